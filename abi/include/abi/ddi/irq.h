@@ -139,6 +139,20 @@ typedef struct {
 	irq_cmd_t *cmds;
 } irq_code_t;
 
+/** IRQ notification flags */
+enum {
+	/**
+	 * Merge interrupts into the notification of the IRQ that has not
+	 * been received yet. The arguments of the merged notifications are
+	 * combined by bitwise or. The request label of the notification is
+	 * the number of interrupts accepted so far.
+	 */
+	IRQ_NOTIF_COALESCE = 1
+};
+
+/** Deliver the IRQ to any processor */
+#define IRQ_CPU_ANY  ((unsigned int) -1)
+
 #endif
 
 /** @}
@@ -113,6 +113,8 @@ typedef enum {
 	    FOURCC_COMPACT('o', 'u', 'd', 'v') | IFACE_EXCHANGE_SERIALIZE,
 	INTERFACE_COMPOSITOR =
 	    FOURCC_COMPACT('c', 'm', 'p', 's') | IFACE_EXCHANGE_SERIALIZE,
+	INTERFACE_COMPOSITOR_CB =
+	    FOURCC_COMPACT('c', 'm', 'p', 's') | IFACE_EXCHANGE_SERIALIZE | IFACE_MOD_CALLBACK,
 	INTERFACE_HOUND =
 	    FOURCC_COMPACT('h', 'o', 'u', 'n') | IFACE_EXCHANGE_PARALLEL,
 	INTERFACE_VISUALIZER_CB =
@@ -185,8 +187,16 @@ typedef enum {
 	    FOURCC_COMPACT('v', 'b', 'd', ' ') | IFACE_EXCHANGE_SERIALIZE,
 	INTERFACE_IPC_TEST =
 	    FOURCC_COMPACT('i', 'p', 'c', 't') | IFACE_EXCHANGE_SERIALIZE,
+	INTERFACE_IPC_TEST_CB =
+	    FOURCC_COMPACT('i', 'p', 'c', 't') | IFACE_EXCHANGE_SERIALIZE | IFACE_MOD_CALLBACK,
 	INTERFACE_PCI =
-	    FOURCC_COMPACT('p', 'c', 'i', ' ') | IFACE_EXCHANGE_SERIALIZE
+	    FOURCC_COMPACT('p', 'c', 'i', ' ') | IFACE_EXCHANGE_SERIALIZE,
+	INTERFACE_LDCACHE =
+	    FOURCC_COMPACT('l', 'd', 'c', 'a') | IFACE_EXCHANGE_SERIALIZE,
+	INTERFACE_ASYNC_STATS =
+	    FOURCC_COMPACT('a', 's', 't', 's') | IFACE_EXCHANGE_SERIALIZE,
+	INTERFACE_PIPE =
+	    FOURCC_COMPACT('p', 'i', 'p', 'e') | IFACE_EXCHANGE_SERIALIZE
 } iface_t;
 
 #endif
@@ -49,8 +49,14 @@ enum {
 	 */
 	IPC_CALL_LEN = 6,
 
-	/** Maximum active async calls per phone */
-	IPC_MAX_ASYNC_CALLS = 64,
+	/** Smallest window of active async calls per phone */
+	IPC_ASYNC_WINDOW_MIN = 8,
+
+	/** Initial window of active async calls per phone */
+	IPC_ASYNC_WINDOW_INIT = 64,
+
+	/** Largest window of active async calls per phone */
+	IPC_ASYNC_WINDOW_MAX = 1024,
 
 	/**
 	 * Maximum buffer size allowed for IPC_M_DATA_WRITE and
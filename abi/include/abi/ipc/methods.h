@@ -112,7 +112,9 @@ enum {
 	/** Share a single page over IPC.
 	 *
 	 * - ARG1 - page-aligned offset from the beginning of the memory object
-	 * - ARG2 - page size
+	 * - ARG2 - page-aligned size of the range to page in, ORed with the
+	 *          access flags (AS_AREA_READ, AS_AREA_WRITE, AS_AREA_EXEC)
+	 *          of the area
 	 * - ARG3 - user defined memory object ID
 	 * - ARG4 - user defined memory object ID
 	 * - ARG5 - user defined memory object ID
@@ -130,7 +132,8 @@ enum {
 	 *            arg2 .. sender's address space area starting address
 	 *                    lower bound
 	 *            arg3 .. <custom>
-	 *            arg4 .. <unused>
+	 *            arg4 .. fixed starting address of the sender's address
+	 *                    space area or 0 to let the kernel choose one
 	 *            arg5 .. <unused>
 	 *
 	 * Recipient:
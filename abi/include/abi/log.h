@@ -37,6 +37,8 @@
 #ifndef _ABI_LOG_H_
 #define _ABI_LOG_H_
 
+#include <stdint.h>
+
 /** Log message level. */
 typedef enum {
 	/** Fatal error, program is not able to recover at all. */
@@ -63,6 +65,29 @@ typedef enum {
 	LF_ARCH
 } log_facility_t;
 
+/** Kernel log ring buffer
+ *
+ * Exported to user space as read-only physical memory described by the
+ * klog.faddr and klog.pages sysinfo items. The header occupies the first
+ * page, the ring of log entries follows it.
+ *
+ * Positions are byte offsets counted since the boot, the byte at position
+ * p is stored at data[p % size]. Entries in [tail, head) are complete.
+ * The kernel advances tail before it overwrites the oldest entries, so an
+ * entry starting at p was read intact if tail is still not past p after
+ * reading it.
+ */
+typedef struct {
+	/** Position just after the last complete entry */
+	volatile uint64_t head;
+	/** Position of the oldest entry not overwritten yet */
+	volatile uint64_t tail;
+	/** Size of the ring in bytes, a power of two */
+	uint32_t size;
+	uint32_t reserved0;
+	uint64_t reserved[5];
+} klog_ring_t;
+
 #endif
 
 /** @}
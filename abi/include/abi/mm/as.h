@@ -45,6 +45,7 @@ enum {
 	AS_AREA_CACHEABLE    = 0x08,
 	AS_AREA_GUARD        = 0x10,
 	AS_AREA_LATE_RESERVE = 0x20,
+	AS_AREA_LARGE_PAGES  = 0x40,
 };
 
 static void *const AS_AREA_ANY = (void *) -1;
@@ -61,6 +62,12 @@ typedef struct {
 
 	/** Area flags */
 	unsigned int flags;
+
+	/** Number of large pages mapped in the area */
+	size_t large_pages;
+
+	/** Number of page faults serviced by the area backend */
+	uint64_t faults;
 } as_area_info_t;
 
 typedef struct {
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup abi_generic
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _ABI_PROFILE_H_
+#define _ABI_PROFILE_H_
+
+#include <stdint.h>
+
+/** Maximum number of return addresses in a profiler sample */
+#define PROFILE_STACK_DEPTH  16
+
+/** The sample was taken while the CPU was running user space code */
+#define PROFILE_SAMPLE_USPACE  0x1
+/** The sample was taken while the CPU was idle */
+#define PROFILE_SAMPLE_IDLE    0x2
+
+/** Operations of the SYS_PROFILE syscall */
+typedef enum {
+	/** Start taking samples */
+	PROFILE_START,
+	/** Stop taking samples */
+	PROFILE_STOP,
+	/** Resolve a kernel address to the name of its function */
+	PROFILE_SYMBOL
+} profile_operation_t;
+
+/** Profiler sample
+ *
+ * A sample is valid only if its sequence number is the same before and
+ * after reading it. The kernel zeroes the sequence number while it
+ * overwrites the sample.
+ */
+typedef struct {
+	/** Sequence number of the sample plus one, zero while written */
+	volatile uint64_t seq;
+	/** ID of the interrupted task */
+	uint64_t task_id;
+	/** ID of the interrupted thread */
+	uint64_t thread_id;
+	/** Sample flags (PROFILE_SAMPLE_*) */
+	uint32_t flags;
+	/** Number of valid entries in pc */
+	uint16_t depth;
+	/** Number of leading entries in pc which are kernel addresses */
+	uint16_t kdepth;
+	/**
+	 * Interrupted program counter followed by the return addresses,
+	 * innermost frame first. Kernel frames precede the user space frame
+	 * of the interrupted thread.
+	 */
+	uint64_t pc[PROFILE_STACK_DEPTH];
+} profile_sample_t;
+
+/** Per-CPU profiler sample ring buffer
+ *
+ * Exported to user space as physical memory described by the
+ * profile.faddr, profile.cpus and profile.buffer_pages sysinfo items.
+ * The buffers of individual CPUs follow each other, each of them
+ * profile.buffer_pages pages long.
+ */
+typedef struct {
+	/** Number of samples written to the buffer so far */
+	volatile uint64_t head;
+	/** Capacity of the buffer in samples */
+	uint32_t count;
+	/** ID of the CPU owning the buffer */
+	uint32_t cpu;
+	uint64_t reserved[6];
+	/** Ring of samples, sample number n is stored at n % count */
+	profile_sample_t samples[];
+} profile_buffer_t;
+
+#endif
+
+/** @}
+ */
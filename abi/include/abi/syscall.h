@@ -71,6 +71,7 @@ typedef enum {
 	SYS_IPC_FORWARD_FAST,
 	SYS_IPC_FORWARD_SLOW,
 	SYS_IPC_WAIT,
+	SYS_IPC_WAIT_BATCH,
 	SYS_IPC_POKE,
 	SYS_IPC_HANGUP,
 	SYS_IPC_CONNECT_KBOX,
@@ -91,6 +92,8 @@ typedef enum {
 
 	SYS_IPC_IRQ_SUBSCRIBE,
 	SYS_IPC_IRQ_UNSUBSCRIBE,
+	SYS_IPC_IRQ_SET_FLAGS,
+	SYS_IPC_IRQ_SET_CPU,
 
 	SYS_SYSINFO_GET_KEYS_SIZE,
 	SYS_SYSINFO_GET_KEYS,
@@ -103,6 +106,8 @@ typedef enum {
 
 	SYS_KLOG,
 
+	SYS_PROFILE,
+
 	SYSCALL_END
 } syscall_t;
 
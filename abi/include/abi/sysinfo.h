@@ -70,6 +70,12 @@ typedef struct {
 	uint16_t frequency_mhz;  /**< Frequency in MHz */
 	uint64_t idle_cycles;    /**< Number of idle cycles */
 	uint64_t busy_cycles;    /**< Number of busy cycles */
+	uint64_t frame_cache_hits;    /**< Frames allocated from CPU cache */
+	uint64_t frame_cache_misses;  /**< CPU frame cache refills */
+	uint64_t threads_created;     /**< Threads created */
+	uint64_t threads_destroyed;   /**< Threads destroyed */
+	uint64_t kstacks_allocated;   /**< Kernel stacks not recycled */
+	uint64_t fpu_contexts_allocated;  /**< FPU contexts allocated */
 } stats_cpu_t;
 
 /** Physical memory statistics
@@ -82,6 +88,16 @@ typedef struct {
 	uint64_t free;     /**< Free physical memory (bytes) */
 } stats_physmem_t;
 
+/** Physical memory statistics of a single memory node
+ *
+ */
+typedef struct {
+	unsigned int node;  /**< Memory node */
+	uint64_t total;     /**< Total available memory of the node (bytes) */
+	uint64_t used;      /**< Allocated memory of the node (bytes) */
+	uint64_t free;      /**< Free memory of the node (bytes) */
+} stats_physmem_node_t;
+
 /** IPC statistics
  *
  * Associated with a task.
@@ -107,6 +123,7 @@ typedef struct {
 	size_t threads;               /**< Number of threads */
 	uint64_t ucycles;             /**< Number of CPU cycles in user space */
 	uint64_t kcycles;             /**< Number of CPU cycles in kernel */
+	uint64_t page_faults;         /**< Number of serviced page faults */
 	stats_ipc_t ipc_info;         /**< IPC statistics */
 } stats_task_t;
 
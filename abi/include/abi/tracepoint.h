@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup abi_generic
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _ABI_TRACEPOINT_H_
+#define _ABI_TRACEPOINT_H_
+
+#include <stdint.h>
+
+/** Kernel tracepoint events */
+typedef enum {
+	/** Thread switch (args: previous thread ID, previous thread state) */
+	TRACE_SCHED_SWITCH,
+	/** IPC request sent (args: callee task ID, method) */
+	TRACE_IPC_CALL,
+	/** IPC answer sent (args: method, return value) */
+	TRACE_IPC_ANSWER,
+	/** Page fault (args: faulting address, access type) */
+	TRACE_PAGE_FAULT,
+	/** IRQ dispatch (args: interrupt number) */
+	TRACE_IRQ,
+	/** Frame allocation (args: physical address, number of frames, flags) */
+	TRACE_FRAME_ALLOC,
+	TRACE_EVENT_COUNT
+} trace_event_t;
+
+/** Tracepoint record
+ *
+ * A record is valid only if its sequence number is the same before and
+ * after reading it. The kernel zeroes the sequence number while it
+ * overwrites the record.
+ */
+typedef struct {
+	/** Sequence number of the record plus one, zero while written */
+	volatile uint64_t seq;
+	/** Cycle counter of the CPU at the time of the event */
+	uint64_t timestamp;
+	/** ID of the thread running at the time of the event */
+	uint64_t thread_id;
+	/** Event-specific arguments */
+	uint64_t args[3];
+	/** ID of the CPU where the event happened */
+	uint32_t cpu;
+	/** Event (trace_event_t) */
+	uint32_t event;
+	uint64_t reserved;
+} trace_record_t;
+
+/** Per-CPU tracepoint ring buffer
+ *
+ * Exported to user space as physical memory described by the
+ * trace.faddr, trace.cpus and trace.buffer_pages sysinfo items.
+ * The buffers of individual CPUs follow each other, each of them
+ * trace.buffer_pages pages long.
+ */
+typedef struct {
+	/** Number of records written to the buffer so far */
+	volatile uint64_t head;
+	/** Capacity of the buffer in records */
+	uint32_t count;
+	/** ID of the CPU owning the buffer */
+	uint32_t cpu;
+	uint64_t reserved[6];
+	/** Ring of records, record number n is stored at n % count */
+	trace_record_t records[];
+} trace_buffer_t;
+
+#endif
+
+/** @}
+ */
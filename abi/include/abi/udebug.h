@@ -35,6 +35,9 @@
 #ifndef _ABI_UDEBUG_H_
 #define _ABI_UDEBUG_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define UDEBUG_EVMASK(event)  (1 << ((event) - 1))
 
 typedef enum { /* udebug_method_t */
@@ -44,6 +47,13 @@ typedef enum { /* udebug_method_t */
 	 * Causes all threads in the receiving task to stop. When they
 	 * are all stoped, an answer with retval 0 is generated.
 	 *
+	 * - ARG2 - flags (udebug_begin_flags_t)
+	 *
+	 * With UDEBUG_BF_SAMPLING, the threads are never stopped and no
+	 * events are generated. Instead, the kernel counts the system
+	 * calls and IPC requests of the task, which can be read using
+	 * UDEBUG_M_STATS_READ. The answer is generated immediately.
+	 *
 	 */
 	UDEBUG_M_BEGIN = 1,
 
@@ -150,9 +160,57 @@ typedef enum { /* udebug_method_t */
 	 * - ARG4 - size of receiving buffer in bytes
 	 *
 	 */
-	UDEBUG_M_MEM_READ
+	UDEBUG_M_MEM_READ,
+
+	/** Read the statistics collected in a sampling session.
+	 *
+	 * - ARG2 - destination address in the caller's address space
+	 * - ARG3 - size of receiving buffer in bytes
+	 *
+	 * The kernel fills the buffer with a udebug_stats_t structure.
+	 * Upon answer, the kernel will set:
+	 *
+	 * - ARG2 - number of bytes that were actually copied
+	 * - ARG3 - number of bytes of the complete data
+	 *
+	 */
+	UDEBUG_M_STATS_READ,
+
+	/** Read several ranges of the debugged task's memory at once.
+	 *
+	 * - ARG2 - destination address in the caller's address space
+	 * - ARG3 - address of an array of udebug_mem_range_t structures
+	 *          in the caller's address space
+	 * - ARG4 - number of the ranges (at most UDEBUG_MEMV_MAX_RANGES)
+	 *
+	 * The contents of the ranges are stored one after another into
+	 * the destination buffer. Their total size must not exceed
+	 * UDEBUG_MEMV_MAX_SIZE bytes.
+	 *
+	 */
+	UDEBUG_M_MEM_READV
 } udebug_method_t;
 
+/** Maximum number of ranges of a single UDEBUG_M_MEM_READV request */
+#define UDEBUG_MEMV_MAX_RANGES  64
+
+/** Maximum total size of a single UDEBUG_M_MEM_READV request */
+#define UDEBUG_MEMV_MAX_SIZE  (64 * 1024)
+
+/** Range of memory read by UDEBUG_M_MEM_READV */
+typedef struct {
+	/** Source address in the debugged task's address space */
+	uintptr_t addr;
+	/** Size of the range in bytes */
+	size_t size;
+} udebug_mem_range_t;
+
+/** Flags of UDEBUG_M_BEGIN */
+typedef enum {
+	/** Only collect statistics, never stop the threads */
+	UDEBUG_BF_SAMPLING = 1
+} udebug_begin_flags_t;
+
 typedef enum {
 	UDEBUG_EVENT_FINISHED = 1,  /**< Debuging session has finished */
 	UDEBUG_EVENT_STOP,          /**< Stopped on DEBUG_STOP request */
@@ -178,6 +236,46 @@ typedef enum {
 	    UDEBUG_EVMASK(UDEBUG_EVENT_THREAD_E))
 } udebug_evmask_t;
 
+/** Number of system calls tracked in a sampling session */
+#define UDEBUG_STATS_SYSCALLS  64
+
+/** Number of buckets of the system call latency histograms */
+#define UDEBUG_STATS_BUCKETS  32
+
+/** Number of distinct IPC methods tracked in a sampling session */
+#define UDEBUG_STATS_METHODS  64
+
+/** Statistics of a single system call */
+typedef struct {
+	/** Number of calls */
+	uint64_t count;
+	/** Total time spent in the calls (CPU cycles) */
+	uint64_t cycles;
+	/**
+	 * Latency histogram, bucket n counts calls taking at least 2^n
+	 * and less than 2^(n + 1) cycles (the last bucket has no upper bound)
+	 */
+	uint64_t hist[UDEBUG_STATS_BUCKETS];
+} udebug_syscall_stats_t;
+
+/** Statistics of a single IPC method */
+typedef struct {
+	/** Interface and method, zero for an unused entry */
+	uint64_t imethod;
+	/** Number of requests sent */
+	uint64_t count;
+} udebug_ipc_stats_t;
+
+/** Statistics collected in a sampling session */
+typedef struct {
+	/** System calls by their number */
+	udebug_syscall_stats_t syscalls[UDEBUG_STATS_SYSCALLS];
+	/** IPC requests by method, in the order of first use */
+	udebug_ipc_stats_t methods[UDEBUG_STATS_METHODS];
+	/** Number of IPC requests with methods not fitting the table */
+	uint64_t methods_other;
+} udebug_stats_t;
+
 #endif
 
 /** @}
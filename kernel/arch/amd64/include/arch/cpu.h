@@ -58,6 +58,11 @@
 
 #define CR4_PAE		(1 << 5)
 #define CR4_OSFXSR	(1 << 9)
+#define CR4_PCIDE	(1 << 17)
+
+/* CR3 bits */
+#define CR3_PCID_MASK	0xfff
+#define CR3_NOFLUSH	(UINT64_C(1) << 63)
 
 /* EFER bits */
 #define AMD_SCE		(1 << 0)
@@ -80,7 +85,9 @@
 
 #ifndef __ASSEMBLER__
 
+#include <stdbool.h>
 #include <arch/pm.h>
+#include <arch/mm/asid.h>
 
 typedef struct {
 	int vendor;
@@ -92,8 +99,33 @@ typedef struct {
 	unsigned int id; /** CPU's local, ie physical, APIC ID. */
 
 	size_t iomapver_copy;  /** Copy of TASK's I/O Permission bitmap generation count. */
+
+	/** Local APIC timer count corresponding to one clock tick. */
+	uint32_t apic_timer_period;
+
+	/** PCIDs whose TLB entries must be flushed before they are used again. */
+	uint64_t pcid_stale[(ASID_MAX_ARCH + 1) / 64];
 } cpu_arch_t;
 
+#ifdef CONFIG_SMP
+
+/** The local APIC timer can stop the periodic clock tick. */
+#define CLOCK_TICKLESS_ARCH
+
+/** The IO APIC can route IRQs to a chosen processor. */
+#define IRQ_ROUTE_ARCH
+
+#endif
+
+/** The time stamp counter can be read from the userspace. */
+#define CLOCK_COUNTER_ARCH
+
+/** memset() and memcpy() are provided by arch/amd64/src/memfnc.c. */
+#define MEMFNC_ARCH
+
+/** The processor has fast rep movsb and rep stosb (ERMS). */
+extern bool memfnc_erms;
+
 struct star_msr {
 };
 
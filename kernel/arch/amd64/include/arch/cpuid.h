@@ -36,14 +36,22 @@
 #define KERN_amd64_CPUID_H_
 
 #define AMD_CPUID_EXTENDED  0x80000001
+#define AMD_CPUID_SIZES     0x80000008
 #define AMD_EXT_NOEXECUTE   20
 #define AMD_EXT_LONG_MODE   29
 
 #define INTEL_CPUID_LEVEL     0x00000000
 #define INTEL_CPUID_STANDARD  0x00000001
+#define INTEL_CPUID_CACHE     0x00000004
+#define INTEL_CPUID_STRUCTURED  0x00000007
 #define INTEL_CPUID_EXTENDED  0x80000000
+#define INTEL_CPUID_POWER     0x80000007
 #define INTEL_SSE2            26
 #define INTEL_FXSAVE          24
+#define INTEL_HTT             28
+#define INTEL_PCID            17
+#define INTEL_ERMS            9
+#define INTEL_INVARIANT_TSC   8
 
 #ifndef __ASSEMBLER__
 
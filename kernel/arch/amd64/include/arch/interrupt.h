@@ -49,6 +49,18 @@
 #define IVT_IRQBASE   (IVT_EXCBASE + EXC_COUNT)
 #define IVT_FREEBASE  (IVT_IRQBASE + IRQ_COUNT)
 
+/*
+ * Message signalled interrupts are delivered by the local APIC directly to
+ * the vectors following the IPIs. Their INRs follow the legacy IRQs.
+ */
+#define MSI_COUNT     8
+#define IVT_MSIBASE   (IVT_FREEBASE + 4)
+#define INR_MSIBASE   IRQ_COUNT
+#define INR_COUNT     (IRQ_COUNT + MSI_COUNT)
+
+/** Address of an MSI message targeting the local APIC @a id */
+#define MSI_ADDRESS(id)  (0xfee00000U | ((uint32_t) (id) << 12))
+
 #define EXC_DE 0
 #define EXC_NM 7
 #define EXC_SS 12
@@ -70,6 +82,10 @@
 #error Wrong definition of VECTOR_APIC_SPUR
 #endif
 
+#if (IVT_MSIBASE + MSI_COUNT > VECTOR_APIC_SPUR)
+#error Wrong definition of IVT_MSIBASE
+#endif
+
 #define VECTOR_DE                 (IVT_EXCBASE + EXC_DE)
 #define VECTOR_NM                 (IVT_EXCBASE + EXC_NM)
 #define VECTOR_SS                 (IVT_EXCBASE + EXC_SS)
@@ -80,6 +96,7 @@
 #define VECTOR_SYSCALL            IVT_FREEBASE
 #define VECTOR_TLB_SHOOTDOWN_IPI  (IVT_FREEBASE + 1)
 #define VECTOR_DEBUG_IPI          (IVT_FREEBASE + 2)
+#define VECTOR_WAKEUP_IPI         (IVT_FREEBASE + 3)
 
 extern void (*disable_irqs_function)(uint16_t);
 extern void (*enable_irqs_function)(uint16_t);
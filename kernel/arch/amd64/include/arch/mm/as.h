@@ -49,7 +49,6 @@
 #define as_destructor_arch(as)          ((void)as, 0)
 #define as_create_arch(as, flags)       ((void)as, (void)flags, EOK)
 
-#define as_install_arch(as)
 #define as_deinstall_arch(as)
 #define as_invalidate_translation_cache(as, page, cnt)
 
@@ -85,6 +85,9 @@
 #define PTL2_FRAMES_ARCH  1
 #define PTL3_FRAMES_ARCH  1
 
+/* Large pages are mapped directly by PTL2 entries. */
+#define LARGE_PAGE_WIDTH_ARCH  21
+
 /* Macros calculating indices into page tables in each level. */
 #define PTL0_INDEX_ARCH(vaddr)  (((vaddr) >> 39) & 0x1ffU)
 #define PTL1_INDEX_ARCH(vaddr)  (((vaddr) >> 30) & 0x1ffU)
@@ -107,8 +110,11 @@
 	    (((uint64_t) ((pte_t *) (ptl3))[(i)].addr_32_51) << 32)))
 
 /* Set PTE address accessors for each level. */
-#define SET_PTL0_ADDRESS_ARCH(ptl0) \
-	(write_cr3((uintptr_t) (ptl0)))
+/*
+ * The page table is loaded into CR3 together with the PCID
+ * by as_install_arch().
+ */
+#define SET_PTL0_ADDRESS_ARCH(ptl0)
 #define SET_PTL1_ADDRESS_ARCH(ptl0, i, a) \
 	set_pt_addr((pte_t *) (ptl0), (size_t) (i), a)
 #define SET_PTL2_ADDRESS_ARCH(ptl1, i, a) \
@@ -148,6 +154,12 @@
 #define SET_FRAME_PRESENT_ARCH(ptl3, i) \
 	set_pt_present((pte_t *) (ptl3), (size_t) (i))
 
+/* Large page accessors for PTL2 entries. */
+#define GET_PTL3_LARGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].page_size != 0)
+#define SET_PTL3_LARGE_ARCH(ptl2, i, x) \
+	(((pte_t *) (ptl2))[(i)].page_size = ((x) != 0))
+
 /* Macros for querying the last-level PTE entries. */
 #define PTE_VALID_ARCH(p) \
 	((p)->soft_valid != 0)
@@ -197,7 +209,7 @@ typedef struct {
 	unsigned int page_cache_disable : 1;
 	unsigned int accessed : 1;
 	unsigned int dirty : 1;
-	unsigned int unused : 1;
+	unsigned int page_size : 1;  /**< Large page in PTL2 entries, PAT in PTL3 entries. */
 	unsigned int global : 1;
 	unsigned int soft_valid : 1;  /**< Valid content even if present bit is cleared. */
 	unsigned int avl : 2;
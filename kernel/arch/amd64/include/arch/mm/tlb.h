@@ -35,6 +35,20 @@
 #ifndef KERN_amd64_TLB_H_
 #define KERN_amd64_TLB_H_
 
+#include <arch/mm/asid.h>
+#include <stdbool.h>
+
+/**
+ * Switching page tables flushes all non-global TLB entries unless
+ * the entries are tagged by PCIDs.
+ */
+#define TLB_FLUSH_ON_SWITCH_ARCH  (!pcid_enabled)
+
+extern bool pcid_enabled;
+
+extern void pcid_init(void);
+extern bool pcid_stale_clear(asid_t);
+
 #endif
 
 /** @}
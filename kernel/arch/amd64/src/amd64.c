@@ -59,6 +59,7 @@
 #include <arch/pm.h>
 #include <arch/vreg.h>
 #include <arch/kseg.h>
+#include <arch/mm/tlb.h>
 
 #ifdef CONFIG_SMP
 #include <arch/smp/apic.h>
@@ -130,7 +131,7 @@ void amd64_post_mm_init(void)
 
 	if (config.cpu_active == 1) {
 		/* Initialize IRQ routing */
-		irq_init(IRQ_COUNT, IRQ_COUNT);
+		irq_init(INR_COUNT, INR_COUNT);
 
 		/* hard clock */
 		i8254_init();
@@ -186,6 +187,9 @@ void amd64_post_smp_init(void)
 	sysinfo_set_item_data("platform", NULL, (void *) platform,
 	    str_size(platform));
 
+	/* Let benchmarks know whether address space switches flush the TLB */
+	sysinfo_set_item_val("mm.pcid", NULL, pcid_enabled);
+
 #ifdef CONFIG_PC_KBD
 	/*
 	 * Initialize the i8042 controller. Then initialize the keyboard
@@ -237,6 +241,20 @@ void amd64_post_smp_init(void)
 
 	if (irqs_info != NULL)
 		sysinfo_set_item_val(irqs_info, NULL, true);
+
+#ifdef CONFIG_SMP
+	if (eoi_function == l_apic_eoi) {
+		/*
+		 * Let the PCI driver program message signalled interrupts.
+		 * The messages target the bootstrap processor.
+		 */
+		sysinfo_set_item_val("msi.inr", NULL, INR_MSIBASE);
+		sysinfo_set_item_val("msi.count", NULL, MSI_COUNT);
+		sysinfo_set_item_val("msi.address", NULL,
+		    MSI_ADDRESS(bsp_l_apic));
+		sysinfo_set_item_val("msi.data", NULL, IVT_MSIBASE);
+	}
+#endif
 }
 
 void calibrate_delay_loop(void)
@@ -38,8 +38,12 @@
 #include <arch/pm.h>
 
 #include <arch.h>
+#include <bitops.h>
 #include <stdio.h>
 #include <fpu_context.h>
+#include <mm/numa.h>
+#include <time/clock.h>
+#include <arch/mm/tlb.h>
 
 /*
  * Identification of CPUs.
@@ -99,6 +103,72 @@ void cpu_arch_init(void)
 	CPU->arch.tss->iomap_base = &CPU->arch.tss->iomap[0] -
 	    ((uint8_t *) CPU->arch.tss);
 	CPU->fpu_owner = NULL;
+
+	pcid_init();
+}
+
+/** Get number of bits needed to hold values below a count.
+ *
+ * @param count Number of distinct values.
+ *
+ * @return Width of the ID field in the APIC ID.
+ *
+ */
+static unsigned int topology_field_width(uint32_t count)
+{
+	return (count > 1) ? fnzb32(count - 1) + 1 : 0;
+}
+
+/** Determine position of the current CPU in the system topology.
+ *
+ * The initial APIC ID is decomposed into the SMT, core and package
+ * fields according to the numbers of logical processors and cores per
+ * package reported by CPUID. The memory node of the processor is
+ * looked up by the APIC ID as well.
+ *
+ * @param max_level Highest supported standard CPUID level.
+ *
+ */
+static void cpu_identify_topology(uint32_t max_level)
+{
+	cpu_info_t info;
+
+	cpuid(INTEL_CPUID_STANDARD, &info);
+	uint32_t apic_id = info.cpuid_ebx >> 24;
+
+	CPU->node = numa_cpu_node(apic_id);
+
+	if ((info.cpuid_edx & (1 << INTEL_HTT)) == 0) {
+		/* Single-core, single-thread package */
+		CPU->package_id = apic_id;
+		CPU->core_id = 0;
+		return;
+	}
+
+	uint32_t logical = (info.cpuid_ebx >> 16) & 0xff;
+	uint32_t cores = 1;
+
+	if (CPU->arch.vendor == VendorIntel) {
+		if (max_level >= INTEL_CPUID_CACHE) {
+			cpuid(INTEL_CPUID_CACHE, &info);
+			cores = (info.cpuid_eax >> 26) + 1;
+		}
+	} else if (CPU->arch.vendor == VendorAMD) {
+		cpuid(INTEL_CPUID_EXTENDED, &info);
+		if (info.cpuid_eax >= AMD_CPUID_SIZES) {
+			cpuid(AMD_CPUID_SIZES, &info);
+			cores = (info.cpuid_ecx & 0xff) + 1;
+		}
+	}
+
+	if ((logical == 0) || (cores > logical))
+		logical = cores;
+
+	unsigned int smt_width = topology_field_width(logical / cores);
+	unsigned int core_width = topology_field_width(cores);
+
+	CPU->core_id = (apic_id >> smt_width) & ((1U << core_width) - 1);
+	CPU->package_id = apic_id >> (smt_width + core_width);
 }
 
 void cpu_identify(void)
@@ -108,6 +178,7 @@ void cpu_identify(void)
 	CPU->arch.vendor = VendorUnknown;
 	if (has_cpuid()) {
 		cpuid(INTEL_CPUID_LEVEL, &info);
+		uint32_t max_level = info.cpuid_eax;
 
 		/*
 		 * Check for AMD processor.
@@ -131,14 +202,46 @@ void cpu_identify(void)
 		CPU->arch.family = (info.cpuid_eax >> 8) & 0xf;
 		CPU->arch.model = (info.cpuid_eax >> 4) & 0xf;
 		CPU->arch.stepping = (info.cpuid_eax >> 0) & 0xf;
+
+		cpu_identify_topology(max_level);
+
+		/*
+		 * Select the memset() and memcpy() implementation once,
+		 * on the bootstrap processor.
+		 */
+		if ((CPU->id == 0) && (max_level >= INTEL_CPUID_STRUCTURED)) {
+			cpuid(INTEL_CPUID_STRUCTURED, &info);
+			memfnc_erms = (info.cpuid_ebx & (1 << INTEL_ERMS)) != 0;
+		}
 	}
 }
 
+/** Check whether the time stamp counter runs at a constant rate
+ *
+ * @return True if the counter is invariant.
+ *
+ */
+bool clock_counter_invariant_arch(void)
+{
+	cpu_info_t info;
+
+	if (!has_cpuid())
+		return false;
+
+	cpuid(INTEL_CPUID_EXTENDED, &info);
+	if (info.cpuid_eax < INTEL_CPUID_POWER)
+		return false;
+
+	cpuid(INTEL_CPUID_POWER, &info);
+	return (info.cpuid_edx & (1 << INTEL_INVARIANT_TSC)) != 0;
+}
+
 void cpu_print_report(cpu_t *m)
 {
-	printf("cpu%d: (%s family=%d model=%d stepping=%d apicid=%u) %dMHz\n",
-	    m->id, vendor_str[m->arch.vendor], m->arch.family, m->arch.model,
-	    m->arch.stepping, m->arch.id, m->frequency_mhz);
+	printf("cpu%d: (%s family=%d model=%d stepping=%d apicid=%u "
+	    "package=%u core=%u) %dMHz\n", m->id, vendor_str[m->arch.vendor],
+	    m->arch.family, m->arch.model, m->arch.stepping, m->arch.id,
+	    m->package_id, m->core_id, m->frequency_mhz);
 }
 
 /** @}
@@ -42,6 +42,7 @@
 #include <arch/asm.h>
 #include <mm/tlb.h>
 #include <mm/as.h>
+#include <time/clock.h>
 #include <arch.h>
 #include <proc/scheduler.h>
 #include <proc/thread.h>
@@ -159,6 +160,12 @@ static void tlb_shootdown_ipi(unsigned int n, istate_t *istate)
 	trap_virtual_eoi();
 	tlb_shootdown_ipi_recv();
 }
+
+static void wakeup_ipi(unsigned int n, istate_t *istate)
+{
+	trap_virtual_eoi();
+	clock_tick_restart();
+}
 #endif
 
 /** Handler of IRQ exceptions.
@@ -168,10 +175,17 @@ static void irq_interrupt(unsigned int n, istate_t *istate)
 {
 	assert(n >= IVT_IRQBASE);
 
-	unsigned int inum = n - IVT_IRQBASE;
+	unsigned int inum;
 	bool ack = false;
-	assert(inum < IRQ_COUNT);
-	assert((inum != IRQ_PIC_SPUR) && (inum != IRQ_PIC1));
+
+	if (n >= IVT_MSIBASE) {
+		inum = INR_MSIBASE + (n - IVT_MSIBASE);
+		assert(inum < INR_COUNT);
+	} else {
+		inum = n - IVT_IRQBASE;
+		assert(inum < IRQ_COUNT);
+		assert((inum != IRQ_PIC_SPUR) && (inum != IRQ_PIC1));
+	}
 
 	irq_t *irq = irq_dispatch_and_lock(inum);
 	if (irq) {
@@ -213,6 +227,11 @@ void interrupt_init(void)
 			    (iroutine_t) irq_interrupt);
 	}
 
+	for (i = 0; i < MSI_COUNT; i++) {
+		exc_register(IVT_MSIBASE + i, "msi", true,
+		    (iroutine_t) irq_interrupt);
+	}
+
 	exc_register(VECTOR_DE, "de_fault", true, (iroutine_t) de_fault);
 	exc_register(VECTOR_NM, "nm_fault", true, (iroutine_t) nm_fault);
 	exc_register(VECTOR_SS, "ss_fault", true, (iroutine_t) ss_fault);
@@ -221,6 +240,8 @@ void interrupt_init(void)
 #ifdef CONFIG_SMP
 	exc_register(VECTOR_TLB_SHOOTDOWN_IPI, "tlb_shootdown", true,
 	    (iroutine_t) tlb_shootdown_ipi);
+	exc_register(VECTOR_WAKEUP_IPI, "wakeup", true,
+	    (iroutine_t) wakeup_ipi);
 #endif
 }
 
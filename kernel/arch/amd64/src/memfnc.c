@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup kernel_amd64
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Memory string functions.
+ *
+ * The kernel does not save the SSE context of its own, so only the string
+ * instructions are used. With ERMS, rep movsb and rep stosb are the fastest
+ * way to copy and fill blocks of any but the smallest sizes, otherwise
+ * whole quadwords are moved first.
+ */
+
+#include <lib/memfnc.h>
+#include <arch/cpu.h>
+#include <typedefs.h>
+
+/** Blocks shorter than this are handled by a plain loop. */
+#define MEMFNC_SMALL  32
+
+bool memfnc_erms = false;
+
+/** Fill block of memory.
+ *
+ * Fill cnt bytes at dst address with the value val.
+ *
+ * @param dst Destination address to fill.
+ * @param val Value to fill.
+ * @param cnt Number of bytes to fill.
+ *
+ * @return Destination address.
+ *
+ */
+void *memset(void *dst, int val, size_t cnt)
+{
+	void *dp = dst;
+
+	if (cnt < MEMFNC_SMALL) {
+		uint8_t *bp = (uint8_t *) dst;
+
+		while (cnt-- != 0)
+			*bp++ = val;
+
+		return dst;
+	}
+
+	if (memfnc_erms) {
+		asm volatile (
+		    "rep stosb\n"
+		    : "+D" (dp), "+c" (cnt)
+		    : "a" (val)
+		    : "memory"
+		);
+
+		return dst;
+	}
+
+	uint64_t pattern = UINT64_C(0x0101010101010101) * (uint8_t) val;
+	size_t qwords = cnt / sizeof(uint64_t);
+
+	asm volatile (
+	    "rep stosq\n"
+	    "movq %[rest], %%rcx\n"
+	    "rep stosb\n"
+	    : "+D" (dp), "+c" (qwords)
+	    : "a" (pattern), [rest] "r" (cnt % sizeof(uint64_t))
+	    : "memory"
+	);
+
+	return dst;
+}
+
+/** Move memory block without overlapping.
+ *
+ * Copy cnt bytes from src address to dst address. The source
+ * and destination memory areas cannot overlap.
+ *
+ * @param dst Destination address to copy to.
+ * @param src Source address to copy from.
+ * @param cnt Number of bytes to copy.
+ *
+ * @return Destination address.
+ *
+ */
+void *memcpy(void *dst, const void *src, size_t cnt)
+{
+	void *dp = dst;
+	const void *sp = src;
+
+	if (cnt < MEMFNC_SMALL) {
+		uint8_t *bdp = (uint8_t *) dst;
+		const uint8_t *bsp = (const uint8_t *) src;
+
+		while (cnt-- != 0)
+			*bdp++ = *bsp++;
+
+		return dst;
+	}
+
+	if (memfnc_erms) {
+		asm volatile (
+		    "rep movsb\n"
+		    : "+D" (dp), "+S" (sp), "+c" (cnt)
+		    :
+		    : "memory"
+		);
+
+		return dst;
+	}
+
+	size_t qwords = cnt / sizeof(uint64_t);
+
+	asm volatile (
+	    "rep movsq\n"
+	    "movq %[rest], %%rcx\n"
+	    "rep movsb\n"
+	    : "+D" (dp), "+S" (sp), "+c" (qwords)
+	    : [rest] "r" (cnt % sizeof(uint64_t))
+	    : "memory"
+	);
+
+	return dst;
+}
+
+/** @}
+ */
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2005 Jakub Jermar
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_amd64_mm
+ * @{
+ */
+/** @file
+ */
+
+#include <mm/tlb.h>
+#include <mm/asid.h>
+#include <arch/mm/asid.h>
+#include <arch/mm/tlb.h>
+#include <arch/asm.h>
+#include <arch/cpu.h>
+#include <arch/cpuid.h>
+#include <arch.h>
+#include <assert.h>
+#include <config.h>
+#include <cpu.h>
+#include <mem.h>
+#include <panic.h>
+#include <typedefs.h>
+
+/** TLB entries are tagged by PCIDs, enabled on all processors or none. */
+bool pcid_enabled = false;
+
+/** Enable PCIDs on the current processor if they are supported.
+ *
+ * The bootstrap processor decides whether PCIDs are used, the application
+ * processors must follow. CR3 must contain PCID 0 at this point.
+ *
+ */
+void pcid_init(void)
+{
+	bool supported = false;
+
+	if (has_cpuid()) {
+		cpu_info_t info;
+
+		cpuid(INTEL_CPUID_STANDARD, &info);
+		supported = (info.cpuid_ecx & (1 << INTEL_PCID)) != 0;
+	}
+
+	if (config.cpu_active == 1)
+		pcid_enabled = supported;
+	else if ((pcid_enabled) && (!supported))
+		panic("PCID not supported by all processors.");
+
+	memsetb(CPU->arch.pcid_stale, sizeof(CPU->arch.pcid_stale), 0);
+
+	if (pcid_enabled) {
+		assert((read_cr3() & CR3_PCID_MASK) == 0);
+		write_cr4(read_cr4() | CR4_PCIDE);
+	}
+}
+
+/** Get the PCID currently loaded on this processor. */
+static asid_t pcid_current(void)
+{
+	return read_cr3() & CR3_PCID_MASK;
+}
+
+/** Mark TLB entries tagged by a PCID stale on this processor.
+ *
+ * The entries are flushed when the PCID is installed the next time.
+ *
+ * @param asid PCID.
+ *
+ */
+static void pcid_stale_set(asid_t asid)
+{
+	CPU->arch.pcid_stale[asid / 64] |= UINT64_C(1) << (asid % 64);
+}
+
+/** Mark TLB entries tagged by any but the current PCID stale. */
+static void pcid_stale_set_all(void)
+{
+	memsetb(CPU->arch.pcid_stale, sizeof(CPU->arch.pcid_stale), 0xff);
+	(void) pcid_stale_clear(pcid_current());
+}
+
+/** Clear the stale mark of a PCID on this processor.
+ *
+ * @param asid PCID.
+ *
+ * @return True if the TLB entries tagged by the PCID were stale.
+ *
+ */
+bool pcid_stale_clear(asid_t asid)
+{
+	uint64_t mask = UINT64_C(1) << (asid % 64);
+	bool stale = (CPU->arch.pcid_stale[asid / 64] & mask) != 0;
+
+	CPU->arch.pcid_stale[asid / 64] &= ~mask;
+	return stale;
+}
+
+/** Invalidate all entries in TLB. */
+void tlb_invalidate_all(void)
+{
+	/*
+	 * Reloading CR3 flushes only the entries of the current PCID,
+	 * the other PCIDs are flushed lazily.
+	 */
+	if (pcid_enabled)
+		pcid_stale_set_all();
+
+	write_cr3(read_cr3());
+}
+
+/** Invalidate all entries in TLB that belong to specified address space.
+ *
+ * @param asid Address space identifier.
+ */
+void tlb_invalidate_asid(asid_t asid)
+{
+	if ((!pcid_enabled) || (asid == ASID_KERNEL)) {
+		/* Kernel mappings are cached under all PCIDs */
+		tlb_invalidate_all();
+		return;
+	}
+
+	if (asid == pcid_current())
+		write_cr3(read_cr3());
+	else
+		pcid_stale_set(asid);
+}
+
+/** Invalidate TLB entries for specified page range belonging to specified address space.
+ *
+ * @param asid Address space identifier.
+ * @param page Address of the first page whose entry is to be invalidated.
+ * @param cnt Number of entries to invalidate.
+ */
+void tlb_invalidate_pages(asid_t asid, uintptr_t page, size_t cnt)
+{
+	unsigned int i;
+
+	if (pcid_enabled) {
+		if (asid == ASID_KERNEL) {
+			/* Kernel mappings are cached under all PCIDs */
+			pcid_stale_set_all();
+		} else if (asid != pcid_current()) {
+			/* INVLPG affects only the current PCID */
+			pcid_stale_set(asid);
+			return;
+		}
+	}
+
+	for (i = 0; i < cnt; i++)
+		invlpg(page + i * PAGE_SIZE);
+}
+
+void tlb_arch_init(void)
+{
+}
+
+void tlb_print(void)
+{
+}
+
+/** @}
+ */
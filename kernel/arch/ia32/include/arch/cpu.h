@@ -81,8 +81,24 @@ typedef struct {
 	tss_t *tss;
 
 	size_t iomapver_copy;  /** Copy of TASK's I/O Permission bitmap generation count. */
+
+	/** Local APIC timer count corresponding to one clock tick. */
+	uint32_t apic_timer_period;
 } cpu_arch_t;
 
+#ifdef CONFIG_SMP
+
+/** The local APIC timer can stop the periodic clock tick. */
+#define CLOCK_TICKLESS_ARCH
+
+/** The IO APIC can route IRQs to a chosen processor. */
+#define IRQ_ROUTE_ARCH
+
+#endif
+
+/** The time stamp counter can be read from the userspace. */
+#define CLOCK_COUNTER_ARCH
+
 #endif
 
 #endif
@@ -37,8 +37,11 @@
 
 #define INTEL_CPUID_LEVEL     0x00000000
 #define INTEL_CPUID_STANDARD  0x00000001
+#define INTEL_CPUID_EXTENDED  0x80000000
+#define INTEL_CPUID_POWER     0x80000007
 #define INTEL_PSE             3
 #define INTEL_SEP             11
+#define INTEL_INVARIANT_TSC   8
 
 #ifndef __ASSEMBLER__
 
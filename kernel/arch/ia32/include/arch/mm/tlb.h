@@ -35,6 +35,9 @@
 #ifndef KERN_ia32_TLB_H_
 #define KERN_ia32_TLB_H_
 
+/** Switching page tables flushes all non-global TLB entries. */
+#define TLB_FLUSH_ON_SWITCH_ARCH  true
+
 #endif
 
 /** @}
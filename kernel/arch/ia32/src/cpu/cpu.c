@@ -40,6 +40,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <fpu_context.h>
+#include <time/clock.h>
 
 #include <arch/smp/apic.h>
 #include <arch/syscall.h>
@@ -146,6 +147,26 @@ void cpu_identify(void)
 	}
 }
 
+/** Check whether the time stamp counter runs at a constant rate
+ *
+ * @return True if the counter is invariant.
+ *
+ */
+bool clock_counter_invariant_arch(void)
+{
+	cpu_info_t info;
+
+	if (!has_cpuid())
+		return false;
+
+	cpuid(INTEL_CPUID_EXTENDED, &info);
+	if (info.cpuid_eax < INTEL_CPUID_POWER)
+		return false;
+
+	cpuid(INTEL_CPUID_POWER, &info);
+	return (info.cpuid_edx & (1 << INTEL_INVARIANT_TSC)) != 0;
+}
+
 void cpu_print_report(cpu_t *cpu)
 {
 	printf("cpu%u: (%s family=%u model=%u stepping=%u apicid=%u) %" PRIu16
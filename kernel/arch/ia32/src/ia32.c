@@ -118,7 +118,7 @@ void ia32_post_mm_init(void)
 
 	if (config.cpu_active == 1) {
 		/* Initialize IRQ routing */
-		irq_init(IRQ_COUNT, IRQ_COUNT);
+		irq_init(INR_COUNT, INR_COUNT);
 
 		/* hard clock */
 		i8254_init();
@@ -222,6 +222,20 @@ void ia32_post_smp_init(void)
 
 	if (irqs_info != NULL)
 		sysinfo_set_item_val(irqs_info, NULL, true);
+
+#ifdef CONFIG_SMP
+	if (eoi_function == l_apic_eoi) {
+		/*
+		 * Let the PCI driver program message signalled interrupts.
+		 * The messages target the bootstrap processor.
+		 */
+		sysinfo_set_item_val("msi.inr", NULL, INR_MSIBASE);
+		sysinfo_set_item_val("msi.count", NULL, MSI_COUNT);
+		sysinfo_set_item_val("msi.address", NULL,
+		    MSI_ADDRESS(bsp_l_apic));
+		sysinfo_set_item_val("msi.data", NULL, IVT_MSIBASE);
+	}
+#endif
 }
 
 void calibrate_delay_loop(void)
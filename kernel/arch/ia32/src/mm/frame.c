@@ -44,9 +44,50 @@
 #include <align.h>
 #include <macros.h>
 #include <stdio.h>
+#include <mm/numa.h>
+
+#if defined(KARCH_amd64) && defined(CONFIG_ACPI)
+#include <genarch/acpi/srat.h>
+#endif
 
 #define PHYSMEM_LIMIT32  UINT64_C(0x100000000)
 
+/** Create available zones, splitting the range at memory node boundaries.
+ *
+ * @param pfn     First frame of the range.
+ * @param count   Number of frames in the range.
+ * @param minconf Lowest frame usable for the zone configuration data
+ *                in low memory.
+ * @param low     Whether the range is in low memory.
+ *
+ */
+static void create_available_zones(pfn_t pfn, size_t count, pfn_t minconf,
+    bool low)
+{
+	while (count > 0) {
+		unsigned int node;
+		size_t piece = numa_pfn_node(pfn, count, &node);
+		pfn_t conf;
+
+		if (low) {
+			if ((minconf < pfn) || (minconf >= pfn + piece))
+				conf = pfn;
+			else
+				conf = minconf;
+			zone_create_node(pfn, piece, conf,
+			    ZONE_AVAILABLE | ZONE_LOWMEM, node);
+		} else {
+			conf = zone_external_conf_alloc(piece);
+			if (conf != 0)
+				zone_create_node(pfn, piece, conf,
+				    ZONE_AVAILABLE | ZONE_HIGHMEM, node);
+		}
+
+		pfn += piece;
+		count -= piece;
+	}
+}
+
 static void init_e820_memory(pfn_t minconf, bool low)
 {
 	unsigned int i;
@@ -78,23 +119,8 @@ static void init_e820_memory(pfn_t minconf, bool low)
 			uint64_t new_size = ALIGN_DOWN(size - (new_base - base),
 			    FRAME_SIZE);
 
-			size_t count = SIZE2FRAMES(new_size);
-			pfn_t pfn = ADDR2PFN(new_base);
-			pfn_t conf;
-
-			if (low) {
-				if ((minconf < pfn) || (minconf >= pfn + count))
-					conf = pfn;
-				else
-					conf = minconf;
-				zone_create(pfn, count, conf,
-				    ZONE_AVAILABLE | ZONE_LOWMEM);
-			} else {
-				conf = zone_external_conf_alloc(count);
-				if (conf != 0)
-					zone_create(pfn, count, conf,
-					    ZONE_AVAILABLE | ZONE_HIGHMEM);
-			}
+			create_available_zones(ADDR2PFN(new_base),
+			    SIZE2FRAMES(new_size), minconf, low);
 		} else if ((e820table[i].type == MEMMAP_MEMORY_ACPI) ||
 		    (e820table[i].type == MEMMAP_MEMORY_NVS)) {
 			/* To be safe, make the firmware zone possibly larger */
@@ -148,6 +174,11 @@ void frame_low_arch_init(void)
 	pfn_t minconf;
 
 	if (config.cpu_active == 1) {
+#if defined(KARCH_amd64) && defined(CONFIG_ACPI)
+		/* Learn the memory node topology before creating the zones */
+		acpi_srat_init();
+#endif
+
 		minconf = 1;
 
 #ifdef CONFIG_SMP
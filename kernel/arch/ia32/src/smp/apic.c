@@ -40,6 +40,8 @@
 #include <assert.h>
 #include <mm/page.h>
 #include <time/delay.h>
+#include <time/clock.h>
+#include <cpu.h>
 #include <interrupt.h>
 #include <arch/interrupt.h>
 #include <log.h>
@@ -77,6 +79,9 @@ volatile uint32_t *io_apic = (uint32_t *) IO_APIC_BASE;
 uint32_t apic_id_mask = 0;
 uint8_t bsp_l_apic = 0;
 
+/** Serializes changes of the IO APIC redirection table at run time. */
+IRQ_SPINLOCK_STATIC_INITIALIZE(io_apic_lock);
+
 static irq_t l_apic_timer_irq;
 
 static int apic_poll_errors(void);
@@ -488,7 +493,8 @@ void l_apic_init(void)
 	delay(1000000 / HZ);
 	uint32_t t2 = l_apic[CCRT];
 
-	l_apic[ICRT] = t1 - t2;
+	CPU->arch.apic_timer_period = t1 - t2;
+	l_apic[ICRT] = CPU->arch.apic_timer_period;
 
 	/* Program Logical Destination Register. */
 	assert(CPU->id < 8);
@@ -506,6 +512,56 @@ void l_apic_init(void)
 	l_apic[DFR] = dfr.value;
 }
 
+/** Stop the periodic local APIC timer
+ *
+ * The timer is switched to one-shot mode so that only a single clock
+ * interrupt arrives after the given number of clock ticks.
+ *
+ * @param ticks Number of clock ticks until the next clock interrupt.
+ *
+ * @return False if the timer of the current CPU is not programmed.
+ *
+ */
+bool clock_tick_stop_arch(uint64_t ticks)
+{
+	uint32_t period = CPU->arch.apic_timer_period;
+	if (period == 0)
+		return false;
+
+	if (ticks > UINT32_MAX / period)
+		ticks = UINT32_MAX / period;
+
+	lvt_tm_t tm;
+
+	tm.value = l_apic[LVT_Tm];
+	tm.mode = TIMER_ONESHOT;
+	l_apic[LVT_Tm] = tm.value;
+	l_apic[ICRT] = period * (uint32_t) ticks;
+
+	return true;
+}
+
+/** Restart the periodic local APIC timer. */
+void clock_tick_start_arch(void)
+{
+	lvt_tm_t tm;
+
+	tm.value = l_apic[LVT_Tm];
+	tm.mode = TIMER_PERIODIC;
+	l_apic[LVT_Tm] = tm.value;
+	l_apic[ICRT] = CPU->arch.apic_timer_period;
+}
+
+/** Wake up a CPU whose clock tick is stopped
+ *
+ * @param cpu CPU to wake up.
+ *
+ */
+void clock_tick_wakeup_arch(cpu_t *cpu)
+{
+	l_apic_send_custom_ipi(cpu->arch.id, VECTOR_WAKEUP_IPI);
+}
+
 /** Local APIC End of Interrupt. */
 void l_apic_eoi(void)
 {
@@ -613,6 +669,45 @@ void io_apic_change_ioredtbl(uint8_t pin, uint8_t dest, uint8_t vec,
 	io_apic_write((uint8_t) (IOREDTBL + pin * 2 + 1), reg.hi);
 }
 
+/** Route an IRQ to one processor or let it go to any processor.
+ *
+ * The IRQs are routed in the logical destination mode to the processor
+ * with the lowest priority. The logical APIC ID of a processor is the bit
+ * of its number, so only the first eight processors can be addressed
+ * alone.
+ *
+ * @param inr IRQ number.
+ * @param cpu Processor to deliver the IRQ to or NULL for any.
+ *
+ * @return EOK on success, ENOTSUP if the IRQ or the processor cannot be
+ *         routed.
+ *
+ */
+errno_t irq_route_arch(inr_t inr, cpu_t *cpu)
+{
+	if (enable_irqs_function != io_apic_enable_irqs)
+		return ENOTSUP;
+
+	if ((inr < 0) || (inr >= IRQ_COUNT))
+		return ENOTSUP;
+
+	int pin = smp_irq_to_pin(inr);
+	if (pin == -1)
+		return ENOTSUP;
+
+	if ((cpu != NULL) && (cpu->id >= 8))
+		return ENOTSUP;
+
+	uint8_t dest = (cpu != NULL) ? (uint8_t) (1 << cpu->id) : DEST_ALL;
+
+	irq_spinlock_lock(&io_apic_lock, true);
+	io_apic_change_ioredtbl((uint8_t) pin, dest,
+	    (uint8_t) (IVT_IRQBASE + inr), (cpu != NULL) ? 0 : LOPRI);
+	irq_spinlock_unlock(&io_apic_lock, true);
+
+	return EOK;
+}
+
 /** Mask IRQs in IO APIC.
  *
  * @param irqmask Bitmask of IRQs to be masked (0 = do not mask, 1 = mask).
@@ -87,6 +87,7 @@ extern struct acpi_xsdt *acpi_xsdt;
 
 extern void acpi_init(void);
 extern int acpi_sdt_check(uint8_t *sdt);
+extern struct acpi_sdt_header *acpi_early_find(const char *);
 
 #endif /* KERN_ACPI_H_ */
 
@@ -47,6 +47,9 @@
 #define RSDP_SIGNATURE      "RSD PTR "
 #define RSDP_REVISION_OFFS  15
 
+/** Tables below this address are accessible via the boot identity mapping. */
+#define EARLY_LIMIT  UINT64_C(0x100000000)
+
 #define CMP_SIGNATURE(left, right) \
 	(((left)[0] == (right)[0]) && \
 	((left)[1] == (right)[1]) && \
@@ -181,7 +184,7 @@ static uint8_t *search_rsdp(uint8_t *base, size_t len)
 	return NULL;
 }
 
-void acpi_init(void)
+static uint8_t *find_rsdp(void)
 {
 	/*
 	 * Find Root System Description Pointer
@@ -197,6 +200,80 @@ void acpi_init(void)
 	if (!rsdp)
 		rsdp = search_rsdp((uint8_t *) PA2KA(0xe0000), 128 * 1024);
 
+	return rsdp;
+}
+
+static struct acpi_sdt_header *early_sdt(uint64_t psdt)
+{
+	if ((psdt == 0) || (psdt + sizeof(struct acpi_sdt_header) > EARLY_LIMIT))
+		return NULL;
+
+	struct acpi_sdt_header *sdt =
+	    (struct acpi_sdt_header *) PA2KA((uintptr_t) psdt);
+	if (psdt + sdt->length > EARLY_LIMIT)
+		return NULL;
+
+	if (!acpi_sdt_check((uint8_t *) sdt))
+		return NULL;
+
+	return sdt;
+}
+
+/** Find a system description table before memory management is initialized.
+ *
+ * Unlike acpi_init(), the tables are not mapped using km_map(),
+ * but accessed through the boot identity mapping. Therefore
+ * only tables located below 4 GiB can be found.
+ *
+ * @param signature Signature of the table.
+ *
+ * @return Table or NULL if the table is not found.
+ *
+ */
+struct acpi_sdt_header *acpi_early_find(const char *signature)
+{
+	struct acpi_rsdp *rsdp = (struct acpi_rsdp *) find_rsdp();
+	if (!rsdp)
+		return NULL;
+
+	struct acpi_sdt_header *root = NULL;
+	size_t entry_size = sizeof(uint32_t);
+
+	if (rsdp->revision) {
+		root = early_sdt(rsdp->xsdt_address);
+		entry_size = sizeof(uint64_t);
+	}
+
+	if (!root) {
+		root = early_sdt(rsdp->rsdt_address);
+		entry_size = sizeof(uint32_t);
+	}
+
+	if (!root)
+		return NULL;
+
+	size_t cnt = (root->length - sizeof(struct acpi_sdt_header)) /
+	    entry_size;
+
+	for (size_t i = 0; i < cnt; i++) {
+		uint64_t psdt;
+
+		if (entry_size == sizeof(uint64_t))
+			psdt = ((struct acpi_xsdt *) root)->entry[i];
+		else
+			psdt = ((struct acpi_rsdt *) root)->entry[i];
+
+		struct acpi_sdt_header *sdt = early_sdt(psdt);
+		if ((sdt) && (CMP_SIGNATURE(sdt->signature, signature)))
+			return sdt;
+	}
+
+	return NULL;
+}
+
+void acpi_init(void)
+{
+	uint8_t *rsdp = find_rsdp();
 	if (!rsdp)
 		return;
 
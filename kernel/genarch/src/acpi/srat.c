@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_genarch
+ * @{
+ */
+
+/**
+ * @file
+ * @brief System Resource Affinity Table (SRAT) and System Locality
+ * Information Table (SLIT) parsing.
+ */
+
+#include <genarch/acpi/acpi.h>
+#include <genarch/acpi/srat.h>
+#include <mm/numa.h>
+#include <typedefs.h>
+
+static void srat_parse(struct acpi_srat *srat)
+{
+	uint8_t *entry = (uint8_t *) srat->entry;
+	uint8_t *end = (uint8_t *) srat + srat->header.length;
+
+	while (entry + sizeof(struct srat_header) <= end) {
+		struct srat_header *hdr = (struct srat_header *) entry;
+		if ((hdr->length < sizeof(struct srat_header)) ||
+		    (entry + hdr->length > end))
+			break;
+
+		switch (hdr->type) {
+		case SRAT_L_APIC:
+			{
+				struct srat_l_apic *l_apic =
+				    (struct srat_l_apic *) hdr;
+				if (!(l_apic->flags & SRAT_FLAG_ENABLED))
+					break;
+
+				uint32_t domain = l_apic->domain_lo |
+				    (l_apic->domain_hi[0] << 8) |
+				    (l_apic->domain_hi[1] << 16) |
+				    ((uint32_t) l_apic->domain_hi[2] << 24);
+				numa_cpu_add(l_apic->apic_id, numa_node_get(domain));
+				break;
+			}
+		case SRAT_MEMORY:
+			{
+				struct srat_memory *memory =
+				    (struct srat_memory *) hdr;
+				if (!(memory->flags & SRAT_FLAG_ENABLED))
+					break;
+
+				numa_memory_add(memory->base, memory->length,
+				    numa_node_get(memory->domain));
+				break;
+			}
+		case SRAT_X2_APIC:
+			{
+				struct srat_x2_apic *x2_apic =
+				    (struct srat_x2_apic *) hdr;
+				if (!(x2_apic->flags & SRAT_FLAG_ENABLED))
+					break;
+
+				numa_cpu_add(x2_apic->x2_apic_id,
+				    numa_node_get(x2_apic->domain));
+				break;
+			}
+		default:
+			break;
+		}
+
+		entry += hdr->length;
+	}
+}
+
+static void slit_parse(struct acpi_slit *slit)
+{
+	uint64_t count = slit->count;
+	if (sizeof(struct acpi_slit) + count * count > slit->header.length)
+		return;
+
+	/*
+	 * The SLIT is indexed by proximity domains. Only domains that
+	 * were already mapped to nodes by the SRAT are of interest.
+	 */
+	for (uint64_t from = 0; from < count; from++) {
+		for (uint64_t to = 0; to < count; to++) {
+			unsigned int from_node = numa_node_find(from);
+			unsigned int to_node = numa_node_find(to);
+
+			if ((from_node != NUMA_NODE_ANY) &&
+			    (to_node != NUMA_NODE_ANY))
+				numa_distance_set(from_node, to_node,
+				    slit->distance[from * count + to]);
+		}
+	}
+}
+
+/** Describe memory node topology using SRAT and SLIT.
+ *
+ * This is called before memory management is initialized,
+ * so that the frame allocator can create the zones with the
+ * node affinity already known.
+ *
+ */
+void acpi_srat_init(void)
+{
+	struct acpi_srat *srat =
+	    (struct acpi_srat *) acpi_early_find("SRAT");
+	if (!srat)
+		return;
+
+	srat_parse(srat);
+
+	struct acpi_slit *slit =
+	    (struct acpi_slit *) acpi_early_find("SLIT");
+	if (slit)
+		slit_parse(slit);
+}
+
+/** @}
+ */
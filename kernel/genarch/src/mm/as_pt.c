@@ -116,7 +116,8 @@ void ptl0_destroy(pte_t *page_table)
 
 /** Lock page tables.
  *
- * Lock only the address space.
+ * Lock the page tables of the address space and, optionally,
+ * the address space itself.
  * Interrupts must be disabled.
  *
  * @param as   Address space.
@@ -127,11 +128,13 @@ void pt_lock(as_t *as, bool lock)
 {
 	if (lock)
 		mutex_lock(&as->lock);
+
+	mutex_lock(&as->pt_lock);
 }
 
 /** Unlock page tables.
  *
- * Unlock the address space.
+ * Unlock the page tables and, optionally, the address space.
  * Interrupts must be disabled.
  *
  * @param as     Address space.
@@ -140,6 +143,8 @@ void pt_lock(as_t *as, bool lock)
  */
 void pt_unlock(as_t *as, bool unlock)
 {
+	mutex_unlock(&as->pt_lock);
+
 	if (unlock)
 		mutex_unlock(&as->lock);
 }
@@ -153,7 +158,7 @@ void pt_unlock(as_t *as, bool unlock)
  */
 bool pt_locked(as_t *as)
 {
-	return mutex_locked(&as->lock);
+	return mutex_locked(&as->pt_lock);
 }
 
 /** @}
@@ -128,6 +128,12 @@ asid_t asid_get(void)
 		ipl_t ipl = tlb_shootdown_start(TLB_INVL_ASID, asid, 0, 0);
 		tlb_invalidate_asid(asid);
 		tlb_shootdown_finalize(ipl);
+
+		/*
+		 * No processor holds translations of the address space
+		 * any more.
+		 */
+		atomic_store(&as->tlb_cpus, 0);
 	} else {
 
 		/*
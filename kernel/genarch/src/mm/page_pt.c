@@ -57,27 +57,30 @@ static bool pt_mapping_find(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_update(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_make_global(uintptr_t, size_t);
 
+#ifdef LARGE_PAGE_WIDTH_ARCH
+static void pt_mapping_insert_large(as_t *, uintptr_t, uintptr_t, unsigned int);
+#endif
+
 page_mapping_operations_t pt_mapping_operations = {
 	.mapping_insert = pt_mapping_insert,
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	.mapping_insert_large = pt_mapping_insert_large,
+#endif
 	.mapping_remove = pt_mapping_remove,
 	.mapping_find = pt_mapping_find,
 	.mapping_update = pt_mapping_update,
 	.mapping_make_global = pt_mapping_make_global
 };
 
-/** Map page to frame using hierarchical page tables.
+/** Get PTL2 for a page, allocate the missing page tables on the way.
  *
- * Map virtual address page to physical address frame
- * using flags.
+ * @param as   Address space to wich page belongs.
+ * @param page Virtual address of the page.
  *
- * @param as    Address space to wich page belongs.
- * @param page  Virtual address of the page to be mapped.
- * @param frame Physical address of memory frame to which the mapping is done.
- * @param flags Flags to be used for mapping.
+ * @return PTL2 containing the entry for the page.
  *
  */
-void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
-    unsigned int flags)
+static pte_t *pt_ptl2_get(as_t *as, uintptr_t page)
 {
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
 
@@ -117,7 +120,110 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 		SET_PTL2_PRESENT(ptl1, PTL1_INDEX(page));
 	}
 
-	pte_t *ptl2 = (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+	return (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+}
+
+#ifdef LARGE_PAGE_WIDTH_ARCH
+
+/** Split a large page mapping into a PTL3 with base page mappings.
+ *
+ * The base pages keep mapping the same frames with the same flags, so
+ * stale TLB entries for the large page remain coherent until the caller
+ * invalidates the base pages it changes.
+ *
+ * @param ptl2 PTL2 containing the large page entry.
+ * @param i    Index of the large page entry.
+ *
+ */
+static void pt_split_large(pte_t *ptl2, size_t i)
+{
+	uintptr_t frame = PTE_GET_FRAME(&ptl2[i]);
+	unsigned int flags = GET_PTL3_FLAGS(ptl2, i) & ~PAGE_NOT_PRESENT;
+
+	pte_t *newpt = (pte_t *)
+	    PA2KA(frame_alloc(PTL3_FRAMES, FRAME_LOWMEM, PTL3_SIZE - 1));
+	memsetb(newpt, PTL3_SIZE, 0);
+
+	for (size_t j = 0; j < PTL3_ENTRIES; j++) {
+		SET_FRAME_ADDRESS(newpt, j, frame + P2SZ(j));
+		SET_FRAME_FLAGS(newpt, j, flags);
+	}
+
+	/*
+	 * Hide the large page while the entry is being rewritten. A
+	 * concurrent access faults and waits for the page table lock.
+	 */
+	SET_PTL3_FLAGS(ptl2, i, flags | PAGE_NOT_PRESENT);
+	write_barrier();
+
+	SET_PTL3_LARGE(ptl2, i, false);
+	SET_PTL3_ADDRESS(ptl2, i, KA2PA(newpt));
+	SET_PTL3_FLAGS(ptl2, i,
+	    PAGE_NOT_PRESENT | PAGE_USER | PAGE_EXEC | PAGE_CACHEABLE |
+	    PAGE_WRITE);
+	write_barrier();
+	SET_PTL3_PRESENT(ptl2, i);
+}
+
+/** Map large page to frames using hierarchical page tables.
+ *
+ * The large page is mapped directly by a PTL2 entry, which must not
+ * contain any mapping yet.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the first frame to which the mapping
+ *              is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void pt_mapping_insert_large(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(page_table_locked(as));
+	assert(IS_ALIGNED(page, LARGE_PAGE_SIZE));
+	assert(IS_ALIGNED(frame, LARGE_PAGE_SIZE));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+
+	/* Do not leak a page table that might still be there */
+	assert(GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT);
+
+	SET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page), frame);
+	SET_PTL3_FLAGS(ptl2, PTL2_INDEX(page), flags | PAGE_NOT_PRESENT);
+	SET_PTL3_LARGE(ptl2, PTL2_INDEX(page), true);
+	/*
+	 * Make the new mapping visible only after it is fully initialized.
+	 */
+	write_barrier();
+	SET_PTL3_PRESENT(ptl2, PTL2_INDEX(page));
+}
+
+#endif /* LARGE_PAGE_WIDTH_ARCH */
+
+/** Map page to frame using hierarchical page tables.
+ *
+ * Map virtual address page to physical address frame
+ * using flags. A large page mapping containing the page is split.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the page to be mapped.
+ * @param frame Physical address of memory frame to which the mapping is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	if ((!(GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)) &&
+	    (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page))))
+		pt_split_large(ptl2, PTL2_INDEX(page));
+#endif
 
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
@@ -151,6 +257,7 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
  * TLB shootdown should follow in order to make effects of
  * this call visible.
  *
+ * A large page mapping containing the page is split first.
  * Empty page tables except PTL0 are freed.
  *
  * @param as   Address space to wich page belongs.
@@ -177,6 +284,11 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return;
 
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page)))
+		pt_split_large(ptl2, PTL2_INDEX(page));
+#endif
+
 	pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
 
 	/*
@@ -291,10 +403,13 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 #endif /* PTL1_ENTRIES != 0 */
 }
 
-static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
+static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock,
+    bool *large)
 {
 	assert(nolock || page_table_locked(as));
 
+	*large = false;
+
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
 	if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT)
 		return NULL;
@@ -316,6 +431,13 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return NULL;
 
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page))) {
+		*large = true;
+		return &ptl2[PTL2_INDEX(page)];
+	}
+#endif
+
 #if (PTL2_ENTRIES != 0)
 	/*
 	 * Always read ptl3 only after we are sure it is present.
@@ -329,6 +451,9 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
 }
 
 /** Find mapping for virtual page in hierarchical page tables.
+ *
+ * If the page is mapped by a large page, the returned PTE describes
+ * the base page within the large page.
  *
  * @param as       Address space to which page belongs.
  * @param page     Virtual page.
@@ -339,10 +464,22 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
  */
 bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
-	if (t)
-		*pte = *t;
-	return t != NULL;
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
+	if (!t)
+		return false;
+
+	*pte = *t;
+
+#ifdef LARGE_PAGE_WIDTH_ARCH
+	if (large) {
+		SET_FRAME_ADDRESS(pte, 0, PTE_GET_FRAME(t) +
+		    (page & (LARGE_PAGE_SIZE - 1)));
+		SET_PTL3_LARGE(pte, 0, false);
+	}
+#endif
+
+	return true;
 }
 
 /** Update mapping for virtual page in hierarchical page tables.
@@ -354,10 +491,18 @@ bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
  */
 void pt_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
 	if (!t)
 		panic("Updating non-existent PTE");
 
+	/*
+	 * Large pages are only used on architectures with page tables
+	 * walked by hardware, which never update the PTEs this way.
+	 */
+	if (large)
+		panic("Updating large page PTE");
+
 	assert(PTE_VALID(t) == PTE_VALID(pte));
 	assert(PTE_PRESENT(t) == PTE_PRESENT(pte));
 	assert(PTE_GET_FRAME(t) == PTE_GET_FRAME(pte));
@@ -38,12 +38,16 @@
 #include <abi/cap.h>
 #include <typedefs.h>
 #include <adt/list.h>
-#include <adt/hash.h>
-#include <adt/hash_table.h>
 #include <lib/ra.h>
 #include <synch/mutex.h>
+#include <synch/spinlock.h>
 #include <atomic.h>
 
+/** Number of capabilities in one leaf of the capability table. */
+#define CAPS_LEAF_SIZE	512
+/** Number of leaves of the capability table. */
+#define CAPS_DIR_SIZE	512
+
 typedef enum {
 	CAP_STATE_FREE,
 	CAP_STATE_ALLOCATED,
@@ -94,9 +98,14 @@ typedef struct kobject {
 } kobject_t;
 
 /*
- * A cap_t may only be accessed under the protection of the cap_info_t lock.
+ * A cap_t may only be modified under the protection of the cap_info_t lock.
+ * The state and kobject members are additionally protected by the cap_t lock,
+ * which is sufficient for reading them.
  */
 typedef struct cap {
+	/** Protects state and kobject for lockless lookups. */
+	SPINLOCK_DECLARE(lock);
+
 	cap_state_t state;
 
 	struct task *task;
@@ -108,18 +117,29 @@ typedef struct cap {
 	/* Link to the task's capabilities of the same kobject type. */
 	link_t type_link;
 
-	ht_link_t caps_link;
-
 	/* The underlying kernel object. */
 	kobject_t *kobject;
 } cap_t;
 
+/** Leaf of the capability table. */
+typedef struct cap_leaf {
+	_Atomic(cap_t *) caps[CAPS_LEAF_SIZE];
+} cap_leaf_t;
+
 typedef struct cap_info {
 	mutex_t lock;
 
 	list_t type_list[KOBJECT_TYPE_MAX];
 
-	hash_table_t caps;
+	/**
+	 * Two-level capability table indexed by the capability handle.
+	 *
+	 * Leaves and capabilities are only added under the lock and stay in
+	 * the table until the task is destroyed, so that the table can be
+	 * walked without locking. Freed capabilities are kept in the
+	 * CAP_STATE_FREE state and reused for the same handle.
+	 */
+	_Atomic(cap_leaf_t *) table[CAPS_DIR_SIZE];
 	ra_arena_t *handles;
 } cap_info_t;
 
@@ -45,6 +45,15 @@
 
 #define CPU                  CURRENT->cpu
 
+struct istate;
+
+/** Number of bits of the timeout expiration time handled by one wheel level. */
+#define TIMEOUT_WHEEL_BITS    6
+/** Number of slots of each level of the timing wheel. */
+#define TIMEOUT_WHEEL_SLOTS   (1 << TIMEOUT_WHEEL_BITS)
+/** Number of levels of the timing wheel. */
+#define TIMEOUT_WHEEL_LEVELS  4
+
 /** CPU structure.
  *
  * There is one structure like this for every processor.
@@ -59,10 +68,36 @@ typedef struct cpu {
 
 	atomic_t nrdy;
 	runq_t rq[RQ_COUNT];
+
+	/**
+	 * Bitmap of non-empty run queues. Bit i is set iff rq[i].n is
+	 * non-zero. The bit is only modified while holding rq[i].lock,
+	 * but it may be read without any lock as a hint.
+	 */
+	atomic_uint rq_mask;
+
 	volatile size_t needs_relink;
 
 	IRQ_SPINLOCK_DECLARE(timeoutlock);
-	list_t timeout_active_list;
+
+	/**
+	 * Hierarchical timing wheel of active timeouts. Level l holds the
+	 * timeouts expiring in less than TIMEOUT_WHEEL_SLOTS^(l + 1) ticks,
+	 * hashed by the respective bits of their expiration time.
+	 */
+	list_t timeout_wheel[TIMEOUT_WHEEL_LEVELS][TIMEOUT_WHEEL_SLOTS];
+	/** Number of clock ticks processed by the timing wheel. */
+	uint64_t timeout_ticks;
+
+	/**
+	 * The periodic clock tick is stopped. Set and cleared only by the
+	 * processor itself, read by others to decide whether to wake it up.
+	 */
+	atomic_bool tick_stopped;
+	/** Value of the cycle counter when the clock tick was stopped. */
+	uint64_t tick_stop_cycle;
+	/** Cycles spent with the clock tick stopped not accounted as a tick. */
+	uint64_t tick_cycles_rem;
 
 	/**
 	 * When system clock loses a tick, it is
@@ -73,6 +108,12 @@ typedef struct cpu {
 	 */
 	size_t missed_clock_ticks;
 
+	/**
+	 * State of the code interrupted by the exception being handled,
+	 * NULL outside of exception handlers.
+	 */
+	struct istate *istate;
+
 	/**
 	 * Processor cycle accounting.
 	 */
@@ -81,14 +122,42 @@ typedef struct cpu {
 	uint64_t idle_cycles;
 	uint64_t busy_cycles;
 
+	/**
+	 * Thread accounting, protected by the CPU lock. A thread_t that
+	 * comes out of the slab magazines still has its kernel stack, so
+	 * kstacks_allocated only counts the threads that needed a new one.
+	 */
+	uint64_t threads_created;
+	uint64_t threads_destroyed;
+	uint64_t kstacks_allocated;
+	uint64_t fpu_contexts_allocated;
+
 	/**
 	 * Processor ID assigned by kernel.
 	 */
 	unsigned int id;
 
+	/**
+	 * Position of the processor in the system topology. Processors
+	 * sharing both the package and the core are SMT siblings. Filled
+	 * in by cpu_identify(), by default every processor is a separate
+	 * core of a single package.
+	 */
+	unsigned int package_id;
+	unsigned int core_id;
+
+	/** Memory node local to the processor. */
+	unsigned int node;
+
 	bool active;
 	volatile bool tlb_active;
 
+	/**
+	 * The processor is a recipient of the TLB shootdown in progress.
+	 * Protected by the TLB shootdown lock.
+	 */
+	volatile bool tlb_shootdown;
+
 	uint16_t frequency_mhz;
 	uint32_t delay_loop_const;
 
@@ -82,6 +82,13 @@ typedef struct {
 	irq_code_t *code;
 	/** Counter. */
 	size_t counter;
+	/** IRQ_NOTIF_* flags. */
+	unsigned int flags;
+	/**
+	 * Notification not received from the answerbox yet, if the
+	 * notifications are coalesced. Protected by the answerbox irq_lock.
+	 */
+	call_t *pending;
 } ipc_notif_cfg_t;
 
 /** Structure representing one device IRQ.
@@ -140,6 +147,12 @@ extern void irq_initialize(irq_t *);
 extern void irq_register(irq_t *);
 extern irq_t *irq_dispatch_and_lock(inr_t);
 
+/*
+ * Interface to be implemented by architectures which define
+ * IRQ_ROUTE_ARCH.
+ */
+extern errno_t irq_route_arch(inr_t, cpu_t *);
+
 #endif
 
 /** @}
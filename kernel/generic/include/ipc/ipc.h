@@ -71,6 +71,10 @@ typedef struct phone {
 	struct call *hangup_call;
 	ipc_phone_state_t state;
 	atomic_t active_calls;
+	/** Number of async calls allowed to be active at a time. */
+	atomic_t window;
+	/** Number of async calls refused because the window was full. */
+	atomic_t stalls;
 	/** User-defined label */
 	sysarg_t label;
 	kobject_t *kobject;
@@ -91,6 +95,9 @@ typedef struct answerbox {
 	 */
 	atomic_t active_calls;
 
+	/** Number of calls waiting in the calls list. */
+	atomic_t queued_calls;
+
 	/** Phones connected to this answerbox. */
 	list_t connected_phones;
 	/** Received calls. */
@@ -165,6 +172,22 @@ typedef struct call {
 
 	/** Buffer for IPC_M_DATA_WRITE and IPC_M_DATA_READ. */
 	uint8_t *buffer;
+
+	/**
+	 * Referenced frames holding the data of a large IPC_M_DATA_WRITE or
+	 * IPC_M_DATA_READ transfer. Used instead of buffer.
+	 */
+	uintptr_t *frames;
+	/** Number of frames in frames. */
+	size_t frames_count;
+	/** Offset of the data in the first frame. */
+	size_t frames_offset;
+
+	/**
+	 * Pointer to clear when the IRQ notification is received.
+	 * Protected by the answerbox irq_lock.
+	 */
+	struct call **notif_pending;
 } call_t;
 
 extern slab_cache_t *phone_cache;
@@ -181,6 +204,8 @@ extern errno_t ipc_wait_for_call(answerbox_t *, uint32_t, unsigned int, call_t *
 extern errno_t ipc_forward(call_t *, phone_t *, answerbox_t *, unsigned int);
 extern void ipc_answer(answerbox_t *, call_t *);
 extern void _ipc_answer_free_call(call_t *, bool);
+extern errno_t ipc_call_frames_get(call_t *, uintptr_t, size_t, unsigned int);
+extern errno_t ipc_call_frames_copy(call_t *, uintptr_t, size_t, bool);
 
 extern void ipc_phone_init(phone_t *, struct task *);
 extern bool ipc_phone_connect(phone_t *, answerbox_t *);
@@ -52,6 +52,9 @@ extern void ipc_irq_top_half_handler(irq_t *);
 extern errno_t ipc_irq_subscribe(answerbox_t *, inr_t, sysarg_t, irq_code_t *,
     cap_irq_handle_t *);
 extern errno_t ipc_irq_unsubscribe(answerbox_t *, cap_irq_handle_t);
+extern errno_t ipc_irq_set_flags(answerbox_t *, cap_irq_handle_t,
+    unsigned int);
+extern errno_t ipc_irq_set_cpu(answerbox_t *, cap_irq_handle_t, unsigned int);
 
 /*
  * User friendly wrappers for ipc_irq_send_msg(). They are in the form
@@ -49,6 +49,8 @@ extern sys_errno_t sys_ipc_answer_fast(cap_call_handle_t, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t);
 extern sys_errno_t sys_ipc_answer_slow(cap_call_handle_t, ipc_data_t *);
 extern sys_errno_t sys_ipc_wait_for_call(ipc_data_t *, uint32_t, unsigned int);
+extern sys_errno_t sys_ipc_wait_for_calls(ipc_data_t *, size_t, uint32_t,
+    unsigned int, size_t *);
 extern sys_errno_t sys_ipc_poke(void);
 extern sys_errno_t sys_ipc_forward_fast(cap_call_handle_t, cap_phone_handle_t,
     sysarg_t, sysarg_t, sysarg_t, unsigned int);
@@ -59,6 +61,8 @@ extern sys_errno_t sys_ipc_hangup(cap_phone_handle_t);
 extern sys_errno_t sys_ipc_irq_subscribe(inr_t, sysarg_t, irq_code_t *,
     cap_irq_handle_t *);
 extern sys_errno_t sys_ipc_irq_unsubscribe(cap_irq_handle_t);
+extern sys_errno_t sys_ipc_irq_set_flags(cap_irq_handle_t, unsigned int);
+extern sys_errno_t sys_ipc_irq_set_cpu(cap_irq_handle_t, unsigned int);
 
 extern sys_errno_t sys_ipc_connect_kbox(task_id_t *, cap_phone_handle_t *);
 
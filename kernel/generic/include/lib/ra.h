@@ -40,9 +40,30 @@
 #include <adt/hash_table.h>
 #include <synch/spinlock.h>
 
+/** Number of size classes of the per-CPU quantum caches. */
+#define RA_QCACHE_CLASSES	4
+
+/** Maximum number of allocations in one class of a quantum cache. */
+#define RA_QCACHE_SIZE		16
+
+/** Number of allocations moved between a quantum cache and the arena. */
+#define RA_QCACHE_BATCH		8
+
+/** Per-CPU cache of small allocations, see ra_arena_qcache_enable(). */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	/** Number of cached allocations in each class. */
+	size_t count[RA_QCACHE_CLASSES];
+	/** Cached allocations, class i holding those of i + 1 quanta. */
+	uintptr_t base[RA_QCACHE_CLASSES][RA_QCACHE_SIZE];
+} ra_qcache_t;
+
 typedef struct {
 	IRQ_SPINLOCK_DECLARE(lock);
 	list_t spans;		/**< List of arena's spans. */
+
+	size_t quantum;		/**< Unit of the quantum caches. */
+	ra_qcache_t *qcache;	/**< Per-CPU quantum caches or NULL. */
 } ra_arena_t;
 
 typedef struct {
@@ -52,6 +73,7 @@ typedef struct {
 
 	size_t max_order;	/**< Base 2 logarithm of span's size. */
 	list_t *free;		/**< max_order segment free lists. */
+	size_t free_mask;	/**< Bit i is set iff free[i] is not empty. */
 
 	hash_table_t used;
 
@@ -87,6 +109,7 @@ typedef struct {
 extern void ra_init(void);
 extern ra_arena_t *ra_arena_create(void);
 extern void ra_arena_destroy(ra_arena_t *);
+extern bool ra_arena_qcache_enable(ra_arena_t *, size_t);
 extern bool ra_span_add(ra_arena_t *, uintptr_t, size_t);
 extern bool ra_alloc(ra_arena_t *, size_t, size_t, uintptr_t *);
 extern void ra_free(ra_arena_t *, uintptr_t, size_t);
@@ -112,8 +112,36 @@ typedef struct as {
 	/** Number of references (i.e. tasks that reference this as). */
 	atomic_refcount_t refcount;
 
+	/**
+	 * Bitmap of processors which might hold translations of this
+	 * address space in their TLBs. Processors with IDs that do not
+	 * fit into the bitmap are always assumed to hold them.
+	 */
+	atomic_size_t tlb_cpus;
+
+	/**
+	 * Protects the list of address space areas and their placement.
+	 * Page faults hold it only while looking up the faulting area.
+	 */
 	mutex_t lock;
 
+	/**
+	 * Protects the page tables. Nests inside @c lock and inside the
+	 * locks of the address space areas.
+	 */
+	mutex_t pt_lock;
+
+	/** Number of page faults serviced in this address space. Protected by
+	 * the page table lock.
+	 */
+	uint64_t faults;
+
+	/** Total number of pages of all areas in this address space. */
+	atomic_size_t virt_pages;
+
+	/** Total number of used (resident) pages of all areas. */
+	atomic_size_t resident_pages;
+
 	/** Address space areas in this address space by base address.
 	 *
 	 * Members are of type as_area_t.
@@ -177,6 +205,8 @@ typedef struct used_space {
 	odict_t ivals;
 	/** Total number of used pages. */
 	size_t pages;
+	/** Address space whose resident page counter is maintained. */
+	struct as *as;
 } used_space_t;
 
 /**
@@ -261,6 +291,18 @@ typedef struct {
 	/** Number of pages in the area. */
 	size_t pages;
 
+	/** Number of large pages mapped in the area so far. */
+	size_t large_pages;
+
+	/** Number of page faults serviced by the backend of this area. */
+	uint64_t faults;
+
+	/** Page expected to fault next if the area is accessed sequentially. */
+	uintptr_t readahead_next;
+
+	/** Number of pages to be paged in by the next sequential fault. */
+	size_t readahead_pages;
+
 	/** Base address of this area. */
 	uintptr_t base;
 
@@ -331,6 +373,11 @@ extern void as_pagemap_remove(as_page_mapping_t *);
 extern unsigned int as_area_get_flags(as_area_t *);
 extern bool as_area_check_access(as_area_t *, pf_access_t);
 extern size_t as_area_get_size(uintptr_t);
+extern errno_t as_area_frames_get(as_t *, uintptr_t, size_t, unsigned int,
+    uintptr_t *);
+#ifdef LARGE_PAGE_WIDTH_ARCH
+extern bool as_area_large_page(as_area_t *, uintptr_t, uintptr_t *);
+#endif
 extern used_space_ival_t *used_space_first(used_space_t *);
 extern used_space_ival_t *used_space_next(used_space_ival_t *);
 extern used_space_ival_t *used_space_find_gteq(used_space_t *, uintptr_t);
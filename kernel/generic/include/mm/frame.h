@@ -40,6 +40,7 @@
 #include <trace.h>
 #include <adt/bitmap.h>
 #include <adt/list.h>
+#include <atomic.h>
 #include <synch/spinlock.h>
 #include <arch/mm/page.h>
 #include <arch/mm/frame.h>
@@ -90,7 +91,7 @@ typedef uint8_t zone_flags_t;
 	    (((zf) & ~ZONE_EF_MASK) & (f)))
 
 typedef struct {
-	size_t refcount;  /**< Tracking of shared frames */
+	atomic_size_t refcount;  /**< Tracking of shared frames */
 	void *parent;     /**< If allocated by slab, this points there */
 } frame_t;
 
@@ -110,6 +111,9 @@ typedef struct {
 	/** Type of the zone */
 	zone_flags_t flags;
 
+	/** Memory node of the zone */
+	unsigned int node;
+
 	/** Frame bitmap */
 	bitmap_t bitmap;
 
@@ -130,10 +134,14 @@ typedef struct {
 extern zones_t zones;
 
 extern void frame_init(void);
+extern void frame_enable_cpucache(void);
+extern void frame_cpucache_stats(unsigned int, uint64_t *, uint64_t *);
 extern bool frame_adjust_zone_bounds(bool, uintptr_t *, size_t *);
 extern uintptr_t frame_alloc_generic(size_t, frame_flags_t, uintptr_t,
     size_t *);
 extern uintptr_t frame_alloc(size_t, frame_flags_t, uintptr_t);
+extern uintptr_t frame_alloc_node(size_t, frame_flags_t, uintptr_t,
+    unsigned int);
 extern void frame_free_generic(uintptr_t, size_t, frame_flags_t);
 extern void frame_free(uintptr_t, size_t);
 extern void frame_free_noreserve(uintptr_t, size_t);
@@ -142,6 +150,8 @@ extern size_t frame_total_free_get(void);
 
 extern size_t find_zone(pfn_t, size_t, size_t);
 extern size_t zone_create(pfn_t, size_t, pfn_t, zone_flags_t);
+extern size_t zone_create_node(pfn_t, size_t, pfn_t, zone_flags_t,
+    unsigned int);
 extern void *frame_get_parent(pfn_t, size_t);
 extern void frame_set_parent(pfn_t, void *, size_t);
 extern void frame_mark_unavailable(pfn_t, size_t);
@@ -151,6 +161,8 @@ extern bool zone_merge(size_t, size_t);
 extern void zone_merge_all(void);
 extern uint64_t zones_total_size(void);
 extern void zones_stats(uint64_t *, uint64_t *, uint64_t *, uint64_t *);
+extern void zones_node_stats(unsigned int, uint64_t *, uint64_t *,
+    uint64_t *);
 
 /*
  * Console functions
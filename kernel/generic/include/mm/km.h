@@ -44,6 +44,7 @@ extern void km_identity_init(void);
 extern void km_non_identity_init(void);
 
 extern void km_non_identity_span_add(uintptr_t, size_t);
+extern void km_enable_cpucache(void);
 
 extern uintptr_t km_page_alloc(size_t, size_t);
 extern void km_page_free(uintptr_t, size_t);
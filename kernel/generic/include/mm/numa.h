@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_mm
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_NUMA_H_
+#define KERN_NUMA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <typedefs.h>
+
+/** Maximum number of memory nodes. */
+#define NUMA_NODES_MAX  8
+
+/** Maximum number of memory ranges with known node affinity. */
+#define NUMA_RANGES_MAX  32
+
+/** Maximum number of processors with known node affinity. */
+#define NUMA_CPUS_MAX  64
+
+/** No node preference. */
+#define NUMA_NODE_ANY  ((unsigned int) -1)
+
+/** Distance of a node from itself. */
+#define NUMA_DISTANCE_LOCAL  10
+
+/** Default distance of two different nodes. */
+#define NUMA_DISTANCE_REMOTE  20
+
+extern unsigned int numa_node_find(uint32_t);
+extern unsigned int numa_node_get(uint32_t);
+extern unsigned int numa_node_count(void);
+extern void numa_memory_add(uint64_t, uint64_t, unsigned int);
+extern void numa_cpu_add(uint32_t, unsigned int);
+extern void numa_distance_set(unsigned int, unsigned int, uint8_t);
+
+extern size_t numa_pfn_node(pfn_t, size_t, unsigned int *);
+extern unsigned int numa_cpu_node(uint32_t);
+extern uint8_t numa_distance(unsigned int, unsigned int);
+extern size_t numa_nodes_by_distance(unsigned int, unsigned int *);
+
+#endif
+
+/** @}
+ */
@@ -43,9 +43,22 @@
 #define P2SZ(pages) \
 	((pages) << PAGE_WIDTH)
 
+#ifdef LARGE_PAGE_WIDTH_ARCH
+
+/** Large pages are supported by the architecture. */
+#define LARGE_PAGE_WIDTH  LARGE_PAGE_WIDTH_ARCH
+#define LARGE_PAGE_SIZE   (1 << LARGE_PAGE_WIDTH)
+
+/** Number of base pages in a large page. */
+#define LARGE_PAGE_PAGES  (LARGE_PAGE_SIZE / PAGE_SIZE)
+
+#endif
+
 /** Operations to manipulate page mappings. */
 typedef struct {
 	void (*mapping_insert)(as_t *, uintptr_t, uintptr_t, unsigned int);
+	/** Optional, map a large page. */
+	void (*mapping_insert_large)(as_t *, uintptr_t, uintptr_t, unsigned int);
 	void (*mapping_remove)(as_t *, uintptr_t);
 	bool (*mapping_find)(as_t *, uintptr_t, bool, pte_t *);
 	void (*mapping_update)(as_t *, uintptr_t, bool, pte_t *);
@@ -59,6 +72,9 @@ extern void page_table_lock(as_t *, bool);
 extern void page_table_unlock(as_t *, bool);
 extern bool page_table_locked(as_t *);
 extern void page_mapping_insert(as_t *, uintptr_t, uintptr_t, unsigned int);
+extern bool page_mapping_large_supported(void);
+extern void page_mapping_insert_large(as_t *, uintptr_t, uintptr_t,
+    unsigned int);
 extern void page_mapping_remove(as_t *, uintptr_t);
 extern bool page_mapping_find(as_t *, uintptr_t, bool, pte_t *);
 extern void page_mapping_update(as_t *, uintptr_t, bool, pte_t *);
@@ -39,6 +39,7 @@
 #include <stddef.h>
 
 extern void reserve_init(void);
+extern void reserve_enable_cpucache(void);
 extern bool reserve_try_alloc(size_t);
 extern void reserve_force_alloc(size_t);
 extern void reserve_free(size_t);
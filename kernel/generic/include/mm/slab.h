@@ -39,10 +39,20 @@
 #include <synch/spinlock.h>
 #include <atomic.h>
 #include <mm/frame.h>
+#include <mm/numa.h>
 
-/** Initial Magazine size (TODO: dynamically growing magazines) */
+/** Initial magazine size */
 #define SLAB_MAG_SIZE  4
 
+/** Maximum magazine size */
+#define SLAB_MAG_SIZE_MAX  64
+
+/** Number of magazine sizes (powers of two up to SLAB_MAG_SIZE_MAX) */
+#define SLAB_MAG_SIZES  5
+
+/** Number of contended depot accesses which make the magazines grow */
+#define SLAB_MAG_CONTENTION_LIMIT  16
+
 /** If object size is less, store control structure inside SLAB */
 #define SLAB_INSIDE_SIZE  (PAGE_SIZE >> 3)
 
@@ -75,8 +85,19 @@ typedef struct {
 	slab_magazine_t *current;
 	slab_magazine_t *last;
 	IRQ_SPINLOCK_DECLARE(lock);
+
+	/** Allocations satisfied from the CPU magazines */
+	uint64_t hits;
+	/** Allocations which had to go to the slab layer */
+	uint64_t misses;
 } slab_mag_cache_t;
 
+/** Depot of full magazines shared by the CPUs of a memory node */
+typedef struct {
+	list_t magazines;  /**< List of full magazines */
+	IRQ_SPINLOCK_DECLARE(lock);
+} slab_depot_t;
+
 typedef struct {
 	const char *name;
 
@@ -101,16 +122,19 @@ typedef struct {
 	atomic_t allocated_slabs;
 	atomic_t allocated_objs;
 	atomic_t cached_objs;
-	/** How many magazines in magazines list */
+	/** How many magazines in all depots */
 	atomic_t magazine_counter;
+	/** Size of newly allocated magazines */
+	atomic_t mag_size;
+	/** Number of contended depot accesses since the last growth */
+	atomic_t mag_contention;
 
 	/* Slabs */
 	list_t full_slabs;     /**< List of full slabs */
 	list_t partial_slabs;  /**< List of partial slabs */
 	IRQ_SPINLOCK_DECLARE(slablock);
 	/* Magazines */
-	list_t magazines;  /**< List o full magazines */
-	IRQ_SPINLOCK_DECLARE(maglock);
+	slab_depot_t depots[NUMA_NODES_MAX];  /**< Per-node magazine depots */
 
 	/** CPU cache */
 	slab_mag_cache_t *mag_cache;
@@ -44,6 +44,17 @@
  */
 #define TLB_MESSAGE_QUEUE_LEN	10
 
+/** Number of page ranges a TLB shootdown batch can hold. */
+#define TLB_BATCH_LEN	8
+
+/**
+ * Page ranges longer than this are invalidated by invalidating the
+ * whole address space (except for the kernel address space).
+ */
+#define TLB_INVL_PAGES_MAX	64
+
+struct as;
+
 /** Type of TLB shootdown message. */
 typedef enum {
 	/** Invalid type. */
@@ -64,17 +75,45 @@ typedef struct {
 	size_t count;			/**< Number of pages to invalidate. */
 } tlb_shootdown_msg_t;
 
+/** Range of pages to invalidate. */
+typedef struct {
+	uintptr_t page;			/**< Address of the first page. */
+	size_t count;			/**< Number of pages. */
+} tlb_range_t;
+
+/** Batch of TLB invalidations belonging to one address space.
+ *
+ * The batch covers a single shootdown sequence during which an arbitrary
+ * number of page ranges can be unmapped. Adjacent and overlapping ranges
+ * are merged and the invalidation is delivered only to the processors
+ * which might hold translations of the address space.
+ */
+typedef struct {
+	struct as *as;			/**< Address space. */
+	ipl_t ipl;			/**< Interrupt priority level to restore. */
+	size_t count;			/**< Number of valid ranges. */
+	tlb_range_t ranges[TLB_BATCH_LEN];
+} tlb_batch_t;
+
 extern void tlb_init(void);
 
+extern void tlb_batch_start(tlb_batch_t *, struct as *);
+extern void tlb_batch_add(tlb_batch_t *, uintptr_t, size_t);
+extern void tlb_batch_finalize(tlb_batch_t *);
+
 #ifdef CONFIG_SMP
 extern ipl_t tlb_shootdown_start(tlb_invalidate_type_t, asid_t, uintptr_t,
     size_t);
 extern void tlb_shootdown_finalize(ipl_t);
 extern void tlb_shootdown_ipi_recv(void);
+extern void tlb_as_activate(struct as *);
+extern void tlb_as_deactivate(struct as *);
 #else
 #define tlb_shootdown_start(w, x, y, z)	interrupts_disable()
 #define tlb_shootdown_finalize(i)	(interrupts_restore(i));
 #define tlb_shootdown_ipi_recv()
+#define tlb_as_activate(as)	((void) (as))
+#define tlb_as_deactivate(as)	((void) (as))
 #endif /* CONFIG_SMP */
 
 /* Export TLB interface that each architecture must implement. */
@@ -44,6 +44,21 @@
 #define RQ_COUNT          16
 #define NEEDS_RELINK_MAX  (HZ)
 
+/** Minimal number of ready threads a CPU must have to be robbed by an idle CPU. */
+#define STEAL_NRDY_MIN  2
+
+/** Scheduling domain levels, from the closest to the most remote. */
+typedef enum {
+	/** Hardware threads of one core. */
+	SCHED_DOMAIN_SMT = 0,
+	/** Cores of one physical package. */
+	SCHED_DOMAIN_PACKAGE,
+	/** All processors in the system. */
+	SCHED_DOMAIN_SYSTEM,
+
+	SCHED_DOMAIN_COUNT
+} sched_domain_t;
+
 /** Scheduler run queue structure. */
 typedef struct {
 	IRQ_SPINLOCK_DECLARE(lock);
@@ -55,6 +70,7 @@ extern atomic_t nrdy;
 extern void scheduler_init(void);
 
 extern void scheduler_fpu_lazy_request(void);
+extern void scheduler_fpu_release(void);
 extern void scheduler(void);
 extern void kcpulb(void *arg);
 
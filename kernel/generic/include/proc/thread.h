@@ -119,6 +119,13 @@ typedef struct thread {
 
 	/** Wait queue in which this thread sleeps. */
 	waitq_t *sleep_queue;
+	/**
+	 * Wait queue a wakeup may move this thread to instead of waking it
+	 * up, see waitq_wakeup_morph().
+	 */
+	waitq_t *sleep_morph_queue;
+	/** The thread was moved to or woken up from sleep_morph_queue. */
+	bool sleep_morphed;
 	/** Timeout used for timeoutable sleeping.  */
 	timeout_t sleep_timeout;
 	/** Flag signalling sleep timeout in progress. */
@@ -149,6 +156,10 @@ typedef struct thread {
 	/** Link used in the joiner_head list. */
 	link_t joiner_link;
 
+	/**
+	 * Allocated when the thread first needs it, then kept for as long
+	 * as the thread_t stays in its slab cache.
+	 */
 	fpu_context_t *saved_fpu_context;
 	bool fpu_context_exists;
 
@@ -217,8 +228,10 @@ extern void thread_init(void);
 extern thread_t *thread_create(void (*)(void *), void *, task_t *,
     thread_flags_t, const char *);
 extern void thread_wire(thread_t *, cpu_t *);
+extern void thread_unwire(thread_t *);
 extern void thread_attach(thread_t *, task_t *);
 extern void thread_ready(thread_t *);
+extern void thread_ready_handoff(thread_t *);
 extern void thread_exit(void) __attribute__((noreturn));
 extern void thread_interrupt(thread_t *);
 extern bool thread_interrupted(thread_t *);
@@ -263,6 +276,10 @@ extern void thread_stack_trace(thread_id_t);
 /** Fpu context slab cache. */
 extern slab_cache_t *fpu_context_cache;
 
+#ifdef CONFIG_FPU
+extern errno_t thread_fpu_context_alloc(thread_t *);
+#endif
+
 /* Thread syscall prototypes. */
 extern sys_errno_t sys_thread_create(uspace_arg_t *, char *, size_t,
     thread_id_t *);
@@ -43,12 +43,47 @@
 
 #ifdef CONFIG_SMP
 
+#if defined(CONFIG_DEBUG_SPINLOCK) || defined(CONFIG_SPINLOCK_STATS)
+#define SPINLOCK_NAMED
+#endif
+
+#ifdef CONFIG_SPINLOCK_STATS
+#include <adt/list.h>
+
+/** Spinlock contention statistics */
+typedef struct {
+	/** Number of acquisitions. */
+	uint64_t acquisitions;
+	/** Number of acquisitions which had to wait for the lock. */
+	uint64_t contended;
+	/** Total number of spin iterations. */
+	uint64_t spins;
+	/** Longest time the lock was held (in cycles). */
+	uint64_t max_hold;
+	/** Cycle counter value at the last acquisition. */
+	uint64_t acquired;
+	/** Link for the list of reported spinlocks. */
+	link_t link;
+} spinlock_stats_t;
+#endif /* CONFIG_SPINLOCK_STATS */
+
 typedef struct spinlock {
+#ifdef CONFIG_TICKET_SPINLOCK
+	/** Next ticket to be handed out. */
+	atomic_uint next;
+	/** Ticket which currently owns the lock. */
+	atomic_uint owner;
+#else
 	atomic_flag flag;
+#endif
 
-#ifdef CONFIG_DEBUG_SPINLOCK
+#ifdef SPINLOCK_NAMED
 	const char *name;
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif /* SPINLOCK_NAMED */
+
+#ifdef CONFIG_SPINLOCK_STATS
+	spinlock_stats_t stats;
+#endif /* CONFIG_SPINLOCK_STATS */
 } spinlock_t;
 
 /*
@@ -58,46 +93,58 @@ typedef struct spinlock {
 #define SPINLOCK_DECLARE(lock_name)  spinlock_t lock_name
 #define SPINLOCK_EXTERN(lock_name)   extern spinlock_t lock_name
 
+#ifdef CONFIG_TICKET_SPINLOCK
+#define SPINLOCK_STATE_INITIALIZER \
+	.next = 0, \
+	.owner = 0
+#else
+#define SPINLOCK_STATE_INITIALIZER \
+	.flag = ATOMIC_FLAG_INIT
+#endif
+
+#ifdef SPINLOCK_NAMED
+#define SPINLOCK_INITIALIZER(desc_name) \
+	{ \
+		.name = desc_name, \
+		SPINLOCK_STATE_INITIALIZER \
+	}
+#else
+#define SPINLOCK_INITIALIZER(desc_name) \
+	{ \
+		SPINLOCK_STATE_INITIALIZER \
+	}
+#endif
+
 /*
  * SPINLOCK_INITIALIZE and SPINLOCK_STATIC_INITIALIZE are to be used
  * for statically allocated spinlocks. They declare (either as global
  * or static) symbol and initialize the lock.
  */
-#ifdef CONFIG_DEBUG_SPINLOCK
-
 #define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
-	spinlock_t lock_name = { \
-		.name = desc_name, \
-		.flag = ATOMIC_FLAG_INIT \
-	}
+	spinlock_t lock_name = SPINLOCK_INITIALIZER(desc_name)
 
 #define SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
-	static spinlock_t lock_name = { \
-		.name = desc_name, \
-		.flag = ATOMIC_FLAG_INIT \
-	}
+	static spinlock_t lock_name = SPINLOCK_INITIALIZER(desc_name)
+
+#ifdef CONFIG_DEBUG_SPINLOCK
 
 #define ASSERT_SPINLOCK(expr, lock) \
 	assert_verbose(expr, (lock)->name)
 
-#define spinlock_lock(lock)    spinlock_lock_debug((lock))
-#define spinlock_unlock(lock)  spinlock_unlock_debug((lock))
-
 #else /* CONFIG_DEBUG_SPINLOCK */
 
-#define SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
-	spinlock_t lock_name = { \
-		.flag = ATOMIC_FLAG_INIT \
-	}
-
-#define SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
-	static spinlock_t lock_name = { \
-		.flag = ATOMIC_FLAG_INIT \
-	}
-
 #define ASSERT_SPINLOCK(expr, lock) \
 	assert(expr)
 
+#endif /* CONFIG_DEBUG_SPINLOCK */
+
+#ifdef SPINLOCK_NAMED
+
+#define spinlock_lock(lock)    spinlock_lock_debug((lock))
+#define spinlock_unlock(lock)  spinlock_unlock_debug((lock))
+
+#else /* SPINLOCK_NAMED */
+
 /** Acquire spinlock
  *
  * @param lock  Pointer to spinlock_t structure.
@@ -105,9 +152,17 @@ typedef struct spinlock {
 _NO_TRACE static inline void spinlock_lock(spinlock_t *lock)
 {
 	preemption_disable();
+#ifdef CONFIG_TICKET_SPINLOCK
+	unsigned int ticket = atomic_fetch_add_explicit(&lock->next, 1,
+	    memory_order_relaxed);
+	while (atomic_load_explicit(&lock->owner, memory_order_acquire) !=
+	    ticket)
+		;
+#else
 	while (atomic_flag_test_and_set_explicit(&lock->flag,
 	    memory_order_acquire))
 		;
+#endif
 }
 
 /** Release spinlock
@@ -116,11 +171,18 @@ _NO_TRACE static inline void spinlock_lock(spinlock_t *lock)
  */
 _NO_TRACE static inline void spinlock_unlock(spinlock_t *lock)
 {
+#ifdef CONFIG_TICKET_SPINLOCK
+	/* Only the owner writes lock->owner, so a plain increment will do. */
+	unsigned int owner = atomic_load_explicit(&lock->owner,
+	    memory_order_relaxed);
+	atomic_store_explicit(&lock->owner, owner + 1, memory_order_release);
+#else
 	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+#endif
 	preemption_enable();
 }
 
-#endif /* CONFIG_DEBUG_SPINLOCK */
+#endif /* SPINLOCK_NAMED */
 
 #define SPINLOCK_INITIALIZE(lock_name) \
 	SPINLOCK_INITIALIZE_NAME(lock_name, #lock_name)
@@ -208,50 +270,20 @@ typedef struct {
  * for statically allocated interrupts-disabled spinlocks. They declare (either
  * as global or static symbol) and initialize the lock.
  */
-#ifdef CONFIG_DEBUG_SPINLOCK
-
-#define IRQ_SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
-	irq_spinlock_t lock_name = { \
-		.lock = { \
-			.name = desc_name, \
-			.flag = ATOMIC_FLAG_INIT \
-		}, \
-		.guard = false, \
-		.ipl = 0 \
-	}
-
-#define IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
-	static irq_spinlock_t lock_name = { \
-		.lock = { \
-			.name = desc_name, \
-			.flag = ATOMIC_FLAG_INIT \
-		}, \
-		.guard = false, \
-		.ipl = 0 \
-	}
-
-#else /* CONFIG_DEBUG_SPINLOCK */
-
 #define IRQ_SPINLOCK_INITIALIZE_NAME(lock_name, desc_name) \
 	irq_spinlock_t lock_name = { \
-		.lock = { \
-			.flag = ATOMIC_FLAG_INIT \
-		}, \
+		.lock = SPINLOCK_INITIALIZER(desc_name), \
 		.guard = false, \
 		.ipl = 0 \
 	}
 
 #define IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(lock_name, desc_name) \
 	static irq_spinlock_t lock_name = { \
-		.lock = { \
-			.flag = ATOMIC_FLAG_INIT \
-		}, \
+		.lock = SPINLOCK_INITIALIZER(desc_name), \
 		.guard = false, \
 		.ipl = 0 \
 	}
 
-#endif /* CONFIG_DEBUG_SPINLOCK */
-
 #else /* CONFIG_SMP */
 
 /*
@@ -291,6 +323,27 @@ extern void irq_spinlock_pass(irq_spinlock_t *, irq_spinlock_t *);
 extern void irq_spinlock_exchange(irq_spinlock_t *, irq_spinlock_t *);
 extern bool irq_spinlock_locked(irq_spinlock_t *);
 
+#ifdef CONFIG_SPINLOCK_STATS
+
+extern void spinlock_stats_register(spinlock_t *);
+extern void spinlock_stats_unregister(spinlock_t *);
+extern void spinlock_stats_print(void);
+
+#define irq_spinlock_stats_register(irq_lock) \
+	spinlock_stats_register(&(irq_lock)->lock)
+#define irq_spinlock_stats_unregister(irq_lock) \
+	spinlock_stats_unregister(&(irq_lock)->lock)
+
+#else /* CONFIG_SPINLOCK_STATS */
+
+#define spinlock_stats_register(lock)
+#define spinlock_stats_unregister(lock)
+
+#define irq_spinlock_stats_register(irq_lock)
+#define irq_spinlock_stats_unregister(irq_lock)
+
+#endif /* CONFIG_SPINLOCK_STATS */
+
 #endif
 
 /** @}
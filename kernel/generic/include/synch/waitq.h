@@ -42,7 +42,9 @@
 
 typedef enum {
 	WAKEUP_FIRST = 0,
-	WAKEUP_ALL
+	WAKEUP_ALL,
+	/** Wake up the first thread and run it next on the current CPU. */
+	WAKEUP_HANDOFF
 } wakeup_mode_t;
 
 /** Wait queue structure.
@@ -80,6 +82,7 @@ extern errno_t waitq_sleep_timeout_unsafe(waitq_t *, uint32_t, unsigned int, boo
 extern void waitq_sleep_finish(waitq_t *, bool, ipl_t);
 extern void waitq_wakeup(waitq_t *, wakeup_mode_t);
 extern void _waitq_wakeup_unsafe(waitq_t *, wakeup_mode_t);
+extern void waitq_wakeup_morph(waitq_t *, bool);
 extern void waitq_interrupt_sleep(struct thread *);
 extern int waitq_count_get(waitq_t *);
 extern void waitq_count_set(waitq_t *, int val);
@@ -35,21 +35,55 @@
 #ifndef KERN_CLOCK_H_
 #define KERN_CLOCK_H_
 
+#include <stdbool.h>
 #include <typedefs.h>
 
 #define HZ  100
 
-/** Uptime structure */
+/** Uptime structure
+ *
+ * Besides the uptime updated on each clock tick, the structure describes
+ * how to compute the uptime from the cycle counter. The counter fields
+ * are only valid if counter_mult is not zero and are protected by
+ * counter_seq, which is odd while they are being updated.
+ */
 typedef struct {
 	sysarg_t seconds1;
 	sysarg_t useconds;
 	sysarg_t seconds2;
+
+	uint32_t counter_seq;    /**< Sequence counter of the counter fields */
+	uint32_t counter_shift;  /**< Fixed-point shift of counter_mult */
+	uint64_t counter_mult;   /**< Nanoseconds per cycle (fixed-point) */
+	uint64_t counter_base;   /**< Cycle counter at nsec_base */
+	uint64_t nsec_base;      /**< Uptime in nanoseconds at counter_base */
 } uptime_t;
 
 extern uptime_t *uptime;
 
+struct cpu;
+
 extern void clock(void);
 extern void clock_counter_init(void);
+extern bool clock_idle_enter(void);
+extern void clock_idle_exit(void);
+extern void clock_tick_restart(void);
+extern void clock_tick_kick(struct cpu *);
+
+/*
+ * Interface to be implemented by architectures which define
+ * CLOCK_TICKLESS_ARCH.
+ */
+extern bool clock_tick_stop_arch(uint64_t);
+extern void clock_tick_start_arch(void);
+extern void clock_tick_wakeup_arch(struct cpu *);
+
+/*
+ * Interface to be implemented by architectures which define
+ * CLOCK_COUNTER_ARCH, i.e. whose cycle counter can be read from
+ * the userspace.
+ */
+extern bool clock_counter_invariant_arch(void);
 
 #endif
 
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_debug
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_TRACEPOINT_H_
+#define KERN_TRACEPOINT_H_
+
+#include <abi/tracepoint.h>
+#include <stdint.h>
+
+#ifdef CONFIG_TRACEPOINTS
+
+extern void tracepoint_init(void);
+extern void tracepoint_record(trace_event_t, uint64_t, uint64_t, uint64_t);
+
+/** Record a kernel tracepoint event
+ *
+ * @param event Event (trace_event_t).
+ * @param arg1  First event-specific argument.
+ * @param arg2  Second event-specific argument.
+ * @param arg3  Third event-specific argument.
+ */
+#define TRACEPOINT(event, arg1, arg2, arg3) \
+	tracepoint_record((event), (uint64_t) (arg1), (uint64_t) (arg2), \
+	    (uint64_t) (arg3))
+
+#else /* CONFIG_TRACEPOINTS */
+
+#define tracepoint_init()
+#define TRACEPOINT(event, arg1, arg2, arg3)
+
+#endif /* CONFIG_TRACEPOINTS */
+
+#endif
+
+/** @}
+ */
@@ -39,6 +39,7 @@
 #include <ipc/ipc.h>
 #include <synch/mutex.h>
 #include <synch/condvar.h>
+#include <synch/spinlock.h>
 #include <arch/interrupt.h>
 #include <atomic.h>
 
@@ -63,6 +64,15 @@ typedef struct {
 	int not_stoppable_count;
 	struct task *debugger;
 	udebug_evmask_t evmask;
+
+	/** Sampling session, threads are never stopped */
+	bool sampling;
+	/** Statistics are being collected, may be read without locking */
+	bool stats_enabled;
+	/** Collected statistics, kept until the task is destroyed */
+	udebug_stats_t *stats;
+	/** Protects the contents of @c stats */
+	SPINLOCK_DECLARE(stats_lock);
 } udebug_task_t;
 
 /** Debugging part of thread_t structure.
@@ -88,6 +98,7 @@ struct task;
 struct thread;
 
 void udebug_task_init(udebug_task_t *);
+void udebug_task_destroy(udebug_task_t *);
 void udebug_thread_initialize(udebug_thread_t *);
 
 void udebug_syscall_event(sysarg_t, sysarg_t, sysarg_t, sysarg_t, sysarg_t,
@@ -101,6 +112,9 @@ void udebug_stoppable_end(void);
 
 void udebug_before_thread_runs(void);
 
+void udebug_stats_syscall(sysarg_t, uint64_t);
+void udebug_stats_ipc(sysarg_t);
+
 errno_t udebug_task_cleanup(struct task *);
 void udebug_thread_fault(void);
 
@@ -40,7 +40,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 
-errno_t udebug_begin(call_t *call, bool *active);
+errno_t udebug_begin(call_t *call, sysarg_t flags, bool *active);
 errno_t udebug_end(void);
 errno_t udebug_set_evmask(udebug_evmask_t mask);
 
@@ -50,11 +50,14 @@ errno_t udebug_stop(thread_t *t, call_t *call);
 errno_t udebug_thread_read(void **buffer, size_t buf_size, size_t *stored,
     size_t *needed);
 errno_t udebug_name_read(char **data, size_t *data_size);
+errno_t udebug_stats_read(void **data, size_t *data_size);
 errno_t udebug_args_read(thread_t *t, void **buffer);
 
 errno_t udebug_regs_read(thread_t *t, void **buffer);
 
 errno_t udebug_mem_read(sysarg_t uspace_addr, size_t n, void **buffer);
+errno_t udebug_mem_readv(const udebug_mem_range_t *ranges, size_t n,
+    void **buffer, size_t *size);
 
 #endif
 
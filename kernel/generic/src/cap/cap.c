@@ -88,37 +88,12 @@
 #include <stdlib.h>
 
 #define CAPS_START	(CAP_NIL + 1)
-#define CAPS_SIZE	(INT_MAX - CAPS_START)
-#define CAPS_LAST	(CAPS_SIZE - 1)
+#define CAPS_SIZE	(CAPS_DIR_SIZE * CAPS_LEAF_SIZE - CAPS_START)
+#define CAPS_LAST	(CAPS_START + CAPS_SIZE - 1)
 
 static slab_cache_t *cap_cache;
 static slab_cache_t *kobject_cache;
 
-static size_t caps_hash(const ht_link_t *item)
-{
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return hash_mix(cap_handle_raw(cap->handle));
-}
-
-static size_t caps_key_hash(const void *key)
-{
-	const cap_handle_t *handle = key;
-	return hash_mix(cap_handle_raw(*handle));
-}
-
-static bool caps_key_equal(const void *key, const ht_link_t *item)
-{
-	const cap_handle_t *handle = key;
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return *handle == cap->handle;
-}
-
-static hash_table_ops_t caps_ops = {
-	.hash = caps_hash,
-	.key_hash = caps_key_hash,
-	.key_equal = caps_key_equal
-};
-
 void caps_init(void)
 {
 	cap_cache = slab_cache_create("cap_t", sizeof(cap_t), 0, NULL,
@@ -141,8 +116,8 @@ errno_t caps_task_alloc(task_t *task)
 		goto error_handles;
 	if (!ra_span_add(task->cap_info->handles, CAPS_START, CAPS_SIZE))
 		goto error_span;
-	if (!hash_table_create(&task->cap_info->caps, 0, 0, &caps_ops))
-		goto error_span;
+	for (size_t i = 0; i < CAPS_DIR_SIZE; i++)
+		atomic_init(&task->cap_info->table[i], NULL);
 	return EOK;
 
 error_span:
@@ -170,7 +145,24 @@ void caps_task_init(task_t *task)
  */
 void caps_task_free(task_t *task)
 {
-	hash_table_destroy(&task->cap_info->caps);
+	for (size_t i = 0; i < CAPS_DIR_SIZE; i++) {
+		cap_leaf_t *leaf = atomic_load_explicit(&task->cap_info->table[i],
+		    memory_order_relaxed);
+		if (!leaf)
+			continue;
+
+		for (size_t j = 0; j < CAPS_LEAF_SIZE; j++) {
+			cap_t *cap = atomic_load_explicit(&leaf->caps[j],
+			    memory_order_relaxed);
+			if (cap) {
+				assert(cap->state == CAP_STATE_FREE);
+				slab_free(cap_cache, cap);
+			}
+		}
+
+		free(leaf);
+	}
+
 	ra_arena_destroy(task->cap_info->handles);
 	free(task->cap_info);
 }
@@ -211,6 +203,7 @@ bool caps_apply_to_kobject_type(task_t *task, kobject_type_t type,
  */
 static void cap_initialize(cap_t *cap, task_t *task, cap_handle_t handle)
 {
+	spinlock_initialize(&cap->lock, "cap.lock");
 	cap->state = CAP_STATE_FREE;
 	cap->task = task;
 	cap->handle = handle;
@@ -218,6 +211,33 @@ static void cap_initialize(cap_t *cap, task_t *task, cap_handle_t handle)
 	link_initialize(&cap->type_link);
 }
 
+/** Find capability in the capability table
+ *
+ * This function does not take any locks. The returned capability stays
+ * allocated until the task is destroyed, but it may be in any state.
+ *
+ * @param task    Task whose capability to find.
+ * @param handle  Capability handle of the desired capability.
+ *
+ * @return Address of the capability if it was ever allocated.
+ * @return NULL if no such capability exists.
+ */
+static cap_t *cap_lookup(task_t *task, cap_handle_t handle)
+{
+	if ((cap_handle_raw(handle) < CAPS_START) ||
+	    (cap_handle_raw(handle) > CAPS_LAST))
+		return NULL;
+
+	uintptr_t idx = (uintptr_t) cap_handle_raw(handle);
+	cap_leaf_t *leaf = atomic_load_explicit(
+	    &task->cap_info->table[idx / CAPS_LEAF_SIZE], memory_order_acquire);
+	if (!leaf)
+		return NULL;
+
+	return atomic_load_explicit(&leaf->caps[idx % CAPS_LEAF_SIZE],
+	    memory_order_acquire);
+}
+
 /** Get capability using capability handle
  *
  * @param task    Task whose capability to get.
@@ -231,18 +251,28 @@ static cap_t *cap_get(task_t *task, cap_handle_t handle, cap_state_t state)
 {
 	assert(mutex_locked(&task->cap_info->lock));
 
-	if ((cap_handle_raw(handle) < CAPS_START) ||
-	    (cap_handle_raw(handle) > CAPS_LAST))
-		return NULL;
-	ht_link_t *link = hash_table_find(&task->cap_info->caps, &handle);
-	if (!link)
-		return NULL;
-	cap_t *cap = hash_table_get_inst(link, cap_t, caps_link);
-	if (cap->state != state)
+	cap_t *cap = cap_lookup(task, handle);
+	if ((!cap) || (cap->state != state))
 		return NULL;
 	return cap;
 }
 
+/** Set the state and kernel object of a capability
+ *
+ * @param cap    Capability to modify.
+ * @param state  New state of the capability.
+ * @param kobj   New kernel object of the capability.
+ */
+static void cap_set(cap_t *cap, cap_state_t state, kobject_t *kobj)
+{
+	assert(mutex_locked(&cap->task->cap_info->lock));
+
+	spinlock_lock(&cap->lock);
+	cap->state = state;
+	cap->kobject = kobj;
+	spinlock_unlock(&cap->lock);
+}
+
 /** Allocate new capability
  *
  * @param task  Task for which to allocate the new capability.
@@ -254,21 +284,45 @@ static cap_t *cap_get(task_t *task, cap_handle_t handle, cap_state_t state)
 errno_t cap_alloc(task_t *task, cap_handle_t *handle)
 {
 	mutex_lock(&task->cap_info->lock);
-	cap_t *cap = slab_alloc(cap_cache, FRAME_ATOMIC);
-	if (!cap) {
-		mutex_unlock(&task->cap_info->lock);
-		return ENOMEM;
-	}
 	uintptr_t hbase;
 	if (!ra_alloc(task->cap_info->handles, 1, 1, &hbase)) {
-		slab_free(cap_cache, cap);
 		mutex_unlock(&task->cap_info->lock);
 		return ENOMEM;
 	}
-	cap_initialize(cap, task, (cap_handle_t) hbase);
-	hash_table_insert(&task->cap_info->caps, &cap->caps_link);
 
-	cap->state = CAP_STATE_ALLOCATED;
+	_Atomic(cap_leaf_t *) *slot =
+	    &task->cap_info->table[hbase / CAPS_LEAF_SIZE];
+	cap_leaf_t *leaf = atomic_load_explicit(slot, memory_order_relaxed);
+	if (!leaf) {
+		leaf = malloc(sizeof(cap_leaf_t));
+		if (!leaf) {
+			ra_free(task->cap_info->handles, hbase, 1);
+			mutex_unlock(&task->cap_info->lock);
+			return ENOMEM;
+		}
+
+		for (size_t i = 0; i < CAPS_LEAF_SIZE; i++)
+			atomic_init(&leaf->caps[i], NULL);
+
+		atomic_store_explicit(slot, leaf, memory_order_release);
+	}
+
+	_Atomic(cap_t *) *cslot = &leaf->caps[hbase % CAPS_LEAF_SIZE];
+	cap_t *cap = atomic_load_explicit(cslot, memory_order_relaxed);
+	if (!cap) {
+		cap = slab_alloc(cap_cache, FRAME_ATOMIC);
+		if (!cap) {
+			ra_free(task->cap_info->handles, hbase, 1);
+			mutex_unlock(&task->cap_info->lock);
+			return ENOMEM;
+		}
+
+		cap_initialize(cap, task, (cap_handle_t) hbase);
+		atomic_store_explicit(cslot, cap, memory_order_release);
+	}
+
+	assert(cap->state == CAP_STATE_FREE);
+	cap_set(cap, CAP_STATE_ALLOCATED, NULL);
 	*handle = cap->handle;
 	mutex_unlock(&task->cap_info->lock);
 
@@ -292,9 +346,8 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 	mutex_lock(&task->cap_info->lock);
 	cap_t *cap = cap_get(task, handle, CAP_STATE_ALLOCATED);
 	assert(cap);
-	cap->state = CAP_STATE_PUBLISHED;
 	/* Hand over kobj's reference to cap */
-	cap->kobject = kobj;
+	cap_set(cap, CAP_STATE_PUBLISHED, kobj);
 	list_append(&cap->kobj_link, &kobj->caps_list);
 	list_append(&cap->type_link, &task->cap_info->type_list[kobj->type]);
 	mutex_unlock(&task->cap_info->lock);
@@ -303,10 +356,9 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 
 static void cap_unpublish_unsafe(cap_t *cap)
 {
-	cap->kobject = NULL;
+	cap_set(cap, CAP_STATE_ALLOCATED, NULL);
 	list_remove(&cap->kobj_link);
 	list_remove(&cap->type_link);
-	cap->state = CAP_STATE_ALLOCATED;
 }
 
 /** Unpublish published capability
@@ -390,9 +442,9 @@ void cap_free(task_t *task, cap_handle_t handle)
 
 	assert(cap);
 
-	hash_table_remove_item(&task->cap_info->caps, &cap->caps_link);
+	/* The capability stays in the table for lockless lookups. */
+	cap_set(cap, CAP_STATE_FREE, NULL);
 	ra_free(task->cap_info->handles, cap_handle_raw(handle), 1);
-	slab_free(cap_cache, cap);
 	mutex_unlock(&task->cap_info->lock);
 }
 
@@ -427,6 +479,9 @@ void kobject_initialize(kobject_t *kobj, kobject_type_t type, void *raw,
 }
 
 /** Get new reference to kernel object from capability
+ *
+ * The capability is looked up without taking the capability info lock. Only
+ * the lock of the capability itself is held while the reference is taken.
  *
  * @param task    Task from which to get the reference.
  * @param handle  Capability handle.
@@ -441,15 +496,17 @@ kobject_get(struct task *task, cap_handle_t handle, kobject_type_t type)
 {
 	kobject_t *kobj = NULL;
 
-	mutex_lock(&task->cap_info->lock);
-	cap_t *cap = cap_get(task, handle, CAP_STATE_PUBLISHED);
-	if (cap) {
-		if (cap->kobject->type == type) {
-			kobj = cap->kobject;
-			atomic_inc(&kobj->refcnt);
-		}
+	cap_t *cap = cap_lookup(task, handle);
+	if (!cap)
+		return NULL;
+
+	spinlock_lock(&cap->lock);
+	if ((cap->state == CAP_STATE_PUBLISHED) &&
+	    (cap->kobject->type == type)) {
+		kobj = cap->kobject;
+		atomic_inc(&kobj->refcnt);
 	}
-	mutex_unlock(&task->cap_info->lock);
+	spinlock_unlock(&cap->lock);
 
 	return kobj;
 }
@@ -511,6 +511,19 @@ static cmd_info_t sysinfo_info = {
 	.argc = 0
 };
 
+#ifdef CONFIG_SPINLOCK_STATS
+
+/* Data and methods for 'spinlocks' command */
+static int cmd_spinlocks(cmd_arg_t *argv);
+static cmd_info_t spinlocks_info = {
+	.name = "spinlocks",
+	.description = "Show spinlock contention statistics.",
+	.func = cmd_spinlocks,
+	.argc = 0
+};
+
+#endif /* CONFIG_SPINLOCK_STATS */
+
 /* Data and methods for 'zones' command */
 static int cmd_zones(cmd_arg_t *argv);
 static cmd_info_t zones_info = {
@@ -600,6 +613,9 @@ static cmd_info_t *basic_commands[] = {
 	&reboot_info,
 	&sched_info,
 	&set4_info,
+#ifdef CONFIG_SPINLOCK_STATS
+	&spinlocks_info,
+#endif
 	&symaddr_info,
 	&sysinfo_info,
 	&tasks_info,
@@ -1280,6 +1296,22 @@ int cmd_sched(cmd_arg_t *argv)
 	return 1;
 }
 
+#ifdef CONFIG_SPINLOCK_STATS
+
+/** Command for printing spinlock contention statistics
+ *
+ * @param argv Ignored
+ *
+ * @return Always 1
+ */
+int cmd_spinlocks(cmd_arg_t *argv)
+{
+	spinlock_stats_print();
+	return 1;
+}
+
+#endif /* CONFIG_SPINLOCK_STATS */
+
 /** Command for listing memory zones
  *
  * @param argv Ignored
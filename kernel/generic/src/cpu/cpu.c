@@ -86,6 +86,7 @@ void cpu_init(void)
 
 			for (unsigned int j = 0; j < RQ_COUNT; j++) {
 				irq_spinlock_initialize(&cpus[i].rq[j].lock, "cpus[].rq[].lock");
+				irq_spinlock_stats_register(&cpus[i].rq[j].lock);
 				list_initialize(&cpus[i].rq[j].rq);
 			}
 		}
@@ -104,6 +105,10 @@ void cpu_init(void)
 	CPU->idle_cycles = 0;
 	CPU->busy_cycles = 0;
 
+	CPU->package_id = 0;
+	CPU->core_id = CPU->id;
+	CPU->node = 0;
+
 	cpu_identify();
 	cpu_arch_init();
 }
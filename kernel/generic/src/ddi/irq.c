@@ -48,6 +48,7 @@
 #include <interrupt.h>
 #include <mem.h>
 #include <arch.h>
+#include <tracepoint.h>
 
 slab_cache_t *irq_cache = NULL;
 
@@ -180,6 +181,8 @@ irq_t *irq_dispatch_and_lock(inr_t inr)
 	 * In the usual case the uspace handlers have precedence.
 	 */
 
+	TRACEPOINT(TRACE_IRQ, inr, 0, 0);
+
 	if (console_override) {
 		irq_t *irq = irq_dispatch_and_lock_table(&irq_kernel_hash_table,
 		    &irq_kernel_hash_table_lock, inr);
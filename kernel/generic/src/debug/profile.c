@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup kernel_generic_debug
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Sampling profiler.
+ *
+ * While profiling is enabled, every clock tick records the interrupted
+ * program counter, the kernel call stack and the task and thread IDs
+ * into a per-CPU ring buffer of samples. The buffers are exported to user
+ * space in the same way as the tracepoint buffers, the user space tool
+ * aggregates and symbolizes the samples.
+ */
+
+#include <profile.h>
+#include <abi/errno.h>
+#include <typedefs.h>
+
+#ifdef CONFIG_PROFILE
+
+#include <arch.h>
+#include <barrier.h>
+#include <config.h>
+#include <cpu.h>
+#include <ddi/ddi.h>
+#include <interrupt.h>
+#include <log.h>
+#include <macros.h>
+#include <mem.h>
+#include <mm/frame.h>
+#include <proc/task.h>
+#include <proc/thread.h>
+#include <security/perm.h>
+#include <stacktrace.h>
+#include <stdatomic.h>
+#include <str.h>
+#include <symtab_lookup.h>
+#include <syscall/copy.h>
+#include <sysinfo/sysinfo.h>
+
+/** Size of the sample buffer of a single CPU in pages. */
+#define PROFILE_BUFFER_PAGES  64
+
+/** Sample buffers of all CPUs, NULL until initialized. */
+static uint8_t *profile_buffers = NULL;
+
+static parea_t profile_parea;
+
+/** Samples are being taken. */
+static atomic_bool profile_enabled = false;
+
+/** Get the sample buffer of a CPU. */
+static inline profile_buffer_t *profile_buffer(unsigned int cpu)
+{
+	return (profile_buffer_t *) (profile_buffers +
+	    cpu * FRAMES2SIZE(PROFILE_BUFFER_PAGES));
+}
+
+/** Initialize the sampling profiler
+ *
+ * Allocate the sample buffers of all CPUs and export them to user space.
+ * Profiling stays disabled until requested by user space.
+ *
+ */
+void profile_init(void)
+{
+	size_t frames = config.cpu_count * PROFILE_BUFFER_PAGES;
+	uintptr_t faddr = frame_alloc(frames, FRAME_LOWMEM | FRAME_ATOMIC, 0);
+	if (faddr == 0) {
+		log(LF_OTHER, LVL_WARN,
+		    "Cannot allocate profiler buffers, profiling disabled.");
+		return;
+	}
+
+	uint8_t *buffers = (uint8_t *) PA2KA(faddr);
+	memsetb(buffers, FRAMES2SIZE(frames), 0);
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		profile_buffer_t *buf = (profile_buffer_t *) (buffers +
+		    i * FRAMES2SIZE(PROFILE_BUFFER_PAGES));
+
+		buf->head = 0;
+		buf->count = (FRAMES2SIZE(PROFILE_BUFFER_PAGES) -
+		    sizeof(profile_buffer_t)) / sizeof(profile_sample_t);
+		buf->cpu = i;
+	}
+
+	ddi_parea_init(&profile_parea);
+	profile_parea.pbase = faddr;
+	profile_parea.frames = frames;
+	profile_parea.unpriv = false;
+	profile_parea.mapped = false;
+	ddi_parea_register(&profile_parea);
+
+	sysinfo_set_item_val("profile.faddr", NULL, (sysarg_t) faddr);
+	sysinfo_set_item_val("profile.cpus", NULL, config.cpu_count);
+	sysinfo_set_item_val("profile.buffer_pages", NULL,
+	    PROFILE_BUFFER_PAGES);
+
+	write_barrier();
+	profile_buffers = buffers;
+}
+
+/** Check that a frame pointer points into the current kernel stack
+ *
+ * The kernel stack of the interrupted code is walked from the interrupt
+ * handler, so every frame must be checked before it is dereferenced.
+ *
+ */
+static bool profile_fp_valid(uintptr_t fp)
+{
+	uintptr_t base = (uintptr_t) ((THREAD) ? THREAD->kstack : CPU->stack);
+
+	return ((fp % sizeof(uintptr_t)) == 0) && (fp >= base) &&
+	    (fp <= base + STACK_SIZE - 2 * sizeof(uintptr_t));
+}
+
+/** Take a profiler sample of the current CPU
+ *
+ * Called from the clock interrupt handler with interrupts disabled.
+ * The interrupted user space call stack is not walked, because reading
+ * user memory may fault and the fault cannot be handled here. Only the
+ * user space program counter of the interrupted thread is recorded.
+ *
+ */
+void profile_sample(void)
+{
+	if ((!atomic_load_explicit(&profile_enabled, memory_order_relaxed)) ||
+	    (profile_buffers == NULL))
+		return;
+
+	istate_t *istate = CPU->istate;
+	if (istate == NULL)
+		return;
+
+	profile_buffer_t *buf = profile_buffer(CPU->id);
+	uint64_t seq = buf->head;
+	profile_sample_t *sample = &buf->samples[seq % buf->count];
+
+	/* Invalidate the sample for the readers while it is overwritten. */
+	sample->seq = 0;
+	write_barrier();
+
+	sample->task_id = (TASK) ? TASK->taskid : 0;
+	sample->thread_id = (THREAD) ? THREAD->tid : 0;
+	sample->flags = (THREAD) ? 0 : PROFILE_SAMPLE_IDLE;
+
+	unsigned int depth = 0;
+	unsigned int kdepth = 0;
+
+	if (istate_from_uspace(istate)) {
+		sample->flags |= PROFILE_SAMPLE_USPACE;
+		sample->pc[depth++] = istate_get_pc(istate);
+	} else {
+		stack_trace_context_t ctx = {
+			.fp = istate_get_fp(istate),
+			.pc = istate_get_pc(istate),
+			.istate = istate
+		};
+
+		sample->pc[depth++] = ctx.pc;
+
+		while ((depth < PROFILE_STACK_DEPTH) &&
+		    (profile_fp_valid(ctx.fp))) {
+			uintptr_t pc;
+			uintptr_t fp;
+
+			if ((!kernel_return_address_get(&ctx, &pc)) ||
+			    (!kernel_frame_pointer_prev(&ctx, &fp)) ||
+			    (pc == 0))
+				break;
+
+			sample->pc[depth++] = pc;
+			ctx.fp = fp;
+			ctx.pc = pc;
+		}
+
+		kdepth = depth;
+
+		/* Attribute the sample to the user space caller, if any. */
+		if ((THREAD) && (THREAD->uspace) &&
+		    (depth < PROFILE_STACK_DEPTH))
+			sample->pc[depth++] = istate_get_pc(istate_get(THREAD));
+	}
+
+	sample->depth = depth;
+	sample->kdepth = kdepth;
+
+	write_barrier();
+	sample->seq = seq + 1;
+	buf->head = seq + 1;
+}
+
+/** Copy the name of the kernel function containing an address to user space */
+static errno_t profile_symbol(uintptr_t addr, void *buf, size_t size)
+{
+	const char *name;
+	errno_t rc = symtab_name_lookup(addr, &name, NULL);
+	if (rc != EOK)
+		return rc;
+
+	size_t len = str_size(name) + 1;
+	if (len > size)
+		return EOVERFLOW;
+
+	return copy_to_uspace(buf, name, len);
+}
+
+/** Start or stop profiling, resolve kernel symbols
+ *
+ * @param op   Operation (profile_operation_t).
+ * @param addr Kernel address to resolve (PROFILE_SYMBOL).
+ * @param buf  User space buffer for the symbol name (PROFILE_SYMBOL).
+ * @param size Size of buf.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+sys_errno_t sys_profile(sysarg_t op, sysarg_t addr, void *buf, size_t size)
+{
+	switch (op) {
+	case PROFILE_START:
+	case PROFILE_STOP:
+		if (!(perm_get(TASK) & PERM_MEM_MANAGER))
+			return (sys_errno_t) EPERM;
+
+		if (profile_buffers == NULL)
+			return (sys_errno_t) ENOMEM;
+
+		atomic_store(&profile_enabled, op == PROFILE_START);
+		return EOK;
+	case PROFILE_SYMBOL:
+		return (sys_errno_t) profile_symbol(addr, buf, size);
+	default:
+		return (sys_errno_t) EINVAL;
+	}
+}
+
+#else /* CONFIG_PROFILE */
+
+sys_errno_t sys_profile(sysarg_t op, sysarg_t addr, void *buf, size_t size)
+{
+	return (sys_errno_t) ENOTSUP;
+}
+
+#endif /* CONFIG_PROFILE */
+
+/** @}
+ */
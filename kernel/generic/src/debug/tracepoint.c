@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_debug
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Kernel tracepoints.
+ *
+ * Every CPU records tracepoint events into its own ring buffer of
+ * fixed-size binary records. Records are written with interrupts disabled
+ * and without any locking, so tracepoints can be placed on hot paths and
+ * in interrupt context. The buffers are exported to user space, which
+ * consumes them without any kernel involvement.
+ */
+
+#ifdef CONFIG_TRACEPOINTS
+
+#include <tracepoint.h>
+#include <arch.h>
+#include <arch/asm.h>
+#include <arch/cycle.h>
+#include <barrier.h>
+#include <config.h>
+#include <cpu.h>
+#include <ddi/ddi.h>
+#include <log.h>
+#include <macros.h>
+#include <mem.h>
+#include <mm/frame.h>
+#include <proc/thread.h>
+#include <sysinfo/sysinfo.h>
+
+/** Size of the tracepoint buffer of a single CPU in pages. */
+#define TRACE_BUFFER_PAGES  32
+
+/** Tracepoint buffers of all CPUs, NULL until initialized. */
+static uint8_t *trace_buffers = NULL;
+
+static parea_t trace_parea;
+
+/** Get the tracepoint buffer of a CPU. */
+static inline trace_buffer_t *trace_buffer(unsigned int cpu)
+{
+	return (trace_buffer_t *) (trace_buffers +
+	    cpu * FRAMES2SIZE(TRACE_BUFFER_PAGES));
+}
+
+/** Initialize kernel tracepoints
+ *
+ * Allocate the tracepoint buffers of all CPUs and export them to user
+ * space. Tracepoint events that occur before this point are dropped.
+ *
+ */
+void tracepoint_init(void)
+{
+	size_t frames = config.cpu_count * TRACE_BUFFER_PAGES;
+	uintptr_t faddr = frame_alloc(frames, FRAME_LOWMEM | FRAME_ATOMIC, 0);
+	if (faddr == 0) {
+		log(LF_OTHER, LVL_WARN,
+		    "Cannot allocate tracepoint buffers, tracepoints disabled.");
+		return;
+	}
+
+	uint8_t *buffers = (uint8_t *) PA2KA(faddr);
+	memsetb(buffers, FRAMES2SIZE(frames), 0);
+
+	for (unsigned int i = 0; i < config.cpu_count; i++) {
+		trace_buffer_t *buf = (trace_buffer_t *) (buffers +
+		    i * FRAMES2SIZE(TRACE_BUFFER_PAGES));
+
+		buf->head = 0;
+		buf->count = (FRAMES2SIZE(TRACE_BUFFER_PAGES) -
+		    sizeof(trace_buffer_t)) / sizeof(trace_record_t);
+		buf->cpu = i;
+	}
+
+	ddi_parea_init(&trace_parea);
+	trace_parea.pbase = faddr;
+	trace_parea.frames = frames;
+	trace_parea.unpriv = false;
+	trace_parea.mapped = false;
+	ddi_parea_register(&trace_parea);
+
+	sysinfo_set_item_val("trace.faddr", NULL, (sysarg_t) faddr);
+	sysinfo_set_item_val("trace.cpus", NULL, config.cpu_count);
+	sysinfo_set_item_val("trace.buffer_pages", NULL, TRACE_BUFFER_PAGES);
+
+	write_barrier();
+	trace_buffers = buffers;
+}
+
+/** Record a tracepoint event
+ *
+ * @param event Event.
+ * @param arg1  First event-specific argument.
+ * @param arg2  Second event-specific argument.
+ * @param arg3  Third event-specific argument.
+ *
+ */
+void tracepoint_record(trace_event_t event, uint64_t arg1, uint64_t arg2,
+    uint64_t arg3)
+{
+	if ((trace_buffers == NULL) || (CPU == NULL))
+		return;
+
+	ipl_t ipl = interrupts_disable();
+
+	trace_buffer_t *buf = trace_buffer(CPU->id);
+	uint64_t seq = buf->head;
+	trace_record_t *rec = &buf->records[seq % buf->count];
+
+	/* Invalidate the record for the readers while it is overwritten. */
+	rec->seq = 0;
+	write_barrier();
+
+	rec->timestamp = get_cycle();
+	rec->thread_id = (THREAD != NULL) ? THREAD->tid : 0;
+	rec->args[0] = arg1;
+	rec->args[1] = arg2;
+	rec->args[2] = arg3;
+	rec->cpu = CPU->id;
+	rec->event = event;
+
+	write_barrier();
+	rec->seq = seq + 1;
+	buf->head = seq + 1;
+
+	interrupts_restore(ipl);
+}
+
+#endif /* CONFIG_TRACEPOINTS */
+
+/** @}
+ */
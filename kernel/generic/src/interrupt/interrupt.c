@@ -128,8 +128,17 @@ _NO_TRACE void exc_dispatch(unsigned int n, istate_t *istate)
 		THREAD->udebug.uspace_state = istate;
 #endif
 
+	istate_t *prev_istate = NULL;
+	if (CPU) {
+		prev_istate = CPU->istate;
+		CPU->istate = istate;
+	}
+
 	exc_table[n].handler(n + IVT_FIRST, istate);
 
+	if (CPU)
+		CPU->istate = prev_istate;
+
 #ifdef CONFIG_UDEBUG
 	if (THREAD)
 		THREAD->udebug.uspace_state = NULL;
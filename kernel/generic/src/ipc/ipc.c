@@ -51,8 +51,13 @@
 #include <ipc/sysipc_priv.h>
 #include <errno.h>
 #include <mm/slab.h>
+#include <mm/as.h>
+#include <mm/frame.h>
+#include <syscall/copy.h>
+#include <align.h>
 #include <arch.h>
 #include <proc/task.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdio.h>
 #include <console/console.h>
@@ -61,6 +66,16 @@
 #include <ipc/irq.h>
 #include <cap/cap.h>
 #include <stdlib.h>
+#include <tracepoint.h>
+
+/** Smallest data transfer passed by referencing the frames of the buffer. */
+#define IPC_DATA_FRAMES_MIN  (4 * PAGE_SIZE)
+
+/** Backlog of an answerbox below which its callers' windows grow. */
+#define IPC_BACKLOG_LOW  8
+
+/** Backlog of an answerbox above which its callers' windows shrink. */
+#define IPC_BACKLOG_HIGH  256
 
 static void ipc_forget_call(call_t *);
 
@@ -86,6 +101,20 @@ static void _ipc_call_init(call_t *call)
 	call->sender = NULL;
 	call->callerbox = NULL;
 	call->buffer = NULL;
+	call->frames = NULL;
+	call->frames_count = 0;
+	call->notif_pending = NULL;
+}
+
+/** Drop the references to the frames of a data transfer. */
+static void call_frames_put(call_t *call)
+{
+	for (size_t i = 0; i < call->frames_count; i++)
+		frame_free(call->frames[i], 1);
+
+	free(call->frames);
+	call->frames = NULL;
+	call->frames_count = 0;
 }
 
 static void call_destroy(void *arg)
@@ -94,6 +123,8 @@ static void call_destroy(void *arg)
 
 	if (call->buffer)
 		free(call->buffer);
+	if (call->frames)
+		call_frames_put(call);
 	if (call->caller_phone)
 		kobject_put(call->caller_phone->kobject);
 	slab_free(call_cache, call);
@@ -132,6 +163,94 @@ call_t *ipc_call_alloc(void)
 	return call;
 }
 
+/** Attach the frames backing a data transfer buffer to a call.
+ *
+ * Large IPC_M_DATA_WRITE and IPC_M_DATA_READ transfers do not bounce the
+ * payload through a kernel buffer. Instead, the frames backing the buffer
+ * in one address space are referenced and the data is copied directly
+ * between them and the other address space, see ipc_call_frames_copy().
+ * This halves the number of copies.
+ *
+ * @param call   Call of the transfer.
+ * @param uaddr  Userspace address of the buffer in the current address
+ *               space.
+ * @param size   Size of the buffer.
+ * @param access AS_AREA_READ if the data will be read from the buffer,
+ *               AS_AREA_WRITE if it will be written to it.
+ *
+ * @return EOK if the frames were attached to the call.
+ * @return ENOTSUP if the transfer is too small or the buffer cannot be
+ *         referenced, in which case the data has to be bounced.
+ * @return ENOMEM if there is not enough memory.
+ *
+ */
+errno_t ipc_call_frames_get(call_t *call, uintptr_t uaddr, size_t size,
+    unsigned int access)
+{
+	assert(!call->buffer);
+	assert(!call->frames);
+
+	if (size < IPC_DATA_FRAMES_MIN)
+		return ENOTSUP;
+
+	size_t offset = uaddr - ALIGN_DOWN(uaddr, PAGE_SIZE);
+	size_t count = SIZE2FRAMES(offset + size);
+
+	uintptr_t *frames = malloc(count * sizeof(uintptr_t));
+	if (!frames)
+		return ENOMEM;
+
+	if (as_area_frames_get(AS, uaddr, size, access, frames) != EOK) {
+		free(frames);
+		return ENOTSUP;
+	}
+
+	call->frames = frames;
+	call->frames_count = count;
+	call->frames_offset = offset;
+
+	return EOK;
+}
+
+/** Copy data between the frames attached to a call and the current AS.
+ *
+ * @param call  Call with frames attached by ipc_call_frames_get().
+ * @param uaddr Userspace address in the current address space.
+ * @param size  Number of bytes to copy.
+ * @param to    If true, copy from the frames to @a uaddr, otherwise copy
+ *              from @a uaddr to the frames.
+ *
+ * @return EOK on success or an error code from the uspace copy.
+ *
+ */
+errno_t ipc_call_frames_copy(call_t *call, uintptr_t uaddr, size_t size,
+    bool to)
+{
+	assert(call->frames);
+	assert(call->frames_offset + size <=
+	    FRAMES2SIZE(call->frames_count));
+
+	size_t offset = call->frames_offset;
+	for (size_t i = 0; size > 0; i++) {
+		size_t chunk = min(PAGE_SIZE - offset, size);
+		void *kaddr = (void *) (PA2KA(call->frames[i]) + offset);
+
+		errno_t rc;
+		if (to)
+			rc = copy_to_uspace((void *) uaddr, kaddr, chunk);
+		else
+			rc = copy_from_uspace(kaddr, (void *) uaddr, chunk);
+		if (rc != EOK)
+			return rc;
+
+		uaddr += chunk;
+		size -= chunk;
+		offset = 0;
+	}
+
+	return EOK;
+}
+
 /** Initialize an answerbox structure.
  *
  * @param box  Answerbox structure to be initialized.
@@ -149,6 +268,7 @@ void ipc_answerbox_init(answerbox_t *box, task_t *task)
 	list_initialize(&box->answers);
 	list_initialize(&box->irq_notifs);
 	atomic_store(&box->active_calls, 0);
+	atomic_store(&box->queued_calls, 0);
 	box->task = task;
 }
 
@@ -199,6 +319,8 @@ void ipc_phone_init(phone_t *phone, task_t *caller)
 	phone->callee = NULL;
 	phone->state = IPC_PHONE_FREE;
 	atomic_store(&phone->active_calls, 0);
+	atomic_store(&phone->window, IPC_ASYNC_WINDOW_INIT);
+	atomic_store(&phone->stalls, 0);
 	phone->label = 0;
 	phone->kobject = NULL;
 }
@@ -280,15 +402,20 @@ errno_t ipc_call_sync(phone_t *phone, call_t *request)
  *
  * @param call       Call structure to be answered.
  * @param selflocked If true, then TASK->answebox is locked.
+ * @param handoff    If true, the woken up caller runs next on this CPU.
  *
  */
-void _ipc_answer_free_call(call_t *call, bool selflocked)
+static void _ipc_answer_free_call_internal(call_t *call, bool selflocked,
+    bool handoff)
 {
 	/* Count sent answer */
 	irq_spinlock_lock(&TASK->lock, true);
 	TASK->ipc_info.answer_sent++;
 	irq_spinlock_unlock(&TASK->lock, true);
 
+	TRACEPOINT(TRACE_IPC_ANSWER, ipc_get_imethod(&call->data),
+	    ipc_get_retval(&call->data), 0);
+
 	spinlock_lock(&call->forget_lock);
 	if (call->forget) {
 		/* This is a forgotten call and call->sender is not valid. */
@@ -325,7 +452,18 @@ void _ipc_answer_free_call(call_t *call, bool selflocked)
 	if (do_lock)
 		irq_spinlock_unlock(&callerbox->lock, true);
 
-	waitq_wakeup(&callerbox->wq, WAKEUP_FIRST);
+	waitq_wakeup(&callerbox->wq, handoff ? WAKEUP_HANDOFF : WAKEUP_FIRST);
+}
+
+/** Answer a message which was not dispatched and is not listed in any queue.
+ *
+ * @param call       Call structure to be answered.
+ * @param selflocked If true, then TASK->answebox is locked.
+ *
+ */
+void _ipc_answer_free_call(call_t *call, bool selflocked)
+{
+	_ipc_answer_free_call_internal(call, selflocked, false);
 }
 
 /** Answer a message which is in a callee queue.
@@ -341,8 +479,11 @@ void ipc_answer(answerbox_t *box, call_t *call)
 	list_remove(&call->ab_link);
 	irq_spinlock_unlock(&box->lock, true);
 
-	/* Send back answer */
-	_ipc_answer_free_call(call, false);
+	/*
+	 * Send back answer. The answering server is typically about to wait
+	 * for the next request, so let the caller run next on this CPU.
+	 */
+	_ipc_answer_free_call_internal(call, false, true);
 }
 
 static void _ipc_call_actions_internal(phone_t *phone, call_t *call,
@@ -373,6 +514,55 @@ static void _ipc_call_actions_internal(phone_t *phone, call_t *call,
 	call->data.task_id = caller->taskid;
 }
 
+/** Let a phone have one more async call active at a time.
+ *
+ * Called when the callee picks up a call made over the phone and has only
+ * few other calls waiting. The window only grows while the caller actually
+ * makes use of it.
+ *
+ * @param phone Phone the call was made over.
+ *
+ */
+static void ipc_window_grow(phone_t *phone)
+{
+	size_t window = atomic_load(&phone->window);
+
+	if (window >= IPC_ASYNC_WINDOW_MAX)
+		return;
+
+	if (atomic_load(&phone->active_calls) < window / 2)
+		return;
+
+	/* Losing the race with another update just skips this step. */
+	atomic_compare_exchange_strong(&phone->window, &window, window + 1);
+}
+
+/** Halve the async call window of a phone whose callee backs up.
+ *
+ * Phones with fewer than half of their window in use are not the cause of
+ * the backlog and keep their window.
+ *
+ * @param phone Phone the call is being made over.
+ * @param box   Answerbox of the callee.
+ *
+ */
+static void ipc_window_shrink(phone_t *phone, answerbox_t *box)
+{
+	size_t window = atomic_load(&phone->window);
+
+	if (atomic_load(&box->queued_calls) < IPC_BACKLOG_HIGH)
+		return;
+
+	if (window <= IPC_ASYNC_WINDOW_MIN)
+		return;
+
+	if (atomic_load(&phone->active_calls) < window / 2)
+		return;
+
+	atomic_compare_exchange_strong(&phone->window, &window,
+	    max(window / 2, (size_t) IPC_ASYNC_WINDOW_MIN));
+}
+
 /** Simulate sending back a message.
  *
  * Most errors are better handled by forming a normal backward
@@ -396,10 +586,11 @@ void ipc_backsend_err(phone_t *phone, call_t *call, errno_t err)
  * @param box       Destination answerbox structure.
  * @param call      Call structure with request.
  * @param preforget If true, the call will be delivered already forgotten.
+ * @param handoff   If true, the woken up callee runs next on this CPU.
  *
  */
 static void _ipc_call(phone_t *phone, answerbox_t *box, call_t *call,
-    bool preforget)
+    bool preforget, bool handoff)
 {
 	task_t *caller = phone->caller;
 
@@ -408,17 +599,29 @@ static void _ipc_call(phone_t *phone, answerbox_t *box, call_t *call,
 	caller->ipc_info.call_sent++;
 	irq_spinlock_unlock(&caller->lock, true);
 
-	if (!(call->flags & IPC_CALL_FORWARDED))
+	TRACEPOINT(TRACE_IPC_CALL, box->task->taskid,
+	    ipc_get_imethod(&call->data), 0);
+
+	if (!(call->flags & IPC_CALL_FORWARDED)) {
 		_ipc_call_actions_internal(phone, call, preforget);
+		if (!preforget)
+			ipc_window_shrink(phone, box);
+	}
 
 	irq_spinlock_lock(&box->lock, true);
 	list_append(&call->ab_link, &box->calls);
+	atomic_inc(&box->queued_calls);
 	irq_spinlock_unlock(&box->lock, true);
 
-	waitq_wakeup(&box->wq, WAKEUP_FIRST);
+	waitq_wakeup(&box->wq, handoff ? WAKEUP_HANDOFF : WAKEUP_FIRST);
 }
 
 /** Send an asynchronous request using a phone to an answerbox.
+ *
+ * The number of async calls which may be active over the phone adapts to
+ * the callee. The window grows by one with each call the callee picks up
+ * while it has few calls waiting and halves when a call finds a long
+ * queue in the answerbox.
  *
  * @param phone Phone structure the call comes from and which is
  *              connected to the destination answerbox.
@@ -442,8 +645,12 @@ errno_t ipc_call(phone_t *phone, call_t *call)
 		return ENOENT;
 	}
 
+	/*
+	 * The caller will usually wait for the answer right away, so hand
+	 * the processor over to the server thread blocked on its answerbox.
+	 */
 	answerbox_t *box = phone->callee;
-	_ipc_call(phone, box, call, false);
+	_ipc_call(phone, box, call, false, true);
 
 	mutex_unlock(&phone->lock);
 	return 0;
@@ -487,7 +694,7 @@ errno_t ipc_phone_hangup(phone_t *phone)
 		ipc_set_imethod(&call->data, IPC_M_PHONE_HUNGUP);
 		call->request_method = IPC_M_PHONE_HUNGUP;
 		call->flags |= IPC_CALL_DISCARD_ANSWER;
-		_ipc_call(phone, box, call, false);
+		_ipc_call(phone, box, call, false, false);
 	}
 
 	phone->state = IPC_PHONE_HUNGUP;
@@ -569,6 +776,12 @@ errno_t ipc_wait_for_call(answerbox_t *box, uint32_t usec, unsigned int flags,
 		    call_t, ab_link);
 		list_remove(&request->ab_link);
 
+		/* Further interrupts need a new notification */
+		if (request->notif_pending != NULL) {
+			*request->notif_pending = NULL;
+			request->notif_pending = NULL;
+		}
+
 		irq_spinlock_unlock(&box->irq_lock, false);
 	} else if (!list_empty(&box->answers)) {
 		/* Count received answer */
@@ -590,6 +803,11 @@ errno_t ipc_wait_for_call(answerbox_t *box, uint32_t usec, unsigned int flags,
 		    call_t, ab_link);
 		list_remove(&request->ab_link);
 
+		/* The callee keeps up with the caller */
+		if ((atomic_predec(&box->queued_calls) < IPC_BACKLOG_LOW) &&
+		    (!request->forget))
+			ipc_window_grow(request->caller_phone);
+
 		/* Append request to dispatch queue */
 		list_append(&request->ab_link, &box->dispatched_calls);
 	} else {
@@ -626,6 +844,8 @@ void ipc_cleanup_call_list(answerbox_t *box, list_t *lst)
 		    ab_link);
 
 		list_remove(&call->ab_link);
+		if (lst == &box->calls)
+			atomic_dec(&box->queued_calls);
 
 		irq_spinlock_unlock(&box->lock, true);
 
@@ -692,7 +912,7 @@ restart_phones:
 			ipc_set_imethod(&call->data, IPC_M_PHONE_HUNGUP);
 			call->request_method = IPC_M_PHONE_HUNGUP;
 			call->flags |= IPC_CALL_DISCARD_ANSWER;
-			_ipc_call(phone, box, call, true);
+			_ipc_call(phone, box, call, true, false);
 
 			task_release(phone->caller);
 
@@ -930,8 +1150,11 @@ static bool print_task_phone_cb(cap_t *cap, void *arg)
 
 	mutex_lock(&phone->lock);
 	if (phone->state != IPC_PHONE_FREE) {
-		printf("%-11d %7" PRIun " ", (int) cap_handle_raw(cap->handle),
-		    atomic_load(&phone->active_calls));
+		printf("%-11d %7" PRIun " %8" PRIun " %8" PRIun " ",
+		    (int) cap_handle_raw(cap->handle),
+		    atomic_load(&phone->active_calls),
+		    atomic_load(&phone->window),
+		    atomic_load(&phone->stalls));
 
 		switch (phone->state) {
 		case IPC_PHONE_CONNECTING:
@@ -975,7 +1198,7 @@ void ipc_print_task(task_id_t taskid)
 	task_hold(task);
 	irq_spinlock_unlock(&tasks_lock, true);
 
-	printf("[phone cap] [calls] [state\n");
+	printf("[phone cap] [calls] [window] [stalls] [state\n");
 
 	caps_apply_to_kobject_type(task, KOBJECT_TYPE_PHONE,
 	    print_task_phone_cb, NULL);
@@ -985,6 +1208,8 @@ void ipc_print_task(task_id_t taskid)
 
 	printf("Active calls: %" PRIun "\n",
 	    atomic_load(&task->answerbox.active_calls));
+	printf("Queued calls: %" PRIun "\n",
+	    atomic_load(&task->answerbox.queued_calls));
 
 #ifdef __32_BITS__
 	printf("[call adr] [method] [arg1] [arg2] [arg3] [arg4] [arg5]"
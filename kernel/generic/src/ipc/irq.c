@@ -65,6 +65,10 @@
 #include <console/console.h>
 #include <macros.h>
 #include <cap/cap.h>
+#include <config.h>
+#include <cpu.h>
+#include <proc/scheduler.h>
+#include <proc/thread.h>
 #include <stdlib.h>
 
 static void ranges_unmap(irq_pio_range_t *ranges, size_t rangecount)
@@ -300,6 +304,15 @@ static void irq_destroy(void *arg)
 
 	irq_hash_out(irq);
 
+	/* A coalesced notification may still be queued in the answerbox. */
+	answerbox_t *box = irq->notif_cfg.answerbox;
+	irq_spinlock_lock(&box->irq_lock, true);
+	if (irq->notif_cfg.pending != NULL) {
+		irq->notif_cfg.pending->notif_pending = NULL;
+		irq->notif_cfg.pending = NULL;
+	}
+	irq_spinlock_unlock(&box->irq_lock, true);
+
 	/* Free up the IRQ code and associated structures. */
 	code_free(irq->notif_cfg.code);
 	slab_free(irq_cache, irq);
@@ -371,6 +384,8 @@ errno_t ipc_irq_subscribe(answerbox_t *box, inr_t inr, sysarg_t imethod,
 	irq->notif_cfg.imethod = imethod;
 	irq->notif_cfg.code = code;
 	irq->notif_cfg.counter = 0;
+	irq->notif_cfg.flags = 0;
+	irq->notif_cfg.pending = NULL;
 
 	/*
 	 * Insert the IRQ structure into the uspace IRQ hash table.
@@ -414,21 +429,180 @@ errno_t ipc_irq_unsubscribe(answerbox_t *box, cap_irq_handle_t handle)
 	return EOK;
 }
 
-/** Add a call to the proper answerbox queue.
+/** Set the notification flags of an IRQ.
+ *
+ * @param box    Answerbox associated with the notification.
+ * @param handle IRQ capability handle.
+ * @param flags  IRQ_NOTIF_* flags.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t ipc_irq_set_flags(answerbox_t *box, cap_irq_handle_t handle,
+    unsigned int flags)
+{
+	if ((flags & ~IRQ_NOTIF_COALESCE) != 0)
+		return EINVAL;
+
+	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_IRQ);
+	if (!kobj)
+		return ENOENT;
+
+	irq_t *irq = kobj->irq;
+	assert(irq->notif_cfg.answerbox == box);
+
+	irq_spinlock_lock(&irq->lock, true);
+	irq_spinlock_lock(&box->irq_lock, false);
+
+	irq->notif_cfg.flags = flags;
+
+	/* Interrupts no longer merge into the queued notification. */
+	if (((flags & IRQ_NOTIF_COALESCE) == 0) &&
+	    (irq->notif_cfg.pending != NULL)) {
+		irq->notif_cfg.pending->notif_pending = NULL;
+		irq->notif_cfg.pending = NULL;
+	}
+
+	irq_spinlock_unlock(&box->irq_lock, false);
+	irq_spinlock_unlock(&irq->lock, true);
+
+	kobject_put(kobj);
+	return EOK;
+}
+
+/** Deliver an IRQ to a processor and run the current thread there.
+ *
+ * Handling the interrupts on the processor which receives them keeps the
+ * data of the driver in the cache of that processor.
+ *
+ * @param box    Answerbox associated with the notification.
+ * @param handle IRQ capability handle.
+ * @param cpu    Processor ID or IRQ_CPU_ANY to let the IRQ go to any
+ *               processor and the current thread run anywhere.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t ipc_irq_set_cpu(answerbox_t *box, cap_irq_handle_t handle,
+    unsigned int cpu)
+{
+	cpu_t *target = NULL;
+
+	if (cpu != IRQ_CPU_ANY) {
+		if ((cpu >= config.cpu_count) || (!cpus[cpu].active))
+			return EINVAL;
+
+		target = &cpus[cpu];
+	}
+
+	kobject_t *kobj = kobject_get(TASK, handle, KOBJECT_TYPE_IRQ);
+	if (!kobj)
+		return ENOENT;
+
+	irq_t *irq = kobj->irq;
+	assert(irq->notif_cfg.answerbox == box);
+
+#ifdef IRQ_ROUTE_ARCH
+	errno_t rc = irq_route_arch(irq->inr, target);
+#else
+	errno_t rc = (target == NULL) ? EOK : ENOTSUP;
+#endif
+
+	kobject_put(kobj);
+
+	if (rc != EOK)
+		return rc;
+
+	if (target == NULL) {
+		thread_unwire(THREAD);
+		return EOK;
+	}
+
+#ifdef CONFIG_FPU_LAZY
+	/* The FPU context must not stay behind on this processor. */
+	scheduler_fpu_release();
+#endif
+
+	thread_wire(THREAD, target);
+
+	/* Move to the target processor right away. */
+	if (target != CPU)
+		scheduler();
+
+	return EOK;
+}
+
+/** Send an IRQ notification to the answerbox.
  *
  * Assume irq->lock is locked and interrupts disabled.
  *
- * @param irq  IRQ structure referencing the target answerbox.
- * @param call IRQ notification call.
+ * If the IRQ coalesces its notifications and the previous notification
+ * is still queued in the answerbox, the arguments are merged into it and
+ * no new notification is allocated.
+ *
+ * @param irq IRQ structure referencing the target answerbox.
+ * @param a1  Payload argument.
+ * @param a2  Payload argument.
+ * @param a3  Payload argument.
+ * @param a4  Payload argument.
+ * @param a5  Payload argument.
  *
  */
-static void send_call(irq_t *irq, call_t *call)
+static void send_notif(irq_t *irq, sysarg_t a1, sysarg_t a2, sysarg_t a3,
+    sysarg_t a4, sysarg_t a5)
 {
-	irq_spinlock_lock(&irq->notif_cfg.answerbox->irq_lock, false);
-	list_append(&call->ab_link, &irq->notif_cfg.answerbox->irq_notifs);
-	irq_spinlock_unlock(&irq->notif_cfg.answerbox->irq_lock, false);
+	answerbox_t *box = irq->notif_cfg.answerbox;
+	bool coalesce = (irq->notif_cfg.flags & IRQ_NOTIF_COALESCE) != 0;
+	call_t *call;
+
+	if (coalesce) {
+		irq_spinlock_lock(&box->irq_lock, false);
+
+		call = irq->notif_cfg.pending;
+		if (call != NULL) {
+			/* Put a counter to the message */
+			call->priv = ++irq->notif_cfg.counter;
+
+			call->data.args[1] |= a1;
+			call->data.args[2] |= a2;
+			call->data.args[3] |= a3;
+			call->data.args[4] |= a4;
+			call->data.args[5] |= a5;
+
+			irq_spinlock_unlock(&box->irq_lock, false);
+			return;
+		}
+
+		irq_spinlock_unlock(&box->irq_lock, false);
+	}
+
+	call = ipc_call_alloc();
+	if (!call)
+		return;
+
+	call->flags |= IPC_CALL_NOTIF;
+	/* Put a counter to the message */
+	call->priv = ++irq->notif_cfg.counter;
+
+	/* Set up args */
+	ipc_set_imethod(&call->data, irq->notif_cfg.imethod);
+	ipc_set_arg1(&call->data, a1);
+	ipc_set_arg2(&call->data, a2);
+	ipc_set_arg3(&call->data, a3);
+	ipc_set_arg4(&call->data, a4);
+	ipc_set_arg5(&call->data, a5);
 
-	waitq_wakeup(&irq->notif_cfg.answerbox->wq, WAKEUP_FIRST);
+	irq_spinlock_lock(&box->irq_lock, false);
+
+	list_append(&call->ab_link, &box->irq_notifs);
+	if (coalesce) {
+		irq->notif_cfg.pending = call;
+		call->notif_pending = &irq->notif_cfg.pending;
+	}
+
+	irq_spinlock_unlock(&box->irq_lock, false);
+
+	waitq_wakeup(&box->wq, WAKEUP_FIRST);
 }
 
 /** Apply the top-half IRQ code to find out whether to accept the IRQ or not.
@@ -529,23 +703,9 @@ void ipc_irq_top_half_handler(irq_t *irq)
 	assert(irq_spinlock_locked(&irq->lock));
 
 	if (irq->notif_cfg.answerbox) {
-		call_t *call = ipc_call_alloc();
-		if (!call)
-			return;
-
-		call->flags |= IPC_CALL_NOTIF;
-		/* Put a counter to the message */
-		call->priv = ++irq->notif_cfg.counter;
-
-		/* Set up args */
-		ipc_set_imethod(&call->data, irq->notif_cfg.imethod);
-		ipc_set_arg1(&call->data, irq->notif_cfg.scratch[1]);
-		ipc_set_arg2(&call->data, irq->notif_cfg.scratch[2]);
-		ipc_set_arg3(&call->data, irq->notif_cfg.scratch[3]);
-		ipc_set_arg4(&call->data, irq->notif_cfg.scratch[4]);
-		ipc_set_arg5(&call->data, irq->notif_cfg.scratch[5]);
-
-		send_call(irq, call);
+		send_notif(irq, irq->notif_cfg.scratch[1],
+		    irq->notif_cfg.scratch[2], irq->notif_cfg.scratch[3],
+		    irq->notif_cfg.scratch[4], irq->notif_cfg.scratch[5]);
 	}
 }
 
@@ -564,26 +724,8 @@ void ipc_irq_send_msg(irq_t *irq, sysarg_t a1, sysarg_t a2, sysarg_t a3,
 {
 	irq_spinlock_lock(&irq->lock, true);
 
-	if (irq->notif_cfg.answerbox) {
-		call_t *call = ipc_call_alloc();
-		if (!call) {
-			irq_spinlock_unlock(&irq->lock, true);
-			return;
-		}
-
-		call->flags |= IPC_CALL_NOTIF;
-		/* Put a counter to the message */
-		call->priv = ++irq->notif_cfg.counter;
-
-		ipc_set_imethod(&call->data, irq->notif_cfg.imethod);
-		ipc_set_arg1(&call->data, a1);
-		ipc_set_arg2(&call->data, a2);
-		ipc_set_arg3(&call->data, a3);
-		ipc_set_arg4(&call->data, a4);
-		ipc_set_arg5(&call->data, a5);
-
-		send_call(irq, call);
-	}
+	if (irq->notif_cfg.answerbox)
+		send_notif(irq, a1, a2, a3, a4, a5);
 
 	irq_spinlock_unlock(&irq->lock, true);
 }
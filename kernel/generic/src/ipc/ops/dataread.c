@@ -35,6 +35,7 @@
 #include <assert.h>
 #include <ipc/sysipc_ops.h>
 #include <ipc/ipc.h>
+#include <mm/as.h>
 #include <stdlib.h>
 #include <abi/errno.h>
 #include <syscall/copy.h>
@@ -42,17 +43,26 @@
 
 static errno_t request_preprocess(call_t *call, phone_t *phone)
 {
+	uintptr_t dst = ipc_get_arg1(&call->data);
 	size_t size = ipc_get_arg2(&call->data);
 
 	if (size > DATA_XFER_LIMIT) {
 		int flags = ipc_get_arg3(&call->data);
 
-		if (flags & IPC_XF_RESTRICT)
-			ipc_set_arg2(&call->data, DATA_XFER_LIMIT);
-		else
+		if (flags & IPC_XF_RESTRICT) {
+			size = DATA_XFER_LIMIT;
+			ipc_set_arg2(&call->data, size);
+		} else
 			return ELIMIT;
 	}
 
+	/*
+	 * Large payloads can be copied by the sender of the data straight
+	 * to the frames of the destination buffer. If the frames cannot be
+	 * referenced, the data is bounced through a kernel buffer.
+	 */
+	(void) ipc_call_frames_get(call, dst, size, AS_AREA_WRITE);
+
 	return EOK;
 }
 
@@ -74,6 +84,14 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 			 */
 			ipc_set_arg1(&answer->data, dst);
 
+			if (answer->frames) {
+				errno_t rc = ipc_call_frames_copy(answer, src,
+				    size, false);
+				if (rc)
+					ipc_set_retval(&answer->data, rc);
+				return EOK;
+			}
+
 			answer->buffer = malloc(size);
 			if (!answer->buffer) {
 				ipc_set_retval(&answer->data, ENOMEM);
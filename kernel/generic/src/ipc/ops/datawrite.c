@@ -35,6 +35,7 @@
 #include <assert.h>
 #include <ipc/sysipc_ops.h>
 #include <ipc/ipc.h>
+#include <mm/as.h>
 #include <stdlib.h>
 #include <abi/errno.h>
 #include <syscall/copy.h>
@@ -55,10 +56,18 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 			return ELIMIT;
 	}
 
+	/*
+	 * Large payloads stay in the sender's frames and are copied
+	 * straight to the recipient when it accepts them.
+	 */
+	errno_t rc = ipc_call_frames_get(call, src, size, AS_AREA_READ);
+	if (rc != ENOTSUP)
+		return rc;
+
 	call->buffer = (uint8_t *) malloc(size);
 	if (!call->buffer)
 		return ENOMEM;
-	errno_t rc = copy_from_uspace(call->buffer, (void *) src, size);
+	rc = copy_from_uspace(call->buffer, (void *) src, size);
 	if (rc != EOK) {
 		/*
 		 * call->buffer will be cleaned up in ipc_call_free() at the
@@ -72,7 +81,7 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 
 static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 {
-	assert(answer->buffer);
+	assert((answer->buffer) || (answer->frames));
 
 	if (!ipc_get_retval(&answer->data)) {
 		/* The recipient agreed to receive data. */
@@ -81,8 +90,13 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		size_t max_size = (size_t)ipc_get_arg2(olddata);
 
 		if (size <= max_size) {
-			errno_t rc = copy_to_uspace((void *) dst,
-			    answer->buffer, size);
+			errno_t rc;
+			if (answer->frames)
+				rc = ipc_call_frames_copy(answer, dst, size,
+				    true);
+			else
+				rc = copy_to_uspace((void *) dst,
+				    answer->buffer, size);
 			if (rc)
 				ipc_set_retval(&answer->data, rc);
 		} else {
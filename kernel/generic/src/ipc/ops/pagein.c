@@ -68,28 +68,44 @@ static errno_t pagein_answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		return EOK;
 
 	if (!ipc_get_retval(&answer->data)) {
-
-		pte_t pte;
-		uintptr_t frame;
+		/*
+		 * The kernel passes a buffer for the frames of all the
+		 * requested pages in answer->priv. Pages missing in the pager's
+		 * address space are reported as zero frames, except for the
+		 * first page, which must be present.
+		 */
+		uintptr_t *frames = (uintptr_t *) answer->priv;
+		size_t count = ipc_get_arg2(olddata) >> PAGE_WIDTH;
+		uintptr_t page = ipc_get_arg1(&answer->data);
 
 		page_table_lock(AS, true);
-		bool found = page_mapping_find(AS, ipc_get_arg1(&answer->data),
-		    false, &pte);
-		if (found & PTE_PRESENT(&pte)) {
-			frame = PTE_GET_FRAME(&pte);
-			pfn_t pfn = ADDR2PFN(frame);
-			if (find_zone(pfn, 1, 0) != (size_t) -1) {
-				/*
-				 * The frame is in physical memory managed by
-				 * the frame allocator.
-				 */
-				frame_reference_add(ADDR2PFN(frame));
+		for (size_t i = 0; i < count; i++) {
+			pte_t pte;
+			uintptr_t frame = 0;
+
+			bool found = page_mapping_find(AS, page + P2SZ(i),
+			    false, &pte);
+			if (found && PTE_PRESENT(&pte)) {
+				frame = PTE_GET_FRAME(&pte);
+				pfn_t pfn = ADDR2PFN(frame);
+				if (find_zone(pfn, 1, 0) != (size_t) -1) {
+					/*
+					 * The frame is in physical memory
+					 * managed by the frame allocator.
+					 */
+					frame_reference_add(pfn);
+				}
+			} else if (i == 0) {
+				ipc_set_retval(&answer->data, ENOENT);
+				break;
 			}
-			ipc_set_arg1(&answer->data, frame);
-		} else {
-			ipc_set_retval(&answer->data, ENOENT);
+
+			frames[i] = frame;
 		}
 		page_table_unlock(AS, true);
+
+		if (!ipc_get_retval(&answer->data))
+			ipc_set_arg1(&answer->data, frames[0]);
 	}
 
 	return EOK;
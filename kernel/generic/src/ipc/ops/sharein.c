@@ -47,7 +47,11 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		as_t *as = answer->sender->as;
 		irq_spinlock_unlock(&answer->sender->lock, true);
 
+		/* A non-zero arg4 of the request asks for a fixed address. */
 		uintptr_t dst_base = (uintptr_t) -1;
+		if (ipc_get_arg4(olddata) != 0)
+			dst_base = ipc_get_arg4(olddata);
+
 		errno_t rc = as_area_share(AS, ipc_get_arg1(&answer->data),
 		    ipc_get_arg1(olddata), as, ipc_get_arg2(&answer->data),
 		    &dst_base, ipc_get_arg2(olddata));
@@ -52,6 +52,7 @@
 #include <console/console.h>
 #include <macros.h>
 #include <cap/cap.h>
+#include <udebug/udebug.h>
 
 #define STRUCT_TO_USPACE(dst, src)  copy_to_uspace((dst), (src), sizeof(*(src)))
 
@@ -223,6 +224,12 @@ errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 static errno_t request_preprocess(call_t *call, phone_t *phone)
 {
 	call->request_method = ipc_get_imethod(&call->data);
+
+#ifdef CONFIG_UDEBUG
+	if (TASK->udebug.stats_enabled)
+		udebug_stats_ipc(call->request_method);
+#endif
+
 	return SYSIPC_OP(request_preprocess, call, phone);
 }
 
@@ -334,9 +341,12 @@ ipc_req_internal(cap_phone_handle_t handle, ipc_data_t *data, sysarg_t priv)
 	return EOK;
 }
 
-/** Check that the task did not exceed the allowed limit of asynchronous calls
+/** Check that the task did not exceed the window of asynchronous calls
  * made over a phone.
  *
+ * The window adapts to how fast the callee picks up the calls, see
+ * ipc_call().
+ *
  * @param phone Phone to check the limit against.
  *
  * @return 0 if limit not reached or -1 if limit exceeded.
@@ -344,8 +354,10 @@ ipc_req_internal(cap_phone_handle_t handle, ipc_data_t *data, sysarg_t priv)
  */
 static int check_call_limit(phone_t *phone)
 {
-	if (atomic_load(&phone->active_calls) >= IPC_MAX_ASYNC_CALLS)
+	if (atomic_load(&phone->active_calls) >= atomic_load(&phone->window)) {
+		atomic_inc(&phone->stalls);
 		return -1;
+	}
 
 	return 0;
 }
@@ -756,7 +768,7 @@ sys_errno_t sys_ipc_hangup(cap_phone_handle_t handle)
 	return rc;
 }
 
-/** Wait for an incoming IPC call or an answer.
+/** Wait for an incoming IPC call or an answer and pass it to userspace.
  *
  * @param calldata Pointer to buffer where the call/answer data is stored.
  * @param usec     Timeout. See waitq_sleep_timeout() for explanation.
@@ -765,7 +777,7 @@ sys_errno_t sys_ipc_hangup(cap_phone_handle_t handle)
  *
  * @return An error code on error.
  */
-sys_errno_t sys_ipc_wait_for_call(ipc_data_t *calldata, uint32_t usec,
+static errno_t ipc_wait_receive(ipc_data_t *calldata, uint32_t usec,
     unsigned int flags)
 {
 	call_t *call = NULL;
@@ -865,6 +877,62 @@ error:
 	return rc;
 }
 
+/** Wait for an incoming IPC call or an answer.
+ *
+ * @param calldata Pointer to buffer where the call/answer data is stored.
+ * @param usec     Timeout. See waitq_sleep_timeout() for explanation.
+ * @param flags    Select mode of sleep operation. See waitq_sleep_timeout()
+ *                 for explanation.
+ *
+ * @return An error code on error.
+ */
+sys_errno_t sys_ipc_wait_for_call(ipc_data_t *calldata, uint32_t usec,
+    unsigned int flags)
+{
+	return (sys_errno_t) ipc_wait_receive(calldata, usec, flags);
+}
+
+/** Wait for incoming IPC calls or answers and receive all that are pending.
+ *
+ * The first call or answer is waited for as in sys_ipc_wait_for_call().
+ * Afterwards, further calls and answers that are already pending are
+ * received without blocking, until @a count of them have been received.
+ *
+ * @param calldata Pointer to an array of @a count buffers where the
+ *                 call/answer data is stored.
+ * @param count    Number of buffers in @a calldata.
+ * @param usec     Timeout for the first call. See waitq_sleep_timeout()
+ *                 for explanation.
+ * @param flags    Select mode of sleep operation for the first call. See
+ *                 waitq_sleep_timeout() for explanation.
+ * @param received Pointer to where the number of received calls and
+ *                 answers is stored.
+ *
+ * @return An error code on error, in which case nothing was received.
+ */
+sys_errno_t sys_ipc_wait_for_calls(ipc_data_t *calldata, size_t count,
+    uint32_t usec, unsigned int flags, size_t *received)
+{
+	if (count == 0)
+		return EINVAL;
+
+	errno_t rc = ipc_wait_receive(&calldata[0], usec, flags);
+	if (rc != EOK)
+		return rc;
+
+	size_t i = 1;
+	while (i < count) {
+		rc = ipc_wait_receive(&calldata[i], SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING);
+		if (rc != EOK)
+			break;
+
+		i++;
+	}
+
+	return (sys_errno_t) copy_to_uspace(received, &i, sizeof(i));
+}
+
 /** Interrupt one thread from sys_ipc_wait_for_call().
  *
  */
@@ -912,6 +980,40 @@ sys_errno_t sys_ipc_irq_unsubscribe(cap_irq_handle_t handle)
 	return 0;
 }
 
+/** Set the notification flags of an IRQ.
+ *
+ * @param handle  IRQ capability handle.
+ * @param flags   IRQ_NOTIF_* flags.
+ *
+ * @return EPERM
+ * @return Error code returned by ipc_irq_set_flags().
+ *
+ */
+sys_errno_t sys_ipc_irq_set_flags(cap_irq_handle_t handle, unsigned int flags)
+{
+	if (!(perm_get(TASK) & PERM_IRQ_REG))
+		return EPERM;
+
+	return ipc_irq_set_flags(&TASK->answerbox, handle, flags);
+}
+
+/** Deliver an IRQ to a processor and run the calling thread there.
+ *
+ * @param handle  IRQ capability handle.
+ * @param cpu     Processor ID or IRQ_CPU_ANY.
+ *
+ * @return EPERM
+ * @return Error code returned by ipc_irq_set_cpu().
+ *
+ */
+sys_errno_t sys_ipc_irq_set_cpu(cap_irq_handle_t handle, unsigned int cpu)
+{
+	if (!(perm_get(TASK) & PERM_IRQ_REG))
+		return EPERM;
+
+	return ipc_irq_set_cpu(&TASK->answerbox, handle, cpu);
+}
+
 /** Syscall connect to a task by ID
  *
  * @return Error code.
@@ -40,8 +40,14 @@
  */
 
 #include <lib/memfnc.h>
+#include <arch/cpu.h>
 #include <typedefs.h>
 
+/** Word which may alias any other type. */
+typedef unsigned long __attribute__((may_alias)) memfnc_word_t;
+
+#ifndef MEMFNC_ARCH
+
 /** Fill block of memory.
  *
  * Fill cnt bytes at dst address with the value val.
@@ -86,6 +92,8 @@ void *memcpy(void *dst, const void *src, size_t cnt)
 	return dst;
 }
 
+#endif /* MEMFNC_ARCH */
+
 /** Compare two memory areas.
  *
  * @param s1  Pointer to the first area to compare.
@@ -103,6 +111,19 @@ int memcmp(const void *s1, const void *s2, size_t len)
 	uint8_t *u2 = (uint8_t *) s2;
 	size_t i;
 
+	/*
+	 * Skip the equal leading words if both areas are word-aligned,
+	 * the first difference is then located bytewise.
+	 */
+	if ((((uintptr_t) u1 | (uintptr_t) u2) % sizeof(memfnc_word_t)) == 0) {
+		while ((len >= sizeof(memfnc_word_t)) &&
+		    (*(memfnc_word_t *) u1 == *(memfnc_word_t *) u2)) {
+			u1 += sizeof(memfnc_word_t);
+			u2 += sizeof(memfnc_word_t);
+			len -= sizeof(memfnc_word_t);
+		}
+	}
+
 	for (i = 0; i < len; i++) {
 		if (*u1 != *u2)
 			return (int)(*u1) - (int)(*u2);
@@ -40,6 +40,11 @@
  *   Bonwick J., Adams J.: Magazines and Vmem: Extending the Slab Allocator to
  *   Many CPUs and Arbitrary Resources, USENIX 2001
  *
+ * Free segments are kept on power-of-two free lists and a bit mask of the
+ * non-empty lists lets allocations find a suitable list without scanning.
+ * Arenas can also have per-CPU quantum caches, which satisfy allocations
+ * of a few quanta without taking the arena lock.
+ *
  */
 
 #include <assert.h>
@@ -55,6 +60,9 @@
 #include <macros.h>
 #include <synch/spinlock.h>
 #include <stdlib.h>
+#include <config.h>
+#include <cpu.h>
+#include <arch.h>
 
 static slab_cache_t *ra_segment_cache;
 
@@ -118,6 +126,31 @@ static void ra_segment_destroy(ra_segment_t *seg)
 	slab_free(ra_segment_cache, seg);
 }
 
+/** Put a free segment on the free list of its order.
+ *
+ * The segment must already be on the list of segments.
+ */
+static void ra_free_list_add(ra_span_t *span, ra_segment_t *seg)
+{
+	size_t order = fnzb(ra_segment_size_get(seg));
+
+	list_append(&seg->fl_link, &span->free[order]);
+	span->free_mask |= (size_t) 1 << order;
+}
+
+/** Take a free segment off its free list.
+ *
+ * Must be called before the size of the segment changes.
+ */
+static void ra_free_list_remove(ra_span_t *span, ra_segment_t *seg)
+{
+	size_t order = fnzb(ra_segment_size_get(seg));
+
+	list_remove(&seg->fl_link);
+	if (list_empty(&span->free[order]))
+		span->free_mask &= ~((size_t) 1 << order);
+}
+
 static ra_span_t *ra_span_create(uintptr_t base, size_t size)
 {
 	ra_span_t *span;
@@ -129,6 +162,7 @@ static ra_span_t *ra_span_create(uintptr_t base, size_t size)
 		return NULL;
 
 	span->max_order = fnzb(size);
+	span->free_mask = 0;
 	span->base = base;
 	span->size = size;
 
@@ -178,7 +212,7 @@ static ra_span_t *ra_span_create(uintptr_t base, size_t size)
 	list_append(&lastseg->segment_link, &span->segments);
 
 	/* Insert the first segment into the respective free list. */
-	list_append(&seg->fl_link, &span->free[span->max_order]);
+	ra_free_list_add(span, seg);
 
 	return span;
 }
@@ -210,6 +244,8 @@ ra_arena_t *ra_arena_create(void)
 
 	irq_spinlock_initialize(&arena->lock, "arena_lock");
 	list_initialize(&arena->spans);
+	arena->quantum = 1;
+	arena->qcache = NULL;
 
 	return arena;
 }
@@ -226,6 +262,8 @@ void ra_arena_destroy(ra_arena_t *arena)
 		ra_span_destroy(span);
 	}
 
+	if (arena->qcache)
+		free(arena->qcache);
 	free(arena);
 }
 
@@ -256,85 +294,76 @@ ra_span_alloc(ra_span_t *span, size_t size, size_t align, uintptr_t *base)
 	size_t order = ispwr2(needed) ? fnzb(needed) : fnzb(needed) + 1;
 	ra_segment_t *pred = NULL;
 	ra_segment_t *succ = NULL;
+	ra_segment_t *seg;
+	uintptr_t newbase;
+
+	if (order > span->max_order)
+		return false;
 
 	/*
-	 * Find the free list of the smallest order which can satisfy this
-	 * request.
+	 * Find the non-empty free list of the smallest order which can
+	 * satisfy this request. Any segment on it is large enough.
 	 */
-	for (; order <= span->max_order; order++) {
-		ra_segment_t *seg;
-		uintptr_t newbase;
+	size_t mask = span->free_mask & ~(((size_t) 1 << order) - 1);
+	if (mask == 0)
+		return false;
 
-		if (list_empty(&span->free[order]))
-			continue;
+	order = fnzb(mask & (~mask + 1));
 
-		/* Take the first segment from the free list. */
-		seg = list_get_instance(list_first(&span->free[order]),
-		    ra_segment_t, fl_link);
+	/* Take the first segment from the free list. */
+	seg = list_get_instance(list_first(&span->free[order]), ra_segment_t,
+	    fl_link);
 
-		assert(seg->flags & RA_SEGMENT_FREE);
+	assert(seg->flags & RA_SEGMENT_FREE);
 
-		/*
-		 * See if we need to allocate new segments for the chopped-off
-		 * parts of this segment.
-		 */
-		if (!IS_ALIGNED(seg->base, align)) {
-			pred = ra_segment_create(seg->base);
-			if (!pred) {
-				/*
-				 * Fail as we are unable to split the segment.
-				 */
-				break;
-			}
-			pred->flags |= RA_SEGMENT_FREE;
+	/*
+	 * See if we need to allocate new segments for the chopped-off parts
+	 * of this segment.
+	 */
+	if (!IS_ALIGNED(seg->base, align)) {
+		pred = ra_segment_create(seg->base);
+		if (!pred) {
+			/* Fail as we are unable to split the segment. */
+			return false;
 		}
-		newbase = ALIGN_UP(seg->base, align);
-		if (newbase + size != seg->base + ra_segment_size_get(seg)) {
-			assert(newbase + (size - 1) < seg->base +
-			    (ra_segment_size_get(seg) - 1));
-			succ = ra_segment_create(newbase + size);
-			if (!succ) {
-				if (pred)
-					ra_segment_destroy(pred);
-				/*
-				 * Fail as we are unable to split the segment.
-				 */
-				break;
-			}
-			succ->flags |= RA_SEGMENT_FREE;
+		pred->flags |= RA_SEGMENT_FREE;
+	}
+	newbase = ALIGN_UP(seg->base, align);
+	if (newbase + size != seg->base + ra_segment_size_get(seg)) {
+		assert(newbase + (size - 1) < seg->base +
+		    (ra_segment_size_get(seg) - 1));
+		succ = ra_segment_create(newbase + size);
+		if (!succ) {
+			if (pred)
+				ra_segment_destroy(pred);
+			/* Fail as we are unable to split the segment. */
+			return false;
 		}
+		succ->flags |= RA_SEGMENT_FREE;
+	}
 
-		/* Put unneeded parts back. */
-		if (pred) {
-			size_t pred_order;
-
-			list_insert_before(&pred->segment_link,
-			    &seg->segment_link);
-			pred_order = fnzb(ra_segment_size_get(pred));
-			list_append(&pred->fl_link, &span->free[pred_order]);
-		}
-		if (succ) {
-			size_t succ_order;
+	/* Remove the found segment from the free list. */
+	ra_free_list_remove(span, seg);
 
-			list_insert_after(&succ->segment_link,
-			    &seg->segment_link);
-			succ_order = fnzb(ra_segment_size_get(succ));
-			list_append(&succ->fl_link, &span->free[succ_order]);
-		}
+	/* Put unneeded parts back. */
+	if (pred)
+		list_insert_before(&pred->segment_link, &seg->segment_link);
+	if (succ)
+		list_insert_after(&succ->segment_link, &seg->segment_link);
 
-		/* Now remove the found segment from the free list. */
-		list_remove(&seg->fl_link);
-		seg->base = newbase;
-		seg->flags &= ~RA_SEGMENT_FREE;
+	seg->base = newbase;
+	seg->flags &= ~RA_SEGMENT_FREE;
 
-		/* Hash-in the segment into the used hash. */
-		hash_table_insert(&span->used, &seg->uh_link);
+	if (pred)
+		ra_free_list_add(span, pred);
+	if (succ)
+		ra_free_list_add(span, succ);
 
-		*base = newbase;
-		return true;
-	}
+	/* Hash-in the segment into the used hash. */
+	hash_table_insert(&span->used, &seg->uh_link);
 
-	return false;
+	*base = newbase;
+	return true;
 }
 
 static void ra_span_free(ra_span_t *span, size_t base, size_t size)
@@ -344,7 +373,6 @@ static void ra_span_free(ra_span_t *span, size_t base, size_t size)
 	ra_segment_t *seg;
 	ra_segment_t *pred;
 	ra_segment_t *succ;
-	size_t order;
 
 	/*
 	 * Locate the segment in the used hash table.
@@ -381,7 +409,7 @@ static void ra_span_free(ra_span_t *span, size_t base, size_t size)
 			 * lists, rebase the segment and throw the predecessor
 			 * away.
 			 */
-			list_remove(&pred->fl_link);
+			ra_free_list_remove(span, pred);
 			list_remove(&pred->segment_link);
 			seg->base = pred->base;
 			ra_segment_destroy(pred);
@@ -400,53 +428,234 @@ static void ra_span_free(ra_span_t *span, size_t base, size_t size)
 		 * Remove the successor from the free and segment lists
 		 * and throw it away.
 		 */
-		list_remove(&succ->fl_link);
+		ra_free_list_remove(span, succ);
 		list_remove(&succ->segment_link);
 		ra_segment_destroy(succ);
 	}
 
 	/* Put the segment on the appropriate free list. */
 	seg->flags |= RA_SEGMENT_FREE;
-	order = fnzb(ra_segment_size_get(seg));
-	list_append(&seg->fl_link, &span->free[order]);
+	ra_free_list_add(span, seg);
+}
+
+/** Allocate resources from the spans of an arena.
+ *
+ * Assume the arena is locked.
+ */
+static bool ra_arena_alloc_locked(ra_arena_t *arena, size_t size,
+    size_t alignment, uintptr_t *base)
+{
+	list_foreach(arena->spans, span_link, ra_span_t, span) {
+		if (ra_span_alloc(span, size, alignment, base))
+			return true;
+	}
+
+	return false;
+}
+
+/** Return resources to the spans of an arena.
+ *
+ * Assume the arena is locked.
+ */
+static void ra_arena_free_locked(ra_arena_t *arena, uintptr_t base,
+    size_t size)
+{
+	list_foreach(arena->spans, span_link, ra_span_t, span) {
+		if (iswithin(span->base, span->size, base, size)) {
+			ra_span_free(span, base, size);
+			return;
+		}
+	}
+
+	panic("Freeing to wrong arena (base=%" PRIxPTR ", size=%zd).",
+	    base, size);
+}
+
+/** Get the quantum cache class of an allocation.
+ *
+ * @return Class of the allocation or RA_QCACHE_CLASSES if the allocation
+ *         is not served by the quantum caches.
+ */
+static size_t ra_qcache_class(ra_arena_t *arena, size_t size,
+    size_t alignment)
+{
+	if ((!arena->qcache) || (!CPU) || (alignment > arena->quantum) ||
+	    (size % arena->quantum != 0) ||
+	    (size / arena->quantum > RA_QCACHE_CLASSES))
+		return RA_QCACHE_CLASSES;
+
+	return size / arena->quantum - 1;
+}
+
+/** Return allocations from a quantum cache class to the arena.
+ *
+ * Assume interrupts are disabled and the cache is locked.
+ *
+ * @param arena Arena
+ * @param qc    Quantum cache of the arena
+ * @param cls   Class to drain
+ * @param keep  Number of allocations to keep in the class
+ */
+static void ra_qcache_drain(ra_arena_t *arena, ra_qcache_t *qc, size_t cls,
+    size_t keep)
+{
+	irq_spinlock_lock(&arena->lock, false);
+
+	while (qc->count[cls] > keep) {
+		ra_arena_free_locked(arena, qc->base[cls][--qc->count[cls]],
+		    (cls + 1) * arena->quantum);
+	}
+
+	irq_spinlock_unlock(&arena->lock, false);
+}
+
+/** Return all allocations from the quantum caches to the arena.
+ *
+ * Used when the arena runs out of resources, part of which may be held
+ * by the caches of other processors.
+ */
+static void ra_qcache_drain_all(ra_arena_t *arena)
+{
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		ra_qcache_t *qc = &arena->qcache[i];
+
+		irq_spinlock_lock(&qc->lock, true);
+		for (size_t cls = 0; cls < RA_QCACHE_CLASSES; cls++)
+			ra_qcache_drain(arena, qc, cls, 0);
+		irq_spinlock_unlock(&qc->lock, true);
+	}
+}
+
+/** Allocate resources from the quantum cache of the current processor.
+ *
+ * An empty cache class is refilled from the arena in a batch.
+ */
+static bool ra_qcache_alloc(ra_arena_t *arena, size_t cls, uintptr_t *base)
+{
+	size_t size = (cls + 1) * arena->quantum;
+	bool success = false;
+
+	ipl_t ipl = interrupts_disable();
+	ra_qcache_t *qc = &arena->qcache[CPU->id];
+	irq_spinlock_lock(&qc->lock, false);
+
+	if (qc->count[cls] == 0) {
+		irq_spinlock_lock(&arena->lock, false);
+		while ((qc->count[cls] < RA_QCACHE_BATCH) &&
+		    (ra_arena_alloc_locked(arena, size, arena->quantum,
+		    &qc->base[cls][qc->count[cls]])))
+			qc->count[cls]++;
+		irq_spinlock_unlock(&arena->lock, false);
+	}
+
+	if (qc->count[cls] > 0) {
+		*base = qc->base[cls][--qc->count[cls]];
+		success = true;
+	}
+
+	irq_spinlock_unlock(&qc->lock, false);
+	interrupts_restore(ipl);
+
+	return success;
+}
+
+/** Free resources to the quantum cache of the current processor.
+ *
+ * A full cache class is partially drained to the arena first.
+ */
+static void ra_qcache_free(ra_arena_t *arena, size_t cls, uintptr_t base)
+{
+	ipl_t ipl = interrupts_disable();
+	ra_qcache_t *qc = &arena->qcache[CPU->id];
+	irq_spinlock_lock(&qc->lock, false);
+
+	if (qc->count[cls] == RA_QCACHE_SIZE) {
+		ra_qcache_drain(arena, qc, cls,
+		    RA_QCACHE_SIZE - RA_QCACHE_BATCH);
+	}
+
+	qc->base[cls][qc->count[cls]++] = base;
+
+	irq_spinlock_unlock(&qc->lock, false);
+	interrupts_restore(ipl);
+}
+
+/** Enable per-CPU quantum caches of an arena.
+ *
+ * Allocations of up to RA_QCACHE_CLASSES quanta which need an alignment of
+ * at most one quantum are then mostly served by a cache of the current
+ * processor. Must be called after the number of processors is known.
+ *
+ * @param arena   Arena
+ * @param quantum Unit of the cached allocations, a power of two
+ * @return True on success, false if out of memory
+ */
+bool ra_arena_qcache_enable(ra_arena_t *arena, size_t quantum)
+{
+	ra_qcache_t *qcache;
+
+	assert(ispwr2(quantum));
+	assert(!arena->qcache);
+
+	qcache = malloc(sizeof(ra_qcache_t) * config.cpu_count);
+	if (!qcache)
+		return false;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_initialize(&qcache[i].lock, "ra_qcache_lock");
+		for (size_t cls = 0; cls < RA_QCACHE_CLASSES; cls++)
+			qcache[i].count[cls] = 0;
+	}
+
+	arena->quantum = quantum;
+	arena->qcache = qcache;
+	return true;
 }
 
 /** Allocate resources from arena. */
 bool
 ra_alloc(ra_arena_t *arena, size_t size, size_t alignment, uintptr_t *base)
 {
-	bool success = false;
+	bool success;
 
 	assert(size >= 1);
 	assert(alignment >= 1);
 	assert(ispwr2(alignment));
 
+	size_t cls = ra_qcache_class(arena, size, alignment);
+	if ((cls < RA_QCACHE_CLASSES) && (ra_qcache_alloc(arena, cls, base)))
+		return true;
+
 	irq_spinlock_lock(&arena->lock, true);
-	list_foreach(arena->spans, span_link, ra_span_t, span) {
-		success = ra_span_alloc(span, size, alignment, base);
-		if (success)
-			break;
-	}
+	success = ra_arena_alloc_locked(arena, size, alignment, base);
 	irq_spinlock_unlock(&arena->lock, true);
 
+	if ((!success) && (arena->qcache)) {
+		/* Retry with the resources held by the caches. */
+		ra_qcache_drain_all(arena);
+
+		irq_spinlock_lock(&arena->lock, true);
+		success = ra_arena_alloc_locked(arena, size, alignment, base);
+		irq_spinlock_unlock(&arena->lock, true);
+	}
+
 	return success;
 }
 
 /* Return resources to arena. */
 void ra_free(ra_arena_t *arena, uintptr_t base, size_t size)
 {
-	irq_spinlock_lock(&arena->lock, true);
-	list_foreach(arena->spans, span_link, ra_span_t, span) {
-		if (iswithin(span->base, span->size, base, size)) {
-			ra_span_free(span, base, size);
-			irq_spinlock_unlock(&arena->lock, true);
-			return;
-		}
+	size_t cls = ra_qcache_class(arena, size, 1);
+
+	/* Only allocations aligned to a quantum can be handed out again. */
+	if ((cls < RA_QCACHE_CLASSES) && (IS_ALIGNED(base, arena->quantum))) {
+		ra_qcache_free(arena, cls, base);
+		return;
 	}
-	irq_spinlock_unlock(&arena->lock, true);
 
-	panic("Freeing to wrong arena (base=%" PRIxPTR ", size=%zd).",
-	    base, size);
+	irq_spinlock_lock(&arena->lock, true);
+	ra_arena_free_locked(arena, base, size);
+	irq_spinlock_unlock(&arena->lock, true);
 }
 
 void ra_init(void)
@@ -33,6 +33,8 @@
  */
 
 #include <sysinfo/sysinfo.h>
+#include <barrier.h>
+#include <mm/frame.h>
 #include <synch/spinlock.h>
 #include <typedefs.h>
 #include <ddi/irq.h>
@@ -58,8 +60,24 @@
 #define LOG_LENGTH   (LOG_PAGES * PAGE_SIZE)
 #define LOG_ENTRY_HEADER_LENGTH (sizeof(size_t) + sizeof(uint32_t))
 
-/** Cyclic buffer holding the data for kernel log */
-uint8_t log_buffer[LOG_LENGTH] __attribute__((aligned(PAGE_SIZE)));
+/** Kernel log shared with user space: header page and cyclic buffer */
+static struct {
+	union {
+		klog_ring_t ring;
+		uint8_t page[PAGE_SIZE];
+	} header;
+	/** Cyclic buffer holding the data for kernel log */
+	uint8_t buffer[LOG_LENGTH];
+} log_area __attribute__((aligned(PAGE_SIZE)));
+
+#define log_ring    (log_area.header.ring)
+#define log_buffer  (log_area.buffer)
+
+/** Physical memory area of the kernel log */
+static parea_t log_parea;
+
+/** Ring head at the time of the last successful EVENT_KLOG notification */
+static uint64_t log_notified = 0;
 
 /** Kernel log initialized */
 static atomic_bool log_inited = false;
@@ -92,6 +110,22 @@ static void log_update(void *);
  */
 void log_init(void)
 {
+	void *faddr = (void *) KA2PA(&log_area);
+
+	assert((uintptr_t) faddr % FRAME_SIZE == 0);
+
+	log_ring.size = LOG_LENGTH;
+
+	ddi_parea_init(&log_parea);
+	log_parea.pbase = (uintptr_t) faddr;
+	log_parea.frames = SIZE2FRAMES(sizeof(log_area));
+	log_parea.unpriv = false;
+	log_parea.mapped = false;
+	ddi_parea_register(&log_parea);
+
+	sysinfo_set_item_val("klog.faddr", NULL, (sysarg_t) faddr);
+	sysinfo_set_item_val("klog.pages", NULL, SIZE2FRAMES(sizeof(log_area)));
+
 	event_set_unmask_callback(EVENT_KLOG, log_update);
 	atomic_store(&log_inited, true);
 }
@@ -136,6 +170,10 @@ static void log_append(const uint8_t *data, size_t len)
 		log_used -= entry_len;
 		log_free += entry_len;
 		next_for_uspace -= entry_len;
+		log_ring.tail += entry_len;
+
+		/* Readers must see the new tail before the data change */
+		write_barrier();
 	}
 
 	size_t pos = (log_current_start + log_current_len) % LOG_LENGTH;
@@ -177,6 +215,10 @@ void log_end(void)
 	log_copy_to((uint8_t *) &log_current_len, log_current_start, sizeof(size_t));
 	log_used += log_current_len;
 
+	/* Publish the entry to readers of the shared ring */
+	write_barrier();
+	log_ring.head += log_current_len;
+
 	kio_push_char('\n');
 	spinlock_unlock(&kio_lock);
 	spinlock_unlock(&log_lock);
@@ -193,8 +235,10 @@ static void log_update(void *event)
 		return;
 
 	spinlock_lock(&log_lock);
-	if (next_for_uspace < log_used)
-		event_notify_0(EVENT_KLOG, true);
+	if (log_notified != log_ring.head) {
+		if (event_notify_0(EVENT_KLOG, true) == EOK)
+			log_notified = log_ring.head;
+	}
 	spinlock_unlock(&log_lock);
 }
 
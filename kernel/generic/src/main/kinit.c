@@ -89,6 +89,52 @@ static char alive[ALIVE_CHARS] = "-\\|/";
 #define INIT_PREFIX      "init:"
 #define INIT_PREFIX_LEN  5
 
+/** Init task image being loaded by a kinitld thread. */
+typedef struct {
+	/** Index of the image in the init structure. */
+	size_t index;
+	/** Name of the task. */
+	char namebuf[TASK_NAME_BUFLEN];
+	/** True if the image is the program loader. */
+	bool loader;
+	/** Kernel virtual address of the image. */
+	uintptr_t page;
+	/** Result of the program creation. */
+	errno_t rc;
+	/** Created program. */
+	program_t *prg;
+	/** Thread loading the image or NULL if loaded directly by kinit. */
+	thread_t *thread;
+} kinit_load_t;
+
+/** Map an init task image and create its program.
+ *
+ * The program loader image is only mapped. The program is not made
+ * ready, kinit does that once all images are loaded.
+ *
+ * @param arg Init task image load structure.
+ */
+static void kinit_load(void *arg)
+{
+	kinit_load_t *load = (kinit_load_t *) arg;
+	size_t i = load->index;
+
+	/*
+	 * Create virtual memory mappings for init task images.
+	 */
+	load->page = km_map(init.tasks[i].paddr, init.tasks[i].size,
+	    PAGE_SIZE, PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+	assert(load->page);
+
+	if (load->loader) {
+		load->rc = EOK;
+		return;
+	}
+
+	load->rc = program_create_from_image((void *) load->page,
+	    load->namebuf, load->prg);
+}
+
 /** Kernel initialization thread.
  *
  * kinit takes care of higher level kernel
@@ -210,11 +256,26 @@ void kinit(void *arg)
 		sysinfo_set_item_data(item_name, NULL, arguments_copy, arguments_size);
 	}
 
+	kinit_load_t *loads = malloc(sizeof(kinit_load_t) * init.cnt);
+	if ((init.cnt > 0) && (!loads))
+		panic("Unable to allocate init task loads.");
+
+	/*
+	 * The init task images are independent of each other, load them
+	 * in parallel on all processors.
+	 */
 	for (i = 0; i < init.cnt; i++) {
+		kinit_load_t *load = &loads[i];
+
+		load->index = i;
+		load->prg = &programs[i];
+		load->thread = NULL;
+		programs[i].task = NULL;
+
 		if (init.tasks[i].paddr % FRAME_SIZE) {
 			log(LF_OTHER, LVL_ERROR,
 			    "init[%zu]: Address is not frame aligned", i);
-			programs[i].task = NULL;
+			load->rc = EINVAL;
 			continue;
 		}
 
@@ -223,29 +284,48 @@ void kinit(void *arg)
 		 * name stored in the init structure (if any).
 		 */
 
-		char namebuf[TASK_NAME_BUFLEN];
-
 		const char *name = init.tasks[i].name;
 		if (name[0] == 0)
 			name = "<unknown>";
 
 		static_assert(TASK_NAME_BUFLEN >= INIT_PREFIX_LEN, "");
-		str_cpy(namebuf, TASK_NAME_BUFLEN, INIT_PREFIX);
-		str_cpy(namebuf + INIT_PREFIX_LEN,
+		str_cpy(load->namebuf, TASK_NAME_BUFLEN, INIT_PREFIX);
+		str_cpy(load->namebuf + INIT_PREFIX_LEN,
 		    TASK_NAME_BUFLEN - INIT_PREFIX_LEN, name);
 
-		/*
-		 * Create virtual memory mappings for init task images.
-		 */
-		uintptr_t page = km_map(init.tasks[i].paddr,
-		    init.tasks[i].size, PAGE_SIZE,
-		    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
-		assert(page);
+		load->loader = (str_cmp(name, "loader") == 0);
+
+		load->thread = thread_create(kinit_load, load, TASK,
+		    THREAD_FLAG_NONE, "kinitld");
+		if (load->thread != NULL) {
+#ifdef CONFIG_SMP
+			thread_wire(load->thread,
+			    &cpus[i % config.cpu_count]);
+#endif
+			thread_ready(load->thread);
+		} else {
+			kinit_load(load);
+		}
+	}
 
-		if (str_cmp(name, "loader") == 0) {
+	/*
+	 * Finish the loaded tasks in the order of their images.
+	 */
+	for (i = 0; i < init.cnt; i++) {
+		kinit_load_t *load = &loads[i];
+
+		if (load->thread != NULL) {
+			thread_join(load->thread);
+			thread_detach(load->thread);
+		}
+
+		if (init.tasks[i].paddr % FRAME_SIZE)
+			continue;
+
+		if (load->loader) {
 			/* Register image as the program loader */
 			if (program_loader == NULL) {
-				program_loader = (void *) page;
+				program_loader = (void *) load->page;
 				log(LF_OTHER, LVL_NOTE, "Program loader at %p",
 				    program_loader);
 			} else {
@@ -254,12 +334,10 @@ void kinit(void *arg)
 				    " present.", i);
 			}
 
-			programs[i].task = NULL;
 			continue;
 		}
 
-		errno_t rc = program_create_from_image((void *) page, namebuf,
-		    &programs[i]);
+		errno_t rc = load->rc;
 
 		if (rc == 0) {
 			assert(programs[i].task != NULL);
@@ -295,6 +373,8 @@ void kinit(void *arg)
 		}
 	}
 
+	free(loads);
+
 	/*
 	 * Run user tasks.
 	 */
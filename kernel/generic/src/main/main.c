@@ -90,6 +90,8 @@
 #include <sysinfo/stats.h>
 #include <lib/ra.h>
 #include <cap/cap.h>
+#include <tracepoint.h>
+#include <profile.h>
 
 /*
  * Ensure [u]int*_t types are of correct size.
@@ -259,6 +261,9 @@ void main_bsp_separated_stack(void)
 
 	/* Slab must be initialized after we know the number of processors. */
 	slab_enable_cpucache();
+	frame_enable_cpucache();
+	km_enable_cpucache();
+	reserve_enable_cpucache();
 
 	uint64_t size;
 	const char *size_suffix;
@@ -293,6 +298,8 @@ void main_bsp_separated_stack(void)
 	kio_init();
 	log_init();
 	stats_init();
+	tracepoint_init();
+	profile_init();
 
 	/*
 	 * Create kernel task.
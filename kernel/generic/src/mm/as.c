@@ -80,6 +80,7 @@
 #include <arch/interrupt.h>
 #include <interrupt.h>
 #include <stdlib.h>
+#include <tracepoint.h>
 
 /**
  * Each architecture decides what functions will be used to carry out
@@ -118,7 +119,7 @@ as_t *AS_KERNEL = NULL;
 static void *as_areas_getkey(odlink_t *);
 static int as_areas_cmp(void *, void *);
 
-static void used_space_initialize(used_space_t *);
+static void used_space_initialize(used_space_t *, as_t *);
 static void used_space_finalize(used_space_t *);
 static void *used_space_getkey(odlink_t *);
 static int used_space_cmp(void *, void *);
@@ -132,6 +133,7 @@ _NO_TRACE static errno_t as_constructor(void *obj, unsigned int flags)
 
 	link_initialize(&as->inactive_as_with_asid_link);
 	mutex_initialize(&as->lock, MUTEX_PASSIVE);
+	mutex_initialize(&as->pt_lock, MUTEX_PASSIVE);
 
 	return as_constructor_arch(as, flags);
 }
@@ -183,6 +185,10 @@ as_t *as_create(unsigned int flags)
 
 	refcount_init(&as->refcount);
 	as->cpu_refcount = 0;
+	as->faults = 0;
+	atomic_store(&as->virt_pages, 0);
+	atomic_store(&as->resident_pages, 0);
+	atomic_store(&as->tlb_cpus, 0);
 
 #ifdef AS_PAGE_TABLE
 	as->genarch.page_table = page_table_create(flags);
@@ -791,6 +797,10 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 	area->flags = flags;
 	area->attributes = attrs;
 	area->pages = pages;
+	area->large_pages = 0;
+	area->faults = 0;
+	area->readahead_next = 0;
+	area->readahead_pages = 0;
 	area->base = *base;
 	area->backend = backend;
 	area->sh_info = NULL;
@@ -843,8 +853,9 @@ as_area_t *as_area_create(as_t *as, unsigned int flags, size_t size,
 		}
 	}
 
-	used_space_initialize(&area->used_space);
+	used_space_initialize(&area->used_space, as);
 	odict_insert(&area->las_areas, &as->as_areas, NULL);
+	atomic_fetch_add(&as->virt_pages, area->pages);
 
 	mutex_unlock(&as->lock);
 
@@ -954,9 +965,8 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 		 * Start TLB shootdown sequence.
 		 */
 
-		ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES,
-		    as->asid, area->base + P2SZ(pages),
-		    area->pages - pages);
+		tlb_batch_t batch;
+		tlb_batch_start(&batch, as);
 
 		/*
 		 * Remove frames belonging to used space starting from
@@ -1004,6 +1014,8 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 				used_space_remove_ival(ival);
 			}
 
+			tlb_batch_add(&batch, ptr + P2SZ(i), pcount - i);
+
 			for (; i < pcount; i++) {
 				pte_t pte;
 				bool found = page_mapping_find(as,
@@ -1023,25 +1035,12 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 
 				page_mapping_remove(as, ptr + P2SZ(i));
 			}
-
 		}
 
 		/*
 		 * Finish TLB shootdown sequence.
 		 */
-
-		tlb_invalidate_pages(as->asid,
-		    area->base + P2SZ(pages),
-		    area->pages - pages);
-
-		/*
-		 * Invalidate software translation caches
-		 * (e.g. TSB on sparc64, PHT on ppc32).
-		 */
-		as_invalidate_translation_cache(as,
-		    area->base + P2SZ(pages),
-		    area->pages - pages);
-		tlb_shootdown_finalize(ipl);
+		tlb_batch_finalize(&batch);
 
 		page_table_unlock(as, false);
 	} else {
@@ -1071,6 +1070,11 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 		}
 	}
 
+	if (pages > area->pages)
+		atomic_fetch_add(&as->virt_pages, pages - area->pages);
+	else
+		atomic_fetch_sub(&as->virt_pages, area->pages - pages);
+
 	area->pages = pages;
 
 	mutex_unlock(&area->lock);
@@ -1104,8 +1108,8 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
-	    area->pages);
+	tlb_batch_t batch;
+	tlb_batch_start(&batch, as);
 
 	/*
 	 * Visit only the pages mapped by used_space.
@@ -1114,6 +1118,8 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	while (ival != NULL) {
 		uintptr_t ptr = ival->page;
 
+		tlb_batch_add(&batch, ptr, ival->count);
+
 		for (size_t size = 0; size < ival->count; size++) {
 			pte_t pte;
 			bool found = page_mapping_find(as,
@@ -1141,15 +1147,7 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	/*
 	 * Finish TLB shootdown sequence.
 	 */
-
-	tlb_invalidate_pages(as->asid, area->base, area->pages);
-
-	/*
-	 * Invalidate potential software translation caches
-	 * (e.g. TSB on sparc64, PHT on ppc32).
-	 */
-	as_invalidate_translation_cache(as, area->base, area->pages);
-	tlb_shootdown_finalize(ipl);
+	tlb_batch_finalize(&batch);
 
 	page_table_unlock(as, false);
 
@@ -1163,6 +1161,7 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	 * Remove the empty area from address space.
 	 */
 	odict_remove(&area->las_areas);
+	atomic_fetch_sub(&as->virt_pages, area->pages);
 
 	free(area);
 
@@ -1404,8 +1403,8 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
-	    area->pages);
+	tlb_batch_t batch;
+	tlb_batch_start(&batch, as);
 
 	/*
 	 * Remove used pages from page tables and remember their frame
@@ -1418,6 +1417,8 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 		uintptr_t ptr = ival->page;
 		size_t size;
 
+		tlb_batch_add(&batch, ptr, ival->count);
+
 		for (size = 0; size < ival->count; size++) {
 			pte_t pte;
 			bool found = page_mapping_find(as, ptr + P2SZ(size),
@@ -1440,15 +1441,7 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	/*
 	 * Finish TLB shootdown sequence.
 	 */
-
-	tlb_invalidate_pages(as->asid, area->base, area->pages);
-
-	/*
-	 * Invalidate potential software translation caches
-	 * (e.g. TSB on sparc64, PHT on ppc32).
-	 */
-	as_invalidate_translation_cache(as, area->base, area->pages);
-	tlb_shootdown_finalize(ipl);
+	tlb_batch_finalize(&batch);
 
 	page_table_unlock(as, false);
 
@@ -1514,20 +1507,28 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 	uintptr_t page = ALIGN_DOWN(address, PAGE_SIZE);
 	int rc = AS_PF_FAULT;
 
+	TRACEPOINT(TRACE_PAGE_FAULT, address, access, 0);
+
 	if (!THREAD)
 		goto page_fault;
 
 	if (!AS)
 		goto page_fault;
 
+	/*
+	 * The address space lock is only needed to find the area. The
+	 * locked area cannot be destroyed, resized or remapped, so faults in
+	 * different areas can run in parallel, serializing only on the page
+	 * table lock.
+	 */
 	mutex_lock(&AS->lock);
 	as_area_t *area = find_area_and_lock(AS, page);
+	mutex_unlock(&AS->lock);
 	if (!area) {
 		/*
 		 * No area contained mapping for 'page'.
 		 * Signal page fault to low-level handler.
 		 */
-		mutex_unlock(&AS->lock);
 		goto page_fault;
 	}
 
@@ -1537,7 +1538,6 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 		 * Avoid possible race by returning error.
 		 */
 		mutex_unlock(&area->lock);
-		mutex_unlock(&AS->lock);
 		goto page_fault;
 	}
 
@@ -1547,7 +1547,6 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 		 * or the backend cannot handle page faults.
 		 */
 		mutex_unlock(&area->lock);
-		mutex_unlock(&AS->lock);
 		goto page_fault;
 	}
 
@@ -1565,7 +1564,6 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 		    (access == PF_ACCESS_EXEC && PTE_EXECUTABLE(&pte))) {
 			page_table_unlock(AS, false);
 			mutex_unlock(&area->lock);
-			mutex_unlock(&AS->lock);
 			return AS_PF_OK;
 		}
 	}
@@ -1577,13 +1575,14 @@ int as_page_fault(uintptr_t address, pf_access_t access, istate_t *istate)
 	if (rc != AS_PF_OK) {
 		page_table_unlock(AS, false);
 		mutex_unlock(&area->lock);
-		mutex_unlock(&AS->lock);
 		goto page_fault;
 	}
 
+	area->faults++;
+	AS->faults++;
+
 	page_table_unlock(AS, false);
 	mutex_unlock(&area->lock);
-	mutex_unlock(&AS->lock);
 	return AS_PF_OK;
 
 page_fault:
@@ -1675,6 +1674,12 @@ retry:
 			new_as->asid = asid_get();
 	}
 
+	/*
+	 * Let TLB shootdowns of the new address space know that they
+	 * need to involve this processor.
+	 */
+	tlb_as_activate(new_as);
+
 #ifdef AS_PAGE_TABLE
 	SET_PTL0_ADDRESS(new_as->genarch.page_table);
 #endif
@@ -1685,6 +1690,9 @@ retry:
 	 */
 	as_install_arch(new_as);
 
+	if ((old_as) && (old_as != new_as))
+		tlb_as_deactivate(old_as);
+
 	spinlock_unlock(&asidlock);
 
 	AS = new_as;
@@ -1830,7 +1838,7 @@ size_t as_area_get_size(uintptr_t base)
 {
 	size_t size;
 
-	page_table_lock(AS, true);
+	mutex_lock(&AS->lock);
 	as_area_t *src_area = find_area_and_lock(AS, base);
 
 	if (src_area) {
@@ -1839,18 +1847,138 @@ size_t as_area_get_size(uintptr_t base)
 	} else
 		size = 0;
 
-	page_table_unlock(AS, true);
+	mutex_unlock(&AS->lock);
 	return size;
 }
 
+/** Take references to the frames backing a piece of an address space.
+ *
+ * The range must lie within a single anonymous address space area that
+ * permits @a access and all of its pages must be resident and
+ * identity-mapped in the kernel.
+ * Each frame stored to @a frames has its reference count incremented,
+ * so it stays allocated even if the area is destroyed in the meantime.
+ * The references are to be dropped using frame_free().
+ *
+ * @param as     Address space.
+ * @param va     Start of the range.
+ * @param size   Size of the range in bytes.
+ * @param access Address space area flags the area must have.
+ * @param frames Array to store the physical addresses of the frames. It
+ *               must be large enough to hold the frames of all pages
+ *               touched by the range.
+ *
+ * @return EOK on success.
+ * @return ENOENT if the range is not a resident part of an anonymous
+ *         area permitting @a access.
+ *
+ */
+errno_t as_area_frames_get(as_t *as, uintptr_t va, size_t size,
+    unsigned int access, uintptr_t *frames)
+{
+	uintptr_t page = ALIGN_DOWN(va, PAGE_SIZE);
+	size_t count = SIZE2FRAMES(va - page + size);
+
+	if ((size == 0) || (va + size < va))
+		return ENOENT;
+
+	mutex_lock(&as->lock);
+	as_area_t *area = find_area_and_lock(as, va);
+	mutex_unlock(&as->lock);
+	if (!area)
+		return ENOENT;
+
+	if ((area->backend != &anon_backend) ||
+	    ((area->flags & access) != access) ||
+	    (va + size > area->base + P2SZ(area->pages))) {
+		mutex_unlock(&area->lock);
+		return ENOENT;
+	}
+
+	page_table_lock(as, false);
+
+	size_t i;
+	for (i = 0; i < count; i++) {
+		pte_t pte;
+		bool found = page_mapping_find(as, page + P2SZ(i), false, &pte);
+		if ((!found) || (!PTE_VALID(&pte)) || (!PTE_PRESENT(&pte)))
+			break;
+
+		uintptr_t frame = PTE_GET_FRAME(&pte);
+		if (frame >= config.identity_size)
+			break;
+
+		frame_reference_add(ADDR2PFN(frame));
+		frames[i] = frame;
+	}
+
+	page_table_unlock(as, false);
+	mutex_unlock(&area->lock);
+
+	if (i < count) {
+		while (i > 0)
+			frame_free(frames[--i], 1);
+
+		return ENOENT;
+	}
+
+	return EOK;
+}
+
+#ifdef LARGE_PAGE_WIDTH
+
+/** Check whether a faulting page can be backed by a large page.
+ *
+ * A large page can be used if the area asked for large pages, the
+ * architecture supports them, the naturally aligned large page containing
+ * the faulting page lies entirely within the area and none of its base
+ * pages is mapped yet.
+ *
+ * The caller must hold the area lock.
+ *
+ * @param area  Address space area.
+ * @param upage Faulting page.
+ * @param lpage Place to store the address of the large page.
+ *
+ * @return True if the large page @a lpage can be mapped.
+ *
+ */
+bool as_area_large_page(as_area_t *area, uintptr_t upage, uintptr_t *lpage)
+{
+	assert(mutex_locked(&area->lock));
+
+	if (!(area->flags & AS_AREA_LARGE_PAGES))
+		return false;
+
+	if (!page_mapping_large_supported())
+		return false;
+
+	uintptr_t base = ALIGN_DOWN(upage, LARGE_PAGE_SIZE);
+	if ((base < area->base) ||
+	    (base + LARGE_PAGE_SIZE > area->base + P2SZ(area->pages)) ||
+	    (base + LARGE_PAGE_SIZE < base))
+		return false;
+
+	used_space_ival_t *ival = used_space_find_gteq(&area->used_space, base);
+	if ((ival != NULL) && (ival->page < base + LARGE_PAGE_SIZE))
+		return false;
+
+	*lpage = base;
+	return true;
+}
+
+#endif /* LARGE_PAGE_WIDTH */
+
 /** Initialize used space map.
  *
  * @param used_space Used space map
+ * @param as Address space containing the map
  */
-static void used_space_initialize(used_space_t *used_space)
+static void used_space_initialize(used_space_t *used_space, as_t *as)
 {
 	odict_initialize(&used_space->ivals, used_space_getkey, used_space_cmp);
 	used_space->pages = 0;
+	used_space->as = as;
 }
 
 /** Finalize used space map.
@@ -1995,6 +2123,7 @@ static int used_space_cmp(void *a, void *b)
 static void used_space_remove_ival(used_space_ival_t *ival)
 {
 	ival->used_space->pages -= ival->count;
+	atomic_fetch_sub(&ival->used_space->as->resident_pages, ival->count);
 	odict_remove(&ival->lused_space);
 	slab_free(used_space_ival_cache, ival);
 }
@@ -2010,6 +2139,8 @@ static void used_space_shorten_ival(used_space_ival_t *ival, size_t count)
 	assert(count < ival->count);
 
 	ival->used_space->pages -= ival->count - count;
+	atomic_fetch_sub(&ival->used_space->as->resident_pages,
+	    ival->count - count);
 	ival->count = count;
 }
 
@@ -2060,8 +2191,9 @@ bool used_space_insert(used_space_t *used_space, uintptr_t page, size_t count)
 	adj_b = (b != NULL) && page + P2SZ(count) == b->page;
 
 	if (adj_a && adj_b) {
-		/* Fuse into a single interval */
+		/* Fuse into a single interval, pages of B stay accounted */
 		a->count += count + b->count;
+		b->count = 0;
 		used_space_remove_ival(b);
 	} else if (adj_a) {
 		/* Append to A */
@@ -2083,6 +2215,7 @@ bool used_space_insert(used_space_t *used_space, uintptr_t page, size_t count)
 	}
 
 	used_space->pages += count;
+	atomic_fetch_add(&used_space->as->resident_pages, count);
 	return true;
 }
 
@@ -2138,6 +2271,8 @@ sys_errno_t sys_as_area_get_info(uintptr_t address, as_area_info_t *dest)
 	dest->start_addr = area->base;
 	dest->size = P2SZ(area->pages);
 	dest->flags = area->flags;
+	dest->large_pages = area->large_pages;
+	dest->faults = area->faults;
 
 	mutex_unlock(&area->lock);
 	mutex_unlock(&AS->lock);
@@ -2182,6 +2317,8 @@ as_area_info_t *as_get_area_info(as_t *as, size_t *osize)
 		info[area_idx].start_addr = area->base;
 		info[area_idx].size = P2SZ(area->pages);
 		info[area_idx].flags = area->flags;
+		info[area_idx].large_pages = area->large_pages;
+		info[area_idx].faults = area->faults;
 		++area_idx;
 
 		mutex_unlock(&area->lock);
@@ -2207,9 +2344,9 @@ void as_print(as_t *as)
 	as_area_t *area = as_area_first(as);
 	while (area != NULL) {
 		mutex_lock(&area->lock);
-		printf("as_area: %p, base=%p, pages=%zu"
+		printf("as_area: %p, base=%p, pages=%zu, large=%zu"
 		    " (%p - %p)\n", area, (void *) area->base,
-		    area->pages, (void *) area->base,
+		    area->pages, area->large_pages, (void *) area->base,
 		    (void *) (area->base + P2SZ(area->pages)));
 		mutex_unlock(&area->lock);
 
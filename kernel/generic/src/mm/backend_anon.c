@@ -64,6 +64,10 @@ static bool anon_is_shareable(as_area_t *);
 static int anon_page_fault(as_area_t *, uintptr_t, pf_access_t);
 static void anon_frame_free(as_area_t *, uintptr_t, uintptr_t);
 
+#ifdef LARGE_PAGE_WIDTH
+static bool anon_large_page_fault(as_area_t *, uintptr_t);
+#endif
+
 mem_backend_t anon_backend = {
 	.create = anon_create,
 	.resize = anon_resize,
@@ -170,7 +174,59 @@ bool anon_is_shareable(as_area_t *area)
 	return !(area->flags & AS_AREA_LATE_RESERVE);
 }
 
+#ifdef LARGE_PAGE_WIDTH
+
+/** Try to service a page fault with a large page.
+ *
+ * The naturally aligned large page containing the faulting page is backed
+ * by physically contiguous zeroed frames. The frames are released one by
+ * one as the large page mapping gets split on partial unmap.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area  Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ *
+ * @return True if the large page was mapped, false if the fault is to be
+ *         serviced by a base page.
+ */
+bool anon_large_page_fault(as_area_t *area, uintptr_t upage)
+{
+	uintptr_t lpage;
+
+	if (!as_area_large_page(area, upage, &lpage))
+		return false;
+
+	if (area->flags & AS_AREA_LATE_RESERVE) {
+		if (!reserve_try_alloc(LARGE_PAGE_PAGES))
+			return false;
+	}
+
+	uintptr_t frame = frame_alloc(LARGE_PAGE_PAGES, FRAME_LOWMEM |
+	    FRAME_ATOMIC | FRAME_NO_RECLAIM | FRAME_NO_RESERVE,
+	    LARGE_PAGE_SIZE - 1);
+	if (frame == 0) {
+		if (area->flags & AS_AREA_LATE_RESERVE)
+			reserve_free(LARGE_PAGE_PAGES);
+		return false;
+	}
+
+	memsetb((void *) PA2KA(frame), LARGE_PAGE_SIZE, 0);
+
+	page_mapping_insert_large(AS, lpage, frame, as_area_get_flags(area));
+	if (!used_space_insert(&area->used_space, lpage, LARGE_PAGE_PAGES))
+		panic("Cannot insert used space.");
+
+	area->large_pages++;
+	return true;
+}
+
+#endif /* LARGE_PAGE_WIDTH */
+
 /** Service a page fault in the anonymous memory address space area.
+ *
+ * Private areas created with AS_AREA_LARGE_PAGES are backed by large
+ * pages where the alignment and the existing mappings permit.
  *
  * The address space area and page tables must be already locked.
  *
@@ -236,6 +292,13 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		 *   the different causes
 		 */
 
+#ifdef LARGE_PAGE_WIDTH
+		if (anon_large_page_fault(area, upage)) {
+			mutex_unlock(&area->sh_info->lock);
+			return AS_PF_OK;
+		}
+#endif
+
 		if (area->flags & AS_AREA_LATE_RESERVE) {
 			/*
 			 * Reserve the memory for this page now.
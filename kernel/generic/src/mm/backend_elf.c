@@ -52,6 +52,9 @@
 #include <arch.h>
 #include <barrier.h>
 
+/** Number of pages in the window mapped around a faulting ELF image page. */
+#define ELF_FAULT_AROUND_PAGES  16
+
 static bool elf_create(as_area_t *);
 static bool elf_resize(as_area_t *, size_t);
 static void elf_share(as_area_t *);
@@ -110,6 +113,89 @@ static uintptr_t elf_orig_page(as_area_t *area, uintptr_t page)
 	return page - area->base + area->backend_data.elf_base;
 }
 
+/** Get the frame of the ELF image which backs a page of a segment.
+ *
+ * @param area		Pointer to the address space area.
+ * @param i		Index of the page within the segment.
+ * @return		Physical address of the image frame.
+ */
+static uintptr_t elf_image_frame(as_area_t *area, size_t i)
+{
+	elf_header_t *elf = area->backend_data.elf;
+	elf_segment_header_t *entry = area->backend_data.segment;
+	uintptr_t base = (uintptr_t)
+	    (((void *) elf) + ALIGN_DOWN(entry->p_offset, PAGE_SIZE));
+	pte_t pte;
+
+	bool found = page_mapping_find(AS_KERNEL, base + i * FRAME_SIZE,
+	    true, &pte);
+
+	(void) found;
+	assert(found);
+	assert(PTE_PRESENT(&pte));
+
+	return PTE_GET_FRAME(&pte);
+}
+
+/** Remove a read-only mapping of an ELF image frame from a page.
+ *
+ * Pages of writable segments are mapped read-only to the frames of the
+ * image until they are first written. Before the page gets its private
+ * copy, the old mapping must be removed from the page tables and TLBs.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area		Pointer to the address space area.
+ * @param upage		Faulting virtual page.
+ * @return		True if a mapping was removed, false if the page was
+ *			not mapped.
+ */
+static bool elf_cow_unmap(as_area_t *area, uintptr_t upage)
+{
+	as_t *as = area->as;
+	pte_t pte;
+
+	if (!page_mapping_find(as, upage, false, &pte) || !PTE_PRESENT(&pte))
+		return false;
+
+	tlb_batch_t batch;
+	tlb_batch_start(&batch, as);
+	page_mapping_remove(as, upage);
+	tlb_batch_add(&batch, upage, 1);
+	tlb_batch_finalize(&batch);
+
+	return true;
+}
+
+/** Give a page still mapped to the ELF image its private copy.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area		Pointer to the address space area.
+ * @param upage		Virtual page mapped read-only to the image.
+ * @param i		Index of the page within the segment.
+ * @return		Physical address of the frame with the copy.
+ */
+static uintptr_t elf_cow_copy(as_area_t *area, uintptr_t upage, size_t i)
+{
+	elf_header_t *elf = area->backend_data.elf;
+	elf_segment_header_t *entry = area->backend_data.segment;
+	uintptr_t base = (uintptr_t)
+	    (((void *) elf) + ALIGN_DOWN(entry->p_offset, PAGE_SIZE));
+	uintptr_t frame;
+
+	uintptr_t kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
+	memcpy((void *) kpage, (void *) (base + i * PAGE_SIZE), PAGE_SIZE);
+	if (entry->p_flags & PF_X)
+		smc_coherence((void *) kpage, PAGE_SIZE);
+	km_temporary_page_put(kpage);
+
+	(void) elf_cow_unmap(area, upage);
+	page_mapping_insert(area->as, upage, frame, as_area_get_flags(area));
+
+	return frame;
+}
+
 bool elf_create(as_area_t *area)
 {
 	size_t nonanon_pages = elf_nonanon_pages_get(area);
@@ -210,13 +296,32 @@ void elf_share(as_area_t *area)
 			assert(PTE_VALID(&pte));
 			assert(PTE_PRESENT(&pte));
 
+			uintptr_t frame = PTE_GET_FRAME(&pte);
+			uintptr_t elfpage = elf_orig_page(area, base + P2SZ(i));
+
+			/*
+			 * Pages of writable segments which have not been
+			 * written yet still map the image read-only. The
+			 * image cannot be shared writable, copy them now.
+			 */
+			if ((area->flags & AS_AREA_WRITE) &&
+			    (elfpage >= entry->p_vaddr) &&
+			    (elfpage + PAGE_SIZE <= start_anon)) {
+				size_t idx = (elfpage -
+				    ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE)) >>
+				    PAGE_WIDTH;
+
+				if (frame == elf_image_frame(area, idx)) {
+					frame = elf_cow_copy(area,
+					    base + P2SZ(i), idx);
+				}
+			}
+
 			as_pagemap_insert(&area->sh_info->pagemap,
-			    (base + P2SZ(i)) - area->base,
-			    PTE_GET_FRAME(&pte));
+			    (base + P2SZ(i)) - area->base, frame);
 			page_table_unlock(area->as, false);
 
-			pfn_t pfn = ADDR2PFN(PTE_GET_FRAME(&pte));
-			frame_reference_add(pfn);
+			frame_reference_add(ADDR2PFN(frame));
 		}
 
 		cur = used_space_next(cur);
@@ -243,6 +348,58 @@ bool elf_is_shareable(as_area_t *area)
 	return true;
 }
 
+/** Map resident ELF image pages around a faulting page.
+ *
+ * Pages of read-only segments are backed directly by the frames of the ELF
+ * image, which are always resident. So are pages of private writable
+ * segments until they are first written, except that they are mapped
+ * read-only. Map the unmapped ones in an aligned window around the faulting
+ * page so that the neighbouring accesses do not need to fault.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area		Pointer to the address space area.
+ * @param upage		Faulting virtual page.
+ * @param flags		Flags of the mappings.
+ */
+static void elf_fault_around(as_area_t *area, uintptr_t upage,
+    unsigned int flags)
+{
+	elf_segment_header_t *entry = area->backend_data.segment;
+	uintptr_t start_anon = entry->p_vaddr + entry->p_filesz;
+
+	uintptr_t first = ALIGN_DOWN(upage, P2SZ(ELF_FAULT_AROUND_PAGES));
+	uintptr_t last = first + P2SZ(ELF_FAULT_AROUND_PAGES);
+
+	if (first < area->base)
+		first = area->base;
+	if (last > area->base + P2SZ(area->pages))
+		last = area->base + P2SZ(area->pages);
+
+	for (uintptr_t page = first; page < last; page += PAGE_SIZE) {
+		if (page == upage)
+			continue;
+
+		uintptr_t elfpage = elf_orig_page(area, page);
+
+		/* Only pages fully backed by the ELF image qualify. */
+		if ((elfpage < entry->p_vaddr) ||
+		    (elfpage + PAGE_SIZE > start_anon))
+			continue;
+
+		pte_t pte;
+		if (page_mapping_find(AS, page, false, &pte))
+			continue;
+
+		size_t i = (elfpage - ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE)) >>
+		    PAGE_WIDTH;
+
+		page_mapping_insert(AS, page, elf_image_frame(area, i), flags);
+		if (!used_space_insert(&area->used_space, page, 1))
+			panic("Cannot insert used space.");
+	}
+}
+
 /** Service a page fault in the ELF backend address space area.
  *
  * The address space area and page tables must be already locked.
@@ -266,6 +423,8 @@ int elf_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	uintptr_t elfpage;
 	size_t i;
 	bool dirty = false;
+	bool cow = false;
+	bool remap;
 
 	assert(page_table_locked(AS));
 	assert(mutex_locked(&area->lock));
@@ -300,9 +459,11 @@ int elf_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		    upage - area->base, &frame);
 		if (rc == EOK) {
 			frame_reference_add(ADDR2PFN(frame));
+			remap = elf_cow_unmap(area, upage);
 			page_mapping_insert(AS, upage, frame,
 			    as_area_get_flags(area));
-			if (!used_space_insert(&area->used_space, upage, 1))
+			if (!remap &&
+			    !used_space_insert(&area->used_space, upage, 1))
 				panic("Cannot insert used space.");
 			mutex_unlock(&area->sh_info->lock);
 			return AS_PF_OK;
@@ -319,10 +480,14 @@ int elf_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		 * directly by the content of the ELF image. Pages are
 		 * only copied if the segment is writable so that there
 		 * can be more instances of the same memory ELF image
-		 * used at a time. Note that this could be later done
-		 * as COW.
+		 * used at a time. Private pages are copied on write,
+		 * until then they are mapped read-only to the image.
 		 */
-		if (entry->p_flags & PF_W) {
+		if ((entry->p_flags & PF_W) && (access != PF_ACCESS_WRITE) &&
+		    (!area->sh_info->shared)) {
+			frame = elf_image_frame(area, i);
+			cow = true;
+		} else if (entry->p_flags & PF_W) {
 			kpage = km_temporary_page_get(&frame, FRAME_NO_RESERVE);
 			memcpy((void *) kpage, (void *) (base + i * PAGE_SIZE),
 			    PAGE_SIZE);
@@ -332,17 +497,7 @@ int elf_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 			km_temporary_page_put(kpage);
 			dirty = true;
 		} else {
-			pte_t pte;
-			bool found;
-
-			found = page_mapping_find(AS_KERNEL,
-			    base + i * FRAME_SIZE, true, &pte);
-
-			(void) found;
-			assert(found);
-			assert(PTE_PRESENT(&pte));
-
-			frame = PTE_GET_FRAME(&pte);
+			frame = elf_image_frame(area, i);
 		}
 	} else if (elfpage >= start_anon) {
 		/*
@@ -396,10 +551,18 @@ int elf_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 
 	mutex_unlock(&area->sh_info->lock);
 
-	page_mapping_insert(AS, upage, frame, as_area_get_flags(area));
-	if (!used_space_insert(&area->used_space, upage, 1))
+	unsigned int flags = as_area_get_flags(area);
+	if (cow)
+		flags &= ~PAGE_WRITE;
+
+	remap = elf_cow_unmap(area, upage);
+	page_mapping_insert(AS, upage, frame, flags);
+	if (!remap && !used_space_insert(&area->used_space, upage, 1))
 		panic("Cannot insert used space.");
 
+	if ((!(entry->p_flags & PF_W)) || (cow))
+		elf_fault_around(area, upage, flags);
+
 	return AS_PF_OK;
 }
 
@@ -430,10 +593,14 @@ void elf_frame_free(as_area_t *area, uintptr_t page, uintptr_t frame)
 	start_anon = entry->p_vaddr + entry->p_filesz;
 
 	if (elfpage >= entry->p_vaddr && elfpage + PAGE_SIZE <= start_anon) {
-		if (entry->p_flags & PF_W) {
+		size_t i = (elfpage - ALIGN_DOWN(entry->p_vaddr, PAGE_SIZE)) >>
+		    PAGE_WIDTH;
+
+		if ((entry->p_flags & PF_W) &&
+		    (frame != elf_image_frame(area, i))) {
 			/*
 			 * Free the frame with the copy of writable segment
-			 * data.
+			 * data. Pages not written yet map the image itself.
 			 */
 			frame_free_noreserve(frame, 1);
 		}
@@ -117,6 +117,10 @@ bool phys_is_shareable(as_area_t *area)
 }
 
 /** Service a page fault in the address space area backed by physical memory.
+ *
+ * Areas created with AS_AREA_LARGE_PAGES are mapped by large pages where
+ * the virtual and physical addresses are congruent modulo the large page
+ * size.
  *
  * The address space area and page tables must be already locked.
  *
@@ -139,6 +143,25 @@ int phys_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		return AS_PF_FAULT;
 
 	assert(upage - area->base < area->backend_data.frames * FRAME_SIZE);
+
+#ifdef LARGE_PAGE_WIDTH
+	uintptr_t lpage;
+	if ((as_area_large_page(area, upage, &lpage)) &&
+	    (IS_ALIGNED(base + (lpage - area->base), LARGE_PAGE_SIZE)) &&
+	    (lpage - area->base + LARGE_PAGE_SIZE <=
+	    area->backend_data.frames * FRAME_SIZE)) {
+		page_mapping_insert_large(AS, lpage, base + (lpage - area->base),
+		    as_area_get_flags(area));
+
+		if (!used_space_insert(&area->used_space, lpage,
+		    LARGE_PAGE_PAGES))
+			panic("Cannot insert used space.");
+
+		area->large_pages++;
+		return AS_PF_OK;
+	}
+#endif
+
 	page_mapping_insert(AS, upage, base + (upage - area->base),
 	    as_area_get_flags(area));
 
@@ -48,8 +48,12 @@
 #include <assert.h>
 #include <errno.h>
 #include <log.h>
+#include <macros.h>
 #include <str.h>
 
+/** Maximum number of pages paged in by a single page-in request. */
+#define USER_READAHEAD_MAX  16
+
 static bool user_create(as_area_t *);
 static void user_destroy(as_area_t *);
 
@@ -95,59 +99,140 @@ bool user_is_shareable(as_area_t *area)
 	return false;
 }
 
-/** Service a page fault in the user-paged address space area.
+/** Determine how many pages to page in from the faulting page on
  *
- * The address space area and page tables must be already locked.
+ * The readahead window doubles with every fault that continues a
+ * sequential access pattern and collapses back to a single page otherwise.
+ * The window never extends past the area or over already mapped pages.
  *
- * @param area Pointer to the address space area.
+ * @param area  Pointer to the address space area.
  * @param upage Faulting virtual page.
- * @param access Access mode that caused the fault (i.e. read/write/exec).
  *
- * @return AS_PF_FAULT on failure (i.e. page fault) or AS_PF_OK on success (i.e.
- *     serviced).
+ * @return Number of pages to page in.
  */
-int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
+static size_t user_readahead_pages(as_area_t *area, uintptr_t upage)
 {
-	assert(page_table_locked(AS));
-	assert(mutex_locked(&area->lock));
-	assert(IS_ALIGNED(upage, PAGE_SIZE));
+	if ((upage == area->readahead_next) && (area->readahead_pages > 0))
+		area->readahead_pages = min(2 * area->readahead_pages,
+		    USER_READAHEAD_MAX);
+	else
+		area->readahead_pages = 1;
 
-	if (!as_area_check_access(area, access))
-		return AS_PF_FAULT;
+	size_t avail = (area->base + P2SZ(area->pages) - upage) >> PAGE_WIDTH;
+	size_t count = min(area->readahead_pages, avail);
 
+	for (size_t i = 1; i < count; i++) {
+		pte_t pte;
+		if (page_mapping_find(AS, upage + P2SZ(i), false, &pte))
+			return i;
+	}
+
+	return count;
+}
+
+/** Send a page-in request to the pager of the area.
+ *
+ * @param area   Pointer to the address space area.
+ * @param upage  First page to be paged in.
+ * @param count  Number of pages to be paged in.
+ * @param frames Array to be filled with the frames of the pages.
+ *
+ * The area and the page tables must be locked. The page tables are unlocked
+ * while the request is pending.
+ *
+ * @return EOK on success or an error code.
+ */
+static errno_t user_page_in(as_area_t *area, uintptr_t upage, size_t count,
+    uintptr_t *frames)
+{
 	as_area_pager_info_t *pager_info = &area->backend_data.pager_info;
 
 	ipc_data_t data = { };
 	ipc_set_imethod(&data, IPC_M_PAGE_IN);
 	ipc_set_arg1(&data, upage - area->base);
-	ipc_set_arg2(&data, PAGE_SIZE);
+	/* Let the pager know how the pages are going to be accessed. */
+	ipc_set_arg2(&data, P2SZ(count) |
+	    (area->flags & (AS_AREA_READ | AS_AREA_WRITE | AS_AREA_EXEC)));
 	ipc_set_arg3(&data, pager_info->id1);
 	ipc_set_arg4(&data, pager_info->id2);
 	ipc_set_arg5(&data, pager_info->id3);
 
-	errno_t rc = ipc_req_internal(pager_info->pager, &data, (sysarg_t) true);
+	/*
+	 * Do not block page faults in other areas while waiting for the
+	 * pager. No mappings can appear in this area in the meantime as
+	 * the area stays locked.
+	 */
+	page_table_unlock(AS, false);
+	errno_t rc = ipc_req_internal(pager_info->pager, &data,
+	    (sysarg_t) frames);
+	page_table_lock(AS, false);
 
 	if (rc != EOK) {
 		log(LF_USPACE, LVL_FATAL,
 		    "Page-in request for page %#" PRIxPTR
 		    " at pager %p failed with error %s.",
 		    upage, pager_info->pager, str_error_name(rc));
+		return rc;
+	}
+
+	return ipc_get_retval(&data);
+}
+
+/** Service a page fault in the user-paged address space area.
+ *
+ * Sequential faults are detected and serviced with page-in requests for
+ * several pages at once.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ * @param access Access mode that caused the fault (i.e. read/write/exec).
+ *
+ * @return AS_PF_FAULT on failure (i.e. page fault) or AS_PF_OK on success (i.e.
+ *     serviced).
+ */
+int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
+{
+	assert(page_table_locked(AS));
+	assert(mutex_locked(&area->lock));
+	assert(IS_ALIGNED(upage, PAGE_SIZE));
+
+	if (!as_area_check_access(area, access))
 		return AS_PF_FAULT;
+
+	uintptr_t frames[USER_READAHEAD_MAX];
+	size_t count = user_readahead_pages(area, upage);
+
+	errno_t rc = user_page_in(area, upage, count, frames);
+	if ((rc != EOK) && (count > 1)) {
+		/* The pager may be unable to satisfy a large request. */
+		area->readahead_pages = 1;
+		count = 1;
+		rc = user_page_in(area, upage, count, frames);
 	}
 
-	if (ipc_get_retval(&data) != EOK)
+	if (rc != EOK)
 		return AS_PF_FAULT;
 
 	/*
-	 * A successful reply will contain the physical frame in ARG1.
-	 * The physical frame will have the reference count already
-	 * incremented (if applicable).
+	 * A successful reply contains the physical frames of the pages.
+	 * The physical frames will have the reference count already
+	 * incremented (if applicable). Only the first frame is guaranteed
+	 * to be present.
 	 */
 
-	uintptr_t frame = ipc_get_arg1(&data);
-	page_mapping_insert(AS, upage, frame, as_area_get_flags(area));
-	if (!used_space_insert(&area->used_space, upage, 1))
-		panic("Cannot insert used space.");
+	for (size_t i = 0; i < count; i++) {
+		if ((i > 0) && (frames[i] == 0))
+			continue;
+
+		page_mapping_insert(AS, upage + P2SZ(i), frames[i],
+		    as_area_get_flags(area));
+		if (!used_space_insert(&area->used_space, upage + P2SZ(i), 1))
+			panic("Cannot insert used space.");
+	}
+
+	area->readahead_next = upage + P2SZ(count);
 
 	return AS_PF_OK;
 }
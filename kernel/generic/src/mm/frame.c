@@ -39,11 +39,22 @@
  * This file contains the physical frame allocator and memory zone management.
  * The frame allocator is built on top of the two-level bitmap structure.
  *
+ * Single frames are allocated and freed through small per-CPU caches
+ * which are refilled from and drained to the zones in batches, so that
+ * the zones lock is not taken on every allocation and deallocation.
+ * The frames held in a per-CPU cache are allocated in the zone bitmaps,
+ * but their reference count is zero.
+ *
+ * Each available zone belongs to a memory node. Allocations prefer zones
+ * on the node of the current processor and fall back to other nodes in
+ * the order of their distance.
+ *
  */
 
 #include <typedefs.h>
 #include <mm/frame.h>
 #include <mm/reserve.h>
+#include <mm/numa.h>
 #include <mm/as.h>
 #include <panic.h>
 #include <assert.h>
@@ -60,7 +71,9 @@
 #include <macros.h>
 #include <config.h>
 #include <str.h>
+#include <stdlib.h>
 #include <proc/thread.h> /* THREAD */
+#include <tracepoint.h>
 
 zones_t zones;
 
@@ -73,6 +86,45 @@ static condvar_t mem_avail_cv;
 static size_t mem_avail_req = 0;  /**< Number of frames requested. */
 static size_t mem_avail_gen = 0;  /**< Generation counter. */
 
+/** Maximum number of frames in one list of a per-CPU frame cache. */
+#define FRAME_CPUCACHE_SIZE  64
+
+/** Number of frames moved between a per-CPU frame cache and the zones. */
+#define FRAME_CPUCACHE_BATCH  16
+
+/** Frame lists of a per-CPU frame cache. */
+typedef enum {
+	FRAME_CPUCACHE_LOWMEM = 0,
+	FRAME_CPUCACHE_HIGHMEM,
+	FRAME_CPUCACHE_LISTS
+} frame_cpucache_list_t;
+
+/** Per-CPU cache of free frames. */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+
+	/** Number of cached frames in each list. */
+	size_t count[FRAME_CPUCACHE_LISTS];
+
+	/** Cached frames. */
+	pfn_t pfn[FRAME_CPUCACHE_LISTS][FRAME_CPUCACHE_SIZE];
+
+	/** Zone the cache was last refilled from. */
+	size_t hint;
+
+	/** Number of allocations satisfied from the cache. */
+	uint64_t hits;
+
+	/** Number of allocations which required a refill from the zones. */
+	uint64_t misses;
+} frame_cpucache_t;
+
+/** Per-CPU frame caches, NULL until frame_enable_cpucache() is called. */
+static frame_cpucache_t *frame_cpucaches = NULL;
+
+/** Whether there is any available high memory zone. */
+static bool frame_highmem_present = false;
+
 /** Initialize frame structure.
  *
  * @param frame Frame structure to be initialized.
@@ -84,6 +136,27 @@ _NO_TRACE static void frame_initialize(frame_t *frame)
 	frame->parent = NULL;
 }
 
+/** Get number of frames in all per-CPU frame caches.
+ *
+ * The result is only approximate as the caches are not locked.
+ *
+ */
+static size_t frame_cpucache_count(void)
+{
+	if (frame_cpucaches == NULL)
+		return 0;
+
+	size_t count = 0;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		for (frame_cpucache_list_t list = 0;
+		    list < FRAME_CPUCACHE_LISTS; list++)
+			count += frame_cpucaches[i].count[list];
+	}
+
+	return count;
+}
+
 /*******************/
 /* Zones functions */
 /*******************/
@@ -174,7 +247,7 @@ _NO_TRACE size_t frame_total_free_get(void)
 	total = frame_total_free_get_internal();
 	irq_spinlock_unlock(&zones.lock, true);
 
-	return total;
+	return total + frame_cpucache_count();
 }
 
 /** Find a zone with a given frames.
@@ -233,17 +306,22 @@ _NO_TRACE static bool zone_can_alloc(zone_t *zone, size_t count,
  * @param constraint Indication of bits that cannot be set in the
  *                   physical frame number of the first allocated frame.
  * @param hint       Preferred zone.
+ * @param node       Required node of the zone or NUMA_NODE_ANY.
  *
  * @return Zone that can allocate specified number of frames.
  * @return -1 if no zone can satisfy the request.
  *
  */
 _NO_TRACE static size_t find_free_zone_all(size_t count, zone_flags_t flags,
-    pfn_t constraint, size_t hint)
+    pfn_t constraint, size_t hint, unsigned int node)
 {
 	for (size_t pos = 0; pos < zones.count; pos++) {
 		size_t i = (pos + hint) % zones.count;
 
+		/* Check whether the zone is on the requested node. */
+		if ((node != NUMA_NODE_ANY) && (zones.info[i].node != node))
+			continue;
+
 		/* Check whether the zone meets the search criteria. */
 		if (!ZONE_FLAGS_MATCH(zones.info[i].flags, flags))
 			continue;
@@ -279,17 +357,22 @@ _NO_TRACE static bool is_high_priority(pfn_t base, size_t count)
  * @param constraint Indication of bits that cannot be set in the
  *                   physical frame number of the first allocated frame.
  * @param hint       Preferred zone.
+ * @param node       Required node of the zone or NUMA_NODE_ANY.
  *
  * @return Zone that can allocate specified number of frames.
  * @return -1 if no low-priority zone can satisfy the request.
  *
  */
 _NO_TRACE static size_t find_free_zone_lowprio(size_t count, zone_flags_t flags,
-    pfn_t constraint, size_t hint)
+    pfn_t constraint, size_t hint, unsigned int node)
 {
 	for (size_t pos = 0; pos < zones.count; pos++) {
 		size_t i = (pos + hint) % zones.count;
 
+		/* Check whether the zone is on the requested node. */
+		if ((node != NUMA_NODE_ANY) && (zones.info[i].node != node))
+			continue;
+
 		/* Skip zones containing only high-priority memory. */
 		if (is_high_priority(zones.info[i].base, zones.info[i].count))
 			continue;
@@ -316,13 +399,14 @@ _NO_TRACE static size_t find_free_zone_lowprio(size_t count, zone_flags_t flags,
  * @param constraint Indication of bits that cannot be set in the
  *                   physical frame number of the first allocated frame.
  * @param hint       Preferred zone.
+ * @param node       Required node of the zone or NUMA_NODE_ANY.
  *
  * @return Zone that can allocate specified number of frames.
  * @return -1 if no zone can satisfy the request.
  *
  */
 _NO_TRACE static size_t find_free_zone(size_t count, zone_flags_t flags,
-    pfn_t constraint, size_t hint)
+    pfn_t constraint, size_t hint, unsigned int node)
 {
 	if (hint >= zones.count)
 		hint = 0;
@@ -332,12 +416,13 @@ _NO_TRACE static size_t find_free_zone(size_t count, zone_flags_t flags,
 	 * zones with high-priority memory.
 	 */
 
-	size_t znum = find_free_zone_lowprio(count, flags, constraint, hint);
+	size_t znum = find_free_zone_lowprio(count, flags, constraint, hint,
+	    node);
 	if (znum != (size_t) -1)
 		return znum;
 
 	/* Take all zones into account */
-	return find_free_zone_all(count, flags, constraint, hint);
+	return find_free_zone_all(count, flags, constraint, hint, node);
 }
 
 /******************/
@@ -425,6 +510,26 @@ _NO_TRACE static size_t zone_frame_free(zone_t *zone, size_t index)
 	return 0;
 }
 
+/** Return frame from a per-CPU cache to zone.
+ *
+ * Assume zone is locked and is available for deallocation.
+ *
+ * @param zone  Pointer to zone to which the frame is returned.
+ * @param index Frame index relative to zone.
+ *
+ */
+_NO_TRACE static void zone_frame_return(zone_t *zone, size_t index)
+{
+	assert(zone->flags & ZONE_AVAILABLE);
+	assert(zone_get_frame(zone, index)->refcount == 0);
+
+	bitmap_set(&zone->bitmap, index, 0);
+
+	/* Update zone information. */
+	zone->free_count++;
+	zone->busy_count--;
+}
+
 /** Mark frame in zone unavailable to allocation. */
 _NO_TRACE static void zone_mark_unavailable(zone_t *zone, size_t index)
 {
@@ -458,6 +563,7 @@ _NO_TRACE static void zone_merge_internal(size_t z1, size_t z2, zone_t *old_z1,
 	assert(zones.info[z1].flags & ZONE_AVAILABLE);
 	assert(zones.info[z2].flags & ZONE_AVAILABLE);
 	assert(zones.info[z1].flags == zones.info[z2].flags);
+	assert(zones.info[z1].node == zones.info[z2].node);
 	assert(zones.info[z1].base < zones.info[z2].base);
 	assert(!overlaps(zones.info[z1].base, zones.info[z1].count,
 	    zones.info[z2].base, zones.info[z2].count));
@@ -525,7 +631,7 @@ _NO_TRACE static void return_config_frames(size_t znum, pfn_t pfn, size_t count)
  *
  * The merged zones must be 2 zones with no zone existing in between
  * (which means that z2 = z1 + 1). Both zones must be available zones
- * with the same flags.
+ * with the same flags on the same node.
  *
  * When you create a new zone, the frame allocator configuration does
  * not to be 2^order size. Once the allocator is running it is no longer
@@ -534,17 +640,21 @@ _NO_TRACE static void return_config_frames(size_t znum, pfn_t pfn, size_t count)
  */
 bool zone_merge(size_t z1, size_t z2)
 {
+	/* The zone layout must not change once the per-CPU caches are used. */
+	assert(frame_cpucaches == NULL);
+
 	irq_spinlock_lock(&zones.lock, true);
 
 	bool ret = true;
 
 	/*
 	 * We can join only 2 zones with none existing inbetween,
-	 * the zones have to be available and with the same
-	 * set of flags
+	 * the zones have to be available, with the same
+	 * set of flags and on the same node
 	 */
 	if ((z1 >= zones.count) || (z2 >= zones.count) || (z2 - z1 != 1) ||
-	    (zones.info[z1].flags != zones.info[z2].flags)) {
+	    (zones.info[z1].flags != zones.info[z2].flags) ||
+	    (zones.info[z1].node != zones.info[z2].node)) {
 		ret = false;
 		goto errout;
 	}
@@ -617,17 +727,19 @@ void zone_merge_all(void)
  * @param start    Physical address of the first frame within the zone.
  * @param count    Count of frames in zone.
  * @param flags    Zone flags.
+ * @param node     Memory node of the zone.
  * @param confdata Configuration data of the zone.
  *
  * @return Initialized zone.
  *
  */
 _NO_TRACE static void zone_construct(zone_t *zone, pfn_t start, size_t count,
-    zone_flags_t flags, void *confdata)
+    zone_flags_t flags, unsigned int node, void *confdata)
 {
 	zone->base = start;
 	zone->count = count;
 	zone->flags = flags;
+	zone->node = node;
 	zone->free_count = count;
 	zone->busy_count = 0;
 
@@ -688,13 +800,17 @@ pfn_t zone_external_conf_alloc(size_t count)
  *                  zone_conf_size() amount of data. If the confframe is
  *                  inside the area, the zone free frame information is
  *                  modified not to include it.
+ * @param flags     Zone flags.
+ * @param node      Memory node of the zone.
  *
  * @return Zone number or -1 on error.
  *
  */
-size_t zone_create(pfn_t start, size_t count, pfn_t confframe,
-    zone_flags_t flags)
+size_t zone_create_node(pfn_t start, size_t count, pfn_t confframe,
+    zone_flags_t flags, unsigned int node)
 {
+	assert(frame_cpucaches == NULL);
+
 	irq_spinlock_lock(&zones.lock, true);
 
 	if (flags & ZONE_AVAILABLE) {  /* Create available zone */
@@ -752,7 +868,8 @@ size_t zone_create(pfn_t start, size_t count, pfn_t confframe,
 		}
 
 		void *confdata = (void *) PA2KA(PFN2ADDR(confframe));
-		zone_construct(&zones.info[znum], start, count, flags, confdata);
+		zone_construct(&zones.info[znum], start, count, flags, node,
+		    confdata);
 
 		/* If confdata in zone, mark as unavailable */
 		if ((confframe >= start) && (confframe < start + count)) {
@@ -773,13 +890,24 @@ size_t zone_create(pfn_t start, size_t count, pfn_t confframe,
 		return (size_t) -1;
 	}
 
-	zone_construct(&zones.info[znum], start, count, flags, NULL);
+	zone_construct(&zones.info[znum], start, count, flags, node, NULL);
 
 	irq_spinlock_unlock(&zones.lock, true);
 
 	return znum;
 }
 
+/** Create and add zone on the first memory node to system.
+ *
+ * @see zone_create_node()
+ *
+ */
+size_t zone_create(pfn_t start, size_t count, pfn_t confframe,
+    zone_flags_t flags)
+{
+	return zone_create_node(start, count, confframe, flags, 0);
+}
+
 /*******************/
 /* Frame functions */
 /*******************/
@@ -815,18 +943,325 @@ void *frame_get_parent(pfn_t pfn, size_t hint)
 	return res;
 }
 
-static size_t try_find_zone(size_t count, bool lowmem,
-    pfn_t frame_constraint, size_t hint)
+static size_t try_find_zone_node(size_t count, bool lowmem,
+    pfn_t frame_constraint, size_t hint, unsigned int node)
 {
 	if (!lowmem) {
 		size_t znum = find_free_zone(count,
-		    ZONE_HIGHMEM | ZONE_AVAILABLE, frame_constraint, hint);
+		    ZONE_HIGHMEM | ZONE_AVAILABLE, frame_constraint, hint, node);
 		if (znum != (size_t) -1)
 			return znum;
 	}
 
 	return find_free_zone(count, ZONE_LOWMEM | ZONE_AVAILABLE,
-	    frame_constraint, hint);
+	    frame_constraint, hint, node);
+}
+
+/** Find a zone, preferring zones close to a memory node.
+ *
+ * Assume interrupts are disabled and zones lock is locked.
+ *
+ * @param count            Number of free frames we are trying to find.
+ * @param lowmem           Whether the frames must reside in low memory.
+ * @param frame_constraint Indication of bits that cannot be set in the
+ *                         physical frame number of the first frame.
+ * @param hint             Preferred zone.
+ * @param node             Preferred node or NUMA_NODE_ANY.
+ *
+ * @return Zone that can allocate specified number of frames.
+ * @return -1 if no zone can satisfy the request.
+ *
+ */
+static size_t try_find_zone(size_t count, bool lowmem,
+    pfn_t frame_constraint, size_t hint, unsigned int node)
+{
+	if ((node == NUMA_NODE_ANY) || (numa_node_count() == 1))
+		return try_find_zone_node(count, lowmem, frame_constraint,
+		    hint, NUMA_NODE_ANY);
+
+	unsigned int order[NUMA_NODES_MAX];
+	size_t nodes = numa_nodes_by_distance(node, order);
+
+	for (size_t i = 0; i < nodes; i++) {
+		size_t znum = try_find_zone_node(count, lowmem,
+		    frame_constraint, hint, order[i]);
+		if (znum != (size_t) -1)
+			return znum;
+	}
+
+	return (size_t) -1;
+}
+
+/** Refill a per-CPU frame cache list from the zones.
+ *
+ * Assume interrupts are disabled and the cache is locked.
+ *
+ * The cache is only refilled with frames from the node of the processor.
+ *
+ * @param cache Per-CPU frame cache.
+ * @param list  List to refill.
+ * @param node  Node of the processor owning the cache.
+ *
+ */
+static void frame_cpucache_refill(frame_cpucache_t *cache,
+    frame_cpucache_list_t list, unsigned int node)
+{
+	zone_flags_t flags = ZONE_AVAILABLE |
+	    ((list == FRAME_CPUCACHE_LOWMEM) ? ZONE_LOWMEM : ZONE_HIGHMEM);
+
+	irq_spinlock_lock(&zones.lock, false);
+
+	while (cache->count[list] < FRAME_CPUCACHE_BATCH) {
+		size_t znum = find_free_zone(1, flags, 0, cache->hint, node);
+		if (znum == (size_t) -1)
+			break;
+
+		size_t index = zone_frame_alloc(&zones.info[znum], 1, 0);
+		zone_get_frame(&zones.info[znum], index)->refcount = 0;
+
+		cache->pfn[list][cache->count[list]++] =
+		    zones.info[znum].base + index;
+		cache->hint = znum;
+	}
+
+	irq_spinlock_unlock(&zones.lock, false);
+}
+
+/** Drain a per-CPU frame cache list to the zones.
+ *
+ * Assume interrupts are disabled and the cache is locked.
+ *
+ * @param cache Per-CPU frame cache.
+ * @param list  List to drain.
+ * @param keep  Number of frames to keep in the list.
+ *
+ * @return Number of frames returned to the zones.
+ *
+ */
+static size_t frame_cpucache_drain(frame_cpucache_t *cache,
+    frame_cpucache_list_t list, size_t keep)
+{
+	size_t drained = 0;
+
+	irq_spinlock_lock(&zones.lock, false);
+
+	while (cache->count[list] > keep) {
+		pfn_t pfn = cache->pfn[list][--cache->count[list]];
+		size_t znum = find_zone(pfn, 1, cache->hint);
+
+		assert(znum != (size_t) -1);
+
+		zone_frame_return(&zones.info[znum],
+		    pfn - zones.info[znum].base);
+		drained++;
+	}
+
+	irq_spinlock_unlock(&zones.lock, false);
+
+	return drained;
+}
+
+/** Drain all per-CPU frame caches to the zones.
+ *
+ * The zones lock must not be held.
+ *
+ * @return Number of frames returned to the zones.
+ *
+ */
+static size_t frame_cpucache_drain_all(void)
+{
+	if (frame_cpucaches == NULL)
+		return 0;
+
+	size_t drained = 0;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_lock(&frame_cpucaches[i].lock, true);
+
+		for (frame_cpucache_list_t list = 0;
+		    list < FRAME_CPUCACHE_LISTS; list++)
+			drained += frame_cpucache_drain(&frame_cpucaches[i],
+			    list, 0);
+
+		irq_spinlock_unlock(&frame_cpucaches[i].lock, true);
+	}
+
+	return drained;
+}
+
+/** Find frame structure without locking the zones.
+ *
+ * This is possible because the zone layout does not change once the
+ * per-CPU frame caches have been enabled.
+ *
+ */
+static frame_t *frame_cpucache_lookup(pfn_t pfn, size_t hint)
+{
+	size_t znum = find_zone(pfn, 1, hint);
+
+	assert(znum != (size_t) -1);
+
+	return zone_get_frame(&zones.info[znum], pfn - zones.info[znum].base);
+}
+
+/** Allocate a single frame from the per-CPU frame cache.
+ *
+ * @param lowmem Whether the frame must reside in low memory.
+ *
+ * @return Frame number of the allocated frame or 0 if the frame could not
+ *         be allocated from the cache.
+ *
+ */
+static pfn_t frame_cpucache_alloc(bool lowmem)
+{
+	if ((frame_cpucaches == NULL) || (!CPU))
+		return 0;
+
+	frame_cpucache_list_t list = ((lowmem) || (!frame_highmem_present)) ?
+	    FRAME_CPUCACHE_LOWMEM : FRAME_CPUCACHE_HIGHMEM;
+	pfn_t pfn = 0;
+
+	ipl_t ipl = interrupts_disable();
+	frame_cpucache_t *cache = &frame_cpucaches[CPU->id];
+	irq_spinlock_lock(&cache->lock, false);
+
+	if (cache->count[list] > 0) {
+		cache->hits++;
+	} else {
+		cache->misses++;
+		frame_cpucache_refill(cache, list, CPU->node);
+	}
+
+	if (cache->count[list] > 0) {
+		pfn = cache->pfn[list][--cache->count[list]];
+
+		frame_t *frame = frame_cpucache_lookup(pfn, cache->hint);
+		assert(frame->refcount == 0);
+		frame->refcount = 1;
+	}
+
+	irq_spinlock_unlock(&cache->lock, false);
+	interrupts_restore(ipl);
+
+	return pfn;
+}
+
+/** Free a single frame to the per-CPU frame cache.
+ *
+ * @param pfn Frame number of the frame to be freed.
+ *
+ * @return Number of frames freed (0 or 1) or -1 if the frame has to be
+ *         freed through the zones.
+ *
+ */
+static int frame_cpucache_free(pfn_t pfn)
+{
+	if ((frame_cpucaches == NULL) || (!CPU))
+		return -1;
+
+	/*
+	 * Keep the high-priority memory out of the caches and do not
+	 * bypass the wakeup of threads waiting for memory.
+	 */
+	if ((is_high_priority(pfn, 1)) || (mem_avail_req > 0))
+		return -1;
+
+	ipl_t ipl = interrupts_disable();
+	frame_cpucache_t *cache = &frame_cpucaches[CPU->id];
+	irq_spinlock_lock(&cache->lock, false);
+
+	int freed = 0;
+	size_t znum = find_zone(pfn, 1, cache->hint);
+	assert(znum != (size_t) -1);
+
+	frame_t *frame = zone_get_frame(&zones.info[znum],
+	    pfn - zones.info[znum].base);
+
+	assert(frame->refcount > 0);
+
+	/* Only frames of the local node are cached. */
+	if (zones.info[znum].node != CPU->node) {
+		freed = -1;
+		goto out;
+	}
+
+	if (atomic_predec(&frame->refcount) == 0) {
+		frame_cpucache_list_t list =
+		    (zones.info[znum].flags & ZONE_LOWMEM) ?
+		    FRAME_CPUCACHE_LOWMEM : FRAME_CPUCACHE_HIGHMEM;
+
+		if (cache->count[list] == FRAME_CPUCACHE_SIZE)
+			(void) frame_cpucache_drain(cache, list,
+			    FRAME_CPUCACHE_SIZE - FRAME_CPUCACHE_BATCH);
+
+		cache->pfn[list][cache->count[list]++] = pfn;
+		freed = 1;
+	}
+
+out:
+	irq_spinlock_unlock(&cache->lock, false);
+	interrupts_restore(ipl);
+
+	return freed;
+}
+
+/** Enable the per-CPU frame caches.
+ *
+ * Must be called after the number of processors is known and after
+ * the zone layout has been finalized.
+ *
+ */
+void frame_enable_cpucache(void)
+{
+	frame_cpucache_t *caches =
+	    malloc(sizeof(frame_cpucache_t) * config.cpu_count);
+	if (!caches)
+		panic("Cannot allocate per-CPU frame caches.");
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_initialize(&caches[i].lock, "frame.cpucache.lock");
+
+		for (frame_cpucache_list_t list = 0;
+		    list < FRAME_CPUCACHE_LISTS; list++)
+			caches[i].count[list] = 0;
+
+		caches[i].hint = 0;
+		caches[i].hits = 0;
+		caches[i].misses = 0;
+	}
+
+	irq_spinlock_lock(&zones.lock, true);
+
+	for (size_t i = 0; i < zones.count; i++) {
+		if (ZONE_FLAGS_MATCH(zones.info[i].flags,
+		    ZONE_HIGHMEM | ZONE_AVAILABLE))
+			frame_highmem_present = true;
+	}
+
+	frame_cpucaches = caches;
+
+	irq_spinlock_unlock(&zones.lock, true);
+}
+
+/** Get statistics of a per-CPU frame cache.
+ *
+ * @param cpu    CPU ID.
+ * @param hits   Place to store the number of cache hits.
+ * @param misses Place to store the number of cache misses.
+ *
+ */
+void frame_cpucache_stats(unsigned int cpu, uint64_t *hits, uint64_t *misses)
+{
+	*hits = 0;
+	*misses = 0;
+
+	if ((frame_cpucaches == NULL) || (cpu >= config.cpu_count))
+		return;
+
+	irq_spinlock_lock(&frame_cpucaches[cpu].lock, true);
+	*hits = frame_cpucaches[cpu].hits;
+	*misses = frame_cpucaches[cpu].misses;
+	irq_spinlock_unlock(&frame_cpucaches[cpu].lock, true);
 }
 
 /** Allocate frames of physical memory.
@@ -836,12 +1271,13 @@ static size_t try_find_zone(size_t count, bool lowmem,
  * @param constraint Indication of physical address bits that cannot be
  *                   set in the address of the first allocated frame.
  * @param pzone      Preferred zone.
+ * @param node       Preferred memory node or NUMA_NODE_ANY.
  *
  * @return Physical address of the allocated frame.
  *
  */
-uintptr_t frame_alloc_generic(size_t count, frame_flags_t flags,
-    uintptr_t constraint, size_t *pzone)
+static uintptr_t frame_alloc_internal(size_t count, frame_flags_t flags,
+    uintptr_t constraint, size_t *pzone, unsigned int node)
 {
 	assert(count > 0);
 
@@ -854,16 +1290,43 @@ uintptr_t frame_alloc_generic(size_t count, frame_flags_t flags,
 	if (!(flags & FRAME_NO_RESERVE))
 		reserve_force_alloc(count);
 
-loop:
-	irq_spinlock_lock(&zones.lock, true);
-
 	// TODO: Print diagnostic if neither is explicitly specified.
 	bool lowmem = (flags & FRAME_LOWMEM) || !(flags & FRAME_HIGHMEM);
 
+	/*
+	 * Single unconstrained frames on the local node are taken
+	 * from the per-CPU cache.
+	 */
+	if ((count == 1) && (frame_constraint == 0) && (!pzone) && (CPU) &&
+	    ((node == NUMA_NODE_ANY) || (node == CPU->node))) {
+		pfn_t pfn = frame_cpucache_alloc(lowmem);
+		if (pfn != 0) {
+			TRACEPOINT(TRACE_FRAME_ALLOC, PFN2ADDR(pfn), count, flags);
+			return PFN2ADDR(pfn);
+		}
+	}
+
+loop:
+	irq_spinlock_lock(&zones.lock, true);
+
 	/*
 	 * First, find suitable frame zone.
 	 */
-	size_t znum = try_find_zone(count, lowmem, frame_constraint, hint);
+	size_t znum = try_find_zone(count, lowmem, frame_constraint, hint,
+	    node);
+
+	/*
+	 * If no memory, flush the per-CPU frame caches.
+	 */
+	if ((znum == (size_t) -1) && (frame_cpucaches != NULL)) {
+		irq_spinlock_unlock(&zones.lock, true);
+		size_t drained = frame_cpucache_drain_all();
+		irq_spinlock_lock(&zones.lock, true);
+
+		if (drained > 0)
+			znum = try_find_zone(count, lowmem,
+			    frame_constraint, hint, node);
+	}
 
 	/*
 	 * If no memory, reclaim some slab memory,
@@ -876,7 +1339,7 @@ loop:
 
 		if (freed > 0)
 			znum = try_find_zone(count, lowmem,
-			    frame_constraint, hint);
+			    frame_constraint, hint, node);
 
 		if (znum == (size_t) -1) {
 			irq_spinlock_unlock(&zones.lock, true);
@@ -885,7 +1348,7 @@ loop:
 
 			if (freed > 0)
 				znum = try_find_zone(count, lowmem,
-				    frame_constraint, hint);
+				    frame_constraint, hint, node);
 		}
 	}
 
@@ -953,9 +1416,54 @@ loop:
 	if (pzone)
 		*pzone = znum;
 
+	TRACEPOINT(TRACE_FRAME_ALLOC, PFN2ADDR(pfn), count, flags);
 	return PFN2ADDR(pfn);
 }
 
+/** Allocate frames of physical memory near the current processor.
+ *
+ * Zones on the memory node of the current processor are preferred, other
+ * nodes are used in the order of their distance.
+ *
+ * @param count      Number of continuous frames to allocate.
+ * @param flags      Flags for host zone selection and address processing.
+ * @param constraint Indication of physical address bits that cannot be
+ *                   set in the address of the first allocated frame.
+ * @param pzone      Preferred zone.
+ *
+ * @return Physical address of the allocated frame.
+ *
+ */
+uintptr_t frame_alloc_generic(size_t count, frame_flags_t flags,
+    uintptr_t constraint, size_t *pzone)
+{
+	return frame_alloc_internal(count, flags, constraint, pzone,
+	    CPU ? CPU->node : NUMA_NODE_ANY);
+}
+
+/** Allocate frames of physical memory near a memory node.
+ *
+ * Zones on the given memory node are preferred, other nodes are used
+ * in the order of their distance from the given node.
+ *
+ * @param count      Number of continuous frames to allocate.
+ * @param flags      Flags for host zone selection and address processing.
+ * @param constraint Indication of physical address bits that cannot be
+ *                   set in the address of the first allocated frame.
+ * @param node       Preferred memory node or NUMA_NODE_ANY.
+ *
+ * @return Physical address of the allocated frame.
+ *
+ */
+uintptr_t frame_alloc_node(size_t count, frame_flags_t flags,
+    uintptr_t constraint, unsigned int node)
+{
+	if ((node != NUMA_NODE_ANY) && (node >= numa_node_count()))
+		node = NUMA_NODE_ANY;
+
+	return frame_alloc_internal(count, flags, constraint, NULL, node);
+}
+
 uintptr_t frame_alloc(size_t count, frame_flags_t flags, uintptr_t constraint)
 {
 	return frame_alloc_generic(count, flags, constraint, NULL);
@@ -976,6 +1484,16 @@ void frame_free_generic(uintptr_t start, size_t count, frame_flags_t flags)
 {
 	size_t freed = 0;
 
+	if (count == 1) {
+		int rc = frame_cpucache_free(ADDR2PFN(start));
+		if (rc >= 0) {
+			if (!(flags & FRAME_NO_RESERVE))
+				reserve_free(rc);
+
+			return;
+		}
+	}
+
 	irq_spinlock_lock(&zones.lock, true);
 
 	for (size_t i = 0; i < count; i++) {
@@ -1080,6 +1598,7 @@ void frame_init(void)
 	if (config.cpu_active == 1) {
 		zones.count = 0;
 		irq_spinlock_initialize(&zones.lock, "frame.zones.lock");
+		irq_spinlock_stats_register(&zones.lock);
 		mutex_initialize(&mem_avail_mtx, MUTEX_ACTIVE);
 		condvar_initialize(&mem_avail_cv);
 	}
@@ -1191,6 +1710,48 @@ void zones_stats(uint64_t *total, uint64_t *unavail, uint64_t *busy,
 	}
 
 	irq_spinlock_unlock(&zones.lock, true);
+
+	/* Frames in the per-CPU caches are accounted as busy in the zones */
+	uint64_t cached = (uint64_t) FRAMES2SIZE(frame_cpucache_count());
+	cached = min(cached, *busy);
+	*busy -= cached;
+	*free += cached;
+}
+
+/** Get statistics of a memory node.
+ *
+ * Frames held in the per-CPU caches are accounted as busy.
+ *
+ * @param node  Memory node.
+ * @param total Place to store the total size of the available zones.
+ * @param busy  Place to store the size of the allocated memory.
+ * @param free  Place to store the size of the free memory.
+ *
+ */
+void zones_node_stats(unsigned int node, uint64_t *total, uint64_t *busy,
+    uint64_t *free)
+{
+	assert(total != NULL);
+	assert(busy != NULL);
+	assert(free != NULL);
+
+	irq_spinlock_lock(&zones.lock, true);
+
+	*total = 0;
+	*busy = 0;
+	*free = 0;
+
+	for (size_t i = 0; i < zones.count; i++) {
+		if ((!(zones.info[i].flags & ZONE_AVAILABLE)) ||
+		    (zones.info[i].node != node))
+			continue;
+
+		*total += (uint64_t) FRAMES2SIZE(zones.info[i].count);
+		*busy += (uint64_t) FRAMES2SIZE(zones.info[i].busy_count);
+		*free += (uint64_t) FRAMES2SIZE(zones.info[i].free_count);
+	}
+
+	irq_spinlock_unlock(&zones.lock, true);
 }
 
 /** Prints list of zones.
@@ -1199,11 +1760,11 @@ void zones_stats(uint64_t *total, uint64_t *unavail, uint64_t *busy,
 void zones_print_list(void)
 {
 #ifdef __32_BITS__
-	printf("[nr] [base addr] [frames    ] [flags ] [free frames ] [busy frames ]\n");
+	printf("[nr] [base addr] [frames    ] [flags ] [node] [free frames ] [busy frames ]\n");
 #endif
 
 #ifdef __64_BITS__
-	printf("[nr] [base address    ] [frames    ] [flags ] [free frames ] [busy frames ]\n");
+	printf("[nr] [base address    ] [frames    ] [flags ] [node] [free frames ] [busy frames ]\n");
 #endif
 
 	/*
@@ -1220,6 +1781,7 @@ void zones_print_list(void)
 	size_t free_lowmem = 0;
 	size_t free_highmem = 0;
 	size_t free_highprio = 0;
+	size_t free_node[NUMA_NODES_MAX] = { 0 };
 
 	for (size_t i = 0; ; i++) {
 		irq_spinlock_lock(&zones.lock, true);
@@ -1235,6 +1797,7 @@ void zones_print_list(void)
 		zone_flags_t flags = zones.info[i].flags;
 		size_t free_count = zones.info[i].free_count;
 		size_t busy_count = zones.info[i].busy_count;
+		unsigned int node = zones.info[i].node;
 
 		bool available = ((flags & ZONE_AVAILABLE) != 0);
 		bool lowmem = ((flags & ZONE_LOWMEM) != 0);
@@ -1248,6 +1811,9 @@ void zones_print_list(void)
 			if (highmem)
 				free_highmem += free_count;
 
+			if (node < NUMA_NODES_MAX)
+				free_node[node] += free_count;
+
 			if (highprio) {
 				free_highprio += free_count;
 			} else {
@@ -1287,7 +1853,7 @@ void zones_print_list(void)
 		    (flags & ZONE_HIGHMEM) ? 'H' : '-');
 
 		if (available)
-			printf("%14zu %14zu",
+			printf("%6u %14zu %14zu", node,
 			    free_count, busy_count);
 
 		printf("\n");
@@ -1312,6 +1878,16 @@ void zones_print_list(void)
 	    false);
 	printf("Available high priority: %zu frames (%" PRIu64 " %s)\n",
 	    free_highprio, size, size_suffix);
+
+	unsigned int nodes = numa_node_count();
+	if (nodes > 1) {
+		for (unsigned int node = 0; node < nodes; node++) {
+			bin_order_suffix(FRAMES2SIZE(free_node[node]), &size,
+			    &size_suffix, false);
+			printf("Available on node %-2u:   %zu frames (%" PRIu64
+			    " %s)\n", node, free_node[node], size, size_suffix);
+		}
+	}
 }
 
 /** Prints zone details.
@@ -1347,6 +1923,7 @@ void zone_print_one(size_t num)
 	size_t count = zones.info[znum].count;
 	size_t free_count = zones.info[znum].free_count;
 	size_t busy_count = zones.info[znum].busy_count;
+	unsigned int node = zones.info[znum].node;
 
 	bool available = ((flags & ZONE_AVAILABLE) != 0);
 	bool lowmem = ((flags & ZONE_LOWMEM) != 0);
@@ -1396,6 +1973,7 @@ void zone_print_one(size_t num)
 	    (flags & ZONE_FIRMWARE) ? 'F' : '-',
 	    (flags & ZONE_LOWMEM) ? 'L' : '-',
 	    (flags & ZONE_HIGHMEM) ? 'H' : '-');
+	printf("Zone node:               %u\n", node);
 
 	if (available) {
 		bin_order_suffix(FRAMES2SIZE(busy_count), &size, &size_suffix,
@@ -49,9 +49,35 @@
 #include <macros.h>
 #include <bitops.h>
 #include <proc/thread.h>
+#include <cpu.h>
+#include <stdlib.h>
+#include <synch/spinlock.h>
 
 static ra_arena_t *km_ni_arena;
 
+/** Number of temporary page slots in each per-CPU window. */
+#define KM_WINDOW_PAGES	32
+
+/** Per-CPU window of temporary pages.
+ *
+ * Temporary pages of high memory frames are mapped into a window of the
+ * current processor instead of being allocated from the arena. Mappings of
+ * returned slots are removed in batches by a single TLB shootdown before
+ * the slots are used again.
+ */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	/** Bit mask of free slots without a mapping. */
+	uint32_t clean;
+	/** Bit mask of free slots whose stale mappings must be removed. */
+	uint32_t dirty;
+} km_window_t;
+
+/** Per-CPU windows, NULL until km_enable_cpucache() is called. */
+static km_window_t *km_windows = NULL;
+/** Base of the virtual range covered by the windows of all processors. */
+static uintptr_t km_windows_base;
+
 #define DEFERRED_PAGES_MAX	(PAGE_SIZE / sizeof(uintptr_t))
 
 /** Number of freed pages in the deferred buffer. */
@@ -232,6 +258,144 @@ static void km_unmap_deferred(uintptr_t page)
 	page_table_unlock(AS_KERNEL, true);
 }
 
+/** Remove stale mappings of slots of a temporary page window.
+ *
+ * @param cpu   Processor owning the window
+ * @param slots Bit mask of slots to unmap
+ */
+static void km_window_flush(size_t cpu, uint32_t slots)
+{
+	uintptr_t base = km_windows_base + cpu * KM_WINDOW_PAGES * PAGE_SIZE;
+	ipl_t ipl;
+
+	page_table_lock(AS_KERNEL, true);
+
+	ipl = tlb_shootdown_start(TLB_INVL_ASID, ASID_KERNEL, 0, 0);
+
+	for (unsigned i = 0; i < KM_WINDOW_PAGES; i++) {
+		if (slots & (UINT32_C(1) << i))
+			page_mapping_remove(AS_KERNEL, base + i * PAGE_SIZE);
+	}
+
+	tlb_invalidate_asid(ASID_KERNEL);
+
+	as_invalidate_translation_cache(AS_KERNEL, 0, -1);
+	tlb_shootdown_finalize(ipl);
+	page_table_unlock(AS_KERNEL, true);
+}
+
+/** Map a frame into a slot of the window of the current processor.
+ *
+ * @param frame Physical address of the frame
+ * @return Virtual address of the mapping or 0 if the window is full.
+ */
+static uintptr_t km_window_map(uintptr_t frame)
+{
+	uintptr_t page = 0;
+	km_window_t *window;
+	uint32_t dirty;
+	size_t cpu;
+
+	ipl_t ipl = interrupts_disable();
+	cpu = CPU->id;
+	window = &km_windows[cpu];
+	irq_spinlock_lock(&window->lock, false);
+
+	if ((window->clean == 0) && (window->dirty != 0)) {
+		/*
+		 * Recycle the returned slots. The window lock must not be held
+		 * during the TLB shootdown.
+		 */
+		dirty = window->dirty;
+		window->dirty = 0;
+		irq_spinlock_unlock(&window->lock, false);
+		interrupts_restore(ipl);
+
+		km_window_flush(cpu, dirty);
+
+		ipl = interrupts_disable();
+		irq_spinlock_lock(&window->lock, false);
+		window->clean |= dirty;
+	}
+
+	if (window->clean != 0) {
+		unsigned slot = fnzb32(window->clean & (~window->clean + 1));
+		window->clean &= ~(UINT32_C(1) << slot);
+		page = km_windows_base +
+		    (cpu * KM_WINDOW_PAGES + slot) * PAGE_SIZE;
+	}
+
+	irq_spinlock_unlock(&window->lock, false);
+	interrupts_restore(ipl);
+
+	if (page != 0) {
+		page_table_lock(AS_KERNEL, true);
+		page_mapping_insert(AS_KERNEL, page, frame,
+		    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+		page_table_unlock(AS_KERNEL, true);
+	}
+
+	return page;
+}
+
+/** Return a temporary page to the window it belongs to.
+ *
+ * @param page Virtual address of the temporary page
+ * @return True if the page belongs to a window, false otherwise.
+ */
+static bool km_window_unmap(uintptr_t page)
+{
+	if ((km_windows == NULL) || (!iswithin(km_windows_base,
+	    config.cpu_count * KM_WINDOW_PAGES * PAGE_SIZE, page, PAGE_SIZE)))
+		return false;
+
+	size_t idx = (page - km_windows_base) / PAGE_SIZE;
+	km_window_t *window = &km_windows[idx / KM_WINDOW_PAGES];
+
+	irq_spinlock_lock(&window->lock, true);
+	window->dirty |= UINT32_C(1) << (idx % KM_WINDOW_PAGES);
+	irq_spinlock_unlock(&window->lock, true);
+
+	return true;
+}
+
+/** Enable per-CPU caching of kernel virtual memory.
+ *
+ * Small allocations from the non-identity arena are served by per-CPU
+ * quantum caches and each processor gets its own window of temporary
+ * pages. Must be called after the number of processors is known. When
+ * memory is short, the kernel simply keeps using the shared arena.
+ */
+void km_enable_cpucache(void)
+{
+	km_window_t *windows;
+	uintptr_t base;
+
+	if (!config.non_identity_configured)
+		return;
+
+	(void) ra_arena_qcache_enable(km_ni_arena, PAGE_SIZE);
+
+	windows = malloc(sizeof(km_window_t) * config.cpu_count);
+	if (!windows)
+		return;
+
+	if (!ra_alloc(km_ni_arena, config.cpu_count * KM_WINDOW_PAGES *
+	    PAGE_SIZE, PAGE_SIZE, &base)) {
+		free(windows);
+		return;
+	}
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_initialize(&windows[i].lock, "km.window.lock");
+		windows[i].clean = UINT32_MAX;
+		windows[i].dirty = 0;
+	}
+
+	km_windows_base = base;
+	km_windows = windows;
+}
+
 /** Create a temporary page.
  *
  * The page is mapped read/write to a newly allocated frame of physical memory.
@@ -258,8 +422,11 @@ uintptr_t km_temporary_page_get(uintptr_t *framep, frame_flags_t flags)
 
 	frame = frame_alloc(1, FRAME_HIGHMEM | flags, 0);
 	if (frame >= config.identity_size) {
-		page = km_map(frame, PAGE_SIZE, PAGE_SIZE,
-		    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+		page = (km_windows != NULL) ? km_window_map(frame) : 0;
+		if (page == 0) {
+			page = km_map(frame, PAGE_SIZE, PAGE_SIZE,
+			    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+		}
 	} else {
 		page = PA2KA(frame);
 	}
@@ -280,6 +447,9 @@ void km_temporary_page_put(uintptr_t page)
 {
 	assert(THREAD);
 
+	if (km_window_unmap(page))
+		return;
+
 	if (km_is_non_identity(page))
 		km_unmap_deferred(page);
 }
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_generic_mm
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Memory node topology.
+ *
+ * The architecture or firmware code describes which physical memory ranges
+ * and which processors belong to which memory node and how distant the
+ * nodes are from each other. The frame allocator uses this information to
+ * tag the zones with nodes and to prefer memory local to the processor.
+ *
+ * The topology is only modified during early boot on the bootstrap
+ * processor and is read-only afterwards, therefore no locking is needed.
+ */
+
+#include <assert.h>
+#include <mm/numa.h>
+#include <mm/frame.h>
+#include <macros.h>
+#include <log.h>
+#include <align.h>
+#include <inttypes.h>
+
+/** Memory range with known node affinity. */
+typedef struct {
+	pfn_t base;
+	size_t count;
+	unsigned int node;
+} numa_range_t;
+
+/** Processor with known node affinity. */
+typedef struct {
+	uint32_t hwid;
+	unsigned int node;
+} numa_cpu_t;
+
+/** Firmware proximity domains of the nodes. */
+static uint32_t numa_domains[NUMA_NODES_MAX];
+static unsigned int numa_nodes = 0;
+
+static numa_range_t numa_ranges[NUMA_RANGES_MAX];
+static size_t numa_range_count = 0;
+
+static numa_cpu_t numa_cpus[NUMA_CPUS_MAX];
+static size_t numa_cpu_count = 0;
+
+/** Node distances, zero means unknown. */
+static uint8_t numa_distances[NUMA_NODES_MAX][NUMA_NODES_MAX];
+
+/** Find node of a firmware proximity domain.
+ *
+ * @param domain Firmware proximity domain.
+ *
+ * @return Node number or NUMA_NODE_ANY if the domain is not known.
+ *
+ */
+unsigned int numa_node_find(uint32_t domain)
+{
+	for (unsigned int node = 0; node < numa_nodes; node++) {
+		if (numa_domains[node] == domain)
+			return node;
+	}
+
+	return NUMA_NODE_ANY;
+}
+
+/** Get node for a firmware proximity domain.
+ *
+ * The nodes are numbered densely in the order in which the proximity
+ * domains are first seen.
+ *
+ * @param domain Firmware proximity domain.
+ *
+ * @return Node number or NUMA_NODE_ANY if there are too many nodes.
+ *
+ */
+unsigned int numa_node_get(uint32_t domain)
+{
+	unsigned int node = numa_node_find(domain);
+	if (node != NUMA_NODE_ANY)
+		return node;
+
+	if (numa_nodes == NUMA_NODES_MAX) {
+		log(LF_OTHER, LVL_WARN, "Too many memory nodes, proximity "
+		    "domain %" PRIu32 " ignored.", domain);
+		return NUMA_NODE_ANY;
+	}
+
+	numa_domains[numa_nodes] = domain;
+	return numa_nodes++;
+}
+
+/** Get number of memory nodes.
+ *
+ * @return Number of nodes, at least one.
+ *
+ */
+unsigned int numa_node_count(void)
+{
+	return max(numa_nodes, 1U);
+}
+
+/** Register memory range affinity.
+ *
+ * @param base Physical base address of the range.
+ * @param size Size of the range in bytes.
+ * @param node Node the range belongs to.
+ *
+ */
+void numa_memory_add(uint64_t base, uint64_t size, unsigned int node)
+{
+	if ((node >= NUMA_NODES_MAX) || (size == 0))
+		return;
+
+	if (numa_range_count == NUMA_RANGES_MAX) {
+		log(LF_OTHER, LVL_WARN, "Too many memory affinity ranges.");
+		return;
+	}
+
+	pfn_t pfn = ADDR2PFN(ALIGN_DOWN(base, FRAME_SIZE));
+	size_t count = SIZE2FRAMES(size + (base - PFN2ADDR(pfn)));
+
+	/* Keep the ranges sorted by base */
+	size_t i = numa_range_count;
+	while ((i > 0) && (numa_ranges[i - 1].base > pfn)) {
+		numa_ranges[i] = numa_ranges[i - 1];
+		i--;
+	}
+
+	numa_ranges[i].base = pfn;
+	numa_ranges[i].count = count;
+	numa_ranges[i].node = node;
+	numa_range_count++;
+}
+
+/** Register processor affinity.
+ *
+ * @param hwid Hardware processor ID (e.g. the local APIC ID).
+ * @param node Node the processor belongs to.
+ *
+ */
+void numa_cpu_add(uint32_t hwid, unsigned int node)
+{
+	if (node >= NUMA_NODES_MAX)
+		return;
+
+	if (numa_cpu_count == NUMA_CPUS_MAX) {
+		log(LF_OTHER, LVL_WARN, "Too many processor affinity entries.");
+		return;
+	}
+
+	numa_cpus[numa_cpu_count].hwid = hwid;
+	numa_cpus[numa_cpu_count].node = node;
+	numa_cpu_count++;
+}
+
+/** Set distance of two nodes.
+ *
+ * @param from     Source node.
+ * @param to       Destination node.
+ * @param distance Relative distance, NUMA_DISTANCE_LOCAL being the distance
+ *                 of a node from itself.
+ *
+ */
+void numa_distance_set(unsigned int from, unsigned int to, uint8_t distance)
+{
+	if ((from < NUMA_NODES_MAX) && (to < NUMA_NODES_MAX))
+		numa_distances[from][to] = distance;
+}
+
+/** Get node of a range of frames.
+ *
+ * @param pfn   First frame of the range.
+ * @param count Number of frames in the range.
+ * @param node  Place to store the node of the first frame.
+ *
+ * @return Number of frames from the beginning of the range which belong
+ *         to the same node as the first frame.
+ *
+ */
+size_t numa_pfn_node(pfn_t pfn, size_t count, unsigned int *node)
+{
+	*node = 0;
+
+	for (size_t i = 0; i < numa_range_count; i++) {
+		numa_range_t *range = &numa_ranges[i];
+
+		if (pfn < range->base) {
+			/* Unknown affinity up to the next range */
+			return min(count, range->base - pfn);
+		}
+
+		if (pfn < range->base + range->count) {
+			*node = range->node;
+			return min(count, range->base + range->count - pfn);
+		}
+	}
+
+	return count;
+}
+
+/** Get node of a processor.
+ *
+ * @param hwid Hardware processor ID.
+ *
+ * @return Node of the processor, node 0 if the affinity is not known.
+ *
+ */
+unsigned int numa_cpu_node(uint32_t hwid)
+{
+	for (size_t i = 0; i < numa_cpu_count; i++) {
+		if (numa_cpus[i].hwid == hwid)
+			return numa_cpus[i].node;
+	}
+
+	return 0;
+}
+
+/** Get distance of two nodes.
+ *
+ * @param from Source node.
+ * @param to   Destination node.
+ *
+ * @return Relative distance of the nodes.
+ *
+ */
+uint8_t numa_distance(unsigned int from, unsigned int to)
+{
+	assert(from < NUMA_NODES_MAX);
+	assert(to < NUMA_NODES_MAX);
+
+	if (numa_distances[from][to] != 0)
+		return numa_distances[from][to];
+
+	return (from == to) ? NUMA_DISTANCE_LOCAL : NUMA_DISTANCE_REMOTE;
+}
+
+/** Get nodes ordered by distance.
+ *
+ * @param node  Node to measure the distance from.
+ * @param order Array of at least NUMA_NODES_MAX elements to store the
+ *              nodes in, the closest first.
+ *
+ * @return Number of nodes stored.
+ *
+ */
+size_t numa_nodes_by_distance(unsigned int node, unsigned int *order)
+{
+	unsigned int count = numa_node_count();
+
+	assert(node < count);
+
+	/* Insertion sort, there are only a few nodes */
+	for (unsigned int i = 0; i < count; i++) {
+		unsigned int j = i;
+		while ((j > 0) && (numa_distance(node, order[j - 1]) >
+		    numa_distance(node, i))) {
+			order[j] = order[j - 1];
+			j--;
+		}
+
+		order[j] = i;
+	}
+
+	return count;
+}
+
+/** @}
+ */
@@ -109,6 +109,45 @@ _NO_TRACE void page_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 	memory_barrier();
 }
 
+/** Test whether large page mappings are supported.
+ *
+ * @return True if page_mapping_insert_large() can be used.
+ *
+ */
+_NO_TRACE bool page_mapping_large_supported(void)
+{
+	assert(page_mapping_operations);
+
+	return (page_mapping_operations->mapping_insert_large != NULL);
+}
+
+/** Insert mapping of large page to frame.
+ *
+ * Map naturally aligned virtual large page to naturally aligned physical
+ * frames using flags. The mapping is split into base page mappings when
+ * any of its base pages is remapped or removed.
+ *
+ * @param as    Address space to which page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the first frame to which the mapping
+ *              is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+_NO_TRACE void page_mapping_insert_large(as_t *as, uintptr_t page,
+    uintptr_t frame, unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	assert(page_mapping_operations);
+	assert(page_mapping_operations->mapping_insert_large);
+
+	page_mapping_operations->mapping_insert_large(as, page, frame, flags);
+
+	/* Repel prefetched accesses to the old mapping. */
+	memory_barrier();
+}
+
 /** Remove mapping of page.
  *
  * Remove any mapping of page within address space as.
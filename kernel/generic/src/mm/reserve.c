@@ -42,12 +42,36 @@
 #include <synch/spinlock.h>
 #include <typedefs.h>
 #include <arch/types.h>
+#include <arch.h>
+#include <config.h>
+#include <cpu.h>
+#include <panic.h>
+#include <stdlib.h>
+
+/** Number of frames a processor borrows from the global reserve at once. */
+#define RESERVE_BATCH	64
+
+/** Number of cached frames above which a processor returns the excess. */
+#define RESERVE_CACHE_MAX	(2 * RESERVE_BATCH)
 
 static bool reserve_initialized = false;
 
 IRQ_SPINLOCK_STATIC_INITIALIZE_NAME(reserve_lock, "reserve_lock");
 static ssize_t reserve = 0;
 
+/** Per-CPU batch of reserved frames.
+ *
+ * The frames of the batch are already subtracted from the global reserve
+ * and can be handed out without taking the global lock.
+ */
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	size_t cached;
+} reserve_cpu_t;
+
+/** Per-CPU batches, NULL until reserve_enable_cpucache() is called. */
+static reserve_cpu_t *reserve_cpus = NULL;
+
 /** Initialize memory reservations tracking.
  *
  * This function must be called after frame zones are created and merged
@@ -59,52 +83,140 @@ void reserve_init(void)
 	reserve_initialized = true;
 }
 
-/** Try to reserve memory.
+/** Enable per-CPU batches of reserved frames.
  *
- * This function may not be called from contexts that do not allow memory
- * reclaiming, such as some invocations of frame_alloc_generic().
+ * Must be called after the number of processors is known.
+ */
+void reserve_enable_cpucache(void)
+{
+	reserve_cpu_t *cpus = malloc(sizeof(reserve_cpu_t) * config.cpu_count);
+	if (!cpus)
+		panic("Cannot allocate per-CPU reservation batches.");
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_initialize(&cpus[i].lock, "reserve.cpu.lock");
+		cpus[i].cached = 0;
+	}
+
+	reserve_cpus = cpus;
+}
+
+/** Get the batch of the current processor.
+ *
+ * Assume interrupts are disabled.
+ *
+ * @return Batch of the current processor or NULL if there is none.
+ */
+static reserve_cpu_t *reserve_cpu_get(void)
+{
+	if ((!reserve_cpus) || (!CPU))
+		return NULL;
+
+	return &reserve_cpus[CPU->id];
+}
+
+/** Take reserved frames from the batch of the current processor.
+ *
+ * If the batch does not suffice, the rest is borrowed from the global
+ * reserve together with a new batch, as long as the global reserve allows.
  *
  * @param size		Number of frames to reserve.
  * @return		True on success or false otherwise.
  */
-bool reserve_try_alloc(size_t size)
+static bool reserve_take(size_t size)
 {
 	bool reserved = false;
 
-	assert(reserve_initialized);
+	ipl_t ipl = interrupts_disable();
+	reserve_cpu_t *rcpu = reserve_cpu_get();
 
-	irq_spinlock_lock(&reserve_lock, true);
-	if (reserve >= 0 && (size_t) reserve >= size) {
-		reserve -= size;
-		reserved = true;
-	} else {
-		/*
-		 * Some reservable frames may be cached by the slab allocator.
-		 * Try to reclaim some reservable memory. Try to be gentle for
-		 * the first time. If it does not help, try to reclaim
-		 * everything.
-		 */
-		irq_spinlock_unlock(&reserve_lock, true);
-		slab_reclaim(0);
-		irq_spinlock_lock(&reserve_lock, true);
-		if (reserve >= 0 && (size_t) reserve >= size) {
-			reserve -= size;
-			reserved = true;
-		} else {
-			irq_spinlock_unlock(&reserve_lock, true);
-			slab_reclaim(SLAB_RECLAIM_ALL);
-			irq_spinlock_lock(&reserve_lock, true);
-			if (reserve >= 0 && (size_t) reserve >= size) {
-				reserve -= size;
-				reserved = true;
-			}
+	if (rcpu) {
+		irq_spinlock_lock(&rcpu->lock, false);
+		if (rcpu->cached >= size) {
+			rcpu->cached -= size;
+			irq_spinlock_unlock(&rcpu->lock, false);
+			interrupts_restore(ipl);
+			return true;
 		}
 	}
-	irq_spinlock_unlock(&reserve_lock, true);
+
+	size_t cached = rcpu ? rcpu->cached : 0;
+	size_t need = size - cached;
+
+	irq_spinlock_lock(&reserve_lock, false);
+	if (reserve >= 0 && (size_t) reserve >= need) {
+		size_t batch = rcpu ? min((size_t) reserve - need,
+		    (size_t) RESERVE_BATCH) : 0;
+
+		reserve -= need + batch;
+		if (rcpu)
+			rcpu->cached = batch;
+		reserved = true;
+	}
+	irq_spinlock_unlock(&reserve_lock, false);
+
+	if (rcpu)
+		irq_spinlock_unlock(&rcpu->lock, false);
+	interrupts_restore(ipl);
 
 	return reserved;
 }
 
+/** Return the batches of all processors to the global reserve.
+ *
+ * Used before failing a reservation so that the accounting stays exact.
+ */
+static void reserve_drain_all(void)
+{
+	if (!reserve_cpus)
+		return;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_lock(&reserve_cpus[i].lock, true);
+		irq_spinlock_lock(&reserve_lock, false);
+		reserve += reserve_cpus[i].cached;
+		reserve_cpus[i].cached = 0;
+		irq_spinlock_unlock(&reserve_lock, false);
+		irq_spinlock_unlock(&reserve_cpus[i].lock, true);
+	}
+}
+
+/** Try to reserve memory.
+ *
+ * This function may not be called from contexts that do not allow memory
+ * reclaiming, such as some invocations of frame_alloc_generic().
+ *
+ * @param size		Number of frames to reserve.
+ * @return		True on success or false otherwise.
+ */
+bool reserve_try_alloc(size_t size)
+{
+	assert(reserve_initialized);
+
+	if (reserve_take(size))
+		return true;
+
+	/*
+	 * Other processors may hold reservable frames in their batches.
+	 */
+	reserve_drain_all();
+	if (reserve_take(size))
+		return true;
+
+	/*
+	 * Some reservable frames may be cached by the slab allocator.
+	 * Try to reclaim some reservable memory. Try to be gentle for
+	 * the first time. If it does not help, try to reclaim
+	 * everything.
+	 */
+	slab_reclaim(0);
+	if (reserve_take(size))
+		return true;
+
+	slab_reclaim(SLAB_RECLAIM_ALL);
+	return reserve_take(size);
+}
+
 /** Reserve memory.
  *
  * This function simply marks the respective amount of memory frames reserved.
@@ -119,12 +231,34 @@ void reserve_force_alloc(size_t size)
 	if (!reserve_initialized)
 		return;
 
-	irq_spinlock_lock(&reserve_lock, true);
-	reserve -= size;
-	irq_spinlock_unlock(&reserve_lock, true);
+	ipl_t ipl = interrupts_disable();
+	reserve_cpu_t *rcpu = reserve_cpu_get();
+
+	if (rcpu) {
+		irq_spinlock_lock(&rcpu->lock, false);
+		if (rcpu->cached >= size) {
+			rcpu->cached -= size;
+			size = 0;
+		} else {
+			size -= rcpu->cached;
+			rcpu->cached = 0;
+		}
+		irq_spinlock_unlock(&rcpu->lock, false);
+	}
+
+	if (size > 0) {
+		irq_spinlock_lock(&reserve_lock, false);
+		reserve -= size;
+		irq_spinlock_unlock(&reserve_lock, false);
+	}
+
+	interrupts_restore(ipl);
 }
 
 /** Unreserve memory.
+ *
+ * The frames are kept in the batch of the current processor, only the
+ * excess over RESERVE_CACHE_MAX goes back to the global reserve.
  *
  * @param size		Number of frames to unreserve.
  */
@@ -133,9 +267,29 @@ void reserve_free(size_t size)
 	if (!reserve_initialized)
 		return;
 
-	irq_spinlock_lock(&reserve_lock, true);
-	reserve += size;
-	irq_spinlock_unlock(&reserve_lock, true);
+	ipl_t ipl = interrupts_disable();
+	reserve_cpu_t *rcpu = reserve_cpu_get();
+
+	if (rcpu) {
+		irq_spinlock_lock(&rcpu->lock, false);
+		rcpu->cached += size;
+		if (rcpu->cached > RESERVE_CACHE_MAX) {
+			size = rcpu->cached - RESERVE_BATCH;
+			rcpu->cached = RESERVE_BATCH;
+		} else {
+			size = 0;
+		}
+	}
+
+	if (size > 0) {
+		irq_spinlock_lock(&reserve_lock, false);
+		reserve += size;
+		irq_spinlock_unlock(&reserve_lock, false);
+	}
+
+	if (rcpu)
+		irq_spinlock_unlock(&rcpu->lock, false);
+	interrupts_restore(ipl);
 }
 
 /** @}
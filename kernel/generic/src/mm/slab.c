@@ -45,8 +45,6 @@
  *
  * Following features are not currently supported but would be easy to do:
  * @li cache coloring
- * @li dynamic magazine growing (different magazine sizes are already
- *     supported, but we would need to adjust allocation strategy)
  *
  * The slab allocator supports per-CPU caches ('magazines') to facilitate
  * good SMP scaling.
@@ -61,6 +59,16 @@
  * the object is deallocated into slab). If the magazine is full, it is
  * put into cpu-shared list of magazines and a new one is allocated.
  *
+ * The cpu-shared lists of full magazines ('depots') are kept per memory
+ * node. A CPU puts full magazines into the depot of its own node and
+ * takes them from the closest non-empty depot.
+ *
+ * Magazines are dynamically growing. Every cache counts how many times
+ * a depot lock was found contended and once the count reaches
+ * SLAB_MAG_CONTENTION_LIMIT, the size of newly allocated magazines is
+ * doubled (up to SLAB_MAG_SIZE_MAX), so that the CPUs go to the depot
+ * less often. The magazine size is reset when all memory is reclaimed.
+ *
  * The CPU-bound magazine is actually a pair of magazines in order to avoid
  * thrashing when somebody is allocating/deallocating 1 item at the magazine
  * size boundary. LIFO order is enforced, which should avoid fragmentation
@@ -120,8 +128,16 @@
 IRQ_SPINLOCK_STATIC_INITIALIZE(slab_cache_lock);
 static LIST_INITIALIZE(slab_cache_list);
 
-/** Magazine cache */
-static slab_cache_t mag_cache;
+/** Magazine caches, one for each magazine size */
+static slab_cache_t mag_cache[SLAB_MAG_SIZES];
+
+static const char *mag_cache_names[SLAB_MAG_SIZES] = {
+	"slab_magazine_t/4",
+	"slab_magazine_t/8",
+	"slab_magazine_t/16",
+	"slab_magazine_t/32",
+	"slab_magazine_t/64"
+};
 
 /** Cache for cache descriptors */
 static slab_cache_t slab_cache_cache;
@@ -326,7 +342,40 @@ _NO_TRACE static void *slab_obj_create(slab_cache_t *cache, unsigned int flags)
 /* CPU-Cache slab functions */
 /****************************/
 
+/** Return magazine cache for magazines of given size */
+_NO_TRACE static slab_cache_t *magazine_cache(size_t size)
+{
+	size_t idx = fnzb(size) - fnzb(SLAB_MAG_SIZE);
+
+	assert(idx < SLAB_MAG_SIZES);
+	return &mag_cache[idx];
+}
+
+/** Lock depot of a cache, account for contention
+ *
+ */
+_NO_TRACE static ipl_t depot_lock(slab_cache_t *cache, slab_depot_t *depot)
+{
+	ipl_t ipl = interrupts_disable();
+
+	if (!irq_spinlock_trylock(&depot->lock)) {
+		atomic_inc(&cache->mag_contention);
+		irq_spinlock_lock(&depot->lock, false);
+	}
+
+	return ipl;
+}
+
+_NO_TRACE static void depot_unlock(slab_depot_t *depot, ipl_t ipl)
+{
+	irq_spinlock_unlock(&depot->lock, false);
+	interrupts_restore(ipl);
+}
+
 /** Find a full magazine in cache, take it from list and return it
+ *
+ * The depot of the local node is tried first, then the depots
+ * of the other nodes in the order of their distance.
  *
  * @param first If true, return first, else last mag.
  *
@@ -334,37 +383,69 @@ _NO_TRACE static void *slab_obj_create(slab_cache_t *cache, unsigned int flags)
 _NO_TRACE static slab_magazine_t *get_mag_from_cache(slab_cache_t *cache,
     bool first)
 {
-	slab_magazine_t *mag = NULL;
-	link_t *cur;
-
-	irq_spinlock_lock(&cache->maglock, true);
-	if (!list_empty(&cache->magazines)) {
-		if (first)
-			cur = list_first(&cache->magazines);
-		else
-			cur = list_last(&cache->magazines);
+	unsigned int order[NUMA_NODES_MAX];
+	size_t nodes = numa_nodes_by_distance(CPU ? CPU->node : 0, order);
+
+	for (size_t i = 0; i < nodes; i++) {
+		slab_depot_t *depot = &cache->depots[order[i]];
+		slab_magazine_t *mag = NULL;
+		link_t *cur;
+
+		ipl_t ipl = depot_lock(cache, depot);
+		if (!list_empty(&depot->magazines)) {
+			if (first)
+				cur = list_first(&depot->magazines);
+			else
+				cur = list_last(&depot->magazines);
+
+			mag = list_get_instance(cur, slab_magazine_t, link);
+			list_remove(&mag->link);
+			atomic_dec(&cache->magazine_counter);
+		}
+		depot_unlock(depot, ipl);
 
-		mag = list_get_instance(cur, slab_magazine_t, link);
-		list_remove(&mag->link);
-		atomic_dec(&cache->magazine_counter);
+		if (mag)
+			return mag;
 	}
-	irq_spinlock_unlock(&cache->maglock, true);
 
-	return mag;
+	return NULL;
 }
 
-/** Prepend magazine to magazine list in cache
+/** Prepend magazine to magazine list of the local depot in cache
  *
  */
 _NO_TRACE static void put_mag_to_cache(slab_cache_t *cache,
     slab_magazine_t *mag)
 {
-	irq_spinlock_lock(&cache->maglock, true);
+	slab_depot_t *depot = &cache->depots[CPU->node];
+	ipl_t ipl = depot_lock(cache, depot);
 
-	list_prepend(&mag->link, &cache->magazines);
+	list_prepend(&mag->link, &depot->magazines);
 	atomic_inc(&cache->magazine_counter);
 
-	irq_spinlock_unlock(&cache->maglock, true);
+	depot_unlock(depot, ipl);
+}
+
+/** Get size of a newly allocated magazine
+ *
+ * If the depots of the cache were contended too often since the
+ * last growth, grow the magazines.
+ *
+ */
+_NO_TRACE static size_t magazine_size(slab_cache_t *cache)
+{
+	size_t size = atomic_load(&cache->mag_size);
+
+	if ((size < SLAB_MAG_SIZE_MAX) &&
+	    (atomic_load(&cache->mag_contention) >= SLAB_MAG_CONTENTION_LIMIT)) {
+		if (atomic_compare_exchange_strong(&cache->mag_size, &size,
+		    size << 1)) {
+			atomic_store(&cache->mag_contention, 0);
+			size <<= 1;
+		}
+	}
+
+	return size;
 }
 
 /** Free all objects in magazine and free memory associated with magazine
@@ -383,7 +464,7 @@ _NO_TRACE static size_t magazine_destroy(slab_cache_t *cache,
 		atomic_dec(&cache->cached_objs);
 	}
 
-	slab_free(&mag_cache, mag);
+	slab_free(magazine_cache(mag->size), mag);
 
 	return frames;
 }
@@ -437,11 +518,13 @@ _NO_TRACE static void *magazine_obj_get(slab_cache_t *cache)
 
 	slab_magazine_t *mag = get_full_current_mag(cache);
 	if (!mag) {
+		cache->mag_cache[CPU->id].misses++;
 		irq_spinlock_unlock(&cache->mag_cache[CPU->id].lock, true);
 		return NULL;
 	}
 
 	void *obj = mag->objs[--mag->busy];
+	cache->mag_cache[CPU->id].hits++;
 	irq_spinlock_unlock(&cache->mag_cache[CPU->id].lock, true);
 
 	atomic_dec(&cache->cached_objs);
@@ -484,12 +567,13 @@ _NO_TRACE static slab_magazine_t *make_empty_current_mag(slab_cache_t *cache)
 	 * this would deadlock.
 	 *
 	 */
-	slab_magazine_t *newmag = slab_alloc(&mag_cache,
+	size_t size = magazine_size(cache);
+	slab_magazine_t *newmag = slab_alloc(magazine_cache(size),
 	    FRAME_ATOMIC | FRAME_NO_RECLAIM);
 	if (!newmag)
 		return NULL;
 
-	newmag->size = SLAB_MAG_SIZE;
+	newmag->size = size;
 	newmag->busy = 0;
 
 	/* Flush last to magazine list */
@@ -605,10 +689,16 @@ _NO_TRACE static void _slab_cache_create(slab_cache_t *cache, const char *name,
 
 	list_initialize(&cache->full_slabs);
 	list_initialize(&cache->partial_slabs);
-	list_initialize(&cache->magazines);
+
+	for (unsigned int i = 0; i < NUMA_NODES_MAX; i++) {
+		list_initialize(&cache->depots[i].magazines);
+		irq_spinlock_initialize(&cache->depots[i].lock,
+		    "slab.cache.depots[].lock");
+	}
+
+	atomic_store(&cache->mag_size, SLAB_MAG_SIZE);
 
 	irq_spinlock_initialize(&cache->slablock, "slab.cache.slablock");
-	irq_spinlock_initialize(&cache->maglock, "slab.cache.maglock");
 
 	if (!(cache->flags & SLAB_CACHE_NOMAGAZINE))
 		(void) make_magcache(cache);
@@ -698,6 +788,10 @@ _NO_TRACE static size_t _slab_reclaim(slab_cache_t *cache, unsigned int flags)
 
 			irq_spinlock_unlock(&cache->mag_cache[i].lock, true);
 		}
+
+		/* Start over with small magazines */
+		atomic_store(&cache->mag_size, SLAB_MAG_SIZE);
+		atomic_store(&cache->mag_contention, 0);
 	}
 
 	return frames;
@@ -807,7 +901,7 @@ size_t slab_reclaim(unsigned int flags)
 void slab_print_list(void)
 {
 	printf("[cache name      ] [size  ] [pages ] [obj/pg] [slabs ]"
-	    " [cached] [alloc ] [ctl]\n");
+	    " [cached] [alloc ] [mag] [hit%%] [ctl]\n");
 
 	size_t skip = 0;
 	while (true) {
@@ -860,23 +954,49 @@ void slab_print_list(void)
 		long cached_objs = atomic_load(&cache->cached_objs);
 		long allocated_objs = atomic_load(&cache->allocated_objs);
 		unsigned int flags = cache->flags;
+		size_t mag_size = atomic_load(&cache->mag_size);
+
+		/*
+		 * The per-CPU counters are read without locking,
+		 * the hit rate is only approximate.
+		 */
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+
+		if ((!(flags & SLAB_CACHE_NOMAGAZINE)) && (cache->mag_cache)) {
+			for (size_t cpu = 0; cpu < config.cpu_count; cpu++) {
+				hits += cache->mag_cache[cpu].hits;
+				misses += cache->mag_cache[cpu].misses;
+			}
+		}
 
 		irq_spinlock_unlock(&slab_cache_lock, true);
 
-		printf("%-18s %8zu %8zu %8zu %8ld %8ld %8ld %-5s\n",
-		    name, size, frames, objects, allocated_slabs,
-		    cached_objs, allocated_objs,
-		    flags & SLAB_CACHE_SLINSIDE ? "in" : "out");
+		printf("%-18s %8zu %8zu %8zu %8ld %8ld %8ld", name, size,
+		    frames, objects, allocated_slabs, cached_objs,
+		    allocated_objs);
+
+		if (flags & SLAB_CACHE_NOMAGAZINE)
+			printf("     -      -");
+		else if (hits + misses == 0)
+			printf(" %5zu      -", mag_size);
+		else
+			printf(" %5zu %5" PRIu64 "%%", mag_size,
+			    hits * 100 / (hits + misses));
+
+		printf(" %-5s\n", flags & SLAB_CACHE_SLINSIDE ? "in" : "out");
 	}
 }
 
 void slab_cache_init(void)
 {
-	/* Initialize magazine cache */
-	_slab_cache_create(&mag_cache, "slab_magazine_t",
-	    sizeof(slab_magazine_t) + SLAB_MAG_SIZE * sizeof(void *),
-	    sizeof(uintptr_t), NULL, NULL, SLAB_CACHE_NOMAGAZINE |
-	    SLAB_CACHE_SLINSIDE);
+	/* Initialize magazine caches */
+	for (size_t i = 0; i < SLAB_MAG_SIZES; i++) {
+		_slab_cache_create(&mag_cache[i], mag_cache_names[i],
+		    sizeof(slab_magazine_t) + (SLAB_MAG_SIZE << i) *
+		    sizeof(void *), sizeof(uintptr_t), NULL, NULL,
+		    SLAB_CACHE_NOMAGAZINE | SLAB_CACHE_SLINSIDE);
+	}
 
 	/* Initialize slab_cache cache */
 	_slab_cache_create(&slab_cache_cache, "slab_cache_cache",
@@ -35,12 +35,21 @@
  * @brief Generic TLB shootdown algorithm.
  *
  * The algorithm implemented here is based on the CMU TLB shootdown
- * algorithm and is further simplified (e.g. all CPUs receive all TLB
- * shootdown messages).
+ * algorithm and is further simplified (e.g. there is only one shootdown
+ * in progress at a time).
+ *
+ * Shootdowns relating to a user address space are only delivered to the
+ * processors which might hold translations of that address space, i.e.
+ * the processors which have had it active since they last flushed their
+ * TLB. Other processors are not waited for and the IPI is not sent at all
+ * if there is no recipient. Invalidation requests are queued per processor
+ * and adjacent or overlapping page ranges are merged.
  */
 
 #include <mm/tlb.h>
 #include <mm/asid.h>
+#include <mm/as.h>
+#include <mm/page.h>
 #include <arch/mm/tlb.h>
 #include <assert.h>
 #include <smp/ipi.h>
@@ -50,13 +59,53 @@
 #include <config.h>
 #include <arch.h>
 #include <panic.h>
+#include <macros.h>
 #include <cpu.h>
 
+/** Number of processors that can be tracked in as_t.tlb_cpus. */
+#define TLB_CPUS_TRACKED  (sizeof(size_t) * 8)
+
 void tlb_init(void)
 {
 	tlb_arch_init();
 }
 
+/** Invalidate TLB entries on the current processor.
+ *
+ * @param type  Type describing scope of invalidation.
+ * @param asid  Address space, if required by type.
+ * @param page  Virtual page address, if required by type.
+ * @param count Number of pages, if required by type.
+ *
+ */
+static void tlb_invalidate(tlb_invalidate_type_t type, asid_t asid,
+    uintptr_t page, size_t count)
+{
+	switch (type) {
+	case TLB_INVL_ALL:
+		tlb_invalidate_all();
+		break;
+	case TLB_INVL_ASID:
+		tlb_invalidate_asid(asid);
+		break;
+	case TLB_INVL_PAGES:
+		assert(count);
+
+		/*
+		 * Kernel mappings may be global and survive invalidation
+		 * of the address space.
+		 */
+		if ((count > TLB_INVL_PAGES_MAX) && (asid != ASID_KERNEL))
+			tlb_invalidate_asid(asid);
+		else
+			tlb_invalidate_pages(asid, page, count);
+		break;
+	default:
+		panic("Unknown type (%d).", type);
+		break;
+	}
+}
+
 #ifdef CONFIG_SMP
 
 /**
@@ -67,68 +116,197 @@ void tlb_init(void)
  */
 IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
 
-/** Send TLB shootdown message.
+/** A shootdown is in progress, see tlb_as_activate(). */
+static atomic_bool tlb_shootdown_pending = false;
+
+/** Message of the shootdown in progress started by tlb_shootdown_start(). */
+static tlb_shootdown_msg_t tlb_message;
+
+/** Test whether a processor might hold translations of an address space.
  *
- * This function attempts to deliver TLB shootdown message
- * to all other processors.
+ * @param cpu Processor.
+ * @param as  Address space or NULL for all address spaces.
+ *
+ * @return False if the processor holds no translations of the address space.
+ *
+ */
+static bool tlb_cpu_uses_as(cpu_t *cpu, as_t *as)
+{
+	if ((as == NULL) || (as == AS_KERNEL) || (cpu->id >= TLB_CPUS_TRACKED))
+		return true;
+
+	return (atomic_load(&as->tlb_cpus) & ((size_t) 1 << cpu->id)) != 0;
+}
+
+/** Queue TLB shootdown message to a processor.
+ *
+ * The message is merged with the already queued messages if possible.
+ * If the queue is full, it is replaced by a single TLB_INVL_ALL message.
  *
+ * @param cpu   Recipient processor, its lock must be held.
  * @param type  Type describing scope of shootdown.
  * @param asid  Address space, if required by type.
  * @param page  Virtual page address, if required by type.
  * @param count Number of pages, if required by type.
  *
+ */
+static void tlb_message_enqueue(cpu_t *cpu, tlb_invalidate_type_t type,
+    asid_t asid, uintptr_t page, size_t count)
+{
+	assert(irq_spinlock_locked(&cpu->lock));
+
+	if ((cpu->tlb_messages_count > 0) &&
+	    (cpu->tlb_messages[0].type == TLB_INVL_ALL))
+		return;
+
+	size_t i = 0;
+	while ((type != TLB_INVL_ALL) && (i < cpu->tlb_messages_count)) {
+		tlb_shootdown_msg_t *msg = &cpu->tlb_messages[i];
+
+		if (msg->asid != asid) {
+			i++;
+			continue;
+		}
+
+		/* The whole address space is already being invalidated */
+		if (msg->type == TLB_INVL_ASID)
+			return;
+
+		assert(msg->type == TLB_INVL_PAGES);
+
+		if (type == TLB_INVL_ASID) {
+			/* The page range is covered by the new message */
+			*msg = cpu->tlb_messages[--cpu->tlb_messages_count];
+			continue;
+		}
+
+		uintptr_t end = page + P2SZ(count);
+		uintptr_t msg_end = msg->page + P2SZ(msg->count);
+		if ((page <= msg_end) && (msg->page <= end)) {
+			/* Merge the ranges */
+			msg->page = min(msg->page, page);
+			msg->count = (max(msg_end, end) - msg->page) >>
+			    PAGE_WIDTH;
+			return;
+		}
+
+		i++;
+	}
+
+	if ((type == TLB_INVL_ALL) ||
+	    (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN)) {
+		/*
+		 * The message queue is full.
+		 * Erase the queue and store one TLB_INVL_ALL message.
+		 */
+		cpu->tlb_messages_count = 1;
+		cpu->tlb_messages[0].type = TLB_INVL_ALL;
+		cpu->tlb_messages[0].asid = ASID_INVALID;
+		cpu->tlb_messages[0].page = 0;
+		cpu->tlb_messages[0].count = 0;
+	} else {
+		/*
+		 * Enqueue the message.
+		 */
+		size_t idx = cpu->tlb_messages_count++;
+		cpu->tlb_messages[idx].type = type;
+		cpu->tlb_messages[idx].asid = asid;
+		cpu->tlb_messages[idx].page = page;
+		cpu->tlb_messages[idx].count = count;
+	}
+}
+
+/** Begin TLB shootdown sequence.
+ *
+ * Select the processors which might hold translations of the address
+ * space, interrupt them and wait until they stop using their TLBs.
+ *
+ * @param as Address space or NULL for all address spaces.
+ *
  * @return The interrupt priority level as it existed prior to this call.
  *
  */
-ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
-    uintptr_t page, size_t count)
+static ipl_t tlb_shootdown_begin(as_t *as)
 {
 	ipl_t ipl = interrupts_disable();
 	CPU->tlb_active = false;
 	irq_spinlock_lock(&tlblock, false);
 
-	size_t i;
-	for (i = 0; i < config.cpu_count; i++) {
-		if (i == CPU->id)
-			continue;
+	/*
+	 * Processors activating the address space from now on wait
+	 * for the end of the sequence in tlb_as_activate().
+	 */
+	atomic_store(&tlb_shootdown_pending, true);
+	memory_barrier();
 
-		cpu_t *cpu = &cpus[i];
+	bool recipients = false;
 
-		irq_spinlock_lock(&cpu->lock, false);
-		if (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN) {
-			/*
-			 * The message queue is full.
-			 * Erase the queue and store one TLB_INVL_ALL message.
-			 */
-			cpu->tlb_messages_count = 1;
-			cpu->tlb_messages[0].type = TLB_INVL_ALL;
-			cpu->tlb_messages[0].asid = ASID_INVALID;
-			cpu->tlb_messages[0].page = 0;
-			cpu->tlb_messages[0].count = 0;
-		} else {
-			/*
-			 * Enqueue the message.
-			 */
-			size_t idx = cpu->tlb_messages_count++;
-			cpu->tlb_messages[idx].type = type;
-			cpu->tlb_messages[idx].asid = asid;
-			cpu->tlb_messages[idx].page = page;
-			cpu->tlb_messages[idx].count = count;
+	/*
+	 * Recipients of previous shootdowns which have not processed
+	 * their messages yet stay selected.
+	 */
+	size_t i;
+	for (i = 0; i < config.cpu_count; i++) {
+		if ((i != CPU->id) && (tlb_cpu_uses_as(&cpus[i], as))) {
+			cpus[i].tlb_shootdown = true;
+			recipients = true;
 		}
-		irq_spinlock_unlock(&cpu->lock, false);
 	}
 
+	if (!recipients)
+		return ipl;
+
 	tlb_shootdown_ipi_send();
 
 busy_wait:
 	for (i = 0; i < config.cpu_count; i++) {
-		if (cpus[i].tlb_active)
+		if ((cpus[i].tlb_shootdown) && (cpus[i].tlb_active))
 			goto busy_wait;
 	}
 
 	return ipl;
 }
 
+/** End TLB shootdown sequence.
+ *
+ * Let the recipients process their message queues. The messages must be
+ * queued just before so that no recipient processes them while the page
+ * tables are still being changed.
+ *
+ */
+static void tlb_shootdown_end(void)
+{
+	atomic_store(&tlb_shootdown_pending, false);
+	irq_spinlock_unlock(&tlblock, false);
+	CPU->tlb_active = true;
+}
+
+/** Send TLB shootdown message.
+ *
+ * This function attempts to deliver TLB shootdown message
+ * to all other processors.
+ *
+ * @param type  Type describing scope of shootdown.
+ * @param asid  Address space, if required by type.
+ * @param page  Virtual page address, if required by type.
+ * @param count Number of pages, if required by type.
+ *
+ * @return The interrupt priority level as it existed prior to this call.
+ *
+ */
+ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
+    uintptr_t page, size_t count)
+{
+	ipl_t ipl = tlb_shootdown_begin(NULL);
+
+	tlb_message.type = type;
+	tlb_message.asid = asid;
+	tlb_message.page = page;
+	tlb_message.count = count;
+
+	return ipl;
+}
+
 /** Finish TLB shootdown sequence.
  *
  * @param ipl Previous interrupt priority level.
@@ -136,8 +314,20 @@ busy_wait:
  */
 void tlb_shootdown_finalize(ipl_t ipl)
 {
-	irq_spinlock_unlock(&tlblock, false);
-	CPU->tlb_active = true;
+	size_t i;
+	for (i = 0; i < config.cpu_count; i++) {
+		cpu_t *cpu = &cpus[i];
+
+		if (!cpu->tlb_shootdown)
+			continue;
+
+		irq_spinlock_lock(&cpu->lock, false);
+		tlb_message_enqueue(cpu, tlb_message.type, tlb_message.asid,
+		    tlb_message.page, tlb_message.count);
+		irq_spinlock_unlock(&cpu->lock, false);
+	}
+
+	tlb_shootdown_end();
 	interrupts_restore(ipl);
 }
 
@@ -153,8 +343,16 @@ void tlb_shootdown_ipi_recv(void)
 {
 	assert(CPU);
 
+	/*
+	 * The IPI is broadcast, ignore it if this processor is not
+	 * a recipient of the shootdown.
+	 */
+	if (!CPU->tlb_shootdown)
+		return;
+
 	CPU->tlb_active = false;
 	irq_spinlock_lock(&tlblock, false);
+	CPU->tlb_shootdown = false;
 	irq_spinlock_unlock(&tlblock, false);
 
 	irq_spinlock_lock(&CPU->lock, false);
@@ -162,28 +360,11 @@ void tlb_shootdown_ipi_recv(void)
 
 	size_t i;
 	for (i = 0; i < CPU->tlb_messages_count; i++) {
-		tlb_invalidate_type_t type = CPU->tlb_messages[i].type;
-		asid_t asid = CPU->tlb_messages[i].asid;
-		uintptr_t page = CPU->tlb_messages[i].page;
-		size_t count = CPU->tlb_messages[i].count;
-
-		switch (type) {
-		case TLB_INVL_ALL:
-			tlb_invalidate_all();
-			break;
-		case TLB_INVL_ASID:
-			tlb_invalidate_asid(asid);
-			break;
-		case TLB_INVL_PAGES:
-			assert(count);
-			tlb_invalidate_pages(asid, page, count);
-			break;
-		default:
-			panic("Unknown type (%d).", type);
-			break;
-		}
+		tlb_shootdown_msg_t *msg = &CPU->tlb_messages[i];
+
+		tlb_invalidate(msg->type, msg->asid, msg->page, msg->count);
 
-		if (type == TLB_INVL_ALL)
+		if (msg->type == TLB_INVL_ALL)
 			break;
 	}
 
@@ -192,7 +373,173 @@ void tlb_shootdown_ipi_recv(void)
 	CPU->tlb_active = true;
 }
 
+/** Note that the current processor starts using an address space.
+ *
+ * Must be called with interrupts disabled before the address space is
+ * installed. If a shootdown which has not selected this processor is in
+ * progress, wait for it to end so that no translations are loaded from
+ * page tables being changed.
+ *
+ * @param as Address space.
+ *
+ */
+void tlb_as_activate(as_t *as)
+{
+	assert(interrupts_disabled());
+
+	if ((as == AS_KERNEL) || (CPU->id >= TLB_CPUS_TRACKED))
+		return;
+
+	atomic_fetch_or(&as->tlb_cpus, (size_t) 1 << CPU->id);
+	memory_barrier();
+
+	if (atomic_load(&tlb_shootdown_pending)) {
+		CPU->tlb_active = false;
+		irq_spinlock_lock(&tlblock, false);
+		irq_spinlock_unlock(&tlblock, false);
+		CPU->tlb_active = true;
+	}
+}
+
+/** Note that the current processor stopped using an address space.
+ *
+ * Must be called after another address space has been installed. On
+ * architectures which flush the TLB when switching page tables, the
+ * processor holds no translations of the old address space any more.
+ *
+ * @param as Old address space.
+ *
+ */
+void tlb_as_deactivate(as_t *as)
+{
+#ifdef TLB_FLUSH_ON_SWITCH_ARCH
+	if ((!TLB_FLUSH_ON_SWITCH_ARCH) || (as == AS_KERNEL) ||
+	    (CPU->id >= TLB_CPUS_TRACKED))
+		return;
+
+	atomic_fetch_and(&as->tlb_cpus, ~((size_t) 1 << CPU->id));
+#endif
+}
+
 #endif /* CONFIG_SMP */
 
+/** Start a batch of TLB invalidations in an address space.
+ *
+ * The address space mappings can be changed until the batch
+ * is finalized by tlb_batch_finalize().
+ *
+ * @param batch Batch to start.
+ * @param as    Address space.
+ *
+ */
+void tlb_batch_start(tlb_batch_t *batch, as_t *as)
+{
+	batch->as = as;
+	batch->count = 0;
+
+#ifdef CONFIG_SMP
+	batch->ipl = tlb_shootdown_begin(as);
+#else
+	batch->ipl = interrupts_disable();
+#endif
+}
+
+/** Add page range to a batch of TLB invalidations.
+ *
+ * @param batch Batch to add the range to.
+ * @param page  Address of the first page.
+ * @param count Number of pages.
+ *
+ */
+void tlb_batch_add(tlb_batch_t *batch, uintptr_t page, size_t count)
+{
+	if (count == 0)
+		return;
+
+	uintptr_t end = page + P2SZ(count);
+
+	size_t i;
+	for (i = 0; i < batch->count; i++) {
+		tlb_range_t *range = &batch->ranges[i];
+		uintptr_t range_end = range->page + P2SZ(range->count);
+
+		if ((page <= range_end) && (range->page <= end)) {
+			range->page = min(range->page, page);
+			range->count = (max(range_end, end) - range->page) >>
+			    PAGE_WIDTH;
+			return;
+		}
+	}
+
+	if (batch->count < TLB_BATCH_LEN) {
+		batch->ranges[batch->count].page = page;
+		batch->ranges[batch->count].count = count;
+		batch->count++;
+		return;
+	}
+
+	/*
+	 * Out of ranges, replace them by a single range covering
+	 * all of them.
+	 */
+	for (i = 0; i < batch->count; i++) {
+		tlb_range_t *range = &batch->ranges[i];
+
+		end = max(end, range->page + P2SZ(range->count));
+		page = min(page, range->page);
+	}
+
+	batch->ranges[0].page = page;
+	batch->ranges[0].count = (end - page) >> PAGE_WIDTH;
+	batch->count = 1;
+}
+
+/** Finalize a batch of TLB invalidations.
+ *
+ * Invalidate the ranges in the batch on all processors which might
+ * hold their translations, including the software translation caches.
+ *
+ * @param batch Batch to finalize.
+ *
+ */
+void tlb_batch_finalize(tlb_batch_t *batch)
+{
+	as_t *as = batch->as;
+	size_t i;
+
+#ifdef CONFIG_SMP
+	for (i = 0; i < config.cpu_count; i++) {
+		cpu_t *cpu = &cpus[i];
+
+		if (!cpu->tlb_shootdown)
+			continue;
+
+		irq_spinlock_lock(&cpu->lock, false);
+		for (size_t j = 0; j < batch->count; j++) {
+			tlb_message_enqueue(cpu, TLB_INVL_PAGES, as->asid,
+			    batch->ranges[j].page, batch->ranges[j].count);
+		}
+		irq_spinlock_unlock(&cpu->lock, false);
+	}
+#endif
+
+	for (i = 0; i < batch->count; i++) {
+		tlb_invalidate(TLB_INVL_PAGES, as->asid, batch->ranges[i].page,
+		    batch->ranges[i].count);
+
+		/*
+		 * Invalidate software translation caches
+		 * (e.g. TSB on sparc64, PHT on ppc32).
+		 */
+		as_invalidate_translation_cache(as, batch->ranges[i].page,
+		    batch->ranges[i].count);
+	}
+
+#ifdef CONFIG_SMP
+	tlb_shootdown_end();
+#endif
+	interrupts_restore(batch->ipl);
+}
+
 /** @}
  */
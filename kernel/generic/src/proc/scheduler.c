@@ -36,6 +36,15 @@
  *
  * This file contains the scheduler and kcpulb kernel thread which
  * performs load-balancing of per-CPU run queues.
+ *
+ * Short-term imbalances are handled by the scheduler itself: a CPU
+ * which runs out of ready threads steals one from the busiest CPU
+ * before it goes to sleep. The kcpulb thread takes care of the
+ * long-term rebalancing.
+ *
+ * Both prefer migrating threads between the CPUs which are close to
+ * each other in the system topology (SMT siblings first, then CPUs
+ * of the same package) to preserve cache locality.
  */
 
 #include <assert.h>
@@ -46,12 +55,18 @@
 #include <mm/frame.h>
 #include <mm/page.h>
 #include <mm/as.h>
+#include <mem.h>
+#include <ddi/ddi.h>
+#include <sysinfo/sysinfo.h>
+#include <time/clock.h>
 #include <time/timeout.h>
+#include <tracepoint.h>
 #include <time/delay.h>
 #include <arch/asm.h>
 #include <arch/faddr.h>
 #include <arch/cycle.h>
 #include <atomic.h>
+#include <bitops.h>
 #include <synch/spinlock.h>
 #include <config.h>
 #include <context.h>
@@ -69,6 +84,16 @@ static void scheduler_separated_stack(void);
 
 atomic_t nrdy;  /**< Number of ready threads in the system. */
 
+/** IDs of the threads running on the CPUs, 0 for an idle CPU.
+ *
+ * The page is mapped read-only by the tasks, which use it to tell whether
+ * the holder of a lock is running and thus worth spinning for.
+ */
+static volatile sysarg_t *running_tid = NULL;
+
+/** Physical memory area with running_tid. */
+static parea_t running_parea;
+
 /** Carry out actions before new task runs. */
 static void before_task_runs(void)
 {
@@ -88,6 +113,9 @@ static void before_thread_runs(void)
 {
 	before_thread_runs_arch();
 
+	if ((running_tid != NULL) && (CPU->id < config.cpu_count))
+		running_tid[CPU->id] = (sysarg_t) THREAD->tid;
+
 #ifdef CONFIG_FPU_LAZY
 	if (THREAD == CPU->fpu_owner)
 		fpu_enable();
@@ -128,11 +156,24 @@ static void before_thread_runs(void)
 static void after_thread_ran(void)
 {
 	after_thread_ran_arch();
+
+	if ((running_tid != NULL) && (CPU->id < config.cpu_count))
+		running_tid[CPU->id] = 0;
 }
 
 #ifdef CONFIG_FPU_LAZY
 void scheduler_fpu_lazy_request(void)
 {
+	/* This is the first FPU use of the thread unless it has a context */
+	if (thread_fpu_context_alloc(THREAD) != EOK) {
+		if (THREAD->uspace) {
+			printf("Thread %" PRIu64 ": No memory for FPU "
+			    "context.\n", THREAD->tid);
+			task_kill_self(true);
+		}
+		panic("No memory for FPU context.");
+	}
+
 	fpu_enable();
 	irq_spinlock_lock(&CPU->lock, false);
 
@@ -161,6 +202,32 @@ void scheduler_fpu_lazy_request(void)
 
 	irq_spinlock_unlock(&CPU->lock, false);
 }
+
+/** Save the FPU context of the current thread held by the processor
+ *
+ * Afterwards the current thread can migrate to another processor.
+ *
+ */
+void scheduler_fpu_release(void)
+{
+	ipl_t ipl = interrupts_disable();
+	irq_spinlock_lock(&CPU->lock, false);
+
+	if (CPU->fpu_owner == THREAD) {
+		fpu_enable();
+
+		irq_spinlock_lock(&THREAD->lock, false);
+		fpu_context_save(THREAD->saved_fpu_context);
+		THREAD->fpu_context_engaged = false;
+		irq_spinlock_unlock(&THREAD->lock, false);
+
+		CPU->fpu_owner = NULL;
+		fpu_disable();
+	}
+
+	irq_spinlock_unlock(&CPU->lock, false);
+	interrupts_restore(ipl);
+}
 #endif /* CONFIG_FPU_LAZY */
 
 /** Initialize scheduler
@@ -170,29 +237,263 @@ void scheduler_fpu_lazy_request(void)
  */
 void scheduler_init(void)
 {
+	/* Publish the IDs of the running threads if they fit into a page. */
+	if (config.cpu_count > PAGE_SIZE / sizeof(sysarg_t))
+		return;
+
+	uintptr_t faddr = frame_alloc(1, FRAME_LOWMEM | FRAME_ATOMIC, 0);
+	if (faddr == 0)
+		return;
+
+	running_tid = (sysarg_t *) PA2KA(faddr);
+	memsetb((void *) running_tid, PAGE_SIZE, 0);
+
+	ddi_parea_init(&running_parea);
+	running_parea.pbase = faddr;
+	running_parea.frames = 1;
+	running_parea.unpriv = true;
+	running_parea.mapped = false;
+	ddi_parea_register(&running_parea);
+
+	sysinfo_set_item_val("sched.running.faddr", NULL, (sysarg_t) faddr);
+	sysinfo_set_item_val("sched.running.cpus", NULL, config.cpu_count);
+}
+
+/** Remove the first thread from a run queue.
+ *
+ * @param cpu CPU whose run queue is to be used.
+ * @param i   Index of the run queue. Its lock must be held and the queue
+ *            must not be empty.
+ *
+ * @return Removed thread.
+ *
+ */
+static thread_t *rq_remove_first(cpu_t *cpu, int i)
+{
+	assert(irq_spinlock_locked(&cpu->rq[i].lock));
+	assert(cpu->rq[i].n > 0);
+
+	thread_t *thread = list_get_instance(list_first(&cpu->rq[i].rq),
+	    thread_t, rq_link);
+	list_remove(&thread->rq_link);
+
+	if (--cpu->rq[i].n == 0)
+		atomic_fetch_and(&cpu->rq_mask, ~(1U << i));
+
+	atomic_dec(&cpu->nrdy);
+	atomic_dec(&nrdy);
+
+	return thread;
+}
+
+/** Get index of the highest-priority non-empty run queue.
+ *
+ * @param mask Bitmap of non-empty run queues.
+ *
+ * @return Index of the lowest set bit in @a mask.
+ *
+ */
+static inline int rq_mask_first(unsigned int mask)
+{
+	assert(mask != 0);
+	return fnzb32(mask & (~mask + 1));
+}
+
+#ifdef CONFIG_SMP
+
+/** Imbalance thresholds of the scheduling domains.
+ *
+ * Percentage by which the number of ready threads of a CPU must exceed
+ * the average of the domain for kcpulb to migrate threads away from it.
+ * The more remote the domain, the more cache locality is lost by the
+ * migration and the higher the threshold.
+ */
+static const unsigned int sched_domain_imbalance[SCHED_DOMAIN_COUNT] = {
+	[SCHED_DOMAIN_SMT] = 0,
+	[SCHED_DOMAIN_PACKAGE] = 25,
+	[SCHED_DOMAIN_SYSTEM] = 50
+};
+
+/** Get the closest scheduling domain shared by two CPUs.
+ *
+ * @param a First CPU.
+ * @param b Second CPU.
+ *
+ * @return Scheduling domain level.
+ *
+ */
+static sched_domain_t sched_domain_get(cpu_t *a, cpu_t *b)
+{
+	if (a->package_id != b->package_id)
+		return SCHED_DOMAIN_SYSTEM;
+
+	if (a->core_id != b->core_id)
+		return SCHED_DOMAIN_PACKAGE;
+
+	return SCHED_DOMAIN_SMT;
+}
+
+/** Try to steal a thread from a run queue of another CPU.
+ *
+ * The run queue is searched from its tail so that the threads which
+ * were least recently enqueued are taken first. Wired threads, threads
+ * which have already been stolen, threads for which migration was
+ * temporarily disabled and threads whose FPU context is still in the
+ * CPU are skipped.
+ *
+ * Interrupts must be disabled.
+ *
+ * @param cpu CPU to steal from.
+ * @param i   Index of the run queue.
+ *
+ * @return Thread removed from the run queue or NULL if there was
+ *         no suitable thread.
+ *
+ */
+static thread_t *steal_thread_from(cpu_t *cpu, int i)
+{
+	assert(interrupts_disabled());
+
+	irq_spinlock_lock(&cpu->rq[i].lock, false);
+
+	/* Search rq from the back */
+	link_t *link = cpu->rq[i].rq.head.prev;
+
+	while (link != &cpu->rq[i].rq.head) {
+		thread_t *thread = list_get_instance(link, thread_t, rq_link);
+
+		irq_spinlock_lock(&thread->lock, false);
+
+		if ((!thread->wired) && (!thread->stolen) &&
+		    (!thread->nomigrate) && (!thread->fpu_context_engaged)) {
+			irq_spinlock_unlock(&thread->lock, false);
+
+			list_remove(&thread->rq_link);
+			if (--cpu->rq[i].n == 0)
+				atomic_fetch_and(&cpu->rq_mask, ~(1U << i));
+
+			atomic_dec(&cpu->nrdy);
+			atomic_dec(&nrdy);
+
+			irq_spinlock_unlock(&cpu->rq[i].lock, false);
+			return thread;
+		}
+
+		irq_spinlock_unlock(&thread->lock, false);
+		link = link->prev;
+	}
+
+	irq_spinlock_unlock(&cpu->rq[i].lock, false);
+	return NULL;
 }
 
+/** Steal a thread for an idle CPU.
+ *
+ * Find the CPU with the most ready threads in the closest scheduling
+ * domain and take one of its threads, searching the lowest-priority
+ * run queues first. More remote domains are tried only if there is
+ * no CPU worth robbing in the closer ones.
+ *
+ * Interrupts must be disabled.
+ *
+ * @param rqi Place to store index of the run queue the thread was
+ *            taken from.
+ *
+ * @return Stolen thread or NULL if there is no CPU worth robbing.
+ *
+ */
+static thread_t *steal_work(int *rqi)
+{
+	assert(interrupts_disabled());
+
+	cpu_t *busiest[SCHED_DOMAIN_COUNT];
+	size_t busiest_nrdy[SCHED_DOMAIN_COUNT];
+
+	for (sched_domain_t domain = SCHED_DOMAIN_SMT;
+	    domain < SCHED_DOMAIN_COUNT; domain++) {
+		busiest[domain] = NULL;
+		busiest_nrdy[domain] = STEAL_NRDY_MIN - 1;
+	}
+
+	for (size_t acpu = 0; acpu < config.cpu_active; acpu++) {
+		cpu_t *cpu = &cpus[(CPU->id + acpu + 1) % config.cpu_active];
+		if (cpu == CPU)
+			continue;
+
+		sched_domain_t domain = sched_domain_get(CPU, cpu);
+		size_t cpu_nrdy = atomic_load(&cpu->nrdy);
+		if (cpu_nrdy > busiest_nrdy[domain]) {
+			busiest[domain] = cpu;
+			busiest_nrdy[domain] = cpu_nrdy;
+		}
+	}
+
+	for (sched_domain_t domain = SCHED_DOMAIN_SMT;
+	    domain < SCHED_DOMAIN_COUNT; domain++) {
+		if (busiest[domain] == NULL)
+			continue;
+
+		unsigned int mask = atomic_load(&busiest[domain]->rq_mask);
+		for (int i = RQ_COUNT - 1; i >= 0; i--) {
+			if ((mask & (1U << i)) == 0)
+				continue;
+
+			thread_t *thread = steal_thread_from(busiest[domain], i);
+			if (thread != NULL) {
+				*rqi = i;
+				return thread;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+#endif /* CONFIG_SMP */
+
 /** Get thread to be scheduled
  *
  * Get the optimal thread to be scheduled
  * according to thread accounting and scheduler
  * policy.
  *
+ * The highest-priority non-empty run queue is located using the
+ * per-CPU bitmap of non-empty run queues. If the local run queues
+ * are empty, the CPU attempts to steal a thread from the busiest
+ * CPU before it goes to sleep.
+ *
  * @return Thread to be scheduled.
  *
  */
 static thread_t *find_best_thread(void)
 {
+	thread_t *thread;
+	int i;
+
 	assert(CPU != NULL);
 
 loop:
 
 	if (atomic_load(&CPU->nrdy) == 0) {
+#ifdef CONFIG_SMP
+		thread = steal_work(&i);
+		if (thread != NULL) {
+			irq_spinlock_lock(&thread->lock, false);
+			goto found;
+		}
+#endif
+
 		/*
 		 * For there was nothing to run, the CPU goes to sleep
 		 * until a hardware interrupt or an IPI comes.
 		 * This improves energy saving and hyperthreading.
+		 *
+		 * The periodic clock tick is stopped until the next
+		 * timeout is due, unless a thread became ready meanwhile.
 		 */
+		if (!clock_idle_enter())
+			goto loop;
+
 		irq_spinlock_lock(&CPU->lock, false);
 		CPU->idle = true;
 		irq_spinlock_unlock(&CPU->lock, false);
@@ -205,50 +506,51 @@ loop:
 		 */
 		cpu_sleep();
 		interrupts_disable();
+		clock_idle_exit();
 		goto loop;
 	}
 
 	assert(!CPU->idle);
 
-	unsigned int i;
-	for (i = 0; i < RQ_COUNT; i++) {
+	unsigned int mask;
+	while ((mask = atomic_load(&CPU->rq_mask)) != 0) {
+		i = rq_mask_first(mask);
+
 		irq_spinlock_lock(&(CPU->rq[i].lock), false);
 		if (CPU->rq[i].n == 0) {
 			/*
-			 * If this queue is empty, try a lower-priority queue.
+			 * The queue has been emptied in the meantime
+			 * (e.g. by a stealing CPU), look again.
 			 */
 			irq_spinlock_unlock(&(CPU->rq[i].lock), false);
 			continue;
 		}
 
-		atomic_dec(&CPU->nrdy);
-		atomic_dec(&nrdy);
-		CPU->rq[i].n--;
-
 		/*
 		 * Take the first thread from the queue.
 		 */
-		thread_t *thread = list_get_instance(
-		    list_first(&CPU->rq[i].rq), thread_t, rq_link);
-		list_remove(&thread->rq_link);
-
+		thread = rq_remove_first(CPU, i);
 		irq_spinlock_pass(&(CPU->rq[i].lock), &thread->lock);
+		goto found;
+	}
 
-		thread->cpu = CPU;
-		thread->ticks = us2ticks((i + 1) * 10000);
-		thread->priority = i;  /* Correct rq index */
+	goto loop;
 
-		/*
-		 * Clear the stolen flag so that it can be migrated
-		 * when load balancing needs emerge.
-		 */
-		thread->stolen = false;
-		irq_spinlock_unlock(&thread->lock, false);
+found:
+	assert(irq_spinlock_locked(&thread->lock));
 
-		return thread;
-	}
+	thread->cpu = CPU;
+	thread->ticks = us2ticks((i + 1) * 10000);
+	thread->priority = i;  /* Correct rq index */
 
-	goto loop;
+	/*
+	 * Clear the stolen flag so that it can be migrated
+	 * when load balancing needs emerge.
+	 */
+	thread->stolen = false;
+	irq_spinlock_unlock(&thread->lock, false);
+
+	return thread;
 }
 
 /** Prevent rq starvation
@@ -278,6 +580,7 @@ static void relink_rq(int start)
 			list_concat(&list, &CPU->rq[i + 1].rq);
 			size_t n = CPU->rq[i + 1].n;
 			CPU->rq[i + 1].n = 0;
+			atomic_fetch_and(&CPU->rq_mask, ~(1U << (i + 1)));
 			irq_spinlock_unlock(&CPU->rq[i + 1].lock, false);
 
 			/* Append rq[i + 1] to rq[i] */
@@ -285,6 +588,8 @@ static void relink_rq(int start)
 			irq_spinlock_lock(&CPU->rq[i].lock, false);
 			list_concat(&CPU->rq[i].rq, &list);
 			CPU->rq[i].n += n;
+			if (CPU->rq[i].n > 0)
+				atomic_fetch_or(&CPU->rq_mask, 1U << i);
 			irq_spinlock_unlock(&CPU->rq[i].lock, false);
 		}
 
@@ -401,6 +706,11 @@ void scheduler_separated_stack(void)
 	if (old_as)
 		as_hold(old_as);
 
+#ifdef CONFIG_TRACEPOINTS
+	uint64_t old_tid = (THREAD) ? THREAD->tid : 0;
+	state_t old_state = (THREAD) ? THREAD->state : Entering;
+#endif
+
 	if (THREAD) {
 		/* Must be run after the switch to scheduler stack */
 		after_thread_ran();
@@ -469,6 +779,7 @@ void scheduler_separated_stack(void)
 	}
 
 	THREAD = find_best_thread();
+	TRACEPOINT(TRACE_SCHED_SWITCH, old_tid, old_state, 0);
 
 	irq_spinlock_lock(&THREAD->lock, false);
 	int priority = THREAD->priority;
@@ -537,50 +848,55 @@ void scheduler_separated_stack(void)
 }
 
 #ifdef CONFIG_SMP
-/** Load balancing thread
+/** Balance the load of the current CPU within a scheduling domain.
  *
- * SMP load balancing thread, supervising thread supplies
- * for the CPU it's wired to.
+ * Only the CPUs whose closest common domain with the current CPU is
+ * @a domain are robbed, the closer CPUs are expected to have been taken
+ * care of on the lower levels. A CPU is robbed only if the number of
+ * its ready threads exceeds the average of the domain by more than the
+ * imbalance threshold of the domain.
  *
- * @param arg Generic thread argument (unused).
+ * @param domain Scheduling domain level.
+ *
+ * @return Number of threads migrated to the current CPU.
  *
  */
-void kcpulb(void *arg)
+static size_t kcpulb_balance(sched_domain_t domain)
 {
-	size_t average;
-	size_t rdy;
+	size_t domain_nrdy = 0;
+	size_t domain_cpus = 0;
+	size_t acpu;
 
-	/*
-	 * Detach kcpulb as nobody will call thread_join_timeout() on it.
-	 */
-	thread_detach(THREAD);
+	for (acpu = 0; acpu < config.cpu_active; acpu++) {
+		if (sched_domain_get(CPU, &cpus[acpu]) <= domain) {
+			domain_nrdy += atomic_load(&cpus[acpu].nrdy);
+			domain_cpus++;
+		}
+	}
 
-loop:
-	/*
-	 * Work in 1s intervals.
-	 */
-	thread_sleep(1);
+	if (domain_cpus < 2)
+		return 0;
 
-not_satisfied:
 	/*
 	 * Calculate the number of threads that will be migrated/stolen from
 	 * other CPU's. Note that situation can have changed between two
 	 * passes. Each time get the most up to date counts.
 	 *
 	 */
-	average = atomic_load(&nrdy) / config.cpu_active + 1;
-	rdy = atomic_load(&CPU->nrdy);
+	size_t average = domain_nrdy / domain_cpus + 1;
+	size_t rdy = atomic_load(&CPU->nrdy);
 
 	if (average <= rdy)
-		goto satisfied;
+		return 0;
 
 	size_t count = average - rdy;
+	size_t limit = average + average * sched_domain_imbalance[domain] / 100;
+	size_t migrated = 0;
 
 	/*
 	 * Searching least priority queues on all CPU's first and most priority
 	 * queues on all CPU's last.
 	 */
-	size_t acpu;
 	size_t acpu_bias = 0;
 	int rq;
 
@@ -597,80 +913,42 @@ not_satisfied:
 			if (CPU == cpu)
 				continue;
 
-			if (atomic_load(&cpu->nrdy) <= average)
+			if (sched_domain_get(CPU, cpu) != domain)
 				continue;
 
-			irq_spinlock_lock(&(cpu->rq[rq].lock), true);
-			if (cpu->rq[rq].n == 0) {
-				irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
+			if (atomic_load(&cpu->nrdy) <= limit)
 				continue;
-			}
-
-			thread_t *thread = NULL;
-
-			/* Search rq from the back */
-			link_t *link = cpu->rq[rq].rq.head.prev;
 
-			while (link != &(cpu->rq[rq].rq.head)) {
-				thread = (thread_t *) list_get_instance(link,
-				    thread_t, rq_link);
-
-				/*
-				 * Do not steal CPU-wired threads, threads
-				 * already stolen, threads for which migration
-				 * was temporarily disabled or threads whose
-				 * FPU context is still in the CPU.
-				 */
-				irq_spinlock_lock(&thread->lock, false);
-
-				if ((!thread->wired) && (!thread->stolen) &&
-				    (!thread->nomigrate) &&
-				    (!thread->fpu_context_engaged)) {
-					/*
-					 * Remove thread from ready queue.
-					 */
-					irq_spinlock_unlock(&thread->lock,
-					    false);
-
-					atomic_dec(&cpu->nrdy);
-					atomic_dec(&nrdy);
-
-					cpu->rq[rq].n--;
-					list_remove(&thread->rq_link);
-
-					break;
-				}
-
-				irq_spinlock_unlock(&thread->lock, false);
+			if ((atomic_load(&cpu->rq_mask) & (1U << rq)) == 0)
+				continue;
 
-				link = link->prev;
-				thread = NULL;
-			}
+			ipl_t ipl = interrupts_disable();
+			thread_t *thread = steal_thread_from(cpu, rq);
 
 			if (thread) {
 				/*
 				 * Ready thread on local CPU
 				 */
 
-				irq_spinlock_pass(&(cpu->rq[rq].lock),
-				    &thread->lock);
+				irq_spinlock_lock(&thread->lock, false);
 
 #ifdef KCPULB_VERBOSE
 				log(LF_OTHER, LVL_DEBUG,
 				    "kcpulb%u: TID %" PRIu64 " -> cpu%u, "
-				    "nrdy=%ld, avg=%ld", CPU->id, thread->tid,
-				    CPU->id, atomic_load(&CPU->nrdy),
-				    atomic_load(&nrdy) / config.cpu_active);
+				    "domain=%d, nrdy=%ld, avg=%ld", CPU->id,
+				    thread->tid, CPU->id, domain,
+				    atomic_load(&CPU->nrdy), average);
 #endif
 
 				thread->stolen = true;
 				thread->state = Entering;
 
-				irq_spinlock_unlock(&thread->lock, true);
+				irq_spinlock_unlock(&thread->lock, false);
+				interrupts_restore(ipl);
 				thread_ready(thread);
 
-				if (--count == 0)
-					goto satisfied;
+				if (++migrated == count)
+					return migrated;
 
 				/*
 				 * We are not satisfied yet, focus on another
@@ -680,31 +958,53 @@ not_satisfied:
 				acpu_bias++;
 
 				continue;
-			} else
-				irq_spinlock_unlock(&(cpu->rq[rq].lock), true);
+			}
 
+			interrupts_restore(ipl);
 		}
 	}
 
-	if (atomic_load(&CPU->nrdy)) {
-		/*
-		 * Be a little bit light-weight and let migrated threads run.
-		 *
-		 */
-		scheduler();
-	} else {
+	return migrated;
+}
+
+/** Load balancing thread
+ *
+ * SMP load balancing thread, supervising thread supplies
+ * for the CPU it's wired to.
+ *
+ * The scheduling domains are balanced from the closest to the most
+ * remote one so that threads are preferably migrated between SMT
+ * siblings, then within the same package and only then across
+ * packages.
+ *
+ * @param arg Generic thread argument (unused).
+ *
+ */
+void kcpulb(void *arg)
+{
+	/*
+	 * Detach kcpulb as nobody will call thread_join_timeout() on it.
+	 */
+	thread_detach(THREAD);
+
+	while (true) {
 		/*
-		 * We failed to migrate a single thread.
-		 * Give up this turn.
-		 *
+		 * Work in 1s intervals.
 		 */
-		goto loop;
-	}
-
-	goto not_satisfied;
+		thread_sleep(1);
 
-satisfied:
-	goto loop;
+		for (sched_domain_t domain = SCHED_DOMAIN_SMT;
+		    domain < SCHED_DOMAIN_COUNT; domain++) {
+			while (kcpulb_balance(domain) > 0) {
+				/*
+				 * Be a little bit light-weight and let
+				 * migrated threads run.
+				 *
+				 */
+				scheduler();
+			}
+		}
+	}
 }
 #endif /* CONFIG_SMP */
 
@@ -720,9 +1020,10 @@ void sched_print_list(void)
 
 		irq_spinlock_lock(&cpus[cpu].lock, true);
 
-		printf("cpu%u: address=%p, nrdy=%zu, needs_relink=%zu\n",
-		    cpus[cpu].id, &cpus[cpu], atomic_load(&cpus[cpu].nrdy),
-		    cpus[cpu].needs_relink);
+		printf("cpu%u: address=%p, nrdy=%zu, needs_relink=%zu, "
+		    "rq_mask=%#x\n", cpus[cpu].id, &cpus[cpu],
+		    atomic_load(&cpus[cpu].nrdy), cpus[cpu].needs_relink,
+		    atomic_load(&cpus[cpu].rq_mask));
 
 		unsigned int i;
 		for (i = 0; i < RQ_COUNT; i++) {
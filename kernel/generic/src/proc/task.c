@@ -165,6 +165,7 @@ errno_t tsk_constructor(void *obj, unsigned int kmflags)
 	list_initialize(&task->threads);
 
 	ipc_answerbox_init(&task->answerbox, task);
+	irq_spinlock_stats_register(&task->answerbox.lock);
 
 	spinlock_initialize(&task->active_calls_lock, "active_calls_lock");
 	list_initialize(&task->active_calls);
@@ -183,6 +184,7 @@ size_t tsk_destructor(void *obj)
 {
 	task_t *task = (task_t *) obj;
 
+	irq_spinlock_stats_unregister(&task->answerbox.lock);
 	caps_task_free(task);
 	return 0;
 }
@@ -284,6 +286,10 @@ void task_destroy(task_t *task)
 	 */
 	as_release(task->as);
 
+#ifdef CONFIG_UDEBUG
+	udebug_task_destroy(&task->udebug);
+#endif
+
 	slab_free(task_cache, task);
 }
 
@@ -165,10 +165,8 @@ static errno_t thr_constructor(void *obj, unsigned int kmflags)
 	thr_constructor_arch(thread);
 
 #ifdef CONFIG_FPU
-	thread->saved_fpu_context = slab_alloc(fpu_context_cache,
-	    FRAME_ATOMIC | kmflags);
-	if (!thread->saved_fpu_context)
-		return ENOMEM;
+	/* Allocated on first use, see thread_fpu_context_alloc() */
+	thread->saved_fpu_context = NULL;
 #endif /* CONFIG_FPU */
 
 	/*
@@ -195,16 +193,15 @@ static errno_t thr_constructor(void *obj, unsigned int kmflags)
 
 	uintptr_t stack_phys =
 	    frame_alloc(STACK_FRAMES, kmflags, STACK_SIZE - 1);
-	if (!stack_phys) {
-#ifdef CONFIG_FPU
-		assert(thread->saved_fpu_context);
-		slab_free(fpu_context_cache, thread->saved_fpu_context);
-#endif
+	if (!stack_phys)
 		return ENOMEM;
-	}
 
 	thread->kstack = (uint8_t *) PA2KA(stack_phys);
 
+	irq_spinlock_lock(&CPU->lock, true);
+	CPU->kstacks_allocated++;
+	irq_spinlock_unlock(&CPU->lock, true);
+
 #ifdef CONFIG_UDEBUG
 	mutex_initialize(&thread->udebug.lock, MUTEX_PASSIVE);
 #endif
@@ -223,13 +220,48 @@ static size_t thr_destructor(void *obj)
 	frame_free(KA2PA(thread->kstack), STACK_FRAMES);
 
 #ifdef CONFIG_FPU
-	assert(thread->saved_fpu_context);
-	slab_free(fpu_context_cache, thread->saved_fpu_context);
+	if (thread->saved_fpu_context != NULL)
+		slab_free(fpu_context_cache, thread->saved_fpu_context);
 #endif
 
 	return STACK_FRAMES;  /* number of frames freed */
 }
 
+#ifdef CONFIG_FPU
+
+/** Allocate the FPU context of a thread unless it already has one
+ *
+ * Most threads never touch the FPU, so the context is only allocated
+ * when it is needed for the first time. It stays with the thread_t
+ * in the slab cache afterwards.
+ *
+ * @param thread Thread.
+ *
+ * @return EOK on success, ENOMEM if there is no memory.
+ *
+ */
+errno_t thread_fpu_context_alloc(thread_t *thread)
+{
+	if (thread->saved_fpu_context != NULL)
+		return EOK;
+
+	fpu_context_t *ctx = slab_alloc(fpu_context_cache, FRAME_ATOMIC);
+	if (ctx == NULL)
+		return ENOMEM;
+
+	thread->saved_fpu_context = ctx;
+
+	ipl_t ipl = interrupts_disable();
+	irq_spinlock_lock(&CPU->lock, false);
+	CPU->fpu_contexts_allocated++;
+	irq_spinlock_unlock(&CPU->lock, false);
+	interrupts_restore(ipl);
+
+	return EOK;
+}
+
+#endif /* CONFIG_FPU */
+
 /** Initialize threads
  *
  * Initialize kernel threads support.
@@ -264,20 +296,33 @@ void thread_wire(thread_t *thread, cpu_t *cpu)
 	irq_spinlock_unlock(&thread->lock, true);
 }
 
+/** Let a wired thread run on any CPU again.
+ *
+ * @param thread Thread to be unwired.
+ *
+ */
+void thread_unwire(thread_t *thread)
+{
+	irq_spinlock_lock(&thread->lock, true);
+	thread->wired = false;
+	irq_spinlock_unlock(&thread->lock, true);
+}
+
 /** Invoked right before thread_ready() readies the thread. thread is locked. */
 static void before_thread_is_ready(thread_t *thread)
 {
 	assert(irq_spinlock_locked(&thread->lock));
 }
 
-/** Make thread ready
+/** Make thread ready on run queue
  *
- * Switch thread to the ready state.
- *
- * @param thread Thread to make ready.
+ * @param thread  Thread to make ready.
+ * @param handoff If true and the thread may run on the current CPU, put it
+ *                at the head of the current CPU's run queue of the current
+ *                thread's priority instead of the tail of its own.
  *
  */
-void thread_ready(thread_t *thread)
+static void thread_ready_internal(thread_t *thread, bool handoff)
 {
 	irq_spinlock_lock(&thread->lock, true);
 
@@ -285,23 +330,37 @@ void thread_ready(thread_t *thread)
 
 	before_thread_is_ready(thread);
 
-	int i = (thread->priority < RQ_COUNT - 1) ?
-	    ++thread->priority : thread->priority;
+	bool pinned = thread->wired || thread->nomigrate ||
+	    thread->fpu_context_engaged;
+
+	if ((handoff) && ((pinned) || (THREAD == NULL) || (THREAD == thread)))
+		handoff = false;
 
+	int i;
 	cpu_t *cpu;
-	if (thread->wired || thread->nomigrate || thread->fpu_context_engaged) {
-		/* Cannot ready to another CPU */
-		assert(thread->cpu != NULL);
-		cpu = thread->cpu;
-	} else if (thread->stolen) {
-		/* Ready to the stealing CPU */
+	if (handoff) {
+		/* Run next on this CPU, inheriting the current priority */
+		i = THREAD->priority;
+		thread->priority = i;
 		cpu = CPU;
-	} else if (thread->cpu) {
-		/* Prefer the CPU on which the thread ran last */
-		assert(thread->cpu != NULL);
-		cpu = thread->cpu;
 	} else {
-		cpu = CPU;
+		i = (thread->priority < RQ_COUNT - 1) ?
+		    ++thread->priority : thread->priority;
+
+		if (pinned) {
+			/* Cannot ready to another CPU */
+			assert(thread->cpu != NULL);
+			cpu = thread->cpu;
+		} else if (thread->stolen) {
+			/* Ready to the stealing CPU */
+			cpu = CPU;
+		} else if (thread->cpu) {
+			/* Prefer the CPU on which the thread ran last */
+			assert(thread->cpu != NULL);
+			cpu = thread->cpu;
+		} else {
+			cpu = CPU;
+		}
 	}
 
 	thread->state = Ready;
@@ -310,15 +369,51 @@ void thread_ready(thread_t *thread)
 
 	/*
 	 * Append thread to respective ready queue
-	 * on respective processor.
+	 * on respective processor. A handed-off thread
+	 * jumps the queue.
 	 */
 
-	list_append(&thread->rq_link, &cpu->rq[i].rq);
-	cpu->rq[i].n++;
+	if (handoff)
+		list_prepend(&thread->rq_link, &cpu->rq[i].rq);
+	else
+		list_append(&thread->rq_link, &cpu->rq[i].rq);
+	if (cpu->rq[i].n++ == 0)
+		atomic_fetch_or(&cpu->rq_mask, 1U << i);
 	irq_spinlock_unlock(&(cpu->rq[i].lock), true);
 
 	atomic_inc(&nrdy);
 	atomic_inc(&cpu->nrdy);
+
+	clock_tick_kick(cpu);
+}
+
+/** Make thread ready
+ *
+ * Switch thread to the ready state.
+ *
+ * @param thread Thread to make ready.
+ *
+ */
+void thread_ready(thread_t *thread)
+{
+	thread_ready_internal(thread, false);
+}
+
+/** Make thread ready and have it run next on the current CPU
+ *
+ * Used for synchronous rendezvous, e.g. an IPC request waking up the
+ * server or an answer waking up the client, where the current thread
+ * is about to block. The woken thread is queued at the head of the
+ * current CPU's run queue at the current thread's priority, so that
+ * it effectively receives the rest of the current time slice. Threads
+ * that may not migrate are readied normally.
+ *
+ * @param thread Thread to make ready.
+ *
+ */
+void thread_ready_handoff(thread_t *thread)
+{
+	thread_ready_internal(thread, true);
 }
 
 /** Create new thread
@@ -348,8 +443,21 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 		return NULL;
 	}
 
-	/* Not needed, but good for debugging */
+#if (defined CONFIG_FPU) && (!defined CONFIG_FPU_LAZY)
+	/* The context is saved and restored on every thread switch */
+	if (thread_fpu_context_alloc(thread) != EOK) {
+		slab_free(thread_cache, thread);
+		return NULL;
+	}
+#endif
+
+#ifdef CONFIG_DEBUG
+	/*
+	 * Not needed, but good for debugging. Recycled stacks are not
+	 * cleared otherwise, to keep thread creation cheap.
+	 */
 	memsetb(thread->kstack, STACK_SIZE, 0);
+#endif
 
 	irq_spinlock_lock(&tidlock, true);
 	thread->tid = ++last_tid;
@@ -388,6 +496,8 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 	thread->sleep_interruptible = false;
 	thread->sleep_composable = false;
 	thread->sleep_queue = NULL;
+	thread->sleep_morph_queue = NULL;
+	thread->sleep_morphed = false;
 	thread->timeout_pending = false;
 
 	thread->in_copy_from_uspace = false;
@@ -413,6 +523,10 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 	if ((flags & THREAD_FLAG_NOATTACH) != THREAD_FLAG_NOATTACH)
 		thread_attach(thread, task);
 
+	irq_spinlock_lock(&CPU->lock, true);
+	CPU->threads_created++;
+	irq_spinlock_unlock(&CPU->lock, true);
+
 	return thread;
 }
 
@@ -435,6 +549,7 @@ void thread_destroy(thread_t *thread, bool irq_res)
 	irq_spinlock_lock(&thread->cpu->lock, false);
 	if (thread->cpu->fpu_owner == thread)
 		thread->cpu->fpu_owner = NULL;
+	thread->cpu->threads_destroyed++;
 	irq_spinlock_unlock(&thread->cpu->lock, false);
 
 	irq_spinlock_pass(&thread->lock, &threads_lock);
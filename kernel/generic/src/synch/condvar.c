@@ -39,6 +39,7 @@
 #include <synch/mutex.h>
 #include <synch/spinlock.h>
 #include <synch/waitq.h>
+#include <proc/thread.h>
 #include <arch.h>
 
 /** Initialize condition variable.
@@ -57,7 +58,7 @@ void condvar_initialize(condvar_t *cv)
  */
 void condvar_signal(condvar_t *cv)
 {
-	waitq_wakeup(&cv->wq, WAKEUP_FIRST);
+	waitq_wakeup_morph(&cv->wq, false);
 }
 
 /** Signal the condition has become true to all waiting threads by waking
@@ -67,7 +68,7 @@ void condvar_signal(condvar_t *cv)
  */
 void condvar_broadcast(condvar_t *cv)
 {
-	waitq_wakeup(&cv->wq, WAKEUP_ALL);
+	waitq_wakeup_morph(&cv->wq, true);
 }
 
 /** Wait for the condition becoming true.
@@ -94,13 +95,38 @@ errno_t _condvar_wait_timeout(condvar_t *cv, mutex_t *mtx, uint32_t usec, int fl
 	/* Unlock only after the waitq is locked so we don't miss a wakeup. */
 	mutex_unlock(mtx);
 
+	/*
+	 * A wakeup moves us straight to the wait queue of a passive mutex, so
+	 * that a broadcast does not wake up all waiters just to have them
+	 * sleep on the mutex again.
+	 */
+	if (mtx->type == MUTEX_PASSIVE)
+		THREAD->sleep_morph_queue = &mtx->sem.wq;
+
 	cv->wq.missed_wakeups = 0;	/* Enforce blocking. */
 	rc = waitq_sleep_timeout_unsafe(&cv->wq, usec, flags, &blocked);
 	assert(blocked || rc != EOK);
 
+	THREAD->sleep_morph_queue = NULL;
 	waitq_sleep_finish(&cv->wq, blocked, ipl);
-	/* Lock only after releasing the waitq to avoid a possible deadlock. */
-	mutex_lock(mtx);
+
+	if (THREAD->sleep_morphed) {
+		/* We were handed the mutex */
+		THREAD->sleep_morphed = false;
+
+		/*
+		 * Wait for the wakeup to complete as waitq_sleep_finish()
+		 * would have done had we slept in the mutex.
+		 */
+		irq_spinlock_lock(&mtx->sem.wq.lock, true);
+		irq_spinlock_unlock(&mtx->sem.wq.lock, true);
+	} else {
+		/*
+		 * Lock only after releasing the waitq to avoid a possible
+		 * deadlock.
+		 */
+		mutex_lock(mtx);
+	}
 
 	return rc;
 }
@@ -45,9 +45,21 @@
 #include <symtab.h>
 #include <stacktrace.h>
 #include <cpu.h>
+#include <arch/cycle.h>
+#include <inttypes.h>
 
 #ifdef CONFIG_SMP
 
+#ifdef CONFIG_SPINLOCK_STATS
+
+/** Lock protecting the list of spinlocks with reported statistics. */
+SPINLOCK_STATIC_INITIALIZE_NAME(spinlock_stats_lock, "*spinlock_stats_lock");
+
+/** List of spinlocks with reported statistics. */
+static LIST_INITIALIZE(spinlock_stats_list);
+
+#endif /* CONFIG_SPINLOCK_STATS */
+
 /** Initialize spinlock
  *
  * @param sl Pointer to spinlock_t structure.
@@ -55,30 +67,130 @@
  */
 void spinlock_initialize(spinlock_t *lock, const char *name)
 {
+#ifdef CONFIG_TICKET_SPINLOCK
+	atomic_store_explicit(&lock->next, 0, memory_order_relaxed);
+	atomic_store_explicit(&lock->owner, 0, memory_order_relaxed);
+#else
 	atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
-#ifdef CONFIG_DEBUG_SPINLOCK
+#endif
+#ifdef SPINLOCK_NAMED
 	lock->name = name;
 #endif
+#ifdef CONFIG_SPINLOCK_STATS
+	lock->stats.acquisitions = 0;
+	lock->stats.contended = 0;
+	lock->stats.spins = 0;
+	lock->stats.max_hold = 0;
+	lock->stats.acquired = 0;
+	link_initialize(&lock->stats.link);
+#endif
 }
 
-#ifdef CONFIG_DEBUG_SPINLOCK
+/** Try to acquire the spinlock without waiting
+ *
+ * @param lock Pointer to spinlock_t structure.
+ *
+ * @return True if the spinlock was acquired.
+ *
+ */
+_NO_TRACE static inline bool spinlock_try_acquire(spinlock_t *lock)
+{
+#ifdef CONFIG_TICKET_SPINLOCK
+	/* The lock is free iff the next ticket would own it right away. */
+	unsigned int owner = atomic_load_explicit(&lock->owner,
+	    memory_order_relaxed);
+	unsigned int next = owner;
+
+	return atomic_compare_exchange_strong_explicit(&lock->next, &next,
+	    owner + 1, memory_order_acquire, memory_order_relaxed);
+#else
+	return !atomic_flag_test_and_set_explicit(&lock->flag,
+	    memory_order_acquire);
+#endif
+}
+
+#ifdef SPINLOCK_NAMED
+
+/** Take a place in the queue of spinlock waiters
+ *
+ * @param lock Pointer to spinlock_t structure.
+ *
+ * @return Ticket to wait for (meaningful only for ticket spinlocks).
+ *
+ */
+_NO_TRACE static inline unsigned int spinlock_ticket(spinlock_t *lock)
+{
+#ifdef CONFIG_TICKET_SPINLOCK
+	return atomic_fetch_add_explicit(&lock->next, 1, memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+
+/** Find out whether the spinlock waiter must keep spinning
+ *
+ * @param lock   Pointer to spinlock_t structure.
+ * @param ticket Ticket returned by spinlock_ticket().
+ *
+ * @return False if the spinlock has been acquired.
+ *
+ */
+_NO_TRACE static inline bool spinlock_wait(spinlock_t *lock,
+    unsigned int ticket)
+{
+#ifdef CONFIG_TICKET_SPINLOCK
+	return atomic_load_explicit(&lock->owner, memory_order_acquire) !=
+	    ticket;
+#else
+	(void) ticket;
+	return atomic_flag_test_and_set_explicit(&lock->flag,
+	    memory_order_acquire);
+#endif
+}
+
+/** Release the acquired spinlock
+ *
+ * @param lock Pointer to spinlock_t structure.
+ *
+ */
+_NO_TRACE static inline void spinlock_release(spinlock_t *lock)
+{
+#ifdef CONFIG_TICKET_SPINLOCK
+	unsigned int owner = atomic_load_explicit(&lock->owner,
+	    memory_order_relaxed);
+	atomic_store_explicit(&lock->owner, owner + 1, memory_order_release);
+#else
+	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+#endif
+}
 
 /** Lock spinlock
  *
  * Lock spinlock.
  * This version has limitted ability to report
- * possible occurence of deadlock.
+ * possible occurence of deadlock and gathers
+ * contention statistics if configured.
  *
  * @param lock Pointer to spinlock_t structure.
  *
  */
 void spinlock_lock_debug(spinlock_t *lock)
 {
+#ifdef CONFIG_DEBUG_SPINLOCK
 	size_t i = 0;
 	bool deadlock_reported = false;
+#endif
+#ifdef CONFIG_SPINLOCK_STATS
+	uint64_t spins = 0;
+#endif
 
 	preemption_disable();
-	while (atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire)) {
+	unsigned int ticket = spinlock_ticket(lock);
+	while (spinlock_wait(lock, ticket)) {
+#ifdef CONFIG_SPINLOCK_STATS
+		spins++;
+#endif
+#ifdef CONFIG_DEBUG_SPINLOCK
 		/*
 		 * We need to be careful about particular locks
 		 * which are directly used to report deadlocks
@@ -110,10 +222,22 @@ void spinlock_lock_debug(spinlock_t *lock)
 			i = 0;
 			deadlock_reported = true;
 		}
+#endif
 	}
 
+#ifdef CONFIG_DEBUG_SPINLOCK
 	if (deadlock_reported)
 		printf("cpu%u: not deadlocked\n", CPU->id);
+#endif
+
+#ifdef CONFIG_SPINLOCK_STATS
+	lock->stats.acquisitions++;
+	if (spins > 0) {
+		lock->stats.contended++;
+		lock->stats.spins += spins;
+	}
+	lock->stats.acquired = get_cycle();
+#endif
 }
 
 /** Unlock spinlock
@@ -126,11 +250,17 @@ void spinlock_unlock_debug(spinlock_t *lock)
 {
 	ASSERT_SPINLOCK(spinlock_locked(lock), lock);
 
-	atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+#ifdef CONFIG_SPINLOCK_STATS
+	uint64_t held = get_cycle() - lock->stats.acquired;
+	if (held > lock->stats.max_hold)
+		lock->stats.max_hold = held;
+#endif
+
+	spinlock_release(lock);
 	preemption_enable();
 }
 
-#endif
+#endif /* SPINLOCK_NAMED */
 
 /** Lock spinlock conditionally
  *
@@ -145,11 +275,18 @@ void spinlock_unlock_debug(spinlock_t *lock)
 bool spinlock_trylock(spinlock_t *lock)
 {
 	preemption_disable();
-	bool ret = !atomic_flag_test_and_set_explicit(&lock->flag, memory_order_acquire);
+	bool ret = spinlock_try_acquire(lock);
 
 	if (!ret)
 		preemption_enable();
 
+#ifdef CONFIG_SPINLOCK_STATS
+	if (ret) {
+		lock->stats.acquisitions++;
+		lock->stats.acquired = get_cycle();
+	}
+#endif
+
 	return ret;
 }
 
@@ -160,6 +297,10 @@ bool spinlock_trylock(spinlock_t *lock)
  */
 bool spinlock_locked(spinlock_t *lock)
 {
+#ifdef CONFIG_TICKET_SPINLOCK
+	return atomic_load_explicit(&lock->next, memory_order_relaxed) !=
+	    atomic_load_explicit(&lock->owner, memory_order_relaxed);
+#else
 	// NOTE: Atomic flag doesn't support simple atomic read (by design),
 	//       so instead we test_and_set and then clear if necessary.
 	//       This function is only used inside assert, so we don't need
@@ -169,8 +310,62 @@ bool spinlock_locked(spinlock_t *lock)
 	if (!ret)
 		atomic_flag_clear_explicit(&lock->flag, memory_order_relaxed);
 	return ret;
+#endif
+}
+
+#ifdef CONFIG_SPINLOCK_STATS
+
+/** Report contention statistics of a spinlock
+ *
+ * The statistics of the spinlock are listed by spinlock_stats_print()
+ * until the spinlock is unregistered.
+ *
+ * @param lock Initialized spinlock.
+ *
+ */
+void spinlock_stats_register(spinlock_t *lock)
+{
+	spinlock_lock(&spinlock_stats_lock);
+	if (!link_in_use(&lock->stats.link))
+		list_append(&lock->stats.link, &spinlock_stats_list);
+	spinlock_unlock(&spinlock_stats_lock);
 }
 
+/** Stop reporting contention statistics of a spinlock
+ *
+ * Must be called before the memory of a registered spinlock is freed.
+ *
+ * @param lock Registered spinlock.
+ *
+ */
+void spinlock_stats_unregister(spinlock_t *lock)
+{
+	spinlock_lock(&spinlock_stats_lock);
+	if (link_in_use(&lock->stats.link))
+		list_remove(&lock->stats.link);
+	spinlock_unlock(&spinlock_stats_lock);
+}
+
+/** Print contention statistics of all registered spinlocks */
+void spinlock_stats_print(void)
+{
+	printf("[spinlock                ] [acquisitions  ] [contended     ]"
+	    " [spins           ] [max hold cycles ]\n");
+
+	spinlock_lock(&spinlock_stats_lock);
+
+	list_foreach(spinlock_stats_list, stats.link, spinlock_t, lock) {
+		printf("%-26s %16" PRIu64 " %16" PRIu64 " %18" PRIu64
+		    " %18" PRIu64 "\n", lock->name, lock->stats.acquisitions,
+		    lock->stats.contended, lock->stats.spins,
+		    lock->stats.max_hold);
+	}
+
+	spinlock_unlock(&spinlock_stats_lock);
+}
+
+#endif /* CONFIG_SPINLOCK_STATS */
+
 #endif
 
 /** Initialize interrupts-disabled spinlock
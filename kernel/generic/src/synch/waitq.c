@@ -495,9 +495,12 @@ static void waitq_complete_wakeup(waitq_t *wq)
  * @param wq   Pointer to wait queue.
  * @param mode If mode is WAKEUP_FIRST, then the longest waiting
  *             thread, if any, is woken up. If mode is WAKEUP_ALL, then
- *             all waiting threads, if any, are woken up. If there are
- *             no waiting threads to be woken up, the missed wakeup is
- *             recorded in the wait queue.
+ *             all waiting threads, if any, are woken up. If mode is
+ *             WAKEUP_HANDOFF, the longest waiting thread is woken up
+ *             and handed the current processor, see
+ *             thread_ready_handoff(). If there are no waiting threads
+ *             to be woken up, the missed wakeup is recorded in the
+ *             wait queue.
  *
  */
 void _waitq_wakeup_unsafe(waitq_t *wq, wakeup_mode_t mode)
@@ -508,7 +511,7 @@ void _waitq_wakeup_unsafe(waitq_t *wq, wakeup_mode_t mode)
 	assert(irq_spinlock_locked(&wq->lock));
 
 	if (wq->ignore_wakeups > 0) {
-		if (mode == WAKEUP_FIRST) {
+		if (mode != WAKEUP_ALL) {
 			wq->ignore_wakeups--;
 			return;
 		}
@@ -555,12 +558,95 @@ loop:
 	thread->sleep_queue = NULL;
 	irq_spinlock_unlock(&thread->lock, false);
 
-	thread_ready(thread);
+	if (mode == WAKEUP_HANDOFF)
+		thread_ready_handoff(thread);
+	else
+		thread_ready(thread);
 
 	if (mode == WAKEUP_ALL)
 		goto loop;
 }
 
+/** Move sleepers to another wait queue instead of waking them up
+ *
+ * This is wait morphing for condition variables. A sleeper that set
+ * its sleep_morph_queue continues sleeping there as though it went to
+ * sleep in it, so that waking it up does not make it contend for the
+ * resource the morph queue guards. If the morph queue has a missed
+ * wakeup, which means a semaphore is available, the sleeper takes it
+ * and is woken up right away as its owner. Either way, the sleeper
+ * finds sleep_morphed set once it runs again.
+ *
+ * Sleepers without a morph queue and sleepers whose timeout is already
+ * being handled are woken up as by waitq_wakeup().
+ *
+ * @param wq  Pointer to wait queue.
+ * @param all Move all sleepers rather than just the longest waiting one.
+ *
+ */
+void waitq_wakeup_morph(waitq_t *wq, bool all)
+{
+	irq_spinlock_lock(&wq->lock, true);
+
+	if ((list_empty(&wq->sleepers)) || (wq->ignore_wakeups > 0)) {
+		_waitq_wakeup_unsafe(wq, all ? WAKEUP_ALL : WAKEUP_FIRST);
+		irq_spinlock_unlock(&wq->lock, true);
+		return;
+	}
+
+	do {
+		thread_t *thread = list_get_instance(list_first(&wq->sleepers),
+		    thread_t, wq_link);
+
+		/*
+		 * The morph queue is stable while the thread sleeps in wq.
+		 * Lock it before the thread to keep the wait queue before
+		 * thread lock ordering.
+		 */
+		waitq_t *dst = thread->sleep_morph_queue;
+		if (dst != NULL)
+			irq_spinlock_lock(&dst->lock, false);
+
+		irq_spinlock_lock(&thread->lock, false);
+
+		if ((thread->timeout_pending) &&
+		    (timeout_unregister(&thread->sleep_timeout)))
+			thread->timeout_pending = false;
+
+		if ((dst == NULL) || (thread->timeout_pending) ||
+		    (thread->sleep_composable)) {
+			irq_spinlock_unlock(&thread->lock, false);
+			if (dst != NULL)
+				irq_spinlock_unlock(&dst->lock, false);
+			_waitq_wakeup_unsafe(wq, WAKEUP_FIRST);
+			continue;
+		}
+
+		list_remove(&thread->wq_link);
+
+		/* Already signalled, only the wakeup from dst is missing */
+		thread->sleep_interruptible = false;
+		thread->sleep_morphed = true;
+
+		bool owner = (dst->missed_wakeups > 0);
+		if (owner) {
+			dst->missed_wakeups--;
+			thread->sleep_queue = NULL;
+		} else {
+			list_append(&thread->wq_link, &dst->sleepers);
+			thread->sleep_queue = dst;
+		}
+
+		irq_spinlock_unlock(&thread->lock, false);
+		irq_spinlock_unlock(&dst->lock, false);
+
+		if (owner)
+			thread_ready(thread);
+	} while ((all) && (!list_empty(&wq->sleepers)));
+
+	irq_spinlock_unlock(&wq->lock, true);
+}
+
 /** Get the missed wakeups count.
  *
  * @param wq	Pointer to wait queue.
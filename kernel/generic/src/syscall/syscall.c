@@ -54,6 +54,8 @@
 #include <console/console.h>
 #include <udebug/udebug.h>
 #include <log.h>
+#include <profile.h>
+#include <arch/cycle.h>
 
 /** Dispatch system call */
 sysarg_t syscall_handler(sysarg_t a1, sysarg_t a2, sysarg_t a3,
@@ -78,6 +80,10 @@ sysarg_t syscall_handler(sysarg_t a1, sysarg_t a2, sysarg_t a3,
 	 */
 	if (THREAD->udebug.active)
 		udebug_syscall_event(a1, a2, a3, a4, a5, a6, id, 0, false);
+
+	/* Sampling sessions only count system calls, nothing is locked */
+	bool sampled = TASK->udebug.stats_enabled;
+	uint64_t start = sampled ? get_cycle() : 0;
 #endif
 
 	sysarg_t rc;
@@ -89,6 +95,11 @@ sysarg_t syscall_handler(sysarg_t a1, sysarg_t a2, sysarg_t a3,
 		task_kill_self(true);
 	}
 
+#ifdef CONFIG_UDEBUG
+	if (sampled)
+		udebug_stats_syscall(id, get_cycle() - start);
+#endif
+
 	if (THREAD->interrupted)
 		thread_exit();
 
@@ -159,6 +170,7 @@ syshandler_t syscall_table[SYSCALL_END] = {
 	[SYS_IPC_FORWARD_FAST] = (syshandler_t) sys_ipc_forward_fast,
 	[SYS_IPC_FORWARD_SLOW] = (syshandler_t) sys_ipc_forward_slow,
 	[SYS_IPC_WAIT] = (syshandler_t) sys_ipc_wait_for_call,
+	[SYS_IPC_WAIT_BATCH] = (syshandler_t) sys_ipc_wait_for_calls,
 	[SYS_IPC_POKE] = (syshandler_t) sys_ipc_poke,
 	[SYS_IPC_HANGUP] = (syshandler_t) sys_ipc_hangup,
 	[SYS_IPC_CONNECT_KBOX] = (syshandler_t) sys_ipc_connect_kbox,
@@ -182,6 +194,8 @@ syshandler_t syscall_table[SYSCALL_END] = {
 
 	[SYS_IPC_IRQ_SUBSCRIBE] = (syshandler_t) sys_ipc_irq_subscribe,
 	[SYS_IPC_IRQ_UNSUBSCRIBE] = (syshandler_t) sys_ipc_irq_unsubscribe,
+	[SYS_IPC_IRQ_SET_FLAGS] = (syshandler_t) sys_ipc_irq_set_flags,
+	[SYS_IPC_IRQ_SET_CPU] = (syshandler_t) sys_ipc_irq_set_cpu,
 
 	/* Sysinfo syscalls. */
 	[SYS_SYSINFO_GET_KEYS_SIZE] = (syshandler_t) sys_sysinfo_get_keys_size,
@@ -195,6 +209,8 @@ syshandler_t syscall_table[SYSCALL_END] = {
 	[SYS_DEBUG_CONSOLE] = (syshandler_t) sys_debug_console,
 
 	[SYS_KLOG] = (syshandler_t) sys_klog,
+
+	[SYS_PROFILE] = (syshandler_t) sys_profile,
 };
 
 /** @}
@@ -43,6 +43,7 @@
 #include <synch/mutex.h>
 #include <time/clock.h>
 #include <mm/frame.h>
+#include <mm/numa.h>
 #include <proc/task.h>
 #include <proc/thread.h>
 #include <interrupt.h>
@@ -117,8 +118,16 @@ static void *get_stats_cpus(struct sysinfo_item *item, size_t *size,
 		stats_cpus[i].frequency_mhz = cpus[i].frequency_mhz;
 		stats_cpus[i].busy_cycles = cpus[i].busy_cycles;
 		stats_cpus[i].idle_cycles = cpus[i].idle_cycles;
+		stats_cpus[i].threads_created = cpus[i].threads_created;
+		stats_cpus[i].threads_destroyed = cpus[i].threads_destroyed;
+		stats_cpus[i].kstacks_allocated = cpus[i].kstacks_allocated;
+		stats_cpus[i].fpu_contexts_allocated =
+		    cpus[i].fpu_contexts_allocated;
 
 		irq_spinlock_unlock(&cpus[i].lock, true);
+
+		frame_cpucache_stats(i, &stats_cpus[i].frame_cache_hits,
+		    &stats_cpus[i].frame_cache_misses);
 	}
 
 	return ((void *) stats_cpus);
@@ -134,31 +143,11 @@ static void *get_stats_cpus(struct sysinfo_item *item, size_t *size,
 static size_t get_task_virtmem(as_t *as)
 {
 	/*
-	 * We are holding spinlocks here and therefore are not allowed to
-	 * block. Only attempt to lock the address space and address space
-	 * area mutexes conditionally. If it is not possible to lock either
-	 * object, return inexact statistics by skipping the respective object.
+	 * The counter is maintained when address space areas are created,
+	 * resized and destroyed, so there is no need to walk the areas
+	 * while holding spinlocks.
 	 */
-
-	if (mutex_trylock(&as->lock) != EOK)
-		return 0;
-
-	size_t pages = 0;
-
-	/* Walk areas in the address space and count pages */
-	as_area_t *area = as_area_first(as);
-	while (area != NULL) {
-		if (mutex_trylock(&area->lock) != EOK)
-			continue;
-
-		pages += area->pages;
-		mutex_unlock(&area->lock);
-		area = as_area_next(area);
-	}
-
-	mutex_unlock(&as->lock);
-
-	return (pages << PAGE_WIDTH);
+	return (atomic_load(&as->virt_pages) << PAGE_WIDTH);
 }
 
 /** Get the resident (used) size of a virtual address space
@@ -170,32 +159,8 @@ static size_t get_task_virtmem(as_t *as)
  */
 static size_t get_task_resmem(as_t *as)
 {
-	/*
-	 * We are holding spinlocks here and therefore are not allowed to
-	 * block. Only attempt to lock the address space and address space
-	 * area mutexes conditionally. If it is not possible to lock either
-	 * object, return inexact statistics by skipping the respective object.
-	 */
-
-	if (mutex_trylock(&as->lock) != EOK)
-		return 0;
-
-	size_t pages = 0;
-
-	/* Walk areas in the address space and count pages */
-	as_area_t *area = as_area_first(as);
-	while (area != NULL) {
-		if (mutex_trylock(&area->lock) != EOK)
-			continue;
-
-		pages += area->used_space.pages;
-		mutex_unlock(&area->lock);
-		area = as_area_next(area);
-	}
-
-	mutex_unlock(&as->lock);
-
-	return (pages << PAGE_WIDTH);
+	/* Maintained when pages are mapped and unmapped */
+	return (atomic_load(&as->resident_pages) << PAGE_WIDTH);
 }
 
 /** Produce task statistics
@@ -218,6 +183,7 @@ static void produce_stats_task(task_t *task, stats_task_t *stats_task)
 	stats_task->threads = atomic_load(&task->refcount);
 	task_get_accounting(task, &(stats_task->ucycles),
 	    &(stats_task->kcycles));
+	stats_task->page_faults = task->as->faults;
 	stats_task->ipc_info = task->ipc_info;
 }
 
@@ -667,6 +633,42 @@ static void *get_stats_physmem(struct sysinfo_item *item, size_t *size,
 	return ((void *) stats_physmem);
 }
 
+/** Get physical memory statistics of the memory nodes
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing several stats_physmem_node_t structures.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_physmem_nodes(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	unsigned int nodes = numa_node_count();
+
+	*size = sizeof(stats_physmem_node_t) * nodes;
+	if (dry_run)
+		return NULL;
+
+	stats_physmem_node_t *stats_nodes =
+	    (stats_physmem_node_t *) malloc(*size);
+	if (stats_nodes == NULL) {
+		*size = 0;
+		return NULL;
+	}
+
+	for (unsigned int i = 0; i < nodes; i++) {
+		stats_nodes[i].node = i;
+		zones_node_stats(i, &(stats_nodes[i].total),
+		    &(stats_nodes[i].used), &(stats_nodes[i].free));
+	}
+
+	return ((void *) stats_nodes);
+}
+
 /** Get system load
  *
  * @param item    Sysinfo item (unused).
@@ -750,6 +752,7 @@ void stats_init(void)
 
 	sysinfo_set_item_gen_data("system.cpus", NULL, get_stats_cpus, NULL);
 	sysinfo_set_item_gen_data("system.physmem", NULL, get_stats_physmem, NULL);
+	sysinfo_set_item_gen_data("system.physmem_nodes", NULL, get_stats_physmem_nodes, NULL);
 	sysinfo_set_item_gen_data("system.load", NULL, get_stats_load, NULL);
 	sysinfo_set_item_gen_data("system.tasks", NULL, get_stats_tasks, NULL);
 	sysinfo_set_item_gen_data("system.threads", NULL, get_stats_threads, NULL);
@@ -57,6 +57,8 @@
 #include <mm/frame.h>
 #include <ddi/ddi.h>
 #include <arch/cycle.h>
+#include <arch/asm.h>
+#include <profile.h>
 
 /* Pointer to variable with uptime */
 uptime_t *uptime;
@@ -64,6 +66,9 @@ uptime_t *uptime;
 /** Physical memory area of the real time clock */
 static parea_t clock_parea;
 
+/** Fixed-point shift of the nanoseconds per cycle */
+#define CLOCK_COUNTER_SHIFT  24
+
 /** Fragment of second
  *
  * For updating  seconds correctly.
@@ -90,6 +95,26 @@ void clock_counter_init(void)
 	uptime->seconds2 = 0;
 	uptime->useconds = 0;
 
+	uptime->counter_seq = 0;
+	uptime->counter_shift = CLOCK_COUNTER_SHIFT;
+	uptime->counter_mult = 0;
+	uptime->counter_base = 0;
+	uptime->nsec_base = 0;
+
+#ifdef CLOCK_COUNTER_ARCH
+	/*
+	 * The userspace can compute the uptime from the cycle counter if it
+	 * runs at a constant rate. The counter starts to count the uptime
+	 * now, when the uptime is zero.
+	 */
+	if ((clock_counter_invariant_arch()) && (CPU->frequency_mhz != 0)) {
+		uptime->counter_base = get_cycle();
+		uptime->counter_mult =
+		    ((uint64_t) 1000 << CLOCK_COUNTER_SHIFT) /
+		    CPU->frequency_mhz;
+	}
+#endif
+
 	ddi_parea_init(&clock_parea);
 	clock_parea.pbase = faddr;
 	clock_parea.frames = 1;
@@ -105,6 +130,43 @@ void clock_counter_init(void)
 	sysinfo_set_item_val("clock.faddr", NULL, (sysarg_t) faddr);
 }
 
+/** Convert cycles to nanoseconds without overflowing
+ *
+ * @param cycles Number of cycles.
+ *
+ * @return Number of nanoseconds.
+ *
+ */
+static uint64_t clock_counter_scale(uint64_t cycles)
+{
+	uint64_t mask = ((uint64_t) 1 << CLOCK_COUNTER_SHIFT) - 1;
+
+	return (cycles >> CLOCK_COUNTER_SHIFT) * uptime->counter_mult +
+	    (((cycles & mask) * uptime->counter_mult) >> CLOCK_COUNTER_SHIFT);
+}
+
+/** Move the base of the cycle counter uptime to the current cycle
+ *
+ * Keeps the cycle differences which the userspace has to scale small.
+ *
+ */
+static void clock_counter_rebase(void)
+{
+	if (uptime->counter_mult == 0)
+		return;
+
+	uint64_t now = get_cycle();
+	uint64_t nsec = uptime->nsec_base +
+	    clock_counter_scale(now - uptime->counter_base);
+
+	uptime->counter_seq++;
+	write_barrier();
+	uptime->counter_base = now;
+	uptime->nsec_base = nsec;
+	write_barrier();
+	uptime->counter_seq++;
+}
+
 /** Update public counters
  *
  * Update it only on first processor
@@ -122,6 +184,8 @@ static void clock_update_counters(void)
 			uptime->useconds = secfrag;
 			write_barrier();
 			uptime->seconds2 = uptime->seconds1;
+
+			clock_counter_rebase();
 		} else
 			uptime->useconds += 1000000 / HZ;
 	}
@@ -136,6 +200,161 @@ static void cpu_update_accounting(void)
 	irq_spinlock_unlock(&CPU->lock, false);
 }
 
+#ifdef CLOCK_TICKLESS_ARCH
+
+/** Maximum number of ticks for which the clock tick may be stopped. */
+#define CLOCK_TICK_STOP_MAX  HZ
+
+/** Cycles of the current processor per clock tick. */
+static uint64_t clock_cycles_per_tick(void)
+{
+	return (uint64_t) CPU->frequency_mhz * (1000000 / HZ);
+}
+
+/** Stop the periodic clock tick of the current processor
+ *
+ * The clock interrupt is reprogrammed to come in time for the next
+ * timeout that needs to be processed.
+ *
+ * @return True if the clock tick was stopped.
+ *
+ */
+static bool clock_tick_stop(void)
+{
+	if (atomic_load(&CPU->tick_stopped))
+		return true;
+
+	if (clock_cycles_per_tick() == 0)
+		return false;
+
+	uint64_t ticks = timeout_next(CLOCK_TICK_STOP_MAX);
+	if (ticks <= 1)
+		return false;
+
+	if (!clock_tick_stop_arch(ticks))
+		return false;
+
+	CPU->tick_stop_cycle = get_cycle();
+	atomic_store(&CPU->tick_stopped, true);
+	return true;
+}
+
+/** Restart the periodic clock tick of the current processor
+ *
+ * @return Number of whole clock ticks that elapsed while the clock tick
+ *         was stopped.
+ *
+ */
+static size_t clock_tick_start(void)
+{
+	assert(atomic_load(&CPU->tick_stopped));
+
+	uint64_t cpt = clock_cycles_per_tick();
+	uint64_t cycles = get_cycle() - CPU->tick_stop_cycle +
+	    CPU->tick_cycles_rem;
+
+	clock_tick_start_arch();
+	atomic_store(&CPU->tick_stopped, false);
+
+	CPU->tick_cycles_rem = cycles % cpt;
+	return cycles / cpt;
+}
+
+#endif /* CLOCK_TICKLESS_ARCH */
+
+/** Stop the clock tick before the current processor goes idle
+ *
+ * Must be called with interrupts disabled. If a thread becomes ready on
+ * the current processor while the tick is stopped, clock_tick_kick()
+ * restarts it.
+ *
+ * @return False if a thread became ready in the meantime and the processor
+ *         must not go to sleep.
+ *
+ */
+bool clock_idle_enter(void)
+{
+#ifdef CLOCK_TICKLESS_ARCH
+	if (!clock_tick_stop())
+		return true;
+
+	/* Pairs with the check in clock_tick_kick(). */
+	if (atomic_load(&CPU->nrdy) != 0) {
+		clock_idle_exit();
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+/** Restart the clock tick after the current processor woke up
+ *
+ * Must be called with interrupts disabled.
+ *
+ */
+void clock_idle_exit(void)
+{
+#ifdef CLOCK_TICKLESS_ARCH
+	if (atomic_load(&CPU->tick_stopped))
+		clock_tick_restart();
+#endif
+}
+
+/** Restart the stopped clock tick of the current processor
+ *
+ * The ticks that elapsed in the meantime are processed by the next run
+ * of clock(). Must be called with interrupts disabled.
+ *
+ */
+void clock_tick_restart(void)
+{
+#ifdef CLOCK_TICKLESS_ARCH
+	if (atomic_load(&CPU->tick_stopped))
+		CPU->missed_clock_ticks += clock_tick_start();
+#endif
+}
+
+/** Make sure a processor notices a thread that became ready on it
+ *
+ * Wakes up the processor if its clock tick is stopped. If the processor
+ * has more ready threads than it can run, an idle processor with a stopped
+ * tick is woken up as well so that it can steal one.
+ *
+ * @param cpu Processor on which a thread became ready.
+ *
+ */
+void clock_tick_kick(cpu_t *cpu)
+{
+#ifdef CLOCK_TICKLESS_ARCH
+	if (atomic_load(&cpu->tick_stopped)) {
+		if (cpu == CPU) {
+			ipl_t ipl = interrupts_disable();
+			clock_tick_restart();
+			interrupts_restore(ipl);
+		} else
+			clock_tick_wakeup_arch(cpu);
+
+		return;
+	}
+
+	if (atomic_load(&cpu->nrdy) < 2)
+		return;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		cpu_t *idle = &cpus[i];
+
+		if ((idle != cpu) && (idle->active) && (idle->idle) &&
+		    (atomic_load(&idle->tick_stopped))) {
+			clock_tick_wakeup_arch(idle);
+			break;
+		}
+	}
+#else
+	(void) cpu;
+#endif
+}
+
 /** Clock routine
  *
  * Clock routine executed from clock interrupt handler
@@ -145,14 +364,25 @@ static void cpu_update_accounting(void)
  */
 void clock(void)
 {
+#ifdef CLOCK_TICKLESS_ARCH
+	/* The interrupt itself accounts for one of the elapsed ticks. */
+	if (atomic_load(&CPU->tick_stopped)) {
+		size_t elapsed = clock_tick_start();
+		if (elapsed > 1)
+			CPU->missed_clock_ticks += elapsed - 1;
+	}
+#endif
+
 	size_t missed_clock_ticks = CPU->missed_clock_ticks;
 
+	profile_sample();
+
 	/* Account CPU usage */
 	cpu_update_accounting();
 
 	/*
-	 * To avoid lock ordering problems,
-	 * run all expired timeouts as you visit them.
+	 * Advance the timing wheel once for every tick,
+	 * running all timeouts that expire.
 	 *
 	 */
 	size_t i;
@@ -161,33 +391,7 @@ void clock(void)
 		clock_update_counters();
 		cpu_update_accounting();
 
-		irq_spinlock_lock(&CPU->timeoutlock, false);
-
-		link_t *cur;
-		while ((cur = list_first(&CPU->timeout_active_list)) != NULL) {
-			timeout_t *timeout = list_get_instance(cur, timeout_t,
-			    link);
-
-			irq_spinlock_lock(&timeout->lock, false);
-			if (timeout->ticks-- != 0) {
-				irq_spinlock_unlock(&timeout->lock, false);
-				break;
-			}
-
-			list_remove(cur);
-			timeout_handler_t handler = timeout->handler;
-			void *arg = timeout->arg;
-			timeout_reinitialize(timeout);
-
-			irq_spinlock_unlock(&timeout->lock, false);
-			irq_spinlock_unlock(&CPU->timeoutlock, false);
-
-			handler(arg);
-
-			irq_spinlock_lock(&CPU->timeoutlock, false);
-		}
-
-		irq_spinlock_unlock(&CPU->timeoutlock, false);
+		timeout_tick();
 	}
 	CPU->missed_clock_ticks = 0;
 
@@ -224,6 +428,16 @@ void clock(void)
 				udebug_before_thread_runs();
 #endif
 		}
+#ifdef CLOCK_TICKLESS_ARCH
+		else if (atomic_load(&CPU->nrdy) == 0) {
+			/*
+			 * Nothing else to run on this CPU, so there is no need
+			 * for the periodic tick until the next timeout.
+			 */
+			if ((clock_tick_stop()) && (atomic_load(&CPU->nrdy) != 0))
+				clock_tick_restart();
+		}
+#endif
 	}
 }
 
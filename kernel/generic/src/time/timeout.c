@@ -44,6 +44,14 @@
 #include <cpu.h>
 #include <arch/asm.h>
 #include <arch.h>
+#include <assert.h>
+#include <time/clock.h>
+
+#define TIMEOUT_WHEEL_MASK   (TIMEOUT_WHEEL_SLOTS - 1)
+
+/** Number of ticks covered by the whole timing wheel. */
+#define TIMEOUT_WHEEL_RANGE \
+	(UINT64_C(1) << (TIMEOUT_WHEEL_LEVELS * TIMEOUT_WHEEL_BITS))
 
 /** Initialize timeouts
  *
@@ -53,7 +61,62 @@
 void timeout_init(void)
 {
 	irq_spinlock_initialize(&CPU->timeoutlock, "cpu.timeoutlock");
-	list_initialize(&CPU->timeout_active_list);
+
+	for (unsigned int l = 0; l < TIMEOUT_WHEEL_LEVELS; l++) {
+		for (unsigned int s = 0; s < TIMEOUT_WHEEL_SLOTS; s++)
+			list_initialize(&CPU->timeout_wheel[l][s]);
+	}
+
+	CPU->timeout_ticks = 0;
+}
+
+/** Insert timeout into the timing wheel of a processor
+ *
+ * The level is chosen by the distance of the deadline, the slot by the
+ * corresponding bits of the deadline. Timeouts too far in the future are
+ * parked in the last level and reinserted when it cascades.
+ *
+ * @param cpu     Processor whose timing wheel to use.
+ * @param timeout Timeout with the deadline set.
+ *
+ */
+static void timeout_wheel_insert(cpu_t *cpu, timeout_t *timeout)
+{
+	assert(irq_spinlock_locked(&cpu->timeoutlock));
+
+	uint64_t expires = timeout->deadline;
+	uint64_t delta = expires - cpu->timeout_ticks;
+	if (delta >= TIMEOUT_WHEEL_RANGE)
+		expires = cpu->timeout_ticks + TIMEOUT_WHEEL_RANGE - 1;
+
+	unsigned int level = 0;
+	while ((level < TIMEOUT_WHEEL_LEVELS - 1) &&
+	    (delta >> ((level + 1) * TIMEOUT_WHEEL_BITS)) != 0)
+		level++;
+
+	unsigned int slot = (expires >> (level * TIMEOUT_WHEEL_BITS)) &
+	    TIMEOUT_WHEEL_MASK;
+
+	list_append(&timeout->link, &cpu->timeout_wheel[level][slot]);
+}
+
+/** Move timeouts from a slot of a higher level to the lower levels
+ *
+ * @param level Level of the slot.
+ * @param slot  Slot to cascade.
+ *
+ */
+static void timeout_wheel_cascade(unsigned int level, unsigned int slot)
+{
+	list_t *list = &CPU->timeout_wheel[level][slot];
+	link_t *cur;
+
+	while ((cur = list_first(list)) != NULL) {
+		timeout_t *timeout = list_get_instance(cur, timeout_t, link);
+
+		list_remove(cur);
+		timeout_wheel_insert(CPU, timeout);
+	}
 }
 
 /** Reinitialize timeout
@@ -66,7 +129,7 @@ void timeout_init(void)
 void timeout_reinitialize(timeout_t *timeout)
 {
 	timeout->cpu = NULL;
-	timeout->ticks = 0;
+	timeout->deadline = 0;
 	timeout->handler = NULL;
 	timeout->arg = NULL;
 	link_initialize(&timeout->link);
@@ -88,7 +151,7 @@ void timeout_initialize(timeout_t *timeout)
 /** Register timeout
  *
  * Insert timeout handler f (with argument arg)
- * to timeout list and make it execute in
+ * to the timing wheel and make it execute in
  * time microseconds (or slightly more).
  *
  * @param timeout Timeout structure.
@@ -107,57 +170,27 @@ void timeout_register(timeout_t *timeout, uint64_t time,
 		panic("Unexpected: timeout->cpu != 0.");
 
 	timeout->cpu = CPU;
-	timeout->ticks = us2ticks(time);
+
+	/* The timeout fires on the (us2ticks(time) + 1)-th clock tick. */
+	timeout->deadline = CPU->timeout_ticks + us2ticks(time) + 1;
 
 	timeout->handler = handler;
 	timeout->arg = arg;
 
-	/*
-	 * Insert timeout into the active timeouts list according to timeout->ticks.
-	 */
-	uint64_t sum = 0;
-	timeout_t *target = NULL;
-	link_t *cur;
-	for (cur = CPU->timeout_active_list.head.next;
-	    cur != &CPU->timeout_active_list.head; cur = cur->next) {
-		target = list_get_instance(cur, timeout_t, link);
-		irq_spinlock_lock(&target->lock, false);
+	timeout_wheel_insert(CPU, timeout);
 
-		if (timeout->ticks < sum + target->ticks) {
-			irq_spinlock_unlock(&target->lock, false);
-			break;
-		}
-
-		sum += target->ticks;
-		irq_spinlock_unlock(&target->lock, false);
-	}
-
-	/* Avoid using cur->prev directly */
-	link_t *prev = cur->prev;
-	list_insert_after(&timeout->link, prev);
-
-	/*
-	 * Adjust timeout->ticks according to ticks
-	 * accumulated in target's predecessors.
-	 */
-	timeout->ticks -= sum;
+	irq_spinlock_unlock(&timeout->lock, false);
 
-	/*
-	 * Decrease ticks of timeout's immediate succesor by timeout->ticks.
-	 */
-	if (cur != &CPU->timeout_active_list.head) {
-		irq_spinlock_lock(&target->lock, false);
-		target->ticks -= timeout->ticks;
-		irq_spinlock_unlock(&target->lock, false);
-	}
+	/* The stopped clock tick might not come in time for the timeout. */
+	if (atomic_load(&CPU->tick_stopped))
+		clock_tick_restart();
 
-	irq_spinlock_unlock(&timeout->lock, false);
 	irq_spinlock_unlock(&CPU->timeoutlock, true);
 }
 
 /** Unregister timeout
  *
- * Remove timeout from timeout list.
+ * Remove timeout from the timing wheel.
  *
  * @param timeout Timeout to unregister.
  *
@@ -183,17 +216,9 @@ grab_locks:
 
 	/*
 	 * Now we know for sure that timeout hasn't been activated yet
-	 * and is lurking in timeout->cpu->timeout_active_list.
+	 * and is lurking in timeout->cpu->timeout_wheel.
 	 */
 
-	link_t *cur = timeout->link.next;
-	if (cur != &timeout->cpu->timeout_active_list.head) {
-		timeout_t *tmp = list_get_instance(cur, timeout_t, link);
-		irq_spinlock_lock(&tmp->lock, false);
-		tmp->ticks += timeout->ticks;
-		irq_spinlock_unlock(&tmp->lock, false);
-	}
-
 	list_remove(&timeout->link);
 	irq_spinlock_unlock(&timeout->cpu->timeoutlock, false);
 
@@ -203,5 +228,94 @@ grab_locks:
 	return true;
 }
 
+/** Advance the timing wheel of the current processor by one tick
+ *
+ * Cascades the higher levels whose turn it is and runs all timeouts that
+ * expire in this tick. To avoid lock ordering problems, the handlers are
+ * called without holding the timeout lock.
+ *
+ * Must be called with interrupts disabled.
+ *
+ */
+void timeout_tick(void)
+{
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+
+	uint64_t now = ++CPU->timeout_ticks;
+
+	for (unsigned int l = 1; l < TIMEOUT_WHEEL_LEVELS; l++) {
+		if ((now & ((UINT64_C(1) << (l * TIMEOUT_WHEEL_BITS)) - 1)) != 0)
+			break;
+
+		timeout_wheel_cascade(l,
+		    (now >> (l * TIMEOUT_WHEEL_BITS)) & TIMEOUT_WHEEL_MASK);
+	}
+
+	list_t *list = &CPU->timeout_wheel[0][now & TIMEOUT_WHEEL_MASK];
+	link_t *cur;
+	while ((cur = list_first(list)) != NULL) {
+		timeout_t *timeout = list_get_instance(cur, timeout_t, link);
+
+		irq_spinlock_lock(&timeout->lock, false);
+		assert(timeout->deadline == now);
+
+		list_remove(cur);
+		timeout_handler_t handler = timeout->handler;
+		void *arg = timeout->arg;
+		timeout_reinitialize(timeout);
+
+		irq_spinlock_unlock(&timeout->lock, false);
+		irq_spinlock_unlock(&CPU->timeoutlock, false);
+
+		handler(arg);
+
+		irq_spinlock_lock(&CPU->timeoutlock, false);
+	}
+
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+}
+
+/** Get the number of ticks until the next timeout of the current CPU
+ *
+ * The result may be smaller than the time until the earliest timeout
+ * actually expires if a higher level of the timing wheel needs to be
+ * cascaded before. The caller then simply checks again later.
+ *
+ * Must be called with interrupts disabled.
+ *
+ * @param limit Maximum number of ticks to return.
+ *
+ * @return Number of clock ticks until timeout_tick() has some work to do,
+ *         but at most @a limit.
+ *
+ */
+uint64_t timeout_next(uint64_t limit)
+{
+	irq_spinlock_lock(&CPU->timeoutlock, false);
+
+	uint64_t now = CPU->timeout_ticks;
+	uint64_t next = limit;
+
+	for (unsigned int l = 0; l < TIMEOUT_WHEEL_LEVELS; l++) {
+		unsigned int shift = l * TIMEOUT_WHEEL_BITS;
+
+		for (uint64_t k = 1; k <= TIMEOUT_WHEEL_SLOTS; k++) {
+			uint64_t tick = ((now >> shift) + k) << shift;
+			if (tick - now >= next)
+				break;
+
+			unsigned int slot = (tick >> shift) & TIMEOUT_WHEEL_MASK;
+			if (!list_empty(&CPU->timeout_wheel[l][slot])) {
+				next = tick - now;
+				break;
+			}
+		}
+	}
+
+	irq_spinlock_unlock(&CPU->timeoutlock, false);
+
+	return next;
+}
+
 /** @}
  */
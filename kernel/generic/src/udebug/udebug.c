@@ -38,7 +38,9 @@
  */
 
 #include <assert.h>
+#include <bitops.h>
 #include <debug.h>
+#include <stdlib.h>
 #include <synch/waitq.h>
 #include <udebug/udebug.h>
 #include <errno.h>
@@ -59,6 +61,21 @@ void udebug_task_init(udebug_task_t *ut)
 	ut->begin_call = NULL;
 	ut->not_stoppable_count = 0;
 	ut->evmask = 0;
+	ut->sampling = false;
+	ut->stats_enabled = false;
+	ut->stats = NULL;
+	spinlock_initialize(&ut->stats_lock, "udebug_stats_lock");
+}
+
+/** Finalize udebug part of task structure.
+ *
+ * Called when the task is destroyed.
+ * @param ut Pointer to the structure to finalize.
+ *
+ */
+void udebug_task_destroy(udebug_task_t *ut)
+{
+	free(ut->stats);
 }
 
 /** Initialize udebug part of thread structure.
@@ -271,6 +288,66 @@ void udebug_syscall_event(sysarg_t a1, sysarg_t a2, sysarg_t a3,
 	udebug_wait_for_go(&THREAD->udebug.go_wq);
 }
 
+/** Account a system call in a sampling session.
+ *
+ * @param id     Number of the system call.
+ * @param cycles Time spent in the system call (CPU cycles).
+ *
+ */
+void udebug_stats_syscall(sysarg_t id, uint64_t cycles)
+{
+	if (id >= UDEBUG_STATS_SYSCALLS)
+		return;
+
+	unsigned int bucket = (cycles > 0) ? fnzb64(cycles) : 0;
+	if (bucket >= UDEBUG_STATS_BUCKETS)
+		bucket = UDEBUG_STATS_BUCKETS - 1;
+
+	spinlock_lock(&TASK->udebug.stats_lock);
+
+	if (TASK->udebug.stats_enabled) {
+		udebug_syscall_stats_t *sc = &TASK->udebug.stats->syscalls[id];
+		sc->count++;
+		sc->cycles += cycles;
+		sc->hist[bucket]++;
+	}
+
+	spinlock_unlock(&TASK->udebug.stats_lock);
+}
+
+/** Account an IPC request in a sampling session.
+ *
+ * @param imethod Interface and method of the request.
+ *
+ */
+void udebug_stats_ipc(sysarg_t imethod)
+{
+	spinlock_lock(&TASK->udebug.stats_lock);
+
+	if (TASK->udebug.stats_enabled) {
+		udebug_stats_t *stats = TASK->udebug.stats;
+		udebug_ipc_stats_t *entry = NULL;
+
+		/* Methods are never removed, stop at the first gap */
+		for (size_t i = 0; i < UDEBUG_STATS_METHODS; i++) {
+			if (stats->methods[i].imethod == imethod ||
+			    stats->methods[i].imethod == 0) {
+				entry = &stats->methods[i];
+				break;
+			}
+		}
+
+		if (entry != NULL) {
+			entry->imethod = imethod;
+			entry->count++;
+		} else {
+			stats->methods_other++;
+		}
+	}
+
+	spinlock_unlock(&TASK->udebug.stats_lock);
+}
+
 /** Thread-creation event hook combined with attaching the thread.
  *
  * Must be called when a new userspace thread is created in the debugged
@@ -454,6 +531,11 @@ errno_t udebug_task_cleanup(struct task *task)
 			mutex_unlock(&thread->udebug.lock);
 	}
 
+	spinlock_lock(&task->udebug.stats_lock);
+	task->udebug.stats_enabled = false;
+	spinlock_unlock(&task->udebug.stats_lock);
+
+	task->udebug.sampling = false;
 	task->udebug.dt_state = UDEBUG_TS_INACTIVE;
 	task->udebug.debugger = NULL;
 
@@ -45,14 +45,67 @@
 #include <arch.h>
 #include <errno.h>
 #include <ipc/ipc.h>
+#include <macros.h>
+#include <stdlib.h>
 #include <syscall/copy.h>
 #include <udebug/udebug.h>
 #include <udebug/udebug_ops.h>
 #include <udebug/udebug_ipc.h>
 
+/** Fetch the list of ranges of a MEM_READV call.
+ *
+ * Runs in the context of the debugger, so that the list can be copied
+ * from its address space. The list is passed to the kbox thread in
+ * @c call->buffer.
+ *
+ * @param call	The call structure.
+ *
+ * @return EOK on success or an error code.
+ */
+static errno_t udebug_mem_readv_preprocess(call_t *call)
+{
+	size_t n = ipc_get_arg4(&call->data);
+	udebug_mem_range_t *ranges;
+	size_t total = 0;
+	errno_t rc;
+
+	if ((n == 0) || (n > UDEBUG_MEMV_MAX_RANGES))
+		return EINVAL;
+
+	ranges = malloc(n * sizeof(udebug_mem_range_t));
+	if (ranges == NULL)
+		return ENOMEM;
+
+	rc = copy_from_uspace(ranges, (void *) ipc_get_arg3(&call->data),
+	    n * sizeof(udebug_mem_range_t));
+	if (rc != EOK) {
+		free(ranges);
+		return rc;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		if (ranges[i].size > UDEBUG_MEMV_MAX_SIZE - total) {
+			free(ranges);
+			return ELIMIT;
+		}
+
+		total += ranges[i].size;
+	}
+
+	if (total == 0) {
+		free(ranges);
+		return EINVAL;
+	}
+
+	call->buffer = (uint8_t *) ranges;
+	return EOK;
+}
+
 errno_t udebug_request_preprocess(call_t *call, phone_t *phone)
 {
 	switch (ipc_get_arg1(&call->data)) {
+	case UDEBUG_M_MEM_READV:
+		return udebug_mem_readv_preprocess(call);
 		/* future UDEBUG_M_REGS_WRITE, UDEBUG_M_MEM_WRITE: */
 	default:
 		break;
@@ -73,7 +126,7 @@ static void udebug_receive_begin(call_t *call)
 	errno_t rc;
 	bool active;
 
-	rc = udebug_begin(call, &active);
+	rc = udebug_begin(call, ipc_get_arg2(&call->data), &active);
 	if (rc != EOK) {
 		ipc_set_retval(&call->data, rc);
 		ipc_answer(&TASK->kb.box, call);
@@ -252,6 +305,41 @@ static void udebug_receive_name_read(call_t *call)
 	ipc_answer(&TASK->kb.box, call);
 }
 
+/** Process a STATS_READ call.
+ *
+ * Returns the statistics collected in a sampling session as
+ * a udebug_stats_t structure.
+ *
+ * @param call	The call structure.
+ */
+static void udebug_receive_stats_read(call_t *call)
+{
+	sysarg_t uspace_addr;
+	size_t data_size;
+	size_t buf_size;
+	void *data;
+	errno_t rc;
+
+	uspace_addr = ipc_get_arg2(&call->data);	/* Dest. address */
+	buf_size = ipc_get_arg3(&call->data);	/* Dest. buffer size */
+
+	rc = udebug_stats_read(&data, &data_size);
+	if (rc != EOK) {
+		ipc_set_retval(&call->data, rc);
+		ipc_answer(&TASK->kb.box, call);
+		return;
+	}
+
+	/* Same answer layout as in udebug_receive_name_read() */
+	ipc_set_retval(&call->data, 0);
+	ipc_set_arg1(&call->data, uspace_addr);
+	ipc_set_arg2(&call->data, min(buf_size, data_size));
+	ipc_set_arg3(&call->data, data_size);
+	call->buffer = data;
+
+	ipc_answer(&TASK->kb.box, call);
+}
+
 /** Process an AREAS_READ call.
  *
  * Returns a list of address space areas in the current task, as an array
@@ -429,6 +517,47 @@ static void udebug_receive_mem_read(call_t *call)
 	ipc_answer(&TASK->kb.box, call);
 }
 
+/** Process a MEM_READV call.
+ *
+ * Reads several ranges of the memory of the current task and sends
+ * their contents, one after another, to the debugger.
+ *
+ * @param call	The call structure.
+ */
+static void udebug_receive_mem_readv(call_t *call)
+{
+	udebug_mem_range_t *ranges;
+	sysarg_t uspace_dst;
+	size_t size;
+	void *buffer = NULL;
+	errno_t rc;
+
+	/* The list of ranges was fetched in udebug_mem_readv_preprocess() */
+	ranges = (udebug_mem_range_t *) call->buffer;
+	call->buffer = NULL;
+	assert(ranges != NULL);
+
+	uspace_dst = ipc_get_arg2(&call->data);
+
+	rc = udebug_mem_readv(ranges, ipc_get_arg4(&call->data), &buffer,
+	    &size);
+	free(ranges);
+
+	if (rc != EOK) {
+		ipc_set_retval(&call->data, rc);
+		ipc_answer(&TASK->kb.box, call);
+		return;
+	}
+
+	ipc_set_retval(&call->data, 0);
+	/* Same answer layout as in udebug_receive_mem_read() */
+	ipc_set_arg1(&call->data, uspace_dst);
+	ipc_set_arg2(&call->data, size);
+	call->buffer = buffer;
+
+	ipc_answer(&TASK->kb.box, call);
+}
+
 /** Handle a debug call received on the kernel answerbox.
  *
  * This is called by the kbox servicing thread. Verifies that the sender
@@ -489,6 +618,12 @@ void udebug_call_receive(call_t *call)
 	case UDEBUG_M_MEM_READ:
 		udebug_receive_mem_read(call);
 		break;
+	case UDEBUG_M_STATS_READ:
+		udebug_receive_stats_read(call);
+		break;
+	case UDEBUG_M_MEM_READV:
+		udebug_receive_mem_readv(call);
+		break;
 	}
 }
 
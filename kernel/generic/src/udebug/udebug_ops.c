@@ -166,24 +166,59 @@ static void _thread_op_end(thread_t *thread)
  * be sent as soon as all the threads become stoppable (i.e. they can be
  * considered stopped).
  *
+ * A sampling session (@a flags contain UDEBUG_BF_SAMPLING) becomes active
+ * immediately. Its threads are never stopped, the kernel only collects
+ * statistics of the task.
+ *
  * @param call The BEGIN call we are servicing.
+ * @param flags Flags of the session (udebug_begin_flags_t).
  * @param active Place to store @c true iff we went directly to active state,
  *               @c false if we only went to beginning state
  *
  * @return EOK on success, EBUSY if the task is already has an active
- *         debugging session.
+ *         debugging session, ENOMEM if there is not enough memory.
  */
-errno_t udebug_begin(call_t *call, bool *active)
+errno_t udebug_begin(call_t *call, sysarg_t flags, bool *active)
 {
+	udebug_stats_t *stats = NULL;
+
 	LOG("Debugging task %" PRIu64, TASK->taskid);
 
+	if ((flags & UDEBUG_BF_SAMPLING) && TASK->udebug.stats == NULL) {
+		stats = malloc(sizeof(udebug_stats_t));
+		if (stats == NULL)
+			return ENOMEM;
+	}
+
 	mutex_lock(&TASK->udebug.lock);
 
 	if (TASK->udebug.dt_state != UDEBUG_TS_INACTIVE) {
 		mutex_unlock(&TASK->udebug.lock);
+		free(stats);
 		return EBUSY;
 	}
 
+	if (flags & UDEBUG_BF_SAMPLING) {
+		/* Only the kbox thread sets the pointer, no need to lock */
+		if (TASK->udebug.stats == NULL)
+			TASK->udebug.stats = stats;
+		else
+			free(stats);
+
+		spinlock_lock(&TASK->udebug.stats_lock);
+		memset(TASK->udebug.stats, 0, sizeof(udebug_stats_t));
+		TASK->udebug.stats_enabled = true;
+		spinlock_unlock(&TASK->udebug.stats_lock);
+
+		TASK->udebug.sampling = true;
+		TASK->udebug.dt_state = UDEBUG_TS_ACTIVE;
+		TASK->udebug.debugger = call->sender;
+		*active = true;
+
+		mutex_unlock(&TASK->udebug.lock);
+		return EOK;
+	}
+
 	TASK->udebug.dt_state = UDEBUG_TS_BEGINNING;
 	TASK->udebug.begin_call = call;
 	TASK->udebug.debugger = call->sender;
@@ -443,6 +478,43 @@ errno_t udebug_name_read(char **data, size_t *data_size)
 	return EOK;
 }
 
+/** Read the statistics of a sampling session.
+ *
+ * The statistics are copied to a newly allocated udebug_stats_t
+ * structure and a pointer to it is written to @a data.
+ *
+ * @param data      Place to store pointer to newly allocated block.
+ * @param data_size Place to store size of the data.
+ *
+ * @return EOK on success, EINVAL if the session is not a sampling
+ *         session, ENOMEM if there is not enough memory.
+ *
+ */
+errno_t udebug_stats_read(void **data, size_t *data_size)
+{
+	udebug_stats_t *stats = malloc(sizeof(udebug_stats_t));
+	if (stats == NULL)
+		return ENOMEM;
+
+	mutex_lock(&TASK->udebug.lock);
+
+	if (!TASK->udebug.sampling) {
+		mutex_unlock(&TASK->udebug.lock);
+		free(stats);
+		return EINVAL;
+	}
+
+	spinlock_lock(&TASK->udebug.stats_lock);
+	memcpy(stats, TASK->udebug.stats, sizeof(udebug_stats_t));
+	spinlock_unlock(&TASK->udebug.stats_lock);
+
+	mutex_unlock(&TASK->udebug.lock);
+
+	*data = stats;
+	*data_size = sizeof(udebug_stats_t);
+	return EOK;
+}
+
 /** Read the arguments of a system call.
  *
  * The arguments of the system call being being executed are copied
@@ -578,5 +650,61 @@ errno_t udebug_mem_read(sysarg_t uspace_addr, size_t n, void **buffer)
 	return EOK;
 }
 
+/** Read several ranges of the memory of the current task.
+ *
+ * The contents of the ranges are copied one after another to a newly
+ * allocated buffer and a pointer to it is written to @a buffer.
+ *
+ * @param ranges Ranges to read.
+ * @param n      Number of the ranges.
+ * @param buffer Place to store pointer to the new buffer.
+ * @param size   Place to store the size of the new buffer.
+ *
+ * @return EOK on success, EBUSY if the debugging session is not active
+ *         or an error code of the first read that failed.
+ *
+ */
+errno_t udebug_mem_readv(const udebug_mem_range_t *ranges, size_t n,
+    void **buffer, size_t *size)
+{
+	size_t total = 0;
+	for (size_t i = 0; i < n; i++)
+		total += ranges[i].size;
+
+	/* Verify task state */
+	mutex_lock(&TASK->udebug.lock);
+
+	if (TASK->udebug.dt_state != UDEBUG_TS_ACTIVE) {
+		mutex_unlock(&TASK->udebug.lock);
+		return EBUSY;
+	}
+
+	uint8_t *data_buffer = malloc(total);
+	if (!data_buffer) {
+		mutex_unlock(&TASK->udebug.lock);
+		return ENOMEM;
+	}
+
+	errno_t rc = EOK;
+	size_t offset = 0;
+	for (size_t i = 0; i < n && rc == EOK; i++) {
+		/* Not strictly from a syscall, see udebug_mem_read() */
+		rc = copy_from_uspace(data_buffer + offset,
+		    (void *) ranges[i].addr, ranges[i].size);
+		offset += ranges[i].size;
+	}
+
+	mutex_unlock(&TASK->udebug.lock);
+
+	if (rc != EOK) {
+		free(data_buffer);
+		return rc;
+	}
+
+	*buffer = data_buffer;
+	*size = total;
+	return EOK;
+}
+
 /** @}
  */
@@ -0,0 +1,8 @@
+#ifndef HEAD_ENTRY_H
+#define HEAD_ENTRY_H
+
+/* Entry points for the head command */
+extern int cmd_head(char **);
+extern void help_cmd_head(unsigned int);
+
+#endif /* HEAD_ENTRY_H */
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <macros.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+
+#include "cmds.h"
+#include "config.h"
+#include "entry.h"
+#include "errors.h"
+#include "head.h"
+#include "util.h"
+
+static const char *cmdname = "head";
+#define HEAD_VERSION "0.0.1"
+#define HEAD_BUFLEN 4096
+#define HEAD_DEFAULT_LINES 10
+
+static struct option const long_options[] = {
+	{ "bytes", required_argument, 0, 'c' },
+	{ "lines", required_argument, 0, 'n' },
+	{ "help", no_argument, 0, 'h' },
+	{ "version", no_argument, 0, 'v' },
+	{ 0, 0, 0, 0 }
+};
+
+/* Dispays help for head in various levels */
+void help_cmd_head(unsigned int level)
+{
+	if (level == HELP_SHORT) {
+		printf("`%s' prints the first lines of files\n", cmdname);
+	} else {
+		help_cmd_head(HELP_SHORT);
+		printf(
+		    "Usage:  %s [options] [file ...]\n"
+		    "Options:\n"
+		    "  -n, --lines=N    Print the first N lines (default %d)\n"
+		    "  -c, --bytes=N    Print the first N bytes\n"
+		    "  -h, --help       A short option summary\n"
+		    "  -v, --version    Print version information and exit\n"
+		    "Standard input is read if no file is given.\n",
+		    cmdname, HEAD_DEFAULT_LINES);
+	}
+
+	return;
+}
+
+/** Copy the beginning of a stream to the standard output.
+ *
+ * @param f        Input stream
+ * @param count    Number of lines or bytes to copy
+ * @param in_bytes @a count is in bytes rather than in lines
+ * @return EOK on success or an error code
+ */
+static errno_t head_stream(FILE *f, uint64_t count, bool in_bytes)
+{
+	char buf[HEAD_BUFLEN];
+	size_t nread;
+	size_t n;
+
+	while (count > 0) {
+		nread = fread(buf, 1, HEAD_BUFLEN, f);
+		if (nread == 0)
+			break;
+
+		if (in_bytes) {
+			n = min(nread, count);
+			count -= n;
+		} else {
+			for (n = 0; n < nread && count > 0; n++) {
+				if (buf[n] == '\n')
+					count--;
+			}
+		}
+
+		if (fwrite(buf, 1, n, stdout) != n)
+			return EIO;
+	}
+
+	if (ferror(f))
+		return EIO;
+
+	return EOK;
+}
+
+/* Main entry point for head, accepts an array of arguments */
+int cmd_head(char **argv)
+{
+	unsigned int argc;
+	uint64_t count = HEAD_DEFAULT_LINES;
+	bool in_bytes = false;
+	int c, opt_ind;
+	int ret = CMD_SUCCESS;
+	errno_t rc;
+	FILE *f;
+
+	argc = cli_count_args(argv);
+
+	c = 0;
+	optreset = 1;
+	optind = 0;
+	opt_ind = 0;
+
+	while (c != -1) {
+		c = getopt_long(argc, argv, "c:n:hv", long_options, &opt_ind);
+		switch (c) {
+		case 'c':
+		case 'n':
+			if (!optarg || str_uint64_t(optarg, NULL, 10, true,
+			    &count) != EOK) {
+				printf("%s: Invalid count '%s'\n", cmdname,
+				    optarg != NULL ? optarg : "");
+				return CMD_FAILURE;
+			}
+			in_bytes = (c == 'c');
+			break;
+		case 'h':
+			help_cmd_head(HELP_LONG);
+			return CMD_SUCCESS;
+		case 'v':
+			printf("%s\n", HEAD_VERSION);
+			return CMD_SUCCESS;
+		case '?':
+			return CMD_FAILURE;
+		}
+	}
+
+	if (optind == (int) argc) {
+		rc = head_stream(stdin, count, in_bytes);
+		if (rc != EOK) {
+			printf("%s: Error copying input\n", cmdname);
+			return CMD_FAILURE;
+		}
+
+		return CMD_SUCCESS;
+	}
+
+	for (int i = optind; argv[i] != NULL; i++) {
+		f = fopen(argv[i], "r");
+		if (f == NULL) {
+			printf("%s: Unable to open %s\n", cmdname, argv[i]);
+			ret = CMD_FAILURE;
+			continue;
+		}
+
+		if (argc - optind > 1)
+			printf("%s==> %s <==\n", i > optind ? "\n" : "",
+			    argv[i]);
+
+		rc = head_stream(f, count, in_bytes);
+		fclose(f);
+		if (rc != EOK) {
+			printf("%s: Error reading %s\n", cmdname, argv[i]);
+			ret = CMD_FAILURE;
+		}
+	}
+
+	return ret;
+}
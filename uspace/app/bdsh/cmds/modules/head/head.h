@@ -0,0 +1,6 @@
+#ifndef HEAD_H
+#define HEAD_H
+
+/* Prototypes for the head command, excluding entry points */
+
+#endif /* HEAD_H */
@@ -62,6 +62,8 @@
 #include "printf/entry.h"
 #include "echo/entry.h"
 #include "cmp/entry.h"
+#include "head/entry.h"
+#include "wc/entry.h"
 
 /*
  * Each .def function fills the module_t struct with the individual name, entry
@@ -87,6 +89,8 @@ module_t modules[] = {
 #include "printf/printf_def.inc"
 #include "echo/echo_def.inc"
 #include "cmp/cmp_def.inc"
+#include "head/head_def.inc"
+#include "wc/wc_def.inc"
 
 	{ NULL, NULL, NULL, NULL }
 };
@@ -0,0 +1,8 @@
+#ifndef WC_ENTRY_H
+#define WC_ENTRY_H
+
+/* Entry points for the wc command */
+extern int cmd_wc(char **);
+extern void help_cmd_wc(unsigned int);
+
+#endif /* WC_ENTRY_H */
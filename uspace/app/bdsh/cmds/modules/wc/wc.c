@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cmds.h"
+#include "config.h"
+#include "entry.h"
+#include "errors.h"
+#include "util.h"
+#include "wc.h"
+
+static const char *cmdname = "wc";
+#define WC_VERSION "0.0.1"
+#define WC_BUFLEN 4096
+
+static struct option const long_options[] = {
+	{ "bytes", no_argument, 0, 'c' },
+	{ "lines", no_argument, 0, 'l' },
+	{ "words", no_argument, 0, 'w' },
+	{ "help", no_argument, 0, 'h' },
+	{ "version", no_argument, 0, 'v' },
+	{ 0, 0, 0, 0 }
+};
+
+/** Counts of one input */
+typedef struct {
+	uint64_t lines;
+	uint64_t words;
+	uint64_t bytes;
+} wc_counts_t;
+
+/** Which counts to print */
+static bool show_lines;
+static bool show_words;
+static bool show_bytes;
+
+/* Dispays help for wc in various levels */
+void help_cmd_wc(unsigned int level)
+{
+	if (level == HELP_SHORT) {
+		printf("`%s' counts lines, words and bytes in files\n",
+		    cmdname);
+	} else {
+		help_cmd_wc(HELP_SHORT);
+		printf(
+		    "Usage:  %s [options] [file ...]\n"
+		    "Options:\n"
+		    "  -l, --lines      Print the number of lines\n"
+		    "  -w, --words      Print the number of words\n"
+		    "  -c, --bytes      Print the number of bytes\n"
+		    "  -h, --help       A short option summary\n"
+		    "  -v, --version    Print version information and exit\n"
+		    "All counts are printed if none is selected. Standard\n"
+		    "input is read if no file is given.\n",
+		    cmdname);
+	}
+
+	return;
+}
+
+/** Count lines, words and bytes in a stream.
+ *
+ * @param f      Input stream
+ * @param counts Place to store the counts
+ * @return EOK on success or an error code
+ */
+static errno_t wc_stream(FILE *f, wc_counts_t *counts)
+{
+	char buf[WC_BUFLEN];
+	bool in_word = false;
+	size_t nread;
+	size_t i;
+
+	counts->lines = 0;
+	counts->words = 0;
+	counts->bytes = 0;
+
+	while ((nread = fread(buf, 1, WC_BUFLEN, f)) > 0) {
+		counts->bytes += nread;
+
+		for (i = 0; i < nread; i++) {
+			if (buf[i] == '\n')
+				counts->lines++;
+
+			if (isspace((unsigned char) buf[i])) {
+				in_word = false;
+			} else if (!in_word) {
+				in_word = true;
+				counts->words++;
+			}
+		}
+	}
+
+	if (ferror(f))
+		return EIO;
+
+	return EOK;
+}
+
+static void wc_print(wc_counts_t *counts, const char *name)
+{
+	if (show_lines)
+		printf(" %7" PRIu64, counts->lines);
+	if (show_words)
+		printf(" %7" PRIu64, counts->words);
+	if (show_bytes)
+		printf(" %7" PRIu64, counts->bytes);
+	if (name != NULL)
+		printf(" %s", name);
+	printf("\n");
+}
+
+/* Main entry point for wc, accepts an array of arguments */
+int cmd_wc(char **argv)
+{
+	unsigned int argc;
+	wc_counts_t counts;
+	wc_counts_t total = { 0, 0, 0 };
+	int c, opt_ind;
+	int ret = CMD_SUCCESS;
+	errno_t rc;
+	FILE *f;
+
+	argc = cli_count_args(argv);
+
+	show_lines = false;
+	show_words = false;
+	show_bytes = false;
+
+	c = 0;
+	optreset = 1;
+	optind = 0;
+	opt_ind = 0;
+
+	while (c != -1) {
+		c = getopt_long(argc, argv, "clwhv", long_options, &opt_ind);
+		switch (c) {
+		case 'c':
+			show_bytes = true;
+			break;
+		case 'l':
+			show_lines = true;
+			break;
+		case 'w':
+			show_words = true;
+			break;
+		case 'h':
+			help_cmd_wc(HELP_LONG);
+			return CMD_SUCCESS;
+		case 'v':
+			printf("%s\n", WC_VERSION);
+			return CMD_SUCCESS;
+		case '?':
+			return CMD_FAILURE;
+		}
+	}
+
+	if (!show_lines && !show_words && !show_bytes) {
+		show_lines = true;
+		show_words = true;
+		show_bytes = true;
+	}
+
+	if (optind == (int) argc) {
+		rc = wc_stream(stdin, &counts);
+		if (rc != EOK) {
+			printf("%s: Error reading input\n", cmdname);
+			return CMD_FAILURE;
+		}
+
+		wc_print(&counts, NULL);
+		return CMD_SUCCESS;
+	}
+
+	for (int i = optind; argv[i] != NULL; i++) {
+		f = fopen(argv[i], "r");
+		if (f == NULL) {
+			printf("%s: Unable to open %s\n", cmdname, argv[i]);
+			ret = CMD_FAILURE;
+			continue;
+		}
+
+		rc = wc_stream(f, &counts);
+		fclose(f);
+		if (rc != EOK) {
+			printf("%s: Error reading %s\n", cmdname, argv[i]);
+			ret = CMD_FAILURE;
+			continue;
+		}
+
+		wc_print(&counts, argv[i]);
+		total.lines += counts.lines;
+		total.words += counts.words;
+		total.bytes += counts.bytes;
+	}
+
+	if (argc - optind > 1)
+		wc_print(&total, "total");
+
+	return ret;
+}
@@ -0,0 +1,6 @@
+#ifndef WC_H
+#define WC_H
+
+/* Prototypes for the wc command, excluding entry points */
+
+#endif /* WC_H */
@@ -25,15 +25,15 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-
 /*
  * The VERY basics of execute in place support. These are buggy, leaky
  * and not nearly done. Only here for beta testing!! You were warned!!
  * TODO:
- * Hash command lookups to save time
  * Create a running pointer to **path and advance/rewind it as we go
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -46,14 +46,121 @@
 #include "exec.h"
 #include "errors.h"
 
-/* FIXME: Just have find_command() return an allocated string */
-static char *found;
-
-static char *find_command(char *);
+static char *find_command(const char *);
 static int try_access(const char *);
 
 const char *search_dir[] = { "/app", NULL };
 
+/** Command found in one of the search directories */
+typedef struct {
+	ht_link_t link;
+	/** Command name */
+	char *name;
+	/** Full path of the command */
+	char *path;
+} cmd_cache_t;
+
+static size_t cmd_name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != '\0')
+		hash = hash_combine(hash, (uint8_t) *name++);
+
+	return hash;
+}
+
+static size_t cmd_cache_hash(const ht_link_t *item)
+{
+	cmd_cache_t *entry = hash_table_get_inst(item, cmd_cache_t, link);
+	return cmd_name_hash(entry->name);
+}
+
+static size_t cmd_cache_key_hash(const void *key)
+{
+	return cmd_name_hash(key);
+}
+
+static bool cmd_cache_key_equal(const void *key, const ht_link_t *item)
+{
+	cmd_cache_t *entry = hash_table_get_inst(item, cmd_cache_t, link);
+	return str_cmp(entry->name, key) == 0;
+}
+
+static bool cmd_cache_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	cmd_cache_t *a = hash_table_get_inst(item1, cmd_cache_t, link);
+	cmd_cache_t *b = hash_table_get_inst(item2, cmd_cache_t, link);
+	return str_cmp(a->name, b->name) == 0;
+}
+
+static void cmd_cache_remove(ht_link_t *item)
+{
+	cmd_cache_t *entry = hash_table_get_inst(item, cmd_cache_t, link);
+
+	free(entry->name);
+	free(entry->path);
+	free(entry);
+}
+
+static hash_table_ops_t cmd_cache_ops = {
+	.hash = cmd_cache_hash,
+	.key_hash = cmd_cache_key_hash,
+	.key_equal = cmd_cache_key_equal,
+	.equal = cmd_cache_equal,
+	.remove_callback = cmd_cache_remove
+};
+
+/** Paths of commands found in the search directories */
+static hash_table_t cmd_cache;
+static bool cmd_cache_ready;
+
+/** Remember where a command was found.
+ *
+ * The cache is only an optimization, failures are ignored.
+ */
+static void cmd_cache_add(const char *name, const char *path)
+{
+	cmd_cache_t *entry;
+
+	if (!cmd_cache_ready) {
+		if (!hash_table_create(&cmd_cache, 0, 0, &cmd_cache_ops))
+			return;
+		cmd_cache_ready = true;
+	}
+
+	entry = calloc(1, sizeof(cmd_cache_t));
+	if (entry == NULL)
+		return;
+
+	entry->name = str_dup(name);
+	entry->path = str_dup(path);
+	if (entry->name == NULL || entry->path == NULL) {
+		cmd_cache_remove(&entry->link);
+		return;
+	}
+
+	hash_table_insert(&cmd_cache, &entry->link);
+}
+
+/** Look up a command in the cache.
+ *
+ * @return Cached path or @c NULL
+ */
+static const char *cmd_cache_find(const char *name)
+{
+	ht_link_t *link;
+
+	if (!cmd_cache_ready)
+		return NULL;
+
+	link = hash_table_find(&cmd_cache, name);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, cmd_cache_t, link)->path;
+}
+
 /* work-around for access() */
 static int try_access(const char *f)
 {
@@ -69,46 +176,61 @@ static int try_access(const char *f)
 
 /** Returns the full path of "cmd" if cmd is found
  *
- * else just hand back cmd as it was presented
+ * else just hand back cmd as it was presented. A command name containing
+ * a slash is a path and it is used as is. Other names are looked up in
+ * the search directories, remembering where they were found, and then
+ * in the current directory.
+ *
+ * @return Newly allocated path or @c NULL if out of memory
  */
-static char *find_command(char *cmd)
+static char *find_command(const char *cmd)
 {
+	const char *cached;
+	char *found;
 	size_t i;
 
-	found = (char *)malloc(PATH_MAX);
+	if (str_chr(cmd, '/') != NULL)
+		return str_dup(cmd);
 
-	/* The user has specified a full or relative path, just give it back. */
-	if (-1 != try_access(cmd)) {
-		return (char *) cmd;
-	}
+	cached = cmd_cache_find(cmd);
+	if (cached != NULL)
+		return str_dup(cached);
+
+	found = malloc(PATH_MAX);
+	if (found == NULL)
+		return NULL;
 
 	/* We now have n places to look for the command */
 	for (i = 0; search_dir[i] != NULL; i++) {
-		memset(found, 0, PATH_MAX);
 		snprintf(found, PATH_MAX, "%s/%s", search_dir[i], cmd);
 		if (-1 != try_access(found)) {
-			return (char *) found;
+			cmd_cache_add(cmd, found);
+			return found;
 		}
 	}
 
 	/* We didn't find it, just give it back as-is. */
-	return (char *) cmd;
+	free(found);
+	return str_dup(cmd);
 }
 
-unsigned int try_exec(char *cmd, char **argv, iostate_t *io)
+/** Start an external command.
+ *
+ * @param cmd   Command name
+ * @param argv  Arguments
+ * @param io    Standard streams of the command
+ * @param twait Place to store the wait structure of the new task
+ * @return EOK on success or an error code
+ */
+errno_t exec_spawn(char *cmd, char **argv, iostate_t *io, task_wait_t *twait)
 {
 	task_id_t tid;
-	task_wait_t twait;
-	task_exit_t texit;
 	char *tmp;
 	errno_t rc;
-	int retval, i;
+	int i;
 	int file_handles[3] = { -1, -1, -1 };
 	FILE *files[3];
 
-	tmp = str_dup(find_command(cmd));
-	free(found);
-
 	files[0] = io->stdin;
 	files[1] = io->stdout;
 	files[2] = io->stderr;
@@ -117,17 +239,48 @@ unsigned int try_exec(char *cmd, char **argv, iostate_t *io)
 		vfs_fhandle(files[i], &file_handles[i]);
 	}
 
-	rc = task_spawnvf(&tid, &twait, tmp, (const char **) argv,
+	tmp = find_command(cmd);
+	if (tmp == NULL)
+		return ENOMEM;
+
+	rc = task_spawnvf(&tid, twait, tmp, (const char **) argv,
 	    file_handles[0], file_handles[1], file_handles[2]);
+
+	/* The command might have moved since we found it */
+	if (rc == ENOENT && cmd_cache_find(cmd) != NULL) {
+		hash_table_remove(&cmd_cache, cmd);
+		free(tmp);
+
+		tmp = find_command(cmd);
+		if (tmp == NULL)
+			return ENOMEM;
+
+		rc = task_spawnvf(&tid, twait, tmp, (const char **) argv,
+		    file_handles[0], file_handles[1], file_handles[2]);
+	}
+
 	free(tmp);
 
 	if (rc != EOK) {
 		cli_error(CL_EEXEC, "%s: Cannot spawn `%s' (%s)", progname, cmd,
 		    str_error(rc));
-		return 1;
 	}
 
-	rc = task_wait(&twait, &texit, &retval);
+	return rc;
+}
+
+/** Wait for an external command to finish.
+ *
+ * @param twait Wait structure from exec_spawn()
+ * @return 0 if the command succeeded, 1 otherwise
+ */
+unsigned int exec_wait(task_wait_t *twait)
+{
+	task_exit_t texit;
+	errno_t rc;
+	int retval;
+
+	rc = task_wait(twait, &texit, &retval);
 	if (rc != EOK) {
 		printf("%s: Failed waiting for command (%s)\n", progname,
 		    str_error(rc));
@@ -143,3 +296,13 @@ unsigned int try_exec(char *cmd, char **argv, iostate_t *io)
 
 	return 0;
 }
+
+unsigned int try_exec(char *cmd, char **argv, iostate_t *io)
+{
+	task_wait_t twait;
+
+	if (exec_spawn(cmd, argv, io, &twait) != EOK)
+		return 1;
+
+	return exec_wait(&twait);
+}
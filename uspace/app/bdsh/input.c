@@ -31,6 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
+#include <str_error.h>
 #include <io/console.h>
 #include <io/keycode.h>
 #include <io/style.h>
@@ -40,6 +41,9 @@
 #include <macros.h>
 #include <errno.h>
 #include <assert.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <pipe.h>
 #include <stdbool.h>
 #include <tinput.h>
 
@@ -51,14 +55,40 @@
 #include "errors.h"
 #include "exec.h"
 #include "tok.h"
+#include "cmds/cmds.h"
 
 extern volatile unsigned int cli_quit;
 
 /** Text input field. */
 static tinput_t *tinput;
 
+/** One command of a pipeline */
+typedef struct {
+	/** Command and its arguments */
+	char **argv;
+	/** Standard streams of the command */
+	iostate_t io;
+	/** Read end of the pipe from the previous command or @c NULL */
+	FILE *rpipe;
+	/** Write end of the pipe to the next command or @c NULL */
+	FILE *wpipe;
+	/** The command runs as a separate task */
+	bool spawned;
+	/** The task has finished and its pipe ends are closed */
+	bool done;
+	/** Wait structure of the task */
+	task_wait_t twait;
+	/** Result of the command */
+	int status;
+} stage_t;
+
+/** Synchronizes waiting for the tasks of a pipeline */
+static FIBRIL_MUTEX_INITIALIZE(stage_lock);
+static FIBRIL_CONDVAR_INITIALIZE(stage_cv);
+
 /* Private helpers */
 static int run_command(char **, cliuser_t *, iostate_t *);
+static int run_pipeline(stage_t *, unsigned int, cliuser_t *);
 static void print_pipe_usage(void);
 
 /*
@@ -73,11 +103,12 @@ errno_t process_input(cliuser_t *usr)
 		return ENOMEM;
 	token_t *tokens = tokens_buf;
 
-	char *cmd[WORD_MAX];
+	char *cmd[WORD_MAX + 1];
+	stage_t *stages_buf = NULL;
+	stage_t *stages;
 	errno_t rc = EOK;
 	tokenizer_t tok;
-	unsigned int i, pipe_count, processed_pipes;
-	unsigned int pipe_pos[2];
+	unsigned int i, pipe_count, nstages;
 	char *redir_from = NULL;
 	char *redir_to = NULL;
 
@@ -107,67 +138,62 @@ errno_t process_input(cliuser_t *usr)
 	}
 
 	/*
-	 * Until full support for pipes is implemented, allow for a simple case:
-	 * [from <file> |] command [| to <file>]
+	 * Split the command line at the pipes into commands:
+	 * [from <file> |] command [| command ...] [| to <file>]
 	 *
-	 * First find the pipes and check that there are no more
+	 * Each command is converted to a NULL-terminated string array,
+	 * the arrays follow each other in cmd[].
 	 */
 	for (i = 0, pipe_count = 0; i < tokens_length; i++) {
-		if (tokens[i].type == TOKTYPE_PIPE) {
-			if (pipe_count >= 2) {
-				print_pipe_usage();
-				rc = ENOTSUP;
-				goto finit;
-			}
-			pipe_pos[pipe_count] = i;
+		if (tokens[i].type == TOKTYPE_PIPE)
 			pipe_count++;
-		}
 	}
 
-	unsigned int cmd_token_start = 0;
-	unsigned int cmd_token_end = tokens_length;
-
-	processed_pipes = 0;
-
-	/* Check if the first part (from <file> |) is present */
-	if (pipe_count > 0 && (pipe_pos[0] == 3 || pipe_pos[0] == 4) && str_cmp(tokens[0].text, "from") == 0) {
-		/* Ignore the first three tokens (from, file, pipe) and set from */
-		redir_from = tokens[2].text;
-		cmd_token_start = pipe_pos[0] + 1;
-		processed_pipes++;
-	}
-
-	/* Check if the second part (| to <file>) is present */
-	if ((pipe_count - processed_pipes) > 0 &&
-	    (pipe_pos[processed_pipes] == tokens_length - 4 ||
-	    (pipe_pos[processed_pipes] == tokens_length - 5 &&
-	    tokens[tokens_length - 4].type == TOKTYPE_SPACE)) &&
-	    str_cmp(tokens[tokens_length - 3].text, "to") == 0) {
-		/* Ignore the last three tokens (pipe, to, file) and set to */
-		redir_to = tokens[tokens_length - 1].text;
-		cmd_token_end = pipe_pos[processed_pipes];
-		processed_pipes++;
-	}
-
-	if (processed_pipes != pipe_count) {
-		print_pipe_usage();
-		rc = ENOTSUP;
+	stages_buf = calloc(pipe_count + 1, sizeof(stage_t));
+	if (stages_buf == NULL) {
+		rc = ENOMEM;
 		goto finit;
 	}
 
-	/* Convert tokens of the command to string array */
+	stages = stages_buf;
+
 	unsigned int cmd_pos = 0;
-	for (i = cmd_token_start; i < cmd_token_end; i++) {
-		if (tokens[i].type != TOKTYPE_SPACE) {
+	nstages = 0;
+	stages[0].argv = &cmd[0];
+	for (i = 0; i <= tokens_length; i++) {
+		if (i == tokens_length || tokens[i].type == TOKTYPE_PIPE) {
+			cmd[cmd_pos++] = NULL;
+			nstages++;
+			if (i < tokens_length)
+				stages[nstages].argv = &cmd[cmd_pos];
+		} else if (tokens[i].type != TOKTYPE_SPACE) {
 			cmd[cmd_pos++] = tokens[i].text;
 		}
 	}
-	cmd[cmd_pos++] = NULL;
 
-	if (cmd[0] == NULL) {
-		print_pipe_usage();
-		rc = ENOTSUP;
-		goto finit;
+	/* Check if the first part (from <file> |) is present */
+	char **first = stages[0].argv;
+	if (nstages > 1 && first[0] != NULL && first[1] != NULL &&
+	    first[2] == NULL && str_cmp(first[0], "from") == 0) {
+		redir_from = first[1];
+		stages++;
+		nstages--;
+	}
+
+	/* Check if the last part (| to <file>) is present */
+	char **last = stages[nstages - 1].argv;
+	if (nstages > 1 && last[0] != NULL && last[1] != NULL &&
+	    last[2] == NULL && str_cmp(last[0], "to") == 0) {
+		redir_to = last[1];
+		nstages--;
+	}
+
+	for (i = 0; i < nstages; i++) {
+		if (stages[i].argv[0] == NULL) {
+			print_pipe_usage();
+			rc = ENOTSUP;
+			goto finit;
+		}
 	}
 
 	iostate_t new_iostate = {
@@ -199,7 +225,17 @@ errno_t process_input(cliuser_t *usr)
 		new_iostate.stdout = to;
 	}
 
-	if (run_command(cmd, usr, &new_iostate) == 0) {
+	int status;
+
+	if (nstages == 1) {
+		status = run_command(stages[0].argv, usr, &new_iostate);
+	} else {
+		stages[0].io.stdin = new_iostate.stdin;
+		stages[nstages - 1].io.stdout = new_iostate.stdout;
+		status = run_pipeline(stages, nstages, usr);
+	}
+
+	if (status == 0) {
 		rc = EOK;
 	} else {
 		rc = EINVAL;
@@ -220,6 +256,7 @@ finit:
 	}
 	tok_fini(&tok);
 	free(tokens_buf);
+	free(stages_buf);
 
 	return rc;
 }
@@ -227,11 +264,158 @@ finit:
 void print_pipe_usage(void)
 {
 	printf("Invalid syntax!\n");
-	printf("Usage of redirection (pipes in the future):\n");
-	printf("from filename | command ...\n");
-	printf("from filename | command ... | to filename\n");
-	printf("command ... | to filename\n");
+	printf("Usage of pipes and redirection:\n");
+	printf("command ... | command ... [| command ...]\n");
+	printf("from filename | command ... [| command ...]\n");
+	printf("command ... [| command ...] | to filename\n");
+}
+
+/** Wait for the task of a pipeline command and close its pipe ends.
+ *
+ * The pipe ends are kept open by the shell until the task finishes so
+ * that the neighbouring commands see the end of the stream only after
+ * the task is gone.
+ */
+static errno_t stage_wait_fibril(void *arg)
+{
+	stage_t *stage = (stage_t *) arg;
+
+	stage->status = exec_wait(&stage->twait);
+
+	if (stage->rpipe != NULL)
+		fclose(stage->rpipe);
+	if (stage->wpipe != NULL)
+		fclose(stage->wpipe);
+
+	fibril_mutex_lock(&stage_lock);
+	stage->done = true;
+	fibril_condvar_broadcast(&stage_cv);
+	fibril_mutex_unlock(&stage_lock);
+
+	return EOK;
+}
+
+/** Run commands connected with pipes.
+ *
+ * External commands run concurrently as separate tasks. At most one
+ * builtin command or module can be part of the pipeline, it runs in the
+ * shell while the other commands are running.
+ *
+ * @param stages  Commands, standard input of the first one and standard
+ *                output of the last one are set up
+ * @param nstages Number of commands
+ * @param usr     User
+ * @return Result of the last command
+ */
+static int run_pipeline(stage_t *stages, unsigned int nstages,
+    cliuser_t *usr)
+{
+	stage_t *local = NULL;
+	unsigned int i;
+	int rfd, wfd;
+	errno_t rc;
+
+	for (i = 0; i < nstages; i++) {
+		if (is_builtin(stages[i].argv[0]) > -1 ||
+		    is_module(stages[i].argv[0]) > -1) {
+			if (local != NULL) {
+				cli_error(CL_EFAIL, "%s: Only one builtin "
+				    "command can be used in a pipeline",
+				    progname);
+				return 1;
+			}
+			local = &stages[i];
+		}
+	}
+
+	for (i = 0; i + 1 < nstages; i++) {
+		rc = pipe_create(&rfd, &wfd);
+		if (rc != EOK) {
+			cli_error(CL_EFAIL, "%s: Cannot create pipe (%s)",
+			    progname, str_error(rc));
+			goto error;
+		}
+
+		stages[i].wpipe = fdopen(wfd, "w");
+		if (stages[i].wpipe == NULL)
+			vfs_put(wfd);
+		stages[i + 1].rpipe = fdopen(rfd, "r");
+		if (stages[i + 1].rpipe == NULL)
+			vfs_put(rfd);
+		if (stages[i].wpipe == NULL || stages[i + 1].rpipe == NULL) {
+			cli_error(CL_ENOMEM, "%s: Cannot create pipe",
+			    progname);
+			goto error;
+		}
+	}
+
+	for (i = 0; i < nstages; i++) {
+		if (i > 0)
+			stages[i].io.stdin = stages[i].rpipe;
+		if (i + 1 < nstages)
+			stages[i].io.stdout = stages[i].wpipe;
+		stages[i].io.stderr = stderr;
+	}
+
+	for (i = 0; i < nstages; i++) {
+		if (&stages[i] == local)
+			continue;
+
+		rc = exec_spawn(stages[i].argv[0], stages[i].argv,
+		    &stages[i].io, &stages[i].twait);
+		if (rc != EOK) {
+			stages[i].status = 1;
+			continue;
+		}
+
+		fid_t fid = fibril_create(stage_wait_fibril, &stages[i]);
+		if (fid == 0) {
+			/* Out of memory, wait for the task right away */
+			(void) stage_wait_fibril(&stages[i]);
+			stages[i].rpipe = stages[i].wpipe = NULL;
+			continue;
+		}
+
+		stages[i].spawned = true;
+		fibril_add_ready(fid);
+	}
+
+	/* Let the commands that did not start see the end of the stream */
+	for (i = 0; i < nstages; i++) {
+		if (&stages[i] == local || stages[i].spawned)
+			continue;
+		if (stages[i].rpipe != NULL)
+			fclose(stages[i].rpipe);
+		if (stages[i].wpipe != NULL)
+			fclose(stages[i].wpipe);
+		stages[i].rpipe = stages[i].wpipe = NULL;
+	}
+
+	if (local != NULL) {
+		local->status = run_command(local->argv, usr, &local->io);
+		if (local->rpipe != NULL)
+			fclose(local->rpipe);
+		if (local->wpipe != NULL)
+			fclose(local->wpipe);
+	}
+
+	fibril_mutex_lock(&stage_lock);
+	for (i = 0; i < nstages; i++) {
+		while (stages[i].spawned && !stages[i].done)
+			fibril_condvar_wait(&stage_cv, &stage_lock);
+	}
+	fibril_mutex_unlock(&stage_lock);
+
+	return stages[nstages - 1].status;
+error:
+	for (i = 0; i < nstages; i++) {
+		if (stages[i].rpipe != NULL)
+			fclose(stages[i].rpipe);
+		if (stages[i].wpipe != NULL)
+			fclose(stages[i].wpipe);
+	}
 
+	return 1;
 }
 
 int run_command(char **cmd, cliuser_t *usr, iostate_t *new_iostate)
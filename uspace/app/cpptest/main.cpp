@@ -47,6 +47,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <deque>
@@ -105,6 +106,9 @@ int main()
     std::test::test_set ts{};
     ts.add<std::test::vector_test>();
     ts.add<std::test::string_test>();
+    ts.add<std::test::string_bench>();
+    ts.add<std::test::regex_test>();
+    ts.add<std::test::regex_bench>();
     ts.add<std::test::array_test>();
     ts.add<std::test::bitset_test>();
     ts.add<std::test::deque_test>();
@@ -113,13 +117,18 @@ int main()
     ts.add<std::test::set_test>();
     ts.add<std::test::unordered_map_test>();
     ts.add<std::test::unordered_set_test>();
+    ts.add<std::test::flat_hash_map_test>();
     ts.add<std::test::numeric_test>();
     ts.add<std::test::adaptors_test>();
     ts.add<std::test::memory_test>();
+    ts.add<std::test::memory_resource_test>();
     ts.add<std::test::list_test>();
     ts.add<std::test::ratio_test>();
     ts.add<std::test::functional_test>();
+    ts.add<std::test::function_bench>();
     ts.add<std::test::algorithm_test>();
+    ts.add<std::test::execution_test>();
+    ts.add<std::test::atomic_test>();
 
     return ts.run(true) ? 0 : 1;
 }
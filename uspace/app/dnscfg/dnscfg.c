@@ -42,6 +42,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <str.h>
 #include <str_error.h>
 
@@ -51,8 +52,10 @@ static void print_syntax(void)
 {
 	printf("Syntax:\n");
 	printf("\t%s get-ns\n", NAME);
-	printf("\t%s set-ns <server-addr>\n", NAME);
+	printf("\t%s set-ns <server-addr> [<server-addr>...]\n", NAME);
 	printf("\t%s unset-ns\n", NAME);
+	printf("\t%s show-cache\n", NAME);
+	printf("\t%s flush-cache\n", NAME);
 }
 
 static errno_t dnscfg_set_ns(int argc, char *argv[])
@@ -63,27 +66,38 @@ static errno_t dnscfg_set_ns(int argc, char *argv[])
 		return EINVAL;
 	}
 
-	if (argc > 1) {
+	if (argc > DNSR_SERVERS_MAX) {
 		printf("%s: Too many arguments.\n", NAME);
 		print_syntax();
 		return EINVAL;
 	}
 
-	char *srv_addr  = argv[0];
-
-	inet_addr_t addr;
-	errno_t rc = inet_addr_parse(srv_addr, &addr, NULL);
-
-	if (rc != EOK) {
-		printf("%s: Invalid address format '%s'.\n", NAME, srv_addr);
-		return rc;
+	inet_addr_t addr[DNSR_SERVERS_MAX];
+	errno_t rc;
+	int i;
+
+	for (i = 0; i < DNSR_SERVERS_MAX; i++) {
+		if (i >= argc) {
+			inet_addr_any(&addr[i]);
+			continue;
+		}
+
+		rc = inet_addr_parse(argv[i], &addr[i], NULL);
+		if (rc != EOK) {
+			printf("%s: Invalid address format '%s'.\n", NAME,
+			    argv[i]);
+			return rc;
+		}
 	}
 
-	rc = dnsr_set_srvaddr(&addr);
-	if (rc != EOK) {
-		printf("%s: Failed setting nameserver address '%s' (%s)\n",
-		    NAME, srv_addr, str_error(rc));
-		return rc;
+	for (i = 0; i < DNSR_SERVERS_MAX; i++) {
+		rc = dnsr_set_srvaddr_idx(i, &addr[i]);
+		if (rc != EOK) {
+			printf("%s: Failed setting nameserver address "
+			    "'%s' (%s)\n", NAME, i < argc ? argv[i] : "",
+			    str_error(rc));
+			return rc;
+		}
 	}
 
 	return EOK;
@@ -94,11 +108,13 @@ static errno_t dnscfg_unset_ns(void)
 	inet_addr_t addr;
 	inet_addr_any(&addr);
 
-	errno_t rc = dnsr_set_srvaddr(&addr);
-	if (rc != EOK) {
-		printf("%s: Failed unsetting server address (%s)\n",
-		    NAME, str_error(rc));
-		return rc;
+	for (size_t i = 0; i < DNSR_SERVERS_MAX; i++) {
+		errno_t rc = dnsr_set_srvaddr_idx(i, &addr);
+		if (rc != EOK) {
+			printf("%s: Failed unsetting server address (%s)\n",
+			    NAME, str_error(rc));
+			return rc;
+		}
 	}
 
 	return EOK;
@@ -106,22 +122,85 @@ static errno_t dnscfg_unset_ns(void)
 
 static errno_t dnscfg_print(void)
 {
-	inet_addr_t addr;
-	errno_t rc = dnsr_get_srvaddr(&addr);
+	for (size_t i = 0; i < DNSR_SERVERS_MAX; i++) {
+		inet_addr_t addr;
+		errno_t rc = dnsr_get_srvaddr_idx(i, &addr);
+		if (rc != EOK) {
+			printf("%s: Failed getting DNS server address.\n",
+			    NAME);
+			return rc;
+		}
+
+		/* Always show the primary server, even if unset */
+		if (i > 0 && inet_addr_is_any(&addr))
+			continue;
+
+		char *addr_str;
+		rc = inet_addr_format(&addr, &addr_str);
+		if (rc != EOK) {
+			printf("%s: Out of memory.\n", NAME);
+			return rc;
+		}
+
+		printf("Nameserver: %s\n", addr_str);
+		free(addr_str);
+	}
+
+	return EOK;
+}
+
+static errno_t dnscfg_show_cache(void)
+{
+	dnsr_cache_entry_t *entries;
+	size_t count;
+	errno_t rc = dnsr_get_cache(&entries, &count);
 	if (rc != EOK) {
-		printf("%s: Failed getting DNS server address.\n", NAME);
+		printf("%s: Failed getting resolver cache (%s).\n", NAME,
+		    str_error(rc));
 		return rc;
 	}
 
-	char *addr_str;
-	rc = inet_addr_format(&addr, &addr_str);
+	if (count == 0)
+		printf("Resolver cache is empty.\n");
+
+	for (size_t i = 0; i < count; i++) {
+		dnsr_cache_entry_t *ent = &entries[i];
+		const char *type = ent->ver == ip_v4 ? "A" : "AAAA";
+
+		if (ent->negative) {
+			printf("%s %s (does not exist) ttl %" PRIu32 "\n",
+			    ent->name, type, ent->ttl);
+			continue;
+		}
+
+		char *addr_str;
+		rc = inet_addr_format(&ent->addr, &addr_str);
+		if (rc != EOK) {
+			printf("%s: Out of memory.\n", NAME);
+			free(entries);
+			return rc;
+		}
+
+		printf("%s %s %s", ent->name, type, addr_str);
+		if (str_casecmp(ent->name, ent->cname) != 0)
+			printf(" (%s)", ent->cname);
+		printf(" ttl %" PRIu32 "\n", ent->ttl);
+		free(addr_str);
+	}
+
+	free(entries);
+	return EOK;
+}
+
+static errno_t dnscfg_flush_cache(void)
+{
+	errno_t rc = dnsr_flush_cache();
 	if (rc != EOK) {
-		printf("%s: Out of memory.\n", NAME);
+		printf("%s: Failed flushing resolver cache (%s).\n", NAME,
+		    str_error(rc));
 		return rc;
 	}
 
-	printf("Nameserver: %s\n", addr_str);
-	free(addr_str);
 	return EOK;
 }
 
@@ -133,6 +212,10 @@ int main(int argc, char *argv[])
 		return dnscfg_set_ns(argc - 2, argv + 2);
 	else if (str_cmp(argv[1], "unset-ns") == 0)
 		return dnscfg_unset_ns();
+	else if (str_cmp(argv[1], "show-cache") == 0)
+		return dnscfg_show_cache();
+	else if (str_cmp(argv[1], "flush-cache") == 0)
+		return dnscfg_flush_cache();
 	else {
 		printf("%s: Unknown command '%s'.\n", NAME, argv[1]);
 		print_syntax();
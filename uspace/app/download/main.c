@@ -36,12 +36,17 @@
  */
 
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <inttypes.h>
+#include <perf.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
 #include <str_error.h>
 #include <task.h>
 #include <macros.h>
+#include <vfs/vfs.h>
 
 #include <http/http.h>
 #include <uri.h>
@@ -54,13 +59,376 @@
 #endif
 #define USER_AGENT "HelenOS-" NAME "/" VERSION
 
+/** Size of the ranges a file is split into with -n */
+#define RANGE_SIZE (1024 * 1024)
+/** Maximum number of connections with -n */
+#define MAX_CONNS 16
+/** Number of times a range is retried without any progress */
+#define RANGE_RETRIES 3
+
+/** Download of a file split into ranges */
+typedef struct {
+	const char *host;
+	const char *path;
+	/** Output file */
+	int fd;
+	/** Size of the file */
+	uint64_t size;
+
+	/** Synchronizes access to the fields below */
+	fibril_mutex_t lock;
+	/** Signalled when a connection is done */
+	fibril_condvar_t done_cv;
+	/** Start of the next range that was not handed out yet */
+	uint64_t next;
+	/** Total number of bytes received */
+	uint64_t received;
+	/** Number of connections still working */
+	unsigned active;
+	/** First error of a range that could not be downloaded */
+	errno_t rc;
+} ranges_t;
+
+/** One connection of a download split into ranges */
+typedef struct {
+	ranges_t *ranges;
+	http_t *http;
+} ranges_conn_t;
+
 static void syntax_print(void)
 {
-	fprintf(stderr, "Usage: download [-o <outfile>] <url>\n");
+	fprintf(stderr, "Usage: download [-o <outfile>] [-n <conns>] <url>\n");
 	fprintf(stderr, "  Without -o, data will be written to stdout, so you may want\n");
 	fprintf(stderr, "  to redirect the output, e.g.\n");
 	fprintf(stderr, "\n");
 	fprintf(stderr, "    download http://helenos.org/ | to helenos.html\n\n");
+	fprintf(stderr, "  With -n, a large file is split into ranges which\n");
+	fprintf(stderr, "  are downloaded over <conns> connections at once.\n");
+	fprintf(stderr, "  This needs -o.\n");
+}
+
+static http_request_t *request_create(const char *method, const char *path,
+    const char *host)
+{
+	http_request_t *req = http_request_create(method, path);
+	if (req == NULL)
+		return NULL;
+
+	errno_t rc = http_headers_append(&req->headers, "Host", host);
+	if (rc != EOK) {
+		http_request_destroy(req);
+		return NULL;
+	}
+
+	rc = http_headers_append(&req->headers, "User-Agent", USER_AGENT);
+	if (rc != EOK) {
+		http_request_destroy(req);
+		return NULL;
+	}
+
+	return req;
+}
+
+/** Find out whether the file can be downloaded in ranges
+ *
+ * @param http   Connected HTTP client
+ * @param host   Host name
+ * @param path   Path of the file on the server
+ * @param rsize  Place to store size of the file, zero if the server does
+ *               not support ranges for it
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t ranges_probe(http_t *http, const char *host, const char *path,
+    uint64_t *rsize)
+{
+	http_response_t *response = NULL;
+	http_slice_t value;
+	char *str;
+	errno_t rc;
+
+	*rsize = 0;
+
+	http_request_t *req = request_create("HEAD", path, host);
+	if (req == NULL)
+		return ENOMEM;
+
+	rc = http_send_request(http, req);
+	http_request_destroy(req);
+	if (rc != EOK)
+		return rc;
+
+	/* A response to HEAD never has a body */
+	rc = http_receive_response(&http->recv_buffer, &response, 16 * 1024,
+	    100);
+	if (rc != EOK)
+		return rc;
+
+	if (!http_response_persistent(response))
+		(void) http_close(http);
+
+	if (response->status != 200)
+		goto out;
+
+	if (http_headers_get(&response->headers, "Accept-Ranges", &str) != EOK)
+		goto out;
+	value.data = str;
+	value.size = str_size(str);
+	if (!http_slice_has_token(&value, "bytes"))
+		goto out;
+
+	if (http_headers_get(&response->headers, "Content-Length", &str) != EOK)
+		goto out;
+	value.data = str;
+	value.size = str_size(str);
+	if (http_slice_uint64(&value, 10, rsize) != EOK)
+		*rsize = 0;
+out:
+	http_response_destroy(response);
+	return EOK;
+}
+
+/** Take the next range that needs to be downloaded
+ *
+ * @return @c false if there are no more ranges
+ */
+static bool ranges_next(ranges_t *ranges, uint64_t *first, uint64_t *last)
+{
+	bool found = false;
+
+	fibril_mutex_lock(&ranges->lock);
+	if (ranges->rc == EOK && ranges->next < ranges->size) {
+		*first = ranges->next;
+		*last = min(ranges->size, ranges->next + RANGE_SIZE) - 1;
+		ranges->next = *last + 1;
+		found = true;
+	}
+	fibril_mutex_unlock(&ranges->lock);
+
+	return found;
+}
+
+/** Download a range and write it at its offset in the output file
+ *
+ * @param conn       Connection
+ * @param buf        Buffer for the received data
+ * @param buf_size   Size of @a buf
+ * @param first      Offset of the first byte, advanced by the number of
+ *                   bytes written even if the range fails
+ * @param last       Offset of the last byte
+ * @param persistent Place to store whether the connection can be reused
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t ranges_fetch(ranges_conn_t *conn, void *buf, size_t buf_size,
+    uint64_t *first, uint64_t last, bool *persistent)
+{
+	ranges_t *ranges = conn->ranges;
+	http_response_t *response = NULL;
+	uint64_t rfirst, rlast, rlength;
+	http_body_t body;
+	size_t nread, nwritten;
+	aoff64_t pos;
+	errno_t rc;
+
+	*persistent = false;
+
+	http_request_t *req = request_create("GET", ranges->path,
+	    ranges->host);
+	if (req == NULL)
+		return ENOMEM;
+
+	rc = http_request_set_range(req, *first, last);
+	if (rc == EOK)
+		rc = http_send_request(conn->http, req);
+	http_request_destroy(req);
+	if (rc != EOK)
+		return rc;
+
+	rc = http_receive_response(&conn->http->recv_buffer, &response,
+	    16 * 1024, 100);
+	if (rc != EOK)
+		return rc;
+
+	if (response->status != 206 ||
+	    http_response_content_range(response, &rfirst, &rlast,
+	    &rlength) != EOK || rfirst != *first || rlast != last) {
+		rc = EIO;
+		goto out;
+	}
+
+	rc = http_body_init_headers(&body, &conn->http->recv_buffer,
+	    &response->headers);
+	if (rc != EOK)
+		goto out;
+
+	while ((rc = http_body_read(&body, buf, buf_size, &nread)) == EOK &&
+	    nread > 0) {
+		if (nread > last - *first + 1) {
+			rc = EIO;
+			break;
+		}
+
+		pos = *first;
+		rc = vfs_write(ranges->fd, &pos, buf, nread, &nwritten);
+		if (rc != EOK)
+			break;
+
+		*first += nread;
+		fibril_mutex_lock(&ranges->lock);
+		ranges->received += nread;
+		fibril_mutex_unlock(&ranges->lock);
+	}
+
+	if (rc == EOK && *first != last + 1)
+		rc = EIO;
+	if (rc == EOK)
+		*persistent = http_response_persistent(response);
+out:
+	http_response_destroy(response);
+	return rc;
+}
+
+/** Download ranges over one connection until there are none left */
+static errno_t ranges_conn_fibril(void *arg)
+{
+	ranges_conn_t *conn = arg;
+	ranges_t *ranges = conn->ranges;
+	size_t buf_size = 16384;
+	uint64_t first, last, start;
+	bool persistent;
+	errno_t rc = EOK;
+
+	void *buf = malloc(buf_size);
+	if (buf == NULL)
+		rc = ENOMEM;
+
+	while (rc == EOK && ranges_next(ranges, &first, &last)) {
+		unsigned retries = 0;
+
+		while (first <= last) {
+			start = first;
+			rc = EOK;
+			if (conn->http->conn == NULL)
+				rc = http_connect(conn->http);
+			if (rc == EOK) {
+				rc = ranges_fetch(conn, buf, buf_size, &first,
+				    last, &persistent);
+			}
+
+			if (rc == EOK) {
+				/* Keep the connection for the next range */
+				if (!persistent)
+					(void) http_close(conn->http);
+				break;
+			}
+
+			/* Resume the rest of the range over a new connection */
+			(void) http_close(conn->http);
+			if (first != start)
+				retries = 0;
+			if (++retries > RANGE_RETRIES)
+				break;
+		}
+
+		if (rc != EOK) {
+			fprintf(stderr, "Failed downloading bytes %" PRIu64
+			    "-%" PRIu64 ": %s\n", first, last, str_error(rc));
+		}
+	}
+
+	free(buf);
+
+	fibril_mutex_lock(&ranges->lock);
+	if (rc != EOK && ranges->rc == EOK)
+		ranges->rc = rc;
+	ranges->active--;
+	fibril_condvar_broadcast(&ranges->done_cv);
+	fibril_mutex_unlock(&ranges->lock);
+
+	return rc;
+}
+
+/** Download a file over several connections at once
+ *
+ * @param http  Client to use for the first connection, possibly connected
+ * @param host  Host name
+ * @param path  Path of the file on the server
+ * @param fd    Output file
+ * @param size  Size of the file
+ * @param nconn Number of connections to use
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t ranges_download(http_t *http, const char *host,
+    const char *path, int fd, uint64_t size, unsigned nconn)
+{
+	ranges_conn_t conns[MAX_CONNS];
+	stopwatch_t sw;
+	ranges_t ranges;
+	unsigned i;
+	errno_t rc;
+
+	/* Allocate the whole file up front, the ranges arrive out of order */
+	rc = vfs_resize(fd, size);
+	if (rc != EOK)
+		return rc;
+
+	ranges.host = host;
+	ranges.path = path;
+	ranges.fd = fd;
+	ranges.size = size;
+	fibril_mutex_initialize(&ranges.lock);
+	fibril_condvar_initialize(&ranges.done_cv);
+	ranges.next = 0;
+	ranges.received = 0;
+	ranges.active = 0;
+	ranges.rc = EOK;
+
+	nconn = min(nconn, (size + RANGE_SIZE - 1) / RANGE_SIZE);
+
+	conns[0].ranges = &ranges;
+	conns[0].http = http;
+	for (i = 1; i < nconn; i++) {
+		conns[i].ranges = &ranges;
+		conns[i].http = http_create(http->host, http->port);
+		if (conns[i].http == NULL)
+			break;
+		/* Do not look up the host once for each connection */
+		conns[i].http->addr = http->addr;
+		conns[i].http->addr_valid = http->addr_valid;
+	}
+	nconn = i;
+
+	stopwatch_init(&sw);
+	stopwatch_start(&sw);
+
+	fibril_mutex_lock(&ranges.lock);
+	for (i = 0; i < nconn; i++) {
+		fid_t fid = fibril_create(ranges_conn_fibril, &conns[i]);
+		if (fid == 0)
+			break;
+		ranges.active++;
+		fibril_add_ready(fid);
+	}
+
+	while (ranges.active > 0)
+		fibril_condvar_wait(&ranges.done_cv, &ranges.lock);
+	fibril_mutex_unlock(&ranges.lock);
+
+	stopwatch_stop(&sw);
+
+	for (i = 1; i < nconn; i++)
+		http_destroy(conns[i].http);
+
+	if (ranges.rc != EOK)
+		return ranges.rc;
+
+	nsec_t msec = max(NSEC2MSEC(stopwatch_get_nanos(&sw)), 1);
+	fprintf(stderr, "Received %" PRIu64 " bytes in %lld ms over %u "
+	    "connections (%" PRIu64 " KiB/s)\n", ranges.received, msec, nconn,
+	    ranges.received * 1000 / 1024 / (uint64_t) msec);
+	return EOK;
 }
 
 int main(int argc, char *argv[])
@@ -72,32 +440,46 @@ int main(int argc, char *argv[])
 	void *buf = NULL;
 	uri_t *uri = NULL;
 	http_t *http = NULL;
+	http_request_t *req = NULL;
+	http_response_t *response = NULL;
+	char *server_path = NULL;
+	unsigned nconn = 1;
 	errno_t rc;
 	int ret;
 
-	if (argc < 2) {
-		syntax_print();
-		rc = EINVAL;
-		goto error;
-	}
-
 	i = 1;
 
-	if (str_cmp(argv[i], "-o") == 0) {
-		++i;
-		if (argc < i + 1) {
+	while (i < argc && argv[i][0] == '-') {
+		if (str_cmp(argv[i], "-o") == 0 && ofname == NULL) {
+			++i;
+			if (argc < i + 1) {
+				syntax_print();
+				rc = EINVAL;
+				goto error;
+			}
+
+			ofname = argv[i++];
+			ofile = fopen(ofname, "wb");
+			if (ofile == NULL) {
+				fprintf(stderr, "Error creating '%s'.\n",
+				    ofname);
+				rc = EINVAL;
+				goto error;
+			}
+		} else if (str_cmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			rc = str_uint32_t(argv[i + 1], NULL, 10, true, &nconn);
+			if (rc != EOK || nconn < 1 || nconn > MAX_CONNS) {
+				fprintf(stderr, "Number of connections must "
+				    "be 1 to %d.\n", MAX_CONNS);
+				rc = EINVAL;
+				goto error;
+			}
+			i += 2;
+		} else {
 			syntax_print();
 			rc = EINVAL;
 			goto error;
 		}
-
-		ofname = argv[i++];
-		ofile = fopen(ofname, "wb");
-		if (ofile == NULL) {
-			fprintf(stderr, "Error creating '%s'.\n", ofname);
-			rc = EINVAL;
-			goto error;
-		}
 	}
 
 	if (argc != i + 1) {
@@ -106,6 +488,12 @@ int main(int argc, char *argv[])
 		goto error;
 	}
 
+	if (nconn > 1 && ofile == NULL) {
+		fprintf(stderr, "Option -n needs an output file.\n");
+		rc = EINVAL;
+		goto error;
+	}
+
 	uri = uri_parse(argv[i]);
 	if (uri == NULL) {
 		fprintf(stderr, "Failed parsing URI\n");
@@ -146,7 +534,6 @@ int main(int argc, char *argv[])
 	const char *path = uri->path;
 	if (path == NULL || *path == 0)
 		path = "/";
-	char *server_path = NULL;
 	if (uri->query == NULL) {
 		server_path = str_dup(path);
 		if (server_path == NULL) {
@@ -163,26 +550,6 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	http_request_t *req = http_request_create("GET", server_path);
-	free(server_path);
-	if (req == NULL) {
-		fprintf(stderr, "Failed creating request\n");
-		rc = ENOMEM;
-		goto error;
-	}
-
-	rc = http_headers_append(&req->headers, "Host", uri->host);
-	if (rc != EOK) {
-		fprintf(stderr, "Failed setting Host header: %s\n", str_error(rc));
-		goto error;
-	}
-
-	rc = http_headers_append(&req->headers, "User-Agent", USER_AGENT);
-	if (rc != EOK) {
-		fprintf(stderr, "Failed creating User-Agent header: %s\n", str_error(rc));
-		goto error;
-	}
-
 	http = http_create(uri->host, port);
 	if (http == NULL) {
 		fprintf(stderr, "Failed creating HTTP object\n");
@@ -197,6 +564,48 @@ int main(int argc, char *argv[])
 		goto error;
 	}
 
+	if (nconn > 1) {
+		uint64_t size;
+
+		rc = ranges_probe(http, uri->host, server_path, &size);
+		if (rc != EOK) {
+			fprintf(stderr, "Failed probing for ranges: %s\n",
+			    str_error(rc));
+			rc = EIO;
+			goto error;
+		}
+
+		if (size > RANGE_SIZE) {
+			rc = ranges_download(http, uri->host, server_path,
+			    fileno(ofile), size, nconn);
+			if (rc != EOK) {
+				fprintf(stderr, "Failed downloading: %s\n",
+				    str_error(rc));
+				rc = EIO;
+				goto error;
+			}
+
+			goto done;
+		}
+
+		/* Fall back to a single request */
+		if (http->conn == NULL)
+			rc = http_connect(http);
+		if (rc != EOK) {
+			fprintf(stderr, "Failed connecting: %s\n",
+			    str_error(rc));
+			rc = EIO;
+			goto error;
+		}
+	}
+
+	req = request_create("GET", server_path, uri->host);
+	if (req == NULL) {
+		fprintf(stderr, "Failed creating request\n");
+		rc = ENOMEM;
+		goto error;
+	}
+
 	rc = http_send_request(http, req);
 	if (rc != EOK) {
 		fprintf(stderr, "Failed sending request: %s\n", str_error(rc));
@@ -204,7 +613,6 @@ int main(int argc, char *argv[])
 		goto error;
 	}
 
-	http_response_t *response = NULL;
 	rc = http_receive_response(&http->recv_buffer, &response, 16 * 1024,
 	    100);
 	if (rc != EOK) {
@@ -224,8 +632,13 @@ int main(int argc, char *argv[])
 			goto error;
 		}
 
+		http_body_t body;
+		rc = http_body_init_headers(&body, &http->recv_buffer,
+		    &response->headers);
+
 		size_t body_size;
-		while ((rc = recv_buffer(&http->recv_buffer, buf, buf_size, &body_size)) == EOK && body_size > 0) {
+		while (rc == EOK && (rc = http_body_read(&body, buf, buf_size,
+		    &body_size)) == EOK && body_size > 0) {
 			fwrite(buf, 1, body_size, ofile != NULL ? ofile : stdout);
 		}
 
@@ -234,7 +647,13 @@ int main(int argc, char *argv[])
 		}
 	}
 
+done:
 	free(buf);
+	if (response != NULL)
+		http_response_destroy(response);
+	if (req != NULL)
+		http_request_destroy(req);
+	free(server_path);
 	http_destroy(http);
 	uri_destroy(uri);
 	if (ofile != NULL && fclose(ofile) != 0) {
@@ -245,6 +664,11 @@ int main(int argc, char *argv[])
 	return EOK;
 error:
 	free(buf);
+	if (response != NULL)
+		http_response_destroy(response);
+	if (req != NULL)
+		http_request_destroy(req);
+	free(server_path);
 	if (http != NULL)
 		http_destroy(http);
 	if (uri != NULL)
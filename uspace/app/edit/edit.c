@@ -1398,6 +1398,7 @@ static void search(char *pattern, bool reverse)
 	if (rc != EOK) {
 		status_display("Failed searching.");
 		search_fini(search);
+		return;
 	}
 
 	if (match.end) {
@@ -72,7 +72,9 @@ search_t *search_init(const char *pattern, void *client_data, search_ops_t ops,
 
 	search->client_data = client_data;
 	search->ops = ops;
-	search->back_table = calloc(search->pattern_length, sizeof(ssize_t));
+	/* One entry per prefix including the whole pattern, at least two */
+	search->back_table = calloc(search->pattern_length + 2,
+	    sizeof(ssize_t));
 	if (search->back_table == NULL) {
 		free(search->pattern);
 		free(search);
@@ -85,7 +87,7 @@ search_t *search_init(const char *pattern, void *client_data, search_ops_t ops,
 	search->back_table[1] = 0;
 	size_t table_idx = 2;
 	size_t pattern_idx = 0;
-	while (table_idx < search->pattern_length) {
+	while (table_idx <= search->pattern_length) {
 		if (ops.equals(search->pattern[table_idx - 1],
 		    search->pattern[pattern_idx])) {
 			pattern_idx++;
@@ -137,7 +139,7 @@ void search_fini(search_t *search)
 {
 	free(search->pattern);
 	free(search->back_table);
-
+	free(search);
 }
 
 bool char_exact_equals(const wchar_t a, const wchar_t b)
@@ -31,7 +31,7 @@
  */
 /**
  * @file
- * @brief Prototype implementation of Sheet data structure.
+ * @brief Piece table implementation of Sheet data structure.
  *
  * The sheet is an abstract data structure representing a piece of text.
  * On top of this data structure we can implement a text editor. It is
@@ -43,17 +43,24 @@
  * versa. The text that is inserted or deleted can contain tabs and newlines
  * which are interpreted and properly acted upon.
  *
- * This is a trivial implementation with poor efficiency with O(N+n)
- * insertion and deletion and O(N) mapping (in both directions), where
- * N is the size of the file and n is the size of the inserted/deleted text.
+ * The text is kept as a sequence of pieces referring to append-only text
+ * blocks, organized in a treap which also counts newlines. Insertion and
+ * deletion take O(log P + n) time, where P is the number of pieces and n
+ * is the size of the inserted text. Mapping between coordinates and
+ * positions takes O(log P + L), where L is the length of the row. Tags
+ * are kept ordered by position, so that only the tags following the
+ * modified position need to be moved.
  */
 
+#include <assert.h>
 #include <stdlib.h>
 #include <str.h>
 #include <errno.h>
 #include <adt/list.h>
+#include <adt/odict.h>
 #include <align.h>
 #include <macros.h>
+#include <mem.h>
 
 #include "sheet.h"
 #include "sheet_impl.h"
@@ -61,10 +68,483 @@
 enum {
 	TAB_WIDTH	= 8,
 
-	/** Initial  of dat buffer in bytes */
-	INITIAL_SIZE	= 32
+	/** Maximum size of a piece in bytes */
+	PIECE_SIZE	= 4096,
+
+	/** Minimum size of a text block in bytes */
+	BLOCK_SIZE	= 65536,
+
+	/** Number of unused piece nodes to keep around */
+	SPARE_PIECES	= 16
 };
 
+static void *tag_getkey(odlink_t *);
+static int tag_cmp(void *, void *);
+
+/** Get size of piece subtree. */
+static size_t piece_sub_size(sheet_piece_t *p)
+{
+	return p != NULL ? p->sub_size : 0;
+}
+
+/** Get number of newlines in piece subtree. */
+static size_t piece_sub_nl(sheet_piece_t *p)
+{
+	return p != NULL ? p->sub_nl : 0;
+}
+
+/** Recompute subtree totals of a piece from its children. */
+static void piece_update(sheet_piece_t *p)
+{
+	p->sub_size = piece_sub_size(p->left) + p->size +
+	    piece_sub_size(p->right);
+	p->sub_nl = piece_sub_nl(p->left) + p->nl + piece_sub_nl(p->right);
+}
+
+/** Count newlines in a run of text. */
+static size_t count_nl(const char *text, size_t size)
+{
+	const char *end = text + size;
+	const char *nlp;
+	size_t cnt = 0;
+
+	while ((nlp = memchr(text, '\n', end - text)) != NULL) {
+		++cnt;
+		text = nlp + 1;
+	}
+
+	return cnt;
+}
+
+/** Make sure enough piece nodes are available.
+ *
+ * Allocating the nodes in advance allows the treap operations
+ * themselves to never fail.
+ *
+ * @param sh	Sheet
+ * @param cnt	Number of nodes that will be needed
+ * @return	EOK on success, ENOMEM if out of memory
+ */
+static errno_t piece_reserve(sheet_t *sh, size_t cnt)
+{
+	sheet_piece_t *p;
+
+	while (sh->nspare < cnt) {
+		p = calloc(1, sizeof(sheet_piece_t));
+		if (p == NULL)
+			return ENOMEM;
+
+		p->right = sh->spare;
+		sh->spare = p;
+		++sh->nspare;
+	}
+
+	return EOK;
+}
+
+/** Take a reserved piece node.
+ *
+ * @param sh	Sheet
+ * @param text	Text of the piece
+ * @param size	Size of the piece in bytes
+ * @param nl	Number of newlines in the piece
+ * @return	Piece node
+ */
+static sheet_piece_t *piece_get(sheet_t *sh, const char *text, size_t size,
+    size_t nl)
+{
+	sheet_piece_t *p;
+
+	assert(sh->nspare > 0);
+	p = sh->spare;
+	sh->spare = p->right;
+	--sh->nspare;
+
+	/* xorshift32 */
+	sh->seed ^= sh->seed << 13;
+	sh->seed ^= sh->seed >> 17;
+	sh->seed ^= sh->seed << 5;
+
+	p->left = p->right = NULL;
+	p->prio = sh->seed;
+	p->text = text;
+	p->size = size;
+	p->nl = nl;
+	piece_update(p);
+	return p;
+}
+
+/** Return all nodes of a piece subtree to the reserve. */
+static void piece_put_tree(sheet_t *sh, sheet_piece_t *p)
+{
+	if (p == NULL)
+		return;
+
+	piece_put_tree(sh, p->left);
+	piece_put_tree(sh, p->right);
+
+	p->right = sh->spare;
+	sh->spare = p;
+	++sh->nspare;
+}
+
+/** Split piece treap at offset.
+ *
+ * A piece straddling @a off is cut in two, which takes one reserved node.
+ *
+ * @param sh	Sheet
+ * @param p	Root of the treap to split
+ * @param off	Offset to split at
+ * @param rl	Place to store the treap with text before @a off
+ * @param rr	Place to store the treap with text from @a off on
+ */
+static void piece_split(sheet_t *sh, sheet_piece_t *p, size_t off,
+    sheet_piece_t **rl, sheet_piece_t **rr)
+{
+	sheet_piece_t *n;
+	size_t lsize;
+	size_t nl;
+
+	if (p == NULL) {
+		*rl = *rr = NULL;
+		return;
+	}
+
+	lsize = piece_sub_size(p->left);
+	if (off <= lsize) {
+		piece_split(sh, p->left, off, rl, &p->left);
+		piece_update(p);
+		*rr = p;
+	} else if (off >= lsize + p->size) {
+		piece_split(sh, p->right, off - lsize - p->size, &p->right, rr);
+		piece_update(p);
+		*rl = p;
+	} else {
+		/* Cut the piece in two */
+		off -= lsize;
+		nl = count_nl(p->text, off);
+		n = piece_get(sh, p->text + off, p->size - off, p->nl - nl);
+		n->prio = p->prio;
+		n->right = p->right;
+		piece_update(n);
+
+		p->size = off;
+		p->nl = nl;
+		p->right = NULL;
+		piece_update(p);
+
+		*rl = p;
+		*rr = n;
+	}
+}
+
+/** Concatenate two piece treaps.
+ *
+ * @param a	Treap with the preceding text
+ * @param b	Treap with the following text
+ * @return	Root of the resulting treap
+ */
+static sheet_piece_t *piece_merge(sheet_piece_t *a, sheet_piece_t *b)
+{
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	if (a->prio > b->prio) {
+		a->right = piece_merge(a->right, b);
+		piece_update(a);
+		return a;
+	}
+
+	b->left = piece_merge(a, b->left);
+	piece_update(b);
+	return b;
+}
+
+/** Extend the piece ending at offset by text appended right after it.
+ *
+ * This is what happens when the user is typing, it saves creating a new
+ * piece for every character.
+ *
+ * @param p	Root of the treap
+ * @param off	Offset where the text is being inserted
+ * @param text	Text being inserted, already stored in a text block
+ * @param size	Size of the text in bytes
+ * @param nl	Number of newlines in the text
+ * @return	@c true if the piece was extended, @c false if there is
+ *		no such piece
+ */
+static bool piece_append(sheet_piece_t *p, size_t off, const char *text,
+    size_t size, size_t nl)
+{
+	size_t lsize;
+	bool extended;
+
+	if (p == NULL)
+		return false;
+
+	lsize = piece_sub_size(p->left);
+	if (off <= lsize) {
+		extended = piece_append(p->left, off, text, size, nl);
+	} else if (off < lsize + p->size) {
+		extended = false;
+	} else if (off == lsize + p->size) {
+		extended = p->text + p->size == text &&
+		    p->size + size <= PIECE_SIZE;
+		if (extended) {
+			p->size += size;
+			p->nl += nl;
+		}
+	} else {
+		extended = piece_append(p->right, off - lsize - p->size, text,
+		    size, nl);
+	}
+
+	if (extended) {
+		p->sub_size += size;
+		p->sub_nl += nl;
+	}
+
+	return extended;
+}
+
+/** Get size of the next piece to cut off text being inserted.
+ *
+ * Pieces are kept small so that scanning within one stays cheap. If
+ * possible, a character is not split between two pieces.
+ */
+static size_t piece_chunk(const char *text, size_t size)
+{
+	size_t n;
+
+	if (size <= PIECE_SIZE)
+		return size;
+
+	n = PIECE_SIZE;
+	while (n > PIECE_SIZE - STR_BOUNDS(1) && (text[n] & 0xc0) == 0x80)
+		--n;
+
+	return n;
+}
+
+/** Store text in a text block.
+ *
+ * @param sh	Sheet
+ * @param str	Text to store
+ * @param size	Size of the text in bytes
+ * @return	Stored text or @c NULL if out of memory
+ */
+static const char *sheet_text_store(sheet_t *sh, const char *str, size_t size)
+{
+	sheet_block_t *block = NULL;
+	link_t *link;
+	char *text;
+
+	link = list_last(&sh->blocks);
+	if (link != NULL)
+		block = list_get_instance(link, sheet_block_t, lblocks);
+
+	if (block == NULL || block->size - block->used < size) {
+		block = malloc(sizeof(sheet_block_t) + max(size, BLOCK_SIZE));
+		if (block == NULL)
+			return NULL;
+
+		block->size = max(size, BLOCK_SIZE);
+		block->used = 0;
+		list_append(&block->lblocks, &sh->blocks);
+	}
+
+	text = block->data + block->used;
+	memcpy(text, str, size);
+	block->used += size;
+	return text;
+}
+
+/** Find piece containing offset.
+ *
+ * Sequential access, such as by spt_next_char(), keeps hitting the same
+ * piece, which is then found without searching the treap.
+ *
+ * @param sh	Sheet
+ * @param off	Offset
+ * @param cur	Place to store location of the piece
+ * @return	@c true on success, @c false if @a off is at or past end
+ *		of text
+ */
+static bool sheet_find_piece(sheet_t *sh, size_t off, sheet_cursor_t *cur)
+{
+	sheet_piece_t *p;
+	size_t start;
+	size_t lsize;
+
+	if (sh->cursor.text != NULL && off >= sh->cursor.start &&
+	    off - sh->cursor.start < sh->cursor.size) {
+		*cur = sh->cursor;
+		return true;
+	}
+
+	p = sh->root;
+	start = 0;
+	while (p != NULL) {
+		lsize = piece_sub_size(p->left);
+		if (off < lsize) {
+			p = p->left;
+		} else if (off < lsize + p->size) {
+			sh->cursor.text = p->text;
+			sh->cursor.start = start + lsize;
+			sh->cursor.size = p->size;
+			*cur = sh->cursor;
+			return true;
+		} else {
+			off -= lsize + p->size;
+			start += lsize + p->size;
+			p = p->right;
+		}
+	}
+
+	return false;
+}
+
+/** Copy text out of the sheet.
+ *
+ * @param sh	Sheet
+ * @param off	Offset of the first byte to copy
+ * @param buf	Destination buffer
+ * @param size	Number of bytes to copy
+ * @return	Number of bytes copied, less than @a size if the end of
+ *		text was reached
+ */
+static size_t sheet_read(sheet_t *sh, size_t off, char *buf, size_t size)
+{
+	sheet_cursor_t cur;
+	size_t done;
+	size_t n;
+
+	done = 0;
+	while (done < size && sheet_find_piece(sh, off + done, &cur)) {
+		n = min(cur.start + cur.size - (off + done), size - done);
+		memcpy(buf + done, cur.text + (off + done - cur.start), n);
+		done += n;
+	}
+
+	return done;
+}
+
+/** Decode character at offset and advance the offset past it. */
+static wchar_t sheet_decode(sheet_t *sh, size_t *off)
+{
+	char buf[STR_BOUNDS(1)];
+	size_t size;
+	size_t boff;
+	wchar_t c;
+
+	size = sheet_read(sh, *off, buf, sizeof(buf));
+	boff = 0;
+	c = str_decode(buf, &boff, size);
+	*off += boff;
+	return c;
+}
+
+/** Decode character preceding offset and move the offset before it. */
+static wchar_t sheet_decode_reverse(sheet_t *sh, size_t *off)
+{
+	char buf[STR_BOUNDS(1)];
+	size_t start;
+	size_t size;
+	size_t boff;
+	wchar_t c;
+
+	start = *off > sizeof(buf) ? *off - sizeof(buf) : 0;
+	size = sheet_read(sh, start, buf, *off - start);
+	boff = size;
+	c = str_decode_reverse(buf, &boff, size);
+	*off = start + boff;
+	return c;
+}
+
+/** Find the offset where a row starts.
+ *
+ * @param sh	Sheet
+ * @param row	Row number (starting from 1)
+ * @param roff	Place to store offset of the first character on the row
+ * @return	@c true on success, @c false if there is no such row
+ */
+static bool sheet_row_start(sheet_t *sh, int row, size_t *roff)
+{
+	sheet_piece_t *p;
+	const char *nlp;
+	size_t off;
+	size_t lnl;
+	size_t k;
+
+	if (row <= 1) {
+		*roff = 0;
+		return true;
+	}
+
+	/* Look for the (row - 1)-th newline */
+	k = row - 1;
+	if (k > piece_sub_nl(sh->root))
+		return false;
+
+	p = sh->root;
+	off = 0;
+	while (true) {
+		lnl = piece_sub_nl(p->left);
+		if (k <= lnl) {
+			p = p->left;
+			continue;
+		}
+
+		k -= lnl;
+		off += piece_sub_size(p->left);
+		if (k <= p->nl)
+			break;
+
+		k -= p->nl;
+		off += p->size;
+		p = p->right;
+	}
+
+	nlp = p->text - 1;
+	do {
+		nlp = memchr(nlp + 1, '\n', p->text + p->size - (nlp + 1));
+	} while (--k > 0);
+
+	*roff = off + (nlp - p->text) + 1;
+	return true;
+}
+
+/** Count newlines preceding an offset. */
+static size_t sheet_nl_before(sheet_t *sh, size_t off)
+{
+	sheet_piece_t *p;
+	size_t lsize;
+	size_t cnt;
+
+	p = sh->root;
+	cnt = 0;
+	while (p != NULL) {
+		lsize = piece_sub_size(p->left);
+		if (off <= lsize) {
+			p = p->left;
+			continue;
+		}
+
+		cnt += piece_sub_nl(p->left);
+		off -= lsize;
+		if (off <= p->size)
+			return cnt + count_nl(p->text, off);
+
+		cnt += p->nl;
+		off -= p->size;
+		p = p->right;
+	}
+
+	return cnt;
+}
+
 /** Initialize an empty sheet. */
 errno_t sheet_create(sheet_t **rsh)
 {
@@ -74,14 +554,9 @@ errno_t sheet_create(sheet_t **rsh)
 	if (sh == NULL)
 		return ENOMEM;
 
-	sh->dbuf_size = INITIAL_SIZE;
-	sh->text_size = 0;
-
-	sh->data = malloc(sh->dbuf_size);
-	if (sh->data == NULL)
-		return ENOMEM;
-
-	list_initialize(&sh->tags);
+	sh->seed = 0x2545f491;
+	list_initialize(&sh->blocks);
+	odict_initialize(&sh->tags, tag_getkey, tag_cmp);
 
 	*rsh = sh;
 	return EOK;
@@ -102,35 +577,57 @@ errno_t sheet_create(sheet_t **rsh)
  */
 errno_t sheet_insert(sheet_t *sh, spt_t *pos, enum dir_spec dir, char *str)
 {
-	char *ipp;
+	sheet_piece_t *l, *r;
+	const char *text;
 	size_t sz;
-	char *newp;
+	size_t nl;
+	size_t cnt;
+	size_t off;
+	size_t n;
+	odlink_t *odlink;
+	errno_t rc;
 
 	sz = str_size(str);
-	if (sh->text_size + sz > sh->dbuf_size) {
-		/* Enlarge data buffer. */
-		newp = realloc(sh->data, sh->dbuf_size * 2);
-		if (newp == NULL)
-			return ELIMIT;
-
-		sh->data = newp;
-		sh->dbuf_size = sh->dbuf_size * 2;
-	}
+	if (sz == 0)
+		return EOK;
+
+	/* One node for each piece plus one for cutting the piece at pos */
+	cnt = 1;
+	for (off = 0; off < sz; off += piece_chunk(str + off, sz - off))
+		++cnt;
 
-	ipp = sh->data + pos->b_off;
+	rc = piece_reserve(sh, cnt);
+	if (rc != EOK)
+		return rc;
 
-	/* Copy data. */
-	memmove(ipp + sz, ipp, sh->text_size - pos->b_off);
-	memcpy(ipp, str, sz);
-	sh->text_size += sz;
+	text = sheet_text_store(sh, str, sz);
+	if (text == NULL)
+		return ENOMEM;
 
-	/* Adjust tags. */
+	nl = count_nl(text, sz);
+	if (!piece_append(sh->root, pos->b_off, text, sz, nl)) {
+		piece_split(sh, sh->root, pos->b_off, &l, &r);
 
-	list_foreach(sh->tags, link, tag_t, tag) {
-		if (tag->b_off > pos->b_off)
-			tag->b_off += sz;
-		else if (tag->b_off == pos->b_off && dir == dir_before)
-			tag->b_off += sz;
+		for (off = 0; off < sz; off += n) {
+			n = piece_chunk(text + off, sz - off);
+			l = piece_merge(l, piece_get(sh, text + off, n,
+			    count_nl(text + off, n)));
+		}
+
+		sh->root = piece_merge(l, r);
+	}
+
+	sh->cursor.text = NULL;
+
+	/* Adjust tags. */
+	if (dir == dir_before)
+		odlink = odict_find_geq(&sh->tags, &pos->b_off, NULL);
+	else
+		odlink = odict_find_gt(&sh->tags, &pos->b_off, NULL);
+
+	while (odlink != NULL) {
+		odict_get_instance(odlink, tag_t, ltags)->b_off += sz;
+		odlink = odict_next(odlink, &sh->tags);
 	}
 
 	return EOK;
@@ -148,37 +645,42 @@ errno_t sheet_insert(sheet_t *sh, spt_t *pos, enum dir_spec dir, char *str)
  */
 errno_t sheet_delete(sheet_t *sh, spt_t *spos, spt_t *epos)
 {
-	char *spp;
+	sheet_piece_t *l, *m, *r;
 	size_t sz;
-	char *newp;
-	size_t shrink_size;
+	odlink_t *odlink;
+	tag_t *tag;
+	errno_t rc;
 
-	spp = sh->data + spos->b_off;
 	sz = epos->b_off - spos->b_off;
 
-	memmove(spp, spp + sz, sh->text_size - (spos->b_off + sz));
-	sh->text_size -= sz;
+	/* Cutting pieces at both ends may take two nodes. */
+	rc = piece_reserve(sh, 2);
+	if (rc != EOK)
+		return rc;
+
+	piece_split(sh, sh->root, epos->b_off, &l, &r);
+	piece_split(sh, l, spos->b_off, &l, &m);
+	piece_put_tree(sh, m);
+	sh->root = piece_merge(l, r);
+
+	while (sh->nspare > SPARE_PIECES) {
+		m = sh->spare;
+		sh->spare = m->right;
+		--sh->nspare;
+		free(m);
+	}
 
-	/* Adjust tags. */
-	list_foreach(sh->tags, link, tag_t, tag) {
+	sh->cursor.text = NULL;
+
+	/* Adjust tags. This does not change their order. */
+	odlink = odict_find_geq(&sh->tags, &spos->b_off, NULL);
+	while (odlink != NULL) {
+		tag = odict_get_instance(odlink, tag_t, ltags);
 		if (tag->b_off >= epos->b_off)
 			tag->b_off -= sz;
-		else if (tag->b_off >= spos->b_off)
+		else
 			tag->b_off = spos->b_off;
-	}
-
-	/* See if we should free up some memory. */
-	shrink_size = max(sh->dbuf_size / 4, INITIAL_SIZE);
-	if (sh->text_size <= shrink_size && sh->dbuf_size > INITIAL_SIZE) {
-		/* Shrink data buffer. */
-		newp = realloc(sh->data, shrink_size);
-		if (newp == NULL) {
-			/* Failed to shrink buffer... no matter. */
-			return EOK;
-		}
-
-		sh->data = newp;
-		sh->dbuf_size = shrink_size;
+		odlink = odict_next(odlink, &sh->tags);
 	}
 
 	return EOK;
@@ -188,26 +690,24 @@ errno_t sheet_delete(sheet_t *sh, spt_t *spos, spt_t *epos)
 void sheet_copy_out(sheet_t *sh, spt_t const *spos, spt_t const *epos,
     char *buf, size_t bufsize, spt_t *fpos)
 {
-	char *spp;
 	size_t range_sz;
 	size_t copy_sz;
 	size_t off, prev;
 	wchar_t c;
 
-	spp = sh->data + spos->b_off;
 	range_sz = epos->b_off - spos->b_off;
 	copy_sz = (range_sz < bufsize - 1) ? range_sz : bufsize - 1;
+	copy_sz = sheet_read(sh, spos->b_off, buf, copy_sz);
 
 	prev = off = 0;
 	do {
 		prev = off;
-		c = str_decode(spp, &off, copy_sz);
+		c = str_decode(buf, &off, copy_sz);
 	} while (c != '\0');
 
 	/* Crop copy_sz down to the last full character. */
 	copy_sz = prev;
 
-	memcpy(buf, spp, copy_sz);
 	buf[copy_sz] = '\0';
 
 	fpos->b_off = spos->b_off + copy_sz;
@@ -218,14 +718,29 @@ void sheet_copy_out(sheet_t *sh, spt_t const *spos, spt_t const *epos,
 void sheet_get_cell_pt(sheet_t *sh, coord_t const *coord, enum dir_spec dir,
     spt_t *pt)
 {
+	size_t text_size;
 	size_t cur_pos, prev_pos;
 	wchar_t c;
 	coord_t cc;
 
-	cc.row = cc.column = 1;
-	cur_pos = prev_pos = 0;
+	text_size = piece_sub_size(sh->root);
+
+	/* Start scanning at the beginning of the row. */
+	if (!sheet_row_start(sh, coord->row, &cur_pos)) {
+		/* No such row, the scan would stop at the end of text. */
+		cur_pos = prev_pos = text_size;
+	} else if (cur_pos > 0) {
+		/* Continue as if we have just passed the newline. */
+		prev_pos = cur_pos - 1;
+		cc.row = coord->row;
+		cc.column = 1;
+	} else {
+		prev_pos = 0;
+		cc.row = cc.column = 1;
+	}
+
 	while (true) {
-		if (prev_pos >= sh->text_size) {
+		if (prev_pos >= text_size) {
 			/* Cannot advance any further. */
 			break;
 		}
@@ -238,7 +753,7 @@ void sheet_get_cell_pt(sheet_t *sh, coord_t const *coord, enum dir_spec dir,
 
 		prev_pos = cur_pos;
 
-		c = str_decode(sh->data, &cur_pos, sh->text_size);
+		c = sheet_decode(sh, &cur_pos);
 		if (c == '\n') {
 			++cc.row;
 			cc.column = 1;
@@ -271,40 +786,31 @@ void sheet_get_row_width(sheet_t *sh, int row, int *length)
 /** Get the number of rows in a sheet. */
 void sheet_get_num_rows(sheet_t *sh, int *rows)
 {
-	int cnt;
-	size_t bo;
-
-	cnt = 1;
-	for (bo = 0; bo < sh->dbuf_size; ++bo) {
-		if (sh->data[bo] == '\n')
-			cnt += 1;
-	}
-
-	*rows = cnt;
+	*rows = 1 + piece_sub_nl(sh->root);
 }
 
 /** Get the coordinates of an s-point. */
 void spt_get_coord(spt_t const *pos, coord_t *coord)
 {
 	size_t off;
+	size_t end;
 	coord_t cc;
 	wchar_t c;
 	sheet_t *sh;
 
 	sh = pos->sh;
-	cc.row = cc.column = 1;
+	end = min(pos->b_off, piece_sub_size(sh->root));
 
-	off = 0;
-	while (off < pos->b_off && off < sh->text_size) {
-		c = str_decode(sh->data, &off, sh->text_size);
-		if (c == '\n') {
-			++cc.row;
-			cc.column = 1;
-		} else if (c == '\t') {
+	cc.row = 1 + sheet_nl_before(sh, end);
+	cc.column = 1;
+
+	(void) sheet_row_start(sh, cc.row, &off);
+	while (off < end) {
+		c = sheet_decode(sh, &off);
+		if (c == '\t')
 			cc.column = 1 + ALIGN_UP(cc.column, TAB_WIDTH);
-		} else {
+		else
 			++cc.column;
-		}
 	}
 
 	*coord = cc;
@@ -319,7 +825,7 @@ bool spt_equal(spt_t const *a, spt_t const *b)
 /** Get a character at spt and return next spt */
 wchar_t spt_next_char(spt_t spt, spt_t *next)
 {
-	wchar_t ch = str_decode(spt.sh->data, &spt.b_off, spt.sh->text_size);
+	wchar_t ch = sheet_decode(spt.sh, &spt.b_off);
 	if (next)
 		*next = spt;
 	return ch;
@@ -327,7 +833,7 @@ wchar_t spt_next_char(spt_t spt, spt_t *next)
 
 wchar_t spt_prev_char(spt_t spt, spt_t *prev)
 {
-	wchar_t ch = str_decode_reverse(spt.sh->data, &spt.b_off, spt.sh->text_size);
+	wchar_t ch = sheet_decode_reverse(spt.sh, &spt.b_off);
 	if (prev)
 		*prev = spt;
 	return ch;
@@ -338,13 +844,13 @@ void sheet_place_tag(sheet_t *sh, spt_t const *pt, tag_t *tag)
 {
 	tag->b_off = pt->b_off;
 	tag->sh = sh;
-	list_append(&tag->link, &sh->tags);
+	odict_insert(&tag->ltags, &sh->tags, NULL);
 }
 
 /** Remove a tag from the sheet. */
 void sheet_remove_tag(sheet_t *sh, tag_t *tag)
 {
-	list_remove(&tag->link);
+	odict_remove(&tag->ltags);
 }
 
 /** Get s-point on which the tag is located right now. */
@@ -354,5 +860,25 @@ void tag_get_pt(tag_t const *tag, spt_t *pt)
 	pt->sh = tag->sh;
 }
 
+/** Get key of a tag in sheet_t.tags. */
+static void *tag_getkey(odlink_t *odlink)
+{
+	return &odict_get_instance(odlink, tag_t, ltags)->b_off;
+}
+
+/** Compare keys of tags in sheet_t.tags. */
+static int tag_cmp(void *a, void *b)
+{
+	size_t oa = *(size_t *)a;
+	size_t ob = *(size_t *)b;
+
+	if (oa < ob)
+		return -1;
+	else if (oa > ob)
+		return 1;
+	else
+		return 0;
+}
+
 /** @}
  */
@@ -36,17 +36,81 @@
 #ifndef SHEET_IMPL_H__
 #define SHEET_IMPL_H__
 
+#include <adt/list.h>
+#include <adt/odict.h>
+#include <stdint.h>
 #include "sheet.h"
 
+/** Piece of text
+ *
+ * The text of the sheet is a sequence of pieces, each referring to a run
+ * of bytes in one of the text blocks. The pieces form a treap ordered by
+ * position in the text. Each node caches the size and the number of
+ * newlines of its subtree, which serves as the line-start index.
+ */
+typedef struct sheet_piece {
+	/** Pieces preceding this one */
+	struct sheet_piece *left;
+	/** Pieces following this one */
+	struct sheet_piece *right;
+	/** Treap priority */
+	uint32_t prio;
+	/** Text of the piece */
+	const char *text;
+	/** Size of the piece in bytes */
+	size_t size;
+	/** Number of newlines in the piece */
+	size_t nl;
+	/** Size of the subtree in bytes */
+	size_t sub_size;
+	/** Number of newlines in the subtree */
+	size_t sub_nl;
+} sheet_piece_t;
+
+/** Block of memory holding inserted text
+ *
+ * Text is only ever appended to a block, the pieces refer to it.
+ */
+typedef struct {
+	/** Link to sheet_t.blocks */
+	link_t lblocks;
+	/** Size of the block data */
+	size_t size;
+	/** Number of bytes used */
+	size_t used;
+	/** Block data */
+	char data[];
+} sheet_block_t;
+
+/** Cached location of the piece accessed most recently */
+typedef struct {
+	/** Text of the piece or @c NULL if the cache is not valid */
+	const char *text;
+	/** Offset of the piece in the sheet */
+	size_t start;
+	/** Size of the piece in bytes */
+	size_t size;
+} sheet_cursor_t;
+
 /** Sheet */
 struct sheet {
 	/* Note: This structure is opaque for the user. */
 
-	size_t text_size;
-	size_t dbuf_size;
-	char *data;
+	/** Root of the piece treap */
+	sheet_piece_t *root;
+	/** Unused piece nodes linked through the @c right pointer */
+	sheet_piece_t *spare;
+	/** Number of unused piece nodes */
+	size_t nspare;
+	/** Text blocks (sheet_block_t) */
+	list_t blocks;
+	/** Most recently accessed piece */
+	sheet_cursor_t cursor;
+	/** State of the priority generator */
+	uint32_t seed;
 
-	list_t tags;
+	/** Tags ordered by position (tag_t) */
+	odict_t tags;
 };
 
 #endif
@@ -34,16 +34,25 @@
 
 #include <errno.h>
 #include <gzip.h>
+#include <inflate.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+/** Size of the input and output buffers */
+#define BUFFER_SIZE  65536
+
+static uint8_t inbuf[BUFFER_SIZE];
+static uint8_t outbuf[BUFFER_SIZE];
+
 int main(int argc, char *argv[])
 {
+	inflate_stream_t strm;
 	errno_t rc;
-	void *data, *ddata;
-	size_t size, dsize;
 	size_t nread, nwr;
-	long len;
+	size_t hdrlen;
 	FILE *f, *wf;
 
 	if (argc != 3) {
@@ -57,61 +66,90 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
-	if (fseek(f, 0, SEEK_END) < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
-
-	len = ftell(f);
-	if (len < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
+	/* The header has to fit in the first buffer */
+	nread = fread(inbuf, 1, BUFFER_SIZE, f);
+	if (ferror(f)) {
+		printf("Error reading '%s'\n", argv[1]);
 		fclose(f);
 		return 1;
 	}
 
-	if (fseek(f, 0, SEEK_SET) < 0) {
-		printf ("Error rewinding '%s'\n", argv[1]);
+	rc = gzip_header_parse(inbuf, nread, &hdrlen);
+	if (rc != EOK) {
+		printf("Invalid header of '%s'\n", argv[1]);
 		fclose(f);
 		return 1;
 	}
 
-	data = malloc(len);
-	if (data == NULL) {
-		printf("Error allocating %ld bytes.\n", len);
+	wf = fopen(argv[2], "wb");
+	if (wf == NULL) {
+		printf("Error creating file '%s'\n", argv[2]);
 		fclose(f);
 		return 1;
 	}
 
-	nread = fread(data, 1, len, f);
-	if (nread != (size_t)len) {
-		printf("Error reading '%s'\n", argv[1]);
+	rc = inflate_init(&strm);
+	if (rc != EOK) {
+		printf("Out of memory.\n");
 		fclose(f);
+		fclose(wf);
 		return 1;
 	}
 
-	fclose(f);
-
-	size = (size_t) len;
-
-	rc = gzip_expand(data, size, &ddata, &dsize);
+	strm.next_in = inbuf + hdrlen;
+	strm.avail_in = nread - hdrlen;
+
+	/* Decompress buffer by buffer */
+	do {
+		if ((strm.avail_in == 0) && !feof(f)) {
+			nread = fread(inbuf, 1, BUFFER_SIZE, f);
+			if (ferror(f)) {
+				printf("Error reading '%s'\n", argv[1]);
+				goto error;
+			}
+
+			strm.next_in = inbuf;
+			strm.avail_in = nread;
+		}
+
+		bool no_input = (strm.avail_in == 0);
+
+		strm.next_out = outbuf;
+		strm.avail_out = BUFFER_SIZE;
+
+		rc = inflate_step(&strm);
+		if ((rc != EOK) && (rc != EAGAIN)) {
+			printf("Error decompressing data.\n");
+			goto error;
+		}
+
+		size_t cnt = BUFFER_SIZE - strm.avail_out;
+		nwr = fwrite(outbuf, 1, cnt, wf);
+		if (nwr != cnt) {
+			printf("Error writing '%s'\n", argv[2]);
+			goto error;
+		}
+
+		if ((rc == EAGAIN) && no_input && (strm.avail_out > 0)) {
+			printf("Unexpected end of '%s'\n", argv[1]);
+			goto error;
+		}
+	} while (rc == EAGAIN);
+
+	/* Read the rest of the footer following the deflate stream */
+	nread = strm.avail_in;
+	memmove(inbuf, strm.next_in, nread);
+	if (!feof(f))
+		nread += fread(inbuf + nread, 1, BUFFER_SIZE - nread, f);
+
+	rc = gzip_footer_check(inbuf, nread, strm.total_out);
 	if (rc != EOK) {
-		printf("Error decompressing data.\n");
-		return 1;
-	}
-
-	wf = fopen(argv[2], "wb");
-	if (wf == NULL) {
-		printf("Error creating file '%s'\n", argv[2]);
-		return 1;
+		printf("Invalid footer of '%s'\n", argv[1]);
+		goto error;
 	}
 
-	nwr = fwrite(ddata, 1, dsize, wf);
-	if (nwr != dsize) {
-		printf("Error writing '%s'\n", argv[2]);
-		fclose(wf);
-		return 1;
-	}
+	inflate_end(&strm);
+	fclose(f);
 
 	if (fclose(wf) != 0) {
 		printf("Error writing '%s'\n", argv[2]);
@@ -119,6 +157,12 @@ int main(int argc, char *argv[])
 	}
 
 	return 0;
+
+error:
+	inflate_end(&strm);
+	fclose(f);
+	fclose(wf);
+	return 1;
 }
 
 /** @}
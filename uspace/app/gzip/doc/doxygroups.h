@@ -0,0 +1,4 @@
+/** @addtogroup gzip gzip
+ * @brief Compress a file to .gz
+ * @ingroup apps
+ */
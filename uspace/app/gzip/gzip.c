@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup gzip
+ * @{
+ */
+/** @file
+ */
+
+#include <adt/checksum.h>
+#include <deflate.h>
+#include <errno.h>
+#include <fibril.h>
+#include <gzip.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+
+/** Size of the input and output buffers */
+#define BUFFER_SIZE  65536
+
+static uint8_t inbuf[BUFFER_SIZE];
+static uint8_t outbuf[BUFFER_SIZE];
+
+static void print_syntax(void)
+{
+	printf("syntax: gzip [-<level>] [-j <workers>] <src> <dest.gz>\n");
+	printf("\t-<level>      compression level (0 to 9, default %u)\n",
+	    DEFLATE_LEVEL_DEFAULT);
+	printf("\t-j <workers>  compress in parallel on <workers> threads\n");
+}
+
+/** Compress a file buffer by buffer
+ *
+ * @param f     Source file.
+ * @param wf    Destination file.
+ * @param level Compression level.
+ *
+ * @return EOK on success, EIO on I/O error or an error code.
+ */
+static errno_t gzip_stream(FILE *f, FILE *wf, unsigned int level)
+{
+	deflate_stream_t strm;
+	uint32_t crc = 0;
+	errno_t rc;
+
+	rc = deflate_init(&strm, level);
+	if (rc != EOK)
+		return rc;
+
+	gzip_header_write(outbuf, level);
+	if (fwrite(outbuf, 1, GZIP_HEADER_SIZE, wf) != GZIP_HEADER_SIZE) {
+		rc = EIO;
+		goto out;
+	}
+
+	strm.next_in = inbuf;
+	strm.avail_in = 0;
+
+	do {
+		if ((strm.avail_in == 0) && !feof(f)) {
+			size_t nread = fread(inbuf, 1, BUFFER_SIZE, f);
+			if (ferror(f)) {
+				rc = EIO;
+				goto out;
+			}
+
+			crc = compute_crc32_seed(inbuf, nread, crc);
+			strm.next_in = inbuf;
+			strm.avail_in = nread;
+		}
+
+		deflate_flush_t flush = feof(f) ? DEFLATE_FINISH :
+		    DEFLATE_NO_FLUSH;
+
+		strm.next_out = outbuf;
+		strm.avail_out = BUFFER_SIZE;
+
+		rc = deflate_step(&strm, flush);
+		if ((rc != EOK) && (rc != EAGAIN))
+			goto out;
+
+		size_t cnt = BUFFER_SIZE - strm.avail_out;
+		if (fwrite(outbuf, 1, cnt, wf) != cnt) {
+			rc = EIO;
+			goto out;
+		}
+	} while (rc == EAGAIN);
+
+	gzip_footer_write(outbuf, crc, strm.total_in);
+	if (fwrite(outbuf, 1, GZIP_FOOTER_SIZE, wf) != GZIP_FOOTER_SIZE)
+		rc = EIO;
+
+out:
+	deflate_end(&strm);
+	return rc;
+}
+
+/** Compress a whole file in parallel
+ *
+ * @param f       Source file.
+ * @param wf      Destination file.
+ * @param level   Compression level.
+ * @param workers Number of workers.
+ *
+ * @return EOK on success, EIO on I/O error or an error code.
+ */
+static errno_t gzip_parallel(FILE *f, FILE *wf, unsigned int level,
+    unsigned int workers)
+{
+	uint8_t *data = NULL;
+	size_t size = 0;
+	size_t len = 0;
+	void *dest;
+	size_t destlen;
+	errno_t rc;
+
+	while (!feof(f)) {
+		if (len == size) {
+			size = (size == 0) ? BUFFER_SIZE : 2 * size;
+			uint8_t *ndata = realloc(data, size);
+			if (ndata == NULL) {
+				free(data);
+				return ENOMEM;
+			}
+
+			data = ndata;
+		}
+
+		len += fread(data + len, 1, size - len, f);
+		if (ferror(f)) {
+			free(data);
+			return EIO;
+		}
+	}
+
+	/* The calling fibril is one of the workers */
+	fibril_test_spawn_runners(workers - 1);
+
+	rc = gzip_compress(data, len, level, workers, &dest, &destlen);
+	free(data);
+	if (rc != EOK)
+		return rc;
+
+	if (fwrite(dest, 1, destlen, wf) != destlen)
+		rc = EIO;
+
+	free(dest);
+	return rc;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int level = DEFLATE_LEVEL_DEFAULT;
+	unsigned int workers = 1;
+	FILE *f, *wf;
+	errno_t rc;
+	int i = 1;
+
+	while ((i < argc) && (argv[i][0] == '-')) {
+		if (str_cmp(argv[i], "-j") == 0) {
+			if (i + 1 >= argc) {
+				print_syntax();
+				return 1;
+			}
+
+			workers = strtoul(argv[i + 1], NULL, 10);
+			if (workers == 0) {
+				print_syntax();
+				return 1;
+			}
+
+			i += 2;
+		} else if ((argv[i][1] >= '0') && (argv[i][1] <= '9') &&
+		    (argv[i][2] == '\0')) {
+			level = argv[i][1] - '0';
+			i++;
+		} else {
+			print_syntax();
+			return 1;
+		}
+	}
+
+	if (argc - i != 2) {
+		print_syntax();
+		return 1;
+	}
+
+	f = fopen(argv[i], "rb");
+	if (f == NULL) {
+		printf("Error opening '%s'\n", argv[i]);
+		return 1;
+	}
+
+	wf = fopen(argv[i + 1], "wb");
+	if (wf == NULL) {
+		printf("Error creating file '%s'\n", argv[i + 1]);
+		fclose(f);
+		return 1;
+	}
+
+	if (workers > 1)
+		rc = gzip_parallel(f, wf, level, workers);
+	else
+		rc = gzip_stream(f, wf, level);
+
+	fclose(f);
+
+	if (fclose(wf) != 0)
+		rc = EIO;
+
+	if (rc != EOK) {
+		printf("Error compressing '%s' to '%s': %s\n", argv[i],
+		    argv[i + 1], str_error(rc));
+		return 1;
+	}
+
+	return 0;
+}
+
+/** @}
+ */
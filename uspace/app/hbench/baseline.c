@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+/**
+ * @file
+ * @brief Comparison with results of a previous run.
+ *
+ * A baseline is a CSV report written by an earlier run (see csv.c). The
+ * throughputs of the measured runs of a benchmark are compared with the
+ * baseline ones by the Mann-Whitney U test, which needs no assumption
+ * about their distribution. A regression is reported when the throughput
+ * is significantly lower and its median dropped by more than the
+ * threshold.
+ */
+
+#include <adt/list.h>
+#include <errno.h>
+#include <macros.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include "hbench.h"
+
+/** Longest line of a CSV report */
+#define LINE_SIZE 512
+/** Largest number of fields of a CSV report line */
+#define FIELDS_MAX 16
+
+/**
+ * Critical value of the standard normal distribution for the one-sided
+ * test at the 5 % significance level.
+ */
+#define Z_CRITICAL 1.645
+
+/** Measured run of the baseline. */
+typedef struct {
+	link_t link;
+	char *name;
+	unsigned int threads;
+	/** Throughput in operations per nanosecond */
+	double thruput;
+} baseline_entry_t;
+
+/** Throughput sample of either the baseline or the current run. */
+typedef struct {
+	double thruput;
+	bool current;
+} sample_t;
+
+static LIST_INITIALIZE(baseline);
+
+/** Allowed drop of the median throughput in percent */
+static unsigned int threshold = BASELINE_DEFAULT_THRESHOLD;
+
+/** Split a CSV line into fields.
+ *
+ * @param line Line to split, it is modified.
+ * @param fields Where to store the fields.
+ * @return Number of fields.
+ */
+static size_t split_line(char *line, char *fields[FIELDS_MAX])
+{
+	size_t count = 0;
+	char *p = line;
+
+	while (count < FIELDS_MAX) {
+		fields[count++] = p;
+
+		while (*p != ',' && *p != '\n' && *p != '\r' && *p != '\0')
+			p++;
+		if (*p != ',') {
+			*p = '\0';
+			break;
+		}
+		*p++ = '\0';
+	}
+
+	return count;
+}
+
+/** Find a column of a CSV report by its name.
+ *
+ * @return Column index or -1 if the report has no such column.
+ */
+static int find_column(char *fields[], size_t count, const char *name)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (str_cmp(fields[i], name) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+/** Load the baseline from a CSV report.
+ *
+ * Warm-up runs are ignored. Reports without the threads column are
+ * taken as single-threaded.
+ *
+ * @param filename CSV report of a previous run.
+ * @return EOK on success or an error code.
+ */
+errno_t baseline_load(const char *filename)
+{
+	char line[LINE_SIZE];
+	char *fields[FIELDS_MAX];
+	errno_t rc = EOK;
+
+	FILE *f = fopen(filename, "r");
+	if (f == NULL)
+		return errno;
+
+	if (fgets(line, sizeof(line), f) == NULL) {
+		fclose(f);
+		return EINVAL;
+	}
+
+	size_t count = split_line(line, fields);
+	int col_name = find_column(fields, count, "benchmark");
+	int col_threads = find_column(fields, count, "threads");
+	int col_run = find_column(fields, count, "run");
+	int col_size = find_column(fields, count, "size");
+	int col_duration = find_column(fields, count, "duration_nanos");
+
+	if (col_name < 0 || col_run < 0 || col_size < 0 || col_duration < 0) {
+		fclose(f);
+		return EINVAL;
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		count = split_line(line, fields);
+		if (count <= (size_t) max(max(col_name, col_threads),
+		    max(col_run, max(col_size, col_duration))))
+			continue;
+
+		if (strtol(fields[col_run], NULL, 10) < 0)
+			continue;
+
+		double size = strtoull(fields[col_size], NULL, 10);
+		double nanos = strtoull(fields[col_duration], NULL, 10);
+		if (nanos <= 0)
+			continue;
+
+		baseline_entry_t *entry = calloc(1, sizeof(baseline_entry_t));
+		if (entry == NULL) {
+			rc = ENOMEM;
+			break;
+		}
+
+		entry->name = str_dup(fields[col_name]);
+		if (entry->name == NULL) {
+			free(entry);
+			rc = ENOMEM;
+			break;
+		}
+
+		entry->threads = 1;
+		if (col_threads >= 0)
+			entry->threads = strtoul(fields[col_threads], NULL, 10);
+		entry->thruput = size / nanos;
+		list_append(&entry->link, &baseline);
+	}
+
+	fclose(f);
+
+	if (rc != EOK)
+		baseline_free();
+	return rc;
+}
+
+/** Free the loaded baseline. */
+void baseline_free(void)
+{
+	while (!list_empty(&baseline)) {
+		baseline_entry_t *entry = list_get_instance(
+		    list_first(&baseline), baseline_entry_t, link);
+
+		list_remove(&entry->link);
+		free(entry->name);
+		free(entry);
+	}
+}
+
+/** Whether a baseline has been loaded. */
+bool baseline_loaded(void)
+{
+	return !list_empty(&baseline);
+}
+
+/** Whether the baseline contains results of a benchmark. */
+bool baseline_contains(benchmark_t *bench)
+{
+	list_foreach(baseline, link, baseline_entry_t, entry) {
+		if (str_cmp(entry->name, bench->name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/** Set the allowed drop of the median throughput.
+ *
+ * @param percent Threshold in percent.
+ */
+void baseline_set_threshold(unsigned int percent)
+{
+	threshold = percent;
+}
+
+static int sample_cmp(const void *a, const void *b)
+{
+	const sample_t *sa = a;
+	const sample_t *sb = b;
+
+	if (sa->thruput < sb->thruput)
+		return -1;
+	if (sa->thruput > sb->thruput)
+		return 1;
+	return 0;
+}
+
+/** Get median throughput of either the baseline or the current samples.
+ *
+ * @param samples Samples sorted by throughput.
+ */
+static double median(sample_t *samples, size_t count, bool current,
+    size_t n)
+{
+	size_t seen = 0;
+	double lower = 0.0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (samples[i].current != current)
+			continue;
+
+		if (seen == (n - 1) / 2)
+			lower = samples[i].thruput;
+		if (seen == n / 2)
+			return (lower + samples[i].thruput) / 2.0;
+		seen++;
+	}
+
+	return lower;
+}
+
+/** Compare measured runs with the baseline.
+ *
+ * @param bench Benchmark.
+ * @param threads Number of threads the runs were executed on.
+ * @param runs Measured runs.
+ * @param run_count Number of measured runs.
+ * @param workload_size Workload size of each run.
+ * @return False if the benchmark regressed, true otherwise.
+ */
+bool baseline_compare(benchmark_t *bench, unsigned int threads,
+    bench_run_t *runs, size_t run_count, uint64_t workload_size)
+{
+	size_t m = 0;
+
+	list_foreach(baseline, link, baseline_entry_t, entry) {
+		if (str_cmp(entry->name, bench->name) == 0 &&
+		    entry->threads == threads)
+			m++;
+	}
+
+	if (m == 0) {
+		printf("Baseline: no results to compare with.\n");
+		return true;
+	}
+
+	size_t n = run_count;
+	size_t total = n + m;
+	sample_t *samples = calloc(total, sizeof(sample_t));
+	if (samples == NULL) {
+		printf("Baseline: out of memory.\n");
+		return true;
+	}
+
+	size_t count = 0;
+	for (size_t i = 0; i < n; i++) {
+		double nanos = stopwatch_get_nanos(&runs[i].stopwatch);
+		samples[count].thruput = nanos > 0 ?
+		    (double) workload_size / nanos : 0.0;
+		samples[count].current = true;
+		count++;
+	}
+
+	list_foreach(baseline, link, baseline_entry_t, entry) {
+		if (str_cmp(entry->name, bench->name) == 0 &&
+		    entry->threads == threads) {
+			samples[count].thruput = entry->thruput;
+			samples[count].current = false;
+			count++;
+		}
+	}
+
+	qsort(samples, total, sizeof(sample_t), sample_cmp);
+
+	/* Rank sum of the current samples, ties get their average rank */
+	double rank_sum = 0.0;
+	double ties = 0.0;
+	for (size_t i = 0; i < total; ) {
+		size_t j = i + 1;
+		while (j < total && samples[j].thruput == samples[i].thruput)
+			j++;
+
+		double rank = (i + 1 + j) / 2.0;
+		for (size_t k = i; k < j; k++) {
+			if (samples[k].current)
+				rank_sum += rank;
+		}
+
+		double t = j - i;
+		ties += t * t * t - t;
+		i = j;
+	}
+
+	double u = rank_sum - n * (n + 1) / 2.0;
+	double mean = n * m / 2.0;
+	double var = n * m / 12.0 * ((total + 1) - ties /
+	    ((double) total * (total - 1)));
+
+	/* A small U means the current throughput tends to be lower */
+	double z = 0.0;
+	if (var > 0)
+		z = (u - mean + 0.5) / estimate_square_root(var, 0.0001);
+
+	double base_median = median(samples, total, false, m);
+	double cur_median = median(samples, total, true, n);
+	double change = base_median > 0 ?
+	    (cur_median - base_median) / base_median * 100.0 : 0.0;
+
+	bool regressed = z < -Z_CRITICAL && -change > threshold;
+
+	printf("Baseline: median %.0f ops/s, now %.0f ops/s (%+.1f %%), "
+	    "z = %.2f: %s\n", base_median * 1000000000.0,
+	    cur_median * 1000000000.0, change, z,
+	    regressed ? "REGRESSION" : "ok");
+
+	free(samples);
+	return !regressed;
+}
+
+/** @}
+ */
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <async.h>
+#include <bd.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <loc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Raw reads of the block device given by the "device" parameter, which
+ * bypass VFS, the file system server and its block cache. Requests of
+ * "blocksize" bytes are submitted asynchronously, keeping up to "qdepth"
+ * of them in flight.
+ */
+
+typedef struct {
+	bd_req_t req;
+	char *buf;
+	stopwatch_t stopwatch;
+	bool busy;
+} bd_slot_t;
+
+static const char *device;
+static size_t blocksize;
+static unsigned int qdepth;
+
+static async_sess_t *sess;
+static bd_t *bd;
+/** Device blocks per request */
+static size_t count;
+/** Number of requests fitting the device */
+static uint64_t nreqs;
+
+static FIBRIL_MUTEX_INITIALIZE(slots_lock);
+static FIBRIL_CONDVAR_INITIALIZE(slots_cv);
+static bench_run_t *slots_run;
+static errno_t slots_rc;
+
+/** Get a random number covering more than RAND_MAX values. */
+static uint64_t random_index(uint64_t n)
+{
+	uint64_t r = (uint64_t) rand() * ((uint64_t) RAND_MAX + 1) + rand();
+	return r % n;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	bd_close(bd);
+	async_hangup(sess);
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	device = bench_env_param_get(env, "device", "bd/initrd");
+	const char *bs_str = bench_env_param_get(env, "blocksize", "4096");
+	blocksize = strtoul(bs_str, NULL, 10);
+	if (blocksize == 0)
+		return bench_run_fail(run, "invalid block size %s", bs_str);
+	const char *qd_str = bench_env_param_get(env, "qdepth", "1");
+	qdepth = strtoul(qd_str, NULL, 10);
+	if (qdepth == 0)
+		return bench_run_fail(run, "invalid queue depth %s", qd_str);
+
+	service_id_t sid;
+	errno_t rc = loc_service_get_id(device, &sid, 0);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to find %s: %s", device,
+		    str_error(rc));
+	}
+
+	sess = loc_service_connect(sid, INTERFACE_BLOCK, 0);
+	if (sess == NULL)
+		return bench_run_fail(run, "failed to connect to %s", device);
+
+	rc = bd_open(sess, &bd);
+	if (rc != EOK) {
+		async_hangup(sess);
+		return bench_run_fail(run, "failed to open %s: %s", device,
+		    str_error(rc));
+	}
+
+	size_t dev_bsize;
+	aoff64_t dev_nblocks;
+	rc = bd_get_block_size(bd, &dev_bsize);
+	if (rc == EOK)
+		rc = bd_get_num_blocks(bd, &dev_nblocks);
+	if (rc != EOK) {
+		bench_run_fail(run, "failed to get geometry of %s: %s",
+		    device, str_error(rc));
+		teardown(env, run);
+		return false;
+	}
+
+	if ((blocksize % dev_bsize) != 0) {
+		bench_run_fail(run, "block size %zu is not a multiple of "
+		    "%zu", blocksize, dev_bsize);
+		teardown(env, run);
+		return false;
+	}
+
+	count = blocksize / dev_bsize;
+	nreqs = dev_nblocks / count;
+	if (nreqs == 0) {
+		bench_run_fail(run, "device %s smaller than block size %zu",
+		    device, blocksize);
+		teardown(env, run);
+		return false;
+	}
+
+	return true;
+}
+
+static void read_done(void *arg, errno_t rc)
+{
+	bd_slot_t *slot = arg;
+
+	stopwatch_stop(&slot->stopwatch);
+
+	fibril_mutex_lock(&slots_lock);
+
+	if (rc == EOK) {
+		bench_run_latency_add(slots_run,
+		    stopwatch_get_nanos(&slot->stopwatch));
+	} else if (slots_rc == EOK) {
+		slots_rc = rc;
+	}
+
+	slot->busy = false;
+	fibril_condvar_broadcast(&slots_cv);
+	fibril_mutex_unlock(&slots_lock);
+}
+
+static bool read_runner(bench_run_t *run, uint64_t size, bool random)
+{
+	bd_slot_t *slots = calloc(qdepth, sizeof(bd_slot_t));
+	if (slots == NULL)
+		return bench_run_fail(run, "failed to allocate requests");
+
+	bool ret = true;
+	unsigned int allocated;
+
+	for (allocated = 0; allocated < qdepth; allocated++) {
+		slots[allocated].buf = malloc(blocksize);
+		if (slots[allocated].buf == NULL) {
+			bench_run_fail(run, "failed to allocate buffers");
+			ret = false;
+			goto leave;
+		}
+	}
+
+	slots_run = run;
+	slots_rc = EOK;
+
+	bench_run_start(run);
+
+	for (uint64_t i = 0; i < size; i++) {
+		bd_slot_t *slot = &slots[i % qdepth];
+
+		fibril_mutex_lock(&slots_lock);
+		while (slot->busy)
+			fibril_condvar_wait(&slots_cv, &slots_lock);
+		errno_t rc = slots_rc;
+		slot->busy = (rc == EOK);
+		fibril_mutex_unlock(&slots_lock);
+
+		if (rc != EOK)
+			break;
+
+		uint64_t index = random ? random_index(nreqs) : i % nreqs;
+
+		stopwatch_init(&slot->stopwatch);
+		stopwatch_start(&slot->stopwatch);
+
+		rc = bd_read_blocks_async(bd, &slot->req, index * count, count,
+		    slot->buf, blocksize, read_done, slot);
+		if (rc != EOK) {
+			fibril_mutex_lock(&slots_lock);
+			slot->busy = false;
+			if (slots_rc == EOK)
+				slots_rc = rc;
+			fibril_mutex_unlock(&slots_lock);
+			break;
+		}
+	}
+
+	bd_wait_idle(bd);
+
+	bench_run_stop(run);
+
+	if (slots_rc != EOK) {
+		bench_run_fail(run, "failed to read from %s: %s", device,
+		    str_error(slots_rc));
+		ret = false;
+	}
+
+leave:
+	for (unsigned int i = 0; i < allocated; i++)
+		free(slots[i].buf);
+
+	free(slots);
+	return ret;
+}
+
+static bool seq_read_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return read_runner(run, size, false);
+}
+
+static bool rand_read_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return read_runner(run, size, true);
+}
+
+benchmark_t benchmark_bd_seq_read = {
+	.name = "bd_seq_read",
+	.desc = "Read a block device sequentially, bypassing VFS (use 'device', 'blocksize' and 'qdepth' params to alter the defaults).",
+	.entry = &seq_read_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_bd_rand_read = {
+	.name = "bd_rand_read",
+	.desc = "Read random blocks of a block device, bypassing VFS (use 'device', 'blocksize' and 'qdepth' params to alter the defaults).",
+	.entry = &rand_read_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -38,13 +38,42 @@
 #include "hbench.h"
 
 benchmark_t *benchmarks[] = {
+	&benchmark_bd_rand_read,
+	&benchmark_bd_seq_read,
+	&benchmark_conn_rate,
+	&benchmark_crc32,
+	&benchmark_crc32c,
+	&benchmark_dir_create,
+	&benchmark_dir_lookup,
 	&benchmark_dir_read,
 	&benchmark_fibril_mutex,
+	&benchmark_file_create,
+	&benchmark_file_fsync,
+	&benchmark_file_rand_read,
+	&benchmark_file_rand_write,
 	&benchmark_file_read,
+	&benchmark_file_seq_read,
+	&benchmark_file_seq_write,
+	&benchmark_file_stat,
+	&benchmark_file_unlink,
+	&benchmark_ipc_clients,
+	&benchmark_ipc_data_read,
+	&benchmark_ipc_data_write,
+	&benchmark_ipc_forward,
+	&benchmark_ipc_notify,
+	&benchmark_ipc_share_in,
+	&benchmark_ipc_share_out,
 	&benchmark_malloc1,
 	&benchmark_malloc2,
+	&benchmark_memcmp,
+	&benchmark_memcpy,
+	&benchmark_memset,
 	&benchmark_ns_ping,
-	&benchmark_ping_pong
+	&benchmark_ping_pong,
+	&benchmark_ring,
+	&benchmark_tcp_rr,
+	&benchmark_tcp_stream,
+	&benchmark_udp_pps
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
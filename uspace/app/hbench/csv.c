@@ -39,6 +39,9 @@
 
 static FILE *csv_output = NULL;
 
+/** Reported latency percentiles in tenths of a percent */
+static const unsigned int percentiles[] = { 500, 900, 990, 999 };
+
 /** Open CSV benchmark report.
  *
  * @param filename Filename where to store the CSV.
@@ -51,7 +54,8 @@ errno_t csv_report_open(const char *filename)
 		return errno;
 	}
 
-	fprintf(csv_output, "benchmark,run,size,duration_nanos\n");
+	fprintf(csv_output, "benchmark,threads,run,size,duration_nanos,"
+	    "p50_nanos,p90_nanos,p99_nanos,p999_nanos\n");
 
 	return EOK;
 }
@@ -59,23 +63,36 @@ errno_t csv_report_open(const char *filename)
 /** Add one entry to the report.
  *
  * When csv_report_open() was not called or failed, the function does
- * nothing.
+ * nothing. Latency percentiles are left empty when the benchmark does
+ * not record latencies of individual operations.
  *
  * @param run Performance data of the entry.
  * @param run_index Run index, use negative values for warm-up.
  * @param bench Benchmark information.
- * @param workload_size Workload size.
+ * @param threads Number of threads the run was executed on.
+ * @param workload_size Workload size of all the threads together.
  */
 void csv_report_add_entry(bench_run_t *run, int run_index,
-    benchmark_t *bench, uint64_t workload_size)
+    benchmark_t *bench, unsigned int threads, uint64_t workload_size)
 {
 	if (csv_output == NULL) {
 		return;
 	}
 
-	fprintf(csv_output, "%s,%d,%" PRIu64 ",%lld\n",
-	    bench->name, run_index, workload_size,
+	fprintf(csv_output, "%s,%u,%d,%" PRIu64 ",%lld",
+	    bench->name, threads, run_index, workload_size,
 	    (long long) stopwatch_get_nanos(&run->stopwatch));
+
+	for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]);
+	    i++) {
+		nsec_t nanos;
+		if (bench_run_latency_get(run, percentiles[i], &nanos))
+			fprintf(csv_output, ",%lld", (long long) nanos);
+		else
+			fprintf(csv_output, ",");
+	}
+
+	fprintf(csv_output, "\n");
 }
 
 /** Close CSV report.
@@ -16,7 +16,9 @@
  * benchmark) and fill-in the benchmark_t structure.
  *
  * Fill-in the name of the benchmark, its description and a reference to the
- * benchmark function to the benchmark_t.
+ * benchmark function to the benchmark_t. Set its parallel member when the
+ * benchmark function can run on several threads at once, so that the
+ * 'threads' parameter can be used to measure how the benchmark scales.
  *
  * The benchmarking function has to accept trhee arguments:
  *  @li bench_env_t: benchmark environment configuration
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Lookup and creation of entries in a large directory. The directory
+ * given by the "dirname" parameter is populated by "entries" empty files
+ * during setup and removed again during teardown. Point "dirname" to
+ * a mounted file system to benchmark its directory implementation.
+ */
+
+#define NAME_SIZE  64
+
+/** Step through the populated entries in a non-sequential order */
+#define LOOKUP_STRIDE  7919
+
+static const char *dirname;
+static uint64_t entries;
+
+static void entry_path(char *buf, const char *prefix, uint64_t index)
+{
+	snprintf(buf, NAME_SIZE, "%s/%s%08" PRIu64, dirname, prefix, index);
+}
+
+static errno_t entry_create(const char *prefix, uint64_t index)
+{
+	char path[NAME_SIZE];
+	int fd;
+
+	entry_path(path, prefix, index);
+	errno_t rc = vfs_lookup_open(path, WALK_REGULAR | WALK_MUST_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK)
+		return rc;
+
+	return vfs_put(fd);
+}
+
+static void entries_remove(const char *prefix, uint64_t count)
+{
+	char path[NAME_SIZE];
+
+	for (uint64_t i = 0; i < count; i++) {
+		entry_path(path, prefix, i);
+		(void) vfs_unlink_path(path);
+	}
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	entries_remove("f", entries);
+
+	errno_t rc = vfs_unlink_path(dirname);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to remove %s: %s",
+		    dirname, str_error(rc));
+	}
+
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	dirname = bench_env_param_get(env, "dirname", "/tmp/hbench_dir");
+	const char *entries_str = bench_env_param_get(env, "entries", "100000");
+	entries = strtoul(entries_str, NULL, 10);
+	if (entries == 0)
+		return bench_run_fail(run, "invalid entry count %s", entries_str);
+
+	if (str_size(dirname) + 16 > NAME_SIZE)
+		return bench_run_fail(run, "directory name %s too long", dirname);
+
+	errno_t rc = vfs_link_path(dirname, KIND_DIRECTORY, NULL);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to create %s: %s",
+		    dirname, str_error(rc));
+	}
+
+	for (uint64_t i = 0; i < entries; i++) {
+		rc = entry_create("f", i);
+		if (rc != EOK) {
+			bench_run_fail(run, "failed to populate %s: %s",
+			    dirname, str_error(rc));
+			entries = i;
+			teardown(env, run);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** Look up random entries of a large directory. */
+static bool lookup_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	char path[NAME_SIZE];
+	stopwatch_t stopwatch;
+	vfs_stat_t st;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		entry_path(path, "f", (i * LOOKUP_STRIDE) % entries);
+
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		errno_t rc = vfs_stat_path(path, &st);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed to look up %s: %s",
+			    path, str_error(rc));
+		}
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+/** Create new entries in a large directory. */
+static bool create_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	stopwatch_t stopwatch;
+	bool ret = true;
+	uint64_t created;
+
+	bench_run_start(run);
+	for (created = 0; created < size; created++) {
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		errno_t rc = entry_create("n", created);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK) {
+			bench_run_fail(run, "failed to create entry in %s: %s",
+			    dirname, str_error(rc));
+			ret = false;
+			break;
+		}
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+	bench_run_stop(run);
+
+	/* Restore the directory for the next run */
+	entries_remove("n", created);
+
+	return ret;
+}
+
+benchmark_t benchmark_dir_lookup = {
+	.name = "dir_lookup",
+	.desc = "Look up entries of a large directory (use 'dirname' and 'entries' params to alter the defaults).",
+	.entry = &lookup_runner,
+	.setup = &setup,
+	.teardown = &teardown,
+	.parallel = true
+};
+
+benchmark_t benchmark_dir_create = {
+	.name = "dir_create",
+	.desc = "Create entries in a large directory (use 'dirname' and 'entries' params to alter the defaults).",
+	.entry = &create_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
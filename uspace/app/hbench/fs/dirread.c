@@ -72,7 +72,8 @@ benchmark_t benchmark_dir_read = {
 	.desc = "Read contents of a directory (use 'dirname' param to alter the default).",
 	.entry = &runner,
 	.setup = NULL,
-	.teardown = NULL
+	.teardown = NULL,
+	.parallel = true
 };
 
 /**
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Reads and writes of a file in blocks of "blocksize" bytes. The file
+ * given by the "filename" parameter is created with "filesize" bytes
+ * during setup and removed during teardown. Up to "qdepth" requests are
+ * kept in flight, each by its own fibril using its own file descriptor,
+ * as VFS serves the requests of one descriptor one at a time.
+ */
+
+#define FILL_CHUNK_SIZE  65536
+
+typedef enum {
+	FILE_OP_READ,
+	FILE_OP_WRITE,
+	FILE_OP_FSYNC
+} file_op_t;
+
+typedef struct file_job file_job_t;
+
+typedef struct {
+	file_job_t *job;
+	int fd;
+	char *buf;
+} file_worker_t;
+
+struct file_job {
+	bench_run_t *run;
+	file_op_t op;
+	bool random;
+	/** Number of requests to issue */
+	uint64_t size;
+	/** Index of the next request */
+	uint64_t next;
+	/** Number of workers still running */
+	unsigned int active;
+	/** First error, if any */
+	errno_t rc;
+	fibril_mutex_t lock;
+	fibril_condvar_t done_cv;
+};
+
+static const char *filename;
+static uint64_t filesize;
+static size_t blocksize;
+static unsigned int qdepth;
+static uint64_t nblocks;
+
+/** Get a random number covering more than RAND_MAX values. */
+static uint64_t random_index(uint64_t count)
+{
+	uint64_t r = (uint64_t) rand() * ((uint64_t) RAND_MAX + 1) + rand();
+	return r % count;
+}
+
+static bool parse_size(bench_env_t *env, bench_run_t *run, const char *name,
+    const char *def, uint64_t *value)
+{
+	const char *str = bench_env_param_get(env, name, def);
+	*value = strtoull(str, NULL, 10);
+	if (*value == 0)
+		return bench_run_fail(run, "invalid %s %s", name, str);
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	errno_t rc = vfs_unlink_path(filename);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to remove %s: %s",
+		    filename, str_error(rc));
+	}
+
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	uint64_t value;
+
+	filename = bench_env_param_get(env, "filename", "/tmp/hbench_file");
+
+	if (!parse_size(env, run, "filesize", "8388608", &filesize))
+		return false;
+	if (!parse_size(env, run, "blocksize", "4096", &value))
+		return false;
+	blocksize = value;
+	if (!parse_size(env, run, "qdepth", "1", &value))
+		return false;
+	qdepth = value;
+
+	nblocks = filesize / blocksize;
+	if (nblocks == 0) {
+		return bench_run_fail(run, "file size %" PRIu64 " smaller than "
+		    "block size %zu", filesize, blocksize);
+	}
+
+	char *buf = malloc(FILL_CHUNK_SIZE);
+	if (buf == NULL)
+		return bench_run_fail(run, "failed to allocate buffer");
+	memset(buf, 0x5a, FILL_CHUNK_SIZE);
+
+	int fd;
+	errno_t rc = vfs_lookup_open(filename, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK) {
+		free(buf);
+		return bench_run_fail(run, "failed to create %s: %s",
+		    filename, str_error(rc));
+	}
+
+	aoff64_t pos = 0;
+	while ((rc == EOK) && (pos < filesize)) {
+		size_t nwr;
+		size_t chunk = min(FILL_CHUNK_SIZE, filesize - pos);
+		rc = vfs_write(fd, &pos, buf, chunk, &nwr);
+	}
+
+	if (rc == EOK)
+		rc = vfs_sync(fd);
+
+	vfs_put(fd);
+	free(buf);
+
+	if (rc != EOK) {
+		bench_run_fail(run, "failed to fill %s: %s", filename,
+		    str_error(rc));
+		teardown(env, run);
+		return false;
+	}
+
+	return true;
+}
+
+/** Issue requests until the job is done. */
+static errno_t file_worker(void *arg)
+{
+	file_worker_t *worker = arg;
+	file_job_t *job = worker->job;
+	stopwatch_t stopwatch;
+
+	fibril_mutex_lock(&job->lock);
+
+	while ((job->next < job->size) && (job->rc == EOK)) {
+		uint64_t index = job->next++;
+		fibril_mutex_unlock(&job->lock);
+
+		uint64_t block = job->random ? random_index(nblocks) :
+		    index % nblocks;
+		aoff64_t pos = block * blocksize;
+		ssize_t nbytes;
+		errno_t rc;
+
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+
+		if (job->op == FILE_OP_READ) {
+			rc = vfs_read_short(worker->fd, pos, worker->buf,
+			    blocksize, &nbytes);
+		} else {
+			rc = vfs_write_short(worker->fd, pos, worker->buf,
+			    blocksize, &nbytes);
+			if ((rc == EOK) && (job->op == FILE_OP_FSYNC))
+				rc = vfs_sync(worker->fd);
+		}
+
+		stopwatch_stop(&stopwatch);
+
+		fibril_mutex_lock(&job->lock);
+
+		if ((rc == EOK) && ((size_t) nbytes != blocksize))
+			rc = EIO;
+
+		if (rc != EOK) {
+			if (job->rc == EOK)
+				job->rc = rc;
+			break;
+		}
+
+		bench_run_latency_add(job->run,
+		    stopwatch_get_nanos(&stopwatch));
+	}
+
+	job->active--;
+	fibril_condvar_broadcast(&job->done_cv);
+	fibril_mutex_unlock(&job->lock);
+
+	return EOK;
+}
+
+static bool file_runner(bench_run_t *run, uint64_t size, file_op_t op,
+    bool random)
+{
+	file_job_t job = {
+		.run = run,
+		.op = op,
+		.random = random,
+		.size = size,
+		.next = 0,
+		.active = 0,
+		.rc = EOK
+	};
+	fibril_mutex_initialize(&job.lock);
+	fibril_condvar_initialize(&job.done_cv);
+
+	file_worker_t *workers = calloc(qdepth, sizeof(file_worker_t));
+	if (workers == NULL)
+		return bench_run_fail(run, "failed to allocate workers");
+
+	bool ret = true;
+	unsigned int opened;
+	errno_t rc = EOK;
+
+	for (opened = 0; opened < qdepth; opened++) {
+		workers[opened].job = &job;
+		workers[opened].buf = malloc(blocksize);
+		if (workers[opened].buf == NULL) {
+			rc = ENOMEM;
+			break;
+		}
+
+		memset(workers[opened].buf, 0xa5, blocksize);
+
+		rc = vfs_lookup_open(filename, WALK_REGULAR, MODE_READ |
+		    MODE_WRITE, &workers[opened].fd);
+		if (rc != EOK) {
+			free(workers[opened].buf);
+			break;
+		}
+	}
+
+	if (rc != EOK) {
+		bench_run_fail(run, "failed to open %s: %s", filename,
+		    str_error(rc));
+		ret = false;
+		goto leave;
+	}
+
+	bench_run_start(run);
+
+	job.active = qdepth;
+	for (unsigned int i = 1; i < qdepth; i++) {
+		fid_t fid = fibril_create(file_worker, &workers[i]);
+		if (fid == 0) {
+			job.active--;
+			continue;
+		}
+
+		fibril_add_ready(fid);
+	}
+
+	file_worker(&workers[0]);
+
+	fibril_mutex_lock(&job.lock);
+	while (job.active > 0)
+		fibril_condvar_wait(&job.done_cv, &job.lock);
+	fibril_mutex_unlock(&job.lock);
+
+	bench_run_stop(run);
+
+	if (job.rc != EOK) {
+		bench_run_fail(run, "failed to access %s: %s", filename,
+		    str_error(job.rc));
+		ret = false;
+	}
+
+leave:
+	for (unsigned int i = 0; i < opened; i++) {
+		vfs_put(workers[i].fd);
+		free(workers[i].buf);
+	}
+
+	free(workers);
+	return ret;
+}
+
+static bool seq_read_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return file_runner(run, size, FILE_OP_READ, false);
+}
+
+static bool rand_read_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return file_runner(run, size, FILE_OP_READ, true);
+}
+
+static bool seq_write_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return file_runner(run, size, FILE_OP_WRITE, false);
+}
+
+static bool rand_write_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t size)
+{
+	return file_runner(run, size, FILE_OP_WRITE, true);
+}
+
+static bool fsync_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return file_runner(run, size, FILE_OP_FSYNC, true);
+}
+
+benchmark_t benchmark_file_seq_read = {
+	.name = "file_seq_read",
+	.desc = "Read a file sequentially in blocks (use 'filename', 'filesize', 'blocksize' and 'qdepth' params to alter the defaults).",
+	.entry = &seq_read_runner,
+	.setup = &setup,
+	.teardown = &teardown,
+	.parallel = true
+};
+
+benchmark_t benchmark_file_rand_read = {
+	.name = "file_rand_read",
+	.desc = "Read random blocks of a file (use 'filename', 'filesize', 'blocksize' and 'qdepth' params to alter the defaults).",
+	.entry = &rand_read_runner,
+	.setup = &setup,
+	.teardown = &teardown,
+	.parallel = true
+};
+
+benchmark_t benchmark_file_seq_write = {
+	.name = "file_seq_write",
+	.desc = "Overwrite a file sequentially in blocks (use 'filename', 'filesize', 'blocksize' and 'qdepth' params to alter the defaults).",
+	.entry = &seq_write_runner,
+	.setup = &setup,
+	.teardown = &teardown,
+	.parallel = true
+};
+
+benchmark_t benchmark_file_rand_write = {
+	.name = "file_rand_write",
+	.desc = "Overwrite random blocks of a file (use 'filename', 'filesize', 'blocksize' and 'qdepth' params to alter the defaults).",
+	.entry = &rand_write_runner,
+	.setup = &setup,
+	.teardown = &teardown,
+	.parallel = true
+};
+
+benchmark_t benchmark_file_fsync = {
+	.name = "file_fsync",
+	.desc = "Overwrite a random block of a file and sync it (use 'filename', 'filesize', 'blocksize' and 'qdepth' params to alter the defaults).",
+	.entry = &fsync_runner,
+	.setup = &setup,
+	.teardown = &teardown,
+	.parallel = true
+};
+
+/**
+ * @}
+ */
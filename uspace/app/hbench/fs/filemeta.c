@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <vfs/vfs.h>
+#include "../hbench.h"
+
+/*
+ * Rates of file creation, stat and removal. The files live in the
+ * directory given by the "dirname" parameter, which is created during
+ * setup together with "files" files to be examined by the stat benchmark.
+ * The latency of each operation is recorded.
+ */
+
+#define NAME_SIZE  64
+
+static const char *dirname;
+static uint64_t files;
+
+static void entry_path(char *buf, const char *prefix, uint64_t index)
+{
+	snprintf(buf, NAME_SIZE, "%s/%s%08" PRIu64, dirname, prefix, index);
+}
+
+static errno_t entry_create(const char *prefix, uint64_t index)
+{
+	char path[NAME_SIZE];
+	int fd;
+
+	entry_path(path, prefix, index);
+	errno_t rc = vfs_lookup_open(path, WALK_REGULAR | WALK_MUST_CREATE,
+	    MODE_WRITE, &fd);
+	if (rc != EOK)
+		return rc;
+
+	return vfs_put(fd);
+}
+
+static void entries_remove(const char *prefix, uint64_t count)
+{
+	char path[NAME_SIZE];
+
+	for (uint64_t i = 0; i < count; i++) {
+		entry_path(path, prefix, i);
+		(void) vfs_unlink_path(path);
+	}
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	entries_remove("s", files);
+
+	errno_t rc = vfs_unlink_path(dirname);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to remove %s: %s",
+		    dirname, str_error(rc));
+	}
+
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	dirname = bench_env_param_get(env, "dirname", "/tmp/hbench_meta");
+	const char *files_str = bench_env_param_get(env, "files", "1000");
+	files = strtoul(files_str, NULL, 10);
+	if (files == 0)
+		return bench_run_fail(run, "invalid file count %s", files_str);
+
+	if (str_size(dirname) + 16 > NAME_SIZE)
+		return bench_run_fail(run, "directory name %s too long", dirname);
+
+	errno_t rc = vfs_link_path(dirname, KIND_DIRECTORY, NULL);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed to create %s: %s",
+		    dirname, str_error(rc));
+	}
+
+	for (uint64_t i = 0; i < files; i++) {
+		rc = entry_create("s", i);
+		if (rc != EOK) {
+			bench_run_fail(run, "failed to populate %s: %s",
+			    dirname, str_error(rc));
+			files = i;
+			teardown(env, run);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** Create new files. */
+static bool create_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	stopwatch_t stopwatch;
+	bool ret = true;
+	uint64_t created;
+
+	bench_run_start(run);
+	for (created = 0; created < size; created++) {
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		errno_t rc = entry_create("c", created);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK) {
+			bench_run_fail(run, "failed to create file in %s: %s",
+			    dirname, str_error(rc));
+			ret = false;
+			break;
+		}
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+	bench_run_stop(run);
+
+	entries_remove("c", created);
+	return ret;
+}
+
+/** Get information about existing files. */
+static bool stat_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	char path[NAME_SIZE];
+	stopwatch_t stopwatch;
+	vfs_stat_t st;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		entry_path(path, "s", i % files);
+
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		errno_t rc = vfs_stat_path(path, &st);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed to stat %s: %s",
+			    path, str_error(rc));
+		}
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+/** Remove files created beforehand. */
+static bool unlink_runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	char path[NAME_SIZE];
+	stopwatch_t stopwatch;
+
+	for (uint64_t i = 0; i < size; i++) {
+		errno_t rc = entry_create("u", i);
+		if (rc != EOK) {
+			entries_remove("u", i);
+			return bench_run_fail(run, "failed to create file "
+			    "in %s: %s", dirname, str_error(rc));
+		}
+	}
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		entry_path(path, "u", i);
+
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		errno_t rc = vfs_unlink_path(path);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK) {
+			entries_remove("u", size);
+			return bench_run_fail(run, "failed to remove %s: %s",
+			    path, str_error(rc));
+		}
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_file_create = {
+	.name = "file_create",
+	.desc = "Create empty files (use 'dirname' param to alter the default).",
+	.entry = &create_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_file_stat = {
+	.name = "file_stat",
+	.desc = "Stat existing files (use 'dirname' and 'files' params to alter the defaults).",
+	.entry = &stat_runner,
+	.setup = &setup,
+	.teardown = &teardown,
+	.parallel = true
+};
+
+benchmark_t benchmark_file_unlink = {
+	.name = "file_unlink",
+	.desc = "Remove empty files (use 'dirname' param to alter the default).",
+	.entry = &unlink_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/**
+ * @}
+ */
@@ -98,7 +98,8 @@ benchmark_t benchmark_file_read = {
 	.desc = "Sequentially read contents of a file (use 'filename' param to alter the default).",
 	.entry = &runner,
 	.setup = NULL,
-	.teardown = NULL
+	.teardown = NULL,
+	.parallel = true
 };
 
 /**
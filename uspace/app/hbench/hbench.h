@@ -39,11 +39,26 @@
 #include <adt/hash_table.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <perf.h>
 
 #define DEFAULT_RUN_COUNT 10
 #define DEFAULT_MIN_RUN_DURATION_SEC 10
 
+/** Number of measured runs when comparing with a baseline */
+#define BASELINE_RUN_COUNT 20
+/** Allowed drop of median throughput against a baseline in percent */
+#define BASELINE_DEFAULT_THRESHOLD 5
+
+/*
+ * Latencies of individual operations are kept in a histogram with
+ * BENCH_LATENCY_SUB_COUNT buckets per power of two, so that a percentile
+ * is reported with a relative error below 1 / BENCH_LATENCY_SUB_COUNT.
+ */
+#define BENCH_LATENCY_SUB_BITS 3
+#define BENCH_LATENCY_SUB_COUNT (1 << BENCH_LATENCY_SUB_BITS)
+#define BENCH_LATENCY_BUCKETS (64 * BENCH_LATENCY_SUB_COUNT)
+
 /** Single run information.
  *
  * Used to store both performance information (now, only wall-clock
@@ -58,6 +73,9 @@ typedef struct {
 	stopwatch_t stopwatch;
 	char *error_message;
 	size_t error_message_buffer_size;
+	/** Number of operation latencies recorded by the runner. */
+	uint64_t latency_count;
+	uint32_t latency_hist[BENCH_LATENCY_BUCKETS];
 } bench_run_t;
 
 /** Benchmark environment configuration.
@@ -95,10 +113,16 @@ typedef struct {
 	benchmark_entry_t entry;
 	benchmark_helper_t setup;
 	benchmark_helper_t teardown;
+	/** The entry may run on several threads at once (see 'threads'). */
+	bool parallel;
 } benchmark_t;
 
 extern void bench_run_init(bench_run_t *, char *, size_t);
 extern bool bench_run_fail(bench_run_t *, const char *, ...);
+extern void bench_run_latency_add(bench_run_t *, nsec_t);
+extern bool bench_run_latency_get(bench_run_t *, unsigned int, nsec_t *);
+extern void bench_run_merge(bench_run_t *, bench_run_t *);
+extern double estimate_square_root(double, double);
 
 /*
  * We keep the following two functions inline to ensure that we start
@@ -119,9 +143,18 @@ static inline void bench_run_stop(bench_run_t *run)
 }
 
 extern errno_t csv_report_open(const char *);
-extern void csv_report_add_entry(bench_run_t *, int, benchmark_t *, uint64_t);
+extern void csv_report_add_entry(bench_run_t *, int, benchmark_t *,
+    unsigned int, uint64_t);
 extern void csv_report_close(void);
 
+extern errno_t baseline_load(const char *);
+extern void baseline_free(void);
+extern bool baseline_loaded(void);
+extern bool baseline_contains(benchmark_t *);
+extern void baseline_set_threshold(unsigned int);
+extern bool baseline_compare(benchmark_t *, unsigned int, bench_run_t *,
+    size_t, uint64_t);
+
 extern errno_t bench_env_init(bench_env_t *);
 extern errno_t bench_env_param_set(bench_env_t *, const char *, const char *);
 extern const char *bench_env_param_get(bench_env_t *, const char *, const char *);
@@ -131,13 +164,42 @@ extern benchmark_t *benchmarks[];
 extern size_t benchmark_count;
 
 /* Put your benchmark descriptors here (and also to benchlist.c). */
+extern benchmark_t benchmark_bd_rand_read;
+extern benchmark_t benchmark_bd_seq_read;
+extern benchmark_t benchmark_conn_rate;
+extern benchmark_t benchmark_crc32;
+extern benchmark_t benchmark_crc32c;
+extern benchmark_t benchmark_dir_create;
+extern benchmark_t benchmark_dir_lookup;
 extern benchmark_t benchmark_dir_read;
 extern benchmark_t benchmark_fibril_mutex;
+extern benchmark_t benchmark_file_create;
+extern benchmark_t benchmark_file_fsync;
+extern benchmark_t benchmark_file_rand_read;
+extern benchmark_t benchmark_file_rand_write;
 extern benchmark_t benchmark_file_read;
+extern benchmark_t benchmark_file_seq_read;
+extern benchmark_t benchmark_file_seq_write;
+extern benchmark_t benchmark_file_stat;
+extern benchmark_t benchmark_file_unlink;
+extern benchmark_t benchmark_ipc_clients;
+extern benchmark_t benchmark_ipc_data_read;
+extern benchmark_t benchmark_ipc_data_write;
+extern benchmark_t benchmark_ipc_forward;
+extern benchmark_t benchmark_ipc_notify;
+extern benchmark_t benchmark_ipc_share_in;
+extern benchmark_t benchmark_ipc_share_out;
 extern benchmark_t benchmark_malloc1;
 extern benchmark_t benchmark_malloc2;
+extern benchmark_t benchmark_memcmp;
+extern benchmark_t benchmark_memcpy;
+extern benchmark_t benchmark_memset;
 extern benchmark_t benchmark_ns_ping;
 extern benchmark_t benchmark_ping_pong;
+extern benchmark_t benchmark_ring;
+extern benchmark_t benchmark_tcp_rr;
+extern benchmark_t benchmark_tcp_stream;
+extern benchmark_t benchmark_udp_pps;
 
 #endif
 
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <ipc_test.h>
+#include <ipc/ipc_test.h>
+#include <macros.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Benchmarks of call patterns used by servers: forwarded calls,
+ * notifications through a callback port and many clients talking to one
+ * server at once.
+ */
+
+/** Maximum value of the "clients" parameter */
+#define CLIENTS_MAX  256
+
+static ipc_test_t *test = NULL;
+
+static ipc_test_t **clients = NULL;
+static unsigned int nclients;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	errno_t rc = ipc_test_create(&test);
+	if (rc != EOK) {
+		return bench_run_fail(run,
+		    "failed contacting IPC test server (have you run /srv/test/ipc-test?): %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	ipc_test_destroy(test);
+	return true;
+}
+
+static bool notify_setup(bench_env_t *env, bench_run_t *run)
+{
+	if (!setup(env, run))
+		return false;
+
+	errno_t rc = ipc_test_callback_create(test);
+	if (rc != EOK) {
+		ipc_test_destroy(test);
+		return bench_run_fail(run, "failed creating callback port: "
+		    "%s (%d)", str_error(rc), rc);
+	}
+
+	return true;
+}
+
+static bool clients_teardown(bench_env_t *env, bench_run_t *run)
+{
+	for (unsigned int i = 0; i < nclients; i++)
+		ipc_test_destroy(clients[i]);
+
+	free(clients);
+	clients = NULL;
+	return true;
+}
+
+static bool clients_setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *str = bench_env_param_get(env, "clients", "16");
+	unsigned long count = strtoul(str, NULL, 10);
+	if ((count == 0) || (count > CLIENTS_MAX)) {
+		return bench_run_fail(run, "invalid number of clients %s "
+		    "(must be between 1 and %d)", str, CLIENTS_MAX);
+	}
+
+	clients = calloc(count, sizeof(ipc_test_t *));
+	if (clients == NULL)
+		return bench_run_fail(run, "failed allocating clients");
+
+	/* Each client has a connection of its own */
+	for (nclients = 0; nclients < count; nclients++) {
+		errno_t rc = ipc_test_create(&clients[nclients]);
+		if (rc != EOK) {
+			clients_teardown(env, run);
+			return bench_run_fail(run,
+			    "failed contacting IPC test server (have you run /srv/test/ipc-test?): %s (%d)",
+			    str_error(rc), rc);
+		}
+	}
+
+	return true;
+}
+
+static bool forward_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t niter)
+{
+	stopwatch_t stopwatch;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		errno_t rc = ipc_test_forward_ping(test);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending forwarded "
+			    "ping: %s (%d)", str_error(rc), rc);
+		}
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+/** Receive notifications, requested in batches given by "batch". */
+static bool notify_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t niter)
+{
+	const char *str = bench_env_param_get(env, "batch", "64");
+	unsigned long batch = strtoul(str, NULL, 10);
+	if ((batch == 0) || (batch > IPC_TEST_NOTIFY_MAX)) {
+		return bench_run_fail(run, "invalid batch %s (must be between "
+		    "1 and %d)", str, IPC_TEST_NOTIFY_MAX);
+	}
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count += batch) {
+		errno_t rc = ipc_test_notify(test, min(batch, niter - count));
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed requesting "
+			    "notifications: %s (%d)", str_error(rc), rc);
+		}
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+typedef struct {
+	bench_run_t *run;
+	fibril_mutex_t lock;
+	fibril_condvar_t done_cv;
+	unsigned int active;
+	errno_t rc;
+} clients_job_t;
+
+typedef struct {
+	clients_job_t *job;
+	ipc_test_t *test;
+	uint64_t niter;
+} client_t;
+
+static errno_t client_fibril(void *arg)
+{
+	client_t *client = arg;
+	clients_job_t *job = client->job;
+	stopwatch_t stopwatch;
+	errno_t rc = EOK;
+
+	fibril_detach(fibril_get_id());
+
+	for (uint64_t count = 0; count < client->niter; count++) {
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		rc = ipc_test_ping(client->test);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK)
+			break;
+
+		fibril_mutex_lock(&job->lock);
+		bench_run_latency_add(job->run,
+		    stopwatch_get_nanos(&stopwatch));
+		fibril_mutex_unlock(&job->lock);
+	}
+
+	fibril_mutex_lock(&job->lock);
+	if (rc != EOK)
+		job->rc = rc;
+	job->active--;
+	fibril_condvar_signal(&job->done_cv);
+	fibril_mutex_unlock(&job->lock);
+
+	return EOK;
+}
+
+/** Ping the server from all the clients at once. */
+static bool clients_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t niter)
+{
+	clients_job_t job = {
+		.run = run,
+		.active = 0,
+		.rc = EOK
+	};
+	fibril_mutex_initialize(&job.lock);
+	fibril_condvar_initialize(&job.done_cv);
+
+	client_t *cl = calloc(nclients, sizeof(client_t));
+	if (cl == NULL)
+		return bench_run_fail(run, "failed allocating clients");
+
+	bench_run_start(run);
+
+	/* The workload is split among the clients */
+	for (unsigned int i = 0; i < nclients; i++) {
+		cl[i].job = &job;
+		cl[i].test = clients[i];
+		cl[i].niter = niter / nclients + (i < niter % nclients ? 1 : 0);
+
+		fid_t fid = fibril_create(client_fibril, &cl[i]);
+		if (fid == 0) {
+			fibril_mutex_lock(&job.lock);
+			job.rc = ENOMEM;
+			fibril_mutex_unlock(&job.lock);
+			break;
+		}
+
+		fibril_mutex_lock(&job.lock);
+		job.active++;
+		fibril_mutex_unlock(&job.lock);
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&job.lock);
+	while (job.active > 0)
+		fibril_condvar_wait(&job.done_cv, &job.lock);
+	fibril_mutex_unlock(&job.lock);
+
+	bench_run_stop(run);
+
+	free(cl);
+
+	if (job.rc != EOK) {
+		return bench_run_fail(run, "failed sending ping message: "
+		    "%s (%d)", str_error(job.rc), job.rc);
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_ipc_forward = {
+	.name = "ipc_forward",
+	.desc = "IPC ping-pong benchmark with the call forwarded by the server",
+	.entry = &forward_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_ipc_notify = {
+	.name = "ipc_notify",
+	.desc = "Notifications through a callback port (use 'batch' param to alter the default of 64 per request)",
+	.entry = &notify_runner,
+	.setup = &notify_setup,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_ipc_clients = {
+	.name = "ipc_clients",
+	.desc = "IPC ping-pong benchmark with many clients at once (use 'clients' param to alter the default of 16)",
+	.entry = &clients_runner,
+	.setup = &clients_setup,
+	.teardown = &clients_teardown
+};
+
+/** @}
+ */
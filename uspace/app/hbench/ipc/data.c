@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <as.h>
+#include <errno.h>
+#include <ipc_test.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Data transfer and memory sharing benchmarks against the IPC test server.
+ * The size of the transferred data or of the shared area is given by the
+ * "size" parameter (in bytes).
+ */
+
+/** Maximum size of a shared area */
+#define SHARE_SIZE_MAX  (64 * 1024 * 1024)
+
+static ipc_test_t *test = NULL;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	errno_t rc = ipc_test_create(&test);
+	if (rc != EOK) {
+		return bench_run_fail(run,
+		    "failed contacting IPC test server (have you run /srv/test/ipc-test?): %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	ipc_test_destroy(test);
+	return true;
+}
+
+static bool get_size(bench_env_t *env, bench_run_t *run, size_t max,
+    size_t *size)
+{
+	const char *size_str = bench_env_param_get(env, "size", "4096");
+
+	*size = strtoul(size_str, NULL, 10);
+	if ((*size == 0) || (*size > max)) {
+		return bench_run_fail(run, "invalid size %s (must be between "
+		    "1 B and %zu B)", size_str, max);
+	}
+
+	return true;
+}
+
+static bool data_runner(bench_run_t *run, uint64_t niter, size_t size,
+    bool write)
+{
+	stopwatch_t stopwatch;
+	errno_t rc = EOK;
+
+	char *buf = calloc(1, size);
+	if (buf == NULL)
+		return bench_run_fail(run, "failed to allocate %zuB buffer", size);
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		if (write)
+			rc = ipc_test_data_write(test, buf, size);
+		else
+			rc = ipc_test_data_read(test, buf, size);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK)
+			break;
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+
+	bench_run_stop(run);
+
+	free(buf);
+
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed transferring data: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	return true;
+}
+
+static bool data_write_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t niter)
+{
+	size_t size;
+	if (!get_size(env, run, DATA_XFER_LIMIT, &size))
+		return false;
+
+	return data_runner(run, niter, size, true);
+}
+
+static bool data_read_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t niter)
+{
+	size_t size;
+	if (!get_size(env, run, DATA_XFER_LIMIT, &size))
+		return false;
+
+	return data_runner(run, niter, size, false);
+}
+
+/** Share in the read-only area of the server and unmap it again. */
+static bool share_in_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t niter)
+{
+	stopwatch_t stopwatch;
+	size_t size;
+
+	errno_t rc = ipc_test_get_ro_area_size(test, &size);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed getting area size: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		const void *area;
+
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		rc = ipc_test_share_in_ro(test, size, &area);
+		if (rc == EOK)
+			rc = as_area_destroy((void *) area);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sharing in: %s (%d)",
+			    str_error(rc), rc);
+		}
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+/** Share an area with the server, which maps and unmaps it. */
+static bool share_out_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t niter)
+{
+	stopwatch_t stopwatch;
+	size_t size;
+	errno_t rc = EOK;
+
+	if (!get_size(env, run, SHARE_SIZE_MAX, &size))
+		return false;
+
+	void *area = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return bench_run_fail(run, "failed to create %zuB area", size);
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+		rc = ipc_test_share_out(test, area);
+		stopwatch_stop(&stopwatch);
+
+		if (rc != EOK)
+			break;
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+
+	bench_run_stop(run);
+
+	as_area_destroy(area);
+
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed sharing out: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_ipc_data_write = {
+	.name = "ipc_data_write",
+	.desc = "IPC data write benchmark (use 'size' param to alter the default of 4096 bytes)",
+	.entry = &data_write_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_ipc_data_read = {
+	.name = "ipc_data_read",
+	.desc = "IPC data read benchmark (use 'size' param to alter the default of 4096 bytes)",
+	.entry = &data_read_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_ipc_share_in = {
+	.name = "ipc_share_in",
+	.desc = "Cost of sharing in and unmapping an address space area",
+	.entry = &share_in_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+benchmark_t benchmark_ipc_share_out = {
+	.name = "ipc_share_out",
+	.desc = "Cost of sharing out an address space area (use 'size' param to alter the default of 4096 bytes)",
+	.entry = &share_out_runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -39,15 +39,22 @@
 
 static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
 {
+	stopwatch_t stopwatch;
+
 	bench_run_start(run);
 
 	for (uint64_t count = 0; count < niter; count++) {
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
 		errno_t rc = ns_ping();
+		stopwatch_stop(&stopwatch);
 
 		if (rc != EOK) {
 			return bench_run_fail(run, "failed sending ping message: %s (%d)",
 			    str_error(rc), rc);
 		}
+
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
 	}
 
 	bench_run_stop(run);
@@ -60,7 +67,8 @@ benchmark_t benchmark_ns_ping = {
 	.desc = "Name service IPC ping-pong benchmark",
 	.entry = &runner,
 	.setup = NULL,
-	.teardown = NULL
+	.teardown = NULL,
+	.parallel = true
 };
 
 /** @}
@@ -35,6 +35,7 @@
 #include <async.h>
 #include <errno.h>
 #include <str_error.h>
+#include <sysinfo.h>
 #include "../hbench.h"
 
 static ipc_test_t *test = NULL;
@@ -48,6 +49,14 @@ static bool setup(bench_env_t *env, bench_run_t *run)
 		    str_error(rc), rc);
 	}
 
+	/*
+	 * Each round trip switches address spaces twice, report whether
+	 * the switches flush the TLB so that results can be compared.
+	 */
+	sysarg_t pcid;
+	if (sysinfo_get_value("mm.pcid", &pcid) == EOK)
+		printf("TLB entries tagged by PCID: %s\n", pcid ? "yes" : "no");
+
 	return true;
 }
 
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <async_ring.h>
+#include <errno.h>
+#include <ipc_test.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Streams messages to the IPC test server through a shared-memory ring.
+ * The message size is given by the "size" parameter (in bytes), the ring
+ * capacity by the "ring" parameter.
+ */
+
+#define MESSAGE_SIZE_MAX  4096
+
+static ipc_test_t *test = NULL;
+static async_ring_t *ring = NULL;
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	errno_t rc = ipc_test_create(&test);
+	if (rc != EOK) {
+		return bench_run_fail(run,
+		    "failed contacting IPC test server (have you run /srv/test/ipc-test?): %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	const char *ring_str = bench_env_param_get(env, "ring", "65536");
+	rc = ipc_test_ring_create(test, strtoul(ring_str, NULL, 10), &ring);
+	if (rc != EOK) {
+		ipc_test_destroy(test);
+		return bench_run_fail(run, "failed setting up the ring: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	async_ring_destroy(ring);
+	ipc_test_destroy(test);
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	const char *size_str = bench_env_param_get(env, "size", "64");
+	size_t size = strtoul(size_str, NULL, 10);
+	if ((size == 0) || (size > MESSAGE_SIZE_MAX)) {
+		return bench_run_fail(run, "invalid message size %s (must be "
+		    "between 1 B and %d B)", size_str, MESSAGE_SIZE_MAX);
+	}
+
+	char *buf = calloc(1, size);
+	if (buf == NULL)
+		return bench_run_fail(run, "failed to allocate %zuB buffer", size);
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		errno_t rc = async_ring_write(ring, buf, size);
+
+		if (rc != EOK) {
+			free(buf);
+			return bench_run_fail(run, "failed writing to the ring: %s (%d)",
+			    str_error(rc), rc);
+		}
+	}
+
+	/* Make sure the server has seen all the preceding doorbells. */
+	errno_t rc = ipc_test_ping(test);
+
+	bench_run_stop(run);
+
+	free(buf);
+
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed sending ping message: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	return true;
+}
+
+benchmark_t benchmark_ring = {
+	.name = "ring",
+	.desc = "Shared-memory ring streaming benchmark",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -35,8 +35,12 @@
  */
 
 #include <assert.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <getopt.h>
+#include <macros.h>
 #include <math.h>
+#include <stats.h>
 #include <stdio.h>
 #include <stddef.h>
 #include <stdlib.h>
@@ -50,49 +54,62 @@
 
 #define MAX_ERROR_STR_LENGTH 1024
 
+/** Maximum value of the 'threads' parameter */
+#define MAX_THREADS 64
+
+/** Run of a benchmark on several threads at once. */
+typedef struct {
+	bench_env_t *env;
+	benchmark_t *bench;
+	uint64_t workload_size;
+
+	fibril_mutex_t lock;
+	fibril_condvar_t cv;
+	/** Number of workers not yet waiting for the start */
+	unsigned int starting;
+	/** Number of workers still running the benchmark */
+	unsigned int active;
+	/** The workers may start */
+	bool go;
+} par_job_t;
+
+/** Thread of a parallel benchmark run. */
+typedef struct {
+	par_job_t *job;
+	bench_run_t run;
+	char error_msg[MAX_ERROR_STR_LENGTH + 1];
+	bool ok;
+} par_worker_t;
+
+/** Number of fibril runner threads of this task */
+static unsigned int runner_count = 1;
+
 static void short_report(bench_run_t *info, int run_index,
-    benchmark_t *bench, uint64_t workload_size)
+    benchmark_t *bench, unsigned int threads, uint64_t workload_size)
 {
-	csv_report_add_entry(info, run_index, bench, workload_size);
+	csv_report_add_entry(info, run_index, bench, threads, workload_size);
 
 	usec_t duration_usec = NSEC2USEC(stopwatch_get_nanos(&info->stopwatch));
 
-	printf("Completed %" PRIu64 " operations in %llu us",
-	    workload_size, duration_usec);
+	printf("Completed %" PRIu64 " operations", workload_size);
+	if (threads > 1)
+		printf(" on %u threads", threads);
+	printf(" in %llu us", duration_usec);
 	if (duration_usec > 0) {
 		double nanos = stopwatch_get_nanos(&info->stopwatch);
 		double thruput = (double) workload_size / (nanos / 1000000000.0l);
-		printf(", %.0f ops/s.\n", thruput);
-	} else {
-		printf(".\n");
+		printf(", %.0f ops/s", thruput);
 	}
-}
 
-/** Estimate square root value.
- *
- * @param value The value to compute square root of.
- * @param precision Required precision (e.g. 0.00001).
- *
- * @details
- *
- * This is a temporary solution until we have proper sqrt() implementation
- * in libmath.
- *
- * The algorithm uses Babylonian method [1].
- *
- * [1] https://en.wikipedia.org/wiki/Methods_of_computing_square_roots#Babylonian_method
- */
-static double estimate_square_root(double value, double precision)
-{
-	double estimate = 1.;
-	double prev_estimate = estimate + 10 * precision;
-
-	while (fabs(estimate - prev_estimate) > precision) {
-		prev_estimate = estimate;
-		estimate = (prev_estimate + value / prev_estimate) / 2.;
+	nsec_t p50, p99, p999;
+	if (bench_run_latency_get(info, 500, &p50) &&
+	    bench_run_latency_get(info, 990, &p99) &&
+	    bench_run_latency_get(info, 999, &p999)) {
+		printf("; latency p50 %lld ns, p99 %lld ns, p99.9 %lld ns",
+		    (long long) p50, (long long) p99, (long long) p999);
 	}
 
-	return estimate;
+	printf(".\n");
 }
 
 /** Compute available statistics from given stopwatches.
@@ -136,7 +153,11 @@ static void compute_stats(bench_run_t *runs, size_t run_count,
 	*out_thruput_avg = 1.0 / (inv_thruput_sum / run_count);
 }
 
-static void summary_stats(bench_run_t *runs, size_t run_count,
+/** Print summary of the measured runs.
+ *
+ * @return Average throughput in operations per second.
+ */
+static double summary_stats(bench_run_t *runs, size_t run_count,
     benchmark_t *bench, uint64_t workload_size)
 {
 	double duration_avg, duration_sigma, thruput_avg;
@@ -147,6 +168,185 @@ static void summary_stats(bench_run_t *runs, size_t run_count,
 	    "%.0f ops/s; Samples: %zu\n",
 	    workload_size, duration_avg / 1000.0, duration_sigma / 1000.0,
 	    thruput_avg * 1000000000.0, run_count);
+
+	return thruput_avg * 1000000000.0;
+}
+
+/** Print throughput and latency for each number of threads.
+ *
+ * @param totals Runs with the same number of threads merged together.
+ * @param thruputs Average throughput for each number of threads.
+ * @param min_threads Number of threads of the first entry.
+ * @param count Number of entries.
+ */
+static void scalability_report(bench_run_t *totals, double *thruputs,
+    unsigned int min_threads, size_t count)
+{
+	printf("\nScalability:\n");
+	printf("%7s %12s %8s %10s %10s %10s\n", "threads", "ops/s",
+	    "speedup", "p50 ns", "p99 ns", "p99.9 ns");
+
+	for (size_t i = 0; i < count; i++) {
+		printf("%7u %12.0f %8.2f", min_threads + (unsigned int) i,
+		    thruputs[i], thruputs[i] / thruputs[0]);
+
+		nsec_t p50, p99, p999;
+		if (bench_run_latency_get(&totals[i], 500, &p50) &&
+		    bench_run_latency_get(&totals[i], 990, &p99) &&
+		    bench_run_latency_get(&totals[i], 999, &p999)) {
+			printf(" %10lld %10lld %10lld", (long long) p50,
+			    (long long) p99, (long long) p999);
+		}
+
+		printf("\n");
+	}
+}
+
+/** Determine the numbers of threads to run a benchmark with.
+ *
+ * The 'threads' parameter is either the number of threads, or 'sweep'
+ * to run the benchmark with each number of threads from one to the number
+ * of CPUs.
+ *
+ * @param env Benchmark environment.
+ * @param min_threads Where to store the smallest number of threads.
+ * @param max_threads Where to store the largest number of threads.
+ * @return Whether the parameter is valid.
+ */
+static bool get_thread_counts(bench_env_t *env, unsigned int *min_threads,
+    unsigned int *max_threads)
+{
+	const char *str = bench_env_param_get(env, "threads", "1");
+
+	if (str_cmp(str, "sweep") == 0) {
+		size_t cpus;
+		free(stats_get_cpus(&cpus));
+
+		*min_threads = 1;
+		*max_threads = min(max(cpus, 1), MAX_THREADS);
+		return true;
+	}
+
+	char *end;
+	unsigned long val = strtoul(str, &end, 10);
+	if ((*end != '\0') || (val == 0) || (val > MAX_THREADS))
+		return false;
+
+	*min_threads = val;
+	*max_threads = val;
+	return true;
+}
+
+/** Make sure there is a fibril runner thread for each benchmark thread. */
+static void spawn_runners(unsigned int threads)
+{
+	if (threads > runner_count)
+		runner_count += fibril_test_spawn_runners(threads -
+		    runner_count);
+}
+
+static errno_t par_worker_fn(void *arg)
+{
+	par_worker_t *worker = arg;
+	par_job_t *job = worker->job;
+
+	fibril_detach(fibril_get_id());
+
+	/* Wait for the other workers so that all of them start at once */
+	fibril_mutex_lock(&job->lock);
+	job->starting--;
+	fibril_condvar_broadcast(&job->cv);
+	while (!job->go)
+		fibril_condvar_wait(&job->cv, &job->lock);
+	fibril_mutex_unlock(&job->lock);
+
+	worker->ok = job->bench->entry(job->env, &worker->run,
+	    job->workload_size);
+
+	fibril_mutex_lock(&job->lock);
+	job->active--;
+	fibril_condvar_broadcast(&job->cv);
+	fibril_mutex_unlock(&job->lock);
+
+	return EOK;
+}
+
+/** Execute one run of a benchmark on the given number of threads.
+ *
+ * Each thread executes the whole workload. The resulting run lasts from
+ * the earliest start to the latest stop of the threads and its latency
+ * histogram covers the operations of all of them.
+ *
+ * @param env Benchmark environment.
+ * @param bench Benchmark to run.
+ * @param threads Number of threads.
+ * @param workload_size Workload size of each thread.
+ * @param run Where to store the performance data or error message.
+ * @return Whether the benchmark succeeded on all threads.
+ */
+static bool run_threads(bench_env_t *env, benchmark_t *bench,
+    unsigned int threads, uint64_t workload_size, bench_run_t *run)
+{
+	if (threads == 1)
+		return bench->entry(env, run, workload_size);
+
+	par_worker_t *workers = calloc(threads, sizeof(par_worker_t));
+	if (workers == NULL)
+		return bench_run_fail(run, "failed allocating memory");
+
+	par_job_t job = {
+		.env = env,
+		.bench = bench,
+		.workload_size = workload_size,
+		.starting = threads,
+		.active = threads,
+		.go = false
+	};
+	fibril_mutex_initialize(&job.lock);
+	fibril_condvar_initialize(&job.cv);
+
+	unsigned int created;
+	for (created = 0; created < threads; created++) {
+		par_worker_t *worker = &workers[created];
+
+		worker->job = &job;
+		bench_run_init(&worker->run, worker->error_msg,
+		    MAX_ERROR_STR_LENGTH);
+
+		fid_t fid = fibril_create(par_worker_fn, worker);
+		if (fid == 0)
+			break;
+		fibril_add_ready(fid);
+	}
+
+	fibril_mutex_lock(&job.lock);
+	job.starting -= threads - created;
+	job.active -= threads - created;
+	while (job.starting > 0)
+		fibril_condvar_wait(&job.cv, &job.lock);
+	job.go = true;
+	fibril_condvar_broadcast(&job.cv);
+	while (job.active > 0)
+		fibril_condvar_wait(&job.cv, &job.lock);
+	fibril_mutex_unlock(&job.lock);
+
+	bool ok = true;
+	if (created < threads) {
+		bench_run_fail(run, "failed creating fibrils");
+		ok = false;
+	}
+
+	run->stopwatch = workers[0].run.stopwatch;
+	for (unsigned int i = 0; i < created; i++) {
+		if (ok && !workers[i].ok) {
+			bench_run_fail(run, "%s", workers[i].error_msg);
+			ok = false;
+		}
+		bench_run_merge(run, &workers[i].run);
+	}
+
+	free(workers);
+	return ok;
 }
 
 static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
@@ -167,8 +367,27 @@ static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
 	bench_run_t helper_run;
 	bench_run_init(&helper_run, error_msg, MAX_ERROR_STR_LENGTH);
 
+	bench_run_t *runs = NULL;
+	bench_run_t *totals = NULL;
+	double *thruputs = NULL;
+	bool regressed = false;
 	bool ret = true;
 
+	unsigned int min_threads;
+	unsigned int max_threads;
+	if (!get_thread_counts(env, &min_threads, &max_threads)) {
+		printf("Error: invalid threads parameter (must be 1 to %d "
+		    "or sweep)\n", MAX_THREADS);
+		free(error_msg);
+		return false;
+	}
+
+	if (!bench->parallel && max_threads > 1) {
+		printf("Benchmark cannot run on several threads, using one.\n");
+		min_threads = 1;
+		max_threads = 1;
+	}
+
 	if (bench->setup != NULL) {
 		ret = bench->setup(env, &helper_run);
 		if (!ret) {
@@ -195,7 +414,7 @@ static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
 		if (!ok) {
 			goto leave_error;
 		}
-		short_report(&run, -1, bench, workload_size);
+		short_report(&run, -1, bench, 1, workload_size);
 
 		nsec_t duration = stopwatch_get_nanos(&run.stopwatch);
 		if (duration > env->minimal_run_duration_nanos) {
@@ -206,26 +425,61 @@ static bool run_benchmark(bench_env_t *env, benchmark_t *bench)
 	printf("Workload size set to %" PRIu64 ", measuring %zu samples.\n",
 	    workload_size, env->run_count);
 
-	bench_run_t *runs = calloc(env->run_count, sizeof(bench_run_t));
-	if (runs == NULL) {
+	size_t counts = max_threads - min_threads + 1;
+	runs = calloc(env->run_count, sizeof(bench_run_t));
+	totals = calloc(counts, sizeof(bench_run_t));
+	thruputs = calloc(counts, sizeof(double));
+	if ((runs == NULL) || (totals == NULL) || (thruputs == NULL)) {
 		snprintf(error_msg, MAX_ERROR_STR_LENGTH, "failed allocating memory");
 		goto leave_error;
 	}
-	for (size_t i = 0; i < env->run_count; i++) {
-		bench_run_init(&runs[i], error_msg, MAX_ERROR_STR_LENGTH);
 
-		bool ok = bench->entry(env, &runs[i], workload_size);
-		if (!ok) {
-			free(runs);
-			goto leave_error;
+	spawn_runners(max_threads);
+
+	for (size_t c = 0; c < counts; c++) {
+		unsigned int threads = min_threads + c;
+		uint64_t ops = threads * workload_size;
+
+		if (threads > 1)
+			printf("Running on %u threads.\n", threads);
+
+		bench_run_init(&totals[c], error_msg, MAX_ERROR_STR_LENGTH);
+
+		for (size_t i = 0; i < env->run_count; i++) {
+			bench_run_init(&runs[i], error_msg,
+			    MAX_ERROR_STR_LENGTH);
+
+			bool ok = run_threads(env, bench, threads,
+			    workload_size, &runs[i]);
+			if (!ok) {
+				goto leave_error;
+			}
+			short_report(&runs[i], i, bench, threads, ops);
+
+			if (i == 0)
+				totals[c].stopwatch = runs[i].stopwatch;
+			bench_run_merge(&totals[c], &runs[i]);
+		}
+
+		thruputs[c] = summary_stats(runs, env->run_count, bench, ops);
+
+		if (baseline_loaded() &&
+		    !baseline_compare(bench, threads, runs, env->run_count,
+		    ops)) {
+			regressed = true;
 		}
-		short_report(&runs[i], i, bench, workload_size);
 	}
 
-	summary_stats(runs, env->run_count, bench, workload_size);
-	printf("\nBenchmark completed\n");
+	if (counts > 1)
+		scalability_report(totals, thruputs, min_threads, counts);
 
-	free(runs);
+	if (regressed) {
+		snprintf(error_msg, MAX_ERROR_STR_LENGTH,
+		    "performance regressed against the baseline");
+		goto leave_error;
+	}
+
+	printf("\nBenchmark completed\n");
 
 	goto leave;
 
@@ -242,21 +496,36 @@ leave:
 		}
 	}
 
+	free(runs);
+	free(totals);
+	free(thruputs);
 	free(error_msg);
 
 	return ret;
 }
 
-static int run_benchmarks(bench_env_t *env)
+/** Run all benchmarks.
+ *
+ * @param env Benchmark environment.
+ * @param baseline_only Run only the benchmarks found in the baseline.
+ * @return Number of failed benchmarks.
+ */
+static int run_benchmarks(bench_env_t *env, bool baseline_only)
 {
 	unsigned int count_ok = 0;
 	unsigned int count_fail = 0;
 
 	char *failed_names = NULL;
 
-	printf("\n*** Running all benchmarks ***\n\n");
+	if (baseline_only)
+		printf("\n*** Running benchmarks of the baseline ***\n\n");
+	else
+		printf("\n*** Running all benchmarks ***\n\n");
 
 	for (size_t it = 0; it < benchmark_count; it++) {
+		if (baseline_only && !baseline_contains(benchmarks[it]))
+			continue;
+
 		printf("%s (%s)\n", benchmarks[it]->name, benchmarks[it]->desc);
 		if (run_benchmark(env, benchmarks[it])) {
 			count_ok++;
@@ -306,6 +575,10 @@ static void list_benchmarks(void)
 static void print_usage(const char *progname)
 {
 	printf("Usage: %s [options] <benchmark>\n", progname);
+	printf("       %s [options] -b baseline.csv [<benchmark>]\n",
+	    progname);
+	printf("-b, --baseline file.csv    "
+	    "Compare with results stored by -o and fail on regressions\n");
 	printf("-h, --help                 "
 	    "Print this help and exit\n");
 	printf("-d, --duration MILLIS      "
@@ -316,6 +589,14 @@ static void print_usage(const char *progname)
 	    "Store machine-readable data in filename.csv\n");
 	printf("-p, --param KEY=VALUE      "
 	    "Additional parameters for the benchmark\n");
+	printf("-t, --threshold PERCENT    "
+	    "Allowed throughput drop against the baseline (default %d)\n",
+	    BASELINE_DEFAULT_THRESHOLD);
+	printf("Use -p threads=N to run the benchmark on N threads at once "
+	    "or -p threads=sweep\nfor each number of threads up to the "
+	    "number of CPUs.\n");
+	printf("Without <benchmark>, the benchmarks of the baseline "
+	    "are run.\n");
 	printf("<benchmark> is one of the following:\n");
 	list_benchmarks();
 }
@@ -337,21 +618,28 @@ int main(int argc, char *argv[])
 		return -5;
 	}
 
-	const char *short_options = "ho:p:n:d:";
+	const char *short_options = "hb:o:p:n:d:t:";
 	struct option long_options[] = {
+		{ "baseline", required_argument, NULL, 'b' },
 		{ "duration", required_argument, NULL, 'd' },
 		{ "help", optional_argument, NULL, 'h' },
 		{ "count", required_argument, NULL, 'n' },
 		{ "output", required_argument, NULL, 'o' },
 		{ "param", required_argument, NULL, 'p' },
+		{ "threshold", required_argument, NULL, 't' },
 		{ 0, 0, NULL, 0 }
 	};
 
 	char *csv_output_filename = NULL;
+	char *baseline_filename = NULL;
+	bool run_count_set = false;
 
 	int opt = 0;
 	while ((opt = getopt_long(argc, argv, short_options, long_options, NULL)) > 0) {
 		switch (opt) {
+		case 'b':
+			baseline_filename = optarg;
+			break;
 		case 'd':
 			errno = EOK;
 			bench_env.minimal_run_duration_nanos = MSEC2NSEC(atoll(optarg));
@@ -370,6 +658,7 @@ int main(int argc, char *argv[])
 				fprintf(stderr, "Invalid -n argument.\n");
 				return -3;
 			}
+			run_count_set = true;
 			break;
 		case 'o':
 			csv_output_filename = optarg;
@@ -377,19 +666,38 @@ int main(int argc, char *argv[])
 		case 'p':
 			handle_param_arg(&bench_env, optarg);
 			break;
+		case 't':
+			baseline_set_threshold(strtoul(optarg, NULL, 10));
+			break;
 		case -1:
 		default:
 			break;
 		}
 	}
 
-	if (optind + 1 != argc) {
+	if (optind + 1 != argc &&
+	    (baseline_filename == NULL || optind != argc)) {
 		print_usage(*argv);
 		fprintf(stderr, "Error: specify one benchmark to run or * for all.\n");
 		return -3;
 	}
 
-	const char *benchmark = argv[optind];
+	const char *benchmark = optind < argc ? argv[optind] : NULL;
+
+	if (baseline_filename != NULL) {
+		rc = baseline_load(baseline_filename);
+		if (rc == EOK && !baseline_loaded())
+			rc = ENOENT;
+		if (rc != EOK) {
+			fprintf(stderr, "Failed to load baseline '%s': %s\n",
+			    baseline_filename, str_error(rc));
+			return -4;
+		}
+
+		/* More samples make the comparison more sensitive */
+		if (!run_count_set)
+			bench_env.run_count = BASELINE_RUN_COUNT;
+	}
 
 	if (csv_output_filename != NULL) {
 		errno_t rc = csv_report_open(csv_output_filename);
@@ -402,8 +710,10 @@ int main(int argc, char *argv[])
 
 	int exit_code = 0;
 
-	if (str_cmp(benchmark, "*") == 0) {
-		exit_code = run_benchmarks(&bench_env);
+	if (benchmark == NULL) {
+		exit_code = run_benchmarks(&bench_env, true);
+	} else if (str_cmp(benchmark, "*") == 0) {
+		exit_code = run_benchmarks(&bench_env, false);
 	} else {
 		bool benchmark_exists = false;
 		for (size_t i = 0; i < benchmark_count; i++) {
@@ -420,6 +730,7 @@ int main(int argc, char *argv[])
 	}
 
 	csv_report_close();
+	baseline_free();
 	bench_env_cleanup(&bench_env);
 
 	return exit_code;
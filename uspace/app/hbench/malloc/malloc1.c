@@ -57,7 +57,8 @@ benchmark_t benchmark_malloc1 = {
 	.desc = "User-space memory allocator benchmark, repeatedly allocate one block",
 	.entry = &runner,
 	.setup = NULL,
-	.teardown = NULL
+	.teardown = NULL,
+	.parallel = true
 };
 
 /** @}
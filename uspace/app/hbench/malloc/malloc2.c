@@ -72,7 +72,8 @@ benchmark_t benchmark_malloc2 = {
 	.desc = "User-space memory allocator benchmark, allocate many small blocks",
 	.entry = &runner,
 	.setup = NULL,
-	.teardown = NULL
+	.teardown = NULL,
+	.parallel = true
 };
 
 /** @}
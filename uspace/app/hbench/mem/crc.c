@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <adt/checksum.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../hbench.h"
+
+/*
+ * Benchmarks of the CRC functions. The block size is given by the "size"
+ * parameter (1 B to 1 MiB, K and M suffixes are accepted).
+ */
+
+#define BLOCK_SIZE_MAX  (1024 * 1024)
+
+typedef uint32_t (*crc_fn_t)(uint8_t *, size_t, uint32_t);
+
+static bool parse_size(const char *str, size_t *size)
+{
+	char *end;
+	unsigned long val = strtoul(str, &end, 10);
+
+	if ((*end == 'k') || (*end == 'K')) {
+		val *= 1024;
+		end++;
+	} else if ((*end == 'm') || (*end == 'M')) {
+		val *= 1024 * 1024;
+		end++;
+	}
+
+	if (*end != '\0')
+		return false;
+
+	*size = val;
+	return true;
+}
+
+static bool crc_runner(bench_env_t *env, bench_run_t *run, uint64_t count,
+    crc_fn_t crc_fn)
+{
+	size_t size;
+
+	const char *size_str = bench_env_param_get(env, "size", "4K");
+	if ((!parse_size(size_str, &size)) || (size == 0) ||
+	    (size > BLOCK_SIZE_MAX)) {
+		return bench_run_fail(run, "invalid block size %s (must be "
+		    "between 1 B and %d B)", size_str, BLOCK_SIZE_MAX);
+	}
+
+	uint8_t *buf = malloc(size);
+	if (buf == NULL)
+		return bench_run_fail(run, "failed to allocate %zuB buffer",
+		    size);
+
+	for (size_t i = 0; i < size; i++)
+		buf[i] = (uint8_t) (i * 7);
+
+	volatile uint32_t crc = 0;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < count; i++)
+		crc = crc_fn(buf, size, crc);
+	bench_run_stop(run);
+
+	free(buf);
+	return true;
+}
+
+static bool crc32_runner(bench_env_t *env, bench_run_t *run, uint64_t count)
+{
+	return crc_runner(env, run, count, compute_crc32_seed);
+}
+
+static bool crc32c_runner(bench_env_t *env, bench_run_t *run, uint64_t count)
+{
+	return crc_runner(env, run, count, compute_crc32c_seed);
+}
+
+benchmark_t benchmark_crc32 = {
+	.name = "crc32",
+	.desc = "Compute CRC32 of a memory block (params: size)",
+	.entry = &crc32_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.parallel = true
+};
+
+benchmark_t benchmark_crc32c = {
+	.name = "crc32c",
+	.desc = "Compute CRC32C of a memory block (params: size)",
+	.entry = &crc32c_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.parallel = true
+};
+
+/** @}
+ */
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <mem.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+/*
+ * Benchmarks of the memory string functions. The block size is given by
+ * the "size" parameter (8 B to 1 MiB, K and M suffixes are accepted) and
+ * the misalignment of the source block by the "offset" parameter.
+ */
+
+#define BLOCK_SIZE_MIN  8
+#define BLOCK_SIZE_MAX  (1024 * 1024)
+
+typedef enum {
+	MEM_OP_COPY,
+	MEM_OP_SET,
+	MEM_OP_CMP
+} mem_op_t;
+
+static bool parse_size(const char *str, size_t *size)
+{
+	char *end;
+	unsigned long val = strtoul(str, &end, 10);
+
+	if ((*end == 'k') || (*end == 'K')) {
+		val *= 1024;
+		end++;
+	} else if ((*end == 'm') || (*end == 'M')) {
+		val *= 1024 * 1024;
+		end++;
+	}
+
+	if (*end != '\0')
+		return false;
+
+	*size = val;
+	return true;
+}
+
+static bool mem_runner(bench_env_t *env, bench_run_t *run, uint64_t count,
+    mem_op_t op)
+{
+	size_t size;
+	size_t offset;
+
+	const char *size_str = bench_env_param_get(env, "size", "4K");
+	if ((!parse_size(size_str, &size)) || (size < BLOCK_SIZE_MIN) ||
+	    (size > BLOCK_SIZE_MAX)) {
+		return bench_run_fail(run, "invalid block size %s (must be "
+		    "between %d B and %d B)", size_str, BLOCK_SIZE_MIN,
+		    BLOCK_SIZE_MAX);
+	}
+
+	const char *offset_str = bench_env_param_get(env, "offset", "0");
+	if ((!parse_size(offset_str, &offset)) || (offset >= 64))
+		return bench_run_fail(run, "invalid offset %s", offset_str);
+
+	uint8_t *src = malloc(size + offset);
+	uint8_t *dst = malloc(size);
+	if ((src == NULL) || (dst == NULL)) {
+		free(src);
+		free(dst);
+		return bench_run_fail(run, "failed to allocate %zuB buffers",
+		    size);
+	}
+
+	memset(src, 0x5a, size + offset);
+	memset(dst, 0x5a, size);
+
+	volatile int result = 0;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < count; i++) {
+		switch (op) {
+		case MEM_OP_COPY:
+			memcpy(dst, src + offset, size);
+			break;
+		case MEM_OP_SET:
+			memset(dst, (int) i, size);
+			break;
+		case MEM_OP_CMP:
+			result += memcmp(dst, src + offset, size);
+			break;
+		}
+	}
+	bench_run_stop(run);
+
+	(void) result;
+
+	free(src);
+	free(dst);
+	return true;
+}
+
+static bool memcpy_runner(bench_env_t *env, bench_run_t *run, uint64_t count)
+{
+	return mem_runner(env, run, count, MEM_OP_COPY);
+}
+
+static bool memset_runner(bench_env_t *env, bench_run_t *run, uint64_t count)
+{
+	return mem_runner(env, run, count, MEM_OP_SET);
+}
+
+static bool memcmp_runner(bench_env_t *env, bench_run_t *run, uint64_t count)
+{
+	return mem_runner(env, run, count, MEM_OP_CMP);
+}
+
+benchmark_t benchmark_memcpy = {
+	.name = "memcpy",
+	.desc = "Copy a memory block (params: size, offset)",
+	.entry = &memcpy_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.parallel = true
+};
+
+benchmark_t benchmark_memset = {
+	.name = "memset",
+	.desc = "Fill a memory block (params: size, offset)",
+	.entry = &memset_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.parallel = true
+};
+
+benchmark_t benchmark_memcmp = {
+	.name = "memcmp",
+	.desc = "Compare two equal memory blocks (params: size, offset)",
+	.entry = &memcmp_runner,
+	.setup = NULL,
+	.teardown = NULL,
+	.parallel = true
+};
+
+/** @}
+ */
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/hostport.h>
+#include <inet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * TCP throughput, latency and connection rate. Unless the "peer"
+ * parameter gives the host:port of a remote server, hbench serves the
+ * connections itself over loopback on the port given by the "port"
+ * parameter. A remote peer is expected to discard data for tcp_stream
+ * (like the discard service), to echo it for tcp_rr (like the echo
+ * service) and to close the connection once the client did for
+ * conn_rate. The "size" parameter gives the message size.
+ */
+
+#define MESSAGE_SIZE_MAX  (1024 * 1024)
+
+typedef enum {
+	/** Receive and count data */
+	SERVER_DISCARD,
+	/** Send back received data */
+	SERVER_ECHO
+} server_mode_t;
+
+static tcp_t *tcp = NULL;
+static tcp_listener_t *listener = NULL;
+static tcp_conn_t *conn = NULL;
+static inet_ep_t peer;
+static size_t msg_size;
+static char *msg_buf = NULL;
+static server_mode_t server_mode;
+
+/** Protects server state below */
+static FIBRIL_MUTEX_INITIALIZE(server_lock);
+/** Signalled when server state changes */
+static FIBRIL_CONDVAR_INITIALIZE(server_cv);
+/** Number of connections being served */
+static unsigned int server_conns;
+/** Number of bytes received by the server */
+static uint64_t server_received;
+
+static void server_new_conn(tcp_listener_t *, tcp_conn_t *);
+
+static tcp_listen_cb_t listen_cb = {
+	.new_conn = server_new_conn
+};
+
+static tcp_cb_t conn_cb = {
+	.connected = NULL
+};
+
+/** Serve one connection until the client closes it. */
+static void server_new_conn(tcp_listener_t *lst, tcp_conn_t *sconn)
+{
+	char buf[4096];
+	size_t nrecv;
+	errno_t rc;
+
+	fibril_mutex_lock(&server_lock);
+	++server_conns;
+	fibril_mutex_unlock(&server_lock);
+
+	while (true) {
+		rc = tcp_conn_recv_wait(sconn, buf, sizeof(buf), &nrecv);
+		if (rc != EOK || nrecv == 0)
+			break;
+
+		if (server_mode == SERVER_ECHO) {
+			rc = tcp_conn_send(sconn, buf, nrecv);
+			if (rc == EOK)
+				rc = tcp_conn_push(sconn);
+			if (rc != EOK)
+				break;
+		} else {
+			fibril_mutex_lock(&server_lock);
+			server_received += nrecv;
+			fibril_condvar_broadcast(&server_cv);
+			fibril_mutex_unlock(&server_lock);
+		}
+	}
+
+	if (rc == EOK)
+		(void) tcp_conn_send_fin(sconn);
+
+	fibril_mutex_lock(&server_lock);
+	--server_conns;
+	fibril_condvar_broadcast(&server_cv);
+	fibril_mutex_unlock(&server_lock);
+}
+
+/** Connect to the peer.
+ *
+ * @param run   Current benchmark run
+ * @param rconn Place to store the connection
+ * @return Whether the connection was established
+ */
+static bool client_connect(bench_run_t *run, tcp_conn_t **rconn)
+{
+	inet_ep2_t epp;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	epp.remote = peer;
+
+	rc = tcp_conn_create(tcp, &epp, NULL, NULL, rconn);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed creating connection: %s",
+		    str_error(rc));
+	}
+
+	rc = tcp_conn_wait_connected(*rconn);
+	if (rc != EOK) {
+		tcp_conn_destroy(*rconn);
+		return bench_run_fail(run, "failed connecting: %s",
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+/** Close connection gracefully, waiting for the peer to close too. */
+static errno_t client_close(tcp_conn_t *cconn)
+{
+	char buf[256];
+	size_t nrecv;
+	errno_t rc;
+
+	rc = tcp_conn_send_fin(cconn);
+	while (rc == EOK) {
+		rc = tcp_conn_recv_wait(cconn, buf, sizeof(buf), &nrecv);
+		if (nrecv == 0)
+			break;
+	}
+
+	tcp_conn_destroy(cconn);
+	return rc;
+}
+
+/** Set up the peer and, for a local peer, the server. */
+static bool setup_common(bench_env_t *env, bench_run_t *run,
+    const char *def_size, server_mode_t mode)
+{
+	const char *peer_str = bench_env_param_get(env, "peer", NULL);
+	const char *size_str = bench_env_param_get(env, "size", def_size);
+	const char *errmsg;
+	errno_t rc;
+
+	msg_size = strtoul(size_str, NULL, 10);
+	if (msg_size == 0 || msg_size > MESSAGE_SIZE_MAX) {
+		return bench_run_fail(run, "invalid message size %s (must be "
+		    "between 1 B and %d B)", size_str, MESSAGE_SIZE_MAX);
+	}
+
+	msg_buf = calloc(1, msg_size);
+	if (msg_buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %zuB buffer",
+		    msg_size);
+	}
+
+	rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		free(msg_buf);
+		return bench_run_fail(run, "failed contacting TCP service: %s",
+		    str_error(rc));
+	}
+
+	if (peer_str != NULL) {
+		rc = inet_hostport_plookup_one(peer_str, ip_any, &peer, NULL,
+		    &errmsg);
+		if (rc != EOK) {
+			tcp_destroy(tcp);
+			free(msg_buf);
+			return bench_run_fail(run, "invalid peer %s: %s",
+			    peer_str, errmsg);
+		}
+
+		return true;
+	}
+
+	const char *port_str = bench_env_param_get(env, "port", "5001");
+	inet_ep_init(&peer);
+	inet_addr(&peer.addr, 127, 0, 0, 1);
+	peer.port = strtoul(port_str, NULL, 10);
+
+	server_mode = mode;
+	server_received = 0;
+
+	rc = tcp_listener_create(tcp, &peer, &listen_cb, NULL, &conn_cb, NULL,
+	    &listener);
+	if (rc != EOK) {
+		tcp_destroy(tcp);
+		free(msg_buf);
+		return bench_run_fail(run, "failed listening on port %s: %s",
+		    port_str, str_error(rc));
+	}
+
+	return true;
+}
+
+static bool teardown_common(bench_env_t *env, bench_run_t *run)
+{
+	if (listener != NULL) {
+		/* Let the server finish with all connections */
+		fibril_mutex_lock(&server_lock);
+		while (server_conns > 0)
+			fibril_condvar_wait(&server_cv, &server_lock);
+		fibril_mutex_unlock(&server_lock);
+
+		tcp_listener_destroy(listener);
+		listener = NULL;
+	}
+
+	tcp_destroy(tcp);
+	tcp = NULL;
+	free(msg_buf);
+	msg_buf = NULL;
+	return true;
+}
+
+/** Set up a benchmark running over a single connection. */
+static bool setup_conn(bench_env_t *env, bench_run_t *run,
+    const char *def_size, server_mode_t mode)
+{
+	if (!setup_common(env, run, def_size, mode))
+		return false;
+
+	if (!client_connect(run, &conn)) {
+		teardown_common(env, run);
+		return false;
+	}
+
+	return true;
+}
+
+static bool teardown_conn(bench_env_t *env, bench_run_t *run)
+{
+	errno_t rc = client_close(conn);
+	conn = NULL;
+
+	teardown_common(env, run);
+
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed closing connection: %s",
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+static bool stream_setup(bench_env_t *env, bench_run_t *run)
+{
+	if (!setup_conn(env, run, "16384", SERVER_DISCARD))
+		return false;
+
+	(void) tcp_conn_send_ring(conn, 4 * msg_size);
+	return true;
+}
+
+static bool rr_setup(bench_env_t *env, bench_run_t *run)
+{
+	if (!setup_conn(env, run, "64", SERVER_ECHO))
+		return false;
+
+	(void) tcp_conn_set_nodelay(conn, true);
+	return true;
+}
+
+static bool conn_rate_setup(bench_env_t *env, bench_run_t *run)
+{
+	return setup_common(env, run, "1", SERVER_DISCARD);
+}
+
+/** Send @a niter messages.
+ *
+ * With a local server, the run ends once the server received all data.
+ */
+static bool stream_runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	uint64_t target = server_received + niter * msg_size;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		rc = tcp_conn_send(conn, msg_buf, msg_size);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending data: %s",
+			    str_error(rc));
+		}
+	}
+
+	rc = tcp_conn_push(conn);
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed pushing data: %s",
+		    str_error(rc));
+	}
+
+	if (listener != NULL) {
+		fibril_mutex_lock(&server_lock);
+		while (server_received < target && server_conns > 0)
+			fibril_condvar_wait(&server_cv, &server_lock);
+		fibril_mutex_unlock(&server_lock);
+	}
+
+	bench_run_stop(run);
+
+	if (listener != NULL && server_received < target)
+		return bench_run_fail(run, "server closed the connection");
+
+	return true;
+}
+
+/** Send a message and wait for it to be echoed, @a niter times. */
+static bool rr_runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	stopwatch_t stopwatch;
+	size_t nrecv;
+	size_t left;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+
+		rc = tcp_conn_send(conn, msg_buf, msg_size);
+		if (rc == EOK)
+			rc = tcp_conn_push(conn);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending request: %s",
+			    str_error(rc));
+		}
+
+		for (left = msg_size; left > 0; left -= nrecv) {
+			rc = tcp_conn_recv_wait(conn, msg_buf, left, &nrecv);
+			if (rc == EOK && nrecv == 0)
+				rc = ECONNRESET;
+			if (rc != EOK) {
+				return bench_run_fail(run, "failed receiving "
+				    "response: %s", str_error(rc));
+			}
+		}
+
+		stopwatch_stop(&stopwatch);
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+/** Open and close a connection, @a niter times. */
+static bool conn_rate_runner(bench_env_t *env, bench_run_t *run,
+    uint64_t niter)
+{
+	stopwatch_t stopwatch;
+	tcp_conn_t *cconn;
+	errno_t rc;
+
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count++) {
+		stopwatch_init(&stopwatch);
+		stopwatch_start(&stopwatch);
+
+		if (!client_connect(run, &cconn))
+			return false;
+
+		rc = client_close(cconn);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed closing "
+			    "connection: %s", str_error(rc));
+		}
+
+		stopwatch_stop(&stopwatch);
+		bench_run_latency_add(run, stopwatch_get_nanos(&stopwatch));
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_tcp_stream = {
+	.name = "tcp_stream",
+	.desc = "TCP bulk transfer (use 'peer', 'port' and 'size' params "
+	    "to alter the defaults).",
+	.entry = &stream_runner,
+	.setup = &stream_setup,
+	.teardown = &teardown_conn
+};
+
+benchmark_t benchmark_tcp_rr = {
+	.name = "tcp_rr",
+	.desc = "TCP request/response round trips (use 'peer', 'port' and "
+	    "'size' params to alter the defaults).",
+	.entry = &rr_runner,
+	.setup = &rr_setup,
+	.teardown = &teardown_conn
+};
+
+benchmark_t benchmark_conn_rate = {
+	.name = "conn_rate",
+	.desc = "TCP connection setup and teardown (use 'peer' and 'port' "
+	    "params to alter the defaults).",
+	.entry = &conn_rate_runner,
+	.setup = &conn_rate_setup,
+	.teardown = &teardown_common
+};
+
+/** @}
+ */
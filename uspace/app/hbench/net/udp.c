@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <inet/hostport.h>
+#include <inet/udp.h>
+#include <inttypes.h>
+#include <macros.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Rate of small UDP datagrams. Datagrams of "size" bytes are sent in
+ * batches of "batch". Unless the "peer" parameter gives the host:port of
+ * a remote receiver, hbench receives the datagrams itself over loopback
+ * on the port given by the "port" parameter. In that case at most
+ * "window" datagrams are in flight, so that the service does not drop
+ * them, and the run ends once all of them were received.
+ */
+
+#define MESSAGE_SIZE_MAX  1472
+#define BATCH_MAX  64
+
+/** How long to wait for a datagram before considering it lost */
+#define RECV_TIMEOUT  SEC2USEC(1)
+
+static udp_t *udp = NULL;
+static udp_assoc_t *sender = NULL;
+static udp_assoc_t *receiver = NULL;
+static size_t msg_size;
+static size_t batch;
+static uint64_t window;
+static char *msg_buf = NULL;
+
+/** Protects received */
+static FIBRIL_MUTEX_INITIALIZE(recv_lock);
+/** Signalled when a datagram is received */
+static FIBRIL_CONDVAR_INITIALIZE(recv_cv);
+/** Number of datagrams received */
+static uint64_t received;
+
+static void recv_msg(udp_assoc_t *, udp_rmsg_t *);
+
+static udp_cb_t recv_cb = {
+	.recv_msg = recv_msg
+};
+
+static void recv_msg(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
+{
+	fibril_mutex_lock(&recv_lock);
+	++received;
+	fibril_condvar_broadcast(&recv_cv);
+	fibril_mutex_unlock(&recv_lock);
+}
+
+/** Wait until at most @a pending of sent datagrams are not received. */
+static errno_t recv_wait(uint64_t sent, uint64_t pending)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&recv_lock);
+	while (received + pending < sent && rc == EOK)
+		rc = fibril_condvar_wait_timeout(&recv_cv, &recv_lock,
+		    RECV_TIMEOUT);
+	fibril_mutex_unlock(&recv_lock);
+
+	return rc;
+}
+
+static bool parse_size(bench_env_t *env, bench_run_t *run, const char *name,
+    const char *def, size_t max, size_t *value)
+{
+	const char *str = bench_env_param_get(env, name, def);
+	*value = strtoul(str, NULL, 10);
+	if (*value == 0 || *value > max) {
+		return bench_run_fail(run, "invalid %s %s (must be between "
+		    "1 and %zu)", name, str, max);
+	}
+
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	udp_assoc_destroy(sender);
+	sender = NULL;
+	udp_assoc_destroy(receiver);
+	receiver = NULL;
+	udp_destroy(udp);
+	udp = NULL;
+	free(msg_buf);
+	msg_buf = NULL;
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	const char *peer_str = bench_env_param_get(env, "peer", NULL);
+	const char *errmsg;
+	size_t value;
+	inet_ep2_t epp;
+	errno_t rc;
+
+	if (!parse_size(env, run, "size", "64", MESSAGE_SIZE_MAX, &msg_size))
+		return false;
+	if (!parse_size(env, run, "batch", "16", BATCH_MAX, &batch))
+		return false;
+	if (!parse_size(env, run, "window", "64", UINT32_MAX, &value))
+		return false;
+	window = max(value, batch);
+
+	msg_buf = calloc(1, msg_size);
+	if (msg_buf == NULL) {
+		return bench_run_fail(run, "failed to allocate %zuB buffer",
+		    msg_size);
+	}
+
+	rc = udp_create(&udp);
+	if (rc != EOK) {
+		free(msg_buf);
+		msg_buf = NULL;
+		return bench_run_fail(run, "failed contacting UDP service: %s",
+		    str_error(rc));
+	}
+
+	inet_ep2_init(&epp);
+
+	if (peer_str != NULL) {
+		rc = inet_hostport_plookup_one(peer_str, ip_any, &epp.remote,
+		    NULL, &errmsg);
+		if (rc != EOK) {
+			teardown(env, run);
+			return bench_run_fail(run, "invalid peer %s: %s",
+			    peer_str, errmsg);
+		}
+	} else {
+		const char *port_str = bench_env_param_get(env, "port", "5001");
+		inet_ep2_t repp;
+
+		inet_ep2_init(&repp);
+		inet_addr(&repp.local.addr, 127, 0, 0, 1);
+		repp.local.port = strtoul(port_str, NULL, 10);
+
+		rc = udp_assoc_create(udp, &repp, &recv_cb, NULL, &receiver);
+		if (rc != EOK) {
+			teardown(env, run);
+			return bench_run_fail(run, "failed listening on port "
+			    "%s: %s", port_str, str_error(rc));
+		}
+
+		epp.remote = repp.local;
+		received = 0;
+	}
+
+	rc = udp_assoc_create(udp, &epp, NULL, NULL, &sender);
+	if (rc != EOK) {
+		teardown(env, run);
+		return bench_run_fail(run, "failed creating association: %s",
+		    str_error(rc));
+	}
+
+	return true;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	udp_smsg_t msgs[BATCH_MAX];
+	uint64_t sent = 0;
+	uint64_t first = received;
+	size_t nsent;
+	size_t n;
+	errno_t rc;
+
+	for (n = 0; n < batch; n++) {
+		msgs[n].dest = NULL;
+		msgs[n].data = msg_buf;
+		msgs[n].size = msg_size;
+	}
+
+	bench_run_start(run);
+
+	while (sent < niter) {
+		if (receiver != NULL) {
+			rc = recv_wait(first + sent, window - batch);
+			if (rc != EOK) {
+				return bench_run_fail(run, "datagrams lost "
+				    "(%" PRIu64 " of %" PRIu64 " received)",
+				    received - first, sent);
+			}
+		}
+
+		n = min(batch, niter - sent);
+		rc = udp_assoc_send_batch(sender, msgs, n, &nsent);
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending datagrams: "
+			    "%s", str_error(rc));
+		}
+
+		sent += nsent;
+	}
+
+	if (receiver != NULL) {
+		rc = recv_wait(first + sent, 0);
+		if (rc != EOK) {
+			return bench_run_fail(run, "datagrams lost "
+			    "(%" PRIu64 " of %" PRIu64 " received)",
+			    received - first, sent);
+		}
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
+benchmark_t benchmark_udp_pps = {
+	.name = "udp_pps",
+	.desc = "UDP small datagram rate (use 'peer', 'port', 'size', "
+	    "'batch' and 'window' params to alter the defaults).",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -94,7 +94,8 @@ benchmark_t benchmark_fibril_mutex = {
 	.desc = "Speed of mutex lock/unlock operations",
 	.entry = &runner,
 	.setup = NULL,
-	.teardown = NULL
+	.teardown = NULL,
+	.parallel = true
 };
 
 /** @}
@@ -33,8 +33,12 @@
  * @file
  */
 
+#include <bitops.h>
+#include <math.h>
+#include <mem.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <time.h>
 #include "hbench.h"
 
 /** Initialize bench run structure.
@@ -48,6 +52,8 @@ void bench_run_init(bench_run_t *run, char *error_buffer, size_t error_buffer_si
 	stopwatch_init(&run->stopwatch);
 	run->error_message = error_buffer;
 	run->error_message_buffer_size = error_buffer_size;
+	run->latency_count = 0;
+	memset(run->latency_hist, 0, sizeof(run->latency_hist));
 }
 
 /** Format error message on benchmark failure.
@@ -75,5 +81,123 @@ bool bench_run_fail(bench_run_t *run, const char *fmt, ...)
 	return false;
 }
 
+/** Get latency histogram bucket of a duration. */
+static unsigned int latency_bucket(uint64_t nanos)
+{
+	if (nanos < BENCH_LATENCY_SUB_COUNT)
+		return nanos;
+
+	unsigned int shift = fnzb64(nanos) - BENCH_LATENCY_SUB_BITS;
+	return (shift + 1) * BENCH_LATENCY_SUB_COUNT +
+	    ((nanos >> shift) & (BENCH_LATENCY_SUB_COUNT - 1));
+}
+
+/** Get the longest duration falling into a latency histogram bucket. */
+static uint64_t latency_bucket_max(unsigned int bucket)
+{
+	if (bucket < BENCH_LATENCY_SUB_COUNT)
+		return bucket;
+
+	unsigned int shift = bucket / BENCH_LATENCY_SUB_COUNT - 1;
+	uint64_t first = BENCH_LATENCY_SUB_COUNT +
+	    bucket % BENCH_LATENCY_SUB_COUNT;
+	return ((first + 1) << shift) - 1;
+}
+
+/** Record latency of a single operation.
+ *
+ * Runners that measure their operations one by one call this for each
+ * of them, so that latency percentiles can be reported next to the
+ * duration of the whole run.
+ *
+ * @param run Current benchmark run.
+ * @param nanos Duration of the operation in nanoseconds.
+ */
+void bench_run_latency_add(bench_run_t *run, nsec_t nanos)
+{
+	if (nanos < 0)
+		nanos = 0;
+
+	run->latency_hist[latency_bucket(nanos)]++;
+	run->latency_count++;
+}
+
+/** Get latency percentile of a run.
+ *
+ * @param run Benchmark run.
+ * @param permille Requested percentile in tenths of a percent (e.g. 990).
+ * @param nanos Where to store the latency in nanoseconds.
+ * @return Whether the runner recorded any latencies.
+ */
+bool bench_run_latency_get(bench_run_t *run, unsigned int permille,
+    nsec_t *nanos)
+{
+	if (run->latency_count == 0)
+		return false;
+
+	uint64_t rank = (run->latency_count * permille + 999) / 1000;
+	if (rank == 0)
+		rank = 1;
+
+	uint64_t seen = 0;
+	unsigned int bucket;
+	for (bucket = 0; bucket < BENCH_LATENCY_BUCKETS - 1; bucket++) {
+		seen += run->latency_hist[bucket];
+		if (seen >= rank)
+			break;
+	}
+
+	*nanos = (nsec_t) latency_bucket_max(bucket);
+	return true;
+}
+
+/** Add performance data of a run to another one.
+ *
+ * Used to combine runs executed in parallel on several threads. The
+ * resulting run lasts from the earliest start to the latest stop and its
+ * latency histogram covers operations of both runs.
+ *
+ * @param run Run to add to, its stopwatch must be already set.
+ * @param other Run to add.
+ */
+void bench_run_merge(bench_run_t *run, bench_run_t *other)
+{
+	if (ts_gt(&run->stopwatch.start, &other->stopwatch.start))
+		run->stopwatch.start = other->stopwatch.start;
+	if (ts_gt(&other->stopwatch.end, &run->stopwatch.end))
+		run->stopwatch.end = other->stopwatch.end;
+
+	for (unsigned int i = 0; i < BENCH_LATENCY_BUCKETS; i++)
+		run->latency_hist[i] += other->latency_hist[i];
+	run->latency_count += other->latency_count;
+}
+
+/** Estimate square root value.
+ *
+ * @param value The value to compute square root of.
+ * @param precision Required precision (e.g. 0.00001).
+ *
+ * @details
+ *
+ * This is a temporary solution until we have proper sqrt() implementation
+ * in libmath.
+ *
+ * The algorithm uses Babylonian method [1].
+ *
+ * [1] https://en.wikipedia.org/wiki/Methods_of_computing_square_roots#Babylonian_method
+ */
+double estimate_square_root(double value, double precision)
+{
+	double estimate = 1.;
+	double prev_estimate = estimate + 10 * precision;
+
+	while (fabs(estimate - prev_estimate) > precision) {
+		prev_estimate = estimate;
+		estimate = (prev_estimate + value / prev_estimate) / 2.;
+	}
+
+	return estimate;
+}
+
 /** @}
  */
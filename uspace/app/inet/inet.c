@@ -37,6 +37,8 @@
 #include <errno.h>
 #include <inet/addr.h>
 #include <inet/inetcfg.h>
+#include <inet/tcp.h>
+#include <inttypes.h>
 #include <io/table.h>
 #include <loc.h>
 #include <stdio.h>
@@ -58,6 +60,8 @@ static void print_syntax(void)
 	printf("  %s create-sr <dest-addr>/<width> <router-addr> <route-name>\n", NAME);
 	printf("  %s delete-sr <route-name>\n", NAME);
 	printf("  %s list-link\n", NAME);
+	printf("  %s list-tcp\n", NAME);
+	printf("  %s show-reass\n", NAME);
 }
 
 static errno_t addr_create_static(int argc, char *argv[])
@@ -482,6 +486,117 @@ out:
 	return rc;
 }
 
+static errno_t tcp_list(void)
+{
+	tcp_t *tcp = NULL;
+	tcp_conn_info_t *info = NULL;
+	table_t *table = NULL;
+
+	size_t count;
+	size_t i;
+	errno_t rc;
+	char *lstr = NULL;
+	char *rstr = NULL;
+
+	rc = tcp_create(&tcp);
+	if (rc != EOK) {
+		printf(NAME ": Failed connecting to TCP service.\n");
+		return rc;
+	}
+
+	rc = tcp_conn_info_list(tcp, &info, &count);
+	if (rc != EOK) {
+		printf(NAME ": Failed getting connection list.\n");
+		goto out;
+	}
+
+	rc = table_create(&table);
+	if (rc != EOK) {
+		printf("Memory allocation failed.\n");
+		goto out;
+	}
+
+	table_header_row(table);
+	table_printf(table, "Local\t" "Remote\t" "Seg-Sent\t" "Seg-Rcvd\t"
+	    "Rexmit\t" "Bytes-Sent\t" "Bytes-Rcvd\t" "ACK-Sent\t"
+	    "ACK-Delayed\n");
+
+	for (i = 0; i < count; i++) {
+		rc = inet_addr_format(&info[i].epp.local.addr, &lstr);
+		if (rc != EOK) {
+			printf("Memory allocation failed.\n");
+			lstr = NULL;
+			goto out;
+		}
+
+		rc = inet_addr_format(&info[i].epp.remote.addr, &rstr);
+		if (rc != EOK) {
+			printf("Memory allocation failed.\n");
+			rstr = NULL;
+			goto out;
+		}
+
+		table_printf(table, "%s:%u\t" "%s:%u\t" "%" PRIu64 "\t"
+		    "%" PRIu64 "\t" "%" PRIu64 "\t" "%" PRIu64 "\t"
+		    "%" PRIu64 "\t" "%" PRIu64 "\t" "%" PRIu64 "\n",
+		    lstr, (unsigned) info[i].epp.local.port,
+		    rstr, (unsigned) info[i].epp.remote.port,
+		    info[i].stats.seg_sent, info[i].stats.seg_rcvd,
+		    info[i].stats.seg_rexmit, info[i].stats.bytes_sent,
+		    info[i].stats.bytes_rcvd, info[i].stats.ack_sent,
+		    info[i].stats.ack_delayed);
+
+		free(lstr);
+		free(rstr);
+
+		lstr = NULL;
+		rstr = NULL;
+	}
+
+	if (count != 0) {
+		rc = table_print_out(table, stdout);
+		if (rc != EOK) {
+			printf("Error printing table.\n");
+			goto out;
+		}
+	}
+
+	rc = EOK;
+out:
+	table_destroy(table);
+	if (lstr != NULL)
+		free(lstr);
+	if (rstr != NULL)
+		free(rstr);
+
+	free(info);
+	tcp_destroy(tcp);
+
+	return rc;
+}
+
+static errno_t reass_show(void)
+{
+	inet_reass_stats_t stats;
+	errno_t rc;
+
+	rc = inetcfg_reass_stats(&stats);
+	if (rc != EOK) {
+		printf(NAME ": Failed getting reassembly statistics.\n");
+		return rc;
+	}
+
+	printf("Fragments received: %" PRIu64 "\n", stats.frags);
+	printf("Fragments dropped: %" PRIu64 "\n", stats.frags_dropped);
+	printf("Datagrams reassembled: %" PRIu64 "\n", stats.reassembled);
+	printf("Reassembly timeouts: %" PRIu64 "\n", stats.timeouts);
+	printf("Datagrams evicted: %" PRIu64 "\n", stats.evicted);
+	printf("Datagrams in progress: %zu (%zu bytes)\n", stats.dgrams,
+	    stats.mem);
+
+	return EOK;
+}
+
 int main(int argc, char *argv[])
 {
 	errno_t rc;
@@ -526,6 +641,14 @@ int main(int argc, char *argv[])
 		rc = link_list();
 		if (rc != EOK)
 			return 1;
+	} else if (str_cmp(argv[1], "list-tcp") == 0) {
+		rc = tcp_list();
+		if (rc != EOK)
+			return 1;
+	} else if (str_cmp(argv[1], "show-reass") == 0) {
+		rc = reass_show();
+		if (rc != EOK)
+			return 1;
 	} else {
 		printf(NAME ": Unknown command '%s'.\n", argv[1]);
 		print_syntax();
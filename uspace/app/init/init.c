@@ -164,8 +164,9 @@ static bool mount_root(const char *fstype)
  */
 static bool mount_locfs(void)
 {
+	/* Names in locfs come and go without VFS noticing. */
 	errno_t rc = vfs_mount_path(LOCFS_MOUNT_POINT, LOCFS_FS_TYPE, "", "",
-	    IPC_FLAG_BLOCKING, 0);
+	    IPC_FLAG_BLOCKING | VFS_MOUNT_NO_DCACHE, 0);
 	return mount_report("Location service file system", LOCFS_MOUNT_POINT,
 	    LOCFS_FS_TYPE, NULL, rc);
 }
@@ -410,6 +411,9 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
+	/* Allow the following tasks to share their read-only segments. */
+	srv_start("/srv/ldcache");
+
 	/* Make sure file systems are running. */
 	if (str_cmp(STRING(RDFMT), "tmpfs") != 0)
 		srv_start("/srv/fs/tmpfs");
@@ -448,6 +452,7 @@ int main(int argc, char *argv[])
 	srv_start("/srv/net/nconfsrv");
 
 	srv_start("/srv/clipboard");
+	srv_start("/srv/pipe");
 	srv_start("/srv/hid/remcons");
 
 	srv_start("/srv/hid/input", HID_INPUT);
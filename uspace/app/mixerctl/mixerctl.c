@@ -38,6 +38,7 @@
 #include <str_error.h>
 #include <str.h>
 #include <audio_mixer_iface.h>
+#include <hound/protocol.h>
 #include <stdio.h>
 
 #define DEFAULT_SERVICE "devices/\\hw\\pci0\\00:01.0\\sb16\\control"
@@ -125,11 +126,40 @@ static void get_level(async_exch_t *exch, int argc, char *argv[])
 	printf("Control item %u level: %u.\n", item, value);
 }
 
+/**
+ * Print playback statistics of the audio server.
+ * @return Exit code.
+ */
+static int print_hound_stats(void)
+{
+	hound_sess_t *sess = hound_service_connect(HOUND_SERVICE);
+	if (!sess) {
+		printf("Failed to connect to the audio server.\n");
+		return 1;
+	}
+
+	hound_stats_t stats;
+	const errno_t ret = hound_service_get_stats(sess, &stats);
+	hound_service_disconnect(sess);
+	if (ret != EOK) {
+		printf("Failed to get audio server statistics: %s.\n",
+		    str_error(ret));
+		return 1;
+	}
+
+	printf("Stream underruns: %zu.\n", stats.underruns);
+	printf("Buffered audio: %lld usec.\n", stats.latency);
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	const char *service = DEFAULT_SERVICE;
 	void (*command)(async_exch_t *, int, char *[]) = NULL;
 
+	if (argc >= 2 && str_cmp(argv[1], "hound") == 0)
+		return print_hound_stats();
+
 	if (argc >= 2 && str_cmp(argv[1], "setlevel") == 0) {
 		command = set_level;
 		if (argc == 5)
@@ -175,6 +205,8 @@ int main(int argc, char *argv[])
 		    "settings\n", argv[0]);
 		printf("Use '%s setlevel idx' command to change "
 		    "settings\n", argv[0]);
+		printf("Use '%s hound' command to show audio server "
+		    "statistics\n", argv[0]);
 	}
 
 	async_exchange_end(exch);
@@ -58,6 +58,7 @@ int main(int argc, char **argv)
 	unsigned int bsize = 4096;
 
 	cfg.version = ext4_def_fs_version;
+	cfg.lazy_itable_init = false;
 
 	if (argc < 2) {
 		printf(NAME ": Error, argument missing.\n");
@@ -148,6 +149,14 @@ int main(int argc, char **argv)
 			continue;
 		}
 
+		if (str_cmp(*argv, "--lazy-itable-init") == 0) {
+			cfg.lazy_itable_init = true;
+
+			--argc;
+			++argv;
+			continue;
+		}
+
 		if (str_cmp(*argv, "--help") == 0) {
 			syntax_print();
 			return 0;
@@ -201,7 +210,8 @@ static void syntax_print(void)
 	    "\t--size <sectors> Filesystem size, overrides device size\n"
 	    "\t--label <label>  Volume label\n"
 	    "\t--type <fstype>  Filesystem type (ext2, ext2old)\n"
-	    "\t--bsize <bytes>  Filesystem block size in bytes (default = 4096)\n");
+	    "\t--bsize <bytes>  Filesystem block size in bytes (default = 4096)\n"
+	    "\t--lazy-itable-init Zero inode tables after the first mount\n");
 }
 
 static errno_t ext4_version_parse(const char *str, ext4_cfg_ver_t *ver)
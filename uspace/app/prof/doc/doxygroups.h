@@ -0,0 +1,4 @@
+/** @addtogroup prof prof
+ * @brief Sampling profiler
+ * @ingroup apps
+ */
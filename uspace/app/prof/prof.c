@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup prof
+ * @{
+ */
+/**
+ * @file
+ * @brief Sampling profiler.
+ *
+ * Enables the kernel sampling profiler for a period of time, collects
+ * the samples from the per-CPU sample buffers and prints them as folded
+ * stacks, one unique stack per line followed by the number of samples.
+ * The output can be fed directly to flame graph generators.
+ */
+
+#include <as.h>
+#include <barrier.h>
+#include <ddi.h>
+#include <errno.h>
+#include <fibril.h>
+#include <inttypes.h>
+#include <mem.h>
+#include <profile.h>
+#include <stats.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+#include <sysinfo.h>
+
+#define NAME  "prof"
+
+/** Default profiling period (in seconds) */
+#define PROF_DEFAULT_DURATION  5
+
+/** Polling period of the sample buffers (in microseconds) */
+#define PROF_POLL_PERIOD  100000
+
+/** Size of the buffer for a kernel symbol name */
+#define PROF_SYMBOL_BUFLEN  128
+
+static uint8_t *prof_buffers;
+static size_t prof_buffer_size;
+
+/** Collected samples */
+static profile_sample_t *samples;
+static size_t samples_count;
+static size_t samples_size;
+
+/** Number of samples overwritten before they could be collected */
+static uint64_t samples_lost;
+
+static stats_task_t *tasks;
+static size_t tasks_count;
+
+static profile_buffer_t *prof_buffer(size_t cpu)
+{
+	return (profile_buffer_t *) (prof_buffers + cpu * prof_buffer_size);
+}
+
+static errno_t prof_store(profile_sample_t *sample)
+{
+	if (samples_count == samples_size) {
+		size_t size = (samples_size == 0) ? 1024 : 2 * samples_size;
+		profile_sample_t *tmp = realloc(samples,
+		    size * sizeof(profile_sample_t));
+		if (tmp == NULL)
+			return ENOMEM;
+
+		samples = tmp;
+		samples_size = size;
+	}
+
+	samples[samples_count++] = *sample;
+	return EOK;
+}
+
+/** Collect new samples of a sample buffer
+ *
+ * @param buf  Sample buffer.
+ * @param tail Sequence number of the next sample to collect, updated.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t prof_collect(profile_buffer_t *buf, uint64_t *tail)
+{
+	uint64_t head = buf->head;
+	read_barrier();
+
+	if (head - *tail > buf->count) {
+		samples_lost += head - *tail - buf->count;
+		*tail = head - buf->count;
+	}
+
+	while (*tail < head) {
+		profile_sample_t *slot = &buf->samples[*tail % buf->count];
+		uint64_t seq = slot->seq;
+		read_barrier();
+
+		profile_sample_t sample = *slot;
+
+		read_barrier();
+		if ((seq != *tail + 1) || (slot->seq != seq)) {
+			/* Overwritten while being read */
+			samples_lost++;
+		} else {
+			if (sample.depth > PROFILE_STACK_DEPTH)
+				sample.depth = PROFILE_STACK_DEPTH;
+			if (sample.kdepth > sample.depth)
+				sample.kdepth = sample.depth;
+
+			errno_t rc = prof_store(&sample);
+			if (rc != EOK)
+				return rc;
+		}
+
+		(*tail)++;
+	}
+
+	return EOK;
+}
+
+/** Order samples so that identical stacks are adjacent */
+static int prof_sample_cmp(const void *a, const void *b)
+{
+	const profile_sample_t *sa = a;
+	const profile_sample_t *sb = b;
+
+	if (sa->task_id != sb->task_id)
+		return (sa->task_id < sb->task_id) ? -1 : 1;
+
+	if (sa->flags != sb->flags)
+		return (sa->flags < sb->flags) ? -1 : 1;
+
+	if (sa->depth != sb->depth)
+		return (sa->depth < sb->depth) ? -1 : 1;
+
+	if (sa->kdepth != sb->kdepth)
+		return (sa->kdepth < sb->kdepth) ? -1 : 1;
+
+	for (unsigned int i = 0; i < sa->depth; i++) {
+		if (sa->pc[i] != sb->pc[i])
+			return (sa->pc[i] < sb->pc[i]) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+static const char *prof_task_name(uint64_t task_id)
+{
+	for (size_t i = 0; i < tasks_count; i++) {
+		if (tasks[i].task_id == task_id)
+			return tasks[i].name;
+	}
+
+	return "unknown";
+}
+
+/** Print a stack in the folded format, outermost frame first */
+static void prof_print_stack(profile_sample_t *sample, size_t count)
+{
+	if (sample->flags & PROFILE_SAMPLE_IDLE)
+		printf("idle");
+	else
+		printf("%s", prof_task_name(sample->task_id));
+
+	/* User space frames are not symbolized. */
+	for (unsigned int i = sample->depth; i > sample->kdepth; i--)
+		printf(";[user 0x%" PRIx64 "]", sample->pc[i - 1]);
+
+	for (unsigned int i = sample->kdepth; i > 0; i--) {
+		char name[PROF_SYMBOL_BUFLEN];
+
+		if (profile_kernel_symbol(sample->pc[i - 1], name,
+		    sizeof(name)) == EOK)
+			printf(";%s", name);
+		else
+			printf(";[kernel 0x%" PRIx64 "]", sample->pc[i - 1]);
+	}
+
+	printf(" %zu\n", count);
+}
+
+static void prof_print(void)
+{
+	qsort(samples, samples_count, sizeof(profile_sample_t),
+	    prof_sample_cmp);
+
+	size_t i = 0;
+	while (i < samples_count) {
+		size_t j = i + 1;
+		while ((j < samples_count) &&
+		    (prof_sample_cmp(&samples[i], &samples[j]) == 0))
+			j++;
+
+		prof_print_stack(&samples[i], j - i);
+		i = j;
+	}
+}
+
+/** Collect samples for the given number of seconds */
+static errno_t prof_run(unsigned int duration)
+{
+	sysarg_t faddr;
+	sysarg_t cpus;
+	sysarg_t pages;
+
+	errno_t rc = sysinfo_get_value("profile.faddr", &faddr);
+	if (rc == EOK)
+		rc = sysinfo_get_value("profile.cpus", &cpus);
+	if (rc == EOK)
+		rc = sysinfo_get_value("profile.buffer_pages", &pages);
+	if (rc != EOK) {
+		fprintf(stderr, "%s: Kernel profiler is not available\n", NAME);
+		return rc;
+	}
+
+	rc = physmem_map(faddr, cpus * pages, AS_AREA_READ | AS_AREA_CACHEABLE,
+	    (void *) &prof_buffers);
+	if (rc != EOK) {
+		fprintf(stderr, "%s: Unable to map sample buffers: %s\n", NAME,
+		    str_error(rc));
+		return rc;
+	}
+
+	prof_buffer_size = pages * PAGE_SIZE;
+
+	uint64_t *tails = calloc(cpus, sizeof(uint64_t));
+	if (tails == NULL) {
+		physmem_unmap(prof_buffers);
+		return ENOMEM;
+	}
+
+	for (size_t i = 0; i < cpus; i++)
+		tails[i] = prof_buffer(i)->head;
+
+	rc = profile_start();
+	if (rc != EOK) {
+		fprintf(stderr, "%s: Unable to start profiling: %s\n", NAME,
+		    str_error(rc));
+		goto out;
+	}
+
+	usec_t left = (usec_t) duration * 1000000;
+	while ((rc == EOK) && (left > 0)) {
+		usec_t period = (left < PROF_POLL_PERIOD) ? left :
+		    PROF_POLL_PERIOD;
+		fibril_usleep(period);
+		left -= period;
+
+		for (size_t i = 0; (rc == EOK) && (i < cpus); i++)
+			rc = prof_collect(prof_buffer(i), &tails[i]);
+	}
+
+	(void) profile_stop();
+
+	/* Collect the samples taken before profiling stopped. */
+	for (size_t i = 0; (rc == EOK) && (i < cpus); i++)
+		rc = prof_collect(prof_buffer(i), &tails[i]);
+
+	if (rc != EOK) {
+		fprintf(stderr, "%s: Unable to collect samples: %s\n", NAME,
+		    str_error(rc));
+		goto out;
+	}
+
+	tasks = stats_get_tasks(&tasks_count);
+	prof_print();
+
+	if (samples_lost > 0) {
+		fprintf(stderr, "%s: %" PRIu64 " samples lost\n", NAME,
+		    samples_lost);
+	}
+
+out:
+	free(tails);
+	physmem_unmap(prof_buffers);
+	return rc;
+}
+
+static void print_syntax(void)
+{
+	printf("Syntax: %s [<seconds>]\n", NAME);
+	printf("Profile the system for the given number of seconds "
+	    "(default %u)\nand print the samples as folded stacks.\n",
+	    PROF_DEFAULT_DURATION);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int duration = PROF_DEFAULT_DURATION;
+
+	if (argc > 2) {
+		print_syntax();
+		return 1;
+	}
+
+	if (argc == 2) {
+		char *end;
+		duration = strtoul(argv[1], &end, 10);
+		if ((*end != '\0') || (duration == 0)) {
+			print_syntax();
+			return 1;
+		}
+	}
+
+	return (prof_run(duration) == EOK) ? 0 : 1;
+}
+
+/** @}
+ */
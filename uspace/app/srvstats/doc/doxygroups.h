@@ -0,0 +1,4 @@
+/** @addtogroup srvstats srvstats
+ * @brief Show IPC statistics of a server
+ * @ingroup apps
+ */
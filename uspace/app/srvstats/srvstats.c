@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup srvstats
+ * @{
+ */
+/**
+ * @file Show IPC statistics of a server.
+ */
+
+#include <async.h>
+#include <async_stats.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <ipc/services.h>
+#include <loc.h>
+#include <macros.h>
+#include <ns.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str.h>
+#include <str_error.h>
+
+#define NAME  "srvstats"
+
+/** Maximum number of entries shown */
+#define MAX_ENTRIES  128
+
+/** Servers registered at the naming service instead of location service */
+static struct {
+	const char *name;
+	service_t service;
+} ns_services[] = {
+	{ "vfs", SERVICE_VFS },
+	{ "loc", SERVICE_LOC },
+	{ "logger", SERVICE_LOGGER },
+	{ "devman", SERVICE_DEVMAN },
+	{ "ldcache", SERVICE_LDCACHE }
+};
+
+static void print_syntax(void)
+{
+	printf("Syntax: " NAME " [-e|-d|-r] <service>\n");
+	printf("\t-e Enable collecting statistics\n");
+	printf("\t-d Disable collecting statistics\n");
+	printf("\t-r Reset statistics\n");
+	printf("Without an option, collected statistics are shown.\n");
+	printf("<service> is a location service name or one of:");
+	for (size_t i = 0; i < ARRAY_SIZE(ns_services); i++)
+		printf(" %s", ns_services[i].name);
+	printf("\n");
+}
+
+static async_sess_t *connect_server(const char *name)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(ns_services); i++) {
+		if (str_cmp(name, ns_services[i].name) == 0) {
+			return service_connect_blocking(ns_services[i].service,
+			    INTERFACE_ASYNC_STATS, 0);
+		}
+	}
+
+	service_id_t sid;
+	errno_t rc = loc_service_get_id(name, &sid, 0);
+	if (rc != EOK) {
+		printf("Service '%s' not found: %s\n", name, str_error(rc));
+		return NULL;
+	}
+
+	return loc_service_connect(sid, INTERFACE_ASYNC_STATS, 0);
+}
+
+/** Upper bound of a service time percentile in microseconds. */
+static uint64_t hist_percentile(const async_method_stats_t *ms,
+    unsigned int percent)
+{
+	uint64_t limit = (ms->calls * percent + 99) / 100;
+	uint64_t seen = 0;
+
+	for (unsigned int i = 0; i < ASYNC_STATS_BUCKETS; i++) {
+		seen += ms->service_hist[i];
+		if (seen >= limit)
+			return (i == 0) ? 1 : (UINT64_C(1) << i);
+	}
+
+	return ms->service_max_usec;
+}
+
+static errno_t print_methods(async_sess_t *sess)
+{
+	async_method_stats_t *stats =
+	    calloc(MAX_ENTRIES, sizeof(async_method_stats_t));
+	if (stats == NULL)
+		return ENOMEM;
+
+	size_t count;
+	errno_t rc = async_stats_read_methods(sess, stats, MAX_ENTRIES,
+	    &count);
+	if (rc != EOK) {
+		free(stats);
+		return rc;
+	}
+
+	printf("%10s %6s %8s %8s %8s %8s %8s %8s %8s\n", "interface",
+	    "method", "calls", "queue", "maxqueue", "service", "p99",
+	    "maxsrv", "run");
+
+	for (size_t i = 0; i < count; i++) {
+		async_method_stats_t *ms = &stats[i];
+
+		printf("%#10" PRIx32 " %6" PRIun " %8" PRIu64 " %8" PRIu64
+		    " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64
+		    " %8" PRIu64 "\n", (uint32_t) ms->iface, ms->imethod,
+		    ms->calls, ms->queue_usec / ms->calls, ms->queue_max_usec,
+		    ms->service_usec / ms->calls, hist_percentile(ms, 99),
+		    ms->service_max_usec, ms->run_usec / ms->calls);
+	}
+
+	free(stats);
+	return EOK;
+}
+
+static errno_t print_clients(async_sess_t *sess)
+{
+	async_client_stats_t *stats =
+	    calloc(MAX_ENTRIES, sizeof(async_client_stats_t));
+	if (stats == NULL)
+		return ENOMEM;
+
+	size_t count;
+	errno_t rc = async_stats_read_clients(sess, stats, MAX_ENTRIES,
+	    &count);
+	if (rc != EOK) {
+		free(stats);
+		return rc;
+	}
+
+	printf("%8s %10s %8s %8s %12s %12s\n", "task", "interface", "conns",
+	    "calls", "service", "run");
+
+	for (size_t i = 0; i < count; i++) {
+		async_client_stats_t *cs = &stats[i];
+
+		printf("%8" PRIu64 " %#10" PRIx32 " %8" PRIu64 " %8" PRIu64
+		    " %12" PRIu64 " %12" PRIu64 "\n", cs->task_id,
+		    (uint32_t) cs->iface, cs->connections, cs->calls,
+		    cs->service_usec, cs->run_usec);
+	}
+
+	free(stats);
+	return EOK;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *opt = NULL;
+	errno_t rc;
+
+	if ((argc == 3) && (argv[1][0] == '-')) {
+		opt = argv[1];
+		argv++;
+		argc--;
+	}
+
+	if (argc != 2) {
+		print_syntax();
+		return 1;
+	}
+
+	async_sess_t *sess = connect_server(argv[1]);
+	if (sess == NULL) {
+		printf("Failed connecting to '%s'.\n", argv[1]);
+		return 2;
+	}
+
+	if (opt == NULL) {
+		printf("Per-method statistics (times in us):\n");
+		rc = print_methods(sess);
+		if (rc == EOK) {
+			printf("\nPer-client statistics (times in us):\n");
+			rc = print_clients(sess);
+		}
+	} else if (str_cmp(opt, "-e") == 0) {
+		rc = async_stats_enable(sess, true);
+	} else if (str_cmp(opt, "-d") == 0) {
+		rc = async_stats_enable(sess, false);
+	} else if (str_cmp(opt, "-r") == 0) {
+		rc = async_stats_reset(sess);
+	} else {
+		async_hangup(sess);
+		print_syntax();
+		return 1;
+	}
+
+	async_hangup(sess);
+
+	if (rc != EOK) {
+		printf("Request failed: %s\n", str_error(rc));
+		return 3;
+	}
+
+	return 0;
+}
+
+/** @}
+ */
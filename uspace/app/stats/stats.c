@@ -62,7 +62,7 @@ static void list_tasks(void)
 	}
 
 	printf("[taskid] [thrds] [resident] [virtual] [ucycles]"
-	    " [kcycles] [name\n");
+	    " [kcycles] [faults] [name\n");
 
 	size_t i;
 	for (i = 0; i < count; i++) {
@@ -81,10 +81,11 @@ static void list_tasks(void)
 		order_suffix(stats_tasks[i].kcycles, &kcycles, &ksuffix);
 
 		printf("%-8" PRIu64 " %7zu %7" PRIu64 "%s %6" PRIu64 "%s"
-		    " %8" PRIu64 "%c %8" PRIu64 "%c %s\n",
+		    " %8" PRIu64 "%c %8" PRIu64 "%c %8" PRIu64 " %s\n",
 		    stats_tasks[i].task_id, stats_tasks[i].threads,
 		    resmem, resmem_suffix, virtmem, virtmem_suffix,
-		    ucycles, usuffix, kcycles, ksuffix, stats_tasks[i].name);
+		    ucycles, usuffix, kcycles, ksuffix,
+		    stats_tasks[i].page_faults, stats_tasks[i].name);
 	}
 
 	free(stats_tasks);
@@ -139,7 +140,8 @@ static void list_cpus(void)
 		return;
 	}
 
-	printf("[id] [MHz     ] [busy cycles] [idle cycles]\n");
+	printf("[id] [MHz     ] [busy cycles] [idle cycles] "
+	    "[frame cache hits] [misses]\n");
 
 	size_t i;
 	for (i = 0; i < count; i++) {
@@ -151,16 +153,56 @@ static void list_cpus(void)
 			order_suffix(cpus[i].busy_cycles, &bcycles, &bsuffix);
 			order_suffix(cpus[i].idle_cycles, &icycles, &isuffix);
 
-			printf("%10" PRIu16 " %12" PRIu64 "%c %12" PRIu64 "%c\n",
+			printf("%10" PRIu16 " %12" PRIu64 "%c %12" PRIu64 "%c "
+			    "%18" PRIu64 " %8" PRIu64 "\n",
 			    cpus[i].frequency_mhz, bcycles, bsuffix,
-			    icycles, isuffix);
+			    icycles, isuffix, cpus[i].frame_cache_hits,
+			    cpus[i].frame_cache_misses);
 		} else
 			printf("inactive\n");
 	}
 
+	printf("\n[id] [threads created] [destroyed] [new stacks] "
+	    "[FPU contexts]\n");
+
+	for (i = 0; i < count; i++) {
+		printf("%-4u %17" PRIu64 " %11" PRIu64 " %12" PRIu64
+		    " %14" PRIu64 "\n", cpus[i].id, cpus[i].threads_created,
+		    cpus[i].threads_destroyed, cpus[i].kstacks_allocated,
+		    cpus[i].fpu_contexts_allocated);
+	}
+
 	free(cpus);
 }
 
+static void list_memory_nodes(void)
+{
+	size_t count;
+	stats_physmem_node_t *nodes = stats_get_physmem_nodes(&count);
+
+	if (nodes == NULL) {
+		fprintf(stderr, "%s: Unable to get memory statistics\n", NAME);
+		return;
+	}
+
+	printf("[node] [total     ] [used      ] [free      ]\n");
+
+	for (size_t i = 0; i < count; i++) {
+		uint64_t total, used, free_mem;
+		const char *tsuffix, *usuffix, *fsuffix;
+
+		bin_order_suffix(nodes[i].total, &total, &tsuffix, false);
+		bin_order_suffix(nodes[i].used, &used, &usuffix, false);
+		bin_order_suffix(nodes[i].free, &free_mem, &fsuffix, false);
+
+		printf("%-6u %8" PRIu64 " %s %8" PRIu64 " %s %8" PRIu64 " %s\n",
+		    nodes[i].node, total, tsuffix, used, usuffix,
+		    free_mem, fsuffix);
+	}
+
+	free(nodes);
+}
+
 static void print_load(void)
 {
 	size_t count;
@@ -199,7 +241,7 @@ static void print_uptime(void)
 static void usage(const char *name)
 {
 	printf(
-	    "Usage: %s [-t task_id] [-a] [-c] [-l] [-u]\n"
+	    "Usage: %s [-t task_id] [-a] [-c] [-m] [-l] [-u]\n"
 	    "\n"
 	    "Options:\n"
 	    "\t-t task_id\n"
@@ -214,6 +256,10 @@ static void usage(const char *name)
 	    "\t--cpus\n"
 	    "\t\tList CPUs\n"
 	    "\n"
+	    "\t-m\n"
+	    "\t--memory\n"
+	    "\t\tList memory nodes\n"
+	    "\n"
 	    "\t-l\n"
 	    "\t--load\n"
 	    "\t\tPrint system load\n"
@@ -236,6 +282,7 @@ int main(int argc, char *argv[])
 	bool toggle_threads = false;
 	bool toggle_all = false;
 	bool toggle_cpus = false;
+	bool toggle_memory = false;
 	bool toggle_load = false;
 	bool toggle_uptime = false;
 
@@ -266,6 +313,13 @@ int main(int argc, char *argv[])
 			continue;
 		}
 
+		/* Memory nodes */
+		if ((off = arg_parse_short_long(argv[i], "-m", "--memory")) != -1) {
+			toggle_tasks = false;
+			toggle_memory = true;
+			continue;
+		}
+
 		/* Threads */
 		if ((off = arg_parse_short_long(argv[i], "-t", "--task=")) != -1) {
 			// TODO: Support for 64b range
@@ -307,6 +361,9 @@ int main(int argc, char *argv[])
 	if (toggle_cpus)
 		list_cpus();
 
+	if (toggle_memory)
+		list_memory_nodes();
+
 	if (toggle_load)
 		print_load();
 
@@ -32,21 +32,268 @@
 /** @file File manipulation utility functions for installer
  */
 
+#include <adt/list.h>
+#include <block.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <mem.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
 #include <vfs/vfs.h>
-#include <dirent.h>
 
 #include "futil.h"
 
-#define BUF_SIZE 16384
-static char buf[BUF_SIZE];
+/** Size of a chunk of a large file copy */
+#define COPY_CHUNK_SIZE (1024 * 1024)
+
+/** Files up to this size are copied by the worker fibrils */
+#define SMALL_FILE_SIZE (64 * 1024)
+
+/** Number of fibrils copying small files */
+#define COPY_WORKERS 4
+
+/** Maximum number of small files waiting to be copied */
+#define COPY_QUEUE_MAX 64
+
+/** Write a chunk of data to the destination of a copy.
+ *
+ * The buffer holding the data is COPY_CHUNK_SIZE bytes long and may be
+ * modified.
+ */
+typedef errno_t (*futil_write_t)(void *, aoff64_t, void *, size_t);
+
+/** Double-buffered copy
+ *
+ * While the writer fibril writes one chunk, the next one is being read
+ * into the other buffer.
+ */
+typedef struct {
+	fibril_mutex_t lock;
+	/** Signalled when a buffer is filled or freed */
+	fibril_condvar_t cv;
+	/** Chunk buffers */
+	char *buf[2];
+	/** Number of bytes in each buffer, zero if the buffer is free */
+	size_t size[2];
+	/** Destination position of each buffer */
+	aoff64_t pos[2];
+	/** No more chunks will be filled */
+	bool eof;
+	/** The writer fibril has finished */
+	bool done;
+	/** First write error */
+	errno_t rc;
+	/** Write operation */
+	futil_write_t write;
+	/** Argument to the write operation */
+	void *arg;
+} futil_dbuf_t;
+
+/** Pending copy of a small file */
+typedef struct {
+	/** Link to futil_pool_t.jobs */
+	link_t ljobs;
+	/** Source path */
+	char *srcp;
+	/** Destination path */
+	char *destp;
+} futil_job_t;
+
+struct futil_pool;
+
+/** Fibril copying small files */
+typedef struct {
+	/** Containing pool */
+	struct futil_pool *pool;
+	/** Copy buffer, SMALL_FILE_SIZE bytes long */
+	char *buf;
+} futil_worker_t;
+
+/** Fibrils copying small files in parallel */
+typedef struct futil_pool {
+	fibril_mutex_t lock;
+	/** Signalled when a job is queued or taken or a worker exits */
+	fibril_condvar_t cv;
+	/** Queued jobs (futil_job_t) */
+	list_t jobs;
+	/** Number of queued jobs */
+	size_t njobs;
+	/** Number of running workers */
+	size_t running;
+	/** No more jobs will be queued */
+	bool stop;
+	/** First error */
+	errno_t rc;
+	/** Workers */
+	futil_worker_t worker[COPY_WORKERS];
+} futil_pool_t;
+
+/** Block device being written by an image copy */
+typedef struct {
+	service_id_t sid;
+	/** Block size */
+	size_t bsize;
+} futil_bdev_t;
+
+/** Write the chunks filled by futil_copy_data(). */
+static errno_t futil_dbuf_writer(void *arg)
+{
+	futil_dbuf_t *db = (futil_dbuf_t *) arg;
+	unsigned i = 0;
+	errno_t rc;
+
+	fibril_mutex_lock(&db->lock);
+
+	while (true) {
+		while (db->size[i] == 0 && !db->eof)
+			fibril_condvar_wait(&db->cv, &db->lock);
+
+		if (db->size[i] == 0)
+			break;
+
+		/* After an error the chunks are only discarded */
+		if (db->rc == EOK) {
+			fibril_mutex_unlock(&db->lock);
+			rc = db->write(db->arg, db->pos[i], db->buf[i],
+			    db->size[i]);
+			fibril_mutex_lock(&db->lock);
+
+			if (rc != EOK)
+				db->rc = rc;
+		}
+
+		db->size[i] = 0;
+		fibril_condvar_broadcast(&db->cv);
+		i = 1 - i;
+	}
+
+	db->done = true;
+	fibril_condvar_broadcast(&db->cv);
+	fibril_mutex_unlock(&db->lock);
+	return EOK;
+}
+
+/** Copy file data with reading overlapped with writing.
+ *
+ * @param sf File to read from
+ * @param write Operation writing the data to the destination
+ * @param arg Argument to @a write
+ *
+ * @return EOK on success, ENOMEM if out of memory or an error code
+ *         from reading or writing
+ */
+static errno_t futil_copy_data(int sf, futil_write_t write, void *arg)
+{
+	futil_dbuf_t db;
+	aoff64_t posr = 0;
+	aoff64_t pos;
+	unsigned i = 0;
+	size_t nr;
+	fid_t fid;
+	errno_t rc = EOK;
+	errno_t wrc;
+
+	fibril_mutex_initialize(&db.lock);
+	fibril_condvar_initialize(&db.cv);
+	db.size[0] = db.size[1] = 0;
+	db.eof = false;
+	db.done = false;
+	db.rc = EOK;
+	db.write = write;
+	db.arg = arg;
+
+	db.buf[0] = malloc(COPY_CHUNK_SIZE);
+	db.buf[1] = malloc(COPY_CHUNK_SIZE);
+	if (db.buf[0] == NULL || db.buf[1] == NULL) {
+		free(db.buf[0]);
+		free(db.buf[1]);
+		return ENOMEM;
+	}
+
+	fid = fibril_create(futil_dbuf_writer, &db);
+	if (fid == 0) {
+		free(db.buf[0]);
+		free(db.buf[1]);
+		return ENOMEM;
+	}
+
+	fibril_add_ready(fid);
+
+	while (true) {
+		fibril_mutex_lock(&db.lock);
+		while (db.size[i] != 0)
+			fibril_condvar_wait(&db.cv, &db.lock);
+		wrc = db.rc;
+		fibril_mutex_unlock(&db.lock);
+
+		if (wrc != EOK)
+			break;
+
+		pos = posr;
+		rc = vfs_read(sf, &posr, db.buf[i], COPY_CHUNK_SIZE, &nr);
+		if (rc != EOK || nr == 0)
+			break;
+
+		fibril_mutex_lock(&db.lock);
+		db.pos[i] = pos;
+		db.size[i] = nr;
+		fibril_condvar_broadcast(&db.cv);
+		fibril_mutex_unlock(&db.lock);
+
+		if (nr < COPY_CHUNK_SIZE)
+			break;
+
+		i = 1 - i;
+	}
+
+	fibril_mutex_lock(&db.lock);
+	db.eof = true;
+	fibril_condvar_broadcast(&db.cv);
+	while (!db.done)
+		fibril_condvar_wait(&db.cv, &db.lock);
+	wrc = db.rc;
+	fibril_mutex_unlock(&db.lock);
+
+	free(db.buf[0]);
+	free(db.buf[1]);
+
+	return rc != EOK ? rc : wrc;
+}
+
+/** Write a chunk of data to a file. */
+static errno_t futil_file_write(void *arg, aoff64_t pos, void *data,
+    size_t size)
+{
+	int *df = (int *) arg;
+	size_t nw;
+
+	return vfs_write(*df, &pos, data, size, &nw);
+}
+
+/** Write a chunk of data to a block device.
+ *
+ * The last chunk is padded with zeros to a whole number of blocks.
+ */
+static errno_t futil_block_write(void *arg, aoff64_t pos, void *data,
+    size_t size)
+{
+	futil_bdev_t *bdev = (futil_bdev_t *) arg;
+	size_t nblocks;
+
+	nblocks = (size + bdev->bsize - 1) / bdev->bsize;
+	memset((char *) data + size, 0, nblocks * bdev->bsize - size);
+
+	return block_write_direct(bdev->sid, pos / bdev->bsize, nblocks, data);
+}
 
 /** Copy file.
+ *
+ * Large chunks of the file are read ahead while the previous ones are
+ * being written.
  *
  * @param srcp Source path
  * @param dstp Destination path
@@ -54,6 +301,50 @@ static char buf[BUF_SIZE];
  * @return EOK on success, EIO on I/O error
  */
 errno_t futil_copy_file(const char *srcp, const char *destp)
+{
+	int sf, df;
+	errno_t rc;
+
+	printf("Copy '%s' to '%s'.\n", srcp, destp);
+
+	rc = vfs_lookup_open(srcp, WALK_REGULAR, MODE_READ, &sf);
+	if (rc != EOK)
+		return EIO;
+
+	rc = vfs_lookup_open(destp, WALK_REGULAR | WALK_MAY_CREATE, MODE_WRITE,
+	    &df);
+	if (rc != EOK) {
+		vfs_put(sf);
+		return EIO;
+	}
+
+	rc = futil_copy_data(sf, futil_file_write, &df);
+	if (rc != EOK)
+		goto error;
+
+	(void) vfs_put(sf);
+
+	rc = vfs_put(df);
+	if (rc != EOK)
+		return EIO;
+
+	return EOK;
+error:
+	vfs_put(sf);
+	vfs_put(df);
+	return rc;
+}
+
+/** Copy small file using a single buffer.
+ *
+ * @param srcp Source path
+ * @param dstp Destination path
+ * @param buf Buffer, SMALL_FILE_SIZE bytes long
+ *
+ * @return EOK on success, EIO on I/O error
+ */
+static errno_t futil_copy_small(const char *srcp, const char *destp,
+    char *buf)
 {
 	int sf, df;
 	size_t nr, nw;
@@ -66,12 +357,15 @@ errno_t futil_copy_file(const char *srcp, const char *destp)
 	if (rc != EOK)
 		return EIO;
 
-	rc = vfs_lookup_open(destp, WALK_REGULAR | WALK_MAY_CREATE, MODE_WRITE, &df);
-	if (rc != EOK)
+	rc = vfs_lookup_open(destp, WALK_REGULAR | WALK_MAY_CREATE, MODE_WRITE,
+	    &df);
+	if (rc != EOK) {
+		vfs_put(sf);
 		return EIO;
+	}
 
 	do {
-		rc = vfs_read(sf, &posr, buf, BUF_SIZE, &nr);
+		rc = vfs_read(sf, &posr, buf, SMALL_FILE_SIZE, &nr);
 		if (rc != EOK)
 			goto error;
 		if (nr == 0)
@@ -80,8 +374,7 @@ errno_t futil_copy_file(const char *srcp, const char *destp)
 		rc = vfs_write(df, &posw, buf, nr, &nw);
 		if (rc != EOK)
 			goto error;
-
-	} while (nr == BUF_SIZE);
+	} while (nr == SMALL_FILE_SIZE);
 
 	(void) vfs_put(sf);
 
@@ -96,20 +389,187 @@ error:
 	return rc;
 }
 
+/** Copy small files queued in the pool. */
+static errno_t futil_worker(void *arg)
+{
+	futil_worker_t *worker = (futil_worker_t *) arg;
+	futil_pool_t *pool = worker->pool;
+	futil_job_t *job;
+	errno_t rc;
+
+	fibril_mutex_lock(&pool->lock);
+
+	while (true) {
+		while (list_empty(&pool->jobs) && !pool->stop)
+			fibril_condvar_wait(&pool->cv, &pool->lock);
+
+		if (list_empty(&pool->jobs))
+			break;
+
+		job = list_get_instance(list_first(&pool->jobs), futil_job_t,
+		    ljobs);
+		list_remove(&job->ljobs);
+		--pool->njobs;
+		fibril_condvar_broadcast(&pool->cv);
+
+		/* After an error the remaining jobs are only discarded */
+		if (pool->rc == EOK) {
+			fibril_mutex_unlock(&pool->lock);
+			rc = futil_copy_small(job->srcp, job->destp,
+			    worker->buf);
+			fibril_mutex_lock(&pool->lock);
+
+			if (rc != EOK && pool->rc == EOK)
+				pool->rc = rc;
+		}
+
+		free(job->srcp);
+		free(job->destp);
+		free(job);
+	}
+
+	--pool->running;
+	fibril_condvar_broadcast(&pool->cv);
+	fibril_mutex_unlock(&pool->lock);
+	return EOK;
+}
+
+/** Start fibrils copying small files.
+ *
+ * @param pool Pool to initialize
+ * @return EOK on success, ENOMEM if out of memory
+ */
+static errno_t futil_pool_start(futil_pool_t *pool)
+{
+	fid_t fids[COPY_WORKERS];
+	size_t i;
+
+	fibril_mutex_initialize(&pool->lock);
+	fibril_condvar_initialize(&pool->cv);
+	list_initialize(&pool->jobs);
+	pool->njobs = 0;
+	pool->stop = false;
+	pool->rc = EOK;
+
+	for (i = 0; i < COPY_WORKERS; i++) {
+		pool->worker[i].pool = pool;
+		pool->worker[i].buf = malloc(SMALL_FILE_SIZE);
+		fids[i] = fibril_create(futil_worker, &pool->worker[i]);
+		if (pool->worker[i].buf == NULL || fids[i] == 0)
+			break;
+	}
+
+	if (i < COPY_WORKERS) {
+		do {
+			free(pool->worker[i].buf);
+			if (fids[i] != 0)
+				fibril_destroy(fids[i]);
+		} while (i-- > 0);
+
+		return ENOMEM;
+	}
+
+	pool->running = COPY_WORKERS;
+
+	for (i = 0; i < COPY_WORKERS; i++)
+		fibril_add_ready(fids[i]);
+
+	return EOK;
+}
+
+/** Queue copying of a small file.
+ *
+ * @param pool Pool
+ * @param srcp Source path, the pool takes ownership of it
+ * @param destp Destination path, the pool takes ownership of it
+ *
+ * @return EOK on success, ENOMEM if out of memory or the error
+ *         copying an earlier file failed with
+ */
+static errno_t futil_pool_submit(futil_pool_t *pool, char *srcp, char *destp)
+{
+	futil_job_t *job;
+	errno_t rc;
+
+	job = calloc(1, sizeof(futil_job_t));
+	if (job == NULL) {
+		free(srcp);
+		free(destp);
+		return ENOMEM;
+	}
+
+	job->srcp = srcp;
+	job->destp = destp;
+
+	fibril_mutex_lock(&pool->lock);
+
+	while (pool->njobs >= COPY_QUEUE_MAX && pool->rc == EOK)
+		fibril_condvar_wait(&pool->cv, &pool->lock);
+
+	rc = pool->rc;
+	if (rc == EOK) {
+		list_append(&job->ljobs, &pool->jobs);
+		++pool->njobs;
+		fibril_condvar_broadcast(&pool->cv);
+	}
+
+	fibril_mutex_unlock(&pool->lock);
+
+	if (rc != EOK) {
+		free(srcp);
+		free(destp);
+		free(job);
+	}
+
+	return rc;
+}
+
+/** Wait for the queued copies to finish and stop the workers.
+ *
+ * @param pool Pool
+ * @return EOK on success or the first error copying a file
+ */
+static errno_t futil_pool_finish(futil_pool_t *pool)
+{
+	errno_t rc;
+	size_t i;
+
+	fibril_mutex_lock(&pool->lock);
+
+	pool->stop = true;
+	fibril_condvar_broadcast(&pool->cv);
+
+	while (pool->running > 0)
+		fibril_condvar_wait(&pool->cv, &pool->lock);
+
+	rc = pool->rc;
+	fibril_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < COPY_WORKERS; i++)
+		free(pool->worker[i].buf);
+
+	return rc;
+}
+
 /** Copy contents of srcdir (recursively) into destdir.
  *
+ * Small files are handed over to the pool, large ones are copied
+ * right away.
+ *
+ * @param pool Pool copying small files
  * @param srcdir Source directory
  * @param destdir Destination directory
  *
  * @return EOK on success, ENOMEM if out of memory, EIO on I/O error
  */
-errno_t futil_rcopy_contents(const char *srcdir, const char *destdir)
+static errno_t futil_rcopy_dir(futil_pool_t *pool, const char *srcdir,
+    const char *destdir)
 {
 	DIR *dir;
 	struct dirent *de;
 	vfs_stat_t s;
-	char *srcp, *destp;
-	errno_t rc;
+	char *srcp = NULL, *destp = NULL;
+	errno_t rc = EOK;
 
 	dir = opendir(srcdir);
 	if (dir == NULL)
@@ -117,35 +577,161 @@ errno_t futil_rcopy_contents(const char *srcdir, const char *destdir)
 
 	de = readdir(dir);
 	while (de != NULL) {
-		if (asprintf(&srcp, "%s/%s", srcdir, de->d_name) < 0)
-			return ENOMEM;
-		if (asprintf(&destp, "%s/%s", destdir, de->d_name) < 0)
-			return ENOMEM;
+		if (asprintf(&srcp, "%s/%s", srcdir, de->d_name) < 0) {
+			srcp = NULL;
+			rc = ENOMEM;
+			break;
+		}
+
+		if (asprintf(&destp, "%s/%s", destdir, de->d_name) < 0) {
+			destp = NULL;
+			rc = ENOMEM;
+			break;
+		}
 
 		rc = vfs_stat_path(srcp, &s);
-		if (rc != EOK)
-			return EIO;
+		if (rc != EOK) {
+			rc = EIO;
+			break;
+		}
 
-		if (s.is_file) {
+		if (s.is_file && s.size <= SMALL_FILE_SIZE) {
+			rc = futil_pool_submit(pool, srcp, destp);
+			srcp = destp = NULL;
+			if (rc != EOK) {
+				rc = (rc == ENOMEM) ? ENOMEM : EIO;
+				break;
+			}
+		} else if (s.is_file) {
 			rc = futil_copy_file(srcp, destp);
-			if (rc != EOK)
-				return EIO;
+			if (rc != EOK) {
+				rc = EIO;
+				break;
+			}
 		} else if (s.is_directory) {
 			printf("Create directory '%s'\n", destp);
 			rc = vfs_link_path(destp, KIND_DIRECTORY, NULL);
+			if (rc != EOK) {
+				rc = EIO;
+				break;
+			}
+			rc = futil_rcopy_dir(pool, srcp, destp);
 			if (rc != EOK)
-				return EIO;
-			rc = futil_rcopy_contents(srcp, destp);
-			if (rc != EOK)
-				return EIO;
+				break;
 		} else {
-			return EIO;
+			rc = EIO;
+			break;
 		}
 
+		free(srcp);
+		free(destp);
+		srcp = destp = NULL;
+
 		de = readdir(dir);
 	}
 
-	return EOK;
+	free(srcp);
+	free(destp);
+	closedir(dir);
+	return rc;
+}
+
+/** Copy contents of srcdir (recursively) into destdir.
+ *
+ * Small files are copied by several fibrils in parallel.
+ *
+ * @param srcdir Source directory
+ * @param destdir Destination directory
+ *
+ * @return EOK on success, ENOMEM if out of memory, EIO on I/O error
+ */
+errno_t futil_rcopy_contents(const char *srcdir, const char *destdir)
+{
+	futil_pool_t pool;
+	errno_t rc;
+	errno_t prc;
+
+	rc = futil_pool_start(&pool);
+	if (rc != EOK)
+		return rc;
+
+	rc = futil_rcopy_dir(&pool, srcdir, destdir);
+
+	prc = futil_pool_finish(&pool);
+	if (rc == EOK && prc != EOK)
+		rc = (prc == ENOMEM) ? ENOMEM : EIO;
+
+	return rc;
+}
+
+/** Copy file system image to a block device.
+ *
+ * The image is written to the device block by block, bypassing the
+ * file system on the device. This is only useful with a fresh volume
+ * as anything on it is overwritten.
+ *
+ * @param srcp Image path
+ * @param dsid Service ID of the block device to write to
+ *
+ * @return EOK on success, ENOENT if failed to open the image, ENOSPC if
+ *         the image does not fit on the device, ENOTSUP if the block
+ *         size is not supported, ENOMEM if out of memory, EIO on other
+ *         I/O error
+ */
+errno_t futil_copy_image(const char *srcp, service_id_t dsid)
+{
+	futil_bdev_t bdev;
+	aoff64_t nblocks;
+	vfs_stat_t st;
+	int sf;
+	errno_t rc;
+
+	printf("Copy image '%s' to block device.\n", srcp);
+
+	rc = vfs_lookup_open(srcp, WALK_REGULAR, MODE_READ, &sf);
+	if (rc != EOK)
+		return ENOENT;
+
+	rc = vfs_stat(sf, &st);
+	if (rc != EOK) {
+		vfs_put(sf);
+		return EIO;
+	}
+
+	rc = block_init(dsid, 2048);
+	if (rc != EOK) {
+		vfs_put(sf);
+		return EIO;
+	}
+
+	bdev.sid = dsid;
+	rc = block_get_bsize(dsid, &bdev.bsize);
+	if (rc == EOK)
+		rc = block_get_nblocks(dsid, &nblocks);
+	if (rc != EOK) {
+		rc = EIO;
+		goto out;
+	}
+
+	if (bdev.bsize == 0 || COPY_CHUNK_SIZE % bdev.bsize != 0) {
+		rc = ENOTSUP;
+		goto out;
+	}
+
+	if (st.size > nblocks * bdev.bsize) {
+		rc = ENOSPC;
+		goto out;
+	}
+
+	rc = futil_copy_data(sf, futil_block_write, &bdev);
+	if (rc == EOK)
+		rc = block_sync_cache(dsid, 0, 0);
+	if (rc != EOK && rc != ENOMEM)
+		rc = EIO;
+out:
+	block_fini(dsid);
+	vfs_put(sf);
+	return rc;
 }
 
 /** Return file contents as a heap-allocated block of bytes.
@@ -42,6 +42,7 @@
 
 extern errno_t futil_copy_file(const char *, const char *);
 extern errno_t futil_rcopy_contents(const char *, const char *);
+extern errno_t futil_copy_image(const char *, service_id_t);
 extern errno_t futil_get_file(const char *, void **, size_t *);
 
 #endif
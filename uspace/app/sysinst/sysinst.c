@@ -76,6 +76,8 @@
 #define CD_MOUNT_POINT "/vol/" CD_VOL_LABEL
 
 #define BOOT_FILES_SRC CD_MOUNT_POINT
+/** Image of the system volume, written at block level if present */
+#define SYS_IMAGE_SRC CD_MOUNT_POINT "/boot/sysvol.img"
 #define BOOT_BLOCK_IDX 0 /* MBR */
 
 static const char *sys_dirs[] = {
@@ -223,6 +225,60 @@ static errno_t sysinst_copy_boot_files(void)
 	return EOK;
 }
 
+/** Copy system volume image.
+ *
+ * If the installation medium carries an image of the system volume, it
+ * is written directly to the freshly created partition. This is much
+ * faster than copying the files one by one. The image must contain an
+ * ext4 file system labelled INST_VOL_LABEL.
+ *
+ * @param part_id Partition service ID
+ * @return EOK on success, ENOENT if there is no image or an error code
+ */
+static errno_t sysinst_copy_image(service_id_t part_id)
+{
+	vol_t *vol = NULL;
+	vfs_stat_t st;
+	errno_t rc;
+
+	rc = vfs_stat_path(SYS_IMAGE_SRC, &st);
+	if (rc != EOK)
+		return ENOENT;
+
+	rc = vol_create(&vol);
+	if (rc != EOK) {
+		printf("Error contacting volume service.\n");
+		goto out;
+	}
+
+	/* Unmount the empty file system before overwriting it */
+	rc = vol_part_eject(vol, part_id);
+	if (rc != EOK) {
+		printf("Error ejecting volume.\n");
+		goto out;
+	}
+
+	rc = futil_copy_image(SYS_IMAGE_SRC, part_id);
+	if (rc != EOK) {
+		printf("Error copying system volume image: %s.\n",
+		    str_error(rc));
+		if (rc == ENOENT)
+			rc = EIO;
+		goto out;
+	}
+
+	rc = vol_part_insert(vol, part_id);
+	if (rc != EOK) {
+		printf("Error mounting system volume.\n");
+		goto out;
+	}
+
+	rc = EOK;
+out:
+	vol_destroy(vol);
+	return rc;
+}
+
 /** Set up configuration in the initial RAM disk.
  *
  * @return EOK on success or an error code
@@ -459,15 +515,21 @@ static errno_t sysinst_install(const char *dev)
 	if (rc != EOK)
 		return rc;
 
-	printf("FS created and mounted. Creating system directory structure.\n");
-	rc = sysinst_setup_sysvol();
-	if (rc != EOK)
-		return rc;
-
-	printf("Directories created. Copying boot files.\n");
-	rc = sysinst_copy_boot_files();
-	if (rc != EOK)
+	printf("FS created and mounted. Copying system volume image.\n");
+	rc = sysinst_copy_image(psvc_id);
+	if (rc == ENOENT) {
+		printf("No image. Creating system directory structure.\n");
+		rc = sysinst_setup_sysvol();
+		if (rc != EOK)
+			return rc;
+
+		printf("Directories created. Copying boot files.\n");
+		rc = sysinst_copy_boot_files();
+		if (rc != EOK)
+			return rc;
+	} else if (rc != EOK) {
 		return rc;
+	}
 
 	printf("Boot files done. Configuring the system.\n");
 	rc = sysinst_customize_initrd();
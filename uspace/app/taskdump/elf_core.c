@@ -68,7 +68,11 @@
 static off64_t align_foff_up(off64_t, uintptr_t, size_t);
 static errno_t write_mem_area(int, aoff64_t *, as_area_info_t *, async_sess_t *);
 
-#define BUFFER_SIZE 0x1000
+/*
+ * Each chunk costs an IPC round trip to the kbox thread, so read
+ * and write memory in chunks as large as the kernel allows.
+ */
+#define BUFFER_SIZE UDEBUG_MEMV_MAX_SIZE
 static uint8_t buffer[BUFFER_SIZE];
 
 /** Save ELF core file.
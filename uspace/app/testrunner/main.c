@@ -219,6 +219,45 @@ static void run_pcut_tests(void)
 	closedir(d);
 }
 
+/** Baseline of performance checks, these are skipped without it. */
+#define HBENCH_BASELINE "/data/hbench/baseline.csv"
+
+static bool hbench_baseline_exists(void)
+{
+	vfs_stat_t st;
+	return vfs_stat_path(HBENCH_BASELINE, &st) == EOK;
+}
+
+static void run_hbench(const char *logfile)
+{
+	if (!hbench_baseline_exists())
+		return;
+
+	task_exit_t ex;
+	int retval;
+
+	const char *app = "/app/hbench";
+	const char *const args[] = {
+		app, "-b", HBENCH_BASELINE, "-o", "/data/web/result-hbench.csv",
+		NULL
+	};
+	errno_t rc = run_test(logfile, "w", app, args, &ex, &retval);
+	if (rc != EOK) {
+		/* Reason already printed in run_test(). */
+		return;
+	}
+
+	if (ex != TASK_EXIT_NORMAL) {
+		fprintf(stderr, "hbench CRASHED\n");
+		return;
+	}
+
+	if (retval == 0)
+		printf("hbench ok\n");
+	else
+		printf("hbench FAILED\n");
+}
+
 static void gen_index(const char *fname)
 {
 	FILE *f = fopen(fname, "w");
@@ -234,6 +273,11 @@ static void gen_index(const char *fname)
 
 	fprintf(f, "<li><a href=\"result-tester.txt\">tester</a></li>\n");
 
+	if (hbench_baseline_exists()) {
+		fprintf(f, "<li><a href=\"result-hbench.txt\">hbench</a>"
+		    "</li>\n");
+	}
+
 	DIR *d = opendir("/test");
 	if (d) {
 		struct dirent *e;
@@ -256,6 +300,7 @@ int main(int argc, char **argv)
 	run_tester("/data/web/result-tester.txt");
 	run_tester_fault("/tmp/tester_fault.log");
 	run_pcut_tests();
+	run_hbench("/data/web/result-hbench.txt");
 
 	const char *fname = "/data/web/test.html";
 	printf("Generating HTML report in %s\n", fname);
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup trace
+ * @{
+ */
+/** @file
+ * @brief Kernel tracepoint consumer.
+ *
+ * Maps the per-CPU kernel tracepoint buffers and streams the records
+ * as they are produced. The kernel does not wait for the reader, records
+ * which are overwritten before they could be read are counted as lost.
+ */
+
+#include <as.h>
+#include <barrier.h>
+#include <ddi.h>
+#include <errno.h>
+#include <fibril.h>
+#include <inttypes.h>
+#include <io/console.h>
+#include <io/keycode.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <sysinfo.h>
+#include <abi/tracepoint.h>
+
+#include "ktrace.h"
+
+/** Polling period of the tracepoint buffers (in microseconds) */
+#define KTRACE_POLL_PERIOD  10000
+
+static const char *event_name[TRACE_EVENT_COUNT] = {
+	[TRACE_SCHED_SWITCH] = "sched_switch",
+	[TRACE_IPC_CALL] = "ipc_call",
+	[TRACE_IPC_ANSWER] = "ipc_answer",
+	[TRACE_PAGE_FAULT] = "page_fault",
+	[TRACE_IRQ] = "irq",
+	[TRACE_FRAME_ALLOC] = "frame_alloc"
+};
+
+/** Kernel tracepoint buffers */
+static uint8_t *ktrace_buffers;
+static size_t ktrace_buffer_size;
+
+/** Get the tracepoint buffer of a CPU. */
+static trace_buffer_t *ktrace_buffer(size_t cpu)
+{
+	return (trace_buffer_t *) (ktrace_buffers + cpu * ktrace_buffer_size);
+}
+
+static void ktrace_print(trace_record_t *rec)
+{
+	const char *name = (rec->event < TRACE_EVENT_COUNT) ?
+	    event_name[rec->event] : "unknown";
+
+	printf("[%" PRIu32 "] %" PRIu64 " thread %" PRIu64 " %s 0x%" PRIx64
+	    " 0x%" PRIx64 " 0x%" PRIx64 "\n", rec->cpu, rec->timestamp,
+	    rec->thread_id, name, rec->args[0], rec->args[1], rec->args[2]);
+}
+
+/** Consume new records of a tracepoint buffer
+ *
+ * @param buf  Tracepoint buffer.
+ * @param tail Sequence number of the next record to read, updated.
+ *
+ * @return Number of records lost.
+ *
+ */
+static uint64_t ktrace_consume(trace_buffer_t *buf, uint64_t *tail)
+{
+	uint64_t lost = 0;
+	uint64_t head = buf->head;
+	read_barrier();
+
+	if (head - *tail > buf->count) {
+		lost += head - *tail - buf->count;
+		*tail = head - buf->count;
+	}
+
+	while (*tail < head) {
+		trace_record_t *slot = &buf->records[*tail % buf->count];
+		uint64_t seq = slot->seq;
+		read_barrier();
+
+		trace_record_t rec = *slot;
+
+		read_barrier();
+		if ((seq != *tail + 1) || (slot->seq != seq)) {
+			/* Overwritten while being read */
+			lost++;
+		} else {
+			ktrace_print(&rec);
+		}
+
+		(*tail)++;
+	}
+
+	return lost;
+}
+
+/** Stream kernel tracepoint records until the user presses Q
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t ktrace_run(void)
+{
+	sysarg_t faddr;
+	sysarg_t cpus;
+	sysarg_t pages;
+
+	errno_t rc = sysinfo_get_value("trace.faddr", &faddr);
+	if (rc == EOK)
+		rc = sysinfo_get_value("trace.cpus", &cpus);
+	if (rc == EOK)
+		rc = sysinfo_get_value("trace.buffer_pages", &pages);
+	if (rc != EOK) {
+		printf("Kernel tracepoints are not available.\n");
+		return rc;
+	}
+
+	rc = physmem_map(faddr, cpus * pages, AS_AREA_READ | AS_AREA_CACHEABLE,
+	    (void *) &ktrace_buffers);
+	if (rc != EOK) {
+		printf("Unable to map kernel tracepoint buffers: %s.\n",
+		    str_error(rc));
+		return rc;
+	}
+
+	ktrace_buffer_size = pages * PAGE_SIZE;
+
+	uint64_t *tails = calloc(cpus, sizeof(uint64_t));
+	if (tails == NULL) {
+		physmem_unmap(ktrace_buffers);
+		return ENOMEM;
+	}
+
+	/* Skip the records produced before we started. */
+	for (size_t i = 0; i < cpus; i++)
+		tails[i] = ktrace_buffer(i)->head;
+
+	console_ctrl_t *console = console_init(stdin, stdout);
+	uint64_t lost = 0;
+	bool done = false;
+
+	while (!done) {
+		for (size_t i = 0; i < cpus; i++)
+			lost += ktrace_consume(ktrace_buffer(i), &tails[i]);
+
+		if (console == NULL) {
+			fibril_usleep(KTRACE_POLL_PERIOD);
+			continue;
+		}
+
+		usec_t timeout = KTRACE_POLL_PERIOD;
+		cons_event_t event;
+		while (console_get_event_timeout(console, &event, &timeout)) {
+			if ((event.type == CEV_KEY) &&
+			    (event.ev.key.type == KEY_PRESS) &&
+			    (event.ev.key.key == KC_Q))
+				done = true;
+		}
+	}
+
+	printf("%" PRIu64 " records lost.\n", lost);
+
+	free(tails);
+	physmem_unmap(ktrace_buffers);
+	return EOK;
+}
+
+/** @}
+ */
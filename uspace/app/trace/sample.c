@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup trace
+ * @{
+ */
+/** @file
+ * @brief Sampling mode.
+ *
+ * Attaches to a task in a udebug sampling session, in which the kernel
+ * counts system calls and IPC requests of the task without ever stopping
+ * it. The statistics are read periodically and the differences since the
+ * previous period are printed.
+ */
+
+#include <async.h>
+#include <errno.h>
+#include <fibril.h>
+#include <inttypes.h>
+#include <io/console.h>
+#include <io/keycode.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <udebug.h>
+
+#include "ipc_desc.h"
+#include "syscalls.h"
+#include "sample.h"
+
+/** Period of reading the statistics (in microseconds) */
+#define SAMPLE_PERIOD  1000000
+
+/** Get the upper bound of a percentile from a latency histogram.
+ *
+ * @param hist  Histogram of the period.
+ * @param count Number of calls in the period.
+ * @param pct   Percentile.
+ *
+ * @return Latency (in CPU cycles) that at least @a pct percent
+ *         of the calls did not exceed.
+ */
+static uint64_t hist_percentile(const uint64_t *hist, uint64_t count,
+    unsigned int pct)
+{
+	uint64_t limit = (count * pct + 99) / 100;
+	uint64_t sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < UDEBUG_STATS_BUCKETS - 1; i++) {
+		sum += hist[i];
+		if (sum >= limit)
+			break;
+	}
+
+	return ((uint64_t) 1) << (i + 1);
+}
+
+static const char *method_name(uint64_t imethod)
+{
+	for (size_t i = 0; i < ipc_methods_len; i++) {
+		if ((uint64_t) ipc_methods[i].number == imethod)
+			return ipc_methods[i].name;
+	}
+
+	return NULL;
+}
+
+/** Print the differences of two snapshots of statistics. */
+static void sample_print(const udebug_stats_t *cur, const udebug_stats_t *prev)
+{
+	uint64_t hist[UDEBUG_STATS_BUCKETS];
+
+	printf("%-24s %10s %12s %12s %12s\n", "syscall", "calls",
+	    "avg cycles", "p50 <", "p99 <");
+
+	for (size_t id = 0; id < UDEBUG_STATS_SYSCALLS; id++) {
+		const udebug_syscall_stats_t *c = &cur->syscalls[id];
+		const udebug_syscall_stats_t *p = &prev->syscalls[id];
+		uint64_t count = c->count - p->count;
+
+		if (count == 0)
+			continue;
+
+		for (size_t i = 0; i < UDEBUG_STATS_BUCKETS; i++)
+			hist[i] = c->hist[i] - p->hist[i];
+
+		if (syscall_desc_defined(id))
+			printf("%-24s", syscall_desc[id].name);
+		else
+			printf("%-24zu", id);
+
+		printf(" %10" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12" PRIu64
+		    "\n", count, (c->cycles - p->cycles) / count,
+		    hist_percentile(hist, count, 50),
+		    hist_percentile(hist, count, 99));
+	}
+
+	printf("%-24s %10s\n", "IPC method", "requests");
+
+	for (size_t i = 0; i < UDEBUG_STATS_METHODS; i++) {
+		const udebug_ipc_stats_t *c = &cur->methods[i];
+		if (c->imethod == 0 && c->count == 0)
+			break;
+
+		/* Entries are never reordered, only appended */
+		uint64_t count = c->count;
+		if (prev->methods[i].imethod == c->imethod)
+			count -= prev->methods[i].count;
+
+		if (count == 0)
+			continue;
+
+		const char *name = method_name(c->imethod);
+		if (name != NULL)
+			printf("%-24s", name);
+		else
+			printf("%-24" PRIu64, c->imethod);
+
+		printf(" %10" PRIu64 "\n", count);
+	}
+
+	uint64_t other = cur->methods_other - prev->methods_other;
+	if (other != 0)
+		printf("%-24s %10" PRIu64 "\n", "(other)", other);
+
+	printf("\n");
+}
+
+/** Print statistics of a task periodically until the user presses Q
+ *
+ * @param task_id ID of the task to sample.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t sample_run(task_id_t task_id)
+{
+	async_sess_t *ksess = async_connect_kbox(task_id);
+	if (ksess == NULL) {
+		printf("Error connecting to task %" PRIu64 ": %s.\n", task_id,
+		    str_error(errno));
+		return errno;
+	}
+
+	errno_t rc = udebug_begin_sampling(ksess);
+	if (rc != EOK) {
+		printf("udebug_begin_sampling() -> %s\n", str_error_name(rc));
+		async_hangup(ksess);
+		return rc;
+	}
+
+	udebug_stats_t *cur = calloc(1, sizeof(udebug_stats_t));
+	udebug_stats_t *prev = calloc(1, sizeof(udebug_stats_t));
+	if (cur == NULL || prev == NULL) {
+		rc = ENOMEM;
+		goto leave;
+	}
+
+	printf("Sampling task %" PRIu64 ".\n", task_id);
+
+	console_ctrl_t *console = console_init(stdin, stdout);
+	bool done = false;
+
+	while (!done) {
+		if (console == NULL) {
+			fibril_usleep(SAMPLE_PERIOD);
+		} else {
+			usec_t timeout = SAMPLE_PERIOD;
+			cons_event_t event;
+			while (console_get_event_timeout(console, &event,
+			    &timeout)) {
+				if ((event.type == CEV_KEY) &&
+				    (event.ev.key.type == KEY_PRESS) &&
+				    (event.ev.key.key == KC_Q))
+					done = true;
+			}
+		}
+
+		rc = udebug_stats_read(ksess, cur);
+		if (rc != EOK) {
+			/* Most likely, the task has terminated */
+			printf("udebug_stats_read() -> %s\n",
+			    str_error_name(rc));
+			break;
+		}
+
+		sample_print(cur, prev);
+
+		udebug_stats_t *tmp = prev;
+		prev = cur;
+		cur = tmp;
+	}
+
+leave:
+	free(cur);
+	free(prev);
+	udebug_end(ksess);
+	async_hangup(ksess);
+	return rc;
+}
+
+/** @}
+ */
@@ -58,6 +58,7 @@ const sc_desc_t syscall_desc[] = {
 	[SYS_IPC_FORWARD_FAST] = { "ipc_forward_fast", 6, V_ERRNO },
 	[SYS_IPC_FORWARD_SLOW] = { "ipc_forward_slow", 3, V_ERRNO },
 	[SYS_IPC_WAIT] = { "ipc_wait_for_call", 3, V_HASH },
+	[SYS_IPC_WAIT_BATCH] = { "ipc_wait_for_calls", 5, V_ERRNO },
 	[SYS_IPC_POKE] = { "ipc_poke", 0, V_ERRNO },
 	[SYS_IPC_HANGUP] = { "ipc_hangup", 1, V_ERRNO },
 
@@ -72,6 +73,8 @@ const sc_desc_t syscall_desc[] = {
 
 	[SYS_IPC_IRQ_SUBSCRIBE] = { "ipc_irq_subscribe", 4, V_ERRNO },
 	[SYS_IPC_IRQ_UNSUBSCRIBE] = { "ipc_irq_unsubscribe", 2, V_ERRNO },
+	[SYS_IPC_IRQ_SET_FLAGS] = { "ipc_irq_set_flags", 2, V_ERRNO },
+	[SYS_IPC_IRQ_SET_CPU] = { "ipc_irq_set_cpu", 2, V_ERRNO },
 
 	[SYS_SYSINFO_GET_VAL_TYPE] = { "sysinfo_get_val_type", 2, V_INTEGER },
 	[SYS_SYSINFO_GET_VALUE] = { "sysinfo_get_value", 3, V_ERRNO },
@@ -79,7 +82,9 @@ const sc_desc_t syscall_desc[] = {
 	[SYS_SYSINFO_GET_DATA] = { "sysinfo_get_data", 5, V_ERRNO },
 
 	[SYS_DEBUG_CONSOLE] = { "debug_console", 0, V_ERRNO },
-	[SYS_IPC_CONNECT_KBOX] = { "ipc_connect_kbox", 1, V_ERRNO }
+	[SYS_IPC_CONNECT_KBOX] = { "ipc_connect_kbox", 1, V_ERRNO },
+
+	[SYS_PROFILE] = { "profile", 4, V_ERRNO }
 };
 
 const size_t syscall_desc_len = (sizeof(syscall_desc) / sizeof(sc_desc_t));
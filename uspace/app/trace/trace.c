@@ -62,6 +62,8 @@
 
 #include "syscalls.h"
 #include "ipcp.h"
+#include "ktrace.h"
+#include "sample.h"
 #include "trace.h"
 
 #define THBUF_SIZE 64
@@ -88,6 +90,8 @@ void thread_trace_start(uintptr_t thread_hash);
 static task_id_t task_id;
 static loader_t *task_ldr;
 static bool task_wait_for;
+static bool ktrace;
+static bool sample;
 
 /** Combination of events/data to print. */
 display_mask_t display_mask;
@@ -745,6 +749,8 @@ static void print_syntax(void)
 	printf("Syntax:\n");
 	printf("\ttrace [+<events>] <executable> [<arg1> [...]]\n");
 	printf("or\ttrace [+<events>] -t <task_id>\n");
+	printf("or\ttrace -k\t(stream kernel tracepoints)\n");
+	printf("or\ttrace -s <task_id>\t(sample without stopping the task)\n");
 	printf("Events: (default is +tp)\n");
 	printf("\n");
 	printf("\tt ... Thread creation and termination\n");
@@ -813,6 +819,27 @@ static int parse_args(int argc, char *argv[])
 					print_syntax();
 					return -1;
 				}
+			} else if (arg[1] == 's') {
+				/* Sample an already running task */
+				--argc;
+				++argv;
+				if (argc == 0) {
+					printf("Missing task ID\n");
+					print_syntax();
+					return -1;
+				}
+				task_id = strtol(*argv, &err_p, 10);
+				task_ldr = NULL;
+				task_wait_for = false;
+				sample = true;
+				if (*err_p) {
+					printf("Task ID syntax error\n");
+					print_syntax();
+					return -1;
+				}
+			} else if (arg[1] == 'k') {
+				/* Stream kernel tracepoints */
+				ktrace = true;
 			} else {
 				printf("Uknown option '%c'\n", arg[0]);
 				print_syntax();
@@ -826,7 +853,7 @@ static int parse_args(int argc, char *argv[])
 		++argv;
 	}
 
-	if (task_id != 0) {
+	if ((task_id != 0) || (ktrace)) {
 		if (argc == 0)
 			return 0;
 		printf("Extra arguments\n");
@@ -867,6 +894,12 @@ int main(int argc, char *argv[])
 	if (parse_args(argc, argv) < 0)
 		return 1;
 
+	if (ktrace)
+		return (ktrace_run() == EOK) ? 0 : 1;
+
+	if (sample)
+		return (sample_run(task_id) == EOK) ? 0 : 1;
+
 	main_init();
 
 	rc = connect_task(task_id);
@@ -33,15 +33,145 @@
  */
 
 #include <errno.h>
+#include <gzip.h>
+#include <inflate.h>
+#include <inttypes.h>
+#include <mem.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <untar.h>
 
+/** Size of the buffer for compressed input */
+#define GZIP_BUFFER_SIZE  65536
+
 typedef struct {
 	const char *filename;
 	FILE *file;
+
+	/** The archive is compressed with gzip */
+	bool gzip;
+	/** The deflate stream has ended */
+	bool gzip_end;
+	inflate_stream_t strm;
+	uint8_t *inbuf;
 } tar_state_t;
 
+/** Start decompressing the archive if it has a gzip header.
+ *
+ * @param state Archive state with the file open
+ * @return EOK on success or an error code
+ */
+static errno_t tar_gzip_open(tar_state_t *state)
+{
+	size_t hdrlen;
+
+	state->inbuf = malloc(GZIP_BUFFER_SIZE);
+	if (state->inbuf == NULL)
+		return ENOMEM;
+
+	/* The header has to fit in the first buffer */
+	size_t nread = fread(state->inbuf, 1, GZIP_BUFFER_SIZE, state->file);
+	if (ferror(state->file)) {
+		free(state->inbuf);
+		return EIO;
+	}
+
+	if (gzip_header_parse(state->inbuf, nread, &hdrlen) != EOK) {
+		/* Not compressed, read the archive from the start */
+		free(state->inbuf);
+		state->inbuf = NULL;
+		state->gzip = false;
+		return (fseek(state->file, 0, SEEK_SET) == 0) ? EOK : EIO;
+	}
+
+	errno_t rc = inflate_init(&state->strm);
+	if (rc != EOK) {
+		free(state->inbuf);
+		return rc;
+	}
+
+	state->strm.next_in = state->inbuf + hdrlen;
+	state->strm.avail_in = nread - hdrlen;
+	state->gzip = true;
+	state->gzip_end = false;
+	return EOK;
+}
+
+/** Check the gzip footer after the end of the deflate stream. */
+static errno_t tar_gzip_footer(tar_state_t *state)
+{
+	size_t nread = state->strm.avail_in;
+
+	memmove(state->inbuf, state->strm.next_in, nread);
+	if (!feof(state->file)) {
+		nread += fread(state->inbuf + nread, 1,
+		    GZIP_BUFFER_SIZE - nread, state->file);
+	}
+
+	state->strm.next_in = state->inbuf;
+	state->strm.avail_in = 0;
+
+	return gzip_footer_check(state->inbuf, nread, state->strm.total_out);
+}
+
+/** Read decompressed data straight from the inflate stream.
+ *
+ * @param state Archive state
+ * @param data  Buffer
+ * @param size  Number of bytes to read
+ * @return Number of bytes read, errno is set on a short read
+ */
+static size_t tar_gzip_read(tar_state_t *state, void *data, size_t size)
+{
+	inflate_stream_t *strm = &state->strm;
+
+	strm->next_out = data;
+	strm->avail_out = size;
+
+	while ((strm->avail_out > 0) && !state->gzip_end) {
+		if ((strm->avail_in == 0) && !feof(state->file)) {
+			size_t nread = fread(state->inbuf, 1, GZIP_BUFFER_SIZE,
+			    state->file);
+			if (ferror(state->file)) {
+				errno = EIO;
+				break;
+			}
+
+			strm->next_in = state->inbuf;
+			strm->avail_in = nread;
+		}
+
+		bool no_input = (strm->avail_in == 0);
+
+		errno_t rc = inflate_step(strm);
+		if (rc == EOK) {
+			state->gzip_end = true;
+			rc = tar_gzip_footer(state);
+			if (rc != EOK) {
+				fprintf(stderr, "Invalid gzip footer of %s.\n",
+				    state->filename);
+				errno = rc;
+			}
+			break;
+		}
+
+		if (rc != EAGAIN) {
+			errno = rc;
+			break;
+		}
+
+		if (no_input && (strm->avail_out > 0)) {
+			fprintf(stderr, "Unexpected end of %s.\n",
+			    state->filename);
+			errno = EIO;
+			break;
+		}
+	}
+
+	return size - strm->avail_out;
+}
+
 static int tar_open(tar_file_t *tar)
 {
 	tar_state_t *state = (tar_state_t *) tar->data;
@@ -50,18 +180,34 @@ static int tar_open(tar_file_t *tar)
 	if (state->file == NULL)
 		return errno;
 
+	errno_t rc = tar_gzip_open(state);
+	if (rc != EOK) {
+		fclose(state->file);
+		return rc;
+	}
+
 	return EOK;
 }
 
 static void tar_close(tar_file_t *tar)
 {
 	tar_state_t *state = (tar_state_t *) tar->data;
+
+	if (state->gzip) {
+		inflate_end(&state->strm);
+		free(state->inbuf);
+	}
+
 	fclose(state->file);
 }
 
 static size_t tar_read(tar_file_t *tar, void *data, size_t size)
 {
 	tar_state_t *state = (tar_state_t *) tar->data;
+
+	if (state->gzip)
+		return tar_gzip_read(state, data, size);
+
 	return fread(data, 1, size, state->file);
 }
 
@@ -81,7 +227,7 @@ tar_file_t tar = {
 int main(int argc, char *argv[])
 {
 	if (argc != 2) {
-		fprintf(stderr, "Usage: %s tar-file\n", argv[0]);
+		fprintf(stderr, "Usage: %s tar-file[.gz]\n", argv[0]);
 		return 1;
 	}
 
@@ -89,7 +235,20 @@ int main(int argc, char *argv[])
 	state.filename = argv[1];
 
 	tar.data = (void *) &state;
-	return untar(&tar);
+
+	int rc = untar(&tar);
+	if (rc != EOK)
+		return rc;
+
+	uint64_t msec = NSEC2MSEC(tar.stats.nsec);
+	uint64_t rate = (msec > 0) ? tar.stats.bytes * 1000 / msec / 1024 : 0;
+
+	printf("Extracted %zu files and %zu directories, %" PRIu64 " bytes "
+	    "in %" PRIu64 ".%03" PRIu64 " s (%" PRIu64 " KiB/s).\n",
+	    tar.stats.files, tar.stats.directories, tar.stats.bytes,
+	    msec / 1000, msec % 1000, rate);
+
+	return 0;
 }
 
 /** @}
@@ -49,7 +49,7 @@ int main(int argc, char *argv[])
 	}
 
 	window_t *main_window = window_open(argv[1], NULL,
-	    WINDOW_MAIN | WINDOW_DECORATED, "vterm");
+	    WINDOW_MAIN | WINDOW_DECORATED | WINDOW_OPAQUE, "vterm");
 	if (!main_window) {
 		printf("%s: Cannot open main window.\n", NAME);
 		return 2;
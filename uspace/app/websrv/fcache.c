@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup websrv
+ * @{
+ */
+/**
+ * @file File cache.
+ *
+ * Keeps the content of small, frequently requested files in memory
+ * together with a precomputed response header. The cache is bounded by
+ * total size and evicts the least recently used files first. Cached
+ * files are checked against the file system at most once a second and
+ * reloaded after a while even if they seem unchanged, since the file
+ * system does not tell us modification times.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <stdlib.h>
+#include <str.h>
+#include <time.h>
+#include <vfs/vfs.h>
+
+#include "fcache.h"
+
+/** How long a cached file is used without checking the file system */
+#define FCACHE_VALID_NSEC  SEC2NSEC(1)
+
+/** How long a cached file is used before it is reloaded */
+#define FCACHE_MAX_AGE_NSEC  SEC2NSEC(30)
+
+static size_t fcache_hash(const ht_link_t *);
+static size_t fcache_key_hash(const void *);
+static bool fcache_key_equal(const void *, const ht_link_t *);
+static bool fcache_equal(const ht_link_t *, const ht_link_t *);
+
+static hash_table_ops_t fcache_ops = {
+	.hash = fcache_hash,
+	.key_hash = fcache_key_hash,
+	.key_equal = fcache_key_equal,
+	.equal = fcache_equal,
+	.remove_callback = NULL
+};
+
+/** Protects all cache data */
+static FIBRIL_MUTEX_INITIALIZE(fcache_lock);
+/** Cached files by name */
+static hash_table_t fcache_map;
+/** Cached files, least recently used first */
+static LIST_INITIALIZE(fcache_lru);
+/** Memory used by cached files */
+static size_t fcache_used;
+/** Maximum memory used by cached files */
+static size_t fcache_max;
+/** Maximum size of a file to be cached */
+static size_t fcache_file_max;
+/** Function building response headers */
+static fcache_hdr_fn_t fcache_hdr;
+
+static size_t fcache_name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != '\0')
+		hash = hash_combine(hash, (unsigned char) *name++);
+
+	return hash_mix(hash);
+}
+
+static size_t fcache_hash(const ht_link_t *item)
+{
+	fcache_entry_t *entry = hash_table_get_inst(item, fcache_entry_t,
+	    lhash);
+
+	return fcache_name_hash(entry->name);
+}
+
+static size_t fcache_key_hash(const void *key)
+{
+	return fcache_name_hash((const char *) key);
+}
+
+static bool fcache_key_equal(const void *key, const ht_link_t *item)
+{
+	fcache_entry_t *entry = hash_table_get_inst(item, fcache_entry_t,
+	    lhash);
+
+	return str_cmp(entry->name, (const char *) key) == 0;
+}
+
+static bool fcache_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	fcache_entry_t *entry1 = hash_table_get_inst(item1, fcache_entry_t,
+	    lhash);
+	fcache_entry_t *entry2 = hash_table_get_inst(item2, fcache_entry_t,
+	    lhash);
+
+	return str_cmp(entry1->name, entry2->name) == 0;
+}
+
+/** Initialize file cache.
+ *
+ * @param size_max Maximum memory used by cached files
+ * @param file_max Maximum size of a file to be cached
+ * @param hdr_fn   Function building response headers for cached files
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t fcache_init(size_t size_max, size_t file_max, fcache_hdr_fn_t hdr_fn)
+{
+	if (!hash_table_create(&fcache_map, 0, 0, &fcache_ops))
+		return ENOMEM;
+
+	fcache_max = size_max;
+	fcache_file_max = min(file_max, size_max);
+	fcache_hdr = hdr_fn;
+	return EOK;
+}
+
+/** Free cached file. */
+static void fcache_entry_free(fcache_entry_t *entry)
+{
+	free(entry->name);
+	free(entry->hdr);
+	free(entry->data);
+	free(entry);
+}
+
+/** Drop reference to cached file with the cache locked. */
+static void fcache_entry_delref(fcache_entry_t *entry)
+{
+	assert(fibril_mutex_is_locked(&fcache_lock));
+	assert(entry->refcnt > 0);
+
+	if (--entry->refcnt == 0) {
+		assert(!entry->cached);
+		fcache_entry_free(entry);
+	}
+}
+
+/** Remove file from the cache. */
+static void fcache_entry_remove(fcache_entry_t *entry)
+{
+	assert(fibril_mutex_is_locked(&fcache_lock));
+	assert(entry->cached);
+
+	hash_table_remove_item(&fcache_map, &entry->lhash);
+	list_remove(&entry->llru);
+	fcache_used -= entry->size + entry->hdr_size;
+	entry->cached = false;
+	fcache_entry_delref(entry);
+}
+
+/** Load file for the cache.
+ *
+ * @param name    File name
+ * @param rentry  Place to store pointer to new entry, not yet in the cache
+ *
+ * @return EOK on success, ELIMIT if the file is too large to be cached
+ *         or an error code
+ */
+static errno_t fcache_load(const char *name, fcache_entry_t **rentry)
+{
+	fcache_entry_t *entry = NULL;
+	vfs_stat_t stat;
+	aoff64_t pos;
+	size_t nr;
+	int fd;
+	errno_t rc;
+
+	rc = vfs_lookup_open(name, WALK_REGULAR, MODE_READ, &fd);
+	if (rc != EOK)
+		return rc;
+
+	rc = vfs_stat(fd, &stat);
+	if (rc != EOK)
+		goto error;
+
+	if (stat.size > fcache_file_max) {
+		rc = ELIMIT;
+		goto error;
+	}
+
+	entry = calloc(1, sizeof(fcache_entry_t));
+	if (entry == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	entry->name = str_dup(name);
+	entry->data = malloc(max(stat.size, 1));
+	if (entry->name == NULL || entry->data == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	pos = 0;
+	while (pos < stat.size) {
+		rc = vfs_read(fd, &pos, entry->data + pos, stat.size - pos,
+		    &nr);
+		if (rc != EOK)
+			goto error;
+
+		if (nr == 0)
+			break;
+	}
+
+	(void) vfs_put(fd);
+	fd = -1;
+
+	entry->size = pos;
+	entry->service_id = stat.service_id;
+	entry->index = stat.index;
+
+	rc = fcache_hdr(name, entry->size, &entry->hdr);
+	if (rc != EOK)
+		goto error;
+
+	entry->hdr_size = str_size(entry->hdr);
+	entry->refcnt = 1;
+	getuptime(&entry->loaded);
+	entry->validated = entry->loaded;
+
+	*rentry = entry;
+	return EOK;
+error:
+	if (fd >= 0)
+		(void) vfs_put(fd);
+	if (entry != NULL)
+		fcache_entry_free(entry);
+	return rc;
+}
+
+/** Insert loaded file into the cache, evicting other files if needed. */
+static void fcache_insert(fcache_entry_t *entry)
+{
+	size_t size = entry->size + entry->hdr_size;
+	ht_link_t *link;
+
+	assert(fibril_mutex_is_locked(&fcache_lock));
+
+	/* Another fibril could have loaded the file in the meantime */
+	link = hash_table_find(&fcache_map, entry->name);
+	if (link != NULL) {
+		fcache_entry_remove(hash_table_get_inst(link, fcache_entry_t,
+		    lhash));
+	}
+
+	if (size > fcache_max)
+		return;
+
+	while (fcache_used + size > fcache_max) {
+		assert(!list_empty(&fcache_lru));
+		fcache_entry_remove(list_get_instance(list_first(&fcache_lru),
+		    fcache_entry_t, llru));
+	}
+
+	hash_table_insert(&fcache_map, &entry->lhash);
+	list_append(&entry->llru, &fcache_lru);
+	fcache_used += size;
+	entry->cached = true;
+	++entry->refcnt;
+}
+
+/** Check cached file against the file system.
+ *
+ * Called with the cache locked and a reference to @a entry held.
+ * The cache is unlocked while talking to the file system.
+ *
+ * @param entry Cached file
+ * @param now   Current time
+ *
+ * @return @c true if the cached file can still be used
+ */
+static bool fcache_entry_validate(fcache_entry_t *entry,
+    struct timespec *now)
+{
+	vfs_stat_t stat;
+	errno_t rc;
+
+	if (ts_sub_diff(now, &entry->validated) < FCACHE_VALID_NSEC)
+		return true;
+
+	if (ts_sub_diff(now, &entry->loaded) >= FCACHE_MAX_AGE_NSEC)
+		return false;
+
+	fibril_mutex_unlock(&fcache_lock);
+	rc = vfs_stat_path(entry->name, &stat);
+	fibril_mutex_lock(&fcache_lock);
+
+	if (rc != EOK || !stat.is_file || stat.service_id !=
+	    entry->service_id || stat.index != entry->index ||
+	    stat.size != entry->size)
+		return false;
+
+	entry->validated = *now;
+	return true;
+}
+
+/** Get file from the cache, loading it if necessary.
+ *
+ * @param name   File name
+ * @param rentry Place to store pointer to the cached file. The caller
+ *               must release it using fcache_put().
+ *
+ * @return EOK on success, ELIMIT if the file is too large to be cached
+ *         or an error code (ENOENT if the file does not exist)
+ */
+errno_t fcache_get(const char *name, fcache_entry_t **rentry)
+{
+	fcache_entry_t *entry;
+	struct timespec now;
+	ht_link_t *link;
+	errno_t rc;
+
+	fibril_mutex_lock(&fcache_lock);
+
+	link = hash_table_find(&fcache_map, name);
+	if (link != NULL) {
+		entry = hash_table_get_inst(link, fcache_entry_t, lhash);
+		++entry->refcnt;
+
+		getuptime(&now);
+		if (fcache_entry_validate(entry, &now)) {
+			/* Move to the most recently used end */
+			if (entry->cached) {
+				list_remove(&entry->llru);
+				list_append(&entry->llru, &fcache_lru);
+			}
+
+			fibril_mutex_unlock(&fcache_lock);
+			*rentry = entry;
+			return EOK;
+		}
+
+		if (entry->cached)
+			fcache_entry_remove(entry);
+		fcache_entry_delref(entry);
+	}
+
+	fibril_mutex_unlock(&fcache_lock);
+
+	rc = fcache_load(name, &entry);
+	if (rc != EOK)
+		return rc;
+
+	fibril_mutex_lock(&fcache_lock);
+	fcache_insert(entry);
+	fibril_mutex_unlock(&fcache_lock);
+
+	*rentry = entry;
+	return EOK;
+}
+
+/** Release file obtained by fcache_get().
+ *
+ * @param entry Cached file
+ */
+void fcache_put(fcache_entry_t *entry)
+{
+	fibril_mutex_lock(&fcache_lock);
+	fcache_entry_delref(entry);
+	fibril_mutex_unlock(&fcache_lock);
+}
+
+/** @}
+ */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup websrv
+ * @{
+ */
+/**
+ * @file File cache.
+ */
+
+#ifndef FCACHE_H
+#define FCACHE_H
+
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <errno.h>
+#include <ipc/loc.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <vfs/vfs.h>
+
+/** Build response header for a cached file.
+ *
+ * Called when a file is loaded into the cache with the file name and
+ * size. Returns a newly allocated header string.
+ */
+typedef errno_t (*fcache_hdr_fn_t)(const char *, size_t, char **);
+
+/** Cached file */
+typedef struct {
+	/** Link to cache map */
+	ht_link_t lhash;
+	/** Link to LRU list */
+	link_t llru;
+	/** Number of references, including the one held by the cache */
+	unsigned refcnt;
+	/** @c true while the entry is in the cache */
+	bool cached;
+	/** File name */
+	char *name;
+	/** Service ID of the file system holding the file */
+	service_id_t service_id;
+	/** Index of the file in its file system */
+	fs_index_t index;
+	/** When the file was loaded */
+	struct timespec loaded;
+	/** When the entry was last checked against the file system */
+	struct timespec validated;
+	/** Precomputed response header */
+	char *hdr;
+	/** Size of the response header in bytes */
+	size_t hdr_size;
+	/** File data */
+	void *data;
+	/** Size of file data in bytes */
+	size_t size;
+} fcache_entry_t;
+
+extern errno_t fcache_init(size_t, size_t, fcache_hdr_fn_t);
+extern errno_t fcache_get(const char *, fcache_entry_t **);
+extern void fcache_put(fcache_entry_t *);
+
+#endif
+
+/** @}
+ */
@@ -33,8 +33,9 @@
  * @file Skeletal web server.
  */
 
+#include <as.h>
 #include <errno.h>
-#include <assert.h>
+#include <fibril_synch.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -50,17 +51,46 @@
 
 #include <arg_parse.h>
 #include <macros.h>
+#include <mem.h>
 #include <str.h>
 #include <str_error.h>
 
+#include <http/http.h>
+
+#include "fcache.h"
+
 #define NAME  "websrv"
 
 #define DEFAULT_PORT  8080
 
 #define WEB_ROOT  "/data/web"
 
-/** Buffer for receiving the request. */
-#define BUFFER_SIZE  1024
+/** Buffer for receiving requests. Also limits the size of request header. */
+#define BUFFER_SIZE  4096
+
+/** Size of the shared ring for sending responses. */
+#define SEND_RING_SIZE  (64 * 1024)
+
+/** Size of the buffer for sending files not kept in the cache. */
+#define FILE_BUF_SIZE  (64 * 1024)
+
+/** Maximum memory used by the file cache. */
+#define FCACHE_SIZE  (1024 * 1024)
+
+/** Maximum size of a file kept in the file cache. */
+#define FCACHE_FILE_MAX  (64 * 1024)
+
+/** Default maximum number of connections served at the same time. */
+#define DEFAULT_CONN_MAX  32
+
+/** Default maximum number of connections waiting to be served. */
+#define DEFAULT_BACKLOG  64
+
+/** How long an idle persistent connection is kept open. */
+#define KEEPALIVE_TIMEOUT  SEC2USEC(15)
+
+/** Maximum number of requests served over one connection. */
+#define KEEPALIVE_MAX  100
 
 static void websrv_new_conn(tcp_listener_t *, tcp_conn_t *);
 
@@ -74,28 +104,49 @@ static tcp_cb_t conn_cb = {
 
 static uint16_t port = DEFAULT_PORT;
 
-typedef struct {
-	tcp_conn_t *conn;
+/** Maximum number of connections served at the same time. */
+static int conn_max = DEFAULT_CONN_MAX;
+
+/** Maximum number of connections waiting to be served. */
+static int backlog = DEFAULT_BACKLOG;
+
+/** Protects conn_active and conn_waiting. */
+static FIBRIL_MUTEX_INITIALIZE(conn_lock);
+
+/** Signalled when a connection stops being served. */
+static FIBRIL_CONDVAR_INITIALIZE(conn_cv);
 
-	char rbuf[BUFFER_SIZE];
-	size_t rbuf_out;
-	size_t rbuf_in;
+/** Number of connections being served. */
+static int conn_active = 0;
 
-	char lbuf[BUFFER_SIZE + 1];
-	size_t lbuf_used;
-} recv_t;
+/** Number of connections waiting to be served. */
+static int conn_waiting = 0;
+
+/** HTTP request
+ *
+ * The method and URI point into the receive buffer and are valid only
+ * until the request body is read.
+ */
+typedef struct {
+	/** Method */
+	http_slice_t method;
+	/** Requested URI */
+	http_slice_t uri;
+	/** Respond without body */
+	bool head;
+	/** Keep the connection open after the response */
+	bool keepalive;
+	/** @c true for HTTP/1.0 clients, which need keep-alive announced */
+	bool http10;
+	/** Request body */
+	http_body_t body;
+} req_t;
 
 static bool verbose = false;
 
 /** Responses to send to client. */
 
-static const char *msg_ok =
-    "HTTP/1.0 200 OK\r\n"
-    "\r\n";
-
 static const char *msg_bad_request =
-    "HTTP/1.0 400 Bad Request\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>400 Bad Request</title>\r\n"
@@ -107,8 +158,6 @@ static const char *msg_bad_request =
     "</html>\r\n";
 
 static const char *msg_not_found =
-    "HTTP/1.0 404 Not Found\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>404 Not Found</title>\r\n"
@@ -119,9 +168,18 @@ static const char *msg_not_found =
     "</body>\r\n"
     "</html>\r\n";
 
+static const char *msg_internal_error =
+    "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
+    "<html><head>\r\n"
+    "<title>500 Internal Server Error</title>\r\n"
+    "</head>\r\n"
+    "<body>\r\n"
+    "<h1>Internal Server Error</h1>\r\n"
+    "<p>The server could not complete the request.</p>\r\n"
+    "</body>\r\n"
+    "</html>\r\n";
+
 static const char *msg_not_implemented =
-    "HTTP/1.0 501 Not Implemented\r\n"
-    "\r\n"
     "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
     "<html><head>\r\n"
     "<title>501 Not Implemented</title>\r\n"
@@ -132,209 +190,488 @@ static const char *msg_not_implemented =
     "</body>\r\n"
     "</html>\r\n";
 
-static errno_t recv_create(tcp_conn_t *conn, recv_t **rrecv)
+static const char *msg_unavailable =
+    "<!DOCTYPE HTML PUBLIC \"-//IETF//DTD HTML 2.0//EN\">\r\n"
+    "<html><head>\r\n"
+    "<title>503 Service Unavailable</title>\r\n"
+    "</head>\r\n"
+    "<body>\r\n"
+    "<h1>Service Unavailable</h1>\r\n"
+    "<p>The server is too busy, please try again later.</p>\r\n"
+    "</body>\r\n"
+    "</html>\r\n";
+
+/** Content types by file name extension. */
+static struct {
+	const char *ext;
+	const char *type;
+} content_types[] = {
+	{ ".html", "text/html" },
+	{ ".htm", "text/html" },
+	{ ".txt", "text/plain" },
+	{ ".css", "text/css" },
+	{ ".js", "text/javascript" },
+	{ ".json", "application/json" },
+	{ ".png", "image/png" },
+	{ ".jpg", "image/jpeg" },
+	{ ".gif", "image/gif" },
+	{ ".svg", "image/svg+xml" },
+	{ ".ico", "image/x-icon" }
+};
+
+/** Receive data for the receive buffer.
+ *
+ * A connection that was reset or stayed idle for too long is treated
+ * as closed.
+ */
+static errno_t websrv_receive(void *arg, void *buf, size_t size,
+    size_t *nrecv)
 {
-	recv_t *recv;
+	tcp_conn_t *conn = (tcp_conn_t *) arg;
+	errno_t rc;
 
-	recv = calloc(1, sizeof(recv_t));
-	if (recv == NULL)
-		return ENOMEM;
+	rc = tcp_conn_recv_wait_timeout(conn, buf, size, KEEPALIVE_TIMEOUT,
+	    nrecv);
+	if (rc == ETIMEOUT || rc == ECONNRESET) {
+		*nrecv = 0;
+		return EOK;
+	}
 
-	recv->conn = conn;
-	recv->rbuf_out = 0;
-	recv->rbuf_in = 0;
-	recv->lbuf_used = 0;
+	if (rc != EOK)
+		fprintf(stderr, "tcp_conn_recv() failed: %s\n", str_error(rc));
 
-	*rrecv = recv;
-	return EOK;
+	return rc;
 }
 
-static void recv_destroy(recv_t *recv)
+/** Initialize request for responding before it could be parsed. */
+static void req_init(req_t *req)
 {
-	free(recv);
+	memset(req, 0, sizeof(req_t));
 }
 
-/** Receive one character (with buffering) */
-static errno_t recv_char(recv_t *recv, char *c)
+/** Parse request header.
+ *
+ * @param parser Parser of the received request header
+ * @param rb     Receive buffer
+ * @param req    Place to store parsed request
+ *
+ * @return EOK on success, EINVAL if the header is malformed, ENOTSUP
+ *         if the request body uses transfer coding we do not support
+ */
+static errno_t req_parse(http_parser_t *parser, receive_buffer_t *rb,
+    req_t *req)
 {
-	size_t nrecv;
+	http_version_t version;
+	http_field_t field;
+	uint64_t length = 0;
+	bool chunked = false;
 	errno_t rc;
 
-	if (recv->rbuf_out == recv->rbuf_in) {
-		recv->rbuf_out = 0;
-		recv->rbuf_in = 0;
+	memset(req, 0, sizeof(req_t));
 
-		rc = tcp_conn_recv_wait(recv->conn, recv->rbuf, BUFFER_SIZE, &nrecv);
-		if (rc != EOK) {
-			fprintf(stderr, "tcp_conn_recv() failed: %s\n", str_error(rc));
-			return rc;
-		}
+	rc = http_parser_request_line(parser, &req->method, &req->uri,
+	    &version);
+	if (rc != EOK)
+		return EINVAL;
 
-		recv->rbuf_in = nrecv;
+	if (verbose) {
+		fprintf(stderr, "Request: %.*s %.*s\n", (int) req->method.size,
+		    req->method.data, (int) req->uri.size, req->uri.data);
+	}
+
+	req->head = http_slice_equal(&req->method, "HEAD");
+	if (version.major == 1 && version.minor >= 1)
+		req->keepalive = true;
+	else if (version.major == 1 && version.minor == 0)
+		req->http10 = true;
+
+	while ((rc = http_parser_field(parser, &field)) == EOK) {
+		if (http_slice_equal_nocase(&field.name, "Connection")) {
+			if (http_slice_has_token(&field.value, "close"))
+				req->keepalive = false;
+			else if (http_slice_has_token(&field.value,
+			    "keep-alive"))
+				req->keepalive = true;
+		} else if (http_slice_equal_nocase(&field.name,
+		    "Content-Length")) {
+			if (http_slice_uint64(&field.value, 10, &length) != EOK)
+				return EINVAL;
+		} else if (http_slice_equal_nocase(&field.name,
+		    "Transfer-Encoding")) {
+			if (!http_slice_has_token(&field.value, "chunked"))
+				return ENOTSUP;
+			chunked = true;
+		}
 	}
 
-	*c = recv->rbuf[recv->rbuf_out++];
+	if (rc != ENOENT)
+		return EINVAL;
+
+	http_body_init(&req->body, rb, chunked ? http_body_chunked :
+	    http_body_length, length);
 	return EOK;
 }
 
-/** Receive one line with length limit */
-static errno_t recv_line(recv_t *recv, char **rbuf)
+static bool uri_is_valid(http_slice_t *uri)
 {
-	char *bp = recv->lbuf;
-	char c = '\0';
+	if (uri->size < 1 || uri->data[0] != '/')
+		return false;
 
-	while (bp < recv->lbuf + BUFFER_SIZE) {
-		char prev = c;
-		errno_t rc = recv_char(recv, &c);
+	if (uri->size > 1 && uri->data[1] == '.')
+		return false;
 
-		if (rc != EOK)
-			return rc;
+	if (memchr(uri->data + 1, '/', uri->size - 1) != NULL)
+		return false;
 
-		*bp++ = c;
-		if ((prev == '\r') && (c == '\n'))
-			break;
+	if (memchr(uri->data, '\0', uri->size) != NULL)
+		return false;
+
+	return true;
+}
+/** Determine content type of a file from the file name. */
+static const char *content_type(const char *fname)
+{
+	const char *ext = str_rchr(fname, '.');
+	size_t i;
+
+	if (ext != NULL) {
+		for (i = 0; i < sizeof(content_types) /
+		    sizeof(content_types[0]); i++) {
+			if (str_casecmp(ext, content_types[i].ext) == 0)
+				return content_types[i].type;
+		}
 	}
 
-	recv->lbuf_used = bp - recv->lbuf;
-	*bp = '\0';
+	return "application/octet-stream";
+}
 
-	if (bp == recv->lbuf + BUFFER_SIZE)
-		return ELIMIT;
+/** Build response header for a cached file.
+ *
+ * The header is not terminated by an empty line so that the connection
+ * header field can be added to it.
+ */
+static errno_t fcache_hdr_build(const char *fname, size_t size, char **rhdr)
+{
+	if (asprintf(rhdr, "HTTP/1.1 200 OK\r\n"
+	    "Content-Type: %s\r\n"
+	    "Content-Length: %zu\r\n", content_type(fname), size) < 0)
+		return ENOMEM;
 
-	*rbuf = recv->lbuf;
 	return EOK;
 }
 
-static bool uri_is_valid(char *uri)
+/** Send data to client. */
+static errno_t send_data(tcp_conn_t *conn, const void *data, size_t size)
 {
-	if (uri[0] != '/')
-		return false;
+	errno_t rc = tcp_conn_send(conn, data, size);
+	if (rc != EOK) {
+		fprintf(stderr, "tcp_conn_send() failed\n");
+		return rc;
+	}
 
-	if (uri[1] == '.')
-		return false;
+	return EOK;
+}
 
-	char *cp = uri + 1;
+/** Send the end of response header.
+ *
+ * @param conn Connection
+ * @param req  Request being responded to
+ */
+static errno_t send_hdr_end(tcp_conn_t *conn, req_t *req)
+{
+	const char *end;
 
-	while (*cp != '\0') {
-		char c = *cp++;
-		if (c == '/')
-			return false;
-	}
+	if (!req->keepalive)
+		end = "Connection: close\r\n\r\n";
+	else if (req->http10)
+		end = "Connection: keep-alive\r\n\r\n";
+	else
+		end = "\r\n";
 
-	return true;
+	return send_data(conn, end, str_size(end));
 }
 
-static errno_t send_response(tcp_conn_t *conn, const char *msg)
+/** Send response header.
+ *
+ * @param conn   Connection
+ * @param req    Request being responded to
+ * @param status Status code and reason phrase
+ * @param ctype  Content type
+ * @param size   Size of response body
+ */
+static errno_t send_hdr(tcp_conn_t *conn, req_t *req, const char *status,
+    const char *ctype, aoff64_t size)
+{
+	char *hdr;
+	errno_t rc;
+
+	if (asprintf(&hdr, "HTTP/1.1 %s\r\n"
+	    "Content-Type: %s\r\n"
+	    "Content-Length: %" PRIuOFF64 "\r\n", status, ctype, size) < 0)
+		return ENOMEM;
+
+	rc = send_data(conn, hdr, str_size(hdr));
+	free(hdr);
+	if (rc != EOK)
+		return rc;
+
+	return send_hdr_end(conn, req);
+}
+
+static errno_t send_response(tcp_conn_t *conn, req_t *req,
+    const char *status, const char *msg)
 {
 	size_t response_size = str_size(msg);
+	errno_t rc;
 
 	if (verbose)
 		fprintf(stderr, "Sending response\n");
 
-	errno_t rc = tcp_conn_send(conn, (void *) msg, response_size);
-	if (rc != EOK) {
-		fprintf(stderr, "tcp_conn_send() failed\n");
+	rc = send_hdr(conn, req, status, "text/html", response_size);
+	if (rc != EOK)
 		return rc;
-	}
 
-	return EOK;
+	if (req->head)
+		return EOK;
+
+	return send_data(conn, msg, response_size);
 }
 
-static errno_t uri_get(const char *uri, tcp_conn_t *conn)
+/** Send file that is not kept in the cache.
+ *
+ * If possible, the file system server reads the file straight to
+ * a buffer shared with us and the data is copied from there into the
+ * ring shared with the TCP service.
+ */
+static errno_t uri_send_file(const char *fname, tcp_conn_t *conn,
+    req_t *req)
 {
-	char *fbuf = NULL;
-	char *fname = NULL;
-	errno_t rc;
+	vfs_stat_t stat;
+	void *fbuf = NULL;
+	bool shared = false;
+	aoff64_t pos;
 	size_t nr;
 	int fd = -1;
+	errno_t rc;
 
-	fbuf = calloc(BUFFER_SIZE, 1);
-	if (fbuf == NULL) {
-		rc = ENOMEM;
-		goto out;
-	}
-
-	if (str_cmp(uri, "/") == 0)
-		uri = "/index.html";
+	rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ, &fd);
+	if (rc != EOK)
+		return send_response(conn, req, "404 Not Found", msg_not_found);
 
-	if (asprintf(&fname, "%s%s", WEB_ROOT, uri) < 0) {
-		rc = ENOMEM;
+	rc = vfs_stat(fd, &stat);
+	if (rc != EOK) {
+		rc = send_response(conn, req, "500 Internal Server Error",
+		    msg_internal_error);
 		goto out;
 	}
 
-	rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ, &fd);
-	if (rc != EOK) {
-		rc = send_response(conn, msg_not_found);
+	rc = send_hdr(conn, req, "200 OK", content_type(fname), stat.size);
+	if (rc != EOK || req->head)
 		goto out;
-	}
 
-	free(fname);
-	fname = NULL;
+	rc = vfs_read_buffer_create(fd, FILE_BUF_SIZE, &fbuf);
+	if (rc == EOK) {
+		shared = true;
+	} else {
+		fbuf = malloc(FILE_BUF_SIZE);
+		if (fbuf == NULL) {
+			rc = ENOMEM;
+			goto out;
+		}
+	}
 
-	rc = send_response(conn, msg_ok);
-	if (rc != EOK)
-		goto out;
+	pos = 0;
+	while (pos < stat.size) {
+		size_t nbyte = min(stat.size - pos, FILE_BUF_SIZE);
 
-	aoff64_t pos = 0;
-	while (true) {
-		rc = vfs_read(fd, &pos, fbuf, BUFFER_SIZE, &nr);
+		if (shared)
+			rc = vfs_read_buffer(fd, &pos, 0, nbyte, &nr);
+		else
+			rc = vfs_read(fd, &pos, fbuf, nbyte, &nr);
 		if (rc != EOK)
 			goto out;
 
-		if (nr == 0)
-			break;
-
-		rc = tcp_conn_send(conn, fbuf, nr);
-		if (rc != EOK) {
-			fprintf(stderr, "tcp_conn_send() failed\n");
+		/* File shrank, we cannot send as much as promised */
+		if (nr == 0) {
+			rc = EIO;
 			goto out;
 		}
+
+		rc = send_data(conn, fbuf, nr);
+		if (rc != EOK)
+			goto out;
 	}
 
 	rc = EOK;
 out:
 	if (fd >= 0)
 		vfs_put(fd);
-	free(fname);
-	free(fbuf);
+	if (shared)
+		as_area_destroy(fbuf);
+	else
+		free(fbuf);
 	return rc;
 }
 
-static errno_t req_process(tcp_conn_t *conn, recv_t *recv)
+static errno_t uri_get(http_slice_t *uri, tcp_conn_t *conn, req_t *req)
 {
-	char *reqline = NULL;
+	fcache_entry_t *entry;
+	char *fname = NULL;
+	errno_t rc;
+	int rv;
 
-	errno_t rc = recv_line(recv, &reqline);
-	if (rc != EOK) {
-		fprintf(stderr, "recv_line() failed\n");
+	if (http_slice_equal(uri, "/")) {
+		rv = asprintf(&fname, "%s/index.html", WEB_ROOT);
+	} else {
+		rv = asprintf(&fname, "%s%.*s", WEB_ROOT, (int) uri->size,
+		    uri->data);
+	}
+
+	if (rv < 0)
+		return ENOMEM;
+
+	rc = fcache_get(fname, &entry);
+	if (rc == ELIMIT) {
+		rc = uri_send_file(fname, conn, req);
+		free(fname);
 		return rc;
 	}
 
-	if (verbose)
-		fprintf(stderr, "Request: %s", reqline);
+	free(fname);
+
+	if (rc == ENOENT)
+		return send_response(conn, req, "404 Not Found", msg_not_found);
+	if (rc != EOK) {
+		return send_response(conn, req, "500 Internal Server Error",
+		    msg_internal_error);
+	}
 
-	if (str_lcmp(reqline, "GET ", 4) != 0) {
-		rc = send_response(conn, msg_not_implemented);
+	rc = send_data(conn, entry->hdr, entry->hdr_size);
+	if (rc == EOK)
+		rc = send_hdr_end(conn, req);
+	if (rc == EOK && !req->head)
+		rc = send_data(conn, entry->data, entry->size);
+
+	fcache_put(entry);
+	return rc;
+}
+
+/** Receive and process one request.
+ *
+ * @param conn      Connection
+ * @param rb        Receive buffer
+ * @param last      This is the last request served over the connection
+ * @param keepalive Place to store @c true if the connection can be reused
+ *
+ * @return EOK on success, ENOENT if the connection was closed or idle
+ *         for too long or other error code
+ */
+static errno_t req_process(tcp_conn_t *conn, receive_buffer_t *rb, bool last,
+    bool *keepalive)
+{
+	http_parser_t parser;
+	req_t req;
+
+	errno_t rc = http_parser_receive(&parser, rb, 0);
+	if (rc == ELIMIT) {
+		req_init(&req);
+		*keepalive = false;
+		return send_response(conn, &req, "400 Bad Request",
+		    msg_bad_request);
+	}
+
+	if (rc != EOK) {
+		if (rc != ENOENT)
+			fprintf(stderr, "http_parser_receive() failed\n");
 		return rc;
 	}
 
-	char *uri = reqline + 4;
-	char *end_uri = str_chr(uri, ' ');
-	if (end_uri == NULL) {
-		end_uri = reqline + str_size(reqline) - 2;
-		assert(*end_uri == '\r');
+	rc = req_parse(&parser, rb, &req);
+	if (rc == ENOTSUP) {
+		req.keepalive = false;
+		*keepalive = false;
+		return send_response(conn, &req, "501 Not Implemented",
+		    msg_not_implemented);
 	}
 
-	*end_uri = '\0';
-	if (verbose)
-		fprintf(stderr, "Requested URI: %s\n", uri);
+	if (rc != EOK) {
+		req_init(&req);
+		*keepalive = false;
+		return send_response(conn, &req, "400 Bad Request",
+		    msg_bad_request);
+	}
+
+	http_parser_end(&parser);
+
+	if (last)
+		req.keepalive = false;
+	*keepalive = req.keepalive;
+
+	if (!http_slice_equal(&req.method, "GET") && !req.head) {
+		rc = send_response(conn, &req, "501 Not Implemented",
+		    msg_not_implemented);
+	} else if (!uri_is_valid(&req.uri)) {
+		rc = send_response(conn, &req, "400 Bad Request",
+		    msg_bad_request);
+	} else {
+		rc = uri_get(&req.uri, conn, &req);
+	}
 
-	if (!uri_is_valid(uri)) {
-		rc = send_response(conn, msg_bad_request);
+	if (rc != EOK || !req.keepalive)
 		return rc;
+
+	/*
+	 * Skip the request body. This may move data in the receive buffer,
+	 * so the method and URI must not be used afterwards.
+	 */
+	return http_body_skip(&req.body);
+}
+
+/** Wait until the connection can be served.
+ *
+ * @return EOK when the connection can be served, ELIMIT if too many
+ *         connections are waiting already
+ */
+static errno_t conn_admit(void)
+{
+	fibril_mutex_lock(&conn_lock);
+
+	if (conn_active >= conn_max) {
+		if (conn_waiting >= backlog) {
+			fibril_mutex_unlock(&conn_lock);
+			return ELIMIT;
+		}
+
+		++conn_waiting;
+		while (conn_active >= conn_max)
+			fibril_condvar_wait(&conn_cv, &conn_lock);
+		--conn_waiting;
 	}
 
-	return uri_get(uri, conn);
+	++conn_active;
+	fibril_mutex_unlock(&conn_lock);
+	return EOK;
+}
+
+/** Stop serving connection, letting a waiting one in. */
+static void conn_release(void)
+{
+	fibril_mutex_lock(&conn_lock);
+	--conn_active;
+	fibril_condvar_signal(&conn_cv);
+	fibril_mutex_unlock(&conn_lock);
+}
+
+/** Determine whether other connections are waiting to be served. */
+static bool conn_contended(void)
+{
+	bool contended;
+
+	fibril_mutex_lock(&conn_lock);
+	contended = conn_waiting > 0;
+	fibril_mutex_unlock(&conn_lock);
+
+	return contended;
 }
 
 static void usage(void)
@@ -347,6 +684,14 @@ static void usage(void)
 	    "-p port_number | --port=port_number\n"
 	    "\tListening port (default " STRING(DEFAULT_PORT) ").\n"
 	    "\n"
+	    "-c count | --max-conn=count\n"
+	    "\tMaximum number of connections served at the same time\n"
+	    "\t(default " STRING(DEFAULT_CONN_MAX) ").\n"
+	    "\n"
+	    "-b count | --backlog=count\n"
+	    "\tMaximum number of connections waiting to be served\n"
+	    "\t(default " STRING(DEFAULT_BACKLOG) ").\n"
+	    "\n"
 	    "-h | --help\n"
 	    "\tShow this application help.\n"
 	    "-v | --verbose\n"
@@ -359,6 +704,16 @@ static errno_t parse_option(int argc, char *argv[], int *index)
 	errno_t rc;
 
 	switch (argv[*index][1]) {
+	case 'b':
+		rc = arg_parse_int(argc, argv, index, &backlog, 0);
+		if (rc != EOK || backlog < 0)
+			return EINVAL;
+		break;
+	case 'c':
+		rc = arg_parse_int(argc, argv, index, &conn_max, 0);
+		if (rc != EOK || conn_max < 1)
+			return EINVAL;
+		break;
 	case 'h':
 		usage();
 		exit(0);
@@ -384,6 +739,14 @@ static errno_t parse_option(int argc, char *argv[], int *index)
 				return rc;
 
 			port = (uint16_t) value;
+		} else if (str_lcmp(argv[*index] + 2, "max-conn=", 9) == 0) {
+			rc = arg_parse_int(argc, argv, index, &conn_max, 11);
+			if (rc != EOK || conn_max < 1)
+				return EINVAL;
+		} else if (str_lcmp(argv[*index] + 2, "backlog=", 8) == 0) {
+			rc = arg_parse_int(argc, argv, index, &backlog, 10);
+			if (rc != EOK || backlog < 0)
+				return EINVAL;
 		} else if (str_cmp(argv[*index] + 2, "verbose") == 0) {
 			verbose = true;
 		} else {
@@ -399,25 +762,79 @@ static errno_t parse_option(int argc, char *argv[], int *index)
 	return EOK;
 }
 
+/** Refuse connection because the server is too busy. */
+static void websrv_refuse_conn(tcp_conn_t *conn)
+{
+	req_t req;
+
+	if (verbose)
+		fprintf(stderr, "Too many connections, refusing\n");
+
+	req_init(&req);
+
+	if (send_response(conn, &req, "503 Service Unavailable",
+	    msg_unavailable) != EOK || tcp_conn_send_fin(conn) != EOK)
+		(void) tcp_conn_reset(conn);
+}
+
 static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 {
 	errno_t rc;
-	recv_t *recv = NULL;
+	receive_buffer_t rb;
+	bool keepalive;
+	int nreq;
+
+	rc = conn_admit();
+	if (rc != EOK) {
+		websrv_refuse_conn(conn);
+		return;
+	}
 
 	if (verbose)
 		fprintf(stderr, "New connection, waiting for request\n");
 
-	rc = recv_create(conn, &recv);
+	rc = recv_buffer_init(&rb, BUFFER_SIZE, websrv_receive, conn);
 	if (rc != EOK) {
 		fprintf(stderr, "Out of memory.\n");
 		goto error;
 	}
 
-	rc = req_process(conn, recv);
-	if (rc != EOK) {
-		fprintf(stderr, "Error processing request (%s)\n",
+	/* Pass response data through shared memory if possible */
+	rc = tcp_conn_send_ring(conn, SEND_RING_SIZE);
+	if (rc != EOK && verbose) {
+		fprintf(stderr, "Using IPC to send data (%s)\n",
 		    str_error(rc));
-		goto error;
+	}
+
+	for (nreq = 1; true; nreq++) {
+		rc = req_process(conn, &rb, nreq == KEEPALIVE_MAX, &keepalive);
+		if (rc == ENOENT) {
+			/* Connection closed or idle */
+			break;
+		}
+
+		if (rc != EOK) {
+			fprintf(stderr, "Error processing request (%s)\n",
+			    str_error(rc));
+			goto error;
+		}
+
+		if (!keepalive)
+			break;
+
+		/*
+		 * Responses to pipelined requests are sent together, flush
+		 * them once there are no more requests to respond to.
+		 */
+		if (!http_parser_buffered(&rb)) {
+			rc = tcp_conn_push(conn);
+			if (rc != EOK)
+				goto error;
+
+			/* Make room for connections waiting to be served */
+			if (rb.out == rb.in && conn_contended())
+				break;
+		}
 	}
 
 	rc = tcp_conn_send_fin(conn);
@@ -426,14 +843,16 @@ static void websrv_new_conn(tcp_listener_t *lst, tcp_conn_t *conn)
 		goto error;
 	}
 
-	recv_destroy(recv);
+	recv_buffer_fini(&rb);
+	conn_release();
 	return;
 error:
 	rc = tcp_conn_reset(conn);
 	if (rc != EOK)
 		fprintf(stderr, "Error resetting connection.\n");
 
-	recv_destroy(recv);
+	recv_buffer_fini(&rb);
+	conn_release();
 }
 
 int main(int argc, char *argv[])
@@ -460,6 +879,12 @@ int main(int argc, char *argv[])
 	if (verbose)
 		fprintf(stderr, "Creating listener\n");
 
+	rc = fcache_init(FCACHE_SIZE, FCACHE_FILE_MAX, fcache_hdr_build);
+	if (rc != EOK) {
+		fprintf(stderr, "Error initializing file cache.\n");
+		return 1;
+	}
+
 	inet_ep_init(&ep);
 	ep.port = port;
 
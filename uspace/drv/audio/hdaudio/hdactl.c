@@ -40,6 +40,7 @@
 #include <errno.h>
 #include <fibril_synch.h>
 #include <macros.h>
+#include <mem.h>
 #include <stdint.h>
 
 #include "codec.h"
@@ -337,6 +338,54 @@ static void hda_rirb_fini(hda_t *hda)
 		dmamem_unmap_anonymous(hda->ctl->rirb_virt);
 }
 
+/** Initialize the DMA Position Buffer
+ *
+ * The controller then keeps the position of every running stream in
+ * memory, which is cheaper to read than the LPIB registers.
+ */
+static errno_t hda_dmapos_init(hda_t *hda)
+{
+	size_t nsdesc;
+	errno_t rc;
+
+	nsdesc = hda->ctl->iss + hda->ctl->oss + hda->ctl->bss;
+
+	/*
+	 * DMA Position Buffer must be aligned to 128 bytes. If 64OK is not
+	 * set, it must be within the 32-bit address space.
+	 */
+	hda->ctl->dmapos_virt = AS_AREA_ANY;
+	rc = dmamem_map_anonymous(nsdesc * sizeof(hda_dma_pos_t),
+	    hda->ctl->ok64bit ? 0 : DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0,
+	    &hda->ctl->dmapos_phys, (void **)&hda->ctl->dmapos_virt);
+	if (rc != EOK) {
+		hda->ctl->dmapos_virt = NULL;
+		ddf_msg(LVL_NOTE, "Failed allocating DMA Position Buffer");
+		return rc;
+	}
+
+	memset(hda->ctl->dmapos_virt, 0, nsdesc * sizeof(hda_dma_pos_t));
+
+	hda_reg32_write(&hda->regs->dpubase, UPPER32(hda->ctl->dmapos_phys));
+	hda_reg32_write(&hda->regs->dplbase, LOWER32(hda->ctl->dmapos_phys) |
+	    BIT_V(uint32_t, dplbase_enable));
+
+	ddf_msg(LVL_NOTE, "DMA Position Buffer initialized");
+	return EOK;
+}
+
+/** Tear down the DMA Position Buffer */
+static void hda_dmapos_fini(hda_t *hda)
+{
+	hda_reg32_write(&hda->regs->dplbase, 0);
+	hda_reg32_write(&hda->regs->dpubase, 0);
+
+	if (hda->ctl->dmapos_virt != NULL) {
+		dmamem_unmap_anonymous(hda->ctl->dmapos_virt);
+		hda->ctl->dmapos_virt = NULL;
+	}
+}
+
 static size_t hda_get_corbrp(hda_t *hda)
 {
 	uint16_t corbrp;
@@ -599,6 +648,9 @@ hda_ctl_t *hda_ctl_init(hda_t *hda)
 	if (rc != EOK)
 		goto error;
 
+	/* Without the DMA Position Buffer we fall back to reading LPIB */
+	(void) hda_dmapos_init(hda);
+
 	ddf_msg(LVL_NOTE, "call hda_codec_init()");
 	hda->ctl->codec = hda_codec_init(hda, 0);
 	if (hda->ctl->codec == NULL) {
@@ -612,6 +664,7 @@ hda_ctl_t *hda_ctl_init(hda_t *hda)
 
 	return ctl;
 error:
+	hda_dmapos_fini(hda);
 	hda_rirb_fini(hda);
 	hda_corb_fini(hda);
 	free(ctl);
@@ -622,6 +675,7 @@ error:
 void hda_ctl_fini(hda_ctl_t *ctl)
 {
 	ddf_msg(LVL_NOTE, "hda_ctl_fini()");
+	hda_dmapos_fini(ctl->hda);
 	hda_rirb_fini(ctl->hda);
 	hda_corb_fini(ctl->hda);
 	free(ctl);
@@ -60,6 +60,10 @@ typedef struct hda_ctl {
 	size_t rirb_entries;
 	size_t rirb_rp;
 
+	/** DMA Position Buffer, NULL if not available */
+	uintptr_t dmapos_phys;
+	hda_dma_pos_t *dmapos_virt;
+
 	fibril_mutex_t solrb_lock;
 	fibril_condvar_t solrb_cv;
 	hda_rirb_entry_t solrb[softrb_entries];
@@ -48,6 +48,7 @@
 #include "hdaudio.h"
 #include "pcm_iface.h"
 #include "spec/regs.h"
+#include "stream.h"
 
 #define NAME "hdaudio"
 
@@ -387,16 +388,16 @@ static void hdaudio_interrupt(ipc_call_t *icall, ddf_dev_t *dev)
 	if (ipc_get_arg3(icall) != 0) {
 		/* Buffer completed */
 		hda_lock(hda);
-		if (hda->playing) {
-			hda_pcm_event(hda, PCM_EVENT_FRAMES_PLAYED);
-			hda_pcm_event(hda, PCM_EVENT_FRAMES_PLAYED);
-			hda_pcm_event(hda, PCM_EVENT_FRAMES_PLAYED);
-			hda_pcm_event(hda, PCM_EVENT_FRAMES_PLAYED);
-		} else if (hda->capturing) {
-			hda_pcm_event(hda, PCM_EVENT_FRAMES_CAPTURED);
-			hda_pcm_event(hda, PCM_EVENT_FRAMES_CAPTURED);
-			hda_pcm_event(hda, PCM_EVENT_FRAMES_CAPTURED);
-			hda_pcm_event(hda, PCM_EVENT_FRAMES_CAPTURED);
+		if (hda->pcm_stream != NULL && (hda->playing ||
+		    hda->capturing)) {
+			/* One event per completed period */
+			size_t periods =
+			    hda_stream_periods_elapsed(hda->pcm_stream);
+			while (periods-- > 0) {
+				hda_pcm_event(hda, hda->playing ?
+				    PCM_EVENT_FRAMES_PLAYED :
+				    PCM_EVENT_FRAMES_CAPTURED);
+			}
 		}
 
 		hda_unlock(hda);
@@ -33,9 +33,11 @@
  */
 
 #include <async.h>
+#include <align.h>
 #include <audio_pcm_iface.h>
 #include <ddf/log.h>
 #include <errno.h>
+#include <macros.h>
 #include <pcm/sample_format.h>
 #include <stdbool.h>
 
@@ -81,7 +83,9 @@ audio_pcm_iface_t hda_pcm_iface = {
 };
 
 enum {
-	max_buffer_size = 65536 /* XXX this is completely arbitrary */
+	max_buffer_size = 65536, /* XXX this is completely arbitrary */
+	/** Default period size if the client does not ask for one */
+	default_period_size = 16384
 };
 
 static hda_t *fun_to_hda(ddf_fun_t *fun)
@@ -111,13 +115,15 @@ static unsigned hda_query_cap(ddf_fun_t *fun, audio_cap_t cap)
 		/* Yes if we have an input converter */
 		return hda->ctl->codec->in_aw >= 0;
 	case AUDIO_CAP_BUFFER_POS:
-		return 0;
+		return 1;
 	case AUDIO_CAP_MAX_BUFFER:
 		return max_buffer_size;
 	case AUDIO_CAP_INTERRUPT_MIN_FRAMES:
 		return 128;
 	case AUDIO_CAP_INTERRUPT_MAX_FRAMES:
-		return 16384;
+		/* At least two periods must fit in the buffer */
+		return max_buffer_size / 2 /
+		    pcm_sample_format_frame_size(2, PCM_SAMPLE_SINT16_LE);
 	default:
 		return -1;
 	}
@@ -162,8 +168,13 @@ static errno_t hda_get_buffer(ddf_fun_t *fun, void **buffer, size_t *size)
 		return EBUSY;
 	}
 
+	/* Zero means the largest buffer possible */
+	if (*size == 0 || *size > max_buffer_size)
+		*size = max_buffer_size;
+	*size = ALIGN_UP(*size, hda_buffer_align);
+
 	ddf_msg(LVL_NOTE, "hda_get_buffer() - allocate stream buffers");
-	rc = hda_stream_buffers_alloc(hda, &hda->pcm_buffers);
+	rc = hda_stream_buffers_alloc(hda, *size, &hda->pcm_buffers);
 	if (rc != EOK) {
 		assert(rc == ENOMEM);
 		hda_unlock(hda);
@@ -171,9 +182,8 @@ static errno_t hda_get_buffer(ddf_fun_t *fun, void **buffer, size_t *size)
 	}
 
 	ddf_msg(LVL_NOTE, "hda_get_buffer() - fill info");
-	/* XXX This is only one buffer */
 	*buffer = hda->pcm_buffers->buf[0];
-	*size = hda->pcm_buffers->bufsize * hda->pcm_buffers->nbuffers;
+	*size = hda->pcm_buffers->size;
 
 	ddf_msg(LVL_NOTE, "hda_get_buffer() returing EOK, buffer=%p, size=%zu",
 	    *buffer, *size);
@@ -184,8 +194,45 @@ static errno_t hda_get_buffer(ddf_fun_t *fun, void **buffer, size_t *size)
 
 static errno_t hda_get_buffer_position(ddf_fun_t *fun, size_t *pos)
 {
-	ddf_msg(LVL_NOTE, "hda_get_buffer_position()");
-	return ENOTSUP;
+	hda_t *hda = fun_to_hda(fun);
+
+	hda_lock(hda);
+
+	if (hda->pcm_stream == NULL) {
+		hda_unlock(hda);
+		return EINVAL;
+	}
+
+	*pos = hda_stream_get_pos(hda->pcm_stream);
+
+	hda_unlock(hda);
+	return EOK;
+}
+
+/** Split PCM buffer into periods of the size requested by the client.
+ *
+ * @param hda HDA instance
+ * @param frames Period size in frames, zero to use the default
+ * @param channels Number of channels
+ * @param format Sample format
+ * @return EOK on success or an error code
+ */
+static errno_t hda_pcm_set_period(hda_t *hda, unsigned frames,
+    unsigned channels, pcm_sample_format_t format)
+{
+	size_t period;
+
+	if (hda->pcm_buffers == NULL)
+		return EINVAL;
+
+	if (frames != 0) {
+		period = frames *
+		    pcm_sample_format_frame_size(channels, format);
+	} else {
+		period = min(default_period_size, hda->pcm_buffers->size / 2);
+	}
+
+	return hda_stream_buffers_set_period(hda->pcm_buffers, period);
 }
 
 static errno_t hda_set_event_session(ddf_fun_t *fun, async_sess_t *sess)
@@ -247,6 +294,12 @@ static errno_t hda_start_playback(ddf_fun_t *fun, unsigned frames,
 		return EBUSY;
 	}
 
+	rc = hda_pcm_set_period(hda, frames, channels, format);
+	if (rc != EOK) {
+		hda_unlock(hda);
+		return rc;
+	}
+
 	/* XXX Choose appropriate parameters */
 	uint32_t fmt;
 	/* 48 kHz, 16-bits, 1 channel */
@@ -306,6 +359,12 @@ static errno_t hda_start_capture(ddf_fun_t *fun, unsigned frames, unsigned chann
 		return EBUSY;
 	}
 
+	rc = hda_pcm_set_period(hda, frames, channels, format);
+	if (rc != EOK) {
+		hda_unlock(hda);
+		return rc;
+	}
+
 	/* XXX Choose appropriate parameters */
 	uint32_t fmt;
 	/* 48 kHz, 16-bits, 1 channel */
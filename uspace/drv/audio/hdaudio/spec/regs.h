@@ -302,6 +302,19 @@ typedef enum {
 	respex_addr_l = 0
 } hda_respex_bits_t;
 
+typedef enum {
+	/** DMA Position Buffer Enable */
+	dplbase_enable = 0
+} hda_dplbase_bits_t;
+
+/** DMA Position Buffer entry, one per stream descriptor */
+typedef struct {
+	/** Link Position in Current Buffer */
+	uint32_t pos;
+	/** Reserved */
+	uint32_t reserved;
+} hda_dma_pos_t;
+
 #endif
 
 /** @}
@@ -33,6 +33,7 @@
  */
 
 #include <as.h>
+#include <assert.h>
 #include <bitops.h>
 #include <byteorder.h>
 #include <ddf/log.h>
@@ -48,33 +49,44 @@
 #include "spec/bdl.h"
 #include "stream.h"
 
-errno_t hda_stream_buffers_alloc(hda_t *hda, hda_stream_buffers_t **rbufs)
+/** Allocate cyclic stream buffer.
+ *
+ * The buffer is one contiguous DMA area, since audio_pcm_iface shares
+ * it as a whole. It is split into periods by
+ * hda_stream_buffers_set_period() once the period size is known.
+ *
+ * @param hda HDA instance
+ * @param size Buffer size in bytes, multiple of hda_buffer_align
+ * @param rbufs Place to store pointer to the new stream buffers
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t hda_stream_buffers_alloc(hda_t *hda, size_t size,
+    hda_stream_buffers_t **rbufs)
 {
 	void *bdl;
 	void *buffer;
 	uintptr_t buffer_phys;
 	hda_stream_buffers_t *bufs = NULL;
-	size_t i;
-	//size_t j, k;
 	errno_t rc;
 
+	assert(size > 0 && size % hda_buffer_align == 0);
+
 	bufs = calloc(1, sizeof(hda_stream_buffers_t));
 	if (bufs == NULL) {
 		rc = ENOMEM;
 		goto error;
 	}
 
-	bufs->nbuffers = 4;
-	bufs->bufsize = 16384;
+	bufs->size = size;
 
 	/*
 	 * BDL must be aligned to 128 bytes. If 64OK is not set,
 	 * it must be within the 32-bit address space.
 	 */
 	bdl = AS_AREA_ANY;
-	rc = dmamem_map_anonymous(bufs->nbuffers * sizeof(hda_buffer_desc_t),
-	    hda->ctl->ok64bit ? 0 : DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE,
-	    0, &bufs->bdl_phys, &bdl);
+	rc = dmamem_map_anonymous(hda_bdl_max_entries *
+	    sizeof(hda_buffer_desc_t), hda->ctl->ok64bit ? 0 : DMAMEM_4GiB,
+	    AS_AREA_READ | AS_AREA_WRITE, 0, &bufs->bdl_phys, &bdl);
 	if (rc != EOK)
 		goto error;
 
@@ -82,43 +94,17 @@ errno_t hda_stream_buffers_alloc(hda_t *hda, hda_stream_buffers_t **rbufs)
 
 	/* Allocate arrays of buffer pointers */
 
-	bufs->buf = calloc(bufs->nbuffers, sizeof(void *));
+	bufs->buf = calloc(hda_bdl_max_entries, sizeof(void *));
 	if (bufs->buf == NULL)
 		goto error;
 
-	bufs->buf_phys = calloc(bufs->nbuffers, sizeof(uintptr_t));
+	bufs->buf_phys = calloc(hda_bdl_max_entries, sizeof(uintptr_t));
 	if (bufs->buf_phys == NULL)
 		goto error;
 
-	/* Allocate buffers */
-#if 0
-	for (i = 0; i < bufs->nbuffers; i++) {
-		buffer = AS_AREA_ANY;
-		rc = dmamem_map_anonymous(bufs->bufsize,
-		    bufs->hda->ctl->ok64bit ? 0 : DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE,
-		    0, &buffer_phys, &buffer);
-		if (rc != EOK)
-			goto error;
-
-		ddf_msg(LVL_NOTE, "Stream buf phys=0x%llx virt=%p",
-		    (unsigned long long)buffer_phys, buffer);
-
-		bufs->buf[i] = buffer;
-		bufs->buf_phys[i] = buffer_phys;
-
-		k = 0;
-		for (j = 0; j < bufs->bufsize / 2; j++) {
-			int16_t *bp = bufs->buf[i];
-			bp[j] = (k > 128) ? -100 : 100;
-			++k;
-			if (k >= 256)
-				k = 0;
-		}
-	}
-#endif
 	/* audio_pcm_iface requires a single contiguous buffer */
 	buffer = AS_AREA_ANY;
-	rc = dmamem_map_anonymous(bufs->bufsize * bufs->nbuffers,
+	rc = dmamem_map_anonymous(size,
 	    hda->ctl->ok64bit ? 0 : DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE,
 	    0, &buffer_phys, &buffer);
 	if (rc != EOK) {
@@ -126,13 +112,49 @@ errno_t hda_stream_buffers_alloc(hda_t *hda, hda_stream_buffers_t **rbufs)
 		goto error;
 	}
 
-	for (i = 0; i < bufs->nbuffers; i++) {
-		bufs->buf[i] = buffer + i * bufs->bufsize;
-		bufs->buf_phys[i] = buffer_phys + i * bufs->bufsize;
+	bufs->buf[0] = buffer;
+	bufs->buf_phys[0] = buffer_phys;
+
+	ddf_msg(LVL_NOTE, "Stream buffer phys=0x%llx virt=%p size=%zu",
+	    (unsigned long long)buffer_phys, buffer, size);
+
+	*rbufs = bufs;
+	return EOK;
+error:
+	hda_stream_buffers_free(bufs);
+	return ENOMEM;
+}
+
+/** Split cyclic stream buffer into periods.
+ *
+ * Every period gets its own BDL entry with Interrupt on Completion set,
+ * so the controller interrupts once per period.
+ *
+ * @param bufs Stream buffers
+ * @param period Period size in bytes
+ * @return EOK on success, EINVAL if the buffer cannot be split into
+ *         periods of this size
+ */
+errno_t hda_stream_buffers_set_period(hda_stream_buffers_t *bufs,
+    size_t period)
+{
+	size_t nbuffers;
+	size_t i;
+
+	if (period == 0 || period % hda_buffer_align != 0 ||
+	    bufs->size % period != 0)
+		return EINVAL;
+
+	nbuffers = bufs->size / period;
+	if (nbuffers < 2 || nbuffers > hda_bdl_max_entries)
+		return EINVAL;
+
+	bufs->nbuffers = nbuffers;
+	bufs->bufsize = period;
 
-		ddf_msg(LVL_NOTE, "Stream buf phys=0x%llx virt=%p",
-		    (long long unsigned)(uintptr_t)bufs->buf[i],
-		    (void *)bufs->buf_phys[i]);
+	for (i = 0; i < bufs->nbuffers; i++) {
+		bufs->buf[i] = bufs->buf[0] + i * bufs->bufsize;
+		bufs->buf_phys[i] = bufs->buf_phys[0] + i * bufs->bufsize;
 	}
 
 	/* Fill in BDL */
@@ -142,11 +164,9 @@ errno_t hda_stream_buffers_alloc(hda_t *hda, hda_stream_buffers_t **rbufs)
 		bufs->bdl[i].flags = BIT_V(uint32_t, bdf_ioc);
 	}
 
-	*rbufs = bufs;
+	ddf_msg(LVL_NOTE, "Stream buffer split into %zu periods of %zu bytes",
+	    bufs->nbuffers, bufs->bufsize);
 	return EOK;
-error:
-	hda_stream_buffers_free(bufs);
-	return ENOMEM;
 }
 
 void hda_stream_buffers_free(hda_stream_buffers_t *bufs)
@@ -154,7 +174,13 @@ void hda_stream_buffers_free(hda_stream_buffers_t *bufs)
 	if (bufs == NULL)
 		return;
 
-	/* XXX */
+	if (bufs->buf != NULL && bufs->buf[0] != NULL)
+		dmamem_unmap_anonymous(bufs->buf[0]);
+	if (bufs->bdl != NULL)
+		dmamem_unmap_anonymous(bufs->bdl);
+
+	free(bufs->buf);
+	free(bufs->buf_phys);
 	free(bufs);
 }
 
@@ -171,7 +197,7 @@ static void hda_stream_desc_configure(hda_stream_t *stream)
 	sdregs = &stream->hda->regs->sdesc[stream->sdid];
 	hda_reg8_write(&sdregs->ctl3, ctl3);
 	hda_reg8_write(&sdregs->ctl1, ctl1);
-	hda_reg32_write(&sdregs->cbl, bufs->nbuffers * bufs->bufsize);
+	hda_reg32_write(&sdregs->cbl, bufs->size);
 	hda_reg16_write(&sdregs->lvi, bufs->nbuffers - 1);
 	hda_reg16_write(&sdregs->fmt, stream->fmt);
 	hda_reg32_write(&sdregs->bdpl, LOWER32(bufs->bdl_phys));
@@ -262,6 +288,7 @@ void hda_stream_destroy(hda_stream_t *stream)
 void hda_stream_start(hda_stream_t *stream)
 {
 	ddf_msg(LVL_NOTE, "hda_stream_start()");
+	stream->cur_buf = 0;
 	hda_stream_set_run(stream, true);
 }
 
@@ -278,5 +305,61 @@ void hda_stream_reset(hda_stream_t *stream)
 	hda_stream_desc_configure(stream);
 }
 
+/** Get current DMA position within the cyclic buffer.
+ *
+ * Read from the DMA Position Buffer if we have one, otherwise from
+ * the LPIB register.
+ *
+ * @param stream Stream
+ * @return Position in bytes from the start of the cyclic buffer
+ */
+size_t hda_stream_get_pos(hda_stream_t *stream)
+{
+	hda_ctl_t *ctl = stream->hda->ctl;
+	uint32_t pos;
+
+	if (ctl->dmapos_virt != NULL) {
+		pos = uint32_t_le2host(((volatile hda_dma_pos_t *)
+		    ctl->dmapos_virt)[stream->sdid].pos);
+	} else {
+		pos = hda_reg32_read(
+		    &stream->hda->regs->sdesc[stream->sdid].lpib);
+	}
+
+	/* The position may read as CBL at the very end of the buffer */
+	return pos % stream->buffers->size;
+}
+
+/** Determine the number of periods completed since last called.
+ *
+ * Called on Buffer Completion interrupt. Counting the periods from the
+ * DMA position instead of the interrupts themselves keeps us in sync
+ * even if some interrupts were coalesced.
+ *
+ * @param stream Stream
+ * @return Number of periods completed
+ */
+size_t hda_stream_periods_elapsed(hda_stream_t *stream)
+{
+	hda_stream_buffers_t *bufs = stream->buffers;
+	size_t cur_buf;
+	size_t elapsed;
+
+	cur_buf = hda_stream_get_pos(stream) / bufs->bufsize;
+	elapsed = (cur_buf + bufs->nbuffers - stream->cur_buf) %
+	    bufs->nbuffers;
+
+	/*
+	 * The position may lag behind the interrupt (and thus behind
+	 * the periods already counted), but the interrupt itself means
+	 * at least one period has completed.
+	 */
+	if (elapsed == 0 || elapsed == bufs->nbuffers - 1)
+		elapsed = 1;
+
+	stream->cur_buf = (stream->cur_buf + elapsed) % bufs->nbuffers;
+	return elapsed;
+}
+
 /** @}
  */
@@ -47,11 +47,20 @@ typedef enum {
 	sdir_bidi
 } hda_stream_dir_t;
 
+enum {
+	/** Maximum number of entries in a Buffer Descriptor List */
+	hda_bdl_max_entries = 256,
+	/** Required alignment of buffer sizes and addresses */
+	hda_buffer_align = 128
+};
+
 typedef struct hda_stream_buffers {
-	/** Number of buffers */
+	/** Number of buffers (periods) */
 	size_t nbuffers;
-	/** Buffer size */
+	/** Buffer (period) size */
 	size_t bufsize;
+	/** Total size of the cyclic buffer */
+	size_t size;
 	/** Buffer Descriptor List */
 	hda_buffer_desc_t *bdl;
 	/** Physical address of BDL */
@@ -74,9 +83,13 @@ typedef struct hda_stream {
 	hda_stream_buffers_t *buffers;
 	/** Stream format */
 	uint32_t fmt;
+	/** Index of the buffer in progress when last checked */
+	size_t cur_buf;
 } hda_stream_t;
 
-extern errno_t hda_stream_buffers_alloc(hda_t *, hda_stream_buffers_t **);
+extern errno_t hda_stream_buffers_alloc(hda_t *, size_t,
+    hda_stream_buffers_t **);
+extern errno_t hda_stream_buffers_set_period(hda_stream_buffers_t *, size_t);
 extern void hda_stream_buffers_free(hda_stream_buffers_t *);
 extern hda_stream_t *hda_stream_create(hda_t *, hda_stream_dir_t,
     hda_stream_buffers_t *, uint32_t);
@@ -84,6 +97,8 @@ extern void hda_stream_destroy(hda_stream_t *);
 extern void hda_stream_start(hda_stream_t *);
 extern void hda_stream_stop(hda_stream_t *);
 extern void hda_stream_reset(hda_stream_t *);
+extern size_t hda_stream_get_pos(hda_stream_t *);
+extern size_t hda_stream_periods_elapsed(hda_stream_t *);
 
 #endif
 
@@ -31,7 +31,9 @@
  */
 
 #include <as.h>
+#include <bitops.h>
 #include <errno.h>
+#include <macros.h>
 #include <stdio.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
@@ -45,6 +47,9 @@
 
 #define NAME  "ahci"
 
+/** Maximum number of blocks transferred by one NCQ command. */
+#define AHCI_NCQ_MAX_BLOCKS  128
+
 #define LO(ptr) \
 	((uint32_t) (((uint64_t) ((uintptr_t) (ptr))) & 0xffffffff))
 
@@ -111,13 +116,14 @@
 static errno_t get_sata_device_name(ddf_fun_t *, size_t, char *);
 static errno_t get_num_blocks(ddf_fun_t *, uint64_t *);
 static errno_t get_block_size(ddf_fun_t *, size_t *);
+static errno_t get_queue_depth(ddf_fun_t *, unsigned *);
 static errno_t read_blocks(ddf_fun_t *, uint64_t, size_t, void *);
 static errno_t write_blocks(ddf_fun_t *, uint64_t, size_t, void *);
 
 static errno_t ahci_identify_device(sata_dev_t *);
 static errno_t ahci_set_highest_ultra_dma_mode(sata_dev_t *);
-static errno_t ahci_rb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
-static errno_t ahci_wb_fpdma(sata_dev_t *, uintptr_t, uint64_t);
+static errno_t ahci_rw_blocks(sata_dev_t *, uint64_t, size_t, void *, bool);
+static errno_t ahci_fpdma(sata_dev_t *, uintptr_t, uint64_t, size_t, bool);
 
 static void ahci_sata_devices_create(ahci_dev_t *, ddf_dev_t *);
 static ahci_dev_t *ahci_ahci_create(ddf_dev_t *);
@@ -138,6 +144,7 @@ static ahci_iface_t ahci_interface = {
 	.get_sata_device_name = &get_sata_device_name,
 	.get_num_blocks = &get_num_blocks,
 	.get_block_size = &get_block_size,
+	.get_queue_depth = &get_queue_depth,
 	.read_blocks = &read_blocks,
 	.write_blocks = &write_blocks
 };
@@ -214,6 +221,21 @@ static errno_t get_block_size(ddf_fun_t *fun, size_t *block_size)
 	return EOK;
 }
 
+/** Get number of NCQ commands the SATA device serves at the same time.
+ *
+ * @param fun   Device function handling the call.
+ * @param depth Return queue depth.
+ *
+ * @return EOK.
+ *
+ */
+static errno_t get_queue_depth(ddf_fun_t *fun, unsigned *depth)
+{
+	sata_dev_t *sata = fun_sata_dev(fun);
+	*depth = sata->ncq_slots;
+	return EOK;
+}
+
 /** Read data blocks into SATA device.
  *
  * @param fun      Device function handling the call.
@@ -227,34 +249,7 @@ static errno_t get_block_size(ddf_fun_t *fun, size_t *block_size)
 static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
     size_t count, void *buf)
 {
-	sata_dev_t *sata = fun_sata_dev(fun);
-
-	uintptr_t phys;
-	void *ibuf = AS_AREA_ANY;
-	errno_t rc = dmamem_map_anonymous(sata->block_size, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
-	if (rc != EOK) {
-		ddf_msg(LVL_ERROR, "Cannot allocate read buffer.");
-		return rc;
-	}
-
-	memset(buf, 0, sata->block_size);
-
-	fibril_mutex_lock(&sata->lock);
-
-	for (size_t cur = 0; cur < count; cur++) {
-		rc = ahci_rb_fpdma(sata, phys, blocknum + cur);
-		if (rc != EOK)
-			break;
-
-		memcpy((void *) (((uint8_t *) buf) + (sata->block_size * cur)),
-		    ibuf, sata->block_size);
-	}
-
-	fibril_mutex_unlock(&sata->lock);
-	dmamem_unmap_anonymous(ibuf);
-
-	return rc;
+	return ahci_rw_blocks(fun_sata_dev(fun), blocknum, count, buf, false);
 }
 
 /** Write data blocks into SATA device.
@@ -270,28 +265,57 @@ static errno_t read_blocks(ddf_fun_t *fun, uint64_t blocknum,
 static errno_t write_blocks(ddf_fun_t *fun, uint64_t blocknum,
     size_t count, void *buf)
 {
-	sata_dev_t *sata = fun_sata_dev(fun);
+	return ahci_rw_blocks(fun_sata_dev(fun), blocknum, count, buf, true);
+}
+
+/** Transfer data blocks between SATA device and a buffer.
+ *
+ * The blocks are transferred by NCQ commands of up to AHCI_NCQ_MAX_BLOCKS
+ * blocks each. Transfers of concurrent callers are not serialized, their
+ * commands are queued in different command slots.
+ *
+ * @param sata     SATA device structure.
+ * @param blocknum Number of first block.
+ * @param count    Number of blocks to transfer.
+ * @param buf      Buffer for data.
+ * @param write    Write (true) or read (false).
+ *
+ * @return EOK if succeed, error code otherwise
+ *
+ */
+static errno_t ahci_rw_blocks(sata_dev_t *sata, uint64_t blocknum,
+    size_t count, void *buf, bool write)
+{
+	if (count == 0)
+		return EOK;
+
+	size_t xfer = min(count, (size_t) AHCI_NCQ_MAX_BLOCKS);
 
 	uintptr_t phys;
 	void *ibuf = AS_AREA_ANY;
-	errno_t rc = dmamem_map_anonymous(sata->block_size, DMAMEM_4GiB,
+	errno_t rc = dmamem_map_anonymous(xfer * sata->block_size, DMAMEM_4GiB,
 	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &ibuf);
 	if (rc != EOK) {
-		ddf_msg(LVL_ERROR, "Cannot allocate write buffer.");
+		ddf_msg(LVL_ERROR, "Cannot allocate %s buffer.",
+		    write ? "write" : "read");
 		return rc;
 	}
 
-	fibril_mutex_lock(&sata->lock);
+	for (size_t cur = 0; cur < count; cur += xfer) {
+		uint8_t *data = (uint8_t *) buf + sata->block_size * cur;
+
+		xfer = min(count - cur, xfer);
+		if (write)
+			memcpy(ibuf, data, sata->block_size * xfer);
 
-	for (size_t cur = 0; cur < count; cur++) {
-		memcpy(ibuf, (void *) (((uint8_t *) buf) + (sata->block_size * cur)),
-		    sata->block_size);
-		rc = ahci_wb_fpdma(sata, phys, blocknum + cur);
+		rc = ahci_fpdma(sata, phys, blocknum + cur, xfer, write);
 		if (rc != EOK)
 			break;
+
+		if (!write)
+			memcpy(data, ibuf, sata->block_size * xfer);
 	}
 
-	fibril_mutex_unlock(&sata->lock);
 	dmamem_unmap_anonymous(ibuf);
 
 	return rc;
@@ -367,7 +391,6 @@ static void ahci_identify_device_cmd(sata_dev_t *sata, uintptr_t phys)
 	sata->cmd_header->bytesprocessed = 0;
 
 	/* Run command. */
-	sata->port->pxsact |= 1;
 	sata->port->pxci |= 1;
 }
 
@@ -412,7 +435,6 @@ static void ahci_identify_packet_device_cmd(sata_dev_t *sata, uintptr_t phys)
 	sata->cmd_header->bytesprocessed = 0;
 
 	/* Run command. */
-	sata->port->pxsact |= 1;
 	sata->port->pxci |= 1;
 }
 
@@ -478,6 +500,13 @@ static errno_t ahci_identify_device(sata_dev_t *sata)
 		goto error;
 	}
 
+	/* Use as many command slots as both the HBA and the device support. */
+	ahci_ghc_cap_t cap;
+	cap.u32 = sata->ahci->memregs->ghc.cap;
+	sata->ncq_slots = min(cap.ncs + 1U, (idata->queue_depth & 0x1fU) + 1);
+	sata->ncq_free = (sata->ncq_slots == AHCI_MAX_CMD_SLOTS) ?
+	    (uint32_t) -1 : (1U << sata->ncq_slots) - 1;
+
 	uint16_t logsec = idata->physical_logic_sector_size;
 	if ((logsec & 0xc000) == 0x4000) {
 		/* Length of sector may be larger than 512 B */
@@ -593,7 +622,6 @@ static void ahci_set_mode_cmd(sata_dev_t *sata, uintptr_t phys, uint8_t mode)
 	sata->cmd_header->bytesprocessed = 0;
 
 	/* Run command. */
-	sata->port->pxsact |= 1;
 	sata->port->pxci |= 1;
 }
 
@@ -668,24 +696,42 @@ error:
 	return EINTR;
 }
 
-/** Set AHCI registers for reading one sector from the SATA device using FPDMA.
+/** Get command table of a command slot.
+ *
+ * @param sata SATA device structure.
+ * @param slot Command slot.
+ *
+ * @return Pointer to the command table.
+ *
+ */
+static volatile uint32_t *ahci_slot_table(sata_dev_t *sata, unsigned int slot)
+{
+	return sata->cmd_table + slot * (AHCI_CMD_TABLE_SIZE / sizeof(uint32_t));
+}
+
+/** Set AHCI registers for transferring sectors using FPDMA.
  *
  * @param sata     SATA device structure.
+ * @param slot     Command slot (and NCQ tag) of the command.
  * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
+ * @param blocknum First block number to transfer.
+ * @param count    Number of blocks to transfer.
+ * @param write    Write (true) or read (false).
  *
  */
-static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
+static void ahci_fpdma_cmd(sata_dev_t *sata, unsigned int slot,
+    uintptr_t phys, uint64_t blocknum, size_t count, bool write)
 {
+	volatile uint32_t *table = ahci_slot_table(sata, slot);
 	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
+	    (sata_ncq_command_frame_t *) table;
 
 	cmd->fis_type = SATA_CMD_FIS_TYPE;
 	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x60;
-	cmd->tag = 0;
+	cmd->command = write ? 0x61 : 0x60;
+	cmd->tag = slot << 3;
 	cmd->control = 0;
+	cmd->fua = 0x40;
 
 	cmd->reserved1 = 0;
 	cmd->reserved2 = 0;
@@ -694,8 +740,8 @@ static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	cmd->reserved5 = 0;
 	cmd->reserved6 = 0;
 
-	cmd->sector_count_low = 1;
-	cmd->sector_count_high = 0;
+	cmd->sector_count_low = count & 0xff;
+	cmd->sector_count_high = (count >> 8) & 0xff;
 
 	cmd->lba0 = blocknum & 0xff;
 	cmd->lba1 = (blocknum >> 8) & 0xff;
@@ -705,136 +751,79 @@ static void ahci_rb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
 	cmd->lba5 = (blocknum >> 40) & 0xff;
 
 	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	    (ahci_cmd_prdt_t *) (&table[0x20]);
 
 	prdt->data_address_low = LO(phys);
 	prdt->data_address_upper = HI(phys);
 	prdt->reserved1 = 0;
-	prdt->dbc = sata->block_size - 1;
+	prdt->dbc = count * sata->block_size - 1;
 	prdt->reserved2 = 0;
 	prdt->ioc = 0;
 
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
+	volatile ahci_cmdhdr_t *header = &sata->cmd_header[slot];
+
+	header->prdtl = 1;
+	header->flags =
 	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
+	    (write ? AHCI_CMDHDR_FLAGS_WRITE : 0) |
 	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
-
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
+	header->bytesprocessed = 0;
 }
 
-/** Read one sector from the SATA device using FPDMA.
+/** Transfer sectors between the SATA device and a buffer using FPDMA.
+ *
+ * The command is queued in a free command slot. If all slots used for NCQ
+ * are busy, wait for one to become free.
  *
  * @param sata     SATA device structure.
  * @param phys     Physical address of buffer for sector data.
- * @param blocknum Block number to read.
+ * @param blocknum First block number to transfer.
+ * @param count    Number of blocks to transfer.
+ * @param write    Write (true) or read (false).
  *
  * @return EOK if succeed, error code otherwise
  *
  */
-static errno_t ahci_rb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
+static errno_t ahci_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum,
+    size_t count, bool write)
 {
 	if (sata->is_invalid_device) {
-		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA read from invalid device", sata->model);
+		ddf_msg(LVL_ERROR, "%s: FPDMA %s invalid device", sata->model,
+		    write ? "write to" : "read from");
 		return EINTR;
 	}
 
-	ahci_rb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
-
-	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
-		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA read", sata->model);
-		return EINTR;
-	}
-
-	return EOK;
-}
-
-/** Set AHCI registers for writing one sector to the SATA device, use FPDMA.
- *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
- *
- * @return EOK if succeed, error code otherwise
- *
- */
-static void ahci_wb_fpdma_cmd(sata_dev_t *sata, uintptr_t phys,
-    uint64_t blocknum)
-{
-	volatile sata_ncq_command_frame_t *cmd =
-	    (sata_ncq_command_frame_t *) sata->cmd_table;
-
-	cmd->fis_type = SATA_CMD_FIS_TYPE;
-	cmd->c = SATA_CMD_FIS_COMMAND_INDICATOR;
-	cmd->command = 0x61;
-	cmd->tag = 0;
-	cmd->control = 0;
-
-	cmd->reserved1 = 0;
-	cmd->reserved2 = 0;
-	cmd->reserved3 = 0;
-	cmd->reserved4 = 0;
-	cmd->reserved5 = 0;
-	cmd->reserved6 = 0;
-
-	cmd->sector_count_low = 1;
-	cmd->sector_count_high = 0;
+	fibril_mutex_lock(&sata->event_lock);
+	while (sata->ncq_free == 0)
+		fibril_condvar_wait(&sata->ncq_free_condvar, &sata->event_lock);
 
-	cmd->lba0 = blocknum & 0xff;
-	cmd->lba1 = (blocknum >> 8) & 0xff;
-	cmd->lba2 = (blocknum >> 16) & 0xff;
-	cmd->lba3 = (blocknum >> 24) & 0xff;
-	cmd->lba4 = (blocknum >> 32) & 0xff;
-	cmd->lba5 = (blocknum >> 40) & 0xff;
+	unsigned int slot = fnzb32(sata->ncq_free);
+	uint32_t mask = 1U << slot;
+	sata->ncq_free &= ~mask;
+	fibril_mutex_unlock(&sata->event_lock);
 
-	volatile ahci_cmd_prdt_t *prdt =
-	    (ahci_cmd_prdt_t *) (&sata->cmd_table[0x20]);
+	ahci_fpdma_cmd(sata, slot, phys, blocknum, count, write);
 
-	prdt->data_address_low = LO(phys);
-	prdt->data_address_upper = HI(phys);
-	prdt->reserved1 = 0;
-	prdt->dbc = sata->block_size - 1;
-	prdt->reserved2 = 0;
-	prdt->ioc = 0;
+	fibril_mutex_lock(&sata->event_lock);
 
-	sata->cmd_header->prdtl = 1;
-	sata->cmd_header->flags =
-	    AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK |
-	    AHCI_CMDHDR_FLAGS_WRITE |
-	    AHCI_CMDHDR_FLAGS_5DWCMD;
-	sata->cmd_header->bytesprocessed = 0;
+	/* Run command. */
+	sata->ncq_active |= mask;
+	sata->port->pxsact = mask;
+	sata->port->pxci = mask;
 
-	sata->port->pxsact |= 1;
-	sata->port->pxci |= 1;
-}
+	while ((sata->ncq_active & mask) != 0)
+		fibril_condvar_wait(&sata->ncq_done_condvar, &sata->event_lock);
 
-/** Write one sector into the SATA device, use FPDMA.
- *
- * @param sata     SATA device structure.
- * @param phys     Physical address of buffer with sector data.
- * @param blocknum Block number to write.
- *
- * @return EOK if succeed, error code otherwise
- *
- */
-static errno_t ahci_wb_fpdma(sata_dev_t *sata, uintptr_t phys, uint64_t blocknum)
-{
-	if (sata->is_invalid_device) {
-		ddf_msg(LVL_ERROR,
-		    "%s: FPDMA write to invalid device", sata->model);
-		return EINTR;
-	}
+	bool failed = (sata->ncq_failed & mask) != 0;
+	sata->ncq_failed &= ~mask;
+	sata->ncq_free |= mask;
+	fibril_condvar_signal(&sata->ncq_free_condvar);
 
-	ahci_wb_fpdma_cmd(sata, phys, blocknum);
-	ahci_port_is_t pxis = ahci_wait_event(sata);
+	fibril_mutex_unlock(&sata->event_lock);
 
-	if ((sata->is_invalid_device) || (ahci_port_is_error(pxis))) {
-		ddf_msg(LVL_ERROR,
-		    "%s: Unrecoverable error during FPDMA write", sata->model);
+	if ((sata->is_invalid_device) || (failed)) {
+		ddf_msg(LVL_ERROR, "%s: Unrecoverable error during FPDMA %s",
+		    sata->model, write ? "write" : "read");
 		return EINTR;
 	}
 
@@ -906,16 +895,34 @@ static void ahci_interrupt(ipc_call_t *icall, ddf_dev_t *dev)
 	if (sata == NULL)
 		return;
 
-	/* Evaluate port event */
-	if ((ahci_port_is_end_of_operation(pxis)) ||
-	    (ahci_port_is_error(pxis))) {
-		fibril_mutex_lock(&sata->event_lock);
+	fibril_mutex_lock(&sata->event_lock);
+
+	if (sata->ncq_active != 0) {
+		/*
+		 * NCQ commands are complete once the device has cleared their
+		 * bits in PxSACT. On error, the port stops processing the
+		 * command list, so all outstanding commands fail.
+		 */
+		uint32_t done = sata->ncq_active & ~sata->port->pxsact;
+		if (ahci_port_is_error(pxis)) {
+			done = sata->ncq_active;
+			sata->ncq_failed |= done;
+			if (ahci_port_is_permanent_error(pxis))
+				sata->is_invalid_device = true;
+		}
 
+		if (done != 0) {
+			sata->ncq_active &= ~done;
+			fibril_condvar_broadcast(&sata->ncq_done_condvar);
+		}
+	} else if ((ahci_port_is_end_of_operation(pxis)) ||
+	    (ahci_port_is_error(pxis))) {
+		/* Evaluate port event */
 		sata->event_pxis = pxis;
 		fibril_condvar_signal(&sata->event_condvar);
-
-		fibril_mutex_unlock(&sata->event_lock);
 	}
+
+	fibril_mutex_unlock(&sata->event_lock);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -968,15 +975,19 @@ static sata_dev_t *ahci_sata_allocate(ahci_dev_t *ahci, volatile ahci_port_t *po
 	sata->port->pxclb = LO(phys);
 	sata->cmd_header = (ahci_cmdhdr_t *) virt_cmd;
 
-	/* Allocate and init command table structure. */
-	rc = dmamem_map_anonymous(size, DMAMEM_4GiB,
+	/* Allocate and init command table structures of all slots. */
+	size_t table_size = AHCI_MAX_CMD_SLOTS * AHCI_CMD_TABLE_SIZE;
+	rc = dmamem_map_anonymous(table_size, DMAMEM_4GiB,
 	    AS_AREA_READ | AS_AREA_WRITE, 0, &phys, &virt_table);
 	if (rc != EOK)
 		goto error_table;
 
-	memset(virt_table, 0, size);
-	sata->cmd_header->cmdtableu = HI(phys);
-	sata->cmd_header->cmdtable = LO(phys);
+	memset(virt_table, 0, table_size);
+	for (unsigned int slot = 0; slot < AHCI_MAX_CMD_SLOTS; slot++) {
+		uintptr_t table_phys = phys + slot * AHCI_CMD_TABLE_SIZE;
+		sata->cmd_header[slot].cmdtableu = HI(table_phys);
+		sata->cmd_header[slot].cmdtable = LO(table_phys);
+	}
 	sata->cmd_table = (uint32_t *) virt_table;
 
 	return sata;
@@ -1056,6 +1067,8 @@ static errno_t ahci_sata_create(ahci_dev_t *ahci, ddf_dev_t *dev,
 	fibril_mutex_initialize(&sata->lock);
 	fibril_mutex_initialize(&sata->event_lock);
 	fibril_condvar_initialize(&sata->event_condvar);
+	fibril_condvar_initialize(&sata->ncq_free_condvar);
+	fibril_condvar_initialize(&sata->ncq_done_condvar);
 
 	ahci_sata_hw_start(sata);
 
@@ -1183,16 +1196,24 @@ static ahci_dev_t *ahci_ahci_create(ddf_dev_t *dev)
 	ct.rangecount = sizeof(ahci_ranges) / sizeof(irq_pio_range_t);
 	ct.ranges = ahci_ranges;
 
+	/* Prefer a message signalled interrupt to a possibly shared line */
+	int irq = hw_res_parsed.irqs.irqs[0];
+	int msi_irq;
+	unsigned int granted;
+	if (pci_msi_enable(ahci->parent_sess, 1, &msi_irq, &granted) == EOK) {
+		irq = msi_irq;
+		ahci->msi = true;
+	}
+
 	cap_irq_handle_t irq_cap;
-	errno_t rc = register_interrupt_handler(dev,
-	    hw_res_parsed.irqs.irqs[0], ahci_interrupt, &ct, &irq_cap);
+	errno_t rc = register_interrupt_handler(dev, irq, ahci_interrupt, &ct,
+	    &irq_cap);
 	if (rc != EOK) {
 		ddf_msg(LVL_ERROR, "Failed registering interrupt handler.");
 		goto error_register_interrupt_handler;
 	}
 
-	rc = hw_res_enable_interrupt(ahci->parent_sess,
-	    hw_res_parsed.irqs.irqs[0]);
+	rc = hw_res_enable_interrupt(ahci->parent_sess, irq);
 	if (rc != EOK) {
 		ddf_msg(LVL_ERROR, "Failed enable interupt.");
 		goto error_enable_interrupt;
@@ -1232,11 +1253,11 @@ static void ahci_ahci_hw_start(ahci_dev_t *ahci)
 	/* Set master latency timer. */
 	pci_config_space_write_8(ahci->parent_sess, AHCI_PCI_MLT, 32);
 
-	/* Enable PCI interrupt and bus mastering */
+	/* Enable bus mastering and the INTx interrupt unless MSI is used */
 	ahci_pcireg_cmd_t cmd;
 
 	pci_config_space_read_16(ahci->parent_sess, AHCI_PCI_CMD, &cmd.u16);
-	cmd.id = 0;
+	cmd.id = ahci->msi ? 1 : 0;
 	cmd.bme = 1;
 	pci_config_space_write_16(ahci->parent_sess, AHCI_PCI_CMD, cmd.u16);
 
@@ -53,6 +53,9 @@ typedef struct {
 
 	/** Parent session */
 	async_sess_t *parent_sess;
+
+	/** Message signalled interrupt is used instead of INTx */
+	bool msi;
 } ahci_dev_t;
 
 /** SATA Device. */
@@ -75,7 +78,7 @@ typedef struct {
 	/** Pointer to command header. */
 	volatile ahci_cmdhdr_t *cmd_header;
 
-	/** Pointer to command table. */
+	/** Pointer to command table of command slot 0. */
 	volatile uint32_t *cmd_table;
 
 	/** Mutex for single operation on device. */
@@ -90,6 +93,24 @@ typedef struct {
 	/** Event interrupt state. */
 	ahci_port_is_t event_pxis;
 
+	/** Number of command slots used for NCQ commands. */
+	unsigned int ncq_slots;
+
+	/** Command slots not used by any NCQ command. */
+	uint32_t ncq_free;
+
+	/** Issued NCQ commands that have not completed yet. */
+	uint32_t ncq_active;
+
+	/** Completed NCQ commands that have failed. */
+	uint32_t ncq_failed;
+
+	/** Signalled when a command slot is freed. */
+	fibril_condvar_t ncq_free_condvar;
+
+	/** Signalled when NCQ commands complete. */
+	fibril_condvar_t ncq_done_condvar;
+
 	/** Number of device data blocks. */
 	uint64_t blocks;
 
@@ -1004,8 +1004,16 @@ typedef volatile struct {
 	uint32_t cmdtable;
 	/** Command Table Descriptor Base Address Upper 32-bits. */
 	uint32_t cmdtableu;
+	/** Reserved. */
+	uint32_t reserved[4];
 } ahci_cmdhdr_t;
 
+/** Number of command slots in a command list. */
+#define AHCI_MAX_CMD_SLOTS  32
+
+/** Size of a command table with room for one PRDT entry (128 B aligned). */
+#define AHCI_CMD_TABLE_SIZE  0x100
+
 /** Clear Busy upon R_OK (C) flag. */
 #define AHCI_CMDHDR_FLAGS_CLEAR_BUSY_UPON_OK  0x0400
 
@@ -35,8 +35,12 @@
  * @brief ATA disk driver
  *
  * This driver supports CHS, 28-bit and 48-bit LBA addressing, as well as
- * PACKET devices. It only uses PIO transfers. There is no support DMA
- * or any other fancy features such as S.M.A.R.T, removable devices, etc.
+ * PACKET devices. It only uses PIO transfers, several sectors per command
+ * and per data block (Read/Write Multiple) if the device supports it. If
+ * the controller has an IRQ assigned, data blocks and command completion
+ * are waited for with the interrupt instead of polling the status. There
+ * is no support DMA or any other fancy features such as S.M.A.R.T,
+ * removable devices, etc.
  *
  * This driver is based on the ATA-1, ATA-2, ATA-3 and ATA/ATAPI-4 through 7
  * standards, as published by the ANSI, NCITS and INCITS standards bodies,
@@ -48,10 +52,13 @@
  */
 
 #include <ddi.h>
+#include <ddf/interrupt.h>
 #include <ddf/log.h>
+#include <device/hw_res.h>
 #include <async.h>
 #include <as.h>
 #include <bd_srv.h>
+#include <bitops.h>
 #include <fibril_synch.h>
 #include <scsi/mmc.h>
 #include <scsi/sbc.h>
@@ -61,6 +68,7 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <str.h>
+#include <str_error.h>
 #include <inttypes.h>
 #include <errno.h>
 #include <byteorder.h>
@@ -93,6 +101,7 @@ static errno_t ata_bd_write_blocks(bd_srv_t *, uint64_t ba, size_t cnt,
     const void *buf, size_t);
 static errno_t ata_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t ata_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t ata_bd_get_queue_depth(bd_srv_t *, unsigned *);
 static errno_t ata_bd_sync_cache(bd_srv_t *, aoff64_t, size_t);
 
 static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t cnt,
@@ -100,6 +109,7 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t cnt,
 static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
     const void *buf);
 static errno_t ata_rcmd_flush_cache(disk_t *disk);
+static errno_t ata_rcmd_set_multiple(disk_t *disk, unsigned count);
 static errno_t disk_init(ata_ctrl_t *ctrl, disk_t *d, int disk_id);
 static errno_t ata_identify_dev(disk_t *disk, void *buf);
 static errno_t ata_identify_pkt_dev(disk_t *disk, void *buf);
@@ -119,6 +129,20 @@ static void coord_sc_program(ata_ctrl_t *ctrl, const block_coord_t *bc,
     uint16_t scnt);
 static errno_t wait_status(ata_ctrl_t *ctrl, unsigned set, unsigned n_reset,
     uint8_t *pstatus, unsigned timeout);
+static void ata_irq_arm(ata_ctrl_t *ctrl);
+static errno_t wait_irq(ata_ctrl_t *ctrl, uint8_t *pstatus, unsigned timeout);
+
+/** Interrupt pseudo-code. Reading the status register clears INTRQ. */
+static const irq_cmd_t ata_irq_cmds[] = {
+	{
+		.cmd = CMD_PIO_READ_8,
+		.addr = NULL,	/* status */
+		.dstarg = 1
+	},
+	{
+		.cmd = CMD_ACCEPT
+	}
+};
 
 bd_ops_t ata_bd_ops = {
 	.open = ata_bd_open,
@@ -128,6 +152,7 @@ bd_ops_t ata_bd_ops = {
 	.write_blocks = ata_bd_write_blocks,
 	.get_block_size = ata_bd_get_block_size,
 	.get_num_blocks = ata_bd_get_num_blocks,
+	.get_queue_depth = ata_bd_get_queue_depth,
 	.sync_cache = ata_bd_sync_cache
 };
 
@@ -141,6 +166,79 @@ static int disk_dev_idx(disk_t *disk)
 	return (disk->disk_id & 1);
 }
 
+/** ATA controller interrupt handler. */
+static void ata_irq_handler(ipc_call_t *call, ddf_dev_t *dev)
+{
+	ata_ctrl_t *ctrl = (ata_ctrl_t *) ddf_dev_data_get(dev);
+
+	fibril_mutex_lock(&ctrl->irq_lock);
+	ctrl->irq_status = ipc_get_arg1(call);
+	ctrl->irq_fired = true;
+	fibril_condvar_broadcast(&ctrl->irq_cv);
+	fibril_mutex_unlock(&ctrl->irq_lock);
+}
+
+/** Start using the controller interrupt.
+ *
+ * @param ctrl		Controller
+ * @return		EOK on success or an error code
+ */
+static errno_t ata_irq_init(ata_ctrl_t *ctrl)
+{
+	irq_cmd_t cmds[ARRAY_SIZE(ata_irq_cmds)];
+	irq_pio_range_t ranges[] = {
+		{
+			.base = ctrl->cmd_physical,
+			.size = sizeof(ata_cmd_t)
+		}
+	};
+	irq_code_t irq_code = {
+		.rangecount = ARRAY_SIZE(ranges),
+		.ranges = ranges,
+		.cmdcount = ARRAY_SIZE(cmds),
+		.cmds = cmds
+	};
+	errno_t rc;
+
+	if (ctrl->irq < 0)
+		return ENOENT;
+
+	memcpy(cmds, ata_irq_cmds, sizeof(cmds));
+	cmds[0].addr = (void *) (ctrl->cmd_physical +
+	    offsetof(ata_cmd_t, status));
+
+	rc = register_interrupt_handler(ctrl->dev, ctrl->irq, ata_irq_handler,
+	    &irq_code, &ctrl->irq_handle);
+	if (rc != EOK)
+		return rc;
+
+	rc = hw_res_enable_interrupt(ddf_dev_parent_sess_get(ctrl->dev),
+	    ctrl->irq);
+	if (rc != EOK) {
+		unregister_interrupt_handler(ctrl->dev, ctrl->irq_handle);
+		return rc;
+	}
+
+	/* Let the devices raise INTRQ */
+	pio_write_8(&ctrl->ctl->device_control, 0);
+	ctrl->use_irq = true;
+	return EOK;
+}
+
+/** Stop using the controller interrupt.
+ *
+ * @param ctrl		Controller
+ */
+static void ata_irq_fini(ata_ctrl_t *ctrl)
+{
+	if (!ctrl->use_irq)
+		return;
+
+	pio_write_8(&ctrl->ctl->device_control, DCR_nIEN);
+	ctrl->use_irq = false;
+	unregister_interrupt_handler(ctrl->dev, ctrl->irq_handle);
+}
+
 /** Initialize ATA controller. */
 errno_t ata_ctrl_init(ata_ctrl_t *ctrl, ata_base_t *res)
 {
@@ -151,8 +249,12 @@ errno_t ata_ctrl_init(ata_ctrl_t *ctrl, ata_base_t *res)
 	ddf_msg(LVL_DEBUG, "ata_ctrl_init()");
 
 	fibril_mutex_initialize(&ctrl->lock);
+	fibril_mutex_initialize(&ctrl->irq_lock);
+	fibril_condvar_initialize(&ctrl->irq_cv);
 	ctrl->cmd_physical = res->cmd;
 	ctrl->ctl_physical = res->ctl;
+	ctrl->irq = res->irq;
+	ctrl->use_irq = false;
 
 	ddf_msg(LVL_NOTE, "I/O address %p/%p", (void *) ctrl->cmd_physical,
 	    (void *) ctrl->ctl_physical);
@@ -173,6 +275,15 @@ errno_t ata_ctrl_init(ata_ctrl_t *ctrl, ata_base_t *res)
 		}
 	}
 
+	/* Disks are probed by polling, commands use the interrupt if any */
+	rc = ata_irq_init(ctrl);
+	if (rc == EOK) {
+		ddf_msg(LVL_NOTE, "Using IRQ %d.", ctrl->irq);
+	} else if (rc != ENOENT) {
+		ddf_msg(LVL_WARN, "Failed to set up IRQ %d, polling: %s",
+		    ctrl->irq, str_error(rc));
+	}
+
 	n_disks = 0;
 
 	for (i = 0; i < MAX_DISKS; i++) {
@@ -203,6 +314,7 @@ error:
 			    "disk %d.", i);
 		}
 	}
+	ata_irq_fini(ctrl);
 	ata_bd_fini_io(ctrl);
 	return rc;
 }
@@ -226,6 +338,7 @@ errno_t ata_ctrl_remove(ata_ctrl_t *ctrl)
 		}
 	}
 
+	ata_irq_fini(ctrl);
 	ata_bd_fini_io(ctrl);
 	fibril_mutex_unlock(&ctrl->lock);
 
@@ -251,6 +364,7 @@ errno_t ata_ctrl_gone(ata_ctrl_t *ctrl)
 		}
 	}
 
+	ata_irq_fini(ctrl);
 	ata_bd_fini_io(ctrl);
 	fibril_mutex_unlock(&ctrl->lock);
 
@@ -355,6 +469,7 @@ static errno_t disk_init(ata_ctrl_t *ctrl, disk_t *d, int disk_id)
 	uint64_t nblocks;
 	size_t block_size;
 	size_t pos, len;
+	unsigned mcount;
 	errno_t rc;
 	unsigned i;
 
@@ -362,6 +477,7 @@ static errno_t disk_init(ata_ctrl_t *ctrl, disk_t *d, int disk_id)
 	d->disk_id = disk_id;
 	d->present = false;
 	d->afun = NULL;
+	d->multi_sectors = 0;
 
 	/* Try identify command. */
 	rc = ata_identify_dev(d, &idata);
@@ -489,9 +605,24 @@ static errno_t disk_init(ata_ctrl_t *ctrl, disk_t *d, int disk_id)
 
 		d->blocks = nblocks;
 		d->block_size = block_size;
+		d->max_sectors = 1;
 	} else {
 		/* Assume register Read always uses 512-byte blocks. */
 		d->block_size = 512;
+
+		/* Sector count 0 stands for the maximum */
+		d->max_sectors = d->amode == am_lba48 ? 65536 : 256;
+
+		/*
+		 * Transfer several sectors per data block if the device
+		 * supports it. The count must be a power of two.
+		 */
+		mcount = idata.max_rw_multiple & mrm_max_count;
+		if (mcount > 1) {
+			mcount = 1 << fnzb32(mcount);
+			if (ata_rcmd_set_multiple(d, mcount) == EOK)
+				d->multi_sectors = mcount;
+		}
 	}
 
 	d->present = true;
@@ -513,25 +644,28 @@ static errno_t ata_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
     void *buf, size_t size)
 {
 	disk_t *disk = bd_srv_disk(bd);
+	size_t n;
 	errno_t rc;
 
 	if (size < cnt * disk->block_size)
 		return EINVAL;
 
 	while (cnt > 0) {
+		n = min(cnt, disk->max_sectors);
+
 		if (disk->dev_type == ata_reg_dev) {
-			rc = ata_rcmd_read(disk, ba, 1, buf);
+			rc = ata_rcmd_read(disk, ba, n, buf);
 		} else {
-			rc = ata_pcmd_read_12(disk, ba, 1, buf,
-			    disk->block_size);
+			rc = ata_pcmd_read_12(disk, ba, n, buf,
+			    n * disk->block_size);
 		}
 
 		if (rc != EOK)
 			return rc;
 
-		++ba;
-		--cnt;
-		buf += disk->block_size;
+		ba += n;
+		cnt -= n;
+		buf += n * disk->block_size;
 	}
 
 	return EOK;
@@ -550,6 +684,7 @@ static errno_t ata_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
     const void *buf, size_t size)
 {
 	disk_t *disk = bd_srv_disk(bd);
+	size_t n;
 	errno_t rc;
 
 	if (disk->dev_type != ata_reg_dev)
@@ -559,13 +694,15 @@ static errno_t ata_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
 		return EINVAL;
 
 	while (cnt > 0) {
-		rc = ata_rcmd_write(disk, ba, 1, buf);
+		n = min(cnt, disk->max_sectors);
+
+		rc = ata_rcmd_write(disk, ba, n, buf);
 		if (rc != EOK)
 			return rc;
 
-		++ba;
-		--cnt;
-		buf += disk->block_size;
+		ba += n;
+		cnt -= n;
+		buf += n * disk->block_size;
 	}
 
 	return EOK;
@@ -589,6 +726,16 @@ static errno_t ata_bd_get_num_blocks(bd_srv_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Get queue depth of the device.
+ *
+ * The controller executes one command at a time.
+ */
+static errno_t ata_bd_get_queue_depth(bd_srv_t *bd, unsigned *rdepth)
+{
+	*rdepth = 1;
+	return EOK;
+}
+
 /** Flush cache. */
 static errno_t ata_bd_sync_cache(bd_srv_t *bd, uint64_t ba, size_t cnt)
 {
@@ -601,58 +748,88 @@ static errno_t ata_bd_sync_cache(bd_srv_t *bd, uint64_t ba, size_t cnt)
 	return ata_rcmd_flush_cache(disk);
 }
 
-/** PIO data-in command protocol. */
+/** PIO data-in command protocol.
+ *
+ * The device requests an interrupt before each data block.
+ *
+ * @param disk		Disk
+ * @param obuf		Buffer for the data
+ * @param obuf_size	Size of @a obuf in bytes
+ * @param blk_size	Block size in bytes
+ * @param nblocks	Number of blocks to transfer
+ * @param drq_blocks	Number of blocks in one data block
+ */
 static errno_t ata_pio_data_in(disk_t *disk, void *obuf, size_t obuf_size,
-    size_t blk_size, size_t nblocks)
+    size_t blk_size, size_t nblocks, size_t drq_blocks)
 {
 	ata_ctrl_t *ctrl = disk->ctrl;
-	uint16_t data;
-	size_t i;
+	uint16_t *bp = obuf;
+	size_t i, n;
 	uint8_t status;
 
-	/* XXX Support multiple blocks */
-	assert(nblocks == 1);
 	assert(blk_size % 2 == 0);
+	assert(nblocks * blk_size <= obuf_size);
+	assert(drq_blocks > 0);
 
-	if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
-		return EIO;
+	while (nblocks > 0) {
+		if (wait_irq(ctrl, &status, TIMEOUT_BSY) != EOK)
+			return EIO;
+
+		if ((status & SR_ERR) != 0 || (status & SR_DRQ) == 0)
+			return EIO;
 
-	if ((status & SR_DRQ) != 0) {
 		/* Read data from the device buffer. */
+		n = min(nblocks, drq_blocks);
+		for (i = 0; i < n * blk_size / 2; i++)
+			*bp++ = pio_read_16(&ctrl->cmd->data_port);
 
-		for (i = 0; i < blk_size / 2; i++) {
-			data = pio_read_16(&ctrl->cmd->data_port);
-			((uint16_t *) obuf)[i] = data;
-		}
+		nblocks -= n;
 	}
 
-	if ((status & SR_ERR) != 0)
-		return EIO;
-
 	return EOK;
 }
 
-/** PIO data-out command protocol. */
+/** PIO data-out command protocol.
+ *
+ * The device requests an interrupt after each data block, the one after
+ * the last data block signals command completion.
+ *
+ * @param disk		Disk
+ * @param buf		Data to write
+ * @param buf_size	Size of @a buf in bytes
+ * @param blk_size	Block size in bytes
+ * @param nblocks	Number of blocks to transfer
+ * @param drq_blocks	Number of blocks in one data block
+ */
 static errno_t ata_pio_data_out(disk_t *disk, const void *buf, size_t buf_size,
-    size_t blk_size, size_t nblocks)
+    size_t blk_size, size_t nblocks, size_t drq_blocks)
 {
 	ata_ctrl_t *ctrl = disk->ctrl;
-	size_t i;
+	const uint16_t *bp = buf;
+	size_t i, n;
 	uint8_t status;
 
-	/* XXX Support multiple blocks */
-	assert(nblocks == 1);
 	assert(blk_size % 2 == 0);
+	assert(nblocks * blk_size <= buf_size);
+	assert(drq_blocks > 0);
 
+	/* There is no interrupt before the first data block. */
 	if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
 		return EIO;
 
-	if ((status & SR_DRQ) != 0) {
+	while (nblocks > 0) {
+		if ((status & SR_ERR) != 0 || (status & SR_DRQ) == 0)
+			return EIO;
+
 		/* Write data to the device buffer. */
+		n = min(nblocks, drq_blocks);
+		for (i = 0; i < n * blk_size / 2; i++)
+			pio_write_16(&ctrl->cmd->data_port, *bp++);
 
-		for (i = 0; i < blk_size / 2; i++) {
-			pio_write_16(&ctrl->cmd->data_port, ((uint16_t *) buf)[i]);
-		}
+		nblocks -= n;
+
+		if (wait_irq(ctrl, &status, TIMEOUT_BSY) != EOK)
+			return EIO;
 	}
 
 	if (status & SR_ERR)
@@ -667,7 +844,7 @@ static errno_t ata_pio_nondata(disk_t *disk)
 	ata_ctrl_t *ctrl = disk->ctrl;
 	uint8_t status;
 
-	if (wait_status(ctrl, 0, ~SR_BSY, &status, TIMEOUT_BSY) != EOK)
+	if (wait_irq(ctrl, &status, TIMEOUT_BSY) != EOK)
 		return EIO;
 
 	if (status & SR_ERR)
@@ -728,7 +905,7 @@ static errno_t ata_identify_dev(disk_t *disk, void *buf)
 		return ETIMEOUT;
 
 	return ata_pio_data_in(disk, buf, identify_data_size,
-	    identify_data_size, 1);
+	    identify_data_size, 1, 1);
 }
 
 /** Issue Identify Packet Device command.
@@ -758,7 +935,7 @@ static errno_t ata_identify_pkt_dev(disk_t *disk, void *buf)
 	pio_write_8(&ctrl->cmd->command, CMD_IDENTIFY_PKT_DEV);
 
 	return ata_pio_data_in(disk, buf, identify_data_size,
-	    identify_data_size, 1);
+	    identify_data_size, 1, 1);
 }
 
 /** Issue packet command (i. e. write a command packet to the device).
@@ -1007,6 +1184,8 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t blk_cnt,
 	ata_ctrl_t *ctrl = disk->ctrl;
 	uint8_t drv_head;
 	block_coord_t bc;
+	uint8_t cmd;
+	size_t drq_blocks;
 	errno_t rc;
 
 	/* Silence warning. */
@@ -1016,6 +1195,20 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t blk_cnt,
 	if (coord_calc(disk, ba, &bc) != EOK)
 		return EINVAL;
 
+	if (blk_cnt == 0 || blk_cnt > disk->max_sectors ||
+	    blk_cnt > disk->blocks - ba)
+		return EINVAL;
+
+	if (disk->multi_sectors != 0) {
+		cmd = disk->amode == am_lba48 ? CMD_READ_MULTIPLE_EXT :
+		    CMD_READ_MULTIPLE;
+		drq_blocks = disk->multi_sectors;
+	} else {
+		cmd = disk->amode == am_lba48 ? CMD_READ_SECTORS_EXT :
+		    CMD_READ_SECTORS;
+		drq_blocks = 1;
+	}
+
 	/* New value for Drive/Head register */
 	drv_head =
 	    ((disk_dev_idx(disk) != 0) ? DHR_DRV : 0) |
@@ -1024,7 +1217,7 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t blk_cnt,
 
 	fibril_mutex_lock(&ctrl->lock);
 
-	/* Program a Read Sectors operation. */
+	/* Program a Read Sectors or Read Multiple operation. */
 
 	if (wait_status(ctrl, 0, ~SR_BSY, NULL, TIMEOUT_BSY) != EOK) {
 		fibril_mutex_unlock(&ctrl->lock);
@@ -1039,13 +1232,13 @@ static errno_t ata_rcmd_read(disk_t *disk, uint64_t ba, size_t blk_cnt,
 	}
 
 	/* Program block coordinates into the device. */
-	coord_sc_program(ctrl, &bc, 1);
+	coord_sc_program(ctrl, &bc, blk_cnt);
 
-	pio_write_8(&ctrl->cmd->command, disk->amode == am_lba48 ?
-	    CMD_READ_SECTORS_EXT : CMD_READ_SECTORS);
+	ata_irq_arm(ctrl);
+	pio_write_8(&ctrl->cmd->command, cmd);
 
 	rc = ata_pio_data_in(disk, buf, blk_cnt * disk->block_size,
-	    disk->block_size, blk_cnt);
+	    disk->block_size, blk_cnt, drq_blocks);
 
 	fibril_mutex_unlock(&ctrl->lock);
 
@@ -1067,6 +1260,8 @@ static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
 	ata_ctrl_t *ctrl = disk->ctrl;
 	uint8_t drv_head;
 	block_coord_t bc;
+	uint8_t cmd;
+	size_t drq_blocks;
 	errno_t rc;
 
 	/* Silence warning. */
@@ -1076,6 +1271,19 @@ static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
 	if (coord_calc(disk, ba, &bc) != EOK)
 		return EINVAL;
 
+	if (cnt == 0 || cnt > disk->max_sectors || cnt > disk->blocks - ba)
+		return EINVAL;
+
+	if (disk->multi_sectors != 0) {
+		cmd = disk->amode == am_lba48 ? CMD_WRITE_MULTIPLE_EXT :
+		    CMD_WRITE_MULTIPLE;
+		drq_blocks = disk->multi_sectors;
+	} else {
+		cmd = disk->amode == am_lba48 ? CMD_WRITE_SECTORS_EXT :
+		    CMD_WRITE_SECTORS;
+		drq_blocks = 1;
+	}
+
 	/* New value for Drive/Head register */
 	drv_head =
 	    ((disk_dev_idx(disk) != 0) ? DHR_DRV : 0) |
@@ -1084,7 +1292,7 @@ static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
 
 	fibril_mutex_lock(&ctrl->lock);
 
-	/* Program a Write Sectors operation. */
+	/* Program a Write Sectors or Write Multiple operation. */
 
 	if (wait_status(ctrl, 0, ~SR_BSY, NULL, TIMEOUT_BSY) != EOK) {
 		fibril_mutex_unlock(&ctrl->lock);
@@ -1099,13 +1307,13 @@ static errno_t ata_rcmd_write(disk_t *disk, uint64_t ba, size_t cnt,
 	}
 
 	/* Program block coordinates into the device. */
-	coord_sc_program(ctrl, &bc, 1);
+	coord_sc_program(ctrl, &bc, cnt);
 
-	pio_write_8(&ctrl->cmd->command, disk->amode == am_lba48 ?
-	    CMD_WRITE_SECTORS_EXT : CMD_WRITE_SECTORS);
+	ata_irq_arm(ctrl);
+	pio_write_8(&ctrl->cmd->command, cmd);
 
 	rc = ata_pio_data_out(disk, buf, cnt * disk->block_size,
-	    disk->block_size, cnt);
+	    disk->block_size, cnt, drq_blocks);
 
 	fibril_mutex_unlock(&ctrl->lock);
 	return rc;
@@ -1143,6 +1351,7 @@ static errno_t ata_rcmd_flush_cache(disk_t *disk)
 		return EIO;
 	}
 
+	ata_irq_arm(ctrl);
 	pio_write_8(&ctrl->cmd->command, CMD_FLUSH_CACHE);
 
 	rc = ata_pio_nondata(disk);
@@ -1151,6 +1360,50 @@ static errno_t ata_rcmd_flush_cache(disk_t *disk)
 	return rc;
 }
 
+/** Set the number of sectors per data block of Read/Write Multiple.
+ *
+ * @param disk		Disk
+ * @param count		Number of sectors
+ *
+ * @return EOK on success, EIO on error.
+ */
+static errno_t ata_rcmd_set_multiple(disk_t *disk, unsigned count)
+{
+	ata_ctrl_t *ctrl = disk->ctrl;
+	uint8_t drv_head;
+	errno_t rc;
+
+	/* New value for Drive/Head register */
+	drv_head =
+	    (disk_dev_idx(disk) != 0) ? DHR_DRV : 0;
+
+	fibril_mutex_lock(&ctrl->lock);
+
+	/* Program a Set Multiple Mode operation. */
+
+	if (wait_status(ctrl, 0, ~SR_BSY, NULL, TIMEOUT_BSY) != EOK) {
+		fibril_mutex_unlock(&ctrl->lock);
+		return EIO;
+	}
+
+	pio_write_8(&ctrl->cmd->drive_head, drv_head);
+
+	if (wait_status(ctrl, SR_DRDY, ~SR_BSY, NULL, TIMEOUT_DRDY) != EOK) {
+		fibril_mutex_unlock(&ctrl->lock);
+		return EIO;
+	}
+
+	pio_write_8(&ctrl->cmd->sector_count, count);
+
+	ata_irq_arm(ctrl);
+	pio_write_8(&ctrl->cmd->command, CMD_SET_MULTIPLE_MODE);
+
+	rc = ata_pio_nondata(disk);
+
+	fibril_mutex_unlock(&ctrl->lock);
+	return rc;
+}
+
 /** Calculate block coordinates.
  *
  * Calculates block coordinates in the best coordinate system supported
@@ -1288,6 +1541,64 @@ static errno_t wait_status(ata_ctrl_t *ctrl, unsigned set, unsigned n_reset,
 	return EOK;
 }
 
+/** Forget interrupts that arrived before a command is issued.
+ *
+ * @param ctrl		Controller
+ */
+static void ata_irq_arm(ata_ctrl_t *ctrl)
+{
+	if (!ctrl->use_irq)
+		return;
+
+	fibril_mutex_lock(&ctrl->irq_lock);
+	ctrl->irq_fired = false;
+	fibril_mutex_unlock(&ctrl->irq_lock);
+}
+
+/** Wait for an interrupt from the device.
+ *
+ * Without an interrupt this waits until the device is not busy. If the
+ * interrupt does not arrive in time, the status is checked directly in
+ * case the interrupt got lost.
+ *
+ * @param ctrl		Controller
+ * @param pstatus	Pointer where to store the status
+ * @param timeout	Timeout in 10ms units.
+ *
+ * @return		EOK on success, EIO on timeout.
+ */
+static errno_t wait_irq(ata_ctrl_t *ctrl, uint8_t *pstatus, unsigned timeout)
+{
+	errno_t rc = EOK;
+	bool fired;
+	uint8_t status;
+
+	if (!ctrl->use_irq)
+		return wait_status(ctrl, 0, ~SR_BSY, pstatus, timeout);
+
+	fibril_mutex_lock(&ctrl->irq_lock);
+	while (!ctrl->irq_fired && rc == EOK) {
+		rc = fibril_condvar_wait_timeout(&ctrl->irq_cv,
+		    &ctrl->irq_lock, (usec_t) timeout * 10000);
+	}
+
+	fired = ctrl->irq_fired;
+	status = ctrl->irq_status;
+	ctrl->irq_fired = false;
+	fibril_mutex_unlock(&ctrl->irq_lock);
+
+	if (!fired) {
+		ddf_msg(LVL_WARN, "Interrupt timed out.");
+		return wait_status(ctrl, 0, ~SR_BSY, pstatus, 1);
+	}
+
+	if ((status & SR_BSY) != 0)
+		return wait_status(ctrl, 0, ~SR_BSY, pstatus, timeout);
+
+	*pstatus = status;
+	return EOK;
+}
+
 /**
  * @}
  */
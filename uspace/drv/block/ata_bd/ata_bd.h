@@ -50,6 +50,7 @@
 typedef struct {
 	uintptr_t cmd;	/**< Command block base address. */
 	uintptr_t ctl;	/**< Control block base address. */
+	int irq;	/**< IRQ number or -1 if none. */
 } ata_base_t;
 
 /** Timeout definitions. Unit is 10 ms. */
@@ -121,6 +122,11 @@ typedef struct {
 	uint64_t blocks;
 	size_t block_size;
 
+	/** Sectors per DRQ block of Read/Write Multiple, 0 if not used */
+	unsigned multi_sectors;
+	/** Maximum number of sectors transferred by one command */
+	size_t max_sectors;
+
 	char model[STR_BOUNDS(40) + 1];
 
 	int disk_id;
@@ -144,6 +150,21 @@ typedef struct ata_ctrl {
 	disk_t disk[MAX_DISKS];
 
 	fibril_mutex_t lock;
+
+	/** IRQ number or -1 if none */
+	int irq;
+	/** Whether command completion is signalled by interrupts */
+	bool use_irq;
+	/** IRQ capability handle */
+	cap_irq_handle_t irq_handle;
+	/** Protects @c irq_fired and @c irq_status */
+	fibril_mutex_t irq_lock;
+	/** Signalled when an interrupt arrives */
+	fibril_condvar_t irq_cv;
+	/** An interrupt arrived since the last wait */
+	bool irq_fired;
+	/** Status register read when the interrupt arrived */
+	uint8_t irq_status;
 } ata_ctrl_t;
 
 typedef struct ata_fun {
@@ -133,8 +133,13 @@ enum ata_command {
 	CMD_READ_SECTORS_EXT	= 0x24,
 	CMD_WRITE_SECTORS	= 0x30,
 	CMD_WRITE_SECTORS_EXT	= 0x34,
+	CMD_READ_MULTIPLE_EXT	= 0x29,
+	CMD_WRITE_MULTIPLE_EXT	= 0x39,
 	CMD_PACKET		= 0xA0,
 	CMD_IDENTIFY_PKT_DEV	= 0xA1,
+	CMD_READ_MULTIPLE	= 0xC4,
+	CMD_WRITE_MULTIPLE	= 0xC5,
+	CMD_SET_MULTIPLE_MODE	= 0xC6,
 	CMD_IDENTIFY_DRIVE	= 0xEC,
 	CMD_FLUSH_CACHE		= 0xE7
 };
@@ -236,6 +241,12 @@ enum ata_pktdev_caps {
 	pd_cap_dma		= 0x0100
 };
 
+/** Bits of @c identify_data_t.max_rw_multiple */
+enum ata_max_rw_multiple {
+	/** Maximum number of sectors per DRQ block of Read/Write Multiple */
+	mrm_max_count		= 0x00ff
+};
+
 /** Bits of @c identify_data_t.cmd_set1 */
 enum ata_cs1 {
 	cs1_addr48	= 0x0400	/**< 48-bit address feature set */
@@ -89,6 +89,7 @@ static errno_t ata_get_res(ddf_dev_t *dev, ata_base_t *ata_res)
 	addr_range_t *ctl_rng = &hw_res.io_ranges.ranges[1];
 	ata_res->cmd = RNGABS(*cmd_rng);
 	ata_res->ctl = RNGABS(*ctl_rng);
+	ata_res->irq = hw_res.irqs.count > 0 ? hw_res.irqs.irqs[0] : -1;
 
 	if (RNGSZ(*ctl_rng) < sizeof(ata_ctl_t)) {
 		rc = EINVAL;
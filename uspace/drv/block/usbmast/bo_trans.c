@@ -36,6 +36,7 @@
 
 #include <stdbool.h>
 #include <errno.h>
+#include <mem.h>
 #include <str_error.h>
 #include <usb/debug.h>
 #include <usb/dev/request.h>
@@ -47,7 +48,98 @@
 #define MASTLOG(format, ...) \
 	usb_log_debug2("USB cl08: " format, ##__VA_ARGS__)
 
-/** Send command via bulk-only transport.
+/** Size of the data part of the transfer buffer */
+#define BO_BUF_DATA_SIZE  (128 * 1024)
+/** Offset of command and status wrappers in the transfer buffer */
+#define BO_BUF_WRAPPER_OFFSET  BO_BUF_DATA_SIZE
+/** Size of the transfer buffer */
+#define BO_BUF_SIZE  (BO_BUF_DATA_SIZE + 64)
+
+/** Allocate the transfer buffer of a mass storage device.
+ *
+ * The buffer is shared with the host controller for all commands, which
+ * saves allocating DMA memory for every transfer. Without it, transfers
+ * go through usb_pipe_read() and usb_pipe_write().
+ *
+ * @param mdev		Mass storage device
+ */
+void usb_massstor_buffer_alloc(usbmast_dev_t *mdev)
+{
+	fibril_mutex_initialize(&mdev->cmd_lock);
+	mdev->dma_buf = usb_pipe_alloc_buffer(mdev->bulk_in_pipe, BO_BUF_SIZE);
+	if (mdev->dma_buf == NULL)
+		usb_log_warning("Failed to allocate transfer buffer.");
+}
+
+/** Free the transfer buffer of a mass storage device.
+ *
+ * @param mdev		Mass storage device
+ */
+void usb_massstor_buffer_free(usbmast_dev_t *mdev)
+{
+	if (mdev->dma_buf != NULL)
+		usb_pipe_free_buffer(mdev->bulk_in_pipe, mdev->dma_buf);
+	mdev->dma_buf = NULL;
+}
+
+/** Get the preferred maximum amount of data transferred by one command.
+ *
+ * Larger data stages bypass the transfer buffer and need DMA memory to be
+ * allocated for every transfer.
+ *
+ * @param mdev		Mass storage device
+ * @return		Size in bytes
+ */
+size_t usb_massstor_max_xfer_size(usbmast_dev_t *mdev)
+{
+	return BO_BUF_DATA_SIZE;
+}
+
+/** Write to a bulk pipe, through the transfer buffer if possible.
+ *
+ * @param mdev		Mass storage device
+ * @param pipe		Bulk out pipe
+ * @param offset	Offset in the transfer buffer to use
+ * @param data		Data to send
+ * @param size		Size of data
+ * @return		Error code
+ */
+static errno_t bo_write(usbmast_dev_t *mdev, usb_pipe_t *pipe, size_t offset,
+    const void *data, size_t size)
+{
+	if (mdev->dma_buf == NULL || offset + size > BO_BUF_SIZE)
+		return usb_pipe_write(pipe, data, size);
+
+	void *ptr = mdev->dma_buf + offset;
+	memcpy(ptr, data, size);
+	return usb_pipe_write_dma(pipe, mdev->dma_buf, ptr, size);
+}
+
+/** Read from a bulk pipe, through the transfer buffer if possible.
+ *
+ * @param mdev		Mass storage device
+ * @param pipe		Bulk in pipe
+ * @param offset	Offset in the transfer buffer to use
+ * @param data		Buffer for received data
+ * @param size		Size of the buffer
+ * @param act_size	Place to store number of bytes received
+ * @return		Error code
+ */
+static errno_t bo_read(usbmast_dev_t *mdev, usb_pipe_t *pipe, size_t offset,
+    void *data, size_t size, size_t *act_size)
+{
+	if (mdev->dma_buf == NULL || offset + size > BO_BUF_SIZE)
+		return usb_pipe_read(pipe, data, size, act_size);
+
+	void *ptr = mdev->dma_buf + offset;
+	const errno_t rc = usb_pipe_read_dma(pipe, mdev->dma_buf, ptr, size,
+	    act_size);
+	if (rc == EOK)
+		memcpy(data, ptr, *act_size);
+	return rc;
+}
+
+/** Send command via bulk-only transport with the command lock held.
  *
  * @param mfun		Mass storage function
  * @param tag		Command block wrapper tag (automatically compared
@@ -56,8 +148,9 @@
  *
  * @return		Error code
  */
-errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
+static errno_t bo_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 {
+	usbmast_dev_t *mdev = mfun->mdev;
 	errno_t rc;
 
 	if (cmd->data_in && cmd->data_out)
@@ -83,7 +176,8 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 
 	/* Send the CBW. */
 	MASTLOG("Sending CBW.\n");
-	rc = usb_pipe_write(bulk_out_pipe, &cbw, sizeof(cbw));
+	rc = bo_write(mdev, bulk_out_pipe, BO_BUF_WRAPPER_OFFSET, &cbw,
+	    sizeof(cbw));
 	MASTLOG("CBW '%s' sent: %s.\n",
 	    usb_debug_str_buffer((uint8_t *) &cbw, sizeof(cbw), 0),
 	    str_error(rc));
@@ -96,7 +190,7 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	if (cmd->data_in) {
 		size_t act_size;
 		/* Recieve data from the device. */
-		rc = usb_pipe_read(dpipe, cmd->data_in, cmd->data_in_size,
+		rc = bo_read(mdev, dpipe, 0, cmd->data_in, cmd->data_in_size,
 		    &act_size);
 		MASTLOG("Received %zu bytes (%s): %s.\n", act_size,
 		    usb_debug_str_buffer(cmd->data_in, act_size, 0),
@@ -104,7 +198,8 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	}
 	if (cmd->data_out) {
 		/* Send data to the device. */
-		rc = usb_pipe_write(dpipe, cmd->data_out, cmd->data_out_size);
+		rc = bo_write(mdev, dpipe, 0, cmd->data_out,
+		    cmd->data_out_size);
 		MASTLOG("Sent %zu bytes (%s): %s.\n", cmd->data_out_size,
 		    usb_debug_str_buffer(cmd->data_out, cmd->data_out_size, 0),
 		    str_error(rc));
@@ -123,7 +218,8 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	usb_massstor_csw_t csw;
 	size_t csw_size;
 	MASTLOG("Reading CSW.\n");
-	rc = usb_pipe_read(bulk_in_pipe, &csw, sizeof(csw), &csw_size);
+	rc = bo_read(mdev, bulk_in_pipe, BO_BUF_WRAPPER_OFFSET, &csw,
+	    sizeof(csw), &csw_size);
 	MASTLOG("CSW '%s' received (%zu bytes): %s.\n",
 	    usb_debug_str_buffer((uint8_t *) &csw, csw_size, 0), csw_size,
 	    str_error(rc));
@@ -185,6 +281,26 @@ errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
 	return rc;
 }
 
+/** Send command via bulk-only transport.
+ *
+ * @param mfun		Mass storage function
+ * @param tag		Command block wrapper tag (automatically compared
+ *			with answer)
+ * @param cmd		SCSI command
+ *
+ * @return		Error code
+ */
+errno_t usb_massstor_cmd(usbmast_fun_t *mfun, uint32_t tag, scsi_cmd_t *cmd)
+{
+	usbmast_dev_t *mdev = mfun->mdev;
+
+	fibril_mutex_lock(&mdev->cmd_lock);
+	const errno_t rc = bo_cmd(mfun, tag, cmd);
+	fibril_mutex_unlock(&mdev->cmd_lock);
+
+	return rc;
+}
+
 /** Perform bulk-only mass storage reset.
  *
  * @param mfun		Mass storage function
@@ -85,6 +85,9 @@ typedef struct {
 	cmd_status_t status;
 } scsi_cmd_t;
 
+extern void usb_massstor_buffer_alloc(usbmast_dev_t *);
+extern void usb_massstor_buffer_free(usbmast_dev_t *);
+extern size_t usb_massstor_max_xfer_size(usbmast_dev_t *);
 extern errno_t usb_massstor_cmd(usbmast_fun_t *, uint32_t, scsi_cmd_t *);
 extern errno_t usb_massstor_reset(usbmast_dev_t *);
 extern void usb_massstor_reset_recovery(usbmast_dev_t *);
@@ -124,6 +124,7 @@ static errno_t usbmast_device_gone(usb_device_t *dev)
 		mdev->luns[i] = NULL;
 	}
 	free(mdev->luns);
+	usb_massstor_buffer_free(mdev);
 	return EOK;
 }
 
@@ -185,6 +186,8 @@ static errno_t usbmast_device_add(usb_device_t *dev)
 
 	mdev->bulk_in_pipe = &epm_in->pipe;
 	mdev->bulk_out_pipe = &epm_out->pipe;
+	usb_massstor_buffer_alloc(mdev);
+
 	for (i = 0; i < mdev->lun_count; i++) {
 		rc = usbmast_fun_create(mdev, i);
 		if (rc != EOK)
@@ -205,6 +208,7 @@ error:
 		ddf_fun_destroy(mdev->luns[i]);
 	}
 	free(mdev->luns);
+	usb_massstor_buffer_free(mdev);
 	return rc;
 }
 
@@ -276,7 +280,11 @@ static errno_t usbmast_fun_create(usbmast_dev_t *mdev, unsigned lun)
 	    usbmast_scsi_dev_type_str(inquiry.device_type),
 	    inquiry.removable ? "removable" : "non-removable");
 
-	uint32_t nblocks, block_size;
+	/* Only the result of the commands that follow matters */
+	(void) usbmast_test_unit_ready(mfun);
+
+	uint64_t nblocks;
+	uint32_t block_size;
 
 	rc = usbmast_read_capacity(mfun, &nblocks, &block_size);
 	if (rc != EOK) {
@@ -286,11 +294,35 @@ static errno_t usbmast_fun_create(usbmast_dev_t *mdev, unsigned lun)
 		goto error;
 	}
 
-	usb_log_info("Read Capacity: nblocks=%" PRIu32 ", "
+	usb_log_info("Read Capacity: nblocks=%" PRIu64 ", "
 	    "block_size=%" PRIu32 "\n", nblocks, block_size);
 
+	if (block_size == 0) {
+		usb_log_warning("Invalid block size, device `%s'.",
+		    usb_device_get_name(mdev->usb_dev));
+		rc = EIO;
+		goto error;
+	}
+
 	mfun->nblocks = nblocks;
 	mfun->block_size = block_size;
+	mfun->max_xfer_blocks = max(usb_massstor_max_xfer_size(mdev) /
+	    block_size, 1);
+
+	/*
+	 * The Block Limits VPD page is only asked for if the device claims
+	 * SPC-3, some older devices do not cope with VPD inquiries.
+	 */
+	uint32_t max_xfer_len;
+	if (inquiry.version >= SCSI_VERSION_SPC3 &&
+	    usbmast_block_limits(mfun, &max_xfer_len) == EOK &&
+	    max_xfer_len != 0) {
+		mfun->max_xfer_blocks = min(mfun->max_xfer_blocks,
+		    max_xfer_len);
+	}
+
+	usb_log_debug("Maximum transfer length: %zu blocks.",
+	    mfun->max_xfer_blocks);
 
 	rc = ddf_fun_bind(fun);
 	if (rc != EOK) {
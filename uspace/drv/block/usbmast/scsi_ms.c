@@ -40,6 +40,7 @@
 #include <byteorder.h>
 #include <inttypes.h>
 #include <macros.h>
+#include <stddef.h>
 #include <usb/dev/driver.h>
 #include <usb/debug.h>
 #include <errno.h>
@@ -72,7 +73,15 @@ static void usbmast_dump_sense(scsi_sense_data_t *sense_buf)
 	    sense_buf->additional_cqual);
 }
 
-static errno_t usb_massstor_unit_ready(usbmast_fun_t *mfun)
+/** Perform SCSI Test Unit Ready command on USB mass storage device.
+ *
+ * Failure of the command itself is only logged, commands that follow
+ * will report it if there is something wrong with the device.
+ *
+ * @param mfun		Mass storage function
+ * @return		Error code
+ */
+errno_t usbmast_test_unit_ready(usbmast_fun_t *mfun)
 {
 	scsi_cmd_t cmd;
 	scsi_cdb_test_unit_ready_t cdb;
@@ -105,7 +114,10 @@ static errno_t usb_massstor_unit_ready(usbmast_fun_t *mfun)
 
 /** Run SCSI command.
  *
- * Run command and repeat in case of unit attention.
+ * Run command and repeat in case of unit attention. The unit is not tested
+ * for readiness before each command as that would double the number of
+ * bulk-only transport round trips; a unit that is not ready fails the
+ * command and reports it in the sense data.
  * XXX This is too simplified.
  */
 static errno_t usbmast_run_cmd(usbmast_fun_t *mfun, scsi_cmd_t *cmd)
@@ -115,17 +127,11 @@ static errno_t usbmast_run_cmd(usbmast_fun_t *mfun, scsi_cmd_t *cmd)
 	errno_t rc;
 
 	do {
-		rc = usb_massstor_unit_ready(mfun);
-		if (rc != EOK) {
-			usb_log_error("Inquiry transport failed, device %s: %s.",
-			    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
-			return rc;
-		}
-
 		rc = usb_massstor_cmd(mfun, 0xDEADBEEF, cmd);
 		if (rc != EOK) {
-			usb_log_error("Inquiry transport failed, device %s: %s.",
-			    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
+			usb_log_error("Command transport failed, device %s: "
+			    "%s.", usb_device_get_name(mfun->mdev->usb_dev),
+			    str_error(rc));
 			return rc;
 		}
 
@@ -209,6 +215,8 @@ errno_t usbmast_inquiry(usbmast_fun_t *mfun, usbmast_inquiry_data_t *inq_res)
 	inq_res->device_type = BIT_RANGE_EXTRACT(uint8_t,
 	    inq_data.pqual_devtype, SCSI_PQDT_DEV_TYPE_h, SCSI_PQDT_DEV_TYPE_l);
 
+	inq_res->version = inq_data.version;
+
 	inq_res->removable = BIT_RANGE_EXTRACT(uint8_t,
 	    inq_data.rmb, SCSI_RMB_RMB, SCSI_RMB_RMB);
 
@@ -265,7 +273,64 @@ errno_t usbmast_request_sense(usbmast_fun_t *mfun, void *buf, size_t size)
 	return EOK;
 }
 
+/** Perform SCSI Read Capacity (16) command on USB mass storage device.
+ *
+ * @param mfun		Mass storage function
+ * @param nblocks	Output, number of blocks
+ * @param block_size	Output, block size in bytes
+ *
+ * @return		Error code.
+ */
+static errno_t usbmast_read_capacity_16(usbmast_fun_t *mfun,
+    uint64_t *nblocks, uint32_t *block_size)
+{
+	scsi_cmd_t cmd;
+	scsi_cdb_read_capacity_16_t cdb;
+	scsi_read_capacity_16_data_t data;
+	errno_t rc;
+
+	memset(&cdb, 0, sizeof(cdb));
+	cdb.op_code = SCSI_CMD_READ_CAPACITY_16;
+	cdb.service_action = SCSI_SA_READ_CAPACITY_16;
+	cdb.alloc_len = host2uint32_t_be(sizeof(data));
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cdb = &cdb;
+	cmd.cdb_size = sizeof(cdb);
+	cmd.data_in = &data;
+	cmd.data_in_size = sizeof(data);
+
+	rc = usbmast_run_cmd(mfun, &cmd);
+
+	if (rc != EOK) {
+		usb_log_error("Read Capacity (16) transport failed, device %s: %s.",
+		    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
+		return rc;
+	}
+
+	if (cmd.status != CMDS_GOOD) {
+		usb_log_error("Read Capacity (16) command failed, device %s.",
+		    usb_device_get_name(mfun->mdev->usb_dev));
+		return EIO;
+	}
+
+	/* Only the last LBA and block size are needed */
+	if (cmd.rcvd_size < offsetof(scsi_read_capacity_16_data_t, prot)) {
+		usb_log_error("SCSI Read Capacity response too short (%zu).",
+		    cmd.rcvd_size);
+		return EIO;
+	}
+
+	*nblocks = uint64_t_be2host(data.last_lba) + 1;
+	*block_size = uint32_t_be2host(data.block_size);
+
+	return EOK;
+}
+
 /** Perform SCSI Read Capacity command on USB mass storage device.
+ *
+ * Read Capacity (16) is used if the device has more blocks than
+ * Read Capacity (10) can report.
  *
  * @param mfun		Mass storage function
  * @param nblocks	Output, number of blocks
@@ -273,7 +338,7 @@ errno_t usbmast_request_sense(usbmast_fun_t *mfun, void *buf, size_t size)
  *
  * @return		Error code.
  */
-errno_t usbmast_read_capacity(usbmast_fun_t *mfun, uint32_t *nblocks,
+errno_t usbmast_read_capacity(usbmast_fun_t *mfun, uint64_t *nblocks,
     uint32_t *block_size)
 {
 	scsi_cmd_t cmd;
@@ -310,58 +375,132 @@ errno_t usbmast_read_capacity(usbmast_fun_t *mfun, uint32_t *nblocks,
 		return EIO;
 	}
 
-	*nblocks = uint32_t_be2host(data.last_lba) + 1;
+	/* Last LBA does not fit, the device expects Read Capacity (16) */
+	if (uint32_t_be2host(data.last_lba) == UINT32_MAX)
+		return usbmast_read_capacity_16(mfun, nblocks, block_size);
+
+	*nblocks = (uint64_t) uint32_t_be2host(data.last_lba) + 1;
 	*block_size = uint32_t_be2host(data.block_size);
 
 	return EOK;
 }
 
-/** Perform SCSI Read command on USB mass storage device.
+/** Read the Block Limits VPD page of USB mass storage device.
+ *
+ * @param mfun		Mass storage function
+ * @param max_xfer_len	Output, maximum number of blocks transferred by one
+ *			command, zero if the device reports no limit
+ *
+ * @return		Error code, ENOTSUP if the page is not supported
+ */
+errno_t usbmast_block_limits(usbmast_fun_t *mfun, uint32_t *max_xfer_len)
+{
+	scsi_block_limits_vpd_t data;
+	scsi_cmd_t cmd;
+	scsi_cdb_inquiry_t cdb;
+	errno_t rc;
+
+	memset(&cdb, 0, sizeof(cdb));
+	cdb.op_code = SCSI_CMD_INQUIRY;
+	cdb.evpd = BIT_V(uint8_t, SCSI_INQ_EVPD);
+	cdb.page_code = SCSI_VPD_BLOCK_LIMITS;
+	cdb.alloc_len = host2uint16_t_be(sizeof(data));
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.cdb = &cdb;
+	cmd.cdb_size = sizeof(cdb);
+	cmd.data_in = &data;
+	cmd.data_in_size = sizeof(data);
+
+	rc = usbmast_run_cmd(mfun, &cmd);
+
+	if (rc != EOK) {
+		usb_log_error("Inquiry transport failed, device %s: %s.",
+		    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
+		return rc;
+	}
+
+	if (cmd.status != CMDS_GOOD || cmd.rcvd_size < sizeof(data) ||
+	    data.page_code != SCSI_VPD_BLOCK_LIMITS)
+		return ENOTSUP;
+
+	*max_xfer_len = uint32_t_be2host(data.max_xfer_len);
+	return EOK;
+}
+
+/** Perform one SCSI Read or Write command on USB mass storage device.
+ *
+ * The 10-byte command is used when the request fits it, the 16-byte
+ * one otherwise.
  *
  * @param mfun		Mass storage function
  * @param ba		Address of first block
- * @param nblocks	Number of blocks to read
+ * @param nblocks	Number of blocks to transfer
+ * @param data_in	Buffer for read data or NULL when writing
+ * @param data_out	Data to write or NULL when reading
  *
  * @return		Error code
  */
-errno_t usbmast_read(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks, void *buf)
+static errno_t usbmast_rw_cmd(usbmast_fun_t *mfun, uint64_t ba,
+    size_t nblocks, void *data_in, const void *data_out)
 {
 	scsi_cmd_t cmd;
-	scsi_cdb_read_10_t cdb;
+	union {
+		scsi_cdb_read_10_t read_10;
+		scsi_cdb_read_16_t read_16;
+		scsi_cdb_write_10_t write_10;
+		scsi_cdb_write_16_t write_16;
+	} cdb;
+	const char *name;
 	errno_t rc;
 
-	if (ba > UINT32_MAX)
-		return ELIMIT;
-
-	if (nblocks > UINT16_MAX)
-		return ELIMIT;
+	const size_t size = nblocks * mfun->block_size;
 
 	memset(&cdb, 0, sizeof(cdb));
-	cdb.op_code = SCSI_CMD_READ_10;
-	cdb.lba = host2uint32_t_be(ba);
-	cdb.xfer_len = host2uint16_t_be(nblocks);
-
 	memset(&cmd, 0, sizeof(cmd));
 	cmd.cdb = &cdb;
-	cmd.cdb_size = sizeof(cdb);
-	cmd.data_in = buf;
-	cmd.data_in_size = nblocks * mfun->block_size;
+
+	if (ba + nblocks <= UINT32_MAX && nblocks <= UINT16_MAX) {
+		/* Read (10) and Write (10) share the layout */
+		cdb.read_10.op_code = data_in != NULL ? SCSI_CMD_READ_10 :
+		    SCSI_CMD_WRITE_10;
+		cdb.read_10.lba = host2uint32_t_be(ba);
+		cdb.read_10.xfer_len = host2uint16_t_be(nblocks);
+		cmd.cdb_size = sizeof(cdb.read_10);
+		name = data_in != NULL ? "Read (10)" : "Write (10)";
+	} else {
+		/* Read (16) and Write (16) share the layout */
+		cdb.read_16.op_code = data_in != NULL ? SCSI_CMD_READ_16 :
+		    SCSI_CMD_WRITE_16;
+		cdb.read_16.lba = host2uint64_t_be(ba);
+		cdb.read_16.xfer_len = host2uint32_t_be(nblocks);
+		cmd.cdb_size = sizeof(cdb.read_16);
+		name = data_in != NULL ? "Read (16)" : "Write (16)";
+	}
+
+	if (data_in != NULL) {
+		cmd.data_in = data_in;
+		cmd.data_in_size = size;
+	} else {
+		cmd.data_out = data_out;
+		cmd.data_out_size = size;
+	}
 
 	rc = usbmast_run_cmd(mfun, &cmd);
 
 	if (rc != EOK) {
-		usb_log_error("Read (10) transport failed, device %s: %s.",
+		usb_log_error("%s transport failed, device %s: %s.", name,
 		    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
 		return rc;
 	}
 
 	if (cmd.status != CMDS_GOOD) {
-		usb_log_error("Read (10) command failed, device %s.",
+		usb_log_error("%s command failed, device %s.", name,
 		    usb_device_get_name(mfun->mdev->usb_dev));
 		return EIO;
 	}
 
-	if (cmd.rcvd_size < nblocks * mfun->block_size) {
+	if (data_in != NULL && cmd.rcvd_size < size) {
 		usb_log_error("SCSI Read response too short (%zu).",
 		    cmd.rcvd_size);
 		return EIO;
@@ -370,7 +509,44 @@ errno_t usbmast_read(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks, void *buf
 	return EOK;
 }
 
+/** Perform SCSI Read command on USB mass storage device.
+ *
+ * The request is split into commands of at most the maximum transfer
+ * length of the function.
+ *
+ * @param mfun		Mass storage function
+ * @param ba		Address of first block
+ * @param nblocks	Number of blocks to read
+ *
+ * @return		Error code
+ */
+errno_t usbmast_read(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks, void *buf)
+{
+	uint8_t *bp = buf;
+	errno_t rc;
+
+	if (ba + nblocks < ba)
+		return ELIMIT;
+
+	while (nblocks > 0) {
+		const size_t n = min(nblocks, mfun->max_xfer_blocks);
+
+		rc = usbmast_rw_cmd(mfun, ba, n, bp, NULL);
+		if (rc != EOK)
+			return rc;
+
+		ba += n;
+		nblocks -= n;
+		bp += n * mfun->block_size;
+	}
+
+	return EOK;
+}
+
 /** Perform SCSI Write command on USB mass storage device.
+ *
+ * The request is split into commands of at most the maximum transfer
+ * length of the function.
  *
  * @param mfun		Mass storage function
  * @param ba		Address of first block
@@ -382,39 +558,22 @@ errno_t usbmast_read(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks, void *buf
 errno_t usbmast_write(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks,
     const void *data)
 {
-	scsi_cmd_t cmd;
-	scsi_cdb_write_10_t cdb;
+	const uint8_t *dp = data;
 	errno_t rc;
 
-	if (ba > UINT32_MAX)
+	if (ba + nblocks < ba)
 		return ELIMIT;
 
-	if (nblocks > UINT16_MAX)
-		return ELIMIT;
-
-	memset(&cdb, 0, sizeof(cdb));
-	cdb.op_code = SCSI_CMD_WRITE_10;
-	cdb.lba = host2uint32_t_be(ba);
-	cdb.xfer_len = host2uint16_t_be(nblocks);
-
-	memset(&cmd, 0, sizeof(cmd));
-	cmd.cdb = &cdb;
-	cmd.cdb_size = sizeof(cdb);
-	cmd.data_out = data;
-	cmd.data_out_size = nblocks * mfun->block_size;
-
-	rc = usbmast_run_cmd(mfun, &cmd);
+	while (nblocks > 0) {
+		const size_t n = min(nblocks, mfun->max_xfer_blocks);
 
-	if (rc != EOK) {
-		usb_log_error("Write (10) transport failed, device %s: %s.",
-		    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
-		return rc;
-	}
+		rc = usbmast_rw_cmd(mfun, ba, n, NULL, dp);
+		if (rc != EOK)
+			return rc;
 
-	if (cmd.status != CMDS_GOOD) {
-		usb_log_error("Write (10) command failed, device %s.",
-		    usb_device_get_name(mfun->mdev->usb_dev));
-		return EIO;
+		ba += n;
+		nblocks -= n;
+		dp += n * mfun->block_size;
 	}
 
 	return EOK;
@@ -431,33 +590,44 @@ errno_t usbmast_write(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks,
  */
 errno_t usbmast_sync_cache(usbmast_fun_t *mfun, uint64_t ba, size_t nblocks)
 {
-	if (ba > UINT32_MAX)
-		return ELIMIT;
-
-	if (nblocks > UINT16_MAX)
-		return ELIMIT;
-
-	const scsi_cdb_sync_cache_10_t cdb = {
-		.op_code = SCSI_CMD_SYNC_CACHE_10,
-		.lba = host2uint32_t_be(ba),
-		.numlb = host2uint16_t_be(nblocks),
-	};
+	const char *name;
+	union {
+		scsi_cdb_sync_cache_10_t sc_10;
+		scsi_cdb_sync_cache_16_t sc_16;
+	} cdb;
 
 	scsi_cmd_t cmd = {
 		.cdb = &cdb,
-		.cdb_size = sizeof(cdb),
 	};
 
+	memset(&cdb, 0, sizeof(cdb));
+
+	if (ba <= UINT32_MAX && nblocks <= UINT16_MAX) {
+		cdb.sc_10.op_code = SCSI_CMD_SYNC_CACHE_10;
+		cdb.sc_10.lba = host2uint32_t_be(ba);
+		cdb.sc_10.numlb = host2uint16_t_be(nblocks);
+		cmd.cdb_size = sizeof(cdb.sc_10);
+		name = "Synchronize Cache (10)";
+	} else if (nblocks <= UINT32_MAX) {
+		cdb.sc_16.op_code = SCSI_CMD_SYNC_CACHE_16;
+		cdb.sc_16.lba = host2uint64_t_be(ba);
+		cdb.sc_16.numlb = host2uint32_t_be(nblocks);
+		cmd.cdb_size = sizeof(cdb.sc_16);
+		name = "Synchronize Cache (16)";
+	} else {
+		return ELIMIT;
+	}
+
 	const errno_t rc = usbmast_run_cmd(mfun, &cmd);
 
 	if (rc != EOK) {
-		usb_log_error("Synchronize Cache (10) transport failed, device %s: %s.",
+		usb_log_error("%s transport failed, device %s: %s.", name,
 		    usb_device_get_name(mfun->mdev->usb_dev), str_error(rc));
 		return rc;
 	}
 
 	if (cmd.status != CMDS_GOOD) {
-		usb_log_error("Synchronize Cache (10) command failed, device %s.",
+		usb_log_error("%s command failed, device %s.", name,
 		    usb_device_get_name(mfun->mdev->usb_dev));
 		return EIO;
 	}
@@ -49,6 +49,8 @@
 typedef struct {
 	/** SCSI peripheral device type */
 	unsigned device_type;
+	/** Version of the standard the device claims conformance to */
+	unsigned version;
 	/** Whether the device is removable */
 	bool removable;
 	/** Vendor ID string */
@@ -61,7 +63,9 @@ typedef struct {
 
 extern errno_t usbmast_inquiry(usbmast_fun_t *, usbmast_inquiry_data_t *);
 extern errno_t usbmast_request_sense(usbmast_fun_t *, void *, size_t);
-extern errno_t usbmast_read_capacity(usbmast_fun_t *, uint32_t *, uint32_t *);
+extern errno_t usbmast_test_unit_ready(usbmast_fun_t *);
+extern errno_t usbmast_read_capacity(usbmast_fun_t *, uint64_t *, uint32_t *);
+extern errno_t usbmast_block_limits(usbmast_fun_t *, uint32_t *);
 extern errno_t usbmast_read(usbmast_fun_t *, uint64_t, size_t, void *);
 extern errno_t usbmast_write(usbmast_fun_t *, uint64_t, size_t, const void *);
 extern errno_t usbmast_sync_cache(usbmast_fun_t *, uint64_t, size_t);
@@ -37,6 +37,7 @@
 #define USBMAST_H_
 
 #include <bd_srv.h>
+#include <fibril_synch.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <usb/usb.h>
@@ -53,6 +54,10 @@ typedef struct usbmast_dev {
 	usb_pipe_t *bulk_in_pipe;
 	/** Data write pipe */
 	usb_pipe_t *bulk_out_pipe;
+	/** Serializes commands on the device */
+	fibril_mutex_t cmd_lock;
+	/** Transfer buffer accessible to the host controller or NULL */
+	void *dma_buf;
 } usbmast_dev_t;
 
 /** Mass storage function.
@@ -70,6 +75,8 @@ typedef struct {
 	uint64_t nblocks;
 	/** Block size in bytes */
 	size_t block_size;
+	/** Maximum number of blocks transferred by one command */
+	size_t max_xfer_blocks;
 	/** Block device service structure */
 	bd_srvs_t bds;
 } usbmast_fun_t;
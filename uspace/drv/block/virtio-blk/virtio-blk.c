@@ -32,6 +32,8 @@
 #include <stdint.h>
 
 #include <as.h>
+#include <ddi.h>
+#include <macros.h>
 #include <ddf/driver.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
@@ -50,16 +52,33 @@
 
 /*
  * VIRTIO_BLK requests need at least two descriptors so that device-read-only
- * buffers are separated from device-writable buffers. For convenience, we
- * always use three descriptors for the request header, buffer and footer.
- * We therefore organize the virtque so that first RQ_BUFFERS descriptors are
- * used for request headers, the following RQ_BUFFERS descriptors are used
- * for in/out buffers and the last RQ_BUFFERS descriptors are used for request
- * footers.
+ * buffers are separated from device-writable buffers. Each request slot owns
+ * RQ_CHAIN consecutive descriptors of the virtqueue, starting with the
+ * request header. A request either chains the header, up to RQ_DIRECT_SEGS
+ * data segments and the footer directly in these descriptors, or, if the
+ * device supports it, uses only the first one to point to the slot's
+ * indirect descriptor table.
  */
-#define REQ_HEADER_DESC(descno)	(0 * RQ_BUFFERS + (descno))
-#define REQ_BUFFER_DESC(descno)	(1 * RQ_BUFFERS + (descno))
-#define REQ_FOOTER_DESC(descno)	(2 * RQ_BUFFERS + (descno))
+#define REQ_HEAD_DESC(slot)	((slot) * RQ_CHAIN)
+#define REQ_SLOT(descno)	((descno) / RQ_CHAIN)
+
+/** Physically contiguous piece of a request's data */
+typedef struct {
+	uint64_t addr;
+	uint32_t len;
+} virtio_blk_seg_t;
+
+/** Request in flight */
+typedef struct {
+	/** Request slot */
+	uint16_t slot;
+	/** Number of blocks transferred by the request */
+	size_t cnt;
+	/** Caller's buffer */
+	void *buf;
+	/** Data goes through the slot's bounce buffer */
+	bool bounce;
+} virtio_blk_rq_t;
 
 static errno_t virtio_blk_dev_add(ddf_dev_t *dev);
 
@@ -81,10 +100,12 @@ static void virtio_blk_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	uint32_t len;
 
 	while (virtio_virtq_consume_used(vdev, RQ_QUEUE, &descno, &len)) {
-		assert(descno < RQ_BUFFERS);
-		fibril_mutex_lock(&virtio_blk->completion_lock[descno]);
-		fibril_condvar_signal(&virtio_blk->completion_cv[descno]);
-		fibril_mutex_unlock(&virtio_blk->completion_lock[descno]);
+		uint16_t slot = REQ_SLOT(descno);
+		assert(slot < RQ_SLOTS);
+		fibril_mutex_lock(&virtio_blk->completion_lock[slot]);
+		virtio_blk->completion_done[slot] = true;
+		fibril_condvar_signal(&virtio_blk->completion_cv[slot]);
+		fibril_mutex_unlock(&virtio_blk->completion_lock[slot]);
 	}
 }
 
@@ -93,6 +114,13 @@ static errno_t virtio_blk_register_interrupt(ddf_dev_t *dev)
 	virtio_blk_t *virtio_blk = (virtio_blk_t *) ddf_dev_data_get(dev);
 	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
 
+	/* The request queue gets a vector of its own if possible */
+	if (virtio_pci_msix_enable(vdev, 1) == EOK) {
+		virtio_blk->irq = vdev->msix_irq;
+		return virtio_pci_msix_register(dev, vdev, 0,
+		    virtio_blk_irq_handler, &virtio_blk->irq_handle);
+	}
+
 	async_sess_t *parent_sess = ddf_dev_parent_sess_get(dev);
 	if (parent_sess == NULL)
 		return ENOMEM;
@@ -157,71 +185,213 @@ static errno_t virtio_blk_bd_close(bd_srv_t *bd)
 	return EOK;
 }
 
-static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
-    aoff64_t ba, void *buf)
+/** Describe a buffer by its physical segments.
+ *
+ * The buffer is looked up page by page and physically adjacent pages are
+ * merged into one segment. The pages of a read buffer are touched first so
+ * that they are backed by frames when they are looked up.
+ *
+ * @param buf		Buffer.
+ * @param size		Size of the buffer in bytes.
+ * @param read		The device is going to write to the buffer.
+ * @param segs		Array for the segments.
+ * @param max_segs	Capacity of @a segs.
+ * @param rnsegs	Place to store the number of segments.
+ *
+ * @return		Number of bytes described, a multiple of the block
+ *			size. Zero if the buffer cannot be transferred in
+ *			place.
+ */
+static size_t virtio_blk_map_segs(void *buf, size_t size, bool read,
+    virtio_blk_seg_t *segs, unsigned max_segs, unsigned *rnsegs)
+{
+	unsigned nsegs = 0;
+	size_t done = 0;
+
+	while (done < size) {
+		uintptr_t va = (uintptr_t) buf + done;
+		size_t chunk = min(PAGE_SIZE - (va & (PAGE_SIZE - 1)),
+		    size - done);
+		uintptr_t pa;
+
+		if (read)
+			(void) *(volatile uint8_t *) va;
+		if (dmamem_map((void *) va, chunk, 0, 0, &pa) != EOK)
+			break;
+
+		virtio_blk_seg_t *last = nsegs > 0 ? &segs[nsegs - 1] : NULL;
+		if (last != NULL && last->addr + last->len == pa) {
+			last->len += chunk;
+		} else {
+			if (nsegs == max_segs)
+				break;
+			segs[nsegs].addr = pa;
+			segs[nsegs].len = chunk;
+			nsegs++;
+		}
+		done += chunk;
+	}
+
+	/* Only transfer whole blocks */
+	size_t trim = done % VIRTIO_BLK_BLOCK_SIZE;
+	done -= trim;
+	while (trim > 0) {
+		if (segs[nsegs - 1].len > trim) {
+			segs[nsegs - 1].len -= trim;
+			trim = 0;
+		} else {
+			trim -= segs[nsegs - 1].len;
+			nsegs--;
+		}
+	}
+
+	*rnsegs = nsegs;
+	return done;
+}
+
+/** Submit a request to the device.
+ *
+ * The request covers as many of the @a cnt blocks as fit in one descriptor
+ * chain or indirect table. The data is transferred directly to or from
+ * @a buf if its pages can be looked up, otherwise it goes through the
+ * bounce buffer of the request slot.
+ *
+ * @param virtio_blk	Device.
+ * @param read		Read (true) or write (false).
+ * @param ba		Block address.
+ * @param cnt		Number of blocks.
+ * @param buf		Buffer for the data.
+ * @param wait		Wait for a free request slot if there is none.
+ * @param rq		Place to store the submitted request.
+ *
+ * @return		True if the request was submitted, false if there was no
+ *			free request slot and @a wait was false.
+ */
+static bool virtio_blk_rq_submit(virtio_blk_t *virtio_blk, bool read,
+    aoff64_t ba, size_t cnt, void *buf, bool wait, virtio_blk_rq_t *rq)
 {
 	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
 
-	/*
-	 * Allocate a descriptor.
-	 *
-	 * The allocated descno will determine the header descriptor
-	 * (REQ_HEADER_DESC), the buffer descriptor (REQ_BUFFER_DESC) and the
-	 * footer (REQ_FOOTER_DESC) descriptor.
-	 */
+	/* Allocate a request slot. */
 	fibril_mutex_lock(&virtio_blk->free_lock);
-	uint16_t descno = virtio_alloc_desc(vdev, RQ_QUEUE,
-	    &virtio_blk->rq_free_head);
-	while (descno == (uint16_t) -1U) {
+	while (virtio_blk->rq_nfree == 0) {
+		if (!wait) {
+			fibril_mutex_unlock(&virtio_blk->free_lock);
+			return false;
+		}
 		fibril_condvar_wait(&virtio_blk->free_cv,
 		    &virtio_blk->free_lock);
-		descno = virtio_alloc_desc(vdev, RQ_QUEUE,
-		    &virtio_blk->rq_free_head);
 	}
+	uint16_t slot = virtio_blk->rq_free[--virtio_blk->rq_nfree];
 	fibril_mutex_unlock(&virtio_blk->free_lock);
 
-	assert(descno < RQ_BUFFERS);
+	assert(slot < RQ_SLOTS);
+
+	virtio_blk_seg_t segs[RQ_INDIRECT_SEGS];
+	unsigned nsegs;
+	size_t bytes = virtio_blk_map_segs(buf, cnt * VIRTIO_BLK_BLOCK_SIZE,
+	    read, segs, virtio_blk->max_segs, &nsegs);
+
+	rq->slot = slot;
+	rq->buf = buf;
+	rq->bounce = (bytes == 0);
+	if (rq->bounce) {
+		bytes = min(cnt * VIRTIO_BLK_BLOCK_SIZE, RQ_BOUNCE_SIZE);
+		segs[0].addr = virtio_blk->rq_buf_p[slot];
+		segs[0].len = bytes;
+		nsegs = 1;
+
+		/* Copy write data to the request. */
+		if (!read)
+			memcpy(virtio_blk->rq_buf[slot], buf, bytes);
+	}
+	rq->cnt = bytes / VIRTIO_BLK_BLOCK_SIZE;
 
 	/* Setup the request header */
 	virtio_blk_req_header_t *req_header =
-	    (virtio_blk_req_header_t *) virtio_blk->rq_header[descno];
+	    (virtio_blk_req_header_t *) virtio_blk->rq_header[slot];
 	memset(req_header, 0, sizeof(virtio_blk_req_header_t));
 	pio_write_le32(&req_header->type,
 	    read ? VIRTIO_BLK_T_IN : VIRTIO_BLK_T_OUT);
 	pio_write_le64(&req_header->sector, ba);
 
-	/* Copy write data to the request. */
-	if (!read)
-		memcpy(virtio_blk->rq_buf[descno], buf, VIRTIO_BLK_BLOCK_SIZE);
-
-	fibril_mutex_lock(&virtio_blk->completion_lock[descno]);
+	fibril_mutex_lock(&virtio_blk->completion_lock[slot]);
+	virtio_blk->completion_done[slot] = false;
+	fibril_mutex_unlock(&virtio_blk->completion_lock[slot]);
 
 	/*
-	 * Set the descriptors, chain them in the virtqueue and notify the
-	 * device.
+	 * Set the descriptors, chain them in the virtqueue or in the indirect
+	 * table and notify the device.
 	 */
-	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_HEADER_DESC(descno),
-	    virtio_blk->rq_header_p[descno], sizeof(virtio_blk_req_header_t),
-	    VIRTQ_DESC_F_NEXT, REQ_BUFFER_DESC(descno));
-	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_BUFFER_DESC(descno),
-	    virtio_blk->rq_buf_p[descno], VIRTIO_BLK_BLOCK_SIZE,
-	    VIRTQ_DESC_F_NEXT | (read ? VIRTQ_DESC_F_WRITE : 0),
-	    REQ_FOOTER_DESC(descno));
-	virtio_virtq_desc_set(vdev, RQ_QUEUE, REQ_FOOTER_DESC(descno),
-	    virtio_blk->rq_footer_p[descno], sizeof(virtio_blk_req_footer_t),
-	    VIRTQ_DESC_F_WRITE, 0);
-	virtio_virtq_produce_available(vdev, RQ_QUEUE, descno);
+	uint16_t head = REQ_HEAD_DESC(slot);
+	uint16_t data_flags = VIRTQ_DESC_F_NEXT |
+	    (read ? VIRTQ_DESC_F_WRITE : 0);
+
+	if (virtio_blk->indirect && nsegs > 1) {
+		virtq_desc_t *table = virtio_blk->rq_indirect[slot];
+
+		virtio_indirect_desc_set(vdev, table, 0,
+		    virtio_blk->rq_header_p[slot],
+		    sizeof(virtio_blk_req_header_t), VIRTQ_DESC_F_NEXT, 1);
+		for (unsigned i = 0; i < nsegs; i++) {
+			virtio_indirect_desc_set(vdev, table, i + 1,
+			    segs[i].addr, segs[i].len, data_flags, i + 2);
+		}
+		virtio_indirect_desc_set(vdev, table, nsegs + 1,
+		    virtio_blk->rq_footer_p[slot],
+		    sizeof(virtio_blk_req_footer_t), VIRTQ_DESC_F_WRITE, 0);
+
+		virtio_virtq_desc_set(vdev, RQ_QUEUE, head,
+		    virtio_blk->rq_indirect_p[slot],
+		    (nsegs + 2) * sizeof(virtq_desc_t), VIRTQ_DESC_F_INDIRECT,
+		    0);
+	} else {
+		assert(nsegs <= RQ_DIRECT_SEGS);
+
+		virtio_virtq_desc_set(vdev, RQ_QUEUE, head,
+		    virtio_blk->rq_header_p[slot],
+		    sizeof(virtio_blk_req_header_t), VIRTQ_DESC_F_NEXT,
+		    head + 1);
+		for (unsigned i = 0; i < nsegs; i++) {
+			virtio_virtq_desc_set(vdev, RQ_QUEUE, head + i + 1,
+			    segs[i].addr, segs[i].len, data_flags,
+			    head + i + 2);
+		}
+		virtio_virtq_desc_set(vdev, RQ_QUEUE, head + nsegs + 1,
+		    virtio_blk->rq_footer_p[slot],
+		    sizeof(virtio_blk_req_footer_t), VIRTQ_DESC_F_WRITE, 0);
+	}
+	virtio_virtq_produce_available(vdev, RQ_QUEUE, head);
+
+	return true;
+}
+
+/** Wait for a request to complete and release its slot.
+ *
+ * @param virtio_blk	Device.
+ * @param rq		Request.
+ * @param read		Read (true) or write (false).
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t virtio_blk_rq_complete(virtio_blk_t *virtio_blk,
+    virtio_blk_rq_t *rq, bool read)
+{
+	uint16_t slot = rq->slot;
 
 	/*
 	 * Wait for the completion of the request.
 	 */
-	fibril_condvar_wait(&virtio_blk->completion_cv[descno],
-	    &virtio_blk->completion_lock[descno]);
-	fibril_mutex_unlock(&virtio_blk->completion_lock[descno]);
+	fibril_mutex_lock(&virtio_blk->completion_lock[slot]);
+	while (!virtio_blk->completion_done[slot]) {
+		fibril_condvar_wait(&virtio_blk->completion_cv[slot],
+		    &virtio_blk->completion_lock[slot]);
+	}
+	fibril_mutex_unlock(&virtio_blk->completion_lock[slot]);
 
 	errno_t rc;
 	virtio_blk_req_footer_t *footer =
-	    (virtio_blk_req_footer_t *) virtio_blk->rq_footer[descno];
+	    (virtio_blk_req_footer_t *) virtio_blk->rq_footer[slot];
 	switch (footer->status) {
 	case VIRTIO_BLK_S_OK:
 		rc = EOK;
@@ -240,36 +410,59 @@ static errno_t virtio_blk_rw_block(virtio_blk_t *virtio_blk, bool read,
 	}
 
 	/* Copy read data from the request */
-	if (rc == EOK && read)
-		memcpy(buf, virtio_blk->rq_buf[descno], VIRTIO_BLK_BLOCK_SIZE);
+	if (rc == EOK && read && rq->bounce) {
+		memcpy(rq->buf, virtio_blk->rq_buf[slot],
+		    rq->cnt * VIRTIO_BLK_BLOCK_SIZE);
+	}
 
-	/* Free the descriptor and buffer */
+	/* Free the request slot */
 	fibril_mutex_lock(&virtio_blk->free_lock);
-	virtio_free_desc(vdev, RQ_QUEUE, &virtio_blk->rq_free_head, descno);
+	virtio_blk->rq_free[virtio_blk->rq_nfree++] = slot;
 	fibril_condvar_signal(&virtio_blk->free_cv);
 	fibril_mutex_unlock(&virtio_blk->free_lock);
 
 	return rc;
 }
 
+/** Transfer blocks, keeping up to RQ_PER_XFER requests in flight.
+ *
+ * A free request slot is only waited for when the transfer has no request
+ * in flight, so that concurrent transfers cannot deadlock each other over
+ * the slots they hold.
+ */
 static errno_t virtio_blk_bd_rw_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
     void *buf, size_t size, bool read)
 {
 	virtio_blk_t *virtio_blk = (virtio_blk_t *) bd->srvs->sarg;
-	aoff64_t i;
-	errno_t rc;
+	virtio_blk_rq_t rqs[RQ_PER_XFER];
+	size_t first = 0;
+	size_t next = 0;
+	size_t done = 0;
+	errno_t rc = EOK;
+	errno_t crc;
 
 	if (size != cnt * VIRTIO_BLK_BLOCK_SIZE)
 		return EINVAL;
 
-	for (i = 0; i < cnt; i++) {
-		rc = virtio_blk_rw_block(virtio_blk, read, ba + i,
-		    buf + i * VIRTIO_BLK_BLOCK_SIZE);
-		if (rc != EOK)
-			return rc;
+	while (first < next || (rc == EOK && done < cnt)) {
+		while (rc == EOK && done < cnt && next - first < RQ_PER_XFER) {
+			virtio_blk_rq_t *rq = &rqs[next % RQ_PER_XFER];
+			if (!virtio_blk_rq_submit(virtio_blk, read, ba + done,
+			    cnt - done, buf + done * VIRTIO_BLK_BLOCK_SIZE,
+			    first == next, rq))
+				break;
+			done += rq->cnt;
+			next++;
+		}
+
+		crc = virtio_blk_rq_complete(virtio_blk,
+		    &rqs[first % RQ_PER_XFER], read);
+		if (crc != EOK && rc == EOK)
+			rc = crc;
+		first++;
 	}
 
-	return EOK;
+	return rc;
 }
 
 static errno_t virtio_blk_bd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
@@ -290,6 +483,12 @@ static errno_t virtio_blk_bd_get_block_size(bd_srv_t *bd, size_t *size)
 	return EOK;
 }
 
+static errno_t virtio_blk_bd_get_queue_depth(bd_srv_t *bd, unsigned *depth)
+{
+	*depth = VIRTIO_BLK_QUEUE_DEPTH;
+	return EOK;
+}
+
 static errno_t virtio_blk_bd_get_num_blocks(bd_srv_t *bd, aoff64_t *nb)
 {
 	virtio_blk_t *virtio_blk = (virtio_blk_t *) bd->srvs->sarg;
@@ -305,6 +504,7 @@ bd_ops_t virtio_blk_bd_ops = {
 	.write_blocks = virtio_blk_bd_write_blocks,
 	.get_block_size = virtio_blk_bd_get_block_size,
 	.get_num_blocks = virtio_blk_bd_get_num_blocks,
+	.get_queue_depth = virtio_blk_bd_get_queue_depth,
 };
 
 static errno_t virtio_blk_initialize(ddf_dev_t *dev)
@@ -317,9 +517,10 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 	fibril_mutex_initialize(&virtio_blk->free_lock);
 	fibril_condvar_initialize(&virtio_blk->free_cv);
 
-	for (unsigned i = 0; i < RQ_BUFFERS; i++) {
+	for (unsigned i = 0; i < RQ_SLOTS; i++) {
 		fibril_mutex_initialize(&virtio_blk->completion_lock[i]);
 		fibril_condvar_initialize(&virtio_blk->completion_cv[i]);
+		virtio_blk->completion_done[i] = false;
 	}
 
 	bd_srvs_init(&virtio_blk->bds);
@@ -333,6 +534,8 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 	virtio_dev_t *vdev = &virtio_blk->virtio_dev;
 	virtio_pci_common_cfg_t *cfg = virtio_blk->virtio_dev.common_cfg;
 
+	vdev->packed = true;
+
 	/*
 	 * Register IRQ
 	 */
@@ -341,11 +544,21 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/* Reset the device and negotiate the feature bits */
-	rc = virtio_device_setup_start(vdev, 0);
+	rc = virtio_device_setup_start(vdev, 0, VIRTIO_RING_F_INDIRECT_DESC |
+	    VIRTIO_RING_F_EVENT_IDX | VIRTIO_BLK_F_SEG_MAX);
 	if (rc != EOK)
 		goto fail;
 
 	/* Perform device-specific setup */
+	virtio_blk->indirect = (vdev->features & VIRTIO_RING_F_INDIRECT_DESC);
+	virtio_blk->max_segs = virtio_blk->indirect ? RQ_INDIRECT_SEGS :
+	    RQ_DIRECT_SEGS;
+	if (vdev->features & VIRTIO_BLK_F_SEG_MAX) {
+		virtio_blk_cfg_t *blkcfg = vdev->device_cfg;
+		uint32_t seg_max = pio_read_le32(&blkcfg->seg_max);
+		if (seg_max > 0 && seg_max < virtio_blk->max_segs)
+			virtio_blk->max_segs = seg_max;
+	}
 
 	/*
 	 * Discover and configure the virtqueue
@@ -364,35 +577,38 @@ static errno_t virtio_blk_initialize(ddf_dev_t *dev)
 		goto fail;
 	}
 
-	/* For each in/out request we need 3 descriptors */
-	rc = virtio_virtq_setup(vdev, RQ_QUEUE, 3 * RQ_BUFFERS);
+	/* Each request slot owns RQ_CHAIN descriptors */
+	rc = virtio_virtq_setup(vdev, RQ_QUEUE, RQ_SLOTS * RQ_CHAIN);
 	if (rc != EOK)
 		goto fail;
 
 	/*
 	 * Setup DMA buffers
 	 */
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_header_t),
+	rc = virtio_setup_dma_bufs(RQ_SLOTS, sizeof(virtio_blk_req_header_t),
 	    true, virtio_blk->rq_header, virtio_blk->rq_header_p);
 	if (rc != EOK)
 		goto fail;
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, VIRTIO_BLK_BLOCK_SIZE,
+	rc = virtio_setup_dma_bufs(RQ_SLOTS, RQ_BOUNCE_SIZE,
 	    true, virtio_blk->rq_buf, virtio_blk->rq_buf_p);
 	if (rc != EOK)
 		goto fail;
-	rc = virtio_setup_dma_bufs(RQ_BUFFERS, sizeof(virtio_blk_req_footer_t),
+	rc = virtio_setup_dma_bufs(RQ_SLOTS, sizeof(virtio_blk_req_footer_t),
 	    false, virtio_blk->rq_footer, virtio_blk->rq_footer_p);
 	if (rc != EOK)
 		goto fail;
+	if (virtio_blk->indirect) {
+		rc = virtio_setup_dma_bufs(RQ_SLOTS,
+		    sizeof(virtq_desc_t[RQ_INDIRECT_SEGS + 2]), true,
+		    virtio_blk->rq_indirect, virtio_blk->rq_indirect_p);
+		if (rc != EOK)
+			goto fail;
+	}
 
-	/*
-	 * Put all request descriptors on a free list. Because of the
-	 * correspondence between the request, buffer and footer descriptors,
-	 * we only need to manage allocations for one set: the request header
-	 * descriptors.
-	 */
-	virtio_create_desc_free_list(vdev, RQ_QUEUE, RQ_BUFFERS,
-	    &virtio_blk->rq_free_head);
+	/* Put all request slots on the free stack. */
+	for (unsigned i = 0; i < RQ_SLOTS; i++)
+		virtio_blk->rq_free[i] = RQ_SLOTS - 1 - i;
+	virtio_blk->rq_nfree = RQ_SLOTS;
 
 	/*
 	 * Enable IRQ
@@ -415,6 +631,7 @@ fail:
 	virtio_teardown_dma_bufs(virtio_blk->rq_header);
 	virtio_teardown_dma_bufs(virtio_blk->rq_buf);
 	virtio_teardown_dma_bufs(virtio_blk->rq_footer);
+	virtio_teardown_dma_bufs(virtio_blk->rq_indirect);
 
 	virtio_device_setup_fail(vdev);
 	virtio_pci_dev_cleanup(vdev);
@@ -428,6 +645,7 @@ static void virtio_blk_uninitialize(ddf_dev_t *dev)
 	virtio_teardown_dma_bufs(virtio_blk->rq_header);
 	virtio_teardown_dma_bufs(virtio_blk->rq_buf);
 	virtio_teardown_dma_bufs(virtio_blk->rq_footer);
+	virtio_teardown_dma_bufs(virtio_blk->rq_indirect);
 
 	virtio_device_setup_fail(&virtio_blk->virtio_dev);
 	virtio_pci_dev_cleanup(&virtio_blk->virtio_dev);
@@ -46,8 +46,29 @@
 #define VIRTIO_BLK_S_IOERR	1
 #define VIRTIO_BLK_S_UNSUPP	2
 
-#define RQ_BUFFERS	32
+/** Number of requests that can be outstanding at the same time. */
+#define RQ_SLOTS	16
 
+/** Number of virtqueue descriptors reserved for each request. */
+#define RQ_CHAIN	8
+
+/** Maximum data segments of a request built from direct descriptors. */
+#define RQ_DIRECT_SEGS	(RQ_CHAIN - 2)
+
+/** Maximum data segments of a request built from an indirect table. */
+#define RQ_INDIRECT_SEGS	64
+
+/** Size of the bounce buffer of each request. */
+#define RQ_BOUNCE_SIZE	(16 * 1024)
+
+/** Number of requests a single block transfer keeps in flight. */
+#define RQ_PER_XFER	4
+
+/** Number of block transfers served at the same time. */
+#define VIRTIO_BLK_QUEUE_DEPTH	(RQ_SLOTS / RQ_PER_XFER)
+
+/** Maximum number of segments in a request is in seg_max. */
+#define VIRTIO_BLK_F_SEG_MAX	(1U << 2)
 /** Device is read-only. */
 #define VIRTIO_BLK_F_RO		(1U << 5)
 
@@ -63,21 +84,35 @@ typedef struct {
 
 typedef struct {
 	uint64_t capacity;
+	uint32_t size_max;
+	uint32_t seg_max;
 } virtio_blk_cfg_t;
 
 typedef struct {
 	virtio_dev_t virtio_dev;
 
-	void *rq_header[RQ_BUFFERS];
-	uintptr_t rq_header_p[RQ_BUFFERS];
+	void *rq_header[RQ_SLOTS];
+	uintptr_t rq_header_p[RQ_SLOTS];
+
+	/** Bounce buffers for data that cannot be transferred in place */
+	void *rq_buf[RQ_SLOTS];
+	uintptr_t rq_buf_p[RQ_SLOTS];
+
+	void *rq_footer[RQ_SLOTS];
+	uintptr_t rq_footer_p[RQ_SLOTS];
 
-	void *rq_buf[RQ_BUFFERS];
-	uintptr_t rq_buf_p[RQ_BUFFERS];
+	/** Indirect descriptor tables */
+	void *rq_indirect[RQ_SLOTS];
+	uintptr_t rq_indirect_p[RQ_SLOTS];
 
-	void *rq_footer[RQ_BUFFERS];
-	uintptr_t rq_footer_p[RQ_BUFFERS];
+	/** Stack of free request slots */
+	uint16_t rq_free[RQ_SLOTS];
+	unsigned rq_nfree;
 
-	uint16_t rq_free_head;
+	/** Requests are built from indirect descriptor tables */
+	bool indirect;
+	/** Maximum number of data segments in a request */
+	unsigned max_segs;
 
 	int irq;
 	cap_irq_handle_t irq_handle;
@@ -87,8 +122,9 @@ typedef struct {
 	fibril_mutex_t free_lock;
 	fibril_condvar_t free_cv;
 
-	fibril_mutex_t completion_lock[RQ_BUFFERS];
-	fibril_condvar_t completion_cv[RQ_BUFFERS];
+	fibril_mutex_t completion_lock[RQ_SLOTS];
+	fibril_condvar_t completion_cv[RQ_SLOTS];
+	bool completion_done[RQ_SLOTS];
 } virtio_blk_t;
 
 #endif
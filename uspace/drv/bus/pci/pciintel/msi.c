@@ -0,0 +1,476 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup pciintel
+ * @{
+ */
+/** @file Message signalled interrupts
+ *
+ * The kernel announces a range of IRQ numbers backed by interrupt vectors
+ * that can be raised by MSI and MSI-X messages. The vectors are handed out
+ * to PCI functions here and the function's MSI or MSI-X capability is
+ * programmed to deliver them.
+ */
+
+#include <assert.h>
+#include <ddf/log.h>
+#include <ddi.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <pci_dev_iface.h>
+#include <stdint.h>
+#include <sysinfo.h>
+
+#include "msi.h"
+#include "pci.h"
+#include "pci_regs.h"
+
+#define MSI_CTL(c)		((c) + 0x2)
+#define MSI_ADDR_LO(c)		((c) + 0x4)
+#define MSI_ADDR_HI(c)		((c) + 0x8)
+#define MSI_DATA_32(c)		((c) + 0x8)
+#define MSI_DATA_64(c)		((c) + 0xc)
+#define MSI_MASK_32(c)		((c) + 0xc)
+#define MSI_MASK_64(c)		((c) + 0x10)
+
+#define MSI_CTL_ENABLE		(1 << 0)
+#define MSI_CTL_MMC_SHIFT	1
+#define MSI_CTL_MME_SHIFT	4
+#define MSI_CTL_MM_MASK		0x7
+#define MSI_CTL_64BIT		(1 << 7)
+#define MSI_CTL_MASKABLE	(1 << 8)
+
+#define MSIX_CTL(c)		((c) + 0x2)
+#define MSIX_TABLE(c)		((c) + 0x4)
+
+#define MSIX_CTL_SIZE_MASK	0x7ff
+#define MSIX_CTL_FUNC_MASK	(1 << 14)
+#define MSIX_CTL_ENABLE		(1 << 15)
+
+#define MSIX_TABLE_BIR_MASK	0x7
+
+/** MSI-X table entry layout in 32-bit words */
+#define MSIX_ENTRY_WORDS	4
+#define MSIX_ENTRY_ADDR_LO	0
+#define MSIX_ENTRY_ADDR_HI	1
+#define MSIX_ENTRY_DATA		2
+#define MSIX_ENTRY_CTL		3
+
+#define MSIX_ENTRY_CTL_MASK	(1 << 0)
+
+/** Maximum number of vectors we keep track of */
+#define MSI_MAX_VECTORS		32
+
+/** Message signalled interrupt vectors announced by the kernel */
+static struct {
+	fibril_mutex_t lock;
+	/** IRQ number of the first vector */
+	int irq;
+	/** Number of vectors */
+	unsigned int count;
+	/** Message address */
+	uint32_t address;
+	/** Message data of the first vector */
+	uint32_t data;
+	/** Bitmap of vectors in use */
+	uint32_t used;
+} msi;
+
+/** Learn which vectors the kernel set aside for MSI. */
+void pci_msi_init(void)
+{
+	sysarg_t irq;
+	sysarg_t count;
+	sysarg_t address;
+	sysarg_t data;
+
+	fibril_mutex_initialize(&msi.lock);
+
+	if (sysinfo_get_value("msi.inr", &irq) != EOK ||
+	    sysinfo_get_value("msi.count", &count) != EOK ||
+	    sysinfo_get_value("msi.address", &address) != EOK ||
+	    sysinfo_get_value("msi.data", &data) != EOK) {
+		ddf_msg(LVL_NOTE, "Message signalled interrupts not "
+		    "available.");
+		return;
+	}
+
+	msi.irq = irq;
+	msi.count = min(count, MSI_MAX_VECTORS);
+	msi.address = address;
+	msi.data = data;
+}
+
+/** Allocate consecutive vectors.
+ *
+ * @param count Number of vectors
+ * @param align Required alignment of the message data of the first vector
+ *
+ * @return Index of the first vector or -1 if there is no free run
+ */
+static int msi_alloc(unsigned int count, unsigned int align)
+{
+	uint32_t mask = (count < 32) ? (1U << count) - 1 : UINT32_MAX;
+
+	for (unsigned int i = 0; i + count <= msi.count; i++) {
+		if (((msi.data + i) % align) != 0)
+			continue;
+
+		if ((msi.used & (mask << i)) == 0) {
+			msi.used |= mask << i;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/** Return vectors allocated by msi_alloc(). */
+static void msi_free(unsigned int first, unsigned int count)
+{
+	uint32_t mask = (count < 32) ? (1U << count) - 1 : UINT32_MAX;
+
+	msi.used &= ~(mask << first);
+}
+
+/** Find a capability of a function. */
+static uint8_t pci_fun_cap_find(pci_fun_t *fun, uint8_t id)
+{
+	if (!(pci_conf_read_16(fun, PCI_STATUS) & PCI_STATUS_CAP_LIST))
+		return 0;
+
+	uint8_t c = pci_conf_read_8(fun, PCI_CAP_PTR);
+
+	for (unsigned int n = 0; n < PCI_CONFIG_SPACE_SIZE / 4; n++) {
+		c &= ~3;
+		if (c == 0)
+			break;
+		if (pci_conf_read_8(fun, PCI_CAP_ID(c)) == id)
+			return c;
+		c = pci_conf_read_8(fun, PCI_CAP_NEXT(c));
+	}
+
+	return 0;
+}
+
+/** Disable legacy INTx interrupts of a function when it uses MSI. */
+static void pci_fun_intx_disable(pci_fun_t *fun, bool disable)
+{
+	uint16_t cmd = pci_conf_read_16(fun, PCI_COMMAND);
+
+	if (disable)
+		cmd |= PCI_COMMAND_INTX_DISABLE;
+	else
+		cmd &= ~PCI_COMMAND_INTX_DISABLE;
+
+	pci_conf_write_16(fun, PCI_COMMAND, cmd);
+}
+
+/** Map the MSI-X table of a function. */
+static errno_t msix_map_table(pci_fun_t *fun, uint8_t cap, size_t size)
+{
+	uint32_t table = pci_conf_read_32(fun, MSIX_TABLE(cap));
+	unsigned int bir = table & MSIX_TABLE_BIR_MASK;
+	uint64_t base;
+
+	if (bir >= PCI_BAR_COUNT)
+		return EINVAL;
+
+	uint32_t bar = pci_conf_read_32(fun, PCI_BAR0 + bir * 4);
+
+	/* The table must live in a memory BAR */
+	if ((bar & 1) != 0)
+		return EINVAL;
+
+	base = bar & ~0xfU;
+	if (((bar >> 1) & 3) == 2) {
+		base |= (uint64_t) pci_conf_read_32(fun,
+		    PCI_BAR0 + (bir + 1) * 4) << 32;
+	}
+
+	if (base == 0)
+		return EINVAL;
+
+	void *virt;
+	errno_t rc = pio_enable((void *) (uintptr_t) (base +
+	    (table & ~MSIX_TABLE_BIR_MASK)), size, &virt);
+	if (rc != EOK)
+		return rc;
+
+	fun->msix_table = virt;
+	fun->msix_table_size = size;
+	return EOK;
+}
+
+/** Program the MSI-X capability of a function. */
+static errno_t msix_enable(pci_fun_t *fun, uint8_t cap, unsigned int count,
+    int *irq, unsigned int *granted)
+{
+	uint16_t ctl = pci_conf_read_16(fun, MSIX_CTL(cap));
+	unsigned int entries = (ctl & MSIX_CTL_SIZE_MASK) + 1;
+	int first = -1;
+	errno_t rc;
+
+	rc = msix_map_table(fun, cap, entries * MSIX_ENTRY_WORDS *
+	    sizeof(uint32_t));
+	if (rc != EOK)
+		return rc;
+
+	/* Settle for fewer vectors rather than none */
+	for (count = min(count, entries); count > 0; count--) {
+		first = msi_alloc(count, 1);
+		if (first >= 0)
+			break;
+	}
+
+	if (first < 0) {
+		pio_disable((void *) fun->msix_table, fun->msix_table_size);
+		fun->msix_table = NULL;
+		return ENOSPC;
+	}
+
+	/* Keep all vectors masked until we are done */
+	pci_conf_write_16(fun, MSIX_CTL(cap),
+	    ctl | MSIX_CTL_ENABLE | MSIX_CTL_FUNC_MASK);
+
+	for (unsigned int i = 0; i < entries; i++) {
+		ioport32_t *entry = fun->msix_table + i * MSIX_ENTRY_WORDS;
+
+		pio_write_le32(&entry[MSIX_ENTRY_CTL], MSIX_ENTRY_CTL_MASK);
+		if (i >= count)
+			continue;
+
+		pio_write_le32(&entry[MSIX_ENTRY_ADDR_LO], msi.address);
+		pio_write_le32(&entry[MSIX_ENTRY_ADDR_HI], 0);
+		pio_write_le32(&entry[MSIX_ENTRY_DATA], msi.data + first + i);
+	}
+
+	pci_conf_write_16(fun, MSIX_CTL(cap), (ctl | MSIX_CTL_ENABLE) &
+	    ~MSIX_CTL_FUNC_MASK);
+
+	fun->msix = true;
+	*irq = msi.irq + first;
+	*granted = count;
+	return EOK;
+}
+
+/** Program the MSI capability of a function. */
+static errno_t msi_enable(pci_fun_t *fun, uint8_t cap, unsigned int count,
+    int *irq, unsigned int *granted)
+{
+	uint16_t ctl = pci_conf_read_16(fun, MSI_CTL(cap));
+	unsigned int mmc = (ctl >> MSI_CTL_MMC_SHIFT) & MSI_CTL_MM_MASK;
+	unsigned int mme;
+	int first = -1;
+
+	/* MSI can only grant a power of two of naturally aligned vectors */
+	for (mme = min(mmc, 5); mme > 0 && (1U << mme) > count; mme--)
+		;
+
+	for (;;) {
+		first = msi_alloc(1U << mme, 1U << mme);
+		if (first >= 0 || mme == 0)
+			break;
+		mme--;
+	}
+
+	if (first < 0)
+		return ENOSPC;
+
+	pci_conf_write_16(fun, MSI_CTL(cap), ctl & ~MSI_CTL_ENABLE);
+	pci_conf_write_32(fun, MSI_ADDR_LO(cap), msi.address);
+
+	if ((ctl & MSI_CTL_64BIT) != 0) {
+		pci_conf_write_32(fun, MSI_ADDR_HI(cap), 0);
+		pci_conf_write_16(fun, MSI_DATA_64(cap), msi.data + first);
+	} else {
+		pci_conf_write_16(fun, MSI_DATA_32(cap), msi.data + first);
+	}
+
+	/* Mask the vectors until they are enabled, if the device can */
+	if ((ctl & MSI_CTL_MASKABLE) != 0) {
+		pci_conf_write_32(fun, (ctl & MSI_CTL_64BIT) != 0 ?
+		    MSI_MASK_64(cap) : MSI_MASK_32(cap), UINT32_MAX);
+	}
+
+	ctl &= ~(MSI_CTL_MM_MASK << MSI_CTL_MME_SHIFT);
+	ctl |= (mme << MSI_CTL_MME_SHIFT) | MSI_CTL_ENABLE;
+	pci_conf_write_16(fun, MSI_CTL(cap), ctl);
+
+	fun->msix = false;
+	*irq = msi.irq + first;
+	*granted = 1U << mme;
+	return EOK;
+}
+
+/** Enable message signalled interrupts of a function.
+ *
+ * MSI-X is preferred over MSI. Once enabled, the function no longer
+ * signals INTx interrupts.
+ *
+ * @param fun     PCI function
+ * @param count   Number of requested vectors
+ * @param irq     Place to store the IRQ number of the first vector
+ * @param granted Place to store the number of granted vectors
+ *
+ * @return EOK on success or an error code
+ */
+errno_t pci_fun_msi_enable(pci_fun_t *fun, unsigned int count, int *irq,
+    unsigned int *granted)
+{
+	errno_t rc;
+	uint8_t cap;
+
+	if (count == 0)
+		return EINVAL;
+
+	fibril_mutex_lock(&msi.lock);
+
+	if (msi.count == 0) {
+		rc = ENOTSUP;
+		goto out;
+	}
+
+	if (fun->msi_count != 0) {
+		rc = EBUSY;
+		goto out;
+	}
+
+	cap = pci_fun_cap_find(fun, PCI_CAP_MSIX);
+	if (cap != 0) {
+		rc = msix_enable(fun, cap, count, irq, granted);
+	} else {
+		cap = pci_fun_cap_find(fun, PCI_CAP_MSI);
+		if (cap != 0)
+			rc = msi_enable(fun, cap, count, irq, granted);
+		else
+			rc = ENOTSUP;
+	}
+
+	if (rc == EOK) {
+		fun->msi_cap = cap;
+		fun->msi_irq = *irq;
+		fun->msi_count = *granted;
+		pci_fun_intx_disable(fun, true);
+
+		ddf_msg(LVL_NOTE, "Function %s uses %s irqs %d-%d.",
+		    ddf_fun_get_name(fun->fnode), fun->msix ? "MSI-X" : "MSI",
+		    fun->msi_irq, fun->msi_irq + (int) fun->msi_count - 1);
+	}
+
+out:
+	fibril_mutex_unlock(&msi.lock);
+	return rc;
+}
+
+/** Disable message signalled interrupts of a function.
+ *
+ * @param fun PCI function
+ *
+ * @return EOK on success or an error code
+ */
+errno_t pci_fun_msi_disable(pci_fun_t *fun)
+{
+	fibril_mutex_lock(&msi.lock);
+
+	if (fun->msi_count == 0) {
+		fibril_mutex_unlock(&msi.lock);
+		return EINVAL;
+	}
+
+	if (fun->msix) {
+		uint16_t ctl = pci_conf_read_16(fun, MSIX_CTL(fun->msi_cap));
+		pci_conf_write_16(fun, MSIX_CTL(fun->msi_cap),
+		    ctl & ~MSIX_CTL_ENABLE);
+
+		pio_disable((void *) fun->msix_table, fun->msix_table_size);
+		fun->msix_table = NULL;
+	} else {
+		uint16_t ctl = pci_conf_read_16(fun, MSI_CTL(fun->msi_cap));
+		pci_conf_write_16(fun, MSI_CTL(fun->msi_cap),
+		    ctl & ~MSI_CTL_ENABLE);
+	}
+
+	pci_fun_intx_disable(fun, false);
+
+	msi_free(fun->msi_irq - msi.irq, fun->msi_count);
+	fun->msi_count = 0;
+
+	fibril_mutex_unlock(&msi.lock);
+	return EOK;
+}
+
+/** Check whether an IRQ is one of the MSI vectors of a function. */
+bool pci_fun_owns_msi(pci_fun_t *fun, int irq)
+{
+	return fun->msi_count != 0 && irq >= fun->msi_irq &&
+	    irq < fun->msi_irq + (int) fun->msi_count;
+}
+
+/** Mask or unmask a message signalled interrupt vector.
+ *
+ * Vectors are masked when MSI is enabled so that the device does not
+ * interrupt before its driver is ready. MSI vectors of devices without
+ * per-vector masking cannot be masked and are left alone.
+ *
+ * @param fun  PCI function
+ * @param irq  IRQ number of the vector
+ * @param mask @c true to mask the vector, @c false to unmask it
+ */
+void pci_fun_msi_mask(pci_fun_t *fun, int irq, bool mask)
+{
+	unsigned int vec = irq - fun->msi_irq;
+
+	assert(pci_fun_owns_msi(fun, irq));
+
+	if (fun->msix) {
+		ioport32_t *ctl = &fun->msix_table[vec * MSIX_ENTRY_WORDS +
+		    MSIX_ENTRY_CTL];
+		pio_write_le32(ctl, mask ? MSIX_ENTRY_CTL_MASK : 0);
+		return;
+	}
+
+	uint16_t msictl = pci_conf_read_16(fun, MSI_CTL(fun->msi_cap));
+	if ((msictl & MSI_CTL_MASKABLE) == 0)
+		return;
+
+	int reg = (msictl & MSI_CTL_64BIT) != 0 ?
+	    MSI_MASK_64(fun->msi_cap) : MSI_MASK_32(fun->msi_cap);
+	uint32_t bits = pci_conf_read_32(fun, reg);
+
+	if (mask)
+		bits |= 1U << vec;
+	else
+		bits &= ~(1U << vec);
+
+	pci_conf_write_32(fun, reg, bits);
+}
+
+/**
+ * @}
+ */
@@ -58,6 +58,7 @@
 #include <pci_dev_iface.h>
 
 #include "ctl.h"
+#include "msi.h"
 #include "pci.h"
 #include "pci_regs.h"
 
@@ -116,6 +117,11 @@ static errno_t pciintel_enable_interrupt(ddf_fun_t *fnode, int irq)
 {
 	pci_fun_t *fun = pci_fun(fnode);
 
+	if (pci_fun_owns_msi(fun, irq)) {
+		pci_fun_msi_mask(fun, irq, false);
+		return EOK;
+	}
+
 	if (!pciintel_fun_owns_interrupt(fun, irq))
 		return EINVAL;
 
@@ -126,6 +132,11 @@ static errno_t pciintel_disable_interrupt(ddf_fun_t *fnode, int irq)
 {
 	pci_fun_t *fun = pci_fun(fnode);
 
+	if (pci_fun_owns_msi(fun, irq)) {
+		pci_fun_msi_mask(fun, irq, true);
+		return EOK;
+	}
+
 	if (!pciintel_fun_owns_interrupt(fun, irq))
 		return EINVAL;
 
@@ -136,6 +147,10 @@ static errno_t pciintel_clear_interrupt(ddf_fun_t *fnode, int irq)
 {
 	pci_fun_t *fun = pci_fun(fnode);
 
+	/* Message signalled interrupts need no acknowledgement */
+	if (pci_fun_owns_msi(fun, irq))
+		return EOK;
+
 	if (!pciintel_fun_owns_interrupt(fun, irq))
 		return EINVAL;
 
@@ -205,6 +220,17 @@ static errno_t config_space_read_8(
 	return EOK;
 }
 
+static errno_t pciintel_msi_enable(ddf_fun_t *fun, unsigned int count,
+    int *irq, unsigned int *granted)
+{
+	return pci_fun_msi_enable(pci_fun(fun), count, irq, granted);
+}
+
+static errno_t pciintel_msi_disable(ddf_fun_t *fun)
+{
+	return pci_fun_msi_disable(pci_fun(fun));
+}
+
 static hw_res_ops_t pciintel_hw_res_ops = {
 	.get_resource_list = &pciintel_get_resources,
 	.enable_interrupt = &pciintel_enable_interrupt,
@@ -222,7 +248,9 @@ static pci_dev_iface_t pci_dev_ops = {
 	.config_space_read_32 = &config_space_read_32,
 	.config_space_write_8 = &config_space_write_8,
 	.config_space_write_16 = &config_space_write_16,
-	.config_space_write_32 = &config_space_write_32
+	.config_space_write_32 = &config_space_write_32,
+	.msi_enable = &pciintel_msi_enable,
+	.msi_disable = &pciintel_msi_disable
 };
 
 static ddf_dev_ops_t pci_fun_ops = {
@@ -889,6 +917,7 @@ static errno_t pci_fun_offline(ddf_fun_t *fun)
 static void pciintel_init(void)
 {
 	ddf_log_init(NAME);
+	pci_msi_init();
 }
 
 pci_fun_t *pci_fun_new(pci_bus_t *bus)
@@ -74,6 +74,18 @@ typedef struct pci_fun_data {
 	hw_resource_list_t hw_resources;
 	hw_resource_t resources[PCI_MAX_HW_RES];
 	pio_window_t pio_window;
+
+	/** Number of enabled message signalled interrupt vectors */
+	unsigned int msi_count;
+	/** IRQ number of the first vector */
+	int msi_irq;
+	/** Offset of the MSI or MSI-X capability */
+	uint8_t msi_cap;
+	/** MSI-X is used rather than MSI */
+	bool msix;
+	/** Mapped MSI-X table */
+	ioport32_t *msix_table;
+	size_t msix_table_size;
 } pci_fun_t;
 
 extern pci_bus_t *pci_bus(ddf_dev_t *);
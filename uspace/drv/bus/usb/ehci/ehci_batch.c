@@ -33,6 +33,7 @@
  * @brief EHCI driver USB transaction structure
  */
 
+#include <align.h>
 #include <assert.h>
 #include <errno.h>
 #include <macros.h>
@@ -56,6 +57,15 @@
 
 static void (*const batch_setup[])(ehci_transfer_batch_t *);
 
+/** Get TD of a batch, which may have been moved to the queue by commit. */
+static inline td_t *batch_td(ehci_transfer_batch_t *ehci_batch, size_t i)
+{
+	assert(i < ehci_batch->td_count);
+	if (i == 0 && ehci_batch->first_td)
+		return ehci_batch->first_td;
+	return &ehci_batch->tds[i];
+}
+
 /** Safely destructs ehci_transfer_batch_t structure
  *
  * @param[in] ehci_batch Instance to destroy.
@@ -122,12 +132,24 @@ int ehci_transfer_batch_prepare(ehci_transfer_batch_t *ehci_batch)
 
 	const size_t tds_size = ehci_batch->td_count * sizeof(td_t);
 
-	/* Mix setup stage and TDs together, we have enough space */
-	if (dma_buffer_alloc(&ehci_batch->ehci_dma_buffer, tds_size + setup_size)) {
-		usb_log_error("Batch %p: Failed to allocate device buffer",
-		    ehci_batch);
-		return ENOMEM;
+	/* Memory of a previous transfer is reused if large enough */
+	if (ehci_batch->td_count > ehci_batch->td_capacity) {
+		dma_buffer_free(&ehci_batch->ehci_dma_buffer);
+		ehci_batch->td_capacity = 0;
+
+		/* Mix setup stage and TDs together, we have enough space */
+		const size_t size = ALIGN_UP(tds_size + USB_SETUP_PACKET_SIZE,
+		    PAGE_SIZE);
+		if (dma_buffer_alloc(&ehci_batch->ehci_dma_buffer, size)) {
+			usb_log_error("Batch %p: Failed to allocate device "
+			    "buffer", ehci_batch);
+			return ENOMEM;
+		}
+
+		ehci_batch->td_capacity =
+		    (size - USB_SETUP_PACKET_SIZE) / sizeof(td_t);
 	}
+	ehci_batch->first_td = NULL;
 
 	/* Clean TDs */
 	ehci_batch->tds = ehci_batch->ehci_dma_buffer.virt;
@@ -138,7 +160,7 @@ int ehci_transfer_batch_prepare(ehci_transfer_batch_t *ehci_batch)
 	memcpy(ehci_batch->setup_buffer, ehci_batch->base.setup.buffer, setup_size);
 
 	/* Generic data already prepared*/
-	ehci_batch->data_buffer = ehci_batch->base.dma_buffer.virt;
+	ehci_batch->data_buffer = usb_transfer_batch_data(&ehci_batch->base);
 
 	if (!batch_setup[ehci_batch->base.ep->transfer_type])
 		return ENOTSUP;
@@ -157,13 +179,14 @@ int ehci_transfer_batch_prepare(ehci_transfer_batch_t *ehci_batch)
  * @param[in] ehci_batch Batch structure to use.
  * @return False, if there is an active TD, true otherwise.
  *
- * Walk all TDs (usually there is just one). Stop with false if there is an
- * active TD. Stop with true if an error is found. Return true if the walk
- * completes with the last TD.
+ * The batch is done when its last TD is no longer active, or when the queue
+ * halted on an error. Walk all TDs (usually there is just one) and stop with
+ * true if an error is found.
  */
 bool ehci_transfer_batch_check_completed(ehci_transfer_batch_t *ehci_batch)
 {
 	assert(ehci_batch);
+	ehci_endpoint_t *ehci_ep = ehci_endpoint_get(ehci_batch->base.ep);
 
 	usb_log_debug("Batch %p: checking %zu td(s) for completion.",
 	    ehci_batch, ehci_batch->td_count);
@@ -174,8 +197,8 @@ bool ehci_transfer_batch_check_completed(ehci_transfer_batch_t *ehci_batch)
 	    ehci_batch->qh->status, ehci_batch->qh->current,
 	    ehci_batch->qh->next, ehci_batch->qh->alternate);
 
-	if (!qh_halted(ehci_batch->qh) && (qh_transfer_pending(ehci_batch->qh) ||
-	    qh_transfer_active(ehci_batch->qh)))
+	if (!qh_halted(ehci_batch->qh) &&
+	    td_active(batch_td(ehci_batch, ehci_batch->td_count - 1)))
 		return false;
 
 	/*
@@ -188,12 +211,11 @@ bool ehci_transfer_batch_check_completed(ehci_transfer_batch_t *ehci_batch)
 
 	/* Check all TDs */
 	for (size_t i = 0; i < ehci_batch->td_count; ++i) {
+		const td_t *td = batch_td(ehci_batch, i);
 		usb_log_debug("Batch %p: TD %zu: %08x:%08x:%08x.",
-		    ehci_batch, i,
-		    ehci_batch->tds[i].status, ehci_batch->tds[i].next,
-		    ehci_batch->tds[i].alternate);
+		    ehci_batch, i, td->status, td->next, td->alternate);
 
-		ehci_batch->base.error = td_error(&ehci_batch->tds[i]);
+		ehci_batch->base.error = td_error(td);
 		if (ehci_batch->base.error == EOK) {
 			/*
 			 * If the TD got all its data through, it will report
@@ -209,12 +231,21 @@ bool ehci_transfer_batch_check_completed(ehci_transfer_batch_t *ehci_batch)
 			 * we leave the very last(unused) TD behind.
 			 */
 			ehci_batch->base.transferred_size -=
-			    td_remain_size(&ehci_batch->tds[i]);
+			    td_remain_size(td);
 		} else {
 			usb_log_debug("Batch %p found error TD(%zu):%08x: %s.",
-			    ehci_batch, i,
-			    ehci_batch->tds[i].status,
+			    ehci_batch, i, td->status,
 			    str_error_name(ehci_batch->base.error));
+			/*
+			 * Restart the queue at its end, past the TDs of this
+			 * transfer and of those queued behind it.
+			 */
+			EHCI_MEM32_WR(ehci_batch->qh->next, LINK_POINTER_TD(
+			    dma_buffer_phys(&ehci_ep->dma_buffer,
+			    ehci_ep->tds[ehci_ep->tail])));
+			EHCI_MEM32_WR(ehci_batch->qh->alternate,
+			    LINK_POINTER_TERM);
+			write_barrier();
 			/* Clear possible ED HALT */
 			qh_clear_halt(ehci_batch->qh);
 			break;
@@ -223,9 +254,6 @@ bool ehci_transfer_batch_check_completed(ehci_transfer_batch_t *ehci_batch)
 
 	assert(ehci_batch->base.transferred_size <= ehci_batch->base.size);
 
-	/* Clear TD pointers */
-	ehci_batch->qh->next = LINK_POINTER_TERM;
-	ehci_batch->qh->current = LINK_POINTER_TERM;
 	usb_log_debug("Batch %p complete: %s", ehci_batch,
 	    str_error(ehci_batch->base.error));
 
@@ -236,11 +264,37 @@ bool ehci_transfer_batch_check_completed(ehci_transfer_batch_t *ehci_batch)
  *
  * @param[in] ehci_batch Batch structure to use
  */
-void ehci_transfer_batch_commit(const ehci_transfer_batch_t *ehci_batch)
+void ehci_transfer_batch_commit(ehci_transfer_batch_t *ehci_batch)
 {
 	assert(ehci_batch);
-	qh_set_next_td(ehci_batch->qh,
-	    dma_buffer_phys(&ehci_batch->ehci_dma_buffer, &ehci_batch->tds[0]));
+	ehci_endpoint_t *ehci_ep = ehci_endpoint_get(ehci_batch->base.ep);
+
+	/*
+	 * Use the next EP TD to terminate the queue. It is not in use, as
+	 * there are more of them than transfers queued at once.
+	 */
+	td_t *const head = ehci_ep->tds[ehci_ep->tail];
+	ehci_ep->tail = (ehci_ep->tail + 1) %
+	    (ehci_ep->base.max_active_batches + 1);
+	td_t *const tail = ehci_ep->tds[ehci_ep->tail];
+	td_init_inactive(tail);
+
+	td_t *last = &ehci_batch->tds[ehci_batch->td_count - 1];
+	EHCI_MEM32_WR(last->next,
+	    LINK_POINTER_TD(dma_buffer_phys(&ehci_ep->dma_buffer, tail)));
+
+	/*
+	 * Copy the first TD over the inactive one the queue ends with.
+	 * The HC may look at it anytime, so activate it only once complete.
+	 */
+	const uint32_t status = EHCI_MEM32_RD(ehci_batch->tds[0].status);
+	EHCI_MEM32_CLR(ehci_batch->tds[0].status, TD_STATUS_ACTIVE_FLAG);
+	memcpy(head, &ehci_batch->tds[0], sizeof(td_t));
+	write_barrier();
+	EHCI_MEM32_WR(head->status, status);
+	write_barrier();
+
+	ehci_batch->first_td = head;
 }
 
 /** Prepare generic control transfer
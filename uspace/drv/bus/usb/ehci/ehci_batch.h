@@ -49,12 +49,16 @@ typedef struct ehci_transfer_batch {
 	usb_transfer_batch_t base;
 	/** Number of TDs used by the transfer */
 	size_t td_count;
+	/** Number of TDs there is room for, kept when the batch is reused */
+	size_t td_capacity;
 	/** Endpoint descriptor of the target endpoint. */
 	qh_t *qh;
 	/** Backend for TDs and setup data. */
 	dma_buffer_t ehci_dma_buffer;
 	/** List of TDs needed for the transfer - backed by dma_buffer */
 	td_t *tds;
+	/** Endpoint TD the first TD was copied to when scheduling */
+	td_t *first_td;
 	/** Data buffers - backed by dma_buffer */
 	void *setup_buffer;
 	void *data_buffer;
@@ -64,7 +68,7 @@ typedef struct ehci_transfer_batch {
 
 ehci_transfer_batch_t *ehci_transfer_batch_create(endpoint_t *ep);
 int ehci_transfer_batch_prepare(ehci_transfer_batch_t *batch);
-void ehci_transfer_batch_commit(const ehci_transfer_batch_t *batch);
+void ehci_transfer_batch_commit(ehci_transfer_batch_t *batch);
 bool ehci_transfer_batch_check_completed(ehci_transfer_batch_t *batch);
 void ehci_transfer_batch_destroy(ehci_transfer_batch_t *batch);
 
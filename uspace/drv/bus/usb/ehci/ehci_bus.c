@@ -83,11 +83,23 @@ static endpoint_t *ehci_endpoint_create(device_t *dev,
 
 	endpoint_init(&ehci_ep->base, dev, desc);
 
-	if (dma_buffer_alloc(&ehci_ep->dma_buffer, sizeof(qh_t)))
+	/* Further transfers can be queued behind the one in progress */
+	if (ehci_ep->base.transfer_type == USB_TRANSFER_BULK ||
+	    ehci_ep->base.transfer_type == USB_TRANSFER_INTERRUPT)
+		ehci_ep->base.max_active_batches = EHCI_EP_MAX_ACTIVE_BATCHES;
+
+	const size_t td_count = ehci_ep->base.max_active_batches + 1;
+	if (dma_buffer_alloc(&ehci_ep->dma_buffer,
+	    sizeof(qh_t) + td_count * sizeof(td_t)))
 		return NULL;
 
 	ehci_ep->qh = ehci_ep->dma_buffer.virt;
 
+	ehci_ep->tds[0] = (td_t *) (ehci_ep->qh + 1);
+	for (size_t i = 1; i < td_count; ++i)
+		ehci_ep->tds[i] = ehci_ep->tds[i - 1] + 1;
+	ehci_ep->tail = 0;
+
 	link_initialize(&ehci_ep->eplist_link);
 	link_initialize(&ehci_ep->pending_link);
 	return &ehci_ep->base;
@@ -118,6 +130,9 @@ static int ehci_register_ep(endpoint_t *ep)
 		return err;
 
 	qh_init(ehci_ep->qh, ep);
+	td_init_inactive(ehci_ep->tds[ehci_ep->tail]);
+	qh_set_next_td(ehci_ep->qh, dma_buffer_phys(&ehci_ep->dma_buffer,
+	    ehci_ep->tds[ehci_ep->tail]));
 	hc_enqueue_endpoint(bus->hc, ep);
 	endpoint_set_online(ep, &bus->hc->guard);
 	return EOK;
@@ -134,20 +149,30 @@ static void ehci_unregister_ep(endpoint_t *ep)
 	usb2_bus_endpoint_unregister(&bus->helper, ep);
 	hc_dequeue_endpoint(hc, ep);
 	/*
-	 * Now we can be sure the active transfer will not be completed,
-	 * as it's out of the schedule, and HC acknowledged it.
+	 * Now we can be sure the active transfers will not be completed,
+	 * as they're out of the schedule, and HC acknowledged it.
 	 */
 
 	ehci_endpoint_t *ehci_ep = ehci_endpoint_get(ep);
 
+	list_t aborted;
+	list_initialize(&aborted);
+
 	fibril_mutex_lock(&hc->guard);
 	endpoint_set_offline_locked(ep);
 	list_remove(&ehci_ep->pending_link);
-	usb_transfer_batch_t *const batch = ep->active_batch;
-	endpoint_deactivate_locked(ep);
+	usb_transfer_batch_t *batch;
+	while ((batch = endpoint_first_active_locked(ep))) {
+		endpoint_deactivate_locked(ep, batch);
+		list_append(&batch->active_link, &aborted);
+	}
 	fibril_mutex_unlock(&hc->guard);
 
-	if (batch) {
+	while (!list_empty(&aborted)) {
+		batch = list_get_instance(list_first(&aborted),
+		    usb_transfer_batch_t, active_link);
+		list_remove(&batch->active_link);
+
 		batch->error = EINTR;
 		batch->transferred_size = 0;
 		usb_transfer_batch_finish(batch);
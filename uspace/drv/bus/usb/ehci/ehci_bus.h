@@ -42,15 +42,30 @@
 #include <usb/dma_buffer.h>
 
 #include "hw_struct/queue_head.h"
+#include "hw_struct/transfer_descriptor.h"
 
-/** Connector structure linking ED to to prepared TD. */
+/** Number of bulk or interrupt transfers queued on a QH at once */
+#define EHCI_EP_MAX_ACTIVE_BATCHES 8
+
+/**
+ * Connector structure linking ED to to prepared TD.
+ *
+ * The queue is terminated by an inactive TD owned by the endpoint. New
+ * transfer copies its first TD over it and ends with the next spare one,
+ * so that transfers can be appended while the HC works on the queue.
+ */
 typedef struct ehci_endpoint {
 	/* Inheritance */
 	endpoint_t base;
 
 	/** EHCI endpoint descriptor, backed by dma_buffer */
 	qh_t *qh;
+	/** TDs to be used at the beginning and end of transfers */
+	td_t *tds [EHCI_EP_MAX_ACTIVE_BATCHES + 1];
+	/** Index of the inactive TD currently terminating the queue */
+	size_t tail;
 
+	/** Buffer to back QH + TDs */
 	dma_buffer_t dma_buffer;
 
 	/** Link in endpoint_list */
@@ -149,7 +149,7 @@ errno_t ehci_rh_schedule(ehci_rh_t *instance, usb_transfer_batch_t *batch)
 	assert(batch);
 	batch->error = virthub_base_request(&instance->base, batch->target,
 	    batch->dir, (void *) batch->setup.buffer,
-	    batch->dma_buffer.virt, batch->size,
+	    usb_transfer_batch_data(batch), batch->size,
 	    &batch->transferred_size);
 	if (batch->error == ENAK) {
 		usb_log_debug("RH(%p): BATCH(%p) adding as unfinished",
@@ -196,8 +196,9 @@ errno_t ehci_rh_interrupt(ehci_rh_t *instance)
 		return EOK;
 	}
 
-	usb_transfer_batch_t *const batch = ep->active_batch;
-	endpoint_deactivate_locked(ep);
+	usb_transfer_batch_t *const batch = endpoint_first_active_locked(ep);
+	if (batch)
+		endpoint_deactivate_locked(ep, batch);
 	instance->status_change_endpoint = NULL;
 	fibril_mutex_unlock(instance->guard);
 
@@ -208,7 +209,7 @@ errno_t ehci_rh_interrupt(ehci_rh_t *instance)
 		    instance, batch);
 		batch->error = virthub_base_request(&instance->base, batch->target,
 		    batch->dir, (void *) batch->setup.buffer,
-		    batch->dma_buffer.virt, batch->size,
+		    usb_transfer_batch_data(batch), batch->size,
 		    &batch->transferred_size);
 		usb_transfer_batch_finish(batch);
 	}
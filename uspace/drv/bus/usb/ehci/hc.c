@@ -323,12 +323,30 @@ errno_t ehci_hc_schedule(usb_transfer_batch_t *batch)
 
 	/* Enqueue endpoint to the checked list */
 	usb_log_debug2("HC(%p): Appending BATCH(%p)", hc, batch);
-	list_append(&ehci_ep->pending_link, &hc->pending_endpoints);
+	if (!link_in_use(&ehci_ep->pending_link))
+		list_append(&ehci_ep->pending_link, &hc->pending_endpoints);
 
 	fibril_mutex_unlock(&hc->guard);
 	return EOK;
 }
 
+/** Finish transfers queued behind a failed one.
+ *
+ * The QH was restarted past them, so they would never complete.
+ *
+ * @param[in] ep Endpoint with the failed transfer.
+ */
+static void hc_abort_queued(endpoint_t *ep)
+{
+	usb_transfer_batch_t *batch;
+	while ((batch = endpoint_first_active_locked(ep))) {
+		endpoint_deactivate_locked(ep, batch);
+		batch->error = EINTR;
+		batch->transferred_size = 0;
+		usb_transfer_batch_finish(batch);
+	}
+}
+
 /** Interrupt handling routine
  *
  * @param[in] hcd HCD driver structure.
@@ -363,16 +381,26 @@ void ehci_hc_interrupt(bus_t *bus_base, uint32_t status)
 			ehci_endpoint_t *ep =
 			    list_get_instance(current, ehci_endpoint_t, pending_link);
 
-			ehci_transfer_batch_t *batch =
-			    ehci_transfer_batch_get(ep->base.active_batch);
-			assert(batch);
+			/* Transfers on a QH complete in the order queued */
+			endpoint_t *const base = &ep->base;
+			usb_transfer_batch_t *first;
+			while ((first = endpoint_first_active_locked(base))) {
+				ehci_transfer_batch_t *batch =
+				    ehci_transfer_batch_get(first);
+				if (!ehci_transfer_batch_check_completed(batch))
+					break;
+
+				const bool failed = first->error != EOK;
+				endpoint_deactivate_locked(base, first);
+				hc_reset_toggles(first, &ehci_ep_toggle_reset);
+				usb_transfer_batch_finish(first);
+
+				if (failed)
+					hc_abort_queued(base);
+			}
 
-			if (ehci_transfer_batch_check_completed(batch)) {
-				endpoint_deactivate_locked(&ep->base);
+			if (!endpoint_first_active_locked(base))
 				list_remove(current);
-				hc_reset_toggles(&batch->base, &ehci_ep_toggle_reset);
-				usb_transfer_batch_finish(&batch->base);
-			}
 		}
 		fibril_mutex_unlock(&hc->guard);
 
@@ -117,6 +117,22 @@ void td_init(td_t *instance, uintptr_t next_phys, uintptr_t buffer,
 	EHCI_MEM32_SET(instance->status, TD_STATUS_ACTIVE_FLAG);
 	write_barrier();
 }
+
+/**
+ * Initialize inactive EHCI TD.
+ *
+ * The HC does not advance a queue to an inactive TD, so it can terminate
+ * the queue and be filled in later.
+ * @param instance TD structure to initialize.
+ */
+void td_init_inactive(td_t *instance)
+{
+	assert(instance);
+	memset(instance, 0, sizeof(td_t));
+	EHCI_MEM32_WR(instance->next, LINK_POINTER_TERM);
+	EHCI_MEM32_WR(instance->alternate, LINK_POINTER_TERM);
+	write_barrier();
+}
 /**
  * @}
  */
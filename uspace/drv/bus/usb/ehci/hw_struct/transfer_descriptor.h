@@ -92,7 +92,7 @@ static_assert(sizeof(td_t) % 32 == 0, "");
 static inline bool td_active(const td_t *td)
 {
 	assert(td);
-	return (EHCI_MEM32_RD(td->status) & TD_STATUS_HALTED_FLAG) != 0;
+	return (EHCI_MEM32_RD(td->status) & TD_STATUS_ACTIVE_FLAG) != 0;
 }
 
 static inline size_t td_remain_size(const td_t *td)
@@ -106,6 +106,7 @@ errno_t td_error(const td_t *td);
 
 void td_init(td_t *td, uintptr_t next_phys, uintptr_t buf, usb_direction_t dir,
     size_t buf_size, int toggle, bool ioc);
+void td_init_inactive(td_t *td);
 
 #endif
 /**
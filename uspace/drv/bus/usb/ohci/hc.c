@@ -314,7 +314,8 @@ errno_t ohci_hc_schedule(usb_transfer_batch_t *batch)
 	}
 
 	ohci_transfer_batch_commit(ohci_batch);
-	list_append(&ohci_ep->pending_link, &hc->pending_endpoints);
+	if (!link_in_use(&ohci_ep->pending_link))
+		list_append(&ohci_ep->pending_link, &hc->pending_endpoints);
 	fibril_mutex_unlock(&hc->guard);
 
 	/* Control and bulk schedules need a kick to start working */
@@ -332,6 +333,23 @@ errno_t ohci_hc_schedule(usb_transfer_batch_t *batch)
 	return EOK;
 }
 
+/** Finish transfers queued behind a failed one.
+ *
+ * The ED was restarted past them, so they would never complete.
+ *
+ * @param[in] ep Endpoint with the failed transfer.
+ */
+static void hc_abort_queued(endpoint_t *ep)
+{
+	usb_transfer_batch_t *batch;
+	while ((batch = endpoint_first_active_locked(ep))) {
+		endpoint_deactivate_locked(ep, batch);
+		batch->error = EINTR;
+		batch->transferred_size = 0;
+		usb_transfer_batch_finish(batch);
+	}
+}
+
 /** Interrupt handling routine
  *
  * @param[in] hcd HCD driver structure.
@@ -365,16 +383,26 @@ void ohci_hc_interrupt(bus_t *bus_base, uint32_t status)
 			ohci_endpoint_t *ep =
 			    list_get_instance(current, ohci_endpoint_t, pending_link);
 
-			ohci_transfer_batch_t *batch =
-			    ohci_transfer_batch_get(ep->base.active_batch);
-			assert(batch);
+			/* Transfers on an ED complete in the order queued */
+			endpoint_t *const base = &ep->base;
+			usb_transfer_batch_t *first;
+			while ((first = endpoint_first_active_locked(base))) {
+				ohci_transfer_batch_t *batch =
+				    ohci_transfer_batch_get(first);
+				if (!ohci_transfer_batch_check_completed(batch))
+					break;
+
+				const bool failed = first->error != EOK;
+				endpoint_deactivate_locked(base, first);
+				hc_reset_toggles(first, &ohci_ep_toggle_reset);
+				usb_transfer_batch_finish(first);
+
+				if (failed)
+					hc_abort_queued(base);
+			}
 
-			if (ohci_transfer_batch_check_completed(batch)) {
-				endpoint_deactivate_locked(&ep->base);
+			if (!endpoint_first_active_locked(base))
 				list_remove(current);
-				hc_reset_toggles(&batch->base, &ohci_ep_toggle_reset);
-				usb_transfer_batch_finish(&batch->base);
-			}
 		}
 		fibril_mutex_unlock(&hc->guard);
 	}
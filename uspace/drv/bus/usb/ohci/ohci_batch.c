@@ -34,6 +34,7 @@
  * @brief OHCI driver USB transaction structure
  */
 
+#include <align.h>
 #include <assert.h>
 #include <errno.h>
 #include <macros.h>
@@ -57,6 +58,7 @@ void ohci_transfer_batch_destroy(ohci_transfer_batch_t *ohci_batch)
 {
 	assert(ohci_batch);
 	dma_buffer_free(&ohci_batch->ohci_dma_buffer);
+	free(ohci_batch->tds);
 	free(ohci_batch);
 }
 
@@ -103,19 +105,32 @@ int ohci_transfer_batch_prepare(ohci_transfer_batch_t *ohci_batch)
 		ohci_batch->td_count += 2;
 	}
 
-	/* Alloc one more to NULL terminate */
-	ohci_batch->tds = calloc(ohci_batch->td_count + 1, sizeof(td_t *));
-	if (!ohci_batch->tds)
-		return ENOMEM;
-
-	const size_t td_size = ohci_batch->td_count * sizeof(td_t);
 	const size_t setup_size = (usb_batch->ep->transfer_type == USB_TRANSFER_CONTROL) ?
 	    USB_SETUP_PACKET_SIZE :
 	    0;
 
-	if (dma_buffer_alloc(&ohci_batch->ohci_dma_buffer, td_size + setup_size)) {
-		usb_log_error("Failed to allocate OHCI DMA buffer.");
-		return ENOMEM;
+	/* Memory of a previous transfer is reused if large enough */
+	if (ohci_batch->td_count > ohci_batch->td_capacity) {
+		dma_buffer_free(&ohci_batch->ohci_dma_buffer);
+		free(ohci_batch->tds);
+		ohci_batch->td_capacity = 0;
+
+		const size_t size = ALIGN_UP(ohci_batch->td_count *
+		    sizeof(td_t) + USB_SETUP_PACKET_SIZE, PAGE_SIZE);
+		const size_t capacity =
+		    (size - USB_SETUP_PACKET_SIZE) / sizeof(td_t);
+
+		/* Alloc one more to NULL terminate */
+		ohci_batch->tds = calloc(capacity + 1, sizeof(td_t *));
+		if (!ohci_batch->tds)
+			return ENOMEM;
+
+		if (dma_buffer_alloc(&ohci_batch->ohci_dma_buffer, size)) {
+			usb_log_error("Failed to allocate OHCI DMA buffer.");
+			return ENOMEM;
+		}
+
+		ohci_batch->td_capacity = capacity;
 	}
 
 	td_t *tds = ohci_batch->ohci_dma_buffer.virt;
@@ -129,7 +144,7 @@ int ohci_transfer_batch_prepare(ohci_transfer_batch_t *ohci_batch)
 	ohci_batch->setup_buffer = (void *) (&tds[ohci_batch->td_count]);
 	memcpy(ohci_batch->setup_buffer, usb_batch->setup.buffer, setup_size);
 
-	ohci_batch->data_buffer = usb_batch->dma_buffer.virt;
+	ohci_batch->data_buffer = usb_transfer_batch_data(usb_batch);
 
 	batch_setup[usb_batch->ep->transfer_type](ohci_batch);
 
@@ -159,8 +174,17 @@ bool ohci_transfer_batch_check_completed(ohci_transfer_batch_t *ohci_batch)
 	    ohci_ep->ed->status, ohci_ep->ed->td_head,
 	    ohci_ep->ed->td_tail, ohci_ep->ed->next);
 
-	if (!ed_inactive(ohci_ep->ed) && ed_transfer_pending(ohci_ep->ed))
-		return false;
+	/*
+	 * Further transfers may be queued behind this one, so it is done once
+	 * the HC moved past its TDs.
+	 */
+	if (!ed_inactive(ohci_ep->ed)) {
+		const uint32_t head = ed_head_td(ohci_ep->ed);
+		for (size_t i = 0; i < ohci_batch->td_count; ++i) {
+			if (head == addr_to_phys(ohci_batch->tds[i]))
+				return false;
+		}
+	}
 
 	/*
 	 * Now we may be sure that either the ED is inactive because of errors
@@ -204,12 +228,13 @@ bool ohci_transfer_batch_check_completed(ohci_transfer_batch_t *ohci_batch)
 			/*
 			 * We don't care where the processing stopped, we just
 			 * need to make sure it's not using any of the TDs owned
-			 * by the transfer.
+			 * by the transfer, nor by those queued behind it.
 			 *
 			 * As the chain is terminated by a TD in ownership of
 			 * the EP, set it.
 			 */
-			ed_set_head_td(ohci_ep->ed, ohci_ep->tds[0]);
+			ed_set_head_td(ohci_ep->ed,
+			    ohci_ep->tds[ohci_ep->tail]);
 
 			/* Clear the halted condition for the next transfer */
 			ed_clear_halt(ohci_ep->ed);
@@ -219,8 +244,8 @@ bool ohci_transfer_batch_check_completed(ohci_transfer_batch_t *ohci_batch)
 	assert(usb_batch->transferred_size <= usb_batch->size);
 
 	/* Make sure that we are leaving the right TD behind */
-	assert(addr_to_phys(ohci_ep->tds[0]) == ed_tail_td(ohci_ep->ed));
-	assert(ed_tail_td(ohci_ep->ed) == ed_head_td(ohci_ep->ed));
+	assert(addr_to_phys(ohci_ep->tds[ohci_ep->tail]) ==
+	    ed_tail_td(ohci_ep->ed));
 
 	return true;
 }
@@ -229,7 +254,7 @@ bool ohci_transfer_batch_check_completed(ohci_transfer_batch_t *ohci_batch)
  *
  * @param[in] ohci_batch Batch structure to use
  */
-void ohci_transfer_batch_commit(const ohci_transfer_batch_t *ohci_batch)
+void ohci_transfer_batch_commit(ohci_transfer_batch_t *ohci_batch)
 {
 	assert(ohci_batch);
 
@@ -243,18 +268,22 @@ void ohci_transfer_batch_commit(const ohci_transfer_batch_t *ohci_batch)
 	 * According to spec, we need to copy the first TD to the currently
 	 * enqueued one.
 	 */
-	memcpy(ohci_ep->tds[0], ohci_batch->tds[0], sizeof(td_t));
-	ohci_batch->tds[0] = ohci_ep->tds[0];
+	td_t *const head = ohci_ep->tds[ohci_ep->tail];
+	memcpy(head, ohci_batch->tds[0], sizeof(td_t));
+	ohci_batch->tds[0] = head;
 
-	td_t *last = ohci_batch->tds[ohci_batch->td_count - 1];
-	td_set_next(last, ohci_ep->tds[1]);
+	/*
+	 * Use the next EP TD as the new placeholder. It is not in use, as
+	 * there are more of them than transfers queued at once.
+	 */
+	ohci_ep->tail = (ohci_ep->tail + 1) %
+	    (ohci_ep->base.max_active_batches + 1);
+	td_t *const tail = ohci_ep->tds[ohci_ep->tail];
 
-	ed_set_tail_td(ohci_ep->ed, ohci_ep->tds[1]);
+	td_t *last = ohci_batch->tds[ohci_batch->td_count - 1];
+	td_set_next(last, tail);
 
-	/* Swap the EP TDs for the next transfer */
-	td_t *tmp = ohci_ep->tds[0];
-	ohci_ep->tds[0] = ohci_ep->tds[1];
-	ohci_ep->tds[1] = tmp;
+	ed_set_tail_td(ohci_ep->ed, tail);
 }
 
 /** Prepare generic control transfer
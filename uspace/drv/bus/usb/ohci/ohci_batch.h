@@ -50,6 +50,8 @@ typedef struct ohci_transfer_batch {
 
 	/** Number of TDs used by the transfer */
 	size_t td_count;
+	/** Number of TDs there is room for, kept when the batch is reused */
+	size_t td_capacity;
 
 	/**
 	 * List of TDs needed for the transfer - together with setup data
@@ -66,7 +68,7 @@ typedef struct ohci_transfer_batch {
 
 ohci_transfer_batch_t *ohci_transfer_batch_create(endpoint_t *batch);
 int ohci_transfer_batch_prepare(ohci_transfer_batch_t *ohci_batch);
-void ohci_transfer_batch_commit(const ohci_transfer_batch_t *batch);
+void ohci_transfer_batch_commit(ohci_transfer_batch_t *batch);
 bool ohci_transfer_batch_check_completed(ohci_transfer_batch_t *batch);
 void ohci_transfer_batch_destroy(ohci_transfer_batch_t *ohci_batch);
 
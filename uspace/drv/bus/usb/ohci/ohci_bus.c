@@ -82,8 +82,14 @@ static endpoint_t *ohci_endpoint_create(device_t *dev,
 
 	endpoint_init(&ohci_ep->base, dev, desc);
 
+	/* Further transfers can be queued behind the one in progress */
+	if (ohci_ep->base.transfer_type == USB_TRANSFER_BULK ||
+	    ohci_ep->base.transfer_type == USB_TRANSFER_INTERRUPT)
+		ohci_ep->base.max_active_batches = OHCI_EP_MAX_ACTIVE_BATCHES;
+
+	const size_t td_count = ohci_ep->base.max_active_batches + 1;
 	const errno_t err = dma_buffer_alloc(&ohci_ep->dma_buffer,
-	    sizeof(ed_t) + 2 * sizeof(td_t));
+	    sizeof(ed_t) + td_count * sizeof(td_t));
 	if (err) {
 		free(ohci_ep);
 		return NULL;
@@ -92,7 +98,9 @@ static endpoint_t *ohci_endpoint_create(device_t *dev,
 	ohci_ep->ed = ohci_ep->dma_buffer.virt;
 
 	ohci_ep->tds[0] = (td_t *) ohci_ep->ed + 1;
-	ohci_ep->tds[1] = ohci_ep->tds[0] + 1;
+	for (size_t i = 1; i < td_count; ++i)
+		ohci_ep->tds[i] = ohci_ep->tds[i - 1] + 1;
+	ohci_ep->tail = 0;
 
 	link_initialize(&ohci_ep->eplist_link);
 	link_initialize(&ohci_ep->pending_link);
@@ -123,7 +131,7 @@ static int ohci_register_ep(endpoint_t *ep)
 	if (err)
 		return err;
 
-	ed_init(ohci_ep->ed, ep, ohci_ep->tds[0]);
+	ed_init(ohci_ep->ed, ep, ohci_ep->tds[ohci_ep->tail]);
 	hc_enqueue_endpoint(bus->hc, ep);
 	endpoint_set_online(ep, &bus->hc->guard);
 
@@ -140,20 +148,30 @@ static void ohci_unregister_ep(endpoint_t *ep)
 	hc_dequeue_endpoint(bus->hc, ep);
 
 	/*
-	 * Now we can be sure the active transfer will not be completed,
-	 * as it's out of the schedule, and HC acknowledged it.
+	 * Now we can be sure the active transfers will not be completed,
+	 * as they're out of the schedule, and HC acknowledged it.
 	 */
 
 	ohci_endpoint_t *ohci_ep = ohci_endpoint_get(ep);
 
+	list_t aborted;
+	list_initialize(&aborted);
+
 	fibril_mutex_lock(&hc->guard);
 	endpoint_set_offline_locked(ep);
 	list_remove(&ohci_ep->pending_link);
-	usb_transfer_batch_t *const batch = ep->active_batch;
-	endpoint_deactivate_locked(ep);
+	usb_transfer_batch_t *batch;
+	while ((batch = endpoint_first_active_locked(ep))) {
+		endpoint_deactivate_locked(ep, batch);
+		list_append(&batch->active_link, &aborted);
+	}
 	fibril_mutex_unlock(&hc->guard);
 
-	if (batch) {
+	while (!list_empty(&aborted)) {
+		batch = list_get_instance(list_first(&aborted),
+		    usb_transfer_batch_t, active_link);
+		list_remove(&batch->active_link);
+
 		batch->error = EINTR;
 		batch->transferred_size = 0;
 		usb_transfer_batch_finish(batch);
@@ -43,23 +43,29 @@
 #include "hw_struct/endpoint_descriptor.h"
 #include "hw_struct/transfer_descriptor.h"
 
+/** Number of bulk or interrupt transfers queued on an ED at once */
+#define OHCI_EP_MAX_ACTIVE_BATCHES 8
+
 /**
  * Connector structure linking ED to to prepared TD.
  *
  * OHCI requires new transfers to be appended at the end of a queue. But it has
  * a weird semantics of a leftover TD, which serves as a placeholder. This left
- * TD is overwritten with first TD of a new transfer, and the spare one is used
- * as the next placeholder. Then the two are swapped for the next transaction.
+ * TD is overwritten with first TD of a new transfer, and the next spare one is
+ * used as the next placeholder. The endpoint owns one placeholder more than
+ * the number of transfers which may be queued at once, and uses them in turn.
  */
 typedef struct ohci_endpoint {
 	endpoint_t base;
 
 	/** OHCI endpoint descriptor */
 	ed_t *ed;
-	/** TDs to be used at the beginning and end of transaction */
-	td_t *tds [2];
+	/** TDs to be used at the beginning and end of transactions */
+	td_t *tds [OHCI_EP_MAX_ACTIVE_BATCHES + 1];
+	/** Index of the placeholder TD currently at the tail of the queue */
+	size_t tail;
 
-	/** Buffer to back ED + 2 TD */
+	/** Buffer to back ED + placeholder TDs */
 	dma_buffer_t dma_buffer;
 
 	/** Link in endpoint_list*/
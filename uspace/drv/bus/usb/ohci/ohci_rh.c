@@ -182,7 +182,8 @@ errno_t ohci_rh_schedule(ohci_rh_t *instance, usb_transfer_batch_t *batch)
 	assert(batch);
 	batch->error = virthub_base_request(&instance->base, batch->target,
 	    batch->dir, &batch->setup.packet,
-	    batch->dma_buffer.virt, batch->size, &batch->transferred_size);
+	    usb_transfer_batch_data(batch), batch->size,
+	    &batch->transferred_size);
 	if (batch->error == ENAK) {
 		/* Lock the HC guard */
 		fibril_mutex_lock(instance->guard);
@@ -223,8 +224,9 @@ errno_t ohci_rh_interrupt(ohci_rh_t *instance)
 		return EOK;
 	}
 
-	usb_transfer_batch_t *const batch = ep->active_batch;
-	endpoint_deactivate_locked(ep);
+	usb_transfer_batch_t *const batch = endpoint_first_active_locked(ep);
+	if (batch)
+		endpoint_deactivate_locked(ep, batch);
 	instance->status_change_endpoint = NULL;
 	fibril_mutex_unlock(instance->guard);
 
@@ -233,7 +235,8 @@ errno_t ohci_rh_interrupt(ohci_rh_t *instance)
 	if (batch) {
 		batch->error = virthub_base_request(&instance->base, batch->target,
 		    batch->dir, &batch->setup.packet,
-		    batch->dma_buffer.virt, batch->size, &batch->transferred_size);
+		    usb_transfer_batch_data(batch), batch->size,
+		    &batch->transferred_size);
 		usb_transfer_batch_finish(batch);
 	}
 	return EOK;
@@ -376,7 +376,7 @@ static void endpoint_unregister(endpoint_t *ep)
 	endpoint_set_offline_locked(ep);
 	/* From now on, no other transfer will be scheduled. */
 
-	if (!ep->active_batch) {
+	if (!endpoint_first_active_locked(ep)) {
 		fibril_mutex_unlock(&list->guard);
 		return;
 	}
@@ -384,16 +384,17 @@ static void endpoint_unregister(endpoint_t *ep)
 	/* First, offer the batch a short chance to be finished. */
 	endpoint_wait_timeout_locked(ep, 10000);
 
-	if (!ep->active_batch) {
+	if (!endpoint_first_active_locked(ep)) {
 		fibril_mutex_unlock(&list->guard);
 		return;
 	}
 
+	/* UHCI endpoints process a single batch at a time */
 	uhci_transfer_batch_t *const batch =
-	    uhci_transfer_batch_get(ep->active_batch);
+	    uhci_transfer_batch_get(endpoint_first_active_locked(ep));
 
 	/* Remove the batch from the schedule to stop it from being finished. */
-	endpoint_deactivate_locked(ep);
+	endpoint_deactivate_locked(ep, &batch->base);
 	transfer_list_remove_batch(list, batch);
 
 	fibril_mutex_unlock(&list->guard);
@@ -184,8 +184,8 @@ void transfer_list_check_finished(transfer_list_t *instance)
 		uhci_transfer_batch_t *batch = uhci_transfer_batch_from_link(current);
 
 		if (uhci_transfer_batch_check_completed(batch)) {
-			assert(batch->base.ep->active_batch == &batch->base);
-			endpoint_deactivate_locked(batch->base.ep);
+			endpoint_deactivate_locked(batch->base.ep,
+			    &batch->base);
 			hc_reset_toggles(&batch->base, &uhci_reset_toggle);
 			transfer_list_remove_batch(instance, batch);
 			usb_transfer_batch_finish(&batch->base);
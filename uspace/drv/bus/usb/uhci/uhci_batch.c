@@ -34,6 +34,7 @@
  * @brief UHCI driver USB transfer structure
  */
 
+#include <align.h>
 #include <assert.h>
 #include <errno.h>
 #include <macros.h>
@@ -113,9 +114,20 @@ int uhci_transfer_batch_prepare(uhci_transfer_batch_t *uhci_batch)
 	const size_t total_size = (sizeof(td_t) * uhci_batch->td_count) +
 	    sizeof(qh_t) + setup_size;
 
-	if (dma_buffer_alloc(&uhci_batch->uhci_dma_buffer, total_size)) {
-		usb_log_error("Failed to allocate UHCI buffer.");
-		return ENOMEM;
+	/* Memory of a previous transfer is reused if large enough */
+	if (uhci_batch->td_count > uhci_batch->td_capacity) {
+		dma_buffer_free(&uhci_batch->uhci_dma_buffer);
+		uhci_batch->td_capacity = 0;
+
+		const size_t size = ALIGN_UP(total_size - setup_size +
+		    USB_SETUP_PACKET_SIZE, PAGE_SIZE);
+		if (dma_buffer_alloc(&uhci_batch->uhci_dma_buffer, size)) {
+			usb_log_error("Failed to allocate UHCI buffer.");
+			return ENOMEM;
+		}
+
+		uhci_batch->td_capacity = (size - sizeof(qh_t) -
+		    USB_SETUP_PACKET_SIZE) / sizeof(td_t);
 	}
 	memset(uhci_batch->uhci_dma_buffer.virt, 0, total_size);
 
@@ -61,6 +61,8 @@ typedef struct uhci_transfer_batch {
 	td_t *tds;
 	/** Number of TDs used by the transfer */
 	size_t td_count;
+	/** Number of TDs there is room for, kept when the batch is reused */
+	size_t td_capacity;
 	/* Setup data */
 	char *setup_buffer;
 	/** Backing TDs + setup_buffer */
@@ -94,7 +96,7 @@ static inline void *uhci_transfer_batch_data_buffer(
     const uhci_transfer_batch_t *uhci_batch)
 {
 	assert(uhci_batch);
-	return uhci_batch->base.dma_buffer.virt;
+	return usb_transfer_batch_data(&uhci_batch->base);
 }
 
 /** Linked list conversion wrapper.
@@ -47,6 +47,9 @@
 #include "endpoint.h"
 #include "streams.h"
 
+/** Number of bulk or interrupt TDs queued on a transfer ring at once */
+#define XHCI_EP_MAX_ACTIVE_BATCHES 8
+
 static errno_t alloc_transfer_ds(xhci_endpoint_t *);
 
 /**
@@ -93,6 +96,11 @@ static errno_t xhci_endpoint_init(xhci_endpoint_t *xhci_ep, device_t *dev,
 		}
 	}
 
+	/* Further TDs can be queued on the ring behind the one in progress */
+	if (ep->transfer_type == USB_TRANSFER_BULK ||
+	    ep->transfer_type == USB_TRANSFER_INTERRUPT)
+		ep->max_active_batches = XHCI_EP_MAX_ACTIVE_BATCHES;
+
 	xhci_ep->interval = desc->endpoint.poll_interval;
 
 	/*
@@ -208,7 +216,7 @@ errno_t xhci_endpoint_register(endpoint_t *ep_base)
 }
 
 /**
- * Abort a transfer on an endpoint.
+ * Abort all transfers on an endpoint.
  */
 static void endpoint_abort(endpoint_t *ep)
 {
@@ -222,21 +230,19 @@ static void endpoint_abort(endpoint_t *ep)
 
 	endpoint_set_offline_locked(ep);
 
-	if (!ep->active_batch) {
+	if (!endpoint_first_active_locked(ep)) {
 		fibril_mutex_unlock(&xhci_ep->guard);
 		return;
 	}
 
-	/* First, offer the batch a short chance to be finished. */
+	/* First, offer the batches a short chance to be finished. */
 	endpoint_wait_timeout_locked(ep, 10000);
 
-	if (!ep->active_batch) {
+	if (!endpoint_first_active_locked(ep)) {
 		fibril_mutex_unlock(&xhci_ep->guard);
 		return;
 	}
 
-	usb_transfer_batch_t *const batch = ep->active_batch;
-
 	const errno_t err = hc_stop_endpoint(xhci_ep);
 	if (err) {
 		usb_log_error("Failed to stop endpoint %u of device "
@@ -244,12 +250,27 @@ static void endpoint_abort(endpoint_t *ep)
 		    str_error(err));
 	}
 
+	/* Events for the aborted batches will not find them anymore. */
+	list_t aborted;
+	list_initialize(&aborted);
+
+	usb_transfer_batch_t *batch;
+	while ((batch = endpoint_first_active_locked(ep))) {
+		endpoint_deactivate_locked(ep, batch);
+		list_append(&batch->active_link, &aborted);
+	}
+
 	fibril_mutex_unlock(&xhci_ep->guard);
 
-	batch->error = EINTR;
-	batch->transferred_size = 0;
-	usb_transfer_batch_finish(batch);
-	return;
+	while (!list_empty(&aborted)) {
+		batch = list_get_instance(list_first(&aborted),
+		    usb_transfer_batch_t, active_link);
+		list_remove(&batch->active_link);
+
+		batch->error = EINTR;
+		batch->transferred_size = 0;
+		usb_transfer_batch_finish(batch);
+	}
 }
 
 /**
@@ -46,6 +46,18 @@
 #include "transfers.h"
 #include "trb_ring.h"
 
+/**
+ * Minimum interval between interrupts in 250 ns units (40 us). Events
+ * arriving meanwhile are handled by one run of the event ring.
+ */
+#define XHCI_IMOD_INTERVAL  160
+
+/** How often the dequeue pointer is reported while running the event ring */
+#define XHCI_ERDP_UPDATE_INTERVAL  16
+
+/** Maximum number of events passed to or handled by a worker at once */
+#define XHCI_EVENT_BATCH_SIZE  16
+
 /**
  * Default USB Speed ID mapping: Table 157
  */
@@ -253,6 +265,41 @@ err_pio:
 
 static int event_worker(void *arg);
 
+/**
+ * Tear down the transfer event workers.
+ */
+static void hc_event_workers_fini(xhci_hc_t *hc)
+{
+	for (unsigned i = 0; i < XHCI_EVENT_WORKERS; ++i) {
+		xhci_event_worker_t *worker = &hc->event_workers[i];
+
+		joinable_fibril_destroy(worker->fibril);
+		worker->fibril = NULL;
+		xhci_sw_ring_fini(&worker->sw_ring);
+		worker->sw_ring.begin = NULL;
+	}
+}
+
+/**
+ * Prepare the transfer event workers. They are started with the HC.
+ */
+static errno_t hc_event_workers_init(xhci_hc_t *hc)
+{
+	for (unsigned i = 0; i < XHCI_EVENT_WORKERS; ++i) {
+		xhci_event_worker_t *worker = &hc->event_workers[i];
+
+		worker->hc = hc;
+		worker->fibril = joinable_fibril_create(&event_worker, worker);
+		if (!worker->fibril || xhci_sw_ring_init(&worker->sw_ring,
+		    PAGE_SIZE / sizeof(xhci_trb_t))) {
+			hc_event_workers_fini(hc);
+			return ENOMEM;
+		}
+	}
+
+	return EOK;
+}
+
 /**
  * Initialize structures kept in allocated memory.
  */
@@ -264,8 +311,7 @@ errno_t hc_init_memory(xhci_hc_t *hc, ddf_dev_t *device)
 		return ENOMEM;
 	hc->dcbaa = hc->dcbaa_dma.virt;
 
-	hc->event_worker = joinable_fibril_create(&event_worker, hc);
-	if (!hc->event_worker)
+	if ((err = hc_event_workers_init(hc)))
 		goto err_dcbaa;
 
 	if ((err = xhci_event_ring_init(&hc->event_ring, 1)))
@@ -280,8 +326,6 @@ errno_t hc_init_memory(xhci_hc_t *hc, ddf_dev_t *device)
 	if ((err = xhci_bus_init(&hc->bus, hc)))
 		goto err_cmd;
 
-	xhci_sw_ring_init(&hc->sw_ring, PAGE_SIZE / sizeof(xhci_trb_t));
-
 	return EOK;
 
 err_cmd:
@@ -291,7 +335,7 @@ err_scratch:
 err_event_ring:
 	xhci_event_ring_fini(&hc->event_ring);
 err_worker:
-	joinable_fibril_destroy(hc->event_worker);
+	hc_event_workers_fini(hc);
 err_dcbaa:
 	hc->dcbaa = NULL;
 	dma_buffer_free(&hc->dcbaa_dma);
@@ -493,6 +537,9 @@ errno_t hc_start(xhci_hc_t *hc)
 	const uintptr_t erstba_phys = dma_buffer_phys_base(&hc->event_ring.erst);
 	XHCI_REG_WR(intr0, XHCI_INTR_ERSTBA, erstba_phys);
 
+	/* Let events accumulate a little before interrupting */
+	XHCI_REG_WR(intr0, XHCI_INTR_IMI, XHCI_IMOD_INTERVAL);
+
 	if (cap_handle_valid(hc->base.irq_handle)) {
 		XHCI_REG_SET(intr0, XHCI_INTR_IE, 1);
 		XHCI_REG_SET(hc->op_regs, XHCI_OP_INTE, 1);
@@ -500,8 +547,10 @@ errno_t hc_start(xhci_hc_t *hc)
 
 	XHCI_REG_SET(hc->op_regs, XHCI_OP_HSEE, 1);
 
-	xhci_sw_ring_restart(&hc->sw_ring);
-	joinable_fibril_start(hc->event_worker);
+	for (unsigned i = 0; i < XHCI_EVENT_WORKERS; ++i) {
+		xhci_sw_ring_restart(&hc->event_workers[i].sw_ring);
+		joinable_fibril_start(hc->event_workers[i].fibril);
+	}
 
 	xhci_start_command_ring(hc);
 
@@ -528,9 +577,11 @@ static void hc_stop(xhci_hc_t *hc)
 	/* Make sure commands will not block other fibrils. */
 	xhci_nuke_command_ring(hc);
 
-	/* Stop the event worker fibril to restart it */
-	xhci_sw_ring_stop(&hc->sw_ring);
-	joinable_fibril_join(hc->event_worker);
+	/* Stop the event worker fibrils to restart them */
+	for (unsigned i = 0; i < XHCI_EVENT_WORKERS; ++i) {
+		xhci_sw_ring_stop(&hc->event_workers[i].sw_ring);
+		joinable_fibril_join(hc->event_workers[i].fibril);
+	}
 
 	/*
 	 * Then, disconnect all roothub devices, which shall trigger
@@ -547,7 +598,8 @@ static void hc_reinitialize(xhci_hc_t *hc)
 	usb_log_info("HC stopped. Starting again...");
 
 	/* The worker fibrils need to be started again */
-	joinable_fibril_recreate(hc->event_worker);
+	for (unsigned i = 0; i < XHCI_EVENT_WORKERS; ++i)
+		joinable_fibril_recreate(hc->event_workers[i].fibril);
 	joinable_fibril_recreate(hc->rh.event_worker);
 
 	/* Now, the HC shall be stopped and software shall be clean. */
@@ -616,15 +668,47 @@ static event_handler event_handlers_fast [] = {
 	[XHCI_TRB_TYPE_MFINDEX_WRAP_EVENT] = &xhci_handle_mfindex_wrap_event,
 };
 
-static errno_t hc_handle_event(xhci_hc_t *hc, xhci_trb_t *trb)
+/**
+ * Events deferred to the workers during one run of the event ring. They are
+ * passed to each worker in batches rather than one by one.
+ */
+typedef struct {
+	xhci_trb_t trbs [XHCI_EVENT_WORKERS][XHCI_EVENT_BATCH_SIZE];
+	size_t count [XHCI_EVENT_WORKERS];
+} hc_event_batch_t;
+
+static errno_t hc_flush_event_batch(xhci_hc_t *hc, hc_event_batch_t *batch,
+    unsigned worker)
+{
+	const size_t count = batch->count[worker];
+
+	batch->count[worker] = 0;
+	return xhci_sw_ring_enqueue_batch(&hc->event_workers[worker].sw_ring,
+	    batch->trbs[worker], count);
+}
+
+static errno_t hc_handle_event(xhci_hc_t *hc, xhci_trb_t *trb,
+    hc_event_batch_t *batch)
 {
 	const unsigned type = TRB_TYPE(*trb);
+	errno_t err;
 
 	if (type <= ARRAY_SIZE(event_handlers_fast) && event_handlers_fast[type])
 		return event_handlers_fast[type](hc, trb);
 
-	if (type <= ARRAY_SIZE(event_handlers) && event_handlers[type])
-		return xhci_sw_ring_enqueue(&hc->sw_ring, trb);
+	if (type <= ARRAY_SIZE(event_handlers) && event_handlers[type]) {
+		/* Keep events of one device on one worker, in order */
+		const unsigned slot_id =
+		    XHCI_DWORD_EXTRACT(trb->control, 31, 24);
+		const unsigned worker = slot_id % XHCI_EVENT_WORKERS;
+
+		if (batch->count[worker] == XHCI_EVENT_BATCH_SIZE &&
+		    (err = hc_flush_event_batch(hc, batch, worker)))
+			return err;
+
+		batch->trbs[worker][batch->count[worker]++] = *trb;
+		return EOK;
+	}
 
 	if (type == XHCI_TRB_TYPE_PORT_STATUS_CHANGE_EVENT)
 		return xhci_sw_ring_enqueue(&hc->rh.event_ring, trb);
@@ -635,15 +719,22 @@ static errno_t hc_handle_event(xhci_hc_t *hc, xhci_trb_t *trb)
 static int event_worker(void *arg)
 {
 	errno_t err;
-	xhci_trb_t trb;
-	xhci_hc_t *const hc = arg;
-	assert(hc);
-
-	while (xhci_sw_ring_dequeue(&hc->sw_ring, &trb) != EINTR) {
-		const unsigned type = TRB_TYPE(trb);
-
-		if ((err = event_handlers[type](hc, &trb)))
-			usb_log_error("Failed to handle event: %s", str_error(err));
+	xhci_trb_t trbs [XHCI_EVENT_BATCH_SIZE];
+	size_t count;
+	xhci_event_worker_t *const worker = arg;
+	assert(worker);
+	xhci_hc_t *const hc = worker->hc;
+
+	while (xhci_sw_ring_dequeue_batch(&worker->sw_ring, trbs,
+	    ARRAY_SIZE(trbs), &count) != EINTR) {
+		for (size_t i = 0; i < count; ++i) {
+			const unsigned type = TRB_TYPE(trbs[i]);
+
+			if ((err = event_handlers[type](hc, &trbs[i]))) {
+				usb_log_error("Failed to handle event: %s",
+				    str_error(err));
+			}
+		}
 	}
 
 	return 0;
@@ -654,6 +745,10 @@ static int event_worker(void *arg)
  *
  * As there can be events, that blocks on waiting for subsequent events,
  * we solve this problem by deferring some types of events to separate fibrils.
+ *
+ * All pending events are processed in one run. The dequeue pointer is
+ * reported to the HC only every XHCI_ERDP_UPDATE_INTERVAL events and at the
+ * end, and the deferred events reach the workers in batches.
  */
 static void hc_run_event_ring(xhci_hc_t *hc, xhci_event_ring_t *event_ring,
     xhci_interrupter_regs_t *intr)
@@ -661,14 +756,31 @@ static void hc_run_event_ring(xhci_hc_t *hc, xhci_event_ring_t *event_ring,
 	errno_t err;
 
 	xhci_trb_t trb;
+	hc_event_batch_t batch;
+	size_t handled = 0;
+
+	memset(batch.count, 0, sizeof(batch.count));
 	hc->event_handler = fibril_get_id();
 
 	while ((err = xhci_event_ring_dequeue(event_ring, &trb)) != ENOENT) {
-		if ((err = hc_handle_event(hc, &trb)) != EOK) {
+		if ((err = hc_handle_event(hc, &trb, &batch)) != EOK) {
 			usb_log_error("Failed to handle event in interrupt: %s", str_error(err));
 		}
 
-		XHCI_REG_WR(intr, XHCI_INTR_ERDP, hc->event_ring.dequeue_ptr);
+		if (++handled % XHCI_ERDP_UPDATE_INTERVAL == 0) {
+			XHCI_REG_WR(intr, XHCI_INTR_ERDP,
+			    hc->event_ring.dequeue_ptr);
+		}
+	}
+
+	for (unsigned i = 0; i < XHCI_EVENT_WORKERS; ++i) {
+		if (!batch.count[i])
+			continue;
+
+		if ((err = hc_flush_event_batch(hc, &batch, i))) {
+			usb_log_error("Failed to pass events: %s",
+			    str_error(err));
+		}
 	}
 
 	hc->event_handler = 0;
@@ -733,8 +845,7 @@ void hc_fini(xhci_hc_t *hc)
 {
 	hc_stop(hc);
 
-	xhci_sw_ring_fini(&hc->sw_ring);
-	joinable_fibril_destroy(hc->event_worker);
+	hc_event_workers_fini(hc);
 	xhci_bus_fini(&hc->bus);
 	xhci_event_ring_fini(&hc->event_ring);
 	xhci_scratchpad_free(hc);
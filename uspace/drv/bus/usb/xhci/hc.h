@@ -50,6 +50,25 @@
 
 typedef struct xhci_command xhci_cmd_t;
 
+/** Number of fibrils handling transfer events */
+#define XHCI_EVENT_WORKERS  4
+
+/**
+ * Transfer event handling fibril. Devices are assigned to workers by their
+ * slot ID, so that events of one device are handled in order while a device
+ * that keeps its worker busy does not delay the others.
+ */
+typedef struct xhci_event_worker {
+	/** The HC this worker belongs to */
+	struct xhci_hc *hc;
+
+	/** Buffer for events */
+	xhci_sw_ring_t sw_ring;
+
+	/** Event handling fibril */
+	joinable_fibril_t *fibril;
+} xhci_event_worker_t;
+
 typedef struct xhci_hc {
 	/** Common HC device header */
 	hc_device_t base;
@@ -75,11 +94,8 @@ typedef struct xhci_hc {
 	/* Command ring management */
 	xhci_cmd_ring_t cr;
 
-	/* Buffer for events */
-	xhci_sw_ring_t sw_ring;
-
-	/** Event handling fibril */
-	joinable_fibril_t *event_worker;
+	/** Transfer event handling fibrils */
+	xhci_event_worker_t event_workers [XHCI_EVENT_WORKERS];
 
 	/* Root hub emulation */
 	xhci_rh_t rh;
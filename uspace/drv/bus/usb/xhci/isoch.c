@@ -524,7 +524,8 @@ errno_t isoch_schedule_out(xhci_transfer_t *transfer)
 
 	/* Prepare the transfer. */
 	it->size = transfer->batch.size;
-	memcpy(it->data.virt, transfer->batch.dma_buffer.virt, it->size);
+	memcpy(it->data.virt, usb_transfer_batch_data(&transfer->batch),
+	    it->size);
 	it->state = ISOCH_FILLED;
 
 	fibril_timer_clear_locked(isoch->feeding_timer);
@@ -573,7 +574,8 @@ errno_t isoch_schedule_in(xhci_transfer_t *transfer)
 
 	/* Withdraw results from previous transfer. */
 	if (!it->error) {
-		memcpy(transfer->batch.dma_buffer.virt, it->data.virt, it->size);
+		memcpy(usb_transfer_batch_data(&transfer->batch),
+		    it->data.virt, it->size);
 		transfer->batch.transferred_size = it->size;
 		transfer->batch.error = it->error;
 	}
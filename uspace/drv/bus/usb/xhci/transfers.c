@@ -290,6 +290,63 @@ static int schedule_isochronous(xhci_transfer_t *transfer)
 	    isoch_schedule_in(transfer);
 }
 
+/**
+ * Find the active batch a transfer event refers to.
+ *
+ * TDs on a ring complete in order. Completion is reported on the TRB with
+ * the IOC flag, errors are reported on the failed TRB, which always belongs
+ * to the oldest TD.
+ *
+ * @param addr Address of the TRB the event was generated for
+ * @param td_end Whether the event was generated at the end of the TD
+ */
+static usb_transfer_batch_t *find_active_batch(xhci_endpoint_t *ep,
+    uintptr_t addr, bool td_end)
+{
+	usb_transfer_batch_t *batch = endpoint_first_active_locked(&ep->base);
+
+	if (!td_end)
+		return batch;
+
+	while (batch) {
+		if (xhci_transfer_from_batch(batch)->interrupt_trb_phys == addr)
+			return batch;
+		batch = endpoint_next_active_locked(&ep->base, batch);
+	}
+
+	return NULL;
+}
+
+/**
+ * Finish batches queued behind a TD which halted the endpoint.
+ *
+ * Clearing the halt condition moves the dequeue pointer past them, so they
+ * would never complete.
+ */
+static void abort_queued_batches(xhci_endpoint_t *ep)
+{
+	list_t aborted;
+	list_initialize(&aborted);
+
+	fibril_mutex_lock(&ep->guard);
+	usb_transfer_batch_t *batch;
+	while ((batch = endpoint_first_active_locked(&ep->base))) {
+		endpoint_deactivate_locked(&ep->base, batch);
+		list_append(&batch->active_link, &aborted);
+	}
+	fibril_mutex_unlock(&ep->guard);
+
+	while (!list_empty(&aborted)) {
+		batch = list_get_instance(list_first(&aborted),
+		    usb_transfer_batch_t, active_link);
+		list_remove(&batch->active_link);
+
+		batch->error = EINTR;
+		batch->transferred_size = 0;
+		usb_transfer_batch_finish(batch);
+	}
+}
+
 errno_t xhci_handle_transfer_event(xhci_hc_t *hc, xhci_trb_t *trb)
 {
 	uintptr_t addr = trb->parameter;
@@ -315,6 +372,7 @@ errno_t xhci_handle_transfer_event(xhci_hc_t *hc, xhci_trb_t *trb)
 
 	usb_transfer_batch_t *batch;
 	xhci_transfer_t *transfer;
+	const xhci_trb_completion_code_t completion_code = TRB_COMPLETION_CODE(*trb);
 
 	if (TRB_EVENT_DATA(*trb)) {
 		/* We schedule those only when streams are involved */
@@ -325,6 +383,10 @@ errno_t xhci_handle_transfer_event(xhci_hc_t *hc, xhci_trb_t *trb)
 		xhci_trb_ring_update_dequeue(get_ring(transfer),
 		    transfer->interrupt_trb_phys);
 		batch = &transfer->batch;
+
+		fibril_mutex_lock(&ep->guard);
+		endpoint_deactivate_locked(&ep->base, batch);
+		fibril_mutex_unlock(&ep->guard);
 	} else {
 		xhci_trb_ring_update_dequeue(&ep->ring, addr);
 
@@ -335,9 +397,13 @@ errno_t xhci_handle_transfer_event(xhci_hc_t *hc, xhci_trb_t *trb)
 			return EOK;
 		}
 
+		const bool td_end = completion_code == XHCI_TRBC_SUCCESS ||
+		    completion_code == XHCI_TRBC_SHORT_PACKET;
+
 		fibril_mutex_lock(&ep->guard);
-		batch = ep->base.active_batch;
-		endpoint_deactivate_locked(&ep->base);
+		batch = find_active_batch(ep, addr, td_end);
+		if (batch)
+			endpoint_deactivate_locked(&ep->base, batch);
 		fibril_mutex_unlock(&ep->guard);
 
 		if (!batch) {
@@ -349,7 +415,7 @@ errno_t xhci_handle_transfer_event(xhci_hc_t *hc, xhci_trb_t *trb)
 		transfer = xhci_transfer_from_batch(batch);
 	}
 
-	const xhci_trb_completion_code_t completion_code = TRB_COMPLETION_CODE(*trb);
+	bool halted = false;
 	switch (completion_code) {
 	case XHCI_TRBC_SHORT_PACKET:
 	case XHCI_TRBC_SUCCESS:
@@ -367,12 +433,14 @@ errno_t xhci_handle_transfer_event(xhci_hc_t *hc, xhci_trb_t *trb)
 		usb_log_warning("Babble detected during the transfer.");
 		batch->error = EAGAIN;
 		batch->transferred_size = 0;
+		halted = true;
 		break;
 
 	case XHCI_TRBC_USB_TRANSACTION_ERROR:
 		usb_log_warning("USB Transaction error.");
 		batch->error = EAGAIN;
 		batch->transferred_size = 0;
+		halted = true;
 		break;
 
 	case XHCI_TRBC_TRB_ERROR:
@@ -385,12 +453,14 @@ errno_t xhci_handle_transfer_event(xhci_hc_t *hc, xhci_trb_t *trb)
 		usb_log_warning("Stall condition detected.");
 		batch->error = ESTALL;
 		batch->transferred_size = 0;
+		halted = true;
 		break;
 
 	case XHCI_TRBC_SPLIT_TRANSACTION_ERROR:
 		usb_log_error("Split transcation error detected.");
 		batch->error = EAGAIN;
 		batch->transferred_size = 0;
+		halted = true;
 		break;
 
 	default:
@@ -401,6 +471,10 @@ errno_t xhci_handle_transfer_event(xhci_hc_t *hc, xhci_trb_t *trb)
 	assert(batch->transferred_size <= batch->size);
 
 	usb_transfer_batch_finish(batch);
+
+	if (halted && !TRB_EVENT_DATA(*trb))
+		abort_queued_batches(ep);
+
 	/* Dropping temporary reference */
 	endpoint_del_ref(&ep->base);
 	return EOK;
@@ -499,8 +573,20 @@ errno_t xhci_transfer_schedule(usb_transfer_batch_t *batch)
 		return err;
 	}
 
-	if ((err = transfer_handlers[batch->ep->transfer_type](hc, transfer))) {
-		endpoint_deactivate_locked(ep);
+	/*
+	 * If the ring is full, wait for the TDs queued before this one
+	 * to complete.
+	 */
+	while (true) {
+		err = transfer_handlers[batch->ep->transfer_type](hc, transfer);
+		if (err != EAGAIN || !ep->online || ep->active_count <= 1)
+			break;
+
+		fibril_condvar_wait(&ep->avail, &xhci_ep->guard);
+	}
+
+	if (err) {
+		endpoint_deactivate_locked(ep, batch);
 		fibril_mutex_unlock(&xhci_ep->guard);
 		return err;
 	}
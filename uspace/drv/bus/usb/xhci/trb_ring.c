@@ -441,9 +441,11 @@ errno_t xhci_event_ring_dequeue(xhci_event_ring_t *ring, xhci_trb_t *event)
 	return EOK;
 }
 
-void xhci_sw_ring_init(xhci_sw_ring_t *ring, size_t size)
+errno_t xhci_sw_ring_init(xhci_sw_ring_t *ring, size_t size)
 {
 	ring->begin = calloc(size, sizeof(xhci_trb_t));
+	if (!ring->begin)
+		return ENOMEM;
 	ring->end = ring->begin + size;
 
 	fibril_mutex_initialize(&ring->guard);
@@ -451,6 +453,7 @@ void xhci_sw_ring_init(xhci_sw_ring_t *ring, size_t size)
 	fibril_condvar_initialize(&ring->dequeued_cv);
 
 	xhci_sw_ring_restart(ring);
+	return EOK;
 }
 
 errno_t xhci_sw_ring_enqueue(xhci_sw_ring_t *ring, xhci_trb_t *trb)
@@ -491,6 +494,67 @@ errno_t xhci_sw_ring_dequeue(xhci_sw_ring_t *ring, xhci_trb_t *trb)
 	return ring->running ? EOK : EINTR;
 }
 
+/**
+ * Enqueue several TRBs at once, waking the consumer only once they are all
+ * in or when the ring fills up.
+ */
+errno_t xhci_sw_ring_enqueue_batch(xhci_sw_ring_t *ring, xhci_trb_t *trbs,
+    size_t count)
+{
+	assert(ring);
+	assert(trbs || count == 0);
+
+	fibril_mutex_lock(&ring->guard);
+	for (size_t i = 0; i < count && ring->running; ++i) {
+		if (TRB_CYCLE(*ring->enqueue)) {
+			fibril_condvar_signal(&ring->enqueued_cv);
+			while (ring->running && TRB_CYCLE(*ring->enqueue)) {
+				fibril_condvar_wait(&ring->dequeued_cv,
+				    &ring->guard);
+			}
+		}
+
+		*ring->enqueue = trbs[i];
+		TRB_SET_CYCLE(*ring->enqueue, 1);
+		if (++ring->enqueue == ring->end)
+			ring->enqueue = ring->begin;
+	}
+	fibril_condvar_signal(&ring->enqueued_cv);
+	fibril_mutex_unlock(&ring->guard);
+
+	return ring->running ? EOK : EINTR;
+}
+
+/**
+ * Dequeue all TRBs available at once, up to @a max. Blocks until there is
+ * at least one.
+ */
+errno_t xhci_sw_ring_dequeue_batch(xhci_sw_ring_t *ring, xhci_trb_t *trbs,
+    size_t max, size_t *count)
+{
+	assert(ring);
+	assert(trbs);
+	assert(count);
+
+	size_t i = 0;
+
+	fibril_mutex_lock(&ring->guard);
+	while (ring->running && !TRB_CYCLE(*ring->dequeue))
+		fibril_condvar_wait(&ring->enqueued_cv, &ring->guard);
+
+	while (i < max && TRB_CYCLE(*ring->dequeue)) {
+		trbs[i++] = *ring->dequeue;
+		TRB_SET_CYCLE(*ring->dequeue, 0);
+		if (++ring->dequeue == ring->end)
+			ring->dequeue = ring->begin;
+	}
+	fibril_condvar_signal(&ring->dequeued_cv);
+	fibril_mutex_unlock(&ring->guard);
+
+	*count = i;
+	return ring->running ? EOK : EINTR;
+}
+
 void xhci_sw_ring_stop(xhci_sw_ring_t *ring)
 {
 	ring->running = false;
@@ -34,6 +34,7 @@
  */
 
 #include <align.h>
+#include <macros.h>
 #include <assert.h>
 #include <errno.h>
 #include <ddf/log.h>
@@ -75,22 +76,38 @@ static const visualizer_ops_t amdm37x_dispc_vis_ops = {
 static const struct {
 	unsigned bpp;
 	pixel2visual_t func;
+	pixel2visual_span_t span;
 } pixel2visual_table[] = {
-	[VISUAL_INDIRECT_8] = { .bpp = 1, .func = pixel2bgr_323 },
-	[VISUAL_RGB_5_5_5_LE] = { .bpp = 2, .func = pixel2rgb_555_le },
-	[VISUAL_RGB_5_5_5_BE] = { .bpp = 2, .func = pixel2rgb_555_be },
-	[VISUAL_RGB_5_6_5_LE] = { .bpp = 2, .func = pixel2rgb_565_le },
-	[VISUAL_RGB_5_6_5_BE] = { .bpp = 2, .func = pixel2rgb_565_be },
-	[VISUAL_BGR_8_8_8] = { .bpp = 3, .func = pixel2bgr_888 },
-	[VISUAL_RGB_8_8_8] = { .bpp = 3, .func = pixel2rgb_888 },
-	[VISUAL_BGR_0_8_8_8] = { .bpp = 4, .func = pixel2rgb_0888 },
-	[VISUAL_BGR_8_8_8_0] = { .bpp = 4, .func = pixel2bgr_8880 },
-	[VISUAL_ABGR_8_8_8_8] = { .bpp = 4, .func = pixel2abgr_8888 },
-	[VISUAL_BGRA_8_8_8_8] = { .bpp = 4, .func = pixel2bgra_8888 },
-	[VISUAL_RGB_0_8_8_8] = { .bpp = 4, .func = pixel2rgb_0888 },
-	[VISUAL_RGB_8_8_8_0] = { .bpp = 4, .func = pixel2rgb_8880 },
-	[VISUAL_ARGB_8_8_8_8] = { .bpp = 4, .func = pixel2argb_8888 },
-	[VISUAL_RGBA_8_8_8_8] = { .bpp = 4, .func = pixel2rgba_8888 },
+	[VISUAL_INDIRECT_8] = { .bpp = 1, .func = pixel2bgr_323,
+	    .span = pixel2bgr_323_span },
+	[VISUAL_RGB_5_5_5_LE] = { .bpp = 2, .func = pixel2rgb_555_le,
+	    .span = pixel2rgb_555_le_span },
+	[VISUAL_RGB_5_5_5_BE] = { .bpp = 2, .func = pixel2rgb_555_be,
+	    .span = pixel2rgb_555_be_span },
+	[VISUAL_RGB_5_6_5_LE] = { .bpp = 2, .func = pixel2rgb_565_le,
+	    .span = pixel2rgb_565_le_span },
+	[VISUAL_RGB_5_6_5_BE] = { .bpp = 2, .func = pixel2rgb_565_be,
+	    .span = pixel2rgb_565_be_span },
+	[VISUAL_BGR_8_8_8] = { .bpp = 3, .func = pixel2bgr_888,
+	    .span = pixel2bgr_888_span },
+	[VISUAL_RGB_8_8_8] = { .bpp = 3, .func = pixel2rgb_888,
+	    .span = pixel2rgb_888_span },
+	[VISUAL_BGR_0_8_8_8] = { .bpp = 4, .func = pixel2rgb_0888,
+	    .span = pixel2rgb_0888_span },
+	[VISUAL_BGR_8_8_8_0] = { .bpp = 4, .func = pixel2bgr_8880,
+	    .span = pixel2bgr_8880_span },
+	[VISUAL_ABGR_8_8_8_8] = { .bpp = 4, .func = pixel2abgr_8888,
+	    .span = pixel2abgr_8888_span },
+	[VISUAL_BGRA_8_8_8_8] = { .bpp = 4, .func = pixel2bgra_8888,
+	    .span = pixel2bgra_8888_span },
+	[VISUAL_RGB_0_8_8_8] = { .bpp = 4, .func = pixel2rgb_0888,
+	    .span = pixel2rgb_0888_span },
+	[VISUAL_RGB_8_8_8_0] = { .bpp = 4, .func = pixel2rgb_8880,
+	    .span = pixel2rgb_8880_span },
+	[VISUAL_ARGB_8_8_8_8] = { .bpp = 4, .func = pixel2argb_8888,
+	    .span = pixel2argb_8888_span },
+	[VISUAL_RGBA_8_8_8_8] = { .bpp = 4, .func = pixel2rgba_8888,
+	    .span = pixel2rgba_8888_span },
 };
 
 static void mode_init(vslmode_list_element_t *mode,
@@ -278,6 +295,7 @@ static errno_t change_mode(visualizer_t *vis, vslmode_t mode)
 	assert((size_t)visual < sizeof(pixel2visual_table) / sizeof(pixel2visual_table[0]));
 	const unsigned bpp = pixel2visual_table[visual].bpp;
 	pixel2visual_t p2v = pixel2visual_table[visual].func;
+	pixel2visual_span_t p2v_span = pixel2visual_table[visual].span;
 	const unsigned x = mode.screen_width;
 	const unsigned y = mode.screen_height;
 	ddf_log_note("Setting mode: %ux%ux%u\n", x, y, bpp * 8);
@@ -301,6 +319,7 @@ static errno_t change_mode(visualizer_t *vis, vslmode_t mode)
 	dispc->active_fb.pitch = 0;
 	dispc->active_fb.bpp = bpp;
 	dispc->active_fb.pixel2visual = p2v;
+	dispc->active_fb.pixel2visual_span = p2v_span;
 	dispc->size = size;
 	assert(mode.index < 1);
 
@@ -322,20 +341,27 @@ static errno_t handle_damage(visualizer_t *vs,
 	if (x_offset == 0 && y_offset == 0) {
 		/* Faster damage routine ignoring offsets. */
 		for (sysarg_t y = y0; y < height + y0; ++y) {
-			pixel_t *pixel = pixelmap_pixel_at(map, x0, y);
-			for (sysarg_t x = x0; x < width + x0; ++x) {
-				dispc->active_fb.pixel2visual(
-				    dispc->fb_data + FB_POS(x, y), *pixel++);
-			}
+			dispc->active_fb.pixel2visual_span(
+			    dispc->fb_data + FB_POS(x0, y),
+			    pixelmap_pixel_at(map, x0, y), width);
 		}
 	} else {
 		for (sysarg_t y = y0; y < height + y0; ++y) {
-			for (sysarg_t x = x0; x < width + x0; ++x) {
-				dispc->active_fb.pixel2visual(
+			sysarg_t x = x0;
+			sysarg_t x_map = (x0 + x_offset) % map->width;
+			sysarg_t y_map = (y + y_offset) % map->height;
+
+			/* The row wraps around at most once per map width. */
+			while (x < width + x0) {
+				sysarg_t count = min(width + x0 - x,
+				    map->width - x_map);
+
+				dispc->active_fb.pixel2visual_span(
 				    dispc->fb_data + FB_POS(x, y),
-				    *pixelmap_pixel_at(map,
-				    (x + x_offset) % map->width,
-				    (y + y_offset) % map->height));
+				    pixelmap_pixel_at(map, x_map, y_map),
+				    count);
+				x += count;
+				x_map = 0;
 			}
 		}
 	}
@@ -45,6 +45,7 @@
 #include <mem.h>
 #include <as.h>
 #include <align.h>
+#include <macros.h>
 
 #include <sysinfo.h>
 #include <ddi.h>
@@ -73,12 +74,16 @@ typedef struct {
 	visual_t visual;
 
 	pixel2visual_t pixel2visual;
+	pixel2visual_span_t pixel2visual_span;
 	visual2pixel_t visual2pixel;
 	visual_mask_t visual_mask;
 	size_t pixel_bytes;
 
 	size_t size;
 	uint8_t *addr;
+
+	/** One scanline rendered in system memory */
+	uint8_t *rowbuf;
 } kfb_t;
 
 static kfb_t kfb;
@@ -113,23 +118,41 @@ static errno_t kfb_handle_damage_pixels(visualizer_t *vs,
     sysarg_t x_offset, sysarg_t y_offset)
 {
 	pixelmap_t *map = &vs->cells;
-
+	size_t bytes = width * kfb.pixel_bytes;
+
+	/*
+	 * Each damaged scanline is converted in system memory first and
+	 * then copied to the framebuffer at once. Video memory is usually
+	 * uncached, so it is written by wide stores of memcpy() rather
+	 * than by single pixels or even bytes.
+	 */
 	if (x_offset == 0 && y_offset == 0) {
 		/* Faster damage routine ignoring offsets. */
 		for (sysarg_t y = y0; y < height + y0; ++y) {
-			pixel_t *pixel = pixelmap_pixel_at(map, x0, y);
-			for (sysarg_t x = x0; x < width + x0; ++x) {
-				kfb.pixel2visual(kfb.addr + FB_POS(x, y), *pixel++);
-			}
+			kfb.pixel2visual_span(kfb.rowbuf,
+			    pixelmap_pixel_at(map, x0, y), width);
+			memcpy(kfb.addr + FB_POS(x0, y), kfb.rowbuf, bytes);
 		}
 	} else {
 		for (sysarg_t y = y0; y < height + y0; ++y) {
-			for (sysarg_t x = x0; x < width + x0; ++x) {
-				kfb.pixel2visual(kfb.addr + FB_POS(x, y),
-				    *pixelmap_pixel_at(map,
-				    (x + x_offset) % map->width,
-				    (y + y_offset) % map->height));
+			sysarg_t x = 0;
+			sysarg_t x_map = (x0 + x_offset) % map->width;
+			sysarg_t y_map = (y + y_offset) % map->height;
+
+			/* The row wraps around at most once per map width. */
+			while (x < width) {
+				sysarg_t count = min(width - x,
+				    map->width - x_map);
+
+				kfb.pixel2visual_span(
+				    kfb.rowbuf + x * kfb.pixel_bytes,
+				    pixelmap_pixel_at(map, x_map, y_map),
+				    count);
+				x += count;
+				x_map = 0;
 			}
+
+			memcpy(kfb.addr + FB_POS(x0, y), kfb.rowbuf, bytes);
 		}
 	}
 
@@ -234,66 +257,77 @@ errno_t port_init(ddf_dev_t *dev)
 	switch (visual) {
 	case VISUAL_INDIRECT_8:
 		kfb.pixel2visual = pixel2bgr_323;
+		kfb.pixel2visual_span = pixel2bgr_323_span;
 		kfb.visual2pixel = bgr_323_2pixel;
 		kfb.visual_mask = visual_mask_323;
 		kfb.pixel_bytes = 1;
 		break;
 	case VISUAL_RGB_5_5_5_LE:
 		kfb.pixel2visual = pixel2rgb_555_le;
+		kfb.pixel2visual_span = pixel2rgb_555_le_span;
 		kfb.visual2pixel = rgb_555_le_2pixel;
 		kfb.visual_mask = visual_mask_555;
 		kfb.pixel_bytes = 2;
 		break;
 	case VISUAL_RGB_5_5_5_BE:
 		kfb.pixel2visual = pixel2rgb_555_be;
+		kfb.pixel2visual_span = pixel2rgb_555_be_span;
 		kfb.visual2pixel = rgb_555_be_2pixel;
 		kfb.visual_mask = visual_mask_555;
 		kfb.pixel_bytes = 2;
 		break;
 	case VISUAL_RGB_5_6_5_LE:
 		kfb.pixel2visual = pixel2rgb_565_le;
+		kfb.pixel2visual_span = pixel2rgb_565_le_span;
 		kfb.visual2pixel = rgb_565_le_2pixel;
 		kfb.visual_mask = visual_mask_565;
 		kfb.pixel_bytes = 2;
 		break;
 	case VISUAL_RGB_5_6_5_BE:
 		kfb.pixel2visual = pixel2rgb_565_be;
+		kfb.pixel2visual_span = pixel2rgb_565_be_span;
 		kfb.visual2pixel = rgb_565_be_2pixel;
 		kfb.visual_mask = visual_mask_565;
 		kfb.pixel_bytes = 2;
 		break;
 	case VISUAL_RGB_8_8_8:
 		kfb.pixel2visual = pixel2rgb_888;
+		kfb.pixel2visual_span = pixel2rgb_888_span;
 		kfb.visual2pixel = rgb_888_2pixel;
 		kfb.visual_mask = visual_mask_888;
 		kfb.pixel_bytes = 3;
 		break;
 	case VISUAL_BGR_8_8_8:
 		kfb.pixel2visual = pixel2bgr_888;
+		kfb.pixel2visual_span = pixel2bgr_888_span;
 		kfb.visual2pixel = bgr_888_2pixel;
 		kfb.visual_mask = visual_mask_888;
 		kfb.pixel_bytes = 3;
 		break;
 	case VISUAL_RGB_8_8_8_0:
 		kfb.pixel2visual = pixel2rgb_8880;
+		kfb.pixel2visual_span = pixel2rgb_8880_span;
 		kfb.visual2pixel = rgb_8880_2pixel;
 		kfb.visual_mask = visual_mask_8880;
 		kfb.pixel_bytes = 4;
 		break;
 	case VISUAL_RGB_0_8_8_8:
 		kfb.pixel2visual = pixel2rgb_0888;
+		kfb.pixel2visual_span = pixel2rgb_0888_span;
 		kfb.visual2pixel = rgb_0888_2pixel;
 		kfb.visual_mask = visual_mask_0888;
 		kfb.pixel_bytes = 4;
 		break;
 	case VISUAL_BGR_0_8_8_8:
 		kfb.pixel2visual = pixel2bgr_0888;
+		kfb.pixel2visual_span = pixel2bgr_0888_span;
 		kfb.visual2pixel = bgr_0888_2pixel;
 		kfb.visual_mask = visual_mask_0888;
 		kfb.pixel_bytes = 4;
 		break;
 	case VISUAL_BGR_8_8_8_0:
 		kfb.pixel2visual = pixel2bgr_8880;
+		kfb.pixel2visual_span = pixel2bgr_8880_span;
 		kfb.visual2pixel = bgr_8880_2pixel;
 		kfb.visual_mask = visual_mask_8880;
 		kfb.pixel_bytes = 4;
@@ -305,9 +339,14 @@ errno_t port_init(ddf_dev_t *dev)
 	kfb.size = scanline * height;
 	kfb.addr = AS_AREA_ANY;
 
+	kfb.rowbuf = malloc(width * kfb.pixel_bytes);
+	if (kfb.rowbuf == NULL)
+		return ENOMEM;
+
 	ddf_fun_t *fun_vs = ddf_fun_create(dev, fun_exposed, "vsl0");
 	if (fun_vs == NULL) {
 		as_area_destroy(kfb.addr);
+		free(kfb.rowbuf);
 		return ENOMEM;
 	}
 	ddf_fun_set_conn_handler(fun_vs, &graph_vsl_connection);
@@ -315,6 +354,7 @@ errno_t port_init(ddf_dev_t *dev)
 	visualizer_t *vs = ddf_fun_data_alloc(fun_vs, sizeof(visualizer_t));
 	if (vs == NULL) {
 		as_area_destroy(kfb.addr);
+		free(kfb.rowbuf);
 		return ENOMEM;
 	}
 	graph_init_visualizer(vs);
@@ -343,6 +383,7 @@ errno_t port_init(ddf_dev_t *dev)
 		list_remove(&pixel_mode.link);
 		ddf_fun_destroy(fun_vs);
 		as_area_destroy(kfb.addr);
+		free(kfb.rowbuf);
 		return rc;
 	}
 
@@ -353,6 +394,7 @@ errno_t port_init(ddf_dev_t *dev)
 		ddf_fun_unbind(fun_vs);
 		ddf_fun_destroy(fun_vs);
 		as_area_destroy(kfb.addr);
+		free(kfb.rowbuf);
 		return rc;
 	}
 
@@ -58,6 +58,9 @@
 #define E1000_RX_FRAME_COUNT  128
 #define E1000_TX_FRAME_COUNT  128
 
+/** Receive buffers in the ring and lent up the stack */
+#define E1000_RX_POOL_SIZE  (2 * E1000_RX_FRAME_COUNT)
+
 #define E1000_RECEIVE_ADDRESS  16
 
 /** Maximum sending frame size */
@@ -142,10 +145,10 @@ typedef struct {
 	/** Virtual rx ring address */
 	void *rx_ring_virt;
 
-	/** Ring of RX frames, physical address */
-	uintptr_t *rx_frame_phys;
-	/** Ring of RX frames, virtual address */
-	void **rx_frame_virt;
+	/** Ring of RX frames */
+	nic_frame_t **rx_frames;
+	/** Pool of RX frames */
+	nic_frame_pool_t *rx_pool;
 
 	/** VLAN tag */
 	uint16_t vlan_tag;
@@ -1082,7 +1085,7 @@ static errno_t e1000_vlan_set_tag(ddf_fun_t *fun, uint16_t tag, bool add,
 
 /** Fill receive descriptor with new empty buffer
  *
- * Store frame in e1000->rx_frame_phys
+ * Store frame in e1000->rx_frames
  *
  * @param nic    NIC data stricture
  * @param offset Receive descriptor offset
@@ -1095,7 +1098,7 @@ static void e1000_fill_new_rx_descriptor(nic_t *nic, size_t offset)
 	e1000_rx_descriptor_t *rx_descriptor = (e1000_rx_descriptor_t *)
 	    (e1000->rx_ring_virt + offset * sizeof(e1000_rx_descriptor_t));
 
-	rx_descriptor->phys_addr = PTR_TO_U64(e1000->rx_frame_phys[offset]);
+	rx_descriptor->phys_addr = PTR_TO_U64(e1000->rx_frames[offset]->phys);
 	rx_descriptor->length = 0;
 	rx_descriptor->checksum = 0;
 	rx_descriptor->status = 0;
@@ -1161,10 +1164,13 @@ static uint32_t e1000_inc_tail(uint32_t tail, uint32_t descriptors_count)
 
 /** Receive frames
  *
- * @param nic NIC data
+ * @param nic    NIC data
+ * @param budget Maximal number of frames to receive
+ *
+ * @return Number of frames received
  *
  */
-static void e1000_receive_frames(nic_t *nic)
+static size_t e1000_receive_frames(nic_t *nic, size_t budget)
 {
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
@@ -1176,13 +1182,34 @@ static void e1000_receive_frames(nic_t *nic)
 	e1000_rx_descriptor_t *rx_descriptor = (e1000_rx_descriptor_t *)
 	    (e1000->rx_ring_virt + next_tail * sizeof(e1000_rx_descriptor_t));
 
-	while (rx_descriptor->status & 0x01) {
+	/* Pass all frames received so far up the stack at once */
+	nic_frame_list_t *frames = nic_alloc_frame_list();
+	size_t count = 0;
+
+	while (count < budget && (rx_descriptor->status & 0x01)) {
 		uint32_t frame_size = rx_descriptor->length - E1000_CRC_SIZE;
 
-		nic_frame_t *frame = nic_alloc_frame(nic, frame_size);
+		nic_frame_t *frame = e1000->rx_frames[next_tail];
+		nic_frame_t *fresh = nic_frame_pool_get(e1000->rx_pool);
+		if (fresh != NULL) {
+			/* Lend the buffer up the stack, refill the ring */
+			e1000->rx_frames[next_tail] = fresh;
+			frame->size = frame_size;
+		} else {
+			/* All buffers are lent, pass a copy */
+			frame = nic_alloc_frame(nic, frame_size);
+			if (frame != NULL) {
+				memcpy(frame->data,
+				    e1000->rx_frames[next_tail]->data,
+				    frame_size);
+			}
+		}
+
 		if (frame != NULL) {
-			memcpy(frame->data, e1000->rx_frame_virt[next_tail], frame_size);
-			nic_received_frame(nic, frame);
+			if (frames != NULL)
+				nic_frame_list_append(frames, frame);
+			else
+				nic_received_frame(nic, frame);
 		} else {
 			ddf_msg(LVL_ERROR, "Memory allocation failed. Frame dropped.");
 		}
@@ -1194,9 +1221,13 @@ static void e1000_receive_frames(nic_t *nic)
 
 		rx_descriptor = (e1000_rx_descriptor_t *)
 		    (e1000->rx_ring_virt + next_tail * sizeof(e1000_rx_descriptor_t));
+		count++;
 	}
 
 	fibril_mutex_unlock(&e1000->rx_lock);
+
+	nic_received_frame_list(nic, frames);
+	return count;
 }
 
 /** Enable E1000 interupts
@@ -1216,13 +1247,13 @@ static void e1000_enable_interrupts(e1000_t *e1000)
  */
 static void e1000_disable_interrupts(e1000_t *e1000)
 {
-	E1000_REG_WRITE(e1000, E1000_IMS, 0);
+	/* Writing zeroes to IMS has no effect, the mask is cleared by IMC */
+	E1000_REG_WRITE(e1000, E1000_IMC, 0xffffffff);
 }
 
 /** Interrupt handler implementation
  *
- * This function is called from e1000_interrupt_handler()
- * and e1000_poll()
+ * This function is called from e1000_poll()
  *
  * @param nic NIC data
  * @param icr ICR register value
@@ -1231,7 +1262,30 @@ static void e1000_disable_interrupts(e1000_t *e1000)
 static void e1000_interrupt_handler_impl(nic_t *nic, uint32_t icr)
 {
 	if (icr & ICR_RXT0)
-		e1000_receive_frames(nic);
+		e1000_receive_frames(nic, SIZE_MAX);
+}
+
+/** Receive frames while NICF polls the device
+ *
+ * @param nic    NIC data
+ * @param budget Maximal number of frames to receive
+ *
+ * @return Number of frames received
+ *
+ */
+static size_t e1000_rx_poll(nic_t *nic, size_t budget)
+{
+	return e1000_receive_frames(nic, budget);
+}
+
+/** Enable E1000 interrupts once NICF stops polling the device
+ *
+ * @param nic NIC data
+ *
+ */
+static void e1000_rx_irq_enable(nic_t *nic)
+{
+	e1000_enable_interrupts(DRIVER_DATA_NIC(nic));
 }
 
 /** Handle device interrupt
@@ -1247,7 +1301,13 @@ static void e1000_interrupt_handler(ipc_call_t *icall,
 	nic_t *nic = NIC_DATA_DEV(dev);
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
-	e1000_interrupt_handler_impl(nic, icr);
+	/*
+	 * Under load NICF keeps polling the device, the interrupts stay
+	 * disabled until it is done.
+	 */
+	if ((icr & ICR_RXT0) && nic_rx_interrupt(nic))
+		return;
+
 	e1000_enable_interrupts(e1000);
 }
 
@@ -1383,35 +1443,30 @@ static errno_t e1000_initialize_rx_structure(nic_t *nic)
 	    E1000_RX_FRAME_COUNT * sizeof(e1000_rx_descriptor_t),
 	    DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0,
 	    &e1000->rx_ring_phys, &e1000->rx_ring_virt);
-	if (rc != EOK)
+	if (rc != EOK) {
+		fibril_mutex_unlock(&e1000->rx_lock);
 		return rc;
+	}
 
 	E1000_REG_WRITE(e1000, E1000_RDBAH,
 	    (uint32_t) (PTR_TO_U64(e1000->rx_ring_phys) >> 32));
 	E1000_REG_WRITE(e1000, E1000_RDBAL,
 	    (uint32_t) PTR_TO_U64(e1000->rx_ring_phys));
 
-	e1000->rx_frame_phys = (uintptr_t *)
-	    calloc(E1000_RX_FRAME_COUNT, sizeof(uintptr_t));
-	e1000->rx_frame_virt =
-	    calloc(E1000_RX_FRAME_COUNT, sizeof(void *));
-	if ((e1000->rx_frame_phys == NULL) || (e1000->rx_frame_virt == NULL)) {
+	e1000->rx_frames = calloc(E1000_RX_FRAME_COUNT, sizeof(nic_frame_t *));
+	if (e1000->rx_frames == NULL) {
 		rc = ENOMEM;
 		goto error;
 	}
 
-	for (size_t i = 0; i < E1000_RX_FRAME_COUNT; i++) {
-		uintptr_t frame_phys;
-		void *frame_virt = AS_AREA_ANY;
-
-		rc = dmamem_map_anonymous(E1000_MAX_SEND_FRAME_SIZE,
-		    DMAMEM_4GiB, AS_AREA_READ | AS_AREA_WRITE, 0,
-		    &frame_phys, &frame_virt);
-		if (rc != EOK)
-			goto error;
+	rc = nic_frame_pool_create(E1000_RX_POOL_SIZE,
+	    E1000_MAX_RECEIVE_FRAME_SIZE, &e1000->rx_pool);
+	if (rc != EOK)
+		goto error;
 
-		e1000->rx_frame_phys[i] = frame_phys;
-		e1000->rx_frame_virt[i] = frame_virt;
+	for (size_t i = 0; i < E1000_RX_FRAME_COUNT; i++) {
+		e1000->rx_frames[i] = nic_frame_pool_get(e1000->rx_pool);
+		assert(e1000->rx_frames[i] != NULL);
 	}
 
 	/* Write descriptor */
@@ -1424,24 +1479,11 @@ static errno_t e1000_initialize_rx_structure(nic_t *nic)
 	return EOK;
 
 error:
-	for (size_t i = 0; i < E1000_RX_FRAME_COUNT; i++) {
-		if (e1000->rx_frame_virt[i] != NULL) {
-			dmamem_unmap_anonymous(e1000->rx_frame_virt[i]);
-			e1000->rx_frame_phys[i] = 0;
-			e1000->rx_frame_virt[i] = NULL;
-		}
-	}
-
-	if (e1000->rx_frame_phys != NULL) {
-		free(e1000->rx_frame_phys);
-		e1000->rx_frame_phys = NULL;
-	}
-
-	if (e1000->rx_frame_virt != NULL) {
-		free(e1000->rx_frame_virt);
-		e1000->rx_frame_virt = NULL;
-	}
+	free(e1000->rx_frames);
+	e1000->rx_frames = NULL;
+	dmamem_unmap_anonymous(e1000->rx_ring_virt);
 
+	fibril_mutex_unlock(&e1000->rx_lock);
 	return rc;
 }
 
@@ -1454,17 +1496,11 @@ static void e1000_uninitialize_rx_structure(nic_t *nic)
 {
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
 
-	/* Write descriptor */
-	for (unsigned int offset = 0; offset < E1000_RX_FRAME_COUNT; offset++) {
-		dmamem_unmap_anonymous(e1000->rx_frame_virt[offset]);
-		e1000->rx_frame_phys[offset] = 0;
-		e1000->rx_frame_virt[offset] = NULL;
-	}
-
-	free(e1000->rx_frame_virt);
+	nic_frame_pool_destroy(e1000->rx_pool);
+	free(e1000->rx_frames);
 
-	e1000->rx_frame_phys = NULL;
-	e1000->rx_frame_virt = NULL;
+	e1000->rx_pool = NULL;
+	e1000->rx_frames = NULL;
 
 	dmamem_unmap_anonymous(e1000->rx_ring_virt);
 }
@@ -1898,6 +1934,7 @@ static e1000_t *e1000_create_dev_data(ddf_dev_t *dev)
 	    e1000_on_unicast_mode_change, e1000_on_multicast_mode_change,
 	    e1000_on_broadcast_mode_change, NULL, e1000_on_vlan_mask_change);
 	nic_set_poll_handlers(nic, e1000_poll_mode_change, e1000_poll);
+	nic_set_rx_poll_handlers(nic, e1000_rx_poll, e1000_rx_irq_enable);
 
 	fibril_mutex_initialize(&e1000->ctrl_lock);
 	fibril_mutex_initialize(&e1000->rx_lock);
@@ -1955,6 +1992,12 @@ static errno_t e1000_fill_resource_info(ddf_dev_t *dev,
 	e1000->reg_base_phys =
 	    MEMADDR_TO_PTR(RNGABS(hw_resources->mem_ranges.ranges[0]));
 
+	/* Prefer a message signalled interrupt to a possibly shared line */
+	int msi_irq;
+	unsigned int granted;
+	if (pci_msi_enable(e1000->parent_sess, 1, &msi_irq, &granted) == EOK)
+		e1000->irq = msi_irq;
+
 	return EOK;
 }
 
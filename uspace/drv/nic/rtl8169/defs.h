@@ -102,7 +102,7 @@ enum rtl8169_registers {
 	RMS = 0xda, /**< Rx packet Maximum Size, 2b */
 	/* 0xdc - 0xdf reserved */
 	CCR = 0xe0, /**< C+ Command Register */
-	/* 0xe2 - 0xe3 reserved */
+	INTRMITIGATE = 0xe2, /**< Interrupt mitigation, 2b */
 	RDSAR = 0xe4, /**< Receive Descriptor Start Address Register, 8b */
 	ETTHR = 0xec, /**< Early Transmit Threshold Register, 1b */
 	/* 0xed - 0xef reserved */
@@ -188,6 +188,7 @@ enum rtl8169_interrupts {
 	INT_TOK = (1 << 2), /**< Transmit OK interrupt */
 	INT_RER = (1 << 1), /**< Receive error interrupt */
 	INT_ROK = (1 << 0), /**< Receive OK interrupt */
+	INT_RX = (INT_RXOVW | INT_RER | INT_ROK), /**< Receive interrupts */
 	INT_KNOWN = (INT_SERR | INT_TIME_OUT | INT_SW | INT_TDU |
 	    INT_FIFOOVW | INT_PUN | INT_RXOVW | INT_TER |
 	    INT_TOK | INT_RER | INT_ROK),
@@ -73,6 +73,8 @@ static errno_t rtl8169_defective_set_mode(ddf_fun_t *fun, uint32_t mode);
 static errno_t rtl8169_on_activated(nic_t *nic_data);
 static errno_t rtl8169_on_stopped(nic_t *nic_data);
 static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size);
+static size_t rtl8169_rx_poll(nic_t *nic_data, size_t budget);
+static void rtl8169_rx_irq_enable(nic_t *nic_data);
 static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev);
 static inline errno_t rtl8169_register_int_handler(nic_t *nic_data,
     cap_irq_handle_t *handle);
@@ -277,16 +279,17 @@ static errno_t rtl8169_allocate_buffers(rtl8169_t *rtl8169)
 	    rtl8169->tx_buff_phys, rtl8169->tx_buff);
 
 	/* Allocate RX buffers */
-	rtl8169->rx_buff = AS_AREA_ANY;
-	rc = dmamem_map_anonymous(RX_BUFFERS_SIZE, DMAMEM_4GiB,
-	    AS_AREA_READ | AS_AREA_WRITE, 0, &rtl8169->rx_buff_phys,
-	    &rtl8169->rx_buff);
-
-	if (rc != EOK)
-		return rc;
-
-	ddf_msg(LVL_DEBUG, "RX buffers base address: phys=0x%#" PRIxn ", virt=%p",
-	    rtl8169->rx_buff_phys, rtl8169->rx_buff);
+	if (rtl8169->rx_pool == NULL) {
+		rc = nic_frame_pool_create(RX_POOL_SIZE, BUFFER_SIZE,
+		    &rtl8169->rx_pool);
+		if (rc != EOK)
+			return rc;
+
+		for (unsigned int i = 0; i < RX_BUFFERS_COUNT; i++) {
+			rtl8169->rx_frames[i] =
+			    nic_frame_pool_get(rtl8169->rx_pool);
+		}
+	}
 
 	return EOK;
 }
@@ -317,8 +320,12 @@ static rtl8169_t *rtl8169_create_dev_data(ddf_dev_t *dev)
 	    rtl8169_unicast_set, rtl8169_multicast_set, rtl8169_broadcast_set,
 	    NULL, NULL);
 
+	nic_set_rx_poll_handlers(nic_data, rtl8169_rx_poll,
+	    rtl8169_rx_irq_enable);
+
 	fibril_mutex_initialize(&rtl8169->rx_lock);
 	fibril_mutex_initialize(&rtl8169->tx_lock);
+	fibril_mutex_initialize(&rtl8169->irq_lock);
 
 	nic_set_wol_max_caps(nic_data, NIC_WV_BROADCAST, 1);
 	nic_set_wol_max_caps(nic_data, NIC_WV_LINK_CHANGE, 1);
@@ -677,7 +684,7 @@ static void rtl8169_rx_ring_refill(rtl8169_t *rtl8169, unsigned int first,
 
 	while (true) {
 		descr = &rtl8169->rx_ring[i];
-		buff_phys = rtl8169->rx_buff_phys + (BUFFER_SIZE * i);
+		buff_phys = rtl8169->rx_frames[i]->phys;
 		descr->control = BUFFER_SIZE | CONTROL_OWN;
 		descr->buf_low = buff_phys & 0xffffffff;
 		descr->buf_high = (buff_phys >> 32) & 0xffffffff;
@@ -747,7 +754,13 @@ static errno_t rtl8169_on_activated(nic_t *nic_data)
 	pio_write_32(rtl8169->regs + RCR, rcr);
 	pio_write_16(rtl8169->regs + RMS, BUFFER_SIZE);
 
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
+	/* Throttle interrupts under load */
+	pio_write_16(rtl8169->regs + INTRMITIGATE, INTR_MITIGATE_DEFAULT);
+
+	fibril_mutex_lock(&rtl8169->irq_lock);
+	rtl8169->int_mask = 0xffff;
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
+	fibril_mutex_unlock(&rtl8169->irq_lock);
 	/* XXX Check return value */
 	hw_res_enable_interrupt(rtl8169->parent_sess, rtl8169->irq);
 
@@ -974,15 +987,15 @@ static void rtl8169_transmit_done(ddf_dev_t *dev)
 	fibril_mutex_unlock(&rtl8169->tx_lock);
 }
 
-static void rtl8169_receive_done(ddf_dev_t *dev)
+static size_t rtl8169_receive_done(ddf_dev_t *dev, size_t budget)
 {
 	nic_t *nic_data = nic_get_from_ddf_dev(dev);
 	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
 	rtl8169_descr_t *descr;
 	nic_frame_list_t *frames = nic_alloc_frame_list();
-	nic_frame_t *frame;
-	void *buffer;
-	unsigned int tail, fsidx = 0;
+	nic_frame_t *frame, *fresh;
+	unsigned int tail, fsidx = 0, used = 0;
+	size_t count = 0;
 	int frame_size;
 
 	ddf_msg(LVL_DEBUG, "rtl8169_receive_done()");
@@ -991,12 +1004,15 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 
 	tail = rtl8169->rx_tail;
 
-	while (true) {
+	/* Stop before wrapping over descriptors consumed in this round */
+	while (count < budget && used < RX_BUFFERS_COUNT) {
 		descr = &rtl8169->rx_ring[tail];
 
 		if (descr->control & CONTROL_OWN)
 			break;
 
+		used++;
+
 		if (descr->control & RXSTATUS_RES) {
 			ddf_msg(LVL_WARN, "error at slot %d: 0x%08x\n", tail, descr->control);
 			tail = (tail + 1) % RX_BUFFERS_COUNT;
@@ -1013,23 +1029,85 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 				ddf_msg(LVL_WARN, "single frame spanning multiple descriptors");
 
 			frame_size = descr->control & 0x1fff;
-			buffer = rtl8169->rx_buff + (BUFFER_SIZE * tail);
-			frame = nic_alloc_frame(nic_data, frame_size);
-			memcpy(frame->data, buffer, frame_size);
-			nic_frame_list_append(frames, frame);
+			frame = rtl8169->rx_frames[tail];
+			fresh = nic_frame_pool_get(rtl8169->rx_pool);
+			if (fresh != NULL) {
+				/* Lend the buffer up the stack */
+				rtl8169->rx_frames[tail] = fresh;
+				frame->size = frame_size;
+			} else {
+				/* All buffers are lent, pass a copy */
+				frame = nic_alloc_frame(nic_data, frame_size);
+				if (frame != NULL) {
+					memcpy(frame->data,
+					    rtl8169->rx_frames[tail]->data,
+					    frame_size);
+				}
+			}
+
+			if (frame != NULL) {
+				nic_frame_list_append(frames, frame);
+				count++;
+			}
 		}
 
 		tail = (tail + 1) % RX_BUFFERS_COUNT;
 	}
 
-	rtl8169_rx_ring_refill(rtl8169, rtl8169->rx_tail, tail);
+	/* Descriptors from tail on may already hold unreceived frames */
+	if (used > 0) {
+		rtl8169_rx_ring_refill(rtl8169, rtl8169->rx_tail,
+		    (tail + RX_BUFFERS_COUNT - 1) % RX_BUFFERS_COUNT);
+	}
 
 	rtl8169->rx_tail = tail;
 
 	fibril_mutex_unlock(&rtl8169->rx_lock);
 
 	nic_received_frame_list(nic_data, frames);
+	return count;
+}
+
+/** Receive frames while NICF polls the device
+ *
+ * Once the budget is exhausted, the receive interrupts stay masked
+ * until rtl8169_rx_irq_enable() is called.
+ *
+ * @param nic_data NIC data
+ * @param budget   Maximal number of frames to receive
+ *
+ * @return Number of frames received
+ */
+static size_t rtl8169_rx_poll(nic_t *nic_data, size_t budget)
+{
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+	size_t count;
+
+	pio_write_16(rtl8169->regs + ISR, INT_RX);
+	count = rtl8169_receive_done(nic_get_ddf_dev(nic_data), budget);
+
+	if (count >= budget) {
+		fibril_mutex_lock(&rtl8169->irq_lock);
+		rtl8169->int_mask = 0xffff & ~INT_RX;
+		pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
+		fibril_mutex_unlock(&rtl8169->irq_lock);
+	}
 
+	return count;
+}
+
+/** Unmask the receive interrupts once NICF stops polling the device
+ *
+ * @param nic_data NIC data
+ */
+static void rtl8169_rx_irq_enable(nic_t *nic_data)
+{
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	fibril_mutex_lock(&rtl8169->irq_lock);
+	rtl8169->int_mask = 0xffff;
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
+	fibril_mutex_unlock(&rtl8169->irq_lock);
 }
 
 static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
@@ -1040,9 +1118,17 @@ static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	uint16_t isr = (uint16_t) ipc_get_arg2(icall) & INT_KNOWN;
 	nic_t *nic_data = nic_get_from_ddf_dev(dev);
 	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+	uint16_t imr;
 
 	ddf_msg(LVL_DEBUG, "rtl8169_irq_handler(): isr=0x%04x", isr);
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
+
+	/* Receive interrupts stay masked while NICF polls the device */
+	fibril_mutex_lock(&rtl8169->irq_lock);
+	imr = rtl8169->int_mask;
+	pio_write_16(rtl8169->regs + IMR, imr);
+	fibril_mutex_unlock(&rtl8169->irq_lock);
+
+	isr &= imr;
 
 	while (isr != 0) {
 		ddf_msg(LVL_DEBUG, "irq handler: remaining isr=0x%04x", isr);
@@ -1059,26 +1145,21 @@ static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 			pio_write_16(rtl8169->regs + ISR, (INT_TER | INT_TOK | INT_TDU));
 		}
 
-		/* Receive underrun */
-		if (isr & INT_RXOVW) {
-			/* just ack.. */
-			pio_write_16(rtl8169->regs + ISR, INT_RXOVW);
-		}
-
 		if (isr & INT_SERR) {
 			ddf_msg(LVL_ERROR, "System error interrupt");
 			pio_write_16(rtl8169->regs + ISR, INT_SERR);
 		}
 
-		if (isr & (INT_RER | INT_ROK)) {
-			rtl8169_receive_done(dev);
-			pio_write_16(rtl8169->regs + ISR, (INT_RER | INT_ROK));
+		/* Receive notification or receive buffer overflow */
+		if (isr & INT_RX) {
+			if (nic_rx_interrupt(nic_data))
+				imr &= ~INT_RX;
 		}
 
-		isr = pio_read_16(rtl8169->regs + ISR) & INT_KNOWN;
+		isr = pio_read_16(rtl8169->regs + ISR) & INT_KNOWN & imr;
 	}
 
-	pio_write_16(rtl8169->regs + ISR, 0xffff);
+	pio_write_16(rtl8169->regs + ISR, imr);
 }
 
 static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size)
@@ -44,7 +44,13 @@
 #define	TX_RING_SIZE		(sizeof(rtl8169_descr_t) * TX_BUFFERS_COUNT)
 #define	RX_RING_SIZE		(sizeof(rtl8169_descr_t) * RX_BUFFERS_COUNT)
 #define	TX_BUFFERS_SIZE		(BUFFER_SIZE * TX_BUFFERS_COUNT)
-#define	RX_BUFFERS_SIZE		(BUFFER_SIZE * RX_BUFFERS_COUNT)
+#define	RX_POOL_SIZE		(2 * RX_BUFFERS_COUNT)
+
+/*
+ * Interrupt mitigation, four bits each for Tx timer, Tx frame count,
+ * Rx timer and Rx frame count thresholds
+ */
+#define	INTR_MITIGATE_DEFAULT	0x5151
 
 /** RTL8139 device data */
 typedef struct rtl8169_data {
@@ -63,6 +69,8 @@ typedef struct rtl8169_data {
 	uint16_t pci_pid;
 	/** Mask of the turned interupts (IMR value) */
 	uint16_t int_mask;
+	/** Lock for the interrupt mask */
+	fibril_mutex_t irq_lock;
 	/** TX ring */
 	uintptr_t tx_ring_phys;
 	rtl8169_descr_t *tx_ring;
@@ -76,9 +84,10 @@ typedef struct rtl8169_data {
 	/** TX buffers */
 	uintptr_t tx_buff_phys;
 	void *tx_buff;
-	/** RX buffers */
-	uintptr_t rx_buff_phys;
-	void *rx_buff;
+	/** RX buffers in the ring */
+	nic_frame_t *rx_frames[RX_BUFFERS_COUNT];
+	/** Pool of RX buffers, both in the ring and lent up the stack */
+	nic_frame_pool_t *rx_pool;
 	/** The nubmer of the next buffer to use, index = tx_next % TX_BUFF_COUNT */
 	size_t tx_next;
 	/** The number of the first used buffer in the row
@@ -32,9 +32,11 @@
 #include <stdint.h>
 
 #include <as.h>
+#include <byteorder.h>
 #include <ddf/driver.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
+#include <macros.h>
 #include <ops/nic.h>
 #include <pci_dev_iface.h>
 #include <nic/nic.h>
@@ -45,8 +47,6 @@
 
 #define NAME	"virtio-net"
 
-#define VIRTIO_NET_NUM_QUEUES	3
-
 #define RX_QUEUE_1	0
 #define TX_QUEUE_1	1
 #define CT_QUEUE_1	2
@@ -69,7 +69,112 @@ static driver_t virtio_net_driver = {
 	.driver_ops = &virtio_net_driver_ops
 };
 
-static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+/** Complete a partial checksum left to the driver by the device.
+ *
+ * The checksum field already holds the checksum of the pseudo-header.
+ *
+ * @param data   Frame
+ * @param size   Size of the frame
+ * @param start  Offset at which checksumming starts
+ * @param offset Offset of the checksum field from @a start
+ */
+static void virtio_net_csum_complete(uint8_t *data, size_t size,
+    uint16_t start, uint16_t offset)
+{
+	uint32_t sum = 0;
+	size_t i;
+
+	if (start >= size || size - start < (size_t) offset + 2) {
+		ddf_msg(LVL_WARN, "Bad partial checksum range");
+		return;
+	}
+
+	for (i = start; i + 1 < size; i += 2)
+		sum += ((uint32_t) data[i] << 8) | data[i + 1];
+	if (i < size)
+		sum += (uint32_t) data[i] << 8;
+
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	sum = ~sum & 0xffff;
+	data[start + offset] = sum >> 8;
+	data[start + offset + 1] = sum & 0xff;
+}
+
+/** Receive one frame, possibly spread over several buffers.
+ *
+ * @param nic    NIC
+ * @param descno First descriptor of the frame
+ * @param len    Number of bytes used in the first buffer
+ *
+ * @return Received frame or @c NULL if it was dropped
+ */
+static nic_frame_t *virtio_net_receive_frame(nic_t *nic, uint16_t descno,
+    uint32_t len)
+{
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	virtio_net_hdr_t *hdr =
+	    (virtio_net_hdr_t *) virtio_net->rx_buf[descno];
+	nic_frame_t *frame = NULL;
+	uint16_t nbufs = 1;
+
+	if (vdev->features & VIRTIO_NET_F_MRG_RXBUF)
+		nbufs = uint16_t_le2host(hdr->num_buffers);
+
+	uint8_t flags = hdr->flags;
+	uint16_t csum_start = uint16_t_le2host(hdr->csum_start);
+	uint16_t csum_offset = uint16_t_le2host(hdr->csum_offset);
+
+	if (len <= sizeof(*hdr) || len > RX_BUF_SIZE || nbufs == 0 ||
+	    nbufs > RX_BUFFERS) {
+		ddf_msg(LVL_WARN, "Bad RX buffer, packet dropped");
+		virtio_virtq_add_available(vdev, RX_QUEUE_1, descno);
+		return NULL;
+	}
+
+	/* Merged buffers carry no header of their own */
+	frame = nic_alloc_frame(nic, nbufs * RX_BUF_SIZE);
+	if (frame == NULL)
+		ddf_msg(LVL_WARN, "Cannot allocate RX frame, packet dropped");
+
+	size_t size = len - sizeof(*hdr);
+	if (frame != NULL)
+		memcpy(frame->data, &hdr[1], size);
+	virtio_virtq_add_available(vdev, RX_QUEUE_1, descno);
+
+	for (uint16_t i = 1; i < nbufs; i++) {
+		if (!virtio_virtq_consume_used(vdev, RX_QUEUE_1, &descno,
+		    &len)) {
+			ddf_msg(LVL_WARN, "Missing RX buffer, packet dropped");
+			nic_release_frame(nic, frame);
+			return NULL;
+		}
+
+		len = min(len, (uint32_t) RX_BUF_SIZE);
+		if (frame != NULL) {
+			memcpy((uint8_t *) frame->data + size,
+			    virtio_net->rx_buf[descno], len);
+		}
+		size += len;
+		virtio_virtq_add_available(vdev, RX_QUEUE_1, descno);
+	}
+
+	if (frame == NULL)
+		return NULL;
+
+	frame->size = size;
+
+	if (flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
+		virtio_net_csum_complete(frame->data, size, csum_start,
+		    csum_offset);
+	}
+
+	return frame;
+}
+
+static void virtio_net_rx_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 {
 	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = nic_get_specific(nic);
@@ -77,49 +182,99 @@ static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 
 	uint16_t descno;
 	uint32_t len;
+
+	/* Pass all frames received so far up the stack at once */
+	nic_frame_list_t *frames = nic_alloc_frame_list();
+
 	while (virtio_virtq_consume_used(vdev, RX_QUEUE_1, &descno, &len)) {
-		virtio_net_hdr_t *hdr =
-		    (virtio_net_hdr_t *) virtio_net->rx_buf[descno];
-		if (len <= sizeof(*hdr)) {
-			ddf_msg(LVL_WARN,
-			    "RX data length too short, packet dropped");
-			virtio_virtq_produce_available(vdev, RX_QUEUE_1,
-			    descno);
+		nic_frame_t *frame = virtio_net_receive_frame(nic, descno, len);
+		if (frame == NULL)
 			continue;
-		}
 
-		nic_frame_t *frame = nic_alloc_frame(nic, len - sizeof(*hdr));
-		if (frame) {
-			memcpy(frame->data, &hdr[1], len - sizeof(*hdr));
+		if (frames != NULL)
+			nic_frame_list_append(frames, frame);
+		else
 			nic_received_frame(nic, frame);
-		} else {
-			ddf_msg(LVL_WARN,
-			    "Cannot allocate RX frame, packet dropped");
-		}
-
-		virtio_virtq_produce_available(vdev, RX_QUEUE_1, descno);
 	}
 
+	/* Give the buffers back to the device with a single notification */
+	virtio_virtq_kick(vdev, RX_QUEUE_1);
+
+	nic_received_frame_list(nic, frames);
+}
+
+static void virtio_net_tx_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	nic_t *nic = ddf_dev_data_get(dev);
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	uint16_t descno;
+	uint32_t len;
+
 	while (virtio_virtq_consume_used(vdev, TX_QUEUE_1, &descno, &len)) {
 		virtio_free_desc(vdev, TX_QUEUE_1, &virtio_net->tx_free_head,
 		    descno);
 	}
+}
+
+static void virtio_net_ct_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	nic_t *nic = ddf_dev_data_get(dev);
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	uint16_t descno;
+	uint32_t len;
+
 	while (virtio_virtq_consume_used(vdev, CT_QUEUE_1, &descno, &len)) {
 		virtio_free_desc(vdev, CT_QUEUE_1, &virtio_net->ct_free_head,
 		    descno);
 	}
 }
 
+/** Handlers of the individual virtqueues' MSI-X vectors */
+static interrupt_handler_t *virtio_net_queue_irq_handler[] = {
+	[RX_QUEUE_1] = virtio_net_rx_irq_handler,
+	[TX_QUEUE_1] = virtio_net_tx_irq_handler,
+	[CT_QUEUE_1] = virtio_net_ct_irq_handler
+};
+
+/** INT#x is shared by all virtqueues */
+static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	virtio_net_rx_irq_handler(icall, dev);
+	virtio_net_tx_irq_handler(icall, dev);
+	virtio_net_ct_irq_handler(icall, dev);
+}
+
 static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
 {
 	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	errno_t rc;
+
+	/*
+	 * With a vector per virtqueue, receive and transmit completions are
+	 * told apart without reading the ISR status register.
+	 */
+	if (virtio_pci_msix_enable(vdev, VIRTIO_NET_NUM_QUEUES) == EOK) {
+		for (unsigned i = 0; i < VIRTIO_NET_NUM_QUEUES; i++) {
+			rc = virtio_pci_msix_register(dev, vdev, i,
+			    virtio_net_queue_irq_handler[i],
+			    &virtio_net->queue_irq_handle[i]);
+			if (rc != EOK)
+				return rc;
+		}
+
+		return EOK;
+	}
 
 	hw_res_list_parsed_t res;
 	hw_res_list_parsed_init(&res);
 
-	errno_t rc = nic_get_resources(nic, &res);
+	rc = nic_get_resources(nic, &res);
 	if (rc != EOK)
 		return rc;
 
@@ -185,6 +340,7 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		return rc;
 
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	vdev->packed = true;
 	virtio_pci_common_cfg_t *cfg = virtio_net->virtio_dev.common_cfg;
 	virtio_net_cfg_t *netcfg = virtio_net->virtio_dev.device_cfg;
 
@@ -197,7 +353,8 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 
 	/* Reset the device and negotiate the feature bits */
 	rc = virtio_device_setup_start(vdev,
-	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ);
+	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ, VIRTIO_NET_F_GUEST_CSUM |
+	    VIRTIO_NET_F_MRG_RXBUF | VIRTIO_RING_F_EVENT_IDX);
 	if (rc != EOK)
 		goto fail;
 
@@ -261,8 +418,9 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		 * Put the set descriptor into the available ring of the RX
 		 * queue.
 		 */
-		virtio_virtq_produce_available(vdev, RX_QUEUE_1, i);
+		virtio_virtq_add_available(vdev, RX_QUEUE_1, i);
 	}
+	virtio_virtq_kick(vdev, RX_QUEUE_1);
 
 	/*
 	 * Put all TX and CT buffers on a free list
@@ -287,14 +445,24 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/*
 	 * Enable IRQ
 	 */
-	rc = hw_res_enable_interrupt(ddf_dev_parent_sess_get(dev),
-	    virtio_net->irq);
+	if (vdev->msix_count > 0) {
+		for (unsigned i = 0; i < vdev->msix_count; i++) {
+			rc = hw_res_enable_interrupt(
+			    ddf_dev_parent_sess_get(dev), vdev->msix_irq + i);
+			if (rc != EOK)
+				break;
+		}
+	} else {
+		rc = hw_res_enable_interrupt(ddf_dev_parent_sess_get(dev),
+		    virtio_net->irq);
+	}
 	if (rc != EOK) {
 		ddf_msg(LVL_NOTE, "Failed to enable interrupt");
 		goto fail;
 	}
 
-	ddf_msg(LVL_NOTE, "Registered IRQ %d", virtio_net->irq);
+	if (vdev->msix_count == 0)
+		ddf_msg(LVL_NOTE, "Registered IRQ %d", virtio_net->irq);
 
 	/* Go live */
 	virtio_device_setup_finalize(vdev);
@@ -329,7 +497,7 @@ static void virtio_net_send(nic_t *nic, void *data, size_t size)
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
 
-	if (size > sizeof(virtio_net) + TX_BUF_SIZE) {
+	if (sizeof(virtio_net_hdr_t) + size > TX_BUF_SIZE) {
 		ddf_msg(LVL_WARN, "TX data too big, frame dropped");
 		return;
 	}
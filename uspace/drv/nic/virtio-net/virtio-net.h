@@ -33,7 +33,9 @@
 #include <abi/cap.h>
 #include <nic/nic.h>
 
-#define RX_BUFFERS	8
+#define VIRTIO_NET_NUM_QUEUES	3
+
+#define RX_BUFFERS	32
 #define TX_BUFFERS	8
 #define CT_BUFFERS	4
 
@@ -43,9 +45,16 @@
 #define VIRTIO_NET_F_GUEST_CSUM		(1U << 2)
 /** Device has given MAC address. */
 #define VIRTIO_NET_F_MAC		(1U << 5)
+/** Driver can merge receive buffers. */
+#define VIRTIO_NET_F_MRG_RXBUF		(1U << 15)
 /** Control channel is available */
 #define VIRTIO_NET_F_CTRL_VQ		(1U << 17)
 
+/** Checksum from csum_start to the end of the packet is to be completed */
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM	1
+/** Checksum of the packet has been validated by the device */
+#define VIRTIO_NET_HDR_F_DATA_VALID	2
+
 #define VIRTIO_NET_HDR_GSO_NONE 0
 typedef struct {
 	uint8_t flags;
@@ -75,6 +84,8 @@ typedef struct {
 
 	int irq;
 	cap_irq_handle_t irq_handle;
+	/** MSI-X vector handlers, if used instead of INT#x */
+	cap_irq_handle_t queue_irq_handle[VIRTIO_NET_NUM_QUEUES];
 } virtio_net_t;
 
 #endif
@@ -45,11 +45,19 @@
 #include <bithenge/blob.h>
 #include <bithenge/file.h>
 
+/** Size of the window of the file kept in memory by a file blob. */
+#define FILE_WINDOW_SIZE  4096
+
 typedef struct {
 	bithenge_blob_t base;
 	int fd;
 	aoff64_t size; // needed by file_read()
 	bool needs_close;
+	/** Offset of the data in @a window. */
+	aoff64_t window_start;
+	/** Amount of valid data in @a window. */
+	size_t window_size;
+	char window[FILE_WINDOW_SIZE];
 } file_blob_t;
 
 static inline file_blob_t *blob_as_file(bithenge_blob_t *base)
@@ -75,19 +83,54 @@ static errno_t file_read(bithenge_blob_t *base, aoff64_t offset, char *buffer,
 	file_blob_t *blob = blob_as_file(base);
 	if (offset > blob->size)
 		return ELIMIT;
+	*size = min(*size, blob->size - offset);
 
 	size_t amount_read;
-	errno_t rc = vfs_read(blob->fd, &offset, buffer, *size, &amount_read);
-	if (rc != EOK)
-		return errno;
-	*size += amount_read;
+	errno_t rc;
+	if (*size >= FILE_WINDOW_SIZE) {
+		rc = vfs_read(blob->fd, &offset, buffer, *size, &amount_read);
+		if (rc != EOK)
+			return rc;
+		*size = amount_read;
+		return EOK;
+	}
+
+	/*
+	 * Small reads, which are the common case when decoding, are served
+	 * from an aligned window of the file so that they do not each cost a
+	 * round trip to the file system.
+	 */
+	aoff64_t done = 0;
+	while (done < *size) {
+		aoff64_t pos = offset + done;
+		if (pos < blob->window_start ||
+		    pos >= blob->window_start + blob->window_size) {
+			aoff64_t start = pos - pos % FILE_WINDOW_SIZE;
+			blob->window_start = start;
+			blob->window_size = 0;
+			rc = vfs_read(blob->fd, &start, blob->window,
+			    FILE_WINDOW_SIZE, &amount_read);
+			if (rc != EOK)
+				return rc;
+			blob->window_size = amount_read;
+			if (pos >= blob->window_start + blob->window_size)
+				break;
+		}
+		size_t amount = min(*size - done,
+		    blob->window_start + blob->window_size - pos);
+		memcpy(buffer + done, blob->window + (pos - blob->window_start),
+		    amount);
+		done += amount;
+	}
+	*size = done;
 	return EOK;
 }
 
 static void file_destroy(bithenge_blob_t *base)
 {
 	file_blob_t *blob = blob_as_file(base);
-	vfs_put(blob->fd);
+	if (blob->needs_close)
+		vfs_put(blob->fd);
 	free(blob);
 }
 
@@ -130,6 +173,8 @@ static errno_t new_file_blob(bithenge_node_t **out, int fd, bool needs_close)
 	blob->size = stat.st_size;
 #endif
 	blob->needs_close = needs_close;
+	blob->window_start = 0;
+	blob->window_size = 0;
 	*out = bithenge_blob_as_node(file_as_blob(blob));
 
 	return EOK;
@@ -41,12 +41,14 @@
 #include <loc.h>
 #include <macros.h>
 #include <stdlib.h>
+#include <str.h>
 #include <bithenge/blob.h>
 #include "block.h"
 
 typedef struct {
 	bithenge_blob_t base;
 	service_id_t service_id;
+	size_t bsize;
 	aoff64_t size;
 } block_blob_t;
 
@@ -74,12 +76,35 @@ static errno_t block_read(bithenge_blob_t *base, aoff64_t offset, char *buffer,
 	if (offset > self->size)
 		return ELIMIT;
 	*size = min(*size, self->size - offset);
-	return block_read_bytes_direct(self->service_id, offset, *size, buffer);
+
+	/*
+	 * Go through the block cache, so that the many small reads done while
+	 * decoding only touch the device for the blocks they need, once.
+	 */
+	aoff64_t done = 0;
+	while (done < *size) {
+		aoff64_t ba = (offset + done) / self->bsize;
+		size_t boff = (offset + done) % self->bsize;
+		size_t amount = min(self->bsize - boff, *size - done);
+
+		block_t *block;
+		errno_t rc = block_get(&block, self->service_id, ba,
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			return rc;
+		memcpy(buffer + done, (char *)block->data + boff, amount);
+		rc = block_put(block);
+		if (rc != EOK)
+			return rc;
+		done += amount;
+	}
+	return EOK;
 }
 
 static void block_destroy(bithenge_blob_t *base)
 {
 	block_blob_t *self = blob_as_block(base);
+	block_cache_fini(self->service_id);
 	block_fini(self->service_id);
 	free(self);
 }
@@ -122,9 +147,16 @@ errno_t bithenge_new_block_blob(bithenge_node_t **out, service_id_t service_id)
 	}
 	size = bsize * nblocks;
 
+	rc = block_cache_init(service_id, bsize, 0, CACHE_MODE_WT);
+	if (rc != EOK) {
+		block_fini(service_id);
+		return rc;
+	}
+
 	// Create blob
 	block_blob_t *blob = malloc(sizeof(*blob));
 	if (!blob) {
+		block_cache_fini(service_id);
 		block_fini(service_id);
 		return ENOMEM;
 	}
@@ -132,10 +164,12 @@ errno_t bithenge_new_block_blob(bithenge_node_t **out, service_id_t service_id)
 	    &block_ops);
 	if (rc != EOK) {
 		free(blob);
+		block_cache_fini(service_id);
 		block_fini(service_id);
 		return rc;
 	}
 	blob->service_id = service_id;
+	blob->bsize = bsize;
 	blob->size = size;
 	*out = bithenge_blob_as_node(block_as_blob(blob));
 
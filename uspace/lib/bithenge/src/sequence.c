@@ -52,6 +52,11 @@ typedef struct {
 	size_t num_ends;
 	bool end_on_empty;
 	bithenge_int_t num_xforms;
+	/** Subtrees already decoded, indexed like @a ends. */
+	bithenge_node_t **children;
+	size_t num_children;
+	/** Whether decoded subtrees may be kept in @a children. */
+	bool memoize;
 } seq_node_t;
 
 typedef struct seq_node_ops {
@@ -133,9 +138,52 @@ static errno_t seq_node_field_offset(seq_node_t *self, aoff64_t *out, size_t ind
 	return EOK;
 }
 
+/** Remember a decoded subtree so it does not have to be decoded again when
+ * it is looked up later. Failure to remember it is not an error. */
+static void seq_node_memoize(seq_node_t *self, size_t index,
+    bithenge_node_t *node)
+{
+	if (!self->memoize)
+		return;
+	if (index >= self->num_children) {
+		size_t num = max(index + 1, 2 * self->num_children);
+		bithenge_node_t **children = realloc(self->children,
+		    num * sizeof(*children));
+		if (!children)
+			return;
+		for (size_t i = self->num_children; i < num; i++)
+			children[i] = NULL;
+		self->children = children;
+		self->num_children = num;
+	}
+	bithenge_node_inc_ref(node);
+	self->children[index] = node;
+}
+
+/** Drop all remembered subtrees and stop remembering new ones. Subtrees may
+ * refer back to this node through their scopes, so this must be done before
+ * the node decides who owns whom in its destructor. */
+static void seq_node_forget(seq_node_t *self)
+{
+	bithenge_node_t **children = self->children;
+	size_t num_children = self->num_children;
+	self->memoize = false;
+	self->children = NULL;
+	self->num_children = 0;
+	for (size_t i = 0; i < num_children; i++)
+		bithenge_node_dec_ref(children[i]);
+	free(children);
+}
+
 static errno_t seq_node_subtransform(seq_node_t *self, bithenge_node_t **out,
     size_t index)
 {
+	if (index < self->num_children && self->children[index]) {
+		bithenge_node_inc_ref(self->children[index]);
+		*out = self->children[index];
+		return EOK;
+	}
+
 	aoff64_t start_pos;
 	errno_t rc = seq_node_field_offset(self, &start_pos, index);
 	if (rc != EOK)
@@ -216,6 +264,7 @@ static errno_t seq_node_subtransform(seq_node_t *self, bithenge_node_t **out,
 			return rc;
 	}
 
+	seq_node_memoize(self, index, *out);
 	return EOK;
 }
 
@@ -234,6 +283,7 @@ static errno_t seq_node_complete(seq_node_t *self, bool *out)
 
 static void seq_node_destroy(seq_node_t *self)
 {
+	seq_node_forget(self);
 	bithenge_scope_dec_ref(self->scope);
 	bithenge_blob_dec_ref(self->blob);
 	free(self->ends);
@@ -266,6 +316,9 @@ static errno_t seq_node_init(seq_node_t *self, const seq_node_ops_t *ops,
 	self->num_xforms = num_xforms;
 	self->num_ends = 0;
 	self->end_on_empty = end_on_empty;
+	self->children = NULL;
+	self->num_children = 0;
+	self->memoize = true;
 	self->scope = scope;
 	if (self->scope)
 		bithenge_scope_inc_ref(self->scope);
@@ -415,6 +468,12 @@ static void struct_node_destroy(bithenge_node_t *base)
 {
 	struct_node_t *node = node_as_struct(base);
 
+	/*
+	 * Remembered fields hold references to the scope, which would look
+	 * like other users of it below.
+	 */
+	seq_node_forget(struct_as_seq(node));
+
 	/*
 	 * Treat the scope carefully because of the circular reference. In
 	 * struct_transform_make_node, things are set up so node owns a
@@ -54,24 +54,92 @@
 #include <str_error.h>
 #include <offset.h>
 #include <inttypes.h>
+#include <stdatomic.h>
+#include <time.h>
 #include "block.h"
 
 #define MAX_WRITE_RETRIES 10
 
+/*
+ * Readahead window bounds, in cache blocks. The upper bound has to stay well
+ * below CACHE_HI_WATERMARK, otherwise block_put() would free the prefetched
+ * blocks right away instead of keeping them on the free list.
+ */
+#define READAHEAD_MIN	2
+#define READAHEAD_MAX	8
+
+/*
+ * Number of cache shards. Blocks are distributed among the shards by their
+ * logical address so that block_get() and block_put() on different blocks
+ * rarely contend for the same lock. The cache watermarks apply to each shard.
+ */
+#define CACHE_SHARDS	4
+
+/*
+ * Write-back flusher tuning. The flusher fibril wakes up every FLUSH_INTERVAL
+ * or as soon as FLUSH_THRESHOLD dirty blocks were released to a shard and
+ * writes the unreferenced dirty blocks out in runs of at most FLUSH_RUN_MAX
+ * consecutive blocks, up to FLUSH_INFLIGHT runs at a time if the device
+ * can work on several requests at the same time. When recycling, up to VICTIM_SCAN blocks are looked at
+ * to find a clean block which can be reused without writing it back first.
+ */
+#define FLUSH_INTERVAL	SEC2USEC(1)
+#define FLUSH_THRESHOLD	8
+#define FLUSH_RUN_MAX	32
+#define FLUSH_INFLIGHT	4
+#define VICTIM_SCAN	4
+
+/*
+ * Largest buffer of zeroes written at once by block_write_zeroes() on devices
+ * which cannot zero blocks by themselves.
+ */
+#define ZERO_CHUNK_SIZE	(256 * 1024)
+
+/** Part of the block cache guarded by its own lock.
+ *
+ * Unreferenced blocks are kept on two LRU lists, as in the 2Q replacement
+ * algorithm. A block instantiated on a miss starts on the probation list
+ * and only moves to the hot list once it is found in the cache by another
+ * block_get(). Probation blocks are recycled first, so a long sequential
+ * scan keeps reusing its own blocks and does not push out metadata.
+ */
+typedef struct {
+	fibril_mutex_t lock;
+	hash_table_t block_hash;
+	list_t probation_list;    /**< Unreferenced blocks used once. */
+	list_t hot_list;          /**< Unreferenced blocks used repeatedly. */
+	size_t probation_count;   /**< Number of blocks on probation_list. */
+	size_t hot_count;         /**< Number of blocks on hot_list. */
+	unsigned blocks_cached;   /**< Number of cached blocks. */
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	unsigned dirty_puts;      /**< Dirty blocks released since last flush. */
+} cache_shard_t;
+
 /** Lock protecting the device connection list */
 static FIBRIL_MUTEX_INITIALIZE(dcl_lock);
 /** Device connection list head. */
 static LIST_INITIALIZE(dcl);
 
 typedef struct {
-	fibril_mutex_t lock;
 	size_t lblock_size;       /**< Logical block size. */
 	unsigned blocks_cluster;  /**< Physical blocks per block_t */
 	unsigned block_count;     /**< Total number of blocks. */
-	unsigned blocks_cached;   /**< Number of cached blocks. */
-	hash_table_t block_hash;
-	list_t free_list;
+	cache_shard_t shards[CACHE_SHARDS];
 	enum cache_mode mode;
+	fibril_mutex_t ra_lock;   /**< Lock protecting the readahead state. */
+	aoff64_t ra_next;         /**< Block expected next in a sequential scan. */
+	aoff64_t ra_mark;         /**< Hit that triggers the next readahead. */
+	size_t ra_window;         /**< Readahead window, 0 if not sequential. */
+	size_t ra_max;            /**< Largest readahead window. */
+	bool ra_pending;          /**< Readahead fibril is in flight. */
+	fibril_condvar_t ra_cv;   /**< Signalled when readahead finishes. */
+	fibril_mutex_t flush_lock; /**< Lock protecting the flusher state. */
+	fibril_condvar_t flush_cv; /**< Wakes the flusher, signals its exit. */
+	bool flush_kick;          /**< Flusher should run without waiting. */
+	bool flush_stop;          /**< Flusher should exit. */
+	bool flush_running;       /**< Flusher fibril exists. */
 } cache_t;
 
 typedef struct {
@@ -84,9 +152,39 @@ typedef struct {
 	aoff64_t pblocks;    /**< Number of physical blocks */
 	size_t pblock_size;  /**< Physical block size. */
 	cache_t *cache;
+	atomic_uint writes;  /**< Number of completed write requests. */
+	unsigned queue_depth; /**< Requests the device works on at a time. */
 } devcon_t;
 
+typedef struct {
+	devcon_t *devcon;
+	aoff64_t ba;         /**< First logical block to prefetch. */
+	size_t cnt;          /**< Number of logical blocks. */
+} readahead_t;
+
+/** Write-back of a run of consecutive blocks */
+typedef struct {
+	struct flush_ctx *ctx;
+	bd_req_t breq;
+	block_t *blocks[FLUSH_RUN_MAX];
+	size_t cnt;          /**< Number of blocks in the run. */
+	uint8_t *buf;        /**< Copy of the data of the blocks. */
+	bool busy;           /**< Run is being filled or written. */
+} flush_run_t;
+
+/** State of a cache_flush() pass */
+typedef struct flush_ctx {
+	devcon_t *devcon;
+	fibril_mutex_t lock; /**< Lock protecting the busy flags and rc. */
+	fibril_condvar_t cv; /**< Signalled when a run is written. */
+	flush_run_t runs[FLUSH_INFLIGHT];
+	size_t nruns;        /**< Number of usable entries in runs. */
+	errno_t rc;          /**< Error of the last failed write. */
+} flush_ctx_t;
+
 static errno_t read_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
+static errno_t cache_flush(devcon_t *, aoff64_t, aoff64_t);
+static errno_t flusher_fibril(void *);
 static errno_t write_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
 static aoff64_t ba_ltop(devcon_t *, aoff64_t);
 
@@ -106,7 +204,7 @@ static devcon_t *devcon_search(service_id_t service_id)
 }
 
 static errno_t devcon_add(service_id_t service_id, async_sess_t *sess,
-    size_t bsize, aoff64_t dev_size, bd_t *bd)
+    size_t bsize, aoff64_t dev_size, unsigned queue_depth, bd_t *bd)
 {
 	devcon_t *devcon;
 
@@ -123,6 +221,8 @@ static errno_t devcon_add(service_id_t service_id, async_sess_t *sess,
 	devcon->pblock_size = bsize;
 	devcon->pblocks = dev_size;
 	devcon->cache = NULL;
+	atomic_init(&devcon->writes, 0);
+	devcon->queue_depth = queue_depth;
 
 	fibril_mutex_lock(&dcl_lock);
 	list_foreach(dcl, link, devcon_t, d) {
@@ -176,7 +276,11 @@ errno_t block_init(service_id_t service_id, size_t comm_size)
 		return rc;
 	}
 
-	rc = devcon_add(service_id, sess, bsize, dev_size, bd);
+	unsigned queue_depth;
+	if (bd_get_queue_depth(bd, &queue_depth) != EOK || queue_depth == 0)
+		queue_depth = 1;
+
+	rc = devcon_add(service_id, sess, bsize, dev_size, queue_depth, bd);
 	if (rc != EOK) {
 		bd_close(bd);
 		async_hangup(sess);
@@ -267,6 +371,94 @@ static hash_table_ops_t cache_ops = {
 	.remove_callback = NULL
 };
 
+/** Get the cache shard a logical block belongs to. */
+static cache_shard_t *cache_shard(cache_t *cache, aoff64_t lba)
+{
+	return &cache->shards[lba % CACHE_SHARDS];
+}
+
+/** Get the least recently used block on a shard free list or NULL. */
+static block_t *shard_first_free(cache_shard_t *shard, list_t *list)
+{
+	link_t *link = list_first(list);
+
+	if (!link)
+		return NULL;
+	return list_get_instance(link, block_t, free_link);
+}
+
+/** Put an unreferenced block on the shard free list it belongs to. */
+static void shard_free_insert(cache_shard_t *shard, block_t *b)
+{
+	if (b->hot) {
+		list_append(&b->free_link, &shard->hot_list);
+		shard->hot_count++;
+	} else {
+		list_append(&b->free_link, &shard->probation_list);
+		shard->probation_count++;
+	}
+}
+
+/** Take a block off the shard free list it is on. */
+static void shard_free_remove(cache_shard_t *shard, block_t *b)
+{
+	list_remove(&b->free_link);
+	if (b->hot)
+		shard->hot_count--;
+	else
+		shard->probation_count--;
+}
+
+/** Get the least recently used clean block on a shard free list.
+ *
+ * Only the first VICTIM_SCAN blocks are looked at. If they are all dirty,
+ * the least recently used one is returned and needs to be written back.
+ * The dirty flags are read without the block locks, the caller has to
+ * check again.
+ */
+static block_t *shard_first_clean(cache_shard_t *shard, list_t *list)
+{
+	block_t *first = shard_first_free(shard, list);
+	unsigned scanned = 0;
+
+	list_foreach(*list, free_link, block_t, b) {
+		if (!b->dirty)
+			return b;
+		if (++scanned == VICTIM_SCAN)
+			break;
+	}
+
+	return first;
+}
+
+/** Choose the block to recycle next.
+ *
+ * Probation blocks are recycled as long as they make up more than a quarter
+ * of the unreferenced blocks, which gives a freshly read block a chance to
+ * be used again before it is thrown out.
+ *
+ * @return	Victim block or NULL if the shard has no unreferenced blocks.
+ */
+static block_t *shard_victim(cache_shard_t *shard)
+{
+	size_t total = shard->probation_count + shard->hot_count;
+
+	if (shard->probation_count > 0 &&
+	    (shard->probation_count > total / 4 || shard->hot_count == 0))
+		return shard_first_clean(shard, &shard->probation_list);
+
+	return shard_first_clean(shard, &shard->hot_list);
+}
+
+/** Make the flusher fibril run as soon as possible. */
+static void flusher_kick(cache_t *cache)
+{
+	fibril_mutex_lock(&cache->flush_lock);
+	cache->flush_kick = true;
+	fibril_condvar_broadcast(&cache->flush_cv);
+	fibril_mutex_unlock(&cache->flush_lock);
+}
+
 errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
     enum cache_mode mode)
 {
@@ -280,12 +472,21 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 	if (!cache)
 		return ENOMEM;
 
-	fibril_mutex_initialize(&cache->lock);
-	list_initialize(&cache->free_list);
 	cache->lblock_size = size;
 	cache->block_count = blocks;
-	cache->blocks_cached = 0;
 	cache->mode = mode;
+	fibril_mutex_initialize(&cache->ra_lock);
+	cache->ra_next = 0;
+	cache->ra_mark = 0;
+	cache->ra_window = 0;
+	cache->ra_max = READAHEAD_MAX;
+	cache->ra_pending = false;
+	fibril_condvar_initialize(&cache->ra_cv);
+	fibril_mutex_initialize(&cache->flush_lock);
+	fibril_condvar_initialize(&cache->flush_cv);
+	cache->flush_kick = false;
+	cache->flush_stop = false;
+	cache->flush_running = false;
 
 	/* Allow 1:1 or small-to-large block size translation */
 	if (cache->lblock_size % devcon->pblock_size != 0) {
@@ -295,12 +496,73 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 
 	cache->blocks_cluster = cache->lblock_size / devcon->pblock_size;
 
-	if (!hash_table_create(&cache->block_hash, 0, 0, &cache_ops)) {
-		free(cache);
-		return ENOMEM;
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_initialize(&shard->lock);
+		list_initialize(&shard->probation_list);
+		list_initialize(&shard->hot_list);
+		shard->probation_count = 0;
+		shard->hot_count = 0;
+		shard->blocks_cached = 0;
+		shard->hits = 0;
+		shard->misses = 0;
+		shard->evictions = 0;
+		shard->dirty_puts = 0;
+
+		if (!hash_table_create(&shard->block_hash, 0, 0, &cache_ops)) {
+			while (i-- > 0)
+				hash_table_destroy(&cache->shards[i].block_hash);
+			free(cache);
+			return ENOMEM;
+		}
 	}
 
 	devcon->cache = cache;
+
+	/*
+	 * In write-back mode, dirty blocks are written out in the background.
+	 * Should the flusher fail to start, they are still written back on
+	 * eviction and by block_sync_cache() and block_cache_fini().
+	 */
+	if (mode == CACHE_MODE_WB) {
+		fid_t fid = fibril_create(flusher_fibril, devcon);
+		if (fid) {
+			cache->flush_running = true;
+			fibril_add_ready(fid);
+		}
+	}
+
+	return EOK;
+}
+
+/** Set the largest readahead window of the block cache.
+ *
+ * Devices with a high access latency, such as optical drives or remote
+ * block devices, benefit from reading further ahead than the default.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param blocks	Largest number of logical blocks read ahead at once,
+ *			zero disables readahead.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
+errno_t block_cache_set_readahead(service_id_t service_id, size_t blocks)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	cache_t *cache;
+
+	if (!devcon)
+		return ENOENT;
+	if (!devcon->cache)
+		return EINVAL;
+	cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->ra_lock);
+	cache->ra_max = blocks;
+	cache->ra_window = min(cache->ra_window, blocks);
+	fibril_mutex_unlock(&cache->ra_lock);
+
 	return EOK;
 }
 
@@ -316,30 +578,51 @@ errno_t block_cache_fini(service_id_t service_id)
 		return EOK;
 	cache = devcon->cache;
 
+	/* Let an in-flight readahead finish before tearing the cache down. */
+	fibril_mutex_lock(&cache->ra_lock);
+	while (cache->ra_pending)
+		fibril_condvar_wait(&cache->ra_cv, &cache->ra_lock);
+	fibril_mutex_unlock(&cache->ra_lock);
+
+	fibril_mutex_lock(&cache->flush_lock);
+	cache->flush_stop = true;
+	fibril_condvar_broadcast(&cache->flush_cv);
+	while (cache->flush_running)
+		fibril_condvar_wait(&cache->flush_cv, &cache->flush_lock);
+	fibril_mutex_unlock(&cache->flush_lock);
+
+	/* Write the dirty blocks back in as few requests as possible. */
+	(void) cache_flush(devcon, 0, (aoff64_t) -1);
+
 	/*
 	 * We are expecting to find all blocks for this device handle on the
 	 * free list, i.e. the block reference count should be zero. Do not
 	 * bother with the cache and block locks because we are single-threaded.
 	 */
-	while (!list_empty(&cache->free_list)) {
-		block_t *b = list_get_instance(list_first(&cache->free_list),
-		    block_t, free_link);
-
-		list_remove(&b->free_link);
-		if (b->dirty) {
-			rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, b->size);
-			if (rc != EOK)
-				return rc;
-		}
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+		block_t *b;
+
+		while ((b = shard_first_free(shard, &shard->hot_list)) ||
+		    (b = shard_first_free(shard, &shard->probation_list))) {
+			shard_free_remove(shard, b);
+			if (b->dirty) {
+				rc = write_blocks(devcon, b->pba,
+				    cache->blocks_cluster, b->data, b->size);
+				if (rc != EOK)
+					return rc;
+			}
 
-		hash_table_remove_item(&cache->block_hash, &b->hash_link);
+			hash_table_remove_item(&shard->block_hash,
+			    &b->hash_link);
 
-		free(b->data);
-		free(b);
+			free(b->data);
+			free(b);
+		}
 	}
 
-	hash_table_destroy(&cache->block_hash);
+	for (unsigned i = 0; i < CACHE_SHARDS; i++)
+		hash_table_destroy(&cache->shards[i].block_hash);
 	devcon->cache = NULL;
 	free(cache);
 
@@ -348,11 +631,11 @@ errno_t block_cache_fini(service_id_t service_id)
 
 #define CACHE_LO_WATERMARK	10
 #define CACHE_HI_WATERMARK	20
-static bool cache_can_grow(cache_t *cache)
+static bool cache_can_grow(cache_shard_t *shard)
 {
-	if (cache->blocks_cached < CACHE_LO_WATERMARK)
+	if (shard->blocks_cached < CACHE_LO_WATERMARK)
 		return true;
-	if (!list_empty(&cache->free_list))
+	if (shard->probation_count + shard->hot_count > 0)
 		return false;
 	return true;
 }
@@ -364,55 +647,138 @@ static void block_initialize(block_t *b)
 	b->write_failures = 0;
 	b->dirty = false;
 	b->toxic = false;
+	b->hot = false;
+	b->prefetched = false;
 	fibril_rwlock_initialize(&b->contents_lock);
 	link_initialize(&b->free_link);
 }
 
+/** Origin of a block_get_internal() request. */
+typedef enum {
+	/** block_get(), feeds the readahead logic */
+	GET_SINGLE,
+	/** block_get_range() */
+	GET_RANGE,
+	/** Readahead fibril, does not count as a use of the block */
+	GET_READAHEAD
+} get_origin_t;
+
+static errno_t readahead_fibril(void *);
+
+/** Start prefetching a run of blocks into the cache.
+ *
+ * Must be called with the readahead lock held and no readahead pending.
+ *
+ * @param devcon	Device connection.
+ * @param ba		First block to prefetch (logical).
+ * @param cnt		Number of blocks to prefetch.
+ */
+static void readahead_start(devcon_t *devcon, aoff64_t ba, size_t cnt)
+{
+	cache_t *cache = devcon->cache;
+	readahead_t *ra;
+	fid_t fid;
+
+	assert(!cache->ra_pending);
+
+	/* Do not read past the end of the device. */
+	while (cnt > 0 && ba_ltop(devcon, ba + cnt - 1) +
+	    cache->blocks_cluster >= devcon->pblocks)
+		cnt--;
+	if (cnt == 0)
+		return;
+
+	ra = malloc(sizeof(readahead_t));
+	if (!ra)
+		return;
+	ra->devcon = devcon;
+	ra->ba = ba;
+	ra->cnt = cnt;
+
+	fid = fibril_create(readahead_fibril, ra);
+	if (!fid) {
+		free(ra);
+		return;
+	}
+
+	cache->ra_pending = true;
+	fibril_add_ready(fid);
+}
+
+/** Update the sequential access detector and start readahead if it fires.
+ *
+ * A miss on the block following the previous miss opens (or doubles) the
+ * readahead window and prefetches the blocks after the one being read. The
+ * first prefetched block serves as a mark: hitting it prefetches the next
+ * window before the scan gets there.
+ *
+ * @param devcon	Device connection.
+ * @param ba		Block being accessed (logical).
+ * @param hit		True if the block was found in the cache.
+ */
+static void readahead_update(devcon_t *devcon, aoff64_t ba, bool hit)
+{
+	cache_t *cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->ra_lock);
+
+	if (hit) {
+		if (cache->ra_window == 0 || ba != cache->ra_mark)
+			goto out;
+	} else if (ba != cache->ra_next) {
+		cache->ra_window = 0;
+		cache->ra_next = ba + 1;
+		goto out;
+	} else {
+		cache->ra_next = ba + 1;
+	}
+
+	if (cache->ra_pending || cache->ra_max == 0)
+		goto out;
+
+	if (cache->ra_window == 0)
+		cache->ra_window = min(READAHEAD_MIN, cache->ra_max);
+	else
+		cache->ra_window = min(2 * cache->ra_window, cache->ra_max);
+
+	cache->ra_mark = cache->ra_next;
+	readahead_start(devcon, cache->ra_next, cache->ra_window);
+	cache->ra_next += cache->ra_window;
+out:
+	fibril_mutex_unlock(&cache->ra_lock);
+}
+
 /** Instantiate a block in memory and get a reference to it.
  *
  * @param block			Pointer to where the function will store the
  * 				block pointer on success.
- * @param service_id		Service ID of the block device.
+ * @param devcon		Device connection.
  * @param ba			Block address (logical).
- * @param flags			If BLOCK_FLAGS_NOREAD is specified, block_get()
- * 				will not read the contents of the block from the
- *				device.
+ * @param flags			Flags as in block_get().
+ * @param src			If not NULL, contents of the block as read from
+ * 				the device by the caller.
+ * @param gen			Value of devcon->writes sampled before @a src
+ * 				was read. If any write completed since then,
+ * 				@a src may be stale and is ignored.
+ * @param origin		Which kind of request this is.
  *
  * @return			EOK on success or an error code.
  */
-errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int flags)
+static errno_t block_get_internal(block_t **block, devcon_t *devcon,
+    aoff64_t ba, int flags, const void *src, unsigned gen, get_origin_t origin)
 {
-	devcon_t *devcon;
-	cache_t *cache;
+	cache_t *cache = devcon->cache;
+	cache_shard_t *shard = cache_shard(cache, ba);
 	block_t *b;
-	link_t *link;
-	aoff64_t p_ba;
+	bool fill;
 	errno_t rc;
 
-	devcon = devcon_search(service_id);
-
-	assert(devcon);
-	assert(devcon->cache);
-
-	cache = devcon->cache;
-
-	/*
-	 * Check whether the logical block (or part of it) is beyond
-	 * the end of the device or not.
-	 */
-	p_ba = ba_ltop(devcon, ba);
-	p_ba += cache->blocks_cluster;
-	if (p_ba >= devcon->pblocks) {
-		/* This request cannot be satisfied */
-		return EIO;
-	}
-
 retry:
 	rc = EOK;
 	b = NULL;
 
-	fibril_mutex_lock(&cache->lock);
-	ht_link_t *hlink = hash_table_find(&cache->block_hash, &ba);
+	fibril_mutex_lock(&shard->lock);
+	ht_link_t *hlink = hash_table_find(&shard->block_hash, &ba);
 	if (hlink) {
 	found:
 		/*
@@ -421,16 +787,29 @@ retry:
 		b = hash_table_get_inst(hlink, block_t, hash_link);
 		fibril_mutex_lock(&b->lock);
 		if (b->refcnt++ == 0)
-			list_remove(&b->free_link);
+			shard_free_remove(shard, b);
 		if (b->toxic)
 			rc = EIO;
+		if (origin != GET_READAHEAD) {
+			/*
+			 * The first use of a prefetched block is the one it
+			 * was prefetched for, only later uses make it hot.
+			 */
+			if (b->prefetched)
+				b->prefetched = false;
+			else
+				b->hot = true;
+			shard->hits++;
+		}
 		fibril_mutex_unlock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		fibril_mutex_unlock(&shard->lock);
+		if (origin == GET_SINGLE)
+			readahead_update(devcon, ba, true);
 	} else {
 		/*
 		 * The block was not found in the cache.
 		 */
-		if (cache_can_grow(cache)) {
+		if (cache_can_grow(shard)) {
 			/*
 			 * We can grow the cache by allocating new blocks.
 			 * Should the allocation fail, we fail over and try to
@@ -445,19 +824,18 @@ retry:
 				b = NULL;
 				goto recycle;
 			}
-			cache->blocks_cached++;
+			shard->blocks_cached++;
 		} else {
 			/*
-			 * Try to recycle a block from the free list.
+			 * Try to recycle a block from the free lists.
 			 */
 		recycle:
-			if (list_empty(&cache->free_list)) {
-				fibril_mutex_unlock(&cache->lock);
+			b = shard_victim(shard);
+			if (!b) {
+				fibril_mutex_unlock(&shard->lock);
 				rc = ENOMEM;
 				goto out;
 			}
-			link = list_first(&cache->free_list);
-			b = list_get_instance(link, block_t, free_link);
 
 			fibril_mutex_lock(&b->lock);
 			if (b->dirty) {
@@ -470,9 +848,11 @@ retry:
 				 * do not slow down other instances of
 				 * block_get() draining the free list.
 				 */
-				list_remove(&b->free_link);
-				list_append(&b->free_link, &cache->free_list);
-				fibril_mutex_unlock(&cache->lock);
+				shard_free_remove(shard, b);
+				shard_free_insert(shard, b);
+				fibril_mutex_unlock(&shard->lock);
+				if (cache->flush_running)
+					flusher_kick(cache);
 				rc = write_blocks(devcon, b->pba,
 				    cache->blocks_cluster, b->data, b->size);
 				if (rc != EOK) {
@@ -496,7 +876,7 @@ retry:
 					b->write_failures = 0;
 
 				b->dirty = false;
-				if (!fibril_mutex_trylock(&cache->lock)) {
+				if (!fibril_mutex_trylock(&shard->lock)) {
 					/*
 					 * Somebody is probably racing with us.
 					 * Unlock the block and retry.
@@ -504,7 +884,7 @@ retry:
 					fibril_mutex_unlock(&b->lock);
 					goto retry;
 				}
-				hlink = hash_table_find(&cache->block_hash, &ba);
+				hlink = hash_table_find(&shard->block_hash, &ba);
 				if (hlink) {
 					/*
 					 * Someone else must have already
@@ -526,16 +906,23 @@ retry:
 			 * Unlink the block from the free list and the hash
 			 * table.
 			 */
-			list_remove(&b->free_link);
-			hash_table_remove_item(&cache->block_hash, &b->hash_link);
+			shard_free_remove(shard, b);
+			hash_table_remove_item(&shard->block_hash, &b->hash_link);
+			shard->evictions++;
 		}
 
 		block_initialize(b);
-		b->service_id = service_id;
+		b->service_id = devcon->service_id;
 		b->size = cache->lblock_size;
 		b->lba = ba;
 		b->pba = ba_ltop(devcon, b->lba);
-		hash_table_insert(&cache->block_hash, &b->hash_link);
+		hash_table_insert(&shard->block_hash, &b->hash_link);
+
+		fill = (src != NULL) && (atomic_load(&devcon->writes) == gen);
+		if (origin == GET_READAHEAD)
+			b->prefetched = true;
+		else
+			shard->misses++;
 
 		/*
 		 * Lock the block before releasing the cache lock. Thus we don't
@@ -543,9 +930,15 @@ retry:
 		 * the block.
 		 */
 		fibril_mutex_lock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		fibril_mutex_unlock(&shard->lock);
+
+		if (origin == GET_SINGLE && !(flags & BLOCK_FLAGS_NOREAD))
+			readahead_update(devcon, ba, false);
 
-		if (!(flags & BLOCK_FLAGS_NOREAD)) {
+		if (fill) {
+			memcpy(b->data, src, cache->lblock_size);
+			rc = EOK;
+		} else if (!(flags & BLOCK_FLAGS_NOREAD)) {
 			/*
 			 * The block contains old or no data. We need to read
 			 * the new contents from the device.
@@ -569,6 +962,199 @@ out:
 	return rc;
 }
 
+/** Instantiate a block in memory and get a reference to it.
+ *
+ * @param block			Pointer to where the function will store the
+ * 				block pointer on success.
+ * @param service_id		Service ID of the block device.
+ * @param ba			Block address (logical).
+ * @param flags			If BLOCK_FLAGS_NOREAD is specified, block_get()
+ * 				will not read the contents of the block from the
+ *				device.
+ *
+ * @return			EOK on success or an error code.
+ */
+errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int flags)
+{
+	devcon_t *devcon;
+	cache_t *cache;
+	aoff64_t p_ba;
+
+	devcon = devcon_search(service_id);
+
+	assert(devcon);
+	assert(devcon->cache);
+
+	cache = devcon->cache;
+
+	/*
+	 * Check whether the logical block (or part of it) is beyond
+	 * the end of the device or not.
+	 */
+	p_ba = ba_ltop(devcon, ba);
+	p_ba += cache->blocks_cluster;
+	if (p_ba >= devcon->pblocks) {
+		/* This request cannot be satisfied */
+		return EIO;
+	}
+
+	return block_get_internal(block, devcon, ba, flags, NULL, 0, GET_SINGLE);
+}
+
+/** Read a run of logical blocks from the device into a new buffer.
+ *
+ * @param devcon	Device connection.
+ * @param ba		First block (logical).
+ * @param cnt		Number of blocks.
+ * @param gen		Place to store devcon->writes as sampled before the
+ * 			read was issued.
+ *
+ * @return		Buffer with the data or NULL on failure.
+ */
+static void *read_range(devcon_t *devcon, aoff64_t ba, size_t cnt,
+    unsigned *gen)
+{
+	cache_t *cache = devcon->cache;
+	size_t size = cnt * cache->lblock_size;
+	void *buf;
+	errno_t rc;
+
+	buf = malloc(size);
+	if (!buf)
+		return NULL;
+
+	*gen = atomic_load(&devcon->writes);
+	rc = bd_read_blocks(devcon->bd, ba_ltop(devcon, ba),
+	    cnt * cache->blocks_cluster, buf, size);
+	if (rc != EOK) {
+		free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+/** Prefetch blocks into the cache in the background. */
+static errno_t readahead_fibril(void *arg)
+{
+	readahead_t *ra = arg;
+	devcon_t *devcon = ra->devcon;
+	cache_t *cache = devcon->cache;
+	uint8_t *buf;
+	unsigned gen;
+	block_t *b;
+
+	buf = read_range(devcon, ra->ba, ra->cnt, &gen);
+	if (buf) {
+		for (size_t i = 0; i < ra->cnt; i++) {
+			/* Not worth reading block by block if stale. */
+			if (atomic_load(&devcon->writes) != gen)
+				break;
+			if (block_get_internal(&b, devcon, ra->ba + i,
+			    BLOCK_FLAGS_NONE, buf + i * cache->lblock_size,
+			    gen, GET_READAHEAD) == EOK)
+				(void) block_put(b);
+		}
+		free(buf);
+	}
+
+	fibril_mutex_lock(&cache->ra_lock);
+	cache->ra_pending = false;
+	fibril_condvar_broadcast(&cache->ra_cv);
+	fibril_mutex_unlock(&cache->ra_lock);
+
+	free(ra);
+	return EOK;
+}
+
+/** Instantiate a run of consecutive blocks and get references to them.
+ *
+ * The blocks which are not in the cache yet are read from the device with
+ * a single request. Each block obtained this way must be released with
+ * block_put() as if it was obtained by block_get().
+ *
+ * @param blocks		Array of @a cnt entries where the function will
+ * 				store the block pointers on success.
+ * @param service_id		Service ID of the block device.
+ * @param ba			Address of the first block (logical).
+ * @param cnt			Number of blocks.
+ * @param flags			Flags as in block_get().
+ *
+ * @return			EOK on success or an error code. On failure,
+ *				no references are held.
+ */
+errno_t block_get_range(block_t **blocks, service_id_t service_id,
+    aoff64_t ba, size_t cnt, int flags)
+{
+	devcon_t *devcon;
+	cache_t *cache;
+	uint8_t *buf = NULL;
+	unsigned gen = 0;
+	size_t first;
+	size_t last;
+	errno_t rc = EOK;
+
+	devcon = devcon_search(service_id);
+
+	assert(devcon);
+	assert(devcon->cache);
+
+	cache = devcon->cache;
+
+	if (cnt == 0)
+		return EOK;
+
+	if (ba_ltop(devcon, ba + cnt - 1) + cache->blocks_cluster >=
+	    devcon->pblocks) {
+		/* This request cannot be satisfied */
+		return EIO;
+	}
+
+	/* Find the span of blocks that need to be read. */
+	first = cnt;
+	last = 0;
+	for (size_t i = 0; i < cnt; i++) {
+		aoff64_t lba = ba + i;
+		cache_shard_t *shard = cache_shard(cache, lba);
+		ht_link_t *hlink;
+
+		fibril_mutex_lock(&shard->lock);
+		hlink = hash_table_find(&shard->block_hash, &lba);
+		fibril_mutex_unlock(&shard->lock);
+
+		if (hlink == NULL) {
+			if (first == cnt)
+				first = i;
+			last = i;
+		}
+	}
+
+	/*
+	 * Should the bulk read fail, block_get_internal() falls back to
+	 * reading the blocks one by one and reports the error properly.
+	 */
+	if (first < cnt && !(flags & BLOCK_FLAGS_NOREAD))
+		buf = read_range(devcon, ba + first, last - first + 1, &gen);
+
+	for (size_t i = 0; i < cnt; i++) {
+		const void *src = NULL;
+
+		if (buf && i >= first && i <= last)
+			src = buf + (i - first) * cache->lblock_size;
+
+		rc = block_get_internal(&blocks[i], devcon, ba + i, flags,
+		    src, gen, GET_RANGE);
+		if (rc != EOK) {
+			while (i-- > 0)
+				(void) block_put(blocks[i]);
+			break;
+		}
+	}
+
+	free(buf);
+	return rc;
+}
+
 /** Release a reference to a block.
  *
  * If the last reference is dropped, the block is put on the free list.
@@ -581,8 +1167,10 @@ errno_t block_put(block_t *block)
 {
 	devcon_t *devcon = devcon_search(block->service_id);
 	cache_t *cache;
+	cache_shard_t *shard;
 	unsigned blocks_cached;
 	enum cache_mode mode;
+	bool kick = false;
 	errno_t rc = EOK;
 
 	assert(devcon);
@@ -590,19 +1178,20 @@ errno_t block_put(block_t *block)
 	assert(block->refcnt >= 1);
 
 	cache = devcon->cache;
+	shard = cache_shard(cache, block->lba);
 
 retry:
-	fibril_mutex_lock(&cache->lock);
-	blocks_cached = cache->blocks_cached;
+	fibril_mutex_lock(&shard->lock);
+	blocks_cached = shard->blocks_cached;
 	mode = cache->mode;
-	fibril_mutex_unlock(&cache->lock);
+	fibril_mutex_unlock(&shard->lock);
 
 	/*
 	 * Determine whether to sync the block. Syncing the block is best done
 	 * when not holding the cache lock as it does not impede concurrency.
-	 * Since the situation may have changed when we unlocked the cache, the
+	 * Since the situation may have changed when we unlocked the shard, the
 	 * blocks_cached and mode variables are mere hints. We will recheck the
-	 * conditions later when the cache lock is held again.
+	 * conditions later when the shard lock is held again.
 	 */
 	fibril_mutex_lock(&block->lock);
 	if (block->toxic)
@@ -617,7 +1206,7 @@ retry:
 	}
 	fibril_mutex_unlock(&block->lock);
 
-	fibril_mutex_lock(&cache->lock);
+	fibril_mutex_lock(&shard->lock);
 	fibril_mutex_lock(&block->lock);
 	if (!--block->refcnt) {
 		/*
@@ -625,7 +1214,7 @@ retry:
 		 * block or put it on the free list. In case of an I/O error,
 		 * free the block.
 		 */
-		if ((cache->blocks_cached > CACHE_HI_WATERMARK) ||
+		if ((shard->blocks_cached > CACHE_HI_WATERMARK) ||
 		    (rc != EOK)) {
 			/*
 			 * Currently there are too many cached blocks or there
@@ -642,7 +1231,7 @@ retry:
 				if (block->write_failures < MAX_WRITE_RETRIES) {
 					block->write_failures++;
 					fibril_mutex_unlock(&block->lock);
-					fibril_mutex_unlock(&cache->lock);
+					fibril_mutex_unlock(&shard->lock);
 					goto retry;
 				} else {
 					printf("Too many errors writing block %"
@@ -654,12 +1243,13 @@ retry:
 			/*
 			 * Take the block out of the cache and free it.
 			 */
-			hash_table_remove_item(&cache->block_hash, &block->hash_link);
+			hash_table_remove_item(&shard->block_hash, &block->hash_link);
+			shard->evictions++;
 			fibril_mutex_unlock(&block->lock);
 			free(block->data);
 			free(block);
-			cache->blocks_cached--;
-			fibril_mutex_unlock(&cache->lock);
+			shard->blocks_cached--;
+			fibril_mutex_unlock(&shard->lock);
 			return rc;
 		}
 		/*
@@ -672,17 +1262,361 @@ retry:
 			 */
 			block->refcnt++;
 			fibril_mutex_unlock(&block->lock);
-			fibril_mutex_unlock(&cache->lock);
+			fibril_mutex_unlock(&shard->lock);
 			goto retry;
 		}
-		list_append(&block->free_link, &cache->free_list);
+		if (block->dirty && ++shard->dirty_puts >= FLUSH_THRESHOLD) {
+			shard->dirty_puts = 0;
+			kick = true;
+		}
+		shard_free_insert(shard, block);
 	}
 	fibril_mutex_unlock(&block->lock);
-	fibril_mutex_unlock(&cache->lock);
+	fibril_mutex_unlock(&shard->lock);
+
+	if (kick && cache->flush_running)
+		flusher_kick(cache);
+
+	return rc;
+}
+
+/** Take references to the unreferenced dirty blocks on a free list.
+ *
+ * Must be called with the shard lock held. Blocks which are locked by
+ * somebody else are skipped.
+ *
+ * @param shard		Cache shard.
+ * @param list		Free list of the shard.
+ * @param first		First block of the range to collect (logical).
+ * @param last		Last block of the range to collect (logical).
+ * @param blocks	Array where to append the blocks.
+ * @param count		Number of blocks in @a blocks.
+ *
+ * @return		New number of blocks in @a blocks.
+ */
+static size_t shard_collect_dirty(cache_shard_t *shard, list_t *list,
+    aoff64_t first, aoff64_t last, block_t **blocks, size_t count)
+{
+	size_t start = count;
+
+	list_foreach(*list, free_link, block_t, b) {
+		if (b->dirty && b->lba >= first && b->lba <= last)
+			blocks[count++] = b;
+	}
+
+	for (size_t i = start; i < count; i++) {
+		block_t *b = blocks[i];
+
+		if (!fibril_mutex_trylock(&b->lock)) {
+			blocks[i--] = blocks[--count];
+			continue;
+		}
+		if (!b->dirty || b->toxic) {
+			fibril_mutex_unlock(&b->lock);
+			blocks[i--] = blocks[--count];
+			continue;
+		}
+		b->refcnt++;
+		shard_free_remove(shard, b);
+		fibril_mutex_unlock(&b->lock);
+	}
+
+	return count;
+}
+
+/** Copy a block into a write buffer if nobody else uses it.
+ *
+ * The block is marked clean before it is written so that any change made
+ * while the write is in progress marks it dirty again. Blocks referenced by
+ * somebody other than the flusher may be in the middle of being modified and
+ * are left alone.
+ *
+ * @return	True if the block was copied.
+ */
+static bool flush_take(block_t *b, uint8_t *buf)
+{
+	bool taken = false;
+
+	fibril_mutex_lock(&b->lock);
+	if (b->refcnt == 1 && b->dirty && !b->toxic) {
+		memcpy(buf, b->data, b->size);
+		b->dirty = false;
+		taken = true;
+	}
+	fibril_mutex_unlock(&b->lock);
+
+	return taken;
+}
+
+/** Finish the write-back of a run of blocks. */
+static void flush_done(flush_run_t *run, errno_t rc)
+{
+	flush_ctx_t *ctx = run->ctx;
+
+	for (size_t i = 0; i < run->cnt; i++) {
+		block_t *b = run->blocks[i];
+
+		fibril_mutex_lock(&b->lock);
+		if (rc == EOK) {
+			b->write_failures = 0;
+		} else {
+			b->dirty = true;
+			b->write_failures++;
+		}
+		fibril_mutex_unlock(&b->lock);
+	}
+
+	fibril_mutex_lock(&ctx->lock);
+	if (rc != EOK)
+		ctx->rc = rc;
+	run->busy = false;
+	fibril_condvar_broadcast(&ctx->cv);
+	fibril_mutex_unlock(&ctx->lock);
+}
+
+static void flush_write_cb(void *arg, errno_t rc)
+{
+	flush_run_t *run = arg;
+
+	atomic_fetch_add(&run->ctx->devcon->writes, 1);
+	flush_done(run, rc);
+}
+
+/** Start writing a run of blocks copied by flush_take().
+ *
+ * If the device can work on several requests at the same time, the run is
+ * written asynchronously. Otherwise, or if the run is too large for a single
+ * asynchronous request, it is written right away.
+ */
+static void flush_write(flush_run_t *run)
+{
+	devcon_t *devcon = run->ctx->devcon;
+	cache_t *cache = devcon->cache;
+	aoff64_t pba = run->blocks[0]->pba;
+	size_t cnt = run->cnt * cache->blocks_cluster;
+	size_t size = run->cnt * cache->lblock_size;
+
+	if (run->ctx->nruns > 1 && bd_write_blocks_async(devcon->bd,
+	    &run->breq, pba, cnt, run->buf, size, flush_write_cb, run) == EOK)
+		return;
+
+	flush_done(run, write_blocks(devcon, pba, cnt, run->buf, size));
+}
+
+/** Get a run which is not being written, waiting for one if necessary. */
+static flush_run_t *flush_get_run(flush_ctx_t *ctx)
+{
+	fibril_mutex_lock(&ctx->lock);
+
+	while (true) {
+		for (size_t i = 0; i < ctx->nruns; i++) {
+			flush_run_t *run = &ctx->runs[i];
+
+			if (!run->busy) {
+				run->busy = true;
+				run->cnt = 0;
+				fibril_mutex_unlock(&ctx->lock);
+				return run;
+			}
+		}
+
+		fibril_condvar_wait(&ctx->cv, &ctx->lock);
+	}
+}
+
+/** Compare blocks by their logical address, for qsort(). */
+static int block_lba_cmp(const void *a, const void *b)
+{
+	const block_t *ba = *(block_t * const *) a;
+	const block_t *bb = *(block_t * const *) b;
+
+	if (ba->lba < bb->lba)
+		return -1;
+	return (ba->lba > bb->lba) ? 1 : 0;
+}
+
+/** Write unreferenced dirty blocks back to the device.
+ *
+ * The blocks are sorted by their address and consecutive blocks are written
+ * with a single request.
+ *
+ * @param devcon	Device connection.
+ * @param first		First block of the range to write back (logical).
+ * @param last		Last block of the range to write back (logical).
+ *
+ * @return		EOK on success or an error code. Blocks which could
+ *			not be written stay dirty.
+ */
+static errno_t cache_flush(devcon_t *devcon, aoff64_t first, aoff64_t last)
+{
+	cache_t *cache = devcon->cache;
+	block_t **blocks = NULL;
+	size_t count = 0;
+	flush_ctx_t ctx;
+	flush_run_t *run;
+	errno_t rc = EOK;
+
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+		size_t nfree;
+
+		fibril_mutex_lock(&shard->lock);
+		shard->dirty_puts = 0;
+		nfree = shard->probation_count + shard->hot_count;
+		if (nfree > 0) {
+			block_t **nblocks = realloc(blocks,
+			    (count + nfree) * sizeof(block_t *));
+			if (!nblocks) {
+				fibril_mutex_unlock(&shard->lock);
+				rc = ENOMEM;
+				break;
+			}
+			blocks = nblocks;
+			count = shard_collect_dirty(shard, &shard->probation_list,
+			    first, last, blocks, count);
+			count = shard_collect_dirty(shard, &shard->hot_list,
+			    first, last, blocks, count);
+		}
+		fibril_mutex_unlock(&shard->lock);
+	}
 
+	ctx.devcon = devcon;
+	fibril_mutex_initialize(&ctx.lock);
+	fibril_condvar_initialize(&ctx.cv);
+	ctx.nruns = 0;
+	ctx.rc = EOK;
+
+	if (count > 0) {
+		size_t nruns = min(devcon->queue_depth, FLUSH_INFLIGHT);
+
+		while (ctx.nruns < nruns) {
+			run = &ctx.runs[ctx.nruns];
+			run->buf = malloc(FLUSH_RUN_MAX * cache->lblock_size);
+			if (!run->buf)
+				break;
+			run->ctx = &ctx;
+			run->cnt = 0;
+			run->busy = false;
+			ctx.nruns++;
+		}
+
+		if (ctx.nruns == 0)
+			rc = ENOMEM;
+	}
+
+	if (ctx.nruns > 0) {
+		qsort(blocks, count, sizeof(block_t *), block_lba_cmp);
+
+		run = flush_get_run(&ctx);
+		for (size_t i = 0; i < count; i++) {
+			block_t *b = blocks[i];
+
+			if (run->cnt > 0 && (run->cnt == FLUSH_RUN_MAX ||
+			    b->lba != run->blocks[run->cnt - 1]->lba + 1)) {
+				flush_write(run);
+				run = flush_get_run(&ctx);
+			}
+
+			if (flush_take(b, run->buf + run->cnt * cache->lblock_size)) {
+				run->blocks[run->cnt++] = b;
+			} else if (run->cnt > 0) {
+				flush_write(run);
+				run = flush_get_run(&ctx);
+			}
+		}
+
+		if (run->cnt > 0)
+			flush_write(run);
+		else
+			flush_done(run, EOK);
+
+		/* Wait for the asynchronous writes to finish. */
+		fibril_mutex_lock(&ctx.lock);
+		for (size_t i = 0; i < ctx.nruns; i++) {
+			while (ctx.runs[i].busy)
+				fibril_condvar_wait(&ctx.cv, &ctx.lock);
+		}
+		fibril_mutex_unlock(&ctx.lock);
+
+		if (ctx.rc != EOK)
+			rc = ctx.rc;
+	}
+
+	for (size_t i = 0; i < ctx.nruns; i++)
+		free(ctx.runs[i].buf);
+
+	for (size_t i = 0; i < count; i++)
+		(void) block_put(blocks[i]);
+
+	free(blocks);
 	return rc;
 }
 
+/** Write dirty blocks back in the background in write-back mode. */
+static errno_t flusher_fibril(void *arg)
+{
+	devcon_t *devcon = arg;
+	cache_t *cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->flush_lock);
+	while (!cache->flush_stop) {
+		if (!cache->flush_kick) {
+			(void) fibril_condvar_wait_timeout(&cache->flush_cv,
+			    &cache->flush_lock, FLUSH_INTERVAL);
+		}
+		if (cache->flush_stop)
+			break;
+		cache->flush_kick = false;
+
+		fibril_mutex_unlock(&cache->flush_lock);
+		(void) cache_flush(devcon, 0, (aoff64_t) -1);
+		fibril_mutex_lock(&cache->flush_lock);
+	}
+
+	cache->flush_running = false;
+	fibril_condvar_broadcast(&cache->flush_cv);
+	fibril_mutex_unlock(&cache->flush_lock);
+	return EOK;
+}
+
+/** Get cache statistics of a block device.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param stats		Place to store the statistics.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t block_cache_get_stats(service_id_t service_id,
+    block_cache_stats_t *stats)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	cache_t *cache;
+
+	if (!devcon)
+		return ENOENT;
+	if (!devcon->cache)
+		return ENOTSUP;
+	cache = devcon->cache;
+
+	stats->hits = 0;
+	stats->misses = 0;
+	stats->evictions = 0;
+	stats->blocks_cached = 0;
+
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_lock(&shard->lock);
+		stats->hits += shard->hits;
+		stats->misses += shard->misses;
+		stats->evictions += shard->evictions;
+		stats->blocks_cached += shard->blocks_cached;
+		fibril_mutex_unlock(&shard->lock);
+	}
+
+	return EOK;
+}
+
 /** Read sequential data from a block device.
  *
  * @param service_id	Service ID of the block device.
@@ -787,7 +1721,10 @@ errno_t block_write_direct(service_id_t service_id, aoff64_t ba, size_t cnt,
 	return write_blocks(devcon, ba, cnt, (void *)data, devcon->pblock_size * cnt);
 }
 
-/** Synchronize blocks to persistent storage.
+/** Set blocks on the device to zeroes (bypass cache).
+ *
+ * The device is asked to zero the blocks by itself first. If it cannot do
+ * that, buffers of zeroes are written instead.
  *
  * @param service_id	Service ID of the block device.
  * @param ba		Address of first block (physical).
@@ -795,13 +1732,78 @@ errno_t block_write_direct(service_id_t service_id, aoff64_t ba, size_t cnt,
  *
  * @return		EOK on success or an error code on failure.
  */
+errno_t block_write_zeroes(service_id_t service_id, aoff64_t ba, size_t cnt)
+{
+	devcon_t *devcon;
+	errno_t rc;
+
+	devcon = devcon_search(service_id);
+	assert(devcon);
+
+	if (cnt == 0)
+		return EOK;
+
+	rc = bd_write_zeroes(devcon->bd, ba, cnt);
+	if (rc != ENOTSUP)
+		return rc;
+
+	size_t chunk = max(ZERO_CHUNK_SIZE / devcon->pblock_size, (size_t) 1);
+	chunk = min(chunk, cnt);
+
+	void *zeroes = calloc(chunk, devcon->pblock_size);
+	if (zeroes == NULL)
+		return ENOMEM;
+
+	while (cnt > 0) {
+		size_t n = min(chunk, cnt);
+
+		rc = write_blocks(devcon, ba, n, zeroes,
+		    n * devcon->pblock_size);
+		if (rc != EOK)
+			break;
+
+		ba += n;
+		cnt -= n;
+	}
+
+	free(zeroes);
+	return rc;
+}
+
+/** Synchronize blocks to persistent storage.
+ *
+ * Unreferenced dirty blocks of the range held in the block cache are written
+ * back first.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param ba		Address of first block (physical).
+ * @param cnt		Number of blocks, zero for the whole device.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
 errno_t block_sync_cache(service_id_t service_id, aoff64_t ba, size_t cnt)
 {
 	devcon_t *devcon;
+	errno_t rc;
 
 	devcon = devcon_search(service_id);
 	assert(devcon);
 
+	if (devcon->cache) {
+		cache_t *cache = devcon->cache;
+		aoff64_t first = 0;
+		aoff64_t last = (aoff64_t) -1;
+
+		if (cnt > 0) {
+			first = ba / cache->blocks_cluster;
+			last = (ba + cnt - 1) / cache->blocks_cluster;
+		}
+
+		rc = cache_flush(devcon, first, last);
+		if (rc != EOK)
+			return rc;
+	}
+
 	return bd_sync_cache(devcon->bd, ba, cnt);
 }
 
@@ -837,6 +1839,41 @@ errno_t block_get_nblocks(service_id_t service_id, aoff64_t *nblocks)
 	return bd_get_num_blocks(devcon->bd, nblocks);
 }
 
+/** Get the number of requests the device can work on at the same time.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param depth		Output queue depth.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
+errno_t block_get_queue_depth(service_id_t service_id, unsigned *depth)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	assert(devcon);
+
+	*depth = devcon->queue_depth;
+	return EOK;
+}
+
+/** Get the session to the block device.
+ *
+ * The session can be used to forward block requests to the device.
+ * It remains valid until block_fini() is called.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param rsess		Output session.
+ *
+ * @return		EOK on success or an error code on failure.
+ */
+errno_t block_get_sess(service_id_t service_id, async_sess_t **rsess)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	assert(devcon);
+
+	*rsess = devcon->sess;
+	return EOK;
+}
+
 /** Read bytes directly from the device (bypass cache)
  *
  * @param service_id	Service ID of the block device.
@@ -870,6 +1907,10 @@ errno_t block_read_bytes_direct(service_id_t service_id, aoff64_t abs_offset,
 	blocks = last_block - first_block + 1;
 	buf_size = blocks * phys_block_size;
 
+	/* whole blocks can be read straight into the caller's buffer */
+	if (offset == 0 && bytes == buf_size)
+		return block_read_direct(service_id, first_block, blocks, data);
+
 	/* read the data into memory */
 	buffer = malloc(buf_size);
 	if (buffer == NULL) {
@@ -949,6 +1990,7 @@ static errno_t write_blocks(devcon_t *devcon, aoff64_t ba, size_t cnt, void *dat
 	assert(devcon);
 
 	errno_t rc = bd_write_blocks(devcon->bd, ba, cnt, data, size);
+	atomic_fetch_add(&devcon->writes, 1);
 	if (rc != EOK) {
 		printf("Error %s writing %zu blocks starting at block %" PRIuOFF64
 		    " to device handle %" PRIun "\n", str_error_name(rc), cnt, ba, devcon->service_id);
@@ -70,6 +70,10 @@ typedef struct block {
 	bool dirty;
 	/** If true, the blcok does not contain valid data. */
 	bool toxic;
+	/** If true, the block was used again while it was cached. */
+	bool hot;
+	/** If true, the block was read ahead and not used yet. */
+	bool prefetched;
 	/** Readers / Writer lock protecting the contents of the block. */
 	fibril_rwlock_t contents_lock;
 	/** Service ID of service providing the block device. */
@@ -98,6 +102,18 @@ enum cache_mode {
 	CACHE_MODE_WB
 };
 
+/** Block cache statistics */
+typedef struct {
+	/** Number of requests satisfied from the cache */
+	uint64_t hits;
+	/** Number of requests that had to instantiate the block */
+	uint64_t misses;
+	/** Number of blocks dropped from the cache */
+	uint64_t evictions;
+	/** Number of blocks currently cached */
+	unsigned blocks_cached;
+} block_cache_stats_t;
+
 extern errno_t block_init(service_id_t, size_t);
 extern void block_fini(service_id_t);
 
@@ -106,8 +122,11 @@ extern void *block_bb_get(service_id_t);
 
 extern errno_t block_cache_init(service_id_t, size_t, unsigned, enum cache_mode);
 extern errno_t block_cache_fini(service_id_t);
+extern errno_t block_cache_set_readahead(service_id_t, size_t);
+extern errno_t block_cache_get_stats(service_id_t, block_cache_stats_t *);
 
 extern errno_t block_get(block_t **, service_id_t, aoff64_t, int);
+extern errno_t block_get_range(block_t **, service_id_t, aoff64_t, size_t, int);
 extern errno_t block_put(block_t *);
 
 extern errno_t block_seqread(service_id_t, void *, size_t *, size_t *, aoff64_t *,
@@ -115,10 +134,13 @@ extern errno_t block_seqread(service_id_t, void *, size_t *, size_t *, aoff64_t
 
 extern errno_t block_get_bsize(service_id_t, size_t *);
 extern errno_t block_get_nblocks(service_id_t, aoff64_t *);
+extern errno_t block_get_queue_depth(service_id_t, unsigned *);
+extern errno_t block_get_sess(service_id_t, async_sess_t **);
 extern errno_t block_read_toc(service_id_t, uint8_t, void *, size_t);
 extern errno_t block_read_direct(service_id_t, aoff64_t, size_t, void *);
 extern errno_t block_read_bytes_direct(service_id_t, aoff64_t, size_t, void *);
 extern errno_t block_write_direct(service_id_t, aoff64_t, size_t, const void *);
+extern errno_t block_write_zeroes(service_id_t, aoff64_t, size_t);
 extern errno_t block_sync_cache(service_id_t, aoff64_t, size_t);
 
 #endif
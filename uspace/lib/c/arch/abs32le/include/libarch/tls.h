@@ -39,6 +39,7 @@
 
 #include <libc.h>
 #include <stddef.h>
+#include <types/tls.h>
 
 /* Some architectures store the value with an offset. Some do not. */
 #define ARCH_TP_OFFSET 0
@@ -46,6 +47,7 @@
 typedef struct {
 	void *self;
 	void *fibril_data;
+	tls_slot_t slots[TLS_SLOT_COUNT];
 } tcb_t;
 
 static inline void __tcb_raw_set(void *tls)
@@ -38,6 +38,15 @@
 #define PAGE_WIDTH	12
 #define PAGE_SIZE	(1 << PAGE_WIDTH)
 
+/** memset() and memcpy() are provided by arch/amd64/src/mem.c */
+#define MEMFNC_ARCH
+
+/** compute_crc32c() can use arch/amd64/src/checksum.c */
+#define CRC32C_ARCH
+
+/** The cycle counter is read by arch_cycle_get() in libarch/cycle.h */
+#define CYCLE_ARCH
+
 #endif
 
 /** @}
@@ -0,0 +1 @@
+../../../ia32/include/libarch/cycle.h
\ No newline at end of file
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ * @brief CRC32C using the SSE4.2 crc32 instruction.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../../../generic/private/checksum.h"
+
+#define CPUID_FEATURES  1
+#define CPUID_SSE42     (1 << 20)
+
+bool __crc32c_arch_avail = false;
+
+void __crc32c_init(void)
+{
+	uint32_t eax;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+
+	asm volatile (
+	    "cpuid\n"
+	    : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+	    : "a" (CPUID_FEATURES), "c" (0)
+	);
+
+	__crc32c_arch_avail = (ecx & CPUID_SSE42) != 0;
+}
+
+/** Update an (inverted) CRC32C value.
+ *
+ * @param crc    Current CRC value.
+ * @param data   Data to process.
+ * @param length Length of the data in bytes.
+ *
+ * @return Updated CRC value.
+ *
+ */
+uint32_t __crc32c_arch(uint32_t crc, const uint8_t *data, size_t length)
+{
+	uint64_t crc64 = crc;
+
+	while (length >= sizeof(uint64_t)) {
+		uint64_t word;
+		__builtin_memcpy(&word, data, sizeof(word));
+
+		asm (
+		    "crc32q %[word], %[crc]\n"
+		    : [crc] "+r" (crc64)
+		    : [word] "rm" (word)
+		);
+
+		data += sizeof(uint64_t);
+		length -= sizeof(uint64_t);
+	}
+
+	crc = (uint32_t) crc64;
+
+	while (length-- > 0) {
+		asm (
+		    "crc32b %[byte], %[crc]\n"
+		    : [crc] "+r" (crc)
+		    : [byte] "rm" (*(data++))
+		);
+	}
+
+	return crc;
+}
+
+/** @}
+ */
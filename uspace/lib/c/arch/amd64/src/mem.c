@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ * @brief Memory string functions.
+ *
+ * Blocks of moderate size are copied and filled by the string
+ * instructions, which are the fastest method on processors with ERMS.
+ * Copies of large blocks use non-temporal SSE2 stores so that they do not
+ * evict the whole cache. The implementation is selected once, when the
+ * task starts, based on the CPUID feature bits.
+ */
+
+#include <mem.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../../../generic/private/cc.h"
+#include "../../../generic/private/mem.h"
+
+/** Blocks shorter than this are handled by a plain loop. */
+#define MEM_SMALL  32
+
+/** Blocks at least this long are copied using non-temporal stores. */
+#define MEM_NONTEMPORAL  (512 * 1024)
+
+#define CPUID_STRUCTURED  7
+#define CPUID_ERMS        (1 << 9)
+
+/** The processor has fast rep movsb and rep stosb (ERMS). */
+static bool mem_erms = false;
+
+void __mem_init(void)
+{
+	uint32_t max_level;
+	uint32_t ebx;
+	uint32_t ecx;
+	uint32_t edx;
+
+	asm volatile (
+	    "cpuid\n"
+	    : "=a" (max_level), "=b" (ebx), "=c" (ecx), "=d" (edx)
+	    : "a" (0), "c" (0)
+	);
+
+	if (max_level < CPUID_STRUCTURED)
+		return;
+
+	uint32_t eax;
+	asm volatile (
+	    "cpuid\n"
+	    : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+	    : "a" (CPUID_STRUCTURED), "c" (0)
+	);
+
+	mem_erms = (ebx & CPUID_ERMS) != 0;
+}
+
+static inline void mem_movs(void *dst, const void *src, size_t n)
+{
+	if (mem_erms) {
+		asm volatile (
+		    "rep movsb\n"
+		    : "+D" (dst), "+S" (src), "+c" (n)
+		    :
+		    : "memory"
+		);
+
+		return;
+	}
+
+	size_t qwords = n / sizeof(uint64_t);
+
+	asm volatile (
+	    "rep movsq\n"
+	    "movq %[rest], %%rcx\n"
+	    "rep movsb\n"
+	    : "+D" (dst), "+S" (src), "+c" (qwords)
+	    : [rest] "r" (n % sizeof(uint64_t))
+	    : "memory"
+	);
+}
+
+/** Copy 64-byte blocks to a 16-byte aligned destination bypassing cache */
+static inline void mem_copy_nontemporal(void *dst, const void *src,
+    size_t blocks)
+{
+	asm volatile (
+	    "1:\n"
+	    "movdqu 0(%[src]), %%xmm0\n"
+	    "movdqu 16(%[src]), %%xmm1\n"
+	    "movdqu 32(%[src]), %%xmm2\n"
+	    "movdqu 48(%[src]), %%xmm3\n"
+	    "movntdq %%xmm0, 0(%[dst])\n"
+	    "movntdq %%xmm1, 16(%[dst])\n"
+	    "movntdq %%xmm2, 32(%[dst])\n"
+	    "movntdq %%xmm3, 48(%[dst])\n"
+	    "addq $64, %[src]\n"
+	    "addq $64, %[dst]\n"
+	    "decq %[blocks]\n"
+	    "jnz 1b\n"
+	    "sfence\n"
+	    : [dst] "+r" (dst), [src] "+r" (src), [blocks] "+r" (blocks)
+	    :
+	    : "memory", "xmm0", "xmm1", "xmm2", "xmm3"
+	);
+}
+
+/** Fill memory block with a constant value. */
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    void *memset(void *dest, int b, size_t n)
+{
+	void *dp = dest;
+
+	if (n < MEM_SMALL) {
+		uint8_t *bp = dest;
+
+		while (n-- != 0)
+			*bp++ = b;
+
+		return dest;
+	}
+
+	if (mem_erms) {
+		asm volatile (
+		    "rep stosb\n"
+		    : "+D" (dp), "+c" (n)
+		    : "a" (b)
+		    : "memory"
+		);
+
+		return dest;
+	}
+
+	uint64_t pattern = UINT64_C(0x0101010101010101) * (uint8_t) b;
+	size_t qwords = n / sizeof(uint64_t);
+
+	asm volatile (
+	    "rep stosq\n"
+	    "movq %[rest], %%rcx\n"
+	    "rep stosb\n"
+	    : "+D" (dp), "+c" (qwords)
+	    : "a" (pattern), [rest] "r" (n % sizeof(uint64_t))
+	    : "memory"
+	);
+
+	return dest;
+}
+
+/** Copy memory block. */
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    void *memcpy(void *dst, const void *src, size_t n)
+{
+	uint8_t *dp = dst;
+	const uint8_t *sp = src;
+
+	if (n < MEM_SMALL) {
+		while (n-- != 0)
+			*dp++ = *sp++;
+
+		return dst;
+	}
+
+	if (n >= MEM_NONTEMPORAL) {
+		size_t head = (-(uintptr_t) dp) & 15;
+		mem_movs(dp, sp, head);
+		dp += head;
+		sp += head;
+		n -= head;
+
+		size_t blocks = n / 64;
+		mem_copy_nontemporal(dp, sp, blocks);
+		dp += blocks * 64;
+		sp += blocks * 64;
+		n -= blocks * 64;
+	}
+
+	mem_movs(dp, sp, n);
+	return dst;
+}
+
+/** @}
+ */
@@ -37,6 +37,7 @@
 #define _LIBC_arm32_TLS_H_
 
 #include <stdint.h>
+#include <types/tls.h>
 
 #define CONFIG_TLS_VARIANT_1
 
@@ -48,6 +49,7 @@
  *  TLS starts just after this struct.
  */
 typedef struct {
+	tls_slot_t slots[TLS_SLOT_COUNT];
 	void **dtv;
 	void *pad;
 	/** Fibril data. */
@@ -41,6 +41,9 @@
 #define USER_ADDRESS_SPACE_START_ARCH  UINT32_C(0x00000000)
 #define USER_ADDRESS_SPACE_END_ARCH    UINT32_C(0x7fffffff)
 
+/** The cycle counter is read by arch_cycle_get() in libarch/cycle.h */
+#define CYCLE_ARCH
+
 #endif
 
 /** @}
@@ -40,11 +40,13 @@
 #define ARCH_TP_OFFSET 0
 
 #include <libc.h>
+#include <types/tls.h>
 
 typedef struct {
 	void *self;
 	void *fibril_data;
 	void **dtv;
+	tls_slot_t slots[TLS_SLOT_COUNT];
 } tcb_t;
 
 static inline void __tcb_raw_set(void *tls)
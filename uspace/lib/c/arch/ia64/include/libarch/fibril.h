@@ -61,7 +61,7 @@
 		(c)->sp = ((uint64_t) stack) + \
 		    ALIGN_UP((size / FIBRIL_INITIAL_STACK_DIVISION), STACK_ALIGNMENT) - \
 		    SP_DELTA; \
-		(c)->tp = (uint64_t) tls; \
+		(c)->tp = ((uint64_t) tls) + ARCH_TP_OFFSET; \
 	} while (0)
 
 static inline uintptr_t _context_get_fp(context_t *ctx)
@@ -37,10 +37,13 @@
 
 #define CONFIG_TLS_VARIANT_1
 
-#define ARCH_TP_OFFSET 0
+#include <types/tls.h>
+
+/* The thread pointer points to the last 16 bytes of the TCB */
+#define ARCH_TP_OFFSET (sizeof(tcb_t) - 16)
 
-/* This structure must be exactly 16 bytes long */
 typedef struct {
+	tls_slot_t slots[TLS_SLOT_COUNT];
 	void *dtv; /* unused in static linking*/
 	void *fibril_data;
 } tcb_t;
@@ -46,6 +46,7 @@
 #define CONFIG_TLS_VARIANT_1
 
 #include <libc.h>
+#include <types/tls.h>
 
 /*
  * I did not find any specification (neither MIPS nor PowerPC), but
@@ -63,6 +64,7 @@
 #define ARCH_TP_OFFSET (0x7000 + sizeof(tcb_t))
 
 typedef struct {
+	tls_slot_t slots[TLS_SLOT_COUNT];
 	void *fibril_data;
 } tcb_t;
 
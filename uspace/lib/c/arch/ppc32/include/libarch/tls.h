@@ -38,10 +38,12 @@
 #define CONFIG_TLS_VARIANT_1
 
 #include <libc.h>
+#include <types/tls.h>
 
 #define ARCH_TP_OFFSET (0x7000 + sizeof(tcb_t))
 
 typedef struct {
+	tls_slot_t slots[TLS_SLOT_COUNT];
 	void **dtv;
 	void *pad;
 	void *fibril_data;
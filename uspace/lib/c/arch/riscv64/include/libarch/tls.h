@@ -38,6 +38,7 @@
 #define CONFIG_TLS_VARIANT_2
 
 #include <libc.h>
+#include <types/tls.h>
 
 /* Some architectures store the value with an offset. Some do not. */
 #define ARCH_TP_OFFSET 0
@@ -45,6 +46,7 @@
 typedef struct {
 	void *self;
 	void *fibril_data;
+	tls_slot_t slots[TLS_SLOT_COUNT];
 } tcb_t;
 
 static inline void __tcb_raw_set(void *tls)
@@ -42,11 +42,14 @@
 
 #define ARCH_TP_OFFSET 0
 
+#include <types/tls.h>
+
 typedef struct {
 	void *self;
 	void *fibril_data;
 	void **dtv;
 	void *pad;
+	tls_slot_t slots[TLS_SLOT_COUNT];
 } tcb_t;
 
 static inline void __tcb_raw_set(void *tcb)
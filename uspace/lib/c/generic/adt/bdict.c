@@ -0,0 +1,1015 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+
+/** @file B+tree dictionary.
+ *
+ * Ordered dictionary of integer keys kept in a B+tree. Unlike odict,
+ * the keys are stored in the tree nodes themselves, so that a lookup
+ * touches a few cache lines per level instead of one entry per level.
+ * Values are stored in the leaves, which are chained for iteration.
+ *
+ * Keys are unique. Any modification of the dictionary invalidates all
+ * positions (bdpos_t) within it.
+ */
+
+#include <adt/bdict.h>
+#include <assert.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static bdict_node_t *bdict_node_create(bool leaf)
+{
+	bdict_node_t *node = calloc(1, sizeof(bdict_node_t));
+	if (node == NULL)
+		return NULL;
+
+	node->leaf = leaf;
+	return node;
+}
+
+static void bdict_free_subtree(bdict_node_t *node)
+{
+	if (!node->leaf) {
+		for (unsigned int i = 0; i <= node->nkeys; i++)
+			bdict_free_subtree(node->child[i]);
+	}
+
+	free(node);
+}
+
+/** Return the number of keys in @a node less than @a key. */
+static unsigned int bdict_lower_bound(bdict_node_t *node, bdkey_t key)
+{
+	unsigned int lo = 0;
+	unsigned int hi = node->nkeys;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+		if (node->key[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/** Return the number of keys in @a node less than or equal to @a key. */
+static unsigned int bdict_upper_bound(bdict_node_t *node, bdkey_t key)
+{
+	unsigned int lo = 0;
+	unsigned int hi = node->nkeys;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+		if (node->key[mid] <= key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/** Descend to the leaf that holds or would hold @a key.
+ *
+ * @param bdict B+tree dictionary, not empty
+ * @param key   Key
+ * @param path  If not NULL, inner nodes visited on the way down
+ * @param pidx  If not NULL, child chosen in each of the inner nodes
+ * @return Leaf node
+ */
+static bdict_node_t *bdict_descend(bdict_t *bdict, bdkey_t key,
+    bdict_node_t **path, unsigned int *pidx)
+{
+	bdict_node_t *node = bdict->root;
+	unsigned int level = 0;
+
+	while (!node->leaf) {
+		unsigned int i = bdict_upper_bound(node, key);
+		if (path != NULL) {
+			path[level] = node;
+			pidx[level] = i;
+		}
+
+		level++;
+		node = node->child[i];
+	}
+
+	return node;
+}
+
+/** Initialize B+tree dictionary.
+ *
+ * @param bdict B+tree dictionary
+ */
+void bdict_initialize(bdict_t *bdict)
+{
+	bdict->root = NULL;
+	bdict->depth = 0;
+	bdict->count = 0;
+}
+
+/** Finalize B+tree dictionary.
+ *
+ * Frees all nodes. The values are left alone.
+ *
+ * @param bdict B+tree dictionary
+ */
+void bdict_finalize(bdict_t *bdict)
+{
+	if (bdict->root != NULL)
+		bdict_free_subtree(bdict->root);
+
+	bdict_initialize(bdict);
+}
+
+static void bdict_leaf_insert_at(bdict_node_t *leaf, unsigned int i,
+    bdkey_t key, void *value)
+{
+	unsigned int n = leaf->nkeys - i;
+
+	memmove(&leaf->key[i + 1], &leaf->key[i], n * sizeof(bdkey_t));
+	memmove(&leaf->value[i + 1], &leaf->value[i], n * sizeof(void *));
+	leaf->key[i] = key;
+	leaf->value[i] = value;
+	leaf->nkeys++;
+}
+
+static void bdict_inner_insert_at(bdict_node_t *node, unsigned int i,
+    bdkey_t key, bdict_node_t *right)
+{
+	unsigned int n = node->nkeys - i;
+
+	memmove(&node->key[i + 1], &node->key[i], n * sizeof(bdkey_t));
+	memmove(&node->child[i + 2], &node->child[i + 1],
+	    n * sizeof(bdict_node_t *));
+	node->key[i] = key;
+	node->child[i + 1] = right;
+	node->nkeys++;
+}
+
+/** Insert into a full leaf, moving the upper half to a new leaf.
+ *
+ * @param leaf  Full leaf
+ * @param right Empty leaf to become the right neighbour of @a leaf
+ * @param i     Position of the new entry
+ * @param key   Key
+ * @param value Value
+ */
+static void bdict_leaf_split(bdict_node_t *leaf, bdict_node_t *right,
+    unsigned int i, bdkey_t key, void *value)
+{
+	bdkey_t keys[BDICT_MAX_KEYS + 1];
+	void *values[BDICT_MAX_KEYS + 1];
+	unsigned int nleft = (BDICT_MAX_KEYS + 1) / 2;
+
+	memcpy(keys, leaf->key, i * sizeof(bdkey_t));
+	memcpy(values, leaf->value, i * sizeof(void *));
+	keys[i] = key;
+	values[i] = value;
+	memcpy(&keys[i + 1], &leaf->key[i],
+	    (BDICT_MAX_KEYS - i) * sizeof(bdkey_t));
+	memcpy(&values[i + 1], &leaf->value[i],
+	    (BDICT_MAX_KEYS - i) * sizeof(void *));
+
+	leaf->nkeys = nleft;
+	right->nkeys = BDICT_MAX_KEYS + 1 - nleft;
+	memcpy(leaf->key, keys, nleft * sizeof(bdkey_t));
+	memcpy(leaf->value, values, nleft * sizeof(void *));
+	memcpy(right->key, &keys[nleft], right->nkeys * sizeof(bdkey_t));
+	memcpy(right->value, &values[nleft], right->nkeys * sizeof(void *));
+
+	right->next = leaf->next;
+	if (right->next != NULL)
+		right->next->prev = right;
+	right->prev = leaf;
+	leaf->next = right;
+}
+
+/** Insert into a full inner node, moving the upper half to a new node.
+ *
+ * @param node  Full inner node
+ * @param right Empty inner node to become the right sibling of @a node
+ * @param i     Position of the new key
+ * @param key   Key separating @a child from its left sibling
+ * @param child New child
+ * @return Key separating @a node and @a right
+ */
+static bdkey_t bdict_inner_split(bdict_node_t *node, bdict_node_t *right,
+    unsigned int i, bdkey_t key, bdict_node_t *child)
+{
+	bdkey_t keys[BDICT_MAX_KEYS + 1];
+	bdict_node_t *children[BDICT_MAX_KEYS + 2];
+	unsigned int nleft = BDICT_MAX_KEYS / 2;
+
+	memcpy(keys, node->key, i * sizeof(bdkey_t));
+	keys[i] = key;
+	memcpy(&keys[i + 1], &node->key[i],
+	    (BDICT_MAX_KEYS - i) * sizeof(bdkey_t));
+	memcpy(children, node->child, (i + 1) * sizeof(bdict_node_t *));
+	children[i + 1] = child;
+	memcpy(&children[i + 2], &node->child[i + 1],
+	    (BDICT_MAX_KEYS - i) * sizeof(bdict_node_t *));
+
+	node->nkeys = nleft;
+	right->nkeys = BDICT_MAX_KEYS - nleft;
+	memcpy(node->key, keys, nleft * sizeof(bdkey_t));
+	memcpy(node->child, children, (nleft + 1) * sizeof(bdict_node_t *));
+	memcpy(right->key, &keys[nleft + 1], right->nkeys * sizeof(bdkey_t));
+	memcpy(right->child, &children[nleft + 1],
+	    (right->nkeys + 1) * sizeof(bdict_node_t *));
+
+	return keys[nleft];
+}
+
+/** Insert entry into B+tree dictionary.
+ *
+ * @param bdict B+tree dictionary
+ * @param key   Key
+ * @param value Value
+ * @return EOK on success, EEXIST if @a key is already present, ENOMEM
+ *         if out of memory. The dictionary is unchanged on failure.
+ */
+errno_t bdict_insert(bdict_t *bdict, bdkey_t key, void *value)
+{
+	bdict_node_t *path[BDICT_MAX_DEPTH];
+	unsigned int pidx[BDICT_MAX_DEPTH];
+	bdict_node_t *pool[BDICT_MAX_DEPTH + 1];
+
+	if (bdict->root == NULL) {
+		bdict_node_t *leaf = bdict_node_create(true);
+		if (leaf == NULL)
+			return ENOMEM;
+
+		bdict_leaf_insert_at(leaf, 0, key, value);
+		bdict->root = leaf;
+		bdict->depth = 1;
+		bdict->count = 1;
+		return EOK;
+	}
+
+	bdict_node_t *leaf = bdict_descend(bdict, key, path, pidx);
+	unsigned int level = bdict->depth - 1;
+	unsigned int i = bdict_lower_bound(leaf, key);
+
+	if (i < leaf->nkeys && leaf->key[i] == key)
+		return EEXIST;
+
+	if (leaf->nkeys < BDICT_MAX_KEYS) {
+		bdict_leaf_insert_at(leaf, i, key, value);
+		bdict->count++;
+		return EOK;
+	}
+
+	/*
+	 * Allocate all the nodes the insertion is going to split up front,
+	 * so that it cannot fail halfway through.
+	 */
+	unsigned int need = 1;
+	unsigned int l = level;
+	while (l > 0 && path[l - 1]->nkeys == BDICT_MAX_KEYS) {
+		need++;
+		l--;
+	}
+
+	if (l == 0) {
+		/* The root splits too. */
+		assert(bdict->depth < BDICT_MAX_DEPTH);
+		need++;
+	}
+
+	for (unsigned int p = 0; p < need; p++) {
+		pool[p] = bdict_node_create(p == 0);
+		if (pool[p] == NULL) {
+			while (p > 0)
+				free(pool[--p]);
+			return ENOMEM;
+		}
+	}
+
+	bdict_node_t *left = leaf;
+	bdict_node_t *right = pool[0];
+	unsigned int used = 1;
+
+	bdict_leaf_split(leaf, right, i, key, value);
+	bdkey_t sep = right->key[0];
+	bdict->count++;
+
+	while (level > 0) {
+		bdict_node_t *parent = path[level - 1];
+		unsigned int ci = pidx[level - 1];
+
+		if (parent->nkeys < BDICT_MAX_KEYS) {
+			bdict_inner_insert_at(parent, ci, sep, right);
+			assert(used == need);
+			return EOK;
+		}
+
+		bdict_node_t *nright = pool[used++];
+		sep = bdict_inner_split(parent, nright, ci, sep, right);
+		left = parent;
+		right = nright;
+		level--;
+	}
+
+	bdict_node_t *root = pool[used++];
+	root->nkeys = 1;
+	root->key[0] = sep;
+	root->child[0] = left;
+	root->child[1] = right;
+	bdict->root = root;
+	bdict->depth++;
+
+	assert(used == need);
+	return EOK;
+}
+
+/** Fill B+tree dictionary with sorted entries.
+ *
+ * Builds the tree bottom-up, which is much faster than inserting the
+ * entries one by one and leaves the nodes fully packed.
+ *
+ * @param bdict  Empty B+tree dictionary
+ * @param keys   Keys in strictly ascending order
+ * @param values Values, @a values[i] belongs to @a keys[i]
+ * @param n      Number of entries
+ * @return EOK on success, EINVAL if the keys are not strictly ascending,
+ *         ENOMEM if out of memory. The dictionary stays empty on failure.
+ */
+errno_t bdict_load(bdict_t *bdict, const bdkey_t *keys, void *const *values,
+    size_t n)
+{
+	assert(bdict->root == NULL);
+
+	if (n == 0)
+		return EOK;
+
+	for (size_t i = 1; i < n; i++) {
+		if (keys[i - 1] >= keys[i])
+			return EINVAL;
+	}
+
+	size_t cnt = (n + BDICT_MAX_KEYS - 1) / BDICT_MAX_KEYS;
+	bdict_node_t **nodes = calloc(cnt, sizeof(bdict_node_t *));
+	bdkey_t *mins = calloc(cnt, sizeof(bdkey_t));
+	if (nodes == NULL || mins == NULL)
+		goto error;
+
+	/* Spread the entries evenly over the leaves. */
+	size_t base = n / cnt;
+	size_t extra = n % cnt;
+	size_t pos = 0;
+
+	for (size_t j = 0; j < cnt; j++) {
+		bdict_node_t *leaf = bdict_node_create(true);
+		if (leaf == NULL)
+			goto error;
+
+		leaf->nkeys = base + (j < extra ? 1 : 0);
+		memcpy(leaf->key, &keys[pos], leaf->nkeys * sizeof(bdkey_t));
+		memcpy(leaf->value, &values[pos], leaf->nkeys * sizeof(void *));
+		if (j > 0) {
+			leaf->prev = nodes[j - 1];
+			nodes[j - 1]->next = leaf;
+		}
+
+		nodes[j] = leaf;
+		mins[j] = keys[pos];
+		pos += leaf->nkeys;
+	}
+
+	unsigned int depth = 1;
+
+	/* Build the inner levels, reusing the arrays. */
+	while (cnt > 1) {
+		size_t pcnt = (cnt + BDICT_MAX_KEYS) / (BDICT_MAX_KEYS + 1);
+		size_t c = 0;
+
+		base = cnt / pcnt;
+		extra = cnt % pcnt;
+
+		for (size_t j = 0; j < pcnt; j++) {
+			bdict_node_t *node = bdict_node_create(false);
+			if (node == NULL) {
+				/* Free the parents built so far and the rest. */
+				for (size_t k = 0; k < j; k++)
+					bdict_free_subtree(nodes[k]);
+				for (size_t k = c; k < cnt; k++)
+					bdict_free_subtree(nodes[k]);
+				cnt = 0;
+				goto error;
+			}
+
+			size_t m = base + (j < extra ? 1 : 0);
+			bdkey_t min = mins[c];
+
+			node->nkeys = m - 1;
+			for (size_t k = 0; k < m; k++) {
+				node->child[k] = nodes[c + k];
+				if (k > 0)
+					node->key[k - 1] = mins[c + k];
+			}
+
+			c += m;
+			nodes[j] = node;
+			mins[j] = min;
+		}
+
+		cnt = pcnt;
+		depth++;
+	}
+
+	bdict->root = nodes[0];
+	bdict->depth = depth;
+	bdict->count = n;
+
+	free(nodes);
+	free(mins);
+	return EOK;
+
+error:
+	if (nodes != NULL) {
+		for (size_t k = 0; k < cnt; k++) {
+			if (nodes[k] != NULL)
+				bdict_free_subtree(nodes[k]);
+		}
+	}
+
+	free(nodes);
+	free(mins);
+	return ENOMEM;
+}
+
+/** Move the last entry of the left sibling of child @a ci to that child. */
+static void bdict_borrow_left(bdict_node_t *parent, unsigned int ci)
+{
+	bdict_node_t *node = parent->child[ci];
+	bdict_node_t *left = parent->child[ci - 1];
+	unsigned int n = node->nkeys;
+
+	memmove(&node->key[1], &node->key[0], n * sizeof(bdkey_t));
+
+	if (node->leaf) {
+		memmove(&node->value[1], &node->value[0], n * sizeof(void *));
+		node->key[0] = left->key[left->nkeys - 1];
+		node->value[0] = left->value[left->nkeys - 1];
+		parent->key[ci - 1] = node->key[0];
+	} else {
+		memmove(&node->child[1], &node->child[0],
+		    (n + 1) * sizeof(bdict_node_t *));
+		node->key[0] = parent->key[ci - 1];
+		node->child[0] = left->child[left->nkeys];
+		parent->key[ci - 1] = left->key[left->nkeys - 1];
+	}
+
+	left->nkeys--;
+	node->nkeys++;
+}
+
+/** Move the first entry of the right sibling of child @a ci to that child. */
+static void bdict_borrow_right(bdict_node_t *parent, unsigned int ci)
+{
+	bdict_node_t *node = parent->child[ci];
+	bdict_node_t *right = parent->child[ci + 1];
+	unsigned int n = node->nkeys;
+
+	if (node->leaf) {
+		node->key[n] = right->key[0];
+		node->value[n] = right->value[0];
+		memmove(&right->value[0], &right->value[1],
+		    (right->nkeys - 1) * sizeof(void *));
+	} else {
+		node->key[n] = parent->key[ci];
+		node->child[n + 1] = right->child[0];
+		parent->key[ci] = right->key[0];
+		memmove(&right->child[0], &right->child[1],
+		    right->nkeys * sizeof(bdict_node_t *));
+	}
+
+	memmove(&right->key[0], &right->key[1],
+	    (right->nkeys - 1) * sizeof(bdkey_t));
+	right->nkeys--;
+	node->nkeys++;
+
+	if (node->leaf)
+		parent->key[ci] = right->key[0];
+}
+
+/** Merge child @a j + 1 into child @a j and free it. */
+static void bdict_merge(bdict_node_t *parent, unsigned int j)
+{
+	bdict_node_t *left = parent->child[j];
+	bdict_node_t *right = parent->child[j + 1];
+	unsigned int n = left->nkeys;
+
+	if (left->leaf) {
+		memcpy(&left->key[n], right->key, right->nkeys * sizeof(bdkey_t));
+		memcpy(&left->value[n], right->value,
+		    right->nkeys * sizeof(void *));
+		left->nkeys = n + right->nkeys;
+
+		left->next = right->next;
+		if (left->next != NULL)
+			left->next->prev = left;
+	} else {
+		left->key[n] = parent->key[j];
+		memcpy(&left->key[n + 1], right->key,
+		    right->nkeys * sizeof(bdkey_t));
+		memcpy(&left->child[n + 1], right->child,
+		    (right->nkeys + 1) * sizeof(bdict_node_t *));
+		left->nkeys = n + 1 + right->nkeys;
+	}
+
+	assert(left->nkeys <= BDICT_MAX_KEYS);
+
+	memmove(&parent->key[j], &parent->key[j + 1],
+	    (parent->nkeys - j - 1) * sizeof(bdkey_t));
+	memmove(&parent->child[j + 1], &parent->child[j + 2],
+	    (parent->nkeys - j - 1) * sizeof(bdict_node_t *));
+	parent->nkeys--;
+
+	free(right);
+}
+
+/** Remove entry from B+tree dictionary.
+ *
+ * @param bdict  B+tree dictionary
+ * @param key    Key
+ * @param rvalue If not NULL, place to store the value of the removed entry
+ * @return EOK on success, ENOENT if @a key is not present
+ */
+errno_t bdict_remove(bdict_t *bdict, bdkey_t key, void **rvalue)
+{
+	bdict_node_t *path[BDICT_MAX_DEPTH];
+	unsigned int pidx[BDICT_MAX_DEPTH];
+
+	if (bdict->root == NULL)
+		return ENOENT;
+
+	bdict_node_t *node = bdict_descend(bdict, key, path, pidx);
+	unsigned int level = bdict->depth - 1;
+	unsigned int i = bdict_lower_bound(node, key);
+
+	if (i >= node->nkeys || node->key[i] != key)
+		return ENOENT;
+
+	if (rvalue != NULL)
+		*rvalue = node->value[i];
+
+	memmove(&node->key[i], &node->key[i + 1],
+	    (node->nkeys - i - 1) * sizeof(bdkey_t));
+	memmove(&node->value[i], &node->value[i + 1],
+	    (node->nkeys - i - 1) * sizeof(void *));
+	node->nkeys--;
+	bdict->count--;
+
+	while (level > 0) {
+		if (node->nkeys >= BDICT_MIN_KEYS)
+			return EOK;
+
+		bdict_node_t *parent = path[level - 1];
+		unsigned int ci = pidx[level - 1];
+
+		if (ci > 0 && parent->child[ci - 1]->nkeys > BDICT_MIN_KEYS) {
+			bdict_borrow_left(parent, ci);
+			return EOK;
+		}
+
+		if (ci < parent->nkeys &&
+		    parent->child[ci + 1]->nkeys > BDICT_MIN_KEYS) {
+			bdict_borrow_right(parent, ci);
+			return EOK;
+		}
+
+		bdict_merge(parent, ci > 0 ? ci - 1 : ci);
+		node = parent;
+		level--;
+	}
+
+	/* The root may shrink below the minimum, but not to zero keys. */
+	if (node->nkeys == 0) {
+		if (node->leaf) {
+			bdict->root = NULL;
+			bdict->depth = 0;
+		} else {
+			bdict->root = node->child[0];
+			bdict->depth--;
+		}
+
+		free(node);
+	}
+
+	return EOK;
+}
+
+/** Return true if B+tree dictionary is empty.
+ *
+ * @param bdict B+tree dictionary
+ * @return @c true if @a bdict is empty, @c false otherwise
+ */
+bool bdict_empty(bdict_t *bdict)
+{
+	return bdict->count == 0;
+}
+
+/** Return the number of entries in B+tree dictionary.
+ *
+ * @param bdict B+tree dictionary
+ * @return Number of entries
+ */
+unsigned long bdict_count(bdict_t *bdict)
+{
+	return bdict->count;
+}
+
+/** Get the position of the first entry.
+ *
+ * @param bdict B+tree dictionary
+ * @param pos   Place to store the position
+ * @return @c true on success, @c false if the dictionary is empty
+ */
+bool bdict_first(bdict_t *bdict, bdpos_t *pos)
+{
+	bdict_node_t *node = bdict->root;
+	if (node == NULL)
+		return false;
+
+	while (!node->leaf)
+		node = node->child[0];
+
+	pos->leaf = node;
+	pos->idx = 0;
+	return true;
+}
+
+/** Get the position of the last entry.
+ *
+ * @param bdict B+tree dictionary
+ * @param pos   Place to store the position
+ * @return @c true on success, @c false if the dictionary is empty
+ */
+bool bdict_last(bdict_t *bdict, bdpos_t *pos)
+{
+	bdict_node_t *node = bdict->root;
+	if (node == NULL)
+		return false;
+
+	while (!node->leaf)
+		node = node->child[node->nkeys];
+
+	pos->leaf = node;
+	pos->idx = node->nkeys - 1;
+	return true;
+}
+
+/** Move to the next entry.
+ *
+ * Together with the bdict_find_*() functions, this allows walking all
+ * entries within a key range in ascending order.
+ *
+ * @param pos Position, left unchanged if there is no next entry
+ * @return @c true on success, @c false if @a pos is the last entry
+ */
+bool bdict_next(bdpos_t *pos)
+{
+	if (pos->idx + 1 < pos->leaf->nkeys) {
+		pos->idx++;
+		return true;
+	}
+
+	if (pos->leaf->next == NULL)
+		return false;
+
+	pos->leaf = pos->leaf->next;
+	pos->idx = 0;
+	return true;
+}
+
+/** Move to the previous entry.
+ *
+ * @param pos Position, left unchanged if there is no previous entry
+ * @return @c true on success, @c false if @a pos is the first entry
+ */
+bool bdict_prev(bdpos_t *pos)
+{
+	if (pos->idx > 0) {
+		pos->idx--;
+		return true;
+	}
+
+	if (pos->leaf->prev == NULL)
+		return false;
+
+	pos->leaf = pos->leaf->prev;
+	pos->idx = pos->leaf->nkeys - 1;
+	return true;
+}
+
+/** Get the key of the entry at a position.
+ *
+ * @param pos Position
+ * @return Key
+ */
+bdkey_t bdict_key(bdpos_t *pos)
+{
+	return pos->leaf->key[pos->idx];
+}
+
+/** Get the value of the entry at a position.
+ *
+ * @param pos Position
+ * @return Value
+ */
+void *bdict_value(bdpos_t *pos)
+{
+	return pos->leaf->value[pos->idx];
+}
+
+/** Replace the value of the entry at a position.
+ *
+ * @param pos   Position
+ * @param value New value
+ */
+void bdict_set_value(bdpos_t *pos, void *value)
+{
+	pos->leaf->value[pos->idx] = value;
+}
+
+/** Get the value of the entry with a given key.
+ *
+ * @param bdict B+tree dictionary
+ * @param key   Key
+ * @return Value or NULL if @a key is not present
+ */
+void *bdict_get(bdict_t *bdict, bdkey_t key)
+{
+	bdpos_t pos;
+
+	if (!bdict_find_eq(bdict, key, &pos))
+		return NULL;
+
+	return bdict_value(&pos);
+}
+
+/** Find the entry with a given key.
+ *
+ * @param bdict B+tree dictionary
+ * @param key   Key
+ * @param pos   Place to store the position of the entry
+ * @return @c true if found, @c false otherwise
+ */
+bool bdict_find_eq(bdict_t *bdict, bdkey_t key, bdpos_t *pos)
+{
+	if (bdict->root == NULL)
+		return false;
+
+	bdict_node_t *leaf = bdict_descend(bdict, key, NULL, NULL);
+	unsigned int i = bdict_lower_bound(leaf, key);
+
+	if (i >= leaf->nkeys || leaf->key[i] != key)
+		return false;
+
+	pos->leaf = leaf;
+	pos->idx = i;
+	return true;
+}
+
+/** Find the first entry whose key lies at index @a i of @a leaf or later. */
+static bool bdict_find_fwd(bdict_node_t *leaf, unsigned int i, bdpos_t *pos)
+{
+	if (i >= leaf->nkeys) {
+		leaf = leaf->next;
+		i = 0;
+		if (leaf == NULL)
+			return false;
+	}
+
+	pos->leaf = leaf;
+	pos->idx = i;
+	return true;
+}
+
+/** Find the last entry whose key lies before index @a i of @a leaf. */
+static bool bdict_find_bwd(bdict_node_t *leaf, unsigned int i, bdpos_t *pos)
+{
+	if (i == 0) {
+		leaf = leaf->prev;
+		if (leaf == NULL)
+			return false;
+		i = leaf->nkeys;
+	}
+
+	pos->leaf = leaf;
+	pos->idx = i - 1;
+	return true;
+}
+
+/** Find the first entry with key greater than or equal to @a key.
+ *
+ * @param bdict B+tree dictionary
+ * @param key   Key
+ * @param pos   Place to store the position of the entry
+ * @return @c true if found, @c false otherwise
+ */
+bool bdict_find_geq(bdict_t *bdict, bdkey_t key, bdpos_t *pos)
+{
+	if (bdict->root == NULL)
+		return false;
+
+	bdict_node_t *leaf = bdict_descend(bdict, key, NULL, NULL);
+	return bdict_find_fwd(leaf, bdict_lower_bound(leaf, key), pos);
+}
+
+/** Find the first entry with key greater than @a key.
+ *
+ * @param bdict B+tree dictionary
+ * @param key   Key
+ * @param pos   Place to store the position of the entry
+ * @return @c true if found, @c false otherwise
+ */
+bool bdict_find_gt(bdict_t *bdict, bdkey_t key, bdpos_t *pos)
+{
+	if (bdict->root == NULL)
+		return false;
+
+	bdict_node_t *leaf = bdict_descend(bdict, key, NULL, NULL);
+	return bdict_find_fwd(leaf, bdict_upper_bound(leaf, key), pos);
+}
+
+/** Find the last entry with key less than or equal to @a key.
+ *
+ * @param bdict B+tree dictionary
+ * @param key   Key
+ * @param pos   Place to store the position of the entry
+ * @return @c true if found, @c false otherwise
+ */
+bool bdict_find_leq(bdict_t *bdict, bdkey_t key, bdpos_t *pos)
+{
+	if (bdict->root == NULL)
+		return false;
+
+	bdict_node_t *leaf = bdict_descend(bdict, key, NULL, NULL);
+	return bdict_find_bwd(leaf, bdict_upper_bound(leaf, key), pos);
+}
+
+/** Find the last entry with key less than @a key.
+ *
+ * @param bdict B+tree dictionary
+ * @param key   Key
+ * @param pos   Place to store the position of the entry
+ * @return @c true if found, @c false otherwise
+ */
+bool bdict_find_lt(bdict_t *bdict, bdkey_t key, bdpos_t *pos)
+{
+	if (bdict->root == NULL)
+		return false;
+
+	bdict_node_t *leaf = bdict_descend(bdict, key, NULL, NULL);
+	return bdict_find_bwd(leaf, bdict_lower_bound(leaf, key), pos);
+}
+
+/** State of bdict_validate_subtree(). */
+typedef struct {
+	/** Last leaf visited */
+	bdict_node_t *last_leaf;
+	/** Number of entries visited */
+	unsigned long count;
+} bdict_validate_t;
+
+/** Verify that a B+tree subtree is consistent.
+ *
+ * @param node  Subtree root
+ * @param depth Levels remaining below and including @a node
+ * @param lo    Lower bound of the keys (inclusive), if @a has_lo
+ * @param hi    Upper bound of the keys (exclusive), if @a has_hi
+ * @param root  True if @a node is the root of the tree
+ * @param st    Validation state
+ * @return EOK on success, EINVAL otherwise
+ */
+static errno_t bdict_validate_subtree(bdict_node_t *node, unsigned int depth,
+    bool has_lo, bdkey_t lo, bool has_hi, bdkey_t hi, bool root,
+    bdict_validate_t *st)
+{
+	errno_t rc;
+
+	if (node->nkeys > BDICT_MAX_KEYS ||
+	    node->nkeys < (root ? 1 : BDICT_MIN_KEYS)) {
+		printf("Node has %u keys\n", node->nkeys);
+		return EINVAL;
+	}
+
+	for (unsigned int i = 0; i < node->nkeys; i++) {
+		if (i > 0 && node->key[i - 1] >= node->key[i]) {
+			printf("Keys not in ascending order\n");
+			return EINVAL;
+		}
+
+		if ((has_lo && node->key[i] < lo) ||
+		    (has_hi && node->key[i] >= hi)) {
+			printf("Key out of the bounds of the subtree\n");
+			return EINVAL;
+		}
+	}
+
+	if (node->leaf != (depth == 1)) {
+		printf("Leaves not all at the same depth\n");
+		return EINVAL;
+	}
+
+	if (node->leaf) {
+		if (node->prev != st->last_leaf ||
+		    (st->last_leaf != NULL && st->last_leaf->next != node)) {
+			printf("Broken leaf chain\n");
+			return EINVAL;
+		}
+
+		st->last_leaf = node;
+		st->count += node->nkeys;
+		return EOK;
+	}
+
+	for (unsigned int i = 0; i <= node->nkeys; i++) {
+		rc = bdict_validate_subtree(node->child[i], depth - 1,
+		    i > 0 ? true : has_lo, i > 0 ? node->key[i - 1] : lo,
+		    i < node->nkeys ? true : has_hi,
+		    i < node->nkeys ? node->key[i] : hi, false, st);
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
+}
+
+/** Verify that B+tree dictionary is consistent.
+ *
+ * @param bdict B+tree dictionary
+ * @return EOK on success, EINVAL if the tree is corrupted
+ */
+errno_t bdict_validate(bdict_t *bdict)
+{
+	bdict_validate_t st = { .last_leaf = NULL, .count = 0 };
+	errno_t rc;
+
+	if (bdict->root == NULL) {
+		if (bdict->depth != 0 || bdict->count != 0) {
+			printf("Empty tree with depth or count\n");
+			return EINVAL;
+		}
+
+		return EOK;
+	}
+
+	rc = bdict_validate_subtree(bdict->root, bdict->depth, false, 0,
+	    false, 0, true, &st);
+	if (rc != EOK)
+		return rc;
+
+	if (st.last_leaf->next != NULL) {
+		printf("Last leaf has a successor\n");
+		return EINVAL;
+	}
+
+	if (st.count != bdict->count) {
+		printf("Entry count mismatch\n");
+		return EINVAL;
+	}
+
+	return EOK;
+}
+
+/** @}
+ */
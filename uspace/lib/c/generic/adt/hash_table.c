@@ -46,11 +46,18 @@
  * have fairly large (prime/odd) divisors. Having a prime table size
  * mitigates the use of suboptimal hash functions and distributes
  * items over the whole table.
+ *
+ * Resizing is incremental. The old buckets are kept next to the new ones
+ * and every insertion or removal migrates a few of them, so that no single
+ * operation has to rehash the whole table. An old bucket is also migrated
+ * before anything is inserted into the new bucket its items map to. Items
+ * with the same lookup key are therefore always all in the same table.
  */
 
 #include <adt/hash_table.h>
 #include <adt/list.h>
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <str.h>
 
@@ -58,11 +65,14 @@
 #define HT_MIN_BUCKETS  89
 /* The table is resized when the average load per bucket exceeds this number. */
 #define HT_MAX_LOAD     2
+/* Number of old buckets migrated by each insertion or removal. */
+#define HT_MIGRATE_STEP 8
 
 static size_t round_up_size(size_t);
 static bool alloc_table(size_t, list_t **);
 static void clear_items(hash_table_t *);
-static void resize(hash_table_t *, size_t);
+static bool resize(hash_table_t *, size_t);
+static void migrate(hash_table_t *, size_t);
 static void grow_if_needed(hash_table_t *);
 static void shrink_if_needed(hash_table_t *);
 
@@ -103,6 +113,9 @@ bool hash_table_create(hash_table_t *h, size_t init_size, size_t max_load,
 	if (!alloc_table(h->bucket_cnt, &h->bucket))
 		return false;
 
+	h->old_bucket = NULL;
+	h->old_bucket_cnt = 0;
+	h->migrate_idx = 0;
 	h->max_load = (max_load == 0) ? HT_MAX_LOAD : max_load;
 	h->item_cnt = 0;
 	h->op = op;
@@ -165,14 +178,39 @@ void hash_table_clear(hash_table_t *h)
 	}
 }
 
-/** Unlinks and removes all items but does not resize. */
-static void clear_items(hash_table_t *h)
+/** Make room for a number of items.
+ *
+ * Resizes the table right away, so that it can hold @a count items
+ * without growing. Meant to be called before inserting many items
+ * in bulk.
+ *
+ * @param h     Hash table.
+ * @param count Number of items the table should be able to hold.
+ *
+ * @return False if the new buckets could not be allocated.
+ */
+bool hash_table_reserve(hash_table_t *h, size_t count)
 {
-	if (h->item_cnt == 0)
-		return;
+	assert(h && h->bucket);
+	assert(!h->apply_ongoing);
+
+	size_t new_bucket_cnt =
+	    round_up_size((count + h->max_load - 1) / h->max_load);
+	if (new_bucket_cnt <= h->bucket_cnt)
+		return true;
+
+	if (!resize(h, new_bucket_cnt))
+		return false;
+
+	migrate(h, SIZE_MAX);
+	return true;
+}
 
-	for (size_t idx = 0; idx < h->bucket_cnt; ++idx) {
-		list_foreach_safe(h->bucket[idx], cur, next) {
+/** Unlinks and removes all items in a bucket array. */
+static void clear_buckets(hash_table_t *h, list_t *buckets, size_t bucket_cnt)
+{
+	for (size_t idx = 0; idx < bucket_cnt; ++idx) {
+		list_foreach_safe(buckets[idx], cur, next) {
 			assert(cur);
 			ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
 
@@ -180,10 +218,80 @@ static void clear_items(hash_table_t *h)
 			h->op->remove_callback(cur_link);
 		}
 	}
+}
+
+/** Unlinks and removes all items but does not resize. */
+static void clear_items(hash_table_t *h)
+{
+	if (h->old_bucket != NULL) {
+		clear_buckets(h, h->old_bucket, h->old_bucket_cnt);
+		free(h->old_bucket);
+		h->old_bucket = NULL;
+		h->old_bucket_cnt = 0;
+	}
+
+	if (h->item_cnt == 0)
+		return;
 
+	clear_buckets(h, h->bucket, h->bucket_cnt);
 	h->item_cnt = 0;
 }
 
+/** Returns the old bucket of a hash or NULL if no resize is in progress. */
+static inline list_t *old_bucket_of(const hash_table_t *h, size_t hash)
+{
+	if (h->old_bucket == NULL)
+		return NULL;
+
+	return &h->old_bucket[hash % h->old_bucket_cnt];
+}
+
+/** Moves all items of an old bucket to the new buckets. */
+static void migrate_bucket(hash_table_t *h, list_t *old)
+{
+	list_foreach_safe(*old, cur, next) {
+		ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+
+		size_t new_idx = h->op->hash(cur_link) % h->bucket_cnt;
+		list_remove(cur);
+		list_append(cur, &h->bucket[new_idx]);
+	}
+}
+
+/** Migrates up to @a steps old buckets and frees them when done. */
+static void migrate(hash_table_t *h, size_t steps)
+{
+	/* Moving items would mess up the buckets being traversed. */
+	if (h->old_bucket == NULL || h->apply_ongoing)
+		return;
+
+	while (steps > 0 && h->migrate_idx < h->old_bucket_cnt) {
+		migrate_bucket(h, &h->old_bucket[h->migrate_idx]);
+		++h->migrate_idx;
+		--steps;
+	}
+
+	if (h->migrate_idx == h->old_bucket_cnt) {
+		free(h->old_bucket);
+		h->old_bucket = NULL;
+		h->old_bucket_cnt = 0;
+	}
+}
+
+/** Returns the bucket new items with the given hash go to.
+ *
+ * If a resize is in progress, the items with the same hash still in the
+ * old buckets are migrated first.
+ */
+static list_t *insert_bucket(hash_table_t *h, size_t hash)
+{
+	list_t *old = old_bucket_of(h, hash);
+	if (old != NULL)
+		migrate_bucket(h, old);
+
+	return &h->bucket[hash % h->bucket_cnt];
+}
+
 /** Insert item into a hash table.
  *
  * @param h    Hash table.
@@ -195,10 +303,11 @@ void hash_table_insert(hash_table_t *h, ht_link_t *item)
 	assert(h && h->bucket);
 	assert(!h->apply_ongoing);
 
-	size_t idx = h->op->hash(item) % h->bucket_cnt;
+	list_t *bucket = insert_bucket(h, h->op->hash(item));
 
-	list_append(&item->link, &h->bucket[idx]);
+	list_append(&item->link, bucket);
 	++h->item_cnt;
+	migrate(h, HT_MIGRATE_STEP);
 	grow_if_needed(h);
 }
 
@@ -217,10 +326,10 @@ bool hash_table_insert_unique(hash_table_t *h, ht_link_t *item)
 	assert(h->op && h->op->hash && h->op->equal);
 	assert(!h->apply_ongoing);
 
-	size_t idx = h->op->hash(item) % h->bucket_cnt;
+	list_t *bucket = insert_bucket(h, h->op->hash(item));
 
 	/* Check for duplicates. */
-	list_foreach(h->bucket[idx], link, ht_link_t, cur_link) {
+	list_foreach(*bucket, link, ht_link_t, cur_link) {
 		/*
 		 * We could filter out items using their hashes first, but
 		 * calling equal() might very well be just as fast.
@@ -229,13 +338,32 @@ bool hash_table_insert_unique(hash_table_t *h, ht_link_t *item)
 			return false;
 	}
 
-	list_append(&item->link, &h->bucket[idx]);
+	list_append(&item->link, bucket);
 	++h->item_cnt;
+	migrate(h, HT_MIGRATE_STEP);
 	grow_if_needed(h);
 
 	return true;
 }
 
+/** Search a bucket for an item matching keys. */
+static ht_link_t *find_in_bucket(const hash_table_t *h, list_t *bucket,
+    const void *key)
+{
+	list_foreach(*bucket, link, ht_link_t, cur_link) {
+		/*
+		 * Is this is the item we are looking for? We could have first
+		 * checked if the hashes match but op->key_equal() may very well be
+		 * just as fast as op->hash().
+		 */
+		if (h->op->key_equal(key, cur_link)) {
+			return cur_link;
+		}
+	}
+
+	return NULL;
+}
+
 /** Search hash table for an item matching keys.
  *
  * @param h   Hash table.
@@ -248,20 +376,16 @@ ht_link_t *hash_table_find(const hash_table_t *h, const void *key)
 {
 	assert(h && h->bucket);
 
-	size_t idx = h->op->key_hash(key) % h->bucket_cnt;
+	size_t hash = h->op->key_hash(key);
 
-	list_foreach(h->bucket[idx], link, ht_link_t, cur_link) {
-		/*
-		 * Is this is the item we are looking for? We could have first
-		 * checked if the hashes match but op->key_equal() may very well be
-		 * just as fast as op->hash().
-		 */
-		if (h->op->key_equal(key, cur_link)) {
+	list_t *old = old_bucket_of(h, hash);
+	if (old != NULL) {
+		ht_link_t *cur_link = find_in_bucket(h, old, key);
+		if (cur_link != NULL)
 			return cur_link;
-		}
 	}
 
-	return NULL;
+	return find_in_bucket(h, &h->bucket[hash % h->bucket_cnt], key);
 }
 
 /** Find the next item equal to item. */
@@ -271,14 +395,18 @@ hash_table_find_next(const hash_table_t *h, ht_link_t *first, ht_link_t *item)
 	assert(item);
 	assert(h && h->bucket);
 
-	size_t idx = h->op->hash(item) % h->bucket_cnt;
+	size_t hash = h->op->hash(item);
+	link_t *head = &h->bucket[hash % h->bucket_cnt].head;
+	list_t *old = old_bucket_of(h, hash);
+	link_t *old_head = (old != NULL) ? &old->head : NULL;
 
 	/* Traverse the circular list until we reach the starting item again. */
 	for (link_t *cur = item->link.next; cur != &first->link;
 	    cur = cur->next) {
 		assert(cur);
 
-		if (cur == &h->bucket[idx].head)
+		/* The items are either in the old or in the new bucket. */
+		if (cur == head || cur == old_head)
 			continue;
 
 		ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
@@ -295,6 +423,25 @@ hash_table_find_next(const hash_table_t *h, ht_link_t *first, ht_link_t *item)
 	return NULL;
 }
 
+/** Remove all matching items from a bucket. */
+static size_t remove_from_bucket(hash_table_t *h, list_t *bucket,
+    const void *key)
+{
+	size_t removed = 0;
+
+	list_foreach_safe(*bucket, cur, next) {
+		ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+
+		if (h->op->key_equal(key, cur_link)) {
+			++removed;
+			list_remove(cur);
+			h->op->remove_callback(cur_link);
+		}
+	}
+
+	return removed;
+}
+
 /** Remove all matching items from hash table.
  *
  * For each removed item, h->remove_callback() is called.
@@ -310,21 +457,17 @@ size_t hash_table_remove(hash_table_t *h, const void *key)
 	assert(h && h->bucket);
 	assert(!h->apply_ongoing);
 
-	size_t idx = h->op->key_hash(key) % h->bucket_cnt;
-
+	size_t hash = h->op->key_hash(key);
 	size_t removed = 0;
 
-	list_foreach_safe(h->bucket[idx], cur, next) {
-		ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+	list_t *old = old_bucket_of(h, hash);
+	if (old != NULL)
+		removed += remove_from_bucket(h, old, key);
 
-		if (h->op->key_equal(key, cur_link)) {
-			++removed;
-			list_remove(cur);
-			h->op->remove_callback(cur_link);
-		}
-	}
+	removed += remove_from_bucket(h, &h->bucket[hash % h->bucket_cnt], key);
 
 	h->item_cnt -= removed;
+	migrate(h, HT_MIGRATE_STEP);
 	shrink_if_needed(h);
 
 	return removed;
@@ -340,9 +483,32 @@ void hash_table_remove_item(hash_table_t *h, ht_link_t *item)
 	list_remove(&item->link);
 	--h->item_cnt;
 	h->op->remove_callback(item);
+	migrate(h, HT_MIGRATE_STEP);
 	shrink_if_needed(h);
 }
 
+/** Apply function to all items in a bucket array.
+ *
+ * @return False if f() asked to stop.
+ */
+static bool apply_buckets(list_t *buckets, size_t bucket_cnt,
+    bool (*f)(ht_link_t *, void *), void *arg)
+{
+	for (size_t idx = 0; idx < bucket_cnt; ++idx) {
+		list_foreach_safe(buckets[idx], cur, next) {
+			ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
+			/*
+			 * The next pointer had already been saved. f() may safely
+			 * delete cur (but not next!).
+			 */
+			if (!f(cur_link, arg))
+				return false;
+		}
+	}
+
+	return true;
+}
+
 /** Apply function to all items in hash table.
  *
  * @param h   Hash table.
@@ -362,18 +528,10 @@ void hash_table_apply(hash_table_t *h, bool (*f)(ht_link_t *, void *), void *arg
 
 	h->apply_ongoing = true;
 
-	for (size_t idx = 0; idx < h->bucket_cnt; ++idx) {
-		list_foreach_safe(h->bucket[idx], cur, next) {
-			ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
-			/*
-			 * The next pointer had already been saved. f() may safely
-			 * delete cur (but not next!).
-			 */
-			if (!f(cur_link, arg))
-				goto out;
-		}
-	}
-out:
+	if (h->old_bucket == NULL ||
+	    apply_buckets(h->old_bucket, h->old_bucket_cnt, f, arg))
+		apply_buckets(h->bucket, h->bucket_cnt, f, arg);
+
 	h->apply_ongoing = false;
 
 	shrink_if_needed(h);
@@ -432,39 +590,43 @@ static inline void grow_if_needed(hash_table_t *h)
 	}
 }
 
-/** Allocates and rehashes items to a new table. Frees the old table. */
-static void resize(hash_table_t *h, size_t new_bucket_cnt)
+/** Allocates a new table and starts migrating the items to it.
+ *
+ * The items are moved over by subsequent insertions and removals. A resize
+ * still in progress is completed first, which normally does not happen, as
+ * migration finishes long before the load crosses a threshold again.
+ *
+ * @return False if the table was left as is.
+ */
+static bool resize(hash_table_t *h, size_t new_bucket_cnt)
 {
 	assert(h && h->bucket);
 	assert(HT_MIN_BUCKETS <= new_bucket_cnt);
 
 	/* We are traversing the table and resizing would mess up the buckets. */
 	if (h->apply_ongoing)
-		return;
+		return false;
+
+	migrate(h, SIZE_MAX);
 
 	list_t *new_buckets;
 
 	/* Leave the table as is if we cannot resize. */
 	if (!alloc_table(new_bucket_cnt, &new_buckets))
-		return;
+		return false;
 
 	if (0 < h->item_cnt) {
-		/* Rehash all the items to the new table. */
-		for (size_t old_idx = 0; old_idx < h->bucket_cnt; ++old_idx) {
-			list_foreach_safe(h->bucket[old_idx], cur, next) {
-				ht_link_t *cur_link = member_to_inst(cur, ht_link_t, link);
-
-				size_t new_idx = h->op->hash(cur_link) % new_bucket_cnt;
-				list_remove(cur);
-				list_append(cur, &new_buckets[new_idx]);
-			}
-		}
+		h->old_bucket = h->bucket;
+		h->old_bucket_cnt = h->bucket_cnt;
+		h->migrate_idx = 0;
+	} else {
+		free(h->bucket);
 	}
 
-	free(h->bucket);
 	h->bucket = new_buckets;
 	h->bucket_cnt = new_bucket_cnt;
 	h->full_item_cnt = h->max_load * h->bucket_cnt;
+	return true;
 }
 
 /** @}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Intrusive lock-free multi-producer single-consumer queue
+ */
+
+#include <adt/mpsc_queue.h>
+#include <stddef.h>
+
+/** Initialize an empty queue.
+ *
+ * @param queue Queue.
+ */
+void mpsc_queue_initialize(mpsc_queue_t *queue)
+{
+	atomic_store_explicit(&queue->stub.next, NULL, memory_order_relaxed);
+	atomic_store_explicit(&queue->tail, &queue->stub, memory_order_relaxed);
+	queue->head = &queue->stub;
+}
+
+/** Append a link to the queue.
+ *
+ * May be called by any number of threads concurrently.
+ *
+ * @param queue Queue.
+ * @param link  Link that is not in any queue.
+ */
+void mpsc_queue_push(mpsc_queue_t *queue, mpsc_link_t *link)
+{
+	atomic_store_explicit(&link->next, NULL, memory_order_relaxed);
+
+	mpsc_link_t *prev = atomic_exchange_explicit(&queue->tail, link,
+	    memory_order_acq_rel);
+
+	/*
+	 * Until the following store, the consumer cannot reach the link
+	 * and any links pushed after it.
+	 */
+	atomic_store_explicit(&prev->next, link, memory_order_release);
+}
+
+/** Remove the oldest link from the queue.
+ *
+ * Must only be called by the consumer.
+ *
+ * @param queue Queue.
+ *
+ * @return Removed link or NULL if no complete push is pending.
+ */
+mpsc_link_t *mpsc_queue_pop(mpsc_queue_t *queue)
+{
+	mpsc_link_t *head = queue->head;
+	mpsc_link_t *next = atomic_load_explicit(&head->next,
+	    memory_order_acquire);
+
+	if (head == &queue->stub) {
+		if (next == NULL)
+			return NULL;
+
+		queue->head = next;
+		head = next;
+		next = atomic_load_explicit(&next->next, memory_order_acquire);
+	}
+
+	if (next != NULL) {
+		queue->head = next;
+		return head;
+	}
+
+	/* The head is the last link, unless a push is in progress. */
+	if (head != atomic_load_explicit(&queue->tail, memory_order_acquire))
+		return NULL;
+
+	/* Put the stub behind the last link so that it can be removed. */
+	mpsc_queue_push(queue, &queue->stub);
+
+	next = atomic_load_explicit(&head->next, memory_order_acquire);
+	if (next != NULL) {
+		queue->head = next;
+		return head;
+	}
+
+	return NULL;
+}
+
+/** Check whether the queue is empty.
+ *
+ * Must only be called by the consumer.
+ *
+ * @param queue Queue.
+ *
+ * @return True if there is no complete push pending.
+ */
+bool mpsc_queue_empty(mpsc_queue_t *queue)
+{
+	mpsc_link_t *head = queue->head;
+	mpsc_link_t *next = atomic_load_explicit(&head->next,
+	    memory_order_acquire);
+
+	return (head == &queue->stub) && (next == NULL);
+}
+
+/** @}
+ */
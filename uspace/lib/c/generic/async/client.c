@@ -1184,6 +1184,33 @@ errno_t async_share_in_start_1_1(async_exch_t *exch, size_t size, sysarg_t arg,
 	return async_share_in_start(exch, size, arg, flags, dst);
 }
 
+/** Wrapper for IPC_M_SHARE_IN calls placing the area at a fixed address.
+ *
+ * @param exch  Exchange for sending the message.
+ * @param size  Size of the destination address space area.
+ * @param arg   User defined argument.
+ * @param dst   Requested destination address space area base address.
+ *              Must be page-aligned and must not overlap any existing area.
+ *
+ * @return Zero on success or an error code from errno.h.
+ *
+ */
+errno_t async_share_in_start_fixed(async_exch_t *exch, size_t size,
+    sysarg_t arg, void *dst)
+{
+	if (exch == NULL)
+		return ENOENT;
+
+	sysarg_t _dst = (sysarg_t) -1;
+	errno_t res = async_req_4_5(exch, IPC_M_SHARE_IN, (sysarg_t) size,
+	    (sysarg_t) __progsymbols.end, arg, (sysarg_t) dst, NULL, NULL,
+	    NULL, NULL, &_dst);
+	if (res != EOK)
+		return res;
+
+	return (_dst == (sysarg_t) dst) ? EOK : EINVAL;
+}
+
 /** Wrapper for IPC_M_SHARE_OUT calls using the async framework.
  *
  * @param exch  Exchange for sending the message.
@@ -1255,6 +1282,159 @@ errno_t async_data_write_start(async_exch_t *exch, const void *src, size_t size)
 	    (sysarg_t) size);
 }
 
+/** Initialize a request batch.
+ *
+ * The exchange must stay open until all requests submitted to the batch
+ * have been collected.
+ *
+ * @param batch Batch to initialize.
+ * @param exch  Exchange the requests will be sent over.
+ *
+ */
+void async_batch_init(async_batch_t *batch, async_exch_t *exch)
+{
+	batch->exch = exch;
+	batch->first = 0;
+	batch->count = 0;
+}
+
+/** Get the number of requests in flight in a batch.
+ *
+ * @param batch Batch.
+ *
+ * @return Number of submitted requests not yet collected.
+ *
+ */
+size_t async_batch_pending(async_batch_t *batch)
+{
+	return batch->count;
+}
+
+/** Reserve the next free request slot in a batch.
+ *
+ * @param batch Batch.
+ *
+ * @return Free request slot or NULL if the batch is full.
+ *
+ */
+static async_batch_req_t *async_batch_slot(async_batch_t *batch)
+{
+	if (batch->count == ASYNC_BATCH_MAX)
+		return NULL;
+
+	return &batch->reqs[(batch->first + batch->count) % ASYNC_BATCH_MAX];
+}
+
+/** Submit a method call followed by IPC_M_DATA_READ to a batch.
+ *
+ * The call returns without waiting for the answer. The destination
+ * buffer must not be touched until the request has been collected by
+ * async_batch_wait() or async_batch_drain().
+ *
+ * @param batch   Batch.
+ * @param imethod Service-defined interface and method.
+ * @param arg1    Service-defined payload argument.
+ * @param arg2    Service-defined payload argument.
+ * @param arg3    Service-defined payload argument.
+ * @param dst     Destination buffer.
+ * @param size    Size of the destination buffer.
+ *
+ * @return EOK on success, ELIMIT if the batch is full.
+ *
+ */
+errno_t async_batch_data_read_3(async_batch_t *batch, sysarg_t imethod,
+    sysarg_t arg1, sysarg_t arg2, sysarg_t arg3, void *dst, size_t size)
+{
+	async_batch_req_t *req = async_batch_slot(batch);
+	if (req == NULL)
+		return ELIMIT;
+
+	req->req = async_send_3(batch->exch, imethod, arg1, arg2, arg3,
+	    &req->answer);
+	req->data = async_data_read(batch->exch, dst, size, NULL);
+	batch->count++;
+
+	return EOK;
+}
+
+/** Submit a method call followed by IPC_M_DATA_WRITE to a batch.
+ *
+ * The call returns without waiting for the answer. The source buffer
+ * must not be modified until the request has been collected by
+ * async_batch_wait() or async_batch_drain().
+ *
+ * @param batch   Batch.
+ * @param imethod Service-defined interface and method.
+ * @param arg1    Service-defined payload argument.
+ * @param arg2    Service-defined payload argument.
+ * @param arg3    Service-defined payload argument.
+ * @param src     Source buffer.
+ * @param size    Size of the source buffer.
+ *
+ * @return EOK on success, ELIMIT if the batch is full.
+ *
+ */
+errno_t async_batch_data_write_3(async_batch_t *batch, sysarg_t imethod,
+    sysarg_t arg1, sysarg_t arg2, sysarg_t arg3, const void *src, size_t size)
+{
+	async_batch_req_t *req = async_batch_slot(batch);
+	if (req == NULL)
+		return ELIMIT;
+
+	req->req = async_send_3(batch->exch, imethod, arg1, arg2, arg3,
+	    &req->answer);
+	req->data = async_send_2(batch->exch, IPC_M_DATA_WRITE,
+	    (sysarg_t) src, (sysarg_t) size, NULL);
+	batch->count++;
+
+	return EOK;
+}
+
+/** Collect the oldest request in flight in a batch.
+ *
+ * Waits for both the data transfer and the method call to be answered.
+ *
+ * @param batch  Batch with at least one request in flight.
+ * @param answer If non-NULL, storage for the answer to the method call.
+ *
+ * @return Return code of the data transfer if it failed, otherwise
+ *         the return code of the method call.
+ *
+ */
+errno_t async_batch_wait(async_batch_t *batch, ipc_call_t *answer)
+{
+	assert(batch->count > 0);
+
+	async_batch_req_t *req = &batch->reqs[batch->first];
+	errno_t data_rc;
+	errno_t rc;
+
+	async_wait_for(req->data, &data_rc);
+	async_wait_for(req->req, &rc);
+
+	if (answer != NULL)
+		*answer = req->answer;
+
+	batch->first = (batch->first + 1) % ASYNC_BATCH_MAX;
+	batch->count--;
+
+	return (data_rc != EOK) ? data_rc : rc;
+}
+
+/** Collect all requests in flight in a batch and discard their answers.
+ *
+ * Unlike async_forget(), this waits for the answers, so that no transfer
+ * can still land in the caller's buffers after this function returns.
+ *
+ * @param batch Batch.
+ *
+ */
+void async_batch_drain(async_batch_t *batch)
+{
+	while (batch->count > 0)
+		async_batch_wait(batch, NULL);
+}
+
 errno_t async_state_change_start(async_exch_t *exch, sysarg_t arg1, sysarg_t arg2,
     sysarg_t arg3, async_exch_t *other_exch)
 {
@@ -0,0 +1,620 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup libc
+ * @{
+ */
+/** @file Shared-memory ring channel
+ *
+ * The ring is a single-producer single-consumer byte ring of
+ * length-prefixed records living in an area shared out by the producer.
+ * The producer only advances the head, the consumer only advances
+ * the tail, so no locking is needed on the data path.
+ *
+ * When the consumer finds the ring empty, it sets the waiting flag and
+ * the next write rings the doorbell (a RING_OP_DATA message). When the
+ * producer finds the ring full, it sends a blocking RING_OP_SPACE request
+ * which the consumer answers once enough room has been freed.
+ */
+
+#include <align.h>
+#include <as.h>
+#include <assert.h>
+#include <async.h>
+#include <async_ring.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/** Magic identifying a ring area. */
+#define RING_MAGIC  UINT32_C(0x52494e47)
+
+/** Smallest ring capacity. */
+#define RING_MIN_SIZE  PAGE_SIZE
+
+/** Largest ring capacity. */
+#define RING_MAX_SIZE  (UINT32_C(1) << 30)
+
+/** Alignment of records in the ring. */
+#define RING_ALIGN  8
+
+/** Separation of the producer and consumer owned header fields. */
+#define RING_CACHE_LINE  64
+
+/** Size of the record header. */
+#define RECORD_HEAD_SIZE  sizeof(uint32_t)
+
+/** Operation carried in the first argument of ring calls.
+ *
+ * The second argument carries the user argument of the ring.
+ */
+typedef enum {
+	/** Set up a ring, followed by IPC_M_SHARE_OUT of its area. */
+	RING_OP_SETUP,
+	/** New data is available. */
+	RING_OP_DATA,
+	/** Wait for the number of free bytes in the third argument. */
+	RING_OP_SPACE
+} ring_op_t;
+
+/** Header at the start of the shared area. */
+typedef struct {
+	/** Ring magic */
+	uint32_t magic;
+
+	/** Capacity of the data part in bytes (power of two) */
+	uint32_t size;
+
+	/** Producer position, only advanced by the producer */
+	_Alignas(RING_CACHE_LINE) atomic_uint head;
+
+	/** Consumer position, only advanced by the consumer */
+	_Alignas(RING_CACHE_LINE) atomic_uint tail;
+
+	/** Consumer waits for a doorbell */
+	atomic_int waiting;
+} ring_shared_t;
+
+/** Offset of the data part in the shared area. */
+#define RING_DATA_OFFSET \
+	((size_t) ALIGN_UP(sizeof(ring_shared_t), RING_CACHE_LINE))
+
+struct async_ring {
+	/** Shared area */
+	ring_shared_t *shared;
+
+	/** Data part of the shared area */
+	uint8_t *data;
+
+	/** Capacity of the data part (not trusting the shared copy) */
+	uint32_t size;
+
+	/** This side produces to the ring */
+	bool producer;
+
+	/** Producer: session to ring doorbells on */
+	async_sess_t *sess;
+
+	/** Producer: method used for the ring calls */
+	sysarg_t method;
+
+	/** Producer: user argument sent with the ring calls */
+	sysarg_t arg;
+
+	/** Consumer: private copy of the tail */
+	uint32_t tail;
+
+	/** Consumer: protects the fields below */
+	fibril_mutex_t lock;
+
+	/** Consumer: signalled on doorbell */
+	fibril_condvar_t cv;
+
+	/** Consumer: doorbell arrived since last checked */
+	bool doorbell;
+
+	/** Consumer: a RING_OP_SPACE request awaits an answer */
+	atomic_bool space_pending;
+
+	/** Consumer: the pending RING_OP_SPACE request */
+	ipc_call_t space_call;
+
+	/** Consumer: number of free bytes the producer waits for */
+	size_t space_needed;
+};
+
+static void ring_copy_in(async_ring_t *ring, uint32_t pos, const void *src,
+    size_t size)
+{
+	uint32_t off = pos & (ring->size - 1);
+	size_t first = min(size, (size_t) (ring->size - off));
+
+	memcpy(ring->data + off, src, first);
+	memcpy(ring->data, src + first, size - first);
+}
+
+static void ring_copy_out(async_ring_t *ring, uint32_t pos, void *dst,
+    size_t size)
+{
+	uint32_t off = pos & (ring->size - 1);
+	size_t first = min(size, (size_t) (ring->size - off));
+
+	memcpy(dst, ring->data + off, first);
+	memcpy(dst + first, ring->data, size - first);
+}
+
+/** Allocate the local part of a ring. */
+static async_ring_t *ring_alloc(void *area, uint32_t size, bool producer)
+{
+	async_ring_t *ring = calloc(1, sizeof(async_ring_t));
+	if (ring == NULL)
+		return NULL;
+
+	ring->shared = (ring_shared_t *) area;
+	ring->data = (uint8_t *) area + RING_DATA_OFFSET;
+	ring->size = size;
+	ring->producer = producer;
+	fibril_mutex_initialize(&ring->lock);
+	fibril_condvar_initialize(&ring->cv);
+
+	return ring;
+}
+
+/** Create a ring with a user argument and share it with a server.
+ *
+ * The server is expected to pass the call to async_ring_handle().
+ * The user argument is sent with every ring call so that the server
+ * can tell several rings on one session apart, see async_ring_arg().
+ *
+ * @param sess   Session to the consumer.
+ * @param method Protocol method used for the ring calls.
+ * @param arg    User argument.
+ * @param size   Requested capacity of the ring in bytes. Rounded up to
+ *               a power of two.
+ * @param rring  Place to store the new ring.
+ *
+ * @return EOK on success, ELIMIT if @a size is too large, ENOMEM if out
+ *         of memory, or an error code returned by the server.
+ *
+ */
+errno_t async_ring_create_arg(async_sess_t *sess, sysarg_t method,
+    sysarg_t arg, size_t size, async_ring_t **rring)
+{
+	if (size > RING_MAX_SIZE)
+		return ELIMIT;
+
+	uint32_t rsize = RING_MIN_SIZE;
+	while (rsize < size)
+		rsize <<= 1;
+
+	size_t asize = ALIGN_UP(RING_DATA_OFFSET + rsize, PAGE_SIZE);
+	void *area = as_area_create(AS_AREA_ANY, asize,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return ENOMEM;
+
+	async_ring_t *ring = ring_alloc(area, rsize, true);
+	if (ring == NULL) {
+		as_area_destroy(area);
+		return ENOMEM;
+	}
+
+	ring->sess = sess;
+	ring->method = method;
+	ring->arg = arg;
+
+	ring_shared_t *shared = ring->shared;
+	shared->magic = RING_MAGIC;
+	shared->size = rsize;
+	atomic_init(&shared->head, 0);
+	atomic_init(&shared->tail, 0);
+	atomic_init(&shared->waiting, 0);
+
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_2(exch, method, RING_OP_SETUP, arg, &answer);
+	errno_t rc = async_share_out_start(exch, area,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		async_ring_destroy(ring);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK) {
+		async_ring_destroy(ring);
+		return retval;
+	}
+
+	*rring = ring;
+	return EOK;
+}
+
+/** Create a ring and share it with a server.
+ *
+ * Same as async_ring_create_arg() with a zero user argument.
+ *
+ * @param sess   Session to the consumer.
+ * @param method Protocol method used for the ring calls.
+ * @param size   Requested capacity of the ring in bytes.
+ * @param rring  Place to store the new ring.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t async_ring_create(async_sess_t *sess, sysarg_t method, size_t size,
+    async_ring_t **rring)
+{
+	return async_ring_create_arg(sess, method, 0, size, rring);
+}
+
+/** Write a message to a ring.
+ *
+ * Blocks while the ring is full. Only one fibril may write to a ring
+ * at a time.
+ *
+ * @param ring Ring created by async_ring_create().
+ * @param buf  Message.
+ * @param size Size of the message in bytes.
+ *
+ * @return EOK on success, ELIMIT if the message can never fit the ring,
+ *         or an error code if waiting for the consumer failed.
+ *
+ */
+errno_t async_ring_write(async_ring_t *ring, const void *buf, size_t size)
+{
+	assert(ring->producer);
+
+	if (size > ring->size - RECORD_HEAD_SIZE)
+		return ELIMIT;
+
+	ring_shared_t *shared = ring->shared;
+	uint32_t rsize = ALIGN_UP(RECORD_HEAD_SIZE + size, RING_ALIGN);
+	uint32_t head = atomic_load_explicit(&shared->head, memory_order_relaxed);
+
+	while (true) {
+		uint32_t tail = atomic_load_explicit(&shared->tail,
+		    memory_order_acquire);
+		if (ring->size - (head - tail) >= rsize)
+			break;
+
+		/* Ring is full, block until the consumer makes room. */
+		async_exch_t *exch = async_exchange_begin(ring->sess);
+		errno_t rc = async_req_3_0(exch, ring->method, RING_OP_SPACE,
+		    ring->arg, rsize);
+		async_exchange_end(exch);
+
+		if (rc != EOK)
+			return rc;
+	}
+
+	uint32_t len = size;
+	ring_copy_in(ring, head, &len, RECORD_HEAD_SIZE);
+	ring_copy_in(ring, head + RECORD_HEAD_SIZE, buf, size);
+
+	atomic_store_explicit(&shared->head, head + rsize, memory_order_seq_cst);
+
+	/* Ring the doorbell only if the consumer waits for it. */
+	if (atomic_exchange_explicit(&shared->waiting, 0, memory_order_seq_cst)) {
+		async_exch_t *exch = async_exchange_begin(ring->sess);
+		async_msg_2(exch, ring->method, RING_OP_DATA, ring->arg);
+		async_exchange_end(exch);
+	}
+
+	return EOK;
+}
+
+/** Answer the pending RING_OP_SPACE request if there is enough room. */
+static void ring_space_check(async_ring_t *ring)
+{
+	if (!atomic_load_explicit(&ring->space_pending, memory_order_seq_cst))
+		return;
+
+	fibril_mutex_lock(&ring->lock);
+
+	if (atomic_load_explicit(&ring->space_pending, memory_order_relaxed)) {
+		ring_shared_t *shared = ring->shared;
+		uint32_t head = atomic_load_explicit(&shared->head,
+		    memory_order_acquire);
+		uint32_t tail = atomic_load_explicit(&shared->tail,
+		    memory_order_seq_cst);
+		uint32_t used = head - tail;
+
+		/* Also let a confused producer go. */
+		if ((used > ring->size) ||
+		    (ring->size - used >= ring->space_needed)) {
+			atomic_store_explicit(&ring->space_pending, false,
+			    memory_order_relaxed);
+			async_answer_0(&ring->space_call, EOK);
+		}
+	}
+
+	fibril_mutex_unlock(&ring->lock);
+}
+
+/** Accept a ring shared by a producer. */
+static errno_t ring_accept(ipc_call_t *icall, async_ring_t **rring)
+{
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return EREFUSED;
+	}
+
+	if ((*rring != NULL) || (size < RING_DATA_OFFSET + RING_MIN_SIZE) ||
+	    ((flags & (AS_AREA_READ | AS_AREA_WRITE)) !=
+	    (AS_AREA_READ | AS_AREA_WRITE))) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return EINVAL;
+	}
+
+	void *area;
+	errno_t rc = async_share_out_finalize(&call, &area);
+	if ((rc != EOK) || (area == AS_MAP_FAILED)) {
+		async_answer_0(icall, ENOMEM);
+		return ENOMEM;
+	}
+
+	/* The producer controls the header, validate it once. */
+	ring_shared_t *shared = (ring_shared_t *) area;
+	uint32_t rsize = shared->size;
+
+	if ((shared->magic != RING_MAGIC) || (rsize < RING_MIN_SIZE) ||
+	    (rsize > RING_MAX_SIZE) || ((rsize & (rsize - 1)) != 0) ||
+	    (RING_DATA_OFFSET + rsize > size)) {
+		as_area_destroy(area);
+		async_answer_0(icall, EINVAL);
+		return EINVAL;
+	}
+
+	async_ring_t *ring = ring_alloc(area, rsize, false);
+	if (ring == NULL) {
+		as_area_destroy(area);
+		async_answer_0(icall, ENOMEM);
+		return ENOMEM;
+	}
+
+	ring->tail = atomic_load_explicit(&shared->tail, memory_order_relaxed);
+
+	*rring = ring;
+	async_answer_0(icall, EOK);
+	return EOK;
+}
+
+/** Get the user argument of a ring call.
+ *
+ * @param call Call with the ring method.
+ *
+ * @return User argument passed to async_ring_create_arg().
+ *
+ */
+sysarg_t async_ring_arg(ipc_call_t *call)
+{
+	return ipc_get_arg2(call);
+}
+
+/** Handle a ring call on the consumer side.
+ *
+ * Sets up a new ring or processes a doorbell. After a doorbell, the
+ * caller should drain the ring using async_ring_read(), unless another
+ * fibril is blocked in async_ring_read_wait().
+ *
+ * @param call  Call with the ring method.
+ * @param rring Ring of the connection. A new ring is stored here,
+ *              it must be NULL before the ring is set up.
+ *
+ * @return EOK on success or an error code. The call is always answered.
+ *
+ */
+errno_t async_ring_handle(ipc_call_t *call, async_ring_t **rring)
+{
+	sysarg_t op = ipc_get_arg1(call);
+	async_ring_t *ring = *rring;
+
+	if (op == RING_OP_SETUP)
+		return ring_accept(call, rring);
+
+	if ((ring == NULL) || (ring->producer)) {
+		async_answer_0(call, EINVAL);
+		return EINVAL;
+	}
+
+	switch (op) {
+	case RING_OP_DATA:
+		async_answer_0(call, EOK);
+
+		fibril_mutex_lock(&ring->lock);
+		ring->doorbell = true;
+		fibril_condvar_broadcast(&ring->cv);
+		fibril_mutex_unlock(&ring->lock);
+		return EOK;
+	case RING_OP_SPACE:
+		fibril_mutex_lock(&ring->lock);
+
+		if (atomic_load_explicit(&ring->space_pending,
+		    memory_order_relaxed)) {
+			fibril_mutex_unlock(&ring->lock);
+			async_answer_0(call, EBUSY);
+			return EBUSY;
+		}
+
+		ring->space_call = *call;
+		ring->space_needed = ipc_get_arg3(call);
+		atomic_store_explicit(&ring->space_pending, true,
+		    memory_order_seq_cst);
+
+		fibril_mutex_unlock(&ring->lock);
+
+		/* The ring might have been drained in the meantime. */
+		ring_space_check(ring);
+		return EOK;
+	default:
+		async_answer_0(call, EINVAL);
+		return EINVAL;
+	}
+}
+
+/** Take one message from the ring, if there is any. */
+static errno_t ring_read_internal(async_ring_t *ring, void *buf, size_t size,
+    size_t *rsize)
+{
+	ring_shared_t *shared = ring->shared;
+	uint32_t tail = ring->tail;
+	uint32_t head = atomic_load_explicit(&shared->head,
+	    memory_order_acquire);
+
+	if (head == tail)
+		return ENOENT;
+
+	/* The producer controls the ring contents, do not trust them. */
+	uint32_t avail = head - tail;
+	if ((avail > ring->size) || (avail < RECORD_HEAD_SIZE))
+		return EIO;
+
+	uint32_t len;
+	ring_copy_out(ring, tail, &len, RECORD_HEAD_SIZE);
+
+	size_t rec = ALIGN_UP(RECORD_HEAD_SIZE + (size_t) len, RING_ALIGN);
+	if (rec > avail)
+		return EIO;
+
+	*rsize = len;
+	if (len > size)
+		return EOVERFLOW;
+
+	ring_copy_out(ring, tail + RECORD_HEAD_SIZE, buf, len);
+
+	ring->tail = tail + rec;
+	atomic_store_explicit(&shared->tail, ring->tail, memory_order_seq_cst);
+
+	ring_space_check(ring);
+	return EOK;
+}
+
+/** Read a message from a ring without blocking.
+ *
+ * Only one fibril may read from a ring at a time. When the ring is found
+ * empty, the producer rings the doorbell on its next write.
+ *
+ * @param ring  Ring set up by async_ring_handle().
+ * @param buf   Buffer for the message.
+ * @param size  Size of the buffer.
+ * @param rsize Place to store the size of the message.
+ *
+ * @return EOK on success, ENOENT if the ring is empty, EOVERFLOW if
+ *         the message does not fit the buffer (it is left in the ring
+ *         and its size is stored to @a rsize), EIO if the ring is
+ *         corrupted.
+ *
+ */
+errno_t async_ring_read(async_ring_t *ring, void *buf, size_t size,
+    size_t *rsize)
+{
+	assert(!ring->producer);
+
+	errno_t rc = ring_read_internal(ring, buf, size, rsize);
+	if (rc != ENOENT)
+		return rc;
+
+	/* Ask for a doorbell and look again, the producer might have won. */
+	atomic_store_explicit(&ring->shared->waiting, 1, memory_order_seq_cst);
+
+	rc = ring_read_internal(ring, buf, size, rsize);
+	if (rc != ENOENT) {
+		atomic_store_explicit(&ring->shared->waiting, 0,
+		    memory_order_relaxed);
+	}
+
+	return rc;
+}
+
+/** Read a message from a ring, waiting for one if the ring is empty.
+ *
+ * The doorbell calls must be passed to async_ring_handle() by another
+ * fibril, typically the connection fibril.
+ *
+ * @param ring  Ring set up by async_ring_handle().
+ * @param buf   Buffer for the message.
+ * @param size  Size of the buffer.
+ * @param rsize Place to store the size of the message.
+ *
+ * @return Same as async_ring_read(), except for never returning ENOENT.
+ *
+ */
+errno_t async_ring_read_wait(async_ring_t *ring, void *buf, size_t size,
+    size_t *rsize)
+{
+	while (true) {
+		errno_t rc = async_ring_read(ring, buf, size, rsize);
+		if (rc != ENOENT)
+			return rc;
+
+		fibril_mutex_lock(&ring->lock);
+		while (!ring->doorbell)
+			fibril_condvar_wait(&ring->cv, &ring->lock);
+		ring->doorbell = false;
+		fibril_mutex_unlock(&ring->lock);
+	}
+}
+
+/** Destroy the local end of a ring.
+ *
+ * A pending producer request for space is answered with EHANGUP.
+ *
+ * @param ring Ring to destroy.
+ *
+ */
+void async_ring_destroy(async_ring_t *ring)
+{
+	if (ring == NULL)
+		return;
+
+	if (atomic_load_explicit(&ring->space_pending, memory_order_relaxed))
+		async_answer_0(&ring->space_call, EHANGUP);
+
+	as_area_destroy(ring->shared);
+	free(ring);
+}
+
+/** @}
+ */
@@ -111,6 +111,7 @@
 #include <errno.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <mem.h>
 #include <stdlib.h>
@@ -123,6 +124,9 @@
 
 #define DPRINTF(...)  ((void) 0)
 
+/** Number of independently locked parts of the client hash table. */
+#define CLIENT_SHARDS  8
+
 /* Client connection data */
 typedef struct {
 	ht_link_t link;
@@ -132,6 +136,14 @@ typedef struct {
 	void *data;
 } client_t;
 
+/* Message queued for a connection fibril */
+typedef struct {
+	ipc_call_t call;
+
+	/** Arrival time, 0 if statistics were disabled at the time. */
+	usec_t arrival;
+} conn_msg_t;
+
 /* Server connection data */
 typedef struct {
 	/** Fibril handling the connection. */
@@ -157,6 +169,21 @@ typedef struct {
 
 	/** Client data */
 	void *data;
+
+	/** Interface of the connection. */
+	iface_t iface;
+
+	/** Method of the call being handled, 0 if not accounted. */
+	sysarg_t stats_imethod;
+
+	/** Queueing delay of the call being handled. */
+	usec_t stats_queue;
+
+	/** Dispatch time of the call being handled. */
+	usec_t stats_start;
+
+	/** Fibril run time at the dispatch of the call being handled. */
+	usec_t stats_run;
 } connection_t;
 
 /* Member of notification_t::msg_list. */
@@ -187,7 +214,10 @@ typedef struct {
 } notification_t;
 
 /** Identifier of the incoming connection handled by the current fibril. */
-static fibril_local connection_t *fibril_connection;
+static inline connection_t *fibril_connection(void)
+{
+	return __tls_slot(TLS_SLOT_ASYNC_CONN)->ptr;
+}
 
 static void *default_client_data_constructor(void)
 {
@@ -215,8 +245,20 @@ void async_set_client_data_destructor(async_client_data_dtor_t dtor)
 	async_client_data_destroy = dtor;
 }
 
-static fibril_rmutex_t client_mutex;
-static hash_table_t client_hash_table;
+/** Part of the client hash table. */
+typedef struct {
+	fibril_rmutex_t mutex;
+	hash_table_t table;
+} client_shard_t;
+
+static client_shard_t client_shards[CLIENT_SHARDS];
+
+/** Serializes async_set_manager_threads(). */
+static FIBRIL_MUTEX_INITIALIZE(manager_mutex);
+static unsigned int manager_count = 1;
+
+/** Whether connection fibrils are bound to a runner thread. */
+static atomic_bool connection_affinity = false;
 
 // TODO: lockfree notification_queue?
 static fibril_rmutex_t notification_mutex;
@@ -258,12 +300,18 @@ static hash_table_ops_t client_hash_table_ops = {
 	.remove_callback = NULL
 };
 
+static client_shard_t *client_shard(task_id_t client_id)
+{
+	return &client_shards[client_id % CLIENT_SHARDS];
+}
+
 static client_t *async_client_get(task_id_t client_id, bool create)
 {
+	client_shard_t *shard = client_shard(client_id);
 	client_t *client = NULL;
 
-	fibril_rmutex_lock(&client_mutex);
-	ht_link_t *link = hash_table_find(&client_hash_table, &client_id);
+	fibril_rmutex_lock(&shard->mutex);
+	ht_link_t *link = hash_table_find(&shard->table, &client_id);
 	if (link) {
 		client = hash_table_get_inst(link, client_t, link);
 		client->refcnt++;
@@ -276,27 +324,28 @@ static client_t *async_client_get(task_id_t client_id, bool create)
 			client->data = async_client_data_create();
 
 			client->refcnt = 1;
-			hash_table_insert(&client_hash_table, &client->link);
+			hash_table_insert(&shard->table, &client->link);
 		}
 	}
 
-	fibril_rmutex_unlock(&client_mutex);
+	fibril_rmutex_unlock(&shard->mutex);
 	return client;
 }
 
 static void async_client_put(client_t *client)
 {
+	client_shard_t *shard = client_shard(client->in_task_id);
 	bool destroy;
 
-	fibril_rmutex_lock(&client_mutex);
+	fibril_rmutex_lock(&shard->mutex);
 
 	if (--client->refcnt == 0) {
-		hash_table_remove(&client_hash_table, &client->in_task_id);
+		hash_table_remove(&shard->table, &client->in_task_id);
 		destroy = true;
 	} else
 		destroy = false;
 
-	fibril_rmutex_unlock(&client_mutex);
+	fibril_rmutex_unlock(&shard->mutex);
 
 	if (destroy) {
 		if (client->data)
@@ -316,16 +365,47 @@ static void async_client_put(client_t *client)
  * @return Always zero.
  *
  */
+/** Account the call the connection fibril has finished handling. */
+static void connection_stats_done(connection_t *conn)
+{
+	if (conn->stats_imethod == 0)
+		return;
+
+	__async_stats_call(conn->in_task_id, conn->iface, conn->stats_imethod,
+	    conn->stats_queue, __async_stats_now() - conn->stats_start,
+	    __fibril_run_usec() - conn->stats_run);
+
+	conn->stats_imethod = 0;
+}
+
+/** Start accounting a call dispatched to the connection fibril. */
+static void connection_stats_start(connection_t *conn, conn_msg_t *msg)
+{
+	if ((msg->arrival == 0) || (conn->iface == INTERFACE_ASYNC_STATS))
+		return;
+
+	sysarg_t imethod = ipc_get_imethod(&msg->call);
+	if (imethod == IPC_M_PHONE_HUNGUP)
+		return;
+
+	conn->stats_imethod = imethod;
+	conn->stats_start = __async_stats_now();
+	conn->stats_queue = conn->stats_start - msg->arrival;
+	conn->stats_run = __fibril_run_usec();
+}
+
 static errno_t connection_fibril(void *arg)
 {
-	assert(arg);
+	connection_t *conn = (connection_t *) arg;
+
+	assert(conn);
 
 	/*
 	 * Setup fibril-local connection pointer.
 	 */
-	fibril_connection = (connection_t *) arg;
+	__tls_slot(TLS_SLOT_ASYNC_CONN)->ptr = conn;
 
-	mpsc_t *c = fibril_connection->msg_channel;
+	mpsc_t *c = conn->msg_channel;
 
 	/*
 	 * Add our reference for the current connection in the client task
@@ -333,19 +413,25 @@ static errno_t connection_fibril(void *arg)
 	 * hash in a new tracking structure.
 	 */
 
-	client_t *client = async_client_get(fibril_connection->in_task_id, true);
+	client_t *client = async_client_get(conn->in_task_id, true);
 	if (!client) {
-		ipc_answer_0(fibril_connection->call.cap_handle, ENOMEM);
+		ipc_answer_0(conn->call.cap_handle, ENOMEM);
 		goto out;
 	}
 
-	fibril_connection->client = client;
+	conn->client = client;
+
+	if (atomic_load_explicit(&__async_stats_enabled,
+	    memory_order_relaxed) && (conn->iface != INTERFACE_ASYNC_STATS))
+		__async_stats_connection(conn->in_task_id, conn->iface);
 
 	/*
 	 * Call the connection handler function.
 	 */
-	fibril_connection->handler(&fibril_connection->call,
-	    fibril_connection->data);
+	conn->handler(&conn->call,
+	    conn->data);
+
+	connection_stats_done(conn);
 
 	/*
 	 * Remove the reference for this client task connection.
@@ -360,23 +446,23 @@ static errno_t connection_fibril(void *arg)
 	/*
 	 * Answer all remaining messages with EHANGUP.
 	 */
-	ipc_call_t call;
-	while (mpsc_receive(c, &call, NULL) == EOK)
-		ipc_answer_0(call.cap_handle, EHANGUP);
+	conn_msg_t msg;
+	while (mpsc_receive(c, &msg, NULL) == EOK)
+		ipc_answer_0(msg.call.cap_handle, EHANGUP);
 
 	/*
 	 * Clean up memory.
 	 */
 out:
 	mpsc_destroy(c);
-	free(fibril_connection);
+	free(conn);
 	return EOK;
 }
 
 /** Return label usable during replies to IPC_M_CONNECT_ME_TO. */
 sysarg_t async_get_label(void)
 {
-	return (sysarg_t) fibril_connection;
+	return (sysarg_t) fibril_connection();
 }
 
 /** Create a new fibril for a new connection.
@@ -403,7 +489,7 @@ static fid_t async_new_connection(connection_t *conn, task_id_t in_task_id,
     ipc_call_t *call, async_port_handler_t handler, void *data)
 {
 	conn->in_task_id = in_task_id;
-	conn->msg_channel = mpsc_create(sizeof(ipc_call_t));
+	conn->msg_channel = mpsc_create(sizeof(conn_msg_t));
 	conn->handler = handler;
 	conn->data = data;
 
@@ -421,6 +507,9 @@ static fid_t async_new_connection(connection_t *conn, task_id_t in_task_id,
 	if (conn->fid == 0)
 		goto error;
 
+	if (atomic_load_explicit(&connection_affinity, memory_order_relaxed))
+		fibril_bind_runner((fibril_t *) conn->fid);
+
 	fibril_start(conn->fid);
 
 	return conn->fid;
@@ -464,6 +553,8 @@ errno_t async_create_callback_port(async_exch_t *exch, iface_t iface, sysarg_t a
 	if (!conn)
 		return ENOMEM;
 
+	conn->iface = iface;
+
 	ipc_call_t answer;
 	aid_t req = async_send_5(exch, IPC_M_CONNECT_TO_ME, iface, arg1, arg2,
 	    0, (sysarg_t) conn, &answer);
@@ -543,7 +634,12 @@ static errno_t route_call(ipc_call_t *call)
 
 	assert(conn->msg_channel);
 
-	errno_t rc = mpsc_send(conn->msg_channel, call);
+	conn_msg_t msg;
+	msg.call = *call;
+	msg.arrival = atomic_load_explicit(&__async_stats_enabled,
+	    memory_order_relaxed) ? __async_stats_now() : 0;
+
+	errno_t rc = mpsc_send(conn->msg_channel, &msg);
 
 	if (ipc_get_imethod(call) == IPC_M_PHONE_HUNGUP) {
 		/* Close the channel, but let the connection fibril answer. */
@@ -847,7 +943,10 @@ errno_t async_event_task_unmask(event_task_type_t evno)
 bool async_get_call_timeout(ipc_call_t *call, usec_t usecs)
 {
 	assert(call);
-	assert(fibril_connection);
+	assert(fibril_connection());
+
+	connection_t *conn = fibril_connection();
+	connection_stats_done(conn);
 
 	struct timespec ts;
 	struct timespec *expires = NULL;
@@ -857,12 +956,17 @@ bool async_get_call_timeout(ipc_call_t *call, usec_t usecs)
 		expires = &ts;
 	}
 
-	errno_t rc = mpsc_receive(fibril_connection->msg_channel,
-	    call, expires);
+	conn_msg_t msg;
+	errno_t rc = mpsc_receive(conn->msg_channel, &msg, expires);
 
 	if (rc == ETIMEOUT)
 		return false;
 
+	if (rc == EOK) {
+		*call = msg.call;
+		connection_stats_start(conn, &msg);
+	}
+
 	if (rc != EOK) {
 		/*
 		 * The async_get_call_timeout() interface doesn't support
@@ -884,8 +988,8 @@ bool async_get_call(ipc_call_t *call)
 
 void *async_get_client_data(void)
 {
-	assert(fibril_connection);
-	return fibril_connection->client->data;
+	assert(fibril_connection());
+	return fibril_connection()->client->data;
 }
 
 void *async_get_client_data_by_id(task_id_t client_id)
@@ -951,11 +1055,15 @@ static void handle_call(ipc_call_t *call)
 		}
 
 		iface_t iface = (iface_t) ipc_get_arg1(call);
+		conn->iface = iface;
 
 		// TODO: Currently ignores all ports but the first one.
-		void *data;
-		async_port_handler_t handler =
-		    async_get_port_handler(iface, 0, &data);
+		void *data = NULL;
+		async_port_handler_t handler;
+		if (iface == INTERFACE_ASYNC_STATS)
+			handler = __async_stats_conn;
+		else
+			handler = async_get_port_handler(iface, 0, &data);
 
 		async_new_connection(conn, call->task_id, call, handler, data);
 		return;
@@ -1010,34 +1118,92 @@ static errno_t async_manager_fibril(void *arg)
 static fid_t async_create_manager(void)
 {
 	fid_t fid = fibril_create_generic(async_manager_fibril, NULL, PAGE_SIZE);
+	if (fid == 0)
+		return 0;
+
+	if (atomic_load_explicit(&connection_affinity, memory_order_relaxed))
+		fibril_bind_runner((fibril_t *) fid);
+
 	fibril_start(fid);
 	return fid;
 }
 
+/** Dispatch incoming calls on several threads.
+ *
+ * Spawns runner threads and manager fibrils so that there are @a n of
+ * each, with the new managers spread over the runners. From then on, every new
+ * connection fibril gets bound to one runner, so that its calls tend to
+ * be handled by the same thread. The number of managers never decreases.
+ *
+ * The connection handlers of the server must be ready to run in
+ * parallel.
+ *
+ * @param n Number of manager threads.
+ *
+ * @return EOK on success, ENOMEM if fewer than @a n threads could be set up.
+ *
+ */
+errno_t async_set_manager_threads(unsigned int n)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&manager_mutex);
+
+	if (n > manager_count) {
+		int more = n - manager_count;
+		int spawned = fibril_test_spawn_runners(more);
+		if (spawned < more)
+			rc = ENOMEM;
+
+		atomic_store_explicit(&connection_affinity, true,
+		    memory_order_relaxed);
+
+		for (int i = 0; i < spawned; i++) {
+			if (async_create_manager() == 0) {
+				rc = ENOMEM;
+				break;
+			}
+
+			manager_count++;
+		}
+	}
+
+	fibril_mutex_unlock(&manager_mutex);
+	return rc;
+}
+
 /** Initialize the async framework.
  *
  */
 void __async_server_init(void)
 {
-	if (fibril_rmutex_initialize(&client_mutex) != EOK)
-		abort();
-	if (fibril_rmutex_initialize(&notification_mutex) != EOK)
-		abort();
+	for (size_t i = 0; i < CLIENT_SHARDS; i++) {
+		if (fibril_rmutex_initialize(&client_shards[i].mutex) != EOK)
+			abort();
+		if (!hash_table_create(&client_shards[i].table, 0, 0,
+		    &client_hash_table_ops))
+			abort();
+	}
 
-	if (!hash_table_create(&client_hash_table, 0, 0, &client_hash_table_ops))
+	if (fibril_rmutex_initialize(&notification_mutex) != EOK)
 		abort();
 
 	if (!hash_table_create(&notification_hash_table, 0, 0,
 	    &notification_hash_table_ops))
 		abort();
 
+	__async_stats_init();
+
 	async_create_manager();
 }
 
 void __async_server_fini(void)
 {
-	fibril_rmutex_destroy(&client_mutex);
+	for (size_t i = 0; i < CLIENT_SHARDS; i++)
+		fibril_rmutex_destroy(&client_shards[i].mutex);
+
 	fibril_rmutex_destroy(&notification_mutex);
+	__async_stats_fini();
 }
 
 errno_t async_accept_0(ipc_call_t *call)
@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Async framework statistics
+ *
+ * While enabled, the async framework accounts every call handled by
+ * a connection fibril to its interface and method and to the client task
+ * which made it. Both tables have a fixed size and are hashed by their
+ * key. Calls which find their table full are accounted to the first
+ * entry, which has a zero key.
+ */
+
+#include <async.h>
+#include <async_stats.h>
+#include <bitops.h>
+#include <errno.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../private/async.h"
+#include "../private/fibril.h"
+
+/** Number of entries in the method statistics table */
+#define STATS_METHODS  128
+
+/** Number of entries in the client statistics table */
+#define STATS_CLIENTS  64
+
+typedef enum {
+	ASYNC_STATS_ENABLE = IPC_FIRST_USER_METHOD,
+	ASYNC_STATS_RESET,
+	ASYNC_STATS_READ_METHODS,
+	ASYNC_STATS_READ_CLIENTS
+} async_stats_request_t;
+
+atomic_bool __async_stats_enabled = false;
+
+static fibril_rmutex_t stats_mutex;
+static async_method_stats_t method_stats[STATS_METHODS];
+static async_client_stats_t client_stats[STATS_CLIENTS];
+
+void __async_stats_init(void)
+{
+	if (fibril_rmutex_initialize(&stats_mutex) != EOK)
+		abort();
+}
+
+void __async_stats_fini(void)
+{
+	fibril_rmutex_destroy(&stats_mutex);
+}
+
+/** Current uptime in microseconds. */
+usec_t __async_stats_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+static async_method_stats_t *method_stats_get(iface_t iface, sysarg_t imethod)
+{
+	size_t start = (iface ^ (imethod * 31)) % (STATS_METHODS - 1);
+
+	for (size_t i = 0; i < STATS_METHODS - 1; i++) {
+		async_method_stats_t *ms =
+		    &method_stats[1 + (start + i) % (STATS_METHODS - 1)];
+
+		if ((ms->iface == iface) && (ms->imethod == imethod))
+			return ms;
+
+		if (ms->calls == 0) {
+			ms->iface = iface;
+			ms->imethod = imethod;
+			return ms;
+		}
+	}
+
+	/* Table full, use the catch-all entry */
+	return &method_stats[0];
+}
+
+static async_client_stats_t *client_stats_get(task_id_t task_id,
+    iface_t iface)
+{
+	size_t start = (iface ^ (task_id * 31)) % (STATS_CLIENTS - 1);
+
+	for (size_t i = 0; i < STATS_CLIENTS - 1; i++) {
+		async_client_stats_t *cs =
+		    &client_stats[1 + (start + i) % (STATS_CLIENTS - 1)];
+
+		if ((cs->task_id == task_id) && (cs->iface == iface))
+			return cs;
+
+		if ((cs->connections == 0) && (cs->calls == 0)) {
+			cs->task_id = task_id;
+			cs->iface = iface;
+			return cs;
+		}
+	}
+
+	return &client_stats[0];
+}
+
+/** Account a new connection.
+ *
+ * @param task_id Client task
+ * @param iface   Interface of the connection
+ */
+void __async_stats_connection(task_id_t task_id, iface_t iface)
+{
+	fibril_rmutex_lock(&stats_mutex);
+	client_stats_get(task_id, iface)->connections++;
+	fibril_rmutex_unlock(&stats_mutex);
+}
+
+/** Account a call handled by a connection fibril.
+ *
+ * @param task_id Client task
+ * @param iface   Interface of the connection
+ * @param imethod Method of the call
+ * @param queue   Queueing delay in microseconds
+ * @param service Service time in microseconds
+ * @param run     Run time in microseconds
+ */
+void __async_stats_call(task_id_t task_id, iface_t iface, sysarg_t imethod,
+    usec_t queue, usec_t service, usec_t run)
+{
+	unsigned int bucket = 0;
+	if (service > 0) {
+		bucket = min(fnzb64((uint64_t) service) + 1,
+		    ASYNC_STATS_BUCKETS - 1);
+	}
+
+	fibril_rmutex_lock(&stats_mutex);
+
+	async_method_stats_t *ms = method_stats_get(iface, imethod);
+	ms->calls++;
+	ms->queue_usec += queue;
+	ms->queue_max_usec = max(ms->queue_max_usec, (uint64_t) queue);
+	ms->service_usec += service;
+	ms->service_max_usec = max(ms->service_max_usec, (uint64_t) service);
+	ms->run_usec += run;
+	ms->service_hist[bucket]++;
+
+	async_client_stats_t *cs = client_stats_get(task_id, iface);
+	cs->calls++;
+	cs->service_usec += service;
+	cs->run_usec += run;
+
+	fibril_rmutex_unlock(&stats_mutex);
+}
+
+static void stats_enable(ipc_call_t *call)
+{
+	bool enable = ipc_get_arg1(call) != 0;
+
+	if (enable) {
+		/* Map the uptime page before it is needed in context switch */
+		(void) __async_stats_now();
+	}
+
+	__fibril_accounting_set(enable);
+	atomic_store(&__async_stats_enabled, enable);
+	async_answer_0(call, EOK);
+}
+
+static void stats_reset(ipc_call_t *call)
+{
+	fibril_rmutex_lock(&stats_mutex);
+	memset(method_stats, 0, sizeof(method_stats));
+	memset(client_stats, 0, sizeof(client_stats));
+	fibril_rmutex_unlock(&stats_mutex);
+
+	async_answer_0(call, EOK);
+}
+
+/** Send the used entries of a statistics table to the client.
+ *
+ * @param call  Read request
+ * @param table Table
+ * @param esize Size of a table entry
+ * @param count Number of table entries
+ * @param used  Returns true if the entry is used
+ */
+static void stats_read(ipc_call_t *call, const void *table, size_t esize,
+    size_t count, bool (*used)(const void *))
+{
+	ipc_call_t rcall;
+	size_t size;
+
+	if (!async_data_read_receive(&rcall, &size)) {
+		async_answer_0(&rcall, EREFUSED);
+		async_answer_0(call, EREFUSED);
+		return;
+	}
+
+	size_t max = min(size / esize, count);
+	uint8_t *buf = malloc(max * esize);
+	if ((buf == NULL) && (max > 0)) {
+		async_answer_0(&rcall, ENOMEM);
+		async_answer_0(call, ENOMEM);
+		return;
+	}
+
+	size_t n = 0;
+
+	fibril_rmutex_lock(&stats_mutex);
+
+	for (size_t i = 0; (i < count) && (n < max); i++) {
+		const void *entry = (const uint8_t *) table + i * esize;
+		if (used(entry)) {
+			memcpy(buf + n * esize, entry, esize);
+			n++;
+		}
+	}
+
+	fibril_rmutex_unlock(&stats_mutex);
+
+	errno_t rc = async_data_read_finalize(&rcall, buf, n * esize);
+	free(buf);
+
+	async_answer_1(call, rc, n);
+}
+
+static bool method_stats_used(const void *entry)
+{
+	return ((const async_method_stats_t *) entry)->calls != 0;
+}
+
+static bool client_stats_used(const void *entry)
+{
+	const async_client_stats_t *cs = entry;
+	return (cs->connections != 0) || (cs->calls != 0);
+}
+
+/** Handle a connection to INTERFACE_ASYNC_STATS.
+ *
+ * @param icall Opening call
+ * @param arg   Not used
+ */
+void __async_stats_conn(ipc_call_t *icall, void *arg)
+{
+	async_accept_0(icall);
+
+	while (true) {
+		ipc_call_t call;
+		async_get_call(&call);
+
+		if (!ipc_get_imethod(&call)) {
+			async_answer_0(&call, EOK);
+			return;
+		}
+
+		switch (ipc_get_imethod(&call)) {
+		case ASYNC_STATS_ENABLE:
+			stats_enable(&call);
+			break;
+		case ASYNC_STATS_RESET:
+			stats_reset(&call);
+			break;
+		case ASYNC_STATS_READ_METHODS:
+			stats_read(&call, method_stats,
+			    sizeof(async_method_stats_t), STATS_METHODS,
+			    method_stats_used);
+			break;
+		case ASYNC_STATS_READ_CLIENTS:
+			stats_read(&call, client_stats,
+			    sizeof(async_client_stats_t), STATS_CLIENTS,
+			    client_stats_used);
+			break;
+		default:
+			async_answer_0(&call, EINVAL);
+			break;
+		}
+	}
+}
+
+/** Enable or disable collecting statistics in a server.
+ *
+ * @param sess   Session to INTERFACE_ASYNC_STATS of the server
+ * @param enable @c true to enable, @c false to disable
+ * @return EOK on success or an error code
+ */
+errno_t async_stats_enable(async_sess_t *sess, bool enable)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	errno_t rc = async_req_1_0(exch, ASYNC_STATS_ENABLE, enable);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/** Clear the statistics of a server.
+ *
+ * @param sess Session to INTERFACE_ASYNC_STATS of the server
+ * @return EOK on success or an error code
+ */
+errno_t async_stats_reset(async_sess_t *sess)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	errno_t rc = async_req_0_0(exch, ASYNC_STATS_RESET);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+static errno_t async_stats_read(async_sess_t *sess, sysarg_t method,
+    void *buf, size_t size, size_t *count)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, method, &answer);
+	errno_t rc = async_data_read_start(exch, buf, size);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK)
+		return retval;
+
+	*count = ipc_get_arg1(&answer);
+	return EOK;
+}
+
+/** Read the per-method statistics of a server.
+ *
+ * @param sess  Session to INTERFACE_ASYNC_STATS of the server
+ * @param stats Array to fill in
+ * @param max   Number of entries in @a stats
+ * @param count Place to store the number of entries filled in
+ * @return EOK on success or an error code
+ */
+errno_t async_stats_read_methods(async_sess_t *sess,
+    async_method_stats_t *stats, size_t max, size_t *count)
+{
+	return async_stats_read(sess, ASYNC_STATS_READ_METHODS, stats,
+	    max * sizeof(async_method_stats_t), count);
+}
+
+/** Read the per-client statistics of a server.
+ *
+ * @param sess  Session to INTERFACE_ASYNC_STATS of the server
+ * @param stats Array to fill in
+ * @param max   Number of entries in @a stats
+ * @param count Place to store the number of entries filled in
+ * @return EOK on success or an error code
+ */
+errno_t async_stats_read_clients(async_sess_t *sess,
+    async_client_stats_t *stats, size_t max, size_t *count)
+{
+	return async_stats_read(sess, ASYNC_STATS_READ_CLIENTS, stats,
+	    max * sizeof(async_client_stats_t), count);
+}
+
+/** @}
+ */
@@ -34,10 +34,15 @@
  * @brief Block device client interface
  */
 
+#include <abi/ipc/methods.h>
+#include <align.h>
+#include <as.h>
 #include <async.h>
 #include <assert.h>
 #include <bd.h>
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <ipc/bd.h>
 #include <ipc/services.h>
 #include <loc.h>
@@ -46,6 +51,8 @@
 #include <offset.h>
 
 static void bd_cb_conn(ipc_call_t *icall, void *arg);
+static errno_t bd_xfer_pipelined(bd_t *, sysarg_t, aoff64_t, size_t, void *,
+    size_t);
 
 errno_t bd_open(async_sess_t *sess, bd_t **rbd)
 {
@@ -54,6 +61,11 @@ errno_t bd_open(async_sess_t *sess, bd_t **rbd)
 		return ENOMEM;
 
 	bd->sess = sess;
+	fibril_mutex_initialize(&bd->lock);
+	fibril_condvar_initialize(&bd->cv);
+	list_initialize(&bd->reqs);
+	bd->nreqs = 0;
+	bd->reaper = false;
 
 	async_exch_t *exch = async_exchange_begin(sess);
 
@@ -66,6 +78,11 @@ errno_t bd_open(async_sess_t *sess, bd_t **rbd)
 	if (rc != EOK)
 		goto error;
 
+	/* Servers not reporting their queue depth take one request at a time */
+	if (bd_get_queue_depth(bd, &bd->queue_depth) != EOK ||
+	    bd->queue_depth == 0)
+		bd->queue_depth = 1;
+
 	*rbd = bd;
 	return EOK;
 
@@ -78,12 +95,19 @@ error:
 
 void bd_close(bd_t *bd)
 {
+	bd_wait_idle(bd);
+
 	/* XXX Synchronize with bd_cb_conn */
 	free(bd);
 }
 
 errno_t bd_read_blocks(bd_t *bd, aoff64_t ba, size_t cnt, void *data, size_t size)
 {
+	if (size > DATA_XFER_LIMIT && cnt > 0 && size % cnt == 0 &&
+	    size / cnt <= DATA_XFER_LIMIT)
+		return bd_xfer_pipelined(bd, BD_READ_BLOCKS, ba, cnt, data,
+		    size / cnt);
+
 	async_exch_t *exch = async_exchange_begin(bd->sess);
 
 	ipc_call_t answer;
@@ -132,6 +156,11 @@ errno_t bd_read_toc(bd_t *bd, uint8_t session, void *buf, size_t size)
 errno_t bd_write_blocks(bd_t *bd, aoff64_t ba, size_t cnt, const void *data,
     size_t size)
 {
+	if (size > DATA_XFER_LIMIT && cnt > 0 && size % cnt == 0 &&
+	    size / cnt <= DATA_XFER_LIMIT)
+		return bd_xfer_pipelined(bd, BD_WRITE_BLOCKS, ba, cnt,
+		    (void *) data, size / cnt);
+
 	async_exch_t *exch = async_exchange_begin(bd->sess);
 
 	ipc_call_t answer;
@@ -153,6 +182,61 @@ errno_t bd_write_blocks(bd_t *bd, aoff64_t ba, size_t cnt, const void *data,
 	return EOK;
 }
 
+/** Transfer blocks in several requests kept in flight on one exchange.
+ *
+ * A single IPC_M_DATA_READ or IPC_M_DATA_WRITE cannot carry more than
+ * DATA_XFER_LIMIT bytes, so larger transfers are split into chunks of
+ * whole blocks, up to ASYNC_BATCH_MAX of which are in flight at a time.
+ *
+ * @param bd     Block device
+ * @param method BD_READ_BLOCKS or BD_WRITE_BLOCKS
+ * @param ba     Address of the first block
+ * @param cnt    Number of blocks
+ * @param data   Buffer of @a cnt * @a bsize bytes
+ * @param bsize  Block size, at most DATA_XFER_LIMIT
+ *
+ * @return EOK on success or an error code of the first failed chunk
+ */
+static errno_t bd_xfer_pipelined(bd_t *bd, sysarg_t method, aoff64_t ba,
+    size_t cnt, void *data, size_t bsize)
+{
+	uint8_t *bp = (uint8_t *) data;
+	size_t chunk_blocks = DATA_XFER_LIMIT / bsize;
+	async_batch_t batch;
+	size_t sent = 0;
+	errno_t rc = EOK;
+
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+	async_batch_init(&batch, exch);
+
+	while (rc == EOK && (sent < cnt || async_batch_pending(&batch) > 0)) {
+		while (sent < cnt &&
+		    async_batch_pending(&batch) < ASYNC_BATCH_MAX) {
+			size_t n = min(cnt - sent, chunk_blocks);
+			aoff64_t cba = ba + sent;
+
+			if (method == BD_WRITE_BLOCKS) {
+				async_batch_data_write_3(&batch, method,
+				    LOWER32(cba), UPPER32(cba), n,
+				    bp + sent * bsize, n * bsize);
+			} else {
+				async_batch_data_read_3(&batch, method,
+				    LOWER32(cba), UPPER32(cba), n,
+				    bp + sent * bsize, n * bsize);
+			}
+
+			sent += n;
+		}
+
+		rc = async_batch_wait(&batch, NULL);
+	}
+
+	async_batch_drain(&batch);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
 errno_t bd_sync_cache(bd_t *bd, aoff64_t ba, size_t cnt)
 {
 	async_exch_t *exch = async_exchange_begin(bd->sess);
@@ -164,6 +248,26 @@ errno_t bd_sync_cache(bd_t *bd, aoff64_t ba, size_t cnt)
 	return rc;
 }
 
+/** Set blocks to zeroes without transferring any data.
+ *
+ * @param bd  Block device
+ * @param ba  Address of the first block
+ * @param cnt Number of blocks
+ *
+ * @return EOK on success, ENOTSUP if the device cannot do this or
+ *         an error code
+ */
+errno_t bd_write_zeroes(bd_t *bd, aoff64_t ba, size_t cnt)
+{
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	errno_t rc = async_req_3_0(exch, BD_WRITE_ZEROES, LOWER32(ba),
+	    UPPER32(ba), cnt);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
 errno_t bd_get_block_size(bd_t *bd, size_t *rbsize)
 {
 	sysarg_t bsize;
@@ -195,6 +299,242 @@ errno_t bd_get_num_blocks(bd_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+errno_t bd_get_queue_depth(bd_t *bd, unsigned *rdepth)
+{
+	sysarg_t depth;
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	errno_t rc = async_req_0_1(exch, BD_GET_QUEUE_DEPTH, &depth);
+	async_exchange_end(exch);
+
+	if (rc != EOK)
+		return rc;
+
+	*rdepth = depth;
+	return EOK;
+}
+
+/** Map the device image into the address space.
+ *
+ * Only devices backed by memory, such as the RAM disk, support this.
+ * The mapping covers the whole device rounded up to whole pages and is
+ * removed with as_area_destroy().
+ *
+ * @param bd     Block device
+ * @param write  @c true to map the image writable
+ * @param rimage Place to store the address of the image
+ * @param rsize  Place to store the size of the mapping
+ *
+ * @return EOK on success, ENOTSUP if the device cannot be mapped or
+ *         an error code
+ */
+errno_t bd_map(bd_t *bd, bool write, void **rimage, size_t *rsize)
+{
+	size_t bsize;
+	aoff64_t nblocks;
+	void *image;
+	errno_t rc;
+
+	rc = bd_get_block_size(bd, &bsize);
+	if (rc != EOK)
+		return rc;
+
+	rc = bd_get_num_blocks(bd, &nblocks);
+	if (rc != EOK)
+		return rc;
+
+	if (bsize == 0)
+		return EIO;
+
+	if (nblocks > (SIZE_MAX - PAGE_SIZE) / bsize)
+		return ELIMIT;
+
+	size_t size = ALIGN_UP((size_t) nblocks * bsize, PAGE_SIZE);
+
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_1(exch, BD_MAP, write, &answer);
+	rc = async_share_in_start_0_0(exch, size, &image);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK) {
+		as_area_destroy(image);
+		return retval;
+	}
+
+	*rimage = image;
+	*rsize = size;
+	return EOK;
+}
+
+/** Collect answers to asynchronous requests and run their callbacks.
+ *
+ * Requests are collected in submission order. The fibril exits once there
+ * are no more requests in flight.
+ */
+static errno_t bd_reaper_fibril(void *arg)
+{
+	bd_t *bd = (bd_t *) arg;
+
+	fibril_mutex_lock(&bd->lock);
+
+	while (!list_empty(&bd->reqs)) {
+		bd_req_t *breq = list_get_instance(list_first(&bd->reqs),
+		    bd_req_t, lreqs);
+		errno_t data_rc;
+		errno_t rc;
+
+		fibril_mutex_unlock(&bd->lock);
+
+		async_wait_for(breq->data, &data_rc);
+		async_wait_for(breq->req, &rc);
+
+		fibril_mutex_lock(&bd->lock);
+		list_remove(&breq->lreqs);
+		bd->nreqs--;
+		fibril_condvar_broadcast(&bd->cv);
+		fibril_mutex_unlock(&bd->lock);
+
+		breq->cb(breq->arg, (data_rc != EOK) ? data_rc : rc);
+
+		fibril_mutex_lock(&bd->lock);
+	}
+
+	bd->reaper = false;
+	fibril_condvar_broadcast(&bd->cv);
+	fibril_mutex_unlock(&bd->lock);
+
+	return EOK;
+}
+
+/** Submit an asynchronous block transfer.
+ *
+ * Waits until the number of requests in flight drops below the queue depth
+ * of the server.
+ */
+static errno_t bd_xfer_async(bd_t *bd, bd_req_t *breq, sysarg_t method,
+    aoff64_t ba, size_t cnt, void *data, size_t size, bd_req_cb_t cb,
+    void *arg)
+{
+	if (size > DATA_XFER_LIMIT)
+		return ELIMIT;
+
+	breq->cb = cb;
+	breq->arg = arg;
+	link_initialize(&breq->lreqs);
+
+	fibril_mutex_lock(&bd->lock);
+
+	while (bd->nreqs >= bd->queue_depth)
+		fibril_condvar_wait(&bd->cv, &bd->lock);
+
+	if (!bd->reaper) {
+		fid_t fid = fibril_create(bd_reaper_fibril, bd);
+		if (fid == 0) {
+			fibril_mutex_unlock(&bd->lock);
+			return ENOMEM;
+		}
+
+		bd->reaper = true;
+		fibril_add_ready(fid);
+	}
+
+	/*
+	 * Keep the lock while sending so that the requests are queued in
+	 * the order in which they reach the server.
+	 */
+	async_exch_t *exch = async_exchange_begin(bd->sess);
+
+	breq->req = async_send_3(exch, method, LOWER32(ba), UPPER32(ba), cnt,
+	    NULL);
+	if (method == BD_WRITE_BLOCKS) {
+		breq->data = async_send_2(exch, IPC_M_DATA_WRITE,
+		    (sysarg_t) data, (sysarg_t) size, NULL);
+	} else {
+		breq->data = async_data_read(exch, data, size, NULL);
+	}
+
+	async_exchange_end(exch);
+
+	list_append(&breq->lreqs, &bd->reqs);
+	bd->nreqs++;
+	fibril_mutex_unlock(&bd->lock);
+
+	return EOK;
+}
+
+/** Start reading blocks without waiting for the data.
+ *
+ * The callback is called from a separate fibril and must not submit
+ * further requests to the same block device.
+ *
+ * @param bd   Block device
+ * @param breq Request structure, must stay valid until @a cb is called
+ * @param ba   Address of the first block
+ * @param cnt  Number of blocks
+ * @param data Buffer for the data, at most DATA_XFER_LIMIT bytes
+ * @param size Size of the buffer
+ * @param cb   Callback called with @a arg and the result of the transfer
+ * @param arg  Argument of the callback
+ *
+ * @return EOK if the request was submitted, an error code otherwise, in
+ *         which case @a cb will not be called
+ */
+errno_t bd_read_blocks_async(bd_t *bd, bd_req_t *breq, aoff64_t ba,
+    size_t cnt, void *data, size_t size, bd_req_cb_t cb, void *arg)
+{
+	return bd_xfer_async(bd, breq, BD_READ_BLOCKS, ba, cnt, data, size,
+	    cb, arg);
+}
+
+/** Start writing blocks without waiting for the transfer to finish.
+ *
+ * The callback is called from a separate fibril and must not submit
+ * further requests to the same block device.
+ *
+ * @param bd   Block device
+ * @param breq Request structure, must stay valid until @a cb is called
+ * @param ba   Address of the first block
+ * @param cnt  Number of blocks
+ * @param data Data to write, at most DATA_XFER_LIMIT bytes, must not be
+ *             modified until @a cb is called
+ * @param size Size of the data
+ * @param cb   Callback called with @a arg and the result of the transfer
+ * @param arg  Argument of the callback
+ *
+ * @return EOK if the request was submitted, an error code otherwise, in
+ *         which case @a cb will not be called
+ */
+errno_t bd_write_blocks_async(bd_t *bd, bd_req_t *breq, aoff64_t ba,
+    size_t cnt, const void *data, size_t size, bd_req_cb_t cb, void *arg)
+{
+	return bd_xfer_async(bd, breq, BD_WRITE_BLOCKS, ba, cnt, (void *) data,
+	    size, cb, arg);
+}
+
+/** Wait until all asynchronous requests have completed.
+ *
+ * When this returns, the callbacks of all requests submitted before have
+ * been called.
+ *
+ * @param bd Block device
+ */
+void bd_wait_idle(bd_t *bd)
+{
+	fibril_mutex_lock(&bd->lock);
+	while (bd->reaper)
+		fibril_condvar_wait(&bd->cv, &bd->lock);
+	fibril_mutex_unlock(&bd->lock);
+}
+
 static void bd_cb_conn(ipc_call_t *icall, void *arg)
 {
 	bd_t *bd = (bd_t *)arg;
@@ -33,7 +33,10 @@
  * @file
  * @brief Block device server stub
  */
+#include <as.h>
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <ipc/bd.h>
 #include <macros.h>
 #include <stdlib.h>
@@ -42,49 +45,189 @@
 
 #include <bd_srv.h>
 
-static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
-{
+/** Block transfer handed over to the driver */
+typedef struct {
+	bd_srv_t *srv;
+	/** Method call */
+	ipc_call_t call;
+	/** Data read request (reads) or data write request (passthrough) */
+	ipc_call_t rcall;
+	/** Write (true) or read (false) */
+	bool write;
 	aoff64_t ba;
 	size_t cnt;
+	/** Data to be written or buffer for the data read */
 	void *buf;
 	size_t size;
+} bd_xfer_t;
+
+/** Forward a block transfer to the backing device.
+ *
+ * Only the block address is translated. The data transfer call of the
+ * client is forwarded along with the request so that the data travels
+ * directly between the client and the driver of the backing device.
+ */
+static void bd_xfer_forward(bd_xfer_t *xfer)
+{
+	bd_srv_t *srv = xfer->srv;
+	async_sess_t *sess;
+	async_exch_t *exch = NULL;
+	aoff64_t ba;
 	errno_t rc;
 
-	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
-	cnt = ipc_get_arg3(call);
+	rc = srv->srvs->ops->translate(srv, xfer->ba, xfer->cnt, &sess, &ba);
+	if (rc == EOK) {
+		exch = async_exchange_begin(sess);
+		if (exch == NULL)
+			rc = ENOENT;
+	}
 
-	ipc_call_t rcall;
-	if (!async_data_read_receive(&rcall, &size)) {
-		async_answer_0(call, EINVAL);
+	if (rc != EOK) {
+		async_answer_0(&xfer->rcall, rc);
+		async_answer_0(&xfer->call, rc);
 		return;
 	}
 
-	buf = malloc(size);
-	if (buf == NULL) {
-		async_answer_0(&rcall, ENOMEM);
-		async_answer_0(call, ENOMEM);
+	aid_t req = async_send_3(exch, xfer->write ? BD_WRITE_BLOCKS :
+	    BD_READ_BLOCKS, LOWER32(ba), UPPER32(ba), xfer->cnt, NULL);
+
+	/* Data transfer calls keep their arguments when forwarded */
+	rc = async_forward_0(&xfer->rcall, exch, 0, IPC_FF_ROUTE_FROM_ME);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		/* The data transfer call has been answered by the kernel */
+		async_forget(req);
+		async_answer_0(&xfer->call, rc);
 		return;
 	}
 
-	if (srv->srvs->ops->read_blocks == NULL) {
-		async_answer_0(&rcall, ENOTSUP);
-		async_answer_0(call, ENOTSUP);
-		free(buf);
+	errno_t retval;
+	async_wait_for(req, &retval);
+	async_answer_0(&xfer->call, retval);
+}
+
+/** Perform a block transfer and answer the calls. */
+static void bd_xfer_run(bd_xfer_t *xfer)
+{
+	bd_srv_t *srv = xfer->srv;
+	errno_t rc;
+
+	if (srv->srvs->ops->translate != NULL) {
+		bd_xfer_forward(xfer);
 		return;
 	}
 
-	rc = srv->srvs->ops->read_blocks(srv, ba, cnt, buf, size);
+	if (xfer->write) {
+		rc = srv->srvs->ops->write_blocks(srv, xfer->ba, xfer->cnt,
+		    xfer->buf, xfer->size);
+		free(xfer->buf);
+		async_answer_0(&xfer->call, rc);
+		return;
+	}
+
+	rc = srv->srvs->ops->read_blocks(srv, xfer->ba, xfer->cnt, xfer->buf,
+	    xfer->size);
 	if (rc != EOK) {
-		async_answer_0(&rcall, ENOMEM);
+		async_answer_0(&xfer->rcall, ENOMEM);
+		async_answer_0(&xfer->call, ENOMEM);
+		free(xfer->buf);
+		return;
+	}
+
+	async_data_read_finalize(&xfer->rcall, xfer->buf, xfer->size);
+
+	free(xfer->buf);
+	async_answer_0(&xfer->call, EOK);
+}
+
+static errno_t bd_xfer_fibril(void *arg)
+{
+	bd_xfer_t *xfer = (bd_xfer_t *) arg;
+	bd_srv_t *srv = xfer->srv;
+
+	bd_xfer_run(xfer);
+	free(xfer);
+
+	fibril_mutex_lock(&srv->lock);
+	srv->xfers--;
+	fibril_condvar_broadcast(&srv->cv);
+	fibril_mutex_unlock(&srv->lock);
+
+	return EOK;
+}
+
+/** Start a block transfer.
+ *
+ * If the driver can work on several requests at the same time, the transfer
+ * is performed by a new fibril and the connection fibril goes on to fetch
+ * the next request, up to the queue depth of the driver. Otherwise, the
+ * transfer is performed right away.
+ */
+static void bd_xfer_start(bd_srv_t *srv, bd_xfer_t *xfer)
+{
+	bd_xfer_t *axfer;
+	fid_t fid;
+
+	if (srv->queue_depth > 1) {
+		axfer = malloc(sizeof(bd_xfer_t));
+		if (axfer != NULL) {
+			*axfer = *xfer;
+			fid = fibril_create(bd_xfer_fibril, axfer);
+			if (fid != 0) {
+				fibril_mutex_lock(&srv->lock);
+				while (srv->xfers >= srv->queue_depth)
+					fibril_condvar_wait(&srv->cv, &srv->lock);
+				srv->xfers++;
+				fibril_mutex_unlock(&srv->lock);
+
+				fibril_add_ready(fid);
+				return;
+			}
+
+			free(axfer);
+		}
+	}
+
+	bd_xfer_run(xfer);
+}
+
+static void bd_read_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	bd_xfer_t xfer;
+
+	xfer.srv = srv;
+	xfer.call = *call;
+	xfer.write = false;
+	xfer.ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
+	xfer.cnt = ipc_get_arg3(call);
+
+	if (!async_data_read_receive(&xfer.rcall, &xfer.size)) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (srv->srvs->ops->translate != NULL) {
+		xfer.buf = NULL;
+		bd_xfer_start(srv, &xfer);
+		return;
+	}
+
+	xfer.buf = malloc(xfer.size);
+	if (xfer.buf == NULL) {
+		async_answer_0(&xfer.rcall, ENOMEM);
 		async_answer_0(call, ENOMEM);
-		free(buf);
 		return;
 	}
 
-	async_data_read_finalize(&rcall, buf, size);
+	if (srv->srvs->ops->read_blocks == NULL) {
+		async_answer_0(&xfer.rcall, ENOTSUP);
+		async_answer_0(call, ENOTSUP);
+		free(xfer.buf);
+		return;
+	}
 
-	free(buf);
-	async_answer_0(call, EOK);
+	bd_xfer_start(srv, &xfer);
 }
 
 static void bd_read_toc_srv(bd_srv_t *srv, ipc_call_t *call)
@@ -148,31 +291,82 @@ static void bd_sync_cache_srv(bd_srv_t *srv, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
-static void bd_write_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
+static void bd_write_zeroes_srv(bd_srv_t *srv, ipc_call_t *call)
 {
+	async_sess_t *sess;
 	aoff64_t ba;
 	size_t cnt;
-	void *data;
-	size_t size;
 	errno_t rc;
 
 	ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
 	cnt = ipc_get_arg3(call);
 
-	rc = async_data_write_accept(&data, false, 0, 0, 0, &size);
+	if (srv->srvs->ops->translate != NULL) {
+		rc = srv->srvs->ops->translate(srv, ba, cnt, &sess, &ba);
+		if (rc != EOK) {
+			async_answer_0(call, rc);
+			return;
+		}
+
+		async_exch_t *exch = async_exchange_begin(sess);
+		if (exch == NULL) {
+			async_answer_0(call, ENOENT);
+			return;
+		}
+
+		rc = async_req_3_0(exch, BD_WRITE_ZEROES, LOWER32(ba),
+		    UPPER32(ba), cnt);
+		async_exchange_end(exch);
+
+		async_answer_0(call, rc);
+		return;
+	}
+
+	if (srv->srvs->ops->write_zeroes == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	rc = srv->srvs->ops->write_zeroes(srv, ba, cnt);
+	async_answer_0(call, rc);
+}
+
+static void bd_write_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	bd_xfer_t xfer;
+	errno_t rc;
+
+	xfer.srv = srv;
+	xfer.call = *call;
+	xfer.write = true;
+	xfer.ba = MERGE_LOUP32(ipc_get_arg1(call), ipc_get_arg2(call));
+	xfer.cnt = ipc_get_arg3(call);
+
+	if (srv->srvs->ops->translate != NULL) {
+		if (!async_data_write_receive(&xfer.rcall, &xfer.size)) {
+			async_answer_0(&xfer.rcall, EINVAL);
+			async_answer_0(call, EINVAL);
+			return;
+		}
+
+		xfer.buf = NULL;
+		bd_xfer_start(srv, &xfer);
+		return;
+	}
+
+	rc = async_data_write_accept(&xfer.buf, false, 0, 0, 0, &xfer.size);
 	if (rc != EOK) {
 		async_answer_0(call, rc);
 		return;
 	}
 
 	if (srv->srvs->ops->write_blocks == NULL) {
+		free(xfer.buf);
 		async_answer_0(call, ENOTSUP);
 		return;
 	}
 
-	rc = srv->srvs->ops->write_blocks(srv, ba, cnt, data, size);
-	free(data);
-	async_answer_0(call, rc);
+	bd_xfer_start(srv, &xfer);
 }
 
 static void bd_get_block_size_srv(bd_srv_t *srv, ipc_call_t *call)
@@ -203,6 +397,50 @@ static void bd_get_num_blocks_srv(bd_srv_t *srv, ipc_call_t *call)
 	async_answer_2(call, rc, LOWER32(num_blocks), UPPER32(num_blocks));
 }
 
+static void bd_get_queue_depth_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	async_answer_1(call, EOK, srv->queue_depth);
+}
+
+static void bd_map_srv(bd_srv_t *srv, ipc_call_t *call)
+{
+	unsigned int flags;
+	ipc_call_t scall;
+	size_t size;
+	void *area;
+	size_t asize;
+	errno_t rc;
+
+	flags = AS_AREA_READ;
+	if (ipc_get_arg1(call) != 0)
+		flags |= AS_AREA_WRITE;
+
+	if (!async_share_in_receive(&scall, &size)) {
+		async_answer_0(&scall, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (srv->srvs->ops->map == NULL) {
+		async_answer_0(&scall, ENOTSUP);
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	rc = srv->srvs->ops->map(srv, &area, &asize);
+	if (rc == EOK && size != asize)
+		rc = EINVAL;
+
+	if (rc != EOK) {
+		async_answer_0(&scall, rc);
+		async_answer_0(call, rc);
+		return;
+	}
+
+	rc = async_share_in_finalize(&scall, area, flags);
+	async_answer_0(call, rc);
+}
+
 static bd_srv_t *bd_srv_create(bd_srvs_t *srvs)
 {
 	bd_srv_t *srv;
@@ -212,6 +450,10 @@ static bd_srv_t *bd_srv_create(bd_srvs_t *srvs)
 		return NULL;
 
 	srv->srvs = srvs;
+	srv->queue_depth = 1;
+	fibril_mutex_initialize(&srv->lock);
+	fibril_condvar_initialize(&srv->cv);
+	srv->xfers = 0;
 	return srv;
 }
 
@@ -224,6 +466,7 @@ void bd_srvs_init(bd_srvs_t *srvs)
 errno_t bd_conn(ipc_call_t *icall, bd_srvs_t *srvs)
 {
 	bd_srv_t *srv;
+	unsigned depth;
 	errno_t rc;
 
 	/* Accept the connection */
@@ -243,6 +486,10 @@ errno_t bd_conn(ipc_call_t *icall, bd_srvs_t *srvs)
 	if (rc != EOK)
 		return rc;
 
+	if (srvs->ops->get_queue_depth != NULL &&
+	    srvs->ops->get_queue_depth(srv, &depth) == EOK && depth > 0)
+		srv->queue_depth = depth;
+
 	while (true) {
 		ipc_call_t call;
 		async_get_call(&call);
@@ -273,11 +520,26 @@ errno_t bd_conn(ipc_call_t *icall, bd_srvs_t *srvs)
 		case BD_GET_NUM_BLOCKS:
 			bd_get_num_blocks_srv(srv, &call);
 			break;
+		case BD_GET_QUEUE_DEPTH:
+			bd_get_queue_depth_srv(srv, &call);
+			break;
+		case BD_MAP:
+			bd_map_srv(srv, &call);
+			break;
+		case BD_WRITE_ZEROES:
+			bd_write_zeroes_srv(srv, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 		}
 	}
 
+	/* Let the transfers in progress finish */
+	fibril_mutex_lock(&srv->lock);
+	while (srv->xfers > 0)
+		fibril_condvar_wait(&srv->cv, &srv->lock);
+	fibril_mutex_unlock(&srv->lock);
+
 	rc = srvs->ops->close(srv);
 	free(srv);
 
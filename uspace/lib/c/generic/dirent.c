@@ -38,11 +38,21 @@
 #include <stddef.h>
 #include <errno.h>
 #include <assert.h>
+#include <str.h>
+
+/** Size of the buffer for directory entries read with one request */
+#define DIR_BATCH_SIZE  (16 * 1024)
 
 struct __dirstream {
 	int fd;
 	struct dirent res;
 	aoff64_t pos;
+	/** Entries read ahead or NULL if the FS returns one entry per read */
+	uint8_t *batch;
+	/** Number of bytes of the batch filled */
+	size_t batch_size;
+	/** Offset of the next entry in the batch */
+	size_t batch_offset;
 };
 
 /** Open directory.
@@ -77,9 +87,67 @@ DIR *opendir(const char *dirname)
 
 	dirp->fd = fd;
 	dirp->pos = 0;
+	/* Without the buffer, entries are read one by one */
+	dirp->batch = malloc(DIR_BATCH_SIZE);
+	dirp->batch_size = 0;
+	dirp->batch_offset = 0;
 	return dirp;
 }
 
+/** Return the next entry of the batch, reading a new batch if needed.
+ *
+ * @param dirp Open directory
+ * @param rc   Error code if no entry is returned, EOK at the end of the
+ *             directory
+ * @return Entry or @c NULL
+ */
+static struct dirent *readdir_batch(DIR *dirp, errno_t *rc)
+{
+	if (dirp->batch_offset >= dirp->batch_size) {
+		size_t nread;
+		*rc = vfs_readdir(dirp->fd, dirp->pos, dirp->batch,
+		    DIR_BATCH_SIZE, &nread);
+		if (*rc != EOK)
+			return NULL;
+
+		dirp->batch_size = nread;
+		dirp->batch_offset = 0;
+		if (nread == 0)
+			return NULL;
+	}
+
+	vfs_dirent_t *ent = (vfs_dirent_t *) (dirp->batch +
+	    dirp->batch_offset);
+	if (dirp->batch_size - dirp->batch_offset < sizeof(vfs_dirent_t) ||
+	    ent->size <= sizeof(vfs_dirent_t) ||
+	    ent->size > dirp->batch_size - dirp->batch_offset) {
+		*rc = EIO;
+		return NULL;
+	}
+
+	str_ncpy(dirp->res.d_name, sizeof(dirp->res.d_name),
+	    (const char *) (ent + 1), ent->size - sizeof(vfs_dirent_t));
+	dirp->res.d_ino = ent->index;
+
+	switch (ent->type) {
+	case VFS_DIRENT_FILE:
+		dirp->res.d_type = DT_REG;
+		break;
+	case VFS_DIRENT_DIRECTORY:
+		dirp->res.d_type = DT_DIR;
+		break;
+	default:
+		dirp->res.d_type = DT_UNKNOWN;
+		break;
+	}
+
+	dirp->pos = ent->next_pos;
+	dirp->batch_offset += ent->size;
+
+	*rc = EOK;
+	return &dirp->res;
+}
+
 /** Read directory entry.
  *
  * @param dirp Open directory
@@ -91,6 +159,22 @@ struct dirent *readdir(DIR *dirp)
 	errno_t rc;
 	ssize_t len = 0;
 
+	if (dirp->batch != NULL) {
+		struct dirent *res = readdir_batch(dirp, &rc);
+		if (res != NULL)
+			return res;
+
+		if (rc != ENOTSUP) {
+			if (rc != EOK)
+				errno = rc;
+			return NULL;
+		}
+
+		/* The file system returns one entry per read */
+		free(dirp->batch);
+		dirp->batch = NULL;
+	}
+
 	rc = vfs_read_short(dirp->fd, dirp->pos, &dirp->res.d_name[0],
 	    NAME_MAX + 1, &len);
 	if (rc != EOK) {
@@ -99,6 +183,8 @@ struct dirent *readdir(DIR *dirp)
 	}
 
 	dirp->pos += len;
+	dirp->res.d_ino = 0;
+	dirp->res.d_type = DT_UNKNOWN;
 
 	return &dirp->res;
 }
@@ -110,6 +196,8 @@ struct dirent *readdir(DIR *dirp)
 void rewinddir(DIR *dirp)
 {
 	dirp->pos = 0;
+	dirp->batch_size = 0;
+	dirp->batch_offset = 0;
 }
 
 /** Close directory.
@@ -120,6 +208,7 @@ void rewinddir(DIR *dirp)
 int closedir(DIR *dirp)
 {
 	errno_t rc = vfs_put(dirp->fd);
+	free(dirp->batch);
 	free(dirp);
 
 	if (rc == EOK) {
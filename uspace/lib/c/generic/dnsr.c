@@ -149,12 +149,39 @@ void dnsr_hostinfo_destroy(dnsr_hostinfo_t *info)
 	free(info);
 }
 
+/** Get address of the primary name server.
+ *
+ * @param srvaddr Place to store the address
+ * @return EOK on success or an error code
+ */
 errno_t dnsr_get_srvaddr(inet_addr_t *srvaddr)
+{
+	return dnsr_get_srvaddr_idx(0, srvaddr);
+}
+
+/** Set address of the primary name server.
+ *
+ * @param srvaddr Server address
+ * @return EOK on success or an error code
+ */
+errno_t dnsr_set_srvaddr(inet_addr_t *srvaddr)
+{
+	return dnsr_set_srvaddr_idx(0, srvaddr);
+}
+
+/** Get address of a name server.
+ *
+ * @param idx     Server index (less than DNSR_SERVERS_MAX)
+ * @param srvaddr Place to store the address, unspecified if the slot
+ *                is not used
+ * @return EOK on success or an error code
+ */
+errno_t dnsr_get_srvaddr_idx(size_t idx, inet_addr_t *srvaddr)
 {
 	async_exch_t *exch = dnsr_exchange_begin();
 
 	ipc_call_t answer;
-	aid_t req = async_send_0(exch, DNSR_GET_SRVADDR, &answer);
+	aid_t req = async_send_1(exch, DNSR_GET_SRVADDR, idx, &answer);
 	errno_t rc = async_data_read_start(exch, srvaddr, sizeof(inet_addr_t));
 
 	loc_exchange_end(exch);
@@ -170,12 +197,20 @@ errno_t dnsr_get_srvaddr(inet_addr_t *srvaddr)
 	return retval;
 }
 
-errno_t dnsr_set_srvaddr(inet_addr_t *srvaddr)
+/** Set address of a name server.
+ *
+ * Queries are sent to all configured servers at once.
+ *
+ * @param idx     Server index (less than DNSR_SERVERS_MAX)
+ * @param srvaddr Server address, unspecified address to unset
+ * @return EOK on success or an error code
+ */
+errno_t dnsr_set_srvaddr_idx(size_t idx, inet_addr_t *srvaddr)
 {
 	async_exch_t *exch = dnsr_exchange_begin();
 
 	ipc_call_t answer;
-	aid_t req = async_send_0(exch, DNSR_SET_SRVADDR, &answer);
+	aid_t req = async_send_1(exch, DNSR_SET_SRVADDR, idx, &answer);
 	errno_t rc = async_data_write_start(exch, srvaddr, sizeof(inet_addr_t));
 
 	loc_exchange_end(exch);
@@ -191,5 +226,87 @@ errno_t dnsr_set_srvaddr(inet_addr_t *srvaddr)
 	return retval;
 }
 
+static errno_t dnsr_get_cache_once(dnsr_cache_entry_t *buf, size_t buf_size,
+    size_t *act_size)
+{
+	async_exch_t *exch = dnsr_exchange_begin();
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, DNSR_GET_CACHE, &answer);
+	errno_t rc = async_data_read_start(exch, buf, buf_size);
+
+	dnsr_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+
+	if (retval != EOK)
+		return retval;
+
+	*act_size = ipc_get_arg1(&answer);
+	return EOK;
+}
+
+/** Get contents of the resolver cache.
+ *
+ * @param rentries Place to store pointer to an allocated array of entries
+ * @param rcount   Place to store number of entries
+ * @return EOK on success or an error code
+ */
+errno_t dnsr_get_cache(dnsr_cache_entry_t **rentries, size_t *rcount)
+{
+	size_t act_size = 0;
+	errno_t rc = dnsr_get_cache_once(NULL, 0, &act_size);
+	if (rc != EOK)
+		return rc;
+
+	size_t alloc_size = act_size;
+	dnsr_cache_entry_t *entries = malloc(alloc_size);
+	if (alloc_size > 0 && entries == NULL)
+		return ENOMEM;
+
+	while (true) {
+		rc = dnsr_get_cache_once(entries, alloc_size, &act_size);
+		if (rc != EOK) {
+			free(entries);
+			return rc;
+		}
+
+		if (act_size <= alloc_size)
+			break;
+
+		alloc_size = act_size;
+		dnsr_cache_entry_t *nentries = realloc(entries, alloc_size);
+		if (nentries == NULL) {
+			free(entries);
+			return ENOMEM;
+		}
+
+		entries = nentries;
+	}
+
+	*rentries = entries;
+	*rcount = act_size / sizeof(dnsr_cache_entry_t);
+	return EOK;
+}
+
+/** Remove all entries from the resolver cache.
+ *
+ * @return EOK on success or an error code
+ */
+errno_t dnsr_flush_cache(void)
+{
+	async_exch_t *exch = dnsr_exchange_begin();
+	errno_t rc = async_req_0_0(exch, DNSR_FLUSH_CACHE);
+	dnsr_exchange_end(exch);
+
+	return rc;
+}
+
 /** @}
  */
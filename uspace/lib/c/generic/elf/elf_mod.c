@@ -58,6 +58,10 @@
 #include <str_error.h>
 #include <stdlib.h>
 #include <macros.h>
+#include <async.h>
+#include <ns.h>
+#include <ipc/services.h>
+#include <ipc/ldcache.h>
 
 #include <elf/elf_load.h>
 
@@ -77,6 +81,11 @@ static unsigned int elf_load_module(elf_ld_t *elf);
 static int segment_header(elf_ld_t *elf, elf_segment_header_t *entry);
 static int load_segment(elf_ld_t *elf, elf_segment_header_t *entry);
 
+/** Session to the segment cache, NULL if not available */
+static async_sess_t *ldcache_sess;
+/** True if connecting to the segment cache has already been attempted */
+static bool ldcache_probed;
+
 /** Load ELF binary from a file.
  *
  * Load an ELF binary from the specified file. If the file is
@@ -394,6 +403,67 @@ static int segment_header(elf_ld_t *elf, elf_segment_header_t *entry)
 	return EE_OK;
 }
 
+/** Map a read-only segment image from the segment cache.
+ *
+ * The segment cache keeps a single copy of each read-only segment image
+ * it has been asked for and shares it into the requesting address space.
+ * Since read-only segments are not modified by relocation, the same image
+ * can back the segment regardless of the load bias.
+ *
+ * @param elf   Loader state.
+ * @param entry Program header entry describing segment to be loaded.
+ * @param addr  Page-aligned address where the image should be mapped.
+ * @param size  Size of the image in bytes.
+ * @param flags Final flags of the memory area.
+ *
+ * @return EOK on success or an error code.
+ */
+static errno_t load_segment_cached(elf_ld_t *elf, elf_segment_header_t *entry,
+    void *addr, size_t size, int flags)
+{
+	if (!ldcache_probed) {
+		ldcache_probed = true;
+		ldcache_sess = service_connect(SERVICE_LDCACHE, INTERFACE_LDCACHE,
+		    0);
+	}
+
+	if (ldcache_sess == NULL)
+		return ENOENT;
+
+	ldcache_seg_t seg = {
+		.offset = entry->p_offset,
+		.filesz = entry->p_filesz,
+		.memsz = entry->p_memsz,
+		.pgoff = entry->p_vaddr % PAGE_SIZE,
+		.flags = flags
+	};
+
+	async_exch_t *exch = async_exchange_begin(ldcache_sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, LDCACHE_MAP_SEGMENT, &answer);
+
+	errno_t rc = async_data_write_start(exch, &seg, sizeof(seg));
+	if (rc == EOK) {
+		async_exch_t *vfs_exch = vfs_exchange_begin();
+		rc = vfs_pass_handle(vfs_exch, elf->fd, exch);
+		vfs_exchange_end(vfs_exch);
+	}
+
+	if (rc == EOK)
+		rc = async_share_in_start_fixed(exch, size, 0, addr);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	async_wait_for(req, &rc);
+	return rc;
+}
+
 /** Load segment described by program header entry.
  *
  * @param elf	Loader state.
@@ -455,6 +525,22 @@ int load_segment(elf_ld_t *elf, elf_segment_header_t *entry)
 	    (void *) (entry->p_vaddr + bias +
 	    ALIGN_UP(entry->p_memsz, PAGE_SIZE)));
 
+	/*
+	 * Read-only segments which the caller does not intend to modify
+	 * can be shared from the segment cache.
+	 */
+	if ((flags & AS_AREA_WRITE) == 0 && (elf->flags & ELDF_RW) == 0 &&
+	    load_segment_cached(elf, entry, (uint8_t *) base + bias,
+	    ALIGN_UP(mem_sz, PAGE_SIZE), flags) == EOK) {
+		if (flags & AS_AREA_EXEC) {
+			/* Enforce SMC coherence for the segment */
+			if (smc_coherence(seg_ptr, entry->p_filesz))
+				return EE_MEMORY;
+		}
+
+		return EE_OK;
+	}
+
 	/*
 	 * For the course of loading, the area needs to be readable
 	 * and writeable.
@@ -33,13 +33,11 @@
  */
 
 #include <errno.h>
-#include <fibril.h>
-
-static fibril_local errno_t fibril_errno;
+#include <tls.h>
 
 errno_t *__errno(void)
 {
-	return &fibril_errno;
+	return &__tls_slot(TLS_SLOT_ERRNO)->err;
 }
 
 /** @}
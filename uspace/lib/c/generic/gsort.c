@@ -32,14 +32,16 @@
 
 /**
  * @file
- * @brief Gnome Sort.
+ * @brief Stable sort.
  *
- * This file contains an implementation of gnome sort
+ * This file contains an implementation of a stable merge sort
+ * with an insertion sort cutoff for short runs.
  *
  */
 
 #include <gsort.h>
 #include <inttypes.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 
@@ -51,14 +53,17 @@
  */
 #define IBUF_SIZE  32
 
+/** Length of runs sorted by insertion sort before merging. */
+#define RUN_LENGTH  16
+
 /** Array accessor.
  *
  */
 #define INDEX(buf, i, elem_size)  ((buf) + (i) * (elem_size))
 
-/** Gnome sort
+/** Insertion sort
  *
- * Apply generic gnome sort algorithm on supplied data,
+ * Apply stable insertion sort on supplied data,
  * using pre-allocated buffer.
  *
  * @param data      Pointer to data to be sorted.
@@ -70,30 +75,140 @@
  *                  elem_size bytes long.
  *
  */
-static void _gsort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp,
+static void _isort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp,
     void *arg, void *slot)
 {
-	size_t i = 0;
-
-	while (i < cnt) {
-		if ((i != 0) &&
-		    (cmp(INDEX(data, i, elem_size),
-		    INDEX(data, i - 1, elem_size), arg) < 0)) {
-			memcpy(slot, INDEX(data, i, elem_size), elem_size);
-			memcpy(INDEX(data, i, elem_size), INDEX(data, i - 1, elem_size),
+	size_t i;
+	size_t j;
+
+	for (i = 1; i < cnt; i++) {
+		if (cmp(INDEX(data, i, elem_size),
+		    INDEX(data, i - 1, elem_size), arg) >= 0)
+			continue;
+
+		memcpy(slot, INDEX(data, i, elem_size), elem_size);
+
+		j = i - 1;
+		while ((j > 0) &&
+		    (cmp(slot, INDEX(data, j - 1, elem_size), arg) < 0))
+			j--;
+
+		memmove(INDEX(data, j + 1, elem_size), INDEX(data, j, elem_size),
+		    (i - j) * elem_size);
+		memcpy(INDEX(data, j, elem_size), slot, elem_size);
+	}
+}
+
+/** Merge two adjacent sorted runs
+ *
+ * Elements of the first run go first among equal elements,
+ * which keeps the sort stable.
+ *
+ * @param src       Source array.
+ * @param dst       Destination array.
+ * @param lo        Start of the first run.
+ * @param mid       Start of the second run.
+ * @param hi        End of the second run.
+ * @param elem_size Size of one element.
+ * @param cmp       Comparator function.
+ * @param arg       3rd argument passed to cmp.
+ *
+ */
+static void _merge(void *src, void *dst, size_t lo, size_t mid, size_t hi,
+    size_t elem_size, sort_cmp_t cmp, void *arg)
+{
+	size_t i = lo;
+	size_t j = mid;
+	size_t k = lo;
+
+	/* Runs already in order */
+	if ((mid == hi) || (cmp(INDEX(src, mid, elem_size),
+	    INDEX(src, mid - 1, elem_size), arg) >= 0)) {
+		memcpy(INDEX(dst, lo, elem_size), INDEX(src, lo, elem_size),
+		    (hi - lo) * elem_size);
+		return;
+	}
+
+	while ((i < mid) && (j < hi)) {
+		if (cmp(INDEX(src, j, elem_size), INDEX(src, i, elem_size),
+		    arg) < 0) {
+			memcpy(INDEX(dst, k, elem_size), INDEX(src, j, elem_size),
+			    elem_size);
+			j++;
+		} else {
+			memcpy(INDEX(dst, k, elem_size), INDEX(src, i, elem_size),
 			    elem_size);
-			memcpy(INDEX(data, i - 1, elem_size), slot, elem_size);
-			i--;
-		} else
 			i++;
+		}
+
+		k++;
+	}
+
+	if (i < mid)
+		memcpy(INDEX(dst, k, elem_size), INDEX(src, i, elem_size),
+		    (mid - i) * elem_size);
+	else
+		memcpy(INDEX(dst, k, elem_size), INDEX(src, j, elem_size),
+		    (hi - j) * elem_size);
+}
+
+/** Merge sort
+ *
+ * Sort runs of RUN_LENGTH elements using insertion sort
+ * and then merge them bottom-up, bouncing between the data
+ * and the scratch buffer.
+ *
+ * @param data      Pointer to data to be sorted.
+ * @param cnt       Number of elements to be sorted.
+ * @param elem_size Size of one element.
+ * @param cmp       Comparator function.
+ * @param arg       3rd argument passed to cmp.
+ * @param slot      Pointer to scratch memory buffer
+ *                  elem_size bytes long.
+ * @param tmp       Pointer to scratch memory buffer
+ *                  cnt * elem_size bytes long.
+ *
+ */
+static void _msort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp,
+    void *arg, void *slot, void *tmp)
+{
+	void *src = data;
+	void *dst = tmp;
+	void *t;
+	size_t width;
+	size_t lo;
+	size_t mid;
+	size_t hi;
+
+	for (lo = 0; lo < cnt; lo += RUN_LENGTH) {
+		hi = min(lo + RUN_LENGTH, cnt);
+		_isort(INDEX(data, lo, elem_size), hi - lo, elem_size, cmp,
+		    arg, slot);
 	}
+
+	for (width = RUN_LENGTH; width < cnt; width *= 2) {
+		for (lo = 0; lo < cnt; lo += 2 * width) {
+			mid = min(lo + width, cnt);
+			hi = min(lo + 2 * width, cnt);
+			_merge(src, dst, lo, mid, hi, elem_size, cmp, arg);
+		}
+
+		t = src;
+		src = dst;
+		dst = t;
+	}
+
+	if (src != data)
+		memcpy(data, src, cnt * elem_size);
 }
 
-/** Gnome sort wrapper
+/** Stable sort
  *
- * This is only a wrapper that takes care of memory
- * allocations for storing the slot element for generic
- * gnome sort algorithm.
+ * This is a wrapper that takes care of memory
+ * allocations for the scratch buffers and picks
+ * insertion sort for short arrays and merge sort
+ * for long ones. If the merge buffer cannot be
+ * allocated, insertion sort is used instead.
  *
  * @param data      Pointer to data to be sorted.
  * @param cnt       Number of elements to be sorted.
@@ -108,6 +223,7 @@ bool gsort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp, void *arg)
 {
 	uint8_t ibuf_slot[IBUF_SIZE];
 	void *slot;
+	void *tmp = NULL;
 
 	if (elem_size > IBUF_SIZE) {
 		slot = (void *) malloc(elem_size);
@@ -116,7 +232,14 @@ bool gsort(void *data, size_t cnt, size_t elem_size, sort_cmp_t cmp, void *arg)
 	} else
 		slot = (void *) ibuf_slot;
 
-	_gsort(data, cnt, elem_size, cmp, arg, slot);
+	if (cnt > RUN_LENGTH)
+		tmp = malloc(cnt * elem_size);
+
+	if (tmp != NULL) {
+		_msort(data, cnt, elem_size, cmp, arg, slot, tmp);
+		free(tmp);
+	} else
+		_isort(data, cnt, elem_size, cmp, arg, slot);
 
 	if (elem_size > IBUF_SIZE)
 		free(slot);
@@ -33,6 +33,7 @@
 #include <ipc/inet.h>
 #include <ipc/services.h>
 #include <loc.h>
+#include <mem.h>
 #include <stdlib.h>
 
 static void inet_cb_conn(ipc_call_t *icall, void *arg);
@@ -233,6 +234,45 @@ static void inet_ev_recv(ipc_call_t *icall)
 	async_answer_0(icall, rc);
 }
 
+static void inet_ev_recv_list(ipc_call_t *icall)
+{
+	inet_recv_hdr_t hdr;
+	inet_dgram_t dgram;
+	uint8_t *data;
+	size_t size;
+	size_t off;
+
+	errno_t rc = async_data_write_accept((void **) &data, false, 0,
+	    DATA_XFER_LIMIT, 0, &size);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	off = 0;
+	while (size - off >= sizeof(hdr)) {
+		memcpy(&hdr, data + off, sizeof(hdr));
+		off += sizeof(hdr);
+
+		if (hdr.size > size - off) {
+			rc = EINVAL;
+			break;
+		}
+
+		dgram.src = hdr.src;
+		dgram.dest = hdr.dest;
+		dgram.tos = hdr.tos;
+		dgram.iplink = hdr.iplink;
+		dgram.data = data + off;
+		dgram.size = hdr.size;
+		(void) inet_ev_ops->recv(&dgram);
+		off += hdr.size;
+	}
+
+	free(data);
+	async_answer_0(icall, rc);
+}
+
 static void inet_cb_conn(ipc_call_t *icall, void *arg)
 {
 	while (true) {
@@ -248,6 +288,9 @@ static void inet_cb_conn(ipc_call_t *icall, void *arg)
 		case INET_EV_RECV:
 			inet_ev_recv(&call);
 			break;
+		case INET_EV_RECV_LIST:
+			inet_ev_recv_list(&call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 		}
@@ -71,6 +71,11 @@ static const inet_addr_t inet_addr_any_addr6 = {
 	.addr6 = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }
 };
 
+static const inet_addr_t inet_addr_loopback_addr6 = {
+	.version = ip_v6,
+	.addr6 = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }
+};
+
 void addr48(const addr48_t src, addr48_t dst)
 {
 	memcpy(dst, src, 6);
@@ -231,6 +236,17 @@ int inet_addr_is_any(const inet_addr_t *addr)
 	    (inet_addr_compare(addr, &inet_addr_any_addr6)));
 }
 
+/** Determine whether address is a loopback address.
+ *
+ * @param addr Address
+ * @return Non-zero if @a addr is in 127.0.0.0/8 or is ::1
+ */
+int inet_addr_is_loopback(const inet_addr_t *addr)
+{
+	return ((addr->version == ip_v4 && (addr->addr >> 24) == 127) ||
+	    (inet_addr_compare(addr, &inet_addr_loopback_addr6)));
+}
+
 int inet_naddr_compare(const inet_naddr_t *naddr, const inet_addr_t *addr)
 {
 	if (naddr->version != addr->version)
@@ -38,7 +38,9 @@
 #include <inet/tcp.h>
 #include <ipc/services.h>
 #include <ipc/tcp.h>
+#include <macros.h>
 #include <stdlib.h>
+#include <time.h>
 
 static void tcp_cb_conn(ipc_call_t *, void *);
 static errno_t tcp_conn_fibril(void *);
@@ -262,6 +264,7 @@ void tcp_conn_destroy(tcp_conn_t *conn)
 	errno_t rc = async_req_1_0(exch, TCP_CONN_DESTROY, conn->id);
 	async_exchange_end(exch);
 
+	async_ring_destroy(conn->snd_ring);
 	free(conn);
 	(void) rc;
 }
@@ -452,6 +455,21 @@ errno_t tcp_conn_send(tcp_conn_t *conn, const void *data, size_t bytes)
 	async_exch_t *exch;
 	errno_t rc;
 
+	if (conn->snd_ring != NULL) {
+		while (bytes > 0) {
+			size_t xfer = min(bytes, TCP_SEND_RING_MSG_MAX);
+
+			rc = async_ring_write(conn->snd_ring, data, xfer);
+			if (rc != EOK)
+				return rc;
+
+			data += xfer;
+			bytes -= xfer;
+		}
+
+		return EOK;
+	}
+
 	exch = async_exchange_begin(conn->tcp->sess);
 	aid_t req = async_send_1(exch, TCP_CONN_SEND, conn->id, NULL);
 
@@ -522,6 +540,71 @@ errno_t tcp_conn_reset(tcp_conn_t *conn)
 	return rc;
 }
 
+/** Set connection buffer size ceilings.
+ *
+ * The TCP service grows connection buffers with the measured
+ * bandwidth-delay product, up to these ceilings.
+ *
+ * @param conn Connection
+ * @param rcv_max Receive buffer ceiling in bytes or 0 to keep current
+ * @param snd_max Send buffer ceiling in bytes or 0 to keep current
+ * @return EOK on success or an error code
+ */
+errno_t tcp_conn_set_buf_max(tcp_conn_t *conn, size_t rcv_max, size_t snd_max)
+{
+	async_exch_t *exch;
+
+	exch = async_exchange_begin(conn->tcp->sess);
+	errno_t rc = async_req_3_0(exch, TCP_CONN_SET_BUF_MAX, conn->id,
+	    rcv_max, snd_max);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/** Enable or disable Nagle algorithm on connection.
+ *
+ * With @a nodelay set, small segments are transmitted right away even
+ * when previously sent data has not been acknowledged yet.
+ *
+ * @param conn Connection
+ * @param nodelay @c true to disable Nagle algorithm
+ * @return EOK on success or an error code
+ */
+errno_t tcp_conn_set_nodelay(tcp_conn_t *conn, bool nodelay)
+{
+	async_exch_t *exch;
+
+	exch = async_exchange_begin(conn->tcp->sess);
+	errno_t rc = async_req_2_0(exch, TCP_CONN_SET_NODELAY, conn->id,
+	    nodelay ? 1 : 0);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
+/** Send data over TCP connection through a shared-memory ring.
+ *
+ * After this call tcp_conn_send() copies data into a ring shared with
+ * the TCP service, which takes them straight into the connection send
+ * buffer. IPC is then only used when one side waits for the other.
+ * Errors of the connection are reported to tcp_conn_send() only once
+ * the TCP service stops draining the ring.
+ *
+ * @param conn Connection
+ * @param size Ring size in bytes
+ * @return EOK on success, EEXIST if the connection already has a ring,
+ *         or an error code
+ */
+errno_t tcp_conn_send_ring(tcp_conn_t *conn, size_t size)
+{
+	if (conn->snd_ring != NULL)
+		return EEXIST;
+
+	return async_ring_create_arg(conn->tcp->sess, TCP_CONN_SEND_RING,
+	    conn->id, size, &conn->snd_ring);
+}
+
 /** Read received data from connection without blocking.
  *
  * If any received data is pending on the connection, up to @a bsize bytes
@@ -573,35 +656,51 @@ errno_t tcp_conn_recv(tcp_conn_t *conn, void *buf, size_t bsize, size_t *nrecv)
 	return EOK;
 }
 
-/** Read received data from connection with blocking.
+/** Read received data from connection, waiting at most until a deadline.
  *
- * Wait for @a bsize bytes of data to be received and copy them to
- * @a buf. Less data may be returned if FIN is received on the connection.
- * The actual If any received data is written to @a *nrecv and EOK
- * is returned on success.
- *
- * @param conn Connection
- * @param buf  Buffer
- * @param bsize Buffer size
- * @param nrecv Place to store actual number of received bytes
+ * @param conn     Connection
+ * @param buf      Buffer
+ * @param bsize    Buffer size
+ * @param deadline Deadline or @c NULL to wait indefinitely
+ * @param nrecv    Place to store actual number of received bytes
  *
- * @return EOK on success or an error code
+ * @return EOK on success, ETIMEOUT if no data arrived before the deadline,
+ *         ECONNRESET if the connection was reset or other error code
  */
-errno_t tcp_conn_recv_wait(tcp_conn_t *conn, void *buf, size_t bsize,
-    size_t *nrecv)
+static errno_t tcp_conn_recv_wait_until(tcp_conn_t *conn, void *buf,
+    size_t bsize, struct timespec *deadline, size_t *nrecv)
 {
 	async_exch_t *exch;
 	ipc_call_t answer;
+	struct timespec now;
+	errno_t rc;
 
 again:
 	fibril_mutex_lock(&conn->lock);
 	while (!conn->data_avail) {
-		fibril_condvar_wait(&conn->cv, &conn->lock);
+		if (conn->conn_reset) {
+			fibril_mutex_unlock(&conn->lock);
+			return ECONNRESET;
+		}
+
+		if (deadline == NULL) {
+			fibril_condvar_wait(&conn->cv, &conn->lock);
+			continue;
+		}
+
+		getuptime(&now);
+		if (!ts_gt(deadline, &now)) {
+			fibril_mutex_unlock(&conn->lock);
+			return ETIMEOUT;
+		}
+
+		(void) fibril_condvar_wait_timeout(&conn->cv, &conn->lock,
+		    max(NSEC2USEC(ts_sub_diff(deadline, &now)), 1));
 	}
 
 	exch = async_exchange_begin(conn->tcp->sess);
 	aid_t req = async_send_1(exch, TCP_CONN_RECV_WAIT, conn->id, &answer);
-	errno_t rc = async_data_read_start(exch, buf, bsize);
+	rc = async_data_read_start(exch, buf, bsize);
 	async_exchange_end(exch);
 
 	if (rc != EOK) {
@@ -630,6 +729,51 @@ again:
 	return EOK;
 }
 
+/** Read received data from connection with blocking.
+ *
+ * Wait for @a bsize bytes of data to be received and copy them to
+ * @a buf. Less data may be returned if FIN is received on the connection.
+ * The actual If any received data is written to @a *nrecv and EOK
+ * is returned on success.
+ *
+ * @param conn Connection
+ * @param buf  Buffer
+ * @param bsize Buffer size
+ * @param nrecv Place to store actual number of received bytes
+ *
+ * @return EOK on success, ECONNRESET if the connection was reset
+ *         or other error code
+ */
+errno_t tcp_conn_recv_wait(tcp_conn_t *conn, void *buf, size_t bsize,
+    size_t *nrecv)
+{
+	return tcp_conn_recv_wait_until(conn, buf, bsize, NULL, nrecv);
+}
+
+/** Read received data from connection with blocking and timeout.
+ *
+ * Same as tcp_conn_recv_wait(), but gives up if no data arrive within
+ * @a timeout.
+ *
+ * @param conn    Connection
+ * @param buf     Buffer
+ * @param bsize   Buffer size
+ * @param timeout Timeout in microseconds
+ * @param nrecv   Place to store actual number of received bytes
+ *
+ * @return EOK on success, ETIMEOUT if no data arrived in time,
+ *         ECONNRESET if the connection was reset or other error code
+ */
+errno_t tcp_conn_recv_wait_timeout(tcp_conn_t *conn, void *buf, size_t bsize,
+    usec_t timeout, size_t *nrecv)
+{
+	struct timespec deadline;
+
+	getuptime(&deadline);
+	ts_add_diff(&deadline, USEC2NSEC(timeout));
+	return tcp_conn_recv_wait_until(conn, buf, bsize, &deadline, nrecv);
+}
+
 /** Connection established event.
  *
  * @param tcp   TCP client
@@ -872,5 +1016,87 @@ static errno_t tcp_conn_fibril(void *arg)
 	return EOK;
 }
 
+/** Get connection information list once.
+ *
+ * @param tcp TCP client
+ * @param buf Buffer for connection information or @c NULL
+ * @param bsize Buffer size in bytes
+ * @param act_size Place to store size of the entire list in bytes
+ * @return EOK on success or an error code
+ */
+static errno_t tcp_conn_info_list_once(tcp_t *tcp, tcp_conn_info_t *buf,
+    size_t bsize, size_t *act_size)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+
+	exch = async_exchange_begin(tcp->sess);
+	aid_t req = async_send_0(exch, TCP_CONN_INFO_LIST, &answer);
+	errno_t rc = async_data_read_start(exch, buf, bsize);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK)
+		return retval;
+
+	*act_size = ipc_get_arg1(&answer);
+	return EOK;
+}
+
+/** Get information on all connections of the TCP service.
+ *
+ * Lists every connection known to the TCP service, not only those
+ * belonging to this client, together with its packet statistics.
+ *
+ * @param tcp TCP client
+ * @param rinfo Place to store pointer to newly allocated array
+ * @param rcount Place to store number of array entries
+ * @return EOK on success or an error code
+ */
+errno_t tcp_conn_info_list(tcp_t *tcp, tcp_conn_info_t **rinfo,
+    size_t *rcount)
+{
+	tcp_conn_info_t *info;
+	tcp_conn_info_t *ninfo;
+	size_t alloc_size;
+	size_t act_size;
+	errno_t rc;
+
+	rc = tcp_conn_info_list_once(tcp, NULL, 0, &act_size);
+	if (rc != EOK)
+		return rc;
+
+	info = NULL;
+	while (true) {
+		alloc_size = act_size;
+		ninfo = realloc(info, max(alloc_size, 1));
+		if (ninfo == NULL) {
+			free(info);
+			return ENOMEM;
+		}
+
+		info = ninfo;
+
+		rc = tcp_conn_info_list_once(tcp, info, alloc_size, &act_size);
+		if (rc != EOK) {
+			free(info);
+			return rc;
+		}
+
+		if (act_size <= alloc_size)
+			break;
+	}
+
+	*rinfo = info;
+	*rcount = act_size / sizeof(tcp_conn_info_t);
+	return EOK;
+}
+
 /** @}
  */
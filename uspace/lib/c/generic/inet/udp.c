@@ -32,12 +32,15 @@
 /** @file UDP API
  */
 
+#include <assert.h>
 #include <errno.h>
 #include <inet/endpoint.h>
 #include <inet/udp.h>
 #include <ipc/services.h>
 #include <ipc/udp.h>
 #include <loc.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 static void udp_cb_conn(ipc_call_t *, void *);
@@ -90,6 +93,12 @@ errno_t udp_create(udp_t **rudp)
 	fibril_mutex_initialize(&udp->lock);
 	fibril_condvar_initialize(&udp->cv);
 
+	udp->rbuf = malloc(DATA_XFER_LIMIT);
+	if (udp->rbuf == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
 	rc = loc_service_get_id(SERVICE_NAME_UDP, &udp_svcid,
 	    IPC_FLAG_BLOCKING);
 	if (rc != EOK) {
@@ -113,6 +122,8 @@ errno_t udp_create(udp_t **rudp)
 	*rudp = udp;
 	return EOK;
 error:
+	if (udp != NULL)
+		free(udp->rbuf);
 	free(udp);
 	return rc;
 }
@@ -133,6 +144,7 @@ void udp_destroy(udp_t *udp)
 		fibril_condvar_wait(&udp->cv, &udp->lock);
 	fibril_mutex_unlock(&udp->lock);
 
+	free(udp->rbuf);
 	free(udp);
 }
 
@@ -284,6 +296,118 @@ errno_t udp_assoc_send_msg(udp_assoc_t *assoc, inet_ep_t *dest, void *data,
 	return rc;
 }
 
+/** Send messages packed in one buffer via UDP association.
+ *
+ * @param assoc Association
+ * @param msgs  Messages
+ * @param cnt   Number of messages
+ * @param size  Size of the packed messages in bytes
+ * @param rsent Place to store number of messages sent
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t udp_assoc_send_list(udp_assoc_t *assoc, udp_smsg_t *msgs,
+    size_t cnt, size_t size, size_t *rsent)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+	udp_send_hdr_t hdr;
+	uint8_t *buf;
+	size_t off;
+	size_t i;
+
+	*rsent = 0;
+
+	buf = malloc(size);
+	if (buf == NULL)
+		return ENOMEM;
+
+	off = 0;
+	for (i = 0; i < cnt; i++) {
+		if (msgs[i].dest != NULL)
+			hdr.dest = *msgs[i].dest;
+		else
+			inet_ep_init(&hdr.dest);
+		hdr.size = msgs[i].size;
+
+		memcpy(buf + off, &hdr, sizeof(hdr));
+		memcpy(buf + off + sizeof(hdr), msgs[i].data, msgs[i].size);
+		off += sizeof(hdr) + msgs[i].size;
+	}
+
+	assert(off == size);
+
+	exch = async_exchange_begin(assoc->udp->sess);
+	aid_t req = async_send_1(exch, UDP_ASSOC_SEND_BATCH, assoc->id,
+	    &answer);
+	errno_t rc = async_data_write_start(exch, buf, size);
+	async_exchange_end(exch);
+
+	free(buf);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	async_wait_for(req, &rc);
+	*rsent = ipc_get_arg1(&answer);
+	return rc;
+}
+
+/** Send a batch of messages via UDP association.
+ *
+ * The messages are passed to the UDP service in as few requests as
+ * possible. Sending stops at the first message that fails.
+ *
+ * @param assoc Association
+ * @param msgs  Messages
+ * @param cnt   Number of messages
+ * @param rsent Place to store number of messages sent or @c NULL
+ *
+ * @return EOK on success or an error code
+ */
+errno_t udp_assoc_send_batch(udp_assoc_t *assoc, udp_smsg_t *msgs,
+    size_t cnt, size_t *rsent)
+{
+	size_t sent;
+	size_t nsent;
+	size_t size;
+	size_t n;
+	errno_t rc = EOK;
+
+	sent = 0;
+	while (sent < cnt) {
+		n = 0;
+		size = 0;
+		while (sent + n < cnt && msgs[sent + n].size <=
+		    DATA_XFER_LIMIT - sizeof(udp_send_hdr_t) - size) {
+			size += sizeof(udp_send_hdr_t) + msgs[sent + n].size;
+			++n;
+		}
+
+		if (n == 0) {
+			/* Too large to be packed with a header */
+			rc = udp_assoc_send_msg(assoc, msgs[sent].dest,
+			    msgs[sent].data, msgs[sent].size);
+			if (rc != EOK)
+				break;
+
+			++sent;
+			continue;
+		}
+
+		rc = udp_assoc_send_list(assoc, &msgs[sent], n, size, &nsent);
+		sent += nsent;
+		if (rc != EOK)
+			break;
+	}
+
+	if (rsent != NULL)
+		*rsent = sent;
+	return rc;
+}
+
 /** Get the user/callback argument for an association.
  *
  * @param assoc UDP association
@@ -322,6 +446,15 @@ errno_t udp_rmsg_read(udp_rmsg_t *rmsg, size_t off, void *buf, size_t bsize)
 	async_exch_t *exch;
 	ipc_call_t answer;
 
+	if (rmsg->data != NULL) {
+		if (off > rmsg->size)
+			return EINVAL;
+
+		memcpy(buf, (uint8_t *) rmsg->data + off,
+		    min(rmsg->size - off, bsize));
+		return EOK;
+	}
+
 	exch = async_exchange_begin(rmsg->udp->sess);
 	aid_t req = async_send_1(exch, UDP_RMSG_READ, off, &answer);
 	errno_t rc = async_data_read_start(exch, buf, bsize);
@@ -406,6 +539,43 @@ static errno_t udp_rmsg_info(udp_t *udp, udp_rmsg_t *rmsg)
 	rmsg->assoc_id = ipc_get_arg1(&answer);
 	rmsg->size = ipc_get_arg2(&answer);
 	rmsg->remote_ep = ep;
+	rmsg->data = NULL;
+	return EOK;
+}
+
+/** Read a batch of received messages from UDP service.
+ *
+ * The messages are removed from the UDP service receive queue and
+ * stored to the receive buffer of @a udp.
+ *
+ * @param udp   UDP client
+ * @param rsize Place to store size of the received batch in bytes
+ *
+ * @return EOK on success, ENOENT if there are no received messages,
+ *         EOVERFLOW if the next message does not fit into the buffer
+ *         or an error code
+ */
+static errno_t udp_rmsg_read_batch(udp_t *udp, size_t *rsize)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+
+	exch = async_exchange_begin(udp->sess);
+	aid_t req = async_send_0(exch, UDP_RMSG_READ_BATCH, &answer);
+	errno_t rc = async_data_read_start(exch, udp->rbuf, DATA_XFER_LIMIT);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK)
+		return retval;
+
+	*rsize = ipc_get_arg2(&answer);
 	return EOK;
 }
 
@@ -445,10 +615,49 @@ static errno_t udp_assoc_get(udp_t *udp, sysarg_t id, udp_assoc_t **rassoc)
 	return EINVAL;
 }
 
+/** Pass received message to the @c recv_msg callback of its association.
+ *
+ * @param udp  UDP client
+ * @param rmsg Received message
+ */
+static void udp_rmsg_deliver(udp_t *udp, udp_rmsg_t *rmsg)
+{
+	udp_assoc_t *assoc;
+	errno_t rc;
+
+	rc = udp_assoc_get(udp, rmsg->assoc_id, &assoc);
+	if (rc != EOK)
+		return;
+
+	if (assoc->cb != NULL && assoc->cb->recv_msg != NULL)
+		assoc->cb->recv_msg(assoc, rmsg);
+}
+
+/** Receive the next message one request at a time.
+ *
+ * This is used for messages too large to be received in a batch.
+ *
+ * @param udp UDP client
+ * @return EOK on success or an error code
+ */
+static errno_t udp_ev_data_single(udp_t *udp)
+{
+	udp_rmsg_t rmsg;
+	errno_t rc;
+
+	rc = udp_rmsg_info(udp, &rmsg);
+	if (rc != EOK)
+		return rc;
+
+	udp_rmsg_deliver(udp, &rmsg);
+
+	return udp_rmsg_discard(udp);
+}
+
 /** Handle 'data' event, i.e. some message(s) arrived.
  *
- * For each received message, get information about it, call @c recv_msg
- * callback and discard it.
+ * Read received messages from the UDP service in batches and call
+ * @c recv_msg callback for each of them.
  *
  * @param udp   UDP client
  * @param icall IPC message
@@ -456,27 +665,42 @@ static errno_t udp_assoc_get(udp_t *udp, sysarg_t id, udp_assoc_t **rassoc)
  */
 static void udp_ev_data(udp_t *udp, ipc_call_t *icall)
 {
+	udp_recv_hdr_t hdr;
 	udp_rmsg_t rmsg;
-	udp_assoc_t *assoc;
+	uint8_t *data;
+	size_t size;
+	size_t off;
 	errno_t rc;
 
 	while (true) {
-		rc = udp_rmsg_info(udp, &rmsg);
-		if (rc != EOK) {
-			break;
-		}
-
-		rc = udp_assoc_get(udp, rmsg.assoc_id, &assoc);
-		if (rc != EOK) {
+		rc = udp_rmsg_read_batch(udp, &size);
+		if (rc == EOVERFLOW) {
+			rc = udp_ev_data_single(udp);
+			if (rc != EOK)
+				break;
 			continue;
 		}
 
-		if (assoc->cb != NULL && assoc->cb->recv_msg != NULL)
-			assoc->cb->recv_msg(assoc, &rmsg);
-
-		rc = udp_rmsg_discard(udp);
-		if (rc != EOK) {
+		if (rc != EOK)
 			break;
+
+		data = udp->rbuf;
+		off = 0;
+		while (size - off >= sizeof(hdr)) {
+			memcpy(&hdr, data + off, sizeof(hdr));
+			off += sizeof(hdr);
+
+			if (hdr.size > size - off)
+				break;
+
+			rmsg.udp = udp;
+			rmsg.assoc_id = hdr.assoc_id;
+			rmsg.size = hdr.size;
+			rmsg.remote_ep = hdr.remote_ep;
+			rmsg.data = data + off;
+			udp_rmsg_deliver(udp, &rmsg);
+
+			off += hdr.size;
 		}
 	}
 
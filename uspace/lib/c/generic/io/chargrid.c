@@ -79,6 +79,7 @@ chargrid_t *chargrid_create(sysarg_t cols, sysarg_t rows,
 	scrbuf->attrs.val.style = STYLE_NORMAL;
 
 	scrbuf->top_row = 0;
+	chargrid_reset_dirty_rows(scrbuf);
 	chargrid_clear(scrbuf);
 
 	return scrbuf;
@@ -100,11 +101,61 @@ sysarg_t chargrid_get_top_row(chargrid_t *scrbuf)
 	return scrbuf->top_row;
 }
 
+/** Get the range of rows containing dirty fields.
+ *
+ * Rows outside of the range contain no dirty fields, so that the reader
+ * of the chargrid need not look at them at all.
+ *
+ * @param scrbuf Chargrid.
+ * @param top    Place to store the first dirty row.
+ * @param bottom Place to store the row after the last dirty row.
+ *
+ */
+void chargrid_get_dirty_rows(chargrid_t *scrbuf, sysarg_t *top,
+    sysarg_t *bottom)
+{
+	*top = scrbuf->dirty_top;
+	*bottom = scrbuf->dirty_bottom;
+}
+
+/** Mark all rows as clean.
+ *
+ * @param scrbuf Chargrid.
+ *
+ */
+void chargrid_reset_dirty_rows(chargrid_t *scrbuf)
+{
+	scrbuf->dirty_top = 0;
+	scrbuf->dirty_bottom = 0;
+}
+
+static void chargrid_dirty_row(chargrid_t *scrbuf, sysarg_t row)
+{
+	if (scrbuf->dirty_top >= scrbuf->dirty_bottom) {
+		scrbuf->dirty_top = row;
+		scrbuf->dirty_bottom = row + 1;
+		return;
+	}
+
+	if (row < scrbuf->dirty_top)
+		scrbuf->dirty_top = row;
+
+	if (row >= scrbuf->dirty_bottom)
+		scrbuf->dirty_bottom = row + 1;
+}
+
 static sysarg_t chargrid_update_rows(chargrid_t *scrbuf)
 {
 	if (scrbuf->row == scrbuf->rows) {
 		scrbuf->row = scrbuf->rows - 1;
 		scrbuf->top_row = (scrbuf->top_row + 1) % scrbuf->rows;
+
+		/* The dirty rows have moved one row up. */
+		if (scrbuf->dirty_top > 0)
+			scrbuf->dirty_top--;
+		if (scrbuf->dirty_bottom > 0)
+			scrbuf->dirty_bottom--;
+
 		chargrid_clear_row(scrbuf, scrbuf->row);
 
 		return scrbuf->rows;
@@ -150,6 +201,7 @@ sysarg_t chargrid_putwchar(chargrid_t *scrbuf, wchar_t ch, bool update)
 	field->ch = ch;
 	field->attrs = scrbuf->attrs;
 	field->flags |= CHAR_FLAG_DIRTY;
+	chargrid_dirty_row(scrbuf, scrbuf->row);
 
 	if (update) {
 		scrbuf->col++;
@@ -249,6 +301,9 @@ void chargrid_clear(chargrid_t *scrbuf)
 		scrbuf->data[pos].flags = CHAR_FLAG_DIRTY;
 	}
 
+	scrbuf->dirty_top = 0;
+	scrbuf->dirty_bottom = scrbuf->rows;
+
 	scrbuf->col = 0;
 	scrbuf->row = 0;
 }
@@ -312,6 +367,8 @@ void chargrid_clear_row(chargrid_t *scrbuf, sysarg_t row)
 		field->attrs = scrbuf->attrs;
 		field->flags |= CHAR_FLAG_DIRTY;
 	}
+
+	chargrid_dirty_row(scrbuf, row);
 }
 
 /** Set chargrid style.
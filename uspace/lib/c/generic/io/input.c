@@ -40,6 +40,7 @@
 #include <io/kbd_event.h>
 #include <io/input.h>
 #include <ipc/input.h>
+#include <macros.h>
 #include <stdlib.h>
 
 static void input_cb_conn(ipc_call_t *icall, void *arg);
@@ -124,12 +125,14 @@ static void input_ev_move(input_t *input, ipc_call_t *call)
 {
 	int dx;
 	int dy;
+	usec_t time;
 	errno_t rc;
 
 	dx = ipc_get_arg1(call);
 	dy = ipc_get_arg2(call);
+	time = MERGE_LOUP32(ipc_get_arg3(call), ipc_get_arg4(call));
 
-	rc = input->ev_ops->move(input, dx, dy);
+	rc = input->ev_ops->move(input, dx, dy, time);
 	async_answer_0(call, rc);
 }
 
@@ -163,6 +166,62 @@ static void input_ev_button(input_t *input, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+/** Deliver one event from an event list. */
+static errno_t input_ev_rec(input_t *input, input_ev_rec_t *rec)
+{
+	switch (rec->type) {
+	case INPUT_EVENT_ACTIVE:
+		return input->ev_ops->active(input);
+	case INPUT_EVENT_DEACTIVE:
+		return input->ev_ops->deactive(input);
+	case INPUT_EVENT_KEY:
+		return input->ev_ops->key(input, rec->args[0], rec->args[1],
+		    rec->args[2], rec->args[3]);
+	case INPUT_EVENT_MOVE:
+		return input->ev_ops->move(input, (int) rec->args[0],
+		    (int) rec->args[1],
+		    MERGE_LOUP32(rec->args[2], rec->args[3]));
+	case INPUT_EVENT_ABS_MOVE:
+		return input->ev_ops->abs_move(input, rec->args[0],
+		    rec->args[1], rec->args[2], rec->args[3]);
+	case INPUT_EVENT_BUTTON:
+		return input->ev_ops->button(input, (int) rec->args[0],
+		    (int) rec->args[1]);
+	default:
+		return ENOTSUP;
+	}
+}
+
+/** Deliver a list of events sent at once by the input server. */
+static void input_ev_list(input_t *input, ipc_call_t *call)
+{
+	input_ev_rec_t *recs;
+	size_t size;
+	size_t i;
+	errno_t rc;
+
+	rc = async_data_write_accept((void **) &recs, false,
+	    sizeof(input_ev_rec_t),
+	    INPUT_EVENT_LIST_MAX * sizeof(input_ev_rec_t), 0, &size);
+	if (rc != EOK) {
+		async_answer_0(call, rc);
+		return;
+	}
+
+	/*
+	 * Answer only after all events were processed so that the input
+	 * server can coalesce further events while we are busy.
+	 */
+	for (i = 0; i < size / sizeof(input_ev_rec_t); i++) {
+		rc = input_ev_rec(input, &recs[i]);
+		if (rc != EOK)
+			break;
+	}
+
+	free(recs);
+	async_answer_0(call, rc);
+}
+
 static void input_cb_conn(ipc_call_t *icall, void *arg)
 {
 	input_t *input = (input_t *) arg;
@@ -195,6 +254,9 @@ static void input_cb_conn(ipc_call_t *icall, void *arg)
 		case INPUT_EVENT_BUTTON:
 			input_ev_button(input, &call);
 			break;
+		case INPUT_EVENT_LIST:
+			input_ev_list(input, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 		}
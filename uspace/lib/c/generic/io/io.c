@@ -37,6 +37,7 @@
 #include <str.h>
 #include <errno.h>
 #include <limits.h>
+#include <mem.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <async.h>
@@ -52,6 +53,7 @@
 
 static void _ffillbuf(FILE *stream);
 static void _fflushbuf(FILE *stream);
+static void _faio_drain(FILE *stream);
 
 static size_t stdio_kio_read(void *, size_t, size_t, FILE *);
 static size_t stdio_kio_write(const void *, size_t, size_t, FILE *);
@@ -269,6 +271,9 @@ int setvbuf(FILE *stream, void *buf, int mode, size_t size)
 	if (mode != _IONBF && mode != _IOLBF && mode != _IOFBF)
 		return -1;
 
+	/* The read ahead and write behind buffers have the old size. */
+	_faio_drain(stream);
+
 	stream->btype = mode;
 	stream->buf = buf;
 	stream->buf_size = size;
@@ -388,6 +393,8 @@ FILE *fopen(const char *path, const char *fmode)
 	stream->arg = NULL;
 	stream->sess = NULL;
 	stream->need_sync = false;
+	stream->aio = NULL;
+	stream->aio_disabled = false;
 	_setvbuf(stream);
 	stream->ungetc_chars = 0;
 
@@ -413,6 +420,8 @@ FILE *fdopen(int fd, const char *mode)
 	stream->arg = NULL;
 	stream->sess = NULL;
 	stream->need_sync = false;
+	stream->aio = NULL;
+	stream->aio_disabled = false;
 	_setvbuf(stream);
 	stream->ungetc_chars = 0;
 
@@ -427,6 +436,10 @@ static int _fclose_nofree(FILE *stream)
 
 	fflush(stream);
 
+	_faio_drain(stream);
+	free(stream->aio);
+	stream->aio = NULL;
+
 	if (stream->sess != NULL)
 		async_hangup(stream->sess);
 
@@ -520,23 +533,216 @@ static size_t _fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 	return (nwritten / size);
 }
 
+/** Get asynchronous I/O state of a stream.
+ *
+ * The state is allocated on first use. Only fully buffered streams backed
+ * by regular files do asynchronous I/O, as a read ahead on a device or a
+ * pipe could block indefinitely.
+ *
+ * @return Asynchronous I/O state or NULL if it is not used by the stream.
+ */
+static __stream_aio_t *_faio(FILE *stream)
+{
+	vfs_stat_t st;
+
+	if (stream->btype != _IOFBF)
+		return NULL;
+
+	if (stream->aio != NULL || stream->aio_disabled)
+		return stream->aio;
+
+	stream->aio_disabled = true;
+
+	if (stream->ops != &stdio_vfs_ops || stream->fd < 0)
+		return NULL;
+
+	if (vfs_stat(stream->fd, &st) != EOK || !st.is_file)
+		return NULL;
+
+	stream->aio = calloc(1, sizeof(__stream_aio_t));
+	if (stream->aio == NULL)
+		return NULL;
+
+	stream->aio->advice = FADV_NORMAL;
+	stream->aio->next_pos = stream->pos;
+	stream->aio_disabled = false;
+	return stream->aio;
+}
+
+/** Start reading the next stream buffer ahead. */
+static void _fra_start(FILE *stream, __stream_aio_t *aio)
+{
+	if (aio->ra_pending)
+		return;
+
+	if (aio->ra_buf == NULL) {
+		aio->ra_buf = malloc(stream->buf_size);
+		if (aio->ra_buf == NULL)
+			return;
+	}
+
+	vfs_read_start(stream->fd, stream->pos, aio->ra_buf, stream->buf_size,
+	    &aio->ra);
+	aio->ra_pos = stream->pos;
+	aio->ra_pending = true;
+}
+
+/** Wait for the read ahead request and discard its data. */
+static void _fra_drop(__stream_aio_t *aio)
+{
+	size_t nread;
+
+	if (aio->ra_pending) {
+		aio->ra_pending = false;
+		(void) vfs_aio_wait(&aio->ra, &nread);
+	}
+}
+
+/** Wait for the write behind request.
+ *
+ * If the request wrote only part of the data, the rest is written
+ * synchronously. On error, stream error indicator is set and errno is set.
+ *
+ * @return Zero on success, EOF on error.
+ */
+static int _fwb_wait(FILE *stream)
+{
+	__stream_aio_t *aio = stream->aio;
+	aoff64_t pos;
+	size_t nwritten;
+	errno_t rc;
+
+	if (aio == NULL || !aio->wb_pending)
+		return 0;
+
+	aio->wb_pending = false;
+
+	rc = vfs_aio_wait(&aio->wb, &nwritten);
+	if (rc == EOK && nwritten < aio->wb_size) {
+		pos = aio->wb_pos + nwritten;
+		rc = vfs_write(stream->fd, &pos, aio->wb_buf + nwritten,
+		    aio->wb_size - nwritten, &nwritten);
+	}
+
+	if (rc != EOK) {
+		errno = rc;
+		stream->error = true;
+		return EOF;
+	}
+
+	return 0;
+}
+
+/** Write out stream buffer behind, without waiting for the result.
+ *
+ * At most one write behind request per stream is in progress, so that
+ * no more than two buffers of data are not on the file yet.
+ *
+ * @return True if the buffer was written behind or an error occured,
+ *         false if the buffer has to be written synchronously.
+ */
+static bool _fwb_start(FILE *stream, size_t size)
+{
+	__stream_aio_t *aio = _faio(stream);
+
+	if (aio == NULL)
+		return false;
+
+	if (_fwb_wait(stream) != 0)
+		return true;
+
+	if (aio->wb_buf == NULL) {
+		aio->wb_buf = malloc(stream->buf_size);
+		if (aio->wb_buf == NULL)
+			return false;
+	}
+
+	memcpy(aio->wb_buf, stream->buf_tail, size);
+	vfs_write_start(stream->fd, stream->pos, aio->wb_buf, size, &aio->wb);
+	aio->wb_pos = stream->pos;
+	aio->wb_size = size;
+	aio->wb_pending = true;
+
+	stream->pos += size;
+	stream->need_sync = true;
+	return true;
+}
+
+/** Finish asynchronous I/O on a stream and free its buffers.
+ *
+ * On write behind error, stream error indicator is set and errno is set.
+ */
+static void _faio_drain(FILE *stream)
+{
+	__stream_aio_t *aio = stream->aio;
+
+	if (aio == NULL)
+		return;
+
+	_fra_drop(aio);
+	(void) _fwb_wait(stream);
+
+	free(aio->ra_buf);
+	free(aio->wb_buf);
+	aio->ra_buf = NULL;
+	aio->wb_buf = NULL;
+}
+
 /** Read some data in stream buffer.
+ *
+ * If the stream buffer is being read sequentially, the next buffer is
+ * read ahead while the caller consumes this one.
  *
  * On error, stream error indicator is set and errno is set.
  */
 static void _ffillbuf(FILE *stream)
 {
+	__stream_aio_t *aio = _faio(stream);
+	aoff64_t fill_pos = stream->pos;
+	bool have_data = false;
 	errno_t rc;
 	size_t nread;
 
 	stream->buf_head = stream->buf_tail = stream->buf;
 
-	rc = vfs_read(stream->fd, &stream->pos, stream->buf, stream->buf_size,
-	    &nread);
-	if (rc != EOK) {
-		errno = rc;
-		stream->error = true;
-		return;
+	if (aio != NULL) {
+		/* Data written behind must be visible to the read. */
+		if (_fwb_wait(stream) != 0)
+			return;
+
+		if (aio->ra_pending) {
+			aio->ra_pending = false;
+			rc = vfs_aio_wait(&aio->ra, &nread);
+
+			/*
+			 * Data read ahead from elsewhere is discarded. Errors
+			 * are left for the synchronous read to report.
+			 */
+			if (rc == EOK && aio->ra_pos == stream->pos) {
+				memcpy(stream->buf, aio->ra_buf, nread);
+				stream->pos += nread;
+				have_data = true;
+			}
+		}
+	}
+
+	if (!have_data) {
+		rc = vfs_read(stream->fd, &stream->pos, stream->buf,
+		    stream->buf_size, &nread);
+		if (rc != EOK) {
+			errno = rc;
+			stream->error = true;
+			return;
+		}
+	}
+
+	if (aio != NULL) {
+		bool sequential = (fill_pos == aio->next_pos);
+
+		aio->next_pos = stream->pos;
+		if (nread > 0 && aio->advice != FADV_RANDOM &&
+		    (sequential || aio->advice == FADV_SEQUENTIAL))
+			_fra_start(stream, aio);
 	}
 
 	if (nread == 0) {
@@ -564,8 +770,9 @@ static void _fflushbuf(FILE *stream)
 
 	/* If buffer has unwritten data, we need to write them out. */
 	if (bytes_used > 0 && stream->buf_state == _bs_write) {
-		(void) _fwrite(stream->buf_tail, 1, bytes_used, stream);
-		/* On error stream error indicator and errno are set by _fwrite */
+		if (!_fwb_start(stream, bytes_used))
+			(void) _fwrite(stream->buf_tail, 1, bytes_used, stream);
+		/* On error stream error indicator and errno are set */
 		if (stream->error)
 			return;
 	}
@@ -590,7 +797,6 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
 	size_t now;
 	size_t data_avail;
 	size_t total_read;
-	size_t i;
 
 	if (size == 0 || nmemb == 0)
 		return 0;
@@ -638,9 +844,7 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
 		else
 			now = bytes_left;
 
-		for (i = 0; i < now; i++) {
-			dp[i] = stream->buf_tail[i];
-		}
+		memcpy(dp, stream->buf_tail, now);
 
 		dp += now;
 		stream->buf_tail += now;
@@ -666,8 +870,6 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 	size_t now;
 	size_t buf_free;
 	size_t total_written;
-	size_t i;
-	uint8_t b;
 	bool need_flush;
 
 	if (size == 0 || nmemb == 0)
@@ -684,6 +886,10 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 	if (stream->buf_state == _bs_read)
 		_fflushbuf(stream);
 
+	/* Data read ahead could miss the write. */
+	if (stream->aio != NULL)
+		_fra_drop(stream->aio);
+
 	/* Perform lazy allocation of stream buffer. */
 	if (stream->buf == NULL) {
 		if (_fallocbuf(stream) != 0)
@@ -702,13 +908,10 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 		else
 			now = bytes_left;
 
-		for (i = 0; i < now; i++) {
-			b = data[i];
-			stream->buf_head[i] = b;
+		memcpy(stream->buf_head, data, now);
 
-			if ((b == '\n') && (stream->btype == _IOLBF))
-				need_flush = true;
-		}
+		if ((stream->btype == _IOLBF) && (memchr(data, '\n', now) != NULL))
+			need_flush = true;
 
 		data += now;
 		stream->buf_head += now;
@@ -873,6 +1076,10 @@ int fseek64(FILE *stream, off64_t offset, int whence)
 		stream->pos += offset;
 		break;
 	case SEEK_END:
+		/* The size has to include data written behind. */
+		if (_fwb_wait(stream) != 0)
+			return -1;
+
 		rc = vfs_stat(stream->fd, &st);
 		if (rc != EOK) {
 			errno = rc;
@@ -935,6 +1142,9 @@ int fflush(FILE *stream)
 		return EOF;
 	}
 
+	if (_fwb_wait(stream) != 0)
+		return EOF;
+
 	if (stream->need_sync) {
 		/**
 		 * Better than syncing always, but probably still not the
@@ -949,6 +1159,53 @@ int fflush(FILE *stream)
 	return 0;
 }
 
+/** Advise about the expected access pattern of a stream.
+ *
+ * This only affects reading ahead on streams backed by regular files.
+ *
+ * @param stream Stream.
+ * @param advice FADV_NORMAL, FADV_SEQUENTIAL or FADV_RANDOM to set the
+ *               access pattern, FADV_WILLNEED to start reading ahead from
+ *               the current position, FADV_DONTNEED to drop data read ahead.
+ *
+ * @return Zero on success, EOF with errno set on error.
+ */
+int fadvise(FILE *stream, int advice)
+{
+	__stream_aio_t *aio;
+
+	if (advice < FADV_NORMAL || advice > FADV_DONTNEED) {
+		errno = EINVAL;
+		return EOF;
+	}
+
+	aio = _faio(stream);
+	if (aio == NULL)
+		return 0;
+
+	switch (advice) {
+	case FADV_NORMAL:
+	case FADV_SEQUENTIAL:
+		aio->advice = advice;
+		break;
+	case FADV_RANDOM:
+		aio->advice = advice;
+		_fra_drop(aio);
+		break;
+	case FADV_WILLNEED:
+		if (stream->buf_state != _bs_write)
+			_fra_start(stream, aio);
+		break;
+	case FADV_DONTNEED:
+		_fra_drop(aio);
+		free(aio->ra_buf);
+		aio->ra_buf = NULL;
+		break;
+	}
+
+	return 0;
+}
+
 int feof(FILE *stream)
 {
 	return stream->eof;
@@ -42,6 +42,7 @@
 #include <ipc/logger.h>
 #include <str.h>
 #include <ns.h>
+#include <time.h>
 
 /** Id of the first log we create at logger. */
 static sysarg_t default_log_id;
@@ -66,7 +67,93 @@ static async_sess_t *logger_session;
 /** Maximum length of a single log message (in bytes). */
 #define MESSAGE_BUFFER_SIZE 4096
 
+/** Number of logs whose level is cached. */
+#define LEVEL_CACHE_SIZE 16
+
+/** How long a cached log level is trusted (in milliseconds). */
+#define LEVEL_CACHE_MSEC 1000
+
+/** Cached effective level of a log at the logger. */
+typedef struct {
+	/** Log id, zero for an unused entry. */
+	sysarg_t log;
+	/** Effective level of the log. */
+	log_level_t level;
+	/** When the level was received from the logger. */
+	struct timespec updated;
+} log_level_cache_t;
+
+static FIBRIL_MUTEX_INITIALIZE(level_cache_guard);
+static log_level_cache_t level_cache[LEVEL_CACHE_SIZE];
+
+/** Entry of the level cache to be replaced next. */
+static size_t level_cache_next;
+
+/** Look up a fresh cached level of a log.
+ *
+ * @param log Log id.
+ * @param[out] level Where to store the cached level.
+ * @return @c true if a level not older than LEVEL_CACHE_MSEC was found.
+ */
+static bool level_cache_lookup(sysarg_t log, log_level_t *level)
+{
+	struct timespec now;
+	bool found = false;
+
+	getuptime(&now);
+
+	fibril_mutex_lock(&level_cache_guard);
+	for (size_t i = 0; i < LEVEL_CACHE_SIZE; i++) {
+		log_level_cache_t *entry = &level_cache[i];
+		if (entry->log != log)
+			continue;
+
+		if (NSEC2MSEC(ts_sub_diff(&now, &entry->updated)) <
+		    LEVEL_CACHE_MSEC) {
+			*level = entry->level;
+			found = true;
+		}
+		break;
+	}
+	fibril_mutex_unlock(&level_cache_guard);
+
+	return found;
+}
+
+/** Remember the level of a log received from the logger.
+ *
+ * @param log Log id.
+ * @param level Effective level of the log.
+ */
+static void level_cache_update(sysarg_t log, log_level_t level)
+{
+	log_level_cache_t *entry = NULL;
+
+	fibril_mutex_lock(&level_cache_guard);
+	for (size_t i = 0; i < LEVEL_CACHE_SIZE; i++) {
+		if (level_cache[i].log == log) {
+			entry = &level_cache[i];
+			break;
+		}
+	}
+
+	if (entry == NULL) {
+		entry = &level_cache[level_cache_next];
+		level_cache_next = (level_cache_next + 1) % LEVEL_CACHE_SIZE;
+		entry->log = log;
+	}
+
+	entry->level = level;
+	getuptime(&entry->updated);
+	fibril_mutex_unlock(&level_cache_guard);
+}
+
 /** Send formatted message to the logger service.
+ *
+ * While the level of the log is known from a recent answer of the
+ * logger, messages above that level are dropped right away and other
+ * messages are sent without waiting for the answer. Otherwise the
+ * message is always sent and the answer refreshes the cached level.
  *
  * @param session Initialized IPC session with the logger.
  * @param log Log to use.
@@ -76,21 +163,35 @@ static async_sess_t *logger_session;
  */
 static errno_t logger_message(async_sess_t *session, log_t log, log_level_t level, char *message)
 {
+	if (log == LOG_DEFAULT)
+		log = default_log_id;
+
+	log_level_t log_level;
+	bool cached = level_cache_lookup(log, &log_level);
+	if (cached && level > log_level)
+		return EOK;
+
 	async_exch_t *exchange = async_exchange_begin(session);
 	if (exchange == NULL) {
 		return ENOMEM;
 	}
-	if (log == LOG_DEFAULT)
-		log = default_log_id;
 
 	// FIXME: remove when all USB drivers use libc logging explicitly
 	str_rtrim(message, '\n');
 
+	ipc_call_t answer;
 	aid_t reg_msg = async_send_2(exchange, LOGGER_WRITER_MESSAGE,
-	    log, level, NULL);
+	    log, level, &answer);
 	errno_t rc = async_data_write_start(exchange, message, str_size(message));
-	errno_t reg_msg_rc;
-	async_wait_for(reg_msg, &reg_msg_rc);
+
+	errno_t reg_msg_rc = EOK;
+	if (cached) {
+		async_forget(reg_msg);
+	} else {
+		async_wait_for(reg_msg, &reg_msg_rc);
+		if (reg_msg_rc == EOK)
+			level_cache_update(log, ipc_get_arg1(&answer));
+	}
 
 	async_exchange_end(exchange);
 
@@ -207,6 +308,7 @@ log_t log_create(const char *name, log_t parent)
 	if ((rc != EOK) || (reg_msg_rc != EOK))
 		return parent;
 
+	level_cache_update(ipc_get_arg1(&answer), ipc_get_arg2(&answer));
 	return ipc_get_arg1(&answer);
 }
 
@@ -47,6 +47,8 @@
 #include <assert.h>
 #include <macros.h>
 #include <wchar.h>
+#include <mem.h>
+#include <stdint.h>
 
 /** show prefixes 0x or 0 */
 #define __PRINTF_FLAG_PREFIX       0x00000001
@@ -85,6 +87,9 @@
  */
 #define PRINT_NUMBER_BUFFER_SIZE  (64 + 5)
 
+/** Size of the buffer a single conversion is assembled in before output */
+#define PRINTF_FIELD_BUFFER_SIZE  128
+
 /** Get signed or unsigned integer argument */
 #define PRINTF_GET_INT_ARGUMENT(type, ap, flags) \
 	({ \
@@ -122,6 +127,38 @@ static const char *digits_small = "0123456789abcdef";
 static const char *digits_big = "0123456789ABCDEF";
 static const char invalch = U_SPECIAL;
 
+/** Decimal representation of all numbers from 0 to 99 */
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/** Output of a single conversion.
+ *
+ * A conversion consists of many small pieces (padding, sign, prefix,
+ * digits). Instead of passing each of them to the output method,
+ * they are collected here and written out in one go. Only ASCII
+ * characters are passed through the field, so the number of characters
+ * is equal to the number of bytes for every output method.
+ */
+typedef struct {
+	printf_spec_t *ps;
+	/** Number of characters written out so far */
+	int counter;
+	/** An output error has occurred */
+	bool error;
+	/** Number of bytes used in buf */
+	size_t len;
+	char buf[PRINTF_FIELD_BUFFER_SIZE];
+} printf_field_t;
+
 /** Unformatted double number string representation. */
 typedef struct {
 	/** Buffer with len digits, no sign or leading zeros. */
@@ -151,13 +188,112 @@ static int get_sign_char(bool negative, uint32_t flags)
 /** Prints count times character ch. */
 static int print_padding(char ch, int count, printf_spec_t *ps)
 {
-	for (int i = 0; i < count; ++i) {
-		if (ps->str_write(&ch, 1, ps->data) < 0) {
+	char buf[16];
+	int counter = 0;
+
+	if (count <= 0)
+		return 0;
+
+	memset(buf, ch, min(count, (int) sizeof(buf)));
+
+	while (count > 0) {
+		int now = min(count, (int) sizeof(buf));
+		int ret = ps->str_write(buf, now, ps->data);
+		if (ret < 0)
 			return -1;
-		}
+
+		counter += ret;
+		count -= now;
+	}
+
+	return counter;
+}
+
+static void field_init(printf_field_t *field, printf_spec_t *ps)
+{
+	field->ps = ps;
+	field->counter = 0;
+	field->error = false;
+	field->len = 0;
+}
+
+/** Write out the buffered part of a field. */
+static void field_flush(printf_field_t *field)
+{
+	if ((field->len == 0) || (field->error)) {
+		field->len = 0;
+		return;
+	}
+
+	int ret = field->ps->str_write(field->buf, field->len,
+	    field->ps->data);
+	if (ret < 0)
+		field->error = true;
+	else
+		field->counter += ret;
+
+	field->len = 0;
+}
+
+/** Append ASCII characters to a field. */
+static void field_write(printf_field_t *field, const char *str, size_t size)
+{
+	if (size > PRINTF_FIELD_BUFFER_SIZE - field->len)
+		field_flush(field);
+
+	if (size > PRINTF_FIELD_BUFFER_SIZE) {
+		/* Too big to be buffered, write out directly. */
+		if (field->error)
+			return;
+
+		int ret = field->ps->str_write(str, size, field->ps->data);
+		if (ret < 0)
+			field->error = true;
+		else
+			field->counter += ret;
+
+		return;
 	}
 
-	return count;
+	memcpy(field->buf + field->len, str, size);
+	field->len += size;
+}
+
+/** Append a single ASCII character to a field. */
+static void field_putchar(printf_field_t *field, char ch)
+{
+	if (!ascii_check(ch))
+		ch = invalch;
+
+	if (field->len == PRINTF_FIELD_BUFFER_SIZE)
+		field_flush(field);
+
+	field->buf[field->len++] = ch;
+}
+
+/** Append count times character ch to a field. */
+static void field_pad(printf_field_t *field, char ch, int count)
+{
+	while (count > 0) {
+		if (field->len == PRINTF_FIELD_BUFFER_SIZE)
+			field_flush(field);
+
+		size_t now = min((size_t) count,
+		    PRINTF_FIELD_BUFFER_SIZE - field->len);
+		memset(field->buf + field->len, ch, now);
+		field->len += now;
+		count -= now;
+	}
+}
+
+/** Write out the rest of a field.
+ *
+ * @return Number of characters printed, negative value on failure.
+ */
+static int field_finish(printf_field_t *field)
+{
+	field_flush(field);
+	return field->error ? -1 : field->counter;
 }
 
 /** Print one or more characters without adding newline.
@@ -251,31 +387,19 @@ static int printf_putwchar(const wchar_t ch, printf_spec_t *ps)
  */
 static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *ps)
 {
-	size_t counter = 0;
-	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
-		while (--width > 0) {
-			/*
-			 * One space is consumed by the character itself, hence
-			 * the predecrement.
-			 */
-			if (printf_putchar(' ', ps) > 0)
-				counter++;
-		}
-	}
+	printf_field_t field;
+	field_init(&field, ps);
 
-	if (printf_putchar(ch, ps) > 0)
-		counter++;
+	/* One space is consumed by the character itself. */
+	if (!(flags & __PRINTF_FLAG_LEFTALIGNED))
+		field_pad(&field, ' ', width - 1);
 
-	while (--width > 0) {
-		/*
-		 * One space is consumed by the character itself, hence
-		 * the predecrement.
-		 */
-		if (printf_putchar(' ', ps) > 0)
-			counter++;
-	}
+	field_putchar(&field, ch);
 
-	return (int) (counter);
+	if (flags & __PRINTF_FLAG_LEFTALIGNED)
+		field_pad(&field, ' ', width - 1);
+
+	return field_finish(&field);
 }
 
 /** Print one formatted wide character.
@@ -290,27 +414,20 @@ static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *p
 static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_spec_t *ps)
 {
 	size_t counter = 0;
+	int ret;
+
+	/* One space is consumed by the character itself. */
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
-		while (--width > 0) {
-			/*
-			 * One space is consumed by the character itself, hence
-			 * the predecrement.
-			 */
-			if (printf_putchar(' ', ps) > 0)
-				counter++;
-		}
+		if ((ret = print_padding(' ', width - 1, ps)) > 0)
+			counter += ret;
 	}
 
 	if (printf_putwchar(ch, ps) > 0)
 		counter++;
 
-	while (--width > 0) {
-		/*
-		 * One space is consumed by the character itself, hence
-		 * the predecrement.
-		 */
-		if (printf_putchar(' ', ps) > 0)
-			counter++;
+	if (flags & __PRINTF_FLAG_LEFTALIGNED) {
+		if ((ret = print_padding(' ', width - 1, ps)) > 0)
+			counter += ret;
 	}
 
 	return (int) (counter);
@@ -331,6 +448,10 @@ static int print_str(char *str, int width, unsigned int precision,
 	if (str == NULL)
 		return printf_putstr(nullstr, ps);
 
+	/* Neither padding nor truncation, no need to count characters. */
+	if ((width <= 0) && (precision == 0))
+		return printf_putstr(str, ps);
+
 	size_t strw = str_length(str);
 
 	/* Precision unspecified - print everything. */
@@ -339,12 +460,12 @@ static int print_str(char *str, int width, unsigned int precision,
 
 	/* Left padding */
 	size_t counter = 0;
+	int ret;
 	width -= precision;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
-		while (width-- > 0) {
-			if (printf_putchar(' ', ps) == 1)
-				counter++;
-		}
+		if ((ret = print_padding(' ', width, ps)) > 0)
+			counter += ret;
+		width = 0;
 	}
 
 	/* Part of @a str fitting into the alloted space. */
@@ -356,10 +477,8 @@ static int print_str(char *str, int width, unsigned int precision,
 	counter += retval;
 
 	/* Right padding */
-	while (width-- > 0) {
-		if (printf_putchar(' ', ps) == 1)
-			counter++;
-	}
+	if ((ret = print_padding(' ', width, ps)) > 0)
+		counter += ret;
 
 	return ((int) counter);
 
@@ -388,12 +507,12 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
 
 	/* Left padding */
 	size_t counter = 0;
+	int ret;
 	width -= precision;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
-		while (width-- > 0) {
-			if (printf_putchar(' ', ps) == 1)
-				counter++;
-		}
+		if ((ret = print_padding(' ', width, ps)) > 0)
+			counter += ret;
+		width = 0;
 	}
 
 	/* Part of @a wstr fitting into the alloted space. */
@@ -405,14 +524,79 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
 	counter += retval;
 
 	/* Right padding */
-	while (width-- > 0) {
-		if (printf_putchar(' ', ps) == 1)
-			counter++;
-	}
+	if ((ret = print_padding(' ', width, ps)) > 0)
+		counter += ret;
 
 	return ((int) counter);
 }
 
+/** Convert a number to digits in a given base.
+ *
+ * The digits are stored right-aligned, ending just before @a end.
+ *
+ * @param num    Number to convert.
+ * @param base   Base to convert the number to (must be between 2 and 16).
+ * @param digits Digit characters to use.
+ * @param end    End of the output buffer.
+ *
+ * @return Pointer to the most significant digit.
+ *
+ */
+static char *format_number(uint64_t num, unsigned int base,
+    const char *digits, char *end)
+{
+	char *ptr = end;
+
+	switch (base) {
+	case 2:
+	case 8:
+	case 16:
+		{
+			unsigned int shift = (base == 16) ? 4 : (base == 8) ? 3 : 1;
+
+			do {
+				*--ptr = digits[num & (base - 1)];
+				num >>= shift;
+			} while (num != 0);
+		}
+		return ptr;
+	case 10:
+		break;
+	default:
+		do {
+			*--ptr = digits[num % base];
+			num /= base;
+		} while (num != 0);
+		return ptr;
+	}
+
+	/* Two decimal digits per division, native word size when possible. */
+	while (num > UINT32_MAX) {
+		unsigned int pair = num % 100;
+		num /= 100;
+		ptr -= 2;
+		memcpy(ptr, &digit_pairs[pair * 2], 2);
+	}
+
+	uint32_t n = num;
+
+	while (n >= 100) {
+		unsigned int pair = n % 100;
+		n /= 100;
+		ptr -= 2;
+		memcpy(ptr, &digit_pairs[pair * 2], 2);
+	}
+
+	if (n >= 10) {
+		ptr -= 2;
+		memcpy(ptr, &digit_pairs[n * 2], 2);
+	} else {
+		*--ptr = '0' + n;
+	}
+
+	return ptr;
+}
+
 /** Print a number in a given base.
  *
  * Print significant digits of a number in given base.
@@ -423,17 +607,12 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
  * @param base      Base to print the number in (must be between 2 and 16).
  * @param flags     Flags that modify the way the number is printed.
  *
- * @return Number of characters printed.
+ * @return Number of characters printed, negative value on failure.
  *
  */
 static int print_number(uint64_t num, int width, int precision, int base,
     uint32_t flags, printf_spec_t *ps)
 {
-	/* Precision not specified. */
-	if (precision < 0) {
-		precision = 0;
-	}
-
 	const char *digits;
 	if (flags & __PRINTF_FLAG_BIGCHARS)
 		digits = digits_big;
@@ -441,26 +620,30 @@ static int print_number(uint64_t num, int width, int precision, int base,
 		digits = digits_small;
 
 	char data[PRINT_NUMBER_BUFFER_SIZE];
-	char *ptr = &data[PRINT_NUMBER_BUFFER_SIZE - 1];
+	char *end = &data[PRINT_NUMBER_BUFFER_SIZE];
+	char *ptr = format_number(num, base, digits, end);
 
-	/* Size of number with all prefixes and signs */
-	int size = 0;
+	/* Size of plain number */
+	int number_size = end - ptr;
 
-	/* Put zero at end of string */
-	*ptr-- = 0;
+	/* Plain %d, %u, %x and the like need nothing but the digits. */
+	if ((width <= number_size) && (precision <= 1) &&
+	    !(flags & (__PRINTF_FLAG_PREFIX | __PRINTF_FLAG_SHOWPLUS |
+	    __PRINTF_FLAG_SPACESIGN))) {
+		if ((flags & __PRINTF_FLAG_SIGNED) &&
+		    (flags & __PRINTF_FLAG_NEGATIVE))
+			*--ptr = '-';
 
-	if (num == 0) {
-		*ptr-- = '0';
-		size++;
-	} else {
-		do {
-			*ptr-- = digits[num % base];
-			size++;
-		} while (num /= base);
+		return printf_putnchars(ptr, end - ptr, ps);
 	}
 
-	/* Size of plain number */
-	int number_size = size;
+	/* Precision not specified. */
+	if (precision < 0) {
+		precision = 0;
+	}
+
+	/* Size of number with all prefixes and signs */
+	int size = number_size;
 
 	/*
 	 * Collect the sum of all prefixes/signs/etc. to calculate padding and
@@ -514,74 +697,53 @@ static int print_number(uint64_t num, int width, int precision, int base,
 	}
 
 	width -= precision + size - number_size;
-	size_t counter = 0;
+
+	printf_field_t field;
+	field_init(&field, ps);
 
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
-		while (width-- > 0) {
-			if (printf_putchar(' ', ps) == 1)
-				counter++;
-		}
+		field_pad(&field, ' ', width);
+		width = 0;
 	}
 
 	/* Print sign */
-	if (sgn) {
-		if (printf_putchar(sgn, ps) == 1)
-			counter++;
-	}
+	if (sgn)
+		field_putchar(&field, sgn);
 
 	/* Print prefix */
 	if (flags & __PRINTF_FLAG_PREFIX) {
 		switch (base) {
 		case 2:
 			/* Binary formating is not standard, but usefull */
-			if (printf_putchar('0', ps) == 1)
-				counter++;
-			if (flags & __PRINTF_FLAG_BIGCHARS) {
-				if (printf_putchar('B', ps) == 1)
-					counter++;
-			} else {
-				if (printf_putchar('b', ps) == 1)
-					counter++;
-			}
+			field_putchar(&field, '0');
+			if (flags & __PRINTF_FLAG_BIGCHARS)
+				field_putchar(&field, 'B');
+			else
+				field_putchar(&field, 'b');
 			break;
 		case 8:
-			if (printf_putchar('o', ps) == 1)
-				counter++;
+			field_putchar(&field, 'o');
 			break;
 		case 16:
-			if (printf_putchar('0', ps) == 1)
-				counter++;
-			if (flags & __PRINTF_FLAG_BIGCHARS) {
-				if (printf_putchar('X', ps) == 1)
-					counter++;
-			} else {
-				if (printf_putchar('x', ps) == 1)
-					counter++;
-			}
+			field_putchar(&field, '0');
+			if (flags & __PRINTF_FLAG_BIGCHARS)
+				field_putchar(&field, 'X');
+			else
+				field_putchar(&field, 'x');
 			break;
 		}
 	}
 
 	/* Print leading zeroes */
-	precision -= number_size;
-	while (precision-- > 0) {
-		if (printf_putchar('0', ps) == 1)
-			counter++;
-	}
+	field_pad(&field, '0', precision - number_size);
 
 	/* Print the number itself */
-	int retval;
-	if ((retval = printf_putstr(++ptr, ps)) > 0)
-		counter += retval;
+	field_write(&field, ptr, number_size);
 
 	/* Print trailing spaces */
+	field_pad(&field, ' ', width);
 
-	while (width-- > 0) {
-		if (printf_putchar(' ', ps) == 1)
-			counter++;
-	}
-
-	return ((int) counter);
+	return field_finish(&field);
 }
 
 /** Prints a special double (ie NaN, infinity) padded to width characters. */
@@ -603,38 +765,23 @@ static int print_special(ieee_double_t val, int width, uint32_t flags,
 
 	int padding_len = max(0, width - ((sign ? 1 : 0) + str_len));
 
-	int counter = 0;
-	int ret;
+	printf_field_t field;
+	field_init(&field, ps);
 
 	/* Leading padding. */
-	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
-			return -1;
-
-		counter += ret;
-	}
-
-	if (sign) {
-		if ((ret = ps->str_write(&sign, 1, ps->data)) < 0)
-			return -1;
-
-		counter += ret;
-	}
+	if (!(flags & __PRINTF_FLAG_LEFTALIGNED))
+		field_pad(&field, ' ', padding_len);
 
-	if ((ret = ps->str_write(str, str_len, ps->data)) < 0)
-		return -1;
+	if (sign)
+		field_putchar(&field, sign);
 
-	counter += ret;
+	field_write(&field, str, str_len);
 
 	/* Trailing padding. */
-	if (flags & __PRINTF_FLAG_LEFTALIGNED) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
-			return -1;
-
-		counter += ret;
-	}
+	if (flags & __PRINTF_FLAG_LEFTALIGNED)
+		field_pad(&field, ' ', padding_len);
 
-	return counter;
+	return field_finish(&field);
 }
 
 /** Trims trailing zeros but leaves a single "0" intact. */
@@ -727,93 +874,55 @@ static int print_double_str_fixed(double_str_t *val_str, int precision, int widt
 	int num_len = (sign ? 1 : 0) + int_len + (has_decimal_pt ? 1 : 0) + frac_len;
 
 	int padding_len = max(0, width - num_len);
-	int ret = 0;
-	int counter = 0;
-
-	/* Leading padding and sign. */
 
-	if (!(flags & (__PRINTF_FLAG_LEFTALIGNED | __PRINTF_FLAG_ZEROPADDED))) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
-			return -1;
+	printf_field_t field;
+	field_init(&field, ps);
 
-		counter += ret;
-	}
-
-	if (sign) {
-		if ((ret = ps->str_write(&sign, 1, ps->data)) < 0)
-			return -1;
+	/* Leading padding and sign. */
 
-		counter += ret;
-	}
+	if (!(flags & (__PRINTF_FLAG_LEFTALIGNED | __PRINTF_FLAG_ZEROPADDED)))
+		field_pad(&field, ' ', padding_len);
 
-	if (flags & __PRINTF_FLAG_ZEROPADDED) {
-		if ((ret = print_padding('0', padding_len, ps)) < 0)
-			return -1;
+	if (sign)
+		field_putchar(&field, sign);
 
-		counter += ret;
-	}
+	if (flags & __PRINTF_FLAG_ZEROPADDED)
+		field_pad(&field, '0', padding_len);
 
 	/* Print the intergral part of the buffer. */
 
 	int buf_int_len = min(len, len + dec_exp);
 
 	if (0 < buf_int_len) {
-		if ((ret = ps->str_write(buf, buf_int_len, ps->data)) < 0)
-			return -1;
-
-		counter += ret;
+		field_write(&field, buf, buf_int_len);
 
 		/* Print trailing zeros of the integral part of the number. */
-		if ((ret = print_padding('0', int_len - buf_int_len, ps)) < 0)
-			return -1;
+		field_pad(&field, '0', int_len - buf_int_len);
 	} else {
 		/* Single leading integer 0. */
-		char ch = '0';
-		if ((ret = ps->str_write(&ch, 1, ps->data)) < 0)
-			return -1;
+		field_putchar(&field, '0');
 	}
 
-	counter += ret;
-
 	/* Print the decimal point and the fractional part. */
 	if (has_decimal_pt) {
-		char ch = '.';
-
-		if ((ret = ps->str_write(&ch, 1, ps->data)) < 0)
-			return -1;
-
-		counter += ret;
+		field_putchar(&field, '.');
 
 		/* Print leading zeros of the fractional part of the number. */
-		if ((ret = print_padding('0', leading_frac_zeros, ps)) < 0)
-			return -1;
-
-		counter += ret;
+		field_pad(&field, '0', leading_frac_zeros);
 
 		/* Print significant digits of the fractional part of the number. */
-		if (0 < signif_frac_figs) {
-			if ((ret = ps->str_write(buf_frac, signif_frac_figs, ps->data)) < 0)
-				return -1;
-
-			counter += ret;
-		}
+		if (0 < signif_frac_figs)
+			field_write(&field, buf_frac, signif_frac_figs);
 
 		/* Print trailing zeros of the fractional part of the number. */
-		if ((ret = print_padding('0', trailing_frac_zeros, ps)) < 0)
-			return -1;
-
-		counter += ret;
+		field_pad(&field, '0', trailing_frac_zeros);
 	}
 
 	/* Trailing padding. */
-	if (flags & __PRINTF_FLAG_LEFTALIGNED) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
-			return -1;
-
-		counter += ret;
-	}
+	if (flags & __PRINTF_FLAG_LEFTALIGNED)
+		field_pad(&field, ' ', padding_len);
 
-	return counter;
+	return field_finish(&field);
 }
 
 /** Convert, format and print a double according to the %f specifier.
@@ -884,24 +993,10 @@ static int print_double_fixed(double g, int precision, int width, uint32_t flags
 }
 
 /** Prints the decimal exponent part of a %e specifier formatted number. */
-static int print_exponent(int exp_val, uint32_t flags, printf_spec_t *ps)
+static void print_exponent(int exp_val, uint32_t flags, printf_field_t *field)
 {
-	int counter = 0;
-	int ret;
-
-	char exp_ch = (flags & __PRINTF_FLAG_BIGCHARS) ? 'E' : 'e';
-
-	if ((ret = ps->str_write(&exp_ch, 1, ps->data)) < 0)
-		return -1;
-
-	counter += ret;
-
-	char exp_sign = (exp_val < 0) ? '-' : '+';
-
-	if ((ret = ps->str_write(&exp_sign, 1, ps->data)) < 0)
-		return -1;
-
-	counter += ret;
+	field_putchar(field, (flags & __PRINTF_FLAG_BIGCHARS) ? 'E' : 'e');
+	field_putchar(field, (exp_val < 0) ? '-' : '+');
 
 	/* Print the exponent. */
 	exp_val = abs(exp_val);
@@ -915,12 +1010,7 @@ static int print_exponent(int exp_val, uint32_t flags, printf_spec_t *ps)
 	int exp_len = (exp_str[0] == '0') ? 2 : 3;
 	const char *exp_str_start = &exp_str[3] - exp_len;
 
-	if ((ret = ps->str_write(exp_str_start, exp_len, ps->data)) < 0)
-		return -1;
-
-	counter += ret;
-
-	return counter;
+	field_write(field, exp_str_start, exp_len);
 }
 
 /** Format and print the double string repressentation according
@@ -957,74 +1047,41 @@ static int print_double_str_scient(double_str_t *val_str, int precision,
 	int num_len = (sign ? 1 : 0) + 1 + dec_pt_len + frac_len + exp_len;
 
 	int padding_len = max(0, width - num_len);
-	int ret = 0;
-	int counter = 0;
 
-	if (!(flags & (__PRINTF_FLAG_LEFTALIGNED | __PRINTF_FLAG_ZEROPADDED))) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
-			return -1;
+	printf_field_t field;
+	field_init(&field, ps);
 
-		counter += ret;
-	}
+	if (!(flags & (__PRINTF_FLAG_LEFTALIGNED | __PRINTF_FLAG_ZEROPADDED)))
+		field_pad(&field, ' ', padding_len);
 
-	if (sign) {
-		if ((ret = ps->str_write(&sign, 1, ps->data)) < 0)
-			return -1;
+	if (sign)
+		field_putchar(&field, sign);
 
-		counter += ret;
-	}
-
-	if (flags & __PRINTF_FLAG_ZEROPADDED) {
-		if ((ret = print_padding('0', padding_len, ps)) < 0)
-			return -1;
-
-		counter += ret;
-	}
+	if (flags & __PRINTF_FLAG_ZEROPADDED)
+		field_pad(&field, '0', padding_len);
 
 	/* Single leading integer. */
-	if ((ret = ps->str_write(buf, 1, ps->data)) < 0)
-		return -1;
-
-	counter += ret;
+	field_write(&field, buf, 1);
 
 	/* Print the decimal point and the fractional part. */
 	if (has_decimal_pt) {
-		char ch = '.';
-
-		if ((ret = ps->str_write(&ch, 1, ps->data)) < 0)
-			return -1;
-
-		counter += ret;
+		field_putchar(&field, '.');
 
 		/* Print significant digits of the fractional part of the number. */
-		if (0 < signif_frac_figs) {
-			if ((ret = ps->str_write(buf + 1, signif_frac_figs, ps->data)) < 0)
-				return -1;
-
-			counter += ret;
-		}
+		if (0 < signif_frac_figs)
+			field_write(&field, buf + 1, signif_frac_figs);
 
 		/* Print trailing zeros of the fractional part of the number. */
-		if ((ret = print_padding('0', trailing_frac_zeros, ps)) < 0)
-			return -1;
-
-		counter += ret;
+		field_pad(&field, '0', trailing_frac_zeros);
 	}
 
 	/* Print the exponent. */
-	if ((ret = print_exponent(exp_val, flags, ps)) < 0)
-		return -1;
-
-	counter += ret;
+	print_exponent(exp_val, flags, &field);
 
-	if (flags & __PRINTF_FLAG_LEFTALIGNED) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
-			return -1;
-
-		counter += ret;
-	}
+	if (flags & __PRINTF_FLAG_LEFTALIGNED)
+		field_pad(&field, ' ', padding_len);
 
-	return counter;
+	return field_finish(&field);
 }
 
 /** Convert, format and print a double according to the %e specifier.
@@ -1180,6 +1237,23 @@ static int print_double_generic(double g, int precision, int width,
 	}
 }
 
+/** Fetch the next character of a conversion specification.
+ *
+ * The conversion specifications consist of ASCII characters only. Any
+ * other byte ends the specification as an unknown conversion and the
+ * whole sequence is then printed verbatim. The terminating null character
+ * is never consumed.
+ */
+static inline wchar_t printf_fetch(const char *fmt, size_t *nxt)
+{
+	uint8_t ch = fmt[*nxt];
+
+	if (ch != 0)
+		(*nxt)++;
+
+	return ch;
+}
+
 /** Convert, format and print a double according to the specifier.
  *
  * Depending on the specifier it prints the double using the styles
@@ -1328,8 +1402,16 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 	int retval;           /* Return values from nested functions */
 
 	while (true) {
+		/*
+		 * Ordinary characters are printed verbatim, so they can be
+		 * skipped byte by byte. A '%' byte is never part of a
+		 * multibyte character.
+		 */
+		while ((fmt[nxt] != '%') && (fmt[nxt] != 0))
+			nxt++;
+
 		i = nxt;
-		wchar_t uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+		wchar_t uc = printf_fetch(fmt, &nxt);
 
 		if (uc == 0)
 			break;
@@ -1354,7 +1436,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 
 			do {
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_fetch(fmt, &nxt);
 				switch (uc) {
 				case '#':
 					flags |= __PRINTF_FLAG_PREFIX;
@@ -1385,7 +1467,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 					width += uc - '0';
 
 					i = nxt;
-					uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+					uc = printf_fetch(fmt, &nxt);
 					if (uc == 0)
 						break;
 					if (!isdigit(uc))
@@ -1394,7 +1476,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 			} else if (uc == '*') {
 				/* Get width value from argument list */
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_fetch(fmt, &nxt);
 				width = (int) va_arg(ap, int);
 				if (width < 0) {
 					/* Negative width sets '-' flag */
@@ -1407,7 +1489,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 			int precision = -1;
 			if (uc == '.') {
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_fetch(fmt, &nxt);
 				if (isdigit(uc)) {
 					precision = 0;
 					while (true) {
@@ -1415,7 +1497,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 						precision += uc - '0';
 
 						i = nxt;
-						uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+						uc = printf_fetch(fmt, &nxt);
 						if (uc == 0)
 							break;
 						if (!isdigit(uc))
@@ -1424,7 +1506,7 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				} else if (uc == '*') {
 					/* Get precision value from the argument list */
 					i = nxt;
-					uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+					uc = printf_fetch(fmt, &nxt);
 					precision = (int) va_arg(ap, int);
 					if (precision < 0) {
 						/* Ignore negative precision - use default instead */
@@ -1443,16 +1525,16 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				else
 					qualifier = PrintfQualifierLongLong;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_fetch(fmt, &nxt);
 				break;
 			case 'h':
 				/* Char or short */
 				qualifier = PrintfQualifierShort;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_fetch(fmt, &nxt);
 				if (uc == 'h') {
 					i = nxt;
-					uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+					uc = printf_fetch(fmt, &nxt);
 					qualifier = PrintfQualifierByte;
 				}
 				break;
@@ -1460,22 +1542,22 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				/* Long or long long */
 				qualifier = PrintfQualifierLong;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_fetch(fmt, &nxt);
 				if (uc == 'l') {
 					i = nxt;
-					uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+					uc = printf_fetch(fmt, &nxt);
 					qualifier = PrintfQualifierLongLong;
 				}
 				break;
 			case 'z':
 				qualifier = PrintfQualifierSize;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_fetch(fmt, &nxt);
 				break;
 			case 'j':
 				qualifier = PrintfQualifierMax;
 				i = nxt;
-				uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
+				uc = printf_fetch(fmt, &nxt);
 				break;
 			default:
 				/* Default type */
@@ -38,22 +38,78 @@
 #include <fibril_synch.h>
 #include <async.h>
 #include <str.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdbool.h>
+
+/** Size of the buffer collecting output of vfprintf() */
+#define VPRINTF_BUFFER_SIZE  256
 
 static FIBRIL_MUTEX_INITIALIZE(printf_mutex);
 
-static int vprintf_str_write(const char *str, size_t size, void *stream)
+/** Output of vfprintf() not yet passed to the stream.
+ *
+ * printf_core() produces its output in many small pieces. Collecting
+ * them before calling fwrite() avoids going through the stream
+ * machinery for each of them.
+ */
+typedef struct {
+	FILE *stream;
+	/** Writing to the stream has failed */
+	bool error;
+	/** Number of bytes used in buf */
+	size_t len;
+	char buf[VPRINTF_BUFFER_SIZE];
+} vprintf_data_t;
+
+static void vprintf_flush(vprintf_data_t *data)
+{
+	if ((data->len > 0) && (!data->error)) {
+		if (fwrite(data->buf, 1, data->len, data->stream) < data->len)
+			data->error = true;
+	}
+
+	data->len = 0;
+}
+
+static int vprintf_str_write(const char *str, size_t size, void *arg)
 {
-	size_t wr = fwrite(str, 1, size, (FILE *) stream);
-	return str_nlength(str, wr);
+	vprintf_data_t *data = (vprintf_data_t *) arg;
+
+	if (size > VPRINTF_BUFFER_SIZE - data->len)
+		vprintf_flush(data);
+
+	if (data->error)
+		return -1;
+
+	if (size > VPRINTF_BUFFER_SIZE) {
+		size_t wr = fwrite(str, 1, size, data->stream);
+		if (wr < size)
+			data->error = true;
+
+		return str_nlength(str, wr);
+	}
+
+	memcpy(data->buf + data->len, str, size);
+	data->len += size;
+	return str_nlength(str, size);
 }
 
-static int vprintf_wstr_write(const wchar_t *str, size_t size, void *stream)
+static int vprintf_wstr_write(const wchar_t *str, size_t size, void *arg)
 {
+	vprintf_data_t *data = (vprintf_data_t *) arg;
 	size_t offset = 0;
 	size_t chars = 0;
 
 	while (offset < size) {
-		if (fputwc(str[chars], (FILE *) stream) <= 0)
+		if (VPRINTF_BUFFER_SIZE - data->len < STR_BOUNDS(1))
+			vprintf_flush(data);
+
+		if (data->error)
+			break;
+
+		if (chr_encode(str[chars], data->buf, &data->len,
+		    VPRINTF_BUFFER_SIZE) != EOK)
 			break;
 
 		chars++;
@@ -74,21 +130,30 @@ static int vprintf_wstr_write(const wchar_t *str, size_t size, void *stream)
  */
 int vfprintf(FILE *stream, const char *fmt, va_list ap)
 {
+	vprintf_data_t data;
 	printf_spec_t ps = {
 		vprintf_str_write,
 		vprintf_wstr_write,
-		stream
+		&data
 	};
 
+	data.stream = stream;
+	data.error = false;
+	data.len = 0;
+
 	/*
 	 * Prevent other threads to execute printf_core()
 	 */
 	fibril_mutex_lock(&printf_mutex);
 
 	int ret = printf_core(fmt, &ps, ap);
+	vprintf_flush(&data);
 
 	fibril_mutex_unlock(&printf_mutex);
 
+	if (data.error)
+		return EOF;
+
 	return ret;
 }
 
@@ -34,11 +34,19 @@
 
 #include <errno.h>
 #include <as.h>
+#include <async_ring.h>
 #include <ipc/window.h>
 #include <io/window.h>
+#include <stdlib.h>
 
 #include <stdio.h>
 
+/** Window event ring, the receiving end */
+struct win_events {
+	/** Ring set up by the compositor */
+	async_ring_t *ring;
+};
+
 errno_t win_register(async_sess_t *sess, window_flags_t flags, service_id_t *in,
     service_id_t *out)
 {
@@ -72,6 +80,106 @@ errno_t win_get_event(async_sess_t *sess, window_event_t *event)
 	}
 }
 
+/** Compositor callback connection of a window event ring. */
+static void win_events_cb_conn(ipc_call_t *icall, void *arg)
+{
+	win_events_t *events = (win_events_t *) arg;
+
+	while (true) {
+		ipc_call_t call;
+		async_get_call(&call);
+
+		if (!ipc_get_imethod(&call)) {
+			async_answer_0(&call, EOK);
+			break;
+		}
+
+		switch (ipc_get_imethod(&call)) {
+		case WINDOW_EVENT_RING:
+			(void) async_ring_handle(&call, &events->ring);
+			break;
+		default:
+			async_answer_0(&call, ENOTSUP);
+		}
+	}
+}
+
+/** Set up a shared-memory ring for receiving window events.
+ *
+ * The compositor then queues events to the ring instead of waiting for
+ * WINDOW_GET_EVENT requests and only notifies us if we have drained
+ * the ring and wait for more. The ring lives as long as the window.
+ *
+ * @param sess Input session of the window
+ * @param revents Place to store pointer to the event ring
+ * @return EOK on success or an error code
+ */
+errno_t win_events_open(async_sess_t *sess, win_events_t **revents)
+{
+	win_events_t *events = calloc(1, sizeof(win_events_t));
+	if (events == NULL)
+		return ENOMEM;
+
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	port_id_t port;
+	errno_t rc = async_create_callback_port(exch, INTERFACE_COMPOSITOR_CB,
+	    0, 0, win_events_cb_conn, events, &port);
+	if (rc != EOK) {
+		async_exchange_end(exch);
+		free(events);
+		return rc;
+	}
+
+	/* The compositor sets up the ring before answering */
+	rc = async_req_0_0(exch, WINDOW_EVENT_RING);
+	async_exchange_end(exch);
+
+	/* On failure, events stay referenced by the callback connection */
+	if (rc != EOK)
+		return rc;
+
+	if (events->ring == NULL)
+		return EIO;
+
+	*revents = events;
+	return EOK;
+}
+
+/** Read window events from the event ring.
+ *
+ * Wait for at least one event, then take as many events as are
+ * available, up to @a count.
+ *
+ * @param events Window event ring
+ * @param event Array of @a count events to fill in
+ * @param count Number of events to read at most
+ * @param nread Place to store the number of events read
+ * @return EOK on success or an error code
+ */
+errno_t win_events_read(win_events_t *events, window_event_t *event,
+    size_t count, size_t *nread)
+{
+	size_t size;
+	size_t n;
+	errno_t rc;
+
+	rc = async_ring_read_wait(events->ring, &event[0],
+	    sizeof(window_event_t), &size);
+	if (rc != EOK)
+		return rc;
+
+	for (n = 1; n < count; n++) {
+		rc = async_ring_read(events->ring, &event[n],
+		    sizeof(window_event_t), &size);
+		if (rc != EOK)
+			break;
+	}
+
+	*nread = n;
+	return EOK;
+}
+
 errno_t win_damage(async_sess_t *sess,
     sysarg_t x, sysarg_t y, sysarg_t width, sysarg_t height)
 {
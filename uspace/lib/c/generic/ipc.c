@@ -176,6 +176,28 @@ errno_t ipc_wait(ipc_call_t *call, sysarg_t usec, unsigned int flags)
 	return __SYSCALL3(SYS_IPC_WAIT, (sysarg_t) call, usec, flags);
 }
 
+/** Wait for IPC calls and receive as many pending ones as fit.
+ *
+ * Like ipc_wait(), but after the first call or answer arrives, all calls
+ * and answers that are already pending are received as well, up to
+ * @a count of them, in a single system call.
+ *
+ * @param calls    Array of @a count call structures to fill in.
+ * @param count    Number of entries in @a calls.
+ * @param usec     Timeout for the first call.
+ * @param flags    Flags for the wait for the first call.
+ * @param received Place to store the number of received calls.
+ *
+ * @return EOK on success or an error code as ipc_wait().
+ *
+ */
+errno_t ipc_wait_batch(ipc_call_t *calls, size_t count, sysarg_t usec,
+    unsigned int flags, size_t *received)
+{
+	return __SYSCALL5(SYS_IPC_WAIT_BATCH, (sysarg_t) calls, count, usec,
+	    flags, (sysarg_t) received);
+}
+
 /** Hang up a phone.
  *
  * @param phandle  Handle of the phone to be hung up.
@@ -41,6 +41,8 @@
 #include <stdlib.h>
 #include <ipc_test.h>
 
+static void ipc_test_cb_conn(ipc_call_t *, void *);
+
 /** Create IPC test service session.
  *
  * @param rvol Place to store pointer to volume service session.
@@ -59,6 +61,9 @@ errno_t ipc_test_create(ipc_test_t **rtest)
 		goto error;
 	}
 
+	fibril_mutex_initialize(&test->lock);
+	fibril_condvar_initialize(&test->cv);
+
 	rc = loc_service_get_id(SERVICE_NAME_IPC_TEST, &test_svcid, 0);
 	if (rc != EOK) {
 		rc = ENOENT;
@@ -220,5 +225,227 @@ errno_t ipc_test_share_in_rw(ipc_test_t *test, size_t size, void **rptr)
 	return EOK;
 }
 
+/** Set up a shared-memory ring to the IPC test service.
+ *
+ * The service reads and discards all messages written to the ring.
+ *
+ * @param test IPC test service
+ * @param size Capacity of the ring in bytes
+ * @param rring Place to store pointer to the new ring
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_ring_create(ipc_test_t *test, size_t size,
+    async_ring_t **rring)
+{
+	return async_ring_create(test->sess, IPC_TEST_RING, size, rring);
+}
+
+/** Write data to the IPC test service.
+ *
+ * The service receives the data and discards them.
+ *
+ * @param test IPC test service
+ * @param data Data to write
+ * @param size Size of the data, at most DATA_XFER_LIMIT bytes
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_data_write(ipc_test_t *test, const void *data, size_t size)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+	aid_t req;
+	errno_t rc;
+
+	exch = async_exchange_begin(test->sess);
+	req = async_send_0(exch, IPC_TEST_DATA_WRITE, &answer);
+	rc = async_data_write_start(exch, data, size);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Read data from the IPC test service.
+ *
+ * @param test IPC test service
+ * @param buf Buffer for the data
+ * @param size Size of the data, at most DATA_XFER_LIMIT bytes
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_data_read(ipc_test_t *test, void *buf, size_t size)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+	aid_t req;
+	errno_t rc;
+
+	exch = async_exchange_begin(test->sess);
+	req = async_send_0(exch, IPC_TEST_DATA_READ, &answer);
+	rc = async_data_read_start(exch, buf, size);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Share an address space area with the IPC test service.
+ *
+ * The service maps the area read-only and unmaps it again before
+ * answering.
+ *
+ * @param test IPC test service
+ * @param area Start of the area to share
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_share_out(ipc_test_t *test, void *area)
+{
+	async_exch_t *exch;
+	ipc_call_t answer;
+	aid_t req;
+	errno_t rc;
+
+	exch = async_exchange_begin(test->sess);
+	req = async_send_0(exch, IPC_TEST_SHARE_OUT, &answer);
+	rc = async_share_out_start(exch, area, AS_AREA_READ);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Ping the IPC test service through a forwarded call.
+ *
+ * The service forwards the call to a connection of its own and answers
+ * it there, as servers like VFS or the location service do.
+ *
+ * @param test IPC test service
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_forward_ping(ipc_test_t *test)
+{
+	async_exch_t *exch;
+	errno_t retval;
+
+	exch = async_exchange_begin(test->sess);
+	retval = async_req_0_0(exch, IPC_TEST_FORWARD);
+	async_exchange_end(exch);
+
+	return retval;
+}
+
+/** Create a callback connection from the IPC test service.
+ *
+ * Needed by ipc_test_notify().
+ *
+ * @param test IPC test service
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_callback_create(ipc_test_t *test)
+{
+	async_exch_t *exch = async_exchange_begin(test->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, IPC_TEST_CALLBACK_CREATE, &answer);
+
+	port_id_t port;
+	errno_t rc = async_create_callback_port(exch, INTERFACE_IPC_TEST_CB, 0,
+	    0, ipc_test_cb_conn, test, &port);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Have the IPC test service send notifications through the callback port.
+ *
+ * Returns after all the notifications have been received.
+ *
+ * @param test IPC test service
+ * @param count Number of notifications, at most IPC_TEST_NOTIFY_MAX
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_notify(ipc_test_t *test, unsigned int count)
+{
+	async_exch_t *exch;
+	errno_t retval;
+
+	fibril_mutex_lock(&test->lock);
+	uint64_t target = test->notifications + count;
+	fibril_mutex_unlock(&test->lock);
+
+	exch = async_exchange_begin(test->sess);
+	retval = async_req_1_0(exch, IPC_TEST_NOTIFY, count);
+	async_exchange_end(exch);
+
+	if (retval != EOK)
+		return retval;
+
+	/* The notifications travel over another connection */
+	fibril_mutex_lock(&test->lock);
+	while (test->notifications < target)
+		fibril_condvar_wait(&test->cv, &test->lock);
+	fibril_mutex_unlock(&test->lock);
+
+	return EOK;
+}
+
+/** Connection from the IPC test service to the callback port.
+ *
+ * @param icall Connect call
+ * @param arg IPC test service
+ */
+static void ipc_test_cb_conn(ipc_call_t *icall, void *arg)
+{
+	ipc_test_t *test = arg;
+
+	while (true) {
+		ipc_call_t call;
+		async_get_call(&call);
+
+		if (!ipc_get_imethod(&call)) {
+			async_answer_0(&call, EOK);
+			return;
+		}
+
+		switch (ipc_get_imethod(&call)) {
+		case IPC_TEST_EV_NOTIFY:
+			fibril_mutex_lock(&test->lock);
+			test->notifications++;
+			fibril_condvar_broadcast(&test->cv);
+			fibril_mutex_unlock(&test->lock);
+			async_answer_0(&call, EOK);
+			break;
+		default:
+			async_answer_0(&call, ENOTSUP);
+			break;
+		}
+	}
+}
+
 /** @}
  */
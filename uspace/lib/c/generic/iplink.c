@@ -42,6 +42,7 @@
 #include <ipc/iplink.h>
 #include <ipc/services.h>
 #include <loc.h>
+#include <mem.h>
 #include <stdlib.h>
 
 static void iplink_cb_conn(ipc_call_t *icall, void *arg);
@@ -261,6 +262,47 @@ static void iplink_ev_recv(iplink_t *iplink, ipc_call_t *icall)
 	async_answer_0(icall, rc);
 }
 
+static void iplink_ev_recv_list(iplink_t *iplink, ipc_call_t *icall)
+{
+	iplink_recv_hdr_t hdr;
+	iplink_recv_sdu_t sdu;
+	uint8_t *data;
+	size_t size;
+	size_t off;
+
+	errno_t rc = async_data_write_accept((void **) &data, false, 0,
+	    DATA_XFER_LIMIT, 0, &size);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	if (iplink->ev_ops->recv_begin != NULL)
+		iplink->ev_ops->recv_begin(iplink);
+
+	off = 0;
+	while (size - off >= sizeof(hdr)) {
+		memcpy(&hdr, data + off, sizeof(hdr));
+		off += sizeof(hdr);
+
+		if (hdr.size > size - off) {
+			rc = EINVAL;
+			break;
+		}
+
+		sdu.data = data + off;
+		sdu.size = hdr.size;
+		(void) iplink->ev_ops->recv(iplink, &sdu, hdr.ver);
+		off += hdr.size;
+	}
+
+	if (iplink->ev_ops->recv_end != NULL)
+		iplink->ev_ops->recv_end(iplink);
+
+	free(data);
+	async_answer_0(icall, rc);
+}
+
 static void iplink_ev_change_addr(iplink_t *iplink, ipc_call_t *icall)
 {
 	addr48_t *addr;
@@ -298,6 +340,9 @@ static void iplink_cb_conn(ipc_call_t *icall, void *arg)
 		case IPLINK_EV_CHANGE_ADDR:
 			iplink_ev_change_addr(iplink, &call);
 			break;
+		case IPLINK_EV_RECV_LIST:
+			iplink_ev_recv_list(iplink, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 		}
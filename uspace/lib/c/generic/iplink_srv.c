@@ -38,6 +38,7 @@
 #include <ipc/iplink.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <mem.h>
 #include <inet/addr.h>
 #include <inet/iplink_srv.h>
 
@@ -219,6 +220,9 @@ void iplink_srv_init(iplink_srv_t *srv)
 	srv->ops = NULL;
 	srv->arg = NULL;
 	srv->client_sess = NULL;
+	srv->rbatch = NULL;
+	srv->rbatch_size = 0;
+	srv->rbatch_count = 0;
 }
 
 errno_t iplink_conn(ipc_call_t *icall, void *arg)
@@ -294,11 +298,9 @@ errno_t iplink_conn(ipc_call_t *icall, void *arg)
 }
 
 /* XXX Version should be part of @a sdu */
-errno_t iplink_ev_recv(iplink_srv_t *srv, iplink_recv_sdu_t *sdu, ip_ver_t ver)
+static errno_t iplink_ev_recv_send(iplink_srv_t *srv, iplink_recv_sdu_t *sdu,
+    ip_ver_t ver)
 {
-	if (srv->client_sess == NULL)
-		return EIO;
-
 	async_exch_t *exch = async_exchange_begin(srv->client_sess);
 
 	ipc_call_t answer;
@@ -321,6 +323,135 @@ errno_t iplink_ev_recv(iplink_srv_t *srv, iplink_recv_sdu_t *sdu, ip_ver_t ver)
 	return EOK;
 }
 
+/** Send the batched datagrams to the client. */
+static errno_t iplink_ev_recv_flush(iplink_srv_t *srv)
+{
+	iplink_recv_hdr_t hdr;
+	iplink_recv_sdu_t sdu;
+	size_t size = srv->rbatch_size;
+	size_t count = srv->rbatch_count;
+	errno_t rc;
+
+	srv->rbatch_size = 0;
+	srv->rbatch_count = 0;
+
+	if (count == 0)
+		return EOK;
+
+	if (count == 1) {
+		memcpy(&hdr, srv->rbatch, sizeof(hdr));
+		sdu.data = srv->rbatch + sizeof(hdr);
+		sdu.size = hdr.size;
+		return iplink_ev_recv_send(srv, &sdu, hdr.ver);
+	}
+
+	async_exch_t *exch = async_exchange_begin(srv->client_sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, IPLINK_EV_RECV_LIST, &answer);
+
+	rc = async_data_write_start(exch, srv->rbatch, size);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Pass a received datagram to the client.
+ *
+ * Between iplink_ev_recv_begin() and iplink_ev_recv_end() the datagram
+ * is only queued so that the whole batch reaches the client in one
+ * message.
+ *
+ * @param srv IP link server
+ * @param sdu Received datagram
+ * @param ver IP version
+ * @return EOK on success or an error code
+ */
+errno_t iplink_ev_recv(iplink_srv_t *srv, iplink_recv_sdu_t *sdu, ip_ver_t ver)
+{
+	size_t rsize = sizeof(iplink_recv_hdr_t) + sdu->size;
+	iplink_recv_hdr_t hdr;
+	errno_t rc;
+
+	if (srv->client_sess == NULL)
+		return EIO;
+
+	if (srv->rbatch == NULL || rsize > DATA_XFER_LIMIT) {
+		/* Keep the order of datagrams */
+		if (srv->rbatch != NULL) {
+			rc = iplink_ev_recv_flush(srv);
+			if (rc != EOK)
+				return rc;
+		}
+
+		return iplink_ev_recv_send(srv, sdu, ver);
+	}
+
+	if (srv->rbatch_size + rsize > DATA_XFER_LIMIT) {
+		rc = iplink_ev_recv_flush(srv);
+		if (rc != EOK)
+			return rc;
+	}
+
+	hdr.ver = ver;
+	hdr.size = sdu->size;
+	memcpy(srv->rbatch + srv->rbatch_size, &hdr, sizeof(hdr));
+	memcpy(srv->rbatch + srv->rbatch_size + sizeof(hdr), sdu->data,
+	    sdu->size);
+	srv->rbatch_size += rsize;
+	srv->rbatch_count++;
+
+	return EOK;
+}
+
+/** Start batching received datagrams.
+ *
+ * Typically called before processing frames received from the hardware
+ * at once. If memory for the batch cannot be allocated, datagrams are
+ * passed to the client one by one. Until iplink_ev_recv_end(), only
+ * the calling fibril may pass datagrams to the client.
+ *
+ * @param srv IP link server
+ */
+void iplink_ev_recv_begin(iplink_srv_t *srv)
+{
+	if (srv->rbatch != NULL)
+		return;
+
+	srv->rbatch = malloc(DATA_XFER_LIMIT);
+	srv->rbatch_size = 0;
+	srv->rbatch_count = 0;
+}
+
+/** Send the batched datagrams to the client and stop batching.
+ *
+ * @param srv IP link server
+ * @return EOK on success or an error code
+ */
+errno_t iplink_ev_recv_end(iplink_srv_t *srv)
+{
+	errno_t rc = EOK;
+
+	if (srv->rbatch == NULL)
+		return EOK;
+
+	if (srv->client_sess != NULL)
+		rc = iplink_ev_recv_flush(srv);
+
+	free(srv->rbatch);
+	srv->rbatch = NULL;
+	srv->rbatch_size = 0;
+	srv->rbatch_count = 0;
+	return rc;
+}
+
 errno_t iplink_ev_change_addr(iplink_srv_t *srv, addr48_t *addr)
 {
 	if (srv->client_sess == NULL)
@@ -85,5 +85,39 @@ errno_t ipc_irq_unsubscribe(cap_irq_handle_t cap)
 	    cap_handle_raw(cap));
 }
 
+/** Set IRQ notification flags.
+ *
+ * With IRQ_NOTIF_COALESCE, interrupts that arrive before the previous
+ * notification has been received are merged into it.
+ *
+ * @param cap   IRQ capability handle.
+ * @param flags IRQ_NOTIF_* flags.
+ *
+ * @return Error code returned by the kernel.
+ *
+ */
+errno_t ipc_irq_set_flags(cap_irq_handle_t cap, unsigned int flags)
+{
+	return (errno_t) __SYSCALL2(SYS_IPC_IRQ_SET_FLAGS,
+	    cap_handle_raw(cap), flags);
+}
+
+/** Deliver IRQ notifications to a processor.
+ *
+ * The IRQ is routed to the processor and the calling thread, which is
+ * expected to handle the notifications, is wired to it.
+ *
+ * @param cap IRQ capability handle.
+ * @param cpu Processor ID or IRQ_CPU_ANY to remove the affinity.
+ *
+ * @return Error code returned by the kernel.
+ *
+ */
+errno_t ipc_irq_set_cpu(cap_irq_handle_t cap, unsigned int cpu)
+{
+	return (errno_t) __SYSCALL2(SYS_IPC_IRQ_SET_CPU,
+	    cap_handle_raw(cap), cpu);
+}
+
 /** @}
  */
@@ -48,8 +48,11 @@
 #include "private/libc.h"
 #include "private/async.h"
 #include "private/malloc.h"
+#include "private/mem.h"
+#include "private/checksum.h"
 #include "private/io.h"
 #include "private/fibril.h"
+#include "private/thread.h"
 
 #ifdef CONFIG_RTLD
 #include <rtld/rtld.h>
@@ -59,9 +62,12 @@ progsymbols_t __progsymbols;
 
 static bool env_setup;
 static fibril_t main_fibril;
+static fibril_rcu_thread_t main_rcu_thread;
 
 void __libc_main(void *pcb_ptr)
 {
+	__mem_init();
+	__crc32c_init();
 	__kio_init();
 
 	assert(!__tcb_is_set());
@@ -89,7 +95,10 @@ void __libc_main(void *pcb_ptr)
 	/* Initialize the fibril. */
 	main_fibril.tcb->fibril_data = &main_fibril;
 	__tcb_set(main_fibril.tcb);
+	main_fibril.tid = (sysarg_t) thread_get_id();
 	fibril_setup(&main_fibril);
+	fibril_rcu_thread_register(&main_rcu_thread);
+	main_fibril.rcu_thread = &main_rcu_thread;
 
 	/* Initialize user task run-time environment */
 	__malloc_init();
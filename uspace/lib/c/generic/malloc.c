@@ -1,6 +1,7 @@
 /*
  * Copyright (c) 2009 Martin Decky
  * Copyright (c) 2009 Petr Tuma
+ * Copyright (c) 2026 HelenOS Project
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -31,11 +32,24 @@
  * @{
  */
 /** @file
+ *
+ * Size-class heap allocator.
+ *
+ * Small requests (up to SMALL_MAX bytes) are rounded up to one of the
+ * size classes and served from runs. A run is a dedicated address space
+ * area carved into equally sized slots of a single class. Runs are owned
+ * by arenas, each protected by its own lock, so that fibrils running on
+ * different threads rarely contend for the same lock. Large requests
+ * get an address space area of their own.
+ *
+ * Every block is preceded by a heap_block_head_t header which identifies
+ * the run or the large area the block belongs to.
  */
 
 #include <malloc.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <as.h>
 #include <align.h>
 #include <macros.h>
@@ -44,723 +58,549 @@
 #include <bitops.h>
 #include <mem.h>
 #include <stdlib.h>
-#include <adt/gcdlcm.h>
+#include <fibril.h>
+#include <adt/list.h>
 
 #include "private/malloc.h"
 #include "private/fibril.h"
 
-/** Magic used in heap headers. */
-#define HEAP_BLOCK_HEAD_MAGIC  UINT32_C(0xBEEF0101)
+/** Magic used in headers of allocated blocks. */
+#define HEAP_BLOCK_USED_MAGIC  UINT32_C(0xBEEF0101)
+
+/** Magic used in headers of free blocks. */
+#define HEAP_BLOCK_FREE_MAGIC  UINT32_C(0xBEEF0202)
 
-/** Magic used in heap footers. */
-#define HEAP_BLOCK_FOOT_MAGIC  UINT32_C(0xBEEF0202)
+/** Magic used in run descriptors. */
+#define HEAP_RUN_MAGIC  UINT32_C(0xBEEFCAFE)
 
-/** Magic used in heap descriptor. */
-#define HEAP_AREA_MAGIC  UINT32_C(0xBEEFCAFE)
+/** Magic used in large block descriptors. */
+#define HEAP_LARGE_MAGIC  UINT32_C(0xBEEFF00D)
 
 /** Allocation alignment.
  *
  * This also covers the alignment of fields
- * in the heap header and footer.
+ * in the block header.
  *
  */
 #define BASE_ALIGN  16
 
-/** Heap shrink granularity
- *
- * Try not to pump and stress the heap too much
- * by shrinking and enlarging it too often.
- * A heap area won't shrink if the released
- * free block is smaller than this constant.
- *
- */
-#define SHRINK_GRANULARITY  (64 * PAGE_SIZE)
+/** Size of a run of small blocks. */
+#define RUN_SIZE  (16 * PAGE_SIZE)
 
-/** Overhead of each heap block. */
-#define STRUCT_OVERHEAD \
-	(sizeof(heap_block_head_t) + sizeof(heap_block_foot_t))
+/** Number of independently locked arenas. */
+#define HEAP_ARENAS  8
 
-/** Overhead of each area. */
-#define AREA_OVERHEAD(size) \
-	(ALIGN_UP(size + sizeof(heap_area_t), BASE_ALIGN))
+/** Largest block size served from runs. */
+#define SMALL_MAX  4096
 
-/** Calculate real size of a heap block.
- *
- * Add header and footer size.
- *
- */
-#define GROSS_SIZE(size)  ((size) + STRUCT_OVERHEAD)
+/** Number of small size classes. */
+#define CLASS_COUNT  28
 
-/** Calculate net size of a heap block.
- *
- * Subtract header and footer size.
- *
- */
-#define NET_SIZE(size)  ((size) - STRUCT_OVERHEAD)
+/** Class number used in headers of large blocks. */
+#define CLASS_LARGE  UINT16_MAX
 
-/** Get first block in heap area.
- *
- */
-#define AREA_FIRST_BLOCK_HEAD(area) \
-	(ALIGN_UP(((uintptr_t) (area)) + sizeof(heap_area_t), BASE_ALIGN))
+/** Size of the block header including padding. */
+#define HEAD_SIZE  ((size_t) ALIGN_UP(sizeof(heap_block_head_t), BASE_ALIGN))
 
-/** Get last block in heap area.
- *
- */
-#define AREA_LAST_BLOCK_FOOT(area) \
-	(((uintptr_t) (area)->end) - sizeof(heap_block_foot_t))
+/** Get first slot in a run. */
+#define RUN_FIRST_SLOT(run) \
+	((void *) ALIGN_UP(((uintptr_t) (run)) + sizeof(heap_run_t), BASE_ALIGN))
 
-#define AREA_LAST_BLOCK_HEAD(area) \
-	((uintptr_t) BLOCK_HEAD(((heap_block_foot_t *) AREA_LAST_BLOCK_FOOT(area))))
+/** Get slot with the given index in a run. */
+#define RUN_SLOT(run, idx) \
+	(RUN_FIRST_SLOT(run) + (idx) * (run)->slot_size)
 
-/** Get header in heap block.
+/** Header of a heap block
  *
- */
-#define BLOCK_HEAD(foot) \
-	((heap_block_head_t *) \
-	    (((uintptr_t) (foot)) + sizeof(heap_block_foot_t) - (foot)->size))
-
-/** Get footer in heap block.
+ * The header is placed immediately before the block payload.
  *
  */
-#define BLOCK_FOOT(head) \
-	((heap_block_foot_t *) \
-	    (((uintptr_t) (head)) + (head)->size - sizeof(heap_block_foot_t)))
+typedef struct {
+	/** Block magic (allocated or free) */
+	uint32_t magic;
 
-/** Heap area.
- *
- * The memory managed by the heap allocator is divided into
- * multiple discontinuous heaps. Each heap is represented
- * by a separate address space area which has this structure
- * at its very beginning.
- *
- */
-typedef struct heap_area {
-	/** Start of the heap area (including this structure)
+	/** Size class of the block or CLASS_LARGE */
+	uint16_t cls;
+
+	/** Distance of this header from the start of the slot
 	 *
-	 * Aligned on page boundary.
+	 * Non-zero only for blocks that had to be aligned
+	 * inside the slot by memalign().
 	 *
 	 */
-	void *start;
+	uint16_t offset;
 
-	/** End of the heap area (aligned on page boundary) */
-	void *end;
-
-	/** Previous heap area */
-	struct heap_area *prev;
+	/** Run or large block descriptor the block belongs to */
+	void *owner;
+} heap_block_head_t;
 
-	/** Next heap area */
-	struct heap_area *next;
+typedef struct heap_arena heap_arena_t;
 
-	/** A magic value */
+/** Run of small blocks of a single size class */
+typedef struct {
+	/** Run magic */
 	uint32_t magic;
-} heap_area_t;
 
-/** Header of a heap block
- *
- */
-typedef struct {
-	/* Size of the block (including header and footer) */
-	size_t size;
+	/** Size class of all slots in the run */
+	uint16_t cls;
 
-	/* Indication of a free block */
-	bool free;
+	/** Arena owning the run */
+	heap_arena_t *arena;
 
-	/** Heap area this block belongs to */
-	heap_area_t *area;
+	/** Link in the list of runs with free slots */
+	link_t partial_link;
 
-	/* A magic value to detect overwrite of heap header */
-	uint32_t magic;
-} heap_block_head_t;
+	/** Link in the list of all runs of the arena */
+	link_t runs_link;
+
+	/** Chain of released slots */
+	void *free_list;
+
+	/** Size of a slot including its header */
+	size_t slot_size;
+
+	/** Total number of slots */
+	size_t slots;
 
-/** Footer of a heap block
+	/** Number of slots that have ever been handed out */
+	size_t initialized;
+
+	/** Number of slots currently allocated */
+	size_t used;
+} heap_run_t;
+
+/** Large block descriptor
+ *
+ * Placed at the start of the address space area holding the block.
  *
  */
 typedef struct {
-	/* Size of the block (including header and footer) */
+	/** Large block magic */
+	uint32_t magic;
+
+	/** Size of the address space area */
 	size_t size;
 
-	/* A magic value to detect overwrite of heap footer */
-	uint32_t magic;
-} heap_block_foot_t;
+	/** Header of the block */
+	heap_block_head_t *head;
 
-/** First heap area */
-static heap_area_t *first_heap_area = NULL;
+	/** Link in the list of large blocks */
+	link_t link;
+} heap_large_t;
 
-/** Last heap area */
-static heap_area_t *last_heap_area = NULL;
+/** Heap arena */
+struct heap_arena {
+	/** Lock protecting the arena and all its runs */
+	fibril_rmutex_t lock;
 
-/** Next heap block to examine (next fit algorithm) */
-static heap_block_head_t *next_fit = NULL;
+	/** Runs with free slots, one list per size class */
+	list_t partial[CLASS_COUNT];
 
-/** Futex for thread-safe heap manipulation */
-static fibril_rmutex_t malloc_mutex;
+	/** All runs of the arena */
+	list_t runs;
+};
 
-#define malloc_assert(expr) safe_assert(expr)
+/** Sizes of the size classes */
+static const uint16_t class_size[CLASS_COUNT] = {
+	16, 32, 48, 64, 80, 96, 112, 128,
+	160, 192, 224, 256,
+	320, 384, 448, 512,
+	640, 768, 896, 1024,
+	1280, 1536, 1792, 2048,
+	2560, 3072, 3584, 4096
+};
 
-/** Serializes access to the heap from multiple threads. */
-static inline void heap_lock(void)
-{
-	fibril_rmutex_lock(&malloc_mutex);
-}
+/** Size class lookup indexed by size in BASE_ALIGN units */
+static uint8_t size_class[SMALL_MAX / BASE_ALIGN + 1];
 
-/** Serializes access to the heap from multiple threads. */
-static inline void heap_unlock(void)
-{
-	fibril_rmutex_unlock(&malloc_mutex);
-}
+static heap_arena_t arenas[HEAP_ARENAS];
+
+/** Large blocks */
+static LIST_INITIALIZE(large_blocks);
+
+/** Futex protecting the list of large blocks */
+static fibril_rmutex_t large_mutex;
 
-/** Initialize a heap block
+/** Indication of an initialized heap */
+static bool heap_initialized = false;
+
+
+#define malloc_assert(expr) safe_assert(expr)
+
+/** Lock an arena for allocation.
  *
- * Fill in the structures related to a heap block.
- * Should be called only inside the critical section.
+ * Prefer the arena used last time by the current fibril, but move on
+ * to the first arena which is not held by somebody else. Only if all
+ * arenas are busy, block on the preferred one.
  *
- * @param addr Address of the block.
- * @param size Size of the block including the header and the footer.
- * @param free Indication of a free block.
- * @param area Heap area the block belongs to.
+ * @return Locked arena.
  *
  */
-static void block_init(void *addr, size_t size, bool free, heap_area_t *area)
+static heap_arena_t *arena_lock(void)
 {
-	/* Calculate the position of the header and the footer */
-	heap_block_head_t *head = (heap_block_head_t *) addr;
+	/* Arena the current fibril allocated from last time */
+	tls_slot_t *arena_hint = __tls_slot(TLS_SLOT_MALLOC_ARENA);
+	unsigned int hint = arena_hint->uint % HEAP_ARENAS;
 
-	head->size = size;
-	head->free = free;
-	head->area = area;
-	head->magic = HEAP_BLOCK_HEAD_MAGIC;
+	for (unsigned int i = 0; i < HEAP_ARENAS; i++) {
+		unsigned int idx = (hint + i) % HEAP_ARENAS;
 
-	heap_block_foot_t *foot = BLOCK_FOOT(head);
+		if (fibril_rmutex_trylock(&arenas[idx].lock)) {
+			arena_hint->uint = idx;
+			return &arenas[idx];
+		}
+	}
 
-	foot->size = size;
-	foot->magic = HEAP_BLOCK_FOOT_MAGIC;
+	fibril_rmutex_lock(&arenas[hint].lock);
+	return &arenas[hint];
 }
 
-/** Check a heap block
- *
- * Verifies that the structures related to a heap block still contain
- * the magic constants. This helps detect heap corruption early on.
- * Should be called only inside the critical section.
+static inline void arena_unlock(heap_arena_t *arena)
+{
+	fibril_rmutex_unlock(&arena->lock);
+}
+
+/** Check a block header
  *
- * @param addr Address of the block.
+ * @param head Header of an allocated block.
  *
  */
-static void block_check(void *addr)
+static void block_check(heap_block_head_t *head)
 {
-	heap_block_head_t *head = (heap_block_head_t *) addr;
+	malloc_assert(head->magic == HEAP_BLOCK_USED_MAGIC);
 
-	malloc_assert(head->magic == HEAP_BLOCK_HEAD_MAGIC);
+	if (head->cls == CLASS_LARGE) {
+		heap_large_t *large = (heap_large_t *) head->owner;
 
-	heap_block_foot_t *foot = BLOCK_FOOT(head);
+		malloc_assert(large->magic == HEAP_LARGE_MAGIC);
+		malloc_assert(large->head == head);
+	} else {
+		heap_run_t *run = (heap_run_t *) head->owner;
 
-	malloc_assert(foot->magic == HEAP_BLOCK_FOOT_MAGIC);
-	malloc_assert(head->size == foot->size);
+		malloc_assert(head->cls < CLASS_COUNT);
+		malloc_assert(run->magic == HEAP_RUN_MAGIC);
+		malloc_assert(run->cls == head->cls);
+	}
 }
 
-/** Check a heap area structure
- *
- * Should be called only inside the critical section.
+/** Get the number of usable bytes of a block
  *
- * @param addr Address of the heap area.
+ * @param head Header of the block.
  *
  */
-static void area_check(void *addr)
+static size_t block_usable(heap_block_head_t *head)
 {
-	heap_area_t *area = (heap_area_t *) addr;
+	void *payload = ((void *) head) + HEAD_SIZE;
 
-	malloc_assert(area->magic == HEAP_AREA_MAGIC);
-	malloc_assert(addr == area->start);
-	malloc_assert(area->start < area->end);
-	malloc_assert(((uintptr_t) area->start % PAGE_SIZE) == 0);
-	malloc_assert(((uintptr_t) area->end % PAGE_SIZE) == 0);
+	if (head->cls == CLASS_LARGE) {
+		heap_large_t *large = (heap_large_t *) head->owner;
+		return ((void *) large) + large->size - payload;
+	}
+
+	void *slot = ((void *) head) - head->offset;
+	return slot + HEAD_SIZE + class_size[head->cls] - payload;
 }
 
-/** Create new heap area
+/** Create a new run
  *
- * Should be called only inside the critical section.
+ * Should be called only inside the critical section of the arena.
  *
- * @param size Size of the area.
+ * @param arena Arena to own the run.
+ * @param cls   Size class of the run.
+ *
+ * @return New run or NULL on out of memory.
  *
  */
-static bool area_create(size_t size)
+static heap_run_t *run_create(heap_arena_t *arena, unsigned int cls)
 {
-	/* Align the heap area size on page boundary */
-	size_t asize = ALIGN_UP(size, PAGE_SIZE);
-	void *astart = as_area_create(AS_AREA_ANY, asize,
+	void *astart = as_area_create(AS_AREA_ANY, RUN_SIZE,
 	    AS_AREA_WRITE | AS_AREA_READ | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
 	if (astart == AS_MAP_FAILED)
-		return false;
-
-	heap_area_t *area = (heap_area_t *) astart;
-
-	area->start = astart;
-	area->end = (void *) ((uintptr_t) astart + asize);
-	area->prev = NULL;
-	area->next = NULL;
-	area->magic = HEAP_AREA_MAGIC;
+		return NULL;
 
-	void *block = (void *) AREA_FIRST_BLOCK_HEAD(area);
-	size_t bsize = (size_t) (area->end - block);
+	heap_run_t *run = (heap_run_t *) astart;
 
-	block_init(block, bsize, true, area);
+	run->magic = HEAP_RUN_MAGIC;
+	run->cls = cls;
+	run->arena = arena;
+	link_initialize(&run->partial_link);
+	link_initialize(&run->runs_link);
+	run->free_list = NULL;
+	run->slot_size = HEAD_SIZE + class_size[cls];
+	run->slots = (astart + RUN_SIZE - RUN_FIRST_SLOT(run)) /
+	    run->slot_size;
+	run->initialized = 0;
+	run->used = 0;
 
-	if (last_heap_area == NULL) {
-		first_heap_area = area;
-		last_heap_area = area;
-	} else {
-		area->prev = last_heap_area;
-		last_heap_area->next = area;
-		last_heap_area = area;
-	}
+	list_append(&run->runs_link, &arena->runs);
+	list_append(&run->partial_link, &arena->partial[cls]);
 
-	return true;
+	return run;
 }
 
-/** Try to enlarge a heap area
+/** Allocate a slot from an arena
  *
- * Should be called only inside the critical section.
+ * Should be called only inside the critical section of the arena.
  *
- * @param area Heap area to grow.
- * @param size Gross size to grow (bytes).
+ * @param arena Arena to allocate from.
+ * @param cls   Size class of the slot.
+ * @param rrun  Place to store the run owning the slot.
  *
- * @return True if successful.
+ * @return Start of the slot or NULL on out of memory.
  *
  */
-static bool area_grow(heap_area_t *area, size_t size)
+static void *slot_alloc(heap_arena_t *arena, unsigned int cls,
+    heap_run_t **rrun)
 {
-	if (size == 0)
-		return true;
-
-	area_check(area);
+	heap_run_t *run;
+	link_t *link = list_first(&arena->partial[cls]);
 
-	/* New heap area size */
-	size_t gross_size = (size_t) (area->end - area->start) + size;
-	size_t asize = ALIGN_UP(gross_size, PAGE_SIZE);
-	void *end = (void *) ((uintptr_t) area->start + asize);
-
-	/* Check for overflow */
-	if (end < area->start)
-		return false;
-
-	/* Resize the address space area */
-	errno_t ret = as_area_resize(area->start, asize, 0);
-	if (ret != EOK)
-		return false;
+	if (link != NULL) {
+		run = list_get_instance(link, heap_run_t, partial_link);
+	} else {
+		run = run_create(arena, cls);
+		if (run == NULL)
+			return NULL;
+	}
 
-	heap_block_head_t *last_head =
-	    (heap_block_head_t *) AREA_LAST_BLOCK_HEAD(area);
+	void *slot;
 
-	if (last_head->free) {
-		/* Add the new space to the last block. */
-		size_t net_size = (size_t) (end - area->end) + last_head->size;
-		malloc_assert(net_size > 0);
-		block_init(last_head, net_size, true, area);
+	if (run->free_list != NULL) {
+		/* The link to the next free slot is kept in the payload. */
+		slot = run->free_list;
+		run->free_list = *((void **) (slot + HEAD_SIZE));
 	} else {
-		/* Add new free block */
-		size_t net_size = (size_t) (end - area->end);
-		if (net_size > 0)
-			block_init(area->end, net_size, true, area);
+		malloc_assert(run->initialized < run->slots);
+		slot = RUN_SLOT(run, run->initialized);
+		run->initialized++;
 	}
 
-	/* Update heap area parameters */
-	area->end = end;
+	run->used++;
+	if (run->used == run->slots)
+		list_remove(&run->partial_link);
 
-	return true;
+	*rrun = run;
+	return slot;
 }
 
-/** Try to shrink heap
+/** Release a slot back to its run
  *
- * Should be called only inside the critical section.
- * In all cases the next pointer is reset.
- *
- * @param area Last modified heap area.
+ * @param run  Run owning the slot.
+ * @param slot Start of the slot.
  *
  */
-static void heap_shrink(heap_area_t *area)
+static void slot_free(heap_run_t *run, void *slot)
 {
-	area_check(area);
-
-	heap_block_foot_t *last_foot =
-	    (heap_block_foot_t *) AREA_LAST_BLOCK_FOOT(area);
-	heap_block_head_t *last_head = BLOCK_HEAD(last_foot);
-
-	block_check((void *) last_head);
-	malloc_assert(last_head->area == area);
-
-	if (last_head->free) {
-		/*
-		 * The last block of the heap area is
-		 * unused. The area might be potentially
-		 * shrunk.
-		 */
-
-		heap_block_head_t *first_head =
-		    (heap_block_head_t *) AREA_FIRST_BLOCK_HEAD(area);
-
-		block_check((void *) first_head);
-		malloc_assert(first_head->area == area);
-
-		size_t shrink_size = ALIGN_DOWN(last_head->size, PAGE_SIZE);
-
-		if (first_head == last_head) {
-			/*
-			 * The entire heap area consists of a single
-			 * free heap block. This means we can get rid
-			 * of it entirely.
-			 */
-
-			heap_area_t *prev = area->prev;
-			heap_area_t *next = area->next;
-
-			if (prev != NULL) {
-				area_check(prev);
-				prev->next = next;
-			} else
-				first_heap_area = next;
-
-			if (next != NULL) {
-				area_check(next);
-				next->prev = prev;
-			} else
-				last_heap_area = prev;
-
-			as_area_destroy(area->start);
-		} else if (shrink_size >= SHRINK_GRANULARITY) {
-			/*
-			 * Make sure that we always shrink the area
-			 * by a multiple of page size and update
-			 * the block layout accordingly.
-			 */
-
-			size_t asize = (size_t) (area->end - area->start) - shrink_size;
-			void *end = (void *) ((uintptr_t) area->start + asize);
-
-			/* Resize the address space area */
-			errno_t ret = as_area_resize(area->start, asize, 0);
-			if (ret != EOK)
-				abort();
-
-			/* Update heap area parameters */
-			area->end = end;
-			size_t excess = ((size_t) area->end) - ((size_t) last_head);
-
-			if (excess > 0) {
-				if (excess >= STRUCT_OVERHEAD) {
-					/*
-					 * The previous block cannot be free and there
-					 * is enough free space left in the area to
-					 * create a new free block.
-					 */
-					block_init((void *) last_head, excess, true, area);
-				} else {
-					/*
-					 * The excess is small. Therefore just enlarge
-					 * the previous block.
-					 */
-					heap_block_foot_t *prev_foot = (heap_block_foot_t *)
-					    (((uintptr_t) last_head) - sizeof(heap_block_foot_t));
-					heap_block_head_t *prev_head = BLOCK_HEAD(prev_foot);
-
-					block_check((void *) prev_head);
-
-					block_init(prev_head, prev_head->size + excess,
-					    prev_head->free, area);
-				}
-			}
-		}
+	heap_arena_t *arena = run->arena;
+	bool destroy = false;
+
+	fibril_rmutex_lock(&arena->lock);
+
+	malloc_assert(run->used > 0);
+
+	*((void **) (slot + HEAD_SIZE)) = run->free_list;
+	run->free_list = slot;
+
+	if (run->used == run->slots)
+		list_append(&run->partial_link, &arena->partial[run->cls]);
+
+	run->used--;
+
+	/*
+	 * Return an empty run to the system unless it is the only run
+	 * of the class that can serve further requests.
+	 */
+	list_t *partial = &arena->partial[run->cls];
+	if ((run->used == 0) && (list_first(partial) != list_last(partial))) {
+		list_remove(&run->partial_link);
+		list_remove(&run->runs_link);
+		run->magic = 0;
+		destroy = true;
 	}
 
-	next_fit = NULL;
+	fibril_rmutex_unlock(&arena->lock);
+
+	if (destroy)
+		as_area_destroy(run);
 }
 
-/** Initialize the heap allocator
+/** Allocate a large block
  *
- * Create initial heap memory area. This routine is
- * only called from libc initialization, thus we do not
- * take any locks.
+ * @param size  Size of the block.
+ * @param align Alignment of the block (power of two).
+ *
+ * @return Allocated block or NULL.
  *
  */
-void __malloc_init(void)
+static void *large_alloc(size_t size, size_t align)
 {
-	if (fibril_rmutex_initialize(&malloc_mutex) != EOK)
-		abort();
+	size_t overhead = sizeof(heap_large_t) + HEAD_SIZE + align;
 
-	if (!area_create(PAGE_SIZE))
-		abort();
-}
+	if (size > SIZE_MAX - overhead - PAGE_SIZE)
+		return NULL;
 
-void __malloc_fini(void)
-{
-	fibril_rmutex_destroy(&malloc_mutex);
+	size_t asize = ALIGN_UP(size + overhead, PAGE_SIZE);
+
+	void *astart = as_area_create(AS_AREA_ANY, asize,
+	    AS_AREA_WRITE | AS_AREA_READ | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (astart == AS_MAP_FAILED)
+		return NULL;
+
+	heap_large_t *large = (heap_large_t *) astart;
+	void *payload = (void *) ALIGN_UP((uintptr_t) astart +
+	    sizeof(heap_large_t) + HEAD_SIZE, align);
+	heap_block_head_t *head = (heap_block_head_t *) (payload - HEAD_SIZE);
+
+	malloc_assert(payload + size <= astart + asize);
+
+	large->magic = HEAP_LARGE_MAGIC;
+	large->size = asize;
+	large->head = head;
+	link_initialize(&large->link);
+
+	head->magic = HEAP_BLOCK_USED_MAGIC;
+	head->cls = CLASS_LARGE;
+	head->offset = 0;
+	head->owner = large;
+
+	fibril_rmutex_lock(&large_mutex);
+	list_append(&large->link, &large_blocks);
+	fibril_rmutex_unlock(&large_mutex);
+
+	return payload;
 }
 
-/** Split heap block and mark it as used.
+/** Release a large block
  *
- * Should be called only inside the critical section.
- *
- * @param cur  Heap block to split.
- * @param size Number of bytes to split and mark from the beginning
- *             of the block.
+ * @param large Descriptor of the large block.
  *
  */
-static void split_mark(heap_block_head_t *cur, const size_t size)
+static void large_free(heap_large_t *large)
 {
-	malloc_assert(cur->size >= size);
-
-	/* See if we should split the block. */
-	size_t split_limit = GROSS_SIZE(size);
+	fibril_rmutex_lock(&large_mutex);
+	list_remove(&large->link);
+	fibril_rmutex_unlock(&large_mutex);
 
-	if (cur->size > split_limit) {
-		/* Block big enough -> split. */
-		void *next = ((void *) cur) + size;
-		block_init(next, cur->size - size, true, cur->area);
-		block_init(cur, size, false, cur->area);
-	} else {
-		/* Block too small -> use as is. */
-		cur->free = false;
-	}
+	large->magic = 0;
+	large->head->magic = HEAP_BLOCK_FREE_MAGIC;
+	as_area_destroy(large);
 }
 
-/** Allocate memory from heap area starting from given block
+/** Try to resize a large block in place
  *
- * Should be called only inside the critical section.
- * As a side effect this function also sets the current
- * pointer on successful allocation.
+ * @param head Header of the large block.
+ * @param size New size of the block.
  *
- * @param area        Heap area where to allocate from.
- * @param first_block Starting heap block.
- * @param final_block Heap block where to finish the search
- *                    (may be NULL).
- * @param real_size   Gross number of bytes to allocate.
- * @param falign      Physical alignment of the block.
- *
- * @return Address of the allocated block or NULL on not enough memory.
+ * @return True if the block can now hold @a size bytes.
  *
  */
-static void *malloc_area(heap_area_t *area, heap_block_head_t *first_block,
-    heap_block_head_t *final_block, size_t real_size, size_t falign)
+static bool large_resize(heap_block_head_t *head, size_t size)
 {
-	area_check((void *) area);
-	malloc_assert((void *) first_block >= (void *) AREA_FIRST_BLOCK_HEAD(area));
-	malloc_assert((void *) first_block < area->end);
-
-	for (heap_block_head_t *cur = first_block; (void *) cur < area->end;
-	    cur = (heap_block_head_t *) (((void *) cur) + cur->size)) {
-		block_check(cur);
-
-		/* Finish searching on the final block */
-		if ((final_block != NULL) && (cur == final_block))
-			break;
-
-		/* Try to find a block that is free and large enough. */
-		if ((cur->free) && (cur->size >= real_size)) {
-			/*
-			 * We have found a suitable block.
-			 * Check for alignment properties.
-			 */
-			void *addr = (void *)
-			    ((uintptr_t) cur + sizeof(heap_block_head_t));
-			void *aligned = (void *)
-			    ALIGN_UP((uintptr_t) addr, falign);
-
-			if (addr == aligned) {
-				/* Exact block start including alignment. */
-				split_mark(cur, real_size);
-
-				next_fit = cur;
-				return addr;
-			} else {
-				/* Block start has to be aligned */
-				size_t excess = (size_t) (aligned - addr);
-
-				if (cur->size >= real_size + excess) {
-					/*
-					 * The current block is large enough to fit
-					 * data in (including alignment).
-					 */
-					if ((void *) cur > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
-						/*
-						 * There is a block before the current block.
-						 * This previous block can be enlarged to
-						 * compensate for the alignment excess.
-						 */
-						heap_block_foot_t *prev_foot = (heap_block_foot_t *)
-						    ((void *) cur - sizeof(heap_block_foot_t));
-
-						heap_block_head_t *prev_head = (heap_block_head_t *)
-						    ((void *) cur - prev_foot->size);
-
-						block_check(prev_head);
-
-						size_t reduced_size = cur->size - excess;
-						heap_block_head_t *next_head = ((void *) cur) + excess;
-
-						if ((!prev_head->free) &&
-						    (excess >= STRUCT_OVERHEAD)) {
-							/*
-							 * The previous block is not free and there
-							 * is enough free space left to fill in
-							 * a new free block between the previous
-							 * and current block.
-							 */
-							block_init(cur, excess, true, area);
-						} else {
-							/*
-							 * The previous block is free (thus there
-							 * is no need to induce additional
-							 * fragmentation to the heap) or the
-							 * excess is small. Therefore just enlarge
-							 * the previous block.
-							 */
-							block_init(prev_head, prev_head->size + excess,
-							    prev_head->free, area);
-						}
-
-						block_init(next_head, reduced_size, true, area);
-						split_mark(next_head, real_size);
-
-						next_fit = next_head;
-						return aligned;
-					} else {
-						/*
-						 * The current block is the first block
-						 * in the heap area. We have to make sure
-						 * that the alignment excess is large enough
-						 * to fit a new free block just before the
-						 * current block.
-						 */
-						while (excess < STRUCT_OVERHEAD) {
-							aligned += falign;
-							excess += falign;
-						}
-
-						/* Check for current block size again */
-						if (cur->size >= real_size + excess) {
-							size_t reduced_size = cur->size - excess;
-							cur = (heap_block_head_t *)
-							    (AREA_FIRST_BLOCK_HEAD(area) + excess);
-
-							block_init((void *) AREA_FIRST_BLOCK_HEAD(area),
-							    excess, true, area);
-							block_init(cur, reduced_size, true, area);
-							split_mark(cur, real_size);
-
-							next_fit = cur;
-							return aligned;
-						}
-					}
-				}
-			}
-		}
-	}
+	heap_large_t *large = (heap_large_t *) head->owner;
+	size_t offset = ((void *) head) + HEAD_SIZE - (void *) large;
 
-	return NULL;
+	if (size > SIZE_MAX - offset - PAGE_SIZE)
+		return false;
+
+	size_t asize = ALIGN_UP(offset + size, PAGE_SIZE);
+	if (asize == large->size)
+		return true;
+
+	if (as_area_resize(large, asize, 0) != EOK)
+		return (asize < large->size);
+
+	large->size = asize;
+	return true;
 }
 
-/** Try to enlarge any of the heap areas.
- *
- * If successful, allocate block of the given size in the area.
- * Should be called only inside the critical section.
- *
- * @param size  Gross size of item to allocate (bytes).
- * @param align Memory address alignment.
+/** Initialize the heap allocator
  *
- * @return Allocated block.
- * @return NULL on failure.
+ * Create the arenas and the size class lookup table. This function is
+ * only called from libc initialization, thus we do not take any locks.
  *
  */
-static void *heap_grow_and_alloc(size_t size, size_t align)
+void __malloc_init(void)
 {
-	if (size == 0)
-		return NULL;
+	if (fibril_rmutex_initialize(&large_mutex) != EOK)
+		abort();
 
-	/* First try to enlarge some existing area */
-	for (heap_area_t *area = first_heap_area; area != NULL;
-	    area = area->next) {
+	for (unsigned int i = 0; i < HEAP_ARENAS; i++) {
+		if (fibril_rmutex_initialize(&arenas[i].lock) != EOK)
+			abort();
 
-		if (area_grow(area, size + align)) {
-			heap_block_head_t *first =
-			    (heap_block_head_t *) AREA_LAST_BLOCK_HEAD(area);
+		for (unsigned int cls = 0; cls < CLASS_COUNT; cls++)
+			list_initialize(&arenas[i].partial[cls]);
 
-			void *addr =
-			    malloc_area(area, first, NULL, size, align);
-			malloc_assert(addr != NULL);
-			return addr;
-		}
+		list_initialize(&arenas[i].runs);
 	}
 
-	/* Eventually try to create a new area */
-	if (area_create(AREA_OVERHEAD(size + align))) {
-		heap_block_head_t *first =
-		    (heap_block_head_t *) AREA_FIRST_BLOCK_HEAD(last_heap_area);
+	unsigned int cls = 0;
+	for (size_t i = 0; i <= SMALL_MAX / BASE_ALIGN; i++) {
+		while (class_size[cls] < i * BASE_ALIGN)
+			cls++;
 
-		void *addr =
-		    malloc_area(last_heap_area, first, NULL, size, align);
-		malloc_assert(addr != NULL);
-		return addr;
+		size_class[i] = cls;
 	}
 
-	return NULL;
+	heap_initialized = true;
 }
 
-/** Allocate a memory block
- *
- * Should be called only inside the critical section.
+void __malloc_fini(void)
+{
+	for (unsigned int i = 0; i < HEAP_ARENAS; i++)
+		fibril_rmutex_destroy(&arenas[i].lock);
+
+	fibril_rmutex_destroy(&large_mutex);
+}
+
+/** Allocate memory
  *
- * @param size  The size of the block to allocate.
- * @param align Memory address alignment.
+ * @param size  Number of bytes to allocate.
+ * @param align Memory address alignment (power of two).
  *
- * @return Address of the allocated block or NULL on not enough memory.
+ * @return Allocated memory or NULL.
  *
  */
 static void *malloc_internal(const size_t size, const size_t align)
 {
-	malloc_assert(first_heap_area != NULL);
+	malloc_assert(heap_initialized);
 
-	if (align == 0)
-		return NULL;
+	size_t falign = max(align, BASE_ALIGN);
 
-	size_t falign = lcm(align, BASE_ALIGN);
+	/* Aligning inside a slot may need up to this many extra bytes. */
+	size_t slack = falign - BASE_ALIGN;
 
-	/* Check for integer overflow. */
-	if (falign < align)
-		return NULL;
+	if ((size > SMALL_MAX) || (size + slack > SMALL_MAX))
+		return large_alloc(size, falign);
 
-	/*
-	 * The size of the allocated block needs to be naturally
-	 * aligned, because the footer structure also needs to reside
-	 * on a naturally aligned address in order to avoid unaligned
-	 * memory accesses.
-	 */
-	size_t gross_size = GROSS_SIZE(ALIGN_UP(size, BASE_ALIGN));
+	unsigned int cls =
+	    size_class[(size + slack + BASE_ALIGN - 1) / BASE_ALIGN];
 
-	/* Try the next fit approach */
-	heap_block_head_t *split = next_fit;
+	heap_arena_t *arena = arena_lock();
+	heap_run_t *run;
+	void *slot = slot_alloc(arena, cls, &run);
+	arena_unlock(arena);
 
-	if (split != NULL) {
-		void *addr = malloc_area(split->area, split, NULL, gross_size,
-		    falign);
-
-		if (addr != NULL)
-			return addr;
-	}
-
-	/* Search the entire heap */
-	for (heap_area_t *area = first_heap_area; area != NULL;
-	    area = area->next) {
-		heap_block_head_t *first = (heap_block_head_t *)
-		    AREA_FIRST_BLOCK_HEAD(area);
-
-		void *addr = malloc_area(area, first, split, gross_size,
-		    falign);
+	if (slot == NULL)
+		return NULL;
 
-		if (addr != NULL)
-			return addr;
+	heap_block_head_t *head = (heap_block_head_t *) slot;
+	head->magic = HEAP_BLOCK_USED_MAGIC;
+	head->cls = cls;
+	head->offset = 0;
+	head->owner = run;
+
+	void *payload = (void *) ALIGN_UP((uintptr_t) slot + HEAD_SIZE, falign);
+	if (payload != slot + HEAD_SIZE) {
+		/* Add a header right before the aligned payload. */
+		head = (heap_block_head_t *) (payload - HEAD_SIZE);
+		head->magic = HEAP_BLOCK_USED_MAGIC;
+		head->cls = cls;
+		head->offset = (void *) head - slot;
+		head->owner = run;
 	}
 
-	/* Finally, try to grow heap space and allocate in the new area. */
-	return heap_grow_and_alloc(gross_size, falign);
+	return payload;
 }
 
 /** Allocate memory by number of elements
@@ -773,7 +613,8 @@ static void *malloc_internal(const size_t size, const size_t align)
  */
 void *calloc(const size_t nmemb, const size_t size)
 {
-	// FIXME: Check for overflow
+	if ((size != 0) && (nmemb > SIZE_MAX / size))
+		return NULL;
 
 	void *block = malloc(nmemb * size);
 	if (block == NULL)
@@ -792,11 +633,7 @@ void *calloc(const size_t nmemb, const size_t size)
  */
 void *malloc(const size_t size)
 {
-	heap_lock();
-	void *block = malloc_internal(size, BASE_ALIGN);
-	heap_unlock();
-
-	return block;
+	return malloc_internal(size, BASE_ALIGN);
 }
 
 /** Allocate memory with specified alignment
@@ -815,11 +652,7 @@ void *memalign(const size_t align, const size_t size)
 	size_t palign =
 	    1 << (fnzb(max(sizeof(void *), align) - 1) + 1);
 
-	heap_lock();
-	void *block = malloc_internal(size, palign);
-	heap_unlock();
-
-	return block;
+	return malloc_internal(size, palign);
 }
 
 /** Reallocate memory block
@@ -840,100 +673,28 @@ void *realloc(void *const addr, const size_t size)
 	if (addr == NULL)
 		return malloc(size);
 
-	heap_lock();
-
 	/* Calculate the position of the header. */
 	heap_block_head_t *head =
-	    (heap_block_head_t *) (addr - sizeof(heap_block_head_t));
+	    (heap_block_head_t *) (addr - HEAD_SIZE);
 
 	block_check(head);
-	malloc_assert(!head->free);
-
-	heap_area_t *area = head->area;
-
-	area_check(area);
-	malloc_assert((void *) head >= (void *) AREA_FIRST_BLOCK_HEAD(area));
-	malloc_assert((void *) head < area->end);
-
-	void *ptr = NULL;
-	bool reloc = false;
-	size_t real_size = GROSS_SIZE(ALIGN_UP(size, BASE_ALIGN));
-	size_t orig_size = head->size;
-
-	if (orig_size > real_size) {
-		/* Shrink */
-		if (orig_size - real_size >= STRUCT_OVERHEAD) {
-			/*
-			 * Split the original block to a full block
-			 * and a trailing free block.
-			 */
-			block_init((void *) head, real_size, false, area);
-			block_init((void *) head + real_size,
-			    orig_size - real_size, true, area);
-			heap_shrink(area);
-		}
 
-		ptr = ((void *) head) + sizeof(heap_block_head_t);
-	} else {
-		heap_block_head_t *next_head =
-		    (heap_block_head_t *) (((void *) head) + head->size);
-		bool have_next = ((void *) next_head < area->end);
-
-		if (((void *) head) + real_size > area->end) {
-			/*
-			 * The current area is too small to hold the resized
-			 * block. Make sure there are no used blocks standing
-			 * in our way and try to grow the area using real_size
-			 * as a safe upper bound.
-			 */
-
-			bool have_next_next;
-
-			if (have_next) {
-				have_next_next = (((void *) next_head) +
-				    next_head->size < area->end);
-			}
-			if (!have_next || (next_head->free && !have_next_next)) {
-				/*
-				 * There is no next block in this area or
-				 * it is a free block and there is no used
-				 * block following it. There can't be any
-				 * free block following it either as
-				 * two free blocks would be merged.
-				 */
-				(void) area_grow(area, real_size);
-			}
-		}
+	size_t usable = block_usable(head);
 
-		/*
-		 * Look at the next block. If it is free and the size is
-		 * sufficient then merge the two. Otherwise just allocate a new
-		 * block, copy the original data into it and free the original
-		 * block.
-		 */
-
-		if (have_next && (head->size + next_head->size >= real_size) &&
-		    next_head->free) {
-			block_check(next_head);
-			block_init(head, head->size + next_head->size, false,
-			    area);
-			split_mark(head, real_size);
-
-			ptr = ((void *) head) + sizeof(heap_block_head_t);
-			next_fit = NULL;
-		} else {
-			reloc = true;
-		}
+	if (head->cls == CLASS_LARGE) {
+		/* Grow or shrink the area in place if possible. */
+		if (large_resize(head, size))
+			return addr;
+	} else if ((size <= usable) &&
+	    ((size > SMALL_MAX / 2) || (size + size > usable))) {
+		/* The block fits and does not waste too much space. */
+		return addr;
 	}
 
-	heap_unlock();
-
-	if (reloc) {
-		ptr = malloc(size);
-		if (ptr != NULL) {
-			memcpy(ptr, addr, NET_SIZE(orig_size));
-			free(addr);
-		}
+	void *ptr = malloc(size);
+	if (ptr != NULL) {
+		memcpy(ptr, addr, min(usable, size));
+		free(addr);
 	}
 
 	return ptr;
@@ -949,99 +710,111 @@ void free(void *const addr)
 	if (addr == NULL)
 		return;
 
-	heap_lock();
-
 	/* Calculate the position of the header. */
 	heap_block_head_t *head =
-	    (heap_block_head_t *) (addr - sizeof(heap_block_head_t));
+	    (heap_block_head_t *) (addr - HEAD_SIZE);
 
 	block_check(head);
-	malloc_assert(!head->free);
-
-	heap_area_t *area = head->area;
 
-	area_check(area);
-	malloc_assert((void *) head >= (void *) AREA_FIRST_BLOCK_HEAD(area));
-	malloc_assert((void *) head < area->end);
-
-	/* Mark the block itself as free. */
-	head->free = true;
-
-	/* Look at the next block. If it is free, merge the two. */
-	heap_block_head_t *next_head =
-	    (heap_block_head_t *) (((void *) head) + head->size);
-
-	if ((void *) next_head < area->end) {
-		block_check(next_head);
-		if (next_head->free)
-			block_init(head, head->size + next_head->size, true, area);
+	if (head->cls == CLASS_LARGE) {
+		large_free((heap_large_t *) head->owner);
+		return;
 	}
 
-	/* Look at the previous block. If it is free, merge the two. */
-	if ((void *) head > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
-		heap_block_foot_t *prev_foot =
-		    (heap_block_foot_t *) (((void *) head) - sizeof(heap_block_foot_t));
+	heap_run_t *run = (heap_run_t *) head->owner;
+	void *slot = ((void *) head) - head->offset;
 
-		heap_block_head_t *prev_head =
-		    (heap_block_head_t *) (((void *) head) - prev_foot->size);
+	malloc_assert(slot >= RUN_FIRST_SLOT(run));
+	malloc_assert(slot < ((void *) run) + RUN_SIZE);
+	malloc_assert(((slot - RUN_FIRST_SLOT(run)) % run->slot_size) == 0);
 
-		block_check(prev_head);
+	/* Mark the block itself as free. */
+	head->magic = HEAP_BLOCK_FREE_MAGIC;
+	((heap_block_head_t *) slot)->magic = HEAP_BLOCK_FREE_MAGIC;
 
-		if (prev_head->free)
-			block_init(prev_head, prev_head->size + head->size, true,
-			    area);
-	}
+	slot_free(run, slot);
+}
 
-	heap_shrink(area);
+/** Check a run and all slots it has handed out
+ *
+ * Should be called only inside the critical section of the arena.
+ *
+ * @return NULL if the run is consistent or the address
+ *         of the first corrupted structure.
+ *
+ */
+static void *run_check(heap_arena_t *arena, heap_run_t *run)
+{
+	if ((run->magic != HEAP_RUN_MAGIC) ||
+	    (((uintptr_t) run % PAGE_SIZE) != 0) ||
+	    (run->arena != arena) ||
+	    (run->cls >= CLASS_COUNT) ||
+	    (run->slot_size != HEAD_SIZE + class_size[run->cls]) ||
+	    (run->initialized > run->slots) ||
+	    (run->used > run->initialized))
+		return (void *) run;
+
+	for (size_t i = 0; i < run->initialized; i++) {
+		heap_block_head_t *head =
+		    (heap_block_head_t *) RUN_SLOT(run, i);
+
+		if (head->magic == HEAP_BLOCK_FREE_MAGIC)
+			continue;
+
+		if ((head->magic != HEAP_BLOCK_USED_MAGIC) ||
+		    (head->cls != run->cls) ||
+		    (head->offset != 0) ||
+		    (head->owner != run))
+			return (void *) head;
+	}
 
-	heap_unlock();
+	return NULL;
 }
 
 void *heap_check(void)
 {
-	heap_lock();
-
-	if (first_heap_area == NULL) {
-		heap_unlock();
+	if (!heap_initialized)
 		return (void *) -1;
-	}
 
-	/* Walk all heap areas */
-	for (heap_area_t *area = first_heap_area; area != NULL;
-	    area = area->next) {
-
-		/* Check heap area consistency */
-		if ((area->magic != HEAP_AREA_MAGIC) ||
-		    ((void *) area != area->start) ||
-		    (area->start >= area->end) ||
-		    (((uintptr_t) area->start % PAGE_SIZE) != 0) ||
-		    (((uintptr_t) area->end % PAGE_SIZE) != 0)) {
-			heap_unlock();
-			return (void *) area;
-		}
+	/* Walk all arenas */
+	for (unsigned int i = 0; i < HEAP_ARENAS; i++) {
+		heap_arena_t *arena = &arenas[i];
 
-		/* Walk all heap blocks */
-		for (heap_block_head_t *head = (heap_block_head_t *)
-		    AREA_FIRST_BLOCK_HEAD(area); (void *) head < area->end;
-		    head = (heap_block_head_t *) (((void *) head) + head->size)) {
+		fibril_rmutex_lock(&arena->lock);
 
-			/* Check heap block consistency */
-			if (head->magic != HEAP_BLOCK_HEAD_MAGIC) {
-				heap_unlock();
-				return (void *) head;
+		/* Walk all runs */
+		list_foreach(arena->runs, runs_link, heap_run_t, run) {
+			void *bad = run_check(arena, run);
+			if (bad != NULL) {
+				fibril_rmutex_unlock(&arena->lock);
+				return bad;
 			}
+		}
 
-			heap_block_foot_t *foot = BLOCK_FOOT(head);
+		fibril_rmutex_unlock(&arena->lock);
+	}
 
-			if ((foot->magic != HEAP_BLOCK_FOOT_MAGIC) ||
-			    (head->size != foot->size)) {
-				heap_unlock();
-				return (void *) foot;
-			}
+	/* Walk all large blocks */
+	fibril_rmutex_lock(&large_mutex);
+
+	list_foreach(large_blocks, link, heap_large_t, large) {
+		if ((large->magic != HEAP_LARGE_MAGIC) ||
+		    (((uintptr_t) large % PAGE_SIZE) != 0)) {
+			fibril_rmutex_unlock(&large_mutex);
+			return (void *) large;
+		}
+
+		heap_block_head_t *head = large->head;
+
+		if ((head->magic != HEAP_BLOCK_USED_MAGIC) ||
+		    (head->cls != CLASS_LARGE) ||
+		    (head->owner != large)) {
+			fibril_rmutex_unlock(&large_mutex);
+			return (void *) head;
 		}
 	}
 
-	heap_unlock();
+	fibril_rmutex_unlock(&large_mutex);
 
 	return NULL;
 }
@@ -38,6 +38,12 @@
 #include <stddef.h>
 #include <stdint.h>
 #include "private/cc.h"
+#include "private/mem.h"
+
+/** Word which may alias any other type. */
+typedef unsigned long __attribute__((may_alias)) mem_word_t;
+
+#ifndef MEMFNC_ARCH
 
 /** Fill memory block with a constant value. */
 ATTRIBUTE_OPTIMIZE_NO_TLDP
@@ -192,6 +198,8 @@ ATTRIBUTE_OPTIMIZE_NO_TLDP
 	return dst;
 }
 
+#endif /* MEMFNC_ARCH */
+
 /** Move memory block with possible overlapping. */
 void *memmove(void *dst, const void *src, size_t n)
 {
@@ -244,6 +252,19 @@ int memcmp(const void *s1, const void *s2, size_t len)
 	uint8_t *u2 = (uint8_t *) s2;
 	size_t i;
 
+	/*
+	 * Skip the equal leading words if both areas are word-aligned,
+	 * the first difference is then located bytewise.
+	 */
+	if ((((uintptr_t) u1 | (uintptr_t) u2) % sizeof(mem_word_t)) == 0) {
+		while ((len >= sizeof(mem_word_t)) &&
+		    (*(mem_word_t *) u1 == *(mem_word_t *) u2)) {
+			u1 += sizeof(mem_word_t);
+			u2 += sizeof(mem_word_t);
+			len -= sizeof(mem_word_t);
+		}
+	}
+
 	for (i = 0; i < len; i++) {
 		if (*u1 != *u2)
 			return (int)(*u1) - (int)(*u2);
@@ -267,11 +288,35 @@ void *memchr(const void *s, int c, size_t n)
 {
 	uint8_t *u = (uint8_t *) s;
 	unsigned char uc = (unsigned char) c;
-	size_t i;
+	mem_word_t ones = ((mem_word_t) -1) / 0xff;
+	mem_word_t pattern = ones * uc;
+	mem_word_t w;
+
+	/* Search bytewise up to the first word boundary. */
+	while ((n > 0) && (((uintptr_t) u % sizeof(mem_word_t)) != 0)) {
+		if (*u == uc)
+			return (void *) u;
+		u++;
+		n--;
+	}
+
+	/*
+	 * Skip whole words not containing the byte, i.e. words which
+	 * have no zero byte after XORing with the pattern.
+	 */
+	while (n >= sizeof(mem_word_t)) {
+		w = *(mem_word_t *) u ^ pattern;
+		if (((w - ones) & ~w & (ones << 7)) != 0)
+			break;
+		u += sizeof(mem_word_t);
+		n -= sizeof(mem_word_t);
+	}
 
-	for (i = 0; i < n; i++) {
-		if (u[i] == uc)
-			return (void *) &u[i];
+	while (n > 0) {
+		if (*u == uc)
+			return (void *) u;
+		u++;
+		n--;
 	}
 
 	return NULL;
@@ -32,11 +32,15 @@
 /** @file
  */
 
+#include <assert.h>
 #include <ns.h>
 #include <ipc/ns.h>
 #include <async.h>
 #include <macros.h>
 #include <errno.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <adt/list.h>
 #include "private/ns.h"
 
 /*
@@ -45,6 +49,143 @@
  */
 static async_sess_t *sess_ns = NULL;
 
+/** Number of services remembered by the connection cache */
+#define NS_CACHE_SIZE  8
+
+/** Connection cache entry
+ *
+ * Once a service is connected for the second time, the entry keeps
+ * a connection to it. Further connections are then cloned from it,
+ * which goes directly to the service instead of through ns.
+ */
+typedef struct {
+	link_t link;
+	service_t service;
+	iface_t iface;
+	sysarg_t arg3;
+	/** Connection to clone, NULL if connected only once so far */
+	async_sess_t *sess;
+} ns_cache_entry_t;
+
+static FIBRIL_MUTEX_INITIALIZE(ns_cache_lock);
+
+/** Cache entries, most recently used first */
+static LIST_INITIALIZE(ns_cache);
+static size_t ns_cache_count = 0;
+
+static void ns_cache_remove(ns_cache_entry_t *entry)
+{
+	assert(fibril_mutex_is_locked(&ns_cache_lock));
+
+	list_remove(&entry->link);
+	ns_cache_count--;
+
+	if (entry->sess != NULL)
+		async_hangup(entry->sess);
+	free(entry);
+}
+
+static ns_cache_entry_t *ns_cache_find(service_t service, iface_t iface,
+    sysarg_t arg3)
+{
+	assert(fibril_mutex_is_locked(&ns_cache_lock));
+
+	list_foreach(ns_cache, link, ns_cache_entry_t, entry) {
+		if ((entry->service == service) && (entry->iface == iface) &&
+		    (entry->arg3 == arg3)) {
+			/* Keep the list in the order of use */
+			list_remove(&entry->link);
+			list_prepend(&entry->link, &ns_cache);
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/** Connect to a service by cloning a cached connection.
+ *
+ * A connection to a service that has terminated fails right away, such
+ * entry is dropped from the cache.
+ *
+ * @return New session or NULL if the service is not cached.
+ */
+static async_sess_t *ns_cache_connect(service_t service, iface_t iface,
+    sysarg_t arg3)
+{
+	async_sess_t *csess = NULL;
+
+	fibril_mutex_lock(&ns_cache_lock);
+
+	ns_cache_entry_t *entry = ns_cache_find(service, iface, arg3);
+	if ((entry != NULL) && (entry->sess != NULL)) {
+		async_exch_t *exch = async_exchange_begin(entry->sess);
+		if (exch != NULL) {
+			csess = async_connect_me_to(exch, iface, arg3, 0);
+			async_exchange_end(exch);
+		}
+
+		if (csess == NULL)
+			ns_cache_remove(entry);
+	}
+
+	fibril_mutex_unlock(&ns_cache_lock);
+
+	if (csess != NULL)
+		async_sess_args_set(csess, iface, arg3, 0);
+
+	return csess;
+}
+
+/** Remember a connection made through ns.
+ *
+ * @param csess New session to the service.
+ */
+static void ns_cache_update(service_t service, iface_t iface, sysarg_t arg3,
+    async_sess_t *csess)
+{
+	/*
+	 * Each connection to a clonable service reaches a new server
+	 * instance, cloning an existing one would defeat that.
+	 */
+	if ((service == SERVICE_LOADER) && (iface == INTERFACE_LOADER))
+		return;
+
+	fibril_mutex_lock(&ns_cache_lock);
+
+	ns_cache_entry_t *entry = ns_cache_find(service, iface, arg3);
+	if (entry == NULL) {
+		entry = malloc(sizeof(ns_cache_entry_t));
+		if (entry != NULL) {
+			link_initialize(&entry->link);
+			entry->service = service;
+			entry->iface = iface;
+			entry->arg3 = arg3;
+			entry->sess = NULL;
+			list_prepend(&entry->link, &ns_cache);
+			ns_cache_count++;
+
+			if (ns_cache_count > NS_CACHE_SIZE) {
+				ns_cache_remove(list_get_instance(
+				    list_last(&ns_cache), ns_cache_entry_t,
+				    link));
+			}
+		}
+	} else if (entry->sess == NULL) {
+		/* Connected repeatedly, keep a connection for cloning */
+		async_exch_t *exch = async_exchange_begin(csess);
+		if (exch != NULL) {
+			entry->sess = async_connect_me_to(exch, iface, arg3, 0);
+			async_exchange_end(exch);
+		}
+
+		if (entry->sess != NULL)
+			async_sess_args_set(entry->sess, iface, arg3, 0);
+	}
+
+	fibril_mutex_unlock(&ns_cache_lock);
+}
+
 errno_t service_register(service_t service, iface_t iface,
     async_port_handler_t handler, void *data)
 {
@@ -104,6 +245,10 @@ errno_t service_register_broker(service_t service, async_port_handler_t handler,
 
 async_sess_t *service_connect(service_t service, iface_t iface, sysarg_t arg3)
 {
+	async_sess_t *csess = ns_cache_connect(service, iface, arg3);
+	if (csess != NULL)
+		return csess;
+
 	async_sess_t *sess = ns_session_get();
 	if (sess == NULL)
 		return NULL;
@@ -112,8 +257,7 @@ async_sess_t *service_connect(service_t service, iface_t iface, sysarg_t arg3)
 	if (exch == NULL)
 		return NULL;
 
-	async_sess_t *csess =
-	    async_connect_me_to(exch, iface, service, arg3);
+	csess = async_connect_me_to(exch, iface, service, arg3);
 	async_exchange_end(exch);
 
 	if (csess == NULL)
@@ -126,19 +270,23 @@ async_sess_t *service_connect(service_t service, iface_t iface, sysarg_t arg3)
 	 */
 	async_sess_args_set(csess, iface, arg3, 0);
 
+	ns_cache_update(service, iface, arg3, csess);
 	return csess;
 }
 
 async_sess_t *service_connect_blocking(service_t service, iface_t iface,
     sysarg_t arg3)
 {
+	async_sess_t *csess = ns_cache_connect(service, iface, arg3);
+	if (csess != NULL)
+		return csess;
+
 	async_sess_t *sess = ns_session_get();
 	if (sess == NULL)
 		return NULL;
 
 	async_exch_t *exch = async_exchange_begin(sess);
-	async_sess_t *csess =
-	    async_connect_me_to_blocking(exch, iface, service, arg3);
+	csess = async_connect_me_to_blocking(exch, iface, service, arg3);
 	async_exchange_end(exch);
 
 	if (csess == NULL)
@@ -151,6 +299,7 @@ async_sess_t *service_connect_blocking(service_t service, iface_t iface,
 	 */
 	async_sess_args_set(csess, iface, arg3, 0);
 
+	ns_cache_update(service, iface, arg3, csess);
 	return csess;
 }
 
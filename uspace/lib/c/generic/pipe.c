@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ * @brief Pipes.
+ *
+ * A pipe is a pair of services registered by the pipe service. Data written
+ * to the file of the write end can be read from the file of the read end.
+ * Each end is opened through locfs so the resulting file handles can be
+ * passed to other tasks just like any other file.
+ */
+
+#include <async.h>
+#include <errno.h>
+#include <ipc/pipe.h>
+#include <ipc/services.h>
+#include <loc.h>
+#include <pipe.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vfs/vfs.h>
+
+/** Open one end of a pipe.
+ *
+ * @param sid  Service ID of the pipe end
+ * @param mode Open mode
+ * @param rfd  Place to store the file handle
+ * @return EOK on success or an error code
+ */
+static errno_t pipe_open_end(service_id_t sid, int mode, int *rfd)
+{
+	char *name;
+	char *path;
+	errno_t rc;
+
+	rc = loc_service_get_name(sid, &name);
+	if (rc != EOK)
+		return rc;
+
+	if (asprintf(&path, "/loc/%s", name) < 0) {
+		free(name);
+		return ENOMEM;
+	}
+
+	free(name);
+
+	rc = vfs_lookup_open(path, WALK_REGULAR, mode, rfd);
+	free(path);
+	return rc;
+}
+
+/** Create a pipe.
+ *
+ * The pipe lives until both of its ends are closed. Reading from the read
+ * end returns no data once the write end is closed and the buffered data
+ * have been consumed. Writing to the write end fails with EPIPE once the
+ * read end is closed.
+ *
+ * @param rfd Place to store the file handle of the read end
+ * @param wfd Place to store the file handle of the write end
+ * @return EOK on success, ENOENT if pipes are not available or an error code
+ */
+errno_t pipe_create(int *rfd, int *wfd)
+{
+	async_sess_t *sess;
+	async_exch_t *exch;
+	service_id_t sid;
+	sysarg_t rsid;
+	sysarg_t wsid;
+	errno_t rc;
+
+	rc = loc_service_get_id(SERVICE_NAME_PIPE, &sid, 0);
+	if (rc != EOK)
+		return ENOENT;
+
+	sess = loc_service_connect(sid, INTERFACE_PIPE, 0);
+	if (sess == NULL)
+		return EIO;
+
+	exch = async_exchange_begin(sess);
+	rc = async_req_0_2(exch, PIPE_CREATE, &rsid, &wsid);
+	async_exchange_end(exch);
+	if (rc != EOK)
+		goto error;
+
+	/*
+	 * The pipe is kept alive as long as we are connected, so open
+	 * both ends before hanging up.
+	 */
+	rc = pipe_open_end(rsid, MODE_READ, rfd);
+	if (rc != EOK)
+		goto error;
+
+	rc = pipe_open_end(wsid, MODE_WRITE, wfd);
+	if (rc != EOK) {
+		vfs_put(*rfd);
+		goto error;
+	}
+
+	async_hangup(sess);
+	return EOK;
+error:
+	async_hangup(sess);
+	return rc;
+}
+
+/** @}
+ */
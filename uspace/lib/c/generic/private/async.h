@@ -40,6 +40,7 @@
 #include <fibril.h>
 #include <fibril_synch.h>
 #include <time.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 
 /** Session data */
@@ -106,6 +107,16 @@ extern async_port_handler_t async_get_port_handler(iface_t, port_id_t, void **);
 
 extern void async_reply_received(ipc_call_t *);
 
+extern atomic_bool __async_stats_enabled;
+
+extern void __async_stats_init(void);
+extern void __async_stats_fini(void);
+extern usec_t __async_stats_now(void);
+extern void __async_stats_connection(task_id_t, iface_t);
+extern void __async_stats_call(task_id_t, iface_t, sysarg_t, usec_t, usec_t,
+    usec_t);
+extern void __async_stats_conn(ipc_call_t *, void *);
+
 #endif
 
 /** @}
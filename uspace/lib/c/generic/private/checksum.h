@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015 Jiri Svoboda
+ * Copyright (c) 2026 HelenOS Project
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -26,44 +26,34 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-/** @addtogroup libnettl
+/** @addtogroup libc
  * @{
  */
-/**
- * @file Port range allocator.
+/** @file
  */
 
-#ifndef LIBNETTL_PORTRNG_H_
-#define LIBNETTL_PORTRNG_H_
+#ifndef _LIBC_PRIVATE_CHECKSUM_H_
+#define _LIBC_PRIVATE_CHECKSUM_H_
+
+#include <libarch/config.h>
+
+#ifdef CRC32C_ARCH
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-/** Allocated port */
-typedef struct {
-	/** Link to portrng_t.used */
-	link_t lprng;
-	/** Port number */
-	uint16_t pn;
-	/** User argument */
-	void *arg;
-} portrng_port_t;
+/** The processor can compute CRC32C, set by __crc32c_init(). */
+extern bool __crc32c_arch_avail;
 
-typedef struct {
-	list_t used; /* of portrng_port_t */
-} portrng_t;
+extern void __crc32c_init(void);
+extern uint32_t __crc32c_arch(uint32_t, const uint8_t *, size_t);
 
-typedef enum {
-	pf_allow_system = 0x1
-} portrng_flags_t;
+#else
 
-extern errno_t portrng_create(portrng_t **);
-extern void portrng_destroy(portrng_t *);
-extern errno_t portrng_alloc(portrng_t *, uint16_t, void *,
-    portrng_flags_t, uint16_t *);
-extern errno_t portrng_find_port(portrng_t *, uint16_t, void **);
-extern void portrng_free_port(portrng_t *, uint16_t);
-extern bool portrng_empty(portrng_t *);
+#define __crc32c_init()
+
+#endif
 
 #endif
 
@@ -30,6 +30,8 @@
 #define _LIBC_PRIVATE_FIBRIL_H_
 
 #include <adt/list.h>
+#include <assert.h>
+#include <stdatomic.h>
 #include <context.h>
 #include <tls.h>
 #include <abi/proc/uarg.h>
@@ -38,10 +40,27 @@
 
 #include "./futex.h"
 
+/** Maximum number of runners with a ready queue of their own. */
+#define RUNNER_MAX 16
+
 typedef struct {
 	fibril_t *fibril;
 } fibril_event_t;
 
+/** Quiescent state tracking of a thread, see fibril_rcu_synchronize(). */
+typedef struct {
+	/** Link to the list of threads */
+	link_t link;
+	/** Incremented by the thread whenever it switches fibrils */
+	atomic_uint switches;
+	/** The thread is waiting for work in its helper fibril */
+	atomic_bool idle;
+	/** Value of @c switches when the current grace period started */
+	unsigned int gp_switches;
+	/** The current grace period waits for the thread */
+	bool gp_wait;
+} fibril_rcu_thread_t;
+
 #define FIBRIL_EVENT_INIT ((fibril_event_t) {0})
 
 struct fibril {
@@ -57,11 +76,31 @@ struct fibril {
 	errno_t (*func)(void *);
 	tcb_t *tcb;
 
+	/* Work left behind by the fibril that switched to this one. */
 	fibril_t *clean_after_me;
+	fibril_t *ready_after_me;
+	fibril_t *block_after_me;
 	errno_t retval;
 
 	fibril_t *thread_ctx;
 
+	/* ID of the thread running the fibril (truncated), 0 if unknown. */
+	sysarg_t tid;
+	/* Quiescent state tracking of the thread running the fibril. */
+	fibril_rcu_thread_t *rcu_thread;
+
+	/* Runner whose ready queue the fibril uses while running. */
+	unsigned int runner;
+	/* Runner to queue the fibril at when made ready, plus one (0 if any). */
+	unsigned int home;
+
+	/* Timeouts are delayed to a multiple of this (ns), 0 for none. */
+	nsec_t timer_slack;
+
+	/* Accumulated run time (us) and start of the current run, if known. */
+	usec_t run_usec;
+	usec_t run_since;
+
 	bool is_running : 1;
 	bool is_writer : 1;
 	/* In some places, we use fibril structs that can't be freed. */
@@ -76,7 +115,22 @@ struct fibril {
 extern fibril_t *fibril_alloc(void);
 extern void fibril_setup(fibril_t *);
 extern void fibril_teardown(fibril_t *f);
-extern fibril_t *fibril_self(void);
+extern void fibril_bind_runner(fibril_t *);
+extern void fibril_keys_release(void);
+extern void fibril_rcu_thread_register(fibril_rcu_thread_t *);
+extern void fibril_rcu_thread_unregister(fibril_rcu_thread_t *);
+
+extern void __fibril_accounting_set(bool);
+extern usec_t __fibril_run_usec(void);
+
+/** @return the currently running fibril. */
+static inline fibril_t *fibril_self(void)
+{
+	assert(__tcb_is_set());
+	tcb_t *tcb = __tcb_get();
+	assert(tcb->fibril_data);
+	return tcb->fibril_data;
+}
 
 extern void __fibrils_init(void);
 extern void __fibrils_fini(void);
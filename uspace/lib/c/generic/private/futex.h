@@ -44,10 +44,22 @@
 #include <abi/cap.h>
 #include <abi/synch.h>
 
+/** Contention statistics of a futex used as a lock. */
+typedef struct {
+	/** Number of futex_lock() calls which found the futex locked. */
+	atomic_uint contended;
+	/** Number of those which then acquired the futex by spinning. */
+	atomic_uint spun;
+} futex_stats_t;
+
 typedef struct futex {
 	volatile atomic_int val;
 	volatile cap_waitq_handle_t whandle;
 
+	/** Thread holding the futex locked by futex_lock(), 0 if unknown. */
+	_Atomic(sysarg_t) holder;
+	futex_stats_t stats;
+
 #ifdef CONFIG_DEBUG_FUTEX
 	_Atomic(fibril_t *) owner;
 #endif
@@ -55,6 +67,13 @@ typedef struct futex {
 
 extern errno_t futex_initialize(futex_t *futex, int value);
 
+extern void __futex_acquire(futex_t *);
+extern bool __futex_tryacquire(futex_t *);
+extern void __futex_release(futex_t *);
+extern void __futex_stats_print(futex_t *, const char *);
+
+#define futex_stats_print(futex) __futex_stats_print((futex), #futex)
+
 static inline errno_t futex_destroy(futex_t *futex)
 {
 	if (futex->whandle) {
@@ -85,9 +104,9 @@ void __futex_give_to(futex_t *, void *, const char *);
 
 #else
 
-#define futex_lock(fut)     (void) futex_down((fut))
-#define futex_trylock(fut)  futex_trydown((fut))
-#define futex_unlock(fut)   (void) futex_up((fut))
+#define futex_lock(fut)     __futex_acquire((fut))
+#define futex_trylock(fut)  __futex_tryacquire((fut))
+#define futex_unlock(fut)   __futex_release((fut))
 
 #define futex_give_to(fut, owner) ((void)0)
 #define futex_assert_is_locked(fut) assert(atomic_load_explicit(&(fut)->val, memory_order_relaxed) <= 0)
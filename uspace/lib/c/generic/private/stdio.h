@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <async.h>
 #include <stddef.h>
+#include <vfs/vfs.h>
 
 /** Maximum characters that can be pushed back by ungetc() */
 #define UNGETC_MAX 1
@@ -54,6 +55,36 @@ typedef struct {
 	int (*flush)(FILE *stream);
 } __stream_ops_t;
 
+/** Asynchronous I/O state of a VFS stream */
+typedef struct {
+	/** Access pattern hint (FADV_xxx) */
+	int advice;
+	/** Stream position right after the previous buffer fill */
+	aoff64_t next_pos;
+	/** Number of consecutive buffer fills continuing the previous one */
+	unsigned int seq;
+
+	/** Read ahead request is in progress */
+	bool ra_pending;
+	/** Position the read ahead request reads from */
+	aoff64_t ra_pos;
+	/** Read ahead request */
+	vfs_aio_t ra;
+	/** Read ahead buffer of buf_size bytes */
+	uint8_t *ra_buf;
+
+	/** Write behind request is in progress */
+	bool wb_pending;
+	/** Write behind request */
+	vfs_aio_t wb;
+	/** Bytes submitted by the write behind request */
+	size_t wb_size;
+	/** Position the write behind request writes to */
+	aoff64_t wb_pos;
+	/** Write behind buffer of buf_size bytes */
+	uint8_t *wb_buf;
+} __stream_aio_t;
+
 struct _IO_FILE {
 	/** Linked list pointer. */
 	link_t link;
@@ -108,6 +139,12 @@ struct _IO_FILE {
 
 	/** Number of pushed back characters */
 	int ungetc_chars;
+
+	/** Read ahead and write behind state, allocated on first use */
+	__stream_aio_t *aio;
+
+	/** I/O on the stream is never asynchronous */
+	bool aio_disabled;
 };
 
 #endif
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#include <libc.h>
+#include <stddef.h>
+#include <profile.h>
+
+/** Start taking kernel profiler samples
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t profile_start(void)
+{
+	return (errno_t) __SYSCALL1(SYS_PROFILE, PROFILE_START);
+}
+
+/** Stop taking kernel profiler samples
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+errno_t profile_stop(void)
+{
+	return (errno_t) __SYSCALL1(SYS_PROFILE, PROFILE_STOP);
+}
+
+/** Get the name of the kernel function containing an address
+ *
+ * @param addr Kernel address.
+ * @param name Buffer for the function name.
+ * @param size Size of the buffer.
+ *
+ * @return EOK on success, ENOENT if there is no such function,
+ *         EOVERFLOW if the buffer is too small, ENOTSUP if the kernel
+ *         has no symbol table.
+ *
+ */
+errno_t profile_kernel_symbol(uintptr_t addr, char *name, size_t size)
+{
+	return (errno_t) __SYSCALL4(SYS_PROFILE, PROFILE_SYMBOL,
+	    (sysarg_t) addr, (sysarg_t) name, (sysarg_t) size);
+}
+
+/** @}
+ */
@@ -33,11 +33,34 @@
 /**
  * @file
  * @brief Quicksort.
+ *
+ * Pattern-defeating quicksort: introsort with ninther pivot selection,
+ * an insertion sort cutoff for short ranges, detection of ranges that
+ * are already sorted, special handling of runs of equal keys and
+ * a heapsort fallback which bounds the worst case to O(n log n).
  */
 
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <qsort.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+enum {
+	/** Ranges shorter than this are sorted using insertion sort */
+	insertion_threshold = 16,
+	/** Ranges longer than this use the ninther for pivot selection */
+	ninther_threshold = 128,
+	/** Maximum number of element moves in a partial insertion sort */
+	partial_insertion_limit = 8,
+	/** Ranges longer than this are handed off to another fibril */
+	parallel_threshold = 16384
+};
+
+struct qs_par;
 
 /** Quicksort spec */
 typedef struct {
@@ -46,8 +69,33 @@ typedef struct {
 	size_t size;
 	int (*compar)(const void *, const void *, void *);
 	void *arg;
+	/** Elements can be swapped one machine word at a time */
+	bool word_swap;
+	/** Parallel sort state or @c NULL when sorting sequentially */
+	struct qs_par *par;
 } qs_spec_t;
 
+/** Parallel quicksort state */
+typedef struct qs_par {
+	/** Protects @c pending */
+	fibril_mutex_t lock;
+	/** Signalled when @c pending drops to zero */
+	fibril_condvar_t done_cv;
+	/** Number of outstanding sorting fibrils */
+	size_t pending;
+} qs_par_t;
+
+/** Parallel quicksort task */
+typedef struct {
+	qs_spec_t *qs;
+	size_t lo;
+	size_t hi;
+	unsigned bad_allowed;
+	bool leftmost;
+} qs_task_t;
+
+static void pdqsort_loop(qs_spec_t *, size_t, size_t, unsigned, bool);
+
 /** Comparison function wrapper.
  *
  * Performs qsort_r comparison using qsort comparison function
@@ -92,75 +140,407 @@ static bool elem_lt(qs_spec_t *qs, size_t i, size_t j)
  */
 static void elem_swap(qs_spec_t *qs, size_t i, size_t j)
 {
-	char *a;
-	char *b;
-	char t;
 	size_t k;
 
-	a = qs->base + i * qs->size;
-	b = qs->base + j * qs->size;
+	if (qs->word_swap) {
+		unsigned long *a = qs->base + i * qs->size;
+		unsigned long *b = qs->base + j * qs->size;
+		unsigned long t;
+
+		for (k = 0; k < qs->size / sizeof(unsigned long); k++) {
+			t = a[k];
+			a[k] = b[k];
+			b[k] = t;
+		}
+	} else {
+		char *a = qs->base + i * qs->size;
+		char *b = qs->base + j * qs->size;
+		char t;
 
-	for (k = 0; k < qs->size; k++) {
-		t = a[k];
-		a[k] = b[k];
-		b[k] = t;
+		for (k = 0; k < qs->size; k++) {
+			t = a[k];
+			a[k] = b[k];
+			b[k] = t;
+		}
 	}
 }
 
-/** Partition a range of indices.
+/** Order three elements so that they are non-decreasing.
+ *
+ * @param qs Quicksort spec
+ * @param a First element index
+ * @param b Second element index
+ * @param c Third element index
+ */
+static void sort3(qs_spec_t *qs, size_t a, size_t b, size_t c)
+{
+	if (elem_lt(qs, b, a))
+		elem_swap(qs, a, b);
+	if (elem_lt(qs, c, b))
+		elem_swap(qs, b, c);
+	if (elem_lt(qs, b, a))
+		elem_swap(qs, a, b);
+}
+
+/** Sort a range of indices using insertion sort.
  *
  * @param qs Quicksort spec
  * @param lo Lower bound (inclusive)
- * @param hi Upper bound (inclusive)
- * @return Pivot index
+ * @param hi Upper bound (exclusive)
  */
-static size_t partition(qs_spec_t *qs, size_t lo, size_t hi)
+static void insertion_sort(qs_spec_t *qs, size_t lo, size_t hi)
 {
-	size_t pivot;
 	size_t i, j;
 
-	pivot = lo + (hi - lo) / 2;
-	i = lo;
-	j = hi;
-	while (true) {
-		while (elem_lt(qs, i, pivot))
-			++i;
-		while (elem_lt(qs, pivot, j))
-			--j;
+	for (i = lo + 1; i < hi; i++) {
+		for (j = i; j > lo && elem_lt(qs, j, j - 1); j--)
+			elem_swap(qs, j, j - 1);
+	}
+}
 
-		if (i >= j)
-			return j;
+/** Attempt to sort a range of indices using insertion sort.
+ *
+ * Gives up as soon as more than @c partial_insertion_limit element
+ * moves have been made. This quickly finishes off ranges that are
+ * already (nearly) sorted.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ * @return @c true if the range is now sorted
+ */
+static bool partial_insertion_sort(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t moves = 0;
+	size_t i, j;
+
+	for (i = lo + 1; i < hi; i++) {
+		for (j = i; j > lo && elem_lt(qs, j, j - 1); j--) {
+			if (++moves > partial_insertion_limit)
+				return false;
+			elem_swap(qs, j, j - 1);
+		}
+	}
+
+	return true;
+}
+
+/** Restore the max-heap property below a node.
+ *
+ * @param qs Quicksort spec
+ * @param lo Index of the heap root
+ * @param node Offset of the node from @a lo
+ * @param n Number of elements in the heap
+ */
+static void sift_down(qs_spec_t *qs, size_t lo, size_t node, size_t n)
+{
+	size_t child;
+
+	while ((child = 2 * node + 1) < n) {
+		if (child + 1 < n && elem_lt(qs, lo + child, lo + child + 1))
+			child++;
+		if (!elem_lt(qs, lo + node, lo + child))
+			break;
+		elem_swap(qs, lo + node, lo + child);
+		node = child;
+	}
+}
 
+/** Sort a range of indices using heapsort.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ */
+static void heap_sort(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t n = hi - lo;
+	size_t i;
+
+	for (i = n / 2; i > 0; i--)
+		sift_down(qs, lo, i - 1, n);
+
+	for (i = n - 1; i > 0; i--) {
+		elem_swap(qs, lo, lo + i);
+		sift_down(qs, lo, 0, i);
+	}
+}
+
+/** Partition a range around the pivot at its lower bound.
+ *
+ * Elements equal to the pivot end up on the right. The caller must
+ * guarantee that the range contains an element not less than the pivot
+ * other than the pivot itself, which median-of-three selection does.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive), holds the pivot
+ * @param hi Upper bound (exclusive)
+ * @param already Place to store @c true if no elements were moved
+ * @return Final pivot index
+ */
+static size_t partition_right(qs_spec_t *qs, size_t lo, size_t hi,
+    bool *already)
+{
+	size_t i = lo;
+	size_t j = hi;
+
+	/* Find first element not less than pivot */
+	while (elem_lt(qs, ++i, lo))
+		;
+
+	/* Find last element less than pivot */
+	if (i - 1 == lo) {
+		while (i < j && !elem_lt(qs, --j, lo))
+			;
+	} else {
+		while (!elem_lt(qs, --j, lo))
+			;
+	}
+
+	*already = i >= j;
+
+	while (i < j) {
+		elem_swap(qs, i, j);
+		while (elem_lt(qs, ++i, lo))
+			;
+		while (!elem_lt(qs, --j, lo))
+			;
+	}
+
+	elem_swap(qs, lo, i - 1);
+	return i - 1;
+}
+
+/** Partition a range around the pivot at its lower bound.
+ *
+ * Elements equal to the pivot end up on the left. This is used when
+ * the pivot is equal to the element preceding the range, i.e. no
+ * element in the range is less than the pivot.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive), holds the pivot
+ * @param hi Upper bound (exclusive)
+ * @return Final pivot index
+ */
+static size_t partition_left(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t i = lo;
+	size_t j = hi;
+
+	while (elem_lt(qs, lo, --j))
+		;
+
+	if (j + 1 == hi) {
+		while (i < j && !elem_lt(qs, lo, ++i))
+			;
+	} else {
+		while (!elem_lt(qs, lo, ++i))
+			;
+	}
+
+	while (i < j) {
 		elem_swap(qs, i, j);
+		while (elem_lt(qs, lo, --j))
+			;
+		while (!elem_lt(qs, lo, ++i))
+			;
+	}
+
+	elem_swap(qs, lo, j);
+	return j;
+}
 
-		/* Need to follow pivot movement */
-		if (i == pivot)
-			pivot = j;
-		else if (j == pivot)
-			pivot = i;
+/** Break up a pattern that led to an unbalanced partition.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ */
+static void break_pattern(qs_spec_t *qs, size_t lo, size_t hi)
+{
+	size_t n = hi - lo;
+
+	if (n < insertion_threshold)
+		return;
+
+	elem_swap(qs, lo, lo + n / 4);
+	elem_swap(qs, hi - 1, hi - n / 4);
+
+	if (n > ninther_threshold) {
+		elem_swap(qs, lo + 1, lo + n / 4 + 1);
+		elem_swap(qs, lo + 2, lo + n / 4 + 2);
+		elem_swap(qs, hi - 2, hi - n / 4 - 1);
+		elem_swap(qs, hi - 3, hi - n / 4 - 2);
+	}
+}
+
+/** Parallel quicksort task fibril.
+ *
+ * @param arg Quicksort task (qs_task_t *)
+ * @return EOK
+ */
+static errno_t qs_task_fibril(void *arg)
+{
+	qs_task_t *task = (qs_task_t *)arg;
+	qs_par_t *par = task->qs->par;
+
+	pdqsort_loop(task->qs, task->lo, task->hi, task->bad_allowed,
+	    task->leftmost);
+	free(task);
+
+	fibril_mutex_lock(&par->lock);
+	if (--par->pending == 0)
+		fibril_condvar_broadcast(&par->done_cv);
+	fibril_mutex_unlock(&par->lock);
+
+	return EOK;
+}
 
-		i++;
-		j--;
+/** Sort a subrange, possibly in a new fibril.
+ *
+ * @param qs Quicksort spec
+ * @param lo Lower bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ * @param bad_allowed Number of unbalanced partitions allowed
+ * @param leftmost @c true if @a lo is the start of the array
+ */
+static void pdqsort_sub(qs_spec_t *qs, size_t lo, size_t hi,
+    unsigned bad_allowed, bool leftmost)
+{
+	qs_task_t *task;
+	fid_t fid;
+
+	if (qs->par == NULL || hi - lo < parallel_threshold)
+		goto seq;
+
+	task = malloc(sizeof(qs_task_t));
+	if (task == NULL)
+		goto seq;
+
+	task->qs = qs;
+	task->lo = lo;
+	task->hi = hi;
+	task->bad_allowed = bad_allowed;
+	task->leftmost = leftmost;
+
+	fid = fibril_create(qs_task_fibril, task);
+	if (fid == 0) {
+		free(task);
+		goto seq;
 	}
+
+	fibril_mutex_lock(&qs->par->lock);
+	qs->par->pending++;
+	fibril_mutex_unlock(&qs->par->lock);
+
+	fibril_add_ready(fid);
+	return;
+seq:
+	pdqsort_loop(qs, lo, hi, bad_allowed, leftmost);
 }
 
 /** Sort a range of indices.
+ *
+ * The smaller side of each partition is sorted recursively, the larger
+ * one iteratively, so the recursion depth is at most log2(n).
  *
  * @param qs Quicksort spec
  * @param lo Lower bound (inclusive)
- * @param hi Upper bound (inclusive)
+ * @param hi Upper bound (exclusive)
+ * @param bad_allowed Number of unbalanced partitions allowed before
+ *                    falling back to heapsort
+ * @param leftmost @c true if @a lo is the start of the array
  */
-static void quicksort(qs_spec_t *qs, size_t lo, size_t hi)
+static void pdqsort_loop(qs_spec_t *qs, size_t lo, size_t hi,
+    unsigned bad_allowed, bool leftmost)
 {
-	size_t p;
+	size_t n, mid, p;
+	size_t l_size, r_size;
+	bool already;
+	bool unbalanced;
+
+	while (true) {
+		n = hi - lo;
+
+		if (n < insertion_threshold) {
+			insertion_sort(qs, lo, hi);
+			return;
+		}
+
+		/* Move the pivot to lo */
+		mid = lo + n / 2;
+		if (n > ninther_threshold) {
+			sort3(qs, lo, mid, hi - 1);
+			sort3(qs, lo + 1, mid - 1, hi - 2);
+			sort3(qs, lo + 2, mid + 1, hi - 3);
+			sort3(qs, mid - 1, mid, mid + 1);
+			elem_swap(qs, lo, mid);
+		} else {
+			sort3(qs, mid, lo, hi - 1);
+		}
+
+		/*
+		 * If the pivot is equal to the element preceding the range
+		 * (which is not greater than any element in the range), put
+		 * all elements equal to the pivot to the left and skip them.
+		 */
+		if (!leftmost && !elem_lt(qs, lo - 1, lo)) {
+			lo = partition_left(qs, lo, hi) + 1;
+			continue;
+		}
+
+		p = partition_right(qs, lo, hi, &already);
+		l_size = p - lo;
+		r_size = hi - (p + 1);
+		unbalanced = l_size < n / 8 || r_size < n / 8;
+
+		if (unbalanced) {
+			if (--bad_allowed == 0) {
+				heap_sort(qs, lo, hi);
+				return;
+			}
 
-	if (lo < hi) {
-		p = partition(qs, lo, hi);
-		quicksort(qs, lo, p);
-		quicksort(qs, p + 1, hi);
+			break_pattern(qs, lo, p);
+			break_pattern(qs, p + 1, hi);
+		} else if (already) {
+			/* Partition did not move anything, range may be sorted */
+			if (partial_insertion_sort(qs, lo, p) &&
+			    partial_insertion_sort(qs, p + 1, hi))
+				return;
+		}
+
+		if (l_size < r_size) {
+			pdqsort_sub(qs, lo, p, bad_allowed, leftmost);
+			lo = p + 1;
+			leftmost = false;
+		} else {
+			pdqsort_sub(qs, p + 1, hi, bad_allowed, false);
+			hi = p;
+		}
 	}
 }
 
+/** Sort an array.
+ *
+ * @param qs Quicksort spec
+ */
+static void quicksort(qs_spec_t *qs)
+{
+	unsigned log2n = 0;
+	size_t n;
+
+	if (qs->nmemb < 2)
+		return;
+
+	qs->word_swap = ((uintptr_t)qs->base % sizeof(unsigned long)) == 0 &&
+	    (qs->size % sizeof(unsigned long)) == 0;
+
+	for (n = qs->nmemb; n > 1; n >>= 1)
+		log2n++;
+
+	pdqsort_loop(qs, 0, qs->nmemb, log2n, true);
+}
+
 /** Quicksort.
  *
  * @param base Array to sort
@@ -173,16 +553,14 @@ void qsort(void *base, size_t nmemb, size_t size, int (*compar)(const void *,
 {
 	qs_spec_t qs;
 
-	if (nmemb == 0)
-		return;
-
 	qs.base = base;
 	qs.nmemb = nmemb;
 	qs.size = size;
 	qs.compar = compar_wrap;
 	qs.arg = compar;
+	qs.par = NULL;
 
-	quicksort(&qs, 0, nmemb - 1);
+	quicksort(&qs);
 }
 
 /** Quicksort with extra argument to comparison function.
@@ -198,16 +576,58 @@ void qsort_r(void *base, size_t nmemb, size_t size, int (*compar)(const void *,
 {
 	qs_spec_t qs;
 
-	if (nmemb == 0)
-		return;
+	qs.base = base;
+	qs.nmemb = nmemb;
+	qs.size = size;
+	qs.compar = compar;
+	qs.arg = arg;
+	qs.par = NULL;
+
+	quicksort(&qs);
+}
+
+/** Parallel quicksort.
+ *
+ * Works like qsort_r(), but large partitions are sorted by separate
+ * fibrils. The sort only runs in parallel if the task has additional
+ * fibril runner threads, otherwise the fibrils are simply interleaved
+ * with the caller. The comparison function must be safe to call from
+ * several threads at once.
+ *
+ * @param base Array to sort
+ * @param nmemb Number of array members
+ * @param size Size of member in bytes
+ * @param compar Comparison function
+ * @param arg Argument to comparison function
+ */
+void qsort_parallel(void *base, size_t nmemb, size_t size,
+    int (*compar)(const void *, const void *, void *), void *arg)
+{
+	qs_spec_t qs;
+	qs_par_t par;
 
 	qs.base = base;
 	qs.nmemb = nmemb;
 	qs.size = size;
 	qs.compar = compar;
 	qs.arg = arg;
+	qs.par = NULL;
 
-	quicksort(&qs, 0, nmemb - 1);
+	if (nmemb >= 2 * parallel_threshold) {
+		fibril_mutex_initialize(&par.lock);
+		fibril_condvar_initialize(&par.done_cv);
+		par.pending = 0;
+		qs.par = &par;
+	}
+
+	quicksort(&qs);
+
+	if (qs.par != NULL) {
+		fibril_mutex_lock(&par.lock);
+		while (par.pending > 0)
+			fibril_condvar_wait(&par.done_cv, &par.lock);
+		fibril_mutex_unlock(&par.lock);
+	}
 }
 
 /** @}
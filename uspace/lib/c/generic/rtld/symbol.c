@@ -34,6 +34,8 @@
  * @file
  */
 
+#include <adt/hash_table.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -44,6 +46,30 @@
 #include <rtld/rtld_debug.h>
 #include <rtld/symbol.h>
 
+/** Symbol lookup key */
+typedef struct {
+	/** Symbol name */
+	const char *name;
+	/** GNU hash of the name */
+	elf_word gnu_hash;
+	/** SysV hash of the name (only valid if @c sysv_valid is @c true) */
+	elf_word sysv_hash;
+	bool sysv_valid;
+} symbol_key_t;
+
+/** Resolved symbol cache entry */
+typedef struct {
+	ht_link_t link;
+	/** Symbol name (points into the string table of some module) */
+	const char *name;
+	elf_word gnu_hash;
+	symbol_search_flags_t flags;
+	/** Symbol definition */
+	elf_symbol_t *sym;
+	/** Module containing the definition */
+	module_t *mod;
+} symbol_cache_entry_t;
+
 /*
  * Hash tables are 32-bit (elf_word) even for 64-bit ELF files.
  */
@@ -62,38 +88,128 @@ static elf_word elf_hash(const unsigned char *name)
 	return h;
 }
 
-static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
+/** Compute the hash function used by DT_GNU_HASH tables. */
+static elf_word elf_gnu_hash(const unsigned char *name)
+{
+	elf_word h = 5381;
+
+	while (*name)
+		h = (h << 5) + h + *name++;
+
+	return h;
+}
+
+static void symbol_key_init(symbol_key_t *key, const char *name)
+{
+	key->name = name;
+	key->gnu_hash = elf_gnu_hash((const unsigned char *)name);
+	key->sysv_valid = false;
+}
+
+/** Look up a symbol in a module's DT_GNU_HASH table.
+ *
+ * The table consists of a header, a Bloom filter with two bits set
+ * per symbol, the buckets and the hash chains. The Bloom filter
+ * rejects most of the modules not defining the symbol without
+ * touching the buckets or the symbol table.
+ */
+static elf_symbol_t *gnu_hash_find(symbol_key_t *key, module_t *m)
+{
+	elf_word *gh = m->dyn.gnu_hash;
+	elf_word nbuckets = gh[0];
+	elf_word symoffset = gh[1];
+	elf_word bloom_size = gh[2];
+	elf_word bloom_shift = gh[3];
+	const uintptr_t *bloom = (const uintptr_t *) &gh[4];
+	const elf_word *buckets = (const elf_word *) &bloom[bloom_size];
+	const elf_word *chain = &buckets[nbuckets];
+	const size_t bits = sizeof(uintptr_t) * 8;
+	elf_symbol_t *sym_table = m->dyn.sym_tab;
+	elf_word h = key->gnu_hash;
+	uintptr_t word;
+	uintptr_t mask;
+	elf_word ch;
+	elf_word i;
+
+	if (nbuckets == 0 || bloom_size == 0)
+		return NULL;
+
+	word = bloom[(h / bits) % bloom_size];
+	mask = ((uintptr_t) 1 << (h % bits)) |
+	    ((uintptr_t) 1 << ((h >> bloom_shift) % bits));
+	if ((word & mask) != mask)
+		return NULL;
+
+	i = buckets[h % nbuckets];
+	if (i < symoffset)
+		return NULL;
+
+	while (true) {
+		ch = chain[i - symoffset];
+
+		/* The lowest bit marks the end of the chain */
+		if ((ch | 1) == (h | 1) && str_cmp(key->name,
+		    m->dyn.str_tab + sym_table[i].st_name) == 0)
+			return &sym_table[i];
+
+		if ((ch & 1) != 0)
+			break;
+
+		++i;
+	}
+
+	return NULL;
+}
+
+/** Look up a symbol in a module's SysV DT_HASH table. */
+static elf_symbol_t *sysv_hash_find(symbol_key_t *key, module_t *m)
 {
 	elf_symbol_t *sym_table;
-	elf_symbol_t *s, *sym;
+	elf_symbol_t *s;
 	elf_word nbucket;
 	/*elf_word nchain;*/
 	elf_word i;
 	char *s_name;
 	elf_word bucket;
 
-	DPRINTF("def_find_in_module('%s', %s)\n", name, m->dyn.soname);
+	if (!key->sysv_valid) {
+		key->sysv_hash = elf_hash((const unsigned char *)key->name);
+		key->sysv_valid = true;
+	}
 
 	sym_table = m->dyn.sym_tab;
 	nbucket = m->dyn.hash[0];
 	/*nchain = m->dyn.hash[1]; XXX Use to check HT range*/
 
-	bucket = elf_hash((unsigned char *)name) % nbucket;
+	bucket = key->sysv_hash % nbucket;
 	i = m->dyn.hash[2 + bucket];
 
-	sym = NULL;
 	while (i != STN_UNDEF) {
 		s = &sym_table[i];
 		s_name = m->dyn.str_tab + s->st_name;
 
-		if (str_cmp(name, s_name) == 0) {
-			sym = s;
-			break;
-		}
+		if (str_cmp(key->name, s_name) == 0)
+			return s;
 
 		i = m->dyn.hash[2 + nbucket + i];
 	}
 
+	return NULL;
+}
+
+static elf_symbol_t *def_find_in_module(symbol_key_t *key, module_t *m)
+{
+	elf_symbol_t *sym;
+
+	DPRINTF("def_find_in_module('%s', %s)\n", key->name, m->dyn.soname);
+
+	if (m->dyn.gnu_hash != NULL)
+		sym = gnu_hash_find(key, m);
+	else if (m->dyn.hash != NULL)
+		sym = sysv_hash_find(key, m);
+	else
+		sym = NULL;
+
 	if (!sym)
 		return NULL;	/* Not found */
 
@@ -105,6 +221,101 @@ static elf_symbol_t *def_find_in_module(const char *name, module_t *m)
 	return sym; /* Found */
 }
 
+static size_t symbol_cache_hash(const ht_link_t *item)
+{
+	symbol_cache_entry_t *e =
+	    hash_table_get_inst(item, symbol_cache_entry_t, link);
+	return e->gnu_hash ^ e->flags;
+}
+
+static size_t symbol_cache_key_hash(const void *key)
+{
+	const symbol_cache_entry_t *k = key;
+	return k->gnu_hash ^ k->flags;
+}
+
+static bool symbol_cache_key_equal(const void *key, const ht_link_t *item)
+{
+	const symbol_cache_entry_t *k = key;
+	symbol_cache_entry_t *e =
+	    hash_table_get_inst(item, symbol_cache_entry_t, link);
+
+	return k->gnu_hash == e->gnu_hash && k->flags == e->flags &&
+	    str_cmp(k->name, e->name) == 0;
+}
+
+static bool symbol_cache_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	symbol_cache_entry_t *e1 =
+	    hash_table_get_inst(item1, symbol_cache_entry_t, link);
+
+	return symbol_cache_key_equal(e1, item2);
+}
+
+static hash_table_ops_t symbol_cache_ops = {
+	.hash = symbol_cache_hash,
+	.key_hash = symbol_cache_key_hash,
+	.equal = symbol_cache_equal,
+	.key_equal = symbol_cache_key_equal,
+	.remove_callback = NULL
+};
+
+/** Look up a symbol in the resolved symbol cache.
+ *
+ * @return Cache entry or @c NULL if the symbol is not cached.
+ */
+static symbol_cache_entry_t *symbol_cache_find(rtld_t *rtld,
+    symbol_key_t *key, symbol_search_flags_t flags)
+{
+	symbol_cache_entry_t k;
+	ht_link_t *link;
+
+	if (!rtld->sym_cache_ready)
+		return NULL;
+
+	k.name = key->name;
+	k.gnu_hash = key->gnu_hash;
+	k.flags = flags;
+
+	link = hash_table_find(&rtld->sym_cache, &k);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, symbol_cache_entry_t, link);
+}
+
+/** Remember a symbol found in the global modules.
+ *
+ * Modules are only ever appended to the list of loaded modules
+ * and never removed, so a symbol found in the global modules
+ * keeps resolving to the same definition. Failure to allocate
+ * the cache is not an error, the symbol is just not cached.
+ */
+static void symbol_cache_insert(rtld_t *rtld, symbol_key_t *key,
+    symbol_search_flags_t flags, elf_symbol_t *sym, module_t *mod)
+{
+	symbol_cache_entry_t *e;
+
+	if (!rtld->sym_cache_ready) {
+		if (!hash_table_create(&rtld->sym_cache, 0, 0,
+		    &symbol_cache_ops))
+			return;
+		rtld->sym_cache_ready = true;
+	}
+
+	e = malloc(sizeof(symbol_cache_entry_t));
+	if (e == NULL)
+		return;
+
+	e->name = key->name;
+	e->gnu_hash = key->gnu_hash;
+	e->flags = flags;
+	e->sym = sym;
+	e->mod = mod;
+
+	hash_table_insert(&rtld->sym_cache, &e->link);
+}
+
 /** Find the definition of a symbol in a module and its deps.
  *
  * Search the module dependency graph is breadth-first, beginning
@@ -121,9 +332,12 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 {
 	module_t *m, *dm;
 	elf_symbol_t *sym, *s;
+	symbol_key_t key;
 	list_t queue;
 	size_t i;
 
+	symbol_key_init(&key, name);
+
 	/*
 	 * Do a BFS using the queue_link and bfs_tag fields.
 	 * Vertices (modules) are tagged the moment they are inserted
@@ -149,7 +363,7 @@ elf_symbol_t *symbol_bfs_find(const char *name, module_t *start,
 		list_remove(&m->queue_link);
 
 		/* If ssf_noroot is specified, do not look in start module */
-		s = def_find_in_module(name, m);
+		s = def_find_in_module(&key, m);
 		if (s != NULL) {
 			/* Symbol found */
 			sym = s;
@@ -199,16 +413,21 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
     symbol_search_flags_t flags, module_t **mod)
 {
 	elf_symbol_t *s;
+	symbol_key_t key;
+	symbol_cache_entry_t *ce;
 
 	DPRINTF("symbol_def_find('%s', origin='%s'\n",
 	    name, origin->dyn.soname);
+
+	symbol_key_init(&key, name);
+
 	if (origin->dyn.symbolic && (!origin->exec || (flags & ssf_noexec) == 0)) {
 		DPRINTF("symbolic->find '%s' in module '%s'\n", name, origin->dyn.soname);
 		/*
 		 * Origin module has a DT_SYMBOLIC flag.
 		 * Try this module first
 		 */
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -218,13 +437,22 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 
 	/* Not DT_SYMBOLIC or no match. Now try other locations. */
 
+	ce = symbol_cache_find(origin->rtld, &key, flags);
+	if (ce != NULL) {
+		DPRINTF("'%s' found in cache\n", name);
+		*mod = ce->mod;
+		return ce->sym;
+	}
+
 	list_foreach(origin->rtld->modules, modules_link, module_t, m) {
 		DPRINTF("module '%s' local?\n", m->dyn.soname);
 		if (!m->local && (!m->exec || (flags & ssf_noexec) == 0)) {
 			DPRINTF("!local->find '%s' in module '%s'\n", name, m->dyn.soname);
-			s = def_find_in_module(name, m);
+			s = def_find_in_module(&key, m);
 			if (s != NULL) {
 				/* Found */
+				symbol_cache_insert(origin->rtld, &key, flags,
+				    s, m);
 				*mod = m;
 				return s;
 			}
@@ -237,7 +465,7 @@ elf_symbol_t *symbol_def_find(const char *name, module_t *origin,
 	    origin->dyn.soname);
 
 	if (!origin->exec || (flags & ssf_noexec) == 0) {
-		s = def_find_in_module(name, origin);
+		s = def_find_in_module(&key, origin);
 		if (s != NULL) {
 			/* Found */
 			*mod = origin;
@@ -104,6 +104,33 @@ stats_physmem_t *stats_get_physmem(void)
 	return stats_physmem;
 }
 
+/** Get physical memory statistics of the memory nodes
+ *
+ * @param count Number of records returned.
+ *
+ * @return Array of stats_physmem_node_t structures.
+ *         If non-NULL then it should be eventually freed
+ *         by free().
+ *
+ */
+stats_physmem_node_t *stats_get_physmem_nodes(size_t *count)
+{
+	size_t size = 0;
+	stats_physmem_node_t *stats_nodes =
+	    (stats_physmem_node_t *) sysinfo_get_data("system.physmem_nodes",
+	    &size);
+
+	if ((size % sizeof(stats_physmem_node_t)) != 0) {
+		if (stats_nodes != NULL)
+			free(stats_nodes);
+		*count = 0;
+		return NULL;
+	}
+
+	*count = size / sizeof(stats_physmem_node_t);
+	return stats_nodes;
+}
+
 /** Get task statistics
  *
  * @param count Number of records returned.
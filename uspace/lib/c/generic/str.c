@@ -137,6 +137,107 @@
 /** Number of data bits in a UTF-8 continuation byte */
 #define CONT_BITS  6
 
+/** Word which may alias any other type. */
+typedef unsigned long __attribute__((may_alias)) str_word_t;
+
+/** Word with every byte equal to one */
+#define WORD_ONES  (((str_word_t) -1) / 0xff)
+
+/** Word with the highest bit of every byte set */
+#define WORD_HIGHS  (WORD_ONES * 0x80)
+
+/** Non-zero iff some byte of the word @a w is zero */
+#define WORD_HAS_ZERO(w)  (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+
+/** Skip plain ASCII characters.
+ *
+ * Find the first byte at or after @a off which is zero, equal to @a stop,
+ * not plain ASCII or at @a size. Every skipped byte is a complete character,
+ * so the result is a character boundary if @a off is one. Aligned words are
+ * examined at once; such reads never cross a page boundary.
+ *
+ * @param str  String.
+ * @param off  Byte offset where to start.
+ * @param size Size of the string (in bytes).
+ * @param stop Additional ASCII byte value to stop at (0 for none).
+ *
+ * @return Byte offset of the first byte not skipped.
+ *
+ */
+static size_t str_ascii_skip(const char *str, size_t off, size_t size,
+    uint8_t stop)
+{
+	const uint8_t *u = (const uint8_t *) str;
+	str_word_t pattern = WORD_ONES * stop;
+	str_word_t w;
+
+	while ((off < size) && (((uintptr_t) &u[off] % sizeof(str_word_t)) != 0)) {
+		if ((u[off] == 0) || (u[off] == stop) || ((u[off] & 0x80) != 0))
+			return off;
+		off++;
+	}
+
+	while (size - off >= sizeof(str_word_t)) {
+		w = *(const str_word_t *) &u[off];
+		if (((w & WORD_HIGHS) != 0) || (WORD_HAS_ZERO(w) != 0) ||
+		    (WORD_HAS_ZERO(w ^ pattern) != 0))
+			break;
+		off += sizeof(str_word_t);
+	}
+
+	while ((off < size) && (u[off] != 0) && (u[off] != stop) &&
+	    ((u[off] & 0x80) == 0))
+		off++;
+
+	return off;
+}
+
+/** Skip common plain ASCII prefix of two strings.
+ *
+ * Find the first byte offset where the strings differ, either of them
+ * contains a zero or non-ASCII byte, or which is equal to @a max_len.
+ * The result is a character boundary in both strings.
+ *
+ * @param s1      First string.
+ * @param s2      Second string.
+ * @param max_len Maximum number of bytes to consider.
+ *
+ * @return Size of the common prefix.
+ *
+ */
+static size_t str_ascii_common(const char *s1, const char *s2, size_t max_len)
+{
+	const uint8_t *u1 = (const uint8_t *) s1;
+	const uint8_t *u2 = (const uint8_t *) s2;
+	size_t off = 0;
+	str_word_t w;
+
+	if (((uintptr_t) u1 % sizeof(str_word_t)) ==
+	    ((uintptr_t) u2 % sizeof(str_word_t))) {
+		while ((off < max_len) &&
+		    (((uintptr_t) &u1[off] % sizeof(str_word_t)) != 0)) {
+			if ((u1[off] != u2[off]) || (u1[off] == 0) ||
+			    ((u1[off] & 0x80) != 0))
+				return off;
+			off++;
+		}
+
+		while (max_len - off >= sizeof(str_word_t)) {
+			w = *(const str_word_t *) &u1[off];
+			if ((w != *(const str_word_t *) &u2[off]) ||
+			    ((w & WORD_HIGHS) != 0) || (WORD_HAS_ZERO(w) != 0))
+				break;
+			off += sizeof(str_word_t);
+		}
+	}
+
+	while ((off < max_len) && (u1[off] == u2[off]) && (u1[off] != 0) &&
+	    ((u1[off] & 0x80) == 0))
+		off++;
+
+	return off;
+}
+
 /** Decode a single character from a string.
  *
  * Decode a single character from a string of size @a size. Decoding starts
@@ -333,12 +434,26 @@ errno_t chr_encode(const wchar_t ch, char *str, size_t *offset, size_t size)
  */
 size_t str_size(const char *str)
 {
-	size_t size = 0;
+	const char *p = str;
+	str_word_t w;
 
-	while (*str++ != 0)
-		size++;
+	while (((uintptr_t) p % sizeof(str_word_t)) != 0) {
+		if (*p == 0)
+			return p - str;
+		p++;
+	}
+
+	while (true) {
+		w = *(const str_word_t *) p;
+		if (WORD_HAS_ZERO(w) != 0)
+			break;
+		p += sizeof(str_word_t);
+	}
 
-	return size;
+	while (*p != 0)
+		p++;
+
+	return p - str;
 }
 
 /** Get size of wide string.
@@ -397,12 +512,12 @@ size_t str_lsize(const char *str, size_t max_len)
  */
 size_t str_nsize(const char *str, size_t max_size)
 {
-	size_t size = 0;
+	const char *end = memchr(str, 0, max_size);
 
-	while ((*str++ != 0) && (size < max_size))
-		size++;
+	if (end == NULL)
+		return max_size;
 
-	return size;
+	return end - str;
 }
 
 /** Get size of wide string with size limit.
@@ -450,9 +565,18 @@ size_t str_length(const char *str)
 {
 	size_t len = 0;
 	size_t offset = 0;
+	size_t ascii;
+
+	while (true) {
+		ascii = str_ascii_skip(str, offset, STR_NO_LIMIT, 0);
+		len += ascii - offset;
+		offset = ascii;
+
+		if (str_decode(str, &offset, STR_NO_LIMIT) == 0)
+			break;
 
-	while (str_decode(str, &offset, STR_NO_LIMIT) != 0)
 		len++;
+	}
 
 	return len;
 }
@@ -486,9 +610,18 @@ size_t str_nlength(const char *str, size_t size)
 {
 	size_t len = 0;
 	size_t offset = 0;
+	size_t ascii;
+
+	while (true) {
+		ascii = str_ascii_skip(str, offset, size, 0);
+		len += ascii - offset;
+		offset = ascii;
+
+		if (str_decode(str, &offset, size) == 0)
+			break;
 
-	while (str_decode(str, &offset, size) != 0)
 		len++;
+	}
 
 	return len;
 }
@@ -591,8 +724,8 @@ int str_cmp(const char *s1, const char *s2)
 	wchar_t c1 = 0;
 	wchar_t c2 = 0;
 
-	size_t off1 = 0;
-	size_t off2 = 0;
+	size_t off1 = str_ascii_common(s1, s2, STR_NO_LIMIT);
+	size_t off2 = off1;
 
 	while (true) {
 		c1 = str_decode(s1, &off1, STR_NO_LIMIT);
@@ -638,10 +771,10 @@ int str_lcmp(const char *s1, const char *s2, size_t max_len)
 	wchar_t c1 = 0;
 	wchar_t c2 = 0;
 
-	size_t off1 = 0;
-	size_t off2 = 0;
+	size_t off1 = str_ascii_common(s1, s2, max_len);
+	size_t off2 = off1;
 
-	size_t len = 0;
+	size_t len = off1;
 
 	while (true) {
 		if (len >= max_len)
@@ -690,8 +823,8 @@ int str_casecmp(const char *s1, const char *s2)
 	wchar_t c1 = 0;
 	wchar_t c2 = 0;
 
-	size_t off1 = 0;
-	size_t off2 = 0;
+	size_t off1 = str_ascii_common(s1, s2, STR_NO_LIMIT);
+	size_t off2 = off1;
 
 	while (true) {
 		c1 = tolower(str_decode(s1, &off1, STR_NO_LIMIT));
@@ -738,10 +871,10 @@ int str_lcasecmp(const char *s1, const char *s2, size_t max_len)
 	wchar_t c1 = 0;
 	wchar_t c2 = 0;
 
-	size_t off1 = 0;
-	size_t off2 = 0;
+	size_t off1 = str_ascii_common(s1, s2, max_len);
+	size_t off2 = off1;
 
-	size_t len = 0;
+	size_t len = off1;
 
 	while (true) {
 		if (len >= max_len)
@@ -782,8 +915,8 @@ bool str_test_prefix(const char *s, const char *p)
 	wchar_t c1 = 0;
 	wchar_t c2 = 0;
 
-	size_t off1 = 0;
-	size_t off2 = 0;
+	size_t off1 = str_ascii_common(s, p, STR_NO_LIMIT);
+	size_t off2 = off1;
 
 	while (true) {
 		c1 = str_decode(s, &off1, STR_NO_LIMIT);
@@ -1196,14 +1329,22 @@ wchar_t *str_to_awstr(const char *str)
  */
 char *str_chr(const char *str, wchar_t ch)
 {
+	uint8_t stop = ascii_check(ch) ? (uint8_t) ch : 0;
 	wchar_t acc;
 	size_t off = 0;
 	size_t last = 0;
 
-	while ((acc = str_decode(str, &off, STR_NO_LIMIT)) != 0) {
+	while (true) {
+		/* Plain ASCII bytes other than ch cannot match */
+		off = str_ascii_skip(str, off, STR_NO_LIMIT, stop);
+		last = off;
+
+		acc = str_decode(str, &off, STR_NO_LIMIT);
+		if (acc == 0)
+			break;
+
 		if (acc == ch)
 			return (char *) (str + last);
-		last = off;
 	}
 
 	return NULL;
@@ -1294,15 +1435,23 @@ void str_ltrim(char *str, wchar_t ch)
  */
 char *str_rchr(const char *str, wchar_t ch)
 {
+	uint8_t stop = ascii_check(ch) ? (uint8_t) ch : 0;
 	wchar_t acc;
 	size_t off = 0;
 	size_t last = 0;
 	const char *res = NULL;
 
-	while ((acc = str_decode(str, &off, STR_NO_LIMIT)) != 0) {
+	while (true) {
+		/* Plain ASCII bytes other than ch cannot match */
+		off = str_ascii_skip(str, off, STR_NO_LIMIT, stop);
+		last = off;
+
+		acc = str_decode(str, &off, STR_NO_LIMIT);
+		if (acc == 0)
+			break;
+
 		if (acc == ch)
 			res = (str + last);
-		last = off;
 	}
 
 	return (char *) res;
@@ -36,6 +36,7 @@
 
 #include <adt/list.h>
 #include <fibril.h>
+#include <fibril_synch.h>
 #include <stack.h>
 #include <tls.h>
 #include <stdlib.h>
@@ -47,6 +48,8 @@
 #include <str.h>
 #include <ipc/ipc.h>
 #include <libarch/faddr.h>
+#include <macros.h>
+#include <bitops.h>
 
 #include "../private/thread.h"
 #include "../private/futex.h"
@@ -54,13 +57,57 @@
 #include "../private/libc.h"
 
 #define DPRINTF(...) ((void)0)
+
+/** Maximum number of IPC calls received by a single wait. */
+#define IPC_WAIT_BATCH 16
 #undef READY_DEBUG
 
-/** Member of timeout_list. */
+/** Interval of polling for the end of an RCU grace period. */
+#define RCU_POLL_USEC 1000
+
+/** Rounds of fibril key destructors called when a fibril exits. */
+#define FIBRIL_KEY_DESTRUCTOR_ITERATIONS 4
+
+/** Consecutive runs of the next fibril before the ready queue gets a turn. */
+#define RUNNER_NEXT_LIMIT 8
+
+/**
+ * Number of stack size classes kept in the stack cache. Class i holds
+ * stacks of PAGE_SIZE << i bytes, larger stacks are never cached.
+ */
+#define STACK_CACHE_CLASSES 10
+
+/** Maximum number of stacks kept in the stack cache per size class. */
+#define STACK_CACHE_DEPTH 16
+
+/** Resolution of the timer wheel in nanoseconds. */
+#define TIMER_TICK_NSEC MSEC2NSEC(1)
+
+/** Number of slots on each level of the timer wheel (power of two). */
+#define TIMER_WHEEL_BITS 8
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+/** Timer wheel levels, the last one being the overflow list. */
+enum {
+	/** Slots of one tick */
+	TIMER_LEVEL_TICK,
+	/** Slots of TIMER_WHEEL_SLOTS ticks */
+	TIMER_LEVEL_BLOCK,
+	/** Timeouts too far to fit the wheel */
+	TIMER_LEVEL_FAR,
+	TIMER_LEVELS
+};
+
+/** Member of the timer wheel. */
 typedef struct {
 	link_t link;
 	struct timespec expires;
 	fibril_event_t *event;
+	/** Tick of the expiration. */
+	uint64_t tick;
+	/** Level of the timer wheel the timeout is on. */
+	unsigned int level;
 } _timeout_t;
 
 typedef struct {
@@ -76,6 +123,28 @@ typedef struct {
 	ipc_call_t call;
 } _ipc_buffer_t;
 
+/** Ready queue of a runner thread.
+ *
+ * Fibrils made ready by a runner are queued locally. Runners that run
+ * out of local work steal from the others.
+ */
+typedef struct {
+	/** Protects the runner's ready queue. */
+	futex_t lock;
+	/** Fibril just woken up by this runner, to be run before the queue. */
+	fibril_t *next;
+	/** Number of consecutive runs of the next fibril. */
+	unsigned int next_streak;
+	/** Ready fibrils in FIFO order. */
+	list_t ready;
+} _runner_t;
+
+/** Recycled fibril stacks of one size class. */
+typedef struct {
+	size_t count;
+	void *stacks[STACK_CACHE_DEPTH];
+} _stack_class_t;
+
 typedef enum {
 	SWITCH_FROM_DEAD,
 	SWITCH_FROM_HELPER,
@@ -85,14 +154,53 @@ typedef enum {
 
 static bool multithreaded = false;
 
-/* This futex serializes access to global data. */
+/* This futex serializes access to events, timeouts and the fibril list. */
 static futex_t fibril_futex;
 static futex_t ready_semaphore;
 static long ready_st_count;
 
-static LIST_INITIALIZE(ready_list);
+static _runner_t runners[RUNNER_MAX];
+static atomic_uint runner_count = 1;
+static unsigned int runners_spawned = 1;
+
+/** Number of fibrils in all ready queues. */
+static atomic_long ready_count;
+
+/** Round-robin cursor for fibril_bind_runner(). */
+static atomic_uint home_next;
+
+/** Whether fibril run time is being accounted. */
+static atomic_bool run_accounting = false;
+
+/** TCB slots used by fibril keys, protected by fibril_futex. */
+static uint32_t key_mask;
+static void (*key_destructors[TLS_SLOT_COUNT])(void *);
+
 static LIST_INITIALIZE(fibril_list);
-static LIST_INITIALIZE(timeout_list);
+
+/** Threads tracked by fibril RCU, protected by fibril_futex. */
+static LIST_INITIALIZE(rcu_threads);
+/** Serializes RCU grace periods. */
+static FIBRIL_MUTEX_INITIALIZE(rcu_gp_lock);
+/*
+ * Pending timeouts are kept on a two-level timer wheel, so that arming
+ * and cancelling a timeout takes constant time. The tick level has a slot
+ * for each of the next TIMER_WHEEL_SLOTS ticks. The block level has a slot
+ * for each of the following blocks of TIMER_WHEEL_SLOTS ticks, which is
+ * moved to the tick level once its block starts. Farther timeouts wait on
+ * a list that is redistributed once the block level turns over.
+ */
+static list_t timer_ticks[TIMER_WHEEL_SLOTS];
+static list_t timer_blocks[TIMER_WHEEL_SLOTS];
+static LIST_INITIALIZE(timer_far);
+static size_t timer_count[TIMER_LEVELS];
+/** Tick the timer wheel has been advanced to. */
+static uint64_t timer_tick;
+
+static fibril_timeout_stats_t timeout_stats;
+
+static futex_t stack_cache_futex;
+static _stack_class_t stack_cache[STACK_CACHE_CLASSES];
 
 static futex_t ipc_lists_futex;
 static LIST_INITIALIZE(ipc_waiter_list);
@@ -110,7 +218,7 @@ static inline void _ready_debug_check(void)
 {
 #ifdef READY_DEBUG
 	assert(!multithreaded);
-	long count = (long) list_count(&ready_list) +
+	long count = atomic_load_explicit(&ready_count, memory_order_relaxed) +
 	    (long) list_count(&ipc_buffer_free_list);
 	assert(ready_st_count == count);
 #endif
@@ -136,8 +244,97 @@ static inline errno_t _ready_down(const struct timespec *expires)
 	return EOK;
 }
 
+/** Take up to @a max more tokens of the ready semaphore without blocking.
+ *
+ * @return Number of tokens taken.
+ */
+static size_t _ready_down_nonblocking(size_t limit)
+{
+	size_t count = 0;
+
+	if (multithreaded) {
+		while ((count < limit) && (futex_trydown(&ready_semaphore)))
+			count++;
+	} else {
+		while ((count < limit) && (ready_st_count > 0)) {
+			ready_st_count--;
+			count++;
+		}
+	}
+
+	return count;
+}
+
 static atomic_int threads_in_ipc_wait;
 
+/** @return Stack size class for a stack of @a size bytes. */
+static unsigned int _stack_class(size_t size)
+{
+	size_t pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	if (pages <= 1)
+		return 0;
+
+	return fnzb(pages - 1) + 1;
+}
+
+/**
+ * Allocate a fibril stack, preferably a recycled one.
+ *
+ * Stacks are guarded and their memory is only reserved and committed
+ * as it is used, so a recycled stack comes with its working set already
+ * faulted in.
+ *
+ * @param size  Requested stack size. Rounded up to the size class
+ *              on return.
+ * @return      Stack base or AS_MAP_FAILED.
+ */
+static void *_stack_alloc(size_t *size)
+{
+	unsigned int cls = _stack_class(*size);
+
+	if (cls < STACK_CACHE_CLASSES) {
+		*size = (size_t) PAGE_SIZE << cls;
+
+		void *stack = NULL;
+		futex_lock(&stack_cache_futex);
+		if (stack_cache[cls].count > 0)
+			stack = stack_cache[cls].stacks[--stack_cache[cls].count];
+		futex_unlock(&stack_cache_futex);
+
+		if (stack)
+			return stack;
+	}
+
+	return as_area_create(AS_AREA_ANY, *size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE | AS_AREA_GUARD |
+	    AS_AREA_LATE_RESERVE, AS_AREA_UNPAGED);
+}
+
+/** Return a fibril stack to the stack cache or destroy it if it is full. */
+static void _stack_free(void *stack, size_t size)
+{
+	unsigned int cls = _stack_class(size);
+
+	if ((cls < STACK_CACHE_CLASSES) && (size == ((size_t) PAGE_SIZE << cls))) {
+		bool cached = false;
+
+		futex_lock(&stack_cache_futex);
+		if (stack_cache[cls].count < STACK_CACHE_DEPTH) {
+			stack_cache[cls].stacks[stack_cache[cls].count++] = stack;
+			cached = true;
+		}
+		futex_unlock(&stack_cache_futex);
+
+		if (cached)
+			return;
+	}
+
+	as_area_destroy(stack);
+}
+
+static void _ready_list_push(fibril_t *, bool);
+static void _fibril_switch_complete(void);
+
 /** Function that spans the whole life-cycle of a fibril.
  *
  * Each fibril begins execution in this function. Then the function implementing
@@ -147,8 +344,8 @@ static atomic_int threads_in_ipc_wait;
  */
 static void _fibril_main(void)
 {
-	/* fibril_futex is locked when a fibril is started. */
-	futex_unlock(&fibril_futex);
+	/* Finish the switch that started us. */
+	_fibril_switch_complete();
 
 	fibril_t *fibril = fibril_self();
 
@@ -237,22 +434,102 @@ static fibril_t *_fibril_trigger_internal(fibril_event_t *event, fibril_t *reaso
 	return f;
 }
 
-static errno_t _ipc_wait(ipc_call_t *call, const struct timespec *expires)
+static errno_t _ipc_wait(ipc_call_t *calls, size_t count,
+    const struct timespec *expires, size_t *received)
 {
 	if (!expires)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NONE);
+		return ipc_wait_batch(calls, count, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NONE, received);
 
 	if (expires->tv_sec == 0)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+		return ipc_wait_batch(calls, count, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING, received);
 
 	struct timespec now;
 	getuptime(&now);
 
 	if (ts_gteq(&now, expires))
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+		return ipc_wait_batch(calls, count, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING, received);
+
+	/* Zero would mean no timeout at all, so round up. */
+	usec_t usec = NSEC2USEC(ts_sub_diff(expires, &now));
+	if (usec == 0)
+		usec = 1;
+
+	return ipc_wait_batch(calls, count, usec, SYNCH_FLAGS_NONE, received);
+}
+
+/** @return Ready queue of the current runner thread. */
+static inline _runner_t *_runner_self(void)
+{
+	return &runners[fibril_self()->runner];
+}
+
+/**
+ * Take a fibril from a runner's ready queue.
+ *
+ * The next fibril takes precedence, unless it has been preferred too many
+ * times in a row. Thieves only take it when the queue is empty, since
+ * the owner is likely to switch to it soon and it is cache-hot there.
+ *
+ * @param r      Runner to take from.
+ * @param steal  True if the current thread does not own the runner.
+ * @return       Ready fibril or NULL.
+ */
+static fibril_t *_ready_take(_runner_t *r, bool steal)
+{
+	if (steal) {
+		if (!futex_trylock(&r->lock))
+			return NULL;
+	} else {
+		futex_lock(&r->lock);
+	}
+
+	fibril_t *f = NULL;
+	bool use_next = (r->next != NULL) && (list_empty(&r->ready) ||
+	    (!steal && r->next_streak < RUNNER_NEXT_LIMIT));
+
+	if (use_next) {
+		f = r->next;
+		r->next = NULL;
+		if (!steal)
+			r->next_streak++;
+	} else {
+		f = list_pop(&r->ready, fibril_t, link);
+		if (!steal)
+			r->next_streak = 0;
+	}
 
-	return ipc_wait(call, NSEC2USEC(ts_sub_diff(expires, &now)),
-	    SYNCH_FLAGS_NONE);
+	if (f)
+		atomic_fetch_sub_explicit(&ready_count, 1, memory_order_relaxed);
+
+	futex_unlock(&r->lock);
+	return f;
+}
+
+/**
+ * Find a ready fibril, looking at the own ready queue first and then
+ * stealing from other runners.
+ */
+static fibril_t *_ready_find(void)
+{
+	_runner_t *self = _runner_self();
+	fibril_t *f = _ready_take(self, false);
+	if (f)
+		return f;
+
+	unsigned int count =
+	    atomic_load_explicit(&runner_count, memory_order_relaxed);
+	unsigned int idx = self - runners;
+
+	for (unsigned int i = 1; i < count; i++) {
+		f = _ready_take(&runners[(idx + i) % count], true);
+		if (f)
+			return f;
+	}
+
+	return NULL;
 }
 
 /*
@@ -260,16 +537,9 @@ static errno_t _ipc_wait(ipc_call_t *call, const struct timespec *expires)
  * Returns NULL on timeout and may also return NULL if returning from IPC
  * wait after new ready fibrils are added.
  */
-static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
+static fibril_t *_ready_list_pop(const struct timespec *expires)
 {
-	if (locked) {
-		futex_assert_is_locked(&fibril_futex);
-		assert(expires);
-		/* Must be nonblocking. */
-		assert(expires->tv_sec == 0);
-	} else {
-		futex_assert_is_not_locked(&fibril_futex);
-	}
+	futex_assert_is_not_locked(&fibril_futex);
 
 	errno_t rc = _ready_down(expires);
 	if (rc != EOK)
@@ -277,36 +547,55 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 
 	/*
 	 * Once we acquire a token from ready_semaphore, there are two options.
-	 * Either there is a ready fibril in the list, or it's our turn to
-	 * call `ipc_wait_cycle()`. There is one extra token on the semaphore
+	 * Either there is a ready fibril in some ready queue, or it's our turn
+	 * to call `ipc_wait_cycle()`. There is one extra token on the semaphore
 	 * for each entry of the call buffer.
+	 *
+	 * A fibril counted in ready_count may not be visible to us yet, or
+	 * a thief may hold the lock of its queue, so keep looking until
+	 * we find one or there is none left.
 	 */
 
-	if (!locked)
-		futex_lock(&fibril_futex);
-	fibril_t *f = list_pop(&ready_list, fibril_t, link);
-	if (!f)
+	fibril_t *f;
+
+	while (true) {
+		f = _ready_find();
+		if (f)
+			return f;
+
+		/*
+		 * Announce the IPC wait before looking at ready_count. Either
+		 * _ready_list_push() sees us and pokes, or we see its fibril.
+		 */
 		atomic_fetch_add_explicit(&threads_in_ipc_wait, 1,
-		    memory_order_relaxed);
-	if (!locked)
-		futex_unlock(&fibril_futex);
+		    memory_order_seq_cst);
 
-	if (f)
-		return f;
+		if (atomic_load_explicit(&ready_count, memory_order_seq_cst) == 0)
+			break;
+
+		atomic_fetch_sub_explicit(&threads_in_ipc_wait, 1,
+		    memory_order_relaxed);
+	}
 
 	if (!multithreaded)
 		assert(list_empty(&ipc_buffer_list));
 
-	/* No fibril is ready, IPC wait it is. */
-	ipc_call_t call = { 0 };
-	rc = _ipc_wait(&call, expires);
+	/*
+	 * No fibril is ready, IPC wait it is. Receive all pending calls
+	 * in one go, each of them needs another token for its buffer.
+	 */
+	ipc_call_t calls[IPC_WAIT_BATCH] = { 0 };
+	size_t count = 1 + _ready_down_nonblocking(IPC_WAIT_BATCH - 1);
+	size_t received = 0;
+	rc = _ipc_wait(calls, count, expires, &received);
 
 	atomic_fetch_sub_explicit(&threads_in_ipc_wait, 1,
 	    memory_order_relaxed);
 
 	if (rc != EOK && rc != ENOENT) {
-		/* Return token. */
-		_ready_up();
+		/* Return tokens. */
+		for (size_t i = 0; i < count; i++)
+			_ready_up();
 		return NULL;
 	}
 
@@ -315,6 +604,12 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 	 * In that case, we propagate the null call out of fibril_ipc_wait(),
 	 * because poke must result in that call returning.
 	 */
+	if (rc != EOK)
+		received = 1;
+
+	/* Return the tokens of calls that were not received. */
+	for (size_t i = received; i < count; i++)
+		_ready_up();
 
 	/*
 	 * If a fibril is already waiting for IPC, we wake up the fibril,
@@ -324,53 +619,90 @@ static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
 	 * returned.
 	 */
 
-	if (!locked)
-		futex_lock(&fibril_futex);
-
+	futex_lock(&fibril_futex);
 	futex_lock(&ipc_lists_futex);
 
-	_ipc_waiter_t *w = list_pop(&ipc_waiter_list, _ipc_waiter_t, link);
-	if (w) {
-		*w->call = call;
-		w->rc = rc;
-		/* We switch to the woken up fibril immediately if possible. */
-		f = _fibril_trigger_internal(&w->event, _EVENT_TRIGGERED);
-
-		/* Return token. */
-		_ready_up();
-	} else {
-		_ipc_buffer_t *buf = list_pop(&ipc_buffer_free_list, _ipc_buffer_t, link);
-		assert(buf);
-		*buf = (_ipc_buffer_t) { .call = call, .rc = rc };
-		list_append(&buf->link, &ipc_buffer_list);
+	for (size_t i = 0; i < received; i++) {
+		_ipc_waiter_t *w = list_pop(&ipc_waiter_list, _ipc_waiter_t, link);
+		if (w) {
+			*w->call = calls[i];
+			w->rc = rc;
+			/*
+			 * We switch to the first woken up fibril immediately
+			 * if possible.
+			 */
+			fibril_t *wf = _fibril_trigger_internal(&w->event,
+			    _EVENT_TRIGGERED);
+			if (!f)
+				f = wf;
+			else
+				_ready_list_push(wf, false);
+
+			/* Return token. */
+			_ready_up();
+		} else {
+			_ipc_buffer_t *buf = list_pop(&ipc_buffer_free_list, _ipc_buffer_t, link);
+			assert(buf);
+			*buf = (_ipc_buffer_t) { .call = calls[i], .rc = rc };
+			list_append(&buf->link, &ipc_buffer_list);
+		}
 	}
 
 	futex_unlock(&ipc_lists_futex);
-
-	if (!locked)
-		futex_unlock(&fibril_futex);
+	futex_unlock(&fibril_futex);
 
 	return f;
 }
 
-static fibril_t *_ready_list_pop_nonblocking(bool locked)
+static fibril_t *_ready_list_pop_nonblocking(void)
 {
 	struct timespec tv = { .tv_sec = 0, .tv_nsec = 0 };
-	return _ready_list_pop(&tv, locked);
+	return _ready_list_pop(&tv);
 }
 
-static void _ready_list_push(fibril_t *f)
+/**
+ * Make a fibril ready in the ready queue of the current runner, or of
+ * its home runner if it has one.
+ *
+ * @param f     Fibril to make ready, may be NULL.
+ * @param next  Run the fibril before the rest of the queue. The fibril
+ *              previously occupying that place moves to the queue tail.
+ *              Ignored when queueing at another runner.
+ */
+static void _ready_list_push(fibril_t *f, bool next)
 {
 	if (!f)
 		return;
 
-	futex_assert_is_locked(&fibril_futex);
+	_runner_t *r = _runner_self();
+
+	if (f->home != 0 && &runners[f->home - 1] != r) {
+		r = &runners[f->home - 1];
+		next = false;
+	}
+
+	futex_lock(&r->lock);
+
+	/*
+	 * Counted under the lock, so that ready_count never drops below
+	 * the number of fibrils a token holder can still find.
+	 */
+	atomic_fetch_add_explicit(&ready_count, 1, memory_order_seq_cst);
+
+	if (next) {
+		fibril_t *prev = r->next;
+		r->next = f;
+		f = prev;
+	}
+
+	if (f)
+		list_append(&f->link, &r->ready);
+
+	futex_unlock(&r->lock);
 
-	/* Enqueue in ready_list. */
-	list_append(&f->link, &ready_list);
 	_ready_up();
 
-	if (atomic_load_explicit(&threads_in_ipc_wait, memory_order_relaxed)) {
+	if (atomic_load_explicit(&threads_in_ipc_wait, memory_order_seq_cst)) {
 		DPRINTF("Poking.\n");
 		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
 		ipc_poke();
@@ -414,60 +746,316 @@ static errno_t _wait_ipc(ipc_call_t *call, const struct timespec *expires)
 	return rc;
 }
 
+/** Convert a time to a timer wheel tick. */
+static inline uint64_t _timer_tick(const struct timespec *ts)
+{
+	return SEC2NSEC((uint64_t) ts->tv_sec) / TIMER_TICK_NSEC +
+	    ts->tv_nsec / TIMER_TICK_NSEC;
+}
+
+static inline size_t _timer_total(void)
+{
+	return timer_count[TIMER_LEVEL_TICK] + timer_count[TIMER_LEVEL_BLOCK] +
+	    timer_count[TIMER_LEVEL_FAR];
+}
+
+/** Put a timeout on the right level of the timer wheel. */
+static void _timer_wheel_insert(_timeout_t *timeout)
+{
+	uint64_t tick = max(timeout->tick, timer_tick);
+	uint64_t block = tick >> TIMER_WHEEL_BITS;
+	list_t *list;
+
+	if (tick - timer_tick < TIMER_WHEEL_SLOTS) {
+		timeout->level = TIMER_LEVEL_TICK;
+		list = &timer_ticks[tick & TIMER_WHEEL_MASK];
+	} else if (block - (timer_tick >> TIMER_WHEEL_BITS) <
+	    TIMER_WHEEL_SLOTS) {
+		timeout->level = TIMER_LEVEL_BLOCK;
+		list = &timer_blocks[block & TIMER_WHEEL_MASK];
+	} else {
+		timeout->level = TIMER_LEVEL_FAR;
+		list = &timer_far;
+	}
+
+	list_append(&timeout->link, list);
+	timer_count[timeout->level]++;
+}
+
+static void _timer_wheel_remove(_timeout_t *timeout)
+{
+	list_remove(&timeout->link);
+	timer_count[timeout->level]--;
+}
+
+/** Move the timer wheel to a tick, redistributing timeouts as needed. */
+static void _timer_wheel_step(uint64_t tick)
+{
+	timer_tick = tick;
+
+	if ((tick & TIMER_WHEEL_MASK) != 0)
+		return;
+
+	uint64_t block = tick >> TIMER_WHEEL_BITS;
+	list_t moved;
+
+	list_initialize(&moved);
+	list_concat(&moved, &timer_blocks[block & TIMER_WHEEL_MASK]);
+	if ((block & TIMER_WHEEL_MASK) == 0)
+		list_concat(&moved, &timer_far);
+
+	while (!list_empty(&moved)) {
+		_timeout_t *to = list_get_instance(list_first(&moved),
+		    _timeout_t, link);
+		_timer_wheel_remove(to);
+		_timer_wheel_insert(to);
+	}
+}
+
+/** Fire a timeout. */
+static void _timer_fire(_timeout_t *to)
+{
+	_timer_wheel_remove(to);
+	timeout_stats.expired++;
+
+	_ready_list_push(_fibril_trigger_internal(
+	    to->event, _EVENT_TIMED_OUT), false);
+}
+
+/** Find the earliest expiration in a list of timeouts. */
+static _timeout_t *_timer_list_min(list_t *list)
+{
+	_timeout_t *min = NULL;
+
+	list_foreach(*list, link, _timeout_t, to) {
+		if (min == NULL || ts_gt(&min->expires, &to->expires))
+			min = to;
+	}
+
+	return min;
+}
+
+/** Pick the one of two timeouts which expires first. */
+static _timeout_t *_timer_earlier(_timeout_t *a, _timeout_t *b)
+{
+	if (a == NULL || (b != NULL && ts_gt(&a->expires, &b->expires)))
+		return b;
+	return a;
+}
+
+/** Find the timeout which expires first.
+ *
+ * Timeouts were put on a level according to the wheel position at the
+ * time they were started, so each level has to be checked.
+ */
+static _timeout_t *_timer_wheel_first(void)
+{
+	_timeout_t *first = NULL;
+
+	if (timer_count[TIMER_LEVEL_TICK] > 0) {
+		for (unsigned int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+			list_t *list = &timer_ticks[(timer_tick + i) &
+			    TIMER_WHEEL_MASK];
+			if (!list_empty(list)) {
+				first = _timer_list_min(list);
+				break;
+			}
+		}
+	}
+
+	if (timer_count[TIMER_LEVEL_BLOCK] > 0) {
+		uint64_t block = timer_tick >> TIMER_WHEEL_BITS;
+		for (unsigned int i = 1; i < TIMER_WHEEL_SLOTS; i++) {
+			list_t *list = &timer_blocks[(block + i) &
+			    TIMER_WHEEL_MASK];
+			if (!list_empty(list)) {
+				first = _timer_earlier(first,
+				    _timer_list_min(list));
+				break;
+			}
+		}
+	}
+
+	if (timer_count[TIMER_LEVEL_FAR] > 0)
+		first = _timer_earlier(first, _timer_list_min(&timer_far));
+
+	return first;
+}
+
 /** Fire all timeouts that expired. */
 static struct timespec *_handle_expired_timeouts(struct timespec *next_timeout)
 {
 	struct timespec ts;
 	getuptime(&ts);
+	uint64_t now = _timer_tick(&ts);
 
 	futex_lock(&fibril_futex);
 
-	while (!list_empty(&timeout_list)) {
-		link_t *cur = list_first(&timeout_list);
-		_timeout_t *to = list_get_instance(cur, _timeout_t, link);
+	uint64_t expired = timeout_stats.expired;
 
-		if (ts_gt(&to->expires, &ts)) {
-			*next_timeout = to->expires;
-			futex_unlock(&fibril_futex);
-			return next_timeout;
-		}
+	while (timer_tick < now && _timer_total() > 0) {
+		list_t *list = &timer_ticks[timer_tick & TIMER_WHEEL_MASK];
+
+		while (!list_empty(list))
+			_timer_fire(list_get_instance(list_first(list),
+			    _timeout_t, link));
 
-		list_remove(&to->link);
+		/* Skip the rest of an empty block at once. */
+		uint64_t next = timer_tick + 1;
+		if (timer_count[TIMER_LEVEL_TICK] == 0)
+			next = min((timer_tick | TIMER_WHEEL_MASK) + 1, now);
 
-		_ready_list_push(_fibril_trigger_internal(
-		    to->event, _EVENT_TIMED_OUT));
+		_timer_wheel_step(next);
 	}
 
+	if (_timer_total() == 0)
+		timer_tick = now;
+
+	/* The current tick may hold timeouts that expire later in the tick. */
+	list_t *list = &timer_ticks[now & TIMER_WHEEL_MASK];
+	list_foreach_safe(*list, cur, next) {
+		_timeout_t *to = list_get_instance(cur, _timeout_t, link);
+		if (ts_gteq(&ts, &to->expires))
+			_timer_fire(to);
+	}
+
+	if (timeout_stats.expired != expired)
+		timeout_stats.wakeups++;
+
+	_timeout_t *first = _timer_wheel_first();
+	if (first != NULL)
+		*next_timeout = first->expires;
+
 	futex_unlock(&fibril_futex);
-	return NULL;
+	return (first != NULL) ? next_timeout : NULL;
 }
 
 /**
- * Clean up after a dead fibril from which we restored context, if any.
- * Called after a switch is made and fibril_futex is unlocked.
+ * Put a fibril that blocked on its sleep event to sleep, now that its
+ * context has been saved. If the event was triggered or timed out in
+ * the meantime, the fibril is made ready right away.
  */
-static void _fibril_cleanup_dead(void)
+static void _fibril_block_complete(fibril_t *f)
+{
+	fibril_event_t *event = f->sleep_event;
+
+	futex_lock(&fibril_futex);
+
+	bool ready = (event->fibril != _EVENT_INITIAL);
+	if (!ready)
+		event->fibril = f;
+
+	futex_unlock(&fibril_futex);
+
+	if (ready)
+		_ready_list_push(f, false);
+}
+
+/**
+ * Finish the work left behind by the fibril from which we restored context,
+ * if any: make it ready again, put it to sleep, or clean up after it.
+ *
+ * Called by the destination fibril after each switch, once the source
+ * fibril is no longer running, so that no other thread can restore the
+ * source fibril before its context is saved.
+ */
+static void _fibril_switch_complete(void)
 {
 	fibril_t *srcf = fibril_self();
+
+	if (srcf->ready_after_me) {
+		fibril_t *f = srcf->ready_after_me;
+		srcf->ready_after_me = NULL;
+		_ready_list_push(f, false);
+	}
+
+	if (srcf->block_after_me) {
+		fibril_t *f = srcf->block_after_me;
+		srcf->block_after_me = NULL;
+		_fibril_block_complete(f);
+	}
+
 	if (!srcf->clean_after_me)
 		return;
 
 	void *stack = srcf->clean_after_me->stack;
 	assert(stack);
-	as_area_destroy(stack);
+	_stack_free(stack, srcf->clean_after_me->stack_size);
 	fibril_teardown(srcf->clean_after_me);
 	srcf->clean_after_me = NULL;
 }
 
+static usec_t _uptime_usec(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+/** Account the run time of the fibril being switched out. */
+static void _run_account(fibril_t *srcf, fibril_t *dstf)
+{
+	if (!atomic_load_explicit(&run_accounting, memory_order_relaxed)) {
+		/* Do not count periods spent with accounting disabled. */
+		dstf->run_since = 0;
+		return;
+	}
+
+	usec_t now = _uptime_usec();
+
+	if (srcf->run_since != 0)
+		srcf->run_usec += now - srcf->run_since;
+
+	dstf->run_since = now;
+}
+
+/** Enable or disable accounting of fibril run time. */
+void __fibril_accounting_set(bool enable)
+{
+	atomic_store_explicit(&run_accounting, enable, memory_order_relaxed);
+}
+
+/** Get the run time of the current fibril.
+ *
+ * Only time during which the run time accounting was enabled counts.
+ *
+ * @return Run time in microseconds.
+ */
+usec_t __fibril_run_usec(void)
+{
+	fibril_t *f = fibril_self();
+	usec_t run = f->run_usec;
+
+	if (f->run_since != 0)
+		run += _uptime_usec() - f->run_since;
+
+	return run;
+}
+
+/**
+ * Mark the current thread idle or busy for fibril RCU.
+ *
+ * An idle thread runs no fibril and thus no RCU reader.
+ */
+static void _rcu_idle_set(bool idle)
+{
+	fibril_rcu_thread_t *rt = fibril_self()->rcu_thread;
+	if (rt == NULL)
+		return;
+
+	atomic_store_explicit(&rt->idle, idle, memory_order_seq_cst);
+
+	/* Readers that follow must see updates made while we were idle. */
+	if (!idle)
+		atomic_thread_fence(memory_order_seq_cst);
+}
+
 /** Switch to a fibril. */
-static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
+static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf)
 {
 	assert(fibril_self()->rmutex_locks == 0);
-
-	if (!locked)
-		futex_lock(&fibril_futex);
-	else
-		futex_assert_is_locked(&fibril_futex);
+	futex_assert_is_not_locked(&fibril_futex);
 
 	fibril_t *srcf = fibril_self();
 	assert(srcf);
@@ -475,21 +1063,34 @@ static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
 
 	switch (type) {
 	case SWITCH_FROM_YIELD:
-		_ready_list_push(srcf);
+		dstf->ready_after_me = srcf;
 		break;
 	case SWITCH_FROM_DEAD:
 		dstf->clean_after_me = srcf;
 		break;
-	case SWITCH_FROM_HELPER:
 	case SWITCH_FROM_BLOCKED:
+		dstf->block_after_me = srcf;
+		break;
+	case SWITCH_FROM_HELPER:
 		break;
 	}
 
 	dstf->thread_ctx = srcf->thread_ctx;
 	srcf->thread_ctx = NULL;
+	dstf->runner = srcf->runner;
+	dstf->tid = srcf->tid;
+	dstf->rcu_thread = srcf->rcu_thread;
+
+	/* Leaving a fibril is a quiescent state of the thread. */
+	fibril_rcu_thread_t *rt = srcf->rcu_thread;
+	if (rt != NULL) {
+		unsigned int switches =
+		    atomic_load_explicit(&rt->switches, memory_order_relaxed);
+		atomic_store_explicit(&rt->switches, switches + 1,
+		    memory_order_release);
+	}
 
-	/* Just some bookkeeping to allow better debugging of futex locks. */
-	futex_give_to(&fibril_futex, dstf);
+	_run_account(srcf, dstf);
 
 	/* Swap to the next fibril. */
 	context_swap(&srcf->ctx, &dstf->ctx);
@@ -497,11 +1098,8 @@ static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
 	assert(srcf == fibril_self());
 	assert(srcf->thread_ctx);
 
-	if (!locked) {
-		/* Must be after context_swap()! */
-		futex_unlock(&fibril_futex);
-		_fibril_cleanup_dead();
-	}
+	/* Must be after context_swap()! */
+	_fibril_switch_complete();
 }
 
 /**
@@ -523,9 +1121,13 @@ static errno_t _helper_fibril_fn(void *arg)
 	struct timespec next_timeout;
 	while (true) {
 		struct timespec *to = _handle_expired_timeouts(&next_timeout);
-		fibril_t *f = _ready_list_pop(to, false);
+
+		_rcu_idle_set(true);
+		fibril_t *f = _ready_list_pop(to);
+		_rcu_idle_set(false);
+
 		if (f) {
-			_fibril_switch_to(SWITCH_FROM_HELPER, f, false);
+			_fibril_switch_to(SWITCH_FROM_HELPER, f);
 		}
 	}
 
@@ -550,9 +1152,7 @@ fid_t fibril_create_generic(errno_t (*func)(void *), void *arg, size_t stksz)
 		return 0;
 
 	fibril->stack_size = stksz;
-	fibril->stack = as_area_create(AS_AREA_ANY, fibril->stack_size,
-	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE | AS_AREA_GUARD |
-	    AS_AREA_LATE_RESERVE, AS_AREA_UNPAGED);
+	fibril->stack = _stack_alloc(&fibril->stack_size);
 	if (fibril->stack == AS_MAP_FAILED) {
 		fibril_teardown(fibril);
 		return 0;
@@ -560,6 +1160,7 @@ fid_t fibril_create_generic(errno_t (*func)(void *), void *arg, size_t stksz)
 
 	fibril->func = func;
 	fibril->arg = arg;
+	fibril->timer_slack = fibril_self()->timer_slack;
 
 	context_create_t sctx = {
 		.fn = _fibril_main,
@@ -591,7 +1192,7 @@ void fibril_destroy(fid_t fid)
 
 	assert(!fibril->is_running);
 	assert(fibril->stack);
-	as_area_destroy(fibril->stack);
+	_stack_free(fibril->stack, fibril->stack_size);
 	fibril_teardown(fibril);
 }
 
@@ -600,17 +1201,29 @@ static void _insert_timeout(_timeout_t *timeout)
 	futex_assert_is_locked(&fibril_futex);
 	assert(timeout);
 
-	link_t *tmp = timeout_list.head.next;
-	while (tmp != &timeout_list.head) {
-		_timeout_t *cur = list_get_instance(tmp, _timeout_t, link);
+	if (_timer_total() == 0) {
+		struct timespec now;
+		getuptime(&now);
+		timer_tick = _timer_tick(&now);
+	}
 
-		if (ts_gteq(&cur->expires, &timeout->expires))
-			break;
+	timeout->tick = _timer_tick(&timeout->expires);
+	_timer_wheel_insert(timeout);
+	timeout_stats.armed++;
+}
 
-		tmp = tmp->next;
-	}
+/** Delay a deadline to the end of the slack interval it falls into.
+ *
+ * Deadlines of fibrils using the same slack which fall into the same
+ * interval expire at once, so that they cause a single wakeup.
+ */
+static void _apply_timer_slack(struct timespec *expires, nsec_t slack)
+{
+	nsec_t ns = SEC2NSEC((nsec_t) expires->tv_sec) + expires->tv_nsec;
+	nsec_t rem = ns % slack;
 
-	list_insert_before(&timeout->link, tmp);
+	if (rem != 0)
+		ts_add_diff(expires, slack - rem);
 }
 
 /**
@@ -648,61 +1261,64 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 
 	assert(event->fibril == _EVENT_INITIAL);
 
-	fibril_t *srcf = fibril_self();
-	fibril_t *dstf = NULL;
-
-	/*
-	 * We cannot block here waiting for another fibril becoming
-	 * ready, since that would require unlocking the fibril_futex,
-	 * and that in turn would allow another thread to restore
-	 * the source fibril before this thread finished switching.
-	 *
-	 * Instead, we switch to an internal "helper" fibril whose only
-	 * job is to wait for an event, freeing the source fibril for
-	 * wakeups. There is always one for each running thread.
-	 */
-
-	dstf = _ready_list_pop_nonblocking(true);
-	if (!dstf) {
-		// XXX: It is possible for the _ready_list_pop_nonblocking() to
-		//      check for IPC, find a pending message, and trigger the
-		//      event on which we are currently trying to sleep.
-		if (event->fibril == _EVENT_TRIGGERED) {
-			event->fibril = _EVENT_INITIAL;
-			futex_unlock(&fibril_futex);
-			return EOK;
-		}
-
-		dstf = srcf->thread_ctx;
-		assert(dstf);
-	}
-
 	_timeout_t timeout = { 0 };
 	if (expires) {
 		timeout.expires = *expires;
 		timeout.event = event;
+		if (fibril_self()->timer_slack > 0)
+			_apply_timer_slack(&timeout.expires,
+			    fibril_self()->timer_slack);
 		_insert_timeout(&timeout);
 	}
 
-	assert(srcf);
+	futex_unlock(&fibril_futex);
 
-	event->fibril = srcf;
+	fibril_t *srcf = fibril_self();
 	srcf->sleep_event = event;
 
-	assert(event->fibril != _EVENT_INITIAL);
+	/*
+	 * The event only learns about the source fibril once the switch
+	 * is complete (see _fibril_block_complete()), so that another
+	 * thread cannot restore the source fibril before this thread
+	 * finished switching away from it.
+	 *
+	 * If no other fibril is ready, we switch to an internal "helper"
+	 * fibril whose only job is to wait for an event. There is always
+	 * one for each running thread.
+	 */
+
+	fibril_t *dstf = _ready_list_pop_nonblocking();
+	if (!dstf) {
+		/*
+		 * It is possible for the _ready_list_pop_nonblocking() to
+		 * check for IPC, find a pending message, and trigger the
+		 * event on which we are currently trying to sleep.
+		 */
+		futex_lock(&fibril_futex);
+		bool done = (event->fibril != _EVENT_INITIAL);
+		futex_unlock(&fibril_futex);
+
+		if (!done) {
+			dstf = srcf->thread_ctx;
+			assert(dstf);
+			_fibril_switch_to(SWITCH_FROM_BLOCKED, dstf);
+		}
+	} else {
+		_fibril_switch_to(SWITCH_FROM_BLOCKED, dstf);
+	}
 
-	_fibril_switch_to(SWITCH_FROM_BLOCKED, dstf, true);
+	futex_lock(&fibril_futex);
 
 	assert(event->fibril != srcf);
 	assert(event->fibril != _EVENT_INITIAL);
 	assert(event->fibril == _EVENT_TIMED_OUT || event->fibril == _EVENT_TRIGGERED);
 
-	list_remove(&timeout.link);
+	if (link_in_use(&timeout.link))
+		_timer_wheel_remove(&timeout);
 	errno_t rc = (event->fibril == _EVENT_TIMED_OUT) ? ETIMEOUT : EOK;
 	event->fibril = _EVENT_INITIAL;
 
 	futex_unlock(&fibril_futex);
-	_fibril_cleanup_dead();
 	return rc;
 }
 
@@ -722,8 +1338,28 @@ void fibril_wait_for(fibril_event_t *event)
 void fibril_notify(fibril_event_t *event)
 {
 	futex_lock(&fibril_futex);
-	_ready_list_push(_fibril_trigger_internal(event, _EVENT_TRIGGERED));
+	fibril_t *f = _fibril_trigger_internal(event, _EVENT_TRIGGERED);
 	futex_unlock(&fibril_futex);
+
+	/* Prefer running the woken fibril next on this runner. */
+	_ready_list_push(f, true);
+}
+
+/**
+ * Give a fibril a home runner, chosen round-robin among the existing ones.
+ *
+ * Whenever the fibril is made ready, it is queued at its home runner
+ * instead of the one that woke it up, so that it tends to keep running
+ * on the same thread. Idle runners may still steal it.
+ */
+void fibril_bind_runner(fibril_t *f)
+{
+	unsigned int count =
+	    atomic_load_explicit(&runner_count, memory_order_relaxed);
+	unsigned int idx =
+	    atomic_fetch_add_explicit(&home_next, 1, memory_order_relaxed);
+
+	f->home = 1 + idx % count;
 }
 
 /** Start a fibril that has not been running yet. */
@@ -736,9 +1372,9 @@ void fibril_start(fibril_t *fibril)
 	if (!link_in_use(&fibril->all_link))
 		list_append(&fibril->all_link, &fibril_list);
 
-	_ready_list_push(fibril);
-
 	futex_unlock(&fibril_futex);
+
+	_ready_list_push(fibril, false);
 }
 
 /** Start a fibril that has not been running yet. (obsolete) */
@@ -747,15 +1383,6 @@ void fibril_add_ready(fibril_t *fibril)
 	fibril_start(fibril);
 }
 
-/** @return the currently running fibril. */
-fibril_t *fibril_self(void)
-{
-	assert(__tcb_is_set());
-	tcb_t *tcb = __tcb_get();
-	assert(tcb->fibril_data);
-	return tcb->fibril_data;
-}
-
 /**
  * Obsolete, use fibril_self().
  *
@@ -775,14 +1402,17 @@ void fibril_yield(void)
 	if (fibril_self()->rmutex_locks > 0)
 		return;
 
-	fibril_t *f = _ready_list_pop_nonblocking(false);
+	fibril_t *f = _ready_list_pop_nonblocking();
 	if (f)
-		_fibril_switch_to(SWITCH_FROM_YIELD, f, false);
+		_fibril_switch_to(SWITCH_FROM_YIELD, f);
 }
 
 static void _runner_fn(void *arg)
 {
-	_helper_fibril_fn(arg);
+	/* Use the ready queue assigned by fibril_test_spawn_runners(). */
+	fibril_self()->runner = (unsigned int) (uintptr_t) arg;
+
+	_helper_fibril_fn(NULL);
 }
 
 /**
@@ -807,8 +1437,20 @@ int fibril_test_spawn_runners(int n)
 	errno_t rc;
 
 	for (int i = 0; i < n; i++) {
+		/*
+		 * Runners beyond RUNNER_MAX share ready queues with
+		 * the first ones.
+		 */
+		futex_lock(&fibril_futex);
+		unsigned int idx = runners_spawned % RUNNER_MAX;
+		runners_spawned++;
+		atomic_store_explicit(&runner_count,
+		    min(runners_spawned, RUNNER_MAX), memory_order_relaxed);
+		futex_unlock(&fibril_futex);
+
 		thread_id_t tid;
-		rc = thread_create(_runner_fn, NULL, "fibril runner", &tid);
+		rc = thread_create(_runner_fn, (void *) (uintptr_t) idx,
+		    "fibril runner", &tid);
 		if (rc != EOK)
 			return i;
 		thread_detach(tid);
@@ -835,6 +1477,18 @@ void fibril_enable_multithreaded(void)
 	}
 }
 
+/**
+ * Check whether fibrils can run on more than one thread.
+ *
+ * The answer changes from false to true before the first additional
+ * runner is started and never changes back, so a fibril that sees false
+ * cannot be running concurrently with any other fibril.
+ */
+bool fibril_is_multithreaded(void)
+{
+	return multithreaded;
+}
+
 /**
  * Detach a fibril.
  */
@@ -855,20 +1509,238 @@ _Noreturn void fibril_exit(long retval)
 	// TODO: implement fibril_join() and remember retval
 	(void) retval;
 
-	fibril_t *f = _ready_list_pop_nonblocking(false);
+	fibril_keys_release();
+
+	fibril_t *f = _ready_list_pop_nonblocking();
 	if (!f)
 		f = fibril_self()->thread_ctx;
 
-	_fibril_switch_to(SWITCH_FROM_DEAD, f, false);
+	_fibril_switch_to(SWITCH_FROM_DEAD, f);
 	__builtin_unreachable();
 }
 
+/** Create a key for fibril-local values.
+ *
+ * The value of the key is kept in a TCB slot, so getting and setting it
+ * is just a memory access. Initially, the value is NULL in all fibrils.
+ *
+ * @param[out] key       Created key.
+ * @param      destructor Function called with the non-NULL value of the key
+ *                        when a fibril exits, or NULL.
+ *
+ * @return EOK on success, EAGAIN if all slots are used.
+ */
+errno_t fibril_key_create(fibril_key_t *key, void (*destructor)(void *))
+{
+	futex_lock(&fibril_futex);
+
+	for (unsigned int slot = TLS_SLOT_KEY_FIRST; slot < TLS_SLOT_COUNT;
+	    slot++) {
+		if ((key_mask & (1u << slot)) == 0) {
+			key_mask |= 1u << slot;
+			key_destructors[slot] = destructor;
+			futex_unlock(&fibril_futex);
+			*key = slot;
+			return EOK;
+		}
+	}
+
+	futex_unlock(&fibril_futex);
+	return EAGAIN;
+}
+
+/** Delete a key for fibril-local values.
+ *
+ * No destructors are called.
+ *
+ * @param key Key that is not used anymore.
+ */
+void fibril_key_delete(fibril_key_t key)
+{
+	assert(key >= TLS_SLOT_KEY_FIRST && key < TLS_SLOT_COUNT);
+
+	futex_lock(&fibril_futex);
+
+	/* The slot must be NULL in all fibrils once it is reused. */
+	list_foreach(fibril_list, all_link, fibril_t, f)
+		f->tcb->slots[key].ptr = NULL;
+
+	key_mask &= ~(1u << key);
+	key_destructors[key] = NULL;
+
+	futex_unlock(&fibril_futex);
+}
+
+/** Get the value of a key in the current fibril. */
+void *fibril_key_get(fibril_key_t key)
+{
+	assert(key >= TLS_SLOT_KEY_FIRST && key < TLS_SLOT_COUNT);
+	return __tls_slot(key)->ptr;
+}
+
+/** Set the value of a key in the current fibril. */
+void fibril_key_set(fibril_key_t key, void *value)
+{
+	assert(key >= TLS_SLOT_KEY_FIRST && key < TLS_SLOT_COUNT);
+	__tls_slot(key)->ptr = value;
+}
+
+/** Call destructors of the keys set in the exiting fibril.
+ *
+ * A destructor may set a key again, so this is repeated a few times.
+ */
+void fibril_keys_release(void)
+{
+	for (int i = 0; i < FIBRIL_KEY_DESTRUCTOR_ITERATIONS; i++) {
+		bool called = false;
+
+		for (unsigned int slot = TLS_SLOT_KEY_FIRST;
+		    slot < TLS_SLOT_COUNT; slot++) {
+			tls_slot_t *s = __tls_slot(slot);
+			void (*destructor)(void *) = key_destructors[slot];
+
+			if (s->ptr != NULL && destructor != NULL) {
+				void *value = s->ptr;
+				s->ptr = NULL;
+				destructor(value);
+				called = true;
+			}
+		}
+
+		if (!called)
+			break;
+	}
+}
+
+/** Start tracking quiescent states of the current thread for fibril RCU.
+ *
+ * @param rt Tracking structure, must live as long as the thread
+ */
+void fibril_rcu_thread_register(fibril_rcu_thread_t *rt)
+{
+	atomic_init(&rt->switches, 0);
+	atomic_init(&rt->idle, false);
+	rt->gp_switches = 0;
+	rt->gp_wait = false;
+
+	futex_lock(&fibril_futex);
+	list_append(&rt->link, &rcu_threads);
+	futex_unlock(&fibril_futex);
+}
+
+/** Stop tracking quiescent states of an exiting thread. */
+void fibril_rcu_thread_unregister(fibril_rcu_thread_t *rt)
+{
+	futex_lock(&fibril_futex);
+	list_remove(&rt->link);
+	futex_unlock(&fibril_futex);
+}
+
+/** Check whether a thread has passed a quiescent state.
+ *
+ * @param rt Thread
+ * @return @c true if the thread is idle or has switched fibrils since
+ *         the grace period started
+ */
+static bool _rcu_thread_quiescent(fibril_rcu_thread_t *rt)
+{
+	return atomic_load_explicit(&rt->idle, memory_order_seq_cst) ||
+	    atomic_load_explicit(&rt->switches, memory_order_acquire) !=
+	    rt->gp_switches;
+}
+
+/**
+ * Wait until all RCU read-side critical sections that are running have
+ * finished.
+ *
+ * Readers may not block, so a thread that has switched fibrils or is idle
+ * has left any section it was in. The grace period thus ends once every
+ * thread has been seen doing so, without readers writing anything.
+ *
+ * Must not be called from an RCU read-side critical section.
+ */
+void fibril_rcu_synchronize(void)
+{
+	fibril_mutex_lock(&rcu_gp_lock);
+
+	/* Make the caller's updates visible before looking at the readers. */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	futex_lock(&fibril_futex);
+
+	bool wait = false;
+	list_foreach(rcu_threads, link, fibril_rcu_thread_t, rt) {
+		rt->gp_switches =
+		    atomic_load_explicit(&rt->switches, memory_order_acquire);
+
+		/* The caller's own thread is not running any reader. */
+		rt->gp_wait = rt != fibril_self()->rcu_thread &&
+		    !atomic_load_explicit(&rt->idle, memory_order_seq_cst);
+		wait = wait || rt->gp_wait;
+	}
+
+	while (wait) {
+		futex_unlock(&fibril_futex);
+		fibril_usleep(RCU_POLL_USEC);
+		futex_lock(&fibril_futex);
+
+		wait = false;
+		list_foreach(rcu_threads, link, fibril_rcu_thread_t, rt) {
+			if (rt->gp_wait && _rcu_thread_quiescent(rt))
+				rt->gp_wait = false;
+			wait = wait || rt->gp_wait;
+		}
+	}
+
+	futex_unlock(&fibril_futex);
+	fibril_mutex_unlock(&rcu_gp_lock);
+}
+
+/** Set the timer slack of the current fibril.
+ *
+ * Timeouts of the fibril may expire up to @a slack later than requested,
+ * which lets nearby timeouts share a single wakeup.
+ *
+ * @param slack Timer slack in microseconds, zero for precise timeouts.
+ */
+void fibril_set_timer_slack(usec_t slack)
+{
+	fibril_self()->timer_slack = USEC2NSEC(slack);
+}
+
+/** @return Timer slack of the current fibril in microseconds. */
+usec_t fibril_get_timer_slack(void)
+{
+	return NSEC2USEC(fibril_self()->timer_slack);
+}
+
+/** Get statistics of fibril timeouts. */
+void fibril_get_timeout_stats(fibril_timeout_stats_t *stats)
+{
+	futex_lock(&fibril_futex);
+	*stats = timeout_stats;
+	futex_unlock(&fibril_futex);
+}
+
 void __fibrils_init(void)
 {
 	if (futex_initialize(&fibril_futex, 1) != EOK)
 		abort();
 	if (futex_initialize(&ipc_lists_futex, 1) != EOK)
 		abort();
+	if (futex_initialize(&stack_cache_futex, 1) != EOK)
+		abort();
+
+	for (unsigned int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+		list_initialize(&timer_ticks[i]);
+		list_initialize(&timer_blocks[i]);
+	}
+
+	for (int i = 0; i < RUNNER_MAX; i++) {
+		if (futex_initialize(&runners[i].lock, 1) != EOK)
+			abort();
+		list_initialize(&runners[i].ready);
+	}
 
 	/*
 	 * We allow a fixed, small amount of parallelism for IPC reads, but
@@ -889,6 +1761,10 @@ void __fibrils_fini(void)
 {
 	futex_destroy(&fibril_futex);
 	futex_destroy(&ipc_lists_futex);
+	futex_destroy(&stack_cache_futex);
+
+	for (int i = 0; i < RUNNER_MAX; i++)
+		futex_destroy(&runners[i].lock);
 }
 
 void fibril_usleep(usec_t timeout)
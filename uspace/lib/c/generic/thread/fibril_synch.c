@@ -45,6 +45,8 @@
 #include <io/kio.h>
 #include <mem.h>
 #include <context.h>
+#include <malloc.h>
+#include <barrier.h>
 
 #include "../private/async.h"
 #include "../private/fibril.h"
@@ -107,6 +109,8 @@ typedef struct {
 	fibril_event_t event;
 	fibril_mutex_t *mutex;
 	fid_t fid;
+	/** Moved from a condition variable to the waiters of @c mutex */
+	bool morphed;
 } awaiter_t;
 
 #define AWAITER_INIT { .fid = fibril_get_id() }
@@ -297,6 +301,48 @@ void fibril_rwlock_write_lock(fibril_rwlock_t *frw)
 	fibril_wait_for(&wdata.event);
 }
 
+/** Try to lock a rwlock for reading without blocking.
+ *
+ * @param frw Rwlock
+ * @return @c true if the rwlock has been locked, @c false if it is
+ *         locked for writing
+ */
+bool fibril_rwlock_try_read_lock(fibril_rwlock_t *frw)
+{
+	bool locked = false;
+
+	futex_lock(&fibril_synch_futex);
+	if (!frw->writers) {
+		if (frw->readers++ == 0)
+			frw->oi.owned_by = fibril_self();
+		locked = true;
+	}
+	futex_unlock(&fibril_synch_futex);
+
+	return locked;
+}
+
+/** Try to lock a rwlock for writing without blocking.
+ *
+ * @param frw Rwlock
+ * @return @c true if the rwlock has been locked, @c false if it is
+ *         already locked
+ */
+bool fibril_rwlock_try_write_lock(fibril_rwlock_t *frw)
+{
+	bool locked = false;
+
+	futex_lock(&fibril_synch_futex);
+	if (!frw->writers && !frw->readers) {
+		frw->oi.owned_by = fibril_self();
+		frw->writers++;
+		locked = true;
+	}
+	futex_unlock(&fibril_synch_futex);
+
+	return locked;
+}
+
 static void _fibril_rwlock_common_unlock(fibril_rwlock_t *frw)
 {
 	if (frw->readers) {
@@ -392,6 +438,217 @@ bool fibril_rwlock_is_locked(fibril_rwlock_t *frw)
 	    fibril_rwlock_is_write_locked(frw);
 }
 
+/** Cache line size assumed when separating reader counts of runners. */
+#define DRWLOCK_CACHE_LINE 64
+
+/** Shared state of a distributed rwlock. */
+struct fibril_drwlock_counts {
+	/** A writer holds the lock or waits for readers to leave. */
+	_Alignas(DRWLOCK_CACHE_LINE) atomic_bool writer;
+	/** Readers that entered at a runner, minus those that left there. */
+	struct {
+		_Alignas(DRWLOCK_CACHE_LINE) atomic_long readers;
+	} runner[RUNNER_MAX];
+};
+
+/** Initialize a distributed rwlock.
+ *
+ * Unlike fibril_rwlock_t, readers of a distributed rwlock only update
+ * a reader count of the runner they run at and read the writer flag
+ * shared by all runners, so readers do not contend with each other.
+ * Writers wait until the reader counts sum up to zero, which makes them
+ * comparatively expensive. Use for data that is seldom modified.
+ *
+ * @param drw Distributed rwlock
+ * @return EOK on success or ENOMEM if out of memory
+ */
+errno_t fibril_drwlock_initialize(fibril_drwlock_t *drw)
+{
+	drw->counts = memalign(DRWLOCK_CACHE_LINE,
+	    sizeof(fibril_drwlock_counts_t));
+	if (drw->counts == NULL)
+		return ENOMEM;
+
+	atomic_init(&drw->counts->writer, false);
+	for (unsigned int i = 0; i < RUNNER_MAX; i++)
+		atomic_init(&drw->counts->runner[i].readers, 0);
+
+	fibril_mutex_initialize(&drw->lock);
+	fibril_condvar_initialize(&drw->cv);
+	return EOK;
+}
+
+/** Destroy an unlocked distributed rwlock.
+ *
+ * @param drw Distributed rwlock
+ */
+void fibril_drwlock_destroy(fibril_drwlock_t *drw)
+{
+	assert(!atomic_load_explicit(&drw->counts->writer,
+	    memory_order_relaxed));
+
+	free(drw->counts);
+	drw->counts = NULL;
+}
+
+/** @return Reader count of the current runner. */
+static atomic_long *_drwlock_readers(fibril_drwlock_t *drw)
+{
+	return &drw->counts->runner[fibril_self()->runner].readers;
+}
+
+/** @return Number of readers holding a distributed rwlock. */
+static long _drwlock_readers_total(fibril_drwlock_t *drw)
+{
+	long total = 0;
+
+	for (unsigned int i = 0; i < RUNNER_MAX; i++) {
+		total += atomic_load_explicit(&drw->counts->runner[i].readers,
+		    memory_order_seq_cst);
+	}
+
+	return total;
+}
+
+/** Lock a distributed rwlock for reading.
+ *
+ * A reader that unlocks at another runner than where it locked leaves
+ * the two counts off by one each, but their sum stays right.
+ *
+ * @param drw Distributed rwlock
+ */
+void fibril_drwlock_read_lock(fibril_drwlock_t *drw)
+{
+	atomic_long *readers = _drwlock_readers(drw);
+
+	/*
+	 * The writer sets its flag before summing the reader counts, so
+	 * either it sees our count or we see its flag.
+	 */
+	atomic_fetch_add_explicit(readers, 1, memory_order_seq_cst);
+	if (!atomic_load_explicit(&drw->counts->writer, memory_order_seq_cst))
+		return;
+
+	/* Back off and wait for the writer to finish. */
+	fibril_mutex_lock(&drw->lock);
+	atomic_fetch_sub_explicit(readers, 1, memory_order_seq_cst);
+	fibril_condvar_broadcast(&drw->cv);
+
+	while (atomic_load_explicit(&drw->counts->writer, memory_order_relaxed))
+		fibril_condvar_wait(&drw->cv, &drw->lock);
+
+	/* Writers set their flag with the mutex held, so this is safe. */
+	atomic_fetch_add_explicit(_drwlock_readers(drw), 1,
+	    memory_order_seq_cst);
+	fibril_mutex_unlock(&drw->lock);
+}
+
+/** Unlock a distributed rwlock locked for reading.
+ *
+ * @param drw Distributed rwlock
+ */
+void fibril_drwlock_read_unlock(fibril_drwlock_t *drw)
+{
+	atomic_fetch_sub_explicit(_drwlock_readers(drw), 1,
+	    memory_order_seq_cst);
+
+	if (atomic_load_explicit(&drw->counts->writer, memory_order_seq_cst)) {
+		/* The writer may be waiting for us to leave. */
+		fibril_mutex_lock(&drw->lock);
+		fibril_condvar_broadcast(&drw->cv);
+		fibril_mutex_unlock(&drw->lock);
+	}
+}
+
+/** Lock a distributed rwlock for writing.
+ *
+ * New readers wait as soon as the writer announces itself, so that the
+ * readers holding the lock eventually drain.
+ *
+ * @param drw Distributed rwlock
+ */
+void fibril_drwlock_write_lock(fibril_drwlock_t *drw)
+{
+	fibril_mutex_lock(&drw->lock);
+
+	while (atomic_load_explicit(&drw->counts->writer, memory_order_relaxed))
+		fibril_condvar_wait(&drw->cv, &drw->lock);
+
+	atomic_store_explicit(&drw->counts->writer, true,
+	    memory_order_seq_cst);
+
+	while (_drwlock_readers_total(drw) != 0)
+		fibril_condvar_wait(&drw->cv, &drw->lock);
+
+	fibril_mutex_unlock(&drw->lock);
+}
+
+/** Unlock a distributed rwlock locked for writing.
+ *
+ * @param drw Distributed rwlock
+ */
+void fibril_drwlock_write_unlock(fibril_drwlock_t *drw)
+{
+	fibril_mutex_lock(&drw->lock);
+	assert(atomic_load_explicit(&drw->counts->writer,
+	    memory_order_relaxed));
+	atomic_store_explicit(&drw->counts->writer, false,
+	    memory_order_seq_cst);
+	fibril_condvar_broadcast(&drw->cv);
+	fibril_mutex_unlock(&drw->lock);
+}
+
+/** Begin an RCU read-side critical section.
+ *
+ * Data published with fibril_rcu_assign() and read with
+ * fibril_rcu_access() inside the section is not freed until the section
+ * ends, provided the updater waits with fibril_rcu_synchronize() before
+ * freeing it. The section must not block or yield. Sections may nest.
+ *
+ * Apart from debugging checks, readers write no memory at all.
+ */
+void fibril_rcu_read_lock(void)
+{
+#ifndef NDEBUG
+	/* Catch readers that block, like in a restricted mutex section. */
+	fibril_self()->rmutex_locks++;
+#endif
+	compiler_barrier();
+}
+
+/** End an RCU read-side critical section. */
+void fibril_rcu_read_unlock(void)
+{
+	compiler_barrier();
+#ifndef NDEBUG
+	assert(fibril_self()->rmutex_locks > 0);
+	fibril_self()->rmutex_locks--;
+#endif
+}
+
+/** Pass a condition variable wakeup on to the mutex of the waiter.
+ *
+ * Instead of waking up only to contend for the mutex, the waiter gets
+ * the mutex right away if it is free or waits for it as though it called
+ * fibril_mutex_lock(). Must be called with fibril_synch_futex locked and
+ * the awaiter already removed from the condition variable.
+ */
+static void _fibril_condvar_morph_unsafe(awaiter_t *w)
+{
+	fibril_mutex_t *fm = w->mutex;
+	fibril_t *f = (fibril_t *) w->fid;
+
+	w->morphed = true;
+
+	if (fm->counter-- > 0) {
+		fm->oi.owned_by = f;
+		fibril_notify(&w->event);
+	} else {
+		list_append(&w->link, &fm->waiters);
+		f->waits_for = &fm->oi;
+	}
+}
+
 void fibril_condvar_initialize(fibril_condvar_t *fcv)
 {
 	list_initialize(&fcv->waiters);
@@ -430,6 +687,22 @@ fibril_condvar_wait_timeout(fibril_condvar_t *fcv, fibril_mutex_t *fm,
 	(void) fibril_wait_timeout(&wdata.event, expires);
 
 	futex_lock(&fibril_synch_futex);
+
+	if (wdata.morphed) {
+		/*
+		 * We were signalled and handed over to the mutex. If the wait
+		 * timed out meanwhile, keep waiting until we own the mutex.
+		 */
+		bool owner = (fm->oi.owned_by == (fibril_t *) wdata.fid);
+		futex_unlock(&fibril_synch_futex);
+
+		if (!owner)
+			fibril_wait_for(&wdata.event);
+
+		assert(fibril_mutex_is_locked(fm));
+		return EOK;
+	}
+
 	bool timed_out = link_in_use(&wdata.link);
 	list_remove(&wdata.link);
 	futex_unlock(&fibril_synch_futex);
@@ -450,7 +723,7 @@ void fibril_condvar_signal(fibril_condvar_t *fcv)
 
 	awaiter_t *w = list_pop(&fcv->waiters, awaiter_t, link);
 	if (w != NULL)
-		fibril_notify(&w->event);
+		_fibril_condvar_morph_unsafe(w);
 
 	futex_unlock(&fibril_synch_futex);
 }
@@ -459,9 +732,13 @@ void fibril_condvar_broadcast(fibril_condvar_t *fcv)
 {
 	futex_lock(&fibril_synch_futex);
 
+	/*
+	 * The waiters are queued on their mutex rather than all woken up,
+	 * so they get to run one after another as the mutex is passed on.
+	 */
 	awaiter_t *w;
 	while ((w = list_pop(&fcv->waiters, awaiter_t, link)))
-		fibril_notify(&w->event);
+		_fibril_condvar_morph_unsafe(w);
 
 	futex_unlock(&fibril_synch_futex);
 }
@@ -36,6 +36,9 @@
 #include <stdatomic.h>
 #include <fibril.h>
 #include <io/kio.h>
+#include <as.h>
+#include <ddi.h>
+#include <sysinfo.h>
 
 #include "../private/fibril.h"
 #include "../private/futex.h"
@@ -54,9 +57,162 @@ errno_t futex_initialize(futex_t *futex, int val)
 {
 	atomic_store_explicit(&futex->val, val, memory_order_relaxed);
 	futex->whandle = CAP_NIL;
+	atomic_store_explicit(&futex->holder, 0, memory_order_relaxed);
+	atomic_store_explicit(&futex->stats.contended, 0, memory_order_relaxed);
+	atomic_store_explicit(&futex->stats.spun, 0, memory_order_relaxed);
 	return futex_allocate_waitq(futex);
 }
 
+/** Maximum number of polls of a locked futex before going to sleep. */
+#define FUTEX_SPIN_MAX  1000
+
+/** IDs of the threads running on the CPUs, mapped from the kernel. */
+static const volatile sysarg_t *running_tid;
+/** Number of entries of running_tid, 0 if spinning is not worth it. */
+static size_t running_cpus;
+static atomic_bool running_probed;
+
+/** Map the kernel's table of running threads.
+ *
+ * Like the uptime page in getuptime(), the table is mapped lazily. Two
+ * threads may race to map it, in which case one mapping is leaked.
+ */
+static void futex_running_init(void)
+{
+	sysarg_t faddr;
+	sysarg_t cpus;
+
+	if (sysinfo_get_value("sched.running.faddr", &faddr) != EOK ||
+	    sysinfo_get_value("sched.running.cpus", &cpus) != EOK ||
+	    cpus < 2)
+		goto done;
+
+	void *addr = AS_AREA_ANY;
+	if (physmem_map(faddr, 1, AS_AREA_READ | AS_AREA_CACHEABLE,
+	    &addr) != EOK)
+		goto done;
+
+	running_tid = addr;
+	running_cpus = cpus;
+done:
+	atomic_store_explicit(&running_probed, true, memory_order_release);
+}
+
+/** Check whether a thread is running on some CPU.
+ *
+ * @param tid Thread ID.
+ * @return True if the kernel reports the thread as currently running.
+ */
+static bool futex_thread_running(sysarg_t tid)
+{
+	for (size_t i = 0; i < running_cpus; i++) {
+		if (running_tid[i] == tid)
+			return true;
+	}
+
+	return false;
+}
+
+/** Acquire a futex locked by another thread.
+ *
+ * Spin for a bounded time while the holder is running on another CPU,
+ * as it is likely to release the futex soon. Otherwise sleep in the
+ * kernel.
+ */
+static void futex_acquire_contended(futex_t *futex)
+{
+	atomic_fetch_add_explicit(&futex->stats.contended, 1,
+	    memory_order_relaxed);
+
+	if (!atomic_load_explicit(&running_probed, memory_order_acquire))
+		futex_running_init();
+
+	if (running_cpus > 0) {
+		for (unsigned int i = 0; i < FUTEX_SPIN_MAX; i++) {
+			int val = atomic_load_explicit(&futex->val,
+			    memory_order_relaxed);
+			if (val > 0) {
+				if (atomic_compare_exchange_weak_explicit(
+				    &futex->val, &val, val - 1,
+				    memory_order_acquire,
+				    memory_order_relaxed)) {
+					atomic_fetch_add_explicit(
+					    &futex->stats.spun, 1,
+					    memory_order_relaxed);
+					return;
+				}
+
+				continue;
+			}
+
+			/* The holder is not recorded yet right after acquiring. */
+			sysarg_t holder = atomic_load_explicit(&futex->holder,
+			    memory_order_relaxed);
+			if (holder != 0 && !futex_thread_running(holder))
+				break;
+		}
+	}
+
+	futex_down(futex);
+}
+
+/** Lock a futex.
+ *
+ * @param futex Futex initialized to 1.
+ */
+void __futex_acquire(futex_t *futex)
+{
+	int expected = 1;
+
+	if (!atomic_compare_exchange_strong_explicit(&futex->val, &expected,
+	    0, memory_order_acquire, memory_order_relaxed))
+		futex_acquire_contended(futex);
+
+	atomic_store_explicit(&futex->holder, fibril_self()->tid,
+	    memory_order_relaxed);
+}
+
+/** Try to lock a futex.
+ *
+ * @param futex Futex initialized to 1.
+ * @return True if the futex was locked.
+ */
+bool __futex_tryacquire(futex_t *futex)
+{
+	if (!futex_trydown(futex))
+		return false;
+
+	atomic_store_explicit(&futex->holder, fibril_self()->tid,
+	    memory_order_relaxed);
+	return true;
+}
+
+/** Unlock a futex.
+ *
+ * @param futex Futex locked by the current thread.
+ */
+void __futex_release(futex_t *futex)
+{
+	atomic_store_explicit(&futex->holder, 0, memory_order_relaxed);
+	futex_up(futex);
+}
+
+/** Print contention statistics of a futex.
+ *
+ * @param futex Futex.
+ * @param name  Name to print the statistics under.
+ */
+void __futex_stats_print(futex_t *futex, const char *name)
+{
+	unsigned int contended = atomic_load_explicit(&futex->stats.contended,
+	    memory_order_relaxed);
+	unsigned int spun = atomic_load_explicit(&futex->stats.spun,
+	    memory_order_relaxed);
+
+	kio_printf("futex %s (%p): %u contended, %u acquired by spinning, "
+	    "%u slept\n", name, futex, contended, spun, contended - spun);
+}
+
 #ifdef CONFIG_DEBUG_FUTEX
 
 void __futex_assert_is_locked(futex_t *futex, const char *name)
@@ -91,7 +247,7 @@ void __futex_lock(futex_t *futex, const char *name)
 	fibril_t *self = (fibril_t *) fibril_get_id();
 	DPRINTF("Locking futex %s (%p) by fibril %p.\n", name, futex, self);
 	__futex_assert_is_not_locked(futex, name);
-	futex_down(futex);
+	__futex_acquire(futex);
 
 	void *prev_owner = atomic_load_explicit(&futex->owner,
 	    memory_order_relaxed);
@@ -105,13 +261,13 @@ void __futex_unlock(futex_t *futex, const char *name)
 	DPRINTF("Unlocking futex %s (%p) by fibril %p.\n", name, futex, self);
 	__futex_assert_is_locked(futex, name);
 	atomic_store_explicit(&futex->owner, NULL, memory_order_relaxed);
-	futex_up(futex);
+	__futex_release(futex);
 }
 
 bool __futex_trylock(futex_t *futex, const char *name)
 {
 	fibril_t *self = (fibril_t *) fibril_get_id();
-	bool success = futex_trydown(futex);
+	bool success = __futex_tryacquire(futex);
 	if (success) {
 		void *owner = atomic_load_explicit(&futex->owner,
 		    memory_order_relaxed);
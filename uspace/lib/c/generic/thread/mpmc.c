@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Bounded multi-producer, multi-consumer channel
+ */
+
+#include <align.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * A multi-producer, multi-consumer concurrent FIFO channel with a fixed
+ * capacity.
+ *
+ * The messages are stored in a ring of cells, each with its own sequence
+ * number, following the bounded queue by D. Vyukov. Sending and receiving
+ * only take a compare-and-swap on the shared position and do not lock
+ * anything as long as the channel is neither full nor empty.
+ *
+ * Fibrils that have to wait sleep on a condition variable. The mutex
+ * protecting it is only taken by the waiters and by those who find a
+ * waiter registered after completing their operation.
+ *
+ * The state word counts the senders in progress and has a flag set once
+ * the channel is closed, so that the receivers do not report the end of
+ * the channel while the last messages are being stored.
+ */
+
+#define MPMC_CLOSED  ((size_t) 1 << (sizeof(size_t) * 8 - 1))
+
+typedef struct {
+	atomic_size_t seq;
+	alignas(max_align_t) unsigned char data[];
+} mpmc_cell_t;
+
+struct mpmc {
+	size_t elem_size;
+	/** Size of one cell including the message */
+	size_t cell_size;
+	/** Number of cells minus one */
+	size_t mask;
+	unsigned char *cells;
+
+	/** Position of the next send */
+	atomic_size_t send_pos;
+	/** Position of the next receive */
+	atomic_size_t recv_pos;
+	/** MPMC_CLOSED flag and the number of senders in progress */
+	atomic_size_t state;
+
+	/** Number of fibrils waiting to send or to receive */
+	atomic_uint send_waiting;
+	atomic_uint recv_waiting;
+
+	fibril_mutex_t lock;
+	fibril_condvar_t not_full;
+	fibril_condvar_t not_empty;
+};
+
+static inline mpmc_cell_t *mpmc_cell(mpmc_t *q, size_t pos)
+{
+	return (mpmc_cell_t *) (q->cells + (pos & q->mask) * q->cell_size);
+}
+
+/**
+ * Create a channel.
+ *
+ * @param elem_size Size of one message.
+ * @param capacity  Maximum number of messages buffered in the channel,
+ *                  rounded up to a power of two.
+ *
+ * @return New channel or NULL if out of memory.
+ */
+mpmc_t *mpmc_create(size_t elem_size, size_t capacity)
+{
+	size_t count = 2;
+	while (count < capacity) {
+		if (count > SIZE_MAX / 4)
+			return NULL;
+		count *= 2;
+	}
+
+	size_t cell_size = ALIGN_UP(sizeof(mpmc_cell_t) + elem_size,
+	    alignof(mpmc_cell_t));
+	if (cell_size > SIZE_MAX / count)
+		return NULL;
+
+	mpmc_t *q = calloc(1, sizeof(mpmc_t));
+	unsigned char *cells = malloc(count * cell_size);
+	if (!q || !cells) {
+		free(q);
+		free(cells);
+		return NULL;
+	}
+
+	q->elem_size = elem_size;
+	q->cell_size = cell_size;
+	q->mask = count - 1;
+	q->cells = cells;
+
+	for (size_t i = 0; i < count; i++)
+		atomic_init(&mpmc_cell(q, i)->seq, i);
+
+	atomic_init(&q->send_pos, 0);
+	atomic_init(&q->recv_pos, 0);
+	atomic_init(&q->state, 0);
+	atomic_init(&q->send_waiting, 0);
+	atomic_init(&q->recv_waiting, 0);
+
+	fibril_mutex_initialize(&q->lock);
+	fibril_condvar_initialize(&q->not_full);
+	fibril_condvar_initialize(&q->not_empty);
+	return q;
+}
+
+/**
+ * Destroy a channel. Messages left in the channel are discarded.
+ */
+void mpmc_destroy(mpmc_t *q)
+{
+	free(q->cells);
+	free(q);
+}
+
+static bool mpmc_try_push(mpmc_t *q, const void *b)
+{
+	size_t pos = atomic_load_explicit(&q->send_pos, memory_order_relaxed);
+	mpmc_cell_t *cell;
+
+	while (true) {
+		cell = mpmc_cell(q, pos);
+		size_t seq = atomic_load_explicit(&cell->seq,
+		    memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&q->send_pos,
+			    &pos, pos + 1, memory_order_relaxed,
+			    memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			/* The channel is full. */
+			return false;
+		} else {
+			pos = atomic_load_explicit(&q->send_pos,
+			    memory_order_relaxed);
+		}
+	}
+
+	memcpy(cell->data, b, q->elem_size);
+	atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+	return true;
+}
+
+static bool mpmc_try_pop(mpmc_t *q, void *b)
+{
+	size_t pos = atomic_load_explicit(&q->recv_pos, memory_order_relaxed);
+	mpmc_cell_t *cell;
+
+	while (true) {
+		cell = mpmc_cell(q, pos);
+		size_t seq = atomic_load_explicit(&cell->seq,
+		    memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t) (pos + 1);
+
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&q->recv_pos,
+			    &pos, pos + 1, memory_order_relaxed,
+			    memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			/* The channel is empty. */
+			return false;
+		} else {
+			pos = atomic_load_explicit(&q->recv_pos,
+			    memory_order_relaxed);
+		}
+	}
+
+	memcpy(b, cell->data, q->elem_size);
+	atomic_store_explicit(&cell->seq, pos + q->mask + 1,
+	    memory_order_release);
+	return true;
+}
+
+/** Wake up one fibril waiting on @a cv if there is any. */
+static void mpmc_wakeup(mpmc_t *q, atomic_uint *waiting,
+    fibril_condvar_t *cv)
+{
+	/* Pairs with the registration of the waiter in mpmc_wait(). */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (atomic_load_explicit(waiting, memory_order_relaxed) == 0)
+		return;
+
+	fibril_mutex_lock(&q->lock);
+	fibril_condvar_signal(cv);
+	fibril_mutex_unlock(&q->lock);
+}
+
+/** Wait on a condition variable until a deadline.
+ *
+ * @return EOK when woken up, ETIMEOUT when the deadline expired.
+ */
+static errno_t mpmc_wait(mpmc_t *q, fibril_condvar_t *cv,
+    const struct timespec *expires)
+{
+	if (expires == NULL) {
+		fibril_condvar_wait(cv, &q->lock);
+		return EOK;
+	}
+
+	struct timespec now;
+	getuptime(&now);
+	if (ts_gteq(&now, expires))
+		return ETIMEOUT;
+
+	usec_t timeout = max(NSEC2USEC(ts_sub_diff(expires, &now)), 1);
+	return fibril_condvar_wait_timeout(cv, &q->lock, timeout);
+}
+
+/** True if the channel is closed and no sender is in progress. */
+static bool mpmc_finished(mpmc_t *q)
+{
+	return atomic_load_explicit(&q->state, memory_order_acquire) ==
+	    MPMC_CLOSED;
+}
+
+/**
+ * Send data on the channel, waiting while the channel is full.
+ * The length of data is equal to the `elem_size` value set in `mpmc_create`.
+ *
+ * @param q       Channel.
+ * @param b       Message.
+ * @param expires Deadline, NULL to wait indefinitely.
+ *
+ * @return EOK on success, ETIMEOUT if the deadline expired, EINVAL if the
+ *         channel is closed.
+ */
+errno_t mpmc_send(mpmc_t *q, const void *b, const struct timespec *expires)
+{
+	errno_t rc = EOK;
+	size_t state = atomic_fetch_add_explicit(&q->state, 1,
+	    memory_order_acquire);
+
+	if ((state & MPMC_CLOSED) != 0) {
+		rc = EINVAL;
+	} else if (!mpmc_try_push(q, b)) {
+		fibril_mutex_lock(&q->lock);
+		atomic_fetch_add_explicit(&q->send_waiting, 1,
+		    memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+
+		while (true) {
+			if ((atomic_load_explicit(&q->state,
+			    memory_order_relaxed) & MPMC_CLOSED) != 0) {
+				rc = EINVAL;
+				break;
+			}
+
+			if (mpmc_try_push(q, b))
+				break;
+
+			rc = mpmc_wait(q, &q->not_full, expires);
+			if (rc != EOK)
+				break;
+		}
+
+		atomic_fetch_sub_explicit(&q->send_waiting, 1,
+		    memory_order_relaxed);
+		fibril_mutex_unlock(&q->lock);
+	}
+
+	state = atomic_fetch_sub_explicit(&q->state, 1, memory_order_release);
+
+	if (state == (MPMC_CLOSED | 1)) {
+		/* Let the receivers notice the end of the channel. */
+		fibril_mutex_lock(&q->lock);
+		fibril_condvar_broadcast(&q->not_empty);
+		fibril_mutex_unlock(&q->lock);
+	} else if (rc == EOK) {
+		mpmc_wakeup(q, &q->recv_waiting, &q->not_empty);
+	}
+
+	return rc;
+}
+
+/**
+ * Send data on the channel if it is not full.
+ *
+ * @return EOK on success, EAGAIN if the channel is full, EINVAL if the
+ *         channel is closed.
+ */
+errno_t mpmc_trysend(mpmc_t *q, const void *b)
+{
+	struct timespec expired = { .tv_sec = 0, .tv_nsec = 0 };
+	errno_t rc = mpmc_send(q, b, &expired);
+	return (rc == ETIMEOUT) ? EAGAIN : rc;
+}
+
+/**
+ * Receive data from the channel, waiting while the channel is empty.
+ *
+ * @param q       Channel.
+ * @param b       Buffer for the message.
+ * @param expires Deadline, NULL to wait indefinitely.
+ *
+ * @return EOK on success, ETIMEOUT if the deadline expired, ENOENT if the
+ *         channel is closed and there is no message left in it.
+ */
+errno_t mpmc_receive(mpmc_t *q, void *b, const struct timespec *expires)
+{
+	errno_t rc = EOK;
+
+	if (!mpmc_try_pop(q, b)) {
+		fibril_mutex_lock(&q->lock);
+		atomic_fetch_add_explicit(&q->recv_waiting, 1,
+		    memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+
+		while (true) {
+			if (mpmc_try_pop(q, b))
+				break;
+
+			/* Messages may be stored until the last sender is done. */
+			if (mpmc_finished(q)) {
+				if (!mpmc_try_pop(q, b))
+					rc = ENOENT;
+				break;
+			}
+
+			rc = mpmc_wait(q, &q->not_empty, expires);
+			if (rc != EOK)
+				break;
+		}
+
+		atomic_fetch_sub_explicit(&q->recv_waiting, 1,
+		    memory_order_relaxed);
+		fibril_mutex_unlock(&q->lock);
+	}
+
+	if (rc == EOK)
+		mpmc_wakeup(q, &q->send_waiting, &q->not_full);
+
+	return rc;
+}
+
+/**
+ * Receive data from the channel if it is not empty.
+ *
+ * @return EOK on success, EAGAIN if the channel is empty, ENOENT if the
+ *         channel is closed and there is no message left in it.
+ */
+errno_t mpmc_tryreceive(mpmc_t *q, void *b)
+{
+	struct timespec expired = { .tv_sec = 0, .tv_nsec = 0 };
+	errno_t rc = mpmc_receive(q, b, &expired);
+	return (rc == ETIMEOUT) ? EAGAIN : rc;
+}
+
+/**
+ * Close the channel.
+ *
+ * Pending and future sends fail, receives fail once the channel is empty.
+ */
+void mpmc_close(mpmc_t *q)
+{
+	atomic_fetch_or_explicit(&q->state, MPMC_CLOSED, memory_order_acq_rel);
+
+	fibril_mutex_lock(&q->lock);
+	fibril_condvar_broadcast(&q->not_full);
+	fibril_condvar_broadcast(&q->not_empty);
+	fibril_mutex_unlock(&q->lock);
+}
+
+/** @}
+ */
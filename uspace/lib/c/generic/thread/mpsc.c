@@ -31,9 +31,11 @@
  *	Jiří Zárevúcky (jzr) <zarevucky.jiri@gmail.com>
  */
 
+#include <adt/mpsc_queue.h>
 #include <fibril.h>
 #include <fibril_synch.h>
 #include <mem.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 
 #include "../private/fibril.h"
@@ -42,87 +44,82 @@
  * A multi-producer, single-consumer concurrent FIFO channel with unlimited
  * buffering.
  *
- * The current implementation is based on the super simple two-lock queue
- * by Michael and Scott
- * (http://www.cs.rochester.edu/~scott/papers/1996_PODC_queues.pdf)
+ * Messages are kept in an intrusive lock-free queue (see adt/mpsc_queue.h),
+ * so neither sending nor receiving takes a lock.
  *
- * The original algorithm uses one lock on each side. Since this queue is
- * single-consumer, we only use the tail lock.
+ * Closing has to be ordered with respect to the concurrent senders: every
+ * message sent successfully must be received before the close node. The
+ * state word counts the senders in progress and has a flag set once the
+ * channel is closed. Whoever leaves the state at just the flag, the closer
+ * or the last sender in progress, claims the close node by setting a second
+ * flag and pushes it.
  */
 
+#define MPSC_CLOSED  ((size_t) 1 << (sizeof(size_t) * 8 - 1))
+#define MPSC_CLOSE_PUSHED  ((size_t) 1 << (sizeof(size_t) * 8 - 2))
+
 typedef struct mpsc_node mpsc_node_t;
 
 struct mpsc {
 	size_t elem_size;
-	fibril_rmutex_t t_lock;
-	mpsc_node_t *head;
-	mpsc_node_t *tail;
+	mpsc_queue_t queue;
+	/** MPSC_CLOSED flag and the number of senders in progress */
+	atomic_size_t state;
+	/** The consumer has received the close node */
+	bool drained;
 	mpsc_node_t *close_node;
 	fibril_event_t event;
 };
 
 struct mpsc_node {
-	mpsc_node_t *next;
+	mpsc_link_t link;
 	unsigned char data[];
 };
 
 mpsc_t *mpsc_create(size_t elem_size)
 {
 	mpsc_t *q = calloc(1, sizeof(mpsc_t));
-	mpsc_node_t *n = calloc(1, sizeof(mpsc_node_t) + elem_size);
-	mpsc_node_t *c = calloc(1, sizeof(mpsc_node_t) + elem_size);
+	mpsc_node_t *c = calloc(1, sizeof(mpsc_node_t));
 
-	if (!q || !n || !c) {
+	if (!q || !c) {
 		free(q);
-		free(n);
-		free(c);
-		return NULL;
-	}
-
-	if (fibril_rmutex_initialize(&q->t_lock) != EOK) {
-		free(q);
-		free(n);
 		free(c);
 		return NULL;
 	}
 
 	q->elem_size = elem_size;
-	q->head = q->tail = n;
+	mpsc_queue_initialize(&q->queue);
+	atomic_store_explicit(&q->state, 0, memory_order_relaxed);
 	q->close_node = c;
 	return q;
 }
 
 void mpsc_destroy(mpsc_t *q)
 {
-	mpsc_node_t *n = q->head;
-	mpsc_node_t *next = NULL;
-	while (n != NULL) {
-		next = n->next;
-		free(n);
-		n = next;
-	}
+	mpsc_link_t *link;
 
-	fibril_rmutex_destroy(&q->t_lock);
+	while ((link = mpsc_queue_pop(&q->queue)) != NULL) {
+		mpsc_node_t *n = mpsc_queue_get_inst(link, mpsc_node_t, link);
+		if (n != q->close_node)
+			free(n);
+	}
 
+	free(q->close_node);
 	free(q);
 }
 
-static errno_t _mpsc_push(mpsc_t *q, mpsc_node_t *n)
+static void _mpsc_push_close(mpsc_t *q)
 {
-	fibril_rmutex_lock(&q->t_lock);
-
-	if (q->tail == q->close_node) {
-		fibril_rmutex_unlock(&q->t_lock);
-		return EINVAL;
-	}
+	size_t state = MPSC_CLOSED;
 
-	__atomic_store_n(&q->tail->next, n, __ATOMIC_RELEASE);
-	q->tail = n;
-
-	fibril_rmutex_unlock(&q->t_lock);
+	/* Senders failing after the close must not push the node twice. */
+	if (!atomic_compare_exchange_strong_explicit(&q->state, &state,
+	    MPSC_CLOSED | MPSC_CLOSE_PUSHED, memory_order_acq_rel,
+	    memory_order_relaxed))
+		return;
 
+	mpsc_queue_push(&q->queue, &q->close_node->link);
 	fibril_notify(&q->event);
-	return EOK;
 }
 
 /**
@@ -139,10 +136,29 @@ errno_t mpsc_send(mpsc_t *q, const void *b)
 	if (!n)
 		return ENOMEM;
 
-	n->next = NULL;
 	memcpy(n->data, b, q->elem_size);
 
-	return _mpsc_push(q, n);
+	errno_t rc = EINVAL;
+	size_t state = atomic_fetch_add_explicit(&q->state, 1,
+	    memory_order_acquire);
+
+	if ((state & MPSC_CLOSED) == 0) {
+		mpsc_queue_push(&q->queue, &n->link);
+		rc = EOK;
+	}
+
+	state = atomic_fetch_sub_explicit(&q->state, 1, memory_order_release);
+
+	if (rc == EOK)
+		fibril_notify(&q->event);
+	else
+		free(n);
+
+	/* The channel was closed while we were sending. */
+	if (state == (MPSC_CLOSED | 1))
+		_mpsc_push_close(q);
+
+	return rc;
 }
 
 /**
@@ -153,13 +169,14 @@ errno_t mpsc_send(mpsc_t *q, const void *b)
  */
 errno_t mpsc_receive(mpsc_t *q, void *b, const struct timespec *expires)
 {
-	mpsc_node_t *n;
-	mpsc_node_t *new_head;
+	mpsc_link_t *link;
+
+	if (q->drained)
+		return ENOENT;
 
 	while (true) {
-		n = q->head;
-		new_head = __atomic_load_n(&n->next, __ATOMIC_ACQUIRE);
-		if (new_head)
+		link = mpsc_queue_pop(&q->queue);
+		if (link)
 			break;
 
 		errno_t rc = fibril_wait_timeout(&q->event, expires);
@@ -167,11 +184,13 @@ errno_t mpsc_receive(mpsc_t *q, void *b, const struct timespec *expires)
 			return rc;
 	}
 
-	if (new_head == q->close_node)
+	mpsc_node_t *n = mpsc_queue_get_inst(link, mpsc_node_t, link);
+	if (n == q->close_node) {
+		q->drained = true;
 		return ENOENT;
+	}
 
-	memcpy(b, new_head->data, q->elem_size);
-	q->head = new_head;
+	memcpy(b, n->data, q->elem_size);
 
 	free(n);
 	return EOK;
@@ -184,5 +203,10 @@ errno_t mpsc_receive(mpsc_t *q, void *b, const struct timespec *expires)
  */
 void mpsc_close(mpsc_t *q)
 {
-	_mpsc_push(q, q->close_node);
+	size_t state = atomic_fetch_or_explicit(&q->state, MPSC_CLOSED,
+	    memory_order_acq_rel);
+
+	/* If there are senders in progress, the last of them pushes. */
+	if (state == 0)
+		_mpsc_push_close(q);
 }
@@ -64,6 +64,11 @@ void __thread_main(uspace_arg_t *uarg)
 	assert(fibril);
 
 	__tcb_set(fibril->tcb);
+	fibril->tid = (sysarg_t) thread_get_id();
+
+	fibril_rcu_thread_t rcu_thread;
+	fibril_rcu_thread_register(&rcu_thread);
+	fibril->rcu_thread = &rcu_thread;
 
 	uarg->uspace_thread_function(fibril->arg);
 	/*
@@ -73,6 +78,8 @@ void __thread_main(uspace_arg_t *uarg)
 	 * free(uarg);
 	 */
 
+	fibril_rcu_thread_unregister(&rcu_thread);
+	fibril_keys_release();
 	fibril_teardown(fibril);
 	thread_exit(0);
 }
@@ -51,6 +51,11 @@
 #include <loc.h>
 #include <device/clock_dev.h>
 #include <stats.h>
+#include <libarch/config.h>
+
+#ifdef CYCLE_ARCH
+#include <libarch/cycle.h>
+#endif
 
 #define ASCTIME_BUF_LEN  27
 
@@ -67,6 +72,12 @@ struct {
 	volatile sysarg_t seconds1;
 	volatile sysarg_t useconds;
 	volatile sysarg_t seconds2;
+
+	volatile uint32_t counter_seq;
+	volatile uint32_t counter_shift;
+	volatile uint64_t counter_mult;
+	volatile uint64_t counter_base;
+	volatile uint64_t nsec_base;
 } *ktime = NULL;
 
 static async_sess_t *clock_conn = NULL;
@@ -646,6 +657,57 @@ fallback:
 	getuptime(ts);
 }
 
+#ifdef CYCLE_ARCH
+
+/** Compute system uptime from the cycle counter.
+ *
+ * The kernel publishes the uptime at some value of the cycle counter and
+ * the rate of the counter. The parameters are consistent if the sequence
+ * counter is even and does not change while they are being read.
+ *
+ * @param[out] ts  Timespec to hold time current uptime.
+ *
+ * @return False if the kernel does not support the cycle counter.
+ *
+ */
+static bool getuptime_counter(struct timespec *ts)
+{
+	uint32_t seq;
+	uint32_t shift;
+	uint64_t mult;
+	uint64_t base;
+	uint64_t nsec;
+	uint64_t now;
+
+	do {
+		seq = ktime->counter_seq;
+		read_barrier();
+
+		shift = ktime->counter_shift;
+		mult = ktime->counter_mult;
+		base = ktime->counter_base;
+		nsec = ktime->nsec_base;
+		now = arch_cycle_get();
+
+		read_barrier();
+	} while (((seq & 1) != 0) || (ktime->counter_seq != seq));
+
+	if (mult == 0)
+		return false;
+
+	/* The counters of the processors may be slightly out of sync */
+	uint64_t cycles = (now > base) ? now - base : 0;
+	uint64_t mask = ((uint64_t) 1 << shift) - 1;
+
+	nsec += (cycles >> shift) * mult + (((cycles & mask) * mult) >> shift);
+
+	ts->tv_sec = nsec / NSECS_PER_SEC;
+	ts->tv_nsec = nsec % NSECS_PER_SEC;
+	return true;
+}
+
+#endif
+
 /** Get system uptime.
  *
  * @param[out] ts  Timespec to hold time current uptime.
@@ -653,10 +715,13 @@ fallback:
  * The time variables are memory mapped (read-only) from kernel which
  * updates them periodically.
  *
- * As it is impossible to read 2 values atomically, we use a trick:
- * First we read the seconds, then we read the microseconds, then we
- * read the seconds again. If a second elapsed in the meantime, set
- * the microseconds to zero.
+ * If the kernel publishes the parameters of the cycle counter, the
+ * uptime is computed from the counter with nanosecond resolution.
+ *
+ * Otherwise the uptime advances with the clock tick. As it is impossible
+ * to read 2 values atomically, we use a trick: First we read the seconds,
+ * then we read the microseconds, then we read the seconds again. If
+ * a second elapsed in the meantime, set the microseconds to zero.
  *
  * This assures that the values returned by two subsequent calls
  * to getuptime() are monotonous.
@@ -684,6 +749,11 @@ void getuptime(struct timespec *ts)
 		ktime = addr;
 	}
 
+#ifdef CYCLE_ARCH
+	if (getuptime_counter(ts))
+		return;
+#endif
+
 	sysarg_t s2 = ktime->seconds2;
 
 	read_barrier();
@@ -33,6 +33,7 @@
  */
 
 #include <udebug.h>
+#include <errno.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <abi/ipc/methods.h>
@@ -44,6 +45,18 @@ errno_t udebug_begin(async_sess_t *sess)
 	return async_req_1_0(exch, IPC_M_DEBUG, UDEBUG_M_BEGIN);
 }
 
+/** Begin a sampling session.
+ *
+ * The threads of the task are never stopped, the kernel only collects
+ * statistics which can be read by udebug_stats_read().
+ */
+errno_t udebug_begin_sampling(async_sess_t *sess)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	return async_req_2_0(exch, IPC_M_DEBUG, UDEBUG_M_BEGIN,
+	    UDEBUG_BF_SAMPLING);
+}
+
 errno_t udebug_end(async_sess_t *sess)
 {
 	async_exch_t *exch = async_exchange_begin(sess);
@@ -101,6 +114,21 @@ errno_t udebug_areas_read(async_sess_t *sess, void *buffer, size_t n,
 	return rc;
 }
 
+errno_t udebug_stats_read(async_sess_t *sess, udebug_stats_t *stats)
+{
+	sysarg_t a_copied, a_needed;
+
+	async_exch_t *exch = async_exchange_begin(sess);
+	errno_t rc = async_req_3_3(exch, IPC_M_DEBUG, UDEBUG_M_STATS_READ,
+	    (sysarg_t) stats, sizeof(udebug_stats_t), NULL, &a_copied,
+	    &a_needed);
+
+	if (rc == EOK && a_copied != sizeof(udebug_stats_t))
+		rc = EIO;
+
+	return rc;
+}
+
 errno_t udebug_mem_read(async_sess_t *sess, void *buffer, uintptr_t addr, size_t n)
 {
 	async_exch_t *exch = async_exchange_begin(sess);
@@ -108,6 +136,20 @@ errno_t udebug_mem_read(async_sess_t *sess, void *buffer, uintptr_t addr, size_t
 	    (sysarg_t) buffer, addr, n);
 }
 
+/** Read several ranges of the debugged task's memory at once.
+ *
+ * The contents of the ranges are stored one after another into @a buffer.
+ * There may be at most UDEBUG_MEMV_MAX_RANGES ranges of total size up to
+ * UDEBUG_MEMV_MAX_SIZE bytes.
+ */
+errno_t udebug_mem_readv(async_sess_t *sess, void *buffer,
+    const udebug_mem_range_t *ranges, size_t n)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	return async_req_4_0(exch, IPC_M_DEBUG, UDEBUG_M_MEM_READV,
+	    (sysarg_t) buffer, (sysarg_t) ranges, n);
+}
+
 errno_t udebug_args_read(async_sess_t *sess, thash_t tid, sysarg_t *buffer)
 {
 	async_exch_t *exch = async_exchange_begin(sess);
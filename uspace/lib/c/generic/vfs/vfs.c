@@ -47,9 +47,12 @@
 #include <errno.h>
 #include <assert.h>
 #include <str.h>
+#include <mem.h>
 #include <loc.h>
 #include <ipc/vfs.h>
 #include <ipc/loc.h>
+#include <abi/ipc/methods.h>
+#include <as.h>
 
 /*
  * This file contains the implementation of the native HelenOS file system API.
@@ -127,6 +130,13 @@ static size_t cwd_size = 0;
 static FIBRIL_MUTEX_INITIALIZE(root_mutex);
 static int root_fd = -1;
 
+/** Size of the on-stack buffer for gathering small vectored transfers */
+#define VFS_IOV_LOCAL_SIZE  256
+
+static errno_t vfs_read_pipelined(int, aoff64_t, void *, size_t, ssize_t *);
+static errno_t vfs_write_pipelined(int, aoff64_t, const void *, size_t,
+    ssize_t *);
+
 static errno_t get_parent_and_child(const char *path, int *parent, char **child)
 {
 	size_t size;
@@ -677,6 +687,8 @@ errno_t vfs_mount_path(const char *mp, const char *fs_name, const char *fqsn,
 		fqsn = null;
 	}
 
+	unsigned int no_dcache = flags & VFS_MOUNT_NO_DCACHE;
+
 	if (flags & IPC_FLAG_BLOCKING)
 		flags = VFS_MOUNT_BLOCKING;
 	else
@@ -691,6 +703,8 @@ errno_t vfs_mount_path(const char *mp, const char *fs_name, const char *fqsn,
 		return res;
 	}
 
+	flags |= no_dcache;
+
 	size_t mpa_size;
 	char *mpa = vfs_absolutize(mp, &mpa_size);
 	if (mpa == NULL) {
@@ -744,6 +758,158 @@ errno_t vfs_mount_path(const char *mp, const char *fs_name, const char *fqsn,
 	return (errno_t) rc;
 }
 
+/** Mapping of a file into the address space. */
+typedef struct {
+	link_t link;
+	/** Address of the area. */
+	void *addr;
+	/** File handle used by the VFS pager to page the area in. */
+	int file;
+} vfs_mapping_t;
+
+static FIBRIL_MUTEX_INITIALIZE(mappings_mutex);
+static LIST_INITIALIZE(mappings);
+static async_sess_t *pager_sess = NULL;
+
+/** Find a file mapping.
+ *
+ * @param addr  Address of the mapping
+ *
+ * @return      Mapping or NULL if @a addr does not map a file
+ */
+static vfs_mapping_t *vfs_mapping_find(void *addr)
+{
+	assert(fibril_mutex_is_locked(&mappings_mutex));
+
+	list_foreach(mappings, link, vfs_mapping_t, map) {
+		if (map->addr == addr)
+			return map;
+	}
+
+	return NULL;
+}
+
+/** Map a file into the address space
+ *
+ * The mapping is paged in by VFS. Read-only and shared mappings use the
+ * pages of the VFS page cache of the file, which are shared by all such
+ * mappings of the file. Modifications of a shared mapping are written back
+ * to the file by vfs_msync() and when the last mapping of the file goes
+ * away. Writable private mappings get their own copies of the pages.
+ *
+ * @param file      File handle permitting reading, and also writing if the
+ *                  mapping is writable and shared
+ * @param pos       Page-aligned file offset of the mapping
+ * @param base      Requested address of the mapping or AS_AREA_ANY
+ * @param size      Size of the mapping
+ * @param flags     Address space area flags (AS_AREA_READ etc.)
+ * @param shared    True for a shared mapping, false for a private one
+ * @param[out] addr Place to store the address of the mapping
+ *
+ * @return          EOK on success or an error code
+ */
+errno_t vfs_mmap(int file, aoff64_t pos, void *base, size_t size,
+    unsigned int flags, bool shared, void **addr)
+{
+	if ((pos & (PAGE_SIZE - 1)) != 0)
+		return EINVAL;
+	if ((sysarg_t) pos != pos)
+		return EOVERFLOW;
+
+	vfs_mapping_t *map = malloc(sizeof(vfs_mapping_t));
+	if (map == NULL)
+		return ENOMEM;
+
+	fibril_mutex_lock(&mappings_mutex);
+
+	if (pager_sess == NULL) {
+		pager_sess = service_connect_blocking(SERVICE_VFS,
+		    INTERFACE_PAGER, 0);
+		if (pager_sess == NULL) {
+			fibril_mutex_unlock(&mappings_mutex);
+			free(map);
+			return ENOENT;
+		}
+	}
+
+	/* The mapping keeps its own open file handle. */
+	errno_t rc = vfs_clone(file, -1, false, &map->file);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&mappings_mutex);
+		free(map);
+		return rc;
+	}
+
+	bool write = shared && (flags & AS_AREA_WRITE);
+	rc = vfs_open(map->file, write ? MODE_READ | MODE_WRITE : MODE_READ);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&mappings_mutex);
+		vfs_put(map->file);
+		free(map);
+		return rc;
+	}
+
+	map->addr = async_as_area_create(base, size, flags, pager_sess,
+	    map->file, pos, shared ? VFS_MAP_SHARED : 0);
+	if (map->addr == AS_MAP_FAILED) {
+		fibril_mutex_unlock(&mappings_mutex);
+		vfs_put(map->file);
+		free(map);
+		return ENOMEM;
+	}
+
+	link_initialize(&map->link);
+	list_append(&map->link, &mappings);
+	*addr = map->addr;
+
+	fibril_mutex_unlock(&mappings_mutex);
+	return EOK;
+}
+
+/** Unmap a file mapped by vfs_mmap()
+ *
+ * @param addr  Address of the mapping
+ *
+ * @return      EOK on success, ENOENT if @a addr does not map a file
+ */
+errno_t vfs_munmap(void *addr)
+{
+	fibril_mutex_lock(&mappings_mutex);
+
+	vfs_mapping_t *map = vfs_mapping_find(addr);
+	if (map == NULL) {
+		fibril_mutex_unlock(&mappings_mutex);
+		return ENOENT;
+	}
+
+	list_remove(&map->link);
+	fibril_mutex_unlock(&mappings_mutex);
+
+	(void) as_area_destroy(map->addr);
+
+	/* Closing the last handle mapping the file writes the pages back. */
+	errno_t rc = vfs_put(map->file);
+	free(map);
+	return rc;
+}
+
+/** Write back the modifications of a file mapped by vfs_mmap()
+ *
+ * @param addr  Address of the mapping
+ *
+ * @return      EOK on success, ENOENT if @a addr does not map a file
+ */
+errno_t vfs_msync(void *addr)
+{
+	fibril_mutex_lock(&mappings_mutex);
+
+	vfs_mapping_t *map = vfs_mapping_find(addr);
+	errno_t rc = (map != NULL) ? vfs_sync(map->file) : ENOENT;
+
+	fibril_mutex_unlock(&mappings_mutex);
+	return rc;
+}
+
 /** Open a file handle for I/O
  *
  * @param file  File handle to enable I/O on
@@ -847,7 +1013,10 @@ errno_t vfs_read(int file, aoff64_t *pos, void *buf, size_t nbyte, size_t *nread
 		bp += cnt;
 		nr += cnt;
 		*pos += cnt;
-		rc = vfs_read_short(file, *pos, bp, nbyte - nr, &cnt);
+		if (cnt == DATA_XFER_LIMIT && nbyte - nr > DATA_XFER_LIMIT)
+			rc = vfs_read_pipelined(file, *pos, bp, nbyte - nr, &cnt);
+		else
+			rc = vfs_read_short(file, *pos, bp, nbyte - nr, &cnt);
 	} while (rc == EOK && cnt > 0 && (nbyte - nr - cnt) > 0);
 
 	if (rc != EOK) {
@@ -861,6 +1030,159 @@ errno_t vfs_read(int file, aoff64_t *pos, void *buf, size_t nbyte, size_t *nread
 	return EOK;
 }
 
+/** Read bytes from a file using several requests in flight
+ *
+ * Splits the read into DATA_XFER_LIMIT-sized chunks and keeps up to
+ * ASYNC_BATCH_MAX of them in flight on one exchange. The result covers
+ * the chunks up to and including the first short one; whatever the
+ * later chunks stored in @a buf beyond that is not part of the result.
+ *
+ * @param file          File handle to read from
+ * @param[in] pos       Position to read from
+ * @param buf           Buffer to read to
+ * @param nbyte         Number of bytes to read
+ * @param[out] nread	Actual number of bytes read (0 or more)
+ *
+ * @return              EOK on success or an error code
+ */
+static errno_t vfs_read_pipelined(int file, aoff64_t pos, void *buf,
+    size_t nbyte, ssize_t *nread)
+{
+	uint8_t *bp = (uint8_t *) buf;
+	async_batch_t batch;
+	ipc_call_t answer;
+	size_t sent = 0;
+	size_t done = 0;
+	errno_t rc = EOK;
+
+	async_exch_t *exch = vfs_exchange_begin();
+	async_batch_init(&batch, exch);
+
+	while (true) {
+		while (sent < nbyte &&
+		    async_batch_pending(&batch) < ASYNC_BATCH_MAX) {
+			size_t chunk = min(nbyte - sent, DATA_XFER_LIMIT);
+			aoff64_t cpos = pos + sent;
+
+			async_batch_data_read_3(&batch, VFS_IN_READ, file,
+			    LOWER32(cpos), UPPER32(cpos), bp + sent, chunk);
+			sent += chunk;
+		}
+
+		if (async_batch_pending(&batch) == 0)
+			break;
+
+		size_t expect = min(nbyte - done, DATA_XFER_LIMIT);
+		rc = async_batch_wait(&batch, &answer);
+		if (rc != EOK)
+			break;
+
+		size_t cnt = ipc_get_arg1(&answer);
+		done += cnt;
+		if (cnt < expect)
+			break;
+	}
+
+	async_batch_drain(&batch);
+	vfs_exchange_end(exch);
+
+	if (rc != EOK && done == 0)
+		return rc;
+
+	*nread = (ssize_t) done;
+	return EOK;
+}
+
+/** Create a buffer for reading a file without copying through VFS
+ *
+ * The buffer is shared with VFS and, if the file system supports it, with
+ * the file system server, which then copies file data straight into it.
+ * Data are read into the buffer using vfs_read_buffer(). The buffer stays
+ * shared until the file handle is closed, the caller should destroy it
+ * using as_area_destroy() afterwards.
+ *
+ * @param file          File handle open for reading
+ * @param size          Size of the buffer
+ * @param[out] buf      Place to store the address of the buffer
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_read_buffer_create(int file, size_t size, void **buf)
+{
+	void *area = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED)
+		return ENOMEM;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	ipc_call_t answer;
+	aid_t req = async_send_1(exch, VFS_IN_SHARE_BUFFER, file, &answer);
+	errno_t rc = async_share_out_start(exch, area,
+	    AS_AREA_READ | AS_AREA_WRITE);
+
+	vfs_exchange_end(exch);
+
+	if (rc == EOK)
+		async_wait_for(req, &rc);
+	else
+		async_forget(req);
+
+	if (rc != EOK) {
+		as_area_destroy(area);
+		return rc;
+	}
+
+	*buf = area;
+	return EOK;
+}
+
+/** Read bytes from a file into its shared buffer
+ *
+ * Read up to @a nbyte bytes from file to the buffer created by
+ * vfs_read_buffer_create(), starting at @a offset in the buffer. Fewer bytes
+ * are read only at the end of the file or on error.
+ *
+ * @param file          File handle to read from
+ * @param[in,out] pos   Position to read from, updates by the number of bytes
+ *                      read
+ * @param offset        Offset in the buffer to read to
+ * @param nbyte         Number of bytes to read
+ * @param[out] nread    Actual number of bytes read (0 or more)
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_read_buffer(int file, aoff64_t *pos, size_t offset, size_t nbyte,
+    size_t *nread)
+{
+	size_t done = 0;
+	errno_t rc = EOK;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	while (done < nbyte) {
+		aoff64_t p = *pos + done;
+		ipc_call_t answer;
+		aid_t req = async_send_5(exch, VFS_IN_READ_BUFFER, file,
+		    LOWER32(p), UPPER32(p), offset + done, nbyte - done,
+		    &answer);
+		async_wait_for(req, &rc);
+		if (rc != EOK || ipc_get_arg1(&answer) == 0)
+			break;
+
+		done += ipc_get_arg1(&answer);
+	}
+
+	vfs_exchange_end(exch);
+
+	if (rc != EOK && done == 0)
+		return rc;
+
+	*pos += done;
+	*nread = done;
+	return EOK;
+}
+
 /** Read bytes from a file
  *
  * Read up to @a nbyte bytes from file. The actual number of bytes read
@@ -906,6 +1228,240 @@ errno_t vfs_read_short(int file, aoff64_t pos, void *buf, size_t nbyte,
 	return EOK;
 }
 
+/** Read directory entries
+ *
+ * Reads as many entries of a directory as fit into the buffer with a
+ * single request. The entries are packed one after another, each starting
+ * with a vfs_dirent_t header followed by the null-terminated name. Zero
+ * bytes are read at the end of the directory.
+ *
+ * @param file          Directory handle
+ * @param pos           Position of the first entry to read
+ * @param buf           Buffer for the entries
+ * @param size          Size of the buffer
+ * @param[out] nread    Number of bytes of the buffer filled
+ *
+ * @return              EOK on success, ENOTSUP if the file system does not
+ *                      support reading multiple entries, or an error code
+ */
+errno_t vfs_readdir(int file, aoff64_t pos, void *buf, size_t size,
+    size_t *nread)
+{
+	errno_t rc;
+	ipc_call_t answer;
+	aid_t req;
+
+	if (size > DATA_XFER_LIMIT)
+		size = DATA_XFER_LIMIT;
+
+	async_exch_t *exch = vfs_exchange_begin();
+
+	req = async_send_3(exch, VFS_IN_READDIR, file, LOWER32(pos),
+	    UPPER32(pos), &answer);
+	rc = async_data_read_start(exch, buf, size);
+
+	vfs_exchange_end(exch);
+
+	if (rc == EOK)
+		async_wait_for(req, &rc);
+	else
+		async_forget(req);
+
+	if (rc != EOK)
+		return rc;
+
+	*nread = ipc_get_arg1(&answer);
+	return EOK;
+}
+
+/** Start reading bytes from a file without waiting for the result
+ *
+ * Like vfs_read_short(), this reads at most DATA_XFER_LIMIT bytes. The
+ * request keeps its own exchange until it is collected by vfs_aio_wait(),
+ * so other requests can be made in the meantime. The buffer must not be
+ * touched before that.
+ *
+ * @param file          File handle to read from
+ * @param[in] pos       Position to read from
+ * @param buf           Buffer to read to
+ * @param nbyte         Maximum number of bytes to read
+ * @param[out] aio      Request in flight
+ */
+void vfs_read_start(int file, aoff64_t pos, void *buf, size_t nbyte,
+    vfs_aio_t *aio)
+{
+	if (nbyte > DATA_XFER_LIMIT)
+		nbyte = DATA_XFER_LIMIT;
+
+	aio->exch = vfs_exchange_begin();
+	aio->req = async_send_3(aio->exch, VFS_IN_READ, file, LOWER32(pos),
+	    UPPER32(pos), &aio->answer);
+	aio->data = async_data_read(aio->exch, buf, nbyte, NULL);
+}
+
+/** Start writing bytes to a file without waiting for the result
+ *
+ * Like vfs_write_short(), this writes at most DATA_XFER_LIMIT bytes and
+ * may write fewer. The data must not be modified before the request is
+ * collected by vfs_aio_wait().
+ *
+ * @param file          File handle to write to
+ * @param[in] pos       Position to write to
+ * @param buf           Data to write
+ * @param nbyte         Maximum number of bytes to write
+ * @param[out] aio      Request in flight
+ */
+void vfs_write_start(int file, aoff64_t pos, const void *buf, size_t nbyte,
+    vfs_aio_t *aio)
+{
+	if (nbyte > DATA_XFER_LIMIT)
+		nbyte = DATA_XFER_LIMIT;
+
+	aio->exch = vfs_exchange_begin();
+	aio->req = async_send_3(aio->exch, VFS_IN_WRITE, file, LOWER32(pos),
+	    UPPER32(pos), &aio->answer);
+	aio->data = async_send_2(aio->exch, IPC_M_DATA_WRITE,
+	    (sysarg_t) buf, (sysarg_t) nbyte, NULL);
+}
+
+/** Wait for a read or write request started earlier
+ *
+ * @param aio           Request in flight
+ * @param[out] ndone    Number of bytes actually transferred
+ *
+ * @return              EOK on success or an error code
+ */
+errno_t vfs_aio_wait(vfs_aio_t *aio, size_t *ndone)
+{
+	errno_t data_rc;
+	errno_t rc;
+
+	async_wait_for(aio->data, &data_rc);
+	async_wait_for(aio->req, &rc);
+	vfs_exchange_end(aio->exch);
+
+	if (data_rc != EOK)
+		rc = data_rc;
+
+	*ndone = (rc == EOK) ? ipc_get_arg1(&aio->answer) : 0;
+	return rc;
+}
+
+/** Find a run of buffers that can be transferred by a single request
+ *
+ * @param iov     Array of buffers
+ * @param iovcnt  Number of buffers in @a iov
+ * @param[out] size Total size of the buffers in the run
+ *
+ * @return Number of buffers in the run, at least one
+ */
+static size_t vfs_iov_run(const vfs_iovec_t *iov, size_t iovcnt, size_t *size)
+{
+	size_t total = iov[0].len;
+	size_t cnt = 1;
+
+	while (cnt < iovcnt && iov[cnt].len <= DATA_XFER_LIMIT - total) {
+		total += iov[cnt].len;
+		cnt++;
+	}
+
+	*size = total;
+	return cnt;
+}
+
+/** Get a buffer for gathering a run of buffers
+ *
+ * @param local   On-stack buffer, VFS_IOV_LOCAL_SIZE bytes long
+ * @param size    Size of the run
+ *
+ * @return Buffer or NULL if out of memory
+ */
+static uint8_t *vfs_iov_buffer(uint8_t *local, size_t size)
+{
+	if (size <= VFS_IOV_LOCAL_SIZE)
+		return local;
+
+	return malloc(size);
+}
+
+/** Read data into several buffers
+ *
+ * Consecutive buffers are read together by a single request as long as
+ * they fit into one data transfer, which makes reading many small
+ * records as cheap as reading one. Like vfs_read(), this reads all the
+ * available bytes up to the total size of the buffers.
+ *
+ * @param file          File handle to read from
+ * @param[inout] pos    Position to read from, updated by the actual bytes read
+ * @param iov           Array of buffers to fill in turn
+ * @param iovcnt        Number of buffers in @a iov
+ * @param[out] nread    Place to store number of bytes actually read
+ *
+ * @return              On success, EOK and @a *nread is filled with number
+ *			of bytes actually read.
+ * @return              On failure, an error code
+ */
+errno_t vfs_readv(int file, aoff64_t *pos, const vfs_iovec_t *iov,
+    size_t iovcnt, size_t *nread)
+{
+	uint8_t local[VFS_IOV_LOCAL_SIZE];
+	size_t nr = 0;
+	errno_t rc = EOK;
+
+	while (iovcnt > 0) {
+		size_t size;
+		size_t cnt = vfs_iov_run(iov, iovcnt, &size);
+		size_t n;
+
+		if (cnt == 1 && size == 0) {
+			iov++;
+			iovcnt--;
+			continue;
+		}
+
+		if (cnt == 1) {
+			/* A lone buffer is read into directly. */
+			rc = vfs_read(file, pos, iov[0].base, iov[0].len, &n);
+			nr += n;
+			if (rc != EOK || n < size)
+				break;
+
+			iov++;
+			iovcnt--;
+			continue;
+		}
+
+		uint8_t *buf = vfs_iov_buffer(local, size);
+		if (buf == NULL) {
+			rc = ENOMEM;
+			break;
+		}
+
+		rc = vfs_read(file, pos, buf, size, &n);
+
+		/* Scatter whatever has been read. */
+		size_t off = 0;
+		for (size_t i = 0; i < cnt && off < n; i++) {
+			size_t part = min(iov[i].len, n - off);
+			memcpy(iov[i].base, buf + off, part);
+			off += part;
+		}
+
+		if (buf != local)
+			free(buf);
+
+		nr += n;
+		if (rc != EOK || n < size)
+			break;
+
+		iov += cnt;
+		iovcnt -= cnt;
+	}
+
+	*nread = nr;
+	return rc;
+}
+
 /** Rename a file or directory
  *
  * There is no file-handle-based variant to disallow attempts to introduce loops
@@ -1313,7 +1869,10 @@ errno_t vfs_write(int file, aoff64_t *pos, const void *buf, size_t nbyte,
 		bp += cnt;
 		nwr += cnt;
 		*pos += cnt;
-		rc = vfs_write_short(file, *pos, bp, nbyte - nwr, &cnt);
+		if (cnt == DATA_XFER_LIMIT && nbyte - nwr > DATA_XFER_LIMIT)
+			rc = vfs_write_pipelined(file, *pos, bp, nbyte - nwr, &cnt);
+		else
+			rc = vfs_write_short(file, *pos, bp, nbyte - nwr, &cnt);
 	} while (rc == EOK && ((ssize_t)nbyte - nwr - cnt) > 0);
 
 	if (rc != EOK) {
@@ -1327,6 +1886,68 @@ errno_t vfs_write(int file, aoff64_t *pos, const void *buf, size_t nbyte,
 	return EOK;
 }
 
+/** Write bytes to a file using several requests in flight
+ *
+ * Splits the write into DATA_XFER_LIMIT-sized chunks and keeps up to
+ * ASYNC_BATCH_MAX of them in flight on one exchange. The result covers
+ * the chunks up to and including the first short one.
+ *
+ * @param file          File handle to write to
+ * @param[in] pos       Position to write to
+ * @param buf           Data to write
+ * @param nbyte         Number of bytes to write
+ * @param[out] nwritten Actual number of bytes written (0 or more)
+ *
+ * @return              EOK on success or an error code
+ */
+static errno_t vfs_write_pipelined(int file, aoff64_t pos, const void *buf,
+    size_t nbyte, ssize_t *nwritten)
+{
+	const uint8_t *bp = (const uint8_t *) buf;
+	async_batch_t batch;
+	ipc_call_t answer;
+	size_t sent = 0;
+	size_t done = 0;
+	errno_t rc = EOK;
+
+	async_exch_t *exch = vfs_exchange_begin();
+	async_batch_init(&batch, exch);
+
+	while (true) {
+		while (sent < nbyte &&
+		    async_batch_pending(&batch) < ASYNC_BATCH_MAX) {
+			size_t chunk = min(nbyte - sent, DATA_XFER_LIMIT);
+			aoff64_t cpos = pos + sent;
+
+			async_batch_data_write_3(&batch, VFS_IN_WRITE, file,
+			    LOWER32(cpos), UPPER32(cpos), bp + sent, chunk);
+			sent += chunk;
+		}
+
+		if (async_batch_pending(&batch) == 0)
+			break;
+
+		size_t expect = min(nbyte - done, DATA_XFER_LIMIT);
+		rc = async_batch_wait(&batch, &answer);
+		if (rc != EOK)
+			break;
+
+		size_t cnt = ipc_get_arg1(&answer);
+		done += cnt;
+		if (cnt < expect)
+			break;
+	}
+
+	async_batch_drain(&batch);
+	vfs_exchange_end(exch);
+
+	if (rc != EOK && done == 0)
+		return rc;
+
+	*nwritten = (ssize_t) done;
+	return EOK;
+}
+
 /** Write bytes to a file
  *
  * Write up to @a nbyte bytes from file. The actual number of bytes written
@@ -1370,5 +1991,81 @@ errno_t vfs_write_short(int file, aoff64_t pos, const void *buf, size_t nbyte,
 	return EOK;
 }
 
+/** Write data from several buffers
+ *
+ * Consecutive buffers are gathered and written by a single request as
+ * long as they fit into one data transfer. Like vfs_write(), this fails
+ * if it cannot write all the data.
+ *
+ * @param file          File handle to write to
+ * @param[inout] pos    Position to write to, updated by the actual bytes
+ *                      written
+ * @param iov           Array of buffers to write in turn
+ * @param iovcnt        Number of buffers in @a iov
+ * @param[out] nwritten Place to store number of bytes written
+ *
+ * @return		On success, EOK, @a *nwritten is filled with number
+ *			of bytes written
+ * @return              On failure, an error code
+ */
+errno_t vfs_writev(int file, aoff64_t *pos, const vfs_iovec_t *iov,
+    size_t iovcnt, size_t *nwritten)
+{
+	uint8_t local[VFS_IOV_LOCAL_SIZE];
+	size_t nwr = 0;
+	errno_t rc = EOK;
+
+	while (iovcnt > 0) {
+		size_t size;
+		size_t cnt = vfs_iov_run(iov, iovcnt, &size);
+		size_t n;
+
+		if (cnt == 1 && size == 0) {
+			iov++;
+			iovcnt--;
+			continue;
+		}
+
+		if (cnt == 1) {
+			/* A lone buffer is written from directly. */
+			rc = vfs_write(file, pos, iov[0].base, iov[0].len, &n);
+			nwr += n;
+			if (rc != EOK)
+				break;
+
+			iov++;
+			iovcnt--;
+			continue;
+		}
+
+		uint8_t *buf = vfs_iov_buffer(local, size);
+		if (buf == NULL) {
+			rc = ENOMEM;
+			break;
+		}
+
+		size_t off = 0;
+		for (size_t i = 0; i < cnt; i++) {
+			memcpy(buf + off, iov[i].base, iov[i].len);
+			off += iov[i].len;
+		}
+
+		rc = vfs_write(file, pos, buf, size, &n);
+
+		if (buf != local)
+			free(buf);
+
+		nwr += n;
+		if (rc != EOK)
+			break;
+
+		iov += cnt;
+		iovcnt -= cnt;
+	}
+
+	*nwritten = nwr;
+	return rc;
+}
+
 /** @}
  */
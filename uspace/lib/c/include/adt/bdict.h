@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_BDICT_H_
+#define _LIBC_BDICT_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <types/adt/bdict.h>
+
+extern void bdict_initialize(bdict_t *);
+extern void bdict_finalize(bdict_t *);
+extern errno_t bdict_insert(bdict_t *, bdkey_t, void *);
+extern errno_t bdict_load(bdict_t *, const bdkey_t *, void *const *, size_t);
+extern errno_t bdict_remove(bdict_t *, bdkey_t, void **);
+extern bool bdict_empty(bdict_t *);
+extern unsigned long bdict_count(bdict_t *);
+extern bool bdict_first(bdict_t *, bdpos_t *);
+extern bool bdict_last(bdict_t *, bdpos_t *);
+extern bool bdict_next(bdpos_t *);
+extern bool bdict_prev(bdpos_t *);
+extern bdkey_t bdict_key(bdpos_t *);
+extern void *bdict_value(bdpos_t *);
+extern void bdict_set_value(bdpos_t *, void *);
+extern void *bdict_get(bdict_t *, bdkey_t);
+extern bool bdict_find_eq(bdict_t *, bdkey_t, bdpos_t *);
+extern bool bdict_find_geq(bdict_t *, bdkey_t, bdpos_t *);
+extern bool bdict_find_gt(bdict_t *, bdkey_t, bdpos_t *);
+extern bool bdict_find_leq(bdict_t *, bdkey_t, bdpos_t *);
+extern bool bdict_find_lt(bdict_t *, bdkey_t, bdpos_t *);
+extern errno_t bdict_validate(bdict_t *);
+
+#endif
+
+/** @}
+ */
@@ -74,6 +74,11 @@ typedef struct {
 	hash_table_ops_t *op;
 	list_t *bucket;
 	size_t bucket_cnt;
+	/** Buckets still being migrated by a resize, NULL if none. */
+	list_t *old_bucket;
+	size_t old_bucket_cnt;
+	/** Index of the next old bucket to migrate. */
+	size_t migrate_idx;
 	size_t full_item_cnt;
 	size_t item_cnt;
 	size_t max_load;
@@ -91,6 +96,7 @@ extern bool hash_table_empty(hash_table_t *);
 extern size_t hash_table_size(hash_table_t *);
 
 extern void hash_table_clear(hash_table_t *);
+extern bool hash_table_reserve(hash_table_t *, size_t);
 extern void hash_table_insert(hash_table_t *, ht_link_t *);
 extern bool hash_table_insert_unique(hash_table_t *, ht_link_t *);
 extern ht_link_t *hash_table_find(const hash_table_t *, const void *);
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Intrusive lock-free multi-producer single-consumer queue
+ *
+ * Any number of threads may push links concurrently without locking,
+ * while a single consumer pops them in FIFO order. The algorithm is due
+ * to D. Vyukov. A push takes one atomic exchange, a pop normally takes no
+ * atomic read-modify-write operation at all.
+ *
+ * A push is only visible to the consumer once it is complete, so a pop
+ * racing with a push may report an empty queue. The producer is expected
+ * to notify the consumer after pushing, which then retries.
+ */
+
+#ifndef _LIBC_MPSC_QUEUE_H_
+#define _LIBC_MPSC_QUEUE_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Link embedded in the queued structures */
+typedef struct mpsc_link {
+	struct mpsc_link *_Atomic next;
+} mpsc_link_t;
+
+/** Multi-producer single-consumer queue */
+typedef struct {
+	/** Last pushed link, updated by the producers */
+	mpsc_link_t *_Atomic tail;
+	/** Oldest link, only accessed by the consumer */
+	mpsc_link_t *head;
+	/** Placeholder keeping the queue non-empty */
+	mpsc_link_t stub;
+} mpsc_queue_t;
+
+#define mpsc_queue_get_inst(link, type, member) \
+	((type *) (((char *) (link)) - offsetof(type, member)))
+
+extern void mpsc_queue_initialize(mpsc_queue_t *);
+extern void mpsc_queue_push(mpsc_queue_t *, mpsc_link_t *);
+extern mpsc_link_t *mpsc_queue_pop(mpsc_queue_t *);
+extern bool mpsc_queue_empty(mpsc_queue_t *);
+
+#endif
+
+/** @}
+ */
@@ -105,7 +105,38 @@ struct async_sess;
 typedef struct async_sess async_sess_t;
 typedef struct async_exch async_exch_t;
 
+/** Maximum number of requests a batch keeps in flight */
+#define ASYNC_BATCH_MAX  8
+
+/** Request in flight within a batch */
+typedef struct {
+	/** Method call */
+	aid_t req;
+	/** Data transfer accompanying the method call */
+	aid_t data;
+	/** Answer to the method call */
+	ipc_call_t answer;
+} async_batch_req_t;
+
+/** Batch of requests pipelined over a single exchange
+ *
+ * Requests are submitted without waiting for the previous ones and
+ * their answers are collected in submission order.
+ *
+ */
+typedef struct {
+	/** Exchange the requests are sent over */
+	async_exch_t *exch;
+	/** Index of the oldest request in flight */
+	size_t first;
+	/** Number of requests in flight */
+	size_t count;
+	/** Requests in flight (circular) */
+	async_batch_req_t reqs[ASYNC_BATCH_MAX];
+} async_batch_t;
+
 extern __noreturn void async_manager(void);
+extern errno_t async_set_manager_threads(unsigned int);
 
 extern bool async_get_call(ipc_call_t *);
 extern bool async_get_call_timeout(ipc_call_t *, usec_t);
@@ -303,6 +334,8 @@ extern errno_t async_share_in_start_1_0(async_exch_t *, size_t, sysarg_t,
     void **);
 extern errno_t async_share_in_start_1_1(async_exch_t *, size_t, sysarg_t,
     unsigned int *, void **);
+extern errno_t async_share_in_start_fixed(async_exch_t *, size_t, sysarg_t,
+    void *);
 
 extern bool async_share_in_receive(ipc_call_t *, size_t *);
 extern errno_t async_share_in_finalize(ipc_call_t *, void *, unsigned int);
@@ -364,6 +397,15 @@ extern errno_t async_data_write_accept(void **, const bool, const size_t,
     const size_t, const size_t, size_t *);
 extern void async_data_write_void(errno_t);
 
+extern void async_batch_init(async_batch_t *, async_exch_t *);
+extern size_t async_batch_pending(async_batch_t *);
+extern errno_t async_batch_data_read_3(async_batch_t *, sysarg_t, sysarg_t,
+    sysarg_t, sysarg_t, void *, size_t);
+extern errno_t async_batch_data_write_3(async_batch_t *, sysarg_t, sysarg_t,
+    sysarg_t, sysarg_t, const void *, size_t);
+extern errno_t async_batch_wait(async_batch_t *, ipc_call_t *);
+extern void async_batch_drain(async_batch_t *);
+
 extern async_sess_t *async_callback_receive(exch_mgmt_t);
 extern async_sess_t *async_callback_receive_start(exch_mgmt_t, ipc_call_t *);
 
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup libc
+ * @{
+ */
+/** @file Shared-memory ring channel
+ */
+
+#ifndef _LIBC_ASYNC_RING_H_
+#define _LIBC_ASYNC_RING_H_
+
+#include <async.h>
+#include <errno.h>
+#include <stddef.h>
+
+/** Shared-memory ring channel
+ *
+ * A ring streams messages from a client (producer) to a server (consumer)
+ * through a memory area shared by the client. Messages are passed without
+ * involving the kernel. IPC is only used as a doorbell when the consumer
+ * is waiting for data and as a blocking fallback when the ring is full.
+ *
+ * Both the setup and all doorbells use a single protocol-defined method.
+ * The server passes every call with that method to async_ring_handle().
+ * Rings created with a user argument can share a session and method,
+ * the server finds the ring of a call using async_ring_arg().
+ */
+typedef struct async_ring async_ring_t;
+
+/* Producer side */
+extern errno_t async_ring_create(async_sess_t *, sysarg_t, size_t,
+    async_ring_t **);
+extern errno_t async_ring_create_arg(async_sess_t *, sysarg_t, sysarg_t,
+    size_t, async_ring_t **);
+extern errno_t async_ring_write(async_ring_t *, const void *, size_t);
+
+/* Consumer side */
+extern sysarg_t async_ring_arg(ipc_call_t *);
+extern errno_t async_ring_handle(ipc_call_t *, async_ring_t **);
+extern errno_t async_ring_read(async_ring_t *, void *, size_t, size_t *);
+extern errno_t async_ring_read_wait(async_ring_t *, void *, size_t, size_t *);
+
+extern void async_ring_destroy(async_ring_t *);
+
+#endif
+
+/** @}
+ */
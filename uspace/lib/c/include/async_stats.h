@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Async framework statistics
+ */
+
+#ifndef _LIBC_ASYNC_STATS_H_
+#define _LIBC_ASYNC_STATS_H_
+
+#include <async.h>
+#include <abi/ipc/interfaces.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Number of service time histogram buckets
+ *
+ * Bucket 0 counts calls served in less than a microsecond, bucket i
+ * counts calls served in [2^(i-1), 2^i) microseconds. The last bucket
+ * also counts all longer calls.
+ */
+#define ASYNC_STATS_BUCKETS  24
+
+/** Statistics of one method of one interface
+ *
+ * Queueing delay is measured from the arrival of a call in the async
+ * manager to its dispatch by async_get_call(). Service time runs from
+ * the dispatch until the connection fibril asks for its next call or
+ * terminates. Run time is the part of the service time during which
+ * the connection fibril was actually running.
+ */
+typedef struct {
+	iface_t iface;
+	sysarg_t imethod;
+
+	uint64_t calls;
+	uint64_t queue_usec;
+	uint64_t queue_max_usec;
+	uint64_t service_usec;
+	uint64_t service_max_usec;
+	uint64_t run_usec;
+	uint64_t service_hist[ASYNC_STATS_BUCKETS];
+} async_method_stats_t;
+
+/** Statistics of the connections of one client task to one interface */
+typedef struct {
+	task_id_t task_id;
+	iface_t iface;
+
+	uint64_t connections;
+	uint64_t calls;
+	uint64_t service_usec;
+	uint64_t run_usec;
+} async_client_stats_t;
+
+/*
+ * Any server using the async framework accepts connections to
+ * INTERFACE_ASYNC_STATS which query and control its statistics.
+ * Statistics are collected only while enabled.
+ */
+extern errno_t async_stats_enable(async_sess_t *, bool);
+extern errno_t async_stats_reset(async_sess_t *);
+extern errno_t async_stats_read_methods(async_sess_t *, async_method_stats_t *,
+    size_t, size_t *);
+extern errno_t async_stats_read_clients(async_sess_t *, async_client_stats_t *,
+    size_t, size_t *);
+
+#endif
+
+/** @}
+ */
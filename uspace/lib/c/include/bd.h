@@ -35,11 +35,47 @@
 #ifndef _LIBC_BD_H_
 #define _LIBC_BD_H_
 
+#include <adt/list.h>
 #include <async.h>
+#include <fibril_synch.h>
 #include <offset.h>
+#include <stdbool.h>
+
+/** Completion callback of an asynchronous block device request */
+typedef void (*bd_req_cb_t)(void *, errno_t);
+
+/** Asynchronous block device request
+ *
+ * The structure is provided by the caller and identifies the request
+ * until its completion callback is called.
+ */
+typedef struct {
+	/** Link to bd_t.reqs */
+	link_t lreqs;
+	/** Method call */
+	aid_t req;
+	/** Data transfer accompanying the method call */
+	aid_t data;
+	/** Completion callback */
+	bd_req_cb_t cb;
+	/** Argument of the completion callback */
+	void *arg;
+} bd_req_t;
 
 typedef struct {
 	async_sess_t *sess;
+	/** Number of requests the server can work on at the same time */
+	unsigned queue_depth;
+	/** Lock protecting the asynchronous request state */
+	fibril_mutex_t lock;
+	/** Signalled when a request completes or the reaper exits */
+	fibril_condvar_t cv;
+	/** Asynchronous requests in flight, in submission order */
+	list_t reqs;
+	/** Number of entries in @c reqs */
+	unsigned nreqs;
+	/** Fibril collecting the answers is running */
+	bool reaper;
 } bd_t;
 
 extern errno_t bd_open(async_sess_t *, bd_t **);
@@ -48,8 +84,16 @@ extern errno_t bd_read_blocks(bd_t *, aoff64_t, size_t, void *, size_t);
 extern errno_t bd_read_toc(bd_t *, uint8_t, void *, size_t);
 extern errno_t bd_write_blocks(bd_t *, aoff64_t, size_t, const void *, size_t);
 extern errno_t bd_sync_cache(bd_t *, aoff64_t, size_t);
+extern errno_t bd_write_zeroes(bd_t *, aoff64_t, size_t);
 extern errno_t bd_get_block_size(bd_t *, size_t *);
 extern errno_t bd_get_num_blocks(bd_t *, aoff64_t *);
+extern errno_t bd_get_queue_depth(bd_t *, unsigned *);
+extern errno_t bd_map(bd_t *, bool, void **, size_t *);
+extern errno_t bd_read_blocks_async(bd_t *, bd_req_t *, aoff64_t, size_t,
+    void *, size_t, bd_req_cb_t, void *);
+extern errno_t bd_write_blocks_async(bd_t *, bd_req_t *, aoff64_t, size_t,
+    const void *, size_t, bd_req_cb_t, void *);
+extern void bd_wait_idle(bd_t *);
 
 #endif
 
@@ -54,6 +54,14 @@ typedef struct {
 	bd_srvs_t *srvs;
 	async_sess_t *client_sess;
 	void *carg;
+	/** Number of transfers handed to the driver at the same time */
+	unsigned queue_depth;
+	/** Lock protecting @c xfers */
+	fibril_mutex_t lock;
+	/** Signalled when a transfer completes */
+	fibril_condvar_t cv;
+	/** Number of transfers in progress */
+	unsigned xfers;
 } bd_srv_t;
 
 struct bd_ops {
@@ -65,6 +73,28 @@ struct bd_ops {
 	errno_t (*write_blocks)(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 	errno_t (*get_block_size)(bd_srv_t *, size_t *);
 	errno_t (*get_num_blocks)(bd_srv_t *, aoff64_t *);
+	errno_t (*get_queue_depth)(bd_srv_t *, unsigned *);
+	/** Translate a block range for passthrough.
+	 *
+	 * If set, read and write requests are not handed to @c read_blocks
+	 * and @c write_blocks. The block range is translated to a session
+	 * of the backing device and an address on it and the request,
+	 * including its data transfer, is forwarded there.
+	 */
+	errno_t (*translate)(bd_srv_t *, aoff64_t, size_t, async_sess_t **,
+	    aoff64_t *);
+	/** Get the address space area holding the device image.
+	 *
+	 * Returns the area and its size. The area is shared with clients
+	 * asking for a mapping of the device.
+	 */
+	errno_t (*map)(bd_srv_t *, void **, size_t *);
+	/** Set a block range to zeroes.
+	 *
+	 * Optional. Clients fall back to writing zeroed buffers if the
+	 * device does not support this.
+	 */
+	errno_t (*write_zeroes)(bd_srv_t *, aoff64_t, size_t);
 };
 
 extern void bd_srvs_init(bd_srvs_t *);
@@ -37,7 +37,18 @@
 
 #define NAME_MAX  256
 
+/** Values of d_type */
+enum {
+	DT_UNKNOWN = 0,
+	DT_REG,
+	DT_DIR
+};
+
 struct dirent {
+	/** Index of the node, zero if not known */
+	unsigned long d_ino;
+	/** Type of the node, DT_UNKNOWN if not known */
+	unsigned char d_type;
 	char d_name[NAME_MAX + 1];
 };
 
@@ -36,6 +36,7 @@
 #define _LIBC_FIBRIL_H_
 
 #include <types/common.h>
+#include <stdbool.h>
 #include <time.h>
 #include <_bits/__noreturn.h>
 
@@ -47,6 +48,19 @@ typedef struct {
 
 typedef fibril_t *fid_t;
 
+/** Statistics of fibril timeouts */
+typedef struct {
+	/** Timeouts started */
+	uint64_t armed;
+	/** Timeouts that expired */
+	uint64_t expired;
+	/** Checks for expired timeouts that found some */
+	uint64_t wakeups;
+} fibril_timeout_stats_t;
+
+/** Key of a fibril-local value, see fibril_key_create() */
+typedef unsigned int fibril_key_t;
+
 #ifndef __cplusplus
 /** Fibril-local variable specifier */
 #define fibril_local __thread
@@ -62,7 +76,12 @@ extern void fibril_yield(void);
 extern void fibril_usleep(usec_t);
 extern void fibril_sleep(sec_t);
 
+extern void fibril_set_timer_slack(usec_t);
+extern usec_t fibril_get_timer_slack(void);
+extern void fibril_get_timeout_stats(fibril_timeout_stats_t *);
+
 extern void fibril_enable_multithreaded(void);
+extern bool fibril_is_multithreaded(void);
 extern int fibril_test_spawn_runners(int);
 
 extern void fibril_detach(fid_t fid);
@@ -70,6 +89,11 @@ extern void fibril_detach(fid_t fid);
 extern void fibril_start(fid_t);
 extern __noreturn void fibril_exit(long);
 
+extern errno_t fibril_key_create(fibril_key_t *, void (*)(void *));
+extern void fibril_key_delete(fibril_key_t);
+extern void *fibril_key_get(fibril_key_t);
+extern void fibril_key_set(fibril_key_t, void *);
+
 #endif
 
 /** @}
@@ -90,6 +90,25 @@ typedef struct {
 #define FIBRIL_CONDVAR_INITIALIZE(name) \
 	fibril_condvar_t name = FIBRIL_CONDVAR_INITIALIZER(name)
 
+typedef struct fibril_drwlock_counts fibril_drwlock_counts_t;
+
+/** Read-write lock for read-mostly data, see fibril_drwlock_initialize() */
+typedef struct {
+	/** Writer flag and per-runner reader counts */
+	fibril_drwlock_counts_t *counts;
+	/** Serializes writers and readers waiting for them */
+	fibril_mutex_t lock;
+	fibril_condvar_t cv;
+} fibril_drwlock_t;
+
+/** Publish a pointer to data read by RCU readers. */
+#define fibril_rcu_assign(ptr, value) \
+	__atomic_store_n(&(ptr), (value), __ATOMIC_RELEASE)
+
+/** Read a pointer published by fibril_rcu_assign(). */
+#define fibril_rcu_access(ptr) \
+	__atomic_load_n(&(ptr), __ATOMIC_CONSUME)
+
 typedef void (*fibril_timer_fun_t)(void *);
 
 typedef enum {
@@ -154,12 +173,25 @@ extern bool fibril_mutex_is_locked(fibril_mutex_t *);
 extern void fibril_rwlock_initialize(fibril_rwlock_t *);
 extern void fibril_rwlock_read_lock(fibril_rwlock_t *);
 extern void fibril_rwlock_write_lock(fibril_rwlock_t *);
+extern bool fibril_rwlock_try_read_lock(fibril_rwlock_t *);
+extern bool fibril_rwlock_try_write_lock(fibril_rwlock_t *);
 extern void fibril_rwlock_read_unlock(fibril_rwlock_t *);
 extern void fibril_rwlock_write_unlock(fibril_rwlock_t *);
 extern bool fibril_rwlock_is_read_locked(fibril_rwlock_t *);
 extern bool fibril_rwlock_is_write_locked(fibril_rwlock_t *);
 extern bool fibril_rwlock_is_locked(fibril_rwlock_t *);
 
+extern errno_t fibril_drwlock_initialize(fibril_drwlock_t *);
+extern void fibril_drwlock_destroy(fibril_drwlock_t *);
+extern void fibril_drwlock_read_lock(fibril_drwlock_t *);
+extern void fibril_drwlock_read_unlock(fibril_drwlock_t *);
+extern void fibril_drwlock_write_lock(fibril_drwlock_t *);
+extern void fibril_drwlock_write_unlock(fibril_drwlock_t *);
+
+extern void fibril_rcu_read_lock(void);
+extern void fibril_rcu_read_unlock(void);
+extern void fibril_rcu_synchronize(void);
+
 extern void fibril_condvar_initialize(fibril_condvar_t *);
 extern errno_t fibril_condvar_wait_timeout(fibril_condvar_t *, fibril_mutex_t *,
     usec_t);
@@ -189,6 +221,15 @@ extern errno_t mpsc_send(mpsc_t *, const void *);
 extern errno_t mpsc_receive(mpsc_t *, void *, const struct timespec *);
 extern void mpsc_close(mpsc_t *);
 
+typedef struct mpmc mpmc_t;
+extern mpmc_t *mpmc_create(size_t, size_t);
+extern void mpmc_destroy(mpmc_t *);
+extern errno_t mpmc_send(mpmc_t *, const void *, const struct timespec *);
+extern errno_t mpmc_trysend(mpmc_t *, const void *);
+extern errno_t mpmc_receive(mpmc_t *, void *, const struct timespec *);
+extern errno_t mpmc_tryreceive(mpmc_t *, void *);
+extern void mpmc_close(mpmc_t *);
+
 #endif
 
 /** @}
@@ -107,6 +107,7 @@ extern void inet_naddr_any(inet_naddr_t *);
 
 extern int inet_addr_compare(const inet_addr_t *, const inet_addr_t *);
 extern int inet_addr_is_any(const inet_addr_t *);
+extern int inet_addr_is_loopback(const inet_addr_t *);
 
 extern int inet_naddr_compare(const inet_naddr_t *, const inet_addr_t *);
 extern int inet_naddr_compare_mask(const inet_naddr_t *, const inet_addr_t *);
@@ -37,9 +37,12 @@
 
 #include <inet/inet.h>
 #include <inet/addr.h>
+#include <stdbool.h>
 
 enum {
-	DNSR_NAME_MAX_SIZE = 255
+	DNSR_NAME_MAX_SIZE = 255,
+	/** Maximum number of configured name servers */
+	DNSR_SERVERS_MAX = 3
 };
 
 typedef struct {
@@ -49,11 +52,31 @@ typedef struct {
 	inet_addr_t addr;
 } dnsr_hostinfo_t;
 
+/** Resolver cache entry */
+typedef struct {
+	/** Queried name */
+	char name[DNSR_NAME_MAX_SIZE + 1];
+	/** Host canonical name */
+	char cname[DNSR_NAME_MAX_SIZE + 1];
+	/** Queried IP version (ip_v4 for A, ip_v6 for AAAA) */
+	ip_ver_t ver;
+	/** The name does not exist or has no address of this version */
+	bool negative;
+	/** Host address, valid unless @c negative */
+	inet_addr_t addr;
+	/** Remaining time to live in seconds */
+	uint32_t ttl;
+} dnsr_cache_entry_t;
+
 extern errno_t dnsr_init(void);
 extern errno_t dnsr_name2host(const char *, dnsr_hostinfo_t **, ip_ver_t);
 extern void dnsr_hostinfo_destroy(dnsr_hostinfo_t *);
 extern errno_t dnsr_get_srvaddr(inet_addr_t *);
 extern errno_t dnsr_set_srvaddr(inet_addr_t *);
+extern errno_t dnsr_get_srvaddr_idx(size_t, inet_addr_t *);
+extern errno_t dnsr_set_srvaddr_idx(size_t, inet_addr_t *);
+extern errno_t dnsr_get_cache(dnsr_cache_entry_t **, size_t *);
+extern errno_t dnsr_flush_cache(void);
 
 #endif
 
@@ -79,6 +79,10 @@ typedef struct {
 typedef struct iplink_ev_ops {
 	errno_t (*recv)(iplink_t *, iplink_recv_sdu_t *, ip_ver_t);
 	errno_t (*change_addr)(iplink_t *, addr48_t);
+	/** Optional, called before datagrams received at once are passed */
+	void (*recv_begin)(iplink_t *);
+	/** Optional, called after datagrams received at once were passed */
+	void (*recv_end)(iplink_t *);
 } iplink_ev_ops_t;
 
 extern errno_t iplink_open(async_sess_t *, iplink_ev_ops_t *, void *, iplink_t **);
@@ -49,6 +49,12 @@ typedef struct {
 	struct iplink_ops *ops;
 	void *arg;
 	async_sess_t *client_sess;
+	/** Received datagrams batched for the client or @c NULL */
+	uint8_t *rbatch;
+	/** Size of @c rbatch contents in bytes */
+	size_t rbatch_size;
+	/** Number of datagrams in @c rbatch */
+	size_t rbatch_count;
 } iplink_srv_t;
 
 typedef struct iplink_ops {
@@ -67,6 +73,8 @@ extern void iplink_srv_init(iplink_srv_t *);
 
 extern errno_t iplink_conn(ipc_call_t *, void *);
 extern errno_t iplink_ev_recv(iplink_srv_t *, iplink_recv_sdu_t *, ip_ver_t);
+extern void iplink_ev_recv_begin(iplink_srv_t *);
+extern errno_t iplink_ev_recv_end(iplink_srv_t *);
 extern errno_t iplink_ev_change_addr(iplink_srv_t *, addr48_t *);
 
 #endif
@@ -35,10 +35,12 @@
 #ifndef _LIBC_INET_TCP_H_
 #define _LIBC_INET_TCP_H_
 
+#include <async_ring.h>
 #include <fibril_synch.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
 #include <inet/inet.h>
+#include <types/inet/tcp.h>
 
 /** TCP connection */
 typedef struct {
@@ -54,6 +56,8 @@ typedef struct {
 	bool connected;
 	bool conn_failed;
 	bool conn_reset;
+	/** Send ring or @c NULL to send data using IPC */
+	async_ring_t *snd_ring;
 } tcp_conn_t;
 
 /** TCP connection listener */
@@ -113,9 +117,16 @@ extern errno_t tcp_conn_send(tcp_conn_t *, const void *, size_t);
 extern errno_t tcp_conn_send_fin(tcp_conn_t *);
 extern errno_t tcp_conn_push(tcp_conn_t *);
 extern errno_t tcp_conn_reset(tcp_conn_t *);
+extern errno_t tcp_conn_set_buf_max(tcp_conn_t *, size_t, size_t);
+extern errno_t tcp_conn_set_nodelay(tcp_conn_t *, bool);
+extern errno_t tcp_conn_send_ring(tcp_conn_t *, size_t);
 
 extern errno_t tcp_conn_recv(tcp_conn_t *, void *, size_t, size_t *);
 extern errno_t tcp_conn_recv_wait(tcp_conn_t *, void *, size_t, size_t *);
+extern errno_t tcp_conn_recv_wait_timeout(tcp_conn_t *, void *, size_t, usec_t,
+    size_t *);
+
+extern errno_t tcp_conn_info_list(tcp_t *, tcp_conn_info_t **, size_t *);
 
 #endif
 
@@ -59,6 +59,10 @@ typedef struct {
 	char_attrs_t attrs;     /**< Current attributes */
 
 	sysarg_t top_row;       /**< The first row in the cyclic buffer */
+
+	sysarg_t dirty_top;     /**< The first row with dirty fields */
+	sysarg_t dirty_bottom;  /**< The row after the last dirty row */
+
 	charfield_t data[];     /**< Screen contents (cyclic buffer) */
 } chargrid_t;
 
@@ -77,6 +81,8 @@ extern void chargrid_destroy(chargrid_t *);
 extern bool chargrid_cursor_at(chargrid_t *, sysarg_t, sysarg_t);
 
 extern sysarg_t chargrid_get_top_row(chargrid_t *);
+extern void chargrid_get_dirty_rows(chargrid_t *, sysarg_t *, sysarg_t *);
+extern void chargrid_reset_dirty_rows(chargrid_t *);
 
 extern sysarg_t chargrid_putwchar(chargrid_t *, wchar_t, bool);
 extern sysarg_t chargrid_newline(chargrid_t *);
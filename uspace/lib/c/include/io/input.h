@@ -37,6 +37,7 @@
 
 #include <async.h>
 #include <io/kbd_event.h>
+#include <time.h>
 
 struct input_ev_ops;
 
@@ -50,7 +51,7 @@ typedef struct input_ev_ops {
 	errno_t (*active)(input_t *);
 	errno_t (*deactive)(input_t *);
 	errno_t (*key)(input_t *, kbd_event_type_t, keycode_t, keymod_t, wchar_t);
-	errno_t (*move)(input_t *, int, int);
+	errno_t (*move)(input_t *, int, int, usec_t);
 	errno_t (*abs_move)(input_t *, unsigned, unsigned, unsigned, unsigned);
 	errno_t (*button)(input_t *, int, int);
 } input_ev_ops_t;
@@ -44,7 +44,9 @@
 typedef enum {
 	WINDOW_MAIN = 1,
 	WINDOW_DECORATED = 2,
-	WINDOW_RESIZEABLE = 4
+	WINDOW_RESIZEABLE = 4,
+	/** Client guarantees every pixel of the surface is opaque */
+	WINDOW_OPAQUE = 8
 } window_flags_t;
 
 typedef enum {
@@ -115,7 +117,12 @@ typedef struct {
 extern errno_t win_register(async_sess_t *, window_flags_t, service_id_t *,
     service_id_t *);
 
+typedef struct win_events win_events_t;
+
 extern errno_t win_get_event(async_sess_t *, window_event_t *);
+extern errno_t win_events_open(async_sess_t *, win_events_t **);
+extern errno_t win_events_read(win_events_t *, window_event_t *, size_t,
+    size_t *);
 
 extern errno_t win_damage(async_sess_t *, sysarg_t, sysarg_t, sysarg_t, sysarg_t);
 extern errno_t win_grab(async_sess_t *, sysarg_t, sysarg_t);
@@ -43,7 +43,10 @@ typedef enum {
 	BD_READ_BLOCKS,
 	BD_SYNC_CACHE,
 	BD_WRITE_BLOCKS,
-	BD_READ_TOC
+	BD_READ_TOC,
+	BD_GET_QUEUE_DEPTH,
+	BD_MAP,
+	BD_WRITE_ZEROES
 } bd_request_t;
 
 #endif
@@ -35,7 +35,9 @@
 #ifndef _LIBC_IPC_INET_H_
 #define _LIBC_IPC_INET_H_
 
+#include <inet/addr.h>
 #include <ipc/common.h>
+#include <stddef.h>
 
 /** Requests on Inet default port */
 typedef enum {
@@ -47,9 +49,27 @@ typedef enum {
 
 /** Events on Inet default port */
 typedef enum {
-	INET_EV_RECV = IPC_FIRST_USER_METHOD
+	INET_EV_RECV = IPC_FIRST_USER_METHOD,
+	INET_EV_RECV_LIST
 } inet_event_t;
 
+/** Header of a datagram in an INET_EV_RECV_LIST message
+ *
+ * The datagram data follow right after the header.
+ */
+typedef struct {
+	/** Source address */
+	inet_addr_t src;
+	/** Destination address */
+	inet_addr_t dest;
+	/** Type of service */
+	sysarg_t tos;
+	/** Link the datagram was received on */
+	sysarg_t iplink;
+	/** Size of the datagram data in bytes */
+	size_t size;
+} inet_recv_hdr_t;
+
 /** Requests on Inet configuration port */
 typedef enum {
 	INETCFG_ADDR_CREATE_STATIC = IPC_FIRST_USER_METHOD,
@@ -65,7 +85,8 @@ typedef enum {
 	INETCFG_SROUTE_CREATE,
 	INETCFG_SROUTE_DELETE,
 	INETCFG_SROUTE_GET,
-	INETCFG_SROUTE_GET_ID
+	INETCFG_SROUTE_GET_ID,
+	INETCFG_REASS_STATS
 } inetcfg_request_t;
 
 /** Events on Inet ping port */
@@ -47,9 +47,25 @@ typedef enum {
 	INPUT_EVENT_KEY,
 	INPUT_EVENT_MOVE,
 	INPUT_EVENT_ABS_MOVE,
-	INPUT_EVENT_BUTTON
+	INPUT_EVENT_BUTTON,
+	INPUT_EVENT_LIST
 } input_notif_t;
 
+/** Maximum number of events delivered at once by INPUT_EVENT_LIST */
+#define INPUT_EVENT_LIST_MAX  64
+
+/** Input event record as delivered by INPUT_EVENT_LIST
+ *
+ * The arguments are the same as those of the message that would deliver
+ * the event alone.
+ */
+typedef struct {
+	/** Event type (input_notif_t) */
+	sysarg_t type;
+	/** Event arguments */
+	sysarg_t args[4];
+} input_ev_rec_t;
+
 #endif
 
 /**
@@ -42,9 +42,23 @@ typedef enum {
 	IPC_TEST_GET_RO_AREA_SIZE,
 	IPC_TEST_GET_RW_AREA_SIZE,
 	IPC_TEST_SHARE_IN_RO,
-	IPC_TEST_SHARE_IN_RW
+	IPC_TEST_SHARE_IN_RW,
+	IPC_TEST_RING,
+	IPC_TEST_DATA_WRITE,
+	IPC_TEST_DATA_READ,
+	IPC_TEST_SHARE_OUT,
+	IPC_TEST_FORWARD,
+	IPC_TEST_CALLBACK_CREATE,
+	IPC_TEST_NOTIFY
 } ipc_test_request_t;
 
+typedef enum {
+	IPC_TEST_EV_NOTIFY = IPC_FIRST_USER_METHOD
+} ipc_test_event_t;
+
+/** Maximum number of notifications requested by one IPC_TEST_NOTIFY */
+#define IPC_TEST_NOTIFY_MAX  256
+
 #endif
 
 /** @}
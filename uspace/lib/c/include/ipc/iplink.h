@@ -36,6 +36,7 @@
 #define _LIBC_IPC_IPLINK_H_
 
 #include <ipc/common.h>
+#include <stddef.h>
 
 typedef enum {
 	IPLINK_GET_MTU = IPC_FIRST_USER_METHOD,
@@ -50,8 +51,20 @@ typedef enum {
 typedef enum {
 	IPLINK_EV_RECV = IPC_FIRST_USER_METHOD,
 	IPLINK_EV_CHANGE_ADDR,
+	IPLINK_EV_RECV_LIST
 } iplink_event_t;
 
+/** Header of a datagram in an IPLINK_EV_RECV_LIST message
+ *
+ * The datagram follows right after the header.
+ */
+typedef struct {
+	/** IP version (ip_ver_t) */
+	sysarg_t ver;
+	/** Size of the datagram in bytes */
+	size_t size;
+} iplink_recv_hdr_t;
+
 #endif
 
 /**
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcipc
+ * @{
+ */
+
+#ifndef _LIBC_IPC_LDCACHE_H_
+#define _LIBC_IPC_LDCACHE_H_
+
+#include <ipc/common.h>
+#include <stdint.h>
+
+typedef enum {
+	LDCACHE_MAP_SEGMENT = IPC_FIRST_USER_METHOD
+} ldcache_request_t;
+
+/** Read-only segment image requested from the segment cache.
+ *
+ * The image starts at the page containing the first byte of the segment,
+ * i.e. the segment data is found @c pgoff bytes from the start of the image
+ * and the remainder of the image up to @c pgoff + @c memsz is zero-filled.
+ */
+typedef struct {
+	/** Offset of the segment data in the file */
+	uint64_t offset;
+	/** Size of the segment data in the file */
+	uint64_t filesz;
+	/** Size of the segment in memory */
+	uint64_t memsz;
+	/** Offset of the segment start within its first page */
+	uint64_t pgoff;
+	/** Address space area flags of the mapping (AS_AREA_xxx) */
+	uint32_t flags;
+} ldcache_seg_t;
+
+#endif
+
+/** @}
+ */
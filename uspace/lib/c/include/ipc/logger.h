@@ -61,14 +61,14 @@ typedef enum {
 	/** Create new log.
 	 *
 	 * Arguments: parent log id (0 for top-level log).
-	 * Returns: error code, log id
+	 * Returns: error code, log id, effective log level
 	 * Followed by: string with log name.
 	 */
 	LOGGER_WRITER_CREATE_LOG = IPC_FIRST_USER_METHOD,
 	/** Write a message to a given log.
 	 *
 	 * Arguments: log id, message severity level (log_level_t)
-	 * Returns: error code
+	 * Returns: error code, effective log level
 	 * Followed by: string with the message.
 	 */
 	LOGGER_WRITER_MESSAGE
@@ -46,6 +46,7 @@ typedef enum {
 	SERVICE_LOC        = FOURCC('l', 'o', 'c', ' '),
 	SERVICE_LOGGER     = FOURCC('l', 'o', 'g', 'g'),
 	SERVICE_DEVMAN     = FOURCC('d', 'e', 'v', 'n'),
+	SERVICE_LDCACHE    = FOURCC('l', 'd', 'c', 'a'),
 } service_t;
 
 #define SERVICE_NAME_CHARDEV_TEST_SMALLX "chardev-test/smallx"
@@ -58,6 +59,7 @@ typedef enum {
 #define SERVICE_NAME_INET     "net/inet"
 #define SERVICE_NAME_IPC_TEST "ipc-test"
 #define SERVICE_NAME_NETCONF  "net/netconf"
+#define SERVICE_NAME_PIPE     "pipe"
 #define SERVICE_NAME_UDP      "net/udp"
 #define SERVICE_NAME_TCP      "net/tcp"
 #define SERVICE_NAME_VBD      "vbd"
@@ -48,9 +48,19 @@ typedef enum {
 	TCP_CONN_PUSH,
 	TCP_CONN_RESET,
 	TCP_CONN_RECV,
-	TCP_CONN_RECV_WAIT
+	TCP_CONN_RECV_WAIT,
+	TCP_CONN_SET_BUF_MAX,
+	TCP_CONN_SET_NODELAY,
+	TCP_CONN_INFO_LIST,
+	TCP_CONN_SEND_RING
 } tcp_request_t;
 
+/** Largest message passed through a connection send ring.
+ *
+ * Fits both the smallest ring and the initial connection send buffer.
+ */
+#define TCP_SEND_RING_MSG_MAX  2048
+
 typedef enum {
 	TCP_EV_CONNECTED = IPC_FIRST_USER_METHOD,
 	TCP_EV_CONN_FAILED,
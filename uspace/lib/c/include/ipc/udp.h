@@ -35,7 +35,9 @@
 #ifndef _LIBC_IPC_UDP_H_
 #define _LIBC_IPC_UDP_H_
 
+#include <inet/endpoint.h>
 #include <ipc/common.h>
+#include <stddef.h>
 
 typedef enum {
 	UDP_CALLBACK_CREATE = IPC_FIRST_USER_METHOD,
@@ -43,15 +45,42 @@ typedef enum {
 	UDP_ASSOC_DESTROY,
 	UDP_ASSOC_SET_NOLOCAL,
 	UDP_ASSOC_SEND_MSG,
+	UDP_ASSOC_SEND_BATCH,
 	UDP_RMSG_INFO,
 	UDP_RMSG_READ,
-	UDP_RMSG_DISCARD
+	UDP_RMSG_DISCARD,
+	UDP_RMSG_READ_BATCH
 } udp_request_t;
 
 typedef enum {
 	UDP_EV_DATA = IPC_FIRST_USER_METHOD
 } udp_event_t;
 
+/** Header of a message in a UDP_ASSOC_SEND_BATCH request
+ *
+ * The message data follow right after the header. An unspecified
+ * destination endpoint selects the remote endpoint of the association.
+ */
+typedef struct {
+	/** Destination endpoint */
+	inet_ep_t dest;
+	/** Size of the message data in bytes */
+	size_t size;
+} udp_send_hdr_t;
+
+/** Header of a message in a UDP_RMSG_READ_BATCH reply
+ *
+ * The message data follow right after the header.
+ */
+typedef struct {
+	/** Association ID */
+	sysarg_t assoc_id;
+	/** Remote endpoint */
+	inet_ep_t remote_ep;
+	/** Size of the message data in bytes */
+	size_t size;
+} udp_recv_hdr_t;
+
 #endif
 
 /** @}
@@ -61,6 +61,13 @@ typedef struct {
 	unsigned int instance;
 	bool concurrent_read_write;
 	bool write_retains_size;
+	/** Reads can be done into buffers shared with VFS. */
+	bool read_buffer;
+	/**
+	 * Number of threads serving requests (0 means one). More than one
+	 * thread requires the operations to be safe to run in parallel.
+	 */
+	unsigned int threads;
 } vfs_info_t;
 
 /** Data returned by filesystem probe regarding a specific volume. */
@@ -69,6 +76,33 @@ typedef struct {
 	char vuid[FS_VUID_MAXLEN + 1];
 } vfs_fs_probe_info_t;
 
+/** Type of a directory entry returned by VFS_IN_READDIR. */
+typedef enum {
+	VFS_DIRENT_UNKNOWN = 0,
+	VFS_DIRENT_FILE,
+	VFS_DIRENT_DIRECTORY
+} vfs_dirent_type_t;
+
+/** Alignment of the entries packed in a VFS_IN_READDIR buffer. */
+#define VFS_DIRENT_ALIGN  8
+
+/**
+ * Header of a directory entry packed in a VFS_IN_READDIR buffer. It is
+ * followed by the null-terminated name of the entry. The next entry
+ * starts @c size bytes after the beginning of the header.
+ */
+typedef struct {
+	/** Directory position of the entry following this one. */
+	uint64_t next_pos;
+	/** Index of the node the entry refers to. */
+	fs_index_t index;
+	/** Size of the entry including the name and padding. */
+	uint16_t size;
+	/** Type of the node, one of vfs_dirent_type_t. */
+	uint8_t type;
+	uint8_t reserved;
+} vfs_dirent_t;
+
 typedef enum {
 	VFS_IN_CLONE = IPC_FIRST_USER_METHOD,
 	VFS_IN_FSPROBE,
@@ -77,9 +111,12 @@ typedef enum {
 	VFS_IN_OPEN,
 	VFS_IN_PUT,
 	VFS_IN_READ,
+	VFS_IN_READ_BUFFER,
+	VFS_IN_READDIR,
 	VFS_IN_REGISTER,
 	VFS_IN_RENAME,
 	VFS_IN_RESIZE,
+	VFS_IN_SHARE_BUFFER,
 	VFS_IN_STAT,
 	VFS_IN_STATFS,
 	VFS_IN_SYNC,
@@ -100,6 +137,10 @@ typedef enum {
 	VFS_OUT_MOUNTED,
 	VFS_OUT_OPEN_NODE,
 	VFS_OUT_READ,
+	VFS_OUT_READ_BUFFER,
+	VFS_OUT_READDIR,
+	VFS_OUT_RELEASE_BUFFER,
+	VFS_OUT_SHARE_BUFFER,
 	VFS_OUT_STAT,
 	VFS_OUT_STATFS,
 	VFS_OUT_SYNC,
@@ -181,6 +222,13 @@ enum {
 	VFS_MOUNT_BLOCKING = 1,
 	VFS_MOUNT_CONNECT_ONLY = 2,
 	VFS_MOUNT_NO_REF = 4,
+	VFS_MOUNT_NO_DCACHE = 8,
+};
+
+/** Flags of areas mapping a file, passed to the VFS pager. */
+enum {
+	/** Modifications are shared with the file and its other mappings. */
+	VFS_MAP_SHARED = 1,
 };
 
 enum {
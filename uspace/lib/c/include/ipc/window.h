@@ -44,9 +44,13 @@ typedef enum {
 	WINDOW_GRAB,
 	WINDOW_RESIZE,
 	WINDOW_CLOSE,
-	WINDOW_CLOSE_REQUEST
+	WINDOW_CLOSE_REQUEST,
+	WINDOW_EVENT_RING
 } window_request_t;
 
+/** Number of events the window event ring is sized for */
+#define WINDOW_EVENT_RING_EVENTS  64
+
 #endif
 
 /** @}
@@ -36,10 +36,20 @@
 #define _LIBC_IPC_TEST_H_
 
 #include <async.h>
+#include <async_ring.h>
 #include <errno.h>
+#include <fibril_synch.h>
+#include <stdint.h>
 
 typedef struct {
 	async_sess_t *sess;
+
+	/** Protects @c notifications */
+	fibril_mutex_t lock;
+	/** Signalled when a notification arrives */
+	fibril_condvar_t cv;
+	/** Number of notifications received through the callback port */
+	uint64_t notifications;
 } ipc_test_t;
 
 extern errno_t ipc_test_create(ipc_test_t **);
@@ -49,6 +59,13 @@ extern errno_t ipc_test_get_ro_area_size(ipc_test_t *, size_t *);
 extern errno_t ipc_test_get_rw_area_size(ipc_test_t *, size_t *);
 extern errno_t ipc_test_share_in_ro(ipc_test_t *, size_t, const void **);
 extern errno_t ipc_test_share_in_rw(ipc_test_t *, size_t, void **);
+extern errno_t ipc_test_ring_create(ipc_test_t *, size_t, async_ring_t **);
+extern errno_t ipc_test_data_write(ipc_test_t *, const void *, size_t);
+extern errno_t ipc_test_data_read(ipc_test_t *, void *, size_t);
+extern errno_t ipc_test_share_out(ipc_test_t *, void *);
+extern errno_t ipc_test_forward_ping(ipc_test_t *);
+extern errno_t ipc_test_callback_create(ipc_test_t *);
+extern errno_t ipc_test_notify(ipc_test_t *, unsigned int);
 
 #endif
 
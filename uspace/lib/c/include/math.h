@@ -56,6 +56,17 @@ void sincosl(long double, long double *, long double *);
 
 #endif
 
+#ifdef _HELENOS_SOURCE
+
+void sin_array(const double *, double *, size_t);
+void sinf_array(const float *, float *, size_t);
+void cos_array(const double *, double *, size_t);
+void cosf_array(const float *, float *, size_t);
+void sincos_array(const double *, double *, double *, size_t);
+void sincosf_array(const float *, float *, float *, size_t);
+
+#endif
+
 #if FLT_EVAL_METHOD == 0
 typedef float float_t;
 typedef double double_t;
@@ -41,6 +41,8 @@ extern void qsort(void *, size_t, size_t, int (*)(const void *,
     const void *));
 extern void qsort_r(void *, size_t, size_t, int (*)(const void *,
     const void *, void *), void *);
+extern void qsort_parallel(void *, size_t, size_t, int (*)(const void *,
+    const void *, void *), void *);
 
 #endif
 
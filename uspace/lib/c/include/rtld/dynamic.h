@@ -69,6 +69,9 @@ typedef struct dyn_info {
 	/** Hash table */
 	elf_word *hash;
 
+	/** GNU hash table or @c NULL if not present */
+	elf_word *gnu_hash;
+
 	/** String table */
 	char *str_tab;
 	size_t str_sz;
@@ -214,6 +214,22 @@ extern int fileno(FILE *);
 extern int fseek64(FILE *, off64_t, int);
 extern off64_t ftell64(FILE *);
 
+/** Stream access pattern hints for fadvise() */
+enum {
+	/** Read ahead once sequential access is detected */
+	FADV_NORMAL,
+	/** Always read ahead */
+	FADV_SEQUENTIAL,
+	/** Never read ahead */
+	FADV_RANDOM,
+	/** Start reading ahead from the current position now */
+	FADV_WILLNEED,
+	/** Drop data read ahead */
+	FADV_DONTNEED
+};
+
+extern int fadvise(FILE *, int);
+
 #endif
 
 #ifdef __cplusplus
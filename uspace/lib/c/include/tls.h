@@ -64,6 +64,15 @@ static inline bool __tcb_is_set(void)
 	return __tcb_raw_get() != NULL;
 }
 
+/** Get a slot in the TCB of the current fibril.
+ *
+ * @param slot One of TLS_SLOT_xxx.
+ */
+static inline tls_slot_t *__tls_slot(unsigned int slot)
+{
+	return &__tcb_get()->slots[slot];
+}
+
 /** DTV Generation number - equals vector length */
 #define DTV_GN(dtv) (((uintptr_t *)(dtv))[0])
 
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_TYPES_BDICT_H_
+#define _LIBC_TYPES_BDICT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Maximum number of keys in a B+tree node
+ *
+ * With 8-byte keys and pointers a node takes four cache lines.
+ */
+#define BDICT_MAX_KEYS  15
+
+/** Minimum number of keys in a non-root B+tree node */
+#define BDICT_MIN_KEYS  (BDICT_MAX_KEYS / 2)
+
+/** Maximum depth of a B+tree, enough for any address space */
+#define BDICT_MAX_DEPTH  24
+
+/** B+tree dictionary key */
+typedef uint64_t bdkey_t;
+
+typedef struct bdict_node bdict_node_t;
+
+/** B+tree node */
+struct bdict_node {
+	/** Number of keys */
+	unsigned int nkeys;
+	/** True for leaf nodes */
+	bool leaf;
+	/** Keys in ascending order */
+	bdkey_t key[BDICT_MAX_KEYS];
+	union {
+		/** Values of a leaf node, value[i] belongs to key[i] */
+		void *value[BDICT_MAX_KEYS];
+		/**
+		 * Children of an inner node. The keys in child[i] are greater
+		 * or equal to key[i - 1] and less than key[i].
+		 */
+		bdict_node_t *child[BDICT_MAX_KEYS + 1];
+	};
+	/** Neighbouring leaves, valid in leaf nodes only */
+	bdict_node_t *prev;
+	bdict_node_t *next;
+};
+
+/** B+tree dictionary */
+typedef struct {
+	/** Root node or NULL if the dictionary is empty */
+	bdict_node_t *root;
+	/** Number of levels */
+	unsigned int depth;
+	/** Number of entries */
+	unsigned long count;
+} bdict_t;
+
+/** Position of an entry in a B+tree dictionary */
+typedef struct {
+	/** Leaf containing the entry */
+	bdict_node_t *leaf;
+	/** Index of the entry within the leaf */
+	unsigned int idx;
+} bdpos_t;
+
+#endif
+
+/** @}
+ */
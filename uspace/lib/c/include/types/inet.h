@@ -60,6 +60,24 @@ typedef enum {
 	INET_DF = 1
 } inet_df_t;
 
+/** Datagram reassembly statistics */
+typedef struct {
+	/** Fragments received */
+	uint64_t frags;
+	/** Fragments dropped (invalid, too large or out of memory) */
+	uint64_t frags_dropped;
+	/** Datagrams reassembled */
+	uint64_t reassembled;
+	/** Datagrams dropped because reassembly timed out */
+	uint64_t timeouts;
+	/** Datagrams dropped to stay within the memory budget */
+	uint64_t evicted;
+	/** Datagrams being reassembled */
+	size_t dgrams;
+	/** Memory used by datagrams being reassembled in bytes */
+	size_t mem;
+} inet_reass_stats_t;
+
 #endif
 
 /** @}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_TYPES_INET_TCP_H_
+#define _LIBC_TYPES_INET_TCP_H_
+
+#include <inet/endpoint.h>
+#include <stdint.h>
+
+/** TCP connection packet statistics */
+typedef struct {
+	/** Segments transmitted (including retransmissions) */
+	uint64_t seg_sent;
+	/** Segments received */
+	uint64_t seg_rcvd;
+	/** Segments retransmitted */
+	uint64_t seg_rexmit;
+	/** Data bytes transmitted (including retransmissions) */
+	uint64_t bytes_sent;
+	/** Data bytes received */
+	uint64_t bytes_rcvd;
+	/** Pure ACK segments transmitted */
+	uint64_t ack_sent;
+	/** Received data segments whose ACK was delayed */
+	uint64_t ack_delayed;
+} tcp_conn_stats_t;
+
+/** TCP connection information as reported by the TCP service */
+typedef struct {
+	/** Connection endpoint pair */
+	inet_ep2_t epp;
+	/** Packet statistics */
+	tcp_conn_stats_t stats;
+} tcp_conn_info_t;
+
+#endif
+
+/** @}
+ */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Thread control block slots
+ *
+ * Every fibril has its own TCB, which is switched together with the rest
+ * of the fibril context. A value kept in a TCB slot is thus fibril-local
+ * and can be reached with a single load from the thread pointer, unlike
+ * a fibril_local variable in a shared library.
+ */
+
+#ifndef _LIBC_TYPES_TLS_H_
+#define _LIBC_TYPES_TLS_H_
+
+#include <_bits/errno.h>
+#include <stdint.h>
+
+/** Number of slots in each TCB */
+#define TLS_SLOT_COUNT  16
+
+/** Value kept in a TCB slot */
+typedef union {
+	void *ptr;
+	uintptr_t uint;
+	errno_t err;
+} tls_slot_t;
+
+/** TCB slots reserved for libc */
+enum {
+	/** Value of errno */
+	TLS_SLOT_ERRNO,
+	/** Arena the fibril allocated from last time */
+	TLS_SLOT_MALLOC_ARENA,
+	/** Connection served by the fibril */
+	TLS_SLOT_ASYNC_CONN,
+	/** First slot available to fibril_key_create() */
+	TLS_SLOT_KEY_FIRST = 4
+};
+
+#endif
+
+/** @}
+ */
@@ -43,6 +43,7 @@
 typedef sysarg_t thash_t;
 
 extern errno_t udebug_begin(async_sess_t *);
+extern errno_t udebug_begin_sampling(async_sess_t *);
 extern errno_t udebug_end(async_sess_t *);
 extern errno_t udebug_set_evmask(async_sess_t *, udebug_evmask_t);
 extern errno_t udebug_thread_read(async_sess_t *, void *, size_t, size_t *,
@@ -52,6 +53,9 @@ extern errno_t udebug_name_read(async_sess_t *, void *, size_t, size_t *,
 extern errno_t udebug_areas_read(async_sess_t *, void *, size_t, size_t *,
     size_t *);
 extern errno_t udebug_mem_read(async_sess_t *, void *, uintptr_t, size_t);
+extern errno_t udebug_mem_readv(async_sess_t *, void *,
+    const udebug_mem_range_t *, size_t);
+extern errno_t udebug_stats_read(async_sess_t *, udebug_stats_t *);
 extern errno_t udebug_args_read(async_sess_t *, thash_t, sysarg_t *);
 extern errno_t udebug_regs_read(async_sess_t *, thash_t, void *);
 extern errno_t udebug_go(async_sess_t *, thash_t, udebug_event_t *, sysarg_t *,
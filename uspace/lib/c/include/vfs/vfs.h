@@ -73,6 +73,24 @@ typedef struct {
 	uint64_t f_bfree;    /* free blocks in fs */
 } vfs_statfs_t;
 
+/** One buffer of a vectored read or write */
+typedef struct {
+	void *base;
+	size_t len;
+} vfs_iovec_t;
+
+/** Read or write request in flight */
+typedef struct {
+	/** Exchange the request was sent over */
+	async_exch_t *exch;
+	/** Method call */
+	aid_t req;
+	/** Accompanying data transfer */
+	aid_t data;
+	/** Answer to the method call */
+	ipc_call_t answer;
+} vfs_aio_t;
+
 /** List of file system types */
 typedef struct {
 	char **fstypes;
@@ -95,15 +113,25 @@ extern errno_t vfs_link(int, const char *, vfs_file_kind_t, int *);
 extern errno_t vfs_link_path(const char *, vfs_file_kind_t, int *);
 extern errno_t vfs_lookup(const char *, int, int *);
 extern errno_t vfs_lookup_open(const char *, int, int, int *);
+extern errno_t vfs_mmap(int, aoff64_t, void *, size_t, unsigned int, bool,
+    void **);
 extern errno_t vfs_mount_path(const char *, const char *, const char *,
     const char *, unsigned int, unsigned int);
 extern errno_t vfs_mount(int, const char *, service_id_t, const char *, unsigned,
     unsigned, int *);
+extern errno_t vfs_msync(void *);
+extern errno_t vfs_munmap(void *);
 extern errno_t vfs_open(int, int);
 extern errno_t vfs_pass_handle(async_exch_t *, int, async_exch_t *);
 extern errno_t vfs_put(int);
 extern errno_t vfs_read(int, aoff64_t *, void *, size_t, size_t *);
+extern errno_t vfs_read_buffer(int, aoff64_t *, size_t, size_t, size_t *);
+extern errno_t vfs_read_buffer_create(int, size_t, void **);
 extern errno_t vfs_read_short(int, aoff64_t, void *, size_t, ssize_t *);
+extern void vfs_read_start(int, aoff64_t, void *, size_t, vfs_aio_t *);
+extern errno_t vfs_readdir(int, aoff64_t, void *, size_t, size_t *);
+extern errno_t vfs_readv(int, aoff64_t *, const vfs_iovec_t *, size_t,
+    size_t *);
 extern errno_t vfs_receive_handle(bool, int *);
 extern errno_t vfs_rename_path(const char *, const char *);
 extern errno_t vfs_resize(int, aoff64_t);
@@ -121,6 +149,10 @@ extern errno_t vfs_unmount_path(const char *);
 extern errno_t vfs_walk(int, const char *, int, int *);
 extern errno_t vfs_write(int, aoff64_t *, const void *, size_t, size_t *);
 extern errno_t vfs_write_short(int, aoff64_t, const void *, size_t, ssize_t *);
+extern void vfs_write_start(int, aoff64_t, const void *, size_t, vfs_aio_t *);
+extern errno_t vfs_aio_wait(vfs_aio_t *, size_t *);
+extern errno_t vfs_writev(int, aoff64_t *, const vfs_iovec_t *, size_t,
+    size_t *);
 
 #endif
 
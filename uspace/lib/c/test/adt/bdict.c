@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/bdict.h>
+#include <pcut/pcut.h>
+#include <stdlib.h>
+
+enum {
+	/** Number of test entries, enough for a three-level tree */
+	test_count = 4000
+};
+
+static bdkey_t test_keys[test_count];
+static void *test_values[test_count];
+
+/** Value stored with a key in the tests */
+static void *test_value(bdkey_t key)
+{
+	return (void *) (uintptr_t) (key * 3 + 1);
+}
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(bdict);
+
+/** Inserted entries are found and walked in ascending order. */
+PCUT_TEST(insert)
+{
+	bdict_t bdict;
+	bdpos_t pos;
+	bdkey_t i, key;
+
+	bdict_initialize(&bdict);
+	PCUT_ASSERT_TRUE(bdict_empty(&bdict));
+	PCUT_ASSERT_FALSE(bdict_first(&bdict, &pos));
+
+	/* Insert the even keys in a scrambled order. */
+	for (i = 0; i < test_count; i++) {
+		key = 2 * ((i * 1237) % test_count);
+		PCUT_ASSERT_ERRNO_VAL(EOK, bdict_insert(&bdict, key,
+		    test_value(key)));
+	}
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, bdict_validate(&bdict));
+	PCUT_ASSERT_INT_EQUALS(test_count, bdict_count(&bdict));
+	PCUT_ASSERT_ERRNO_VAL(EEXIST, bdict_insert(&bdict, 10, NULL));
+
+	i = 0;
+	PCUT_ASSERT_TRUE(bdict_first(&bdict, &pos));
+	do {
+		PCUT_ASSERT_INT_EQUALS(2 * i, bdict_key(&pos));
+		PCUT_ASSERT_EQUALS(test_value(2 * i), bdict_value(&pos));
+		++i;
+	} while (bdict_next(&pos));
+	PCUT_ASSERT_INT_EQUALS(test_count, i);
+
+	PCUT_ASSERT_TRUE(bdict_last(&bdict, &pos));
+	do {
+		--i;
+		PCUT_ASSERT_INT_EQUALS(2 * i, bdict_key(&pos));
+	} while (bdict_prev(&pos));
+	PCUT_ASSERT_INT_EQUALS(0, i);
+
+	bdict_finalize(&bdict);
+}
+
+/** Range lookups find the nearest entries. */
+PCUT_TEST(find)
+{
+	bdict_t bdict;
+	bdpos_t pos;
+	bdkey_t i;
+
+	bdict_initialize(&bdict);
+
+	for (i = 0; i < test_count; i++) {
+		PCUT_ASSERT_ERRNO_VAL(EOK, bdict_insert(&bdict, 2 * i + 2,
+		    test_value(2 * i + 2)));
+	}
+
+	for (i = 1; i <= 2 * test_count + 1; i++) {
+		if (i % 2 == 0) {
+			PCUT_ASSERT_TRUE(bdict_find_eq(&bdict, i, &pos));
+			PCUT_ASSERT_INT_EQUALS(i, bdict_key(&pos));
+			PCUT_ASSERT_EQUALS(test_value(i), bdict_get(&bdict, i));
+		} else {
+			PCUT_ASSERT_FALSE(bdict_find_eq(&bdict, i, &pos));
+			PCUT_ASSERT_NULL(bdict_get(&bdict, i));
+		}
+
+		if (i <= 2 * test_count) {
+			PCUT_ASSERT_TRUE(bdict_find_geq(&bdict, i, &pos));
+			PCUT_ASSERT_INT_EQUALS(i + i % 2, bdict_key(&pos));
+		} else {
+			PCUT_ASSERT_FALSE(bdict_find_geq(&bdict, i, &pos));
+		}
+
+		if (i < 2 * test_count) {
+			PCUT_ASSERT_TRUE(bdict_find_gt(&bdict, i, &pos));
+			PCUT_ASSERT_INT_EQUALS(i + 2 - i % 2, bdict_key(&pos));
+		} else {
+			PCUT_ASSERT_FALSE(bdict_find_gt(&bdict, i, &pos));
+		}
+
+		if (i >= 2) {
+			PCUT_ASSERT_TRUE(bdict_find_leq(&bdict, i, &pos));
+			PCUT_ASSERT_INT_EQUALS(i - i % 2, bdict_key(&pos));
+		} else {
+			PCUT_ASSERT_FALSE(bdict_find_leq(&bdict, i, &pos));
+		}
+
+		if (i > 2) {
+			PCUT_ASSERT_TRUE(bdict_find_lt(&bdict, i, &pos));
+			PCUT_ASSERT_INT_EQUALS(i - 2 + i % 2, bdict_key(&pos));
+		} else {
+			PCUT_ASSERT_FALSE(bdict_find_lt(&bdict, i, &pos));
+		}
+	}
+
+	bdict_finalize(&bdict);
+}
+
+/** Removal keeps the tree balanced down to an empty tree. */
+PCUT_TEST(remove)
+{
+	bdict_t bdict;
+	bdpos_t pos;
+	bdkey_t i, key;
+	void *value;
+
+	bdict_initialize(&bdict);
+
+	for (i = 0; i < test_count; i++)
+		PCUT_ASSERT_ERRNO_VAL(EOK, bdict_insert(&bdict, i, test_value(i)));
+
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, bdict_remove(&bdict, test_count, NULL));
+
+	for (i = 0; i < test_count; i++) {
+		key = (i * 1237) % test_count;
+		PCUT_ASSERT_ERRNO_VAL(EOK, bdict_remove(&bdict, key, &value));
+		PCUT_ASSERT_EQUALS(test_value(key), value);
+		PCUT_ASSERT_FALSE(bdict_find_eq(&bdict, key, &pos));
+
+		if (i % 100 == 0)
+			PCUT_ASSERT_ERRNO_VAL(EOK, bdict_validate(&bdict));
+	}
+
+	PCUT_ASSERT_TRUE(bdict_empty(&bdict));
+	PCUT_ASSERT_ERRNO_VAL(EOK, bdict_validate(&bdict));
+
+	bdict_finalize(&bdict);
+}
+
+/** Bulk-loaded trees are valid and can be modified. */
+PCUT_TEST(load)
+{
+	bdict_t bdict;
+	bdpos_t pos;
+	size_t n, i;
+
+	for (n = 0; n < test_count; n = 2 * n + 1) {
+		for (i = 0; i < n; i++) {
+			test_keys[i] = 2 * i;
+			test_values[i] = test_value(2 * i);
+		}
+
+		bdict_initialize(&bdict);
+		PCUT_ASSERT_ERRNO_VAL(EOK, bdict_load(&bdict, test_keys,
+		    test_values, n));
+		PCUT_ASSERT_ERRNO_VAL(EOK, bdict_validate(&bdict));
+		PCUT_ASSERT_INT_EQUALS(n, bdict_count(&bdict));
+
+		for (i = 0; i < n; i++) {
+			PCUT_ASSERT_TRUE(bdict_find_eq(&bdict, 2 * i, &pos));
+			PCUT_ASSERT_EQUALS(test_value(2 * i), bdict_value(&pos));
+		}
+
+		for (i = 0; i < n; i++) {
+			PCUT_ASSERT_ERRNO_VAL(EOK, bdict_insert(&bdict, 2 * i + 1,
+			    NULL));
+		}
+
+		PCUT_ASSERT_ERRNO_VAL(EOK, bdict_validate(&bdict));
+		bdict_finalize(&bdict);
+	}
+
+	test_keys[0] = 1;
+	test_keys[1] = 1;
+	bdict_initialize(&bdict);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, bdict_load(&bdict, test_keys,
+	    test_values, 2));
+	PCUT_ASSERT_TRUE(bdict_empty(&bdict));
+}
+
+PCUT_EXPORT(bdict);
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/hash_table.h>
+#include <pcut/pcut.h>
+#include <stdlib.h>
+
+/** Test entry */
+typedef struct {
+	ht_link_t link;
+	size_t key;
+} test_entry_t;
+
+enum {
+	/** Number of test entries, enough for several resizes */
+	test_count = 5000
+};
+
+static test_entry_t entries[test_count];
+
+static size_t test_key_hash(const void *key)
+{
+	return *(const size_t *) key;
+}
+
+static size_t test_hash(const ht_link_t *item)
+{
+	test_entry_t *e = hash_table_get_inst(item, test_entry_t, link);
+	return e->key;
+}
+
+static bool test_key_equal(const void *key, const ht_link_t *item)
+{
+	test_entry_t *e = hash_table_get_inst(item, test_entry_t, link);
+	return *(const size_t *) key == e->key;
+}
+
+static bool test_equal(const ht_link_t *a, const ht_link_t *b)
+{
+	return test_hash(a) == test_hash(b);
+}
+
+static hash_table_ops_t test_ops = {
+	.hash = test_hash,
+	.key_hash = test_key_hash,
+	.key_equal = test_key_equal,
+	.equal = test_equal,
+	.remove_callback = NULL
+};
+
+/** Count the items with a key, using hash_table_find_next(). */
+static size_t test_count_key(hash_table_t *h, size_t key)
+{
+	ht_link_t *first = hash_table_find(h, &key);
+	if (first == NULL)
+		return 0;
+
+	size_t cnt = 1;
+	ht_link_t *cur = first;
+	while ((cur = hash_table_find_next(h, first, cur)) != NULL)
+		++cnt;
+
+	return cnt;
+}
+
+static bool test_count_fn(ht_link_t *item, void *arg)
+{
+	size_t *cnt = (size_t *) arg;
+	++*cnt;
+	return true;
+}
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(hash_table);
+
+/** All items stay reachable while the table grows. */
+PCUT_TEST(grow)
+{
+	hash_table_t h;
+	size_t i, j;
+
+	PCUT_ASSERT_TRUE(hash_table_create(&h, 0, 0, &test_ops));
+
+	for (i = 0; i < test_count; i++) {
+		entries[i].key = i;
+		hash_table_insert(&h, &entries[i].link);
+		PCUT_ASSERT_INT_EQUALS(i + 1, hash_table_size(&h));
+
+		if (i % 256 == 0) {
+			for (j = 0; j <= i; j++)
+				PCUT_ASSERT_NOT_NULL(hash_table_find(&h, &j));
+		}
+	}
+
+	for (i = 0; i < test_count; i++) {
+		ht_link_t *link = hash_table_find(&h, &i);
+		PCUT_ASSERT_EQUALS(&entries[i].link, link);
+	}
+
+	hash_table_destroy(&h);
+}
+
+/** Removed items disappear and the others stay while the table shrinks. */
+PCUT_TEST(shrink)
+{
+	hash_table_t h;
+	size_t i;
+
+	PCUT_ASSERT_TRUE(hash_table_create(&h, 0, 0, &test_ops));
+
+	for (i = 0; i < test_count; i++) {
+		entries[i].key = i;
+		hash_table_insert(&h, &entries[i].link);
+	}
+
+	for (i = 0; i < test_count; i += 2)
+		PCUT_ASSERT_INT_EQUALS(1, hash_table_remove(&h, &i));
+
+	for (i = 1; i < test_count; i += 4)
+		hash_table_remove_item(&h, &entries[i].link);
+
+	PCUT_ASSERT_INT_EQUALS(test_count / 4, hash_table_size(&h));
+
+	for (i = 0; i < test_count; i++) {
+		ht_link_t *link = hash_table_find(&h, &i);
+		if (i % 4 == 3)
+			PCUT_ASSERT_EQUALS(&entries[i].link, link);
+		else
+			PCUT_ASSERT_NULL(link);
+	}
+
+	hash_table_destroy(&h);
+}
+
+/** Items with equal keys are all found while the table is resized. */
+PCUT_TEST(duplicates)
+{
+	hash_table_t h;
+	size_t i;
+
+	PCUT_ASSERT_TRUE(hash_table_create(&h, 0, 0, &test_ops));
+
+	for (i = 0; i < test_count; i++) {
+		entries[i].key = i % 7 == 0 ? 7 : i;
+		hash_table_insert(&h, &entries[i].link);
+	}
+
+	PCUT_ASSERT_INT_EQUALS((test_count + 6) / 7, test_count_key(&h, 7));
+	PCUT_ASSERT_INT_EQUALS(1, test_count_key(&h, 8));
+
+	i = 7;
+	PCUT_ASSERT_FALSE(hash_table_insert_unique(&h, &entries[0].link));
+	PCUT_ASSERT_INT_EQUALS((test_count + 6) / 7,
+	    hash_table_remove(&h, &i));
+	PCUT_ASSERT_NULL(hash_table_find(&h, &i));
+
+	hash_table_destroy(&h);
+}
+
+/** hash_table_apply() visits every item once, even during a resize. */
+PCUT_TEST(apply)
+{
+	hash_table_t h;
+	size_t i, cnt;
+
+	PCUT_ASSERT_TRUE(hash_table_create(&h, 0, 0, &test_ops));
+
+	for (i = 0; i < test_count; i++) {
+		entries[i].key = i;
+		hash_table_insert(&h, &entries[i].link);
+
+		cnt = 0;
+		if (i % 97 == 0) {
+			hash_table_apply(&h, test_count_fn, &cnt);
+			PCUT_ASSERT_INT_EQUALS(i + 1, cnt);
+		}
+	}
+
+	hash_table_clear(&h);
+	PCUT_ASSERT_TRUE(hash_table_empty(&h));
+
+	cnt = 0;
+	hash_table_apply(&h, test_count_fn, &cnt);
+	PCUT_ASSERT_INT_EQUALS(0, cnt);
+
+	hash_table_destroy(&h);
+}
+
+/** A table reserved in advance does not grow during bulk insertion. */
+PCUT_TEST(reserve)
+{
+	hash_table_t h;
+	size_t i;
+
+	PCUT_ASSERT_TRUE(hash_table_create(&h, 0, 0, &test_ops));
+	PCUT_ASSERT_TRUE(hash_table_reserve(&h, test_count));
+
+	size_t bucket_cnt = h.bucket_cnt;
+	PCUT_ASSERT_TRUE(bucket_cnt * 2 >= test_count);
+
+	for (i = 0; i < test_count; i++) {
+		entries[i].key = i;
+		hash_table_insert(&h, &entries[i].link);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(bucket_cnt, h.bucket_cnt);
+
+	for (i = 0; i < test_count; i++)
+		PCUT_ASSERT_NOT_NULL(hash_table_find(&h, &i));
+
+	hash_table_destroy(&h);
+}
+
+PCUT_EXPORT(hash_table);
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/checksum.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(checksum);
+
+#define BUF_SIZE  1000
+
+/** Bit-at-a-time reference implementation of a reflected CRC. */
+static uint32_t crc_ref(uint32_t poly, const uint8_t *data, size_t length,
+    uint32_t seed)
+{
+	uint32_t crc = ~seed;
+
+	while (length-- > 0) {
+		crc ^= *(data++);
+		for (unsigned int i = 0; i < 8; i++)
+			crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+	}
+
+	return ~crc;
+}
+
+/** Word-at-a-time reference implementation of the Internet checksum. */
+static uint16_t inet_ref(uint16_t ivalue, const uint8_t *data, size_t length)
+{
+	uint32_t sum = (uint16_t) ~ivalue;
+
+	for (size_t i = 0; i < length; i += 2) {
+		sum += (uint32_t) data[i] << 8;
+		if (i + 1 < length)
+			sum += data[i + 1];
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+
+	return ~sum;
+}
+
+static void fill_buf(uint8_t *buf, size_t size)
+{
+	uint32_t x = 12345;
+
+	for (size_t i = 0; i < size; i++) {
+		x = x * 1103515245 + 12345;
+		buf[i] = x >> 16;
+	}
+}
+
+/** Standard check values */
+PCUT_TEST(check_value)
+{
+	uint8_t data[] = "123456789";
+
+	PCUT_ASSERT_INT_EQUALS(0xcbf43926, compute_crc32(data, 9));
+	PCUT_ASSERT_INT_EQUALS(0xe3069283, compute_crc32c(data, 9));
+	PCUT_ASSERT_INT_EQUALS(0, compute_crc32(data, 0));
+	PCUT_ASSERT_INT_EQUALS(0, compute_crc32c(data, 0));
+}
+
+/** All lengths and alignments match the reference implementation */
+PCUT_TEST(reference)
+{
+	uint8_t buf[BUF_SIZE];
+	fill_buf(buf, BUF_SIZE);
+
+	for (size_t off = 0; off < 8; off++) {
+		for (size_t len = 0; len < 100; len++) {
+			PCUT_ASSERT_INT_EQUALS(crc_ref(0xedb88320, buf + off,
+			    len, 0), compute_crc32(buf + off, len));
+			PCUT_ASSERT_INT_EQUALS(crc_ref(0x82f63b78, buf + off,
+			    len, 0), compute_crc32c(buf + off, len));
+		}
+	}
+
+	PCUT_ASSERT_INT_EQUALS(crc_ref(0xedb88320, buf + 3, BUF_SIZE - 3, 0),
+	    compute_crc32(buf + 3, BUF_SIZE - 3));
+	PCUT_ASSERT_INT_EQUALS(crc_ref(0x82f63b78, buf + 3, BUF_SIZE - 3, 0),
+	    compute_crc32c(buf + 3, BUF_SIZE - 3));
+}
+
+/** Checksumming in pieces gives the same result as all at once */
+PCUT_TEST(seed)
+{
+	uint8_t buf[BUF_SIZE];
+	fill_buf(buf, BUF_SIZE);
+
+	uint32_t crc = compute_crc32(buf, 123);
+	crc = compute_crc32_seed(buf + 123, 500, crc);
+	crc = compute_crc32_seed(buf + 623, BUF_SIZE - 623, crc);
+	PCUT_ASSERT_INT_EQUALS(compute_crc32(buf, BUF_SIZE), crc);
+
+	crc = compute_crc32c(buf, 77);
+	crc = compute_crc32c_seed(buf + 77, 13, crc);
+	crc = compute_crc32c_seed(buf + 90, BUF_SIZE - 90, crc);
+	PCUT_ASSERT_INT_EQUALS(compute_crc32c(buf, BUF_SIZE), crc);
+}
+
+/** Internet checksum matches the example in RFC 1071 and the reference */
+PCUT_TEST(inet_checksum)
+{
+	uint8_t data[] = { 0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7 };
+	uint8_t buf[BUF_SIZE];
+	fill_buf(buf, BUF_SIZE);
+
+	PCUT_ASSERT_INT_EQUALS(0x220d, compute_inet_checksum(0xffff, data, 8));
+
+	for (size_t off = 0; off < 8; off++) {
+		for (size_t len = 0; len < 200; len++) {
+			PCUT_ASSERT_INT_EQUALS(inet_ref(0xffff, buf + off, len),
+			    compute_inet_checksum(0xffff, buf + off, len));
+		}
+	}
+
+	PCUT_ASSERT_INT_EQUALS(inet_ref(0x1234, buf + 1, BUF_SIZE - 1),
+	    compute_inet_checksum(0x1234, buf + 1, BUF_SIZE - 1));
+
+	uint16_t cs = compute_inet_checksum(0xffff, buf, 124);
+	cs = compute_inet_checksum(cs, buf + 124, BUF_SIZE - 124);
+	PCUT_ASSERT_INT_EQUALS(compute_inet_checksum(0xffff, buf, BUF_SIZE),
+	    cs);
+}
+
+/** Copying checksum copies the data and computes the same checksum */
+PCUT_TEST(inet_checksum_copy)
+{
+	uint8_t buf[BUF_SIZE];
+	uint8_t dst[BUF_SIZE];
+	fill_buf(buf, BUF_SIZE);
+
+	for (size_t len = 0; len < 40; len++) {
+		memset(dst, 0, BUF_SIZE);
+		PCUT_ASSERT_INT_EQUALS(compute_inet_checksum(0xffff, buf + 3,
+		    len), compute_inet_checksum_copy(0xffff, dst + 1, buf + 3,
+		    len));
+		PCUT_ASSERT_INT_EQUALS(0, memcmp(dst + 1, buf + 3, len));
+		PCUT_ASSERT_INT_EQUALS(0, dst[len + 1]);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(compute_inet_checksum(0xffff, buf, BUF_SIZE),
+	    compute_inet_checksum_copy(0xffff, dst, buf, BUF_SIZE));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(dst, buf, BUF_SIZE));
+}
+
+/** Incremental update gives the same result as recomputing */
+PCUT_TEST(inet_checksum_update)
+{
+	uint8_t buf[64];
+	fill_buf(buf, sizeof(buf));
+
+	uint16_t cs = compute_inet_checksum(0xffff, buf, sizeof(buf));
+
+	uint16_t old16 = ((uint16_t) buf[10] << 8) | buf[11];
+	buf[10] = 0xab;
+	buf[11] = 0xcd;
+	cs = update_inet_checksum16(cs, old16, 0xabcd);
+	PCUT_ASSERT_INT_EQUALS(compute_inet_checksum(0xffff, buf,
+	    sizeof(buf)), cs);
+
+	uint32_t old32 = ((uint32_t) buf[20] << 24) |
+	    ((uint32_t) buf[21] << 16) | ((uint32_t) buf[22] << 8) | buf[23];
+	buf[20] = 0x12;
+	buf[21] = 0x34;
+	buf[22] = 0x56;
+	buf[23] = 0x78;
+	cs = update_inet_checksum32(cs, old32, 0x12345678);
+	PCUT_ASSERT_INT_EQUALS(compute_inet_checksum(0xffff, buf,
+	    sizeof(buf)), cs);
+}
+
+PCUT_EXPORT(checksum);
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/mpsc_queue.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <pcut/pcut.h>
+#include <time.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(channel);
+
+enum {
+	nitems = 10
+};
+
+typedef struct {
+	mpsc_link_t link;
+	int value;
+} test_item_t;
+
+/** Items pushed to an MPSC queue come out in FIFO order. */
+PCUT_TEST(mpsc_queue_fifo)
+{
+	mpsc_queue_t q;
+	test_item_t items[nitems];
+	mpsc_link_t *link;
+	test_item_t *item;
+	int i;
+
+	mpsc_queue_initialize(&q);
+	PCUT_ASSERT_TRUE(mpsc_queue_empty(&q));
+	PCUT_ASSERT_NULL(mpsc_queue_pop(&q));
+
+	for (i = 0; i < nitems; i++) {
+		items[i].value = i;
+		mpsc_queue_push(&q, &items[i].link);
+	}
+
+	PCUT_ASSERT_FALSE(mpsc_queue_empty(&q));
+
+	for (i = 0; i < nitems; i++) {
+		link = mpsc_queue_pop(&q);
+		PCUT_ASSERT_NOT_NULL(link);
+		item = mpsc_queue_get_inst(link, test_item_t, link);
+		PCUT_ASSERT_INT_EQUALS(i, item->value);
+	}
+
+	PCUT_ASSERT_TRUE(mpsc_queue_empty(&q));
+	PCUT_ASSERT_NULL(mpsc_queue_pop(&q));
+
+	/* The queue stays usable after being drained. */
+	mpsc_queue_push(&q, &items[0].link);
+	PCUT_ASSERT_EQUALS(&items[0].link, mpsc_queue_pop(&q));
+	PCUT_ASSERT_NULL(mpsc_queue_pop(&q));
+}
+
+/** Messages sent before closing an MPSC channel are still delivered. */
+PCUT_TEST(mpsc_send_close)
+{
+	mpsc_t *q;
+	errno_t rc;
+	int i;
+	int v;
+
+	q = mpsc_create(sizeof(int));
+	PCUT_ASSERT_NOT_NULL(q);
+
+	for (i = 0; i < nitems; i++) {
+		rc = mpsc_send(q, &i);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	}
+
+	mpsc_close(q);
+
+	rc = mpsc_send(q, &i);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	for (i = 0; i < nitems; i++) {
+		rc = mpsc_receive(q, &v, NULL);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		PCUT_ASSERT_INT_EQUALS(i, v);
+	}
+
+	rc = mpsc_receive(q, &v, NULL);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+	rc = mpsc_receive(q, &v, NULL);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	mpsc_destroy(q);
+}
+
+/** Destroying an MPSC channel with pending messages does not leak them. */
+PCUT_TEST(mpsc_destroy_pending)
+{
+	mpsc_t *q;
+	errno_t rc;
+	int i;
+
+	q = mpsc_create(sizeof(int));
+	PCUT_ASSERT_NOT_NULL(q);
+
+	for (i = 0; i < nitems; i++) {
+		rc = mpsc_send(q, &i);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	}
+
+	mpsc_destroy(q);
+}
+
+/** A bounded MPMC channel holds at least the requested number of items. */
+PCUT_TEST(mpmc_capacity)
+{
+	mpmc_t *q;
+	errno_t rc;
+	int i;
+	int v;
+
+	q = mpmc_create(sizeof(int), nitems);
+	PCUT_ASSERT_NOT_NULL(q);
+
+	rc = mpmc_tryreceive(q, &v);
+	PCUT_ASSERT_ERRNO_VAL(EAGAIN, rc);
+
+	i = 0;
+	while (mpmc_trysend(q, &i) == EOK)
+		i++;
+
+	/* Capacity is rounded up to a power of two. */
+	PCUT_ASSERT_INT_EQUALS(16, i);
+
+	rc = mpmc_trysend(q, &i);
+	PCUT_ASSERT_ERRNO_VAL(EAGAIN, rc);
+
+	for (i = 0; i < 16; i++) {
+		rc = mpmc_tryreceive(q, &v);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		PCUT_ASSERT_INT_EQUALS(i, v);
+	}
+
+	rc = mpmc_tryreceive(q, &v);
+	PCUT_ASSERT_ERRNO_VAL(EAGAIN, rc);
+
+	mpmc_destroy(q);
+}
+
+/** Blocking operations on an MPMC channel honor their deadline. */
+PCUT_TEST(mpmc_timeout)
+{
+	mpmc_t *q;
+	struct timespec expires;
+	errno_t rc;
+	int v;
+
+	q = mpmc_create(sizeof(int), 2);
+	PCUT_ASSERT_NOT_NULL(q);
+
+	getuptime(&expires);
+	ts_add_diff(&expires, MSEC2NSEC(10));
+	rc = mpmc_receive(q, &v, &expires);
+	PCUT_ASSERT_ERRNO_VAL(ETIMEOUT, rc);
+
+	v = 1;
+	rc = mpmc_send(q, &v, NULL);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = mpmc_send(q, &v, NULL);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	getuptime(&expires);
+	ts_add_diff(&expires, MSEC2NSEC(10));
+	rc = mpmc_send(q, &v, &expires);
+	PCUT_ASSERT_ERRNO_VAL(ETIMEOUT, rc);
+
+	mpmc_destroy(q);
+}
+
+/** Closing an MPMC channel rejects senders and drains receivers. */
+PCUT_TEST(mpmc_close)
+{
+	mpmc_t *q;
+	errno_t rc;
+	int v;
+
+	q = mpmc_create(sizeof(int), 4);
+	PCUT_ASSERT_NOT_NULL(q);
+
+	v = 42;
+	rc = mpmc_send(q, &v, NULL);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	mpmc_close(q);
+
+	rc = mpmc_send(q, &v, NULL);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+	rc = mpmc_trysend(q, &v);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	v = 0;
+	rc = mpmc_receive(q, &v, NULL);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(42, v);
+
+	rc = mpmc_receive(q, &v, NULL);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+	rc = mpmc_tryreceive(q, &v);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	mpmc_destroy(q);
+}
+
+PCUT_EXPORT(channel);
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <pcut/pcut.h>
+#include <stdbool.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(fibril_drwlock);
+
+static fibril_drwlock_t test_drwlock;
+static bool writer_locked;
+static bool writer_done;
+
+static errno_t writer_fibril(void *arg)
+{
+	fibril_drwlock_write_lock(&test_drwlock);
+	writer_locked = true;
+	fibril_drwlock_write_unlock(&test_drwlock);
+
+	writer_done = true;
+	return EOK;
+}
+
+/** Readers share the lock. */
+PCUT_TEST(readers)
+{
+	PCUT_ASSERT_ERRNO_VAL(EOK, fibril_drwlock_initialize(&test_drwlock));
+
+	fibril_drwlock_read_lock(&test_drwlock);
+	fibril_drwlock_read_lock(&test_drwlock);
+	fibril_drwlock_read_unlock(&test_drwlock);
+	fibril_drwlock_read_unlock(&test_drwlock);
+
+	fibril_drwlock_write_lock(&test_drwlock);
+	fibril_drwlock_write_unlock(&test_drwlock);
+
+	fibril_drwlock_destroy(&test_drwlock);
+}
+
+/** A writer waits for the readers to leave. */
+PCUT_TEST(writer_waits)
+{
+	fid_t fid;
+	int i;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, fibril_drwlock_initialize(&test_drwlock));
+
+	writer_locked = false;
+	writer_done = false;
+
+	fibril_drwlock_read_lock(&test_drwlock);
+
+	fid = fibril_create(writer_fibril, NULL);
+	PCUT_ASSERT_NOT_NULL(fid);
+	fibril_add_ready(fid);
+
+	for (i = 0; i < 10; i++)
+		fibril_yield();
+
+	PCUT_ASSERT_FALSE(writer_locked);
+	fibril_drwlock_read_unlock(&test_drwlock);
+
+	for (i = 0; i < 100 && !writer_done; i++)
+		fibril_yield();
+
+	PCUT_ASSERT_TRUE(writer_done);
+
+	/* Readers get in once the writer is gone. */
+	fibril_drwlock_read_lock(&test_drwlock);
+	fibril_drwlock_read_unlock(&test_drwlock);
+
+	fibril_drwlock_destroy(&test_drwlock);
+}
+
+/** RCU readers see either the old or the new data. */
+PCUT_TEST(rcu)
+{
+	static int old_value = 1;
+	static int new_value = 2;
+	static int *value = &old_value;
+	int *v;
+
+	fibril_rcu_read_lock();
+	fibril_rcu_read_lock();
+	v = fibril_rcu_access(value);
+	PCUT_ASSERT_INT_EQUALS(1, *v);
+	fibril_rcu_read_unlock();
+	fibril_rcu_read_unlock();
+
+	fibril_rcu_assign(value, &new_value);
+	fibril_rcu_synchronize();
+
+	fibril_rcu_read_lock();
+	v = fibril_rcu_access(value);
+	PCUT_ASSERT_INT_EQUALS(2, *v);
+	fibril_rcu_read_unlock();
+}
+
+PCUT_EXPORT(fibril_drwlock);
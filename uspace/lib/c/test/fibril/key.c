@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fibril.h>
+#include <pcut/pcut.h>
+#include <stdbool.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(fibril_key);
+
+static fibril_key_t test_key;
+static int destroyed;
+static int values[2];
+static bool fibril_done;
+static errno_t fibril_errno;
+
+static void test_destructor(void *arg)
+{
+	if (arg == &values[1])
+		destroyed++;
+}
+
+static errno_t test_fibril(void *arg)
+{
+	fibril_errno = EOK;
+
+	/* Values and errno start out cleared in a new fibril. */
+	if (fibril_key_get(test_key) != NULL || errno != EOK)
+		fibril_errno = EINVAL;
+
+	fibril_key_set(test_key, &values[1]);
+	errno = ENOENT;
+	fibril_yield();
+
+	if (fibril_key_get(test_key) != &values[1] || errno != ENOENT)
+		fibril_errno = EINVAL;
+
+	fibril_done = true;
+	return EOK;
+}
+
+/** Keys hold a separate value in each fibril. */
+PCUT_TEST(fibril_local_values)
+{
+	fid_t fid;
+	int i;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, fibril_key_create(&test_key,
+	    test_destructor));
+	PCUT_ASSERT_NULL(fibril_key_get(test_key));
+
+	fibril_key_set(test_key, &values[0]);
+	errno = EOK;
+
+	destroyed = 0;
+	fibril_done = false;
+	fid = fibril_create(test_fibril, NULL);
+	PCUT_ASSERT_NOT_NULL(fid);
+	fibril_add_ready(fid);
+
+	for (i = 0; i < 100 && destroyed == 0; i++)
+		fibril_yield();
+
+	PCUT_ASSERT_TRUE(fibril_done);
+	PCUT_ASSERT_ERRNO_VAL(EOK, fibril_errno);
+	PCUT_ASSERT_INT_EQUALS(1, destroyed);
+
+	PCUT_ASSERT_EQUALS(&values[0], fibril_key_get(test_key));
+	PCUT_ASSERT_ERRNO_VAL(EOK, errno);
+
+	fibril_key_set(test_key, NULL);
+	fibril_key_delete(test_key);
+}
+
+/** A deleted key is reused with a NULL value. */
+PCUT_TEST(reuse)
+{
+	fibril_key_t key1;
+	fibril_key_t key2;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, fibril_key_create(&key1, NULL));
+	fibril_key_set(key1, &values[0]);
+	fibril_key_delete(key1);
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, fibril_key_create(&key2, NULL));
+	PCUT_ASSERT_INT_EQUALS(key1, key2);
+	PCUT_ASSERT_NULL(fibril_key_get(key2));
+	fibril_key_delete(key2);
+}
+
+PCUT_EXPORT(fibril_key);
@@ -27,8 +27,10 @@
  */
 
 #include <async.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <pcut/pcut.h>
+#include <time.h>
 
 PCUT_INIT;
 
@@ -138,4 +140,29 @@ PCUT_TEST(fire)
 	fibril_timer_destroy(t);
 }
 
+/** Sleeping with timer slack still sleeps at least as requested */
+PCUT_TEST(sleep_slack)
+{
+	fibril_timeout_stats_t before, after;
+	struct timespec start, end;
+	nsec_t slack = MSEC2NSEC(20);
+
+	fibril_get_timeout_stats(&before);
+	fibril_set_timer_slack(NSEC2USEC(slack));
+	PCUT_ASSERT_INT_EQUALS(NSEC2USEC(slack), fibril_get_timer_slack());
+
+	getuptime(&start);
+	fibril_usleep(1000);
+	getuptime(&end);
+
+	fibril_set_timer_slack(0);
+	fibril_get_timeout_stats(&after);
+
+	PCUT_ASSERT_TRUE(ts_sub_diff(&end, &start) >= MSEC2NSEC(1));
+
+	PCUT_ASSERT_TRUE(after.armed > before.armed);
+	PCUT_ASSERT_TRUE(after.expired > before.expired);
+	PCUT_ASSERT_TRUE(after.wakeups > before.wakeups);
+}
+
 PCUT_EXPORT(fibril_timer);
@@ -105,4 +105,41 @@ PCUT_TEST(gsort_desc)
 	}
 }
 
+typedef struct {
+	int key;
+	int idx;
+} pair_t;
+
+static int cmp_pair(void *a, void *b, void *param)
+{
+	pair_t *pa = (pair_t *)a;
+	pair_t *pb = (pair_t *)b;
+
+	if (pa->key == pb->key)
+		return 0;
+
+	return pa->key < pb->key ? -1 : 1;
+}
+
+/* sort long sequence with many equal keys, order of equal keys is kept */
+PCUT_TEST(gsort_stable)
+{
+	int size = 1000;
+	pair_t data[size];
+
+	for (int i = 0; i < size; i++) {
+		data[i].key = (i * 7919) % 13;
+		data[i].idx = i;
+	}
+
+	bool ret = gsort(data, size, sizeof(pair_t), cmp_pair, NULL);
+	PCUT_ASSERT_TRUE(ret);
+
+	for (int i = 1; i < size; i++) {
+		PCUT_ASSERT_TRUE(data[i - 1].key <= data[i].key);
+		if (data[i - 1].key == data[i].key)
+			PCUT_ASSERT_TRUE(data[i - 1].idx < data[i].idx);
+	}
+}
+
 PCUT_EXPORT(gsort);
@@ -31,13 +31,19 @@
 
 PCUT_INIT;
 
+PCUT_IMPORT(bdict);
 PCUT_IMPORT(cap);
 PCUT_IMPORT(casting);
+PCUT_IMPORT(channel);
+PCUT_IMPORT(checksum);
 PCUT_IMPORT(circ_buf);
 PCUT_IMPORT(double_to_str);
+PCUT_IMPORT(fibril_drwlock);
+PCUT_IMPORT(fibril_key);
 PCUT_IMPORT(fibril_timer);
 PCUT_IMPORT(getopt);
 PCUT_IMPORT(gsort);
+PCUT_IMPORT(hash_table);
 PCUT_IMPORT(ieee_double);
 PCUT_IMPORT(imath);
 PCUT_IMPORT(inttypes);
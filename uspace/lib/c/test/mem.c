@@ -98,6 +98,28 @@ PCUT_TEST(memchr)
 	PCUT_ASSERT_TRUE(p == NULL);
 }
 
+/** memchr function on an area spanning several words */
+PCUT_TEST(memchr_long)
+{
+	char buf[64];
+	size_t i, j;
+
+	for (i = 0; i < sizeof(buf); i++) {
+		memset(buf, 'a', sizeof(buf));
+		buf[i] = 'b';
+
+		for (j = 0; j < 8; j++) {
+			if (j <= i)
+				PCUT_ASSERT_TRUE(memchr(buf + j, 'b',
+				    sizeof(buf) - j) == buf + i);
+			PCUT_ASSERT_TRUE(memchr(buf + j, 'c',
+			    sizeof(buf) - j) == NULL);
+		}
+
+		PCUT_ASSERT_TRUE(memchr(buf, 'b', i) == NULL);
+	}
+}
+
 /** memset function */
 PCUT_TEST(memset)
 {
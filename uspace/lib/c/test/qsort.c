@@ -28,12 +28,15 @@
 
 #include <pcut/pcut.h>
 #include <qsort.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 enum {
 	/** Length of test number sequences */
-	test_seq_len = 5
+	test_seq_len = 5,
+	/** Length of long test number sequences */
+	test_long_len = 5000
 };
 
 /** Test compare function.
@@ -50,6 +53,12 @@ static int test_cmp(const void *a, const void *b)
 	return *ia - *ib;
 }
 
+/** Test compare function comparing the first byte. */
+static int test_cmp_char(const void *a, const void *b)
+{
+	return *(const char *)a - *(const char *)b;
+}
+
 static void bubble_sort(int *seq, size_t nmemb)
 {
 	size_t i;
@@ -171,4 +180,138 @@ PCUT_TEST(pseudorandom_seq)
 	free(seq2);
 }
 
+/** Comparison function for qsort_r() and qsort_parallel(). */
+static int test_cmp_r(const void *a, const void *b, void *arg)
+{
+	int *ia = (int *)a;
+	int *ib = (int *)b;
+
+	if (arg != NULL)
+		(*(size_t *)arg)++;
+	return *ia - *ib;
+}
+
+/** Fill sequence with a pattern.
+ *
+ * @param seq Sequence
+ * @param nmemb Number of members
+ * @param pattern Pattern number
+ */
+static void fill_pattern(int *seq, int nmemb, int pattern)
+{
+	int i;
+	int v = 1;
+
+	for (i = 0; i < nmemb; i++) {
+		switch (pattern) {
+		case 0:
+			/* Increasing */
+			seq[i] = i;
+			break;
+		case 1:
+			/* Decreasing */
+			seq[i] = nmemb - i;
+			break;
+		case 2:
+			/* Organ pipe */
+			seq[i] = i < nmemb / 2 ? i : nmemb - i;
+			break;
+		case 3:
+			/* Few distinct values */
+			seq[i] = v % 4;
+			v = seq_next(v);
+			break;
+		default:
+			/* Pseudorandom */
+			seq[i] = v;
+			v = seq_next(v);
+			break;
+		}
+	}
+}
+
+/** Verify that a sequence is non-decreasing. */
+static bool is_sorted(int *seq, int nmemb)
+{
+	int i;
+
+	for (i = 1; i < nmemb; i++) {
+		if (seq[i - 1] > seq[i])
+			return false;
+	}
+
+	return true;
+}
+
+/** Test sorting long sequences with patterns that are hard for quicksort. */
+PCUT_TEST(long_patterns)
+{
+	int *seq;
+	int pattern;
+	size_t ncmp;
+
+	seq = calloc(test_long_len, sizeof(int));
+	PCUT_ASSERT_NOT_NULL(seq);
+
+	for (pattern = 0; pattern < 5; pattern++) {
+		fill_pattern(seq, test_long_len, pattern);
+		ncmp = 0;
+		qsort_r(seq, test_long_len, sizeof(int), test_cmp_r, &ncmp);
+		PCUT_ASSERT_TRUE(is_sorted(seq, test_long_len));
+
+		/* Well below quadratic */
+		PCUT_ASSERT_TRUE(ncmp < 40 * test_long_len);
+	}
+
+	free(seq);
+}
+
+/** Test sorting with members that do not allow word-sized swaps. */
+PCUT_TEST(odd_size)
+{
+	char (*seq)[3];
+	int i;
+	int v;
+
+	seq = calloc(test_long_len, 3);
+	PCUT_ASSERT_NOT_NULL(seq);
+
+	v = 1;
+	for (i = 0; i < test_long_len; i++) {
+		seq[i][0] = v % 64;
+		seq[i][1] = v % 7;
+		seq[i][2] = seq[i][0] ^ seq[i][1];
+		v = seq_next(v);
+	}
+
+	qsort(seq, test_long_len, 3, test_cmp_char);
+
+	for (i = 0; i < test_long_len; i++) {
+		PCUT_ASSERT_INT_EQUALS(seq[i][0] ^ seq[i][1], seq[i][2]);
+		if (i > 0)
+			PCUT_ASSERT_TRUE(seq[i - 1][0] <= seq[i][0]);
+	}
+
+	free(seq);
+}
+
+/** Test parallel quicksort. */
+PCUT_TEST(parallel)
+{
+	int *seq;
+	int pattern;
+	int len = 100000;
+
+	seq = calloc(len, sizeof(int));
+	PCUT_ASSERT_NOT_NULL(seq);
+
+	for (pattern = 0; pattern < 5; pattern++) {
+		fill_pattern(seq, len, pattern);
+		qsort_parallel(seq, len, sizeof(int), test_cmp_r, NULL);
+		PCUT_ASSERT_TRUE(is_sorted(seq, len));
+	}
+
+	free(seq);
+}
+
 PCUT_EXPORT(qsort);
@@ -82,4 +82,28 @@ SPRINTF_TEST(int_as_hex, "[0x11] [0x012] [0x013] [0x00014] [0x00015]",
     "[%#x] [%#5.3x] [%#-5.3x] [%#3.5x] [%#-3.5x]",
     17, 18, 19, 20, 21);
 
+SPRINTF_TEST(int_decimal_digits, "[0] [7] [42] [-100] [4294967296] [18446744073709551615]",
+    "[%d] [%u] [%d] [%d] [%llu] [%llu]",
+    0, 7u, 42, -100, 4294967296ULL, 18446744073709551615ULL);
+
+SPRINTF_TEST(int_min, "[-2147483648] [-9223372036854775808]",
+    "[%d] [%lld]", -2147483647 - 1, -9223372036854775807LL - 1);
+
+SPRINTF_TEST(int_other_bases, "[deadbeef] [DEADBEEF] [777] [101]",
+    "[%x] [%X] [%o] [%b]", 0xdeadbeef, 0xdeadbeef, 0777, 5);
+
+SPRINTF_TEST(int_wide_padding,
+    "[                                                                      "
+    "                                                                   -12]",
+    "[%140d]", -12);
+
+SPRINTF_TEST(double_fixed, "[3.141593] [  -2.50] [-2.50  ] [0002.50]",
+    "[%f] [%7.2f] [%-7.2f] [%07.2f]", 3.14159265, -2.5, -2.5, 2.5);
+
+SPRINTF_TEST(double_scientific, "[1.500000e+10] [-1.5E-05] [  1.0e+100]",
+    "[%e] [%.1E] [%10.1e]", 1.5e10, -1.5e-5, 1e100);
+
+SPRINTF_TEST(double_generic, "[0.1] [1e+20] [123.5]",
+    "[%g] [%g] [%.4g]", 0.1, 1e20, 123.456);
+
 PCUT_EXPORT(sprintf);
@@ -203,6 +203,73 @@ PCUT_TEST(fgetpos_setpos)
 	(void) fclose(f);
 }
 
+/** Sequential and random access with read ahead and write behind */
+PCUT_TEST(fadvise_readback)
+{
+	char buf[BUFSIZ / 2];
+	size_t nblocks = 8 * BUFSIZ / sizeof(buf);
+	size_t i, j;
+	size_t n;
+	int rc;
+	FILE *f;
+
+	f = tmpfile();
+	PCUT_ASSERT_NOT_NULL(f);
+
+	for (i = 0; i < nblocks; i++) {
+		for (j = 0; j < sizeof(buf); j++)
+			buf[j] = (char) (i + j);
+		n = fwrite(buf, 1, sizeof(buf), f);
+		PCUT_ASSERT_INT_EQUALS(sizeof(buf), n);
+	}
+
+	rc = fseek(f, 0, SEEK_END);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+	PCUT_ASSERT_INT_EQUALS(nblocks * sizeof(buf), ftell(f));
+
+	rewind(f);
+	rc = fadvise(f, FADV_SEQUENTIAL);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+
+	for (i = 0; i < nblocks; i++) {
+		n = fread(buf, 1, sizeof(buf), f);
+		PCUT_ASSERT_INT_EQUALS(sizeof(buf), n);
+		for (j = 0; j < sizeof(buf); j++)
+			PCUT_ASSERT_INT_EQUALS((char) (i + j), buf[j]);
+	}
+
+	n = fread(buf, 1, sizeof(buf), f);
+	PCUT_ASSERT_INT_EQUALS(0, n);
+	PCUT_ASSERT_TRUE(feof(f));
+
+	/* Seek back while data is being read ahead */
+	rc = fseek(f, 3 * sizeof(buf), SEEK_SET);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+	rc = fadvise(f, FADV_WILLNEED);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+	rc = fseek(f, sizeof(buf), SEEK_SET);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+
+	n = fread(buf, 1, sizeof(buf), f);
+	PCUT_ASSERT_INT_EQUALS(sizeof(buf), n);
+	for (j = 0; j < sizeof(buf); j++)
+		PCUT_ASSERT_INT_EQUALS((char) (1 + j), buf[j]);
+
+	/* Overwrite data that has been read ahead */
+	rc = fputc('x', f);
+	PCUT_ASSERT_INT_EQUALS('x', rc);
+	rc = fseek(f, -1, SEEK_CUR);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+	PCUT_ASSERT_INT_EQUALS('x', fgetc(f));
+
+	rc = fadvise(f, FADV_DONTNEED + 1);
+	PCUT_ASSERT_INT_EQUALS(EOF, rc);
+	PCUT_ASSERT_ERRNO(EINVAL);
+
+	rc = fclose(f);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+}
+
 /** perror function with NULL as argument */
 PCUT_TEST(perror_null_msg)
 {
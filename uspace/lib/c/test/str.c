@@ -114,4 +114,48 @@ PCUT_TEST(str_str_empty_n)
 	PCUT_ASSERT_TRUE((const char *)p == hs);
 }
 
+PCUT_TEST(str_size_long)
+{
+	const char *s = "/usr/share/doc/\xc3\xa9l\xc3\xa8ve/readme.txt";
+
+	PCUT_ASSERT_INT_EQUALS(33, str_size(s));
+	PCUT_ASSERT_INT_EQUALS(31, str_length(s));
+	PCUT_ASSERT_INT_EQUALS(17, str_nlength(s, 18));
+	PCUT_ASSERT_INT_EQUALS(10, str_nsize(s, 10));
+}
+
+PCUT_TEST(str_cmp_mixed)
+{
+	PCUT_ASSERT_INT_EQUALS(0, str_cmp("/usr/local/bin/\xc3\xa9", "/usr/local/bin/\xc3\xa9"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("/usr/local/bin/a", "/usr/local/bin/\xc3\xa9"));
+	PCUT_ASSERT_INT_EQUALS(1, str_cmp("/usr/local/bin/\xe2\x82\xac", "/usr/local/bin/\xc3\xa9"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("/usr/local/bin", "/usr/local/bin/"));
+	PCUT_ASSERT_INT_EQUALS(0, str_lcmp("/usr/local/bin", "/usr/local/lib", 11));
+	PCUT_ASSERT_INT_EQUALS(-1, str_lcmp("/usr/local/bin", "/usr/local/lib", 12));
+	PCUT_ASSERT_TRUE(str_test_prefix("/usr/local/bin", "/usr/local/"));
+	PCUT_ASSERT_FALSE(str_test_prefix("/usr/local", "/usr/local/"));
+}
+
+PCUT_TEST(str_chr_mixed)
+{
+	const char *s = "/data/\xc3\xa9t\xc3\xa9/report.txt";
+
+	PCUT_ASSERT_TRUE(str_chr(s, '/') == s);
+	PCUT_ASSERT_TRUE(str_chr(s, 'r') == s + 12);
+	PCUT_ASSERT_TRUE(str_chr(s, 0xe9) == s + 6);
+	PCUT_ASSERT_TRUE(str_chr(s, 'q') == NULL);
+	PCUT_ASSERT_TRUE(str_rchr(s, '/') == s + 11);
+	PCUT_ASSERT_TRUE(str_rchr(s, 0xe9) == s + 9);
+}
+
+PCUT_TEST(str_chr_invalid)
+{
+	/* Broken lead byte swallows the following character */
+	const char *s = "abc\xc3/def";
+
+	PCUT_ASSERT_TRUE(str_chr(s, '/') == NULL);
+	PCUT_ASSERT_TRUE(str_chr(s, 'd') == s + 5);
+	PCUT_ASSERT_INT_EQUALS(7, str_length(s));
+}
+
 PCUT_EXPORT(str);
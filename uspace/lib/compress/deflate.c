@@ -0,0 +1,1639 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief Implementation of deflate compression
+ *
+ * Streaming deflate implementation (compression to `deflate' stream as
+ * described by RFC 1951) following the design of zlib by Jean-loup Gailly
+ * and Mark Adler.
+ *
+ * Matches are searched for in a sliding window of the recent input using
+ * hash chains of the positions of three-byte strings. Except for the
+ * fastest levels, a match is only taken if the match starting at the next
+ * byte is not longer (lazy matching). The symbols are collected in a
+ * buffer and each block is emitted with Huffman codes built for it, with
+ * the fixed codes or stored, whichever is the shortest.
+ *
+ * The blocks are written to a pending buffer, which is flushed to the
+ * output buffer of the caller.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <mem.h>
+#include <macros.h>
+#include <bitops.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include "deflate.h"
+
+/** Maximum bits in the Huffman code */
+#define MAX_HUFFMAN_BIT  15
+/** Maximum bits in the code length code */
+#define MAX_CLEN_BIT     7
+
+/** Number of length codes */
+#define MAX_LEN           29
+/** Number of distance codes */
+#define MAX_DIST          30
+/** Number of order codes */
+#define MAX_ORDER         19
+/** Number of literal/length codes */
+#define MAX_LITLEN        286
+/** Number of fixed literal/length codes */
+#define MAX_FIXED_LITLEN  288
+
+/** End of block symbol */
+#define END_OF_BLOCK  256
+
+/** Shortest and longest match */
+#define MIN_MATCH  3
+#define MAX_MATCH  258
+
+/** Size of the window the matches may reach into */
+#define WINDOW_SIZE  32768
+#define WINDOW_MASK  (WINDOW_SIZE - 1)
+
+/** Lookahead needed to find the longest match at any position */
+#define MIN_LOOKAHEAD  (MAX_MATCH + MIN_MATCH + 1)
+
+/** Longest match distance keeping the lookahead in the window buffer */
+#define MAX_WINDOW_DIST  (WINDOW_SIZE - MIN_LOOKAHEAD)
+
+/** Bytes the string comparison may read past the window buffer */
+#define COMPARE_SLACK  (MAX_MATCH + 8)
+
+/** Matches of minimal length further away than this are not worth it */
+#define TOO_FAR  4096
+
+/** Hash of three-byte strings */
+#define HASH_BITS  15
+#define HASH_SIZE  (1 << HASH_BITS)
+
+/** Empty hash chain */
+#define NIL  0
+
+/** Number of symbols in a block */
+#define SYMBOL_BUFFER_SIZE  16384
+
+/*
+ * A block never takes more than in fixed codes, which is at most 31 bits
+ * per symbol. There is also room for a sync marker.
+ */
+#define PENDING_SIZE  (SYMBOL_BUFFER_SIZE * 4 + 64)
+
+/** Longest stored block */
+#define MAX_STORED  65535
+
+/** Size of the chunks compressed in parallel */
+#define PARALLEL_CHUNK_SIZE  (128 * 1024)
+
+/** Match finding parameters of a compression level */
+typedef struct {
+	/** Search only a quarter of the chain from this match length on */
+	uint16_t good_length;
+	/**
+	 * Do not look for a lazy match from this match length on. With
+	 * greedy matching, longer matches are not hashed.
+	 */
+	uint16_t max_lazy;
+	/** Stop searching at this match length */
+	uint16_t nice_length;
+	/** Maximum number of chain entries searched */
+	uint16_t max_chain;
+	/** Lazy matching */
+	bool lazy;
+} deflate_config_t;
+
+/** Parameters of the compression levels (as used by zlib) */
+static const deflate_config_t deflate_config[] = {
+	{ 0, 0, 0, 0, false },
+	{ 4, 4, 8, 4, false },
+	{ 4, 5, 16, 8, false },
+	{ 4, 6, 32, 32, false },
+	{ 4, 4, 16, 16, true },
+	{ 8, 16, 32, 32, true },
+	{ 8, 16, 128, 128, true },
+	{ 8, 32, 128, 256, true },
+	{ 32, 128, 258, 1024, true },
+	{ 32, 258, 258, 4096, true }
+};
+
+/** Outcome of compressing for a while */
+typedef enum {
+	BLOCK_NEED_INPUT,  /**< All input consumed */
+	BLOCK_DONE,        /**< A block was emitted */
+	BLOCK_FLUSHED      /**< All input emitted as requested */
+} block_state_t;
+
+/** Huffman code */
+typedef struct {
+	uint16_t code[MAX_FIXED_LITLEN];   /**< Bit-reversed codes */
+	uint8_t length[MAX_FIXED_LITLEN];  /**< Code lengths */
+} huffman_code_t;
+
+/** Internal state of the deflate stream */
+struct deflate_state {
+	const deflate_config_t *config;  /**< Compression parameters */
+	bool store;                      /**< Level 0 (store only) */
+	bool flushed;                    /**< No input since the last flush */
+	bool finished;                   /**< Last block emitted */
+
+	size_t strstart;       /**< Current position in the window */
+	size_t lookahead;      /**< Valid bytes from the current position */
+	ptrdiff_t block_start; /**< Start of the block (negative if lost) */
+
+	uint16_t head[HASH_SIZE];    /**< Latest position of each hash */
+	uint16_t prev[WINDOW_SIZE];  /**< Previous position of the same hash */
+
+	size_t match_length;   /**< Length of the current match */
+	size_t match_start;    /**< Start of the current match */
+	size_t prev_length;    /**< Length of the previous match */
+	size_t prev_match;     /**< Start of the previous match */
+	bool match_available;  /**< Previous byte not emitted yet */
+
+	uint16_t sym_dist[SYMBOL_BUFFER_SIZE];  /**< Distances (0 if literal) */
+	uint8_t sym_lc[SYMBOL_BUFFER_SIZE];     /**< Literals or lengths - 3 */
+	size_t sym_count;                       /**< Symbols in the block */
+
+	uint32_t lit_freq[MAX_LITLEN];  /**< Literal/length frequencies */
+	uint32_t dist_freq[MAX_DIST];   /**< Distance frequencies */
+
+	huffman_code_t fixed_lit;   /**< Fixed literal/length code */
+	huffman_code_t fixed_dist;  /**< Fixed distance code */
+
+	uint64_t bitbuf;       /**< Bits not written out yet */
+	unsigned int bitlen;   /**< Number of bits in the bit buffer */
+
+	size_t pending_len;    /**< Bytes in the pending buffer */
+	size_t pending_pos;    /**< Bytes already flushed */
+	uint8_t pending[PENDING_SIZE];
+
+	/** Window of the recent input and the lookahead */
+	uint8_t window[2 * WINDOW_SIZE + COMPARE_SLACK];
+};
+
+/** Table of code length codes */
+static const uint8_t order[MAX_ORDER] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+/** Size base for length codes 257..285 */
+static const uint16_t lens[MAX_LEN] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+/** Extra bits for length codes 257..285 */
+static const uint8_t lens_ext[MAX_LEN] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+/** Offset base for distance codes 0..29 */
+static const uint16_t dists[MAX_DIST] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+
+/** Extra bits for distance codes 0..29 */
+static const uint8_t dists_ext[MAX_DIST] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/** Length code of a match
+ *
+ * @param lc Length of the match minus MIN_MATCH.
+ *
+ * @return Index of the length code.
+ *
+ */
+static inline unsigned int length_code(unsigned int lc)
+{
+	if (lc < 8)
+		return lc;
+
+	if (lc == MAX_MATCH - MIN_MATCH)
+		return MAX_LEN - 1;
+
+	/* Four codes for each number of extra bits */
+	unsigned int bits = fnzb32(lc);
+	return 4 * (bits - 1) + ((lc >> (bits - 2)) & 3);
+}
+
+/** Distance code of a match
+ *
+ * @param dist Distance of the match minus one.
+ *
+ * @return Index of the distance code.
+ *
+ */
+static inline unsigned int dist_code(unsigned int dist)
+{
+	if (dist < 4)
+		return dist;
+
+	/* Two codes for each number of extra bits */
+	unsigned int bits = fnzb32(dist);
+	return 2 * bits + ((dist >> (bits - 1)) & 1);
+}
+
+/** Append bits to the pending buffer
+ *
+ * @param state Deflate state.
+ * @param val   Bits to append (least significant first).
+ * @param cnt   Number of bits (at most 32).
+ *
+ */
+static inline void put_bits(struct deflate_state *state, uint32_t val,
+    unsigned int cnt)
+{
+	state->bitbuf |= (uint64_t) val << state->bitlen;
+	state->bitlen += cnt;
+
+	if (state->bitlen >= 32) {
+		uint8_t *dest = state->pending + state->pending_len;
+
+		dest[0] = state->bitbuf;
+		dest[1] = state->bitbuf >> 8;
+		dest[2] = state->bitbuf >> 16;
+		dest[3] = state->bitbuf >> 24;
+
+		state->pending_len += 4;
+		state->bitbuf >>= 32;
+		state->bitlen -= 32;
+	}
+}
+
+/** Pad the bits in the pending buffer to a byte boundary
+ *
+ * @param state Deflate state.
+ *
+ */
+static void put_align(struct deflate_state *state)
+{
+	while (state->bitlen > 0) {
+		state->pending[state->pending_len++] = state->bitbuf;
+		state->bitbuf >>= 8;
+		state->bitlen = (state->bitlen > 8) ? state->bitlen - 8 : 0;
+	}
+
+	state->bitbuf = 0;
+}
+
+/** Append a 16-bit little-endian value to the aligned pending buffer
+ *
+ * @param state Deflate state.
+ * @param val   Value to append.
+ *
+ */
+static void put_short(struct deflate_state *state, uint16_t val)
+{
+	state->pending[state->pending_len++] = val;
+	state->pending[state->pending_len++] = val >> 8;
+}
+
+/** Flush the pending buffer to the output buffer
+ *
+ * @param state Deflate state.
+ * @param strm  Deflate stream.
+ *
+ */
+static void pending_flush(struct deflate_state *state, deflate_stream_t *strm)
+{
+	size_t cnt = min(state->pending_len - state->pending_pos,
+	    strm->avail_out);
+
+	memcpy(strm->next_out, state->pending + state->pending_pos, cnt);
+	strm->next_out += cnt;
+	strm->avail_out -= cnt;
+	strm->total_out += cnt;
+
+	state->pending_pos += cnt;
+	if (state->pending_pos == state->pending_len) {
+		state->pending_pos = 0;
+		state->pending_len = 0;
+	}
+}
+
+/** Compute the lengths of a length-limited Huffman code
+ *
+ * If the Huffman code is too long, the frequencies are flattened until it
+ * fits the limit.
+ *
+ * @param[in]  freq   Symbol frequencies, at least two of them non-zero.
+ * @param[in]  n      Number of symbols.
+ * @param[in]  limit  Maximum code length.
+ * @param[out] length Code lengths.
+ *
+ */
+static void huffman_lengths(const uint32_t *freq, size_t n,
+    unsigned int limit, uint8_t *length)
+{
+	uint16_t sym[MAX_FIXED_LITLEN];
+	uint32_t weight[2 * MAX_FIXED_LITLEN];
+	uint16_t parent[2 * MAX_FIXED_LITLEN];
+	uint8_t depth[2 * MAX_FIXED_LITLEN];
+	size_t used = 0;
+
+	/* Sort the used symbols by frequency */
+	for (size_t i = 0; i < n; i++) {
+		length[i] = 0;
+		if (freq[i] == 0)
+			continue;
+
+		size_t j = used++;
+		while ((j > 0) && (weight[j - 1] > freq[i])) {
+			sym[j] = sym[j - 1];
+			weight[j] = weight[j - 1];
+			j--;
+		}
+
+		sym[j] = i;
+		weight[j] = freq[i];
+	}
+
+	while (true) {
+		/*
+		 * Merge the two lightest nodes until there is one left. The
+		 * leaves and the merged nodes are both ordered by weight.
+		 */
+		size_t leaf = 0;
+		size_t node = used;
+		size_t next = used;
+
+		while (next < 2 * used - 1) {
+			for (unsigned int k = 0; k < 2; k++) {
+				size_t child;
+
+				if ((leaf < used) && ((node == next) ||
+				    (weight[leaf] <= weight[node])))
+					child = leaf++;
+				else
+					child = node++;
+
+				parent[child] = next;
+				weight[next] = (k == 0) ? weight[child] :
+				    weight[next] + weight[child];
+			}
+
+			next++;
+		}
+
+		depth[next - 1] = 0;
+		for (size_t i = next - 1; i-- > 0;)
+			depth[i] = depth[parent[i]] + 1;
+
+		unsigned int max_depth = 0;
+		for (size_t i = 0; i < used; i++)
+			max_depth = max(max_depth, depth[i]);
+
+		if (max_depth <= limit)
+			break;
+
+		/* Flattening keeps the order of the leaves */
+		for (size_t i = 0; i < used; i++)
+			weight[i] = (weight[i] >> 1) | 1;
+	}
+
+	for (size_t i = 0; i < used; i++)
+		length[sym[i]] = depth[i];
+}
+
+/** Assign canonical codes to code lengths
+ *
+ * @param huffman Huffman code with the code lengths set.
+ * @param n       Number of symbols.
+ *
+ */
+static void huffman_codes(huffman_code_t *huffman, size_t n)
+{
+	uint16_t count[MAX_HUFFMAN_BIT + 1];
+	uint16_t next[MAX_HUFFMAN_BIT + 1];
+
+	memset(count, 0, sizeof(count));
+	for (size_t i = 0; i < n; i++)
+		count[huffman->length[i]]++;
+
+	count[0] = 0;
+
+	uint16_t code = 0;
+	for (unsigned int len = 1; len <= MAX_HUFFMAN_BIT; len++) {
+		code = (code + count[len - 1]) << 1;
+		next[len] = code;
+	}
+
+	/* The codes are sent starting with the most significant bit */
+	for (size_t i = 0; i < n; i++) {
+		unsigned int len = huffman->length[i];
+		if (len == 0)
+			continue;
+
+		uint16_t val = next[len]++;
+		uint16_t rev = 0;
+
+		for (unsigned int bit = 0; bit < len; bit++) {
+			rev = (rev << 1) | (val & 1);
+			val >>= 1;
+		}
+
+		huffman->code[i] = rev;
+	}
+}
+
+/** Build a Huffman code for symbol frequencies
+ *
+ * At least two symbols are always assigned a code, so that the code is
+ * complete.
+ *
+ * @param huffman Huffman code to build.
+ * @param freq    Symbol frequencies.
+ * @param n       Number of symbols.
+ * @param limit   Maximum code length.
+ *
+ */
+static void huffman_build(huffman_code_t *huffman, const uint32_t *freq,
+    size_t n, unsigned int limit)
+{
+	uint32_t weight[MAX_FIXED_LITLEN];
+	size_t used = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		weight[i] = freq[i];
+		if (freq[i] != 0)
+			used++;
+	}
+
+	for (size_t i = 0; used < 2; i++) {
+		if (weight[i] == 0) {
+			weight[i] = 1;
+			used++;
+		}
+	}
+
+	huffman_lengths(weight, n, limit, huffman->length);
+	huffman_codes(huffman, n);
+}
+
+/** Set up the fixed Huffman codes
+ *
+ * @param state Deflate state.
+ *
+ */
+static void huffman_fixed(struct deflate_state *state)
+{
+	size_t sym;
+
+	for (sym = 0; sym < 144; sym++)
+		state->fixed_lit.length[sym] = 8;
+
+	for (; sym < 256; sym++)
+		state->fixed_lit.length[sym] = 9;
+
+	for (; sym < 280; sym++)
+		state->fixed_lit.length[sym] = 7;
+
+	for (; sym < MAX_FIXED_LITLEN; sym++)
+		state->fixed_lit.length[sym] = 8;
+
+	for (sym = 0; sym < MAX_DIST; sym++)
+		state->fixed_dist.length[sym] = 5;
+
+	huffman_codes(&state->fixed_lit, MAX_FIXED_LITLEN);
+	huffman_codes(&state->fixed_dist, MAX_DIST);
+}
+
+/** Run-length encode code lengths
+ *
+ * @param[in]  length Code lengths.
+ * @param[in]  n      Number of code lengths.
+ * @param[out] sym    Code length symbols.
+ * @param[out] extra  Extra bits of the symbols.
+ * @param[out] freq   Frequencies of the code length symbols (added to).
+ *
+ * @return Number of code length symbols.
+ *
+ */
+static size_t clen_encode(const uint8_t *length, size_t n, uint8_t *sym,
+    uint8_t *extra, uint32_t *freq)
+{
+	size_t cnt = 0;
+	size_t i = 0;
+
+	while (i < n) {
+		uint8_t len = length[i];
+		size_t run = 1;
+
+		while ((i + run < n) && (length[i + run] == len))
+			run++;
+
+		i += run;
+
+		if (len == 0) {
+			/* Runs of zeros (codes 17 and 18) */
+			while (run >= 3) {
+				size_t rep = min(run, (size_t) 138);
+
+				sym[cnt] = (rep >= 11) ? 18 : 17;
+				extra[cnt] = (rep >= 11) ? rep - 11 : rep - 3;
+				freq[sym[cnt]]++;
+				cnt++;
+				run -= rep;
+			}
+		} else if (run >= 4) {
+			/* Repeats of the previous length (code 16) */
+			sym[cnt] = len;
+			freq[len]++;
+			cnt++;
+			run--;
+
+			while (run >= 3) {
+				size_t rep = min(run, (size_t) 6);
+
+				sym[cnt] = 16;
+				extra[cnt] = rep - 3;
+				freq[16]++;
+				cnt++;
+				run -= rep;
+			}
+		}
+
+		while (run > 0) {
+			sym[cnt] = len;
+			freq[len]++;
+			cnt++;
+			run--;
+		}
+	}
+
+	return cnt;
+}
+
+/** Number of extra bits of a code length symbol */
+static inline unsigned int clen_extra_bits(uint8_t sym)
+{
+	switch (sym) {
+	case 16:
+		return 2;
+	case 17:
+		return 3;
+	case 18:
+		return 7;
+	default:
+		return 0;
+	}
+}
+
+/** Size of the symbols of the block in given codes
+ *
+ * @param state Deflate state.
+ * @param lit   Literal/length code.
+ * @param dist  Distance code.
+ *
+ * @return Size of the symbols including the end of block (bits).
+ *
+ */
+static size_t block_bits(struct deflate_state *state,
+    const huffman_code_t *lit, const huffman_code_t *dist)
+{
+	size_t bits = 0;
+
+	for (size_t i = 0; i < END_OF_BLOCK; i++)
+		bits += state->lit_freq[i] * lit->length[i];
+
+	for (size_t i = END_OF_BLOCK; i < MAX_LITLEN; i++) {
+		unsigned int ext = (i > END_OF_BLOCK) ?
+		    lens_ext[i - END_OF_BLOCK - 1] : 0;
+
+		bits += state->lit_freq[i] * (lit->length[i] + ext);
+	}
+
+	for (size_t i = 0; i < MAX_DIST; i++)
+		bits += state->dist_freq[i] * (dist->length[i] + dists_ext[i]);
+
+	return bits;
+}
+
+/** Emit the symbols of the block
+ *
+ * @param state Deflate state.
+ * @param lit   Literal/length code.
+ * @param dist  Distance code.
+ *
+ */
+static void block_codes(struct deflate_state *state,
+    const huffman_code_t *lit, const huffman_code_t *dist)
+{
+	for (size_t i = 0; i < state->sym_count; i++) {
+		unsigned int lc = state->sym_lc[i];
+		unsigned int distance = state->sym_dist[i];
+
+		if (distance == 0) {
+			put_bits(state, lit->code[lc], lit->length[lc]);
+			continue;
+		}
+
+		unsigned int code = length_code(lc);
+		unsigned int sym = END_OF_BLOCK + 1 + code;
+
+		put_bits(state, lit->code[sym], lit->length[sym]);
+		if (lens_ext[code] > 0)
+			put_bits(state, lc + MIN_MATCH - lens[code],
+			    lens_ext[code]);
+
+		code = dist_code(distance - 1);
+		put_bits(state, dist->code[code], dist->length[code]);
+		if (dists_ext[code] > 0)
+			put_bits(state, distance - dists[code],
+			    dists_ext[code]);
+	}
+
+	put_bits(state, lit->code[END_OF_BLOCK], lit->length[END_OF_BLOCK]);
+}
+
+/** Emit stored blocks
+ *
+ * @param state Deflate state.
+ * @param data  Data of the blocks.
+ * @param len   Size of the data (bytes).
+ * @param last  Whether the last block ends the deflate stream.
+ *
+ */
+static void block_stored(struct deflate_state *state, const uint8_t *data,
+    size_t len, bool last)
+{
+	do {
+		size_t piece = min(len, (size_t) MAX_STORED);
+		len -= piece;
+
+		put_bits(state, (last && (len == 0)) ? 1 : 0, 3);
+		put_align(state);
+		put_short(state, piece);
+		put_short(state, ~piece);
+
+		memcpy(state->pending + state->pending_len, data, piece);
+		state->pending_len += piece;
+		data += piece;
+	} while (len > 0);
+}
+
+/** Emit the symbols collected as a block
+ *
+ * The block is emitted with dynamic Huffman codes, fixed codes or stored,
+ * whichever is the shortest. Storing is only possible while the data of
+ * the block is in the window.
+ *
+ * @param state Deflate state.
+ * @param end   End of the data of the block in the window.
+ * @param last  Whether the block ends the deflate stream.
+ *
+ */
+static void block_emit(struct deflate_state *state, size_t end, bool last)
+{
+	huffman_code_t lit;
+	huffman_code_t dist;
+	huffman_code_t clen;
+	uint8_t length[MAX_LITLEN + MAX_DIST];
+	uint8_t clen_sym[MAX_LITLEN + MAX_DIST];
+	uint8_t clen_ext[MAX_LITLEN + MAX_DIST];
+	uint32_t clen_freq[MAX_ORDER];
+
+	state->lit_freq[END_OF_BLOCK]++;
+
+	size_t stored_bits = SIZE_MAX;
+	size_t stored_len = 0;
+
+	if (state->block_start >= 0) {
+		/*
+		 * The data of each stored block starts at a byte boundary,
+		 * following the length and its complement.
+		 */
+		stored_len = end - state->block_start;
+		size_t pieces = max((stored_len + MAX_STORED - 1) / MAX_STORED,
+		    (size_t) 1);
+		size_t pad = (8 - ((state->bitlen + 3) & 7)) & 7;
+
+		stored_bits = 3 + pad + 32 + 40 * (pieces - 1) +
+		    8 * stored_len;
+	}
+
+	size_t fixed_bits = SIZE_MAX;
+	size_t dynamic_bits = SIZE_MAX;
+	size_t hlit = 0;
+	size_t hdist = 0;
+	size_t hclen = 0;
+	size_t clen_cnt = 0;
+
+	if ((!state->store) || (stored_bits == SIZE_MAX)) {
+		fixed_bits = 3 + block_bits(state, &state->fixed_lit,
+		    &state->fixed_dist);
+
+		huffman_build(&lit, state->lit_freq, MAX_LITLEN,
+		    MAX_HUFFMAN_BIT);
+		huffman_build(&dist, state->dist_freq, MAX_DIST,
+		    MAX_HUFFMAN_BIT);
+
+		hlit = MAX_LITLEN;
+		while ((hlit > END_OF_BLOCK + 1) && (lit.length[hlit - 1] == 0))
+			hlit--;
+
+		hdist = MAX_DIST;
+		while ((hdist > 1) && (dist.length[hdist - 1] == 0))
+			hdist--;
+
+		memcpy(length, lit.length, hlit);
+		memcpy(length + hlit, dist.length, hdist);
+
+		memset(clen_freq, 0, sizeof(clen_freq));
+		clen_cnt = clen_encode(length, hlit + hdist, clen_sym,
+		    clen_ext, clen_freq);
+		huffman_build(&clen, clen_freq, MAX_ORDER, MAX_CLEN_BIT);
+
+		hclen = MAX_ORDER;
+		while ((hclen > 4) && (clen.length[order[hclen - 1]] == 0))
+			hclen--;
+
+		dynamic_bits = 3 + 5 + 5 + 4 + 3 * hclen;
+		for (size_t i = 0; i < clen_cnt; i++) {
+			dynamic_bits += clen.length[clen_sym[i]] +
+			    clen_extra_bits(clen_sym[i]);
+		}
+
+		dynamic_bits += block_bits(state, &lit, &dist);
+	}
+
+	if ((stored_bits <= fixed_bits) && (stored_bits <= dynamic_bits)) {
+		block_stored(state, state->window + state->block_start,
+		    stored_len, last);
+	} else if (fixed_bits <= dynamic_bits) {
+		put_bits(state, last ? 1 : 0, 1);
+		put_bits(state, 1, 2);
+		block_codes(state, &state->fixed_lit, &state->fixed_dist);
+	} else {
+		put_bits(state, last ? 1 : 0, 1);
+		put_bits(state, 2, 2);
+		put_bits(state, hlit - END_OF_BLOCK - 1, 5);
+		put_bits(state, hdist - 1, 5);
+		put_bits(state, hclen - 4, 4);
+
+		for (size_t i = 0; i < hclen; i++)
+			put_bits(state, clen.length[order[i]], 3);
+
+		for (size_t i = 0; i < clen_cnt; i++) {
+			uint8_t sym = clen_sym[i];
+
+			put_bits(state, clen.code[sym], clen.length[sym]);
+			if (clen_extra_bits(sym) > 0)
+				put_bits(state, clen_ext[i],
+				    clen_extra_bits(sym));
+		}
+
+		block_codes(state, &lit, &dist);
+	}
+
+	if (last) {
+		put_align(state);
+		state->finished = true;
+	}
+
+	memset(state->lit_freq, 0, sizeof(state->lit_freq));
+	memset(state->dist_freq, 0, sizeof(state->dist_freq));
+	state->sym_count = 0;
+	state->block_start = end;
+}
+
+/** Emit an empty stored block aligning the output to a byte boundary
+ *
+ * @param state Deflate state.
+ *
+ */
+static void block_sync(struct deflate_state *state)
+{
+	put_bits(state, 0, 3);
+	put_align(state);
+	put_short(state, 0);
+	put_short(state, 0xffff);
+}
+
+/** Record a literal
+ *
+ * @param state Deflate state.
+ * @param lit   Literal byte.
+ *
+ * @return Whether the block is full.
+ *
+ */
+static inline bool tally_literal(struct deflate_state *state, uint8_t lit)
+{
+	state->sym_dist[state->sym_count] = 0;
+	state->sym_lc[state->sym_count] = lit;
+	state->sym_count++;
+	state->lit_freq[lit]++;
+
+	return (state->sym_count == SYMBOL_BUFFER_SIZE);
+}
+
+/** Record a match
+ *
+ * @param state Deflate state.
+ * @param dist  Distance of the match.
+ * @param lc    Length of the match minus MIN_MATCH.
+ *
+ * @return Whether the block is full.
+ *
+ */
+static inline bool tally_match(struct deflate_state *state, size_t dist,
+    size_t lc)
+{
+	state->sym_dist[state->sym_count] = dist;
+	state->sym_lc[state->sym_count] = lc;
+	state->sym_count++;
+	state->lit_freq[END_OF_BLOCK + 1 + length_code(lc)]++;
+	state->dist_freq[dist_code(dist - 1)]++;
+
+	return (state->sym_count == SYMBOL_BUFFER_SIZE);
+}
+
+/** Insert the string at a position into its hash chain
+ *
+ * @param state Deflate state.
+ * @param pos   Position in the window with at least MIN_MATCH bytes.
+ *
+ * @return Previous position of the same hash or NIL.
+ *
+ */
+static inline uint16_t insert_string(struct deflate_state *state, size_t pos)
+{
+	const uint8_t *str = state->window + pos;
+	uint32_t val = str[0] | (str[1] << 8) | (str[2] << 16);
+	uint32_t hash = (val * UINT32_C(2654435761)) >> (32 - HASH_BITS);
+
+	uint16_t head = state->head[hash];
+	state->prev[pos & WINDOW_MASK] = head;
+	state->head[hash] = pos;
+
+	return head;
+}
+
+/** Slide the window down by WINDOW_SIZE
+ *
+ * @param state Deflate state.
+ *
+ */
+static void window_slide(struct deflate_state *state)
+{
+	memcpy(state->window, state->window + WINDOW_SIZE, WINDOW_SIZE);
+
+	state->match_start = (state->match_start >= WINDOW_SIZE) ?
+	    state->match_start - WINDOW_SIZE : 0;
+	state->strstart -= WINDOW_SIZE;
+	state->block_start -= WINDOW_SIZE;
+
+	for (size_t i = 0; i < HASH_SIZE; i++) {
+		state->head[i] = (state->head[i] >= WINDOW_SIZE) ?
+		    state->head[i] - WINDOW_SIZE : NIL;
+	}
+
+	for (size_t i = 0; i < WINDOW_SIZE; i++) {
+		state->prev[i] = (state->prev[i] >= WINDOW_SIZE) ?
+		    state->prev[i] - WINDOW_SIZE : NIL;
+	}
+}
+
+/** Read input into the window
+ *
+ * Reads until there is enough lookahead or the input runs out.
+ *
+ * @param state Deflate state.
+ * @param strm  Deflate stream.
+ *
+ */
+static void window_fill(struct deflate_state *state, deflate_stream_t *strm)
+{
+	do {
+		if (state->strstart >= WINDOW_SIZE + MAX_WINDOW_DIST)
+			window_slide(state);
+
+		size_t cnt = min(2 * WINDOW_SIZE - state->strstart -
+		    state->lookahead, strm->avail_in);
+		if (cnt == 0)
+			break;
+
+		memcpy(state->window + state->strstart + state->lookahead,
+		    strm->next_in, cnt);
+
+		strm->next_in += cnt;
+		strm->avail_in -= cnt;
+		strm->total_in += cnt;
+
+		state->lookahead += cnt;
+		state->flushed = false;
+	} while (state->lookahead < MIN_LOOKAHEAD);
+}
+
+/** Compare two strings
+ *
+ * @param scan    First string.
+ * @param match   Second string.
+ * @param max_len Maximum length to compare.
+ *
+ * @return Length of the common prefix.
+ *
+ */
+static inline size_t string_compare(const uint8_t *scan, const uint8_t *match,
+    size_t max_len)
+{
+	size_t len = 0;
+
+	/* Word by word may read up to a word past max_len */
+	while (len < max_len) {
+		uint64_t a;
+		uint64_t b;
+
+		memcpy(&a, scan + len, sizeof(a));
+		memcpy(&b, match + len, sizeof(b));
+		if (a != b)
+			break;
+
+		len += sizeof(a);
+	}
+
+	while ((len < max_len) && (scan[len] == match[len]))
+		len++;
+
+	return min(len, max_len);
+}
+
+/** Find the longest match at the current position
+ *
+ * Only matches longer than the previous match are looked for.
+ *
+ * @param state     Deflate state.
+ * @param cur_match Head of the hash chain of the current position.
+ *
+ * @return Length of the longest match, its start in state->match_start.
+ *
+ */
+static size_t longest_match(struct deflate_state *state, size_t cur_match)
+{
+	const deflate_config_t *config = state->config;
+	const uint8_t *scan = state->window + state->strstart;
+	unsigned int chain = config->max_chain;
+	size_t best_len = state->prev_length;
+	size_t nice_len = min(config->nice_length, state->lookahead);
+	size_t max_len = min(MAX_MATCH, state->lookahead);
+	size_t limit = (state->strstart > MAX_WINDOW_DIST) ?
+	    state->strstart - MAX_WINDOW_DIST : NIL;
+
+	/* A good match is already there, do not search long */
+	if (best_len >= config->good_length)
+		chain >>= 2;
+
+	do {
+		const uint8_t *match = state->window + cur_match;
+
+		/* Skip quickly what cannot be longer */
+		if ((match[best_len] != scan[best_len]) ||
+		    (match[best_len - 1] != scan[best_len - 1]) ||
+		    (match[0] != scan[0]) || (match[1] != scan[1]))
+			continue;
+
+		size_t len = string_compare(scan, match, max_len);
+		if (len > best_len) {
+			state->match_start = cur_match;
+			best_len = len;
+			if (len >= nice_len)
+				break;
+		}
+	} while (((cur_match = state->prev[cur_match & WINDOW_MASK]) > limit) &&
+	    (--chain != 0));
+
+	return min(best_len, state->lookahead);
+}
+
+/** Emit the rest of the input as requested by the flush mode
+ *
+ * @param state Deflate state.
+ * @param flush Flush mode (DEFLATE_SYNC_FLUSH or DEFLATE_FINISH).
+ *
+ * @return BLOCK_FLUSHED.
+ *
+ */
+static block_state_t deflate_flush(struct deflate_state *state,
+    deflate_flush_t flush)
+{
+	if (flush == DEFLATE_FINISH) {
+		block_emit(state, state->strstart, true);
+	} else {
+		if (state->sym_count > 0)
+			block_emit(state, state->strstart, false);
+
+		block_sync(state);
+	}
+
+	state->flushed = true;
+	return BLOCK_FLUSHED;
+}
+
+/** Compress without looking for matches (level 0)
+ *
+ * @param state Deflate state.
+ * @param strm  Deflate stream.
+ * @param flush Flush mode.
+ *
+ * @return Outcome of compression.
+ *
+ */
+static block_state_t deflate_store(struct deflate_state *state,
+    deflate_stream_t *strm, deflate_flush_t flush)
+{
+	while (true) {
+		if (state->lookahead == 0) {
+			window_fill(state, strm);
+			if (state->lookahead == 0)
+				break;
+		}
+
+		uint8_t lit = state->window[state->strstart];
+		bool full = tally_literal(state, lit);
+		state->strstart++;
+		state->lookahead--;
+
+		if (full) {
+			block_emit(state, state->strstart, false);
+			return BLOCK_DONE;
+		}
+	}
+
+	if (flush == DEFLATE_NO_FLUSH)
+		return BLOCK_NEED_INPUT;
+
+	return deflate_flush(state, flush);
+}
+
+/** Compress taking the longest match at each position (levels 1 to 3)
+ *
+ * @param state Deflate state.
+ * @param strm  Deflate stream.
+ * @param flush Flush mode.
+ *
+ * @return Outcome of compression.
+ *
+ */
+static block_state_t deflate_greedy(struct deflate_state *state,
+    deflate_stream_t *strm, deflate_flush_t flush)
+{
+	while (true) {
+		if (state->lookahead < MIN_LOOKAHEAD) {
+			window_fill(state, strm);
+			if ((state->lookahead < MIN_LOOKAHEAD) &&
+			    (flush == DEFLATE_NO_FLUSH))
+				return BLOCK_NEED_INPUT;
+
+			if (state->lookahead == 0)
+				break;
+		}
+
+		size_t hash_head = NIL;
+		if (state->lookahead >= MIN_MATCH)
+			hash_head = insert_string(state, state->strstart);
+
+		if ((hash_head != NIL) &&
+		    (state->strstart - hash_head <= MAX_WINDOW_DIST))
+			state->match_length = longest_match(state, hash_head);
+
+		bool full;
+
+		if (state->match_length >= MIN_MATCH) {
+			full = tally_match(state,
+			    state->strstart - state->match_start,
+			    state->match_length - MIN_MATCH);
+			state->lookahead -= state->match_length;
+
+			/* Hash the strings within short matches */
+			if ((state->match_length <= state->config->max_lazy) &&
+			    (state->lookahead >= MIN_MATCH)) {
+				state->match_length--;
+				do {
+					state->strstart++;
+					insert_string(state, state->strstart);
+				} while (--state->match_length != 0);
+
+				state->strstart++;
+			} else {
+				state->strstart += state->match_length;
+				state->match_length = 0;
+			}
+		} else {
+			full = tally_literal(state,
+			    state->window[state->strstart]);
+			state->strstart++;
+			state->lookahead--;
+		}
+
+		if (full) {
+			block_emit(state, state->strstart, false);
+			return BLOCK_DONE;
+		}
+	}
+
+	return deflate_flush(state, flush);
+}
+
+/** Compress with lazy matching (levels 4 to 9)
+ *
+ * A match is only emitted if there is no longer match at the next
+ * position, otherwise a literal is emitted and the match at the next
+ * position is considered instead.
+ *
+ * @param state Deflate state.
+ * @param strm  Deflate stream.
+ * @param flush Flush mode.
+ *
+ * @return Outcome of compression.
+ *
+ */
+static block_state_t deflate_lazy(struct deflate_state *state,
+    deflate_stream_t *strm, deflate_flush_t flush)
+{
+	while (true) {
+		if (state->lookahead < MIN_LOOKAHEAD) {
+			window_fill(state, strm);
+			if ((state->lookahead < MIN_LOOKAHEAD) &&
+			    (flush == DEFLATE_NO_FLUSH))
+				return BLOCK_NEED_INPUT;
+
+			if (state->lookahead == 0)
+				break;
+		}
+
+		size_t hash_head = NIL;
+		if (state->lookahead >= MIN_MATCH)
+			hash_head = insert_string(state, state->strstart);
+
+		state->prev_length = state->match_length;
+		state->prev_match = state->match_start;
+		state->match_length = MIN_MATCH - 1;
+
+		if ((hash_head != NIL) &&
+		    (state->prev_length < state->config->max_lazy) &&
+		    (state->strstart - hash_head <= MAX_WINDOW_DIST)) {
+			state->match_length = longest_match(state, hash_head);
+
+			if ((state->match_length == MIN_MATCH) &&
+			    (state->strstart - state->match_start > TOO_FAR))
+				state->match_length = MIN_MATCH - 1;
+		}
+
+		if ((state->prev_length >= MIN_MATCH) &&
+		    (state->match_length <= state->prev_length)) {
+			/* The previous match is better, emit it */
+			size_t max_insert = state->strstart + state->lookahead -
+			    MIN_MATCH;
+
+			bool full = tally_match(state,
+			    state->strstart - 1 - state->prev_match,
+			    state->prev_length - MIN_MATCH);
+
+			/* Hash the strings within the match */
+			state->lookahead -= state->prev_length - 1;
+			state->prev_length -= 2;
+			do {
+				if (++state->strstart <= max_insert)
+					insert_string(state, state->strstart);
+			} while (--state->prev_length != 0);
+
+			state->match_available = false;
+			state->match_length = MIN_MATCH - 1;
+			state->strstart++;
+
+			if (full) {
+				block_emit(state, state->strstart, false);
+				return BLOCK_DONE;
+			}
+		} else if (state->match_available) {
+			/* The previous byte has no better match */
+			bool full = tally_literal(state,
+			    state->window[state->strstart - 1]);
+			if (full)
+				block_emit(state, state->strstart, false);
+
+			state->strstart++;
+			state->lookahead--;
+
+			if (full)
+				return BLOCK_DONE;
+		} else {
+			/* Wait for the next position to decide */
+			state->match_available = true;
+			state->strstart++;
+			state->lookahead--;
+		}
+	}
+
+	if (state->match_available) {
+		tally_literal(state, state->window[state->strstart - 1]);
+		state->match_available = false;
+	}
+
+	return deflate_flush(state, flush);
+}
+
+/** Initialize deflate stream
+ *
+ * The caller sets up the input and output buffers of the stream
+ * before calling deflate_step().
+ *
+ * @param strm  Deflate stream.
+ * @param level Compression level (DEFLATE_LEVEL_STORE to
+ *              DEFLATE_LEVEL_BEST).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t deflate_init(deflate_stream_t *strm, unsigned int level)
+{
+	if (level > DEFLATE_LEVEL_BEST)
+		return EINVAL;
+
+	struct deflate_state *state = malloc(sizeof(struct deflate_state));
+	if (state == NULL)
+		return ENOMEM;
+
+	state->config = &deflate_config[level];
+	state->store = (level == DEFLATE_LEVEL_STORE);
+	state->flushed = true;
+	state->finished = false;
+
+	state->strstart = 0;
+	state->lookahead = 0;
+	state->block_start = 0;
+	memset(state->head, 0, sizeof(state->head));
+	memset(state->prev, 0, sizeof(state->prev));
+
+	state->match_length = MIN_MATCH - 1;
+	state->match_start = 0;
+	state->prev_length = MIN_MATCH - 1;
+	state->prev_match = 0;
+	state->match_available = false;
+
+	state->sym_count = 0;
+	memset(state->lit_freq, 0, sizeof(state->lit_freq));
+	memset(state->dist_freq, 0, sizeof(state->dist_freq));
+	huffman_fixed(state);
+
+	state->bitbuf = 0;
+	state->bitlen = 0;
+	state->pending_len = 0;
+	state->pending_pos = 0;
+
+	/* The string comparison may look past the input */
+	memset(state->window, 0, sizeof(state->window));
+
+	strm->total_in = 0;
+	strm->total_out = 0;
+	strm->state = state;
+	return EOK;
+}
+
+/** Compress as much data as possible
+ *
+ * Consumes input from and produces output to the buffers of the stream,
+ * advancing them. Without flushing, the compressor may keep some of the
+ * input consumed until more input or a flush comes.
+ *
+ * @param strm  Deflate stream.
+ * @param flush Flush mode. Once DEFLATE_FINISH is used, it has to be
+ *              used until the end of the deflate stream is reached.
+ *
+ * @return EOK if all input is compressed and output as requested by
+ *         DEFLATE_SYNC_FLUSH or DEFLATE_FINISH.
+ * @return EAGAIN if more input or output space is needed to continue.
+ *
+ */
+errno_t deflate_step(deflate_stream_t *strm, deflate_flush_t flush)
+{
+	struct deflate_state *state = strm->state;
+
+	while (true) {
+		pending_flush(state, strm);
+		if (state->pending_len > 0)
+			return EAGAIN;
+
+		if (state->finished)
+			return EOK;
+
+		if ((flush == DEFLATE_SYNC_FLUSH) && (state->flushed) &&
+		    (strm->avail_in == 0))
+			return EOK;
+
+		block_state_t ret;
+
+		if (state->store)
+			ret = deflate_store(state, strm, flush);
+		else if (state->config->lazy)
+			ret = deflate_lazy(state, strm, flush);
+		else
+			ret = deflate_greedy(state, strm, flush);
+
+		if (ret == BLOCK_NEED_INPUT)
+			return EAGAIN;
+	}
+}
+
+/** Release deflate stream
+ *
+ * @param strm Deflate stream.
+ *
+ */
+void deflate_end(deflate_stream_t *strm)
+{
+	free(strm->state);
+	strm->state = NULL;
+}
+
+/** Compress data to a newly allocated buffer
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[in]  level   Compression level.
+ * @param[in]  flush   DEFLATE_FINISH to end the deflate stream or
+ *                     DEFLATE_SYNC_FLUSH to allow appending to it.
+ * @param[out] dest    Compressed data.
+ * @param[out] destlen Size of the compressed data (bytes).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+static errno_t deflate_buffer(const void *src, size_t srclen,
+    unsigned int level, deflate_flush_t flush, void **dest, size_t *destlen)
+{
+	deflate_stream_t strm;
+
+	errno_t ret = deflate_init(&strm, level);
+	if (ret != EOK)
+		return ret;
+
+	size_t size = srclen / 4 + 64;
+	uint8_t *buf = malloc(size);
+	if (buf == NULL) {
+		deflate_end(&strm);
+		return ENOMEM;
+	}
+
+	strm.next_in = src;
+	strm.avail_in = srclen;
+	strm.next_out = buf;
+	strm.avail_out = size;
+
+	/* With all the input there, only the output space can run out */
+	while ((ret = deflate_step(&strm, flush)) == EAGAIN) {
+		uint8_t *nbuf = realloc(buf, 2 * size);
+		if (nbuf == NULL) {
+			ret = ENOMEM;
+			break;
+		}
+
+		buf = nbuf;
+		size *= 2;
+		strm.next_out = buf + strm.total_out;
+		strm.avail_out = size - strm.total_out;
+	}
+
+	deflate_end(&strm);
+
+	if (ret != EOK) {
+		free(buf);
+		return ret;
+	}
+
+	*dest = buf;
+	*destlen = strm.total_out;
+	return EOK;
+}
+
+/** Deflate data
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[in]  level   Compression level.
+ * @param[out] dest    Newly allocated buffer with the deflate stream.
+ * @param[out] destlen Size of the deflate stream (bytes).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t deflate(const void *src, size_t srclen, unsigned int level,
+    void **dest, size_t *destlen)
+{
+	return deflate_buffer(src, srclen, level, DEFLATE_FINISH, dest,
+	    destlen);
+}
+
+/** Chunk of data compressed in parallel */
+typedef struct {
+	const uint8_t *src;     /**< Source data */
+	size_t srclen;          /**< Size of the source data */
+	deflate_flush_t flush;  /**< How to end the compressed data */
+	void *dest;             /**< Compressed data */
+	size_t destlen;         /**< Size of the compressed data */
+	errno_t rc;             /**< Outcome of the compression */
+} deflate_chunk_t;
+
+/** Parallel compression job */
+typedef struct {
+	fibril_mutex_t lock;      /**< Protects the job */
+	fibril_condvar_t done_cv; /**< Signalled when a worker finishes */
+	deflate_chunk_t *chunks;  /**< Chunks of the data */
+	size_t count;             /**< Number of chunks */
+	size_t next;              /**< Next chunk to be compressed */
+	unsigned int level;       /**< Compression level */
+	unsigned int workers;     /**< Number of workers still running */
+} deflate_job_t;
+
+/** Compress chunks of a parallel compression job until there are none
+ *
+ * @param arg Parallel compression job.
+ *
+ * @return EOK.
+ *
+ */
+static errno_t deflate_worker(void *arg)
+{
+	deflate_job_t *job = (deflate_job_t *) arg;
+
+	fibril_mutex_lock(&job->lock);
+
+	while (job->next < job->count) {
+		deflate_chunk_t *chunk = &job->chunks[job->next++];
+		fibril_mutex_unlock(&job->lock);
+
+		chunk->rc = deflate_buffer(chunk->src, chunk->srclen,
+		    job->level, chunk->flush, &chunk->dest, &chunk->destlen);
+
+		fibril_mutex_lock(&job->lock);
+	}
+
+	job->workers--;
+	fibril_condvar_broadcast(&job->done_cv);
+	fibril_mutex_unlock(&job->lock);
+
+	return EOK;
+}
+
+/** Deflate data in parallel
+ *
+ * The data is split into chunks which are compressed independently by
+ * worker fibrils. Each chunk but the last ends with a sync flush, so the
+ * compressed chunks concatenate into a single deflate stream. Matches do
+ * not reach across the chunks, which costs a little compression ratio.
+ *
+ * The workers run in parallel if the task has several fibril runners
+ * (see fibril_enable_multithreaded()).
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[in]  level   Compression level.
+ * @param[in]  workers Maximum number of worker fibrils.
+ * @param[out] dest    Newly allocated buffer with the deflate stream.
+ * @param[out] destlen Size of the deflate stream (bytes).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t deflate_parallel(const void *src, size_t srclen, unsigned int level,
+    unsigned int workers, void **dest, size_t *destlen)
+{
+	size_t count = (srclen + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+
+	if ((workers <= 1) || (count <= 1))
+		return deflate(src, srclen, level, dest, destlen);
+
+	if (level > DEFLATE_LEVEL_BEST)
+		return EINVAL;
+
+	deflate_job_t job;
+
+	job.chunks = calloc(count, sizeof(deflate_chunk_t));
+	if (job.chunks == NULL)
+		return ENOMEM;
+
+	for (size_t i = 0; i < count; i++) {
+		size_t offset = i * PARALLEL_CHUNK_SIZE;
+
+		job.chunks[i].src = (const uint8_t *) src + offset;
+		job.chunks[i].srclen = min(srclen - offset,
+		    (size_t) PARALLEL_CHUNK_SIZE);
+		job.chunks[i].flush = (i == count - 1) ? DEFLATE_FINISH :
+		    DEFLATE_SYNC_FLUSH;
+	}
+
+	fibril_mutex_initialize(&job.lock);
+	fibril_condvar_initialize(&job.done_cv);
+	job.count = count;
+	job.next = 0;
+	job.level = level;
+
+	/* The calling fibril is one of the workers */
+	job.workers = 1;
+	workers = min(workers, count);
+
+	for (unsigned int i = 1; i < workers; i++) {
+		fid_t fid = fibril_create(deflate_worker, &job);
+		if (fid == 0)
+			break;
+
+		fibril_mutex_lock(&job.lock);
+		job.workers++;
+		fibril_mutex_unlock(&job.lock);
+
+		fibril_add_ready(fid);
+	}
+
+	deflate_worker(&job);
+
+	fibril_mutex_lock(&job.lock);
+	while (job.workers > 0)
+		fibril_condvar_wait(&job.done_cv, &job.lock);
+	fibril_mutex_unlock(&job.lock);
+
+	/* Concatenate the compressed chunks */
+	errno_t ret = EOK;
+	size_t size = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (job.chunks[i].rc != EOK)
+			ret = job.chunks[i].rc;
+		else
+			size += job.chunks[i].destlen;
+	}
+
+	uint8_t *buf = NULL;
+	if (ret == EOK) {
+		buf = malloc(size);
+		if (buf == NULL)
+			ret = ENOMEM;
+	}
+
+	size_t pos = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (job.chunks[i].rc != EOK)
+			continue;
+
+		if (buf != NULL) {
+			memcpy(buf + pos, job.chunks[i].dest,
+			    job.chunks[i].destlen);
+			pos += job.chunks[i].destlen;
+		}
+
+		free(job.chunks[i].dest);
+	}
+
+	free(job.chunks);
+
+	if (ret != EOK)
+		return ret;
+
+	*dest = buf;
+	*destlen = size;
+	return EOK;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCOMPRESS_DEFLATE_H_
+#define LIBCOMPRESS_DEFLATE_H_
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Compression levels */
+#define DEFLATE_LEVEL_STORE    0
+#define DEFLATE_LEVEL_FAST     1
+#define DEFLATE_LEVEL_DEFAULT  6
+#define DEFLATE_LEVEL_BEST     9
+
+/** Flush modes of deflate_step() */
+typedef enum {
+	/** Compress as much input as possible */
+	DEFLATE_NO_FLUSH,
+	/** Compress all input and align the output to a byte boundary */
+	DEFLATE_SYNC_FLUSH,
+	/** Compress all input and end the deflate stream */
+	DEFLATE_FINISH
+} deflate_flush_t;
+
+struct deflate_state;
+
+/** Deflate stream
+ *
+ * The caller points the stream to its input and output buffers and calls
+ * deflate_step() for as long as it returns EAGAIN, supplying more input
+ * or output space in between.
+ */
+typedef struct {
+	const uint8_t *next_in;  /**< Next input byte */
+	size_t avail_in;         /**< Number of bytes available at next_in */
+	size_t total_in;         /**< Total number of input bytes consumed */
+
+	uint8_t *next_out;       /**< Next output byte */
+	size_t avail_out;        /**< Free space at next_out */
+	size_t total_out;        /**< Total number of bytes output */
+
+	struct deflate_state *state;  /**< Internal encoder state */
+} deflate_stream_t;
+
+extern errno_t deflate_init(deflate_stream_t *, unsigned int);
+extern errno_t deflate_step(deflate_stream_t *, deflate_flush_t);
+extern void deflate_end(deflate_stream_t *);
+
+extern errno_t deflate(const void *, size_t, unsigned int, void **, size_t *);
+extern errno_t deflate_parallel(const void *, size_t, unsigned int,
+    unsigned int, void **, size_t *);
+
+#endif
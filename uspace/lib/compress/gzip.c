@@ -32,8 +32,10 @@
 #include <mem.h>
 #include <byteorder.h>
 #include <stdlib.h>
+#include <adt/checksum.h>
 #include "gzip.h"
 #include "inflate.h"
+#include "deflate.h"
 
 #define GZIP_ID1  UINT8_C(0x1f)
 #define GZIP_ID2  UINT8_C(0x8b)
@@ -46,6 +48,11 @@
 #define GZIP_FLAG_FNAME     UINT8_C(1 << 3)
 #define GZIP_FLAG_FCOMMENT  UINT8_C(1 << 4)
 
+#define GZIP_XFLAGS_BEST  UINT8_C(2)
+#define GZIP_XFLAGS_FAST  UINT8_C(4)
+
+#define GZIP_OS_UNKNOWN  UINT8_C(255)
+
 typedef struct {
 	uint8_t id1;
 	uint8_t id2;
@@ -61,41 +68,50 @@ typedef struct {
 	uint32_t size;
 } __attribute__((packed)) gzip_footer_t;
 
-/** Expand GZIP compressed data
+/** Skip a zero-terminated header field
  *
- * The routine allocates the output buffer based
- * on the size encoded in the input stream. This
- * effectively limits the size of the uncompressed
- * data to 4 GiB (expanding input streams that actually
- * encode more data will always fail).
+ * @param src    Header data.
+ * @param srclen Size of the header data (bytes).
+ * @param pos    Position of the field, updated past its terminator.
  *
- * So far, no CRC is perfomed.
+ * @return EOK on success.
+ * @return ELIMIT if the field does not end within the data.
  *
- * @param[in]  src     Source data buffer.
- * @param[in]  srclen  Source buffer size (bytes).
- * @param[out] dest    Destination data buffer.
- * @param[out] destlen Destination buffer size (bytes).
+ */
+static errno_t gzip_skip_string(const uint8_t *src, size_t srclen, size_t *pos)
+{
+	while (*pos < srclen) {
+		if (src[*pos] == 0) {
+			(*pos)++;
+			return EOK;
+		}
+
+		(*pos)++;
+	}
+
+	return ELIMIT;
+}
+
+/** Parse GZIP header
+ *
+ * @param[in]  src    Beginning of GZIP compressed data.
+ * @param[in]  srclen Size of the data available (bytes).
+ * @param[out] hdrlen Size of the header, followed by the deflate stream.
  *
  * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code, invalid deflate data,
- *                   invalid compression method or invalid stream.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @return EINVAL on invalid header or compression method.
+ * @return ELIMIT if the header does not end within the data.
  *
  */
-errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
+errno_t gzip_header_parse(const void *src, size_t srclen, size_t *hdrlen)
 {
+	const uint8_t *data = src;
 	gzip_header_t header;
-	gzip_footer_t footer;
-
-	if ((srclen < sizeof(header)) || (srclen < sizeof(footer)))
-		return EINVAL;
 
-	/* Decode header and footer */
+	if (srclen < sizeof(header))
+		return ELIMIT;
 
 	memcpy(&header, src, sizeof(header));
-	memcpy(&footer, src + srclen - sizeof(footer), sizeof(footer));
 
 	if ((header.id1 != GZIP_ID1) ||
 	    (header.id2 != GZIP_ID2) ||
@@ -103,79 +119,221 @@ errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
 	    ((header.flags & (~GZIP_FLAGS_MASK)) != 0))
 		return EINVAL;
 
-	*destlen = uint32_t_le2host(footer.size);
-
 	/* Ignore extra metadata */
 
-	void *stream = src + sizeof(header);
-	size_t stream_length = srclen - sizeof(header) - sizeof(footer);
+	size_t pos = sizeof(header);
+	errno_t rc;
 
 	if ((header.flags & GZIP_FLAG_FEXTRA) != 0) {
 		uint16_t extra_length;
 
-		if (stream_length < sizeof(extra_length))
-			return EINVAL;
+		if (srclen - pos < sizeof(extra_length))
+			return ELIMIT;
 
-		memcpy(&extra_length, stream, sizeof(extra_length));
-		stream += sizeof(extra_length);
-		stream_length -= sizeof(extra_length);
+		memcpy(&extra_length, data + pos, sizeof(extra_length));
+		pos += sizeof(extra_length);
 
-		if (stream_length < extra_length)
-			return EINVAL;
+		extra_length = uint16_t_le2host(extra_length);
+		if (srclen - pos < extra_length)
+			return ELIMIT;
 
-		stream += extra_length;
-		stream_length -= extra_length;
+		pos += extra_length;
 	}
 
 	if ((header.flags & GZIP_FLAG_FNAME) != 0) {
-		while (*((uint8_t *) stream) != 0) {
-			if (stream_length == 0)
-				return EINVAL;
+		rc = gzip_skip_string(data, srclen, &pos);
+		if (rc != EOK)
+			return rc;
+	}
 
-			stream++;
-			stream_length--;
-		}
+	if ((header.flags & GZIP_FLAG_FCOMMENT) != 0) {
+		rc = gzip_skip_string(data, srclen, &pos);
+		if (rc != EOK)
+			return rc;
+	}
 
-		if (stream_length == 0)
-			return EINVAL;
+	if ((header.flags & GZIP_FLAG_FHCRC) != 0) {
+		if (srclen - pos < 2)
+			return ELIMIT;
 
-		stream++;
-		stream_length--;
+		pos += 2;
 	}
 
-	if ((header.flags & GZIP_FLAG_FCOMMENT) != 0) {
-		while (*((uint8_t *) stream) != 0) {
-			if (stream_length == 0)
-				return EINVAL;
+	*hdrlen = pos;
+	return EOK;
+}
 
-			stream++;
-			stream_length--;
-		}
+/** Check GZIP footer
+ *
+ * So far, no CRC is perfomed.
+ *
+ * @param src     Footer following the deflate stream.
+ * @param srclen  Size of the data available (bytes).
+ * @param destlen Size of the uncompressed data (bytes).
+ *
+ * @return EOK on success.
+ * @return EINVAL if the size does not match.
+ * @return ELIMIT if the data is shorter than the footer.
+ *
+ */
+errno_t gzip_footer_check(const void *src, size_t srclen, size_t destlen)
+{
+	gzip_footer_t footer;
 
-		if (stream_length == 0)
-			return EINVAL;
+	if (srclen < sizeof(footer))
+		return ELIMIT;
 
-		stream++;
-		stream_length--;
-	}
+	memcpy(&footer, src, sizeof(footer));
 
-	if ((header.flags & GZIP_FLAG_FHCRC) != 0) {
-		if (stream_length < 2)
-			return EINVAL;
+	/* The size is stored modulo 2^32 */
+	if (uint32_t_le2host(footer.size) != (uint32_t) destlen)
+		return EINVAL;
+
+	return EOK;
+}
+
+/** Write GZIP header
+ *
+ * The header carries no metadata.
+ *
+ * @param dest  Buffer for GZIP_HEADER_SIZE bytes.
+ * @param level Compression level of the deflate stream.
+ *
+ */
+void gzip_header_write(void *dest, unsigned int level)
+{
+	gzip_header_t header;
+
+	header.id1 = GZIP_ID1;
+	header.id2 = GZIP_ID2;
+	header.method = GZIP_METHOD_DEFLATE;
+	header.flags = 0;
+	header.mtime = 0;
+	header.os = GZIP_OS_UNKNOWN;
+
+	if (level == DEFLATE_LEVEL_BEST)
+		header.extra_flags = GZIP_XFLAGS_BEST;
+	else if (level == DEFLATE_LEVEL_FAST)
+		header.extra_flags = GZIP_XFLAGS_FAST;
+	else
+		header.extra_flags = 0;
+
+	memcpy(dest, &header, sizeof(header));
+}
+
+/** Write GZIP footer
+ *
+ * @param dest    Buffer for GZIP_FOOTER_SIZE bytes.
+ * @param crc     CRC-32 of the uncompressed data.
+ * @param destlen Size of the uncompressed data (bytes).
+ *
+ */
+void gzip_footer_write(void *dest, uint32_t crc, size_t destlen)
+{
+	gzip_footer_t footer;
 
-		stream += 2;
-		stream_length -= 2;
+	footer.crc32 = host2uint32_t_le(crc);
+	footer.size = host2uint32_t_le((uint32_t) destlen);
+
+	memcpy(dest, &footer, sizeof(footer));
+}
+
+/** Compress data to GZIP format
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[in]  level   Compression level.
+ * @param[in]  workers Maximum number of fibrils compressing in parallel.
+ * @param[out] dest    Newly allocated buffer with the GZIP data.
+ * @param[out] destlen Size of the GZIP data (bytes).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t gzip_compress(const void *src, size_t srclen, unsigned int level,
+    unsigned int workers, void **dest, size_t *destlen)
+{
+	void *stream;
+	size_t stream_length;
+
+	errno_t ret = deflate_parallel(src, srclen, level, workers, &stream,
+	    &stream_length);
+	if (ret != EOK)
+		return ret;
+
+	size_t size = GZIP_HEADER_SIZE + stream_length + GZIP_FOOTER_SIZE;
+	uint8_t *buf = malloc(size);
+	if (buf == NULL) {
+		free(stream);
+		return ENOMEM;
 	}
 
+	gzip_header_write(buf, level);
+	memcpy(buf + GZIP_HEADER_SIZE, stream, stream_length);
+	gzip_footer_write(buf + GZIP_HEADER_SIZE + stream_length,
+	    compute_crc32((uint8_t *) src, srclen), srclen);
+
+	free(stream);
+
+	*dest = buf;
+	*destlen = size;
+	return EOK;
+}
+
+/** Expand GZIP compressed data
+ *
+ * The routine allocates the output buffer based
+ * on the size encoded in the input stream. This
+ * effectively limits the size of the uncompressed
+ * data to 4 GiB (expanding input streams that actually
+ * encode more data will always fail).
+ *
+ * So far, no CRC is perfomed.
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[out] dest    Destination data buffer.
+ * @param[out] destlen Destination buffer size (bytes).
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code, invalid deflate data,
+ *                   invalid compression method or invalid stream.
+ * @return ELIMIT on input buffer overrun.
+ * @return ENOMEM on output buffer overrun.
+ *
+ */
+errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
+{
+	gzip_footer_t footer;
+	size_t hdrlen;
+
+	if (srclen < sizeof(footer))
+		return EINVAL;
+
+	/* Decode header and footer */
+
+	errno_t ret = gzip_header_parse(src, srclen - sizeof(footer), &hdrlen);
+	if (ret != EOK)
+		return EINVAL;
+
+	memcpy(&footer, src + srclen - sizeof(footer), sizeof(footer));
+	*destlen = uint32_t_le2host(footer.size);
+
+	void *stream = src + hdrlen;
+	size_t stream_length = srclen - hdrlen - sizeof(footer);
+
 	/* Allocate output buffer and inflate the data */
 
 	*dest = malloc(*destlen);
 	if (*dest == NULL)
 		return ENOMEM;
 
-	errno_t ret = inflate(stream, stream_length, *dest, *destlen);
+	ret = inflate(stream, stream_length, *dest, *destlen);
 	if (ret != EOK) {
-		free(dest);
+		free(*dest);
 		return ret;
 	}
 
@@ -30,7 +30,20 @@
 #define LIBCOMPRESS_GZIP_H_
 
 #include <stddef.h>
+#include <stdint.h>
 
+/** Size of the header written by gzip_header_write() */
+#define GZIP_HEADER_SIZE  10
+/** Size of the GZIP footer */
+#define GZIP_FOOTER_SIZE  8
+
+extern errno_t gzip_header_parse(const void *, size_t, size_t *);
+extern errno_t gzip_footer_check(const void *, size_t, size_t);
 extern errno_t gzip_expand(void *, size_t, void **, size_t *);
 
+extern void gzip_header_write(void *, unsigned int);
+extern void gzip_footer_write(void *, uint32_t, size_t);
+extern errno_t gzip_compress(const void *, size_t, unsigned int, unsigned int,
+    void **, size_t *);
+
 #endif
@@ -30,12 +30,17 @@
 /** @file
  * @brief Implementation of inflate decompression
  *
- * A simple inflate implementation (decompression of `deflate' stream as
- * described by RFC 1951) based on puff.c by Mark Adler. This code is
- * currently not optimized for speed but for readability.
+ * Streaming inflate implementation (decompression of `deflate' stream as
+ * described by RFC 1951) derived from puff.c by Mark Adler.
  *
- * All dynamically allocated memory memory is taken from the stack. The
- * stack usage should be typically bounded by 2 KB.
+ * The decoder is a state machine which can be suspended whenever it runs
+ * out of input or output space and resumed once more is available. Symbols
+ * are decoded using two-level lookup tables indexed by the next bits of
+ * the input, which is read into a 64-bit bit buffer a word at a time.
+ *
+ * The output is first written to a window of the recent output, from
+ * which matches are copied and which is flushed to the output buffer
+ * of the caller.
  *
  * Original copyright notice:
  *
@@ -66,8 +71,11 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <mem.h>
+#include <byteorder.h>
+#include <macros.h>
 #include "inflate.h"
 
 /** Maximum bits in the Huffman code */
@@ -83,43 +91,103 @@
 #define MAX_LITLEN        286
 /** Number of fixed literal/length codes */
 #define MAX_FIXED_LITLEN  288
+/** Number of fixed distance codes */
+#define MAX_FIXED_DIST    32
 
 /** Number of all codes */
 #define MAX_CODE  (MAX_LITLEN + MAX_DIST)
 
-/** Check for input buffer overrun condition */
-#define CHECK_OVERRUN(state) \
-	do { \
-		if ((state).overrun) \
-			return ELIMIT; \
-	} while (false)
+/** Bits indexing the root tables */
+#define LEN_ROOT_BITS   9
+#define DIST_ROOT_BITS  6
+#define CLEN_ROOT_BITS  7
 
-/** Inflate algorithm state
+/*
+ * Maximum sizes of the lookup tables including the second-level
+ * tables, as computed by the `enough' utility of zlib.
+ */
+#define LEN_TABLE_SIZE   852
+#define DIST_TABLE_SIZE  592
+#define CLEN_TABLE_SIZE  (1 << CLEN_ROOT_BITS)
+
+/** Size of the output window (power of two, at least twice the distance) */
+#define WINDOW_SIZE  65536
+#define WINDOW_MASK  (WINDOW_SIZE - 1)
+
+/** Longest match */
+#define MAX_MATCH  258
+
+/** Bytes a word-wide match copy may write past the match */
+#define COPY_SLACK  8
+
+/** Decoder state machine modes */
+typedef enum {
+	MODE_HEADER,     /**< Block header */
+	MODE_STORED,     /**< Length of a stored block */
+	MODE_COPY,       /**< Data of a stored block */
+	MODE_TABLE,      /**< Table sizes of a dynamic block */
+	MODE_CODELENS,   /**< Code length code lengths */
+	MODE_LENLENS,    /**< Literal/length and distance code lengths */
+	MODE_CODES,      /**< Compressed data */
+	MODE_DONE        /**< End of the last block */
+} inflate_mode_t;
+
+/** Lookup table entry types */
+typedef enum {
+	ENTRY_INVALID = 0,  /**< No code starts with these bits */
+	ENTRY_SYMBOL,       /**< Decoded symbol */
+	ENTRY_LINK          /**< Link to a second-level table */
+} huffman_entry_type_t;
+
+/** Lookup table entry
  *
  */
 typedef struct {
-	uint8_t *dest;    /**< Output buffer */
-	size_t destlen;   /**< Output buffer size */
-	size_t destcnt;   /**< Position in the output buffer */
-
-	uint8_t *src;     /**< Input buffer */
-	size_t srclen;    /**< Input buffer size */
-	size_t srccnt;    /**< Position in the input buffer */
-
-	uint16_t bitbuf;  /**< Bit buffer */
-	size_t bitlen;    /**< Number of bits in the bit buffer */
+	uint16_t val;  /**< Symbol or offset of the second-level table */
+	uint8_t type;  /**< Entry type */
+	uint8_t bits;  /**< Code bits or second-level table index bits */
+} huffman_entry_t;
 
-	bool overrun;     /**< Overrun condition */
-} inflate_state_t;
-
-/** Huffman code description
+/** Huffman code lookup table
  *
  */
 typedef struct {
-	uint16_t *count;   /**< Array of symbol counts */
-	uint16_t *symbol;  /**< Array of symbols */
+	huffman_entry_t *table;  /**< Root table and second-level tables */
+	size_t size;             /**< Number of table entries */
+	unsigned int root;       /**< Bits indexing the root table */
 } huffman_t;
 
+/** Inflate algorithm state
+ *
+ */
+struct inflate_state {
+	inflate_mode_t mode;  /**< Current mode */
+	bool last;            /**< Current block is the last one */
+	errno_t error;        /**< Sticky error */
+
+	uint64_t bitbuf;      /**< Bit buffer */
+	unsigned int bitlen;  /**< Number of bits in the bit buffer */
+
+	size_t stored;        /**< Bytes left in the stored block */
+
+	uint16_t nlen;        /**< Number of literal/length codes */
+	uint16_t ndist;       /**< Number of distance codes */
+	uint16_t ncode;       /**< Number of code length codes */
+	uint16_t index;       /**< Code lengths read so far */
+	uint16_t length[MAX_FIXED_LITLEN + MAX_FIXED_DIST];
+
+	huffman_t len_code;
+	huffman_t dist_code;
+	huffman_t clen_code;
+	huffman_entry_t len_table[LEN_TABLE_SIZE];
+	huffman_entry_t dist_table[DIST_TABLE_SIZE];
+	huffman_entry_t clen_table[CLEN_TABLE_SIZE];
+
+	uint64_t whave;       /**< Bytes written to the window */
+	uint64_t wflushed;    /**< Bytes flushed from the window */
+	uint8_t window[WINDOW_SIZE];
+};
+
 /** Length codes
  *
  */
@@ -161,223 +229,153 @@ static const short order[MAX_ORDER] = {
 	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
 };
 
-/** Static length symbol counts
- *
- */
-static uint16_t len_count[MAX_HUFFMAN_BIT + 1] = {
-	0, 0, 0, 0, 0, 0, 0, 24, 152, 112, 0, 0, 0, 0, 0, 0
-};
-
-/** Static length symbols
- *
- */
-static uint16_t len_symbol[MAX_FIXED_LITLEN] = {
-	256, 257, 258, 259, 260, 261, 262, 263, 264, 265, 266, 267, 268,
-	269, 270, 271, 272, 273, 274, 275, 276, 277, 278, 279, 0, 1, 2,
-	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
-	21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36,
-	37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52,
-	53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68,
-	69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84,
-	85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 97, 98, 99, 100,
-	101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113,
-	114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126,
-	127, 128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139,
-	140, 141, 142, 143, 280, 281, 282, 283, 284, 285, 286, 287, 144,
-	145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156, 157,
-	158, 159, 160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170,
-	171, 172, 173, 174, 175, 176, 177, 178, 179, 180, 181, 182, 183,
-	184, 185, 186, 187, 188, 189, 190, 191, 192, 193, 194, 195, 196,
-	197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207, 208, 209,
-	210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222,
-	223, 224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235,
-	236, 237, 238, 239, 240, 241, 242, 243, 244, 245, 246, 247, 248,
-	249, 250, 251, 252, 253, 254, 255
-};
-
-/** Static distance symbol counts
- *
- */
-static uint16_t dist_count[MAX_HUFFMAN_BIT + 1] = {
-	0, 0, 0, 0, 0, 30, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-};
-
-/** Static distance symbols
+/** Mask of the lowest bits
  *
- */
-static uint16_t dist_symbol[MAX_DIST] = {
-	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
-	16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29
-};
-
-/** Huffman code for lengths
+ * @param cnt Number of bits (less than 64).
  *
  */
-static huffman_t len_code = {
-	.count = len_count,
-	.symbol = len_symbol
-};
+static inline uint64_t bits_mask(unsigned int cnt)
+{
+	return (UINT64_C(1) << cnt) - 1;
+}
 
-/** Huffman code for distances
+/** Fill the bit buffer from the input
  *
- */
-static huffman_t dist_code = {
-	.count = dist_count,
-	.symbol = dist_symbol
-};
-
-/** Get bits from the bit buffer
+ * Unless the input runs out, the bit buffer holds at least 56 bits
+ * afterwards, enough for any literal/length and distance pair.
  *
  * @param state Inflate state.
- * @param cnt   Number of bits to return (at most 16).
- *
- * @return Returned bits.
+ * @param strm  Inflate stream.
  *
  */
-static inline uint16_t get_bits(inflate_state_t *state, size_t cnt)
+static inline void bits_fill(struct inflate_state *state,
+    inflate_stream_t *strm)
 {
-	/* Bit accumulator for at least 20 bits */
-	uint32_t val = state->bitbuf;
-
-	while (state->bitlen < cnt) {
-		if (state->srccnt == state->srclen) {
-			state->overrun = true;
-			return 0;
-		}
+	if (state->bitlen > 56)
+		return;
+
+	if (strm->avail_in >= sizeof(uint64_t)) {
+		/* Load as many whole bytes of a word as fit */
+		uint64_t word;
+		memcpy(&word, strm->next_in, sizeof(word));
+		word = uint64_t_le2host(word);
+
+		size_t cnt = (63 - state->bitlen) >> 3;
+		state->bitbuf |= word << state->bitlen;
+		state->bitlen += cnt << 3;
+		state->bitbuf &= bits_mask(state->bitlen);
+
+		strm->next_in += cnt;
+		strm->avail_in -= cnt;
+		return;
+	}
 
-		/* Load 8 more bits */
-		val |= ((uint32_t) state->src[state->srccnt]) << state->bitlen;
-		state->srccnt++;
+	while ((state->bitlen <= 56) && (strm->avail_in > 0)) {
+		state->bitbuf |= ((uint64_t) *strm->next_in) << state->bitlen;
 		state->bitlen += 8;
+		strm->next_in++;
+		strm->avail_in--;
 	}
+}
 
-	/* Update bits in the buffer */
-	state->bitbuf = (uint16_t) (val >> cnt);
+/** Drop bits from the bit buffer
+ *
+ * @param state Inflate state.
+ * @param cnt   Number of bits to drop (at most the bits in the buffer).
+ *
+ */
+static inline void bits_drop(struct inflate_state *state, unsigned int cnt)
+{
+	state->bitbuf >>= cnt;
 	state->bitlen -= cnt;
-
-	return ((uint16_t) (val & ((1 << cnt) - 1)));
 }
 
-/** Decode `stored' block
+/** Get bits from the bit buffer
  *
  * @param state Inflate state.
+ * @param strm  Inflate stream.
+ * @param cnt   Number of bits to return (at most 56).
+ * @param val   Returned bits.
  *
- * @return EOK on success.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
- * @return EINVAL on invalid data.
+ * @return True if the bits were available.
  *
  */
-static errno_t inflate_stored(inflate_state_t *state)
+static inline bool get_bits(struct inflate_state *state,
+    inflate_stream_t *strm, unsigned int cnt, uint16_t *val)
 {
-	/* Discard bits in the bit buffer */
-	state->bitbuf = 0;
-	state->bitlen = 0;
-
-	if (state->srccnt + 4 > state->srclen)
-		return ELIMIT;
-
-	uint16_t len =
-	    state->src[state->srccnt] | (state->src[state->srccnt + 1] << 8);
-	uint16_t len_compl =
-	    state->src[state->srccnt + 2] | (state->src[state->srccnt + 3] << 8);
-
-	/* Check block length and its complement */
-	if (((int16_t) len) != ~((int16_t) len_compl))
-		return EINVAL;
-
-	state->srccnt += 4;
+	bits_fill(state, strm);
+	if (state->bitlen < cnt)
+		return false;
 
-	/* Check input buffer size */
-	if (state->srccnt + len > state->srclen)
-		return ELIMIT;
-
-	/* Check output buffer size */
-	if (state->destcnt + len > state->destlen)
-		return ENOMEM;
-
-	/* Copy data */
-	memcpy(state->dest + state->destcnt, state->src + state->srccnt, len);
-	state->srccnt += len;
-	state->destcnt += len;
-
-	return EOK;
+	*val = (uint16_t) (state->bitbuf & bits_mask(cnt));
+	bits_drop(state, cnt);
+	return true;
 }
 
 /** Decode a symbol using the Huffman code
  *
- * @param state   Inflate state.
+ * The bits of the symbol are not dropped from the the bit buffer.
+ *
  * @param huffman Huffman code.
+ * @param bitbuf  Next bits of the input.
+ * @param bitlen  Number of valid bits in @a bitbuf (bits above are zero).
  * @param symbol  Decoded symbol.
+ * @param used    Number of bits of the decoded symbol.
  *
- * @param EOK on success.
- * @param EINVAL on invalid Huffman code.
+ * @return EOK on success.
+ * @return EAGAIN if more bits are needed.
+ * @return EINVAL on invalid Huffman code.
  *
  */
-static errno_t huffman_decode(inflate_state_t *state, huffman_t *huffman,
-    uint16_t *symbol)
+static inline errno_t huffman_decode(const huffman_t *huffman,
+    uint64_t bitbuf, unsigned int bitlen, uint16_t *symbol, unsigned int *used)
 {
-	/* Decode bits */
-	uint16_t code = 0;
-
-	/* First code of the given length */
-	size_t first = 0;
-
-	/*
-	 * Index of the first code of the given length
-	 * in the symbol table
-	 */
-	size_t index = 0;
+	huffman_entry_t entry =
+	    huffman->table[bitbuf & bits_mask(huffman->root)];
+	unsigned int base = 0;
+
+	if (entry.type == ENTRY_LINK) {
+		base = huffman->root;
+		entry = huffman->table[entry.val +
+		    ((bitbuf >> base) & bits_mask(entry.bits))];
+	}
 
-	/* Current number of bits in the code */
-	size_t len;
+	if (entry.type != ENTRY_SYMBOL)
+		return (bitlen >= MAX_HUFFMAN_BIT) ? EINVAL : EAGAIN;
 
-	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
-		/* Get next bit */
-		code |= get_bits(state, 1);
-		CHECK_OVERRUN(*state);
-
-		uint16_t count = huffman->count[len];
-		if (code < first + count) {
-			/* Return decoded symbol */
-			*symbol = huffman->symbol[index + code - first];
-			return EOK;
-		}
-
-		/* Update for next length */
-		index += count;
-		first += count;
-		first <<= 1;
-		code <<= 1;
-	}
+	if (base + entry.bits > bitlen)
+		return EAGAIN;
 
-	return EINVAL;
+	*symbol = entry.val;
+	*used = base + entry.bits;
+	return EOK;
 }
 
-/** Construct Huffman tables from canonical Huffman code
+/** Check a canonical Huffman code
  *
- * @param huffman Constructed Huffman tables.
- * @param length  Lengths of the canonical Huffman code.
- * @param n       Number of lengths.
+ * @param length Lengths of the canonical Huffman code.
+ * @param n      Number of lengths.
+ * @param count  Number of codes of each length.
  *
  * @return 0 if the Huffman code set is complete.
  * @return Negative value for an over-subscribed code set.
  * @return Positive value for an incomplete code set.
  *
  */
-static int16_t huffman_construct(huffman_t *huffman, uint16_t *length, size_t n)
+static int16_t huffman_count(const uint16_t *length, size_t n,
+    uint16_t *count)
 {
 	/* Count number of codes for each length */
 	size_t len;
 	for (len = 0; len <= MAX_HUFFMAN_BIT; len++)
-		huffman->count[len] = 0;
+		count[len] = 0;
 
 	/* We assume that the lengths are within bounds */
 	size_t symbol;
 	for (symbol = 0; symbol < n; symbol++)
-		huffman->count[length[symbol]]++;
+		count[length[symbol]]++;
 
-	if (huffman->count[0] == n) {
+	if (count[0] == n) {
 		/* The code is complete, but decoding will fail */
 		return 0;
 	}
@@ -386,229 +384,781 @@ static int16_t huffman_construct(huffman_t *huffman, uint16_t *length, size_t n)
 	int16_t left = 1;
 	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
 		left <<= 1;
-		left -= huffman->count[len];
+		left -= count[len];
 		if (left < 0) {
 			/* Over-subscribed */
 			return left;
 		}
 	}
 
-	/* Generate offsets into symbol table */
-	uint16_t offs[MAX_HUFFMAN_BIT + 1];
+	return left;
+}
 
-	offs[1] = 0;
-	for (len = 1; len < MAX_HUFFMAN_BIT; len++)
-		offs[len + 1] = offs[len] + huffman->count[len];
+/** Construct lookup tables from canonical Huffman code
+ *
+ * Codes not longer than the root bits are decoded by a single lookup in
+ * the root table. Longer codes sharing their first root bits are decoded
+ * by a second-level table large enough for the longest of them.
+ *
+ * @param huffman Constructed Huffman tables.
+ * @param length  Lengths of the canonical Huffman code (not over-subscribed).
+ * @param n       Number of lengths.
+ * @param count   Number of codes of each length.
+ *
+ * @return EOK on success.
+ * @return EINVAL if the tables do not fit.
+ *
+ */
+static errno_t huffman_construct(huffman_t *huffman, const uint16_t *length,
+    size_t n, const uint16_t *count)
+{
+	unsigned int root = huffman->root;
+	size_t root_size = 1 << root;
+
+	/* First code of each length, in reading order of bits */
+	uint16_t next[MAX_HUFFMAN_BIT + 1];
+	uint16_t code = 0;
+	unsigned int len;
+
+	next[0] = 0;
+	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
+		code = (code + count[len - 1]) << 1;
+		next[len] = code;
+	}
 
+	/* Start with no valid codes */
+	memset(huffman->table, 0, huffman->size * sizeof(huffman_entry_t));
+
+	/* Size the second-level tables */
+	uint8_t sub_bits[1 << LEN_ROOT_BITS];
+	memset(sub_bits, 0, root_size);
+
+	uint16_t codes[MAX_FIXED_LITLEN];
+	size_t symbol;
 	for (symbol = 0; symbol < n; symbol++) {
-		if (length[symbol] != 0) {
-			huffman->symbol[offs[length[symbol]]] = symbol;
-			offs[length[symbol]]++;
+		len = length[symbol];
+		if (len == 0)
+			continue;
+
+		/* Codes are sent starting from the most significant bit */
+		uint16_t rev = 0;
+		code = next[len]++;
+		for (unsigned int i = 0; i < len; i++) {
+			rev = (rev << 1) | (code & 1);
+			code >>= 1;
+		}
+
+		codes[symbol] = rev;
+
+		if (len > root) {
+			size_t prefix = rev & (root_size - 1);
+			sub_bits[prefix] = max(sub_bits[prefix], len - root);
 		}
 	}
 
-	return left;
+	size_t offset = root_size;
+	size_t prefix;
+	for (prefix = 0; prefix < root_size; prefix++) {
+		if (sub_bits[prefix] == 0)
+			continue;
+
+		if (offset + (1 << sub_bits[prefix]) > huffman->size)
+			return EINVAL;
+
+		huffman->table[prefix].type = ENTRY_LINK;
+		huffman->table[prefix].val = offset;
+		huffman->table[prefix].bits = sub_bits[prefix];
+		offset += 1 << sub_bits[prefix];
+	}
+
+	/* Fill in the symbols, replicated for all the bits that follow */
+	for (symbol = 0; symbol < n; symbol++) {
+		len = length[symbol];
+		if (len == 0)
+			continue;
+
+		huffman_entry_t entry = {
+			.val = symbol,
+			.type = ENTRY_SYMBOL
+		};
+
+		size_t first;
+		size_t end;
+		size_t idx;
+
+		if (len <= root) {
+			entry.bits = len;
+			first = codes[symbol];
+			end = root_size;
+		} else {
+			entry.bits = len - root;
+			prefix = codes[symbol] & (root_size - 1);
+			first = huffman->table[prefix].val +
+			    (codes[symbol] >> root);
+			end = huffman->table[prefix].val +
+			    (1 << huffman->table[prefix].bits);
+		}
+
+		for (idx = first; idx < end; idx += 1 << entry.bits)
+			huffman->table[idx] = entry;
+	}
+
+	return EOK;
 }
 
-/** Decode literal/length and distance codes
+/** Write a literal to the window
  *
- * Decode until end-of-block code.
+ * @param state Inflate state.
+ * @param byte  Literal.
  *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+ */
+static inline void window_put(struct inflate_state *state, uint8_t byte)
+{
+	state->window[state->whave & WINDOW_MASK] = byte;
+	state->whave++;
+}
+
+/** Copy a match within the window
  *
- * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * The window must have room for the match and COPY_SLACK bytes.
+ *
+ * @param state Inflate state.
+ * @param dist  Distance of the match.
+ * @param len   Length of the match.
  *
  */
-static errno_t inflate_codes(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static inline void window_copy(struct inflate_state *state, size_t dist,
+    size_t len)
 {
-	uint16_t symbol;
+	size_t to = state->whave & WINDOW_MASK;
+	size_t from = (state->whave - dist) & WINDOW_MASK;
+
+	state->whave += len;
+
+	if ((to + len + COPY_SLACK > WINDOW_SIZE) ||
+	    (from + len + COPY_SLACK > WINDOW_SIZE)) {
+		/* The match wraps around the window */
+		while (len > 0) {
+			state->window[to] = state->window[from];
+			to = (to + 1) & WINDOW_MASK;
+			from = (from + 1) & WINDOW_MASK;
+			len--;
+		}
 
-	do {
-		errno_t err = huffman_decode(state, len_code, &symbol);
-		if (err != EOK) {
-			/* Error decoding */
-			return err;
+		return;
+	}
+
+	uint8_t *dest = state->window + to;
+	const uint8_t *src = state->window + from;
+
+	if (dist >= sizeof(uint64_t)) {
+		/*
+		 * Each word is read only after all its bytes have been
+		 * written, even if the match overlaps itself. This may
+		 * write up to COPY_SLACK bytes past the match.
+		 */
+		for (size_t i = 0; i < len; i += sizeof(uint64_t)) {
+			uint64_t word;
+			memcpy(&word, src + i, sizeof(word));
+			memcpy(dest + i, &word, sizeof(word));
 		}
+	} else if (dist == 1) {
+		memset(dest, *src, len);
+	} else {
+		for (size_t i = 0; i < len; i++)
+			dest[i] = src[i];
+	}
+}
 
-		if (symbol < 256) {
-			/* Write out literal */
-			if (state->destcnt == state->destlen)
-				return ENOMEM;
-
-			state->dest[state->destcnt] = (uint8_t) symbol;
-			state->destcnt++;
-		} else if (symbol > 256) {
-			/* Compute length */
-			symbol -= 257;
-			if (symbol >= 29)
-				return EINVAL;
+/** Flush the window to the output buffer
+ *
+ * @param state Inflate state.
+ * @param strm  Inflate stream.
+ *
+ */
+static void window_flush(struct inflate_state *state, inflate_stream_t *strm)
+{
+	while ((state->whave != state->wflushed) && (strm->avail_out > 0)) {
+		size_t pos = state->wflushed & WINDOW_MASK;
+		size_t cnt = min(state->whave - state->wflushed,
+		    min(strm->avail_out, WINDOW_SIZE - pos));
+
+		memcpy(strm->next_out, state->window + pos, cnt);
+		strm->next_out += cnt;
+		strm->avail_out -= cnt;
+		strm->total_out += cnt;
+		state->wflushed += cnt;
+	}
+}
 
-			size_t len = lens[symbol] + get_bits(state, lens_ext[symbol]);
-			CHECK_OVERRUN(*state);
+/** Free space in the window */
+static inline size_t window_room(struct inflate_state *state)
+{
+	return WINDOW_SIZE - (state->whave - state->wflushed);
+}
 
-			/* Get distance */
-			err = huffman_decode(state, dist_code, &symbol);
-			if (err != EOK)
-				return err;
+/** Decode the length of a `stored' block
+ *
+ * @param state Inflate state.
+ * @param strm  Inflate stream.
+ *
+ * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid data.
+ *
+ */
+static errno_t inflate_stored(struct inflate_state *state,
+    inflate_stream_t *strm)
+{
+	/* Discard bits up to the byte boundary */
+	bits_drop(state, state->bitlen & 7);
 
-			size_t dist = dists[symbol] + get_bits(state, dists_ext[symbol]);
-			if (dist > state->destcnt)
-				return ENOENT;
+	bits_fill(state, strm);
+	if (state->bitlen < 32)
+		return EAGAIN;
 
-			if (state->destcnt + len > state->destlen)
-				return ENOMEM;
+	uint16_t len = state->bitbuf & 0xffff;
+	uint16_t len_compl = (state->bitbuf >> 16) & 0xffff;
+	bits_drop(state, 32);
 
-			while (len > 0) {
-				/* Copy len bytes from distance bytes back */
-				state->dest[state->destcnt] =
-				    state->dest[state->destcnt - dist];
-				state->destcnt++;
-				len--;
-			}
-		}
-	} while (symbol != 256);
+	/* Check block length and its complement */
+	if ((len ^ len_compl) != 0xffff)
+		return EINVAL;
 
+	state->stored = len;
+	state->mode = MODE_COPY;
 	return EOK;
 }
 
-/** Decode `fixed codes' block
+/** Copy data of a `stored' block to the window
  *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+ * @param state Inflate state.
+ * @param strm  Inflate stream.
  *
  * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @return EAGAIN if more input is needed.
+ * @return ENOSPC if the window needs to be flushed.
  *
  */
-static errno_t inflate_fixed(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static errno_t inflate_copy(struct inflate_state *state,
+    inflate_stream_t *strm)
 {
-	return inflate_codes(state, len_code, dist_code);
+	while (state->stored > 0) {
+		if (window_room(state) == 0)
+			return ENOSPC;
+
+		/* Whole bytes already loaded to the bit buffer go first */
+		if (state->bitlen >= 8) {
+			window_put(state, state->bitbuf & 0xff);
+			bits_drop(state, 8);
+			state->stored--;
+			continue;
+		}
+
+		if (strm->avail_in == 0)
+			return EAGAIN;
+
+		size_t pos = state->whave & WINDOW_MASK;
+		size_t cnt = min(min(state->stored, strm->avail_in),
+		    min(window_room(state), WINDOW_SIZE - pos));
+
+		memcpy(state->window + pos, strm->next_in, cnt);
+		strm->next_in += cnt;
+		strm->avail_in -= cnt;
+		state->whave += cnt;
+		state->stored -= cnt;
+	}
+
+	state->mode = state->last ? MODE_DONE : MODE_HEADER;
+	return EOK;
 }
 
-/** Decode `dynamic codes' block
+/** Decode literal/length and distance codes
  *
- * @param state     Inflate state.
+ * Decode until end-of-block code.
+ *
+ * @param state Inflate state.
+ * @param strm  Inflate stream.
  *
  * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return ENOSPC if the window needs to be flushed.
  * @return ENOENT on distance too large.
  * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
  *
  */
-static errno_t inflate_dynamic(inflate_state_t *state)
+static errno_t inflate_codes(struct inflate_state *state,
+    inflate_stream_t *strm)
 {
-	uint16_t length[MAX_CODE];
-	uint16_t dyn_len_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_len_symbol[MAX_LITLEN];
-	uint16_t dyn_dist_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_dist_symbol[MAX_DIST];
-	huffman_t dyn_len_code;
-	huffman_t dyn_dist_code;
+	while (true) {
+		if (window_room(state) < MAX_MATCH + COPY_SLACK)
+			return ENOSPC;
+
+		bits_fill(state, strm);
 
-	dyn_len_code.count = dyn_len_count;
-	dyn_len_code.symbol = dyn_len_symbol;
+		uint64_t bitbuf = state->bitbuf;
+		unsigned int bitlen = state->bitlen;
+		uint16_t symbol;
+		unsigned int used;
 
-	dyn_dist_code.count = dyn_dist_count;
-	dyn_dist_code.symbol = dyn_dist_symbol;
+		errno_t err = huffman_decode(&state->len_code, bitbuf, bitlen,
+		    &symbol, &used);
+		if (err != EOK)
+			return err;
+
+		if (symbol < 256) {
+			/* Write out literal */
+			bits_drop(state, used);
+			window_put(state, symbol);
+			continue;
+		}
+
+		if (symbol == 256) {
+			/* End of block */
+			bits_drop(state, used);
+			state->mode = state->last ? MODE_DONE : MODE_HEADER;
+			return EOK;
+		}
+
+		/*
+		 * The match is decoded as a whole and its bits are dropped
+		 * only once they are all available.
+		 */
+
+		/* Compute length */
+		symbol -= 257;
+		if (symbol >= MAX_LEN)
+			return EINVAL;
+
+		if (used + lens_ext[symbol] > bitlen)
+			return EAGAIN;
+
+		size_t len = lens[symbol] +
+		    ((bitbuf >> used) & bits_mask(lens_ext[symbol]));
+		used += lens_ext[symbol];
+
+		/* Get distance */
+		unsigned int dused;
+		err = huffman_decode(&state->dist_code, bitbuf >> used,
+		    bitlen - used, &symbol, &dused);
+		if (err != EOK)
+			return err;
+
+		if (symbol >= MAX_DIST)
+			return EINVAL;
+
+		used += dused;
+		if (used + dists_ext[symbol] > bitlen)
+			return EAGAIN;
+
+		size_t dist = dists[symbol] +
+		    ((bitbuf >> used) & bits_mask(dists_ext[symbol]));
+		used += dists_ext[symbol];
+
+		if (dist > state->whave)
+			return ENOENT;
+
+		bits_drop(state, used);
+
+		/* Copy len bytes from distance bytes back */
+		window_copy(state, dist, len);
+	}
+}
+
+/** Set up tables for a `fixed codes' block
+ *
+ * @param state Inflate state.
+ *
+ */
+static void inflate_fixed(struct inflate_state *state)
+{
+	uint16_t count[MAX_HUFFMAN_BIT + 1];
+	size_t symbol;
+
+	for (symbol = 0; symbol < 144; symbol++)
+		state->length[symbol] = 8;
+	for (; symbol < 256; symbol++)
+		state->length[symbol] = 9;
+	for (; symbol < 280; symbol++)
+		state->length[symbol] = 7;
+	for (; symbol < MAX_FIXED_LITLEN; symbol++)
+		state->length[symbol] = 8;
+
+	(void) huffman_count(state->length, MAX_FIXED_LITLEN, count);
+	(void) huffman_construct(&state->len_code, state->length,
+	    MAX_FIXED_LITLEN, count);
+
+	/* Distance codes 30 and 31 are completing the code but invalid */
+	for (symbol = 0; symbol < MAX_FIXED_DIST; symbol++)
+		state->length[symbol] = 5;
+
+	(void) huffman_count(state->length, MAX_FIXED_DIST, count);
+	(void) huffman_construct(&state->dist_code, state->length,
+	    MAX_FIXED_DIST, count);
+
+	state->mode = MODE_CODES;
+}
+
+/** Decode table sizes of a `dynamic codes' block
+ *
+ * @param state Inflate state.
+ * @param strm  Inflate stream.
+ *
+ * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid data.
+ *
+ */
+static errno_t inflate_table(struct inflate_state *state,
+    inflate_stream_t *strm)
+{
+	bits_fill(state, strm);
+	if (state->bitlen < 14)
+		return EAGAIN;
 
 	/* Get number of bits in each table */
-	uint16_t nlen = get_bits(state, 5) + 257;
-	CHECK_OVERRUN(*state);
+	uint16_t bits;
+	(void) get_bits(state, strm, 5, &bits);
+	state->nlen = bits + 257;
 
-	uint16_t ndist = get_bits(state, 5) + 1;
-	CHECK_OVERRUN(*state);
+	(void) get_bits(state, strm, 5, &bits);
+	state->ndist = bits + 1;
 
-	uint16_t ncode = get_bits(state, 4) + 4;
-	CHECK_OVERRUN(*state);
+	(void) get_bits(state, strm, 4, &bits);
+	state->ncode = bits + 4;
 
-	if ((nlen > MAX_LITLEN) || (ndist > MAX_DIST) ||
-	    (ncode > MAX_ORDER))
+	if ((state->nlen > MAX_LITLEN) || (state->ndist > MAX_DIST) ||
+	    (state->ncode > MAX_ORDER))
 		return EINVAL;
 
-	/* Read code length code lengths */
-	uint16_t index;
-	for (index = 0; index < ncode; index++) {
-		length[order[index]] = get_bits(state, 3);
-		CHECK_OVERRUN(*state);
+	state->index = 0;
+	state->mode = MODE_CODELENS;
+	return EOK;
+}
+
+/** Read code length code lengths of a `dynamic codes' block
+ *
+ * @param state Inflate state.
+ * @param strm  Inflate stream.
+ *
+ * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid data.
+ *
+ */
+static errno_t inflate_codelens(struct inflate_state *state,
+    inflate_stream_t *strm)
+{
+	while (state->index < state->ncode) {
+		uint16_t len;
+		if (!get_bits(state, strm, 3, &len))
+			return EAGAIN;
+
+		state->length[order[state->index]] = len;
+		state->index++;
 	}
 
 	/* Set missing lengths to zero */
-	for (index = ncode; index < MAX_ORDER; index++)
-		length[order[index]] = 0;
+	for (; state->index < MAX_ORDER; state->index++)
+		state->length[order[state->index]] = 0;
 
 	/* Build Huffman code */
-	int16_t rc = huffman_construct(&dyn_len_code, length, MAX_ORDER);
-	if (rc != 0)
+	uint16_t count[MAX_HUFFMAN_BIT + 1];
+	if (huffman_count(state->length, MAX_ORDER, count) != 0)
 		return EINVAL;
 
-	/* Read length/literal and distance code length tables */
-	index = 0;
-	while (index < nlen + ndist) {
+	errno_t rc = huffman_construct(&state->clen_code, state->length,
+	    MAX_ORDER, count);
+	if (rc != EOK)
+		return rc;
+
+	state->index = 0;
+	state->mode = MODE_LENLENS;
+	return EOK;
+}
+
+/** Read literal/length and distance code lengths of a `dynamic codes' block
+ *
+ * @param state Inflate state.
+ * @param strm  Inflate stream.
+ *
+ * @return EOK on success.
+ * @return EAGAIN if more input is needed.
+ * @return EINVAL on invalid data.
+ *
+ */
+static errno_t inflate_lenlens(struct inflate_state *state,
+    inflate_stream_t *strm)
+{
+	uint16_t total = state->nlen + state->ndist;
+
+	while (state->index < total) {
+		bits_fill(state, strm);
+
 		uint16_t symbol;
-		errno_t err = huffman_decode(state, &dyn_len_code, &symbol);
+		unsigned int used;
+		errno_t err = huffman_decode(&state->clen_code, state->bitbuf,
+		    state->bitlen, &symbol, &used);
 		if (err != EOK)
-			return EOK;
+			return err;
 
 		if (symbol < 16) {
-			length[index] = symbol;
-			index++;
-		} else {
-			uint16_t len = 0;
-
-			if (symbol == 16) {
-				if (index == 0)
-					return EINVAL;
-
-				len = length[index - 1];
-				symbol = get_bits(state, 2) + 3;
-				CHECK_OVERRUN(*state);
-			} else if (symbol == 17) {
-				symbol = get_bits(state, 3) + 3;
-				CHECK_OVERRUN(*state);
-			} else {
-				symbol = get_bits(state, 7) + 11;
-				CHECK_OVERRUN(*state);
-			}
+			bits_drop(state, used);
+			state->length[state->index] = symbol;
+			state->index++;
+			continue;
+		}
 
-			if (index + symbol > nlen + ndist)
+		uint16_t len = 0;
+		unsigned int ext;
+		uint16_t base;
+
+		if (symbol == 16) {
+			if (state->index == 0)
 				return EINVAL;
 
-			while (symbol > 0) {
-				length[index] = len;
-				index++;
-				symbol--;
-			}
+			len = state->length[state->index - 1];
+			ext = 2;
+			base = 3;
+		} else if (symbol == 17) {
+			ext = 3;
+			base = 3;
+		} else {
+			ext = 7;
+			base = 11;
+		}
+
+		/* Drop the symbol only together with its repeat count */
+		if (used + ext > state->bitlen)
+			return EAGAIN;
+
+		uint16_t repeat = base +
+		    ((state->bitbuf >> used) & bits_mask(ext));
+		bits_drop(state, used + ext);
+
+		if (state->index + repeat > total)
+			return EINVAL;
+
+		while (repeat > 0) {
+			state->length[state->index] = len;
+			state->index++;
+			repeat--;
 		}
 	}
 
 	/* Check for end-of-block code */
-	if (length[256] == 0)
+	if (state->length[256] == 0)
 		return EINVAL;
 
 	/* Build Huffman tables for literal/length codes */
-	rc = huffman_construct(&dyn_len_code, length, nlen);
-	if ((rc < 0) || ((rc > 0) && (dyn_len_code.count[0] + 1 != nlen)))
+	uint16_t count[MAX_HUFFMAN_BIT + 1];
+	int16_t rc = huffman_count(state->length, state->nlen, count);
+	if ((rc < 0) || ((rc > 0) && (count[0] + 1 != state->nlen)))
+		return EINVAL;
+
+	if (huffman_construct(&state->len_code, state->length, state->nlen,
+	    count) != EOK)
 		return EINVAL;
 
 	/* Build Huffman tables for distance codes */
-	rc = huffman_construct(&dyn_dist_code, length + nlen, ndist);
-	if ((rc < 0) || ((rc > 0) && (dyn_dist_code.count[0] + 1 != ndist)))
+	rc = huffman_count(state->length + state->nlen, state->ndist, count);
+	if ((rc < 0) || ((rc > 0) && (count[0] + 1 != state->ndist)))
+		return EINVAL;
+
+	if (huffman_construct(&state->dist_code, state->length + state->nlen,
+	    state->ndist, count) != EOK)
 		return EINVAL;
 
-	return inflate_codes(state, &dyn_len_code, &dyn_dist_code);
+	state->mode = MODE_CODES;
+	return EOK;
+}
+
+/** Run the decoder until it needs more input or output space
+ *
+ * @param state Inflate state.
+ * @param strm  Inflate stream.
+ *
+ * @return EOK at the end of the last block.
+ * @return EAGAIN if more input is needed.
+ * @return ENOSPC if the window needs to be flushed.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
+ *
+ */
+static errno_t inflate_run(struct inflate_state *state, inflate_stream_t *strm)
+{
+	errno_t ret = EOK;
+
+	while ((ret == EOK) && (state->mode != MODE_DONE)) {
+		uint16_t hdr;
+
+		switch (state->mode) {
+		case MODE_HEADER:
+			/* Last block is indicated by a non-zero bit */
+			if (!get_bits(state, strm, 3, &hdr))
+				return EAGAIN;
+
+			state->last = (hdr & 1) != 0;
+
+			/* Block type */
+			switch (hdr >> 1) {
+			case 0:
+				state->mode = MODE_STORED;
+				break;
+			case 1:
+				inflate_fixed(state);
+				break;
+			case 2:
+				state->mode = MODE_TABLE;
+				break;
+			default:
+				ret = EINVAL;
+			}
+			break;
+		case MODE_STORED:
+			ret = inflate_stored(state, strm);
+			break;
+		case MODE_COPY:
+			ret = inflate_copy(state, strm);
+			break;
+		case MODE_TABLE:
+			ret = inflate_table(state, strm);
+			break;
+		case MODE_CODELENS:
+			ret = inflate_codelens(state, strm);
+			break;
+		case MODE_LENLENS:
+			ret = inflate_lenlens(state, strm);
+			break;
+		case MODE_CODES:
+			ret = inflate_codes(state, strm);
+			break;
+		case MODE_DONE:
+			break;
+		}
+	}
+
+	return ret;
+}
+
+/** Initialize inflate stream
+ *
+ * The caller sets up the input and output buffers of the stream
+ * before calling inflate_step().
+ *
+ * @param strm Inflate stream.
+ *
+ * @return EOK on success.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t inflate_init(inflate_stream_t *strm)
+{
+	struct inflate_state *state = malloc(sizeof(struct inflate_state));
+	if (state == NULL)
+		return ENOMEM;
+
+	state->mode = MODE_HEADER;
+	state->last = false;
+	state->error = EOK;
+
+	state->bitbuf = 0;
+	state->bitlen = 0;
+
+	state->len_code.table = state->len_table;
+	state->len_code.size = LEN_TABLE_SIZE;
+	state->len_code.root = LEN_ROOT_BITS;
+
+	state->dist_code.table = state->dist_table;
+	state->dist_code.size = DIST_TABLE_SIZE;
+	state->dist_code.root = DIST_ROOT_BITS;
+
+	state->clen_code.table = state->clen_table;
+	state->clen_code.size = CLEN_TABLE_SIZE;
+	state->clen_code.root = CLEN_ROOT_BITS;
+
+	state->whave = 0;
+	state->wflushed = 0;
+
+	strm->total_in = 0;
+	strm->total_out = 0;
+	strm->state = state;
+	return EOK;
+}
+
+/** Decompress as much data as possible
+ *
+ * Consumes input from and produces output to the buffers of the stream,
+ * advancing them. Input following the end of the deflate stream is left
+ * unconsumed.
+ *
+ * @param strm Inflate stream.
+ *
+ * @return EOK at the end of the deflate stream with all output produced.
+ * @return EAGAIN if more input or output space is needed to continue.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
+ *
+ */
+errno_t inflate_step(inflate_stream_t *strm)
+{
+	struct inflate_state *state = strm->state;
+	size_t avail_in = strm->avail_in;
+	errno_t ret;
+
+	if (state->error != EOK)
+		return state->error;
+
+	while (true) {
+		window_flush(state, strm);
+		ret = inflate_run(state, strm);
+		if ((ret != ENOSPC) || (strm->avail_out == 0))
+			break;
+	}
+
+	/*
+	 * When out of input, all the bits in the bit buffer belong to the
+	 * pending symbol. Otherwise the decoder may have loaded whole bytes
+	 * ahead, which are returned to the input. The bits left from the
+	 * previous call are always used up by then, so the bytes come from
+	 * the current input buffer.
+	 */
+	if (ret != EAGAIN) {
+		size_t unused = min(state->bitlen >> 3,
+		    avail_in - strm->avail_in);
+
+		strm->next_in -= unused;
+		strm->avail_in += unused;
+		state->bitlen -= unused << 3;
+		state->bitbuf &= bits_mask(state->bitlen);
+	}
+
+	if (ret == ENOSPC)
+		ret = EAGAIN;
+
+	if (ret == EOK) {
+		window_flush(state, strm);
+		if (state->whave != state->wflushed)
+			ret = EAGAIN;
+	}
+
+	strm->total_in += avail_in - strm->avail_in;
+
+	if ((ret != EOK) && (ret != EAGAIN))
+		state->error = ret;
+
+	return ret;
+}
+
+/** Release inflate stream
+ *
+ * @param strm Inflate stream.
+ *
+ */
+void inflate_end(inflate_stream_t *strm)
+{
+	free(strm->state);
+	strm->state = NULL;
 }
 
 /** Inflate data
@@ -622,53 +1172,26 @@ static errno_t inflate_dynamic(inflate_state_t *state)
  * @return ENOENT on distance too large.
  * @return EINVAL on invalid Huffman code or invalid deflate data.
  * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @return ENOMEM on output buffer overrun or if out of memory.
  *
  */
 errno_t inflate(void *src, size_t srclen, void *dest, size_t destlen)
 {
-	/* Initialize the state */
-	inflate_state_t state;
+	inflate_stream_t strm;
 
-	state.dest = (uint8_t *) dest;
-	state.destlen = destlen;
-	state.destcnt = 0;
+	errno_t ret = inflate_init(&strm);
+	if (ret != EOK)
+		return ret;
 
-	state.src = (uint8_t *) src;
-	state.srclen = srclen;
-	state.srccnt = 0;
+	strm.next_in = src;
+	strm.avail_in = srclen;
+	strm.next_out = dest;
+	strm.avail_out = destlen;
 
-	state.bitbuf = 0;
-	state.bitlen = 0;
-
-	state.overrun = false;
-
-	uint16_t last;
-	errno_t ret = EOK;
-
-	do {
-		/* Last block is indicated by a non-zero bit */
-		last = get_bits(&state, 1);
-		CHECK_OVERRUN(state);
-
-		/* Block type */
-		uint16_t type = get_bits(&state, 2);
-		CHECK_OVERRUN(state);
-
-		switch (type) {
-		case 0:
-			ret = inflate_stored(&state);
-			break;
-		case 1:
-			ret = inflate_fixed(&state, &len_code, &dist_code);
-			break;
-		case 2:
-			ret = inflate_dynamic(&state);
-			break;
-		default:
-			ret = EINVAL;
-		}
-	} while ((!last) && (ret == 0));
+	ret = inflate_step(&strm);
+	if (ret == EAGAIN)
+		ret = (strm.avail_out == 0) ? ENOMEM : ELIMIT;
 
+	inflate_end(&strm);
 	return ret;
 }
@@ -29,7 +29,33 @@
 #ifndef LIBCOMPRESS_INFLATE_H_
 #define LIBCOMPRESS_INFLATE_H_
 
+#include <errno.h>
 #include <stddef.h>
+#include <stdint.h>
+
+struct inflate_state;
+
+/** Inflate stream
+ *
+ * The caller points the stream to its input and output buffers and calls
+ * inflate_step() for as long as it returns EAGAIN, supplying more input
+ * or output space in between.
+ */
+typedef struct {
+	const uint8_t *next_in;  /**< Next input byte */
+	size_t avail_in;         /**< Number of bytes available at next_in */
+	size_t total_in;         /**< Total number of input bytes consumed */
+
+	uint8_t *next_out;       /**< Next output byte */
+	size_t avail_out;        /**< Free space at next_out */
+	size_t total_out;        /**< Total number of bytes output */
+
+	struct inflate_state *state;  /**< Internal decoder state */
+} inflate_stream_t;
+
+extern errno_t inflate_init(inflate_stream_t *);
+extern errno_t inflate_step(inflate_stream_t *);
+extern void inflate_end(inflate_stream_t *);
 
 extern errno_t inflate(void *, size_t, void *, size_t);
 
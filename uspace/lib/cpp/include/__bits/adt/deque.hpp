@@ -1215,4 +1215,18 @@ namespace std
     }
 }
 
+namespace std::pmr
+{
+    /**
+     * Aliases using polymorphic memory resources,
+     * see <memory_resource>.
+     */
+
+    template<class T>
+    class polymorphic_allocator;
+
+    template<class T>
+    using deque = std::deque<T, polymorphic_allocator<T>>;
+}
+
 #endif
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_MAP
+#define LIBCPP_BITS_ADT_FLAT_HASH_MAP
+
+#include <__bits/adt/flat_hash_table.hpp>
+#include <__bits/adt/key_extractors.hpp>
+#include <functional>
+#include <initializer_list>
+#include <utility>
+
+/**
+ * HelenOS extension: unordered associative containers with
+ * open addressing (see aux::flat_hash_table). Values are stored
+ * in the table itself, so inserting into a table with free
+ * room does not allocate and lookups do not chase pointers.
+ * In exchange, any insertion may invalidate all iterators and
+ * references, and there is no bucket interface.
+ */
+namespace helenos
+{
+    template<
+        class Key, class Value,
+        class Hash = std::hash<Key>,
+        class Pred = std::equal_to<Key>
+    >
+    class flat_hash_map
+    {
+        public:
+            using key_type    = Key;
+            using mapped_type = Value;
+            using value_type  = std::pair<const key_type, mapped_type>;
+            using hasher      = Hash;
+            using key_equal   = Pred;
+            using reference   = value_type&;
+            using size_type   = std::size_t;
+
+        private:
+            using table_type = std::aux::flat_hash_table<
+                value_type, key_type,
+                std::aux::key_value_key_extractor<key_type, mapped_type>,
+                hasher, key_equal
+            >;
+
+        public:
+            using iterator       = typename table_type::iterator;
+            using const_iterator = typename table_type::const_iterator;
+
+            flat_hash_map()
+                : table_{}
+            { /* DUMMY BODY */ }
+
+            explicit flat_hash_map(size_type count, const hasher& hf = hasher{},
+                                   const key_equal& eql = key_equal{})
+                : table_{count, hf, eql}
+            { /* DUMMY BODY */ }
+
+            flat_hash_map(std::initializer_list<value_type> init)
+                : table_{init.size()}
+            {
+                insert(init.begin(), init.end());
+            }
+
+            iterator begin() noexcept
+            {
+                return table_.begin();
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return table_.begin();
+            }
+
+            iterator end() noexcept
+            {
+                return table_.end();
+            }
+
+            const_iterator end() const noexcept
+            {
+                return table_.end();
+            }
+
+            const_iterator cbegin() const noexcept
+            {
+                return table_.begin();
+            }
+
+            const_iterator cend() const noexcept
+            {
+                return table_.end();
+            }
+
+            bool empty() const noexcept
+            {
+                return table_.empty();
+            }
+
+            size_type size() const noexcept
+            {
+                return table_.size();
+            }
+
+            void clear() noexcept
+            {
+                table_.clear();
+            }
+
+            template<class... Args>
+            std::pair<iterator, bool> emplace(Args&&... args)
+            {
+                return table_.emplace(std::forward<Args>(args)...);
+            }
+
+            std::pair<iterator, bool> insert(const value_type& val)
+            {
+                return table_.emplace_key(val.first, val);
+            }
+
+            std::pair<iterator, bool> insert(value_type&& val)
+            {
+                return table_.emplace_key(val.first, std::move(val));
+            }
+
+            template<class InputIterator>
+            void insert(InputIterator first, InputIterator last)
+            {
+                while (first != last)
+                    insert(*first++);
+            }
+
+            void insert(std::initializer_list<value_type> init)
+            {
+                insert(init.begin(), init.end());
+            }
+
+            template<class... Args>
+            std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
+            {
+                return table_.emplace_key(
+                    key, key, mapped_type(std::forward<Args>(args)...)
+                );
+            }
+
+            template<class... Args>
+            std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
+            {
+                return table_.emplace_key(
+                    key, std::move(key), mapped_type(std::forward<Args>(args)...)
+                );
+            }
+
+            mapped_type& operator[](const key_type& key)
+            {
+                return try_emplace(key).first->second;
+            }
+
+            mapped_type& operator[](key_type&& key)
+            {
+                return try_emplace(std::move(key)).first->second;
+            }
+
+            iterator erase(const_iterator position)
+            {
+                return table_.erase(position);
+            }
+
+            size_type erase(const key_type& key)
+            {
+                return table_.erase(key);
+            }
+
+            void swap(flat_hash_map& other)
+            {
+                table_.swap(other.table_);
+            }
+
+            iterator find(const key_type& key)
+            {
+                return table_.find(key);
+            }
+
+            const_iterator find(const key_type& key) const
+            {
+                return table_.find(key);
+            }
+
+            size_type count(const key_type& key) const
+            {
+                return table_.find(key) != table_.end() ? 1 : 0;
+            }
+
+            bool contains(const key_type& key) const
+            {
+                return table_.find(key) != table_.end();
+            }
+
+            size_type capacity() const noexcept
+            {
+                return table_.capacity();
+            }
+
+            void reserve(size_type count)
+            {
+                table_.reserve(count);
+            }
+
+            hasher hash_function() const
+            {
+                return table_.hash_function();
+            }
+
+            key_equal key_eq() const
+            {
+                return table_.key_eq();
+            }
+
+        private:
+            table_type table_;
+    };
+
+    template<
+        class Key,
+        class Hash = std::hash<Key>,
+        class Pred = std::equal_to<Key>
+    >
+    class flat_hash_set
+    {
+        public:
+            using key_type   = Key;
+            using value_type = Key;
+            using hasher     = Hash;
+            using key_equal  = Pred;
+            using size_type  = std::size_t;
+
+        private:
+            using table_type = std::aux::flat_hash_table<
+                value_type, key_type,
+                std::aux::key_no_value_key_extractor<key_type>,
+                hasher, key_equal
+            >;
+
+        public:
+            /**
+             * Note: Like in unordered_set, the elements
+             *       cannot be modified through iterators.
+             */
+            using iterator       = typename table_type::const_iterator;
+            using const_iterator = typename table_type::const_iterator;
+
+            flat_hash_set()
+                : table_{}
+            { /* DUMMY BODY */ }
+
+            explicit flat_hash_set(size_type count, const hasher& hf = hasher{},
+                                   const key_equal& eql = key_equal{})
+                : table_{count, hf, eql}
+            { /* DUMMY BODY */ }
+
+            flat_hash_set(std::initializer_list<value_type> init)
+                : table_{init.size()}
+            {
+                insert(init.begin(), init.end());
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return table_.begin();
+            }
+
+            const_iterator end() const noexcept
+            {
+                return table_.end();
+            }
+
+            const_iterator cbegin() const noexcept
+            {
+                return table_.begin();
+            }
+
+            const_iterator cend() const noexcept
+            {
+                return table_.end();
+            }
+
+            bool empty() const noexcept
+            {
+                return table_.empty();
+            }
+
+            size_type size() const noexcept
+            {
+                return table_.size();
+            }
+
+            void clear() noexcept
+            {
+                table_.clear();
+            }
+
+            template<class... Args>
+            std::pair<iterator, bool> emplace(Args&&... args)
+            {
+                return table_.emplace(std::forward<Args>(args)...);
+            }
+
+            std::pair<iterator, bool> insert(const value_type& val)
+            {
+                return table_.emplace_key(val, val);
+            }
+
+            std::pair<iterator, bool> insert(value_type&& val)
+            {
+                return table_.emplace_key(val, std::move(val));
+            }
+
+            template<class InputIterator>
+            void insert(InputIterator first, InputIterator last)
+            {
+                while (first != last)
+                    insert(*first++);
+            }
+
+            void insert(std::initializer_list<value_type> init)
+            {
+                insert(init.begin(), init.end());
+            }
+
+            iterator erase(const_iterator position)
+            {
+                return table_.erase(position);
+            }
+
+            size_type erase(const key_type& key)
+            {
+                return table_.erase(key);
+            }
+
+            void swap(flat_hash_set& other)
+            {
+                table_.swap(other.table_);
+            }
+
+            const_iterator find(const key_type& key) const
+            {
+                return table_.find(key);
+            }
+
+            size_type count(const key_type& key) const
+            {
+                return table_.find(key) != table_.end() ? 1 : 0;
+            }
+
+            bool contains(const key_type& key) const
+            {
+                return table_.find(key) != table_.end();
+            }
+
+            size_type capacity() const noexcept
+            {
+                return table_.capacity();
+            }
+
+            void reserve(size_type count)
+            {
+                table_.reserve(count);
+            }
+
+            hasher hash_function() const
+            {
+                return table_.hash_function();
+            }
+
+            key_equal key_eq() const
+            {
+                return table_.key_eq();
+            }
+
+        private:
+            table_type table_;
+    };
+
+    template<class Key, class Value, class Hash, class Pred>
+    void swap(flat_hash_map<Key, Value, Hash, Pred>& lhs,
+              flat_hash_map<Key, Value, Hash, Pred>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+    template<class Key, class Hash, class Pred>
+    void swap(flat_hash_set<Key, Hash, Pred>& lhs,
+              flat_hash_set<Key, Hash, Pred>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+}
+
+#endif
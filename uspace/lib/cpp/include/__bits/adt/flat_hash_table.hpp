@@ -0,0 +1,599 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+#define LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * Open addressing hash table in the style of SwissTable.
+     *
+     * Every slot has a control byte, which is either empty, deleted
+     * or contains the lowest 7 bits of the hash of the value in the
+     * slot. Lookups probe a group of 8 control bytes at once as a
+     * single 64-bit word, so only slots whose control byte matches
+     * the hash are compared, and a group with an empty byte ends
+     * the probe sequence.
+     *
+     * The first group of control bytes is mirrored after the last
+     * one, so that a group can be loaded from any position without
+     * wrapping around. The capacity is a power of two and at most
+     * 7/8 of the slots, counting the deleted ones, are used.
+     */
+
+    struct flat_hash_group
+    {
+        static constexpr size_t width{8};
+
+        static constexpr uint8_t empty{0x80};
+        static constexpr uint8_t deleted{0xFE};
+
+        static constexpr uint64_t lsbs{0x0101010101010101ULL};
+        static constexpr uint64_t msbs{0x8080808080808080ULL};
+
+        explicit flat_hash_group(const uint8_t* pos)
+        {
+            memcpy(&ctrl, pos, sizeof(ctrl));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            ctrl = __builtin_bswap64(ctrl);
+#endif
+        }
+
+        /**
+         * Note: This can report false positives, but only
+         *       for full slots, which are compared anyway.
+         */
+        uint64_t match(uint8_t h2) const noexcept
+        {
+            auto x = ctrl ^ (lsbs * h2);
+
+            return (x - lsbs) & ~x & msbs;
+        }
+
+        uint64_t match_empty() const noexcept
+        {
+            return ctrl & ~(ctrl << 6) & msbs;
+        }
+
+        uint64_t match_empty_or_deleted() const noexcept
+        {
+            return ctrl & ~(ctrl << 7) & msbs;
+        }
+
+        static size_t lowest(uint64_t mask) noexcept
+        {
+            return static_cast<size_t>(__builtin_ctzll(mask)) / 8;
+        }
+
+        static uint64_t next(uint64_t mask) noexcept
+        {
+            return mask & (mask - 1);
+        }
+
+        static bool is_full(uint8_t c) noexcept
+        {
+            return (c & 0x80) == 0;
+        }
+
+        uint64_t ctrl;
+    };
+
+    template<class Value, class Reference, class Pointer>
+    class flat_hash_table_iterator
+    {
+        public:
+            using value_type        = Value;
+            using reference         = Reference;
+            using pointer           = Pointer;
+            using difference_type   = ptrdiff_t;
+            using iterator_category = forward_iterator_tag;
+
+            flat_hash_table_iterator(Value* slot = nullptr,
+                                     const uint8_t* ctrl = nullptr,
+                                     const uint8_t* ctrl_end = nullptr)
+                : slot_{slot}, ctrl_{ctrl}, ctrl_end_{ctrl_end}
+            {
+                skip_();
+            }
+
+            template<class R, class P>
+            flat_hash_table_iterator(const flat_hash_table_iterator<Value, R, P>& other)
+                : slot_{other.slot_}, ctrl_{other.ctrl_}, ctrl_end_{other.ctrl_end_}
+            { /* DUMMY BODY */ }
+
+            reference operator*() const
+            {
+                return *slot_;
+            }
+
+            pointer operator->() const
+            {
+                return slot_;
+            }
+
+            flat_hash_table_iterator& operator++()
+            {
+                ++slot_;
+                ++ctrl_;
+                skip_();
+
+                return *this;
+            }
+
+            flat_hash_table_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+            template<class R, class P>
+            bool operator==(const flat_hash_table_iterator<Value, R, P>& other) const
+            {
+                return slot_ == other.slot_;
+            }
+
+            template<class R, class P>
+            bool operator!=(const flat_hash_table_iterator<Value, R, P>& other) const
+            {
+                return slot_ != other.slot_;
+            }
+
+        private:
+            Value* slot_;
+            const uint8_t* ctrl_;
+            const uint8_t* ctrl_end_;
+
+            template<class V, class R, class P>
+            friend class flat_hash_table_iterator;
+
+            template<class V, class K, class KE, class H, class KEq>
+            friend class flat_hash_table;
+
+            void skip_()
+            {
+                while (ctrl_ != ctrl_end_ && !flat_hash_group::is_full(*ctrl_))
+                {
+                    ++slot_;
+                    ++ctrl_;
+                }
+            }
+    };
+
+    template<
+        class Value, class Key, class KeyExtractor,
+        class Hasher, class KeyEq
+    >
+    class flat_hash_table
+    {
+        public:
+            using value_type     = Value;
+            using key_type       = Key;
+            using size_type      = size_t;
+            using hasher         = Hasher;
+            using key_equal      = KeyEq;
+            using key_extract    = KeyExtractor;
+
+            using iterator       = flat_hash_table_iterator<
+                value_type, value_type&, value_type*
+            >;
+            using const_iterator = flat_hash_table_iterator<
+                value_type, const value_type&, const value_type*
+            >;
+
+            flat_hash_table(size_type capacity = 0, const hasher& hf = hasher{},
+                            const key_equal& eql = key_equal{})
+                : slots_{}, ctrl_{}, capacity_{}, size_{}, growth_left_{},
+                  hasher_{hf}, key_eq_{eql}, key_extractor_{}
+            {
+                reserve(capacity);
+            }
+
+            flat_hash_table(const flat_hash_table& other)
+                : flat_hash_table{other.size_, other.hasher_, other.key_eq_}
+            {
+                for (const auto& x: other)
+                    insert_new_(hash_(key_extractor_(x)), x);
+            }
+
+            flat_hash_table(flat_hash_table&& other)
+                : slots_{other.slots_}, ctrl_{other.ctrl_},
+                  capacity_{other.capacity_}, size_{other.size_},
+                  growth_left_{other.growth_left_}, hasher_{move(other.hasher_)},
+                  key_eq_{move(other.key_eq_)}, key_extractor_{move(other.key_extractor_)}
+            {
+                other.slots_ = nullptr;
+                other.ctrl_ = nullptr;
+                other.capacity_ = size_type{};
+                other.size_ = size_type{};
+                other.growth_left_ = size_type{};
+            }
+
+            flat_hash_table& operator=(const flat_hash_table& other)
+            {
+                flat_hash_table tmp{other};
+                swap(tmp);
+
+                return *this;
+            }
+
+            flat_hash_table& operator=(flat_hash_table&& other)
+            {
+                flat_hash_table tmp{move(other)};
+                swap(tmp);
+
+                return *this;
+            }
+
+            ~flat_hash_table()
+            {
+                destroy_slots_();
+                ::operator delete(slots_);
+            }
+
+            iterator begin() noexcept
+            {
+                return iterator{slots_, ctrl_, ctrl_ + capacity_};
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return const_iterator{slots_, ctrl_, ctrl_ + capacity_};
+            }
+
+            iterator end() noexcept
+            {
+                return iterator{slots_ + capacity_, ctrl_ + capacity_, ctrl_ + capacity_};
+            }
+
+            const_iterator end() const noexcept
+            {
+                return const_iterator{slots_ + capacity_, ctrl_ + capacity_, ctrl_ + capacity_};
+            }
+
+            bool empty() const noexcept
+            {
+                return size_ == 0;
+            }
+
+            size_type size() const noexcept
+            {
+                return size_;
+            }
+
+            size_type capacity() const noexcept
+            {
+                return capacity_;
+            }
+
+            void clear() noexcept
+            {
+                destroy_slots_();
+
+                if (capacity_ > 0)
+                    memset(ctrl_, flat_hash_group::empty, capacity_ + flat_hash_group::width);
+
+                size_ = 0;
+                growth_left_ = max_growth_(capacity_);
+            }
+
+            /**
+             * Inserts the value constructed from args unless there
+             * already is a value with the given key.
+             */
+            template<class... Args>
+            pair<iterator, bool> emplace_key(const key_type& key, Args&&... args)
+            {
+                auto h = hash_(key);
+                auto idx = find_(key, h);
+                if (idx != capacity_)
+                    return make_pair(iterator_at_(idx), false);
+
+                if (growth_left_ == 0)
+                {
+                    /**
+                     * Note: Growing invalidates references to the values
+                     *       in the table, which the arguments may use.
+                     */
+                    value_type value(forward<Args>(args)...);
+                    rehash_for_insert_();
+                    idx = insert_new_(h, move(value));
+                }
+                else
+                    idx = insert_new_(h, forward<Args>(args)...);
+
+                return make_pair(iterator_at_(idx), true);
+            }
+
+            template<class... Args>
+            pair<iterator, bool> emplace(Args&&... args)
+            {
+                value_type value(forward<Args>(args)...);
+
+                auto h = hash_(key_extractor_(value));
+                auto idx = find_(key_extractor_(value), h);
+                if (idx != capacity_)
+                    return make_pair(iterator_at_(idx), false);
+
+                if (growth_left_ == 0)
+                    rehash_for_insert_();
+                idx = insert_new_(h, move(value));
+
+                return make_pair(iterator_at_(idx), true);
+            }
+
+            iterator find(const key_type& key)
+            {
+                return iterator_at_(find_(key, hash_(key)));
+            }
+
+            const_iterator find(const key_type& key) const
+            {
+                return const_iterator_at_(find_(key, hash_(key)));
+            }
+
+            iterator erase(const_iterator it)
+            {
+                auto idx = static_cast<size_type>(it.slot_ - slots_);
+                erase_at_(idx);
+
+                return iterator_at_(idx + 1);
+            }
+
+            size_type erase(const key_type& key)
+            {
+                auto idx = find_(key, hash_(key));
+                if (idx == capacity_)
+                    return 0;
+
+                erase_at_(idx);
+
+                return 1;
+            }
+
+            void reserve(size_type count)
+            {
+                if (count <= size_ + growth_left_)
+                    return;
+
+                auto capacity = flat_hash_group::width;
+                while (max_growth_(capacity) < count)
+                    capacity *= 2;
+
+                resize_(capacity);
+            }
+
+            void swap(flat_hash_table& other)
+            {
+                std::swap(slots_, other.slots_);
+                std::swap(ctrl_, other.ctrl_);
+                std::swap(capacity_, other.capacity_);
+                std::swap(size_, other.size_);
+                std::swap(growth_left_, other.growth_left_);
+                std::swap(hasher_, other.hasher_);
+                std::swap(key_eq_, other.key_eq_);
+            }
+
+            hasher hash_function() const
+            {
+                return hasher_;
+            }
+
+            key_equal key_eq() const
+            {
+                return key_eq_;
+            }
+
+        private:
+            value_type* slots_;
+            uint8_t* ctrl_;
+            size_type capacity_;
+            size_type size_;
+            size_type growth_left_;
+            hasher hasher_;
+            key_equal key_eq_;
+            key_extract key_extractor_;
+
+            static size_type max_growth_(size_type capacity) noexcept
+            {
+                return capacity - capacity / 8;
+            }
+
+            /**
+             * The user hash is mixed, because the lowest bits are
+             * used as control bytes and a hash like the identity
+             * would put consecutive keys to the same group.
+             */
+            size_type hash_(const key_type& key) const
+            {
+                auto h = static_cast<uint64_t>(hasher_(key));
+                h *= 0x9E3779B97F4A7C15ULL;
+
+                return static_cast<size_type>(h ^ (h >> 32));
+            }
+
+            static uint8_t h2_(size_type h) noexcept
+            {
+                return static_cast<uint8_t>(h & 0x7F);
+            }
+
+            void set_ctrl_(size_type idx, uint8_t c) noexcept
+            {
+                ctrl_[idx] = c;
+                if (idx < flat_hash_group::width)
+                    ctrl_[capacity_ + idx] = c;
+            }
+
+            iterator iterator_at_(size_type idx) noexcept
+            {
+                return iterator{slots_ + idx, ctrl_ + idx, ctrl_ + capacity_};
+            }
+
+            const_iterator const_iterator_at_(size_type idx) const noexcept
+            {
+                return const_iterator{slots_ + idx, ctrl_ + idx, ctrl_ + capacity_};
+            }
+
+            size_type find_(const key_type& key, size_type h) const
+            {
+                if (capacity_ == 0)
+                    return capacity_;
+
+                auto mask = capacity_ - 1;
+                auto pos = (h >> 7) & mask;
+                size_type step{};
+
+                while (true)
+                {
+                    flat_hash_group group{ctrl_ + pos};
+
+                    for (auto m = group.match(h2_(h)); m; m = flat_hash_group::next(m))
+                    {
+                        auto idx = (pos + flat_hash_group::lowest(m)) & mask;
+                        if (key_eq_(key_extractor_(slots_[idx]), key))
+                            return idx;
+                    }
+
+                    if (group.match_empty())
+                        return capacity_;
+
+                    step += flat_hash_group::width;
+                    pos = (pos + step) & mask;
+                }
+            }
+
+            size_type find_free_(size_type h) const noexcept
+            {
+                auto mask = capacity_ - 1;
+                auto pos = (h >> 7) & mask;
+                size_type step{};
+
+                while (true)
+                {
+                    flat_hash_group group{ctrl_ + pos};
+
+                    auto m = group.match_empty_or_deleted();
+                    if (m)
+                        return (pos + flat_hash_group::lowest(m)) & mask;
+
+                    step += flat_hash_group::width;
+                    pos = (pos + step) & mask;
+                }
+            }
+
+            /**
+             * Inserts a value whose key is known not to be in the table,
+             * which must have room for it.
+             */
+            template<class... Args>
+            size_type insert_new_(size_type h, Args&&... args)
+            {
+                auto idx = find_free_(h);
+                if (ctrl_[idx] == flat_hash_group::empty)
+                    --growth_left_;
+
+                ::new(static_cast<void*>(slots_ + idx)) value_type(forward<Args>(args)...);
+                set_ctrl_(idx, h2_(h));
+                ++size_;
+
+                return idx;
+            }
+
+            void erase_at_(size_type idx)
+            {
+                slots_[idx].~value_type();
+                set_ctrl_(idx, flat_hash_group::deleted);
+                --size_;
+            }
+
+            void destroy_slots_() noexcept
+            {
+                for (size_type i = 0; i < capacity_; ++i)
+                {
+                    if (flat_hash_group::is_full(ctrl_[i]))
+                        slots_[i].~value_type();
+                }
+            }
+
+            /**
+             * Makes room for one value, either by getting rid of
+             * the deleted slots or by doubling the capacity.
+             */
+            void rehash_for_insert_()
+            {
+                if (capacity_ == 0)
+                    resize_(flat_hash_group::width);
+                else if (size_ <= max_growth_(capacity_) / 2)
+                    resize_(capacity_);
+                else
+                    resize_(capacity_ * 2);
+            }
+
+            void resize_(size_type capacity)
+            {
+                auto old_slots = slots_;
+                auto old_ctrl = ctrl_;
+                auto old_capacity = capacity_;
+
+                auto bytes = capacity * sizeof(value_type) +
+                             capacity + flat_hash_group::width;
+                slots_ = static_cast<value_type*>(::operator new(bytes));
+                ctrl_ = reinterpret_cast<uint8_t*>(slots_ + capacity);
+                capacity_ = capacity;
+
+                memset(ctrl_, flat_hash_group::empty, capacity + flat_hash_group::width);
+                growth_left_ = max_growth_(capacity) - size_;
+
+                for (size_type i = 0; i < old_capacity; ++i)
+                {
+                    if (!flat_hash_group::is_full(old_ctrl[i]))
+                        continue;
+
+                    auto h = hash_(key_extractor_(old_slots[i]));
+                    auto idx = find_free_(h);
+
+                    ::new(static_cast<void*>(slots_ + idx)) value_type(move(old_slots[i]));
+                    set_ctrl_(idx, h2_(h));
+                    old_slots[i].~value_type();
+                }
+
+                ::operator delete(old_slots);
+            }
+    };
+}
+
+#endif
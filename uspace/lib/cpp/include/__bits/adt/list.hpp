@@ -1200,4 +1200,18 @@ namespace std
     }
 }
 
+namespace std::pmr
+{
+    /**
+     * Aliases using polymorphic memory resources,
+     * see <memory_resource>.
+     */
+
+    template<class T>
+    class polymorphic_allocator;
+
+    template<class T>
+    using list = std::list<T, polymorphic_allocator<T>>;
+}
+
 #endif
@@ -62,18 +62,23 @@ namespace std
             using size_type       = size_t;
             using difference_type = ptrdiff_t;
 
-            using node_type = aux::rbtree_single_node<value_type>;
+        private:
+            using tree_node_type = aux::rbtree_single_node<value_type>;
 
+        public:
             using iterator             = aux::rbtree_iterator<
-                value_type, reference, pointer, size_type, node_type
+                value_type, reference, pointer, size_type, tree_node_type
             >;
             using const_iterator       = aux::rbtree_const_iterator<
-                value_type, const_reference, const_pointer, size_type, node_type
+                value_type, const_reference, const_pointer, size_type, tree_node_type
             >;
 
             using reverse_iterator       = std::reverse_iterator<iterator>;
             using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+            using node_type = aux::map_node_handle<tree_node_type, allocator_type>;
+            using insert_return_type = aux::node_insert_return<iterator, node_type>;
+
             class value_compare
             {
                 friend class map;
@@ -106,7 +111,7 @@ namespace std
 
             explicit map(const key_compare& comp,
                          const allocator_type& alloc = allocator_type{})
-                : tree_{comp}, allocator_{alloc}
+                : tree_{comp, alloc}
             { /* DUMMY BODY */ }
 
             template<class InputIterator>
@@ -119,23 +124,23 @@ namespace std
             }
 
             map(const map& other)
-                : map{other, other.allocator_}
+                : tree_{other.tree_}
             { /* DUMMY BODY */ }
 
             map(map&& other)
-                : tree_{move(other.tree_)}, allocator_{move(other.allocator_)}
+                : tree_{move(other.tree_)}
             { /* DUMMY BODY */ }
 
             explicit map(const allocator_type& alloc)
-                : tree_{}, allocator_{alloc}
+                : tree_{key_compare{}, alloc}
             { /* DUMMY BODY */ }
 
             map(const map& other, const allocator_type& alloc)
-                : tree_{other.tree_}, allocator_{alloc}
+                : tree_{other.tree_, alloc}
             { /* DUMMY BODY */ }
 
             map(map&& other, const allocator_type& alloc)
-                : tree_{move(other.tree_)}, allocator_{alloc}
+                : tree_{move(other.tree_), alloc}
             { /* DUMMY BODY */ }
 
             map(initializer_list<value_type> init,
@@ -163,7 +168,6 @@ namespace std
             map& operator=(const map& other)
             {
                 tree_ = other.tree_;
-                allocator_ = other.allocator_;
 
                 return *this;
             }
@@ -173,7 +177,6 @@ namespace std
                          is_nothrow_move_assignable<key_compare>::value)
             {
                 tree_ = move(other.tree_);
-                allocator_ = move(other.allocator_);
 
                 return *this;
             }
@@ -189,7 +192,7 @@ namespace std
 
             allocator_type get_allocator() const noexcept
             {
-                return allocator_;
+                return allocator_type{tree_.get_allocator()};
             }
 
             iterator begin() noexcept
@@ -264,7 +267,7 @@ namespace std
 
             size_type max_size() const noexcept
             {
-                return tree_.max_size(allocator_);
+                return tree_.max_size();
             }
 
             /**
@@ -277,7 +280,7 @@ namespace std
                 if (parent && tree_.keys_equal(tree_.get_key(parent->value), key))
                     return parent->value.second;
 
-                auto node = new node_type{value_type{key, mapped_type{}}};
+                auto node = tree_.make_node(value_type{key, mapped_type{}});
                 tree_.insert_node(node, parent);
 
                 return node->value.second;
@@ -289,7 +292,7 @@ namespace std
                 if (parent && tree_.keys_equal(tree_.get_key(parent->value), key))
                     return parent->value.second;
 
-                auto node = new node_type{value_type{move(key), mapped_type{}}};
+                auto node = tree_.make_node(value_type{move(key), mapped_type{}});
                 tree_.insert_node(node, parent);
 
                 return node->value.second;
@@ -378,6 +381,72 @@ namespace std
                 insert(init.begin(), init.end());
             }
 
+            node_type extract(const_iterator position)
+            {
+                return tree_.template extract<node_type>(position);
+            }
+
+            node_type extract(const key_type& key)
+            {
+                return extract(find(key));
+            }
+
+            insert_return_type insert(node_type&& node)
+            {
+                auto res = tree_.insert_handle(node);
+
+                return insert_return_type{res.first, res.second, move(node)};
+            }
+
+            iterator insert(const_iterator, node_type&& node)
+            {
+                return tree_.insert_handle(node).first;
+            }
+
+            /**
+             * Moves the nodes whose keys are not present
+             * here, the other ones stay in source. Should the
+             * allocators differ, the elements are moved into
+             * new nodes instead.
+             */
+            void merge(map& source)
+            {
+                if (&source == this)
+                    return;
+
+                auto same = (get_allocator() == source.get_allocator());
+                auto it = source.begin();
+                while (it != source.end())
+                {
+                    auto next = it;
+                    ++next;
+                    auto last = (next == source.end());
+
+                    if (find(it->first) == end())
+                    {
+                        if (same)
+                        {
+                            auto node = source.extract(it);
+                            tree_.insert_handle(node);
+                        }
+                        else
+                        {
+                            insert(move(*it));
+                            source.erase(it);
+                        }
+                    }
+
+                    if (last)
+                        break;
+                    it = next;
+                }
+            }
+
+            void merge(map&& source)
+            {
+                merge(source);
+            }
+
             template<class... Args>
             pair<iterator, bool> try_emplace(const key_type& key, Args&&... args)
             {
@@ -386,7 +455,7 @@ namespace std
                     return make_pair(iterator{parent, false}, false);
                 else
                 {
-                    auto node = new node_type{value_type{key, forward<Args>(args)...}};
+                    auto node = tree_.make_node(value_type{key, forward<Args>(args)...});
                     tree_.insert_node(node, parent);
 
                     return make_pair(iterator{node, false}, true);
@@ -401,7 +470,7 @@ namespace std
                     return make_pair(iterator{parent, false}, false);
                 else
                 {
-                    auto node = new node_type{value_type{move(key), forward<Args>(args)...}};
+                    auto node = tree_.make_node(value_type{move(key), forward<Args>(args)...});
                     tree_.insert_node(node, parent);
 
                     return make_pair(iterator{node, false}, true);
@@ -432,7 +501,7 @@ namespace std
                 }
                 else
                 {
-                    auto node = new node_type{value_type{key, forward<T>(val)}};
+                    auto node = tree_.make_node(value_type{key, forward<T>(val)});
                     tree_.insert_node(node, parent);
 
                     return make_pair(iterator{node, false}, true);
@@ -451,7 +520,7 @@ namespace std
                 }
                 else
                 {
-                    auto node = new node_type{value_type{move(key), forward<T>(val)}};
+                    auto node = tree_.make_node(value_type{move(key), forward<T>(val)});
                     tree_.insert_node(node, parent);
 
                     return make_pair(iterator{node, false}, true);
@@ -495,7 +564,6 @@ namespace std
                          noexcept(std::swap(declval<key_compare>(), declval<key_compare>())))
             {
                 tree_.swap(other.tree_);
-                std::swap(allocator_, other.allocator_);
             }
 
             void clear() noexcept
@@ -644,27 +712,26 @@ namespace std
                 value_type, key_type, aux::key_value_key_extractor<key_type, mapped_type>,
                 key_compare, allocator_type, size_type,
                 iterator, const_iterator,
-                aux::rbtree_single_policy, node_type
+                aux::rbtree_single_policy, tree_node_type
             >;
 
             tree_type tree_;
-            allocator_type allocator_;
 
-            template<class K, class C, class A>
-            friend bool operator==(const map<K, C, A>&,
-                                   const map<K, C, A>&);
+            template<class K, class V, class C, class A>
+            friend bool operator==(const map<K, V, C, A>&,
+                                   const map<K, V, C, A>&);
     };
 
-    template<class Key, class Compare, class Allocator>
-    bool operator==(const map<Key, Compare, Allocator>& lhs,
-                    const map<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator==(const map<Key, Value, Compare, Allocator>& lhs,
+                    const map<Key, Value, Compare, Allocator>& rhs)
     {
         return lhs.tree_.is_eq_to(rhs.tree_);
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator<(const map<Key, Compare, Allocator>& lhs,
-                   const map<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator<(const map<Key, Value, Compare, Allocator>& lhs,
+                   const map<Key, Value, Compare, Allocator>& rhs)
     {
         return lexicographical_compare(
             lhs.begin(), lhs.end(),
@@ -673,30 +740,30 @@ namespace std
         );
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator!=(const map<Key, Compare, Allocator>& lhs,
-                    const map<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator!=(const map<Key, Value, Compare, Allocator>& lhs,
+                    const map<Key, Value, Compare, Allocator>& rhs)
     {
         return !(lhs == rhs);
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator>(const map<Key, Compare, Allocator>& lhs,
-                   const map<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator>(const map<Key, Value, Compare, Allocator>& lhs,
+                   const map<Key, Value, Compare, Allocator>& rhs)
     {
         return rhs < lhs;
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator>=(const map<Key, Compare, Allocator>& lhs,
-                    const map<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator>=(const map<Key, Value, Compare, Allocator>& lhs,
+                    const map<Key, Value, Compare, Allocator>& rhs)
     {
         return !(lhs < rhs);
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator<=(const map<Key, Compare, Allocator>& lhs,
-                    const map<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator<=(const map<Key, Value, Compare, Allocator>& lhs,
+                    const map<Key, Value, Compare, Allocator>& rhs)
     {
         return !(rhs < lhs);
     }
@@ -725,8 +792,10 @@ namespace std
             using size_type       = size_t;
             using difference_type = ptrdiff_t;
 
-            using node_type = aux::rbtree_multi_node<value_type>;
+        private:
+            using tree_node_type = aux::rbtree_multi_node<value_type>;
 
+        public:
             class value_compare
             {
                 friend class multimap;
@@ -750,22 +819,24 @@ namespace std
             };
 
             using iterator             = aux::rbtree_iterator<
-                value_type, reference, pointer, size_type, node_type
+                value_type, reference, pointer, size_type, tree_node_type
             >;
             using const_iterator       = aux::rbtree_const_iterator<
-                value_type, const_reference, const_pointer, size_type, node_type
+                value_type, const_reference, const_pointer, size_type, tree_node_type
             >;
 
             using reverse_iterator       = std::reverse_iterator<iterator>;
             using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+            using node_type = aux::map_node_handle<tree_node_type, allocator_type>;
+
             multimap()
                 : multimap{key_compare{}}
             { /* DUMMY BODY */ }
 
             explicit multimap(const key_compare& comp,
                               const allocator_type& alloc = allocator_type{})
-                : tree_{comp}, allocator_{alloc}
+                : tree_{comp, alloc}
             { /* DUMMY BODY */ }
 
             template<class InputIterator>
@@ -778,23 +849,23 @@ namespace std
             }
 
             multimap(const multimap& other)
-                : multimap{other, other.allocator_}
+                : tree_{other.tree_}
             { /* DUMMY BODY */ }
 
             multimap(multimap&& other)
-                : tree_{move(other.tree_)}, allocator_{move(other.allocator_)}
+                : tree_{move(other.tree_)}
             { /* DUMMY BODY */ }
 
             explicit multimap(const allocator_type& alloc)
-                : tree_{}, allocator_{alloc}
+                : tree_{key_compare{}, alloc}
             { /* DUMMY BODY */ }
 
             multimap(const multimap& other, const allocator_type& alloc)
-                : tree_{other.tree_}, allocator_{alloc}
+                : tree_{other.tree_, alloc}
             { /* DUMMY BODY */ }
 
             multimap(multimap&& other, const allocator_type& alloc)
-                : tree_{move(other.tree_)}, allocator_{alloc}
+                : tree_{move(other.tree_), alloc}
             { /* DUMMY BODY */ }
 
             multimap(initializer_list<value_type> init,
@@ -822,7 +893,6 @@ namespace std
             multimap& operator=(const multimap& other)
             {
                 tree_ = other.tree_;
-                allocator_ = other.allocator_;
 
                 return *this;
             }
@@ -832,7 +902,6 @@ namespace std
                          is_nothrow_move_assignable<key_compare>::value)
             {
                 tree_ = move(other.tree_);
-                allocator_ = move(other.allocator_);
 
                 return *this;
             }
@@ -848,7 +917,7 @@ namespace std
 
             allocator_type get_allocator() const noexcept
             {
-                return allocator_;
+                return allocator_type{tree_.get_allocator()};
             }
 
             iterator begin() noexcept
@@ -923,7 +992,7 @@ namespace std
 
             size_type max_size() const noexcept
             {
-                return tree_.max_size(allocator_);
+                return tree_.max_size();
             }
 
             template<class... Args>
@@ -989,6 +1058,50 @@ namespace std
                 insert(init.begin(), init.end());
             }
 
+            node_type extract(const_iterator position)
+            {
+                return tree_.template extract<node_type>(position);
+            }
+
+            node_type extract(const key_type& key)
+            {
+                return extract(find(key));
+            }
+
+            iterator insert(node_type&& node)
+            {
+                return tree_.insert_handle(node);
+            }
+
+            iterator insert(const_iterator, node_type&& node)
+            {
+                return insert(move(node));
+            }
+
+            void merge(multimap& source)
+            {
+                if (&source == this)
+                    return;
+
+                auto same = (get_allocator() == source.get_allocator());
+                while (!source.empty())
+                {
+                    auto it = source.begin();
+                    if (same)
+                        insert(source.extract(it));
+                    else
+                    {
+                        insert(move(*it));
+                        source.erase(it);
+                    }
+                }
+            }
+
+            void merge(multimap&& source)
+            {
+                merge(source);
+            }
+
             iterator erase(const_iterator position)
             {
                 return tree_.erase(position);
@@ -1014,7 +1127,6 @@ namespace std
                          noexcept(std::swap(declval<key_compare>(), declval<key_compare>())))
             {
                 tree_.swap(other.tree_);
-                std::swap(allocator_, other.allocator_);
             }
 
             void clear() noexcept
@@ -1163,27 +1275,26 @@ namespace std
                 value_type, key_type, aux::key_value_key_extractor<key_type, mapped_type>,
                 key_compare, allocator_type, size_type,
                 iterator, const_iterator,
-                aux::rbtree_multi_policy, node_type
+                aux::rbtree_multi_policy, tree_node_type
             >;
 
             tree_type tree_;
-            allocator_type allocator_;
 
-            template<class K, class C, class A>
-            friend bool operator==(const multimap<K, C, A>&,
-                                   const multimap<K, C, A>&);
+            template<class K, class V, class C, class A>
+            friend bool operator==(const multimap<K, V, C, A>&,
+                                   const multimap<K, V, C, A>&);
     };
 
-    template<class Key, class Compare, class Allocator>
-    bool operator==(const multimap<Key, Compare, Allocator>& lhs,
-                    const multimap<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator==(const multimap<Key, Value, Compare, Allocator>& lhs,
+                    const multimap<Key, Value, Compare, Allocator>& rhs)
     {
         return lhs.tree_.is_eq_to(rhs.tree_);
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator<(const multimap<Key, Compare, Allocator>& lhs,
-                   const multimap<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator<(const multimap<Key, Value, Compare, Allocator>& lhs,
+                   const multimap<Key, Value, Compare, Allocator>& rhs)
     {
         return lexicographical_compare(
             lhs.begin(), lhs.end(),
@@ -1192,33 +1303,50 @@ namespace std
         );
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator!=(const multimap<Key, Compare, Allocator>& lhs,
-                    const multimap<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator!=(const multimap<Key, Value, Compare, Allocator>& lhs,
+                    const multimap<Key, Value, Compare, Allocator>& rhs)
     {
         return !(lhs == rhs);
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator>(const multimap<Key, Compare, Allocator>& lhs,
-                   const multimap<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator>(const multimap<Key, Value, Compare, Allocator>& lhs,
+                   const multimap<Key, Value, Compare, Allocator>& rhs)
     {
         return rhs < lhs;
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator>=(const multimap<Key, Compare, Allocator>& lhs,
-                    const multimap<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator>=(const multimap<Key, Value, Compare, Allocator>& lhs,
+                    const multimap<Key, Value, Compare, Allocator>& rhs)
     {
         return !(lhs < rhs);
     }
 
-    template<class Key, class Compare, class Allocator>
-    bool operator<=(const multimap<Key, Compare, Allocator>& lhs,
-                    const multimap<Key, Compare, Allocator>& rhs)
+    template<class Key, class Value, class Compare, class Allocator>
+    bool operator<=(const multimap<Key, Value, Compare, Allocator>& lhs,
+                    const multimap<Key, Value, Compare, Allocator>& rhs)
     {
         return !(rhs < lhs);
     }
 }
 
+namespace std::pmr
+{
+    /**
+     * Aliases using polymorphic memory resources,
+     * see <memory_resource>.
+     */
+
+    template<class T>
+    class polymorphic_allocator;
+
+    template<class Key, class T, class Compare = less<Key>>
+    using map = std::map<Key, T, Compare, polymorphic_allocator<pair<const Key, T>>>;
+
+    template<class Key, class T, class Compare = less<Key>>
+    using multimap = std::multimap<Key, T, Compare, polymorphic_allocator<pair<const Key, T>>>;
+}
+
 #endif
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_NODE_HANDLE
+#define LIBCPP_BITS_ADT_NODE_HANDLE
+
+#include <__bits/memory/allocator_traits.hpp>
+#include <type_traits>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * 23.2.4, node handles:
+     * A node handle owns a node extracted from a node based
+     * container together with a copy of the allocator that
+     * allocated it, so that the node can be destroyed or
+     * inserted into another container with an equal allocator
+     * without copying or reallocating the element.
+     */
+
+    template<class Node, class Alloc>
+    class node_handle_base
+    {
+        protected:
+            using node_value_type = remove_reference_t<
+                decltype(declval<Node&>().value)
+            >;
+            using node_allocator_type = typename allocator_traits<
+                Alloc
+            >::template rebind_alloc<Node>;
+            using node_traits = allocator_traits<node_allocator_type>;
+
+        public:
+            using allocator_type = Alloc;
+
+            constexpr node_handle_base() noexcept
+                : node_{}
+            { /* DUMMY BODY */ }
+
+            node_handle_base(node_handle_base&& other) noexcept
+                : node_{other.node_}
+            {
+                if (node_)
+                {
+                    ::new(static_cast<void*>(&alloc_)) node_allocator_type{move(other.alloc_)};
+                    other.release_();
+                }
+            }
+
+            node_handle_base& operator=(node_handle_base&& other)
+            {
+                if (this != &other)
+                {
+                    destroy_();
+                    if (other.node_)
+                    {
+                        node_ = other.node_;
+                        ::new(static_cast<void*>(&alloc_)) node_allocator_type{move(other.alloc_)};
+                        other.release_();
+                    }
+                }
+
+                return *this;
+            }
+
+            ~node_handle_base()
+            {
+                destroy_();
+            }
+
+            allocator_type get_allocator() const
+            {
+                return allocator_type{alloc_};
+            }
+
+            explicit operator bool() const noexcept
+            {
+                return node_ != nullptr;
+            }
+
+            [[nodiscard]] bool empty() const noexcept
+            {
+                return node_ == nullptr;
+            }
+
+            void swap(node_handle_base& other)
+            {
+                node_handle_base tmp{move(other)};
+                other = move(*this);
+                *this = move(tmp);
+            }
+
+        protected:
+            Node* node_;
+
+            /**
+             * The allocator only exists while the handle
+             * owns a node, an empty handle has none.
+             */
+            union
+            {
+                node_allocator_type alloc_;
+            };
+
+            node_handle_base(Node* node, const node_allocator_type& alloc)
+                : node_{node}
+            {
+                ::new(static_cast<void*>(&alloc_)) node_allocator_type{alloc};
+            }
+
+            Node* release_() noexcept
+            {
+                auto res = node_;
+                if (res)
+                {
+                    alloc_.~node_allocator_type();
+                    node_ = nullptr;
+                }
+
+                return res;
+            }
+
+            void destroy_()
+            {
+                if (node_)
+                {
+                    node_traits::destroy(alloc_, node_);
+                    node_traits::deallocate(alloc_, node_, 1);
+                    release_();
+                }
+            }
+
+            friend struct node_handle_access;
+    };
+
+    template<class Node, class Alloc>
+    class map_node_handle: public node_handle_base<Node, Alloc>
+    {
+        using base = node_handle_base<Node, Alloc>;
+
+        public:
+            using key_type    = remove_const_t<
+                typename base::node_value_type::first_type
+            >;
+            using mapped_type = typename base::node_value_type::second_type;
+
+            constexpr map_node_handle() noexcept = default;
+
+            map_node_handle(map_node_handle&&) noexcept = default;
+
+            map_node_handle& operator=(map_node_handle&&) = default;
+
+            key_type& key() const
+            {
+                return const_cast<key_type&>(this->node_->value.first);
+            }
+
+            mapped_type& mapped() const
+            {
+                return this->node_->value.second;
+            }
+
+            void swap(map_node_handle& other)
+            {
+                base::swap(other);
+            }
+
+        private:
+            map_node_handle(Node* node, const typename base::node_allocator_type& alloc)
+                : base{node, alloc}
+            { /* DUMMY BODY */ }
+
+            friend struct node_handle_access;
+    };
+
+    template<class Node, class Alloc>
+    class set_node_handle: public node_handle_base<Node, Alloc>
+    {
+        using base = node_handle_base<Node, Alloc>;
+
+        public:
+            using value_type = typename base::node_value_type;
+
+            constexpr set_node_handle() noexcept = default;
+
+            set_node_handle(set_node_handle&&) noexcept = default;
+
+            set_node_handle& operator=(set_node_handle&&) = default;
+
+            value_type& value() const
+            {
+                return this->node_->value;
+            }
+
+            void swap(set_node_handle& other)
+            {
+                base::swap(other);
+            }
+
+        private:
+            set_node_handle(Node* node, const typename base::node_allocator_type& alloc)
+                : base{node, alloc}
+            { /* DUMMY BODY */ }
+
+            friend struct node_handle_access;
+    };
+
+    template<class Node, class Alloc>
+    void swap(map_node_handle<Node, Alloc>& lhs, map_node_handle<Node, Alloc>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+    template<class Node, class Alloc>
+    void swap(set_node_handle<Node, Alloc>& lhs, set_node_handle<Node, Alloc>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+    /**
+     * Lets the containers create handles and take
+     * nodes out of them without exposing that
+     * to the users.
+     */
+    struct node_handle_access
+    {
+        template<class Handle, class Node, class NodeAlloc>
+        static Handle make(Node* node, const NodeAlloc& alloc)
+        {
+            if (node)
+                return Handle{node, alloc};
+            else
+                return Handle{};
+        }
+
+        template<class Handle>
+        static auto node(const Handle& handle)
+        {
+            return handle.node_;
+        }
+
+        template<class Handle>
+        static auto release(Handle& handle)
+        {
+            return handle.release_();
+        }
+
+        template<class Handle>
+        static const auto& allocator(const Handle& handle)
+        {
+            return handle.alloc_;
+        }
+    };
+
+    template<class Iterator, class NodeHandle>
+    struct node_insert_return
+    {
+        Iterator position;
+        bool inserted;
+        NodeHandle node;
+    };
+}
+
+#endif
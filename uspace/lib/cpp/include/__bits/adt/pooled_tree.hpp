@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_POOLED_TREE
+#define LIBCPP_BITS_ADT_POOLED_TREE
+
+#include <__bits/memory/node_pool.hpp>
+#include <functional>
+#include <map>
+#include <set>
+#include <utility>
+
+/**
+ * HelenOS extension: the tree based containers with
+ * their nodes served from a per container node pool.
+ */
+namespace helenos
+{
+    template<class Key, class Value, class Compare = std::less<Key>>
+    using pooled_map = std::map<
+        Key, Value, Compare,
+        node_pool_allocator<std::pair<const Key, Value>>
+    >;
+
+    template<class Key, class Value, class Compare = std::less<Key>>
+    using pooled_multimap = std::multimap<
+        Key, Value, Compare,
+        node_pool_allocator<std::pair<const Key, Value>>
+    >;
+
+    template<class Key, class Compare = std::less<Key>>
+    using pooled_set = std::set<Key, Compare, node_pool_allocator<Key>>;
+
+    template<class Key, class Compare = std::less<Key>>
+    using pooled_multiset = std::multiset<Key, Compare, node_pool_allocator<Key>>;
+}
+
+#endif
@@ -30,9 +30,12 @@
 #define LIBCPP_BITS_ADT_RBTREE
 
 #include <__bits/adt/key_extractors.hpp>
+#include <__bits/adt/node_handle.hpp>
 #include <__bits/adt/rbtree_iterators.hpp>
 #include <__bits/adt/rbtree_node.hpp>
 #include <__bits/adt/rbtree_policies.hpp>
+#include <__bits/memory/allocator_traits.hpp>
+#include <cassert>
 
 namespace std::aux
 {
@@ -60,13 +63,33 @@ namespace std::aux
 
             using node_type = Node;
 
-            rbtree(const key_compare& kcmp = key_compare{})
-                : root_{nullptr}, size_{}, key_compare_{},
-                  key_extractor_{}
+            /**
+             * Nodes are allocated through the container's
+             * allocator rebound to the node type, which lets
+             * e.g. helenos::node_pool_allocator or a pmr
+             * resource serve them.
+             */
+            using node_allocator_type = typename allocator_traits<
+                allocator_type
+            >::template rebind_alloc<node_type>;
+            using node_traits = allocator_traits<node_allocator_type>;
+
+            rbtree(const key_compare& kcmp = key_compare{},
+                   const allocator_type& alloc = allocator_type{})
+                : root_{nullptr}, size_{}, key_compare_{kcmp},
+                  key_extractor_{}, node_allocator_{alloc}
             { /* DUMMY BODY */ }
 
             rbtree(const rbtree& other)
-                : rbtree{other.key_compare_}
+                : rbtree{other, allocator_type{
+                    node_traits::select_on_container_copy_construction(
+                        other.node_allocator_
+                    )
+                  }}
+            { /* DUMMY BODY */ }
+
+            rbtree(const rbtree& other, const allocator_type& alloc)
+                : rbtree{other.key_compare_, alloc}
             {
                 for (const auto& x: other)
                     insert(x);
@@ -75,28 +98,76 @@ namespace std::aux
             rbtree(rbtree&& other)
                 : root_{other.root_}, size_{other.size_},
                   key_compare_{move(other.key_compare_)},
-                  key_extractor_{move(other.key_extractor_)}
+                  key_extractor_{move(other.key_extractor_)},
+                  node_allocator_{other.node_allocator_}
             {
                 other.root_ = nullptr;
                 other.size_ = size_type{};
             }
 
+            rbtree(rbtree&& other, const allocator_type& alloc)
+                : rbtree{other.key_compare_, alloc}
+            {
+                if (node_allocator_ == other.node_allocator_)
+                    steal_(other);
+                else
+                {
+                    for (auto it = other.begin(); it != other.end(); ++it)
+                        emplace(move(*it));
+                }
+            }
+
             rbtree& operator=(const rbtree& other)
             {
-                auto tmp{other};
-                tmp.swap(*this);
+                if (this == &other)
+                    return *this;
+
+                clear();
+                if constexpr (node_traits::propagate_on_container_copy_assignment::value)
+                    node_allocator_ = other.node_allocator_;
+                key_compare_ = other.key_compare_;
+
+                for (const auto& x: other)
+                    insert(x);
 
                 return *this;
             }
 
             rbtree& operator=(rbtree&& other)
             {
-                rbtree tmp{move(other)};
-                tmp.swap(*this);
+                if (this == &other)
+                    return *this;
+
+                clear();
+                key_compare_ = move(other.key_compare_);
+
+                if constexpr (node_traits::propagate_on_container_move_assignment::value)
+                {
+                    node_allocator_ = other.node_allocator_;
+                    steal_(other);
+                }
+                else if (node_allocator_ == other.node_allocator_)
+                    steal_(other);
+                else
+                {
+                    for (auto it = other.begin(); it != other.end(); ++it)
+                        emplace(move(*it));
+                    other.clear();
+                }
 
                 return *this;
             }
 
+            ~rbtree()
+            {
+                clear();
+            }
+
+            node_allocator_type get_allocator() const noexcept
+            {
+                return node_allocator_;
+            }
+
             bool empty() const noexcept
             {
                 return size_ == 0U;
@@ -107,14 +178,14 @@ namespace std::aux
                 return size_;
             }
 
-            size_type max_size(allocator_type& alloc)
+            size_type max_size() const noexcept
             {
-                return allocator_traits<allocator_type>::max_size(alloc);
+                return node_traits::max_size(node_allocator_);
             }
 
             iterator begin()
             {
-                return iterator{find_smallest_(), false};
+                return iterator{find_smallest_(), !root_};
             }
 
             const_iterator begin() const
@@ -163,7 +234,7 @@ namespace std::aux
 
             const_iterator cbegin() const
             {
-                return const_iterator{find_smallest_(), false};
+                return const_iterator{find_smallest_(), !root_};
             }
 
             const_iterator cend() const
@@ -222,12 +293,39 @@ namespace std::aux
 
             void clear() noexcept
             {
-                if (root_)
+                /**
+                 * Rotating the left child up until there is
+                 * none lets us free the nodes in order without
+                 * recursion or an explicit stack.
+                 */
+                auto current = root_;
+                while (current)
                 {
-                    delete root_;
-                    root_ = nullptr;
-                    size_ = size_type{};
+                    if (auto left = current->left(); left)
+                    {
+                        current->left(left->right());
+                        left->right(current);
+                        current = left;
+                    }
+                    else
+                    {
+                        auto right = current->right();
+
+                        auto dup = current->list_next();
+                        while (dup)
+                        {
+                            auto next = dup->list_next();
+                            destroy_node(dup);
+                            dup = next;
+                        }
+                        destroy_node(current);
+
+                        current = right;
+                    }
                 }
+
+                root_ = nullptr;
+                size_ = size_type{};
             }
 
             void swap(rbtree& other)
@@ -238,6 +336,9 @@ namespace std::aux
                 std::swap(size_, other.size_);
                 std::swap(key_compare_, other.key_compare_);
                 std::swap(key_extractor_, other.key_extractor_);
+
+                if constexpr (node_traits::propagate_on_container_swap::value)
+                    std::swap(node_allocator_, other.node_allocator_);
             }
 
             key_compare key_comp() const
@@ -306,11 +407,13 @@ namespace std::aux
                 auto it1 = begin();
                 auto it2 = other.begin();
 
-                // TODO: this doesn't compare values :/
-                while (keys_equal(*it1++, *it2++))
-                { /* DUMMY BODY */ }
+                while (it1 != end())
+                {
+                    if (!(*it1++ == *it2++))
+                        return false;
+                }
 
-                return (it1 == end()) && (it2 == other.end());
+                return true;
             }
 
             const key_type& get_key(const value_type& val) const
@@ -347,7 +450,39 @@ namespace std::aux
                 return parent;
             }
 
+            template<class... Args>
+            node_type* make_node(Args&&... args)
+            {
+                auto node = node_traits::allocate(node_allocator_, 1);
+                node_traits::construct(node_allocator_, node, forward<Args>(args)...);
+
+                return node;
+            }
+
+            void destroy_node(node_type* node)
+            {
+                node_traits::destroy(node_allocator_, node);
+                node_traits::deallocate(node_allocator_, node, 1);
+            }
+
             node_type* delete_node(const node_type* n)
+            {
+                auto node = const_cast<node_type*>(n);
+                if (!node)
+                    return nullptr;
+
+                auto succ = node->successor();
+                destroy_node(extract_node(node));
+
+                return succ;
+            }
+
+            /**
+             * Unlinks the node from the tree without destroying
+             * it, the result is a detached node that can be
+             * inserted into any tree with an equal allocator.
+             */
+            node_type* extract_node(const node_type* n)
             {
                 auto node = const_cast<node_type*>(n);
                 if (!node)
@@ -355,70 +490,53 @@ namespace std::aux
 
                 --size_;
 
-                auto succ = node->successor();
+                auto next = node->list_next();
                 if (auto tmp = node->get_node_for_deletion(); tmp != nullptr)
                 {
                     /**
                      * This will kick in multi containers,
                      * we popped one node from a list of nodes
-                     * with equivalent keys and we can delete it
-                     * and return the successor which was the next
-                     * in the list.
+                     * with equivalent keys, the rest of the list
+                     * stays in the tree.
                      */
-                    delete tmp;
+                    if (root_ == tmp)
+                        root_ = next;
 
-                    update_root_(succ); // Incase the first in list was root.
-                    return succ;
-                }
-                else if (node == root_)
-                { // Only executed if root_ is unique.
-                    root_ = nullptr;
-                    delete node;
-
-                    return nullptr;
+                    return tmp;
                 }
 
                 if (node->left() && node->right())
                 {
-                    node->swap(succ);
-                    if (succ && !succ->parent())
-                        root_ = succ;
-
-                    // Node now has at most one child.
-                    // Also: If succ was nullptr, the swap
-                    //       didn't do anything and we can
-                    //       safely delete node.
-                    return delete_node(node);
+                    /**
+                     * Move the successor (which has no left child)
+                     * into the position of node, node then has at
+                     * most one child.
+                     */
+                    swap_with_successor_(node);
                 }
 
                 auto child = node->right() ? node->right() : node->left();
-                if (!child)
-                {
-                    // Simply remove the node.
-                    // TODO: repair here too?
-                    node->unlink();
-                    delete node;
-                }
+                auto parent = node->parent();
+
+                if (child)
+                    child->parent(parent);
+
+                if (!parent)
+                    root_ = child;
+                else if (parent->left() == node)
+                    parent->left(child);
                 else
-                {
-                    // Replace with the child.
-                    child->parent(node->parent());
-                    if (node->is_left_child())
-                        child->parent()->left(child);
-                    else if (node->is_right_child())
-                        child->parent()->right(child);
-                    node->parent(nullptr);
-                    node->left(nullptr);
-                    node->right(nullptr);
-
-                    // Repair if needed.
+                    parent->right(child);
+
+                if (child)
                     repair_after_erase_(node, child);
-                    update_root_(child);
 
-                    delete node;
-                }
+                node->parent(nullptr);
+                node->left(nullptr);
+                node->right(nullptr);
+                node->color = rbcolor::red;
 
-                return succ;
+                return node;
             }
 
             void insert_node(node_type* node, node_type* parent)
@@ -426,11 +544,82 @@ namespace std::aux
                 Policy::insert(*this, node, parent);
             }
 
+            template<class Handle>
+            Handle extract(const_iterator it)
+            {
+                if (it == cend())
+                    return Handle{};
+
+                return node_handle_access::make<Handle>(
+                    extract_node(it.node()), node_allocator_
+                );
+            }
+
+            template<class Handle>
+            auto insert_handle(Handle& handle)
+            {
+                assert(handle.empty() ||
+                       node_handle_access::allocator(handle) == node_allocator_);
+
+                return Policy::insert_handle(*this, handle);
+            }
+
         private:
             node_type* root_;
             size_type size_;
             key_compare key_compare_;
             key_extract key_extractor_;
+            node_allocator_type node_allocator_;
+
+            void steal_(rbtree& other)
+            {
+                root_ = other.root_;
+                size_ = other.size_;
+                other.root_ = nullptr;
+                other.size_ = size_type{};
+            }
+
+            void swap_with_successor_(node_type* node)
+            {
+                auto succ = node->right()->find_smallest();
+
+                auto parent = node->parent();
+                auto left = node->left();
+                auto right = node->right();
+                auto succ_parent = succ->parent();
+                auto succ_right = succ->right();
+
+                succ->parent(parent);
+                if (!parent)
+                    root_ = succ;
+                else if (parent->left() == node)
+                    parent->left(succ);
+                else
+                    parent->right(succ);
+
+                succ->left(left);
+                left->parent(succ);
+
+                if (succ == right)
+                {
+                    succ->right(node);
+                    node->parent(succ);
+                }
+                else
+                {
+                    succ->right(right);
+                    right->parent(succ);
+                    succ_parent->left(node);
+                    node->parent(succ_parent);
+                }
+
+                node->left(nullptr);
+                node->right(succ_right);
+                if (succ_right)
+                    succ_right->parent(node);
+
+                std::swap(node->color, succ->color);
+            }
 
             node_type* find_(const key_type& key) const
             {
@@ -410,13 +410,9 @@ namespace std::aux
                 return this;
             }
 
-            ~rbtree_single_node()
+            rbtree_single_node* list_next() const
             {
-                parent_ = nullptr;
-                if (left_)
-                    delete left_;
-                if (right_)
-                    delete right_;
+                return nullptr;
             }
 
         private:
@@ -557,10 +553,15 @@ namespace std::aux
 
             const rbtree_multi_node* successor() const
             {
+                /**
+                 * The climb has to start from the first node
+                 * of the list, it is the one linked from the
+                 * parent.
+                 */
                 if (next_)
                     return next_;
                 else
-                    return utils::successor(this);
+                    return utils::successor(first_);
             }
 
             rbtree_multi_node* predecessor()
@@ -620,19 +621,36 @@ namespace std::aux
                  * update then list and return this
                  * for deletion.
                  */
-                if (next_)
+                if (first_ != this)
+                {
+                    // Nodes behind the first are simply unlinked.
+                    auto prev = first_;
+                    while (prev->next_ != this)
+                        prev = prev->next_;
+                    prev->next_ = next_;
+
+                    parent_ = nullptr;
+                    left_ = nullptr;
+                    right_ = nullptr;
+                    next_ = nullptr;
+                    first_ = this;
+
+                    return this;
+                }
+                else if (next_)
                 {
                     // Make next the new this.
                     next_->first_ = next_;
+                    next_->color = color;
                     if (is_left_child())
-                        parent_->left_ = next_;
+                        parent_->left(next_);
                     else if (is_right_child())
-                        parent_->right_ = next_;
+                        parent_->right(next_);
 
                     if (left_)
-                        left_->parent_ = next_;
+                        left_->parent(next_);
                     if (right_)
-                        right_->parent_ = next_;
+                        right_->parent(next_);
 
                     /**
                      * Update the first_ pointer
@@ -646,16 +664,16 @@ namespace std::aux
                     }
 
                     /**
-                     * Otherwise destructor could
-                     * destroy them.
+                     * Leave this as a detached node, it
+                     * either gets deleted or extracted.
                      */
                     parent_ = nullptr;
                     left_ = nullptr;
                     right_ = nullptr;
                     next_ = nullptr;
-                    first_ = nullptr;
+                    first_ = this;
 
-                    return this; // This will get deleted.
+                    return this;
                 }
                 else
                     return nullptr;
@@ -704,15 +722,14 @@ namespace std::aux
                 }
             }
 
-            ~rbtree_multi_node()
+            /**
+             * Next node in the list of nodes with equivalent
+             * keys, the tree frees the whole list when it frees
+             * the node holding it.
+             */
+            rbtree_multi_node* list_next() const
             {
-                parent_ = nullptr;
-                if (left_)
-                    delete left_;
-                if (right_)
-                    delete right_;
-
-                // TODO: delete the list
+                return next_;
             }
 
         private:
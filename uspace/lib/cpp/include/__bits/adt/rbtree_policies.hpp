@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_ADT_RBTREE_POLICIES
 #define LIBCPP_BITS_ADT_RBTREE_POLICIES
 
+#include <__bits/adt/node_handle.hpp>
 #include <__bits/adt/rbtree_node.hpp>
 #include <utility>
 
@@ -164,7 +165,6 @@ namespace std::aux
         {
             using value_type = typename Tree::value_type;
             using iterator   = typename Tree::iterator;
-            using node_type  = typename Tree::node_type;
 
             auto val = value_type{forward<Args>(args)...};
             auto parent = tree.find_parent_for_insertion(tree.get_key(val));
@@ -172,7 +172,7 @@ namespace std::aux
             if (parent && tree.keys_equal(tree.get_key(parent->value), tree.get_key(val)))
                 return make_pair(iterator{parent, false}, false);
 
-            auto node = new node_type{move(val)};
+            auto node = tree.make_node(move(val));
 
             return insert(tree, node, parent);
         }
@@ -183,13 +183,12 @@ namespace std::aux
         > insert(Tree& tree, const Value& val)
         {
             using iterator  = typename Tree::iterator;
-            using node_type = typename Tree::node_type;
 
             auto parent = tree.find_parent_for_insertion(tree.get_key(val));
             if (parent && tree.keys_equal(tree.get_key(parent->value), tree.get_key(val)))
                 return make_pair(iterator{parent, false}, false);
 
-            auto node = new node_type{val};
+            auto node = tree.make_node(val);
 
             return insert(tree, node, parent);
         }
@@ -200,13 +199,12 @@ namespace std::aux
         > insert(Tree& tree, Value&& val)
         {
             using iterator  = typename Tree::iterator;
-            using node_type = typename Tree::node_type;
 
             auto parent = tree.find_parent_for_insertion(tree.get_key(val));
             if (parent && tree.keys_equal(tree.get_key(parent->value), tree.get_key(val)))
                 return make_pair(iterator{parent, false}, false);
 
-            auto node = new node_type{forward<Value>(val)};
+            auto node = tree.make_node(forward<Value>(val));
 
             return insert(tree, node, parent);
         }
@@ -243,6 +241,24 @@ namespace std::aux
 
             return make_pair(iterator{node, false}, true);
         }
+
+        template<class Tree, class Handle>
+        static pair<
+            typename Tree::iterator, bool
+        > insert_handle(Tree& tree, Handle& handle)
+        {
+            using iterator  = typename Tree::iterator;
+
+            auto node = node_handle_access::node(handle);
+            if (!node)
+                return make_pair(tree.end(), false);
+
+            auto parent = tree.find_parent_for_insertion(tree.get_key(node->value));
+            if (parent && tree.keys_equal(tree.get_key(parent->value), tree.get_key(node->value)))
+                return make_pair(iterator{parent, false}, false);
+
+            return insert(tree, node_handle_access::release(handle), parent);
+        }
     };
 
     struct rbtree_multi_policy
@@ -385,9 +401,7 @@ namespace std::aux
         template<class Tree, class... Args>
         static typename Tree::iterator emplace(Tree& tree, Args&&... args)
         {
-            using node_type  = typename Tree::node_type;
-
-            auto node = new node_type{forward<Args>(args)...};
+            auto node = tree.make_node(forward<Args>(args)...);
 
             return insert(tree, node);
         }
@@ -395,9 +409,7 @@ namespace std::aux
         template<class Tree, class Value>
         static typename Tree::iterator insert(Tree& tree, const Value& val)
         {
-            using node_type = typename Tree::node_type;
-
-            auto node = new node_type{val};
+            auto node = tree.make_node(val);
 
             return insert(tree, node);
         }
@@ -405,9 +417,7 @@ namespace std::aux
         template<class Tree, class Value>
         static typename Tree::iterator insert(Tree& tree, Value&& val)
         {
-            using node_type = typename Tree::node_type;
-
-            auto node = new node_type{forward<Value>(val)};
+            auto node = tree.make_node(forward<Value>(val));
 
             return insert(tree, node);
         }
@@ -451,6 +461,15 @@ namespace std::aux
 
             return iterator{node, false};
         }
+
+        template<class Tree, class Handle>
+        static typename Tree::iterator insert_handle(Tree& tree, Handle& handle)
+        {
+            if (!node_handle_access::node(handle))
+                return tree.end();
+
+            return insert(tree, node_handle_access::release(handle));
+        }
     };
 }
 
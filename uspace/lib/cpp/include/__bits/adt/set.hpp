@@ -61,28 +61,33 @@ namespace std
             using size_type       = size_t;
             using difference_type = ptrdiff_t;
 
-            using node_type = aux::rbtree_single_node<value_type>;
+        private:
+            using tree_node_type = aux::rbtree_single_node<value_type>;
 
+        public:
             /**
              * Note: Both the iterator and const_iterator (and their local variants)
              *       types are constant iterators, the standard does not require them
              *       to be the same type, but why not? :)
              */
             using iterator             = aux::rbtree_const_iterator<
-                value_type, const_reference, const_pointer, size_type, node_type
+                value_type, const_reference, const_pointer, size_type, tree_node_type
             >;
             using const_iterator       = iterator;
 
             using reverse_iterator       = std::reverse_iterator<iterator>;
             using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+            using node_type = aux::set_node_handle<tree_node_type, allocator_type>;
+            using insert_return_type = aux::node_insert_return<iterator, node_type>;
+
             set()
                 : set{key_compare{}}
             { /* DUMMY BODY */ }
 
             explicit set(const key_compare& comp,
                          const allocator_type& alloc = allocator_type{})
-                : tree_{comp}, allocator_{alloc}
+                : tree_{comp, alloc}
             { /* DUMMY BODY */ }
 
             template<class InputIterator>
@@ -95,23 +100,23 @@ namespace std
             }
 
             set(const set& other)
-                : set{other, other.allocator_}
+                : tree_{other.tree_}
             { /* DUMMY BODY */ }
 
             set(set&& other)
-                : tree_{move(other.tree_)}, allocator_{move(other.allocator_)}
+                : tree_{move(other.tree_)}
             { /* DUMMY BODY */ }
 
             explicit set(const allocator_type& alloc)
-                : tree_{}, allocator_{alloc}
+                : tree_{key_compare{}, alloc}
             { /* DUMMY BODY */ }
 
             set(const set& other, const allocator_type& alloc)
-                : tree_{other.tree_}, allocator_{alloc}
+                : tree_{other.tree_, alloc}
             { /* DUMMY BODY */ }
 
             set(set&& other, const allocator_type& alloc)
-                : tree_{move(other.tree_)}, allocator_{alloc}
+                : tree_{move(other.tree_), alloc}
             { /* DUMMY BODY */ }
 
             set(initializer_list<value_type> init,
@@ -139,7 +144,6 @@ namespace std
             set& operator=(const set& other)
             {
                 tree_ = other.tree_;
-                allocator_ = other.allocator_;
 
                 return *this;
             }
@@ -149,7 +153,6 @@ namespace std
                          is_nothrow_move_assignable<key_compare>::value)
             {
                 tree_ = move(other.tree_);
-                allocator_ = move(other.allocator_);
 
                 return *this;
             }
@@ -165,7 +168,7 @@ namespace std
 
             allocator_type get_allocator() const noexcept
             {
-                return allocator_;
+                return allocator_type{tree_.get_allocator()};
             }
 
             iterator begin() noexcept
@@ -240,7 +243,7 @@ namespace std
 
             size_type max_size() const noexcept
             {
-                return tree_.max_size(allocator_);
+                return tree_.max_size();
             }
 
             template<class... Args>
@@ -287,6 +290,72 @@ namespace std
                 insert(init.begin(), init.end());
             }
 
+            node_type extract(const_iterator position)
+            {
+                return tree_.template extract<node_type>(position);
+            }
+
+            node_type extract(const key_type& key)
+            {
+                return extract(find(key));
+            }
+
+            insert_return_type insert(node_type&& node)
+            {
+                auto res = tree_.insert_handle(node);
+
+                return insert_return_type{res.first, res.second, move(node)};
+            }
+
+            iterator insert(const_iterator, node_type&& node)
+            {
+                return tree_.insert_handle(node).first;
+            }
+
+            /**
+             * Moves the nodes whose keys are not present
+             * here, the other ones stay in source. Should the
+             * allocators differ, the elements are moved into
+             * new nodes instead.
+             */
+            void merge(set& source)
+            {
+                if (&source == this)
+                    return;
+
+                auto same = (get_allocator() == source.get_allocator());
+                auto it = source.begin();
+                while (it != source.end())
+                {
+                    auto next = it;
+                    ++next;
+                    auto last = (next == source.end());
+
+                    if (find(*it) == end())
+                    {
+                        if (same)
+                        {
+                            auto node = source.extract(it);
+                            tree_.insert_handle(node);
+                        }
+                        else
+                        {
+                            insert(move(*it));
+                            source.erase(it);
+                        }
+                    }
+
+                    if (last)
+                        break;
+                    it = next;
+                }
+            }
+
+            void merge(set&& source)
+            {
+                merge(source);
+            }
+
             iterator erase(const_iterator position)
             {
                 return tree_.erase(position);
@@ -312,7 +381,6 @@ namespace std
                          noexcept(std::swap(declval<key_compare>(), declval<key_compare>())))
             {
                 tree_.swap(other.tree_);
-                std::swap(allocator_, other.allocator_);
             }
 
             void clear() noexcept
@@ -461,11 +529,10 @@ namespace std
                 key_type, key_type, aux::key_no_value_key_extractor<key_type>,
                 key_compare, allocator_type, size_type,
                 iterator, const_iterator,
-                aux::rbtree_single_policy, node_type
+                aux::rbtree_single_policy, tree_node_type
             >;
 
             tree_type tree_;
-            allocator_type allocator_;
 
             template<class K, class C, class A>
             friend bool operator==(const set<K, C, A>&,
@@ -542,28 +609,32 @@ namespace std
             using size_type       = size_t;
             using difference_type = ptrdiff_t;
 
-            using node_type = aux::rbtree_multi_node<value_type>;
+        private:
+            using tree_node_type = aux::rbtree_multi_node<value_type>;
 
+        public:
             /**
              * Note: Both the iterator and const_iterator types are constant
              *       iterators, the standard does not require them
              *       to be the same type, but why not? :)
              */
             using iterator             = aux::rbtree_const_iterator<
-                value_type, const_reference, const_pointer, size_type, node_type
+                value_type, const_reference, const_pointer, size_type, tree_node_type
             >;
             using const_iterator       = iterator;
 
             using reverse_iterator       = std::reverse_iterator<iterator>;
             using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+            using node_type = aux::set_node_handle<tree_node_type, allocator_type>;
+
             multiset()
                 : multiset{key_compare{}}
             { /* DUMMY BODY */ }
 
             explicit multiset(const key_compare& comp,
                               const allocator_type& alloc = allocator_type{})
-                : tree_{comp}, allocator_{alloc}
+                : tree_{comp, alloc}
             { /* DUMMY BODY */ }
 
             template<class InputIterator>
@@ -576,23 +647,23 @@ namespace std
             }
 
             multiset(const multiset& other)
-                : multiset{other, other.allocator_}
+                : tree_{other.tree_}
             { /* DUMMY BODY */ }
 
             multiset(multiset&& other)
-                : tree_{move(other.tree_)}, allocator_{move(other.allocator_)}
+                : tree_{move(other.tree_)}
             { /* DUMMY BODY */ }
 
             explicit multiset(const allocator_type& alloc)
-                : tree_{}, allocator_{alloc}
+                : tree_{key_compare{}, alloc}
             { /* DUMMY BODY */ }
 
             multiset(const multiset& other, const allocator_type& alloc)
-                : tree_{other.tree_}, allocator_{alloc}
+                : tree_{other.tree_, alloc}
             { /* DUMMY BODY */ }
 
             multiset(multiset&& other, const allocator_type& alloc)
-                : tree_{move(other.tree_)}, allocator_{alloc}
+                : tree_{move(other.tree_), alloc}
             { /* DUMMY BODY */ }
 
             multiset(initializer_list<value_type> init,
@@ -620,7 +691,6 @@ namespace std
             multiset& operator=(const multiset& other)
             {
                 tree_ = other.tree_;
-                allocator_ = other.allocator_;
 
                 return *this;
             }
@@ -630,7 +700,6 @@ namespace std
                          is_nothrow_move_assignable<key_compare>::value)
             {
                 tree_ = move(other.tree_);
-                allocator_ = move(other.allocator_);
 
                 return *this;
             }
@@ -646,7 +715,7 @@ namespace std
 
             allocator_type get_allocator() const noexcept
             {
-                return allocator_;
+                return allocator_type{tree_.get_allocator()};
             }
 
             iterator begin() noexcept
@@ -721,7 +790,7 @@ namespace std
 
             size_type max_size() const noexcept
             {
-                return tree_.max_size(allocator_);
+                return tree_.max_size();
             }
 
             template<class... Args>
@@ -768,6 +837,50 @@ namespace std
                 insert(init.begin(), init.end());
             }
 
+            node_type extract(const_iterator position)
+            {
+                return tree_.template extract<node_type>(position);
+            }
+
+            node_type extract(const key_type& key)
+            {
+                return extract(find(key));
+            }
+
+            iterator insert(node_type&& node)
+            {
+                return tree_.insert_handle(node);
+            }
+
+            iterator insert(const_iterator, node_type&& node)
+            {
+                return insert(move(node));
+            }
+
+            void merge(multiset& source)
+            {
+                if (&source == this)
+                    return;
+
+                auto same = (get_allocator() == source.get_allocator());
+                while (!source.empty())
+                {
+                    auto it = source.begin();
+                    if (same)
+                        insert(source.extract(it));
+                    else
+                    {
+                        insert(move(*it));
+                        source.erase(it);
+                    }
+                }
+            }
+
+            void merge(multiset&& source)
+            {
+                merge(source);
+            }
+
             iterator erase(const_iterator position)
             {
                 return tree_.erase(position);
@@ -793,7 +906,6 @@ namespace std
                          noexcept(std::swap(declval<key_compare>(), declval<key_compare>())))
             {
                 tree_.swap(other.tree_);
-                std::swap(allocator_, other.allocator_);
             }
 
             void clear() noexcept
@@ -942,11 +1054,10 @@ namespace std
                 key_type, key_type, aux::key_no_value_key_extractor<key_type>,
                 key_compare, allocator_type, size_type,
                 iterator, const_iterator,
-                aux::rbtree_multi_policy, node_type
+                aux::rbtree_multi_policy, tree_node_type
             >;
 
             tree_type tree_;
-            allocator_type allocator_;
 
             template<class K, class C, class A>
             friend bool operator==(const multiset<K, C, A>&,
@@ -1000,4 +1111,21 @@ namespace std
     }
 }
 
+namespace std::pmr
+{
+    /**
+     * Aliases using polymorphic memory resources,
+     * see <memory_resource>.
+     */
+
+    template<class T>
+    class polymorphic_allocator;
+
+    template<class Key, class Compare = less<Key>>
+    using set = std::set<Key, Compare, polymorphic_allocator<Key>>;
+
+    template<class Key, class Compare = less<Key>>
+    using multiset = std::multiset<Key, Compare, polymorphic_allocator<Key>>;
+}
+
 #endif
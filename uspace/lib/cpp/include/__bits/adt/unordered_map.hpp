@@ -1190,4 +1190,31 @@ namespace std
     }
 }
 
+namespace std::pmr
+{
+    /**
+     * Aliases using polymorphic memory resources,
+     * see <memory_resource>.
+     */
+
+    template<class T>
+    class polymorphic_allocator;
+
+    template<
+        class Key, class T,
+        class Hash = hash<Key>, class Pred = equal_to<Key>
+    >
+    using unordered_map = std::unordered_map<
+        Key, T, Hash, Pred, polymorphic_allocator<pair<const Key, T>>
+    >;
+
+    template<
+        class Key, class T,
+        class Hash = hash<Key>, class Pred = equal_to<Key>
+    >
+    using unordered_multimap = std::unordered_multimap<
+        Key, T, Hash, Pred, polymorphic_allocator<pair<const Key, T>>
+    >;
+}
+
 #endif
@@ -914,4 +914,31 @@ namespace std
     }
 }
 
+namespace std::pmr
+{
+    /**
+     * Aliases using polymorphic memory resources,
+     * see <memory_resource>.
+     */
+
+    template<class T>
+    class polymorphic_allocator;
+
+    template<
+        class Key,
+        class Hash = hash<Key>, class Pred = equal_to<Key>
+    >
+    using unordered_set = std::unordered_set<
+        Key, Hash, Pred, polymorphic_allocator<Key>
+    >;
+
+    template<
+        class Key,
+        class Hash = hash<Key>, class Pred = equal_to<Key>
+    >
+    using unordered_multiset = std::unordered_multiset<
+        Key, Hash, Pred, polymorphic_allocator<Key>
+    >;
+}
+
 #endif
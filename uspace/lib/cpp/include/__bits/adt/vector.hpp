@@ -30,9 +30,11 @@
 #define LIBCPP_BITS_ADT_VECTOR
 
 #include <algorithm>
+#include <cstring>
 #include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
 namespace std
@@ -82,7 +84,7 @@ namespace std
                 data_ = allocator_.allocate(capacity_);
 
                 for (size_type i = 0; i < size_; ++i)
-                    data_[i] = val;
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, val);
             }
 
             template<class InputIterator>
@@ -100,7 +102,7 @@ namespace std
                 data_ = allocator_.allocate(capacity_);
 
                 for (size_type i = 0; i < size_; ++i)
-                    data_[i] = other.data_[i];
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, other.data_[i]);
             }
 
             vector(vector&& other) noexcept
@@ -119,7 +121,7 @@ namespace std
                 data_ = allocator_.allocate(capacity_);
 
                 for (size_type i = 0; i < size_; ++i)
-                    data_[i] = other.data_[i];
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, other.data_[i]);
             }
 
             vector(initializer_list<T> init, const Allocator& alloc = Allocator{})
@@ -130,13 +132,12 @@ namespace std
 
                 auto it = init.begin();
                 for (size_type i = 0; it != init.end(); ++i, ++it)
-                {
-                    data_[i] = *it;
-                }
+                    allocator_traits<Allocator>::construct(allocator_, data_ + i, *it);
             }
 
             ~vector()
             {
+                destroy_from_end_until_(begin());
                 allocator_.deallocate(data_, capacity_);
             }
 
@@ -153,7 +154,10 @@ namespace std
                          allocator_traits<Allocator>::is_always_equal::value)
             {
                 if (data_)
+                {
+                    destroy_from_end_until_(begin());
                     allocator_.deallocate(data_, capacity_);
+                }
 
                 // TODO: test this
                 data_ = other.data_;
@@ -274,16 +278,32 @@ namespace std
 
             void resize(size_type sz)
             {
-                resize_with_copy_(size_, capacity_);
+                if (sz <= size_)
+                {
+                    resize_with_copy_(sz, capacity_);
+                    return;
+                }
+
+                if (sz > capacity_)
+                    resize_with_copy_(size_, next_capacity_(sz));
+
+                while (size_ < sz)
+                    allocator_traits<Allocator>::construct(allocator_, data_ + size_++);
             }
 
             void resize(size_type sz, const value_type& val)
             {
-                auto old_size = size_;
-                resize_with_copy_(sz, capacity_);
+                if (sz <= size_)
+                {
+                    resize_with_copy_(sz, capacity_);
+                    return;
+                }
+
+                if (sz > capacity_)
+                    resize_with_copy_(size_, next_capacity_(sz));
 
-                for (size_type i = old_size - 1; i < size_; ++i)
-                    data_[i] = val;
+                while (size_ < sz)
+                    allocator_traits<Allocator>::construct(allocator_, data_ + size_++, val);
             }
 
             size_type capacity() const noexcept
@@ -372,27 +392,39 @@ namespace std
             template<class... Args>
             reference emplace_back(Args&&... args)
             {
-                if (size_ >= capacity_)
-                    resize_with_copy_(size_, next_capacity_());
-
-                allocator_traits<Allocator>::construct(allocator_,
-                                                       begin() + size_, forward<Args>(args)...);
+                if (size_ < capacity_)
+                {
+                    allocator_traits<Allocator>::construct(allocator_,
+                                                           data_ + size_, forward<Args>(args)...);
+                    ++size_;
+                }
+                else
+                {
+                    /**
+                     * The new element is constructed before the old
+                     * ones are relocated, the arguments may refer
+                     * to elements of this vector.
+                     */
+                    auto new_capacity = next_capacity_();
+                    auto new_data = allocator_.allocate(new_capacity);
+
+                    allocator_traits<Allocator>::construct(allocator_,
+                                                           new_data + size_, forward<Args>(args)...);
+                    relocate_(new_data, new_capacity);
+                    ++size_;
+                }
 
                 return back();
             }
 
             void push_back(const T& x)
             {
-                if (size_ >= capacity_)
-                    resize_with_copy_(size_, next_capacity_());
-                data_[size_++] = x;
+                emplace_back(x);
             }
 
             void push_back(T&& x)
             {
-                if (size_ >= capacity_)
-                    resize_with_copy_(size_, next_capacity_());
-                data_[size_++] = forward<T>(x);
+                emplace_back(move(x));
             }
 
             void pop_back()
@@ -517,26 +549,68 @@ namespace std
                 capacity_ = capacity;
             }
 
-            void resize_with_copy_(size_type size, size_type capacity)
-            {
-                if (size < size_)
-                    destroy_from_end_until_(begin() + size);
+            /**
+             * Trivially copyable elements can be relocated with memcpy,
+             * unless the allocator customizes their construction.
+             */
+            static constexpr bool relocate_bitwise_ =
+                is_trivially_copyable<value_type>::value &&
+                is_same<allocator_type, allocator<value_type>>::value;
 
-                if(capacity_ == 0 || capacity_ < capacity)
+            /**
+             * Moves the elements to new_data with the given capacity,
+             * which becomes the storage of the vector. Elements are
+             * only copied if their move constructor can throw and
+             * they are copyable.
+             */
+            void relocate_(value_type* new_data, size_type new_capacity)
+            {
+                if constexpr (relocate_bitwise_)
                 {
-                    auto new_data = allocator_.allocate(capacity);
+                    if (size_ > 0)
+                        std::memcpy(new_data, data_, size_ * sizeof(value_type));
+                }
+                else
+                {
+                    for (size_type i = 0; i < size_; ++i)
+                    {
+                        allocator_traits<Allocator>::construct(allocator_,
+                                                               new_data + i, move_if_noexcept(data_[i]));
+                    }
 
-                    auto to_copy = min(size, size_);
-                    for (size_type i = 0; i < to_copy; ++i)
-                        new_data[i] = move(data_[i]);
+                    destroy_from_end_until_(begin());
+                }
+
+                if (data_)
+                    allocator_.deallocate(data_, capacity_);
 
-                    std::swap(data_, new_data);
+                data_ = new_data;
+                capacity_ = new_capacity;
+            }
 
-                    allocator_.deallocate(new_data, capacity_);
+            /**
+             * Shrinks the vector to size elements (it never grows the
+             * size) and reallocates it if the capacity differs.
+             */
+            void resize_with_copy_(size_type size, size_type capacity)
+            {
+                if (size < size_)
+                {
+                    destroy_from_end_until_(begin() + size);
+                    size_ = size;
                 }
 
-                capacity_ = capacity;
-                size_ = size;
+                if (capacity != capacity_ && capacity >= size_)
+                {
+                    if (capacity == 0)
+                    {
+                        allocator_.deallocate(data_, capacity_);
+                        data_ = nullptr;
+                        capacity_ = 0;
+                    }
+                    else
+                        relocate_(allocator_.allocate(capacity), capacity);
+                }
             }
 
             void destroy_from_end_until_(iterator target)
@@ -663,4 +737,18 @@ namespace std
     // TODO: implement
 }
 
+namespace std::pmr
+{
+    /**
+     * Aliases using polymorphic memory resources,
+     * see <memory_resource>.
+     */
+
+    template<class T>
+    class polymorphic_allocator;
+
+    template<class T>
+    using vector = std::vector<T, polymorphic_allocator<T>>;
+}
+
 #endif
@@ -30,6 +30,7 @@
 #define LIBCPP_BITS_ALGORITHM
 
 #include <iterator>
+#include <new>
 #include <utility>
 
 namespace std
@@ -653,7 +654,31 @@ namespace std
      * 25.3.11, rotate:
      */
 
-    // TODO: implement
+    template<class ForwardIterator>
+    ForwardIterator rotate(ForwardIterator first, ForwardIterator middle,
+                           ForwardIterator last)
+    {
+        if (first == middle)
+            return last;
+        if (middle == last)
+            return first;
+
+        auto result = first;
+        advance(result, distance(middle, last));
+
+        auto next = middle;
+        while (first != next)
+        {
+            iter_swap(first++, next++);
+
+            if (next == last)
+                next = middle;
+            else if (first == middle)
+                middle = next;
+        }
+
+        return result;
+    }
 
     /**
      * 25.3.12, shuffle:
@@ -679,13 +704,216 @@ namespace std
      * 25.4.1.1, sort:
      */
 
-    template<class RandomAccessIterator, class Compare>
-    void make_heap(RandomAccessIterator, RandomAccessIterator,
-                   Compare);
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator lower_bound(ForwardIterator, ForwardIterator,
+                                const T&, Compare);
 
-    template<class RandomAccessIterator, class Compare>
-    void sort_heap(RandomAccessIterator, RandomAccessIterator,
-                   Compare);
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator upper_bound(ForwardIterator, ForwardIterator,
+                                const T&, Compare);
+
+    namespace aux
+    {
+        /**
+         * Ranges with at most this many elements are left
+         * for the insertion sort by the partitioning algorithms.
+         */
+        constexpr int sort_threshold{16};
+
+        template<class RandomAccessIterator, class Compare>
+        void insertion_sort(RandomAccessIterator first, RandomAccessIterator last,
+                            Compare comp)
+        {
+            if (first == last)
+                return;
+
+            for (auto it = first + 1; it != last; ++it)
+            {
+                auto value = move(*it);
+                auto hole = it;
+
+                while (hole != first && comp(value, *(hole - 1)))
+                {
+                    *hole = move(*(hole - 1));
+                    --hole;
+                }
+                *hole = move(value);
+            }
+        }
+
+        /**
+         * Recursion depth after which the partitioning algorithms
+         * give up on quicksort and switch to heapsort: 2 * log2(n).
+         */
+        template<class Size>
+        Size sort_depth_limit(Size n)
+        {
+            Size depth{};
+            while (n > 1)
+            {
+                n /= 2;
+                ++depth;
+            }
+
+            return 2 * depth;
+        }
+
+        template<class RandomAccessIterator, class Size, class Compare>
+        void sort_sift_down(RandomAccessIterator first, Size idx, Size count,
+                            Compare comp)
+        {
+            auto value = move(first[idx]);
+
+            while (2 * idx + 1 < count)
+            {
+                auto child = 2 * idx + 1;
+                if (child + 1 < count && comp(first[child], first[child + 1]))
+                    ++child;
+
+                if (!comp(value, first[child]))
+                    break;
+
+                first[idx] = move(first[child]);
+                idx = child;
+            }
+            first[idx] = move(value);
+        }
+
+        /**
+         * Moves the smallest middle - first elements of [first, last)
+         * to [first, middle) arranged as a max-heap.
+         */
+        template<class RandomAccessIterator, class Compare>
+        void heap_select(RandomAccessIterator first, RandomAccessIterator middle,
+                         RandomAccessIterator last, Compare comp)
+        {
+            auto count = middle - first;
+            for (auto i = count / 2; i > 0; --i)
+                sort_sift_down(first, i - 1, count, comp);
+
+            for (auto it = middle; it < last; ++it)
+            {
+                if (comp(*it, *first))
+                {
+                    iter_swap(it, first);
+                    sort_sift_down(first, decltype(count){}, count, comp);
+                }
+            }
+        }
+
+        template<class RandomAccessIterator, class Compare>
+        void heap_sort(RandomAccessIterator first, RandomAccessIterator middle,
+                       RandomAccessIterator last, Compare comp)
+        {
+            heap_select(first, middle, last, comp);
+
+            for (auto count = middle - first; count > 1; --count)
+            {
+                iter_swap(first, first + (count - 1));
+                sort_sift_down(first, decltype(count){}, count - 1, comp);
+            }
+        }
+
+        template<class Iterator, class Compare>
+        void move_median_to_first(Iterator result, Iterator a, Iterator b,
+                                  Iterator c, Compare comp)
+        {
+            if (comp(*a, *b))
+            {
+                if (comp(*b, *c))
+                    iter_swap(result, b);
+                else if (comp(*a, *c))
+                    iter_swap(result, c);
+                else
+                    iter_swap(result, a);
+            }
+            else if (comp(*a, *c))
+                iter_swap(result, a);
+            else if (comp(*b, *c))
+                iter_swap(result, c);
+            else
+                iter_swap(result, b);
+        }
+
+        /**
+         * Partitions [first, last) around the median of its first,
+         * middle and last element, which is moved to *first and
+         * stops both scans, so they need no bounds checks. Returns
+         * the cut, elements before it are not greater than the pivot
+         * and elements after it are not less than the pivot.
+         */
+        template<class RandomAccessIterator, class Compare>
+        RandomAccessIterator partition_pivot(RandomAccessIterator first,
+                                             RandomAccessIterator last,
+                                             Compare comp)
+        {
+            auto mid = first + (last - first) / 2;
+            move_median_to_first(first, first + 1, mid, last - 1, comp);
+
+            auto pivot = first;
+            auto lo = first + 1;
+            auto hi = last;
+            while (true)
+            {
+                while (comp(*lo, *pivot))
+                    ++lo;
+
+                --hi;
+                while (comp(*pivot, *hi))
+                    --hi;
+
+                if (!(lo < hi))
+                    return lo;
+
+                iter_swap(lo, hi);
+                ++lo;
+            }
+        }
+
+        template<class RandomAccessIterator, class Size, class Compare>
+        void introsort_loop(RandomAccessIterator first, RandomAccessIterator last,
+                            Size depth_limit, Compare comp)
+        {
+            while (last - first > sort_threshold)
+            {
+                if (depth_limit == 0)
+                {
+                    heap_sort(first, last, last, comp);
+                    return;
+                }
+                --depth_limit;
+
+                auto cut = partition_pivot(first, last, comp);
+                introsort_loop(cut, last, depth_limit, comp);
+                last = cut;
+            }
+        }
+
+        template<class RandomAccessIterator, class Size, class Compare>
+        void introselect(RandomAccessIterator first, RandomAccessIterator nth,
+                         RandomAccessIterator last, Size depth_limit,
+                         Compare comp)
+        {
+            while (last - first > 3)
+            {
+                if (depth_limit == 0)
+                {
+                    heap_select(first, nth + 1, last, comp);
+                    iter_swap(first, nth);
+                    return;
+                }
+                --depth_limit;
+
+                auto cut = partition_pivot(first, last, comp);
+                if (cut <= nth)
+                    first = cut;
+                else
+                    last = cut;
+            }
+
+            insertion_sort(first, last, comp);
+        }
+    }
 
     template<class RandomAccessIterator>
     void sort(RandomAccessIterator first, RandomAccessIterator last)
@@ -700,29 +928,199 @@ namespace std
               Compare comp)
     {
         /**
-         * Note: This isn't the most effective approach,
-         *       but since we already have these two functions
-         *       and they satisfy asymptotic limitations
-         *       imposed by the standard, we're using them at
-         *       the moment. Might be good to change it to qsort
-         *       or merge sort later.
+         * Introsort: quicksort with median of three pivots that
+         * falls back to heapsort when the recursion gets too deep,
+         * leaving short partitions for a final insertion sort pass.
          */
+        if (last - first < 2)
+            return;
 
-        make_heap(first, last, comp);
-        sort_heap(first, last, comp);
+        aux::introsort_loop(first, last,
+                            aux::sort_depth_limit(last - first), comp);
+        aux::insertion_sort(first, last, comp);
     }
 
     /**
      * 25.4.1.2, stable_sort:
      */
 
-    // TODO: implement
+    namespace aux
+    {
+        /**
+         * Merges [first, middle) and [middle, last) using rotations,
+         * used when there is no memory for the merge buffer.
+         */
+        template<class BidirectionalIterator, class Size, class Compare>
+        void merge_without_buffer(BidirectionalIterator first,
+                                  BidirectionalIterator middle,
+                                  BidirectionalIterator last,
+                                  Size len1, Size len2, Compare comp)
+        {
+            if (len1 == 0 || len2 == 0)
+                return;
+
+            if (len1 + len2 == 2)
+            {
+                if (comp(*middle, *first))
+                    iter_swap(first, middle);
+                return;
+            }
+
+            auto first_cut = first;
+            auto second_cut = middle;
+            Size len11{};
+            Size len22{};
+
+            if (len1 > len2)
+            {
+                len11 = len1 / 2;
+                advance(first_cut, len11);
+                second_cut = lower_bound(middle, last, *first_cut, comp);
+                len22 = distance(middle, second_cut);
+            }
+            else
+            {
+                len22 = len2 / 2;
+                advance(second_cut, len22);
+                first_cut = upper_bound(first, middle, *second_cut, comp);
+                len11 = distance(first, first_cut);
+            }
+
+            auto new_middle = rotate(first_cut, middle, second_cut);
+            merge_without_buffer(first, first_cut, new_middle,
+                                 len11, len22, comp);
+            merge_without_buffer(new_middle, second_cut, last,
+                                 len1 - len11, len2 - len22, comp);
+        }
+
+        /**
+         * Merges [first, middle) and [middle, last), the first of which
+         * is moved to the uninitialized buffer for the duration.
+         */
+        template<class RandomAccessIterator, class T, class Compare>
+        void merge_with_buffer(RandomAccessIterator first,
+                               RandomAccessIterator middle,
+                               RandomAccessIterator last,
+                               T* buffer, Compare comp)
+        {
+            auto buffer_end = buffer;
+            for (auto it = first; it != middle; ++it)
+                ::new(static_cast<void*>(buffer_end++)) T(move(*it));
+
+            auto buf = buffer;
+            auto out = first;
+            while (buf != buffer_end && middle != last)
+            {
+                if (comp(*middle, *buf))
+                    *out++ = move(*middle++);
+                else
+                    *out++ = move(*buf++);
+            }
+
+            while (buf != buffer_end)
+                *out++ = move(*buf++);
+
+            for (buf = buffer; buf != buffer_end; ++buf)
+                buf->~T();
+        }
+
+        template<class RandomAccessIterator, class T, class Compare>
+        void merge_sort(RandomAccessIterator first, RandomAccessIterator last,
+                        T* buffer, Compare comp)
+        {
+            auto len = last - first;
+            if (len <= sort_threshold)
+            {
+                insertion_sort(first, last, comp);
+                return;
+            }
+
+            auto middle = first + len / 2;
+            merge_sort(first, middle, buffer, comp);
+            merge_sort(middle, last, buffer, comp);
+
+            if (!comp(*middle, *(middle - 1)))
+                return;
+
+            if (buffer)
+                merge_with_buffer(first, middle, last, buffer, comp);
+            else
+                merge_without_buffer(first, middle, last, middle - first,
+                                     last - middle, comp);
+        }
+    }
+
+    template<class RandomAccessIterator>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        stable_sort(first, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last,
+                     Compare comp)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        auto len = last - first;
+        if (len < 2)
+            return;
+
+        /**
+         * Merge sort, the left half of each merge lives in a buffer
+         * of half the size of the range. If that cannot be allocated,
+         * the merges are done in place in O(n log n) swaps each.
+         */
+        auto buffer = static_cast<value_type*>(::operator new(
+            sizeof(value_type) * static_cast<size_t>(len / 2), nothrow
+        ));
+
+        aux::merge_sort(first, last, buffer, comp);
+
+        if (buffer)
+            ::operator delete(static_cast<void*>(buffer));
+    }
 
     /**
      * 25.4.1.3, partial_sort:
      */
 
-    // TODO: implement
+    template<class RandomAccessIterator>
+    void partial_sort(RandomAccessIterator first, RandomAccessIterator middle,
+                      RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        partial_sort(first, middle, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void partial_sort(RandomAccessIterator first, RandomAccessIterator middle,
+                      RandomAccessIterator last, Compare comp)
+    {
+        if (first == middle)
+            return;
+
+        /**
+         * A short prefix of a long range is cheaper to collect
+         * in a heap, otherwise select it and sort it.
+         */
+        if ((middle - first) < (last - first) / 8 ||
+            middle - first <= aux::sort_threshold)
+        {
+            aux::heap_sort(first, middle, last, comp);
+            return;
+        }
+
+        if (middle != last)
+        {
+            aux::introselect(first, middle, last,
+                             aux::sort_depth_limit(last - first), comp);
+        }
+        sort(first, middle, comp);
+    }
 
     /**
      * 25.4.1.4, partial_sort_copy:
@@ -782,7 +1180,25 @@ namespace std
      * 25.4.2, nth_element:
      */
 
-    // TODO: implement
+    template<class RandomAccessIterator>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth,
+                     RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        nth_element(first, nth, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth,
+                     RandomAccessIterator last, Compare comp)
+    {
+        if (first == last || nth == last)
+            return;
+
+        aux::introselect(first, nth, last,
+                         aux::sort_depth_limit(last - first), comp);
+    }
 
     /**
      * 25.4.3, binary search:
@@ -792,13 +1208,69 @@ namespace std
      * 25.4.3.1, lower_bound
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    ForwardIterator lower_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value)
+    {
+        return lower_bound(first, last, value, less<T>{});
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator lower_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value, Compare comp)
+    {
+        auto count = distance(first, last);
+        while (count > 0)
+        {
+            auto step = count / 2;
+            auto it = first;
+            advance(it, step);
+
+            if (comp(*it, value))
+            {
+                first = ++it;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+
+        return first;
+    }
 
     /**
      * 25.4.3.2, upper_bound
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    ForwardIterator upper_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value)
+    {
+        return upper_bound(first, last, value, less<T>{});
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator upper_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value, Compare comp)
+    {
+        auto count = distance(first, last);
+        while (count > 0)
+        {
+            auto step = count / 2;
+            auto it = first;
+            advance(it, step);
+
+            if (!comp(value, *it))
+            {
+                first = ++it;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+
+        return first;
+    }
 
     /**
      * 25.4.3.3, equal_range:
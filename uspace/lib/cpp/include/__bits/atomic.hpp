@@ -29,6 +29,714 @@
 #ifndef LIBCPP_BITS_ATOMIC
 #define LIBCPP_BITS_ATOMIC
 
-#error "<atomic> is not implemented"
+#include <__bits/thread/atomic_wait.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace std
+{
+    /**
+     * 29.3, order and consistency:
+     */
+
+    enum memory_order
+    {
+        memory_order_relaxed = __ATOMIC_RELAXED,
+        memory_order_consume = __ATOMIC_CONSUME,
+        memory_order_acquire = __ATOMIC_ACQUIRE,
+        memory_order_release = __ATOMIC_RELEASE,
+        memory_order_acq_rel = __ATOMIC_ACQ_REL,
+        memory_order_seq_cst = __ATOMIC_SEQ_CST
+    };
+
+    template<class T>
+    T kill_dependency(T y) noexcept
+    {
+        return y;
+    }
+
+    /**
+     * 29.4, lock-free property:
+     */
+
+    #define ATOMIC_BOOL_LOCK_FREE __GCC_ATOMIC_BOOL_LOCK_FREE
+    #define ATOMIC_CHAR_LOCK_FREE __GCC_ATOMIC_CHAR_LOCK_FREE
+    #define ATOMIC_CHAR16_T_LOCK_FREE __GCC_ATOMIC_CHAR16_T_LOCK_FREE
+    #define ATOMIC_CHAR32_T_LOCK_FREE __GCC_ATOMIC_CHAR32_T_LOCK_FREE
+    #define ATOMIC_WCHAR_T_LOCK_FREE __GCC_ATOMIC_WCHAR_T_LOCK_FREE
+    #define ATOMIC_SHORT_LOCK_FREE __GCC_ATOMIC_SHORT_LOCK_FREE
+    #define ATOMIC_INT_LOCK_FREE __GCC_ATOMIC_INT_LOCK_FREE
+    #define ATOMIC_LONG_LOCK_FREE __GCC_ATOMIC_LONG_LOCK_FREE
+    #define ATOMIC_LLONG_LOCK_FREE __GCC_ATOMIC_LLONG_LOCK_FREE
+    #define ATOMIC_POINTER_LOCK_FREE __GCC_ATOMIC_POINTER_LOCK_FREE
+
+    /**
+     * 29.6.5, initialization:
+     */
+
+    #define ATOMIC_VAR_INIT(value) { value }
+
+    namespace aux
+    {
+        /**
+         * The failure order of compare_exchange derived
+         * from a single order, it cannot release.
+         */
+        constexpr memory_order atomic_failure_order(memory_order mo) noexcept
+        {
+            if (mo == memory_order_acq_rel)
+                return memory_order_acquire;
+            else if (mo == memory_order_release)
+                return memory_order_relaxed;
+            else
+                return mo;
+        }
+
+        /**
+         * Note: Values are compared by their representation
+         *       like compare_exchange does it.
+         */
+        template<class T>
+        bool atomic_same(const T& lhs, const T& rhs) noexcept
+        {
+            return __builtin_memcmp(&lhs, &rhs, sizeof(T)) == 0;
+        }
+
+        template<class T>
+        class atomic_base
+        {
+            static_assert(is_trivially_copyable_v<T>,
+                          "atomic<T> requires a trivially copyable T");
+
+            /**
+             * TODO: Larger types would need a lock, which
+             *       libgcc does not provide to us.
+             */
+            static_assert(sizeof(T) == 1 || sizeof(T) == 2 ||
+                          sizeof(T) == 4 || sizeof(T) == 8,
+                          "atomic<T> is only implemented for lock-free T");
+
+            public:
+                using value_type = T;
+
+                atomic_base() noexcept = default;
+
+                constexpr atomic_base(T desired) noexcept
+                    : value_{desired}
+                { /* DUMMY BODY */ }
+
+                atomic_base(const atomic_base&) = delete;
+                atomic_base& operator=(const atomic_base&) = delete;
+
+                /**
+                 * TODO: The volatile overloads of the
+                 *       operations are missing.
+                 */
+
+                bool is_lock_free() const noexcept
+                {
+                    return __atomic_is_lock_free(sizeof(T), &value_);
+                }
+
+                void store(T desired, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    __atomic_store(&value_, &desired, mo);
+                }
+
+                T load(memory_order mo = memory_order_seq_cst) const noexcept
+                {
+                    T res;
+                    __atomic_load(&value_, &res, mo);
+
+                    return res;
+                }
+
+                operator T() const noexcept
+                {
+                    return load();
+                }
+
+                T operator=(T desired) noexcept
+                {
+                    store(desired);
+
+                    return desired;
+                }
+
+                T exchange(T desired, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    T res;
+                    __atomic_exchange(&value_, &desired, &res, mo);
+
+                    return res;
+                }
+
+                bool compare_exchange_weak(T& expected, T desired,
+                                           memory_order success,
+                                           memory_order failure) noexcept
+                {
+                    return __atomic_compare_exchange(
+                        &value_, &expected, &desired, true, success, failure
+                    );
+                }
+
+                bool compare_exchange_weak(T& expected, T desired,
+                                           memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return compare_exchange_weak(
+                        expected, desired, mo, atomic_failure_order(mo)
+                    );
+                }
+
+                bool compare_exchange_strong(T& expected, T desired,
+                                             memory_order success,
+                                             memory_order failure) noexcept
+                {
+                    return __atomic_compare_exchange(
+                        &value_, &expected, &desired, false, success, failure
+                    );
+                }
+
+                bool compare_exchange_strong(T& expected, T desired,
+                                             memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return compare_exchange_strong(
+                        expected, desired, mo, atomic_failure_order(mo)
+                    );
+                }
+
+                /**
+                 * Blocks until a notification finds a value
+                 * different from old.
+                 */
+                void wait(T old, memory_order mo = memory_order_seq_cst) const noexcept
+                {
+                    aux::atomic_wait(&value_, [this, &old, mo](){
+                        return !atomic_same(load(mo), old);
+                    });
+                }
+
+                /**
+                 * Note: Waiters share slots, notify_one wakes up
+                 *       all waiters and the others see no change.
+                 */
+                void notify_one() noexcept
+                {
+                    aux::atomic_notify(&value_);
+                }
+
+                void notify_all() noexcept
+                {
+                    aux::atomic_notify(&value_);
+                }
+
+            protected:
+                alignas(sizeof(T)) T value_;
+        };
+
+        template<class T>
+        class atomic_integral: public atomic_base<T>
+        {
+            public:
+                using difference_type = T;
+
+                using atomic_base<T>::atomic_base;
+                using atomic_base<T>::operator=;
+
+                T fetch_add(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_add(&this->value_, arg, mo);
+                }
+
+                T fetch_sub(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_sub(&this->value_, arg, mo);
+                }
+
+                T fetch_and(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_and(&this->value_, arg, mo);
+                }
+
+                T fetch_or(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_or(&this->value_, arg, mo);
+                }
+
+                T fetch_xor(T arg, memory_order mo = memory_order_seq_cst) noexcept
+                {
+                    return __atomic_fetch_xor(&this->value_, arg, mo);
+                }
+
+                T operator++(int) noexcept
+                {
+                    return fetch_add(1);
+                }
+
+                T operator--(int) noexcept
+                {
+                    return fetch_sub(1);
+                }
+
+                T operator++() noexcept
+                {
+                    return __atomic_add_fetch(&this->value_, 1, __ATOMIC_SEQ_CST);
+                }
+
+                T operator--() noexcept
+                {
+                    return __atomic_sub_fetch(&this->value_, 1, __ATOMIC_SEQ_CST);
+                }
+
+                T operator+=(T arg) noexcept
+                {
+                    return __atomic_add_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+
+                T operator-=(T arg) noexcept
+                {
+                    return __atomic_sub_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+
+                T operator&=(T arg) noexcept
+                {
+                    return __atomic_and_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+
+                T operator|=(T arg) noexcept
+                {
+                    return __atomic_or_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+
+                T operator^=(T arg) noexcept
+                {
+                    return __atomic_xor_fetch(&this->value_, arg, __ATOMIC_SEQ_CST);
+                }
+        };
+
+        template<class T>
+        using atomic_base_for = conditional_t<
+            is_integral<T>::value && !is_same_v<remove_cv_t<T>, bool>,
+            atomic_integral<T>, atomic_base<T>
+        >;
+    }
+
+    /**
+     * 29.5, atomic types:
+     */
+
+    template<class T>
+    struct atomic: aux::atomic_base_for<T>
+    {
+        static constexpr bool is_always_lock_free =
+            __atomic_always_lock_free(sizeof(T), 0);
+
+        atomic() noexcept = default;
+
+        constexpr atomic(T desired) noexcept
+            : aux::atomic_base_for<T>{desired}
+        { /* DUMMY BODY */ }
+
+        atomic(const atomic&) = delete;
+        atomic& operator=(const atomic&) = delete;
+
+        using aux::atomic_base_for<T>::operator=;
+    };
+
+    template<class T>
+    struct atomic<T*>: aux::atomic_base<T*>
+    {
+        using difference_type = ptrdiff_t;
+
+        static constexpr bool is_always_lock_free =
+            __atomic_always_lock_free(sizeof(T*), 0);
+
+        atomic() noexcept = default;
+
+        constexpr atomic(T* desired) noexcept
+            : aux::atomic_base<T*>{desired}
+        { /* DUMMY BODY */ }
+
+        atomic(const atomic&) = delete;
+        atomic& operator=(const atomic&) = delete;
+
+        using aux::atomic_base<T*>::operator=;
+
+        /**
+         * Note: The builtins do not scale the argument
+         *       by the size of the pointee.
+         */
+
+        T* fetch_add(ptrdiff_t arg, memory_order mo = memory_order_seq_cst) noexcept
+        {
+            return __atomic_fetch_add(&this->value_, arg * sizeof(T), mo);
+        }
+
+        T* fetch_sub(ptrdiff_t arg, memory_order mo = memory_order_seq_cst) noexcept
+        {
+            return __atomic_fetch_sub(&this->value_, arg * sizeof(T), mo);
+        }
+
+        T* operator++(int) noexcept
+        {
+            return fetch_add(1);
+        }
+
+        T* operator--(int) noexcept
+        {
+            return fetch_sub(1);
+        }
+
+        T* operator++() noexcept
+        {
+            return fetch_add(1) + 1;
+        }
+
+        T* operator--() noexcept
+        {
+            return fetch_sub(1) - 1;
+        }
+
+        T* operator+=(ptrdiff_t arg) noexcept
+        {
+            return fetch_add(arg) + arg;
+        }
+
+        T* operator-=(ptrdiff_t arg) noexcept
+        {
+            return fetch_sub(arg) - arg;
+        }
+    };
+
+    using atomic_bool     = atomic<bool>;
+    using atomic_char     = atomic<char>;
+    using atomic_schar    = atomic<signed char>;
+    using atomic_uchar    = atomic<unsigned char>;
+    using atomic_short    = atomic<short>;
+    using atomic_ushort   = atomic<unsigned short>;
+    using atomic_int      = atomic<int>;
+    using atomic_uint     = atomic<unsigned int>;
+    using atomic_long     = atomic<long>;
+    using atomic_ulong    = atomic<unsigned long>;
+    using atomic_llong    = atomic<long long>;
+    using atomic_ullong   = atomic<unsigned long long>;
+    using atomic_char16_t = atomic<char16_t>;
+    using atomic_char32_t = atomic<char32_t>;
+    using atomic_wchar_t  = atomic<wchar_t>;
+
+    using atomic_int8_t    = atomic<int8_t>;
+    using atomic_uint8_t   = atomic<uint8_t>;
+    using atomic_int16_t   = atomic<int16_t>;
+    using atomic_uint16_t  = atomic<uint16_t>;
+    using atomic_int32_t   = atomic<int32_t>;
+    using atomic_uint32_t  = atomic<uint32_t>;
+    using atomic_int64_t   = atomic<int64_t>;
+    using atomic_uint64_t  = atomic<uint64_t>;
+    using atomic_intptr_t  = atomic<intptr_t>;
+    using atomic_uintptr_t = atomic<uintptr_t>;
+    using atomic_size_t    = atomic<size_t>;
+    using atomic_ptrdiff_t = atomic<ptrdiff_t>;
+    using atomic_intmax_t  = atomic<intmax_t>;
+    using atomic_uintmax_t = atomic<uintmax_t>;
+
+    /**
+     * 29.6, operations on atomic types:
+     */
+
+    template<class T>
+    bool atomic_is_lock_free(const atomic<T>* obj) noexcept
+    {
+        return obj->is_lock_free();
+    }
+
+    template<class T>
+    void atomic_init(atomic<T>* obj, typename atomic<T>::value_type desired) noexcept
+    {
+        obj->store(desired, memory_order_relaxed);
+    }
+
+    template<class T>
+    void atomic_store(atomic<T>* obj, typename atomic<T>::value_type desired) noexcept
+    {
+        obj->store(desired);
+    }
+
+    template<class T>
+    void atomic_store_explicit(atomic<T>* obj, typename atomic<T>::value_type desired,
+                               memory_order mo) noexcept
+    {
+        obj->store(desired, mo);
+    }
+
+    template<class T>
+    T atomic_load(const atomic<T>* obj) noexcept
+    {
+        return obj->load();
+    }
+
+    template<class T>
+    T atomic_load_explicit(const atomic<T>* obj, memory_order mo) noexcept
+    {
+        return obj->load(mo);
+    }
+
+    template<class T>
+    T atomic_exchange(atomic<T>* obj, typename atomic<T>::value_type desired) noexcept
+    {
+        return obj->exchange(desired);
+    }
+
+    template<class T>
+    T atomic_exchange_explicit(atomic<T>* obj, typename atomic<T>::value_type desired,
+                               memory_order mo) noexcept
+    {
+        return obj->exchange(desired, mo);
+    }
+
+    template<class T>
+    bool atomic_compare_exchange_weak(atomic<T>* obj,
+                                      typename atomic<T>::value_type* expected,
+                                      typename atomic<T>::value_type desired) noexcept
+    {
+        return obj->compare_exchange_weak(*expected, desired);
+    }
+
+    template<class T>
+    bool atomic_compare_exchange_strong(atomic<T>* obj,
+                                        typename atomic<T>::value_type* expected,
+                                        typename atomic<T>::value_type desired) noexcept
+    {
+        return obj->compare_exchange_strong(*expected, desired);
+    }
+
+    template<class T>
+    bool atomic_compare_exchange_weak_explicit(atomic<T>* obj,
+                                               typename atomic<T>::value_type* expected,
+                                               typename atomic<T>::value_type desired,
+                                               memory_order success,
+                                               memory_order failure) noexcept
+    {
+        return obj->compare_exchange_weak(*expected, desired, success, failure);
+    }
+
+    template<class T>
+    bool atomic_compare_exchange_strong_explicit(atomic<T>* obj,
+                                                 typename atomic<T>::value_type* expected,
+                                                 typename atomic<T>::value_type desired,
+                                                 memory_order success,
+                                                 memory_order failure) noexcept
+    {
+        return obj->compare_exchange_strong(*expected, desired, success, failure);
+    }
+
+    template<class T>
+    T atomic_fetch_add(atomic<T>* obj, typename atomic<T>::difference_type arg) noexcept
+    {
+        return obj->fetch_add(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_add_explicit(atomic<T>* obj, typename atomic<T>::difference_type arg,
+                                memory_order mo) noexcept
+    {
+        return obj->fetch_add(arg, mo);
+    }
+
+    template<class T>
+    T atomic_fetch_sub(atomic<T>* obj, typename atomic<T>::difference_type arg) noexcept
+    {
+        return obj->fetch_sub(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_sub_explicit(atomic<T>* obj, typename atomic<T>::difference_type arg,
+                                memory_order mo) noexcept
+    {
+        return obj->fetch_sub(arg, mo);
+    }
+
+    template<class T>
+    T atomic_fetch_and(atomic<T>* obj, typename atomic<T>::value_type arg) noexcept
+    {
+        return obj->fetch_and(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_and_explicit(atomic<T>* obj, typename atomic<T>::value_type arg,
+                                memory_order mo) noexcept
+    {
+        return obj->fetch_and(arg, mo);
+    }
+
+    template<class T>
+    T atomic_fetch_or(atomic<T>* obj, typename atomic<T>::value_type arg) noexcept
+    {
+        return obj->fetch_or(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_or_explicit(atomic<T>* obj, typename atomic<T>::value_type arg,
+                               memory_order mo) noexcept
+    {
+        return obj->fetch_or(arg, mo);
+    }
+
+    template<class T>
+    T atomic_fetch_xor(atomic<T>* obj, typename atomic<T>::value_type arg) noexcept
+    {
+        return obj->fetch_xor(arg);
+    }
+
+    template<class T>
+    T atomic_fetch_xor_explicit(atomic<T>* obj, typename atomic<T>::value_type arg,
+                                memory_order mo) noexcept
+    {
+        return obj->fetch_xor(arg, mo);
+    }
+
+    template<class T>
+    void atomic_wait(const atomic<T>* obj, typename atomic<T>::value_type old) noexcept
+    {
+        obj->wait(old);
+    }
+
+    template<class T>
+    void atomic_wait_explicit(const atomic<T>* obj, typename atomic<T>::value_type old,
+                              memory_order mo) noexcept
+    {
+        obj->wait(old, mo);
+    }
+
+    template<class T>
+    void atomic_notify_one(atomic<T>* obj) noexcept
+    {
+        obj->notify_one();
+    }
+
+    template<class T>
+    void atomic_notify_all(atomic<T>* obj) noexcept
+    {
+        obj->notify_all();
+    }
+
+    /**
+     * 29.7, flag type and operations:
+     */
+
+    struct atomic_flag
+    {
+        atomic_flag() noexcept = default;
+
+        /**
+         * Note: Used by ATOMIC_FLAG_INIT.
+         */
+        constexpr atomic_flag(bool flag) noexcept
+            : flag_{flag}
+        { /* DUMMY BODY */ }
+
+        atomic_flag(const atomic_flag&) = delete;
+        atomic_flag& operator=(const atomic_flag&) = delete;
+
+        bool test(memory_order mo = memory_order_seq_cst) const noexcept
+        {
+            return __atomic_load_n(&flag_, mo) != 0;
+        }
+
+        bool test_and_set(memory_order mo = memory_order_seq_cst) noexcept
+        {
+            return __atomic_test_and_set(&flag_, mo);
+        }
+
+        void clear(memory_order mo = memory_order_seq_cst) noexcept
+        {
+            __atomic_clear(&flag_, mo);
+        }
+
+        void wait(bool old, memory_order mo = memory_order_seq_cst) const noexcept
+        {
+            aux::atomic_wait(&flag_, [this, old, mo](){
+                return test(mo) != old;
+            });
+        }
+
+        void notify_one() noexcept
+        {
+            aux::atomic_notify(&flag_);
+        }
+
+        void notify_all() noexcept
+        {
+            aux::atomic_notify(&flag_);
+        }
+
+        private:
+            unsigned char flag_;
+    };
+
+    #define ATOMIC_FLAG_INIT { false }
+
+    inline bool atomic_flag_test(const atomic_flag* flag) noexcept
+    {
+        return flag->test();
+    }
+
+    inline bool atomic_flag_test_explicit(const atomic_flag* flag,
+                                          memory_order mo) noexcept
+    {
+        return flag->test(mo);
+    }
+
+    inline bool atomic_flag_test_and_set(atomic_flag* flag) noexcept
+    {
+        return flag->test_and_set();
+    }
+
+    inline bool atomic_flag_test_and_set_explicit(atomic_flag* flag,
+                                                  memory_order mo) noexcept
+    {
+        return flag->test_and_set(mo);
+    }
+
+    inline void atomic_flag_clear(atomic_flag* flag) noexcept
+    {
+        flag->clear();
+    }
+
+    inline void atomic_flag_clear_explicit(atomic_flag* flag,
+                                           memory_order mo) noexcept
+    {
+        flag->clear(mo);
+    }
+
+    inline void atomic_flag_wait(const atomic_flag* flag, bool old) noexcept
+    {
+        flag->wait(old);
+    }
+
+    inline void atomic_flag_notify_one(atomic_flag* flag) noexcept
+    {
+        flag->notify_one();
+    }
+
+    inline void atomic_flag_notify_all(atomic_flag* flag) noexcept
+    {
+        flag->notify_all();
+    }
+
+    /**
+     * 29.8, fences:
+     */
+
+    inline void atomic_thread_fence(memory_order mo) noexcept
+    {
+        __atomic_thread_fence(mo);
+    }
+
+    inline void atomic_signal_fence(memory_order mo) noexcept
+    {
+        __atomic_signal_fence(mo);
+    }
+}
 
 #endif
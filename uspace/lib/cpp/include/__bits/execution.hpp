@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_EXECUTION
+#define LIBCPP_BITS_EXECUTION
+
+#include <__bits/thread/thread_pool.hpp>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+
+namespace std
+{
+    /**
+     * 23.19, execution policies:
+     */
+
+    template<class T>
+    struct is_execution_policy: false_type
+    { /* DUMMY BODY */ };
+
+    template<class T>
+    inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+    namespace execution
+    {
+        class sequenced_policy
+        { /* DUMMY BODY */ };
+
+        class parallel_policy
+        { /* DUMMY BODY */ };
+
+        /**
+         * Note: The workers do not vectorize, so this
+         *       is equivalent to parallel_policy.
+         */
+        class parallel_unsequenced_policy
+        { /* DUMMY BODY */ };
+
+        inline constexpr sequenced_policy seq{};
+        inline constexpr parallel_policy par{};
+        inline constexpr parallel_unsequenced_policy par_unseq{};
+    }
+
+    template<>
+    struct is_execution_policy<execution::sequenced_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::parallel_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    template<>
+    struct is_execution_policy<execution::parallel_unsequenced_policy>: true_type
+    { /* DUMMY BODY */ };
+
+    namespace aux
+    {
+        template<class ExecutionPolicy, class T>
+        using enable_if_policy_t = enable_if_t<
+            is_execution_policy_v<decay_t<ExecutionPolicy>>, T
+        >;
+
+        /**
+         * The parallel algorithms split their range into
+         * chunks, so they run in parallel only when all of
+         * the iterators involved are random access.
+         */
+        template<class ExecutionPolicy, class... Iterators>
+        inline constexpr bool run_parallel_v =
+            !is_same_v<decay_t<ExecutionPolicy>, execution::sequenced_policy> &&
+            (is_base_of_v<
+                random_access_iterator_tag,
+                typename iterator_traits<Iterators>::iterator_category
+             > && ...);
+
+        /**
+         * Minimal number of elements per chunk, we have no
+         * idea how expensive the user supplied functions are
+         * so this only prevents the scheduling overhead from
+         * dominating on trivial ones.
+         */
+        inline constexpr size_t parallel_grain{2048};
+
+        /**
+         * A few chunks per worker, so that the stealing
+         * can balance uneven chunks.
+         */
+        template<class Size>
+        size_t parallel_chunk_count(Size count)
+        {
+            size_t max_chunks = thread_pool::instance().size() * 4;
+            size_t chunks = static_cast<size_t>(count) / parallel_grain;
+
+            return chunks < max_chunks ? chunks : max_chunks;
+        }
+
+        /**
+         * Calls f(idx, begin, end) for each of the chunks
+         * of [0, count) on the thread pool and waits for all
+         * of them to finish, the last chunk is processed by
+         * the calling fibril.
+         */
+        template<class Size, class Function>
+        void parallel_for_chunks(Size count, size_t chunks, Function f)
+        {
+            Size step = count / static_cast<Size>(chunks);
+            Size extra = count % static_cast<Size>(chunks);
+
+            task_group group{};
+            Size begin{};
+            for (size_t i = 0; i < chunks; ++i)
+            {
+                Size end = begin + step + (static_cast<Size>(i) < extra ? 1 : 0);
+
+                if (i + 1 == chunks)
+                    f(i, begin, end);
+                else
+                    group.run([&f, i, begin, end](){ f(i, begin, end); });
+
+                begin = end;
+            }
+
+            group.wait();
+        }
+
+        template<class Size, class Function>
+        void parallel_for_range(Size count, Function f)
+        {
+            auto chunks = parallel_chunk_count(count);
+            if (chunks < 2)
+            {
+                f(size_t{}, Size{}, count);
+
+                return;
+            }
+
+            parallel_for_chunks(count, chunks, f);
+        }
+
+        inline constexpr ptrdiff_t parallel_sort_grain{8192};
+
+        /**
+         * Quicksort that forks the upper partitions into the pool
+         * until they get small enough for the sequential sort.
+         */
+        template<class RandomAccessIterator, class Size, class Compare>
+        void parallel_sort_loop(task_group& group, RandomAccessIterator first,
+                                RandomAccessIterator last, Size depth_limit,
+                                Compare comp)
+        {
+            while (last - first > parallel_sort_grain)
+            {
+                if (depth_limit == 0)
+                    break;
+                --depth_limit;
+
+                auto cut = partition_pivot(first, last, comp);
+                group.run([&group, cut, last, depth_limit, comp](){
+                    parallel_sort_loop(group, cut, last, depth_limit, comp);
+                });
+                last = cut;
+            }
+
+            sort(first, last, comp);
+        }
+    }
+
+    /**
+     * 25.2.4, for each:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator, class Function>
+    aux::enable_if_policy_t<ExecutionPolicy, void>
+    for_each(ExecutionPolicy&&, ForwardIterator first, ForwardIterator last,
+             Function f)
+    {
+        if constexpr (aux::run_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            aux::parallel_for_range(last - first, [&](size_t, auto begin, auto end){
+                for_each(first + begin, first + end, f);
+            });
+        }
+        else
+            for_each(first, last, f);
+    }
+
+    /**
+     * 25.3.1, copy:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator1, class ForwardIterator2>
+    aux::enable_if_policy_t<ExecutionPolicy, ForwardIterator2>
+    copy(ExecutionPolicy&&, ForwardIterator1 first, ForwardIterator1 last,
+         ForwardIterator2 result)
+    {
+        if constexpr (aux::run_parallel_v<ExecutionPolicy, ForwardIterator1, ForwardIterator2>)
+        {
+            auto count = last - first;
+            aux::parallel_for_range(count, [&](size_t, auto begin, auto end){
+                copy(first + begin, first + end, result + begin);
+            });
+
+            return result + count;
+        }
+        else
+            return copy(first, last, result);
+    }
+
+    /**
+     * 25.3.4, transform:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator1,
+             class ForwardIterator2, class UnaryOperation>
+    aux::enable_if_policy_t<ExecutionPolicy, ForwardIterator2>
+    transform(ExecutionPolicy&&, ForwardIterator1 first, ForwardIterator1 last,
+              ForwardIterator2 result, UnaryOperation op)
+    {
+        if constexpr (aux::run_parallel_v<ExecutionPolicy, ForwardIterator1, ForwardIterator2>)
+        {
+            auto count = last - first;
+            aux::parallel_for_range(count, [&](size_t, auto begin, auto end){
+                transform(first + begin, first + end, result + begin, op);
+            });
+
+            return result + count;
+        }
+        else
+            return transform(first, last, result, op);
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator1, class ForwardIterator2,
+             class ForwardIterator3, class BinaryOperation>
+    aux::enable_if_policy_t<ExecutionPolicy, ForwardIterator3>
+    transform(ExecutionPolicy&&, ForwardIterator1 first1, ForwardIterator1 last1,
+              ForwardIterator2 first2, ForwardIterator3 result, BinaryOperation op)
+    {
+        if constexpr (aux::run_parallel_v<ExecutionPolicy, ForwardIterator1,
+                                          ForwardIterator2, ForwardIterator3>)
+        {
+            auto count = last1 - first1;
+            aux::parallel_for_range(count, [&](size_t, auto begin, auto end){
+                transform(first1 + begin, first1 + end, first2 + begin,
+                          result + begin, op);
+            });
+
+            return result + count;
+        }
+        else
+            return transform(first1, last1, first2, result, op);
+    }
+
+    /**
+     * 25.4.1.1, sort:
+     */
+
+    template<class ExecutionPolicy, class RandomAccessIterator, class Compare>
+    aux::enable_if_policy_t<ExecutionPolicy, void>
+    sort(ExecutionPolicy&&, RandomAccessIterator first, RandomAccessIterator last,
+         Compare comp)
+    {
+        if constexpr (aux::run_parallel_v<ExecutionPolicy, RandomAccessIterator>)
+        {
+            if (last - first <= aux::parallel_sort_grain)
+            {
+                sort(first, last, comp);
+
+                return;
+            }
+
+            aux::task_group group{};
+            aux::parallel_sort_loop(group, first, last,
+                                    aux::sort_depth_limit(last - first), comp);
+            group.wait();
+        }
+        else
+            sort(first, last, comp);
+    }
+
+    template<class ExecutionPolicy, class RandomAccessIterator>
+    aux::enable_if_policy_t<ExecutionPolicy, void>
+    sort(ExecutionPolicy&& policy, RandomAccessIterator first,
+         RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        sort(forward<ExecutionPolicy>(policy), first, last, less<value_type>{});
+    }
+
+    /**
+     * 29.8.3, reduce:
+     */
+
+    template<class ExecutionPolicy, class ForwardIterator, class T,
+             class BinaryOperation>
+    aux::enable_if_policy_t<ExecutionPolicy, T>
+    reduce(ExecutionPolicy&&, ForwardIterator first, ForwardIterator last,
+           T init, BinaryOperation op)
+    {
+        if constexpr (aux::run_parallel_v<ExecutionPolicy, ForwardIterator>)
+        {
+            auto count = last - first;
+            auto chunks = aux::parallel_chunk_count(count);
+            if (chunks < 2)
+                return reduce(first, last, move(init), op);
+
+            /**
+             * Chunks are never empty, so every partial
+             * result starts with the chunk's first element.
+             */
+            allocator<T> alloc{};
+            T* partial = alloc.allocate(chunks);
+            aux::parallel_for_chunks(count, chunks, [&](size_t idx, auto begin, auto end){
+                ::new(partial + idx) T(reduce(
+                    first + begin + 1, first + end, T(*(first + begin)), op
+                ));
+            });
+
+            auto acc{move(init)};
+            for (size_t i = 0; i < chunks; ++i)
+            {
+                acc = op(move(acc), move(partial[i]));
+                partial[i].~T();
+            }
+            alloc.deallocate(partial, chunks);
+
+            return acc;
+        }
+        else
+            return reduce(first, last, move(init), op);
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator, class T>
+    aux::enable_if_policy_t<ExecutionPolicy, T>
+    reduce(ExecutionPolicy&& policy, ForwardIterator first, ForwardIterator last,
+           T init)
+    {
+        return reduce(forward<ExecutionPolicy>(policy), first, last, move(init),
+                      plus<>{});
+    }
+
+    template<class ExecutionPolicy, class ForwardIterator>
+    aux::enable_if_policy_t<
+        ExecutionPolicy, typename iterator_traits<ForwardIterator>::value_type
+    >
+    reduce(ExecutionPolicy&& policy, ForwardIterator first, ForwardIterator last)
+    {
+        using value_type = typename iterator_traits<ForwardIterator>::value_type;
+
+        return reduce(forward<ExecutionPolicy>(policy), first, last, value_type{},
+                      plus<>{});
+    }
+}
+
+#endif
@@ -73,6 +73,13 @@ namespace std
             new(to) Callable{*from};
         }
 
+        template<class Callable>
+        void move_callable(Callable* to, Callable* from)
+        {
+            new(to) Callable{move(*from)};
+            from->~Callable();
+        }
+
         template<class Callable>
         void destroy_callable(Callable* clbl)
         {
@@ -81,6 +88,21 @@ namespace std
         }
     }
 
+    namespace aux
+    {
+        /**
+         * Strictest alignment a target stored inline
+         * in a function can have.
+         */
+        union function_align_type
+        {
+            long long ll;
+            long double ld;
+            void* ptr;
+            void (*fptr)();
+        };
+    }
+
     // TODO: implement
     class bad_function_call;
 
@@ -88,12 +110,13 @@ namespace std
     class function; // undefined
 
     /**
-     * Note: Ideally, this implementation wouldn't
-     *       copy the target if it was a pointer to
-     *       a function, but for the simplicity of the
-     *       implementation, we do copy even in that
-     *       case for now. It would be a nice optimization
-     *       if this was changed in the future.
+     * Note: Targets that are small enough and cannot
+     *       throw when moved (function pointers, lambdas
+     *       with a few captures, bind expressions over
+     *       a few arguments) are stored inline and never
+     *       allocate. Larger targets are kept on the heap
+     *       and moving the function just passes the pointer
+     *       along.
      */
     template<class R, class... Args>
     class function<R(Args...)>
@@ -108,7 +131,7 @@ namespace std
 
             function() noexcept
                 : callable_{}, callable_size_{}, call_{},
-                  copy_{}, dest_{}
+                  copy_{}, move_{}, dest_{}
             { /* DUMMY BODY */ }
 
             function(nullptr_t) noexcept
@@ -116,34 +139,42 @@ namespace std
             { /* DUMMY BODY */ }
 
             function(const function& other)
-                : callable_{}, callable_size_{other.callable_size_},
-                  call_{other.call_}, copy_{other.copy_}, dest_{other.dest_}
+                : function{}
             {
-                callable_ = new uint8_t[callable_size_];
+                if (!other.callable_)
+                    return;
+
+                callable_size_ = other.callable_size_;
+                call_ = other.call_;
+                copy_ = other.copy_;
+                move_ = other.move_;
+                dest_ = other.dest_;
+
+                if (other.is_inline_())
+                    callable_ = storage_;
+                else
+                    callable_ = new uint8_t[callable_size_];
                 (*copy_)(callable_, other.callable_);
             }
 
-            function(function&& other)
-                : callable_{other.callable_}, callable_size_{other.callable_size_},
-                  call_{other.call_}, copy_{other.copy_}, dest_{other.dest_}
+            function(function&& other) noexcept
+                : function{}
             {
-                other.callable_ = nullptr;
-                other.callable_size_ = size_t{};
-                other.call_ = nullptr;
-                other.copy_ = nullptr;
-                other.dest_ = nullptr;
+                take_(other);
             }
 
             // TODO: shall not participate in overloading unless aux::is_callable<F>
             template<class F>
             function(F f)
-                : callable_{}, callable_size_{sizeof(F)},
-                  call_{(call_t)aux::invoke_callable<F, R, Args...>},
-                  copy_{(copy_t)aux::copy_callable<F>},
-                  dest_{(dest_t)aux::destroy_callable<F>}
+                : function{}
             {
-                callable_ = new uint8_t[callable_size_];
-                (*copy_)(callable_, (uint8_t*)&f);
+                if constexpr (is_pointer_v<F> || is_member_pointer_v<F>)
+                {
+                    if (!f)
+                        return;
+                }
+
+                init_(move(f));
             }
 
             /**
@@ -174,7 +205,7 @@ namespace std
             // TODO: shall not participate in overloading unless aux::is_callable<F>
             template<class F, class A>
             function(allocator_arg_t, const A& a, F f)
-                : function{f}
+                : function{move(f)}
             { /* DUMMY BODY */ }
 
             function& operator=(const function& rhs)
@@ -184,26 +215,13 @@ namespace std
                 return *this;
             }
 
-            /**
-             * Note: We have to copy call_, copy_
-             *       and dest_ because they can be templated
-             *       by a type F we don't know.
-             */
-            function& operator=(function&& rhs)
+            function& operator=(function&& rhs) noexcept
             {
-                clear_();
-
-                callable_ = rhs.callable_;
-                callable_size_ = rhs.callable_size_;
-                call_ = rhs.call_;
-                copy_ = rhs.copy_;
-                dest_ = rhs.dest_;
-
-                rhs.callable_ = nullptr;
-                rhs.callable_size_ = size_t{};
-                rhs.call_ = nullptr;
-                rhs.copy_ = nullptr;
-                rhs.dest_ = nullptr;
+                if (this != &rhs)
+                {
+                    clear_();
+                    take_(rhs);
+                }
 
                 return *this;
             }
@@ -216,16 +234,13 @@ namespace std
             }
 
             // TODO: shall not participate in overloading unless aux::is_callable<F>
-            template<class F>
+            template<
+                class F,
+                class = enable_if_t<!is_same_v<decay_t<F>, function>>
+            >
             function& operator=(F&& f)
             {
-                callable_size_ = sizeof(F);
-                callable_ = new uint8_t[callable_size_];
-                call_ = aux::invoke_callable<F, R, Args...>;
-                copy_ = aux::copy_callable<F>;
-                dest_ = aux::destroy_callable<F>;
-
-                (*copy_)(callable_, (uint8_t*)&f);
+                return (*this) = function{forward<F>(f)};
             }
 
             template<class F>
@@ -236,11 +251,7 @@ namespace std
 
             ~function()
             {
-                if (callable_)
-                {
-                    (*dest_)(callable_);
-                    delete[] callable_;
-                }
+                clear_();
             }
 
             /**
@@ -249,11 +260,10 @@ namespace std
 
             void swap(function& other) noexcept
             {
-                std::swap(callable_, other.callable_);
-                std::swap(callable_size_, other.callable_size_);
-                std::swap(call_, other.call_);
-                std::swap(copy_, other.copy_);
-                std::swap(dest_, other.dest_);
+                function tmp{move(other)};
+
+                other = move(*this);
+                (*this) = move(tmp);
             }
 
             template<class F, class A>
@@ -314,20 +324,93 @@ namespace std
         private:
             using call_t = R(*)(uint8_t*, Args&&...);
             using copy_t = void (*)(uint8_t*, uint8_t*);
+            using move_t = void (*)(uint8_t*, uint8_t*);
             using dest_t = void (*)(uint8_t*);
 
+            static constexpr size_t inline_size_{4 * sizeof(void*)};
+
+            /**
+             * Moving an inline target must not throw,
+             * otherwise moving the function could not
+             * be noexcept.
+             */
+            template<class F>
+            static constexpr bool is_inline_target_()
+            {
+                return sizeof(F) <= inline_size_ &&
+                       alignof(F) <= alignof(aux::function_align_type) &&
+                       is_nothrow_move_constructible<F>::value;
+            }
+
             uint8_t* callable_;
             size_t callable_size_;
             call_t call_;
             copy_t copy_;
+            move_t move_;
             dest_t dest_;
+            alignas(aux::function_align_type) uint8_t storage_[inline_size_];
+
+            bool is_inline_() const noexcept
+            {
+                return callable_ == storage_;
+            }
+
+            template<class F>
+            void init_(F&& f)
+            {
+                using callable_type = decay_t<F>;
+
+                callable_size_ = sizeof(callable_type);
+                call_ = (call_t)aux::invoke_callable<callable_type, R, Args...>;
+                copy_ = (copy_t)aux::copy_callable<callable_type>;
+                move_ = (move_t)aux::move_callable<callable_type>;
+                dest_ = (dest_t)aux::destroy_callable<callable_type>;
+
+                if constexpr (is_inline_target_<callable_type>())
+                    callable_ = storage_;
+                else
+                    callable_ = new uint8_t[callable_size_];
+                new(callable_) callable_type{forward<F>(f)};
+            }
+
+            /**
+             * Takes the target of other, this function
+             * must be empty.
+             */
+            void take_(function& other) noexcept
+            {
+                if (!other.callable_)
+                    return;
+
+                callable_size_ = other.callable_size_;
+                call_ = other.call_;
+                copy_ = other.copy_;
+                move_ = other.move_;
+                dest_ = other.dest_;
+
+                if (other.is_inline_())
+                {
+                    callable_ = storage_;
+                    (*move_)(callable_, other.callable_);
+                }
+                else
+                    callable_ = other.callable_;
+
+                other.callable_ = nullptr;
+                other.callable_size_ = size_t{};
+                other.call_ = nullptr;
+                other.copy_ = nullptr;
+                other.move_ = nullptr;
+                other.dest_ = nullptr;
+            }
 
             void clear_()
             {
                 if (callable_)
                 {
                     (*dest_)(callable_);
-                    delete[] callable_;
+                    if (!is_inline_())
+                        delete[] callable_;
                     callable_ = nullptr;
                 }
             }
@@ -32,6 +32,7 @@
 namespace std
 {
     struct forward_iterator_tag;
+    struct input_iterator_tag;
 }
 
 namespace std::aux
@@ -39,6 +39,21 @@
 
 namespace std
 {
+    namespace aux
+    {
+        /**
+         * The VFS calls are kept out of line so that <fstream>
+         * does not drag <vfs/vfs.h> into user code. All of these
+         * return a negative value on failure.
+         */
+
+        int filebuf_open(const char* name, const char* mode);
+        int filebuf_close(int fd);
+        streamsize filebuf_read(int fd, streamoff& pos, void* buf, size_t size);
+        streamsize filebuf_write(int fd, streamoff& pos, const void* buf, size_t size);
+        streamoff filebuf_size(int fd);
+    }
+
     /**
      * 27.9.1.1, class template basic_filebuf:
      */
@@ -58,26 +73,30 @@ namespace std
 
             basic_filebuf()
                 : basic_streambuf<char_type, traits_type>{},
-                  obuf_{nullptr}, ibuf_{nullptr}, mode_{}, file_{nullptr}
+                  obuf_{nullptr}, ibuf_{nullptr}, mode_{}, fd_{-1}, pos_{}
             { /* DUMMY BODY */ }
 
             basic_filebuf(const basic_filebuf&) = delete;
 
             basic_filebuf(basic_filebuf&& other)
-                : mode_{other.mode_}
+                : basic_streambuf<char_type, traits_type>{other},
+                  obuf_{other.obuf_}, ibuf_{other.ibuf_}, mode_{other.mode_},
+                  fd_{other.fd_}, pos_{other.pos_}
             {
-                close();
-                std::swap(obuf_, other.obuf_);
-                std::swap(ibuf_, other.ibuf_);
-                std::swap(file_, other.file_);
-
-                basic_streambuf<char_type, traits_type>::swap(other);
+                other.obuf_ = nullptr;
+                other.ibuf_ = nullptr;
+                other.fd_ = -1;
+                other.setg(nullptr, nullptr, nullptr);
+                other.setp(nullptr, nullptr);
             }
 
             virtual ~basic_filebuf()
             {
                 // TODO: exception here caught and not rethrown
                 close();
+
+                delete[] obuf_;
+                delete[] ibuf_;
             }
 
             /**
@@ -99,6 +118,8 @@ namespace std
                 std::swap(mode_, rhs.mode_);
                 std::swap(obuf_, rhs.obuf_);
                 std::swap(ibuf_, rhs.ibuf_);
+                std::swap(fd_, rhs.fd_);
+                std::swap(pos_, rhs.pos_);
 
                 basic_streambuf<char_type, traits_type>::swap(rhs);
             }
@@ -109,28 +130,28 @@ namespace std
 
             bool is_open() const
             {
-                return file_ != nullptr;
+                return fd_ >= 0;
             }
 
             basic_filebuf<char_type, traits_type>* open(const char* name, ios_base::openmode mode)
             {
-                if (file_)
+                if (is_open())
                     return nullptr;
 
-                mode_ = mode;
-                mode = (mode & (~ios_base::ate));
-                const char* mode_str = get_mode_str_(mode);
-
+                const char* mode_str = get_mode_str_(mode & (~ios_base::ate));
                 if (!mode_str)
                     return nullptr;
 
-                file_ = fopen(name, mode_str);
-                if (!file_)
+                fd_ = aux::filebuf_open(name, mode_str);
+                if (fd_ < 0)
                     return nullptr;
 
+                mode_ = mode;
+                pos_ = 0;
                 if ((mode_ & ios_base::ate) != 0)
                 {
-                    if (fseek(file_, 0, SEEK_END) != 0)
+                    pos_ = aux::filebuf_size(fd_);
+                    if (pos_ < 0)
                     {
                         close();
                         return nullptr;
@@ -154,17 +175,20 @@ namespace std
             basic_filebuf<char_type, traits_type>* close()
             {
                 // TODO: caught exceptions are to be rethrown after closing the file
-                if (!file_)
+                if (!is_open())
                     return nullptr;
-                // TODO: deallocate buffers?
 
-                if (this->output_next_ != this->output_begin_)
-                    overflow(traits_type::eof());
+                bool flushed = flush_output_();
                 // TODO: unshift? (p. 1084 at the top)
 
-                fclose(file_);
-                file_ = nullptr;
+                bool closed = aux::filebuf_close(fd_) >= 0;
+                fd_ = -1;
 
+                this->setg(nullptr, nullptr, nullptr);
+                this->setp(nullptr, nullptr);
+
+                if (!flushed || !closed)
+                    return nullptr;
                 return this;
             }
 
@@ -173,50 +197,46 @@ namespace std
              * 27.9.1.5, overriden virtual functions:
              */
 
+            streamsize showmanyc() override
+            {
+                if (!is_open() || !mode_is_in_(mode_))
+                    return -1;
+
+                auto size = aux::filebuf_size(fd_);
+                if (size <= pos_)
+                    return 0;
+
+                return static_cast<streamsize>((size - pos_) / sizeof(char_type));
+            }
+
             int_type underflow() override
             {
                 // TODO: use codecvt
-                if (!mode_is_in_(mode_))
+                if (!is_open() || !mode_is_in_(mode_))
                     return traits_type::eof();
 
-                if (!ibuf_)
-                {
-                    ibuf_ = new char_type[buf_size_];
-                    this->input_begin_ = this->input_next_ = this->input_end_ = ibuf_;
-                }
+                if (this->gptr() && this->gptr() < this->egptr())
+                    return traits_type::to_int_type(*this->gptr());
 
-                off_type i{};
-                if (this->input_next_ < this->input_end_)
-                {
-                    auto idx = static_cast<off_type>(this->input_next_ - this->input_begin_);
-                    auto count = static_cast<off_type>(buf_size_) - idx;
+                if (!flush_output_())
+                    return traits_type::eof();
 
-                    for (; i < count; ++i, ++idx)
-                        ibuf_[i] = ibuf_[idx];
-                }
+                if (!ibuf_)
+                    ibuf_ = new char_type[buf_size_];
 
-                for (; i < static_cast<off_type>(buf_size_); ++i)
+                auto res = aux::filebuf_read(
+                    fd_, pos_, ibuf_, buf_size_ * sizeof(char_type)
+                );
+                if (res <= 0)
                 {
-                    auto c = fgetc(file_);
-                    if (c == traits_type::eof())
-                        break;
-
-                    ibuf_[i] = static_cast<char_type>(c);
+                    this->setg(ibuf_, ibuf_, ibuf_);
 
-                    if (ibuf_[i] == '\n')
-                    {
-                        ++i;
-                        break;
-                    }
+                    return traits_type::eof();
                 }
 
-                this->input_next_ = this->input_begin_;
-                this->input_end_ = this->input_begin_ + i;
-
-                if (i == 0)
-                    return traits_type::eof();
+                this->setg(ibuf_, ibuf_, ibuf_ + res / sizeof(char_type));
 
-                return traits_type::to_int_type(*this->input_next_);
+                return traits_type::to_int_type(*this->gptr());
             }
 
             int_type pbackfail(int_type c = traits_type::eof()) override
@@ -251,18 +271,43 @@ namespace std
             int_type overflow(int_type c = traits_type::eof()) override
             {
                 // TODO: use codecvt
-                if (!mode_is_out_(mode_))
+                if (!is_open() || !mode_is_out_(mode_))
                     return traits_type::eof();
 
-                auto count = static_cast<size_t>(this->output_next_ - this->output_begin_);
-                fwrite(obuf_, sizeof(char_type), count, file_);
-                fflush(file_);
+                if (!flush_output_())
+                    return traits_type::eof();
 
-                this->output_next_ = this->output_begin_;
+                if (!traits_type::eq_int_type(c, traits_type::eof()))
+                {
+                    auto cc = traits_type::to_char_type(c);
+                    if (this->pptr() && this->pptr() < this->epptr())
+                        traits_type::assign(*this->output_next_++, cc);
+                    else if (aux::filebuf_write(fd_, pos_, &cc, sizeof(char_type)) < 0)
+                        return traits_type::eof();
+                }
 
                 return traits_type::not_eof(c);
             }
 
+            streamsize xsputn(const char_type* s, streamsize n) override
+            {
+                if (n < static_cast<streamsize>(buf_size_))
+                    return basic_streambuf<char_type, traits_type>::xsputn(s, n);
+
+                /**
+                 * Large writes bypass the buffer instead
+                 * of being chopped into buf_size_ pieces.
+                 */
+                if (!is_open() || !mode_is_out_(mode_) || !flush_output_())
+                    return 0;
+
+                auto res = aux::filebuf_write(fd_, pos_, s, n * sizeof(char_type));
+                if (res < 0)
+                    return 0;
+
+                return res / static_cast<streamsize>(sizeof(char_type));
+            }
+
             basic_streambuf<char_type, traits_type>*
             setbuf(char_type* s, streamsize n) override
             {
@@ -274,25 +319,36 @@ namespace std
             pos_type seekoff(off_type off, ios_base::seekdir dir,
                              ios_base::openmode mode = ios_base::in | ios_base::out) override
             {
-                // TODO: implement
-                __unimplemented();
-                return pos_type{};
+                // TODO: use codecvt
+                if (!is_open() || !flush_output_())
+                    return static_cast<pos_type>(off_type(-1));
+
+                streamoff base{};
+                if (dir == ios_base::cur)
+                    base = pos_;
+                else if (dir == ios_base::end)
+                    base = aux::filebuf_size(fd_);
+
+                auto new_pos = base + off * static_cast<streamoff>(sizeof(char_type));
+                if (base < 0 || new_pos < 0)
+                    return static_cast<pos_type>(off_type(-1));
+                pos_ = new_pos;
+
+                return static_cast<pos_type>(pos_ / sizeof(char_type));
             }
 
             pos_type seekpos(pos_type pos,
                              ios_base::openmode mode = ios_base::in | ios_base::out) override
             {
-                // TODO: implement
-                __unimplemented();
-                return pos_type{};
+                return seekoff(static_cast<off_type>(pos), ios_base::beg, mode);
             }
 
             int sync() override
             {
-                if (mode_is_out_(mode_))
-                    overflow();
+                if (!is_open())
+                    return 0;
 
-                return 0; // TODO: what is the correct return value?
+                return flush_output_() ? 0 : -1;
             }
 
             void imbue(const locale& loc) override
@@ -307,9 +363,44 @@ namespace std
 
             ios_base::openmode mode_;
 
-            FILE* file_;
+            int fd_;
+
+            /**
+             * Position in the file that corresponds to the end
+             * of the get area or the beginning of the put area,
+             * only one of which is ever non-empty.
+             */
+            streamoff pos_;
+
+            static constexpr size_t buf_size_{4096 / sizeof(char_type)};
+
+            /**
+             * Writes out the put area and drops any read-ahead
+             * in the get area, leaving pos_ at the logical
+             * position of the stream.
+             */
+            bool flush_output_()
+            {
+                if (this->gptr() && this->gptr() < this->egptr())
+                {
+                    pos_ -= static_cast<streamoff>(
+                        (this->egptr() - this->gptr()) * sizeof(char_type)
+                    );
+                }
+                if (ibuf_)
+                    this->setg(ibuf_, ibuf_, ibuf_);
+
+                if (!this->pptr() || this->pptr() == this->pbase())
+                    return true;
 
-            static constexpr size_t buf_size_{128};
+                auto size = static_cast<size_t>(this->pptr() - this->pbase());
+                auto res = aux::filebuf_write(
+                    fd_, pos_, this->pbase(), size * sizeof(char_type)
+                );
+                this->setp(obuf_, obuf_ + buf_size_);
+
+                return res == static_cast<streamsize>(size * sizeof(char_type));
+            }
 
             const char* get_mode_str_(ios_base::openmode mode)
             {
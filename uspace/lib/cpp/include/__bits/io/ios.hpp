@@ -183,13 +183,7 @@ namespace std
             using event_callback = void (*)(event, ios_base&, int);
             void register_callback(event_callback fn, int index);
 
-            static bool sync_with_stdio(bool sync = true)
-            {
-                auto old = sync_;
-                sync_ = sync;
-
-                return old;
-            }
+            static bool sync_with_stdio(bool sync = true);
 
         protected:
             ios_base();
@@ -253,6 +247,12 @@ namespace std
 
     // TODO: implement
 
+    template<class Char, class OutputIterator>
+    class num_put;
+
+    template<class Char, class InputIterator>
+    class num_get;
+
     /**
      * 27.5.5, basic_ios:
      */
@@ -392,6 +392,7 @@ namespace std
                 precision_  = rhs.precision_;
                 fill_      = rhs.fill_;
                 locale_     = rhs.locale_;
+                cache_facets_();
 
                 delete[] iarray_;
                 iarray_size_ = rhs.iarray_size_;
@@ -430,6 +431,7 @@ namespace std
             locale imbue(const locale& loc)
             {
                 auto res = ios_base::imbue(loc);
+                cache_facets_();
 
                 if (rdbuf_)
                     rdbuf_->pubimbue(loc);
@@ -463,8 +465,9 @@ namespace std
                 width(0);
                 precision(6);
 
-                fill_ = widen(' ');
                 locale_ = locale();
+                cache_facets_();
+                fill_ = widen(' ');
 
                 iarray_ = nullptr;
                 parray_ = nullptr;
@@ -480,6 +483,8 @@ namespace std
                 precision_  = rhs.precision_;
                 fill_       = rhs.fill_;
                 locale_     = move(rhs.locale_);
+                num_put_    = rhs.num_put_;
+                num_get_    = rhs.num_get_;
                 rdstate_    = rhs.rdstate_;
                 callbacks_  = move(rhs.callbacks_);
 
@@ -506,6 +511,8 @@ namespace std
                 precision_  = rhs.precision_;
                 fill_       = rhs.fill_;
                 locale_     = move(rhs.locale_);
+                num_put_    = rhs.num_put_;
+                num_get_    = rhs.num_get_;
                 rdstate_    = rhs.rdstate_;
                 callbacks_.swap(rhs.callbacks_);
 
@@ -532,6 +539,8 @@ namespace std
                 swap(precision_, rhs.precision_);
                 swap(fill_, rhs.fill_);
                 swap(locale_, rhs.locale_);
+                swap(num_put_, rhs.num_put_);
+                swap(num_get_, rhs.num_get_);
                 swap(rdstate_, rhs.rdstate_);
                 swap(callbacks_, rhs.callbacks_);
                 swap(iarray_);
@@ -546,6 +555,22 @@ namespace std
                 rdbuf_ = sb;
             }
 
+            using num_put_type_ = num_put<char_type, ostreambuf_iterator<char_type, traits_type>>;
+            using num_get_type_ = num_get<char_type, istreambuf_iterator<char_type, traits_type>>;
+
+            /**
+             * Looked up on init and imbue so that formatted
+             * I/O does not go through use_facet every time.
+             */
+            const num_put_type_* num_put_;
+            const num_get_type_* num_get_;
+
+            void cache_facets_()
+            {
+                num_put_ = &use_facet<num_put_type_>(locale_);
+                num_get_ = &use_facet<num_get_type_>(locale_);
+            }
+
         private:
             basic_streambuf<Char, Traits>* rdbuf_;
             basic_ostream<Char, Traits>* tie_;
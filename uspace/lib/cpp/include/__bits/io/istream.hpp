@@ -159,11 +159,9 @@ namespace std
 
                 if (sen)
                 {
-                    using num_get = num_get<Char, istreambuf_iterator<Char, Traits>>;
                     auto err = ios_base::goodbit;
 
-                    auto loc = this->getloc();
-                    use_facet<num_get>(loc).get(*this, 0, *this, err, x);
+                    this->num_get_->get(*this, 0, *this, err, x);
                     this->setstate(err);
                 }
 
@@ -176,12 +174,10 @@ namespace std
 
                 if (sen)
                 {
-                    using num_get = num_get<Char, istreambuf_iterator<Char, Traits>>;
                     auto err = ios_base::goodbit;
 
                     long tmp{};
-                    auto loc = this->getloc();
-                    use_facet<num_get>(loc).get(*this, 0, *this, err, tmp);
+                    this->num_get_->get(*this, 0, *this, err, tmp);
 
                     if (tmp < numeric_limits<short>::min())
                     {
@@ -208,11 +204,9 @@ namespace std
 
                 if (sen)
                 {
-                    using num_get = num_get<Char, istreambuf_iterator<Char, Traits>>;
                     auto err = ios_base::goodbit;
 
-                    auto loc = this->getloc();
-                    use_facet<num_get>(loc).get(*this, 0, *this, err, x);
+                    this->num_get_->get(*this, 0, *this, err, x);
                     this->setstate(err);
                 }
 
@@ -225,12 +219,10 @@ namespace std
 
                 if (sen)
                 {
-                    using num_get = num_get<Char, istreambuf_iterator<Char, Traits>>;
                     auto err = ios_base::goodbit;
 
                     long tmp{};
-                    auto loc = this->getloc();
-                    use_facet<num_get>(loc).get(*this, 0, *this, err, tmp);
+                    this->num_get_->get(*this, 0, *this, err, tmp);
 
                     if (tmp < numeric_limits<int>::min())
                     {
@@ -257,11 +249,9 @@ namespace std
 
                 if (sen)
                 {
-                    using num_get = num_get<Char, istreambuf_iterator<Char, Traits>>;
                     auto err = ios_base::goodbit;
 
-                    auto loc = this->getloc();
-                    use_facet<num_get>(loc).get(*this, 0, *this, err, x);
+                    this->num_get_->get(*this, 0, *this, err, x);
                     this->setstate(err);
                 }
 
@@ -274,11 +264,9 @@ namespace std
 
                 if (sen)
                 {
-                    using num_get = num_get<Char, istreambuf_iterator<Char, Traits>>;
                     auto err = ios_base::goodbit;
 
-                    auto loc = this->getloc();
-                    use_facet<num_get>(loc).get(*this, 0, *this, err, x);
+                    this->num_get_->get(*this, 0, *this, err, x);
                     this->setstate(err);
                 }
 
@@ -291,11 +279,9 @@ namespace std
 
                 if (sen)
                 {
-                    using num_get = num_get<Char, istreambuf_iterator<Char, Traits>>;
                     auto err = ios_base::goodbit;
 
-                    auto loc = this->getloc();
-                    use_facet<num_get>(loc).get(*this, 0, *this, err, x);
+                    this->num_get_->get(*this, 0, *this, err, x);
                     this->setstate(err);
                 }
 
@@ -308,11 +294,9 @@ namespace std
 
                 if (sen)
                 {
-                    using num_get = num_get<Char, istreambuf_iterator<Char, Traits>>;
                     auto err = ios_base::goodbit;
 
-                    auto loc = this->getloc();
-                    use_facet<num_get>(loc).get(*this, 0, *this, err, x);
+                    this->num_get_->get(*this, 0, *this, err, x);
                     this->setstate(err);
                 }
 
@@ -325,11 +309,9 @@ namespace std
 
                 if (sen)
                 {
-                    using num_get = num_get<Char, istreambuf_iterator<Char, Traits>>;
                     auto err = ios_base::goodbit;
 
-                    auto loc = this->getloc();
-                    use_facet<num_get>(loc).get(*this, 0, *this, err, x);
+                    this->num_get_->get(*this, 0, *this, err, x);
                     this->setstate(err);
                 }
 
@@ -139,9 +139,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
+                    bool failed = this->num_put_->put(*this, *this, this->fill(), x).failed();
 
                     if (failed)
                         this->setstate(ios_base::badbit);
@@ -157,9 +155,7 @@ namespace std
                 if (sen)
                 {
                     auto basefield = (this->flags() & ios_base::basefield);
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(),
+                    bool failed = this->num_put_->put(*this, *this, this->fill(),
                                           (basefield == ios_base::oct || basefield == ios_base::hex)
                                           ? static_cast<long>(static_cast<unsigned short>(x))
                                           : static_cast<long>(x)).failed();
@@ -177,9 +173,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(),
+                    bool failed = this->num_put_->put(*this, *this, this->fill(),
                                           static_cast<unsigned long>(x)).failed();
 
                     if (failed)
@@ -196,9 +190,7 @@ namespace std
                 if (sen)
                 {
                     auto basefield = (this->flags() & ios_base::basefield);
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(),
+                    bool failed = this->num_put_->put(*this, *this, this->fill(),
                                           (basefield == ios_base::oct || basefield == ios_base::hex)
                                           ? static_cast<long>(static_cast<unsigned int>(x))
                                           : static_cast<long>(x)).failed();
@@ -216,9 +208,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(),
+                    bool failed = this->num_put_->put(*this, *this, this->fill(),
                                           static_cast<unsigned long>(x)).failed();
 
                     if (failed)
@@ -234,9 +224,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
+                    bool failed = this->num_put_->put(*this, *this, this->fill(), x).failed();
 
                     if (failed)
                         this->setstate(ios_base::badbit);
@@ -251,9 +239,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
+                    bool failed = this->num_put_->put(*this, *this, this->fill(), x).failed();
 
                     if (failed)
                         this->setstate(ios_base::badbit);
@@ -268,9 +254,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
+                    bool failed = this->num_put_->put(*this, *this, this->fill(), x).failed();
 
                     if (failed)
                         this->setstate(ios_base::badbit);
@@ -285,9 +269,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
+                    bool failed = this->num_put_->put(*this, *this, this->fill(), x).failed();
 
                     if (failed)
                         this->setstate(ios_base::badbit);
@@ -302,9 +284,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), static_cast<double>(x)).failed();
+                    bool failed = this->num_put_->put(*this, *this, this->fill(), static_cast<double>(x)).failed();
 
                     if (failed)
                         this->setstate(ios_base::badbit);
@@ -319,9 +299,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
+                    bool failed = this->num_put_->put(*this, *this, this->fill(), x).failed();
 
                     if (failed)
                         this->setstate(ios_base::badbit);
@@ -336,9 +314,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), x).failed();
+                    bool failed = this->num_put_->put(*this, *this, this->fill(), x).failed();
 
                     if (failed)
                         this->setstate(ios_base::badbit);
@@ -353,9 +329,7 @@ namespace std
 
                 if (sen)
                 {
-                    bool failed = use_facet<
-                        num_put<char_type, ostreambuf_iterator<char_type, traits_type>>
-                    >(this->getloc()).put(*this, *this, this->fill(), p).failed();
+                    bool failed = this->num_put_->put(*this, *this, this->fill(), p).failed();
 
                     if (failed)
                         this->setstate(ios_base::badbit);
@@ -381,12 +381,22 @@ namespace std
                     return 0;
 
                 streamsize i{0};
-                for (; i <= n; ++i)
+                while (i < n)
                 {
-                    if (!write_avail_() && traits_type::eq_int_type(overflow(), traits_type::eof()))
+                    if (write_avail_())
+                    {
+                        auto avail = static_cast<streamsize>(output_end_ - output_next_);
+                        auto count = (n - i < avail) ? n - i : avail;
+
+                        traits_type::copy(output_next_, s + i, count);
+                        output_next_ += count;
+                        i += count;
+                    }
+                    else if (traits_type::eq_int_type(
+                        overflow(traits_type::to_int_type(s[i])), traits_type::eof()))
                         break;
-
-                    *output_next_++ = *s++;
+                    else
+                        ++i;
                 }
 
                 return i;
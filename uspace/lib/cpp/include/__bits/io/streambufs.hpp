@@ -132,7 +132,25 @@ namespace std::aux
             { /* DUMMY BODY */ }
 
             virtual ~stdout_streambuf()
-            { /* DUMMY BODY */ }
+            {
+                flush_();
+            }
+
+            /**
+             * While synchronized with stdio, every character is
+             * handed to stdout immediately so that output interleaves
+             * with printf. Otherwise we keep our own block buffer
+             * and only touch stdio once per block.
+             */
+            void buffered(bool buf)
+            {
+                flush_();
+
+                if (buf)
+                    this->setp(buffer_, buffer_ + buf_size_);
+                else
+                    this->setp(nullptr, nullptr);
+            }
 
         protected:
             using traits_type = Traits;
@@ -142,10 +160,16 @@ namespace std::aux
 
             int_type overflow(int_type c = traits_type::eof()) override
             {
+                if (!flush_())
+                    return traits_type::eof();
+
                 if (!traits_type::eq_int_type(c, traits_type::eof()))
                 {
                     auto cc = traits_type::to_char_type(c);
-                    fwrite(&cc, sizeof(char_type), 1, out_);
+                    if (this->pptr())
+                        traits_type::assign(*this->output_next_++, cc);
+                    else if (fwrite(&cc, sizeof(char_type), 1, out_) != 1)
+                        return traits_type::eof();
                 }
 
                 return traits_type::not_eof(c);
@@ -153,18 +177,44 @@ namespace std::aux
 
             streamsize xsputn(const char_type* s, streamsize n) override
             {
+                if (this->pptr() && n < this->epptr() - this->pptr())
+                {
+                    traits_type::copy(this->output_next_, s, n);
+                    this->output_next_ += n;
+
+                    return n;
+                }
+
+                if (!flush_())
+                    return 0;
                 return fwrite(s, sizeof(char_type), n, out_);
             }
 
             int sync() override
             {
-                if (fflush(out_))
+                if (!flush_() || fflush(out_))
                     return -1;
                 return 0;
             }
 
         private:
             FILE* out_{stdout};
+
+            static constexpr size_t buf_size_{1024};
+
+            char_type buffer_[buf_size_];
+
+            bool flush_()
+            {
+                if (!this->pptr() || this->pptr() == this->pbase())
+                    return true;
+
+                auto count = static_cast<size_t>(this->pptr() - this->pbase());
+                auto res = fwrite(this->pbase(), sizeof(char_type), count, out_);
+                this->setp(buffer_, buffer_ + buf_size_);
+
+                return res == count;
+            }
     };
 }
 
@@ -145,20 +145,23 @@ namespace std
             }
 
             template<class Facet>
-            /* friend const Facet& use_facet(const locale&); */
-            friend Facet use_facet(const locale&);
+            friend const Facet& use_facet(const locale&);
 
             template<class Facet>
-            /* const Facet& get_() const */
-            Facet get_() const
+            const Facet& get_() const
             {
-                return Facet{0U};
+                /**
+                 * Our single locale is the classic one, so every
+                 * locale object can share one instance of each facet.
+                 */
+                static const Facet facet{0U};
+
+                return facet;
             }
     };
 
     template<class Facet>
-    /* const Facet& use_facet(const locale& loc) */
-    Facet use_facet(const locale& loc)
+    const Facet& use_facet(const locale& loc)
     {
         return loc.get_<Facet>();
     }
@@ -159,7 +159,7 @@ namespace std
                      * and the result is deduced.
                      */
 
-                    auto loc = base.getloc();
+                    const auto& loc = base.locale_;
                     const auto& nt = use_facet<numpunct<char_type>>(loc);
 
                     auto true_target = nt.truename();
@@ -338,7 +338,7 @@ namespace std
                 if (in == end)
                     return 0;
 
-                auto loc = base.getloc();
+                const auto& loc = base.locale_;
                 const auto& ct = use_facet<ctype<char_type>>(loc);
                 auto hex = ((base.flags() & ios_base::hex) != 0);
 
@@ -96,7 +96,7 @@ namespace std
         protected:
             iter_type do_put(iter_type it, ios_base& base, char_type fill, bool v) const
             {
-                auto loc = base.getloc();
+                const auto& loc = base.locale_;
 
                 if ((base.flags() & ios_base::boolalpha) == 0)
                     return do_put(it, base, fill, (long)v);
@@ -291,7 +291,7 @@ namespace std
 
             iter_type put_buffer_(iter_type it, ios_base& base, char_type fill, size_t start, size_t size) const
             {
-                const auto& loc = base.getloc();
+                const auto& loc = base.locale_;
                 const auto& ct = use_facet<ctype<char_type>>(loc);
                 const auto& punct = use_facet<numpunct<char_type>>(loc);
 
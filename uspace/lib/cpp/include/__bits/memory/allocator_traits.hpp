@@ -55,13 +55,20 @@ namespace std
         { /* DUMMY BODY */ };
     }
 
+    namespace aux
+    {
+        template<class T, class Alloc, bool = has_allocator_type<T>::value>
+        struct uses_allocator_impl: false_type
+        { /* DUMMY BODY */ };
+
+        template<class T, class Alloc>
+        struct uses_allocator_impl<T, Alloc, true>
+            : value_is<bool, is_convertible_v<Alloc, typename T::allocator_type>>
+        { /* DUMMY BODY */ };
+    }
+
     template<class T, class Alloc>
-    struct uses_allocator
-        : aux::value_is<
-        bool, aux::has_allocator_type<T>::value && is_convertible_v<
-            Alloc, typename T::allocator_type
-        >
-    >
+    struct uses_allocator: aux::uses_allocator_impl<T, Alloc>
     { /* DUMMY BODY */ };
 
     /**
@@ -87,7 +94,7 @@ namespace std
         using is_always_equal                        = typename aux::alloc_get_always_equal<Alloc>::type;
 
         template<class T>
-        using rebind_alloc = typename aux::alloc_get_rebind_alloc<Alloc, T>;
+        using rebind_alloc = typename aux::alloc_get_rebind_alloc<Alloc, T>::type;
 
         template<class T>
         using rebind_traits = allocator_traits<rebind_alloc<T>>;
@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_MEMORY_MEMORY_RESOURCE
+#define LIBCPP_BITS_MEMORY_MEMORY_RESOURCE
+
+#include <__bits/memory/allocator_arg.hpp>
+#include <__bits/memory/allocator_traits.hpp>
+#include <__bits/thread/threading.hpp>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * Our libc does not provide max_align_t, so we
+     * take the strictest alignment among the
+     * fundamental types instead.
+     */
+    union pmr_max_align_type
+    {
+        long long ll;
+        long double ld;
+        void* ptr;
+        void (*fptr)();
+    };
+
+    inline constexpr size_t pmr_max_align = alignof(pmr_max_align_type);
+
+    /**
+     * Single size class of a pool resource. Free
+     * blocks are kept in an intrusive singly linked
+     * list, chunks obtained from the upstream resource
+     * are chained so that they can be released at once.
+     */
+    struct pmr_pool
+    {
+        size_t block_size;
+        size_t next_blocks;
+        void* free_list;
+        void* chunks;
+    };
+
+    inline constexpr size_t pmr_min_block_size = 8;
+    inline constexpr size_t pmr_max_pool_count = 14;
+}
+
+namespace std::pmr
+{
+    /**
+     * 23.12.2, class memory_resource:
+     */
+
+    class memory_resource
+    {
+        public:
+            virtual ~memory_resource();
+
+            void* allocate(size_t bytes, size_t alignment = aux::pmr_max_align)
+            {
+                return do_allocate(bytes, alignment);
+            }
+
+            void deallocate(void* p, size_t bytes, size_t alignment = aux::pmr_max_align)
+            {
+                do_deallocate(p, bytes, alignment);
+            }
+
+            bool is_equal(const memory_resource& other) const noexcept
+            {
+                return do_is_equal(other);
+            }
+
+        private:
+            virtual void* do_allocate(size_t bytes, size_t alignment) = 0;
+
+            virtual void do_deallocate(void* p, size_t bytes, size_t alignment) = 0;
+
+            virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+    };
+
+    inline bool operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept
+    {
+        return &lhs == &rhs || lhs.is_equal(rhs);
+    }
+
+    inline bool operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * 23.12.6, global memory resources:
+     */
+
+    memory_resource* new_delete_resource() noexcept;
+
+    memory_resource* null_memory_resource() noexcept;
+
+    memory_resource* set_default_resource(memory_resource* r) noexcept;
+
+    memory_resource* get_default_resource() noexcept;
+
+    /**
+     * 23.12.3, class template polymorphic_allocator:
+     */
+
+    template<class T>
+    class polymorphic_allocator
+    {
+        public:
+            using value_type = T;
+
+            polymorphic_allocator() noexcept
+                : resource_{get_default_resource()}
+            { /* DUMMY BODY */ }
+
+            polymorphic_allocator(memory_resource* r)
+                : resource_{r}
+            { /* DUMMY BODY */ }
+
+            polymorphic_allocator(const polymorphic_allocator& other) = default;
+
+            template<class U>
+            polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+                : resource_{other.resource()}
+            { /* DUMMY BODY */ }
+
+            polymorphic_allocator& operator=(const polymorphic_allocator&) = delete;
+
+            T* allocate(size_t n)
+            {
+                return static_cast<T*>(
+                    resource_->allocate(n * sizeof(T), alignof(T))
+                );
+            }
+
+            void deallocate(T* p, size_t n)
+            {
+                resource_->deallocate(p, n * sizeof(T), alignof(T));
+            }
+
+            /**
+             * Uses-allocator construction, so that elements
+             * which are themselves allocator aware (e.g. the
+             * strings in a pmr::vector<pmr::string>) draw
+             * their memory from the same resource.
+             * TODO: piecewise construction of pairs.
+             */
+            template<class U, class... Args>
+            void construct(U* p, Args&&... args)
+            {
+                if constexpr (!uses_allocator<U, polymorphic_allocator>::value)
+                    ::new(static_cast<void*>(p)) U(forward<Args>(args)...);
+                else if constexpr (is_constructible_v<
+                    U, allocator_arg_t, const polymorphic_allocator&, Args...
+                >)
+                {
+                    ::new(static_cast<void*>(p)) U(
+                        allocator_arg, *this, forward<Args>(args)...
+                    );
+                }
+                else
+                    ::new(static_cast<void*>(p)) U(forward<Args>(args)..., *this);
+            }
+
+            template<class U>
+            void destroy(U* p)
+            {
+                p->~U();
+            }
+
+            polymorphic_allocator select_on_container_copy_construction() const
+            {
+                return polymorphic_allocator{};
+            }
+
+            memory_resource* resource() const
+            {
+                return resource_;
+            }
+
+        private:
+            memory_resource* resource_;
+    };
+
+    template<class T1, class T2>
+    bool operator==(const polymorphic_allocator<T1>& lhs,
+                    const polymorphic_allocator<T2>& rhs) noexcept
+    {
+        return *lhs.resource() == *rhs.resource();
+    }
+
+    template<class T1, class T2>
+    bool operator!=(const polymorphic_allocator<T1>& lhs,
+                    const polymorphic_allocator<T2>& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * 23.12.5.2, pool resource options:
+     */
+
+    struct pool_options
+    {
+        size_t max_blocks_per_chunk = 0;
+        size_t largest_required_pool_block = 0;
+    };
+
+    /**
+     * 23.12.5, pool resource classes:
+     * Requests up to the largest pool block size are
+     * rounded up to a power of two and served from
+     * per size free lists, larger (or overaligned)
+     * requests go straight to the upstream resource.
+     */
+
+    class unsynchronized_pool_resource: public memory_resource
+    {
+        public:
+            unsynchronized_pool_resource(const pool_options& opts, memory_resource* upstream);
+
+            unsynchronized_pool_resource()
+                : unsynchronized_pool_resource{pool_options{}, get_default_resource()}
+            { /* DUMMY BODY */ }
+
+            explicit unsynchronized_pool_resource(memory_resource* upstream)
+                : unsynchronized_pool_resource{pool_options{}, upstream}
+            { /* DUMMY BODY */ }
+
+            explicit unsynchronized_pool_resource(const pool_options& opts)
+                : unsynchronized_pool_resource{opts, get_default_resource()}
+            { /* DUMMY BODY */ }
+
+            unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+
+            unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+
+            ~unsynchronized_pool_resource() override;
+
+            void release();
+
+            memory_resource* upstream_resource() const
+            {
+                return upstream_;
+            }
+
+            pool_options options() const
+            {
+                return options_;
+            }
+
+        protected:
+            void* do_allocate(size_t bytes, size_t alignment) override;
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+
+            bool do_is_equal(const memory_resource& other) const noexcept override;
+
+        private:
+            memory_resource* upstream_;
+            pool_options options_;
+            aux::pmr_pool pools_[aux::pmr_max_pool_count];
+            size_t pool_count_;
+
+            /**
+             * Oversized allocations are tracked in a doubly
+             * linked list so that release() can return them.
+             */
+            void* oversized_;
+
+            size_t pool_index_(size_t bytes, size_t alignment) const;
+
+            bool refill_(aux::pmr_pool& pool);
+    };
+
+    class synchronized_pool_resource: public memory_resource
+    {
+        public:
+            synchronized_pool_resource(const pool_options& opts, memory_resource* upstream)
+                : impl_{opts, upstream}, mtx_{}
+            {
+                aux::threading::mutex::init(mtx_);
+            }
+
+            synchronized_pool_resource()
+                : synchronized_pool_resource{pool_options{}, get_default_resource()}
+            { /* DUMMY BODY */ }
+
+            explicit synchronized_pool_resource(memory_resource* upstream)
+                : synchronized_pool_resource{pool_options{}, upstream}
+            { /* DUMMY BODY */ }
+
+            explicit synchronized_pool_resource(const pool_options& opts)
+                : synchronized_pool_resource{opts, get_default_resource()}
+            { /* DUMMY BODY */ }
+
+            synchronized_pool_resource(const synchronized_pool_resource&) = delete;
+
+            synchronized_pool_resource& operator=(const synchronized_pool_resource&) = delete;
+
+            ~synchronized_pool_resource() override = default;
+
+            void release();
+
+            memory_resource* upstream_resource() const
+            {
+                return impl_.upstream_resource();
+            }
+
+            pool_options options() const
+            {
+                return impl_.options();
+            }
+
+        protected:
+            void* do_allocate(size_t bytes, size_t alignment) override;
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+
+            bool do_is_equal(const memory_resource& other) const noexcept override;
+
+        private:
+            unsynchronized_pool_resource impl_;
+            aux::mutex_t mtx_;
+    };
+
+    /**
+     * 23.12.6, class monotonic_buffer_resource:
+     * Hands out memory by bumping a pointer through
+     * a buffer that grows geometrically, individual
+     * deallocations are no-ops and everything is given
+     * back on release() or destruction.
+     */
+
+    class monotonic_buffer_resource: public memory_resource
+    {
+        public:
+            explicit monotonic_buffer_resource(memory_resource* upstream)
+                : monotonic_buffer_resource{initial_size_, upstream}
+            { /* DUMMY BODY */ }
+
+            monotonic_buffer_resource(size_t initial_size, memory_resource* upstream)
+                : upstream_{upstream}, buffer_{}, buffer_size_{},
+                  current_{}, remaining_{},
+                  next_size_{initial_size > 0 ? initial_size : 1},
+                  chunks_{}
+            { /* DUMMY BODY */ }
+
+            monotonic_buffer_resource(void* buffer, size_t buffer_size,
+                                      memory_resource* upstream)
+                : upstream_{upstream}, buffer_{buffer}, buffer_size_{buffer_size},
+                  current_{buffer}, remaining_{buffer_size},
+                  next_size_{buffer_size > 0 ? buffer_size * 2 : initial_size_},
+                  chunks_{}
+            { /* DUMMY BODY */ }
+
+            monotonic_buffer_resource()
+                : monotonic_buffer_resource{get_default_resource()}
+            { /* DUMMY BODY */ }
+
+            explicit monotonic_buffer_resource(size_t initial_size)
+                : monotonic_buffer_resource{initial_size, get_default_resource()}
+            { /* DUMMY BODY */ }
+
+            monotonic_buffer_resource(void* buffer, size_t buffer_size)
+                : monotonic_buffer_resource{buffer, buffer_size, get_default_resource()}
+            { /* DUMMY BODY */ }
+
+            monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+
+            monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+            ~monotonic_buffer_resource() override;
+
+            void release();
+
+            memory_resource* upstream_resource() const
+            {
+                return upstream_;
+            }
+
+        protected:
+            void* do_allocate(size_t bytes, size_t alignment) override;
+
+            void do_deallocate(void*, size_t, size_t) override
+            { /* DUMMY BODY */ }
+
+            bool do_is_equal(const memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+
+        private:
+            static constexpr size_t initial_size_{1024};
+
+            memory_resource* upstream_;
+            void* buffer_;
+            size_t buffer_size_;
+            void* current_;
+            size_t remaining_;
+            size_t next_size_;
+            void* chunks_;
+    };
+}
+
+#endif
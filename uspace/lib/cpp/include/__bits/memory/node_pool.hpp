@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_MEMORY_NODE_POOL
+#define LIBCPP_BITS_MEMORY_NODE_POOL
+
+#include <__bits/memory/shared_payload.hpp>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace std::aux
+{
+    /**
+     * Slab of fixed size blocks shared by all copies
+     * (and rebinds) of one node_pool_allocator. The block
+     * size is fixed by the first single object allocation,
+     * which for node based containers is the node type.
+     * Chunks grow geometrically and are only returned when
+     * the last allocator referring to the pool is gone.
+     */
+    class node_pool
+    {
+        public:
+            node_pool()
+                : refs_{1}, block_size_{}, block_align_{},
+                  next_blocks_{initial_blocks_}, free_list_{},
+                  chunks_{}
+            { /* DUMMY BODY */ }
+
+            node_pool(const node_pool&) = delete;
+            node_pool& operator=(const node_pool&) = delete;
+
+            ~node_pool()
+            {
+                while (chunks_)
+                {
+                    auto next = *static_cast<void**>(chunks_);
+                    ::operator delete(chunks_);
+                    chunks_ = next;
+                }
+            }
+
+            void* allocate(size_t size, size_t align)
+            {
+                if (!block_size_ && align <= alignof(void*))
+                {
+                    block_size_ = size < sizeof(void*) ? sizeof(void*) : size;
+                    block_size_ = (block_size_ + alignof(void*) - 1) & ~(alignof(void*) - 1);
+                    block_align_ = align;
+                }
+
+                if (!serves_(size, align))
+                    return ::operator new(size);
+
+                if (!free_list_)
+                    refill_();
+
+                auto res = free_list_;
+                free_list_ = *static_cast<void**>(res);
+
+                return res;
+            }
+
+            void deallocate(void* ptr, size_t size, size_t align)
+            {
+                if (!serves_(size, align))
+                {
+                    ::operator delete(ptr);
+
+                    return;
+                }
+
+                *static_cast<void**>(ptr) = free_list_;
+                free_list_ = ptr;
+            }
+
+            void acquire() noexcept
+            {
+                refcount_increment(refs_);
+            }
+
+            bool release() noexcept
+            {
+                return refcount_decrement(refs_);
+            }
+
+        private:
+            static constexpr size_t initial_blocks_{8};
+            static constexpr size_t max_blocks_{256};
+
+            refcount_t refs_;
+            size_t block_size_;
+            size_t block_align_;
+            size_t next_blocks_;
+            void* free_list_;
+            void* chunks_;
+
+            bool serves_(size_t size, size_t align) const
+            {
+                return block_size_ && align == block_align_ &&
+                       size <= block_size_ && size + sizeof(void*) > block_size_;
+            }
+
+            void refill_()
+            {
+                /**
+                 * The first pointer sized slot of a chunk
+                 * links the chunks together, the blocks after
+                 * it are pointer aligned, which is the most
+                 * we serve from the pool.
+                 */
+                auto count = next_blocks_;
+                auto chunk = static_cast<char*>(
+                    ::operator new(sizeof(void*) + count * block_size_)
+                );
+                *reinterpret_cast<void**>(chunk) = chunks_;
+                chunks_ = chunk;
+
+                auto blocks = chunk + sizeof(void*);
+                for (size_t i = count; i > 0; --i)
+                {
+                    auto block = blocks + (i - 1) * block_size_;
+                    *reinterpret_cast<void**>(block) = free_list_;
+                    free_list_ = block;
+                }
+
+                if (next_blocks_ < max_blocks_)
+                    next_blocks_ *= 2;
+            }
+    };
+}
+
+/**
+ * HelenOS extension: allocator that carves single objects out
+ * of a per container slab (see aux::node_pool). Intended for
+ * the node based containers, e.g.
+ *     std::map<K, V, std::less<K>, helenos::node_pool_allocator<std::pair<const K, V>>>
+ * or the helenos::pooled_map shorthand from <helenos/node_pool>, where it replaces one
+ * malloc per element with a free list pop and keeps the nodes
+ * of one container close together. Copying a container gives
+ * the copy a fresh pool, moving or extracting nodes keeps the
+ * pool alive for as long as any of its nodes exist.
+ */
+namespace helenos
+{
+    template<class T>
+    class node_pool_allocator
+    {
+        public:
+            using value_type = T;
+
+            using propagate_on_container_copy_assignment = std::false_type;
+            using propagate_on_container_move_assignment = std::true_type;
+            using propagate_on_container_swap            = std::true_type;
+            using is_always_equal                        = std::false_type;
+
+            node_pool_allocator()
+                : pool_{new std::aux::node_pool{}}
+            { /* DUMMY BODY */ }
+
+            node_pool_allocator(const node_pool_allocator& other) noexcept
+                : pool_{other.pool_}
+            {
+                pool_->acquire();
+            }
+
+            template<class U>
+            node_pool_allocator(const node_pool_allocator<U>& other) noexcept
+                : pool_{other.pool_}
+            {
+                pool_->acquire();
+            }
+
+            node_pool_allocator& operator=(const node_pool_allocator& other) noexcept
+            {
+                other.pool_->acquire();
+                drop_();
+                pool_ = other.pool_;
+
+                return *this;
+            }
+
+            ~node_pool_allocator()
+            {
+                drop_();
+            }
+
+            T* allocate(std::size_t n)
+            {
+                if (n == 1)
+                    return static_cast<T*>(pool_->allocate(sizeof(T), alignof(T)));
+                else
+                    return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T* ptr, std::size_t n)
+            {
+                if (n == 1)
+                    pool_->deallocate(ptr, sizeof(T), alignof(T));
+                else
+                    ::operator delete(ptr);
+            }
+
+            node_pool_allocator select_on_container_copy_construction() const
+            {
+                return node_pool_allocator{};
+            }
+
+            template<class U>
+            bool operator==(const node_pool_allocator<U>& other) const noexcept
+            {
+                return pool_ == other.pool_;
+            }
+
+            template<class U>
+            bool operator!=(const node_pool_allocator<U>& other) const noexcept
+            {
+                return pool_ != other.pool_;
+            }
+
+        private:
+            std::aux::node_pool* pool_;
+
+            void drop_() noexcept
+            {
+                if (pool_->release())
+                    delete pool_;
+            }
+
+            template<class U>
+            friend class node_pool_allocator;
+    };
+}
+
+#endif
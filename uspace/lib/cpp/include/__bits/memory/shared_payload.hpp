@@ -29,15 +29,22 @@
 #ifndef LIBCPP_BITS_MEMORY_SHARED_PAYLOAD
 #define LIBCPP_BITS_MEMORY_SHARED_PAYLOAD
 
+#include <__bits/memory/allocator_traits.hpp>
 #include <cinttypes>
+#include <type_traits>
 #include <utility>
 
+namespace std::hel
+{
+    extern "C" {
+        #include <fibril.h>
+    }
+}
+
 namespace std
 {
     template<class>
     struct default_delete;
-
-    struct allocator_arg_t;
 }
 
 namespace std::aux
@@ -48,6 +55,46 @@ namespace std::aux
      */
     using refcount_t = long;
 
+    /**
+     * As long as all fibrils run on a single thread they
+     * cannot interrupt each other in the middle of a refcount
+     * update, so plain arithmetic is enough. The program
+     * becomes multithreaded before the second thread starts,
+     * so no plain update can race with an atomic one.
+     */
+    inline bool refcount_atomic() noexcept
+    {
+        return hel::fibril_is_multithreaded();
+    }
+
+    inline void refcount_increment(refcount_t& refs) noexcept
+    {
+        if (refcount_atomic())
+            __atomic_add_fetch(&refs, 1, __ATOMIC_RELAXED);
+        else
+            ++refs;
+    }
+
+    /**
+     * Returns true if the count dropped to zero, in that
+     * case all accesses made through the other references
+     * happen before the return.
+     */
+    inline bool refcount_decrement(refcount_t& refs) noexcept
+    {
+        if (!refcount_atomic())
+            return --refs == 0;
+
+        if (__atomic_sub_fetch(&refs, 1, __ATOMIC_RELEASE) == 0)
+        {
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            return true;
+        }
+        else
+            return false;
+    }
+
     /**
      * This allows us to construct shared_ptr from
      * a payload pointer in make_shared etc.
@@ -68,128 +115,79 @@ namespace std::aux
     class shared_payload_base
     {
         public:
-            virtual void destroy() = 0;
+            shared_payload_base()
+                : refcount_{1}, weak_refcount_{1}
+            { /* DUMMY BODY */ }
+
             virtual T* get() const noexcept = 0;
 
             virtual uint8_t* deleter() const noexcept = 0;
 
-            virtual void increment() noexcept = 0;
-            virtual void increment_weak() noexcept = 0;
-            virtual bool decrement() noexcept = 0;
-            virtual bool decrement_weak() noexcept = 0;
-            virtual refcount_t refs() const noexcept = 0;
-            virtual refcount_t weak_refs() const noexcept = 0;
-            virtual bool expired() const noexcept = 0;
-            virtual shared_payload_base* lock() noexcept = 0;
-
-            virtual ~shared_payload_base() = default;
-    };
-
-    template<class T, class D = default_delete<T>>
-    class shared_payload: public shared_payload_base<T>
-    {
-        public:
-            shared_payload(T* ptr, D deleter = D{})
-                : data_{ptr}, deleter_{deleter},
-                  refcount_{1}, weak_refcount_{1}
-            { /* DUMMY BODY */ }
-
-            template<class... Args>
-            shared_payload(Args&&... args)
-                : data_{new T{forward<Args>(args)...}},
-                  deleter_{}, refcount_{1}, weak_refcount_{1}
-            { /* DUMMY BODY */ }
-
-            template<class Alloc, class... Args>
-            shared_payload(allocator_arg_t, Alloc alloc, Args&&... args)
-                : data_{alloc.allocate(1)},
-                  deleter_{}, refcount_{1}, weak_refcount_{1}
+            void increment() noexcept
             {
-                alloc.construct(data_, forward<Args>(args)...);
+                refcount_increment(refcount_);
             }
 
-            template<class Alloc, class... Args>
-            shared_payload(D deleter, Alloc alloc, Args&&... args)
-                : data_{alloc.allocate(1)},
-                  deleter_{deleter}, refcount_{1}, weak_refcount_{1}
+            void increment_weak() noexcept
             {
-                alloc.construct(data_, forward<Args>(args)...);
+                refcount_increment(weak_refcount_);
             }
 
-            void destroy() override
+            /**
+             * Destroys the held object when the last shared
+             * reference is released.
+             */
+            void release() noexcept
             {
-                if (refs() == 0)
+                if (refcount_decrement(refcount_))
                 {
-                    if (data_)
-                    {
-                        deleter_(data_);
-                        data_ = nullptr;
-                    }
-
-                    if (weak_refs() == 0)
-                        delete this;
-                }
-            }
-
-            T* get() const noexcept override
-            {
-                return data_;
-            }
-
-            uint8_t* deleter() const noexcept override
-            {
-                return (uint8_t*)&deleter_;
-            }
-
-            void increment() noexcept override
-            {
-                __atomic_add_fetch(&refcount_, 1, __ATOMIC_ACQ_REL);
-            }
+                    dispose_();
 
-            void increment_weak() noexcept override
-            {
-                __atomic_add_fetch(&weak_refcount_, 1, __ATOMIC_ACQ_REL);
-            }
-
-            bool decrement() noexcept override
-            {
-                if (__atomic_sub_fetch(&refcount_, 1, __ATOMIC_ACQ_REL) == 0)
-                {
                     /**
-                     * First call to destroy() will delete the held object,
-                     * so it doesn't matter what the weak_refcount_ is,
-                     * but we added one and we need to remove it now.
+                     * The weak reference added for all of
+                     * the shared ones, see refcount_ below.
                      */
-                    decrement_weak();
-
-                    return true;
+                    release_weak();
                 }
-                else
-                    return false;
             }
 
-            bool decrement_weak() noexcept override
+            /**
+             * Frees the payload when the last weak reference
+             * is released.
+             */
+            void release_weak() noexcept
             {
-                return __atomic_sub_fetch(&weak_refcount_, 1, __ATOMIC_ACQ_REL) == 0 && refs() == 0;
+                if (refcount_decrement(weak_refcount_))
+                    destroy_();
             }
 
-            refcount_t refs() const noexcept override
+            refcount_t refs() const noexcept
             {
                 return __atomic_load_n(&refcount_, __ATOMIC_RELAXED);
             }
 
-            refcount_t weak_refs() const noexcept override
+            refcount_t weak_refs() const noexcept
             {
                 return __atomic_load_n(&weak_refcount_, __ATOMIC_RELAXED);
             }
 
-            bool expired() const noexcept override
+            bool expired() const noexcept
             {
                 return refs() == 0;
             }
 
-            shared_payload_base<T>* lock() noexcept override
+            shared_payload_base* lock() noexcept
             {
+                if (!refcount_atomic())
+                {
+                    if (refcount_ == 0)
+                        return nullptr;
+
+                    ++refcount_;
+
+                    return this;
+                }
+
                 refcount_t rfs = refs();
                 while (rfs != 0L)
                 {
@@ -204,10 +202,20 @@ namespace std::aux
                 return nullptr;
             }
 
-        private:
-            T* data_;
-            D deleter_;
+            virtual ~shared_payload_base() = default;
 
+        protected:
+            /**
+             * Destroys the held object.
+             */
+            virtual void dispose_() noexcept = 0;
+
+            /**
+             * Frees the payload itself.
+             */
+            virtual void destroy_() noexcept = 0;
+
+        private:
             /**
              * We're using a trick where refcount_ > 0
              * means weak_refcount_ has 1 added to it,
@@ -218,6 +226,111 @@ namespace std::aux
             refcount_t refcount_;
             refcount_t weak_refcount_;
     };
+
+    /**
+     * Payload of a shared_ptr that took ownership
+     * of an already allocated object.
+     */
+    template<class T, class D = default_delete<T>>
+    class shared_payload: public shared_payload_base<T>
+    {
+        public:
+            shared_payload(T* ptr, D deleter = D{})
+                : data_{ptr}, deleter_{deleter}
+            { /* DUMMY BODY */ }
+
+            T* get() const noexcept override
+            {
+                return data_;
+            }
+
+            uint8_t* deleter() const noexcept override
+            {
+                return (uint8_t*)&deleter_;
+            }
+
+        private:
+            T* data_;
+            D deleter_;
+
+            void dispose_() noexcept override
+            {
+                if (data_)
+                {
+                    deleter_(data_);
+                    data_ = nullptr;
+                }
+            }
+
+            void destroy_() noexcept override
+            {
+                delete this;
+            }
+    };
+
+    /**
+     * Payload of make_shared and allocate_shared, the object
+     * lives inside of the payload so that both of them take
+     * a single allocation.
+     */
+    template<class T, class Alloc>
+    class shared_payload_inplace: public shared_payload_base<T>
+    {
+        using alloc_traits = allocator_traits<Alloc>;
+        using payload_alloc_type =
+            typename alloc_traits::template rebind_alloc<shared_payload_inplace>;
+        using payload_alloc_traits = allocator_traits<payload_alloc_type>;
+
+        public:
+            template<class... Args>
+            static shared_payload_inplace* create(const Alloc& alloc, Args&&... args)
+            {
+                payload_alloc_type payload_alloc{alloc};
+                auto payload = payload_alloc_traits::allocate(payload_alloc, 1);
+
+                return ::new(static_cast<void*>(payload)) shared_payload_inplace{
+                    alloc, forward<Args>(args)...
+                };
+            }
+
+            T* get() const noexcept override
+            {
+                return static_cast<T*>(
+                    static_cast<void*>(const_cast<storage_type*>(&storage_))
+                );
+            }
+
+            uint8_t* deleter() const noexcept override
+            {
+                return nullptr;
+            }
+
+        private:
+            using storage_type = aligned_storage_t<sizeof(T), alignof(T)>;
+
+            Alloc alloc_;
+            storage_type storage_;
+
+            template<class... Args>
+            shared_payload_inplace(const Alloc& alloc, Args&&... args)
+                : alloc_{alloc}
+            {
+                alloc_traits::construct(alloc_, get(), forward<Args>(args)...);
+            }
+
+            void dispose_() noexcept override
+            {
+                alloc_traits::destroy(alloc_, get());
+            }
+
+            void destroy_() noexcept override
+            {
+                payload_alloc_type payload_alloc{alloc_};
+
+                this->~shared_payload_inplace();
+                payload_alloc_traits::deallocate(payload_alloc, this, 1);
+            }
+    };
 }
 
 #endif
@@ -382,10 +382,7 @@ namespace std
             {
                 if (payload_)
                 {
-                    auto res = payload_->decrement();
-                    if (res)
-                        payload_->destroy();
-
+                    payload_->release();
                     payload_ = nullptr;
                 }
 
@@ -408,11 +405,8 @@ namespace std
 
     /**
      * 20.8.2.2.6, shared_ptr creation:
-     * Note: According to the standard, these two functions
-     *       should perform at most one memory allocation
-     *       (should, don't have to :P). It might be better
-     *       to create payloads that embed the type T to
-     *       perform this optimization.
+     * Note: The object is embedded in its payload,
+     *       so these perform a single allocation.
      */
 
     template<class T, class... Args>
@@ -420,16 +414,22 @@ namespace std
     {
         return shared_ptr<T>{
             aux::payload_tag,
-            new aux::shared_payload<T>{forward<Args>(args)...}
+            aux::shared_payload_inplace<T, allocator<T>>::create(
+                allocator<T>{}, forward<Args>(args)...
+            )
         };
     }
 
     template<class T, class A, class... Args>
     shared_ptr<T> allocate_shared(const A& alloc, Args&&... args)
     {
+        using alloc_type = typename allocator_traits<A>::template rebind_alloc<T>;
+
         return shared_ptr<T>{
             aux::payload_tag,
-            new aux::shared_payload<T>{allocator_arg, A{alloc}, forward<Args>(args)...}
+            aux::shared_payload_inplace<T, alloc_type>::create(
+                alloc_type{alloc}, forward<Args>(args)...
+            )
         };
     }
 
@@ -211,8 +211,8 @@ namespace std
 
             void remove_payload_()
             {
-                if (payload_ && payload_->decrement_weak())
-                    payload_->destroy();
+                if (payload_)
+                    payload_->release_weak();
                 payload_ = nullptr;
             }
 
@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_NUMERIC
 #define LIBCPP_BITS_NUMERIC
 
+#include <iterator>
 #include <utility>
 
 namespace std
@@ -59,6 +60,41 @@ namespace std
         return acc;
     }
 
+    /**
+     * 29.8.3, reduce:
+     * Note: The execution policy overloads are
+     *       in <execution>.
+     */
+
+    template<class InputIterator, class T, class BinaryOperation>
+    T reduce(InputIterator first, InputIterator last, T init,
+             BinaryOperation op)
+    {
+        auto acc{move(init)};
+        while (first != last)
+            acc = op(move(acc), *first++);
+
+        return acc;
+    }
+
+    template<class InputIterator, class T>
+    T reduce(InputIterator first, InputIterator last, T init)
+    {
+        auto acc{move(init)};
+        while (first != last)
+            acc = move(acc) + *first++;
+
+        return acc;
+    }
+
+    template<class InputIterator>
+    auto reduce(InputIterator first, InputIterator last)
+    {
+        using value_type = typename iterator_traits<InputIterator>::value_type;
+
+        return reduce(first, last, value_type{});
+    }
+
     /**
      * 26.7.3, inner product:
      */
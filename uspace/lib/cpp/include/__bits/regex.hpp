@@ -29,6 +29,1662 @@
 #ifndef LIBCPP_BITS_REGEX
 #define LIBCPP_BITS_REGEX
 
-#error "<regex> is not implemented"
+#include <__bits/trycatch.hpp>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace std
+{
+    /**
+     * 28.5, regex constants:
+     */
+
+    namespace regex_constants
+    {
+        /**
+         * 28.5.1, syntax_option_type:
+         * Note: Only the ECMAScript grammar is supported, the
+         *       other grammars are parsed as ECMAScript.
+         */
+
+        enum syntax_option_type: unsigned int
+        {
+            icase      = 1U << 0,
+            nosubs     = 1U << 1,
+            optimize   = 1U << 2,
+            collate    = 1U << 3,
+            ECMAScript = 1U << 4,
+            basic      = 1U << 5,
+            extended   = 1U << 6,
+            awk        = 1U << 7,
+            grep       = 1U << 8,
+            egrep      = 1U << 9,
+            multiline  = 1U << 10
+        };
+
+        constexpr syntax_option_type operator|(syntax_option_type lhs, syntax_option_type rhs)
+        {
+            return static_cast<syntax_option_type>(
+                static_cast<unsigned int>(lhs) | static_cast<unsigned int>(rhs)
+            );
+        }
+
+        constexpr syntax_option_type operator&(syntax_option_type lhs, syntax_option_type rhs)
+        {
+            return static_cast<syntax_option_type>(
+                static_cast<unsigned int>(lhs) & static_cast<unsigned int>(rhs)
+            );
+        }
+
+        constexpr syntax_option_type operator^(syntax_option_type lhs, syntax_option_type rhs)
+        {
+            return static_cast<syntax_option_type>(
+                static_cast<unsigned int>(lhs) ^ static_cast<unsigned int>(rhs)
+            );
+        }
+
+        constexpr syntax_option_type operator~(syntax_option_type opt)
+        {
+            return static_cast<syntax_option_type>(~static_cast<unsigned int>(opt));
+        }
+
+        inline syntax_option_type& operator|=(syntax_option_type& lhs, syntax_option_type rhs)
+        {
+            return lhs = lhs | rhs;
+        }
+
+        inline syntax_option_type& operator&=(syntax_option_type& lhs, syntax_option_type rhs)
+        {
+            return lhs = lhs & rhs;
+        }
+
+        inline syntax_option_type& operator^=(syntax_option_type& lhs, syntax_option_type rhs)
+        {
+            return lhs = lhs ^ rhs;
+        }
+
+        /**
+         * 28.5.2, match_flag_type:
+         */
+
+        enum match_flag_type: unsigned int
+        {
+            match_default     = 0,
+            match_not_bol     = 1U << 0,
+            match_not_eol     = 1U << 1,
+            match_not_bow     = 1U << 2,
+            match_not_eow     = 1U << 3,
+            match_any         = 1U << 4,
+            match_not_null    = 1U << 5,
+            match_continuous  = 1U << 6,
+            match_prev_avail  = 1U << 7,
+            format_default    = 0,
+            format_sed        = 1U << 8,
+            format_no_copy    = 1U << 9,
+            format_first_only = 1U << 10
+        };
+
+        constexpr match_flag_type operator|(match_flag_type lhs, match_flag_type rhs)
+        {
+            return static_cast<match_flag_type>(
+                static_cast<unsigned int>(lhs) | static_cast<unsigned int>(rhs)
+            );
+        }
+
+        constexpr match_flag_type operator&(match_flag_type lhs, match_flag_type rhs)
+        {
+            return static_cast<match_flag_type>(
+                static_cast<unsigned int>(lhs) & static_cast<unsigned int>(rhs)
+            );
+        }
+
+        constexpr match_flag_type operator^(match_flag_type lhs, match_flag_type rhs)
+        {
+            return static_cast<match_flag_type>(
+                static_cast<unsigned int>(lhs) ^ static_cast<unsigned int>(rhs)
+            );
+        }
+
+        constexpr match_flag_type operator~(match_flag_type flag)
+        {
+            return static_cast<match_flag_type>(~static_cast<unsigned int>(flag));
+        }
+
+        inline match_flag_type& operator|=(match_flag_type& lhs, match_flag_type rhs)
+        {
+            return lhs = lhs | rhs;
+        }
+
+        inline match_flag_type& operator&=(match_flag_type& lhs, match_flag_type rhs)
+        {
+            return lhs = lhs & rhs;
+        }
+
+        inline match_flag_type& operator^=(match_flag_type& lhs, match_flag_type rhs)
+        {
+            return lhs = lhs ^ rhs;
+        }
+
+        /**
+         * 28.5.3, error_type:
+         */
+
+        enum error_type
+        {
+            error_collate = 1,
+            error_ctype,
+            error_escape,
+            error_backref,
+            error_brack,
+            error_paren,
+            error_brace,
+            error_badbrace,
+            error_range,
+            error_space,
+            error_badrepeat,
+            error_complexity,
+            error_stack
+        };
+    }
+
+    /**
+     * 28.6, class regex_error:
+     */
+
+    class regex_error: public runtime_error
+    {
+        public:
+            explicit regex_error(regex_constants::error_type ecode);
+
+            regex_constants::error_type code() const;
+
+        private:
+            regex_constants::error_type code_;
+    };
+
+    /**
+     * 28.7, class template regex_traits:
+     */
+
+    template<class charT>
+    struct regex_traits
+    {
+        using char_type   = charT;
+        using string_type = basic_string<char_type>;
+
+        regex_traits() = default;
+
+        static size_t length(const char_type* p)
+        {
+            return char_traits<char_type>::length(p);
+        }
+
+        charT translate(charT c) const
+        {
+            return c;
+        }
+
+        charT translate_nocase(charT c) const
+        {
+            if (c >= 'A' && c <= 'Z')
+                return c - 'A' + 'a';
+            else
+                return c;
+        }
+
+        int value(charT c, int radix) const
+        {
+            int res{-1};
+            if (c >= '0' && c <= '9')
+                res = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                res = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                res = c - 'A' + 10;
+
+            return res < radix ? res : -1;
+        }
+    };
+
+    template<class charT, class traits>
+    class basic_regex;
+
+    template<class BidirectionalIterator>
+    class sub_match;
+
+    template<class BidirectionalIterator, class Allocator>
+    class match_results;
+
+    namespace aux
+    {
+        /**
+         * The engine is compiled into the library and works on
+         * contiguous ranges of chars, the templates below adapt
+         * it to the standard interface.
+         */
+        class regex_program;
+
+        regex_program* regex_compile(const char*, const char*, unsigned int,
+                                     regex_constants::error_type&);
+        regex_program* regex_copy(const regex_program*);
+        void regex_destroy(regex_program*);
+        size_t regex_mark_count(const regex_program*);
+
+        /**
+         * Matches [first, last), the whole range if full is true.
+         * If caps is not null, it receives the begin and end offsets
+         * of all groups, -1 for groups that did not participate.
+         */
+        bool regex_execute(const regex_program*, const char*, const char*,
+                           unsigned int, bool, ptrdiff_t*);
+
+        struct regex_access;
+    }
+
+    /**
+     * 28.8, class template basic_regex:
+     */
+
+    template<class charT, class traits = regex_traits<charT>>
+    class basic_regex
+    {
+        static_assert(is_same_v<charT, char>, "basic_regex only supports char");
+
+        public:
+            using value_type  = charT;
+            using traits_type = traits;
+            using string_type = typename traits::string_type;
+            using flag_type   = regex_constants::syntax_option_type;
+
+            static constexpr flag_type icase      = regex_constants::icase;
+            static constexpr flag_type nosubs     = regex_constants::nosubs;
+            static constexpr flag_type optimize   = regex_constants::optimize;
+            static constexpr flag_type collate    = regex_constants::collate;
+            static constexpr flag_type ECMAScript = regex_constants::ECMAScript;
+            static constexpr flag_type basic      = regex_constants::basic;
+            static constexpr flag_type extended   = regex_constants::extended;
+            static constexpr flag_type awk        = regex_constants::awk;
+            static constexpr flag_type grep       = regex_constants::grep;
+            static constexpr flag_type egrep      = regex_constants::egrep;
+            static constexpr flag_type multiline  = regex_constants::multiline;
+
+            /**
+             * 28.8.2, construct/copy/destroy:
+             */
+
+            basic_regex()
+                : program_{}, flags_{regex_constants::ECMAScript}
+            { /* DUMMY BODY */ }
+
+            explicit basic_regex(const charT* p, flag_type f = regex_constants::ECMAScript)
+                : program_{}, flags_{f}
+            {
+                assign(p, f);
+            }
+
+            basic_regex(const charT* p, size_t len, flag_type f = regex_constants::ECMAScript)
+                : program_{}, flags_{f}
+            {
+                assign(p, len, f);
+            }
+
+            basic_regex(const basic_regex& other)
+                : program_{aux::regex_copy(other.program_)}, flags_{other.flags_}
+            { /* DUMMY BODY */ }
+
+            basic_regex(basic_regex&& other) noexcept
+                : program_{other.program_}, flags_{other.flags_}
+            {
+                other.program_ = nullptr;
+            }
+
+            template<class ST, class SA>
+            explicit basic_regex(const basic_string<charT, ST, SA>& p,
+                                 flag_type f = regex_constants::ECMAScript)
+                : program_{}, flags_{f}
+            {
+                assign(p, f);
+            }
+
+            template<class ForwardIterator>
+            basic_regex(ForwardIterator first, ForwardIterator last,
+                        flag_type f = regex_constants::ECMAScript)
+                : program_{}, flags_{f}
+            {
+                assign(first, last, f);
+            }
+
+            basic_regex(initializer_list<charT> init, flag_type f = regex_constants::ECMAScript)
+                : program_{}, flags_{f}
+            {
+                assign(init, f);
+            }
+
+            ~basic_regex()
+            {
+                aux::regex_destroy(program_);
+            }
+
+            basic_regex& operator=(const basic_regex& other)
+            {
+                return assign(other);
+            }
+
+            basic_regex& operator=(basic_regex&& other) noexcept
+            {
+                return assign(move(other));
+            }
+
+            basic_regex& operator=(const charT* p)
+            {
+                return assign(p);
+            }
+
+            basic_regex& operator=(initializer_list<charT> init)
+            {
+                return assign(init);
+            }
+
+            template<class ST, class SA>
+            basic_regex& operator=(const basic_string<charT, ST, SA>& p)
+            {
+                return assign(p);
+            }
+
+            /**
+             * 28.8.3, assign:
+             */
+
+            basic_regex& assign(const basic_regex& other)
+            {
+                if (this != &other)
+                {
+                    auto copy = aux::regex_copy(other.program_);
+                    aux::regex_destroy(program_);
+
+                    program_ = copy;
+                    flags_ = other.flags_;
+                }
+
+                return *this;
+            }
+
+            basic_regex& assign(basic_regex&& other) noexcept
+            {
+                swap(other);
+
+                return *this;
+            }
+
+            basic_regex& assign(const charT* p, flag_type f = regex_constants::ECMAScript)
+            {
+                return assign(p, p + traits::length(p), f);
+            }
+
+            basic_regex& assign(const charT* p, size_t len, flag_type f)
+            {
+                return assign(p, p + len, f);
+            }
+
+            template<class ST, class SA>
+            basic_regex& assign(const basic_string<charT, ST, SA>& s,
+                                flag_type f = regex_constants::ECMAScript)
+            {
+                return assign(s.data(), s.data() + s.size(), f);
+            }
+
+            template<class InputIterator>
+            basic_regex& assign(InputIterator first, InputIterator last,
+                                flag_type f = regex_constants::ECMAScript)
+            {
+                if constexpr (is_pointer_v<InputIterator>)
+                    compile_(first, last, f);
+                else
+                {
+                    basic_string<charT> pattern{};
+                    for (; first != last; ++first)
+                        pattern.push_back(*first);
+                    compile_(pattern.data(), pattern.data() + pattern.size(), f);
+                }
+
+                return *this;
+            }
+
+            basic_regex& assign(initializer_list<charT> init,
+                                flag_type f = regex_constants::ECMAScript)
+            {
+                return assign(init.begin(), init.end(), f);
+            }
+
+            /**
+             * 28.8.4, const operations:
+             */
+
+            unsigned int mark_count() const
+            {
+                return static_cast<unsigned int>(aux::regex_mark_count(program_));
+            }
+
+            flag_type flags() const
+            {
+                return flags_;
+            }
+
+            /**
+             * 28.8.5, locale:
+             * TODO: implement when locale support is needed
+             */
+
+            /**
+             * 28.8.6, swap:
+             */
+
+            void swap(basic_regex& other)
+            {
+                std::swap(program_, other.program_);
+                std::swap(flags_, other.flags_);
+            }
+
+        private:
+            aux::regex_program* program_;
+            flag_type flags_;
+
+            void compile_(const charT* first, const charT* last, flag_type f)
+            {
+                regex_constants::error_type err{};
+                auto prog = aux::regex_compile(first, last, f, err);
+
+                aux::regex_destroy(program_);
+                program_ = prog;
+                flags_ = f;
+
+                /**
+                 * Without exceptions an invalid pattern leaves
+                 * a regex that matches nothing.
+                 */
+                if (!prog)
+                    throw regex_error{err};
+            }
+
+            friend struct aux::regex_access;
+    };
+
+    /**
+     * 28.8.7, basic_regex non-member functions:
+     */
+
+    template<class charT, class traits>
+    void swap(basic_regex<charT, traits>& lhs, basic_regex<charT, traits>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+    using regex = basic_regex<char>;
+    // TODO: wregex needs a wide engine.
+    using wregex = basic_regex<wchar_t>;
+
+    /**
+     * 28.9, class template sub_match:
+     */
+
+    template<class BidirectionalIterator>
+    class sub_match: public pair<BidirectionalIterator, BidirectionalIterator>
+    {
+        public:
+            using value_type      = typename iterator_traits<BidirectionalIterator>::value_type;
+            using difference_type = typename iterator_traits<BidirectionalIterator>::difference_type;
+            using iterator        = BidirectionalIterator;
+            using string_type     = basic_string<value_type>;
+
+            bool matched;
+
+            constexpr sub_match()
+                : pair<BidirectionalIterator, BidirectionalIterator>{}, matched{false}
+            { /* DUMMY BODY */ }
+
+            difference_type length() const
+            {
+                if (matched)
+                    return distance(this->first, this->second);
+                else
+                    return 0;
+            }
+
+            operator string_type() const
+            {
+                return str();
+            }
+
+            string_type str() const
+            {
+                string_type res{};
+                if (matched)
+                {
+                    for (auto it = this->first; it != this->second; ++it)
+                        res.push_back(*it);
+                }
+
+                return res;
+            }
+
+            int compare(const sub_match& s) const
+            {
+                return str().compare(s.str());
+            }
+
+            int compare(const string_type& s) const
+            {
+                return str().compare(s);
+            }
+
+            int compare(const value_type* s) const
+            {
+                return str().compare(s);
+            }
+    };
+
+    using csub_match  = sub_match<const char*>;
+    using wcsub_match = sub_match<const wchar_t*>;
+    using ssub_match  = sub_match<string::const_iterator>;
+    using wssub_match = sub_match<wstring::const_iterator>;
+
+    /**
+     * 28.9.2, sub_match non-member operators:
+     */
+
+    template<class BiIter>
+    bool operator==(const sub_match<BiIter>& lhs, const sub_match<BiIter>& rhs)
+    {
+        return lhs.compare(rhs) == 0;
+    }
+
+    template<class BiIter>
+    bool operator!=(const sub_match<BiIter>& lhs, const sub_match<BiIter>& rhs)
+    {
+        return lhs.compare(rhs) != 0;
+    }
+
+    template<class BiIter>
+    bool operator<(const sub_match<BiIter>& lhs, const sub_match<BiIter>& rhs)
+    {
+        return lhs.compare(rhs) < 0;
+    }
+
+    template<class BiIter>
+    bool operator<=(const sub_match<BiIter>& lhs, const sub_match<BiIter>& rhs)
+    {
+        return lhs.compare(rhs) <= 0;
+    }
+
+    template<class BiIter>
+    bool operator>(const sub_match<BiIter>& lhs, const sub_match<BiIter>& rhs)
+    {
+        return lhs.compare(rhs) > 0;
+    }
+
+    template<class BiIter>
+    bool operator>=(const sub_match<BiIter>& lhs, const sub_match<BiIter>& rhs)
+    {
+        return lhs.compare(rhs) >= 0;
+    }
+
+    template<class BiIter>
+    bool operator==(const sub_match<BiIter>& lhs,
+                    const typename iterator_traits<BiIter>::value_type* rhs)
+    {
+        return lhs.compare(rhs) == 0;
+    }
+
+    template<class BiIter>
+    bool operator==(const typename iterator_traits<BiIter>::value_type* lhs,
+                    const sub_match<BiIter>& rhs)
+    {
+        return rhs.compare(lhs) == 0;
+    }
+
+    template<class BiIter>
+    bool operator!=(const sub_match<BiIter>& lhs,
+                    const typename iterator_traits<BiIter>::value_type* rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class BiIter>
+    bool operator!=(const typename iterator_traits<BiIter>::value_type* lhs,
+                    const sub_match<BiIter>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class BiIter, class ST, class SA>
+    bool operator==(const sub_match<BiIter>& lhs,
+                    const basic_string<typename iterator_traits<BiIter>::value_type, ST, SA>& rhs)
+    {
+        return lhs.str().compare(rhs.c_str()) == 0;
+    }
+
+    template<class BiIter, class ST, class SA>
+    bool operator==(const basic_string<typename iterator_traits<BiIter>::value_type, ST, SA>& lhs,
+                    const sub_match<BiIter>& rhs)
+    {
+        return rhs == lhs;
+    }
+
+    template<class BiIter, class ST, class SA>
+    bool operator!=(const sub_match<BiIter>& lhs,
+                    const basic_string<typename iterator_traits<BiIter>::value_type, ST, SA>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class BiIter, class ST, class SA>
+    bool operator!=(const basic_string<typename iterator_traits<BiIter>::value_type, ST, SA>& lhs,
+                    const sub_match<BiIter>& rhs)
+    {
+        return !(rhs == lhs);
+    }
+
+    /**
+     * 28.10, class template match_results:
+     */
+
+    template<
+        class BidirectionalIterator,
+        class Allocator = allocator<sub_match<BidirectionalIterator>>
+    >
+    class match_results
+    {
+        public:
+            using value_type      = sub_match<BidirectionalIterator>;
+            using const_reference = const value_type&;
+            using reference       = value_type&;
+            using const_iterator  = typename vector<value_type, Allocator>::const_iterator;
+            using iterator        = const_iterator;
+            using difference_type = typename iterator_traits<BidirectionalIterator>::difference_type;
+            using size_type       = typename allocator_traits<Allocator>::size_type;
+            using allocator_type  = Allocator;
+            using char_type       = typename iterator_traits<BidirectionalIterator>::value_type;
+            using string_type     = basic_string<char_type>;
+
+            /**
+             * 28.10.1, construct/copy/destroy:
+             */
+
+            explicit match_results(const Allocator& alloc = Allocator{})
+                : subs_{alloc}, prefix_{}, suffix_{}, unmatched_{},
+                  base_{}, ready_{false}
+            { /* DUMMY BODY */ }
+
+            match_results(const match_results&) = default;
+            match_results(match_results&&) = default;
+            match_results& operator=(const match_results&) = default;
+            match_results& operator=(match_results&&) = default;
+
+            ~match_results() = default;
+
+            /**
+             * 28.10.2, state:
+             */
+
+            bool ready() const
+            {
+                return ready_;
+            }
+
+            /**
+             * 28.10.3, size:
+             */
+
+            size_type size() const
+            {
+                return subs_.size();
+            }
+
+            size_type max_size() const
+            {
+                return subs_.max_size();
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            /**
+             * 28.10.4, element access:
+             */
+
+            difference_type length(size_type sub = 0) const
+            {
+                return (*this)[sub].length();
+            }
+
+            difference_type position(size_type sub = 0) const
+            {
+                return distance(base_, (*this)[sub].first);
+            }
+
+            string_type str(size_type sub = 0) const
+            {
+                return (*this)[sub].str();
+            }
+
+            const_reference operator[](size_type n) const
+            {
+                if (n < size())
+                    return subs_[n];
+                else
+                    return unmatched_;
+            }
+
+            const_reference prefix() const
+            {
+                return prefix_;
+            }
+
+            const_reference suffix() const
+            {
+                return suffix_;
+            }
+
+            const_iterator begin() const
+            {
+                return subs_.begin();
+            }
+
+            const_iterator end() const
+            {
+                return subs_.end();
+            }
+
+            const_iterator cbegin() const
+            {
+                return subs_.cbegin();
+            }
+
+            const_iterator cend() const
+            {
+                return subs_.cend();
+            }
+
+            /**
+             * 28.10.5, format:
+             */
+
+            template<class OutputIterator>
+            OutputIterator format(
+                OutputIterator out, const char_type* fmt_first, const char_type* fmt_last,
+                regex_constants::match_flag_type flags = regex_constants::format_default
+            ) const
+            {
+                if (flags & regex_constants::format_sed)
+                    return format_sed_(out, fmt_first, fmt_last);
+
+                for (auto it = fmt_first; it != fmt_last; ++it)
+                {
+                    if (*it != '$' || it + 1 == fmt_last)
+                    {
+                        *out++ = *it;
+                        continue;
+                    }
+
+                    auto c = *++it;
+                    if (c == '$')
+                        *out++ = '$';
+                    else if (c == '&')
+                        out = copy_(out, (*this)[0]);
+                    else if (c == '`')
+                        out = copy_(out, prefix());
+                    else if (c == '\'')
+                        out = copy_(out, suffix());
+                    else if (c >= '0' && c <= '9')
+                    {
+                        size_type n = c - '0';
+                        if (it + 1 != fmt_last && it[1] >= '0' && it[1] <= '9' &&
+                            n * 10 + (it[1] - '0') < size())
+                            n = n * 10 + (*++it - '0');
+
+                        out = copy_(out, (*this)[n]);
+                    }
+                    else
+                    {
+                        *out++ = '$';
+                        *out++ = c;
+                    }
+                }
+
+                return out;
+            }
+
+            template<class OutputIterator, class ST, class SA>
+            OutputIterator format(
+                OutputIterator out, const basic_string<char_type, ST, SA>& fmt,
+                regex_constants::match_flag_type flags = regex_constants::format_default
+            ) const
+            {
+                return format(out, fmt.data(), fmt.data() + fmt.size(), flags);
+            }
+
+            template<class ST, class SA>
+            basic_string<char_type, ST, SA> format(
+                const basic_string<char_type, ST, SA>& fmt,
+                regex_constants::match_flag_type flags = regex_constants::format_default
+            ) const
+            {
+                basic_string<char_type, ST, SA> res{};
+                format(back_inserter(res), fmt, flags);
+
+                return res;
+            }
+
+            string_type format(
+                const char_type* fmt,
+                regex_constants::match_flag_type flags = regex_constants::format_default
+            ) const
+            {
+                string_type res{};
+                format(back_inserter(res), fmt, fmt + char_traits<char_type>::length(fmt), flags);
+
+                return res;
+            }
+
+            /**
+             * 28.10.6, allocator:
+             */
+
+            allocator_type get_allocator() const
+            {
+                return subs_.get_allocator();
+            }
+
+            /**
+             * 28.10.7, swap:
+             */
+
+            void swap(match_results& other)
+            {
+                std::swap(subs_, other.subs_);
+                std::swap(prefix_, other.prefix_);
+                std::swap(suffix_, other.suffix_);
+                std::swap(unmatched_, other.unmatched_);
+                std::swap(base_, other.base_);
+                std::swap(ready_, other.ready_);
+            }
+
+        private:
+            vector<value_type, Allocator> subs_;
+            value_type prefix_;
+            value_type suffix_;
+            value_type unmatched_;
+            BidirectionalIterator base_;
+            bool ready_;
+
+            template<class OutputIterator>
+            static OutputIterator copy_(OutputIterator out, const value_type& sub)
+            {
+                if (sub.matched)
+                {
+                    for (auto it = sub.first; it != sub.second; ++it)
+                        *out++ = *it;
+                }
+
+                return out;
+            }
+
+            template<class OutputIterator>
+            OutputIterator format_sed_(OutputIterator out, const char_type* fmt_first,
+                                       const char_type* fmt_last) const
+            {
+                for (auto it = fmt_first; it != fmt_last; ++it)
+                {
+                    if (*it == '&')
+                        out = copy_(out, (*this)[0]);
+                    else if (*it == '\\' && it + 1 != fmt_last)
+                    {
+                        auto c = *++it;
+                        if (c >= '0' && c <= '9')
+                            out = copy_(out, (*this)[c - '0']);
+                        else
+                            *out++ = c;
+                    }
+                    else
+                        *out++ = *it;
+                }
+
+                return out;
+            }
+
+            friend struct aux::regex_access;
+    };
+
+    using cmatch  = match_results<const char*>;
+    using wcmatch = match_results<const wchar_t*>;
+    using smatch  = match_results<string::const_iterator>;
+    using wsmatch = match_results<wstring::const_iterator>;
+
+    template<class BidirectionalIterator, class Allocator>
+    bool operator==(const match_results<BidirectionalIterator, Allocator>& lhs,
+                    const match_results<BidirectionalIterator, Allocator>& rhs)
+    {
+        if (lhs.ready() != rhs.ready())
+            return false;
+        if (!lhs.ready())
+            return true;
+        if (lhs.empty() || rhs.empty())
+            return lhs.empty() == rhs.empty();
+
+        if (lhs.size() != rhs.size() || lhs.prefix() != rhs.prefix() ||
+            lhs.suffix() != rhs.suffix())
+            return false;
+
+        for (size_t i = 0; i < lhs.size(); ++i)
+        {
+            if (lhs[i] != rhs[i])
+                return false;
+        }
+
+        return true;
+    }
+
+    template<class BidirectionalIterator, class Allocator>
+    bool operator!=(const match_results<BidirectionalIterator, Allocator>& lhs,
+                    const match_results<BidirectionalIterator, Allocator>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class BidirectionalIterator, class Allocator>
+    void swap(match_results<BidirectionalIterator, Allocator>& lhs,
+              match_results<BidirectionalIterator, Allocator>& rhs)
+    {
+        lhs.swap(rhs);
+    }
+
+    namespace aux
+    {
+        struct regex_access
+        {
+            template<class charT, class traits>
+            static const regex_program* program(const basic_regex<charT, traits>& re)
+            {
+                return re.program_;
+            }
+
+            template<class BidirIt, class Alloc>
+            static void fill(match_results<BidirIt, Alloc>& m, BidirIt first, BidirIt last,
+                             const ptrdiff_t* caps, size_t marks, bool matched)
+            {
+                using sub_type = sub_match<BidirIt>;
+
+                m.ready_ = true;
+                m.base_ = first;
+                m.subs_.clear();
+                m.unmatched_.first = last;
+                m.unmatched_.second = last;
+                m.unmatched_.matched = false;
+
+                if (!matched)
+                {
+                    m.prefix_ = sub_type{};
+                    m.suffix_ = sub_type{};
+                    return;
+                }
+
+                m.subs_.resize(marks + 1);
+                for (size_t i = 0; i <= marks; ++i)
+                {
+                    auto& sub = m.subs_[i];
+                    if (caps[2 * i] >= 0 && caps[2 * i + 1] >= 0)
+                    {
+                        sub.first = next(first, caps[2 * i]);
+                        sub.second = next(first, caps[2 * i + 1]);
+                        sub.matched = true;
+                    }
+                    else
+                    {
+                        sub.first = last;
+                        sub.second = last;
+                        sub.matched = false;
+                    }
+                }
+
+                m.prefix_.first = first;
+                m.prefix_.second = m.subs_[0].first;
+                m.prefix_.matched = m.prefix_.first != m.prefix_.second;
+                m.suffix_.first = m.subs_[0].second;
+                m.suffix_.second = last;
+                m.suffix_.matched = m.suffix_.first != m.suffix_.second;
+            }
+
+            /**
+             * Used by regex_iterator, the prefix of a match starts
+             * at the end of the previous match and positions are
+             * relative to the start of the whole sequence.
+             */
+            template<class BidirIt, class Alloc>
+            static void rebase(match_results<BidirIt, Alloc>& m, BidirIt base,
+                               BidirIt prefix_first)
+            {
+                m.base_ = base;
+                m.prefix_.first = prefix_first;
+                m.prefix_.matched = m.prefix_.first != m.prefix_.second;
+            }
+        };
+
+        template<class BidirIt, class Alloc, class charT, class traits>
+        bool regex_run(BidirIt first, BidirIt last, match_results<BidirIt, Alloc>* m,
+                       const basic_regex<charT, traits>& re,
+                       regex_constants::match_flag_type flags, bool full)
+        {
+            auto prog = regex_access::program(re);
+            auto marks = regex_mark_count(prog);
+
+            vector<ptrdiff_t> caps{};
+            if (m)
+                caps.resize(2 * (marks + 1), -1);
+            auto caps_ptr = m ? caps.data() : nullptr;
+
+            bool matched{};
+            if constexpr (is_pointer_v<BidirIt>)
+                matched = regex_execute(prog, first, last, flags, full, caps_ptr);
+            else
+            {
+                /**
+                 * The engine needs contiguous input, with
+                 * match_prev_avail the character before
+                 * first is needed as well.
+                 */
+                bool prev = flags & regex_constants::match_prev_avail;
+
+                basic_string<charT> buffer{};
+                if (prev)
+                    buffer.push_back(*std::prev(first));
+                for (auto it = first; it != last; ++it)
+                    buffer.push_back(*it);
+
+                auto data = buffer.data() + (prev ? 1 : 0);
+                matched = regex_execute(prog, data, buffer.data() + buffer.size(),
+                                        flags, full, caps_ptr);
+            }
+
+            if (m)
+                regex_access::fill(*m, first, last, caps.data(), marks, matched);
+
+            return matched;
+        }
+    }
+
+    /**
+     * 28.11.2, regex_match:
+     */
+
+    template<class BidirectionalIterator, class Allocator, class charT, class traits>
+    bool regex_match(BidirectionalIterator first, BidirectionalIterator last,
+                     match_results<BidirectionalIterator, Allocator>& m,
+                     const basic_regex<charT, traits>& e,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return aux::regex_run(first, last, &m, e, flags, true);
+    }
+
+    template<class BidirectionalIterator, class charT, class traits>
+    bool regex_match(BidirectionalIterator first, BidirectionalIterator last,
+                     const basic_regex<charT, traits>& e,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        match_results<BidirectionalIterator>* m{};
+
+        return aux::regex_run(first, last, m, e, flags, true);
+    }
+
+    template<class charT, class Allocator, class traits>
+    bool regex_match(const charT* str, match_results<const charT*, Allocator>& m,
+                     const basic_regex<charT, traits>& e,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_match(str, str + char_traits<charT>::length(str), m, e, flags);
+    }
+
+    template<class ST, class SA, class Allocator, class charT, class traits>
+    bool regex_match(const basic_string<charT, ST, SA>& s,
+                     match_results<typename basic_string<charT, ST, SA>::const_iterator, Allocator>& m,
+                     const basic_regex<charT, traits>& e,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_match(s.begin(), s.end(), m, e, flags);
+    }
+
+    template<class ST, class SA, class Allocator, class charT, class traits>
+    bool regex_match(const basic_string<charT, ST, SA>&&,
+                     match_results<typename basic_string<charT, ST, SA>::const_iterator, Allocator>&,
+                     const basic_regex<charT, traits>&,
+                     regex_constants::match_flag_type = regex_constants::match_default) = delete;
+
+    template<class charT, class traits>
+    bool regex_match(const charT* str, const basic_regex<charT, traits>& e,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_match(str, str + char_traits<charT>::length(str), e, flags);
+    }
+
+    template<class ST, class SA, class charT, class traits>
+    bool regex_match(const basic_string<charT, ST, SA>& s, const basic_regex<charT, traits>& e,
+                     regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_match(s.begin(), s.end(), e, flags);
+    }
+
+    /**
+     * 28.11.3, regex_search:
+     */
+
+    template<class BidirectionalIterator, class Allocator, class charT, class traits>
+    bool regex_search(BidirectionalIterator first, BidirectionalIterator last,
+                      match_results<BidirectionalIterator, Allocator>& m,
+                      const basic_regex<charT, traits>& e,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return aux::regex_run(first, last, &m, e, flags, false);
+    }
+
+    template<class BidirectionalIterator, class charT, class traits>
+    bool regex_search(BidirectionalIterator first, BidirectionalIterator last,
+                      const basic_regex<charT, traits>& e,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        match_results<BidirectionalIterator>* m{};
+
+        return aux::regex_run(first, last, m, e, flags, false);
+    }
+
+    template<class charT, class Allocator, class traits>
+    bool regex_search(const charT* str, match_results<const charT*, Allocator>& m,
+                      const basic_regex<charT, traits>& e,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_search(str, str + char_traits<charT>::length(str), m, e, flags);
+    }
+
+    template<class charT, class traits>
+    bool regex_search(const charT* str, const basic_regex<charT, traits>& e,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_search(str, str + char_traits<charT>::length(str), e, flags);
+    }
+
+    template<class ST, class SA, class charT, class traits>
+    bool regex_search(const basic_string<charT, ST, SA>& s, const basic_regex<charT, traits>& e,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_search(s.begin(), s.end(), e, flags);
+    }
+
+    template<class ST, class SA, class Allocator, class charT, class traits>
+    bool regex_search(const basic_string<charT, ST, SA>& s,
+                      match_results<typename basic_string<charT, ST, SA>::const_iterator, Allocator>& m,
+                      const basic_regex<charT, traits>& e,
+                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return regex_search(s.begin(), s.end(), m, e, flags);
+    }
+
+    template<class ST, class SA, class Allocator, class charT, class traits>
+    bool regex_search(const basic_string<charT, ST, SA>&&,
+                      match_results<typename basic_string<charT, ST, SA>::const_iterator, Allocator>&,
+                      const basic_regex<charT, traits>&,
+                      regex_constants::match_flag_type = regex_constants::match_default) = delete;
+
+    /**
+     * 28.12.1, class template regex_iterator:
+     */
+
+    template<
+        class BidirectionalIterator,
+        class charT = typename iterator_traits<BidirectionalIterator>::value_type,
+        class traits = regex_traits<charT>
+    >
+    class regex_iterator
+    {
+        public:
+            using regex_type        = basic_regex<charT, traits>;
+            using value_type        = match_results<BidirectionalIterator>;
+            using difference_type   = ptrdiff_t;
+            using pointer           = const value_type*;
+            using reference         = const value_type&;
+            using iterator_category = forward_iterator_tag;
+
+            regex_iterator()
+                : begin_{}, end_{}, regex_{}, flags_{}, match_{}
+            { /* DUMMY BODY */ }
+
+            regex_iterator(BidirectionalIterator a, BidirectionalIterator b,
+                           const regex_type& re,
+                           regex_constants::match_flag_type flags = regex_constants::match_default)
+                : begin_{a}, end_{b}, regex_{&re}, flags_{flags}, match_{}
+            {
+                if (!regex_search(begin_, end_, match_, *regex_, flags_))
+                    regex_ = nullptr;
+            }
+
+            regex_iterator(BidirectionalIterator, BidirectionalIterator, const regex_type&&,
+                           regex_constants::match_flag_type = regex_constants::match_default) = delete;
+
+            regex_iterator(const regex_iterator&) = default;
+            regex_iterator& operator=(const regex_iterator&) = default;
+
+            bool operator==(const regex_iterator& other) const
+            {
+                if (!regex_ || !other.regex_)
+                    return regex_ == other.regex_;
+
+                return begin_ == other.begin_ && end_ == other.end_ &&
+                       regex_ == other.regex_ && flags_ == other.flags_ &&
+                       match_[0] == other.match_[0];
+            }
+
+            bool operator!=(const regex_iterator& other) const
+            {
+                return !(*this == other);
+            }
+
+            reference operator*() const
+            {
+                return match_;
+            }
+
+            pointer operator->() const
+            {
+                return &match_;
+            }
+
+            regex_iterator& operator++()
+            {
+                auto prev_end = match_[0].second;
+                auto start = prev_end;
+                auto flags = flags_;
+                if (start != begin_)
+                    flags |= regex_constants::match_prev_avail;
+
+                if (match_[0].first == match_[0].second)
+                {
+                    /**
+                     * After an empty match try a non empty one at the
+                     * same position, then continue one character later.
+                     */
+                    if (start == end_)
+                    {
+                        regex_ = nullptr;
+                        return *this;
+                    }
+
+                    auto retry = flags | regex_constants::match_not_null |
+                                 regex_constants::match_continuous;
+                    if (regex_search(start, end_, match_, *regex_, retry))
+                    {
+                        aux::regex_access::rebase(match_, begin_, prev_end);
+                        return *this;
+                    }
+
+                    ++start;
+                    flags = flags_ | regex_constants::match_prev_avail;
+                }
+
+                if (regex_search(start, end_, match_, *regex_, flags))
+                    aux::regex_access::rebase(match_, begin_, prev_end);
+                else
+                    regex_ = nullptr;
+
+                return *this;
+            }
+
+            regex_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+        private:
+            BidirectionalIterator begin_;
+            BidirectionalIterator end_;
+            const regex_type* regex_;
+            regex_constants::match_flag_type flags_;
+            match_results<BidirectionalIterator> match_;
+    };
+
+    using cregex_iterator  = regex_iterator<const char*>;
+    using wcregex_iterator = regex_iterator<const wchar_t*>;
+    using sregex_iterator  = regex_iterator<string::const_iterator>;
+    using wsregex_iterator = regex_iterator<wstring::const_iterator>;
+
+    /**
+     * 28.12.2, class template regex_token_iterator:
+     */
+
+    template<
+        class BidirectionalIterator,
+        class charT = typename iterator_traits<BidirectionalIterator>::value_type,
+        class traits = regex_traits<charT>
+    >
+    class regex_token_iterator
+    {
+        public:
+            using regex_type        = basic_regex<charT, traits>;
+            using value_type        = sub_match<BidirectionalIterator>;
+            using difference_type   = ptrdiff_t;
+            using pointer           = const value_type*;
+            using reference         = const value_type&;
+            using iterator_category = forward_iterator_tag;
+
+            regex_token_iterator()
+                : position_{}, result_{}, suffix_{}, n_{}, subs_{}
+            { /* DUMMY BODY */ }
+
+            regex_token_iterator(BidirectionalIterator a, BidirectionalIterator b,
+                                 const regex_type& re, int submatch = 0,
+                                 regex_constants::match_flag_type flags = regex_constants::match_default)
+                : position_{a, b, re, flags}, result_{}, suffix_{}, n_{}, subs_{}
+            {
+                subs_.push_back(submatch);
+                init_(a, b);
+            }
+
+            regex_token_iterator(BidirectionalIterator a, BidirectionalIterator b,
+                                 const regex_type& re, const vector<int>& submatches,
+                                 regex_constants::match_flag_type flags = regex_constants::match_default)
+                : position_{a, b, re, flags}, result_{}, suffix_{}, n_{}, subs_{submatches}
+            {
+                init_(a, b);
+            }
+
+            regex_token_iterator(BidirectionalIterator a, BidirectionalIterator b,
+                                 const regex_type& re, initializer_list<int> submatches,
+                                 regex_constants::match_flag_type flags = regex_constants::match_default)
+                : position_{a, b, re, flags}, result_{}, suffix_{}, n_{}, subs_{submatches}
+            {
+                init_(a, b);
+            }
+
+            template<size_t N>
+            regex_token_iterator(BidirectionalIterator a, BidirectionalIterator b,
+                                 const regex_type& re, const int (&submatches)[N],
+                                 regex_constants::match_flag_type flags = regex_constants::match_default)
+                : position_{a, b, re, flags}, result_{}, suffix_{}, n_{},
+                  subs_(submatches, submatches + N)
+            {
+                init_(a, b);
+            }
+
+            regex_token_iterator(BidirectionalIterator, BidirectionalIterator,
+                                 const regex_type&&, int = 0,
+                                 regex_constants::match_flag_type = regex_constants::match_default) = delete;
+
+            regex_token_iterator(const regex_token_iterator& other)
+                : position_{other.position_}, result_{}, suffix_{other.suffix_},
+                  n_{other.n_}, subs_{other.subs_}
+            {
+                copy_result_(other);
+            }
+
+            regex_token_iterator& operator=(const regex_token_iterator& other)
+            {
+                position_ = other.position_;
+                suffix_ = other.suffix_;
+                n_ = other.n_;
+                subs_ = other.subs_;
+                copy_result_(other);
+
+                return *this;
+            }
+
+            bool operator==(const regex_token_iterator& other) const
+            {
+                if (!result_ || !other.result_)
+                    return result_ == other.result_;
+                if (result_ == &suffix_ || other.result_ == &other.suffix_)
+                {
+                    return result_ == &suffix_ && other.result_ == &other.suffix_ &&
+                           suffix_ == other.suffix_;
+                }
+
+                return position_ == other.position_ && n_ == other.n_ &&
+                       subs_ == other.subs_;
+            }
+
+            bool operator!=(const regex_token_iterator& other) const
+            {
+                return !(*this == other);
+            }
+
+            reference operator*() const
+            {
+                return *result_;
+            }
+
+            pointer operator->() const
+            {
+                return result_;
+            }
+
+            regex_token_iterator& operator++()
+            {
+                if (result_ == &suffix_)
+                {
+                    result_ = nullptr;
+                    return *this;
+                }
+
+                if (n_ + 1 < subs_.size())
+                {
+                    ++n_;
+                    result_ = current_();
+                    return *this;
+                }
+
+                auto last_suffix = position_->suffix();
+                ++position_;
+                n_ = 0;
+
+                if (position_ != end_)
+                    result_ = current_();
+                else if (splits_() && last_suffix.length() != 0)
+                {
+                    suffix_ = last_suffix;
+                    result_ = &suffix_;
+                }
+                else
+                    result_ = nullptr;
+
+                return *this;
+            }
+
+            regex_token_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+        private:
+            using position_iterator = regex_iterator<BidirectionalIterator, charT, traits>;
+
+            position_iterator position_;
+            const value_type* result_;
+            value_type suffix_;
+            size_t n_;
+            vector<int> subs_;
+
+            static inline const position_iterator end_{};
+
+            bool splits_() const
+            {
+                for (auto sub: subs_)
+                {
+                    if (sub == -1)
+                        return true;
+                }
+
+                return false;
+            }
+
+            const value_type* current_() const
+            {
+                if (subs_[n_] == -1)
+                    return &position_->prefix();
+                else
+                    return &(*position_)[subs_[n_]];
+            }
+
+            void init_(BidirectionalIterator a, BidirectionalIterator b)
+            {
+                if (position_ != end_)
+                    result_ = current_();
+                else if (splits_() && a != b)
+                {
+                    // No match at all, the whole sequence is the only token.
+                    suffix_.first = a;
+                    suffix_.second = b;
+                    suffix_.matched = true;
+                    result_ = &suffix_;
+                }
+            }
+
+            void copy_result_(const regex_token_iterator& other)
+            {
+                if (!other.result_)
+                    result_ = nullptr;
+                else if (other.result_ == &other.suffix_)
+                    result_ = &suffix_;
+                else
+                    result_ = current_();
+            }
+    };
+
+    using cregex_token_iterator  = regex_token_iterator<const char*>;
+    using wcregex_token_iterator = regex_token_iterator<const wchar_t*>;
+    using sregex_token_iterator  = regex_token_iterator<string::const_iterator>;
+    using wsregex_token_iterator = regex_token_iterator<wstring::const_iterator>;
+
+    /**
+     * 28.11.4, regex_replace:
+     */
+
+    namespace aux
+    {
+        template<class OutputIterator, class BidirIt, class traits, class charT>
+        OutputIterator regex_replace(OutputIterator out, BidirIt first, BidirIt last,
+                                     const basic_regex<charT, traits>& e,
+                                     const charT* fmt_first, const charT* fmt_last,
+                                     regex_constants::match_flag_type flags)
+        {
+            regex_iterator<BidirIt, charT, traits> it{first, last, e, flags};
+            regex_iterator<BidirIt, charT, traits> end{};
+            bool copy = !(flags & regex_constants::format_no_copy);
+
+            auto tail = first;
+            for (; it != end; ++it)
+            {
+                if (copy)
+                {
+                    for (auto c = it->prefix().first; c != it->prefix().second; ++c)
+                        *out++ = *c;
+                }
+
+                out = it->format(out, fmt_first, fmt_last, flags);
+                tail = it->suffix().first;
+
+                if (flags & regex_constants::format_first_only)
+                    break;
+            }
+
+            if (copy)
+            {
+                for (; tail != last; ++tail)
+                    *out++ = *tail;
+            }
+
+            return out;
+        }
+    }
+
+    template<class OutputIterator, class BidirectionalIterator, class traits,
+             class charT, class ST, class SA>
+    OutputIterator regex_replace(OutputIterator out,
+                                 BidirectionalIterator first, BidirectionalIterator last,
+                                 const basic_regex<charT, traits>& e,
+                                 const basic_string<charT, ST, SA>& fmt,
+                                 regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return aux::regex_replace(out, first, last, e, fmt.data(),
+                                  fmt.data() + fmt.size(), flags);
+    }
+
+    template<class OutputIterator, class BidirectionalIterator, class traits, class charT>
+    OutputIterator regex_replace(OutputIterator out,
+                                 BidirectionalIterator first, BidirectionalIterator last,
+                                 const basic_regex<charT, traits>& e, const charT* fmt,
+                                 regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        return aux::regex_replace(out, first, last, e, fmt,
+                                  fmt + char_traits<charT>::length(fmt), flags);
+    }
+
+    template<class traits, class charT, class ST, class SA, class FST, class FSA>
+    basic_string<charT, ST, SA> regex_replace(const basic_string<charT, ST, SA>& s,
+                                              const basic_regex<charT, traits>& e,
+                                              const basic_string<charT, FST, FSA>& fmt,
+                                              regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        basic_string<charT, ST, SA> res{};
+        regex_replace(back_inserter(res), s.begin(), s.end(), e, fmt, flags);
+
+        return res;
+    }
+
+    template<class traits, class charT, class ST, class SA>
+    basic_string<charT, ST, SA> regex_replace(const basic_string<charT, ST, SA>& s,
+                                              const basic_regex<charT, traits>& e,
+                                              const charT* fmt,
+                                              regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        basic_string<charT, ST, SA> res{};
+        regex_replace(back_inserter(res), s.begin(), s.end(), e, fmt, flags);
+
+        return res;
+    }
+
+    template<class traits, class charT, class ST, class SA>
+    basic_string<charT> regex_replace(const charT* s,
+                                      const basic_regex<charT, traits>& e,
+                                      const basic_string<charT, ST, SA>& fmt,
+                                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        basic_string<charT> res{};
+        regex_replace(back_inserter(res), s, s + char_traits<charT>::length(s), e, fmt, flags);
+
+        return res;
+    }
+
+    template<class traits, class charT>
+    basic_string<charT> regex_replace(const charT* s,
+                                      const basic_regex<charT, traits>& e,
+                                      const charT* fmt,
+                                      regex_constants::match_flag_type flags = regex_constants::match_default)
+    {
+        basic_string<charT> res{};
+        regex_replace(back_inserter(res), s, s + char_traits<charT>::length(s), e, fmt, flags);
+
+        return res;
+    }
+}
 
 #endif
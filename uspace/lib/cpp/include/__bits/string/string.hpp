@@ -431,12 +431,61 @@ namespace std
         }
     };
 
+    namespace aux
+    {
+        /**
+         * Base of basic_string that stores its allocator,
+         * taking no space when the allocator is empty.
+         */
+        template<class Allocator, bool = is_empty<Allocator>::value &&
+                                         !is_final<Allocator>::value>
+        class string_allocator_holder: private Allocator
+        {
+            public:
+                string_allocator_holder(const Allocator& alloc)
+                    : Allocator{alloc}
+                { /* DUMMY BODY */ }
+
+                Allocator& allocator_() noexcept
+                {
+                    return *this;
+                }
+
+                const Allocator& allocator_() const noexcept
+                {
+                    return *this;
+                }
+        };
+
+        template<class Allocator>
+        class string_allocator_holder<Allocator, false>
+        {
+            public:
+                string_allocator_holder(const Allocator& alloc)
+                    : alloc_{alloc}
+                { /* DUMMY BODY */ }
+
+                Allocator& allocator_() noexcept
+                {
+                    return alloc_;
+                }
+
+                const Allocator& allocator_() const noexcept
+                {
+                    return alloc_;
+                }
+
+            private:
+                Allocator alloc_;
+        };
+    }
+
     /**
      * 21.4, class template basic_string:
      */
 
     template<class Char, class Traits, class Allocator>
-    class basic_string
+    class basic_string: private aux::string_allocator_holder<Allocator>
     {
         public:
             using traits_type     = Traits;
@@ -468,7 +517,7 @@ namespace std
             { /* DUMMY BODY */ }
 
             explicit basic_string(const allocator_type& alloc)
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : allocator_holder_{alloc}, data_{local_}, size_{}
             {
                 /**
                  * Postconditions:
@@ -476,29 +525,24 @@ namespace std
                  *  size() = 0
                  *  capacity() = unspecified
                  */
-                data_ = allocator_.allocate(default_capacity_);
-                capacity_ = default_capacity_;
+                ensure_null_terminator_();
             }
 
             basic_string(const basic_string& other)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_},
-                  allocator_{other.allocator_}
+                : allocator_holder_{other.allocator_()}, data_{local_}, size_{}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size_);
             }
 
-            basic_string(basic_string&& other)
-                : data_{other.data_}, size_{other.size_},
-                  capacity_{other.capacity_}, allocator_{move(other.allocator_)}
+            basic_string(basic_string&& other) noexcept
+                : allocator_holder_{move(other.allocator_())}, data_{local_}, size_{}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                steal_(other);
             }
 
             basic_string(const basic_string& other, size_type pos, size_type n = npos,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : allocator_holder_{alloc}, data_{local_}, size_{}
             {
                 // TODO: if pos < other.size() throw out_of_range.
                 auto len = min(n, other.size() - pos);
@@ -506,36 +550,35 @@ namespace std
             }
 
             basic_string(const value_type* str, size_type n, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : allocator_holder_{alloc}, data_{local_}, size_{}
             {
-                init_(str, size_);
+                init_(str, n);
             }
 
             basic_string(const value_type* str, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : allocator_holder_{alloc}, data_{local_}, size_{}
             {
                 init_(str, traits_type::length(str));
             }
 
             basic_string(size_type n, value_type c, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : allocator_holder_{alloc}, data_{local_}, size_{}
             {
-                data_ = allocator_.allocate(capacity_);
-                for (size_type i = 0; i < size_; ++i)
-                    traits_type::assign(data_[i], c);
+                resize_without_copy_(n + 1);
+                size_ = n;
+                traits_type::assign(data_, n, c);
                 ensure_null_terminator_();
             }
 
             template<class InputIterator>
             basic_string(InputIterator first, InputIterator last,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : allocator_holder_{alloc}, data_{local_}, size_{}
             {
                 if constexpr (is_integral<InputIterator>::value)
                 { // Required by the standard.
+                    resize_without_copy_(static_cast<size_type>(first) + 1);
                     size_ = static_cast<size_type>(first);
-                    capacity_ = size_;
-                    data_ = allocator_.allocate(capacity_);
 
                     for (size_type i = 0; i < size_; ++i)
                         traits_type::assign(data_[i], static_cast<value_type>(last));
@@ -553,22 +596,20 @@ namespace std
             { /* DUMMY BODY */ }
 
             basic_string(const basic_string& other, const allocator_type& alloc)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : allocator_holder_{alloc}, data_{local_}, size_{}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size_);
             }
 
             basic_string(basic_string&& other, const allocator_type& alloc)
-                : data_{other.data_}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : allocator_holder_{alloc}, data_{local_}, size_{}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                steal_(other);
             }
 
             ~basic_string()
             {
-                allocator_.deallocate(data_, capacity_);
+                release_();
             }
 
             basic_string& operator=(const basic_string& other)
@@ -704,7 +745,7 @@ namespace std
                 {
                     ensure_free_space_(new_size - size_ + 1);
                     for (size_type i = size_; i < new_size; ++i)
-                        traits_type::assign(data_[i], i);
+                        traits_type::assign(data_[i], c);
                 }
 
                 size_ = new_size;
@@ -718,7 +759,7 @@ namespace std
 
             size_type capacity() const noexcept
             {
-                return capacity_;
+                return capacity_();
             }
 
             void reserve(size_type new_capacity = 0)
@@ -726,21 +767,22 @@ namespace std
                 // TODO: if new_capacity > max_size() throw
                 //       length_error (this function shall have no
                 //       effect in such case)
-                if (new_capacity > capacity_)
+                if (new_capacity > capacity_())
                     resize_with_copy_(size_, new_capacity);
-                else if (new_capacity < capacity_)
+                else if (new_capacity < capacity_())
                     shrink_to_fit(); // Non-binding request, but why not.
             }
 
             void shrink_to_fit()
             {
-                if (size_ != capacity_)
-                    resize_with_copy_(size_, capacity_);
+                if (size_ + 1 != capacity_())
+                    resize_with_copy_(size_, size_ + 1);
             }
 
             void clear() noexcept
             {
                 size_ = 0;
+                ensure_null_terminator_();
             }
 
             bool empty() const noexcept
@@ -905,8 +947,9 @@ namespace std
             basic_string& assign(const value_type* str, size_type n)
             {
                 // TODO: if (n > max_size()) throw length_error.
-                resize_without_copy_(n);
-                traits_type::copy(begin(), str, n);
+                if (n + 1 > capacity_())
+                    resize_without_copy_(n + 1);
+                traits_type::move(begin(), str, n);
                 size_ = n;
                 ensure_null_terminator_();
 
@@ -1081,7 +1124,7 @@ namespace std
                 auto len = min(n1, size_ - pos);
 
                 basic_string tmp{};
-                tmp.resize_without_copy_(size_ - len + n2);
+                tmp.resize_without_copy_(size_ - len + n2 + 1);
 
                 // Prefix.
                 copy_(begin(), begin() + pos, tmp.begin());
@@ -1093,6 +1136,7 @@ namespace std
                 copy_(begin() + pos + len, end(), tmp.begin() + pos + n2);
 
                 tmp.size_ = size_ - len + n2;
+                tmp.ensure_null_terminator_();
                 swap(tmp);
                 return *this;
             }
@@ -1158,9 +1202,27 @@ namespace std
                 noexcept(allocator_traits<allocator_type>::propagate_on_container_swap::value ||
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
-                std::swap(data_, other.data_);
+                if (this == &other)
+                    return;
+
+                if (!is_local_() && !other.is_local_())
+                {
+                    std::swap(data_, other.data_);
+                    std::swap(heap_capacity_, other.heap_capacity_);
+                }
+                else if (is_local_() && other.is_local_())
+                {
+                    value_type tmp[local_capacity_];
+                    traits_type::copy(tmp, local_, size_ + 1);
+                    traits_type::copy(local_, other.local_, other.size_ + 1);
+                    traits_type::copy(other.local_, tmp, size_ + 1);
+                }
+                else if (is_local_())
+                    swap_local_with_heap_(other);
+                else
+                    other.swap_local_with_heap_(*this);
+
                 std::swap(size_, other.size_);
-                std::swap(capacity_, other.capacity_);
             }
 
             /**
@@ -1179,7 +1241,7 @@ namespace std
 
             allocator_type get_allocator() const noexcept
             {
-                return allocator_type{allocator_};
+                return allocator_type{allocator_()};
             }
 
             /**
@@ -1474,31 +1536,90 @@ namespace std
             }
 
         private:
+            using allocator_holder_ = aux::string_allocator_holder<allocator_type>;
+            using allocator_holder_::allocator_;
+
+            /**
+             * Number of characters, including the null terminator,
+             * that fit in the string object itself. Short strings
+             * live there and need no allocation.
+             */
+            static constexpr size_type local_capacity_{
+                16 / sizeof(value_type) > 1 ? 16 / sizeof(value_type) : 1
+            };
+
+            /**
+             * Points either to local_ or to a buffer allocated
+             * with heap_capacity_ characters.
+             */
             value_type* data_;
             size_type size_;
-            size_type capacity_;
-            allocator_type allocator_;
+
+            union
+            {
+                size_type heap_capacity_;
+                value_type local_[local_capacity_];
+            };
 
             template<class C, class T, class A>
             friend class basic_stringbuf;
 
+            bool is_local_() const noexcept
+            {
+                return data_ == local_;
+            }
+
+            size_type capacity_() const noexcept
+            {
+                return is_local_() ? local_capacity_ : heap_capacity_;
+            }
+
+            void release_()
+            {
+                if (!is_local_())
+                    allocator_().deallocate(data_, heap_capacity_);
+                data_ = local_;
+            }
+
             /**
-             * Arbitrary value, standard just requires
-             * data() to have some capacity.
-             * (Well, we could've done data_ = &data_ and
-             * set capacity to 0, but that would be too cryptic.)
+             * Sets the data, size and capacity of the string
+             * to those of other, which becomes empty.
              */
-            static constexpr size_type default_capacity_{4};
+            void steal_(basic_string& other)
+            {
+                release_();
+
+                if (other.is_local_())
+                    traits_type::copy(local_, other.local_, other.size_ + 1);
+                else
+                {
+                    data_ = other.data_;
+                    heap_capacity_ = other.heap_capacity_;
+                    other.data_ = other.local_;
+                }
+
+                size_ = other.size_;
+                other.size_ = 0;
+                other.ensure_null_terminator_();
+            }
+
+            void swap_local_with_heap_(basic_string& other)
+            {
+                value_type tmp[local_capacity_];
+                traits_type::copy(tmp, local_, size_ + 1);
+
+                data_ = other.data_;
+                heap_capacity_ = other.heap_capacity_;
+
+                other.data_ = other.local_;
+                traits_type::copy(other.local_, tmp, size_ + 1);
+            }
 
             void init_(const value_type* str, size_type size)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                resize_without_copy_(size + 1);
 
                 size_ = size;
-                capacity_ = size + 1;
-
-                data_ = allocator_.allocate(capacity_);
                 traits_type::copy(data_, str, size);
                 ensure_null_terminator_();
             }
@@ -1506,9 +1627,9 @@ namespace std
             size_type next_capacity_(size_type hint = 0) const noexcept
             {
                 if (hint != 0)
-                    return max(capacity_ * 2, hint);
+                    return max(capacity_() * 2, hint);
                 else
-                    return max(capacity_ * 2, size_type{2u});
+                    return max(capacity_() * 2, size_type{2u});
             }
 
             void ensure_free_space_(size_type n)
@@ -1518,36 +1639,58 @@ namespace std
                  *       did in vector, because in string
                  *       reserve can cause shrinking.
                  */
-                if (size_ + 1 + n > capacity_)
+                if (size_ + 1 + n > capacity_())
                     resize_with_copy_(size_, max(size_ + 1 + n, next_capacity_()));
             }
 
+            /**
+             * Makes room for capacity characters and empties the string,
+             * the current buffer is kept if it is large enough.
+             */
             void resize_without_copy_(size_type capacity)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                if (capacity > capacity_())
+                {
+                    release_();
+
+                    if (capacity > local_capacity_)
+                    {
+                        data_ = allocator_().allocate(capacity);
+                        heap_capacity_ = capacity;
+                    }
+                }
 
-                data_ = allocator_.allocate(capacity);
                 size_ = 0;
-                capacity_ = capacity;
                 ensure_null_terminator_();
             }
 
             void resize_with_copy_(size_type size, size_type capacity)
             {
-                if(capacity_ == 0 || capacity_ < capacity)
-                {
-                    auto new_data = allocator_.allocate(capacity);
-
-                    auto to_copy = min(size, size_);
-                    traits_type::move(new_data, data_, to_copy);
+                auto to_copy = min(size, size_);
+                capacity = max(capacity, size + 1);
 
-                    std::swap(data_, new_data);
+                if (capacity <= local_capacity_)
+                {
+                    if (!is_local_())
+                    {
+                        auto old_data = data_;
+                        auto old_capacity = heap_capacity_;
+
+                        traits_type::copy(local_, old_data, to_copy);
+                        data_ = local_;
+                        allocator_().deallocate(old_data, old_capacity);
+                    }
+                }
+                else if (capacity != capacity_())
+                {
+                    auto new_data = allocator_().allocate(capacity);
+                    traits_type::copy(new_data, data_, to_copy);
 
-                    allocator_.deallocate(new_data, capacity_);
+                    release_();
+                    data_ = new_data;
+                    heap_capacity_ = capacity;
                 }
 
-                capacity_ = capacity;
                 size_ = size;
                 ensure_null_terminator_();
             }
@@ -1989,4 +2132,23 @@ inline namespace string_literals
 #pragma GCC diagnostic pop
 }
 
+namespace std::pmr
+{
+    /**
+     * Aliases using polymorphic memory resources,
+     * see <memory_resource>.
+     */
+
+    template<class T>
+    class polymorphic_allocator;
+
+    template<class Char, class Traits = char_traits<Char>>
+    using basic_string = std::basic_string<Char, Traits, polymorphic_allocator<Char>>;
+
+    using string    = basic_string<char>;
+    using u16string = basic_string<char16_t>;
+    using u32string = basic_string<char32_t>;
+    using wstring   = basic_string<wchar_t>;
+}
+
 #endif
@@ -92,6 +92,19 @@ namespace std::test
             ~array_test() = default;
     };
 
+    class atomic_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_operations();
+            void test_wait();
+            void test_mutex();
+            void test_condition_variable();
+    };
+
     class vector_test: public test_suite
     {
         public:
@@ -105,6 +118,18 @@ namespace std::test
             void test_construction_and_assignment();
             void test_insert();
             void test_erase();
+            void test_growth();
+    };
+
+    class flat_hash_map_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_map();
+            void test_set();
     };
 
     class string_test: public test_suite
@@ -123,6 +148,46 @@ namespace std::test
             void test_find();
             void test_substr();
             void test_compare();
+            void test_short_strings();
+    };
+
+    class string_bench: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void bench_short();
+            void bench_long();
+    };
+
+    class regex_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_match();
+            void test_search();
+            void test_submatches();
+            void test_replace();
+            void test_iterators();
+            void test_errors();
+    };
+
+    class regex_bench: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void bench_search();
+            void bench_reject();
+            void bench_pathological();
+            void bench_backrefs();
     };
 
     class bitset_test: public test_suite
@@ -177,6 +242,8 @@ namespace std::test
             void test_multi();
             void test_reverse_iterators();
             void test_multi_bounds_and_ranges();
+            void test_node_handles();
+            void test_node_pool();
     };
 
     class set_test: public test_suite
@@ -192,6 +259,7 @@ namespace std::test
             void test_multi();
             void test_reverse_iterators();
             void test_multi_bounds_and_ranges();
+            void test_node_handles();
     };
 
     class unordered_map_test: public test_suite
@@ -256,6 +324,19 @@ namespace std::test
             void test_pointers();
     };
 
+    class memory_resource_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void test_global_resources();
+            void test_monotonic_buffer();
+            void test_pool_resources();
+            void test_containers();
+    };
+
     class list_test: public test_suite
     {
         public:
@@ -285,6 +366,18 @@ namespace std::test
             void test_bind();
     };
 
+    class function_bench: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+
+        private:
+            void bench_pointer();
+            void bench_lambda();
+            void bench_large();
+    };
+
     class algorithm_test: public test_suite
     {
         public:
@@ -293,6 +386,18 @@ namespace std::test
         private:
             void test_non_modifying();
             void test_mutating();
+            void test_sorting();
+    };
+
+    class execution_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+        private:
+            void test_async();
+            void test_promise();
+            void test_algorithms();
     };
 }
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_THREAD_ATOMIC_WAIT
+#define LIBCPP_BITS_THREAD_ATOMIC_WAIT
+
+#include <__bits/thread/threading.hpp>
+#include <cerrno>
+#include <chrono>
+
+namespace std::aux
+{
+    /**
+     * Fibrils waiting for a change of the value at some address
+     * park on one of a fixed number of slots chosen by hashing
+     * the address. Unrelated addresses may share a slot, so all
+     * of its waiters are woken and each rechecks its condition.
+     */
+    struct atomic_wait_slot
+    {
+        mutex_t mtx;
+        condvar_t cv;
+        unsigned int waiters;
+    };
+
+    atomic_wait_slot& atomic_wait_slot_for(const volatile void*) noexcept;
+
+    /**
+     * Wakes the fibrils waiting on the address, which costs
+     * only a load and a fence when there are none. Must be
+     * called after the value has been modified.
+     */
+    void atomic_notify(const volatile void*) noexcept;
+
+    template<class Predicate>
+    bool atomic_wait_impl(const volatile void* addr, Predicate& ready,
+                          bool timed, time_unit_t timeout)
+    {
+        if (ready())
+            return true;
+        else if (timed && timeout <= 0)
+            return false;
+
+        chrono::steady_clock::time_point deadline{};
+        if (timed)
+            deadline = chrono::steady_clock::now() + chrono::microseconds{timeout};
+
+        auto& slot = atomic_wait_slot_for(addr);
+
+        threading::mutex::lock(slot.mtx);
+
+        /**
+         * Pairs with the fence in atomic_notify(), either we see
+         * the new value or the notifier sees us waiting.
+         */
+        __atomic_add_fetch(&slot.waiters, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        bool res{};
+        while (!(res = ready()))
+        {
+            if (!timed)
+            {
+                threading::condvar::wait(slot.cv, slot.mtx);
+                continue;
+            }
+
+            timeout = threading::time::convert(
+                deadline - chrono::steady_clock::now()
+            );
+            if (timeout <= 0 ||
+                threading::condvar::wait_for(slot.cv, slot.mtx, timeout) != EOK)
+            {
+                res = ready();
+                break;
+            }
+        }
+
+        __atomic_sub_fetch(&slot.waiters, 1, __ATOMIC_RELAXED);
+        threading::mutex::unlock(slot.mtx);
+
+        return res;
+    }
+
+    /**
+     * Blocks the calling fibril until ready() returns true,
+     * ready() has to become true only by a modification that
+     * is followed by atomic_notify() on the same address.
+     */
+    template<class Predicate>
+    void atomic_wait(const volatile void* addr, Predicate ready)
+    {
+        atomic_wait_impl(addr, ready, false, 0);
+    }
+
+    /**
+     * Like atomic_wait(), but gives up after the timeout
+     * and returns the last result of ready().
+     */
+    template<class Predicate>
+    bool atomic_wait_for(const volatile void* addr, Predicate ready,
+                         time_unit_t timeout)
+    {
+        return atomic_wait_impl(addr, ready, true, timeout);
+    }
+}
+
+#endif
@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_THREAD_CONDITION_VARIABLE
 #define LIBCPP_BITS_THREAD_CONDITION_VARIABLE
 
+#include <__bits/thread/atomic_wait.hpp>
 #include <__bits/thread/threading.hpp>
 #include <mutex>
 
@@ -52,6 +53,17 @@ namespace std
         {
             return aux::threading::time::convert(abs_time - Clock::now());
         }
+
+        /**
+         * Condition variables count notifications, waiters park
+         * until the count changes after they unlocked the mutex.
+         */
+        inline auto cv_notified(const unsigned int& seq, unsigned int old)
+        {
+            return [&seq, old](){
+                return __atomic_load_n(&seq, __ATOMIC_RELAXED) != old;
+            };
+        }
     }
 
     /**
@@ -87,11 +99,15 @@ namespace std
             cv_status wait_until(unique_lock<mutex>& lock,
                                  const chrono::time_point<Clock, Duration>& abs_time)
             {
-                auto ret = aux::threading::condvar::wait_for(
-                    cv_, *lock.mutex()->native_handle(), aux::time_until(abs_time)
+                auto seq = __atomic_load_n(&seq_, __ATOMIC_RELAXED);
+
+                lock.mutex()->unlock();
+                auto notified = aux::atomic_wait_for(
+                    &seq_, aux::cv_notified(seq_, seq), aux::time_until(abs_time)
                 );
+                lock.mutex()->lock();
 
-                if (ret == EOK)
+                if (notified)
                     return cv_status::no_timeout;
                 else
                     return cv_status::timeout;
@@ -131,11 +147,11 @@ namespace std
                 );
             }
 
-            using native_handle_type = aux::condvar_t*;
+            using native_handle_type = unsigned int*;
             native_handle_type native_handle();
 
         private:
-            aux::condvar_t cv_;
+            unsigned int seq_;
     };
 
     /**
@@ -157,7 +173,11 @@ namespace std
             template<class Lock>
             void wait(Lock& lock)
             {
-                aux::threading::condvar::wait(cv_, *lock.native_handle());
+                auto seq = __atomic_load_n(&seq_, __ATOMIC_RELAXED);
+
+                lock.unlock();
+                aux::atomic_wait(&seq_, aux::cv_notified(seq_, seq));
+                lock.lock();
             }
 
             template<class Lock, class Predicate>
@@ -171,11 +191,15 @@ namespace std
             cv_status wait_until(Lock& lock,
                                  const chrono::time_point<Clock, Duration>& abs_time)
             {
-                auto ret = aux::threading::condvar::wait_for(
-                    cv_, *lock.mutex()->native_handle(), aux::time_until(abs_time)
+                auto seq = __atomic_load_n(&seq_, __ATOMIC_RELAXED);
+
+                lock.unlock();
+                auto notified = aux::atomic_wait_for(
+                    &seq_, aux::cv_notified(seq_, seq), aux::time_until(abs_time)
                 );
+                lock.lock();
 
-                if (ret == EOK)
+                if (notified)
                     return cv_status::no_timeout;
                 else
                     return cv_status::timeout;
@@ -215,11 +239,11 @@ namespace std
                 );
             }
 
-            using native_handle_type = aux::condvar_t*;
+            using native_handle_type = unsigned int*;
             native_handle_type native_handle();
 
         private:
-            aux::condvar_t cv_;
+            unsigned int seq_;
     };
 
     void notify_all_at_thread_exit(condition_variable&, unique_lock<mutex>&);
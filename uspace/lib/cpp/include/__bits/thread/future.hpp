@@ -29,10 +29,17 @@
 #ifndef LIBCPP_BITS_THREAD_FUTURE
 #define LIBCPP_BITS_THREAD_FUTURE
 
+#include <__bits/thread/thread_pool.hpp>
+#include <__bits/thread/threading.hpp>
+#include <__bits/trycatch.hpp>
 #include <cassert>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <system_error>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace std
 {
@@ -50,10 +57,53 @@ namespace std
 
     enum class launch
     {
-        async,
-        deferred
+        async    = 0b01,
+        deferred = 0b10
     };
 
+    constexpr launch operator&(launch lhs, launch rhs)
+    {
+        return static_cast<launch>(
+            static_cast<int>(lhs) & static_cast<int>(rhs)
+        );
+    }
+
+    constexpr launch operator|(launch lhs, launch rhs)
+    {
+        return static_cast<launch>(
+            static_cast<int>(lhs) | static_cast<int>(rhs)
+        );
+    }
+
+    constexpr launch operator^(launch lhs, launch rhs)
+    {
+        return static_cast<launch>(
+            static_cast<int>(lhs) ^ static_cast<int>(rhs)
+        );
+    }
+
+    constexpr launch operator~(launch lhs)
+    {
+        return static_cast<launch>(
+            ~static_cast<int>(lhs) & 0b11
+        );
+    }
+
+    inline launch& operator&=(launch& lhs, launch rhs)
+    {
+        return lhs = lhs & rhs;
+    }
+
+    inline launch& operator|=(launch& lhs, launch rhs)
+    {
+        return lhs = lhs | rhs;
+    }
+
+    inline launch& operator^=(launch& lhs, launch rhs)
+    {
+        return lhs = lhs ^ rhs;
+    }
+
     enum class future_status
     {
         ready,
@@ -93,59 +143,670 @@ namespace std
      * 30.6.4, shared state:
      */
 
+    namespace aux
+    {
+        /**
+         * Note: The shared state is reference counted between
+         *       its provider (a promise or an async call) and
+         *       the future. Since we do not support exceptions,
+         *       errors are reported through the mock throw only,
+         *       a broken promise is still marked ready so that
+         *       its waiters are not blocked forever.
+         */
+        class future_state_base
+        {
+            public:
+                future_state_base()
+                    : refs_{1}, ready_{false}, broken_{false},
+                      retrieved_{false}, deferred_{false},
+                      blocking_{false}
+                {
+                    threading::mutex::init(mtx_);
+                    threading::condvar::init(cv_);
+                }
+
+                future_state_base(const future_state_base&) = delete;
+                future_state_base& operator=(const future_state_base&) = delete;
+
+                virtual ~future_state_base() = default;
+
+                void add_ref() noexcept
+                {
+                    __atomic_add_fetch(&refs_, 1, __ATOMIC_RELAXED);
+                }
+
+                void release() noexcept
+                {
+                    if (__atomic_sub_fetch(&refs_, 1, __ATOMIC_ACQ_REL) == 0)
+                        delete this;
+                }
+
+                bool is_ready() const noexcept
+                {
+                    return __atomic_load_n(&ready_, __ATOMIC_ACQUIRE);
+                }
+
+                /**
+                 * True if the future has to wait for the result
+                 * when it is destroyed (i.e. it was obtained
+                 * from std::async).
+                 */
+                bool blocking() const noexcept
+                {
+                    return blocking_;
+                }
+
+                bool mark_retrieved() noexcept
+                {
+                    return !__atomic_exchange_n(&retrieved_, true, __ATOMIC_RELAXED);
+                }
+
+                void abandon()
+                {
+                    if (!is_ready())
+                    {
+                        broken_ = true;
+                        mark_ready_();
+                    }
+                }
+
+                void wait()
+                {
+                    if (deferred_)
+                    {
+                        deferred_ = false;
+                        run_deferred_();
+
+                        return;
+                    }
+
+                    while (!is_ready() && help_())
+                    { /* DUMMY BODY */ }
+
+                    threading::mutex::lock(mtx_);
+                    while (!is_ready())
+                        threading::condvar::wait(cv_, mtx_);
+                    threading::mutex::unlock(mtx_);
+                }
+
+                template<class Rep, class Period>
+                future_status wait_for(const chrono::duration<Rep, Period>& rel_time)
+                {
+                    if (deferred_)
+                        return future_status::deferred;
+
+                    threading::mutex::lock(mtx_);
+                    if (!is_ready())
+                    {
+                        threading::condvar::wait_for(
+                            cv_, mtx_, threading::time::convert(rel_time)
+                        );
+                    }
+                    threading::mutex::unlock(mtx_);
+
+                    return is_ready() ? future_status::ready : future_status::timeout;
+                }
+
+            protected:
+                /**
+                 * Returns false if the provider cannot be satisfied.
+                 */
+                bool check_satisfiable_()
+                {
+                    if (is_ready())
+                    {
+                        throw future_error{make_error_code(future_errc::promise_already_satisfied)};
+
+                        return false;
+                    }
+
+                    return true;
+                }
+
+                void check_broken_()
+                {
+                    if (broken_)
+                    {
+                        throw future_error{make_error_code(future_errc::broken_promise)};
+                    }
+                }
+
+                void mark_ready_()
+                {
+                    threading::mutex::lock(mtx_);
+                    __atomic_store_n(&ready_, true, __ATOMIC_RELEASE);
+                    threading::mutex::unlock(mtx_);
+
+                    threading::condvar::broadcast(cv_);
+                }
+
+                /**
+                 * Executes a piece of outstanding work while the result
+                 * is not ready, returns false if there was none.
+                 */
+                virtual bool help_()
+                {
+                    return false;
+                }
+
+                virtual void run_deferred_()
+                { /* DUMMY BODY */ }
+
+                mutex_t mtx_;
+                condvar_t cv_;
+
+                size_t refs_;
+                bool ready_;
+                bool broken_;
+                bool retrieved_;
+                bool deferred_;
+                bool blocking_;
+        };
+
+        template<class R>
+        class future_state: public future_state_base
+        {
+            public:
+                ~future_state() override
+                {
+                    if (is_ready() && !broken_)
+                        value_()->~R();
+                }
+
+                template<class T>
+                void set_value(T&& val)
+                {
+                    if (!check_satisfiable_())
+                        return;
+
+                    ::new(&storage_) R(forward<T>(val));
+                    mark_ready_();
+                }
+
+                R& get()
+                {
+                    wait();
+                    check_broken_();
+
+                    return *value_();
+                }
+
+            private:
+                aligned_storage_t<sizeof(R), alignof(R)> storage_;
+
+                R* value_()
+                {
+                    return static_cast<R*>(static_cast<void*>(&storage_));
+                }
+        };
+
+        template<class R>
+        class future_state<R&>: public future_state_base
+        {
+            public:
+                void set_value(R& val)
+                {
+                    if (!check_satisfiable_())
+                        return;
+
+                    value_ = addressof(val);
+                    mark_ready_();
+                }
+
+                R& get()
+                {
+                    wait();
+                    check_broken_();
+
+                    return *value_;
+                }
+
+            private:
+                R* value_{};
+        };
+
+        template<>
+        class future_state<void>: public future_state_base
+        {
+            public:
+                void set_value()
+                {
+                    if (!check_satisfiable_())
+                        return;
+
+                    mark_ready_();
+                }
+
+                void get()
+                {
+                    wait();
+                    check_broken_();
+                }
+        };
+
+        /**
+         * Shared state of std::async, the call is either
+         * submitted to the thread pool or deferred until
+         * the result is requested.
+         */
+        template<class R, class F, class... Args>
+        class async_state: public future_state<R>
+        {
+            public:
+                template<class G, class... As>
+                explicit async_state(G&& g, As&&... as)
+                    : future_state<R>{}, func_{forward<G>(g)},
+                      args_{forward<As>(as)...}
+                { /* DUMMY BODY */ }
+
+                void start()
+                {
+                    this->blocking_ = true;
+                    this->add_ref();
+
+                    thread_pool::instance().submit([this](){
+                        call_(make_index_sequence<sizeof...(Args)>{});
+                        this->release();
+                    });
+                }
+
+                void defer()
+                {
+                    this->deferred_ = true;
+                }
+
+            private:
+                using args_type = tuple_impl<
+                    make_index_sequence<sizeof...(Args)>, Args...
+                >;
+
+                /**
+                 * Note: The tuple_impl base is used directly as the
+                 *       tuple converting constructor does not accept
+                 *       move only types.
+                 */
+                F func_;
+                args_type args_;
+
+                template<size_t I>
+                auto&& arg_()
+                {
+                    using wrapper_type = tuple_element_wrapper<I, type_at_t<I, Args...>>;
+
+                    return move(static_cast<wrapper_type&>(args_).value);
+                }
+
+                template<size_t... Is>
+                void call_(index_sequence<Is...>)
+                {
+                    if constexpr (is_void_v<R>)
+                    {
+                        invoke(move(func_), arg_<Is>()...);
+                        this->set_value();
+                    }
+                    else
+                        this->set_value(invoke(move(func_), arg_<Is>()...));
+                }
+
+                bool help_() override
+                {
+                    return thread_pool::instance().run_pending();
+                }
+
+                void run_deferred_() override
+                {
+                    call_(make_index_sequence<sizeof...(Args)>{});
+                }
+        };
+
+        struct future_access;
+
+        template<class R>
+        class future_base
+        {
+            public:
+                future_base() noexcept
+                    : state_{}
+                { /* DUMMY BODY */ }
+
+                future_base(const future_base&) = delete;
+
+                future_base(future_base&& other) noexcept
+                    : state_{other.state_}
+                {
+                    other.state_ = nullptr;
+                }
+
+                ~future_base()
+                {
+                    release_();
+                }
+
+                future_base& operator=(const future_base&) = delete;
+
+                future_base& operator=(future_base&& rhs) noexcept
+                {
+                    if (this != &rhs)
+                    {
+                        release_();
+                        state_ = rhs.state_;
+                        rhs.state_ = nullptr;
+                    }
+
+                    return *this;
+                }
+
+                bool valid() const noexcept
+                {
+                    return state_ != nullptr;
+                }
+
+                void wait() const
+                {
+                    assert(state_);
+
+                    state_->wait();
+                }
+
+                template<class Rep, class Period>
+                future_status wait_for(const chrono::duration<Rep, Period>& rel_time) const
+                {
+                    assert(state_);
+
+                    return state_->wait_for(rel_time);
+                }
+
+                template<class Clock, class Duration>
+                future_status wait_until(
+                    const chrono::time_point<Clock, Duration>& abs_time
+                ) const
+                {
+                    return wait_for(abs_time - Clock::now());
+                }
+
+            protected:
+                future_state<R>* state_;
+
+                explicit future_base(future_state<R>* state)
+                    : state_{state}
+                { /* DUMMY BODY */ }
+
+                void release_()
+                {
+                    if (state_)
+                    {
+                        if (state_->blocking())
+                            state_->wait();
+
+                        state_->release();
+                        state_ = nullptr;
+                    }
+                }
+        };
+    }
+
     template<class R>
-    class promise
+    class future: public aux::future_base<R>
     {
+        public:
+            future() noexcept = default;
+
+            future(future&&) noexcept = default;
+
+            future& operator=(future&&) noexcept = default;
+
+            // TODO: shared_future<R> share();
+
+            R get()
+            {
+                assert(this->state_);
+
+                R res{move(this->state_->get())};
+                this->release_();
+
+                return res;
+            }
+
+        private:
+            explicit future(aux::future_state<R>* state)
+                : aux::future_base<R>{state}
+            { /* DUMMY BODY */ }
+
+            friend struct aux::future_access;
     };
 
     template<class R>
-    class promise<R&>
+    class future<R&>: public aux::future_base<R&>
     {
+        public:
+            future() noexcept = default;
+
+            future(future&&) noexcept = default;
+
+            future& operator=(future&&) noexcept = default;
+
+            // TODO: shared_future<R&> share();
+
+            R& get()
+            {
+                assert(this->state_);
+
+                R& res = this->state_->get();
+                this->release_();
+
+                return res;
+            }
+
+        private:
+            explicit future(aux::future_state<R&>* state)
+                : aux::future_base<R&>{state}
+            { /* DUMMY BODY */ }
+
+            friend struct aux::future_access;
     };
 
     template<>
-    class promise<void>
+    class future<void>: public aux::future_base<void>
     {
+        public:
+            future() noexcept = default;
+
+            future(future&&) noexcept = default;
+
+            future& operator=(future&&) noexcept = default;
+
+            // TODO: shared_future<void> share();
+
+            void get()
+            {
+                assert(this->state_);
+
+                this->state_->get();
+                this->release_();
+            }
+
+        private:
+            explicit future(aux::future_state<void>* state)
+                : aux::future_base<void>{state}
+            { /* DUMMY BODY */ }
+
+            friend struct aux::future_access;
     };
 
-    template<class R>
-    void swap(promise<R>& lhs, promise<R>& rhs) noexcept
+    namespace aux
     {
-        lhs.swap(rhs);
+        struct future_access
+        {
+            template<class R>
+            static future<R> make(future_state<R>* state)
+            {
+                return future<R>{state};
+            }
+        };
+
+        template<class R>
+        class promise_base
+        {
+            public:
+                promise_base()
+                    : state_{new future_state<R>{}}
+                { /* DUMMY BODY */ }
+
+                // TODO: allocator-extended constructor
+
+                promise_base(promise_base&& other) noexcept
+                    : state_{other.state_}
+                {
+                    other.state_ = nullptr;
+                }
+
+                promise_base(const promise_base&) = delete;
+
+                ~promise_base()
+                {
+                    abandon_();
+                }
+
+                promise_base& operator=(promise_base&& rhs) noexcept
+                {
+                    if (this != &rhs)
+                    {
+                        abandon_();
+                        state_ = rhs.state_;
+                        rhs.state_ = nullptr;
+                    }
+
+                    return *this;
+                }
+
+                promise_base& operator=(const promise_base&) = delete;
+
+                void swap(promise_base& other) noexcept
+                {
+                    std::swap(state_, other.state_);
+                }
+
+                future<R> get_future()
+                {
+                    assert(state_);
+
+                    if (!state_->mark_retrieved())
+                    {
+                        throw future_error{make_error_code(future_errc::future_already_retrieved)};
+
+                        return future<R>{};
+                    }
+
+                    state_->add_ref();
+
+                    return future_access::make(state_);
+                }
+
+                // TODO: set_exception, set_value_at_thread_exit,
+                //       set_exception_at_thread_exit
+
+            protected:
+                future_state<R>* state_;
+
+                void abandon_()
+                {
+                    if (state_)
+                    {
+                        state_->abandon();
+                        state_->release();
+                        state_ = nullptr;
+                    }
+                }
+        };
     }
 
-    template<class R, class Alloc>
-    struct uses_allocator<promise<R>, Alloc>: true_type
-    { /* DUMMY BODY */ };
-
     template<class R>
-    class future
+    class promise: public aux::promise_base<R>
     {
+        public:
+            promise() = default;
+
+            promise(promise&&) noexcept = default;
+
+            promise& operator=(promise&&) noexcept = default;
+
+            void set_value(const R& val)
+            {
+                assert(this->state_);
+
+                this->state_->set_value(val);
+            }
+
+            void set_value(R&& val)
+            {
+                assert(this->state_);
+
+                this->state_->set_value(move(val));
+            }
     };
 
     template<class R>
-    class future<R&>
+    class promise<R&>: public aux::promise_base<R&>
     {
+        public:
+            promise() = default;
+
+            promise(promise&&) noexcept = default;
+
+            promise& operator=(promise&&) noexcept = default;
+
+            void set_value(R& val)
+            {
+                assert(this->state_);
+
+                this->state_->set_value(val);
+            }
     };
 
     template<>
-    class future<void>
+    class promise<void>: public aux::promise_base<void>
     {
+        public:
+            promise() = default;
+
+            promise(promise&&) noexcept = default;
+
+            promise& operator=(promise&&) noexcept = default;
+
+            void set_value()
+            {
+                assert(this->state_);
+
+                this->state_->set_value();
+            }
     };
 
+    template<class R>
+    void swap(promise<R>& lhs, promise<R>& rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+    template<class R, class Alloc>
+    struct uses_allocator<promise<R>, Alloc>: true_type
+    { /* DUMMY BODY */ };
+
     template<class R>
     class shared_future
     {
+        // TODO: implement
     };
 
     template<class R>
     class shared_future<R&>
     {
+        // TODO: implement
     };
 
     template<>
     class shared_future<void>
     {
+        // TODO: implement
     };
 
     template<class>
@@ -154,6 +815,7 @@ namespace std
     template<class R, class... Args>
     class packaged_task<R(Args...)>
     {
+        // TODO: implement
     };
 
     template<class R, class... Args>
@@ -166,20 +828,56 @@ namespace std
     struct uses_allocator<packaged_task<R>, Alloc>: true_type
     { /* DUMMY BODY */ };
 
+    /**
+     * 30.6.8, function template async:
+     * Note: Asynchronous calls are executed by the shared
+     *       thread pool (see aux::thread_pool) instead of
+     *       a new thread each.
+     */
+
     template<class F, class... Args>
     future<result_of_t<decay_t<F>(decay_t<Args>...)>>
-    async(F&& f, Args&&... args)
+    async(launch policy, F&& f, Args&&... args)
     {
-        // TODO: implement
-        __unimplemented();
+        using result_type = result_of_t<decay_t<F>(decay_t<Args>...)>;
+
+        auto state = new aux::async_state<
+            result_type, decay_t<F>, decay_t<Args>...
+        >{forward<F>(f), forward<Args>(args)...};
+
+        if ((policy & launch::async) == launch::async)
+            state->start();
+        else
+            state->defer();
+
+        return aux::future_access::make<result_type>(state);
+    }
+
+    namespace aux
+    {
+        /**
+         * The launch policy-less overload of async must not
+         * be considered when the first argument is a policy.
+         */
+        template<class F, class... Args>
+        struct async_result
+        {
+            using type = result_of_t<F(Args...)>;
+        };
+
+        template<class... Args>
+        struct async_result<launch, Args...>
+        { /* DUMMY BODY */ };
     }
 
     template<class F, class... Args>
-    future<result_of_t<decay_t<F>(decay_t<Args>...)>>
-    async(launch, F&& f, Args&&... args)
+    future<typename aux::async_result<decay_t<F>, decay_t<Args>...>::type>
+    async(F&& f, Args&&... args)
     {
-        // TODO: implement
-        __unimplemented();
+        return async(
+            launch::async | launch::deferred,
+            forward<F>(f), forward<Args>(args)...
+        );
     }
 }
 
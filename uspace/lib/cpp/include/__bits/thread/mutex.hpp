@@ -37,31 +37,55 @@ namespace std
 {
     /**
      * 20.4.1.2.1, class mutex:
+     *
+     * The lock word is 0 when unlocked, 1 when locked and 2 when
+     * locked with possible waiters. Uncontended locking is a single
+     * atomic operation, only waiting and waking up waiters goes
+     * through the fibril synchronization.
      */
 
     class mutex
     {
         public:
             constexpr mutex() noexcept
-                : mtx_{}
-            {
-                aux::threading::mutex::init(mtx_);
-            }
+                : state_{}
+            { /* DUMMY BODY */ }
 
             ~mutex() = default;
 
             mutex(const mutex&) = delete;
             mutex& operator=(const mutex&) = delete;
 
-            void lock();
-            bool try_lock();
-            void unlock();
+            void lock()
+            {
+                int expected{};
+                if (!__atomic_compare_exchange_n(&state_, &expected, 1, false,
+                                                 __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                    lock_contended_();
+            }
 
-            using native_handle_type = aux::mutex_t*;
+            bool try_lock()
+            {
+                int expected{};
+
+                return __atomic_compare_exchange_n(&state_, &expected, 1, false,
+                                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+            }
+
+            void unlock()
+            {
+                if (__atomic_exchange_n(&state_, 0, __ATOMIC_RELEASE) == 2)
+                    unlock_contended_();
+            }
+
+            using native_handle_type = int*;
             native_handle_type native_handle();
 
         private:
-            aux::mutex_t mtx_;
+            int state_;
+
+            void lock_contended_();
+            void unlock_contended_();
     };
 
     /**
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_THREAD_THREAD_POOL
+#define LIBCPP_BITS_THREAD_THREAD_POOL
+
+#include <__bits/thread/threading.hpp>
+#include <cstdlib>
+#include <deque>
+#include <type_traits>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * Type erased unit of work executed by the thread pool.
+     */
+    class pool_task
+    {
+        public:
+            virtual void execute() = 0;
+
+            virtual ~pool_task() = default;
+    };
+
+    template<class Function>
+    class pool_task_impl: public pool_task
+    {
+        public:
+            template<class F>
+            explicit pool_task_impl(F&& f)
+                : func_{forward<F>(f)}
+            { /* DUMMY BODY */ }
+
+            void execute() override
+            {
+                func_();
+            }
+
+        private:
+            Function func_;
+    };
+
+    /**
+     * Process wide pool of worker fibrils shared by std::async
+     * and the parallel algorithms. There is one worker per active
+     * CPU and the pool spawns enough fibril runners for all of them
+     * to run at the same time.
+     *
+     * Every worker owns a deque of tasks, tasks submitted by a worker
+     * go to its own deque and are taken from the back (so that forked
+     * subtasks run while their data are still in the cache), idle
+     * workers steal from the front of the other deques. Tasks submitted
+     * from outside of the pool are distributed round robin.
+     *
+     * Fibrils waiting for a result should call run_pending() instead
+     * of blocking, so that nested parallelism cannot exhaust the
+     * workers.
+     */
+    class thread_pool
+    {
+        public:
+            static thread_pool& instance();
+
+            template<class Function>
+            void submit(Function&& func)
+            {
+                push(new pool_task_impl<decay_t<Function>>{forward<Function>(func)});
+            }
+
+            /**
+             * Takes the ownership of the task.
+             */
+            void push(pool_task* task);
+
+            /**
+             * Executes one pending task on the calling fibril,
+             * returns false if there was none.
+             */
+            bool run_pending();
+
+            size_t size() const noexcept
+            {
+                return size_;
+            }
+
+        private:
+            struct worker
+            {
+                thread_pool* pool;
+                size_t index;
+                mutex_t mtx;
+                deque<pool_task*> tasks;
+            };
+
+            thread_pool();
+
+            /**
+             * The pool is never destroyed, workers can still
+             * be running when static destructors are executed.
+             */
+            ~thread_pool() = delete;
+
+            pool_task* take_();
+            void sleep_();
+
+            static int worker_main_(void*);
+
+            worker* workers_;
+            size_t size_;
+            size_t next_;
+            size_t pending_;
+            size_t idle_;
+
+            mutex_t idle_mtx_;
+            condvar_t idle_cv_;
+    };
+
+    /**
+     * Fork-join helper, tasks started by run() are executed
+     * by the thread pool and wait() returns once all of them
+     * finished. The waiting fibril executes pending tasks
+     * in the meantime.
+     */
+    class task_group
+    {
+        public:
+            task_group()
+                : pending_{}
+            { /* DUMMY BODY */ }
+
+            task_group(const task_group&) = delete;
+            task_group& operator=(const task_group&) = delete;
+
+            ~task_group()
+            {
+                wait();
+            }
+
+            template<class Function>
+            void run(Function&& func)
+            {
+                __atomic_add_fetch(&pending_, 1, __ATOMIC_RELAXED);
+                thread_pool::instance().submit(
+                    [this, f = forward<Function>(func)]() mutable {
+                        f();
+                        __atomic_sub_fetch(&pending_, 1, __ATOMIC_RELEASE);
+                    }
+                );
+            }
+
+            void wait();
+
+        private:
+            size_t pending_;
+    };
+}
+
+#endif
@@ -734,12 +734,25 @@ namespace std
     template<class T>
     inline constexpr bool is_trivially_destructible_v = is_trivially_destructible<T>::value;
 
+    namespace aux
+    {
+        template<bool, class T, class... Args>
+        struct is_nothrow_constructible: false_type
+        { /* DUMMY BODY */ };
+
+        template<class T, class... Args>
+        struct is_nothrow_constructible<true, T, Args...>
+            : value_is<bool, noexcept(T(declval<Args>()...))>
+        { /* DUMMY BODY */ };
+    }
+
     template<class T, class... Args>
-    struct is_nothrow_constructible: aux::value_is<bool, __has_nothrow_constructor(T)>
+    struct is_nothrow_constructible
+        : aux::is_nothrow_constructible<is_constructible<T, Args...>::value, T, Args...>
     { /* DUMMY BODY */ };
 
-    template<class T>
-    inline constexpr bool is_nothrow_constructible_v = is_nothrow_constructible<T>::value;
+    template<class T, class... Args>
+    inline constexpr bool is_nothrow_constructible_v = is_nothrow_constructible<T, Args...>::value;
 
     template<class T>
     struct is_nothrow_default_constructible
@@ -755,7 +768,7 @@ namespace std
 
     template<class T>
     struct is_nothrow_move_constructible
-        : is_nothrow_constructible<add_lvalue_reference_t<T>, add_rvalue_reference_t<T>>
+        : is_nothrow_constructible<T, add_rvalue_reference_t<T>>
     { /* DUMMY BODY */ };
 
     template<class T, class U>
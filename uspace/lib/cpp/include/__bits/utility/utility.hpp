@@ -103,6 +103,19 @@ namespace std
         return old_val;
     }
 
+    /**
+     * 20.2.4, forward/move helpers:
+     */
+
+    template<class T>
+    constexpr conditional_t<
+        !is_nothrow_move_constructible<T>::value && is_copy_constructible<T>::value,
+        const T&, T&&
+    > move_if_noexcept(T& x) noexcept
+    {
+        return move(x);
+    }
+
     /**
      * 20.5.2, class template integer_sequence:
      */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/thread/atomic_wait.hpp>
+#include <cstdint>
+
+namespace std::aux
+{
+    namespace
+    {
+        constexpr size_t atomic_wait_slot_count{64};
+
+        /**
+         * The slots cannot be initialized by a constructor,
+         * because mutexes may be contended before all static
+         * constructors run, the first wait initializes them.
+         */
+        atomic_wait_slot atomic_wait_slots[atomic_wait_slot_count]{};
+
+        enum : int
+        {
+            slots_uninitialized,
+            slots_initializing,
+            slots_ready
+        };
+
+        int atomic_wait_slots_state{slots_uninitialized};
+
+        void atomic_wait_slots_init() noexcept
+        {
+            int state{slots_uninitialized};
+            if (__atomic_compare_exchange_n(&atomic_wait_slots_state, &state,
+                                            slots_initializing, false,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+            {
+                for (auto& slot: atomic_wait_slots)
+                {
+                    threading::mutex::init(slot.mtx);
+                    threading::condvar::init(slot.cv);
+                }
+
+                __atomic_store_n(&atomic_wait_slots_state, slots_ready,
+                                 __ATOMIC_RELEASE);
+                return;
+            }
+
+            while (__atomic_load_n(&atomic_wait_slots_state,
+                                   __ATOMIC_ACQUIRE) != slots_ready)
+                threading::thread::yield();
+        }
+
+        atomic_wait_slot& atomic_wait_slot_get(const volatile void* addr) noexcept
+        {
+            auto key = reinterpret_cast<uintptr_t>(addr);
+
+            return atomic_wait_slots[(key >> 2) % atomic_wait_slot_count];
+        }
+    }
+
+    atomic_wait_slot& atomic_wait_slot_for(const volatile void* addr) noexcept
+    {
+        if (__atomic_load_n(&atomic_wait_slots_state,
+                            __ATOMIC_ACQUIRE) != slots_ready)
+            atomic_wait_slots_init();
+
+        return atomic_wait_slot_get(addr);
+    }
+
+    void atomic_notify(const volatile void* addr) noexcept
+    {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        /**
+         * Slots only get waiters after they are initialized and
+         * the acquire load makes the initialization visible.
+         */
+        auto& slot = atomic_wait_slot_get(addr);
+        if (__atomic_load_n(&slot.waiters, __ATOMIC_ACQUIRE) == 0)
+            return;
+
+        threading::mutex::lock(slot.mtx);
+        threading::condvar::broadcast(slot.cv);
+        threading::mutex::unlock(slot.mtx);
+    }
+}
@@ -128,7 +128,18 @@ namespace __cxxabiv1
     {
         static_guard_mtx.lock();
 
-        return !*((std::uint8_t*)guard);
+        /**
+         * Another thread might have finished the initialization
+         * while we were waiting, in which case no release follows.
+         */
+        if (*((std::uint8_t*)guard))
+        {
+            static_guard_mtx.unlock();
+
+            return 0;
+        }
+
+        return 1;
     }
 
     extern "C" void __cxa_guard_release(guard_t* guard)
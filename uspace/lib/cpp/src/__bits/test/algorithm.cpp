@@ -31,6 +31,7 @@
 #include <array>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace std::test
 {
@@ -41,6 +42,7 @@ namespace std::test
 
         test_non_modifying();
         test_mutating();
+        test_sorting();
 
         return end();
     }
@@ -293,4 +295,100 @@ namespace std::test
         );
         test_eq("transform pt2", res6, data10.end());
     }
+
+    void algorithm_test::test_sorting()
+    {
+        std::vector<int> data1{};
+        unsigned int seed{42};
+        for (int i = 0; i < 500; ++i)
+        {
+            seed = seed * 1103515245U + 12345U;
+            data1.push_back(static_cast<int>((seed >> 16) % 100));
+        }
+
+        auto sorted = [](const auto& vec, std::size_t count) {
+            for (std::size_t i = 1; i < count; ++i)
+            {
+                if (vec[i] < vec[i - 1])
+                    return false;
+            }
+            return true;
+        };
+
+        auto data2 = data1;
+        std::sort(data2.begin(), data2.end());
+        test("sort pt1", sorted(data2, data2.size()));
+
+        std::sort(data2.begin(), data2.end(), [](auto x, auto y){ return x > y; });
+        test("sort pt2", data2.front() >= data2[250] && data2[250] >= data2.back());
+
+        auto check1 = {1, 2, 3, 4, 5};
+        std::array<int, 5> data3{5, 4, 3, 2, 1};
+        std::sort(data3.begin(), data3.end());
+        test_eq(
+            "sort pt3", check1.begin(), check1.end(),
+            data3.begin(), data3.end()
+        );
+
+        std::vector<std::pair<int, int>> data4{};
+        for (int i = 0; i < 500; ++i)
+            data4.emplace_back(data1[i] % 10, i);
+
+        std::stable_sort(
+            data4.begin(), data4.end(),
+            [](const auto& x, const auto& y){ return x.first < y.first; }
+        );
+
+        bool stable{true};
+        for (std::size_t i = 1; i < data4.size(); ++i)
+        {
+            if (data4[i].first < data4[i - 1].first ||
+                (data4[i].first == data4[i - 1].first &&
+                 data4[i].second < data4[i - 1].second))
+                stable = false;
+        }
+        test("stable_sort", stable);
+
+        auto data5 = data1;
+        std::partial_sort(data5.begin(), data5.begin() + 10, data5.end());
+        std::sort(data2.begin(), data2.end());
+        test_eq(
+            "partial_sort pt1", data2.begin(), data2.begin() + 10,
+            data5.begin(), data5.begin() + 10
+        );
+
+        data5 = data1;
+        std::partial_sort(data5.begin(), data5.begin() + 300, data5.end());
+        test_eq(
+            "partial_sort pt2", data2.begin(), data2.begin() + 300,
+            data5.begin(), data5.begin() + 300
+        );
+
+        data5 = data1;
+        std::nth_element(data5.begin(), data5.begin() + 123, data5.end());
+        test_eq("nth_element pt1", data5[123], data2[123]);
+
+        bool partitioned{true};
+        for (std::size_t i = 0; i < data5.size(); ++i)
+        {
+            if ((i < 123 && data5[i] > data5[123]) ||
+                (i > 123 && data5[i] < data5[123]))
+                partitioned = false;
+        }
+        test("nth_element pt2", partitioned);
+
+        auto res1 = std::lower_bound(data2.begin(), data2.end(), 50);
+        auto res2 = std::upper_bound(data2.begin(), data2.end(), 50);
+        test("lower_bound", *res1 >= 50 && *(res1 - 1) < 50);
+        test("upper_bound", *res2 > 50 && *(res2 - 1) <= 50);
+
+        auto check2 = {3, 4, 5, 1, 2};
+        std::array<int, 5> data6{1, 2, 3, 4, 5};
+        auto res3 = std::rotate(data6.begin(), data6.begin() + 2, data6.end());
+        test_eq(
+            "rotate pt1", check2.begin(), check2.end(),
+            data6.begin(), data6.end()
+        );
+        test_eq("rotate pt2", res3, data6.begin() + 3);
+    }
 }
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace std::test
+{
+    bool atomic_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_operations();
+        test_wait();
+        test_mutex();
+        test_condition_variable();
+
+        return end();
+    }
+
+    const char* atomic_test::name()
+    {
+        return "atomic";
+    }
+
+    void atomic_test::test_operations()
+    {
+        std::atomic<int> a{5};
+        test_eq("load", a.load(), 5);
+        test_eq("exchange", a.exchange(7), 5);
+        test_eq("fetch_add", a.fetch_add(3), 7);
+        test_eq("fetch_sub", a.fetch_sub(2), 10);
+        test_eq("pre increment", ++a, 9);
+        test_eq("post decrement", a--, 9);
+        test_eq("fetch_or", a.fetch_or(0x10), 8);
+        test_eq("fetch_and", a.fetch_and(0x18), 0x18);
+        test_eq("fetch_xor", a.fetch_xor(0x08), 0x18);
+        test_eq("after bitwise operations", a.load(), 0x10);
+
+        int expected{3};
+        test("compare_exchange failure", !a.compare_exchange_strong(expected, 4));
+        test_eq("compare_exchange failure expected", expected, 0x10);
+        test("compare_exchange success", a.compare_exchange_strong(expected, 4));
+        test_eq("compare_exchange success value", a.load(), 4);
+
+        int arr[4]{};
+        std::atomic<int*> p{&arr[0]};
+        test_eq("pointer fetch_add", p.fetch_add(2), &arr[0]);
+        test_eq("pointer after fetch_add", p.load(), &arr[2]);
+        test_eq("pointer pre decrement", --p, &arr[1]);
+
+        std::atomic<bool> b{false};
+        test("bool exchange", !b.exchange(true));
+        test("bool load", b.load());
+
+        std::atomic_flag flag = ATOMIC_FLAG_INIT;
+        test("flag test_and_set", !flag.test_and_set());
+        test("flag already set", flag.test_and_set());
+        flag.clear();
+        test("flag clear", !flag.test());
+    }
+
+    void atomic_test::test_wait()
+    {
+        std::atomic<int> a{0};
+        std::atomic<int> done{0};
+
+        std::thread t{[&a, &done](){
+            for (int i = 0; i < 10; ++i)
+                std::this_thread::yield();
+
+            a.store(1);
+            a.notify_one();
+
+            done.wait(0);
+        }};
+
+        a.wait(0);
+        test_eq("wait returns after notify", a.load(), 1);
+
+        done.store(1);
+        done.notify_all();
+        t.join();
+
+        /**
+         * A value that is already different does not block.
+         */
+        a.wait(2);
+        test_eq("wait without notify", a.load(), 1);
+    }
+
+    void atomic_test::test_mutex()
+    {
+        constexpr int thread_count{4};
+        constexpr int iterations{100};
+
+        std::mutex mtx{};
+        int counter{};
+
+        std::vector<std::thread> threads{};
+        for (int i = 0; i < thread_count; ++i)
+        {
+            threads.emplace_back([&mtx, &counter](){
+                for (int j = 0; j < iterations; ++j)
+                {
+                    std::lock_guard<std::mutex> guard{mtx};
+
+                    int old = counter;
+                    std::this_thread::yield();
+                    counter = old + 1;
+                }
+            });
+        }
+
+        for (auto& t: threads)
+            t.join();
+
+        test_eq("contended mutex", counter, thread_count * iterations);
+        test("unlocked after contention", mtx.try_lock());
+        test("try_lock of locked mutex", !mtx.try_lock());
+        mtx.unlock();
+    }
+
+    void atomic_test::test_condition_variable()
+    {
+        std::mutex mtx{};
+        std::condition_variable cv{};
+        int turn{};
+
+        std::thread t{[&](){
+            for (int i = 0; i < 10; ++i)
+            {
+                std::unique_lock<std::mutex> lock{mtx};
+                cv.wait(lock, [&turn, i](){ return turn == 2 * i + 1; });
+                ++turn;
+                cv.notify_one();
+            }
+        }};
+
+        for (int i = 0; i < 10; ++i)
+        {
+            std::unique_lock<std::mutex> lock{mtx};
+            ++turn;
+            cv.notify_one();
+            cv.wait(lock, [&turn, i](){ return turn == 2 * i + 2; });
+        }
+
+        t.join();
+        test_eq("condition_variable ping pong", turn, 20);
+
+        std::unique_lock<std::mutex> lock{mtx};
+        auto res = cv.wait_for(lock, std::chrono::milliseconds{1});
+        test("condition_variable timeout", res == std::cv_status::timeout);
+    }
+}
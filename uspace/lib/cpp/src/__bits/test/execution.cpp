@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <algorithm>
+#include <execution>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace std::test
+{
+    bool execution_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_async();
+        test_promise();
+        test_algorithms();
+
+        return end();
+    }
+
+    const char* execution_test::name()
+    {
+        return "execution";
+    }
+
+    void execution_test::test_async()
+    {
+        auto f1 = std::async(std::launch::async, [](int x, int y){
+            return x * y;
+        }, 6, 7);
+        test("async valid", f1.valid());
+        test_eq("async get", f1.get(), 42);
+        test("async invalid after get", !f1.valid());
+
+        auto f2 = std::async(
+            std::launch::async,
+            [](std::unique_ptr<int> p){ return *p + 1; },
+            std::unique_ptr<int>{new int{1}}
+        );
+        test_eq("async move only argument", f2.get(), 2);
+
+        bool called{false};
+        auto f3 = std::async(std::launch::deferred, [&called](){
+            called = true;
+        });
+        test("deferred not called", !called);
+        test("deferred status",
+             f3.wait_for(std::chrono::milliseconds{1}) == std::future_status::deferred);
+        f3.get();
+        test("deferred called", called);
+
+        int val{};
+        auto f4 = std::async([](int& x) -> int& { return x; }, std::ref(val));
+        test("async reference", &f4.get() == &val);
+
+        auto f5 = std::async([](){ return std::string{"result"}; });
+        test_eq("async string", f5.get(), std::string{"result"});
+
+        /**
+         * Nested tasks that wait for each other must not
+         * exhaust the workers.
+         */
+        std::vector<std::future<int>> futures{};
+        for (int i = 0; i < 32; ++i)
+        {
+            futures.push_back(std::async(std::launch::async, [i](){
+                auto inner = std::async(std::launch::async, [i](){ return i; });
+
+                return inner.get() * 2;
+            }));
+        }
+
+        int sum{};
+        for (auto& f: futures)
+            sum += f.get();
+        test_eq("nested async", sum, 992);
+    }
+
+    void execution_test::test_promise()
+    {
+        std::promise<int> p1{};
+        auto f1 = p1.get_future();
+        test("promise not ready",
+             f1.wait_for(std::chrono::milliseconds{1}) == std::future_status::timeout);
+        p1.set_value(5);
+        test("promise ready",
+             f1.wait_for(std::chrono::milliseconds{1}) == std::future_status::ready);
+        test_eq("promise get", f1.get(), 5);
+
+        std::promise<void> p2{};
+        auto f2 = p2.get_future();
+        auto f3 = std::async(std::launch::async, [&f2](){
+            f2.wait();
+
+            return 1;
+        });
+        p2.set_value();
+        test_eq("promise void", f3.get(), 1);
+
+        int val{};
+        std::promise<int&> p3{};
+        auto f4 = p3.get_future();
+        p3.set_value(val);
+        test("promise reference", &f4.get() == &val);
+
+        std::promise<int> p4{};
+        auto p5 = std::move(p4);
+        auto f5 = p5.get_future();
+        p5.set_value(3);
+        test_eq("promise move", f5.get(), 3);
+
+        auto policy = std::launch::async | std::launch::deferred;
+        test("launch bitmask", (policy & std::launch::deferred) == std::launch::deferred);
+    }
+
+    void execution_test::test_algorithms()
+    {
+        test("policy trait", std::is_execution_policy_v<std::execution::parallel_policy>);
+        test("policy trait non policy", !std::is_execution_policy_v<int>);
+
+        constexpr size_t size{100000};
+        std::vector<int> data(size);
+        std::iota(data.begin(), data.end(), 0);
+
+        long long expected{};
+        for (auto x: data)
+            expected += x;
+
+        auto res1 = std::reduce(std::execution::par, data.begin(), data.end(), 0LL);
+        test_eq("reduce par", res1, expected);
+
+        auto res2 = std::reduce(std::execution::seq, data.begin(), data.end(), 0LL);
+        test_eq("reduce seq", res2, expected);
+
+        std::vector<long long> wide(data.begin(), data.end());
+        auto res3 = std::reduce(std::execution::par_unseq, wide.begin(), wide.end());
+        test_eq("reduce par_unseq", res3, expected);
+
+        auto res4 = std::reduce(
+            std::execution::par, data.begin(), data.begin() + 10, 1LL,
+            [](auto lhs, auto rhs){ return lhs + rhs; }
+        );
+        test_eq("reduce small", res4, 46LL);
+
+        auto res5 = std::reduce(data.begin(), data.begin() + 5);
+        test_eq("reduce sequential", res5, 10);
+
+        std::vector<int> out(size);
+        std::transform(std::execution::par, data.begin(), data.end(),
+                       out.begin(), [](int x){ return x * 2; });
+        bool ok{true};
+        for (size_t i = 0; i < size; ++i)
+            ok = ok && out[i] == static_cast<int>(i * 2);
+        test("transform par", ok);
+
+        std::transform(std::execution::par, data.begin(), data.end(),
+                       out.begin(), out.begin(), std::plus<int>{});
+        ok = true;
+        for (size_t i = 0; i < size; ++i)
+            ok = ok && out[i] == static_cast<int>(i * 3);
+        test("transform binary par", ok);
+
+        std::vector<int> copied(size);
+        auto it = std::copy(std::execution::par, data.begin(), data.end(), copied.begin());
+        test("copy par end", it == copied.end());
+        test("copy par", copied == data);
+
+        std::for_each(std::execution::par, copied.begin(), copied.end(),
+                      [](int& x){ ++x; });
+        ok = true;
+        for (size_t i = 0; i < size; ++i)
+            ok = ok && copied[i] == static_cast<int>(i + 1);
+        test("for_each par", ok);
+
+        std::list<int> lst{3, 1, 2};
+        std::for_each(std::execution::par, lst.begin(), lst.end(),
+                      [](int& x){ x *= 10; });
+        test_eq("for_each non random access", lst.front(), 30);
+
+        std::vector<unsigned> unsorted(size);
+        unsigned seed{12345};
+        for (auto& x: unsorted)
+        {
+            seed = seed * 1103515245U + 12345U;
+            x = (seed >> 8) % 1000;
+        }
+
+        auto sorted = unsorted;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto sorted_par = unsorted;
+        std::sort(std::execution::par, sorted_par.begin(), sorted_par.end());
+        test("sort par", sorted_par == sorted);
+
+        std::sort(std::execution::par, sorted_par.begin(), sorted_par.end(),
+                  std::greater<unsigned>{});
+        test("sort par comp", std::is_sorted(sorted_par.begin(), sorted_par.end(),
+                                             std::greater<unsigned>{}));
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <helenos/flat_hash_map>
+#include <string>
+#include <utility>
+
+namespace std::test
+{
+    bool flat_hash_map_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_map();
+        test_set();
+
+        return end();
+    }
+
+    const char* flat_hash_map_test::name()
+    {
+        return "flat_hash_map";
+    }
+
+    void flat_hash_map_test::test_map()
+    {
+        helenos::flat_hash_map<int, int> map1{};
+        for (int i = 0; i < 1000; ++i)
+            map1[i] = 2 * i;
+        test_eq("size after growth", map1.size(), 1000ul);
+
+        bool ok{true};
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto it = map1.find(i);
+            ok = ok && it != map1.end() && it->second == 2 * i;
+        }
+        test("find after growth", ok);
+        test("find missing", map1.find(1000) == map1.end());
+
+        auto res1 = map1.insert(std::make_pair(5, 0));
+        test("insert existing pt1", !res1.second);
+        test_eq("insert existing pt2", res1.first->second, 10);
+
+        for (int i = 0; i < 1000; i += 2)
+            map1.erase(i);
+        test_eq("size after erase", map1.size(), 500ul);
+        test_eq("count erased", map1.count(4), 0ul);
+        test_eq("count remaining", map1.count(5), 1ul);
+
+        size_t visited{};
+        for (auto& x: map1)
+        {
+            if (x.first % 2 == 1)
+                ++visited;
+        }
+        test_eq("iteration", visited, 500ul);
+
+        for (int i = 0; i < 1000; i += 2)
+            map1.try_emplace(i, -i);
+        test_eq("reuse deleted slots", map1[998], -998);
+
+        auto it = map1.find(7);
+        it = map1.erase(it);
+        test("erase iterator", !map1.contains(7));
+
+        helenos::flat_hash_map<std::string, int> map2{
+            {"alpha", 1}, {"beta", 2}, {"gamma", 3}
+        };
+        auto map3 = map2;
+        map2.clear();
+        test("clear", map2.empty() && map2.find("alpha") == map2.end());
+        test_eq("copy", map3["gamma"], 3);
+
+        auto map4 = std::move(map3);
+        test_eq("move pt1", map4.size(), 3ul);
+        test("move pt2", map3.empty());
+    }
+
+    void flat_hash_map_test::test_set()
+    {
+        helenos::flat_hash_set<int> set1{1, 2, 3, 2, 1};
+        test_eq("set dedup", set1.size(), 3ul);
+
+        auto res1 = set1.insert(4);
+        test("set insert pt1", res1.second);
+        test_eq("set insert pt2", *res1.first, 4);
+
+        test_eq("set erase pt1", set1.erase(2), 1ul);
+        test_eq("set erase pt2", set1.erase(2), 0ul);
+        test("set contains", set1.contains(1) && !set1.contains(2));
+
+        set1.reserve(100);
+        test("set reserve", set1.capacity() >= 100 && set1.contains(4));
+    }
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <utility>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr unsigned int iterations{100000};
+
+        template<class Fn>
+        long long measure(Fn fn)
+        {
+            auto start = chrono::steady_clock::now();
+            fn();
+            auto end = chrono::steady_clock::now();
+
+            return chrono::duration_cast<chrono::microseconds>(end - start).count();
+        }
+
+        int add(int x, int y)
+        {
+            return x + y;
+        }
+
+        /**
+         * Callables that tell where they are
+         * stored, so that the benchmark can see
+         * whether a function allocated.
+         */
+        struct small_target
+        {
+            const void* operator()() const
+            {
+                return this;
+            }
+        };
+
+        struct large_target
+        {
+            const void* operator()() const
+            {
+                return this;
+            }
+
+            char data[256];
+        };
+
+        bool stored_inline(const void* target, const void* fn, size_t size)
+        {
+            auto begin = static_cast<const char*>(fn);
+            auto ptr = static_cast<const char*>(target);
+
+            return begin <= ptr && ptr < begin + size;
+        }
+    }
+
+    bool function_bench::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        bench_pointer();
+        bench_lambda();
+        bench_large();
+
+        return end();
+    }
+
+    const char* function_bench::name()
+    {
+        return "function_bench";
+    }
+
+    void function_bench::bench_pointer()
+    {
+        int (* volatile raw)(int, int) = &add;
+        int total{};
+
+        auto raw_usecs = measure([&](){
+            for (unsigned int i = 0; i < iterations; ++i)
+            {
+                int (*fn)(int, int) = raw;
+                total += fn(1, 1);
+            }
+        });
+
+        auto usecs = measure([&](){
+            for (unsigned int i = 0; i < iterations; ++i)
+            {
+                std::function<int(int, int)> fn{raw};
+                total += fn(1, 1);
+            }
+        });
+
+        if (report_)
+        {
+            std::printf("[%s] pointer: %u iterations in %lld us (raw %lld us)\n",
+                        name(), iterations, usecs, raw_usecs);
+        }
+
+        test_eq("pointer total", total, 4 * static_cast<int>(iterations));
+    }
+
+    void function_bench::bench_lambda()
+    {
+        int total{};
+        int step{1};
+
+        auto usecs = measure([&](){
+            for (unsigned int i = 0; i < iterations; ++i)
+            {
+                std::function<void()> fn{[&total, step](){ total += step; }};
+                std::function<void()> copy{fn};
+                std::function<void()> moved{std::move(copy)};
+                moved();
+            }
+        });
+
+        if (report_)
+        {
+            std::printf("[%s] lambda: %u iterations in %lld us\n",
+                        name(), iterations, usecs);
+        }
+
+        test_eq("lambda total", total, static_cast<int>(iterations));
+
+        std::function<const void*()> fn{small_target{}};
+        test("small target stored inline", stored_inline(fn(), &fn, sizeof(fn)));
+
+        std::function<const void*()> moved{std::move(fn)};
+        test("small target inline after move",
+             stored_inline(moved(), &moved, sizeof(moved)));
+        test("moved from function is empty", !fn);
+    }
+
+    void function_bench::bench_large()
+    {
+        size_t total{};
+
+        auto usecs = measure([&](){
+            for (unsigned int i = 0; i < iterations; ++i)
+            {
+                std::function<const void*()> fn{large_target{}};
+                std::function<const void*()> moved{std::move(fn)};
+                total += (moved() != nullptr);
+            }
+        });
+
+        if (report_)
+        {
+            std::printf("[%s] large: %u iterations in %lld us\n",
+                        name(), iterations, usecs);
+        }
+
+        test_eq("large total", total, size_t{iterations});
+
+        std::function<const void*()> fn{large_target{}};
+        auto target = fn();
+        test("large target stored on the heap",
+             !stored_inline(target, &fn, sizeof(fn)));
+
+        std::function<const void*()> moved{std::move(fn)};
+        test("large target move does not allocate", moved() == target);
+    }
+}
@@ -27,6 +27,7 @@
  */
 
 #include <__bits/test/tests.hpp>
+#include <helenos/node_pool>
 #include <initializer_list>
 #include <map>
 #include <string>
@@ -47,6 +48,8 @@ namespace std::test
         test_multi();
         test_reverse_iterators();
         test_multi_bounds_and_ranges();
+        test_node_handles();
+        test_node_pool();
 
         return end();
     }
@@ -431,4 +434,89 @@ namespace std::test
             res3.first, res3.second
         );
     }
+
+    void map_test::test_node_handles()
+    {
+        std::map<int, int> map1{{1, 1}, {2, 2}, {3, 3}, {4, 4}};
+
+        auto node = map1.extract(2);
+        test("extract", !node.empty());
+        test_eq("extract key", node.key(), 2);
+        test_eq("extract size", map1.size(), 3U);
+        test("extract erases", map1.find(2) == map1.end());
+        test("extract missing", map1.extract(42).empty());
+
+        node.key() = 5;
+        node.mapped() = 50;
+        auto res1 = map1.insert(std::move(node));
+        test("insert node", res1.inserted);
+        test("insert node empties", node.empty());
+        test_eq("insert node value", map1[5], 50);
+
+        auto node2 = map1.extract(map1.find(1));
+        node2.key() = 3;
+        auto res2 = map1.insert(std::move(node2));
+        test("insert node dup", !res2.inserted);
+        test("insert node dup keeps", !res2.node.empty());
+        test_eq("insert node dup position", res2.position->first, 3);
+
+        std::map<int, int> map2{{1, 10}, {3, 30}, {7, 70}};
+        map1.merge(map2);
+        test_eq("merge size", map1.size(), 5U);
+        test_eq("merge leftover", map2.size(), 1U);
+        test_eq("merge moved", map1[7], 70);
+        test_eq("merge kept", map1[3], 3);
+        test_eq("merge leftover value", map2[3], 30);
+
+        std::map<int, int> check{{1, 10}, {3, 3}, {4, 4}, {5, 50}, {7, 70}};
+        test("merge result", map1 == check);
+
+        std::multimap<int, int> mmap1{{1, 1}, {1, 2}, {2, 2}};
+        std::multimap<int, int> mmap2{{1, 3}, {3, 3}};
+        mmap1.merge(mmap2);
+        test_eq("multi merge size", mmap1.size(), 5U);
+        test("multi merge empties", mmap2.empty());
+        test_eq("multi merge count", mmap1.count(1), 3U);
+
+        auto mnode = mmap1.extract(1);
+        test_eq("multi extract", mmap1.count(1), 2U);
+        mmap2.insert(std::move(mnode));
+        test_eq("multi insert node", mmap2.size(), 1U);
+    }
+
+    void map_test::test_node_pool()
+    {
+        helenos::pooled_map<int, int> map1{};
+        for (int i = 0; i < 100; ++i)
+            map1[(i * 37) % 100] = i;
+        test_eq("pooled size", map1.size(), 100U);
+        test_eq("pooled value", map1[37], 1);
+
+        for (int i = 0; i < 100; i += 2)
+            map1.erase(i);
+        test_eq("pooled erase", map1.size(), 50U);
+
+        /**
+         * Erased nodes go back to the pool, so the
+         * new ones should reuse them.
+         */
+        auto node = &*map1.find(1);
+        map1.erase(1);
+        map1[1000] = 1;
+        test("pooled reuse", &*map1.find(1000) == node);
+
+        auto map2 = map1;
+        test("pooled copy", map2 == map1);
+        test("pooled copy pool", map2.get_allocator() != map1.get_allocator());
+
+        helenos::pooled_map<int, int>::node_type handle{};
+        {
+            helenos::pooled_map<int, int> map3{map1};
+            handle = map3.extract(3);
+        }
+        test_eq("pooled handle outlives", handle.mapped(), map1[3]);
+
+        helenos::pooled_multiset<int> set1{3, 1, 3, 2};
+        test_eq("pooled multiset", set1.count(3), 2U);
+    }
 }
@@ -82,6 +82,38 @@ namespace std::test
             using propagate_on_container_swap            = std::true_type;
             using is_always_equal                        = std::true_type;
         };
+
+        struct allocation_counter
+        {
+            static inline unsigned allocations{};
+            static inline unsigned deallocations{};
+        };
+
+        template<class T>
+        struct counting_allocator
+        {
+            using value_type = T;
+
+            counting_allocator() = default;
+
+            template<class U>
+            counting_allocator(const counting_allocator<U>&)
+            { /* DUMMY BODY */ }
+
+            T* allocate(size_t n)
+            {
+                ++allocation_counter::allocations;
+
+                return std::allocator<T>{}.allocate(n);
+            }
+
+            void deallocate(T* ptr, size_t n)
+            {
+                ++allocation_counter::deallocations;
+
+                std::allocator<T>{}.deallocate(ptr, n);
+            }
+        };
     }
 
     bool memory_test::run(bool report)
@@ -199,6 +231,24 @@ namespace std::test
             test_eq("weak_ptr expired after all shared_ptrs die", wptr1.expired(), true);
             test_eq("shared object destroyed while weak_ptr exists", mock::destructor_calls, 1U);
         }
+
+        mock::clear();
+        {
+            std::weak_ptr<mock> wptr{};
+            {
+                auto ptr = std::allocate_shared<mock>(aux::counting_allocator<mock>{});
+                test_eq("allocate_shared constructs", mock::constructor_calls, 1U);
+                test_eq("allocate_shared single allocation",
+                        aux::allocation_counter::allocations, 1U);
+
+                wptr = ptr;
+            }
+            test_eq("allocate_shared object destroyed", mock::destructor_calls, 1U);
+            test_eq("allocate_shared payload kept for weak_ptr",
+                    aux::allocation_counter::deallocations, 0U);
+        }
+        test_eq("allocate_shared payload freed",
+                aux::allocation_counter::deallocations, 1U);
     }
 
     void memory_test::test_allocators()
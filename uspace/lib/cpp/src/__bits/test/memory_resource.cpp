@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace std::test
+{
+    namespace aux
+    {
+        /**
+         * Upstream resource that keeps track of
+         * how many blocks it currently hands out.
+         */
+        class counting_resource: public pmr::memory_resource
+        {
+            public:
+                size_t allocations{};
+                size_t outstanding{};
+
+            private:
+                void* do_allocate(size_t bytes, size_t alignment) override
+                {
+                    ++allocations;
+                    ++outstanding;
+
+                    return pmr::new_delete_resource()->allocate(bytes, alignment);
+                }
+
+                void do_deallocate(void* p, size_t bytes, size_t alignment) override
+                {
+                    --outstanding;
+                    pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+                }
+
+                bool do_is_equal(const pmr::memory_resource& other) const noexcept override
+                {
+                    return this == &other;
+                }
+        };
+
+        bool is_aligned(void* p, size_t alignment)
+        {
+            return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+        }
+    }
+
+    bool memory_resource_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_global_resources();
+        test_monotonic_buffer();
+        test_pool_resources();
+        test_containers();
+
+        return end();
+    }
+
+    const char* memory_resource_test::name()
+    {
+        return "memory_resource";
+    }
+
+    void memory_resource_test::test_global_resources()
+    {
+        auto nd = pmr::new_delete_resource();
+        test_eq("new_delete_resource is default", pmr::get_default_resource(), nd);
+        test("null_memory_resource differs", *nd != *pmr::null_memory_resource());
+
+        auto p = nd->allocate(100, 64);
+        test("new_delete_resource overaligned", aux::is_aligned(p, 64));
+        nd->deallocate(p, 100, 64);
+
+        aux::counting_resource upstream{};
+        auto old = pmr::set_default_resource(&upstream);
+        test_eq("set_default_resource returns old", old, nd);
+
+        pmr::polymorphic_allocator<int> alloc{};
+        test_eq("polymorphic_allocator uses default", alloc.resource(),
+                static_cast<pmr::memory_resource*>(&upstream));
+
+        pmr::set_default_resource(nullptr);
+        test_eq("set_default_resource(nullptr)", pmr::get_default_resource(), nd);
+    }
+
+    void memory_resource_test::test_monotonic_buffer()
+    {
+        aux::counting_resource upstream{};
+        {
+            alignas(16) char buffer[256];
+            pmr::monotonic_buffer_resource mr{buffer, sizeof(buffer), &upstream};
+
+            auto p1 = mr.allocate(10, 1);
+            auto p2 = mr.allocate(8, 8);
+            test("monotonic buffer pt1", p1 == buffer);
+            test("monotonic buffer pt2", aux::is_aligned(p2, 8));
+            test_eq("monotonic buffer no upstream", upstream.allocations, 0U);
+
+            mr.allocate(512, 16);
+            test_eq("monotonic buffer overflow", upstream.allocations, 1U);
+
+            mr.release();
+            test_eq("monotonic release", upstream.outstanding, 0U);
+            test("monotonic release reuses buffer", mr.allocate(1, 1) == buffer);
+        }
+
+        {
+            pmr::monotonic_buffer_resource mr{64, &upstream};
+            size_t before = upstream.allocations;
+            for (size_t i = 0; i < 1000; ++i)
+                mr.allocate(16, 16);
+
+            /**
+             * Geometric growth means a logarithmic number
+             * of upstream allocations.
+             */
+            test("monotonic geometric growth", upstream.allocations - before < 16);
+        }
+        test_eq("monotonic destructor", upstream.outstanding, 0U);
+    }
+
+    void memory_resource_test::test_pool_resources()
+    {
+        aux::counting_resource upstream{};
+        {
+            pmr::pool_options opts{};
+            opts.largest_required_pool_block = 100;
+            pmr::unsynchronized_pool_resource mr{opts, &upstream};
+            test("pool options", mr.options().largest_required_pool_block >= 100);
+
+            auto p1 = mr.allocate(24, 8);
+            mr.deallocate(p1, 24, 8);
+            auto p2 = mr.allocate(20, 4);
+            test_eq("pool block reuse", p1, p2);
+
+            void* blocks[64];
+            for (size_t i = 0; i < 64; ++i)
+                blocks[i] = mr.allocate(48, 16);
+            for (size_t i = 0; i < 64; ++i)
+                test("pool alignment", aux::is_aligned(blocks[i], 16));
+            test("pool chunking", upstream.allocations < 8);
+            for (size_t i = 0; i < 64; ++i)
+                mr.deallocate(blocks[i], 48, 16);
+
+            auto big = mr.allocate(10000, 8);
+            auto count = upstream.outstanding;
+            mr.deallocate(big, 10000, 8);
+            test_eq("pool oversized", upstream.outstanding, count - 1);
+
+            mr.allocate(10000, 128);
+            mr.release();
+            test_eq("pool release", upstream.outstanding, 0U);
+        }
+
+        {
+            pmr::synchronized_pool_resource mr{&upstream};
+            auto p1 = mr.allocate(32);
+            mr.deallocate(p1, 32);
+            auto p2 = mr.allocate(32);
+            test_eq("synchronized pool reuse", p1, p2);
+            test("synchronized pool equality", mr == mr);
+        }
+        test_eq("pool destructor", upstream.outstanding, 0U);
+    }
+
+    void memory_resource_test::test_containers()
+    {
+        aux::counting_resource upstream{};
+        {
+            pmr::monotonic_buffer_resource mr{&upstream};
+
+            pmr::vector<int> vec{&mr};
+            for (int i = 0; i < 100; ++i)
+                vec.push_back(i);
+            test_eq("pmr::vector", vec[99], 99);
+            test("pmr::vector resource", vec.get_allocator().resource() == &mr);
+
+            pmr::vector<pmr::string> strs{&mr};
+            strs.emplace_back("a string long enough to leave the small buffer");
+            test("uses-allocator construction",
+                 strs[0].get_allocator().resource() == &mr);
+
+            pmr::unordered_map<int, int> map{&mr};
+            map.emplace(1, 2);
+            test_eq("pmr::unordered_map", map[1], 2);
+            test("memory from the resource", upstream.allocations > 0);
+        }
+        test_eq("pmr containers cleanup", upstream.outstanding, 0U);
+    }
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <__bits/trycatch.hpp>
+#include <iterator>
+#include <list>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace std::test
+{
+    bool regex_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_match();
+        test_search();
+        test_submatches();
+        test_replace();
+        test_iterators();
+        test_errors();
+
+        return end();
+    }
+
+    const char* regex_test::name()
+    {
+        return "regex";
+    }
+
+    void regex_test::test_match()
+    {
+        std::regex re1{"a(b|c)*d"};
+        test("match alternation loop", std::regex_match("abcbd", re1));
+        test("match rejects prefix", !std::regex_match("abcbdx", re1));
+        test("match rejects partial", !std::regex_match("abcb", re1));
+
+        std::regex re2{"[a-z_][a-z0-9_]{0,7}"};
+        test("match bounded repeat", std::regex_match("var_12", re2));
+        test("match bounded repeat limit", !std::regex_match("a123456789", re2));
+
+        std::regex re3{"\\d+(\\.\\d+)?"};
+        test("match class escape", std::regex_match("3.14", re3));
+        test("match class escape optional", std::regex_match("42", re3));
+        test("match class escape mismatch", !std::regex_match("4.", re3));
+
+        std::regex re4{"hello", std::regex::icase};
+        test("match icase", std::regex_match("HeLLo", re4));
+
+        std::regex re5{"[^[:space:]]+"};
+        test("match posix class", std::regex_match("no-spaces", re5));
+        test("match posix class mismatch", !std::regex_match("a space", re5));
+
+        std::regex re6{"(a|ab)(c|bcd)(d*)"};
+        std::cmatch m{};
+        test("match leftmost first", std::regex_match("abcd", m, re6));
+        test_eq("match leftmost first group 1", m.str(1), std::string{"a"});
+        test_eq("match leftmost first group 2", m.str(2), std::string{"bcd"});
+
+        std::regex re7{"(a+)\\1"};
+        test("match backref", std::regex_match("aaaa", re7));
+        test("match backref mismatch", !std::regex_match("aaa", re7));
+
+        std::regex re8{"(?=.*\\d)\\w{4}"};
+        test("match lookahead", std::regex_match("ab1c", re8));
+        test("match lookahead mismatch", !std::regex_match("abcd", re8));
+
+        std::string str{"x=1"};
+        test("match string", std::regex_match(str, std::regex{"\\w=\\d"}));
+    }
+
+    void regex_test::test_search()
+    {
+        std::regex re1{"fo+"};
+        std::cmatch m{};
+        test("search", std::regex_search("a foooo bar", m, re1));
+        test_eq("search position", m.position(), 2L);
+        test_eq("search length", m.length(), 5L);
+        test_eq("search prefix", m.prefix().str(), std::string{"a "});
+        test_eq("search suffix", m.suffix().str(), std::string{" bar"});
+        test("search no match", !std::regex_search("a fxo bar", re1));
+
+        std::regex re2{"^b"};
+        test("search bol", !std::regex_search("ab", re2));
+        test("search bol start", std::regex_search("ba", re2));
+        test("search not bol", !std::regex_search("ba", re2, std::regex_constants::match_not_bol));
+
+        std::regex re3{"^b$", std::regex::multiline};
+        test("search multiline", std::regex_search("a\nb\nc", re3));
+
+        std::regex re4{"\\bcat\\b"};
+        test("search word boundary", std::regex_search("a cat sat", re4));
+        test("search word boundary mismatch", !std::regex_search("concatenate", re4));
+
+        std::regex re5{"a*?"};
+        test("search lazy empty", std::regex_search("aaa", m, re5));
+        test_eq("search lazy empty length", m.length(), 0L);
+
+        test("search continuous", !std::regex_search("xab", std::regex{"ab"},
+                                                     std::regex_constants::match_continuous));
+    }
+
+    void regex_test::test_submatches()
+    {
+        std::regex re1{"(\\w+)@(\\w+)\\.(com|org)"};
+        std::smatch m{};
+        std::string str{"mail: user@example.org!"};
+
+        test("submatches", std::regex_search(str, m, re1));
+        test_eq("submatches size", m.size(), 4UL);
+        test_eq("submatches user", m.str(1), std::string{"user"});
+        test_eq("submatches domain", m.str(2), std::string{"example"});
+        test_eq("submatches tld", m[3].str(), std::string{"org"});
+        test_eq("mark_count", re1.mark_count(), 3U);
+
+        std::regex re2{"(a)|(b)"};
+        std::cmatch m2{};
+        test("unmatched group", std::regex_search("b", m2, re2));
+        test("unmatched group flag", !m2[1].matched);
+        test("matched group flag", m2[2].matched);
+
+        std::regex re3{"(z)((a+)?(b+)?(c))*"};
+        test("repeat resets groups", std::regex_match("zaacbbbcac", m2, re3));
+        test_eq("repeat resets groups 3", m2.str(3), std::string{"a"});
+        test("repeat resets groups 4", !m2[4].matched);
+        test_eq("repeat resets groups 5", m2.str(5), std::string{"c"});
+
+        std::regex re4{"(a*)*b"};
+        test("empty loop", std::regex_match("aab", m2, re4));
+        test_eq("empty loop group", m2.str(1), std::string{"aa"});
+
+        std::regex re5{"(a)(b)", std::regex::nosubs};
+        test_eq("nosubs", re5.mark_count(), 0U);
+
+        std::list<char> lst{'k', '=', 'v'};
+        std::match_results<std::list<char>::iterator> m3{};
+        std::regex re6{"(\\w)=(\\w)"};
+        test("non contiguous input", std::regex_match(lst.begin(), lst.end(), m3, re6));
+        test_eq("non contiguous group", m3.str(2), std::string{"v"});
+    }
+
+    void regex_test::test_replace()
+    {
+        std::regex re1{"(\\w+) (\\w+)"};
+        test_eq("replace groups", regex_replace(std::string{"hello world"}, re1, "$2 $1"),
+                std::string{"world hello"});
+
+        std::regex re2{"o"};
+        test_eq("replace all", regex_replace(std::string{"foo boo"}, re2, "0"),
+                std::string{"f00 b00"});
+        test_eq(
+            "replace first only",
+            regex_replace(std::string{"foo boo"}, re2, "0",
+                          std::regex_constants::format_first_only),
+            std::string{"f0o boo"}
+        );
+        test_eq(
+            "replace no copy",
+            regex_replace(std::string{"a1b2"}, std::regex{"\\d"}, "<$&>",
+                          std::regex_constants::format_no_copy),
+            std::string{"<1><2>"}
+        );
+        test_eq("replace prefix and suffix", regex_replace("abc", std::regex{"b"}, "[$`|$']"),
+                std::string{"a[a|c]c"});
+        test_eq("replace empty matches", regex_replace("ab", std::regex{"x*"}, "-"),
+                std::string{"-a-b-"});
+        test_eq("replace sed", regex_replace("ab", std::regex{"(a)"}, "\\1&",
+                                             std::regex_constants::format_sed),
+                std::string{"aab"});
+    }
+
+    void regex_test::test_iterators()
+    {
+        std::string str{"one, two,three"};
+        std::regex re1{"\\w+"};
+
+        std::vector<std::string> words{};
+        for (std::sregex_iterator it{str.begin(), str.end(), re1}, end{}; it != end; ++it)
+            words.push_back(it->str());
+
+        std::vector<std::string> expected{"one", "two", "three"};
+        test_eq("regex_iterator", words.begin(), words.end(),
+                expected.begin(), expected.end());
+
+        std::sregex_iterator it{str.begin(), str.end(), re1};
+        ++it;
+        test_eq("regex_iterator position", it->position(), 5L);
+        test_eq("regex_iterator prefix", it->prefix().str(), std::string{", "});
+
+        std::regex re2{",\\s*"};
+        std::vector<std::string> tokens{};
+        for (std::sregex_token_iterator tit{str.begin(), str.end(), re2, -1}, tend{};
+             tit != tend; ++tit)
+            tokens.push_back(tit->str());
+        test_eq("regex_token_iterator split", tokens.begin(), tokens.end(),
+                expected.begin(), expected.end());
+
+        std::regex re3{"(\\w)(\\w*)"};
+        tokens.clear();
+        for (std::sregex_token_iterator tit{str.begin(), str.end(), re3, {2, 1}}, tend{};
+             tit != tend; ++tit)
+            tokens.push_back(tit->str());
+
+        std::vector<std::string> expected2{"ne", "o", "wo", "t", "hree", "t"};
+        test_eq("regex_token_iterator submatches", tokens.begin(), tokens.end(),
+                expected2.begin(), expected2.end());
+
+        std::string empty{};
+        std::regex re4{"a*"};
+        std::sregex_iterator it2{empty.begin(), empty.end(), re4}, end2{};
+        test("regex_iterator empty input", it2 != end2);
+        ++it2;
+        test("regex_iterator empty input end", it2 == end2);
+    }
+
+    void regex_test::test_errors()
+    {
+        const char* invalid[] = {
+            "(a", "a)", "[a", "a{2,1}", "*a", "a**", "\\", "(?=a)*", "\\2(a)", "[b-a]"
+        };
+
+        bool ok{true};
+        for (auto pattern: invalid)
+        {
+            std::regex re{pattern};
+            ok = ok && !std::regex_search("a(a)[a]**", re);
+        }
+
+        /**
+         * Without exceptions the mock throw only records the error,
+         * the invalid regex then matches nothing.
+         */
+        bool thrown{};
+        LIBCPP_EXCEPTION_THROW_CHECK(thrown);
+        test("invalid patterns throw", thrown);
+        test("invalid patterns do not match", ok);
+        aux::exception_thrown = false;
+
+        std::regex_error err{std::regex_constants::error_paren};
+        test_eq("regex_error code", err.code(), std::regex_constants::error_paren);
+    }
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <chrono>
+#include <cstdio>
+#include <regex>
+#include <string>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr unsigned int lines{2000};
+
+        template<class Fn>
+        long long measure(Fn fn)
+        {
+            auto start = chrono::steady_clock::now();
+            fn();
+            auto end = chrono::steady_clock::now();
+
+            return chrono::duration_cast<chrono::microseconds>(end - start).count();
+        }
+
+        std::string make_log()
+        {
+            std::string log{};
+            for (unsigned int i = 0; i < lines; ++i)
+            {
+                if (i % 100 == 7)
+                    log.append("vfs: error: mount failed on /dev/ata1\n");
+                else
+                    log.append("loc: service registered, waiting for clients\n");
+            }
+
+            return log;
+        }
+    }
+
+    bool regex_bench::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        bench_search();
+        bench_reject();
+        bench_pathological();
+        bench_backrefs();
+
+        return end();
+    }
+
+    const char* regex_bench::name()
+    {
+        return "regex_bench";
+    }
+
+    void regex_bench::bench_search()
+    {
+        auto log = make_log();
+        std::regex re{"(\\w+): error: (\\w+) failed"};
+        size_t count{};
+
+        auto usecs = measure([&](){
+            std::sregex_iterator it{log.begin(), log.end(), re};
+            for (std::sregex_iterator end{}; it != end; ++it)
+                ++count;
+        });
+
+        if (report_)
+        {
+            std::printf("[%s] search: %zu bytes, %zu matches in %lld us\n",
+                        name(), log.size(), count, usecs);
+        }
+
+        test_eq("search matches", count, size_t{lines / 100});
+    }
+
+    void regex_bench::bench_reject()
+    {
+        auto log = make_log();
+        std::regex re{"panic|assertion (failed|violated)"};
+        size_t count{};
+
+        /**
+         * Without submatches the lazy DFA answers on its
+         * own, the states are built during the first run.
+         */
+        auto usecs = measure([&](){
+            for (unsigned int i = 0; i < 10; ++i)
+            {
+                if (std::regex_search(log, re))
+                    ++count;
+            }
+        });
+
+        if (report_)
+        {
+            std::printf("[%s] reject: 10 x %zu bytes in %lld us\n",
+                        name(), log.size(), usecs);
+        }
+
+        test_eq("reject matches", count, size_t{});
+    }
+
+    void regex_bench::bench_pathological()
+    {
+        /**
+         * (a?){n}a{n} against a^n takes 2^n steps when
+         * backtracking, the NFA simulation is linear.
+         */
+        constexpr unsigned int n{30};
+
+        std::string pattern{};
+        for (unsigned int i = 0; i < n; ++i)
+            pattern.append("a?");
+        for (unsigned int i = 0; i < n; ++i)
+            pattern.append("a");
+
+        std::string subject(n, 'a');
+        std::regex re{pattern};
+        std::smatch m{};
+        bool matched{};
+
+        auto usecs = measure([&](){
+            matched = std::regex_match(subject, m, re);
+        });
+
+        if (report_)
+        {
+            std::printf("[%s] pathological: n = %u in %lld us\n",
+                        name(), n, usecs);
+        }
+
+        test("pathological matches", matched);
+    }
+
+    void regex_bench::bench_backrefs()
+    {
+        auto log = make_log();
+        std::regex re{"\\b(\\w+) \\1\\b"};
+        bool matched{};
+
+        auto usecs = measure([&](){
+            matched = std::regex_search(log, re);
+        });
+
+        if (report_)
+        {
+            std::printf("[%s] backrefs: %zu bytes in %lld us\n",
+                        name(), log.size(), usecs);
+        }
+
+        test("backrefs do not match", !matched);
+    }
+}
@@ -45,6 +45,7 @@ namespace std::test
         test_multi();
         test_reverse_iterators();
         test_multi_bounds_and_ranges();
+        test_node_handles();
 
         return end();
     }
@@ -298,4 +299,30 @@ namespace std::test
             res3.first, res3.second
         );
     }
+
+    void set_test::test_node_handles()
+    {
+        std::set<int> set1{1, 2, 3};
+        std::set<int> set2{3, 4};
+
+        auto node = set1.extract(1);
+        test_eq("extract value", node.value(), 1);
+        test_eq("extract size", set1.size(), 2U);
+
+        node.value() = 10;
+        auto res = set2.insert(std::move(node));
+        test("insert node", res.inserted);
+        test_eq("insert node value", *res.position, 10);
+
+        set1.merge(set2);
+        test_eq("merge size", set1.size(), 4U);
+        test_eq("merge leftover", set2.size(), 1U);
+        test_eq("merge leftover value", *set2.begin(), 3);
+
+        std::multiset<int> mset1{1, 1, 2};
+        std::multiset<int> mset2{1, 3};
+        mset1.merge(mset2);
+        test_eq("multi merge", mset1.count(1), 3U);
+        test("multi merge empties", mset2.empty());
+    }
 }
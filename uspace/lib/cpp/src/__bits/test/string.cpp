@@ -47,6 +47,7 @@ namespace std::test
         test_find();
         test_substr();
         test_compare();
+        test_short_strings();
 
         return end();
     }
@@ -703,4 +704,43 @@ namespace std::test
             res, 0
         );
     }
+
+    void string_test::test_short_strings()
+    {
+        test(
+            "short string size budget",
+            sizeof(std::string) <= 2 * sizeof(void*) + 16
+        );
+
+        std::string str1{};
+        test_eq("empty c_str", str1.c_str()[0], '\0');
+        test("empty capacity", str1.capacity() >= 16);
+
+        std::string str2{"0123456789abcde"};
+        std::string str3{"0123456789abcdefghij"};
+        std::string str4{std::move(str2)};
+        test_eq("short move target", str4, std::string{"0123456789abcde"});
+        test_eq("short move source", str2.c_str()[0], '\0');
+
+        str4.swap(str3);
+        test_eq("short/long swap pt1", str3, std::string{"0123456789abcde"});
+        test_eq("short/long swap pt2", str4, std::string{"0123456789abcdefghij"});
+
+        str4.swap(str3);
+        test_eq("long/short swap pt1", str3, std::string{"0123456789abcdefghij"});
+        test_eq("long/short swap pt2", str4, std::string{"0123456789abcde"});
+
+        std::string str5{"abc"};
+        for (int i = 0; i < 40; ++i)
+            str5.push_back('d');
+        test_eq("short grow size", str5.size(), 43ul);
+        test_eq("short grow prefix", str5.substr(0, 4), std::string{"abcd"});
+
+        str5.resize(3);
+        str5.shrink_to_fit();
+        test_eq("shrink back to short", str5, std::string{"abc"});
+
+        str5.assign(str5.c_str() + 1, 2);
+        test_eq("assign from self", str5, std::string{"bc"});
+    }
 }
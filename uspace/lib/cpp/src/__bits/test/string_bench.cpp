@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr unsigned int iterations{100000};
+
+        size_t allocations{};
+
+        /**
+         * Allocator that counts the allocations made by the
+         * strings being benchmarked.
+         */
+        template<class T>
+        struct counting_allocator
+        {
+            using value_type = T;
+
+            counting_allocator() = default;
+
+            template<class U>
+            counting_allocator(const counting_allocator<U>&)
+            { /* DUMMY BODY */ }
+
+            T* allocate(size_t n)
+            {
+                ++allocations;
+
+                return std::allocator<T>{}.allocate(n);
+            }
+
+            void deallocate(T* ptr, size_t n)
+            {
+                std::allocator<T>{}.deallocate(ptr, n);
+            }
+        };
+
+        using counted_string = basic_string<
+            char, char_traits<char>, counting_allocator<char>
+        >;
+
+        template<class Fn>
+        long long measure(Fn fn)
+        {
+            auto start = chrono::steady_clock::now();
+            fn();
+            auto end = chrono::steady_clock::now();
+
+            return chrono::duration_cast<chrono::microseconds>(end - start).count();
+        }
+    }
+
+    bool string_bench::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        bench_short();
+        bench_long();
+
+        return end();
+    }
+
+    const char* string_bench::name()
+    {
+        return "string_bench";
+    }
+
+    void string_bench::bench_short()
+    {
+        allocations = 0;
+        size_t total{};
+
+        auto usecs = measure([&](){
+            for (unsigned int i = 0; i < iterations; ++i)
+            {
+                counted_string key{"content-type"};
+                counted_string copy{key};
+                counted_string moved{std::move(copy)};
+                moved.append("-x");
+                total += moved.size();
+            }
+        });
+
+        if (report_)
+        {
+            std::printf("[%s] short: %u iterations in %lld us, %zu allocations\n",
+                        name(), iterations, usecs, allocations);
+        }
+
+        test_eq("short strings do not allocate", allocations, size_t{});
+        test_eq("short strings total", total, size_t{14} * iterations);
+    }
+
+    void string_bench::bench_long()
+    {
+        allocations = 0;
+        size_t total{};
+
+        auto usecs = measure([&](){
+            for (unsigned int i = 0; i < iterations; ++i)
+            {
+                counted_string path{"/usr/share/doc/helenos/README.txt"};
+                counted_string copy{path};
+                counted_string moved{std::move(copy)};
+                total += moved.size();
+            }
+        });
+
+        if (report_)
+        {
+            std::printf("[%s] long: %u iterations in %lld us, %zu allocations\n",
+                        name(), iterations, usecs, allocations);
+        }
+
+        test_eq("long strings allocate once per copy", allocations, size_t{2} * iterations);
+        test_eq("long strings total", total, size_t{33} * iterations);
+    }
+}
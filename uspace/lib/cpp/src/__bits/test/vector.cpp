@@ -26,9 +26,11 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <__bits/test/mock.hpp>
 #include <__bits/test/tests.hpp>
 #include <algorithm>
 #include <initializer_list>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -42,6 +44,7 @@ namespace std::test
         test_construction_and_assignment();
         test_insert();
         test_erase();
+        test_growth();
 
         return end();
     }
@@ -227,4 +230,77 @@ namespace std::test
             check3.begin(), check3.end()
         );
     }
+
+    namespace
+    {
+        /**
+         * Like mock, but its move constructor cannot throw.
+         */
+        struct nothrow_mock
+        {
+            static size_t copy_constructor_calls;
+            static size_t move_constructor_calls;
+
+            nothrow_mock() = default;
+
+            nothrow_mock(const nothrow_mock&)
+            {
+                ++copy_constructor_calls;
+            }
+
+            nothrow_mock(nothrow_mock&&) noexcept
+            {
+                ++move_constructor_calls;
+            }
+        };
+
+        size_t nothrow_mock::copy_constructor_calls{};
+        size_t nothrow_mock::move_constructor_calls{};
+    }
+
+    void vector_test::test_growth()
+    {
+        std::vector<int> vec1{};
+        for (int i = 0; i < 1000; ++i)
+            vec1.push_back(i);
+
+        bool ok{true};
+        for (int i = 0; i < 1000; ++i)
+            ok = ok && vec1[i] == i;
+        test("push_back trivial", ok);
+
+        std::vector<mock> vec2{};
+        vec2.reserve(4);
+        mock::clear();
+        vec2.emplace_back();
+        vec2.emplace_back();
+        test_eq("emplace_back constructs in place pt1", mock::constructor_calls, 2ul);
+        test_eq("emplace_back constructs in place pt2", mock::copy_constructor_calls, 0ul);
+        test_eq("emplace_back constructs in place pt3", mock::move_constructor_calls, 0ul);
+
+        for (int i = 0; i < 3; ++i)
+            vec2.emplace_back();
+        test_eq("growth copies throwing moves", mock::copy_constructor_calls, 4ul);
+        test_eq("growth destroys old elements", mock::destructor_calls, 4ul);
+
+        std::vector<nothrow_mock> vec3(4);
+        vec3.emplace_back();
+        test_eq("growth moves nothrow moves pt1", nothrow_mock::move_constructor_calls, 4ul);
+        test_eq("growth moves nothrow moves pt2", nothrow_mock::copy_constructor_calls, 0ul);
+
+        std::vector<std::string> vec4{};
+        vec4.push_back("a string that does not fit inline");
+        vec4.shrink_to_fit();
+        vec4.push_back(vec4[0]);
+        test_eq("push_back own element", vec4[1], vec4[0]);
+
+        vec4.resize(5, "x");
+        test_eq("resize size", vec4.size(), 5ul);
+        test_eq("resize value", vec4[4], std::string{"x"});
+
+        vec4.resize(1);
+        vec4.shrink_to_fit();
+        test_eq("shrink_to_fit capacity", vec4.capacity(), 1ul);
+        test_eq("shrink_to_fit value", vec4[0], std::string{"a string that does not fit inline"});
+    }
 }
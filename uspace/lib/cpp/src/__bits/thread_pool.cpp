@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/thread/thread_pool.hpp>
+#include <algorithm>
+#include <thread>
+
+namespace std::aux
+{
+    namespace
+    {
+        /**
+         * Index of the worker run by the current fibril
+         * plus one, zero for fibrils outside of the pool.
+         */
+        thread_local size_t current_worker{};
+    }
+
+    thread_pool& thread_pool::instance()
+    {
+        static thread_pool* pool = new thread_pool{};
+
+        return *pool;
+    }
+
+    thread_pool::thread_pool()
+        : workers_{}, size_{}, next_{}, pending_{}, idle_{}
+    {
+        threading::mutex::init(idle_mtx_);
+        threading::condvar::init(idle_cv_);
+
+        size_t cpus = max(thread::hardware_concurrency(), 1U);
+        workers_ = new worker[cpus];
+
+        /**
+         * The calling fibril's runner makes for one of them,
+         * if the program enabled multithreading on its own,
+         * these are added on top of its runners.
+         */
+        if (cpus > 1)
+            hel::fibril_test_spawn_runners(static_cast<int>(cpus - 1));
+
+        for (size_t i = 0; i < cpus; ++i)
+        {
+            auto& w = workers_[size_];
+            w.pool = this;
+            w.index = size_;
+            threading::mutex::init(w.mtx);
+
+            auto fid = hel::fibril_create(&thread_pool::worker_main_, &w);
+            if (!fid)
+                break;
+
+            ++size_;
+            hel::fibril_add_ready(fid);
+        }
+    }
+
+    void thread_pool::push(pool_task* task)
+    {
+        if (size_ == 0)
+        { // No workers, run synchronously.
+            task->execute();
+            delete task;
+
+            return;
+        }
+
+        size_t idx = current_worker;
+        if (idx == 0)
+            idx = __atomic_fetch_add(&next_, 1, __ATOMIC_RELAXED) % size_;
+        else
+            --idx;
+
+        auto& w = workers_[idx];
+        threading::mutex::lock(w.mtx);
+        w.tasks.push_back(task);
+        threading::mutex::unlock(w.mtx);
+
+        /**
+         * Pairs with sleep_(), either the sleeping worker sees
+         * the new task or we see the sleeping worker.
+         */
+        __atomic_add_fetch(&pending_, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&idle_, __ATOMIC_SEQ_CST) > 0)
+        {
+            threading::mutex::lock(idle_mtx_);
+            threading::condvar::signal(idle_cv_);
+            threading::mutex::unlock(idle_mtx_);
+        }
+    }
+
+    bool thread_pool::run_pending()
+    {
+        auto task = take_();
+        if (!task)
+            return false;
+
+        task->execute();
+        delete task;
+
+        return true;
+    }
+
+    pool_task* thread_pool::take_()
+    {
+        if (__atomic_load_n(&pending_, __ATOMIC_ACQUIRE) == 0)
+            return nullptr;
+
+        size_t self = current_worker;
+        pool_task* task{};
+
+        if (self > 0)
+        { // Own work first, newest task first.
+            auto& w = workers_[self - 1];
+            threading::mutex::lock(w.mtx);
+            if (!w.tasks.empty())
+            {
+                task = w.tasks.back();
+                w.tasks.pop_back();
+            }
+            threading::mutex::unlock(w.mtx);
+        }
+
+        for (size_t i = 0; !task && i < size_; ++i)
+        { // Steal the oldest task.
+            auto& w = workers_[(self + i) % size_];
+            threading::mutex::lock(w.mtx);
+            if (!w.tasks.empty())
+            {
+                task = w.tasks.front();
+                w.tasks.pop_front();
+            }
+            threading::mutex::unlock(w.mtx);
+        }
+
+        if (task)
+            __atomic_sub_fetch(&pending_, 1, __ATOMIC_RELAXED);
+
+        return task;
+    }
+
+    void thread_pool::sleep_()
+    {
+        threading::mutex::lock(idle_mtx_);
+        __atomic_add_fetch(&idle_, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&pending_, __ATOMIC_SEQ_CST) == 0)
+            threading::condvar::wait(idle_cv_, idle_mtx_);
+        __atomic_sub_fetch(&idle_, 1, __ATOMIC_SEQ_CST);
+        threading::mutex::unlock(idle_mtx_);
+    }
+
+    int thread_pool::worker_main_(void* arg)
+    {
+        auto w = static_cast<worker*>(arg);
+        current_worker = w->index + 1;
+
+        while (true)
+        {
+            if (!w->pool->run_pending())
+                w->pool->sleep_();
+        }
+
+        return 0;
+    }
+
+    void task_group::wait()
+    {
+        auto& pool = thread_pool::instance();
+
+        while (__atomic_load_n(&pending_, __ATOMIC_ACQUIRE) > 0)
+        {
+            /**
+             * Nothing to help with, the remaining tasks
+             * are being executed by other workers.
+             */
+            if (!pool.run_pending())
+                threading::thread::yield();
+        }
+    }
+}
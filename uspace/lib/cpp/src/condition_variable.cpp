@@ -26,63 +26,74 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <__bits/thread/atomic_wait.hpp>
 #include <cassert>
 #include <condition_variable>
 
 namespace std
 {
     condition_variable::condition_variable()
-        : cv_{}
-    {
-        aux::threading::condvar::init(cv_);
-    }
+        : seq_{}
+    { /* DUMMY BODY */ }
 
     condition_variable::~condition_variable()
     { /* DUMMY BODY */ }
 
+    /**
+     * Note: The waiters share wait slots, so notify_one
+     *       wakes up all of them like notify_all does.
+     */
     void condition_variable::notify_one() noexcept
     {
-        aux::threading::condvar::signal(cv_);
+        __atomic_add_fetch(&seq_, 1, __ATOMIC_RELAXED);
+        aux::atomic_notify(&seq_);
     }
 
     void condition_variable::notify_all() noexcept
     {
-        aux::threading::condvar::broadcast(cv_);
+        __atomic_add_fetch(&seq_, 1, __ATOMIC_RELAXED);
+        aux::atomic_notify(&seq_);
     }
 
     void condition_variable::wait(unique_lock<mutex>& lock)
     {
-        if (lock.owns_lock())
-            aux::threading::condvar::wait(cv_, *lock.mutex()->native_handle());
+        if (!lock.owns_lock())
+            return;
+
+        auto seq = __atomic_load_n(&seq_, __ATOMIC_RELAXED);
+
+        lock.mutex()->unlock();
+        aux::atomic_wait(&seq_, aux::cv_notified(seq_, seq));
+        lock.mutex()->lock();
     }
 
     condition_variable::native_handle_type condition_variable::native_handle()
     {
-        return &cv_;
+        return &seq_;
     }
 
     condition_variable_any::condition_variable_any()
-        : cv_{}
-    {
-        aux::threading::condvar::init(cv_);
-    }
+        : seq_{}
+    { /* DUMMY BODY */ }
 
     condition_variable_any::~condition_variable_any()
     { /* DUMMY BODY */ }
 
     void condition_variable_any::notify_one() noexcept
     {
-        aux::threading::condvar::signal(cv_);
+        __atomic_add_fetch(&seq_, 1, __ATOMIC_RELAXED);
+        aux::atomic_notify(&seq_);
     }
 
     void condition_variable_any::notify_all() noexcept
     {
-        aux::threading::condvar::broadcast(cv_);
+        __atomic_add_fetch(&seq_, 1, __ATOMIC_RELAXED);
+        aux::atomic_notify(&seq_);
     }
 
     condition_variable_any::native_handle_type condition_variable_any::native_handle()
     {
-        return &cv_;
+        return &seq_;
     }
 
     void notify_all_at_thread_exit(condition_variable&, unique_lock<mutex>&)
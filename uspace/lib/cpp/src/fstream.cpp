@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fstream>
+
+namespace std::hel
+{
+    extern "C" {
+        #include <vfs/vfs.h>
+    }
+}
+
+namespace std::aux
+{
+    int filebuf_open(const char* name, const char* mode)
+    {
+        /**
+         * The mode string comes from basic_filebuf::get_mode_str_,
+         * so it is one of the rows of table 132.
+         */
+        bool plus{false};
+        for (auto c = mode + 1; *c; ++c)
+        {
+            if (*c == '+')
+                plus = true;
+        }
+
+        int flags = hel::WALK_REGULAR;
+        int vfs_mode{};
+        bool truncate{false};
+        switch (mode[0])
+        {
+            case 'r':
+                vfs_mode = hel::MODE_READ;
+                break;
+            case 'w':
+                vfs_mode = hel::MODE_WRITE;
+                flags |= hel::WALK_MAY_CREATE;
+                truncate = true;
+                break;
+            case 'a':
+                vfs_mode = hel::MODE_WRITE | hel::MODE_APPEND;
+                flags |= hel::WALK_MAY_CREATE;
+                break;
+            default:
+                return -1;
+        }
+
+        if (plus)
+            vfs_mode |= hel::MODE_READ | hel::MODE_WRITE;
+
+        int fd{};
+        if (hel::vfs_lookup_open(name, flags, vfs_mode, &fd) != EOK)
+            return -1;
+
+        if (truncate && hel::vfs_resize(fd, 0) != EOK)
+        {
+            hel::vfs_put(fd);
+
+            return -1;
+        }
+
+        return fd;
+    }
+
+    int filebuf_close(int fd)
+    {
+        if (hel::vfs_put(fd) != EOK)
+            return -1;
+        return 0;
+    }
+
+    streamsize filebuf_read(int fd, streamoff& pos, void* buf, size_t size)
+    {
+        auto vfs_pos = static_cast<hel::aoff64_t>(pos);
+        size_t nread{};
+
+        auto rc = hel::vfs_read(fd, &vfs_pos, buf, size, &nread);
+        pos = static_cast<streamoff>(vfs_pos);
+
+        if (rc != EOK && nread == 0)
+            return -1;
+        return static_cast<streamsize>(nread);
+    }
+
+    streamsize filebuf_write(int fd, streamoff& pos, const void* buf, size_t size)
+    {
+        auto vfs_pos = static_cast<hel::aoff64_t>(pos);
+        size_t nwritten{};
+
+        auto rc = hel::vfs_write(fd, &vfs_pos, buf, size, &nwritten);
+        pos = static_cast<streamoff>(vfs_pos);
+
+        if (rc != EOK)
+            return -1;
+        return static_cast<streamsize>(nwritten);
+    }
+
+    streamoff filebuf_size(int fd)
+    {
+        hel::vfs_stat_t stat{};
+        if (hel::vfs_stat(fd, &stat) != EOK)
+            return -1;
+
+        return static_cast<streamoff>(stat.size);
+    }
+}
@@ -39,6 +39,8 @@ namespace std
     namespace aux
     {
         ios_base::Init init{};
+
+        stdout_streambuf<char>* cout_buf{nullptr};
     }
 
     int ios_base::Init::init_cnt_{};
@@ -49,8 +51,11 @@ namespace std
         {
             // TODO: These buffers should be static too
             //       in case somebody reassigns to cout/cin.
+            aux::cout_buf = ::new aux::stdout_streambuf<char>{};
+            aux::cout_buf->buffered(!sync_);
+
             ::new(&cin) istream{::new aux::stdin_streambuf<char>{}};
-            ::new(&cout) ostream{::new aux::stdout_streambuf<char>{}};
+            ::new(&cout) ostream{aux::cout_buf};
 
             cin.tie(&cout);
         }
@@ -61,4 +66,15 @@ namespace std
         if (--init_cnt_ == 0)
             cout.flush();
     }
+
+    bool ios_base::sync_with_stdio(bool sync)
+    {
+        auto old = sync_;
+        sync_ = sync;
+
+        if (aux::cout_buf)
+            aux::cout_buf->buffered(!sync);
+
+        return old;
+    }
 }
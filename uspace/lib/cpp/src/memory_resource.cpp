@@ -0,0 +1,474 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/memory/memory_resource.hpp>
+#include <cstdint>
+#include <cstdlib>
+
+namespace std::hel
+{
+    extern "C" {
+        #include <malloc.h>
+    }
+}
+
+namespace std::pmr
+{
+    namespace
+    {
+        size_t align_up(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        class new_delete_resource_t: public memory_resource
+        {
+            private:
+                void* do_allocate(size_t bytes, size_t alignment) override
+                {
+                    if (alignment <= aux::pmr_max_align)
+                        return ::operator new(bytes);
+
+                    auto res = hel::memalign(alignment, bytes > 0 ? bytes : 1);
+                    if (!res)
+                    {
+                        // TODO: For this we need stack unwinding support.
+                        /* throw bad_alloc{}; */
+                    }
+
+                    return res;
+                }
+
+                void do_deallocate(void* p, size_t, size_t alignment) override
+                {
+                    if (alignment <= aux::pmr_max_align)
+                        ::operator delete(p);
+                    else
+                        hel::free(p);
+                }
+
+                bool do_is_equal(const memory_resource& other) const noexcept override
+                {
+                    return this == &other;
+                }
+        };
+
+        class null_memory_resource_t: public memory_resource
+        {
+            private:
+                void* do_allocate(size_t, size_t) override
+                {
+                    // TODO: For this we need stack unwinding support.
+                    /* throw bad_alloc{}; */
+                    return nullptr;
+                }
+
+                void do_deallocate(void*, size_t, size_t) override
+                { /* DUMMY BODY */ }
+
+                bool do_is_equal(const memory_resource& other) const noexcept override
+                {
+                    return this == &other;
+                }
+        };
+
+        new_delete_resource_t new_delete_res{};
+        null_memory_resource_t null_res{};
+
+        memory_resource* default_res{nullptr};
+
+        /**
+         * Header placed in front of every chunk obtained
+         * from an upstream resource, so that the chunk can
+         * be returned with its original size and alignment.
+         */
+        struct chunk_header
+        {
+            chunk_header* next;
+            size_t size;
+            size_t alignment;
+        };
+
+        constexpr size_t chunk_header_size = (
+            (sizeof(chunk_header) + aux::pmr_max_align - 1) & ~(aux::pmr_max_align - 1)
+        );
+
+        void* allocate_chunk(memory_resource* upstream, void*& chunks,
+                             size_t bytes, size_t alignment)
+        {
+            if (alignment < aux::pmr_max_align)
+                alignment = aux::pmr_max_align;
+
+            auto offset = align_up(chunk_header_size, alignment);
+            auto size = offset + bytes;
+            auto mem = static_cast<char*>(upstream->allocate(size, alignment));
+            if (!mem)
+                return nullptr;
+
+            auto header = reinterpret_cast<chunk_header*>(mem);
+            header->next = static_cast<chunk_header*>(chunks);
+            header->size = size;
+            header->alignment = alignment;
+            chunks = header;
+
+            return mem + offset;
+        }
+
+        void release_chunks(memory_resource* upstream, void*& chunks)
+        {
+            auto current = static_cast<chunk_header*>(chunks);
+            while (current)
+            {
+                auto next = current->next;
+                upstream->deallocate(current, current->size, current->alignment);
+                current = next;
+            }
+
+            chunks = nullptr;
+        }
+
+        /**
+         * Header of an oversized pool allocation, stored
+         * right below the returned pointer.
+         */
+        struct oversized_header
+        {
+            oversized_header* prev;
+            oversized_header* next;
+            size_t size;
+            size_t alignment;
+        };
+
+        size_t oversized_offset(size_t alignment)
+        {
+            return align_up(sizeof(oversized_header), alignment);
+        }
+
+        oversized_header* oversized_from(void* p)
+        {
+            return static_cast<oversized_header*>(p) - 1;
+        }
+
+        constexpr size_t default_max_blocks_per_chunk{1024};
+        constexpr size_t initial_blocks_per_chunk{16};
+    }
+
+    memory_resource::~memory_resource()
+    { /* DUMMY BODY */ }
+
+    memory_resource* new_delete_resource() noexcept
+    {
+        return &new_delete_res;
+    }
+
+    memory_resource* null_memory_resource() noexcept
+    {
+        return &null_res;
+    }
+
+    memory_resource* set_default_resource(memory_resource* r) noexcept
+    {
+        if (!r)
+            r = new_delete_resource();
+
+        auto old = __atomic_exchange_n(&default_res, r, __ATOMIC_ACQ_REL);
+
+        return old ? old : new_delete_resource();
+    }
+
+    memory_resource* get_default_resource() noexcept
+    {
+        auto res = __atomic_load_n(&default_res, __ATOMIC_ACQUIRE);
+
+        return res ? res : new_delete_resource();
+    }
+
+    /**
+     * unsynchronized_pool_resource:
+     */
+
+    unsynchronized_pool_resource::unsynchronized_pool_resource(
+        const pool_options& opts, memory_resource* upstream
+    )
+        : upstream_{upstream}, options_{opts}, pools_{},
+          pool_count_{}, oversized_{}
+    {
+        constexpr size_t max_block = aux::pmr_min_block_size << (aux::pmr_max_pool_count - 1);
+
+        if (options_.max_blocks_per_chunk == 0)
+            options_.max_blocks_per_chunk = default_max_blocks_per_chunk;
+        if (options_.max_blocks_per_chunk < initial_blocks_per_chunk)
+            options_.max_blocks_per_chunk = initial_blocks_per_chunk;
+
+        if (options_.largest_required_pool_block == 0)
+            options_.largest_required_pool_block = 4096;
+        if (options_.largest_required_pool_block > max_block)
+            options_.largest_required_pool_block = max_block;
+
+        size_t block = aux::pmr_min_block_size;
+        while (pool_count_ < aux::pmr_max_pool_count)
+        {
+            auto& pool = pools_[pool_count_++];
+            pool.block_size = block;
+            pool.next_blocks = initial_blocks_per_chunk;
+            pool.free_list = nullptr;
+            pool.chunks = nullptr;
+
+            if (block >= options_.largest_required_pool_block)
+                break;
+            block <<= 1;
+        }
+
+        options_.largest_required_pool_block = block;
+    }
+
+    unsynchronized_pool_resource::~unsynchronized_pool_resource()
+    {
+        release();
+    }
+
+    void unsynchronized_pool_resource::release()
+    {
+        for (size_t i = 0; i < pool_count_; ++i)
+        {
+            auto& pool = pools_[i];
+            release_chunks(upstream_, pool.chunks);
+            pool.free_list = nullptr;
+            pool.next_blocks = initial_blocks_per_chunk;
+        }
+
+        auto current = static_cast<oversized_header*>(oversized_);
+        while (current)
+        {
+            auto next = current->next;
+            auto offset = oversized_offset(current->alignment);
+            upstream_->deallocate(
+                reinterpret_cast<char*>(current + 1) - offset,
+                current->size, current->alignment
+            );
+            current = next;
+        }
+        oversized_ = nullptr;
+    }
+
+    size_t unsynchronized_pool_resource::pool_index_(size_t bytes, size_t alignment) const
+    {
+        if (alignment > aux::pmr_max_align)
+            return pool_count_;
+
+        auto needed = bytes > alignment ? bytes : alignment;
+        for (size_t i = 0; i < pool_count_; ++i)
+        {
+            if (pools_[i].block_size >= needed)
+                return i;
+        }
+
+        return pool_count_;
+    }
+
+    bool unsynchronized_pool_resource::refill_(aux::pmr_pool& pool)
+    {
+        auto count = pool.next_blocks;
+        auto mem = static_cast<char*>(allocate_chunk(
+            upstream_, pool.chunks, count * pool.block_size,
+            aux::pmr_max_align
+        ));
+        if (!mem)
+            return false;
+
+        /**
+         * Thread the whole chunk onto the free list,
+         * lowest address first.
+         */
+        for (size_t i = count; i > 0; --i)
+        {
+            auto block = mem + (i - 1) * pool.block_size;
+            *reinterpret_cast<void**>(block) = pool.free_list;
+            pool.free_list = block;
+        }
+
+        if (pool.next_blocks < options_.max_blocks_per_chunk)
+        {
+            pool.next_blocks *= 2;
+            if (pool.next_blocks > options_.max_blocks_per_chunk)
+                pool.next_blocks = options_.max_blocks_per_chunk;
+        }
+
+        return true;
+    }
+
+    void* unsynchronized_pool_resource::do_allocate(size_t bytes, size_t alignment)
+    {
+        auto idx = pool_index_(bytes, alignment);
+        if (idx < pool_count_)
+        {
+            auto& pool = pools_[idx];
+            if (!pool.free_list && !refill_(pool))
+                return nullptr;
+
+            auto res = pool.free_list;
+            pool.free_list = *static_cast<void**>(res);
+
+            return res;
+        }
+
+        if (alignment < alignof(oversized_header))
+            alignment = alignof(oversized_header);
+
+        auto offset = oversized_offset(alignment);
+        auto size = offset + bytes;
+        auto mem = static_cast<char*>(upstream_->allocate(size, alignment));
+        if (!mem)
+            return nullptr;
+
+        auto res = mem + offset;
+        auto header = oversized_from(res);
+        header->prev = nullptr;
+        header->next = static_cast<oversized_header*>(oversized_);
+        header->size = size;
+        header->alignment = alignment;
+        if (header->next)
+            header->next->prev = header;
+        oversized_ = header;
+
+        return res;
+    }
+
+    void unsynchronized_pool_resource::do_deallocate(void* p, size_t bytes, size_t alignment)
+    {
+        if (!p)
+            return;
+
+        auto idx = pool_index_(bytes, alignment);
+        if (idx < pool_count_)
+        {
+            auto& pool = pools_[idx];
+            *static_cast<void**>(p) = pool.free_list;
+            pool.free_list = p;
+
+            return;
+        }
+
+        auto header = oversized_from(p);
+        if (header->prev)
+            header->prev->next = header->next;
+        else
+            oversized_ = header->next;
+        if (header->next)
+            header->next->prev = header->prev;
+
+        upstream_->deallocate(
+            static_cast<char*>(p) - oversized_offset(header->alignment),
+            header->size, header->alignment
+        );
+    }
+
+    bool unsynchronized_pool_resource::do_is_equal(const memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    /**
+     * synchronized_pool_resource:
+     */
+
+    void synchronized_pool_resource::release()
+    {
+        aux::threading::mutex::lock(mtx_);
+        impl_.release();
+        aux::threading::mutex::unlock(mtx_);
+    }
+
+    void* synchronized_pool_resource::do_allocate(size_t bytes, size_t alignment)
+    {
+        aux::threading::mutex::lock(mtx_);
+        auto res = impl_.allocate(bytes, alignment);
+        aux::threading::mutex::unlock(mtx_);
+
+        return res;
+    }
+
+    void synchronized_pool_resource::do_deallocate(void* p, size_t bytes, size_t alignment)
+    {
+        aux::threading::mutex::lock(mtx_);
+        impl_.deallocate(p, bytes, alignment);
+        aux::threading::mutex::unlock(mtx_);
+    }
+
+    bool synchronized_pool_resource::do_is_equal(const memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    /**
+     * monotonic_buffer_resource:
+     */
+
+    monotonic_buffer_resource::~monotonic_buffer_resource()
+    {
+        release();
+    }
+
+    void monotonic_buffer_resource::release()
+    {
+        release_chunks(upstream_, chunks_);
+
+        current_ = buffer_;
+        remaining_ = buffer_size_;
+    }
+
+    void* monotonic_buffer_resource::do_allocate(size_t bytes, size_t alignment)
+    {
+        auto addr = reinterpret_cast<uintptr_t>(current_);
+        auto padding = align_up(addr, alignment) - addr;
+
+        if (!current_ || padding + bytes > remaining_)
+        {
+            auto size = next_size_;
+            while (size < bytes + alignment)
+                size *= 2;
+
+            auto mem = allocate_chunk(upstream_, chunks_, size, aux::pmr_max_align);
+            if (!mem)
+                return nullptr;
+
+            current_ = mem;
+            remaining_ = size;
+            next_size_ = size * 2;
+
+            addr = reinterpret_cast<uintptr_t>(current_);
+            padding = align_up(addr, alignment) - addr;
+        }
+
+        auto res = static_cast<char*>(current_) + padding;
+        current_ = res + bytes;
+        remaining_ -= padding + bytes;
+
+        return res;
+    }
+}
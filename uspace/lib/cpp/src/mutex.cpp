@@ -26,28 +26,33 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <__bits/thread/atomic_wait.hpp>
 #include <mutex>
 
 namespace std
 {
-    void mutex::lock()
+    void mutex::lock_contended_()
     {
-        aux::threading::mutex::lock(mtx_);
-    }
-
-    bool mutex::try_lock()
-    {
-        return aux::threading::mutex::try_lock(mtx_);
+        /**
+         * Whoever acquires the mutex here does not know if others
+         * still wait, so it leaves it marked as contended.
+         */
+        while (__atomic_exchange_n(&state_, 2, __ATOMIC_ACQUIRE) != 0)
+        {
+            aux::atomic_wait(&state_, [this](){
+                return __atomic_load_n(&state_, __ATOMIC_RELAXED) != 2;
+            });
+        }
     }
 
-    void mutex::unlock()
+    void mutex::unlock_contended_()
     {
-        aux::threading::mutex::unlock(mtx_);
+        aux::atomic_notify(&state_);
     }
 
     mutex::native_handle_type mutex::native_handle()
     {
-        return &mtx_;
+        return &state_;
     }
 
     recursive_mutex::~recursive_mutex()
@@ -0,0 +1,2191 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <helenos/flat_hash_map>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * The regex engine compiles ECMAScript patterns to a Thompson NFA
+ * (a program for a Pike VM) that is then executed in one of three ways:
+ *
+ *  - A lazily built DFA answers whether there is a match at all. Its
+ *    states are sets of NFA instructions and its transitions are only
+ *    computed when the input first needs them. The DFA is used on its
+ *    own when no submatches are requested and as a quick rejection
+ *    filter otherwise.
+ *  - A Pike VM runs all NFA threads in lock step and tracks submatches,
+ *    so it matches in O(pattern * input) time.
+ *  - Backreferences and lookaheads cannot be expressed by an automaton,
+ *    patterns using them are run by a backtracking matcher instead.
+ */
+
+namespace std
+{
+    namespace
+    {
+        const char* regex_error_message(regex_constants::error_type ecode)
+        {
+            switch (ecode)
+            {
+                case regex_constants::error_collate:
+                    return "regex_error: invalid collating element";
+                case regex_constants::error_ctype:
+                    return "regex_error: invalid character class";
+                case regex_constants::error_escape:
+                    return "regex_error: invalid escape";
+                case regex_constants::error_backref:
+                    return "regex_error: invalid back reference";
+                case regex_constants::error_brack:
+                    return "regex_error: mismatched [ and ]";
+                case regex_constants::error_paren:
+                    return "regex_error: mismatched ( and )";
+                case regex_constants::error_brace:
+                    return "regex_error: mismatched { and }";
+                case regex_constants::error_badbrace:
+                    return "regex_error: invalid range in {}";
+                case regex_constants::error_range:
+                    return "regex_error: invalid character range";
+                case regex_constants::error_space:
+                    return "regex_error: out of memory";
+                case regex_constants::error_badrepeat:
+                    return "regex_error: nothing to repeat";
+                case regex_constants::error_complexity:
+                    return "regex_error: pattern too complex";
+                case regex_constants::error_stack:
+                    return "regex_error: out of stack space";
+                default:
+                    return "regex_error";
+            }
+        }
+    }
+
+    regex_error::regex_error(regex_constants::error_type ecode)
+        : runtime_error{regex_error_message(ecode)}, code_{ecode}
+    { /* DUMMY BODY */ }
+
+    regex_constants::error_type regex_error::code() const
+    {
+        return code_;
+    }
+}
+
+namespace std::aux
+{
+    namespace
+    {
+        using regex_constants::error_type;
+
+        enum regex_opcode: uint8_t
+        {
+            op_char,
+            op_class,
+            op_split,
+            op_jmp,
+            op_save,
+            op_clear,
+            op_mark,
+            op_check,
+            op_bol,
+            op_eol,
+            op_word_boundary,
+            op_not_word_boundary,
+            op_backref,
+            op_lookahead,
+            op_lookahead_end,
+            op_match
+        };
+
+        /**
+         * Meaning of the operands:
+         *  - op_char: x is the character,
+         *  - op_class: x is the index of the class,
+         *  - op_split: x is the preferred and y the other target,
+         *  - op_jmp: x is the target,
+         *  - op_save, op_mark, op_check: x is the slot,
+         *  - op_clear: x and y are the first and last slot to reset,
+         *  - op_bol, op_eol: x is nonzero in multiline mode,
+         *  - op_backref: x is the group number,
+         *  - op_lookahead: x is the instruction after the matching
+         *    op_lookahead_end, y is nonzero for negative lookaheads.
+         */
+        struct regex_instruction
+        {
+            regex_opcode op;
+            int x;
+            int y;
+        };
+
+        constexpr int max_program_size{1 << 16};
+        constexpr int max_repeat{1000};
+        constexpr unsigned long max_backtrack_steps{10000000};
+
+        bool is_word_char(unsigned char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                   (c >= '0' && c <= '9') || c == '_';
+        }
+
+        bool is_line_terminator(unsigned char c)
+        {
+            return c == '\n' || c == '\r';
+        }
+
+        unsigned char to_lower(unsigned char c)
+        {
+            if (c >= 'A' && c <= 'Z')
+                return c - 'A' + 'a';
+            else
+                return c;
+        }
+
+        unsigned char to_upper(unsigned char c)
+        {
+            if (c >= 'a' && c <= 'z')
+                return c - 'a' + 'A';
+            else
+                return c;
+        }
+
+        struct regex_class
+        {
+            uint32_t bits[8];
+
+            regex_class()
+                : bits{}
+            { /* DUMMY BODY */ }
+
+            bool test(unsigned char c) const
+            {
+                return bits[c >> 5] & (uint32_t{1} << (c & 31));
+            }
+
+            void set(unsigned char c)
+            {
+                bits[c >> 5] |= uint32_t{1} << (c & 31);
+            }
+
+            void set_range(unsigned char lo, unsigned char hi)
+            {
+                for (unsigned int c = lo; c <= hi; ++c)
+                    set(static_cast<unsigned char>(c));
+            }
+
+            void merge(const regex_class& other)
+            {
+                for (int i = 0; i < 8; ++i)
+                    bits[i] |= other.bits[i];
+            }
+
+            void invert()
+            {
+                for (int i = 0; i < 8; ++i)
+                    bits[i] = ~bits[i];
+            }
+
+            void fold_case()
+            {
+                for (unsigned int c = 'a'; c <= 'z'; ++c)
+                {
+                    auto upper = to_upper(static_cast<unsigned char>(c));
+                    if (test(static_cast<unsigned char>(c)) || test(upper))
+                    {
+                        set(static_cast<unsigned char>(c));
+                        set(upper);
+                    }
+                }
+            }
+        };
+
+        regex_class make_class(char name)
+        {
+            regex_class res{};
+
+            switch (name)
+            {
+                case 'd':
+                case 'D':
+                    res.set_range('0', '9');
+                    break;
+                case 'w':
+                case 'W':
+                    res.set_range('a', 'z');
+                    res.set_range('A', 'Z');
+                    res.set_range('0', '9');
+                    res.set('_');
+                    break;
+                case 's':
+                case 'S':
+                    res.set(' ');
+                    res.set_range('\t', '\r');
+                    break;
+            }
+
+            if (name == 'D' || name == 'W' || name == 'S')
+                res.invert();
+
+            return res;
+        }
+
+        bool make_posix_class(const string& name, regex_class& res)
+        {
+            if (name == "alnum")
+            {
+                res.merge(make_class('d'));
+                res.set_range('a', 'z');
+                res.set_range('A', 'Z');
+            }
+            else if (name == "alpha")
+            {
+                res.set_range('a', 'z');
+                res.set_range('A', 'Z');
+            }
+            else if (name == "blank")
+            {
+                res.set(' ');
+                res.set('\t');
+            }
+            else if (name == "cntrl")
+            {
+                res.set_range(0, 0x1F);
+                res.set(0x7F);
+            }
+            else if (name == "digit" || name == "d")
+                res.merge(make_class('d'));
+            else if (name == "graph")
+                res.set_range(0x21, 0x7E);
+            else if (name == "lower")
+                res.set_range('a', 'z');
+            else if (name == "print")
+                res.set_range(0x20, 0x7E);
+            else if (name == "punct")
+            {
+                res.set_range(0x21, 0x2F);
+                res.set_range(0x3A, 0x40);
+                res.set_range(0x5B, 0x60);
+                res.set_range(0x7B, 0x7E);
+            }
+            else if (name == "space" || name == "s")
+                res.merge(make_class('s'));
+            else if (name == "upper")
+                res.set_range('A', 'Z');
+            else if (name == "xdigit")
+            {
+                res.set_range('0', '9');
+                res.set_range('a', 'f');
+                res.set_range('A', 'F');
+            }
+            else if (name == "w")
+                res.merge(make_class('w'));
+            else
+                return false;
+
+            return true;
+        }
+
+        enum class regex_node_type
+        {
+            empty,
+            chr,
+            cls,
+            concat,
+            alternation,
+            repeat,
+            group,
+            bol,
+            eol,
+            word_boundary,
+            not_word_boundary,
+            backref,
+            lookahead
+        };
+
+        struct regex_node
+        {
+            regex_node_type type;
+
+            /**
+             * Character, class index, group number or
+             * backreference number.
+             */
+            int value{};
+
+            int min{};
+            int max{};
+
+            /**
+             * Greedy repetition or negative lookahead.
+             */
+            bool flag{};
+
+            vector<int> children{};
+        };
+
+        /**
+         * Recursive descent parser of the ECMAScript
+         * pattern grammar producing an AST.
+         */
+        class regex_parser
+        {
+            public:
+                regex_parser(const char* first, const char* last, unsigned int flags,
+                             vector<regex_node>& nodes, vector<regex_class>& classes)
+                    : cur_{first}, end_{last}, flags_{flags}, nodes_{nodes},
+                      classes_{classes}, groups_{}, max_backref_{},
+                      error_{}, has_backtracking_{}, has_word_boundary_{},
+                      has_multiline_anchor_{}
+                { /* DUMMY BODY */ }
+
+                int parse()
+                {
+                    auto root = parse_disjunction();
+
+                    if (root >= 0 && cur_ != end_)
+                        return fail(regex_constants::error_paren);
+                    if (root >= 0 && max_backref_ > groups_)
+                        return fail(regex_constants::error_backref);
+
+                    return root;
+                }
+
+                error_type error() const
+                {
+                    return error_;
+                }
+
+                int groups() const
+                {
+                    return groups_;
+                }
+
+                bool has_backtracking() const
+                {
+                    return has_backtracking_;
+                }
+
+                bool has_backrefs() const
+                {
+                    return max_backref_ > 0;
+                }
+
+                bool has_word_boundary() const
+                {
+                    return has_word_boundary_;
+                }
+
+                bool has_multiline_anchor() const
+                {
+                    return has_multiline_anchor_;
+                }
+
+            private:
+                const char* cur_;
+                const char* end_;
+                unsigned int flags_;
+                vector<regex_node>& nodes_;
+                vector<regex_class>& classes_;
+                int groups_;
+                int max_backref_;
+                error_type error_;
+                bool has_backtracking_;
+                bool has_word_boundary_;
+                bool has_multiline_anchor_;
+
+                int fail(error_type err)
+                {
+                    if (!error_)
+                        error_ = err;
+
+                    return -1;
+                }
+
+                bool icase() const
+                {
+                    return flags_ & regex_constants::icase;
+                }
+
+                bool multiline() const
+                {
+                    return flags_ & regex_constants::multiline;
+                }
+
+                int add_node(regex_node_type type, int value = 0)
+                {
+                    regex_node node{};
+                    node.type = type;
+                    node.value = value;
+                    nodes_.push_back(std::move(node));
+
+                    return static_cast<int>(nodes_.size() - 1);
+                }
+
+                int add_class(const regex_class& cls)
+                {
+                    classes_.push_back(cls);
+
+                    return add_node(
+                        regex_node_type::cls,
+                        static_cast<int>(classes_.size() - 1)
+                    );
+                }
+
+                int add_char(unsigned char c)
+                {
+                    if (icase() && to_lower(c) != to_upper(c))
+                    {
+                        regex_class cls{};
+                        cls.set(to_lower(c));
+                        cls.set(to_upper(c));
+
+                        return add_class(cls);
+                    }
+
+                    return add_node(regex_node_type::chr, c);
+                }
+
+                bool at(char c) const
+                {
+                    return cur_ != end_ && *cur_ == c;
+                }
+
+                bool accept(char c)
+                {
+                    if (at(c))
+                    {
+                        ++cur_;
+                        return true;
+                    }
+
+                    return false;
+                }
+
+                bool accept(const char* str)
+                {
+                    auto len = char_traits<char>::length(str);
+                    if (static_cast<size_t>(end_ - cur_) < len ||
+                        std::memcmp(cur_, str, len) != 0)
+                        return false;
+
+                    cur_ += len;
+                    return true;
+                }
+
+                int parse_disjunction()
+                {
+                    auto first = parse_alternative();
+                    if (first < 0 || !at('|'))
+                        return first;
+
+                    auto alt = add_node(regex_node_type::alternation);
+                    nodes_[alt].children.push_back(first);
+
+                    while (accept('|'))
+                    {
+                        auto next = parse_alternative();
+                        if (next < 0)
+                            return -1;
+
+                        nodes_[alt].children.push_back(next);
+                    }
+
+                    return alt;
+                }
+
+                int parse_alternative()
+                {
+                    vector<int> terms{};
+
+                    while (cur_ != end_ && *cur_ != '|' && *cur_ != ')')
+                    {
+                        auto term = parse_term();
+                        if (term < 0)
+                            return -1;
+
+                        terms.push_back(term);
+                    }
+
+                    if (terms.empty())
+                        return add_node(regex_node_type::empty);
+                    else if (terms.size() == 1)
+                        return terms[0];
+
+                    auto concat = add_node(regex_node_type::concat);
+                    nodes_[concat].children = std::move(terms);
+
+                    return concat;
+                }
+
+                int parse_term()
+                {
+                    int assertion{-1};
+
+                    if (accept('^'))
+                    {
+                        assertion = add_node(regex_node_type::bol, multiline());
+                        has_multiline_anchor_ |= multiline();
+                    }
+                    else if (accept('$'))
+                    {
+                        assertion = add_node(regex_node_type::eol, multiline());
+                        has_multiline_anchor_ |= multiline();
+                    }
+                    else if (accept("\\b"))
+                    {
+                        assertion = add_node(regex_node_type::word_boundary);
+                        has_word_boundary_ = true;
+                    }
+                    else if (accept("\\B"))
+                    {
+                        assertion = add_node(regex_node_type::not_word_boundary);
+                        has_word_boundary_ = true;
+                    }
+                    else if (at('(') && (accept("(?=") || accept("(?!")))
+                    {
+                        bool negative = cur_[-1] == '!';
+                        auto body = parse_disjunction();
+                        if (body < 0)
+                            return -1;
+                        if (!accept(')'))
+                            return fail(regex_constants::error_paren);
+
+                        assertion = add_node(regex_node_type::lookahead);
+                        nodes_[assertion].flag = negative;
+                        nodes_[assertion].children.push_back(body);
+                        has_backtracking_ = true;
+                    }
+
+                    if (assertion >= 0)
+                    {
+                        if (at_quantifier())
+                            return fail(regex_constants::error_badrepeat);
+
+                        return assertion;
+                    }
+
+                    auto atom = parse_atom();
+                    if (atom < 0)
+                        return -1;
+
+                    return parse_quantifier(atom);
+                }
+
+                bool at_quantifier() const
+                {
+                    return at('*') || at('+') || at('?') || at('{');
+                }
+
+                bool parse_number(int& res)
+                {
+                    if (cur_ == end_ || *cur_ < '0' || *cur_ > '9')
+                        return false;
+
+                    res = 0;
+                    while (cur_ != end_ && *cur_ >= '0' && *cur_ <= '9')
+                    {
+                        if (res <= max_repeat)
+                            res = res * 10 + (*cur_ - '0');
+                        ++cur_;
+                    }
+
+                    return true;
+                }
+
+                int parse_quantifier(int atom)
+                {
+                    int min{}, max{};
+
+                    if (accept('*'))
+                    {
+                        min = 0;
+                        max = -1;
+                    }
+                    else if (accept('+'))
+                    {
+                        min = 1;
+                        max = -1;
+                    }
+                    else if (accept('?'))
+                    {
+                        min = 0;
+                        max = 1;
+                    }
+                    else if (accept('{'))
+                    {
+                        if (!parse_number(min))
+                            return fail(regex_constants::error_badbrace);
+
+                        max = min;
+                        if (accept(','))
+                        {
+                            if (!parse_number(max))
+                                max = -1;
+                        }
+
+                        if (!accept('}'))
+                            return fail(regex_constants::error_brace);
+                        if (max >= 0 && max < min)
+                            return fail(regex_constants::error_badbrace);
+                        if (min > max_repeat || max > max_repeat)
+                            return fail(regex_constants::error_complexity);
+                    }
+                    else
+                        return atom;
+
+                    auto rep = add_node(regex_node_type::repeat);
+                    nodes_[rep].min = min;
+                    nodes_[rep].max = max;
+                    nodes_[rep].flag = !accept('?');
+                    nodes_[rep].children.push_back(atom);
+
+                    if (at_quantifier())
+                        return fail(regex_constants::error_badrepeat);
+
+                    return rep;
+                }
+
+                int parse_atom()
+                {
+                    auto c = static_cast<unsigned char>(*cur_);
+
+                    switch (c)
+                    {
+                        case '.':
+                        {
+                            ++cur_;
+
+                            regex_class cls{};
+                            cls.invert();
+                            for (unsigned char nl: {'\n', '\r'})
+                                cls.bits[nl >> 5] &= ~(uint32_t{1} << (nl & 31));
+
+                            return add_class(cls);
+                        }
+                        case '(':
+                        {
+                            ++cur_;
+
+                            int group{};
+                            if (!accept("?:"))
+                                group = ++groups_;
+
+                            auto body = parse_disjunction();
+                            if (body < 0)
+                                return -1;
+                            if (!accept(')'))
+                                return fail(regex_constants::error_paren);
+                            if (group == 0)
+                                return body;
+
+                            auto node = add_node(regex_node_type::group, group);
+                            nodes_[node].children.push_back(body);
+
+                            return node;
+                        }
+                        case '[':
+                            ++cur_;
+                            return parse_class();
+                        case '\\':
+                            ++cur_;
+                            return parse_atom_escape();
+                        case '*':
+                        case '+':
+                        case '?':
+                        case '{':
+                            return fail(regex_constants::error_badrepeat);
+                        default:
+                            ++cur_;
+                            return add_char(c);
+                    }
+                }
+
+                bool parse_hex(int digits, int& res)
+                {
+                    res = 0;
+                    for (int i = 0; i < digits; ++i)
+                    {
+                        if (cur_ == end_)
+                            return false;
+
+                        auto c = *cur_++;
+                        if (c >= '0' && c <= '9')
+                            res = res * 16 + (c - '0');
+                        else if (c >= 'a' && c <= 'f')
+                            res = res * 16 + (c - 'a' + 10);
+                        else if (c >= 'A' && c <= 'F')
+                            res = res * 16 + (c - 'A' + 10);
+                        else
+                            return false;
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * Parses an escape that stands for a single character,
+                 * cur_ points past the backslash.
+                 */
+                bool parse_character_escape(unsigned char& res)
+                {
+                    if (cur_ == end_)
+                        return false;
+
+                    auto c = static_cast<unsigned char>(*cur_++);
+                    int value{};
+
+                    switch (c)
+                    {
+                        case 'f':
+                            res = '\f';
+                            return true;
+                        case 'n':
+                            res = '\n';
+                            return true;
+                        case 'r':
+                            res = '\r';
+                            return true;
+                        case 't':
+                            res = '\t';
+                            return true;
+                        case 'v':
+                            res = '\v';
+                            return true;
+                        case '0':
+                            res = '\0';
+                            return true;
+                        case 'c':
+                            if (cur_ == end_ || !((*cur_ >= 'a' && *cur_ <= 'z') ||
+                                                  (*cur_ >= 'A' && *cur_ <= 'Z')))
+                                return false;
+
+                            res = static_cast<unsigned char>(*cur_++ % 32);
+                            return true;
+                        case 'x':
+                            if (!parse_hex(2, value))
+                                return false;
+
+                            res = static_cast<unsigned char>(value);
+                            return true;
+                        case 'u':
+                            if (!parse_hex(4, value) || value > 0xFF)
+                                return false;
+
+                            res = static_cast<unsigned char>(value);
+                            return true;
+                        default:
+                            if (is_word_char(c))
+                                return false;
+
+                            res = c;
+                            return true;
+                    }
+                }
+
+                int parse_atom_escape()
+                {
+                    if (cur_ == end_)
+                        return fail(regex_constants::error_escape);
+
+                    auto c = *cur_;
+                    if (c >= '1' && c <= '9')
+                    {
+                        int group{};
+                        parse_number(group);
+
+                        if (group > max_backref_)
+                            max_backref_ = group;
+                        has_backtracking_ = true;
+
+                        return add_node(regex_node_type::backref, group);
+                    }
+
+                    switch (c)
+                    {
+                        case 'd':
+                        case 'D':
+                        case 'w':
+                        case 'W':
+                        case 's':
+                        case 'S':
+                            ++cur_;
+                            return add_class(make_class(c));
+                    }
+
+                    unsigned char res{};
+                    if (!parse_character_escape(res))
+                        return fail(regex_constants::error_escape);
+
+                    return add_char(res);
+                }
+
+                /**
+                 * Parses a single class atom, returns false if it was
+                 * a class escape (like \d) merged directly into cls.
+                 */
+                bool parse_class_atom(regex_class& cls, unsigned char& res)
+                {
+                    if (accept("[:"))
+                    {
+                        auto start = cur_;
+                        bool closed{};
+                        while (cur_ != end_ && !closed)
+                        {
+                            if (!(closed = accept(":]")))
+                                ++cur_;
+                        }
+
+                        if (!closed)
+                        {
+                            fail(regex_constants::error_brack);
+                            return false;
+                        }
+
+                        string name{start, static_cast<size_t>(cur_ - 2 - start)};
+                        if (!make_posix_class(name, cls))
+                            fail(regex_constants::error_ctype);
+
+                        return false;
+                    }
+
+                    if (accept("[.") || accept("[="))
+                    {
+                        auto kind = cur_[-1];
+                        if (end_ - cur_ < 3 || cur_[1] != kind || cur_[2] != ']')
+                        {
+                            fail(regex_constants::error_collate);
+                            return false;
+                        }
+
+                        res = static_cast<unsigned char>(*cur_);
+                        cur_ += 3;
+                        return true;
+                    }
+
+                    if (!accept('\\'))
+                    {
+                        res = static_cast<unsigned char>(*cur_++);
+                        return true;
+                    }
+
+                    if (cur_ == end_)
+                    {
+                        fail(regex_constants::error_escape);
+                        return false;
+                    }
+
+                    switch (*cur_)
+                    {
+                        case 'd':
+                        case 'D':
+                        case 'w':
+                        case 'W':
+                        case 's':
+                        case 'S':
+                            cls.merge(make_class(*cur_++));
+                            return false;
+                        case 'b':
+                            ++cur_;
+                            res = '\b';
+                            return true;
+                        case '-':
+                            ++cur_;
+                            res = '-';
+                            return true;
+                    }
+
+                    if (!parse_character_escape(res))
+                        fail(regex_constants::error_escape);
+
+                    return true;
+                }
+
+                int parse_class()
+                {
+                    regex_class cls{};
+                    bool negate = accept('^');
+
+                    while (true)
+                    {
+                        if (cur_ == end_)
+                            return fail(regex_constants::error_brack);
+                        if (accept(']'))
+                            break;
+
+                        unsigned char lo{};
+                        bool lo_char = parse_class_atom(cls, lo);
+                        if (error_)
+                            return -1;
+
+                        if (end_ - cur_ >= 2 && cur_[0] == '-' && cur_[1] != ']')
+                        {
+                            ++cur_;
+
+                            unsigned char hi{};
+                            bool hi_char = parse_class_atom(cls, hi);
+                            if (error_)
+                                return -1;
+                            if (!lo_char || !hi_char || lo > hi)
+                                return fail(regex_constants::error_range);
+
+                            cls.set_range(lo, hi);
+                        }
+                        else if (lo_char)
+                            cls.set(lo);
+                    }
+
+                    if (icase())
+                        cls.fold_case();
+                    if (negate)
+                        cls.invert();
+
+                    return add_class(cls);
+                }
+        };
+    }
+
+    namespace
+    {
+        /**
+         * Lazily built DFA over the instructions of a program.
+         * The DFA does not track submatches, it only answers
+         * whether (and for full matches, where) the input matches.
+         */
+        class regex_dfa
+        {
+            public:
+                enum result
+                {
+                    no_match,
+                    match,
+                    gave_up
+                };
+
+                regex_dfa()
+                    : mtx_{}, states_{}, lookup_{}
+                { /* DUMMY BODY */ }
+
+                regex_dfa(const regex_dfa&)
+                    : regex_dfa{}
+                { /* DUMMY BODY */ }
+
+                result run(const vector<regex_instruction>&, const vector<regex_class>&,
+                           const char*, const char*, unsigned int, bool, bool);
+
+            private:
+                static constexpr int unknown{-1};
+                static constexpr size_t max_states{512};
+                static constexpr int max_flushes{8};
+
+                struct state
+                {
+                    vector<int> pcs;
+                    bool accepts;
+                    bool accepts_at_end;
+                    int next[256];
+                };
+
+                struct context
+                {
+                    const vector<regex_instruction>& code;
+                    const vector<regex_class>& classes;
+                    bool anchored;
+                    bool bol_at_start;
+                    bool eol_at_end;
+                };
+
+                mutex mtx_;
+                vector<state> states_;
+                helenos::flat_hash_map<string, int> lookup_;
+
+                void closure(const context&, int, bool, bool, vector<int>&,
+                             vector<bool>&) const;
+                int intern(const context&, vector<int>&, bool);
+                int start_state(const context&, bool);
+                int step(const context&, int, unsigned char);
+        };
+
+        void regex_dfa::closure(const context& ctx, int start, bool bol, bool eol,
+                                vector<int>& res, vector<bool>& seen) const
+        {
+            vector<int> stack{};
+            stack.push_back(start);
+
+            while (!stack.empty())
+            {
+                auto pc = stack.back();
+                stack.pop_back();
+
+                if (seen[pc])
+                    continue;
+                seen[pc] = true;
+
+                const auto& ins = ctx.code[pc];
+                switch (ins.op)
+                {
+                    case op_jmp:
+                        stack.push_back(ins.x);
+                        break;
+                    case op_split:
+                        stack.push_back(ins.y);
+                        stack.push_back(ins.x);
+                        break;
+                    case op_save:
+                    case op_clear:
+                    case op_mark:
+                    case op_check:
+                        /**
+                         * The empty loop check only prunes paths
+                         * that revisit a state, it cannot change
+                         * whether a match exists.
+                         */
+                        stack.push_back(pc + 1);
+                        break;
+                    case op_bol:
+                        if (bol)
+                            stack.push_back(pc + 1);
+                        break;
+                    case op_eol:
+                        if (eol)
+                            stack.push_back(pc + 1);
+                        else
+                            res.push_back(pc);
+                        break;
+                    default:
+                        res.push_back(pc);
+                        break;
+                }
+            }
+        }
+
+        int regex_dfa::intern(const context& ctx, vector<int>& pcs, bool at_start)
+        {
+            sort(pcs.begin(), pcs.end());
+
+            /**
+             * The flags of the context and the position change
+             * how the anchors behave, so they are part of the key.
+             */
+            string key{};
+            key.push_back(static_cast<char>(ctx.anchored | (ctx.bol_at_start << 1) |
+                                            (ctx.eol_at_end << 2) | (at_start << 3)));
+            for (auto pc: pcs)
+                key.append(reinterpret_cast<const char*>(&pc), sizeof(pc));
+
+            auto it = lookup_.find(key);
+            if (it != lookup_.end())
+                return it->second;
+
+            state st{};
+            st.accepts = false;
+            st.accepts_at_end = false;
+            for (auto& next: st.next)
+                next = unknown;
+
+            vector<bool> seen(ctx.code.size(), false);
+            for (auto pc: pcs)
+            {
+                if (ctx.code[pc].op == op_match)
+                    st.accepts = true;
+                else if (ctx.code[pc].op == op_eol && ctx.eol_at_end)
+                {
+                    /**
+                     * Whether the pending end of line assertion
+                     * leads to a match once the input ends.
+                     */
+                    vector<int> tail{};
+                    closure(ctx, pc + 1, at_start && ctx.bol_at_start, true, tail, seen);
+                    for (auto tpc: tail)
+                    {
+                        if (ctx.code[tpc].op == op_match)
+                            st.accepts_at_end = true;
+                    }
+                }
+            }
+            st.accepts_at_end |= st.accepts;
+            st.pcs = std::move(pcs);
+
+            states_.push_back(std::move(st));
+            auto idx = static_cast<int>(states_.size() - 1);
+            lookup_.emplace(std::move(key), idx);
+
+            return idx;
+        }
+
+        int regex_dfa::start_state(const context& ctx, bool at_start)
+        {
+            vector<int> pcs{};
+            vector<bool> seen(ctx.code.size(), false);
+            closure(ctx, 0, at_start && ctx.bol_at_start, false, pcs, seen);
+
+            return intern(ctx, pcs, at_start);
+        }
+
+        int regex_dfa::step(const context& ctx, int from, unsigned char c)
+        {
+            vector<int> pcs{};
+            vector<bool> seen(ctx.code.size(), false);
+
+            for (auto pc: states_[from].pcs)
+            {
+                const auto& ins = ctx.code[pc];
+                bool matches{};
+
+                if (ins.op == op_char)
+                    matches = static_cast<unsigned char>(ins.x) == c;
+                else if (ins.op == op_class)
+                    matches = ctx.classes[ins.x].test(c);
+
+                if (matches)
+                    closure(ctx, pc + 1, false, false, pcs, seen);
+            }
+
+            if (!ctx.anchored)
+                closure(ctx, 0, false, false, pcs, seen);
+
+            auto to = intern(ctx, pcs, false);
+            states_[from].next[c] = to;
+
+            return to;
+        }
+
+        regex_dfa::result regex_dfa::run(const vector<regex_instruction>& code,
+                                         const vector<regex_class>& classes,
+                                         const char* first, const char* last,
+                                         unsigned int flags, bool anchored, bool full)
+        {
+            context ctx{
+                code, classes, anchored,
+                !(flags & (regex_constants::match_not_bol | regex_constants::match_prev_avail)),
+                !(flags & regex_constants::match_not_eol)
+            };
+
+            lock_guard<mutex> lock{mtx_};
+
+            int flushes{};
+            auto current = start_state(ctx, true);
+
+            for (auto it = first; it != last; ++it)
+            {
+                const auto& st = states_[current];
+                if (!full && st.accepts)
+                    return match;
+                if (st.pcs.empty())
+                    return no_match;
+
+                auto c = static_cast<unsigned char>(*it);
+                auto next = st.next[c];
+                if (next == unknown)
+                {
+                    if (states_.size() >= max_states)
+                    {
+                        /**
+                         * The cache is full, start from scratch
+                         * with just the current state.
+                         */
+                        if (++flushes > max_flushes)
+                            return gave_up;
+
+                        auto pcs = std::move(states_[current].pcs);
+                        states_.clear();
+                        lookup_.clear();
+                        current = intern(ctx, pcs, it == first);
+                    }
+
+                    next = step(ctx, current, c);
+                }
+
+                current = next;
+            }
+
+            const auto& st = states_[current];
+            return st.accepts_at_end ? match : no_match;
+        }
+    }
+
+    class regex_program
+    {
+        public:
+            vector<regex_instruction> code;
+            vector<regex_class> classes;
+
+            /**
+             * Number of capture groups reported to the user.
+             */
+            size_t marks;
+
+            /**
+             * Number of capture groups in the program.
+             */
+            size_t groups;
+
+            /**
+             * Total number of slots, the group boundaries
+             * are followed by the empty loop registers.
+             */
+            size_t slots;
+
+            unsigned int flags;
+            bool backtrack;
+            bool use_dfa;
+
+            /**
+             * If every match starts with a character, the set of
+             * those characters lets searches skip ahead quickly.
+             */
+            regex_class first_chars;
+            bool use_first_chars;
+
+            mutable regex_dfa dfa;
+
+            regex_program()
+                : code{}, classes{}, marks{}, groups{}, slots{}, flags{},
+                  backtrack{}, use_dfa{}, first_chars{},
+                  use_first_chars{}, dfa{}
+            { /* DUMMY BODY */ }
+
+            regex_program(const regex_program&) = default;
+    };
+
+    namespace
+    {
+        /**
+         * Translates the AST into the program.
+         */
+        class regex_compiler
+        {
+            public:
+                regex_compiler(const vector<regex_node>& nodes, regex_program& prog,
+                               bool saves)
+                    : nodes_{nodes}, prog_{prog}, saves_{saves}, registers_{},
+                      error_{}
+                { /* DUMMY BODY */ }
+
+                error_type compile(int root)
+                {
+                    emit(op_save, 0);
+                    emit_node(root);
+                    emit(op_save, 1);
+                    emit(op_match);
+
+                    /**
+                     * The registers of the empty loop checks
+                     * follow the group slots.
+                     */
+                    auto base = static_cast<int>(2 * (prog_.groups + 1));
+                    for (auto& ins: prog_.code)
+                    {
+                        if (ins.op == op_mark || ins.op == op_check)
+                            ins.x += base;
+                    }
+                    prog_.slots = base + registers_;
+
+                    if (!error_)
+                        compute_first_chars();
+
+                    return error_;
+                }
+
+            private:
+                const vector<regex_node>& nodes_;
+                regex_program& prog_;
+                bool saves_;
+                int registers_;
+                error_type error_;
+
+                int pc() const
+                {
+                    return static_cast<int>(prog_.code.size());
+                }
+
+                void compute_first_chars()
+                {
+                    vector<bool> seen(prog_.code.size(), false);
+                    vector<int> stack{};
+                    stack.push_back(0);
+
+                    while (!stack.empty())
+                    {
+                        auto pc = stack.back();
+                        stack.pop_back();
+
+                        if (seen[pc])
+                            continue;
+                        seen[pc] = true;
+
+                        const auto& ins = prog_.code[pc];
+                        switch (ins.op)
+                        {
+                            case op_char:
+                                prog_.first_chars.set(static_cast<unsigned char>(ins.x));
+                                break;
+                            case op_class:
+                                prog_.first_chars.merge(prog_.classes[ins.x]);
+                                break;
+                            case op_split:
+                                stack.push_back(ins.y);
+                                stack.push_back(ins.x);
+                                break;
+                            case op_jmp:
+                                stack.push_back(ins.x);
+                                break;
+                            case op_save:
+                            case op_clear:
+                            case op_mark:
+                            case op_check:
+                                stack.push_back(pc + 1);
+                                break;
+                            default:
+                                // Assertions and empty matches do not consume.
+                                return;
+                        }
+                    }
+
+                    prog_.use_first_chars = true;
+                }
+
+                int emit(regex_opcode op, int x = 0, int y = 0)
+                {
+                    if (pc() >= max_program_size)
+                    {
+                        error_ = regex_constants::error_complexity;
+                        return 0;
+                    }
+
+                    prog_.code.push_back(regex_instruction{op, x, y});
+                    return pc() - 1;
+                }
+
+                bool nullable(int idx) const
+                {
+                    const auto& node = nodes_[idx];
+
+                    switch (node.type)
+                    {
+                        case regex_node_type::chr:
+                        case regex_node_type::cls:
+                            return false;
+                        case regex_node_type::concat:
+                            for (auto child: node.children)
+                            {
+                                if (!nullable(child))
+                                    return false;
+                            }
+                            return true;
+                        case regex_node_type::alternation:
+                            for (auto child: node.children)
+                            {
+                                if (nullable(child))
+                                    return true;
+                            }
+                            return false;
+                        case regex_node_type::repeat:
+                            return node.min == 0 || nullable(node.children[0]);
+                        case regex_node_type::group:
+                            return nullable(node.children[0]);
+                        default:
+                            return true;
+                    }
+                }
+
+                void group_range(int idx, int& lo, int& hi) const
+                {
+                    const auto& node = nodes_[idx];
+
+                    if (node.type == regex_node_type::group)
+                    {
+                        if (lo == 0 || node.value < lo)
+                            lo = node.value;
+                        if (node.value > hi)
+                            hi = node.value;
+                    }
+
+                    for (auto child: node.children)
+                        group_range(child, lo, hi);
+                }
+
+                void emit_node(int idx)
+                {
+                    if (error_)
+                        return;
+
+                    const auto& node = nodes_[idx];
+
+                    switch (node.type)
+                    {
+                        case regex_node_type::empty:
+                            break;
+                        case regex_node_type::chr:
+                            emit(op_char, node.value);
+                            break;
+                        case regex_node_type::cls:
+                            emit(op_class, node.value);
+                            break;
+                        case regex_node_type::concat:
+                            for (auto child: node.children)
+                                emit_node(child);
+                            break;
+                        case regex_node_type::alternation:
+                        {
+                            vector<int> jumps{};
+                            auto count = node.children.size();
+
+                            for (size_t i = 0; i + 1 < count; ++i)
+                            {
+                                auto split = emit(op_split);
+                                prog_.code[split].x = pc();
+                                emit_node(node.children[i]);
+                                jumps.push_back(emit(op_jmp));
+                                prog_.code[split].y = pc();
+                            }
+                            emit_node(node.children[count - 1]);
+
+                            for (auto jmp: jumps)
+                                prog_.code[jmp].x = pc();
+                            break;
+                        }
+                        case regex_node_type::repeat:
+                            emit_repeat(node);
+                            break;
+                        case regex_node_type::group:
+                            if (saves_)
+                                emit(op_save, 2 * node.value);
+                            emit_node(node.children[0]);
+                            if (saves_)
+                                emit(op_save, 2 * node.value + 1);
+                            break;
+                        case regex_node_type::bol:
+                            emit(op_bol, node.value);
+                            break;
+                        case regex_node_type::eol:
+                            emit(op_eol, node.value);
+                            break;
+                        case regex_node_type::word_boundary:
+                            emit(op_word_boundary);
+                            break;
+                        case regex_node_type::not_word_boundary:
+                            emit(op_not_word_boundary);
+                            break;
+                        case regex_node_type::backref:
+                            emit(op_backref, node.value);
+                            break;
+                        case regex_node_type::lookahead:
+                        {
+                            auto look = emit(op_lookahead, 0, node.flag);
+                            emit_node(node.children[0]);
+                            emit(op_lookahead_end);
+                            prog_.code[look].x = pc();
+                            break;
+                        }
+                    }
+                }
+
+                /**
+                 * Emits one iteration of a repeated atom, the
+                 * groups inside are reset at its start.
+                 */
+                void emit_iteration(int child, int lo, int hi)
+                {
+                    if (saves_ && lo > 0)
+                        emit(op_clear, 2 * lo, 2 * hi + 1);
+                    emit_node(child);
+                }
+
+                int emit_split(bool greedy)
+                {
+                    auto split = emit(op_split);
+                    if (greedy)
+                        prog_.code[split].x = pc();
+                    else
+                        prog_.code[split].y = pc();
+
+                    return split;
+                }
+
+                void patch_split(int split, bool greedy, int target)
+                {
+                    if (greedy)
+                        prog_.code[split].y = target;
+                    else
+                        prog_.code[split].x = target;
+                }
+
+                void emit_repeat(const regex_node& node)
+                {
+                    auto child = node.children[0];
+                    bool greedy = node.flag;
+                    int lo{}, hi{};
+                    group_range(child, lo, hi);
+
+                    if (node.max == 0)
+                        return;
+
+                    if (node.max < 0)
+                    {
+                        if (!nullable(child) && node.min > 0)
+                        {
+                            // x{n,} as n - 1 copies of x followed by x+.
+                            for (int i = 0; i + 1 < node.min; ++i)
+                                emit_iteration(child, lo, hi);
+
+                            auto loop = pc();
+                            emit_iteration(child, lo, hi);
+                            auto split = emit(op_split);
+                            if (greedy)
+                            {
+                                prog_.code[split].x = loop;
+                                prog_.code[split].y = pc();
+                            }
+                            else
+                            {
+                                prog_.code[split].x = pc();
+                                prog_.code[split].y = loop;
+                            }
+
+                            return;
+                        }
+
+                        for (int i = 0; i < node.min; ++i)
+                            emit_iteration(child, lo, hi);
+
+                        auto loop = emit_split(greedy);
+                        if (nullable(child))
+                        {
+                            // Iterations matching the empty string end the loop.
+                            auto reg = registers_++;
+                            emit(op_mark, reg);
+                            emit_iteration(child, lo, hi);
+                            emit(op_check, reg);
+                        }
+                        else
+                            emit_iteration(child, lo, hi);
+                        emit(op_jmp, loop);
+                        patch_split(loop, greedy, pc());
+
+                        return;
+                    }
+
+                    for (int i = 0; i < node.min; ++i)
+                        emit_iteration(child, lo, hi);
+
+                    vector<int> splits{};
+                    for (int i = node.min; i < node.max && !error_; ++i)
+                    {
+                        splits.push_back(emit_split(greedy));
+                        emit_iteration(child, lo, hi);
+                    }
+
+                    for (auto split: splits)
+                        patch_split(split, greedy, pc());
+                }
+        };
+
+        /**
+         * State shared by the matchers.
+         */
+        struct regex_input
+        {
+            const regex_program& prog;
+            const char* first;
+            const char* last;
+            unsigned int flags;
+            bool full;
+
+            bool assertion(const regex_instruction& ins, const char* pos) const
+            {
+                bool at_first = pos == first &&
+                    !(flags & regex_constants::match_prev_avail);
+
+                switch (ins.op)
+                {
+                    case op_bol:
+                        if (at_first)
+                            return !(flags & regex_constants::match_not_bol);
+                        return ins.x && is_line_terminator(static_cast<unsigned char>(pos[-1]));
+                    case op_eol:
+                        if (pos == last)
+                            return !(flags & regex_constants::match_not_eol);
+                        return ins.x && is_line_terminator(static_cast<unsigned char>(*pos));
+                    case op_word_boundary:
+                    case op_not_word_boundary:
+                    {
+                        bool before = !at_first &&
+                            is_word_char(static_cast<unsigned char>(pos[-1]));
+                        bool after = pos != last &&
+                            is_word_char(static_cast<unsigned char>(*pos));
+
+                        return (before != after) == (ins.op == op_word_boundary);
+                    }
+                    default:
+                        return false;
+                }
+            }
+
+            bool consumes(const regex_instruction& ins, const char* pos) const
+            {
+                if (pos == last)
+                    return false;
+
+                auto c = static_cast<unsigned char>(*pos);
+                if (ins.op == op_char)
+                    return static_cast<unsigned char>(ins.x) == c;
+                else
+                    return prog.classes[ins.x].test(c);
+            }
+
+            /**
+             * Moves pos to the next possible start of a match,
+             * returns false if there is none.
+             */
+            bool skip_to_first_char(const char*& pos) const
+            {
+                if (!prog.use_first_chars)
+                    return true;
+
+                while (pos != last && !prog.first_chars.test(static_cast<unsigned char>(*pos)))
+                    ++pos;
+
+                return pos != last;
+            }
+
+            bool accepts(const ptrdiff_t* caps, const char* pos) const
+            {
+                if (full && pos != last)
+                    return false;
+                if ((flags & regex_constants::match_not_null) && caps[0] == pos - first)
+                    return false;
+
+                return true;
+            }
+        };
+
+        /**
+         * Pike VM, runs all threads of the NFA in lock step. Threads
+         * are kept in priority order so the first thread to reach
+         * the match instruction is the one ECMAScript prefers.
+         */
+        class regex_pike_vm
+        {
+            public:
+                regex_pike_vm(const regex_input& in)
+                    : in_{in}, size_{in.prog.code.size()}, slots_{in.prog.slots},
+                      clist_{size_, slots_}, nlist_{size_, slots_},
+                      work_(slots_, -1), stack_{}
+                { /* DUMMY BODY */ }
+
+                bool run(bool anchored, ptrdiff_t* res)
+                {
+                    bool matched{};
+                    auto clist = &clist_;
+                    auto nlist = &nlist_;
+
+                    for (auto pos = in_.first; ; ++pos)
+                    {
+                        if (clist->count == 0 && !matched && !anchored &&
+                            !in_.skip_to_first_char(pos))
+                            break;
+
+                        if (!matched && (!anchored || pos == in_.first))
+                        {
+                            for (auto& slot: work_)
+                                slot = -1;
+                            add_thread(*clist, 0, pos);
+                        }
+
+                        if (clist->count == 0)
+                            break;
+
+                        nlist->count = 0;
+                        for (size_t i = 0; i < clist->count; ++i)
+                        {
+                            auto pc = clist->dense[i];
+                            const auto& ins = in_.prog.code[pc];
+                            auto caps = &clist->caps[pc * slots_];
+
+                            if (ins.op == op_match)
+                            {
+                                if (!in_.accepts(caps, pos))
+                                    continue;
+
+                                std::memcpy(res, caps, slots_ * sizeof(ptrdiff_t));
+                                matched = true;
+
+                                // Threads of lower priority are cut off.
+                                break;
+                            }
+
+                            // The list also holds the followed empty transitions.
+                            if (ins.op != op_char && ins.op != op_class)
+                                continue;
+
+                            if (in_.consumes(ins, pos))
+                            {
+                                std::memcpy(work_.data(), caps, slots_ * sizeof(ptrdiff_t));
+                                add_thread(*nlist, pc + 1, pos + 1);
+                            }
+                        }
+
+                        swap(clist, nlist);
+                        if (pos == in_.last)
+                            break;
+                    }
+
+                    return matched;
+                }
+
+            private:
+                struct thread_list
+                {
+                    vector<int> dense;
+                    vector<int> sparse;
+                    vector<ptrdiff_t> caps;
+                    size_t count;
+
+                    thread_list(size_t size, size_t slots)
+                        : dense(size, 0), sparse(size, 0),
+                          caps(size * slots, -1), count{}
+                    { /* DUMMY BODY */ }
+
+                    bool contains(int pc) const
+                    {
+                        auto idx = static_cast<size_t>(sparse[pc]);
+
+                        return idx < count && dense[idx] == pc;
+                    }
+
+                    void insert(int pc)
+                    {
+                        sparse[pc] = static_cast<int>(count);
+                        dense[count++] = pc;
+                    }
+                };
+
+                /**
+                 * Work item of add_thread, either an instruction
+                 * to follow or a slot to restore.
+                 */
+                struct stack_entry
+                {
+                    int pc;
+                    int slot;
+                    ptrdiff_t value;
+                };
+
+                const regex_input& in_;
+                size_t size_;
+                size_t slots_;
+                thread_list clist_;
+                thread_list nlist_;
+                vector<ptrdiff_t> work_;
+                vector<stack_entry> stack_;
+
+                void set_slot(int slot, ptrdiff_t value)
+                {
+                    stack_.push_back(stack_entry{-1, slot, work_[slot]});
+                    work_[slot] = value;
+                }
+
+                /**
+                 * Follows the empty transitions from pc and adds
+                 * the reached threads with the submatches in work_.
+                 */
+                void add_thread(thread_list& list, int start, const char* pos)
+                {
+                    auto offset = pos - in_.first;
+                    stack_.push_back(stack_entry{start, -1, 0});
+
+                    while (!stack_.empty())
+                    {
+                        auto entry = stack_.back();
+                        stack_.pop_back();
+
+                        if (entry.slot >= 0)
+                        {
+                            work_[entry.slot] = entry.value;
+                            continue;
+                        }
+
+                        auto pc = entry.pc;
+                        while (!list.contains(pc))
+                        {
+                            list.insert(pc);
+
+                            const auto& ins = in_.prog.code[pc];
+                            bool follow{true};
+
+                            switch (ins.op)
+                            {
+                                case op_jmp:
+                                    pc = ins.x;
+                                    continue;
+                                case op_split:
+                                    stack_.push_back(stack_entry{ins.y, -1, 0});
+                                    pc = ins.x;
+                                    continue;
+                                case op_save:
+                                case op_mark:
+                                    set_slot(ins.x, offset);
+                                    break;
+                                case op_clear:
+                                    for (int slot = ins.x; slot <= ins.y; ++slot)
+                                        set_slot(slot, -1);
+                                    break;
+                                case op_check:
+                                    follow = work_[ins.x] != offset;
+                                    break;
+                                case op_bol:
+                                case op_eol:
+                                case op_word_boundary:
+                                case op_not_word_boundary:
+                                    follow = in_.assertion(ins, pos);
+                                    break;
+                                default:
+                                    std::memcpy(&list.caps[pc * slots_], work_.data(),
+                                                slots_ * sizeof(ptrdiff_t));
+                                    follow = false;
+                                    break;
+                            }
+
+                            if (!follow)
+                                break;
+                            ++pc;
+                        }
+                    }
+                }
+        };
+
+        /**
+         * Backtracking matcher for programs with backreferences
+         * or lookaheads. The choice points are kept on an explicit
+         * stack instead of the call stack.
+         */
+        class regex_backtracker
+        {
+            public:
+                regex_backtracker(const regex_input& in)
+                    : in_{in}, caps_(in.prog.slots, -1), steps_{}
+                { /* DUMMY BODY */ }
+
+                bool run(bool anchored, ptrdiff_t* res)
+                {
+                    auto pos = in_.first;
+                    if (!anchored && !in_.skip_to_first_char(pos))
+                        return false;
+
+                    while (true)
+                    {
+                        for (auto& slot: caps_)
+                            slot = -1;
+
+                        const char* end{};
+                        if (match(0, pos, false, end))
+                        {
+                            std::memcpy(res, caps_.data(), caps_.size() * sizeof(ptrdiff_t));
+                            return true;
+                        }
+
+                        if (anchored || pos == in_.last || steps_ > max_backtrack_steps)
+                            return false;
+
+                        ++pos;
+                        if (!in_.skip_to_first_char(pos))
+                            return false;
+                    }
+                }
+
+            private:
+                struct stack_entry
+                {
+                    int pc;
+                    int slot;
+                    const char* pos;
+                    ptrdiff_t value;
+                };
+
+                const regex_input& in_;
+                vector<ptrdiff_t> caps_;
+                unsigned long steps_;
+
+                static void set_slot(vector<stack_entry>& stack, vector<ptrdiff_t>& caps,
+                                     int slot, ptrdiff_t value)
+                {
+                    stack.push_back(stack_entry{-1, slot, nullptr, caps[slot]});
+                    caps[slot] = value;
+                }
+
+                bool backref(int group, const char*& pos) const
+                {
+                    auto start = caps_[2 * group];
+                    auto end = caps_[2 * group + 1];
+                    if (start < 0 || end < 0)
+                        return true;
+
+                    auto len = end - start;
+                    if (in_.last - pos < len)
+                        return false;
+
+                    auto ref = in_.first + start;
+                    bool icase = in_.prog.flags & regex_constants::icase;
+                    for (ptrdiff_t i = 0; i < len; ++i)
+                    {
+                        auto a = static_cast<unsigned char>(ref[i]);
+                        auto b = static_cast<unsigned char>(pos[i]);
+                        if (a != b && (!icase || to_lower(a) != to_lower(b)))
+                            return false;
+                    }
+
+                    pos += len;
+                    return true;
+                }
+
+                /**
+                 * Matches from pc at pos, in a lookahead the match
+                 * ends at the op_lookahead_end instruction.
+                 */
+                bool match(int start, const char* start_pos, bool lookahead, const char*& end)
+                {
+                    vector<stack_entry> stack{};
+                    stack.push_back(stack_entry{start, -1, start_pos, 0});
+
+                    while (!stack.empty())
+                    {
+                        auto entry = stack.back();
+                        stack.pop_back();
+
+                        if (entry.slot >= 0)
+                        {
+                            caps_[entry.slot] = entry.value;
+                            continue;
+                        }
+
+                        auto pc = entry.pc;
+                        auto pos = entry.pos;
+                        bool alive{true};
+
+                        while (alive)
+                        {
+                            if (++steps_ > max_backtrack_steps)
+                                return false;
+
+                            const auto& ins = in_.prog.code[pc];
+                            auto offset = pos - in_.first;
+
+                            switch (ins.op)
+                            {
+                                case op_char:
+                                case op_class:
+                                    alive = in_.consumes(ins, pos);
+                                    ++pos;
+                                    ++pc;
+                                    break;
+                                case op_split:
+                                    stack.push_back(stack_entry{ins.y, -1, pos, 0});
+                                    pc = ins.x;
+                                    break;
+                                case op_jmp:
+                                    pc = ins.x;
+                                    break;
+                                case op_save:
+                                case op_mark:
+                                    set_slot(stack, caps_, ins.x, offset);
+                                    ++pc;
+                                    break;
+                                case op_clear:
+                                    for (int slot = ins.x; slot <= ins.y; ++slot)
+                                        set_slot(stack, caps_, slot, -1);
+                                    ++pc;
+                                    break;
+                                case op_check:
+                                    alive = caps_[ins.x] != offset;
+                                    ++pc;
+                                    break;
+                                case op_bol:
+                                case op_eol:
+                                case op_word_boundary:
+                                case op_not_word_boundary:
+                                    alive = in_.assertion(ins, pos);
+                                    ++pc;
+                                    break;
+                                case op_backref:
+                                    alive = backref(ins.x, pos);
+                                    ++pc;
+                                    break;
+                                case op_lookahead:
+                                {
+                                    auto saved = caps_;
+                                    const char* look_end{};
+                                    bool found = match(pc + 1, pos, true, look_end);
+
+                                    if (found == static_cast<bool>(ins.y))
+                                    {
+                                        caps_ = std::move(saved);
+                                        alive = false;
+                                        break;
+                                    }
+
+                                    if (ins.y)
+                                        caps_ = std::move(saved);
+                                    else
+                                    {
+                                        // Keep the submatches of the lookahead.
+                                        for (size_t slot = 0; slot < caps_.size(); ++slot)
+                                        {
+                                            if (caps_[slot] != saved[slot])
+                                            {
+                                                stack.push_back(stack_entry{
+                                                    -1, static_cast<int>(slot),
+                                                    nullptr, saved[slot]
+                                                });
+                                            }
+                                        }
+                                    }
+                                    pc = ins.x;
+                                    break;
+                                }
+                                case op_lookahead_end:
+                                    if (lookahead)
+                                    {
+                                        end = pos;
+                                        return true;
+                                    }
+                                    ++pc;
+                                    break;
+                                case op_match:
+                                    if (!lookahead && in_.accepts(caps_.data(), pos))
+                                    {
+                                        end = pos;
+                                        return true;
+                                    }
+                                    alive = false;
+                                    break;
+                            }
+                        }
+                    }
+
+                    return false;
+                }
+        };
+    }
+
+    regex_program* regex_compile(const char* first, const char* last,
+                                 unsigned int flags, error_type& err)
+    {
+        vector<regex_node> nodes{};
+        auto prog = new regex_program{};
+
+        regex_parser parser{first, last, flags, nodes, prog->classes};
+        auto root = parser.parse();
+        err = parser.error();
+
+        if (!err)
+        {
+            bool nosubs = flags & regex_constants::nosubs;
+            bool saves = !nosubs || parser.has_backrefs();
+
+            prog->groups = saves ? parser.groups() : 0;
+            prog->marks = nosubs ? 0 : parser.groups();
+            prog->flags = flags;
+            prog->backtrack = parser.has_backtracking();
+            prog->use_dfa = !prog->backtrack && !parser.has_word_boundary() &&
+                            !parser.has_multiline_anchor();
+
+            regex_compiler compiler{nodes, *prog, saves};
+            err = compiler.compile(root);
+        }
+
+        if (err)
+        {
+            delete prog;
+            return nullptr;
+        }
+
+        return prog;
+    }
+
+    regex_program* regex_copy(const regex_program* prog)
+    {
+        if (!prog)
+            return nullptr;
+
+        return new regex_program{*prog};
+    }
+
+    void regex_destroy(regex_program* prog)
+    {
+        delete prog;
+    }
+
+    size_t regex_mark_count(const regex_program* prog)
+    {
+        if (!prog)
+            return 0;
+
+        return prog->marks;
+    }
+
+    bool regex_execute(const regex_program* prog, const char* first, const char* last,
+                       unsigned int flags, bool full, ptrdiff_t* caps)
+    {
+        if (!prog)
+            return false;
+
+        bool anchored = full || (flags & regex_constants::match_continuous);
+
+        if (prog->use_dfa && !(flags & regex_constants::match_not_null))
+        {
+            auto res = prog->dfa.run(prog->code, prog->classes, first, last,
+                                     flags, anchored, full);
+
+            if (res == regex_dfa::no_match)
+                return false;
+            if (res == regex_dfa::match && !caps)
+                return true;
+        }
+
+        regex_input in{*prog, first, last, flags, full};
+        vector<ptrdiff_t> res(prog->slots, -1);
+        bool matched{};
+
+        if (prog->backtrack)
+            matched = regex_backtracker{in}.run(anchored, res.data());
+        else
+            matched = regex_pike_vm{in}.run(anchored, res.data());
+
+        if (matched && caps)
+        {
+            for (size_t i = 0; i < 2 * (prog->marks + 1); ++i)
+                caps[i] = res[i];
+        }
+
+        return matched;
+    }
+}
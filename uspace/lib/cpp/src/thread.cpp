@@ -32,6 +32,13 @@
 #include <thread>
 #include <utility>
 
+namespace std::hel
+{
+    extern "C" {
+        #include <sysinfo.h>
+    }
+}
+
 namespace std
 {
     thread::thread() noexcept
@@ -119,9 +126,22 @@ namespace std
 
     unsigned thread::hardware_concurrency() noexcept
     {
-        // TODO:
-        __unimplemented();
-        return 0;
+        size_t size{};
+        auto cpus = static_cast<hel::stats_cpu_t*>(
+            hel::sysinfo_get_data("system.cpus", &size)
+        );
+        if (!cpus)
+            return 0;
+
+        unsigned res{};
+        for (size_t i = 0; i < size / sizeof(hel::stats_cpu_t); ++i)
+        {
+            if (cpus[i].active)
+                ++res;
+        }
+        hel::free(cpus);
+
+        return res;
     }
 
     void swap(thread& x, thread& y) noexcept
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief AES and GHASH using the AES-NI and PCLMULQDQ instructions.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <byteorder.h>
+#include "../../../private/arch.h"
+#include "cpu.h"
+
+/* Number of blocks encrypted at once to keep the AES unit busy. */
+#define AES_PARALLEL  4
+
+#define AES_BLOCK_LEN  16
+
+#define aes_op(insn, block, key) \
+	asm ( \
+	    insn " %[k], %[b]\n" \
+	    : [b] "+x" (block) \
+	    : [k] "x" (key) \
+	)
+
+#define clmul(a, b, sel) ({ \
+		xmm_t __res = (a); \
+		asm ( \
+		    "pclmulqdq %[s], %[y], %[x]\n" \
+		    : [x] "+x" (__res) \
+		    : [y] "x" (b), [s] "i" (sel) \
+		); \
+		__res; \
+	})
+
+#define xmm_shl_bytes(val, cnt) ({ \
+		xmm_t __res = (val); \
+		asm ( \
+		    "pslldq %[c], %[x]\n" \
+		    : [x] "+x" (__res) \
+		    : [c] "i" (cnt) \
+		); \
+		__res; \
+	})
+
+#define xmm_shr_bytes(val, cnt) ({ \
+		xmm_t __res = (val); \
+		asm ( \
+		    "psrldq %[c], %[x]\n" \
+		    : [x] "+x" (__res) \
+		    : [c] "i" (cnt) \
+		); \
+		__res; \
+	})
+
+/** Convert the round keys to the byte order of the AES instructions.
+ *
+ * @param ctx AES context.
+ *
+ */
+void __aes_arch_prepare(aes_ctx_t *ctx)
+{
+	for (size_t i = 0; i < 4 * (ctx->rounds + 1); i++) {
+		ctx->enc_key[i] = host2uint32_t_be(ctx->enc_key[i]);
+		ctx->dec_key[i] = host2uint32_t_be(ctx->dec_key[i]);
+	}
+}
+
+/** Encrypt consecutive blocks.
+ *
+ * @param ctx    AES context.
+ * @param input  Input blocks.
+ * @param output Encrypted blocks.
+ * @param blocks Number of blocks.
+ *
+ */
+void __aes_arch_encrypt(const aes_ctx_t *ctx, const uint8_t *input,
+    uint8_t *output, size_t blocks)
+{
+	const uint32_t *rk = ctx->enc_key;
+	unsigned int rounds = ctx->rounds;
+	xmm_t first = xmm_load(rk);
+	xmm_t last = xmm_load(rk + 4 * rounds);
+
+	while (blocks >= AES_PARALLEL) {
+		xmm_t b0 = xmm_load(input) ^ first;
+		xmm_t b1 = xmm_load(input + AES_BLOCK_LEN) ^ first;
+		xmm_t b2 = xmm_load(input + 2 * AES_BLOCK_LEN) ^ first;
+		xmm_t b3 = xmm_load(input + 3 * AES_BLOCK_LEN) ^ first;
+
+		for (unsigned int r = 1; r < rounds; r++) {
+			xmm_t key = xmm_load(rk + 4 * r);
+
+			aes_op("aesenc", b0, key);
+			aes_op("aesenc", b1, key);
+			aes_op("aesenc", b2, key);
+			aes_op("aesenc", b3, key);
+		}
+
+		aes_op("aesenclast", b0, last);
+		aes_op("aesenclast", b1, last);
+		aes_op("aesenclast", b2, last);
+		aes_op("aesenclast", b3, last);
+
+		xmm_store(output, b0);
+		xmm_store(output + AES_BLOCK_LEN, b1);
+		xmm_store(output + 2 * AES_BLOCK_LEN, b2);
+		xmm_store(output + 3 * AES_BLOCK_LEN, b3);
+
+		input += AES_PARALLEL * AES_BLOCK_LEN;
+		output += AES_PARALLEL * AES_BLOCK_LEN;
+		blocks -= AES_PARALLEL;
+	}
+
+	while (blocks-- > 0) {
+		xmm_t b = xmm_load(input) ^ first;
+
+		for (unsigned int r = 1; r < rounds; r++)
+			aes_op("aesenc", b, xmm_load(rk + 4 * r));
+
+		aes_op("aesenclast", b, last);
+		xmm_store(output, b);
+
+		input += AES_BLOCK_LEN;
+		output += AES_BLOCK_LEN;
+	}
+}
+
+/** Decrypt consecutive blocks.
+ *
+ * The decryption round keys are those of the equivalent inverse cipher,
+ * which the AES instructions implement.
+ *
+ * @param ctx    AES context.
+ * @param input  Input blocks.
+ * @param output Decrypted blocks.
+ * @param blocks Number of blocks.
+ *
+ */
+void __aes_arch_decrypt(const aes_ctx_t *ctx, const uint8_t *input,
+    uint8_t *output, size_t blocks)
+{
+	const uint32_t *rk = ctx->dec_key;
+	unsigned int rounds = ctx->rounds;
+	xmm_t first = xmm_load(rk);
+	xmm_t last = xmm_load(rk + 4 * rounds);
+
+	while (blocks >= AES_PARALLEL) {
+		xmm_t b0 = xmm_load(input) ^ first;
+		xmm_t b1 = xmm_load(input + AES_BLOCK_LEN) ^ first;
+		xmm_t b2 = xmm_load(input + 2 * AES_BLOCK_LEN) ^ first;
+		xmm_t b3 = xmm_load(input + 3 * AES_BLOCK_LEN) ^ first;
+
+		for (unsigned int r = 1; r < rounds; r++) {
+			xmm_t key = xmm_load(rk + 4 * r);
+
+			aes_op("aesdec", b0, key);
+			aes_op("aesdec", b1, key);
+			aes_op("aesdec", b2, key);
+			aes_op("aesdec", b3, key);
+		}
+
+		aes_op("aesdeclast", b0, last);
+		aes_op("aesdeclast", b1, last);
+		aes_op("aesdeclast", b2, last);
+		aes_op("aesdeclast", b3, last);
+
+		xmm_store(output, b0);
+		xmm_store(output + AES_BLOCK_LEN, b1);
+		xmm_store(output + 2 * AES_BLOCK_LEN, b2);
+		xmm_store(output + 3 * AES_BLOCK_LEN, b3);
+
+		input += AES_PARALLEL * AES_BLOCK_LEN;
+		output += AES_PARALLEL * AES_BLOCK_LEN;
+		blocks -= AES_PARALLEL;
+	}
+
+	while (blocks-- > 0) {
+		xmm_t b = xmm_load(input) ^ first;
+
+		for (unsigned int r = 1; r < rounds; r++)
+			aes_op("aesdec", b, xmm_load(rk + 4 * r));
+
+		aes_op("aesdeclast", b, last);
+		xmm_store(output, b);
+
+		input += AES_BLOCK_LEN;
+		output += AES_BLOCK_LEN;
+	}
+}
+
+/** Multiply two elements of GF(2^128) in the GCM representation.
+ *
+ * Both operands are byte-reversed. The 256-bit carry-less product is
+ * shifted by one bit to account for the reflected bit order and reduced
+ * modulo x^128 + x^7 + x^2 + x + 1.
+ *
+ * @param a First operand.
+ * @param b Second operand.
+ *
+ * @return Product.
+ *
+ */
+static xmm_t gfmul(xmm_t a, xmm_t b)
+{
+	xmm_t lo = clmul(a, b, 0x00);
+	xmm_t mid = clmul(a, b, 0x10) ^ clmul(a, b, 0x01);
+	xmm_t hi = clmul(a, b, 0x11);
+
+	lo ^= xmm_shl_bytes(mid, 8);
+	hi ^= xmm_shr_bytes(mid, 8);
+
+	/* Shift the product left by one bit. */
+	xmm32_t lo32 = (xmm32_t) lo;
+	xmm32_t hi32 = (xmm32_t) hi;
+	xmm_t lo_carry = (xmm_t) (lo32 >> 31);
+	xmm_t hi_carry = (xmm_t) (hi32 >> 31);
+
+	lo = (xmm_t) (lo32 << 1) | xmm_shl_bytes(lo_carry, 4);
+	hi = (xmm_t) (hi32 << 1) | xmm_shl_bytes(hi_carry, 4) |
+	    xmm_shr_bytes(lo_carry, 12);
+
+	/* Reduce the lower half into the upper half. */
+	lo32 = (xmm32_t) lo;
+	xmm_t fold = (xmm_t) ((lo32 << 31) ^ (lo32 << 30) ^ (lo32 << 25));
+
+	lo ^= xmm_shl_bytes(fold, 12);
+	lo32 = (xmm32_t) lo;
+
+	xmm_t rest = (xmm_t) ((lo32 >> 1) ^ (lo32 >> 2) ^ (lo32 >> 7)) ^
+	    xmm_shr_bytes(fold, 4);
+
+	return hi ^ lo ^ rest;
+}
+
+/** Hash whole blocks into the GHASH accumulator.
+ *
+ * @param h      Hash subkey.
+ * @param y      GHASH accumulator.
+ * @param data   Input blocks.
+ * @param blocks Number of blocks.
+ *
+ */
+void __ghash_arch(const uint8_t *h, uint8_t *y, const uint8_t *data,
+    size_t blocks)
+{
+	const xmm_t reverse = {
+		0x08090a0b0c0d0e0fLL, 0x0001020304050607LL
+	};
+
+	xmm_t hv = xmm_shuffle_bytes(xmm_load(h), reverse);
+	xmm_t yv = xmm_shuffle_bytes(xmm_load(y), reverse);
+
+	while (blocks-- > 0) {
+		xmm_t x = xmm_shuffle_bytes(xmm_load(data), reverse);
+
+		yv = gfmul(yv ^ x, hv);
+		data += AES_BLOCK_LEN;
+	}
+
+	xmm_store(y, xmm_shuffle_bytes(yv, reverse));
+}
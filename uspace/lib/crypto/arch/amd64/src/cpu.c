@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief Detection of the processor cryptographic extensions.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../../../private/arch.h"
+#include "cpu.h"
+
+#define CPUID_FEATURES      1
+#define CPUID_EXT_FEATURES  7
+
+/* Leaf 1, register ECX. */
+#define CPUID_PCLMUL  (1 << 1)
+#define CPUID_SSSE3   (1 << 9)
+#define CPUID_SSE41   (1 << 19)
+#define CPUID_AES     (1 << 25)
+
+/* Leaf 7, register EBX. */
+#define CPUID_SHA  (1 << 29)
+
+/* The features have been detected. */
+#define FEATURES_VALID  (1U << 31)
+
+static unsigned int features;
+
+static uint32_t cpuid(uint32_t leaf, uint32_t *ebx, uint32_t *ecx)
+{
+	uint32_t eax;
+	uint32_t edx;
+
+	asm volatile (
+	    "cpuid\n"
+	    : "=a" (eax), "=b" (*ebx), "=c" (*ecx), "=d" (edx)
+	    : "a" (leaf), "c" (0)
+	);
+
+	return eax;
+}
+
+/** Get the available processor cryptographic extensions.
+ *
+ * The result is computed once and cached.
+ *
+ * @return Combination of the CRYPTO_FEATURE_* flags.
+ *
+ */
+unsigned int __crypto_features(void)
+{
+	if (features != 0)
+		return features;
+
+	uint32_t ebx;
+	uint32_t ecx;
+	unsigned int found = FEATURES_VALID;
+
+	uint32_t max_leaf = cpuid(0, &ebx, &ecx);
+
+	cpuid(CPUID_FEATURES, &ebx, &ecx);
+
+	if ((ecx & CPUID_AES) != 0)
+		found |= CRYPTO_FEATURE_AES;
+
+	if ((ecx & (CPUID_PCLMUL | CPUID_SSSE3)) ==
+	    (CPUID_PCLMUL | CPUID_SSSE3))
+		found |= CRYPTO_FEATURE_PCLMUL;
+
+	if ((max_leaf >= CPUID_EXT_FEATURES) &&
+	    ((ecx & (CPUID_SSSE3 | CPUID_SSE41)) ==
+	    (CPUID_SSSE3 | CPUID_SSE41))) {
+		cpuid(CPUID_EXT_FEATURES, &ebx, &ecx);
+		if ((ebx & CPUID_SHA) != 0)
+			found |= CRYPTO_FEATURE_SHA;
+	}
+
+	features = found;
+	return found;
+}
+
+bool __aes_arch_avail(void)
+{
+	return (__crypto_features() & CRYPTO_FEATURE_AES) != 0;
+}
+
+bool __ghash_arch_avail(void)
+{
+	return (__crypto_features() & CRYPTO_FEATURE_PCLMUL) != 0;
+}
+
+bool __sha256_arch_avail(void)
+{
+	return (__crypto_features() & CRYPTO_FEATURE_SHA) != 0;
+}
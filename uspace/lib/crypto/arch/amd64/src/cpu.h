@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief Processor cryptographic extensions on amd64.
+ */
+
+#ifndef LIBCRYPTO_AMD64_CPU_H_
+#define LIBCRYPTO_AMD64_CPU_H_
+
+#include <stdint.h>
+
+#define CRYPTO_FEATURE_AES     (1 << 0)
+#define CRYPTO_FEATURE_PCLMUL  (1 << 1)
+#define CRYPTO_FEATURE_SHA     (1 << 2)
+
+/** Contents of a SSE register. */
+typedef long long xmm_t __attribute__((vector_size(16)));
+
+/** SSE register viewed as four 32-bit lanes. */
+typedef uint32_t xmm32_t __attribute__((vector_size(16)));
+
+extern unsigned int __crypto_features(void);
+
+static inline xmm_t xmm_load(const void *data)
+{
+	xmm_t val;
+
+	__builtin_memcpy(&val, data, sizeof(val));
+	return val;
+}
+
+static inline void xmm_store(void *data, xmm_t val)
+{
+	__builtin_memcpy(data, &val, sizeof(val));
+}
+
+/** Shuffle bytes of a register (pshufb). */
+static inline xmm_t xmm_shuffle_bytes(xmm_t val, xmm_t mask)
+{
+	asm (
+	    "pshufb %[mask], %[val]\n"
+	    : [val] "+x" (val)
+	    : [mask] "x" (mask)
+	);
+
+	return val;
+}
+
+#endif
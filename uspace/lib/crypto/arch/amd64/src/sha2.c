@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief SHA-256 using the SHA extensions.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../../private/arch.h"
+#include "cpu.h"
+
+#define SHA256_BLOCK_LEN  64
+
+#define sha_op(insn, dst, src) \
+	asm ( \
+	    insn " %[s], %[d]\n" \
+	    : [d] "+x" (dst) \
+	    : [s] "x" (src) \
+	)
+
+#define sha_op_imm(insn, dst, src, imm) \
+	asm ( \
+	    insn " %[i], %[s], %[d]\n" \
+	    : [d] "+x" (dst) \
+	    : [s] "x" (src), [i] "i" (imm) \
+	)
+
+/** Perform two rounds, the message and constants are taken from xmm0. */
+#define sha256_rounds(cdgh, abef, msg) \
+	asm ( \
+	    "sha256rnds2 %[m], %[s], %[d]\n" \
+	    : [d] "+x" (cdgh) \
+	    : [s] "x" (abef), [m] "Yz" (msg) \
+	)
+
+/** Compress consecutive SHA-256 blocks.
+ *
+ * The state is kept in the ABEF and CDGH layout of the instructions.
+ * The schedule words W[4g], ..., W[4g+3] of each group of four rounds
+ * live in msg[g % 4] and are computed three groups ahead.
+ *
+ * @param h      Hash state.
+ * @param k      Round constants.
+ * @param data   Input blocks.
+ * @param blocks Number of blocks.
+ *
+ */
+void __sha256_arch(uint32_t *h, const uint32_t *k, const uint8_t *data,
+    size_t blocks)
+{
+	const xmm_t swap = {
+		0x0405060700010203LL, 0x0c0d0e0f08090a0bLL
+	};
+
+	xmm_t abcd = xmm_load(h);
+	xmm_t efgh = xmm_load(h + 4);
+	xmm_t abef;
+	xmm_t cdgh;
+
+	/* Rearrange the state from ABCD, EFGH to ABEF, CDGH. */
+	abcd = (xmm_t) __builtin_shuffle((xmm32_t) abcd,
+	    (xmm32_t) { 1, 0, 3, 2 });
+	efgh = (xmm_t) __builtin_shuffle((xmm32_t) efgh,
+	    (xmm32_t) { 3, 2, 1, 0 });
+	abef = abcd;
+	sha_op_imm("palignr", abef, efgh, 8);
+	cdgh = efgh;
+	sha_op_imm("pblendw", cdgh, abcd, 0xf0);
+
+	while (blocks-- > 0) {
+		xmm_t abef_save = abef;
+		xmm_t cdgh_save = cdgh;
+		xmm_t msg[4];
+
+		for (unsigned int g = 0; g < 16; g++) {
+			xmm_t *cur = &msg[g % 4];
+
+			if (g < 4) {
+				*cur = xmm_shuffle_bytes(xmm_load(data +
+				    16 * g), swap);
+			}
+
+			xmm_t wk = (xmm_t) ((xmm32_t) *cur +
+			    (xmm32_t) xmm_load(k + 4 * g));
+
+			sha256_rounds(cdgh, abef, wk);
+
+			if ((g >= 3) && (g < 15)) {
+				xmm_t *next = &msg[(g + 1) % 4];
+				xmm_t tmp = *cur;
+
+				sha_op_imm("palignr", tmp, msg[(g + 3) % 4], 4);
+				*next = (xmm_t) ((xmm32_t) *next +
+				    (xmm32_t) tmp);
+				sha_op("sha256msg2", *next, *cur);
+			}
+
+			wk = (xmm_t) __builtin_shuffle((xmm32_t) wk,
+			    (xmm32_t) { 2, 3, 0, 0 });
+			sha256_rounds(abef, cdgh, wk);
+
+			if ((g >= 1) && (g < 13))
+				sha_op("sha256msg1", msg[(g + 3) % 4], *cur);
+		}
+
+		abef = (xmm_t) ((xmm32_t) abef + (xmm32_t) abef_save);
+		cdgh = (xmm_t) ((xmm32_t) cdgh + (xmm32_t) cdgh_save);
+		data += SHA256_BLOCK_LEN;
+	}
+
+	/* Rearrange the state back to ABCD, EFGH. */
+	xmm_t feba = (xmm_t) __builtin_shuffle((xmm32_t) abef,
+	    (xmm32_t) { 3, 2, 1, 0 });
+	xmm_t dchg = (xmm_t) __builtin_shuffle((xmm32_t) cdgh,
+	    (xmm32_t) { 1, 0, 3, 2 });
+
+	abcd = feba;
+	sha_op_imm("pblendw", abcd, dchg, 0xf0);
+	efgh = dchg;
+	sha_op_imm("palignr", efgh, feba, 8);
+
+	xmm_store(h, abcd);
+	xmm_store(h + 4, efgh);
+}
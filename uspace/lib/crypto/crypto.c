@@ -40,7 +40,7 @@
 /** Hash function procedure definition. */
 typedef void (*hash_fnc_t)(uint32_t *, uint32_t *);
 
-/** Length of HMAC block. */
+/** Length of HMAC block (except for SHA-512). */
 #define HMAC_BLOCK_LENGTH  64
 
 /** Ceiling for uint32_t. */
@@ -202,6 +202,24 @@ errno_t create_hash(uint8_t *input, size_t input_size, uint8_t *output,
 	if (!output)
 		return ENOMEM;
 
+	if (hash_sel == HASH_SHA256) {
+		sha256_ctx_t ctx;
+
+		sha256_init(&ctx);
+		sha256_update(&ctx, input, input_size);
+		sha256_final(&ctx, output);
+		return EOK;
+	}
+
+	if (hash_sel == HASH_SHA512) {
+		sha512_ctx_t ctx;
+
+		sha512_init(&ctx);
+		sha512_update(&ctx, input, input_size);
+		sha512_final(&ctx, output);
+		return EOK;
+	}
+
 	hash_fnc_t hash_func = (hash_sel == HASH_MD5) ? md5_proc : sha1_proc;
 
 	/* Prepare scheduled input. */
@@ -274,33 +292,36 @@ errno_t hmac(uint8_t *key, size_t key_size, uint8_t *msg, size_t msg_size,
 	if (!hash)
 		return ENOMEM;
 
-	uint8_t work_key[HMAC_BLOCK_LENGTH];
-	uint8_t o_key_pad[HMAC_BLOCK_LENGTH];
-	uint8_t i_key_pad[HMAC_BLOCK_LENGTH];
+	/* SHA-512 works with longer blocks. */
+	size_t block_len = (hash_sel == HASH_SHA512) ?
+	    SHA512_BLOCK_LENGTH : HMAC_BLOCK_LENGTH;
+
+	uint8_t work_key[SHA512_BLOCK_LENGTH];
+	uint8_t o_key_pad[SHA512_BLOCK_LENGTH];
+	uint8_t i_key_pad[SHA512_BLOCK_LENGTH];
 	uint8_t temp_hash[hash_sel];
-	memset(work_key, 0, HMAC_BLOCK_LENGTH);
+	memset(work_key, 0, block_len);
 
-	if (key_size > HMAC_BLOCK_LENGTH)
+	if (key_size > block_len)
 		create_hash(key, key_size, work_key, hash_sel);
 	else
 		memcpy(work_key, key, key_size);
 
-	for (size_t i = 0; i < HMAC_BLOCK_LENGTH; i++) {
+	for (size_t i = 0; i < block_len; i++) {
 		o_key_pad[i] = work_key[i] ^ 0x5c;
 		i_key_pad[i] = work_key[i] ^ 0x36;
 	}
 
-	uint8_t temp_work[HMAC_BLOCK_LENGTH + max(msg_size, hash_sel)];
-	memcpy(temp_work, i_key_pad, HMAC_BLOCK_LENGTH);
-	memcpy(temp_work + HMAC_BLOCK_LENGTH, msg, msg_size);
+	uint8_t temp_work[block_len + max(msg_size, hash_sel)];
+	memcpy(temp_work, i_key_pad, block_len);
+	memcpy(temp_work + block_len, msg, msg_size);
 
-	create_hash(temp_work, HMAC_BLOCK_LENGTH + msg_size, temp_hash,
-	    hash_sel);
+	create_hash(temp_work, block_len + msg_size, temp_hash, hash_sel);
 
-	memcpy(temp_work, o_key_pad, HMAC_BLOCK_LENGTH);
-	memcpy(temp_work + HMAC_BLOCK_LENGTH, temp_hash, hash_sel);
+	memcpy(temp_work, o_key_pad, block_len);
+	memcpy(temp_work + block_len, temp_hash, hash_sel);
 
-	create_hash(temp_work, HMAC_BLOCK_LENGTH + hash_sel, hash, hash_sel);
+	create_hash(temp_work, block_len + hash_sel, hash, hash_sel);
 
 	return EOK;
 }
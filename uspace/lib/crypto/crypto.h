@@ -30,12 +30,22 @@
 #define LIBCRYPTO_H
 
 #include <errno.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #define AES_CIPHER_LENGTH  16
 #define PBKDF2_KEY_LENGTH  32
 
+/** Maximum number of AES rounds (AES-256). */
+#define AES_MAX_ROUNDS  14
+
+/** Length of the AES-GCM authentication tag. */
+#define AES_GCM_TAG_LENGTH  16
+
+#define SHA256_BLOCK_LENGTH  64
+#define SHA512_BLOCK_LENGTH  128
+
 /* Left rotation for uint32_t. */
 #define rotl_uint32(val, shift) \
 	(((val) << shift) | ((val) >> (32 - shift)))
@@ -47,12 +57,81 @@
 /** Hash function selector and also result hash length indicator. */
 typedef enum {
 	HASH_MD5 =  16,
-	HASH_SHA1 = 20
+	HASH_SHA1 = 20,
+	HASH_SHA256 = 32,
+	HASH_SHA512 = 64
 } hash_func_t;
 
+/** Expanded AES key. */
+typedef struct {
+	/** Encryption round keys. */
+	uint32_t enc_key[4 * (AES_MAX_ROUNDS + 1)];
+	/** Decryption round keys (for the equivalent inverse cipher). */
+	uint32_t dec_key[4 * (AES_MAX_ROUNDS + 1)];
+	/** Number of rounds. */
+	unsigned int rounds;
+	/** Round keys are prepared for the processor AES instructions. */
+	bool arch;
+} aes_ctx_t;
+
+/** AES-GCM context. */
+typedef struct {
+	/** Expanded key. */
+	aes_ctx_t aes;
+	/** Hash subkey. */
+	uint8_t h[AES_CIPHER_LENGTH];
+	/** Multiples of the hash subkey (high and low halves). */
+	uint64_t h_hi[16];
+	uint64_t h_lo[16];
+	/** Hash subkey multiplication is done by the processor. */
+	bool arch;
+} aes_gcm_ctx_t;
+
+/** Incremental SHA-256 context. */
+typedef struct {
+	uint32_t h[8];
+	uint64_t length;
+	uint8_t buffer[SHA256_BLOCK_LENGTH];
+} sha256_ctx_t;
+
+/** Incremental SHA-512 context. */
+typedef struct {
+	uint64_t h[8];
+	uint64_t length;
+	uint8_t buffer[SHA512_BLOCK_LENGTH];
+} sha512_ctx_t;
+
 extern errno_t rc4(uint8_t *, size_t, uint8_t *, size_t, size_t, uint8_t *);
 extern errno_t aes_encrypt(uint8_t *, uint8_t *, uint8_t *);
 extern errno_t aes_decrypt(uint8_t *, uint8_t *, uint8_t *);
+
+extern errno_t aes_init(aes_ctx_t *, const uint8_t *, size_t);
+extern void aes_encrypt_block(const aes_ctx_t *, const uint8_t *, uint8_t *);
+extern void aes_decrypt_block(const aes_ctx_t *, const uint8_t *, uint8_t *);
+extern errno_t aes_ecb_encrypt(const aes_ctx_t *, const uint8_t *, uint8_t *,
+    size_t);
+extern errno_t aes_ecb_decrypt(const aes_ctx_t *, const uint8_t *, uint8_t *,
+    size_t);
+extern errno_t aes_cbc_encrypt(const aes_ctx_t *, uint8_t *, const uint8_t *,
+    uint8_t *, size_t);
+extern errno_t aes_cbc_decrypt(const aes_ctx_t *, uint8_t *, const uint8_t *,
+    uint8_t *, size_t);
+extern void aes_ctr(const aes_ctx_t *, uint8_t *, const uint8_t *, uint8_t *,
+    size_t);
+
+extern errno_t aes_gcm_init(aes_gcm_ctx_t *, const uint8_t *, size_t);
+extern errno_t aes_gcm_encrypt(const aes_gcm_ctx_t *, const uint8_t *, size_t,
+    const uint8_t *, size_t, const uint8_t *, uint8_t *, size_t, uint8_t *);
+extern errno_t aes_gcm_decrypt(const aes_gcm_ctx_t *, const uint8_t *, size_t,
+    const uint8_t *, size_t, const uint8_t *, uint8_t *, size_t,
+    const uint8_t *);
+
+extern void sha256_init(sha256_ctx_t *);
+extern void sha256_update(sha256_ctx_t *, const void *, size_t);
+extern void sha256_final(sha256_ctx_t *, uint8_t *);
+extern void sha512_init(sha512_ctx_t *);
+extern void sha512_update(sha512_ctx_t *, const void *, size_t);
+extern void sha512_final(sha512_ctx_t *, uint8_t *);
 extern errno_t create_hash(uint8_t *, size_t, uint8_t *, hash_func_t);
 extern errno_t hmac(uint8_t *, size_t, uint8_t *, size_t, uint8_t *, hash_func_t);
 extern errno_t pbkdf2(uint8_t *, size_t, uint8_t *, size_t, uint8_t *);
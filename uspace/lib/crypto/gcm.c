@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file gcm.c
+ *
+ * AES in Galois/Counter Mode (NIST SP 800-38D).
+ *
+ * The multiplication by the hash subkey uses a table of its sixteen
+ * multiples and processes four bits at once (Shoup's method). The
+ * processor carry-less multiplication is used instead where available.
+ */
+
+#include <stdbool.h>
+#include <errno.h>
+#include <mem.h>
+#include <macros.h>
+#include "crypto.h"
+#include "private/arch.h"
+
+/* Length of AES block. */
+#define BLOCK_LEN  16
+
+/* Number of blocks processed at once. */
+#define BATCH_BLOCKS  8
+
+/** Reduction of the four bits shifted out of the product. */
+static const uint16_t last4[16] = {
+	0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+	0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+/** Load a big-endian 64-bit word. */
+static uint64_t load_be64(const uint8_t *data)
+{
+	uint64_t val = 0;
+
+	for (size_t i = 0; i < 8; i++)
+		val = (val << 8) | data[i];
+
+	return val;
+}
+
+/** Store a big-endian 64-bit word. */
+static void store_be64(uint8_t *data, uint64_t val)
+{
+	for (size_t i = 8; i-- > 0;) {
+		data[i] = val & 0xff;
+		val >>= 8;
+	}
+}
+
+/** Compute the multiples of the hash subkey.
+ *
+ * @param gctx AES-GCM context with the hash subkey set.
+ *
+ */
+static void gcm_gen_table(aes_gcm_ctx_t *gctx)
+{
+	uint64_t vh = load_be64(gctx->h);
+	uint64_t vl = load_be64(gctx->h + 8);
+
+	gctx->h_hi[0] = 0;
+	gctx->h_lo[0] = 0;
+	gctx->h_hi[8] = vh;
+	gctx->h_lo[8] = vl;
+
+	/* Bits are reflected, so halving means multiplying by x. */
+	for (size_t i = 4; i > 0; i >>= 1) {
+		uint64_t t = (vl & 1) ? 0xe100000000000000ULL : 0;
+
+		vl = (vh << 63) | (vl >> 1);
+		vh = (vh >> 1) ^ t;
+		gctx->h_hi[i] = vh;
+		gctx->h_lo[i] = vl;
+	}
+
+	for (size_t i = 2; i <= 8; i <<= 1) {
+		for (size_t j = 1; j < i; j++) {
+			gctx->h_hi[i + j] = gctx->h_hi[i] ^ gctx->h_hi[j];
+			gctx->h_lo[i + j] = gctx->h_lo[i] ^ gctx->h_lo[j];
+		}
+	}
+}
+
+/** Multiply a block by the hash subkey.
+ *
+ * @param gctx AES-GCM context.
+ * @param x    Block to multiply in place.
+ *
+ */
+static void gcm_mult(const aes_gcm_ctx_t *gctx, uint8_t *x)
+{
+	size_t lo = x[15] & 0x0f;
+	uint64_t zh = gctx->h_hi[lo];
+	uint64_t zl = gctx->h_lo[lo];
+
+	for (size_t i = BLOCK_LEN; i-- > 0;) {
+		size_t hi = x[i] >> 4;
+		size_t rem;
+
+		lo = x[i] & 0x0f;
+
+		if (i != 15) {
+			rem = zl & 0x0f;
+			zl = (zh << 60) | (zl >> 4);
+			zh = (zh >> 4) ^ ((uint64_t) last4[rem] << 48);
+			zh ^= gctx->h_hi[lo];
+			zl ^= gctx->h_lo[lo];
+		}
+
+		rem = zl & 0x0f;
+		zl = (zh << 60) | (zl >> 4);
+		zh = (zh >> 4) ^ ((uint64_t) last4[rem] << 48);
+		zh ^= gctx->h_hi[hi];
+		zl ^= gctx->h_lo[hi];
+	}
+
+	store_be64(x, zh);
+	store_be64(x + 8, zl);
+}
+
+/** Hash data into the GHASH accumulator.
+ *
+ * A trailing partial block is padded with zeroes.
+ *
+ * @param gctx   AES-GCM context.
+ * @param y      GHASH accumulator.
+ * @param data   Data to hash.
+ * @param length Length of the data.
+ *
+ */
+static void gcm_ghash(const aes_gcm_ctx_t *gctx, uint8_t *y,
+    const uint8_t *data, size_t length)
+{
+	size_t blocks = length / BLOCK_LEN;
+
+#ifdef CRYPTO_ARCH
+	if (gctx->arch) {
+		__ghash_arch(gctx->h, y, data, blocks);
+		data += blocks * BLOCK_LEN;
+		length -= blocks * BLOCK_LEN;
+		blocks = 0;
+	}
+#endif
+
+	for (size_t i = 0; i < blocks; i++) {
+		for (size_t j = 0; j < BLOCK_LEN; j++)
+			y[j] ^= data[j];
+
+		gcm_mult(gctx, y);
+		data += BLOCK_LEN;
+		length -= BLOCK_LEN;
+	}
+
+	if (length > 0) {
+		uint8_t block[BLOCK_LEN];
+
+		memset(block, 0, BLOCK_LEN);
+		memcpy(block, data, length);
+		gcm_ghash(gctx, y, block, BLOCK_LEN);
+	}
+}
+
+/** Increment the last 32 bits of a counter block.
+ *
+ * @param counter Counter block.
+ *
+ */
+static void gcm_inc32(uint8_t *counter)
+{
+	for (size_t i = BLOCK_LEN; i-- > BLOCK_LEN - 4;) {
+		if (++counter[i] != 0)
+			break;
+	}
+}
+
+/** Encrypt or decrypt data with the counter mode of GCM.
+ *
+ * @param gctx    AES-GCM context.
+ * @param counter Counter block, updated.
+ * @param input   Input data.
+ * @param output  Output data (may be the same as input).
+ * @param length  Length of the data.
+ *
+ */
+static void gcm_ctr(const aes_gcm_ctx_t *gctx, uint8_t *counter,
+    const uint8_t *input, uint8_t *output, size_t length)
+{
+	uint8_t stream[BATCH_BLOCKS * BLOCK_LEN];
+
+	while (length > 0) {
+		size_t cnt = min(length, sizeof(stream));
+		size_t blocks = (cnt + BLOCK_LEN - 1) / BLOCK_LEN;
+
+		for (size_t i = 0; i < blocks; i++) {
+			memcpy(stream + i * BLOCK_LEN, counter, BLOCK_LEN);
+			gcm_inc32(counter);
+		}
+
+		aes_ecb_encrypt(&gctx->aes, stream, stream,
+		    blocks * BLOCK_LEN);
+
+		for (size_t i = 0; i < cnt; i++)
+			output[i] = input[i] ^ stream[i];
+
+		input += cnt;
+		output += cnt;
+		length -= cnt;
+	}
+}
+
+/** Initialize AES-GCM context.
+ *
+ * @param gctx    AES-GCM context.
+ * @param key     Input key.
+ * @param key_len Length of the key (16, 24 or 32 bytes).
+ *
+ * @return EINVAL when key not specified or of invalid length,
+ *         otherwise EOK.
+ *
+ */
+errno_t aes_gcm_init(aes_gcm_ctx_t *gctx, const uint8_t *key, size_t key_len)
+{
+	errno_t rc = aes_init(&gctx->aes, key, key_len);
+	if (rc != EOK)
+		return rc;
+
+	memset(gctx->h, 0, BLOCK_LEN);
+	aes_encrypt_block(&gctx->aes, gctx->h, gctx->h);
+	gcm_gen_table(gctx);
+
+	gctx->arch = false;
+
+#ifdef CRYPTO_ARCH
+	gctx->arch = __ghash_arch_avail();
+#endif
+
+	return EOK;
+}
+
+/** Compute the pre-counter block and the hash of the additional data.
+ *
+ * @param gctx    AES-GCM context.
+ * @param iv      Initialization vector.
+ * @param iv_len  Length of the initialization vector.
+ * @param aad     Additional authenticated data.
+ * @param aad_len Length of the additional authenticated data.
+ * @param j0      Pre-counter block.
+ * @param y       GHASH accumulator.
+ *
+ */
+static void gcm_start(const aes_gcm_ctx_t *gctx, const uint8_t *iv,
+    size_t iv_len, const uint8_t *aad, size_t aad_len, uint8_t *j0,
+    uint8_t *y)
+{
+	memset(j0, 0, BLOCK_LEN);
+
+	if (iv_len == 12) {
+		memcpy(j0, iv, iv_len);
+		j0[15] = 1;
+	} else {
+		uint8_t len_block[BLOCK_LEN];
+
+		memset(len_block, 0, BLOCK_LEN);
+		store_be64(len_block + 8, (uint64_t) iv_len * 8);
+
+		gcm_ghash(gctx, j0, iv, iv_len);
+		gcm_ghash(gctx, j0, len_block, BLOCK_LEN);
+	}
+
+	memset(y, 0, BLOCK_LEN);
+	gcm_ghash(gctx, y, aad, aad_len);
+}
+
+/** Compute the authentication tag.
+ *
+ * @param gctx    AES-GCM context.
+ * @param j0      Pre-counter block.
+ * @param y       GHASH accumulator of the data.
+ * @param aad_len Length of the additional authenticated data.
+ * @param length  Length of the ciphertext.
+ * @param tag     Authentication tag.
+ *
+ */
+static void gcm_finish(const aes_gcm_ctx_t *gctx, const uint8_t *j0,
+    uint8_t *y, size_t aad_len, size_t length, uint8_t *tag)
+{
+	uint8_t len_block[BLOCK_LEN];
+
+	store_be64(len_block, (uint64_t) aad_len * 8);
+	store_be64(len_block + 8, (uint64_t) length * 8);
+	gcm_ghash(gctx, y, len_block, BLOCK_LEN);
+
+	aes_encrypt_block(&gctx->aes, j0, tag);
+
+	for (size_t i = 0; i < AES_GCM_TAG_LENGTH; i++)
+		tag[i] ^= y[i];
+}
+
+/** Encrypt and authenticate data with AES-GCM.
+ *
+ * @param gctx    AES-GCM context.
+ * @param iv      Initialization vector (12 bytes recommended).
+ * @param iv_len  Length of the initialization vector.
+ * @param aad     Additional authenticated data.
+ * @param aad_len Length of the additional authenticated data.
+ * @param input   Plaintext.
+ * @param output  Ciphertext (may be the same as input).
+ * @param length  Length of the data.
+ * @param tag     Authentication tag (AES_GCM_TAG_LENGTH bytes).
+ *
+ * @return EINVAL when the initialization vector is empty,
+ *         otherwise EOK.
+ *
+ */
+errno_t aes_gcm_encrypt(const aes_gcm_ctx_t *gctx, const uint8_t *iv,
+    size_t iv_len, const uint8_t *aad, size_t aad_len, const uint8_t *input,
+    uint8_t *output, size_t length, uint8_t *tag)
+{
+	uint8_t j0[BLOCK_LEN];
+	uint8_t counter[BLOCK_LEN];
+	uint8_t y[BLOCK_LEN];
+
+	if (iv_len == 0)
+		return EINVAL;
+
+	gcm_start(gctx, iv, iv_len, aad, aad_len, j0, y);
+
+	memcpy(counter, j0, BLOCK_LEN);
+	gcm_inc32(counter);
+	gcm_ctr(gctx, counter, input, output, length);
+
+	gcm_ghash(gctx, y, output, length);
+	gcm_finish(gctx, j0, y, aad_len, length, tag);
+
+	return EOK;
+}
+
+/** Verify and decrypt data with AES-GCM.
+ *
+ * The tag is verified before any plaintext is produced.
+ *
+ * @param gctx    AES-GCM context.
+ * @param iv      Initialization vector.
+ * @param iv_len  Length of the initialization vector.
+ * @param aad     Additional authenticated data.
+ * @param aad_len Length of the additional authenticated data.
+ * @param input   Ciphertext.
+ * @param output  Plaintext (may be the same as input).
+ * @param length  Length of the data.
+ * @param tag     Expected authentication tag (AES_GCM_TAG_LENGTH bytes).
+ *
+ * @return EINVAL when the initialization vector is empty,
+ *         EBADCHECKSUM when the authentication tag does not match,
+ *         otherwise EOK.
+ *
+ */
+errno_t aes_gcm_decrypt(const aes_gcm_ctx_t *gctx, const uint8_t *iv,
+    size_t iv_len, const uint8_t *aad, size_t aad_len, const uint8_t *input,
+    uint8_t *output, size_t length, const uint8_t *tag)
+{
+	uint8_t j0[BLOCK_LEN];
+	uint8_t counter[BLOCK_LEN];
+	uint8_t y[BLOCK_LEN];
+	uint8_t computed[AES_GCM_TAG_LENGTH];
+
+	if (iv_len == 0)
+		return EINVAL;
+
+	gcm_start(gctx, iv, iv_len, aad, aad_len, j0, y);
+	gcm_ghash(gctx, y, input, length);
+	gcm_finish(gctx, j0, y, aad_len, length, computed);
+
+	/* Compare in constant time not to reveal the matching prefix. */
+	uint8_t diff = 0;
+	for (size_t i = 0; i < AES_GCM_TAG_LENGTH; i++)
+		diff |= computed[i] ^ tag[i];
+
+	if (diff != 0)
+		return EBADCHECKSUM;
+
+	memcpy(counter, j0, BLOCK_LEN);
+	gcm_inc32(counter);
+	gcm_ctr(gctx, counter, input, output, length);
+
+	return EOK;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief Architecture-specific acceleration of the cryptographic functions.
+ *
+ * Architectures providing the functions define CRYPTO_ARCH. Each group
+ * of functions may be used only after its availability was checked.
+ */
+
+#ifndef LIBCRYPTO_PRIVATE_ARCH_H_
+#define LIBCRYPTO_PRIVATE_ARCH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../crypto.h"
+
+#ifdef CRYPTO_ARCH
+
+extern bool __aes_arch_avail(void);
+extern void __aes_arch_prepare(aes_ctx_t *);
+extern void __aes_arch_encrypt(const aes_ctx_t *, const uint8_t *, uint8_t *,
+    size_t);
+extern void __aes_arch_decrypt(const aes_ctx_t *, const uint8_t *, uint8_t *,
+    size_t);
+
+extern bool __ghash_arch_avail(void);
+extern void __ghash_arch(const uint8_t *, uint8_t *, const uint8_t *, size_t);
+
+extern bool __sha256_arch_avail(void);
+extern void __sha256_arch(uint32_t *, const uint32_t *, const uint8_t *,
+    size_t);
+
+#endif
+
+#endif
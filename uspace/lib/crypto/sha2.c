@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file sha2.c
+ *
+ * SHA-256 and SHA-512 hash functions (FIPS 180-4).
+ *
+ * Input is compressed directly from the caller buffer whenever whole
+ * blocks are available; only the unaligned head and tail are copied into
+ * the context. The processor SHA instructions are used for SHA-256 where
+ * available.
+ */
+
+#include <mem.h>
+#include "crypto.h"
+#include "private/arch.h"
+
+/* Right rotation for uint64_t. */
+#define rotr_uint64(val, shift) \
+	(((val) >> shift) | ((val) << (64 - shift)))
+
+/** SHA-256 round constants. */
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/** SHA-512 round constants. */
+static const uint64_t sha512_k[80] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL,
+	0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+	0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+	0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+	0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+	0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL,
+	0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+	0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+	0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+	0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL,
+	0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL,
+	0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+	0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+	0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+	0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL,
+	0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL,
+	0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+	0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+	0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+	0xd192e819d6ef5218ULL, 0xd69906245565a910ULL,
+	0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+	0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+	0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+	0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+	0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL,
+	0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL,
+	0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+	0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+	0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+	0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+	0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL, 0x32caab7b40c72493ULL,
+	0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+	0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+	0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+/** Load a big-endian 32-bit word. */
+static inline uint32_t load_be32(const uint8_t *data)
+{
+	return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) |
+	    ((uint32_t) data[2] << 8) | data[3];
+}
+
+/** Load a big-endian 64-bit word. */
+static inline uint64_t load_be64(const uint8_t *data)
+{
+	return ((uint64_t) load_be32(data) << 32) | load_be32(data + 4);
+}
+
+/** Store a big-endian 32-bit word. */
+static inline void store_be32(uint8_t *data, uint32_t val)
+{
+	data[0] = val >> 24;
+	data[1] = val >> 16;
+	data[2] = val >> 8;
+	data[3] = val;
+}
+
+/** Store a big-endian 64-bit word. */
+static inline void store_be64(uint8_t *data, uint64_t val)
+{
+	store_be32(data, val >> 32);
+	store_be32(data + 4, val);
+}
+
+/** Compress consecutive SHA-256 blocks.
+ *
+ * @param h      Hash state.
+ * @param data   Input blocks.
+ * @param blocks Number of blocks.
+ *
+ */
+static void sha256_compress(uint32_t *h, const uint8_t *data, size_t blocks)
+{
+#ifdef CRYPTO_ARCH
+	if (__sha256_arch_avail()) {
+		__sha256_arch(h, sha256_k, data, blocks);
+		return;
+	}
+#endif
+
+	uint32_t w[16];
+
+	while (blocks-- > 0) {
+		uint32_t a = h[0];
+		uint32_t b = h[1];
+		uint32_t c = h[2];
+		uint32_t d = h[3];
+		uint32_t e = h[4];
+		uint32_t f = h[5];
+		uint32_t g = h[6];
+		uint32_t hh = h[7];
+
+		for (size_t i = 0; i < 64; i++) {
+			/* The message schedule is kept in a 16-word window. */
+			if (i < 16) {
+				w[i] = load_be32(data + 4 * i);
+			} else {
+				uint32_t w15 = w[(i - 15) & 15];
+				uint32_t w2 = w[(i - 2) & 15];
+				uint32_t s0 = rotr_uint32(w15, 7) ^
+				    rotr_uint32(w15, 18) ^ (w15 >> 3);
+				uint32_t s1 = rotr_uint32(w2, 17) ^
+				    rotr_uint32(w2, 19) ^ (w2 >> 10);
+
+				w[i & 15] += s0 + w[(i - 7) & 15] + s1;
+			}
+
+			uint32_t s1 = rotr_uint32(e, 6) ^ rotr_uint32(e, 11) ^
+			    rotr_uint32(e, 25);
+			uint32_t ch = (e & f) ^ (~e & g);
+			uint32_t t1 = hh + s1 + ch + sha256_k[i] + w[i & 15];
+			uint32_t s0 = rotr_uint32(a, 2) ^ rotr_uint32(a, 13) ^
+			    rotr_uint32(a, 22);
+			uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+			uint32_t t2 = s0 + maj;
+
+			hh = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		h[0] += a;
+		h[1] += b;
+		h[2] += c;
+		h[3] += d;
+		h[4] += e;
+		h[5] += f;
+		h[6] += g;
+		h[7] += hh;
+
+		data += SHA256_BLOCK_LENGTH;
+	}
+}
+
+/** Compress consecutive SHA-512 blocks.
+ *
+ * @param h      Hash state.
+ * @param data   Input blocks.
+ * @param blocks Number of blocks.
+ *
+ */
+static void sha512_compress(uint64_t *h, const uint8_t *data, size_t blocks)
+{
+	uint64_t w[16];
+
+	while (blocks-- > 0) {
+		uint64_t a = h[0];
+		uint64_t b = h[1];
+		uint64_t c = h[2];
+		uint64_t d = h[3];
+		uint64_t e = h[4];
+		uint64_t f = h[5];
+		uint64_t g = h[6];
+		uint64_t hh = h[7];
+
+		for (size_t i = 0; i < 80; i++) {
+			/* The message schedule is kept in a 16-word window. */
+			if (i < 16) {
+				w[i] = load_be64(data + 8 * i);
+			} else {
+				uint64_t w15 = w[(i - 15) & 15];
+				uint64_t w2 = w[(i - 2) & 15];
+				uint64_t s0 = rotr_uint64(w15, 1) ^
+				    rotr_uint64(w15, 8) ^ (w15 >> 7);
+				uint64_t s1 = rotr_uint64(w2, 19) ^
+				    rotr_uint64(w2, 61) ^ (w2 >> 6);
+
+				w[i & 15] += s0 + w[(i - 7) & 15] + s1;
+			}
+
+			uint64_t s1 = rotr_uint64(e, 14) ^ rotr_uint64(e, 18) ^
+			    rotr_uint64(e, 41);
+			uint64_t ch = (e & f) ^ (~e & g);
+			uint64_t t1 = hh + s1 + ch + sha512_k[i] + w[i & 15];
+			uint64_t s0 = rotr_uint64(a, 28) ^ rotr_uint64(a, 34) ^
+			    rotr_uint64(a, 39);
+			uint64_t maj = (a & b) ^ (a & c) ^ (b & c);
+			uint64_t t2 = s0 + maj;
+
+			hh = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		h[0] += a;
+		h[1] += b;
+		h[2] += c;
+		h[3] += d;
+		h[4] += e;
+		h[5] += f;
+		h[6] += g;
+		h[7] += hh;
+
+		data += SHA512_BLOCK_LENGTH;
+	}
+}
+
+/** Initialize SHA-256 context.
+ *
+ * @param ctx SHA-256 context.
+ *
+ */
+void sha256_init(sha256_ctx_t *ctx)
+{
+	ctx->h[0] = 0x6a09e667;
+	ctx->h[1] = 0xbb67ae85;
+	ctx->h[2] = 0x3c6ef372;
+	ctx->h[3] = 0xa54ff53a;
+	ctx->h[4] = 0x510e527f;
+	ctx->h[5] = 0x9b05688c;
+	ctx->h[6] = 0x1f83d9ab;
+	ctx->h[7] = 0x5be0cd19;
+	ctx->length = 0;
+}
+
+/** Hash more data with SHA-256.
+ *
+ * @param ctx    SHA-256 context.
+ * @param data   Input data.
+ * @param length Length of the data.
+ *
+ */
+void sha256_update(sha256_ctx_t *ctx, const void *data, size_t length)
+{
+	const uint8_t *input = data;
+	size_t used = ctx->length % SHA256_BLOCK_LENGTH;
+
+	ctx->length += length;
+
+	if (used > 0) {
+		size_t cnt = SHA256_BLOCK_LENGTH - used;
+
+		if (length < cnt) {
+			memcpy(ctx->buffer + used, input, length);
+			return;
+		}
+
+		memcpy(ctx->buffer + used, input, cnt);
+		sha256_compress(ctx->h, ctx->buffer, 1);
+		input += cnt;
+		length -= cnt;
+	}
+
+	size_t blocks = length / SHA256_BLOCK_LENGTH;
+	if (blocks > 0) {
+		sha256_compress(ctx->h, input, blocks);
+		input += blocks * SHA256_BLOCK_LENGTH;
+		length -= blocks * SHA256_BLOCK_LENGTH;
+	}
+
+	memcpy(ctx->buffer, input, length);
+}
+
+/** Finish SHA-256 hash.
+ *
+ * @param ctx  SHA-256 context.
+ * @param hash Output hash (HASH_SHA256 bytes).
+ *
+ */
+void sha256_final(sha256_ctx_t *ctx, uint8_t *hash)
+{
+	size_t used = ctx->length % SHA256_BLOCK_LENGTH;
+	uint64_t bits = ctx->length * 8;
+
+	ctx->buffer[used++] = 0x80;
+
+	if (used > SHA256_BLOCK_LENGTH - 8) {
+		memset(ctx->buffer + used, 0, SHA256_BLOCK_LENGTH - used);
+		sha256_compress(ctx->h, ctx->buffer, 1);
+		used = 0;
+	}
+
+	memset(ctx->buffer + used, 0, SHA256_BLOCK_LENGTH - 8 - used);
+	store_be64(ctx->buffer + SHA256_BLOCK_LENGTH - 8, bits);
+	sha256_compress(ctx->h, ctx->buffer, 1);
+
+	for (size_t i = 0; i < 8; i++)
+		store_be32(hash + 4 * i, ctx->h[i]);
+}
+
+/** Initialize SHA-512 context.
+ *
+ * @param ctx SHA-512 context.
+ *
+ */
+void sha512_init(sha512_ctx_t *ctx)
+{
+	ctx->h[0] = 0x6a09e667f3bcc908ULL;
+	ctx->h[1] = 0xbb67ae8584caa73bULL;
+	ctx->h[2] = 0x3c6ef372fe94f82bULL;
+	ctx->h[3] = 0xa54ff53a5f1d36f1ULL;
+	ctx->h[4] = 0x510e527fade682d1ULL;
+	ctx->h[5] = 0x9b05688c2b3e6c1fULL;
+	ctx->h[6] = 0x1f83d9abfb41bd6bULL;
+	ctx->h[7] = 0x5be0cd19137e2179ULL;
+	ctx->length = 0;
+}
+
+/** Hash more data with SHA-512.
+ *
+ * @param ctx    SHA-512 context.
+ * @param data   Input data.
+ * @param length Length of the data.
+ *
+ */
+void sha512_update(sha512_ctx_t *ctx, const void *data, size_t length)
+{
+	const uint8_t *input = data;
+	size_t used = ctx->length % SHA512_BLOCK_LENGTH;
+
+	ctx->length += length;
+
+	if (used > 0) {
+		size_t cnt = SHA512_BLOCK_LENGTH - used;
+
+		if (length < cnt) {
+			memcpy(ctx->buffer + used, input, length);
+			return;
+		}
+
+		memcpy(ctx->buffer + used, input, cnt);
+		sha512_compress(ctx->h, ctx->buffer, 1);
+		input += cnt;
+		length -= cnt;
+	}
+
+	size_t blocks = length / SHA512_BLOCK_LENGTH;
+	if (blocks > 0) {
+		sha512_compress(ctx->h, input, blocks);
+		input += blocks * SHA512_BLOCK_LENGTH;
+		length -= blocks * SHA512_BLOCK_LENGTH;
+	}
+
+	memcpy(ctx->buffer, input, length);
+}
+
+/** Finish SHA-512 hash.
+ *
+ * @param ctx  SHA-512 context.
+ * @param hash Output hash (HASH_SHA512 bytes).
+ *
+ */
+void sha512_final(sha512_ctx_t *ctx, uint8_t *hash)
+{
+	size_t used = ctx->length % SHA512_BLOCK_LENGTH;
+	uint64_t bits = ctx->length * 8;
+
+	ctx->buffer[used++] = 0x80;
+
+	if (used > SHA512_BLOCK_LENGTH - 16) {
+		memset(ctx->buffer + used, 0, SHA512_BLOCK_LENGTH - used);
+		sha512_compress(ctx->h, ctx->buffer, 1);
+		used = 0;
+	}
+
+	/* The upper half of the 128-bit length is always zero here. */
+	memset(ctx->buffer + used, 0, SHA512_BLOCK_LENGTH - 8 - used);
+	store_be64(ctx->buffer + SHA512_BLOCK_LENGTH - 8, bits);
+	sha512_compress(ctx->h, ctx->buffer, 1);
+
+	for (size_t i = 0; i < 8; i++)
+		store_be64(hash + 8 * i, ctx->h[i]);
+}
@@ -36,9 +36,13 @@
 #include <assert.h>
 #include <adt/list.h>
 #include <stdlib.h>
+#include <macros.h>
 
 #include "drawctx.h"
 
+/** Number of source pixels sampled before they are composed */
+#define TRANSFER_CHUNK  64
+
 void drawctx_init(drawctx_t *context, surface_t *surface)
 {
 	assert(surface);
@@ -128,25 +132,50 @@ void drawctx_transfer(drawctx_t *context,
 		return;
 	}
 
-	bool transfer_fast = source_is_fast(context->source) &&
+	compose_span_t compose_span = compose_get_span(context->compose);
+	bool transfer_span = (compose_span != NULL) &&
 	    (context->shall_clip == false) &&
-	    (context->mask == NULL) &&
-	    (context->compose == compose_src || context->compose == compose_over);
+	    (context->mask == NULL);
+	bool transfer_fast = transfer_span && source_is_fast(context->source);
+	pixelmap_t *pixmap = surface_pixmap_access(context->surface);
 
 	if (transfer_fast) {
 
 		for (sysarg_t _y = y; _y < y + height; ++_y) {
 			pixel_t *src = source_direct_access(context->source, x, _y);
-			pixel_t *dst = pixelmap_pixel_at(surface_pixmap_access(context->surface), x, _y);
-			if (src && dst) {
-				sysarg_t count = width;
-				while (count-- != 0) {
-					*dst++ = *src++;
-				}
-			}
+			pixel_t *dst = pixelmap_pixel_at(pixmap, x, _y);
+			if (src && dst)
+				compose_span(dst, src, width);
 		}
 		surface_add_damaged_region(context->surface, x, y, width, height);
 
+	} else if (transfer_span) {
+
+		/* Sample the source by chunks and compose them at once. */
+		pixel_t buf[TRANSFER_CHUNK];
+
+		for (sysarg_t _y = y; _y < y + height; ++_y) {
+			sysarg_t _x = x;
+
+			while (_x < x + width) {
+				pixel_t *dst = pixelmap_pixel_at(pixmap,
+				    _x, _y);
+				if (dst == NULL)
+					break;
+
+				/* Do not let the chunk wrap to the next row. */
+				sysarg_t end = min(x + width, pixmap->width);
+				sysarg_t count = min(end - _x, TRANSFER_CHUNK);
+
+				source_determine_span(context->source, _x, _y,
+				    buf, count);
+				compose_span(dst, buf, count);
+				_x += count;
+			}
+		}
+		surface_add_damaged_region(context->surface,
+		    x, y, width, height);
+
 	} else {
 
 		bool clipped = false;
@@ -51,6 +51,9 @@ font_t *font_create(font_backend_t *backend, void *backend_data)
 	font->backend = backend;
 	font->backend_data = backend_data;
 
+	for (size_t i = 0; i < FONT_GLYPH_CACHE_SIZE; ++i)
+		font->glyph_cache[i].valid = false;
+
 	return font;
 }
 
@@ -83,6 +86,49 @@ errno_t font_render_glyph(font_t *font, drawctx_t *context, source_t *source,
 	    x, y, glyph_id);
 }
 
+/** Resolve a character to a glyph and get its metrics.
+ *
+ * The characters which are not covered by the font are resolved to
+ * the replacement character. Text is typically drawn from a small set
+ * of characters, so the result is kept in a direct-mapped cache and
+ * the backend is asked only on a miss.
+ *
+ * @param font          Font
+ * @param c             Character
+ * @param glyph_id      Place to store the glyph
+ * @param glyph_metrics Place to store the glyph metrics
+ * @return EOK on success or an error code
+ */
+static errno_t font_lookup_glyph(font_t *font, wchar_t c,
+    glyph_id_t *glyph_id, glyph_metrics_t *glyph_metrics)
+{
+	font_glyph_cache_item_t *item =
+	    &font->glyph_cache[c % FONT_GLYPH_CACHE_SIZE];
+
+	if ((item->valid) && (item->ch == c)) {
+		*glyph_id = item->glyph_id;
+		*glyph_metrics = item->metrics;
+		return EOK;
+	}
+
+	errno_t rc = font_resolve_glyph(font, c, glyph_id);
+	if (rc != EOK) {
+		errno_t rc2 = font_resolve_glyph(font, U_SPECIAL, glyph_id);
+		if (rc2 != EOK)
+			return rc;
+	}
+
+	rc = font_get_glyph_metrics(font, *glyph_id, glyph_metrics);
+	if (rc != EOK)
+		return rc;
+
+	item->valid = true;
+	item->ch = c;
+	item->glyph_id = *glyph_id;
+	item->metrics = *glyph_metrics;
+	return EOK;
+}
+
 /* TODO this is bad interface */
 errno_t font_get_box(font_t *font, char *text, sysarg_t *width, sysarg_t *height)
 {
@@ -100,16 +146,8 @@ errno_t font_get_box(font_t *font, char *text, sysarg_t *width, sysarg_t *height
 			break;
 
 		glyph_id_t glyph_id;
-		rc = font_resolve_glyph(font, c, &glyph_id);
-		if (rc != EOK) {
-			errno_t rc2 = font_resolve_glyph(font, U_SPECIAL, &glyph_id);
-			if (rc2 != EOK) {
-				return rc;
-			}
-		}
-
 		glyph_metrics_t glyph_metrics;
-		rc = font_get_glyph_metrics(font, glyph_id, &glyph_metrics);
+		rc = font_lookup_glyph(font, c, &glyph_id, &glyph_metrics);
 		if (rc != EOK)
 			return rc;
 
@@ -143,16 +181,8 @@ errno_t font_draw_text(font_t *font, drawctx_t *context, source_t *source,
 			break;
 
 		glyph_id_t glyph_id;
-		rc = font_resolve_glyph(font, c, &glyph_id);
-		if (rc != EOK) {
-			errno_t rc2 = font_resolve_glyph(font, U_SPECIAL, &glyph_id);
-			if (rc2 != EOK) {
-				return rc;
-			}
-		}
-
 		glyph_metrics_t glyph_metrics;
-		rc = font_get_glyph_metrics(font, glyph_id, &glyph_metrics);
+		rc = font_lookup_glyph(font, c, &glyph_id, &glyph_metrics);
 		if (rc != EOK)
 			return rc;
 
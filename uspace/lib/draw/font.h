@@ -37,6 +37,7 @@
 #ifndef DRAW_FONT_H_
 #define DRAW_FONT_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "surface.h"
@@ -102,9 +103,23 @@ typedef struct {
 	void (*release)(void *);
 } font_backend_t;
 
+/** Number of entries of the glyph lookup cache of a font */
+#define FONT_GLYPH_CACHE_SIZE  256
+
+/** Glyph lookup cache entry */
+typedef struct {
+	bool valid;
+	wchar_t ch;
+	glyph_id_t glyph_id;
+	glyph_metrics_t metrics;
+} font_glyph_cache_item_t;
+
 typedef struct {
 	font_backend_t *backend;
 	void *backend_data;
+
+	/** Resolved glyphs and their metrics indexed by the character */
+	font_glyph_cache_item_t glyph_cache[FONT_GLYPH_CACHE_SIZE];
 } font_t;
 
 extern font_t *font_create(font_backend_t *, void *);
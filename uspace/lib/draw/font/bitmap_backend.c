@@ -36,12 +36,17 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <adt/list.h>
 
 #include "../font.h"
 #include "../drawctx.h"
 #include "bitmap_backend.h"
 
+/** Maximum number of glyph surfaces kept in the cache */
+#define GLYPH_SURFACES_MAX  512
+
 typedef struct {
+	link_t link;
 	surface_t *surface;
 	glyph_metrics_t metrics;
 	bool metrics_loaded;
@@ -52,6 +57,8 @@ typedef struct {
 	uint32_t glyph_count;
 	font_metrics_t font_metrics;
 	glyph_cache_item_t *glyph_cache;
+	list_t glyph_surfaces;  /**< Cached surfaces, most recent first */
+	size_t glyph_surfaces_count;
 	bitmap_font_decoder_t *decoder;
 	void *decoder_data;
 	bool scale;
@@ -112,14 +119,41 @@ static errno_t bb_get_glyph_metrics(void *backend_data, glyph_id_t glyph_id,
 	return EOK;
 }
 
+/** Store a glyph surface in the cache.
+ *
+ * If the cache is full, the least recently used surface is evicted.
+ */
+static void cache_glyph_surface(bitmap_backend_data_t *data,
+    glyph_id_t glyph_id, surface_t *surface)
+{
+	if (data->glyph_surfaces_count >= GLYPH_SURFACES_MAX) {
+		glyph_cache_item_t *lru = list_get_instance(
+		    list_last(&data->glyph_surfaces), glyph_cache_item_t, link);
+
+		list_remove(&lru->link);
+		surface_destroy(lru->surface);
+		lru->surface = NULL;
+		data->glyph_surfaces_count--;
+	}
+
+	data->glyph_cache[glyph_id].surface = surface;
+	list_prepend(&data->glyph_cache[glyph_id].link, &data->glyph_surfaces);
+	data->glyph_surfaces_count++;
+}
+
 static errno_t get_glyph_surface(bitmap_backend_data_t *data, glyph_id_t glyph_id,
     surface_t **result)
 {
 	if (glyph_id >= data->glyph_count)
 		return ENOENT;
 
-	if (data->glyph_cache[glyph_id].surface != NULL) {
-		*result = data->glyph_cache[glyph_id].surface;
+	glyph_cache_item_t *item = &data->glyph_cache[glyph_id];
+	if (item->surface != NULL) {
+		/* Keep the most recently used surfaces first */
+		list_remove(&item->link);
+		list_prepend(&item->link, &data->glyph_surfaces);
+
+		*result = item->surface;
 		return EOK;
 	}
 
@@ -134,6 +168,7 @@ static errno_t get_glyph_surface(bitmap_backend_data_t *data, glyph_id_t glyph_i
 	surface_get_resolution(raw_surface, &w, &h);
 
 	if (!data->scale) {
+		cache_glyph_surface(data, glyph_id, raw_surface);
 		*result = raw_surface;
 		return EOK;
 	}
@@ -165,7 +200,7 @@ static errno_t get_glyph_surface(bitmap_backend_data_t *data, glyph_id_t glyph_i
 
 	surface_destroy(raw_surface);
 
-	data->glyph_cache[glyph_id].surface = scaled_surface;
+	cache_glyph_surface(data, glyph_id, scaled_surface);
 	*result = scaled_surface;
 	return EOK;
 }
@@ -203,10 +238,12 @@ static void bb_release(void *backend_data)
 {
 	bitmap_backend_data_t *data = (bitmap_backend_data_t *) backend_data;
 
-	for (size_t i = 0; i < data->glyph_count; ++i) {
-		if (data->glyph_cache[i].surface) {
-			surface_destroy(data->glyph_cache[i].surface);
-		}
+	list_foreach_safe(data->glyph_surfaces, cur, next) {
+		glyph_cache_item_t *item =
+		    list_get_instance(cur, glyph_cache_item_t, link);
+
+		list_remove(&item->link);
+		surface_destroy(item->surface);
 	}
 	free(data->glyph_cache);
 
@@ -262,10 +299,14 @@ errno_t bitmap_font_create(bitmap_font_decoder_t *decoder, void *decoder_data,
 	}
 
 	for (size_t i = 0; i < data->glyph_count; ++i) {
+		link_initialize(&data->glyph_cache[i].link);
 		data->glyph_cache[i].surface = NULL;
 		data->glyph_cache[i].metrics_loaded = false;
 	}
 
+	list_initialize(&data->glyph_surfaces);
+	data->glyph_surfaces_count = 0;
+
 	font_t *font = font_create(&bitmap_backend, data);
 	if (font == NULL) {
 		free(data->glyph_cache);
@@ -40,6 +40,7 @@
 void source_init(source_t *source)
 {
 	transform_identity(&source->transform);
+	source->transform_class = TRANSFORM_IDENTITY;
 	source->filter = filter_nearest;
 
 	source->color = PIXEL(0, 0, 0, 0);
@@ -55,11 +56,13 @@ void source_set_transform(source_t *source, transform_t transform)
 {
 	source->transform = transform;
 	transform_invert(&source->transform);
+	source->transform_class = transform_classify(&source->transform);
 }
 
 void source_reset_transform(source_t *source)
 {
 	transform_identity(&source->transform);
+	source->transform_class = TRANSFORM_IDENTITY;
 }
 
 void source_set_filter(source_t *source, filter_t filter)
@@ -148,5 +151,127 @@ pixel_t source_determine_pixel(source_t *source, double x, double y)
 	}
 }
 
+/** Determine a span of pixels of a solid color source with a mask.
+ *
+ * This is the case of text rendering, where the glyph is the mask.
+ * The mask is sampled by the span filter, the color is only blended
+ * with the sampled coverage.
+ */
+static void source_determine_mask_span(source_t *source, double x, double y,
+    pixel_t *dst, size_t count)
+{
+	if (source->transform_class == TRANSFORM_TRANSLATION) {
+		x += source->transform.matrix[0][2];
+		y += source->transform.matrix[1][2];
+	}
+
+	filter_nearest_span(surface_pixmap_access(source->mask), x, y, 1, 0,
+	    source->mask_extend, dst, count);
+
+	pixel_t color = source->color;
+	for (size_t i = 0; i < count; ++i) {
+		unsigned int coverage = ALPHA(dst[i]);
+
+		if (coverage == 0) {
+			dst[i] = 0;
+		} else if (coverage < 255) {
+			double ratio = ((double) coverage) / 255.0;
+			double res_a = ratio * ((double) ALPHA(color));
+			dst[i] = PIXEL((unsigned) res_a,
+			    RED(color), GREEN(color), BLUE(color));
+		} else {
+			dst[i] = color;
+		}
+	}
+}
+
+/** Determine a span of pixels of a row.
+ *
+ * Same as calling source_determine_pixel() for @a count consecutive
+ * pixels starting at [@a x, @a y]. Textures without a mask and masked
+ * solid colors are sampled by the span filters, with the coordinates
+ * stepped according to the class of the transformation instead of
+ * transforming each pixel.
+ *
+ * @param source Source
+ * @param x      X coordinate of the first pixel
+ * @param y      Y coordinate of the first pixel
+ * @param dst    Buffer for the pixels
+ * @param count  Number of pixels
+ */
+void source_determine_span(source_t *source, double x, double y,
+    pixel_t *dst, size_t count)
+{
+	bool span = (source->mask == NULL) && (source->texture != NULL) &&
+	    (source->filter == filter_nearest ||
+	    source->filter == filter_bilinear);
+	bool mask_span = (source->mask != NULL) && (source->texture == NULL) &&
+	    (source->filter == filter_nearest) &&
+	    (source->transform_class == TRANSFORM_IDENTITY ||
+	    source->transform_class == TRANSFORM_TRANSLATION);
+
+	if (mask_span) {
+		source_determine_mask_span(source, x, y, dst, count);
+		return;
+	}
+
+	if (!span) {
+		for (size_t i = 0; i < count; ++i)
+			dst[i] = source_determine_pixel(source, x + i, y);
+		return;
+	}
+
+	if (!ALPHA(source->alpha)) {
+		for (size_t i = 0; i < count; ++i)
+			dst[i] = 0;
+		return;
+	}
+
+	double dx;
+	double dy;
+
+	switch (source->transform_class) {
+	case TRANSFORM_IDENTITY:
+		dx = 1;
+		dy = 0;
+		break;
+	case TRANSFORM_TRANSLATION:
+		x += source->transform.matrix[0][2];
+		y += source->transform.matrix[1][2];
+		dx = 1;
+		dy = 0;
+		break;
+	case TRANSFORM_SCALE:
+		transform_apply_affine(&source->transform, &x, &y);
+		dx = source->transform.matrix[0][0];
+		dy = 0;
+		break;
+	default:
+		transform_apply_affine(&source->transform, &x, &y);
+		dx = source->transform.matrix[0][0];
+		dy = source->transform.matrix[1][0];
+		break;
+	}
+
+	pixelmap_t *pixmap = surface_pixmap_access(source->texture);
+
+	if (source->filter == filter_nearest) {
+		filter_nearest_span(pixmap, x, y, dx, dy,
+		    source->texture_extend, dst, count);
+	} else {
+		filter_bilinear_span(pixmap, x, y, dx, dy,
+		    source->texture_extend, dst, count);
+	}
+
+	unsigned int alpha = ALPHA(source->alpha);
+	if (alpha < 255) {
+		for (size_t i = 0; i < count; ++i) {
+			pixel_t pix = dst[i];
+			dst[i] = PIXEL(ALPHA(pix) * alpha / 255,
+			    RED(pix), GREEN(pix), BLUE(pix));
+		}
+	}
+}
+
 /** @}
  */
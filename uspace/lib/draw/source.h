@@ -46,6 +46,7 @@
 
 typedef struct source {
 	transform_t transform;
+	transform_class_t transform_class;
 	filter_t filter;
 
 	pixel_t color;
@@ -73,6 +74,8 @@ extern void source_set_mask(source_t *, surface_t *, pixelmap_extend_t);
 extern bool source_is_fast(source_t *);
 extern pixel_t *source_direct_access(source_t *, double, double);
 extern pixel_t source_determine_pixel(source_t *, double, double);
+extern void source_determine_span(source_t *, double, double, pixel_t *,
+    size_t);
 
 #endif
 
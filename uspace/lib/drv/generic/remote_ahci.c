@@ -47,7 +47,8 @@ typedef enum {
 	IPC_M_AHCI_GET_NUM_BLOCKS,
 	IPC_M_AHCI_GET_BLOCK_SIZE,
 	IPC_M_AHCI_READ_BLOCKS,
-	IPC_M_AHCI_WRITE_BLOCKS
+	IPC_M_AHCI_WRITE_BLOCKS,
+	IPC_M_AHCI_GET_QUEUE_DEPTH
 } ahci_iface_funcs_t;
 
 #define MAX_NAME_LENGTH  1024
@@ -140,6 +141,29 @@ errno_t ahci_get_block_size(async_sess_t *sess, size_t *blocks_size)
 	return rc;
 }
 
+/** Get the number of requests the device can serve at the same time.
+ *
+ * Requests sent from different fibrils are served in parallel, each on
+ * its own exchange.
+ */
+errno_t ahci_get_queue_depth(async_sess_t *sess, unsigned *depth)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	if (!exch)
+		return EINVAL;
+
+	sysarg_t qd;
+	errno_t rc = async_req_1_1(exch, DEV_IFACE_ID(AHCI_DEV_IFACE),
+	    IPC_M_AHCI_GET_QUEUE_DEPTH, &qd);
+
+	async_exchange_end(exch);
+
+	if (rc == EOK)
+		*depth = (unsigned) qd;
+
+	return rc;
+}
+
 errno_t ahci_read_blocks(async_sess_t *sess, uint64_t blocknum, size_t count,
     void *buf)
 {
@@ -153,11 +177,16 @@ errno_t ahci_read_blocks(async_sess_t *sess, uint64_t blocknum, size_t count,
 
 	async_share_out_start(exch, buf, AS_AREA_READ | AS_AREA_WRITE);
 
-	async_exchange_end(exch);
-
+	/*
+	 * Keep the exchange until the request is answered so that concurrent
+	 * requests go over different connections and the driver serves them
+	 * in parallel.
+	 */
 	errno_t rc;
 	async_wait_for(req, &rc);
 
+	async_exchange_end(exch);
+
 	return rc;
 }
 
@@ -173,11 +202,11 @@ errno_t ahci_write_blocks(async_sess_t *sess, uint64_t blocknum, size_t count,
 
 	async_share_out_start(exch, buf, AS_AREA_READ | AS_AREA_WRITE);
 
-	async_exchange_end(exch);
-
 	errno_t rc;
 	async_wait_for(req, &rc);
 
+	async_exchange_end(exch);
+
 	return rc;
 }
 
@@ -186,6 +215,7 @@ static void remote_ahci_get_num_blocks(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_ahci_get_block_size(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_ahci_read_blocks(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_ahci_write_blocks(ddf_fun_t *, void *, ipc_call_t *);
+static void remote_ahci_get_queue_depth(ddf_fun_t *, void *, ipc_call_t *);
 
 /** Remote AHCI interface operations. */
 static const remote_iface_func_ptr_t remote_ahci_iface_ops [] = {
@@ -193,7 +223,8 @@ static const remote_iface_func_ptr_t remote_ahci_iface_ops [] = {
 	[IPC_M_AHCI_GET_NUM_BLOCKS] = remote_ahci_get_num_blocks,
 	[IPC_M_AHCI_GET_BLOCK_SIZE] = remote_ahci_get_block_size,
 	[IPC_M_AHCI_READ_BLOCKS] = remote_ahci_read_blocks,
-	[IPC_M_AHCI_WRITE_BLOCKS] = remote_ahci_write_blocks
+	[IPC_M_AHCI_WRITE_BLOCKS] = remote_ahci_write_blocks,
+	[IPC_M_AHCI_GET_QUEUE_DEPTH] = remote_ahci_get_queue_depth
 };
 
 /** Remote AHCI interface structure.
@@ -274,6 +305,25 @@ static void remote_ahci_get_block_size(ddf_fun_t *fun, void *iface,
 		async_answer_1(call, EOK, blocks);
 }
 
+static void remote_ahci_get_queue_depth(ddf_fun_t *fun, void *iface,
+    ipc_call_t *call)
+{
+	const ahci_iface_t *ahci_iface = (ahci_iface_t *) iface;
+
+	if (ahci_iface->get_queue_depth == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	unsigned depth;
+	const errno_t ret = ahci_iface->get_queue_depth(fun, &depth);
+
+	if (ret != EOK)
+		async_answer_0(call, ret);
+	else
+		async_answer_1(call, EOK, depth);
+}
+
 void remote_ahci_read_blocks(ddf_fun_t *fun, void *iface, ipc_call_t *call)
 {
 	const ahci_iface_t *ahci_iface = (ahci_iface_t *) iface;
@@ -32,10 +32,13 @@
 /** @file
  */
 
+#include <align.h>
 #include <assert.h>
 #include <async.h>
+#include <byteorder.h>
 #include <errno.h>
 #include <macros.h>
+#include <mem.h>
 
 #include "pci_dev_iface.h"
 #include "ddf/driver.h"
@@ -47,7 +50,12 @@ typedef enum {
 
 	IPC_M_CONFIG_SPACE_WRITE_8,
 	IPC_M_CONFIG_SPACE_WRITE_16,
-	IPC_M_CONFIG_SPACE_WRITE_32
+	IPC_M_CONFIG_SPACE_WRITE_32,
+
+	IPC_M_CONFIG_SPACE_READ,
+
+	IPC_M_MSI_ENABLE,
+	IPC_M_MSI_DISABLE
 } pci_dev_iface_funcs_t;
 
 errno_t pci_config_space_read_8(async_sess_t *sess, uint32_t address, uint8_t *val)
@@ -123,6 +131,238 @@ errno_t pci_config_space_write_32(async_sess_t *sess, uint32_t address,
 	return rc;
 }
 
+/** Read a block of the configuration space in one request.
+ *
+ * @param sess    Session to the PCI function
+ * @param address Offset of the block, aligned to four bytes
+ * @param buf     Buffer for the data, in little-endian byte order
+ * @param size    Size of the block, a multiple of four bytes
+ *
+ * @return EOK on success or an error code
+ */
+errno_t pci_config_space_read(async_sess_t *sess, uint32_t address, void *buf,
+    size_t size)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	aid_t req = async_send_2(exch, DEV_IFACE_ID(PCI_DEV_IFACE),
+	    IPC_M_CONFIG_SPACE_READ, address, NULL);
+	errno_t rc = async_data_read_start(exch, buf, size);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Initialize a configuration space cache.
+ *
+ * @param cache Cache to initialize
+ * @param sess  Session to the PCI function
+ *
+ * @return EOK on success or an error code
+ */
+errno_t pci_config_cache_init(pci_config_cache_t *cache, async_sess_t *sess)
+{
+	cache->sess = sess;
+	return pci_config_cache_refresh(cache, 0, PCI_CONFIG_SPACE_SIZE);
+}
+
+/** Re-read part of the cached configuration space.
+ *
+ * The range is fetched in one request if the PCI bus driver supports block
+ * reads, register by register otherwise.
+ *
+ * @param cache   Configuration space cache
+ * @param address Offset of the range
+ * @param size    Size of the range
+ *
+ * @return EOK on success or an error code
+ */
+errno_t pci_config_cache_refresh(pci_config_cache_t *cache, uint32_t address,
+    size_t size)
+{
+	uint32_t start = ALIGN_DOWN(address, sizeof(uint32_t));
+	size_t end = ALIGN_UP(address + size, sizeof(uint32_t));
+
+	if (address >= PCI_CONFIG_SPACE_SIZE ||
+	    size > PCI_CONFIG_SPACE_SIZE - address)
+		return EINVAL;
+
+	errno_t rc = pci_config_space_read(cache->sess, start,
+	    cache->data + start, end - start);
+	if (rc != ENOTSUP)
+		return rc;
+
+	for (uint32_t addr = start; addr < end; addr += sizeof(uint32_t)) {
+		uint32_t val;
+
+		rc = pci_config_space_read_32(cache->sess, addr, &val);
+		if (rc != EOK)
+			return rc;
+
+		val = host2uint32_t_le(val);
+		memcpy(cache->data + addr, &val, sizeof(val));
+	}
+
+	return EOK;
+}
+
+/** Get an 8-bit register from the configuration space cache. */
+uint8_t pci_config_cache_get_8(pci_config_cache_t *cache, uint32_t address)
+{
+	assert(address < PCI_CONFIG_SPACE_SIZE);
+	return cache->data[address];
+}
+
+/** Get a 16-bit register from the configuration space cache. */
+uint16_t pci_config_cache_get_16(pci_config_cache_t *cache, uint32_t address)
+{
+	uint16_t val;
+
+	assert(address <= PCI_CONFIG_SPACE_SIZE - sizeof(val));
+	memcpy(&val, cache->data + address, sizeof(val));
+	return uint16_t_le2host(val);
+}
+
+/** Get a 32-bit register from the configuration space cache. */
+uint32_t pci_config_cache_get_32(pci_config_cache_t *cache, uint32_t address)
+{
+	uint32_t val;
+
+	assert(address <= PCI_CONFIG_SPACE_SIZE - sizeof(val));
+	memcpy(&val, cache->data + address, sizeof(val));
+	return uint32_t_le2host(val);
+}
+
+/** Write an 8-bit register and update the configuration space cache. */
+errno_t pci_config_cache_write_8(pci_config_cache_t *cache, uint32_t address,
+    uint8_t val)
+{
+	errno_t rc = pci_config_space_write_8(cache->sess, address, val);
+	if (rc == EOK)
+		cache->data[address] = val;
+
+	return rc;
+}
+
+/** Write a 16-bit register and update the configuration space cache. */
+errno_t pci_config_cache_write_16(pci_config_cache_t *cache, uint32_t address,
+    uint16_t val)
+{
+	errno_t rc = pci_config_space_write_16(cache->sess, address, val);
+	if (rc == EOK) {
+		val = host2uint16_t_le(val);
+		memcpy(cache->data + address, &val, sizeof(val));
+	}
+
+	return rc;
+}
+
+/** Write a 32-bit register and update the configuration space cache. */
+errno_t pci_config_cache_write_32(pci_config_cache_t *cache, uint32_t address,
+    uint32_t val)
+{
+	errno_t rc = pci_config_space_write_32(cache->sess, address, val);
+	if (rc == EOK) {
+		val = host2uint32_t_le(val);
+		memcpy(cache->data + address, &val, sizeof(val));
+	}
+
+	return rc;
+}
+
+/** Find a capability in the cached configuration space.
+ *
+ * @param cache Configuration space cache
+ * @param id    Capability ID
+ * @param from  Capability to continue the search after or zero to search
+ *              from the beginning of the list
+ *
+ * @return Offset of the capability or zero if there is none
+ */
+uint8_t pci_config_cache_cap_find(pci_config_cache_t *cache, uint8_t id,
+    uint8_t from)
+{
+	uint8_t c;
+
+	if (from == 0) {
+		if (!(pci_config_cache_get_16(cache, PCI_STATUS) &
+		    PCI_STATUS_CAP_LIST))
+			return 0;
+		c = cache->data[PCI_CAP_PTR];
+	} else {
+		c = cache->data[PCI_CAP_NEXT(from)];
+	}
+
+	/* A malformed list must not make us loop forever */
+	for (unsigned int n = 0; n < PCI_CONFIG_SPACE_SIZE / 4; n++) {
+		c &= ~3;
+		if (c == 0)
+			break;
+		if (cache->data[PCI_CAP_ID(c)] == id)
+			return c;
+		c = cache->data[PCI_CAP_NEXT(c)];
+	}
+
+	return 0;
+}
+
+/** Enable message signalled interrupts of a PCI function.
+ *
+ * MSI-X is used if the function supports it, MSI otherwise. Fewer vectors
+ * than requested may be granted. Vector @c i of the function raises IRQ
+ * @c irq + @c i. Legacy INTx interrupts of the function are disabled.
+ *
+ * @param sess    Session to the PCI function
+ * @param count   Number of requested vectors
+ * @param irq     Place to store the IRQ number of the first vector
+ * @param granted Place to store the number of granted vectors
+ *
+ * @return EOK on success, ENOTSUP if neither the function nor the system
+ *         support message signalled interrupts, or an error code
+ */
+errno_t pci_msi_enable(async_sess_t *sess, unsigned int count, int *irq,
+    unsigned int *granted)
+{
+	sysarg_t first;
+	sysarg_t cnt;
+
+	async_exch_t *exch = async_exchange_begin(sess);
+	errno_t rc = async_req_2_2(exch, DEV_IFACE_ID(PCI_DEV_IFACE),
+	    IPC_M_MSI_ENABLE, count, &first, &cnt);
+	async_exchange_end(exch);
+
+	if (rc != EOK)
+		return rc;
+
+	*irq = (int) first;
+	*granted = (unsigned int) cnt;
+	return EOK;
+}
+
+/** Disable message signalled interrupts and return to INTx.
+ *
+ * @param sess Session to the PCI function
+ *
+ * @return EOK on success or an error code
+ */
+errno_t pci_msi_disable(async_sess_t *sess)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	errno_t rc = async_req_1_0(exch, DEV_IFACE_ID(PCI_DEV_IFACE),
+	    IPC_M_MSI_DISABLE);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
 static void remote_config_space_read_8(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_config_space_read_16(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_config_space_read_32(ddf_fun_t *, void *, ipc_call_t *);
@@ -131,6 +371,11 @@ static void remote_config_space_write_8(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_config_space_write_16(ddf_fun_t *, void *, ipc_call_t *);
 static void remote_config_space_write_32(ddf_fun_t *, void *, ipc_call_t *);
 
+static void remote_config_space_read(ddf_fun_t *, void *, ipc_call_t *);
+
+static void remote_msi_enable(ddf_fun_t *, void *, ipc_call_t *);
+static void remote_msi_disable(ddf_fun_t *, void *, ipc_call_t *);
+
 /** Remote USB interface operations. */
 static const remote_iface_func_ptr_t remote_pci_iface_ops [] = {
 	[IPC_M_CONFIG_SPACE_READ_8] = remote_config_space_read_8,
@@ -139,7 +384,12 @@ static const remote_iface_func_ptr_t remote_pci_iface_ops [] = {
 
 	[IPC_M_CONFIG_SPACE_WRITE_8] = remote_config_space_write_8,
 	[IPC_M_CONFIG_SPACE_WRITE_16] = remote_config_space_write_16,
-	[IPC_M_CONFIG_SPACE_WRITE_32] = remote_config_space_write_32
+	[IPC_M_CONFIG_SPACE_WRITE_32] = remote_config_space_write_32,
+
+	[IPC_M_CONFIG_SPACE_READ] = remote_config_space_read,
+
+	[IPC_M_MSI_ENABLE] = remote_msi_enable,
+	[IPC_M_MSI_DISABLE] = remote_msi_disable
 };
 
 /** Remote USB interface structure.
@@ -256,6 +506,85 @@ void remote_config_space_write_32(ddf_fun_t *fun, void *iface, ipc_call_t *call)
 	}
 }
 
+void remote_config_space_read(ddf_fun_t *fun, void *iface, ipc_call_t *call)
+{
+	assert(iface);
+	pci_dev_iface_t *pci_iface = (pci_dev_iface_t *)iface;
+	uint32_t address = DEV_IPC_GET_ARG1(*call);
+	uint32_t buf[PCI_CONFIG_SPACE_SIZE / sizeof(uint32_t)];
+	ipc_call_t data;
+	size_t size;
+
+	if (!async_data_read_receive(&data, &size)) {
+		async_answer_0(&data, EPARTY);
+		async_answer_0(call, EPARTY);
+		return;
+	}
+
+	if (pci_iface->config_space_read_32 == NULL) {
+		async_answer_0(&data, ENOTSUP);
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+
+	if ((address % sizeof(uint32_t)) != 0 ||
+	    (size % sizeof(uint32_t)) != 0 ||
+	    address >= PCI_CONFIG_SPACE_SIZE ||
+	    size > PCI_CONFIG_SPACE_SIZE - address) {
+		async_answer_0(&data, EINVAL);
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	/* Gather the block here so that it crosses IPC only once */
+	for (size_t i = 0; i < size / sizeof(uint32_t); i++) {
+		uint32_t value;
+		errno_t ret = pci_iface->config_space_read_32(fun,
+		    address + i * sizeof(uint32_t), &value);
+		if (ret != EOK) {
+			async_answer_0(&data, ret);
+			async_answer_0(call, ret);
+			return;
+		}
+
+		buf[i] = host2uint32_t_le(value);
+	}
+
+	errno_t ret = async_data_read_finalize(&data, buf, size);
+	async_answer_0(call, ret);
+}
+
+void remote_msi_enable(ddf_fun_t *fun, void *iface, ipc_call_t *call)
+{
+	assert(iface);
+	pci_dev_iface_t *pci_iface = (pci_dev_iface_t *)iface;
+	if (pci_iface->msi_enable == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+	unsigned int count = DEV_IPC_GET_ARG1(*call);
+	unsigned int granted;
+	int irq;
+	errno_t ret = pci_iface->msi_enable(fun, count, &irq, &granted);
+	if (ret != EOK) {
+		async_answer_0(call, ret);
+	} else {
+		async_answer_2(call, EOK, irq, granted);
+	}
+}
+
+void remote_msi_disable(ddf_fun_t *fun, void *iface, ipc_call_t *call)
+{
+	assert(iface);
+	pci_dev_iface_t *pci_iface = (pci_dev_iface_t *)iface;
+	if (pci_iface->msi_disable == NULL) {
+		async_answer_0(call, ENOTSUP);
+		return;
+	}
+	errno_t ret = pci_iface->msi_disable(fun);
+	async_answer_0(call, ret);
+}
+
 /**
  * @}
  */
@@ -42,7 +42,9 @@
 typedef enum {
 	NIC_EV_ADDR_CHANGED = IPC_FIRST_USER_METHOD,
 	NIC_EV_RECEIVED,
-	NIC_EV_DEVICE_STATE
+	NIC_EV_DEVICE_STATE,
+	/** Several frames, each preceded by its size as @c size_t */
+	NIC_EV_RECEIVED_LIST
 } nic_event_t;
 
 extern errno_t nic_send_frame(async_sess_t *, void *, size_t);
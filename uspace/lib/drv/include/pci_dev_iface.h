@@ -43,6 +43,7 @@
 
 #define PCI_VENDOR_ID	0x00
 #define PCI_DEVICE_ID	0x02
+#define PCI_COMMAND	0x04
 #define PCI_STATUS 	0x06
 #define PCI_SUB_CLASS	0x0A
 #define PCI_BASE_CLASS	0x0B
@@ -51,14 +52,35 @@
 
 #define PCI_BAR_COUNT	6
 
+#define PCI_COMMAND_INTX_DISABLE	0x400
+
 #define PCI_STATUS_CAP_LIST	(1 << 4)
 
 #define PCI_CAP_ID(c)	((c) + 0x0)
 #define PCI_CAP_NEXT(c)	((c) + 0x1)
 
 #define PCI_CAP_PMID		0x1
+#define PCI_CAP_MSI		0x5
 #define PCI_CAP_VENDORSPECID	0x9
+#define PCI_CAP_MSIX		0x11
+
+/** Size of the conventional PCI configuration space */
+#define PCI_CONFIG_SPACE_SIZE	256
+
+/** Cached copy of the configuration space of a PCI function
+ *
+ * The identification registers, BARs and capability structures do not
+ * change once the device is set up, so drivers can look them up in the
+ * cache instead of asking the PCI bus driver over and over. Registers
+ * that the device updates on its own, such as the status register, still
+ * have to be read with pci_config_space_read_*().
+ */
+typedef struct {
+	async_sess_t *sess;
+	uint8_t data[PCI_CONFIG_SPACE_SIZE];
+} pci_config_cache_t;
 
+extern errno_t pci_config_space_read(async_sess_t *, uint32_t, void *, size_t);
 extern errno_t pci_config_space_read_8(async_sess_t *, uint32_t, uint8_t *);
 extern errno_t pci_config_space_read_16(async_sess_t *, uint32_t, uint16_t *);
 extern errno_t pci_config_space_read_32(async_sess_t *, uint32_t, uint32_t *);
@@ -67,6 +89,25 @@ extern errno_t pci_config_space_write_8(async_sess_t *, uint32_t, uint8_t);
 extern errno_t pci_config_space_write_16(async_sess_t *, uint32_t, uint16_t);
 extern errno_t pci_config_space_write_32(async_sess_t *, uint32_t, uint32_t);
 
+extern errno_t pci_config_cache_init(pci_config_cache_t *, async_sess_t *);
+extern errno_t pci_config_cache_refresh(pci_config_cache_t *, uint32_t,
+    size_t);
+extern uint8_t pci_config_cache_get_8(pci_config_cache_t *, uint32_t);
+extern uint16_t pci_config_cache_get_16(pci_config_cache_t *, uint32_t);
+extern uint32_t pci_config_cache_get_32(pci_config_cache_t *, uint32_t);
+extern errno_t pci_config_cache_write_8(pci_config_cache_t *, uint32_t,
+    uint8_t);
+extern errno_t pci_config_cache_write_16(pci_config_cache_t *, uint32_t,
+    uint16_t);
+extern errno_t pci_config_cache_write_32(pci_config_cache_t *, uint32_t,
+    uint32_t);
+extern uint8_t pci_config_cache_cap_find(pci_config_cache_t *, uint8_t,
+    uint8_t);
+
+extern errno_t pci_msi_enable(async_sess_t *, unsigned int, int *,
+    unsigned int *);
+extern errno_t pci_msi_disable(async_sess_t *);
+
 static inline errno_t
 pci_config_space_cap_first(async_sess_t *sess, uint8_t *c, uint8_t *id)
 {
@@ -85,7 +126,7 @@ pci_config_space_cap_first(async_sess_t *sess, uint8_t *c, uint8_t *id)
 	rc = pci_config_space_read_8(sess, PCI_CAP_PTR, c);
 	if (rc != EOK)
 		return rc;
-	if (!c)
+	if (!*c)
 		return EOK;
 	return pci_config_space_read_8(sess, PCI_CAP_ID(*c), id);
 }
@@ -96,7 +137,7 @@ pci_config_space_cap_next(async_sess_t *sess, uint8_t *c, uint8_t *id)
 	errno_t rc = pci_config_space_read_8(sess, PCI_CAP_NEXT(*c), c);
 	if (rc != EOK)
 		return rc;
-	if (!c)
+	if (!*c)
 		return EOK;
 	return pci_config_space_read_8(sess, PCI_CAP_ID(*c), id);
 }
@@ -110,6 +151,10 @@ typedef struct {
 	errno_t (*config_space_write_8)(ddf_fun_t *, uint32_t address, uint8_t data);
 	errno_t (*config_space_write_16)(ddf_fun_t *, uint32_t address, uint16_t data);
 	errno_t (*config_space_write_32)(ddf_fun_t *, uint32_t address, uint32_t data);
+
+	errno_t (*msi_enable)(ddf_fun_t *, unsigned int count, int *irq,
+	    unsigned int *granted);
+	errno_t (*msi_disable)(ddf_fun_t *);
 } pci_dev_iface_t;
 
 #endif
@@ -36,11 +36,22 @@
 #include <stdint.h>
 #include "types.h"
 
+/** Number of blocks allocated ahead when appending to i-node */
+#define EXT4_BALLOC_PREALLOC_BLOCKS  32
+
+extern errno_t ext4_balloc_init(ext4_filesystem_t *);
+extern void ext4_balloc_fini(ext4_filesystem_t *);
 extern errno_t ext4_balloc_free_block(ext4_inode_ref_t *, uint32_t);
 extern errno_t ext4_balloc_free_blocks(ext4_inode_ref_t *, uint32_t, uint32_t);
 extern uint32_t ext4_balloc_get_first_data_block_in_group(ext4_superblock_t *,
     ext4_block_group_ref_t *);
 extern errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *, uint32_t *);
+extern errno_t ext4_balloc_alloc_blocks(ext4_inode_ref_t *, uint32_t, uint32_t,
+    uint32_t *, uint32_t *);
+extern errno_t ext4_balloc_alloc_append_block(ext4_inode_ref_t *, uint32_t,
+    uint32_t *);
+extern errno_t ext4_balloc_prealloc(ext4_inode_ref_t *, uint32_t);
+extern errno_t ext4_balloc_discard_prealloc(ext4_inode_ref_t *);
 extern errno_t ext4_balloc_try_alloc_block(ext4_inode_ref_t *, uint32_t, bool *);
 
 #endif
@@ -54,6 +54,8 @@ typedef struct {
 	const char *volume_name;
 	/** Filesystem block size */
 	size_t bsize;
+	/** Leave zeroing of i-node tables until the file system is mounted */
+	bool lazy_itable_init;
 } ext4_cfg_t;
 
 #endif
@@ -35,6 +35,7 @@
 #define LIBEXT4_FSTYPES_H_
 
 #include <adt/list.h>
+#include <fibril_synch.h>
 #include <libfs.h>
 #include <loc.h>
 #include "ext4/types.h"
@@ -47,6 +48,8 @@ typedef struct ext4_instance {
 	service_id_t service_id;
 	ext4_filesystem_t *filesystem;
 	unsigned int open_nodes_count;
+	/** Blocks promised to data buffered by delayed allocation */
+	uint64_t delalloc_reserved;
 } ext4_instance_t;
 
 /**
@@ -58,6 +61,16 @@ typedef struct ext4_node {
 	fs_node_t *fs_node;
 	ht_link_t link;
 	unsigned int references;
+	/** Held for reading while reading the node, for writing otherwise */
+	fibril_rwlock_t lock;
+
+	/*
+	 * Data appended to the file, whose blocks are not allocated yet.
+	 * The buffer starts at the beginning of block da_iblock.
+	 */
+	uint8_t *da_buf;
+	uint32_t da_iblock;
+	size_t da_bytes;
 } ext4_node_t;
 
 #define EXT4_NODE(node) \
@@ -36,6 +36,7 @@
 #define LIBEXT4_TYPES_H_
 
 #include <block.h>
+#include <fibril_synch.h>
 
 /*
  * Structure of the super block
@@ -232,6 +233,18 @@ typedef struct ext4_filesystem {
 	ext4_superblock_t *superblock;
 	aoff64_t inode_block_limits[4];
 	aoff64_t inode_blocks_per_level[4];
+	/* Upper bounds of the longest free run of blocks in each group */
+	uint32_t *balloc_max_run;
+	/* Serializes allocation and freeing of blocks and i-nodes */
+	fibril_mutex_t alloc_lock;
+	/* Protects the state of the i-node table zeroing fibril */
+	fibril_mutex_t itable_lock;
+	/* Signalled when the i-node table zeroing fibril exits */
+	fibril_condvar_t itable_cv;
+	/* I-node table zeroing fibril exists */
+	bool itable_running;
+	/* I-node table zeroing fibril should exit */
+	bool itable_stop;
 } ext4_filesystem_t;
 
 /** Size of buffer for volume name. To hold 16 latin-1 chars encoded as UTF-8
@@ -387,12 +400,32 @@ typedef struct ext4_inode {
 
 #define EXT4_INODE_ROOT_INDEX  2
 
+/*
+ * Extent status cache entry - a run of logical blocks mapped to
+ * a contiguous run of physical blocks
+ */
+typedef struct ext4_extent_status {
+	uint32_t iblock;        /* First logical block of the run */
+	uint32_t count;         /* Number of blocks in the run */
+	uint64_t fblock;        /* First physical block of the run */
+} ext4_extent_status_t;
+
+#define EXT4_EXTENT_CACHE_SIZE  16
+
 typedef struct ext4_inode_ref {
 	block_t *block;         /* Reference to a block containing this inode */
 	ext4_inode_t *inode;
 	ext4_filesystem_t *fs;
 	uint32_t index;         /* Index number of this inode */
 	bool dirty;
+
+	/* Recently looked up extents, sorted by the first logical block */
+	ext4_extent_status_t extent_cache[EXT4_EXTENT_CACHE_SIZE];
+	unsigned int extent_cache_count;
+
+	/* Blocks allocated ahead for appending, not charged to i-node yet */
+	uint32_t prealloc_start;
+	uint32_t prealloc_count;
 } ext4_inode_ref_t;
 
 #define EXT4_DIRECTORY_FILENAME_LEN  255
@@ -36,8 +36,11 @@
  */
 
 #include <errno.h>
+#include <fibril_synch.h>
+#include <macros.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include "ext4/balloc.h"
 #include "ext4/bitmap.h"
 #include "ext4/block_group.h"
@@ -46,6 +49,95 @@
 #include "ext4/superblock.h"
 #include "ext4/types.h"
 
+/** Value of free run summary for groups which were not scanned yet */
+#define EXT4_BALLOC_MAX_RUN_UNKNOWN  UINT32_MAX
+
+/** Initialize in-memory allocator state of filesystem.
+ *
+ * @param fs Filesystem
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_init(ext4_filesystem_t *fs)
+{
+	uint32_t count = ext4_superblock_get_block_group_count(fs->superblock);
+
+	fs->balloc_max_run = malloc(count * sizeof(uint32_t));
+	if (fs->balloc_max_run == NULL)
+		return ENOMEM;
+
+	for (uint32_t i = 0; i < count; i++)
+		fs->balloc_max_run[i] = EXT4_BALLOC_MAX_RUN_UNKNOWN;
+
+	fibril_mutex_initialize(&fs->alloc_lock);
+	return EOK;
+}
+
+/** Release in-memory allocator state of filesystem.
+ *
+ * @param fs Filesystem
+ *
+ */
+void ext4_balloc_fini(ext4_filesystem_t *fs)
+{
+	free(fs->balloc_max_run);
+	fs->balloc_max_run = NULL;
+}
+
+/** Get upper bound of the longest free run of blocks in a group.
+ *
+ * @param fs   Filesystem
+ * @param bgid Block group index
+ *
+ * @return Maximum length of free run which may exist in the group
+ *
+ */
+static uint32_t ext4_balloc_max_run_get(ext4_filesystem_t *fs, uint32_t bgid)
+{
+	if (fs->balloc_max_run == NULL)
+		return EXT4_BALLOC_MAX_RUN_UNKNOWN;
+
+	return fs->balloc_max_run[bgid];
+}
+
+/** Set upper bound of the longest free run of blocks in a group.
+ *
+ * Releasing blocks may merge free runs, so the bound is forgotten then.
+ * Allocating blocks never makes the bound invalid.
+ *
+ * @param fs      Filesystem
+ * @param bgid    Block group index
+ * @param max_run New bound
+ *
+ */
+static void ext4_balloc_max_run_set(ext4_filesystem_t *fs, uint32_t bgid,
+    uint32_t max_run)
+{
+	if (fs->balloc_max_run != NULL)
+		fs->balloc_max_run[bgid] = max_run;
+}
+
+/** Account blocks newly owned by i-node.
+ *
+ * @param inode_ref I-node the blocks were allocated for
+ * @param count     Number of blocks
+ *
+ */
+static void ext4_balloc_charge_inode(ext4_inode_ref_t *inode_ref,
+    uint32_t count)
+{
+	ext4_superblock_t *sb = inode_ref->fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	/* Inode blocks are counted in different units */
+	uint64_t ino_blocks =
+	    ext4_inode_get_blocks_count(sb, inode_ref->inode);
+	ino_blocks += count * (block_size / EXT4_INODE_BLOCK_SIZE);
+	ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
+	inode_ref->dirty = true;
+}
+
 /** Free block.
  *
  * @param inode_ref  Inode, where the block is allocated
@@ -54,7 +146,8 @@
  * @return Error code
  *
  */
-errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
+static errno_t ext4_balloc_free_block_locked(ext4_inode_ref_t *inode_ref,
+    uint32_t block_addr)
 {
 	ext4_filesystem_t *fs = inode_ref->fs;
 	ext4_superblock_t *sb = fs->superblock;
@@ -83,6 +176,7 @@ errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
 	/* Modify bitmap */
 	ext4_bitmap_free_bit(bitmap_block->data, index_in_group);
 	bitmap_block->dirty = true;
+	ext4_balloc_max_run_set(fs, block_group, EXT4_BALLOC_MAX_RUN_UNKNOWN);
 
 	/* Release block with bitmap */
 	rc = block_put(bitmap_block);
@@ -119,10 +213,36 @@ errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
-static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
+/** Free block.
+ *
+ * @param inode_ref  Inode, where the block is allocated
+ * @param block_addr Absolute block address to free
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
+{
+	fibril_mutex_lock(&inode_ref->fs->alloc_lock);
+	errno_t rc = ext4_balloc_free_block_locked(inode_ref, block_addr);
+	fibril_mutex_unlock(&inode_ref->fs->alloc_lock);
+	return rc;
+}
+
+/** Return continuous set of blocks within one group to free space.
+ *
+ * Blocks counts of i-nodes are not touched.
+ *
+ * @param fs    Filesystem
+ * @param first First block to release
+ * @param count Number of blocks to release
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_balloc_release_run_locked(ext4_filesystem_t *fs,
     uint32_t first, uint32_t count)
 {
-	ext4_filesystem_t *fs = inode_ref->fs;
 	ext4_superblock_t *sb = fs->superblock;
 
 	/* Compute indexes */
@@ -156,6 +276,8 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 	/* Modify bitmap */
 	ext4_bitmap_free_bits(bitmap_block->data, index_in_group_first, count);
 	bitmap_block->dirty = true;
+	ext4_balloc_max_run_set(fs, block_group_first,
+	    EXT4_BALLOC_MAX_RUN_UNKNOWN);
 
 	/* Release block with bitmap */
 	rc = block_put(bitmap_block);
@@ -165,21 +287,12 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 		return rc;
 	}
 
-	uint32_t block_size = ext4_superblock_get_block_size(sb);
-
 	/* Update superblock free blocks count */
 	uint32_t sb_free_blocks =
 	    ext4_superblock_get_free_blocks_count(sb);
 	sb_free_blocks += count;
 	ext4_superblock_set_free_blocks_count(sb, sb_free_blocks);
 
-	/* Update inode blocks count */
-	uint64_t ino_blocks =
-	    ext4_inode_get_blocks_count(sb, inode_ref->inode);
-	ino_blocks -= count * (block_size / EXT4_INODE_BLOCK_SIZE);
-	ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
-	inode_ref->dirty = true;
-
 	/* Update block group free blocks count */
 	uint32_t free_blocks =
 	    ext4_block_group_get_free_blocks_count(bg_ref->block_group, sb);
@@ -192,6 +305,44 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
+/** Return continuous set of blocks within one group to free space.
+ *
+ * @param fs    Filesystem
+ * @param first First block to release
+ * @param count Number of blocks to release
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_balloc_release_run(ext4_filesystem_t *fs,
+    uint32_t first, uint32_t count)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_balloc_release_run_locked(fs, first, count);
+	fibril_mutex_unlock(&fs->alloc_lock);
+	return rc;
+}
+
+static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
+    uint32_t first, uint32_t count)
+{
+	errno_t rc = ext4_balloc_release_run(inode_ref->fs, first, count);
+	if (rc != EOK)
+		return rc;
+
+	ext4_superblock_t *sb = inode_ref->fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	/* Update inode blocks count */
+	uint64_t ino_blocks =
+	    ext4_inode_get_blocks_count(sb, inode_ref->inode);
+	ino_blocks -= count * (block_size / EXT4_INODE_BLOCK_SIZE);
+	ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
+	inode_ref->dirty = true;
+
+	return EOK;
+}
+
 /** Free continuous set of blocks.
  *
  * @param inode_ref Inode, where the blocks are allocated
@@ -312,7 +463,7 @@ static errno_t ext4_balloc_find_goal(ext4_inode_ref_t *inode_ref, uint32_t *goal
 		if (rc != EOK)
 			return rc;
 
-		if (goal != 0) {
+		if (*goal != 0) {
 			(*goal)++;
 			return EOK;
 		}
@@ -343,7 +494,8 @@ static errno_t ext4_balloc_find_goal(ext4_inode_ref_t *inode_ref, uint32_t *goal
  * @return Error code
  *
  */
-errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
+static errno_t ext4_balloc_alloc_block_locked(ext4_inode_ref_t *inode_ref,
+    uint32_t *fblock)
 {
 	uint32_t allocated_block = 0;
 
@@ -614,6 +766,371 @@ success:
 	return rc;
 }
 
+/** Allocate new block.
+ *
+ * @param inode_ref Inode to allocate block for
+ * @param fblock    Output value - newly allocated block address
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
+{
+	fibril_mutex_lock(&inode_ref->fs->alloc_lock);
+	errno_t rc = ext4_balloc_alloc_block_locked(inode_ref, fblock);
+	fibril_mutex_unlock(&inode_ref->fs->alloc_lock);
+	return rc;
+}
+
+/** Allocate run of blocks in one block group.
+ *
+ * Block counts of i-nodes are not touched.
+ *
+ * @param fs        Filesystem
+ * @param bgid      Block group to allocate from
+ * @param goal      Preferred first block (0 if none), must lie in the group
+ * @param min_count Minimum number of blocks in the run unless a run starts
+ *                  right at the goal
+ * @param max_count Maximum number of blocks in the run
+ * @param fblock    Output value - address of the first allocated block
+ * @param allocated Output value - number of allocated blocks
+ *
+ * @return Error code, ENOSPC if there is no suitable run in the group
+ *
+ */
+static errno_t ext4_balloc_alloc_run_in_group(ext4_filesystem_t *fs,
+    uint32_t bgid, uint32_t goal, uint32_t min_count, uint32_t max_count,
+    uint32_t *fblock, uint32_t *allocated)
+{
+	ext4_superblock_t *sb = fs->superblock;
+
+	ext4_block_group_ref_t *bg_ref;
+	errno_t rc = ext4_filesystem_get_block_group_ref(fs, bgid, &bg_ref);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t free_blocks =
+	    ext4_block_group_get_free_blocks_count(bg_ref->block_group, sb);
+	if (free_blocks < min_count) {
+		ext4_balloc_max_run_set(fs, bgid,
+		    min(free_blocks, ext4_balloc_max_run_get(fs, bgid)));
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return ENOSPC;
+	}
+
+	/* Compute indexes */
+	uint32_t first_in_group =
+	    ext4_balloc_get_first_data_block_in_group(sb, bg_ref);
+	uint32_t first_in_group_index =
+	    ext4_filesystem_blockaddr2_index_in_group(sb, first_in_group);
+	uint32_t blocks_in_group =
+	    ext4_superblock_get_blocks_in_group(sb, bgid);
+
+	uint32_t start = first_in_group_index;
+	if (goal != 0) {
+		start = max(start,
+		    ext4_filesystem_blockaddr2_index_in_group(sb, goal));
+	}
+
+	/* Load block with bitmap */
+	uint32_t bitmap_block_addr =
+	    ext4_block_group_get_block_bitmap(bg_ref->block_group, sb);
+	block_t *bitmap_block;
+	rc = block_get(&bitmap_block, fs->device, bitmap_block_addr,
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	uint32_t index;
+	uint32_t len;
+	uint32_t longest;
+
+	/* Prefer continuing at the goal even with a shorter run */
+	if ((goal != 0) && (start < blocks_in_group) &&
+	    ext4_bitmap_is_free_bit(bitmap_block->data, start)) {
+		rc = ext4_bitmap_find_free_run(bitmap_block->data, start,
+		    blocks_in_group, 1, max_count, &index, &len, &longest);
+		if (rc == EOK)
+			goto found;
+	}
+
+	/* Search behind the goal first, then the whole group */
+	rc = ext4_bitmap_find_free_run(bitmap_block->data, start,
+	    blocks_in_group, min_count, max_count, &index, &len, &longest);
+	if ((rc != EOK) && (start != first_in_group_index)) {
+		rc = ext4_bitmap_find_free_run(bitmap_block->data,
+		    first_in_group_index, blocks_in_group, min_count,
+		    max_count, &index, &len, &longest);
+	}
+
+	if (rc != EOK) {
+		/* The whole group was scanned, remember its longest run */
+		ext4_balloc_max_run_set(fs, bgid, longest);
+
+		rc = block_put(bitmap_block);
+		if (rc != EOK) {
+			ext4_filesystem_put_block_group_ref(bg_ref);
+			return rc;
+		}
+
+		rc = ext4_filesystem_put_block_group_ref(bg_ref);
+		if (rc != EOK)
+			return rc;
+
+		return ENOSPC;
+	}
+
+found:
+	/* Mark all blocks of the run at once */
+	ext4_bitmap_set_bits(bitmap_block->data, index, len);
+	bitmap_block->dirty = true;
+
+	rc = block_put(bitmap_block);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	/* Update superblock free blocks count */
+	uint32_t sb_free_blocks = ext4_superblock_get_free_blocks_count(sb);
+	sb_free_blocks -= len;
+	ext4_superblock_set_free_blocks_count(sb, sb_free_blocks);
+
+	/* Update block group free blocks count */
+	free_blocks -= len;
+	ext4_block_group_set_free_blocks_count(bg_ref->block_group, sb,
+	    free_blocks);
+	bg_ref->dirty = true;
+
+	*fblock = ext4_filesystem_index_in_group2blockaddr(sb, index, bgid);
+	*allocated = len;
+
+	return ext4_filesystem_put_block_group_ref(bg_ref);
+}
+
+/** Allocate run of blocks near goal.
+ *
+ * Groups are tried starting from the one containing the goal. Groups
+ * known not to contain a long enough run are skipped without reading
+ * their bitmaps. Only if no group has a run of @a count blocks,
+ * a shorter run is accepted.
+ *
+ * Block counts of i-nodes are not touched.
+ *
+ * @param fs        Filesystem
+ * @param goal      Preferred first block (0 if none)
+ * @param count     Requested number of blocks
+ * @param fblock    Output value - address of the first allocated block
+ * @param allocated Output value - number of allocated blocks (at least 1)
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_balloc_alloc_run_locked(ext4_filesystem_t *fs,
+    uint32_t goal, uint32_t count, uint32_t *fblock, uint32_t *allocated)
+{
+	ext4_superblock_t *sb = fs->superblock;
+	uint32_t block_group_count = ext4_superblock_get_block_group_count(sb);
+
+	uint32_t goal_group = 0;
+	if (goal != 0) {
+		goal_group = ext4_filesystem_blockaddr2group(sb, goal);
+		if (goal_group >= block_group_count) {
+			goal = 0;
+			goal_group = 0;
+		}
+	}
+
+	/* The first pass demands the whole run, the second takes anything */
+	for (unsigned int pass = 0; pass < 2; pass++) {
+		uint32_t min_count = (pass == 0) ? count : 1;
+
+		for (uint32_t i = 0; i < block_group_count; i++) {
+			uint32_t bgid = (goal_group + i) % block_group_count;
+
+			if (ext4_balloc_max_run_get(fs, bgid) < min_count)
+				continue;
+
+			errno_t rc = ext4_balloc_alloc_run_in_group(fs, bgid,
+			    (i == 0) ? goal : 0, min_count, count, fblock,
+			    allocated);
+			if (rc != ENOSPC)
+				return rc;
+		}
+	}
+
+	return ENOSPC;
+}
+
+/** Allocate a run of consecutive blocks.
+ *
+ * @param fs        Filesystem
+ * @param goal      Preferred first block (0 if none)
+ * @param count     Requested number of blocks
+ * @param fblock    Output value - address of the first allocated block
+ * @param allocated Output value - number of allocated blocks (at least 1)
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_balloc_alloc_run(ext4_filesystem_t *fs, uint32_t goal,
+    uint32_t count, uint32_t *fblock, uint32_t *allocated)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_balloc_alloc_run_locked(fs, goal, count, fblock,
+	    allocated);
+	fibril_mutex_unlock(&fs->alloc_lock);
+	return rc;
+}
+
+/** Allocate continuous set of blocks.
+ *
+ * @param inode_ref Inode to allocate blocks for
+ * @param goal      Preferred first block (0 for default goal of the i-node)
+ * @param count     Requested number of blocks
+ * @param fblock    Output value - address of the first allocated block
+ * @param allocated Output value - number of allocated blocks, which may
+ *                  be less than requested if the free space is fragmented
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_alloc_blocks(ext4_inode_ref_t *inode_ref, uint32_t goal,
+    uint32_t count, uint32_t *fblock, uint32_t *allocated)
+{
+	errno_t rc;
+
+	if (goal == 0) {
+		rc = ext4_balloc_find_goal(inode_ref, &goal);
+		if (rc != EOK)
+			return rc;
+	}
+
+	rc = ext4_balloc_alloc_run(inode_ref->fs, goal, count, fblock,
+	    allocated);
+	if (rc != EOK)
+		return rc;
+
+	ext4_balloc_charge_inode(inode_ref, *allocated);
+	return EOK;
+}
+
+/** Allocate block for appending to i-node.
+ *
+ * Blocks are taken from the preallocation window of the i-node reference,
+ * which is refilled by allocating EXT4_BALLOC_PREALLOC_BLOCKS blocks at
+ * once. The bitmap and the group descriptor are thus modified only once
+ * per window instead of once per block.
+ *
+ * @param inode_ref Inode to allocate block for
+ * @param goal      Preferred block, typically the one following the last
+ *                  block of the i-node (0 for default goal)
+ * @param fblock    Output value - allocated block address
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_alloc_append_block(ext4_inode_ref_t *inode_ref,
+    uint32_t goal, uint32_t *fblock)
+{
+	errno_t rc;
+
+	/* Window not following the i-node data anymore is useless */
+	if ((inode_ref->prealloc_count > 0) && (goal != 0) &&
+	    (inode_ref->prealloc_start != goal)) {
+		rc = ext4_balloc_discard_prealloc(inode_ref);
+		if (rc != EOK)
+			return rc;
+	}
+
+	if (inode_ref->prealloc_count == 0) {
+		if (goal == 0) {
+			rc = ext4_balloc_find_goal(inode_ref, &goal);
+			if (rc != EOK)
+				return rc;
+		}
+
+		uint32_t start;
+		uint32_t count;
+		rc = ext4_balloc_alloc_run(inode_ref->fs, goal,
+		    EXT4_BALLOC_PREALLOC_BLOCKS, &start, &count);
+		if (rc != EOK)
+			return rc;
+
+		inode_ref->prealloc_start = start;
+		inode_ref->prealloc_count = count;
+	}
+
+	*fblock = inode_ref->prealloc_start;
+	inode_ref->prealloc_start++;
+	inode_ref->prealloc_count--;
+
+	ext4_balloc_charge_inode(inode_ref, 1);
+	return EOK;
+}
+
+/** Reserve preallocation window for a known number of appended blocks.
+ *
+ * Used when the amount of data to be appended is known in advance, so
+ * that all of the blocks can be taken from a single run instead of
+ * several windows scattered over the free space.
+ *
+ * @param inode_ref Inode to preallocate blocks for
+ * @param count     Number of blocks to be appended
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_prealloc(ext4_inode_ref_t *inode_ref, uint32_t count)
+{
+	if (inode_ref->prealloc_count >= count)
+		return EOK;
+
+	/* The window is reallocated with the same goal, but larger */
+	errno_t rc = ext4_balloc_discard_prealloc(inode_ref);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t goal;
+	rc = ext4_balloc_find_goal(inode_ref, &goal);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t start;
+	uint32_t allocated;
+	rc = ext4_balloc_alloc_run(inode_ref->fs, goal,
+	    max(count, EXT4_BALLOC_PREALLOC_BLOCKS), &start, &allocated);
+	if (rc != EOK)
+		return rc;
+
+	inode_ref->prealloc_start = start;
+	inode_ref->prealloc_count = allocated;
+	return EOK;
+}
+
+/** Return unused blocks of preallocation window to free space.
+ *
+ * @param inode_ref Inode owning the window
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_discard_prealloc(ext4_inode_ref_t *inode_ref)
+{
+	if (inode_ref->prealloc_count == 0)
+		return EOK;
+
+	errno_t rc = ext4_balloc_release_run(inode_ref->fs,
+	    inode_ref->prealloc_start, inode_ref->prealloc_count);
+	if (rc != EOK)
+		return rc;
+
+	inode_ref->prealloc_count = 0;
+	return EOK;
+}
+
 /** Try to allocate concrete block.
  *
  * @param inode_ref Inode to allocate block for
@@ -623,8 +1140,8 @@ success:
  * @return Error code
  *
  */
-errno_t ext4_balloc_try_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t fblock,
-    bool *free)
+static errno_t ext4_balloc_try_alloc_block_locked(ext4_inode_ref_t *inode_ref,
+    uint32_t fblock, bool *free)
 {
 	errno_t rc;
 
@@ -699,6 +1216,25 @@ terminate:
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
+/** Try to allocate concrete block.
+ *
+ * @param inode_ref Inode to allocate block for
+ * @param fblock    Block address to allocate
+ * @param free      Output value - if target block is free
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_try_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t fblock,
+    bool *free)
+{
+	fibril_mutex_lock(&inode_ref->fs->alloc_lock);
+	errno_t rc = ext4_balloc_try_alloc_block_locked(inode_ref, fblock,
+	    free);
+	fibril_mutex_unlock(&inode_ref->fs->alloc_lock);
+	return rc;
+}
+
 /**
  * @}
  */
@@ -134,6 +134,42 @@ void ext4_bitmap_set_bit(uint8_t *bitmap, uint32_t index)
 	*target |= 1 << bit_index;
 }
 
+/** Set continuous set of bits to 1 (used).
+ *
+ * Index and count must be checked by caller, if they aren't out of bounds.
+ *
+ * @param bitmap Pointer to bitmap
+ * @param index  Index of first bit to set
+ * @param count  Number of bits to be set
+ *
+ */
+void ext4_bitmap_set_bits(uint8_t *bitmap, uint32_t index, uint32_t count)
+{
+	uint32_t idx = index;
+	uint32_t remaining = count;
+
+	/* Set bits up to the byte boundary */
+	while (((idx % 8) != 0) && (remaining > 0)) {
+		bitmap[idx / 8] |= 1 << (idx % 8);
+		idx++;
+		remaining--;
+	}
+
+	/* Set the whole bytes */
+	while (remaining >= 8) {
+		bitmap[idx / 8] = 255;
+		idx += 8;
+		remaining -= 8;
+	}
+
+	/* Set the rest of bits */
+	while (remaining > 0) {
+		bitmap[idx / 8] |= 1 << (idx % 8);
+		idx++;
+		remaining--;
+	}
+}
+
 /** Check if requested bit is free.
  *
  * @param bitmap Pointer to bitmap
@@ -264,6 +300,76 @@ errno_t ext4_bitmap_find_free_bit_and_set(uint8_t *bitmap, uint32_t start_idx,
 	return ENOSPC;
 }
 
+/** Find run of free bits.
+ *
+ * Walk through bitmap and find the first run of at least @a min free bits.
+ * The run is not marked as used.
+ *
+ * @param bitmap  Pointer to bitmap
+ * @param start   Index of bit, where the algorithm will begin
+ * @param end     Index of the first bit behind the searched range
+ * @param min     Minimum length of the run
+ * @param max     Maximum length of the run to be reported
+ * @param index   Output value - index of the first bit of the run
+ * @param len     Output value - length of the run (at most @a max)
+ * @param longest Output value - length of the longest run seen, which is
+ *                the longest run in the whole range if none was found
+ *
+ * @return EOK if run found, ENOSPC otherwise
+ *
+ */
+errno_t ext4_bitmap_find_free_run(uint8_t *bitmap, uint32_t start,
+    uint32_t end, uint32_t min, uint32_t max, uint32_t *index, uint32_t *len,
+    uint32_t *longest)
+{
+	uint32_t idx = start;
+
+	*longest = 0;
+
+	while (idx < end) {
+		/* Skip used bytes (255 = 11111111 binary) */
+		if (((idx % 8) == 0) && (bitmap[idx / 8] == 255)) {
+			idx += 8;
+			continue;
+		}
+
+		if (!ext4_bitmap_is_free_bit(bitmap, idx)) {
+			idx++;
+			continue;
+		}
+
+		/* Measure the run, skipping free bytes as a whole */
+		uint32_t run_end = idx + 1;
+		while ((run_end < end) && (run_end - idx < max)) {
+			if (((run_end % 8) == 0) && (run_end + 8 <= end) &&
+			    (run_end - idx + 8 <= max) &&
+			    (bitmap[run_end / 8] == 0)) {
+				run_end += 8;
+				continue;
+			}
+
+			if (!ext4_bitmap_is_free_bit(bitmap, run_end))
+				break;
+
+			run_end++;
+		}
+
+		uint32_t run = run_end - idx;
+		if (run > *longest)
+			*longest = run;
+
+		if (run >= min) {
+			*index = idx;
+			*len = run;
+			return EOK;
+		}
+
+		idx = run_end;
+	}
+
+	return ENOSPC;
+}
+
 /**
  * @}
  */
@@ -445,11 +445,32 @@ errno_t ext4_directory_add_entry(ext4_inode_ref_t *parent, const char *name,
 			return EOK;
 	}
 
+	/*
+	 * Directory is about to outgrow its first block, switch to the index
+	 * (if allowed) so that it does not have to be searched linearly
+	 */
+	errno_t rc;
+	if ((total_blocks == 1) &&
+	    (ext4_superblock_has_feature_compatible(fs->superblock,
+	    EXT4_FEATURE_COMPAT_DIR_INDEX)) &&
+	    (!ext4_inode_has_flag(parent->inode, EXT4_INODE_FLAG_INDEX))) {
+		rc = ext4_directory_dx_build(parent);
+		if (rc == EOK) {
+			ext4_inode_set_flag(parent->inode, EXT4_INODE_FLAG_INDEX);
+			parent->dirty = true;
+
+			return ext4_directory_dx_add_entry(parent, child, name);
+		}
+
+		if (rc != ENOTSUP)
+			return rc;
+	}
+
 	/* No free block found - needed to allocate next data block */
 
 	iblock = 0;
 	fblock = 0;
-	errno_t rc = ext4_filesystem_append_inode_block(parent, &fblock, &iblock);
+	rc = ext4_filesystem_append_inode_block(parent, &fblock, &iblock);
 	if (rc != EOK)
 		return rc;
 
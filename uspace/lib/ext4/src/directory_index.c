@@ -35,6 +35,7 @@
  */
 
 #include <byteorder.h>
+#include <align.h>
 #include <errno.h>
 #include <mem.h>
 #include <stdlib.h>
@@ -228,34 +229,32 @@ void ext4_directory_dx_entry_set_block(ext4_directory_dx_entry_t *entry,
 	entry->block = host2uint32_t_le(block);
 }
 
-/** Initialize index structure of new directory.
+/** Initialize index root in block 0 of directory.
  *
- * @param dir Pointer to directory i-node
+ * Everything behind the '.' and '..' entries is overwritten, the '..' entry
+ * is extended to cover the rest of the block.
  *
- * @return Error code
+ * @param sb     Superblock
+ * @param block  Block 0 of directory, starting with '.' and '..' entries
+ * @param iblock Logical number of the only leaf block of the index
  *
  */
-errno_t ext4_directory_dx_init(ext4_inode_ref_t *dir)
+static void ext4_directory_dx_root_init(ext4_superblock_t *sb, block_t *block,
+    uint32_t iblock)
 {
-	/* Load block 0, where will be index root located */
-	uint32_t fblock;
-	errno_t rc = ext4_filesystem_get_inode_data_block_index(dir, 0,
-	    &fblock);
-	if (rc != EOK)
-		return rc;
-
-	block_t *block;
-	rc = block_get(&block, dir->fs->device, fblock, BLOCK_FLAGS_NONE);
-	if (rc != EOK)
-		return rc;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
 
 	/* Initialize pointers to data structures */
 	ext4_directory_dx_root_t *root = block->data;
 	ext4_directory_dx_root_info_t *info = &(root->info);
 
+	ext4_directory_entry_ll_set_entry_length(
+	    (ext4_directory_entry_ll_t *) &root->dots[1],
+	    block_size - sizeof(ext4_directory_dx_dot_entry_t));
+	memset(info, 0, block_size - 2 * sizeof(ext4_directory_dx_dot_entry_t));
+
 	/* Initialize root info structure */
-	uint8_t hash_version =
-	    ext4_superblock_get_default_hash_version(dir->fs->superblock);
+	uint8_t hash_version = ext4_superblock_get_default_hash_version(sb);
 
 	ext4_directory_dx_root_info_set_hash_version(info, hash_version);
 	ext4_directory_dx_root_info_set_indirect_levels(info, 0);
@@ -266,14 +265,43 @@ errno_t ext4_directory_dx_init(ext4_inode_ref_t *dir)
 	    (ext4_directory_dx_countlimit_t *) &root->entries;
 	ext4_directory_dx_countlimit_set_count(countlimit, 1);
 
-	uint32_t block_size =
-	    ext4_superblock_get_block_size(dir->fs->superblock);
 	uint32_t entry_space =
 	    block_size - 2 * sizeof(ext4_directory_dx_dot_entry_t) -
 	    sizeof(ext4_directory_dx_root_info_t);
 	uint16_t root_limit = entry_space / sizeof(ext4_directory_dx_entry_t);
 	ext4_directory_dx_countlimit_set_limit(countlimit, root_limit);
 
+	/* Connect the leaf block to the only entry in index */
+	ext4_directory_dx_entry_t *entry = root->entries;
+	ext4_directory_dx_entry_set_block(entry, iblock);
+
+	block->dirty = true;
+}
+
+/** Initialize index structure of new directory.
+ *
+ * @param dir Pointer to directory i-node
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_directory_dx_init(ext4_inode_ref_t *dir)
+{
+	/* Load block 0, where will be index root located */
+	uint32_t fblock;
+	errno_t rc = ext4_filesystem_get_inode_data_block_index(dir, 0,
+	    &fblock);
+	if (rc != EOK)
+		return rc;
+
+	block_t *block;
+	rc = block_get(&block, dir->fs->device, fblock, BLOCK_FLAGS_NONE);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t block_size =
+	    ext4_superblock_get_block_size(dir->fs->superblock);
+
 	/* Append new block, where will be new entries inserted in the future */
 	uint32_t iblock;
 	rc = ext4_filesystem_append_inode_block(dir, &fblock, &iblock);
@@ -301,11 +329,115 @@ errno_t ext4_directory_dx_init(ext4_inode_ref_t *dir)
 		return rc;
 	}
 
-	/* Connect new block to the only entry in index */
-	ext4_directory_dx_entry_t *entry = root->entries;
-	ext4_directory_dx_entry_set_block(entry, iblock);
+	ext4_directory_dx_root_init(dir->fs->superblock, block, iblock);
 
-	block->dirty = true;
+	return block_put(block);
+}
+
+/** Convert linear directory occupying a single block to indexed one.
+ *
+ * All entries except '.' and '..' are moved from block 0 to a newly
+ * allocated leaf block and block 0 is turned into the index root.
+ * The caller is responsible for setting the index flag of the i-node.
+ *
+ * @param dir Pointer to directory i-node
+ *
+ * @return Error code, ENOTSUP if block 0 does not start with
+ *         the '.' and '..' entries in the expected layout
+ *
+ */
+errno_t ext4_directory_dx_build(ext4_inode_ref_t *dir)
+{
+	ext4_superblock_t *sb = dir->fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	uint32_t fblock;
+	errno_t rc = ext4_filesystem_get_inode_data_block_index(dir, 0,
+	    &fblock);
+	if (rc != EOK)
+		return rc;
+
+	block_t *block;
+	rc = block_get(&block, dir->fs->device, fblock, BLOCK_FLAGS_NONE);
+	if (rc != EOK)
+		return rc;
+
+	/* Root must begin with '.' (12 bytes long) followed by '..' */
+	ext4_directory_dx_root_t *root = block->data;
+	ext4_directory_entry_ll_t *dot =
+	    (ext4_directory_entry_ll_t *) &root->dots[0];
+	ext4_directory_entry_ll_t *dotdot =
+	    (ext4_directory_entry_ll_t *) &root->dots[1];
+
+	if ((ext4_directory_entry_ll_get_entry_length(dot) !=
+	    sizeof(ext4_directory_dx_dot_entry_t)) ||
+	    (ext4_directory_entry_ll_get_name_length(sb, dot) != 1) ||
+	    (ext4_directory_entry_ll_get_name_length(sb, dotdot) != 2) ||
+	    (memcmp(dotdot->name, "..", 2) != 0)) {
+		block_put(block);
+		return ENOTSUP;
+	}
+
+	uint32_t iblock;
+	rc = ext4_filesystem_append_inode_block(dir, &fblock, &iblock);
+	if (rc != EOK) {
+		block_put(block);
+		return rc;
+	}
+
+	block_t *new_block;
+	rc = block_get(&new_block, dir->fs->device, fblock, BLOCK_FLAGS_NOREAD);
+	if (rc != EOK) {
+		block_put(block);
+		return rc;
+	}
+
+	/* Move all valid entries behind '..' to the new block */
+	memset(new_block->data, 0, block_size);
+
+	ext4_directory_entry_ll_t *dentry = (void *) dotdot +
+	    ext4_directory_entry_ll_get_entry_length(dotdot);
+	ext4_directory_entry_ll_t *last = NULL;
+	void *stop = block->data + block_size;
+	uint32_t offset = 0;
+
+	while ((void *) dentry < stop) {
+		uint16_t rec_len = ext4_directory_entry_ll_get_entry_length(dentry);
+		if (rec_len == 0)
+			break;
+
+		if (ext4_directory_entry_ll_get_inode(dentry) != 0) {
+			uint16_t name_len =
+			    ext4_directory_entry_ll_get_name_length(sb, dentry);
+			uint32_t used_len = ALIGN_UP(
+			    sizeof(ext4_fake_directory_entry_t) + name_len, 4);
+
+			last = new_block->data + offset;
+			memcpy(last, dentry, used_len);
+			ext4_directory_entry_ll_set_entry_length(last, used_len);
+			offset += used_len;
+		}
+
+		dentry = (void *) dentry + rec_len;
+	}
+
+	/* The last entry spans to the end of the block */
+	if (last != NULL) {
+		ext4_directory_entry_ll_set_entry_length(last,
+		    block_size - ((void *) last - new_block->data));
+	} else {
+		ext4_directory_entry_ll_set_entry_length(new_block->data,
+		    block_size);
+	}
+
+	new_block->dirty = true;
+	rc = block_put(new_block);
+	if (rc != EOK) {
+		block_put(block);
+		return rc;
+	}
+
+	ext4_directory_dx_root_init(sb, block, iblock);
 
 	return block_put(block);
 }
@@ -458,7 +590,7 @@ static errno_t ext4_directory_dx_get_leaf(ext4_hash_info_t *hinfo,
 
 		uint16_t entry_space =
 		    ext4_superblock_get_block_size(inode_ref->fs->superblock) -
-		    sizeof(ext4_directory_dx_dot_entry_t);
+		    sizeof(ext4_fake_directory_entry_t);
 		entry_space = entry_space / sizeof(ext4_directory_dx_entry_t);
 
 		if (limit != entry_space) {
@@ -638,7 +770,7 @@ errno_t ext4_directory_dx_find_entry(ext4_directory_search_result_t *result,
 		/* check if the next block could be checked */
 		rc = ext4_directory_dx_next_block(inode_ref, hinfo.hash,
 		    dx_block, &dx_blocks[0]);
-		if (rc != EOK)
+		if ((rc != EOK) && (rc != ENOENT))
 			goto cleanup;
 
 	} while (rc == ENOENT);
@@ -831,6 +963,12 @@ static errno_t ext4_directory_dx_split_data(ext4_inode_ref_t *inode_ref,
 		current_size += sort_array[i].rec_len;
 	}
 
+	/* Keep at least one entry in the old block */
+	if ((mid == 0) && (idx > 1)) {
+		mid = 1;
+		new_hash = sort_array[mid].hash;
+	}
+
 	/* Check hash collision */
 	uint32_t continued = 0;
 	if (new_hash == sort_array[mid - 1].hash)
@@ -891,14 +1029,16 @@ static errno_t ext4_directory_dx_split_data(ext4_inode_ref_t *inode_ref,
  *
  * @param inode_ref Directory i-node
  * @param dx_blocks Array with path from root to leaf node
- * @param dx_block  Leaf block to be split if needed
+ * @param dx_blockp Leaf block to be split if needed, updated when a new
+ *                  level is added to the tree
  *
  * @return Error code
  *
  */
 static errno_t ext4_directory_dx_split_index(ext4_inode_ref_t *inode_ref,
-    ext4_directory_dx_block_t *dx_blocks, ext4_directory_dx_block_t *dx_block)
+    ext4_directory_dx_block_t *dx_blocks, ext4_directory_dx_block_t **dx_blockp)
 {
+	ext4_directory_dx_block_t *dx_block = *dx_blockp;
 	ext4_directory_dx_entry_t *entries;
 	if (dx_block == dx_blocks)
 		entries =
@@ -954,6 +1094,11 @@ static errno_t ext4_directory_dx_split_index(ext4_inode_ref_t *inode_ref,
 		uint32_t block_size =
 		    ext4_superblock_get_block_size(inode_ref->fs->superblock);
 
+		/* Node is seen as a single empty entry by linear readers */
+		memset(&new_node->fake, 0, sizeof(ext4_fake_directory_entry_t));
+		ext4_directory_entry_ll_set_entry_length(
+		    (ext4_directory_entry_ll_t *) &new_node->fake, block_size);
+
 		/* Split leaf node */
 		if (levels > 0) {
 			uint32_t count_left = leaf_count / 2;
@@ -997,6 +1142,8 @@ static errno_t ext4_directory_dx_split_index(ext4_inode_ref_t *inode_ref,
 			/* Finally insert new entry */
 			ext4_directory_dx_insert_entry(dx_blocks, hash_right, new_iblock);
 
+			/* Block which is not on the path anymore */
+			new_block->dirty = true;
 			return block_put(new_block);
 		} else {
 			/* Create second level index */
@@ -1023,12 +1170,18 @@ static errno_t ext4_directory_dx_split_index(ext4_inode_ref_t *inode_ref,
 
 			((ext4_directory_dx_root_t *)
 			    dx_blocks[0].block->data)->info.indirect_levels = 1;
+			dx_blocks[0].block->dirty = true;
 
 			/* Add new entry to the path */
 			dx_block = dx_blocks + 1;
-			dx_block->position = dx_block->position - entries + new_entries;
+			dx_block->position =
+			    dx_blocks[0].position - entries + new_entries;
 			dx_block->entries = new_entries;
 			dx_block->block = new_block;
+			new_block->dirty = true;
+
+			dx_blocks[0].position = entries;
+			*dx_blockp = dx_block;
 		}
 	}
 
@@ -1114,7 +1267,7 @@ errno_t ext4_directory_dx_add_entry(ext4_inode_ref_t *parent,
 	 * Check if there is needed to split index node
 	 * (and recursively also parent nodes)
 	 */
-	rc = ext4_directory_dx_split_index(parent, dx_blocks, dx_block);
+	rc = ext4_directory_dx_split_index(parent, dx_blocks, &dx_block);
 	if (rc != EOK)
 		goto release_target_index;
 
@@ -1138,9 +1291,9 @@ errno_t ext4_directory_dx_add_entry(ext4_inode_ref_t *parent,
 		    child, name, name_len);
 
 	/* Cleanup */
-	rc = block_put(new_block);
-	if (rc != EOK)
-		return rc;
+	rc2 = block_put(new_block);
+	if (rc == EOK)
+		rc = rc2;
 
 	/* Cleanup operations */
 
@@ -36,6 +36,7 @@
 
 #include <byteorder.h>
 #include <errno.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include "ext4/balloc.h"
@@ -360,19 +361,111 @@ static void ext4_extent_binsearch(ext4_extent_header_t *header,
 	*extent = l - 1;
 }
 
-/** Find physical block in the extent tree by logical block number.
+/** Look up a logical block in the extent status cache of an i-node.
+ *
+ * @param inode_ref I-node reference owning the cache
+ * @param iblock    Logical block number to find
+ *
+ * @return Cached run containing iblock or NULL if there is none
+ *
+ */
+static ext4_extent_status_t *ext4_extent_cache_find(ext4_inode_ref_t *inode_ref,
+    uint32_t iblock)
+{
+	unsigned int l = 0;
+	unsigned int r = inode_ref->extent_cache_count;
+
+	/* Find the first entry starting after iblock */
+	while (l < r) {
+		unsigned int m = l + (r - l) / 2;
+
+		if (iblock < inode_ref->extent_cache[m].iblock)
+			r = m;
+		else
+			l = m + 1;
+	}
+
+	if (l == 0)
+		return NULL;
+
+	ext4_extent_status_t *es = &inode_ref->extent_cache[l - 1];
+	if (iblock - es->iblock >= es->count)
+		return NULL;
+
+	return es;
+}
+
+/** Insert an extent into the extent status cache of an i-node.
+ *
+ * Entry starting at the same logical block is replaced, so that an extent
+ * which has grown since it was cached is picked up. When the cache is full,
+ * the entry farthest from the new one is evicted.
+ *
+ * @param inode_ref I-node reference owning the cache
+ * @param iblock    First logical block of the extent
+ * @param count     Number of blocks in the extent
+ * @param fblock    First physical block of the extent
+ *
+ */
+static void ext4_extent_cache_insert(ext4_inode_ref_t *inode_ref,
+    uint32_t iblock, uint32_t count, uint64_t fblock)
+{
+	ext4_extent_status_t *cache = inode_ref->extent_cache;
+	unsigned int n = inode_ref->extent_cache_count;
+	unsigned int pos = 0;
+
+	while (pos < n && cache[pos].iblock < iblock)
+		pos++;
+
+	if (pos < n && cache[pos].iblock == iblock) {
+		/* Refresh existing entry */
+		cache[pos].count = count;
+		cache[pos].fblock = fblock;
+		return;
+	}
+
+	if (n == EXT4_EXTENT_CACHE_SIZE) {
+		if (pos > n / 2) {
+			/* Inserting in the upper half, evict the first entry */
+			memmove(&cache[0], &cache[1],
+			    (pos - 1) * sizeof(ext4_extent_status_t));
+			pos--;
+		} else {
+			/* Inserting in the lower half, evict the last entry */
+			n--;
+			memmove(&cache[pos + 1], &cache[pos],
+			    (n - pos) * sizeof(ext4_extent_status_t));
+		}
+	} else {
+		memmove(&cache[pos + 1], &cache[pos],
+		    (n - pos) * sizeof(ext4_extent_status_t));
+		n++;
+	}
+
+	cache[pos].iblock = iblock;
+	cache[pos].count = count;
+	cache[pos].fblock = fblock;
+	inode_ref->extent_cache_count = n;
+}
+
+/** Find run of physical blocks in the extent tree by logical block number.
  *
- * There is no need to save path in the tree during this algorithm.
+ * The extent status cache of the i-node is consulted first, the tree is
+ * walked only on a miss and the found extent is cached afterwards.
  *
  * @param inode_ref I-node to load block from
  * @param iblock    Logical block number to find
- * @param fblock    Output value for physical block number
+ * @param fblock    Output value for physical block number (0 for hole)
+ * @param count     Output value for number of consecutive logical blocks
+ *                  starting at iblock which are mapped to consecutive
+ *                  physical blocks starting at fblock (or which all are
+ *                  holes if fblock is 0)
  *
  * @return Error code
  *
  */
-errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
-    uint32_t *fblock)
+errno_t ext4_extent_find_run(ext4_inode_ref_t *inode_ref, uint32_t iblock,
+    uint32_t *fblock, uint32_t *count)
 {
 	errno_t rc = EOK;
 	/* Compute bound defined by i-node size */
@@ -385,8 +478,18 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 	uint32_t last_idx = (inode_size - 1) / block_size;
 
 	/* Check if requested iblock is not over size of i-node */
-	if (iblock > last_idx) {
+	if (inode_size == 0 || iblock > last_idx) {
 		*fblock = 0;
+		*count = 1;
+		return EOK;
+	}
+
+	uint32_t max_count = last_idx - iblock + 1;
+
+	ext4_extent_status_t *es = ext4_extent_cache_find(inode_ref, iblock);
+	if (es != NULL) {
+		*fblock = es->fblock + (iblock - es->iblock);
+		*count = min(es->count - (iblock - es->iblock), max_count);
 		return EOK;
 	}
 
@@ -422,16 +525,33 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 	ext4_extent_t *extent = NULL;
 	ext4_extent_binsearch(header, &extent, iblock);
 
+	*fblock = 0;
+	*count = 1;
+
 	/* Prevent empty leaf */
-	if (extent == NULL) {
-		*fblock = 0;
-	} else {
-		/* Compute requested physical block address */
-		uint32_t phys_block;
+	if (extent != NULL) {
+		ext4_extent_t *last = EXT4_EXTENT_FIRST(header) +
+		    ext4_extent_header_get_entries_count(header) - 1;
 		uint32_t first = ext4_extent_get_first_block(extent);
-		phys_block = ext4_extent_get_start(extent) + iblock - first;
-
-		*fblock = phys_block;
+		uint32_t length = ext4_extent_get_block_count(extent);
+
+		if (iblock < first) {
+			/* Hole in front of the first extent of the leaf */
+			*count = min(first - iblock, max_count);
+		} else if (iblock - first < length) {
+			/* Compute requested physical block address */
+			uint64_t start = ext4_extent_get_start(extent);
+
+			*fblock = start + iblock - first;
+			*count = min(length - (iblock - first), max_count);
+
+			ext4_extent_cache_insert(inode_ref, first, length,
+			    start);
+		} else if (extent < last) {
+			/* Hole between two extents of the leaf */
+			uint32_t next = ext4_extent_get_first_block(extent + 1);
+			*count = min(next - iblock, max_count);
+		}
 	}
 
 	/* Cleanup */
@@ -441,6 +561,23 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 	return rc;
 }
 
+/** Find physical block in the extent tree by logical block number.
+ *
+ * @param inode_ref I-node to load block from
+ * @param iblock    Logical block number to find
+ * @param fblock    Output value for physical block number
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
+    uint32_t *fblock)
+{
+	uint32_t count;
+
+	return ext4_extent_find_run(inode_ref, iblock, fblock, &count);
+}
+
 /** Find extent for specified iblock.
  *
  * This function is used for finding block in the extent tree with
@@ -619,6 +756,9 @@ static errno_t ext4_extent_release_branch(ext4_inode_ref_t *inode_ref,
 errno_t ext4_extent_release_blocks_from(ext4_inode_ref_t *inode_ref,
     uint32_t iblock_from)
 {
+	/* Cached extents may refer to blocks which are going to be freed */
+	inode_ref->extent_cache_count = 0;
+
 	/* Find the first extent to modify */
 	ext4_extent_path_t *path;
 	errno_t rc2;
@@ -1001,7 +1141,8 @@ errno_t ext4_extent_append_block(ext4_inode_ref_t *inode_ref, uint32_t *iblock,
 		/* There is space for new block in the extent */
 		if (block_count == 0) {
 			/* Existing extent is empty */
-			rc = ext4_balloc_alloc_block(inode_ref, &phys_block);
+			rc = ext4_balloc_alloc_append_block(inode_ref, 0,
+			    &phys_block);
 			if (rc != EOK)
 				goto finish;
 
@@ -1021,18 +1162,18 @@ errno_t ext4_extent_append_block(ext4_inode_ref_t *inode_ref, uint32_t *iblock,
 			goto finish;
 		} else {
 			/* Existing extent contains some blocks */
-			phys_block = ext4_extent_get_start(path_ptr->extent);
-			phys_block += ext4_extent_get_block_count(path_ptr->extent);
+			uint32_t goal = ext4_extent_get_start(path_ptr->extent);
+			goal += ext4_extent_get_block_count(path_ptr->extent);
 
-			/* Check if the following block is free for allocation */
-			bool free;
-			rc = ext4_balloc_try_alloc_block(inode_ref, phys_block, &free);
+			/* Try to allocate the following block */
+			rc = ext4_balloc_alloc_append_block(inode_ref, goal,
+			    &phys_block);
 			if (rc != EOK)
 				goto finish;
 
-			if (!free) {
+			if (phys_block != goal) {
 				/* Target is not free, new block must be appended to new extent */
-				goto append_extent;
+				goto append_allocated;
 			}
 
 			/* Update extent */
@@ -1055,10 +1196,11 @@ append_extent:
 	phys_block = 0;
 
 	/* Allocate new data block */
-	rc = ext4_balloc_alloc_block(inode_ref, &phys_block);
+	rc = ext4_balloc_alloc_append_block(inode_ref, 0, &phys_block);
 	if (rc != EOK)
 		goto finish;
 
+append_allocated:
 	/* Append extent for new block (includes tree splitting if needed) */
 	rc = ext4_extent_append_extent(inode_ref, path, new_block_idx);
 	if (rc != EOK) {
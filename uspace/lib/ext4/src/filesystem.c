@@ -38,6 +38,8 @@
 
 #include <byteorder.h>
 #include <errno.h>
+#include <fibril.h>
+#include <macros.h>
 #include <mem.h>
 #include <align.h>
 #include <crypto.h>
@@ -57,7 +59,10 @@
 #include "ext4/superblock.h"
 
 static errno_t ext4_filesystem_check_features(ext4_filesystem_t *, bool *);
-static errno_t ext4_filesystem_init_block_groups(ext4_filesystem_t *);
+static errno_t ext4_filesystem_init_block_groups(ext4_filesystem_t *, bool);
+static errno_t ext4_filesystem_init_inode_table(ext4_block_group_ref_t *);
+static void ext4_filesystem_itable_start(ext4_filesystem_t *);
+static void ext4_filesystem_itable_stop(ext4_filesystem_t *);
 static errno_t ext4_filesystem_alloc_this_inode(ext4_filesystem_t *,
     uint32_t, ext4_inode_ref_t **, int);
 static uint32_t ext4_filesystem_inodes_per_block(ext4_superblock_t *);
@@ -137,6 +142,15 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 	if (rc != EOK)
 		goto err_2;
 
+	rc = ext4_balloc_init(fs);
+	if (rc != EOK)
+		goto err_2;
+
+	fibril_mutex_initialize(&fs->itable_lock);
+	fibril_condvar_initialize(&fs->itable_cv);
+	fs->itable_running = false;
+	fs->itable_stop = false;
+
 	return EOK;
 err_2:
 	block_cache_fini(fs->device);
@@ -155,6 +169,8 @@ err:
  */
 static void ext4_filesystem_fini(ext4_filesystem_t *fs)
 {
+	ext4_balloc_fini(fs);
+
 	/* Release memory space for superblock */
 	free(fs->superblock);
 
@@ -307,7 +323,7 @@ errno_t ext4_filesystem_create(ext4_cfg_t *cfg, service_id_t service_id)
 	fs_inited = true;
 
 	/* Init block groups */
-	rc = ext4_filesystem_init_block_groups(fs);
+	rc = ext4_filesystem_init_block_groups(fs, cfg->lazy_itable_init);
 	if (rc != EOK)
 		goto err;
 
@@ -459,6 +475,10 @@ errno_t ext4_filesystem_open(ext4_instance_t *inst, service_id_t service_id,
 	*size = ext4_inode_get_size(fs->superblock, enode->inode_ref->inode);
 
 	ext4_node_put(root_node);
+
+	/* Zero the i-node tables left uninitialized by mkfs */
+	ext4_filesystem_itable_start(fs);
+
 	*rfs = fs;
 	return EOK;
 error:
@@ -481,6 +501,8 @@ error:
  */
 errno_t ext4_filesystem_close(ext4_filesystem_t *fs)
 {
+	ext4_filesystem_itable_stop(fs);
+
 	/* Write the superblock to the device */
 	ext4_superblock_set_state(fs->superblock, EXT4_SUPERBLOCK_STATE_VALID_FS);
 	errno_t rc = ext4_superblock_write_direct(fs->device, fs->superblock);
@@ -595,8 +617,12 @@ uint32_t ext4_filesystem_blockaddr2group(ext4_superblock_t *sb, uint64_t b)
 }
 
 /** Initialize block group structures
+ *
+ * @param fs   Filesystem
+ * @param lazy Leave the i-node tables to be zeroed after mounting
  */
-static errno_t ext4_filesystem_init_block_groups(ext4_filesystem_t *fs)
+static errno_t ext4_filesystem_init_block_groups(ext4_filesystem_t *fs,
+    bool lazy)
 {
 	errno_t rc;
 	block_t *block;
@@ -678,6 +704,8 @@ static errno_t ext4_filesystem_init_block_groups(ext4_filesystem_t *fs)
 			    free_inodes);
 			ext4_block_group_set_used_dirs_count(bg, sb,
 			    used_dirs);
+			ext4_block_group_set_itable_unused(bg, sb,
+			    ext4_superblock_get_inodes_in_group(sb, bg_index));
 
 			/// XX Lazy
 			ext4_block_group_set_flag(bg,
@@ -719,6 +747,17 @@ static errno_t ext4_filesystem_init_block_groups(ext4_filesystem_t *fs)
 		    sb, free_blocks);
 		bg_ref->dirty = true;
 
+		if (!lazy) {
+			rc = ext4_filesystem_init_inode_table(bg_ref);
+			if (rc != EOK) {
+				ext4_filesystem_put_block_group_ref(bg_ref);
+				return rc;
+			}
+
+			ext4_block_group_set_flag(bg_ref->block_group,
+			    EXT4_BLOCK_GROUP_ITABLE_ZEROED);
+		}
+
 		rc = ext4_filesystem_put_block_group_ref(bg_ref);
 		if (rc != EOK)
 			return rc;
@@ -849,7 +888,38 @@ static errno_t ext4_filesystem_init_inode_bitmap(ext4_block_group_ref_t *bg_ref)
 	return block_put(bitmap_block);
 }
 
+/** Zero blocks of the file system on the device.
+ *
+ * Blocks held in the block cache are not updated, the blocks must not be
+ * in use.
+ *
+ * @param fs     Filesystem
+ * @param fblock First block to zero
+ * @param count  Number of blocks
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_filesystem_zero_blocks(ext4_filesystem_t *fs,
+    aoff64_t fblock, aoff64_t count)
+{
+	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
+	size_t dev_bsize;
+
+	errno_t rc = block_get_bsize(fs->device, &dev_bsize);
+	if (rc != EOK)
+		return rc;
+
+	aoff64_t ratio = block_size / dev_bsize;
+
+	return block_write_zeroes(fs->device, fblock * ratio, count * ratio);
+}
+
 /** Initialize i-node table in block group.
+ *
+ * Only the blocks past the i-nodes that were ever used, as recorded by the
+ * count of unused i-nodes of the block group, are zeroed. The blocks are
+ * zeroed on the device at once rather than through the block cache.
  *
  * @param bg_ref Reference to block group
  *
@@ -860,40 +930,133 @@ static errno_t ext4_filesystem_init_inode_table(ext4_block_group_ref_t *bg_ref)
 {
 	ext4_superblock_t *sb = bg_ref->fs->superblock;
 
-	uint32_t block_size = ext4_superblock_get_block_size(sb);
 	uint32_t inodes_per_block = ext4_filesystem_inodes_per_block(sb);
 
 	uint32_t inodes_in_group =
 	    ext4_superblock_get_inodes_in_group(sb, bg_ref->index);
+	uint32_t unused = min(inodes_in_group,
+	    ext4_block_group_get_itable_unused(bg_ref->block_group, sb));
 
-	uint32_t table_blocks = inodes_in_group / inodes_per_block;
+	uint32_t table_blocks =
+	    (inodes_in_group + inodes_per_block - 1) / inodes_per_block;
+	uint32_t used_blocks = (inodes_in_group - unused +
+	    inodes_per_block - 1) / inodes_per_block;
 
-	if (inodes_in_group % inodes_per_block)
-		table_blocks++;
+	if (used_blocks >= table_blocks)
+		return EOK;
 
 	/* Compute initialization bounds */
-	uint32_t first_block = ext4_block_group_get_inode_table_first_block(
-	    bg_ref->block_group, sb);
+	aoff64_t first_block = ext4_block_group_get_inode_table_first_block(
+	    bg_ref->block_group, sb) + used_blocks;
 
-	uint32_t last_block = first_block + table_blocks - 1;
+	return ext4_filesystem_zero_blocks(bg_ref->fs, first_block,
+	    table_blocks - used_blocks);
+}
 
-	/* Initialization of all itable blocks */
-	for (uint32_t fblock = first_block; fblock <= last_block; ++fblock) {
-		block_t *block;
-		errno_t rc = block_get(&block, bg_ref->fs->device, fblock,
-		    BLOCK_FLAGS_NOREAD);
-		if (rc != EOK)
+/** Zero the i-node table of a block group unless it is zeroed already.
+ *
+ * @param fs   Filesystem
+ * @param bgid Index of the block group
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_filesystem_zero_group(ext4_filesystem_t *fs, uint32_t bgid)
+{
+	ext4_block_group_ref_t *bg_ref;
+
+	errno_t rc = ext4_filesystem_get_block_group_ref(fs, bgid, &bg_ref);
+	if (rc != EOK)
+		return rc;
+
+	if (!ext4_block_group_has_flag(bg_ref->block_group,
+	    EXT4_BLOCK_GROUP_ITABLE_ZEROED)) {
+		rc = ext4_filesystem_init_inode_table(bg_ref);
+		if (rc != EOK) {
+			ext4_filesystem_put_block_group_ref(bg_ref);
 			return rc;
+		}
 
-		memset(block->data, 0, block_size);
-		block->dirty = true;
+		ext4_block_group_set_flag(bg_ref->block_group,
+		    EXT4_BLOCK_GROUP_ITABLE_ZEROED);
+		bg_ref->dirty = true;
+	}
+
+	return ext4_filesystem_put_block_group_ref(bg_ref);
+}
+
+/** Fibril zeroing the i-node tables in the background.
+ *
+ * Each block group is zeroed with the allocation lock held so that no
+ * i-node of the group can be allocated in the meantime.
+ *
+ * @param arg Filesystem
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_filesystem_itable_fibril(void *arg)
+{
+	ext4_filesystem_t *fs = (ext4_filesystem_t *) arg;
+	uint32_t bg_count =
+	    ext4_superblock_get_block_group_count(fs->superblock);
+	errno_t rc = EOK;
+
+	for (uint32_t bgid = 0; bgid < bg_count; bgid++) {
+		fibril_mutex_lock(&fs->itable_lock);
+		bool stop = fs->itable_stop;
+		fibril_mutex_unlock(&fs->itable_lock);
+
+		if (stop)
+			break;
+
+		fibril_mutex_lock(&fs->alloc_lock);
+		rc = ext4_filesystem_zero_group(fs, bgid);
+		fibril_mutex_unlock(&fs->alloc_lock);
 
-		rc = block_put(block);
 		if (rc != EOK)
-			return rc;
+			break;
 	}
 
-	return EOK;
+	fibril_mutex_lock(&fs->itable_lock);
+	fs->itable_running = false;
+	fibril_condvar_broadcast(&fs->itable_cv);
+	fibril_mutex_unlock(&fs->itable_lock);
+
+	return rc;
+}
+
+/** Start zeroing the i-node tables which are not zeroed yet.
+ *
+ * @param fs Filesystem
+ *
+ */
+static void ext4_filesystem_itable_start(ext4_filesystem_t *fs)
+{
+	fid_t fid = fibril_create(ext4_filesystem_itable_fibril, fs);
+	if (fid == 0) {
+		/* The tables are zeroed after some later mount */
+		return;
+	}
+
+	fs->itable_running = true;
+	fibril_add_ready(fid);
+}
+
+/** Stop zeroing the i-node tables and wait for the fibril to exit.
+ *
+ * @param fs Filesystem
+ *
+ */
+static void ext4_filesystem_itable_stop(ext4_filesystem_t *fs)
+{
+	fibril_mutex_lock(&fs->itable_lock);
+
+	fs->itable_stop = true;
+	while (fs->itable_running)
+		fibril_condvar_wait(&fs->itable_cv, &fs->itable_lock);
+
+	fibril_mutex_unlock(&fs->itable_lock);
 }
 
 /** Get reference to block group specified by index.
@@ -970,18 +1133,11 @@ errno_t ext4_filesystem_get_block_group_ref(ext4_filesystem_t *fs, uint32_t bgid
 		ext4_block_group_clear_flag(newref->block_group,
 		    EXT4_BLOCK_GROUP_INODE_UNINIT);
 
-		if (!ext4_block_group_has_flag(newref->block_group,
-		    EXT4_BLOCK_GROUP_ITABLE_ZEROED)) {
-			rc = ext4_filesystem_init_inode_table(newref);
-			if (rc != EOK) {
-				block_put(newref->block);
-				free(newref);
-				return rc;
-			}
-
-			ext4_block_group_set_flag(newref->block_group,
-			    EXT4_BLOCK_GROUP_ITABLE_ZEROED);
-		}
+		/*
+		 * The i-node table is zeroed by mkfs or in the background
+		 * after mounting, newly allocated i-nodes are initialized
+		 * in full.
+		 */
 
 		newref->dirty = true;
 	}
@@ -1178,6 +1334,8 @@ errno_t ext4_filesystem_get_inode_ref(ext4_filesystem_t *fs, uint32_t index,
 	newref->index = index + 1;
 	newref->fs = fs;
 	newref->dirty = false;
+	newref->extent_cache_count = 0;
+	newref->prealloc_count = 0;
 
 	*ref = newref;
 
@@ -1193,6 +1351,9 @@ errno_t ext4_filesystem_get_inode_ref(ext4_filesystem_t *fs, uint32_t index,
  */
 errno_t ext4_filesystem_put_inode_ref(ext4_inode_ref_t *ref)
 {
+	/* Return blocks allocated ahead, the reference owns them */
+	errno_t rc2 = ext4_balloc_discard_prealloc(ref);
+
 	/* Check if reference modified */
 	if (ref->dirty) {
 		/* Mark block dirty for writing changes to physical device */
@@ -1203,7 +1364,7 @@ errno_t ext4_filesystem_put_inode_ref(ext4_inode_ref_t *ref)
 	errno_t rc = block_put(ref->block);
 	free(ref);
 
-	return rc;
+	return (rc2 != EOK) ? rc2 : rc;
 }
 
 /** Initialize newly allocated i-node in the filesystem.
@@ -1538,6 +1699,11 @@ errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *inode_ref,
 	if (old_size < new_size)
 		return EINVAL;
 
+	/* Blocks allocated ahead would not follow the file anymore */
+	errno_t rc = ext4_balloc_discard_prealloc(inode_ref);
+	if (rc != EOK)
+		return rc;
+
 	/* Compute how many blocks will be released */
 	aoff64_t size_diff = old_size - new_size;
 	uint32_t block_size  = ext4_superblock_get_block_size(sb);
@@ -1553,7 +1719,7 @@ errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *inode_ref,
 	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
 	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
 		/* Extents require special operation */
-		errno_t rc = ext4_extent_release_blocks_from(inode_ref,
+		rc = ext4_extent_release_blocks_from(inode_ref,
 		    old_blocks_count - diff_blocks_count);
 		if (rc != EOK)
 			return rc;
@@ -1562,7 +1728,7 @@ errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *inode_ref,
 
 		/* Starting from 1 because of logical blocks are numbered from 0 */
 		for (uint32_t i = 1; i <= diff_blocks_count; ++i) {
-			errno_t rc = ext4_filesystem_release_inode_block(inode_ref,
+			rc = ext4_filesystem_release_inode_block(inode_ref,
 			    old_blocks_count - i);
 			if (rc != EOK)
 				return rc;
@@ -1689,6 +1855,61 @@ errno_t ext4_filesystem_get_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 	return EOK;
 }
 
+/** Get run of physical blocks backing consecutive logical blocks of i-node.
+ *
+ * Extent-based i-nodes report the remainder of the extent containing
+ * iblock, direct blocks are scanned for consecutive addresses and blocks
+ * mapped through indirect blocks are always reported one at a time.
+ *
+ * @param inode_ref I-node to read block addresses from
+ * @param iblock    Logical index of the first block
+ * @param fblock    Output pointer for physical address of the first block
+ *                  (0 for sparse block)
+ * @param count     Output pointer for number of blocks in the run
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_filesystem_get_inode_data_block_run(ext4_inode_ref_t *inode_ref,
+    aoff64_t iblock, uint32_t *fblock, uint32_t *count)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+
+	/* Handle i-node using extents */
+	if ((ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS)))
+		return ext4_extent_find_run(inode_ref, iblock, fblock, count);
+
+	errno_t rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
+	    iblock, fblock);
+	if (rc != EOK)
+		return rc;
+
+	*count = 1;
+
+	if (*fblock == 0 || iblock >= EXT4_INODE_DIRECT_BLOCK_COUNT)
+		return EOK;
+
+	/* Extend the run over physically consecutive direct blocks */
+	uint64_t inode_size =
+	    ext4_inode_get_size(fs->superblock, inode_ref->inode);
+	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
+	aoff64_t blocks = ROUND_UP(inode_size, block_size) / block_size;
+
+	for (aoff64_t i = iblock + 1; i < EXT4_INODE_DIRECT_BLOCK_COUNT &&
+	    i < blocks; i++) {
+		uint32_t next = ext4_inode_get_direct_block(inode_ref->inode,
+		    (uint32_t) i);
+		if (next != *fblock + *count)
+			break;
+
+		(*count)++;
+	}
+
+	return EOK;
+}
+
 /** Set physical block address for the block logical address into the i-node.
  *
  * @param inode_ref I-node to set block address to
@@ -1990,7 +2211,7 @@ errno_t ext4_filesystem_append_inode_block(ext4_inode_ref_t *inode_ref,
 
 	/* Allocate new physical block */
 	uint32_t phys_block;
-	errno_t rc = ext4_balloc_alloc_block(inode_ref, &phys_block);
+	errno_t rc = ext4_balloc_alloc_append_block(inode_ref, 0, &phys_block);
 	if (rc != EOK)
 		return rc;
 
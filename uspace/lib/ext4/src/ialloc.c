@@ -36,6 +36,7 @@
  */
 
 #include <errno.h>
+#include <fibril_synch.h>
 #include <stdbool.h>
 #include "ext4/bitmap.h"
 #include "ext4/block_group.h"
@@ -95,7 +96,8 @@ static uint32_t ext4_ialloc_get_bgid_of_inode(ext4_superblock_t *sb,
  * @param is_dir Flag us for information whether i-node is directory or not
  *
  */
-errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_dir)
+static errno_t ext4_ialloc_free_inode_locked(ext4_filesystem_t *fs,
+    uint32_t index, bool is_dir)
 {
 	ext4_superblock_t *sb = fs->superblock;
 
@@ -161,6 +163,21 @@ errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_di
 	return EOK;
 }
 
+/** Free i-node number.
+ *
+ * @param fs     Filesystem, where the i-node is located
+ * @param index  Index of i-node to be release
+ * @param is_dir Flag us for information whether i-node is directory or not
+ *
+ */
+errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_dir)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_ialloc_free_inode_locked(fs, index, is_dir);
+	fibril_mutex_unlock(&fs->alloc_lock);
+	return rc;
+}
+
 /** I-node allocation algorithm.
  *
  * This is more simple algorithm, than Orlov allocator used
@@ -173,7 +190,8 @@ errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_di
  * @return Error code
  *
  */
-errno_t ext4_ialloc_alloc_inode(ext4_filesystem_t *fs, uint32_t *index, bool is_dir)
+static errno_t ext4_ialloc_alloc_inode_locked(ext4_filesystem_t *fs,
+    uint32_t *index, bool is_dir)
 {
 	int pick_first_free = 0;
 	ext4_superblock_t *sb = fs->superblock;
@@ -270,21 +288,18 @@ retry:
 				ext4_block_group_set_used_dirs_count(bg, sb, used_dirs);
 			}
 
-			/* Decrease unused inodes count */
-			if (ext4_block_group_has_flag(bg,
-			    EXT4_BLOCK_GROUP_ITABLE_ZEROED)) {
-				uint32_t unused =
-				    ext4_block_group_get_itable_unused(bg, sb);
-
-				uint32_t inodes_in_group =
-				    ext4_superblock_get_inodes_in_group(sb, bgid);
+			/*
+			 * Decrease unused inodes count. The i-node table is
+			 * zeroed only past the i-nodes that were ever used.
+			 */
+			uint32_t unused =
+			    ext4_block_group_get_itable_unused(bg, sb);
 
-				uint32_t free = inodes_in_group - unused;
+			uint32_t free = inodes_in_group - unused;
 
-				if (index_in_group >= free) {
-					unused = inodes_in_group - (index_in_group + 1);
-					ext4_block_group_set_itable_unused(bg, sb, unused);
-				}
+			if (index_in_group >= free) {
+				unused = inodes_in_group - (index_in_group + 1);
+				ext4_block_group_set_itable_unused(bg, sb, unused);
 			}
 
 			/* Save modified block group */
@@ -321,6 +336,23 @@ retry:
 	return ENOSPC;
 }
 
+/** I-node allocation algorithm.
+ *
+ * @param fs     Filesystem to allocate i-node on
+ * @param index  Output value - allocated i-node number
+ * @param is_dir Flag if allocated i-node will be file or directory
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_ialloc_alloc_inode(ext4_filesystem_t *fs, uint32_t *index, bool is_dir)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_ialloc_alloc_inode_locked(fs, index, is_dir);
+	fibril_mutex_unlock(&fs->alloc_lock);
+	return rc;
+}
+
 /** Allocate a specific I-node.
  *
  * @param fs     Filesystem to allocate i-node on
@@ -330,8 +362,8 @@ retry:
  * @return Error code
  *
  */
-errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *fs, uint32_t inode,
-    bool is_dir)
+static errno_t ext4_ialloc_alloc_this_inode_locked(ext4_filesystem_t *fs,
+    uint32_t inode, bool is_dir)
 {
 	ext4_superblock_t *sb = fs->superblock;
 
@@ -386,20 +418,16 @@ errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *fs, uint32_t inode,
 	}
 
 	/* Decrease unused inodes count */
-	if (ext4_block_group_has_flag(bg,
-	    EXT4_BLOCK_GROUP_ITABLE_ZEROED)) {
-		uint32_t unused =
-		    ext4_block_group_get_itable_unused(bg, sb);
+	uint32_t unused = ext4_block_group_get_itable_unused(bg, sb);
 
-		uint32_t inodes_in_group =
-		    ext4_superblock_get_inodes_in_group(sb, bgid);
+	uint32_t inodes_in_group =
+	    ext4_superblock_get_inodes_in_group(sb, bgid);
 
-		uint32_t free = inodes_in_group - unused;
+	uint32_t free = inodes_in_group - unused;
 
-		if (index_in_group >= free) {
-			unused = inodes_in_group - (index_in_group + 1);
-			ext4_block_group_set_itable_unused(bg, sb, unused);
-		}
+	if (index_in_group >= free) {
+		unused = inodes_in_group - (index_in_group + 1);
+		ext4_block_group_set_itable_unused(bg, sb, unused);
 	}
 
 	/* Save modified block group */
@@ -416,6 +444,24 @@ errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *fs, uint32_t inode,
 	return EOK;
 }
 
+/** Allocate a specific I-node.
+ *
+ * @param fs     Filesystem to allocate i-node on
+ * @param inode  I-node to allocate
+ * @param is_dir Flag if allocated i-node will be file or directory
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *fs, uint32_t inode,
+    bool is_dir)
+{
+	fibril_mutex_lock(&fs->alloc_lock);
+	errno_t rc = ext4_ialloc_alloc_this_inode_locked(fs, inode, is_dir);
+	fibril_mutex_unlock(&fs->alloc_lock);
+	return rc;
+}
+
 /**
  * @}
  */
@@ -55,6 +55,12 @@
 #include "ext4/fstypes.h"
 #include "ext4/superblock.h"
 
+/** Maximum number of data blocks read from the device by one request */
+#define EXT4_READ_BLOCKS_MAX  32
+
+/** Capacity of the delayed allocation buffer of a node in blocks */
+#define EXT4_DELALLOC_BLOCKS  64
+
 /* Forward declarations of auxiliary functions */
 
 static errno_t ext4_read_directory(ipc_call_t *, aoff64_t, size_t,
@@ -63,6 +69,10 @@ static errno_t ext4_read_file(ipc_call_t *, aoff64_t, size_t, ext4_instance_t *,
     ext4_inode_ref_t *, size_t *);
 static bool ext4_is_dots(const uint8_t *, size_t);
 static errno_t ext4_instance_get(service_id_t, ext4_instance_t **);
+static bool ext4_delalloc_start(ext4_node_t *, aoff64_t);
+static errno_t ext4_delalloc_flush(ext4_node_t *);
+static errno_t ext4_delalloc_flush_instance(ext4_instance_t *);
+static void ext4_delalloc_discard(ext4_node_t *);
 
 /* Forward declarations of ext4 libfs operations. */
 
@@ -224,11 +234,14 @@ errno_t ext4_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 	    EXT4_INODE_MODE_DIRECTORY))
 		return ENOTDIR;
 
+	fibril_rwlock_read_lock(&eparent->lock);
+
 	/* Try to find entry */
 	ext4_directory_search_result_t result;
 	errno_t rc = ext4_directory_find_entry(&result, eparent->inode_ref,
 	    component);
 	if (rc != EOK) {
+		fibril_rwlock_read_unlock(&eparent->lock);
 		if (rc == ENOENT) {
 			*rfn = NULL;
 			return EOK;
@@ -246,6 +259,7 @@ errno_t ext4_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 exit:
 	/* Destroy search result structure */
 	rc2 = ext4_directory_destroy_result(&result);
+	fibril_rwlock_read_unlock(&eparent->lock);
 	return rc == EOK ? rc2 : rc;
 }
 
@@ -334,6 +348,10 @@ errno_t ext4_node_get_core(fs_node_t **rfn, ext4_instance_t *inst,
 	enode->instance = inst;
 	enode->references = 1;
 	enode->fs_node = fs_node;
+	fibril_rwlock_initialize(&enode->lock);
+	enode->da_buf = NULL;
+	enode->da_iblock = 0;
+	enode->da_bytes = 0;
 
 	fs_node->data = enode;
 	*rfn = fs_node;
@@ -355,6 +373,9 @@ errno_t ext4_node_get_core(fs_node_t **rfn, ext4_instance_t *inst,
  */
 static errno_t ext4_node_put_core(ext4_node_t *enode)
 {
+	/* Buffered data keep the node referenced */
+	assert(enode->da_buf == NULL);
+
 	hash_table_remove_item(&open_nodes, &enode->link);
 	assert(enode->instance->open_nodes_count > 0);
 	enode->instance->open_nodes_count--;
@@ -414,6 +435,240 @@ errno_t ext4_node_put(fs_node_t *fn)
 	return EOK;
 }
 
+/** Start or continue buffering of data appended to a node.
+ *
+ * Data written to the end of a file are kept in a buffer of the node and
+ * blocks for them are allocated only when the buffer is flushed. The
+ * whole buffer then gets a single run of blocks from the allocator and
+ * the block cache writes the run back to the device in large requests.
+ *
+ * Only appends to a file with block-aligned size are buffered. While the
+ * buffer exists, the node holds an extra reference, so that it stays
+ * open, and blocks for the full buffer are reserved in the instance.
+ * The buffer is protected by the node lock held for writing.
+ *
+ * @param enode Node being written
+ * @param pos   Position of the write
+ *
+ * @return True if the data can be stored to the buffer
+ *
+ */
+static bool ext4_delalloc_start(ext4_node_t *enode, aoff64_t pos)
+{
+	ext4_instance_t *inst = enode->instance;
+	ext4_superblock_t *sb = inst->filesystem->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+	size_t capacity = EXT4_DELALLOC_BLOCKS * block_size;
+
+	if (enode->da_buf != NULL) {
+		return (enode->da_bytes < capacity) &&
+		    (pos == (aoff64_t) enode->da_iblock * block_size +
+		    enode->da_bytes);
+	}
+
+	if (!ext4_inode_is_type(sb, enode->inode_ref->inode,
+	    EXT4_INODE_MODE_FILE))
+		return false;
+
+	uint64_t size = ext4_inode_get_size(sb, enode->inode_ref->inode);
+	if ((pos != size) || ((size % block_size) != 0))
+		return false;
+
+	if (size / block_size + EXT4_DELALLOC_BLOCKS > UINT32_MAX)
+		return false;
+
+	uint8_t *buf = malloc(capacity);
+	if (buf == NULL)
+		return false;
+
+	fibril_mutex_lock(&open_nodes_lock);
+
+	/* Leave room for the buffered data and the block mapping metadata */
+	if (ext4_superblock_get_free_blocks_count(sb) <
+	    inst->delalloc_reserved + 2 * EXT4_DELALLOC_BLOCKS) {
+		fibril_mutex_unlock(&open_nodes_lock);
+		free(buf);
+		return false;
+	}
+
+	inst->delalloc_reserved += EXT4_DELALLOC_BLOCKS;
+	enode->references++;
+	fibril_mutex_unlock(&open_nodes_lock);
+
+	enode->da_buf = buf;
+	enode->da_iblock = size / block_size;
+	enode->da_bytes = 0;
+	return true;
+}
+
+/** Drop the delayed allocation buffer of a node.
+ *
+ * The extra node reference and the reserved blocks are released.
+ *
+ * @param enode Node with buffered data
+ *
+ */
+static void ext4_delalloc_discard(ext4_node_t *enode)
+{
+	if (enode->da_buf == NULL)
+		return;
+
+	free(enode->da_buf);
+	enode->da_buf = NULL;
+	enode->da_bytes = 0;
+
+	fibril_mutex_lock(&open_nodes_lock);
+	assert(enode->instance->delalloc_reserved >= EXT4_DELALLOC_BLOCKS);
+	enode->instance->delalloc_reserved -= EXT4_DELALLOC_BLOCKS;
+	/* The caller holds its own reference */
+	assert(enode->references > 1);
+	enode->references--;
+	fibril_mutex_unlock(&open_nodes_lock);
+}
+
+/** Allocate blocks for the buffered data of a node and write them.
+ *
+ * The buffer is dropped even if the operation fails.
+ *
+ * @param enode Node with buffered data
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_delalloc_flush(ext4_node_t *enode)
+{
+	if (enode->da_buf == NULL)
+		return EOK;
+
+	ext4_inode_ref_t *inode_ref = enode->inode_ref;
+	ext4_superblock_t *sb = enode->instance->filesystem->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+	uint32_t count = (enode->da_bytes + block_size - 1) / block_size;
+	aoff64_t start = (aoff64_t) enode->da_iblock * block_size;
+	size_t done = 0;
+
+	/* Get blocks for the whole buffer from one run if possible */
+	errno_t rc = ext4_balloc_prealloc(inode_ref, count);
+
+	for (uint32_t i = 0; (rc == EOK) && (i < count); i++) {
+		uint32_t fblock;
+		uint32_t iblock;
+		rc = ext4_filesystem_append_inode_block(inode_ref, &fblock,
+		    &iblock);
+		if (rc != EOK)
+			break;
+
+		assert(iblock == enode->da_iblock + i);
+
+		block_t *block;
+		rc = block_get(&block, enode->instance->service_id, fblock,
+		    BLOCK_FLAGS_NOREAD);
+		if (rc != EOK)
+			break;
+
+		size_t bytes = min(block_size, enode->da_bytes - done);
+		memcpy(block->data, enode->da_buf + done, bytes);
+		memset((uint8_t *) block->data + bytes, 0, block_size - bytes);
+		block->dirty = true;
+
+		rc = block_put(block);
+		if (rc != EOK)
+			break;
+
+		done += bytes;
+	}
+
+	/* Appending blocks rounds the size up to whole blocks */
+	if (count > 0) {
+		ext4_inode_set_size(inode_ref->inode, start + done);
+		inode_ref->dirty = true;
+	}
+
+	ext4_delalloc_discard(enode);
+	return rc;
+}
+
+typedef struct {
+	ext4_instance_t *instance;
+	ext4_node_t *enode;
+} ext4_delalloc_search_t;
+
+static bool ext4_delalloc_search_cb(ht_link_t *item, void *arg)
+{
+	ext4_delalloc_search_t *search = arg;
+	ext4_node_t *enode = hash_table_get_inst(item, ext4_node_t, link);
+
+	if ((enode->instance == search->instance) && (enode->da_buf != NULL)) {
+		search->enode = enode;
+		return false;
+	}
+
+	return true;
+}
+
+/** Flush buffered data of all nodes of an instance.
+ *
+ * @param inst Filesystem instance
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_delalloc_flush_instance(ext4_instance_t *inst)
+{
+	while (true) {
+		ext4_delalloc_search_t search = {
+			.instance = inst,
+			.enode = NULL
+		};
+
+		fibril_mutex_lock(&open_nodes_lock);
+		hash_table_apply(&open_nodes, ext4_delalloc_search_cb,
+		    &search);
+		if (search.enode == NULL) {
+			fibril_mutex_unlock(&open_nodes_lock);
+			return EOK;
+		}
+
+		search.enode->references++;
+		fibril_mutex_unlock(&open_nodes_lock);
+
+		fibril_rwlock_write_lock(&search.enode->lock);
+		errno_t rc = ext4_delalloc_flush(search.enode);
+		fibril_rwlock_write_unlock(&search.enode->lock);
+		errno_t rc2 = ext4_node_put(search.enode->fs_node);
+		if (rc != EOK)
+			return rc;
+		if (rc2 != EOK)
+			return rc2;
+	}
+}
+
+/** Lock a node for reading its data.
+ *
+ * Data buffered for the node are flushed first, so that they can be
+ * read from disk.
+ *
+ * @param enode Node to lock
+ *
+ * @return Error code, the node is not locked on failure
+ *
+ */
+static errno_t ext4_node_read_lock(ext4_node_t *enode)
+{
+	while (true) {
+		fibril_rwlock_read_lock(&enode->lock);
+		if (enode->da_buf == NULL)
+			return EOK;
+		fibril_rwlock_read_unlock(&enode->lock);
+
+		fibril_rwlock_write_lock(&enode->lock);
+		errno_t rc = ext4_delalloc_flush(enode);
+		fibril_rwlock_write_unlock(&enode->lock);
+		if (rc != EOK)
+			return rc;
+	}
+}
+
 /** Create new node in filesystem.
  *
  * @param rfn        Output pointer to newly created node if successful
@@ -461,11 +716,15 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 	enode->inode_ref = inode_ref;
 	enode->instance = inst;
 	enode->references = 1;
+	fibril_rwlock_initialize(&enode->lock);
+	enode->da_buf = NULL;
+	enode->da_iblock = 0;
+	enode->da_bytes = 0;
 
 	fibril_mutex_lock(&open_nodes_lock);
 	hash_table_insert(&open_nodes, &enode->link);
-	fibril_mutex_unlock(&open_nodes_lock);
 	inst->open_nodes_count++;
+	fibril_mutex_unlock(&open_nodes_lock);
 
 	enode->inode_ref->dirty = true;
 
@@ -477,37 +736,34 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 	return EOK;
 }
 
-/** Destroy existing node.
+/** Release data and i-node of a node.
  *
- * @param fs Node to destroy
+ * @param fn Node to destroy, locked for writing
  *
  * @return Error code
  *
  */
-errno_t ext4_destroy_node(fs_node_t *fn)
+static errno_t ext4_destroy_node_core(fs_node_t *fn)
 {
 	/* If directory, check for children */
 	bool has_children;
 	errno_t rc = ext4_has_children(&has_children, fn);
-	if (rc != EOK) {
-		ext4_node_put(fn);
+	if (rc != EOK)
 		return rc;
-	}
 
-	if (has_children) {
-		ext4_node_put(fn);
+	if (has_children)
 		return EINVAL;
-	}
 
 	ext4_node_t *enode = EXT4_NODE(fn);
 	ext4_inode_ref_t *inode_ref = enode->inode_ref;
 
+	/* Data not written yet are not needed anymore */
+	ext4_delalloc_discard(enode);
+
 	/* Release data blocks */
 	rc = ext4_filesystem_truncate_inode(inode_ref, 0);
-	if (rc != EOK) {
-		ext4_node_put(fn);
+	if (rc != EOK)
 		return rc;
-	}
 
 	/*
 	 * TODO: Sset real deletion time when it will be supported.
@@ -517,32 +773,68 @@ errno_t ext4_destroy_node(fs_node_t *fn)
 	inode_ref->dirty = true;
 
 	/* Free inode */
-	rc = ext4_filesystem_free_inode(inode_ref);
-	if (rc != EOK) {
-		ext4_node_put(fn);
-		return rc;
-	}
-
-	return ext4_node_put(fn);
+	return ext4_filesystem_free_inode(inode_ref);
 }
 
-/** Link the specfied node to directory.
+/** Destroy existing node.
  *
- * @param pfn  Parent node to link in
- * @param cfn  Node to be linked
- * @param name Name which will be assigned to directory entry
+ * @param fs Node to destroy
  *
  * @return Error code
  *
  */
-errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+errno_t ext4_destroy_node(fs_node_t *fn)
 {
-	/* Check maximum name length */
-	if (str_size(name) > EXT4_DIRECTORY_FILENAME_LEN)
-		return ENAMETOOLONG;
+	ext4_node_t *enode = EXT4_NODE(fn);
 
-	ext4_node_t *parent = EXT4_NODE(pfn);
-	ext4_node_t *child = EXT4_NODE(cfn);
+	fibril_rwlock_write_lock(&enode->lock);
+	errno_t rc = ext4_destroy_node_core(fn);
+	fibril_rwlock_write_unlock(&enode->lock);
+
+	errno_t const rc2 = ext4_node_put(fn);
+	return rc == EOK ? rc2 : rc;
+}
+
+/** Lock a directory and its child for writing.
+ *
+ * Parents are always locked before their children.
+ *
+ * @param parent Directory node
+ * @param child  Node linked in the directory
+ *
+ */
+static void ext4_node_pair_lock(ext4_node_t *parent, ext4_node_t *child)
+{
+	fibril_rwlock_write_lock(&parent->lock);
+	if (child != parent)
+		fibril_rwlock_write_lock(&child->lock);
+}
+
+/** Unlock nodes locked by ext4_node_pair_lock().
+ *
+ * @param parent Directory node
+ * @param child  Node linked in the directory
+ *
+ */
+static void ext4_node_pair_unlock(ext4_node_t *parent, ext4_node_t *child)
+{
+	if (child != parent)
+		fibril_rwlock_write_unlock(&child->lock);
+	fibril_rwlock_write_unlock(&parent->lock);
+}
+
+/** Add directory entries of a link with both nodes locked.
+ *
+ * @param parent Parent node to link in
+ * @param child  Node to be linked
+ * @param name   Name which will be assigned to directory entry
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_link_core(ext4_node_t *parent, ext4_node_t *child,
+    const char *name)
+{
 	ext4_filesystem_t *fs = parent->instance->filesystem;
 
 	/* Add entry to parent directory */
@@ -599,7 +891,32 @@ errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 	return EOK;
 }
 
-/** Unlink node from specified directory.
+/** Link the specfied node to directory.
+ *
+ * @param pfn  Parent node to link in
+ * @param cfn  Node to be linked
+ * @param name Name which will be assigned to directory entry
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	/* Check maximum name length */
+	if (str_size(name) > EXT4_DIRECTORY_FILENAME_LEN)
+		return ENAMETOOLONG;
+
+	ext4_node_t *parent = EXT4_NODE(pfn);
+	ext4_node_t *child = EXT4_NODE(cfn);
+
+	ext4_node_pair_lock(parent, child);
+	errno_t rc = ext4_link_core(parent, child, name);
+	ext4_node_pair_unlock(parent, child);
+
+	return rc;
+}
+
+/** Remove directory entry of a link with both nodes locked.
  *
  * @param pfn  Parent node to delete node from
  * @param cfn  Child node to be unlinked from directory
@@ -608,7 +925,8 @@ errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
  * @return Error code
  *
  */
-errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+static errno_t ext4_unlink_core(fs_node_t *pfn, fs_node_t *cfn,
+    const char *name)
 {
 	bool has_children;
 	errno_t rc = ext4_has_children(&has_children, cfn);
@@ -671,9 +989,32 @@ errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 	return EOK;
 }
 
+/** Unlink node from specified directory.
+ *
+ * @param pfn  Parent node to delete node from
+ * @param cfn  Child node to be unlinked from directory
+ * @param name Name of entry that will be removed
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	ext4_node_t *parent = EXT4_NODE(pfn);
+	ext4_node_t *child = EXT4_NODE(cfn);
+
+	ext4_node_pair_lock(parent, child);
+	errno_t rc = ext4_unlink_core(pfn, cfn, name);
+	ext4_node_pair_unlock(parent, child);
+
+	return rc;
+}
+
 /** Check if specified node has children.
  *
  * For files is response allways false and check is executed only for directories.
+ * The caller either holds the node lock or runs with the namespace locked
+ * by VFS, so that the directory cannot change meanwhile.
  *
  * @param has_children Output value for response
  * @param fn           Node to check
@@ -751,7 +1092,20 @@ aoff64_t ext4_size_get(fs_node_t *fn)
 {
 	ext4_node_t *enode = EXT4_NODE(fn);
 	ext4_superblock_t *sb = enode->instance->filesystem->superblock;
-	return ext4_inode_get_size(sb, enode->inode_ref->inode);
+	aoff64_t size;
+
+	fibril_rwlock_read_lock(&enode->lock);
+
+	/* Buffered data extend the file beyond the size on disk */
+	if (enode->da_buf != NULL) {
+		size = (aoff64_t) enode->da_iblock *
+		    ext4_superblock_get_block_size(sb) + enode->da_bytes;
+	} else {
+		size = ext4_inode_get_size(sb, enode->inode_ref->inode);
+	}
+
+	fibril_rwlock_read_unlock(&enode->lock);
+	return size;
 }
 
 /** Get number of links to specified node.
@@ -951,6 +1305,7 @@ static errno_t ext4_mounted(service_id_t service_id, const char *opts,
 	link_initialize(&inst->link);
 	inst->service_id = service_id;
 	inst->open_nodes_count = 0;
+	inst->delalloc_reserved = 0;
 
 	/* Initialize the filesystem */
 	aoff64_t rnsize;
@@ -987,6 +1342,11 @@ static errno_t ext4_unmounted(service_id_t service_id)
 	if (rc != EOK)
 		return rc;
 
+	/* Nodes with buffered data are open only because of the buffer */
+	rc = ext4_delalloc_flush_instance(inst);
+	if (rc != EOK)
+		return rc;
+
 	fibril_mutex_lock(&open_nodes_lock);
 
 	if (inst->open_nodes_count != 0) {
@@ -1030,26 +1390,37 @@ static errno_t ext4_read(service_id_t service_id, fs_index_t index, aoff64_t pos
 	 */
 	ipc_call_t call;
 	size_t size;
-	if (!async_data_read_receive(&call, &size)) {
-		async_answer_0(&call, EINVAL);
+	if (!libfs_data_read_receive(&call, &size)) {
+		libfs_data_read_refuse(&call, EINVAL);
 		return EINVAL;
 	}
 
 	ext4_instance_t *inst;
 	errno_t rc = ext4_instance_get(service_id, &inst);
 	if (rc != EOK) {
-		async_answer_0(&call, rc);
+		libfs_data_read_refuse(&call, rc);
 		return rc;
 	}
 
 	/* Load i-node */
-	ext4_inode_ref_t *inode_ref;
-	rc = ext4_filesystem_get_inode_ref(inst->filesystem, index, &inode_ref);
+	fs_node_t *fn;
+	rc = ext4_node_get_core(&fn, inst, index);
 	if (rc != EOK) {
-		async_answer_0(&call, rc);
+		libfs_data_read_refuse(&call, rc);
+		return rc;
+	}
+
+	/* Buffered data must be on disk to be read */
+	ext4_node_t *enode = EXT4_NODE(fn);
+	rc = ext4_node_read_lock(enode);
+	if (rc != EOK) {
+		libfs_data_read_refuse(&call, rc);
+		ext4_node_put(fn);
 		return rc;
 	}
 
+	ext4_inode_ref_t *inode_ref = enode->inode_ref;
+
 	/* Read from i-node by type */
 	if (ext4_inode_is_type(inst->filesystem->superblock, inode_ref->inode,
 	    EXT4_INODE_MODE_FILE)) {
@@ -1061,15 +1432,112 @@ static errno_t ext4_read(service_id_t service_id, fs_index_t index, aoff64_t pos
 		    rbytes);
 	} else {
 		/* Other inode types not supported */
-		async_answer_0(&call, ENOTSUP);
+		libfs_data_read_refuse(&call, ENOTSUP);
 		rc = ENOTSUP;
 	}
 
-	errno_t const rc2 = ext4_filesystem_put_inode_ref(inode_ref);
+	fibril_rwlock_read_unlock(&enode->lock);
+	errno_t const rc2 = ext4_node_put(fn);
 
 	return rc == EOK ? rc2 : rc;
 }
 
+/** Read as many directory entries as fit into a buffer.
+ *
+ * @param service_id Device to read data from
+ * @param index      Number of the directory i-node
+ * @param pos        Position of the first entry
+ * @param buf        Buffer for entries packed by libfs_dirent_pack()
+ * @param size       Size of the buffer
+ * @param used       Output value - number of bytes of the buffer filled
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_readdir(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, void *buf, size_t size, size_t *used)
+{
+	ext4_instance_t *inst;
+	errno_t rc = ext4_instance_get(service_id, &inst);
+	if (rc != EOK)
+		return rc;
+
+	fs_node_t *fn;
+	rc = ext4_node_get_core(&fn, inst, index);
+	if (rc != EOK)
+		return rc;
+
+	ext4_node_t *enode = EXT4_NODE(fn);
+	ext4_superblock_t *sb = inst->filesystem->superblock;
+	if (!ext4_inode_is_type(sb, enode->inode_ref->inode,
+	    EXT4_INODE_MODE_DIRECTORY)) {
+		ext4_node_put(fn);
+		return ENOTDIR;
+	}
+
+	fibril_rwlock_read_lock(&enode->lock);
+
+	ext4_directory_iterator_t it;
+	rc = ext4_directory_iterator_init(&it, enode->inode_ref, pos);
+	if (rc != EOK) {
+		fibril_rwlock_read_unlock(&enode->lock);
+		ext4_node_put(fn);
+		return rc;
+	}
+
+	*used = 0;
+	while (it.current != NULL) {
+		ext4_directory_entry_ll_t *entry = it.current;
+		uint32_t inode = ext4_directory_entry_ll_get_inode(entry);
+		uint16_t name_size = ext4_directory_entry_ll_get_name_length(sb,
+		    entry);
+
+		/* Skip unused entries as well as . and .. */
+		if ((inode != 0) && !ext4_is_dots(entry->name, name_size)) {
+			vfs_dirent_type_t type;
+			switch (ext4_directory_entry_ll_get_inode_type(sb,
+			    entry)) {
+			case EXT4_DIRECTORY_FILETYPE_REG_FILE:
+				type = VFS_DIRENT_FILE;
+				break;
+			case EXT4_DIRECTORY_FILETYPE_DIR:
+				type = VFS_DIRENT_DIRECTORY;
+				break;
+			default:
+				type = VFS_DIRENT_UNKNOWN;
+				break;
+			}
+
+			aoff64_t next = it.current_offset +
+			    ext4_directory_entry_ll_get_entry_length(entry);
+			if (!libfs_dirent_pack(buf, size, used, next, inode,
+			    type, (char *) entry->name, name_size))
+				break;
+		}
+
+		rc = ext4_directory_iterator_next(&it);
+		if (rc != EOK)
+			break;
+	}
+
+	/* Not even one entry fits */
+	if ((rc == EOK) && (*used == 0) && (it.current != NULL))
+		rc = EOVERFLOW;
+
+	/* An error after some entries is reported by the next call */
+	if (*used > 0)
+		rc = EOK;
+
+	errno_t rc2 = ext4_directory_iterator_fini(&it);
+	fibril_rwlock_read_unlock(&enode->lock);
+	errno_t rc3 = ext4_node_put(fn);
+
+	if (rc != EOK)
+		return rc;
+
+	return (rc2 != EOK) ? rc2 : rc3;
+}
+
 /** Check if filename is dot or dotdot (reserved names).
  *
  * @param name      Name to check
@@ -1107,7 +1575,7 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 	ext4_directory_iterator_t it;
 	errno_t rc = ext4_directory_iterator_init(&it, inode_ref, pos);
 	if (rc != EOK) {
-		async_answer_0(call, rc);
+		libfs_data_read_refuse(call, rc);
 		return rc;
 	}
 
@@ -1136,7 +1604,7 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 		uint8_t *buf = malloc(name_size + 1);
 		if (buf == NULL) {
 			ext4_directory_iterator_fini(&it);
-			async_answer_0(call, ENOMEM);
+			libfs_data_read_refuse(call, ENOMEM);
 			return ENOMEM;
 		}
 
@@ -1144,7 +1612,7 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 		*(buf + name_size) = 0;
 		found = true;
 
-		(void) async_data_read_finalize(call, buf, name_size + 1);
+		(void) libfs_data_read_finalize(call, buf, name_size + 1);
 		free(buf);
 		break;
 
@@ -1152,7 +1620,7 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 		rc = ext4_directory_iterator_next(&it);
 		if (rc != EOK) {
 			ext4_directory_iterator_fini(&it);
-			async_answer_0(call, rc);
+			libfs_data_read_refuse(call, rc);
 			return rc;
 		}
 	}
@@ -1175,7 +1643,7 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
 		*rbytes = next - pos;
 		return EOK;
 	} else {
-		async_answer_0(call, ENOENT);
+		libfs_data_read_refuse(call, ENOENT);
 		return ENOENT;
 	}
 }
@@ -1200,69 +1668,104 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 
 	if (pos >= file_size) {
 		/* Read 0 bytes successfully */
-		async_data_read_finalize(call, NULL, 0);
+		libfs_data_read_finalize(call, NULL, 0);
 		*rbytes = 0;
 		return EOK;
 	}
 
-	/* For now, we only read data from one block at a time */
+	/*
+	 * Read at most one run of physically contiguous blocks, so that
+	 * the device is asked just once
+	 */
 	uint32_t block_size = ext4_superblock_get_block_size(sb);
 	aoff64_t file_block = pos / block_size;
 	uint32_t offset_in_block = pos % block_size;
-	uint32_t bytes = min(block_size - offset_in_block, size);
 
-	/* Handle end of file */
-	if (pos + bytes > file_size)
-		bytes = file_size - pos;
-
-	/* Get the real block number */
+	/* Get the real block number and length of the run */
 	uint32_t fs_block;
-	errno_t rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
-	    file_block, &fs_block);
+	uint32_t run;
+	errno_t rc = ext4_filesystem_get_inode_data_block_run(inode_ref,
+	    file_block, &fs_block, &run);
 	if (rc != EOK) {
-		async_answer_0(call, rc);
+		libfs_data_read_refuse(call, rc);
 		return rc;
 	}
 
+	run = min(run, EXT4_READ_BLOCKS_MAX);
+	size_t bytes = min((size_t) run * block_size - offset_in_block, size);
+
+	/* Handle end of file */
+	if (pos + bytes > file_size)
+		bytes = file_size - pos;
+
 	/*
 	 * Check for sparse file.
-	 * If ext4_filesystem_get_inode_data_block_index returned
-	 * fs_block == 0, it means that the given block is not allocated for the
-	 * file and we need to return a buffer of zeros
+	 * If ext4_filesystem_get_inode_data_block_run returned
+	 * fs_block == 0, it means that the given blocks are not allocated for
+	 * the file and we need to return a buffer of zeros
 	 */
 	uint8_t *buffer;
 	if (fs_block == 0) {
 		buffer = malloc(bytes);
 		if (buffer == NULL) {
-			async_answer_0(call, ENOMEM);
+			libfs_data_read_refuse(call, ENOMEM);
 			return ENOMEM;
 		}
 
 		memset(buffer, 0, bytes);
 
-		rc = async_data_read_finalize(call, buffer, bytes);
+		rc = libfs_data_read_finalize(call, buffer, bytes);
 		*rbytes = bytes;
 
 		free(buffer);
 		return rc;
 	}
 
-	/* Usual case - we need to read a block from device */
-	block_t *block;
-	rc = block_get(&block, inst->service_id, fs_block, BLOCK_FLAGS_NONE);
+	/* Usual case - we need to read blocks from device */
+	size_t count = (offset_in_block + bytes + block_size - 1) / block_size;
+	block_t *blocks[EXT4_READ_BLOCKS_MAX];
+	assert(count <= EXT4_READ_BLOCKS_MAX);
+
+	rc = block_get_range(blocks, inst->service_id, fs_block, count,
+	    BLOCK_FLAGS_NONE);
 	if (rc != EOK) {
-		async_answer_0(call, rc);
+		libfs_data_read_refuse(call, rc);
 		return rc;
 	}
 
-	assert(offset_in_block + bytes <= block_size);
-	rc = async_data_read_finalize(call, block->data + offset_in_block, bytes);
-	if (rc != EOK) {
-		block_put(block);
-		return rc;
+	if (count == 1) {
+		/* Data can be sent directly from the block cache */
+		assert(offset_in_block + bytes <= block_size);
+		rc = libfs_data_read_finalize(call,
+		    blocks[0]->data + offset_in_block, bytes);
+	} else {
+		buffer = malloc(bytes);
+		if (buffer == NULL) {
+			libfs_data_read_refuse(call, ENOMEM);
+			rc = ENOMEM;
+		} else {
+			size_t copied = 0;
+			for (size_t i = 0; i < count; i++) {
+				size_t off = (i == 0) ? offset_in_block : 0;
+				size_t len = min(block_size - off,
+				    bytes - copied);
+
+				memcpy(buffer + copied,
+				    (uint8_t *) blocks[i]->data + off, len);
+				copied += len;
+			}
+
+			rc = libfs_data_read_finalize(call, buffer, bytes);
+			free(buffer);
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		errno_t rc2 = block_put(blocks[i]);
+		if (rc == EOK)
+			rc = rc2;
 	}
 
-	rc = block_put(block);
 	if (rc != EOK)
 		return rc;
 
@@ -1290,6 +1793,9 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 	if (rc != EOK)
 		return rc;
 
+	ext4_node_t *enode = EXT4_NODE(fn);
+	fibril_rwlock_write_lock(&enode->lock);
+
 	ipc_call_t call;
 	size_t len;
 	if (!async_data_write_receive(&call, &len)) {
@@ -1298,11 +1804,41 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 		goto exit;
 	}
 
-	ext4_node_t *enode = EXT4_NODE(fn);
 	ext4_filesystem_t *fs = enode->instance->filesystem;
 
 	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
 
+	/* Appended data are only buffered, blocks are allocated later */
+	if (ext4_delalloc_start(enode, pos)) {
+		size_t capacity = EXT4_DELALLOC_BLOCKS * block_size;
+		size_t buffered = min(len, capacity - enode->da_bytes);
+
+		rc = async_data_write_finalize(&call,
+		    enode->da_buf + enode->da_bytes, buffered);
+		if (rc != EOK) {
+			if (enode->da_bytes == 0)
+				ext4_delalloc_discard(enode);
+			goto exit;
+		}
+
+		enode->da_bytes += buffered;
+		*wbytes = buffered;
+		*nsize = (aoff64_t) enode->da_iblock * block_size +
+		    enode->da_bytes;
+
+		if (enode->da_bytes == capacity)
+			rc = ext4_delalloc_flush(enode);
+
+		goto exit;
+	}
+
+	/* Other writes must not overtake the buffered data */
+	rc = ext4_delalloc_flush(enode);
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
+		goto exit;
+	}
+
 	/* Prevent writing to more than one block */
 	uint32_t bytes = min(len, block_size - (pos % block_size));
 
@@ -1402,6 +1938,7 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 	*wbytes = bytes;
 
 exit:
+	fibril_rwlock_write_unlock(&enode->lock);
 	rc2 = ext4_node_put(fn);
 	return rc == EOK ? rc2 : rc;
 }
@@ -1428,7 +1965,12 @@ static errno_t ext4_truncate(service_id_t service_id, fs_index_t index,
 	ext4_node_t *enode = EXT4_NODE(fn);
 	ext4_inode_ref_t *inode_ref = enode->inode_ref;
 
-	rc = ext4_filesystem_truncate_inode(inode_ref, new_size);
+	fibril_rwlock_write_lock(&enode->lock);
+	rc = ext4_delalloc_flush(enode);
+	if (rc == EOK)
+		rc = ext4_filesystem_truncate_inode(inode_ref, new_size);
+	fibril_rwlock_write_unlock(&enode->lock);
+
 	errno_t const rc2 = ext4_node_put(fn);
 
 	return rc == EOK ? rc2 : rc;
@@ -1444,7 +1986,19 @@ static errno_t ext4_truncate(service_id_t service_id, fs_index_t index,
  */
 static errno_t ext4_close(service_id_t service_id, fs_index_t index)
 {
-	return EOK;
+	fs_node_t *fn;
+	errno_t rc = ext4_node_get(&fn, service_id, index);
+	if (rc != EOK)
+		return rc;
+
+	/* Write out data buffered for the file */
+	ext4_node_t *enode = EXT4_NODE(fn);
+	fibril_rwlock_write_lock(&enode->lock);
+	rc = ext4_delalloc_flush(enode);
+	fibril_rwlock_write_unlock(&enode->lock);
+	errno_t const rc2 = ext4_node_put(fn);
+
+	return rc == EOK ? rc2 : rc;
 }
 
 /** Destroy node specified by index.
@@ -1480,9 +2034,13 @@ static errno_t ext4_sync(service_id_t service_id, fs_index_t index)
 		return rc;
 
 	ext4_node_t *enode = EXT4_NODE(fn);
+	fibril_rwlock_write_lock(&enode->lock);
+	rc = ext4_delalloc_flush(enode);
 	enode->inode_ref->dirty = true;
+	fibril_rwlock_write_unlock(&enode->lock);
 
-	return ext4_node_put(fn);
+	errno_t const rc2 = ext4_node_put(fn);
+	return rc == EOK ? rc2 : rc;
 }
 
 /** VFS operations
@@ -1497,7 +2055,8 @@ vfs_out_ops_t ext4_ops = {
 	.truncate = ext4_truncate,
 	.close = ext4_close,
 	.destroy = ext4_destroy,
-	.sync = ext4_sync
+	.sync = ext4_sync,
+	.readdir = ext4_readdir
 };
 
 /**
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libfs
+ * @{
+ */
+/**
+ * @file
+ * In-memory bitmaps of used blocks or clusters.
+ *
+ * File system servers keep a copy of their free space map in memory so
+ * that allocation does not need to scan the on-disk structures. Searches
+ * for free bits go on from where the last allocation ended and look for
+ * runs long enough to keep files contiguous.
+ */
+
+#include <assert.h>
+#include <mem.h>
+#include <stdlib.h>
+#include "fs_bitmap.h"
+
+#define BYTE_BITS	8
+
+/** Create a bitmap with all bits set.
+ *
+ * @param bm	Bitmap to initialize
+ * @param size	Number of bits
+ *
+ * @return	EOK on success or ENOMEM
+ */
+errno_t fs_bitmap_create(fs_bitmap_t *bm, size_t size)
+{
+	size_t bytes = (size + BYTE_BITS - 1) / BYTE_BITS;
+
+	bm->map = malloc(bytes > 0 ? bytes : 1);
+	if (bm->map == NULL)
+		return ENOMEM;
+
+	memset(bm->map, 0xff, bytes);
+	bm->size = size;
+	bm->free = 0;
+	bm->hint = 0;
+	return EOK;
+}
+
+/** Free the memory of a bitmap. */
+void fs_bitmap_destroy(fs_bitmap_t *bm)
+{
+	free(bm->map);
+	bm->map = NULL;
+	bm->size = 0;
+	bm->free = 0;
+}
+
+/** Count clear bits in a byte of the bitmap. */
+static size_t clear_bits(fs_bitmap_t *bm, size_t byte)
+{
+	size_t bits = bm->size - byte * BYTE_BITS;
+	if (bits > BYTE_BITS)
+		bits = BYTE_BITS;
+
+	size_t count = 0;
+	for (size_t i = 0; i < bits; i++) {
+		if ((bm->map[byte] & (1 << i)) == 0)
+			count++;
+	}
+
+	return count;
+}
+
+/** Copy bits from an on-disk bitmap.
+ *
+ * @param bm	Bitmap
+ * @param byte	Byte of the bitmap where the data go
+ * @param data	Bits in the same format as the bitmap uses
+ * @param size	Number of bytes to copy
+ */
+void fs_bitmap_import(fs_bitmap_t *bm, size_t byte, const void *data,
+    size_t size)
+{
+	size_t bytes = (bm->size + BYTE_BITS - 1) / BYTE_BITS;
+
+	assert(byte <= bytes && size <= bytes - byte);
+
+	for (size_t i = byte; i < byte + size; i++)
+		bm->free -= clear_bits(bm, i);
+
+	memcpy(bm->map + byte, data, size);
+
+	for (size_t i = byte; i < byte + size; i++)
+		bm->free += clear_bits(bm, i);
+}
+
+/** Test a bit of a bitmap. */
+bool fs_bitmap_is_set(fs_bitmap_t *bm, size_t bit)
+{
+	assert(bit < bm->size);
+	return (bm->map[bit / BYTE_BITS] & (1 << (bit % BYTE_BITS))) != 0;
+}
+
+/** Mark a range of bits as used.
+ *
+ * The next search for free bits starts past the range.
+ *
+ * @param bm	Bitmap
+ * @param start	First bit of the range
+ * @param count	Number of bits in the range
+ */
+void fs_bitmap_set_range(fs_bitmap_t *bm, size_t start, size_t count)
+{
+	assert(start <= bm->size && count <= bm->size - start);
+
+	for (size_t bit = start; bit < start + count; bit++) {
+		uint8_t mask = 1 << (bit % BYTE_BITS);
+
+		if ((bm->map[bit / BYTE_BITS] & mask) == 0) {
+			bm->map[bit / BYTE_BITS] |= mask;
+			bm->free--;
+		}
+	}
+
+	bm->hint = start + count;
+}
+
+/** Mark a range of bits as free.
+ *
+ * @param bm	Bitmap
+ * @param start	First bit of the range
+ * @param count	Number of bits in the range
+ */
+void fs_bitmap_clear_range(fs_bitmap_t *bm, size_t start, size_t count)
+{
+	assert(start <= bm->size && count <= bm->size - start);
+
+	for (size_t bit = start; bit < start + count; bit++) {
+		uint8_t mask = 1 << (bit % BYTE_BITS);
+
+		if ((bm->map[bit / BYTE_BITS] & mask) != 0) {
+			bm->map[bit / BYTE_BITS] &= ~mask;
+			bm->free++;
+		}
+	}
+}
+
+/** Whether a whole byte of the bitmap has the given value from a bit on. */
+static bool byte_is(fs_bitmap_t *bm, size_t bit, uint8_t value)
+{
+	return bit % BYTE_BITS == 0 && bm->size - bit >= BYTE_BITS &&
+	    bm->map[bit / BYTE_BITS] == value;
+}
+
+/** Find a run of free bits.
+ *
+ * The search starts at the bitmap's hint and wraps around at its end. The
+ * first run of at least @a count free bits is returned. If there is no such
+ * run, the longest run of free bits is returned instead.
+ *
+ * @param bm		Bitmap
+ * @param count		Desired number of free bits
+ * @param[out] start	First bit of the run found
+ * @param[out] len	Length of the run found, at most @a count
+ *
+ * @return		True if any free bits were found
+ */
+bool fs_bitmap_find_free(fs_bitmap_t *bm, size_t count, size_t *start,
+    size_t *len)
+{
+	size_t best_start = 0;
+	size_t best_len = 0;
+
+	if (bm->free == 0 || count == 0)
+		return false;
+
+	size_t bit = (bm->hint < bm->size) ? bm->hint : 0;
+	size_t scanned = 0;
+
+	while (scanned < bm->size) {
+		if (fs_bitmap_is_set(bm, bit)) {
+			/* Skip used bits, whole bytes at a time if possible. */
+			size_t skip = (byte_is(bm, bit, 0xff) &&
+			    bm->size - scanned >= BYTE_BITS) ? BYTE_BITS : 1;
+			bit += skip;
+			scanned += skip;
+			if (bit == bm->size)
+				bit = 0;
+			continue;
+		}
+
+		/* Measure the run of free bits. */
+		size_t run_start = bit;
+		size_t run_len = 0;
+
+		while (bit < bm->size && scanned < bm->size &&
+		    run_len < count && !fs_bitmap_is_set(bm, bit)) {
+			size_t skip = (byte_is(bm, bit, 0) &&
+			    count - run_len >= BYTE_BITS &&
+			    bm->size - scanned >= BYTE_BITS) ? BYTE_BITS : 1;
+			bit += skip;
+			scanned += skip;
+			run_len += skip;
+		}
+
+		if (run_len == count) {
+			*start = run_start;
+			*len = count;
+			return true;
+		}
+
+		if (run_len > best_len) {
+			best_start = run_start;
+			best_len = run_len;
+		}
+
+		if (bit == bm->size)
+			bit = 0;
+	}
+
+	*start = best_start;
+	*len = best_len;
+	return best_len > 0;
+}
+
+/**
+ * @}
+ */
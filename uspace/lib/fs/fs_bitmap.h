@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libfs
+ * @{
+ */
+/**
+ * @file
+ * In-memory bitmaps of used blocks or clusters.
+ */
+
+#ifndef LIBFS_FS_BITMAP_H_
+#define LIBFS_FS_BITMAP_H_
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Bitmap with one bit per allocation unit, set bits mark used units. */
+typedef struct {
+	/** Number of bits in the bitmap. */
+	size_t size;
+	/** Number of clear bits. */
+	size_t free;
+	/** Bit to start the next search for free bits at. */
+	size_t hint;
+	/** Bits, least significant bit of each byte first. */
+	uint8_t *map;
+} fs_bitmap_t;
+
+extern errno_t fs_bitmap_create(fs_bitmap_t *, size_t);
+extern void fs_bitmap_destroy(fs_bitmap_t *);
+extern void fs_bitmap_import(fs_bitmap_t *, size_t, const void *, size_t);
+extern bool fs_bitmap_is_set(fs_bitmap_t *, size_t);
+extern void fs_bitmap_set_range(fs_bitmap_t *, size_t, size_t);
+extern void fs_bitmap_clear_range(fs_bitmap_t *, size_t, size_t);
+extern bool fs_bitmap_find_free(fs_bitmap_t *, size_t, size_t *, size_t *);
+
+#endif
+
+/**
+ * @}
+ */
@@ -35,6 +35,7 @@
  */
 
 #include "libfs.h"
+#include <align.h>
 #include <macros.h>
 #include <errno.h>
 #include <async.h>
@@ -63,6 +64,9 @@
 		return; \
 	} while (0)
 
+/** Largest buffer filled by one readdir operation. */
+#define LIBFS_READDIR_MAX  (64 * 1024)
+
 static fs_reg_t reg;
 
 static vfs_out_ops_t *vfs_out_ops = NULL;
@@ -70,6 +74,34 @@ static libfs_ops_t *libfs_ops = NULL;
 
 static char fs_name[FS_NAME_MAXLEN + 1];
 
+/** Buffer shared by VFS for reading a node. */
+typedef struct {
+	link_t link;
+	sysarg_t id;
+	service_id_t service_id;
+	fs_index_t index;
+	void *data;
+	size_t size;
+} libfs_buffer_t;
+
+/** Read request being served into a shared buffer. */
+typedef struct {
+	libfs_buffer_t *buffer;
+	/** Offset in the buffer where the current read operation goes. */
+	size_t offset;
+	/** Offset in the buffer where the request ends. */
+	size_t size;
+} libfs_buffer_read_t;
+
+/** Whether the read operation supports shared buffers. */
+static bool read_buffer = false;
+
+static FIBRIL_MUTEX_INITIALIZE(buffers_mutex);
+static LIST_INITIALIZE(buffers);
+
+/** Shared buffer read request of this fibril, if any. */
+static fibril_local libfs_buffer_read_t *buffer_read = NULL;
+
 static void libfs_link(libfs_ops_t *, fs_handle_t, ipc_call_t *);
 static void libfs_lookup(libfs_ops_t *, fs_handle_t, ipc_call_t *);
 static void libfs_stat(libfs_ops_t *, fs_handle_t, ipc_call_t *);
@@ -166,6 +198,174 @@ static void vfs_out_read(ipc_call_t *req)
 		async_answer_0(req, rc);
 }
 
+static void vfs_out_readdir(ipc_call_t *req)
+{
+	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
+	fs_index_t index = (fs_index_t) ipc_get_arg2(req);
+	aoff64_t pos = (aoff64_t) MERGE_LOUP32(ipc_get_arg3(req),
+	    ipc_get_arg4(req));
+
+	ipc_call_t call;
+	size_t size;
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		answer_and_return(req, EINVAL);
+	}
+
+	if (vfs_out_ops->readdir == NULL) {
+		/* The client falls back to reading one entry at a time */
+		async_answer_0(&call, ENOTSUP);
+		answer_and_return(req, ENOTSUP);
+	}
+
+	size = min(size, LIBFS_READDIR_MAX);
+	void *buf = malloc(size);
+	if (buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		answer_and_return(req, ENOMEM);
+	}
+
+	size_t used = 0;
+	errno_t rc = vfs_out_ops->readdir(service_id, index, pos, buf, size,
+	    &used);
+	if (rc == EOK)
+		rc = async_data_read_finalize(&call, buf, used);
+	else
+		async_answer_0(&call, rc);
+
+	free(buf);
+
+	if (rc == EOK)
+		async_answer_1(req, EOK, used);
+	else
+		async_answer_0(req, rc);
+}
+
+static libfs_buffer_t *libfs_buffer_find(sysarg_t id)
+{
+	assert(fibril_mutex_is_locked(&buffers_mutex));
+
+	list_foreach(buffers, link, libfs_buffer_t, buffer) {
+		if (buffer->id == id)
+			return buffer;
+	}
+
+	return NULL;
+}
+
+static void vfs_out_share_buffer(ipc_call_t *req)
+{
+	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
+	fs_index_t index = (fs_index_t) ipc_get_arg2(req);
+	sysarg_t id = ipc_get_arg3(req);
+
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		async_answer_0(&call, EINVAL);
+		answer_and_return(req, EINVAL);
+	}
+
+	if (!read_buffer || !(flags & AS_AREA_WRITE)) {
+		async_answer_0(&call, ENOTSUP);
+		answer_and_return(req, ENOTSUP);
+	}
+
+	libfs_buffer_t *buffer = malloc(sizeof(libfs_buffer_t));
+	if (buffer == NULL) {
+		async_answer_0(&call, ENOMEM);
+		answer_and_return(req, ENOMEM);
+	}
+
+	errno_t rc = async_share_out_finalize(&call, &buffer->data);
+	if (rc != EOK || buffer->data == AS_MAP_FAILED) {
+		free(buffer);
+		answer_and_return(req, rc != EOK ? rc : ENOMEM);
+	}
+
+	link_initialize(&buffer->link);
+	buffer->id = id;
+	buffer->service_id = service_id;
+	buffer->index = index;
+	buffer->size = size;
+
+	fibril_mutex_lock(&buffers_mutex);
+	list_append(&buffer->link, &buffers);
+	fibril_mutex_unlock(&buffers_mutex);
+
+	async_answer_0(req, EOK);
+}
+
+static void vfs_out_release_buffer(ipc_call_t *req)
+{
+	sysarg_t id = ipc_get_arg1(req);
+
+	fibril_mutex_lock(&buffers_mutex);
+	libfs_buffer_t *buffer = libfs_buffer_find(id);
+	if (buffer != NULL)
+		list_remove(&buffer->link);
+	fibril_mutex_unlock(&buffers_mutex);
+
+	if (buffer == NULL)
+		answer_and_return(req, ENOENT);
+
+	as_area_destroy(buffer->data);
+	free(buffer);
+	async_answer_0(req, EOK);
+}
+
+static void vfs_out_read_buffer(ipc_call_t *req)
+{
+	sysarg_t id = ipc_get_arg1(req);
+	aoff64_t pos = (aoff64_t) MERGE_LOUP32(ipc_get_arg2(req),
+	    ipc_get_arg3(req));
+	size_t size = ipc_get_arg4(req);
+	size_t offset = ipc_get_arg5(req);
+
+	/*
+	 * VFS does not release a buffer while a read into it is in
+	 * progress.
+	 */
+	fibril_mutex_lock(&buffers_mutex);
+	libfs_buffer_t *buffer = libfs_buffer_find(id);
+	fibril_mutex_unlock(&buffers_mutex);
+
+	if (buffer == NULL)
+		answer_and_return(req, ENOENT);
+	if (offset > buffer->size || size > buffer->size - offset)
+		answer_and_return(req, EINVAL);
+
+	libfs_buffer_read_t read = {
+		.buffer = buffer,
+		.offset = offset,
+		.size = offset + size
+	};
+
+	/*
+	 * Read operations may return less data than requested, typically
+	 * one block. Without the IPC round trips, they can simply be
+	 * repeated until the request is satisfied.
+	 */
+	errno_t rc = EOK;
+	buffer_read = &read;
+	while (read.offset < read.size) {
+		size_t rbytes;
+		rc = vfs_out_ops->read(buffer->service_id, buffer->index,
+		    pos + (read.offset - offset), &rbytes);
+		if (rc != EOK || rbytes == 0)
+			break;
+		read.offset += rbytes;
+	}
+	buffer_read = NULL;
+
+	/* Report the data read before an error, like a short read. */
+	if (read.offset > offset || rc == EOK)
+		async_answer_1(req, EOK, read.offset - offset);
+	else
+		async_answer_0(req, rc);
+}
+
 static void vfs_out_write(ipc_call_t *req)
 {
 	service_id_t service_id = (service_id_t) ipc_get_arg1(req);
@@ -313,6 +513,18 @@ static void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_OUT_READ:
 			vfs_out_read(&call);
 			break;
+		case VFS_OUT_READ_BUFFER:
+			vfs_out_read_buffer(&call);
+			break;
+		case VFS_OUT_READDIR:
+			vfs_out_readdir(&call);
+			break;
+		case VFS_OUT_RELEASE_BUFFER:
+			vfs_out_release_buffer(&call);
+			break;
+		case VFS_OUT_SHARE_BUFFER:
+			vfs_out_share_buffer(&call);
+			break;
 		case VFS_OUT_WRITE:
 			vfs_out_write(&call);
 			break;
@@ -347,6 +559,102 @@ static void vfs_connection(ipc_call_t *icall, void *arg)
 	}
 }
 
+/** Receive the data read request of a read operation.
+ *
+ * File system implementations call this in their read operation instead of
+ * async_data_read_receive() if they set read_buffer in their VFS info. When
+ * VFS reads into a shared buffer, no IPC_M_DATA_READ request is sent and
+ * the data end up in the buffer instead.
+ *
+ * @param call Storage for the data read request.
+ * @param size Storage for the maximum size of the data or NULL.
+ *
+ * @return True on success, false on failure.
+ */
+bool libfs_data_read_receive(ipc_call_t *call, size_t *size)
+{
+	if (buffer_read == NULL)
+		return async_data_read_receive(call, size);
+
+	if (size != NULL)
+		*size = buffer_read->size - buffer_read->offset;
+	return true;
+}
+
+/** Finalize the data read request of a read operation.
+ *
+ * @param call Data read request received by libfs_data_read_receive().
+ * @param src  Source data.
+ * @param size Size of the data, at most the size of the request.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t libfs_data_read_finalize(ipc_call_t *call, const void *src,
+    size_t size)
+{
+	if (buffer_read == NULL)
+		return async_data_read_finalize(call, src, size);
+
+	size = min(size, buffer_read->size - buffer_read->offset);
+	if (size > 0) {
+		memcpy((uint8_t *) buffer_read->buffer->data +
+		    buffer_read->offset, src, size);
+	}
+
+	return EOK;
+}
+
+/** Refuse the data read request of a read operation.
+ *
+ * @param call Data read request received by libfs_data_read_receive().
+ * @param rc   Error code.
+ */
+void libfs_data_read_refuse(ipc_call_t *call, errno_t rc)
+{
+	if (buffer_read == NULL)
+		async_answer_0(call, rc);
+}
+
+/** Append a directory entry to a readdir buffer.
+ *
+ * @param buf       Buffer passed to the readdir operation.
+ * @param size      Size of the buffer.
+ * @param used      Number of bytes of the buffer used so far, updated
+ *                  on success.
+ * @param next_pos  Position of the directory entry following this one.
+ * @param index     Index of the node the entry refers to.
+ * @param type      Type of the node.
+ * @param name      Name of the entry, not necessarily null-terminated.
+ * @param name_size Size of the name in bytes.
+ *
+ * @return True if the entry was stored, false if it does not fit.
+ */
+bool libfs_dirent_pack(void *buf, size_t size, size_t *used, aoff64_t next_pos,
+    fs_index_t index, vfs_dirent_type_t type, const char *name,
+    size_t name_size)
+{
+	size_t esize = ALIGN_UP(sizeof(vfs_dirent_t) + name_size + 1,
+	    VFS_DIRENT_ALIGN);
+
+	assert(*used % VFS_DIRENT_ALIGN == 0);
+	if (esize > UINT16_MAX || esize > size - *used)
+		return false;
+
+	vfs_dirent_t *dirent = (vfs_dirent_t *) ((uint8_t *) buf + *used);
+	dirent->next_pos = next_pos;
+	dirent->index = index;
+	dirent->size = esize;
+	dirent->type = type;
+	dirent->reserved = 0;
+
+	char *dname = (char *) (dirent + 1);
+	memcpy(dname, name, name_size);
+	memset(dname + name_size, 0, esize - sizeof(vfs_dirent_t) - name_size);
+
+	*used += esize;
+	return true;
+}
+
 /** Register file system server.
  *
  * This function abstracts away the tedious registration protocol from
@@ -392,6 +700,7 @@ errno_t fs_register(async_sess_t *sess, vfs_info_t *info, vfs_out_ops_t *vops,
 	 */
 	vfs_out_ops = vops;
 	libfs_ops = lops;
+	read_buffer = info->read_buffer;
 
 	str_cpy(fs_name, sizeof(fs_name), info->name);
 
@@ -425,7 +734,19 @@ errno_t fs_register(async_sess_t *sess, vfs_info_t *info, vfs_out_ops_t *vops,
 	async_wait_for(req, NULL);
 	reg.fs_handle = (int) ipc_get_arg1(&answer);
 
-	return ipc_get_retval(&answer);
+	rc = ipc_get_retval(&answer);
+	if (rc != EOK)
+		return rc;
+
+	/*
+	 * VFS talks to us over parallel exchanges, each of them being served
+	 * by its own connection fibril, so serving the connections on more
+	 * threads lets independent requests proceed in parallel.
+	 */
+	if (info->threads > 1)
+		return async_set_manager_threads(info->threads);
+
+	return EOK;
 }
 
 void fs_node_initialize(fs_node_t *fn)
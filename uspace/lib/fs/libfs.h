@@ -52,6 +52,13 @@ typedef struct {
 	errno_t (*close)(service_id_t, fs_index_t);
 	errno_t (*destroy)(service_id_t, fs_index_t);
 	errno_t (*sync)(service_id_t, fs_index_t);
+	/*
+	 * Optional. Packs directory entries starting at the given position
+	 * into the buffer using libfs_dirent_pack(), stores the number of
+	 * bytes used. Zero bytes mean the end of the directory.
+	 */
+	errno_t (*readdir)(service_id_t, fs_index_t, aoff64_t, void *, size_t,
+	    size_t *);
 } vfs_out_ops_t;
 
 typedef struct {
@@ -99,6 +106,13 @@ extern errno_t fs_register(async_sess_t *, vfs_info_t *, vfs_out_ops_t *,
 
 extern void fs_node_initialize(fs_node_t *);
 
+extern bool libfs_data_read_receive(ipc_call_t *, size_t *);
+extern errno_t libfs_data_read_finalize(ipc_call_t *, const void *, size_t);
+extern void libfs_data_read_refuse(ipc_call_t *, errno_t);
+
+extern bool libfs_dirent_pack(void *, size_t, size_t *, aoff64_t, fs_index_t,
+    vfs_dirent_type_t, const char *, size_t);
+
 extern errno_t fs_instance_create(service_id_t, void *);
 extern errno_t fs_instance_get(service_id_t, void **);
 extern errno_t fs_instance_destroy(service_id_t);
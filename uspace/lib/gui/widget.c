@@ -33,7 +33,10 @@
  * @file
  */
 
+#include <stdlib.h>
+
 #include "widget.h"
+#include "window.h"
 
 /** Link widget with parent and initialize default position and size. */
 void widget_init(widget_t *widget, widget_t *parent, const void *data)
@@ -63,6 +66,9 @@ void widget_init(widget_t *widget, widget_t *parent, const void *data)
 	widget->height_ideal = 0;
 	widget->width_max = SIZE_MAX;
 	widget->height_max = SIZE_MAX;
+
+	widget->invalidated = false;
+	widget->child_invalidated = false;
 }
 
 /** Change position and size of the widget. */
@@ -81,6 +87,58 @@ const void *widget_get_data(widget_t *widget)
 	return widget->data;
 }
 
+/** Request repaint of the widget.
+ *
+ * The widget is marked for repaint and its ancestors are marked as having
+ * an invalidated descendant. On the next refresh of the window, only the
+ * marked subtrees are repainted, so that the damage reported to the
+ * compositor covers just the invalidated widgets.
+ */
+void widget_invalidate(widget_t *widget)
+{
+	widget->invalidated = true;
+
+	for (widget_t *anc = widget->parent; anc != NULL; anc = anc->parent)
+		anc->child_invalidated = true;
+
+	window_event_t *event = malloc(sizeof(window_event_t));
+	if (event) {
+		link_initialize(&event->link);
+		event->type = ET_WINDOW_REFRESH;
+		prodcons_produce(&widget->window->events, &event->link);
+	}
+}
+
+/** Clear invalidation marks of the whole subtree. */
+static void widget_validate(widget_t *widget)
+{
+	widget->invalidated = false;
+	widget->child_invalidated = false;
+
+	list_foreach(widget->children, link, widget_t, child) {
+		widget_validate(child);
+	}
+}
+
+/** Repaint invalidated widgets of the subtree in top-bottom order. */
+void widget_repaint_invalidated(widget_t *widget)
+{
+	if (widget->invalidated) {
+		/* Repaint of the widget repaints also its children. */
+		widget_validate(widget);
+		widget->repaint(widget);
+		return;
+	}
+
+	if (widget->child_invalidated) {
+		widget->child_invalidated = false;
+
+		list_foreach(widget->children, link, widget_t, child) {
+			widget_repaint_invalidated(child);
+		}
+	}
+}
+
 /** Unlink widget from its parent. */
 void widget_deinit(widget_t *widget)
 {
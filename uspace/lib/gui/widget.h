@@ -37,6 +37,7 @@
 #define GUI_WIDGET_H_
 
 #include <adt/list.h>
+#include <stdbool.h>
 #include <io/window.h>
 
 struct window;
@@ -68,6 +69,9 @@ struct widget {
 	sysarg_t width_max;
 	sysarg_t height_max;
 
+	bool invalidated; /**< Widget shall be repainted on next refresh. */
+	bool child_invalidated; /**< Some descendant shall be repainted. */
+
 	/**
 	 * Virtual destructor. Apart from deallocating the resources specific for
 	 * the particular widget, each widget shall remove itself from parents
@@ -136,6 +140,8 @@ struct widget {
 extern void widget_init(widget_t *, widget_t *, const void *);
 extern void widget_modify(widget_t *, sysarg_t, sysarg_t, sysarg_t, sysarg_t);
 extern const void *widget_get_data(widget_t *);
+extern void widget_invalidate(widget_t *);
+extern void widget_repaint_invalidated(widget_t *);
 extern void widget_deinit(widget_t *);
 
 #endif
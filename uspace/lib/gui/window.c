@@ -440,6 +440,11 @@ static void handle_refresh(window_t *win)
 	win->root.repaint(&win->root);
 }
 
+static void handle_invalidated(window_t *win)
+{
+	widget_repaint_invalidated(&win->root);
+}
+
 static void handle_damage(window_t *win)
 {
 	sysarg_t x, y, width, height;
@@ -533,7 +538,7 @@ static errno_t event_loop(void *arg)
 			}
 			break;
 		case ET_WINDOW_REFRESH:
-			handle_refresh(win);
+			handle_invalidated(win);
 			break;
 		case ET_WINDOW_DAMAGE:
 			handle_damage(win);
@@ -559,12 +564,52 @@ static errno_t event_loop(void *arg)
 	return 0;
 }
 
+/* Number of events taken from the event ring at once. */
+#define FETCH_BATCH  16
+
+/* Input fetcher using the shared-memory event ring. */
+static void fetch_input_ring(window_t *win, win_events_t *events)
+{
+	window_event_t batch[FETCH_BATCH];
+	size_t count;
+	size_t i;
+	errno_t rc;
+
+	while (true) {
+		rc = win_events_read(events, batch, FETCH_BATCH, &count);
+		if (rc != EOK)
+			return;
+
+		for (i = 0; i < count; i++) {
+			window_event_t *event =
+			    (window_event_t *) malloc(sizeof(window_event_t));
+			if (event == NULL)
+				return;
+
+			*event = batch[i];
+			link_initialize(&event->link);
+			prodcons_produce(&win->events, &event->link);
+
+			if (event->type == ET_WINDOW_CLOSE)
+				return;
+		}
+	}
+}
+
 /* Input fetcher from compositor. Runs in own dedicated fibril. */
 static errno_t fetch_input(void *arg)
 {
 	errno_t rc;
 	bool terminate = false;
 	window_t *win = (window_t *) arg;
+	win_events_t *events;
+
+	/* Prefer the event ring, fall back to fetching events one by one. */
+	rc = win_events_open(win->isess, &events);
+	if (rc == EOK) {
+		fetch_input_ring(win, events);
+		return 0;
+	}
 
 	while (true) {
 		window_event_t *event = (window_event_t *) malloc(sizeof(window_event_t));
@@ -698,12 +743,7 @@ errno_t window_set_caption(window_t *win, const char *caption)
 
 void window_refresh(window_t *win)
 {
-	window_event_t *event = (window_event_t *) malloc(sizeof(window_event_t));
-	if (event) {
-		link_initialize(&event->link);
-		event->type = ET_WINDOW_REFRESH;
-		prodcons_produce(&win->events, &event->link);
-	}
+	widget_invalidate(&win->root);
 }
 
 void window_damage(window_t *win)
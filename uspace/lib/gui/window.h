@@ -82,9 +82,9 @@ extern errno_t window_set_caption(window_t *, const char *);
 
 /**
  * Post refresh event into event loop. Widget tree is traversed and all widgets
- * are asked to repaint themselves in top-bottom order. Should be called by
- * widget after such change of its internal state that does not need resizing
- * of neither parent nor children ().
+ * are asked to repaint themselves in top-bottom order. Widgets that change
+ * only their own appearance should rather call widget_invalidate(), so that
+ * only they are repainted.
  */
 extern void window_refresh(window_t *);
 
@@ -38,6 +38,7 @@
 
 #include <async.h>
 #include <errno.h>
+#include <time.h>
 #include <pcm/format.h>
 
 extern const char *HOUND_SERVICE;
@@ -59,6 +60,14 @@ typedef async_sess_t hound_sess_t;
 typedef struct {
 } *hound_context_id_t;
 
+/** Playback statistics of the audio server */
+typedef struct {
+	/** Number of times a stream did not provide data in time */
+	size_t underruns;
+	/** Longest time of audio buffered in a stream, in microseconds */
+	usec_t latency;
+} hound_stats_t;
+
 hound_sess_t *hound_service_connect(const char *service);
 void hound_service_disconnect(hound_sess_t *sess);
 
@@ -87,6 +96,7 @@ errno_t hound_service_connect_source_sink(hound_sess_t *sess, const char *source
     const char *sink);
 errno_t hound_service_disconnect_source_sink(hound_sess_t *sess, const char *source,
     const char *sink);
+errno_t hound_service_get_stats(hound_sess_t *sess, hound_stats_t *stats);
 
 errno_t hound_service_stream_enter(async_exch_t *exch, hound_context_id_t id,
     int flags, pcm_format_t format, size_t bsize);
@@ -119,10 +129,12 @@ typedef struct hound_server_iface {
 	errno_t (*rem_stream)(void *, void *);
 	/** Block until the stream buffer is empty */
 	errno_t (*drain_stream)(void *);
-	/** Write new data to the stream */
+	/** Write new data to the stream, the data are copied */
 	errno_t (*stream_data_write)(void *, void *, size_t);
 	/** Read data from the stream */
 	errno_t (*stream_data_read)(void *, void *, size_t);
+	/** Get playback statistics */
+	errno_t (*get_stats)(void *, hound_stats_t *);
 	void *server;
 } hound_server_iface_t;
 
@@ -64,6 +64,8 @@ enum ipc_methods {
 	IPC_M_HOUND_STREAM_EXIT,
 	/** Wait until there is no data in the stream */
 	IPC_M_HOUND_STREAM_DRAIN,
+	/** Query playback statistics */
+	IPC_M_HOUND_GET_STATS,
 };
 
 /** PCM format conversion helper structure */
@@ -294,6 +296,31 @@ errno_t hound_service_disconnect_source_sink(hound_sess_t *sess, const char *sou
 	return ENOTSUP;
 }
 
+/**
+ * Query playback statistics of the server.
+ * @param[in] sess Valid audio session.
+ * @param[out] stats Place to store the statistics.
+ * @return Error code.
+ */
+errno_t hound_service_get_stats(hound_sess_t *sess, hound_stats_t *stats)
+{
+	assert(sess);
+	assert(stats);
+	async_exch_t *exch = async_exchange_begin(sess);
+	if (!exch)
+		return ENOMEM;
+	sysarg_t underruns = 0;
+	sysarg_t latency = 0;
+	const errno_t ret = async_req_0_2(exch, IPC_M_HOUND_GET_STATS,
+	    &underruns, &latency);
+	async_exchange_end(exch);
+	if (ret == EOK) {
+		stats->underruns = underruns;
+		stats->latency = latency;
+	}
+	return ret;
+}
+
 /**
  * Switch IPC exchange to a STREAM mode.
  * @param exch IPC exchange.
@@ -608,6 +635,23 @@ void hound_connection_handler(ipc_call_t *icall, void *arg)
 				}
 			}
 			break;
+		case IPC_M_HOUND_GET_STATS:
+			/* check interface functions */
+			if (!server_iface || !server_iface->get_stats) {
+				async_answer_0(&call, ENOTSUP);
+				break;
+			}
+
+			hound_stats_t stats;
+			ret = server_iface->get_stats(server_iface->server,
+			    &stats);
+			if (ret != EOK) {
+				async_answer_0(&call, ret);
+			} else {
+				async_answer_2(&call, EOK, stats.underruns,
+				    stats.latency);
+			}
+			break;
 		case IPC_M_HOUND_STREAM_EXIT:
 		case IPC_M_HOUND_STREAM_DRAIN:
 			/* Stream exit/drain is only allowed in stream context*/
@@ -636,6 +680,9 @@ static void hound_server_read_data(void *stream)
 	ipc_call_t call;
 	size_t size = 0;
 	errno_t ret_answer = EOK;
+	/* The server copies the data, the buffer is reused */
+	char *buffer = NULL;
+	size_t buffer_size = 0;
 
 	/* accept data write or drain */
 	while (async_data_write_receive(&call, &size) ||
@@ -655,10 +702,14 @@ static void hound_server_read_data(void *stream)
 			continue;
 		}
 
-		char *buffer = malloc(size);
-		if (!buffer) {
-			async_answer_0(&call, ENOMEM);
-			continue;
+		if (size > buffer_size) {
+			char *new_buffer = realloc(buffer, size);
+			if (!new_buffer) {
+				async_answer_0(&call, ENOMEM);
+				continue;
+			}
+			buffer = new_buffer;
+			buffer_size = size;
 		}
 		const errno_t ret = async_data_write_finalize(&call, buffer, size);
 		if (ret == EOK) {
@@ -667,6 +718,7 @@ static void hound_server_read_data(void *stream)
 			    stream, buffer, size);
 		}
 	}
+	free(buffer);
 	const errno_t ret = ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_EXIT ?
 	    EOK : EINVAL;
 
@@ -683,6 +735,8 @@ static void hound_server_write_data(void *stream)
 	ipc_call_t call;
 	size_t size = 0;
 	errno_t ret_answer = EOK;
+	char *buffer = NULL;
+	size_t buffer_size = 0;
 
 	/* accept data read and drain */
 	while (async_data_read_receive(&call, &size) ||
@@ -700,10 +754,14 @@ static void hound_server_write_data(void *stream)
 			async_answer_0(&call, ret_answer);
 			continue;
 		}
-		char *buffer = malloc(size);
-		if (!buffer) {
-			async_answer_0(&call, ENOMEM);
-			continue;
+		if (size > buffer_size) {
+			char *new_buffer = realloc(buffer, size);
+			if (!new_buffer) {
+				async_answer_0(&call, ENOMEM);
+				continue;
+			}
+			buffer = new_buffer;
+			buffer_size = size;
 		}
 		errno_t ret = server_iface->stream_data_read(stream, buffer, size);
 		if (ret == EOK) {
@@ -711,6 +769,7 @@ static void hound_server_write_data(void *stream)
 			    async_data_read_finalize(&call, buffer, size);
 		}
 	}
+	free(buffer);
 	const errno_t ret = ipc_get_imethod(&call) == IPC_M_HOUND_STREAM_EXIT ?
 	    EOK : EINVAL;
 
@@ -46,6 +46,8 @@ typedef struct {
 	char *host;
 	uint16_t port;
 	inet_addr_t addr;
+	/** @c addr holds the resolved address of @c host */
+	bool addr_valid;
 
 	tcp_t *tcp;
 	tcp_conn_t *conn;
@@ -82,8 +84,58 @@ typedef struct {
 	http_headers_t headers;
 } http_response_t;
 
+/** String in a buffer, not null-terminated */
+typedef struct {
+	char *data;
+	size_t size;
+} http_slice_t;
+
+/** Header field parsed in place */
+typedef struct {
+	http_slice_t name;
+	http_slice_t value;
+} http_field_t;
+
+/** Parser of a message head (start line and header fields)
+ *
+ * The head is parsed in place in the receive buffer. Slices returned
+ * by the parser stay valid until the receive buffer is read from again.
+ */
+typedef struct {
+	receive_buffer_t *rb;
+	/** Start of the head in the receive buffer */
+	char *head;
+	/** Size of the head including the terminating empty line */
+	size_t size;
+	/** Parsing position in the head */
+	size_t pos;
+} http_parser_t;
+
+/** How the end of a message body is determined */
+typedef enum {
+	/** Body has a known length */
+	http_body_length,
+	/** Body uses chunked transfer coding */
+	http_body_chunked,
+	/** Body ends when the connection is closed */
+	http_body_close
+} http_body_kind_t;
+
+/** Reader of a message body */
+typedef struct {
+	receive_buffer_t *rb;
+	http_body_kind_t kind;
+	/** Bytes left in the body or in the current chunk */
+	uint64_t left;
+	/** A chunk was read and its terminating CRLF was not yet */
+	bool chunk_end;
+	/** The whole body was read */
+	bool done;
+} http_body_t;
+
 extern http_t *http_create(const char *, uint16_t);
 extern errno_t http_connect(http_t *);
+extern errno_t http_reconnect(http_t *);
 
 extern void http_header_init(http_header_t *);
 extern http_header_t *http_header_create(const char *, const char *);
@@ -125,12 +177,39 @@ static inline void http_headers_append_header(http_headers_t *headers,
 extern http_request_t *http_request_create(const char *, const char *);
 extern void http_request_destroy(http_request_t *);
 extern errno_t http_request_format(http_request_t *, char **, size_t *);
+extern errno_t http_request_set_range(http_request_t *, uint64_t, uint64_t);
 extern errno_t http_send_request(http_t *, http_request_t *);
 extern errno_t http_receive_status(receive_buffer_t *, http_version_t *, uint16_t *,
     char **);
 extern errno_t http_receive_response(receive_buffer_t *, http_response_t **,
     size_t, unsigned);
+extern bool http_response_persistent(http_response_t *);
+extern errno_t http_response_content_range(http_response_t *, uint64_t *,
+    uint64_t *, uint64_t *);
 extern void http_response_destroy(http_response_t *);
+
+extern errno_t http_parser_receive(http_parser_t *, receive_buffer_t *, size_t);
+extern bool http_parser_buffered(receive_buffer_t *);
+extern void http_parser_end(http_parser_t *);
+extern errno_t http_parser_request_line(http_parser_t *, http_slice_t *,
+    http_slice_t *, http_version_t *);
+extern errno_t http_parser_status_line(http_parser_t *, http_version_t *,
+    uint16_t *, http_slice_t *);
+extern errno_t http_parser_field(http_parser_t *, http_field_t *);
+extern errno_t http_receive_line(receive_buffer_t *, http_slice_t *);
+extern bool http_slice_equal(http_slice_t *, const char *);
+extern bool http_slice_equal_nocase(http_slice_t *, const char *);
+extern bool http_slice_has_token(http_slice_t *, const char *);
+extern errno_t http_slice_uint64(http_slice_t *, unsigned, uint64_t *);
+extern char *http_slice_dup(http_slice_t *);
+
+extern void http_body_init(http_body_t *, receive_buffer_t *,
+    http_body_kind_t, uint64_t);
+extern errno_t http_body_init_headers(http_body_t *, receive_buffer_t *,
+    http_headers_t *);
+extern errno_t http_body_read(http_body_t *, void *, size_t, size_t *);
+extern errno_t http_body_skip(http_body_t *);
+
 extern errno_t http_close(http_t *);
 extern void http_destroy(http_t *);
 
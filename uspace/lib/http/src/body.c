@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup http
+ * @{
+ */
+/**
+ * @file
+ *
+ * Streaming of message bodies delimited by length, by chunked transfer
+ * coding or by closing the connection.
+ */
+
+#include <errno.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+
+#include <http/http.h>
+
+/** Initialize body reader
+ *
+ * @param body   Body reader
+ * @param rb     Receive buffer positioned at the start of the body
+ * @param kind   How the end of body is determined
+ * @param length Length of the body if @a kind is @c http_body_length
+ */
+void http_body_init(http_body_t *body, receive_buffer_t *rb,
+    http_body_kind_t kind, uint64_t length)
+{
+	body->rb = rb;
+	body->kind = kind;
+	body->left = (kind == http_body_length) ? length : 0;
+	body->chunk_end = false;
+	body->done = (kind == http_body_length && length == 0);
+}
+
+/** Initialize body reader according to message header fields
+ *
+ * A body without Transfer-Encoding and Content-Length is delimited by
+ * closing the connection, as is the case for responses.
+ *
+ * @param body    Body reader
+ * @param rb      Receive buffer positioned at the start of the body
+ * @param headers Header fields of the message
+ *
+ * @return EOK on success, HTTP_EPARSE if the header fields are invalid
+ */
+errno_t http_body_init_headers(http_body_t *body, receive_buffer_t *rb,
+    http_headers_t *headers)
+{
+	http_slice_t value;
+	uint64_t length;
+	char *str;
+	errno_t rc;
+
+	rc = http_headers_get(headers, "Transfer-Encoding", &str);
+	if (rc == EOK) {
+		value.data = str;
+		value.size = str_size(str);
+		if (!http_slice_has_token(&value, "chunked"))
+			return HTTP_EPARSE;
+
+		http_body_init(body, rb, http_body_chunked, 0);
+		return EOK;
+	}
+
+	rc = http_headers_get(headers, "Content-Length", &str);
+	if (rc == EOK) {
+		value.data = str;
+		value.size = str_size(str);
+		if (http_slice_uint64(&value, 10, &length) != EOK)
+			return HTTP_EPARSE;
+
+		http_body_init(body, rb, http_body_length, length);
+		return EOK;
+	}
+
+	http_body_init(body, rb, http_body_close, 0);
+	return EOK;
+}
+
+/** Receive size line of the next chunk
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t http_body_chunk_begin(http_body_t *body)
+{
+	http_slice_t line;
+	char *semicolon;
+	errno_t rc;
+
+	if (body->chunk_end) {
+		/* Empty line terminating the previous chunk */
+		rc = http_receive_line(body->rb, &line);
+		if (rc != EOK)
+			return rc == ENOENT ? EIO : rc;
+		if (line.size != 0)
+			return HTTP_EPARSE;
+		body->chunk_end = false;
+	}
+
+	rc = http_receive_line(body->rb, &line);
+	if (rc != EOK)
+		return rc == ENOENT ? EIO : rc;
+
+	/* Ignore chunk extensions */
+	semicolon = memchr(line.data, ';', line.size);
+	if (semicolon != NULL)
+		line.size = semicolon - line.data;
+	while (line.size > 0 && (line.data[line.size - 1] == ' ' ||
+	    line.data[line.size - 1] == '\t'))
+		--line.size;
+
+	if (http_slice_uint64(&line, 16, &body->left) != EOK)
+		return HTTP_EPARSE;
+
+	if (body->left > 0) {
+		body->chunk_end = true;
+		return EOK;
+	}
+
+	/* Last chunk, skip the trailer */
+	do {
+		rc = http_receive_line(body->rb, &line);
+		if (rc != EOK)
+			return rc == ENOENT ? EIO : rc;
+	} while (line.size != 0);
+
+	body->done = true;
+	return EOK;
+}
+
+/** Read from message body
+ *
+ * @param body  Body reader
+ * @param buf   Buffer to store the data
+ * @param size  Size of the buffer
+ * @param nread Place to store number of bytes read, zero at the end
+ *              of body
+ *
+ * @return EOK on success, EIO if the connection was closed before the
+ *         end of body or an error code
+ */
+errno_t http_body_read(http_body_t *body, void *buf, size_t size,
+    size_t *nread)
+{
+	size_t nrecv;
+	errno_t rc;
+
+	*nread = 0;
+	if (size == 0)
+		return EOK;
+
+	if (body->kind == http_body_chunked) {
+		if (!body->done && body->left == 0) {
+			rc = http_body_chunk_begin(body);
+			if (rc != EOK)
+				return rc;
+		}
+	}
+
+	if (body->done)
+		return EOK;
+
+	if (body->kind != http_body_close)
+		size = min(size, body->left);
+
+	rc = recv_buffer(body->rb, buf, size, &nrecv);
+	if (rc != EOK)
+		return rc;
+
+	if (nrecv == 0) {
+		body->done = true;
+		return (body->kind == http_body_close) ? EOK : EIO;
+	}
+
+	if (body->kind != http_body_close) {
+		body->left -= nrecv;
+		if (body->kind == http_body_length && body->left == 0)
+			body->done = true;
+	}
+
+	*nread = nrecv;
+	return EOK;
+}
+
+/** Discard the rest of message body
+ *
+ * @param body Body reader
+ * @return EOK on success or an error code
+ */
+errno_t http_body_skip(http_body_t *body)
+{
+	char buf[512];
+	size_t nread;
+	errno_t rc;
+
+	do {
+		rc = http_body_read(body, buf, sizeof(buf), &nread);
+		if (rc != EOK)
+			return rc;
+	} while (nread > 0);
+
+	return EOK;
+}
+
+/** @}
+ */
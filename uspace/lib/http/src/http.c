@@ -66,11 +66,15 @@ http_t *http_create(const char *host, uint16_t port)
 		return NULL;
 	}
 	http->port = port;
+	http->addr_valid = false;
+	http->tcp = NULL;
+	http->conn = NULL;
 
-	http->buffer_size = 4096;
+	http->buffer_size = 16384;
 	errno_t rc = recv_buffer_init(&http->recv_buffer, http->buffer_size,
 	    http_receive, http);
 	if (rc != EOK) {
+		free(http->host);
 		free(http);
 		return NULL;
 	}
@@ -80,13 +84,19 @@ http_t *http_create(const char *host, uint16_t port)
 
 errno_t http_connect(http_t *http)
 {
+	errno_t rc;
+
 	if (http->conn != NULL)
 		return EBUSY;
 
-	errno_t rc = inet_host_plookup_one(http->host, ip_any, &http->addr, NULL,
-	    NULL);
-	if (rc != EOK)
-		return rc;
+	/* Reconnecting does not need to resolve the host again */
+	if (!http->addr_valid) {
+		rc = inet_host_plookup_one(http->host, ip_any, &http->addr,
+		    NULL, NULL);
+		if (rc != EOK)
+			return rc;
+		http->addr_valid = true;
+	}
 
 	inet_ep2_t epp;
 
@@ -100,15 +110,37 @@ errno_t http_connect(http_t *http)
 
 	rc = tcp_conn_create(http->tcp, &epp, NULL, NULL, &http->conn);
 	if (rc != EOK)
-		return rc;
+		goto error;
 
 	rc = tcp_conn_wait_connected(http->conn);
 	if (rc != EOK)
-		return rc;
+		goto error;
 
+	/* Nothing received over a previous connection is valid any more */
+	recv_reset(&http->recv_buffer);
+	return EOK;
+error:
+	tcp_conn_destroy(http->conn);
+	http->conn = NULL;
+	tcp_destroy(http->tcp);
+	http->tcp = NULL;
 	return rc;
 }
 
+/** Open a new connection, closing the current one if there is any
+ *
+ * Used when the server closed a persistent connection or when the
+ * connection is in an unknown state after an error.
+ *
+ * @param http HTTP client
+ * @return EOK on success or an error code
+ */
+errno_t http_reconnect(http_t *http)
+{
+	(void) http_close(http);
+	return http_connect(http);
+}
+
 errno_t http_close(http_t *http)
 {
 	if (http->conn == NULL)
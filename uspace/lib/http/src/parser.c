@@ -0,0 +1,601 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup http
+ * @{
+ */
+/**
+ * @file
+ *
+ * Parsing of message heads in place in the receive buffer. The buffer
+ * is searched for line ends and colons a machine word at a time and
+ * the parser returns slices of the buffer instead of allocated strings.
+ */
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <str.h>
+
+#include <http/http.h>
+#include <http/ctype.h>
+
+/** Find first occurrence of either of two characters
+ *
+ * Whole machine words are examined at once, using the fact that
+ * (x - 0x01..01) & ~x & 0x80..80 is non-zero iff some byte of x is zero.
+ *
+ * @param buf  Buffer to search
+ * @param size Size of the buffer
+ * @param c1   First character to look for
+ * @param c2   Second character to look for
+ *
+ * @return Pointer to the first occurrence or @c NULL if none was found
+ */
+static char *http_scan(char *buf, size_t size, char c1, char c2)
+{
+	const unsigned long ones = (unsigned long) -1 / 0xff;
+	const unsigned long highs = ones << 7;
+	const unsigned long m1 = ones * (unsigned char) c1;
+	const unsigned long m2 = ones * (unsigned char) c2;
+	unsigned long w;
+	unsigned long x1;
+	unsigned long x2;
+
+	while (size >= sizeof(w)) {
+		memcpy(&w, buf, sizeof(w));
+		x1 = w ^ m1;
+		x2 = w ^ m2;
+		if ((((x1 - ones) & ~x1) | ((x2 - ones) & ~x2)) & highs)
+			break;
+
+		buf += sizeof(w);
+		size -= sizeof(w);
+	}
+
+	while (size > 0) {
+		if (*buf == c1 || *buf == c2)
+			return buf;
+		++buf;
+		--size;
+	}
+
+	return NULL;
+}
+
+/** Find the end of message head among buffered data
+ *
+ * @param rb    Receive buffer
+ * @param start Offset from @c rb->out where to start searching, updated
+ *              so that the search can be resumed with more data
+ * @param rsize Place to store size of the head
+ *
+ * @return @c true if the whole head is buffered
+ */
+static bool http_head_find(receive_buffer_t *rb, size_t *start,
+    size_t *rsize)
+{
+	char *head = rb->buffer + rb->out;
+	size_t avail = rb->in - rb->out;
+	size_t off = *start;
+	char *nl;
+
+	while (off < avail) {
+		nl = http_scan(head + off, avail - off, '\n', '\n');
+		if (nl == NULL) {
+			off = avail;
+			break;
+		}
+
+		off = nl - head + 1;
+
+		/* Decide whether an empty line follows */
+		if (off < avail && head[off] == '\n') {
+			*rsize = off + 1;
+			return true;
+		}
+
+		if (off + 1 < avail && head[off] == '\r' &&
+		    head[off + 1] == '\n') {
+			*rsize = off + 2;
+			return true;
+		}
+
+		if (off + 1 >= avail && (off == avail || head[off] == '\r')) {
+			/* Cannot decide yet, look at this line end again */
+			off = nl - head;
+			break;
+		}
+	}
+
+	*start = off;
+	return false;
+}
+
+/** Skip empty lines preceding a message
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t http_skip_empty_lines(receive_buffer_t *rb)
+{
+	errno_t rc;
+
+	while (true) {
+		while (rb->in - rb->out < 2) {
+			rc = recv_fill(rb);
+			if (rc != EOK)
+				return rc;
+		}
+
+		if (rb->buffer[rb->out] == '\n')
+			rb->out++;
+		else if (rb->buffer[rb->out] == '\r' &&
+		    rb->buffer[rb->out + 1] == '\n')
+			rb->out += 2;
+		else
+			return EOK;
+	}
+}
+
+/** Receive message head
+ *
+ * Wait until the whole message head is in the receive buffer and set up
+ * the parser for it. Empty lines preceding the head are skipped.
+ *
+ * @param parser Parser
+ * @param rb     Receive buffer
+ * @param limit  Maximum size of the head or zero for no limit other than
+ *               the size of the receive buffer
+ *
+ * @return EOK on success, ELIMIT if the head is too large, ENOENT if
+ *         the connection was closed or an error code
+ */
+errno_t http_parser_receive(http_parser_t *parser, receive_buffer_t *rb,
+    size_t limit)
+{
+	size_t start = 0;
+	size_t size;
+	errno_t rc;
+
+	rc = http_skip_empty_lines(rb);
+	if (rc != EOK)
+		return rc;
+
+	while (!http_head_find(rb, &start, &size)) {
+		if (limit > 0 && start > limit)
+			return ELIMIT;
+
+		rc = recv_fill(rb);
+		if (rc != EOK)
+			return rc;
+	}
+
+	if (limit > 0 && size > limit)
+		return ELIMIT;
+
+	parser->rb = rb;
+	parser->head = rb->buffer + rb->out;
+	parser->size = size;
+	parser->pos = 0;
+	return EOK;
+}
+
+/** Determine whether a whole message head is buffered
+ *
+ * This can be used to find out whether another pipelined message already
+ * arrived.
+ *
+ * @param rb Receive buffer
+ * @return @c true if a whole message head is in the receive buffer
+ */
+bool http_parser_buffered(receive_buffer_t *rb)
+{
+	size_t start = 0;
+	size_t size;
+
+	/* Skip empty lines preceding the message */
+	while (start < rb->in - rb->out &&
+	    (rb->buffer[rb->out + start] == '\r' ||
+	    rb->buffer[rb->out + start] == '\n'))
+		++start;
+
+	return http_head_find(rb, &start, &size);
+}
+
+/** Finish parsing message head, removing it from the receive buffer
+ *
+ * @param parser Parser
+ */
+void http_parser_end(http_parser_t *parser)
+{
+	receive_buffer_t *rb = parser->rb;
+
+	assert(rb->buffer + rb->out == parser->head);
+	rb->out += parser->size;
+}
+
+/** Get next line of message head
+ *
+ * @param parser Parser
+ * @param line   Place to store the line without the line terminator
+ *
+ * @return @c true on success, @c false if at the end of head
+ */
+static bool http_parser_line(http_parser_t *parser, http_slice_t *line)
+{
+	char *start = parser->head + parser->pos;
+	size_t avail = parser->size - parser->pos;
+	char *nl;
+	size_t len;
+
+	if (avail == 0)
+		return false;
+
+	nl = http_scan(start, avail, '\n', '\n');
+	assert(nl != NULL);
+
+	len = nl - start;
+	parser->pos += len + 1;
+	if (len > 0 && start[len - 1] == '\r')
+		--len;
+
+	line->data = start;
+	line->size = len;
+	return true;
+}
+
+/** Split slice at the first space
+ *
+ * @param s    Slice, on return the part after the space
+ * @param part Place to store the part before the space
+ *
+ * @return @c true on success, @c false if there is no space
+ */
+static bool http_slice_split(http_slice_t *s, http_slice_t *part)
+{
+	char *sp = http_scan(s->data, s->size, ' ', ' ');
+	if (sp == NULL)
+		return false;
+
+	part->data = s->data;
+	part->size = sp - s->data;
+	s->size -= part->size + 1;
+	s->data = sp + 1;
+	return true;
+}
+
+/** Parse HTTP version in the form HTTP/x.y */
+static errno_t http_parse_version(http_slice_t *s, http_version_t *version)
+{
+	if (s->size != 8 || memcmp(s->data, "HTTP/", 5) != 0 ||
+	    s->data[6] != '.' || s->data[5] < '0' || s->data[5] > '9' ||
+	    s->data[7] < '0' || s->data[7] > '9')
+		return HTTP_EPARSE;
+
+	version->major = s->data[5] - '0';
+	version->minor = s->data[7] - '0';
+	return EOK;
+}
+
+/** Parse request line
+ *
+ * @param parser  Parser
+ * @param method  Place to store the method
+ * @param target  Place to store the request target
+ * @param version Place to store the HTTP version
+ *
+ * @return EOK on success, HTTP_EPARSE if the request line is malformed
+ */
+errno_t http_parser_request_line(http_parser_t *parser, http_slice_t *method,
+    http_slice_t *target, http_version_t *version)
+{
+	http_slice_t line;
+
+	if (!http_parser_line(parser, &line))
+		return HTTP_EPARSE;
+
+	if (!http_slice_split(&line, method) || method->size == 0)
+		return HTTP_EPARSE;
+
+	if (!http_slice_split(&line, target) || target->size == 0)
+		return HTTP_EPARSE;
+
+	return http_parse_version(&line, version);
+}
+
+/** Parse status line
+ *
+ * @param parser  Parser
+ * @param version Place to store the HTTP version
+ * @param status  Place to store the status code
+ * @param reason  Place to store the reason phrase
+ *
+ * @return EOK on success, HTTP_EPARSE if the status line is malformed
+ */
+errno_t http_parser_status_line(http_parser_t *parser,
+    http_version_t *version, uint16_t *status, http_slice_t *reason)
+{
+	http_slice_t line;
+	http_slice_t part;
+	uint64_t code;
+	errno_t rc;
+
+	if (!http_parser_line(parser, &line))
+		return HTTP_EPARSE;
+
+	if (!http_slice_split(&line, &part))
+		return HTTP_EPARSE;
+
+	rc = http_parse_version(&part, version);
+	if (rc != EOK)
+		return rc;
+
+	/* The reason phrase may be empty and the space before it missing */
+	if (!http_slice_split(&line, &part)) {
+		part = line;
+		line.data += line.size;
+		line.size = 0;
+	}
+
+	if (part.size != 3 || http_slice_uint64(&part, 10, &code) != EOK)
+		return HTTP_EPARSE;
+
+	*status = code;
+	*reason = line;
+	return EOK;
+}
+
+/** Parse next header field
+ *
+ * Obsolete line folding is replaced by spaces in place, so that the
+ * value is always a single slice.
+ *
+ * @param parser Parser
+ * @param field  Place to store the field
+ *
+ * @return EOK on success, ENOENT if there are no more fields,
+ *         HTTP_EPARSE if the field is malformed
+ */
+errno_t http_parser_field(http_parser_t *parser, http_field_t *field)
+{
+	http_slice_t line;
+	http_slice_t next;
+	char *colon;
+	char *cp;
+
+	if (!http_parser_line(parser, &line) || line.size == 0)
+		return ENOENT;
+
+	/* Join continuation lines */
+	while (parser->pos < parser->size &&
+	    (parser->head[parser->pos] == ' ' ||
+	    parser->head[parser->pos] == '\t')) {
+		(void) http_parser_line(parser, &next);
+		for (cp = line.data + line.size; cp < next.data; cp++)
+			*cp = ' ';
+		line.size = next.data + next.size - line.data;
+	}
+
+	colon = http_scan(line.data, line.size, ':', ':');
+	if (colon == NULL || colon == line.data)
+		return HTTP_EPARSE;
+
+	field->name.data = line.data;
+	field->name.size = colon - line.data;
+	for (cp = field->name.data; cp < colon; cp++) {
+		if (!is_token(*cp))
+			return HTTP_EPARSE;
+	}
+
+	field->value.data = colon + 1;
+	field->value.size = line.data + line.size - (colon + 1);
+
+	while (field->value.size > 0 && (field->value.data[0] == ' ' ||
+	    field->value.data[0] == '\t')) {
+		++field->value.data;
+		--field->value.size;
+	}
+
+	while (field->value.size > 0 &&
+	    (field->value.data[field->value.size - 1] == ' ' ||
+	    field->value.data[field->value.size - 1] == '\t'))
+		--field->value.size;
+
+	return EOK;
+}
+
+/** Receive one line
+ *
+ * The line is consumed from the receive buffer and returned as a slice
+ * without the line terminator, valid until the buffer is read from again.
+ *
+ * @param rb   Receive buffer
+ * @param line Place to store the line
+ *
+ * @return EOK on success, ELIMIT if the line does not fit into the
+ *         receive buffer, ENOENT if the connection was closed or an
+ *         error code
+ */
+errno_t http_receive_line(receive_buffer_t *rb, http_slice_t *line)
+{
+	size_t off = 0;
+	char *nl;
+	size_t len;
+	errno_t rc;
+
+	while (true) {
+		nl = http_scan(rb->buffer + rb->out + off,
+		    rb->in - rb->out - off, '\n', '\n');
+		if (nl != NULL)
+			break;
+
+		off = rb->in - rb->out;
+		rc = recv_fill(rb);
+		if (rc != EOK)
+			return rc;
+	}
+
+	line->data = rb->buffer + rb->out;
+	len = nl - line->data;
+	rb->out += len + 1;
+
+	if (len > 0 && line->data[len - 1] == '\r')
+		--len;
+	line->size = len;
+	return EOK;
+}
+
+/** Compare slice with a string
+ *
+ * @return @c true if the slice is equal to @a str
+ */
+bool http_slice_equal(http_slice_t *s, const char *str)
+{
+	size_t len = str_size(str);
+
+	return s->size == len && memcmp(s->data, str, len) == 0;
+}
+
+/** Compare slice with a string, ignoring case
+ *
+ * @return @c true if the slice is equal to @a str ignoring case
+ */
+bool http_slice_equal_nocase(http_slice_t *s, const char *str)
+{
+	size_t len = str_size(str);
+	size_t i;
+
+	if (s->size != len)
+		return false;
+
+	for (i = 0; i < len; i++) {
+		if (tolower((unsigned char) s->data[i]) !=
+		    tolower((unsigned char) str[i]))
+			return false;
+	}
+
+	return true;
+}
+
+/** Determine whether a comma-separated list contains a token
+ *
+ * Tokens are compared ignoring case, as is usual for values of header
+ * fields such as Connection or Transfer-Encoding.
+ *
+ * @param s     Header field value
+ * @param token Token to look for
+ *
+ * @return @c true if the list contains @a token
+ */
+bool http_slice_has_token(http_slice_t *s, const char *token)
+{
+	http_slice_t item;
+	char *end = s->data + s->size;
+	char *cp = s->data;
+	char *comma;
+
+	while (cp < end) {
+		comma = http_scan(cp, end - cp, ',', ',');
+		if (comma == NULL)
+			comma = end;
+
+		item.data = cp;
+		item.size = comma - cp;
+		while (item.size > 0 && (item.data[0] == ' ' ||
+		    item.data[0] == '\t')) {
+			++item.data;
+			--item.size;
+		}
+
+		while (item.size > 0 && (item.data[item.size - 1] == ' ' ||
+		    item.data[item.size - 1] == '\t'))
+			--item.size;
+
+		if (http_slice_equal_nocase(&item, token))
+			return true;
+
+		cp = comma + 1;
+	}
+
+	return false;
+}
+
+/** Convert slice to a number
+ *
+ * @param s      Slice containing only digits
+ * @param base   Base (10 or 16)
+ * @param rvalue Place to store the number
+ *
+ * @return EOK on success, EINVAL if the slice is not a number, EOVERFLOW
+ *         if the number is too large
+ */
+errno_t http_slice_uint64(http_slice_t *s, unsigned base, uint64_t *rvalue)
+{
+	uint64_t value = 0;
+	unsigned digit;
+	size_t i;
+	char c;
+
+	if (s->size == 0)
+		return EINVAL;
+
+	for (i = 0; i < s->size; i++) {
+		c = s->data[i];
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (base == 16 && c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if (base == 16 && c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			return EINVAL;
+
+		if (value > (UINT64_MAX - digit) / base)
+			return EOVERFLOW;
+
+		value = value * base + digit;
+	}
+
+	*rvalue = value;
+	return EOK;
+}
+
+/** Duplicate slice as a null-terminated string
+ *
+ * @return New string or @c NULL if out of memory
+ */
+char *http_slice_dup(http_slice_t *s)
+{
+	return str_ndup(s->data, s->size);
+}
+
+/** @}
+ */
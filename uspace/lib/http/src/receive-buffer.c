@@ -144,35 +144,57 @@ errno_t recv_cut_str(receive_buffer_t *rb, receive_buffer_mark_t *a, receive_buf
 	return EOK;
 }
 
+/** Receive more data into the buffer
+ *
+ * If the buffer is full, data that were consumed and are not protected
+ * by a mark are discarded to make room. Data that were not consumed
+ * yet stay in the buffer, but may move.
+ *
+ * @return EOK on success, ELIMIT if the buffer is full, ENOENT if
+ *         the peer closed the connection or an error code
+ */
+errno_t recv_fill(receive_buffer_t *rb)
+{
+	size_t free = rb->size - rb->in;
+	if (free == 0) {
+		size_t min_mark = rb->out;
+		list_foreach(rb->marks, link, receive_buffer_mark_t, mark) {
+			min_mark = min(min_mark, mark->offset);
+		}
+
+		if (min_mark == 0)
+			return ELIMIT;
+
+		size_t new_in = rb->in - min_mark;
+		memmove(rb->buffer, rb->buffer + min_mark, new_in);
+		rb->in = new_in;
+		rb->out -= min_mark;
+		free = rb->size - rb->in;
+		list_foreach(rb->marks, link, receive_buffer_mark_t, mark) {
+			mark->offset -= min_mark;
+		}
+	}
+
+	size_t nrecv;
+	errno_t rc = rb->receive(rb->client_data, rb->buffer + rb->in, free,
+	    &nrecv);
+	if (rc != EOK)
+		return rc;
+
+	if (nrecv == 0)
+		return ENOENT;
+
+	rb->in += nrecv;
+	return EOK;
+}
+
 /** Receive one character (with buffering) */
 errno_t recv_char(receive_buffer_t *rb, char *c, bool consume)
 {
 	if (rb->out == rb->in) {
-		size_t free = rb->size - rb->in;
-		if (free == 0) {
-			size_t min_mark = rb->size;
-			list_foreach(rb->marks, link, receive_buffer_mark_t, mark) {
-				min_mark = min(min_mark, mark->offset);
-			}
-
-			if (min_mark == 0)
-				return ELIMIT;
-
-			size_t new_in = rb->in - min_mark;
-			memmove(rb->buffer, rb->buffer + min_mark, new_in);
-			rb->out = rb->in = new_in;
-			free = rb->size - rb->in;
-			list_foreach(rb->marks, link, receive_buffer_mark_t, mark) {
-				mark->offset -= min_mark;
-			}
-		}
-
-		size_t nrecv;
-		errno_t rc = rb->receive(rb->client_data, rb->buffer + rb->in, free, &nrecv);
+		errno_t rc = recv_fill(rb);
 		if (rc != EOK)
 			return rc;
-
-		rb->in = nrecv;
 	}
 
 	*c = rb->buffer[rb->out];
@@ -34,6 +34,7 @@
  */
 
 #include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
@@ -135,6 +136,27 @@ errno_t http_request_format(http_request_t *req, char **out_buf,
 	return EOK;
 }
 
+/** Ask for a byte range of the representation only
+ *
+ * @param req   Request
+ * @param first Offset of the first byte
+ * @param last  Offset of the last byte
+ *
+ * @return EOK on success or an error code
+ */
+errno_t http_request_set_range(http_request_t *req, uint64_t first,
+    uint64_t last)
+{
+	char *value;
+
+	if (asprintf(&value, "bytes=%" PRIu64 "-%" PRIu64, first, last) < 0)
+		return ENOMEM;
+
+	errno_t rc = http_headers_set(&req->headers, "Range", value);
+	free(value);
+	return rc;
+}
+
 errno_t http_send_request(http_t *http, http_request_t *req)
 {
 	char *buf = NULL;
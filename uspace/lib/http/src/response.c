@@ -195,23 +195,56 @@ errno_t http_receive_response(receive_buffer_t *rb, http_response_t **out_respon
 	memset(resp, 0, sizeof(http_response_t));
 	http_headers_init(&resp->headers);
 
-	errno_t rc = http_receive_status(rb, &resp->version, &resp->status,
-	    &resp->message);
+	http_parser_t parser;
+	errno_t rc = http_parser_receive(&parser, rb, max_headers_size);
+	if (rc == ENOENT)
+		rc = HTTP_EPARSE;
 	if (rc != EOK)
 		goto error;
 
-	rc = http_headers_receive(rb, &resp->headers, max_headers_size,
-	    max_headers_count);
+	http_slice_t reason;
+	rc = http_parser_status_line(&parser, &resp->version, &resp->status,
+	    &reason);
 	if (rc != EOK)
 		goto error;
 
-	size_t nrecv;
-	rc = recv_eol(rb, &nrecv);
-	if (rc == EOK && nrecv == 0)
-		rc = HTTP_EPARSE;
-	if (rc != EOK)
+	resp->message = http_slice_dup(&reason);
+	if (resp->message == NULL) {
+		rc = ENOMEM;
 		goto error;
+	}
 
+	http_field_t field;
+	unsigned count = 0;
+	while ((rc = http_parser_field(&parser, &field)) == EOK) {
+		if (max_headers_count > 0 && count >= max_headers_count) {
+			rc = ELIMIT;
+			goto error;
+		}
+
+		http_header_t *header = malloc(sizeof(http_header_t));
+		if (header == NULL) {
+			rc = ENOMEM;
+			goto error;
+		}
+		http_header_init(header);
+
+		header->name = http_slice_dup(&field.name);
+		header->value = http_slice_dup(&field.value);
+		if (header->name == NULL || header->value == NULL) {
+			http_header_destroy(header);
+			rc = ENOMEM;
+			goto error;
+		}
+
+		http_headers_append_header(&resp->headers, header);
+		count++;
+	}
+
+	if (rc != ENOENT)
+		goto error;
+
+	http_parser_end(&parser);
 	*out_response = resp;
 
 	return EOK;
@@ -220,6 +253,103 @@ error:
 	return rc;
 }
 
+/** Decide whether the connection stays open after a response
+ *
+ * The connection can be used for another request once the body of the
+ * response was read completely, unless the server asks for it to be
+ * closed or the body is delimited by closing the connection.
+ *
+ * @param resp Response
+ * @return @c true if the connection can be reused
+ */
+bool http_response_persistent(http_response_t *resp)
+{
+	http_slice_t value;
+	char *str;
+
+	if (http_headers_get(&resp->headers, "Connection", &str) == EOK) {
+		value.data = str;
+		value.size = str_size(str);
+		if (http_slice_has_token(&value, "close"))
+			return false;
+		if (resp->version.major == 1 && resp->version.minor == 0 &&
+		    !http_slice_has_token(&value, "keep-alive"))
+			return false;
+	} else if (resp->version.major == 1 && resp->version.minor == 0) {
+		return false;
+	}
+
+	if (resp->status == 204 || resp->status == 304)
+		return true;
+
+	if (http_headers_get(&resp->headers, "Transfer-Encoding", &str) ==
+	    EOK)
+		return true;
+
+	return http_headers_get(&resp->headers, "Content-Length", &str) ==
+	    EOK;
+}
+
+/** Parse the Content-Range header field of a partial response
+ *
+ * @param resp   Response
+ * @param first  Place to store offset of the first byte of the range
+ * @param last   Place to store offset of the last byte of the range
+ * @param length Place to store length of the whole representation or
+ *               @c UINT64_MAX if the server does not know it
+ *
+ * @return EOK on success, HTTP_EMISSING_HEADER if there is no such
+ *         field, HTTP_EPARSE if it is not a satisfied byte range
+ */
+errno_t http_response_content_range(http_response_t *resp, uint64_t *first,
+    uint64_t *last, uint64_t *length)
+{
+	http_slice_t value;
+	http_slice_t part;
+	char *str;
+	char *end;
+	char *cp;
+
+	errno_t rc = http_headers_get(&resp->headers, "Content-Range", &str);
+	if (rc != EOK)
+		return rc;
+
+	/* bytes <first>-<last>/<length> */
+	value.data = str;
+	value.size = str_size(str);
+	end = value.data + value.size;
+	if (value.size < 6 || str_lcasecmp(str, "bytes ", 6) != 0)
+		return HTTP_EPARSE;
+
+	part.data = value.data + 6;
+	cp = memchr(part.data, '-', end - part.data);
+	if (cp == NULL)
+		return HTTP_EPARSE;
+	part.size = cp - part.data;
+	if (http_slice_uint64(&part, 10, first) != EOK)
+		return HTTP_EPARSE;
+
+	part.data = cp + 1;
+	cp = memchr(part.data, '/', end - part.data);
+	if (cp == NULL)
+		return HTTP_EPARSE;
+	part.size = cp - part.data;
+	if (http_slice_uint64(&part, 10, last) != EOK || *last < *first)
+		return HTTP_EPARSE;
+
+	part.data = cp + 1;
+	part.size = end - part.data;
+	if (http_slice_equal(&part, "*")) {
+		*length = UINT64_MAX;
+		return EOK;
+	}
+
+	if (http_slice_uint64(&part, 10, length) != EOK || *last >= *length)
+		return HTTP_EPARSE;
+
+	return EOK;
+}
+
 void http_response_destroy(http_response_t *resp)
 {
 	free(resp->message);
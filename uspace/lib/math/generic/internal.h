@@ -30,9 +30,315 @@
 #ifndef MATH_INTERNAL_H_
 #define MATH_INTERNAL_H_
 
-float __math_base_sin_32(float);
-float __math_base_cos_32(float);
-double __math_base_sin_64(double);
-double __math_base_cos_64(double);
+#include <stdint.h>
+
+/*
+ * Sine and cosine are computed by reducing the argument to
+ * [-pi/4, pi/4] and a quadrant by the Cody-Waite method and evaluating
+ * minimax polynomials on the reduced argument. The kernels are inline so
+ * that the array functions can be vectorized by the compiler.
+ */
+
+/** Bound of arguments reduced by __math_reduce_64() */
+#define __MATH_REDUCE_MAX_64  0x1p20
+
+/** Bit pattern of __MATH_REDUCE_MAX_64 */
+#define __MATH_REDUCE_MAX_BITS_64  UINT64_C(0x4130000000000000)
+
+/** Bound of arguments reduced by __math_reduce_32() */
+#define __MATH_REDUCE_MAX_32  0x1p13f
+
+/** Bit pattern of __MATH_REDUCE_MAX_32 */
+#define __MATH_REDUCE_MAX_BITS_32  UINT32_C(0x46000000)
+
+/* Adding and subtracting these rounds to an integer in the current mode */
+#define __MATH_TOINT_64  0x1.8p52
+#define __MATH_TOINT_32  0x1.8p23f
+
+/* pi/2 split into parts with trailing zero bits (64-bit) */
+#define __MATH_PIO2_1_64  1.57079632673412561417e+00
+#define __MATH_PIO2_2_64  6.07710050630396597660e-11
+#define __MATH_PIO2_3_64  2.02226624871116645580e-21
+#define __MATH_PIO2_3T_64  8.47842766036889956997e-32
+
+/* pi/2 split into parts with trailing zero bits (32-bit) */
+#define __MATH_PIO2_1_32  1.5703125f
+#define __MATH_PIO2_2_32  4.837512969970703125e-4f
+#define __MATH_PIO2_3_32  7.54978995489188216e-8f
+
+extern double __math_reduce_large_64(double, unsigned int *);
+extern float __math_reduce_large_32(float, unsigned int *);
+
+/** Reduce argument of sine or cosine (64-bit floating point)
+ *
+ * @param arg      Argument within (-__MATH_REDUCE_MAX_64,
+ *                 __MATH_REDUCE_MAX_64).
+ * @param quadrant Place to store the quadrant of the argument.
+ *
+ * @return Argument reduced to [-pi/4, pi/4].
+ *
+ */
+static inline double __math_reduce_64(double arg, unsigned int *quadrant)
+{
+	double fn = (arg * M_2_PI + __MATH_TOINT_64) - __MATH_TOINT_64;
+
+	*quadrant = (int) fn;
+	return (((arg - fn * __MATH_PIO2_1_64) - fn * __MATH_PIO2_2_64) -
+	    fn * __MATH_PIO2_3_64) - fn * __MATH_PIO2_3T_64;
+}
+
+/** Reduce argument of sine or cosine (32-bit floating point)
+ *
+ * @param arg      Argument within (-__MATH_REDUCE_MAX_32,
+ *                 __MATH_REDUCE_MAX_32).
+ * @param quadrant Place to store the quadrant of the argument.
+ *
+ * @return Argument reduced to [-pi/4, pi/4].
+ *
+ */
+static inline float __math_reduce_32(float arg, unsigned int *quadrant)
+{
+	float fn = (arg * (float) M_2_PI + __MATH_TOINT_32) - __MATH_TOINT_32;
+
+	*quadrant = (int) fn;
+	return ((arg - fn * __MATH_PIO2_1_32) - fn * __MATH_PIO2_2_32) -
+	    fn * __MATH_PIO2_3_32;
+}
+
+/** Sine on [-pi/4, pi/4] (64-bit floating point)
+ *
+ * Minimax polynomial from fdlibm, error below 1 ulp.
+ *
+ */
+static inline double __math_kernel_sin_64(double arg)
+{
+	double z = arg * arg;
+	double r = 8.33333333332248946124e-03 + z *
+	    (-1.98412698298579493134e-04 + z *
+	    (2.75573137070700676789e-06 + z *
+	    (-2.50507602534068634195e-08 + z *
+	    1.58969099521155010221e-10)));
+
+	return arg + arg * z * (-1.66666666666666324348e-01 + z * r);
+}
+
+/** Cosine on [-pi/4, pi/4] (64-bit floating point)
+ *
+ * Minimax polynomial from fdlibm, error below 1 ulp.
+ *
+ */
+static inline double __math_kernel_cos_64(double arg)
+{
+	double z = arg * arg;
+	double r = z * (4.16666666666666019037e-02 + z *
+	    (-1.38888888888741095749e-03 + z *
+	    (2.48015872894767294178e-05 + z *
+	    (-2.75573143513906633035e-07 + z *
+	    (2.08757232129817482790e-09 + z *
+	    -1.13596475577881948265e-11)))));
+	double hz = 0.5 * z;
+	double w = 1.0 - hz;
+
+	return w + (((1.0 - w) - hz) + z * r);
+}
+
+/** Sine on [-pi/4, pi/4] (32-bit floating point)
+ *
+ * Minimax polynomial from Cephes, error below 1 ulp.
+ *
+ */
+static inline float __math_kernel_sin_32(float arg)
+{
+	float z = arg * arg;
+
+	return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z -
+	    1.6666654611e-1f) * z * arg + arg;
+}
+
+/** Cosine on [-pi/4, pi/4] (32-bit floating point)
+ *
+ * Minimax polynomial from Cephes, error below 1 ulp.
+ *
+ */
+static inline float __math_kernel_cos_32(float arg)
+{
+	float z = arg * arg;
+
+	return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z +
+	    4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+}
+
+/** Sine of a reduced argument (64-bit floating point)
+ *
+ * @param arg      Reduced argument.
+ * @param quadrant Quadrant of the original argument.
+ *
+ */
+static inline double __math_quadrant_sin_64(double arg, unsigned int quadrant)
+{
+	double v = (quadrant & 1) ? __math_kernel_cos_64(arg) :
+	    __math_kernel_sin_64(arg);
+
+	return (quadrant & 2) ? -v : v;
+}
+
+/** Cosine of a reduced argument (64-bit floating point)
+ *
+ * @param arg      Reduced argument.
+ * @param quadrant Quadrant of the original argument.
+ *
+ */
+static inline double __math_quadrant_cos_64(double arg, unsigned int quadrant)
+{
+	return __math_quadrant_sin_64(arg, quadrant + 1);
+}
+
+/** Sine of a reduced argument (32-bit floating point)
+ *
+ * @param arg      Reduced argument.
+ * @param quadrant Quadrant of the original argument.
+ *
+ */
+static inline float __math_quadrant_sin_32(float arg, unsigned int quadrant)
+{
+	float v = (quadrant & 1) ? __math_kernel_cos_32(arg) :
+	    __math_kernel_sin_32(arg);
+
+	return (quadrant & 2) ? -v : v;
+}
+
+/** Cosine of a reduced argument (32-bit floating point)
+ *
+ * @param arg      Reduced argument.
+ * @param quadrant Quadrant of the original argument.
+ *
+ */
+static inline float __math_quadrant_cos_32(float arg, unsigned int quadrant)
+{
+	return __math_quadrant_sin_32(arg, quadrant + 1);
+}
+
+/** Sine and cosine from kernel values (64-bit floating point)
+ *
+ * @param sv       Sine of the reduced argument.
+ * @param cv       Cosine of the reduced argument.
+ * @param quadrant Quadrant of the original argument.
+ * @param s        Place to store the sine.
+ * @param c        Place to store the cosine.
+ *
+ */
+static inline void __math_quadrant_sincos_64(double sv, double cv,
+    unsigned int quadrant, double *s, double *c)
+{
+	double ps = (quadrant & 1) ? cv : sv;
+	double pc = (quadrant & 1) ? sv : cv;
+
+	*s = (quadrant & 2) ? -ps : ps;
+	*c = ((quadrant + 1) & 2) ? -pc : pc;
+}
+
+/** Sine and cosine from kernel values (32-bit floating point)
+ *
+ * @param sv       Sine of the reduced argument.
+ * @param cv       Cosine of the reduced argument.
+ * @param quadrant Quadrant of the original argument.
+ * @param s        Place to store the sine.
+ * @param c        Place to store the cosine.
+ *
+ */
+static inline void __math_quadrant_sincos_32(float sv, float cv,
+    unsigned int quadrant, float *s, float *c)
+{
+	float ps = (quadrant & 1) ? cv : sv;
+	float pc = (quadrant & 1) ? sv : cv;
+
+	*s = (quadrant & 2) ? -ps : ps;
+	*c = ((quadrant + 1) & 2) ? -pc : pc;
+}
+
+/** Reduce an argument of any size (64-bit floating point) */
+static inline double __math_reduce_any_64(double arg, unsigned int *quadrant)
+{
+	if ((arg > -__MATH_REDUCE_MAX_64) && (arg < __MATH_REDUCE_MAX_64))
+		return __math_reduce_64(arg, quadrant);
+
+	return __math_reduce_large_64(arg, quadrant);
+}
+
+/** Reduce an argument of any size (32-bit floating point) */
+static inline float __math_reduce_any_32(float arg, unsigned int *quadrant)
+{
+	if ((arg > -__MATH_REDUCE_MAX_32) && (arg < __MATH_REDUCE_MAX_32))
+		return __math_reduce_32(arg, quadrant);
+
+	return __math_reduce_large_32(arg, quadrant);
+}
+
+/** Replace an argument out of the range of __math_reduce_64() by zero
+ *
+ * Integer operations only, so that the loops of the array functions do not
+ * contain floating point comparisons which would prevent vectorization.
+ *
+ */
+static inline double __math_array_arg_64(double arg)
+{
+	union {
+		double d;
+		uint64_t i;
+	} u = { .d = arg };
+
+	u.i &= -(uint64_t) ((u.i & INT64_MAX) < __MATH_REDUCE_MAX_BITS_64);
+	return u.d;
+}
+
+/** Replace an argument out of the range of __math_reduce_32() by zero
+ *
+ * Integer operations only, see __math_array_arg_64().
+ *
+ */
+static inline float __math_array_arg_32(float arg)
+{
+	union {
+		float f;
+		uint32_t i;
+	} u = { .f = arg };
+
+	u.i &= -(uint32_t) ((u.i & INT32_MAX) < __MATH_REDUCE_MAX_BITS_32);
+	return u.f;
+}
+
+/** Sine and cosine of a reduced argument without branches (64-bit)
+ *
+ * The quadrant is applied by arithmetic instead of selection so that
+ * the compiler can vectorize the array functions. The sign of zero
+ * results is not preserved.
+ *
+ */
+static inline void __math_array_sincos_64(double arg, unsigned int quadrant,
+    double *s, double *c)
+{
+	double sv = __math_kernel_sin_64(arg);
+	double cv = __math_kernel_cos_64(arg);
+	double b = quadrant & 1;
+
+	*s = (sv * (1.0 - b) + cv * b) * (1.0 - (quadrant & 2));
+	*c = (cv * (1.0 - b) + sv * b) * (1.0 - ((quadrant + 1) & 2));
+}
+
+/** Sine and cosine of a reduced argument without branches (32-bit)
+ *
+ * See __math_array_sincos_64().
+ *
+ */
+static inline void __math_array_sincos_32(float arg, unsigned int quadrant,
+    float *s, float *c)
+{
+	float sv = __math_kernel_sin_32(arg);
+	float cv = __math_kernel_cos_32(arg);
+	float b = quadrant & 1;
+
+	*s = (sv * (1.0f - b) + cv * b) * (1.0f - (quadrant & 2));
+	*c = (cv * (1.0f - b) + sv * b) * (1.0f - ((quadrant + 1) & 2));
+}
 
 #endif
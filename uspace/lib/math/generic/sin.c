@@ -47,12 +47,10 @@
  */
 float sinf(float arg)
 {
-	float base_arg = fmodf(arg, 2 * M_PI);
+	unsigned int quadrant;
+	float red_arg = __math_reduce_any_32(arg, &quadrant);
 
-	if (base_arg < 0)
-		return -__math_base_sin_32(-base_arg);
-
-	return __math_base_sin_32(base_arg);
+	return __math_quadrant_sin_32(red_arg, quadrant);
 }
 
 /** Sine (64-bit floating point)
@@ -66,12 +64,10 @@ float sinf(float arg)
  */
 double sin(double arg)
 {
-	double base_arg = fmod(arg, 2 * M_PI);
-
-	if (base_arg < 0)
-		return -__math_base_sin_64(-base_arg);
+	unsigned int quadrant;
+	double red_arg = __math_reduce_any_64(arg, &quadrant);
 
-	return __math_base_sin_64(base_arg);
+	return __math_quadrant_sin_64(red_arg, quadrant);
 }
 
 /** @}
@@ -46,15 +46,12 @@
  */
 void sincosf(float x, float *s, float *c)
 {
-	float base_arg = fmodf(x, 2 * M_PI);
+	unsigned int quadrant;
+	float red_x = __math_reduce_any_32(x, &quadrant);
+	float sv = __math_kernel_sin_32(red_x);
+	float cv = __math_kernel_cos_32(red_x);
 
-	if (base_arg < 0) {
-		*s = -__math_base_sin_32(-base_arg);
-		*c = __math_base_cos_32(-base_arg);
-	} else {
-		*s = __math_base_sin_32(base_arg);
-		*c = __math_base_cos_32(base_arg);
-	}
+	__math_quadrant_sincos_32(sv, cv, quadrant, s, c);
 }
 
 /**
@@ -67,15 +64,12 @@ void sincosf(float x, float *s, float *c)
  */
 void sincos(double x, double *s, double *c)
 {
-	double base_arg = fmod(x, 2 * M_PI);
+	unsigned int quadrant;
+	double red_x = __math_reduce_any_64(x, &quadrant);
+	double sv = __math_kernel_sin_64(red_x);
+	double cv = __math_kernel_cos_64(red_x);
 
-	if (base_arg < 0) {
-		*s = -__math_base_sin_64(-base_arg);
-		*c = __math_base_cos_64(-base_arg);
-	} else {
-		*s = __math_base_sin_64(base_arg);
-		*c = __math_base_cos_64(base_arg);
-	}
+	__math_quadrant_sincos_64(sv, cv, quadrant, s, c);
 }
 
 /** @}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libmath
+ * @{
+ */
+/** @file Sine and cosine of arrays.
+ *
+ * The arrays are processed in two passes. The first pass handles arguments
+ * reducible by the Cody-Waite method without branches, so that the compiler
+ * can vectorize it for the SIMD unit of the target. The second pass
+ * recomputes the results of the few arguments out of that range, including
+ * infinities and NaNs, one by one.
+ */
+
+#include <math.h>
+#include "internal.h"
+
+/** Sine of an array (64-bit floating point)
+ *
+ * @param x Arguments.
+ * @param y Array to store the sine values. Must not overlap @a x.
+ * @param n Number of elements.
+ *
+ */
+void sin_array(const double *restrict x, double *restrict y, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		double a = __math_array_arg_64(x[i]);
+		unsigned int quadrant;
+		double r = __math_reduce_64(a, &quadrant);
+		double s, c;
+
+		__math_array_sincos_64(r, quadrant, &s, &c);
+		y[i] = s;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		if (!((x[i] > -__MATH_REDUCE_MAX_64) &&
+		    (x[i] < __MATH_REDUCE_MAX_64)))
+			y[i] = sin(x[i]);
+	}
+}
+
+/** Cosine of an array (64-bit floating point)
+ *
+ * @param x Arguments.
+ * @param y Array to store the cosine values. Must not overlap @a x.
+ * @param n Number of elements.
+ *
+ */
+void cos_array(const double *restrict x, double *restrict y, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		double a = __math_array_arg_64(x[i]);
+		unsigned int quadrant;
+		double r = __math_reduce_64(a, &quadrant);
+		double s, c;
+
+		__math_array_sincos_64(r, quadrant, &s, &c);
+		y[i] = c;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		if (!((x[i] > -__MATH_REDUCE_MAX_64) &&
+		    (x[i] < __MATH_REDUCE_MAX_64)))
+			y[i] = cos(x[i]);
+	}
+}
+
+/** Sine and cosine of an array (64-bit floating point)
+ *
+ * @param x Arguments.
+ * @param s Array to store the sine values. Must not overlap @a x or @a c.
+ * @param c Array to store the cosine values. Must not overlap @a x or
+ *          @a s.
+ * @param n Number of elements.
+ *
+ */
+void sincos_array(const double *restrict x, double *restrict s,
+    double *restrict c, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		double a = __math_array_arg_64(x[i]);
+		unsigned int quadrant;
+		double r = __math_reduce_64(a, &quadrant);
+
+		__math_array_sincos_64(r, quadrant, &s[i], &c[i]);
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		if (!((x[i] > -__MATH_REDUCE_MAX_64) &&
+		    (x[i] < __MATH_REDUCE_MAX_64)))
+			sincos(x[i], &s[i], &c[i]);
+	}
+}
+
+/** Sine of an array (32-bit floating point)
+ *
+ * @param x Arguments.
+ * @param y Array to store the sine values. Must not overlap @a x.
+ * @param n Number of elements.
+ *
+ */
+void sinf_array(const float *restrict x, float *restrict y, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		float a = __math_array_arg_32(x[i]);
+		unsigned int quadrant;
+		float r = __math_reduce_32(a, &quadrant);
+		float s, c;
+
+		__math_array_sincos_32(r, quadrant, &s, &c);
+		y[i] = s;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		if (!((x[i] > -__MATH_REDUCE_MAX_32) &&
+		    (x[i] < __MATH_REDUCE_MAX_32)))
+			y[i] = sinf(x[i]);
+	}
+}
+
+/** Cosine of an array (32-bit floating point)
+ *
+ * @param x Arguments.
+ * @param y Array to store the cosine values. Must not overlap @a x.
+ * @param n Number of elements.
+ *
+ */
+void cosf_array(const float *restrict x, float *restrict y, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		float a = __math_array_arg_32(x[i]);
+		unsigned int quadrant;
+		float r = __math_reduce_32(a, &quadrant);
+		float s, c;
+
+		__math_array_sincos_32(r, quadrant, &s, &c);
+		y[i] = c;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		if (!((x[i] > -__MATH_REDUCE_MAX_32) &&
+		    (x[i] < __MATH_REDUCE_MAX_32)))
+			y[i] = cosf(x[i]);
+	}
+}
+
+/** Sine and cosine of an array (32-bit floating point)
+ *
+ * @param x Arguments.
+ * @param s Array to store the sine values. Must not overlap @a x or @a c.
+ * @param c Array to store the cosine values. Must not overlap @a x or
+ *          @a s.
+ * @param n Number of elements.
+ *
+ */
+void sincosf_array(const float *restrict x, float *restrict s,
+    float *restrict c, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		float a = __math_array_arg_32(x[i]);
+		unsigned int quadrant;
+		float r = __math_reduce_32(a, &quadrant);
+
+		__math_array_sincos_32(r, quadrant, &s[i], &c[i]);
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		if (!((x[i] > -__MATH_REDUCE_MAX_32) &&
+		    (x[i] < __MATH_REDUCE_MAX_32)))
+			sincosf(x[i], &s[i], &c[i]);
+	}
+}
+
+/** @}
+ */
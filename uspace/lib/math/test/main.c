@@ -32,5 +32,6 @@
 PCUT_INIT;
 
 PCUT_IMPORT(rounding);
+PCUT_IMPORT(trig);
 
 PCUT_MAIN();
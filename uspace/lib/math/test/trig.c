@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcut/pcut.h>
+#include <math.h>
+#include <float.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(trig);
+
+/** Argument, sine and cosine, rounded to nearest */
+typedef struct {
+	double arg;
+	double sin;
+	double cos;
+} trig_case_t;
+
+static trig_case_t trig_cases[] = {
+	{ 0x0p+0, 0x0p+0, 0x1p+0 },
+	{ 0x1.5798ee2308c3ap-27, 0x1.5798ee2308c3ap-27, 0x1p+0 },
+	{ 0x1p-1, 0x1.eaee8744b05fp-2, 0x1.c1528065b7d5p-1 },
+	{ -0x1p-1, -0x1.eaee8744b05fp-2, 0x1.c1528065b7d5p-1 },
+	{ 0x1.921fb54442d18p-1, 0x1.6a09e667f3bccp-1, 0x1.6a09e667f3bcdp-1 },
+	{ 0x1p+0, 0x1.aed548f090ceep-1, 0x1.14a280fb5068cp-1 },
+	{ -0x1p+0, -0x1.aed548f090ceep-1, 0x1.14a280fb5068cp-1 },
+	{ 0x1.921fb54442d18p+0, 0x1p+0, 0x1.1a62633145c07p-54 },
+	{ 0x1p+1, 0x1.d18f6ead1b446p-1, -0x1.aa22657537205p-2 },
+	{ 0x1.921fb54442d18p+1, 0x1.1a62633145c07p-53, -0x1p+0 },
+	{ -0x1.921fb54442d18p+1, -0x1.1a62633145c07p-53, -0x1p+0 },
+	{ 0x1p+2, -0x1.837b9dddc1eaep-1, -0x1.4eaa606db24c1p-1 },
+	{ 0x1.921fb54442d18p+2, -0x1.1a62633145c07p-52, 0x1p+0 },
+	{ 0x1.4p+3, -0x1.1689ef5f34f52p-1, -0x1.ad9ac890c6b1fp-1 },
+	{ -0x1.9p+6, 0x1.03425b78c4db8p-1, 0x1.b981dbf665fdfp-1 },
+	{ 0x1.f4p+9, 0x1.a75cc150a206bp-1, 0x1.1ff026793f1bbp-1 },
+	{ 0x1.81cd6c8b43958p+13, -0x1.687d5890974a5p-1, 0x1.6b94c3bbe24b8p-1 },
+	{ -0x1.81cd6e9e1b08ap+16, -0x1.5a0fd0d209b99p-5, 0x1.ff8afef125a18p-1 },
+	{ 0x1.e848p+19, -0x1.6664b2568d867p-2, 0x1.df9df9906d32cp-1 }
+};
+
+#define TRIG_CASES (sizeof(trig_cases) / sizeof(trig_cases[0]))
+
+/** Check that a value is within two ulps of the expected value */
+static bool close_64(double expected, double actual)
+{
+	return fabs(expected - actual) <= 2 * DBL_EPSILON * fabs(expected);
+}
+
+/** Sine is accurate to two ulps */
+PCUT_TEST(sin_accuracy)
+{
+	for (size_t i = 0; i < TRIG_CASES; i++) {
+		PCUT_ASSERT_TRUE(close_64(trig_cases[i].sin,
+		    sin(trig_cases[i].arg)));
+	}
+}
+
+/** Cosine is accurate to two ulps */
+PCUT_TEST(cos_accuracy)
+{
+	for (size_t i = 0; i < TRIG_CASES; i++) {
+		PCUT_ASSERT_TRUE(close_64(trig_cases[i].cos,
+		    cos(trig_cases[i].arg)));
+	}
+}
+
+/** sincos() gives the same results as sin() and cos() */
+PCUT_TEST(sincos_consistent)
+{
+	for (size_t i = 0; i < TRIG_CASES; i++) {
+		double s, c;
+
+		sincos(trig_cases[i].arg, &s, &c);
+		PCUT_ASSERT_TRUE(s == sin(trig_cases[i].arg));
+		PCUT_ASSERT_TRUE(c == cos(trig_cases[i].arg));
+	}
+}
+
+/** The 32-bit functions agree with the 64-bit ones */
+PCUT_TEST(sinf_cosf_accuracy)
+{
+	for (int k = -2000; k <= 2000; k++) {
+		float x = k * 0.01f;
+		float s, c;
+
+		PCUT_ASSERT_DOUBLE_EQUALS(sin(x), sinf(x), 2 * FLT_EPSILON);
+		PCUT_ASSERT_DOUBLE_EQUALS(cos(x), cosf(x), 2 * FLT_EPSILON);
+
+		sincosf(x, &s, &c);
+		PCUT_ASSERT_TRUE(s == sinf(x));
+		PCUT_ASSERT_TRUE(c == cosf(x));
+	}
+}
+
+/** Infinities and NaNs give NaN */
+PCUT_TEST(special_args)
+{
+	PCUT_ASSERT_TRUE(isnan(sin(HUGE_VAL)));
+	PCUT_ASSERT_TRUE(isnan(cos(-HUGE_VAL)));
+	PCUT_ASSERT_TRUE(isnan(sin(NAN)));
+	PCUT_ASSERT_TRUE(isnan(sinf(HUGE_VALF)));
+	PCUT_ASSERT_TRUE(isnan(cosf(NAN)));
+}
+
+/** Array functions give the same results as the scalar ones */
+PCUT_TEST(array_consistent)
+{
+	double x[TRIG_CASES + 3];
+	double y[TRIG_CASES + 3];
+	double s[TRIG_CASES + 3];
+	double c[TRIG_CASES + 3];
+	float xf[TRIG_CASES + 3];
+	float yf[TRIG_CASES + 3];
+	size_t n = TRIG_CASES + 3;
+
+	for (size_t i = 0; i < TRIG_CASES; i++)
+		x[i] = trig_cases[i].arg;
+
+	/* Arguments out of the range of the vectorized pass */
+	x[TRIG_CASES] = 1.0e9;
+	x[TRIG_CASES + 1] = -HUGE_VAL;
+	x[TRIG_CASES + 2] = NAN;
+
+	for (size_t i = 0; i < n; i++)
+		xf[i] = x[i];
+
+	sin_array(x, y, n);
+	sincos_array(x, s, c, n);
+
+	for (size_t i = 0; i < n; i++) {
+		if (isnan(sin(x[i]))) {
+			PCUT_ASSERT_TRUE(isnan(y[i]));
+			PCUT_ASSERT_TRUE(isnan(s[i]));
+			PCUT_ASSERT_TRUE(isnan(c[i]));
+			continue;
+		}
+
+		PCUT_ASSERT_TRUE(y[i] == sin(x[i]));
+		PCUT_ASSERT_TRUE(s[i] == sin(x[i]));
+		PCUT_ASSERT_TRUE(c[i] == cos(x[i]));
+	}
+
+	cos_array(x, y, n);
+
+	for (size_t i = 0; i < n; i++) {
+		if (!isnan(cos(x[i])))
+			PCUT_ASSERT_TRUE(y[i] == cos(x[i]));
+	}
+
+	sinf_array(xf, yf, n);
+
+	for (size_t i = 0; i < n; i++) {
+		if (!isnan(sinf(xf[i])))
+			PCUT_ASSERT_TRUE(yf[i] == sinf(xf[i]));
+	}
+}
+
+PCUT_EXPORT(trig);
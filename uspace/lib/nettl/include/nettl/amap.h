@@ -36,53 +36,37 @@
 #ifndef LIBNETTL_AMAP_H_
 #define LIBNETTL_AMAP_H_
 
-#include <adt/list.h>
+#include <adt/hash_table.h>
 #include <inet/endpoint.h>
-#include <nettl/portrng.h>
-#include <loc.h>
+#include <stdint.h>
 
-/** Port range for (remote endpoint, local address) */
+/** Association map entry */
 typedef struct {
-	/** Link to amap_t.repla */
-	link_t lamap;
-	/** Remote endpoint */
-	inet_ep_t rep;
-	/* Local address */
-	inet_addr_t laddr;
-	/** Port range */
-	portrng_t *portrng;
-} amap_repla_t;
+	/** Link to one of the amap_t hash tables */
+	ht_link_t lmap;
+	/** Endpoint pair, only the fields forming the table key are used */
+	inet_ep2_t epp;
+	/** User argument */
+	void *arg;
+} amap_entry_t;
 
-/** Port range for local address */
-typedef struct {
-	/** Link to amap_t.laddr */
-	link_t lamap;
-	/** Local address */
-	inet_addr_t laddr;
-	/** Port range */
-	portrng_t *portrng;
-} amap_laddr_t;
-
-/** Port range for local link */
-typedef struct {
-	/** Link to amap_t.llink */
-	link_t lamap;
-	/** Local link ID */
-	service_id_t llink;
-	/** Port range */
-	portrng_t *portrng;
-} amap_llink_t;
-
-/** Association map */
+/** Association map
+ *
+ * Each table is keyed on the attributes its entries specify, so that
+ * matching an incoming endpoint pair takes a constant number of hash
+ * lookups, from the most specific table to the least specific one.
+ */
 typedef struct {
-	/** Remote endpoint, local address */
-	list_t repla; /* of amap_repla_t */
-	/** Local addresses */
-	list_t laddr; /* of amap_laddr_t */
-	/** Local links */
-	list_t llink; /* of amap_llink_t */
-	/** Nothing specified (listen on all local addresses) */
-	portrng_t *unspec;
+	/** Remote endpoint, local address and port (connections) */
+	hash_table_t repla; /* of amap_entry_t */
+	/** Local address and port */
+	hash_table_t laddr; /* of amap_entry_t */
+	/** Local link and port */
+	hash_table_t llink; /* of amap_entry_t */
+	/** Local port only (listen on all local addresses) */
+	hash_table_t unspec; /* of amap_entry_t */
+	/** Next port number to try when allocating a dynamic port */
+	uint16_t port_next;
 } amap_t;
 
 typedef enum {
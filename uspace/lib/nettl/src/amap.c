@@ -25,7 +25,6 @@
  * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
-
 /** @addtogroup libnettl
  * @{
  */
@@ -47,9 +46,14 @@
  *
  * In the unspecified case only the local port is known and the entry matches
  * all remote and local addresses.
+ *
+ * Each type of entry is kept in its own hash table keyed on the attributes
+ * it specifies plus the local port, so demultiplexing an incoming packet
+ * costs at most four hash lookups regardless of the number of entries.
  */
 
-#include <adt/list.h>
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <errno.h>
 #include <inet/addr.h>
 #include <inet/inet.h>
@@ -58,469 +62,327 @@
 #include <stdint.h>
 #include <stdlib.h>
 
-/** Convert association map flags to port range flags.
+/** Compute hash of an internet address.
  *
- * @param flags Association map flags
- * @return Port range flags
+ * @param addr Address
+ * @return Hash value
  */
-static portrng_flags_t aflags_to_pflags(amap_flags_t flags)
+static size_t amap_addr_hash(const inet_addr_t *addr)
 {
-	portrng_flags_t pflags;
-
-	pflags = 0;
-	if ((flags & af_allow_system) != 0)
-		pflags |= pf_allow_system;
+	size_t hash;
+	size_t i;
+
+	hash = addr->version;
+
+	switch (addr->version) {
+	case ip_v4:
+		hash = hash_combine(hash, addr->addr);
+		break;
+	case ip_v6:
+		for (i = 0; i < 16; i += 4) {
+			hash = hash_combine(hash,
+			    ((uint32_t) addr->addr6[i] << 24) |
+			    ((uint32_t) addr->addr6[i + 1] << 16) |
+			    ((uint32_t) addr->addr6[i + 2] << 8) |
+			    addr->addr6[i + 3]);
+		}
+		break;
+	default:
+		break;
+	}
 
-	return pflags;
+	return hash;
 }
 
-/** Create association map.
- *
- * @param rmap Place to store pointer to new association map
- * @return EOk on success, ENOMEM if out of memory
- */
-errno_t amap_create(amap_t **rmap)
+static size_t amap_repla_key_hash(const void *key)
 {
-	amap_t *map;
-	errno_t rc;
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_create()");
-
-	map = calloc(1, sizeof(amap_t));
-	if (map == NULL)
-		return ENOMEM;
-
-	rc = portrng_create(&map->unspec);
-	if (rc != EOK) {
-		assert(rc == ENOMEM);
-		free(map);
-		return ENOMEM;
-	}
-
-	list_initialize(&map->repla);
-	list_initialize(&map->laddr);
-	list_initialize(&map->llink);
-
-	*rmap = map;
-	return EOK;
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
+	size_t hash;
+
+	hash = amap_addr_hash(&epp->remote.addr);
+	hash = hash_combine(hash, epp->remote.port);
+	hash = hash_combine(hash, amap_addr_hash(&epp->local.addr));
+	hash = hash_combine(hash, epp->local.port);
+	return hash_mix(hash);
 }
 
-/** Destroy association map.
- *
- * @param map Association map
- */
-void amap_destroy(amap_t *map)
+static size_t amap_repla_hash(const ht_link_t *item)
 {
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_destroy()");
-
-	assert(list_empty(&map->repla));
-	assert(list_empty(&map->laddr));
-	assert(list_empty(&map->llink));
-	free(map);
+	amap_entry_t *entry = hash_table_get_inst(item, amap_entry_t, lmap);
+	return amap_repla_key_hash(&entry->epp);
 }
 
-/** Find exact repla.
- *
- * Find repla (remote endpoint, local address) entry by exact match.
- *
- * @param map Association map
- * @param rep Remote endpoint
- * @param la  Local address
- * @param rrepla Place to store pointer to repla
- *
- * @return EOK on success, ENOENT if not found
- */
-static errno_t amap_repla_find(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
-    amap_repla_t **rrepla)
+static bool amap_repla_key_equal(const void *key, const ht_link_t *item)
 {
-	char *sraddr, *sladdr;
-
-	(void) inet_addr_format(&rep->addr, &sraddr);
-	(void) inet_addr_format(la, &sladdr);
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): rep=(%s,%" PRIu16
-	    ") la=%s", sraddr, rep->port, sladdr);
-	free(sraddr);
-	free(sladdr);
-
-	list_foreach(map->repla, lamap, amap_repla_t, repla) {
-		(void) inet_addr_format(&repla->rep.addr, &sraddr);
-		(void) inet_addr_format(&repla->laddr, &sladdr);
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): "
-		    "compare to rep=(%s, %" PRIu16 ") la=%s",
-		    sraddr, repla->rep.port, sladdr);
-		free(sraddr);
-		free(sladdr);
-		if (inet_addr_compare(&repla->rep.addr, &rep->addr) &&
-		    repla->rep.port == rep->port &&
-		    inet_addr_compare(&repla->laddr, la)) {
-			*rrepla = repla;
-			return EOK;
-		}
-	}
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
+	amap_entry_t *entry = hash_table_get_inst(item, amap_entry_t, lmap);
 
-	*rrepla = NULL;
-	return ENOENT;
+	return inet_addr_compare(&entry->epp.remote.addr, &epp->remote.addr) &&
+	    entry->epp.remote.port == epp->remote.port &&
+	    inet_addr_compare(&entry->epp.local.addr, &epp->local.addr) &&
+	    entry->epp.local.port == epp->local.port;
 }
 
-/** Insert repla.
- *
- * Insert new repla (remote endpoint, local address) entry to association map.
- *
- * @param amap   Association map
- * @param rep    Remote endpoint
- * @param la     Local address
- * @param rrepla Place to store pointer to new repla
- *
- * @return EOK on success, ENOMEM if out of memory
- */
-static errno_t amap_repla_insert(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
-    amap_repla_t **rrepla)
+static size_t amap_laddr_key_hash(const void *key)
 {
-	amap_repla_t *repla;
-	errno_t rc;
-
-	repla = calloc(1, sizeof(amap_repla_t));
-	if (repla == NULL) {
-		*rrepla = NULL;
-		return ENOMEM;
-	}
-
-	rc = portrng_create(&repla->portrng);
-	if (rc != EOK) {
-		free(repla);
-		return ENOMEM;
-	}
-
-	repla->rep = *rep;
-	repla->laddr = *la;
-	list_append(&repla->lamap, &map->repla);
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
 
-	*rrepla = repla;
-	return EOK;
+	return hash_mix(hash_combine(amap_addr_hash(&epp->local.addr),
+	    epp->local.port));
 }
 
-/** Remove repla from association map.
- *
- * Remove repla (remote endpoint, local address) from association map.
- *
- * @param map   Association map
- * @param repla Repla
- */
-static void amap_repla_remove(amap_t *map, amap_repla_t *repla)
+static size_t amap_laddr_hash(const ht_link_t *item)
 {
-	list_remove(&repla->lamap);
-	portrng_destroy(repla->portrng);
-	free(repla);
+	amap_entry_t *entry = hash_table_get_inst(item, amap_entry_t, lmap);
+	return amap_laddr_key_hash(&entry->epp);
 }
 
-/** Find exact laddr.
- *
- * Find laddr (local address) entry by exact match.
- *
- * @param map    Association map
- * @param addr   Address
- * @param rladdr Place to store pointer to laddr entry
- *
- * @return EOK on success, ENOENT if not found.
- */
-static errno_t amap_laddr_find(amap_t *map, inet_addr_t *addr,
-    amap_laddr_t **rladdr)
+static bool amap_laddr_key_equal(const void *key, const ht_link_t *item)
 {
-	list_foreach(map->laddr, lamap, amap_laddr_t, laddr) {
-		if (inet_addr_compare(&laddr->laddr, addr)) {
-			*rladdr = laddr;
-			return EOK;
-		}
-	}
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
+	amap_entry_t *entry = hash_table_get_inst(item, amap_entry_t, lmap);
 
-	*rladdr = NULL;
-	return ENOENT;
+	return inet_addr_compare(&entry->epp.local.addr, &epp->local.addr) &&
+	    entry->epp.local.port == epp->local.port;
 }
 
-/** Insert laddr.
- *
- * Insert new laddr (local address) entry to association map.
- *
- * @param addr   Local address
- * @param rladdr Place to store pointer to new laddr
- *
- * @return EOK on success, ENOMEM if out of memory
- */
-static errno_t amap_laddr_insert(amap_t *map, inet_addr_t *addr,
-    amap_laddr_t **rladdr)
+static size_t amap_llink_key_hash(const void *key)
 {
-	amap_laddr_t *laddr;
-	errno_t rc;
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
 
-	laddr = calloc(1, sizeof(amap_laddr_t));
-	if (laddr == NULL) {
-		*rladdr = NULL;
-		return ENOMEM;
-	}
-
-	rc = portrng_create(&laddr->portrng);
-	if (rc != EOK) {
-		free(laddr);
-		return ENOMEM;
-	}
-
-	laddr->laddr = *addr;
-	list_append(&laddr->lamap, &map->laddr);
-
-	*rladdr = laddr;
-	return EOK;
+	return hash_mix(hash_combine(epp->local_link, epp->local.port));
 }
 
-/** Remove laddr from association map.
- *
- * Remove laddr (local address) entry from association map.
- *
- * @param map   Association map
- * @param laddr Laddr entry
- */
-static void amap_laddr_remove(amap_t *map, amap_laddr_t *laddr)
+static size_t amap_llink_hash(const ht_link_t *item)
 {
-	list_remove(&laddr->lamap);
-	portrng_destroy(laddr->portrng);
-	free(laddr);
+	amap_entry_t *entry = hash_table_get_inst(item, amap_entry_t, lmap);
+	return amap_llink_key_hash(&entry->epp);
 }
 
-/** Find exact llink.
- *
- * Find llink (local link) entry by exact match.
- *
- * @param map     Association map
- * @param link_id Local link ID
- * @param rllink  Place to store pointer to llink entry
- *
- * @return EOK on success, ENOENT if not found.
- */
-static errno_t amap_llink_find(amap_t *map, sysarg_t link_id,
-    amap_llink_t **rllink)
+static bool amap_llink_key_equal(const void *key, const ht_link_t *item)
 {
-	list_foreach(map->llink, lamap, amap_llink_t, llink) {
-		if (llink->llink == link_id) {
-			*rllink = llink;
-			return EOK;
-		}
-	}
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
+	amap_entry_t *entry = hash_table_get_inst(item, amap_entry_t, lmap);
 
-	*rllink = NULL;
-	return ENOENT;
+	return entry->epp.local_link == epp->local_link &&
+	    entry->epp.local.port == epp->local.port;
 }
 
-/** Insert llink.
- *
- * Insert new llink (local link) entry to association map.
- *
- * @param link_id Local link
- * @param rllink  Place to store pointer to new llink
- *
- * @return EOK on success, ENOMEM if out of memory
- */
-static errno_t amap_llink_insert(amap_t *map, sysarg_t link_id,
-    amap_llink_t **rllink)
+static size_t amap_unspec_key_hash(const void *key)
 {
-	amap_llink_t *llink;
-	errno_t rc;
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
 
-	llink = calloc(1, sizeof(amap_llink_t));
-	if (llink == NULL) {
-		*rllink = NULL;
-		return ENOMEM;
-	}
+	return hash_mix(epp->local.port);
+}
 
-	rc = portrng_create(&llink->portrng);
-	if (rc != EOK) {
-		free(llink);
-		return ENOMEM;
-	}
+static size_t amap_unspec_hash(const ht_link_t *item)
+{
+	amap_entry_t *entry = hash_table_get_inst(item, amap_entry_t, lmap);
+	return amap_unspec_key_hash(&entry->epp);
+}
 
-	llink->llink = link_id;
-	list_append(&llink->lamap, &map->llink);
+static bool amap_unspec_key_equal(const void *key, const ht_link_t *item)
+{
+	const inet_ep2_t *epp = (const inet_ep2_t *) key;
+	amap_entry_t *entry = hash_table_get_inst(item, amap_entry_t, lmap);
 
-	*rllink = llink;
-	return EOK;
+	return entry->epp.local.port == epp->local.port;
 }
 
-/** Remove llink from association map.
- *
- * Remove llink (local link) entry from association map.
- *
- * @param map   Association map
- * @param llink Llink entry
- */
-static void amap_llink_remove(amap_t *map, amap_llink_t *llink)
+static void amap_entry_remove_callback(ht_link_t *item)
 {
-	list_remove(&llink->lamap);
-	portrng_destroy(llink->portrng);
-	free(llink);
+	free(hash_table_get_inst(item, amap_entry_t, lmap));
 }
 
-/** Insert endpoint pair into map with repla as key.
- *
- * If local port number is not specified, it is allocated.
- *
- * @param map Association map
- * @param epp Endpoint pair, possibly with local port inet_port_any
- * @param arg arg User value
- * @param flags Flags
- * @param aepp Place to store actual endpoint pair, possibly with allocated port
+static hash_table_ops_t amap_repla_ops = {
+	.hash = amap_repla_hash,
+	.key_hash = amap_repla_key_hash,
+	.key_equal = amap_repla_key_equal,
+	.equal = NULL,
+	.remove_callback = amap_entry_remove_callback
+};
+
+static hash_table_ops_t amap_laddr_ops = {
+	.hash = amap_laddr_hash,
+	.key_hash = amap_laddr_key_hash,
+	.key_equal = amap_laddr_key_equal,
+	.equal = NULL,
+	.remove_callback = amap_entry_remove_callback
+};
+
+static hash_table_ops_t amap_llink_ops = {
+	.hash = amap_llink_hash,
+	.key_hash = amap_llink_key_hash,
+	.key_equal = amap_llink_key_equal,
+	.equal = NULL,
+	.remove_callback = amap_entry_remove_callback
+};
+
+static hash_table_ops_t amap_unspec_ops = {
+	.hash = amap_unspec_hash,
+	.key_hash = amap_unspec_key_hash,
+	.key_equal = amap_unspec_key_equal,
+	.equal = NULL,
+	.remove_callback = amap_entry_remove_callback
+};
+
+/** Create association map.
  *
- * @return EOK on success, EEXIST if conflicting epp exists,
- *         ENOMEM if out of memory
+ * @param rmap Place to store pointer to new association map
+ * @return EOk on success, ENOMEM if out of memory
  */
-static errno_t amap_insert_repla(amap_t *map, inet_ep2_t *epp, void *arg,
-    amap_flags_t flags, inet_ep2_t *aepp)
+errno_t amap_create(amap_t **rmap)
 {
-	amap_repla_t *repla;
-	inet_ep2_t mepp;
-	errno_t rc;
+	amap_t *map;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_insert_repla()");
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_create()");
 
-	rc = amap_repla_find(map, &epp->remote, &epp->local.addr, &repla);
-	if (rc != EOK) {
-		/* New repla */
-		rc = amap_repla_insert(map, &epp->remote, &epp->local.addr,
-		    &repla);
-		if (rc != EOK) {
-			assert(rc == ENOMEM);
-			return rc;
-		}
-	}
+	map = calloc(1, sizeof(amap_t));
+	if (map == NULL)
+		return ENOMEM;
 
-	mepp = *epp;
+	if (!hash_table_create(&map->repla, 0, 0, &amap_repla_ops))
+		goto error;
+	if (!hash_table_create(&map->laddr, 0, 0, &amap_laddr_ops))
+		goto error;
+	if (!hash_table_create(&map->llink, 0, 0, &amap_llink_ops))
+		goto error;
+	if (!hash_table_create(&map->unspec, 0, 0, &amap_unspec_ops))
+		goto error;
 
-	rc = portrng_alloc(repla->portrng, epp->local.port, arg, aflags_to_pflags(flags),
-	    &mepp.local.port);
-	if (rc != EOK) {
-		return rc;
-	}
+	map->port_next = inet_port_dyn_lo;
 
-	*aepp = mepp;
+	*rmap = map;
 	return EOK;
+error:
+	if (map->repla.bucket != NULL)
+		hash_table_destroy(&map->repla);
+	if (map->laddr.bucket != NULL)
+		hash_table_destroy(&map->laddr);
+	if (map->llink.bucket != NULL)
+		hash_table_destroy(&map->llink);
+	free(map);
+	return ENOMEM;
 }
 
-/** Insert endpoint pair into map with laddr as key.
- *
- * If local port number is not specified, it is allocated.
+/** Destroy association map.
  *
  * @param map Association map
- * @param epp Endpoint pair, possibly with local port inet_port_any
- * @param arg arg User value
- * @param flags Flags
- * @param aepp Place to store actual endpoint pair, possibly with allocated port
- *
- * @return EOK on success, EEXIST if conflicting epp exists,
- *         ENOMEM if out of memory
  */
-static errno_t amap_insert_laddr(amap_t *map, inet_ep2_t *epp, void *arg,
-    amap_flags_t flags, inet_ep2_t *aepp)
+void amap_destroy(amap_t *map)
 {
-	amap_laddr_t *laddr;
-	inet_ep2_t mepp;
-	errno_t rc;
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_insert_laddr()");
-
-	rc = amap_laddr_find(map, &epp->local.addr, &laddr);
-	if (rc != EOK) {
-		/* New laddr */
-		rc = amap_laddr_insert(map, &epp->local.addr, &laddr);
-		if (rc != EOK) {
-			assert(rc == ENOMEM);
-			return rc;
-		}
-	}
-
-	mepp = *epp;
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_destroy()");
 
-	rc = portrng_alloc(laddr->portrng, epp->local.port, arg, aflags_to_pflags(flags),
-	    &mepp.local.port);
-	if (rc != EOK) {
-		return rc;
-	}
+	assert(hash_table_empty(&map->repla));
+	assert(hash_table_empty(&map->laddr));
+	assert(hash_table_empty(&map->llink));
+	assert(hash_table_empty(&map->unspec));
 
-	*aepp = mepp;
-	return EOK;
+	hash_table_destroy(&map->repla);
+	hash_table_destroy(&map->laddr);
+	hash_table_destroy(&map->llink);
+	hash_table_destroy(&map->unspec);
+	free(map);
 }
 
-/** Insert endpoint pair into map with llink as key.
+/** Insert endpoint pair into one of the map tables.
  *
- * If local port number is not specified, it is allocated.
+ * If local port number is not specified, it is allocated from the dynamic
+ * range so that the resulting key is unique in @a table.
  *
  * @param map Association map
+ * @param table Table to insert into
  * @param epp Endpoint pair, possibly with local port inet_port_any
  * @param arg arg User value
  * @param flags Flags
  * @param aepp Place to store actual endpoint pair, possibly with allocated port
  *
  * @return EOK on success, EEXIST if conflicting epp exists,
- *         ENOMEM if out of memory
+ *         ENOENT if no free port is left, EINVAL if a system port is
+ *         requested without @c af_allow_system, ENOMEM if out of memory
  */
-static errno_t amap_insert_llink(amap_t *map, inet_ep2_t *epp, void *arg,
-    amap_flags_t flags, inet_ep2_t *aepp)
+static errno_t amap_insert_table(amap_t *map, hash_table_t *table,
+    inet_ep2_t *epp, void *arg, amap_flags_t flags, inet_ep2_t *aepp)
 {
-	amap_llink_t *llink;
+	amap_entry_t *entry;
 	inet_ep2_t mepp;
-	errno_t rc;
+	uint32_t i;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_insert_llink()");
+	mepp = *epp;
 
-	rc = amap_llink_find(map, epp->local_link, &llink);
-	if (rc != EOK) {
-		/* New llink */
-		rc = amap_llink_insert(map, epp->local_link, &llink);
-		if (rc != EOK) {
-			assert(rc == ENOMEM);
-			return rc;
+	if (mepp.local.port == inet_port_any) {
+		for (i = inet_port_dyn_lo; i <= inet_port_dyn_hi; i++) {
+			mepp.local.port = map->port_next;
+			if (map->port_next == inet_port_dyn_hi)
+				map->port_next = inet_port_dyn_lo;
+			else
+				++map->port_next;
+
+			if (hash_table_find(table, &mepp) == NULL)
+				break;
 		}
-	}
 
-	mepp = *epp;
+		if (i > inet_port_dyn_hi) {
+			/* No free port found */
+			return ENOENT;
+		}
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_insert_table: selected "
+		    "port %" PRIu16, mepp.local.port);
+	} else {
+		if ((flags & af_allow_system) == 0 &&
+		    mepp.local.port < inet_port_user_lo) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG2, "system port not "
+			    "allowed");
+			return EINVAL;
+		}
 
-	rc = portrng_alloc(llink->portrng, epp->local.port, arg, aflags_to_pflags(flags),
-	    &mepp.local.port);
-	if (rc != EOK) {
-		return rc;
+		if (hash_table_find(table, &mepp) != NULL) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG2, "port already used");
+			return EEXIST;
+		}
 	}
 
+	entry = calloc(1, sizeof(amap_entry_t));
+	if (entry == NULL)
+		return ENOMEM;
+
+	entry->epp = mepp;
+	entry->arg = arg;
+	hash_table_insert(table, &entry->lmap);
+
 	*aepp = mepp;
 	return EOK;
 }
 
-/** Insert endpoint pair into map with unspec as key.
- *
- * If local port number is not specified, it is allocated.
+/** Determine which table an endpoint pair belongs to.
  *
  * @param map Association map
- * @param epp Endpoint pair, possibly with local port inet_port_any
- * @param arg arg User value
- * @param flags Flags
- * @param aepp Place to store actual endpoint pair, possibly with allocated port
- *
- * @return EOK on success, EEXIST if conflicting epp exists,
- *         ENOMEM if out of memory
+ * @param epp Endpoint pair
+ * @return Table or @c NULL if the combination of specified attributes
+ *         is not valid
  */
-static errno_t amap_insert_unspec(amap_t *map, inet_ep2_t *epp, void *arg,
-    amap_flags_t flags, inet_ep2_t *aepp)
+static hash_table_t *amap_epp_table(amap_t *map, inet_ep2_t *epp)
 {
-	inet_ep2_t mepp;
-	errno_t rc;
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_insert_unspec()");
-	mepp = *epp;
+	bool raddr, rport, laddr, llink;
 
-	rc = portrng_alloc(map->unspec, epp->local.port, arg, aflags_to_pflags(flags),
-	    &mepp.local.port);
-	if (rc != EOK) {
-		return rc;
-	}
+	raddr = !inet_addr_is_any(&epp->remote.addr);
+	rport = epp->remote.port != inet_port_any;
+	laddr = !inet_addr_is_any(&epp->local.addr);
+	llink = epp->local_link != 0;
 
-	*aepp = mepp;
-	return EOK;
+	if (raddr && rport && laddr && !llink)
+		return &map->repla;
+	else if (!raddr && !rport && laddr && !llink)
+		return &map->laddr;
+	else if (!raddr && !rport && !laddr && llink)
+		return &map->llink;
+	else if (!raddr && !rport && !laddr && !llink)
+		return &map->unspec;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap: invalid combination of "
+	    "raddr=%d rport=%d laddr=%d llink=%d", raddr, rport, laddr, llink);
+	return NULL;
 }
 
 /** Insert endpoint pair into map.
@@ -540,7 +402,7 @@ static errno_t amap_insert_unspec(amap_t *map, inet_ep2_t *epp, void *arg,
 errno_t amap_insert(amap_t *map, inet_ep2_t *epp, void *arg, amap_flags_t flags,
     inet_ep2_t *aepp)
 {
-	bool raddr, rport, laddr, llink;
+	hash_table_t *table;
 	inet_ep2_t mepp;
 	errno_t rc;
 
@@ -564,115 +426,11 @@ errno_t amap_insert(amap_t *map, inet_ep2_t *epp, void *arg, amap_flags_t flags,
 		    "local address specified or remote address not specified");
 	}
 
-	raddr = !inet_addr_is_any(&mepp.remote.addr);
-	rport = mepp.remote.port != inet_port_any;
-	laddr = !inet_addr_is_any(&mepp.local.addr);
-	llink = mepp.local_link != 0;
-
-	if (raddr && rport && laddr && !llink) {
-		return amap_insert_repla(map, &mepp, arg, flags, aepp);
-	} else if (!raddr && !rport && laddr && !llink) {
-		return amap_insert_laddr(map, &mepp, arg, flags, aepp);
-	} else if (!raddr && !rport && !laddr && llink) {
-		return amap_insert_llink(map, &mepp, arg, flags, aepp);
-	} else if (!raddr && !rport && !laddr && !llink) {
-		return amap_insert_unspec(map, &mepp, arg, flags, aepp);
-	} else {
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_insert: invalid "
-		    "combination of raddr=%d rport=%d laddr=%d llink=%d",
-		    raddr, rport, laddr, llink);
+	table = amap_epp_table(map, &mepp);
+	if (table == NULL)
 		return EINVAL;
-	}
 
-	return EOK;
-}
-
-/** Remove endpoint pair using repla as key from map.
- *
- * The endpoint pair must be present in the map, otherwise behavior
- * is unspecified.
- *
- * @param map Association map
- * @param epp Endpoint pair
- */
-static void amap_remove_repla(amap_t *map, inet_ep2_t *epp)
-{
-	amap_repla_t *repla;
-	errno_t rc;
-
-	rc = amap_repla_find(map, &epp->remote, &epp->local.addr, &repla);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_remove_repla: not found");
-		return;
-	}
-
-	portrng_free_port(repla->portrng, epp->local.port);
-
-	if (portrng_empty(repla->portrng))
-		amap_repla_remove(map, repla);
-}
-
-/** Remove endpoint pair using laddr as key from map.
- *
- * The endpoint pair must be present in the map, otherwise behavior
- * is unspecified.
- *
- * @param map Association map
- * @param epp Endpoint pair
- */
-static void amap_remove_laddr(amap_t *map, inet_ep2_t *epp)
-{
-	amap_laddr_t *laddr;
-	errno_t rc;
-
-	rc = amap_laddr_find(map, &epp->local.addr, &laddr);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_remove_laddr: not found");
-		return;
-	}
-
-	portrng_free_port(laddr->portrng, epp->local.port);
-
-	if (portrng_empty(laddr->portrng))
-		amap_laddr_remove(map, laddr);
-}
-
-/** Remove endpoint pair using llink as key from map.
- *
- * The endpoint pair must be present in the map, otherwise behavior
- * is unspecified.
- *
- * @param map Association map
- * @param epp Endpoint pair
- */
-static void amap_remove_llink(amap_t *map, inet_ep2_t *epp)
-{
-	amap_llink_t *llink;
-	errno_t rc;
-
-	rc = amap_llink_find(map, epp->local_link, &llink);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_remove_llink: not found");
-		return;
-	}
-
-	portrng_free_port(llink->portrng, epp->local.port);
-
-	if (portrng_empty(llink->portrng))
-		amap_llink_remove(map, llink);
-}
-
-/** Remove endpoint pair using unspec as key from map.
- *
- * The endpoint pair must be present in the map, otherwise behavior
- * is unspecified.
- *
- * @param map Association map
- * @param epp Endpoint pair
- */
-static void amap_remove_unspec(amap_t *map, inet_ep2_t *epp)
-{
-	portrng_free_port(map->unspec, epp->local.port);
+	return amap_insert_table(map, table, &mepp, arg, flags, aepp);
 }
 
 /** Remove endpoint pair from map.
@@ -685,34 +443,22 @@ static void amap_remove_unspec(amap_t *map, inet_ep2_t *epp)
  */
 void amap_remove(amap_t *map, inet_ep2_t *epp)
 {
-	bool raddr, rport, laddr, llink;
+	hash_table_t *table;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_remove()");
 
-	raddr = !inet_addr_is_any(&epp->remote.addr);
-	rport = epp->remote.port != inet_port_any;
-	laddr = !inet_addr_is_any(&epp->local.addr);
-	llink = epp->local_link != 0;
-
-	if (raddr && rport && laddr && !llink) {
-		amap_remove_repla(map, epp);
-	} else if (!raddr && !rport && laddr && !llink) {
-		amap_remove_laddr(map, epp);
-	} else if (!raddr && !rport && !laddr && llink) {
-		amap_remove_llink(map, epp);
-	} else if (!raddr && !rport && !laddr && !llink) {
-		amap_remove_unspec(map, epp);
-	} else {
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_remove: invalid "
-		    "combination of raddr=%d rport=%d laddr=%d llink=%d",
-		    raddr, rport, laddr, llink);
+	table = amap_epp_table(map, epp);
+	if (table == NULL)
 		return;
-	}
+
+	if (hash_table_remove(table, epp) == 0)
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_remove: not found");
 }
 
 /** Find association matching an endpoint pair.
  *
- * Used to find which association to deliver a datagram to.
+ * Used to find which association to deliver a datagram to. Does not
+ * modify the map, so concurrent lookups may share a reader lock.
  *
  * @param map	Association map
  * @param epp	Endpoint pair
@@ -722,60 +468,52 @@ void amap_remove(amap_t *map, inet_ep2_t *epp)
  */
 errno_t amap_find_match(amap_t *map, inet_ep2_t *epp, void **rarg)
 {
-	errno_t rc;
-	amap_repla_t *repla;
-	amap_laddr_t *laddr;
-	amap_llink_t *llink;
+	ht_link_t *link;
+	amap_entry_t *entry;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_find_match(llink=%zu)",
 	    epp->local_link);
 
-	/* Remode endpoint, local address */
-	rc = amap_repla_find(map, &epp->remote, &epp->local.addr, &repla);
-	if (rc == EOK) {
-		rc = portrng_find_port(repla->portrng, epp->local.port,
-		    rarg);
-		if (rc == EOK) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched repla / "
-			    "port %" PRIu16, epp->local.port);
-			return EOK;
-		}
+	/* Remote endpoint, local address */
+	link = hash_table_find(&map->repla, epp);
+	if (link != NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched repla / "
+		    "port %" PRIu16, epp->local.port);
+		goto found;
 	}
 
 	/* Local address */
-	rc = amap_laddr_find(map, &epp->local.addr, &laddr);
-	if (rc == EOK) {
-		rc = portrng_find_port(laddr->portrng, epp->local.port,
-		    rarg);
-		if (rc == EOK) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched laddr / "
-			    "port %" PRIu16, epp->local.port);
-			return EOK;
-		}
+	link = hash_table_find(&map->laddr, epp);
+	if (link != NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched laddr / "
+		    "port %" PRIu16, epp->local.port);
+		goto found;
 	}
 
 	/* Local link */
-	rc = amap_llink_find(map, epp->local_link, &llink);
-	if (epp->local_link != 0 && rc == EOK) {
-		rc = portrng_find_port(llink->portrng, epp->local.port,
-		    rarg);
-		if (rc == EOK) {
+	if (epp->local_link != 0) {
+		link = hash_table_find(&map->llink, epp);
+		if (link != NULL) {
 			log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched llink / "
 			    "port %" PRIu16, epp->local.port);
-			return EOK;
+			goto found;
 		}
 	}
 
 	/* Unspecified */
-	rc = portrng_find_port(map->unspec, epp->local.port, rarg);
-	if (rc == EOK) {
+	link = hash_table_find(&map->unspec, epp);
+	if (link != NULL) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG2, "Matched unspec / port %" PRIu16,
 		    epp->local.port);
-		return EOK;
+		goto found;
 	}
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "No match.");
 	return ENOENT;
+found:
+	entry = hash_table_get_inst(link, amap_entry_t, lmap);
+	*rarg = entry->arg;
+	return EOK;
 }
 
 /**
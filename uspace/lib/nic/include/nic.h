@@ -46,6 +46,9 @@
 
 #define DEVICE_CATEGORY_NIC "nic"
 
+/** Default number of frames received in one interrupt or poll */
+#define NIC_RX_BUDGET_DEFAULT 64
+
 struct nic;
 typedef struct nic nic_t;
 
@@ -61,6 +64,9 @@ typedef struct nic_wol_virtue {
 	struct nic_wol_virtue *next;
 } nic_wol_virtue_t;
 
+struct nic_frame_pool;
+typedef struct nic_frame_pool nic_frame_pool_t;
+
 /**
  * Simple structure for sending lists of frames.
  */
@@ -68,6 +74,10 @@ typedef struct {
 	link_t link;
 	void *data;
 	size_t size;
+	/** Pool owning the frame or NULL if the frame was allocated */
+	nic_frame_pool_t *pool;
+	/** Physical address of the data (only for frames from a pool) */
+	uintptr_t phys;
 } nic_frame_t;
 
 typedef list_t nic_frame_list_t;
@@ -205,6 +215,24 @@ typedef errno_t (*poll_mode_change_handler)(nic_t *,
  */
 typedef void (*poll_request_handler)(nic_t *);
 
+/**
+ * Handler receiving at most the given number of frames from the device.
+ * Used when the NICF switches the device from interrupts to polling.
+ *
+ * @param nic_data	NICF main structure
+ * @param budget	Maximal number of frames to receive
+ *
+ * @return Number of frames received
+ */
+typedef size_t (*rx_poll_handler)(nic_t *, size_t);
+
+/**
+ * Handler unmasking receive interrupts once polling is no longer needed.
+ *
+ * @param nic_data	NICF main structure
+ */
+typedef void (*rx_irq_enable_handler)(nic_t *);
+
 /* nic_t allocation and deallocation */
 extern nic_t *nic_create_and_bind(ddf_dev_t *);
 extern void nic_unbind_and_destroy(ddf_dev_t *);
@@ -228,6 +256,8 @@ extern void nic_set_wol_virtue_change_handlers(nic_t *,
     wol_virtue_add_handler, wol_virtue_remove_handler);
 extern void nic_set_poll_handlers(nic_t *,
     poll_mode_change_handler, poll_request_handler);
+extern void nic_set_rx_poll_handlers(nic_t *,
+    rx_poll_handler, rx_irq_enable_handler);
 
 /* General driver functions */
 extern ddf_dev_t *nic_get_ddf_dev(nic_t *);
@@ -244,6 +274,9 @@ extern void nic_query_address(nic_t *, nic_address_t *);
 extern void nic_received_frame(nic_t *, nic_frame_t *);
 extern void nic_received_frame_list(nic_t *, nic_frame_list_t *);
 extern nic_poll_mode_t nic_query_poll_mode(nic_t *, struct timespec *);
+extern void nic_set_rx_budget(nic_t *, size_t);
+extern size_t nic_query_rx_budget(nic_t *);
+extern bool nic_rx_interrupt(nic_t *);
 
 /* Statistics updates */
 extern void nic_report_send_ok(nic_t *, size_t, size_t);
@@ -258,6 +291,11 @@ extern nic_frame_list_t *nic_alloc_frame_list(void);
 extern void nic_frame_list_append(nic_frame_list_t *, nic_frame_t *);
 extern void nic_release_frame(nic_t *, nic_frame_t *);
 
+/* Pools of DMA-capable frames */
+extern errno_t nic_frame_pool_create(size_t, size_t, nic_frame_pool_t **);
+extern void nic_frame_pool_destroy(nic_frame_pool_t *);
+extern nic_frame_t *nic_frame_pool_get(nic_frame_pool_t *);
+
 /* RXC query and report functions */
 extern void nic_report_hw_filtering(nic_t *, int, int, int);
 extern void nic_query_unicast(const nic_t *,
@@ -56,6 +56,14 @@ struct sw_poll_info {
 	volatile int running;
 };
 
+struct rx_poll_info {
+	fid_t fibril;
+	fibril_mutex_t lock;
+	fibril_condvar_t cv;
+	/** Receive interrupts are masked and the fibril polls the device */
+	bool scheduled;
+};
+
 struct nic {
 	/**
 	 * Device from device manager's point of view.
@@ -89,6 +97,10 @@ struct nic {
 	struct timespec default_poll_period;
 	/** Software period fibrill information */
 	struct sw_poll_info sw_poll_info;
+	/** Maximal number of frames received in one interrupt or poll */
+	size_t rx_budget;
+	/** Receive polling fibril information */
+	struct rx_poll_info rx_poll_info;
 	/**
 	 * Lock on everything but statistics, rx control and wol virtues. This lock
 	 * cannot be used if filters_lock or stats_lock is already held - you must
@@ -194,10 +206,39 @@ struct nic {
 	 * The implementation is optional.
 	 */
 	poll_request_handler on_poll_request;
+	/**
+	 * Handler receiving a limited number of frames. Set together with
+	 * on_rx_irq_enable by drivers that let the NICF poll them under load.
+	 * Called without any lock held.
+	 */
+	rx_poll_handler on_rx_poll;
+	/**
+	 * Handler unmasking receive interrupts after polling.
+	 * Called with the main_lock locked for reading.
+	 */
+	rx_irq_enable_handler on_rx_irq_enable;
 	/** Data specific for particular driver */
 	void *specific;
 };
 
+/**
+ * Pool of frames with preallocated DMA-capable buffers
+ */
+struct nic_frame_pool {
+	/** Memory holding the buffers of all frames */
+	void *virt;
+	/** Physical address of the memory */
+	uintptr_t phys;
+	/** Size of the buffer of each frame */
+	size_t buf_size;
+	/** All frames of the pool */
+	nic_frame_t *frames;
+	/** Frames not taken from the pool */
+	list_t free;
+	/** Lock for the list of free frames */
+	fibril_mutex_t lock;
+};
+
 /**
  * Structure keeping global data
  */
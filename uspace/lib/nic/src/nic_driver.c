@@ -43,6 +43,7 @@
 #include <str_error.h>
 #include <sysinfo.h>
 #include <as.h>
+#include <ddi.h>
 #include <ddf/interrupt.h>
 #include <ops/nic.h>
 #include <errno.h>
@@ -232,6 +233,22 @@ void nic_set_poll_handlers(nic_t *nic_data,
 	nic_data->on_poll_request = on_poll_req;
 }
 
+/**
+ * Setup handlers letting the NICF switch the device from interrupts
+ * to polling when frames arrive faster than they can be handled in the
+ * interrupt handler (see nic_rx_interrupt()).
+ *
+ * @param nic_data		Driver data
+ * @param on_rx_poll		Handler receiving a limited number of frames
+ * @param on_rx_irq_enable	Handler unmasking receive interrupts
+ */
+void nic_set_rx_poll_handlers(nic_t *nic_data, rx_poll_handler on_rx_poll,
+    rx_irq_enable_handler on_rx_irq_enable)
+{
+	nic_data->on_rx_poll = on_rx_poll;
+	nic_data->on_rx_irq_enable = on_rx_irq_enable;
+}
+
 /**
  * Connect to the parent's driver and get HW resources list in parsed format.
  * Note: this function should be called only from add_device handler, therefore
@@ -280,6 +297,8 @@ nic_frame_t *nic_alloc_frame(nic_t *nic_data, size_t size)
 		link_initialize(&frame->link);
 	}
 
+	frame->pool = NULL;
+	frame->phys = 0;
 	frame->data = malloc(size);
 	if (frame->data == NULL) {
 		free(frame);
@@ -290,7 +309,124 @@ nic_frame_t *nic_alloc_frame(nic_t *nic_data, size_t size)
 	return frame;
 }
 
+/** Create a pool of DMA-capable frames
+ *
+ *  The buffers of all the frames are allocated at once in physically
+ *  contiguous memory below 4 GiB, so the driver can pass them to the
+ *  device. A frame taken from the pool with nic_frame_pool_get() returns
+ *  to the pool when it is released with nic_release_frame(), typically
+ *  after it was passed up the stack by nic_received_frame() or
+ *  nic_received_frame_list().
+ *
+ *  @param count	Number of frames in the pool
+ *  @param buf_size	Size of the buffer of each frame
+ *  @param[out] rpool	Place to store the pointer to the new pool
+ *
+ *  @return EOK on success, ENOMEM if out of memory or an error code
+ *	    from dmamem_map_anonymous()
+ */
+errno_t nic_frame_pool_create(size_t count, size_t buf_size,
+    nic_frame_pool_t **rpool)
+{
+	nic_frame_pool_t *pool;
+	errno_t rc;
+
+	assert(count > 0);
+	assert(buf_size > 0);
+
+	pool = calloc(1, sizeof(nic_frame_pool_t));
+	if (pool == NULL)
+		return ENOMEM;
+
+	pool->frames = calloc(count, sizeof(nic_frame_t));
+	if (pool->frames == NULL) {
+		free(pool);
+		return ENOMEM;
+	}
+
+	pool->virt = AS_AREA_ANY;
+	rc = dmamem_map_anonymous(count * buf_size, DMAMEM_4GiB,
+	    AS_AREA_READ | AS_AREA_WRITE, 0, &pool->phys, &pool->virt);
+	if (rc != EOK) {
+		free(pool->frames);
+		free(pool);
+		return rc;
+	}
+
+	pool->buf_size = buf_size;
+	list_initialize(&pool->free);
+	fibril_mutex_initialize(&pool->lock);
+
+	for (size_t i = 0; i < count; i++) {
+		nic_frame_t *frame = &pool->frames[i];
+
+		link_initialize(&frame->link);
+		frame->data = (uint8_t *) pool->virt + i * buf_size;
+		frame->phys = pool->phys + i * buf_size;
+		frame->pool = pool;
+		list_append(&frame->link, &pool->free);
+	}
+
+	*rpool = pool;
+	return EOK;
+}
+
+/** Destroy a frame pool
+ *
+ *  The frames taken from the pool must not be used after this call,
+ *  whether they were returned or not.
+ *
+ *  @param pool The pool or NULL
+ */
+void nic_frame_pool_destroy(nic_frame_pool_t *pool)
+{
+	if (pool == NULL)
+		return;
+
+	dmamem_unmap_anonymous(pool->virt);
+	free(pool->frames);
+	free(pool);
+}
+
+/** Take a frame from a pool
+ *
+ *  @param pool The pool
+ *
+ *  @return Frame with buffer of the pool's buffer size or NULL if all the
+ *	    frames are taken
+ */
+nic_frame_t *nic_frame_pool_get(nic_frame_pool_t *pool)
+{
+	nic_frame_t *frame = NULL;
+
+	fibril_mutex_lock(&pool->lock);
+	if (!list_empty(&pool->free)) {
+		frame = list_get_instance(list_first(&pool->free),
+		    nic_frame_t, link);
+		list_remove(&frame->link);
+		frame->size = pool->buf_size;
+	}
+	fibril_mutex_unlock(&pool->lock);
+
+	return frame;
+}
+
+/** Return a frame to its pool
+ *
+ *  @param frame Frame taken from a pool
+ */
+static void nic_frame_pool_put(nic_frame_t *frame)
+{
+	nic_frame_pool_t *pool = frame->pool;
+
+	fibril_mutex_lock(&pool->lock);
+	list_prepend(&frame->link, &pool->free);
+	fibril_mutex_unlock(&pool->lock);
+}
+
 /** Release frame
+ *
+ * Frames taken from a pool are returned to the pool.
  *
  * @param nic_data	The driver data
  * @param frame		The frame to release
@@ -300,6 +436,11 @@ void nic_release_frame(nic_t *nic_data, nic_frame_t *frame)
 	if (!frame)
 		return;
 
+	if (frame->pool != NULL) {
+		nic_frame_pool_put(frame);
+		return;
+	}
+
 	if (frame->data != NULL) {
 		free(frame->data);
 		frame->data = NULL;
@@ -507,20 +648,17 @@ void nic_set_tx_busy(nic_t *nic_data, int busy)
 	nic_data->tx_busy = busy;
 }
 
-/**
- * This is the function that the driver should call when it receives a frame.
- * The frame is checked by filters and then sent up to the NIL layer or
- * discarded. The frame is released.
+/** Check a received frame against the filters and update statistics.
  *
  * @param nic_data
  * @param frame		The received frame
+ *
+ * @return True if the frame should be passed to the NIL layer
  */
-void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+static bool nic_received_frame_check(nic_t *nic_data, nic_frame_t *frame)
 {
-	/*
-	 * Note: this function must not lock main lock, because loopback driver
-	 * 		 calls it inside send_frame handler (with locked main lock)
-	 */
+	bool accept;
+
 	fibril_rwlock_read_lock(&nic_data->rxc_lock);
 	nic_frame_type_t frame_type;
 	bool check = nic_rxc_check(&nic_data->rx_control, frame->data,
@@ -529,7 +667,8 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 	/* Update statistics */
 	fibril_rwlock_write_lock(&nic_data->stats_lock);
 
-	if (nic_data->state == NIC_STATE_ACTIVE && check) {
+	accept = nic_data->state == NIC_STATE_ACTIVE && check;
+	if (accept) {
 		nic_data->stats.receive_packets++;
 		nic_data->stats.receive_bytes += frame->size;
 		switch (frame_type) {
@@ -542,9 +681,6 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 		default:
 			break;
 		}
-		fibril_rwlock_write_unlock(&nic_data->stats_lock);
-		nic_ev_received(nic_data->client_session, frame->data,
-		    frame->size);
 	} else {
 		switch (frame_type) {
 		case NIC_FRAME_UNICAST:
@@ -557,31 +693,116 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 			nic_data->stats.receive_filtered_broadcast++;
 			break;
 		}
-		fibril_rwlock_write_unlock(&nic_data->stats_lock);
+	}
+
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+	return accept;
+}
+
+/**
+ * This is the function that the driver should call when it receives a frame.
+ * The frame is checked by filters and then sent up to the NIL layer or
+ * discarded. The frame is released.
+ *
+ * @param nic_data
+ * @param frame		The received frame
+ */
+void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+{
+	/*
+	 * Note: this function must not lock main lock, because loopback driver
+	 * 		 calls it inside send_frame handler (with locked main lock)
+	 */
+	if (nic_received_frame_check(nic_data, frame)) {
+		nic_ev_received(nic_data->client_session, frame->data,
+		    frame->size);
 	}
 	nic_release_frame(nic_data, frame);
 }
 
+/** Pass a batch of frames up to the NIL layer.
+ *
+ * @param nic_data
+ * @param batch		Frames, each preceded by its size
+ * @param size		Size of the batch in bytes
+ * @param count		Number of frames in the batch
+ */
+static void nic_received_batch_send(nic_t *nic_data, uint8_t *batch,
+    size_t size, size_t count)
+{
+	if (count == 1) {
+		nic_ev_received(nic_data->client_session,
+		    batch + sizeof(size_t), size - sizeof(size_t));
+	} else if (count > 1) {
+		nic_ev_received_list(nic_data->client_session, batch, size);
+	}
+}
+
 /**
  * Some NICs can receive multiple frames during single interrupt. These can
  * send them in whole list of frames (actually nic_frame_t structures), then
- * the list is deallocated and each frame is passed to the
- * nic_received_packet function.
+ * the list is deallocated and the frames that pass the filters are sent up
+ * to the NIL layer in as few messages as possible.
  *
  * @param nic_data
  * @param frames		List of received frames
  */
 void nic_received_frame_list(nic_t *nic_data, nic_frame_list_t *frames)
 {
+	uint8_t *batch;
+	size_t bsize;
+	size_t count;
+
 	if (frames == NULL)
 		return;
+
+	/* A lone frame is passed without batching */
+	batch = list_count(frames) > 1 ? malloc(DATA_XFER_LIMIT) : NULL;
+	bsize = 0;
+	count = 0;
+
 	while (!list_empty(frames)) {
 		nic_frame_t *frame =
 		    list_get_instance(list_first(frames), nic_frame_t, link);
 
 		list_remove(&frame->link);
-		nic_received_frame(nic_data, frame);
+
+		size_t fsize = sizeof(size_t) + frame->size;
+		if (batch == NULL || fsize > DATA_XFER_LIMIT) {
+			/* Cannot batch this frame, keep the order */
+			if (batch != NULL) {
+				nic_received_batch_send(nic_data, batch,
+				    bsize, count);
+				bsize = 0;
+				count = 0;
+			}
+
+			nic_received_frame(nic_data, frame);
+			continue;
+		}
+
+		if (!nic_received_frame_check(nic_data, frame)) {
+			nic_release_frame(nic_data, frame);
+			continue;
+		}
+
+		if (bsize + fsize > DATA_XFER_LIMIT) {
+			nic_received_batch_send(nic_data, batch, bsize, count);
+			bsize = 0;
+			count = 0;
+		}
+
+		memcpy(batch + bsize, &frame->size, sizeof(size_t));
+		memcpy(batch + bsize + sizeof(size_t), frame->data,
+		    frame->size);
+		bsize += fsize;
+		++count;
+
+		nic_release_frame(nic_data, frame);
 	}
+
+	nic_received_batch_send(nic_data, batch, bsize, count);
+	free(batch);
 	nic_driver_release_frame_list(frames);
 }
 
@@ -611,6 +832,7 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	nic_data->client_session = NULL;
 	nic_data->poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->default_poll_mode = NIC_POLL_IMMEDIATE;
+	nic_data->rx_budget = NIC_RX_BUDGET_DEFAULT;
 	nic_data->send_frame = NULL;
 	nic_data->on_activating = NULL;
 	nic_data->on_going_down = NULL;
@@ -621,6 +843,8 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	fibril_rwlock_initialize(&nic_data->stats_lock);
 	fibril_rwlock_initialize(&nic_data->rxc_lock);
 	fibril_rwlock_initialize(&nic_data->wv_lock);
+	fibril_mutex_initialize(&nic_data->rx_poll_info.lock);
+	fibril_condvar_initialize(&nic_data->rx_poll_info.cv);
 
 	memset(&nic_data->mac, 0, sizeof(nic_address_t));
 	memset(&nic_data->default_mac, 0, sizeof(nic_address_t));
@@ -1132,5 +1356,118 @@ void nic_sw_period_stop(nic_t *nic_data)
 	nic_data->sw_poll_info.running = 0;
 }
 
+/** Set the receive budget
+ *
+ *  The budget limits the number of frames received in one interrupt
+ *  or one round of polling.
+ *
+ *  @param nic_data The controller data
+ *  @param budget   Maximal number of frames, must not be zero
+ */
+void nic_set_rx_budget(nic_t *nic_data, size_t budget)
+{
+	assert(budget > 0);
+	nic_data->rx_budget = budget;
+}
+
+/** Get the receive budget
+ *
+ *  @param nic_data The controller data
+ *  @return Maximal number of frames received in one interrupt or poll
+ */
+size_t nic_query_rx_budget(nic_t *nic_data)
+{
+	return nic_data->rx_budget;
+}
+
+/** Receive polling fibril
+ *
+ *  Polls the device while it has more frames than the budget, then
+ *  unmasks its receive interrupts again.
+ *
+ *  @param  data The NIC structure pointer
+ *
+ *  @return 0, never reached
+ */
+static errno_t rx_poll_fibril_fun(void *data)
+{
+	nic_t *nic_data = data;
+	struct rx_poll_info *info = &nic_data->rx_poll_info;
+
+	while (true) {
+		fibril_mutex_lock(&info->lock);
+		while (!info->scheduled)
+			fibril_condvar_wait(&info->cv, &info->lock);
+		fibril_mutex_unlock(&info->lock);
+
+		/* Let other fibrils run between the rounds */
+		while (nic_data->state == NIC_STATE_ACTIVE &&
+		    nic_data->on_rx_poll(nic_data, nic_data->rx_budget) >=
+		    nic_data->rx_budget)
+			fibril_yield();
+
+		fibril_mutex_lock(&info->lock);
+		info->scheduled = false;
+		fibril_mutex_unlock(&info->lock);
+
+		/*
+		 * Do not unmask the interrupts if the device was stopped or
+		 * switched to polling meanwhile.
+		 */
+		fibril_rwlock_read_lock(&nic_data->main_lock);
+		if (nic_data->state == NIC_STATE_ACTIVE &&
+		    (nic_data->poll_mode == NIC_POLL_IMMEDIATE ||
+		    nic_data->poll_mode == NIC_POLL_PERIODIC))
+			nic_data->on_rx_irq_enable(nic_data);
+		fibril_rwlock_read_unlock(&nic_data->main_lock);
+	}
+	return EOK;
+}
+
+/** Handle a receive interrupt
+ *
+ *  Called from the driver's interrupt handler with the receive interrupts
+ *  masked. Receives at most rx_budget frames. If the budget is exhausted,
+ *  more frames are probably waiting and the device is switched to polling:
+ *  the interrupts stay masked and the NICF polls the device from its own
+ *  fibril until a round receives less than the budget. Then the receive
+ *  interrupts are unmasked through the on_rx_irq_enable handler.
+ *
+ *  @param nic_data The controller data
+ *
+ *  @return false if the driver should unmask the receive interrupts
+ *  @return true if the receive interrupts must stay masked
+ */
+bool nic_rx_interrupt(nic_t *nic_data)
+{
+	struct rx_poll_info *info = &nic_data->rx_poll_info;
+
+	assert(nic_data->on_rx_poll != NULL);
+	assert(nic_data->on_rx_irq_enable != NULL);
+
+	if (nic_data->on_rx_poll(nic_data, nic_data->rx_budget) <
+	    nic_data->rx_budget)
+		return false;
+
+	fibril_mutex_lock(&info->lock);
+
+	/* Create the fibril if it is not created */
+	if (info->fibril == 0) {
+		info->fibril = fibril_create(rx_poll_fibril_fun, nic_data);
+		if (info->fibril == 0) {
+			fibril_mutex_unlock(&info->lock);
+			return false;
+		}
+
+		fibril_add_ready(info->fibril);
+	}
+
+	info->scheduled = true;
+	fibril_condvar_signal(&info->cv);
+	fibril_mutex_unlock(&info->lock);
+
+	return true;
+}
+
 /** @}
  */
@@ -73,13 +73,14 @@ errno_t nic_ev_device_state(async_sess_t *sess, sysarg_t state)
 	return rc;
 }
 
-/** Frame received. */
-errno_t nic_ev_received(async_sess_t *sess, void *data, size_t size)
+/** Send received frame data with the given event method. */
+static errno_t nic_ev_received_data(async_sess_t *sess, sysarg_t method,
+    void *data, size_t size)
 {
 	async_exch_t *exch = async_exchange_begin(sess);
 
 	ipc_call_t answer;
-	aid_t req = async_send_0(exch, NIC_EV_RECEIVED, &answer);
+	aid_t req = async_send_0(exch, method, &answer);
 	errno_t retval = async_data_write_start(exch, data, size);
 
 	async_exchange_end(exch);
@@ -93,5 +94,20 @@ errno_t nic_ev_received(async_sess_t *sess, void *data, size_t size)
 	return retval;
 }
 
+/** Frame received. */
+errno_t nic_ev_received(async_sess_t *sess, void *data, size_t size)
+{
+	return nic_ev_received_data(sess, NIC_EV_RECEIVED, data, size);
+}
+
+/** Several frames received.
+ *
+ * Each frame in @a data is preceded by its size as @c size_t.
+ */
+errno_t nic_ev_received_list(async_sess_t *sess, void *data, size_t size)
+{
+	return nic_ev_received_data(sess, NIC_EV_RECEIVED_LIST, data, size);
+}
+
 /** @}
  */
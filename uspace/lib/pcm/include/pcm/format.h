@@ -38,6 +38,7 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <pcm/sample_format.h>
 
 /** Linear PCM audio parameters */
@@ -47,6 +48,33 @@ typedef struct {
 	pcm_sample_format_t sample_format;
 } pcm_format_t;
 
+/** Number of taps of the resampling filter */
+#define PCM_RESAMPLER_TAPS  16
+/** Number of filter phases between two source frames */
+#define PCM_RESAMPLER_PHASES  64
+/** Maximum number of source channels the resampler handles */
+#define PCM_RESAMPLER_CHANNELS  8
+
+/** Polyphase sample rate converter */
+typedef struct {
+	/** Source sampling rate */
+	unsigned src_rate;
+	/** Destination sampling rate */
+	unsigned dst_rate;
+	/** Number of source channels */
+	unsigned channels;
+	/** Source frames per destination frame (32.32 fixed point) */
+	uint64_t step;
+	/** Position of the next output between the middle history frames */
+	uint64_t phase;
+	/** Index of the oldest frame in the history */
+	unsigned pos;
+	/** Recent source frames, stored twice to keep the windows contiguous */
+	float history[PCM_RESAMPLER_CHANNELS][2 * PCM_RESAMPLER_TAPS];
+	/** Filter coefficients for each phase */
+	float coef[PCM_RESAMPLER_PHASES][PCM_RESAMPLER_TAPS];
+} pcm_resampler_t;
+
 extern const pcm_format_t AUDIO_FORMAT_DEFAULT;
 extern const pcm_format_t AUDIO_FORMAT_ANY;
 
@@ -103,6 +131,12 @@ errno_t pcm_format_mix(void *dst, const void *src, size_t size, const pcm_format
 errno_t pcm_format_convert(pcm_format_t a, void *srca, size_t sizea,
     pcm_format_t b, void *srcb, size_t *sizeb);
 
+errno_t pcm_resampler_init(pcm_resampler_t *r, unsigned src_rate,
+    unsigned dst_rate, unsigned channels);
+errno_t pcm_resample_and_mix(pcm_resampler_t *r, void *dst, size_t dst_size,
+    const void *src, size_t src_size, const pcm_format_t *sf,
+    const pcm_format_t *df, size_t *dst_used, size_t *src_used);
+
 #endif
 
 /**
@@ -70,6 +70,8 @@ const pcm_format_t AUDIO_FORMAT_ANY = {
 
 static float get_normalized_sample(const void *buffer, size_t size,
     unsigned frame, unsigned channel, const pcm_format_t *f);
+static void mix_normalized_sample(void *buffer, size_t size, unsigned frame,
+    unsigned channel, const pcm_format_t *f, float value);
 
 /**
  * Compare PCM format attribtues.
@@ -163,6 +165,117 @@ errno_t pcm_format_mix(void *dst, const void *src, size_t size, const pcm_format
 	return pcm_format_convert_and_mix(dst, size, src, size, f, f);
 }
 
+/** Clamp a float sample to <-1,1> */
+static inline float clamp_float(float x)
+{
+	if (x < -1.0f)
+		return -1.0f;
+	if (x > 1.0f)
+		return 1.0f;
+	return x;
+}
+
+/** Add a value to a signed 16-bit little endian sample with saturation */
+static inline void mix_s16(int16_t *d, int32_t v)
+{
+	int32_t c = (int16_t) int16_t_le2host(*d) + v;
+	if (c < INT16_MIN)
+		c = INT16_MIN;
+	if (c > INT16_MAX)
+		c = INT16_MAX;
+	*d = host2int16_t_le((int16_t) c);
+}
+
+/** Add a value to a float sample with saturation */
+static inline void mix_float(float *d, float v)
+{
+	*d = clamp_float(*d + v);
+}
+
+#define S16_TO_S16(x) ((int32_t) (int16_t) int16_t_le2host(x))
+#define S16_TO_FLOAT(x) (S16_TO_S16(x) / 32768.0f)
+#define FLOAT_TO_S16(x) ((int32_t) (clamp_float(x) * 32767.0f))
+#define FLOAT_TO_FLOAT(x) (x)
+
+/*
+ * Frame loops for the common formats. Samples are mixed directly in
+ * the destination format so that the compiler can vectorize the loops
+ * instead of going through get_normalized_sample() for every sample.
+ * Mono sources are copied to all destination channels, stereo sources
+ * are averaged into mono destinations.
+ */
+#define MIX_FRAMES(name, dtype, stype, CONV, MIX) \
+static void name(dtype *dst, const stype *src, size_t frames, \
+    unsigned dch, unsigned sch) \
+{ \
+	if (dch == sch) { \
+		for (size_t i = 0; i < frames * dch; ++i) \
+			MIX(&dst[i], CONV(src[i])); \
+	} else if (sch == 1) { \
+		for (size_t i = 0; i < frames; ++i) { \
+			for (unsigned j = 0; j < dch; ++j) \
+				MIX(&dst[i * dch + j], CONV(src[i])); \
+		} \
+	} else { \
+		for (size_t i = 0; i < frames; ++i) { \
+			MIX(&dst[i], (CONV(src[2 * i]) + \
+			    CONV(src[2 * i + 1])) / 2); \
+		} \
+	} \
+}
+
+MIX_FRAMES(mix_frames_s16_s16, int16_t, int16_t, S16_TO_S16, mix_s16);
+MIX_FRAMES(mix_frames_s16_float, int16_t, float, FLOAT_TO_S16, mix_s16);
+MIX_FRAMES(mix_frames_float_s16, float, int16_t, S16_TO_FLOAT, mix_float);
+MIX_FRAMES(mix_frames_float_float, float, float, FLOAT_TO_FLOAT, mix_float);
+
+#undef MIX_FRAMES
+
+/**
+ * Mix audio data using the fast frame loops if the formats allow it.
+ * @param dst Destination audio buffer
+ * @param dst_frames Number of frames in the destination buffer
+ * @param src Source audio buffer
+ * @param src_frames Number of frames in the source buffer
+ * @param sf Pointer to the source format descriptor.
+ * @param df Pointer to the destination format descriptor.
+ * @return True if the data were mixed, false if the formats are not handled.
+ */
+static bool mix_frames_fast(void *dst, size_t dst_frames, const void *src,
+    size_t src_frames, const pcm_format_t *sf, const pcm_format_t *df)
+{
+	const unsigned dch = df->channels;
+	const unsigned sch = sf->channels;
+	const size_t frames = min(dst_frames, src_frames);
+
+	if (dch != sch && sch != 1 && (sch != 2 || dch != 1))
+		return false;
+
+	if (df->sample_format == PCM_SAMPLE_SINT16_LE) {
+		if (sf->sample_format == PCM_SAMPLE_SINT16_LE) {
+			mix_frames_s16_s16(dst, src, frames, dch, sch);
+			return true;
+		}
+		if (sf->sample_format == PCM_SAMPLE_FLOAT32) {
+			mix_frames_s16_float(dst, src, frames, dch, sch);
+			return true;
+		}
+	}
+
+	if (df->sample_format == PCM_SAMPLE_FLOAT32) {
+		if (sf->sample_format == PCM_SAMPLE_SINT16_LE) {
+			mix_frames_float_s16(dst, src, frames, dch, sch);
+			return true;
+		}
+		if (sf->sample_format == PCM_SAMPLE_FLOAT32) {
+			mix_frames_float_float(dst, src, frames, dch, sch);
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * Add and mix audio data.
  * @param dst Destination audio buffer
@@ -189,6 +302,10 @@ errno_t pcm_format_convert_and_mix(void *dst, size_t dst_size, const void *src,
 	if ((dst_size % dst_frame_size) != 0)
 		return EINVAL;
 
+	if (mix_frames_fast(dst, dst_size / dst_frame_size, src,
+	    src_size / src_frame_size, sf, df))
+		return EOK;
+
 	/*
 	 * This is so ugly it eats kittens, and puppies, and ducklings,
 	 * and all little fluffy things...
@@ -251,11 +368,19 @@ do { \
 	case PCM_SAMPLE_SINT32_BE:
 		LOOP_ADD(int32_t, be, INT32_MIN, INT32_MAX);
 		break;
+	case PCM_SAMPLE_FLOAT32:
+		for (size_t i = 0; i < dst_size / dst_frame_size; ++i) {
+			for (unsigned j = 0; j < df->channels; ++j) {
+				mix_normalized_sample(dst, dst_size, i, j, df,
+				    get_normalized_sample(src, src_size, i, j,
+				    sf));
+			}
+		}
+		break;
 	case PCM_SAMPLE_UINT24_LE:
 	case PCM_SAMPLE_SINT24_LE:
 	case PCM_SAMPLE_UINT24_BE:
 	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
 	default:
 		return ENOTSUP;
 	}
@@ -320,17 +445,292 @@ do { \
 	case PCM_SAMPLE_SINT24_32_BE:
 	case PCM_SAMPLE_SINT32_BE:
 		GET(int32_t, le, INT32_MIN, INT32_MAX);
+	case PCM_SAMPLE_FLOAT32: {
+		const float *src = buffer;
+		const size_t sample_pos = frame * f->channels + channel;
+		if (sample_pos >= size / sizeof(float))
+			return 0.0f;
+		return clamp_float(float_le2host(src[sample_pos]));
+	}
 	case PCM_SAMPLE_UINT24_LE:
 	case PCM_SAMPLE_SINT24_LE:
 	case PCM_SAMPLE_UINT24_BE:
 	case PCM_SAMPLE_SINT24_BE:
-	case PCM_SAMPLE_FLOAT32:
 	default:
 		break;
 	}
 	return 0;
 #undef GET
 }
+
+/**
+ * Add a normalized value to a sample in any supported format.
+ * @param buffer Audio data
+ * @param size Size of the buffer
+ * @param frame Index of the frame to modify
+ * @param channel Channel within the frame
+ * @param f Pointer to a format descriptor
+ * @param value Normalized value <-1,1> to add
+ */
+static void mix_normalized_sample(void *buffer, size_t size, unsigned frame,
+    unsigned channel, const pcm_format_t *f, float value)
+{
+	const size_t sample_pos = frame * f->channels + channel;
+	float c = clamp_float(
+	    get_normalized_sample(buffer, size, frame, channel, f) + value);
+
+#define SET(type, endian, low, high) \
+do { \
+	type *dst = buffer; \
+	if (sample_pos < size / sizeof(type)) { \
+		c += 1.0; \
+		c *= ((float)(type)high - (float)(type)low) / 2; \
+		c += (float)(type)low; \
+		dst[sample_pos] = to((type)c, type, endian); \
+	} \
+} while (0)
+
+	switch (f->sample_format) {
+	case PCM_SAMPLE_UINT8:
+		SET(uint8_t, le, UINT8_MIN, UINT8_MAX);
+		break;
+	case PCM_SAMPLE_SINT8:
+		SET(uint8_t, le, INT8_MIN, INT8_MAX);
+		break;
+	case PCM_SAMPLE_UINT16_LE:
+		SET(uint16_t, le, UINT16_MIN, UINT16_MAX);
+		break;
+	case PCM_SAMPLE_SINT16_LE:
+		SET(int16_t, le, INT16_MIN, INT16_MAX);
+		break;
+	case PCM_SAMPLE_UINT16_BE:
+		SET(uint16_t, be, UINT16_MIN, UINT16_MAX);
+		break;
+	case PCM_SAMPLE_SINT16_BE:
+		SET(int16_t, be, INT16_MIN, INT16_MAX);
+		break;
+	case PCM_SAMPLE_UINT24_32_LE:
+	case PCM_SAMPLE_UINT32_LE:
+		SET(uint32_t, le, UINT32_MIN, UINT32_MAX);
+		break;
+	case PCM_SAMPLE_SINT24_32_LE:
+	case PCM_SAMPLE_SINT32_LE:
+		SET(int32_t, le, INT32_MIN, INT32_MAX);
+		break;
+	case PCM_SAMPLE_UINT24_32_BE:
+	case PCM_SAMPLE_UINT32_BE:
+		SET(uint32_t, be, UINT32_MIN, UINT32_MAX);
+		break;
+	case PCM_SAMPLE_SINT24_32_BE:
+	case PCM_SAMPLE_SINT32_BE:
+		SET(int32_t, be, INT32_MIN, INT32_MAX);
+		break;
+	case PCM_SAMPLE_FLOAT32:
+		if (sample_pos < size / sizeof(float))
+			((float *) buffer)[sample_pos] = host2float_le(c);
+		break;
+	case PCM_SAMPLE_UINT24_LE:
+	case PCM_SAMPLE_SINT24_LE:
+	case PCM_SAMPLE_UINT24_BE:
+	case PCM_SAMPLE_SINT24_BE:
+	default:
+		break;
+	}
+#undef SET
+}
+
+/* Sample rate conversion */
+
+#define RESAMPLER_ONE  ((uint64_t) 1 << 32)
+#define RESAMPLER_PI  3.14159265358979323846
+
+/**
+ * Sine for the filter design, so that the library does not need libm.
+ * @param x Angle in radians
+ * @return Sine of @p x
+ */
+static double resampler_sin(double x)
+{
+	while (x > RESAMPLER_PI)
+		x -= 2 * RESAMPLER_PI;
+	while (x < -RESAMPLER_PI)
+		x += 2 * RESAMPLER_PI;
+
+	const double x2 = x * x;
+	double term = x;
+	double sum = x;
+	for (unsigned n = 1; n < 10; ++n) {
+		term *= -x2 / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+/**
+ * Windowed sinc low pass filter.
+ * @param x Distance from the filter center in source frames
+ * @param cutoff Cutoff frequency relative to the source Nyquist frequency
+ * @return Filter response at @p x
+ */
+static double resampler_kernel(double x, double cutoff)
+{
+	const double half = PCM_RESAMPLER_TAPS / 2;
+	if (x <= -half || x >= half)
+		return 0.0;
+
+	/* Hann window */
+	const double window =
+	    0.5 + 0.5 * resampler_sin(RESAMPLER_PI * x / half +
+	    RESAMPLER_PI / 2);
+
+	const double arg = RESAMPLER_PI * cutoff * x;
+	if (arg == 0.0)
+		return cutoff * window;
+	return cutoff * resampler_sin(arg) / arg * window;
+}
+
+/**
+ * Initialize a sample rate converter.
+ * @param r Resampler to initialize.
+ * @param src_rate Source sampling rate.
+ * @param dst_rate Destination sampling rate.
+ * @param channels Number of source channels.
+ * @return Error code.
+ *
+ * Filter coefficients are computed here once for all phases, converting
+ * the data is a plain multiply and add loop afterwards. When down-sampling
+ * the cutoff is lowered to the destination Nyquist frequency.
+ */
+errno_t pcm_resampler_init(pcm_resampler_t *r, unsigned src_rate,
+    unsigned dst_rate, unsigned channels)
+{
+	assert(r);
+	if (src_rate == 0 || dst_rate == 0 || channels == 0 ||
+	    channels > PCM_RESAMPLER_CHANNELS)
+		return EINVAL;
+
+	r->src_rate = src_rate;
+	r->dst_rate = dst_rate;
+	r->channels = channels;
+	r->step = ((uint64_t) src_rate << 32) / dst_rate;
+	r->phase = RESAMPLER_ONE;
+	r->pos = 0;
+
+	for (unsigned c = 0; c < PCM_RESAMPLER_CHANNELS; ++c) {
+		for (unsigned k = 0; k < 2 * PCM_RESAMPLER_TAPS; ++k)
+			r->history[c][k] = 0.0f;
+	}
+
+	/* Leave some room for the transition band */
+	double cutoff = 0.95;
+	if (dst_rate < src_rate)
+		cutoff = cutoff * dst_rate / src_rate;
+
+	for (unsigned p = 0; p < PCM_RESAMPLER_PHASES; ++p) {
+		const double frac = (double) p / PCM_RESAMPLER_PHASES;
+		double coef[PCM_RESAMPLER_TAPS];
+		double sum = 0.0;
+
+		for (unsigned k = 0; k < PCM_RESAMPLER_TAPS; ++k) {
+			const double x =
+			    (double) k - (PCM_RESAMPLER_TAPS / 2 - 1) - frac;
+			coef[k] = resampler_kernel(x, cutoff);
+			sum += coef[k];
+		}
+
+		/* Keep unity gain for DC */
+		for (unsigned k = 0; k < PCM_RESAMPLER_TAPS; ++k)
+			r->coef[p][k] = coef[k] / sum;
+	}
+
+	return EOK;
+}
+
+/**
+ * Convert sampling rate of audio data and mix it into a buffer.
+ * @param r Resampler, initialized for the source and destination rates.
+ * @param dst Destination audio buffer
+ * @param dst_size Size of the destination buffer
+ * @param src Source audio buffer
+ * @param src_size Size of the source buffer.
+ * @param sf Pointer to the source format descriptor.
+ * @param df Pointer to the destination format descriptor.
+ * @param dst_used Place to store the size of the destination data produced.
+ * @param src_used Place to store the size of the source data consumed.
+ * @return Error code.
+ *
+ * Conversion stops when either the destination buffer is full or
+ * the source data run out. The resampler keeps history of the source
+ * so that the next call continues seamlessly.
+ */
+errno_t pcm_resample_and_mix(pcm_resampler_t *r, void *dst, size_t dst_size,
+    const void *src, size_t src_size, const pcm_format_t *sf,
+    const pcm_format_t *df, size_t *dst_used, size_t *src_used)
+{
+	if (!r || !dst || !src || !sf || !df)
+		return EINVAL;
+	if (sf->channels != r->channels)
+		return EINVAL;
+
+	const size_t src_frame_size = pcm_format_frame_size(sf);
+	const size_t dst_frame_size = pcm_format_frame_size(df);
+	const size_t src_frames = src_size / src_frame_size;
+	const size_t dst_frames = dst_size / dst_frame_size;
+	const unsigned sch = sf->channels;
+	const unsigned dch = df->channels;
+	float value[PCM_RESAMPLER_CHANNELS];
+	size_t si = 0;
+	size_t di = 0;
+
+	while (di < dst_frames) {
+		/* Feed source frames up to the position of the output */
+		while (r->phase >= RESAMPLER_ONE && si < src_frames) {
+			for (unsigned c = 0; c < sch; ++c) {
+				const float s = get_normalized_sample(src,
+				    src_size, si, c, sf);
+				r->history[c][r->pos] = s;
+				r->history[c][r->pos + PCM_RESAMPLER_TAPS] = s;
+			}
+			r->pos = (r->pos + 1) % PCM_RESAMPLER_TAPS;
+			r->phase -= RESAMPLER_ONE;
+			++si;
+		}
+		if (r->phase >= RESAMPLER_ONE)
+			break;
+
+		const float *coef =
+		    r->coef[(r->phase * PCM_RESAMPLER_PHASES) >> 32];
+		for (unsigned c = 0; c < sch; ++c) {
+			const float *h = &r->history[c][r->pos];
+			float acc = 0.0f;
+			for (unsigned k = 0; k < PCM_RESAMPLER_TAPS; ++k)
+				acc += h[k] * coef[k];
+			value[c] = acc;
+		}
+
+		for (unsigned j = 0; j < dch; ++j) {
+			float v;
+			if (dch == 1 && sch >= 2)
+				v = (value[0] + value[1]) / 2;
+			else if (sch == 1)
+				v = value[0];
+			else if (j < sch)
+				v = value[j];
+			else
+				continue;
+			mix_normalized_sample(dst, dst_size, di, j, df, v);
+		}
+
+		r->phase += r->step;
+		++di;
+	}
+
+	if (dst_used)
+		*dst_used = di * dst_frame_size;
+	if (src_used)
+		*src_used = si * src_frame_size;
+	return EOK;
+}
 /**
  * @}
  */
@@ -88,8 +88,23 @@
 #undef FD_CLOEXEC
 #define FD_CLOEXEC         1 /* Close on exec. */
 
+/* Advice used with posix_fadvise(). */
+#undef POSIX_FADV_NORMAL
+#undef POSIX_FADV_SEQUENTIAL
+#undef POSIX_FADV_RANDOM
+#undef POSIX_FADV_WILLNEED
+#undef POSIX_FADV_DONTNEED
+#undef POSIX_FADV_NOREUSE
+#define POSIX_FADV_NORMAL      0 /* No particular access pattern. */
+#define POSIX_FADV_SEQUENTIAL  1 /* Sequential access. */
+#define POSIX_FADV_RANDOM      2 /* Random access. */
+#define POSIX_FADV_WILLNEED    3 /* Data will be accessed soon. */
+#define POSIX_FADV_DONTNEED    4 /* Data will not be accessed soon. */
+#define POSIX_FADV_NOREUSE     5 /* Data will be accessed only once. */
+
 extern int open(const char *pathname, int flags, ...);
 extern int fcntl(int fd, int cmd, ...);
+extern int posix_fadvise(int fd, off_t offset, off_t len, int advice);
 
 #endif /* POSIX_FCNTL_H_ */
 
@@ -41,6 +41,10 @@
 #define PATH_MAX 256
 #endif
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
 #endif /* POSIX_LIMITS_H_ */
 
 /** @}
@@ -33,25 +33,46 @@
 #define POSIX_PTHREAD_H_
 
 #include <time.h>
+#include <libc/fibril_synch.h>
 
 typedef void *pthread_t;
 
+#define PTHREAD_CREATE_JOINABLE 0
+#define PTHREAD_CREATE_DETACHED 1
+
 typedef struct {
-	int dummy;
+	int detachstate;
+	size_t stacksize;
 } pthread_attr_t;
 
 typedef int pthread_key_t;
 
+#define PTHREAD_MUTEX_NORMAL 0
 #define PTHREAD_MUTEX_RECURSIVE 1
+#define PTHREAD_MUTEX_ERRORCHECK 2
+#define PTHREAD_MUTEX_DEFAULT PTHREAD_MUTEX_NORMAL
+
+/*
+ * Fibril synchronization primitives cannot be initialized statically
+ * without knowing the name of the object, so objects set up by the static
+ * initializers below are initialized on first use.
+ */
 
 typedef struct pthread_mutex {
-	int dummy;
+	/** Non-zero once @c mutex has been initialized */
+	int initialized;
+	int type;
+	/** Owning fibril */
+	pthread_t owner;
+	/** Recursion depth of a recursive mutex */
+	unsigned int count;
+	fibril_mutex_t mutex;
 } pthread_mutex_t;
 
 #define PTHREAD_MUTEX_INITIALIZER { 0 }
 
 typedef struct {
-	int dummy;
+	int type;
 } pthread_mutexattr_t;
 
 typedef struct {
@@ -59,20 +80,45 @@ typedef struct {
 } pthread_condattr_t;
 
 typedef struct {
-	int dummy;
+	/** Non-zero once @c cv has been initialized */
+	int initialized;
+	fibril_condvar_t cv;
 } pthread_cond_t;
 
 #define PTHREAD_COND_INITIALIZER { 0 }
 
+typedef struct {
+	int dummy;
+} pthread_rwlockattr_t;
+
+typedef struct {
+	/** Non-zero once @c rwlock has been initialized */
+	int initialized;
+	fibril_rwlock_t rwlock;
+} pthread_rwlock_t;
+
+#define PTHREAD_RWLOCK_INITIALIZER { 0 }
+
+#define PTHREAD_PROCESS_PRIVATE 0
+#define PTHREAD_PROCESS_SHARED 1
+
+typedef int pthread_spinlock_t;
+
 extern pthread_t pthread_self(void);
 extern int pthread_equal(pthread_t, pthread_t);
 extern int pthread_create(pthread_t *, const pthread_attr_t *,
     void *(*)(void *), void *);
 extern int pthread_join(pthread_t, void **);
 extern int pthread_detach(pthread_t);
+extern __noreturn void pthread_exit(void *);
 
 extern int pthread_attr_init(pthread_attr_t *);
 extern int pthread_attr_destroy(pthread_attr_t *);
+extern int pthread_attr_getdetachstate(const pthread_attr_t *, int *);
+extern int pthread_attr_setdetachstate(pthread_attr_t *, int);
+extern int pthread_attr_getstacksize(const pthread_attr_t *__restrict__,
+    size_t *__restrict__);
+extern int pthread_attr_setstacksize(pthread_attr_t *, size_t);
 
 extern int pthread_mutex_init(pthread_mutex_t *__restrict__,
     const pthread_mutexattr_t *__restrict__);
@@ -100,6 +146,24 @@ extern int pthread_cond_wait(pthread_cond_t *__restrict__,
 extern int pthread_condattr_destroy(pthread_condattr_t *);
 extern int pthread_condattr_init(pthread_condattr_t *);
 
+extern int pthread_rwlock_init(pthread_rwlock_t *__restrict__,
+    const pthread_rwlockattr_t *__restrict__);
+extern int pthread_rwlock_destroy(pthread_rwlock_t *);
+extern int pthread_rwlock_rdlock(pthread_rwlock_t *);
+extern int pthread_rwlock_tryrdlock(pthread_rwlock_t *);
+extern int pthread_rwlock_wrlock(pthread_rwlock_t *);
+extern int pthread_rwlock_trywrlock(pthread_rwlock_t *);
+extern int pthread_rwlock_unlock(pthread_rwlock_t *);
+
+extern int pthread_rwlockattr_init(pthread_rwlockattr_t *);
+extern int pthread_rwlockattr_destroy(pthread_rwlockattr_t *);
+
+extern int pthread_spin_init(pthread_spinlock_t *, int);
+extern int pthread_spin_destroy(pthread_spinlock_t *);
+extern int pthread_spin_lock(pthread_spinlock_t *);
+extern int pthread_spin_trylock(pthread_spinlock_t *);
+extern int pthread_spin_unlock(pthread_spinlock_t *);
+
 extern void *pthread_getspecific(pthread_key_t);
 extern int pthread_setspecific(pthread_key_t, const void *);
 extern int pthread_key_delete(pthread_key_t);
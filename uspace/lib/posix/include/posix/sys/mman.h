@@ -46,6 +46,10 @@
 #define MAP_ANONYMOUS  (1 << 3)
 #define MAP_ANON MAP_ANONYMOUS
 
+#define MS_ASYNC       (1 << 0)
+#define MS_SYNC        (1 << 1)
+#define MS_INVALIDATE  (1 << 2)
+
 #undef PROT_NONE
 #undef PROT_READ
 #undef PROT_WRITE
@@ -58,6 +62,7 @@
 extern void *mmap(void *start, size_t length, int prot, int flags, int fd,
     off_t offset);
 extern int munmap(void *start, size_t length);
+extern int msync(void *start, size_t length, int flags);
 
 #endif /* POSIX_SYS_MMAN_H_ */
 
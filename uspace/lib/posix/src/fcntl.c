@@ -159,5 +159,33 @@ int open(const char *pathname, int posix_flags, ...)
 	return file;
 }
 
+/**
+ * Advise about the expected access pattern of file data.
+ *
+ * File descriptors do no caching of their own, so the advice is only
+ * validated. Streams take advice through fadvise().
+ *
+ * @param fd File descriptor of the opened file.
+ * @param offset Start of the range the advice applies to.
+ * @param len Length of the range, zero meaning up to the end of the file.
+ * @param advice One of POSIX_FADV_*.
+ * @return Zero on success, error number on failure.
+ */
+int posix_fadvise(int fd, off_t offset, off_t len, int advice)
+{
+	vfs_stat_t st;
+
+	if (offset < 0 || len < 0)
+		return EINVAL;
+
+	if (advice < POSIX_FADV_NORMAL || advice > POSIX_FADV_NOREUSE)
+		return EINVAL;
+
+	if (vfs_stat(fd, &st) != EOK)
+		return EBADF;
+
+	return 0;
+}
+
 /** @}
  */
@@ -30,61 +30,135 @@
  * @{
  */
 /** @file Pthread: condition variables.
+ *
+ * Condition variables are fibril condition variables.
  */
 
 #include <pthread.h>
 #include <errno.h>
+#include <time.h>
 #include "../internal/common.h"
 
+/** Serializes lazy initialization of statically initialized condvars */
+static FIBRIL_MUTEX_INITIALIZE(cond_init_lock);
+
+/** Make sure a condition variable is initialized.
+ *
+ * Condition variables initialized with PTHREAD_COND_INITIALIZER are set
+ * up here on first use.
+ */
+static void cond_init_once(pthread_cond_t *condvar)
+{
+	if (__atomic_load_n(&condvar->initialized, __ATOMIC_ACQUIRE))
+		return;
+
+	fibril_mutex_lock(&cond_init_lock);
+	if (!condvar->initialized) {
+		fibril_condvar_initialize(&condvar->cv);
+		__atomic_store_n(&condvar->initialized, 1, __ATOMIC_RELEASE);
+	}
+	fibril_mutex_unlock(&cond_init_lock);
+}
+
+/** Wait for a condition variable with a relative timeout.
+ *
+ * The mutex gives up its ownership and recursion depth for the time of
+ * the wait and gets them back once it is relocked.
+ *
+ * @param condvar Condition variable
+ * @param mutex   Mutex locked by the caller
+ * @param timeout Timeout in microseconds, zero to wait forever
+ * @return 0 on success, EPERM if the caller does not own the mutex or
+ *         ETIMEDOUT if the timeout expired
+ */
+static int cond_wait(pthread_cond_t *condvar, pthread_mutex_t *mutex,
+    usec_t timeout)
+{
+	unsigned int count;
+	errno_t rc;
+
+	if (mutex->owner != pthread_self())
+		return EPERM;
+
+	cond_init_once(condvar);
+
+	count = mutex->count;
+	__atomic_store_n(&mutex->owner, NULL, __ATOMIC_RELAXED);
+	mutex->count = 0;
+
+	rc = fibril_condvar_wait_timeout(&condvar->cv, &mutex->mutex,
+	    timeout);
+
+	__atomic_store_n(&mutex->owner, pthread_self(), __ATOMIC_RELAXED);
+	mutex->count = count;
+
+	return rc == ETIMEOUT ? ETIMEDOUT : 0;
+}
+
 int pthread_cond_init(pthread_cond_t *restrict condvar,
     const pthread_condattr_t *restrict attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	fibril_condvar_initialize(&condvar->cv);
+	condvar->initialized = 1;
+	return 0;
 }
 
 int pthread_cond_destroy(pthread_cond_t *condvar)
 {
-	not_implemented();
-	return ENOTSUP;
+	if (condvar->initialized && !list_empty(&condvar->cv.waiters))
+		return EBUSY;
+
+	condvar->initialized = 0;
+	return 0;
 }
 
 int pthread_cond_broadcast(pthread_cond_t *condvar)
 {
-	not_implemented();
-	return ENOTSUP;
+	cond_init_once(condvar);
+	fibril_condvar_broadcast(&condvar->cv);
+	return 0;
 }
 
 int pthread_cond_signal(pthread_cond_t *condvar)
 {
-	not_implemented();
-	return ENOTSUP;
+	cond_init_once(condvar);
+	fibril_condvar_signal(&condvar->cv);
+	return 0;
 }
 
 int pthread_cond_timedwait(pthread_cond_t *restrict condvar,
     pthread_mutex_t *restrict mutex, const struct timespec *restrict timeout)
 {
-	not_implemented();
-	return ENOTSUP;
+	struct timespec now;
+	nsec_t diff;
+
+	if (timeout->tv_nsec < 0 || timeout->tv_nsec >= 1000000000)
+		return EINVAL;
+
+	/* The timeout is an absolute time of the realtime clock */
+	clock_gettime(CLOCK_REALTIME, &now);
+	diff = ts_sub_diff(timeout, &now);
+	if (diff <= 0)
+		return mutex->owner == pthread_self() ? ETIMEDOUT : EPERM;
+
+	/* Zero would mean no timeout at all */
+	return cond_wait(condvar, mutex, NSEC2USEC(diff) + 1);
 }
 
 int pthread_cond_wait(pthread_cond_t *restrict condvar,
     pthread_mutex_t *restrict mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	return cond_wait(condvar, mutex, 0);
 }
 
 int pthread_condattr_init(pthread_condattr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	return 0;
 }
 
 int pthread_condattr_destroy(pthread_condattr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	return 0;
 }
 
 /** @}
@@ -30,35 +30,44 @@
  * @{
  */
 /** @file Pthread: keys and thread-specific storage.
+ *
+ * Keys are fibril keys, so thread-specific values are fibril-local.
  */
 
 #include <stdlib.h>
 #include <pthread.h>
 #include <errno.h>
+#include <fibril.h>
 #include "../internal/common.h"
 
 void *pthread_getspecific(pthread_key_t key)
 {
-	not_implemented();
-	return NULL;
+	return fibril_key_get(key);
 }
 
 int pthread_setspecific(pthread_key_t key, const void *data)
 {
-	not_implemented();
-	return ENOTSUP;
+	fibril_key_set(key, (void *) data);
+	return 0;
 }
 
 int pthread_key_delete(pthread_key_t key)
 {
-	not_implemented();
-	return ENOTSUP;
+	fibril_key_delete(key);
+	return 0;
 }
 
 int pthread_key_create(pthread_key_t *key, void (*destructor)(void *))
 {
-	not_implemented();
-	return ENOTSUP;
+	fibril_key_t fkey;
+	errno_t rc;
+
+	rc = fibril_key_create(&fkey, destructor);
+	if (rc != EOK)
+		return rc;
+
+	*key = fkey;
+	return 0;
 }
 
 /** @}
@@ -30,66 +30,153 @@
  * @{
  */
 /** @file Pthread: mutexes.
+ *
+ * Mutexes are fibril mutexes. Recursive and error-checking mutexes also
+ * track their owning fibril.
  */
 
 #include <pthread.h>
 #include <errno.h>
+#include <fibril.h>
 #include "../internal/common.h"
 
+/** Serializes lazy initialization of statically initialized mutexes */
+static FIBRIL_MUTEX_INITIALIZE(mutex_init_lock);
+
+/** Make sure a mutex is initialized.
+ *
+ * Mutexes initialized with PTHREAD_MUTEX_INITIALIZER are set up here
+ * on first use.
+ */
+static void mutex_init_once(pthread_mutex_t *mutex)
+{
+	if (__atomic_load_n(&mutex->initialized, __ATOMIC_ACQUIRE))
+		return;
+
+	fibril_mutex_lock(&mutex_init_lock);
+	if (!mutex->initialized) {
+		fibril_mutex_initialize(&mutex->mutex);
+		mutex->owner = NULL;
+		mutex->count = 0;
+		__atomic_store_n(&mutex->initialized, 1, __ATOMIC_RELEASE);
+	}
+	fibril_mutex_unlock(&mutex_init_lock);
+}
+
+/** Check whether the current fibril owns a non-normal mutex. */
+static bool mutex_owned(pthread_mutex_t *mutex)
+{
+	return __atomic_load_n(&mutex->owner, __ATOMIC_RELAXED) ==
+	    pthread_self();
+}
+
+/** Record the current fibril as the owner of a freshly locked mutex. */
+static void mutex_set_owner(pthread_mutex_t *mutex)
+{
+	__atomic_store_n(&mutex->owner, pthread_self(), __ATOMIC_RELAXED);
+	mutex->count = 1;
+}
+
 int pthread_mutex_init(pthread_mutex_t *restrict mutex,
     const pthread_mutexattr_t *restrict attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	mutex->type = attr != NULL ? attr->type : PTHREAD_MUTEX_DEFAULT;
+	mutex->owner = NULL;
+	mutex->count = 0;
+	fibril_mutex_initialize(&mutex->mutex);
+	mutex->initialized = 1;
+	return 0;
 }
 
 int pthread_mutex_destroy(pthread_mutex_t *mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	if (mutex->initialized && mutex->owner != NULL)
+		return EBUSY;
+
+	mutex->initialized = 0;
+	return 0;
 }
 
 int pthread_mutex_lock(pthread_mutex_t *mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	mutex_init_once(mutex);
+
+	if (mutex->type != PTHREAD_MUTEX_NORMAL && mutex_owned(mutex)) {
+		if (mutex->type == PTHREAD_MUTEX_ERRORCHECK)
+			return EDEADLK;
+
+		mutex->count++;
+		return 0;
+	}
+
+	fibril_mutex_lock(&mutex->mutex);
+	mutex_set_owner(mutex);
+	return 0;
 }
 
 int pthread_mutex_trylock(pthread_mutex_t *mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	mutex_init_once(mutex);
+
+	if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex_owned(mutex)) {
+		mutex->count++;
+		return 0;
+	}
+
+	if (!fibril_mutex_trylock(&mutex->mutex))
+		return EBUSY;
+
+	mutex_set_owner(mutex);
+	return 0;
 }
 
 int pthread_mutex_unlock(pthread_mutex_t *mutex)
 {
-	not_implemented();
-	return ENOTSUP;
+	mutex_init_once(mutex);
+
+	if (mutex->type != PTHREAD_MUTEX_NORMAL) {
+		if (!mutex_owned(mutex))
+			return EPERM;
+
+		if (--mutex->count > 0)
+			return 0;
+	}
+
+	__atomic_store_n(&mutex->owner, NULL, __ATOMIC_RELAXED);
+	mutex->count = 0;
+	fibril_mutex_unlock(&mutex->mutex);
+	return 0;
 }
 
 int pthread_mutexattr_init(pthread_mutexattr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	attr->type = PTHREAD_MUTEX_DEFAULT;
+	return 0;
 }
 
 int pthread_mutexattr_destroy(pthread_mutexattr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	return 0;
 }
 
 int pthread_mutexattr_gettype(const pthread_mutexattr_t *restrict attr,
     int *restrict type)
 {
-	not_implemented();
-	return ENOTSUP;
+	*type = attr->type;
+	return 0;
 }
 
 int pthread_mutexattr_settype(pthread_mutexattr_t *attr, int type)
 {
-	not_implemented();
-	return ENOTSUP;
+	switch (type) {
+	case PTHREAD_MUTEX_NORMAL:
+	case PTHREAD_MUTEX_RECURSIVE:
+	case PTHREAD_MUTEX_ERRORCHECK:
+		attr->type = type;
+		return 0;
+	default:
+		return EINVAL;
+	}
 }
 
 /** @}
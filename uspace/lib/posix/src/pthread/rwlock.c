@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libposix
+ * @{
+ */
+/** @file Pthread: read-write locks.
+ *
+ * Read-write locks are fibril rwlocks.
+ */
+
+#include <pthread.h>
+#include <errno.h>
+#include "../internal/common.h"
+
+/** Serializes lazy initialization of statically initialized rwlocks */
+static FIBRIL_MUTEX_INITIALIZE(rwlock_init_lock);
+
+/** Make sure a read-write lock is initialized.
+ *
+ * Read-write locks initialized with PTHREAD_RWLOCK_INITIALIZER are set
+ * up here on first use.
+ */
+static void rwlock_init_once(pthread_rwlock_t *rwlock)
+{
+	if (__atomic_load_n(&rwlock->initialized, __ATOMIC_ACQUIRE))
+		return;
+
+	fibril_mutex_lock(&rwlock_init_lock);
+	if (!rwlock->initialized) {
+		fibril_rwlock_initialize(&rwlock->rwlock);
+		__atomic_store_n(&rwlock->initialized, 1, __ATOMIC_RELEASE);
+	}
+	fibril_mutex_unlock(&rwlock_init_lock);
+}
+
+int pthread_rwlock_init(pthread_rwlock_t *restrict rwlock,
+    const pthread_rwlockattr_t *restrict attr)
+{
+	fibril_rwlock_initialize(&rwlock->rwlock);
+	rwlock->initialized = 1;
+	return 0;
+}
+
+int pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
+{
+	if (rwlock->initialized && fibril_rwlock_is_locked(&rwlock->rwlock))
+		return EBUSY;
+
+	rwlock->initialized = 0;
+	return 0;
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
+{
+	rwlock_init_once(rwlock);
+
+	if (fibril_rwlock_is_write_locked(&rwlock->rwlock))
+		return EDEADLK;
+
+	fibril_rwlock_read_lock(&rwlock->rwlock);
+	return 0;
+}
+
+int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
+{
+	rwlock_init_once(rwlock);
+
+	if (!fibril_rwlock_try_read_lock(&rwlock->rwlock))
+		return EBUSY;
+
+	return 0;
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
+{
+	rwlock_init_once(rwlock);
+
+	if (fibril_rwlock_is_write_locked(&rwlock->rwlock))
+		return EDEADLK;
+
+	fibril_rwlock_write_lock(&rwlock->rwlock);
+	return 0;
+}
+
+int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
+{
+	rwlock_init_once(rwlock);
+
+	if (!fibril_rwlock_try_write_lock(&rwlock->rwlock))
+		return EBUSY;
+
+	return 0;
+}
+
+int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
+{
+	rwlock_init_once(rwlock);
+
+	if (fibril_rwlock_is_write_locked(&rwlock->rwlock)) {
+		fibril_rwlock_write_unlock(&rwlock->rwlock);
+		return 0;
+	}
+
+	if (!fibril_rwlock_is_read_locked(&rwlock->rwlock))
+		return EPERM;
+
+	fibril_rwlock_read_unlock(&rwlock->rwlock);
+	return 0;
+}
+
+int pthread_rwlockattr_init(pthread_rwlockattr_t *attr)
+{
+	return 0;
+}
+
+int pthread_rwlockattr_destroy(pthread_rwlockattr_t *attr)
+{
+	return 0;
+}
+
+/** @}
+ */
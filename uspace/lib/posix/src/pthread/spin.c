@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libposix
+ * @{
+ */
+/** @file Pthread: spin locks.
+ *
+ * Fibrils are scheduled cooperatively, so the holder of a spin lock may be
+ * a fibril waiting to run on the same thread. A fibril that has been
+ * spinning for a while therefore yields to let the holder finish.
+ */
+
+#include <pthread.h>
+#include <errno.h>
+#include <fibril.h>
+#include "../internal/common.h"
+
+/** Number of failed attempts to take a spin lock before yielding */
+#define SPIN_YIELD_COUNT 100
+
+int pthread_spin_init(pthread_spinlock_t *lock, int pshared)
+{
+	if (pshared != PTHREAD_PROCESS_PRIVATE)
+		return ENOTSUP;
+
+	__atomic_store_n(lock, 0, __ATOMIC_RELAXED);
+	return 0;
+}
+
+int pthread_spin_destroy(pthread_spinlock_t *lock)
+{
+	if (__atomic_load_n(lock, __ATOMIC_RELAXED) != 0)
+		return EBUSY;
+
+	return 0;
+}
+
+int pthread_spin_lock(pthread_spinlock_t *lock)
+{
+	unsigned int spins = 0;
+
+	while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0) {
+		/* Wait for the lock to look free before retrying */
+		while (__atomic_load_n(lock, __ATOMIC_RELAXED) != 0) {
+			if (++spins == SPIN_YIELD_COUNT) {
+				fibril_yield();
+				spins = 0;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int pthread_spin_trylock(pthread_spinlock_t *lock)
+{
+	if (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE) != 0)
+		return EBUSY;
+
+	return 0;
+}
+
+int pthread_spin_unlock(pthread_spinlock_t *lock)
+{
+	__atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/** @}
+ */
@@ -30,14 +30,89 @@
  * @{
  */
 /** @file Pthread: thread management.
+ *
+ * Threads are fibrils. Creating the first thread lets fibrils run on
+ * several kernel threads so that threads can use more than one CPU.
  */
 
 #include <pthread.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <fibril.h>
+#include <adt/list.h>
 #include "../internal/common.h"
 
+/** Thread created by pthread_create() */
+typedef struct {
+	/** Link to @c threads */
+	link_t lthreads;
+	fid_t fid;
+	void *(*start_routine)(void *);
+	void *arg;
+	/** Value returned by the thread */
+	void *retval;
+	/** The thread has finished */
+	bool done;
+	/** Nobody is going to join the thread */
+	bool detached;
+	/** A fibril is waiting to join the thread */
+	bool joined;
+} posix_thread_t;
+
+/** Protects @c threads and the threads in it */
+static FIBRIL_MUTEX_INITIALIZE(threads_lock);
+/** Signalled when a thread finishes */
+static FIBRIL_CONDVAR_INITIALIZE(threads_cv);
+/** Threads that have not been joined yet */
+static LIST_INITIALIZE(threads);
+
+/** Find a thread that has not been joined yet.
+ *
+ * @param id Thread ID
+ * @return Thread or @c NULL if there is no such thread
+ */
+static posix_thread_t *thread_find(pthread_t id)
+{
+	assert(fibril_mutex_is_locked(&threads_lock));
+
+	list_foreach(threads, lthreads, posix_thread_t, thread) {
+		if ((pthread_t) thread->fid == id)
+			return thread;
+	}
+
+	return NULL;
+}
+
+/** Record that a thread has finished and wake up its joiner.
+ *
+ * @param thread Thread
+ * @param retval Value returned by the thread
+ */
+static void thread_finish(posix_thread_t *thread, void *retval)
+{
+	fibril_mutex_lock(&threads_lock);
+
+	thread->retval = retval;
+	thread->done = true;
+
+	if (thread->detached) {
+		list_remove(&thread->lthreads);
+		free(thread);
+	} else {
+		fibril_condvar_broadcast(&threads_cv);
+	}
+
+	fibril_mutex_unlock(&threads_lock);
+}
+
+static errno_t thread_fibril(void *arg)
+{
+	posix_thread_t *thread = (posix_thread_t *) arg;
+
+	thread_finish(thread, thread->start_routine(thread->arg));
+	return EOK;
+}
+
 pthread_t pthread_self(void)
 {
 	return (pthread_t) fibril_get_id();
@@ -51,32 +126,152 @@ int pthread_equal(pthread_t thread1, pthread_t thread2)
 int pthread_create(pthread_t *thread_id, const pthread_attr_t *attributes,
     void *(*start_routine)(void *), void *arg)
 {
-	not_implemented();
-	return ENOTSUP;
+	posix_thread_t *thread;
+
+	thread = calloc(1, sizeof(posix_thread_t));
+	if (thread == NULL)
+		return EAGAIN;
+
+	thread->start_routine = start_routine;
+	thread->arg = arg;
+	if (attributes != NULL) {
+		thread->detached =
+		    attributes->detachstate == PTHREAD_CREATE_DETACHED;
+	}
+
+	if (attributes != NULL && attributes->stacksize != 0) {
+		thread->fid = fibril_create_generic(thread_fibril, thread,
+		    attributes->stacksize);
+	} else {
+		thread->fid = fibril_create(thread_fibril, thread);
+	}
+
+	if (thread->fid == 0) {
+		free(thread);
+		return EAGAIN;
+	}
+
+	fibril_enable_multithreaded();
+
+	fibril_mutex_lock(&threads_lock);
+	list_append(&thread->lthreads, &threads);
+	*thread_id = (pthread_t) thread->fid;
+	fibril_mutex_unlock(&threads_lock);
+
+	fibril_add_ready(thread->fid);
+	return 0;
 }
 
-int pthread_join(pthread_t thread, void **ret_val)
+int pthread_join(pthread_t thread_id, void **ret_val)
 {
-	not_implemented();
-	return ENOTSUP;
+	posix_thread_t *thread;
+
+	if (thread_id == pthread_self())
+		return EDEADLK;
+
+	fibril_mutex_lock(&threads_lock);
+
+	thread = thread_find(thread_id);
+	if (thread == NULL || thread->detached || thread->joined) {
+		fibril_mutex_unlock(&threads_lock);
+		return thread == NULL ? ESRCH : EINVAL;
+	}
+
+	/* Only one fibril may join a thread */
+	thread->joined = true;
+
+	while (!thread->done)
+		fibril_condvar_wait(&threads_cv, &threads_lock);
+
+	list_remove(&thread->lthreads);
+	fibril_mutex_unlock(&threads_lock);
+
+	if (ret_val != NULL)
+		*ret_val = thread->retval;
+
+	free(thread);
+	return 0;
 }
 
-int pthread_detach(pthread_t thread)
+int pthread_detach(pthread_t thread_id)
 {
-	not_implemented();
-	return ENOTSUP;
+	posix_thread_t *thread;
+
+	fibril_mutex_lock(&threads_lock);
+
+	thread = thread_find(thread_id);
+	if (thread == NULL || thread->detached || thread->joined) {
+		fibril_mutex_unlock(&threads_lock);
+		return thread == NULL ? ESRCH : EINVAL;
+	}
+
+	if (thread->done) {
+		list_remove(&thread->lthreads);
+		free(thread);
+	} else {
+		thread->detached = true;
+	}
+
+	fibril_mutex_unlock(&threads_lock);
+	return 0;
+}
+
+void pthread_exit(void *retval)
+{
+	posix_thread_t *thread;
+
+	fibril_mutex_lock(&threads_lock);
+	thread = thread_find(pthread_self());
+	fibril_mutex_unlock(&threads_lock);
+
+	if (thread != NULL)
+		thread_finish(thread, retval);
+
+	fibril_exit(0);
 }
 
 int pthread_attr_init(pthread_attr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	attr->detachstate = PTHREAD_CREATE_JOINABLE;
+	attr->stacksize = 0;
+	return 0;
 }
 
 int pthread_attr_destroy(pthread_attr_t *attr)
 {
-	not_implemented();
-	return ENOTSUP;
+	return 0;
+}
+
+int pthread_attr_getdetachstate(const pthread_attr_t *attr, int *state)
+{
+	*state = attr->detachstate;
+	return 0;
+}
+
+int pthread_attr_setdetachstate(pthread_attr_t *attr, int state)
+{
+	if (state != PTHREAD_CREATE_JOINABLE &&
+	    state != PTHREAD_CREATE_DETACHED)
+		return EINVAL;
+
+	attr->detachstate = state;
+	return 0;
+}
+
+int pthread_attr_getstacksize(const pthread_attr_t *restrict attr,
+    size_t *restrict size)
+{
+	*size = attr->stacksize;
+	return 0;
+}
+
+int pthread_attr_setstacksize(pthread_attr_t *attr, size_t size)
+{
+	if (size == 0)
+		return EINVAL;
+
+	attr->stacksize = size;
+	return 0;
 }
 
 /** @}
@@ -37,6 +37,7 @@
 #include <sys/types.h>
 #include <as.h>
 #include <unistd.h>
+#include <vfs/vfs.h>
 
 void *mmap(void *start, size_t length, int prot, int flags, int fd,
     off_t offset)
@@ -44,20 +45,31 @@ void *mmap(void *start, size_t length, int prot, int flags, int fd,
 	if (!start)
 		start = AS_AREA_ANY;
 
-#if 0
-	if (!((flags & MAP_SHARED) ^ (flags & MAP_PRIVATE)))
+	if (flags & MAP_ANONYMOUS)
+		return as_area_create(start, length, prot, AS_AREA_UNPAGED);
+
+	if (!((flags & MAP_SHARED) ^ (flags & MAP_PRIVATE)) || offset < 0) {
+		errno = EINVAL;
 		return MAP_FAILED;
-#endif
+	}
 
-	if (!(flags & MAP_ANONYMOUS))
+	void *addr;
+	errno_t rc = vfs_mmap(fd, offset, start, length,
+	    prot | AS_AREA_CACHEABLE, (flags & MAP_SHARED) != 0, &addr);
+	if (rc != EOK) {
+		errno = rc;
 		return MAP_FAILED;
+	}
 
-	return as_area_create(start, length, prot, AS_AREA_UNPAGED);
+	return addr;
 }
 
 int munmap(void *start, size_t length)
 {
-	int rc = as_area_destroy(start);
+	errno_t rc = vfs_munmap(start);
+	if (rc == ENOENT)
+		rc = as_area_destroy(start);
+
 	if (rc != EOK) {
 		errno = rc;
 		return -1;
@@ -65,5 +77,17 @@ int munmap(void *start, size_t length)
 	return 0;
 }
 
+int msync(void *start, size_t length, int flags)
+{
+	errno_t rc = vfs_msync(start);
+
+	/* Anonymous mappings have nothing to synchronize. */
+	if (rc != EOK && rc != ENOENT) {
+		errno = rc;
+		return -1;
+	}
+	return 0;
+}
+
 /** @}
  */
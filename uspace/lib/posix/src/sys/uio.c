@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libposix
+ * @{
+ */
+/** @file Vectored I/O.
+ */
+
+#include "../internal/common.h"
+#include <sys/uio.h>
+#include <sys/types.h>
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <vfs/vfs.h>
+
+static_assert(sizeof(struct iovec) == sizeof(vfs_iovec_t));
+static_assert(offsetof(struct iovec, iov_base) ==
+    offsetof(vfs_iovec_t, base));
+static_assert(offsetof(struct iovec, iov_len) ==
+    offsetof(vfs_iovec_t, len));
+
+/** Check the array of buffers passed to a vectored I/O function.
+ *
+ * @param iov Array of buffers.
+ * @param iovcnt Number of buffers.
+ * @return True if the array is valid, false with errno set otherwise.
+ */
+static bool iov_check(const struct iovec *iov, int iovcnt)
+{
+	size_t total = 0;
+
+	if (iovcnt <= 0 || iovcnt > IOV_MAX) {
+		errno = EINVAL;
+		return false;
+	}
+
+	for (int i = 0; i < iovcnt; i++) {
+		if (iov[i].iov_len > SSIZE_MAX - total) {
+			errno = EINVAL;
+			return false;
+		}
+
+		total += iov[i].iov_len;
+	}
+
+	return true;
+}
+
+/**
+ * Read from a file into several buffers.
+ *
+ * @param fildes File descriptor of the opened file.
+ * @param iov Buffers to which the read bytes shall be stored in turn.
+ * @param iovcnt Number of buffers.
+ * @return Number of read bytes on success, -1 otherwise.
+ */
+ssize_t readv(int fildes, const struct iovec *iov, int iovcnt)
+{
+	size_t nread;
+
+	if (!iov_check(iov, iovcnt))
+		return -1;
+
+	if (failed(vfs_readv(fildes, &posix_pos[fildes],
+	    (const vfs_iovec_t *) iov, iovcnt, &nread)))
+		return -1;
+
+	return (ssize_t) nread;
+}
+
+/**
+ * Write to a file from several buffers.
+ *
+ * @param fildes File descriptor of the opened file.
+ * @param iov Buffers to write in turn.
+ * @param iovcnt Number of buffers.
+ * @return Number of written bytes on success, -1 otherwise.
+ */
+ssize_t writev(int fildes, const struct iovec *iov, int iovcnt)
+{
+	size_t nwr;
+
+	if (!iov_check(iov, iovcnt))
+		return -1;
+
+	if (failed(vfs_writev(fildes, &posix_pos[fildes],
+	    (const vfs_iovec_t *) iov, iovcnt, &nwr)))
+		return -1;
+
+	return (ssize_t) nwr;
+}
+
+/**
+ * Read from a given position in a file into several buffers.
+ *
+ * The file offset is not changed.
+ *
+ * @param fildes File descriptor of the opened file.
+ * @param iov Buffers to which the read bytes shall be stored in turn.
+ * @param iovcnt Number of buffers.
+ * @param offset Position in the file to read from.
+ * @return Number of read bytes on success, -1 otherwise.
+ */
+ssize_t preadv(int fildes, const struct iovec *iov, int iovcnt, off_t offset)
+{
+	aoff64_t pos = offset;
+	size_t nread;
+
+	if (offset < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (!iov_check(iov, iovcnt))
+		return -1;
+
+	if (failed(vfs_readv(fildes, &pos, (const vfs_iovec_t *) iov, iovcnt,
+	    &nread)))
+		return -1;
+
+	return (ssize_t) nread;
+}
+
+/**
+ * Write to a given position in a file from several buffers.
+ *
+ * The file offset is not changed.
+ *
+ * @param fildes File descriptor of the opened file.
+ * @param iov Buffers to write in turn.
+ * @param iovcnt Number of buffers.
+ * @param offset Position in the file to write to.
+ * @return Number of written bytes on success, -1 otherwise.
+ */
+ssize_t pwritev(int fildes, const struct iovec *iov, int iovcnt, off_t offset)
+{
+	aoff64_t pos = offset;
+	size_t nwr;
+
+	if (offset < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (!iov_check(iov, iovcnt))
+		return -1;
+
+	if (failed(vfs_writev(fildes, &pos, (const vfs_iovec_t *) iov, iovcnt,
+	    &nwr)))
+		return -1;
+
+	return (ssize_t) nwr;
+}
+
+/** @}
+ */
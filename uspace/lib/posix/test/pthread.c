@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcut/pcut.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(pthread);
+
+static pthread_mutex_t test_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t test_cond = PTHREAD_COND_INITIALIZER;
+static int test_flag;
+
+static void *thread_set_flag(void *arg)
+{
+	pthread_mutex_lock(&test_mutex);
+	test_flag = 1;
+	pthread_cond_signal(&test_cond);
+	pthread_mutex_unlock(&test_mutex);
+
+	return arg;
+}
+
+/** Statically initialized mutex can be locked and unlocked */
+PCUT_TEST(mutex_static)
+{
+	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(EBUSY, pthread_mutex_trylock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_trylock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+}
+
+/** Recursive mutex can be locked repeatedly by its owner */
+PCUT_TEST(mutex_recursive)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutex_t mutex;
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutexattr_init(&attr));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutexattr_settype(&attr,
+	    PTHREAD_MUTEX_RECURSIVE));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_init(&mutex, &attr));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_trylock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(EBUSY, pthread_mutex_destroy(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(EPERM, pthread_mutex_unlock(&mutex));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_destroy(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutexattr_destroy(&attr));
+}
+
+/** Error-checking mutex reports relocking by its owner */
+PCUT_TEST(mutex_errorcheck)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutex_t mutex;
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutexattr_init(&attr));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutexattr_settype(&attr,
+	    PTHREAD_MUTEX_ERRORCHECK));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_init(&mutex, &attr));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(EDEADLK, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(EPERM, pthread_mutex_unlock(&mutex));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_destroy(&mutex));
+}
+
+/** Timed wait for a condition variable that is not signalled times out */
+PCUT_TEST(cond_timedwait_timeout)
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct timespec ts;
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_init(&mutex, NULL));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_cond_init(&cond, NULL));
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_nsec += 10000000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_lock(&mutex));
+	PCUT_ASSERT_INT_EQUALS(ETIMEDOUT, pthread_cond_timedwait(&cond,
+	    &mutex, &ts));
+	PCUT_ASSERT_INT_EQUALS(ETIMEDOUT, pthread_cond_timedwait(&cond,
+	    &mutex, &ts));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_unlock(&mutex));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_cond_destroy(&cond));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_mutex_destroy(&mutex));
+}
+
+/** A created thread signals a condition variable and can be joined */
+PCUT_TEST(create_join)
+{
+	pthread_t thread;
+	void *retval;
+	int rc;
+
+	test_flag = 0;
+
+	rc = pthread_create(&thread, NULL, thread_set_flag, &test_flag);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+
+	pthread_mutex_lock(&test_mutex);
+	while (test_flag == 0)
+		pthread_cond_wait(&test_cond, &test_mutex);
+	pthread_mutex_unlock(&test_mutex);
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_join(thread, &retval));
+	PCUT_ASSERT_TRUE(retval == &test_flag);
+	PCUT_ASSERT_INT_EQUALS(ESRCH, pthread_join(thread, NULL));
+}
+
+/** Read-write lock is shared by readers and exclusive for writers */
+PCUT_TEST(rwlock)
+{
+	static pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_rwlock_rdlock(&rwlock));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_rwlock_tryrdlock(&rwlock));
+	PCUT_ASSERT_INT_EQUALS(EBUSY, pthread_rwlock_trywrlock(&rwlock));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_rwlock_unlock(&rwlock));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_rwlock_unlock(&rwlock));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_rwlock_wrlock(&rwlock));
+	PCUT_ASSERT_INT_EQUALS(EBUSY, pthread_rwlock_tryrdlock(&rwlock));
+	PCUT_ASSERT_INT_EQUALS(EDEADLK, pthread_rwlock_wrlock(&rwlock));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_rwlock_unlock(&rwlock));
+	PCUT_ASSERT_INT_EQUALS(EPERM, pthread_rwlock_unlock(&rwlock));
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_rwlock_destroy(&rwlock));
+}
+
+/** Spin lock can be taken only once */
+PCUT_TEST(spin)
+{
+	pthread_spinlock_t lock;
+
+	PCUT_ASSERT_INT_EQUALS(0, pthread_spin_init(&lock,
+	    PTHREAD_PROCESS_PRIVATE));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_spin_lock(&lock));
+	PCUT_ASSERT_INT_EQUALS(EBUSY, pthread_spin_trylock(&lock));
+	PCUT_ASSERT_INT_EQUALS(EBUSY, pthread_spin_destroy(&lock));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_spin_unlock(&lock));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_spin_trylock(&lock));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_spin_unlock(&lock));
+	PCUT_ASSERT_INT_EQUALS(0, pthread_spin_destroy(&lock));
+}
+
+PCUT_EXPORT(pthread);
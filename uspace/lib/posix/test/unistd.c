@@ -30,6 +30,8 @@
 #include <pcut/pcut.h>
 #include <fcntl.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 PCUT_INIT;
@@ -75,4 +77,66 @@ PCUT_TEST(access_file)
 	close(file);
 }
 
+/** writev and readv, preadv and pwritev round trip */
+PCUT_TEST(writev_readv)
+{
+	char name[L_tmpnam];
+	char a[4], b[1], c[8];
+	char big[300];
+	char *p;
+	int file;
+	ssize_t n;
+	off_t off;
+
+	struct iovec wiov[] = {
+		{ .iov_base = (void *) "head", .iov_len = 4 },
+		{ .iov_base = NULL, .iov_len = 0 },
+		{ .iov_base = (void *) "-", .iov_len = 1 },
+		{ .iov_base = (void *) "trailer!", .iov_len = 8 }
+	};
+	struct iovec riov[] = {
+		{ .iov_base = a, .iov_len = sizeof(a) },
+		{ .iov_base = b, .iov_len = sizeof(b) },
+		{ .iov_base = c, .iov_len = sizeof(c) },
+		{ .iov_base = big, .iov_len = sizeof(big) }
+	};
+
+	p = tmpnam(name);
+	PCUT_ASSERT_NOT_NULL(p);
+
+	file = open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	PCUT_ASSERT_TRUE(file >= 0);
+
+	n = writev(file, wiov, 4);
+	PCUT_ASSERT_INT_EQUALS(13, n);
+
+	off = lseek(file, 0, SEEK_SET);
+	PCUT_ASSERT_INT_EQUALS(0, off);
+
+	/* Only the data in the file is read, the last buffer stays empty. */
+	n = readv(file, riov, 4);
+	PCUT_ASSERT_INT_EQUALS(13, n);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(a, "head", 4));
+	PCUT_ASSERT_INT_EQUALS('-', b[0]);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(c, "trailer!", 8));
+
+	/* Positioned variants leave the file offset alone. */
+	memset(big, 'x', sizeof(big));
+	n = pwritev(file, &riov[3], 1, 4);
+	PCUT_ASSERT_INT_EQUALS((ssize_t) sizeof(big), n);
+
+	n = preadv(file, riov, 2, 0);
+	PCUT_ASSERT_INT_EQUALS(5, n);
+	PCUT_ASSERT_INT_EQUALS('x', b[0]);
+
+	off = lseek(file, 0, SEEK_CUR);
+	PCUT_ASSERT_INT_EQUALS(13, off);
+
+	n = readv(file, riov, 0);
+	PCUT_ASSERT_INT_EQUALS(-1, n);
+
+	(void) unlink(name);
+	close(file);
+}
+
 PCUT_EXPORT(unistd);
@@ -58,6 +58,16 @@ enum scsi_cmd_sbc {
 	SCSI_CMD_WRITE_16		= 0x8a
 };
 
+/** Service actions of SCSI_CMD_READ_CAPACITY_16 (Service Action In (16)) */
+enum scsi_sa_read_capacity_16 {
+	SCSI_SA_READ_CAPACITY_16	= 0x10
+};
+
+/** Vital product data page codes defined in SCSI-SBC */
+enum scsi_vpd_page_sbc {
+	SCSI_VPD_BLOCK_LIMITS		= 0xb0
+};
+
 /** SCSI Read (10) command */
 typedef struct {
 	/** Operation code (SCSI_CMD_READ_10) */
@@ -133,6 +143,65 @@ typedef struct {
 	uint32_t block_size;
 } scsi_read_capacity_10_data_t;
 
+/** SCSI Read Capacity (16) command */
+typedef struct {
+	/** Operation code (SCSI_CMD_READ_CAPACITY_16) */
+	uint8_t op_code;
+	/** Reserved, Service Action (SCSI_SA_READ_CAPACITY_16) */
+	uint8_t service_action;
+	/** Logical block address */
+	uint64_t lba;
+	/** Allocation length */
+	uint32_t alloc_len;
+	/** Reserved, PMI */
+	uint8_t pmi;
+	/** Control */
+	uint8_t control;
+} __attribute__((packed)) scsi_cdb_read_capacity_16_t;
+
+/** Read Capacity (16) parameter data.
+ *
+ * Returned for Read Capacity (16) command.
+ */
+typedef struct {
+	/** Logical address of last block */
+	uint64_t last_lba;
+	/** Size of block in bytes */
+	uint32_t block_size;
+	/** Reserved, P_Type, Prot_En */
+	uint8_t prot;
+	/** P_I_Exponent, Logical Blocks per Physical Block Exponent */
+	uint8_t lbppbe;
+	/** LBPME, LBPRZ, Lowest Aligned Logical Block Address */
+	uint16_t lalba;
+	/** Reserved */
+	uint8_t reserved[16];
+} __attribute__((packed)) scsi_read_capacity_16_data_t;
+
+/** Block Limits VPD page.
+ *
+ * Returned for Inquiry command with evpd bit set and page code
+ * SCSI_VPD_BLOCK_LIMITS. Only the leading part of the page is described.
+ */
+typedef struct {
+	/** Peripheral qualifier, Peripheral device type */
+	uint8_t pqual_devtype;
+	/** Page Code */
+	uint8_t page_code;
+	/** Page Length */
+	uint16_t page_len;
+	/** Reserved, WSNZ */
+	uint8_t wsnz;
+	/** Maximum Compare and Write Length */
+	uint8_t max_cmp_write_len;
+	/** Optimal Transfer Length Granularity */
+	uint16_t opt_xfer_len_gran;
+	/** Maximum Transfer Length */
+	uint32_t max_xfer_len;
+	/** Optimal Transfer Length */
+	uint32_t opt_xfer_len;
+} __attribute__((packed)) scsi_block_limits_vpd_t;
+
 /** SCSI Synchronize Cache (10) command */
 typedef struct {
 	/** Operation code (SCSI_CMD_SYNC_CACHE_10) */
@@ -64,6 +64,12 @@ typedef struct {
 	uint8_t control;
 } __attribute__((packed)) scsi_cdb_inquiry_t;
 
+/** Bits in scsi_cdb_inquiry_t.evpd */
+enum scsi_inquiry_evpd_bits {
+	/** Enable Vital Product Data */
+	SCSI_INQ_EVPD		= 0
+};
+
 /** Minimum size of inquiry data required since SCSI-2 */
 #define SCSI_STD_INQUIRY_DATA_MIN_SIZE 36
 
@@ -126,6 +132,13 @@ enum scsi_pqual_devtype_bits {
 	SCSI_PQDT_DEV_TYPE_l	= 0
 };
 
+/** Values of scsi_std_inquiry_data_t.version */
+enum scsi_version {
+	SCSI_VERSION_SPC2	= 0x04,
+	SCSI_VERSION_SPC3	= 0x05,
+	SCSI_VERSION_SPC4	= 0x06
+};
+
 /** Bits in scsi_std_inquiry_data_t.rmb */
 enum scsi_rmb_bits {
 	SCSI_RMB_RMB		= 7
@@ -51,6 +51,7 @@ typedef struct sif_node sif_node_t;
 errno_t sif_create(const char *, sif_sess_t **);
 errno_t sif_open(const char *, sif_sess_t **);
 errno_t sif_close(sif_sess_t *);
+errno_t sif_export_text(sif_sess_t *, const char *);
 sif_node_t *sif_get_root(sif_sess_t *);
 
 sif_node_t *sif_node_first_child(sif_node_t *);
@@ -37,18 +37,55 @@
 #ifndef PRIVATE_SIF_H_
 #define PRIVATE_SIF_H_
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <adt/odict.h>
+#include <offset.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
+/** Growable buffer for marshalling */
+typedef struct {
+	/** Data */
+	uint8_t *data;
+	/** Number of bytes used */
+	size_t size;
+	/** Number of bytes allocated */
+	size_t alloc;
+} sif_wbuf_t;
+
 /** SIF session */
 struct sif_sess {
 	/** Repository file */
-	FILE *f;
+	int fd;
 	/** Repository file name */
 	char *fname;
 	/** Root node */
 	struct sif_node *root;
+	/** Nodes in memory by node ID (of sif_node_t) */
+	hash_table_t nodes;
+	/** Next free node ID */
+	uint32_t next_nid;
+	/** Snapshot image nodes are loaded from or @c NULL */
+	uint8_t *image;
+	/** Size of the snapshot image */
+	size_t image_size;
+	/** @c image is mapped from the file rather than allocated */
+	bool image_mapped;
+	/** Node index in @c image */
+	const uint8_t *index;
+	/** Number of entries in @c index */
+	uint32_t index_cnt;
+	/** Offset where the journal starts (size of the snapshot) */
+	aoff64_t jstart;
+	/** Offset where the journal ends */
+	aoff64_t jend;
+	/** Journal record with changes not written yet */
+	sif_wbuf_t pending;
+	/** Changes could not be journalled, write a new snapshot instead */
+	bool need_snapshot;
 };
 
 /** SIF transaction */
@@ -70,6 +107,12 @@ typedef struct {
 
 /** SIF node */
 struct sif_node {
+	/** Containing session */
+	struct sif_sess *sess;
+	/** Node ID */
+	uint32_t nid;
+	/** Link to sess->nodes */
+	ht_link_t lnodes;
 	/** Parent node or @c NULL in case of root node */
 	struct sif_node *parent;
 	/** Link to parent->children */
@@ -80,6 +123,12 @@ struct sif_node {
 	odict_t attrs;
 	/** Child nodes */
 	list_t children;
+	/** Child nodes have been loaded from the snapshot image */
+	bool loaded;
+	/** Offset of child record offsets in the snapshot image */
+	size_t image_children;
+	/** Number of child nodes in the snapshot image */
+	uint32_t image_nchildren;
 };
 
 #endif
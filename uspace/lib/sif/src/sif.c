@@ -57,31 +57,298 @@
  *  - does not deal with data sets large enough not to fit in primary memory
  *
  * any kind of structure data validation is left up to the application.
+ *
+ * The repository file starts with a binary snapshot of the tree. The
+ * snapshot is mapped into memory when the repository is opened and nodes
+ * are only unmarshalled when their parent's children are first accessed.
+ * The snapshot contains an index of nodes sorted by node ID.
+ *
+ * The snapshot is followed by a journal. Committing a transaction appends
+ * a single checksummed record describing the changes to the journal. When
+ * opening the repository, the journal is replayed on top of the snapshot
+ * and a record torn by a crash is ignored. Once the journal grows larger
+ * than the snapshot, a new snapshot is written to a temporary file which
+ * then replaces the repository.
+ *
+ * The older text format is still understood by sif_open() and the
+ * repository can be exported in it using sif_export_text().
  */
 
+#include <adt/checksum.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <adt/odict.h>
+#include <align.h>
+#include <as.h>
+#include <assert.h>
+#include <byteorder.h>
 #include <errno.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
+#include <vfs/vfs.h>
 #include "../include/sif.h"
 #include "../private/sif.h"
 
+/** Magic at the beginning of a binary repository */
+#define SIF_MAGIC "SIFB"
+/** Binary format version */
+#define SIF_VERSION 1
+/** Size of the snapshot header */
+#define SIF_HDR_SIZE 32
+/** Size of a node index entry */
+#define SIF_IDX_ENTRY_SIZE 12
+/** Size of a journal record header */
+#define SIF_JREC_HDR_SIZE 8
+/** Node ID of the root node */
+#define SIF_ROOT_NID 1
+/** The journal is compacted once it is larger than this and the snapshot */
+#define SIF_JOURNAL_MIN (16 * 1024)
+
+/** Journal operation */
+typedef enum {
+	/** Create node */
+	SIF_OP_NEW = 1,
+	/** Destroy node */
+	SIF_OP_DESTROY,
+	/** Set attribute */
+	SIF_OP_SET_ATTR,
+	/** Unset attribute */
+	SIF_OP_UNSET_ATTR
+} sif_op_t;
+
+/** Where to insert a new node relative to a reference node */
+typedef enum {
+	/** First child of the reference node */
+	SIF_POS_PREPEND,
+	/** Last child of the reference node */
+	SIF_POS_APPEND,
+	/** Sibling before the reference node */
+	SIF_POS_BEFORE,
+	/** Sibling after the reference node */
+	SIF_POS_AFTER
+} sif_pos_t;
+
+/** Cursor for unmarshalling */
+typedef struct {
+	/** Data */
+	const uint8_t *data;
+	/** Size of data */
+	size_t size;
+	/** Current position */
+	size_t pos;
+} sif_rbuf_t;
+
+/** Node index entry being built */
+typedef struct {
+	/** Node ID */
+	uint32_t nid;
+	/** Node ID of the parent node or zero for the root */
+	uint32_t pnid;
+	/** Offset of the node record */
+	uint32_t off;
+} sif_idx_entry_t;
+
+/** Snapshot being built */
+typedef struct {
+	/** Marshalled snapshot */
+	sif_wbuf_t wbuf;
+	/** Node index */
+	sif_idx_entry_t *idx;
+	/** Number of index entries */
+	size_t idx_cnt;
+} sif_snapshot_t;
+
 static errno_t sif_export_node(sif_node_t *, FILE *);
-static errno_t sif_import_node(sif_node_t *, FILE *, sif_node_t **);
+static errno_t sif_import_node(sif_sess_t *, sif_node_t *, FILE *,
+    sif_node_t **);
 static sif_attr_t *sif_node_first_attr(sif_node_t *);
 static sif_attr_t *sif_node_next_attr(sif_attr_t *);
 static void sif_attr_delete(sif_attr_t *);
 static void *sif_attr_getkey(odlink_t *);
 static int sif_attr_cmp(void *, void *);
 
+static size_t sif_nodes_hash(const ht_link_t *item)
+{
+	return hash_table_get_inst(item, sif_node_t, lnodes)->nid;
+}
+
+static size_t sif_nodes_key_hash(const void *key)
+{
+	return *(const uint32_t *) key;
+}
+
+static bool sif_nodes_key_equal(const void *key, const ht_link_t *item)
+{
+	return hash_table_get_inst(item, sif_node_t, lnodes)->nid ==
+	    *(const uint32_t *) key;
+}
+
+static bool sif_nodes_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	return hash_table_get_inst(item1, sif_node_t, lnodes)->nid ==
+	    hash_table_get_inst(item2, sif_node_t, lnodes)->nid;
+}
+
+static hash_table_ops_t sif_nodes_ops = {
+	.hash = sif_nodes_hash,
+	.key_hash = sif_nodes_key_hash,
+	.key_equal = sif_nodes_key_equal,
+	.equal = sif_nodes_equal,
+	.remove_callback = NULL
+};
+
+/** Make sure a marshalling buffer has space for more data.
+ *
+ * @param wbuf Buffer
+ * @param size Number of bytes to be added
+ * @return EOK on success or ENOMEM if out of memory
+ */
+static errno_t sif_wbuf_reserve(sif_wbuf_t *wbuf, size_t size)
+{
+	uint8_t *ndata;
+	size_t nalloc;
+
+	if (size <= wbuf->alloc - wbuf->size)
+		return EOK;
+
+	nalloc = max(wbuf->alloc, 256);
+	while (size > nalloc - wbuf->size) {
+		if (nalloc > SIZE_MAX / 2)
+			return ENOMEM;
+		nalloc *= 2;
+	}
+
+	ndata = realloc(wbuf->data, nalloc);
+	if (ndata == NULL)
+		return ENOMEM;
+
+	wbuf->data = ndata;
+	wbuf->alloc = nalloc;
+	return EOK;
+}
+
+/** Append data to a marshalling buffer.
+ *
+ * @param wbuf Buffer
+ * @param data Data
+ * @param size Size of data
+ * @return EOK on success or ENOMEM if out of memory
+ */
+static errno_t sif_wbuf_put(sif_wbuf_t *wbuf, const void *data, size_t size)
+{
+	errno_t rc;
+
+	rc = sif_wbuf_reserve(wbuf, size);
+	if (rc != EOK)
+		return rc;
+
+	memcpy(wbuf->data + wbuf->size, data, size);
+	wbuf->size += size;
+	return EOK;
+}
+
+static errno_t sif_wbuf_put_u8(sif_wbuf_t *wbuf, uint8_t val)
+{
+	return sif_wbuf_put(wbuf, &val, sizeof(val));
+}
+
+static errno_t sif_wbuf_put_u32(sif_wbuf_t *wbuf, uint32_t val)
+{
+	uint32_t le = host2uint32_t_le(val);
+
+	return sif_wbuf_put(wbuf, &le, sizeof(le));
+}
+
+/** Store a 32-bit number at a given offset of a marshalling buffer. */
+static void sif_wbuf_set_u32(sif_wbuf_t *wbuf, size_t off, uint32_t val)
+{
+	uint32_t le = host2uint32_t_le(val);
+
+	assert(off + sizeof(le) <= wbuf->size);
+	memcpy(wbuf->data + off, &le, sizeof(le));
+}
+
+/** Append a string (its size followed by its bytes). */
+static errno_t sif_wbuf_put_str(sif_wbuf_t *wbuf, const char *str)
+{
+	size_t size = str_size(str);
+	errno_t rc;
+
+	if (size > UINT32_MAX)
+		return EINVAL;
+
+	rc = sif_wbuf_put_u32(wbuf, size);
+	if (rc != EOK)
+		return rc;
+
+	return sif_wbuf_put(wbuf, str, size);
+}
+
+static errno_t sif_rbuf_get_u8(sif_rbuf_t *rbuf, uint8_t *rval)
+{
+	if (rbuf->size - rbuf->pos < sizeof(uint8_t))
+		return EIO;
+
+	*rval = rbuf->data[rbuf->pos++];
+	return EOK;
+}
+
+static errno_t sif_rbuf_get_u32(sif_rbuf_t *rbuf, uint32_t *rval)
+{
+	uint32_t le;
+
+	if (rbuf->size - rbuf->pos < sizeof(le))
+		return EIO;
+
+	memcpy(&le, rbuf->data + rbuf->pos, sizeof(le));
+	rbuf->pos += sizeof(le);
+	*rval = uint32_t_le2host(le);
+	return EOK;
+}
+
+/** Unmarshal a string.
+ *
+ * @param rbuf Cursor
+ * @param rstr Place to store pointer to newly allocated string
+ * @return EOK on success, EIO if the data are corrupt or ENOMEM
+ */
+static errno_t sif_rbuf_get_str(sif_rbuf_t *rbuf, char **rstr)
+{
+	uint32_t size;
+	char *str;
+	errno_t rc;
+
+	rc = sif_rbuf_get_u32(rbuf, &size);
+	if (rc != EOK)
+		return rc;
+
+	if (rbuf->size - rbuf->pos < size)
+		return EIO;
+
+	str = malloc(size + 1);
+	if (str == NULL)
+		return ENOMEM;
+
+	memcpy(str, rbuf->data + rbuf->pos, size);
+	str[size] = '\0';
+	rbuf->pos += size;
+
+	*rstr = str;
+	return EOK;
+}
+
 /** Create new SIF node.
  *
+ * @param sess SIF session
  * @param parent Parent node
+ * @param nid Node ID
  * @return Pointer to new node on success or @c NULL if out of memory
  */
-static sif_node_t *sif_node_new(sif_node_t *parent)
+static sif_node_t *sif_node_new(sif_sess_t *sess, sif_node_t *parent,
+    uint32_t nid)
 {
 	sif_node_t *node;
 
@@ -89,9 +356,13 @@ static sif_node_t *sif_node_new(sif_node_t *parent)
 	if (node == NULL)
 		return NULL;
 
+	node->sess = sess;
+	node->nid = nid;
 	node->parent = parent;
+	node->loaded = true;
 	odict_initialize(&node->attrs, sif_attr_getkey, sif_attr_cmp);
 	list_initialize(&node->children);
+	hash_table_insert(&sess->nodes, &node->lnodes);
 
 	return node;
 }
@@ -107,12 +378,15 @@ static void sif_node_delete(sif_node_t *node)
 {
 	sif_attr_t *attr;
 	sif_node_t *child;
+	link_t *link;
 
 	if (node == NULL)
 		return;
 
 	assert(!link_used(&node->lparent));
 
+	hash_table_remove_item(&node->sess->nodes, &node->lnodes);
+
 	if (node->ntype != NULL)
 		free(node->ntype);
 
@@ -123,11 +397,11 @@ static void sif_node_delete(sif_node_t *node)
 		attr = sif_node_first_attr(node);
 	}
 
-	child = sif_node_first_child(node);
-	while (child != NULL) {
+	/* Children not loaded from the image yet need no cleanup */
+	while ((link = list_first(&node->children)) != NULL) {
+		child = list_get_instance(link, sif_node_t, lparent);
 		list_remove(&child->lparent);
 		sif_node_delete(child);
-		child = sif_node_first_child(node);
 	}
 
 	free(node);
@@ -146,29 +420,1004 @@ static sif_attr_t *sif_attr_new(sif_node_t *node)
 	if (attr == NULL)
 		return NULL;
 
-	attr->node = node;
-	return attr;
+	attr->node = node;
+	return attr;
+}
+
+/** Delete SIF attribute.
+ *
+ * Delete a SIF attribute that has been already unlinked from is node.
+ *
+ * @param attr Attribute
+ */
+static void sif_attr_delete(sif_attr_t *attr)
+{
+	if (attr == NULL)
+		return;
+
+	assert(!odlink_used(&attr->lattrs));
+
+	if (attr->aname != NULL)
+		free(attr->aname);
+	if (attr->avalue != NULL)
+		free(attr->avalue);
+
+	free(attr);
+}
+
+/** Set node attribute without journalling the change.
+ *
+ * @param node SIF node
+ * @param aname Attribute name
+ * @param value Attribute value
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+static errno_t sif_node_attr_set(sif_node_t *node, const char *aname,
+    const char *avalue)
+{
+	odlink_t *link;
+	sif_attr_t *attr;
+	char *cvalue;
+
+	link = odict_find_eq(&node->attrs, (void *)aname, NULL);
+
+	if (link != NULL) {
+		attr = odict_get_instance(link, sif_attr_t, lattrs);
+		cvalue = str_dup(avalue);
+		if (cvalue == NULL)
+			return ENOMEM;
+
+		free(attr->avalue);
+		attr->avalue = cvalue;
+	} else {
+		attr = sif_attr_new(node);
+		if (attr == NULL)
+			return ENOMEM;
+
+		attr->aname = str_dup(aname);
+		if (attr->aname == NULL) {
+			sif_attr_delete(attr);
+			return ENOMEM;
+		}
+
+		attr->avalue = str_dup(avalue);
+		if (attr->avalue == NULL) {
+			sif_attr_delete(attr);
+			return ENOMEM;
+		}
+
+		odict_insert(&attr->lattrs, &node->attrs, NULL);
+	}
+
+	return EOK;
+}
+
+/** Unset node attribute without journalling the change.
+ *
+ * @param node Node
+ * @param aname Attribute name
+ */
+static void sif_node_attr_unset(sif_node_t *node, const char *aname)
+{
+	odlink_t *link;
+	sif_attr_t *attr;
+
+	link = odict_find_eq(&node->attrs, (void *)aname, NULL);
+	if (link == NULL)
+		return;
+
+	attr = odict_get_instance(link, sif_attr_t, lattrs);
+	odict_remove(link);
+	sif_attr_delete(attr);
+}
+
+/** Unmarshal node from the snapshot image.
+ *
+ * The node's attributes are loaded, its children are not.
+ *
+ * @param sess SIF session
+ * @param parent Parent node
+ * @param off Offset of the node record in the image
+ * @param rnode Place to store pointer to the new node
+ * @return EOK on success, EIO if the image is corrupt or ENOMEM
+ */
+static errno_t sif_node_load(sif_sess_t *sess, sif_node_t *parent,
+    size_t off, sif_node_t **rnode)
+{
+	sif_rbuf_t rbuf;
+	sif_node_t *node;
+	sif_attr_t *attr;
+	uint32_t nid;
+	uint32_t nattrs;
+	uint32_t nchildren;
+	uint32_t i;
+	errno_t rc;
+
+	rbuf.data = sess->image;
+	rbuf.size = sess->image_size;
+	rbuf.pos = off;
+	if (off < SIF_HDR_SIZE || off > rbuf.size)
+		return EIO;
+
+	rc = sif_rbuf_get_u32(&rbuf, &nid);
+	if (rc != EOK)
+		return rc;
+	rc = sif_rbuf_get_u32(&rbuf, &nattrs);
+	if (rc != EOK)
+		return rc;
+	rc = sif_rbuf_get_u32(&rbuf, &nchildren);
+	if (rc != EOK)
+		return rc;
+
+	/* A node appearing twice would turn the tree into a graph */
+	if (nid == 0 || hash_table_find(&sess->nodes, &nid) != NULL)
+		return EIO;
+
+	node = sif_node_new(sess, parent, nid);
+	if (node == NULL)
+		return ENOMEM;
+
+	rc = sif_rbuf_get_str(&rbuf, &node->ntype);
+	if (rc != EOK)
+		goto error;
+
+	for (i = 0; i < nattrs; i++) {
+		attr = sif_attr_new(node);
+		if (attr == NULL) {
+			rc = ENOMEM;
+			goto error;
+		}
+
+		rc = sif_rbuf_get_str(&rbuf, &attr->aname);
+		if (rc == EOK)
+			rc = sif_rbuf_get_str(&rbuf, &attr->avalue);
+		if (rc == EOK && odict_find_eq(&node->attrs, attr->aname,
+		    NULL) != NULL)
+			rc = EIO;
+		if (rc != EOK) {
+			sif_attr_delete(attr);
+			goto error;
+		}
+
+		odict_insert(&attr->lattrs, &node->attrs, NULL);
+	}
+
+	if (rbuf.size - rbuf.pos < (size_t) nchildren * sizeof(uint32_t)) {
+		rc = EIO;
+		goto error;
+	}
+
+	node->image_children = rbuf.pos;
+	node->image_nchildren = nchildren;
+	node->loaded = (nchildren == 0);
+
+	*rnode = node;
+	return EOK;
+error:
+	sif_node_delete(node);
+	return rc;
+}
+
+/** Make sure children of a node are loaded from the snapshot image.
+ *
+ * @param node SIF node
+ * @return EOK on success, EIO if the image is corrupt or ENOMEM
+ */
+static errno_t sif_node_load_children(sif_node_t *node)
+{
+	sif_sess_t *sess = node->sess;
+	sif_rbuf_t rbuf;
+	sif_node_t *child;
+	uint32_t coff;
+	uint32_t i;
+	link_t *link;
+	errno_t rc;
+
+	if (node->loaded)
+		return EOK;
+
+	assert(list_empty(&node->children));
+
+	rbuf.data = sess->image;
+	rbuf.size = sess->image_size;
+	rbuf.pos = node->image_children;
+
+	for (i = 0; i < node->image_nchildren; i++) {
+		rc = sif_rbuf_get_u32(&rbuf, &coff);
+		if (rc != EOK)
+			goto error;
+
+		rc = sif_node_load(sess, node, coff, &child);
+		if (rc != EOK)
+			goto error;
+
+		list_append(&child->lparent, &node->children);
+	}
+
+	node->loaded = true;
+	return EOK;
+error:
+	while ((link = list_first(&node->children)) != NULL) {
+		child = list_get_instance(link, sif_node_t, lparent);
+		list_remove(&child->lparent);
+		sif_node_delete(child);
+	}
+
+	return rc;
+}
+
+/** Load a whole subtree from the snapshot image.
+ *
+ * @param node Root of the subtree
+ * @return EOK on success, EIO if the image is corrupt or ENOMEM
+ */
+static errno_t sif_node_load_all(sif_node_t *node)
+{
+	sif_node_t *child;
+	errno_t rc;
+
+	rc = sif_node_load_children(node);
+	if (rc != EOK)
+		return rc;
+
+	list_foreach(node->children, lparent, sif_node_t, child) {
+		rc = sif_node_load_all(child);
+		if (rc != EOK)
+			return rc;
+	}
+
+	(void) child;
+	return EOK;
+}
+
+/** Find node by node ID.
+ *
+ * If the node has not been loaded yet, it is looked up in the node index
+ * of the snapshot image and loaded together with its ancestors.
+ *
+ * @param sess SIF session
+ * @param nid Node ID
+ * @param rnode Place to store pointer to the node
+ * @return EOK on success, ENOENT if there is no such node, EIO if the
+ *         image is corrupt or ENOMEM
+ */
+static errno_t sif_sess_find_node(sif_sess_t *sess, uint32_t nid,
+    sif_node_t **rnode)
+{
+	sif_rbuf_t rbuf;
+	sif_node_t *parent;
+	ht_link_t *link;
+	uint32_t lo, hi, mid;
+	uint32_t enid;
+	uint32_t pnid;
+	errno_t rc;
+
+	link = hash_table_find(&sess->nodes, &nid);
+	if (link != NULL) {
+		*rnode = hash_table_get_inst(link, sif_node_t, lnodes);
+		return EOK;
+	}
+
+	rbuf.data = sess->index;
+	rbuf.size = (size_t) sess->index_cnt * SIF_IDX_ENTRY_SIZE;
+
+	lo = 0;
+	hi = sess->index_cnt;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		rbuf.pos = (size_t) mid * SIF_IDX_ENTRY_SIZE;
+		rc = sif_rbuf_get_u32(&rbuf, &enid);
+		if (rc != EOK)
+			return rc;
+
+		if (enid == nid)
+			break;
+		if (enid < nid)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo >= hi)
+		return ENOENT;
+
+	rc = sif_rbuf_get_u32(&rbuf, &pnid);
+	if (rc != EOK)
+		return rc;
+
+	if (pnid == 0 || pnid == nid)
+		return ENOENT;
+
+	rc = sif_sess_find_node(sess, pnid, &parent);
+	if (rc != EOK)
+		return rc;
+
+	/* Children already loaded means the node has been destroyed */
+	if (parent->loaded)
+		return ENOENT;
+
+	rc = sif_node_load_children(parent);
+	if (rc != EOK)
+		return rc;
+
+	link = hash_table_find(&sess->nodes, &nid);
+	if (link == NULL)
+		return ENOENT;
+
+	*rnode = hash_table_get_inst(link, sif_node_t, lnodes);
+	return EOK;
+}
+
+/** Create a node and insert it into the tree without journalling.
+ *
+ * @param ref Reference node
+ * @param pos Position relative to @a ref
+ * @param nid Node ID
+ * @param ctype Node type
+ * @param rchild Place to store pointer to the new node
+ * @return EOK on success, EINVAL if @a ref is the root and @a pos
+ *         refers to its sibling, EIO if the image is corrupt or ENOMEM
+ */
+static errno_t sif_node_insert(sif_node_t *ref, sif_pos_t pos, uint32_t nid,
+    const char *ctype, sif_node_t **rchild)
+{
+	sif_node_t *parent;
+	sif_node_t *child;
+	errno_t rc;
+
+	if (pos == SIF_POS_PREPEND || pos == SIF_POS_APPEND) {
+		parent = ref;
+		rc = sif_node_load_children(parent);
+		if (rc != EOK)
+			return rc;
+	} else {
+		parent = ref->parent;
+		if (parent == NULL)
+			return EINVAL;
+	}
+
+	child = sif_node_new(ref->sess, parent, nid);
+	if (child == NULL)
+		return ENOMEM;
+
+	child->ntype = str_dup(ctype);
+	if (child->ntype == NULL) {
+		sif_node_delete(child);
+		return ENOMEM;
+	}
+
+	switch (pos) {
+	case SIF_POS_PREPEND:
+		list_prepend(&child->lparent, &parent->children);
+		break;
+	case SIF_POS_APPEND:
+		list_append(&child->lparent, &parent->children);
+		break;
+	case SIF_POS_BEFORE:
+		list_insert_before(&child->lparent, &ref->lparent);
+		break;
+	case SIF_POS_AFTER:
+		list_insert_after(&child->lparent, &ref->lparent);
+		break;
+	}
+
+	*rchild = child;
+	return EOK;
+}
+
+/** Begin a journal operation.
+ *
+ * @param sess SIF session
+ * @param op Operation
+ * @param nid Node ID of the node the operation applies to
+ * @return EOK on success or ENOMEM
+ */
+static errno_t sif_journal_op(sif_sess_t *sess, sif_op_t op, uint32_t nid)
+{
+	errno_t rc;
+
+	rc = sif_wbuf_put_u8(&sess->pending, op);
+	if (rc != EOK)
+		return rc;
+
+	return sif_wbuf_put_u32(&sess->pending, nid);
+}
+
+/** Replay one journal operation.
+ *
+ * @param sess SIF session
+ * @param rbuf Cursor in the journal record
+ * @return EOK on success, EIO if the journal is inconsistent or ENOMEM
+ */
+static errno_t sif_journal_replay_op(sif_sess_t *sess, sif_rbuf_t *rbuf)
+{
+	sif_node_t *node;
+	sif_node_t *ref;
+	uint8_t op;
+	uint8_t pos;
+	uint32_t nid;
+	uint32_t rnid;
+	char *str1 = NULL;
+	char *str2 = NULL;
+	errno_t rc;
+
+	rc = sif_rbuf_get_u8(rbuf, &op);
+	if (rc != EOK)
+		return rc;
+	rc = sif_rbuf_get_u32(rbuf, &nid);
+	if (rc != EOK)
+		return rc;
+
+	switch (op) {
+	case SIF_OP_NEW:
+		rc = sif_rbuf_get_u8(rbuf, &pos);
+		if (rc == EOK && pos > SIF_POS_AFTER)
+			rc = EIO;
+		if (rc == EOK)
+			rc = sif_rbuf_get_u32(rbuf, &rnid);
+		if (rc == EOK)
+			rc = sif_rbuf_get_str(rbuf, &str1);
+		if (rc != EOK)
+			break;
+
+		rc = sif_sess_find_node(sess, nid, &node);
+		if (rc != ENOENT) {
+			rc = (rc == EOK) ? EIO : rc;
+			break;
+		}
+
+		rc = sif_sess_find_node(sess, rnid, &ref);
+		if (rc != EOK)
+			break;
+
+		rc = sif_node_insert(ref, pos, nid, str1, &node);
+		if (rc == EOK && nid >= sess->next_nid)
+			sess->next_nid = nid + 1;
+		break;
+	case SIF_OP_DESTROY:
+		rc = sif_sess_find_node(sess, nid, &node);
+		if (rc == EOK && node->parent == NULL)
+			rc = EIO;
+		if (rc != EOK)
+			break;
+
+		list_remove(&node->lparent);
+		sif_node_delete(node);
+		break;
+	case SIF_OP_SET_ATTR:
+		rc = sif_rbuf_get_str(rbuf, &str1);
+		if (rc == EOK)
+			rc = sif_rbuf_get_str(rbuf, &str2);
+		if (rc == EOK)
+			rc = sif_sess_find_node(sess, nid, &node);
+		if (rc == EOK)
+			rc = sif_node_attr_set(node, str1, str2);
+		break;
+	case SIF_OP_UNSET_ATTR:
+		rc = sif_rbuf_get_str(rbuf, &str1);
+		if (rc == EOK)
+			rc = sif_sess_find_node(sess, nid, &node);
+		if (rc == EOK)
+			sif_node_attr_unset(node, str1);
+		break;
+	default:
+		rc = EIO;
+		break;
+	}
+
+	free(str1);
+	free(str2);
+
+	/* The journal refers to a node that does not exist */
+	if (rc == ENOENT)
+		rc = EIO;
+	return rc;
+}
+
+/** Replay the journal.
+ *
+ * Records are replayed up to the end of the file or up to the first
+ * incomplete or damaged record, which is then truncated away.
+ *
+ * @param sess SIF session
+ * @param fsize File size
+ * @return EOK on success, EIO if the journal is inconsistent or ENOMEM
+ */
+static errno_t sif_journal_replay(sif_sess_t *sess, aoff64_t fsize)
+{
+	uint8_t hdr[SIF_JREC_HDR_SIZE];
+	sif_rbuf_t rbuf;
+	uint8_t *data;
+	uint32_t size;
+	uint32_t crc;
+	aoff64_t pos;
+	size_t nread;
+	errno_t rc;
+
+	sess->jend = sess->jstart;
+
+	while (fsize - sess->jend >= SIF_JREC_HDR_SIZE) {
+		pos = sess->jend;
+		rc = vfs_read(sess->fd, &pos, hdr, sizeof(hdr), &nread);
+		if (rc != EOK || nread != sizeof(hdr))
+			return EIO;
+
+		rbuf.data = hdr;
+		rbuf.size = sizeof(hdr);
+		rbuf.pos = 0;
+		(void) sif_rbuf_get_u32(&rbuf, &size);
+		(void) sif_rbuf_get_u32(&rbuf, &crc);
+
+		if (size == 0 || size > fsize - pos)
+			break;
+
+		data = malloc(size);
+		if (data == NULL)
+			return ENOMEM;
+
+		rc = vfs_read(sess->fd, &pos, data, size, &nread);
+		if (rc != EOK || nread != size) {
+			free(data);
+			return EIO;
+		}
+
+		if (compute_crc32(data, size) != crc) {
+			free(data);
+			break;
+		}
+
+		rbuf.data = data;
+		rbuf.size = size;
+		rbuf.pos = 0;
+		while (rbuf.pos < rbuf.size) {
+			rc = sif_journal_replay_op(sess, &rbuf);
+			if (rc != EOK) {
+				free(data);
+				return rc;
+			}
+		}
+
+		free(data);
+		sess->jend = pos;
+	}
+
+	if (sess->jend < fsize) {
+		rc = vfs_resize(sess->fd, sess->jend);
+		if (rc != EOK)
+			return EIO;
+	}
+
+	return EOK;
+}
+
+/** Drop changes not yet written to the journal. */
+static void sif_journal_clear(sif_sess_t *sess)
+{
+	assert(sess->pending.alloc >= SIF_JREC_HDR_SIZE);
+	sess->pending.size = SIF_JREC_HDR_SIZE;
+}
+
+/** Write pending changes to the journal as a single record.
+ *
+ * @param sess SIF session
+ * @return EOK on success or EIO
+ */
+static errno_t sif_journal_write(sif_sess_t *sess)
+{
+	size_t size = sess->pending.size - SIF_JREC_HDR_SIZE;
+	aoff64_t pos = sess->jend;
+	size_t nwr;
+	errno_t rc;
+
+	if (size == 0)
+		return EOK;
+
+	sif_wbuf_set_u32(&sess->pending, 0, size);
+	sif_wbuf_set_u32(&sess->pending, sizeof(uint32_t),
+	    compute_crc32(sess->pending.data + SIF_JREC_HDR_SIZE, size));
+
+	rc = vfs_write(sess->fd, &pos, sess->pending.data, sess->pending.size,
+	    &nwr);
+	if (rc == EOK && nwr != sess->pending.size)
+		rc = EIO;
+	if (rc == EOK)
+		rc = vfs_sync(sess->fd);
+
+	if (rc != EOK) {
+		/* Do not leave a partial record behind */
+		(void) vfs_resize(sess->fd, sess->jend);
+		return EIO;
+	}
+
+	sess->jend = pos;
+	sif_journal_clear(sess);
+	return EOK;
+}
+
+/** Marshal a subtree into a snapshot.
+ *
+ * Children are marshalled before their parent so that the parent's
+ * record can refer to them.
+ *
+ * @param node Root of the subtree
+ * @param snap Snapshot
+ * @param roff Place to store offset of the node record
+ * @return EOK on success, EOVERFLOW if the snapshot is too large or ENOMEM
+ */
+static errno_t sif_snapshot_node(sif_node_t *node, sif_snapshot_t *snap,
+    uint32_t *roff)
+{
+	sif_wbuf_t *wbuf = &snap->wbuf;
+	sif_node_t *child;
+	sif_attr_t *attr;
+	uint32_t *coffs;
+	size_t nchildren;
+	size_t i;
+	errno_t rc;
+
+	nchildren = list_count(&node->children);
+	coffs = calloc(max(nchildren, 1), sizeof(uint32_t));
+	if (coffs == NULL)
+		return ENOMEM;
+
+	i = 0;
+	child = sif_node_first_child(node);
+	while (child != NULL) {
+		rc = sif_snapshot_node(child, snap, &coffs[i++]);
+		if (rc != EOK)
+			goto out;
+
+		child = sif_node_next_child(child);
+	}
+
+	if (wbuf->size > UINT32_MAX) {
+		rc = EOVERFLOW;
+		goto out;
+	}
+
+	*roff = wbuf->size;
+
+	rc = sif_wbuf_put_u32(wbuf, node->nid);
+	if (rc == EOK)
+		rc = sif_wbuf_put_u32(wbuf, odict_count(&node->attrs));
+	if (rc == EOK)
+		rc = sif_wbuf_put_u32(wbuf, nchildren);
+	if (rc == EOK)
+		rc = sif_wbuf_put_str(wbuf, node->ntype);
+
+	attr = sif_node_first_attr(node);
+	while (rc == EOK && attr != NULL) {
+		rc = sif_wbuf_put_str(wbuf, attr->aname);
+		if (rc == EOK)
+			rc = sif_wbuf_put_str(wbuf, attr->avalue);
+		attr = sif_node_next_attr(attr);
+	}
+
+	for (i = 0; rc == EOK && i < nchildren; i++)
+		rc = sif_wbuf_put_u32(wbuf, coffs[i]);
+
+	if (rc != EOK)
+		goto out;
+
+	snap->idx[snap->idx_cnt].nid = node->nid;
+	snap->idx[snap->idx_cnt].pnid = node->parent != NULL ?
+	    node->parent->nid : 0;
+	snap->idx[snap->idx_cnt].off = *roff;
+	snap->idx_cnt++;
+out:
+	free(coffs);
+	return rc;
+}
+
+static int sif_idx_entry_cmp(const void *a, const void *b)
+{
+	const sif_idx_entry_t *ea = a;
+	const sif_idx_entry_t *eb = b;
+
+	if (ea->nid < eb->nid)
+		return -1;
+	return ea->nid > eb->nid ? 1 : 0;
+}
+
+/** Write a snapshot of the whole tree to a file.
+ *
+ * @param sess SIF session
+ * @param fd File to write to, its previous contents are discarded
+ * @param rsize Place to store size of the snapshot
+ * @return EOK on success or an error code
+ */
+static errno_t sif_snapshot_write(sif_sess_t *sess, int fd, aoff64_t *rsize)
+{
+	sif_snapshot_t snap;
+	uint32_t root_off;
+	uint32_t index_off;
+	aoff64_t pos;
+	size_t nwr;
+	size_t i;
+	errno_t rc;
+
+	rc = sif_node_load_all(sess->root);
+	if (rc != EOK)
+		return rc;
+
+	memset(&snap, 0, sizeof(snap));
+	snap.idx = calloc(hash_table_size(&sess->nodes),
+	    sizeof(sif_idx_entry_t));
+	if (snap.idx == NULL)
+		return ENOMEM;
+
+	rc = sif_wbuf_put(&snap.wbuf, SIF_MAGIC, 4);
+	if (rc != EOK)
+		goto out;
+
+	rc = sif_wbuf_reserve(&snap.wbuf, SIF_HDR_SIZE - 4);
+	if (rc != EOK)
+		goto out;
+
+	memset(snap.wbuf.data + 4, 0, SIF_HDR_SIZE - 4);
+	snap.wbuf.size = SIF_HDR_SIZE;
+
+	rc = sif_snapshot_node(sess->root, &snap, &root_off);
+	if (rc != EOK)
+		goto out;
+
+	assert(snap.idx_cnt == hash_table_size(&sess->nodes));
+	qsort(snap.idx, snap.idx_cnt, sizeof(sif_idx_entry_t),
+	    sif_idx_entry_cmp);
+
+	index_off = snap.wbuf.size;
+	for (i = 0; rc == EOK && i < snap.idx_cnt; i++) {
+		rc = sif_wbuf_put_u32(&snap.wbuf, snap.idx[i].nid);
+		if (rc == EOK)
+			rc = sif_wbuf_put_u32(&snap.wbuf, snap.idx[i].pnid);
+		if (rc == EOK)
+			rc = sif_wbuf_put_u32(&snap.wbuf, snap.idx[i].off);
+	}
+
+	if (rc != EOK)
+		goto out;
+
+	if (snap.wbuf.size > UINT32_MAX) {
+		rc = EOVERFLOW;
+		goto out;
+	}
+
+	sif_wbuf_set_u32(&snap.wbuf, 4, SIF_VERSION);
+	sif_wbuf_set_u32(&snap.wbuf, 8, snap.idx_cnt);
+	sif_wbuf_set_u32(&snap.wbuf, 12, sess->next_nid);
+	sif_wbuf_set_u32(&snap.wbuf, 16, root_off);
+	sif_wbuf_set_u32(&snap.wbuf, 20, index_off);
+	sif_wbuf_set_u32(&snap.wbuf, 24, snap.wbuf.size);
+
+	pos = 0;
+	rc = vfs_write(fd, &pos, snap.wbuf.data, snap.wbuf.size, &nwr);
+	if (rc == EOK && nwr != snap.wbuf.size)
+		rc = EIO;
+	if (rc == EOK)
+		rc = vfs_resize(fd, pos);
+	if (rc == EOK)
+		rc = vfs_sync(fd);
+	if (rc != EOK) {
+		rc = EIO;
+		goto out;
+	}
+
+	*rsize = pos;
+out:
+	free(snap.wbuf.data);
+	free(snap.idx);
+	return rc;
+}
+
+/** Release the snapshot image. */
+static void sif_image_release(sif_sess_t *sess)
+{
+	if (sess->image == NULL)
+		return;
+
+	if (sess->image_mapped)
+		(void) vfs_munmap(sess->image);
+	else
+		free(sess->image);
+
+	sess->image = NULL;
+	sess->image_size = 0;
+	sess->index = NULL;
+	sess->index_cnt = 0;
+}
+
+/** Replace the repository with a new snapshot.
+ *
+ * The snapshot is written to a temporary file which then atomically
+ * replaces the repository file, so that a crash leaves either the old
+ * or the new repository behind.
+ *
+ * @param sess SIF session
+ * @return EOK on success or an error code
+ */
+static errno_t sif_compact(sif_sess_t *sess)
+{
+	aoff64_t size;
+	char *tname;
+	int fd;
+	errno_t rc;
+
+	if (asprintf(&tname, "%s.tmp", sess->fname) < 0)
+		return ENOMEM;
+
+	rc = vfs_lookup_open(tname, WALK_REGULAR | WALK_MAY_CREATE,
+	    MODE_READ | MODE_WRITE, &fd);
+	if (rc != EOK) {
+		free(tname);
+		return EIO;
+	}
+
+	rc = sif_snapshot_write(sess, fd, &size);
+	if (rc == EOK)
+		rc = vfs_rename_path(tname, sess->fname);
+
+	if (rc != EOK) {
+		vfs_put(fd);
+		(void) vfs_unlink_path(tname);
+		free(tname);
+		return rc;
+	}
+
+	free(tname);
+
+	/* Everything is loaded now, the old image is no longer needed */
+	sif_image_release(sess);
+	vfs_put(sess->fd);
+
+	sess->fd = fd;
+	sess->jstart = size;
+	sess->jend = size;
+	sess->need_snapshot = false;
+	sif_journal_clear(sess);
+	return EOK;
+}
+
+/** Load the snapshot image of a binary repository.
+ *
+ * @param sess SIF session
+ * @param fsize File size
+ * @return EOK on success, EIO if the repository is corrupt or ENOMEM
+ */
+static errno_t sif_image_load(sif_sess_t *sess, aoff64_t fsize)
+{
+	uint8_t hdr[SIF_HDR_SIZE];
+	sif_rbuf_t rbuf;
+	uint32_t version;
+	uint32_t index_cnt;
+	uint32_t next_nid;
+	uint32_t root_off;
+	uint32_t index_off;
+	uint32_t size;
+	aoff64_t pos;
+	size_t nread;
+	void *image;
+	errno_t rc;
+
+	pos = 0;
+	rc = vfs_read(sess->fd, &pos, hdr, sizeof(hdr), &nread);
+	if (rc != EOK || nread != sizeof(hdr))
+		return EIO;
+
+	if (memcmp(hdr, SIF_MAGIC, 4) != 0)
+		return EIO;
+
+	rbuf.data = hdr;
+	rbuf.size = sizeof(hdr);
+	rbuf.pos = 4;
+	(void) sif_rbuf_get_u32(&rbuf, &version);
+	(void) sif_rbuf_get_u32(&rbuf, &index_cnt);
+	(void) sif_rbuf_get_u32(&rbuf, &next_nid);
+	(void) sif_rbuf_get_u32(&rbuf, &root_off);
+	(void) sif_rbuf_get_u32(&rbuf, &index_off);
+	(void) sif_rbuf_get_u32(&rbuf, &size);
+
+	if (version != SIF_VERSION || size > fsize || size < SIF_HDR_SIZE ||
+	    index_off > size || index_cnt > (size - index_off) /
+	    SIF_IDX_ENTRY_SIZE)
+		return EIO;
+
+	/* Map the image, resort to reading it if the file cannot be mapped */
+	rc = vfs_mmap(sess->fd, 0, AS_AREA_ANY, ALIGN_UP(size, PAGE_SIZE),
+	    AS_AREA_READ | AS_AREA_CACHEABLE, false, &image);
+	if (rc == EOK) {
+		sess->image_mapped = true;
+	} else {
+		image = malloc(size);
+		if (image == NULL)
+			return ENOMEM;
+
+		pos = 0;
+		rc = vfs_read(sess->fd, &pos, image, size, &nread);
+		if (rc != EOK || nread != size) {
+			free(image);
+			return EIO;
+		}
+
+		sess->image_mapped = false;
+	}
+
+	sess->image = image;
+	sess->image_size = size;
+	sess->index = sess->image + index_off;
+	sess->index_cnt = index_cnt;
+	sess->next_nid = next_nid;
+	sess->jstart = size;
+
+	rc = sif_node_load(sess, NULL, root_off, &sess->root);
+	if (rc != EOK)
+		return rc;
+
+	if (sess->root->nid >= sess->next_nid)
+		return EIO;
+
+	return EOK;
+}
+
+/** Allocate a SIF session.
+ *
+ * @param fname Repository file name
+ * @param rsess Place to store pointer to new session
+ * @return EOK on success or ENOMEM
+ */
+static errno_t sif_sess_new(const char *fname, sif_sess_t **rsess)
+{
+	sif_sess_t *sess;
+	errno_t rc;
+
+	sess = calloc(1, sizeof(sif_sess_t));
+	if (sess == NULL)
+		return ENOMEM;
+
+	sess->fd = -1;
+	sess->next_nid = SIF_ROOT_NID;
+
+	if (!hash_table_create(&sess->nodes, 0, 0, &sif_nodes_ops)) {
+		free(sess);
+		return ENOMEM;
+	}
+
+	/* Room for the journal record header */
+	rc = sif_wbuf_reserve(&sess->pending, SIF_JREC_HDR_SIZE);
+	if (rc != EOK)
+		goto error;
+	sif_journal_clear(sess);
+
+	sess->fname = str_dup(fname);
+	if (sess->fname == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	*rsess = sess;
+	return EOK;
+error:
+	free(sess->pending.data);
+	hash_table_destroy(&sess->nodes);
+	free(sess);
+	return rc;
 }
 
-/** Delete SIF attribute.
- *
- * Delete a SIF attribute that has been already unlinked from is node.
+/** Free a SIF session.
  *
- * @param attr Attribute
+ * @param sess SIF session
  */
-static void sif_attr_delete(sif_attr_t *attr)
+static void sif_sess_delete(sif_sess_t *sess)
 {
-	if (attr == NULL)
-		return;
-
-	assert(!odlink_used(&attr->lattrs));
-
-	if (attr->aname != NULL)
-		free(attr->aname);
-	if (attr->avalue != NULL)
-		free(attr->avalue);
-
-	free(attr);
+	sif_node_delete(sess->root);
+	sif_image_release(sess);
+	if (sess->fd >= 0)
+		vfs_put(sess->fd);
+	hash_table_destroy(&sess->nodes);
+	free(sess->pending.data);
+	if (sess->fname != NULL)
+		free(sess->fname);
+	free(sess);
 }
 
 /** Create and open a SIF repository.
@@ -181,63 +1430,80 @@ static void sif_attr_delete(sif_attr_t *attr)
 errno_t sif_create(const char *fname, sif_sess_t **rsess)
 {
 	sif_sess_t *sess;
-	sif_node_t *root = NULL;
-	sif_trans_t *trans = NULL;
+	sif_node_t *root;
+	aoff64_t size;
 	errno_t rc;
-	FILE *f;
-
-	sess = calloc(1, sizeof(sif_sess_t));
-	if (sess == NULL)
-		return ENOMEM;
 
-	sess->fname = str_dup(fname);
-	if (sess->fname == NULL) {
-		rc = ENOMEM;
-		goto error;
-	}
+	rc = sif_sess_new(fname, &sess);
+	if (rc != EOK)
+		return rc;
 
-	root = sif_node_new(NULL);
+	root = sif_node_new(sess, NULL, sess->next_nid++);
 	if (root == NULL) {
 		rc = ENOMEM;
 		goto error;
 	}
 
+	sess->root = root;
+
 	root->ntype = str_dup("sif");
 	if (root->ntype == NULL) {
 		rc = ENOMEM;
 		goto error;
 	}
 
-	f = fopen(fname, "wx");
-	if (f == NULL) {
+	rc = vfs_lookup_open(fname, WALK_REGULAR | WALK_MUST_CREATE,
+	    MODE_READ | MODE_WRITE, &sess->fd);
+	if (rc != EOK) {
 		rc = EIO;
 		goto error;
 	}
 
-	sess->f = f;
-	sess->root = root;
-
-	/* Run a dummy trasaction to marshall initial repo state to file */
-	rc = sif_trans_begin(sess, &trans);
+	/* Marshall initial repo state to file */
+	rc = sif_snapshot_write(sess, sess->fd, &size);
 	if (rc != EOK)
 		goto error;
 
-	rc = sif_trans_end(trans);
-	if (rc != EOK)
-		goto error;
+	sess->jstart = size;
+	sess->jend = size;
 
 	*rsess = sess;
 	return EOK;
 error:
-	if (trans != NULL)
-		sif_trans_abort(trans);
-	sif_node_delete(root);
-	if (sess->fname != NULL)
-		free(sess->fname);
-	free(sess);
+	sif_sess_delete(sess);
 	return rc;
 }
 
+/** Import a repository in the text format.
+ *
+ * @param sess SIF session
+ * @return EOK on success or error code
+ */
+static errno_t sif_open_text(sif_sess_t *sess)
+{
+	sif_node_t *root = NULL;
+	errno_t rc;
+	FILE *f;
+
+	f = fopen(sess->fname, "r");
+	if (f == NULL)
+		return EIO;
+
+	rc = sif_import_node(sess, NULL, f, &root);
+	(void) fclose(f);
+	if (rc != EOK)
+		return rc;
+
+	sess->root = root;
+
+	if (str_cmp(root->ntype, "sif") != 0)
+		return EIO;
+
+	/* The first commit converts the repository to the binary format */
+	sess->need_snapshot = true;
+	return EOK;
+}
+
 /** Open an existing SIF repository.
  *
  * @param fname File name
@@ -248,46 +1514,54 @@ error:
 errno_t sif_open(const char *fname, sif_sess_t **rsess)
 {
 	sif_sess_t *sess;
-	sif_node_t *root = NULL;
+	vfs_stat_t stat;
+	aoff64_t pos;
+	size_t nread;
+	char c;
 	errno_t rc;
-	FILE *f;
 
-	sess = calloc(1, sizeof(sif_sess_t));
-	if (sess == NULL)
-		return ENOMEM;
+	rc = sif_sess_new(fname, &sess);
+	if (rc != EOK)
+		return rc;
 
-	sess->fname = str_dup(fname);
-	if (sess->fname == NULL) {
-		rc = ENOMEM;
+	rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ | MODE_WRITE,
+	    &sess->fd);
+	if (rc != EOK) {
+		rc = EIO;
 		goto error;
 	}
 
-	f = fopen(fname, "r");
-	if (f == NULL) {
+	rc = vfs_stat(sess->fd, &stat);
+	if (rc != EOK) {
 		rc = EIO;
 		goto error;
 	}
 
-	rc = sif_import_node(NULL, f, &root);
-	if (rc != EOK)
-		goto error;
-
-	if (str_cmp(root->ntype, "sif") != 0) {
+	pos = 0;
+	rc = vfs_read(sess->fd, &pos, &c, 1, &nread);
+	if (rc != EOK || nread != 1) {
 		rc = EIO;
 		goto error;
 	}
 
-	sess->root = root;
+	if (c == '[') {
+		rc = sif_open_text(sess);
+		if (rc != EOK)
+			goto error;
+	} else {
+		rc = sif_image_load(sess, stat.size);
+		if (rc != EOK)
+			goto error;
+
+		rc = sif_journal_replay(sess, stat.size);
+		if (rc != EOK)
+			goto error;
+	}
 
-	sess->f = f;
-	sess->root = root;
 	*rsess = sess;
 	return EOK;
 error:
-	sif_node_delete(root);
-	if (sess->fname != NULL)
-		free(sess->fname);
-	free(sess);
+	sif_sess_delete(sess);
 	return rc;
 }
 
@@ -298,17 +1572,37 @@ error:
  */
 errno_t sif_close(sif_sess_t *sess)
 {
-	sif_node_delete(sess->root);
+	sif_sess_delete(sess);
+	return EOK;
+}
 
-	if (fclose(sess->f) < 0) {
-		free(sess);
+/** Export SIF repository in the text format.
+ *
+ * @param sess SIF session
+ * @param fname Name of the file to create or overwrite
+ * @return EOK on success or error code
+ */
+errno_t sif_export_text(sif_sess_t *sess, const char *fname)
+{
+	errno_t rc;
+	FILE *f;
+
+	rc = sif_node_load_all(sess->root);
+	if (rc != EOK)
+		return rc;
+
+	f = fopen(fname, "w");
+	if (f == NULL)
 		return EIO;
-	}
 
-	if (sess->fname != NULL)
-		free(sess->fname);
-	free(sess);
-	return EOK;
+	rc = sif_export_node(sess->root, f);
+	if (rc == EOK && fputc('\n', f) == EOF)
+		rc = EIO;
+
+	if (fclose(f) < 0 && rc == EOK)
+		rc = EIO;
+
+	return rc;
 }
 
 /** Return root node.
@@ -321,14 +1615,20 @@ sif_node_t *sif_get_root(sif_sess_t *sess)
 }
 
 /** Get first child of a node.
+ *
+ * Children are loaded from the repository on first access.
  *
  * @param parent Parent node
  * @return First child node or @c NULL if @a parent has no children
+ *         or they cannot be loaded
  */
 sif_node_t *sif_node_first_child(sif_node_t *parent)
 {
 	link_t *link;
 
+	if (sif_node_load_children(parent) != EOK)
+		return NULL;
+
 	link = list_first(&parent->children);
 	if (link == NULL)
 		return NULL;
@@ -405,34 +1705,37 @@ errno_t sif_trans_begin(sif_sess_t *sess, sif_trans_t **rtrans)
  * Commit and free the transaction. If an error is returned, that means
  * the transaction has not been freed (and sif_trans_abort() must be used).
  *
+ * The changes are appended to the journal, or a new snapshot is written
+ * if the journal has grown too large.
+ *
  * @param trans Transaction
  * @return EOK on success or error code
  */
 errno_t sif_trans_end(sif_trans_t *trans)
 {
+	sif_sess_t *sess = trans->sess;
+	aoff64_t jsize;
 	errno_t rc;
 
-	(void) fclose(trans->sess->f);
+	jsize = sess->jend - sess->jstart + sess->pending.size;
 
-	trans->sess->f = fopen(trans->sess->fname, "w");
-	if (trans->sess->f == NULL)
-		return EIO;
+	if (sess->need_snapshot ||
+	    jsize > max(sess->jstart, (aoff64_t) SIF_JOURNAL_MIN))
+		rc = sif_compact(sess);
+	else
+		rc = sif_journal_write(sess);
 
-	rc = sif_export_node(trans->sess->root, trans->sess->f);
 	if (rc != EOK)
 		return rc;
 
-	if (fputc('\n', trans->sess->f) == EOF)
-		return EIO;
-
-	if (fflush(trans->sess->f) == EOF)
-		return EIO;
-
 	free(trans);
 	return EOK;
 }
 
 /** Abort SIF transaction.
+ *
+ * Changes made within the transaction stay in memory and are written
+ * with the next committed transaction.
  *
  * @param trans Transaction
  */
@@ -441,6 +1744,45 @@ void sif_trans_abort(sif_trans_t *trans)
 	free(trans);
 }
 
+/** Create a new node and journal it.
+ *
+ * @param trans Transaction
+ * @param ref Reference node
+ * @param pos Position relative to @a ref
+ * @param ctype Node type
+ * @param rchild Place to store pointer to the new node
+ * @return EOK on success or ENOMEM if out of memory
+ */
+static errno_t sif_node_create(sif_trans_t *trans, sif_node_t *ref,
+    sif_pos_t pos, const char *ctype, sif_node_t **rchild)
+{
+	sif_sess_t *sess = trans->sess;
+	size_t psize = sess->pending.size;
+	uint32_t nid = sess->next_nid;
+	errno_t rc;
+
+	if (nid == UINT32_MAX)
+		return ENOMEM;
+
+	rc = sif_journal_op(sess, SIF_OP_NEW, nid);
+	if (rc == EOK)
+		rc = sif_wbuf_put_u8(&sess->pending, pos);
+	if (rc == EOK)
+		rc = sif_wbuf_put_u32(&sess->pending, ref->nid);
+	if (rc == EOK)
+		rc = sif_wbuf_put_str(&sess->pending, ctype);
+	if (rc == EOK)
+		rc = sif_node_insert(ref, pos, nid, ctype, rchild);
+
+	if (rc != EOK) {
+		sess->pending.size = psize;
+		return rc == EIO ? rc : ENOMEM;
+	}
+
+	sess->next_nid++;
+	return EOK;
+}
+
 /** Prepend new child.
  *
  * Create a new child and prepend it at the beginning of children list of
@@ -456,22 +1798,7 @@ void sif_trans_abort(sif_trans_t *trans)
 errno_t sif_node_prepend_child(sif_trans_t *trans, sif_node_t *parent,
     const char *ctype, sif_node_t **rchild)
 {
-	sif_node_t *child;
-
-	child = sif_node_new(parent);
-	if (child == NULL)
-		return ENOMEM;
-
-	child->ntype = str_dup(ctype);
-	if (child->ntype == NULL) {
-		sif_node_delete(child);
-		return ENOMEM;
-	}
-
-	list_prepend(&child->lparent, &parent->children);
-
-	*rchild = child;
-	return EOK;
+	return sif_node_create(trans, parent, SIF_POS_PREPEND, ctype, rchild);
 }
 
 /** Append new child.
@@ -488,22 +1815,7 @@ errno_t sif_node_prepend_child(sif_trans_t *trans, sif_node_t *parent,
 errno_t sif_node_append_child(sif_trans_t *trans, sif_node_t *parent,
     const char *ctype, sif_node_t **rchild)
 {
-	sif_node_t *child;
-
-	child = sif_node_new(parent);
-	if (child == NULL)
-		return ENOMEM;
-
-	child->ntype = str_dup(ctype);
-	if (child->ntype == NULL) {
-		sif_node_delete(child);
-		return ENOMEM;
-	}
-
-	list_append(&child->lparent, &parent->children);
-
-	*rchild = child;
-	return EOK;
+	return sif_node_create(trans, parent, SIF_POS_APPEND, ctype, rchild);
 }
 
 /** Insert new child before existing child.
@@ -520,22 +1832,7 @@ errno_t sif_node_append_child(sif_trans_t *trans, sif_node_t *parent,
 errno_t sif_node_insert_before(sif_trans_t *trans, sif_node_t *sibling,
     const char *ctype, sif_node_t **rchild)
 {
-	sif_node_t *child;
-
-	child = sif_node_new(sibling->parent);
-	if (child == NULL)
-		return ENOMEM;
-
-	child->ntype = str_dup(ctype);
-	if (child->ntype == NULL) {
-		sif_node_delete(child);
-		return ENOMEM;
-	}
-
-	list_insert_before(&child->lparent, &sibling->lparent);
-
-	*rchild = child;
-	return EOK;
+	return sif_node_create(trans, sibling, SIF_POS_BEFORE, ctype, rchild);
 }
 
 /** Insert new child after existing child.
@@ -552,22 +1849,7 @@ errno_t sif_node_insert_before(sif_trans_t *trans, sif_node_t *sibling,
 errno_t sif_node_insert_after(sif_trans_t *trans, sif_node_t *sibling,
     const char *ctype, sif_node_t **rchild)
 {
-	sif_node_t *child;
-
-	child = sif_node_new(sibling->parent);
-	if (child == NULL)
-		return ENOMEM;
-
-	child->ntype = str_dup(ctype);
-	if (child->ntype == NULL) {
-		sif_node_delete(child);
-		return ENOMEM;
-	}
-
-	list_insert_after(&child->lparent, &sibling->lparent);
-
-	*rchild = child;
-	return EOK;
+	return sif_node_create(trans, sibling, SIF_POS_AFTER, ctype, rchild);
 }
 
 /** Destroy SIF node.
@@ -580,6 +1862,14 @@ errno_t sif_node_insert_after(sif_trans_t *trans, sif_node_t *sibling,
  */
 void sif_node_destroy(sif_trans_t *trans, sif_node_t *node)
 {
+	sif_sess_t *sess = trans->sess;
+	size_t psize = sess->pending.size;
+
+	if (sif_journal_op(sess, SIF_OP_DESTROY, node->nid) != EOK) {
+		sess->pending.size = psize;
+		sess->need_snapshot = true;
+	}
+
 	list_remove(&node->lparent);
 	sif_node_delete(node);
 }
@@ -596,38 +1886,21 @@ void sif_node_destroy(sif_trans_t *trans, sif_node_t *node)
 errno_t sif_node_set_attr(sif_trans_t *trans, sif_node_t *node,
     const char *aname, const char *avalue)
 {
-	odlink_t *link;
-	sif_attr_t *attr;
-	char *cvalue;
-
-	link = odict_find_eq(&node->attrs, (void *)aname, NULL);
-
-	if (link != NULL) {
-		attr = odict_get_instance(link, sif_attr_t, lattrs);
-		cvalue = str_dup(avalue);
-		if (cvalue == NULL)
-			return ENOMEM;
-
-		free(attr->avalue);
-		attr->avalue = cvalue;
-	} else {
-		attr = sif_attr_new(node);
-		if (attr == NULL)
-			return ENOMEM;
-
-		attr->aname = str_dup(aname);
-		if (attr->aname == NULL) {
-			sif_attr_delete(attr);
-			return ENOMEM;
-		}
+	sif_sess_t *sess = trans->sess;
+	size_t psize = sess->pending.size;
+	errno_t rc;
 
-		attr->avalue = str_dup(avalue);
-		if (attr->avalue == NULL) {
-			sif_attr_delete(attr);
-			return ENOMEM;
-		}
+	rc = sif_journal_op(sess, SIF_OP_SET_ATTR, node->nid);
+	if (rc == EOK)
+		rc = sif_wbuf_put_str(&sess->pending, aname);
+	if (rc == EOK)
+		rc = sif_wbuf_put_str(&sess->pending, avalue);
+	if (rc == EOK)
+		rc = sif_node_attr_set(node, aname, avalue);
 
-		odict_insert(&attr->lattrs, &node->attrs, NULL);
+	if (rc != EOK) {
+		sess->pending.size = psize;
+		return ENOMEM;
 	}
 
 	return EOK;
@@ -645,16 +1918,23 @@ errno_t sif_node_set_attr(sif_trans_t *trans, sif_node_t *node,
 void sif_node_unset_attr(sif_trans_t *trans, sif_node_t *node,
     const char *aname)
 {
-	odlink_t *link;
-	sif_attr_t *attr;
+	sif_sess_t *sess = trans->sess;
+	size_t psize = sess->pending.size;
+	errno_t rc;
 
-	link = odict_find_eq(&node->attrs, (void *)aname, NULL);
-	if (link == NULL)
+	if (sif_node_get_attr(node, aname) == NULL)
 		return;
 
-	attr = odict_get_instance(link, sif_attr_t, lattrs);
-	odict_remove(link);
-	sif_attr_delete(attr);
+	rc = sif_journal_op(sess, SIF_OP_UNSET_ATTR, node->nid);
+	if (rc == EOK)
+		rc = sif_wbuf_put_str(&sess->pending, aname);
+
+	if (rc != EOK) {
+		sess->pending.size = psize;
+		sess->need_snapshot = true;
+	}
+
+	sif_node_attr_unset(node, aname);
 }
 
 /** Export string to file.
@@ -883,12 +2163,14 @@ static errno_t sif_export_node(sif_node_t *node, FILE *f)
 
 /** Import SIF node from file.
  *
+ * @param sess SIF session
  * @param parent Parent node
  * @param f File
  * @param rnode Place to store pointer to imported node
  * @return EOK on success, EIO on I/O error
  */
-static errno_t sif_import_node(sif_node_t *parent, FILE *f, sif_node_t **rnode)
+static errno_t sif_import_node(sif_sess_t *sess, sif_node_t *parent, FILE *f,
+    sif_node_t **rnode)
 {
 	errno_t rc;
 	sif_node_t *node = NULL;
@@ -897,7 +2179,7 @@ static errno_t sif_import_node(sif_node_t *parent, FILE *f, sif_node_t **rnode)
 	char *ntype;
 	int c;
 
-	node = sif_node_new(parent);
+	node = sif_node_new(sess, parent, sess->next_nid++);
 	if (node == NULL)
 		return ENOMEM;
 
@@ -954,7 +2236,7 @@ static errno_t sif_import_node(sif_node_t *parent, FILE *f, sif_node_t **rnode)
 	while (c != '}') {
 		ungetc(c, f);
 
-		rc = sif_import_node(node, f, &child);
+		rc = sif_import_node(sess, node, f, &child);
 		if (rc != EOK)
 			goto error;
 
@@ -601,4 +601,150 @@ PCUT_TEST(sif_persist)
 	PCUT_ASSERT_INT_EQUALS(0, rv);
 }
 
+/** Test persistence across many commits, journal replay and compaction. */
+PCUT_TEST(sif_persist_journal)
+{
+	sif_sess_t *sess;
+	sif_node_t *root;
+	sif_node_t *node;
+	sif_trans_t *trans;
+	errno_t rc;
+	int rv;
+	int i;
+	char *fname;
+	char *p;
+	char aval[16];
+
+	fname = calloc(L_tmpnam, 1);
+	PCUT_ASSERT_NOT_NULL(fname);
+
+	p = tmpnam(fname);
+	PCUT_ASSERT_TRUE(p == fname);
+
+	rc = sif_create(fname, &sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	root = sif_get_root(sess);
+
+	/* Enough commits for the journal to be compacted several times */
+	for (i = 0; i < 1000; i++) {
+		rc = sif_trans_begin(sess, &trans);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+		rc = sif_node_append_child(trans, root, "node", &node);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+		snprintf(aval, sizeof(aval), "%d", i);
+		rc = sif_node_set_attr(trans, node, "n", aval);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+		/* Destroy every other node again */
+		if (i % 2 != 0)
+			sif_node_destroy(trans, node);
+
+		rc = sif_trans_end(trans);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	}
+
+	rc = sif_close(sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Now reopen the repository */
+
+	rc = sif_open(fname, &sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	root = sif_get_root(sess);
+
+	node = sif_node_first_child(root);
+	for (i = 0; i < 1000; i += 2) {
+		PCUT_ASSERT_NOT_NULL(node);
+		snprintf(aval, sizeof(aval), "%d", i);
+		PCUT_ASSERT_INT_EQUALS(0, str_cmp(sif_node_get_attr(node, "n"),
+		    aval));
+		node = sif_node_next_child(node);
+	}
+
+	PCUT_ASSERT_NULL(node);
+
+	rc = sif_close(sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rv = remove(fname);
+	PCUT_ASSERT_INT_EQUALS(0, rv);
+}
+
+/** Test sif_export_text and opening a repository in the text format. */
+PCUT_TEST(sif_export_text)
+{
+	sif_sess_t *sess;
+	sif_node_t *root;
+	sif_node_t *node;
+	sif_trans_t *trans;
+	errno_t rc;
+	int rv;
+	char *fname;
+	char *tname;
+	char *p;
+	const char *aval;
+
+	fname = calloc(L_tmpnam, 1);
+	PCUT_ASSERT_NOT_NULL(fname);
+
+	p = tmpnam(fname);
+	PCUT_ASSERT_TRUE(p == fname);
+
+	tname = calloc(L_tmpnam, 1);
+	PCUT_ASSERT_NOT_NULL(tname);
+
+	p = tmpnam(tname);
+	PCUT_ASSERT_TRUE(p == tname);
+
+	rc = sif_create(fname, &sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	root = sif_get_root(sess);
+
+	rc = sif_trans_begin(sess, &trans);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = sif_node_append_child(trans, root, "node", &node);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = sif_node_set_attr(trans, node, "a", "[X]");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = sif_trans_end(trans);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = sif_export_text(sess, tname);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = sif_close(sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Open the exported copy */
+
+	rc = sif_open(tname, &sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	root = sif_get_root(sess);
+
+	node = sif_node_first_child(root);
+	PCUT_ASSERT_NOT_NULL(node);
+	PCUT_ASSERT_INT_EQUALS(0, str_cmp(sif_node_get_type(node), "node"));
+
+	aval = sif_node_get_attr(node, "a");
+	PCUT_ASSERT_INT_EQUALS(0, str_cmp(aval, "[X]"));
+
+	rc = sif_close(sess);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rv = remove(fname);
+	PCUT_ASSERT_INT_EQUALS(0, rv);
+
+	rv = remove(tname);
+	PCUT_ASSERT_INT_EQUALS(0, rv);
+}
+
 PCUT_EXPORT(sif);
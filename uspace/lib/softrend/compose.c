@@ -33,6 +33,7 @@
  * @file
  */
 
+#include <mem.h>
 #include "compose.h"
 
 pixel_t compose_clr(pixel_t fg, pixel_t bg)
@@ -50,7 +51,7 @@ pixel_t compose_dst(pixel_t fg, pixel_t bg)
 	return bg;
 }
 
-pixel_t compose_over(pixel_t fg, pixel_t bg)
+static inline pixel_t over(pixel_t fg, pixel_t bg)
 {
 	uint8_t res_a;
 	uint8_t res_r;
@@ -68,6 +69,11 @@ pixel_t compose_over(pixel_t fg, pixel_t bg)
 	return PIXEL(res_a, res_r, res_g, res_b);
 }
 
+pixel_t compose_over(pixel_t fg, pixel_t bg)
+{
+	return over(fg, bg);
+}
+
 pixel_t compose_in(pixel_t fg, pixel_t bg)
 {
 	// TODO
@@ -98,5 +104,57 @@ pixel_t compose_add(pixel_t fg, pixel_t bg)
 	return 0;
 }
 
+/** Copy a span of pixels.
+ *
+ * Span counterpart of compose_src().
+ *
+ * @param dst   Background pixels, replaced with the result
+ * @param src   Foreground pixels
+ * @param count Number of pixels
+ */
+void compose_src_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	memcpy(dst, src, count * sizeof(pixel_t));
+}
+
+/** Compose a span of pixels over another span.
+ *
+ * Span counterpart of compose_over(). The result is the same as of
+ * compose_over(), but opaque foreground pixels and transparent ones
+ * over an opaque background need no arithmetic at all.
+ *
+ * @param dst   Background pixels, replaced with the result
+ * @param src   Foreground pixels
+ * @param count Number of pixels
+ */
+void compose_over_span(pixel_t *dst, const pixel_t *src, size_t count)
+{
+	while (count-- != 0) {
+		pixel_t fg = *src++;
+
+		if (ALPHA(fg) == 255)
+			*dst = fg;
+		else if ((ALPHA(fg) != 0) || (ALPHA(*dst) != 255))
+			*dst = over(fg, *dst);
+
+		++dst;
+	}
+}
+
+/** Get span counterpart of a compose function.
+ *
+ * @param compose Compose function
+ * @return Span compose function or NULL if there is none
+ */
+compose_span_t compose_get_span(compose_t compose)
+{
+	if (compose == compose_src)
+		return compose_src_span;
+	if (compose == compose_over)
+		return compose_over_span;
+
+	return NULL;
+}
+
 /** @}
  */
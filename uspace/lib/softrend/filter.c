@@ -35,8 +35,18 @@
  */
 
 #include "filter.h"
+#include <stdint.h>
+#include <mem.h>
 #include <io/pixel.h>
 
+/** Fractional bits of the fixed-point texture coordinates */
+#define FIXED_SHIFT  16
+#define FIXED_ONE    (1 << FIXED_SHIFT)
+
+/** Fractional bits of the bilinear weights */
+#define WEIGHT_SHIFT  8
+#define WEIGHT_ONE    (1 << WEIGHT_SHIFT)
+
 static long _round(double val)
 {
 	return val > 0 ? (long) (val + 0.5) : (long) (val - 0.5);
@@ -110,6 +120,136 @@ pixel_t filter_bilinear(pixelmap_t *pixmap, double x, double y,
 	return blend_pixels(4, weights, pixels);
 }
 
+static int64_t _fixed(double val)
+{
+	return val > 0 ? (int64_t) (val * FIXED_ONE + 0.5) :
+	    (int64_t) (val * FIXED_ONE - 0.5);
+}
+
+/** Interpolate between two pixels.
+ *
+ * All four channels are processed at once, two of them in each half
+ * of a 32-bit word.
+ *
+ * @param a      First pixel
+ * @param b      Second pixel
+ * @param weight Weight of @a b in 1 / WEIGHT_ONE units
+ */
+static inline pixel_t lerp_pixels(pixel_t a, pixel_t b, unsigned weight)
+{
+	uint32_t rb = ((a & 0x00ff00ff) * (WEIGHT_ONE - weight) +
+	    (b & 0x00ff00ff) * weight) >> WEIGHT_SHIFT;
+	uint32_t ag = (((a >> 8) & 0x00ff00ff) * (WEIGHT_ONE - weight) +
+	    ((b >> 8) & 0x00ff00ff) * weight) >> WEIGHT_SHIFT;
+
+	return (rb & 0x00ff00ff) | ((ag & 0x00ff00ff) << 8);
+}
+
+/** Sample a span of pixels using nearest neighbour filtering.
+ *
+ * The texture coordinates advance by a constant step from one pixel to
+ * the next, which is the case for any affine transformation.
+ *
+ * @param pixmap Texture
+ * @param x      Texture X coordinate of the first pixel
+ * @param y      Texture Y coordinate of the first pixel
+ * @param dx     Texture X coordinate step
+ * @param dy     Texture Y coordinate step
+ * @param extend How to treat coordinates outside of the texture
+ * @param dst    Buffer for the sampled pixels
+ * @param count  Number of pixels
+ */
+void filter_nearest_span(pixelmap_t *pixmap, double x, double y,
+    double dx, double dy, pixelmap_extend_t extend, pixel_t *dst, size_t count)
+{
+	int64_t fx = _fixed(x) + FIXED_ONE / 2;
+	int64_t fy = _fixed(y) + FIXED_ONE / 2;
+	int64_t step_x = _fixed(dx);
+	int64_t step_y = _fixed(dy);
+
+	if ((step_x == FIXED_ONE) && (step_y == 0)) {
+		/* Consecutive pixels of a single row */
+		int64_t x1 = fx >> FIXED_SHIFT;
+		int64_t y1 = fy >> FIXED_SHIFT;
+
+		if ((x1 >= 0) && (y1 >= 0) &&
+		    ((uint64_t) x1 + count <= pixmap->width) &&
+		    ((uint64_t) y1 < pixmap->height)) {
+			memcpy(dst, pixelmap_pixel_at(pixmap, x1, y1),
+			    count * sizeof(pixel_t));
+			return;
+		}
+	}
+
+	while (count-- != 0) {
+		*dst++ = pixelmap_get_extended_pixel(pixmap, fx >> FIXED_SHIFT,
+		    fy >> FIXED_SHIFT, extend);
+		fx += step_x;
+		fy += step_y;
+	}
+}
+
+/** Sample a span of pixels using bilinear filtering.
+ *
+ * Same as filter_bilinear() for each pixel, except that coordinates and
+ * weights are computed in fixed point.
+ *
+ * @param pixmap Texture
+ * @param x      Texture X coordinate of the first pixel
+ * @param y      Texture Y coordinate of the first pixel
+ * @param dx     Texture X coordinate step
+ * @param dy     Texture Y coordinate step
+ * @param extend How to treat coordinates outside of the texture
+ * @param dst    Buffer for the sampled pixels
+ * @param count  Number of pixels
+ */
+void filter_bilinear_span(pixelmap_t *pixmap, double x, double y,
+    double dx, double dy, pixelmap_extend_t extend, pixel_t *dst, size_t count)
+{
+	int64_t fx = _fixed(x);
+	int64_t fy = _fixed(y);
+	int64_t step_x = _fixed(dx);
+	int64_t step_y = _fixed(dy);
+	unsigned int wmask = WEIGHT_ONE - 1;
+
+	if (((fx & (FIXED_ONE - 1)) == 0) && ((fy & (FIXED_ONE - 1)) == 0) &&
+	    (step_x == FIXED_ONE) && (step_y == 0)) {
+		/* No interpolation needed at all */
+		filter_nearest_span(pixmap, x, y, dx, dy, extend, dst, count);
+		return;
+	}
+
+	while (count-- != 0) {
+		native_t x1 = fx >> FIXED_SHIFT;
+		native_t y1 = fy >> FIXED_SHIFT;
+		unsigned int wx = (fx >> (FIXED_SHIFT - WEIGHT_SHIFT)) & wmask;
+		unsigned int wy = (fy >> (FIXED_SHIFT - WEIGHT_SHIFT)) & wmask;
+
+		pixel_t top = pixelmap_get_extended_pixel(pixmap,
+		    x1, y1, extend);
+		if (wx != 0) {
+			top = lerp_pixels(top, pixelmap_get_extended_pixel(
+			    pixmap, x1 + 1, y1, extend), wx);
+		}
+
+		if (wy != 0) {
+			pixel_t bottom = pixelmap_get_extended_pixel(pixmap,
+			    x1, y1 + 1, extend);
+			if (wx != 0) {
+				bottom = lerp_pixels(bottom,
+				    pixelmap_get_extended_pixel(pixmap,
+				    x1 + 1, y1 + 1, extend), wx);
+			}
+
+			top = lerp_pixels(top, bottom, wy);
+		}
+
+		*dst++ = top;
+		fx += step_x;
+		fy += step_y;
+	}
+}
+
 pixel_t filter_bicubic(pixelmap_t *pixmap, double x, double y,
     pixelmap_extend_t extend)
 {
@@ -36,6 +36,7 @@
 #ifndef SOFTREND_FILTER_H_
 #define SOFTREND_FILTER_H_
 
+#include <stddef.h>
 #include <io/pixelmap.h>
 
 typedef pixel_t (*filter_t)(pixelmap_t *, double, double, pixelmap_extend_t);
@@ -44,6 +45,11 @@ extern pixel_t filter_nearest(pixelmap_t *, double, double, pixelmap_extend_t);
 extern pixel_t filter_bilinear(pixelmap_t *, double, double, pixelmap_extend_t);
 extern pixel_t filter_bicubic(pixelmap_t *, double, double, pixelmap_extend_t);
 
+extern void filter_nearest_span(pixelmap_t *, double, double, double, double,
+    pixelmap_extend_t, pixel_t *, size_t);
+extern void filter_bilinear_span(pixelmap_t *, double, double, double, double,
+    pixelmap_extend_t, pixel_t *, size_t);
+
 #endif
 
 /** @}
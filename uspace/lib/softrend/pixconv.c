@@ -147,6 +147,42 @@ void pixel2gray_8(void *dst, pixel_t pix)
 	*((uint8_t *) dst) = (red + green + blue) >> 24;
 }
 
+/** Span pixel conversion functions
+ *
+ * These functions render a run of consecutive pixels in the same way
+ * as the single pixel conversion functions, without an indirect call
+ * per pixel.
+ */
+
+#define PIXEL2VISUAL_SPAN(visual, bytes) \
+	void pixel2 ## visual ## _span(void *dst, const pixel_t *src, \
+	    size_t count) \
+	{ \
+		uint8_t *pos = (uint8_t *) dst; \
+		\
+		while (count-- != 0) { \
+			pixel2 ## visual(pos, *src++); \
+			pos += (bytes); \
+		} \
+	}
+
+PIXEL2VISUAL_SPAN(argb_8888, 4)
+PIXEL2VISUAL_SPAN(abgr_8888, 4)
+PIXEL2VISUAL_SPAN(rgba_8888, 4)
+PIXEL2VISUAL_SPAN(bgra_8888, 4)
+PIXEL2VISUAL_SPAN(rgb_0888, 4)
+PIXEL2VISUAL_SPAN(bgr_0888, 4)
+PIXEL2VISUAL_SPAN(rgb_8880, 4)
+PIXEL2VISUAL_SPAN(bgr_8880, 4)
+PIXEL2VISUAL_SPAN(rgb_888, 3)
+PIXEL2VISUAL_SPAN(bgr_888, 3)
+PIXEL2VISUAL_SPAN(rgb_555_be, 2)
+PIXEL2VISUAL_SPAN(rgb_555_le, 2)
+PIXEL2VISUAL_SPAN(rgb_565_be, 2)
+PIXEL2VISUAL_SPAN(rgb_565_le, 2)
+PIXEL2VISUAL_SPAN(bgr_323, 1)
+PIXEL2VISUAL_SPAN(gray_8, 1)
+
 void visual_mask_8888(void *dst, bool mask)
 {
 	pixel2abgr_8888(dst, mask ? 0xffffffff : 0);
@@ -148,13 +148,16 @@ void transform_scale(transform_t *trans, double qx, double qy)
 void transform_rotate(transform_t *trans, double angle)
 {
 	transform_t a;
+	double s, c;
 
-	a.matrix[0][0] = cos(angle);
-	a.matrix[1][0] = sin(angle);
+	sincos(angle, &s, &c);
+
+	a.matrix[0][0] = c;
+	a.matrix[1][0] = s;
 	a.matrix[2][0] = 0;
 
-	a.matrix[0][1] = -sin(angle);
-	a.matrix[1][1] = cos(angle);
+	a.matrix[0][1] = -s;
+	a.matrix[1][1] = c;
 	a.matrix[2][1] = 0;
 
 	a.matrix[0][2] = 0;
@@ -174,6 +177,25 @@ bool transform_is_fast(transform_t *trans)
 	    ((trans->matrix[1][2] - trunc(trans->matrix[1][2])) == 0.0));
 }
 
+/** Determine class of an affine transformation.
+ *
+ * @param trans Transformation
+ * @return The cheapest class describing the transformation
+ */
+transform_class_t transform_classify(const transform_t *trans)
+{
+	if ((trans->matrix[0][1] != 0) || (trans->matrix[1][0] != 0))
+		return TRANSFORM_GENERAL;
+
+	if ((trans->matrix[0][0] != 1) || (trans->matrix[1][1] != 1))
+		return TRANSFORM_SCALE;
+
+	if ((trans->matrix[0][2] != 0) || (trans->matrix[1][2] != 0))
+		return TRANSFORM_TRANSLATION;
+
+	return TRANSFORM_IDENTITY;
+}
+
 void transform_apply_linear(const transform_t *trans, double *x, double *y)
 {
 	double old_x = *x;
@@ -44,6 +44,18 @@ typedef struct {
 	double matrix[TRANSFORM_MATRIX_DIM][TRANSFORM_MATRIX_DIM];
 } transform_t;
 
+/** Class of affine transformation, from the cheapest to apply */
+typedef enum {
+	/** No transformation at all */
+	TRANSFORM_IDENTITY,
+	/** Translation only */
+	TRANSFORM_TRANSLATION,
+	/** Scaling along the axes, possibly with translation */
+	TRANSFORM_SCALE,
+	/** Any other affine transformation */
+	TRANSFORM_GENERAL
+} transform_class_t;
+
 extern void transform_product(transform_t *, const transform_t *,
     const transform_t *);
 extern void transform_invert(transform_t *);
@@ -54,6 +66,7 @@ extern void transform_scale(transform_t *, double, double);
 extern void transform_rotate(transform_t *, double);
 
 extern bool transform_is_fast(transform_t *);
+extern transform_class_t transform_classify(const transform_t *);
 
 extern void transform_apply_linear(const transform_t *, double *, double *);
 extern void transform_apply_affine(const transform_t *, double *, double *);
@@ -32,14 +32,112 @@
 /** @file
  */
 
+#include <adt/list.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <macros.h>
+#include <mem.h>
+#include <perf.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <str.h>
 #include <str_error.h>
 #include <vfs/vfs.h>
 #include "private/tar.h"
 #include "untar.h"
 
+/** Size of one read-ahead buffer */
+#define UNTAR_INPUT_SIZE  (256 * 1024)
+
+/** Number of read-ahead buffers */
+#define UNTAR_INPUTS  4
+
+/** File contents are written in chunks of this size */
+#define UNTAR_CHUNK_SIZE  (128 * 1024)
+
+/** Number of chunks that can be queued for writing */
+#define UNTAR_CHUNKS  8
+
+/** Number of fibrils writing the chunks */
+#define UNTAR_WRITERS  4
+
+/** Read-ahead buffer */
+typedef struct {
+	uint8_t *data;
+	/** Valid bytes */
+	size_t size;
+} untar_input_t;
+
+/** File being extracted */
+typedef struct {
+	/** Link to untar_t.files */
+	link_t lfiles;
+	int fd;
+	/** Chunks queued or being written */
+	size_t pending;
+	/** All chunks of the file have been queued */
+	bool done;
+	/** Failure to write the file has been reported */
+	bool failed;
+	char filename[100];
+} untar_out_file_t;
+
+/** Chunk of file contents */
+typedef struct {
+	/** Link to untar_t.free_chunks or untar_t.queue */
+	link_t lchunks;
+	untar_out_file_t *file;
+	aoff64_t pos;
+	size_t size;
+	uint8_t *data;
+} untar_chunk_t;
+
+/** Extraction in progress
+ *
+ * The archive is read ahead by a separate fibril into a ring of large
+ * buffers. File contents are cut into chunks which a pool of fibrils
+ * writes, so that data of several files can be in flight at once.
+ */
+typedef struct {
+	tar_file_t *tar;
+	fibril_mutex_t lock;
+
+	untar_input_t inputs[UNTAR_INPUTS];
+	/** First filled buffer */
+	size_t in_head;
+	/** Number of filled buffers */
+	size_t in_count;
+	/** Offset of the next byte in the first filled buffer */
+	size_t in_pos;
+	/** The last buffer has been read */
+	bool in_eof;
+	/** Error of the read that hit the end */
+	errno_t in_rc;
+	/** The reader should stop */
+	bool in_stop;
+	bool reader_running;
+	fibril_condvar_t in_filled;
+	fibril_condvar_t in_freed;
+
+	untar_chunk_t chunks[UNTAR_CHUNKS];
+	list_t free_chunks;
+	/** Chunks waiting to be written */
+	list_t queue;
+	/** Files with chunks in flight */
+	list_t files;
+	/** The writers should stop after the queue is drained */
+	bool out_stop;
+	/** First write error */
+	errno_t out_rc;
+	size_t writers;
+	fibril_condvar_t chunk_freed;
+	fibril_condvar_t queued;
+	fibril_condvar_t file_closed;
+	fibril_condvar_t writer_exited;
+} untar_t;
+
 static size_t get_block_count(size_t bytes)
 {
 	return (bytes + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE;
@@ -70,93 +168,535 @@ static void tar_report(tar_file_t *tar, const char *fmt, ...)
 	va_end(args);
 }
 
-static errno_t tar_skip_blocks(tar_file_t *tar, size_t valid_data_size)
+/** Fill a read-ahead buffer.
+ *
+ * Some sources cannot satisfy a read which crosses their end, so the
+ * rest of a short read is retried block by block.
+ *
+ * @param tar  Archive
+ * @param data Buffer of UNTAR_INPUT_SIZE bytes
+ * @param rc   Place to store the error code of a short read
+ * @return Number of bytes read
+ */
+static size_t untar_input_fill(tar_file_t *tar, uint8_t *data, errno_t *rc)
+{
+	size_t size = tar_read(tar, data, UNTAR_INPUT_SIZE);
+
+	while (size < UNTAR_INPUT_SIZE) {
+		size_t nread = tar_read(tar, data + size,
+		    min(TAR_BLOCK_SIZE, UNTAR_INPUT_SIZE - size));
+
+		size += nread;
+		if (nread != TAR_BLOCK_SIZE) {
+			*rc = errno;
+			break;
+		}
+	}
+
+	return size;
+}
+
+/** Read-ahead fibril */
+static errno_t untar_reader(void *arg)
+{
+	untar_t *ut = (untar_t *) arg;
+
+	fibril_mutex_lock(&ut->lock);
+
+	while (!ut->in_stop && !ut->in_eof) {
+		if (ut->in_count == UNTAR_INPUTS) {
+			fibril_condvar_wait(&ut->in_freed, &ut->lock);
+			continue;
+		}
+
+		/* The consumer does not touch buffers that are not filled */
+		untar_input_t *input =
+		    &ut->inputs[(ut->in_head + ut->in_count) % UNTAR_INPUTS];
+		errno_t rc = EOK;
+
+		fibril_mutex_unlock(&ut->lock);
+		size_t size = untar_input_fill(ut->tar, input->data, &rc);
+		fibril_mutex_lock(&ut->lock);
+
+		input->size = size;
+		ut->in_count++;
+
+		if (size < UNTAR_INPUT_SIZE) {
+			ut->in_eof = true;
+			ut->in_rc = rc;
+		}
+
+		fibril_condvar_broadcast(&ut->in_filled);
+	}
+
+	ut->reader_running = false;
+	fibril_condvar_broadcast(&ut->in_filled);
+	fibril_mutex_unlock(&ut->lock);
+	return EOK;
+}
+
+/** Read data of the archive.
+ *
+ * @param ut   Extraction
+ * @param data Buffer or @c NULL to skip the data
+ * @param size Number of bytes to read
+ * @return Number of bytes read, less than @a size at the end of input
+ */
+static size_t untar_read(untar_t *ut, void *data, size_t size)
+{
+	uint8_t *dest = (uint8_t *) data;
+	size_t done = 0;
+
+	fibril_mutex_lock(&ut->lock);
+
+	while (done < size) {
+		if (ut->in_count == 0) {
+			if (ut->in_eof || !ut->reader_running)
+				break;
+
+			fibril_condvar_wait(&ut->in_filled, &ut->lock);
+			continue;
+		}
+
+		untar_input_t *input = &ut->inputs[ut->in_head];
+
+		if (ut->in_pos == input->size) {
+			ut->in_head = (ut->in_head + 1) % UNTAR_INPUTS;
+			ut->in_count--;
+			ut->in_pos = 0;
+			fibril_condvar_broadcast(&ut->in_freed);
+			continue;
+		}
+
+		/* The buffer stays ours until it is released */
+		size_t cnt = min(size - done, input->size - ut->in_pos);
+		size_t pos = ut->in_pos;
+
+		fibril_mutex_unlock(&ut->lock);
+		if (dest != NULL)
+			memcpy(dest + done, input->data + pos, cnt);
+		fibril_mutex_lock(&ut->lock);
+
+		ut->in_pos += cnt;
+		done += cnt;
+	}
+
+	fibril_mutex_unlock(&ut->lock);
+	return done;
+}
+
+/** Get the error code of a read that came short. */
+static errno_t untar_read_error(untar_t *ut)
+{
+	fibril_mutex_lock(&ut->lock);
+	errno_t rc = (ut->in_rc != EOK) ? ut->in_rc : EIO;
+	fibril_mutex_unlock(&ut->lock);
+
+	return rc;
+}
+
+static errno_t tar_skip_blocks(untar_t *ut, size_t valid_data_size)
+{
+	size_t bytes = get_block_count(valid_data_size) * TAR_BLOCK_SIZE;
+
+	if (untar_read(ut, NULL, bytes) != bytes)
+		return untar_read_error(ut);
+
+	return EOK;
+}
+
+/** Close a file whose data have all been written.
+ *
+ * Called with the lock held, which is dropped meanwhile.
+ */
+static void untar_file_close(untar_t *ut, untar_out_file_t *file)
+{
+	list_remove(&file->lfiles);
+
+	fibril_mutex_unlock(&ut->lock);
+	vfs_put(file->fd);
+	free(file);
+	fibril_mutex_lock(&ut->lock);
+
+	fibril_condvar_broadcast(&ut->file_closed);
+}
+
+/** Writer fibril */
+static errno_t untar_writer(void *arg)
 {
-	size_t blocks_to_read = get_block_count(valid_data_size);
+	untar_t *ut = (untar_t *) arg;
+
+	fibril_mutex_lock(&ut->lock);
 
-	while (blocks_to_read > 0) {
-		uint8_t block[TAR_BLOCK_SIZE];
-		size_t actually_read = tar_read(tar, block, TAR_BLOCK_SIZE);
-		if (actually_read != TAR_BLOCK_SIZE)
-			return errno;
+	while (true) {
+		if (list_empty(&ut->queue)) {
+			if (ut->out_stop)
+				break;
+
+			fibril_condvar_wait(&ut->queued, &ut->lock);
+			continue;
+		}
+
+		untar_chunk_t *chunk = list_get_instance(list_first(&ut->queue),
+		    untar_chunk_t, lchunks);
+		untar_out_file_t *file = chunk->file;
+
+		list_remove(&chunk->lchunks);
+
+		errno_t rc = EOK;
+		size_t nwr = 0;
+		aoff64_t pos = chunk->pos;
+
+		/* Writes of later chunks are not held up by parsing */
+		if (!file->failed) {
+			fibril_mutex_unlock(&ut->lock);
+			rc = vfs_write(file->fd, &pos, chunk->data,
+			    chunk->size, &nwr);
+			fibril_mutex_lock(&ut->lock);
+		}
 
-		blocks_to_read--;
+		if ((rc == EOK) && (nwr != chunk->size))
+			rc = EIO;
+
+		if ((rc != EOK) && !file->failed) {
+			file->failed = true;
+			if (ut->out_rc == EOK)
+				ut->out_rc = rc;
+
+			tar_report(ut->tar, "Failed to write to %s: %s.\n",
+			    file->filename, str_error(rc));
+		}
+
+		list_append(&chunk->lchunks, &ut->free_chunks);
+		fibril_condvar_broadcast(&ut->chunk_freed);
+
+		file->pending--;
+		if ((file->done) && (file->pending == 0))
+			untar_file_close(ut, file);
 	}
 
+	ut->writers--;
+	fibril_condvar_broadcast(&ut->writer_exited);
+	fibril_mutex_unlock(&ut->lock);
 	return EOK;
 }
 
-static errno_t tar_handle_normal_file(tar_file_t *tar,
+/** Get a free chunk.
+ *
+ * @param ut     Extraction
+ * @param rchunk Place to store the chunk
+ * @return EOK on success or the error of an earlier write
+ */
+static errno_t untar_chunk_get(untar_t *ut, untar_chunk_t **rchunk)
+{
+	fibril_mutex_lock(&ut->lock);
+
+	while ((ut->out_rc == EOK) && list_empty(&ut->free_chunks))
+		fibril_condvar_wait(&ut->chunk_freed, &ut->lock);
+
+	errno_t rc = ut->out_rc;
+	if (rc == EOK) {
+		*rchunk = list_get_instance(list_first(&ut->free_chunks),
+		    untar_chunk_t, lchunks);
+		list_remove(&(*rchunk)->lchunks);
+	}
+
+	fibril_mutex_unlock(&ut->lock);
+	return rc;
+}
+
+/** Return an unused chunk. */
+static void untar_chunk_put(untar_t *ut, untar_chunk_t *chunk)
+{
+	fibril_mutex_lock(&ut->lock);
+	list_append(&chunk->lchunks, &ut->free_chunks);
+	fibril_condvar_broadcast(&ut->chunk_freed);
+	fibril_mutex_unlock(&ut->lock);
+}
+
+/** Queue a chunk for writing. */
+static void untar_chunk_submit(untar_t *ut, untar_chunk_t *chunk)
+{
+	fibril_mutex_lock(&ut->lock);
+	chunk->file->pending++;
+	list_append(&chunk->lchunks, &ut->queue);
+	fibril_condvar_signal(&ut->queued);
+	fibril_mutex_unlock(&ut->lock);
+}
+
+/** Note that all chunks of a file have been queued. */
+static void untar_file_done(untar_t *ut, untar_out_file_t *file)
+{
+	fibril_mutex_lock(&ut->lock);
+	file->done = true;
+	if (file->pending == 0)
+		untar_file_close(ut, file);
+	fibril_mutex_unlock(&ut->lock);
+}
+
+/** Wait until a file of the given name is no longer being written.
+ *
+ * An archive may contain several versions of one file, the later one
+ * must not be truncated under the writes of the earlier one.
+ */
+static void untar_file_wait(untar_t *ut, const char *filename)
+{
+	fibril_mutex_lock(&ut->lock);
+
+	while (true) {
+		bool busy = false;
+
+		list_foreach(ut->files, lfiles, untar_out_file_t, file) {
+			if (str_cmp(file->filename, filename) == 0) {
+				busy = true;
+				break;
+			}
+		}
+
+		if (!busy)
+			break;
+
+		fibril_condvar_wait(&ut->file_closed, &ut->lock);
+	}
+
+	fibril_mutex_unlock(&ut->lock);
+}
+
+static errno_t tar_handle_normal_file(untar_t *ut,
     const tar_header_t *header)
 {
+	tar_file_t *tar = ut->tar;
+	int fd;
+
 	// FIXME: create the directory first
 
-	FILE *file = fopen(header->filename, "wb");
-	if (file == NULL) {
+	untar_file_wait(ut, header->filename);
+
+	errno_t rc = vfs_lookup_open(header->filename,
+	    WALK_REGULAR | WALK_MAY_CREATE, MODE_WRITE, &fd);
+	if (rc == EOK) {
+		rc = vfs_resize(fd, 0);
+		if (rc != EOK)
+			vfs_put(fd);
+	}
+
+	if (rc != EOK) {
 		tar_report(tar, "Failed to create %s: %s.\n", header->filename,
-		    str_error(errno));
-		return errno;
+		    str_error(rc));
+		return rc;
+	}
+
+	untar_out_file_t *file = calloc(1, sizeof(untar_out_file_t));
+	if (file == NULL) {
+		vfs_put(fd);
+		return ENOMEM;
 	}
 
-	errno_t rc = EOK;
+	file->fd = fd;
+	str_cpy(file->filename, sizeof(file->filename), header->filename);
+
+	fibril_mutex_lock(&ut->lock);
+	list_append(&file->lfiles, &ut->files);
+	fibril_mutex_unlock(&ut->lock);
+
 	size_t bytes_remaining = header->size;
-	size_t blocks = get_block_count(bytes_remaining);
+	aoff64_t pos = 0;
+
+	while (bytes_remaining > 0) {
+		untar_chunk_t *chunk;
+		rc = untar_chunk_get(ut, &chunk);
+		if (rc != EOK)
+			break;
 
-	while (blocks > 0) {
-		uint8_t block[TAR_BLOCK_SIZE];
-		size_t actually_read = tar_read(tar, block, TAR_BLOCK_SIZE);
-		if (actually_read != TAR_BLOCK_SIZE) {
-			rc = errno;
+		size_t cnt = min(bytes_remaining, UNTAR_CHUNK_SIZE);
+		if (untar_read(ut, chunk->data, cnt) != cnt) {
+			rc = untar_read_error(ut);
 			tar_report(tar, "Failed to read block for %s: %s.\n",
 			    header->filename, str_error(rc));
+			untar_chunk_put(ut, chunk);
 			break;
 		}
 
-		size_t to_write = TAR_BLOCK_SIZE;
-		if (bytes_remaining < TAR_BLOCK_SIZE)
-			to_write = bytes_remaining;
+		chunk->file = file;
+		chunk->pos = pos;
+		chunk->size = cnt;
+		untar_chunk_submit(ut, chunk);
 
-		size_t actually_written = fwrite(block, 1, to_write, file);
-		if (actually_written != to_write) {
-			rc = errno;
-			tar_report(tar, "Failed to write to %s: %s.\n",
-			    header->filename, str_error(rc));
-			break;
-		}
+		pos += cnt;
+		bytes_remaining -= cnt;
+	}
 
-		blocks--;
-		bytes_remaining -= TAR_BLOCK_SIZE;
+	/* Skip the padding of the last block */
+	if (rc == EOK) {
+		size_t padding = get_block_count(header->size) *
+		    TAR_BLOCK_SIZE - header->size;
+		if (untar_read(ut, NULL, padding) != padding)
+			rc = untar_read_error(ut);
 	}
 
-	fclose(file);
+	untar_file_done(ut, file);
 	return rc;
 }
 
-static errno_t tar_handle_directory(tar_file_t *tar, const tar_header_t *header)
+static errno_t tar_handle_directory(untar_t *ut, const tar_header_t *header)
 {
 	errno_t rc = vfs_link_path(header->filename, KIND_DIRECTORY, NULL);
 	if (rc != EOK) {
 		if (rc != EEXIST) {
-			tar_report(tar, "Failed to create directory %s: %s.\n",
+			tar_report(ut->tar,
+			    "Failed to create directory %s: %s.\n",
 			    header->filename, str_error(rc));
 			return rc;
 		}
 	}
 
-	return tar_skip_blocks(tar, header->size);
+	return tar_skip_blocks(ut, header->size);
+}
+
+static void untar_destroy(untar_t *ut)
+{
+	for (size_t i = 0; i < UNTAR_INPUTS; i++)
+		free(ut->inputs[i].data);
+
+	for (size_t i = 0; i < UNTAR_CHUNKS; i++)
+		free(ut->chunks[i].data);
+
+	free(ut);
+}
+
+static untar_t *untar_create(tar_file_t *tar)
+{
+	untar_t *ut = calloc(1, sizeof(untar_t));
+	if (ut == NULL)
+		return NULL;
+
+	ut->tar = tar;
+	fibril_mutex_initialize(&ut->lock);
+	fibril_condvar_initialize(&ut->in_filled);
+	fibril_condvar_initialize(&ut->in_freed);
+	fibril_condvar_initialize(&ut->chunk_freed);
+	fibril_condvar_initialize(&ut->queued);
+	fibril_condvar_initialize(&ut->file_closed);
+	fibril_condvar_initialize(&ut->writer_exited);
+	list_initialize(&ut->free_chunks);
+	list_initialize(&ut->queue);
+	list_initialize(&ut->files);
+
+	for (size_t i = 0; i < UNTAR_INPUTS; i++) {
+		ut->inputs[i].data = malloc(UNTAR_INPUT_SIZE);
+		if (ut->inputs[i].data == NULL)
+			goto error;
+	}
+
+	for (size_t i = 0; i < UNTAR_CHUNKS; i++) {
+		ut->chunks[i].data = malloc(UNTAR_CHUNK_SIZE);
+		if (ut->chunks[i].data == NULL)
+			goto error;
+
+		list_append(&ut->chunks[i].lchunks, &ut->free_chunks);
+	}
+
+	return ut;
+
+error:
+	untar_destroy(ut);
+	return NULL;
+}
+
+/** Start the reader and writer fibrils.
+ *
+ * @return EOK on success or ENOMEM if the fibrils cannot be created
+ */
+static errno_t untar_start(untar_t *ut)
+{
+	fid_t fids[UNTAR_WRITERS + 1];
+	size_t i;
+
+	fids[0] = fibril_create(untar_reader, ut);
+	for (i = 1; i <= UNTAR_WRITERS; i++)
+		fids[i] = fibril_create(untar_writer, ut);
+
+	for (i = 0; i <= UNTAR_WRITERS; i++) {
+		if (fids[i] == 0)
+			break;
+	}
+
+	if (i <= UNTAR_WRITERS) {
+		for (i = 0; i <= UNTAR_WRITERS; i++) {
+			if (fids[i] != 0)
+				fibril_destroy(fids[i]);
+		}
+
+		return ENOMEM;
+	}
+
+	ut->reader_running = true;
+	ut->writers = UNTAR_WRITERS;
+
+	for (i = 0; i <= UNTAR_WRITERS; i++)
+		fibril_add_ready(fids[i]);
+
+	return EOK;
+}
+
+/** Finish the writes and stop the reader and writer fibrils.
+ *
+ * @return EOK or the first write error
+ */
+static errno_t untar_stop(untar_t *ut)
+{
+	fibril_mutex_lock(&ut->lock);
+
+	ut->out_stop = true;
+	fibril_condvar_broadcast(&ut->queued);
+
+	while (ut->writers > 0)
+		fibril_condvar_wait(&ut->writer_exited, &ut->lock);
+
+	ut->in_stop = true;
+	fibril_condvar_broadcast(&ut->in_freed);
+
+	while (ut->reader_running)
+		fibril_condvar_wait(&ut->in_filled, &ut->lock);
+
+	errno_t rc = ut->out_rc;
+	fibril_mutex_unlock(&ut->lock);
+	return rc;
 }
 
 int untar(tar_file_t *tar)
 {
+	stopwatch_t sw;
+
+	memset(&tar->stats, 0, sizeof(tar->stats));
+	stopwatch_init(&sw);
+	stopwatch_start(&sw);
+
 	int rc = tar_open(tar);
 	if (rc != EOK) {
 		tar_report(tar, "Failed to open: %s.\n", str_error(rc));
 		return rc;
 	}
 
+	untar_t *ut = untar_create(tar);
+	if (ut == NULL) {
+		tar_report(tar, "Failed to open: %s.\n", str_error(ENOMEM));
+		tar_close(tar);
+		return ENOMEM;
+	}
+
+	rc = untar_start(ut);
+	if (rc != EOK) {
+		tar_report(tar, "Failed to open: %s.\n", str_error(rc));
+		untar_destroy(ut);
+		tar_close(tar);
+		return rc;
+	}
+
 	while (true) {
 		tar_header_raw_t header_raw;
-		size_t header_ok = tar_read(tar, &header_raw, sizeof(header_raw));
+		size_t header_ok = untar_read(ut, &header_raw,
+		    sizeof(header_raw));
 		if (header_ok != sizeof(header_raw))
 			break;
 
@@ -172,13 +712,19 @@ int untar(tar_file_t *tar)
 
 		switch (header.type) {
 		case TAR_TYPE_DIRECTORY:
-			rc = tar_handle_directory(tar, &header);
+			rc = tar_handle_directory(ut, &header);
+			if (rc == EOK)
+				tar->stats.directories++;
 			break;
 		case TAR_TYPE_NORMAL:
-			rc = tar_handle_normal_file(tar, &header);
+			rc = tar_handle_normal_file(ut, &header);
+			if (rc == EOK) {
+				tar->stats.files++;
+				tar->stats.bytes += header.size;
+			}
 			break;
 		default:
-			rc = tar_skip_blocks(tar, header.size);
+			rc = tar_skip_blocks(ut, header.size);
 			break;
 		}
 
@@ -186,7 +732,12 @@ int untar(tar_file_t *tar)
 			break;
 	}
 
+	(void) untar_stop(ut);
+	untar_destroy(ut);
 	tar_close(tar);
+
+	stopwatch_stop(&sw);
+	tar->stats.nsec = stopwatch_get_nanos(&sw);
 	return EOK;
 }
 
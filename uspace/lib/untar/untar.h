@@ -37,6 +37,20 @@
 
 #include <stdlib.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <time.h>
+
+/** Statistics of an extraction */
+typedef struct {
+	/** Number of extracted files */
+	size_t files;
+	/** Number of extracted directories */
+	size_t directories;
+	/** Total size of the extracted files */
+	uint64_t bytes;
+	/** Duration of the extraction */
+	nsec_t nsec;
+} untar_stats_t;
 
 typedef struct tar_file {
 	void *data;
@@ -46,6 +60,9 @@ typedef struct tar_file {
 
 	size_t (*read)(struct tar_file *, void *, size_t);
 	void (*vreport)(struct tar_file *, const char *, va_list);
+
+	/** Filled in by untar() */
+	untar_stats_t stats;
 } tar_file_t;
 
 extern int untar(tar_file_t *);
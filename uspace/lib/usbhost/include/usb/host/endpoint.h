@@ -65,7 +65,7 @@ typedef struct usb_transfer_batch usb_transfer_batch_t;
  * concrete instance of mutex can be unknown at the time of initialization,
  * the HC shall pass the right lock at the time of onlining the endpoint.
  *
- * The fields used for scheduling (online, active_batch) are to be used only
+ * The fields used for scheduling (online, active_batches) are to be used only
  * under that guard and by functions designed for this purpose. The driver can
  * also completely avoid using this mechanism, in which case it is on its own in
  * question of transfer aborting.
@@ -83,11 +83,29 @@ typedef struct endpoint {
 	fibril_mutex_t *guard;
 	/** Whether it's allowed to schedule on this endpoint */
 	bool online;
-	/** The currently active transfer batch. */
-	usb_transfer_batch_t *active_batch;
+	/** Batches being processed, oldest first (of usb_transfer_batch_t) */
+	list_t active_batches;
+	/** Number of batches in active_batches */
+	size_t active_count;
+	/**
+	 * Number of batches the HC can process at once. One by default,
+	 * the HC driver can raise it when initializing the endpoint.
+	 */
+	size_t max_active_batches;
 	/** Signals change of active status. */
 	fibril_condvar_t avail;
 
+	/** Guards batch_cache, independently of the inherited guard */
+	fibril_mutex_t batch_cache_guard;
+	/**
+	 * Finished batches kept for further transfers, together with their
+	 * DMA buffers (of usb_transfer_batch_t). Holds at most
+	 * max_active_batches batches, no endpoint references.
+	 */
+	list_t batch_cache;
+	/** Number of batches in batch_cache */
+	size_t batch_cache_count;
+
 	/** Endpoint number */
 	usb_endpoint_t endpoint;
 	/** Communication direction. */
@@ -126,7 +144,10 @@ extern void endpoint_set_offline_locked(endpoint_t *);
 
 extern void endpoint_wait_timeout_locked(endpoint_t *ep, usec_t);
 extern int endpoint_activate_locked(endpoint_t *, usb_transfer_batch_t *);
-extern void endpoint_deactivate_locked(endpoint_t *);
+extern void endpoint_deactivate_locked(endpoint_t *, usb_transfer_batch_t *);
+extern usb_transfer_batch_t *endpoint_first_active_locked(endpoint_t *);
+extern usb_transfer_batch_t *endpoint_next_active_locked(endpoint_t *,
+    usb_transfer_batch_t *);
 
 int endpoint_send_batch(endpoint_t *, const transfer_request_t *);
 
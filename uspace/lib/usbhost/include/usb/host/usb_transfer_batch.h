@@ -62,6 +62,8 @@ typedef struct usb_transfer_batch {
 
 	/** Endpoint used for communication */
 	endpoint_t *ep;
+	/** Link in ep->active_batches */
+	link_t active_link;
 
 	/** Place to store SETUP data needed by control transfers */
 	union {
@@ -81,6 +83,10 @@ typedef struct usb_transfer_batch {
 	 */
 	char *original_buffer;
 	bool is_bounced;
+	/** Bounce buffer kept allocated for further transfers */
+	dma_buffer_t bounce_buffer;
+	/** Size of bounce_buffer */
+	size_t bounce_size;
 
 	/** Indicates success/failure of the communication */
 	errno_t error;
@@ -115,6 +121,15 @@ usb_transfer_batch_t *usb_transfer_batch_create(endpoint_t *);
 /** Batch initializer. */
 void usb_transfer_batch_init(usb_transfer_batch_t *, endpoint_t *);
 
+/** Disposal of batches cached by an endpoint. */
+void usb_transfer_batch_cache_flush(endpoint_t *);
+
+/** Get the beginning of the transferred data in the DMA buffer. */
+static inline void *usb_transfer_batch_data(const usb_transfer_batch_t *batch)
+{
+	return batch->dma_buffer.virt + batch->offset;
+}
+
 /** Buffer handling */
 bool usb_transfer_batch_bounce_required(usb_transfer_batch_t *);
 errno_t usb_transfer_batch_bounce(usb_transfer_batch_t *);
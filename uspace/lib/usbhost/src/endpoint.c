@@ -59,7 +59,11 @@ void endpoint_init(endpoint_t *ep, device_t *dev, const usb_endpoint_descriptors
 	ep->device = dev;
 
 	refcount_init(&ep->refcnt);
+	list_initialize(&ep->active_batches);
+	ep->max_active_batches = 1;
 	fibril_condvar_initialize(&ep->avail);
+	fibril_mutex_initialize(&ep->batch_cache_guard);
+	list_initialize(&ep->batch_cache);
 
 	ep->endpoint = USB_ED_GET_EP(desc->endpoint);
 	ep->direction = USB_ED_GET_DIR(desc->endpoint);
@@ -98,10 +102,13 @@ void endpoint_add_ref(endpoint_t *ep)
 static inline void endpoint_destroy(endpoint_t *ep)
 {
 	const bus_ops_t *ops = get_bus_ops(ep);
+
+	usb_transfer_batch_cache_flush(ep);
+
 	if (ops->endpoint_destroy) {
 		ops->endpoint_destroy(ep);
 	} else {
-		assert(ep->active_batch == NULL);
+		assert(list_empty(&ep->active_batches));
 
 		/* Assume mostly the eps will be allocated by malloc. */
 		free(ep);
@@ -142,22 +149,24 @@ void endpoint_set_offline_locked(endpoint_t *ep)
 
 /**
  * Wait until a transfer finishes. Can be used even when the endpoint is
- * offline (and is interrupted by the endpoint going offline).
+ * offline (and is interrupted by the endpoint going offline). Returns
+ * immediately if there are no active transfers.
  */
 void endpoint_wait_timeout_locked(endpoint_t *ep, usec_t timeout)
 {
 	assert(ep);
 	assert(fibril_mutex_is_locked(ep->guard));
 
-	if (ep->active_batch == NULL)
+	if (list_empty(&ep->active_batches))
 		return;
 
 	fibril_condvar_wait_timeout(&ep->avail, ep->guard, timeout);
 }
 
 /**
- * Mark the endpoint as active and block access for further fibrils. If the
- * endpoint is already active, it will block on ep->avail condvar.
+ * Add a batch to the active batches of the endpoint. If the endpoint already
+ * has ep->max_active_batches active batches, it will block on ep->avail
+ * condvar until one of them is deactivated.
  *
  * Call only under endpoint guard. After you activate the endpoint and release
  * the guard, you must assume that particular transfer is already
@@ -167,7 +176,7 @@ void endpoint_wait_timeout_locked(endpoint_t *ep, usec_t timeout)
  * performance. The HC might want to prepare some memory buffers prior to
  * interfering with other world.
  *
- * @param batch Transfer batch this endpoint is blocked by.
+ * @param batch Transfer batch to activate.
  */
 int endpoint_activate_locked(endpoint_t *ep, usb_transfer_batch_t *batch)
 {
@@ -177,27 +186,67 @@ int endpoint_activate_locked(endpoint_t *ep, usb_transfer_batch_t *batch)
 	assert(ep->guard);
 	assert(fibril_mutex_is_locked(ep->guard));
 
-	while (ep->online && ep->active_batch != NULL)
+	while (ep->online && ep->active_count >= ep->max_active_batches)
 		fibril_condvar_wait(&ep->avail, ep->guard);
 
 	if (!ep->online)
 		return EINTR;
 
-	assert(ep->active_batch == NULL);
-	ep->active_batch = batch;
+	list_append(&batch->active_link, &ep->active_batches);
+	ep->active_count++;
 	return EOK;
 }
 
 /**
- * Mark the endpoint as inactive and allow access for further fibrils.
+ * Remove a batch from the active batches of the endpoint and wake up fibrils
+ * waiting to activate a batch or for a transfer to finish.
+ *
+ * @param batch Active transfer batch, it does not need to be the oldest one.
+ */
+void endpoint_deactivate_locked(endpoint_t *ep, usb_transfer_batch_t *batch)
+{
+	assert(ep);
+	assert(batch);
+	assert(batch->ep == ep);
+	assert(fibril_mutex_is_locked(ep->guard));
+	assert(link_in_use(&batch->active_link));
+	assert(ep->active_count > 0);
+
+	list_remove(&batch->active_link);
+	ep->active_count--;
+	fibril_condvar_broadcast(&ep->avail);
+}
+
+/**
+ * Get the oldest active batch of the endpoint.
+ *
+ * @return The batch activated first or NULL if there is none.
+ */
+usb_transfer_batch_t *endpoint_first_active_locked(endpoint_t *ep)
+{
+	assert(ep);
+	assert(fibril_mutex_is_locked(ep->guard));
+
+	link_t *link = list_first(&ep->active_batches);
+	return link ? list_get_instance(link, usb_transfer_batch_t,
+	    active_link) : NULL;
+}
+
+/**
+ * Get the active batch activated after the given one.
+ *
+ * @return The next active batch or NULL if @a batch is the newest one.
  */
-void endpoint_deactivate_locked(endpoint_t *ep)
+usb_transfer_batch_t *endpoint_next_active_locked(endpoint_t *ep,
+    usb_transfer_batch_t *batch)
 {
 	assert(ep);
+	assert(batch);
 	assert(fibril_mutex_is_locked(ep->guard));
 
-	ep->active_batch = NULL;
-	fibril_condvar_signal(&ep->avail);
+	link_t *link = list_next(&batch->active_link, &ep->active_batches);
+	return link ? list_get_instance(link, usb_transfer_batch_t,
+	    active_link) : NULL;
 }
 
 /**
@@ -267,14 +316,20 @@ errno_t endpoint_send_batch(endpoint_t *ep, const transfer_request_t *req)
 
 	dma_buffer_acquire(&batch->dma_buffer);
 
-	if (batch->offset != 0) {
-		usb_log_debug("A transfer with nonzero offset requested.");
-		usb_transfer_batch_bounce(batch);
+	/*
+	 * HCs handle buffers at any offset, so a buffer satisfying the
+	 * endpoint policy is passed to the HW directly.
+	 */
+	if (usb_transfer_batch_bounce_required(batch)) {
+		const errno_t err = usb_transfer_batch_bounce(batch);
+		if (err != EOK) {
+			usb_log_error("Failed to allocate bounce buffer: %s",
+			    str_error(err));
+			usb_transfer_batch_destroy(batch);
+			return err;
+		}
 	}
 
-	if (usb_transfer_batch_bounce_required(batch))
-		usb_transfer_batch_bounce(batch);
-
 	batch->on_complete = req->on_complete;
 	batch->on_complete_data = req->arg;
 
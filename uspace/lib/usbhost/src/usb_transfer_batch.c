@@ -33,8 +33,10 @@
  * USB transfer transaction structures (implementation).
  */
 
+#include <align.h>
 #include <assert.h>
 #include <errno.h>
+#include <mem.h>
 #include <stdlib.h>
 #include <str_error.h>
 #include <usb/debug.h>
@@ -44,15 +46,95 @@
 
 #include "usb_transfer_batch.h"
 
+/**
+ * Take a finished batch from the endpoint cache and make it a fresh one.
+ *
+ * The HC-specific part of the batch is left intact, so that the HC can reuse
+ * the memory it has allocated for the previous transfer.
+ */
+static usb_transfer_batch_t *batch_cache_get(endpoint_t *ep)
+{
+	fibril_mutex_lock(&ep->batch_cache_guard);
+	link_t *link = list_first(&ep->batch_cache);
+	if (link) {
+		list_remove(link);
+		ep->batch_cache_count--;
+	}
+	fibril_mutex_unlock(&ep->batch_cache_guard);
+
+	if (!link)
+		return NULL;
+
+	usb_transfer_batch_t *batch =
+	    list_get_instance(link, usb_transfer_batch_t, active_link);
+
+	const dma_buffer_t bounce_buffer = batch->bounce_buffer;
+	const size_t bounce_size = batch->bounce_size;
+
+	memset(batch, 0, sizeof(usb_transfer_batch_t));
+	batch->bounce_buffer = bounce_buffer;
+	batch->bounce_size = bounce_size;
+
+	usb_transfer_batch_init(batch, ep);
+	return batch;
+}
+
+/**
+ * Keep a batch in the endpoint cache, if there is room for it.
+ *
+ * @return Whether the batch was cached.
+ */
+static bool batch_cache_put(endpoint_t *ep, usb_transfer_batch_t *batch)
+{
+	assert(!link_in_use(&batch->active_link));
+
+	bool cached = false;
+
+	fibril_mutex_lock(&ep->batch_cache_guard);
+	if (ep->batch_cache_count < ep->max_active_batches) {
+		list_append(&batch->active_link, &ep->batch_cache);
+		ep->batch_cache_count++;
+		cached = true;
+	}
+	fibril_mutex_unlock(&ep->batch_cache_guard);
+
+	return cached;
+}
+
+/**
+ * Free the batch memory. If there's no bus callback, just free it.
+ */
+static void batch_free(usb_transfer_batch_t *batch)
+{
+	bus_t *bus = endpoint_get_bus(batch->ep);
+
+	dma_buffer_free(&batch->bounce_buffer);
+
+	if (bus->ops->batch_destroy) {
+		usb_log_debug2("Batch %p " USB_TRANSFER_BATCH_FMT " destroying.",
+		    batch, USB_TRANSFER_BATCH_ARGS(*batch));
+		bus->ops->batch_destroy(batch);
+	} else {
+		usb_log_debug2("Batch %p " USB_TRANSFER_BATCH_FMT " disposing.",
+		    batch, USB_TRANSFER_BATCH_ARGS(*batch));
+		free(batch);
+	}
+}
+
 /**
  * Create a batch on a given endpoint.
  *
- * If the bus callback is not defined, it just creates a default batch.
+ * A batch left over by a finished transfer is reused if possible. If the bus
+ * callback is not defined, it just creates a default batch.
  */
 usb_transfer_batch_t *usb_transfer_batch_create(endpoint_t *ep)
 {
 	assert(ep);
 
+	usb_transfer_batch_t *batch = batch_cache_get(ep);
+	if (batch)
+		return batch;
+
 	bus_t *bus = endpoint_get_bus(ep);
 
 	if (!bus->ops->batch_create) {
@@ -75,33 +157,47 @@ void usb_transfer_batch_init(usb_transfer_batch_t *batch, endpoint_t *ep)
 	/* Batch reference */
 	endpoint_add_ref(ep);
 	batch->ep = ep;
+	link_initialize(&batch->active_link);
 }
 
 /**
- * Destroy the batch. If there's no bus callback, just free it.
+ * Destroy the batch. It is kept in the endpoint cache for further transfers,
+ * unless the cache is full.
  */
 void usb_transfer_batch_destroy(usb_transfer_batch_t *batch)
 {
 	assert(batch);
 	assert(batch->ep);
 
-	bus_t *bus = endpoint_get_bus(batch->ep);
 	endpoint_t *ep = batch->ep;
 
-	if (bus->ops) {
-		usb_log_debug2("Batch %p " USB_TRANSFER_BATCH_FMT " destroying.",
-		    batch, USB_TRANSFER_BATCH_ARGS(*batch));
-		bus->ops->batch_destroy(batch);
-	} else {
-		usb_log_debug2("Batch %p " USB_TRANSFER_BATCH_FMT " disposing.",
-		    batch, USB_TRANSFER_BATCH_ARGS(*batch));
-		free(batch);
-	}
+	if (!batch_cache_put(ep, batch))
+		batch_free(batch);
 
 	/* Batch reference */
 	endpoint_del_ref(ep);
 }
 
+/**
+ * Free all batches cached by the endpoint. Called when the endpoint is being
+ * destroyed.
+ */
+void usb_transfer_batch_cache_flush(endpoint_t *ep)
+{
+	assert(ep);
+
+	fibril_mutex_lock(&ep->batch_cache_guard);
+	while (!list_empty(&ep->batch_cache)) {
+		usb_transfer_batch_t *batch = list_get_instance(
+		    list_first(&ep->batch_cache), usb_transfer_batch_t,
+		    active_link);
+		list_remove(&batch->active_link);
+		ep->batch_cache_count--;
+		batch_free(batch);
+	}
+	fibril_mutex_unlock(&ep->batch_cache_guard);
+}
+
 bool usb_transfer_batch_bounce_required(usb_transfer_batch_t *batch)
 {
 	if (!batch->size)
@@ -144,10 +240,22 @@ errno_t usb_transfer_batch_bounce(usb_transfer_batch_t *batch)
 	usb_log_debug("Batch(%p): Buffer cannot be used directly, "
 	    "falling back to bounce buffer!", batch);
 
-	const errno_t err = dma_buffer_alloc_policy(&batch->dma_buffer,
-	    batch->size, batch->ep->transfer_buffer_policy);
-	if (err)
-		return err;
+	/* Reuse the bounce buffer of a previous transfer if large enough */
+	if (batch->bounce_size < batch->size) {
+		dma_buffer_free(&batch->bounce_buffer);
+		batch->bounce_size = 0;
+
+		const size_t size = ALIGN_UP(batch->size, PAGE_SIZE);
+		const errno_t err = dma_buffer_alloc_policy(
+		    &batch->bounce_buffer, size,
+		    batch->ep->transfer_buffer_policy);
+		if (err)
+			return err;
+
+		batch->bounce_size = size;
+	}
+
+	batch->dma_buffer = batch->bounce_buffer;
 
 	/* Copy the data out */
 	if (batch->dir == USB_DIRECTION_OUT)
@@ -158,7 +266,7 @@ errno_t usb_transfer_batch_bounce(usb_transfer_batch_t *batch)
 	batch->is_bounced = true;
 	batch->offset = 0;
 
-	return err;
+	return EOK;
 }
 
 /**
@@ -174,18 +282,16 @@ void usb_transfer_batch_finish(usb_transfer_batch_t *batch)
 	usb_log_debug2("Batch %p " USB_TRANSFER_BATCH_FMT " finishing.",
 	    batch, USB_TRANSFER_BATCH_ARGS(*batch));
 
-	if (batch->error == EOK && batch->size > 0) {
-		if (batch->is_bounced) {
-			/* We we're forced to use bounce buffer, copy it back */
-			if (batch->dir == USB_DIRECTION_IN)
-				memcpy(batch->original_buffer,
-				    batch->dma_buffer.virt,
-				    batch->transferred_size);
-
-			dma_buffer_free(&batch->dma_buffer);
-		} else {
-			dma_buffer_release(&batch->dma_buffer);
-		}
+	if (batch->is_bounced) {
+		/* We we're forced to use bounce buffer, copy it back */
+		if (batch->error == EOK && batch->dir == USB_DIRECTION_IN)
+			memcpy(batch->original_buffer,
+			    batch->dma_buffer.virt,
+			    batch->transferred_size);
+
+		/* The bounce buffer itself stays with the batch for reuse */
+	} else if (batch->error == EOK && batch->size > 0) {
+		dma_buffer_release(&batch->dma_buffer);
 	}
 
 	if (batch->on_complete) {
@@ -31,6 +31,7 @@
 
 #include "virtio-pci.h"
 
+#include <assert.h>
 #include <ddf/driver.h>
 #include <ddf/log.h>
 #include <pci_dev_iface.h>
@@ -119,7 +120,8 @@ static void virtio_pci_device_cfg(virtio_dev_t *vdev, uint8_t bar,
 	ddf_msg(LVL_NOTE, "device_cfg=%p", vdev->device_cfg);
 }
 
-static errno_t enable_resources(async_sess_t *pci_sess, virtio_dev_t *vdev)
+static errno_t enable_resources(async_sess_t *pci_sess,
+    pci_config_cache_t *pci_cfg, virtio_dev_t *vdev)
 {
 	pio_window_t pio_window;
 	errno_t rc = pio_window_get(pci_sess, &pio_window);
@@ -142,11 +144,8 @@ static errno_t enable_resources(async_sess_t *pci_sess, virtio_dev_t *vdev)
 	for (unsigned i = 0, j = 0; i < PCI_BAR_COUNT && j < hw_res.count;
 	    i++) {
 		/* Detect and skip unused BARs */
-		uint32_t bar;
-		rc = pci_config_space_read_32(pci_sess,
-		    PCI_BAR0 + i * sizeof(uint32_t), &bar);
-		if (rc != EOK)
-			return rc;
+		uint32_t bar = pci_config_cache_get_32(pci_cfg,
+		    PCI_BAR0 + i * sizeof(uint32_t));
 		if (!bar)
 			continue;
 
@@ -185,55 +184,41 @@ errno_t virtio_pci_dev_initialize(ddf_dev_t *dev, virtio_dev_t *vdev)
 	if (!pci_sess)
 		return ENOENT;
 
-	errno_t rc = enable_resources(pci_sess, vdev);
+	vdev->pci_sess = pci_sess;
+
+	/* Fetch the BARs and capabilities in one go */
+	pci_config_cache_t pci_cfg;
+	errno_t rc = pci_config_cache_init(&pci_cfg, pci_sess);
+	if (rc != EOK)
+		return rc;
+
+	rc = enable_resources(pci_sess, &pci_cfg, vdev);
 	if (rc != EOK)
 		goto error;
 
 	/*
 	 * Find the VIRTIO PCI Capabilities
 	 */
-	uint8_t c;
-	uint8_t cap_vndr;
-	for (rc = pci_config_space_cap_first(pci_sess, &c, &cap_vndr);
-	    (rc == EOK) && c;
-	    rc = pci_config_space_cap_next(pci_sess, &c, &cap_vndr)) {
-		if (cap_vndr != PCI_CAP_VENDORSPECID)
-			continue;
-
-		uint8_t cap_len;
-		rc = pci_config_space_read_8(pci_sess,
-		    VIRTIO_PCI_CAP_CAP_LEN(c), &cap_len);
-		if (rc != EOK)
-			goto error;
-
-		if (cap_len < VIRTIO_PCI_CAP_END(0)) {
+	for (uint8_t c = pci_config_cache_cap_find(&pci_cfg,
+	    PCI_CAP_VENDORSPECID, 0); c != 0;
+	    c = pci_config_cache_cap_find(&pci_cfg, PCI_CAP_VENDORSPECID, c)) {
+		uint8_t cap_len = pci_config_cache_get_8(&pci_cfg,
+		    VIRTIO_PCI_CAP_CAP_LEN(c));
+
+		if (cap_len < VIRTIO_PCI_CAP_END(0) ||
+		    c + cap_len > PCI_CONFIG_SPACE_SIZE) {
 			rc = EINVAL;
 			goto error;
 		}
 
-		uint8_t cfg_type;
-		rc = pci_config_space_read_8(pci_sess,
-		    VIRTIO_PCI_CAP_CFG_TYPE(c), &cfg_type);
-		if (rc != EOK)
-			goto error;
-
-		uint8_t bar;
-		rc = pci_config_space_read_8(pci_sess, VIRTIO_PCI_CAP_BAR(c),
-		    &bar);
-		if (rc != EOK)
-			goto error;
-
-		uint32_t offset;
-		rc = pci_config_space_read_32(pci_sess,
-		    VIRTIO_PCI_CAP_OFFSET(c), &offset);
-		if (rc != EOK)
-			goto error;
-
-		uint32_t length;
-		rc = pci_config_space_read_32(pci_sess,
-		    VIRTIO_PCI_CAP_LENGTH(c), &length);
-		if (rc != EOK)
-			goto error;
+		uint8_t cfg_type = pci_config_cache_get_8(&pci_cfg,
+		    VIRTIO_PCI_CAP_CFG_TYPE(c));
+		uint8_t bar = pci_config_cache_get_8(&pci_cfg,
+		    VIRTIO_PCI_CAP_BAR(c));
+		uint32_t offset = pci_config_cache_get_32(&pci_cfg,
+		    VIRTIO_PCI_CAP_OFFSET(c));
+		uint32_t length = pci_config_cache_get_32(&pci_cfg,
+		    VIRTIO_PCI_CAP_LENGTH(c));
 
 		uint32_t multiplier;
 		switch (cfg_type) {
@@ -245,10 +230,8 @@ errno_t virtio_pci_dev_initialize(ddf_dev_t *dev, virtio_dev_t *vdev)
 				rc = EINVAL;
 				goto error;
 			}
-			rc = pci_config_space_read_32(pci_sess,
-			    VIRTIO_PCI_CAP_END(c), &multiplier);
-			if (rc != EOK)
-				goto error;
+			multiplier = pci_config_cache_get_32(&pci_cfg,
+			    VIRTIO_PCI_CAP_END(c));
 			virtio_pci_notify_cfg(vdev, bar, offset, length,
 			    multiplier);
 			break;
@@ -287,8 +270,84 @@ errno_t virtio_pci_dev_cleanup(virtio_dev_t *vdev)
 			virtio_virtq_teardown(vdev, i);
 		free(vdev->queues);
 	}
+
+	if (vdev->msix_count > 0) {
+		(void) pci_msi_disable(vdev->pci_sess);
+		vdev->msix_count = 0;
+	}
+
 	return disable_resources(vdev);
 }
 
+/** Switch the device to MSI-X interrupts.
+ *
+ * Must be called before the virtqueues are set up. Virtqueue @c n then
+ * signals vector @c n, or the last vector if there are fewer vectors than
+ * virtqueues. With MSI-X the device does not use the ISR status register,
+ * so there is no need to read it to find out whether it interrupted.
+ *
+ * @param vdev  VIRTIO device
+ * @param count Number of vectors, typically one per virtqueue
+ *
+ * @return EOK on success, ENOTSUP if the device must keep using INT#x
+ */
+errno_t virtio_pci_msix_enable(virtio_dev_t *vdev, unsigned int count)
+{
+	unsigned int granted;
+	int irq;
+
+	errno_t rc = pci_msi_enable(vdev->pci_sess, count, &irq, &granted);
+	if (rc != EOK)
+		return ENOTSUP;
+
+	/* Sharing vectors between queues would defeat the purpose */
+	if (granted != count) {
+		(void) pci_msi_disable(vdev->pci_sess);
+		return ENOTSUP;
+	}
+
+	vdev->msix_irq = irq;
+	vdev->msix_count = count;
+
+	ddf_msg(LVL_NOTE, "Using MSI-X irqs %d-%d", irq,
+	    irq + (int) count - 1);
+	return EOK;
+}
+
+/** Top-half code of MSI-X vectors, there is no status to look at */
+static irq_cmd_t virtio_msix_irq_commands[] = {
+	{
+		.cmd = CMD_ACCEPT
+	}
+};
+
+/** Register an interrupt handler for an MSI-X vector.
+ *
+ * @param dev     DDF device
+ * @param vdev    VIRTIO device with MSI-X enabled
+ * @param vector  Vector number
+ * @param handler Interrupt handler
+ * @param handle  Place to store the IRQ capability handle
+ *
+ * @return EOK on success or an error code
+ */
+errno_t virtio_pci_msix_register(ddf_dev_t *dev, virtio_dev_t *vdev,
+    unsigned int vector, interrupt_handler_t *handler,
+    cap_irq_handle_t *handle)
+{
+	irq_code_t irq_code = {
+		.rangecount = 0,
+		.ranges = NULL,
+		.cmdcount = sizeof(virtio_msix_irq_commands) /
+		    sizeof(irq_cmd_t),
+		.cmds = virtio_msix_irq_commands
+	};
+
+	assert(vector < vdev->msix_count);
+
+	return register_interrupt_handler(dev, vdev->msix_irq + vector,
+	    handler, &irq_code, handle);
+}
+
 /** @}
  */
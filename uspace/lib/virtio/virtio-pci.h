@@ -33,6 +33,7 @@
 #define _VIRTIO_PCI_H_
 
 #include <ddf/driver.h>
+#include <ddf/interrupt.h>
 #include <pci_dev_iface.h>
 #include <ddi.h>
 #include <fibril_synch.h>
@@ -62,6 +63,16 @@
 #define VIRTIO_FEATURES_32_63	1
 
 #define VIRTIO_F_VERSION_1	1
+/** The packed virtqueue layout is supported (feature bit 34) */
+#define VIRTIO_F_RING_PACKED	4
+
+/** No MSI-X vector is assigned */
+#define VIRTIO_MSI_NO_VECTOR	0xffff
+
+/** Descriptors may refer to tables of indirect descriptors */
+#define VIRTIO_RING_F_INDIRECT_DESC	(1U << 28)
+/** The used_event and avail_event fields are used */
+#define VIRTIO_RING_F_EVENT_IDX		(1U << 29)
 
 /** Common configuration structure layout according to VIRTIO version 1.0 */
 typedef struct virtio_pci_common_cfg {
@@ -118,6 +129,32 @@ typedef struct virtq_used_elem {
 
 #define VIRTQ_USED_F_NO_NOTIFY	1
 
+/** The descriptor is available, compared with the driver's wrap counter */
+#define VIRTQ_DESC_F_AVAIL	(1 << 7)
+/** The descriptor is used, compared with the driver's wrap counter */
+#define VIRTQ_DESC_F_USED	(1 << 15)
+
+/** Packed Virtqueue Descriptor structure as per VIRTIO version 1.1 */
+typedef struct virtq_pdesc {
+	ioport64_t addr;	/**< Buffer physical address */
+	ioport32_t len;		/**< Buffer length */
+	ioport16_t id;		/**< Buffer ID */
+	ioport16_t flags;	/**< Descriptor flags */
+} virtq_pdesc_t;
+
+#define VIRTQ_EVENT_F_ENABLE	0
+#define VIRTQ_EVENT_F_DISABLE	1
+#define VIRTQ_EVENT_F_DESC	2
+
+/** Wrap counter bit of the event offset */
+#define VIRTQ_EVENT_WRAP	(1 << 15)
+
+/** Event suppression structure of packed virtqueues */
+typedef struct virtq_event {
+	ioport16_t off_wrap;
+	ioport16_t flags;
+} virtq_event_t;
+
 /** Virtqueue Used Ring as per VIRTIO version 1.0 */
 typedef struct virtq_used {
 	ioport16_t flags;
@@ -143,13 +180,43 @@ typedef struct {
 	 */
 	size_t queue_size;
 
-	/** Virtual address of queue size virtq descriptors */
+	/**
+	 * Virtual address of queue size virtq descriptors. With the packed
+	 * layout, the device does not see this table. Drivers keep filling
+	 * it in and the descriptor chains are copied to the packed ring when
+	 * they become available.
+	 */
 	virtq_desc_t *desc;
 	/** Virtual address of the available ring */
 	virtq_avail_t *avail;
 	/** Virtual address of the used ring */
 	virtq_used_t *used;
 	uint16_t used_last_idx;
+	/** Index of the next available ring entry */
+	uint16_t avail_idx;
+
+	/** Descriptors made available since the device was last notified */
+	uint16_t added;
+
+	/** Notifications and interrupts are suppressed with event indices */
+	bool event_idx;
+
+	/** The packed virtqueue layout is used */
+	bool packed;
+	/** Packed descriptor ring */
+	virtq_pdesc_t *ring;
+	/** Driver event suppression structure */
+	virtq_event_t *driver_event;
+	/** Device event suppression structure */
+	virtq_event_t *device_event;
+	/** Next ring slot to make available and its wrap counter */
+	uint16_t avail_next;
+	bool avail_wrap;
+	/** Next ring slot to be used and its wrap counter */
+	uint16_t used_next;
+	bool used_wrap;
+	/** Number of ring slots taken by each buffer, indexed by buffer ID */
+	uint16_t *chain_len;
 
 	/** Address of the queue's notification register */
 	ioport16_t *notify;
@@ -176,17 +243,36 @@ typedef struct {
 	ioport8_t *isr;
 	uintptr_t isr_phys;
 
+	/** Session to the PCI function */
+	async_sess_t *pci_sess;
+	/** Number of MSI-X vectors, zero if INT#x is used */
+	unsigned int msix_count;
+	/** IRQ number of the first MSI-X vector */
+	int msix_irq;
+
 	/** Device-specific configuration */
 	void *device_cfg;
 
 	/** Virtqueues */
 	virtq_t *queues;
+
+	/** Accepted device-specific and ring feature bits */
+	uint32_t features;
+
+	/**
+	 * Set by the driver before virtio_device_setup_start() to use the
+	 * packed virtqueue layout if the device supports it. Cleared if it
+	 * does not.
+	 */
+	bool packed;
 } virtio_dev_t;
 
 extern errno_t virtio_setup_dma_bufs(unsigned int, size_t, bool, void *[],
     uintptr_t []);
 extern void virtio_teardown_dma_bufs(void *[]);
 
+extern void virtio_desc_table_set(virtq_desc_t *, uint16_t, uint64_t, uint32_t,
+    uint16_t, uint16_t);
 extern void virtio_virtq_desc_set(virtio_dev_t *vdev, uint16_t, uint16_t,
     uint64_t, uint32_t, uint16_t, uint16_t);
 extern uint16_t virtio_virtq_desc_get_next(virtio_dev_t *vdev, uint16_t,
@@ -197,6 +283,11 @@ extern void virtio_create_desc_free_list(virtio_dev_t *, uint16_t, uint16_t,
 extern uint16_t virtio_alloc_desc(virtio_dev_t *, uint16_t, uint16_t *);
 extern void virtio_free_desc(virtio_dev_t *, uint16_t, uint16_t *, uint16_t);
 
+extern void virtio_indirect_desc_set(virtio_dev_t *, virtq_desc_t *, uint16_t,
+    uint64_t, uint32_t, uint16_t, uint16_t);
+
+extern void virtio_virtq_add_available(virtio_dev_t *, uint16_t, uint16_t);
+extern void virtio_virtq_kick(virtio_dev_t *, uint16_t);
 extern void virtio_virtq_produce_available(virtio_dev_t *, uint16_t, uint16_t);
 extern bool virtio_virtq_consume_used(virtio_dev_t *, uint16_t, uint16_t *,
     uint32_t *);
@@ -204,13 +295,17 @@ extern bool virtio_virtq_consume_used(virtio_dev_t *, uint16_t, uint16_t *,
 extern errno_t virtio_virtq_setup(virtio_dev_t *, uint16_t, uint16_t);
 extern void virtio_virtq_teardown(virtio_dev_t *, uint16_t);
 
-extern errno_t virtio_device_setup_start(virtio_dev_t *, uint32_t);
+extern errno_t virtio_device_setup_start(virtio_dev_t *, uint32_t, uint32_t);
 extern void virtio_device_setup_fail(virtio_dev_t *);
 extern void virtio_device_setup_finalize(virtio_dev_t *);
 
 extern errno_t virtio_pci_dev_initialize(ddf_dev_t *, virtio_dev_t *);
 extern errno_t virtio_pci_dev_cleanup(virtio_dev_t *);
 
+extern errno_t virtio_pci_msix_enable(virtio_dev_t *, unsigned int);
+extern errno_t virtio_pci_msix_register(ddf_dev_t *, virtio_dev_t *,
+    unsigned int, interrupt_handler_t *, cap_irq_handle_t *);
+
 #endif
 
 /** @}
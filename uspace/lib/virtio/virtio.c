@@ -34,6 +34,7 @@
 #include <as.h>
 #include <align.h>
 #include <macros.h>
+#include <stdlib.h>
 
 #include <ddf/log.h>
 #include <barrier.h>
@@ -93,16 +94,65 @@ void virtio_teardown_dma_bufs(void *buf[])
 	}
 }
 
-void virtio_virtq_desc_set(virtio_dev_t *vdev, uint16_t num, uint16_t descno,
-    uint64_t addr, uint32_t len, uint16_t flags, uint16_t next)
+/** Set a descriptor in a descriptor table
+ *
+ * @param table[in]   Virtqueue descriptors or a table of indirect descriptors.
+ * @param descno[in]  Index of the descriptor in the table.
+ * @param addr[in]    Buffer physical address.
+ * @param len[in]     Buffer length.
+ * @param flags[in]   Descriptor flags.
+ * @param next[in]    Continuation descriptor.
+ */
+void virtio_desc_table_set(virtq_desc_t *table, uint16_t descno, uint64_t addr,
+    uint32_t len, uint16_t flags, uint16_t next)
 {
-	virtq_desc_t *d = &vdev->queues[num].desc[descno];
+	virtq_desc_t *d = &table[descno];
 	pio_write_le64(&d->addr, addr);
 	pio_write_le32(&d->len, len);
 	pio_write_le16(&d->flags, flags);
 	pio_write_le16(&d->next, next);
 }
 
+/** Set a descriptor in a table of indirect descriptors
+ *
+ * Indirect descriptor tables follow the layout of the virtqueue. Packed
+ * virtqueues list indirect descriptors in order, so @a next is only
+ * meaningful for split virtqueues and must be @a descno + 1 when
+ * VIRTQ_DESC_F_NEXT is set.
+ *
+ * @param vdev[in]    VIRTIO device.
+ * @param table[in]   Table of indirect descriptors.
+ * @param descno[in]  Index of the descriptor in the table.
+ * @param addr[in]    Buffer physical address.
+ * @param len[in]     Buffer length.
+ * @param flags[in]   Descriptor flags.
+ * @param next[in]    Continuation descriptor.
+ */
+void virtio_indirect_desc_set(virtio_dev_t *vdev, virtq_desc_t *table,
+    uint16_t descno, uint64_t addr, uint32_t len, uint16_t flags,
+    uint16_t next)
+{
+	if (!vdev->packed) {
+		virtio_desc_table_set(table, descno, addr, len, flags, next);
+		return;
+	}
+
+	assert(!(flags & VIRTQ_DESC_F_NEXT) || next == descno + 1);
+
+	virtq_pdesc_t *d = &((virtq_pdesc_t *) table)[descno];
+	pio_write_le64(&d->addr, addr);
+	pio_write_le32(&d->len, len);
+	pio_write_le16(&d->id, 0);
+	pio_write_le16(&d->flags, flags & ~VIRTQ_DESC_F_NEXT);
+}
+
+void virtio_virtq_desc_set(virtio_dev_t *vdev, uint16_t num, uint16_t descno,
+    uint64_t addr, uint32_t len, uint16_t flags, uint16_t next)
+{
+	virtio_desc_table_set(vdev->queues[num].desc, descno, addr, len, flags,
+	    next);
+}
+
 uint16_t virtio_virtq_desc_get_next(virtio_dev_t *vdev, uint16_t num,
     uint16_t descno)
 {
@@ -169,32 +219,242 @@ void virtio_free_desc(virtio_dev_t *vdev, uint16_t num, uint16_t *head,
 	fibril_mutex_unlock(&q->lock);
 }
 
-void virtio_virtq_produce_available(virtio_dev_t *vdev, uint16_t num,
+/** The used_event field follows the available ring */
+static ioport16_t *virtq_used_event(virtq_t *q)
+{
+	return &q->avail->ring[q->queue_size];
+}
+
+/** The avail_event field follows the used ring */
+static ioport16_t *virtq_avail_event(virtq_t *q)
+{
+	return (ioport16_t *) &q->used->ring[q->queue_size];
+}
+
+/** Check whether moving an index from @a old to @a new passes @a event */
+static bool virtq_need_event(uint16_t event, uint16_t new, uint16_t old)
+{
+	return (uint16_t) (new - event - 1) < (uint16_t) (new - old);
+}
+
+/** Copy a descriptor chain to the packed ring. */
+static void virtq_packed_add(virtq_t *q, uint16_t descno)
+{
+	uint16_t head_slot = q->avail_next;
+	uint16_t head_flags = 0;
+	uint16_t slot = head_slot;
+	uint16_t count = 0;
+	uint16_t d = descno;
+
+	for (;;) {
+		uint16_t flags = pio_read_le16(&q->desc[d].flags);
+		virtq_pdesc_t *pd = &q->ring[slot];
+
+		pio_write_le64(&pd->addr, pio_read_le64(&q->desc[d].addr));
+		pio_write_le32(&pd->len, pio_read_le32(&q->desc[d].len));
+		pio_write_le16(&pd->id, descno);
+
+		flags &= VIRTQ_DESC_F_NEXT | VIRTQ_DESC_F_WRITE |
+		    VIRTQ_DESC_F_INDIRECT;
+		flags |= q->avail_wrap ? VIRTQ_DESC_F_AVAIL : VIRTQ_DESC_F_USED;
+
+		/* The head is written last, it makes the whole chain visible */
+		if (count == 0)
+			head_flags = flags;
+		else
+			pio_write_le16(&pd->flags, flags);
+
+		count++;
+		if (++slot == q->queue_size) {
+			slot = 0;
+			q->avail_wrap = !q->avail_wrap;
+		}
+
+		if (!(flags & VIRTQ_DESC_F_NEXT))
+			break;
+		d = pio_read_le16(&q->desc[d].next);
+	}
+
+	q->chain_len[descno] = count;
+	q->avail_next = slot;
+	q->added += count;
+
+	write_barrier();
+	pio_write_le16(&q->ring[head_slot].flags, head_flags);
+}
+
+/** Make a descriptor chain available without notifying the device
+ *
+ * Use this to pass several buffers to the device at once, and call
+ * virtio_virtq_kick() after the last of them.
+ *
+ * @param vdev[in]    VIRTIO device.
+ * @param num[in]     Index of the virtqueue.
+ * @param descno[in]  Head descriptor of the chain.
+ */
+void virtio_virtq_add_available(virtio_dev_t *vdev, uint16_t num,
     uint16_t descno)
 {
 	virtq_t *q = &vdev->queues[num];
 
 	fibril_mutex_lock(&q->lock);
-	uint16_t idx = pio_read_le16(&q->avail->idx);
-	pio_write_le16(&q->avail->ring[idx % q->queue_size], descno);
-	write_barrier();
-	pio_write_le16(&q->avail->idx, idx + 1);
-	write_barrier();
-	pio_write_le16(q->notify, num);
+	if (q->packed) {
+		virtq_packed_add(q, descno);
+	} else {
+		pio_write_le16(&q->avail->ring[q->avail_idx % q->queue_size],
+		    descno);
+		write_barrier();
+		pio_write_le16(&q->avail->idx, ++q->avail_idx);
+		q->added++;
+	}
 	fibril_mutex_unlock(&q->lock);
 }
 
+/** Check whether the device wants to hear about the new packed buffers. */
+static bool virtq_packed_need_kick(virtq_t *q)
+{
+	uint16_t flags = pio_read_le16(&q->device_event->flags);
+
+	if (flags != VIRTQ_EVENT_F_DESC)
+		return flags != VIRTQ_EVENT_F_DISABLE;
+
+	uint16_t off_wrap = pio_read_le16(&q->device_event->off_wrap);
+	uint16_t event = off_wrap & ~VIRTQ_EVENT_WRAP;
+	bool wrap = (off_wrap & VIRTQ_EVENT_WRAP) != 0;
+
+	if (wrap != q->avail_wrap)
+		event -= q->queue_size;
+
+	return virtq_need_event(event, q->avail_next,
+	    q->avail_next - q->added);
+}
+
+/** Notify the device about the buffers made available since the last time
+ *
+ * The notification is skipped when the device asked not to be disturbed,
+ * e.g. because it is still processing the virtqueue.
+ *
+ * @param vdev[in]  VIRTIO device.
+ * @param num[in]   Index of the virtqueue.
+ */
+void virtio_virtq_kick(virtio_dev_t *vdev, uint16_t num)
+{
+	virtq_t *q = &vdev->queues[num];
+	bool kick;
+
+	fibril_mutex_lock(&q->lock);
+	if (q->added == 0) {
+		fibril_mutex_unlock(&q->lock);
+		return;
+	}
+
+	/* The new buffers must be visible before we look at the device */
+	memory_barrier();
+
+	if (q->packed) {
+		kick = virtq_packed_need_kick(q);
+	} else if (q->event_idx) {
+		/*
+		 * With event indices, the device tells us up to which index
+		 * it has seen the available ring and only needs to be
+		 * notified when we go past that.
+		 */
+		kick = virtq_need_event(pio_read_le16(virtq_avail_event(q)),
+		    q->avail_idx, q->avail_idx - q->added);
+	} else {
+		kick = !(pio_read_le16(&q->used->flags) &
+		    VIRTQ_USED_F_NO_NOTIFY);
+	}
+
+	q->added = 0;
+	if (kick)
+		pio_write_le16(q->notify, num);
+	fibril_mutex_unlock(&q->lock);
+}
+
+void virtio_virtq_produce_available(virtio_dev_t *vdev, uint16_t num,
+    uint16_t descno)
+{
+	virtio_virtq_add_available(vdev, num, descno);
+	virtio_virtq_kick(vdev, num);
+}
+
+/** Check whether the next packed ring slot has been used. */
+static bool virtq_packed_used(virtq_t *q)
+{
+	uint16_t flags = pio_read_le16(&q->ring[q->used_next].flags);
+	bool avail = (flags & VIRTQ_DESC_F_AVAIL) != 0;
+	bool used = (flags & VIRTQ_DESC_F_USED) != 0;
+
+	return avail == used && used == q->used_wrap;
+}
+
+static bool virtq_packed_consume(virtq_t *q, uint16_t *descno, uint32_t *len)
+{
+	if (!virtq_packed_used(q)) {
+		if (!q->event_idx)
+			return false;
+
+		/* Ask for an interrupt when the next slot gets used */
+		pio_write_le16(&q->driver_event->off_wrap, q->used_next |
+		    (q->used_wrap ? VIRTQ_EVENT_WRAP : 0));
+		memory_barrier();
+		if (!virtq_packed_used(q))
+			return false;
+	}
+	read_barrier();
+
+	virtq_pdesc_t *pd = &q->ring[q->used_next];
+	uint16_t id = pio_read_le16(&pd->id);
+
+	assert(id < q->queue_size);
+
+	*descno = id;
+	*len = pio_read_le32(&pd->len);
+
+	q->used_next += q->chain_len[id];
+	if (q->used_next >= q->queue_size) {
+		q->used_next -= q->queue_size;
+		q->used_wrap = !q->used_wrap;
+	}
+
+	return true;
+}
+
 bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
     uint16_t *descno, uint32_t *len)
 {
 	virtq_t *q = &vdev->queues[num];
 
 	fibril_mutex_lock(&q->lock);
+	if (q->packed) {
+		bool rc = virtq_packed_consume(q, descno, len);
+		fibril_mutex_unlock(&q->lock);
+		return rc;
+	}
+
 	uint16_t last_idx = q->used_last_idx % q->queue_size;
 	if (last_idx == (pio_read_le16(&q->used->idx) % q->queue_size)) {
-		fibril_mutex_unlock(&q->lock);
-		return false;
+		if (!q->event_idx) {
+			fibril_mutex_unlock(&q->lock);
+			return false;
+		}
+
+		/*
+		 * Ask for an interrupt when the next buffer gets used, so
+		 * that buffers used before we get here do not interrupt us
+		 * again. Recheck the ring afterwards as the device may have
+		 * used a buffer in the meantime.
+		 */
+		pio_write_le16(virtq_used_event(q), q->used_last_idx);
+		memory_barrier();
+		if (last_idx ==
+		    (pio_read_le16(&q->used->idx) % q->queue_size)) {
+			fibril_mutex_unlock(&q->lock);
+			return false;
+		}
 	}
+	read_barrier();
 
 	*descno = (uint16_t) pio_read_le32(&q->used->ring[last_idx].id);
 	*len = pio_read_le32(&q->used->ring[last_idx].len);
@@ -205,6 +465,103 @@ bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
 	return true;
 }
 
+/** Pass the virtqueue addresses to the device and enable the virtqueue. */
+static void virtq_enable(virtio_dev_t *vdev, uint16_t num, size_t avail_offset,
+    size_t used_offset)
+{
+	virtq_t *q = &vdev->queues[num];
+	virtio_pci_common_cfg_t *cfg = vdev->common_cfg;
+
+	/*
+	 * Write the configured addresses to device's common config
+	 */
+	pio_write_le64(&cfg->queue_desc, q->phys);
+	pio_write_le64(&cfg->queue_avail, q->phys + avail_offset);
+	pio_write_le64(&cfg->queue_used, q->phys + used_offset);
+
+	ddf_msg(LVL_NOTE, "DMA memory for virtq %d: virt=%p, phys=%p, size=%zu",
+	    num, q->virt, (void *) q->phys, q->size);
+
+	/* Determine virtq's notification address */
+	q->notify = vdev->notify_base +
+	    pio_read_le16(&cfg->queue_notif_off) * vdev->notify_off_multiplier;
+
+	ddf_msg(LVL_NOTE, "notification register: %p", q->notify);
+
+	/* Enable the queue */
+	pio_write_le16(&cfg->queue_enable, 1);
+	ddf_msg(LVL_NOTE, "virtq %d set", num);
+}
+
+/** Set up a packed virtqueue.
+ *
+ * The device only sees the packed ring and the event suppression
+ * structures. The split descriptor table drivers fill in stays in ordinary
+ * memory.
+ */
+static errno_t virtq_packed_setup(virtio_dev_t *vdev, uint16_t num,
+    uint16_t size, size_t mem_size, size_t driver_event_offset,
+    size_t device_event_offset)
+{
+	virtq_t *q = &vdev->queues[num];
+
+	q->desc = calloc(size, sizeof(virtq_desc_t));
+	q->chain_len = calloc(size, sizeof(uint16_t));
+	if (q->desc == NULL || q->chain_len == NULL) {
+		free(q->desc);
+		free(q->chain_len);
+		q->desc = NULL;
+		q->chain_len = NULL;
+		return ENOMEM;
+	}
+
+	q->virt = AS_AREA_ANY;
+	errno_t rc = dmamem_map_anonymous(mem_size, 0,
+	    AS_AREA_READ | AS_AREA_WRITE, 0, &q->phys, &q->virt);
+	if (rc != EOK) {
+		free(q->desc);
+		free(q->chain_len);
+		q->desc = NULL;
+		q->chain_len = NULL;
+		q->virt = NULL;
+		return rc;
+	}
+
+	fibril_mutex_initialize(&q->lock);
+
+	q->size = mem_size;
+	q->queue_size = size;
+	q->ring = q->virt;
+	q->driver_event = q->virt + driver_event_offset;
+	q->device_event = q->virt + device_event_offset;
+	q->avail = NULL;
+	q->used = NULL;
+	q->avail_next = 0;
+	q->avail_wrap = true;
+	q->used_next = 0;
+	q->used_wrap = true;
+	q->added = 0;
+	q->event_idx = (vdev->features & VIRTIO_RING_F_EVENT_IDX) != 0;
+	q->packed = true;
+
+	memset(q->virt, 0, q->size);
+
+	/*
+	 * With event indices, interrupts are requested explicitly from
+	 * virtio_virtq_consume_used() once the driver runs out of used
+	 * buffers.
+	 */
+	if (q->event_idx) {
+		pio_write_le16(&q->driver_event->off_wrap, VIRTQ_EVENT_WRAP);
+		pio_write_le16(&q->driver_event->flags, VIRTQ_EVENT_F_DESC);
+	} else {
+		pio_write_le16(&q->driver_event->flags, VIRTQ_EVENT_F_ENABLE);
+	}
+
+	virtq_enable(vdev, num, driver_event_offset, device_event_offset);
+	return EOK;
+}
+
 errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 {
 	virtq_t *q = &vdev->queues[num];
@@ -221,14 +578,38 @@ errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 	pio_write_le16(&cfg->queue_size, size);
 	ddf_msg(LVL_NOTE, "Virtq %u: %u descriptors", num, (unsigned) size);
 
+	if (vdev->msix_count > 0) {
+		uint16_t vector = min(num, vdev->msix_count - 1);
+
+		/* The device reads back NO_VECTOR if it cannot comply */
+		pio_write_le16(&cfg->queue_msix_vector, vector);
+		if (pio_read_le16(&cfg->queue_msix_vector) != vector) {
+			ddf_msg(LVL_ERROR, "Virtq %u: cannot use MSI-X vector "
+			    "%u", num, (unsigned) vector);
+			return ENOMEM;
+		}
+	}
+
 	size_t avail_offset = 0;
 	size_t used_offset = 0;
+	size_t mem_size;
 
 	/*
 	 * Compute the size of the needed DMA memory and also the offsets of
-	 * the individual components
+	 * the individual components. For packed virtqueues, the avail and used
+	 * offsets locate the driver and device event suppression structures.
 	 */
-	size_t mem_size = sizeof(virtq_desc_t[size]);
+	if (vdev->packed) {
+		mem_size = sizeof(virtq_pdesc_t[size]);
+		avail_offset = mem_size;
+		mem_size += sizeof(virtq_event_t);
+		used_offset = mem_size;
+		mem_size += sizeof(virtq_event_t);
+		return virtq_packed_setup(vdev, num, size, mem_size,
+		    avail_offset, used_offset);
+	}
+
+	mem_size = sizeof(virtq_desc_t[size]);
 	mem_size = ALIGN_UP(mem_size, _Alignof(virtq_avail_t));
 	avail_offset = mem_size;
 	mem_size += sizeof(virtq_avail_t) + sizeof(ioport16_t[size]) +
@@ -257,29 +638,14 @@ errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 	q->avail = q->virt + avail_offset;
 	q->used = q->virt + used_offset;
 	q->used_last_idx = 0;
+	q->avail_idx = 0;
+	q->added = 0;
+	q->event_idx = (vdev->features & VIRTIO_RING_F_EVENT_IDX) != 0;
+	q->packed = false;
 
 	memset(q->virt, 0, q->size);
 
-	/*
-	 * Write the configured addresses to device's common config
-	 */
-	pio_write_le64(&cfg->queue_desc, q->phys);
-	pio_write_le64(&cfg->queue_avail, q->phys + avail_offset);
-	pio_write_le64(&cfg->queue_used, q->phys + used_offset);
-
-	ddf_msg(LVL_NOTE, "DMA memory for virtq %d: virt=%p, phys=%p, size=%zu",
-	    num, q->virt, (void *) q->phys, q->size);
-
-	/* Determine virtq's notification address */
-	q->notify = vdev->notify_base +
-	    pio_read_le16(&cfg->queue_notif_off) * vdev->notify_off_multiplier;
-
-	ddf_msg(LVL_NOTE, "notification register: %p", q->notify);
-
-	/* Enable the queue */
-	pio_write_le16(&cfg->queue_enable, 1);
-	ddf_msg(LVL_NOTE, "virtq %d set", num);
-
+	virtq_enable(vdev, num, avail_offset, used_offset);
 	return rc;
 }
 
@@ -293,13 +659,28 @@ void virtio_virtq_teardown(virtio_dev_t *vdev, uint16_t num)
 	virtq_t *q = &vdev->queues[num];
 	if (q->size)
 		dmamem_unmap_anonymous(q->virt);
+
+	if (q->packed) {
+		free(q->desc);
+		free(q->chain_len);
+		q->desc = NULL;
+		q->chain_len = NULL;
+	}
 }
 
 /**
  * Perform device initialization as described in section 3.1.1 of the
  * specification, steps 1 - 6.
+ *
+ * @param vdev[in]      VIRTIO device.
+ * @param features[in]  Feature bits the driver cannot do without.
+ * @param optional[in]  Feature bits the driver uses if the device offers
+ *                      them.
+ *
+ * The accepted feature bits are stored in vdev->features.
  */
-errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
+errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features,
+    uint32_t optional)
 {
 	virtio_pci_common_cfg_t *cfg = vdev->common_cfg;
 
@@ -328,11 +709,14 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 
 	if (features != (features & device_features))
 		return ENOTSUP;
-	features &= device_features;
+	features |= optional & device_features;
 
 	if (reserved_features != (reserved_features & device_reserved_features))
 		return ENOTSUP;
+	if (vdev->packed)
+		reserved_features |= VIRTIO_F_RING_PACKED;
 	reserved_features &= device_reserved_features;
+	vdev->packed = (reserved_features & VIRTIO_F_RING_PACKED) != 0;
 
 	/* 4. Write the accepted feature flags */
 	pio_write_le32(&cfg->driver_feature_select, VIRTIO_FEATURES_0_31);
@@ -352,6 +736,7 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 	if (!(status & VIRTIO_DEV_STATUS_FEATURES_OK))
 		return ENOTSUP;
 
+	vdev->features = features;
 	return EOK;
 }
 
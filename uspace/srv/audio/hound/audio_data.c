@@ -34,6 +34,7 @@
  */
 
 #include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 #include "audio_data.h"
@@ -186,6 +187,7 @@ void audio_pipe_init(audio_pipe_t *pipe)
 	fibril_mutex_initialize(&pipe->guard);
 	pipe->frames = 0;
 	pipe->bytes = 0;
+	pipe->resampler = NULL;
 }
 
 /**
@@ -199,6 +201,8 @@ void audio_pipe_fini(audio_pipe_t *pipe)
 		audio_data_t *adata = audio_pipe_pop(pipe);
 		audio_data_unref(adata);
 	}
+	free(pipe->resampler);
+	pipe->resampler = NULL;
 }
 
 /**
@@ -247,6 +251,75 @@ audio_data_t *audio_pipe_pop(audio_pipe_t *pipe)
 	return adata;
 }
 
+/**
+ * Get a resampler for data of a different sampling rate.
+ * @param resampler Place holding the resampler of a pipe or a ring.
+ * @param sf Format of the stored data.
+ * @param df Target data format.
+ * @return Pointer to the resampler, NULL on failure.
+ *
+ * The resampler keeps its state across calls as long as the formats
+ * do not change.
+ */
+static pcm_resampler_t *audio_resampler_get(pcm_resampler_t **resampler,
+    const pcm_format_t *sf, const pcm_format_t *df)
+{
+	pcm_resampler_t *r = *resampler;
+	if (r && r->src_rate == sf->sampling_rate &&
+	    r->dst_rate == df->sampling_rate && r->channels == sf->channels)
+		return r;
+
+	if (!r) {
+		r = malloc(sizeof(pcm_resampler_t));
+		if (!r)
+			return NULL;
+		*resampler = r;
+	}
+
+	if (pcm_resampler_init(r, sf->sampling_rate, df->sampling_rate,
+	    sf->channels) != EOK)
+		return NULL;
+	return r;
+}
+
+/**
+ * Mix a contiguous block of stored data into the target buffer.
+ * @param resampler Place holding the resampler of a pipe or a ring.
+ * @param data Target buffer.
+ * @param size Target buffer size, a multiple of the frame size.
+ * @param src Stored data.
+ * @param src_size Size of the stored data.
+ * @param sf Format of the stored data.
+ * @param f Target data format.
+ * @param src_used Place to store the size of the stored data consumed.
+ * @return Size of the target buffer used.
+ */
+static size_t audio_mix_block(pcm_resampler_t **resampler, void *data,
+    size_t size, const void *src, size_t src_size, const pcm_format_t *sf,
+    const pcm_format_t *f, size_t *src_used)
+{
+	if (sf->sampling_rate == f->sampling_rate) {
+		const size_t frames = min(pcm_format_size_to_frames(size, f),
+		    pcm_format_size_to_frames(src_size, sf));
+		const size_t dst_size = frames * pcm_format_frame_size(f);
+
+		*src_used = frames * pcm_format_frame_size(sf);
+		pcm_format_convert_and_mix(data, dst_size, src, *src_used,
+		    sf, f);
+		return dst_size;
+	}
+
+	pcm_resampler_t *r = audio_resampler_get(resampler, sf, f);
+	size_t dst_used = 0;
+	if (!r || pcm_resample_and_mix(r, data, size, src, src_size, sf, f,
+	    &dst_used, src_used) != EOK) {
+		/* Drop what cannot be converted */
+		*src_used = src_size;
+		return 0;
+	}
+	return dst_used;
+}
+
 /**
  * Use data store in a pipe and mix it into the provided buffer.
  * @param pipe The piep that should provide data.
@@ -271,28 +344,25 @@ size_t audio_pipe_mix_data(audio_pipe_t *pipe, void *data,
 		audio_data_link_t *alink = audio_data_link_list_instance(l);
 
 		/* Get audio chunk metadata */
-		const size_t src_frame_size =
-		    pcm_format_frame_size(&alink->adata->format);
-		const size_t available_frames =
-		    audio_data_link_available_frames(alink);
-		const size_t copy_frames = min(available_frames, needed_frames);
-		const size_t dst_copy_size = copy_frames * dst_frame_size;
-		const size_t src_copy_size = copy_frames * src_frame_size;
-
-		assert(src_copy_size <= audio_data_link_remain_size(alink));
+		const pcm_format_t *sf = &alink->adata->format;
+		const size_t src_frame_size = pcm_format_frame_size(sf);
 
 		/* Copy audio data */
-		pcm_format_convert_and_mix(data, dst_copy_size,
-		    audio_data_link_start(alink), src_copy_size,
-		    &alink->adata->format, f);
+		size_t src_copy_size;
+		const size_t dst_copy_size = audio_mix_block(&pipe->resampler,
+		    data, needed_frames * dst_frame_size,
+		    audio_data_link_start(alink),
+		    audio_data_link_remain_size(alink), sf, f, &src_copy_size);
+
+		assert(src_copy_size <= audio_data_link_remain_size(alink));
 
 		/* Update values */
-		needed_frames -= copy_frames;
+		needed_frames -= dst_copy_size / dst_frame_size;
 		copied_size += dst_copy_size;
 		data += dst_copy_size;
 		alink->position += src_copy_size;
 		pipe->bytes -= src_copy_size;
-		pipe->frames -= copy_frames;
+		pipe->frames -= src_copy_size / src_frame_size;
 		if (audio_data_link_remain_size(alink) == 0) {
 			list_remove(&alink->link);
 			audio_data_link_destroy(alink);
@@ -304,6 +374,107 @@ size_t audio_pipe_mix_data(audio_pipe_t *pipe, void *data,
 	return copied_size;
 }
 
+/* Audio Ring */
+
+/**
+ * Initialize audio ring buffer.
+ * @param ring The ring structure to initialize.
+ * @param size Requested capacity, rounded up to whole frames.
+ * @param format Format of the stored data.
+ * @return Error code.
+ */
+errno_t audio_ring_init(audio_ring_t *ring, size_t size, pcm_format_t format)
+{
+	assert(ring);
+	const size_t frame_size = pcm_format_frame_size(&format);
+	if (size == 0 || frame_size == 0)
+		return EINVAL;
+
+	size = (size + frame_size - 1) / frame_size * frame_size;
+	ring->data = malloc(size);
+	if (!ring->data)
+		return ENOMEM;
+	ring->size = size;
+	ring->start = 0;
+	ring->used = 0;
+	ring->format = format;
+	ring->resampler = NULL;
+	return EOK;
+}
+
+/**
+ * Release storage of an audio ring buffer.
+ * @param ring The ring to clean.
+ */
+void audio_ring_fini(audio_ring_t *ring)
+{
+	assert(ring);
+	free(ring->data);
+	free(ring->resampler);
+	ring->data = NULL;
+	ring->resampler = NULL;
+	ring->size = 0;
+	ring->used = 0;
+}
+
+/**
+ * Copy audio data to a ring buffer.
+ * @param ring The target ring.
+ * @param data Audio data in the ring's format.
+ * @param size Size of the @p data buffer.
+ * @return Size of the data stored, whole frames that fit in the ring.
+ */
+size_t audio_ring_write(audio_ring_t *ring, const void *data, size_t size)
+{
+	assert(ring);
+	const size_t frame_size = pcm_format_frame_size(&ring->format);
+	size = min(size, audio_ring_space(ring));
+	size -= size % frame_size;
+
+	const size_t end = (ring->start + ring->used) % ring->size;
+	const size_t first = min(size, ring->size - end);
+	memcpy(ring->data + end, data, first);
+	memcpy(ring->data, data + first, size - first);
+	ring->used += size;
+	return size;
+}
+
+/**
+ * Use data stored in a ring and mix it into the provided buffer.
+ * @param ring The ring that should provide data.
+ * @param data Target buffer.
+ * @param size Target buffer size.
+ * @param f Target data format.
+ * @return Size of the target buffer used.
+ */
+size_t audio_ring_mix_data(audio_ring_t *ring, void *data, size_t size,
+    const pcm_format_t *f)
+{
+	assert(ring);
+	size_t needed = size - size % pcm_format_frame_size(f);
+	size_t copied_size = 0;
+
+	while (needed > 0 && ring->used > 0) {
+		/* Stored data up to the end of the storage */
+		const size_t block = min(ring->used, ring->size - ring->start);
+		size_t src_used;
+		const size_t dst_used = audio_mix_block(&ring->resampler, data,
+		    needed, ring->data + ring->start, block, &ring->format, f,
+		    &src_used);
+
+		needed -= dst_used;
+		copied_size += dst_used;
+		data += dst_used;
+		ring->start = (ring->start + src_used) % ring->size;
+		ring->used -= src_used;
+
+		/* Target buffer is full */
+		if (src_used < block)
+			break;
+	}
+	return copied_size;
+}
+
 /**
  * @}
  */
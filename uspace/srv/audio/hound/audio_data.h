@@ -62,10 +62,32 @@ typedef struct {
 	size_t bytes;
 	/** Total frames stored in all buffers */
 	size_t frames;
+	/** Sample rate converter, allocated on first use */
+	pcm_resampler_t *resampler;
 	/** List access synchronization */
 	fibril_mutex_t guard;
 } audio_pipe_t;
 
+/** Preallocated ring buffer of audio data in a single format.
+ *
+ * Data are copied in by a single writer and mixed out by a single reader,
+ * no buffers are allocated while streaming.
+ */
+typedef struct {
+	/** Ring storage */
+	uint8_t *data;
+	/** Size of the storage, a multiple of the frame size */
+	size_t size;
+	/** Offset of the oldest stored data */
+	size_t start;
+	/** Size of the stored data */
+	size_t used;
+	/** Format of the stored data */
+	pcm_format_t format;
+	/** Sample rate converter, allocated on first use */
+	pcm_resampler_t *resampler;
+} audio_ring_t;
+
 audio_data_t *audio_data_create(void *data, size_t size,
     pcm_format_t format);
 void audio_data_addref(audio_data_t *adata);
@@ -80,6 +102,34 @@ audio_data_t *audio_pipe_pop(audio_pipe_t *pipe);
 size_t audio_pipe_mix_data(audio_pipe_t *pipe, void *buffer, size_t size,
     const pcm_format_t *f);
 
+errno_t audio_ring_init(audio_ring_t *ring, size_t size, pcm_format_t format);
+void audio_ring_fini(audio_ring_t *ring);
+size_t audio_ring_write(audio_ring_t *ring, const void *data, size_t size);
+size_t audio_ring_mix_data(audio_ring_t *ring, void *buffer, size_t size,
+    const pcm_format_t *f);
+
+/**
+ * Stored data size getter.
+ * @param ring The audio ring buffer.
+ * @return Size of data stored in the ring.
+ */
+static inline size_t audio_ring_bytes(audio_ring_t *ring)
+{
+	assert(ring);
+	return ring->used;
+}
+
+/**
+ * Free space getter.
+ * @param ring The audio ring buffer.
+ * @return Size of data that fits in the ring.
+ */
+static inline size_t audio_ring_space(audio_ring_t *ring)
+{
+	assert(ring);
+	return ring->size - ring->used;
+}
+
 /**
  * Total bytes getter.
  * @param pipe The audio pipe.
@@ -50,6 +50,12 @@
 /* hardwired to provide ~21ms per fragment */
 #define BUFFER_PARTS   16
 
+/* Number of fragments mixed ahead of the device playback position */
+#define BUFFER_LEAD_PARTS  2
+
+/* Report playback statistics about every five seconds */
+#define DEVICE_STATS_FRAGMENTS  (BUFFER_PARTS * 16)
+
 static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new);
 static errno_t device_source_connection_callback(audio_source_t *source, bool new);
 static void device_event_callback(ipc_call_t *icall, void *arg);
@@ -57,6 +63,7 @@ static errno_t device_check_format(audio_sink_t *sink);
 static errno_t get_buffer(audio_device_t *dev);
 static errno_t release_buffer(audio_device_t *dev);
 static void advance_buffer(audio_device_t *dev, size_t size);
+static void device_stats_reset(audio_device_t *dev);
 static inline bool is_running(audio_device_t *dev)
 {
 	assert(dev);
@@ -93,6 +100,8 @@ errno_t audio_device_init(audio_device_t *dev, service_id_t id, const char *name
 	dev->buffer.position = NULL;
 	dev->buffer.size = 0;
 	dev->buffer.fragment_size = 0;
+	dev->buffer.hw_position = false;
+	device_stats_reset(dev);
 
 	log_verbose("Initialized device (%p) '%s' with id %" PRIun ".",
 	    dev, dev->name, dev->id);
@@ -174,8 +183,8 @@ static errno_t device_sink_connection_callback(audio_sink_t *sink, bool new)
 		 */
 		pcm_format_silence(dev->buffer.base, dev->buffer.size,
 		    &dev->sink.format);
-		//TODO add underrun detection.
-		const size_t size = dev->buffer.fragment_size * 2;
+		const size_t size =
+		    dev->buffer.fragment_size * BUFFER_LEAD_PARTS;
 		/* We never cross the end of the buffer here */
 		audio_sink_mix_inputs(&dev->sink, dev->buffer.position, size);
 		advance_buffer(dev, size);
@@ -256,6 +265,101 @@ static errno_t device_source_connection_callback(audio_source_t *source, bool ne
 	return EOK;
 }
 
+/**
+ * Clear playback timing statistics.
+ * @param dev The audio device.
+ */
+static void device_stats_reset(audio_device_t *dev)
+{
+	dev->stats.fragments = 0;
+	dev->stats.mix_total = 0;
+	dev->stats.mix_min = 0;
+	dev->stats.mix_max = 0;
+	dev->stats.period_max = 0;
+	dev->stats.last.tv_sec = 0;
+	dev->stats.last.tv_nsec = 0;
+}
+
+/**
+ * Account one mixed fragment in the playback statistics.
+ * @param dev The audio device.
+ * @param start Time the fragment event arrived.
+ * @param end Time mixing of the fragment finished.
+ *
+ * Comparing the mixing times and the intervals between events with
+ * the fragment duration shows how much headroom the buffer size leaves.
+ */
+static void device_stats_update(audio_device_t *dev,
+    struct timespec *start, struct timespec *end)
+{
+	const usec_t mix = NSEC2USEC(ts_sub_diff(end, start));
+
+	if (dev->stats.last.tv_sec != 0 || dev->stats.last.tv_nsec != 0) {
+		const usec_t period =
+		    NSEC2USEC(ts_sub_diff(start, &dev->stats.last));
+		if (period > dev->stats.period_max)
+			dev->stats.period_max = period;
+	}
+	dev->stats.last = *start;
+
+	if (dev->stats.fragments == 0 || mix < dev->stats.mix_min)
+		dev->stats.mix_min = mix;
+	if (mix > dev->stats.mix_max)
+		dev->stats.mix_max = mix;
+	dev->stats.mix_total += mix;
+
+	if (++dev->stats.fragments < DEVICE_STATS_FRAGMENTS)
+		return;
+
+	log_verbose("Mixed %u fragments of %lld usec: mix time "
+	    "avg %lld min %lld max %lld usec, max period %lld usec",
+	    dev->stats.fragments,
+	    pcm_format_size_to_usec(dev->buffer.fragment_size,
+	    &dev->sink.format),
+	    dev->stats.mix_total / dev->stats.fragments,
+	    dev->stats.mix_min, dev->stats.mix_max, dev->stats.period_max);
+
+	const struct timespec last = dev->stats.last;
+	device_stats_reset(dev);
+	dev->stats.last = last;
+}
+
+/**
+ * Determine how many fragments to mix to keep ahead of the device.
+ * @param dev The audio device.
+ * @return Number of fragments to mix at the current buffer position.
+ *
+ * Without position reporting every event means exactly one fragment.
+ * Otherwise the mixing deadline follows the actual playback position,
+ * so that late or coalesced events neither overwrite a fragment being
+ * played nor leave the device playing stale data.
+ */
+static unsigned device_fragments_due(audio_device_t *dev)
+{
+	const size_t fragment = dev->buffer.fragment_size;
+	const size_t size = dev->buffer.size;
+	size_t pos;
+
+	if (!dev->buffer.hw_position ||
+	    audio_pcm_get_buffer_pos(dev->sess, &pos) != EOK)
+		return 1;
+
+	/* Start of the fragment being played */
+	pos = (pos % size) / fragment * fragment;
+	const size_t written = dev->buffer.position - dev->buffer.base;
+	unsigned ahead = ((written + size - pos) % size) / fragment;
+
+	if (ahead == 0 || ahead > BUFFER_PARTS / 2) {
+		/* The device caught up with us, skip what it has played */
+		log_verbose("Underrun on device '%s'", dev->name);
+		dev->buffer.position = dev->buffer.base +
+		    (pos + fragment) % size;
+		ahead = 1;
+	}
+
+	return ahead < BUFFER_LEAD_PARTS ? BUFFER_LEAD_PARTS - ahead : 0;
+}
+
 /** Audio device event handler.
  *
  * @param icall Initial call structure.
@@ -277,15 +381,17 @@ static void device_event_callback(ipc_call_t *icall, void *arg)
 		switch (ipc_get_imethod(&call)) {
 		case PCM_EVENT_FRAMES_PLAYED:
 			getuptime(&time1);
-			//TODO add underrun detection.
-			/* We never cross the end of the buffer here */
-			audio_sink_mix_inputs(&dev->sink, dev->buffer.position,
-			    dev->buffer.fragment_size);
-			advance_buffer(dev, dev->buffer.fragment_size);
+			unsigned due = device_fragments_due(dev);
+			for (; due > 0; --due) {
+				/* We never cross the end of the buffer here */
+				audio_sink_mix_inputs(&dev->sink,
+				    dev->buffer.position,
+				    dev->buffer.fragment_size);
+				advance_buffer(dev, dev->buffer.fragment_size);
+			}
 			struct timespec time2;
 			getuptime(&time2);
-			log_verbose("Time to mix sources: %lld\n",
-			    NSEC2USEC(ts_sub_diff(&time2, &time1)));
+			device_stats_update(dev, &time1, &time2);
 			break;
 		case PCM_EVENT_CAPTURE_TERMINATED:
 			log_verbose("Capture terminated");
@@ -365,6 +471,10 @@ static errno_t get_buffer(audio_device_t *dev)
 		dev->buffer.size = preferred_size;
 		dev->buffer.fragment_size = dev->buffer.size / BUFFER_PARTS;
 		dev->buffer.position = dev->buffer.base;
+
+		sysarg_t val;
+		dev->buffer.hw_position = audio_pcm_query_cap(dev->sess,
+		    AUDIO_CAP_BUFFER_POS, &val) == EOK && val != 0;
 	}
 	return ret;
 
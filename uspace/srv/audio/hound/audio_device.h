@@ -41,6 +41,7 @@
 #include <fibril_synch.h>
 #include <errno.h>
 #include <ipc/loc.h>
+#include <time.h>
 #include <audio_pcm_iface.h>
 
 #include "audio_source.h"
@@ -62,7 +63,24 @@ typedef struct {
 		size_t size;
 		void *position;
 		size_t fragment_size;
+		/** Device reports playback position within the buffer */
+		bool hw_position;
 	} buffer;
+	/** Playback timing statistics, reported once per a number of periods */
+	struct {
+		/** Number of fragments mixed since the last report */
+		unsigned fragments;
+		/** Total time spent mixing in usec */
+		usec_t mix_total;
+		/** Shortest time to mix a fragment in usec */
+		usec_t mix_min;
+		/** Longest time to mix a fragment in usec */
+		usec_t mix_max;
+		/** Longest interval between two fragment events in usec */
+		usec_t period_max;
+		/** Time of the last fragment event */
+		struct timespec last;
+	} stats;
 	/** Capture device abstraction. */
 	audio_source_t source;
 	/** Playback device abstraction. */
@@ -34,6 +34,7 @@
  */
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "log.h"
@@ -106,7 +107,13 @@ errno_t connection_add_source_data(connection_t *connection, void *data,
 	assert(connection);
 	if (!data)
 		return EBADMEM;
-	const size_t needed_frames = pcm_format_size_to_frames(size, &format);
+	size_t needed_frames = pcm_format_size_to_frames(size, &format);
+	/* Frames of the source data, which might use a different rate */
+	const unsigned src_rate = connection->source->format.sampling_rate;
+	if (src_rate != 0 && src_rate != format.sampling_rate) {
+		needed_frames = ((uint64_t) needed_frames * src_rate +
+		    format.sampling_rate - 1) / format.sampling_rate;
+	}
 	if (needed_frames > audio_pipe_frames(&connection->fifo) &&
 	    connection->source->update_available_data) {
 		log_debug("Asking source to provide more data");
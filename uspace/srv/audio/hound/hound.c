@@ -35,6 +35,7 @@
  */
 
 #include <assert.h>
+#include <macros.h>
 #include <stdlib.h>
 #include <str.h>
 
@@ -248,6 +249,30 @@ hound_ctx_t *hound_get_ctx_by_id(hound_t *hound, hound_context_id_t id)
 	return res;
 }
 
+/**
+ * Collect playback statistics of all contexts.
+ * @param hound The hound structure.
+ * @param underruns Place to store the total number of stream underruns.
+ * @param latency Place to store the longest time of audio buffered
+ *     in a stream, in microseconds.
+ */
+void hound_get_stats(hound_t *hound, size_t *underruns, usec_t *latency)
+{
+	assert(hound);
+	*underruns = 0;
+	*latency = 0;
+
+	fibril_mutex_lock(&hound->list_guard);
+	list_foreach(hound->contexts, link, hound_ctx_t, ctx) {
+		size_t ctx_underruns;
+		usec_t ctx_latency;
+		hound_ctx_get_stats(ctx, &ctx_underruns, &ctx_latency);
+		*underruns += ctx_underruns;
+		*latency = max(*latency, ctx_latency);
+	}
+	fibril_mutex_unlock(&hound->list_guard);
+}
+
 /**
  * Add a new device.
  * @param hound The hound structure.
@@ -80,6 +80,7 @@ errno_t hound_remove_source(hound_t *hound, audio_source_t *source);
 errno_t hound_remove_sink(hound_t *hound, audio_sink_t *sink);
 errno_t hound_connect(hound_t *hound, const char *source_name, const char *sink_name);
 errno_t hound_disconnect(hound_t *hound, const char *source_name, const char *sink_name);
+void hound_get_stats(hound_t *hound, size_t *underruns, usec_t *latency);
 
 #endif
 
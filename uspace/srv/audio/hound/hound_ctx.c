@@ -35,6 +35,7 @@
  */
 
 #include <macros.h>
+#include <mem.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <str_error.h>
@@ -61,6 +62,7 @@ hound_ctx_t *hound_record_ctx_get(const char *name)
 		link_initialize(&ctx->link);
 		list_initialize(&ctx->streams);
 		fibril_mutex_initialize(&ctx->guard);
+		ctx->underruns = 0;
 		ctx->source = NULL;
 		ctx->sink = malloc(sizeof(audio_sink_t));
 		if (!ctx->sink) {
@@ -92,6 +94,7 @@ hound_ctx_t *hound_playback_ctx_get(const char *name)
 		link_initialize(&ctx->link);
 		list_initialize(&ctx->streams);
 		fibril_mutex_initialize(&ctx->guard);
+		ctx->underruns = 0;
 		ctx->sink = NULL;
 		ctx->source = malloc(sizeof(audio_source_t));
 		if (!ctx->source) {
@@ -157,8 +160,10 @@ bool hound_ctx_is_record(hound_ctx_t *ctx)
 typedef struct hound_ctx_stream {
 	/** Hound context streams link */
 	link_t link;
-	/** Audio data pipe */
+	/** Audio data pipe, used by record streams */
 	audio_pipe_t fifo;
+	/** Preallocated buffer used by playback streams instead of the pipe */
+	audio_ring_t ring;
 	/** Parent context */
 	hound_ctx_t *ctx;
 	/** Stream data format */
@@ -173,6 +178,43 @@ typedef struct hound_ctx_stream {
 	fibril_condvar_t change;
 } hound_ctx_stream_t;
 
+/**
+ * Stream buffer status helper.
+ * @param stream The stream.
+ * @return Size of data buffered in the stream.
+ */
+static inline size_t stream_bytes(hound_ctx_stream_t *stream)
+{
+	if (stream->ring.data)
+		return audio_ring_bytes(&stream->ring);
+	return audio_pipe_bytes(&stream->fifo);
+}
+
+/**
+ * Get playback statistics of a context.
+ * @param ctx hound context.
+ * @param underruns Place to store the number of stream underruns.
+ * @param latency Place to store the longest time of audio buffered
+ *     in a stream, in microseconds.
+ */
+void hound_ctx_get_stats(hound_ctx_t *ctx, size_t *underruns,
+    usec_t *latency)
+{
+	assert(ctx);
+	usec_t buffered = 0;
+
+	fibril_mutex_lock(&ctx->guard);
+	list_foreach(ctx->streams, link, hound_ctx_stream_t, stream) {
+		const usec_t usec =
+		    pcm_format_size_to_usec(stream_bytes(stream),
+		    &stream->format);
+		buffered = max(buffered, usec);
+	}
+	*underruns = ctx->underruns;
+	*latency = buffered;
+	fibril_mutex_unlock(&ctx->guard);
+}
+
 /**
  * New stream append helper.
  * @param ctx hound context.
@@ -250,6 +292,13 @@ hound_ctx_stream_t *hound_ctx_create_stream(hound_ctx_t *ctx, int flags,
 	hound_ctx_stream_t *stream = malloc(sizeof(hound_ctx_stream_t));
 	if (stream) {
 		audio_pipe_init(&stream->fifo);
+		stream->ring.data = NULL;
+		/* Playback data go through a buffer allocated only once */
+		if (ctx->source && buffer_size && audio_ring_init(
+		    &stream->ring, buffer_size, format) != EOK) {
+			free(stream);
+			return NULL;
+		}
 		link_initialize(&stream->link);
 		fibril_mutex_initialize(&stream->guard);
 		fibril_condvar_initialize(&stream->change);
@@ -275,15 +324,17 @@ void hound_ctx_destroy_stream(hound_ctx_stream_t *stream)
 {
 	if (stream) {
 		stream_remove(stream->ctx, stream);
-		if (audio_pipe_bytes(&stream->fifo))
+		if (stream_bytes(stream))
 			log_warning("Destroying stream with non empty buffer");
 		log_verbose("CTX: %p remove stream (%zu/%zu); "
 		    "flags:%#x ch: %u r:%u f:%s",
-		    stream->ctx, audio_pipe_bytes(&stream->fifo),
+		    stream->ctx, stream_bytes(stream),
 		    stream->allowed_size, stream->flags,
 		    stream->format.channels, stream->format.sampling_rate,
 		    pcm_sample_format_str(stream->format.sample_format));
 		audio_pipe_fini(&stream->fifo);
+		if (stream->ring.data)
+			audio_ring_fini(&stream->ring);
 		free(stream);
 	}
 }
@@ -291,7 +342,7 @@ void hound_ctx_destroy_stream(hound_ctx_stream_t *stream)
 /**
  * Write new data to a stream.
  * @param stream The destination stream.
- * @param data audio data buffer.
+ * @param data audio data buffer, the data are copied.
  * @param size size of the @p data buffer.
  * @return Error code.
  */
@@ -299,19 +350,33 @@ errno_t hound_ctx_stream_write(hound_ctx_stream_t *stream, void *data,
     size_t size)
 {
 	assert(stream);
+	errno_t ret = EOK;
 
 	if (stream->allowed_size && size > stream->allowed_size)
 		return EINVAL;
 
 	fibril_mutex_lock(&stream->guard);
 	while (stream->allowed_size &&
-	    (audio_pipe_bytes(&stream->fifo) + size > stream->allowed_size)) {
+	    (stream_bytes(stream) + size > stream->allowed_size)) {
 		fibril_condvar_wait(&stream->change, &stream->guard);
 
 	}
 
-	const errno_t ret =
-	    audio_pipe_push_data(&stream->fifo, data, size, stream->format);
+	if (stream->ring.data) {
+		audio_ring_write(&stream->ring, data, size);
+	} else {
+		void *copy = malloc(size);
+		audio_data_t *adata = copy ?
+		    audio_data_create(copy, size, stream->format) : NULL;
+		if (adata) {
+			memcpy(copy, data, size);
+			ret = audio_pipe_push(&stream->fifo, adata);
+			audio_data_unref(adata);
+		} else {
+			free(copy);
+			ret = ENOMEM;
+		}
+	}
 	fibril_mutex_unlock(&stream->guard);
 	if (ret == EOK)
 		fibril_condvar_signal(&stream->change);
@@ -361,7 +426,9 @@ size_t hound_ctx_stream_add_self(hound_ctx_stream_t *stream, void *data,
 {
 	assert(stream);
 	fibril_mutex_lock(&stream->guard);
-	const size_t ret = audio_pipe_mix_data(&stream->fifo, data, size, f);
+	const size_t ret = stream->ring.data ?
+	    audio_ring_mix_data(&stream->ring, data, size, f) :
+	    audio_pipe_mix_data(&stream->fifo, data, size, f);
 	fibril_condvar_signal(&stream->change);
 	fibril_mutex_unlock(&stream->guard);
 	return ret;
@@ -376,7 +443,7 @@ void hound_ctx_stream_drain(hound_ctx_stream_t *stream)
 	assert(stream);
 	log_debug("Draining stream");
 	fibril_mutex_lock(&stream->guard);
-	while (audio_pipe_bytes(&stream->fifo))
+	while (stream_bytes(stream))
 		fibril_condvar_wait(&stream->change, &stream->guard);
 	fibril_mutex_unlock(&stream->guard);
 }
@@ -409,8 +476,11 @@ errno_t update_data(audio_source_t *source, size_t size)
 	list_foreach(ctx->streams, link, hound_ctx_stream_t, stream) {
 		ssize_t copied = hound_ctx_stream_add_self(
 		    stream, buffer, size, &source->format);
-		if (copied != (ssize_t)size)
+		if (copied != (ssize_t)size &&
+		    !(stream->flags & HOUND_STREAM_IGNORE_UNDERFLOW)) {
 			log_warning("Not enough data in stream buffer");
+			ctx->underruns++;
+		}
 	}
 	log_verbose("CTX: %p. Pushing audio to %lu connections", ctx,
 	    list_count(&source->connections));
@@ -39,6 +39,7 @@
 #include <adt/list.h>
 #include <hound/protocol.h>
 #include <fibril_synch.h>
+#include <time.h>
 
 #include "audio_source.h"
 #include "audio_sink.h"
@@ -55,6 +56,8 @@ typedef struct {
 	audio_sink_t *sink;
 	/** List access synchronization */
 	fibril_mutex_t guard;
+	/** Number of times a stream could not provide data in time */
+	size_t underruns;
 } hound_ctx_t;
 
 typedef struct hound_ctx_stream hound_ctx_stream_t;
@@ -65,6 +68,8 @@ void hound_ctx_destroy(hound_ctx_t *context);
 
 hound_context_id_t hound_ctx_get_id(hound_ctx_t *ctx);
 bool hound_ctx_is_record(hound_ctx_t *ctx);
+void hound_ctx_get_stats(hound_ctx_t *ctx, size_t *underruns,
+    usec_t *latency);
 
 hound_ctx_stream_t *hound_ctx_create_stream(hound_ctx_t *ctx, int flags,
     pcm_format_t format, size_t buffer_size);
@@ -151,6 +151,14 @@ static errno_t iface_stream_data_write(void *stream, void *buffer, size_t size)
 	return hound_ctx_stream_write(stream, buffer, size);
 }
 
+static errno_t iface_get_stats(void *server, hound_stats_t *stats)
+{
+	assert(server);
+	assert(stats);
+	hound_get_stats(server, &stats->underruns, &stats->latency);
+	return EOK;
+}
+
 hound_server_iface_t hound_iface = {
 	.add_context = iface_add_context,
 	.rem_context = iface_rem_context,
@@ -163,5 +171,6 @@ hound_server_iface_t hound_iface = {
 	.drain_stream = iface_drain_stream,
 	.stream_data_write = iface_stream_data_write,
 	.stream_data_read = iface_stream_data_read,
+	.get_stats = iface_get_stats,
 	.server = NULL,
 };
@@ -36,42 +36,140 @@
  *
  * Allows accessing a file as a block device. Useful for, e.g., mounting
  * a disk image.
+ *
+ * The image is accessed through a cache of fixed-size chunks. Reads of
+ * chunks that are not cached are coalesced into larger reads of the
+ * image and extended ahead of sequential readers. Written chunks are kept
+ * dirty in the cache and written back by a separate fibril, consecutive
+ * chunks at once, after a delay, when too many of them are dirty or when
+ * the client asks to synchronize the cache.
+ *
+ * The device may be larger than the image file. The part past the end of
+ * the file reads as zeros without accessing the file and chunks of zeros
+ * written there are not stored, so the image only grows when data is
+ * written to it.
  */
 
 #include <stdio.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
 #include <async.h>
 #include <as.h>
 #include <bd_srv.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <loc.h>
+#include <mem.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <str_error.h>
 #include <stdbool.h>
 #include <task.h>
 #include <macros.h>
 #include <str.h>
+#include <vfs/vfs.h>
 
 #define NAME "file_bd"
 
 #define DEFAULT_BLOCK_SIZE 512
 
+/** Size of a cached chunk of the image */
+#define CHUNK_SIZE 16384
+
+/** Size of the cache */
+#define CACHE_SIZE (4 * 1024 * 1024)
+
+/** Maximum size of a single read or write of the image */
+#define RUN_SIZE (256 * 1024)
+
+/** Amount of data read ahead of a sequential reader */
+#define READAHEAD_SIZE (256 * 1024)
+
+/** Delay before dirty chunks are written back (in microseconds) */
+#define WRITEBACK_DELAY 1000000
+
+/** Cached chunk of the image */
+typedef struct {
+	/** Link to chunk_ht */
+	ht_link_t lht;
+	/** Link to chunk_lru */
+	link_t llru;
+	/** Chunk index */
+	aoff64_t idx;
+	/** Chunk holds data of the image and is in chunk_ht */
+	bool valid;
+	/** Data has not been written back yet */
+	bool dirty;
+	/** A copy of the data is being written back */
+	bool writing;
+	/** Chunk data */
+	uint8_t *data;
+} chunk_t;
+
 static size_t block_size;
 static aoff64_t num_blocks;
-static FILE *img;
+static int img_fd;
+/** Size of the image file */
+static aoff64_t img_size;
+
+/** Number of blocks in a chunk */
+static size_t chunk_blocks;
+/** Number of bytes in a chunk */
+static size_t chunk_bytes;
+/** Number of chunks of the device */
+static aoff64_t dev_chunks;
+/** Maximum number of chunks read or written at once */
+static size_t run_chunks;
+/** Number of chunks read ahead */
+static size_t ra_chunks;
+
+/** Cache chunks */
+static chunk_t *chunks;
+/** Number of cache chunks */
+static size_t nchunks;
+/** Valid chunks by index */
+static hash_table_t chunk_ht;
+/** All chunks, most recently used first */
+static list_t chunk_lru;
+/** Number of dirty chunks */
+static size_t ndirty;
+/** Number of chunks being written back */
+static size_t nwriting;
+/** Number of dirty chunks that start write-back immediately */
+static size_t dirty_max;
+/** Chunk expected to be read next by a sequential reader */
+static aoff64_t ra_next;
+/** Buffer for reading chunks */
+static uint8_t *load_buf;
+/** Buffer for chunks being written back */
+static uint8_t *wb_buf;
+/** Chunks being written back */
+static chunk_t **wb_run;
+/** Write-back should start right away */
+static bool wb_flush;
+/** First write-back error not reported yet */
+static errno_t wb_rc;
+/** Signalled to start write-back */
+static fibril_condvar_t wb_cv;
+/** Signalled when write-back of a run of chunks completes */
+static fibril_condvar_t wb_done_cv;
 
 static service_id_t service_id;
 static bd_srvs_t bd_srvs;
+/** Lock protecting the cache and the image */
 static fibril_mutex_t dev_lock;
 
 static void print_usage(void);
-static errno_t file_bd_init(const char *fname);
+static errno_t file_bd_init(const char *fname, aoff64_t);
 static void file_bd_connection(ipc_call_t *icall, void *);
 
 static errno_t file_bd_open(bd_srvs_t *, bd_srv_t *);
 static errno_t file_bd_close(bd_srv_t *);
 static errno_t file_bd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
+static errno_t file_bd_sync_cache(bd_srv_t *, aoff64_t, size_t);
 static errno_t file_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 static errno_t file_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t file_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
@@ -80,17 +178,50 @@ static bd_ops_t file_bd_ops = {
 	.open = file_bd_open,
 	.close = file_bd_close,
 	.read_blocks = file_bd_read_blocks,
+	.sync_cache = file_bd_sync_cache,
 	.write_blocks = file_bd_write_blocks,
 	.get_block_size = file_bd_get_block_size,
 	.get_num_blocks = file_bd_get_num_blocks
 };
 
+static size_t chunk_hash(const ht_link_t *item)
+{
+	chunk_t *chunk = hash_table_get_inst(item, chunk_t, lht);
+	return chunk->idx;
+}
+
+static size_t chunk_key_hash(const void *key)
+{
+	const aoff64_t *idx = key;
+	return *idx;
+}
+
+static bool chunk_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	return chunk_hash(item1) == chunk_hash(item2);
+}
+
+static bool chunk_key_equal(const void *key, const ht_link_t *item)
+{
+	const aoff64_t *idx = key;
+	return chunk_hash(item) == *idx;
+}
+
+static hash_table_ops_t chunk_ht_ops = {
+	.hash = chunk_hash,
+	.key_hash = chunk_key_hash,
+	.equal = chunk_equal,
+	.key_equal = chunk_key_equal,
+	.remove_callback = NULL
+};
+
 int main(int argc, char **argv)
 {
 	errno_t rc;
 	char *image_name;
 	char *device_name;
 	category_id_t disk_cat;
+	aoff64_t dev_blocks = 0;
 
 	printf(NAME ": File-backed block device driver\n");
 
@@ -115,6 +246,22 @@ int main(int argc, char **argv)
 			}
 			++argv;
 			--argc;
+		} else if (str_cmp(*argv, "-n") == 0) {
+			if (argc < 2) {
+				printf("Argument missing.\n");
+				print_usage();
+				return -1;
+			}
+
+			rc = str_uint64_t(argv[1], NULL, 10, true, &dev_blocks);
+			if (rc != EOK || dev_blocks == 0) {
+				printf("Invalid number of blocks '%s'.\n",
+				    argv[1]);
+				print_usage();
+				return -1;
+			}
+			++argv;
+			--argc;
 		} else {
 			printf("Invalid option '%s'.\n", *argv);
 			print_usage();
@@ -133,7 +280,7 @@ int main(int argc, char **argv)
 	image_name = argv[0];
 	device_name = argv[1];
 
-	if (file_bd_init(image_name) != EOK)
+	if (file_bd_init(image_name, dev_blocks) != EOK)
 		return -1;
 
 	rc = loc_service_register(device_name, &service_id);
@@ -166,11 +313,338 @@ int main(int argc, char **argv)
 
 static void print_usage(void)
 {
-	printf("Usage: " NAME " [-b <block_size>] <image_file> <device_name>\n");
+	printf("Usage: " NAME " [-b <block_size>] [-n <num_blocks>] "
+	    "<image_file> <device_name>\n");
+}
+
+/** Offset of a chunk in the image. */
+static aoff64_t chunk_pos(aoff64_t idx)
+{
+	return idx * chunk_bytes;
+}
+
+/** Size of the part of a chunk within the device. */
+static size_t chunk_len(aoff64_t idx)
+{
+	return min(chunk_bytes, (num_blocks - idx * chunk_blocks) * block_size);
+}
+
+/** Find a cached chunk without making it recently used. */
+static chunk_t *chunk_lookup(aoff64_t idx)
+{
+	ht_link_t *link = hash_table_find(&chunk_ht, &idx);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, chunk_t, lht);
+}
+
+/** Find a cached chunk and make it the most recently used one. */
+static chunk_t *chunk_find(aoff64_t idx)
+{
+	chunk_t *chunk = chunk_lookup(idx);
+	if (chunk == NULL)
+		return NULL;
+
+	list_remove(&chunk->llru);
+	list_prepend(&chunk->llru, &chunk_lru);
+	return chunk;
+}
+
+/** Determine whether a chunk is a hole in the image.
+ *
+ * A chunk of zeros past the end of the image file need not be stored.
+ */
+static bool chunk_is_hole(chunk_t *chunk)
+{
+	size_t len = chunk_len(chunk->idx);
+	size_t i;
+
+	if (chunk_pos(chunk->idx) < img_size)
+		return false;
+
+	for (i = 0; i < len; i++) {
+		if (chunk->data[i] != 0)
+			return false;
+	}
+
+	return true;
+}
+
+/** Mark a chunk dirty. */
+static void chunk_set_dirty(chunk_t *chunk)
+{
+	if (!chunk->dirty) {
+		chunk->dirty = true;
+		++ndirty;
+	}
+}
+
+/** Mark a chunk clean. */
+static void chunk_set_clean(chunk_t *chunk)
+{
+	if (chunk->dirty) {
+		chunk->dirty = false;
+		--ndirty;
+	}
+}
+
+/** Write a dirty chunk to the image right away.
+ *
+ * The lock is held for the duration of the write.
+ */
+static errno_t chunk_write(chunk_t *chunk)
+{
+	aoff64_t pos = chunk_pos(chunk->idx);
+	size_t nwr;
+	errno_t rc;
+
+	assert(chunk->dirty && !chunk->writing);
+
+	if (!chunk_is_hole(chunk)) {
+		rc = vfs_write(img_fd, &pos, chunk->data, chunk_len(chunk->idx),
+		    &nwr);
+		if (rc != EOK)
+			return EIO;
+
+		img_size = max(img_size, pos);
+	}
+
+	chunk_set_clean(chunk);
+	return EOK;
+}
+
+/** Get a chunk for caching new data.
+ *
+ * The least recently used chunk that is not being written back is
+ * reused, if it is dirty it is written back first. The chunk is removed
+ * from the cache and made the most recently used one.
+ */
+static errno_t chunk_get_free(chunk_t **rchunk)
+{
+	chunk_t *victim = NULL;
+	errno_t rc;
+
+	list_foreach_rev(chunk_lru, llru, chunk_t, chunk) {
+		if (!chunk->writing) {
+			victim = chunk;
+			break;
+		}
+	}
+
+	/* There are always more chunks than can be written back at once */
+	assert(victim != NULL);
+
+	if (victim->dirty) {
+		rc = chunk_write(victim);
+		if (rc != EOK)
+			return rc;
+	}
+
+	if (victim->valid) {
+		hash_table_remove_item(&chunk_ht, &victim->lht);
+		victim->valid = false;
+	}
+
+	list_remove(&victim->llru);
+	list_prepend(&victim->llru, &chunk_lru);
+	*rchunk = victim;
+	return EOK;
+}
+
+/** Insert a chunk obtained by chunk_get_free() into the cache. */
+static void chunk_insert(chunk_t *chunk, aoff64_t idx)
+{
+	chunk->idx = idx;
+	chunk->valid = true;
+	hash_table_insert(&chunk_ht, &chunk->lht);
+}
+
+/** Load chunks into the cache.
+ *
+ * Chunk @a idx and the following chunks that are not cached, up to
+ * @a cnt chunks in total, are read with a single read of the image.
+ * The part past the end of the image file is filled with zeros.
+ *
+ * @param idx First chunk, must not be cached
+ * @param cnt Maximum number of chunks to load
+ * @return EOK on success or an error code
+ */
+static errno_t chunk_load(aoff64_t idx, aoff64_t cnt)
+{
+	chunk_t *chunk;
+	aoff64_t pos = chunk_pos(idx);
+	size_t nrd = 0;
+	size_t size = 0;
+	size_t off;
+	size_t n = 0;
+	size_t i;
+	errno_t rc;
+
+	cnt = min(cnt, min(run_chunks, dev_chunks - idx));
+	while (n < cnt && (n == 0 || chunk_lookup(idx + n) == NULL)) {
+		size += chunk_len(idx + n);
+		++n;
+	}
+
+	if (pos < img_size) {
+		rc = vfs_read(img_fd, &pos, load_buf, min(size, img_size - pos),
+		    &nrd);
+		if (rc != EOK)
+			return EIO;
+	}
+
+	memset(load_buf + nrd, 0, size - nrd);
+
+	off = 0;
+	for (i = 0; i < n; i++) {
+		rc = chunk_get_free(&chunk);
+		if (rc != EOK)
+			return rc;
+
+		memcpy(chunk->data, load_buf + off, chunk_len(idx + i));
+		chunk_insert(chunk, idx + i);
+		off += chunk_len(idx + i);
+	}
+
+	return EOK;
+}
+
+/** Write back a run of consecutive dirty chunks.
+ *
+ * The run starts at the dirty chunk with the lowest index. The chunks
+ * are copied to the write-back buffer and written to the image with
+ * @c dev_lock released so that the cache remains usable meanwhile.
+ *
+ * @return @c true if a run has been written back, @c false if there
+ *         is nothing to write back or writing has failed
+ */
+static bool file_bd_wb_run(void)
+{
+	chunk_t *first = NULL;
+	chunk_t *chunk;
+	aoff64_t pos;
+	size_t size;
+	size_t nwr;
+	size_t n;
+	size_t i;
+	errno_t rc;
+
+	for (i = 0; i < nchunks; i++) {
+		chunk = &chunks[i];
+		if (chunk->dirty && !chunk->writing &&
+		    (first == NULL || chunk->idx < first->idx))
+			first = chunk;
+	}
+
+	if (first == NULL)
+		return false;
+
+	pos = chunk_pos(first->idx);
+	size = 0;
+	n = 0;
+	chunk = first;
+	while (n < run_chunks && chunk != NULL && chunk->dirty &&
+	    !chunk->writing) {
+		chunk_set_clean(chunk);
+
+		if (chunk_is_hole(chunk)) {
+			/* Leave the hole in the image */
+			if (n == 0)
+				return true;
+			break;
+		}
+
+		memcpy(wb_buf + size, chunk->data, chunk_len(chunk->idx));
+		size += chunk_len(chunk->idx);
+		chunk->writing = true;
+		wb_run[n++] = chunk;
+
+		chunk = chunk_lookup(chunk->idx + 1);
+	}
+
+	nwriting += n;
+
+	fibril_mutex_unlock(&dev_lock);
+	rc = vfs_write(img_fd, &pos, wb_buf, size, &nwr);
+	fibril_mutex_lock(&dev_lock);
+
+	for (i = 0; i < n; i++) {
+		wb_run[i]->writing = false;
+		if (rc != EOK)
+			chunk_set_dirty(wb_run[i]);
+	}
+
+	nwriting -= n;
+
+	if (rc == EOK)
+		img_size = max(img_size, pos);
+	else if (wb_rc == EOK)
+		wb_rc = EIO;
+
+	fibril_condvar_broadcast(&wb_done_cv);
+	return rc == EOK;
+}
+
+/** Write back dirty chunks.
+ *
+ * Dirty chunks are written back after a delay or right away when asked
+ * to or when there are too many of them.
+ */
+static errno_t file_bd_wb_fibril(void *arg)
+{
+	fibril_mutex_lock(&dev_lock);
+
+	while (true) {
+		if (!wb_flush && ndirty < dirty_max) {
+			(void) fibril_condvar_wait_timeout(&wb_cv, &dev_lock,
+			    WRITEBACK_DELAY);
+		}
+
+		while (file_bd_wb_run())
+			;
+
+		wb_flush = false;
+		fibril_condvar_broadcast(&wb_done_cv);
+	}
+
+	fibril_mutex_unlock(&dev_lock);
+	return EOK;
+}
+
+/** Write back all dirty chunks and synchronize the image.
+ *
+ * @return EOK on success, EIO if any write-back since the last call
+ *         has failed
+ */
+static errno_t file_bd_flush(void)
+{
+	errno_t rc;
+
+	fibril_mutex_lock(&dev_lock);
+
+	while ((ndirty > 0 || nwriting > 0) && wb_rc == EOK) {
+		wb_flush = true;
+		fibril_condvar_signal(&wb_cv);
+		fibril_condvar_wait(&wb_done_cv, &dev_lock);
+	}
+
+	rc = wb_rc;
+	wb_rc = EOK;
+
+	if (rc == EOK && vfs_sync(img_fd) != EOK)
+		rc = EIO;
+
+	fibril_mutex_unlock(&dev_lock);
+	return rc;
 }
 
-static errno_t file_bd_init(const char *fname)
+static errno_t file_bd_init(const char *fname, aoff64_t dev_blocks)
 {
+	vfs_stat_t stat;
+	fid_t fid;
+	size_t i;
+
 	bd_srvs_init(&bd_srvs);
 	bd_srvs.ops = &file_bd_ops;
 
@@ -181,26 +655,83 @@ static errno_t file_bd_init(const char *fname)
 		return rc;
 	}
 
-	img = fopen(fname, "rb+");
-	if (img == NULL)
+	rc = vfs_lookup_open(fname, WALK_REGULAR, MODE_READ | MODE_WRITE,
+	    &img_fd);
+	if (rc != EOK)
 		return EINVAL;
 
-	if (fseek(img, 0, SEEK_END) != 0) {
-		fclose(img);
+	rc = vfs_stat(img_fd, &stat);
+	if (rc != EOK) {
+		vfs_put(img_fd);
 		return EIO;
 	}
 
-	off64_t img_size = ftell(img);
-	if (img_size < 0) {
-		fclose(img);
-		return EIO;
+	img_size = stat.size;
+	num_blocks = dev_blocks != 0 ? dev_blocks : img_size / block_size;
+	if (num_blocks == 0) {
+		vfs_put(img_fd);
+		return EINVAL;
 	}
 
-	num_blocks = img_size / block_size;
+	chunk_blocks = max(CHUNK_SIZE / block_size, 1);
+	chunk_bytes = chunk_blocks * block_size;
+	dev_chunks = (num_blocks + chunk_blocks - 1) / chunk_blocks;
+	run_chunks = max(RUN_SIZE / chunk_bytes, 1);
+	ra_chunks = READAHEAD_SIZE / chunk_bytes;
+
+	/*
+	 * Besides the chunks being written back, there must be room for
+	 * the chunks loaded at once.
+	 */
+	nchunks = max(CACHE_SIZE / chunk_bytes, 4 * run_chunks);
+	dirty_max = nchunks / 4;
+
+	chunks = calloc(nchunks, sizeof(chunk_t));
+	load_buf = malloc(run_chunks * chunk_bytes);
+	wb_buf = malloc(run_chunks * chunk_bytes);
+	wb_run = calloc(run_chunks, sizeof(chunk_t *));
+	if (chunks == NULL || load_buf == NULL || wb_buf == NULL ||
+	    wb_run == NULL)
+		goto error;
+
+	if (!hash_table_create(&chunk_ht, nchunks, 0, &chunk_ht_ops))
+		goto error;
+
+	list_initialize(&chunk_lru);
+	for (i = 0; i < nchunks; i++) {
+		chunks[i].data = malloc(chunk_bytes);
+		if (chunks[i].data == NULL) {
+			hash_table_destroy(&chunk_ht);
+			goto error;
+		}
+
+		list_append(&chunks[i].llru, &chunk_lru);
+	}
 
 	fibril_mutex_initialize(&dev_lock);
+	fibril_condvar_initialize(&wb_cv);
+	fibril_condvar_initialize(&wb_done_cv);
+
+	fid = fibril_create(file_bd_wb_fibril, NULL);
+	if (fid == 0) {
+		hash_table_destroy(&chunk_ht);
+		goto error;
+	}
 
+	fibril_add_ready(fid);
 	return EOK;
+error:
+	if (chunks != NULL) {
+		for (i = 0; i < nchunks; i++)
+			free(chunks[i].data);
+	}
+
+	free(chunks);
+	free(load_buf);
+	free(wb_buf);
+	free(wb_run);
+	vfs_put(img_fd);
+	return ENOMEM;
 }
 
 static void file_bd_connection(ipc_call_t *icall, void *arg)
@@ -217,6 +748,19 @@ static errno_t file_bd_open(bd_srvs_t *bds, bd_srv_t *bd)
 /** Close device. */
 static errno_t file_bd_close(bd_srv_t *bd)
 {
+	return file_bd_flush();
+}
+
+/** Check whether access is within device address bounds. */
+static errno_t file_bd_check_range(uint64_t ba, size_t cnt)
+{
+	if (cnt == 0 || ba + cnt < ba || ba + cnt > num_blocks) {
+		printf(NAME ": Accessed blocks %" PRIuOFF64 "-%" PRIuOFF64 ", while "
+		    "max block number is %" PRIuOFF64 ".\n", ba, ba + cnt - 1,
+		    num_blocks - 1);
+		return ELIMIT;
+	}
+
 	return EOK;
 }
 
@@ -224,39 +768,53 @@ static errno_t file_bd_close(bd_srv_t *bd)
 static errno_t file_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt, void *buf,
     size_t size)
 {
-	size_t n_rd;
+	uint8_t *bp = buf;
+	aoff64_t first;
+	aoff64_t last;
+	aoff64_t idx;
+	aoff64_t ra;
+	errno_t rc;
 
 	if (size < cnt * block_size)
 		return EINVAL;
 
-	/* Check whether access is within device address bounds. */
-	if (ba + cnt > num_blocks) {
-		printf(NAME ": Accessed blocks %" PRIuOFF64 "-%" PRIuOFF64 ", while "
-		    "max block number is %" PRIuOFF64 ".\n", ba, ba + cnt - 1,
-		    num_blocks - 1);
-		return ELIMIT;
-	}
+	rc = file_bd_check_range(ba, cnt);
+	if (rc != EOK)
+		return rc;
+
+	first = ba / chunk_blocks;
+	last = (ba + cnt - 1) / chunk_blocks;
 
 	fibril_mutex_lock(&dev_lock);
 
-	clearerr(img);
-	if (fseek(img, ba * block_size, SEEK_SET) < 0) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;
-	}
+	/* Read ahead if the read continues the previous one */
+	ra = (first == ra_next || first + 1 == ra_next) ? ra_chunks : 0;
+
+	for (idx = first; idx <= last; idx++) {
+		aoff64_t cba = idx * chunk_blocks;
+		aoff64_t sb = max(ba, cba) - cba;
+		aoff64_t eb = min(ba + cnt, cba + chunk_blocks) - cba;
+		chunk_t *chunk;
+
+		chunk = chunk_find(idx);
+		if (chunk == NULL) {
+			rc = chunk_load(idx, last - idx + 1 + ra);
+			if (rc != EOK) {
+				fibril_mutex_unlock(&dev_lock);
+				return rc;
+			}
 
-	n_rd = fread(buf, block_size, cnt, img);
+			chunk = chunk_find(idx);
+			assert(chunk != NULL);
+		}
 
-	if (ferror(img)) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;	/* Read error */
+		memcpy(bp + (cba + sb - ba) * block_size,
+		    chunk->data + sb * block_size, (eb - sb) * block_size);
 	}
 
+	ra_next = last + 1;
 	fibril_mutex_unlock(&dev_lock);
 
-	if (n_rd < cnt)
-		return EINVAL;	/* Read beyond end of device */
-
 	return EOK;
 }
 
@@ -264,44 +822,66 @@ static errno_t file_bd_read_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt, void *
 static errno_t file_bd_write_blocks(bd_srv_t *bd, uint64_t ba, size_t cnt,
     const void *buf, size_t size)
 {
-	size_t n_wr;
+	const uint8_t *bp = buf;
+	aoff64_t first;
+	aoff64_t last;
+	aoff64_t idx;
+	errno_t rc;
 
 	if (size < cnt * block_size)
 		return EINVAL;
 
-	/* Check whether access is within device address bounds. */
-	if (ba + cnt > num_blocks) {
-		printf(NAME ": Accessed blocks %" PRIuOFF64 "-%" PRIuOFF64 ", while "
-		    "max block number is %" PRIuOFF64 ".\n", ba, ba + cnt - 1,
-		    num_blocks - 1);
-		return ELIMIT;
-	}
+	rc = file_bd_check_range(ba, cnt);
+	if (rc != EOK)
+		return rc;
+
+	first = ba / chunk_blocks;
+	last = (ba + cnt - 1) / chunk_blocks;
 
 	fibril_mutex_lock(&dev_lock);
 
-	clearerr(img);
-	if (fseek(img, ba * block_size, SEEK_SET) < 0) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;
-	}
+	for (idx = first; idx <= last; idx++) {
+		aoff64_t cba = idx * chunk_blocks;
+		aoff64_t sb = max(ba, cba) - cba;
+		aoff64_t eb = min(ba + cnt, cba + chunk_blocks) - cba;
+		chunk_t *chunk;
+
+		chunk = chunk_find(idx);
+		if (chunk == NULL && sb == 0 &&
+		    eb * block_size >= chunk_len(idx)) {
+			/* The whole chunk is overwritten */
+			rc = chunk_get_free(&chunk);
+			if (rc == EOK)
+				chunk_insert(chunk, idx);
+		} else if (chunk == NULL) {
+			rc = chunk_load(idx, 1);
+			chunk = chunk_find(idx);
+		}
 
-	n_wr = fwrite(buf, block_size, cnt, img);
+		if (rc != EOK) {
+			fibril_mutex_unlock(&dev_lock);
+			return rc;
+		}
 
-	if (ferror(img) || n_wr < cnt) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;	/* Write error */
+		memcpy(chunk->data + sb * block_size,
+		    bp + (cba + sb - ba) * block_size, (eb - sb) * block_size);
+		chunk_set_dirty(chunk);
 	}
 
-	if (fflush(img) != 0) {
-		fibril_mutex_unlock(&dev_lock);
-		return EIO;
-	}
+	if (ndirty >= dirty_max)
+		fibril_condvar_signal(&wb_cv);
 
 	fibril_mutex_unlock(&dev_lock);
 
 	return EOK;
 }
 
+/** Write back cached blocks and synchronize the image. */
+static errno_t file_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
+{
+	return file_bd_flush();
+}
+
 /** Get device block size. */
 static errno_t file_bd_get_block_size(bd_srv_t *bd, size_t *rsize)
 {
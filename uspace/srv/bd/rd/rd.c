@@ -72,6 +72,8 @@ static errno_t rd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
 static errno_t rd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 static errno_t rd_get_block_size(bd_srv_t *, size_t *);
 static errno_t rd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t rd_map(bd_srv_t *, void **, size_t *);
+static errno_t rd_write_zeroes(bd_srv_t *, aoff64_t, size_t);
 
 /** This rwlock protects the ramdisk's data.
  *
@@ -88,7 +90,9 @@ static bd_ops_t rd_bd_ops = {
 	.read_blocks = rd_read_blocks,
 	.write_blocks = rd_write_blocks,
 	.get_block_size = rd_get_block_size,
-	.get_num_blocks = rd_get_num_blocks
+	.get_num_blocks = rd_get_num_blocks,
+	.map = rd_map,
+	.write_zeroes = rd_write_zeroes
 };
 
 static bd_srvs_t bd_srvs;
@@ -142,6 +146,21 @@ static errno_t rd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
 	return EOK;
 }
 
+/** Set blocks of the device to zeroes. */
+static errno_t rd_write_zeroes(bd_srv_t *bd, aoff64_t ba, size_t cnt)
+{
+	if ((ba + cnt) * block_size > rd_size) {
+		/* Writing past the end of the device. */
+		return ELIMIT;
+	}
+
+	fibril_rwlock_write_lock(&rd_lock);
+	memset(rd_addr + ba * block_size, 0, block_size * cnt);
+	fibril_rwlock_write_unlock(&rd_lock);
+
+	return EOK;
+}
+
 /** Prepare the ramdisk image for operation. */
 static bool rd_init(void)
 {
@@ -209,6 +228,18 @@ static errno_t rd_get_num_blocks(bd_srv_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Get the area holding the ramdisk image.
+ *
+ * Clients mapping the image access its pages directly, bypassing
+ * @c rd_lock.
+ */
+static errno_t rd_map(bd_srv_t *bd, void **rarea, size_t *rsize)
+{
+	*rarea = rd_addr;
+	*rsize = ALIGN_UP(rd_size, PAGE_SIZE);
+	return EOK;
+}
+
 int main(int argc, char **argv)
 {
 	printf("%s: HelenOS RAM disk server\n", NAME);
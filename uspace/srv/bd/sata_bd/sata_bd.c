@@ -65,6 +65,7 @@ static errno_t sata_bd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t)
 static errno_t sata_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *, size_t);
 static errno_t sata_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t sata_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t sata_bd_get_queue_depth(bd_srv_t *, unsigned *);
 
 static bd_ops_t sata_bd_ops = {
 	.open = sata_bd_open,
@@ -72,7 +73,8 @@ static bd_ops_t sata_bd_ops = {
 	.read_blocks = sata_bd_read_blocks,
 	.write_blocks = sata_bd_write_blocks,
 	.get_block_size = sata_bd_get_block_size,
-	.get_num_blocks = sata_bd_get_num_blocks
+	.get_num_blocks = sata_bd_get_num_blocks,
+	.get_queue_depth = sata_bd_get_queue_depth
 };
 
 static sata_bd_dev_t *bd_srv_sata(bd_srv_t *bd)
@@ -106,6 +108,11 @@ static errno_t scan_device_tree(devman_handle_t funh)
 
 		ahci_get_num_blocks(disk[disk_count].sess, &disk[disk_count].blocks);
 
+		if (ahci_get_queue_depth(disk[disk_count].sess,
+		    &disk[disk_count].queue_depth) != EOK ||
+		    disk[disk_count].queue_depth == 0)
+			disk[disk_count].queue_depth = 1;
+
 		bd_srvs_init(&disk[disk_count].bds);
 		disk[disk_count].bds.ops = &sata_bd_ops;
 		disk[disk_count].bds.sarg = &disk[disk_count];
@@ -242,6 +249,18 @@ static errno_t sata_bd_get_num_blocks(bd_srv_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Get queue depth of the device.
+ *
+ * This is the number of NCQ commands the AHCI driver keeps in flight.
+ */
+static errno_t sata_bd_get_queue_depth(bd_srv_t *bd, unsigned *rdepth)
+{
+	sata_bd_dev_t *sbd = bd_srv_sata(bd);
+
+	*rdepth = sbd->queue_depth;
+	return EOK;
+}
+
 int main(int argc, char **argv)
 {
 	errno_t rc;
@@ -57,6 +57,8 @@ typedef struct {
 	uint64_t blocks;
 	/** Size of block. */
 	size_t block_size;
+	/** Number of requests the device serves at the same time. */
+	unsigned queue_depth;
 	/** Block device server structure */
 	bd_srvs_t bds;
 } sata_bd_dev_t;
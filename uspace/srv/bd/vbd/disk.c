@@ -62,12 +62,12 @@ static errno_t vbds_disk_parts_remove(vbds_disk_t *, vbds_rem_flag_t);
 
 static errno_t vbds_bd_open(bd_srvs_t *, bd_srv_t *);
 static errno_t vbds_bd_close(bd_srv_t *);
-static errno_t vbds_bd_read_blocks(bd_srv_t *, aoff64_t, size_t, void *, size_t);
+static errno_t vbds_bd_translate(bd_srv_t *, aoff64_t, size_t, async_sess_t **,
+    aoff64_t *);
 static errno_t vbds_bd_sync_cache(bd_srv_t *, aoff64_t, size_t);
-static errno_t vbds_bd_write_blocks(bd_srv_t *, aoff64_t, size_t, const void *,
-    size_t);
 static errno_t vbds_bd_get_block_size(bd_srv_t *, size_t *);
 static errno_t vbds_bd_get_num_blocks(bd_srv_t *, aoff64_t *);
+static errno_t vbds_bd_get_queue_depth(bd_srv_t *, unsigned *);
 
 static errno_t vbds_bsa_translate(vbds_part_t *, aoff64_t, size_t, aoff64_t *);
 
@@ -86,11 +86,11 @@ static errno_t vbds_label_write(void *, aoff64_t, size_t, const void *);
 static bd_ops_t vbds_bd_ops = {
 	.open = vbds_bd_open,
 	.close = vbds_bd_close,
-	.read_blocks = vbds_bd_read_blocks,
 	.sync_cache = vbds_bd_sync_cache,
-	.write_blocks = vbds_bd_write_blocks,
 	.get_block_size = vbds_bd_get_block_size,
-	.get_num_blocks = vbds_bd_get_num_blocks
+	.get_num_blocks = vbds_bd_get_num_blocks,
+	.get_queue_depth = vbds_bd_get_queue_depth,
+	.translate = vbds_bd_translate
 };
 
 /** Provide disk access to liblabel */
@@ -967,30 +967,35 @@ static errno_t vbds_bd_close(bd_srv_t *bd)
 	return EOK;
 }
 
-static errno_t vbds_bd_read_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
-    void *buf, size_t size)
+/** Translate a partition block range for passthrough.
+ *
+ * Read and write requests are forwarded to the disk with the translated
+ * address, the data is transferred between the client and the disk
+ * driver directly.
+ */
+static errno_t vbds_bd_translate(bd_srv_t *bd, aoff64_t ba, size_t cnt,
+    async_sess_t **rsess, aoff64_t *rba)
 {
 	vbds_part_t *part = bd_srv_part(bd);
 	aoff64_t gba;
 	errno_t rc;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_read_blocks()");
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_translate()");
 	fibril_rwlock_read_lock(&part->lock);
 
-	if (cnt * part->disk->block_size < size) {
-		fibril_rwlock_read_unlock(&part->lock);
-		return EINVAL;
-	}
-
 	if (vbds_bsa_translate(part, ba, cnt, &gba) != EOK) {
 		fibril_rwlock_read_unlock(&part->lock);
 		return ELIMIT;
 	}
 
-	rc = block_read_direct(part->disk->svc_id, gba, cnt, buf);
+	rc = block_get_sess(part->disk->svc_id, rsess);
 	fibril_rwlock_read_unlock(&part->lock);
 
-	return rc;
+	if (rc != EOK)
+		return rc;
+
+	*rba = gba;
+	return EOK;
 }
 
 static errno_t vbds_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
@@ -1017,31 +1022,6 @@ static errno_t vbds_bd_sync_cache(bd_srv_t *bd, aoff64_t ba, size_t cnt)
 	return rc;
 }
 
-static errno_t vbds_bd_write_blocks(bd_srv_t *bd, aoff64_t ba, size_t cnt,
-    const void *buf, size_t size)
-{
-	vbds_part_t *part = bd_srv_part(bd);
-	aoff64_t gba;
-	errno_t rc;
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_write_blocks()");
-	fibril_rwlock_read_lock(&part->lock);
-
-	if (cnt * part->disk->block_size < size) {
-		fibril_rwlock_read_unlock(&part->lock);
-		return EINVAL;
-	}
-
-	if (vbds_bsa_translate(part, ba, cnt, &gba) != EOK) {
-		fibril_rwlock_read_unlock(&part->lock);
-		return ELIMIT;
-	}
-
-	rc = block_write_direct(part->disk->svc_id, gba, cnt, buf);
-	fibril_rwlock_read_unlock(&part->lock);
-	return rc;
-}
-
 static errno_t vbds_bd_get_block_size(bd_srv_t *bd, size_t *rsize)
 {
 	vbds_part_t *part = bd_srv_part(bd);
@@ -1068,6 +1048,21 @@ static errno_t vbds_bd_get_num_blocks(bd_srv_t *bd, aoff64_t *rnb)
 	return EOK;
 }
 
+/** Partitions pass on the queue depth of the disk they are on. */
+static errno_t vbds_bd_get_queue_depth(bd_srv_t *bd, unsigned *rdepth)
+{
+	vbds_part_t *part = bd_srv_part(bd);
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "vbds_bd_get_queue_depth()");
+
+	fibril_rwlock_read_lock(&part->lock);
+	rc = block_get_queue_depth(part->disk->svc_id, rdepth);
+	fibril_rwlock_read_unlock(&part->lock);
+
+	return rc;
+}
+
 void vbds_bd_conn(ipc_call_t *icall, void *arg)
 {
 	vbds_part_t *part;
@@ -42,6 +42,7 @@
 #include <fibril_synch.h>
 #include <refcount.h>
 #include <async.h>
+#include <time.h>
 
 #include "util.h"
 
@@ -89,6 +90,13 @@ typedef struct driver {
 	 * Fibril mutex for this driver - driver state, list of devices, session.
 	 */
 	fibril_mutex_t driver_mutex;
+
+	/** Time the driver task was spawned */
+	struct timespec start_time;
+	/** Number of devices passed to the driver */
+	size_t attach_cnt;
+	/** Total time the driver took to add its devices, in microseconds */
+	usec_t attach_usec;
 } driver_t;
 
 /** The list of drivers. */
@@ -97,6 +105,8 @@ typedef struct driver_list {
 	list_t drivers;
 	/** Fibril mutex for list of drivers. */
 	fibril_mutex_t drivers_mutex;
+	/** Driver match ids indexed by the id string */
+	hash_table_t match_index;
 	/** Next free handle */
 	devman_handle_t next_handle;
 } driver_list_t;
@@ -31,6 +31,7 @@
  * @{
  */
 
+#include <adt/hash.h>
 #include <dirent.h>
 #include <errno.h>
 #include <io/log.h>
@@ -47,8 +48,64 @@
 #include "match.h"
 #include "main.h"
 
+/** Maximum number of devices being added by drivers at the same time */
+#define ADD_DEVICE_MAX  8
+
 static errno_t driver_reassign_fibril(void *);
 
+/** Bounds the number of outstanding add_device() calls */
+static FIBRIL_SEMAPHORE_INITIALIZE(add_device_sem, ADD_DEVICE_MAX);
+
+/** Entry of the driver match id index (driver_list_t.match_index) */
+typedef struct {
+	/** Link to driver_list_t.match_index */
+	ht_link_t link;
+	/** Match id of the driver */
+	const char *id;
+	/** Driver having the match id */
+	driver_t *drv;
+} match_index_entry_t;
+
+static size_t match_index_key_hash(const void *key)
+{
+	const char *cp;
+	size_t hash = 0;
+
+	for (cp = key; *cp != '\0'; cp++)
+		hash = hash_combine(hash, (unsigned char) *cp);
+
+	return hash_mix(hash);
+}
+
+static size_t match_index_hash(const ht_link_t *item)
+{
+	match_index_entry_t *entry = hash_table_get_inst(item,
+	    match_index_entry_t, link);
+	return match_index_key_hash(entry->id);
+}
+
+static bool match_index_key_equal(const void *key, const ht_link_t *item)
+{
+	match_index_entry_t *entry = hash_table_get_inst(item,
+	    match_index_entry_t, link);
+	return str_cmp(entry->id, key) == 0;
+}
+
+static bool match_index_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	match_index_entry_t *entry = hash_table_get_inst(item2,
+	    match_index_entry_t, link);
+	return match_index_key_equal(entry->id, item1);
+}
+
+static hash_table_ops_t match_index_ops = {
+	.hash = match_index_hash,
+	.key_hash = match_index_key_hash,
+	.key_equal = match_index_key_equal,
+	.equal = match_index_equal,
+	.remove_callback = NULL
+};
+
 /**
  * Initialize the list of device driver's.
  *
@@ -61,6 +118,7 @@ void init_driver_list(driver_list_t *drv_list)
 
 	list_initialize(&drv_list->drivers);
 	fibril_mutex_initialize(&drv_list->drivers_mutex);
+	hash_table_create(&drv_list->match_index, 0, 0, &match_index_ops);
 	drv_list->next_handle = 1;
 }
 
@@ -86,6 +144,22 @@ void add_driver(driver_list_t *drivers_list, driver_t *drv)
 	fibril_mutex_lock(&drivers_list->drivers_mutex);
 	list_append(&drv->drivers, &drivers_list->drivers);
 	drv->handle = drivers_list->next_handle++;
+
+	/* Index the match ids so that matching does not visit all drivers */
+	list_foreach(drv->match_ids.ids, link, match_id_t, mid) {
+		match_index_entry_t *entry;
+
+		entry = malloc(sizeof(match_index_entry_t));
+		if (entry == NULL) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Failed indexing match "
+			    "id `%s' of driver `%s'.", mid->id, drv->name);
+			continue;
+		}
+
+		entry->id = mid->id;
+		entry->drv = drv;
+		hash_table_insert(&drivers_list->match_index, &entry->link);
+	}
 	fibril_mutex_unlock(&drivers_list->drivers_mutex);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Driver `%s' was added to the list of available "
@@ -220,51 +294,55 @@ int lookup_available_drivers(driver_list_t *drivers_list, const char *dir_path)
 driver_t *find_best_match_driver(driver_list_t *drivers_list, dev_node_t *node)
 {
 	driver_t *best_drv = NULL;
+	driver_t *same_drv = NULL;
 	int best_score = 0, score = 0;
-	int cur_score;
-	link_t *link;
+	int cur_score = INT_MAX;
+	devman_handle_t cur_handle = 0;
 
 	fibril_mutex_lock(&drivers_list->drivers_mutex);
 
 	if (node->drv != NULL) {
 		cur_score = get_match_score(node->drv, node);
-
-		link = list_next(&node->drv->drivers, &drivers_list->drivers);
-
-		/*
-		 * Find next driver with score equal to the current.
-		 */
-		while (link != NULL) {
-			driver_t *drv = list_get_instance(link, driver_t,
-			    drivers);
-			score = get_match_score(drv, node);
-			if (score == cur_score) {
-				/* Found it */
-				fibril_mutex_unlock(&drivers_list->drivers_mutex);
-				return drv;
-			}
-
-			link = list_next(link, &drivers_list->drivers);
-		}
-
-		/* There is no driver with the same score */
-	} else {
-		cur_score = INT_MAX;
+		cur_handle = node->drv->handle;
 	}
 
 	/*
-	 * Find driver with the next best score
+	 * Only drivers sharing a match id with the device can match it, look
+	 * them up in the index. Handles follow the order of the driver list,
+	 * so the lowest handle wins among drivers with an equal score.
 	 */
-	list_foreach(drivers_list->drivers, drivers, driver_t, drv) {
-		score = get_match_score(drv, node);
-		if (score > best_score && score < cur_score) {
-			best_score = score;
-			best_drv = drv;
+	list_foreach(node->pfun->match_ids.ids, link, match_id_t, dev_id) {
+		ht_link_t *first = hash_table_find(&drivers_list->match_index,
+		    dev_id->id);
+		ht_link_t *cur = first;
+
+		while (cur != NULL) {
+			match_index_entry_t *entry = hash_table_get_inst(cur,
+			    match_index_entry_t, link);
+			driver_t *drv = entry->drv;
+			score = get_match_score(drv, node);
+
+			/* Next driver with score equal to the current */
+			if (score == cur_score && drv->handle > cur_handle &&
+			    (same_drv == NULL ||
+			    drv->handle < same_drv->handle))
+				same_drv = drv;
+
+			/* Driver with the next best score */
+			if (score > 0 && score < cur_score &&
+			    (score > best_score || (score == best_score &&
+			    drv->handle < best_drv->handle))) {
+				best_score = score;
+				best_drv = drv;
+			}
+
+			cur = hash_table_find_next(&drivers_list->match_index,
+			    first, cur);
 		}
 	}
 
 	fibril_mutex_unlock(&drivers_list->drivers_mutex);
-	return best_drv;
+	return same_drv != NULL ? same_drv : best_drv;
 }
 
 /** Assign a driver to a device.
@@ -336,6 +414,7 @@ bool start_driver(driver_t *drv)
 		return false;
 	}
 
+	getuptime(&drv->start_time);
 	drv->state = DRIVER_STARTING;
 	return true;
 }
@@ -420,31 +499,127 @@ driver_t *driver_find_by_name(driver_list_t *drv_list, const char *drv_name)
  *
  * @param driver	The driver to which the devices are passed.
  */
+/** Devices being passed to a driver at the same time */
+typedef struct {
+	/** Protects @c pending */
+	fibril_mutex_t mutex;
+	/** Signalled when a device was passed */
+	fibril_condvar_t cv;
+	/** Number of devices still being passed */
+	size_t pending;
+} pass_devices_t;
+
+/** Argument of pass_device_fibril() */
+typedef struct {
+	pass_devices_t *pass;
+	driver_t *driver;
+	dev_node_t *dev;
+	dev_tree_t *tree;
+} pass_device_t;
+
+/** Pass one device to a driver.
+ *
+ * @param driver	The driver
+ * @param dev		The device, the caller's reference is consumed
+ * @param tree		Device tree
+ */
+static void pass_device(driver_t *driver, dev_node_t *dev, dev_tree_t *tree)
+{
+	add_device(driver, dev, tree);
+
+	/* Device probe failed, need to try next best driver */
+	if (dev->state == DEVICE_NOT_PRESENT) {
+		fibril_mutex_lock(&driver->driver_mutex);
+		list_remove(&dev->driver_devices);
+		fibril_mutex_unlock(&driver->driver_mutex);
+		/* Give an extra reference to driver_reassign_fibril */
+		dev_add_ref(dev);
+		fid_t fid = fibril_create(driver_reassign_fibril, dev);
+		if (fid == 0) {
+			log_msg(LOG_DEFAULT, LVL_ERROR,
+			    "Error creating fibril to assign driver.");
+			dev_del_ref(dev);
+		} else {
+			fibril_add_ready(fid);
+		}
+	}
+
+	dev_del_ref(dev);
+}
+
+/** Fibril passing one device to a driver.
+ *
+ * @param arg	Device to pass (pass_device_t)
+ */
+static errno_t pass_device_fibril(void *arg)
+{
+	pass_device_t *pd = (pass_device_t *) arg;
+	pass_devices_t *pass = pd->pass;
+
+	pass_device(pd->driver, pd->dev, pd->tree);
+	free(pd);
+
+	fibril_mutex_lock(&pass->mutex);
+	pass->pending--;
+	fibril_condvar_broadcast(&pass->cv);
+	fibril_mutex_unlock(&pass->mutex);
+	return EOK;
+}
+
+/** Pass devices to a driver concurrently.
+ *
+ * Devices of independent subtrees do not depend on each other, so they
+ * are passed by separate fibrils. The number of add_device() calls in
+ * progress is bounded by add_device_sem.
+ */
 static void pass_devices_to_driver(driver_t *driver, dev_tree_t *tree)
 {
+	pass_devices_t pass;
 	dev_node_t *dev;
-	link_t *link;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "pass_devices_to_driver(driver=\"%s\")",
 	    driver->name);
 
+	fibril_mutex_initialize(&pass.mutex);
+	fibril_condvar_initialize(&pass.cv);
+	pass.pending = 0;
+
 	fibril_mutex_lock(&driver->driver_mutex);
 
 	/*
 	 * Go through devices list as long as there is some device
-	 * that has not been passed to the driver.
+	 * that has not been passed to the driver, then wait until
+	 * the driver has added all of them.
 	 */
-	link = driver->devices.head.next;
-	while (link != &driver->devices.head) {
-		dev = list_get_instance(link, dev_node_t, driver_devices);
+	while (true) {
 		fibril_rwlock_write_lock(&tree->rwlock);
 
-		if (dev->passed_to_driver) {
+		dev = NULL;
+		list_foreach(driver->devices, driver_devices, dev_node_t, d) {
+			if (!d->passed_to_driver) {
+				dev = d;
+				break;
+			}
+		}
+
+		if (dev == NULL) {
 			fibril_rwlock_write_unlock(&tree->rwlock);
-			link = link->next;
+
+			fibril_mutex_lock(&pass.mutex);
+			if (pass.pending == 0) {
+				fibril_mutex_unlock(&pass.mutex);
+				break;
+			}
+
+			fibril_mutex_unlock(&driver->driver_mutex);
+			fibril_condvar_wait(&pass.cv, &pass.mutex);
+			fibril_mutex_unlock(&pass.mutex);
+			fibril_mutex_lock(&driver->driver_mutex);
 			continue;
 		}
 
+		/* Do not pick the device again while it is being added */
+		dev->passed_to_driver = true;
 		dev_add_ref(dev);
 
 		/*
@@ -454,36 +629,31 @@ static void pass_devices_to_driver(driver_t *driver, dev_tree_t *tree)
 		fibril_mutex_unlock(&driver->driver_mutex);
 		fibril_rwlock_write_unlock(&tree->rwlock);
 
-		add_device(driver, dev, tree);
+		pass_device_t *pd = malloc(sizeof(pass_device_t));
+		fid_t fid = 0;
+		if (pd != NULL) {
+			pd->pass = &pass;
+			pd->driver = driver;
+			pd->dev = dev;
+			pd->tree = tree;
+			fid = fibril_create(pass_device_fibril, pd);
+		}
 
-		/* Device probe failed, need to try next best driver */
-		if (dev->state == DEVICE_NOT_PRESENT) {
-			fibril_mutex_lock(&driver->driver_mutex);
-			list_remove(&dev->driver_devices);
-			fibril_mutex_unlock(&driver->driver_mutex);
-			/* Give an extra reference to driver_reassign_fibril */
-			dev_add_ref(dev);
-			fid_t fid = fibril_create(driver_reassign_fibril, dev);
-			if (fid == 0) {
-				log_msg(LOG_DEFAULT, LVL_ERROR,
-				    "Error creating fibril to assign driver.");
-				dev_del_ref(dev);
-			}
+		if (fid != 0) {
+			fibril_mutex_lock(&pass.mutex);
+			pass.pending++;
+			fibril_mutex_unlock(&pass.mutex);
 			fibril_add_ready(fid);
+		} else {
+			free(pd);
+			pass_device(driver, dev, tree);
 		}
 
-		dev_del_ref(dev);
-
 		/*
 		 * Lock again as we will work with driver's
 		 * structure.
 		 */
 		fibril_mutex_lock(&driver->driver_mutex);
-
-		/*
-		 * Restart the cycle to go through all devices again.
-		 */
-		link = driver->devices.head.next;
 	}
 
 	/*
@@ -498,6 +668,14 @@ static void pass_devices_to_driver(driver_t *driver, dev_tree_t *tree)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Driver `%s' enters running state.", driver->name);
 	driver->state = DRIVER_RUNNING;
 
+	/* Boot timeline */
+	struct timespec now;
+	getuptime(&now);
+	log_msg(LOG_DEFAULT, LVL_NOTE, "Driver `%s' running after %lld ms, "
+	    "%zu devices added in %lld ms.", driver->name,
+	    NSEC2MSEC(ts_sub_diff(&now, &driver->start_time)),
+	    driver->attach_cnt, driver->attach_usec / 1000);
+
 	fibril_mutex_unlock(&driver->driver_mutex);
 }
 
@@ -637,6 +815,12 @@ void add_device(driver_t *drv, dev_node_t *dev, dev_tree_t *tree)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "add_device(drv=\"%s\", dev=\"%s\")",
 	    drv->name, dev->pfun->name);
 
+	struct timespec start;
+	struct timespec end;
+
+	fibril_semaphore_down(&add_device_sem);
+	getuptime(&start);
+
 	/* Send the device to the driver. */
 	devman_handle_t parent_handle;
 	if (dev->pfun) {
@@ -677,6 +861,19 @@ void add_device(driver_t *drv, dev_node_t *dev, dev_tree_t *tree)
 	}
 
 	dev->passed_to_driver = true;
+
+	getuptime(&end);
+	fibril_semaphore_up(&add_device_sem);
+
+	const usec_t usec = NSEC2USEC(ts_sub_diff(&end, &start));
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "Driver `%s' added device `%s' in "
+	    "%lld us: %s.", drv->name, dev->pfun->pathname, usec,
+	    str_error(rc));
+
+	fibril_mutex_lock(&drv->driver_mutex);
+	drv->attach_cnt++;
+	drv->attach_usec += usec;
+	fibril_mutex_unlock(&drv->driver_mutex);
 }
 
 errno_t driver_dev_remove(dev_tree_t *tree, dev_node_t *dev)
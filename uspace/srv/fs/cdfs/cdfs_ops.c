@@ -61,6 +61,15 @@
 
 #define NODE_CACHE_SIZE 200
 
+/** Largest readahead window in blocks, optical drives seek slowly */
+#define CDFS_READAHEAD  32
+
+/** Reads of at least this many bytes go to the device directly */
+#define DIRECT_READ_MIN  (4 * BLOCK_SIZE)
+
+/** Largest number of bytes read from the device directly at once */
+#define DIRECT_READ_MAX  (32 * BLOCK_SIZE)
+
 /** All root nodes have index 0 */
 #define CDFS_SOME_ROOT  0
 
@@ -218,7 +227,10 @@ typedef enum {
 
 typedef struct {
 	link_t link;       /**< Siblings list link */
+	ht_link_t dh_link; /**< Dentries hash table link */
+	fs_node_t *parent; /**< Parent directory */
 	fs_index_t index;  /**< Node index */
+	cdfs_dentry_type_t type; /**< Dentry type */
 	char *name;        /**< Dentry name */
 } cdfs_dentry_t;
 
@@ -243,6 +255,8 @@ typedef struct {
 	uint32_t size;            /**< File size if type is CDFS_FILE */
 
 	list_t cs_list;           /**< Child's siblings list */
+	cdfs_dentry_t *cursor;    /**< Dentry read from the directory last */
+	aoff64_t cursor_pos;      /**< Position of the cursor dentry */
 	cdfs_lba_t lba;           /**< LBA of data on disk */
 	bool processed;           /**< If all children have been read */
 	unsigned int opened;      /**< Opened count */
@@ -275,6 +289,9 @@ static size_t nodes_cached = 0;
 /** Hash table of all cdfs nodes */
 static hash_table_t nodes;
 
+/** Hash table of the dentries of all parsed directories */
+static hash_table_t dentries;
+
 /*
  * Hash table support functions.
  */
@@ -312,7 +329,9 @@ static void nodes_remove_callback(ht_link_t *item)
 		link_t *link;
 		while ((link = list_first(&node->cs_list)) != NULL) {
 			cdfs_dentry_t *dentry = list_get_instance(link, cdfs_dentry_t, link);
+			hash_table_remove_item(&dentries, &dentry->dh_link);
 			list_remove(&dentry->link);
+			free(dentry->name);
 			free(dentry);
 		}
 	}
@@ -330,6 +349,69 @@ static hash_table_ops_t nodes_ops = {
 	.remove_callback = nodes_remove_callback
 };
 
+typedef struct {
+	fs_node_t *parent;
+	const char *name;
+} dentry_key_t;
+
+static size_t dentry_name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != '\0')
+		hash = hash * 31 + (uint8_t) *name++;
+
+	return hash;
+}
+
+static size_t dentries_key_hash(const void *k)
+{
+	const dentry_key_t *key = k;
+	return hash_combine((size_t) key->parent, dentry_name_hash(key->name));
+}
+
+static size_t dentries_hash(const ht_link_t *item)
+{
+	cdfs_dentry_t *dentry = hash_table_get_inst(item, cdfs_dentry_t,
+	    dh_link);
+	return hash_combine((size_t) dentry->parent,
+	    dentry_name_hash(dentry->name));
+}
+
+static bool dentries_key_equal(const void *k, const ht_link_t *item)
+{
+	cdfs_dentry_t *dentry = hash_table_get_inst(item, cdfs_dentry_t,
+	    dh_link);
+	const dentry_key_t *key = k;
+
+	return key->parent == dentry->parent &&
+	    str_cmp(key->name, dentry->name) == 0;
+}
+
+/** Dentries hash table operations */
+static hash_table_ops_t dentries_ops = {
+	.hash = dentries_hash,
+	.key_hash = dentries_key_hash,
+	.key_equal = dentries_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Find a dentry of a parsed directory by its name. */
+static cdfs_dentry_t *cdfs_dentry_find(fs_node_t *pfn, const char *name)
+{
+	dentry_key_t key = {
+		.parent = pfn,
+		.name = name
+	};
+
+	ht_link_t *link = hash_table_find(&dentries, &key);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, cdfs_dentry_t, dh_link);
+}
+
 static errno_t cdfs_node_get(fs_node_t **rfn, service_id_t service_id,
     fs_index_t index)
 {
@@ -368,6 +450,8 @@ static void cdfs_node_initialize(cdfs_node_t *node)
 	node->opened = 0;
 
 	list_initialize(&node->cs_list);
+	node->cursor = NULL;
+	node->cursor_pos = 0;
 }
 
 static errno_t create_node(fs_node_t **rfn, cdfs_t *fs, int lflag,
@@ -424,10 +508,8 @@ static errno_t link_node(fs_node_t *pfn, fs_node_t *fn, const char *name)
 	assert(parent->type == CDFS_DIRECTORY);
 
 	/* Check for duplicate entries */
-	list_foreach(parent->cs_list, link, cdfs_dentry_t, dentry) {
-		if (str_cmp(dentry->name, name) == 0)
-			return EEXIST;
-	}
+	if (cdfs_dentry_find(pfn, name) != NULL)
+		return EEXIST;
 
 	/* Allocate and initialize the dentry */
 	cdfs_dentry_t *dentry = malloc(sizeof(cdfs_dentry_t));
@@ -442,10 +524,13 @@ static errno_t link_node(fs_node_t *pfn, fs_node_t *fn, const char *name)
 	}
 
 	link_initialize(&dentry->link);
+	dentry->parent = pfn;
 	dentry->index = node->index;
+	dentry->type = node->type;
 
 	node->lnkcnt++;
 	list_append(&dentry->link, &parent->cs_list);
+	hash_table_insert(&dentries, &dentry->dh_link);
 
 	return EOK;
 }
@@ -707,11 +792,10 @@ static errno_t cdfs_match(fs_node_t **fn, fs_node_t *pfn, const char *component)
 			return rc;
 	}
 
-	list_foreach(parent->cs_list, link, cdfs_dentry_t, dentry) {
-		if (str_cmp(dentry->name, component) == 0) {
-			*fn = get_cached_node(parent->fs, dentry->index);
-			return EOK;
-		}
+	cdfs_dentry_t *dentry = cdfs_dentry_find(pfn, component);
+	if (dentry != NULL) {
+		*fn = get_cached_node(parent->fs, dentry->index);
+		return EOK;
 	}
 
 	*fn = NULL;
@@ -1178,6 +1262,8 @@ static errno_t cdfs_mounted(service_id_t service_id, const char *opts,
 		return rc;
 	}
 
+	(void) block_cache_set_readahead(service_id, CDFS_READAHEAD);
+
 	/* Check if this device is not already mounted */
 	fs_node_t *rootfn;
 	rc = cdfs_root_get(&rootfn, service_id);
@@ -1251,6 +1337,60 @@ static errno_t cdfs_unmounted(service_id_t service_id)
 	return EOK;
 }
 
+/** Find the dentry at a readdir position.
+ *
+ * Readdir asks for consecutive positions, so continue from the dentry
+ * returned last time if possible.
+ *
+ * @param node Directory node.
+ * @param pos  Position of the dentry in the list of children.
+ *
+ * @return Link of the dentry or NULL if there is none at @a pos.
+ */
+static link_t *cdfs_dentry_seek(cdfs_node_t *node, aoff64_t pos)
+{
+	if (node->cursor != NULL && pos == node->cursor_pos)
+		return &node->cursor->link;
+	if (node->cursor != NULL && pos == node->cursor_pos + 1)
+		return list_next(&node->cursor->link, &node->cs_list);
+
+	return list_nth(&node->cs_list, pos);
+}
+
+/** Read a large chunk of a file directly from the device.
+ *
+ * ISO 9660 files are recorded in one contiguous extent. Reading it in one
+ * device request avoids a round trip through the block cache per block.
+ *
+ * @param call  Read request to answer.
+ * @param node  File node.
+ * @param pos   Position in the file.
+ * @param bytes Number of bytes to read.
+ *
+ * @return EOK on success or an error code.
+ */
+static errno_t cdfs_read_direct(ipc_call_t *call, cdfs_node_t *node,
+    aoff64_t pos, size_t bytes)
+{
+	void *buf = malloc(bytes);
+	if (buf == NULL) {
+		libfs_data_read_refuse(call, ENOMEM);
+		return ENOMEM;
+	}
+
+	errno_t rc = block_read_bytes_direct(node->fs->service_id,
+	    (aoff64_t) node->lba * BLOCK_SIZE + pos, bytes, buf);
+	if (rc != EOK) {
+		free(buf);
+		libfs_data_read_refuse(call, rc);
+		return rc;
+	}
+
+	libfs_data_read_finalize(call, buf, bytes);
+	free(buf);
+	return EOK;
+}
+
 static errno_t cdfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *rbytes)
 {
@@ -1274,15 +1414,23 @@ static errno_t cdfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos
 
 	ipc_call_t call;
 	size_t len;
-	if (!async_data_read_receive(&call, &len)) {
-		async_answer_0(&call, EINVAL);
+	if (!libfs_data_read_receive(&call, &len)) {
+		libfs_data_read_refuse(&call, EINVAL);
 		return EINVAL;
 	}
 
 	if (node->type == CDFS_FILE) {
 		if (pos >= node->size) {
 			*rbytes = 0;
-			async_data_read_finalize(&call, NULL, 0);
+			libfs_data_read_finalize(&call, NULL, 0);
+		} else if (min(len, node->size - pos) >= DIRECT_READ_MIN) {
+			*rbytes = min(min(len, node->size - pos),
+			    DIRECT_READ_MAX);
+
+			errno_t rc = cdfs_read_direct(&call, node, pos,
+			    *rbytes);
+			if (rc != EOK)
+				return rc;
 		} else {
 			cdfs_lba_t lba = pos / BLOCK_SIZE;
 			size_t offset = pos % BLOCK_SIZE;
@@ -1294,34 +1442,87 @@ static errno_t cdfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos
 			errno_t rc = block_get(&block, service_id, node->lba + lba,
 			    BLOCK_FLAGS_NONE);
 			if (rc != EOK) {
-				async_answer_0(&call, rc);
+				libfs_data_read_refuse(&call, rc);
 				return rc;
 			}
 
-			async_data_read_finalize(&call, block->data + offset,
+			libfs_data_read_finalize(&call, block->data + offset,
 			    *rbytes);
 			rc = block_put(block);
 			if (rc != EOK)
 				return rc;
 		}
 	} else {
-		link_t *link = list_nth(&node->cs_list, pos);
+		link_t *link = cdfs_dentry_seek(node, pos);
 		if (link == NULL) {
-			async_answer_0(&call, ENOENT);
+			libfs_data_read_refuse(&call, ENOENT);
 			return ENOENT;
 		}
 
 		cdfs_dentry_t *dentry =
 		    list_get_instance(link, cdfs_dentry_t, link);
+		node->cursor = dentry;
+		node->cursor_pos = pos;
 
 		*rbytes = 1;
-		async_data_read_finalize(&call, dentry->name,
+		libfs_data_read_finalize(&call, dentry->name,
 		    str_size(dentry->name) + 1);
 	}
 
 	return EOK;
 }
 
+static errno_t cdfs_readdir_op(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, void *buf, size_t size, size_t *used)
+{
+	ht_key_t key = {
+		.index = index,
+		.service_id = service_id
+	};
+
+	ht_link_t *hlink = hash_table_find(&nodes, &key);
+	if (hlink == NULL)
+		return ENOENT;
+
+	cdfs_node_t *node =
+	    hash_table_get_inst(hlink, cdfs_node_t, nh_link);
+	if (node->type != CDFS_DIRECTORY)
+		return ENOTDIR;
+
+	if (!node->processed) {
+		errno_t rc = cdfs_readdir(node->fs, FS_NODE(node));
+		if (rc != EOK)
+			return rc;
+	}
+
+	*used = 0;
+
+	link_t *link = cdfs_dentry_seek(node, pos);
+	while (link != NULL) {
+		cdfs_dentry_t *dentry =
+		    list_get_instance(link, cdfs_dentry_t, link);
+		vfs_dirent_type_t type = (dentry->type == CDFS_DIRECTORY) ?
+		    VFS_DIRENT_DIRECTORY : VFS_DIRENT_FILE;
+
+		if (!libfs_dirent_pack(buf, size, used, pos + 1,
+		    dentry->index, type, dentry->name,
+		    str_size(dentry->name)))
+			break;
+
+		node->cursor = dentry;
+		node->cursor_pos = pos;
+
+		pos++;
+		link = list_next(link, &node->cs_list);
+	}
+
+	/* Not even one entry fits */
+	if (*used == 0 && link != NULL)
+		return EOVERFLOW;
+
+	return EOK;
+}
+
 static errno_t cdfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
 {
@@ -1429,7 +1630,8 @@ vfs_out_ops_t cdfs_ops = {
 	.truncate = cdfs_truncate,
 	.close = cdfs_close,
 	.destroy = cdfs_destroy,
-	.sync = cdfs_sync
+	.sync = cdfs_sync,
+	.readdir = cdfs_readdir_op
 };
 
 /** Initialize the cdfs server
@@ -1440,6 +1642,11 @@ bool cdfs_init(void)
 	if (!hash_table_create(&nodes, 0, 0, &nodes_ops))
 		return false;
 
+	if (!hash_table_create(&dentries, 0, 0, &dentries_ops)) {
+		hash_table_destroy(&nodes);
+		return false;
+	}
+
 	return true;
 }
 
@@ -44,42 +44,172 @@
 #include <align.h>
 #include <assert.h>
 #include <fibril_synch.h>
+#include <fs_bitmap.h>
 #include <mem.h>
-
-errno_t exfat_bitmap_is_free(exfat_bs_t *bs, service_id_t service_id,
-    exfat_cluster_t clst)
+#include <stdlib.h>
+
+/** In-memory copy of the Bitmap Table of a file system instance. */
+typedef struct {
+	link_t link;
+	service_id_t service_id;
+	fs_bitmap_t map;
+} exfat_free_map_t;
+
+/** Protects the list of in-memory bitmaps and their contents. */
+static FIBRIL_MUTEX_INITIALIZE(free_maps_lock);
+static LIST_INITIALIZE(free_maps);
+
+/** Load the Bitmap Table of a file system into memory. */
+static errno_t exfat_free_map_load(exfat_bs_t *bs, service_id_t service_id,
+    fs_bitmap_t *map)
 {
 	fs_node_t *fn;
-	block_t *b = NULL;
-	exfat_node_t *bitmapp;
-	uint8_t *bitmap;
+	block_t *b;
 	errno_t rc;
-	bool alloc;
-
-	clst -= EXFAT_CLST_FIRST;
 
 	rc = exfat_bitmap_get(&fn, service_id);
 	if (rc != EOK)
 		return rc;
-	bitmapp = EXFAT_NODE(fn);
 
-	aoff64_t offset = clst / 8;
-	rc = exfat_block_get(&b, bs, bitmapp, offset / BPS(bs), BLOCK_FLAGS_NONE);
+	rc = fs_bitmap_create(map, DATA_CNT(bs));
 	if (rc != EOK) {
 		(void) exfat_node_put(fn);
 		return rc;
 	}
-	bitmap = (uint8_t *)b->data;
-	alloc = bitmap[offset % BPS(bs)] & (1 << (clst % 8));
 
-	rc = block_put(b);
+	size_t bytes = (DATA_CNT(bs) + 7) / 8;
+	for (size_t offset = 0; offset < bytes; offset += BPS(bs)) {
+		rc = exfat_block_get(&b, bs, EXFAT_NODE(fn), offset / BPS(bs),
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			break;
+
+		fs_bitmap_import(map, offset, b->data,
+		    min(BPS(bs), bytes - offset));
+
+		rc = block_put(b);
+		if (rc != EOK)
+			break;
+	}
+
+	if (rc != EOK)
+		fs_bitmap_destroy(map);
+
+	(void) exfat_node_put(fn);
+	return rc;
+}
+
+/** Get the in-memory copy of the Bitmap Table, loading it if needed.
+ *
+ * Must be called with free_maps_lock held.
+ */
+static errno_t exfat_free_map_get(exfat_bs_t *bs, service_id_t service_id,
+    fs_bitmap_t **map)
+{
+	assert(fibril_mutex_is_locked(&free_maps_lock));
+
+	list_foreach(free_maps, link, exfat_free_map_t, fm) {
+		if (fm->service_id == service_id) {
+			*map = &fm->map;
+			return EOK;
+		}
+	}
+
+	exfat_free_map_t *fm = malloc(sizeof(exfat_free_map_t));
+	if (fm == NULL)
+		return ENOMEM;
+
+	errno_t rc = exfat_free_map_load(bs, service_id, &fm->map);
 	if (rc != EOK) {
-		(void) exfat_node_put(fn);
+		free(fm);
 		return rc;
 	}
-	rc = exfat_node_put(fn);
-	if (rc != EOK)
+
+	link_initialize(&fm->link);
+	fm->service_id = service_id;
+	list_append(&fm->link, &free_maps);
+
+	*map = &fm->map;
+	return EOK;
+}
+
+/** Update the in-memory copy of the Bitmap Table after a change on disk. */
+static void exfat_free_map_update(exfat_bs_t *bs, service_id_t service_id,
+    exfat_cluster_t clst, bool alloc)
+{
+	fs_bitmap_t *map;
+
+	fibril_mutex_lock(&free_maps_lock);
+	if (exfat_free_map_get(bs, service_id, &map) == EOK) {
+		if (alloc)
+			fs_bitmap_set_range(map, clst - EXFAT_CLST_FIRST, 1);
+		else
+			fs_bitmap_clear_range(map, clst - EXFAT_CLST_FIRST, 1);
+	}
+	fibril_mutex_unlock(&free_maps_lock);
+}
+
+/** Forget the in-memory copy of the Bitmap Table of a file system.
+ *
+ * @param service_id	Service ID of the file system being closed.
+ */
+void exfat_bitmap_fini(service_id_t service_id)
+{
+	fibril_mutex_lock(&free_maps_lock);
+	list_foreach_safe(free_maps, cur, next) {
+		exfat_free_map_t *fm = list_get_instance(cur, exfat_free_map_t,
+		    link);
+
+		if (fm->service_id == service_id) {
+			list_remove(&fm->link);
+			fs_bitmap_destroy(&fm->map);
+			free(fm);
+		}
+	}
+	fibril_mutex_unlock(&free_maps_lock);
+}
+
+/** Get the number of free clusters.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Service ID of the file system.
+ * @param count		Output parameter where the count will be
+ *			returned.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t exfat_bitmap_free_count(exfat_bs_t *bs, service_id_t service_id,
+    uint64_t *count)
+{
+	fs_bitmap_t *map;
+
+	fibril_mutex_lock(&free_maps_lock);
+	errno_t rc = exfat_free_map_get(bs, service_id, &map);
+	if (rc == EOK)
+		*count = map->free;
+	fibril_mutex_unlock(&free_maps_lock);
+
+	return rc;
+}
+
+errno_t exfat_bitmap_is_free(exfat_bs_t *bs, service_id_t service_id,
+    exfat_cluster_t clst)
+{
+	fs_bitmap_t *map;
+	errno_t rc;
+	bool alloc;
+
+	if (clst < EXFAT_CLST_FIRST || clst - EXFAT_CLST_FIRST >= DATA_CNT(bs))
+		return ENOENT;
+
+	fibril_mutex_lock(&free_maps_lock);
+	rc = exfat_free_map_get(bs, service_id, &map);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&free_maps_lock);
 		return rc;
+	}
+	alloc = fs_bitmap_is_set(map, clst - EXFAT_CLST_FIRST);
+	fibril_mutex_unlock(&free_maps_lock);
 
 	if (alloc)
 		return ENOENT;
@@ -95,22 +225,21 @@ errno_t exfat_bitmap_set_cluster(exfat_bs_t *bs, service_id_t service_id,
 	exfat_node_t *bitmapp;
 	uint8_t *bitmap;
 	errno_t rc;
-
-	clst -= EXFAT_CLST_FIRST;
+	exfat_cluster_t bit = clst - EXFAT_CLST_FIRST;
 
 	rc = exfat_bitmap_get(&fn, service_id);
 	if (rc != EOK)
 		return rc;
 	bitmapp = EXFAT_NODE(fn);
 
-	aoff64_t offset = clst / 8;
+	aoff64_t offset = bit / 8;
 	rc = exfat_block_get(&b, bs, bitmapp, offset / BPS(bs), BLOCK_FLAGS_NONE);
 	if (rc != EOK) {
 		(void) exfat_node_put(fn);
 		return rc;
 	}
 	bitmap = (uint8_t *)b->data;
-	bitmap[offset % BPS(bs)] |= (1 << (clst % 8));
+	bitmap[offset % BPS(bs)] |= (1 << (bit % 8));
 
 	b->dirty = true;
 	rc = block_put(b);
@@ -119,6 +248,7 @@ errno_t exfat_bitmap_set_cluster(exfat_bs_t *bs, service_id_t service_id,
 		return rc;
 	}
 
+	exfat_free_map_update(bs, service_id, clst, true);
 	return exfat_node_put(fn);
 }
 
@@ -130,15 +260,14 @@ errno_t exfat_bitmap_clear_cluster(exfat_bs_t *bs, service_id_t service_id,
 	exfat_node_t *bitmapp;
 	uint8_t *bitmap;
 	errno_t rc;
-
-	clst -= EXFAT_CLST_FIRST;
+	exfat_cluster_t bit = clst - EXFAT_CLST_FIRST;
 
 	rc = exfat_bitmap_get(&fn, service_id);
 	if (rc != EOK)
 		return rc;
 	bitmapp = EXFAT_NODE(fn);
 
-	aoff64_t offset = clst / 8;
+	aoff64_t offset = bit / 8;
 	rc = exfat_block_get(&b, bs, bitmapp, offset / BPS(bs),
 	    BLOCK_FLAGS_NONE);
 	if (rc != EOK) {
@@ -146,7 +275,7 @@ errno_t exfat_bitmap_clear_cluster(exfat_bs_t *bs, service_id_t service_id,
 		return rc;
 	}
 	bitmap = (uint8_t *)b->data;
-	bitmap[offset % BPS(bs)] &= ~(1 << (clst % 8));
+	bitmap[offset % BPS(bs)] &= ~(1 << (bit % 8));
 
 	b->dirty = true;
 	rc = block_put(b);
@@ -155,6 +284,7 @@ errno_t exfat_bitmap_clear_cluster(exfat_bs_t *bs, service_id_t service_id,
 		return rc;
 	}
 
+	exfat_free_map_update(bs, service_id, clst, false);
 	return exfat_node_put(fn);
 }
 
@@ -197,21 +327,29 @@ errno_t exfat_bitmap_clear_clusters(exfat_bs_t *bs, service_id_t service_id,
 errno_t exfat_bitmap_alloc_clusters(exfat_bs_t *bs, service_id_t service_id,
     exfat_cluster_t *firstc, exfat_cluster_t count)
 {
-	exfat_cluster_t startc, endc;
-	startc = EXFAT_CLST_FIRST;
-
-	while (startc < DATA_CNT(bs) + 2) {
-		endc = startc;
-		while (exfat_bitmap_is_free(bs, service_id, endc) == EOK) {
-			if ((endc - startc) + 1 == count) {
-				*firstc = startc;
-				return exfat_bitmap_set_clusters(bs, service_id, startc, count);
-			} else
-				endc++;
-		}
-		startc = endc + 1;
+	fs_bitmap_t *map;
+	size_t start, len;
+	errno_t rc;
+
+	/*
+	 * Look for a run of free clusters long enough for the whole request
+	 * and reserve it in memory before marking it on disk.
+	 */
+	fibril_mutex_lock(&free_maps_lock);
+	rc = exfat_free_map_get(bs, service_id, &map);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&free_maps_lock);
+		return rc;
+	}
+	if (!fs_bitmap_find_free(map, count, &start, &len) || len < count) {
+		fibril_mutex_unlock(&free_maps_lock);
+		return ENOSPC;
 	}
-	return ENOSPC;
+	fs_bitmap_set_range(map, start, count);
+	fibril_mutex_unlock(&free_maps_lock);
+
+	*firstc = start + EXFAT_CLST_FIRST;
+	return exfat_bitmap_set_clusters(bs, service_id, *firstc, count);
 }
 
 errno_t exfat_bitmap_append_clusters(exfat_bs_t *bs, exfat_node_t *nodep,
@@ -931,60 +931,14 @@ errno_t exfat_total_block_count(service_id_t service_id, uint64_t *count)
 
 errno_t exfat_free_block_count(service_id_t service_id, uint64_t *count)
 {
-	fs_node_t *node = NULL;
-	exfat_node_t *bmap_node;
 	exfat_bs_t *bs;
-	uint64_t free_block_count = 0;
-	uint64_t block_count;
-	unsigned sector;
 	errno_t rc;
 
-	rc = exfat_total_block_count(service_id, &block_count);
-	if (rc != EOK)
-		goto exit;
-
 	bs = block_bb_get(service_id);
-	rc = exfat_bitmap_get(&node, service_id);
+	rc = exfat_bitmap_free_count(bs, service_id, count);
 	if (rc != EOK)
-		goto exit;
-
-	bmap_node = (exfat_node_t *) node->data;
-
-	unsigned const bmap_sectors = ROUND_UP(bmap_node->size, BPS(bs)) /
-	    BPS(bs);
-
-	for (sector = 0; sector < bmap_sectors; ++sector) {
-
-		block_t *block;
-		uint8_t *bitmap;
-		unsigned bit;
-
-		rc = exfat_block_get(&block, bs, bmap_node, sector,
-		    BLOCK_FLAGS_NONE);
-		if (rc != EOK) {
-			free_block_count = 0;
-			goto exit;
-		}
-
-		bitmap = (uint8_t *) block->data;
+		*count = 0;
 
-		for (bit = 0; bit < BPS(bs) * 8 && block_count > 0;
-		    ++bit, --block_count) {
-			if (!(bitmap[bit / 8] & (1 << (bit % 8))))
-				++free_block_count;
-		}
-
-		block_put(block);
-
-		if (block_count == 0) {
-			/* Reached the end of the bitmap */
-			goto exit;
-		}
-	}
-
-exit:
-	exfat_node_put(node);
-	*count = free_block_count;
 	return rc;
 }
 
@@ -1223,6 +1177,7 @@ static void exfat_fs_close(service_id_t service_id, fs_node_t *rfn)
 	 * stop using libblock for this instance.
 	 */
 	(void) exfat_node_fini_by_service_id(service_id);
+	exfat_bitmap_fini(service_id);
 	exfat_idx_fini_by_service_id(service_id);
 	(void) block_cache_fini(service_id);
 	block_fini(service_id);
@@ -1337,9 +1292,9 @@ exfat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 
 	ipc_call_t call;
 	size_t len;
-	if (!async_data_read_receive(&call, &len)) {
+	if (!libfs_data_read_receive(&call, &len)) {
 		exfat_node_put(fn);
-		async_answer_0(&call, EINVAL);
+		libfs_data_read_refuse(&call, EINVAL);
 		return EINVAL;
 	}
 
@@ -1354,7 +1309,7 @@ exfat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		if (pos >= nodep->size) {
 			/* reading beyond the EOF */
 			bytes = 0;
-			(void) async_data_read_finalize(&call, NULL, 0);
+			(void) libfs_data_read_finalize(&call, NULL, 0);
 		} else {
 			bytes = min(len, BPS(bs) - pos % BPS(bs));
 			bytes = min(bytes, nodep->size - pos);
@@ -1362,10 +1317,10 @@ exfat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 			    BLOCK_FLAGS_NONE);
 			if (rc != EOK) {
 				exfat_node_put(fn);
-				async_answer_0(&call, rc);
+				libfs_data_read_refuse(&call, rc);
 				return rc;
 			}
-			(void) async_data_read_finalize(&call,
+			(void) libfs_data_read_finalize(&call,
 			    b->data + pos % BPS(bs), bytes);
 			rc = block_put(b);
 			if (rc != EOK) {
@@ -1375,7 +1330,7 @@ exfat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		}
 	} else {
 		if (nodep->type != EXFAT_DIRECTORY) {
-			async_answer_0(&call, ENOTSUP);
+			libfs_data_read_refuse(&call, ENOTSUP);
 			return ENOTSUP;
 		}
 
@@ -1409,7 +1364,7 @@ exfat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 
 	err:
 		(void) exfat_node_put(fn);
-		async_answer_0(&call, rc);
+		libfs_data_read_refuse(&call, rc);
 		return rc;
 
 	miss:
@@ -1417,7 +1372,7 @@ exfat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		if (rc != EOK)
 			goto err;
 		rc = exfat_node_put(fn);
-		async_answer_0(&call, rc != EOK ? rc : ENOENT);
+		libfs_data_read_refuse(&call, rc != EOK ? rc : ENOENT);
 		*rbytes = 0;
 		return rc != EOK ? rc : ENOENT;
 
@@ -1426,7 +1381,7 @@ exfat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		rc = exfat_directory_close(&di);
 		if (rc != EOK)
 			goto err;
-		(void) async_data_read_finalize(&call, name,
+		(void) libfs_data_read_finalize(&call, name,
 		    str_size(name) + 1);
 		bytes = (pos - spos) + 1;
 	}
@@ -49,6 +49,8 @@
 
 vfs_info_t ext4fs_vfs_info = {
 	.name = NAME,
+	.read_buffer = true,
+	.threads = 4,
 	.instance = 0
 };
 
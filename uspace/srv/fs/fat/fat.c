@@ -55,6 +55,8 @@ vfs_info_t fat_vfs_info = {
 	.name = NAME,
 	.concurrent_read_write = false,
 	.write_retains_size = false,
+	.read_buffer = true,
+	.threads = 4,
 	.instance = 0,
 };
 
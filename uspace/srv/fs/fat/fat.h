@@ -36,6 +36,7 @@
 
 #include "fat_fat.h"
 #include <fibril_synch.h>
+#include <fs_bitmap.h>
 #include <libfs.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -156,6 +157,9 @@ typedef struct fat_bs {
 #define FAT32_FSINFO_SIG2	"rrAa"
 #define FAT32_FSINFO_SIG3	"\x00\x00\x55\xaa"
 
+/** FSInfo value for an unknown free cluster count or next free cluster. */
+#define FAT32_FSINFO_UNKNOWN	0xffffffff
+
 typedef struct {
 	uint8_t	sig1[4];
 	uint8_t res1[480];
@@ -221,6 +225,19 @@ typedef struct {
 	struct fat_node	*nodep;
 } fat_idx_t;
 
+/** Maximum number of extents cached for a node. */
+#define FAT_EXTENTS_MAX	32
+
+/** Run of clusters of a file which are contiguous on the disk. */
+typedef struct {
+	/** Index of the first cluster of the run within the file. */
+	uint32_t		fcl;
+	/** Number of clusters in the run. */
+	uint32_t		count;
+	/** First cluster of the run on the disk. */
+	fat_cluster_t		dcl;
+} fat_extent_t;
+
 /** FAT in-core node. */
 typedef struct fat_node {
 	/** Back pointer to the FS node. */
@@ -243,20 +260,36 @@ typedef struct fat_node {
 	bool			dirty;
 
 	/*
-	 * Cache of the node's last and "current" cluster to avoid some
-	 * unnecessary FAT walks.
+	 * Cache of the node's last cluster to avoid some unnecessary FAT
+	 * walks.
 	 */
 	/* Node's last cluster in FAT. */
 	bool		lastc_cached_valid;
 	fat_cluster_t	lastc_cached_value;
-	/* Node's "current" cluster, i.e. where the last I/O took place. */
-	bool		currc_cached_valid;
-	aoff64_t	currc_cached_bn;
-	fat_cluster_t	currc_cached_value;
+
+	/*
+	 * Extents of the beginning of the node's cluster chain, sorted by
+	 * the file cluster index. Together they cover file clusters from
+	 * zero up to the end of the last extent.
+	 */
+	fat_extent_t	extents[FAT_EXTENTS_MAX];
+	unsigned	extents_count;
+	/* The chain continues past the last extent, but the cache is full. */
+	bool		extents_full;
 } fat_node_t;
 
 typedef struct {
 	bool lfn_enabled;
+
+	/*
+	 * Map of clusters in use, built from FAT1 when first needed. Protected
+	 * by fat_alloc_lock.
+	 */
+	bool		free_map_valid;
+	fs_bitmap_t	free_map;
+	/* Free cluster count and next free cluster hints from FSInfo. */
+	uint32_t	fsinfo_free;
+	uint32_t	fsinfo_next;
 } fat_instance_t;
 
 extern vfs_out_ops_t fat_ops;
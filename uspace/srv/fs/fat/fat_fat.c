@@ -112,6 +112,106 @@ fat_cluster_walk(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc,
 	return EOK;
 }
 
+/** Find the extent containing a file cluster.
+ *
+ * @param nodep		FAT node.
+ * @param fcl		Index of the cluster within the file. It must be
+ *			covered by the node's extents.
+ *
+ * @return		Extent containing the cluster.
+ */
+static fat_extent_t *fat_extent_find(fat_node_t *nodep, uint32_t fcl)
+{
+	unsigned lo = 0;
+	unsigned hi = nodep->extents_count;
+
+	while (hi - lo > 1) {
+		unsigned mid = (lo + hi) / 2;
+		if (nodep->extents[mid].fcl <= fcl)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	assert(fcl - nodep->extents[lo].fcl < nodep->extents[lo].count);
+	return &nodep->extents[lo];
+}
+
+/** Get the disk cluster of a file cluster.
+ *
+ * Clusters covered by the node's extent cache are found by a binary search.
+ * Otherwise the cluster chain is walked from the end of the last extent and
+ * the clusters visited on the way are added to the cache.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param nodep		FAT node with at least one cluster allocated.
+ * @param fcl		Index of the cluster within the file.
+ * @param clp		Address where the disk cluster will be stored.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t fat_node_cluster_get(fat_bs_t *bs, fat_node_t *nodep, uint32_t fcl,
+    fat_cluster_t *clp)
+{
+	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	errno_t rc;
+
+	if (nodep->firstc == FAT_CLST_RES0)
+		return ELIMIT;
+
+	if (nodep->extents_count == 0) {
+		nodep->extents[0].fcl = 0;
+		nodep->extents[0].count = 1;
+		nodep->extents[0].dcl = nodep->firstc;
+		nodep->extents_count = 1;
+		nodep->extents_full = false;
+	}
+
+	fat_extent_t *ext = &nodep->extents[nodep->extents_count - 1];
+	if (fcl < ext->fcl + ext->count) {
+		ext = fat_extent_find(nodep, fcl);
+		*clp = ext->dcl + (fcl - ext->fcl);
+		return EOK;
+	}
+
+	/* Walk the chain past the last extent. */
+	uint32_t curfcl = ext->fcl + ext->count - 1;
+	fat_cluster_t clst = ext->dcl + ext->count - 1;
+	bool record = !nodep->extents_full;
+
+	while (curfcl < fcl) {
+		fat_cluster_t nextc;
+
+		rc = fat_get_cluster(bs, nodep->idx->service_id, FAT1, clst,
+		    &nextc);
+		if (rc != EOK)
+			return rc;
+		if (nextc >= clst_last1)
+			return ELIMIT;
+		assert(nextc >= FAT_CLST_FIRST);
+		assert(nextc != FAT_CLST_BAD(bs));
+
+		curfcl++;
+		if (record && nextc == clst + 1) {
+			ext->count++;
+		} else if (record &&
+		    nodep->extents_count < FAT_EXTENTS_MAX) {
+			ext = &nodep->extents[nodep->extents_count++];
+			ext->fcl = curfcl;
+			ext->count = 1;
+			ext->dcl = nextc;
+		} else if (record) {
+			/* Only a prefix of the chain can be cached. */
+			nodep->extents_full = true;
+			record = false;
+		}
+		clst = nextc;
+	}
+
+	*clp = clst;
+	return EOK;
+}
+
 /** Read block from file located on a FAT file system.
  *
  * @param block		Pointer to a block pointer for storing result.
@@ -126,16 +226,16 @@ errno_t
 fat_block_get(block_t **block, struct fat_bs *bs, fat_node_t *nodep,
     aoff64_t bn, int flags)
 {
-	fat_cluster_t firstc = nodep->firstc;
-	fat_cluster_t currc = 0;
-	aoff64_t relbn = bn;
+	fat_cluster_t currc;
 	errno_t rc;
 
 	if (!nodep->size)
 		return ELIMIT;
 
-	if (!FAT_IS_FAT32(bs) && nodep->firstc == FAT_CLST_ROOT)
-		goto fall_through;
+	if (!FAT_IS_FAT32(bs) && nodep->firstc == FAT_CLST_ROOT) {
+		return _fat_block_get(block, bs, nodep->idx->service_id,
+		    nodep->firstc, NULL, bn, flags);
+	}
 
 	if (((((nodep->size - 1) / BPS(bs)) / SPC(bs)) == bn / SPC(bs)) &&
 	    nodep->lastc_cached_valid) {
@@ -147,29 +247,12 @@ fat_block_get(block_t **block, struct fat_bs *bs, fat_node_t *nodep,
 		    CLBN2PBN(bs, nodep->lastc_cached_value, bn), flags);
 	}
 
-	if (nodep->currc_cached_valid && bn >= nodep->currc_cached_bn) {
-		/*
-		 * We can start with the cluster cached by the previous call to
-		 * fat_block_get().
-		 */
-		firstc = nodep->currc_cached_value;
-		relbn -= (nodep->currc_cached_bn / SPC(bs)) * SPC(bs);
-	}
-
-fall_through:
-	rc = _fat_block_get(block, bs, nodep->idx->service_id, firstc,
-	    &currc, relbn, flags);
+	rc = fat_node_cluster_get(bs, nodep, bn / SPC(bs), &currc);
 	if (rc != EOK)
 		return rc;
 
-	/*
-	 * Update the "current" cluster cache.
-	 */
-	nodep->currc_cached_valid = true;
-	nodep->currc_cached_bn = bn;
-	nodep->currc_cached_value = currc;
-
-	return rc;
+	return block_get(block, nodep->idx->service_id,
+	    CLBN2PBN(bs, currc, bn), flags);
 }
 
 /** Read block from file located on a FAT file system.
@@ -654,6 +737,103 @@ errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
 	return EOK;
 }
 
+/** Get the map of clusters in use, building it if needed.
+ *
+ * The map has a bit for every cluster number, including the reserved ones
+ * which are always marked as used. It must be called with fat_alloc_lock
+ * held.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ * @param map		Output parameter where the map will be returned.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t fat_free_map_get(fat_bs_t *bs, service_id_t service_id,
+    fs_bitmap_t **map)
+{
+	fat_instance_t *instance;
+	fat_cluster_t clst, value;
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&fat_alloc_lock));
+
+	rc = fs_instance_get(service_id, (void **) &instance);
+	if (rc != EOK)
+		return rc;
+
+	if (!instance->free_map_valid) {
+		rc = fs_bitmap_create(&instance->free_map, CC(bs) + 2);
+		if (rc != EOK)
+			return rc;
+
+		for (clst = FAT_CLST_FIRST; clst < CC(bs) + 2; clst++) {
+			rc = fat_get_cluster(bs, service_id, FAT1, clst,
+			    &value);
+			if (rc != EOK) {
+				fs_bitmap_destroy(&instance->free_map);
+				return rc;
+			}
+
+			if (value == FAT_CLST_RES0) {
+				fs_bitmap_clear_range(&instance->free_map,
+				    clst, 1);
+			}
+		}
+
+		/* Start allocating where the FSInfo hint suggests. */
+		if (instance->fsinfo_next >= FAT_CLST_FIRST &&
+		    instance->fsinfo_next < CC(bs) + 2)
+			instance->free_map.hint = instance->fsinfo_next;
+		else
+			instance->free_map.hint = FAT_CLST_FIRST;
+
+		instance->free_map_valid = true;
+	}
+
+	*map = &instance->free_map;
+	return EOK;
+}
+
+/** Get the number of free clusters.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ * @param count		Output parameter where the count will be
+ *			returned.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t fat_free_clusters_count(fat_bs_t *bs, service_id_t service_id,
+    uint32_t *count)
+{
+	fat_instance_t *instance;
+	fs_bitmap_t *map;
+	errno_t rc;
+
+	rc = fs_instance_get(service_id, (void **) &instance);
+	if (rc != EOK)
+		return rc;
+
+	fibril_mutex_lock(&fat_alloc_lock);
+
+	if (!instance->free_map_valid &&
+	    instance->fsinfo_free != FAT32_FSINFO_UNKNOWN &&
+	    instance->fsinfo_free <= CC(bs)) {
+		/* Trust FSInfo until the map is needed for allocation. */
+		*count = instance->fsinfo_free;
+		fibril_mutex_unlock(&fat_alloc_lock);
+		return EOK;
+	}
+
+	rc = fat_free_map_get(bs, service_id, &map);
+	if (rc == EOK)
+		*count = map->free;
+
+	fibril_mutex_unlock(&fat_alloc_lock);
+	return rc;
+}
+
 /** Allocate clusters in all copies of FAT.
  *
  * This function will attempt to allocate the requested number of clusters in
@@ -661,6 +841,10 @@ errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
  * clusters form an independent chain (i.e. a chain which does not belong to any
  * file yet).
  *
+ * The clusters are taken from as few runs of free clusters as possible,
+ * starting where the previous allocation ended, so that files stay
+ * contiguous on the disk.
+ *
  * @param bs		Buffer holding the boot sector of the file system.
  * @param service_id	Device service ID of the file system.
  * @param nclsts	Number of clusters to allocate.
@@ -676,45 +860,48 @@ fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
     fat_cluster_t *mcl, fat_cluster_t *lcl)
 {
 	fat_cluster_t *lifo;    /* stack for storing free cluster numbers */
-	unsigned found = 0;     /* top of the free cluster number stack */
-	fat_cluster_t clst;
-	fat_cluster_t value = 0;
+	unsigned found = 0;     /* number of free clusters found */
+	unsigned written = 0;	/* number of clusters chained in FAT1 */
 	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
-	errno_t rc = EOK;
+	fs_bitmap_t *map;
+	errno_t rc;
 
 	lifo = (fat_cluster_t *) malloc(nclsts * sizeof(fat_cluster_t));
 	if (!lifo)
 		return ENOMEM;
 
+	fibril_mutex_lock(&fat_alloc_lock);
+	rc = fat_free_map_get(bs, service_id, &map);
+	if (rc == EOK && map->free < nclsts)
+		rc = ENOSPC;
+
 	/*
-	 * Search FAT1 for unused clusters.
+	 * Take runs of free clusters from the map. The chain is to end with
+	 * lifo[0], so the stack is filled from its top.
 	 */
-	fibril_mutex_lock(&fat_alloc_lock);
-	for (clst = FAT_CLST_FIRST; clst < CC(bs) + 2 && found < nclsts;
-	    clst++) {
-		rc = fat_get_cluster(bs, service_id, FAT1, clst, &value);
-		if (rc != EOK)
+	while (rc == EOK && found < nclsts) {
+		size_t start, len;
+
+		if (!fs_bitmap_find_free(map, nclsts - found, &start, &len)) {
+			rc = ENOSPC;
 			break;
+		}
 
-		if (value == FAT_CLST_RES0) {
-			/*
-			 * The cluster is free. Put it into our stack
-			 * of found clusters and mark it as non-free.
-			 */
-			lifo[found] = clst;
-			rc = fat_set_cluster(bs, service_id, FAT1, clst,
-			    (found == 0) ?  clst_last1 : lifo[found - 1]);
-			if (rc != EOK)
-				break;
+		fs_bitmap_set_range(map, start, len);
+		for (size_t i = 0; i < len; i++, found++)
+			lifo[nclsts - 1 - found] = start + i;
+	}
 
-			found++;
-		}
+	/* Link the clusters into a chain in FAT1. */
+	for (; rc == EOK && written < nclsts; written++) {
+		rc = fat_set_cluster(bs, service_id, FAT1, lifo[written],
+		    (written == 0) ? clst_last1 : lifo[written - 1]);
 	}
 
-	if (rc == EOK && found == nclsts) {
+	if (rc == EOK) {
 		rc = fat_alloc_shadow_clusters(bs, service_id, lifo, nclsts);
 		if (rc == EOK) {
-			*mcl = lifo[found - 1];
+			*mcl = lifo[nclsts - 1];
 			*lcl = lifo[0];
 			free(lifo);
 			fibril_mutex_unlock(&fat_alloc_lock);
@@ -723,15 +910,37 @@ fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 	}
 
 	/* If something wrong - free the clusters */
-	while (found--) {
-		(void) fat_set_cluster(bs, service_id, FAT1, lifo[found],
+	while (written--) {
+		(void) fat_set_cluster(bs, service_id, FAT1, lifo[written],
 		    FAT_CLST_RES0);
 	}
+	while (found--)
+		fs_bitmap_clear_range(map, lifo[nclsts - 1 - found], 1);
 
 	free(lifo);
 	fibril_mutex_unlock(&fat_alloc_lock);
 
-	return ENOSPC;
+	return rc;
+}
+
+/** Mark a cluster as free in the map of clusters in use.
+ *
+ * @param service_id	Device service ID of the file system.
+ * @param clst		Cluster which has been freed in all copies of FAT.
+ */
+static void fat_free_map_clear(service_id_t service_id, fat_cluster_t clst)
+{
+	fat_instance_t *instance;
+
+	if (fs_instance_get(service_id, (void **) &instance) != EOK)
+		return;
+
+	fibril_mutex_lock(&fat_alloc_lock);
+	if (instance->free_map_valid)
+		fs_bitmap_clear_range(&instance->free_map, clst, 1);
+	else
+		instance->fsinfo_free = FAT32_FSINFO_UNKNOWN;
+	fibril_mutex_unlock(&fat_alloc_lock);
 }
 
 /** Free clusters forming a cluster chain in all copies of FAT.
@@ -764,6 +973,7 @@ fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 			if (rc != EOK)
 				return rc;
 		}
+		fat_free_map_clear(service_id, firstc);
 
 		firstc = nextc;
 	}
@@ -817,6 +1027,29 @@ errno_t fat_append_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t mcl,
 	return EOK;
 }
 
+/** Drop cached extents past a cluster which becomes the node's last.
+ *
+ * @param nodep		FAT node.
+ * @param lcl		Last cluster which will remain in the node or
+ *			FAT_CLST_RES0.
+ */
+static void fat_extents_chop(fat_node_t *nodep, fat_cluster_t lcl)
+{
+	for (unsigned i = 0; i < nodep->extents_count; i++) {
+		fat_extent_t *ext = &nodep->extents[i];
+
+		if (lcl >= ext->dcl && lcl - ext->dcl < ext->count) {
+			ext->count = lcl - ext->dcl + 1;
+			nodep->extents_count = i + 1;
+			nodep->extents_full = false;
+			return;
+		}
+	}
+
+	nodep->extents_count = 0;
+	nodep->extents_full = false;
+}
+
 /** Chop off node clusters in all copies of FAT.
  *
  * @param bs		Buffer holding the boot sector of the file system.
@@ -834,11 +1067,11 @@ errno_t fat_chop_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t lcl)
 	service_id_t service_id = nodep->idx->service_id;
 
 	/*
-	 * Invalidate cached cluster numbers.
+	 * Invalidate cached cluster numbers and drop the extents past the
+	 * new last cluster.
 	 */
 	nodep->lastc_cached_valid = false;
-	if (nodep->currc_cached_value != lcl)
-		nodep->currc_cached_valid = false;
+	fat_extents_chop(nodep, lcl);
 
 	if (lcl == FAT_CLST_RES0) {
 		/* The node will have zero size and no clusters allocated. */
@@ -110,6 +110,8 @@ typedef uint32_t fat_cluster_t;
 extern errno_t fat_cluster_walk(struct fat_bs *, service_id_t, fat_cluster_t,
     fat_cluster_t *, uint32_t *, uint32_t);
 
+extern errno_t fat_node_cluster_get(struct fat_bs *, struct fat_node *,
+    uint32_t, fat_cluster_t *);
 extern errno_t fat_block_get(block_t **, struct fat_bs *, struct fat_node *,
     aoff64_t, int);
 extern errno_t _fat_block_get(block_t **, struct fat_bs *, service_id_t,
@@ -122,6 +124,8 @@ extern errno_t fat_chop_clusters(struct fat_bs *, struct fat_node *,
 extern errno_t fat_alloc_clusters(struct fat_bs *, service_id_t, unsigned,
     fat_cluster_t *, fat_cluster_t *);
 extern errno_t fat_free_clusters(struct fat_bs *, service_id_t, fat_cluster_t);
+extern errno_t fat_free_clusters_count(struct fat_bs *, service_id_t,
+    uint32_t *);
 extern errno_t fat_alloc_shadow_clusters(struct fat_bs *, service_id_t,
     fat_cluster_t *, unsigned);
 extern errno_t fat_get_cluster(struct fat_bs *, service_id_t, unsigned,
@@ -108,9 +108,8 @@ static void fat_node_initialize(fat_node_t *node)
 	node->dirty = false;
 	node->lastc_cached_valid = false;
 	node->lastc_cached_value = 0;
-	node->currc_cached_valid = false;
-	node->currc_cached_bn = 0;
-	node->currc_cached_value = 0;
+	node->extents_count = 0;
+	node->extents_full = false;
 }
 
 static errno_t fat_node_sync(fat_node_t *node)
@@ -864,24 +863,15 @@ errno_t fat_total_block_count(service_id_t service_id, uint64_t *count)
 errno_t fat_free_block_count(service_id_t service_id, uint64_t *count)
 {
 	fat_bs_t *bs;
-	fat_cluster_t e0;
-	uint64_t block_count;
+	uint32_t clusters;
 	errno_t rc;
-	uint32_t cluster_no, clusters;
 
-	block_count = 0;
 	bs = block_bb_get(service_id);
-	clusters = (SPC(bs)) ? TS(bs) / SPC(bs) : 0;
-	for (cluster_no = 0; cluster_no < clusters; cluster_no++) {
-		rc = fat_get_cluster(bs, service_id, FAT1, cluster_no, &e0);
-		if (rc != EOK)
-			return EIO;
-
-		if (e0 == FAT_CLST_RES0)
-			block_count++;
-	}
-	*count = block_count;
+	rc = fat_free_clusters_count(bs, service_id, &clusters);
+	if (rc != EOK)
+		return EIO;
 
+	*count = clusters;
 	return EOK;
 }
 
@@ -1074,6 +1064,36 @@ static errno_t fat_fsprobe(service_id_t service_id, vfs_fs_probe_info_t *info)
 	return EOK;
 }
 
+/** Read the free cluster hints from the FAT32 FS info. */
+static errno_t fat_read_fat32_fsinfo(service_id_t service_id,
+    fat_instance_t *instance)
+{
+	fat_bs_t *bs;
+	fat32_fsinfo_t *info;
+	block_t *b;
+	errno_t rc;
+
+	bs = block_bb_get(service_id);
+	assert(FAT_IS_FAT32(bs));
+
+	rc = block_get(&b, service_id, uint16_t_le2host(bs->fat32.fsinfo_sec),
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK)
+		return rc;
+
+	info = (fat32_fsinfo_t *) b->data;
+
+	if (memcmp(info->sig1, FAT32_FSINFO_SIG1, sizeof(info->sig1)) == 0 &&
+	    memcmp(info->sig2, FAT32_FSINFO_SIG2, sizeof(info->sig2)) == 0 &&
+	    memcmp(info->sig3, FAT32_FSINFO_SIG3, sizeof(info->sig3)) == 0) {
+		instance->fsinfo_free = uint32_t_le2host(info->free_clusters);
+		instance->fsinfo_next =
+		    uint32_t_le2host(info->last_allocated_cluster);
+	}
+
+	return block_put(b);
+}
+
 static errno_t
 fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
     aoff64_t *size)
@@ -1088,6 +1108,9 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 	if (!instance)
 		return ENOMEM;
 	instance->lfn_enabled = true;
+	instance->free_map_valid = false;
+	instance->fsinfo_free = FAT32_FSINFO_UNKNOWN;
+	instance->fsinfo_next = FAT32_FSINFO_UNKNOWN;
 
 	/* Parse mount options. */
 	char *mntopts = (char *) opts;
@@ -1117,6 +1140,10 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 
 	fibril_mutex_unlock(&ridxp->lock);
 
+	fat_bs_t *bs = block_bb_get(service_id);
+	if (FAT_IS_FAT32(bs))
+		(void) fat_read_fat32_fsinfo(service_id, instance);
+
 	*index = ridxp->index;
 	*size = FAT_NODE(rfn)->size;
 
@@ -1125,6 +1152,7 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 
 static errno_t fat_update_fat32_fsinfo(service_id_t service_id)
 {
+	fat_instance_t *instance;
 	fat_bs_t *bs;
 	fat32_fsinfo_t *info;
 	block_t *b;
@@ -1133,6 +1161,10 @@ static errno_t fat_update_fat32_fsinfo(service_id_t service_id)
 	bs = block_bb_get(service_id);
 	assert(FAT_IS_FAT32(bs));
 
+	rc = fs_instance_get(service_id, (void **) &instance);
+	if (rc != EOK)
+		return rc;
+
 	rc = block_get(&b, service_id, uint16_t_le2host(bs->fat32.fsinfo_sec),
 	    BLOCK_FLAGS_NONE);
 	if (rc != EOK)
@@ -1147,8 +1179,14 @@ static errno_t fat_update_fat32_fsinfo(service_id_t service_id)
 		return EINVAL;
 	}
 
-	/* For now, invalidate the counter. */
-	info->free_clusters = host2uint16_t_le(-1);
+	/* Record what we know about free clusters as hints for next mount. */
+	if (instance->free_map_valid) {
+		info->free_clusters = host2uint32_t_le(instance->free_map.free);
+		info->last_allocated_cluster =
+		    host2uint32_t_le(instance->free_map.hint);
+	} else {
+		info->free_clusters = host2uint32_t_le(instance->fsinfo_free);
+	}
 
 	b->dirty = true;
 	return block_put(b);
@@ -1199,7 +1237,11 @@ static errno_t fat_unmounted(service_id_t service_id)
 
 	void *data;
 	if (fs_instance_get(service_id, &data) == EOK) {
+		fat_instance_t *instance = (fat_instance_t *) data;
+
 		fs_instance_destroy(service_id);
+		if (instance->free_map_valid)
+			fs_bitmap_destroy(&instance->free_map);
 		free(data);
 	}
 
@@ -1226,9 +1268,9 @@ fat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 
 	ipc_call_t call;
 	size_t len;
-	if (!async_data_read_receive(&call, &len)) {
+	if (!libfs_data_read_receive(&call, &len)) {
 		fat_node_put(fn);
-		async_answer_0(&call, EINVAL);
+		libfs_data_read_refuse(&call, EINVAL);
 		return EINVAL;
 	}
 
@@ -1243,7 +1285,7 @@ fat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		if (pos >= nodep->size) {
 			/* reading beyond the EOF */
 			bytes = 0;
-			(void) async_data_read_finalize(&call, NULL, 0);
+			(void) libfs_data_read_finalize(&call, NULL, 0);
 		} else {
 			bytes = min(len, BPS(bs) - pos % BPS(bs));
 			bytes = min(bytes, nodep->size - pos);
@@ -1251,10 +1293,10 @@ fat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 			    BLOCK_FLAGS_NONE);
 			if (rc != EOK) {
 				fat_node_put(fn);
-				async_answer_0(&call, rc);
+				libfs_data_read_refuse(&call, rc);
 				return rc;
 			}
-			(void) async_data_read_finalize(&call,
+			(void) libfs_data_read_finalize(&call,
 			    b->data + pos % BPS(bs), bytes);
 			rc = block_put(b);
 			if (rc != EOK) {
@@ -1289,7 +1331,7 @@ fat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 
 	err:
 		(void) fat_node_put(fn);
-		async_answer_0(&call, rc);
+		libfs_data_read_refuse(&call, rc);
 		return rc;
 
 	miss:
@@ -1297,7 +1339,7 @@ fat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		if (rc != EOK)
 			goto err;
 		rc = fat_node_put(fn);
-		async_answer_0(&call, rc != EOK ? rc : ENOENT);
+		libfs_data_read_refuse(&call, rc != EOK ? rc : ENOENT);
 		*rbytes = 0;
 		return rc != EOK ? rc : ENOENT;
 
@@ -1306,7 +1348,7 @@ fat_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		rc = fat_directory_close(&di);
 		if (rc != EOK)
 			goto err;
-		(void) async_data_read_finalize(&call, name,
+		(void) libfs_data_read_finalize(&call, name,
 		    str_size(name) + 1);
 		bytes = (pos - spos) + 1;
 	}
@@ -1495,8 +1537,8 @@ fat_truncate(service_id_t service_id, fs_index_t index, aoff64_t size)
 				goto out;
 		} else {
 			fat_cluster_t lastc;
-			rc = fat_cluster_walk(bs, service_id, nodep->firstc,
-			    &lastc, NULL, (size - 1) / BPC(bs));
+			rc = fat_node_cluster_get(bs, nodep,
+			    (size - 1) / BPC(bs), &lastc);
 			if (rc != EOK)
 				goto out;
 			rc = fat_chop_clusters(bs, nodep, lastc);
@@ -56,6 +56,7 @@ static vfs_info_t locfs_vfs_info = {
 	.name = NAME,
 	.concurrent_read_write = false,
 	.write_retains_size = false,
+	.read_buffer = false,
 	.instance = 0,
 };
 
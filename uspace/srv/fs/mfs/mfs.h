@@ -38,6 +38,7 @@
 #include <block.h>
 #include <libfs.h>
 #include <adt/list.h>
+#include <fibril_synch.h>
 #include <mem.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -74,6 +75,17 @@ typedef enum {
 	BMAP_INODE
 } bmap_id_t;
 
+#define MFS_BMAP_COUNT	2
+
+/* In-memory summary of a bitmap, built when the bitmap is first used */
+struct mfs_bmap_summary {
+	bool valid;
+	/* Number of free bits in each bitmap block */
+	uint32_t *nfree;
+	/* Total number of free bits */
+	uint32_t total_free;
+};
+
 typedef enum {
 	MFS_VERSION_V1 = 1,
 	MFS_VERSION_V2,
@@ -105,17 +117,15 @@ struct mfs_sb_info {
 	unsigned isearch;
 	unsigned zsearch;
 
+	/* Protects the bitmaps, their summaries and the search hints */
+	fibril_mutex_t bmap_lock;
+
 	/*
-	 * Indicates wether if the cached number of free zones
-	 * is to be considered valid or not.
-	 */
-	bool nfree_zones_valid;
-	/*
-	 * Cached number of free zones, used to avoid to scan
-	 * the whole bitmap every time the mfs_free_block_count()
-	 * is invoked.
+	 * Summaries of the zone and inode bitmaps (indexed by bmap_id_t),
+	 * used to skip full bitmap blocks and to avoid to scan the whole
+	 * bitmap every time the number of free zones or inodes is needed.
 	 */
-	unsigned nfree_zones;
+	struct mfs_bmap_summary bmap[MFS_BMAP_COUNT];
 };
 
 /* Generic MinixFS inode */
@@ -164,6 +174,10 @@ struct mfs_node {
 	unsigned refcnt;
 	fs_node_t *fsnode;
 	ht_link_t link;
+	/* Link to the list of cached nodes not in use */
+	link_t unused_link;
+	/* Held for reading while reading the node, for writing otherwise */
+	fibril_rwlock_t lock;
 };
 
 /* mfs_ops.c */
@@ -228,6 +242,9 @@ mfs_count_free_zones(struct mfs_instance *inst, uint32_t *zones);
 extern errno_t
 mfs_count_free_inodes(struct mfs_instance *inst, uint32_t *inodes);
 
+extern void
+mfs_bmap_fini(struct mfs_sb_info *sbi);
+
 /* mfs_utils.c */
 extern uint16_t
 conv16(bool native, uint16_t n);
@@ -31,10 +31,12 @@
  */
 
 #include <stdlib.h>
+#include <bitops.h>
+#include <fibril_synch.h>
 #include "mfs.h"
 
 static int
-find_free_bit_and_set(bitchunk_t *b, const int bsize,
+find_free_bit_and_set(bitchunk_t *b, unsigned nbits,
     const bool native, unsigned start_bit);
 
 static errno_t
@@ -46,6 +48,9 @@ mfs_alloc_bit(struct mfs_instance *inst, uint32_t *idx, bmap_id_t bid);
 static errno_t
 mfs_count_free_bits(struct mfs_instance *inst, bmap_id_t bid, uint32_t *free);
 
+static errno_t
+mfs_bmap_load(struct mfs_instance *inst, bmap_id_t bid);
+
 /**Allocate a new inode.
  *
  * @param inst		Pointer to the filesystem instance.
@@ -57,7 +62,9 @@ mfs_count_free_bits(struct mfs_instance *inst, bmap_id_t bid, uint32_t *free);
 errno_t
 mfs_alloc_inode(struct mfs_instance *inst, uint32_t *inum)
 {
+	fibril_mutex_lock(&inst->sbi->bmap_lock);
 	errno_t r = mfs_alloc_bit(inst, inum, BMAP_INODE);
+	fibril_mutex_unlock(&inst->sbi->bmap_lock);
 	return r;
 }
 
@@ -71,7 +78,10 @@ mfs_alloc_inode(struct mfs_instance *inst, uint32_t *inum)
 errno_t
 mfs_free_inode(struct mfs_instance *inst, uint32_t inum)
 {
-	return mfs_free_bit(inst, inum, BMAP_INODE);
+	fibril_mutex_lock(&inst->sbi->bmap_lock);
+	errno_t r = mfs_free_bit(inst, inum, BMAP_INODE);
+	fibril_mutex_unlock(&inst->sbi->bmap_lock);
+	return r;
 }
 
 /**Allocate a new zone.
@@ -85,15 +95,12 @@ mfs_free_inode(struct mfs_instance *inst, uint32_t inum)
 errno_t
 mfs_alloc_zone(struct mfs_instance *inst, uint32_t *zone)
 {
+	fibril_mutex_lock(&inst->sbi->bmap_lock);
 	errno_t r = mfs_alloc_bit(inst, zone, BMAP_ZONE);
+	fibril_mutex_unlock(&inst->sbi->bmap_lock);
 	if (r != EOK)
 		return r;
 
-	/* Update the cached number of free zones */
-	struct mfs_sb_info *sbi = inst->sbi;
-	if (sbi->nfree_zones_valid)
-		sbi->nfree_zones--;
-
 	*zone += inst->sbi->firstdatazone - 1;
 	return r;
 }
@@ -108,19 +115,11 @@ mfs_alloc_zone(struct mfs_instance *inst, uint32_t *zone)
 errno_t
 mfs_free_zone(struct mfs_instance *inst, uint32_t zone)
 {
-	errno_t r;
-
 	zone -= inst->sbi->firstdatazone - 1;
 
-	r = mfs_free_bit(inst, zone, BMAP_ZONE);
-	if (r != EOK)
-		return r;
-
-	/* Update the cached number of free zones */
-	struct mfs_sb_info *sbi = inst->sbi;
-	if (sbi->nfree_zones_valid)
-		sbi->nfree_zones++;
-
+	fibril_mutex_lock(&inst->sbi->bmap_lock);
+	errno_t r = mfs_free_bit(inst, zone, BMAP_ZONE);
+	fibril_mutex_unlock(&inst->sbi->bmap_lock);
 	return r;
 }
 
@@ -135,7 +134,10 @@ mfs_free_zone(struct mfs_instance *inst, uint32_t zone)
 errno_t
 mfs_count_free_zones(struct mfs_instance *inst, uint32_t *zones)
 {
-	return mfs_count_free_bits(inst, BMAP_ZONE, zones);
+	fibril_mutex_lock(&inst->sbi->bmap_lock);
+	errno_t r = mfs_count_free_bits(inst, BMAP_ZONE, zones);
+	fibril_mutex_unlock(&inst->sbi->bmap_lock);
+	return r;
 }
 
 /** Count the number of free inodes
@@ -150,71 +152,161 @@ mfs_count_free_zones(struct mfs_instance *inst, uint32_t *zones)
 errno_t
 mfs_count_free_inodes(struct mfs_instance *inst, uint32_t *inodes)
 {
-	return mfs_count_free_bits(inst, BMAP_INODE, inodes);
+	fibril_mutex_lock(&inst->sbi->bmap_lock);
+	errno_t r = mfs_count_free_bits(inst, BMAP_INODE, inodes);
+	fibril_mutex_unlock(&inst->sbi->bmap_lock);
+	return r;
 }
 
-/** Count the number of free bits in a bitmap
+/** Release the in-memory summaries of the bitmaps
+ *
+ * @param sbi           Pointer to the superblock info structure.
+ */
+void
+mfs_bmap_fini(struct mfs_sb_info *sbi)
+{
+	unsigned i;
+
+	for (i = 0; i < MFS_BMAP_COUNT; ++i) {
+		free(sbi->bmap[i].nfree);
+		sbi->bmap[i].nfree = NULL;
+		sbi->bmap[i].valid = false;
+	}
+}
+
+/** Count the zero bits of a bitmap chunk
+ *
+ * @param chunk         Bitmap chunk in the host byte order.
+ * @param nbits         Number of the least significant bits to consider.
+ *
+ * @return              Number of zero bits.
+ */
+static unsigned
+chunk_count_free(bitchunk_t chunk, unsigned nbits)
+{
+	uint32_t v = ~chunk;
+
+	if (nbits < sizeof(bitchunk_t) * 8)
+		v &= BIT_RRANGE(uint32_t, nbits);
+
+	v = v - ((v >> 1) & 0x55555555);
+	v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+	v = (v + (v >> 4)) & 0x0f0f0f0f;
+	return (v * 0x01010101) >> 24;
+}
+
+/** Number of valid bits in a bitmap block
+ *
+ * @param sbi           Pointer to the superblock info structure.
+ * @param bid           Type of the bitmap (inode or zone).
+ * @param block         Index of the bitmap block.
+ *
+ * @return              Number of bits of the block which describe
+ *                      existing inodes or zones.
+ */
+static unsigned
+bmap_block_bits(struct mfs_sb_info *sbi, bmap_id_t bid, unsigned long block)
+{
+	const unsigned long bits_per_block = sbi->block_size * 8;
+	const unsigned long nbits = MFS_BMAP_SIZE_BITS(sbi, bid);
+
+	if (nbits <= block * bits_per_block)
+		return 0;
+
+	return min(bits_per_block, nbits - block * bits_per_block);
+}
+
+/** Build the in-memory summary of a bitmap
+ *
+ * The number of free bits of each bitmap block is counted once, so
+ * that later allocations can skip full blocks and the free counts can
+ * be reported without scanning the bitmap again.
  *
  * @param inst          Pointer to the instance structure.
  * @param bid           Type of the bitmap (inode or zone).
- * @param free          Pointer to the memory location where the result
- *                      will be stores.
  *
  * @return              EOK on success or an error code.
  */
 static errno_t
-mfs_count_free_bits(struct mfs_instance *inst, bmap_id_t bid, uint32_t *free)
+mfs_bmap_load(struct mfs_instance *inst, bmap_id_t bid)
 {
 	errno_t r;
 	unsigned start_block;
 	unsigned long nblocks;
-	unsigned long nbits;
 	unsigned long block;
-	unsigned long free_bits = 0;
-	bitchunk_t chunk;
-	size_t const bitchunk_bits = sizeof(bitchunk_t) * 8;
+	uint32_t free_bits = 0;
 	block_t *b;
 	struct mfs_sb_info *sbi = inst->sbi;
+	struct mfs_bmap_summary *bmap = &sbi->bmap[bid];
+	const unsigned chunk_bits = sizeof(bitchunk_t) * 8;
+
+	if (bmap->valid)
+		return EOK;
 
 	start_block = MFS_BMAP_START_BLOCK(sbi, bid);
 	nblocks = MFS_BMAP_SIZE_BLOCKS(sbi, bid);
-	nbits = MFS_BMAP_SIZE_BITS(sbi, bid);
+
+	uint32_t *nfree = malloc(nblocks * sizeof(uint32_t));
+	if (!nfree)
+		return ENOMEM;
 
 	for (block = 0; block < nblocks; ++block) {
+		unsigned nbits = bmap_block_bits(sbi, bid, block);
+
+		nfree[block] = 0;
+		if (nbits == 0)
+			continue;
+
 		r = block_get(&b, inst->service_id, block + start_block,
 		    BLOCK_FLAGS_NONE);
-		if (r != EOK)
+		if (r != EOK) {
+			free(nfree);
 			return r;
+		}
 
-		size_t i;
+		/* Count the zero bits a whole chunk at a time */
 		bitchunk_t *data = (bitchunk_t *) b->data;
-
-		/*
-		 * Read the bitmap block, chunk per chunk,
-		 * counting the zero bits.
-		 */
-		for (i = 0; i < sbi->block_size / sizeof(bitchunk_t); ++i) {
-			chunk = conv32(sbi->native, data[i]);
-
-			size_t bit;
-			for (bit = 0; bit < bitchunk_bits && nbits > 0;
-			    ++bit, --nbits) {
-				if (!(chunk & (1 << bit)))
-					free_bits++;
-			}
-
-			if (nbits == 0)
-				break;
+		unsigned i;
+		for (i = 0; i * chunk_bits < nbits; ++i) {
+			nfree[block] += chunk_count_free(
+			    conv32(sbi->native, data[i]),
+			    min(chunk_bits, nbits - i * chunk_bits));
 		}
 
+		free_bits += nfree[block];
+
 		r = block_put(b);
-		if (r != EOK)
+		if (r != EOK) {
+			free(nfree);
 			return r;
+		}
 	}
 
-	*free = free_bits;
-	assert(nbits == 0);
+	free(bmap->nfree);
+	bmap->nfree = nfree;
+	bmap->total_free = free_bits;
+	bmap->valid = true;
+
+	return EOK;
+}
+
+/** Count the number of free bits in a bitmap
+ *
+ * @param inst          Pointer to the instance structure.
+ * @param bid           Type of the bitmap (inode or zone).
+ * @param free          Pointer to the memory location where the result
+ *                      will be stores.
+ *
+ * @return              EOK on success or an error code.
+ */
+static errno_t
+mfs_count_free_bits(struct mfs_instance *inst, bmap_id_t bid, uint32_t *free)
+{
+	errno_t r = mfs_bmap_load(inst, bid);
+	if (r != EOK)
+		return r;
 
+	*free = inst->sbi->bmap[bid].total_free;
 	return EOK;
 }
 
@@ -257,24 +349,38 @@ mfs_free_bit(struct mfs_instance *inst, uint32_t idx, bmap_id_t bid)
 		}
 	}
 
+	r = mfs_bmap_load(inst, bid);
+	if (r != EOK)
+		goto out_err;
+
 	/* Compute the bitmap block */
-	uint32_t block = idx / (sbi->block_size * 8) + start_block;
+	const uint32_t bits_per_block = sbi->block_size * 8;
+	const uint32_t bmap_block = idx / bits_per_block;
 
-	r = block_get(&b, inst->service_id, block, BLOCK_FLAGS_NONE);
+	r = block_get(&b, inst->service_id, bmap_block + start_block,
+	    BLOCK_FLAGS_NONE);
 	if (r != EOK)
 		goto out_err;
 
 	/* Compute the bit index in the block */
-	idx %= (sbi->block_size * 8);
+	const uint32_t bit = idx % bits_per_block;
 	bitchunk_t *ptr = b->data;
 	bitchunk_t chunk;
 	const size_t chunk_bits = sizeof(bitchunk_t) * 8;
 
-	chunk = conv32(sbi->native, ptr[idx / chunk_bits]);
-	chunk &= ~(1 << (idx % chunk_bits));
-	ptr[idx / chunk_bits] = conv32(sbi->native, chunk);
+	chunk = conv32(sbi->native, ptr[bit / chunk_bits]);
+	if (chunk & (1 << (bit % chunk_bits))) {
+		chunk &= ~(1 << (bit % chunk_bits));
+		ptr[bit / chunk_bits] = conv32(sbi->native, chunk);
+		b->dirty = true;
+
+		/* Bits beyond the bitmap size are not accounted for */
+		if (bit < bmap_block_bits(sbi, bid, bmap_block)) {
+			sbi->bmap[bid].nfree[bmap_block]++;
+			sbi->bmap[bid].total_free++;
+		}
+	}
 
-	b->dirty = true;
 	r = block_put(b);
 
 	if (*search > idx)
@@ -285,6 +391,9 @@ out_err:
 }
 
 /**Search a free bit in a bitmap and mark it as used.
+ *
+ * Bitmap blocks without any free bit are skipped using the in-memory
+ * summary of the bitmap, without being read.
  *
  * @param inst		Pointer to the filesystem instance.
  * @param idx		Pointer of a 32 bit number where the index
@@ -298,17 +407,18 @@ static errno_t
 mfs_alloc_bit(struct mfs_instance *inst, uint32_t *idx, bmap_id_t bid)
 {
 	struct mfs_sb_info *sbi;
-	uint32_t limit;
+	struct mfs_bmap_summary *bmap;
 	unsigned long nblocks;
-	unsigned *search, i, start_block;
+	unsigned *search, start_block;
+	unsigned long i, first;
 	unsigned bits_per_block;
 	errno_t r;
 	int freebit;
 
 	sbi = inst->sbi;
+	bmap = &sbi->bmap[bid];
 
 	start_block = MFS_BMAP_START_BLOCK(sbi, bid);
-	limit = MFS_BMAP_SIZE_BITS(sbi, bid);
 	nblocks = MFS_BMAP_SIZE_BLOCKS(sbi, bid);
 
 	if (bid == BMAP_ZONE) {
@@ -319,88 +429,105 @@ mfs_alloc_bit(struct mfs_instance *inst, uint32_t *idx, bmap_id_t bid)
 	}
 	bits_per_block = sbi->block_size * 8;
 
-	block_t *b;
+	r = mfs_bmap_load(inst, bid);
+	if (r != EOK)
+		return r;
 
-retry:
+	if (bmap->total_free == 0 || nblocks == 0)
+		return ENOSPC;
 
-	for (i = *search / bits_per_block; i < nblocks; ++i) {
-		r = block_get(&b, inst->service_id, i + start_block,
-		    BLOCK_FLAGS_NONE);
+	block_t *b;
 
-		if (r != EOK)
-			goto out;
+	/*
+	 * Visit the blocks starting with the one containing the search
+	 * hint. That block is visited again at the end, in case its
+	 * free bits precede the hint.
+	 */
+	first = (*search / bits_per_block) % nblocks;
 
-		unsigned tmp = *search % bits_per_block;
+	for (i = 0; i <= nblocks; ++i) {
+		unsigned long block = (first + i) % nblocks;
+		unsigned tmp = (i == 0) ? *search % bits_per_block : 0;
 
-		freebit = find_free_bit_and_set(b->data, sbi->block_size,
-		    sbi->native, tmp);
-		if (freebit == -1) {
+		if (bmap->nfree[block] == 0) {
 			/* No free bit in this block */
-			r = block_put(b);
-			if (r != EOK)
-				goto out;
 			continue;
 		}
 
-		/* Free bit found in this block, compute the real index */
-		*idx = freebit + bits_per_block * i;
-		if (*idx > limit) {
-			/* Index is beyond the limit, it is invalid */
+		r = block_get(&b, inst->service_id, block + start_block,
+		    BLOCK_FLAGS_NONE);
+		if (r != EOK)
+			return r;
+
+		freebit = find_free_bit_and_set(b->data,
+		    bmap_block_bits(sbi, bid, block), sbi->native, tmp);
+		if (freebit == -1) {
+			/* No free bit after the hint */
 			r = block_put(b);
 			if (r != EOK)
-				goto out;
-			break;
+				return r;
+			continue;
 		}
 
+		/* Free bit found in this block, compute the real index */
+		*idx = freebit + bits_per_block * block;
 		*search = *idx;
-		b->dirty = true;
-		r = block_put(b);
-		goto out;
-	}
+		bmap->nfree[block]--;
+		bmap->total_free--;
 
-	if (*search > 0) {
-		/* Repeat the search from the first bitmap block */
-		*search = 0;
-		goto retry;
+		b->dirty = true;
+		return block_put(b);
 	}
 
-	/* Free bit not found, return error */
-	return ENOSPC;
-
-out:
-	return r;
+	/* The summary does not match the bitmap */
+	return EIO;
 }
 
+/** Find a zero bit in a bitmap block and set it
+ *
+ * The bitmap is searched a whole chunk at a time.
+ *
+ * @param b             Bitmap block data.
+ * @param nbits         Number of valid bits in the block.
+ * @param native        Whether the bitmap is in the host byte order.
+ * @param start_bit     Index of the first bit to consider.
+ *
+ * @return              Index of the bit that was set or -1 if there
+ *                      is no zero bit.
+ */
 static int
-find_free_bit_and_set(bitchunk_t *b, const int bsize,
+find_free_bit_and_set(bitchunk_t *b, unsigned nbits,
     const bool native, unsigned start_bit)
 {
-	int r = -1;
-	unsigned i, j;
-	bitchunk_t chunk;
-	const size_t chunk_bits = sizeof(bitchunk_t) * 8;
+	unsigned i;
+	const unsigned chunk_bits = sizeof(bitchunk_t) * 8;
+
+	for (i = start_bit / chunk_bits; i * chunk_bits < nbits; ++i) {
+		bitchunk_t chunk = conv32(native, b[i]);
+		uint32_t free_mask = ~chunk;
 
-	for (i = start_bit / chunk_bits;
-	    i < bsize / sizeof(bitchunk_t); ++i) {
+		/* Ignore the bits preceding the start bit */
+		if (i == start_bit / chunk_bits) {
+			free_mask &= ~BIT_RRANGE(uint32_t,
+			    start_bit % chunk_bits);
+		}
 
-		if (!(~b[i])) {
+		if (free_mask == 0) {
 			/* No free bit in this chunk */
 			continue;
 		}
 
-		chunk = conv32(native, b[i]);
+		/* Index of the lowest free bit */
+		unsigned j = fnzb32(free_mask & -free_mask);
+		if (i * chunk_bits + j >= nbits)
+			break;
 
-		for (j = 0; j < chunk_bits; ++j) {
-			if (!(chunk & (1 << j))) {
-				r = i * chunk_bits + j;
-				chunk |= 1 << j;
-				b[i] = conv32(native, chunk);
-				goto found;
-			}
-		}
+		chunk |= BIT_V(bitchunk_t, j);
+		b[i] = conv32(native, chunk);
+		return i * chunk_bits + j;
 	}
-found:
-	return r;
+
+	return -1;
 }
 
 /**
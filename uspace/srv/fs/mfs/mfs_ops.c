@@ -43,6 +43,7 @@ static bool check_magic_number(uint16_t magic, bool *native,
 static errno_t mfs_node_core_get(fs_node_t **rfn, struct mfs_instance *inst,
     fs_index_t index);
 static errno_t mfs_node_put(fs_node_t *fsnode);
+static void mfs_node_evict(struct mfs_node *mnode);
 static errno_t mfs_node_open(fs_node_t *fsnode);
 static fs_index_t mfs_index_get(fs_node_t *fsnode);
 static unsigned mfs_lnkcnt_get(fs_node_t *fsnode);
@@ -70,6 +71,17 @@ static errno_t mfs_free_block_count(service_id_t service_id, uint64_t *count);
 static hash_table_t open_nodes;
 static FIBRIL_MUTEX_INITIALIZE(open_nodes_lock);
 
+/*
+ * Nodes which are not referenced anymore stay in the open nodes hash
+ * table, so that opening them again does not need to read the inode
+ * from the device. At most MFS_NODE_CACHE_SIZE such nodes are kept on
+ * the unused_nodes list, the least recently used is freed first.
+ */
+#define MFS_NODE_CACHE_SIZE	128
+
+static LIST_INITIALIZE(unused_nodes);
+static unsigned unused_nodes_cnt = 0;
+
 libfs_ops_t mfs_libfs_ops = {
 	.size_get = mfs_size_get,
 	.root_get = mfs_root_get,
@@ -208,8 +220,13 @@ static errno_t mfs_read_sb(service_id_t service_id, struct mfs_sb_info **rsbi)
 	sbi->magic = magic;
 	sbi->isearch = 0;
 	sbi->zsearch = 0;
-	sbi->nfree_zones_valid = false;
-	sbi->nfree_zones = 0;
+	fibril_mutex_initialize(&sbi->bmap_lock);
+
+	for (unsigned i = 0; i < MFS_BMAP_COUNT; ++i) {
+		sbi->bmap[i].valid = false;
+		sbi->bmap[i].nfree = NULL;
+		sbi->bmap[i].total_free = 0;
+	}
 
 	if (version == MFS_VERSION_V3) {
 		sbi->ninodes = conv32(native, sb3->s_ninodes);
@@ -378,11 +395,22 @@ mfs_unmounted(service_id_t service_id)
 	if (inst->open_nodes_cnt != 0)
 		return EBUSY;
 
+	/* Drop the cached nodes of this instance */
+	fibril_mutex_lock(&open_nodes_lock);
+	list_foreach_safe(unused_nodes, cur, next) {
+		struct mfs_node *mnode = list_get_instance(cur,
+		    struct mfs_node, unused_link);
+		if (mnode->instance == inst)
+			mfs_node_evict(mnode);
+	}
+	fibril_mutex_unlock(&open_nodes_lock);
+
 	(void) block_cache_fini(service_id);
 	block_fini(service_id);
 
 	/* Remove and destroy the instance */
 	(void) fs_instance_destroy(service_id);
+	mfs_bmap_fini(inst->sbi);
 	free(inst->sbi);
 	free(inst);
 	return EOK;
@@ -458,11 +486,27 @@ mfs_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 	mnode->ino_i = ino_i;
 	mnode->instance = inst;
 	mnode->refcnt = 1;
+	fibril_rwlock_initialize(&mnode->lock);
 
 	fibril_mutex_lock(&open_nodes_lock);
+
+	/* A cached node may still describe the inode before it was freed */
+	node_key_t key = {
+		.service_id = inst->service_id,
+		.index = inum
+	};
+
+	ht_link_t *stale = hash_table_find(&open_nodes, &key);
+	if (stale) {
+		struct mfs_node *stale_node = hash_table_get_inst(stale,
+		    struct mfs_node, link);
+		assert(stale_node->refcnt == 0);
+		mfs_node_evict(stale_node);
+	}
+
 	hash_table_insert(&open_nodes, &mnode->link);
-	fibril_mutex_unlock(&open_nodes_lock);
 	inst->open_nodes_cnt++;
+	fibril_mutex_unlock(&open_nodes_lock);
 
 	mnode->ino_i->dirty = true;
 
@@ -496,11 +540,15 @@ mfs_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 	struct mfs_sb_info *sbi = mnode->instance->sbi;
 	const size_t comp_size = str_size(component);
 
+	fibril_rwlock_read_lock(&mnode->lock);
+
 	unsigned i;
 	for (i = 0; i < mnode->ino_i->i_size / sbi->dirsize; ++i) {
 		r = mfs_read_dentry(mnode, &d_info, i);
-		if (r != EOK)
+		if (r != EOK) {
+			fibril_rwlock_read_unlock(&mnode->lock);
 			return r;
+		}
 
 		if (!d_info.d_inum) {
 			/* This entry is not used */
@@ -519,14 +567,20 @@ mfs_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 	}
 	*rfn = NULL;
 found:
+	fibril_rwlock_read_unlock(&mnode->lock);
 	return EOK;
 }
 
 static aoff64_t
 mfs_size_get(fs_node_t *node)
 {
-	const struct mfs_node *mnode = node->data;
-	return mnode->ino_i->i_size;
+	struct mfs_node *mnode = node->data;
+	aoff64_t size;
+
+	fibril_rwlock_read_lock(&mnode->lock);
+	size = mnode->ino_i->i_size;
+	fibril_rwlock_read_unlock(&mnode->lock);
+	return size;
 }
 
 static errno_t
@@ -543,6 +597,26 @@ mfs_node_get(fs_node_t **rfn, service_id_t service_id,
 	return mfs_node_core_get(rfn, instance, index);
 }
 
+/** Free a cached node which is not in use.
+ *
+ * The caller must hold open_nodes_lock.
+ *
+ * @param mnode		Node to free.
+ */
+static void
+mfs_node_evict(struct mfs_node *mnode)
+{
+	assert(mnode->refcnt == 0);
+
+	list_remove(&mnode->unused_link);
+	unused_nodes_cnt--;
+	hash_table_remove_item(&open_nodes, &mnode->link);
+
+	free(mnode->ino_i);
+	free(mnode->fsnode);
+	free(mnode);
+}
+
 static errno_t
 mfs_node_put(fs_node_t *fsnode)
 {
@@ -554,13 +628,25 @@ mfs_node_put(fs_node_t *fsnode)
 	assert(mnode->refcnt > 0);
 	mnode->refcnt--;
 	if (mnode->refcnt == 0) {
-		hash_table_remove_item(&open_nodes, &mnode->link);
 		assert(mnode->instance->open_nodes_cnt > 0);
 		mnode->instance->open_nodes_cnt--;
 		rc = mfs_put_inode(mnode);
-		free(mnode->ino_i);
-		free(mnode);
-		free(fsnode);
+		if (rc != EOK) {
+			/* Do not keep a node that differs from the disk */
+			hash_table_remove_item(&open_nodes, &mnode->link);
+			free(mnode->ino_i);
+			free(mnode);
+			free(fsnode);
+		} else {
+			list_append(&mnode->unused_link, &unused_nodes);
+			unused_nodes_cnt++;
+
+			if (unused_nodes_cnt > MFS_NODE_CACHE_SIZE) {
+				mfs_node_evict(list_get_instance(
+				    list_first(&unused_nodes),
+				    struct mfs_node, unused_link));
+			}
+		}
 	}
 
 	fibril_mutex_unlock(&open_nodes_lock);
@@ -621,6 +707,13 @@ mfs_node_core_get(fs_node_t **rfn, struct mfs_instance *inst,
 	if (already_open) {
 		mnode = hash_table_get_inst(already_open, struct mfs_node, link);
 
+		if (mnode->refcnt == 0) {
+			/* Reuse the cached node */
+			list_remove(&mnode->unused_link);
+			unused_nodes_cnt--;
+			inst->open_nodes_cnt++;
+		}
+
 		*rfn = mnode->fsnode;
 		mnode->refcnt++;
 
@@ -651,6 +744,7 @@ mfs_node_core_get(fs_node_t **rfn, struct mfs_instance *inst,
 	ino_i->index = index;
 	mnode->ino_i = ino_i;
 	mnode->refcnt = 1;
+	fibril_rwlock_initialize(&mnode->lock);
 
 	mnode->instance = inst;
 	node->data = mnode;
@@ -694,17 +788,40 @@ mfs_root_get(fs_node_t **rfn, service_id_t service_id)
 	return rc;
 }
 
+/** Lock a directory and a node linked in it for writing.
+ *
+ * The directory is always locked first.
+ *
+ * @param parent	Directory node.
+ * @param child		Node linked in the directory.
+ */
+static void
+mfs_node_pair_lock(struct mfs_node *parent, struct mfs_node *child)
+{
+	fibril_rwlock_write_lock(&parent->lock);
+	if (child != parent)
+		fibril_rwlock_write_lock(&child->lock);
+}
+
+/** Unlock nodes locked by mfs_node_pair_lock().
+ *
+ * @param parent	Directory node.
+ * @param child		Node linked in the directory.
+ */
+static void
+mfs_node_pair_unlock(struct mfs_node *parent, struct mfs_node *child)
+{
+	if (child != parent)
+		fibril_rwlock_write_unlock(&child->lock);
+	fibril_rwlock_write_unlock(&parent->lock);
+}
+
 static errno_t
-mfs_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+mfs_link_core(struct mfs_node *parent, struct mfs_node *child,
+    const char *name)
 {
-	struct mfs_node *parent = pfn->data;
-	struct mfs_node *child = cfn->data;
-	struct mfs_sb_info *sbi = parent->instance->sbi;
 	bool destroy_dentry = false;
 
-	if (str_size(name) > sbi->max_name_len)
-		return ENAMETOOLONG;
-
 	errno_t r = mfs_insert_dentry(parent, name, child->ino_i->index);
 	if (r != EOK)
 		return r;
@@ -746,15 +863,29 @@ exit:
 }
 
 static errno_t
-mfs_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+mfs_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 {
 	struct mfs_node *parent = pfn->data;
 	struct mfs_node *child = cfn->data;
-	bool has_children;
+	struct mfs_sb_info *sbi = parent->instance->sbi;
 	errno_t r;
 
-	if (!parent)
-		return EBUSY;
+	if (str_size(name) > sbi->max_name_len)
+		return ENAMETOOLONG;
+
+	mfs_node_pair_lock(parent, child);
+	r = mfs_link_core(parent, child, name);
+	mfs_node_pair_unlock(parent, child);
+	return r;
+}
+
+static errno_t
+mfs_unlink_core(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	struct mfs_node *parent = pfn->data;
+	struct mfs_node *child = cfn->data;
+	bool has_children;
+	errno_t r;
 
 	r = mfs_has_children(&has_children, cfn);
 	if (r != EOK)
@@ -787,6 +918,23 @@ mfs_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 	return r;
 }
 
+static errno_t
+mfs_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	struct mfs_node *parent = pfn->data;
+	struct mfs_node *child = cfn->data;
+	errno_t r;
+
+	if (!parent)
+		return EBUSY;
+
+	mfs_node_pair_lock(parent, child);
+	r = mfs_unlink_core(pfn, cfn, name);
+	mfs_node_pair_unlock(parent, child);
+	return r;
+}
+
+/* The caller holds the node lock or VFS keeps the namespace locked */
 static errno_t
 mfs_has_children(bool *has_children, fs_node_t *fsnode)
 {
@@ -841,7 +989,9 @@ mfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	mnode = fn->data;
 	ino_i = mnode->ino_i;
 
-	if (!async_data_read_receive(&call, &len)) {
+	fibril_rwlock_read_lock(&mnode->lock);
+
+	if (!libfs_data_read_receive(&call, &len)) {
 		rc = EINVAL;
 		goto out_error;
 	}
@@ -867,11 +1017,12 @@ mfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 			}
 		}
 
+		fibril_rwlock_read_unlock(&mnode->lock);
 		rc = mfs_node_put(fn);
-		async_answer_0(&call, rc != EOK ? rc : ENOENT);
+		libfs_data_read_refuse(&call, rc != EOK ? rc : ENOENT);
 		return rc;
 	found:
-		async_data_read_finalize(&call, d_info.d_name,
+		libfs_data_read_finalize(&call, d_info.d_name,
 		    str_size(d_info.d_name) + 1);
 		bytes = ((pos - spos) + 1);
 	} else {
@@ -880,7 +1031,7 @@ mfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		if (pos >= (size_t) ino_i->i_size) {
 			/* Trying to read beyond the end of file */
 			bytes = 0;
-			(void) async_data_read_finalize(&call, NULL, 0);
+			(void) libfs_data_read_finalize(&call, NULL, 0);
 			goto out_success;
 		}
 
@@ -902,7 +1053,7 @@ mfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 				goto out_error;
 			}
 			memset(buf, 0, sizeof(sbi->block_size));
-			async_data_read_finalize(&call,
+			libfs_data_read_finalize(&call,
 			    buf + pos % sbi->block_size, bytes);
 			free(buf);
 			goto out_success;
@@ -912,22 +1063,25 @@ mfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		if (rc != EOK)
 			goto out_error;
 
-		async_data_read_finalize(&call, b->data +
+		libfs_data_read_finalize(&call, b->data +
 		    pos % sbi->block_size, bytes);
 
 		rc = block_put(b);
 		if (rc != EOK) {
+			fibril_rwlock_read_unlock(&mnode->lock);
 			mfs_node_put(fn);
 			return rc;
 		}
 	}
 out_success:
+	fibril_rwlock_read_unlock(&mnode->lock);
 	rc = mfs_node_put(fn);
 	*rbytes = bytes;
 	return rc;
 out_error:
+	fibril_rwlock_read_unlock(&mnode->lock);
 	tmp = mfs_node_put(fn);
-	async_answer_0(&call, tmp != EOK ? tmp : rc);
+	libfs_data_read_refuse(&call, tmp != EOK ? tmp : rc);
 	return tmp != EOK ? tmp : rc;
 }
 
@@ -945,15 +1099,17 @@ mfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	if (!fn)
 		return ENOENT;
 
+	struct mfs_node *mnode = fn->data;
 	ipc_call_t call;
 	size_t len;
 
+	fibril_rwlock_write_lock(&mnode->lock);
+
 	if (!async_data_write_receive(&call, &len)) {
 		r = EINVAL;
 		goto out_err;
 	}
 
-	struct mfs_node *mnode = fn->data;
 	struct mfs_sb_info *sbi = mnode->instance->sbi;
 	struct mfs_ino_info *ino_i = mnode->ino_i;
 	const size_t bs = sbi->block_size;
@@ -996,6 +1152,7 @@ mfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
 
 	r = block_put(b);
 	if (r != EOK) {
+		fibril_rwlock_write_unlock(&mnode->lock);
 		mfs_node_put(fn);
 		return r;
 	}
@@ -1004,12 +1161,14 @@ mfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		ino_i->i_size = pos + bytes;
 		ino_i->dirty = true;
 	}
-	r = mfs_node_put(fn);
 	*nsize = ino_i->i_size;
 	*wbytes = bytes;
+	fibril_rwlock_write_unlock(&mnode->lock);
+	r = mfs_node_put(fn);
 	return r;
 
 out_err:
+	fibril_rwlock_write_unlock(&mnode->lock);
 	mfs_node_put(fn);
 	async_answer_0(&call, r);
 	return r;
@@ -1040,6 +1199,8 @@ mfs_destroy_node(fs_node_t *fn)
 
 	mfsdebug("mfs_destroy_node %d\n", mnode->ino_i->index);
 
+	fibril_rwlock_write_lock(&mnode->lock);
+
 	r = mfs_has_children(&has_children, fn);
 	if (r != EOK)
 		goto out;
@@ -1055,6 +1216,7 @@ mfs_destroy_node(fs_node_t *fn)
 	r = mfs_free_inode(mnode->instance, mnode->ino_i->index);
 
 out:
+	fibril_rwlock_write_unlock(&mnode->lock);
 	mfs_node_put(fn);
 	return r;
 }
@@ -1074,10 +1236,12 @@ mfs_truncate(service_id_t service_id, fs_index_t index, aoff64_t size)
 	struct mfs_node *mnode = fn->data;
 	struct mfs_ino_info *ino_i = mnode->ino_i;
 
+	fibril_rwlock_write_lock(&mnode->lock);
 	if (ino_i->i_size == size)
 		r = EOK;
 	else
 		r = mfs_inode_shrink(mnode, ino_i->i_size - size);
+	fibril_rwlock_write_unlock(&mnode->lock);
 
 	mfs_node_put(fn);
 	return r;
@@ -1169,7 +1333,9 @@ mfs_sync(service_id_t service_id, fs_index_t index)
 		return ENOENT;
 
 	struct mfs_node *mnode = fn->data;
+	fibril_rwlock_write_lock(&mnode->lock);
 	mnode->ino_i->dirty = true;
+	fibril_rwlock_write_unlock(&mnode->lock);
 
 	return mfs_node_put(fn);
 }
@@ -1235,24 +1401,12 @@ mfs_free_block_count(service_id_t service_id, uint64_t *count)
 	if (rc != EOK)
 		return rc;
 
-	struct mfs_sb_info *sbi = inst->sbi;
-
-	if (!sbi->nfree_zones_valid) {
-		/*
-		 * The cached number of free zones is not valid,
-		 * we need to scan the bitmap to retrieve the
-		 * current value.
-		 */
-
-		rc = mfs_count_free_zones(inst, &block_free);
-		if (rc != EOK)
-			return rc;
-
-		sbi->nfree_zones = block_free;
-		sbi->nfree_zones_valid = true;
-	}
+	/* The bitmap is scanned only the first time */
+	rc = mfs_count_free_zones(inst, &block_free);
+	if (rc != EOK)
+		return rc;
 
-	*count = sbi->nfree_zones;
+	*count = block_free;
 
 	return rc;
 }
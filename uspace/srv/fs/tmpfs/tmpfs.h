@@ -52,6 +52,8 @@ struct tmpfs_node;
 
 typedef struct tmpfs_dentry {
 	link_t link;		/**< Linkage for the list of siblings. */
+	ht_link_t dh_link;	/**< Dentries hash table link. */
+	struct tmpfs_node *parent;/**< Directory containing the dentry. */
 	struct tmpfs_node *node;/**< Back pointer to TMPFS node. */
 	char *name;		/**< Name of dentry. */
 } tmpfs_dentry_t;
@@ -63,9 +65,14 @@ typedef struct tmpfs_node {
 	ht_link_t nh_link;		/**< Nodes hash table link. */
 	tmpfs_dentry_type_t type;
 	unsigned lnkcnt;	/**< Link count. */
-	size_t size;		/**< File size if type is TMPFS_FILE. */
-	void *data;		/**< File content's if type is TMPFS_FILE. */
+	aoff64_t size;		/**< File size if type is TMPFS_FILE. */
+	/** Radix tree of file pages if type is TMPFS_FILE. */
+	void *pages;
+	unsigned height;	/**< Height of the radix tree of pages. */
 	list_t cs_list;		/**< Child's siblings list. */
+	/** Dentry last returned by readdir, NULL if not valid. */
+	tmpfs_dentry_t *cursor;
+	aoff64_t cursor_pos;	/**< Position of the cursor dentry. */
 } tmpfs_node_t;
 
 extern vfs_out_ops_t tmpfs_ops;
@@ -73,6 +80,10 @@ extern libfs_ops_t tmpfs_libfs_ops;
 
 extern bool tmpfs_init(void);
 
+extern void *tmpfs_page_find(tmpfs_node_t *, uint64_t);
+extern errno_t tmpfs_page_get(tmpfs_node_t *, uint64_t, void **);
+extern void tmpfs_pages_truncate(tmpfs_node_t *, aoff64_t);
+
 #endif
 
 /**
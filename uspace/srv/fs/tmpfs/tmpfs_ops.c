@@ -58,6 +58,9 @@
 /** Global counter for assigning node indices. Shared by all instances. */
 fs_index_t tmpfs_next_index = 1;
 
+/** Source of data read from holes in files. */
+static const uint8_t zero_page[PAGE_SIZE];
+
 /*
  * Implementation of the libfs interface.
  */
@@ -166,6 +169,8 @@ static bool nodes_key_equal(const void *key_arg, const ht_link_t *item)
 	return key->service_id == node->service_id && key->index == node->index;
 }
 
+static void tmpfs_dentry_remove(tmpfs_dentry_t *);
+
 static void nodes_remove_callback(ht_link_t *item)
 {
 	tmpfs_node_t *nodep = hash_table_get_inst(item, tmpfs_node_t, nh_link);
@@ -175,13 +180,12 @@ static void nodes_remove_callback(ht_link_t *item)
 		    list_first(&nodep->cs_list), tmpfs_dentry_t, link);
 
 		assert(nodep->type == TMPFS_DIRECTORY);
-		list_remove(&dentryp->link);
-		free(dentryp);
+		tmpfs_dentry_remove(dentryp);
 	}
 
-	if (nodep->data) {
+	if (nodep->pages) {
 		assert(nodep->type == TMPFS_FILE);
-		free(nodep->data);
+		tmpfs_pages_truncate(nodep, 0);
 	}
 	free(nodep->bp);
 	free(nodep);
@@ -196,6 +200,91 @@ hash_table_ops_t nodes_ops = {
 	.remove_callback = nodes_remove_callback
 };
 
+/** Hash table of the dentries of all TMPFS directories. */
+static hash_table_t dentries;
+
+/*
+ * Implementation of hash table interface for the dentries hash table.
+ */
+
+typedef struct {
+	tmpfs_node_t *parent;
+	const char *name;
+} dentry_key_t;
+
+static size_t dentry_name_hash(const char *name)
+{
+	size_t hash = 0;
+
+	while (*name != '\0')
+		hash = hash * 31 + (uint8_t) *name++;
+
+	return hash;
+}
+
+static size_t dentries_key_hash(const void *k)
+{
+	const dentry_key_t *key = k;
+	return hash_combine((size_t) key->parent, dentry_name_hash(key->name));
+}
+
+static size_t dentries_hash(const ht_link_t *item)
+{
+	tmpfs_dentry_t *dentryp = hash_table_get_inst(item, tmpfs_dentry_t,
+	    dh_link);
+	return hash_combine((size_t) dentryp->parent,
+	    dentry_name_hash(dentryp->name));
+}
+
+static bool dentries_key_equal(const void *key_arg, const ht_link_t *item)
+{
+	tmpfs_dentry_t *dentryp = hash_table_get_inst(item, tmpfs_dentry_t,
+	    dh_link);
+	const dentry_key_t *key = key_arg;
+
+	return key->parent == dentryp->parent &&
+	    str_cmp(key->name, dentryp->name) == 0;
+}
+
+/** TMPFS dentries hash table operations. */
+static hash_table_ops_t dentries_ops = {
+	.hash = dentries_hash,
+	.key_hash = dentries_key_hash,
+	.key_equal = dentries_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Find a dentry by its name. */
+static tmpfs_dentry_t *tmpfs_dentry_find(tmpfs_node_t *parentp,
+    const char *name)
+{
+	dentry_key_t key = {
+		.parent = parentp,
+		.name = name
+	};
+
+	ht_link_t *lnk = hash_table_find(&dentries, &key);
+	if (lnk == NULL)
+		return NULL;
+
+	return hash_table_get_inst(lnk, tmpfs_dentry_t, dh_link);
+}
+
+/** Unlink a dentry from its directory and free it. */
+static void tmpfs_dentry_remove(tmpfs_dentry_t *dentryp)
+{
+	tmpfs_node_t *parentp = dentryp->parent;
+
+	/* The positions of the following dentries change. */
+	parentp->cursor = NULL;
+
+	hash_table_remove_item(&dentries, &dentryp->dh_link);
+	list_remove(&dentryp->link);
+	free(dentryp->name);
+	free(dentryp);
+}
+
 static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 {
 	nodep->bp = NULL;
@@ -204,14 +293,18 @@ static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 	nodep->type = TMPFS_NONE;
 	nodep->lnkcnt = 0;
 	nodep->size = 0;
-	nodep->data = NULL;
+	nodep->pages = NULL;
+	nodep->height = 0;
 	list_initialize(&nodep->cs_list);
+	nodep->cursor = NULL;
+	nodep->cursor_pos = 0;
 }
 
 static void tmpfs_dentry_initialize(tmpfs_dentry_t *dentryp)
 {
 	link_initialize(&dentryp->link);
 	dentryp->name = NULL;
+	dentryp->parent = NULL;
 	dentryp->node = NULL;
 }
 
@@ -220,6 +313,11 @@ bool tmpfs_init(void)
 	if (!hash_table_create(&nodes, 0, 0, &nodes_ops))
 		return false;
 
+	if (!hash_table_create(&dentries, 0, 0, &dentries_ops)) {
+		hash_table_destroy(&nodes);
+		return false;
+	}
+
 	return true;
 }
 
@@ -253,16 +351,10 @@ static void tmpfs_instance_done(service_id_t service_id)
 
 errno_t tmpfs_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 {
-	tmpfs_node_t *parentp = TMPFS_NODE(pfn);
-
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dentryp) {
-		if (!str_cmp(dentryp->name, component)) {
-			*rfn = FS_NODE(dentryp->node);
-			return EOK;
-		}
-	}
+	tmpfs_dentry_t *dentryp = tmpfs_dentry_find(TMPFS_NODE(pfn),
+	    component);
 
-	*rfn = NULL;
+	*rfn = (dentryp != NULL) ? FS_NODE(dentryp->node) : NULL;
 	return EOK;
 }
 
@@ -362,10 +454,8 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 	assert(parentp->type == TMPFS_DIRECTORY);
 
 	/* Check for duplicit entries. */
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dp) {
-		if (!str_cmp(dp->name, nm))
-			return EEXIST;
-	}
+	if (tmpfs_dentry_find(parentp, nm) != NULL)
+		return EEXIST;
 
 	/* Allocate and initialize the dentry. */
 	dentryp = malloc(sizeof(tmpfs_dentry_t));
@@ -381,9 +471,11 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 		return ENOMEM;
 	}
 	str_cpy(dentryp->name, size + 1, nm);
+	dentryp->parent = parentp;
 	dentryp->node = childp;
 	childp->lnkcnt++;
 	list_append(&dentryp->link, &parentp->cs_list);
+	hash_table_insert(&dentries, &dentryp->dh_link);
 
 	return EOK;
 }
@@ -391,29 +483,21 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 errno_t tmpfs_unlink_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 {
 	tmpfs_node_t *parentp = TMPFS_NODE(pfn);
-	tmpfs_node_t *childp = NULL;
-	tmpfs_dentry_t *dentryp;
 
 	if (!parentp)
 		return EBUSY;
 
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dp) {
-		if (!str_cmp(dp->name, nm)) {
-			dentryp = dp;
-			childp = dentryp->node;
-			assert(FS_NODE(childp) == cfn);
-			break;
-		}
-	}
-
-	if (!childp)
+	tmpfs_dentry_t *dentryp = tmpfs_dentry_find(parentp, nm);
+	if (!dentryp)
 		return ENOENT;
 
+	tmpfs_node_t *childp = dentryp->node;
+	assert(FS_NODE(childp) == cfn);
+
 	if ((childp->lnkcnt == 1) && !list_empty(&childp->cs_list))
 		return ENOTEMPTY;
 
-	list_remove(&dentryp->link);
-	free(dentryp);
+	tmpfs_dentry_remove(dentryp);
 	childp->lnkcnt--;
 
 	return EOK;
@@ -462,6 +546,26 @@ static errno_t tmpfs_unmounted(service_id_t service_id)
 	return EOK;
 }
 
+/** Find the dentry at a readdir position.
+ *
+ * Readdir asks for consecutive positions, so continue from the dentry
+ * returned last time if possible.
+ *
+ * @param nodep Directory node.
+ * @param pos   Position of the dentry in the list of children.
+ *
+ * @return Link of the dentry or NULL if there is none at @a pos.
+ */
+static link_t *tmpfs_dentry_seek(tmpfs_node_t *nodep, aoff64_t pos)
+{
+	if (nodep->cursor != NULL && pos == nodep->cursor_pos)
+		return &nodep->cursor->link;
+	if (nodep->cursor != NULL && pos == nodep->cursor_pos + 1)
+		return list_next(&nodep->cursor->link, &nodep->cs_list);
+
+	return list_nth(&nodep->cs_list, pos);
+}
+
 static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *rbytes)
 {
@@ -484,37 +588,40 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 	 */
 	ipc_call_t call;
 	size_t size;
-	if (!async_data_read_receive(&call, &size)) {
-		async_answer_0(&call, EINVAL);
+	if (!libfs_data_read_receive(&call, &size)) {
+		libfs_data_read_refuse(&call, EINVAL);
 		return EINVAL;
 	}
 
 	size_t bytes;
 	if (nodep->type == TMPFS_FILE) {
-		bytes = min(nodep->size - pos, size);
-		(void) async_data_read_finalize(&call, nodep->data + pos,
-		    bytes);
+		/* Read at most up to the end of the page. */
+		size_t offset = pos % PAGE_SIZE;
+		bytes = 0;
+		if (pos < nodep->size)
+			bytes = min(min(nodep->size - pos, size),
+			    PAGE_SIZE - offset);
+
+		const uint8_t *page = tmpfs_page_find(nodep, pos / PAGE_SIZE);
+		(void) libfs_data_read_finalize(&call,
+		    (page != NULL) ? page + offset : zero_page, bytes);
 	} else {
 		tmpfs_dentry_t *dentryp;
 		link_t *lnk;
 
 		assert(nodep->type == TMPFS_DIRECTORY);
 
-		/*
-		 * Yes, we really use O(n) algorithm here.
-		 * If it bothers someone, it could be fixed by introducing a
-		 * hash table.
-		 */
-		lnk = list_nth(&nodep->cs_list, pos);
-
+		lnk = tmpfs_dentry_seek(nodep, pos);
 		if (lnk == NULL) {
-			async_answer_0(&call, ENOENT);
+			libfs_data_read_refuse(&call, ENOENT);
 			return ENOENT;
 		}
 
 		dentryp = list_get_instance(lnk, tmpfs_dentry_t, link);
+		nodep->cursor = dentryp;
+		nodep->cursor_pos = pos;
 
-		(void) async_data_read_finalize(&call, dentryp->name,
+		(void) libfs_data_read_finalize(&call, dentryp->name,
 		    str_size(dentryp->name) + 1);
 		bytes = 1;
 	}
@@ -523,6 +630,50 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 	return EOK;
 }
 
+static errno_t tmpfs_readdir(service_id_t service_id, fs_index_t index,
+    aoff64_t pos, void *buf, size_t size, size_t *used)
+{
+	node_key_t key = {
+		.service_id = service_id,
+		.index = index
+	};
+
+	ht_link_t *hlp = hash_table_find(&nodes, &key);
+	if (!hlp)
+		return ENOENT;
+
+	tmpfs_node_t *nodep = hash_table_get_inst(hlp, tmpfs_node_t, nh_link);
+	if (nodep->type != TMPFS_DIRECTORY)
+		return ENOTDIR;
+
+	*used = 0;
+
+	link_t *lnk = tmpfs_dentry_seek(nodep, pos);
+	while (lnk != NULL) {
+		tmpfs_dentry_t *dentryp = list_get_instance(lnk, tmpfs_dentry_t,
+		    link);
+		vfs_dirent_type_t type = (dentryp->node->type ==
+		    TMPFS_DIRECTORY) ? VFS_DIRENT_DIRECTORY : VFS_DIRENT_FILE;
+
+		if (!libfs_dirent_pack(buf, size, used, pos + 1,
+		    dentryp->node->index, type, dentryp->name,
+		    str_size(dentryp->name)))
+			break;
+
+		nodep->cursor = dentryp;
+		nodep->cursor_pos = pos;
+
+		pos++;
+		lnk = list_next(lnk, &nodep->cs_list);
+	}
+
+	/* Not even one entry fits */
+	if (*used == 0 && lnk != NULL)
+		return EOVERFLOW;
+
+	return EOK;
+}
+
 static errno_t
 tmpfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
     size_t *wbytes, aoff64_t *nsize)
@@ -553,35 +704,24 @@ tmpfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	}
 
 	/*
-	 * Check whether the file needs to grow.
-	 */
-	if (pos + size <= nodep->size) {
-		/* The file size is not changing. */
-		(void) async_data_write_finalize(&call, nodep->data + pos,
-		    size);
-		goto out;
-	}
-	size_t delta = (pos + size) - nodep->size;
-	/*
-	 * At this point, we are deliberately extremely straightforward and
-	 * simply realloc the contents of the file on every write that grows the
-	 * file. In the end, the situation might not be as bad as it may look:
-	 * our heap allocator can save us and just grow the block whenever
-	 * possible.
+	 * Write at most up to the end of the page. Any gap between the old
+	 * end of the file and the written data is either a hole or a part
+	 * of a page that is kept zeroed, so it reads as zeros.
 	 */
-	void *newdata = realloc(nodep->data, nodep->size + delta);
-	if (!newdata) {
-		async_answer_0(&call, ENOMEM);
-		size = 0;
-		goto out;
+	size_t offset = pos % PAGE_SIZE;
+	size = min(size, PAGE_SIZE - offset);
+
+	uint8_t *page;
+	errno_t rc = tmpfs_page_get(nodep, pos / PAGE_SIZE, (void **) &page);
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
+		return rc;
 	}
-	/* Clear any newly allocated memory in order to emulate gaps. */
-	memset(newdata + nodep->size, 0, delta);
-	nodep->size += delta;
-	nodep->data = newdata;
-	(void) async_data_write_finalize(&call, nodep->data + pos, size);
 
-out:
+	(void) async_data_write_finalize(&call, page + offset, size);
+	if (pos + size > nodep->size)
+		nodep->size = pos + size;
+
 	*wbytes = size;
 	*nsize = nodep->size;
 	return EOK;
@@ -603,23 +743,11 @@ static errno_t tmpfs_truncate(service_id_t service_id, fs_index_t index,
 		return ENOENT;
 	tmpfs_node_t *nodep = hash_table_get_inst(hlp, tmpfs_node_t, nh_link);
 
-	if (size == nodep->size)
-		return EOK;
-
-	if (size > SIZE_MAX)
-		return ENOMEM;
-
-	void *newdata = realloc(nodep->data, size);
-	if (!newdata && size)
-		return ENOMEM;
-
-	if (size > nodep->size) {
-		size_t delta = size - nodep->size;
-		memset(newdata + nodep->size, 0, delta);
-	}
+	/* Growing the file only adds a hole at its end. */
+	if (size < nodep->size)
+		tmpfs_pages_truncate(nodep, size);
 
 	nodep->size = size;
-	nodep->data = newdata;
 	return EOK;
 }
 
@@ -662,6 +790,7 @@ vfs_out_ops_t tmpfs_ops = {
 	.close = tmpfs_close,
 	.destroy = tmpfs_destroy,
 	.sync = tmpfs_sync,
+	.readdir = tmpfs_readdir,
 };
 
 /**
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tmpfs
+ * @{
+ */
+
+/**
+ * @file	tmpfs_pages.c
+ * @brief	Paged storage of TMPFS file contents.
+ *
+ * File contents are kept in pages hanging off a radix tree. A tree of
+ * height 0 is the only page of the file itself, each additional level
+ * multiplies the number of pages the tree can hold by TMPFS_RADIX_SLOTS.
+ * Pages that were never written to are not allocated and read as zeros.
+ *
+ * The part of any allocated page past the end of the file is kept zeroed,
+ * so that growing the file by a write or truncate at a later point exposes
+ * nothing but zeros.
+ */
+
+#include "tmpfs.h"
+#include <as.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <mem.h>
+
+#define TMPFS_RADIX_SHIFT	6
+#define TMPFS_RADIX_SLOTS	(1 << TMPFS_RADIX_SHIFT)
+
+typedef struct {
+	void *slots[TMPFS_RADIX_SLOTS];
+} tmpfs_radix_node_t;
+
+/** Number of pages a radix tree of the given height can hold. */
+static uint64_t radix_capacity(unsigned height)
+{
+	return (uint64_t) 1 << (TMPFS_RADIX_SHIFT * height);
+}
+
+/** Index of the slot of a page in a radix tree node. */
+static unsigned radix_slot(uint64_t idx, unsigned height)
+{
+	return (idx >> (TMPFS_RADIX_SHIFT * (height - 1))) &
+	    (TMPFS_RADIX_SLOTS - 1);
+}
+
+/** Find a page of a file.
+ *
+ * @param nodep		TMPFS file node
+ * @param idx		Index of the page in the file
+ *
+ * @return		The page or NULL if it is a hole
+ */
+void *tmpfs_page_find(tmpfs_node_t *nodep, uint64_t idx)
+{
+	if (idx >= radix_capacity(nodep->height))
+		return NULL;
+
+	void *slot = nodep->pages;
+	for (unsigned h = nodep->height; h > 0 && slot != NULL; h--) {
+		tmpfs_radix_node_t *rn = (tmpfs_radix_node_t *) slot;
+		slot = rn->slots[radix_slot(idx, h)];
+	}
+
+	return slot;
+}
+
+/** Get a page of a file, allocating it if it is a hole.
+ *
+ * @param nodep		TMPFS file node
+ * @param idx		Index of the page in the file
+ * @param[out] page	Place to store the page
+ *
+ * @return		EOK on success or ENOMEM
+ */
+errno_t tmpfs_page_get(tmpfs_node_t *nodep, uint64_t idx, void **page)
+{
+	/* Grow the tree until it can hold the page. */
+	while (idx >= radix_capacity(nodep->height)) {
+		if (nodep->pages != NULL) {
+			tmpfs_radix_node_t *rn =
+			    calloc(1, sizeof(tmpfs_radix_node_t));
+			if (rn == NULL)
+				return ENOMEM;
+
+			rn->slots[0] = nodep->pages;
+			nodep->pages = rn;
+		}
+		nodep->height++;
+	}
+
+	void **slot = &nodep->pages;
+	for (unsigned h = nodep->height; h > 0; h--) {
+		if (*slot == NULL) {
+			*slot = calloc(1, sizeof(tmpfs_radix_node_t));
+			if (*slot == NULL)
+				return ENOMEM;
+		}
+
+		tmpfs_radix_node_t *rn = (tmpfs_radix_node_t *) *slot;
+		slot = &rn->slots[radix_slot(idx, h)];
+	}
+
+	if (*slot == NULL) {
+		*slot = calloc(1, PAGE_SIZE);
+		if (*slot == NULL)
+			return ENOMEM;
+	}
+
+	*page = *slot;
+	return EOK;
+}
+
+/** Free the pages of a subtree starting at a given page.
+ *
+ * @param slot		Slot holding the subtree
+ * @param height	Height of the subtree
+ * @param first		Index of the first page to free, relative to the
+ *			subtree
+ */
+static void radix_free(void **slot, unsigned height, uint64_t first)
+{
+	if (*slot == NULL)
+		return;
+
+	if (height == 0) {
+		if (first == 0) {
+			free(*slot);
+			*slot = NULL;
+		}
+		return;
+	}
+
+	tmpfs_radix_node_t *rn = (tmpfs_radix_node_t *) *slot;
+	uint64_t child_capacity = radix_capacity(height - 1);
+	bool empty = true;
+
+	for (unsigned i = 0; i < TMPFS_RADIX_SLOTS; i++) {
+		uint64_t base = i * child_capacity;
+
+		if (first < base + child_capacity) {
+			radix_free(&rn->slots[i], height - 1,
+			    (first > base) ? first - base : 0);
+		}
+
+		if (rn->slots[i] != NULL)
+			empty = false;
+	}
+
+	if (empty) {
+		free(rn);
+		*slot = NULL;
+	}
+}
+
+/** Truncate the contents of a file.
+ *
+ * Frees all pages past the new end of the file and zeroes the rest of the
+ * last page. Truncating to zero frees all the pages of the file.
+ *
+ * @param nodep		TMPFS file node
+ * @param size		New size of the file, not larger than the current
+ *			one
+ */
+void tmpfs_pages_truncate(tmpfs_node_t *nodep, aoff64_t size)
+{
+	uint64_t first = size / PAGE_SIZE;
+	size_t offset = size % PAGE_SIZE;
+
+	radix_free(&nodep->pages, nodep->height,
+	    (offset != 0) ? first + 1 : first);
+
+	/* Shrink the tree while only its first slot is used. */
+	while (nodep->pages != NULL && nodep->height > 0) {
+		tmpfs_radix_node_t *rn = (tmpfs_radix_node_t *) nodep->pages;
+
+		unsigned i;
+		for (i = 1; i < TMPFS_RADIX_SLOTS; i++) {
+			if (rn->slots[i] != NULL)
+				break;
+		}
+		if (i < TMPFS_RADIX_SLOTS)
+			break;
+
+		nodep->pages = rn->slots[0];
+		nodep->height--;
+		free(rn);
+	}
+
+	if (nodep->pages == NULL)
+		nodep->height = 0;
+
+	if (offset != 0) {
+		uint8_t *page = tmpfs_page_find(nodep, first);
+		if (page != NULL)
+			memset(page + offset, 0, PAGE_SIZE - offset);
+	}
+}
+
+/**
+ * @}
+ */
@@ -61,6 +61,9 @@
 
 #define MIN_FID_LEN  38
 
+/** Readahead window of the block cache in bytes */
+#define UDF_READAHEAD_BYTES  65536
+
 #define SPACE_TABLE   0
 #define SPACE_BITMAP  1
 
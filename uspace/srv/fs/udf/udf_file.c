@@ -41,11 +41,18 @@
 #include <inttypes.h>
 #include <io/log.h>
 #include <mem.h>
+#include <macros.h>
 #include "udf.h"
 #include "udf_file.h"
 #include "udf_cksum.h"
 #include "udf_volume.h"
 
+/** Reads of at least this many bytes go to the device directly */
+#define UDF_DIRECT_READ_MIN  8192
+
+/** Largest number of bytes read from the device directly at once */
+#define UDF_DIRECT_READ_MAX  65536
+
 /** Read extended allocator in allocation sequence
  *
  * @paran node     UDF node
@@ -564,7 +571,46 @@ errno_t udf_get_fid_in_sector(udf_file_identifier_descriptor_t **fid,
 	return ENOENT;
 }
 
+/** Read a large chunk of an extent directly from the device.
+ *
+ * A single device request for the whole chunk avoids a round trip through
+ * the block cache per sector.
+ *
+ * @param call   IPC call
+ * @param node   UDF node
+ * @param offset Absolute byte offset on the device
+ * @param bytes  Number of bytes to read
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t udf_read_direct(ipc_call_t *call, udf_node_t *node,
+    aoff64_t offset, size_t bytes)
+{
+	void *buf = malloc(bytes);
+	if (buf == NULL) {
+		libfs_data_read_refuse(call, ENOMEM);
+		return ENOMEM;
+	}
+
+	errno_t rc = block_read_bytes_direct(node->instance->service_id, offset,
+	    bytes, buf);
+	if (rc != EOK) {
+		free(buf);
+		libfs_data_read_refuse(call, rc);
+		return rc;
+	}
+
+	libfs_data_read_finalize(call, buf, bytes);
+	free(buf);
+	return EOK;
+}
+
 /** Read file if it is saved in allocators.
+ *
+ * The read does not cross the end of the allocator (extent) containing
+ * @a pos. Large reads are done directly from the device, small ones go
+ * through the block cache.
  *
  * @param read_len Returned value. Length file or part file which we could read.
  * @param call     IPC call
@@ -578,8 +624,9 @@ errno_t udf_get_fid_in_sector(udf_file_identifier_descriptor_t **fid,
 errno_t udf_read_file(size_t *read_len, ipc_call_t *call, udf_node_t *node,
     aoff64_t pos, size_t len)
 {
+	size_t sector_size = node->instance->sector_size;
 	size_t i = 0;
-	size_t l = 0;
+	aoff64_t l = 0;
 
 	while (i < node->alloc_size) {
 		if (pos >= l + node->allocators[i].length) {
@@ -589,36 +636,38 @@ errno_t udf_read_file(size_t *read_len, ipc_call_t *call, udf_node_t *node,
 			break;
 	}
 
-	size_t sector_cnt = ALL_UP(l, node->instance->sector_size);
-	size_t sector_num = pos / node->instance->sector_size;
+	if (i == node->alloc_size) {
+		libfs_data_read_refuse(call, EIO);
+		return EIO;
+	}
+
+	/* Position inside of the allocator */
+	aoff64_t apos = pos - l;
+
+	len = min(len, node->allocators[i].length - apos);
+	len = min(len, node->data_size - pos);
+
+	if (len >= UDF_DIRECT_READ_MIN) {
+		aoff64_t offset =
+		    (aoff64_t) node->allocators[i].position * sector_size;
+
+		*read_len = min(len, UDF_DIRECT_READ_MAX);
+		return udf_read_direct(call, node, offset + apos, *read_len);
+	}
 
 	block_t *block = NULL;
 	errno_t rc = block_get(&block, node->instance->service_id,
-	    node->allocators[i].position + (sector_num - sector_cnt),
+	    node->allocators[i].position + apos / sector_size,
 	    BLOCK_FLAGS_NONE);
 	if (rc != EOK) {
-		async_answer_0(call, rc);
+		libfs_data_read_refuse(call, rc);
 		return rc;
 	}
 
-	size_t sector_pos = pos % node->instance->sector_size;
-
-	if (sector_pos + len < node->instance->sector_size)
-		*read_len = len;
-	else
-		*read_len = node->instance->sector_size - sector_pos;
-
-	if (ALL_UP(node->allocators[i].length, node->instance->sector_size) ==
-	    sector_num - sector_cnt + 1) {
-		if (pos + len > node->allocators[i].length + l)
-			*read_len = node->allocators[i].length -
-			    (sector_num - sector_cnt) * node->instance->sector_size -
-			    sector_pos;
-		else
-			*read_len = len;
-	}
+	size_t sector_pos = apos % sector_size;
+	*read_len = min(len, sector_size - sector_pos);
 
-	async_data_read_finalize(call, block->data + sector_pos, *read_len);
+	libfs_data_read_finalize(call, block->data + sector_pos, *read_len);
 	return block_put(block);
 }
 
@@ -382,6 +382,10 @@ static errno_t udf_mounted(service_id_t service_id, const char *opts,
 		return rc;
 	}
 
+	/* Optical media seek slowly, read further ahead */
+	(void) block_cache_set_readahead(service_id,
+	    UDF_READAHEAD_BYTES / instance->sector_size);
+
 	/* Read Volume Descriptor Sequence */
 	rc = udf_read_volume_descriptor_sequence(service_id, avd.main_extent);
 	if (rc != EOK) {
@@ -462,8 +466,8 @@ static errno_t udf_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 
 	ipc_call_t call;
 	size_t len = 0;
-	if (!async_data_read_receive(&call, &len)) {
-		async_answer_0(&call, EINVAL);
+	if (!libfs_data_read_receive(&call, &len)) {
+		libfs_data_read_refuse(&call, EINVAL);
 		udf_node_put(rfn);
 		return EINVAL;
 	}
@@ -471,7 +475,7 @@ static errno_t udf_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	if (node->type == NODE_FILE) {
 		if (pos >= node->data_size) {
 			*rbytes = 0;
-			async_data_read_finalize(&call, NULL, 0);
+			libfs_data_read_finalize(&call, NULL, 0);
 			udf_node_put(rfn);
 			return EOK;
 		}
@@ -482,7 +486,8 @@ static errno_t udf_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		else {
 			/* File in allocation descriptors area */
 			read_len = (len < node->data_size) ? len : node->data_size;
-			async_data_read_finalize(&call, node->data + pos, read_len);
+			libfs_data_read_finalize(&call, node->data + pos,
+			    read_len);
 			rc = EOK;
 		}
 
@@ -501,7 +506,8 @@ static errno_t udf_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 			    (char *) fid->implementation_use + FLE16(fid->length_iu),
 			    fid->length_file_id, &node->instance->charset);
 
-			async_data_read_finalize(&call, name, str_size(name) + 1);
+			libfs_data_read_finalize(&call, name,
+			    str_size(name) + 1);
 			*rbytes = 1;
 			free(name);
 			udf_node_put(rfn);
@@ -513,7 +519,7 @@ static errno_t udf_read(service_id_t service_id, fs_index_t index, aoff64_t pos,
 		} else {
 			*rbytes = 0;
 			udf_node_put(rfn);
-			async_answer_0(&call, ENOENT);
+			libfs_data_read_refuse(&call, ENOENT);
 			return ENOENT;
 		}
 	}
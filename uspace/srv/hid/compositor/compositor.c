@@ -45,16 +45,19 @@
 #include <align.h>
 #include <as.h>
 #include <stdlib.h>
+#include <mem.h>
 
 #include <refcount.h>
 #include <fibril_synch.h>
 #include <adt/prodcons.h>
 #include <adt/list.h>
+#include <time.h>
 #include <io/input.h>
 #include <ipc/graph.h>
 #include <ipc/window.h>
 
 #include <async.h>
+#include <async_ring.h>
 #include <loc.h>
 #include <task.h>
 
@@ -98,6 +101,12 @@ typedef struct {
 	service_id_t in_dsid;
 	service_id_t out_dsid;
 	prodcons_t queue;
+	/** Client callback session for the event ring */
+	async_sess_t *ev_sess;
+	/** Shared-memory event ring, NULL if events are fetched by IPC */
+	async_ring_t *ev_ring;
+	/** Window has been closed, stop passing events to the ring */
+	bool closed;
 	transform_t transform;
 	double dx;
 	double dy;
@@ -106,6 +115,13 @@ typedef struct {
 	double angle;
 	uint8_t opacity;
 	surface_t *surface;
+	/** Surface rendered with the transformation of the window */
+	surface_t *cache;
+	/** Transformation the cache was rendered with */
+	transform_t cache_transform;
+	/** Position of the cache at the time it was rendered */
+	sysarg_t cache_x;
+	sysarg_t cache_y;
 } window_t;
 
 static service_id_t winreg_id;
@@ -149,6 +165,31 @@ static LIST_INITIALIZE(viewport_list);
 
 static FIBRIL_MUTEX_INITIALIZE(discovery_mtx);
 
+/** Maximum number of rectangles kept in the damaged region */
+#define DAMAGE_RECTS_MAX  16
+
+/** Minimum time between two frames (usec) */
+#define FRAME_PERIOD  16667
+
+typedef struct {
+	sysarg_t x;
+	sysarg_t y;
+	sysarg_t w;
+	sysarg_t h;
+} damage_rect_t;
+
+/** Damaged region to be painted in the next frame */
+typedef struct {
+	damage_rect_t rects[DAMAGE_RECTS_MAX];
+	size_t count;
+} damage_t;
+
+static FIBRIL_MUTEX_INITIALIZE(damage_mtx);
+static damage_t damage;
+static fibril_timer_t *frame_timer;
+static bool frame_pending = false;
+static struct timespec frame_last;
+
 /** Input server proxy */
 static input_t *input;
 static bool active = false;
@@ -156,8 +197,9 @@ static bool active = false;
 static errno_t comp_active(input_t *);
 static errno_t comp_deactive(input_t *);
 static errno_t comp_key_press(input_t *, kbd_event_type_t, keycode_t, keymod_t, wchar_t);
-static errno_t comp_mouse_move(input_t *, int, int);
+static errno_t comp_mouse_move(input_t *, int, int, usec_t);
 static errno_t comp_abs_move(input_t *, unsigned, unsigned, unsigned, unsigned);
+static errno_t comp_pointer_move(input_t *, int, int);
 static errno_t comp_mouse_button(input_t *, int, int);
 
 static input_ev_ops_t input_ev_ops = {
@@ -226,6 +268,9 @@ static window_t *window_create(void)
 	/* One initial reference will be for being in the window list */
 	refcount_init(&win->ref_cnt);
 	prodcons_initialize(&win->queue);
+	win->ev_sess = NULL;
+	win->ev_ring = NULL;
+	win->closed = false;
 	transform_identity(&win->transform);
 	transform_translate(&win->transform, coord_origin, coord_origin);
 	win->dx = coord_origin;
@@ -235,6 +280,7 @@ static window_t *window_create(void)
 	win->angle = 0;
 	win->opacity = 255;
 	win->surface = NULL;
+	win->cache = NULL;
 
 	return win;
 }
@@ -256,6 +302,9 @@ static void window_destroy(window_t *win)
 	if (win->surface)
 		surface_destroy(win->surface);
 
+	if (win->cache)
+		surface_destroy(win->cache);
+
 	free(win);
 }
 
@@ -385,208 +434,501 @@ static void comp_restrict_pointers(void)
 	fibril_mutex_unlock(&pointer_list_mtx);
 }
 
-static void comp_damage(sysarg_t x_dmg_glob, sysarg_t y_dmg_glob,
-    sysarg_t w_dmg_glob, sysarg_t h_dmg_glob)
+/** Determine whether rectangle @a outer contains rectangle @a inner. */
+static bool damage_rect_contains(damage_rect_t *outer, damage_rect_t *inner)
 {
-	fibril_mutex_lock(&viewport_list_mtx);
-	fibril_mutex_lock(&window_list_mtx);
-	fibril_mutex_lock(&pointer_list_mtx);
+	return (inner->x >= outer->x) && (inner->y >= outer->y) &&
+	    (inner->x + inner->w <= outer->x + outer->w) &&
+	    (inner->y + inner->h <= outer->y + outer->h);
+}
 
-	list_foreach(viewport_list, link, viewport_t, vp) {
-		/* Determine what part of the viewport must be updated. */
-		sysarg_t x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp;
-		surface_get_resolution(vp->surface, &w_dmg_vp, &h_dmg_vp);
-		bool isec_vp = rectangle_intersect(
-		    x_dmg_glob, y_dmg_glob, w_dmg_glob, h_dmg_glob,
-		    vp->pos.x, vp->pos.y, w_dmg_vp, h_dmg_vp,
-		    &x_dmg_vp, &y_dmg_vp, &w_dmg_vp, &h_dmg_vp);
-
-		if (isec_vp) {
-
-			/* Paint background color. */
-			for (sysarg_t y = y_dmg_vp - vp->pos.y; y <  y_dmg_vp - vp->pos.y + h_dmg_vp; ++y) {
-				pixel_t *dst = pixelmap_pixel_at(
-				    surface_pixmap_access(vp->surface), x_dmg_vp - vp->pos.x, y);
-				sysarg_t count = w_dmg_vp;
-				while (count-- != 0) {
-					*dst++ = bg_color;
-				}
+static uint64_t damage_rect_area(damage_rect_t *rect)
+{
+	return (uint64_t) rect->w * rect->h;
+}
+
+static void damage_rect_union(damage_rect_t *a, damage_rect_t *b,
+    damage_rect_t *out)
+{
+	rectangle_union(a->x, a->y, a->w, a->h, b->x, b->y, b->w, b->h,
+	    &out->x, &out->y, &out->w, &out->h);
+}
+
+/** Add rectangle to the damaged region.
+ *
+ * Rectangles are merged whenever their bounding rectangle is not larger
+ * than the two of them together, so that overlapping damage is painted
+ * only once. When the region is full, the rectangle is merged with the one
+ * whose bounding rectangle grows least.
+ *
+ * The caller must hold damage_mtx.
+ */
+static void damage_add(damage_rect_t *rect)
+{
+	damage_rect_t cur = *rect;
+	damage_rect_t u;
+	size_t i;
+
+	i = 0;
+	while (i < damage.count) {
+		damage_rect_t *r = &damage.rects[i];
+
+		if (damage_rect_contains(r, &cur))
+			return;
+
+		damage_rect_union(r, &cur, &u);
+		if (damage_rect_contains(&cur, r) ||
+		    damage_rect_area(&u) - damage_rect_area(r) <=
+		    damage_rect_area(&cur)) {
+			/* Merge and try again with the others */
+			cur = u;
+			damage.rects[i] = damage.rects[--damage.count];
+			i = 0;
+			continue;
+		}
+
+		++i;
+	}
+
+	if (damage.count == DAMAGE_RECTS_MAX) {
+		size_t best = 0;
+		uint64_t best_cost = UINT64_MAX;
+
+		for (i = 0; i < damage.count; i++) {
+			damage_rect_union(&damage.rects[i], &cur, &u);
+			uint64_t cost = damage_rect_area(&u) -
+			    damage_rect_area(&damage.rects[i]);
+			if (cost < best_cost) {
+				best = i;
+				best_cost = cost;
 			}
-			surface_add_damaged_region(vp->surface,
-			    x_dmg_vp - vp->pos.x, y_dmg_vp - vp->pos.y, w_dmg_vp, h_dmg_vp);
+		}
+
+		damage_rect_union(&damage.rects[best], &cur, &u);
+		damage.rects[best] = damage.rects[--damage.count];
+		damage_add(&u);
+		return;
+	}
+
+	damage.rects[damage.count++] = cur;
+}
 
-			transform_t transform;
-			source_t source;
-			drawctx_t context;
+/** Determine whether window is drawn by copying its pixels.
+ *
+ * This is the case for windows whose client promised an opaque surface,
+ * that are not faded and whose transformation is a translation by whole
+ * pixels. Such windows also hide everything behind them.
+ */
+static bool comp_window_is_opaque(window_t *win)
+{
+	const double (*m)[TRANSFORM_MATRIX_DIM] = win->transform.matrix;
+
+	if ((win->surface == NULL) || ((win->flags & WINDOW_OPAQUE) == 0) ||
+	    (win->opacity != 255))
+		return false;
 
-			source_init(&source);
-			source_set_filter(&source, filter);
-			drawctx_init(&context, vp->surface);
-			drawctx_set_compose(&context, compose_over);
-			drawctx_set_source(&context, &source);
+	return (m[0][0] == 1) && (m[0][1] == 0) && (m[1][0] == 0) &&
+	    (m[1][1] == 1) && (m[0][2] == (native_t) m[0][2]) &&
+	    (m[1][2] == (native_t) m[1][2]);
+}
 
-			/* For each window. */
-			for (link_t *link = window_list.head.prev;
-			    link != &window_list.head; link = link->prev) {
+/** Get window bounding rectangle in global coordinates. */
+static void comp_window_bounds(window_t *win, damage_rect_t *rect)
+{
+	sysarg_t width, height;
+
+	surface_get_resolution(win->surface, &width, &height);
+	comp_coord_bounding_rect(0, 0, width, height, win->transform,
+	    &rect->x, &rect->y, &rect->w, &rect->h);
+}
+
+/** Determine whether the transformed window cache can be painted.
+ *
+ * This is the case as long as the window has only been moved by whole
+ * pixels since the cache was rendered.
+ */
+static bool comp_window_cache_valid(window_t *win)
+{
+	double (*m)[TRANSFORM_MATRIX_DIM] = win->transform.matrix;
+	double (*c)[TRANSFORM_MATRIX_DIM] = win->cache_transform.matrix;
+
+	if (win->cache == NULL)
+		return false;
+
+	double shift_x = m[0][2] - c[0][2];
+	double shift_y = m[1][2] - c[1][2];
+
+	return (m[0][0] == c[0][0]) && (m[0][1] == c[0][1]) &&
+	    (m[1][0] == c[1][0]) && (m[1][1] == c[1][1]) &&
+	    (shift_x == (native_t) shift_x) && (shift_y == (native_t) shift_y);
+}
+
+static void comp_window_cache_drop(window_t *win)
+{
+	if (win->cache != NULL) {
+		surface_destroy(win->cache);
+		win->cache = NULL;
+	}
+}
+
+/** Render the window with its transformation into the cache.
+ *
+ * Windows that are scaled or rotated would otherwise be resampled
+ * whenever they are painted. Windows that are only translated need no
+ * cache.
+ */
+static void comp_window_cache_update(window_t *win)
+{
+	if ((win->surface == NULL) ||
+	    (transform_classify(&win->transform) <= TRANSFORM_TRANSLATION)) {
+		comp_window_cache_drop(win);
+		return;
+	}
+
+	if (comp_window_cache_valid(win))
+		return;
+
+	comp_window_cache_drop(win);
+
+	damage_rect_t bnd;
+	comp_window_bounds(win, &bnd);
+
+	surface_t *cache = surface_create(bnd.w, bnd.h, NULL,
+	    SURFACE_FLAG_NONE);
+	if (cache == NULL)
+		return;
+
+	transform_t transform = win->transform;
+	transform_translate(&transform, -(double) bnd.x, -(double) bnd.y);
+
+	source_t source;
+	drawctx_t context;
+
+	source_init(&source);
+	source_set_filter(&source, filter);
+	source_set_transform(&source, transform);
+	source_set_texture(&source, win->surface,
+	    PIXELMAP_EXTEND_TRANSPARENT_SIDES);
+
+	drawctx_init(&context, cache);
+	drawctx_set_compose(&context, compose_src);
+	drawctx_set_source(&context, &source);
+	drawctx_transfer(&context, 0, 0, bnd.w, bnd.h);
+
+	win->cache = cache;
+	win->cache_transform = win->transform;
+	win->cache_x = bnd.x;
+	win->cache_y = bnd.y;
+}
+
+/** Copy part of an opaque window to the viewport.
+ *
+ * @param vp   Viewport
+ * @param win  Opaque window
+ * @param bnd  Window bounding rectangle
+ * @param rect Part of the window to copy in global coordinates
+ */
+static void comp_window_blit(viewport_t *vp, window_t *win,
+    damage_rect_t *bnd, damage_rect_t *rect)
+{
+	pixelmap_t *src_map = surface_pixmap_access(win->surface);
+	pixelmap_t *dst_map = surface_pixmap_access(vp->surface);
+
+	for (sysarg_t y = 0; y < rect->h; ++y) {
+		pixel_t *src = pixelmap_pixel_at(src_map, rect->x - bnd->x,
+		    rect->y - bnd->y + y);
+		pixel_t *dst = pixelmap_pixel_at(dst_map, rect->x - vp->pos.x,
+		    rect->y - vp->pos.y + y);
+		memcpy(dst, src, rect->w * sizeof(pixel_t));
+	}
+}
+
+/** Determine whether an opaque window in front of @a link hides @a rect.
+ *
+ * @param link Window list link of the window whose part is to be painted
+ * @param rect Part of the window in global coordinates
+ */
+static bool comp_window_occluded(link_t *link, damage_rect_t *rect)
+{
+	damage_rect_t bnd;
+
+	for (link = link->prev; link != &window_list.head; link = link->prev) {
+		window_t *win = list_get_instance(link, window_t, link);
+		if (!comp_window_is_opaque(win))
+			continue;
+
+		comp_window_bounds(win, &bnd);
+		if (damage_rect_contains(&bnd, rect))
+			return true;
+	}
+
+	return false;
+}
+
+/** Composite damaged rectangle of a viewport.
+ *
+ * Windows are examined front to back first to find an opaque window
+ * covering the whole rectangle, so that the windows behind it and the
+ * background need not be painted at all.
+ *
+ * @param vp  Viewport
+ * @param dmg Damaged rectangle in global coordinates, within the viewport
+ */
+static void comp_paint_rect(viewport_t *vp, damage_rect_t *dmg)
+{
+	sysarg_t x_dmg_vp = dmg->x;
+	sysarg_t y_dmg_vp = dmg->y;
+	sysarg_t w_dmg_vp = dmg->w;
+	sysarg_t h_dmg_vp = dmg->h;
+	damage_rect_t bnd;
+	damage_rect_t part;
+	link_t *bottom = window_list.head.prev;
+	bool covered = false;
+
+	/* Find the frontmost opaque window covering the whole rectangle. */
+	list_foreach(window_list, link, window_t, win) {
+		if (!comp_window_is_opaque(win))
+			continue;
+
+		comp_window_bounds(win, &bnd);
+		if (damage_rect_contains(&bnd, dmg)) {
+			bottom = &win->link;
+			covered = true;
+			break;
+		}
+	}
+
+	if (!covered) {
+		/* Paint background color. */
+		for (sysarg_t y = y_dmg_vp - vp->pos.y;
+		    y < y_dmg_vp - vp->pos.y + h_dmg_vp; ++y) {
+			pixel_t *dst = pixelmap_pixel_at(
+			    surface_pixmap_access(vp->surface),
+			    x_dmg_vp - vp->pos.x, y);
+			sysarg_t count = w_dmg_vp;
+			while (count-- != 0) {
+				*dst++ = bg_color;
+			}
+		}
+	}
+	surface_add_damaged_region(vp->surface,
+	    x_dmg_vp - vp->pos.x, y_dmg_vp - vp->pos.y, w_dmg_vp, h_dmg_vp);
 
+	transform_t transform;
+	source_t source;
+	drawctx_t context;
+
+	source_init(&source);
+	source_set_filter(&source, filter);
+	drawctx_init(&context, vp->surface);
+	drawctx_set_compose(&context, compose_over);
+	drawctx_set_source(&context, &source);
+
+	/* For each window, back to front, starting with the covering one. */
+	for (link_t *link = bottom;
+	    link != &window_list.head; link = link->prev) {
+
+		/*
+		 * Determine what part of the window intersects with the
+		 * updated area of the current viewport.
+		 */
+		window_t *win = list_get_instance(link, window_t, link);
+		if (!win->surface) {
+			continue;
+		}
+		comp_window_bounds(win, &bnd);
+		bool isec_win = rectangle_intersect(
+		    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
+		    bnd.x, bnd.y, bnd.w, bnd.h,
+		    &part.x, &part.y, &part.w, &part.h);
+
+		if (!isec_win || comp_window_occluded(link, &part))
+			continue;
+
+		if (comp_window_is_opaque(win)) {
+			comp_window_blit(vp, win, &bnd, &part);
+			continue;
+		}
+
+		/*
+		 * Prepare conversion from global coordinates to viewport
+		 * coordinates.
+		 */
+		double_point_t pos;
+		pos.x = vp->pos.x;
+		pos.y = vp->pos.y;
+
+		if (comp_window_cache_valid(win)) {
+			/* Only move the cache by the window shift. */
+			double_point_t shift;
+			shift.x = win->transform.matrix[0][2] -
+			    win->cache_transform.matrix[0][2];
+			shift.y = win->transform.matrix[1][2] -
+			    win->cache_transform.matrix[1][2];
+
+			transform_identity(&transform);
+			transform_translate(&transform,
+			    win->cache_x + shift.x - pos.x,
+			    win->cache_y + shift.y - pos.y);
+			source_set_texture(&source, win->cache,
+			    PIXELMAP_EXTEND_TRANSPARENT_BLACK);
+		} else {
+			transform = win->transform;
+			transform_translate(&transform, -pos.x, -pos.y);
+			source_set_texture(&source, win->surface,
+			    PIXELMAP_EXTEND_TRANSPARENT_SIDES);
+		}
+
+		source_set_transform(&source, transform);
+		source_set_alpha(&source, PIXEL(win->opacity, 0, 0, 0));
+
+		drawctx_transfer(&context,
+		    part.x - vp->pos.x, part.y - vp->pos.y, part.w, part.h);
+	}
+
+	list_foreach(pointer_list, link, pointer_t, ptr) {
+		if (ptr->ghost.surface) {
+
+			sysarg_t x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost;
+			sysarg_t x_dmg_ghost, y_dmg_ghost, w_dmg_ghost, h_dmg_ghost;
+			surface_get_resolution(ptr->ghost.surface, &w_bnd_ghost, &h_bnd_ghost);
+			comp_coord_bounding_rect(0, 0, w_bnd_ghost, h_bnd_ghost, ptr->ghost.transform,
+			    &x_bnd_ghost, &y_bnd_ghost, &w_bnd_ghost, &h_bnd_ghost);
+			bool isec_ghost = rectangle_intersect(
+			    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
+			    x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost,
+			    &x_dmg_ghost, &y_dmg_ghost, &w_dmg_ghost, &h_dmg_ghost);
+
+			if (isec_ghost) {
 				/*
-				 * Determine what part of the window intersects with the
-				 * updated area of the current viewport.
+				 * FIXME: Ghost is currently drawn based on the bounding
+				 * rectangle of the window, which is sufficient as long
+				 * as the windows can be rotated only by 90 degrees.
+				 * For ghost to be compatible with arbitrary-angle
+				 * rotation, it should be drawn as four lines adjusted
+				 * by the transformation matrix. That would however
+				 * require to equip libdraw with line drawing functionality.
 				 */
-				window_t *win = list_get_instance(link, window_t, link);
-				if (!win->surface) {
-					continue;
+
+				transform_t transform = ptr->ghost.transform;
+				double_point_t pos;
+				pos.x = vp->pos.x;
+				pos.y = vp->pos.y;
+				transform_translate(&transform, -pos.x, -pos.y);
+
+				pixel_t ghost_color;
+
+				if (y_bnd_ghost == y_dmg_ghost) {
+					for (sysarg_t x = x_dmg_ghost - vp->pos.x;
+					    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
+						ghost_color = surface_get_pixel(vp->surface,
+						    x, y_dmg_ghost - vp->pos.y);
+						surface_put_pixel(vp->surface,
+						    x, y_dmg_ghost - vp->pos.y, INVERT(ghost_color));
+					}
 				}
-				sysarg_t x_dmg_win, y_dmg_win, w_dmg_win, h_dmg_win;
-				surface_get_resolution(win->surface, &w_dmg_win, &h_dmg_win);
-				comp_coord_bounding_rect(0, 0, w_dmg_win, h_dmg_win, win->transform,
-				    &x_dmg_win, &y_dmg_win, &w_dmg_win, &h_dmg_win);
-				bool isec_win = rectangle_intersect(
-				    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
-				    x_dmg_win, y_dmg_win, w_dmg_win, h_dmg_win,
-				    &x_dmg_win, &y_dmg_win, &w_dmg_win, &h_dmg_win);
-
-				if (isec_win) {
-					/*
-					 * Prepare conversion from global coordinates to viewport
-					 * coordinates.
-					 */
-					transform = win->transform;
-					double_point_t pos;
-					pos.x = vp->pos.x;
-					pos.y = vp->pos.y;
-					transform_translate(&transform, -pos.x, -pos.y);
-
-					source_set_transform(&source, transform);
-					source_set_texture(&source, win->surface,
-					    PIXELMAP_EXTEND_TRANSPARENT_SIDES);
-					source_set_alpha(&source, PIXEL(win->opacity, 0, 0, 0));
-
-					drawctx_transfer(&context,
-					    x_dmg_win - vp->pos.x, y_dmg_win - vp->pos.y, w_dmg_win, h_dmg_win);
+
+				if (y_bnd_ghost + h_bnd_ghost == y_dmg_ghost + h_dmg_ghost) {
+					for (sysarg_t x = x_dmg_ghost - vp->pos.x;
+					    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
+						ghost_color = surface_get_pixel(vp->surface,
+						    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1);
+						surface_put_pixel(vp->surface,
+						    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1, INVERT(ghost_color));
+					}
 				}
-			}
 
-			list_foreach(pointer_list, link, pointer_t, ptr) {
-				if (ptr->ghost.surface) {
-
-					sysarg_t x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost;
-					sysarg_t x_dmg_ghost, y_dmg_ghost, w_dmg_ghost, h_dmg_ghost;
-					surface_get_resolution(ptr->ghost.surface, &w_bnd_ghost, &h_bnd_ghost);
-					comp_coord_bounding_rect(0, 0, w_bnd_ghost, h_bnd_ghost, ptr->ghost.transform,
-					    &x_bnd_ghost, &y_bnd_ghost, &w_bnd_ghost, &h_bnd_ghost);
-					bool isec_ghost = rectangle_intersect(
-					    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
-					    x_bnd_ghost, y_bnd_ghost, w_bnd_ghost, h_bnd_ghost,
-					    &x_dmg_ghost, &y_dmg_ghost, &w_dmg_ghost, &h_dmg_ghost);
-
-					if (isec_ghost) {
-						/*
-						 * FIXME: Ghost is currently drawn based on the bounding
-						 * rectangle of the window, which is sufficient as long
-						 * as the windows can be rotated only by 90 degrees.
-						 * For ghost to be compatible with arbitrary-angle
-						 * rotation, it should be drawn as four lines adjusted
-						 * by the transformation matrix. That would however
-						 * require to equip libdraw with line drawing functionality.
-						 */
-
-						transform_t transform = ptr->ghost.transform;
-						double_point_t pos;
-						pos.x = vp->pos.x;
-						pos.y = vp->pos.y;
-						transform_translate(&transform, -pos.x, -pos.y);
-
-						pixel_t ghost_color;
-
-						if (y_bnd_ghost == y_dmg_ghost) {
-							for (sysarg_t x = x_dmg_ghost - vp->pos.x;
-							    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y);
-								surface_put_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y, INVERT(ghost_color));
-							}
-						}
-
-						if (y_bnd_ghost + h_bnd_ghost == y_dmg_ghost + h_dmg_ghost) {
-							for (sysarg_t x = x_dmg_ghost - vp->pos.x;
-							    x < x_dmg_ghost - vp->pos.x + w_dmg_ghost; ++x) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1);
-								surface_put_pixel(vp->surface,
-								    x, y_dmg_ghost - vp->pos.y + h_dmg_ghost - 1, INVERT(ghost_color));
-							}
-						}
-
-						if (x_bnd_ghost == x_dmg_ghost) {
-							for (sysarg_t y = y_dmg_ghost - vp->pos.y;
-							    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x, y);
-								surface_put_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x, y, INVERT(ghost_color));
-							}
-						}
-
-						if (x_bnd_ghost + w_bnd_ghost == x_dmg_ghost + w_dmg_ghost) {
-							for (sysarg_t y = y_dmg_ghost - vp->pos.y;
-							    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
-								ghost_color = surface_get_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y);
-								surface_put_pixel(vp->surface,
-								    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y, INVERT(ghost_color));
-							}
-						}
+				if (x_bnd_ghost == x_dmg_ghost) {
+					for (sysarg_t y = y_dmg_ghost - vp->pos.y;
+					    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
+						ghost_color = surface_get_pixel(vp->surface,
+						    x_dmg_ghost - vp->pos.x, y);
+						surface_put_pixel(vp->surface,
+						    x_dmg_ghost - vp->pos.x, y, INVERT(ghost_color));
 					}
+				}
 
+				if (x_bnd_ghost + w_bnd_ghost == x_dmg_ghost + w_dmg_ghost) {
+					for (sysarg_t y = y_dmg_ghost - vp->pos.y;
+					    y < y_dmg_ghost - vp->pos.y + h_dmg_ghost; ++y) {
+						ghost_color = surface_get_pixel(vp->surface,
+						    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y);
+						surface_put_pixel(vp->surface,
+						    x_dmg_ghost - vp->pos.x + w_dmg_ghost - 1, y, INVERT(ghost_color));
+					}
 				}
 			}
 
-			list_foreach(pointer_list, link, pointer_t, ptr) {
+		}
+	}
 
-				/*
-				 * Determine what part of the pointer intersects with the
-				 * updated area of the current viewport.
-				 */
-				sysarg_t x_dmg_ptr, y_dmg_ptr, w_dmg_ptr, h_dmg_ptr;
-				surface_t *sf_ptr = ptr->cursor.states[ptr->state];
-				surface_get_resolution(sf_ptr, &w_dmg_ptr, &h_dmg_ptr);
-				bool isec_ptr = rectangle_intersect(
-				    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
-				    ptr->pos.x, ptr->pos.y, w_dmg_ptr, h_dmg_ptr,
-				    &x_dmg_ptr, &y_dmg_ptr, &w_dmg_ptr, &h_dmg_ptr);
-
-				if (isec_ptr) {
-					/*
-					 * Pointer is currently painted directly by copying pixels.
-					 * However, it is possible to draw the pointer similarly
-					 * as window by using drawctx_transfer. It would allow
-					 * more sophisticated control over drawing, but would also
-					 * cost more regarding the performance.
-					 */
-
-					sysarg_t x_vp = x_dmg_ptr - vp->pos.x;
-					sysarg_t y_vp = y_dmg_ptr - vp->pos.y;
-					sysarg_t x_ptr = x_dmg_ptr - ptr->pos.x;
-					sysarg_t y_ptr = y_dmg_ptr - ptr->pos.y;
-
-					for (sysarg_t y = 0; y < h_dmg_ptr; ++y) {
-						pixel_t *src = pixelmap_pixel_at(
-						    surface_pixmap_access(sf_ptr), x_ptr, y_ptr + y);
-						pixel_t *dst = pixelmap_pixel_at(
-						    surface_pixmap_access(vp->surface), x_vp, y_vp + y);
-						sysarg_t count = w_dmg_ptr;
-						while (count-- != 0) {
-							*dst = (*src & 0xff000000) ? *src : *dst;
-							++dst;
-							++src;
-						}
-					}
-					surface_add_damaged_region(vp->surface, x_vp, y_vp, w_dmg_ptr, h_dmg_ptr);
-				}
+	list_foreach(pointer_list, link, pointer_t, ptr) {
 
+		/*
+		 * Determine what part of the pointer intersects with the
+		 * updated area of the current viewport.
+		 */
+		sysarg_t x_dmg_ptr, y_dmg_ptr, w_dmg_ptr, h_dmg_ptr;
+		surface_t *sf_ptr = ptr->cursor.states[ptr->state];
+		surface_get_resolution(sf_ptr, &w_dmg_ptr, &h_dmg_ptr);
+		bool isec_ptr = rectangle_intersect(
+		    x_dmg_vp, y_dmg_vp, w_dmg_vp, h_dmg_vp,
+		    ptr->pos.x, ptr->pos.y, w_dmg_ptr, h_dmg_ptr,
+		    &x_dmg_ptr, &y_dmg_ptr, &w_dmg_ptr, &h_dmg_ptr);
+
+		if (isec_ptr) {
+			/*
+			 * Pointer is currently painted directly by copying pixels.
+			 * However, it is possible to draw the pointer similarly
+			 * as window by using drawctx_transfer. It would allow
+			 * more sophisticated control over drawing, but would also
+			 * cost more regarding the performance.
+			 */
+
+			sysarg_t x_vp = x_dmg_ptr - vp->pos.x;
+			sysarg_t y_vp = y_dmg_ptr - vp->pos.y;
+			sysarg_t x_ptr = x_dmg_ptr - ptr->pos.x;
+			sysarg_t y_ptr = y_dmg_ptr - ptr->pos.y;
+
+			for (sysarg_t y = 0; y < h_dmg_ptr; ++y) {
+				pixel_t *src = pixelmap_pixel_at(
+				    surface_pixmap_access(sf_ptr), x_ptr, y_ptr + y);
+				pixel_t *dst = pixelmap_pixel_at(
+				    surface_pixmap_access(vp->surface), x_vp, y_vp + y);
+				sysarg_t count = w_dmg_ptr;
+				while (count-- != 0) {
+					*dst = (*src & 0xff000000) ? *src : *dst;
+					++dst;
+					++src;
+				}
 			}
+			surface_add_damaged_region(vp->surface, x_vp, y_vp, w_dmg_ptr, h_dmg_ptr);
+		}
+
+	}
+}
+
+/** Composite the damaged region and pass it to the visualizers. */
+static void comp_paint(damage_t *dmg)
+{
+	fibril_mutex_lock(&viewport_list_mtx);
+	fibril_mutex_lock(&window_list_mtx);
+	fibril_mutex_lock(&pointer_list_mtx);
+
+	list_foreach(viewport_list, link, viewport_t, vp) {
+		sysarg_t width, height;
+		surface_get_resolution(vp->surface, &width, &height);
+
+		for (size_t i = 0; i < dmg->count; ++i) {
+			/* Determine what part of the viewport must be updated. */
+			damage_rect_t *r = &dmg->rects[i];
+			damage_rect_t rect;
+			bool isec_vp = rectangle_intersect(
+			    r->x, r->y, r->w, r->h, vp->pos.x, vp->pos.y, width, height,
+			    &rect.x, &rect.y, &rect.w, &rect.h);
+
+			if (isec_vp)
+				comp_paint_rect(vp, &rect);
 		}
 	}
 
@@ -607,6 +949,66 @@ static void comp_damage(sysarg_t x_dmg_glob, sysarg_t y_dmg_glob,
 	fibril_mutex_unlock(&viewport_list_mtx);
 }
 
+/** Paint the damage accumulated since the previous frame. */
+static void comp_frame(void *arg)
+{
+	damage_t dmg;
+
+	fibril_mutex_lock(&damage_mtx);
+	dmg = damage;
+	damage.count = 0;
+	frame_pending = false;
+	getuptime(&frame_last);
+	fibril_mutex_unlock(&damage_mtx);
+
+	comp_paint(&dmg);
+}
+
+/** Mark rectangle in global coordinates as damaged.
+ *
+ * The damage is only recorded here. All damage reported within one frame
+ * period is painted at once when the frame timer fires.
+ */
+static void comp_damage(sysarg_t x_dmg_glob, sysarg_t y_dmg_glob,
+    sysarg_t w_dmg_glob, sysarg_t h_dmg_glob)
+{
+	const sysarg_t coord_max = ~((sysarg_t) 0);
+	damage_rect_t rect;
+	struct timespec now;
+	usec_t delay;
+
+	/* Clip the rectangle so that its right and bottom edges fit. */
+	rect.x = x_dmg_glob;
+	rect.y = y_dmg_glob;
+	rect.w = (w_dmg_glob > coord_max - x_dmg_glob) ?
+	    coord_max - x_dmg_glob : w_dmg_glob;
+	rect.h = (h_dmg_glob > coord_max - y_dmg_glob) ?
+	    coord_max - y_dmg_glob : h_dmg_glob;
+
+	if ((rect.w == 0) || (rect.h == 0))
+		return;
+
+	fibril_mutex_lock(&damage_mtx);
+
+	damage_add(&rect);
+
+	if (!frame_pending) {
+		frame_pending = true;
+
+		getuptime(&now);
+		delay = FRAME_PERIOD -
+		    NSEC2USEC(ts_sub_diff(&now, &frame_last));
+		if (delay < 1)
+			delay = 1;
+		else if (delay > FRAME_PERIOD)
+			delay = FRAME_PERIOD;
+
+		fibril_timer_set_locked(frame_timer, delay, comp_frame, NULL);
+	}
+
+	fibril_mutex_unlock(&damage_mtx);
+}
+
 static void comp_window_get_event(window_t *win, ipc_call_t *icall)
 {
 	window_event_t *event = (window_event_t *) prodcons_consume(&win->queue);
@@ -631,6 +1033,70 @@ static void comp_window_get_event(window_t *win, ipc_call_t *icall)
 	free(event);
 }
 
+/** Pass window events to the client through the event ring.
+ *
+ * Runs in a dedicated fibril, so that a slow client only ever blocks this
+ * fibril. Events keep being queued in the meantime.
+ */
+static errno_t comp_window_event_sender(void *arg)
+{
+	window_t *win = (window_t *) arg;
+
+	while (true) {
+		window_event_t *event =
+		    (window_event_t *) prodcons_consume(&win->queue);
+		if (win->closed) {
+			free(event);
+			break;
+		}
+
+		errno_t rc = async_ring_write(win->ev_ring, event,
+		    sizeof(window_event_t));
+		free(event);
+		if (rc != EOK)
+			break;
+	}
+
+	async_ring_destroy(win->ev_ring);
+	win->ev_ring = NULL;
+	async_hangup(win->ev_sess);
+	win->ev_sess = NULL;
+
+	window_destroy(win);
+	return EOK;
+}
+
+static void comp_window_event_ring(window_t *win, ipc_call_t *icall)
+{
+	if (win->ev_sess == NULL || win->ev_ring != NULL) {
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	/* Leave room for the ring record headers */
+	errno_t rc = async_ring_create(win->ev_sess, WINDOW_EVENT_RING,
+	    WINDOW_EVENT_RING_EVENTS * (sizeof(window_event_t) + 8),
+	    &win->ev_ring);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	fid_t fid = fibril_create(comp_window_event_sender, win);
+	if (fid == 0) {
+		async_ring_destroy(win->ev_ring);
+		win->ev_ring = NULL;
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	/* The sender fibril holds a reference to the window */
+	refcount_up(&win->ref_cnt);
+	fibril_add_ready(fid);
+
+	async_answer_0(icall, EOK);
+}
+
 static void comp_window_damage(window_t *win, ipc_call_t *icall)
 {
 	double x = ipc_get_arg1(icall);
@@ -638,10 +1104,15 @@ static void comp_window_damage(window_t *win, ipc_call_t *icall)
 	double width = ipc_get_arg3(icall);
 	double height = ipc_get_arg4(icall);
 
+	fibril_mutex_lock(&window_list_mtx);
+
+	/* The window contents changed, so the cache is stale. */
+	comp_window_cache_drop(win);
+
 	if ((width == 0) || (height == 0)) {
+		fibril_mutex_unlock(&window_list_mtx);
 		comp_damage(0, 0, UINT32_MAX, UINT32_MAX);
 	} else {
-		fibril_mutex_lock(&window_list_mtx);
 		sysarg_t x_dmg_glob, y_dmg_glob, w_dmg_glob, h_dmg_glob;
 		comp_coord_bounding_rect(x - 1, y - 1, width + 2, height + 2,
 		    win->transform, &x_dmg_glob, &y_dmg_glob, &w_dmg_glob, &h_dmg_glob);
@@ -758,6 +1229,7 @@ static void comp_window_resize(window_t *win, ipc_call_t *icall)
 	}
 
 	win->surface = new_surface;
+	comp_window_cache_drop(win);
 
 	sysarg_t new_width = 0;
 	sysarg_t new_height = 0;
@@ -877,7 +1349,9 @@ static void comp_window_close(window_t *win, ipc_call_t *icall)
 	/*
 	 * In case the client was killed, input fibril of the window might be
 	 * still blocked on the condition within comp_window_get_event.
+	 * Likewise the event ring sender fibril.
 	 */
+	win->closed = true;
 	window_event_t *event_dummy = (window_event_t *) malloc(sizeof(window_event_t));
 	if (event_dummy) {
 		link_initialize(&event_dummy->link);
@@ -1014,15 +1488,38 @@ static void client_connection(ipc_call_t *icall, void *arg)
 			async_get_call(&call);
 
 			if (!ipc_get_imethod(&call)) {
+				/* Otherwise the sender fibril hangs up */
+				if (win->ev_sess != NULL &&
+				    win->ev_ring == NULL) {
+					async_hangup(win->ev_sess);
+					win->ev_sess = NULL;
+				}
+
 				async_answer_0(&call, EOK);
 				window_destroy(win);
 				return;
 			}
 
+			async_sess_t *sess = async_callback_receive_start(
+			    EXCHANGE_SERIALIZE, &call);
+			if (sess != NULL) {
+				if (win->ev_sess == NULL) {
+					win->ev_sess = sess;
+					async_answer_0(&call, EOK);
+				} else {
+					async_hangup(sess);
+					async_answer_0(&call, ELIMIT);
+				}
+				continue;
+			}
+
 			switch (ipc_get_imethod(&call)) {
 			case WINDOW_GET_EVENT:
 				comp_window_get_event(win, &call);
 				break;
+			case WINDOW_EVENT_RING:
+				comp_window_event_ring(win, &call);
+				break;
 			default:
 				async_answer_0(&call, EINVAL);
 			}
@@ -1387,6 +1884,15 @@ static void comp_window_animate(pointer_t *pointer, window_t *win,
 	comp_recalc_transform(win);
 	comp_coord_bounding_rect(0, 0, width, height, win->transform,
 	    &x2, &y2, &width2, &height2);
+
+	/*
+	 * While the window is only being dragged, the transformed surface
+	 * stays the same and is merely moved.
+	 */
+	if (move && !scale && !resize)
+		comp_window_cache_update(win);
+	else
+		comp_window_cache_drop(win);
 	rectangle_union(x1, y1, width1, height1, x2, y2, width2, height2,
 	    dmg_x, dmg_y, dmg_width, dmg_height);
 }
@@ -1547,10 +2053,15 @@ static errno_t comp_abs_move(input_t *input, unsigned x, unsigned y,
 	delta.y = (vp_pos.y + pos_in_viewport.y) - pointer->pos.y;
 	fibril_mutex_unlock(&pointer_list_mtx);
 
-	return comp_mouse_move(input, delta.x, delta.y);
+	return comp_pointer_move(input, delta.x, delta.y);
+}
+
+static errno_t comp_mouse_move(input_t *input, int dx, int dy, usec_t time)
+{
+	return comp_pointer_move(input, dx, dy);
 }
 
-static errno_t comp_mouse_move(input_t *input, int dx, int dy)
+static errno_t comp_pointer_move(input_t *input, int dx, int dy)
 {
 	pointer_t *pointer = input_pointer(input);
 
@@ -2283,6 +2794,13 @@ static errno_t compositor_srv_init(char *input_svc, char *name)
 	/* Color of the viewport background. Must be opaque. */
 	bg_color = PIXEL(255, 69, 51, 103);
 
+	/* Damage is painted in frames driven by this timer. */
+	frame_timer = fibril_timer_create(&damage_mtx);
+	if (frame_timer == NULL) {
+		printf("%s: Unable to create frame timer\n", NAME);
+		return ENOMEM;
+	}
+
 	/* Register compositor server. */
 	async_set_fallback_port_handler(client_connection, NULL);
 
@@ -32,6 +32,7 @@
 /** @file
  */
 
+#include <assert.h>
 #include <async.h>
 #include <stdio.h>
 #include <adt/prodcons.h>
@@ -59,6 +60,9 @@
 
 #define UTF8_CHAR_BUFFER_SIZE  (STR_BOUNDS(1) + 1)
 
+/** Period of coalescing deferred screen updates (us) */
+#define UPDATE_PERIOD  20000
+
 typedef struct {
 	atomic_flag refcnt;      /**< Connection reference count */
 	prodcons_t input_pc;  /**< Incoming keyboard events */
@@ -71,6 +75,9 @@ typedef struct {
 
 	fibril_mutex_t mtx;  /**< Lock protecting mutable fields */
 
+	fibril_timer_t *update_timer;  /**< Timer of deferred updates */
+	bool update_pending;           /**< Deferred update is scheduled */
+
 	size_t index;           /**< Console index */
 	service_id_t dsid;      /**< Service handle */
 
@@ -105,7 +112,7 @@ static console_t *active_console = &consoles[0];
 static errno_t input_ev_active(input_t *);
 static errno_t input_ev_deactive(input_t *);
 static errno_t input_ev_key(input_t *, kbd_event_type_t, keycode_t, keymod_t, wchar_t);
-static errno_t input_ev_move(input_t *, int, int);
+static errno_t input_ev_move(input_t *, int, int, usec_t);
 static errno_t input_ev_abs_move(input_t *, unsigned, unsigned, unsigned, unsigned);
 static errno_t input_ev_button(input_t *, int, int);
 
@@ -172,6 +179,38 @@ static void cons_update(console_t *cons)
 	fibril_mutex_unlock(&switch_mtx);
 }
 
+static void cons_update_timeout(void *arg)
+{
+	console_t *cons = (console_t *) arg;
+
+	fibril_mutex_lock(&cons->mtx);
+	cons->update_pending = false;
+	fibril_mutex_unlock(&cons->mtx);
+
+	cons_update(cons);
+}
+
+/** Schedule a deferred screen update.
+ *
+ * Updates requested before the deferred update takes place are merged
+ * into it, so that the output server is not asked to refresh the screen
+ * more often than once per UPDATE_PERIOD.
+ *
+ * @param cons Console (cons->mtx must be locked).
+ *
+ */
+static void cons_update_defer(console_t *cons)
+{
+	assert(fibril_mutex_is_locked(&cons->mtx));
+
+	if (cons->update_pending)
+		return;
+
+	cons->update_pending = true;
+	fibril_timer_set_locked(cons->update_timer, UPDATE_PERIOD,
+	    cons_update_timeout, cons);
+}
+
 static void cons_update_cursor(console_t *cons)
 {
 	fibril_mutex_lock(&switch_mtx);
@@ -275,7 +314,7 @@ static errno_t input_ev_key(input_t *input, kbd_event_type_t type, keycode_t key
 	return EOK;
 }
 
-static errno_t input_ev_move(input_t *input, int dx, int dy)
+static errno_t input_ev_move(input_t *input, int dx, int dy, usec_t time)
 {
 	return EOK;
 }
@@ -314,10 +353,10 @@ static void cons_write_char(console_t *cons, wchar_t ch)
 		updated = chargrid_putwchar(cons->frontbuf, ch, true);
 	}
 
-	fibril_mutex_unlock(&cons->mtx);
-
 	if (updated > 1)
-		cons_update(cons);
+		cons_update_defer(cons);
+
+	fibril_mutex_unlock(&cons->mtx);
 }
 
 static void cons_set_cursor_vis(console_t *cons, bool visible)
@@ -613,6 +652,15 @@ static bool console_srv_init(char *input_svc, char *output_svc)
 			consoles[i].index = i;
 			atomic_flag_clear(&consoles[i].refcnt);
 			fibril_mutex_initialize(&consoles[i].mtx);
+			consoles[i].update_timer =
+			    fibril_timer_create(&consoles[i].mtx);
+			if (consoles[i].update_timer == NULL) {
+				printf("%s: Unable to create update timer "
+				    "%zu\n", NAME, i);
+				return false;
+			}
+
+			consoles[i].update_pending = false;
 			prodcons_initialize(&consoles[i].input_pc);
 			consoles[i].char_remains_len = 0;
 
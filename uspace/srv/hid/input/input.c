@@ -49,12 +49,15 @@
 #include <ipc/services.h>
 #include <ipc/input.h>
 #include <loc.h>
+#include <macros.h>
+#include <mem.h>
 #include <ns.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
 #include <str_error.h>
+#include <time.h>
 
 #include "input.h"
 #include "kbd.h"
@@ -83,6 +86,19 @@ typedef struct {
 
 	/** Client callback session */
 	async_sess_t *sess;
+
+	/** Protects the event queue */
+	fibril_mutex_t lock;
+	/** Signalled when the event queue or sender state changes */
+	fibril_condvar_t cv;
+	/** Events waiting for delivery to the client */
+	input_ev_rec_t queue[INPUT_EVENT_LIST_MAX];
+	/** Number of events in the queue */
+	size_t queue_len;
+	/** Event sender fibril is running */
+	bool sender;
+	/** Event sender fibril should terminate */
+	bool closing;
 } client_t;
 
 /** List of clients */
@@ -115,6 +131,8 @@ static void *client_data_create(void)
 	link_initialize(&client->link);
 	client->active = false;
 	client->sess = NULL;
+	fibril_mutex_initialize(&client->lock);
+	fibril_condvar_initialize(&client->cv);
 
 	list_append(&client->link, &clients);
 
@@ -129,6 +147,157 @@ static void client_data_destroy(void *data)
 	free(client);
 }
 
+/** Get event timestamp (uptime in microseconds). */
+static usec_t input_timestamp(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+/** Send events to the client.
+ *
+ * A single event is sent as its own message, more events at once using
+ * INPUT_EVENT_LIST. Wait until the client processes them.
+ */
+static void client_events_send(client_t *client, input_ev_rec_t *recs,
+    size_t count)
+{
+	async_exch_t *exch = async_exchange_begin(client->sess);
+
+	if (count == 1) {
+		(void) async_req_4_0(exch, recs[0].type, recs[0].args[0],
+		    recs[0].args[1], recs[0].args[2], recs[0].args[3]);
+		async_exchange_end(exch);
+		return;
+	}
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, INPUT_EVENT_LIST, &answer);
+	errno_t rc = async_data_write_start(exch, recs,
+	    count * sizeof(input_ev_rec_t));
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return;
+	}
+
+	async_wait_for(req, NULL);
+}
+
+/** Client event sender fibril.
+ *
+ * Events queued while the client is busy processing the previous ones
+ * are sent in one batch.
+ */
+static errno_t client_sender(void *arg)
+{
+	client_t *client = (client_t *) arg;
+	input_ev_rec_t recs[INPUT_EVENT_LIST_MAX];
+	size_t count;
+
+	fibril_mutex_lock(&client->lock);
+
+	while (true) {
+		while (client->queue_len == 0 && !client->closing)
+			fibril_condvar_wait(&client->cv, &client->lock);
+
+		if (client->closing)
+			break;
+
+		count = client->queue_len;
+		memcpy(recs, client->queue, count * sizeof(input_ev_rec_t));
+		client->queue_len = 0;
+		fibril_mutex_unlock(&client->lock);
+
+		client_events_send(client, recs, count);
+
+		fibril_mutex_lock(&client->lock);
+	}
+
+	client->sender = false;
+	fibril_condvar_broadcast(&client->cv);
+	fibril_mutex_unlock(&client->lock);
+	return EOK;
+}
+
+/** Start client event sender fibril. */
+static errno_t client_sender_start(client_t *client)
+{
+	fid_t fid = fibril_create(client_sender, client);
+	if (fid == 0)
+		return ENOMEM;
+
+	client->sender = true;
+	client->closing = false;
+	fibril_add_ready(fid);
+	return EOK;
+}
+
+/** Stop client event sender fibril and wait for it to terminate. */
+static void client_sender_stop(client_t *client)
+{
+	fibril_mutex_lock(&client->lock);
+
+	client->closing = true;
+	fibril_condvar_broadcast(&client->cv);
+
+	while (client->sender)
+		fibril_condvar_wait(&client->cv, &client->lock);
+
+	client->queue_len = 0;
+	fibril_mutex_unlock(&client->lock);
+}
+
+/** Queue event for delivery to the client.
+ *
+ * If the client has not yet received the previous motion event, a new
+ * one is merged into it. Relative motion is summed up and the newer
+ * timestamp kept, absolute position is simply replaced.
+ */
+static void client_event_push(client_t *client, sysarg_t type, sysarg_t arg1,
+    sysarg_t arg2, sysarg_t arg3, sysarg_t arg4)
+{
+	input_ev_rec_t *last;
+
+	fibril_mutex_lock(&client->lock);
+
+	if (!client->sender || client->closing) {
+		fibril_mutex_unlock(&client->lock);
+		return;
+	}
+
+	last = client->queue_len > 0 ?
+	    &client->queue[client->queue_len - 1] : NULL;
+
+	if (last != NULL && last->type == type && type == INPUT_EVENT_MOVE) {
+		last->args[0] = (int) last->args[0] + (int) arg1;
+		last->args[1] = (int) last->args[1] + (int) arg2;
+		last->args[2] = arg3;
+		last->args[3] = arg4;
+	} else if (last != NULL && last->type == type &&
+	    type == INPUT_EVENT_ABS_MOVE) {
+		last->args[0] = arg1;
+		last->args[1] = arg2;
+		last->args[2] = arg3;
+		last->args[3] = arg4;
+	} else if (client->queue_len < INPUT_EVENT_LIST_MAX) {
+		last = &client->queue[client->queue_len++];
+		last->type = type;
+		last->args[0] = arg1;
+		last->args[1] = arg2;
+		last->args[2] = arg3;
+		last->args[3] = arg4;
+	} else {
+		printf("%s: Event queue full, dropping event.\n", NAME);
+	}
+
+	fibril_condvar_signal(&client->cv);
+	fibril_mutex_unlock(&client->lock);
+}
+
 void kbd_push_data(kbd_dev_t *kdev, sysarg_t data)
 {
 	(*kdev->ctl_ops->parse)(data);
@@ -243,9 +412,8 @@ void kbd_push_event(kbd_dev_t *kdev, int type, unsigned int key)
 
 	list_foreach(clients, link, client_t, client) {
 		if (client->active) {
-			async_exch_t *exch = async_exchange_begin(client->sess);
-			async_msg_4(exch, INPUT_EVENT_KEY, ev.type, ev.key, ev.mods, ev.c);
-			async_exchange_end(exch);
+			client_event_push(client, INPUT_EVENT_KEY, ev.type,
+			    ev.key, ev.mods, ev.c);
 		}
 	}
 }
@@ -253,24 +421,28 @@ void kbd_push_event(kbd_dev_t *kdev, int type, unsigned int key)
 /** Mouse pointer has moved (relative mode). */
 void mouse_push_event_move(mouse_dev_t *mdev, int dx, int dy, int dz)
 {
+	usec_t time = input_timestamp();
+
 	list_foreach(clients, link, client_t, client) {
 		if (client->active) {
-			async_exch_t *exch = async_exchange_begin(client->sess);
-
-			if ((dx) || (dy))
-				async_msg_2(exch, INPUT_EVENT_MOVE, dx, dy);
+			if ((dx) || (dy)) {
+				client_event_push(client, INPUT_EVENT_MOVE,
+				    dx, dy, LOWER32(time), UPPER32(time));
+			}
 
 			if (dz) {
 				// TODO: Implement proper wheel support
 				keycode_t code = dz > 0 ? KC_UP : KC_DOWN;
 
-				for (unsigned int i = 0; i < 3; i++)
-					async_msg_4(exch, INPUT_EVENT_KEY, KEY_PRESS, code, 0, 0);
+				for (unsigned int i = 0; i < 3; i++) {
+					client_event_push(client,
+					    INPUT_EVENT_KEY, KEY_PRESS, code,
+					    0, 0);
+				}
 
-				async_msg_4(exch, INPUT_EVENT_KEY, KEY_RELEASE, code, 0, 0);
+				client_event_push(client, INPUT_EVENT_KEY,
+				    KEY_RELEASE, code, 0, 0);
 			}
-
-			async_exchange_end(exch);
 		}
 	}
 }
@@ -282,9 +454,8 @@ void mouse_push_event_abs_move(mouse_dev_t *mdev, unsigned int x, unsigned int y
 	list_foreach(clients, link, client_t, client) {
 		if (client->active) {
 			if ((max_x) && (max_y)) {
-				async_exch_t *exch = async_exchange_begin(client->sess);
-				async_msg_4(exch, INPUT_EVENT_ABS_MOVE, x, y, max_x, max_y);
-				async_exchange_end(exch);
+				client_event_push(client, INPUT_EVENT_ABS_MOVE,
+				    x, y, max_x, max_y);
 			}
 		}
 	}
@@ -295,9 +466,8 @@ void mouse_push_event_button(mouse_dev_t *mdev, int bnum, int press)
 {
 	list_foreach(clients, link, client_t, client) {
 		if (client->active) {
-			async_exch_t *exch = async_exchange_begin(client->sess);
-			async_msg_2(exch, INPUT_EVENT_BUTTON, bnum, press);
-			async_exchange_end(exch);
+			client_event_push(client, INPUT_EVENT_BUTTON,
+			    bnum, press, 0, 0);
 		}
 	}
 }
@@ -311,10 +481,8 @@ static void client_arbitration(void)
 
 	/* Notify clients about the arbitration */
 	list_foreach(clients, link, client_t, client) {
-		async_exch_t *exch = async_exchange_begin(client->sess);
-		async_msg_0(exch, client->active ?
-		    INPUT_EVENT_ACTIVE : INPUT_EVENT_DEACTIVE);
-		async_exchange_end(exch);
+		client_event_push(client, client->active ?
+		    INPUT_EVENT_ACTIVE : INPUT_EVENT_DEACTIVE, 0, 0, 0, 0);
 	}
 }
 
@@ -335,6 +503,7 @@ static void client_connection(ipc_call_t *icall, void *arg)
 
 		if (!ipc_get_imethod(&call)) {
 			if (client->sess != NULL) {
+				client_sender_stop(client);
 				async_hangup(client->sess);
 				client->sess = NULL;
 			}
@@ -348,7 +517,12 @@ static void client_connection(ipc_call_t *icall, void *arg)
 		if (sess != NULL) {
 			if (client->sess == NULL) {
 				client->sess = sess;
-				async_answer_0(&call, EOK);
+				errno_t rc = client_sender_start(client);
+				if (rc != EOK) {
+					async_hangup(sess);
+					client->sess = NULL;
+				}
+				async_answer_0(&call, rc);
 			} else
 				async_answer_0(&call, ELIMIT);
 		} else {
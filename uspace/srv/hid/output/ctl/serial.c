@@ -104,6 +104,13 @@ static void serial_char_update(outdev_t *dev, sysarg_t col, sysarg_t row)
 	draw_char(state, field, col, row);
 }
 
+static void serial_scroll(outdev_t *dev, sysarg_t lines)
+{
+	vt100_state_t *state = (vt100_state_t *) dev->data;
+
+	vt100_scroll(state, lines);
+}
+
 static void serial_flush(outdev_t *dev)
 {
 	vt100_state_t *state = (vt100_state_t *) dev->data;
@@ -118,6 +125,7 @@ static outdev_ops_t serial_ops = {
 	.get_caps = serial_get_caps,
 	.cursor_update = serial_cursor_update,
 	.char_update = serial_char_update,
+	.scroll = serial_scroll,
 	.flush = serial_flush
 };
 
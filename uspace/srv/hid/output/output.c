@@ -66,6 +66,7 @@ outdev_t *outdev_register(outdev_ops_t *ops, void *data)
 
 	link_initialize(&dev->link);
 
+	dev->top_row = 0;
 	dev->ops = *ops;
 	dev->data = data;
 
@@ -275,8 +276,39 @@ static bool srv_update_scroll(outdev_t *dev, chargrid_t *buf)
 	if (dev->top_row == top_row)
 		return false;
 
+	sysarg_t lines = (top_row + buf->rows - dev->top_row) % buf->rows;
 	dev->top_row = top_row;
 
+	if ((dev->ops.scroll != NULL) && (buf->cols == dev->cols) &&
+	    (buf->rows == dev->rows)) {
+		/*
+		 * Let the device move its contents and do the same
+		 * with the back buffer. Only the rows scrolled in
+		 * need to be drawn, the rest is left to the ordinary
+		 * update of the dirty fields.
+		 */
+		dev->ops.scroll(dev, lines);
+		dev->backbuf->top_row =
+		    (dev->backbuf->top_row + lines) % dev->rows;
+
+		for (sysarg_t y = dev->rows - lines; y < dev->rows; y++) {
+			for (sysarg_t x = 0; x < dev->cols; x++) {
+				charfield_t *front_field =
+				    chargrid_charfield_at(buf, x, y);
+				charfield_t *back_field =
+				    chargrid_charfield_at(dev->backbuf, x, y);
+
+				back_field->ch = front_field->ch;
+				back_field->attrs = front_field->attrs;
+				front_field->flags &= ~CHAR_FLAG_DIRTY;
+
+				dev->ops.char_update(dev, x, y);
+			}
+		}
+
+		return false;
+	}
+
 	for (sysarg_t y = 0; y < dev->rows; y++) {
 		for (sysarg_t x = 0; x < dev->cols; x++) {
 			charfield_t *front_field =
@@ -319,7 +351,13 @@ static void srv_update(ipc_call_t *icall)
 		if (srv_update_scroll(dev, buf))
 			continue;
 
-		for (sysarg_t y = 0; y < dev->rows; y++) {
+		/* Rows outside of the dirty range need not be looked at */
+		sysarg_t top;
+		sysarg_t bottom;
+		chargrid_get_dirty_rows(buf, &top, &bottom);
+		bottom = min(bottom, dev->rows);
+
+		for (sysarg_t y = top; y < bottom; y++) {
 			for (sysarg_t x = 0; x < dev->cols; x++) {
 				charfield_t *front_field =
 				    chargrid_charfield_at(buf, x, y);
@@ -351,6 +389,7 @@ static void srv_update(ipc_call_t *icall)
 		dev->ops.flush(dev);
 	}
 
+	chargrid_reset_dirty_rows(buf);
 	async_answer_0(icall, EOK);
 }
 
@@ -230,6 +230,32 @@ void vt100_putwchar(vt100_state_t *state, wchar_t ch)
 	}
 }
 
+/** Scroll the screen contents up.
+ *
+ * The scrolling region is set to the whole screen, so that the terminal
+ * scrolls even if it is actually larger than assumed. The contents of
+ * the rows scrolled in are undefined.
+ *
+ * @param state VT100 state.
+ * @param lines Number of rows to scroll by.
+ *
+ */
+void vt100_scroll(vt100_state_t *state, sysarg_t lines)
+{
+	char control[MAX_CONTROL];
+
+	/* ECMA-48 Set Top and Bottom Margins moves the cursor home */
+	snprintf(control, MAX_CONTROL, "\033[1;%" PRIun "r", state->rows);
+	state->control_puts(control);
+	state->cur_col = 0;
+	state->cur_row = 0;
+
+	/* ECMA-48 Index scrolls at the bottom margin */
+	vt100_goto(state, 0, state->rows - 1);
+	for (sysarg_t i = 0; i < lines; i++)
+		state->control_puts("\033D");
+}
+
 void vt100_flush(vt100_state_t *state)
 {
 	state->flush();
@@ -121,6 +121,8 @@ static errno_t rfb_handle_damage_pixels(visualizer_t *vs,
 		}
 	}
 
+	/* Let the client encoders know */
+	fibril_condvar_broadcast(&rfb.update_cv);
 	fibril_mutex_unlock(&rfb.lock);
 	return EOK;
 }
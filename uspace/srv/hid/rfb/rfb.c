@@ -176,6 +176,7 @@ errno_t rfb_init(rfb_t *rfb, uint16_t width, uint16_t height, const char *name)
 {
 	memset(rfb, 0, sizeof(rfb_t));
 	fibril_mutex_initialize(&rfb->lock);
+	fibril_condvar_initialize(&rfb->update_cv);
 
 	rfb_pixel_format_t *pf = &rfb->pixel_format;
 	pf->bpp = 32;
@@ -191,6 +192,7 @@ errno_t rfb_init(rfb_t *rfb, uint16_t width, uint16_t height, const char *name)
 
 	rfb->name = str_dup(name);
 	rfb->supports_trle = false;
+	rfb->supports_copyrect = false;
 
 	return rfb_set_size(rfb, width, height);
 }
@@ -202,6 +204,20 @@ errno_t rfb_set_size(rfb_t *rfb, uint16_t width, uint16_t height)
 	if (pixbuf == NULL)
 		return ENOMEM;
 
+	size_t tile_cols = (width + RFB_TILE_SIZE - 1) / RFB_TILE_SIZE;
+	size_t tile_rows = (height + RFB_TILE_SIZE - 1) / RFB_TILE_SIZE;
+	rfb_tile_t *tiles = calloc(tile_cols * tile_rows, sizeof(rfb_tile_t));
+	if (tiles == NULL && tile_cols * tile_rows > 0) {
+		free(pixbuf);
+		return ENOMEM;
+	}
+
+	free(rfb->tiles);
+	rfb->tiles = tiles;
+	rfb->tile_cols = tile_cols;
+	rfb->tile_rows = tile_rows;
+	rfb->tiles_valid = false;
+
 	free(rfb->framebuffer.data);
 	rfb->framebuffer.data = pixbuf;
 	rfb->framebuffer.width = width;
@@ -423,73 +439,505 @@ static size_t rfb_tile_encode_raw(rfb_t *rfb, cpixel_ctx_t *cpixel,
 		for (uint16_t x = tile->x; x < tile->x + tile->width; x++) {
 			pixel_t pixel = pixelmap_get_pixel(&rfb->framebuffer, x, y);
 			cpixel_encode(rfb, cpixel, buf, pixel);
+			buf += cpixel->size;
 		}
 	}
 
 	return size;
 }
 
-static errno_t rfb_tile_encode_solid(rfb_t *rfb, cpixel_ctx_t *cpixel,
-    rfb_rectangle_t *tile, void *buf, size_t *size)
+/** Statistics of a tile used to pick its subencoding. */
+typedef struct {
+	/** Colors of the tile, valid if @c palette_full is false */
+	pixel_t palette[RFB_TILE_PALETTE_MAX];
+	size_t palette_size;
+	bool palette_full;
+
+	/** Size of run lengths of plain RLE */
+	size_t rle_size;
+	/** Size of the indices and run lengths of palette RLE */
+	size_t palette_rle_size;
+	/** Number of runs */
+	size_t runs;
+} tile_stats_t;
+
+static pixel_t rfb_tile_pixel(rfb_t *rfb, rfb_rectangle_t *tile, size_t i)
 {
-	/* Check if it is single color */
-	pixel_t the_color = pixelmap_get_pixel(&rfb->framebuffer, tile->x, tile->y);
-	for (uint16_t y = tile->y; y < tile->y + tile->height; y++) {
-		for (uint16_t x = tile->x; x < tile->x + tile->width; x++) {
-			if (pixelmap_get_pixel(&rfb->framebuffer, x, y) != the_color)
-				return EINVAL;
+	return pixelmap_get_pixel(&rfb->framebuffer, tile->x + i % tile->width,
+	    tile->y + i / tile->width);
+}
+
+/** Number of bytes encoding the length of a run in TRLE. */
+static size_t rfb_run_length_size(size_t length)
+{
+	return (length - 1) / 255 + 1;
+}
+
+static void rfb_run_length_encode(uint8_t **buf, size_t length)
+{
+	length--;
+	while (length >= 255) {
+		*(*buf)++ = 255;
+		length -= 255;
+	}
+	*(*buf)++ = length;
+}
+
+static size_t rfb_tile_palette_index(tile_stats_t *stats, pixel_t pixel)
+{
+	for (size_t i = 0; i < stats->palette_size; i++) {
+		if (stats->palette[i] == pixel)
+			return i;
+	}
+
+	return stats->palette_size;
+}
+
+static void rfb_tile_stats_run(tile_stats_t *stats, size_t length)
+{
+	size_t length_size = rfb_run_length_size(length);
+
+	stats->rle_size += length_size;
+	stats->palette_rle_size += (length == 1) ? 1 : 1 + length_size;
+	stats->runs++;
+}
+
+static void rfb_tile_stats(rfb_t *rfb, rfb_rectangle_t *tile,
+    tile_stats_t *stats)
+{
+	size_t count = tile->width * tile->height;
+
+	stats->palette_size = 0;
+	stats->palette_full = false;
+	stats->rle_size = 0;
+	stats->palette_rle_size = 0;
+	stats->runs = 0;
+
+	pixel_t run_pixel = rfb_tile_pixel(rfb, tile, 0);
+	size_t run_length = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		pixel_t pixel = rfb_tile_pixel(rfb, tile, i);
+
+		if (!stats->palette_full &&
+		    rfb_tile_palette_index(stats, pixel) ==
+		    stats->palette_size) {
+			if (stats->palette_size == RFB_TILE_PALETTE_MAX)
+				stats->palette_full = true;
+			else
+				stats->palette[stats->palette_size++] = pixel;
 		}
+
+		if (pixel != run_pixel) {
+			rfb_tile_stats_run(stats, run_length);
+			run_pixel = pixel;
+			run_length = 0;
+		}
+
+		run_length++;
 	}
 
-	/* OK, encode it */
-	if (buf)
-		cpixel_encode(rfb, cpixel, buf, the_color);
-	*size = cpixel->size;
-	return EOK;
+	rfb_tile_stats_run(stats, run_length);
+}
+
+/** Number of bits per index of a packed palette tile. */
+static size_t rfb_packed_index_bits(size_t palette_size)
+{
+	if (palette_size <= 2)
+		return 1;
+	if (palette_size <= 4)
+		return 2;
+	return 4;
+}
+
+static size_t rfb_tile_encode_packed_palette(rfb_t *rfb, cpixel_ctx_t *cpixel,
+    rfb_rectangle_t *tile, tile_stats_t *stats, uint8_t *buf)
+{
+	size_t bits = rfb_packed_index_bits(stats->palette_size);
+	size_t row_size = (tile->width * bits + 7) / 8;
+	size_t size = stats->palette_size * cpixel->size +
+	    tile->height * row_size;
+
+	if (buf == NULL)
+		return size;
+
+	for (size_t i = 0; i < stats->palette_size; i++) {
+		cpixel_encode(rfb, cpixel, buf, stats->palette[i]);
+		buf += cpixel->size;
+	}
+
+	for (uint16_t y = 0; y < tile->height; y++) {
+		memset(buf, 0, row_size);
+
+		size_t bit = 0;
+		for (uint16_t x = 0; x < tile->width; x++) {
+			pixel_t pixel = rfb_tile_pixel(rfb, tile,
+			    y * tile->width + x);
+			size_t index = rfb_tile_palette_index(stats, pixel);
+
+			/* Most significant bits first */
+			buf[bit / 8] |= index << (8 - bits - bit % 8);
+			bit += bits;
+		}
+
+		buf += row_size;
+	}
+
+	return size;
+}
+
+static size_t rfb_tile_encode_rle(rfb_t *rfb, cpixel_ctx_t *cpixel,
+    rfb_rectangle_t *tile, tile_stats_t *stats, bool palette, uint8_t *buf)
+{
+	size_t size;
+	if (palette) {
+		size = stats->palette_size * cpixel->size +
+		    stats->palette_rle_size;
+	} else {
+		size = stats->runs * cpixel->size + stats->rle_size;
+	}
+
+	if (buf == NULL)
+		return size;
+
+	if (palette) {
+		for (size_t i = 0; i < stats->palette_size; i++) {
+			cpixel_encode(rfb, cpixel, buf, stats->palette[i]);
+			buf += cpixel->size;
+		}
+	}
+
+	size_t count = tile->width * tile->height;
+	size_t i = 0;
+
+	while (i < count) {
+		pixel_t pixel = rfb_tile_pixel(rfb, tile, i);
+		size_t length = 1;
+
+		while (i + length < count &&
+		    rfb_tile_pixel(rfb, tile, i + length) == pixel)
+			length++;
+
+		if (!palette) {
+			cpixel_encode(rfb, cpixel, buf, pixel);
+			buf += cpixel->size;
+			rfb_run_length_encode(&buf, length);
+		} else if (length == 1) {
+			*buf++ = rfb_tile_palette_index(stats, pixel);
+		} else {
+			*buf++ = rfb_tile_palette_index(stats, pixel) | 128;
+			rfb_run_length_encode(&buf, length);
+		}
+
+		i += length;
+	}
+
+	return size;
+}
+
+/** Encode a tile by the subencoding producing the least data.
+ *
+ * @return Size of the encoded tile including the subencoding byte.
+ */
+static size_t rfb_tile_encode(rfb_t *rfb, cpixel_ctx_t *cpixel,
+    rfb_rectangle_t *tile, uint8_t *buf)
+{
+	tile_stats_t stats;
+	rfb_tile_stats(rfb, tile, &stats);
+
+	if (!stats.palette_full && stats.palette_size == 1) {
+		buf[0] = RFB_TILE_ENCODING_SOLID;
+		cpixel_encode(rfb, cpixel, buf + 1, stats.palette[0]);
+		return 1 + cpixel->size;
+	}
+
+	uint8_t enctype = RFB_TILE_ENCODING_RAW;
+	size_t size = rfb_tile_encode_raw(rfb, cpixel, tile, NULL);
+
+	size_t rle_size = rfb_tile_encode_rle(rfb, cpixel, tile, &stats,
+	    false, NULL);
+	if (rle_size < size) {
+		enctype = RFB_TILE_ENCODING_RLE;
+		size = rle_size;
+	}
+
+	if (!stats.palette_full) {
+		size_t packed_size = rfb_tile_encode_packed_palette(rfb, cpixel,
+		    tile, &stats, NULL);
+		if (packed_size < size) {
+			enctype = stats.palette_size;
+			size = packed_size;
+		}
+
+		size_t palette_rle_size = rfb_tile_encode_rle(rfb, cpixel, tile,
+		    &stats, true, NULL);
+		if (palette_rle_size < size) {
+			enctype = RFB_TILE_ENCODING_RLE + stats.palette_size;
+			size = palette_rle_size;
+		}
+	}
+
+	buf[0] = enctype;
+
+	if (enctype == RFB_TILE_ENCODING_RAW)
+		rfb_tile_encode_raw(rfb, cpixel, tile, buf + 1);
+	else if (enctype == RFB_TILE_ENCODING_RLE)
+		rfb_tile_encode_rle(rfb, cpixel, tile, &stats, false, buf + 1);
+	else if (enctype > RFB_TILE_ENCODING_RLE)
+		rfb_tile_encode_rle(rfb, cpixel, tile, &stats, true, buf + 1);
+	else
+		rfb_tile_encode_packed_palette(rfb, cpixel, tile, &stats,
+		    buf + 1);
+
+	return 1 + size;
 }
 
+/** Encode a rectangle by TRLE.
+ *
+ * @param buf Buffer for the data or NULL to get the maximum size
+ * @return Size of the data.
+ */
 static size_t rfb_rect_encode_trle(rfb_t *rfb, rfb_rectangle_t *rect, void *buf)
 {
 	cpixel_ctx_t cpixel;
 	cpixel_context_init(&cpixel, &rfb->pixel_format);
 
 	size_t size = 0;
-	for (uint16_t y = 0; y < rect->height; y += 16) {
-		for (uint16_t x = 0; x < rect->width; x += 16) {
+	for (uint16_t y = 0; y < rect->height; y += RFB_TILE_SIZE) {
+		for (uint16_t x = 0; x < rect->width; x += RFB_TILE_SIZE) {
 			rfb_rectangle_t tile = {
-				.x = x,
-				.y = y,
-				.width = (x + 16 <= rect->width ? 16 : rect->width - x),
-				.height = (y + 16 <= rect->height ? 16 : rect->height - y)
+				.x = rect->x + x,
+				.y = rect->y + y,
+				.width = min(rect->width - x, RFB_TILE_SIZE),
+				.height = min(rect->height - y, RFB_TILE_SIZE)
 			};
 
-			size += 1;
-			uint8_t *tile_enctype_ptr = buf;
-			if (buf)
-				buf +=  1;
+			if (buf == NULL) {
+				/* Raw tiles are the largest ones */
+				size += 1 + rfb_tile_encode_raw(rfb, &cpixel,
+				    &tile, NULL);
+			} else {
+				size += rfb_tile_encode(rfb, &cpixel, &tile,
+				    buf + size);
+			}
+		}
+	}
+	return size;
+}
+
+typedef enum {
+	TILE_SAME,
+	TILE_CHANGED,
+	TILE_COPIED
+} tile_state_t;
 
-			uint8_t tile_enctype = RFB_TILE_ENCODING_SOLID;
-			size_t tile_size;
-			errno_t rc = rfb_tile_encode_solid(rfb, &cpixel, &tile, buf,
-			    &tile_size);
-			if (rc != EOK) {
-				tile_size = rfb_tile_encode_raw(rfb, &cpixel, &tile, buf);
-				tile_enctype = RFB_TILE_ENCODING_RAW;
+static void rfb_tile_rect(rfb_t *rfb, size_t col, size_t row,
+    rfb_rectangle_t *tile)
+{
+	tile->x = col * RFB_TILE_SIZE;
+	tile->y = row * RFB_TILE_SIZE;
+	tile->width = min(rfb->width - tile->x, RFB_TILE_SIZE);
+	tile->height = min(rfb->height - tile->y, RFB_TILE_SIZE);
+}
+
+static uint64_t rfb_tile_hash(rfb_t *rfb, rfb_rectangle_t *tile)
+{
+	/* FNV-1a */
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (uint16_t y = tile->y; y < tile->y + tile->height; y++) {
+		pixel_t *row = pixelmap_pixel_at(&rfb->framebuffer, tile->x, y);
+
+		for (uint16_t x = 0; x < tile->width; x++)
+			hash = (hash ^ row[x]) * 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+static bool rfb_tile_copy_from(rfb_t *rfb, size_t col, size_t row,
+    size_t src_row)
+{
+	rfb_tile_t *tile = &rfb->tiles[row * rfb->tile_cols + col];
+	rfb_tile_t *src = &rfb->tiles[src_row * rfb->tile_cols + col];
+	rfb_rectangle_t rect;
+
+	/* Only whole tiles can be copied */
+	rfb_tile_rect(rfb, col, src_row, &rect);
+	if (rect.width != RFB_TILE_SIZE || rect.height != RFB_TILE_SIZE)
+		return false;
+
+	if (src->hash != tile->new_hash)
+		return false;
+
+	tile->state = TILE_COPIED;
+	tile->src_row = src_row;
+	return true;
+}
+
+/** Find a tile of the same column the client can copy the tile from.
+ *
+ * Tiles are sent from the top, so only the tiles below are not
+ * overwritten earlier in the update and can be copied. This recognizes
+ * scrolling up. The offset of the previous copied tile is tried first.
+ */
+static bool rfb_tile_find_source(rfb_t *rfb, size_t col, size_t row,
+    size_t *offset)
+{
+	rfb_rectangle_t rect;
+
+	rfb_tile_rect(rfb, col, row, &rect);
+	if (rect.width != RFB_TILE_SIZE || rect.height != RFB_TILE_SIZE)
+		return false;
+
+	if (*offset != 0 && row + *offset < rfb->tile_rows &&
+	    rfb_tile_copy_from(rfb, col, row, row + *offset))
+		return true;
+
+	for (size_t src_row = row + 1; src_row < rfb->tile_rows; src_row++) {
+		if (rfb_tile_copy_from(rfb, col, row, src_row)) {
+			*offset = src_row - row;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Find out which tiles of the damaged area have to be sent.
+ *
+ * @return Number of rectangles of the update.
+ */
+static size_t rfb_classify_tiles(rfb_t *rfb, rfb_rectangle_t *damage,
+    bool incremental)
+{
+	size_t col0 = damage->x / RFB_TILE_SIZE;
+	size_t row0 = damage->y / RFB_TILE_SIZE;
+	size_t col1 = (damage->x + damage->width + RFB_TILE_SIZE - 1) /
+	    RFB_TILE_SIZE;
+	size_t row1 = (damage->y + damage->height + RFB_TILE_SIZE - 1) /
+	    RFB_TILE_SIZE;
+	size_t count = 0;
+	size_t offset = 0;
+
+	for (size_t i = 0; i < rfb->tile_cols * rfb->tile_rows; i++)
+		rfb->tiles[i].state = TILE_SAME;
+
+	for (size_t row = row0; row < row1; row++) {
+		bool prev_changed = false;
+		size_t prev_src_row = 0;
+
+		for (size_t col = col0; col < col1; col++) {
+			rfb_tile_t *tile = &rfb->tiles[row * rfb->tile_cols +
+			    col];
+			rfb_rectangle_t rect;
+
+			rfb_tile_rect(rfb, col, row, &rect);
+			tile->new_hash = rfb_tile_hash(rfb, &rect);
+
+			if (incremental && tile->new_hash == tile->hash) {
+				prev_changed = false;
+				continue;
 			}
 
-			if (buf) {
-				*tile_enctype_ptr = tile_enctype;
-				buf += tile_size;
+			if (incremental && rfb->supports_copyrect &&
+			    rfb_tile_find_source(rfb, col, row, &offset)) {
+				/* Tiles copied by the same offset are merged */
+				if (col == col0 ||
+				    tile[-1].state != TILE_COPIED ||
+				    prev_src_row != tile->src_row)
+					count++;
+
+				prev_changed = false;
+				prev_src_row = tile->src_row;
+				continue;
 			}
+
+			/* Adjacent changed tiles are merged */
+			tile->state = TILE_CHANGED;
+			if (!prev_changed)
+				count++;
+
+			prev_changed = true;
 		}
 	}
-	return size;
+
+	return count;
+}
+
+/** Get the next rectangle of the update.
+ *
+ * @param col Column to start at, updated to the column after the rectangle
+ * @param row Row of tiles
+ * @param rect Place to store the rectangle
+ * @param copy Place to store the source of a copied rectangle
+ * @return @c true if there is a rectangle.
+ */
+static bool rfb_next_rect(rfb_t *rfb, size_t *col, size_t row,
+    rfb_rectangle_t *rect, rfb_copyrect_t *copy)
+{
+	rfb_tile_t *tiles = &rfb->tiles[row * rfb->tile_cols];
+
+	while (*col < rfb->tile_cols && tiles[*col].state == TILE_SAME)
+		(*col)++;
+
+	if (*col == rfb->tile_cols)
+		return false;
+
+	size_t first = *col;
+	tile_state_t state = tiles[first].state;
+	uint16_t src_row = tiles[first].src_row;
+
+	do {
+		(*col)++;
+	} while (*col < rfb->tile_cols && tiles[*col].state == state &&
+	    (state != TILE_COPIED || tiles[*col].src_row == src_row));
+
+	rfb_rectangle_t tile;
+	rfb_tile_rect(rfb, first, row, &tile);
+	*rect = tile;
+
+	rfb_tile_rect(rfb, *col - 1, row, &tile);
+	rect->width = tile.x + tile.width - rect->x;
+
+	if (state == TILE_COPIED) {
+		rect->enctype = RFB_ENCODING_COPYRECT;
+		copy->src_x = rect->x;
+		copy->src_y = src_row * RFB_TILE_SIZE;
+	} else if (rfb->supports_trle) {
+		rect->enctype = RFB_ENCODING_TRLE;
+	} else {
+		rect->enctype = RFB_ENCODING_RAW;
+	}
+
+	return true;
+}
+
+static size_t rfb_rect_encode(rfb_t *rfb, rfb_rectangle_t *rect,
+    rfb_copyrect_t *copy, void *buf)
+{
+	switch (rect->enctype) {
+	case RFB_ENCODING_COPYRECT:
+		if (buf != NULL) {
+			rfb_copyrect_t *data = buf;
+			data->src_x = host2uint16_t_be(copy->src_x);
+			data->src_y = host2uint16_t_be(copy->src_y);
+		}
+		return sizeof(rfb_copyrect_t);
+	case RFB_ENCODING_TRLE:
+		return rfb_rect_encode_trle(rfb, rect, buf);
+	default:
+		return rfb_rect_encode_raw(rfb, rect, buf);
+	}
 }
 
 static errno_t rfb_send_framebuffer_update(rfb_t *rfb, tcp_conn_t *conn,
     bool incremental)
 {
 	fibril_mutex_lock(&rfb->lock);
+	if (!rfb->tiles_valid)
+		incremental = false;
+
 	if (!incremental || !rfb->damage_valid) {
 		rfb->damage_rect.x = 0;
 		rfb->damage_rect.y = 0;
@@ -497,10 +945,21 @@ static errno_t rfb_send_framebuffer_update(rfb_t *rfb, tcp_conn_t *conn,
 		rfb->damage_rect.height = rfb->height;
 	}
 
-	/* We send only single raw rectangle right now */
-	size_t buf_size = sizeof(rfb_framebuffer_update_t) +
-	    sizeof(rfb_rectangle_t) * 1 +
-	    rfb_rect_encode_raw(rfb, &rfb->damage_rect, NULL);
+	size_t rect_count = rfb_classify_tiles(rfb, &rfb->damage_rect,
+	    incremental);
+
+	/* Only the tiles which have changed are sent */
+	size_t buf_size = sizeof(rfb_framebuffer_update_t);
+	rfb_rectangle_t rect;
+	rfb_copyrect_t copy;
+
+	for (size_t row = 0; row < rfb->tile_rows; row++) {
+		size_t col = 0;
+		while (rfb_next_rect(rfb, &col, row, &rect, &copy)) {
+			buf_size += sizeof(rfb_rectangle_t) +
+			    rfb_rect_encode(rfb, &rect, &copy, NULL);
+		}
+	}
 
 	void *buf = malloc(buf_size);
 	if (buf == NULL) {
@@ -512,24 +971,29 @@ static errno_t rfb_send_framebuffer_update(rfb_t *rfb, tcp_conn_t *conn,
 	void *pos = buf;
 	rfb_framebuffer_update_t *fbu = buf;
 	fbu->message_type = RFB_SMSG_FRAMEBUFFER_UPDATE;
-	fbu->rect_count = 1;
+	fbu->rect_count = rect_count;
 	rfb_framebuffer_update_to_be(fbu, fbu);
 	pos += sizeof(rfb_framebuffer_update_t);
 
-	rfb_rectangle_t *rect = pos;
-	pos += sizeof(rfb_rectangle_t);
+	for (size_t row = 0; row < rfb->tile_rows; row++) {
+		size_t col = 0;
+		while (rfb_next_rect(rfb, &col, row, &rect, &copy)) {
+			rfb_rectangle_t *prect = pos;
+			pos += sizeof(rfb_rectangle_t);
 
-	*rect = rfb->damage_rect;
+			*prect = rect;
+			pos += rfb_rect_encode(rfb, &rect, &copy, pos);
+			rfb_rectangle_to_be(prect, prect);
+		}
+	}
 
-	if (rfb->supports_trle) {
-		rect->enctype = RFB_ENCODING_TRLE;
-		pos += rfb_rect_encode_trle(rfb, rect, pos);
-	} else {
-		rect->enctype = RFB_ENCODING_RAW;
-		pos += rfb_rect_encode_raw(rfb, rect, pos);
+	/* The client has the contents of the tiles now */
+	for (size_t i = 0; i < rfb->tile_cols * rfb->tile_rows; i++) {
+		if (rfb->tiles[i].state != TILE_SAME)
+			rfb->tiles[i].hash = rfb->tiles[i].new_hash;
 	}
-	rfb_rectangle_to_be(rect, rect);
 
+	rfb->tiles_valid = true;
 	rfb->damage_valid = false;
 
 	size_t send_palette_size = 0;
@@ -548,13 +1012,14 @@ static errno_t rfb_send_framebuffer_update(rfb_t *rfb, tcp_conn_t *conn,
 
 	if (!rfb->pixel_format.true_color) {
 		errno_t rc = tcp_conn_send(conn, send_palette, send_palette_size);
+		free(send_palette);
 		if (rc != EOK) {
 			free(buf);
 			return rc;
 		}
 	}
 
-	errno_t rc = tcp_conn_send(conn, buf, buf_size);
+	errno_t rc = tcp_conn_send(conn, buf, pos - buf);
 	free(buf);
 
 	return rc;
@@ -586,95 +1051,68 @@ static errno_t rfb_set_pixel_format(rfb_t *rfb, rfb_pixel_format_t *pixel_format
 	return EOK;
 }
 
-static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
+/** Client connection state */
+typedef struct {
+	rfb_t *rfb;
+	tcp_conn_t *conn;
+	/** Client waits for an update */
+	bool update_requested;
+	/** Client asked only for the changes */
+	bool update_incremental;
+	/** Connection is being closed */
+	bool closing;
+	/** Encoder fibril has finished */
+	bool encoder_done;
+} rfb_client_t;
+
+/** Encoder fibril of a client.
+ *
+ * Sends an update once the client has asked for it and there is
+ * something to send. Answers to incremental requests are delayed until
+ * the framebuffer is damaged.
+ */
+static errno_t rfb_encoder(void *arg)
 {
-	/* Version handshake */
-	errno_t rc = tcp_conn_send(conn, "RFB 003.008\n", 12);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending server version: %s",
-		    str_error(rc));
-		return;
-	}
+	rfb_client_t *client = (rfb_client_t *) arg;
+	rfb_t *rfb = client->rfb;
 
-	char client_version[12];
-	rc = recv_chars(conn, client_version, 12);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client version: %s",
-		    str_error(rc));
-		return;
-	}
+	fibril_mutex_lock(&rfb->lock);
 
-	if (memcmp(client_version, "RFB 003.008\n", 12) != 0) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Client version is not RFB 3.8");
-		return;
-	}
+	while (true) {
+		while (!client->closing && (!client->update_requested ||
+		    (client->update_incremental && !rfb->damage_valid)))
+			fibril_condvar_wait(&rfb->update_cv, &rfb->lock);
 
-	/*
-	 * Security handshake
-	 * 1 security type supported, which is 1 - None
-	 */
-	char sec_types[2];
-	sec_types[0] = 1; /* length */
-	sec_types[1] = RFB_SECURITY_NONE;
-	rc = tcp_conn_send(conn, sec_types, 2);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN,
-		    "Failed sending security handshake: %s", str_error(rc));
-		return;
-	}
+		if (client->closing)
+			break;
 
-	char selected_sec_type = 0;
-	rc = recv_char(conn, &selected_sec_type);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving security type: %s",
-		    str_error(rc));
-		return;
-	}
-	if (selected_sec_type != RFB_SECURITY_NONE) {
-		log_msg(LOG_DEFAULT, LVL_WARN,
-		    "Client selected security type other than none");
-		return;
-	}
-	uint32_t security_result = RFB_SECURITY_HANDSHAKE_OK;
-	rc = tcp_conn_send(conn, &security_result, sizeof(uint32_t));
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending security result: %s",
-		    str_error(rc));
-		return;
-	}
+		bool incremental = client->update_incremental;
+		client->update_requested = false;
+		fibril_mutex_unlock(&rfb->lock);
 
-	/* Client init */
-	char shared_flag;
-	rc = recv_char(conn, &shared_flag);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client init: %s",
-		    str_error(rc));
-		return;
-	}
+		errno_t rc = rfb_send_framebuffer_update(rfb, client->conn,
+		    incremental);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_WARN,
+			    "Failed sending framebuffer update: %s",
+			    str_error(rc));
+		}
 
-	/* Server init */
-	fibril_mutex_lock(&rfb->lock);
-	size_t name_length = str_length(rfb->name);
-	size_t msg_length = sizeof(rfb_server_init_t) + name_length;
-	rfb_server_init_t *server_init = malloc(msg_length);
-	if (server_init == NULL) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Cannot allocate memory for server init");
-		fibril_mutex_unlock(&rfb->lock);
-		return;
+		fibril_mutex_lock(&rfb->lock);
 	}
-	server_init->width = rfb->width;
-	server_init->height = rfb->height;
-	server_init->pixel_format = rfb->pixel_format;
-	server_init->name_length = name_length;
-	rfb_server_init_to_be(server_init, server_init);
-	memcpy(server_init->name, rfb->name, name_length);
+
+	client->encoder_done = true;
+	fibril_condvar_broadcast(&rfb->update_cv);
 	fibril_mutex_unlock(&rfb->lock);
-	rc = tcp_conn_send(conn, server_init, msg_length);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending server init: %s",
-		    str_error(rc));
-		return;
-	}
+	return EOK;
+}
+
+/** Receive and handle messages of the client until it disconnects. */
+static void rfb_receive_messages(rfb_client_t *client)
+{
+	rfb_t *rfb = client->rfb;
+	tcp_conn_t *conn = client->conn;
+	errno_t rc;
 
 	while (true) {
 		char message_type = 0;
@@ -730,6 +1168,11 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 					    "Client supports TRLE encoding");
 					rfb->supports_trle = true;
 				}
+				if (encoding == RFB_ENCODING_COPYRECT) {
+					log_msg(LOG_DEFAULT, LVL_DEBUG,
+					    "Client supports CopyRect");
+					rfb->supports_copyrect = true;
+				}
 			}
 			break;
 		case RFB_CMSG_FRAMEBUFFER_UPDATE_REQUEST:
@@ -743,7 +1186,14 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 			rfb_framebuffer_update_request_to_host(&fbur, &fbur);
 			log_msg(LOG_DEFAULT, LVL_DEBUG2,
 			    "Received FramebufferUpdateRequest message");
-			rfb_send_framebuffer_update(rfb, conn, fbur.incremental);
+			fibril_mutex_lock(&rfb->lock);
+			if (client->update_requested)
+				client->update_incremental &= fbur.incremental;
+			else
+				client->update_incremental = fbur.incremental;
+			client->update_requested = true;
+			fibril_condvar_broadcast(&rfb->update_cv);
+			fibril_mutex_unlock(&rfb->lock);
 			break;
 		case RFB_CMSG_KEY_EVENT:
 			rc = recv_message(conn, message_type, &ke, sizeof(ke));
@@ -787,6 +1237,127 @@ static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
 	}
 }
 
+static void rfb_socket_connection(rfb_t *rfb, tcp_conn_t *conn)
+{
+	/* Version handshake */
+	errno_t rc = tcp_conn_send(conn, "RFB 003.008\n", 12);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending server version: %s",
+		    str_error(rc));
+		return;
+	}
+
+	char client_version[12];
+	rc = recv_chars(conn, client_version, 12);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client version: %s",
+		    str_error(rc));
+		return;
+	}
+
+	if (memcmp(client_version, "RFB 003.008\n", 12) != 0) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Client version is not RFB 3.8");
+		return;
+	}
+
+	/*
+	 * Security handshake
+	 * 1 security type supported, which is 1 - None
+	 */
+	char sec_types[2];
+	sec_types[0] = 1; /* length */
+	sec_types[1] = RFB_SECURITY_NONE;
+	rc = tcp_conn_send(conn, sec_types, 2);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN,
+		    "Failed sending security handshake: %s", str_error(rc));
+		return;
+	}
+
+	char selected_sec_type = 0;
+	rc = recv_char(conn, &selected_sec_type);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving security type: %s",
+		    str_error(rc));
+		return;
+	}
+	if (selected_sec_type != RFB_SECURITY_NONE) {
+		log_msg(LOG_DEFAULT, LVL_WARN,
+		    "Client selected security type other than none");
+		return;
+	}
+	uint32_t security_result = RFB_SECURITY_HANDSHAKE_OK;
+	rc = tcp_conn_send(conn, &security_result, sizeof(uint32_t));
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending security result: %s",
+		    str_error(rc));
+		return;
+	}
+
+	/* Client init */
+	char shared_flag;
+	rc = recv_char(conn, &shared_flag);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed receiving client init: %s",
+		    str_error(rc));
+		return;
+	}
+
+	/* Server init */
+	fibril_mutex_lock(&rfb->lock);
+	size_t name_length = str_length(rfb->name);
+	size_t msg_length = sizeof(rfb_server_init_t) + name_length;
+	rfb_server_init_t *server_init = malloc(msg_length);
+	if (server_init == NULL) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Cannot allocate memory for server init");
+		fibril_mutex_unlock(&rfb->lock);
+		return;
+	}
+	server_init->width = rfb->width;
+	server_init->height = rfb->height;
+	server_init->pixel_format = rfb->pixel_format;
+	server_init->name_length = name_length;
+	rfb_server_init_to_be(server_init, server_init);
+	memcpy(server_init->name, rfb->name, name_length);
+	fibril_mutex_unlock(&rfb->lock);
+	rc = tcp_conn_send(conn, server_init, msg_length);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed sending server init: %s",
+		    str_error(rc));
+		return;
+	}
+
+	/*
+	 * Updates are encoded and sent by a separate fibril, so that a slow
+	 * client does not delay receiving its messages.
+	 */
+	rfb_client_t client = {
+		.rfb = rfb,
+		.conn = conn,
+		.update_requested = false,
+		.update_incremental = false,
+		.closing = false,
+		.encoder_done = false
+	};
+
+	fid_t encoder = fibril_create(rfb_encoder, &client);
+	if (encoder == 0) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Cannot create encoder fibril");
+		return;
+	}
+
+	fibril_add_ready(encoder);
+
+	rfb_receive_messages(&client);
+
+	fibril_mutex_lock(&rfb->lock);
+	client.closing = true;
+	fibril_condvar_broadcast(&rfb->update_cv);
+	while (!client.encoder_done)
+		fibril_condvar_wait(&rfb->update_cv, &rfb->lock);
+	fibril_mutex_unlock(&rfb->lock);
+}
+
 errno_t rfb_listen(rfb_t *rfb, uint16_t port)
 {
 	tcp_t *tcp = NULL;
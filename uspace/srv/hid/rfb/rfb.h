@@ -49,10 +49,18 @@
 #define RFB_SMSG_SERVER_CUT_TEXT 3
 
 #define RFB_ENCODING_RAW 0
+#define RFB_ENCODING_COPYRECT 1
 #define RFB_ENCODING_TRLE 15
 
 #define RFB_TILE_ENCODING_RAW 0
 #define RFB_TILE_ENCODING_SOLID 1
+#define RFB_TILE_ENCODING_RLE 128
+
+/** Size of the tiles the framebuffer is divided into */
+#define RFB_TILE_SIZE 16
+
+/** Maximum number of colors of a palette encoded tile */
+#define RFB_TILE_PALETTE_MAX 16
 
 typedef struct {
 	uint8_t bpp;
@@ -146,6 +154,19 @@ typedef struct {
 	uint16_t blue;
 } __attribute__((packed)) rfb_color_map_entry_t;
 
+typedef struct {
+	uint16_t src_x;
+	uint16_t src_y;
+} __attribute__((packed)) rfb_copyrect_t;
+
+/** Tile of the framebuffer */
+typedef struct {
+	uint64_t hash;      /**< Hash of the contents sent to the client */
+	uint64_t new_hash;  /**< Hash of the contents to be sent */
+	uint8_t state;      /**< State in the update being prepared */
+	uint16_t src_row;   /**< Source tile row of a copied tile */
+} rfb_tile_t;
+
 typedef struct {
 	uint16_t width;
 	uint16_t height;
@@ -157,9 +178,15 @@ typedef struct {
 	rfb_rectangle_t damage_rect;
 	bool damage_valid;
 	fibril_mutex_t lock;
+	fibril_condvar_t update_cv;
+	rfb_tile_t *tiles;
+	size_t tile_cols;
+	size_t tile_rows;
+	bool tiles_valid;
 	pixel_t *palette;
 	size_t palette_used;
 	bool supports_trle;
+	bool supports_copyrect;
 } rfb_t;
 
 extern errno_t rfb_init(rfb_t *, uint16_t, uint16_t, const char *);
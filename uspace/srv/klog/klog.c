@@ -37,6 +37,7 @@
 #include <stdio.h>
 #include <async.h>
 #include <as.h>
+#include <barrier.h>
 #include <ddi.h>
 #include <errno.h>
 #include <str_error.h>
@@ -44,15 +45,15 @@
 #include <sysinfo.h>
 #include <stdlib.h>
 #include <fibril_synch.h>
+#include <macros.h>
 #include <adt/list.h>
 #include <adt/prodcons.h>
 #include <io/log.h>
 #include <io/logctl.h>
+#include <abi/log.h>
 
 #define NAME  "klog"
 
-typedef size_t __attribute__((aligned(1))) unaligned_size_t;
-
 typedef struct {
 	size_t entry_len;
 	uint32_t serial;
@@ -71,9 +72,12 @@ typedef struct {
 
 static prodcons_t pc;
 
-/* Pointer to buffer where kernel stores new entries */
-#define BUFFER_SIZE PAGE_SIZE
-static void *buffer;
+/* Kernel log ring mapped read-only from the kernel */
+static klog_ring_t *ring;
+static uint8_t *ring_data;
+
+/* Position of the next entry to read from the ring */
+static uint64_t ring_pos;
 
 /* Notification mutex */
 static FIBRIL_MUTEX_INITIALIZE(mtx);
@@ -88,52 +92,130 @@ static const char *facility_name[] = {
 #define facility_len (sizeof(facility_name) / sizeof(const char *))
 static log_t facility_ctx[facility_len];
 
-/** Klog producer
+/** Copy data from the kernel log ring.
+ *
+ * @param dst Destination buffer.
+ * @param pos Position of the data in the ring.
+ * @param len Number of bytes to copy.
+ *
+ */
+static void ring_copy(void *dst, uint64_t pos, size_t len)
+{
+	size_t offset = pos % ring->size;
+	size_t chunk = min(len, ring->size - offset);
+
+	memcpy(dst, ring_data + offset, chunk);
+	memcpy((uint8_t *) dst + chunk, ring_data, len - chunk);
+}
+
+/** Check whether the kernel has overwritten data at a position.
  *
- * Copies the log entries to a producer/consumer queue.
+ * @param pos Position in the ring.
  *
- * @param length Number of characters to copy.
- * @param data   Pointer to the kernel klog buffer.
+ * @return True if the data at @a pos are no longer valid.
+ *
+ */
+static bool ring_lost(uint64_t pos)
+{
+	read_barrier();
+	return (int64_t) (ring->tail - pos) > 0;
+}
+
+/** Klog producer
+ *
+ * Copies all new log entries from the kernel log ring to
+ * a producer/consumer queue.
  *
  */
 static void producer(void)
 {
-	size_t len = 0;
-	errno_t rc = klog_read(buffer, BUFFER_SIZE, &len);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "klog_read failed, rc = %s",
-		    str_error_name(rc));
-		return;
+	bool overrun = false;
+	uint64_t head = ring->head;
+	read_barrier();
+
+	if (ring_lost(ring_pos)) {
+		ring_pos = ring->tail;
+		overrun = true;
 	}
 
-	size_t offset = 0;
-	while (offset < len) {
-		size_t entry_len = *((unaligned_size_t *) (buffer + offset));
+	while (ring_pos < head) {
+		size_t entry_len;
+		ring_copy(&entry_len, ring_pos, sizeof(entry_len));
 
-		if (offset + entry_len > len || entry_len < sizeof(log_entry_t))
+		if (ring_lost(ring_pos)) {
+			ring_pos = ring->tail;
+			overrun = true;
+			continue;
+		}
+
+		if (entry_len < sizeof(log_entry_t) ||
+		    entry_len > head - ring_pos) {
+			/* Cannot happen with consistent data, resynchronize */
+			ring_pos = head;
+			overrun = true;
 			break;
+		}
 
 		log_entry_t *buf = malloc(entry_len + 1);
 		if (buf == NULL)
 			break;
 
+		ring_copy(buf, ring_pos, entry_len);
+		if (ring_lost(ring_pos)) {
+			free(buf);
+			ring_pos = ring->tail;
+			overrun = true;
+			continue;
+		}
+
 		item_t *item = malloc(sizeof(item_t));
 		if (item == NULL) {
 			free(buf);
 			break;
 		}
 
-		memcpy(buf, buffer + offset, entry_len);
 		*((uint8_t *) buf + entry_len) = 0;
 		link_initialize(&item->link);
 		item->size = entry_len;
 		item->data = buf;
 		prodcons_produce(&pc, &item->link);
 
-		offset += entry_len;
+		ring_pos += entry_len;
+	}
+
+	if (overrun) {
+		log_msg(LOG_DEFAULT, LVL_WARN,
+		    "Kernel log overrun, some messages were lost");
 	}
 }
 
+/** Map the kernel log ring.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t ring_map(void)
+{
+	sysarg_t faddr;
+	errno_t rc = sysinfo_get_value("klog.faddr", &faddr);
+	if (rc != EOK)
+		return rc;
+
+	sysarg_t pages;
+	rc = sysinfo_get_value("klog.pages", &pages);
+	if (rc != EOK)
+		return rc;
+
+	rc = physmem_map(faddr, pages, AS_AREA_READ | AS_AREA_CACHEABLE,
+	    (void *) &ring);
+	if (rc != EOK)
+		return rc;
+
+	ring_data = (uint8_t *) ring + PAGE_SIZE;
+	ring_pos = ring->tail;
+	return EOK;
+}
+
 /** Klog consumer
  *
  * Waits in an infinite loop for the log data created by
@@ -219,10 +301,11 @@ int main(int argc, char *argv[])
 		facility_ctx[i] = log_create(facility_name[i], kernel_ctx);
 	}
 
-	buffer = malloc(BUFFER_SIZE);
-	if (buffer == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Unable to allocate buffer");
-		return 1;
+	rc = ring_map();
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR,
+		    "Unable to map kernel log: %s", str_error(rc));
+		return rc;
 	}
 
 	prodcons_initialize(&pc);
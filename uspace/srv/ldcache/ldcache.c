@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup ldcache
+ * @brief Cache of read-only program segment images.
+ * @{
+ */
+/**
+ * @file
+ *
+ * Every task is started by a fresh program loader which maps the program
+ * and its shared libraries by reading their segments from the file system.
+ * The read-only segments (code and constant data) are identical in every
+ * task, so this server keeps one copy of each and shares it into the
+ * loading tasks, which saves the file system reads and the memory for
+ * private copies.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <align.h>
+#include <as.h>
+#include <async.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <ipc/ldcache.h>
+#include <ipc/services.h>
+#include <ns.h>
+#include <smc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <task.h>
+#include <vfs/vfs.h>
+
+#define NAME  "ldcache"
+
+/** Upper limit on the total size of the cached images */
+#define LDCACHE_MAX_SIZE  (32 * 1024 * 1024)
+
+/** Identification of a segment image */
+typedef struct {
+	service_id_t service_id;
+	fs_index_t index;
+	/** File size, to notice files rewritten in place */
+	aoff64_t file_size;
+	ldcache_seg_t seg;
+} ldcache_key_t;
+
+/** Cached segment image */
+typedef struct {
+	ht_link_t link;
+	ldcache_key_t key;
+	/** Base of the address space area with the image */
+	void *image;
+} ldcache_entry_t;
+
+static hash_table_t cache;
+static FIBRIL_MUTEX_INITIALIZE(cache_lock);
+static size_t cache_size;
+
+static size_t ldcache_key_hash(const void *arg)
+{
+	const ldcache_key_t *key = arg;
+	size_t hash;
+
+	hash = hash_mix(key->service_id);
+	hash = hash_combine(hash, hash_mix(key->index));
+	hash = hash_combine(hash, hash_mix(key->seg.offset));
+	return hash_combine(hash, hash_mix(key->seg.memsz));
+}
+
+static size_t ldcache_hash(const ht_link_t *item)
+{
+	ldcache_entry_t *entry = hash_table_get_inst(item, ldcache_entry_t,
+	    link);
+	return ldcache_key_hash(&entry->key);
+}
+
+static bool ldcache_key_equal(const void *arg, const ht_link_t *item)
+{
+	const ldcache_key_t *key = arg;
+	ldcache_entry_t *entry = hash_table_get_inst(item, ldcache_entry_t,
+	    link);
+
+	return key->service_id == entry->key.service_id &&
+	    key->index == entry->key.index &&
+	    key->file_size == entry->key.file_size &&
+	    key->seg.offset == entry->key.seg.offset &&
+	    key->seg.filesz == entry->key.seg.filesz &&
+	    key->seg.memsz == entry->key.seg.memsz &&
+	    key->seg.pgoff == entry->key.seg.pgoff &&
+	    key->seg.flags == entry->key.seg.flags;
+}
+
+static hash_table_ops_t ldcache_ops = {
+	.hash = ldcache_hash,
+	.key_hash = ldcache_key_hash,
+	.key_equal = ldcache_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Create a segment image.
+ *
+ * @param fd   File to read the segment from.
+ * @param key  Segment identification.
+ * @param size Size of the image in bytes.
+ *
+ * @return Base of the new address space area or AS_MAP_FAILED.
+ */
+static void *ldcache_image_create(int fd, ldcache_key_t *key, size_t size)
+{
+	void *image = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (image == AS_MAP_FAILED)
+		return AS_MAP_FAILED;
+
+	uint8_t *seg_ptr = (uint8_t *) image + key->seg.pgoff;
+	aoff64_t pos = key->seg.offset;
+	size_t nr;
+
+	errno_t rc = vfs_read(fd, &pos, seg_ptr, key->seg.filesz, &nr);
+	if (rc != EOK || nr != key->seg.filesz)
+		goto error;
+
+	rc = as_area_change_flags(image, key->seg.flags);
+	if (rc != EOK)
+		goto error;
+
+	if ((key->seg.flags & AS_AREA_EXEC) != 0 &&
+	    smc_coherence(seg_ptr, key->seg.filesz) != EOK)
+		goto error;
+
+	return image;
+error:
+	as_area_destroy(image);
+	return AS_MAP_FAILED;
+}
+
+/** Handle a request to map a segment image.
+ *
+ * The request is followed by a data write with the segment description,
+ * the handle of the file containing the segment and a share-in of the
+ * image.
+ */
+static void ldcache_map_segment_srv(ipc_call_t *req)
+{
+	ldcache_key_t key;
+	ipc_call_t call;
+	size_t len;
+	int fd;
+
+	if (!async_data_write_receive(&call, &len) ||
+	    len != sizeof(ldcache_seg_t)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		return;
+	}
+
+	errno_t rc = async_data_write_finalize(&call, &key.seg,
+	    sizeof(ldcache_seg_t));
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		return;
+	}
+
+	rc = vfs_receive_handle(true, &fd);
+	if (rc != EOK) {
+		async_answer_0(req, rc);
+		return;
+	}
+
+	size_t size;
+	if (!async_share_in_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(req, EINVAL);
+		vfs_put(fd);
+		return;
+	}
+
+	vfs_stat_t stat;
+	rc = vfs_stat(fd, &stat);
+	if (rc != EOK)
+		goto error;
+
+	/* Refuse writable mappings and inconsistent segment descriptions. */
+	if ((key.seg.flags & AS_AREA_WRITE) != 0 ||
+	    key.seg.pgoff >= PAGE_SIZE || key.seg.filesz > key.seg.memsz ||
+	    key.seg.offset > stat.size ||
+	    key.seg.filesz > stat.size - key.seg.offset ||
+	    size != (size_t) ALIGN_UP(key.seg.pgoff + key.seg.memsz,
+	    PAGE_SIZE)) {
+		rc = EINVAL;
+		goto error;
+	}
+
+	key.service_id = stat.service_id;
+	key.index = stat.index;
+	key.file_size = stat.size;
+
+	fibril_mutex_lock(&cache_lock);
+
+	ldcache_entry_t *entry = NULL;
+	ht_link_t *link = hash_table_find(&cache, &key);
+	if (link != NULL) {
+		entry = hash_table_get_inst(link, ldcache_entry_t, link);
+		rc = async_share_in_finalize(&call, entry->image,
+		    key.seg.flags);
+		fibril_mutex_unlock(&cache_lock);
+		vfs_put(fd);
+		async_answer_0(req, rc);
+		return;
+	}
+
+	void *image = ldcache_image_create(fd, &key, size);
+	if (image == AS_MAP_FAILED) {
+		fibril_mutex_unlock(&cache_lock);
+		rc = ENOMEM;
+		goto error;
+	}
+
+	if (cache_size + size <= LDCACHE_MAX_SIZE)
+		entry = malloc(sizeof(ldcache_entry_t));
+
+	if (entry != NULL) {
+		entry->key = key;
+		entry->image = image;
+		hash_table_insert(&cache, &entry->link);
+		cache_size += size;
+	}
+
+	rc = async_share_in_finalize(&call, image, key.seg.flags);
+
+	/* Images that did not fit into the cache are owned by the client. */
+	if (entry == NULL)
+		as_area_destroy(image);
+
+	fibril_mutex_unlock(&cache_lock);
+	vfs_put(fd);
+	async_answer_0(req, rc);
+	return;
+error:
+	async_answer_0(&call, rc);
+	vfs_put(fd);
+	async_answer_0(req, rc);
+}
+
+static void ldcache_client_conn(ipc_call_t *icall, void *arg)
+{
+	/* Accept the connection */
+	async_accept_0(icall);
+
+	while (true) {
+		ipc_call_t call;
+		async_get_call(&call);
+		sysarg_t method = ipc_get_imethod(&call);
+
+		if (!method) {
+			/* The other side has hung up */
+			async_answer_0(&call, EOK);
+			return;
+		}
+
+		switch (method) {
+		case LDCACHE_MAP_SEGMENT:
+			ldcache_map_segment_srv(&call);
+			break;
+		default:
+			async_answer_0(&call, ENOTSUP);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	printf("%s: Program segment cache\n", NAME);
+
+	if (!hash_table_create(&cache, 0, 0, &ldcache_ops)) {
+		printf("%s: Out of memory.\n", NAME);
+		return -1;
+	}
+
+	errno_t rc = service_register(SERVICE_LDCACHE, INTERFACE_LDCACHE,
+	    ldcache_client_conn, NULL);
+	if (rc != EOK) {
+		printf("%s: Failed registering service: %s.\n", NAME,
+		    str_error(rc));
+		return -1;
+	}
+
+	task_retval(0);
+	async_manager();
+
+	/* Never reached */
+	return 0;
+}
+
+/** @}
+ */
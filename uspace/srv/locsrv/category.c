@@ -89,6 +89,7 @@ static void category_init(category_t *cat, const char *name)
 	cat->id = loc_create_id();
 	link_initialize(&cat->cat_list);
 	list_initialize(&cat->svc_memb);
+	cat->svc_cnt = 0;
 }
 
 /** Allocate new category. */
@@ -110,9 +111,12 @@ errno_t category_add_service(category_t *cat, loc_service_t *svc)
 	assert(fibril_mutex_is_locked(&cat->mutex));
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	/* Verify that category does not contain this service yet. */
-	list_foreach(cat->svc_memb, cat_link, svc_categ_t, memb) {
-		if (memb->svc == svc) {
+	/*
+	 * Verify that category does not contain this service yet. A service
+	 * belongs to a few categories, while a category can hold many services.
+	 */
+	list_foreach(svc->cat_memb, svc_link, svc_categ_t, memb) {
+		if (memb->cat == cat) {
 			return EEXIST;
 		}
 	}
@@ -126,6 +130,7 @@ errno_t category_add_service(category_t *cat, loc_service_t *svc)
 
 	list_append(&nmemb->cat_link, &cat->svc_memb);
 	list_append(&nmemb->svc_link, &svc->cat_memb);
+	cat->svc_cnt++;
 
 	return EOK;
 }
@@ -138,6 +143,7 @@ void category_remove_service(svc_categ_t *memb)
 
 	list_remove(&memb->cat_link);
 	list_remove(&memb->svc_link);
+	memb->cat->svc_cnt--;
 
 	free(memb);
 }
@@ -179,7 +185,7 @@ errno_t category_get_services(category_t *cat, service_id_t *id_buf,
 
 	buf_cnt = buf_size / sizeof(service_id_t);
 
-	act_cnt = list_count(&cat->svc_memb);
+	act_cnt = cat->svc_cnt;
 	*act_size = act_cnt * sizeof(service_id_t);
 
 	if (buf_size % sizeof(service_id_t) != 0)
@@ -56,6 +56,9 @@ typedef struct {
 
 	/** List of service memberships in this category (svc_categ_t) */
 	list_t svc_memb;
+
+	/** Number of services in this category */
+	size_t svc_cnt;
 } category_t;
 
 /** Service directory ogranized by categories (yellow pages) */
@@ -35,6 +35,8 @@
 /** @file
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <ipc/services.h>
 #include <ns.h>
 #include <async.h>
@@ -65,6 +67,11 @@ LIST_INITIALIZE(services_list);
 LIST_INITIALIZE(namespaces_list);
 LIST_INITIALIZE(servers_list);
 
+/** Services indexed by ID and by namespace and name, namespaces by ID */
+static hash_table_t services_by_id;
+static hash_table_t services_by_name;
+static hash_table_t namespaces_by_id;
+
 /*
  * Locking order:
  *  servers_list_mutex
@@ -180,6 +187,110 @@ static bool loc_fqsn_split(const char *fqsn, char **ns_name, char **name)
 	return true;
 }
 
+/** Service lookup key by namespace and name */
+typedef struct {
+	const char *ns_name;
+	const char *name;
+} loc_service_key_t;
+
+static size_t loc_id_key_hash(const void *key)
+{
+	const service_id_t *id = key;
+	return hash_mix(*id);
+}
+
+static size_t loc_name_key_hash(const void *key)
+{
+	const loc_service_key_t *skey = key;
+	size_t hash = 0;
+	const char *cp;
+
+	for (cp = skey->ns_name; *cp != '\0'; cp++)
+		hash = hash_combine(hash, (unsigned char) *cp);
+	/* Separate the namespace from the name */
+	hash = hash_combine(hash, '/');
+	for (cp = skey->name; *cp != '\0'; cp++)
+		hash = hash_combine(hash, (unsigned char) *cp);
+
+	return hash_mix(hash);
+}
+
+static size_t services_by_id_hash(const ht_link_t *item)
+{
+	loc_service_t *service = hash_table_get_inst(item, loc_service_t,
+	    id_link);
+	return loc_id_key_hash(&service->id);
+}
+
+static bool services_by_id_key_equal(const void *key, const ht_link_t *item)
+{
+	const service_id_t *id = key;
+	loc_service_t *service = hash_table_get_inst(item, loc_service_t,
+	    id_link);
+	return service->id == *id;
+}
+
+static size_t services_by_name_hash(const ht_link_t *item)
+{
+	loc_service_t *service = hash_table_get_inst(item, loc_service_t,
+	    name_link);
+	loc_service_key_t key = {
+		.ns_name = service->namespace->name,
+		.name = service->name
+	};
+	return loc_name_key_hash(&key);
+}
+
+static bool services_by_name_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const loc_service_key_t *skey = key;
+	loc_service_t *service = hash_table_get_inst(item, loc_service_t,
+	    name_link);
+	return (str_cmp(service->namespace->name, skey->ns_name) == 0) &&
+	    (str_cmp(service->name, skey->name) == 0);
+}
+
+static size_t namespaces_by_id_hash(const ht_link_t *item)
+{
+	loc_namespace_t *namespace = hash_table_get_inst(item,
+	    loc_namespace_t, id_link);
+	return loc_id_key_hash(&namespace->id);
+}
+
+static bool namespaces_by_id_key_equal(const void *key,
+    const ht_link_t *item)
+{
+	const service_id_t *id = key;
+	loc_namespace_t *namespace = hash_table_get_inst(item,
+	    loc_namespace_t, id_link);
+	return namespace->id == *id;
+}
+
+static hash_table_ops_t services_by_id_ops = {
+	.hash = services_by_id_hash,
+	.key_hash = loc_id_key_hash,
+	.key_equal = services_by_id_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static hash_table_ops_t services_by_name_ops = {
+	.hash = services_by_name_hash,
+	.key_hash = loc_name_key_hash,
+	.key_equal = services_by_name_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static hash_table_ops_t namespaces_by_id_ops = {
+	.hash = namespaces_by_id_hash,
+	.key_hash = loc_id_key_hash,
+	.key_equal = namespaces_by_id_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
 /** Find namespace with given name. */
 static loc_namespace_t *loc_namespace_find_name(const char *name)
 {
@@ -193,21 +304,16 @@ static loc_namespace_t *loc_namespace_find_name(const char *name)
 	return NULL;
 }
 
-/** Find namespace with given ID.
- *
- * @todo: use hash table
- *
- */
+/** Find namespace with given ID. */
 static loc_namespace_t *loc_namespace_find_id(service_id_t id)
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(namespaces_list, namespaces, loc_namespace_t, namespace) {
-		if (namespace->id == id)
-			return namespace;
-	}
+	ht_link_t *link = hash_table_find(&namespaces_by_id, &id);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, loc_namespace_t, id_link);
 }
 
 /** Find service with given name. */
@@ -216,30 +322,38 @@ static loc_service_t *loc_service_find_name(const char *ns_name,
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(services_list, services, loc_service_t, service) {
-		if ((str_cmp(service->namespace->name, ns_name) == 0) &&
-		    (str_cmp(service->name, name) == 0))
-			return service;
-	}
+	loc_service_key_t key = {
+		.ns_name = ns_name,
+		.name = name
+	};
 
-	return NULL;
+	ht_link_t *link = hash_table_find(&services_by_name, &key);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, loc_service_t, name_link);
 }
 
-/** Find service with given ID.
- *
- * @todo: use hash table
- *
- */
+/** Find service with given ID. */
 static loc_service_t *loc_service_find_id(service_id_t id)
 {
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 
-	list_foreach(services_list, services, loc_service_t, service) {
-		if (service->id == id)
-			return service;
-	}
+	ht_link_t *link = hash_table_find(&services_by_id, &id);
+	if (link == NULL)
+		return NULL;
 
-	return NULL;
+	return hash_table_get_inst(link, loc_service_t, id_link);
+}
+
+/** Insert service into the list of all services and its indexes. */
+static void loc_service_insert(loc_service_t *service)
+{
+	assert(fibril_mutex_is_locked(&services_list_mutex));
+
+	list_append(&service->services, &services_list);
+	hash_table_insert(&services_by_id, &service->id_link);
+	hash_table_insert(&services_by_name, &service->name_link);
 }
 
 /** Create a namespace (if not already present). */
@@ -270,6 +384,7 @@ static loc_namespace_t *loc_namespace_create(const char *ns_name)
 	 * Insert new namespace into list of registered namespaces
 	 */
 	list_append(&(namespace->namespaces), &namespaces_list);
+	hash_table_insert(&namespaces_by_id, &namespace->id_link);
 
 	return namespace;
 }
@@ -281,6 +396,7 @@ static void loc_namespace_destroy(loc_namespace_t *namespace)
 
 	if (namespace->refcnt == 0) {
 		list_remove(&(namespace->namespaces));
+		hash_table_remove_item(&namespaces_by_id, &namespace->id_link);
 
 		free(namespace->name);
 		free(namespace);
@@ -312,8 +428,11 @@ static void loc_service_unregister_core(loc_service_t *service)
 	assert(fibril_mutex_is_locked(&services_list_mutex));
 	assert(fibril_mutex_is_locked(&cdir.mutex));
 
-	loc_namespace_delref(service->namespace);
+	/* The name index hashes the namespace name, remove it first */
+	hash_table_remove_item(&services_by_name, &service->name_link);
+	hash_table_remove_item(&services_by_id, &service->id_link);
 	list_remove(&(service->services));
+	loc_namespace_delref(service->namespace);
 	list_remove(&(service->server_services));
 
 	/* Remove service from all categories. */
@@ -524,7 +643,7 @@ static void loc_service_register(ipc_call_t *icall, loc_server_t *server)
 	service->server = server;
 
 	/* Insert service into list of all services  */
-	list_append(&service->services, &services_list);
+	loc_service_insert(service);
 
 	/* Insert service into list of services supplied by one server */
 	fibril_mutex_lock(&service->server->services_mutex);
@@ -1212,7 +1331,7 @@ static void loc_null_create(ipc_call_t *icall)
 
 	loc_namespace_t *namespace = loc_namespace_create("null");
 	if (namespace == NULL) {
-		fibril_mutex_lock(&services_list_mutex);
+		fibril_mutex_unlock(&services_list_mutex);
 		fibril_mutex_unlock(&null_services_mutex);
 		async_answer_0(icall, ENOMEM);
 		return;
@@ -1234,7 +1353,7 @@ static void loc_null_create(ipc_call_t *icall)
 	 * Insert service into a dummy list of null server's services so that it
 	 * can be safely removed later.
 	 */
-	list_append(&service->services, &services_list);
+	loc_service_insert(service);
 	list_append(&service->server_services, &dummy_null_services);
 	null_services[i] = service;
 
@@ -1324,6 +1443,15 @@ static bool loc_init(void)
 	for (i = 0; i < NULL_SERVICES; i++)
 		null_services[i] = NULL;
 
+	if (!hash_table_create(&services_by_id, 0, 0, &services_by_id_ops) ||
+	    !hash_table_create(&services_by_name, 0, 0,
+	    &services_by_name_ops) ||
+	    !hash_table_create(&namespaces_by_id, 0, 0,
+	    &namespaces_by_id_ops)) {
+		printf("%s: Error while creating service indexes\n", NAME);
+		return false;
+	}
+
 	categ_dir_init(&cdir);
 
 	cat = category_new("disk");
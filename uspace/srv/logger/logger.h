@@ -54,10 +54,27 @@
 
 typedef struct logger_log logger_log_t;
 
+/** Size of the write behind buffer of a log file (in bytes). */
+#define LOG_BUFFER_SIZE 16384
+
+/** How often buffered records are written to the log files. */
+#define LOG_FLUSH_PERIOD_USEC 200000
+
+/** Log files are synced to the disk every this many flush periods. */
+#define LOG_SYNC_PERIODS 25
+
 typedef struct {
+	/** Link in the list of all destinations. */
+	link_t link;
 	fibril_mutex_t guard;
 	char *filename;
 	FILE *logfile;
+	/** Write behind buffer of @c logfile. */
+	char *buffer;
+	/** There are records not yet written to the file. */
+	bool dirty;
+	/** There are records not yet synced to the disk. */
+	bool unsynced;
 } logger_dest_t;
 
 struct logger_log {
@@ -84,6 +101,7 @@ typedef struct {
 logger_log_t *find_log_by_name_and_lock(const char *name);
 logger_log_t *find_or_create_log_and_lock(const char *, sysarg_t);
 logger_log_t *find_log_by_id_and_lock(sysarg_t);
+log_level_t get_log_level(logger_log_t *);
 bool shall_log_message(logger_log_t *, log_level_t);
 void log_unlock(logger_log_t *);
 void write_to_log(logger_log_t *, log_level_t, const char *);
@@ -93,6 +111,8 @@ void registered_logs_init(logger_registered_logs_t *);
 bool register_log(logger_registered_logs_t *, logger_log_t *);
 void unregister_logs(logger_registered_logs_t *);
 
+errno_t log_flusher_start(void);
+
 log_level_t get_default_logging_level(void);
 errno_t set_default_logging_level(log_level_t);
 
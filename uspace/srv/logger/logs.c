@@ -31,14 +31,23 @@
  */
 #include <assert.h>
 #include <errno.h>
+#include <fibril.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
+#include <vfs/vfs.h>
 #include "logger.h"
 
 static FIBRIL_MUTEX_INITIALIZE(log_list_guard);
 static LIST_INITIALIZE(log_list);
 
+/*
+ * Lock ordering: dest_list_guard is always taken before the guard
+ * of an individual destination.
+ */
+static FIBRIL_MUTEX_INITIALIZE(dest_list_guard);
+static LIST_INITIALIZE(dest_list);
+
 static logger_log_t *find_log_by_name_and_parent_no_list_lock(const char *name, logger_log_t *parent)
 {
 	list_foreach(log_list, link, logger_log_t, log) {
@@ -59,11 +68,102 @@ static errno_t create_dest(const char *name, logger_dest_t **dest)
 		return ENOMEM;
 	}
 	result->logfile = NULL;
+	result->buffer = NULL;
+	result->dirty = false;
+	result->unsynced = false;
 	fibril_mutex_initialize(&result->guard);
+	link_initialize(&result->link);
+
+	fibril_mutex_lock(&dest_list_guard);
+	list_append(&result->link, &dest_list);
+	fibril_mutex_unlock(&dest_list_guard);
+
 	*dest = result;
 	return EOK;
 }
 
+/** Write buffered records of a destination to its file.
+ *
+ * Precondition: dest is locked.
+ *
+ * @param dest Destination to flush.
+ * @param sync Whether to sync the file to the disk as well.
+ */
+static void dest_flush(logger_dest_t *dest, bool sync)
+{
+	assert(fibril_mutex_is_locked(&dest->guard));
+
+	if (dest->logfile == NULL)
+		return;
+
+	if (dest->dirty) {
+		fflush(dest->logfile);
+		dest->dirty = false;
+		dest->unsynced = true;
+	}
+
+	if (sync && dest->unsynced) {
+		(void) vfs_sync(fileno(dest->logfile));
+		dest->unsynced = false;
+	}
+}
+
+static void destroy_dest(logger_dest_t *dest)
+{
+	fibril_mutex_lock(&dest_list_guard);
+	list_remove(&dest->link);
+	fibril_mutex_unlock(&dest_list_guard);
+
+	/*
+	 * Due to lazy file opening in write_to_log(),
+	 * it is possible that no file was actually opened.
+	 */
+	if (dest->logfile != NULL)
+		fclose(dest->logfile);
+
+	free(dest->buffer);
+	free(dest->filename);
+	free(dest);
+}
+
+/** Periodically write buffered records of all destinations. */
+static errno_t log_flusher(void *arg)
+{
+	unsigned periods = 0;
+
+	while (true) {
+		fibril_usleep(LOG_FLUSH_PERIOD_USEC);
+
+		bool sync = ++periods >= LOG_SYNC_PERIODS;
+		if (sync)
+			periods = 0;
+
+		fibril_mutex_lock(&dest_list_guard);
+		list_foreach(dest_list, link, logger_dest_t, dest) {
+			fibril_mutex_lock(&dest->guard);
+			dest_flush(dest, sync);
+			fibril_mutex_unlock(&dest->guard);
+		}
+		fibril_mutex_unlock(&dest_list_guard);
+	}
+
+	return EOK;
+}
+
+/** Start the fibril writing buffered log records to the files.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t log_flusher_start(void)
+{
+	fid_t fid = fibril_create(log_flusher, NULL);
+	if (fid == 0)
+		return ENOMEM;
+
+	fibril_add_ready(fid);
+	return EOK;
+}
+
 static logger_log_t *create_log_no_locking(const char *name, logger_log_t *parent)
 {
 	logger_log_t *result = calloc(1, sizeof(logger_log_t));
@@ -183,14 +283,24 @@ static log_level_t get_actual_log_level(logger_log_t *log)
 	return log->logged_level;
 }
 
-bool shall_log_message(logger_log_t *log, log_level_t level)
+/** Get the level up to which messages are logged to the log.
+ *
+ * @param log Log to query.
+ * @return Effective log level of @p log.
+ */
+log_level_t get_log_level(logger_log_t *log)
 {
 	fibril_mutex_lock(&log_list_guard);
-	bool result = level <= get_actual_log_level(log);
+	log_level_t result = get_actual_log_level(log);
 	fibril_mutex_unlock(&log_list_guard);
 	return result;
 }
 
+bool shall_log_message(logger_log_t *log, log_level_t level)
+{
+	return level <= get_log_level(log);
+}
+
 void log_unlock(logger_log_t *log)
 {
 	assert(fibril_mutex_is_locked(&log->guard));
@@ -260,15 +370,7 @@ void log_release(logger_log_t *log)
 	fibril_mutex_unlock(&log->guard);
 
 	if (log->parent == NULL) {
-		/*
-		 * Due to lazy file opening in write_to_log(),
-		 * it is possible that no file was actually opened.
-		 */
-		if (log->dest->logfile != NULL) {
-			fclose(log->dest->logfile);
-		}
-		free(log->dest->filename);
-		free(log->dest);
+		destroy_dest(log->dest);
 	} else {
 		fibril_mutex_lock(&log->parent->guard);
 		log_release(log->parent);
@@ -282,22 +384,47 @@ void log_release(logger_log_t *log)
 	free(log);
 }
 
+/** Write a record to the log.
+ *
+ * The record is only stored into the write behind buffer of the log
+ * file, the file itself is written by the flusher fibril. Errors are
+ * written out immediately so that they survive a crash of the system.
+ *
+ * Precondition: log is locked.
+ *
+ * @param log Log to write to.
+ * @param level Severity level of the message.
+ * @param message The actual message.
+ */
 void write_to_log(logger_log_t *log, log_level_t level, const char *message)
 {
 	assert(fibril_mutex_is_locked(&log->guard));
 	assert(log->dest != NULL);
-	fibril_mutex_lock(&log->dest->guard);
-	if (log->dest->logfile == NULL)
-		log->dest->logfile = fopen(log->dest->filename, "a");
 
-	if (log->dest->logfile != NULL) {
-		fprintf(log->dest->logfile, "[%s] %s: %s\n",
+	logger_dest_t *dest = log->dest;
+	fibril_mutex_lock(&dest->guard);
+	if (dest->logfile == NULL) {
+		dest->logfile = fopen(dest->filename, "a");
+		if (dest->logfile != NULL && dest->buffer == NULL) {
+			dest->buffer = malloc(LOG_BUFFER_SIZE);
+			if (dest->buffer != NULL) {
+				setvbuf(dest->logfile, dest->buffer, _IOFBF,
+				    LOG_BUFFER_SIZE);
+			}
+		}
+	}
+
+	if (dest->logfile != NULL) {
+		fprintf(dest->logfile, "[%s] %s: %s\n",
 		    log->full_name, log_level_str(level),
 		    (const char *) message);
-		fflush(log->dest->logfile);
+		dest->dirty = true;
+
+		if (level <= LVL_ERROR)
+			dest_flush(dest, false);
 	}
 
-	fibril_mutex_unlock(&log->dest->guard);
+	fibril_mutex_unlock(&dest->guard);
 }
 
 void registered_logs_init(logger_registered_logs_t *logs)
@@ -65,7 +65,14 @@ int main(int argc, char *argv[])
 		parse_level_settings(argv[i]);
 	}
 
-	errno_t rc = service_register(SERVICE_LOGGER, INTERFACE_LOGGER_CONTROL,
+	errno_t rc = log_flusher_start();
+	if (rc != EOK) {
+		printf("%s: Failed to start log flusher: %s.\n", NAME,
+		    str_error(rc));
+		return -1;
+	}
+
+	rc = service_register(SERVICE_LOGGER, INTERFACE_LOGGER_CONTROL,
 	    connection_handler_control, NULL);
 	if (rc != EOK) {
 		printf("%s: Failed to register control port: %s.\n", NAME,
@@ -61,7 +61,15 @@ static logger_log_t *handle_create_log(sysarg_t parent)
 	return log;
 }
 
-static errno_t handle_receive_message(sysarg_t log_id, sysarg_t level)
+/** Receive a message and write it to the log.
+ *
+ * @param log_id Id of the log.
+ * @param level Severity level of the message.
+ * @param[out] log_level Where to store the effective level of the log.
+ * @return Error code.
+ */
+static errno_t handle_receive_message(sysarg_t log_id, sysarg_t level,
+    log_level_t *log_level)
 {
 	logger_log_t *log = find_log_by_id_and_lock(log_id);
 	if (log == NULL)
@@ -72,7 +80,8 @@ static errno_t handle_receive_message(sysarg_t log_id, sysarg_t level)
 	if (rc != EOK)
 		goto leave;
 
-	if (!shall_log_message(log, level)) {
+	*log_level = get_log_level(log);
+	if (level > *log_level) {
 		rc = EOK;
 		goto leave;
 	}
@@ -94,6 +103,7 @@ leave:
 void logger_connection_handler_writer(ipc_call_t *icall)
 {
 	logger_log_t *log;
+	log_level_t level;
 	errno_t rc;
 
 	/* Acknowledge the connection. */
@@ -125,13 +135,15 @@ void logger_connection_handler_writer(ipc_call_t *icall)
 				async_answer_0(&call, ELIMIT);
 				break;
 			}
+			level = get_log_level(log);
 			log_unlock(log);
-			async_answer_1(&call, EOK, (sysarg_t) log);
+			async_answer_2(&call, EOK, (sysarg_t) log, level);
 			break;
 		case LOGGER_WRITER_MESSAGE:
+			level = LVL_LIMIT;
 			rc = handle_receive_message(ipc_get_arg1(&call),
-			    ipc_get_arg2(&call));
-			async_answer_0(&call, rc);
+			    ipc_get_arg2(&call), &level);
+			async_answer_1(&call, rc, level);
 			break;
 		default:
 			async_answer_0(&call, EINVAL);
@@ -0,0 +1,477 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup dnsrsrv
+ * @{
+ */
+/**
+ * @file Resolver cache
+ *
+ * Positive and negative answers are cached for the time to live given
+ * by the name server. Identical queries issued while the first one is
+ * still in progress wait for its result instead of sending their own
+ * request.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <inet/dnsr.h>
+#include <io/log.h>
+#include <macros.h>
+#include <stdlib.h>
+#include <str.h>
+#include <time.h>
+#include "cache.h"
+#include "dns_std.h"
+#include "dns_type.h"
+
+/** Maximum number of cache entries.
+ *
+ * The whole cache must fit in a single data transfer when listed.
+ */
+#define DNS_CACHE_MAX_ENTRIES  100
+
+/** Maximum lifetime of a positive entry (seconds) */
+#define DNS_CACHE_TTL_MAX  (24 * 60 * 60)
+
+/** Maximum lifetime of a negative entry (seconds), see RFC 2308 */
+#define DNS_CACHE_NEG_TTL_MAX  (3 * 60 * 60)
+
+typedef struct {
+	const char *name;
+	dns_qtype_t qtype;
+} dns_cache_key_t;
+
+static size_t dns_cache_hash(const ht_link_t *);
+static size_t dns_cache_key_hash(const void *);
+static bool dns_cache_key_equal(const void *, const ht_link_t *);
+static bool dns_cache_equal(const ht_link_t *, const ht_link_t *);
+
+static hash_table_ops_t dns_cache_ops = {
+	.hash = dns_cache_hash,
+	.key_hash = dns_cache_key_hash,
+	.key_equal = dns_cache_key_equal,
+	.equal = dns_cache_equal,
+	.remove_callback = NULL
+};
+
+/** Cache entries by name and query type */
+static hash_table_t cache_map;
+/** Cache entries, most recently used first */
+static LIST_INITIALIZE(cache_lru);
+/** Number of cache entries */
+static size_t cache_count;
+/** Queries in progress */
+static LIST_INITIALIZE(cquery_list);
+static FIBRIL_MUTEX_INITIALIZE(cache_lock);
+/** Signalled when a query in progress completes */
+static FIBRIL_CONDVAR_INITIALIZE(cquery_cv);
+
+/** Case-insensitive hash of a name and query type. */
+static size_t dns_cache_name_hash(const char *name, dns_qtype_t qtype)
+{
+	size_t hash = qtype;
+	const char *cp;
+
+	for (cp = name; *cp != '\0'; cp++)
+		hash = hash_combine(hash, tolower((unsigned char) *cp));
+
+	return hash_mix(hash);
+}
+
+static size_t dns_cache_hash(const ht_link_t *item)
+{
+	dns_cache_entry_t *entry =
+	    hash_table_get_inst(item, dns_cache_entry_t, lhash);
+
+	return dns_cache_name_hash(entry->name, entry->qtype);
+}
+
+static size_t dns_cache_key_hash(const void *arg)
+{
+	const dns_cache_key_t *key = arg;
+
+	return dns_cache_name_hash(key->name, key->qtype);
+}
+
+static bool dns_cache_key_equal(const void *arg, const ht_link_t *item)
+{
+	const dns_cache_key_t *key = arg;
+	dns_cache_entry_t *entry =
+	    hash_table_get_inst(item, dns_cache_entry_t, lhash);
+
+	return entry->qtype == key->qtype &&
+	    str_casecmp(entry->name, key->name) == 0;
+}
+
+static bool dns_cache_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	dns_cache_entry_t *entry =
+	    hash_table_get_inst(item2, dns_cache_entry_t, lhash);
+	dns_cache_key_t key = {
+		.name = entry->name,
+		.qtype = entry->qtype
+	};
+
+	return dns_cache_key_equal(&key, item1);
+}
+
+/** Initialize resolver cache.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t dns_cache_init(void)
+{
+	if (!hash_table_create(&cache_map, 0, 0, &dns_cache_ops))
+		return ENOMEM;
+
+	return EOK;
+}
+
+/** Remove and destroy cache entry. */
+static void dns_cache_entry_remove(dns_cache_entry_t *entry)
+{
+	assert(fibril_mutex_is_locked(&cache_lock));
+
+	hash_table_remove_item(&cache_map, &entry->lhash);
+	list_remove(&entry->llru);
+	--cache_count;
+
+	free(entry->name);
+	free(entry->cname);
+	free(entry);
+}
+
+/** Add answer to the cache.
+ *
+ * @param name     Queried name
+ * @param qtype    Query type
+ * @param negative @c true to record that the name has no such address
+ * @param cname    Host canonical name (positive entry)
+ * @param addr     Host address (positive entry)
+ * @param ttl      Time to live in seconds
+ */
+static void dns_cache_insert(const char *name, dns_qtype_t qtype,
+    bool negative, const char *cname, inet_addr_t *addr, uint32_t ttl)
+{
+	dns_cache_key_t key;
+	dns_cache_entry_t *entry;
+	ht_link_t *link;
+
+	assert(fibril_mutex_is_locked(&cache_lock));
+
+	ttl = min(ttl, negative ? DNS_CACHE_NEG_TTL_MAX : DNS_CACHE_TTL_MAX);
+
+	key.name = name;
+	key.qtype = qtype;
+	link = hash_table_find(&cache_map, &key);
+	if (link != NULL) {
+		dns_cache_entry_remove(hash_table_get_inst(link,
+		    dns_cache_entry_t, lhash));
+	}
+
+	if (cache_count >= DNS_CACHE_MAX_ENTRIES) {
+		dns_cache_entry_remove(list_get_instance(list_last(&cache_lru),
+		    dns_cache_entry_t, llru));
+	}
+
+	entry = calloc(1, sizeof(dns_cache_entry_t));
+	if (entry == NULL)
+		return;
+
+	entry->name = str_dup(name);
+	if (entry->name == NULL) {
+		free(entry);
+		return;
+	}
+
+	entry->qtype = qtype;
+	entry->negative = negative;
+	if (!negative) {
+		entry->cname = str_dup(cname);
+		if (entry->cname == NULL) {
+			free(entry->name);
+			free(entry);
+			return;
+		}
+
+		entry->addr = *addr;
+	}
+
+	getuptime(&entry->expires);
+	ts_add_diff(&entry->expires, SEC2NSEC(ttl));
+
+	hash_table_insert(&cache_map, &entry->lhash);
+	list_prepend(&entry->llru, &cache_lru);
+	++cache_count;
+}
+
+/** Fill in host information from cached data. */
+static errno_t dns_cache_fill_info(dns_host_info_t *info, const char *cname,
+    inet_addr_t *addr)
+{
+	info->cname = str_dup(cname);
+	if (info->cname == NULL)
+		return ENOMEM;
+
+	info->addr = *addr;
+	return EOK;
+}
+
+/** Find query in progress. */
+static dns_cquery_t *dns_cquery_find(const char *name, dns_qtype_t qtype)
+{
+	assert(fibril_mutex_is_locked(&cache_lock));
+
+	list_foreach(cquery_list, lqueries, dns_cquery_t, cquery) {
+		if (cquery->qtype == qtype &&
+		    str_casecmp(cquery->name, name) == 0)
+			return cquery;
+	}
+
+	return NULL;
+}
+
+/** Drop reference to query in progress. */
+static void dns_cquery_release(dns_cquery_t *cquery)
+{
+	assert(fibril_mutex_is_locked(&cache_lock));
+	assert(cquery->refcnt > 0);
+
+	if (--cquery->refcnt > 0)
+		return;
+
+	free(cquery->name);
+	free(cquery->cname);
+	free(cquery);
+}
+
+/** Look up name in the cache.
+ *
+ * If the same name is being queried by another fibril, wait for the
+ * result of that query. If the name is not cached, @a *rquery is set
+ * and the caller must perform the query and pass its result to
+ * dns_cache_complete().
+ *
+ * @param name   Queried name
+ * @param qtype  Query type
+ * @param info   Host information to fill in on success
+ * @param rquery Place to store query to be performed by the caller
+ *
+ * @return EOK on success or if @a *rquery is set
+ * @return ENOENT if the name is known to have no such address
+ * @return Other error code if the shared query failed
+ */
+errno_t dns_cache_lookup(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info, dns_cquery_t **rquery)
+{
+	dns_cache_key_t key;
+	dns_cache_entry_t *entry;
+	dns_cquery_t *cquery;
+	struct timespec now;
+	ht_link_t *link;
+	errno_t rc;
+
+	*rquery = NULL;
+	getuptime(&now);
+
+	fibril_mutex_lock(&cache_lock);
+
+	key.name = name;
+	key.qtype = qtype;
+	link = hash_table_find(&cache_map, &key);
+	if (link != NULL) {
+		entry = hash_table_get_inst(link, dns_cache_entry_t, lhash);
+		if (ts_gt(&entry->expires, &now)) {
+			list_remove(&entry->llru);
+			list_prepend(&entry->llru, &cache_lru);
+
+			if (entry->negative) {
+				rc = ENOENT;
+			} else {
+				rc = dns_cache_fill_info(info, entry->cname,
+				    &entry->addr);
+			}
+
+			fibril_mutex_unlock(&cache_lock);
+			log_msg(LOG_DEFAULT, LVL_DEBUG,
+			    "dns_cache_lookup: '%s' found in cache", name);
+			return rc;
+		}
+
+		dns_cache_entry_remove(entry);
+	}
+
+	cquery = dns_cquery_find(name, qtype);
+	if (cquery != NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "dns_cache_lookup: join query "
+		    "for '%s'", name);
+
+		cquery->refcnt++;
+		while (!cquery->done)
+			fibril_condvar_wait(&cquery_cv, &cache_lock);
+
+		rc = cquery->rc;
+		if (rc == EOK)
+			rc = dns_cache_fill_info(info, cquery->cname,
+			    &cquery->addr);
+
+		dns_cquery_release(cquery);
+		fibril_mutex_unlock(&cache_lock);
+		return rc;
+	}
+
+	cquery = calloc(1, sizeof(dns_cquery_t));
+	if (cquery == NULL) {
+		fibril_mutex_unlock(&cache_lock);
+		return ENOMEM;
+	}
+
+	cquery->name = str_dup(name);
+	if (cquery->name == NULL) {
+		free(cquery);
+		fibril_mutex_unlock(&cache_lock);
+		return ENOMEM;
+	}
+
+	cquery->qtype = qtype;
+	cquery->refcnt = 1;
+	list_append(&cquery->lqueries, &cquery_list);
+
+	fibril_mutex_unlock(&cache_lock);
+
+	*rquery = cquery;
+	return EOK;
+}
+
+/** Complete query started by dns_cache_lookup().
+ *
+ * Passes the result to the waiting fibrils. Successful results and
+ * @c ENOENT (name does not exist) are cached for @a ttl seconds.
+ *
+ * @param cquery Query
+ * @param rc     Result of the query
+ * @param info   Host information (if @a rc is EOK)
+ * @param ttl    Time to live in seconds, zero not to cache the result
+ */
+void dns_cache_complete(dns_cquery_t *cquery, errno_t rc,
+    dns_host_info_t *info, uint32_t ttl)
+{
+	fibril_mutex_lock(&cache_lock);
+
+	list_remove(&cquery->lqueries);
+
+	cquery->rc = rc;
+	if (rc == EOK) {
+		cquery->cname = str_dup(info->cname);
+		if (cquery->cname == NULL)
+			cquery->rc = ENOMEM;
+
+		cquery->addr = info->addr;
+	}
+
+	cquery->done = true;
+
+	if ((rc == EOK || rc == ENOENT) && ttl > 0) {
+		dns_cache_insert(cquery->name, cquery->qtype, rc == ENOENT,
+		    info != NULL ? info->cname : NULL,
+		    info != NULL ? &info->addr : NULL, ttl);
+	}
+
+	dns_cquery_release(cquery);
+	fibril_mutex_unlock(&cache_lock);
+
+	fibril_condvar_broadcast(&cquery_cv);
+}
+
+/** Get list of cache entries.
+ *
+ * @param rentries Place to store pointer to an allocated array of entries
+ * @param rcount   Place to store number of entries
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t dns_cache_get_list(dnsr_cache_entry_t **rentries, size_t *rcount)
+{
+	dnsr_cache_entry_t *entries;
+	struct timespec now;
+	size_t count;
+
+	getuptime(&now);
+
+	fibril_mutex_lock(&cache_lock);
+
+	entries = calloc(max(cache_count, 1), sizeof(dnsr_cache_entry_t));
+	if (entries == NULL) {
+		fibril_mutex_unlock(&cache_lock);
+		return ENOMEM;
+	}
+
+	count = 0;
+	list_foreach(cache_lru, llru, dns_cache_entry_t, entry) {
+		if (!ts_gt(&entry->expires, &now))
+			continue;
+
+		dnsr_cache_entry_t *ent = &entries[count++];
+
+		str_cpy(ent->name, sizeof(ent->name), entry->name);
+		ent->ver = entry->qtype == DTYPE_A ? ip_v4 : ip_v6;
+		ent->negative = entry->negative;
+		if (!entry->negative) {
+			str_cpy(ent->cname, sizeof(ent->cname), entry->cname);
+			ent->addr = entry->addr;
+		}
+
+		ent->ttl = NSEC2SEC(ts_sub_diff(&entry->expires, &now));
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+
+	*rentries = entries;
+	*rcount = count;
+	return EOK;
+}
+
+/** Remove all entries from the cache. */
+void dns_cache_flush(void)
+{
+	fibril_mutex_lock(&cache_lock);
+
+	while (!list_empty(&cache_lru)) {
+		dns_cache_entry_remove(list_get_instance(list_first(&cache_lru),
+		    dns_cache_entry_t, llru));
+	}
+
+	fibril_mutex_unlock(&cache_lock);
+}
+
+/** @}
+ */
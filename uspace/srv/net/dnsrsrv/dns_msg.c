@@ -572,6 +572,7 @@ errno_t dns_message_decode(void *data, size_t size, dns_message_t **rmsg)
 	dns_rr_t *rr;
 	size_t qd_count;
 	size_t an_count;
+	size_t ns_count;
 	size_t i;
 	errno_t rc;
 
@@ -640,6 +641,21 @@ errno_t dns_message_decode(void *data, size_t size, dns_message_t **rmsg)
 		doff = field_eoff;
 	}
 
+	ns_count = uint16_t_be2host(hdr->ns_count);
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "ns_count=%zu", ns_count);
+
+	for (i = 0; i < ns_count; i++) {
+		rc = dns_rr_decode(&msg->pdu, doff, &rr, &field_eoff);
+		if (rc != EOK) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG,
+			    "Error decoding authority");
+			goto error;
+		}
+
+		list_append(&rr->msg, &msg->authority);
+		doff = field_eoff;
+	}
+
 	*rmsg = msg;
 	return EOK;
 error:
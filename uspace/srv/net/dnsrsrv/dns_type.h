@@ -36,11 +36,13 @@
 #ifndef DNS_TYPE_H
 #define DNS_TYPE_H
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <inet/inet.h>
 #include <inet/addr.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
 #include "dns_std.h"
 
 /** Encoded DNS PDU */
@@ -118,6 +120,46 @@ typedef struct {
 	inet_addr_t addr;
 } dns_host_info_t;
 
+/** Resolver cache entry */
+typedef struct {
+	/** Link to cache hash table */
+	ht_link_t lhash;
+	/** Link to LRU list */
+	link_t llru;
+	/** Queried name */
+	char *name;
+	/** Query type (DTYPE_A or DTYPE_AAAA) */
+	dns_qtype_t qtype;
+	/** Negative entry (name or address does not exist) */
+	bool negative;
+	/** Host canonical name (positive entry) */
+	char *cname;
+	/** Host address (positive entry) */
+	inet_addr_t addr;
+	/** Expiration time */
+	struct timespec expires;
+} dns_cache_entry_t;
+
+/** Query in progress, shared by identical concurrent queries */
+typedef struct {
+	/** Link to list of queries in progress */
+	link_t lqueries;
+	/** Queried name */
+	char *name;
+	/** Query type */
+	dns_qtype_t qtype;
+	/** Number of fibrils using the query */
+	size_t refcnt;
+	/** Query has been completed */
+	bool done;
+	/** Result of the query */
+	errno_t rc;
+	/** Host canonical name (if successful) */
+	char *cname;
+	/** Host address (if successful) */
+	inet_addr_t addr;
+} dns_cquery_t;
+
 typedef struct {
 } dnsr_client_t;
 
@@ -40,11 +40,13 @@
 #include <ipc/dnsr.h>
 #include <ipc/services.h>
 #include <loc.h>
+#include <macros.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
 #include <task.h>
 
+#include "cache.h"
 #include "dns_msg.h"
 #include "dns_std.h"
 #include "query.h"
@@ -54,10 +56,16 @@
 
 static void dnsr_client_conn(ipc_call_t *, void *);
 
-static errno_t dnsr_init(void)
+static errno_t dnsrsrv_init(void)
 {
 	errno_t rc;
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "dnsr_init()");
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "dnsrsrv_init()");
+
+	rc = dns_cache_init();
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing cache.");
+		return EIO;
+	}
 
 	rc = transport_init();
 	if (rc != EOK) {
@@ -153,6 +161,8 @@ static void dnsr_get_srvaddr_srv(dnsr_client_t *client, ipc_call_t *icall)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_get_srvaddr_srv()");
 
+	size_t idx = ipc_get_arg1(icall);
+
 	ipc_call_t call;
 	size_t size;
 	if (!async_data_read_receive(&call, &size)) {
@@ -167,9 +177,15 @@ static void dnsr_get_srvaddr_srv(dnsr_client_t *client, ipc_call_t *icall)
 		return;
 	}
 
-	// FIXME locking
+	inet_addr_t addr;
+	errno_t rc = transport_get_srvaddr(idx, &addr);
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
+		async_answer_0(icall, rc);
+		return;
+	}
 
-	errno_t rc = async_data_read_finalize(&call, &dns_server_addr, size);
+	rc = async_data_read_finalize(&call, &addr, size);
 	if (rc != EOK)
 		async_answer_0(&call, rc);
 
@@ -194,18 +210,61 @@ static void dnsr_set_srvaddr_srv(dnsr_client_t *client, ipc_call_t *icall)
 		return;
 	}
 
-	// FIXME locking
-
-	errno_t rc = async_data_write_finalize(&call, &dns_server_addr, size);
+	inet_addr_t addr;
+	errno_t rc = async_data_write_finalize(&call, &addr, size);
 	if (rc != EOK) {
 		async_answer_0(&call, rc);
 		async_answer_0(icall, rc);
 		return;
 	}
 
+	rc = transport_set_srvaddr(ipc_get_arg1(icall), &addr);
+	if (rc == EOK) {
+		/* Answers may differ on the new server (e.g. a new network) */
+		dns_cache_flush();
+	}
+
 	async_answer_0(icall, rc);
 }
 
+static void dnsr_get_cache_srv(dnsr_client_t *client, ipc_call_t *icall)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "dnsr_get_cache_srv()");
+
+	ipc_call_t call;
+	size_t max_size;
+	if (!async_data_read_receive(&call, &max_size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	dnsr_cache_entry_t *entries;
+	size_t count;
+	errno_t rc = dns_cache_get_list(&entries, &count);
+	if (rc != EOK) {
+		async_answer_0(&call, rc);
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	size_t act_size = count * sizeof(dnsr_cache_entry_t);
+	size_t size = min(act_size, max_size);
+
+	rc = async_data_read_finalize(&call, entries, size);
+	free(entries);
+
+	async_answer_1(icall, rc, act_size);
+}
+
+static void dnsr_flush_cache_srv(dnsr_client_t *client, ipc_call_t *icall)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "dnsr_flush_cache_srv()");
+
+	dns_cache_flush();
+	async_answer_0(icall, EOK);
+}
+
 static void dnsr_client_conn(ipc_call_t *icall, void *arg)
 {
 	dnsr_client_t client;
@@ -236,6 +295,12 @@ static void dnsr_client_conn(ipc_call_t *icall, void *arg)
 		case DNSR_SET_SRVADDR:
 			dnsr_set_srvaddr_srv(&client, &call);
 			break;
+		case DNSR_GET_CACHE:
+			dnsr_get_cache_srv(&client, &call);
+			break;
+		case DNSR_FLUSH_CACHE:
+			dnsr_flush_cache_srv(&client, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 		}
@@ -253,7 +318,7 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
-	rc = dnsr_init();
+	rc = dnsrsrv_init();
 	if (rc != EOK)
 		return 1;
 
@@ -35,9 +35,12 @@
 
 #include <errno.h>
 #include <io/log.h>
+#include <macros.h>
 #include <mem.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <str.h>
+#include "cache.h"
 #include "dns_msg.h"
 #include "dns_std.h"
 #include "dns_type.h"
@@ -46,9 +49,46 @@
 
 static uint16_t msg_id;
 
-static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
-    dns_host_info_t *info)
+/** Get time to live of a negative answer.
+ *
+ * Per RFC 2308 this is the minimum of the SOA record TTL and the SOA
+ * MINIMUM field, the last field of the record data.
+ *
+ * @param amsg Answer message
+ * @return Time to live in seconds, zero if the answer must not be cached
+ */
+static uint32_t dns_negative_ttl(dns_message_t *amsg)
 {
+	list_foreach(amsg->authority, msg, dns_rr_t, rr) {
+		if (rr->rtype != DTYPE_SOA || rr->rclass != DC_IN ||
+		    rr->rdata_size < 5 * sizeof(uint32_t))
+			continue;
+
+		uint32_t minimum = dns_uint32_t_decode((uint8_t *) rr->rdata +
+		    rr->rdata_size - sizeof(uint32_t), sizeof(uint32_t));
+		return min(rr->ttl, minimum);
+	}
+
+	/* Without SOA record the answer is not cached */
+	return 0;
+}
+
+/** Query name servers.
+ *
+ * @param name  Name to look up
+ * @param qtype Query type
+ * @param info  Host information to fill in
+ * @param rttl  Place to store time to live of the answer in seconds
+ *
+ * @return EOK on success
+ * @return ENOENT if the name or an address of the type does not exist
+ * @return Other error code if the query failed
+ */
+static errno_t dns_name_query_srv(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info, uint32_t *rttl)
+{
+	*rttl = 0;
+
 	/* Start with the caller-provided name */
 	char *sname = str_dup(name);
 	if (sname == NULL)
@@ -98,6 +138,20 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 		return rc;
 	}
 
+	if (amsg->rcode != RC_OK && amsg->rcode != RC_NAME_ERR) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "'%s' not resolved, rcode %u",
+		    sname, amsg->rcode);
+
+		dns_message_destroy(msg);
+		dns_message_destroy(amsg);
+		free(sname);
+
+		return EIO;
+	}
+
+	/* TTL of the answer is the minimum along the CNAME chain */
+	uint32_t ttl = UINT32_MAX;
+
 	list_foreach(amsg->answer, msg, dns_rr_t, rr) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, " - '%s' %u/%u, dsize %zu",
 		    rr->name, rr->rtype, rr->rclass, rr->rdata_size);
@@ -129,6 +183,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			/* Continue looking for the more canonical name */
 			free(sname);
 			sname = cname;
+			ttl = min(ttl, rr->ttl);
 		}
 
 		if ((qtype == DTYPE_A) && (rr->rtype == DTYPE_A) &&
@@ -146,6 +201,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 			inet_addr_set(dns_uint32_t_decode(rr->rdata, rr->rdata_size),
 			    &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -171,6 +227,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			dns_addr128_t_decode(rr->rdata, rr->rdata_size, addr);
 
 			inet_addr_set6(addr, &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -182,11 +239,35 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "'%s' not resolved, fail", sname);
 
+	*rttl = dns_negative_ttl(amsg);
+
 	dns_message_destroy(msg);
 	dns_message_destroy(amsg);
 	free(sname);
 
-	return EIO;
+	return ENOENT;
+}
+
+/** Look up name, using the cache if possible.
+ *
+ * @param name  Name to look up
+ * @param qtype Query type
+ * @param info  Host information to fill in
+ * @return EOK on success or an error code
+ */
+static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info)
+{
+	dns_cquery_t *cquery;
+	uint32_t ttl;
+
+	errno_t rc = dns_cache_lookup(name, qtype, info, &cquery);
+	if (cquery == NULL)
+		return rc;
+
+	rc = dns_name_query_srv(name, qtype, info, &ttl);
+	dns_cache_complete(cquery, rc, info, ttl);
+	return rc;
 }
 
 errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
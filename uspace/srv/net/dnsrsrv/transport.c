@@ -38,6 +38,7 @@
 #include <str_error.h>
 #include <fibril_synch.h>
 #include <inet/addr.h>
+#include <inet/dnsr.h>
 #include <inet/endpoint.h>
 #include <inet/udp.h>
 #include <io/log.h>
@@ -57,7 +58,9 @@
 /** Maximum number of retries */
 #define REQ_RETRY_MAX 3
 
-inet_addr_t dns_server_addr;
+/** Configured name servers, unspecified address for unused slots */
+static inet_addr_t dns_server_addr[DNSR_SERVERS_MAX];
+static FIBRIL_MUTEX_INITIALIZE(dns_server_lock);
 
 typedef struct {
 	link_t lreq;
@@ -123,6 +126,42 @@ void transport_fini(void)
 	udp_destroy(transport_udp);
 }
 
+/** Get name server address.
+ *
+ * @param idx  Server index
+ * @param addr Place to store the address
+ * @return EOK on success, EINVAL if @a idx is out of range
+ */
+errno_t transport_get_srvaddr(size_t idx, inet_addr_t *addr)
+{
+	if (idx >= DNSR_SERVERS_MAX)
+		return EINVAL;
+
+	fibril_mutex_lock(&dns_server_lock);
+	*addr = dns_server_addr[idx];
+	fibril_mutex_unlock(&dns_server_lock);
+
+	return EOK;
+}
+
+/** Set name server address.
+ *
+ * @param idx  Server index
+ * @param addr Server address, unspecified address to unset
+ * @return EOK on success, EINVAL if @a idx is out of range
+ */
+errno_t transport_set_srvaddr(size_t idx, inet_addr_t *addr)
+{
+	if (idx >= DNSR_SERVERS_MAX)
+		return EINVAL;
+
+	fibril_mutex_lock(&dns_server_lock);
+	dns_server_addr[idx] = *addr;
+	fibril_mutex_unlock(&dns_server_lock);
+
+	return EOK;
+}
+
 static trans_req_t *treq_create(dns_message_t *req)
 {
 	trans_req_t *treq;
@@ -146,8 +185,14 @@ static trans_req_t *treq_create(dns_message_t *req)
 
 static void treq_destroy(trans_req_t *treq)
 {
+	fibril_mutex_lock(&treq_lock);
 	if (link_in_use(&treq->lreq))
 		list_remove(&treq->lreq);
+	fibril_mutex_unlock(&treq_lock);
+
+	/* Response that arrived after we gave up */
+	if (treq->resp != NULL)
+		dns_message_destroy(treq->resp);
 	free(treq);
 }
 
@@ -176,38 +221,79 @@ static void treq_complete(trans_req_t *treq, dns_message_t *resp)
 	fibril_condvar_broadcast(&treq->done_cv);
 }
 
+/** Send request to all configured name servers.
+ *
+ * @return EOK if the request was sent to at least one server
+ */
+static errno_t dns_request_send(void *req_data, size_t req_size)
+{
+	inet_addr_t addr[DNSR_SERVERS_MAX];
+	inet_ep_t ep;
+	errno_t rc = EIO;
+	size_t i;
+
+	fibril_mutex_lock(&dns_server_lock);
+	for (i = 0; i < DNSR_SERVERS_MAX; i++)
+		addr[i] = dns_server_addr[i];
+	fibril_mutex_unlock(&dns_server_lock);
+
+	for (i = 0; i < DNSR_SERVERS_MAX; i++) {
+		if (inet_addr_is_any(&addr[i]))
+			continue;
+
+		inet_ep_init(&ep);
+		ep.addr = addr[i];
+		ep.port = DNS_SERVER_PORT;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "dns_request: Send DNS message "
+		    "to server %zu", i);
+		errno_t src = udp_assoc_send_msg(transport_assoc, &ep,
+		    req_data, req_size);
+		if (src != EOK) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG,
+			    "Error sending message: %s", str_error(src));
+			continue;
+		}
+
+		rc = EOK;
+	}
+
+	return rc;
+}
+
+/** Send request to the name servers and wait for the first response.
+ *
+ * The request is sent to all configured servers in parallel, the first
+ * matching response completes it.
+ *
+ * @param req   Request
+ * @param rresp Place to store the response
+ * @return EOK on success or an error code
+ */
 errno_t dns_request(dns_message_t *req, dns_message_t **rresp)
 {
 	trans_req_t *treq = NULL;
-	inet_ep_t ep;
 
-	void *req_data;
+	void *req_data = NULL;
 	size_t req_size;
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "dns_request: Encode dns message");
 	errno_t rc = dns_message_encode(req, &req_data, &req_size);
 	if (rc != EOK)
 		goto error;
 
-	inet_ep_init(&ep);
-	ep.addr = dns_server_addr;
-	ep.port = DNS_SERVER_PORT;
+	/* Register before sending so that no response can be missed */
+	treq = treq_create(req);
+	if (treq == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
 
 	size_t ntry = 0;
 
 	while (ntry < REQ_RETRY_MAX) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "dns_request: Send DNS message");
-		rc = udp_assoc_send_msg(transport_assoc, &ep, req_data,
-		    req_size);
-		if (rc != EOK) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "Error sending message: %s", str_error(rc));
+		rc = dns_request_send(req_data, req_size);
+		if (rc != EOK)
 			goto error;
-		}
-
-		treq = treq_create(req);
-		if (treq == NULL) {
-			rc = ENOMEM;
-			goto error;
-		}
 
 		fibril_mutex_lock(&treq->done_lock);
 		while (treq->done != true) {
@@ -236,6 +322,7 @@ errno_t dns_request(dns_message_t *req, dns_message_t **rresp)
 	}
 
 	*rresp = treq->resp;
+	treq->resp = NULL;
 	treq_destroy(treq);
 	free(req_data);
 	return EOK;
@@ -280,14 +367,16 @@ static void transport_recv_msg(udp_assoc_t *assoc, udp_rmsg_t *rmsg)
 	fibril_mutex_lock(&treq_lock);
 	treq = treq_match_resp(resp);
 	if (treq == NULL) {
+		/* E.g. a late response from another server */
 		fibril_mutex_unlock(&treq_lock);
+		dns_message_destroy(resp);
 		return;
 	}
 
+	/* Complete under the lock so that the request cannot go away */
 	list_remove(&treq->lreq);
-	fibril_mutex_unlock(&treq_lock);
-
 	treq_complete(treq, resp);
+	fibril_mutex_unlock(&treq_lock);
 }
 
 static void transport_recv_err(udp_assoc_t *assoc, udp_rerr_t *rerr)
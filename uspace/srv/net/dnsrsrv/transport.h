@@ -39,10 +39,10 @@
 #include <inet/addr.h>
 #include "dns_type.h"
 
-extern inet_addr_t dns_server_addr;
-
 extern errno_t transport_init(void);
 extern void transport_fini(void);
+extern errno_t transport_get_srvaddr(size_t, inet_addr_t *);
+extern errno_t transport_set_srvaddr(size_t, inet_addr_t *);
 extern errno_t dns_request(dns_message_t *, dns_message_t **);
 
 #endif
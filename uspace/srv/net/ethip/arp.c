@@ -46,9 +46,6 @@
 #include "pdu.h"
 #include "std.h"
 
-/** Time to wait for ARP reply in microseconds */
-#define ARP_REQUEST_TIMEOUT (3 * 1000 * 1000)
-
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet);
 
 void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
@@ -93,8 +90,22 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 	}
 }
 
+/** Translate IP address of a datagram's next hop to MAC address.
+ *
+ * If the address is not known yet, the datagram is queued and sent
+ * when the ARP reply arrives.
+ *
+ * @param nic      NIC
+ * @param src_addr Source IP address
+ * @param ip_addr  Destination IP address
+ * @param data     Datagram
+ * @param size     Datagram size
+ * @param mac_addr Place to store the MAC address
+ * @return EOK if @a mac_addr was filled in, EINPROGRESS if the datagram
+ *         was queued or an error code
+ */
 errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
-    addr48_t mac_addr)
+    void *data, size_t size, addr48_t mac_addr)
 {
 	/* Broadcast address */
 	if (ip_addr == addr32_broadcast_all_hosts) {
@@ -102,10 +113,18 @@ errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
 		return EOK;
 	}
 
-	errno_t rc = atrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	return atrans_resolve(nic, src_addr, ip_addr, data, size, mac_addr);
+}
 
+/** Broadcast ARP request for an IP address.
+ *
+ * @param nic      NIC
+ * @param src_addr Source IP address
+ * @param ip_addr  Requested IP address
+ * @return EOK on success or an error code
+ */
+errno_t arp_request(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr)
+{
 	arp_eth_packet_t packet;
 
 	packet.opcode = aop_request;
@@ -114,11 +133,7 @@ errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
 	addr48(addr48_broadcast, packet.target_hw_addr);
 	packet.target_proto_addr = ip_addr;
 
-	rc = arp_send_packet(nic, &packet);
-	if (rc != EOK)
-		return rc;
-
-	return atrans_lookup_timeout(ip_addr, ARP_REQUEST_TIMEOUT, mac_addr);
+	return arp_send_packet(nic, &packet);
 }
 
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet)
@@ -34,129 +34,450 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <inet/iplink_srv.h>
+#include <mem.h>
 #include <stdlib.h>
 
+#include "arp.h"
 #include "atrans.h"
 #include "ethip.h"
 
-/** Address translation list (of ethip_atrans_t) */
+/** Maximum number of entries in the translation table */
+#define ATRANS_MAX_ENTRIES  512
+/** Maximum number of datagrams waiting for one translation */
+#define ATRANS_MAX_PENDING  8
+/** Interval between ARP requests in microseconds */
+#define ATRANS_PROBE_INTERVAL  (1000 * 1000)
+/** Number of unanswered ARP requests after which an entry is dropped */
+#define ATRANS_MAX_PROBES  3
+/** Time for which a confirmed entry stays reachable in seconds */
+#define ATRANS_REACHABLE_TIME  30
+/** Time after which an unused stale entry is dropped in seconds */
+#define ATRANS_STALE_TIME  600
+/** Maximum number of ARP requests sent by one aging pass */
+#define ATRANS_PROBE_BATCH  16
+
+/** ARP request to be sent */
+typedef struct {
+	ethip_nic_t *nic;
+	addr32_t src_addr;
+	addr32_t ip_addr;
+} atrans_probe_t;
+
+/** Address translation table (of ethip_atrans_t) */
 static FIBRIL_MUTEX_INITIALIZE(atrans_list_lock);
-static LIST_INITIALIZE(atrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(atrans_cv);
+static hash_table_t atrans_map;
+/** Entries, least recently used first */
+static LIST_INITIALIZE(atrans_lru);
+
+static size_t atrans_key_hash(const void *key)
+{
+	return hash_mix(*(const addr32_t *) key);
+}
+
+static size_t atrans_hash(const ht_link_t *item)
+{
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_map);
+	return atrans_key_hash(&atrans->ip_addr);
+}
+
+static bool atrans_key_equal(const void *key, const ht_link_t *item)
+{
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_map);
+	return atrans->ip_addr == *(const addr32_t *) key;
+}
+
+static hash_table_ops_t atrans_map_ops = {
+	.hash = atrans_hash,
+	.key_hash = atrans_key_hash,
+	.key_equal = atrans_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
 
 static ethip_atrans_t *atrans_find(addr32_t ip_addr)
 {
-	list_foreach(atrans_list, atrans_list, ethip_atrans_t, atrans) {
-		if (atrans->ip_addr == ip_addr)
-			return atrans;
+	ht_link_t *link = hash_table_find(&atrans_map, &ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, ethip_atrans_t, atrans_map);
+}
+
+/** Free datagrams from a list of pending datagrams. */
+static void atrans_pending_free(list_t *pending)
+{
+	while (!list_empty(pending)) {
+		ethip_atrans_pending_t *pend = list_get_instance(
+		    list_first(pending), ethip_atrans_pending_t, lpending);
+
+		list_remove(&pend->lpending);
+		free(pend->data);
+		free(pend);
 	}
+}
 
-	return NULL;
+/** Remove entry from the table.
+ *
+ * The entry and the datagrams waiting for it are freed with
+ * atrans_free() once the table lock is released.
+ *
+ * @param atrans Entry
+ * @param dead   List to move the entry to
+ */
+static void atrans_unlink(ethip_atrans_t *atrans, list_t *dead)
+{
+	hash_table_remove_item(&atrans_map, &atrans->atrans_map);
+	list_remove(&atrans->atrans_lru);
+	list_append(&atrans->atrans_lru, dead);
 }
 
-errno_t atrans_add(addr32_t ip_addr, addr48_t mac_addr)
+/** Free entries removed from the table. */
+static void atrans_free(list_t *dead)
 {
-	ethip_atrans_t *atrans;
-	ethip_atrans_t *prev;
+	while (!list_empty(dead)) {
+		ethip_atrans_t *atrans = list_get_instance(list_first(dead),
+		    ethip_atrans_t, atrans_lru);
 
-	atrans = calloc(1, sizeof(ethip_atrans_t));
+		list_remove(&atrans->atrans_lru);
+		atrans_pending_free(&atrans->pending);
+		free(atrans);
+	}
+}
+
+/** Create a new entry in the table.
+ *
+ * If the table is full, the least recently used entry is dropped.
+ *
+ * @param ip_addr IP address
+ * @param dead    List to move the dropped entry to
+ * @return New entry or @c NULL if out of memory
+ */
+static ethip_atrans_t *atrans_create(addr32_t ip_addr, list_t *dead)
+{
+	ethip_atrans_t *atrans = calloc(1, sizeof(ethip_atrans_t));
 	if (atrans == NULL)
-		return ENOMEM;
+		return NULL;
+
+	if (hash_table_size(&atrans_map) >= ATRANS_MAX_ENTRIES) {
+		atrans_unlink(list_get_instance(list_first(&atrans_lru),
+		    ethip_atrans_t, atrans_lru), dead);
+	}
 
 	atrans->ip_addr = ip_addr;
-	addr48(mac_addr, atrans->mac_addr);
+	list_initialize(&atrans->pending);
+	hash_table_insert(&atrans_map, &atrans->atrans_map);
+	list_append(&atrans->atrans_lru, &atrans_lru);
+
+	return atrans;
+}
+
+/** Mark entry as recently used. */
+static void atrans_touch(ethip_atrans_t *atrans)
+{
+	list_remove(&atrans->atrans_lru);
+	list_append(&atrans->atrans_lru, &atrans_lru);
+}
+
+/** Send datagrams resolved to a MAC address and free them. */
+static void atrans_pending_send(list_t *pending, addr48_t mac_addr)
+{
+	while (!list_empty(pending)) {
+		ethip_atrans_pending_t *pend = list_get_instance(
+		    list_first(pending), ethip_atrans_pending_t, lpending);
+
+		list_remove(&pend->lpending);
+		(void) ethip_send_dgram(pend->nic, mac_addr, pend->data,
+		    pend->size);
+		free(pend->data);
+		free(pend);
+	}
+}
+
+/** Age the translation table.
+ *
+ * Stale entries and unresolved entries are probed with ARP requests
+ * and dropped when the requests stay unanswered.
+ */
+static void atrans_age(void)
+{
+	atrans_probe_t probes[ATRANS_PROBE_BATCH];
+	size_t nprobes = 0;
+	struct timespec now;
+	list_t dead;
+
+	list_initialize(&dead);
+	getuptime(&now);
 
 	fibril_mutex_lock(&atrans_list_lock);
-	prev = atrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->atrans_list);
-		free(prev);
+
+	list_foreach_safe(atrans_lru, cur, next) {
+		ethip_atrans_t *atrans = list_get_instance(cur, ethip_atrans_t,
+		    atrans_lru);
+		nsec_t age = ts_sub_diff(&now, &atrans->updated);
+
+		if (atrans->state == atrans_reachable) {
+			if (age >= SEC2NSEC(ATRANS_REACHABLE_TIME))
+				atrans->state = atrans_stale;
+			continue;
+		}
+
+		if (atrans->probes == 0) {
+			/* Stale entry nobody asked for */
+			if (age >= SEC2NSEC(ATRANS_STALE_TIME))
+				atrans_unlink(atrans, &dead);
+			continue;
+		}
+
+		if (age < USEC2NSEC(ATRANS_PROBE_INTERVAL))
+			continue;
+
+		if (atrans->probes >= ATRANS_MAX_PROBES) {
+			atrans_unlink(atrans, &dead);
+			continue;
+		}
+
+		if (nprobes < ATRANS_PROBE_BATCH) {
+			probes[nprobes].nic = atrans->nic;
+			probes[nprobes].src_addr = atrans->src_addr;
+			probes[nprobes].ip_addr = atrans->ip_addr;
+			nprobes++;
+
+			atrans->probes++;
+			atrans->updated = now;
+		}
 	}
 
-	list_append(&atrans->atrans_list, &atrans_list);
 	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
+
+	atrans_free(&dead);
+
+	for (size_t i = 0; i < nprobes; i++) {
+		(void) arp_request(probes[i].nic, probes[i].src_addr,
+		    probes[i].ip_addr);
+	}
+}
+
+static errno_t atrans_age_fibril(void *arg)
+{
+	(void) arg;
+
+	while (true) {
+		fibril_usleep(ATRANS_PROBE_INTERVAL);
+		atrans_age();
+	}
 
 	return EOK;
 }
 
-errno_t atrans_remove(addr32_t ip_addr)
+/** Initialize address translation.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_init(void)
+{
+	fid_t fid;
+
+	if (!hash_table_create(&atrans_map, 0, 0, &atrans_map_ops))
+		return ENOMEM;
+
+	fid = fibril_create(atrans_age_fibril, NULL);
+	if (fid == 0) {
+		hash_table_destroy(&atrans_map);
+		return ENOMEM;
+	}
+
+	fibril_add_ready(fid);
+	return EOK;
+}
+
+/** Add or confirm address translation.
+ *
+ * Datagrams waiting for the translation are sent.
+ *
+ * @param ip_addr  IP address
+ * @param mac_addr MAC address
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_add(addr32_t ip_addr, addr48_t mac_addr)
 {
 	ethip_atrans_t *atrans;
+	list_t pending;
+	list_t dead;
+
+	list_initialize(&pending);
+	list_initialize(&dead);
 
 	fibril_mutex_lock(&atrans_list_lock);
+
 	atrans = atrans_find(ip_addr);
 	if (atrans == NULL) {
-		fibril_mutex_unlock(&atrans_list_lock);
-		return ENOENT;
+		atrans = atrans_create(ip_addr, &dead);
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_list_lock);
+			return ENOMEM;
+		}
 	}
 
-	list_remove(&atrans->atrans_list);
+	addr48(mac_addr, atrans->mac_addr);
+	atrans->state = atrans_reachable;
+	atrans->probes = 0;
+	getuptime(&atrans->updated);
+
+	list_concat(&pending, &atrans->pending);
+	atrans->npending = 0;
+
 	fibril_mutex_unlock(&atrans_list_lock);
-	free(atrans);
+
+	atrans_free(&dead);
+	atrans_pending_send(&pending, mac_addr);
 
 	return EOK;
 }
 
-static errno_t atrans_lookup_locked(addr32_t ip_addr, addr48_t mac_addr)
+errno_t atrans_remove(addr32_t ip_addr)
 {
-	ethip_atrans_t *atrans = atrans_find(ip_addr);
-	if (atrans == NULL)
+	ethip_atrans_t *atrans;
+	list_t dead;
+
+	list_initialize(&dead);
+
+	fibril_mutex_lock(&atrans_list_lock);
+	atrans = atrans_find(ip_addr);
+	if (atrans == NULL) {
+		fibril_mutex_unlock(&atrans_list_lock);
 		return ENOENT;
+	}
+
+	atrans_unlink(atrans, &dead);
+	fibril_mutex_unlock(&atrans_list_lock);
+	atrans_free(&dead);
 
-	addr48(atrans->mac_addr, mac_addr);
 	return EOK;
 }
 
 errno_t atrans_lookup(addr32_t ip_addr, addr48_t mac_addr)
 {
-	errno_t rc;
+	ethip_atrans_t *atrans;
+	errno_t rc = ENOENT;
 
 	fibril_mutex_lock(&atrans_list_lock);
-	rc = atrans_lookup_locked(ip_addr, mac_addr);
-	fibril_mutex_unlock(&atrans_list_lock);
 
+	atrans = atrans_find(ip_addr);
+	if (atrans != NULL && atrans->state != atrans_incomplete) {
+		addr48(atrans->mac_addr, mac_addr);
+		rc = EOK;
+	}
+
+	fibril_mutex_unlock(&atrans_list_lock);
 	return rc;
 }
 
-static void atrans_lookup_timeout_handler(void *arg)
+/** Translate IP address for sending a datagram.
+ *
+ * If the MAC address is not known yet, a copy of the datagram is queued
+ * and sent as soon as an ARP reply arrives. The ARP requests are sent
+ * as needed. A stale translation is still used, but it is refreshed.
+ *
+ * @param nic      NIC to send ARP requests through
+ * @param src_addr Source address for ARP requests
+ * @param ip_addr  IP address to translate
+ * @param data     Datagram
+ * @param size     Datagram size
+ * @param mac_addr Place to store the MAC address
+ * @return EOK if @a mac_addr was filled in, EINPROGRESS if the datagram
+ *         was queued, ENOMEM if out of memory
+ */
+errno_t atrans_resolve(ethip_nic_t *nic, addr32_t src_addr,
+    addr32_t ip_addr, void *data, size_t size, addr48_t mac_addr)
 {
-	bool *timedout = (bool *)arg;
+	ethip_atrans_t *atrans;
+	ethip_atrans_pending_t *pend;
+	bool probe = false;
+	list_t dead;
+	errno_t rc;
+
+	list_initialize(&dead);
 
 	fibril_mutex_lock(&atrans_list_lock);
-	*timedout = true;
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
-}
 
-errno_t atrans_lookup_timeout(addr32_t ip_addr, usec_t timeout,
-    addr48_t mac_addr)
-{
-	fibril_timer_t *t;
-	bool timedout;
-	errno_t rc;
+	atrans = atrans_find(ip_addr);
+	if (atrans != NULL && atrans->state != atrans_incomplete) {
+		addr48(atrans->mac_addr, mac_addr);
+		atrans_touch(atrans);
 
-	t = fibril_timer_create(NULL);
-	if (t == NULL)
-		return ENOMEM;
+		if (atrans->state == atrans_stale && atrans->probes == 0)
+			probe = true;
 
-	timedout = false;
-	fibril_timer_set(t, timeout, atrans_lookup_timeout_handler, &timedout);
+		rc = EOK;
+		goto out;
+	}
 
-	fibril_mutex_lock(&atrans_list_lock);
+	pend = calloc(1, sizeof(ethip_atrans_pending_t));
+	if (pend != NULL)
+		pend->data = malloc(size);
+	if (pend == NULL || pend->data == NULL) {
+		free(pend);
+		rc = ENOMEM;
+		goto out;
+	}
+
+	if (atrans == NULL) {
+		atrans = atrans_create(ip_addr, &dead);
+		if (atrans == NULL) {
+			free(pend->data);
+			free(pend);
+			rc = ENOMEM;
+			goto out;
+		}
+
+		atrans->state = atrans_incomplete;
+		probe = true;
+	}
+
+	memcpy(pend->data, data, size);
+	pend->size = size;
+	pend->nic = nic;
+
+	/* Drop the oldest datagram if too many are waiting */
+	if (atrans->npending >= ATRANS_MAX_PENDING) {
+		ethip_atrans_pending_t *old = list_get_instance(
+		    list_first(&atrans->pending), ethip_atrans_pending_t,
+		    lpending);
+
+		list_remove(&old->lpending);
+		free(old->data);
+		free(old);
+		atrans->npending--;
+	}
+
+	list_append(&pend->lpending, &atrans->pending);
+	atrans->npending++;
+	atrans_touch(atrans);
+	rc = EINPROGRESS;
 
-	while ((rc = atrans_lookup_locked(ip_addr, mac_addr)) == ENOENT &&
-	    !timedout) {
-		fibril_condvar_wait(&atrans_cv, &atrans_list_lock);
+out:
+	if (probe) {
+		atrans->nic = nic;
+		atrans->src_addr = src_addr;
+		atrans->probes = 1;
+		getuptime(&atrans->updated);
 	}
 
 	fibril_mutex_unlock(&atrans_list_lock);
-	(void) fibril_timer_clear(t);
-	fibril_timer_destroy(t);
+
+	atrans_free(&dead);
+
+	if (probe)
+		(void) arp_request(nic, src_addr, ip_addr);
 
 	return rc;
 }
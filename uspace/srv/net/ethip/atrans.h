@@ -41,10 +41,12 @@
 #include <inet/addr.h>
 #include "ethip.h"
 
+extern errno_t atrans_init(void);
 extern errno_t atrans_add(addr32_t, addr48_t);
 extern errno_t atrans_remove(addr32_t);
 extern errno_t atrans_lookup(addr32_t, addr48_t);
-extern errno_t atrans_lookup_timeout(addr32_t, usec_t, addr48_t);
+extern errno_t atrans_resolve(ethip_nic_t *, addr32_t, addr32_t, void *,
+    size_t, addr48_t);
 
 #endif
 
@@ -45,6 +45,7 @@
 #include <stdlib.h>
 #include <task.h>
 #include "arp.h"
+#include "atrans.h"
 #include "ethip.h"
 #include "ethip_nic.h"
 #include "pdu.h"
@@ -86,6 +87,10 @@ static errno_t ethip_init(void)
 		return rc;
 	}
 
+	rc = atrans_init();
+	if (rc != EOK)
+		return rc;
+
 	rc = ethip_nic_discovery_start();
 	if (rc != EOK)
 		return rc;
@@ -174,28 +179,52 @@ static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_send()");
 
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
-	eth_frame_t frame;
+	addr48_t dest;
+
+	errno_t rc = arp_translate(nic, sdu->src, sdu->dest, sdu->data,
+	    sdu->size, dest);
+	if (rc == EINPROGRESS) {
+		/* Sent when the address is resolved */
+		return EOK;
+	}
 
-	errno_t rc = arp_translate(nic, sdu->src, sdu->dest, frame.dest);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_WARN, "Failed to look up IPv4 address 0x%"
 		    PRIx32, sdu->dest);
 		return rc;
 	}
 
+	return ethip_send_dgram(nic, dest, sdu->data, sdu->size);
+}
+
+/** Send IPv4 datagram to a MAC address.
+ *
+ * @param nic  NIC
+ * @param dest Destination MAC address
+ * @param data Datagram
+ * @param size Datagram size
+ * @return EOK on success or an error code
+ */
+errno_t ethip_send_dgram(ethip_nic_t *nic, addr48_t dest, void *data,
+    size_t size)
+{
+	eth_frame_t frame;
+	errno_t rc;
+
+	addr48(dest, frame.dest);
 	addr48(nic->mac_addr, frame.src);
 	frame.etype_len = ETYPE_IP;
-	frame.data = sdu->data;
-	frame.size = sdu->size;
+	frame.data = data;
+	frame.size = size;
 
-	void *data;
-	size_t size;
-	rc = eth_pdu_encode(&frame, &data, &size);
+	void *fdata;
+	size_t fsize;
+	rc = eth_pdu_encode(&frame, &fdata, &fsize);
 	if (rc != EOK)
 		return rc;
 
-	rc = ethip_nic_send(nic, data, size);
-	free(data);
+	rc = ethip_nic_send(nic, fdata, fsize);
+	free(fdata);
 
 	return rc;
 }
@@ -37,6 +37,7 @@
 #ifndef ETHIP_H_
 #define ETHIP_H_
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <async.h>
 #include <inet/iplink_srv.h>
@@ -44,6 +45,7 @@
 #include <loc.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 typedef struct {
 	link_t link;
@@ -108,14 +110,49 @@ typedef struct {
 	addr32_t target_proto_addr;
 } arp_eth_packet_t;
 
+/** Address translation state */
+typedef enum {
+	/** Waiting for ARP reply */
+	atrans_incomplete,
+	/** Confirmed by a recent ARP packet */
+	atrans_reachable,
+	/** Not confirmed for a while, still used */
+	atrans_stale
+} ethip_atrans_state_t;
+
 /** Address translation table element */
 typedef struct {
-	link_t atrans_list;
+	/** Link to the translation table */
+	ht_link_t atrans_map;
+	/** Link to the list of entries, least recently used first */
+	link_t atrans_lru;
 	addr32_t ip_addr;
 	addr48_t mac_addr;
+	ethip_atrans_state_t state;
+	/** Time of the last confirmation or of the last ARP request */
+	struct timespec updated;
+	/** Number of ARP requests sent since the last confirmation */
+	unsigned probes;
+	/** NIC to send ARP requests through */
+	ethip_nic_t *nic;
+	/** Source address for ARP requests */
+	addr32_t src_addr;
+	/** Datagrams waiting for the translation (ethip_atrans_pending_t) */
+	list_t pending;
+	/** Number of datagrams in @c pending */
+	size_t npending;
 } ethip_atrans_t;
 
+/** Datagram waiting for address translation */
+typedef struct {
+	link_t lpending;
+	ethip_nic_t *nic;
+	void *data;
+	size_t size;
+} ethip_atrans_pending_t;
+
 extern errno_t ethip_iplink_init(ethip_nic_t *);
+extern errno_t ethip_send_dgram(ethip_nic_t *, addr48_t, void *, size_t);
 extern errno_t ethip_received(iplink_srv_t *, void *, size_t);
 
 #endif
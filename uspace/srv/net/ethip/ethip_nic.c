@@ -282,6 +282,50 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+static void ethip_nic_received_list(ethip_nic_t *nic, ipc_call_t *call)
+{
+	errno_t rc;
+	uint8_t *data;
+	size_t size;
+	size_t fsize;
+	size_t off;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_list() nic=%p",
+	    nic);
+
+	rc = async_data_write_accept((void **) &data, false, 0,
+	    DATA_XFER_LIMIT, 0, &size);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "data_write_accept() failed");
+		async_answer_0(call, rc);
+		return;
+	}
+
+	/* Pass the IP datagrams of all frames to inetsrv at once */
+	iplink_ev_recv_begin(&nic->iplink);
+
+	off = 0;
+	while (size - off >= sizeof(size_t)) {
+		memcpy(&fsize, data + off, sizeof(size_t));
+		off += sizeof(size_t);
+
+		if (fsize > size - off) {
+			rc = EINVAL;
+			break;
+		}
+
+		(void) ethip_received(&nic->iplink, data + off, fsize);
+		off += fsize;
+	}
+
+	(void) iplink_ev_recv_end(&nic->iplink);
+	free(data);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_list() done, "
+	    "rc=%s", str_error_name(rc));
+	async_answer_0(call, rc);
+}
+
 static void ethip_nic_device_state(ethip_nic_t *nic, ipc_call_t *call)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
@@ -313,6 +357,9 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 		case NIC_EV_DEVICE_STATE:
 			ethip_nic_device_state(nic, &call);
 			break;
+		case NIC_EV_RECEIVED_LIST:
+			ethip_nic_received_list(nic, &call);
+			break;
 		default:
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "unknown IPC method: %" PRIun, ipc_get_imethod(&call));
 			async_answer_0(&call, ENOTSUP);
@@ -56,11 +56,15 @@ static uint16_t ip_ident = 0;
 
 static errno_t inet_iplink_recv(iplink_t *, iplink_recv_sdu_t *, ip_ver_t);
 static errno_t inet_iplink_change_addr(iplink_t *, addr48_t);
+static void inet_iplink_recv_begin(iplink_t *);
+static void inet_iplink_recv_end(iplink_t *);
 static inet_link_t *inet_link_get_by_id_locked(sysarg_t);
 
 static iplink_ev_ops_t inet_iplink_ev_ops = {
 	.recv = inet_iplink_recv,
 	.change_addr = inet_iplink_change_addr,
+	.recv_begin = inet_iplink_recv_begin,
+	.recv_end = inet_iplink_recv_end
 };
 
 static LIST_INITIALIZE(inet_links);
@@ -120,6 +124,16 @@ static errno_t inet_iplink_recv(iplink_t *iplink, iplink_recv_sdu_t *sdu, ip_ver
 	return rc;
 }
 
+static void inet_iplink_recv_begin(iplink_t *iplink)
+{
+	inet_recv_begin();
+}
+
+static void inet_iplink_recv_end(iplink_t *iplink)
+{
+	inet_recv_end();
+}
+
 static errno_t inet_iplink_change_addr(iplink_t *iplink, addr48_t mac)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_iplink_change_addr(): "
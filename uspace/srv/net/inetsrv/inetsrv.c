@@ -35,6 +35,7 @@
  */
 
 #include <adt/list.h>
+#include <assert.h>
 #include <async.h>
 #include <errno.h>
 #include <str_error.h>
@@ -43,6 +44,7 @@
 #include <ipc/inet.h>
 #include <ipc/services.h>
 #include <loc.h>
+#include <mem.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -57,6 +59,7 @@
 #include "inetcfg.h"
 #include "inetping.h"
 #include "inet_link.h"
+#include "ntrans.h"
 #include "reass.h"
 #include "sroute.h"
 
@@ -81,14 +84,41 @@ static inet_addr_t multicast_all_nodes = {
 static FIBRIL_MUTEX_INITIALIZE(client_list_lock);
 static LIST_INITIALIZE(client_list);
 
+/** Datagrams batched for delivery to a client */
+typedef struct inet_rbatch {
+	/** Link to list of batches to send */
+	link_t lbatch;
+	/** Client session */
+	async_sess_t *sess;
+	/** Number of datagrams in the batch */
+	size_t count;
+	/** Size of @c data contents in bytes */
+	size_t size;
+	/** Datagrams, each preceded by inet_recv_hdr_t */
+	uint8_t data[DATA_XFER_LIMIT];
+} inet_rbatch_t;
+
+/** Protects @c recv_depth and batches of all clients */
+static FIBRIL_MUTEX_INITIALIZE(rbatch_lock);
+/** Number of batches of received datagrams being processed */
+static unsigned recv_depth;
+
 static void inet_default_conn(ipc_call_t *, void *);
 
 static errno_t inet_init(void)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_init()");
 
+	errno_t rc = ntrans_init();
+	if (rc != EOK)
+		return rc;
+
+	rc = inet_reass_init();
+	if (rc != EOK)
+		return rc;
+
 	port_id_t port;
-	errno_t rc = async_create_port(INTERFACE_INET,
+	rc = async_create_port(INTERFACE_INET,
 	    inet_default_conn, NULL, &port);
 	if (rc != EOK)
 		return rc;
@@ -366,6 +396,7 @@ static void inet_set_proto_srv(inet_client_t *client, ipc_call_t *call)
 static void inet_client_init(inet_client_t *client)
 {
 	client->sess = NULL;
+	client->rbatch = NULL;
 
 	fibril_mutex_lock(&client_list_lock);
 	list_append(&client->client_list, &client_list);
@@ -380,6 +411,12 @@ static void inet_client_fini(inet_client_t *client)
 	fibril_mutex_lock(&client_list_lock);
 	list_remove(&client->client_list);
 	fibril_mutex_unlock(&client_list_lock);
+
+	/* Datagrams not yet delivered are dropped */
+	fibril_mutex_lock(&rbatch_lock);
+	free(client->rbatch);
+	client->rbatch = NULL;
+	fibril_mutex_unlock(&rbatch_lock);
 }
 
 static void inet_default_conn(ipc_call_t *icall, void *arg)
@@ -401,7 +438,7 @@ static void inet_default_conn(ipc_call_t *icall, void *arg)
 		if (!method) {
 			/* The other side has hung up */
 			async_answer_0(&call, EOK);
-			return;
+			break;
 		}
 
 		switch (method) {
@@ -440,15 +477,13 @@ static inet_client_t *inet_client_find(uint8_t proto)
 	return NULL;
 }
 
-errno_t inet_ev_recv(inet_client_t *client, inet_dgram_t *dgram)
+/** Send a datagram to a client. */
+static errno_t inet_ev_recv_send(async_sess_t *sess, inet_dgram_t *dgram)
 {
-	async_exch_t *exch = async_exchange_begin(client->sess);
+	async_exch_t *exch = async_exchange_begin(sess);
 
 	ipc_call_t answer;
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_ev_recv: iplink=%zu",
-	    dgram->iplink);
-
 	aid_t req = async_send_2(exch, INET_EV_RECV, dgram->tos,
 	    dgram->iplink, &answer);
 
@@ -481,6 +516,158 @@ errno_t inet_ev_recv(inet_client_t *client, inet_dgram_t *dgram)
 	return retval;
 }
 
+/** Send batched datagrams to their client and free the batch. */
+static errno_t inet_rbatch_send(inet_rbatch_t *rbatch)
+{
+	inet_recv_hdr_t hdr;
+	inet_dgram_t dgram;
+	errno_t rc;
+
+	if (rbatch->count == 1) {
+		memcpy(&hdr, rbatch->data, sizeof(hdr));
+		dgram.src = hdr.src;
+		dgram.dest = hdr.dest;
+		dgram.tos = hdr.tos;
+		dgram.iplink = hdr.iplink;
+		dgram.data = rbatch->data + sizeof(hdr);
+		dgram.size = hdr.size;
+
+		rc = inet_ev_recv_send(rbatch->sess, &dgram);
+		free(rbatch);
+		return rc;
+	}
+
+	async_exch_t *exch = async_exchange_begin(rbatch->sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, INET_EV_RECV_LIST, &answer);
+	rc = async_data_write_start(exch, rbatch->data, rbatch->size);
+
+	async_exchange_end(exch);
+	free(rbatch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+
+	return retval;
+}
+
+/** Deliver a datagram to a client.
+ *
+ * Between inet_recv_begin() and inet_recv_end() datagrams are batched
+ * per client so that they reach the client in as few messages as
+ * possible.
+ *
+ * @param client Client
+ * @param dgram  Datagram
+ * @return EOK on success or an error code
+ */
+errno_t inet_ev_recv(inet_client_t *client, inet_dgram_t *dgram)
+{
+	size_t rsize = sizeof(inet_recv_hdr_t) + dgram->size;
+	inet_rbatch_t *full = NULL;
+	inet_rbatch_t *rbatch;
+	inet_recv_hdr_t hdr;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_ev_recv: iplink=%zu",
+	    dgram->iplink);
+
+	fibril_mutex_lock(&rbatch_lock);
+
+	rbatch = client->rbatch;
+	if (rbatch != NULL && (recv_depth == 0 ||
+	    rbatch->size + rsize > DATA_XFER_LIMIT)) {
+		full = rbatch;
+		client->rbatch = rbatch = NULL;
+	}
+
+	if (rbatch == NULL && recv_depth > 0 && rsize <= DATA_XFER_LIMIT) {
+		rbatch = malloc(sizeof(inet_rbatch_t));
+		if (rbatch != NULL) {
+			rbatch->sess = client->sess;
+			rbatch->count = 0;
+			rbatch->size = 0;
+			client->rbatch = rbatch;
+		}
+	}
+
+	if (rbatch != NULL) {
+		hdr.src = dgram->src;
+		hdr.dest = dgram->dest;
+		hdr.tos = dgram->tos;
+		hdr.iplink = dgram->iplink;
+		hdr.size = dgram->size;
+
+		memcpy(rbatch->data + rbatch->size, &hdr, sizeof(hdr));
+		memcpy(rbatch->data + rbatch->size + sizeof(hdr), dgram->data,
+		    dgram->size);
+		rbatch->size += rsize;
+		rbatch->count++;
+	}
+
+	fibril_mutex_unlock(&rbatch_lock);
+
+	/* Datagrams batched before this one go first */
+	if (full != NULL)
+		(void) inet_rbatch_send(full);
+
+	if (rbatch != NULL)
+		return EOK;
+
+	return inet_ev_recv_send(client->sess, dgram);
+}
+
+/** Start batching datagrams for delivery to clients.
+ *
+ * Called before passing datagrams received at once to the clients.
+ */
+void inet_recv_begin(void)
+{
+	fibril_mutex_lock(&rbatch_lock);
+	recv_depth++;
+	fibril_mutex_unlock(&rbatch_lock);
+}
+
+/** Deliver batched datagrams to clients.
+ *
+ * Called after passing datagrams received at once to the clients.
+ */
+void inet_recv_end(void)
+{
+	list_t batches;
+
+	list_initialize(&batches);
+
+	fibril_mutex_lock(&client_list_lock);
+	fibril_mutex_lock(&rbatch_lock);
+
+	assert(recv_depth > 0);
+	recv_depth--;
+
+	list_foreach(client_list, client_list, inet_client_t, client) {
+		if (client->rbatch != NULL) {
+			list_append(&client->rbatch->lbatch, &batches);
+			client->rbatch = NULL;
+		}
+	}
+
+	fibril_mutex_unlock(&rbatch_lock);
+	fibril_mutex_unlock(&client_list_lock);
+
+	while (!list_empty(&batches)) {
+		inet_rbatch_t *rbatch = list_get_instance(list_first(&batches),
+		    inet_rbatch_t, lbatch);
+
+		list_remove(&rbatch->lbatch);
+		(void) inet_rbatch_send(rbatch);
+	}
+}
+
 errno_t inet_recv_dgram_local(inet_dgram_t *dgram, uint8_t proto)
 {
 	inet_client_t *client;
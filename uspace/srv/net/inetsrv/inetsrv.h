@@ -47,11 +47,15 @@
 #include <types/inet.h>
 #include <async.h>
 
+struct inet_rbatch;
+
 /** Inet Client */
 typedef struct {
 	async_sess_t *sess;
 	uint8_t protocol;
 	link_t client_list;
+	/** Datagrams batched for delivery or @c NULL */
+	struct inet_rbatch *rbatch;
 } inet_client_t;
 
 /** Inetping Client */
@@ -123,6 +127,8 @@ typedef struct {
 /** Static route configuration */
 typedef struct {
 	link_t sroute_list;
+	/** Link to the routes with the same prefix in the route trie */
+	link_t trie_link;
 	sysarg_t id;
 	/** Destination network */
 	inet_naddr_t dest;
@@ -151,6 +157,8 @@ typedef struct {
 } inet_dir_t;
 
 extern errno_t inet_ev_recv(inet_client_t *, inet_dgram_t *);
+extern void inet_recv_begin(void);
+extern void inet_recv_end(void);
 extern errno_t inet_recv_packet(inet_packet_t *);
 extern errno_t inet_route_packet(inet_dgram_t *, uint8_t, uint8_t, int);
 extern errno_t inet_get_srcaddr(inet_addr_t *, uint8_t, inet_addr_t *);
@@ -44,9 +44,6 @@
 #include "inet_link.h"
 #include "ndp.h"
 
-/** Time to wait for NDP reply in microseconds */
-#define NDP_REQUEST_TIMEOUT  (3 * 1000 * 1000)
-
 static addr128_t solicited_node_ip =
     { 0xff, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xff, 0, 0, 0 };
 
@@ -141,17 +138,26 @@ errno_t ndp_received(inet_dgram_t *dgram)
 
 /** Translate IPv6 to MAC address
  *
- * @param src  Source IPv6 address
- * @param dest Destination IPv6 address
- * @param mac  Target MAC address to be assigned
- * @param link Network interface
+ * If the address is not known yet, the datagram is queued and sent
+ * when the neighbour advertisement arrives.
+ *
+ * @param src   Source IPv6 address
+ * @param dest  Destination IPv6 address
+ * @param mac   Target MAC address to be assigned
+ * @param link  Network interface
+ * @param dgram Datagram to be sent
+ * @param proto Protocol
+ * @param ttl   Time to live
+ * @param df    Do not fragment
  *
  * @return EOK on success
- * @return ENOENT when NDP translation failed
+ * @return EINPROGRESS if the datagram was queued
+ * @return ENOMEM if out of memory
  *
  */
 errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, addr48_t mac_addr,
-    inet_link_t *ilink)
+    inet_link_t *ilink, inet_dgram_t *dgram, uint8_t proto, uint8_t ttl,
+    int df)
 {
 	if (!ilink->mac_valid) {
 		/* The link does not support NDP */
@@ -159,10 +165,21 @@ errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, addr48_t mac_addr,
 		return EOK;
 	}
 
-	errno_t rc = ntrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	return ntrans_resolve(ilink, src_addr, ip_addr, dgram, proto, ttl, df,
+	    mac_addr);
+}
 
+/** Send neighbour solicitation
+ *
+ * @param ilink    Network interface
+ * @param src_addr Source IPv6 address
+ * @param ip_addr  Solicited IPv6 address
+ *
+ * @return EOK on success or an error code
+ *
+ */
+errno_t ndp_solicit(inet_link_t *ilink, addr128_t src_addr, addr128_t ip_addr)
+{
 	ndp_packet_t packet;
 
 	packet.opcode = ICMPV6_NEIGHBOUR_SOLICITATION;
@@ -172,11 +189,5 @@ errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, addr48_t mac_addr,
 	addr48_solicited_node(ip_addr, packet.target_hw_addr);
 	ndp_solicited_node_ip(ip_addr, packet.target_proto_addr);
 
-	rc = ndp_send_packet(ilink, &packet);
-	if (rc != EOK)
-		return rc;
-
-	(void) ntrans_wait_timeout(NDP_REQUEST_TIMEOUT);
-
-	return ntrans_lookup(ip_addr, mac_addr);
+	return ndp_send_packet(ilink, &packet);
 }
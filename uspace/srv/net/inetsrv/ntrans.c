@@ -34,66 +34,317 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <inet/iplink_srv.h>
+#include <mem.h>
 #include <stdlib.h>
+
+#include "inet_link.h"
+#include "ndp.h"
 #include "ntrans.h"
 
-/** Address translation list (of inet_ntrans_t) */
+/** Maximum number of entries in the translation table */
+#define NTRANS_MAX_ENTRIES  512
+/** Maximum number of datagrams waiting for one translation */
+#define NTRANS_MAX_PENDING  8
+/** Interval between neighbour solicitations in microseconds */
+#define NTRANS_PROBE_INTERVAL  (1000 * 1000)
+/** Number of unanswered solicitations after which an entry is dropped */
+#define NTRANS_MAX_PROBES  3
+/** Time for which a confirmed entry stays reachable in seconds */
+#define NTRANS_REACHABLE_TIME  30
+/** Time after which an unused stale entry is dropped in seconds */
+#define NTRANS_STALE_TIME  600
+/** Maximum number of solicitations sent by one aging pass */
+#define NTRANS_PROBE_BATCH  16
+
+/** Neighbour solicitation to be sent */
+typedef struct {
+	inet_link_t *ilink;
+	addr128_t src_addr;
+	addr128_t ip_addr;
+} ntrans_probe_t;
+
+/** Address translation table (of inet_ntrans_t) */
 static FIBRIL_MUTEX_INITIALIZE(ntrans_list_lock);
-static LIST_INITIALIZE(ntrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
+static hash_table_t ntrans_map;
+/** Entries, least recently used first */
+static LIST_INITIALIZE(ntrans_lru);
+
+static size_t ntrans_key_hash(const void *key)
+{
+	const uint8_t *addr = key;
+	size_t hash = 0;
+
+	for (size_t i = 0; i < sizeof(addr128_t); i++)
+		hash = hash_combine(hash, addr[i]);
+
+	return hash_mix(hash);
+}
+
+static size_t ntrans_hash(const ht_link_t *item)
+{
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_map);
+	return ntrans_key_hash(&ntrans->ip_addr);
+}
+
+static bool ntrans_key_equal(const void *key, const ht_link_t *item)
+{
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_map);
+	return addr128_compare(ntrans->ip_addr, key);
+}
+
+static hash_table_ops_t ntrans_map_ops = {
+	.hash = ntrans_hash,
+	.key_hash = ntrans_key_hash,
+	.key_equal = ntrans_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
+{
+	ht_link_t *link = hash_table_find(&ntrans_map, ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, inet_ntrans_t, ntrans_map);
+}
+
+/** Free datagrams from a list of pending datagrams. */
+static void ntrans_pending_free(list_t *pending)
+{
+	while (!list_empty(pending)) {
+		inet_ntrans_pending_t *pend = list_get_instance(
+		    list_first(pending), inet_ntrans_pending_t, lpending);
 
-/** Look for address in translation table
+		list_remove(&pend->lpending);
+		free(pend->dgram.data);
+		free(pend);
+	}
+}
+
+/** Remove entry from the table.
  *
- * @param ip_addr IPv6 address
+ * The entry and the datagrams waiting for it are freed with
+ * ntrans_free() once the table lock is released.
  *
- * @return inet_ntrans_t with the address on success
- * @return NULL if nothing found
+ * @param ntrans Entry
+ * @param dead   List to move the entry to
  */
-static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
+static void ntrans_unlink(inet_ntrans_t *ntrans, list_t *dead)
+{
+	hash_table_remove_item(&ntrans_map, &ntrans->ntrans_map);
+	list_remove(&ntrans->ntrans_lru);
+	list_append(&ntrans->ntrans_lru, dead);
+}
+
+/** Free entries removed from the table. */
+static void ntrans_free(list_t *dead)
+{
+	while (!list_empty(dead)) {
+		inet_ntrans_t *ntrans = list_get_instance(list_first(dead),
+		    inet_ntrans_t, ntrans_lru);
+
+		list_remove(&ntrans->ntrans_lru);
+		ntrans_pending_free(&ntrans->pending);
+		free(ntrans);
+	}
+}
+
+/** Create a new entry in the table.
+ *
+ * If the table is full, the least recently used entry is dropped.
+ *
+ * @param ip_addr IP address
+ * @param dead    List to move the dropped entry to
+ * @return New entry or @c NULL if out of memory
+ */
+static inet_ntrans_t *ntrans_create(addr128_t ip_addr, list_t *dead)
+{
+	inet_ntrans_t *ntrans = calloc(1, sizeof(inet_ntrans_t));
+	if (ntrans == NULL)
+		return NULL;
+
+	if (hash_table_size(&ntrans_map) >= NTRANS_MAX_ENTRIES) {
+		ntrans_unlink(list_get_instance(list_first(&ntrans_lru),
+		    inet_ntrans_t, ntrans_lru), dead);
+	}
+
+	addr128(ip_addr, ntrans->ip_addr);
+	list_initialize(&ntrans->pending);
+	hash_table_insert(&ntrans_map, &ntrans->ntrans_map);
+	list_append(&ntrans->ntrans_lru, &ntrans_lru);
+
+	return ntrans;
+}
+
+/** Mark entry as recently used. */
+static void ntrans_touch(inet_ntrans_t *ntrans)
+{
+	list_remove(&ntrans->ntrans_lru);
+	list_append(&ntrans->ntrans_lru, &ntrans_lru);
+}
+
+/** Send datagrams resolved to a MAC address and free them. */
+static void ntrans_pending_send(list_t *pending, addr48_t mac_addr)
+{
+	while (!list_empty(pending)) {
+		inet_ntrans_pending_t *pend = list_get_instance(
+		    list_first(pending), inet_ntrans_pending_t, lpending);
+
+		list_remove(&pend->lpending);
+		(void) inet_link_send_dgram6(pend->ilink, mac_addr,
+		    &pend->dgram, pend->proto, pend->ttl, pend->df);
+		free(pend->dgram.data);
+		free(pend);
+	}
+}
+
+/** Age the translation table.
+ *
+ * Stale entries and unresolved entries are probed with solicitations
+ * and dropped when the requests stay unanswered.
+ */
+static void ntrans_age(void)
+{
+	ntrans_probe_t probes[NTRANS_PROBE_BATCH];
+	size_t nprobes = 0;
+	struct timespec now;
+	list_t dead;
+
+	list_initialize(&dead);
+	getuptime(&now);
+
+	fibril_mutex_lock(&ntrans_list_lock);
+
+	list_foreach_safe(ntrans_lru, cur, next) {
+		inet_ntrans_t *ntrans = list_get_instance(cur, inet_ntrans_t,
+		    ntrans_lru);
+		nsec_t age = ts_sub_diff(&now, &ntrans->updated);
+
+		if (ntrans->state == ntrans_reachable) {
+			if (age >= SEC2NSEC(NTRANS_REACHABLE_TIME))
+				ntrans->state = ntrans_stale;
+			continue;
+		}
+
+		if (ntrans->probes == 0) {
+			/* Stale entry nobody asked for */
+			if (age >= SEC2NSEC(NTRANS_STALE_TIME))
+				ntrans_unlink(ntrans, &dead);
+			continue;
+		}
+
+		if (age < USEC2NSEC(NTRANS_PROBE_INTERVAL))
+			continue;
+
+		if (ntrans->probes >= NTRANS_MAX_PROBES) {
+			ntrans_unlink(ntrans, &dead);
+			continue;
+		}
+
+		if (nprobes < NTRANS_PROBE_BATCH) {
+			probes[nprobes].ilink = ntrans->ilink;
+			addr128(ntrans->src_addr, probes[nprobes].src_addr);
+			addr128(ntrans->ip_addr, probes[nprobes].ip_addr);
+			nprobes++;
+
+			ntrans->probes++;
+			ntrans->updated = now;
+		}
+	}
+
+	fibril_mutex_unlock(&ntrans_list_lock);
+
+	ntrans_free(&dead);
+
+	for (size_t i = 0; i < nprobes; i++) {
+		(void) ndp_solicit(probes[i].ilink, probes[i].src_addr,
+		    probes[i].ip_addr);
+	}
+}
+
+static errno_t ntrans_age_fibril(void *arg)
 {
-	list_foreach(ntrans_list, ntrans_list, inet_ntrans_t, ntrans) {
-		if (addr128_compare(ntrans->ip_addr, ip_addr))
-			return ntrans;
+	(void) arg;
+
+	while (true) {
+		fibril_usleep(NTRANS_PROBE_INTERVAL);
+		ntrans_age();
 	}
 
-	return NULL;
+	return EOK;
 }
 
-/** Add entry to translation table
+/** Initialize address translation.
  *
- * @param ip_addr  IPv6 address of the new entry
- * @param mac_addr MAC address of the new entry
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t ntrans_init(void)
+{
+	fid_t fid;
+
+	if (!hash_table_create(&ntrans_map, 0, 0, &ntrans_map_ops))
+		return ENOMEM;
+
+	fid = fibril_create(ntrans_age_fibril, NULL);
+	if (fid == 0) {
+		hash_table_destroy(&ntrans_map);
+		return ENOMEM;
+	}
+
+	fibril_add_ready(fid);
+	return EOK;
+}
+
+/** Add or confirm address translation.
  *
- * @return EOK on success
- * @return ENOMEM if not enough memory
+ * Datagrams waiting for the translation are sent.
  *
+ * @param ip_addr  IP address
+ * @param mac_addr MAC address
+ * @return EOK on success, ENOMEM if out of memory
  */
 errno_t ntrans_add(addr128_t ip_addr, addr48_t mac_addr)
 {
 	inet_ntrans_t *ntrans;
-	inet_ntrans_t *prev;
+	list_t pending;
+	list_t dead;
 
-	ntrans = calloc(1, sizeof(inet_ntrans_t));
-	if (ntrans == NULL)
-		return ENOMEM;
-
-	addr128(ip_addr, ntrans->ip_addr);
-	addr48(mac_addr, ntrans->mac_addr);
+	list_initialize(&pending);
+	list_initialize(&dead);
 
 	fibril_mutex_lock(&ntrans_list_lock);
-	prev = ntrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->ntrans_list);
-		free(prev);
+
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans == NULL) {
+		ntrans = ntrans_create(ip_addr, &dead);
+		if (ntrans == NULL) {
+			fibril_mutex_unlock(&ntrans_list_lock);
+			return ENOMEM;
+		}
 	}
 
-	list_append(&ntrans->ntrans_list, &ntrans_list);
+	addr48(mac_addr, ntrans->mac_addr);
+	ntrans->state = ntrans_reachable;
+	ntrans->probes = 0;
+	getuptime(&ntrans->updated);
+
+	list_concat(&pending, &ntrans->pending);
+	ntrans->npending = 0;
+
 	fibril_mutex_unlock(&ntrans_list_lock);
-	fibril_condvar_broadcast(&ntrans_cv);
+
+	ntrans_free(&dead);
+	ntrans_pending_send(&pending, mac_addr);
 
 	return EOK;
 }
@@ -109,6 +360,9 @@ errno_t ntrans_add(addr128_t ip_addr, addr48_t mac_addr)
 errno_t ntrans_remove(addr128_t ip_addr)
 {
 	inet_ntrans_t *ntrans;
+	list_t dead;
+
+	list_initialize(&dead);
 
 	fibril_mutex_lock(&ntrans_list_lock);
 	ntrans = ntrans_find(ip_addr);
@@ -117,9 +371,9 @@ errno_t ntrans_remove(addr128_t ip_addr)
 		return ENOENT;
 	}
 
-	list_remove(&ntrans->ntrans_list);
+	ntrans_unlink(ntrans, &dead);
 	fibril_mutex_unlock(&ntrans_list_lock);
-	free(ntrans);
+	ntrans_free(&dead);
 
 	return EOK;
 }
@@ -135,33 +389,130 @@ errno_t ntrans_remove(addr128_t ip_addr)
  */
 errno_t ntrans_lookup(addr128_t ip_addr, addr48_t mac_addr)
 {
+	inet_ntrans_t *ntrans;
+	errno_t rc = ENOENT;
+
 	fibril_mutex_lock(&ntrans_list_lock);
-	inet_ntrans_t *ntrans = ntrans_find(ip_addr);
-	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
-		return ENOENT;
+
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans != NULL && ntrans->state != ntrans_incomplete) {
+		addr48(ntrans->mac_addr, mac_addr);
+		rc = EOK;
 	}
 
 	fibril_mutex_unlock(&ntrans_list_lock);
-	addr48(ntrans->mac_addr, mac_addr);
-	return EOK;
+	return rc;
 }
 
-/** Wait on translation table CV for some time
+/** Translate IP address for sending a datagram.
  *
- * @param timeout Timeout in microseconds
- *
- * @return EOK if woken up by another fibril
- * @return ETIMEOUT if timed out
+ * If the MAC address is not known yet, a copy of the datagram is queued
+ * and sent as soon as a neighbour advertisement arrives. Neighbour
+ * solicitations are sent as needed. A stale translation is still used,
+ * but it is refreshed.
  *
+ * @param ilink    Link to send solicitations and the datagram through
+ * @param src_addr Source address for solicitations
+ * @param ip_addr  IP address to translate
+ * @param dgram    Datagram
+ * @param proto    Protocol
+ * @param ttl      Time to live
+ * @param df       Do not fragment
+ * @param mac_addr Place to store the MAC address
+ * @return EOK if @a mac_addr was filled in, EINPROGRESS if the datagram
+ *         was queued, ENOMEM if out of memory
  */
-errno_t ntrans_wait_timeout(usec_t timeout)
+errno_t ntrans_resolve(inet_link_t *ilink, addr128_t src_addr,
+    addr128_t ip_addr, inet_dgram_t *dgram, uint8_t proto, uint8_t ttl,
+    int df, addr48_t mac_addr)
 {
+	inet_ntrans_t *ntrans;
+	inet_ntrans_pending_t *pend;
+	bool probe = false;
+	list_t dead;
+	errno_t rc;
+
+	list_initialize(&dead);
+
 	fibril_mutex_lock(&ntrans_list_lock);
-	errno_t rc = fibril_condvar_wait_timeout(&ntrans_cv, &ntrans_list_lock,
-	    timeout);
+
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans != NULL && ntrans->state != ntrans_incomplete) {
+		addr48(ntrans->mac_addr, mac_addr);
+		ntrans_touch(ntrans);
+
+		if (ntrans->state == ntrans_stale && ntrans->probes == 0)
+			probe = true;
+
+		rc = EOK;
+		goto out;
+	}
+
+	pend = calloc(1, sizeof(inet_ntrans_pending_t));
+	if (pend != NULL)
+		pend->dgram.data = malloc(dgram->size);
+	if (pend == NULL || pend->dgram.data == NULL) {
+		free(pend);
+		rc = ENOMEM;
+		goto out;
+	}
+
+	if (ntrans == NULL) {
+		ntrans = ntrans_create(ip_addr, &dead);
+		if (ntrans == NULL) {
+			free(pend->dgram.data);
+			free(pend);
+			rc = ENOMEM;
+			goto out;
+		}
+
+		ntrans->state = ntrans_incomplete;
+		probe = true;
+	}
+
+	pend->dgram.iplink = dgram->iplink;
+	pend->dgram.src = dgram->src;
+	pend->dgram.dest = dgram->dest;
+	pend->dgram.tos = dgram->tos;
+	memcpy(pend->dgram.data, dgram->data, dgram->size);
+	pend->dgram.size = dgram->size;
+	pend->ilink = ilink;
+	pend->proto = proto;
+	pend->ttl = ttl;
+	pend->df = df;
+
+	/* Drop the oldest datagram if too many are waiting */
+	if (ntrans->npending >= NTRANS_MAX_PENDING) {
+		inet_ntrans_pending_t *old = list_get_instance(
+		    list_first(&ntrans->pending), inet_ntrans_pending_t,
+		    lpending);
+
+		list_remove(&old->lpending);
+		free(old->dgram.data);
+		free(old);
+		ntrans->npending--;
+	}
+
+	list_append(&pend->lpending, &ntrans->pending);
+	ntrans->npending++;
+	ntrans_touch(ntrans);
+	rc = EINPROGRESS;
+
+out:
+	if (probe) {
+		ntrans->ilink = ilink;
+		addr128(src_addr, ntrans->src_addr);
+		ntrans->probes = 1;
+		getuptime(&ntrans->updated);
+	}
+
 	fibril_mutex_unlock(&ntrans_list_lock);
 
+	ntrans_free(&dead);
+
+	if (probe)
+		(void) ndp_solicit(ilink, src_addr, ip_addr);
+
 	return rc;
 }
 
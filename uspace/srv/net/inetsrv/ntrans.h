@@ -37,20 +37,63 @@
 #ifndef NTRANS_H_
 #define NTRANS_H_
 
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <inet/iplink_srv.h>
 #include <inet/addr.h>
+#include <time.h>
+#include "inetsrv.h"
+
+/** Address translation state */
+typedef enum {
+	/** Waiting for neighbour advertisement */
+	ntrans_incomplete,
+	/** Confirmed by a recent NDP packet */
+	ntrans_reachable,
+	/** Not confirmed for a while, still used */
+	ntrans_stale
+} inet_ntrans_state_t;
 
 /** Address translation table element */
 typedef struct {
-	link_t ntrans_list;
+	/** Link to the translation table */
+	ht_link_t ntrans_map;
+	/** Link to the list of entries, least recently used first */
+	link_t ntrans_lru;
 	addr128_t ip_addr;
 	addr48_t mac_addr;
+	inet_ntrans_state_t state;
+	/** Time of the last confirmation or of the last solicitation */
+	struct timespec updated;
+	/** Number of solicitations sent since the last confirmation */
+	unsigned probes;
+	/** Link to send neighbour solicitations through */
+	inet_link_t *ilink;
+	/** Source address for neighbour solicitations */
+	addr128_t src_addr;
+	/** Datagrams waiting for the translation (inet_ntrans_pending_t) */
+	list_t pending;
+	/** Number of datagrams in @c pending */
+	size_t npending;
 } inet_ntrans_t;
 
+/** Datagram waiting for address translation */
+typedef struct {
+	link_t lpending;
+	inet_link_t *ilink;
+	/** Datagram, the data is owned by the pending entry */
+	inet_dgram_t dgram;
+	uint8_t proto;
+	uint8_t ttl;
+	int df;
+} inet_ntrans_pending_t;
+
+extern errno_t ntrans_init(void);
 extern errno_t ntrans_add(addr128_t, addr48_t);
 extern errno_t ntrans_remove(addr128_t);
 extern errno_t ntrans_lookup(addr128_t, addr48_t);
-extern errno_t ntrans_wait_timeout(usec_t);
+extern errno_t ntrans_resolve(inet_link_t *, addr128_t, addr128_t,
+    inet_dgram_t *, uint8_t, uint8_t, int, addr48_t);
 
 #endif
 
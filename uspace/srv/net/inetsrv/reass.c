@@ -34,40 +34,94 @@
  * @brief Datagram reassembly.
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <adt/odict.h>
 #include <errno.h>
+#include <fibril.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "inetsrv.h"
 #include "inet_std.h"
 #include "reass.h"
 
+/** Reassembly timeout in seconds (RFC 791 recommends at least 15 s) */
+#define REASS_TIMEOUT  30
+/** Interval between reassembly timeout checks in microseconds */
+#define REASS_CHECK_INTERVAL  (1000 * 1000)
+/** Memory budget for all datagrams being reassembled in bytes */
+#define REASS_MEM_MAX  (1024 * 1024)
+
 /** Datagram being reassembled.
  *
  * Uniquely identified by (source address, destination address, protocol,
  * identification) per RFC 791 sec. 2.3 / Fragmentation.
  */
 typedef struct {
-	link_t map_link;
-	/** List of fragments, @c reass_frag_t */
-	list_t frags;
+	/** Link to @c reass_dgram_map */
+	ht_link_t map_link;
+	/** Link to @c reass_lru */
+	link_t lru_link;
+	/** Link to @c reass_timeout_list */
+	link_t timeout_link;
+	/** Source address */
+	inet_addr_t src;
+	/** Destination address */
+	inet_addr_t dest;
+	/** Protocol */
+	uint8_t proto;
+	/** Identification */
+	uint32_t ident;
+	/** Non-overlapping fragments ordered by offset, @c reass_frag_t */
+	odict_t frags;
+	/** Number of data bytes received */
+	size_t rcvd;
+	/** Datagram size, valid once the last fragment arrived */
+	size_t size;
+	/** The last fragment has arrived */
+	bool have_last;
+	/** Memory charged to the reassembly budget */
+	size_t mem;
+	/** Time after which reassembly is abandoned */
+	struct timespec expires;
 } reass_dgram_t;
 
 /** One datagram fragment */
 typedef struct {
-	link_t dgram_link;
+	/** Link to @c reass_dgram_t.frags */
+	odlink_t dgram_link;
+	/** Fragment, data trimmed so as not to overlap other fragments */
 	inet_packet_t packet;
 } reass_frag_t;
 
-/** Datagram map, list of reass_dgram_t */
-static LIST_INITIALIZE(reass_dgram_map);
-/** Protects access to @c reass_dgram_map */
+/** Key of datagram being reassembled */
+typedef struct {
+	inet_addr_t *src;
+	inet_addr_t *dest;
+	uint8_t proto;
+	uint32_t ident;
+} reass_key_t;
+
+/** Datagram map, hash table of reass_dgram_t */
+static hash_table_t reass_dgram_map;
+/** Datagrams, least recently updated first */
+static LIST_INITIALIZE(reass_lru);
+/** Datagrams in order of expiration */
+static LIST_INITIALIZE(reass_timeout_list);
+/** Memory used by datagrams being reassembled */
+static size_t reass_mem;
+/** Reassembly statistics */
+static inet_reass_stats_t reass_stats;
+/** Protects access to @c reass_dgram_map and the lists */
 static FIBRIL_MUTEX_INITIALIZE(reass_dgram_map_lock);
 
-static reass_dgram_t *reass_dgram_new(void);
+static reass_dgram_t *reass_dgram_new(inet_packet_t *);
 static reass_dgram_t *reass_dgram_get(inet_packet_t *);
 static errno_t reass_dgram_insert_frag(reass_dgram_t *, inet_packet_t *);
 static bool reass_dgram_complete(reass_dgram_t *);
@@ -75,10 +129,193 @@ static void reass_dgram_remove(reass_dgram_t *);
 static errno_t reass_dgram_deliver(reass_dgram_t *);
 static void reass_dgram_destroy(reass_dgram_t *);
 
+static size_t reass_addr_hash(size_t hash, inet_addr_t *addr)
+{
+	hash = hash_combine(hash, addr->version);
+
+	if (addr->version == ip_v4)
+		return hash_combine(hash, addr->addr);
+
+	for (size_t i = 0; i < sizeof(addr128_t); i++)
+		hash = hash_combine(hash, addr->addr6[i]);
+
+	return hash;
+}
+
+static size_t reass_key_hash(const void *arg)
+{
+	const reass_key_t *key = arg;
+	size_t hash;
+
+	hash = hash_combine(key->proto, key->ident);
+	hash = reass_addr_hash(hash, key->src);
+	hash = reass_addr_hash(hash, key->dest);
+
+	return hash_mix(hash);
+}
+
+static size_t reass_dgram_hash(const ht_link_t *item)
+{
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+	reass_key_t key = {
+		.src = &rdg->src,
+		.dest = &rdg->dest,
+		.proto = rdg->proto,
+		.ident = rdg->ident
+	};
+
+	return reass_key_hash(&key);
+}
+
+static bool reass_key_equal(const void *arg, const ht_link_t *item)
+{
+	const reass_key_t *key = arg;
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+
+	return inet_addr_compare(&rdg->src, key->src) &&
+	    inet_addr_compare(&rdg->dest, key->dest) &&
+	    rdg->proto == key->proto && rdg->ident == key->ident;
+}
+
+static hash_table_ops_t reass_dgram_map_ops = {
+	.hash = reass_dgram_hash,
+	.key_hash = reass_key_hash,
+	.key_equal = reass_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static void *reass_frag_getkey(odlink_t *odlink)
+{
+	reass_frag_t *frag = odict_get_instance(odlink, reass_frag_t,
+	    dgram_link);
+
+	return &frag->packet.offs;
+}
+
+static int reass_frag_cmp(void *a, void *b)
+{
+	size_t oa = *(size_t *) a;
+	size_t ob = *(size_t *) b;
+
+	if (oa < ob)
+		return -1;
+	if (oa > ob)
+		return 1;
+	return 0;
+}
+
+/** Abandon reassembly of datagrams that timed out. */
+static void reass_timeout(void)
+{
+	struct timespec now;
+	reass_dgram_t *rdg;
+
+	getuptime(&now);
+
+	fibril_mutex_lock(&reass_dgram_map_lock);
+
+	while (!list_empty(&reass_timeout_list)) {
+		rdg = list_get_instance(list_first(&reass_timeout_list),
+		    reass_dgram_t, timeout_link);
+		if (ts_gt(&rdg->expires, &now))
+			break;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly timed out, "
+		    "datagram dropped.");
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+		++reass_stats.timeouts;
+	}
+
+	fibril_mutex_unlock(&reass_dgram_map_lock);
+}
+
+static errno_t reass_timeout_fibril(void *arg)
+{
+	(void) arg;
+
+	while (true) {
+		fibril_usleep(REASS_CHECK_INTERVAL);
+		reass_timeout();
+	}
+
+	return EOK;
+}
+
+/** Initialize datagram reassembly.
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t inet_reass_init(void)
+{
+	fid_t fid;
+
+	if (!hash_table_create(&reass_dgram_map, 0, 0, &reass_dgram_map_ops))
+		return ENOMEM;
+
+	fid = fibril_create(reass_timeout_fibril, NULL);
+	if (fid == 0) {
+		hash_table_destroy(&reass_dgram_map);
+		return ENOMEM;
+	}
+
+	fibril_add_ready(fid);
+	return EOK;
+}
+
+/** Get reassembly statistics.
+ *
+ * @param stats Place to store the statistics
+ */
+void inet_reass_get_stats(inet_reass_stats_t *stats)
+{
+	fibril_mutex_lock(&reass_dgram_map_lock);
+	*stats = reass_stats;
+	stats->dgrams = hash_table_size(&reass_dgram_map);
+	stats->mem = reass_mem;
+	fibril_mutex_unlock(&reass_dgram_map_lock);
+}
+
+/** Make room in the reassembly budget.
+ *
+ * Datagrams that have not been updated for the longest time are dropped.
+ *
+ * @param size Number of bytes needed
+ * @param keep Datagram which must not be dropped
+ * @return @c true if there is enough room now
+ */
+static bool reass_mem_reserve(size_t size, reass_dgram_t *keep)
+{
+	reass_dgram_t *rdg;
+
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+
+	while (reass_mem + size > REASS_MEM_MAX) {
+		if (list_empty(&reass_lru))
+			return false;
+
+		rdg = list_get_instance(list_first(&reass_lru),
+		    reass_dgram_t, lru_link);
+		if (rdg == keep)
+			return false;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly memory exhausted, "
+		    "datagram dropped.");
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+		++reass_stats.evicted;
+	}
+
+	return true;
+}
+
 /** Queue packet for datagram reassembly.
  *
  * @param packet	Packet
- * @return		EOK on success or ENOMEM.
+ * @return		EOK on success or an error code.
  */
 errno_t inet_reass_queue_packet(inet_packet_t *packet)
 {
@@ -89,24 +326,42 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 	fibril_mutex_lock(&reass_dgram_map_lock);
 
+	++reass_stats.frags;
+
 	/* Get existing or new datagram */
 	rdg = reass_dgram_get(packet);
 	if (rdg == NULL) {
 		/* Only happens when we are out of memory */
+		++reass_stats.frags_dropped;
 		fibril_mutex_unlock(&reass_dgram_map_lock);
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Allocation failed, packet dropped.");
 		return ENOMEM;
 	}
 
+	/* Most recently updated datagrams are evicted last */
+	list_remove(&rdg->lru_link);
+	list_append(&rdg->lru_link, &reass_lru);
+
 	/* Insert fragment into the datagram */
 	rc = reass_dgram_insert_frag(rdg, packet);
-	if (rc != EOK)
-		return ENOMEM;
+	if (rc != EOK) {
+		++reass_stats.frags_dropped;
+
+		/* Do not keep a datagram that has nothing but a bad fragment */
+		if (rc == EINVAL || odict_empty(&rdg->frags)) {
+			reass_dgram_remove(rdg);
+			reass_dgram_destroy(rdg);
+		}
+
+		fibril_mutex_unlock(&reass_dgram_map_lock);
+		return rc;
+	}
 
 	/* Check if datagram is complete */
 	if (reass_dgram_complete(rdg)) {
 		/* Remove it from the map */
 		reass_dgram_remove(rdg);
+		++reass_stats.reassembled;
 		fibril_mutex_unlock(&reass_dgram_map_lock);
 
 		/* Deliver complete datagram */
@@ -126,107 +381,177 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
  */
 static reass_dgram_t *reass_dgram_get(inet_packet_t *packet)
 {
-	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+	reass_key_t key;
+	ht_link_t *link;
 
-	list_foreach(reass_dgram_map, map_link, reass_dgram_t, rdg) {
-		link_t *f1_link = list_first(&rdg->frags);
-		assert(f1_link != NULL);
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-		reass_frag_t *f1 = list_get_instance(f1_link, reass_frag_t,
-		    dgram_link);
+	key.src = &packet->src;
+	key.dest = &packet->dest;
+	key.proto = packet->proto;
+	key.ident = packet->ident;
 
-		if ((inet_addr_compare(&f1->packet.src, &packet->src)) &&
-		    (inet_addr_compare(&f1->packet.dest, &packet->dest)) &&
-		    (f1->packet.proto == packet->proto) &&
-		    (f1->packet.ident == packet->ident)) {
-			/* Match */
-			return rdg;
-		}
-	}
+	link = hash_table_find(&reass_dgram_map, &key);
+	if (link != NULL)
+		return hash_table_get_inst(link, reass_dgram_t, map_link);
 
 	/* No existing reassembly structure. Create a new one. */
-	return reass_dgram_new();
+	return reass_dgram_new(packet);
 }
 
 /** Create new datagram reassembly structure.
  *
- * @return New datagram reassembly structure.
+ * @param packet	First received fragment of the datagram
+ * @return		New datagram reassembly structure.
  */
-static reass_dgram_t *reass_dgram_new(void)
+static reass_dgram_t *reass_dgram_new(inet_packet_t *packet)
 {
 	reass_dgram_t *rdg;
 
+	if (!reass_mem_reserve(sizeof(reass_dgram_t), NULL))
+		return NULL;
+
 	rdg = calloc(1, sizeof(reass_dgram_t));
 	if (rdg == NULL)
 		return NULL;
 
-	list_append(&rdg->map_link, &reass_dgram_map);
-	list_initialize(&rdg->frags);
+	rdg->src = packet->src;
+	rdg->dest = packet->dest;
+	rdg->proto = packet->proto;
+	rdg->ident = packet->ident;
+	odict_initialize(&rdg->frags, reass_frag_getkey, reass_frag_cmp);
+
+	getuptime(&rdg->expires);
+	rdg->expires.tv_sec += REASS_TIMEOUT;
+
+	rdg->mem = sizeof(reass_dgram_t);
+	reass_mem += rdg->mem;
+
+	hash_table_insert(&reass_dgram_map, &rdg->map_link);
+	list_append(&rdg->lru_link, &reass_lru);
+	list_append(&rdg->timeout_link, &reass_timeout_list);
 
 	return rdg;
 }
 
-static reass_frag_t *reass_frag_new(void)
+/** Insert part of a fragment filling a hole in the datagram.
+ *
+ * @param rdg		Datagram reassembly structure
+ * @param packet	Fragment
+ * @param b		Start of the part (datagram offset)
+ * @param e		End of the part (datagram offset)
+ * @return		EOK on success, ENOMEM if out of memory
+ */
+static errno_t reass_dgram_insert_part(reass_dgram_t *rdg,
+    inet_packet_t *packet, size_t b, size_t e)
 {
 	reass_frag_t *frag;
+	size_t mem;
+
+	mem = sizeof(reass_frag_t) + (e - b);
+	if (!reass_mem_reserve(mem, rdg))
+		return ENOMEM;
 
 	frag = calloc(1, sizeof(reass_frag_t));
 	if (frag == NULL)
-		return NULL;
+		return ENOMEM;
+
+	/* Clone the part of the packet */
+
+	frag->packet = *packet;
+	frag->packet.offs = b;
+	frag->packet.size = e - b;
+	frag->packet.data = malloc(e - b);
+	if (frag->packet.data == NULL) {
+		free(frag);
+		return ENOMEM;
+	}
+
+	memcpy(frag->packet.data, packet->data + (b - packet->offs), e - b);
 
-	link_initialize(&frag->dgram_link);
+	odlink_initialize(&frag->dgram_link);
+	odict_insert(&frag->dgram_link, &rdg->frags, NULL);
 
-	return frag;
+	rdg->rcvd += e - b;
+	rdg->mem += mem;
+	reass_mem += mem;
+	return EOK;
 }
 
+/** Insert fragment into datagram.
+ *
+ * Only the data not received yet is stored, so the fragments of the
+ * datagram never overlap and duplicates take no memory.
+ *
+ * @param rdg		Datagram reassembly structure
+ * @param packet	Fragment
+ * @return		EOK on success, EINVAL if the fragment is inconsistent
+ *			with the datagram, ELIMIT if the datagram would be
+ *			too large, ENOMEM if out of memory
+ */
 static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet)
 {
+	size_t fragoff_limit;
+	size_t b, e;
+	odlink_t *odlink;
 	reass_frag_t *frag;
-	void *data_copy;
-	link_t *link;
+	errno_t rc;
 
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-	frag = reass_frag_new();
-
-	/* Clone the packet */
+	b = packet->offs;
+	e = packet->offs + packet->size;
 
-	data_copy = malloc(packet->size);
-	if (data_copy == NULL) {
-		free(frag);
-		return ENOMEM;
-	}
-
-	memcpy(data_copy, packet->data, packet->size);
+	/* Upper bound for fragment offset field */
+	fragoff_limit = 1 << (FF_FRAGOFF_h - FF_FRAGOFF_l + 1);
 
-	frag->packet = *packet;
-	frag->packet.data = data_copy;
+	/* Verify that total size of datagram is within reasonable bounds */
+	if (e > FRAG_OFFS_UNIT * fragoff_limit)
+		return ELIMIT;
 
-	/*
-	 * XXX Make resource-consuming attacks harder, eliminate any duplicate
-	 * data immediately. Possibly eliminate redundant packet headers.
-	 */
+	if (!packet->mf) {
+		if (rdg->have_last && rdg->size != e)
+			return EINVAL;
+
+		/* Data beyond the end of the datagram */
+		odlink = odict_last(&rdg->frags);
+		if (odlink != NULL) {
+			frag = odict_get_instance(odlink, reass_frag_t,
+			    dgram_link);
+			if (frag->packet.offs + frag->packet.size > e)
+				return EINVAL;
+		}
 
-	/*
-	 * Insert into the list, which is sorted by offs member ascending.
-	 */
+		rdg->have_last = true;
+		rdg->size = e;
+	} else if (rdg->have_last && e > rdg->size) {
+		return EINVAL;
+	}
 
-	link = list_first(&rdg->frags);
-	while (link != NULL) {
-		reass_frag_t *qf = list_get_instance(link, reass_frag_t,
-		    dgram_link);
+	/* Skip data covered by the preceding fragment */
+	odlink = odict_find_leq(&rdg->frags, &b, NULL);
+	if (odlink != NULL) {
+		frag = odict_get_instance(odlink, reass_frag_t, dgram_link);
+		b = max(b, frag->packet.offs + frag->packet.size);
+	}
 
-		if (qf->packet.offs >= packet->offs)
-			break;
+	/* Fill in the holes between the following fragments */
+	while (b < e) {
+		odlink = odict_find_geq(&rdg->frags, &b, NULL);
+		if (odlink == NULL)
+			return reass_dgram_insert_part(rdg, packet, b, e);
+
+		frag = odict_get_instance(odlink, reass_frag_t, dgram_link);
+		if (frag->packet.offs > b) {
+			rc = reass_dgram_insert_part(rdg, packet, b,
+			    min(e, frag->packet.offs));
+			if (rc != EOK)
+				return rc;
+		}
 
-		link = list_next(link, &rdg->frags);
+		b = max(b, frag->packet.offs + frag->packet.size);
 	}
 
-	if (link != NULL)
-		list_insert_after(&frag->dgram_link, link);
-	else
-		list_append(&frag->dgram_link, &rdg->frags);
-
 	return EOK;
 }
 
@@ -237,42 +562,10 @@ static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet
  */
 static bool reass_dgram_complete(reass_dgram_t *rdg)
 {
-	reass_frag_t *frag, *prev;
-	link_t *link;
-
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	assert(!list_empty(&rdg->frags));
-
-	link = list_first(&rdg->frags);
-	assert(link != NULL);
-
-	frag = list_get_instance(link, reass_frag_t,
-	    dgram_link);
-
-	/* First fragment must be at offset zero */
-	if (frag->packet.offs != 0)
-		return false;
-
-	prev = frag;
-
-	while (true) {
-		link = list_next(link, &rdg->frags);
-		if (link == NULL)
-			break;
-
-		/* Each next fragment must follow immediately or overlap */
-		frag = list_get_instance(link, reass_frag_t, dgram_link);
-		if (frag->packet.offs > prev->packet.offs + prev->packet.size)
-			return false;
-
-		/* No more fragments - datagram is complete */
-		if (!frag->packet.mf)
-			return true;
 
-		prev = frag;
-	}
-
-	return false;
+	/* Fragments do not overlap, so no holes are left if sizes match */
+	return rdg->have_last && rdg->rcvd == rdg->size;
 }
 
 /** Remove datagram from reassembly map.
@@ -282,7 +575,13 @@ static bool reass_dgram_complete(reass_dgram_t *rdg)
 static void reass_dgram_remove(reass_dgram_t *rdg)
 {
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	list_remove(&rdg->map_link);
+
+	hash_table_remove_item(&reass_dgram_map, &rdg->map_link);
+	list_remove(&rdg->lru_link);
+	list_remove(&rdg->timeout_link);
+
+	assert(reass_mem >= rdg->mem);
+	reass_mem -= rdg->mem;
 }
 
 /** Deliver complete datagram.
@@ -291,44 +590,24 @@ static void reass_dgram_remove(reass_dgram_t *rdg)
  */
 static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
 {
-	size_t dgram_size;
-	size_t fragoff_limit;
 	inet_dgram_t dgram;
 	uint8_t proto;
 	reass_frag_t *frag;
+	odlink_t *odlink;
 	errno_t rc;
 
-	/*
-	 * Potentially there could be something beyond the first packet
-	 * that has !MF. Make sure we ignore that.
-	 */
-	frag = NULL;
-	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		if (!cfrag->packet.mf) {
-			frag = cfrag;
-			break;
-		}
-	}
-
-	assert(frag != NULL);
-	assert(!frag->packet.mf);
+	odlink = odict_first(&rdg->frags);
+	assert(odlink != NULL);
+	frag = odict_get_instance(odlink, reass_frag_t, dgram_link);
+	assert(frag->packet.offs == 0);
 
-	dgram_size = frag->packet.offs + frag->packet.size;
-
-	/* Upper bound for fragment offset field */
-	fragoff_limit = 1 << (FF_FRAGOFF_h - FF_FRAGOFF_l + 1);
-
-	/* Verify that total size of datagram is within reasonable bounds */
-	if (dgram_size > FRAG_OFFS_UNIT * fragoff_limit)
-		return ELIMIT;
-
-	dgram.data = calloc(dgram_size, 1);
+	dgram.data = malloc(rdg->size);
 	if (dgram.data == NULL)
 		return ENOMEM;
 
 	/* XXX What if different fragments came from different link? */
 	dgram.iplink = frag->packet.link_id;
-	dgram.size = dgram_size;
+	dgram.size = rdg->size;
 	dgram.src = frag->packet.src;
 	dgram.dest = frag->packet.dest;
 	dgram.tos = frag->packet.tos;
@@ -336,22 +615,11 @@ static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
 
 	/* Pull together data from individual fragments */
 
-	size_t doffs = 0;
-
-	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		size_t cb, ce;
-
-		cb = max(doffs, cfrag->packet.offs);
-		ce = min(dgram_size, cfrag->packet.offs + cfrag->packet.size);
-
-		if (ce > cb) {
-			memcpy(dgram.data + cb,
-			    cfrag->packet.data + cb - cfrag->packet.offs,
-			    ce - cb);
-		}
-
-		if (!cfrag->packet.mf)
-			break;
+	while (odlink != NULL) {
+		frag = odict_get_instance(odlink, reass_frag_t, dgram_link);
+		memcpy(dgram.data + frag->packet.offs, frag->packet.data,
+		    frag->packet.size);
+		odlink = odict_next(odlink, &rdg->frags);
 	}
 
 	rc = inet_recv_dgram_local(&dgram, proto);
@@ -365,16 +633,18 @@ static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
  */
 static void reass_dgram_destroy(reass_dgram_t *rdg)
 {
-	while (!list_empty(&rdg->frags)) {
-		link_t *flink = list_first(&rdg->frags);
-		reass_frag_t *frag = list_get_instance(flink, reass_frag_t,
+	odlink_t *odlink;
+
+	while ((odlink = odict_first(&rdg->frags)) != NULL) {
+		reass_frag_t *frag = odict_get_instance(odlink, reass_frag_t,
 		    dgram_link);
 
-		list_remove(&frag->dgram_link);
+		odict_remove(&frag->dgram_link);
 		free(frag->packet.data);
 		free(frag);
 	}
 
+	odict_finalize(&rdg->frags);
 	free(rdg);
 }
 
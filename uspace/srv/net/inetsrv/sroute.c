@@ -34,11 +34,14 @@
  * @brief
  */
 
+#include <assert.h>
 #include <bitops.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <ipc/loc.h>
+#include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 #include <str.h>
 #include "sroute.h"
@@ -49,6 +52,242 @@ static FIBRIL_MUTEX_INITIALIZE(sroute_list_lock);
 static LIST_INITIALIZE(sroute_list);
 static sysarg_t sroute_id = 0;
 
+/** Node of a path-compressed binary trie of route prefixes */
+typedef struct sroute_node {
+	/** Prefix, the bits past @c bits are zero */
+	addr128_t prefix;
+	/** Prefix length */
+	uint8_t bits;
+	/** Routes to exactly this prefix (inet_sroute_t) */
+	list_t routes;
+	/** Longer prefixes continuing with bit 0 and 1 */
+	struct sroute_node *child[2];
+} sroute_node_t;
+
+/** Protects the tries, lookups only need to read it */
+static FIBRIL_RWLOCK_INITIALIZE(sroute_trie_lock);
+static sroute_node_t *sroute_trie_v4 = NULL;
+static sroute_node_t *sroute_trie_v6 = NULL;
+
+/** Get bit @a i of @a key, the most significant bit first. */
+static unsigned sroute_key_bit(const addr128_t key, uint8_t i)
+{
+	return (key[i / 8] >> (7 - i % 8)) & 1;
+}
+
+/** Get the number of leading bits in which two keys agree.
+ *
+ * @param a	First key
+ * @param b	Second key
+ * @param max	Maximum number of bits to compare
+ * @return	Length of the common prefix, at most @a max
+ */
+static uint8_t sroute_key_common(const addr128_t a, const addr128_t b,
+    uint8_t max)
+{
+	uint8_t i = 0;
+
+	while (i < max && a[i / 8] == b[i / 8] && i + 8 <= max)
+		i += 8;
+
+	while (i < max && sroute_key_bit(a, i) == sroute_key_bit(b, i))
+		i++;
+
+	return i;
+}
+
+/** Convert an address to a trie key.
+ *
+ * @param ver	IP version
+ * @param v4	IPv4 address
+ * @param v6	IPv6 address
+ * @param key	Place to store the key
+ * @return	Trie for the IP version or @c NULL if there is none
+ */
+static sroute_node_t **sroute_key(ip_ver_t ver, addr32_t v4, addr128_t v6,
+    addr128_t key)
+{
+	switch (ver) {
+	case ip_v4:
+		memset(key, 0, sizeof(addr128_t));
+		key[0] = v4 >> 24;
+		key[1] = (v4 >> 16) & 0xff;
+		key[2] = (v4 >> 8) & 0xff;
+		key[3] = v4 & 0xff;
+		return &sroute_trie_v4;
+	case ip_v6:
+		memcpy(key, v6, sizeof(addr128_t));
+		return &sroute_trie_v6;
+	default:
+		return NULL;
+	}
+}
+
+/** Create a trie node.
+ *
+ * @param key	Prefix, only the first @a bits bits are used
+ * @param bits	Prefix length
+ * @return	New node or @c NULL if out of memory
+ */
+static sroute_node_t *sroute_node_new(const addr128_t key, uint8_t bits)
+{
+	sroute_node_t *node = calloc(1, sizeof(sroute_node_t));
+	if (node == NULL)
+		return NULL;
+
+	for (uint8_t i = 0; i < bits; i++) {
+		if (sroute_key_bit(key, i))
+			node->prefix[i / 8] |= 0x80 >> (i % 8);
+	}
+
+	node->bits = bits;
+	list_initialize(&node->routes);
+	return node;
+}
+
+/** Insert static route into a trie.
+ *
+ * @param root	Trie
+ * @param key	Route prefix
+ * @param bits	Prefix length
+ * @param sroute Static route
+ * @return	EOK on success or ENOMEM if out of memory
+ */
+static errno_t sroute_trie_insert(sroute_node_t **root, const addr128_t key,
+    uint8_t bits, inet_sroute_t *sroute)
+{
+	sroute_node_t **pnode = root;
+	sroute_node_t *node;
+	sroute_node_t *inner;
+	sroute_node_t *leaf;
+	uint8_t common;
+
+	while (true) {
+		node = *pnode;
+		if (node == NULL) {
+			node = sroute_node_new(key, bits);
+			if (node == NULL)
+				return ENOMEM;
+
+			list_append(&sroute->trie_link, &node->routes);
+			*pnode = node;
+			return EOK;
+		}
+
+		common = sroute_key_common(node->prefix, key,
+		    min(node->bits, bits));
+
+		if (common == node->bits && common == bits) {
+			list_append(&sroute->trie_link, &node->routes);
+			return EOK;
+		}
+
+		if (common < node->bits)
+			break;
+
+		pnode = &node->child[sroute_key_bit(key, node->bits)];
+	}
+
+	/* Split the path at the first differing bit */
+	inner = sroute_node_new(key, common);
+	if (inner == NULL)
+		return ENOMEM;
+
+	inner->child[sroute_key_bit(node->prefix, common)] = node;
+
+	if (common == bits) {
+		list_append(&sroute->trie_link, &inner->routes);
+	} else {
+		leaf = sroute_node_new(key, bits);
+		if (leaf == NULL) {
+			free(inner);
+			return ENOMEM;
+		}
+
+		list_append(&sroute->trie_link, &leaf->routes);
+		inner->child[sroute_key_bit(key, common)] = leaf;
+	}
+
+	*pnode = inner;
+	return EOK;
+}
+
+/** Free a node that no longer holds routes if the trie allows it.
+ *
+ * @param pnode	Pointer to the node in its parent (or the root)
+ */
+static void sroute_node_collapse(sroute_node_t **pnode)
+{
+	sroute_node_t *node = *pnode;
+
+	if (!list_empty(&node->routes))
+		return;
+
+	if (node->child[0] != NULL && node->child[1] != NULL)
+		return;
+
+	*pnode = node->child[0] != NULL ? node->child[0] : node->child[1];
+	free(node);
+}
+
+/** Remove static route from a trie.
+ *
+ * @param root	Trie
+ * @param key	Route prefix
+ * @param bits	Prefix length
+ * @param sroute Static route
+ */
+static void sroute_trie_remove(sroute_node_t **root, const addr128_t key,
+    uint8_t bits, inet_sroute_t *sroute)
+{
+	sroute_node_t **pparent = NULL;
+	sroute_node_t **pnode = root;
+	sroute_node_t *node = *root;
+
+	while (node != NULL && node->bits < bits) {
+		pparent = pnode;
+		pnode = &node->child[sroute_key_bit(key, node->bits)];
+		node = *pnode;
+	}
+
+	assert(node != NULL && node->bits == bits);
+
+	list_remove(&sroute->trie_link);
+	sroute_node_collapse(pnode);
+
+	/* A leaf is gone, its parent may have been kept only for it */
+	if (pparent != NULL && *pnode == NULL)
+		sroute_node_collapse(pparent);
+}
+
+/** Find the most specific route in a trie.
+ *
+ * @param node	Trie
+ * @param key	Address
+ * @param max	Address length in bits
+ * @return	Route or @c NULL if none matches
+ */
+static inet_sroute_t *sroute_trie_find(sroute_node_t *node,
+    const addr128_t key, uint8_t max)
+{
+	inet_sroute_t *best = NULL;
+
+	while (node != NULL &&
+	    sroute_key_common(node->prefix, key, node->bits) == node->bits) {
+		if (!list_empty(&node->routes)) {
+			best = list_get_instance(list_first(&node->routes),
+			    inet_sroute_t, trie_link);
+		}
+
+		if (node->bits >= max)
+			break;
+
+		node = node->child[sroute_key_bit(key, node->bits)];
+	}
+
+	return best;
+}
+
 inet_sroute_t *inet_sroute_new(void)
 {
 	inet_sroute_t *sroute = calloc(1, sizeof(inet_sroute_t));
@@ -60,6 +299,7 @@ inet_sroute_t *inet_sroute_new(void)
 	}
 
 	link_initialize(&sroute->sroute_list);
+	link_initialize(&sroute->trie_link);
 	fibril_mutex_lock(&sroute_list_lock);
 	sroute->id = ++sroute_id;
 	fibril_mutex_unlock(&sroute_list_lock);
@@ -74,59 +314,92 @@ void inet_sroute_delete(inet_sroute_t *sroute)
 	free(sroute);
 }
 
-void inet_sroute_add(inet_sroute_t *sroute)
+/** Add static route.
+ *
+ * @param sroute	Static route
+ * @return		EOK on success or ENOMEM if out of memory
+ */
+errno_t inet_sroute_add(inet_sroute_t *sroute)
 {
+	addr32_t v4 = 0;
+	addr128_t v6;
+	addr128_t key;
+	uint8_t bits;
+	sroute_node_t **root;
+	errno_t rc = EOK;
+
+	ip_ver_t ver = inet_naddr_get(&sroute->dest, &v4, &v6, &bits);
+	root = sroute_key(ver, v4, v6, key);
+
 	fibril_mutex_lock(&sroute_list_lock);
-	list_append(&sroute->sroute_list, &sroute_list);
+
+	if (root != NULL) {
+		fibril_rwlock_write_lock(&sroute_trie_lock);
+		rc = sroute_trie_insert(root, key, bits, sroute);
+		fibril_rwlock_write_unlock(&sroute_trie_lock);
+	}
+
+	if (rc == EOK)
+		list_append(&sroute->sroute_list, &sroute_list);
+
 	fibril_mutex_unlock(&sroute_list_lock);
+	return rc;
 }
 
 void inet_sroute_remove(inet_sroute_t *sroute)
 {
+	addr32_t v4 = 0;
+	addr128_t v6;
+	addr128_t key;
+	uint8_t bits;
+	sroute_node_t **root;
+
+	ip_ver_t ver = inet_naddr_get(&sroute->dest, &v4, &v6, &bits);
+	root = sroute_key(ver, v4, v6, key);
+
 	fibril_mutex_lock(&sroute_list_lock);
+
+	if (root != NULL) {
+		fibril_rwlock_write_lock(&sroute_trie_lock);
+		sroute_trie_remove(root, key, bits, sroute);
+		fibril_rwlock_write_unlock(&sroute_trie_lock);
+	}
+
 	list_remove(&sroute->sroute_list);
 	fibril_mutex_unlock(&sroute_list_lock);
 }
 
 /** Find static route object matching address @a addr.
+ *
+ * Of the most specific routes the one added first is returned.
  *
  * @param addr	Address
  */
 inet_sroute_t *inet_sroute_find(inet_addr_t *addr)
 {
-	ip_ver_t addr_ver = inet_addr_get(addr, NULL, NULL);
-
-	inet_sroute_t *best = NULL;
-	uint8_t best_bits = 0;
-
-	fibril_mutex_lock(&sroute_list_lock);
-
-	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
-		uint8_t dest_bits;
-		ip_ver_t dest_ver = inet_naddr_get(&sroute->dest, NULL, NULL,
-		    &dest_bits);
-
-		/* Skip comparison with different address family */
-		if (addr_ver != dest_ver)
-			continue;
-
-		/* Look for the most specific route */
-		if ((best != NULL) && (best_bits >= dest_bits))
-			continue;
-
-		if (inet_naddr_compare_mask(&sroute->dest, addr)) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: found candidate %p",
-			    sroute);
-
-			best = sroute;
-			best_bits = dest_bits;
-		}
+	addr32_t v4 = 0;
+	addr128_t v6;
+	addr128_t key;
+	sroute_node_t **root;
+	inet_sroute_t *best;
+
+	ip_ver_t ver = inet_addr_get(addr, &v4, &v6);
+	root = sroute_key(ver, v4, v6, key);
+	if (root == NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: Not found");
+		return NULL;
 	}
 
-	if (best == NULL)
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: Not found");
+	fibril_rwlock_read_lock(&sroute_trie_lock);
+	best = sroute_trie_find(*root, key, ver == ip_v4 ? 32 : 128);
+	fibril_rwlock_read_unlock(&sroute_trie_lock);
 
-	fibril_mutex_unlock(&sroute_list_lock);
+	if (best != NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: found %p",
+		    best);
+	} else {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: Not found");
+	}
 
 	return best;
 }
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+
+/**
+ * @file TCP congestion control
+ *
+ * Generic part of congestion control (RFC 5681) with NewReno loss recovery
+ * (RFC 6582). Slow start, fast retransmit and recovery are handled here,
+ * the algorithm (tcp_cc_ops_t) decides how to reduce the window when
+ * congestion is detected and how to grow it in congestion avoidance.
+ */
+
+#include <io/log.h>
+#include <macros.h>
+#include <str.h>
+#include "cc.h"
+#include "seq_no.h"
+#include "tcp_type.h"
+#include "tqueue.h"
+
+/** Largest congestion window we allow (bytes) */
+#define TCP_CWND_MAX	(16 * 1024 * 1024)
+
+/** Available congestion control algorithms */
+static tcp_cc_ops_t *tcp_cc_algs[] = {
+	&tcp_cc_cubic,
+	&tcp_cc_newreno
+};
+
+/** Algorithm used for new connections */
+static tcp_cc_ops_t *tcp_cc_default = &tcp_cc_cubic;
+
+/** Select congestion control algorithm for new connections.
+ *
+ * @param name Algorithm name
+ * @return EOK on success, ENOENT if there is no such algorithm
+ */
+errno_t tcp_cc_default_set(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(tcp_cc_algs) / sizeof(tcp_cc_algs[0]); i++) {
+		if (str_cmp(tcp_cc_algs[i]->name, name) == 0) {
+			tcp_cc_default = tcp_cc_algs[i];
+			return EOK;
+		}
+	}
+
+	return ENOENT;
+}
+
+/** Initialize congestion control state of a new connection.
+ *
+ * @param conn Connection
+ */
+void tcp_cc_init(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	cc->ops = tcp_cc_default;
+
+	/* Initial window (RFC 5681 3.1) for SMSS > 2190 bytes */
+	cc->cwnd = 2 * TCP_SMSS;
+	cc->ssthresh = UINT32_MAX;
+	cc->dupacks = 0;
+	cc->recovery = cr_none;
+	cc->recover = 0;
+
+	if (cc->ops->init != NULL)
+		cc->ops->init(conn);
+}
+
+/** Get amount of data in flight.
+ *
+ * @param conn Connection
+ * @return Number of sequence units sent but not acknowledged
+ */
+uint32_t tcp_cc_flight(tcp_conn_t *conn)
+{
+	return conn->snd_nxt - conn->snd_una;
+}
+
+/** Get effective send window.
+ *
+ * @param conn Connection
+ * @return Smaller of the peer's receive window and the congestion window
+ */
+uint32_t tcp_cc_send_wnd(tcp_conn_t *conn)
+{
+	return min(conn->snd_wnd, conn->cc.cwnd);
+}
+
+/** New data has been acknowledged.
+ *
+ * Must be called after acknowledged segments have been removed from the
+ * retransmission queue.
+ *
+ * @param conn  Connection
+ * @param acked Number of newly acknowledged sequence units
+ */
+void tcp_cc_ack(tcp_conn_t *conn, uint32_t acked)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	cc->dupacks = 0;
+
+	if (cc->recovery != cr_none) {
+		if (seq_no_ge(conn->snd_una, cc->recover)) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: recovery complete",
+			    conn->name);
+			if (cc->recovery == cr_fast) {
+				/* Deflate window (RFC 6582 3.2 step 3) */
+				cc->cwnd = min(cc->ssthresh,
+				    max(tcp_cc_flight(conn), TCP_SMSS) +
+				    TCP_SMSS);
+				cc->recovery = cr_none;
+				return;
+			}
+
+			cc->recovery = cr_none;
+		} else {
+			/* Partial ACK, next segment was lost as well */
+			tcp_tqueue_retransmit_next(conn);
+
+			if (cc->recovery == cr_fast) {
+				/* RFC 6582 3.2 step 5 */
+				cc->cwnd -= min(cc->cwnd, acked);
+				if (acked >= TCP_SMSS)
+					cc->cwnd += TCP_SMSS;
+				cc->cwnd = max(cc->cwnd, TCP_SMSS);
+				return;
+			}
+		}
+	}
+
+	if (cc->cwnd < cc->ssthresh) {
+		/* Slow start */
+		cc->cwnd += min(acked, TCP_SMSS);
+	} else {
+		cc->ops->cong_avoid(conn, acked);
+	}
+
+	cc->cwnd = min(cc->cwnd, TCP_CWND_MAX);
+}
+
+/** Duplicate ACK has been received.
+ *
+ * @param conn Connection
+ */
+void tcp_cc_dupack(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	switch (cc->recovery) {
+	case cr_fast:
+		/* Another segment has left the network, inflate window */
+		cc->cwnd = min(cc->cwnd + TCP_SMSS, TCP_CWND_MAX);
+
+		/* Use the opportunity to repair the next known hole */
+		if (conn->sack_ok)
+			(void) tcp_tqueue_retransmit_hole(conn);
+		return;
+	case cr_loss:
+		return;
+	case cr_none:
+		break;
+	}
+
+	if (++cc->dupacks < TCP_DUPACK_THRESH)
+		return;
+
+	cc->ssthresh = cc->ops->ssthresh(conn);
+	cc->recover = conn->snd_nxt;
+	cc->recovery = cr_fast;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: fast retransmit, ssthresh=%"
+	    PRIu32, conn->name, cc->ssthresh);
+
+	tcp_tqueue_recovery_start(conn, false);
+	tcp_tqueue_retransmit(conn);
+	cc->cwnd = cc->ssthresh + TCP_DUPACK_THRESH * TCP_SMSS;
+}
+
+/** Retransmission timer has expired.
+ *
+ * @param conn Connection
+ */
+void tcp_cc_timeout(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	/* Do not reduce ssthresh again when the retransmission is lost */
+	if (cc->recovery != cr_loss)
+		cc->ssthresh = cc->ops->ssthresh(conn);
+
+	/* Loss window (RFC 5681 3.1) */
+	cc->cwnd = TCP_SMSS;
+	cc->dupacks = 0;
+	cc->recover = conn->snd_nxt;
+	cc->recovery = cr_loss;
+	tcp_tqueue_recovery_start(conn, true);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: retransmission timeout, "
+	    "ssthresh=%" PRIu32, conn->name, cc->ssthresh);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+
+/**
+ * @file CUBIC congestion control (RFC 9438)
+ *
+ * The window grows as W(t) = C * (t - K)^3 + W_max, where t is the time
+ * since the last window reduction. Computation is done in fixed point,
+ * windows in bytes and times in milliseconds, with C = 0.4 and
+ * beta = 0.7.
+ */
+
+#include <macros.h>
+#include <time.h>
+#include "cc.h"
+#include "tcp_type.h"
+#include "tqueue.h"
+
+/** Multiplicative decrease factor beta = CUBIC_BETA_NUM / CUBIC_BETA_DEN */
+#define CUBIC_BETA_NUM	7
+#define CUBIC_BETA_DEN	10
+
+/** Largest |t - K| used in the cubic function (msec) to avoid overflow */
+#define CUBIC_T_MAX	60000
+
+/** Integer cube root.
+ *
+ * @param x Argument
+ * @return Largest y such that y^3 <= x
+ */
+static uint64_t tcp_cubic_cbrt(uint64_t x)
+{
+	uint64_t y;
+	uint64_t b;
+	int s;
+
+	y = 0;
+	for (s = 63; s >= 0; s -= 3) {
+		y = 2 * y;
+		b = 3 * y * (y + 1) + 1;
+		if ((x >> s) >= b) {
+			x -= b << s;
+			y++;
+		}
+	}
+
+	return y;
+}
+
+/** Initialize CUBIC state.
+ *
+ * @param conn Connection
+ */
+static void tcp_cubic_init(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	cc->w_max = 0;
+	cc->origin = 0;
+	cc->w_est = 0;
+	cc->k = 0;
+	cc->epoch_valid = false;
+}
+
+/** Compute slow start threshold after congestion.
+ *
+ * @param conn Connection
+ * @return New slow start threshold
+ */
+static uint32_t tcp_cubic_ssthresh(tcp_conn_t *conn)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	/*
+	 * Fast convergence: if the window did not reach the previous
+	 * maximum, release bandwidth to other flows by lowering W_max
+	 * further, to (1 + beta) / 2 of the current window.
+	 */
+	if (cc->cwnd < cc->w_max) {
+		cc->w_max = (uint64_t) cc->cwnd *
+		    (CUBIC_BETA_DEN + CUBIC_BETA_NUM) / (2 * CUBIC_BETA_DEN);
+	} else {
+		cc->w_max = cc->cwnd;
+	}
+
+	cc->epoch_valid = false;
+
+	return max((uint64_t) cc->cwnd * CUBIC_BETA_NUM / CUBIC_BETA_DEN,
+	    2 * TCP_SMSS);
+}
+
+/** Start new congestion avoidance epoch.
+ *
+ * @param conn Connection
+ * @param now  Current time
+ */
+static void tcp_cubic_epoch_start(tcp_conn_t *conn, struct timespec *now)
+{
+	tcp_cc_t *cc = &conn->cc;
+
+	cc->epoch_valid = true;
+	cc->epoch_start = *now;
+	cc->w_est = cc->cwnd;
+
+	if (cc->cwnd < cc->w_max) {
+		/*
+		 * K = cbrt((W_max - cwnd) / C) seconds, windows in
+		 * segments. In msec and bytes that is
+		 * cbrt((W_max - cwnd) * 10^9 / (0.4 * SMSS)).
+		 */
+		cc->k = tcp_cubic_cbrt((uint64_t) (cc->w_max - cc->cwnd) *
+		    10000000000ull / (4 * TCP_SMSS));
+		cc->origin = cc->w_max;
+	} else {
+		cc->k = 0;
+		cc->origin = cc->cwnd;
+	}
+}
+
+/** Grow congestion window in congestion avoidance.
+ *
+ * @param conn  Connection
+ * @param acked Number of newly acknowledged sequence units
+ */
+static void tcp_cubic_cong_avoid(tcp_conn_t *conn, uint32_t acked)
+{
+	tcp_cc_t *cc = &conn->cc;
+	struct timespec now;
+	msec_t t;
+	int64_t delta;
+	int64_t target;
+	uint64_t inc;
+
+	getuptime(&now);
+
+	if (!cc->epoch_valid)
+		tcp_cubic_epoch_start(conn, &now);
+
+	/* Window we want to have one RTT from now */
+	t = NSEC2MSEC(ts_sub_diff(&now, &cc->epoch_start)) +
+	    USEC2MSEC(conn->srtt) - cc->k;
+	t = max(min(t, CUBIC_T_MAX), -CUBIC_T_MAX);
+
+	/* C * t^3 in bytes, C = 0.4 segments / s^3 */
+	delta = t * t * t * 4 * TCP_SMSS / 10000000000ll;
+	target = (int64_t) cc->origin + delta;
+
+	/* Do not grow faster than 1.5 times per RTT */
+	target = min(target, (int64_t) cc->cwnd * 3 / 2);
+
+	/*
+	 * Reno-friendly region: track what Reno with the same beta would
+	 * achieve, which is 3 * (1 - beta) / (1 + beta) segments per RTT.
+	 */
+	cc->w_est += (uint64_t) acked * TCP_SMSS *
+	    3 * (CUBIC_BETA_DEN - CUBIC_BETA_NUM) /
+	    ((CUBIC_BETA_DEN + CUBIC_BETA_NUM) * (uint64_t) cc->cwnd);
+	target = max(target, (int64_t) cc->w_est);
+
+	if (target > cc->cwnd) {
+		inc = (uint64_t) (target - cc->cwnd) * acked / cc->cwnd;
+	} else {
+		/* Probe very slowly around W_max */
+		inc = (uint64_t) TCP_SMSS * acked / (100 * (uint64_t) cc->cwnd);
+	}
+
+	cc->cwnd += max(inc, 1);
+}
+
+tcp_cc_ops_t tcp_cc_cubic = {
+	.name = "cubic",
+	.init = tcp_cubic_init,
+	.ssthresh = tcp_cubic_ssthresh,
+	.cong_avoid = tcp_cubic_cong_avoid
+};
+
+/**
+ * @}
+ */
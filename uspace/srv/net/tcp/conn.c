@@ -38,10 +38,13 @@
 #include <errno.h>
 #include <inet/endpoint.h>
 #include <io/log.h>
+#include <ipc/tcp.h>
 #include <macros.h>
 #include <nettl/amap.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <str_error.h>
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
 #include "iqueue.h"
@@ -56,6 +59,13 @@
 #define RCV_BUF_SIZE 4096/*2*/
 #define SND_BUF_SIZE 4096
 
+/** Default ceiling for receive buffer auto-tuning */
+#define RCV_BUF_MAX_DEFAULT	(256 * 1024)
+/** Default ceiling for send buffer auto-tuning */
+#define SND_BUF_MAX_DEFAULT	(256 * 1024)
+/** Largest buffer size a user may request */
+#define TCP_BUF_SIZE_LIMIT	(4 * 1024 * 1024)
+
 #define MAX_SEGMENT_LIFETIME	(15*1000*1000) //(2*60*1000*1000)
 #define TIME_WAIT_TIMEOUT	(2*MAX_SEGMENT_LIFETIME)
 
@@ -65,8 +75,8 @@ static LIST_INITIALIZE(conn_list);
 static FIBRIL_MUTEX_INITIALIZE(conn_list_lock);
 /** Connection association map */
 static amap_t *amap;
-/** Taken after tcp_conn_t lock */
-static FIBRIL_MUTEX_INITIALIZE(amap_lock);
+/** Taken after tcp_conn_t lock. Lookups only need it for reading. */
+static FIBRIL_RWLOCK_INITIALIZE(amap_lock);
 
 /** Internal loopback configuration */
 tcp_lb_t tcp_conn_lb = tcp_lb_none;
@@ -77,6 +87,7 @@ static void tcp_conn_tw_timer_clear(tcp_conn_t *);
 static void tcp_transmit_segment(inet_ep2_t *, tcp_segment_t *);
 static void tcp_conn_trim_seg_to_wnd(tcp_conn_t *, tcp_segment_t *);
 static void tcp_reply_rst(inet_ep2_t *, tcp_segment_t *);
+static void tcp_conn_rcv_rtt_measure(tcp_conn_t *);
 
 static tcp_tqueue_cb_t tcp_conn_tqueue_cb = {
 	.transmit_seg = tcp_transmit_segment
@@ -126,6 +137,10 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	if (conn->tw_timer == NULL)
 		goto error;
 
+	conn->dack_timer = fibril_timer_create(&conn->lock);
+	if (conn->dack_timer == NULL)
+		goto error;
+
 	/* One for the user, one for not being in closed state */
 	refcount_init(&conn->refcnt);
 	refcount_up(&conn->refcnt);
@@ -136,6 +151,10 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	conn->rcv_buf_used = 0;
 	conn->rcv_buf_fin = false;
 
+	conn->rcv_buf_max = RCV_BUF_MAX_DEFAULT;
+	conn->rcv_copied = 0;
+	getuptime(&conn->rcv_tune_time);
+
 	conn->rcv_buf = calloc(1, conn->rcv_buf_size);
 	if (conn->rcv_buf == NULL)
 		goto error;
@@ -145,6 +164,9 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	conn->snd_buf_size = SND_BUF_SIZE;
 	conn->snd_buf_used = 0;
 	conn->snd_buf_fin = false;
+	conn->snd_buf_max = SND_BUF_MAX_DEFAULT;
+	conn->snd_acked = 0;
+	getuptime(&conn->snd_tune_time);
 	conn->snd_buf = calloc(1, conn->snd_buf_size);
 	if (conn->snd_buf == NULL)
 		goto error;
@@ -152,6 +174,18 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	/* Set up receive window. */
 	conn->rcv_wnd = conn->rcv_buf_size;
 
+	/*
+	 * Pick a window scale large enough for any buffer size the user
+	 * may ask for later, since it cannot change after the handshake.
+	 */
+	conn->wscale_ok = false;
+	conn->snd_wscale = 0;
+	conn->rcv_wscale = 0;
+	conn->sack_ok = false;
+	while (conn->rcv_wscale < TCP_WSCALE_MAX &&
+	    (TCP_BUF_SIZE_LIMIT >> conn->rcv_wscale) > TCP_WND_FIELD_MAX)
+		++conn->rcv_wscale;
+
 	/* Initialize incoming segment queue */
 	tcp_iqueue_init(&conn->incoming, conn);
 
@@ -163,6 +197,9 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 
 	tqueue_inited = true;
 
+	/* Initialize congestion control */
+	tcp_cc_init(conn);
+
 	/* Connection state change signalling */
 	fibril_condvar_initialize(&conn->cstate_cv);
 
@@ -191,6 +228,8 @@ error:
 		free(conn->snd_buf);
 	if (conn != NULL && conn->tw_timer != NULL)
 		fibril_timer_destroy(conn->tw_timer);
+	if (conn != NULL && conn->dack_timer != NULL)
+		fibril_timer_destroy(conn->dack_timer);
 	if (conn != NULL)
 		free(conn);
 
@@ -227,6 +266,9 @@ static void tcp_conn_free(tcp_conn_t *conn)
 		free(conn->snd_buf);
 	if (conn->tw_timer != NULL)
 		fibril_timer_destroy(conn->tw_timer);
+	if (conn->dack_timer != NULL)
+		fibril_timer_destroy(conn->dack_timer);
+	async_ring_destroy(conn->snd_ring);
 	free(conn);
 }
 
@@ -310,20 +352,20 @@ errno_t tcp_conn_add(tcp_conn_t *conn)
 	errno_t rc;
 
 	tcp_conn_addref(conn);
-	fibril_mutex_lock(&amap_lock);
+	fibril_rwlock_write_lock(&amap_lock);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_add: conn=%p", conn);
 
 	rc = amap_insert(amap, &conn->ident, conn, af_allow_system, &aepp);
 	if (rc != EOK) {
 		tcp_conn_delref(conn);
-		fibril_mutex_unlock(&amap_lock);
+		fibril_rwlock_write_unlock(&amap_lock);
 		return rc;
 	}
 
 	conn->ident = aepp;
 	conn->mapped = true;
-	fibril_mutex_unlock(&amap_lock);
+	fibril_rwlock_write_unlock(&amap_lock);
 
 	return EOK;
 }
@@ -337,10 +379,10 @@ static void tcp_conn_remove(tcp_conn_t *conn)
 	if (!conn->mapped)
 		return;
 
-	fibril_mutex_lock(&amap_lock);
+	fibril_rwlock_write_lock(&amap_lock);
 	amap_remove(amap, &conn->ident);
 	conn->mapped = false;
-	fibril_mutex_unlock(&amap_lock);
+	fibril_rwlock_write_unlock(&amap_lock);
 	tcp_conn_delref(conn);
 }
 
@@ -432,24 +474,54 @@ tcp_conn_t *tcp_conn_find_ref(inet_ep2_t *epp)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_find_ref(%p)", epp);
 
-	fibril_mutex_lock(&amap_lock);
+	fibril_rwlock_read_lock(&amap_lock);
 
 	rc = amap_find_match(amap, epp, &arg);
 	if (rc != EOK) {
 		assert(rc == ENOENT);
-		fibril_mutex_unlock(&amap_lock);
+		fibril_rwlock_read_unlock(&amap_lock);
 		return NULL;
 	}
 
 	conn = (tcp_conn_t *)arg;
 	tcp_conn_addref(conn);
 
-	fibril_mutex_unlock(&amap_lock);
+	fibril_rwlock_read_unlock(&amap_lock);
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_find_ref: got conn=%p",
 	    conn);
 	return conn;
 }
 
+/** Get information on all connections.
+ *
+ * Fills in up to @a count entries of @a info. Statistics are read
+ * without taking the connection locks (the connection list lock is
+ * taken below them) and are thus only a snapshot.
+ *
+ * @param info		Array to fill in
+ * @param count		Number of entries in @a info
+ * @param rtotal	Place to store total number of connections
+ */
+void tcp_conns_info_get(tcp_conn_info_t *info, size_t count, size_t *rtotal)
+{
+	size_t i;
+
+	fibril_mutex_lock(&conn_list_lock);
+
+	i = 0;
+	list_foreach(conn_list, link, tcp_conn_t, conn) {
+		if (i < count) {
+			info[i].epp = conn->ident;
+			info[i].stats = conn->stats;
+		}
+
+		++i;
+	}
+
+	fibril_mutex_unlock(&conn_list_lock);
+	*rtotal = i;
+}
+
 /** Reset connection.
  *
  * @param conn	Connection
@@ -468,6 +540,7 @@ void tcp_conn_reset(tcp_conn_t *conn)
 
 	tcp_conn_tw_timer_clear(conn);
 	tcp_tqueue_clear(&conn->retransmit);
+	tcp_conn_snd_ring_close(conn);
 
 	fibril_condvar_broadcast(&conn->rcv_buf_cv);
 	fibril_condvar_broadcast(&conn->snd_buf_cv);
@@ -511,6 +584,33 @@ bool tcp_conn_got_syn(tcp_conn_t *conn)
 	assert(false);
 }
 
+/** Process options of a received SYN segment.
+ *
+ * Window scaling and selective acknowledgements are only used if both
+ * sides sent the respective option in their SYN.
+ *
+ * @param conn		Connection
+ * @param seg		Received SYN segment
+ */
+static void tcp_conn_syn_opts_negotiate(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	conn->sack_ok = seg->sack_perm;
+
+	if (seg->has_wscale) {
+		conn->wscale_ok = true;
+		conn->snd_wscale = min(seg->wscale, TCP_WSCALE_MAX);
+	} else {
+		conn->wscale_ok = false;
+		conn->snd_wscale = 0;
+		conn->rcv_wscale = 0;
+	}
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: window scale %s, snd=%u rcv=%u, "
+	    "SACK %s", conn->name, conn->wscale_ok ? "on" : "off",
+	    (unsigned) conn->snd_wscale, (unsigned) conn->rcv_wscale,
+	    conn->sack_ok ? "on" : "off");
+}
+
 /** Segment arrived in Listen state.
  *
  * @param conn		Connection
@@ -543,6 +643,8 @@ static void tcp_conn_sa_listen(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "rcv_nxt=%u", conn->rcv_nxt);
 
+	tcp_conn_syn_opts_negotiate(conn, seg);
+
 	if (seg->len > 1)
 		log_msg(LOG_DEFAULT, LVL_WARN, "SYN combined with data, ignoring data.");
 
@@ -615,6 +717,8 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 	conn->rcv_nxt = seg->seq + 1;
 	conn->irs = seg->seq;
 
+	tcp_conn_syn_opts_negotiate(conn, seg);
+
 	if ((seg->ctrl & CTL_ACK) != 0) {
 		conn->snd_una = seg->ack;
 
@@ -662,6 +766,7 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	tcp_segment_t *pseg;
+	bool out_of_order;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_sa_seq(%p, %p)", conn, seg);
 
@@ -673,6 +778,11 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 		return;
 	}
 
+	/* Segment following a hole, keep it queued and report it in SACK */
+	out_of_order = seg->len > 0 && !seq_no_segment_ready(conn, seg);
+	if (out_of_order)
+		conn->rcv_sack_last = seg->seq;
+
 	/* Queue for processing */
 	tcp_iqueue_insert_seg(&conn->incoming, seg);
 
@@ -684,6 +794,13 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 	 */
 	while (tcp_iqueue_get_ready_seg(&conn->incoming, &pseg) == EOK)
 		tcp_conn_seg_process(conn, pseg);
+
+	/*
+	 * Acknowledge out-of-order segment immediately (RFC 5681 4.2).
+	 * The duplicate ACK lets the sender detect the loss early.
+	 */
+	if (out_of_order)
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
 }
 
 /** Process segment RST field.
@@ -802,6 +919,23 @@ static cproc_t tcp_conn_seg_proc_ack_sr(tcp_conn_t *conn, tcp_segment_t *seg)
 	return cp_continue;
 }
 
+/** Determine whether segment is a duplicate ACK (RFC 5681 2).
+ *
+ * @param conn		Connection
+ * @param seg		Segment
+ * @return		@c true if the segment acknowledges nothing new,
+ *			carries no data and does not change the window while
+ *			we have data outstanding
+ */
+static bool tcp_conn_seg_is_dupack(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	return seg->ack == conn->snd_una &&
+	    tcp_segment_text_size(seg) == 0 &&
+	    (seg->ctrl & (CTL_SYN | CTL_FIN)) == 0 &&
+	    (seg->wnd << conn->snd_wscale) == conn->snd_wnd &&
+	    !list_empty(&conn->retransmit.list);
+}
+
 /** Process segment ACK field in Established state.
  *
  * @param conn		Connection
@@ -817,6 +951,10 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 	    (unsigned)seg->ack, (unsigned)conn->snd_una,
 	    (unsigned)conn->snd_nxt);
 
+	/* Update retransmission scoreboard */
+	if (conn->sack_ok && seg->sack_cnt > 0)
+		tcp_tqueue_sack_received(conn, seg->sack, seg->sack_cnt);
+
 	if (!seq_no_ack_acceptable(conn, seg->ack)) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "ACK not acceptable.");
 		if (!seq_no_ack_duplicate(conn, seg->ack)) {
@@ -826,8 +964,11 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 			tcp_tqueue_ctrl_seg(conn, CTL_ACK);
 			tcp_segment_delete(seg);
 			return cp_done;
+		} else if (tcp_conn_seg_is_dupack(conn, seg)) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Duplicate ACK.");
+			tcp_cc_dupack(conn);
 		} else {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "Ignoring duplicate ACK.");
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Ignoring old ACK.");
 		}
 	} else {
 		/* Update SND.UNA */
@@ -835,7 +976,8 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 	}
 
 	if (seq_no_new_wnd_update(conn, seg)) {
-		conn->snd_wnd = seg->wnd;
+		/* Window field of non-SYN segments is scaled (RFC 7323) */
+		conn->snd_wnd = seg->wnd << conn->snd_wscale;
 		conn->snd_wl1 = seg->seq;
 		conn->snd_wl2 = seg->ack;
 
@@ -1079,9 +1221,19 @@ static cproc_t tcp_conn_seg_proc_text(tcp_conn_t *conn, tcp_segment_t *seg)
 	/* Update receive window. XXX Not an efficient strategy. */
 	conn->rcv_wnd -= xfer_size;
 
-	/* Send ACK */
 	if (xfer_size > 0)
-		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+		tcp_conn_rcv_rtt_measure(conn);
+
+	/*
+	 * Acknowledge right away while out-of-order data is queued so that
+	 * the sender learns about filled holes quickly (RFC 5681 4.2).
+	 */
+	if (xfer_size > 0) {
+		if (list_empty(&conn->incoming.list))
+			tcp_tqueue_ack_delayed(conn);
+		else
+			tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+	}
 
 	if (xfer_size < seg->len) {
 		/* Trim part of segment which we just received */
@@ -1245,6 +1397,9 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 		return;
 	}
 
+	++conn->stats.seg_rcvd;
+	conn->stats.bytes_rcvd += tcp_segment_text_size(seg);
+
 	if (inet_addr_is_any(&conn->ident.remote.addr) ||
 	    conn->ident.remote.port == inet_port_any ||
 	    inet_addr_is_any(&conn->ident.local.addr)) {
@@ -1254,7 +1409,7 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 		oldepp = conn->ident;
 
 		/* Need to remove and re-insert connection with new identity */
-		fibril_mutex_lock(&amap_lock);
+		fibril_rwlock_write_lock(&amap_lock);
 
 		if (inet_addr_is_any(&conn->ident.remote.addr))
 			conn->ident.remote.addr = epp->remote.addr;
@@ -1270,13 +1425,13 @@ void tcp_conn_segment_arrived(tcp_conn_t *conn, inet_ep2_t *epp,
 			assert(rc != EEXIST);
 			assert(rc == ENOMEM);
 			log_msg(LOG_DEFAULT, LVL_ERROR, "Out of memory.");
-			fibril_mutex_unlock(&amap_lock);
+			fibril_rwlock_write_unlock(&amap_lock);
 			tcp_conn_unlock(conn);
 			return;
 		}
 
 		amap_remove(amap, &oldepp);
-		fibril_mutex_unlock(&amap_lock);
+		fibril_rwlock_write_unlock(&amap_lock);
 
 		conn->name = (char *) "a";
 	}
@@ -1360,6 +1515,252 @@ void tcp_conn_tw_timer_clear(tcp_conn_t *conn)
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_conn_tw_timer_clear() end");
 }
 
+/** Update smoothed RTT estimate with a new sample.
+ *
+ * @param rtt		RTT estimate (0 if none yet)
+ * @param sample	New sample in microseconds
+ * @return		Updated RTT estimate
+ */
+static usec_t tcp_conn_rtt_smooth(usec_t rtt, usec_t sample)
+{
+	/* Zero means not measured, keep estimate non-zero */
+	if (sample <= 0)
+		sample = 1;
+
+	if (rtt == 0)
+		return sample;
+
+	return (7 * rtt + sample) / 8;
+}
+
+/** Measure round-trip time as seen by the receiver.
+ *
+ * A receiver that does not send data cannot time its own segments.
+ * Instead, measure how long it takes for the peer to fill the window
+ * we advertised. This takes at least one round trip.
+ *
+ * @param conn		Connection
+ */
+static void tcp_conn_rcv_rtt_measure(tcp_conn_t *conn)
+{
+	struct timespec now;
+
+	getuptime(&now);
+
+	if (!conn->rcv_rtt_timing) {
+		conn->rcv_rtt_timing = true;
+		conn->rcv_rtt_seq = conn->rcv_nxt + conn->rcv_wnd;
+		conn->rcv_rtt_start = now;
+		return;
+	}
+
+	if (!seq_no_ge(conn->rcv_nxt, conn->rcv_rtt_seq))
+		return;
+
+	conn->rcv_rtt = tcp_conn_rtt_smooth(conn->rcv_rtt,
+	    NSEC2USEC(ts_sub_diff(&now, &conn->rcv_rtt_start)));
+	conn->rcv_rtt_timing = false;
+}
+
+/** Grow receive buffer.
+ *
+ * The buffer never grows beyond its ceiling or what we are able to
+ * advertise with the negotiated window scale. It never shrinks.
+ *
+ * @param conn		Connection
+ * @param size		Requested buffer size
+ */
+static void tcp_conn_rcv_buf_grow(tcp_conn_t *conn, size_t size)
+{
+	uint8_t *nbuf;
+	size_t limit;
+
+	limit = min(conn->rcv_buf_max,
+	    (size_t) TCP_WND_FIELD_MAX << conn->rcv_wscale);
+	size = min(size, limit);
+	if (size <= conn->rcv_buf_size)
+		return;
+
+	nbuf = realloc(conn->rcv_buf, size);
+	if (nbuf == NULL)
+		return;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: receive buffer %zu -> %zu",
+	    conn->name, conn->rcv_buf_size, size);
+
+	/* Newly available space opens the receive window */
+	conn->rcv_wnd += size - conn->rcv_buf_size;
+	conn->rcv_buf = nbuf;
+	conn->rcv_buf_size = size;
+}
+
+/** Grow send buffer.
+ *
+ * @param conn		Connection
+ * @param size		Requested buffer size (capped by the ceiling)
+ */
+static void tcp_conn_snd_buf_grow(tcp_conn_t *conn, size_t size)
+{
+	uint8_t *nbuf;
+
+	size = min(size, conn->snd_buf_max);
+	if (size <= conn->snd_buf_size)
+		return;
+
+	nbuf = realloc(conn->snd_buf, size);
+	if (nbuf == NULL)
+		return;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: send buffer %zu -> %zu",
+	    conn->name, conn->snd_buf_size, size);
+
+	conn->snd_buf = nbuf;
+	conn->snd_buf_size = size;
+	fibril_condvar_broadcast(&conn->snd_buf_cv);
+}
+
+/** Data has been passed from the receive buffer to the user.
+ *
+ * Once per round trip compare the amount of data the user consumed
+ * with the buffer size. The amount consumed in one RTT approximates
+ * the bandwidth-delay product; keep the buffer twice that so that the
+ * window does not limit the sender.
+ *
+ * @param conn		Connection
+ * @param size		Number of bytes passed to the user
+ */
+void tcp_conn_rcv_buf_consumed(tcp_conn_t *conn, size_t size)
+{
+	struct timespec now;
+	usec_t rtt;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	conn->rcv_copied += size;
+
+	rtt = conn->rcv_rtt != 0 ? conn->rcv_rtt : conn->srtt;
+	if (rtt == 0)
+		return;
+
+	getuptime(&now);
+	if (NSEC2USEC(ts_sub_diff(&now, &conn->rcv_tune_time)) < rtt)
+		return;
+
+	tcp_conn_rcv_buf_grow(conn, 2 * conn->rcv_copied);
+	conn->rcv_copied = 0;
+	conn->rcv_tune_time = now;
+}
+
+/** Data from the send buffer has been acknowledged by the peer.
+ *
+ * The amount of data acknowledged in one RTT approximates the
+ * bandwidth-delay product; keep the send buffer twice that so that
+ * the user can keep the pipe full.
+ *
+ * @param conn		Connection
+ * @param size		Number of bytes acknowledged
+ */
+void tcp_conn_snd_buf_acked(tcp_conn_t *conn, size_t size)
+{
+	struct timespec now;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	conn->snd_acked += size;
+	if (conn->srtt == 0)
+		return;
+
+	getuptime(&now);
+	if (NSEC2USEC(ts_sub_diff(&now, &conn->snd_tune_time)) < conn->srtt)
+		return;
+
+	tcp_conn_snd_buf_grow(conn, 2 * conn->snd_acked);
+	conn->snd_acked = 0;
+	conn->snd_tune_time = now;
+}
+
+/** Move data from the send ring to the send buffer.
+ *
+ * Messages are read straight into the free part of the send buffer.
+ * A message that does not fit is left in the ring until transmission
+ * makes room for it.
+ *
+ * @param conn		Connection
+ * @return		@c true if the ring has been emptied or there is
+ *			no ring, @c false if data remains in the ring
+ */
+bool tcp_conn_snd_ring_drain(tcp_conn_t *conn)
+{
+	size_t rsize;
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (conn->snd_ring == NULL)
+		return true;
+
+	while (true) {
+		rc = async_ring_read(conn->snd_ring,
+		    conn->snd_buf + conn->snd_buf_used,
+		    conn->snd_buf_size - conn->snd_buf_used, &rsize);
+		if (rc != EOK)
+			break;
+
+		conn->snd_buf_used += rsize;
+	}
+
+	if (rc == ENOENT)
+		return true;
+
+	if (rc == EOVERFLOW && rsize <= TCP_SEND_RING_MSG_MAX)
+		return false;
+
+	/* The user broke the ring protocol, refuse further data */
+	log_msg(LOG_DEFAULT, LVL_WARN, "%s: Bad send ring (%s).",
+	    conn->name, str_error_name(rc));
+	tcp_conn_snd_ring_close(conn);
+	return true;
+}
+
+/** Stop accepting data through the send ring.
+ *
+ * A user waiting for room in the ring is woken up with an error.
+ *
+ * @param conn		Connection
+ */
+void tcp_conn_snd_ring_close(tcp_conn_t *conn)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	async_ring_destroy(conn->snd_ring);
+	conn->snd_ring = NULL;
+}
+
+/** Set ceilings for buffer auto-tuning.
+ *
+ * Buffers grow with the measured bandwidth-delay product up to these
+ * ceilings. Lowering a ceiling below the current size stops further
+ * growth but does not shrink the buffer.
+ *
+ * @param conn		Connection
+ * @param rcv_max	Receive buffer ceiling in bytes or 0 to keep current
+ * @param snd_max	Send buffer ceiling in bytes or 0 to keep current
+ */
+void tcp_conn_set_buf_max(tcp_conn_t *conn, size_t rcv_max, size_t snd_max)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (rcv_max != 0) {
+		conn->rcv_buf_max = max(min(rcv_max, TCP_BUF_SIZE_LIMIT),
+		    RCV_BUF_SIZE);
+	}
+
+	if (snd_max != 0) {
+		conn->snd_buf_max = max(min(snd_max, TCP_BUF_SIZE_LIMIT),
+		    SND_BUF_SIZE);
+	}
+}
+
 /** Trim segment to the receive window.
  *
  * @param conn		Connection
@@ -1409,7 +1810,14 @@ static void tcp_transmit_segment(inet_ep2_t *epp, tcp_segment_t *seg)
 
 	tcp_segment_dump(seg);
 
-	if (tcp_conn_lb == tcp_lb_segment) {
+	/*
+	 * Segments sent to a loopback address would only travel through
+	 * the internet service and the loopback link to come back to us.
+	 * Loop them back right away, without encoding and checksumming.
+	 */
+	if (tcp_conn_lb == tcp_lb_segment || (tcp_conn_lb == tcp_lb_none &&
+	    inet_addr_is_loopback(&epp->remote.addr) &&
+	    !inet_addr_is_any(&epp->local.addr))) {
 		/* Loop back segment */
 #if 0
 		tcp_ncsim_bounce_seg(sp, seg);
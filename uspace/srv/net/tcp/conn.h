@@ -57,6 +57,12 @@ extern void tcp_conn_segment_arrived(tcp_conn_t *, inet_ep2_t *,
     tcp_segment_t *);
 extern void tcp_unexpected_segment(inet_ep2_t *, tcp_segment_t *);
 extern void tcp_ep2_flipped(inet_ep2_t *, inet_ep2_t *);
+extern void tcp_conn_rcv_buf_consumed(tcp_conn_t *, size_t);
+extern void tcp_conn_snd_buf_acked(tcp_conn_t *, size_t);
+extern bool tcp_conn_snd_ring_drain(tcp_conn_t *);
+extern void tcp_conn_snd_ring_close(tcp_conn_t *);
+extern void tcp_conn_set_buf_max(tcp_conn_t *, size_t, size_t);
+extern void tcp_conns_info_get(tcp_conn_info_t *, size_t, size_t *);
 
 extern tcp_lb_t tcp_conn_lb;
 
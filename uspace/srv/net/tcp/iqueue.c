@@ -186,6 +186,108 @@ errno_t tcp_iqueue_get_ready_seg(tcp_iqueue_t *iqueue, tcp_segment_t **seg)
 	return EOK;
 }
 
+/** Find next range of contiguous queued data beyond RCV.NXT.
+ *
+ * @param iqueue	Incoming queue
+ * @param plink		Start position, updated to where to continue
+ * @param range		Place to store the range
+ * @return		@c true if a range was found
+ */
+static bool tcp_iqueue_next_range(tcp_iqueue_t *iqueue, link_t **plink,
+    tcp_sack_block_t *range)
+{
+	tcp_conn_t *conn = iqueue->conn;
+	tcp_iqueue_entry_t *qe;
+	link_t *link;
+	uint32_t start, end;
+	bool found;
+
+	found = false;
+	link = *plink;
+	while (link != NULL) {
+		qe = list_get_instance(link, tcp_iqueue_entry_t, link);
+		start = qe->seg->seq;
+		end = qe->seg->seq + qe->seg->len;
+
+		if (!found) {
+			/* Only data past a hole is reported */
+			if (qe->seg->len > 0 &&
+			    seq_no_ge(start, conn->rcv_nxt + 1)) {
+				range->start = start;
+				range->end = end;
+				found = true;
+			}
+		} else {
+			/* Stop at the next hole */
+			if (!seq_no_ge(range->end, start))
+				break;
+			if (seq_no_ge(end, range->end))
+				range->end = end;
+		}
+
+		link = list_next(link, &iqueue->list);
+	}
+
+	*plink = link;
+	return found;
+}
+
+/** Determine whether range contains sequence number.
+ *
+ * @param range		Range
+ * @param seq		Sequence number
+ * @return		@c true iff @a seq lies in @a range
+ */
+static bool tcp_iqueue_range_contains(tcp_sack_block_t *range, uint32_t seq)
+{
+	return seq_no_ge(seq, range->start) && !seq_no_ge(seq, range->end);
+}
+
+/** Compute SACK blocks describing out-of-order data in incoming queue.
+ *
+ * As required by RFC 2018 the first block contains the most recently
+ * received segment, the remaining blocks follow in sequence order.
+ *
+ * @param iqueue	Incoming queue
+ * @param blocks	Array to fill in
+ * @param max		Size of @a blocks
+ * @return		Number of blocks stored
+ */
+size_t tcp_iqueue_sack_blocks(tcp_iqueue_t *iqueue, tcp_sack_block_t *blocks,
+    size_t max)
+{
+	tcp_sack_block_t range;
+	link_t *link;
+	uint32_t recent;
+	bool have_recent;
+	size_t cnt;
+
+	if (max == 0)
+		return 0;
+
+	recent = iqueue->conn->rcv_sack_last;
+	have_recent = false;
+	cnt = 0;
+
+	link = list_first(&iqueue->list);
+	while (tcp_iqueue_next_range(iqueue, &link, &range)) {
+		if (tcp_iqueue_range_contains(&range, recent)) {
+			blocks[cnt++] = range;
+			have_recent = true;
+			break;
+		}
+	}
+
+	link = list_first(&iqueue->list);
+	while (cnt < max && tcp_iqueue_next_range(iqueue, &link, &range)) {
+		if (have_recent && tcp_iqueue_range_contains(&range, recent))
+			continue;
+		blocks[cnt++] = range;
+	}
+
+	return cnt;
+}
+
 /**
  * @}
  */
@@ -34,6 +34,7 @@
  * @file TCP header encoding and decoding
  */
 
+#include <adt/checksum.h>
 #include <bitops.h>
 #include <byteorder.h>
 #include <errno.h>
@@ -48,42 +49,6 @@
 
 #define TCP_CHECKSUM_INIT 0xffff
 
-/** One's complement addition.
- *
- * Result is a + b + carry.
- */
-static uint16_t tcp_ocadd16(uint16_t a, uint16_t b)
-{
-	uint32_t s;
-
-	s = (uint32_t)a + (uint32_t)b;
-	return (s & 0xffff) + (s >> 16);
-}
-
-static uint16_t tcp_checksum_calc(uint16_t ivalue, void *data, size_t size)
-{
-	uint16_t sum;
-	uint16_t w;
-	size_t words, i;
-	uint8_t *bdata;
-
-	sum = ~ivalue;
-	words = size / 2;
-	bdata = (uint8_t *)data;
-
-	for (i = 0; i < words; i++) {
-		w = ((uint16_t)bdata[2 * i] << 8) | bdata[2 * i + 1];
-		sum = tcp_ocadd16(sum, w);
-	}
-
-	if (size % 2 != 0) {
-		w = ((uint16_t)bdata[2 * words] << 8);
-		sum = tcp_ocadd16(sum, w);
-	}
-
-	return ~sum;
-}
-
 static void tcp_header_decode_flags(uint16_t doff_flags, tcp_control_t *rctl)
 {
 	tcp_control_t ctl;
@@ -125,7 +90,155 @@ static void tcp_header_encode_flags(tcp_control_t ctl, uint16_t doff_flags0,
 	*rdoff_flags = doff_flags;
 }
 
-static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *hdr)
+/** Store 32-bit value in network byte order at unaligned location. */
+static void tcp_opt_put32(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = (v >> 16) & 0xff;
+	p[2] = (v >> 8) & 0xff;
+	p[3] = v & 0xff;
+}
+
+/** Load 32-bit value in network byte order from unaligned location. */
+static uint32_t tcp_opt_get32(uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	    ((uint32_t)p[2] << 8) | p[3];
+}
+
+/** Compute size of options that will be encoded for a segment.
+ *
+ * @param seg Segment
+ * @return Size of options in bytes, a multiple of four
+ */
+static size_t tcp_header_opts_size(tcp_segment_t *seg)
+{
+	size_t size = 0;
+
+	/* Each option is preceded by NOPs for alignment */
+	if (seg->has_wscale)
+		size += 1 + OPT_WINDOW_SCALE_LEN;
+	if (seg->sack_perm)
+		size += 2 + OPT_SACK_PERMITTED_LEN;
+	if (seg->sack_cnt > 0) {
+		size += 2 + OPT_SACK_HDR_LEN +
+		    seg->sack_cnt * OPT_SACK_BLOCK_LEN;
+	}
+
+	return size;
+}
+
+/** Encode header options.
+ *
+ * @param seg  Segment
+ * @param opts Buffer of tcp_header_opts_size() bytes
+ */
+static void tcp_header_opts_encode(tcp_segment_t *seg, uint8_t *opts)
+{
+	size_t i;
+
+	if (seg->has_wscale) {
+		*opts++ = OPT_NOP;
+		*opts++ = OPT_WINDOW_SCALE;
+		*opts++ = OPT_WINDOW_SCALE_LEN;
+		*opts++ = seg->wscale;
+	}
+
+	if (seg->sack_perm) {
+		*opts++ = OPT_NOP;
+		*opts++ = OPT_NOP;
+		*opts++ = OPT_SACK_PERMITTED;
+		*opts++ = OPT_SACK_PERMITTED_LEN;
+	}
+
+	if (seg->sack_cnt > 0) {
+		*opts++ = OPT_NOP;
+		*opts++ = OPT_NOP;
+		*opts++ = OPT_SACK;
+		*opts++ = OPT_SACK_HDR_LEN + seg->sack_cnt * OPT_SACK_BLOCK_LEN;
+
+		for (i = 0; i < seg->sack_cnt; i++) {
+			tcp_opt_put32(opts, seg->sack[i].start);
+			tcp_opt_put32(opts + 4, seg->sack[i].end);
+			opts += OPT_SACK_BLOCK_LEN;
+		}
+	}
+}
+
+/** Decode header options.
+ *
+ * Unknown options are skipped, malformed option list is ignored from the
+ * point of the error.
+ *
+ * @param opts Options
+ * @param size Size of options in bytes
+ * @param seg  Segment to fill in
+ */
+static void tcp_header_opts_decode(uint8_t *opts, size_t size,
+    tcp_segment_t *seg)
+{
+	size_t i, j;
+	uint8_t olen;
+
+	seg->has_wscale = false;
+	seg->wscale = 0;
+	seg->sack_perm = false;
+	seg->sack_cnt = 0;
+
+	i = 0;
+	while (i < size) {
+		switch (opts[i]) {
+		case OPT_END_LIST:
+			return;
+		case OPT_NOP:
+			++i;
+			continue;
+		default:
+			break;
+		}
+
+		if (i + 1 >= size)
+			return;
+
+		olen = opts[i + 1];
+		if (olen < 2 || i + olen > size)
+			return;
+
+		switch (opts[i]) {
+		case OPT_WINDOW_SCALE:
+			if (olen != OPT_WINDOW_SCALE_LEN)
+				break;
+			seg->has_wscale = true;
+			seg->wscale = opts[i + 2];
+			break;
+		case OPT_SACK_PERMITTED:
+			if (olen != OPT_SACK_PERMITTED_LEN)
+				break;
+			seg->sack_perm = true;
+			break;
+		case OPT_SACK:
+			if ((olen - OPT_SACK_HDR_LEN) % OPT_SACK_BLOCK_LEN != 0)
+				break;
+			for (j = i + OPT_SACK_HDR_LEN; j < i + olen &&
+			    seg->sack_cnt < TCP_SACK_BLOCKS_MAX;
+			    j += OPT_SACK_BLOCK_LEN) {
+				seg->sack[seg->sack_cnt].start =
+				    tcp_opt_get32(opts + j);
+				seg->sack[seg->sack_cnt].end =
+				    tcp_opt_get32(opts + j + 4);
+				++seg->sack_cnt;
+			}
+			break;
+		default:
+			break;
+		}
+
+		i += olen;
+	}
+}
+
+static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg,
+    tcp_header_t *hdr, size_t hdr_size)
 {
 	uint16_t doff_flags;
 	uint16_t doff;
@@ -135,7 +248,7 @@ static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *
 	hdr->seq = host2uint32_t_be(seg->seq);
 	hdr->ack = host2uint32_t_be(seg->ack);
 
-	doff = (sizeof(tcp_header_t) / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
+	doff = (hdr_size / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
 	tcp_header_encode_flags(seg->ctrl, doff, &doff_flags);
 
 	hdr->doff_flags = host2uint16_t_be(doff_flags);
@@ -181,27 +294,34 @@ static ip_ver_t tcp_phdr_setup(tcp_pdu_t *pdu, tcp_phdr_t *phdr,
 	return src_ver;
 }
 
-static void tcp_header_decode(tcp_header_t *hdr, tcp_segment_t *seg)
+static void tcp_header_decode(tcp_header_t *hdr, size_t hdr_size,
+    tcp_segment_t *seg)
 {
 	tcp_header_decode_flags(uint16_t_be2host(hdr->doff_flags), &seg->ctrl);
 	seg->seq = uint32_t_be2host(hdr->seq);
 	seg->ack = uint32_t_be2host(hdr->ack);
 	seg->wnd = uint16_t_be2host(hdr->window);
 	seg->up = uint16_t_be2host(hdr->urg_ptr);
+
+	tcp_header_opts_decode((uint8_t *)hdr + sizeof(tcp_header_t),
+	    hdr_size - sizeof(tcp_header_t), seg);
 }
 
 static errno_t tcp_header_encode(inet_ep2_t *epp, tcp_segment_t *seg,
     void **header, size_t *size)
 {
 	tcp_header_t *hdr;
+	size_t hdr_size;
 
-	hdr = calloc(1, sizeof(tcp_header_t));
+	hdr_size = sizeof(tcp_header_t) + tcp_header_opts_size(seg);
+	hdr = calloc(1, hdr_size);
 	if (hdr == NULL)
 		return ENOMEM;
 
-	tcp_header_setup(epp, seg, hdr);
+	tcp_header_setup(epp, seg, hdr, hdr_size);
+	tcp_header_opts_encode(seg, (uint8_t *)hdr + sizeof(tcp_header_t));
 	*header = hdr;
-	*size = sizeof(tcp_header_t);
+	*size = hdr_size;
 
 	return EOK;
 }
@@ -260,29 +380,32 @@ void tcp_pdu_delete(tcp_pdu_t *pdu)
 	free(pdu);
 }
 
-static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
+/** Compute checksum of pseudo-header and TCP header.
+ *
+ * @param pdu PDU with header filled in and checksum field zero
+ * @return Partial checksum to be continued over the segment text
+ */
+static uint16_t tcp_pdu_header_checksum(tcp_pdu_t *pdu)
 {
 	uint16_t cs_phdr;
-	uint16_t cs_headers;
 	tcp_phdr_t phdr;
 	tcp_phdr6_t phdr6;
 
 	ip_ver_t ver = tcp_phdr_setup(pdu, &phdr, &phdr6);
 	switch (ver) {
 	case ip_v4:
-		cs_phdr = tcp_checksum_calc(TCP_CHECKSUM_INIT, (void *) &phdr,
+		cs_phdr = compute_inet_checksum(TCP_CHECKSUM_INIT, &phdr,
 		    sizeof(tcp_phdr_t));
 		break;
 	case ip_v6:
-		cs_phdr = tcp_checksum_calc(TCP_CHECKSUM_INIT, (void *) &phdr6,
+		cs_phdr = compute_inet_checksum(TCP_CHECKSUM_INIT, &phdr6,
 		    sizeof(tcp_phdr6_t));
 		break;
 	default:
 		assert(false);
 	}
 
-	cs_headers = tcp_checksum_calc(cs_phdr, pdu->header, pdu->header_size);
-	return tcp_checksum_calc(cs_headers, pdu->text, pdu->text_size);
+	return compute_inet_checksum(cs_phdr, pdu->header, pdu->header_size);
 }
 
 static void tcp_pdu_set_checksum(tcp_pdu_t *pdu, uint16_t checksum)
@@ -303,7 +426,7 @@ errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
 	if (nseg == NULL)
 		return ENOMEM;
 
-	tcp_header_decode(pdu->header, nseg);
+	tcp_header_decode(pdu->header, pdu->header_size, nseg);
 	nseg->len += seq_no_control_len(nseg->ctrl);
 
 	hdr = (tcp_header_t *)pdu->header;
@@ -346,10 +469,11 @@ errno_t tcp_pdu_encode(inet_ep2_t *epp, tcp_segment_t *seg, tcp_pdu_t **pdu)
 	}
 
 	npdu->text_size = text_size;
-	memcpy(npdu->text, seg->data, text_size);
 
-	/* Checksum calculation */
-	checksum = tcp_pdu_checksum_calc(npdu);
+	/* Checksum calculation, fused with copying the text */
+	checksum = tcp_pdu_header_checksum(npdu);
+	checksum = compute_inet_checksum_copy(checksum, npdu->text, seg->data,
+	    text_size);
 	tcp_pdu_set_checksum(npdu, checksum);
 
 	*pdu = npdu;
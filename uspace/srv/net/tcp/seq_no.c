@@ -213,6 +213,19 @@ uint32_t seq_no_control_len(tcp_control_t ctrl)
 	return len;
 }
 
+/** Determine whether sequence number @a a is at or past @a b.
+ *
+ * The two numbers must be less than half the sequence space apart.
+ *
+ * @param a First sequence number
+ * @param b Second sequence number
+ * @return @c true iff @a a >= @a b modulo sequence space wraparound
+ */
+bool seq_no_ge(uint32_t a, uint32_t b)
+{
+	return (int32_t)(a - b) >= 0;
+}
+
 /** Calculate the amount of trim needed to fit segment in receive window.
  *
  * @param conn  Connection
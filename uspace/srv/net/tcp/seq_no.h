@@ -51,6 +51,7 @@ extern void seq_no_seg_trim_calc(tcp_conn_t *, tcp_segment_t *, uint32_t *,
 extern int seq_no_seg_cmp(tcp_conn_t *, tcp_segment_t *, tcp_segment_t *);
 
 extern uint32_t seq_no_control_len(tcp_control_t);
+extern bool seq_no_ge(uint32_t, uint32_t);
 
 #endif
 
@@ -618,8 +618,7 @@ static errno_t tcp_conn_push_impl(tcp_client_t *client, sysarg_t conn_id)
 		return ENOENT;
 	}
 
-	(void) cconn;
-	/* XXX TODO */
+	tcp_uc_push(cconn->conn);
 	return EOK;
 }
 
@@ -647,6 +646,61 @@ static errno_t tcp_conn_reset_impl(tcp_client_t *client, sysarg_t conn_id)
 	return EOK;
 }
 
+/** Set connection buffer size ceilings.
+ *
+ * Handle client request to set buffer ceilings (with parameters
+ * unmarshalled).
+ *
+ * @param client  TCP client
+ * @param conn_id Connection ID
+ * @param rcv_max Receive buffer ceiling in bytes or 0 to keep current
+ * @param snd_max Send buffer ceiling in bytes or 0 to keep current
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t tcp_conn_set_buf_max_impl(tcp_client_t *client,
+    sysarg_t conn_id, size_t rcv_max, size_t snd_max)
+{
+	tcp_cconn_t *cconn;
+	errno_t rc;
+
+	rc = tcp_cconn_get(client, conn_id, &cconn);
+	if (rc != EOK) {
+		assert(rc == ENOENT);
+		return ENOENT;
+	}
+
+	tcp_uc_set_buf_max(cconn->conn, rcv_max, snd_max);
+	return EOK;
+}
+
+/** Enable or disable Nagle algorithm on connection.
+ *
+ * Handle client request to set no-delay option (with parameters
+ * unmarshalled).
+ *
+ * @param client  TCP client
+ * @param conn_id Connection ID
+ * @param nodelay @c true to disable Nagle algorithm
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t tcp_conn_set_nodelay_impl(tcp_client_t *client,
+    sysarg_t conn_id, bool nodelay)
+{
+	tcp_cconn_t *cconn;
+	errno_t rc;
+
+	rc = tcp_cconn_get(client, conn_id, &cconn);
+	if (rc != EOK) {
+		assert(rc == ENOENT);
+		return ENOENT;
+	}
+
+	tcp_uc_set_nodelay(cconn->conn, nodelay);
+	return EOK;
+}
+
 /** Send data over connection..
  *
  * Handle client request to send data (with parameters unmarshalled).
@@ -936,6 +990,131 @@ static void tcp_conn_reset_srv(tcp_client_t *client, ipc_call_t *icall)
 	async_answer_0(icall, rc);
 }
 
+/** Set connection buffer size ceilings.
+ *
+ * Handle client request to set buffer ceilings.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_set_buf_max_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	sysarg_t conn_id;
+	size_t rcv_max;
+	size_t snd_max;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_set_buf_max_srv()");
+
+	conn_id = ipc_get_arg1(icall);
+	rcv_max = ipc_get_arg2(icall);
+	snd_max = ipc_get_arg3(icall);
+	rc = tcp_conn_set_buf_max_impl(client, conn_id, rcv_max, snd_max);
+	async_answer_0(icall, rc);
+}
+
+/** Enable or disable Nagle algorithm on connection.
+ *
+ * Handle client request to set no-delay option.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_set_nodelay_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	sysarg_t conn_id;
+	bool nodelay;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_set_nodelay_srv()");
+
+	conn_id = ipc_get_arg1(icall);
+	nodelay = ipc_get_arg2(icall) != 0;
+	rc = tcp_conn_set_nodelay_impl(client, conn_id, nodelay);
+	async_answer_0(icall, rc);
+}
+
+/** Handle a call on the send ring of a connection.
+ *
+ * Handle client request to set up a shared-memory ring for sending data
+ * over a connection, or a doorbell on such ring.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_send_ring_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	tcp_cconn_t *cconn;
+	sysarg_t conn_id;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_send_ring_srv()");
+
+	conn_id = async_ring_arg(icall);
+	rc = tcp_cconn_get(client, conn_id, &cconn);
+	if (rc != EOK) {
+		assert(rc == ENOENT);
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	tcp_uc_send_ring(cconn->conn, icall);
+}
+
+/** Get information on all connections.
+ *
+ * Handle client request to list connections with their statistics.
+ * The answer carries the size of the entire list in bytes, which may
+ * exceed the size of the caller's buffer.
+ *
+ * @param client TCP client
+ * @param icall  Async request data
+ *
+ */
+static void tcp_conn_info_list_srv(tcp_client_t *client, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	tcp_conn_info_t *info;
+	size_t size;
+	size_t count;
+	size_t total;
+	errno_t rc;
+
+	(void) client;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_info_list_srv()");
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	count = size / sizeof(tcp_conn_info_t);
+	info = calloc(max(count, 1), sizeof(tcp_conn_info_t));
+	if (info == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	tcp_conns_info_get(info, count, &total);
+
+	rc = async_data_read_finalize(&call, info,
+	    min(count, total) * sizeof(tcp_conn_info_t));
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		free(info);
+		return;
+	}
+
+	async_answer_1(icall, EOK, total * sizeof(tcp_conn_info_t));
+	free(info);
+}
+
 /** Send data via connection..
  *
  * Handle client request to send data via connection.
@@ -1223,6 +1402,18 @@ static void tcp_client_conn(ipc_call_t *icall, void *arg)
 		case TCP_CONN_RECV_WAIT:
 			tcp_conn_recv_wait_srv(&client, &call);
 			break;
+		case TCP_CONN_SET_BUF_MAX:
+			tcp_conn_set_buf_max_srv(&client, &call);
+			break;
+		case TCP_CONN_SET_NODELAY:
+			tcp_conn_set_nodelay_srv(&client, &call);
+			break;
+		case TCP_CONN_INFO_LIST:
+			tcp_conn_info_list_srv(&client, &call);
+			break;
+		case TCP_CONN_SEND_RING:
+			tcp_conn_send_ring_srv(&client, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
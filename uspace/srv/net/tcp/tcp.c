@@ -38,8 +38,10 @@
 #include <errno.h>
 #include <io/log.h>
 #include <stdio.h>
+#include <str.h>
 #include <task.h>
 
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
 #include "ncsim.h"
@@ -89,12 +91,29 @@ static errno_t tcp_init(void)
 	return EOK;
 }
 
+static void print_syntax(void)
+{
+	printf("syntax: " NAME " [-c <cubic|newreno>]\n");
+}
+
 int main(int argc, char **argv)
 {
 	errno_t rc;
 
 	printf(NAME ": TCP (Transmission Control Protocol) network module\n");
 
+	if (argc == 3 && str_cmp(argv[1], "-c") == 0) {
+		rc = tcp_cc_default_set(argv[2]);
+		if (rc != EOK) {
+			printf(NAME ": Unknown congestion control '%s'.\n",
+			    argv[2]);
+			return 1;
+		}
+	} else if (argc != 1) {
+		print_syntax();
+		return 1;
+	}
+
 	rc = log_init(NAME);
 	if (rc != EOK) {
 		printf(NAME ": Failed to initialize log.\n");
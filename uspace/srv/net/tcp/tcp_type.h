@@ -37,14 +37,17 @@
 
 #include <adt/list.h>
 #include <async.h>
+#include <async_ring.h>
 #include <stdbool.h>
 #include <fibril.h>
 #include <fibril_synch.h>
 #include <refcount.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
+#include <types/inet/tcp.h>
 
 struct tcp_conn;
 
@@ -154,6 +157,17 @@ typedef struct {
 	tcp_cstate_t cstate;
 } tcp_conn_status_t;
 
+/** Maximum number of SACK blocks carried by one segment */
+#define TCP_SACK_BLOCKS_MAX	4
+
+/** SACK block, range of received sequence numbers [start, end) */
+typedef struct {
+	/** First sequence number of the block */
+	uint32_t start;
+	/** Sequence number following the block */
+	uint32_t end;
+} tcp_sack_block_t;
+
 typedef struct {
 	/** SYN, FIN */
 	tcp_control_t ctrl;
@@ -168,6 +182,16 @@ typedef struct {
 	uint32_t wnd;
 	/** Segment urgent pointer */
 	uint32_t up;
+	/** Segment carries window scale option (SYN segments only) */
+	bool has_wscale;
+	/** Window scale shift count from the option */
+	uint8_t wscale;
+	/** Segment carries SACK permitted option (SYN segments only) */
+	bool sack_perm;
+	/** Number of SACK blocks */
+	size_t sack_cnt;
+	/** SACK blocks */
+	tcp_sack_block_t sack[TCP_SACK_BLOCKS_MAX];
 
 	/** Segment data, may be moved when trimming segment */
 	void *data;
@@ -207,6 +231,10 @@ typedef struct {
 	link_t link;
 	tcp_conn_t *conn;
 	tcp_segment_t *seg;
+	/** Peer reported the segment received in a SACK block */
+	bool sacked;
+	/** Segment was retransmitted during the current recovery */
+	bool rexmitted;
 } tcp_tqueue_entry_t;
 
 /** Retransmission queue callbacks */
@@ -227,6 +255,59 @@ typedef struct {
 	tcp_tqueue_cb_t *cb;
 } tcp_tqueue_t;
 
+/** Congestion control algorithm operations */
+typedef struct tcp_cc_ops {
+	/** Algorithm name */
+	const char *name;
+	/** Initialize algorithm-specific state */
+	void (*init)(tcp_conn_t *);
+	/** Congestion detected, return new slow start threshold */
+	uint32_t (*ssthresh)(tcp_conn_t *);
+	/** Grow congestion window in congestion avoidance */
+	void (*cong_avoid)(tcp_conn_t *, uint32_t);
+} tcp_cc_ops_t;
+
+/** Loss recovery state */
+typedef enum {
+	/** Not recovering */
+	cr_none,
+	/** Fast recovery after duplicate ACKs */
+	cr_fast,
+	/** Recovery after retransmission timeout */
+	cr_loss
+} tcp_cc_recovery_t;
+
+/** Congestion control state */
+typedef struct {
+	/** Algorithm */
+	tcp_cc_ops_t *ops;
+	/** Congestion window (bytes) */
+	uint32_t cwnd;
+	/** Slow start threshold (bytes) */
+	uint32_t ssthresh;
+	/** Number of consecutive duplicate ACKs */
+	unsigned dupacks;
+	/** Loss recovery state */
+	tcp_cc_recovery_t recovery;
+	/** Highest sequence number sent when recovery started */
+	uint32_t recover;
+
+	/* CUBIC state */
+
+	/** Window just before the last reduction (bytes) */
+	uint32_t w_max;
+	/** Window at which the cubic function was started (bytes) */
+	uint32_t origin;
+	/** Estimate of Reno-friendly window (bytes) */
+	uint32_t w_est;
+	/** Time to reach @c origin from start of epoch (msec) */
+	msec_t k;
+	/** @c epoch_start is valid */
+	bool epoch_valid;
+	/** Start of current congestion avoidance epoch */
+	struct timespec epoch_start;
+} tcp_cc_t;
+
 /** Connection */
 struct tcp_conn {
 	char *name;
@@ -271,6 +352,11 @@ struct tcp_conn {
 	/** Time-Wait timeout timer */
 	fibril_timer_t *tw_timer;
 
+	/** Delayed ACK timer */
+	fibril_timer_t *dack_timer;
+	/** Received data segments whose ACK is being delayed */
+	unsigned dack_segs;
+
 	/** Receive buffer */
 	uint8_t *rcv_buf;
 	/** Receive buffer size */
@@ -281,6 +367,12 @@ struct tcp_conn {
 	bool rcv_buf_fin;
 	/** Receive buffer CV. Broadcast when new data is inserted */
 	fibril_condvar_t rcv_buf_cv;
+	/** Ceiling for receive buffer auto-tuning */
+	size_t rcv_buf_max;
+	/** Bytes passed to the user since @c rcv_tune_time */
+	size_t rcv_copied;
+	/** Start of current receive buffer tuning interval */
+	struct timespec rcv_tune_time;
 
 	/** Send buffer */
 	uint8_t *snd_buf;
@@ -292,6 +384,18 @@ struct tcp_conn {
 	bool snd_buf_fin;
 	/** Send buffer CV. Broadcast when space is made available in buffer */
 	fibril_condvar_t snd_buf_cv;
+	/** Ceiling for send buffer auto-tuning */
+	size_t snd_buf_max;
+	/** Ring shared by the user, drained into the send buffer, or NULL */
+	async_ring_t *snd_ring;
+	/** Bytes acknowledged since @c snd_tune_time */
+	size_t snd_acked;
+	/** Start of current send buffer tuning interval */
+	struct timespec snd_tune_time;
+	/** Nagle algorithm disabled, send small segments right away */
+	bool nodelay;
+	/** User pushed data, send buffer contents without delay */
+	bool snd_push;
 
 	/** Send unacknowledged */
 	uint32_t snd_una;
@@ -314,8 +418,50 @@ struct tcp_conn {
 	uint32_t rcv_wnd;
 	/** Receive urgent pointer */
 	uint32_t rcv_up;
+	/** Right edge of receive window last advertised to the peer */
+	uint32_t rcv_adv;
 	/** Initial receive sequence number */
 	uint32_t irs;
+
+	/** Window scaling is in effect (both SYNs carried the option) */
+	bool wscale_ok;
+	/** Shift count applied to SEG.WND of incoming segments */
+	uint8_t snd_wscale;
+	/** Shift count applied to RCV.WND we advertise */
+	uint8_t rcv_wscale;
+
+	/** Selective acknowledgements in use (both SYNs carried option) */
+	bool sack_ok;
+	/** Sequence number of the most recent out-of-order segment */
+	uint32_t rcv_sack_last;
+
+	/** Sequence number of segment being timed for RTT, if any */
+	uint32_t rtt_seq;
+	/** A segment is being timed */
+	bool rtt_timing;
+	/** Time when the timed segment was sent */
+	struct timespec rtt_start;
+	/** Smoothed round-trip time (usec), 0 if not measured yet */
+	usec_t srtt;
+	/** Round-trip time variation (usec) */
+	usec_t rttvar;
+	/** Retransmission timeout (usec) */
+	usec_t rto;
+
+	/** Congestion control */
+	tcp_cc_t cc;
+
+	/** Receive-side RTT estimate is being measured */
+	bool rcv_rtt_timing;
+	/** Measurement ends when RCV.NXT reaches this sequence number */
+	uint32_t rcv_rtt_seq;
+	/** Time when receive-side RTT measurement started */
+	struct timespec rcv_rtt_start;
+	/** Receive-side RTT estimate (usec), 0 if not measured yet */
+	usec_t rcv_rtt;
+
+	/** Packet statistics */
+	tcp_conn_stats_t stats;
 };
 
 /** Continuation of processing.
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <io/log.h>
+#include <pcut/pcut.h>
+
+#include "../cc.h"
+#include "../conn.h"
+#include "../segment.h"
+#include "../tqueue.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(cc);
+
+static int seg_cnt;
+
+static void cc_test_transmit_seg(inet_ep2_t *, tcp_segment_t *);
+
+static tcp_tqueue_cb_t cc_test_cb = {
+	.transmit_seg = cc_test_transmit_seg
+};
+
+PCUT_TEST_BEFORE
+{
+	errno_t rc;
+
+	/* We will be calling functions that perform logging */
+	rc = log_init("test-tcp");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = tcp_conns_init();
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = tcp_cc_default_set("newreno");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
+PCUT_TEST_AFTER
+{
+	(void) tcp_cc_default_set("cubic");
+	tcp_conns_fini();
+}
+
+/** Create established connection with @a nseg segments in flight */
+static tcp_conn_t *cc_test_conn(int nseg)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	int i;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->retransmit.cb = &cc_test_cb;
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 10;
+	conn->snd_wnd = 1024 * 1024;
+	conn->cc.cwnd = nseg * TCP_SMSS;
+
+	tcp_conn_lock(conn);
+	for (i = 0; i < nseg; i++) {
+		conn->snd_buf_used = TCP_SMSS;
+		tcp_tqueue_new_data(conn);
+	}
+	tcp_conn_unlock(conn);
+
+	PCUT_ASSERT_INT_EQUALS(10 + nseg * TCP_SMSS, conn->snd_nxt);
+	return conn;
+}
+
+static void cc_test_conn_delete(tcp_conn_t *conn)
+{
+	tcp_conn_lock(conn);
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+	tcp_conn_delete(conn);
+}
+
+/** Unknown algorithm cannot be selected */
+PCUT_TEST(default_set)
+{
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, tcp_cc_default_set("foo"));
+	PCUT_ASSERT_ERRNO_VAL(EOK, tcp_cc_default_set("cubic"));
+	PCUT_ASSERT_ERRNO_VAL(EOK, tcp_cc_default_set("newreno"));
+}
+
+/** Test that the congestion window limits transmission */
+PCUT_TEST(cwnd_limit)
+{
+	tcp_conn_t *conn;
+
+	conn = cc_test_conn(2);
+
+	tcp_conn_lock(conn);
+	seg_cnt = 0;
+	conn->snd_buf_used = TCP_SMSS;
+	tcp_tqueue_new_data(conn);
+	tcp_conn_unlock(conn);
+
+	/* Window is full, nothing is sent */
+	PCUT_ASSERT_INT_EQUALS(0, seg_cnt);
+	PCUT_ASSERT_INT_EQUALS(TCP_SMSS, conn->snd_buf_used);
+
+	cc_test_conn_delete(conn);
+}
+
+/** Test slow start growth */
+PCUT_TEST(slow_start)
+{
+	tcp_conn_t *conn;
+
+	conn = cc_test_conn(2);
+
+	tcp_conn_lock(conn);
+	conn->snd_una += TCP_SMSS;
+	tcp_tqueue_ack_received(conn);
+	tcp_conn_unlock(conn);
+
+	PCUT_ASSERT_INT_EQUALS(3 * TCP_SMSS, conn->cc.cwnd);
+
+	cc_test_conn_delete(conn);
+}
+
+/** Test fast retransmit and NewReno recovery */
+PCUT_TEST(fast_recovery)
+{
+	tcp_conn_t *conn;
+	uint32_t recover;
+	int i;
+
+	conn = cc_test_conn(8);
+	recover = conn->snd_nxt;
+
+	tcp_conn_lock(conn);
+	seg_cnt = 0;
+	for (i = 0; i < TCP_DUPACK_THRESH; i++)
+		tcp_cc_dupack(conn);
+
+	/* Third duplicate ACK triggers fast retransmit */
+	PCUT_ASSERT_INT_EQUALS(1, seg_cnt);
+	PCUT_ASSERT_INT_EQUALS(cr_fast, conn->cc.recovery);
+	PCUT_ASSERT_INT_EQUALS(4 * TCP_SMSS, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(7 * TCP_SMSS, conn->cc.cwnd);
+
+	/* Partial ACK retransmits next segment */
+	conn->snd_una += TCP_SMSS;
+	tcp_tqueue_ack_received(conn);
+	PCUT_ASSERT_INT_EQUALS(2, seg_cnt);
+	PCUT_ASSERT_INT_EQUALS(cr_fast, conn->cc.recovery);
+
+	/* Full ACK ends recovery */
+	conn->snd_una = recover;
+	tcp_tqueue_ack_received(conn);
+	PCUT_ASSERT_INT_EQUALS(cr_none, conn->cc.recovery);
+
+	/* Nothing in flight, window deflates to FlightSize + SMSS */
+	PCUT_ASSERT_INT_EQUALS(2 * TCP_SMSS, conn->cc.cwnd);
+	tcp_conn_unlock(conn);
+
+	cc_test_conn_delete(conn);
+}
+
+/** Test retransmission timeout */
+PCUT_TEST(timeout)
+{
+	tcp_conn_t *conn;
+
+	conn = cc_test_conn(8);
+
+	tcp_conn_lock(conn);
+	tcp_cc_timeout(conn);
+	tcp_conn_unlock(conn);
+
+	PCUT_ASSERT_INT_EQUALS(cr_loss, conn->cc.recovery);
+	PCUT_ASSERT_INT_EQUALS(4 * TCP_SMSS, conn->cc.ssthresh);
+	PCUT_ASSERT_INT_EQUALS(TCP_SMSS, conn->cc.cwnd);
+
+	cc_test_conn_delete(conn);
+}
+
+static void cc_test_transmit_seg(inet_ep2_t *epp, tcp_segment_t *seg)
+{
+	seg_cnt++;
+}
+
+PCUT_EXPORT(cc);
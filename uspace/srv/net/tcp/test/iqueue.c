@@ -175,4 +175,66 @@ PCUT_TEST(two_segments)
 	tcp_conn_delete(conn);
 }
 
+/** Test computing SACK blocks from out-of-order segments */
+PCUT_TEST(sack_blocks)
+{
+	tcp_conn_t *conn;
+	tcp_iqueue_t iqueue;
+	inet_ep2_t epp;
+	tcp_segment_t *seg1, *seg2, *seg3;
+	tcp_sack_block_t blocks[TCP_SACK_BLOCKS_MAX];
+	void *data;
+	size_t dsize;
+	size_t cnt;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->rcv_nxt = 10;
+	conn->rcv_wnd = 100;
+
+	dsize = 10;
+	data = calloc(dsize, 1);
+	PCUT_ASSERT_NOT_NULL(data);
+
+	seg1 = tcp_segment_make_data(0, data, dsize);
+	PCUT_ASSERT_NOT_NULL(seg1);
+	seg2 = tcp_segment_make_data(0, data, dsize);
+	PCUT_ASSERT_NOT_NULL(seg2);
+	seg3 = tcp_segment_make_data(0, data, dsize);
+	PCUT_ASSERT_NOT_NULL(seg3);
+
+	tcp_iqueue_init(&iqueue, conn);
+	cnt = tcp_iqueue_sack_blocks(&iqueue, blocks, TCP_SACK_BLOCKS_MAX);
+	PCUT_ASSERT_INT_EQUALS(0, cnt);
+
+	/* Two adjacent segments after a hole, then another hole */
+	seg1->seq = 20;
+	seg2->seq = 30;
+	seg3->seq = 50;
+	tcp_iqueue_insert_seg(&iqueue, seg3);
+	tcp_iqueue_insert_seg(&iqueue, seg1);
+	tcp_iqueue_insert_seg(&iqueue, seg2);
+
+	/* Most recently received segment is reported first */
+	conn->rcv_sack_last = 50;
+
+	cnt = tcp_iqueue_sack_blocks(&iqueue, blocks, TCP_SACK_BLOCKS_MAX);
+	PCUT_ASSERT_INT_EQUALS(2, cnt);
+	PCUT_ASSERT_INT_EQUALS(50, blocks[0].start);
+	PCUT_ASSERT_INT_EQUALS(60, blocks[0].end);
+	PCUT_ASSERT_INT_EQUALS(20, blocks[1].start);
+	PCUT_ASSERT_INT_EQUALS(40, blocks[1].end);
+
+	tcp_iqueue_remove_seg(&iqueue, seg1);
+	tcp_iqueue_remove_seg(&iqueue, seg2);
+	tcp_iqueue_remove_seg(&iqueue, seg3);
+	tcp_segment_delete(seg1);
+	tcp_segment_delete(seg2);
+	tcp_segment_delete(seg3);
+	free(data);
+	tcp_conn_delete(conn);
+}
+
 PCUT_EXPORT(iqueue);
@@ -36,12 +36,23 @@
 /** Verify that two segments have the same content */
 void test_seg_same(tcp_segment_t *a, tcp_segment_t *b)
 {
+	size_t i;
+
 	PCUT_ASSERT_INT_EQUALS(a->ctrl, b->ctrl);
 	PCUT_ASSERT_INT_EQUALS(a->seq, b->seq);
 	PCUT_ASSERT_INT_EQUALS(a->ack, b->ack);
 	PCUT_ASSERT_INT_EQUALS(a->len, b->len);
 	PCUT_ASSERT_INT_EQUALS(a->wnd, b->wnd);
 	PCUT_ASSERT_INT_EQUALS(a->up, b->up);
+	PCUT_ASSERT_INT_EQUALS(a->has_wscale, b->has_wscale);
+	if (a->has_wscale)
+		PCUT_ASSERT_INT_EQUALS(a->wscale, b->wscale);
+	PCUT_ASSERT_INT_EQUALS(a->sack_perm, b->sack_perm);
+	PCUT_ASSERT_INT_EQUALS(a->sack_cnt, b->sack_cnt);
+	for (i = 0; i < a->sack_cnt; i++) {
+		PCUT_ASSERT_INT_EQUALS(a->sack[i].start, b->sack[i].start);
+		PCUT_ASSERT_INT_EQUALS(a->sack[i].end, b->sack[i].end);
+	}
 	PCUT_ASSERT_INT_EQUALS(tcp_segment_text_size(a),
 	    tcp_segment_text_size(b));
 	if (tcp_segment_text_size(a) != 0)
@@ -56,6 +67,7 @@ void test_seg_same(tcp_segment_t *a, tcp_segment_t *b)
 
 PCUT_INIT;
 
+PCUT_IMPORT(cc);
 PCUT_IMPORT(conn);
 PCUT_IMPORT(iqueue);
 PCUT_IMPORT(pdu);
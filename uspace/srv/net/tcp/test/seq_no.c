@@ -546,4 +546,16 @@ PCUT_TEST(control_len)
 	    CTL_ACK | CTL_RST));
 }
 
+/** Test seq_no_ge() */
+PCUT_TEST(ge)
+{
+	PCUT_ASSERT_TRUE(seq_no_ge(10, 10));
+	PCUT_ASSERT_TRUE(seq_no_ge(11, 10));
+	PCUT_ASSERT_FALSE(seq_no_ge(9, 10));
+
+	/* Wrap around */
+	PCUT_ASSERT_TRUE(seq_no_ge(5, 0xfffffff0));
+	PCUT_ASSERT_FALSE(seq_no_ge(0xfffffff0, 5));
+}
+
 PCUT_EXPORT(seq_no);
@@ -216,6 +216,9 @@ PCUT_TEST(ack_received)
 	conn->snd_nxt = 10;
 	conn->snd_wnd = 1024;
 
+	/* Send the second short segment while the first is in flight */
+	conn->nodelay = true;
+
 	/* Redirect segment transmission */
 	conn->retransmit.cb = &tqueue_test_cb;
 	seg_cnt = 0;
@@ -253,6 +256,138 @@ PCUT_TEST(ack_received)
 	tcp_conn_delete(conn);
 }
 
+/** Test Nagle algorithm holding back short segment while data in flight */
+PCUT_TEST(new_data_nagle)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 20;
+	conn->snd_wnd = 1024;
+	conn->snd_buf_used = 30;
+	conn->snd_buf_fin = false;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+
+	/* Short segment is held back */
+	tcp_tqueue_new_data(conn);
+	PCUT_ASSERT_EQUALS(20, conn->snd_nxt);
+	PCUT_ASSERT_EQUALS(30, conn->snd_buf_used);
+	PCUT_ASSERT_EQUALS(0, seg_cnt);
+
+	/* Disabling Nagle releases it */
+	conn->nodelay = true;
+	tcp_tqueue_new_data(conn);
+	PCUT_ASSERT_EQUALS(50, conn->snd_nxt);
+	PCUT_ASSERT_EQUALS(0, conn->snd_buf_used);
+	PCUT_ASSERT_EQUALS(1, conn->stats.seg_sent);
+	PCUT_ASSERT_EQUALS(30, conn->stats.bytes_sent);
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+
+	tcp_conn_delete(conn);
+	PCUT_ASSERT_EQUALS(1, seg_cnt);
+}
+
+/** Test push overriding Nagle algorithm */
+PCUT_TEST(new_data_push)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 20;
+	conn->snd_wnd = 1024;
+	conn->snd_buf_used = 30;
+	conn->snd_buf_fin = false;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+	conn->snd_push = true;
+	tcp_tqueue_new_data(conn);
+	PCUT_ASSERT_EQUALS(50, conn->snd_nxt);
+	PCUT_ASSERT_FALSE(conn->snd_push);
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+
+	tcp_conn_delete(conn);
+	PCUT_ASSERT_EQUALS(1, seg_cnt);
+}
+
+/** Test delayed ACK and ACK of every second segment */
+PCUT_TEST(ack_delayed)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	/* XXX tqueue can only be created via tcp_conn_new */
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->cstate = st_established;
+	conn->snd_una = 10;
+	conn->snd_nxt = 10;
+	conn->rcv_nxt = 100;
+
+	/* Redirect segment transmission */
+	conn->retransmit.cb = &tqueue_test_cb;
+	seg_cnt = 0;
+
+	tcp_conn_lock(conn);
+
+	/* ACK of the first segment is delayed */
+	tcp_tqueue_ack_delayed(conn);
+	PCUT_ASSERT_EQUALS(0, seg_cnt);
+	PCUT_ASSERT_INT_EQUALS(1, conn->dack_segs);
+
+	/* Second segment is acknowledged right away */
+	tcp_tqueue_ack_delayed(conn);
+	PCUT_ASSERT_EQUALS(1, seg_cnt);
+	PCUT_ASSERT_INT_EQUALS(0, conn->dack_segs);
+
+	/* Pending ACK is piggybacked on data */
+	tcp_tqueue_ack_delayed(conn);
+	PCUT_ASSERT_INT_EQUALS(1, conn->dack_segs);
+	conn->snd_wnd = 1024;
+	conn->snd_buf_used = 10;
+	tcp_tqueue_new_data(conn);
+	PCUT_ASSERT_EQUALS(2, seg_cnt);
+	PCUT_ASSERT_INT_EQUALS(0, conn->dack_segs);
+
+	/* One pure ACK, the other one went with data */
+	PCUT_ASSERT_EQUALS(1, conn->stats.ack_sent);
+	PCUT_ASSERT_EQUALS(2, conn->stats.ack_delayed);
+	PCUT_ASSERT_EQUALS(10, conn->stats.bytes_sent);
+
+	tcp_conn_reset(conn);
+	tcp_conn_unlock(conn);
+
+	tcp_conn_delete(conn);
+}
+
 static void tqueue_test_transmit_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 {
 	trans_seg[seg_cnt++] = seg;
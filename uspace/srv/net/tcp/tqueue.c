@@ -43,18 +43,34 @@
 #include <mem.h>
 #include <stdlib.h>
 
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
+#include "iqueue.h"
 #include "ncsim.h"
 #include "rqueue.h"
 #include "segment.h"
 #include "seq_no.h"
+#include "std.h"
 #include "tqueue.h"
 #include "tcp_type.h"
 
-#define RETRANSMIT_TIMEOUT	(2*1000*1000)
+/** Initial retransmission timeout (RFC 6298 2.1) */
+#define TCP_RTO_INIT	(1000 * 1000)
+/** Lower bound for retransmission timeout (RFC 6298 2.4) */
+#define TCP_RTO_MIN	(1000 * 1000)
+/** Upper bound for retransmission timeout (RFC 6298 2.5) */
+#define TCP_RTO_MAX	(60 * 1000 * 1000)
+/** Clock granularity G (RFC 6298) */
+#define TCP_CLOCK_G	1000
+/** Delayed ACK timeout (RFC 1122 4.2.3.2 requires less than 0.5 s) */
+#define TCP_DACK_TIMEOUT	(200 * 1000)
+/** Acknowledge at least every this many received data segments */
+#define TCP_DACK_SEGS	2
 
 static void retransmit_timeout_func(void *);
+static void dack_timeout_func(void *);
+static void tcp_tqueue_dack_clear(tcp_conn_t *);
 static void tcp_tqueue_timer_set(tcp_conn_t *);
 static void tcp_tqueue_timer_clear(tcp_conn_t *);
 static void tcp_tqueue_seg(tcp_conn_t *, tcp_segment_t *);
@@ -67,6 +83,9 @@ errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
 {
 	tqueue->conn = conn;
 	tqueue->timer = fibril_timer_create(&conn->lock);
+	conn->srtt = 0;
+	conn->rttvar = 0;
+	conn->rto = TCP_RTO_INIT;
 	tqueue->cb = cb;
 	if (tqueue->timer == NULL)
 		return ENOMEM;
@@ -79,6 +98,7 @@ errno_t tcp_tqueue_init(tcp_tqueue_t *tqueue, tcp_conn_t *conn,
 void tcp_tqueue_clear(tcp_tqueue_t *tqueue)
 {
 	tcp_tqueue_timer_clear(tqueue->conn);
+	tcp_tqueue_dack_clear(tqueue->conn);
 }
 
 void tcp_tqueue_fini(tcp_tqueue_t *tqueue)
@@ -149,6 +169,13 @@ static void tcp_tqueue_seg(tcp_conn_t *conn, tcp_segment_t *seg)
 
 		list_append(&tqe->link, &conn->retransmit.list);
 
+		/* Time one segment per round trip */
+		if (!conn->rtt_timing) {
+			conn->rtt_timing = true;
+			conn->rtt_seq = conn->snd_nxt + seg->len;
+			getuptime(&conn->rtt_start);
+		}
+
 		/* Set retransmission timer */
 		tcp_tqueue_timer_set(conn);
 	}
@@ -179,6 +206,7 @@ static void tcp_prepare_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 void tcp_tqueue_new_data(tcp_conn_t *conn)
 {
 	size_t avail_wnd;
+	size_t flight;
 	size_t xfer_seqlen;
 	size_t snd_buf_seqlen;
 	size_t data_size;
@@ -189,52 +217,110 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_new_data()", conn->name);
 
-	/* Number of free sequence numbers in send window */
-	avail_wnd = (conn->snd_una + conn->snd_wnd) - conn->snd_nxt;
-	snd_buf_seqlen = conn->snd_buf_used + (conn->snd_buf_fin ? 1 : 0);
+	while (true) {
+		/* Pull data from the send ring into the space just freed */
+		if (!conn->snd_buf_fin)
+			(void) tcp_conn_snd_ring_drain(conn);
+
+		/*
+		 * Number of free sequence numbers in send window, limited
+		 * by the congestion window.
+		 */
+		avail_wnd = tcp_cc_send_wnd(conn);
+		flight = tcp_cc_flight(conn);
+		avail_wnd = avail_wnd > flight ? avail_wnd - flight : 0;
+		snd_buf_seqlen = conn->snd_buf_used +
+		    (conn->snd_buf_fin ? 1 : 0);
+
+		xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, "
+		    "SND.WND = %" PRIu32 ", xfer_seqlen = %zu", conn->name,
+		    snd_buf_seqlen, conn->snd_wnd, xfer_seqlen);
+
+		if (xfer_seqlen == 0)
+			return;
 
-	xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, SND.WND = %" PRIu32 ", "
-	    "xfer_seqlen = %zu", conn->name, snd_buf_seqlen, conn->snd_wnd,
-	    xfer_seqlen);
+		/* Large windows are sent as a train of segments */
+		xfer_seqlen = min(xfer_seqlen, TCP_SMSS);
 
-	if (xfer_seqlen == 0)
-		return;
+		send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen;
 
-	/* XXX Do not always send immediately */
+		/*
+		 * Nagle algorithm (RFC 1122 4.2.3.4): while data is in
+		 * flight, hold back a short segment until the ACK arrives
+		 * so that small writes coalesce into full segments.
+		 */
+		if (xfer_seqlen < TCP_SMSS && flight > 0 && !send_fin &&
+		    !conn->nodelay && !conn->snd_push) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Nagle, holding "
+			    "%zu bytes", conn->name, xfer_seqlen);
+			return;
+		}
 
-	send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen;
-	data_size = xfer_seqlen - (send_fin ? 1 : 0);
+		data_size = xfer_seqlen - (send_fin ? 1 : 0);
 
-	if (send_fin) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.", conn->name);
-		/* We are sending out FIN */
-		ctrl = CTL_FIN;
-	} else {
-		ctrl = 0;
-	}
+		if (send_fin) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.",
+			    conn->name);
+			/* We are sending out FIN */
+			ctrl = CTL_FIN;
+		} else {
+			ctrl = 0;
+		}
 
-	seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
-	if (seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
-		return;
-	}
+		seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
+		if (seg == NULL) {
+			log_msg(LOG_DEFAULT, LVL_ERROR,
+			    "Memory allocation failure.");
+			return;
+		}
 
-	/* Remove data from send buffer */
-	memmove(conn->snd_buf, conn->snd_buf + data_size,
-	    conn->snd_buf_used - data_size);
-	conn->snd_buf_used -= data_size;
+		/* Remove data from send buffer */
+		memmove(conn->snd_buf, conn->snd_buf + data_size,
+		    conn->snd_buf_used - data_size);
+		conn->snd_buf_used -= data_size;
 
-	if (send_fin)
-		conn->snd_buf_fin = false;
+		/* Push is complete once the buffer has been drained */
+		if (conn->snd_buf_used == 0)
+			conn->snd_push = false;
 
-	fibril_condvar_broadcast(&conn->snd_buf_cv);
+		if (send_fin)
+			conn->snd_buf_fin = false;
 
-	if (send_fin)
-		tcp_conn_fin_sent(conn);
+		fibril_condvar_broadcast(&conn->snd_buf_cv);
 
-	tcp_tqueue_seg(conn, seg);
-	tcp_segment_delete(seg);
+		if (send_fin)
+			tcp_conn_fin_sent(conn);
+
+		tcp_tqueue_seg(conn, seg);
+		tcp_segment_delete(seg);
+	}
+}
+
+/** Update RTT estimates and retransmission timeout (RFC 6298 2.2, 2.3).
+ *
+ * @param conn   Connection
+ * @param sample RTT sample in microseconds
+ */
+static void tcp_tqueue_rtt_sample(tcp_conn_t *conn, usec_t sample)
+{
+	usec_t err;
+
+	if (conn->srtt == 0) {
+		conn->srtt = max(sample, 1);
+		conn->rttvar = sample / 2;
+	} else {
+		err = conn->srtt > sample ? conn->srtt - sample :
+		    sample - conn->srtt;
+		conn->rttvar = (3 * conn->rttvar + err) / 4;
+		conn->srtt = max((7 * conn->srtt + sample) / 8, 1);
+	}
+
+	conn->rto = conn->srtt + max(TCP_CLOCK_G, 4 * conn->rttvar);
+	conn->rto = min(max(conn->rto, TCP_RTO_MIN), TCP_RTO_MAX);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "%s: SRTT=%lld RTTVAR=%lld RTO=%lld",
+	    conn->name, conn->srtt, conn->rttvar, conn->rto);
 }
 
 /** Remove ACKed segments from retransmission queue and possibly transmit
@@ -245,10 +331,21 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 void tcp_tqueue_ack_received(tcp_conn_t *conn)
 {
 	link_t *cur, *next;
+	struct timespec now;
+	size_t acked;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_ack_received(%p)", conn->name,
 	    conn);
 
+	if (conn->rtt_timing && seq_no_ge(conn->snd_una, conn->rtt_seq)) {
+		getuptime(&now);
+		tcp_tqueue_rtt_sample(conn,
+		    NSEC2USEC(ts_sub_diff(&now, &conn->rtt_start)));
+		conn->rtt_timing = false;
+	}
+
+	acked = 0;
+
 	cur = conn->retransmit.list.head.next;
 
 	while (cur != &conn->retransmit.list.head) {
@@ -270,6 +367,7 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 				conn->fin_is_acked = true;
 			}
 
+			acked += tqe->seg->len;
 			tcp_segment_delete(tqe->seg);
 			free(tqe);
 
@@ -284,6 +382,11 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 	if (list_empty(&conn->retransmit.list))
 		tcp_tqueue_timer_clear(conn);
 
+	if (acked > 0) {
+		tcp_cc_ack(conn, acked);
+		tcp_conn_snd_buf_acked(conn, acked);
+	}
+
 	/* Possibly transmit more data */
 	tcp_tqueue_new_data(conn);
 }
@@ -293,12 +396,43 @@ static void tcp_conn_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_conn_transmit_segment(%p, %p)",
 	    conn->name, conn, seg);
 
-	seg->wnd = conn->rcv_wnd;
+	if ((seg->ctrl & CTL_SYN) != 0) {
+		/* Window field of SYN segments is never scaled (RFC 7323) */
+		seg->wnd = min(conn->rcv_wnd, TCP_WND_FIELD_MAX);
+
+		/* Offer window scaling and SACK, or confirm peer's offer */
+		seg->has_wscale = !tcp_conn_got_syn(conn) || conn->wscale_ok;
+		seg->wscale = conn->rcv_wscale;
+		seg->sack_perm = !tcp_conn_got_syn(conn) || conn->sack_ok;
+		seg->sack_cnt = 0;
+	} else {
+		seg->wnd = min(conn->rcv_wnd >> conn->rcv_wscale,
+		    TCP_WND_FIELD_MAX);
+		seg->sack_perm = false;
+
+		/* Report out-of-order data we hold */
+		if (conn->sack_ok && (seg->ctrl & CTL_ACK) != 0) {
+			seg->sack_cnt = tcp_iqueue_sack_blocks(&conn->incoming,
+			    seg->sack, TCP_SACK_BLOCKS_MAX);
+		} else {
+			seg->sack_cnt = 0;
+		}
+	}
 
-	if ((seg->ctrl & CTL_ACK) != 0)
+	if ((seg->ctrl & CTL_ACK) != 0) {
 		seg->ack = conn->rcv_nxt;
-	else
+
+		/* Any ACK we send covers the delayed one */
+		tcp_tqueue_dack_clear(conn);
+	} else {
 		seg->ack = 0;
+	}
+
+	/* Remember right window edge for receiver SWS avoidance */
+	if ((seg->ctrl & CTL_SYN) != 0)
+		conn->rcv_adv = conn->rcv_nxt + seg->wnd;
+	else
+		conn->rcv_adv = conn->rcv_nxt + (seg->wnd << conn->rcv_wscale);
 
 	tcp_tqueue_send_immed(conn, seg);
 }
@@ -314,16 +448,214 @@ void tcp_tqueue_send_immed(tcp_conn_t *conn, tcp_segment_t *seg)
 
 	tcp_segment_dump(seg);
 
+	++conn->stats.seg_sent;
+	conn->stats.bytes_sent += tcp_segment_text_size(seg);
+	if (seg->ctrl == CTL_ACK && seg->len == 0)
+		++conn->stats.ack_sent;
+
 	conn->retransmit.cb->transmit_seg(&conn->ident, seg);
 }
 
-static void retransmit_timeout_func(void *arg)
+/** Acknowledge received data, possibly delaying the ACK.
+ *
+ * Following RFC 1122 4.2.3.2 the ACK is held back for a while so that
+ * it can be piggybacked on data or a window update, or combined with
+ * the ACK of the next segment. At least every second segment is
+ * acknowledged right away.
+ *
+ * @param conn Connection
+ */
+void tcp_tqueue_ack_delayed(tcp_conn_t *conn)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (conn->dack_segs + 1 >= TCP_DACK_SEGS) {
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+		return;
+	}
+
+	if (conn->dack_segs == 0) {
+		tcp_conn_addref(conn);
+		fibril_timer_set_locked(conn->dack_timer, TCP_DACK_TIMEOUT,
+		    dack_timeout_func, (void *) conn);
+	}
+
+	++conn->dack_segs;
+	++conn->stats.ack_delayed;
+}
+
+/** Send window update if the receive window has opened enough.
+ *
+ * Receiver side silly window syndrome avoidance (RFC 1122 4.2.3.3):
+ * only advertise a larger window once the right edge has moved by
+ * at least one segment or half the buffer, whichever is smaller.
+ *
+ * @param conn Connection
+ */
+void tcp_tqueue_wnd_update(tcp_conn_t *conn)
+{
+	uint32_t thresh;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	thresh = min(conn->rcv_buf_size / 2, TCP_SMSS);
+	if (!seq_no_ge(conn->rcv_nxt + conn->rcv_wnd, conn->rcv_adv + thresh))
+		return;
+
+	tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+}
+
+/** Retransmit segment from the retransmission queue.
+ *
+ * @param conn Connection
+ * @param tqe  Retransmission queue entry
+ */
+static void tcp_tqueue_retransmit_tqe(tcp_conn_t *conn,
+    tcp_tqueue_entry_t *tqe)
 {
-	tcp_conn_t *conn = (tcp_conn_t *) arg;
-	tcp_tqueue_entry_t *tqe;
 	tcp_segment_t *rt_seg;
+
+	rt_seg = tcp_segment_dup(tqe->seg);
+	if (rt_seg == NULL) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
+		/* XXX Handle properly */
+		return;
+	}
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment "
+	    "SEG.SEQ=%" PRIu32, conn->name, tqe->seg->seq);
+
+	/* Karn's algorithm: do not time retransmitted segments */
+	conn->rtt_timing = false;
+	tqe->rexmitted = true;
+	++conn->stats.seg_rexmit;
+
+	tcp_conn_transmit_segment(tqe->conn, rt_seg);
+	tcp_segment_delete(rt_seg);
+}
+
+/** Retransmit the first segment in the retransmission queue.
+ *
+ * @param conn Connection
+ */
+void tcp_tqueue_retransmit(tcp_conn_t *conn)
+{
 	link_t *link;
 
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	link = list_first(&conn->retransmit.list);
+	if (link == NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Nothing to retransmit");
+		return;
+	}
+
+	tcp_tqueue_retransmit_tqe(conn,
+	    list_get_instance(link, tcp_tqueue_entry_t, link));
+}
+
+/** Retransmit the first segment not yet SACKed or retransmitted.
+ *
+ * Used on partial acknowledgement during loss recovery.
+ *
+ * @param conn Connection
+ */
+void tcp_tqueue_retransmit_next(tcp_conn_t *conn)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, tqe) {
+		if (!tqe->sacked && !tqe->rexmitted) {
+			tcp_tqueue_retransmit_tqe(conn, tqe);
+			return;
+		}
+	}
+}
+
+/** Retransmit the first hole in the SACK scoreboard.
+ *
+ * A hole is a segment that has not been SACKed nor retransmitted yet
+ * while some later segment has been SACKed, i.e. it is most likely lost.
+ *
+ * @param conn Connection
+ * @return @c true if a segment was retransmitted
+ */
+bool tcp_tqueue_retransmit_hole(tcp_conn_t *conn)
+{
+	tcp_tqueue_entry_t *hole = NULL;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, tqe) {
+		if (tqe->sacked) {
+			if (hole != NULL) {
+				tcp_tqueue_retransmit_tqe(conn, hole);
+				return true;
+			}
+		} else if (hole == NULL && !tqe->rexmitted) {
+			hole = tqe;
+		}
+	}
+
+	return false;
+}
+
+/** Process SACK blocks received from the peer.
+ *
+ * Mark segments fully covered by a block as SACKed so that they are
+ * skipped during loss recovery.
+ *
+ * @param conn   Connection
+ * @param blocks SACK blocks
+ * @param cnt    Number of blocks
+ */
+void tcp_tqueue_sack_received(tcp_conn_t *conn, tcp_sack_block_t *blocks,
+    size_t cnt)
+{
+	uint32_t seg_end;
+	size_t i;
+
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	for (i = 0; i < cnt; i++) {
+		/* Ignore blocks that do not lie within SND.UNA..SND.NXT */
+		if (!seq_no_ge(blocks[i].start, conn->snd_una) ||
+		    !seq_no_ge(conn->snd_nxt, blocks[i].end) ||
+		    !seq_no_ge(blocks[i].end, blocks[i].start + 1))
+			continue;
+
+		list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t,
+		    tqe) {
+			seg_end = tqe->seg->seq + tqe->seg->len;
+			if (seq_no_ge(tqe->seg->seq, blocks[i].start) &&
+			    seq_no_ge(blocks[i].end, seg_end))
+				tqe->sacked = true;
+		}
+	}
+}
+
+/** Start loss recovery.
+ *
+ * @param conn    Connection
+ * @param timeout Recovery is due to retransmission timeout. The SACK
+ *                scoreboard is discarded since the peer may have
+ *                dropped SACKed data (RFC 2018 8).
+ */
+void tcp_tqueue_recovery_start(tcp_conn_t *conn, bool timeout)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, tqe) {
+		tqe->rexmitted = false;
+		if (timeout)
+			tqe->sacked = false;
+	}
+}
+
+static void retransmit_timeout_func(void *arg)
+{
+	tcp_conn_t *conn = (tcp_conn_t *) arg;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmit_timeout_func(%p)", conn->name, conn);
 
 	tcp_conn_lock(conn);
@@ -335,30 +667,21 @@ static void retransmit_timeout_func(void *arg)
 		return;
 	}
 
-	link = list_first(&conn->retransmit.list);
-	if (link == NULL) {
+	if (list_empty(&conn->retransmit.list)) {
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "Nothing to retransmit");
 		tcp_conn_unlock(conn);
 		tcp_conn_delref(conn);
 		return;
 	}
 
-	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+	/* Back off the timer (RFC 6298 5.5) */
+	conn->rto = min(2 * conn->rto, TCP_RTO_MAX);
 
-	rt_seg = tcp_segment_dup(tqe->seg);
-	if (rt_seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
-		tcp_conn_unlock(conn);
-		tcp_conn_delref(conn);
-		/* XXX Handle properly */
-		return;
-	}
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment", conn->name);
-	tcp_conn_transmit_segment(tqe->conn, rt_seg);
+	tcp_cc_timeout(conn);
+	tcp_tqueue_retransmit(conn);
 
 	/* Reset retransmission timer */
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	tcp_conn_unlock(conn);
@@ -377,7 +700,7 @@ static void tcp_tqueue_timer_set(tcp_conn_t *conn)
 	tcp_tqueue_timer_clear(conn);
 
 	tcp_conn_addref(conn);
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: tcp_tqueue_timer_set() end", conn->name);
@@ -396,6 +719,45 @@ static void tcp_tqueue_timer_clear(tcp_conn_t *conn)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: tcp_tqueue_timer_clear() end", conn->name);
 }
 
+/** Delayed ACK timeout handler.
+ *
+ * @param arg Connection
+ */
+static void dack_timeout_func(void *arg)
+{
+	tcp_conn_t *conn = (tcp_conn_t *) arg;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: dack_timeout_func(%p)",
+	    conn->name, conn);
+
+	tcp_conn_lock(conn);
+
+	/* Reset the count first so that sending does not clear the timer */
+	if (conn->cstate != st_closed && conn->dack_segs > 0) {
+		conn->dack_segs = 0;
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+	}
+
+	tcp_conn_unlock(conn);
+	tcp_conn_delref(conn);
+}
+
+/** Cancel pending delayed ACK.
+ *
+ * @param conn Connection
+ */
+static void tcp_tqueue_dack_clear(tcp_conn_t *conn)
+{
+	assert(fibril_mutex_is_locked(&conn->lock));
+
+	if (conn->dack_segs == 0)
+		return;
+
+	conn->dack_segs = 0;
+	if (fibril_timer_clear_locked(conn->dack_timer) == fts_active)
+		tcp_conn_delref(conn);
+}
+
 /**
  * @}
  */
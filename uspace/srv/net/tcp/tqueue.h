@@ -39,6 +39,9 @@
 #include "std.h"
 #include "tcp_type.h"
 
+/** Sender maximum segment size (data bytes carried by one segment) */
+#define TCP_SMSS	4096
+
 extern errno_t tcp_tqueue_init(tcp_tqueue_t *, tcp_conn_t *,
     tcp_tqueue_cb_t *);
 extern void tcp_tqueue_clear(tcp_tqueue_t *);
@@ -46,6 +49,14 @@ extern void tcp_tqueue_fini(tcp_tqueue_t *);
 extern void tcp_tqueue_ctrl_seg(tcp_conn_t *, tcp_control_t);
 extern void tcp_tqueue_new_data(tcp_conn_t *);
 extern void tcp_tqueue_ack_received(tcp_conn_t *);
+extern void tcp_tqueue_ack_delayed(tcp_conn_t *);
+extern void tcp_tqueue_wnd_update(tcp_conn_t *);
+extern void tcp_tqueue_retransmit(tcp_conn_t *);
+extern void tcp_tqueue_retransmit_next(tcp_conn_t *);
+extern bool tcp_tqueue_retransmit_hole(tcp_conn_t *);
+extern void tcp_tqueue_sack_received(tcp_conn_t *, tcp_sack_block_t *,
+    size_t);
+extern void tcp_tqueue_recovery_start(tcp_conn_t *, bool);
 
 #endif
 
@@ -226,11 +226,14 @@ tcp_error_t tcp_uc_receive(tcp_conn_t *conn, void *buf, size_t size,
 	conn->rcv_buf_used -= xfer_size;
 	conn->rcv_wnd += xfer_size;
 
+	/* Possibly grow receive buffer (and window) */
+	tcp_conn_rcv_buf_consumed(conn, xfer_size);
+
 	/* TODO */
 	*xflags = 0;
 
-	/* Send new size of receive window */
-	tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+	/* Send new size of receive window, if it opened enough */
+	tcp_tqueue_wnd_update(conn);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_uc_receive() - returning %zu bytes",
 	    conn->name, xfer_size);
@@ -267,6 +270,19 @@ tcp_error_t tcp_uc_close(tcp_conn_t *conn)
 		return TCP_ECLOSING;
 	}
 
+	/* Data still in the send ring precede FIN */
+	while (!tcp_conn_snd_ring_drain(conn) && !conn->reset) {
+		tcp_tqueue_new_data(conn);
+		fibril_condvar_wait(&conn->snd_buf_cv, &conn->lock);
+	}
+
+	if (conn->reset) {
+		tcp_conn_unlock(conn);
+		return TCP_ERESET;
+	}
+
+	tcp_conn_snd_ring_close(conn);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_uc_close - set snd_buf_fin");
 	conn->snd_buf_fin = true;
 	tcp_tqueue_new_data(conn);
@@ -313,6 +329,90 @@ void tcp_uc_set_cb(tcp_conn_t *conn, tcp_cb_t *cb, void *arg)
 	conn->cb_arg = arg;
 }
 
+/** Set buffer size ceilings user call.
+ *
+ * (Not in spec.) Limit how far auto-tuning may grow the connection buffers.
+ *
+ * @param conn		Connection
+ * @param rcv_max	Receive buffer ceiling in bytes or 0 to keep current
+ * @param snd_max	Send buffer ceiling in bytes or 0 to keep current
+ */
+void tcp_uc_set_buf_max(tcp_conn_t *conn, size_t rcv_max, size_t snd_max)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_uc_set_buf_max(%zu, %zu)",
+	    conn->name, rcv_max, snd_max);
+
+	tcp_conn_lock(conn);
+	tcp_conn_set_buf_max(conn, rcv_max, snd_max);
+	tcp_conn_unlock(conn);
+}
+
+/** Push user call.
+ *
+ * Transmit buffered data without waiting for full-sized segments.
+ *
+ * @param conn		Connection
+ */
+void tcp_uc_push(tcp_conn_t *conn)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_uc_push()", conn->name);
+
+	tcp_conn_lock(conn);
+	(void) tcp_conn_snd_ring_drain(conn);
+	if (conn->snd_buf_used > 0) {
+		conn->snd_push = true;
+		tcp_tqueue_new_data(conn);
+	}
+	tcp_conn_unlock(conn);
+}
+
+/** Send ring user call.
+ *
+ * (Not in spec.) Set up the ring through which the user passes data
+ * for the send buffer or handle a doorbell on it. The call is always
+ * answered.
+ *
+ * @param conn		Connection
+ * @param call		Ring call
+ */
+void tcp_uc_send_ring(tcp_conn_t *conn, ipc_call_t *call)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_uc_send_ring()", conn->name);
+
+	tcp_conn_lock(conn);
+
+	(void) async_ring_handle(call, &conn->snd_ring);
+
+	/* Nobody would drain the ring of a connection closed for sending */
+	if (conn->cstate == st_closed || conn->snd_buf_fin) {
+		tcp_conn_snd_ring_close(conn);
+		tcp_conn_unlock(conn);
+		return;
+	}
+
+	tcp_tqueue_new_data(conn);
+	tcp_conn_unlock(conn);
+}
+
+/** Set no-delay user call.
+ *
+ * (Not in spec.) Enable or disable the Nagle algorithm.
+ *
+ * @param conn		Connection
+ * @param nodelay	@c true to send small segments without delay
+ */
+void tcp_uc_set_nodelay(tcp_conn_t *conn, bool nodelay)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_uc_set_nodelay(%d)",
+	    conn->name, (int) nodelay);
+
+	tcp_conn_lock(conn);
+	conn->nodelay = nodelay;
+	if (nodelay)
+		tcp_tqueue_new_data(conn);
+	tcp_conn_unlock(conn);
+}
+
 void *tcp_uc_get_userptr(tcp_conn_t *conn)
 {
 	return conn->cb_arg;
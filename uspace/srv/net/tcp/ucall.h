@@ -36,6 +36,7 @@
 #define UCALL_H
 
 #include <inet/endpoint.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include "tcp_type.h"
 
@@ -51,6 +52,10 @@ extern void tcp_uc_abort(tcp_conn_t *);
 extern void tcp_uc_status(tcp_conn_t *, tcp_conn_status_t *);
 extern void tcp_uc_delete(tcp_conn_t *);
 extern void tcp_uc_set_cb(tcp_conn_t *, tcp_cb_t *, void *);
+extern void tcp_uc_set_buf_max(tcp_conn_t *, size_t, size_t);
+extern void tcp_uc_push(tcp_conn_t *);
+extern void tcp_uc_set_nodelay(tcp_conn_t *, bool);
+extern void tcp_uc_send_ring(tcp_conn_t *, ipc_call_t *);
 extern void *tcp_uc_get_userptr(tcp_conn_t *);
 
 /*
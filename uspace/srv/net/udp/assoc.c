@@ -41,6 +41,7 @@
 #include <inet/endpoint.h>
 #include <inet/inet.h>
 #include <io/log.h>
+#include <mem.h>
 #include <nettl/amap.h>
 #include <stdlib.h>
 
@@ -51,11 +52,12 @@
 #include "udp_type.h"
 
 static LIST_INITIALIZE(assoc_list);
-static FIBRIL_MUTEX_INITIALIZE(assoc_list_lock);
+static FIBRIL_RWLOCK_INITIALIZE(assoc_list_lock);
 static amap_t *amap;
 
 static udp_assoc_t *udp_assoc_find_ref(inet_ep2_t *);
 static errno_t udp_assoc_queue_msg(udp_assoc_t *, inet_ep2_t *, udp_msg_t *);
+static errno_t udp_assoc_loop_back(inet_ep2_t *, udp_msg_t *);
 
 /** Initialize associations. */
 errno_t udp_assocs_init(void)
@@ -187,18 +189,18 @@ errno_t udp_assoc_add(udp_assoc_t *assoc)
 	errno_t rc;
 
 	udp_assoc_addref(assoc);
-	fibril_mutex_lock(&assoc_list_lock);
+	fibril_rwlock_write_lock(&assoc_list_lock);
 
 	rc = amap_insert(amap, &assoc->ident, assoc, af_allow_system, &aepp);
 	if (rc != EOK) {
 		udp_assoc_delref(assoc);
-		fibril_mutex_unlock(&assoc_list_lock);
+		fibril_rwlock_write_unlock(&assoc_list_lock);
 		return rc;
 	}
 
 	assoc->ident = aepp;
 	list_append(&assoc->link, &assoc_list);
-	fibril_mutex_unlock(&assoc_list_lock);
+	fibril_rwlock_write_unlock(&assoc_list_lock);
 
 	return EOK;
 }
@@ -209,10 +211,10 @@ errno_t udp_assoc_add(udp_assoc_t *assoc)
  */
 void udp_assoc_remove(udp_assoc_t *assoc)
 {
-	fibril_mutex_lock(&assoc_list_lock);
+	fibril_rwlock_write_lock(&assoc_list_lock);
 	amap_remove(amap, &assoc->ident);
 	list_remove(&assoc->link);
-	fibril_mutex_unlock(&assoc_list_lock);
+	fibril_rwlock_write_unlock(&assoc_list_lock);
 	udp_assoc_delref(assoc);
 }
 
@@ -279,6 +281,10 @@ errno_t udp_assoc_send(udp_assoc_t *assoc, inet_ep_t *remote, udp_msg_t *msg)
 	    epp.remote.addr.version != epp.local.addr.version)
 		return EINVAL;
 
+	if (inet_addr_is_loopback(&epp.remote.addr) &&
+	    !inet_addr_is_any(&epp.local.addr))
+		return udp_assoc_loop_back(&epp, msg);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_assoc_send - encode pdu");
 
 	rc = udp_pdu_encode(&epp, msg, &pdu);
@@ -297,6 +303,47 @@ errno_t udp_assoc_send(udp_assoc_t *assoc, inet_ep_t *remote, udp_msg_t *msg)
 	return EOK;
 }
 
+/** Deliver message sent to a loopback address.
+ *
+ * Such message would only travel through the internet service and
+ * the loopback link to come back to us. Pass it to the receiving
+ * association directly instead, without encoding and checksumming it.
+ *
+ * @param epp Endpoint pair of the sending association
+ * @param msg Message (ownership retained by caller)
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+static errno_t udp_assoc_loop_back(inet_ep2_t *epp, udp_msg_t *msg)
+{
+	udp_msg_t *dmsg;
+	inet_ep2_t rident;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_assoc_loop_back(%p, %p)",
+	    epp, msg);
+
+	dmsg = udp_msg_new();
+	if (dmsg == NULL)
+		return ENOMEM;
+
+	dmsg->data_size = msg->data_size;
+	dmsg->data = malloc(msg->data_size);
+	if (dmsg->data == NULL && msg->data_size > 0) {
+		udp_msg_delete(dmsg);
+		return ENOMEM;
+	}
+
+	memcpy(dmsg->data, msg->data, msg->data_size);
+
+	/* Reverse the identification */
+	rident.local_link = epp->local_link;
+	rident.local = epp->remote;
+	rident.remote = epp->local;
+
+	udp_assoc_received(&rident, dmsg);
+	return EOK;
+}
+
 /** Get a received message.
  *
  * Pull one message from the association's receive queue.
@@ -420,19 +467,19 @@ static udp_assoc_t *udp_assoc_find_ref(inet_ep2_t *epp)
 	udp_assoc_t *assoc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_assoc_find_ref(%p)", epp);
-	fibril_mutex_lock(&assoc_list_lock);
+	fibril_rwlock_read_lock(&assoc_list_lock);
 
 	rc = amap_find_match(amap, epp, &arg);
 	if (rc != EOK) {
 		assert(rc == ENOENT);
-		fibril_mutex_unlock(&assoc_list_lock);
+		fibril_rwlock_read_unlock(&assoc_list_lock);
 		return NULL;
 	}
 
 	assoc = (udp_assoc_t *)arg;
 	udp_assoc_addref(assoc);
 
-	fibril_mutex_unlock(&assoc_list_lock);
+	fibril_rwlock_read_unlock(&assoc_list_lock);
 	return assoc;
 }
 
@@ -34,6 +34,7 @@
  * @file HelenOS service implementation
  */
 
+#include <assert.h>
 #include <async.h>
 #include <errno.h>
 #include <inet/endpoint.h>
@@ -42,6 +43,7 @@
 #include <ipc/udp.h>
 #include <loc.h>
 #include <macros.h>
+#include <mem.h>
 #include <stdlib.h>
 
 #include "assoc.h"
@@ -61,35 +63,55 @@ static udp_assoc_cb_t udp_cassoc_cb = {
 	.recv_msg = udp_cassoc_recv_msg
 };
 
-/** Add message to client receive queue.
+/** Add message to client association receive ring.
+ *
+ * The message is dropped if the ring is full so that the receive path
+ * never has to wait for the client.
  *
  * @param cassoc Client association
  * @param epp    Endpoint pair on which message was received
  * @param msg    Message
  *
- * @return EOK on success, ENOMEM if out of memory
+ * @return EOK on success, ELIMIT if the ring is full
  */
 static errno_t udp_cassoc_queue_msg(udp_cassoc_t *cassoc, inet_ep2_t *epp,
     udp_msg_t *msg)
 {
-	udp_crcv_queue_entry_t *rqe;
+	udp_crcv_slot_t *slot;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_cassoc_queue_msg(%p, %p, %p)",
 	    cassoc, epp, msg);
 
-	rqe = calloc(1, sizeof(udp_crcv_queue_entry_t));
-	if (rqe == NULL)
-		return ENOMEM;
+	if (cassoc->rring_count >= UDP_CRCV_RING_SIZE) {
+		++cassoc->rring_dropped;
+		return ELIMIT;
+	}
 
-	link_initialize(&rqe->link);
-	rqe->epp = *epp;
-	rqe->msg = msg;
-	rqe->cassoc = cassoc;
+	slot = &cassoc->rring[(cassoc->rring_first + cassoc->rring_count) %
+	    UDP_CRCV_RING_SIZE];
+	slot->epp = *epp;
+	slot->msg = msg;
 
-	list_append(&rqe->link, &cassoc->client->crcv_queue);
+	if (cassoc->rring_count++ == 0)
+		list_append(&cassoc->lcrcv, &cassoc->client->crcv_queue);
 	return EOK;
 }
 
+/** Remove oldest message from client association receive ring.
+ *
+ * @param cassoc Client association
+ */
+static void udp_cassoc_dequeue_msg(udp_cassoc_t *cassoc)
+{
+	assert(cassoc->rring_count > 0);
+
+	udp_msg_delete(cassoc->rring[cassoc->rring_first].msg);
+	cassoc->rring_first = (cassoc->rring_first + 1) % UDP_CRCV_RING_SIZE;
+
+	if (--cassoc->rring_count == 0)
+		list_remove(&cassoc->lcrcv);
+}
+
 /** Send 'data' event to client.
  *
  * @param client Client
@@ -137,6 +159,7 @@ static errno_t udp_cassoc_create(udp_client_t *client, udp_assoc_t *assoc,
 	cassoc->id = id;
 	cassoc->client = client;
 	cassoc->assoc = assoc;
+	link_initialize(&cassoc->lcrcv);
 
 	list_append(&cassoc->lclient, &client->cassoc);
 	*rcassoc = cassoc;
@@ -149,6 +172,14 @@ static errno_t udp_cassoc_create(udp_client_t *client, udp_assoc_t *assoc,
  */
 static void udp_cassoc_destroy(udp_cassoc_t *cassoc)
 {
+	while (cassoc->rring_count > 0)
+		udp_cassoc_dequeue_msg(cassoc);
+
+	if (cassoc->rring_dropped > 0) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_cassoc_destroy: "
+		    "%zu messages dropped", cassoc->rring_dropped);
+	}
+
 	list_remove(&cassoc->lclient);
 	free(cassoc);
 }
@@ -186,9 +217,25 @@ static errno_t udp_cassoc_get(udp_client_t *client, sysarg_t id,
 static void udp_cassoc_recv_msg(void *arg, inet_ep2_t *epp, udp_msg_t *msg)
 {
 	udp_cassoc_t *cassoc = (udp_cassoc_t *) arg;
+	bool idle;
+	errno_t rc;
+
+	idle = list_empty(&cassoc->client->crcv_queue);
+
+	rc = udp_cassoc_queue_msg(cassoc, epp, msg);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Receive ring full. "
+		    "Message dropped.");
+		udp_msg_delete(msg);
+		return;
+	}
 
-	udp_cassoc_queue_msg(cassoc, epp, msg);
-	udp_ev_data(cassoc->client);
+	/*
+	 * The client fetches messages until the queue is empty, so it only
+	 * needs to be notified when the first message arrives.
+	 */
+	if (idle)
+		udp_ev_data(cassoc->client);
 }
 
 /** Create association.
@@ -510,12 +557,83 @@ static void udp_assoc_send_msg_srv(udp_client_t *client, ipc_call_t *icall)
 	free(data);
 }
 
-/** Get next received message.
+/** Send batch of messages via association.
+ *
+ * Handle client request to send messages packed in one buffer. Sending
+ * stops at the first message that fails. The number of messages sent
+ * is returned in the first answer argument.
+ *
+ * @param client UDP client
+ * @param icall  Async request data
+ *
+ */
+static void udp_assoc_send_batch_srv(udp_client_t *client, ipc_call_t *icall)
+{
+	udp_send_hdr_t hdr;
+	udp_cassoc_t *cassoc;
+	udp_msg_t msg;
+	inet_ep_t *dest;
+	sysarg_t assoc_id;
+	uint8_t *data;
+	size_t count;
+	size_t size;
+	size_t off;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_assoc_send_batch_srv()");
+
+	rc = async_data_write_accept((void **) &data, false, 0,
+	    DATA_XFER_LIMIT, 0, &size);
+	if (rc != EOK) {
+		async_answer_1(icall, rc, 0);
+		return;
+	}
+
+	assoc_id = ipc_get_arg1(icall);
+	rc = udp_cassoc_get(client, assoc_id, &cassoc);
+	if (rc != EOK) {
+		free(data);
+		async_answer_1(icall, rc, 0);
+		return;
+	}
+
+	count = 0;
+	off = 0;
+	while (size - off >= sizeof(hdr)) {
+		memcpy(&hdr, data + off, sizeof(hdr));
+		off += sizeof(hdr);
+
+		if (hdr.size > size - off) {
+			rc = EINVAL;
+			break;
+		}
+
+		dest = &hdr.dest;
+		if (inet_addr_is_any(&hdr.dest.addr) &&
+		    hdr.dest.port == inet_port_any)
+			dest = NULL;
+
+		msg.data = data + off;
+		msg.data_size = hdr.size;
+		rc = udp_assoc_send(cassoc->assoc, dest, &msg);
+		if (rc != EOK)
+			break;
+
+		off += hdr.size;
+		++count;
+	}
+
+	free(data);
+	async_answer_1(icall, rc, count);
+}
+
+/** Get client association with the next received message.
  *
  * @param client UDP Client
- * @return Pointer to queue entry for next received message
+ * @return Client association whose receive ring holds the next received
+ *         message or @c NULL if there is none
  */
-static udp_crcv_queue_entry_t *udp_rmsg_get_next(udp_client_t *client)
+static udp_cassoc_t *udp_rmsg_get_next(udp_client_t *client)
 {
 	link_t *link;
 
@@ -523,7 +641,7 @@ static udp_crcv_queue_entry_t *udp_rmsg_get_next(udp_client_t *client)
 	if (link == NULL)
 		return NULL;
 
-	return list_get_instance(link, udp_crcv_queue_entry_t, link);
+	return list_get_instance(link, udp_cassoc_t, lcrcv);
 }
 
 /** Get info on first received message.
@@ -538,12 +656,13 @@ static void udp_rmsg_info_srv(udp_client_t *client, ipc_call_t *icall)
 {
 	ipc_call_t call;
 	size_t size;
-	udp_crcv_queue_entry_t *enext;
+	udp_cassoc_t *cnext;
+	udp_crcv_slot_t *enext;
 	sysarg_t assoc_id;
 	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_info_srv()");
-	enext = udp_rmsg_get_next(client);
+	cnext = udp_rmsg_get_next(client);
 
 	if (!async_data_read_receive(&call, &size)) {
 		async_answer_0(&call, EREFUSED);
@@ -551,12 +670,13 @@ static void udp_rmsg_info_srv(udp_client_t *client, ipc_call_t *icall)
 		return;
 	}
 
-	if (enext == NULL) {
+	if (cnext == NULL) {
 		async_answer_0(&call, ENOENT);
 		async_answer_0(icall, ENOENT);
 		return;
 	}
 
+	enext = &cnext->rring[cnext->rring_first];
 	rc = async_data_read_finalize(&call, &enext->epp.remote,
 	    max(size, (size_t)sizeof(inet_ep_t)));
 	if (rc != EOK) {
@@ -564,7 +684,7 @@ static void udp_rmsg_info_srv(udp_client_t *client, ipc_call_t *icall)
 		return;
 	}
 
-	assoc_id = enext->cassoc->id;
+	assoc_id = cnext->id;
 	size = enext->msg->data_size;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_info_srv(): assoc_id=%zu, "
@@ -584,7 +704,8 @@ static void udp_rmsg_read_srv(udp_client_t *client, ipc_call_t *icall)
 {
 	ipc_call_t call;
 	size_t msg_size;
-	udp_crcv_queue_entry_t *enext;
+	udp_cassoc_t *cnext;
+	udp_crcv_slot_t *enext;
 	void *data;
 	size_t size;
 	size_t off;
@@ -593,7 +714,7 @@ static void udp_rmsg_read_srv(udp_client_t *client, ipc_call_t *icall)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_read_srv()");
 	off = ipc_get_arg1(icall);
 
-	enext = udp_rmsg_get_next(client);
+	cnext = udp_rmsg_get_next(client);
 
 	if (!async_data_read_receive(&call, &size)) {
 		async_answer_0(&call, EREFUSED);
@@ -601,12 +722,13 @@ static void udp_rmsg_read_srv(udp_client_t *client, ipc_call_t *icall)
 		return;
 	}
 
-	if (enext == NULL) {
+	if (cnext == NULL) {
 		async_answer_0(&call, ENOENT);
 		async_answer_0(icall, ENOENT);
 		return;
 	}
 
+	enext = &cnext->rring[cnext->rring_first];
 	data = enext->msg->data + off;
 	msg_size = enext->msg->data_size;
 
@@ -637,23 +759,113 @@ static void udp_rmsg_read_srv(udp_client_t *client, ipc_call_t *icall)
  */
 static void udp_rmsg_discard_srv(udp_client_t *client, ipc_call_t *icall)
 {
-	udp_crcv_queue_entry_t *enext;
+	udp_cassoc_t *cnext;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_discard_srv()");
 
-	enext = udp_rmsg_get_next(client);
-	if (enext == NULL) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "usg_rmsg_discard_srv: enext==NULL");
+	cnext = udp_rmsg_get_next(client);
+	if (cnext == NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_discard_srv: "
+		    "cnext==NULL");
 		async_answer_0(icall, ENOENT);
 		return;
 	}
 
-	list_remove(&enext->link);
-	udp_msg_delete(enext->msg);
-	free(enext);
+	udp_cassoc_dequeue_msg(cnext);
 	async_answer_0(icall, EOK);
 }
 
+/** Read batch of received messages.
+ *
+ * Handle client request to read as many received messages as fit into
+ * the client buffer. The messages are packed, each preceded by
+ * a udp_recv_hdr_t, and removed from the receive queue. The number
+ * of messages and the size of the batch are returned in the answer.
+ *
+ * @param client UDP client
+ * @param icall  Async request data
+ *
+ */
+static void udp_rmsg_read_batch_srv(udp_client_t *client, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	udp_recv_hdr_t hdr;
+	udp_crcv_slot_t *slot;
+	uint8_t *buf;
+	size_t count;
+	size_t size;
+	size_t off;
+	size_t i;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_read_batch_srv()");
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EREFUSED);
+		async_answer_0(icall, EREFUSED);
+		return;
+	}
+
+	if (list_empty(&client->crcv_queue)) {
+		async_answer_0(&call, ENOENT);
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	size = min(size, (size_t) DATA_XFER_LIMIT);
+	buf = malloc(size);
+	if (buf == NULL) {
+		async_answer_0(&call, ENOMEM);
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	/* Pack messages in the order they would be dequeued */
+	count = 0;
+	off = 0;
+	list_foreach(client->crcv_queue, lcrcv, udp_cassoc_t, cassoc) {
+		for (i = 0; i < cassoc->rring_count; i++) {
+			slot = &cassoc->rring[(cassoc->rring_first + i) %
+			    UDP_CRCV_RING_SIZE];
+			if (sizeof(hdr) + slot->msg->data_size > size - off)
+				goto packed;
+
+			hdr.assoc_id = cassoc->id;
+			hdr.remote_ep = slot->epp.remote;
+			hdr.size = slot->msg->data_size;
+
+			memcpy(buf + off, &hdr, sizeof(hdr));
+			memcpy(buf + off + sizeof(hdr), slot->msg->data,
+			    slot->msg->data_size);
+			off += sizeof(hdr) + slot->msg->data_size;
+			++count;
+		}
+	}
+
+packed:
+	if (count == 0) {
+		/* Client needs to read the message piece-wise */
+		free(buf);
+		async_answer_0(&call, EOVERFLOW);
+		async_answer_0(icall, EOVERFLOW);
+		return;
+	}
+
+	rc = async_data_read_finalize(&call, buf, off);
+	free(buf);
+	if (rc != EOK) {
+		async_answer_0(icall, rc);
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+		udp_cassoc_dequeue_msg(udp_rmsg_get_next(client));
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "udp_rmsg_read_batch_srv(): "
+	    "count=%zu, size=%zu", count, off);
+	async_answer_2(icall, EOK, count, off);
+}
+
 /** Handle UDP client connection.
  *
  * @param icall Connect call data
@@ -704,6 +916,9 @@ static void udp_client_conn(ipc_call_t *icall, void *arg)
 		case UDP_ASSOC_SEND_MSG:
 			udp_assoc_send_msg_srv(&client, &call);
 			break;
+		case UDP_ASSOC_SEND_BATCH:
+			udp_assoc_send_batch_srv(&client, &call);
+			break;
 		case UDP_RMSG_INFO:
 			udp_rmsg_info_srv(&client, &call);
 			break;
@@ -713,6 +928,9 @@ static void udp_client_conn(ipc_call_t *icall, void *arg)
 		case UDP_RMSG_DISCARD:
 			udp_rmsg_discard_srv(&client, &call);
 			break;
+		case UDP_RMSG_READ_BATCH:
+			udp_rmsg_read_batch_srv(&client, &call);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
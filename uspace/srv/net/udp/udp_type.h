@@ -47,6 +47,9 @@
 
 #define UDP_FRAGMENT_SIZE 65535
 
+/** Number of messages the receive ring of a client association can hold */
+#define UDP_CRCV_RING_SIZE 128
+
 /** UDP error codes */
 typedef enum {
 	UDP_EOK,
@@ -140,6 +143,14 @@ typedef struct {
 	udp_msg_t *msg;
 } udp_rcv_queue_entry_t;
 
+/** UDP client receive ring slot */
+typedef struct {
+	/** Endpoint pair */
+	inet_ep2_t epp;
+	/** Message */
+	udp_msg_t *msg;
+} udp_crcv_slot_t;
+
 /** UDP client association.
  *
  * Ties a UDP association into the namespace of a client
@@ -152,20 +163,18 @@ typedef struct udp_cassoc {
 	/** Client */
 	struct udp_client *client;
 	link_t lclient;
+	/** Link to client receive queue while the receive ring is not empty */
+	link_t lcrcv;
+	/** Receive ring. When full, newly received messages are dropped */
+	udp_crcv_slot_t rring[UDP_CRCV_RING_SIZE];
+	/** Index of the oldest message in the receive ring */
+	size_t rring_first;
+	/** Number of messages in the receive ring */
+	size_t rring_count;
+	/** Number of messages dropped because the receive ring was full */
+	size_t rring_dropped;
 } udp_cassoc_t;
 
-/** UDP client receive queue entry */
-typedef struct {
-	/** Link to receive queue */
-	link_t link;
-	/** Endpoint pair */
-	inet_ep2_t epp;
-	/** Message */
-	udp_msg_t *msg;
-	/** Client association */
-	udp_cassoc_t *cassoc;
-} udp_crcv_queue_entry_t;
-
 /** UDP client */
 typedef struct udp_client {
 	/** Client callback session */
@@ -173,7 +182,7 @@ typedef struct udp_client {
 	/** Client assocations */
 	list_t cassoc; /* of udp_cassoc_t */
 	/** Client receive queue */
-	list_t crcv_queue;
+	list_t crcv_queue; /* of udp_cassoc_t */
 } udp_client_t;
 
 #endif
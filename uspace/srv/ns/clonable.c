@@ -50,15 +50,59 @@ typedef struct {
 	ipc_call_t call;
 } cs_req_t;
 
+/** Number of loaders kept ready for future connection requests. */
+#define CS_SPARES  2
+
+/** Loader which registered before being requested. */
+typedef struct {
+	link_t link;
+	async_sess_t *sess;
+} cs_spare_t;
+
 /** List of clonable-service connection requests. */
 static list_t cs_req;
+static size_t cs_req_count = 0;
+
+/** List of spare loaders. */
+static list_t cs_spare;
+static size_t cs_spare_count = 0;
+
+/** Number of loaders spawned which have not registered yet. */
+static size_t cs_spawned = 0;
 
 errno_t ns_clonable_init(void)
 {
 	list_initialize(&cs_req);
+	list_initialize(&cs_spare);
+	return EOK;
+}
+
+/** Spawn loaders for pending requests and to replenish the spares.
+ *
+ * @return EOK if enough loaders are available or being started.
+ */
+static errno_t ns_clonable_refill(void)
+{
+	while (cs_spare_count + cs_spawned < cs_req_count + CS_SPARES) {
+		errno_t rc = loader_spawn("loader");
+		if (rc != EOK)
+			return rc;
+
+		cs_spawned++;
+	}
+
 	return EOK;
 }
 
+/** Forward connection request to a loader. */
+static void ns_clonable_connect(async_sess_t *sess, ipc_call_t *call)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+	async_forward_1(call, exch, ipc_get_arg1(call), ipc_get_arg3(call),
+	    IPC_FF_NONE);
+	async_exchange_end(exch);
+}
+
 /** Return true if @a service is clonable. */
 bool ns_service_is_clonable(service_t service, iface_t iface)
 {
@@ -72,30 +116,51 @@ bool ns_service_is_clonable(service_t service, iface_t iface)
  */
 void ns_clonable_register(ipc_call_t *call)
 {
-	link_t *req_link = list_first(&cs_req);
-	if (req_link == NULL) {
-		/* There was no pending connection request. */
+	if (cs_spawned == 0) {
+		/* We have not spawned this server. */
 		printf("%s: Unexpected clonable server.\n", NAME);
 		async_answer_0(call, EBUSY);
 		return;
 	}
 
-	cs_req_t *csr = list_get_instance(req_link, cs_req_t, link);
-	list_remove(req_link);
+	cs_spawned--;
 
-	/* Currently we can only handle a single type of clonable service. */
-	assert(ns_service_is_clonable(csr->service, csr->iface));
+	cs_spare_t *spare = NULL;
+	if (list_empty(&cs_req)) {
+		/* Keep the server for a future connection request. */
+		spare = malloc(sizeof(cs_spare_t));
+		if (spare == NULL) {
+			async_answer_0(call, ENOMEM);
+			return;
+		}
+	}
 
 	async_answer_0(call, EOK);
 
 	async_sess_t *sess = async_callback_receive(EXCHANGE_SERIALIZE);
-	if (sess == NULL)
-		async_answer_0(call, EIO);
+	if (sess == NULL) {
+		free(spare);
+		(void) ns_clonable_refill();
+		return;
+	}
 
-	async_exch_t *exch = async_exchange_begin(sess);
-	async_forward_1(&csr->call, exch, csr->iface,
-	    ipc_get_arg3(&csr->call), IPC_FF_NONE);
-	async_exchange_end(exch);
+	if (spare != NULL) {
+		link_initialize(&spare->link);
+		spare->sess = sess;
+		list_append(&spare->link, &cs_spare);
+		cs_spare_count++;
+		return;
+	}
+
+	link_t *req_link = list_first(&cs_req);
+	cs_req_t *csr = list_get_instance(req_link, cs_req_t, link);
+	list_remove(req_link);
+	cs_req_count--;
+
+	/* Currently we can only handle a single type of clonable service. */
+	assert(ns_service_is_clonable(csr->service, csr->iface));
+
+	ns_clonable_connect(sess, &csr->call);
 
 	free(csr);
 	async_hangup(sess);
@@ -114,18 +179,27 @@ void ns_clonable_forward(service_t service, iface_t iface, ipc_call_t *call)
 {
 	assert(ns_service_is_clonable(service, iface));
 
-	cs_req_t *csr = malloc(sizeof(cs_req_t));
-	if (csr == NULL) {
-		async_answer_0(call, ENOMEM);
+	link_t *spare_link = list_first(&cs_spare);
+	if (spare_link != NULL) {
+		/* Use a loader which is already running. */
+		cs_spare_t *spare = list_get_instance(spare_link, cs_spare_t,
+		    link);
+		list_remove(spare_link);
+		cs_spare_count--;
+
+		ns_clonable_connect(spare->sess, call);
+
+		async_hangup(spare->sess);
+		free(spare);
+
+		/* Failing to start a spare only matters to later requests. */
+		(void) ns_clonable_refill();
 		return;
 	}
 
-	/* Spawn a loader. */
-	errno_t rc = loader_spawn("loader");
-
-	if (rc != EOK) {
-		free(csr);
-		async_answer_0(call, rc);
+	cs_req_t *csr = malloc(sizeof(cs_req_t));
+	if (csr == NULL) {
+		async_answer_0(call, ENOMEM);
 		return;
 	}
 
@@ -140,6 +214,16 @@ void ns_clonable_forward(service_t service, iface_t iface, ipc_call_t *call)
 	 * Thus we store the call in a queue.
 	 */
 	list_append(&csr->link, &cs_req);
+	cs_req_count++;
+
+	/* Spawn a loader. */
+	errno_t rc = ns_clonable_refill();
+	if ((rc != EOK) && (cs_spawned < cs_req_count)) {
+		list_remove(&csr->link);
+		cs_req_count--;
+		free(csr);
+		async_answer_0(call, rc);
+	}
 }
 
 /**
@@ -0,0 +1,451 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup pipe
+ * @{
+ */
+/**
+ * @file
+ * @brief Pipe service
+ *
+ * Each pipe is a bounded ring buffer exported as two services, one for
+ * the read end and one for the write end. Clients open the ends through
+ * locfs, which forwards file reads and writes to us. A read blocks until
+ * some data are available and returns zero bytes once all writers are gone.
+ * A write blocks until there is some free space and fails with EPIPE once
+ * all readers are gone.
+ *
+ * A pipe is kept alive while the client that created it is connected, so
+ * that its ends can be opened, and then as long as either end is open.
+ */
+
+#include <adt/list.h>
+#include <async.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <io/log.h>
+#include <ipc/pipe.h>
+#include <ipc/services.h>
+#include <ipc/vfs.h>
+#include <loc.h>
+#include <macros.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include <task.h>
+
+#define NAME  "pipe"
+
+/** Pipe buffer size.
+ *
+ * Keep it below DATA_XFER_LIMIT, a read of a full transfer chunk would make
+ * VFS issue the following reads in parallel and they could overtake each
+ * other.
+ */
+#define PIPE_BUF_SIZE  (32 * 1024)
+
+typedef struct {
+	/** Link to pipes */
+	link_t lpipes;
+	/** Link to pipes owned by the creating connection */
+	link_t lowned;
+	/** Service ID of the read end */
+	service_id_t rsid;
+	/** Service ID of the write end */
+	service_id_t wsid;
+	/** Number of connections to the read end */
+	unsigned readers;
+	/** Number of connections to the write end */
+	unsigned writers;
+	/** The creating client is still connected */
+	bool owned;
+	/** Signalled when data, space or the number of ends change */
+	fibril_condvar_t cv;
+	/** Position of the first buffered byte */
+	size_t rpos;
+	/** Number of buffered bytes */
+	size_t used;
+	/** Ring buffer */
+	uint8_t buf[PIPE_BUF_SIZE];
+} pipe_t;
+
+static FIBRIL_MUTEX_INITIALIZE(pipe_lock);
+static LIST_INITIALIZE(pipes);
+static service_id_t ctl_sid;
+static unsigned pipe_next_id;
+
+/** Find pipe by the service ID of one of its ends.
+ *
+ * @param sid Service ID
+ * @param rread Place to store @c true if @a sid is the read end
+ * @return Pipe or @c NULL if not found
+ */
+static pipe_t *pipe_find(service_id_t sid, bool *rread)
+{
+	assert(fibril_mutex_is_locked(&pipe_lock));
+
+	list_foreach(pipes, lpipes, pipe_t, pipe) {
+		if (pipe->rsid == sid || pipe->wsid == sid) {
+			*rread = (pipe->rsid == sid);
+			return pipe;
+		}
+	}
+
+	return NULL;
+}
+
+/** Destroy pipe if it can no longer be used.
+ *
+ * Called with pipe_lock held, releases it.
+ *
+ * @param pipe Pipe
+ */
+static void pipe_release(pipe_t *pipe)
+{
+	assert(fibril_mutex_is_locked(&pipe_lock));
+
+	if (pipe->readers > 0 || pipe->writers > 0 || pipe->owned) {
+		fibril_mutex_unlock(&pipe_lock);
+		return;
+	}
+
+	list_remove(&pipe->lpipes);
+	fibril_mutex_unlock(&pipe_lock);
+
+	(void) loc_service_unregister(pipe->rsid);
+	(void) loc_service_unregister(pipe->wsid);
+	free(pipe);
+}
+
+/** Create a pipe.
+ *
+ * @param owned List of pipes owned by the connection
+ * @param icall PIPE_CREATE call
+ */
+static void pipe_create_srv(list_t *owned, ipc_call_t *icall)
+{
+	char *name;
+	pipe_t *pipe;
+	unsigned id;
+	errno_t rc;
+
+	pipe = calloc(1, sizeof(pipe_t));
+	if (pipe == NULL) {
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	fibril_condvar_initialize(&pipe->cv);
+	pipe->owned = true;
+
+	fibril_mutex_lock(&pipe_lock);
+	id = pipe_next_id++;
+	fibril_mutex_unlock(&pipe_lock);
+
+	if (asprintf(&name, "pipes/%u-r", id) < 0) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	rc = loc_service_register(name, &pipe->rsid);
+	free(name);
+	if (rc != EOK)
+		goto error;
+
+	if (asprintf(&name, "pipes/%u-w", id) < 0) {
+		rc = ENOMEM;
+		goto error_r;
+	}
+
+	rc = loc_service_register(name, &pipe->wsid);
+	free(name);
+	if (rc != EOK)
+		goto error_r;
+
+	fibril_mutex_lock(&pipe_lock);
+	list_append(&pipe->lpipes, &pipes);
+	list_append(&pipe->lowned, owned);
+	fibril_mutex_unlock(&pipe_lock);
+
+	async_answer_2(icall, EOK, pipe->rsid, pipe->wsid);
+	return;
+error_r:
+	(void) loc_service_unregister(pipe->rsid);
+error:
+	log_msg(LOG_DEFAULT, LVL_ERROR, "Failed creating pipe: %s",
+	    str_error(rc));
+	free(pipe);
+	async_answer_0(icall, rc);
+}
+
+/** Handle connection to the control service.
+ *
+ * @param icall Connect call
+ */
+static void pipe_ctl_conn(ipc_call_t *icall)
+{
+	list_t owned;
+
+	list_initialize(&owned);
+	async_accept_0(icall);
+
+	while (true) {
+		ipc_call_t call;
+		async_get_call(&call);
+
+		if (!ipc_get_imethod(&call)) {
+			async_answer_0(&call, EOK);
+			break;
+		}
+
+		switch (ipc_get_imethod(&call)) {
+		case PIPE_CREATE:
+			pipe_create_srv(&owned, &call);
+			break;
+		default:
+			async_answer_0(&call, ENOENT);
+		}
+	}
+
+	/* Pipes created over this connection now live on their ends */
+	while (!list_empty(&owned)) {
+		fibril_mutex_lock(&pipe_lock);
+		pipe_t *pipe = list_get_instance(list_first(&owned), pipe_t,
+		    lowned);
+		list_remove(&pipe->lowned);
+		pipe->owned = false;
+		fibril_condvar_broadcast(&pipe->cv);
+		pipe_release(pipe);
+	}
+}
+
+/** Read from a pipe.
+ *
+ * @param pipe Pipe
+ * @param icall VFS_OUT_READ call
+ */
+static void pipe_read_srv(pipe_t *pipe, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	size_t n;
+	errno_t rc;
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	fibril_mutex_lock(&pipe_lock);
+
+	while (pipe->used == 0 && (pipe->writers > 0 || pipe->owned))
+		fibril_condvar_wait(&pipe->cv, &pipe_lock);
+
+	/* Zero bytes mean end of file */
+	n = min(size, min(pipe->used, PIPE_BUF_SIZE - pipe->rpos));
+	rc = async_data_read_finalize(&call, pipe->buf + pipe->rpos, n);
+	if (rc == EOK && n > 0) {
+		pipe->rpos = (pipe->rpos + n) % PIPE_BUF_SIZE;
+		pipe->used -= n;
+		fibril_condvar_broadcast(&pipe->cv);
+	}
+
+	fibril_mutex_unlock(&pipe_lock);
+
+	if (rc != EOK)
+		n = 0;
+	async_answer_1(icall, rc, n);
+}
+
+/** Write to a pipe.
+ *
+ * @param pipe Pipe
+ * @param icall VFS_OUT_WRITE call
+ */
+static void pipe_write_srv(pipe_t *pipe, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t wpos;
+	size_t size;
+	size_t n;
+	errno_t rc;
+
+	if (!async_data_write_receive(&call, &size)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	fibril_mutex_lock(&pipe_lock);
+
+	while (pipe->used == PIPE_BUF_SIZE && (pipe->readers > 0 ||
+	    pipe->owned))
+		fibril_condvar_wait(&pipe->cv, &pipe_lock);
+
+	if (pipe->readers == 0 && !pipe->owned) {
+		fibril_mutex_unlock(&pipe_lock);
+		async_answer_0(&call, EPIPE);
+		async_answer_0(icall, EPIPE);
+		return;
+	}
+
+	wpos = (pipe->rpos + pipe->used) % PIPE_BUF_SIZE;
+	n = min(size, min(PIPE_BUF_SIZE - pipe->used, PIPE_BUF_SIZE - wpos));
+	rc = async_data_write_finalize(&call, pipe->buf + wpos, n);
+	if (rc == EOK && n > 0) {
+		pipe->used += n;
+		fibril_condvar_broadcast(&pipe->cv);
+	}
+
+	fibril_mutex_unlock(&pipe_lock);
+
+	if (rc != EOK)
+		n = 0;
+	async_answer_1(icall, rc, n);
+}
+
+/** Handle connection to one end of a pipe.
+ *
+ * @param sid Service ID of the end
+ * @param icall Connect call
+ */
+static void pipe_end_conn(service_id_t sid, ipc_call_t *icall)
+{
+	pipe_t *pipe;
+	bool rend;
+
+	fibril_mutex_lock(&pipe_lock);
+
+	pipe = pipe_find(sid, &rend);
+	if (pipe == NULL) {
+		fibril_mutex_unlock(&pipe_lock);
+		async_answer_0(icall, ENOENT);
+		return;
+	}
+
+	if (rend)
+		pipe->readers++;
+	else
+		pipe->writers++;
+
+	fibril_mutex_unlock(&pipe_lock);
+
+	async_accept_0(icall);
+
+	while (true) {
+		ipc_call_t call;
+		async_get_call(&call);
+
+		if (!ipc_get_imethod(&call)) {
+			async_answer_0(&call, EOK);
+			break;
+		}
+
+		switch (ipc_get_imethod(&call)) {
+		case VFS_OUT_READ:
+			if (rend)
+				pipe_read_srv(pipe, &call);
+			else
+				async_answer_0(&call, EBADF);
+			break;
+		case VFS_OUT_WRITE:
+			if (!rend)
+				pipe_write_srv(pipe, &call);
+			else
+				async_answer_0(&call, EBADF);
+			break;
+		case VFS_OUT_SYNC:
+			async_answer_0(&call, EOK);
+			break;
+		default:
+			async_answer_0(&call, ENOTSUP);
+		}
+	}
+
+	fibril_mutex_lock(&pipe_lock);
+
+	if (rend)
+		pipe->readers--;
+	else
+		pipe->writers--;
+
+	fibril_condvar_broadcast(&pipe->cv);
+	pipe_release(pipe);
+}
+
+static void pipe_conn(ipc_call_t *icall, void *arg)
+{
+	service_id_t sid = ipc_get_arg2(icall);
+
+	if (sid == ctl_sid)
+		pipe_ctl_conn(icall);
+	else
+		pipe_end_conn(sid, icall);
+}
+
+int main(int argc, char *argv[])
+{
+	errno_t rc;
+
+	printf("%s: HelenOS pipe service\n", NAME);
+
+	rc = log_init(NAME);
+	if (rc != EOK) {
+		printf("%s: Failed initializing logging: %s\n", NAME,
+		    str_error(rc));
+		return rc;
+	}
+
+	async_set_fallback_port_handler(pipe_conn, NULL);
+
+	rc = loc_server_register(NAME);
+	if (rc != EOK) {
+		printf("%s: Failed registering server: %s\n", NAME,
+		    str_error(rc));
+		return rc;
+	}
+
+	rc = loc_service_register(SERVICE_NAME_PIPE, &ctl_sid);
+	if (rc != EOK) {
+		printf("%s: Failed registering service: %s\n", NAME,
+		    str_error(rc));
+		return rc;
+	}
+
+	printf("%s: Accepting connections\n", NAME);
+	task_retval(0);
+	async_manager();
+
+	/* Never reached */
+	return 0;
+}
+
+/** @}
+ */
@@ -39,7 +39,9 @@
 
 #include <as.h>
 #include <async.h>
+#include <async_ring.h>
 #include <errno.h>
+#include <fibril_synch.h>
 #include <str_error.h>
 #include <io/log.h>
 #include <ipc/ipc_test.h>
@@ -67,6 +69,13 @@ static const char *ro_data = "Hello, world!";
  */
 static char rw_data[] = "Hello, world!";
 
+/** Buffer for data transfers, its contents do not matter. */
+static uint8_t xfer_buf[DATA_XFER_LIMIT];
+
+/** Session to this service for forwarding calls. */
+static async_sess_t *self_sess = NULL;
+static FIBRIL_MUTEX_INITIALIZE(self_sess_lock);
+
 static void ipc_test_get_ro_area_size_srv(ipc_call_t *icall)
 {
 	errno_t rc;
@@ -181,8 +190,150 @@ static void ipc_test_share_in_rw_srv(ipc_call_t *icall)
 	async_answer_0(icall, EOK);
 }
 
+static void ipc_test_ring_srv(ipc_call_t *icall, async_ring_t **ring)
+{
+	char buf[4096];
+	size_t size;
+	errno_t rc;
+
+	rc = async_ring_handle(icall, ring);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "async_ring_handle failed");
+		return;
+	}
+
+	/* Drain the ring, messages are only counted by the client. */
+	do {
+		rc = async_ring_read(*ring, buf, sizeof(buf), &size);
+	} while (rc == EOK);
+
+	if (rc != ENOENT)
+		log_msg(LOG_DEFAULT, LVL_ERROR, "async_ring_read failed");
+}
+
+static void ipc_test_data_write_srv(ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	errno_t rc;
+
+	if (!async_data_write_receive(&call, &size)) {
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	if (size > sizeof(xfer_buf)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = async_data_write_finalize(&call, xfer_buf, size);
+	async_answer_0(icall, rc);
+}
+
+static void ipc_test_data_read_srv(ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	errno_t rc;
+
+	if (!async_data_read_receive(&call, &size)) {
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	if (size > sizeof(xfer_buf)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = async_data_read_finalize(&call, xfer_buf, size);
+	async_answer_0(icall, rc);
+}
+
+static void ipc_test_share_out_srv(ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+	void *dst;
+	errno_t rc;
+
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = async_share_out_finalize(&call, &dst);
+	if (rc != EOK || dst == AS_MAP_FAILED) {
+		log_msg(LOG_DEFAULT, LVL_ERROR,
+		    "async_share_out_finalize failed");
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	/* Only the cost of setting up the mapping is of interest */
+	as_area_destroy(dst);
+	async_answer_0(icall, EOK);
+}
+
+static void ipc_test_forward_srv(ipc_call_t *icall)
+{
+	fibril_mutex_lock(&self_sess_lock);
+	if (self_sess == NULL)
+		self_sess = loc_service_connect(svc_id, INTERFACE_IPC_TEST, 0);
+	fibril_mutex_unlock(&self_sess_lock);
+
+	if (self_sess == NULL) {
+		async_answer_0(icall, EIO);
+		return;
+	}
+
+	/* The ping is answered by the connection it is forwarded to */
+	async_exch_t *exch = async_exchange_begin(self_sess);
+	async_forward_0(icall, exch, IPC_TEST_PING, IPC_FF_NONE);
+	async_exchange_end(exch);
+}
+
+static void ipc_test_callback_create_srv(ipc_call_t *icall,
+    async_sess_t **cb_sess)
+{
+	async_sess_t *sess = async_callback_receive(EXCHANGE_SERIALIZE);
+	if (sess == NULL) {
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	if (*cb_sess != NULL)
+		async_hangup(*cb_sess);
+	*cb_sess = sess;
+	async_answer_0(icall, EOK);
+}
+
+static void ipc_test_notify_srv(ipc_call_t *icall, async_sess_t *cb_sess)
+{
+	sysarg_t count = ipc_get_arg1(icall);
+
+	if (cb_sess == NULL || count > IPC_TEST_NOTIFY_MAX) {
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	async_exch_t *exch = async_exchange_begin(cb_sess);
+	for (sysarg_t i = 0; i < count; i++)
+		async_msg_0(exch, IPC_TEST_EV_NOTIFY);
+	async_exchange_end(exch);
+
+	async_answer_0(icall, EOK);
+}
+
 static void ipc_test_connection(ipc_call_t *icall, void *arg)
 {
+	async_ring_t *ring = NULL;
+	async_sess_t *cb_sess = NULL;
+
 	/* Accept connection */
 	async_accept_0(icall);
 
@@ -191,6 +342,9 @@ static void ipc_test_connection(ipc_call_t *icall, void *arg)
 		async_get_call(&call);
 
 		if (!ipc_get_imethod(&call)) {
+			async_ring_destroy(ring);
+			if (cb_sess != NULL)
+				async_hangup(cb_sess);
 			async_answer_0(&call, EOK);
 			break;
 		}
@@ -211,6 +365,27 @@ static void ipc_test_connection(ipc_call_t *icall, void *arg)
 		case IPC_TEST_SHARE_IN_RW:
 			ipc_test_share_in_rw_srv(&call);
 			break;
+		case IPC_TEST_RING:
+			ipc_test_ring_srv(&call, &ring);
+			break;
+		case IPC_TEST_DATA_WRITE:
+			ipc_test_data_write_srv(&call);
+			break;
+		case IPC_TEST_DATA_READ:
+			ipc_test_data_read_srv(&call);
+			break;
+		case IPC_TEST_SHARE_OUT:
+			ipc_test_share_out_srv(&call);
+			break;
+		case IPC_TEST_FORWARD:
+			ipc_test_forward_srv(&call);
+			break;
+		case IPC_TEST_CALLBACK_CREATE:
+			ipc_test_callback_create_srv(&call, &cb_sess);
+			break;
+		case IPC_TEST_NOTIFY:
+			ipc_test_notify_srv(&call, cb_sess);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
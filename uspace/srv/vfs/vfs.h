@@ -89,6 +89,8 @@ typedef struct {
 	aoff64_t size;
 } vfs_lookup_res_t;
 
+typedef struct vfs_pcache vfs_pcache_t;
+
 /**
  * Instances of this type represent an active, in-memory VFS node and any state
  * which may be associated with it.
@@ -120,6 +122,9 @@ typedef struct _vfs_node {
 	fibril_rwlock_t contents_rwlock;
 
 	struct _vfs_node *mount;
+
+	/** Page cache if the node has been mapped. */
+	vfs_pcache_t *pcache;
 } vfs_node_t;
 
 /**
@@ -141,6 +146,15 @@ typedef struct {
 
 	/** Append on write. */
 	bool append;
+
+	/** The file has been used to page in a mapping. */
+	bool mapped;
+
+	/** Buffer shared by the client for reading the file, if any. */
+	void *buffer;
+	size_t buffer_size;
+	/** ID of the buffer at the FS server or 0 if not shared with it. */
+	sysarg_t buffer_id;
 } vfs_file_t;
 
 extern fibril_mutex_t nodes_mutex;
@@ -187,6 +201,16 @@ extern unsigned vfs_nodes_refcount_sum_get(fs_handle_t, service_id_t);
 
 extern bool vfs_node_has_children(vfs_node_t *node);
 
+extern bool vfs_dcache_init(void);
+extern bool vfs_dcache_enabled(vfs_node_t *);
+extern bool vfs_dcache_get(vfs_node_t *, const char *, size_t, vfs_node_t **);
+extern unsigned vfs_dcache_generation(void);
+extern void vfs_dcache_insert(vfs_node_t *, const char *, size_t, vfs_node_t *,
+    unsigned);
+extern void vfs_dcache_invalidate(vfs_triplet_t *, const char *);
+extern void vfs_dcache_purge(fs_handle_t, service_id_t);
+extern void vfs_dcache_set_enabled(fs_handle_t, service_id_t, bool);
+
 extern void *vfs_client_data_create(void);
 extern void vfs_client_data_destroy(void *);
 
@@ -195,6 +219,7 @@ extern errno_t vfs_wait_handle_internal(bool, int *);
 
 extern vfs_file_t *vfs_file_get(int);
 extern void vfs_file_put(vfs_file_t *);
+extern void vfs_file_buffer_release(vfs_file_t *);
 extern errno_t vfs_fd_assign(vfs_file_t *, int);
 extern errno_t vfs_fd_alloc(vfs_file_t **file, bool desc, int *);
 extern errno_t vfs_fd_free(int);
@@ -210,8 +235,12 @@ extern errno_t vfs_op_mtab_get(void);
 extern errno_t vfs_op_open(int fd, int flags);
 extern errno_t vfs_op_put(int fd);
 extern errno_t vfs_op_read(int fd, aoff64_t, size_t *out_bytes);
+extern errno_t vfs_op_read_buffer(int fd, aoff64_t, size_t, size_t,
+    size_t *out_bytes);
+extern errno_t vfs_op_readdir(int fd, aoff64_t, size_t *out_bytes);
 extern errno_t vfs_op_rename(int basefd, char *old, char *new);
 extern errno_t vfs_op_resize(int fd, int64_t size);
+extern errno_t vfs_op_share_buffer(int fd);
 extern errno_t vfs_op_stat(int fd);
 extern errno_t vfs_op_statfs(int fd);
 extern errno_t vfs_op_sync(int fd);
@@ -225,6 +254,15 @@ extern void vfs_register(ipc_call_t *);
 
 extern void vfs_page_in(ipc_call_t *);
 
+extern errno_t vfs_pcache_map(vfs_node_t *);
+extern void vfs_pcache_unmap(vfs_node_t *);
+extern errno_t vfs_pcache_get(vfs_node_t *, aoff64_t, size_t, bool, void **);
+extern errno_t vfs_pcache_read(vfs_node_t *, aoff64_t, void *, size_t);
+extern void vfs_pcache_update(vfs_node_t *, aoff64_t, size_t);
+extern void vfs_pcache_resize(vfs_node_t *, aoff64_t);
+extern errno_t vfs_pcache_sync(vfs_node_t *);
+extern void vfs_pcache_destroy(vfs_node_t *);
+
 typedef struct {
 	void *buffer;
 	size_t size;
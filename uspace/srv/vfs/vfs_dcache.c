@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file	vfs_dcache.c
+ * @brief	Cache of directory entries and negative lookups.
+ *
+ * Each entry maps a name in a directory to the node it refers to or records
+ * that the directory has no entry of that name. Positive entries hold a
+ * reference to their node, so that the type and size reported on a hit are
+ * maintained by VFS itself.
+ *
+ * Entries are dropped when the name is linked, created or unlinked, and all
+ * entries of a file system instance are dropped when it is unmounted. To
+ * keep a lookup racing with such a change from inserting a stale result,
+ * every invalidation bumps a generation number and an insertion is refused
+ * if the generation changed since the file system was asked.
+ */
+
+#include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <fibril_synch.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+
+/** Maximum number of cached entries. */
+#define DCACHE_MAX	1024
+
+/** Longer names are not cached. */
+#define DCACHE_NAME_MAX	255
+
+typedef struct {
+	ht_link_t dh_link;	/**< Dentry hash-table link. */
+	link_t lru_link;	/**< LRU list link. */
+
+	vfs_triplet_t parent;	/**< Directory containing the name. */
+	char *name;		/**< Name in the directory. */
+
+	/** Node the name refers to or NULL if there is no such name. */
+	vfs_node_t *node;
+} vfs_dentry_t;
+
+typedef struct {
+	const vfs_triplet_t *parent;
+	const char *name;
+	size_t len;
+} dentry_key_t;
+
+/** File system instance mounted with VFS_MOUNT_NO_DCACHE. */
+typedef struct {
+	link_t link;
+	vfs_pair_t pair;
+} dcache_off_t;
+
+/** Mutex protecting the dentry cache. */
+static FIBRIL_MUTEX_INITIALIZE(dcache_mutex);
+
+static hash_table_t dentries;
+static LIST_INITIALIZE(dcache_lru);
+static LIST_INITIALIZE(dcache_off);
+static unsigned dcache_generation;
+
+static size_t dentry_name_hash(const char *name, size_t len)
+{
+	size_t hash = 0;
+
+	for (size_t i = 0; i < len; i++)
+		hash = hash * 31 + (uint8_t) name[i];
+
+	return hash;
+}
+
+static size_t dentries_key_hash(const void *key)
+{
+	const dentry_key_t *dkey = key;
+	size_t hash = hash_combine(dkey->parent->fs_handle,
+	    dkey->parent->index);
+	hash = hash_combine(hash, dkey->parent->service_id);
+	return hash_combine(hash, dentry_name_hash(dkey->name, dkey->len));
+}
+
+static size_t dentries_hash(const ht_link_t *item)
+{
+	vfs_dentry_t *dentry = hash_table_get_inst(item, vfs_dentry_t,
+	    dh_link);
+	dentry_key_t key = {
+		.parent = &dentry->parent,
+		.name = dentry->name,
+		.len = str_size(dentry->name)
+	};
+
+	return dentries_key_hash(&key);
+}
+
+static bool dentries_key_equal(const void *key, const ht_link_t *item)
+{
+	const dentry_key_t *dkey = key;
+	vfs_dentry_t *dentry = hash_table_get_inst(item, vfs_dentry_t,
+	    dh_link);
+
+	return dentry->parent.fs_handle == dkey->parent->fs_handle &&
+	    dentry->parent.service_id == dkey->parent->service_id &&
+	    dentry->parent.index == dkey->parent->index &&
+	    str_size(dentry->name) == dkey->len &&
+	    memcmp(dentry->name, dkey->name, dkey->len) == 0;
+}
+
+static hash_table_ops_t dentries_ops = {
+	.hash = dentries_hash,
+	.key_hash = dentries_key_hash,
+	.key_equal = dentries_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL,
+};
+
+/** Initialize the dentry cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_dcache_init(void)
+{
+	return hash_table_create(&dentries, 0, 0, &dentries_ops);
+}
+
+/** Unlink a dentry from the cache and queue it for destruction. */
+static void dentry_remove(vfs_dentry_t *dentry, list_t *dead)
+{
+	hash_table_remove_item(&dentries, &dentry->dh_link);
+	list_remove(&dentry->lru_link);
+	list_append(&dentry->lru_link, dead);
+}
+
+/** Destroy dentries removed from the cache.
+ *
+ * Must be called without holding dcache_mutex, as putting a node may talk
+ * to its file system.
+ */
+static void dentries_destroy(list_t *dead)
+{
+	while (!list_empty(dead)) {
+		vfs_dentry_t *dentry = list_get_instance(list_first(dead),
+		    vfs_dentry_t, lru_link);
+		list_remove(&dentry->lru_link);
+		if (dentry->node != NULL)
+			vfs_node_put(dentry->node);
+		free(dentry->name);
+		free(dentry);
+	}
+}
+
+static bool dcache_off_find(fs_handle_t fs_handle, service_id_t service_id)
+{
+	list_foreach(dcache_off, link, dcache_off_t, off) {
+		if (off->pair.fs_handle == fs_handle &&
+		    off->pair.service_id == service_id)
+			return true;
+	}
+
+	return false;
+}
+
+/** Check whether lookups in a directory may use the dentry cache.
+ *
+ * @param dir		Directory node.
+ *
+ * @return		False if the file system instance of @a dir was
+ *			mounted with VFS_MOUNT_NO_DCACHE.
+ */
+bool vfs_dcache_enabled(vfs_node_t *dir)
+{
+	fibril_mutex_lock(&dcache_mutex);
+	bool enabled = list_empty(&dcache_off) ||
+	    !dcache_off_find(dir->fs_handle, dir->service_id);
+	fibril_mutex_unlock(&dcache_mutex);
+
+	return enabled;
+}
+
+/** Look up a name in the dentry cache.
+ *
+ * @param dir		Directory node.
+ * @param name		Name, not necessarily NULL-terminated.
+ * @param len		Length of @a name.
+ * @param node		Place to store the node the name refers to, with
+ *			its reference count incremented, or NULL if the
+ *			cache knows that there is no such name.
+ *
+ * @return		True if the cache knows the answer, false otherwise.
+ */
+bool vfs_dcache_get(vfs_node_t *dir, const char *name, size_t len,
+    vfs_node_t **node)
+{
+	dentry_key_t key = {
+		.parent = (vfs_triplet_t *) dir,
+		.name = name,
+		.len = len
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	ht_link_t *tmp = hash_table_find(&dentries, &key);
+	if (tmp == NULL) {
+		fibril_mutex_unlock(&dcache_mutex);
+		return false;
+	}
+
+	vfs_dentry_t *dentry = hash_table_get_inst(tmp, vfs_dentry_t, dh_link);
+	list_remove(&dentry->lru_link);
+	list_append(&dentry->lru_link, &dcache_lru);
+
+	*node = dentry->node;
+	if (*node != NULL)
+		vfs_node_addref(*node);
+
+	fibril_mutex_unlock(&dcache_mutex);
+	return true;
+}
+
+/** Get the current generation of the dentry cache.
+ *
+ * The generation must be read before asking the file system and passed to
+ * vfs_dcache_insert() together with the answer.
+ */
+unsigned vfs_dcache_generation(void)
+{
+	fibril_mutex_lock(&dcache_mutex);
+	unsigned generation = dcache_generation;
+	fibril_mutex_unlock(&dcache_mutex);
+
+	return generation;
+}
+
+/** Insert the result of looking up a name into the dentry cache.
+ *
+ * @param dir		Directory node.
+ * @param name		Name, not necessarily NULL-terminated.
+ * @param len		Length of @a name.
+ * @param node		Node the name refers to or NULL if there is no
+ *			such name. The cache takes its own reference.
+ * @param generation	Generation of the cache when the file system was
+ *			asked.
+ */
+void vfs_dcache_insert(vfs_node_t *dir, const char *name, size_t len,
+    vfs_node_t *node, unsigned generation)
+{
+	if (len > DCACHE_NAME_MAX)
+		return;
+
+	vfs_dentry_t *dentry = malloc(sizeof(vfs_dentry_t));
+	if (dentry == NULL)
+		return;
+
+	dentry->name = str_ndup(name, len);
+	if (dentry->name == NULL) {
+		free(dentry);
+		return;
+	}
+
+	dentry->parent = *((vfs_triplet_t *) dir);
+	dentry->node = node;
+	link_initialize(&dentry->lru_link);
+	if (node != NULL)
+		vfs_node_addref(node);
+
+	LIST_INITIALIZE(dead);
+	dentry_key_t key = {
+		.parent = &dentry->parent,
+		.name = name,
+		.len = len
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	if (generation != dcache_generation ||
+	    hash_table_find(&dentries, &key) != NULL) {
+		/* Stale or already cached by a concurrent lookup. */
+		list_append(&dentry->lru_link, &dead);
+	} else {
+		if (hash_table_size(&dentries) >= DCACHE_MAX) {
+			vfs_dentry_t *victim = list_get_instance(
+			    list_first(&dcache_lru), vfs_dentry_t, lru_link);
+			dentry_remove(victim, &dead);
+		}
+
+		hash_table_insert(&dentries, &dentry->dh_link);
+		list_append(&dentry->lru_link, &dcache_lru);
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+
+	dentries_destroy(&dead);
+}
+
+typedef struct {
+	vfs_triplet_t parent;
+	bool by_pair;
+	list_t *dead;
+} dcache_purge_arg_t;
+
+static bool dcache_purge_cb(ht_link_t *item, void *arg)
+{
+	dcache_purge_arg_t *purge = arg;
+	vfs_dentry_t *dentry = hash_table_get_inst(item, vfs_dentry_t,
+	    dh_link);
+
+	if (dentry->parent.fs_handle == purge->parent.fs_handle &&
+	    dentry->parent.service_id == purge->parent.service_id &&
+	    (purge->by_pair || dentry->parent.index == purge->parent.index))
+		dentry_remove(dentry, purge->dead);
+
+	return true;
+}
+
+/** Drop a name from the dentry cache.
+ *
+ * This must be called after the name has been linked, created or unlinked
+ * in the directory. If the name referred to a directory, the entries of that
+ * directory are dropped as well, since its index may get reused.
+ *
+ * @param dir		Directory containing the name.
+ * @param name		NULL-terminated name.
+ */
+void vfs_dcache_invalidate(vfs_triplet_t *dir, const char *name)
+{
+	LIST_INITIALIZE(dead);
+	dentry_key_t key = {
+		.parent = dir,
+		.name = name,
+		.len = str_size(name)
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	dcache_generation++;
+
+	ht_link_t *tmp = hash_table_find(&dentries, &key);
+	if (tmp != NULL) {
+		vfs_dentry_t *dentry = hash_table_get_inst(tmp, vfs_dentry_t,
+		    dh_link);
+		dentry_remove(dentry, &dead);
+
+		if (dentry->node != NULL &&
+		    dentry->node->type == VFS_NODE_DIRECTORY) {
+			dcache_purge_arg_t purge = {
+				.parent = *((vfs_triplet_t *) dentry->node),
+				.by_pair = false,
+				.dead = &dead
+			};
+			hash_table_apply(&dentries, dcache_purge_cb, &purge);
+		}
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+
+	dentries_destroy(&dead);
+}
+
+/** Drop all entries of a file system instance.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ */
+void vfs_dcache_purge(fs_handle_t fs_handle, service_id_t service_id)
+{
+	LIST_INITIALIZE(dead);
+	dcache_purge_arg_t purge = {
+		.parent = {
+			.fs_handle = fs_handle,
+			.service_id = service_id
+		},
+		.by_pair = true,
+		.dead = &dead
+	};
+
+	fibril_mutex_lock(&dcache_mutex);
+	dcache_generation++;
+	hash_table_apply(&dentries, dcache_purge_cb, &purge);
+	fibril_mutex_unlock(&dcache_mutex);
+
+	dentries_destroy(&dead);
+}
+
+/** Enable or disable the dentry cache for a file system instance.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ * @param enable	Whether lookups in the instance may use the cache.
+ */
+void vfs_dcache_set_enabled(fs_handle_t fs_handle, service_id_t service_id,
+    bool enable)
+{
+	vfs_dcache_purge(fs_handle, service_id);
+
+	fibril_mutex_lock(&dcache_mutex);
+
+	list_foreach_safe(dcache_off, cur, next) {
+		dcache_off_t *off = list_get_instance(cur, dcache_off_t, link);
+		if (off->pair.fs_handle == fs_handle &&
+		    off->pair.service_id == service_id) {
+			list_remove(&off->link);
+			free(off);
+		}
+	}
+
+	if (!enable) {
+		dcache_off_t *off = malloc(sizeof(dcache_off_t));
+		if (off != NULL) {
+			link_initialize(&off->link);
+			off->pair.fs_handle = fs_handle;
+			off->pair.service_id = service_id;
+			list_append(&off->link, &dcache_off);
+		}
+	}
+
+	fibril_mutex_unlock(&dcache_mutex);
+}
+
+/**
+ * @}
+ */
@@ -35,6 +35,7 @@
  * @brief	Various operations on files have their home in this file.
  */
 
+#include <as.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <str.h>
@@ -150,6 +151,27 @@ static errno_t vfs_file_close_remote(vfs_file_t *file)
 	return ipc_get_retval(&answer);
 }
 
+/** Release the read buffer shared by the client for a file.
+ *
+ * @param file		File whose buffer is to be released.
+ */
+void vfs_file_buffer_release(vfs_file_t *file)
+{
+	if (file->buffer == NULL)
+		return;
+
+	if (file->buffer_id != 0) {
+		async_exch_t *exch = vfs_exchange_grab(file->node->fs_handle);
+		async_msg_1(exch, VFS_OUT_RELEASE_BUFFER, file->buffer_id);
+		vfs_exchange_release(exch);
+	}
+
+	as_area_destroy(file->buffer);
+	file->buffer = NULL;
+	file->buffer_size = 0;
+	file->buffer_id = 0;
+}
+
 /** Increment reference count of VFS file structure.
  *
  * @param file		File structure that will have reference count
@@ -180,6 +202,9 @@ static errno_t vfs_file_delref(vfs_client_data_t *vfs_data, vfs_file_t *file)
 		 */
 
 		if (file->node != NULL) {
+			if (file->mapped)
+				vfs_pcache_unmap(file->node);
+			vfs_file_buffer_release(file);
 			if (file->open_read || file->open_write) {
 				rc = vfs_file_close_remote(file);
 			}
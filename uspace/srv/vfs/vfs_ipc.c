@@ -183,6 +183,30 @@ static void vfs_in_read(ipc_call_t *req)
 	async_answer_1(req, rc, bytes);
 }
 
+static void vfs_in_read_buffer(ipc_call_t *req)
+{
+	int fd = ipc_get_arg1(req);
+	aoff64_t pos = MERGE_LOUP32(ipc_get_arg2(req),
+	    ipc_get_arg3(req));
+	size_t offset = ipc_get_arg4(req);
+	size_t size = ipc_get_arg5(req);
+
+	size_t bytes = 0;
+	errno_t rc = vfs_op_read_buffer(fd, pos, offset, size, &bytes);
+	async_answer_1(req, rc, bytes);
+}
+
+static void vfs_in_readdir(ipc_call_t *req)
+{
+	int fd = ipc_get_arg1(req);
+	aoff64_t pos = MERGE_LOUP32(ipc_get_arg2(req),
+	    ipc_get_arg3(req));
+
+	size_t bytes = 0;
+	errno_t rc = vfs_op_readdir(fd, pos, &bytes);
+	async_answer_1(req, rc, bytes);
+}
+
 static void vfs_in_rename(ipc_call_t *req)
 {
 	/* The common base directory. */
@@ -235,6 +259,13 @@ static void vfs_in_resize(ipc_call_t *req)
 	async_answer_0(req, rc);
 }
 
+static void vfs_in_share_buffer(ipc_call_t *req)
+{
+	int fd = ipc_get_arg1(req);
+	errno_t rc = vfs_op_share_buffer(fd);
+	async_answer_0(req, rc);
+}
+
 static void vfs_in_stat(ipc_call_t *req)
 {
 	int fd = ipc_get_arg1(req);
@@ -356,6 +387,12 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_READ:
 			vfs_in_read(&call);
 			break;
+		case VFS_IN_READ_BUFFER:
+			vfs_in_read_buffer(&call);
+			break;
+		case VFS_IN_READDIR:
+			vfs_in_readdir(&call);
+			break;
 		case VFS_IN_REGISTER:
 			vfs_register(&call);
 			cont = false;
@@ -366,6 +403,9 @@ void vfs_connection(ipc_call_t *icall, void *arg)
 		case VFS_IN_RESIZE:
 			vfs_in_resize(&call);
 			break;
+		case VFS_IN_SHARE_BUFFER:
+			vfs_in_share_buffer(&call);
+			break;
 		case VFS_IN_STAT:
 			vfs_in_stat(&call);
 			break;
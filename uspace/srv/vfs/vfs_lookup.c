@@ -202,6 +202,8 @@ errno_t vfs_link_internal(vfs_node_t *base, char *path, vfs_triplet_t *child)
 	if (orig_rc != EOK)
 		rc = orig_rc;
 
+	vfs_dcache_invalidate(triplet, component);
+
 out:
 	return rc;
 }
@@ -321,6 +323,204 @@ out:
 	return rc;
 }
 
+/** Cross the mount points stacked on a node.
+ *
+ * @param pnode		Referenced node on entry, referenced root of the
+ *			topmost file system mounted on it on return.
+ * @param lflag		Lookup flags.
+ *
+ * @return		EOK on success, EXDEV if there is a mount point to
+ *			cross and @a lflag contains L_DISABLE_MOUNTS.
+ */
+static errno_t cross_mounts(vfs_node_t **pnode, int lflag)
+{
+	vfs_node_t *node = *pnode;
+
+	if (node->mount != NULL && (lflag & L_DISABLE_MOUNTS))
+		return EXDEV;
+
+	while (node->mount != NULL) {
+		vfs_node_t *mount = node->mount;
+		vfs_node_addref(mount);
+		vfs_node_put(node);
+		node = mount;
+	}
+
+	*pnode = node;
+	return EOK;
+}
+
+/** Look up a name in a directory.
+ *
+ * On a dentry cache miss, the file system is asked to look up the single
+ * name and the answer is added to the cache.
+ *
+ * @param dir		Directory node. It must not be a mount point.
+ * @param name		Name preceded by a slash in the same buffer, not
+ *			necessarily NULL-terminated.
+ * @param len		Length of @a name.
+ * @param node		Place to store the referenced node @a name refers
+ *			to or NULL if @a dir has no such entry.
+ *
+ * @return		EOK on success or an error code from errno.h.
+ */
+static errno_t lookup_component(vfs_node_t *dir, char *name, size_t len,
+    vfs_node_t **node)
+{
+	assert(name[-1] == '/');
+
+	if (vfs_dcache_get(dir, name, len, node))
+		return EOK;
+
+	unsigned generation = vfs_dcache_generation();
+
+	plb_entry_t entry;
+	size_t first;
+	errno_t rc = plb_insert_entry(&entry, name - 1, &first, len + 1);
+	if (rc != EOK)
+		return rc;
+
+	size_t next = first;
+	size_t nlen = len + 1;
+	vfs_lookup_res_t res;
+
+	rc = out_lookup((vfs_triplet_t *) dir, &next, &nlen, L_NONE, &res);
+	plb_clear_entry(&entry, first, len + 1);
+	if (rc != EOK)
+		return rc;
+
+	if (nlen > 0) {
+		/* The file system stopped at the directory itself. */
+		*node = NULL;
+	} else {
+		*node = vfs_node_get(&res);
+		if (*node == NULL)
+			return ENOMEM;
+	}
+
+	vfs_dcache_insert(dir, name, len, *node, generation);
+	return EOK;
+}
+
+/** Resolve a path one name at a time using the dentry cache.
+ *
+ * The resolution stops early when it enters a file system instance which
+ * does not use the cache. The unresolved rest of the path is then left to
+ * _vfs_lookup_internal().
+ *
+ * @param pnode		Referenced node to start at on entry, referenced
+ *			node the resolution stopped at on return.
+ * @param ppath		Path on entry, rest of the path on return.
+ * @param plen		Length of the path on entry, length of its rest on
+ *			return. Zero if the whole path has been resolved.
+ * @param lflag		Lookup flags.
+ *
+ * @return		EOK on success or an error code from errno.h.
+ */
+static errno_t lookup_cached(vfs_node_t **pnode, char **ppath, size_t *plen,
+    int lflag)
+{
+	vfs_node_t *cur = *pnode;
+	char *path = *ppath;
+	size_t len = *plen;
+	errno_t rc = EOK;
+
+	assert(path[0] == '/');
+
+	/* The path is just "/". */
+	if (len == 1)
+		len = 0;
+
+	while (len > 0) {
+		size_t clen = 1;
+		while (clen < len && path[clen] != '/')
+			clen++;
+
+		rc = cross_mounts(&cur, lflag);
+		if (rc != EOK)
+			break;
+
+		if (!vfs_dcache_enabled(cur))
+			break;
+
+		if (cur->type != VFS_NODE_DIRECTORY) {
+			rc = ENOTDIR;
+			break;
+		}
+
+		vfs_node_t *child;
+		rc = lookup_component(cur, path + 1, clen - 1, &child);
+		if (rc != EOK)
+			break;
+		if (child == NULL) {
+			rc = ENOENT;
+			break;
+		}
+
+		vfs_node_put(cur);
+		cur = child;
+		path += clen;
+		len -= clen;
+	}
+
+	*pnode = cur;
+	*ppath = path;
+	*plen = len;
+	return rc;
+}
+
+/** Perform a path lookup which neither creates nor destroys names.
+ *
+ * @param base		The node from which to perform the lookup.
+ * @param path		Canonical path to be resolved.
+ * @param lflag		Lookup flags without L_CREATE and L_UNLINK.
+ * @param result	Structure where the lookup result will be stored.
+ *			Can be NULL.
+ * @param len		Length of @a path.
+ *
+ * @return		EOK on success or an error code from errno.h.
+ */
+static errno_t lookup_walk(vfs_node_t *base, char *path, int lflag,
+    vfs_lookup_res_t *result, size_t len)
+{
+	assert(!(lflag & (L_CREATE | L_UNLINK)));
+
+	vfs_node_t *node = base;
+	vfs_node_addref(node);
+
+	errno_t rc = lookup_cached(&node, &path, &len, lflag);
+	if (rc != EOK)
+		goto out;
+
+	if (len > 0) {
+		rc = _vfs_lookup_internal(node, path, lflag, result, len);
+		goto out;
+	}
+
+	if (!(lflag & (L_MP | L_DISABLE_MOUNTS)))
+		(void) cross_mounts(&node, lflag);
+
+	if ((lflag & L_FILE) && node->type == VFS_NODE_DIRECTORY) {
+		rc = EISDIR;
+		goto out;
+	}
+
+	if ((lflag & L_DIRECTORY) && node->type == VFS_NODE_FILE) {
+		rc = ENOTDIR;
+		goto out;
+	}
+
+	if (result != NULL) {
+		result->triplet = *((vfs_triplet_t *) node);
+		result->type = node->type;
+		result->size = node->size;
+	}
+
+out:
+	vfs_node_put(node);
+	return rc;
+}
+
 /** Perform a path lookup.
  *
  * @param base    The file from which to perform the lookup.
@@ -372,7 +572,7 @@ errno_t vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 
 			tflag &= ~(L_CREATE | L_EXCLUSIVE | L_UNLINK | L_FILE);
 			tflag |= L_DIRECTORY;
-			rc = _vfs_lookup_internal(base, path, tflag, &tres,
+			rc = lookup_walk(base, path, tflag, &tres,
 			    slash - path);
 			if (rc != EOK)
 				return rc;
@@ -385,10 +585,17 @@ errno_t vfs_lookup_internal(vfs_node_t *base, char *path, int lflag,
 		rc = _vfs_lookup_internal(parent, slash, lflag, result,
 		    len - (slash - path));
 
+		if (rc == EOK) {
+			vfs_node_t *dir = parent;
+			while (dir->mount != NULL)
+				dir = dir->mount;
+			vfs_dcache_invalidate((vfs_triplet_t *) dir, slash + 1);
+		}
+
 		vfs_node_put(parent);
 
 	} else {
-		rc = _vfs_lookup_internal(base, path, lflag, result, len);
+		rc = lookup_walk(base, path, lflag, result, len);
 	}
 
 	return rc;
@@ -134,6 +134,7 @@ void vfs_node_delref(vfs_node_t *node)
 		    (sysarg_t)node->index);
 		vfs_exchange_release(exch);
 
+		vfs_pcache_destroy(node);
 		free(node);
 	}
 }
@@ -150,6 +151,7 @@ void vfs_node_forget(vfs_node_t *node)
 	fibril_mutex_lock(&nodes_mutex);
 	hash_table_remove_item(&nodes, &node->nh_link);
 	fibril_mutex_unlock(&nodes_mutex);
+	vfs_pcache_destroy(node);
 	free(node);
 }
 
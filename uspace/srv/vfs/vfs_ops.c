@@ -48,6 +48,8 @@
 #include <adt/list.h>
 #include <ctype.h>
 #include <assert.h>
+#include <as.h>
+#include <stdatomic.h>
 #include <vfs/canonify.h>
 
 /* Forward declarations of static functions. */
@@ -267,6 +269,10 @@ errno_t vfs_op_mount(int mpfd, unsigned service_id, unsigned flags,
 
 	rc = vfs_connect_internal(service_id, flags, instance, opts, fs_name,
 	    &root);
+	if (rc == EOK && (flags & VFS_MOUNT_NO_DCACHE)) {
+		vfs_dcache_set_enabled(root->fs_handle, root->service_id,
+		    false);
+	}
 	if (rc == EOK && !(flags & VFS_MOUNT_CONNECT_ONLY)) {
 		vfs_node_addref(mp->node);
 		vfs_node_addref(root);
@@ -407,6 +413,91 @@ static errno_t rdwr_ipc_internal(async_exch_t *exch, vfs_file_t *file, aoff64_t
 	return (errno_t) rc;
 }
 
+static errno_t rdwr_ipc_readdir(async_exch_t *exch, vfs_file_t *file,
+    aoff64_t pos, ipc_call_t *answer, bool read, void *data)
+{
+	size_t *bytes = (size_t *) data;
+
+	assert(read);
+
+	if (file->node->type != VFS_NODE_DIRECTORY)
+		return ENOTDIR;
+
+	/*
+	 * Forward the IPC_M_DATA_READ request to the destination FS server,
+	 * which packs as many directory entries into it as fit.
+	 */
+	errno_t rc = async_data_read_forward_4_1(exch, VFS_OUT_READDIR,
+	    file->node->service_id, file->node->index, LOWER32(pos),
+	    UPPER32(pos), answer);
+
+	*bytes = ipc_get_arg1(answer);
+	return rc;
+}
+
+typedef struct {
+	/** Offset of the data in the shared buffer. */
+	size_t offset;
+	/** Requested size on input, number of bytes read on output. */
+	size_t size;
+} rdwr_buffer_t;
+
+static errno_t rdwr_ipc_buffer(async_exch_t *exch, vfs_file_t *file,
+    aoff64_t pos, ipc_call_t *answer, bool read, void *data)
+{
+	rdwr_buffer_t *req = (rdwr_buffer_t *) data;
+	errno_t rc = EOK;
+
+	assert(read);
+
+	size_t offset = req->offset;
+	size_t size = req->size;
+	req->size = 0;
+
+	if (file->buffer == NULL)
+		return ENOENT;
+	if (offset > file->buffer_size || size > file->buffer_size - offset)
+		return EINVAL;
+
+	if (file->buffer_id != 0) {
+		/*
+		 * The FS server has the buffer mapped too, it copies the data
+		 * straight from its cache and fills in as much of the request
+		 * as it can without further round trips.
+		 */
+		aid_t msg = async_send_5(exch, VFS_OUT_READ_BUFFER,
+		    file->buffer_id, LOWER32(pos), UPPER32(pos), size, offset,
+		    answer);
+		async_wait_for(msg, &rc);
+		if (rc == EOK)
+			req->size = ipc_get_arg1(answer);
+		return rc;
+	}
+
+	/* Read into the buffer ourselves, one FS read at a time. */
+	while (req->size < size) {
+		aid_t msg = async_send_4(exch, VFS_OUT_READ,
+		    file->node->service_id, file->node->index,
+		    LOWER32(pos + req->size), UPPER32(pos + req->size), answer);
+		rc = async_data_read_start(exch,
+		    (uint8_t *) file->buffer + offset + req->size,
+		    size - req->size);
+		if (rc != EOK) {
+			async_forget(msg);
+			break;
+		}
+
+		async_wait_for(msg, &rc);
+		if (rc != EOK || ipc_get_arg1(answer) == 0)
+			break;
+
+		req->size += ipc_get_arg1(answer);
+	}
+
+	/* Report the data read before an error, like a short read. */
+	return (req->size > 0) ? EOK : rc;
+}
+
 static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
     void *ipc_cb_data)
 {
@@ -480,6 +571,10 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 
 	vfs_exchange_release(fs_exch);
 
+	/* Let the mappings of the file see the written data. */
+	if (!read && rc == EOK)
+		vfs_pcache_update(file->node, pos, ipc_get_arg1(&answer));
+
 	if (file->node->type == VFS_NODE_DIRECTORY)
 		fibril_rwlock_read_unlock(&namespace_rwlock);
 
@@ -510,6 +605,24 @@ errno_t vfs_op_read(int fd, aoff64_t pos, size_t *out_bytes)
 	return vfs_rdwr(fd, pos, true, rdwr_ipc_client, out_bytes);
 }
 
+errno_t vfs_op_read_buffer(int fd, aoff64_t pos, size_t offset, size_t size,
+    size_t *out_bytes)
+{
+	rdwr_buffer_t req = {
+		.offset = offset,
+		.size = size
+	};
+
+	errno_t rc = vfs_rdwr(fd, pos, true, rdwr_ipc_buffer, &req);
+	*out_bytes = req.size;
+	return rc;
+}
+
+errno_t vfs_op_readdir(int fd, aoff64_t pos, size_t *out_bytes)
+{
+	return vfs_rdwr(fd, pos, true, rdwr_ipc_readdir, out_bytes);
+}
+
 errno_t vfs_op_rename(int basefd, char *old, char *new)
 {
 	vfs_file_t *base_file = vfs_file_get(basefd);
@@ -626,14 +739,88 @@ errno_t vfs_op_resize(int fd, int64_t size)
 
 	errno_t rc = vfs_truncate_internal(file->node->fs_handle,
 	    file->node->service_id, file->node->index, size);
-	if (rc == EOK)
+	if (rc == EOK) {
 		file->node->size = size;
+		vfs_pcache_resize(file->node, size);
+	}
 
 	fibril_rwlock_write_unlock(&file->node->contents_rwlock);
 	vfs_file_put(file);
 	return rc;
 }
 
+/** Next ID of a read buffer shared with an FS server. */
+static atomic_uint buffer_id_next = 1;
+
+/** Accept a buffer for reading a file shared by the client.
+ *
+ * If the endpoint FS supports it, the buffer is shared with it as well so
+ * that it can copy the file data directly into the buffer. Otherwise VFS
+ * reads into the buffer on behalf of the client.
+ *
+ * @param fd	File handle open for reading
+ *
+ * @return	EOK on success or an error code
+ */
+errno_t vfs_op_share_buffer(int fd)
+{
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+
+	if (!async_share_out_receive(&call, &size, &flags))
+		return EINVAL;
+
+	vfs_file_t *file = vfs_file_get(fd);
+	if (!file) {
+		async_answer_0(&call, EBADF);
+		return EBADF;
+	}
+
+	if (!file->open_read || file->node->type != VFS_NODE_FILE ||
+	    (flags & AS_AREA_WRITE) == 0) {
+		vfs_file_put(file);
+		async_answer_0(&call, EINVAL);
+		return EINVAL;
+	}
+
+	void *buffer;
+	errno_t rc = async_share_out_finalize(&call, &buffer);
+	if (rc != EOK || buffer == AS_MAP_FAILED) {
+		vfs_file_put(file);
+		return (rc != EOK) ? rc : ENOMEM;
+	}
+
+	vfs_file_buffer_release(file);
+	file->buffer = buffer;
+	file->buffer_size = size;
+
+	vfs_info_t *fs_info = fs_handle_to_info(file->node->fs_handle);
+	assert(fs_info);
+
+	if (fs_info->read_buffer) {
+		sysarg_t id = atomic_fetch_add(&buffer_id_next, 1);
+		async_exch_t *exch = vfs_exchange_grab(file->node->fs_handle);
+
+		aid_t msg = async_send_3(exch, VFS_OUT_SHARE_BUFFER,
+		    file->node->service_id, file->node->index, id, NULL);
+		rc = async_share_out_start(exch, buffer,
+		    AS_AREA_READ | AS_AREA_WRITE);
+
+		vfs_exchange_release(exch);
+
+		errno_t orig;
+		async_wait_for(msg, &orig);
+
+		/* On failure, VFS reads into the buffer by itself. */
+		if (rc == EOK && orig == EOK)
+			file->buffer_id = id;
+	}
+
+	vfs_file_put(file);
+	return EOK;
+}
+
 errno_t vfs_op_stat(int fd)
 {
 	vfs_file_t *file = vfs_file_get(fd);
@@ -674,6 +861,9 @@ errno_t vfs_op_sync(int fd)
 	if (!file)
 		return EBADF;
 
+	/* Write back the pages modified through shared mappings first. */
+	errno_t wb_rc = vfs_pcache_sync(file->node);
+
 	async_exch_t *fs_exch = vfs_exchange_grab(file->node->fs_handle);
 
 	aid_t msg;
@@ -687,7 +877,7 @@ errno_t vfs_op_sync(int fd)
 	async_wait_for(msg, &rc);
 
 	vfs_file_put(file);
-	return rc;
+	return (rc == EOK) ? wb_rc : rc;
 
 }
 
@@ -797,6 +987,10 @@ errno_t vfs_op_unmount(int mpfd)
 
 	fibril_rwlock_write_lock(&namespace_rwlock);
 
+	/* Drop the node references held by the dentry cache. */
+	vfs_dcache_purge(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
+
 	/*
 	 * Count the total number of references for the mounted file system. We
 	 * are expecting at least one, which is held by the mount point.
@@ -822,6 +1016,8 @@ errno_t vfs_op_unmount(int mpfd)
 		return rc;
 	}
 
+	vfs_dcache_set_enabled(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id, true);
 	vfs_node_forget(mp->node->mount);
 	vfs_node_put(mp->node);
 	mp->node->mount = NULL;
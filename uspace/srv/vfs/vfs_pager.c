@@ -40,52 +40,86 @@
 #include <fibril_synch.h>
 #include <errno.h>
 #include <as.h>
+#include <align.h>
+#include <libarch/config.h>
 
+/** Handle a page-in request of an area mapping a file.
+ *
+ * The pager IDs of the area are the file handle, the page-aligned file
+ * offset of the area and the VFS_MAP_* flags. The kernel passes the
+ * access flags of the area in the low bits of the size of the request.
+ *
+ * Pages of read-only and shared mappings are taken from the page cache of
+ * the file, so that all such mappings share the same frames. Writable
+ * private mappings get copies of the cached pages.
+ */
 void vfs_page_in(ipc_call_t *req)
 {
 	aoff64_t offset = ipc_get_arg1(req);
-	size_t page_size = ipc_get_arg2(req);
+	size_t size = ALIGN_DOWN(ipc_get_arg2(req), PAGE_SIZE);
+	unsigned int aflags = ipc_get_arg2(req) & (PAGE_SIZE - 1);
 	int fd = ipc_get_arg3(req);
+	aoff64_t pos = ipc_get_arg4(req) + offset;
+	bool shared = (ipc_get_arg5(req) & VFS_MAP_SHARED) != 0;
+	bool writable = (aflags & AS_AREA_WRITE) != 0;
 	void *page;
 	errno_t rc;
 
-	page = as_area_create(AS_AREA_ANY, page_size,
-	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
-	    AS_AREA_UNPAGED);
-
-	if (page == AS_MAP_FAILED) {
-		async_answer_0(req, ENOMEM);
+	vfs_file_t *file = vfs_file_get(fd);
+	if (file == NULL) {
+		async_answer_0(req, EBADF);
 		return;
 	}
 
-	rdwr_io_chunk_t chunk = {
-		.buffer = page,
-		.size = page_size
-	};
+	if (!file->open_read || file->node->type != VFS_NODE_FILE ||
+	    ALIGN_DOWN(pos, PAGE_SIZE) != pos) {
+		rc = EINVAL;
+		goto out;
+	}
+
+	if (shared && writable && !file->open_write) {
+		rc = EPERM;
+		goto out;
+	}
 
-	size_t total = 0;
-	aoff64_t pos = offset;
-	do {
-		rc = vfs_rdwr_internal(fd, pos, true, &chunk);
+	if (!file->mapped) {
+		rc = vfs_pcache_map(file->node);
 		if (rc != EOK)
-			break;
-		if (chunk.size == 0)
-			break;
-		total += chunk.size;
-		pos += chunk.size;
-		chunk.buffer += chunk.size;
-		chunk.size = page_size - total;
-	} while (total < page_size);
+			goto out;
+		file->mapped = true;
+	}
+
+	if (shared || !writable) {
+		rc = vfs_pcache_get(file->node, pos, size, shared && writable,
+		    &page);
+		if (rc == EOK)
+			async_answer_1(req, EOK, (sysarg_t) page);
+		goto out;
+	}
+
+	page = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+	    AS_AREA_UNPAGED);
 
-	async_answer_1(req, rc, (sysarg_t) page);
+	if (page == AS_MAP_FAILED) {
+		rc = ENOMEM;
+		goto out;
+	}
+
+	rc = vfs_pcache_read(file->node, pos, page, size);
+	if (rc == EOK)
+		async_answer_1(req, EOK, (sysarg_t) page);
 
 	/*
-	 * FIXME:
-	 * This is just for now until we implement proper page cache
-	 * management.  Not keeping the pages around in a cache results in
-	 * inherently non-coherent private mappings.
+	 * The kernel has already taken its own references to the frames of
+	 * the private copy.
 	 */
 	as_area_destroy(page);
+
+out:
+	if (rc != EOK)
+		async_answer_0(req, rc);
+	vfs_file_put(file);
 }
 
 /**
@@ -0,0 +1,627 @@
+/*
+ * Copyright (c) 2026 HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup vfs
+ * @{
+ */
+
+/**
+ * @file	vfs_pcache.c
+ * @brief	Page cache of mapped files.
+ *
+ * The pages of a file mapped by clients are kept in segments, which are
+ * address space areas of VFS. Page-in requests are answered with the
+ * addresses of the cached pages, so that the kernel maps the very same
+ * frames into all the clients mapping the file.
+ *
+ * Pages handed out to writable shared mappings are considered dirty. They
+ * are written back when the file is synchronized and when the last open
+ * file mapping the node is closed. Writes through VFS update the cached
+ * pages they overlap so that the mappings see them.
+ */
+
+#include "vfs.h"
+#include <adt/list.h>
+#include <align.h>
+#include <as.h>
+#include <assert.h>
+#include <async.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <libarch/config.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+
+/** Number of pages in a page cache segment. */
+#define PCACHE_SEG_PAGES	256
+#define PCACHE_SEG_SIZE		(PCACHE_SEG_PAGES * PAGE_SIZE)
+
+/** Size of the tail following each segment, which is never populated.
+ *
+ * A page-in request can extend past the end of a segment. The kernel
+ * shares only the pages present in VFS, so the tail keeps the pages past
+ * the segment from being taken from an unrelated area.
+ */
+#define PCACHE_SEG_TAIL		(16 * PAGE_SIZE)
+
+/** Number of segments above which segments of unmapped files are evicted. */
+#define PCACHE_MAX_SEGS		64
+
+typedef struct {
+	link_t link;		/**< Link to vfs_pcache_t.segs. */
+	link_t lru_link;	/**< Link to pcache_lru. */
+	vfs_pcache_t *pcache;	/**< Page cache the segment belongs to. */
+
+	aoff64_t offset;	/**< File offset of the first page. */
+	uint8_t *base;		/**< Address of the segment in VFS. */
+
+	bool present[PCACHE_SEG_PAGES];
+	bool dirty[PCACHE_SEG_PAGES];
+} pcache_seg_t;
+
+struct vfs_pcache {
+	/** Protects the segments and their contents. */
+	fibril_mutex_t lock;
+
+	vfs_node_t *node;
+	list_t segs;
+
+	/** Number of open files mapping the node, protected by pcache_mutex. */
+	unsigned mappers;
+};
+
+/** Protects the node page cache pointers, pcache_lru and pcache_nsegs. */
+static FIBRIL_MUTEX_INITIALIZE(pcache_mutex);
+
+static LIST_INITIALIZE(pcache_lru);
+static size_t pcache_nsegs = 0;
+
+/** Read or write file data directly in the endpoint file system.
+ *
+ * Data missing past the end of the file are read as zeros.
+ *
+ * @param node		VFS node.
+ * @param pos		Position in the file.
+ * @param read		True for reading, false for writing.
+ * @param buf		Buffer.
+ * @param size		Number of bytes to transfer.
+ *
+ * @return		EOK on success or an error code from errno.h.
+ */
+static errno_t pcache_io(vfs_node_t *node, aoff64_t pos, bool read,
+    void *buf, size_t size)
+{
+	uint8_t *data = buf;
+
+	while (size > 0) {
+		ipc_call_t answer;
+		async_exch_t *exch = vfs_exchange_grab(node->fs_handle);
+		aid_t msg = async_send_4(exch,
+		    read ? VFS_OUT_READ : VFS_OUT_WRITE, node->service_id,
+		    node->index, LOWER32(pos), UPPER32(pos), &answer);
+
+		errno_t rc;
+		if (read)
+			rc = async_data_read_start(exch, data, size);
+		else
+			rc = async_data_write_start(exch, data, size);
+
+		if (rc != EOK) {
+			async_forget(msg);
+			vfs_exchange_release(exch);
+			return rc;
+		}
+
+		async_wait_for(msg, &rc);
+		vfs_exchange_release(exch);
+		if (rc != EOK)
+			return rc;
+
+		size_t done = ipc_get_arg1(&answer);
+		if (done == 0)
+			break;
+
+		data += done;
+		pos += done;
+		size -= done;
+	}
+
+	if (read)
+		memset(data, 0, size);
+
+	return EOK;
+}
+
+/** Get the page cache of a node.
+ *
+ * @param node		VFS node.
+ *
+ * @return		Page cache or NULL if the node has none.
+ */
+static vfs_pcache_t *pcache_get(vfs_node_t *node)
+{
+	fibril_mutex_lock(&pcache_mutex);
+	vfs_pcache_t *pcache = node->pcache;
+	fibril_mutex_unlock(&pcache_mutex);
+
+	return pcache;
+}
+
+/** Try to evict a segment of a file which nobody maps.
+ *
+ * The pcache_mutex must be locked. Only clean segments are found on such
+ * files, since the dirty pages are written back when the last mapping goes
+ * away.
+ */
+static void pcache_evict(void)
+{
+	assert(fibril_mutex_is_locked(&pcache_mutex));
+
+	list_foreach(pcache_lru, lru_link, pcache_seg_t, seg) {
+		vfs_pcache_t *pcache = seg->pcache;
+
+		if (pcache->mappers > 0)
+			continue;
+		if (!fibril_mutex_trylock(&pcache->lock))
+			continue;
+
+		list_remove(&seg->link);
+		list_remove(&seg->lru_link);
+		pcache_nsegs--;
+		fibril_mutex_unlock(&pcache->lock);
+
+		as_area_destroy(seg->base);
+		free(seg);
+		return;
+	}
+}
+
+/** Find or create the segment containing a file offset.
+ *
+ * @param pcache	Locked page cache.
+ * @param pos		File offset.
+ *
+ * @return		Segment or NULL if out of memory.
+ */
+static pcache_seg_t *pcache_seg_get(vfs_pcache_t *pcache, aoff64_t pos)
+{
+	assert(fibril_mutex_is_locked(&pcache->lock));
+
+	aoff64_t offset = ALIGN_DOWN(pos, PCACHE_SEG_SIZE);
+
+	list_foreach(pcache->segs, link, pcache_seg_t, seg) {
+		if (seg->offset == offset) {
+			fibril_mutex_lock(&pcache_mutex);
+			list_remove(&seg->lru_link);
+			list_append(&seg->lru_link, &pcache_lru);
+			fibril_mutex_unlock(&pcache_mutex);
+			return seg;
+		}
+	}
+
+	pcache_seg_t *seg = calloc(1, sizeof(pcache_seg_t));
+	if (seg == NULL)
+		return NULL;
+
+	seg->base = as_area_create(AS_AREA_ANY,
+	    PCACHE_SEG_SIZE + PCACHE_SEG_TAIL,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE |
+	    AS_AREA_LATE_RESERVE, AS_AREA_UNPAGED);
+	if (seg->base == AS_MAP_FAILED) {
+		free(seg);
+		return NULL;
+	}
+
+	link_initialize(&seg->link);
+	link_initialize(&seg->lru_link);
+	seg->pcache = pcache;
+	seg->offset = offset;
+	list_append(&seg->link, &pcache->segs);
+
+	fibril_mutex_lock(&pcache_mutex);
+	if (pcache_nsegs >= PCACHE_MAX_SEGS)
+		pcache_evict();
+	list_append(&seg->lru_link, &pcache_lru);
+	pcache_nsegs++;
+	fibril_mutex_unlock(&pcache_mutex);
+
+	return seg;
+}
+
+/** Make pages of a segment present.
+ *
+ * Runs of missing pages are read from the file system in one request.
+ *
+ * @param pcache	Locked page cache.
+ * @param seg		Segment.
+ * @param first		Index of the first page.
+ * @param count		Number of pages.
+ *
+ * @return		EOK on success or an error code from errno.h.
+ */
+static errno_t pcache_seg_fill(vfs_pcache_t *pcache, pcache_seg_t *seg,
+    size_t first, size_t count)
+{
+	assert(first + count <= PCACHE_SEG_PAGES);
+
+	size_t i = first;
+	while (i < first + count) {
+		if (seg->present[i]) {
+			i++;
+			continue;
+		}
+
+		size_t j = i;
+		while (j < first + count && !seg->present[j])
+			j++;
+
+		errno_t rc = pcache_io(pcache->node,
+		    seg->offset + PAGES2SIZE(i), true,
+		    seg->base + PAGES2SIZE(i), PAGES2SIZE(j - i));
+		if (rc != EOK)
+			return rc;
+
+		for (; i < j; i++)
+			seg->present[i] = true;
+	}
+
+	return EOK;
+}
+
+/** Register an open file mapping a node.
+ *
+ * @param node		VFS node.
+ *
+ * @return		EOK on success, ENOMEM if out of memory.
+ */
+errno_t vfs_pcache_map(vfs_node_t *node)
+{
+	fibril_mutex_lock(&pcache_mutex);
+
+	if (node->pcache == NULL) {
+		vfs_pcache_t *pcache = malloc(sizeof(vfs_pcache_t));
+		if (pcache == NULL) {
+			fibril_mutex_unlock(&pcache_mutex);
+			return ENOMEM;
+		}
+
+		fibril_mutex_initialize(&pcache->lock);
+		pcache->node = node;
+		list_initialize(&pcache->segs);
+		pcache->mappers = 0;
+		node->pcache = pcache;
+	}
+
+	node->pcache->mappers++;
+
+	fibril_mutex_unlock(&pcache_mutex);
+	return EOK;
+}
+
+/** Write back the dirty pages of a node.
+ *
+ * The caller must hold the contents lock of the node. Pages are never
+ * written past the end of the file.
+ *
+ * @param pcache	Page cache.
+ * @param clean		Whether the pages should be marked clean.
+ *
+ * @return		EOK on success or an error code from errno.h.
+ */
+static errno_t pcache_writeback(vfs_pcache_t *pcache, bool clean)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&pcache->lock);
+
+	aoff64_t size = pcache->node->size;
+
+	list_foreach(pcache->segs, link, pcache_seg_t, seg) {
+		size_t i = 0;
+		while (i < PCACHE_SEG_PAGES &&
+		    seg->offset + PAGES2SIZE(i) < size) {
+			if (!seg->dirty[i]) {
+				i++;
+				continue;
+			}
+
+			size_t j = i;
+			while (j < PCACHE_SEG_PAGES && seg->dirty[j])
+				j++;
+
+			aoff64_t pos = seg->offset + PAGES2SIZE(i);
+			size_t len = min(PAGES2SIZE(j - i), size - pos);
+			errno_t rc1 = pcache_io(pcache->node, pos, false,
+			    seg->base + PAGES2SIZE(i), len);
+
+			if (rc1 != EOK)
+				rc = rc1;
+			else if (clean)
+				memset(&seg->dirty[i], 0, j - i);
+
+			i = j;
+		}
+	}
+
+	fibril_mutex_unlock(&pcache->lock);
+	return rc;
+}
+
+/** Unregister an open file mapping a node.
+ *
+ * When the last such file goes away, the dirty pages are written back.
+ *
+ * @param node		VFS node.
+ */
+void vfs_pcache_unmap(vfs_node_t *node)
+{
+	fibril_mutex_lock(&pcache_mutex);
+	vfs_pcache_t *pcache = node->pcache;
+	assert(pcache != NULL);
+	assert(pcache->mappers > 0);
+	bool last = --pcache->mappers == 0;
+	fibril_mutex_unlock(&pcache_mutex);
+
+	if (last) {
+		fibril_rwlock_write_lock(&node->contents_rwlock);
+		(void) pcache_writeback(pcache, true);
+		fibril_rwlock_write_unlock(&node->contents_rwlock);
+	}
+}
+
+/** Get cached pages of a mapped node.
+ *
+ * @param node		VFS node registered by vfs_pcache_map().
+ * @param pos		Page-aligned file offset of the first page.
+ * @param size		Size of the range, in bytes.
+ * @param dirty		Whether the pages go to a writable shared
+ *			mapping.
+ * @param addr		Place to store the address of the first page.
+ *
+ * @return		EOK on success, ELIMIT if the range extends past the
+ *			tail of the segment or an error code from errno.h.
+ */
+errno_t vfs_pcache_get(vfs_node_t *node, aoff64_t pos, size_t size,
+    bool dirty, void **addr)
+{
+	vfs_pcache_t *pcache = pcache_get(node);
+	assert(pcache != NULL);
+	assert(ALIGN_DOWN(pos, PAGE_SIZE) == pos);
+
+	fibril_mutex_lock(&pcache->lock);
+
+	pcache_seg_t *seg = pcache_seg_get(pcache, pos);
+	if (seg == NULL) {
+		fibril_mutex_unlock(&pcache->lock);
+		return ENOMEM;
+	}
+
+	size_t off = pos - seg->offset;
+	if (off + size > PCACHE_SEG_SIZE + PCACHE_SEG_TAIL) {
+		fibril_mutex_unlock(&pcache->lock);
+		return ELIMIT;
+	}
+
+	/* Pages past the segment are left for subsequent page faults. */
+	size_t first = off >> PAGE_WIDTH;
+	size_t count = SIZE2PAGES(min(size, PCACHE_SEG_SIZE - off));
+
+	errno_t rc = pcache_seg_fill(pcache, seg, first, count);
+	if (rc == EOK) {
+		if (dirty)
+			memset(&seg->dirty[first], true, count);
+		*addr = seg->base + off;
+	}
+
+	fibril_mutex_unlock(&pcache->lock);
+	return rc;
+}
+
+/** Copy data of a mapped node out of its page cache.
+ *
+ * @param node		VFS node registered by vfs_pcache_map().
+ * @param pos		Page-aligned file offset.
+ * @param buf		Destination buffer.
+ * @param size		Number of bytes to copy.
+ *
+ * @return		EOK on success or an error code from errno.h.
+ */
+errno_t vfs_pcache_read(vfs_node_t *node, aoff64_t pos, void *buf,
+    size_t size)
+{
+	vfs_pcache_t *pcache = pcache_get(node);
+	assert(pcache != NULL);
+	assert(ALIGN_DOWN(pos, PAGE_SIZE) == pos);
+
+	uint8_t *data = buf;
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&pcache->lock);
+
+	while (size > 0) {
+		pcache_seg_t *seg = pcache_seg_get(pcache, pos);
+		if (seg == NULL) {
+			rc = ENOMEM;
+			break;
+		}
+
+		size_t off = pos - seg->offset;
+		size_t len = min(size, PCACHE_SEG_SIZE - off);
+
+		rc = pcache_seg_fill(pcache, seg, off >> PAGE_WIDTH,
+		    SIZE2PAGES(len));
+		if (rc != EOK)
+			break;
+
+		memcpy(data, seg->base + off, len);
+		data += len;
+		pos += len;
+		size -= len;
+	}
+
+	fibril_mutex_unlock(&pcache->lock);
+	return rc;
+}
+
+/** Update the cached pages after a write through VFS.
+ *
+ * The caller must hold the contents lock of the node. Only the written
+ * bytes are read back, so that modifications done through the mappings
+ * elsewhere in the pages are preserved.
+ *
+ * @param node		VFS node.
+ * @param pos		Position of the write.
+ * @param size		Number of bytes written.
+ */
+void vfs_pcache_update(vfs_node_t *node, aoff64_t pos, size_t size)
+{
+	vfs_pcache_t *pcache = pcache_get(node);
+	if (pcache == NULL || size == 0)
+		return;
+
+	fibril_mutex_lock(&pcache->lock);
+
+	list_foreach(pcache->segs, link, pcache_seg_t, seg) {
+		aoff64_t start = max(pos, seg->offset);
+		aoff64_t end = min(pos + size, seg->offset + PCACHE_SEG_SIZE);
+
+		while (start < end) {
+			size_t i = (start - seg->offset) >> PAGE_WIDTH;
+			aoff64_t page_end = seg->offset + PAGES2SIZE(i + 1);
+			size_t len = min(end, page_end) - start;
+
+			if (seg->present[i] &&
+			    pcache_io(node, start, true,
+			    seg->base + (start - seg->offset), len) != EOK) {
+				/* Better show zeros than stale data. */
+				memset(seg->base + (start - seg->offset), 0,
+				    len);
+			}
+
+			start += len;
+		}
+	}
+
+	fibril_mutex_unlock(&pcache->lock);
+}
+
+/** Update the cached pages after the file has been resized.
+ *
+ * The caller must hold the contents lock of the node. The cached data past
+ * the new end of the file are cleared so that they do not reappear when
+ * the file grows again.
+ *
+ * @param node		VFS node.
+ * @param size		New size of the file.
+ */
+void vfs_pcache_resize(vfs_node_t *node, aoff64_t size)
+{
+	vfs_pcache_t *pcache = pcache_get(node);
+	if (pcache == NULL)
+		return;
+
+	fibril_mutex_lock(&pcache->lock);
+
+	list_foreach(pcache->segs, link, pcache_seg_t, seg) {
+		aoff64_t end = seg->offset + PCACHE_SEG_SIZE;
+		if (end <= size)
+			continue;
+
+		size_t off = (size > seg->offset) ? size - seg->offset : 0;
+		for (size_t i = off >> PAGE_WIDTH; i < PCACHE_SEG_PAGES; i++) {
+			if (!seg->present[i])
+				continue;
+
+			size_t from = max(off, PAGES2SIZE(i));
+			memset(seg->base + from, 0, PAGES2SIZE(i + 1) - from);
+		}
+	}
+
+	fibril_mutex_unlock(&pcache->lock);
+}
+
+/** Write back the dirty pages of a node.
+ *
+ * The pages stay dirty as long as the node is mapped.
+ *
+ * @param node		VFS node.
+ *
+ * @return		EOK on success or an error code from errno.h.
+ */
+errno_t vfs_pcache_sync(vfs_node_t *node)
+{
+	vfs_pcache_t *pcache = pcache_get(node);
+	if (pcache == NULL)
+		return EOK;
+
+	fibril_rwlock_write_lock(&node->contents_rwlock);
+	errno_t rc = pcache_writeback(pcache, false);
+	fibril_rwlock_write_unlock(&node->contents_rwlock);
+
+	return rc;
+}
+
+/** Destroy the page cache of a node which is going away.
+ *
+ * @param node		VFS node.
+ */
+void vfs_pcache_destroy(vfs_node_t *node)
+{
+	fibril_mutex_lock(&pcache_mutex);
+
+	vfs_pcache_t *pcache = node->pcache;
+	if (pcache == NULL) {
+		fibril_mutex_unlock(&pcache_mutex);
+		return;
+	}
+
+	assert(pcache->mappers == 0);
+
+	list_foreach(pcache->segs, link, pcache_seg_t, seg) {
+		list_remove(&seg->lru_link);
+		pcache_nsegs--;
+	}
+
+	node->pcache = NULL;
+	fibril_mutex_unlock(&pcache_mutex);
+
+	while (!list_empty(&pcache->segs)) {
+		pcache_seg_t *seg = list_get_instance(list_first(&pcache->segs),
+		    pcache_seg_t, link);
+		list_remove(&seg->link);
+		as_area_destroy(seg->base);
+		free(seg);
+	}
+
+	free(pcache);
+}
+
+/**
+ * @}
+ */